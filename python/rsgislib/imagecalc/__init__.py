@@ -872,3 +872,40 @@ def normalise_image_band(input_img, band, output_img, gdal_format='KEA'):
     rsgislib.imagecalc.bandMath(output_img, exp, gdal_format, rsgislib.TYPE_32FLOAT, band_defns)
     rsgislib.imageutils.popImageStats(output_img, usenodataval=True, nodataval=0.0, calcpyramids=True)
 
+
+
+def calcImageBlocksNumpy(inputimgs, outputimg, gdalformat, datatype, numoutbands, blockfunc):
+    """
+    Create an output image by applying a function to numpy arrays of each block of rows
+    read by the image calc engine (see calcImageBlocks). The arrays are views onto the
+    engine's buffers (i.e., not copies) so they must not be kept after the function returns.
+
+    :param inputimgs: a list of input image files (or a single file).
+    :param outputimg: the output image file.
+    :param gdalformat: the output image format.
+    :param datatype: the output image data type (rsgislib.TYPE_*).
+    :param numoutbands: the number of output image bands.
+    :param blockfunc: a function blockfunc(inblocks, outblocks) where inblocks is a list of
+                      read-only float32 arrays (one per input band, shape (nrows, width)) and
+                      outblocks a list of float64 arrays of the same shape, one per output band,
+                      which should be filled in place (e.g., outblocks[0][...] = inblocks[0] * 2).
+
+    Example::
+
+        import rsgislib
+        import rsgislib.imagecalc
+
+        def calcNDVI(inblocks, outblocks):
+            red = inblocks[2]
+            nir = inblocks[3]
+            numpy.divide(nir - red, nir + red, out=outblocks[0], where=(nir + red) != 0)
+
+        rsgislib.imagecalc.calcImageBlocksNumpy(['img.kea'], 'ndvi.kea', 'KEA', rsgislib.TYPE_32FLOAT, 1, calcNDVI)
+
+    """
+    def _blockFunc(inbands, outbands, width, nrows):
+        inblocks = [numpy.frombuffer(band, dtype=numpy.float32).reshape(nrows, width) for band in inbands]
+        outblocks = [numpy.frombuffer(band, dtype=numpy.float64).reshape(nrows, width) for band in outbands]
+        blockfunc(inblocks, outblocks)
+
+    calcImageBlocks(inputimgs, outputimg, gdalformat, datatype, numoutbands, _blockFunc)
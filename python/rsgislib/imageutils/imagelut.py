@@ -92,6 +92,42 @@ def query_img_lut(scn_bbox, lutdbfile, lyrname):
     return imgs
 
 
+def createImgFootprintIndex(imgList, indexFile, ignore_none_imgs=False, nthreads=1):
+    """
+    Create a spatially indexed look up table (LUT) of the image extents, which is much faster to
+    create and query than a vector LUT (createImgExtentLUT) for large numbers of images. The index
+    is saved as a binary file rather than a vector layer. This function calls
+    rsgislib.imageutils.createImageFootprintIndex.
+
+    :param imgList: list of input images for the LUT. All input images should be the same projection/coordinate system.
+    :param indexFile: output index file.
+    :param ignore_none_imgs: if an image cannot be opened or has no projection then ignore and don't include in LUT else throw exception.
+    :param nthreads: the number of threads used to read the image headers (0 uses all the cores).
+
+    Example::
+
+        import glob
+        import rsgislib.imageutils.imagelut
+        imgList = glob.glob('/Users/pete/Temp/GabonLandsat/Hansen*.kea')
+        rsgislib.imageutils.imagelut.createImgFootprintIndex(imgList, './ImgExtents.fpi', nthreads=8)
+
+    """
+    import rsgislib.imageutils
+    rsgislib.imageutils.createImageFootprintIndex(imgList, indexFile, ignore_none_imgs, nthreads)
+
+
+def query_img_footprint_index(scn_bbox, indexFile):
+    """
+    Find the images in an index created with createImgFootprintIndex which intersect a bbox.
+
+    :param scn_bbox: A bbox (MinX, MaxX, MinY, MaxY) in the same projection as the LUT for the area of interest.
+    :param indexFile: The file path to the index file.
+    :return: a list of files from the LUT
+    """
+    import rsgislib.imageutils
+    return rsgislib.imageutils.queryImageFootprintIndex(indexFile, bbox=tuple(scn_bbox))
+
+
 def get_all_lut_imgs(lutdbfile, lyrname):
     """
     Get a list of all the images within the LUT.
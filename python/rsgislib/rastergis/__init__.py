@@ -196,6 +196,52 @@ and usage (e.g., GFU_Generic, GFU_PixelCount, GFU_Name, etc.) within the RAT.
     return col_info
 
 
+def readRATColumn(clumps_img, column, start_row=0, n_rows=None, rat_band=1):
+    """
+A function which reads a column (or a range of rows) of the RAT into a numpy array. The values
+are read straight into the array, in blocks, without an intermediate copy.
+
+:param clumps_img: path to the image file with the RAT
+:param column: the name of the column to be read.
+:param start_row: the first row to be read (default = 0).
+:param n_rows: the number of rows to be read (default = None; to the end of the RAT).
+:param rat_band: the band within the image file for which the RAT is to read.
+:returns: numpy array (int32 for integer columns, otherwise float64)
+
+"""
+    nrows, is_int = getRATColumnInfo(clumps_img, column, rat_band)
+    if n_rows is None:
+        n_rows = nrows - start_row
+    if (start_row < 0) or (n_rows < 0) or ((start_row + n_rows) > nrows):
+        raise Exception("The rows requested are not within the RAT.")
+    col_data = numpy.empty(n_rows, dtype=numpy.int32 if is_int else numpy.float64)
+    readRATColumnToBuffer(clumps_img, column, col_data, start_row, rat_band)
+    return col_data
+
+
+def writeRATColumn(clumps_img, column, data, start_row=0, rat_band=1):
+    """
+A function which writes a numpy array to a column (or a range of rows) of the RAT, creating
+the column if required. Integer arrays are written as int32 and all others as float64; arrays
+of those types are written without a copy. Large columns can be written in chunks using start_row.
+
+:param clumps_img: path to the image file with the RAT
+:param column: the name of the column to be written.
+:param data: a 1D numpy array with the values.
+:param start_row: the first row to be written (default = 0).
+:param rat_band: the band within the image file for which the RAT is to written.
+
+"""
+    data = numpy.asarray(data)
+    if data.ndim != 1:
+        raise Exception("The data must be a 1D array.")
+    if numpy.issubdtype(data.dtype, numpy.integer) or (data.dtype == numpy.bool_):
+        data = numpy.ascontiguousarray(data, dtype=numpy.int32)
+    else:
+        data = numpy.ascontiguousarray(data, dtype=numpy.float64)
+    writeRATColumnFromBuffer(clumps_img, column, data, start_row, rat_band)
+
+
 def readRATNeighbours(clumps_img, start_row=None, end_row=None, rat_band=1):
     """
 A function which returns a list of clumps neighbours from a KEA RAT. Note, the
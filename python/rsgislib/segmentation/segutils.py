@@ -56,7 +56,7 @@ import osgeo.gdal as gdal
 import json
 
 
-def runShepherdSegmentation(inputImg, outputClumps, outputMeanImg=None, tmpath='.', gdalformat='KEA', noStats=False, noStretch=False, noDelete=False, numClusters=60, minPxls=100, distThres=100, bands=None, sampling=100, kmMaxIter=200, processInMem=False, saveProcessStats=False, imgStretchStats="", kMeansCentres="", imgStatsJSONFile=""): 
+def runShepherdSegmentation(inputImg, outputClumps, outputMeanImg=None, tmpath='.', gdalformat='KEA', noStats=False, noStretch=False, noDelete=False, numClusters=60, minPxls=100, distThres=100, bands=None, sampling=100, kmMaxIter=200, processInMem=False, saveProcessStats=False, imgStretchStats="", kMeansCentres="", imgStatsJSONFile="", kmMiniBatchSize=0): 
     """
 Utility function to call the segmentation algorithm of Shepherd et al. (2019).
 
@@ -83,6 +83,7 @@ Where:
 :param imgStretchStats: is a string providing the file name and path for the image stretch stats (Output).
 :param kMeansCentres: is a string providing the file name and path for the KMeans clusters centres (don't include file extension; .gmtxt will be added to the end) (Output).
 :param imgStatsJSONFile: is a string providing the name and path of a JSON file storing the image spatial extent and imgStretchStats and kMeansCentres file paths for use by other commands (Output).
+:param kmMiniBatchSize: if greater than 0 the KMeans uses mini-batch k-means with batches of this many sampled pixels, which is quicker for large images (default = 0; standard KMeans).
 
 Example::
 
@@ -162,7 +163,7 @@ Example::
     outMatrixFile = os.path.join(tmpath,basename+str("_kmeansclusters"))
     if saveProcessStats:
         outMatrixFile = kMeansCentres
-    rsgislib.imagecalc.kMeansClustering(segmentFile, outMatrixFile, numClusters, kmMaxIter, sampling, True, 0.0025, rsgislib.imagecalc.INITCLUSTER_DIAGONAL_FULL_ATTACH)
+    rsgislib.imagecalc.kMeansClustering(segmentFile, outMatrixFile, numClusters, kmMaxIter, sampling, True, 0.0025, rsgislib.imagecalc.INITCLUSTER_DIAGONAL_FULL_ATTACH, kmMiniBatchSize)
     
     # Apply KMEANS
     print("Apply KMeans to image.")
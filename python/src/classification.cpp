@@ -94,7 +94,10 @@ static PyObject *Classification_CollapseClasses(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeCollapseRAT2Class(std::string(pszInputImage), std::string(pszOutputFile), std::string(pszGDALFormat), std::string(pszClassesColumn), classIntColStr, classIntColPresent);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCollapseRAT2Class(std::string(pszInputImage), std::string(pszOutputFile), std::string(pszGDALFormat), std::string(pszClassesColumn), classIntColStr, classIntColPresent);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -113,7 +116,10 @@ static PyObject *Classification_Colour3Bands(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeGenerate3BandFromColourTable(std::string(pszInputImage), std::string(pszOutputFile), std::string(pszGDALFormat));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeGenerate3BandFromColourTable(std::string(pszInputImage), std::string(pszOutputFile), std::string(pszGDALFormat));
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -138,7 +144,10 @@ static PyObject *Classification_GenRandomAccuracyPts(PyObject *self, PyObject *a
     
     try
     {
-        rsgis::cmds::executeGenerateRandomAccuracyPts(std::string(pszInputImage), std::string(pszOutputShp), std::string(pszClassImgCol), std::string(pszClassImgVecCol), std::string(pszClassRefVecCol), numPts, seed, force);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeGenerateRandomAccuracyPts(std::string(pszInputImage), std::string(pszOutputShp), std::string(pszClassImgCol), std::string(pszClassImgVecCol), std::string(pszClassRefVecCol), numPts, seed, force);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -164,7 +173,10 @@ static PyObject *Classification_GenStratifiedRandomAccuracyPts(PyObject *self, P
     
     try
     {
-        rsgis::cmds::executeGenerateStratifiedRandomAccuracyPts(std::string(pszInputImage), std::string(pszOutputShp), std::string(pszClassImgCol), std::string(pszClassImgVecCol), std::string(pszClassRefVecCol), numPts, seed, force, usePxlLst);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeGenerateStratifiedRandomAccuracyPts(std::string(pszInputImage), std::string(pszOutputShp), std::string(pszClassImgCol), std::string(pszClassImgVecCol), std::string(pszClassRefVecCol), numPts, seed, force, usePxlLst);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -196,7 +208,10 @@ static PyObject *Classification_PopClassInfoAccuracyPts(PyObject *self, PyObject
     
     try
     {
-        rsgis::cmds::executePopClassInfoAccuracyPts(std::string(pszInputImage), std::string(pszInputShp), std::string(pszClassImgCol), std::string(pszClassImgVecCol), pszClassRefVecCol, addRefCol);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePopClassInfoAccuracyPts(std::string(pszInputImage), std::string(pszInputShp), std::string(pszClassImgCol), std::string(pszClassImgVecCol), pszClassRefVecCol, addRefCol);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -61,7 +61,10 @@ static PyObject *Elevation_calcSlope(PyObject *self, PyObject *args)
             throw rsgis::cmds::RSGISCmdException("The unit option needs to be specified as either \'degrees\' or \'radians\'.");
         }
         
-        rsgis::cmds::executeCalcSlope(std::string(pszInputImage), std::string(pszOutputFile), outAngleUnit, std::string(pszGDALFormat));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCalcSlope(std::string(pszInputImage), std::string(pszOutputFile), outAngleUnit, std::string(pszGDALFormat));
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -80,7 +83,10 @@ static PyObject *Elevation_calcAspect(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeCalcAspect(std::string(pszInputImage), std::string(pszOutputFile), std::string(pszGDALFormat));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCalcAspect(std::string(pszInputImage), std::string(pszOutputFile), std::string(pszGDALFormat));
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -99,7 +105,10 @@ static PyObject *Elevation_catAspect(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeCatagoriseAspect(std::string(pszInputImage), std::string(pszOutputFile), std::string(pszGDALFormat));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCatagoriseAspect(std::string(pszInputImage), std::string(pszOutputFile), std::string(pszGDALFormat));
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -119,7 +128,91 @@ static PyObject *Elevation_calcHillshade(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeCalcHillshade(std::string(pszInputImage), std::string(pszOutputFile), azimuth, zenith, std::string(pszGDALFormat));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCalcHillshade(std::string(pszInputImage), std::string(pszOutputFile), azimuth, zenith, std::string(pszGDALFormat));
+        }
+    }
+    catch(rsgis::cmds::RSGISCmdException &e)
+    {
+        PyErr_SetString(GETSTATE(self)->error, e.what());
+        return NULL;
+    }
+    
+    Py_RETURN_NONE;
+}
+
+static PyObject *Elevation_calcDEMDerivatives(PyObject *self, PyObject *args, PyObject *keywds)
+{
+    const char *pszInputImage, *pszOutputFile, *pszGDALFormat;
+    PyObject *derivativesObj;
+    float solarAzimuth = 0.0;
+    float solarZenith = 0.0;
+    float viewAzimuth = 0.0;
+    float viewZenith = 0.0;
+    static char *kwlist[] = {"inputImage", "outputImage", "derivatives", "gdalformat", "solarAzimuth", "solarZenith", "viewAzimuth", "viewZenith", NULL};
+    if( !PyArg_ParseTupleAndKeywords(args, keywds, "ssOs|ffff:demDerivatives", kwlist, &pszInputImage, &pszOutputFile, &derivativesObj, &pszGDALFormat, &solarAzimuth, &solarZenith, &viewAzimuth, &viewZenith))
+    {
+        return NULL;
+    }
+    
+    if( !PySequence_Check(derivativesObj))
+    {
+        PyErr_SetString(GETSTATE(self)->error, "derivatives argument must be a sequence");
+        return NULL;
+    }
+    
+    std::vector<rsgis::cmds::RSGISDEMDerivativeType> derivatives;
+    Py_ssize_t nDerivs = PySequence_Size(derivativesObj);
+    for( Py_ssize_t n = 0; n < nDerivs; n++ )
+    {
+        PyObject *o = PySequence_GetItem(derivativesObj, n);
+        if( ( o == NULL ) || ( o == Py_None ) || !RSGISPY_CHECK_STRING(o) )
+        {
+            PyErr_SetString(GETSTATE(self)->error, "value in derivatives was not a string." );
+            Py_XDECREF(o);
+            return NULL;
+        }
+        std::string derivName = RSGISPY_STRING_EXTRACT(o);
+        Py_DECREF(o);
+        
+        if(derivName == "slope")
+        {
+            derivatives.push_back(rsgis::cmds::rsgis_deriv_slope_deg);
+        }
+        else if(derivName == "slope_rad")
+        {
+            derivatives.push_back(rsgis::cmds::rsgis_deriv_slope_rad);
+        }
+        else if(derivName == "aspect")
+        {
+            derivatives.push_back(rsgis::cmds::rsgis_deriv_aspect);
+        }
+        else if(derivName == "hillshade")
+        {
+            derivatives.push_back(rsgis::cmds::rsgis_deriv_hillshade);
+        }
+        else if(derivName == "incidence")
+        {
+            derivatives.push_back(rsgis::cmds::rsgis_deriv_incidence);
+        }
+        else if(derivName == "exitance")
+        {
+            derivatives.push_back(rsgis::cmds::rsgis_deriv_exitance);
+        }
+        else
+        {
+            PyErr_SetString(GETSTATE(self)->error, "derivatives must be one of 'slope', 'slope_rad', 'aspect', 'hillshade', 'incidence' or 'exitance'." );
+            return NULL;
+        }
+    }
+    
+    try
+    {
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCalcDEMDerivatives(std::string(pszInputImage), std::string(pszOutputFile), derivatives, solarAzimuth, solarZenith, viewAzimuth, viewZenith, std::string(pszGDALFormat));
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -134,12 +227,16 @@ static PyObject *Elevation_calcShadowMask(PyObject *self, PyObject *args)
 {
     const char *pszInputImage, *pszOutputFile, *pszGDALFormat;
     float azimuth, zenith, maxHeight = 0.0;
-    if( !PyArg_ParseTuple(args, "ssfffs:shadowmask", &pszInputImage, &pszOutputFile, &azimuth, &zenith, &maxHeight, &pszGDALFormat))
+    int horizonSweep = false;
+    if( !PyArg_ParseTuple(args, "ssfffs|i:shadowmask", &pszInputImage, &pszOutputFile, &azimuth, &zenith, &maxHeight, &pszGDALFormat, &horizonSweep))
         return NULL;
     
     try
     {
-        rsgis::cmds::executeCalcShadowMask(std::string(pszInputImage), std::string(pszOutputFile), azimuth, zenith, maxHeight, std::string(pszGDALFormat));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCalcShadowMask(std::string(pszInputImage), std::string(pszOutputFile), azimuth, zenith, maxHeight, std::string(pszGDALFormat), horizonSweep);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -159,7 +256,10 @@ static PyObject *Elevation_calcLocalIncidenceAngle(PyObject *self, PyObject *arg
     
     try
     {
-        rsgis::cmds::executeCalcLocalIncidenceAngle(std::string(pszInputImage), std::string(pszOutputFile), azimuth, zenith, std::string(pszGDALFormat));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCalcLocalIncidenceAngle(std::string(pszInputImage), std::string(pszOutputFile), azimuth, zenith, std::string(pszGDALFormat));
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -179,7 +279,10 @@ static PyObject *Elevation_calcLocalExistanceAngle(PyObject *self, PyObject *arg
     
     try
     {
-        rsgis::cmds::executeCalcLocalExitanceAngle(std::string(pszInputImage), std::string(pszOutputFile), azimuth, zenith, std::string(pszGDALFormat));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCalcLocalExitanceAngle(std::string(pszInputImage), std::string(pszOutputFile), azimuth, zenith, std::string(pszGDALFormat));
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -200,7 +303,10 @@ static PyObject *Elevation_dtmAspectMedianFilter(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeDTMAspectMedianFilter(std::string(pszInputDTMImage), std::string(pszInputAspectImage), std::string(pszOutputFile), aspectRange, winHSize, std::string(pszGDALFormat));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeDTMAspectMedianFilter(std::string(pszInputDTMImage), std::string(pszInputAspectImage), std::string(pszOutputFile), aspectRange, winHSize, std::string(pszGDALFormat));
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -220,7 +326,61 @@ static PyObject *Elevation_fillDEMSoilleGratin1994(PyObject *self, PyObject *arg
     
     try
     {
-        rsgis::cmds::executeDEMFillSoilleGratin1994(std::string(pszInputDTMImage), std::string(pszValidMaskImage), std::string(pszOutputFile), std::string(pszGDALFormat));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeDEMFillSoilleGratin1994(std::string(pszInputDTMImage), std::string(pszValidMaskImage), std::string(pszOutputFile), std::string(pszGDALFormat));
+        }
+    }
+    catch(rsgis::cmds::RSGISCmdException &e)
+    {
+        PyErr_SetString(GETSTATE(self)->error, e.what());
+        return NULL;
+    }
+    
+    Py_RETURN_NONE;
+}
+
+static PyObject *Elevation_fillDEMPriorityFlood(PyObject *self, PyObject *args)
+{
+    const char *pszInputDTMImage, *pszValidMaskImage, *pszOutputFile, *pszGDALFormat;
+    double epsilon = 0.0;
+
+    if( !PyArg_ParseTuple(args, "ssss|d:fillDEMPriorityFlood", &pszInputDTMImage, &pszValidMaskImage, &pszOutputFile, &pszGDALFormat, &epsilon))
+        return NULL;
+    
+    try
+    {
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeDEMFillPriorityFlood(std::string(pszInputDTMImage), std::string(pszValidMaskImage), std::string(pszOutputFile), std::string(pszGDALFormat), epsilon);
+        }
+    }
+    catch(rsgis::cmds::RSGISCmdException &e)
+    {
+        PyErr_SetString(GETSTATE(self)->error, e.what());
+        return NULL;
+    }
+    
+    Py_RETURN_NONE;
+}
+
+static PyObject *Elevation_fillDEMVoids(PyObject *self, PyObject *args)
+{
+    const char *pszInputDEMImage, *pszOutputFile, *pszGDALFormat;
+    float holeValue = 0.0;
+    int laplacian = false;
+    unsigned int maxIterations = 1000;
+    float tolerance = 0.001;
+    
+    if( !PyArg_ParseTuple(args, "sssf|iIf:fillDEMVoids", &pszInputDEMImage, &pszOutputFile, &pszGDALFormat, &holeValue, &laplacian, &maxIterations, &tolerance))
+        return NULL;
+    
+    try
+    {
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeDEMFillVoids(std::string(pszInputDEMImage), std::string(pszOutputFile), std::string(pszGDALFormat), holeValue, laplacian, maxIterations, tolerance);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -241,7 +401,10 @@ static PyObject *Elevation_planeFitDetreadDEM(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executePlaneFitDetreadDEM(std::string(pszInputDEMImage), std::string(pszOutputFile), std::string(pszGDALFormat), winSize);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePlaneFitDetreadDEM(std::string(pszInputDEMImage), std::string(pszOutputFile), std::string(pszGDALFormat), winSize);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -299,8 +462,30 @@ static PyMethodDef ElevationMethods[] = {
 ":param solarZenith: is a float with the solar zenith in degrees (Good value is 45).\n"
 ":param gdalformat: is a string with the output image format for the GDAL driver.\n"},
     
+{"demDerivatives", (PyCFunction)Elevation_calcDEMDerivatives, METH_VARARGS | METH_KEYWORDS,
+"rsgislib.elevation.demDerivatives(inputImage, outputImage, derivatives, gdalformat, solarAzimuth=0, solarZenith=0, viewAzimuth=0, viewZenith=0)\n"
+"Calculates a set of derivatives of an elevation model in a single pass, with one output band per derivative.\n"
+"The gradient is only calculated once for each pixel, so this is faster than calculating each layer separately.\n"
+"\n"
+"Where:\n"
+"\n"
+":param inputImage: is a string containing the name and path of the input DEM file.\n"
+":param outputImage: is a string containing the name and path of the output file.\n"
+":param derivatives: is a list of the derivatives to output, in band order: 'slope' (degrees), 'slope_rad', 'aspect', 'hillshade', 'incidence' and 'exitance'.\n"
+":param gdalformat: is a string with the output image format for the GDAL driver.\n"
+":param solarAzimuth: is a float with the solar azimuth in degrees (used for 'hillshade' and 'incidence').\n"
+":param solarZenith: is a float with the solar zenith in degrees (used for 'hillshade' and 'incidence').\n"
+":param viewAzimuth: is a float with the view azimuth in degrees (used for 'exitance').\n"
+":param viewZenith: is a float with the view zenith in degrees (used for 'exitance').\n"
+"\n"
+"Example::\n"
+"\n"
+"    import rsgislib.elevation\n"
+"    rsgislib.elevation.demDerivatives('dem.kea', 'dem_derivs.kea', ['slope', 'aspect', 'hillshade'], 'KEA', solarAzimuth=315, solarZenith=45)\n"
+"\n"},
+    
 {"shadowmask", Elevation_calcShadowMask, METH_VARARGS,
-"rsgislib.elevation.shadowmask(inputImage, outputImage, solarAzimuth, solarZenith, maxHeight, gdalformat)\n"
+"rsgislib.elevation.shadowmask(inputImage, outputImage, solarAzimuth, solarZenith, maxHeight, gdalformat, horizonSweep=False)\n"
 "Calculates a shadow mask given an input elevation model\n"
 "\n"
 "Where:\n"
@@ -309,8 +494,9 @@ static PyMethodDef ElevationMethods[] = {
 ":param outputImage: is a string containing the name and path of the output file.\n"
 ":param solarAzimuth: is a float with the solar azimuth in degrees.\n"
 ":param solarZenith: is a float with the solar zenith in degrees.\n"
-":param maxHeight: is a float with the maximum height for the ray tracing (should be above the maximum elevation within the scene)."
-":param gdalformat: is a string with the output image format for the GDAL driver.\n"},
+":param maxHeight: is a float with the maximum height for the ray tracing (should be above the maximum elevation within the scene).\n"
+":param gdalformat: is a string with the output image format for the GDAL driver.\n"
+":param horizonSweep: is a boolean specifying that the cast shadow is calculated by sweeping along lines aligned with the solar azimuth, keeping the running height of the shadowing terrain, rather than tracing a ray from every pixel. Each pixel is visited once, the lines are processed in parallel (RSGISLIB_NUM_THREADS) and maxHeight is not used. The DEM is read into memory. (Default = False)\n"},
     
     
 {"localIncidenceAngle", Elevation_calcLocalIncidenceAngle, METH_VARARGS,
@@ -374,6 +560,56 @@ static PyMethodDef ElevationMethods[] = {
 "\n"
 },
     
+{"fillDEMPriorityFlood", Elevation_fillDEMPriorityFlood, METH_VARARGS,
+"rsgislib.elevation.fillDEMPriorityFlood(inputDEMImage, validMaskImage, outputImage, gdalformat, epsilon=0.0)\n"
+"Fill the local minima in a DEM using the priority-flood algorithm. Unlike fillDEMSoilleGratin1994\n"
+"the DEM does not need to have integer values and the output image is always float.\n\n"
+"Barnes, R., Lehman, C., and Mulla, D. (2014). Priority-flood: An optimal depression-filling\n"
+"and watershed-labeling algorithm for digital elevation models. Computers & Geosciences. 62. 117-127.\n"
+"\n"
+"Where:\n"
+"\n"
+":param inputDEMImage: is a string containing the name and path of the input DEM file.\n"
+":param validMaskImage: is a string containing the name and path to a binary image specifying the valid data region (1 == valid)\n"
+":param outputImage: is a string containing the name and path of the output file.\n"
+":param gdalformat: is a string with the output image format for the GDAL driver.\n"
+":param epsilon: is a float with the increase in elevation per pixel across filled areas, so that every\n"
+"                depression drains, (Default = 0; flat fill).\n"
+"\n"
+"Example::\n"
+"\n"
+"   import rsgislib.elevation\n"
+"   inputDEMImage = 'DEM.kea'\n"
+"   validMaskImage = 'ValidRegionMask.kea'\n"
+"   outFilledImage = 'DEM_filled.kea'\n"
+"   rsgislib.elevation.fillDEMPriorityFlood(inputDEMImage, validMaskImage, outFilledImage, 'KEA', 0.001)\n"
+"\n"
+},
+    
+{"fillDEMVoids", Elevation_fillDEMVoids, METH_VARARGS,
+"rsgislib.elevation.fillDEMVoids(inputDEMImage, outputImage, gdalformat, holeValue, laplacian=False, maxIterations=1000, tolerance=0.001)\n"
+"Fill the voids (regions of pixels equal to holeValue) within a DEM. Each void is labelled once and filled\n"
+"inwards from its boundary, so the run time depends on the area of the voids rather than the image size.\n"
+"The voids are filled in parallel (RSGISLIB_NUM_THREADS) and the DEM is read into memory.\n"
+"\n"
+"Where:\n"
+"\n"
+":param inputDEMImage: is a string containing the name and path of the input DEM file.\n"
+":param outputImage: is a string containing the name and path of the output file.\n"
+":param gdalformat: is a string with the output image format for the GDAL driver.\n"
+":param holeValue: is a float with the pixel value of the voids to be filled.\n"
+":param laplacian: is a boolean specifying that the wavefront fill is refined to a smooth surface matching the\n"
+"                  void boundary (solution of Laplace's equation), (Default = False).\n"
+":param maxIterations: is an int with the maximum number of relaxation iterations per void when laplacian is True (Default = 1000).\n"
+":param tolerance: is a float with the largest change in elevation at which the relaxation stops (Default = 0.001).\n"
+"\n"
+"Example::\n"
+"\n"
+"   import rsgislib.elevation\n"
+"   rsgislib.elevation.fillDEMVoids('DEM.kea', 'DEM_filled.kea', 'KEA', -9999, True)\n"
+"\n"
+},
+    
 {"planeFitDetreatDEM", Elevation_planeFitDetreadDEM, METH_VARARGS,
 "rsgislib.elevation.planeFitDetreatDEM(inputDEMImage, outputImage, gdalformat, winSize)\n"
 "An algorithm to detread a DEM using local plane fitting. The winSize will define the scale\n"
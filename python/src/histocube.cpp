@@ -76,7 +76,10 @@ static PyObject *HistoCube_CreateEmptyHistCube(PyObject *self, PyObject *args, P
     
     try
     {
-        rsgis::cmds::executeCreateEmptyHistoCube(std::string(pszCubeFile), numOfFeats);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCreateEmptyHistoCube(std::string(pszCubeFile), numOfFeats);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -109,7 +112,10 @@ static PyObject *HistoCube_CreateHistoCubeLayer(PyObject *self, PyObject *args,
     
     try
     {
-        rsgis::cmds::executeCreateHistoCubeLayer(std::string(pszCubeFile), std::string(pszLayerName), lowBin, upBin, scale, offset, (bool)hasDateTimeInt, std::string(pszDataTime));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCreateHistoCubeLayer(std::string(pszCubeFile), std::string(pszLayerName), lowBin, upBin, scale, offset, (bool)hasDateTimeInt, std::string(pszDataTime));
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -138,7 +144,90 @@ static PyObject *HistoCube_PopulateHistoCubeLayer(PyObject *self, PyObject *args
     
     try
     {
-        rsgis::cmds::executePopulateSingleHistoCubeLayer(std::string(pszCubeFile), std::string(pszLayerName), std::string(pszClumpsImg), std::string(pszValsImg), imgBand, (bool)inMem);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePopulateSingleHistoCubeLayer(std::string(pszCubeFile), std::string(pszLayerName), std::string(pszClumpsImg), std::string(pszValsImg), imgBand, (bool)inMem);
+        }
+    }
+    catch(rsgis::cmds::RSGISCmdException &e)
+    {
+        PyErr_SetString(GETSTATE(self)->error, e.what());
+        return NULL;
+    }
+    
+    Py_RETURN_NONE;
+}
+
+static PyObject *HistoCube_PopulateHistoCubeLayers(PyObject *self, PyObject *args, PyObject *keywds)
+{
+    const char *pszCubeFile;
+    const char *pszClumpsImg;
+    PyObject *layerNamesObj;
+    PyObject *valsImgsObj;
+    PyObject *bandsObj;
+    double maxMemMB = 1024;
+    
+    static char *kwlist[] = {"filename", "layerNames", "clumpsImg", "valsImgs", "bands", "maxMemMB", NULL};
+    
+    if( !PyArg_ParseTupleAndKeywords(args, keywds, "sOsOO|d:populateHistoCubeLayers", kwlist, &pszCubeFile, &layerNamesObj, &pszClumpsImg, &valsImgsObj, &bandsObj, &maxMemMB))
+    {
+        return NULL;
+    }
+    
+    if( !PySequence_Check(layerNamesObj) || !PySequence_Check(valsImgsObj) || !PySequence_Check(bandsObj))
+    {
+        PyErr_SetString(GETSTATE(self)->error, "layerNames, valsImgs and bands arguments must be sequences");
+        return NULL;
+    }
+    Py_ssize_t nLayers = PySequence_Size(layerNamesObj);
+    if((PySequence_Size(valsImgsObj) != nLayers) || (PySequence_Size(bandsObj) != nLayers))
+    {
+        PyErr_SetString(GETSTATE(self)->error, "layerNames, valsImgs and bands must be the same length");
+        return NULL;
+    }
+    
+    std::vector<std::string> layerNames;
+    std::vector<std::string> valsImgs;
+    std::vector<unsigned int> imgBands;
+    for( Py_ssize_t n = 0; n < nLayers; n++ )
+    {
+        PyObject *o = PySequence_GetItem(layerNamesObj, n);
+        if( ( o == NULL ) || ( o == Py_None ) || !RSGISPY_CHECK_STRING(o) )
+        {
+            PyErr_SetString(GETSTATE(self)->error, "value in layerNames was not a string." );
+            Py_XDECREF(o);
+            return NULL;
+        }
+        layerNames.push_back(RSGISPY_STRING_EXTRACT(o));
+        Py_DECREF(o);
+        
+        o = PySequence_GetItem(valsImgsObj, n);
+        if( ( o == NULL ) || ( o == Py_None ) || !RSGISPY_CHECK_STRING(o) )
+        {
+            PyErr_SetString(GETSTATE(self)->error, "value in valsImgs was not a string." );
+            Py_XDECREF(o);
+            return NULL;
+        }
+        valsImgs.push_back(RSGISPY_STRING_EXTRACT(o));
+        Py_DECREF(o);
+        
+        o = PySequence_GetItem(bandsObj, n);
+        if( ( o == NULL ) || ( o == Py_None ) || !RSGISPY_CHECK_INT(o) )
+        {
+            PyErr_SetString(GETSTATE(self)->error, "value in bands was not an int." );
+            Py_XDECREF(o);
+            return NULL;
+        }
+        imgBands.push_back(RSGISPY_UINT_EXTRACT(o));
+        Py_DECREF(o);
+    }
+    
+    try
+    {
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePopulateHistoCubeLayers(std::string(pszCubeFile), layerNames, std::string(pszClumpsImg), valsImgs, imgBands, maxMemMB);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -189,7 +278,10 @@ static PyObject *HistoCube_ExportHistoBins2ImgBands(PyObject *self, PyObject *ar
     
     try
     {
-        rsgis::cmds::executeExportHistBins2Img(std::string(pszCubeFile), std::string(pszLayerName), std::string(pszClumpsImg), std::string(pszOutputImg), std::string(pszGDALFormat), exportBins);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeExportHistBins2Img(std::string(pszCubeFile), std::string(pszLayerName), std::string(pszClumpsImg), std::string(pszOutputImg), std::string(pszGDALFormat), exportBins);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -214,7 +306,10 @@ static PyObject *HistoCube_GetLayersNames(PyObject *self, PyObject *args, PyObje
     std::vector<std::string> lyrNames;
     try
     {
-        lyrNames = rsgis::cmds::executeExportHistBins2Img(std::string(pszCubeFile));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            lyrNames = rsgis::cmds::executeExportHistBins2Img(std::string(pszCubeFile));
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -284,7 +379,10 @@ static PyObject *HistoCube_ExportHistoStats2ImgBands(PyObject *self, PyObject *a
     
     try
     {
-        rsgis::cmds::executeExportHistStats2Img(std::string(pszCubeFile), std::string(pszLayerName), std::string(pszClumpsImg), std::string(pszOutputImg), std::string(pszGDALFormat), dType, exportSumStats);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeExportHistStats2Img(std::string(pszCubeFile), std::string(pszLayerName), std::string(pszClumpsImg), std::string(pszOutputImg), std::string(pszGDALFormat), dType, exportSumStats);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -380,6 +478,33 @@ static PyMethodDef HistoCubeMethods[] = {
 "\n"
 },
 
+{"populateHistoCubeLayers", (PyCFunction)HistoCube_PopulateHistoCubeLayers, METH_VARARGS | METH_KEYWORDS,
+"rsgislib.histocube.populateHistoCubeLayers(filename=string, layerNames=list, clumpsImg=string, valsImgs=list, bands=list, maxMemMB=float)\n"
+"Populate several histogram layers (e.g., one per date of a time series) in a single pass through the clumps image.\n"
+"The value images are read and binned in parallel (see the RSGISLIB_NUM_THREADS environment variable).\n"
+"Note, data from the bands is 'added' to any existing data already within the histogram(s).\n"
+"\n"
+"Where:\n"
+"\n"
+":param filename: is the file path and name for the histogram cube file.\n"
+":param layerNames: is a list of the names of the layers to be populated.\n"
+":param clumpsImg: is a clumps image that specifies which histogram cube row pixels in with values images are associated.\n"
+":param valsImgs: is a list of the images (one per layer) with the values to be populated; all must be the same size as the clumps image. An image can be listed more than once.\n"
+":param bands: is a list of the band numbers (one per layer; note band numbers start at 1)\n"
+":param maxMemMB: is the memory (MB) available to hold the layers while they are being populated (Optional, default is 1024)\n"
+"\n"
+"Example::\n"
+"\n"
+"    import rsgislib.histocube\n"
+"    \n"
+"    hcFile = 'HistoCubeTest.hcf'\n"
+"    clumpsImg = 'clumps.kea'\n"
+"    layerNames = ['20170101', '20170201', '20170301']\n"
+"    valsImgs = ['ndvi_stack.kea', 'ndvi_stack.kea', 'ndvi_stack.kea']\n"
+"    rsgislib.histocube.populateHistoCubeLayers(hcFile, layerNames=layerNames, clumpsImg=clumpsImg, valsImgs=valsImgs, bands=[1,2,3])\n"
+"\n"
+},
+
 {"exportHistoBins2ImgBands", (PyCFunction)HistoCube_ExportHistoBins2ImgBands, METH_VARARGS | METH_KEYWORDS,
 "rsgislib.histocube.exportHistoBins2ImgBands(filename=string, layerName=string, clumpsImg=string, outputImg=string, gdalformat=string, binidxs=list)\n"
 "Export bins from the histogram cube to an output image.\n"
@@ -112,10 +112,133 @@ static PyObject *ImageCalc_BandMath(PyObject *self, PyObject *args, PyObject *ke
         rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)nDataType;
         bool useExpAsbandName = (bool)bExpBandName;
         bool outputImgExists = (bool)bOutputImgExists;
-        rsgis::cmds::executeBandMaths(pRSGISStruct, nBandDefns, pszOutputFile, pszExpression, pszGDALFormat, type, useExpAsbandName, outputImgExists);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeBandMaths(pRSGISStruct, nBandDefns, pszOutputFile, pszExpression, pszGDALFormat, type, useExpAsbandName, outputImgExists);
+        }
+    }
+    catch(rsgis::cmds::RSGISCmdException &e)
+    {
+        PyErr_SetString(GETSTATE(self)->error, e.what());
+        return NULL;
+    }
+
+    delete[] pRSGISStruct;
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *ImageCalc_BandMathMaskStretch(PyObject *self, PyObject *args, PyObject *keywds)
+{
+    static char *kwlist[] = {"outputimg", "exp", "gdalformat", "datatype", "banddefseq", "maskimg", "maskvals", "maskoutval", "inmin", "inmax", "outmin", "outmax", NULL};
+    const char *pszOutputFile, *pszExpression, *pszGDALFormat, *pszMaskImage;
+    int nDataType;
+    PyObject *pBandDefnObj;
+    PyObject *maskValueObj;
+    float maskOutValue;
+    double inMin, inMax, outMin, outMax;
+    if( !PyArg_ParseTupleAndKeywords(args, keywds, "sssiOsOfdddd:bandMathMaskStretch", kwlist, &pszOutputFile, &pszExpression, &pszGDALFormat, &nDataType, &pBandDefnObj, &pszMaskImage, &maskValueObj, &maskOutValue, &inMin, &inMax, &outMin, &outMax))
+    {
+        return NULL;
+    }
+
+    if( !PySequence_Check(pBandDefnObj))
+    {
+        PyErr_SetString(GETSTATE(self)->error, "banddefseq must be a sequence");
+        return NULL;
+    }
+
+    std::vector<float> maskValues;
+    if( !PySequence_Check(maskValueObj))
+    {
+        if(RSGISPY_CHECK_FLOAT(maskValueObj) || RSGISPY_CHECK_INT(maskValueObj))
+        {
+            maskValues.push_back(RSGISPY_FLOAT_EXTRACT(maskValueObj));
+        }
+        else
+        {
+            PyErr_SetString(GETSTATE(self)->error, "Mask value must be numeric or a list of numeric.");
+            return NULL;
+        }
+    }
+    else
+    {
+        Py_ssize_t numMaskVals = PySequence_Size(maskValueObj);
+        for( Py_ssize_t n = 0; n < numMaskVals; n++ )
+        {
+            PyObject *o = PySequence_GetItem(maskValueObj, n);
+            if(RSGISPY_CHECK_FLOAT(o) || RSGISPY_CHECK_INT(o))
+            {
+                maskValues.push_back(RSGISPY_FLOAT_EXTRACT(o));
+                Py_DECREF(o);
+            }
+            else
+            {
+                Py_DECREF(o);
+                PyErr_SetString(GETSTATE(self)->error, "Mask value must be numeric or a list of numeric.");
+                return NULL;
+            }
+        }
+    }
+
+    Py_ssize_t nBandDefns = PySequence_Size(pBandDefnObj);
+    rsgis::cmds::VariableStruct *pRSGISStruct = new rsgis::cmds::VariableStruct[nBandDefns];
+
+    for( Py_ssize_t n = 0; n < nBandDefns; n++ )
+    {
+        PyObject *o = PySequence_GetItem(pBandDefnObj, n);
+
+        PyObject *pBandName = PyObject_GetAttrString(o, "bandName");
+        if( ( pBandName == NULL ) || ( pBandName == Py_None ) || !RSGISPY_CHECK_STRING(pBandName) )
+        {
+            PyErr_SetString(GETSTATE(self)->error, "could not find string attribute \'bandName\'" );
+            Py_XDECREF(pBandName);
+            Py_DECREF(o);
+            delete[] pRSGISStruct;
+            return NULL;
+        }
+
+        PyObject *pFileName = PyObject_GetAttrString(o, "fileName");
+        if( ( pFileName == NULL ) || ( pFileName == Py_None ) || !RSGISPY_CHECK_STRING(pFileName) )
+        {
+            PyErr_SetString(GETSTATE(self)->error, "could not find string attribute \'fileName\'" );
+            Py_DECREF(pBandName);
+            Py_XDECREF(pFileName);
+            Py_DECREF(o);
+            delete[] pRSGISStruct;
+            return NULL;
+        }
+
+        PyObject *pBandIndex = PyObject_GetAttrString(o, "bandIndex");
+        if( ( pBandIndex == NULL ) || ( pBandIndex == Py_None ) || !RSGISPY_CHECK_INT(pBandIndex) )
+        {
+            PyErr_SetString(GETSTATE(self)->error, "could not find integer attribute \'bandIndex\'" );
+            Py_DECREF(pBandName);
+            Py_DECREF(pFileName);
+            Py_XDECREF(pBandIndex);
+            Py_DECREF(o);
+            delete[] pRSGISStruct;
+            return NULL;
+        }
+
+        pRSGISStruct[n].name = RSGISPY_STRING_EXTRACT(pBandName);
+        pRSGISStruct[n].image = RSGISPY_STRING_EXTRACT(pFileName);
+        pRSGISStruct[n].bandNum = RSGISPY_INT_EXTRACT(pBandIndex);
+
+        Py_DECREF(pBandName);
+        Py_DECREF(pFileName);
+        Py_DECREF(pBandIndex);
+        Py_DECREF(o);
+    }
+
+    try
+    {
+        RSGISPyReleaseGIL releaseGIL;
+        rsgis::cmds::executeBandMathsMaskStretch(pRSGISStruct, nBandDefns, pszMaskImage, maskValues, maskOutValue, inMin, inMax, outMin, outMax, pszOutputFile, pszExpression, pszGDALFormat, (rsgis::RSGISLibDataType)nDataType);
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
+        delete[] pRSGISStruct;
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
     }
@@ -125,6 +248,135 @@ static PyObject *ImageCalc_BandMath(PyObject *self, PyObject *args, PyObject *ke
     Py_RETURN_NONE;
 }
 
+static PyObject *ImageCalc_BandMathPipeline(PyObject *self, PyObject *args, PyObject *keywds)
+{
+    static char *kwlist[] = {"inputs", "steps", "gdalformat", "datatype", "tempdir", NULL};
+    const char *pszGDALFormat;
+    const char *pszTempDIR = "";
+    int nDataType;
+    PyObject *pInputsObj;
+    PyObject *pStepsObj;
+    if( !PyArg_ParseTupleAndKeywords(args, keywds, "OOsi|s:bandMathPipeline", kwlist, &pInputsObj, &pStepsObj, &pszGDALFormat, &nDataType, &pszTempDIR))
+    {
+        return NULL;
+    }
+
+    if( !PySequence_Check(pInputsObj))
+    {
+        PyErr_SetString(GETSTATE(self)->error, "inputs must be a sequence");
+        return NULL;
+    }
+    if( !PySequence_Check(pStepsObj))
+    {
+        PyErr_SetString(GETSTATE(self)->error, "steps must be a sequence");
+        return NULL;
+    }
+
+    std::vector<std::pair<std::string, std::string> > inputImages;
+    Py_ssize_t nInputs = PySequence_Size(pInputsObj);
+    for( Py_ssize_t n = 0; n < nInputs; n++ )
+    {
+        PyObject *o = PySequence_GetItem(pInputsObj, n);
+        if( !PySequence_Check(o) || (PySequence_Size(o) != 2) )
+        {
+            PyErr_SetString(GETSTATE(self)->error, "each input must be a sequence of (name, image)");
+            Py_DECREF(o);
+            return NULL;
+        }
+        PyObject *pName = PySequence_GetItem(o, 0);
+        PyObject *pImage = PySequence_GetItem(o, 1);
+        if( !RSGISPY_CHECK_STRING(pName) || !RSGISPY_CHECK_STRING(pImage) )
+        {
+            PyErr_SetString(GETSTATE(self)->error, "the name and image of an input must be strings");
+            Py_DECREF(pName);
+            Py_DECREF(pImage);
+            Py_DECREF(o);
+            return NULL;
+        }
+        inputImages.push_back(std::pair<std::string, std::string>(RSGISPY_STRING_EXTRACT(pName), RSGISPY_STRING_EXTRACT(pImage)));
+        Py_DECREF(pName);
+        Py_DECREF(pImage);
+        Py_DECREF(o);
+    }
+
+    std::vector<rsgis::cmds::BandMathsPipelineStep> steps;
+    Py_ssize_t nSteps = PySequence_Size(pStepsObj);
+    for( Py_ssize_t n = 0; n < nSteps; n++ )
+    {
+        PyObject *o = PySequence_GetItem(pStepsObj, n);
+        if( !PySequence_Check(o) || (PySequence_Size(o) != 4) )
+        {
+            PyErr_SetString(GETSTATE(self)->error, "each step must be a sequence of (name, exp, banddefseq, outputimg)");
+            Py_DECREF(o);
+            return NULL;
+        }
+        PyObject *pName = PySequence_GetItem(o, 0);
+        PyObject *pExp = PySequence_GetItem(o, 1);
+        PyObject *pBandDefnObj = PySequence_GetItem(o, 2);
+        PyObject *pOutputImg = PySequence_GetItem(o, 3);
+        Py_DECREF(o);
+        if( !RSGISPY_CHECK_STRING(pName) || !RSGISPY_CHECK_STRING(pExp) || !PySequence_Check(pBandDefnObj) || ( (pOutputImg != Py_None) && !RSGISPY_CHECK_STRING(pOutputImg) ) )
+        {
+            PyErr_SetString(GETSTATE(self)->error, "a step must have a string name and exp, a sequence of BandDefn objects and a string outputimg (or None)");
+            Py_DECREF(pName);
+            Py_DECREF(pExp);
+            Py_DECREF(pBandDefnObj);
+            Py_DECREF(pOutputImg);
+            return NULL;
+        }
+
+        rsgis::cmds::BandMathsPipelineStep step;
+        step.name = RSGISPY_STRING_EXTRACT(pName);
+        step.mathsExpression = RSGISPY_STRING_EXTRACT(pExp);
+        step.outputImage = (pOutputImg == Py_None)?"":RSGISPY_STRING_EXTRACT(pOutputImg);
+        Py_DECREF(pName);
+        Py_DECREF(pExp);
+        Py_DECREF(pOutputImg);
+
+        Py_ssize_t nBandDefns = PySequence_Size(pBandDefnObj);
+        for( Py_ssize_t b = 0; b < nBandDefns; b++ )
+        {
+            PyObject *pBandDefn = PySequence_GetItem(pBandDefnObj, b);
+            PyObject *pBandName = PyObject_GetAttrString(pBandDefn, "bandName");
+            PyObject *pFileName = PyObject_GetAttrString(pBandDefn, "fileName");
+            PyObject *pBandIndex = PyObject_GetAttrString(pBandDefn, "bandIndex");
+            Py_DECREF(pBandDefn);
+            if( ( pBandName == NULL ) || !RSGISPY_CHECK_STRING(pBandName) || ( pFileName == NULL ) || !RSGISPY_CHECK_STRING(pFileName) || ( pBandIndex == NULL ) || !RSGISPY_CHECK_INT(pBandIndex) )
+            {
+                PyErr_SetString(GETSTATE(self)->error, "could not find the string attributes \'bandName\' and \'fileName\' and the integer attribute \'bandIndex\'" );
+                Py_XDECREF(pBandName);
+                Py_XDECREF(pFileName);
+                Py_XDECREF(pBandIndex);
+                Py_DECREF(pBandDefnObj);
+                return NULL;
+            }
+            rsgis::cmds::VariableStruct var;
+            var.name = RSGISPY_STRING_EXTRACT(pBandName);
+            var.image = RSGISPY_STRING_EXTRACT(pFileName);
+            var.bandNum = RSGISPY_INT_EXTRACT(pBandIndex);
+            step.variables.push_back(var);
+            Py_DECREF(pBandName);
+            Py_DECREF(pFileName);
+            Py_DECREF(pBandIndex);
+        }
+        Py_DECREF(pBandDefnObj);
+        steps.push_back(step);
+    }
+
+    try
+    {
+        RSGISPyReleaseGIL releaseGIL;
+        rsgis::cmds::executeBandMathsPipeline(inputImages, steps, pszGDALFormat, (rsgis::RSGISLibDataType)nDataType, pszTempDIR);
+    }
+    catch(rsgis::cmds::RSGISCmdException &e)
+    {
+        PyErr_SetString(GETSTATE(self)->error, e.what());
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
 static PyObject *ImageCalc_ImageMath(PyObject *self, PyObject *args, PyObject *keywds)
 {
     static char *kwlist[] = {"inputimg", "outputimg", "exp", "gdalformat", "datatype", "expbandname", "outputexists", NULL};
@@ -142,7 +394,10 @@ static PyObject *ImageCalc_ImageMath(PyObject *self, PyObject *args, PyObject *k
         rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)nDataType;
         bool useExpAsbandName = (bool)bExpBandName;
         bool outputImgExists = (bool)bOutputImgExists;
-        rsgis::cmds::executeImageMaths(pszInputImage, pszOutputFile, pszExpression, pszGDALFormat, type, useExpAsbandName, outputImgExists);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeImageMaths(pszInputImage, pszOutputFile, pszExpression, pszGDALFormat, type, useExpAsbandName, outputImgExists);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -170,7 +425,10 @@ static PyObject *ImageCalc_ImageBandMath(PyObject *self, PyObject *args, PyObjec
         rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)nDataType;
         bool useExpAsbandName = (bool)bExpBandName;
         bool outputImgExists = (bool)bOutputImgExists;
-        rsgis::cmds::executeImageBandMaths(pszInputImage, pszOutputFile, pszExpression, pszGDALFormat, type, useExpAsbandName, outputImgExists);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeImageBandMaths(pszInputImage, pszOutputFile, pszExpression, pszGDALFormat, type, useExpAsbandName, outputImgExists);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -187,14 +445,18 @@ static PyObject *ImageCalc_KMeansClustering(PyObject *self, PyObject *args) {
     int nIgnoreZeros; // passed as a bool - seems the only way to pass into C
     float fDegreeOfChange;
     int nClusterMethod;
-    if( !PyArg_ParseTuple(args, "ssIIIifi:kMeansClustering", &pszInputImage, &pszOutputFile, &nNumClusters,
-                                &nMaxNumIterations, &nSubSample, &nIgnoreZeros, &fDegreeOfChange, &nClusterMethod ))
+    unsigned int nMiniBatchSize = 0;
+    if( !PyArg_ParseTuple(args, "ssIIIifi|I:kMeansClustering", &pszInputImage, &pszOutputFile, &nNumClusters,
+                                &nMaxNumIterations, &nSubSample, &nIgnoreZeros, &fDegreeOfChange, &nClusterMethod, &nMiniBatchSize ))
         return NULL;
     
     try
     {
-        rsgis::cmds::executeKMeansClustering(pszInputImage, pszOutputFile, nNumClusters, nMaxNumIterations,
-                            nSubSample, nIgnoreZeros, fDegreeOfChange, (rsgis::cmds::RSGISInitClustererMethods)nClusterMethod);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeKMeansClustering(pszInputImage, pszOutputFile, nNumClusters, nMaxNumIterations,
+                                nSubSample, nIgnoreZeros, fDegreeOfChange, (rsgis::cmds::RSGISInitClustererMethods)nClusterMethod, nMiniBatchSize);
+        }
         
     }
     catch(rsgis::cmds::RSGISCmdException &e)
@@ -221,9 +483,12 @@ static PyObject *ImageCalc_ISODataClustering(PyObject *self, PyObject *args) {
 
     try
     {
-        rsgis::cmds::executeISODataClustering(pszInputImage, pszOutputFile, nNumClusters, nMaxNumIterations,
-                            nSubSample, nIgnoreZeros, fDegreeOfChange, (rsgis::cmds::RSGISInitClustererMethods)nClusterMethod, fMinDistBetweenClusters,
-                            minNumFeatures, maxStdDev, minNumClusters, startIteration, endIteration);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeISODataClustering(pszInputImage, pszOutputFile, nNumClusters, nMaxNumIterations,
+                                nSubSample, nIgnoreZeros, fDegreeOfChange, (rsgis::cmds::RSGISInitClustererMethods)nClusterMethod, fMinDistBetweenClusters,
+                                minNumFeatures, maxStdDev, minNumClusters, startIteration, endIteration);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -244,7 +509,32 @@ static PyObject *ImageCalc_MahalanobisDistFilter(PyObject *self, PyObject *args)
     rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)datatype;
 
     try {
-        rsgis::cmds::executeMahalanobisDistFilter(inputImage, outputImage, winSize, gdalFormat, type);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeMahalanobisDistFilter(inputImage, outputImage, winSize, gdalFormat, type);
+        }
+    } catch(rsgis::cmds::RSGISCmdException &e) {
+        PyErr_SetString(GETSTATE(self)->error, e.what());
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *ImageCalc_LocalMahalanobisDistFilter(PyObject *self, PyObject *args) {
+    const char *inputImage, *outputImage, *gdalFormat;
+    unsigned int datatype, winSize;
+
+    if(!PyArg_ParseTuple(args, "ssIsI:localMahalanobisDistFilter", &inputImage, &outputImage, &winSize, &gdalFormat, &datatype))
+        return NULL;
+
+    rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)datatype;
+
+    try {
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeLocalMahalanobisDistFilter(inputImage, outputImage, winSize, gdalFormat, type);
+        }
     } catch(rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -263,7 +553,10 @@ static PyObject *ImageCalc_MahalanobisDist2ImgFilter(PyObject *self, PyObject *a
     rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)datatype;
 
     try {
-        rsgis::cmds::executeMahalanobisDist2ImgFilter(inputImage, outputImage, winSize, gdalFormat, type);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeMahalanobisDist2ImgFilter(inputImage, outputImage, winSize, gdalFormat, type);
+        }
     } catch(rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -279,7 +572,10 @@ static PyObject *ImageCalc_ImageCalcDistance(PyObject *self, PyObject *args) {
         return NULL;
 
     try {
-        rsgis::cmds::executeImageCalcDistance(inputImage, outputImage, gdalFormat);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeImageCalcDistance(inputImage, outputImage, gdalFormat);
+        }
     } catch (rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -525,7 +821,10 @@ static PyObject *ImageCalc_ImagePixelColumnSummary(PyObject *self, PyObject *arg
 
     try
     {
-        rsgis::cmds::executeImagePixelColumnSummary(inputImage, outputImage, summary, gdalFormat, type, noDataValue, useNoDataValue);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeImagePixelColumnSummary(inputImage, outputImage, summary, gdalFormat, type, noDataValue, useNoDataValue);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -545,7 +844,10 @@ static PyObject *ImageCalc_ImagePixelLinearFit(PyObject *self, PyObject *args) {
         return NULL;
 
     try {
-        rsgis::cmds::executeImagePixelLinearFit(inputImage, outputImage, gdalFormat, bandValues, noDataValue, useNoDataValue);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeImagePixelLinearFit(inputImage, outputImage, gdalFormat, bandValues, noDataValue, useNoDataValue);
+        }
     } catch (rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -554,6 +856,100 @@ static PyObject *ImageCalc_ImagePixelLinearFit(PyObject *self, PyObject *args) {
     Py_RETURN_NONE;
 }
 
+static PyObject *ImageCalc_ImagePixelModelFit(PyObject *self, PyObject *args, PyObject *keywds)
+{
+    static char *kwlist[] = {"inputimg", "outputimg", "gdalformat", "bandvalues", "model", "nterms", "period", "nodata", NULL};
+    const char *pszInputImage, *pszOutputImage, *pszGDALFormat, *pszBandValues, *pszModel;
+    unsigned int nTerms;
+    float period = 365.25;
+    PyObject *pNoDataObj = Py_None;
+    if( !PyArg_ParseTupleAndKeywords(args, keywds, "sssssI|fO:imagePixelModelFit", kwlist, &pszInputImage, &pszOutputImage, &pszGDALFormat, &pszBandValues, &pszModel, &nTerms, &period, &pNoDataObj))
+    {
+        return NULL;
+    }
+    
+    std::string model = std::string(pszModel);
+    if((model != "polynomial") && (model != "harmonic"))
+    {
+        PyErr_SetString(GETSTATE(self)->error, "The model must be either 'polynomial' or 'harmonic'.");
+        return NULL;
+    }
+    
+    bool useNoData = false;
+    float noDataVal = 0;
+    if(pNoDataObj != Py_None)
+    {
+        noDataVal = (float)PyFloat_AsDouble(pNoDataObj);
+        if(PyErr_Occurred())
+        {
+            return NULL;
+        }
+        useNoData = true;
+    }
+    
+    try
+    {
+        RSGISPyReleaseGIL releaseGIL;
+        rsgis::cmds::executeImagePixelModelFit(pszInputImage, pszOutputImage, pszGDALFormat, pszBandValues, (model == "harmonic"), nTerms, period, noDataVal, useNoData);
+    }
+    catch (rsgis::cmds::RSGISCmdException &e)
+    {
+        PyErr_SetString(GETSTATE(self)->error, e.what());
+        return NULL;
+    }
+    
+    Py_RETURN_NONE;
+}
+
+static PyObject *ImageCalc_ImagePixelRobustModelFit(PyObject *self, PyObject *args, PyObject *keywds)
+{
+    static char *kwlist[] = {"inputimg", "outputimg", "gdalformat", "bandvalues", "model", "nterms", "period", "maxiters", "tuning", "outlierthres", "outliers", "nodata", NULL};
+    const char *pszInputImage, *pszOutputImage, *pszGDALFormat, *pszBandValues, *pszModel;
+    unsigned int nTerms;
+    float period = 365.25;
+    unsigned int maxIters = 5;
+    float tuning = 4.685;
+    float outlierThres = 0;
+    int outputOutliers = 1;
+    PyObject *pNoDataObj = Py_None;
+    if( !PyArg_ParseTupleAndKeywords(args, keywds, "sssssI|fIffiO:imagePixelRobustModelFit", kwlist, &pszInputImage, &pszOutputImage, &pszGDALFormat, &pszBandValues, &pszModel, &nTerms, &period, &maxIters, &tuning, &outlierThres, &outputOutliers, &pNoDataObj))
+    {
+        return NULL;
+    }
+    
+    std::string model = std::string(pszModel);
+    if((model != "polynomial") && (model != "harmonic"))
+    {
+        PyErr_SetString(GETSTATE(self)->error, "The model must be either 'polynomial' or 'harmonic'.");
+        return NULL;
+    }
+    
+    bool useNoData = false;
+    float noDataVal = 0;
+    if(pNoDataObj != Py_None)
+    {
+        noDataVal = (float)PyFloat_AsDouble(pNoDataObj);
+        if(PyErr_Occurred())
+        {
+            return NULL;
+        }
+        useNoData = true;
+    }
+    
+    try
+    {
+        RSGISPyReleaseGIL releaseGIL;
+        rsgis::cmds::executeImagePixelRobustModelFit(pszInputImage, pszOutputImage, pszGDALFormat, pszBandValues, (model == "harmonic"), nTerms, period, maxIters, tuning, outlierThres, (outputOutliers != 0), noDataVal, useNoData);
+    }
+    catch (rsgis::cmds::RSGISCmdException &e)
+    {
+        PyErr_SetString(GETSTATE(self)->error, e.what());
+        return NULL;
+    }
+    
+    Py_RETURN_NONE;
+}
+
 static PyObject *ImageCalc_Normalisation(PyObject *self, PyObject *args) {
     PyObject *pInputImages, *pOutputImages;
     int calcInMinMax;
@@ -594,7 +990,10 @@ static PyObject *ImageCalc_Normalisation(PyObject *self, PyObject *args) {
     }
 
     try {
-        rsgis::cmds::executeNormalisation(inputImages, outputImages, calcInMinMax, inMin, inMax, outMin, outMax);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeNormalisation(inputImages, outputImages, calcInMinMax, inMin, inMax, outMin, outMax);
+        }
     } catch (rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -620,7 +1019,10 @@ static PyObject *ImageCalc_Correlation(PyObject *self, PyObject *args, PyObject
         unsigned int ncols = 0;
         double **outputMatrix = NULL;
 
-        outputMatrix = rsgis::cmds::executeCorrelation(inputImageA, inputImageB, outputMatrixFile, &nrows, &ncols);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            outputMatrix = rsgis::cmds::executeCorrelation(inputImageA, inputImageB, outputMatrixFile, &nrows, &ncols);
+        }
 
         outCorrelationMatrixList = PyTuple_New(nrows);
         
@@ -658,7 +1060,10 @@ static PyObject *ImageCalc_Covariance(PyObject *self, PyObject *args) {
         return NULL;
 
     try {
-        rsgis::cmds::executeCovariance(inputImageA, inputImageB, inputMatrixA, inputMatrixB, shouldCalcMean, outputMatrix);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCovariance(inputImageA, inputImageB, inputMatrixA, inputMatrixB, shouldCalcMean, outputMatrix);
+        }
     } catch (rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -674,7 +1079,10 @@ static PyObject *ImageCalc_MeanVector(PyObject *self, PyObject *args) {
         return NULL;
 
     try {
-        rsgis::cmds::executeMeanVector(inputImage, outputMatrix);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeMeanVector(inputImage, outputMatrix);
+        }
     } catch (rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -683,30 +1091,81 @@ static PyObject *ImageCalc_MeanVector(PyObject *self, PyObject *args) {
     Py_RETURN_NONE;
 }
 
-static PyObject *ImageCalc_PCA(PyObject *self, PyObject *args)
+static PyObject *ImageCalc_PCA(PyObject *self, PyObject *args)
+{
+    const char *eigenVectors, *inputImage, *outputImage;
+    unsigned int numComponents;
+    const char *gdalFormat;
+    int datatype;
+
+    if(!PyArg_ParseTuple(args, "sssIsi:pca", &inputImage, &eigenVectors, &outputImage, &numComponents, &gdalFormat, &datatype))
+    {
+        return NULL;
+    }
+    
+    try
+    {
+        rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)datatype;
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePCA(std::string(inputImage), std::string(eigenVectors), std::string(outputImage), numComponents, std::string(gdalFormat), type);
+        }
+    }
+    catch (rsgis::cmds::RSGISCmdException &e)
+    {
+        PyErr_SetString(GETSTATE(self)->error, e.what());
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *ImageCalc_CalcImagePCA(PyObject *self, PyObject *args, PyObject *keywds)
 {
-    const char *eigenVectors, *inputImage, *outputImage;
-    unsigned int numComponents;
-    const char *gdalFormat;
-    int datatype;
-
-    if(!PyArg_ParseTuple(args, "sssIsi:pca", &inputImage, &eigenVectors, &outputImage, &numComponents, &gdalFormat, &datatype))
+    static char *kwlist[] = {"inputimg", "outputimg", "outeigenvecs", "ncomponents", "gdalformat", "datatype", "nodata", "randomised", NULL};
+    const char *pszInputImage, *pszOutputImage, *pszOutEigenVecs, *pszGDALFormat;
+    unsigned int nComponents;
+    int nDataType;
+    PyObject *pNoDataObj = Py_None;
+    int bRandomised = 0;
+    if( !PyArg_ParseTupleAndKeywords(args, keywds, "sssIsi|Oi:calcImagePCA", kwlist, &pszInputImage, &pszOutputImage, &pszOutEigenVecs, &nComponents, &pszGDALFormat, &nDataType, &pNoDataObj, &bRandomised))
     {
         return NULL;
     }
     
+    bool useNoData = false;
+    float noDataVal = 0;
+    if(pNoDataObj != Py_None)
+    {
+        noDataVal = (float)PyFloat_AsDouble(pNoDataObj);
+        if(PyErr_Occurred())
+        {
+            return NULL;
+        }
+        useNoData = true;
+    }
+    
+    std::vector<double> varExplained;
     try
     {
-        rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)datatype;
-        rsgis::cmds::executePCA(std::string(inputImage), std::string(eigenVectors), std::string(outputImage), numComponents, std::string(gdalFormat), type);
+        rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)nDataType;
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            varExplained = rsgis::cmds::executeImagePCA(std::string(pszInputImage), std::string(pszOutputImage), std::string(pszOutEigenVecs), nComponents, std::string(pszGDALFormat), type, useNoData, noDataVal, (bool)bRandomised);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
     }
-
-    Py_RETURN_NONE;
+    
+    PyObject *pVarExplained = PyList_New(varExplained.size());
+    for(size_t i = 0; i < varExplained.size(); ++i)
+    {
+        PyList_SetItem(pVarExplained, i, PyFloat_FromDouble(varExplained[i]));
+    }
+    return pVarExplained;
 }
 
 static PyObject *ImageCalc_Standardise(PyObject *self, PyObject *args) {
@@ -716,7 +1175,10 @@ static PyObject *ImageCalc_Standardise(PyObject *self, PyObject *args) {
         return NULL;
 
     try {
-        rsgis::cmds::executeStandardise(meanVector, inputImage, outputImage);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeStandardise(meanVector, inputImage, outputImage);
+        }
     } catch (rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -733,7 +1195,10 @@ static PyObject *ImageCalc_ReplaceValuesLessThan(PyObject *self, PyObject *args)
         return NULL;
 
     try {
-        rsgis::cmds::executeReplaceValuesLessThan(inputImage, outputImage, threshold, value);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeReplaceValuesLessThan(inputImage, outputImage, threshold, value);
+        }
     } catch (rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -749,7 +1214,10 @@ static PyObject *ImageCalc_UnitArea(PyObject *self, PyObject *args) {
         return NULL;
 
     try {
-        rsgis::cmds::executeUnitArea(inputImage, outputImage, inputMatrix);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeUnitArea(inputImage, outputImage, inputMatrix);
+        }
     } catch (rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -827,7 +1295,10 @@ static PyObject *ImageCalc_MovementSpeed(PyObject *self, PyObject *args)
 
     // run the command
     try {
-        rsgis::cmds::executeMovementSpeed(inputImages, imageBands, imageTimes, upper, lower, outputImage);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeMovementSpeed(inputImages, imageBands, imageTimes, upper, lower, outputImage);
+        }
     } catch (rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -844,7 +1315,10 @@ static PyObject *ImageCalc_CountValsInCols(PyObject *self, PyObject *args) {
         return NULL;
 
     try {
-        rsgis::cmds::executeCountValsInCols(inputImage, upper, lower, outputImage);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCountValsInCols(inputImage, upper, lower, outputImage);
+        }
     } catch (rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -866,7 +1340,11 @@ static PyObject *ImageCalc_CalculateRMSE(PyObject *self, PyObject *args) {
     PyObject *outVal = PyTuple_New(1);
     try
     {
-        double rmseVal = rsgis::cmds::executeCalculateRMSE(inputImageA, bandA, inputImageB, bandB);
+        double rmseVal = 0;
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rmseVal = rsgis::cmds::executeCalculateRMSE(inputImageA, bandA, inputImageB, bandB);
+        }
         if(PyTuple_SetItem(outVal, 0, Py_BuildValue("d", rmseVal)) == -1)
         {
             throw rsgis::cmds::RSGISCmdException("Failed to add \'RMSE\' value to the list...");
@@ -889,7 +1367,10 @@ static PyObject *ImageCalc_Dist2Geoms(PyObject *self, PyObject *args) {
         return NULL;
 
     try {
-        rsgis::cmds::executeDist2Geoms(inputVector, imgResolution, outputImage);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeDist2Geoms(inputVector, imgResolution, outputImage);
+        }
     } catch (rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -906,7 +1387,10 @@ static PyObject *ImageCalc_ImageBandStats(PyObject *self, PyObject *args) {
         return NULL;
 
     try {
-        rsgis::cmds::executeImageBandStats(inputImage, outputFile, ignoreZeros);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeImageBandStats(inputImage, outputFile, ignoreZeros);
+        }
     } catch (rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -923,7 +1407,10 @@ static PyObject *ImageCalc_ImageStats(PyObject *self, PyObject *args) {
         return NULL;
 
     try {
-        rsgis::cmds::executeImageStats(inputImage, outputFile, ignoreZeros);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeImageStats(inputImage, outputFile, ignoreZeros);
+        }
     } catch (rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -948,7 +1435,10 @@ static PyObject *ImageCalc_UnconLinearSpecUnmix(PyObject *self, PyObject *args)
 
     try
     {
-        rsgis::cmds::executeUnconLinearSpecUnmix(inputImage, imageFormat, type, lsumGain, lsumOffset, outputFile, endmembersFile);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeUnconLinearSpecUnmix(inputImage, imageFormat, type, lsumGain, lsumOffset, outputFile, endmembersFile);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -976,7 +1466,10 @@ static PyObject *ImageCalc_ExhconLinearSpecUnmix(PyObject *self, PyObject *args)
 
     try
     {
-        rsgis::cmds::executeExhconLinearSpecUnmix(inputImage, imageFormat, type, lsumGain, lsumOffset, outputFile, endmembersFile, stepResolution);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeExhconLinearSpecUnmix(inputImage, imageFormat, type, lsumGain, lsumOffset, outputFile, endmembersFile, stepResolution);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -1004,7 +1497,10 @@ static PyObject *ImageCalc_ConSum1LinearSpecUnmix(PyObject *self, PyObject *args
 
     try
     {
-        rsgis::cmds::executeConSum1LinearSpecUnmix(inputImage, imageFormat, type, lsumGain, lsumOffset, lsumWeight, outputFile, endmembersFile);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeConSum1LinearSpecUnmix(inputImage, imageFormat, type, lsumGain, lsumOffset, lsumWeight, outputFile, endmembersFile);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -1032,7 +1528,10 @@ static PyObject *ImageCalc_NnConSum1LinearSpecUnmix(PyObject *self, PyObject *ar
 
     try
     {
-        rsgis::cmds::executeNnConSum1LinearSpecUnmix(inputImage, imageFormat, type, lsumGain, lsumOffset, lsumWeight, outputFile, endmembersFile);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeNnConSum1LinearSpecUnmix(inputImage, imageFormat, type, lsumGain, lsumOffset, lsumWeight, outputFile, endmembersFile);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -1055,7 +1554,10 @@ static PyObject *ImageCalc_AllBandsEqualTo(PyObject *self, PyObject *args) {
 
     try
     {
-        rsgis::cmds::executeAllBandsEqualTo(inputImage, imgValue, outputTrueVal, outputFalseVal, outputImage, imageFormat, type);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeAllBandsEqualTo(inputImage, imgValue, outputTrueVal, outputFalseVal, outputImage, imageFormat, type);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -1077,7 +1579,10 @@ static PyObject *ImageCalc_Histogram(PyObject *self, PyObject *args) {
         return NULL;
 
     try {
-        rsgis::cmds::executeHistogram(inputImage, imageMask, outputFile, imgBand, imgValue, binWidth, calcInMinMax, inMin, inMax);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeHistogram(inputImage, imageMask, outputFile, imgBand, imgValue, binWidth, calcInMinMax, inMin, inMax);
+        }
     } catch (rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -1102,7 +1607,11 @@ static PyObject *ImageCalc_GetHistogram(PyObject *self, PyObject *args) {
         unsigned int nBins = 0;
         double inMinVal = inMin;
         double inMaxVal = inMax;
-        unsigned int *bins = rsgis::cmds::executeGetHistogram(inputImage, imgBand, binWidth, &nBins, calcInMinMax, &inMinVal, &inMaxVal);
+        unsigned int *bins = NULL;
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            bins = rsgis::cmds::executeGetHistogram(inputImage, imgBand, binWidth, &nBins, calcInMinMax, &inMinVal, &inMaxVal);
+        }
         
         Py_ssize_t listLen = nBins;
         
@@ -1151,8 +1660,9 @@ static PyObject *ImageCalc_BandPercentile(PyObject *self, PyObject *args)
     const char *inputImage;
     float percentile;
     PyObject *noDataValueObj;
+    float maxError = 0;
 
-    if(!PyArg_ParseTuple(args, "sfO:bandPercentile", &inputImage, &percentile, &noDataValueObj))
+    if(!PyArg_ParseTuple(args, "sfO|f:bandPercentile", &inputImage, &percentile, &noDataValueObj, &maxError))
     {
         return NULL;
     }
@@ -1171,7 +1681,11 @@ static PyObject *ImageCalc_BandPercentile(PyObject *self, PyObject *args)
     PyObject *outVals = NULL;
     try
     {
-        std::vector<double> outPercentileVals = rsgis::cmds::executeBandPercentile(inputImage, percentile, noDataValue, haveNoDataValue);
+        std::vector<double> outPercentileVals;
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            outPercentileVals = rsgis::cmds::executeBandPercentile(inputImage, percentile, noDataValue, haveNoDataValue, maxError);
+        }
         
         Py_ssize_t listLen = outPercentileVals.size();
         outVals = PyTuple_New(listLen);
@@ -1199,7 +1713,10 @@ static PyObject *ImageCalc_ImageDist2Geoms(PyObject *self, PyObject *args) {
         return NULL;
 
     try {
-        rsgis::cmds::executeImageDist2Geoms(inputImage, inputVector, imageFormat, outputImage);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeImageDist2Geoms(inputImage, inputVector, imageFormat, outputImage);
+        }
     } catch (rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -1218,7 +1735,10 @@ static PyObject *ImageCalc_CorrelationWindow(PyObject *self, PyObject *args) {
     rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)datatype;
     try 
     {
-    rsgis::cmds::executeCorrelationWindow(pszInputImage, pszOutputImage, windowSize, bandA, bandB, pszGDALFormat, type);
+    {
+        RSGISPyReleaseGIL releaseGIL;
+        rsgis::cmds::executeCorrelationWindow(pszInputImage, pszOutputImage, windowSize, bandA, bandB, pszGDALFormat, type);
+    }
     } catch (rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -1260,7 +1780,10 @@ static PyObject *ImageCalc_GetImageStatsInEnv(PyObject *self, PyObject *args) {
         stats->stddev = 0;
         stats->sum = 0;
         
-        rsgis::cmds::executeImageBandStatsEnv(std::string(inputImage), stats, imgBand, noDataValueSpecified, noDataValue, longMin, longMax, latMin, latMax);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeImageBandStatsEnv(std::string(inputImage), stats, imgBand, noDataValueSpecified, noDataValue, longMin, longMax, latMin, latMax);
+        }
         
         
         if(PyTuple_SetItem(outValsList, 0, Py_BuildValue("d", stats->min)) == -1)
@@ -1322,7 +1845,11 @@ static PyObject *ImageCalc_GetImageBandModeInEnv(PyObject *self, PyObject *args)
     PyObject *outVal = PyTuple_New(1);
     try
     {
-        float modeVal = rsgis::cmds::executeImageBandModeEnv(std::string(inputImage), binWidth, imgBand, noDataValueSpecified, noDataValue, longMin, longMax, latMin, latMax);
+        float modeVal = 0;
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            modeVal = rsgis::cmds::executeImageBandModeEnv(std::string(inputImage), binWidth, imgBand, noDataValueSpecified, noDataValue, longMin, longMax, latMin, latMax);
+        }
         
         if(PyTuple_SetItem(outVal, 0, Py_BuildValue("f", modeVal)) == -1)
         {
@@ -1364,7 +1891,11 @@ static PyObject *ImageCalc_Get2DImageHistogram(PyObject *self, PyObject *args)
         double binWidthImg1 = 0.0;
         double binWidthImg2 = 0.0;
         
-        double rSq = rsgis::cmds::executeImageComparison2dHisto(std::string(inputImage1), std::string(inputImage2), std::string(outputImage), std::string(gdalFormat), img1Band, img2Band, numBins, &binWidthImg1, &binWidthImg2, img1Min, img1Max, img2Min, img2Max, img1Scale, img2Scale, img1Off, img2Off, ((bool)normOutput));
+        double rSq = 0;
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rSq = rsgis::cmds::executeImageComparison2dHisto(std::string(inputImage1), std::string(inputImage2), std::string(outputImage), std::string(gdalFormat), img1Band, img2Band, numBins, &binWidthImg1, &binWidthImg2, img1Min, img1Max, img2Min, img2Max, img1Scale, img2Scale, img1Off, img2Off, ((bool)normOutput));
+        }
                 
         if(PyTuple_SetItem(outVal, 0, Py_BuildValue("d", binWidthImg1)) == -1)
         {
@@ -1455,7 +1986,10 @@ static PyObject *ImageCalc_CalcMaskImgPxlValProb(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeCalcMaskImgPxlValProb(std::string(pszInputImage), inImgBandIdxs, std::string(pszMaskImage), maskImgVal, std::string(pszOutputImage), std::string(pszGDALFormat), histBinWidths, calcHistBinWidth, useImgNoData, rescaleProbs);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCalcMaskImgPxlValProb(std::string(pszInputImage), inImgBandIdxs, std::string(pszMaskImage), maskImgVal, std::string(pszOutputImage), std::string(pszGDALFormat), histBinWidths, calcHistBinWidth, useImgNoData, rescaleProbs);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -1544,7 +2078,10 @@ static PyObject *ImageCalc_CalcPropTrueExp(PyObject *self, PyObject *args)
     float prop = 0.0;
     try
     {
-        prop = rsgis::cmds::executeCalcPropTrueExp(pRSGISStruct, nBandDefns, std::string(pszExpression), inValidImage, useValidImg);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            prop = rsgis::cmds::executeCalcPropTrueExp(pRSGISStruct, nBandDefns, std::string(pszExpression), inValidImage, useValidImg);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1759,7 +2296,10 @@ static PyObject *ImageCalc_CalcImageRescale(PyObject *self, PyObject *args)
     try
     {
         rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)datatype;
-        rsgis::cmds::executeRescaleImages(inputImgs, std::string(outputImage), std::string(gdalFormat), type, cNoDataVal, cOffset, cGain, nNoDataVal, nOffset, nGain);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeRescaleImages(inputImgs, std::string(outputImage), std::string(gdalFormat), type, cNoDataVal, cOffset, cGain, nNoDataVal, nOffset, nGain);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -1829,7 +2369,10 @@ static PyObject *ImageCalc_GetImgIdxForStat(PyObject *self, PyObject *args, PyOb
     
     try
     {
-        rsgis::cmds::executeGetImgIdxForStat(inputImages, std::string(pszOutputImage), std::string(pszGDALFormat), noDataVal, summaryStats);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeGetImgIdxForStat(inputImages, std::string(pszOutputImage), std::string(pszGDALFormat), noDataVal, summaryStats);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1931,7 +2474,10 @@ static PyObject *ImageCalc_GetImgSumStatsInPxl(PyObject *self, PyObject *args, P
     {
         bool useNoData = (bool) useImgDataVal;
         rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)datatype;
-        rsgis::cmds::executeGetWithinPxlImgStatSummaries(std::string(pInputRefImage), std::string(pInputStatsImage), statsImgBand, std::string(pszOutputImage), std::string(pszGDALFormat), type, useNoData, cmdSumStats, xIOGrid, yIOGrid);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeGetWithinPxlImgStatSummaries(std::string(pInputRefImage), std::string(pInputStatsImage), statsImgBand, std::string(pszOutputImage), std::string(pszGDALFormat), type, useNoData, cmdSumStats, xIOGrid, yIOGrid);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1996,7 +2542,10 @@ static PyObject *ImageCalc_IdentifyMinPxlValueInWin(PyObject *self, PyObject *ar
     try
     {
         bool useNoData = (bool) useNoDataValue;
-        rsgis::cmds::executeIdentifyMinPxlValueInWin(std::string(pInputImage), std::string(pszOutputImage), std::string(pszOutputRefImage), bandsVec, winSize, std::string(pszGDALFormat), noDataValue, useNoData);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeIdentifyMinPxlValueInWin(std::string(pInputImage), std::string(pszOutputImage), std::string(pszOutputRefImage), bandsVec, winSize, std::string(pszGDALFormat), noDataValue, useNoData);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -2057,7 +2606,10 @@ static PyObject *ImageCalc_CalcImgMeanInMask(PyObject *self, PyObject *args, PyO
     try
     {
         bool useNoData = (bool) useNoDataValue;
-        meanVal = rsgis::cmds::executeCalcImgMeanInMask(std::string(pInputImage), std::string(pInputImageMsk), mskValue, bandsVec, noDataValue, useNoData);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            meanVal = rsgis::cmds::executeCalcImgMeanInMask(std::string(pInputImage), std::string(pInputImageMsk), mskValue, bandsVec, noDataValue, useNoData);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -2069,6 +2621,172 @@ static PyObject *ImageCalc_CalcImgMeanInMask(PyObject *self, PyObject *args, PyO
     return outVal;
 }
 
+#if PY_MAJOR_VERSION >= 3
+// Calls a Python function with each block from executeImageBlockCalc. The
+// planes are passed as memoryviews onto the image calc engine's buffers (no
+// copy), which are released once the function returns. The GIL is only held
+// while the function is called.
+class RSGISPyImageBlockFunction : public rsgis::cmds::RSGISCmdImageBlockFunction
+{
+public:
+    RSGISPyImageBlockFunction(PyObject *pFunc)
+    {
+        m_pFunc = pFunc;
+        m_pErrType = NULL;
+        m_pErrValue = NULL;
+        m_pErrTraceback = NULL;
+    }
+    void calcBlock(const float* const* inPlanes, unsigned int numInBands, double **outPlanes, unsigned int numOutBands, unsigned int width, unsigned int nRows)
+    {
+        PyGILState_STATE gilState = PyGILState_Ensure();
+        size_t nPxls = ((size_t)width) * nRows;
+        PyObject *pInList = PyList_New(numInBands);
+        for(unsigned int n = 0; n < numInBands; ++n)
+        {
+            PyList_SET_ITEM(pInList, n, PyMemoryView_FromMemory((char*)inPlanes[n], nPxls * sizeof(float), PyBUF_READ));
+        }
+        PyObject *pOutList = PyList_New(numOutBands);
+        for(unsigned int n = 0; n < numOutBands; ++n)
+        {
+            PyList_SET_ITEM(pOutList, n, PyMemoryView_FromMemory((char*)outPlanes[n], nPxls * sizeof(double), PyBUF_WRITE));
+        }
+        
+        PyObject *pResult = PyObject_CallFunction(m_pFunc, "OOII", pInList, pOutList, width, nRows);
+        bool failed = (pResult == NULL);
+        if(failed)
+        {
+            PyErr_Fetch(&m_pErrType, &m_pErrValue, &m_pErrTraceback);
+        }
+        Py_XDECREF(pResult);
+        
+        // The buffers are re-used for the next block so must not be kept.
+        bool released = releaseViews(pInList);
+        released = releaseViews(pOutList) && released;
+        if(!released && !failed)
+        {
+            PyErr_SetString(PyExc_BufferError, "The block arrays must not be kept after the block function returns.");
+            PyErr_Fetch(&m_pErrType, &m_pErrValue, &m_pErrTraceback);
+            failed = true;
+        }
+        PyGILState_Release(gilState);
+        
+        if(failed)
+        {
+            throw rsgis::cmds::RSGISCmdException("The block function raised an exception.");
+        }
+    }
+    // Restores the exception raised within the block function (if any); must
+    // be called with the GIL held. Returns false if there was no exception.
+    bool restoreError()
+    {
+        if(m_pErrType == NULL)
+        {
+            return false;
+        }
+        PyErr_Restore(m_pErrType, m_pErrValue, m_pErrTraceback);
+        m_pErrType = NULL;
+        m_pErrValue = NULL;
+        m_pErrTraceback = NULL;
+        return true;
+    }
+    ~RSGISPyImageBlockFunction()
+    {
+        Py_XDECREF(m_pErrType);
+        Py_XDECREF(m_pErrValue);
+        Py_XDECREF(m_pErrTraceback);
+    }
+private:
+    static bool releaseViews(PyObject *pList)
+    {
+        bool released = true;
+        for(Py_ssize_t n = 0; n < PyList_GET_SIZE(pList); ++n)
+        {
+            PyObject *pRelease = PyObject_CallMethod(PyList_GET_ITEM(pList, n), "release", NULL);
+            if(pRelease == NULL)
+            {
+                PyErr_Clear();
+                released = false;
+            }
+            Py_XDECREF(pRelease);
+        }
+        Py_DECREF(pList);
+        return released;
+    }
+    PyObject *m_pFunc;
+    PyObject *m_pErrType;
+    PyObject *m_pErrValue;
+    PyObject *m_pErrTraceback;
+};
+
+static PyObject *ImageCalc_CalcImageBlocks(PyObject *self, PyObject *args, PyObject *keywds)
+{
+    static char *kwlist[] = {"inputimgs", "outputimg", "gdalformat", "datatype", "numoutbands", "blockfunc", NULL};
+    PyObject *pInputImgsObj;
+    const char *outputImage, *gdalFormat;
+    int datatype;
+    unsigned int numOutBands;
+    PyObject *pBlockFunc;
+    
+    if( !PyArg_ParseTupleAndKeywords(args, keywds, "OssiIO:calcImageBlocks", kwlist, &pInputImgsObj, &outputImage, &gdalFormat, &datatype, &numOutBands, &pBlockFunc))
+    {
+        return NULL;
+    }
+    
+    if(!PyCallable_Check(pBlockFunc))
+    {
+        PyErr_SetString(GETSTATE(self)->error, "blockfunc must be callable");
+        return NULL;
+    }
+    
+    std::vector<std::string> inputImgs;
+    if(PySequence_Check(pInputImgsObj) && !RSGISPY_CHECK_STRING(pInputImgsObj))
+    {
+        Py_ssize_t nInputImgs = PySequence_Size(pInputImgsObj);
+        for( Py_ssize_t n = 0; n < nInputImgs; n++ )
+        {
+            PyObject *strObj = PySequence_GetItem(pInputImgsObj, n);
+            if(!RSGISPY_CHECK_STRING(strObj))
+            {
+                PyErr_SetString(GETSTATE(self)->error, "Input images sequence must contain a list of strings");
+                Py_DECREF(strObj);
+                return NULL;
+            }
+            inputImgs.push_back(RSGISPY_STRING_EXTRACT(strObj));
+            Py_DECREF(strObj);
+        }
+    }
+    else if(RSGISPY_CHECK_STRING(pInputImgsObj))
+    {
+        inputImgs.push_back(RSGISPY_STRING_EXTRACT(pInputImgsObj));
+    }
+    else
+    {
+        PyErr_SetString(GETSTATE(self)->error, "Input images parameter must be either a single string or a sequence of strings");
+        return NULL;
+    }
+    
+    RSGISPyImageBlockFunction blockFunc(pBlockFunc);
+    try
+    {
+        rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)datatype;
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeImageBlockCalc(inputImgs, std::string(outputImage), std::string(gdalFormat), type, numOutBands, &blockFunc);
+        }
+    }
+    catch(rsgis::cmds::RSGISCmdException &e)
+    {
+        if(!blockFunc.restoreError())
+        {
+            PyErr_SetString(GETSTATE(self)->error, e.what());
+        }
+        return NULL;
+    }
+    
+    Py_RETURN_NONE;
+}
+#endif
+
 // Our list of functions in this module
 static PyMethodDef ImageCalcMethods[] = {
     {"bandMath", (PyCFunction)ImageCalc_BandMath, METH_VARARGS | METH_KEYWORDS,
@@ -2112,6 +2830,62 @@ static PyMethodDef ImageCalcMethods[] = {
 "\n"
 "\n"},
 
+{"bandMathMaskStretch", (PyCFunction)ImageCalc_BandMathMaskStretch, METH_VARARGS | METH_KEYWORDS,
+"rsgislib.imagecalc.bandMathMaskStretch(outputimg, exp, gdalformat, datatype, banddefseq, maskimg, maskvals, maskoutval, inmin, inmax, outmin, outmax)\n"
+"Performs a band math calculation, masks the result and linearly stretches it in a single pass.\n"
+"No intermediate images are written; the three steps are evaluated together for each block of the image.\n"
+"\n"
+"Where:\n"
+"\n"
+":param outputimg: is a string containing the name of the output file\n"
+":param exp: is a string containing the expression to run over the images, uses muparser syntax.\n"
+":param gdalformat: is a string containing the GDAL format for the output file - eg 'KEA'\n"
+":param datatype: is an containing one of the values from rsgislib.TYPE_*\n"
+":param banddefseq: is a sequence of rsgislib.imagecalc.BandDefn objects that define the inputs\n"
+":param maskimg: is a string containing the name of the mask image (band 1 is used)\n"
+":param maskvals: is a number or list of numbers; pixels where the mask has one of these values are masked\n"
+":param maskoutval: is a float for the output value of the masked pixels (they are not stretched)\n"
+":param inmin: is a float for the band maths value stretched to outmin\n"
+":param inmax: is a float for the band maths value stretched to outmax\n"
+":param outmin: is a float for the minimum of the output stretch\n"
+":param outmax: is a float for the maximum of the output stretch\n"
+"\n"
+"Example::\n"
+"\n"
+"   import rsgislib\n"
+"   from rsgislib import imagecalc\n"
+"   from rsgislib.imagecalc import BandDefn\n"
+"   bandDefns = []\n"
+"   bandDefns.append(BandDefn('red', inFileName, 3))\n"
+"   bandDefns.append(BandDefn('nir', inFileName, 4))\n"
+"   imagecalc.bandMathMaskStretch('ndvi_stch.kea', '(nir-red)/(nir+red)', 'KEA', rsgislib.TYPE_8UINT, bandDefns, 'clouds.kea', [1, 2], 0, -1, 1, 1, 255)\n"
+"\n"},
+
+{"bandMathPipeline", (PyCFunction)ImageCalc_BandMathPipeline, METH_VARARGS | METH_KEYWORDS,
+"rsgislib.imagecalc.bandMathPipeline(inputs, steps, gdalformat, datatype, tempdir='')\n"
+"Runs a workflow of band maths steps, where a step can use the inputs and the outputs of earlier steps.\n"
+"Only the steps given an output image are written; the steps are fused into as few passes over the images as possible, so the intermediate results are not written.\n"
+"\n"
+"Where:\n"
+"\n"
+":param inputs: is a sequence of (name, image) pairs naming the input images for the steps\n"
+":param steps: is a sequence of (name, exp, banddefseq, outputimg) steps, in order. exp is a muparser expression, banddefseq is a sequence of rsgislib.imagecalc.BandDefn objects where the fileName is the name of an input or of an earlier step (which has one band) and outputimg is the output file for the step or None\n"
+":param gdalformat: is a string containing the GDAL format for the output files - eg 'KEA'\n"
+":param datatype: is an containing one of the values from rsgislib.TYPE_*\n"
+":param tempdir: is a string containing a directory for any temporary images (the system temporary directory if empty)\n"
+"\n"
+"Example::\n"
+"\n"
+"   import rsgislib\n"
+"   from rsgislib import imagecalc\n"
+"   from rsgislib.imagecalc import BandDefn\n"
+"   inputs = [('casi', inFileName)]\n"
+"   ndviBands = [BandDefn('red', 'casi', 3), BandDefn('nir', 'casi', 4)]\n"
+"   vegBands = [BandDefn('ndvi', 'ndvi', 1)]\n"
+"   steps = [('ndvi', '(nir-red)/(nir+red)', ndviBands, None), ('veg', 'ndvi>0.5?1:0', vegBands, 'veg.kea')]\n"
+"   imagecalc.bandMathPipeline(inputs, steps, 'KEA', rsgislib.TYPE_8UINT)\n"
+"\n"},
+
 {"imageMath", (PyCFunction)ImageCalc_ImageMath, METH_VARARGS | METH_KEYWORDS,
 "rsgislib.imagecalc.imageMath(inputimg, outputimg, exp, gdalformat, datatype, expbandname, outputexists)\n"
 "Performs image math calculations. Produces an output image file with the same number of bands as the input image.\n"
@@ -2176,7 +2950,7 @@ static PyMethodDef ImageCalcMethods[] = {
 "\n"},
 
 {"kMeansClustering", ImageCalc_KMeansClustering, METH_VARARGS,
-"rsgislib.imagecalc.kMeansClustering(inputImage, outputMatrix, numClusters, maxIterations, subSample, ignoreZeros, degreeOfChange, initMethod)\n"
+"rsgislib.imagecalc.kMeansClustering(inputImage, outputMatrix, numClusters, maxIterations, subSample, ignoreZeros, degreeOfChange, initMethod, miniBatchSize=0)\n"
 "Performs K Means Clustering and saves cluster centres to a text file.\n"
 "\n"
 "Where:\n"
@@ -2189,6 +2963,7 @@ static PyMethodDef ImageCalcMethods[] = {
 ":param ignoreZeros: is a bool specifying if zeros in the image should be treated as no data.\n"
 ":param degreeofChange: is a float providing the minimum change between itterations before terminating.\n"
 ":param initMethod: the method for initialising the clusters and is one of INITCLUSTER_* values\n"
+":param miniBatchSize: is an optional int; if greater than 0 mini-batch k-means is used, updating the centres from random batches of this many sampled pixels each iteration (default = 0; standard k-means).\n"
 "\n"
 "Example::\n"
 "\n"
@@ -2247,6 +3022,22 @@ static PyMethodDef ImageCalcMethods[] = {
 "\n"
 },
 
+{"localMahalanobisDistFilter", ImageCalc_LocalMahalanobisDistFilter, METH_VARARGS,
+"rsgislib.imagecalc.localMahalanobisDistFilter(inputImage, outputImage, windowSize, gdalformat, datatype)\n"
+"Calculates the mahalanobis distance of each pixel from the mean of the window around it, using the\n"
+"covariance of the window (i.e., a local RX anomaly detector). The window statistics are updated with\n"
+"running sums so the run time does not depend on the window size.\n"
+"\n"
+"Where:\n"
+"\n"
+":param inputImage: is a string containing the name of the input file\n"
+":param outputImage: is a string containing the name of the output file\n"
+":param windowSize: is an int defining the size of the window to be used\n"
+":param gdalformat: is a string containing the GDAL format for the output file - eg 'KEA'\n"
+":param datatype: is an int containing one of the values from rsgislib.TYPE_*\n"
+"\n"
+},
+
 {"mahalanobisDist2ImgFilter", ImageCalc_MahalanobisDist2ImgFilter, METH_VARARGS,
 "rsgislib.imagecalc.mahalanobisDist2ImgFilter(inputImage, outputImage, windowSize, gdalformat, datatype)\n"
 "Performs mahalanobis distance image to window filter.\n"
@@ -2263,7 +3054,9 @@ static PyMethodDef ImageCalcMethods[] = {
 
 {"imageCalcDistance", ImageCalc_ImageCalcDistance, METH_VARARGS,
 "rsgislib.imagecalc.imageCalcDistance(inputImage, outputImage, gdalformat)\n"
-"Performs image calculate distance command.\n"
+"Calculates, for the pixels of the first band with the value -1, the Euclidean distance\n"
+"(in the units of the pixel size) to the nearest pixel with any other value, which are 0.\n"
+"If the image has no such pixels the output is -1.\n"
 "\n"
 "Where:\n"
 "\n"
@@ -2333,6 +3126,59 @@ static PyMethodDef ImageCalcMethods[] = {
 "\n"
 },
 
+{"imagePixelModelFit", (PyCFunction)ImageCalc_ImagePixelModelFit, METH_VARARGS | METH_KEYWORDS,
+"rsgislib.imagecalc.imagePixelModelFit(inputimg, outputimg, gdalformat, bandvalues, model, nterms, period=365.25, nodata=None)\n"
+"Fits a polynomial or harmonic model to each column of pixels by least squares. The output image has a band\n"
+"for each model coefficient followed by the RMSE of the fit. No data values are ignored, and pixels with fewer\n"
+"valid values than coefficients are given 0. Pixels with the same pattern of valid bands share a\n"
+"factorisation so whole blocks are fitted at once (using RSGISLIB_NUM_THREADS threads).\n"
+"\n"
+"Where:\n"
+"\n"
+":param inputimg: is a string containing the name of the input file\n"
+":param outputimg: is a string containing the name of the output file\n"
+":param gdalformat: is a string containing the GDAL format for the output file - eg 'KEA'\n"
+":param bandvalues: is text file containing the value of each band (e.g. wavelength, day of year) with a separate line for each band\n"
+":param model: is either 'polynomial' (coefficients c0..cN of 1, x, ..., x^N) or 'harmonic' (Intercept, Slope and Cos/Sin coefficients of each harmonic of the period)\n"
+":param nterms: is the degree of the polynomial or the number of harmonics\n"
+":param period: is the period (in the units of bandvalues) of the harmonic model (Default: 365.25)\n"
+":param nodata: is the no data value to ignore (Default: None, only NaN is ignored)\n"
+"\n"
+"Example::\n"
+"\n"
+"   imagecalc.imagePixelModelFit('ndvi_timeseries.kea', 'ndvi_harmonics.kea', 'KEA', 'doy.txt', 'harmonic', 2, period=365.25, nodata=0)\n"
+"\n"
+},
+
+{"imagePixelRobustModelFit", (PyCFunction)ImageCalc_ImagePixelRobustModelFit, METH_VARARGS | METH_KEYWORDS,
+"rsgislib.imagecalc.imagePixelRobustModelFit(inputimg, outputimg, gdalformat, bandvalues, model, nterms, period=365.25, maxiters=5, tuning=4.685, outlierthres=0, outliers=True, nodata=None)\n"
+"Fits a polynomial or harmonic model to each column of pixels robustly, by iteratively reweighted least squares\n"
+"with Tukey's biweight starting from the least squares fit (as imagePixelModelFit), so outlying observations\n"
+"(e.g., cloud or snow in a time series) do not affect the fit. The output image has a band for each model\n"
+"coefficient, the RMSE of the observations which are not outliers and, if outliers is True, a band for each\n"
+"input band which is 1 where the observation is an outlier. Blocks are fitted using RSGISLIB_NUM_THREADS threads.\n"
+"\n"
+"Where:\n"
+"\n"
+":param inputimg: is a string containing the name of the input file\n"
+":param outputimg: is a string containing the name of the output file\n"
+":param gdalformat: is a string containing the GDAL format for the output file - eg 'KEA'\n"
+":param bandvalues: is text file containing the value of each band (e.g. wavelength, day of year) with a separate line for each band\n"
+":param model: is either 'polynomial' or 'harmonic' (see imagePixelModelFit)\n"
+":param nterms: is the degree of the polynomial or the number of harmonics\n"
+":param period: is the period (in the units of bandvalues) of the harmonic model (Default: 365.25)\n"
+":param maxiters: is the maximum number of reweighting iterations (Default: 5)\n"
+":param tuning: is the tuning constant of the biweight, in units of the robust scale of the residuals (Default: 4.685)\n"
+":param outlierthres: is the absolute residual above which an observation is an outlier; 0 uses the observations given no weight by the biweight (Default: 0)\n"
+":param outliers: is a boolean specifying whether the outlier mask bands are output (Default: True)\n"
+":param nodata: is the no data value to ignore (Default: None, only NaN is ignored)\n"
+"\n"
+"Example::\n"
+"\n"
+"   imagecalc.imagePixelRobustModelFit('green_timeseries.kea', 'green_rlm.kea', 'KEA', 'doy.txt', 'harmonic', 1, outlierthres=400, nodata=0)\n"
+"\n"
+},
+
 {"normalisation", ImageCalc_Normalisation, METH_VARARGS,
 "rsgislib.imagecalc.normalisation(inputImages, outputImages, calcInMinMax, inMin, inMax, outMin, outMax)\n"
 "Performs image normalisation\n"
@@ -2396,6 +3242,34 @@ static PyMethodDef ImageCalcMethods[] = {
 "\n"
 },
 
+{"calcImagePCA", (PyCFunction)ImageCalc_CalcImagePCA, METH_VARARGS | METH_KEYWORDS,
+"rsgislib.imagecalc.calcImagePCA(inputimg, outputimg, outeigenvecs, ncomponents, gdalformat, datatype, nodata=None, randomised=False)\n"
+"Performs a principal components analysis of all the bands of an image. The band means and covariance matrix\n"
+"are calculated in one (multi-threaded) pass over the image, so no sample is needed, and the image (centred\n"
+"on the band means) is then projected onto the components.\n"
+"\n"
+"Where:\n"
+"\n"
+":param inputimg: is a string containing the name of the input image file\n"
+":param outputimg: is a string containing the name of the output image file\n"
+":param outeigenvecs: is a string containing the name of the output file for the eigenvectors (an empty string to not save them)\n"
+":param ncomponents: is an int with the number of components to calculate and output (0 for all)\n"
+":param gdalformat: is a string containing the GDAL format for the output file - eg 'KEA'\n"
+":param datatype: is an int containing one of the values from rsgislib.TYPE_*\n"
+":param nodata: is a float with a no data value, pixels with it in any band are ignored (Default: None)\n"
+":param randomised: is a bool specifying that the components are found with a randomised method, which is faster\n"
+"                   for images with hundreds of bands where only the first few components are required (Default: False)\n"
+"\n"
+":return: list with the proportion of the variance explained by each component\n"
+"\n"
+"Example::\n"
+"\n"
+"   import rsgislib\n"
+"   import rsgislib.imagecalc\n"
+"   varExplain = rsgislib.imagecalc.calcImagePCA('Input.kea', 'Output.kea', 'EigenVec.mtxt', 5, 'KEA', rsgislib.TYPE_32FLOAT)\n"
+"\n"
+},
+
 {"pca", ImageCalc_PCA, METH_VARARGS,
 "rsgislib.imagecalc.pca(inputImage, eigenVectors, outputImage, numComponents, gdalformat, dataType)\n"
 "Performs a principal components analysis of an image using a defined set of eigenvectors.\n"
@@ -2728,7 +3602,7 @@ static PyMethodDef ImageCalcMethods[] = {
 },
 
 {"bandPercentile", ImageCalc_BandPercentile, METH_VARARGS,
-"rsgislib.imagecalc.bandPercentile(inputImage, percentile, noDataValue)\n"
+"rsgislib.imagecalc.bandPercentile(inputImage, percentile, noDataValue, maxError=0)\n"
 "Calculates image band percentiles for the input image and results a list of values\n"
 "\n"
 "Where:\n"
@@ -2736,6 +3610,7 @@ static PyMethodDef ImageCalcMethods[] = {
 ":param inputImage: is a string containing the name of the input image file\n"
 ":param percentile: is a float between 0 -- 1 specifying the percentile to be calculated.\n"
 ":param noDataValue: is a float specifying the value used to represent no data (used None when no value is to be specified).\n"
+":param maxError: is an optional float specifying the largest absolute error accepted in the percentiles, which can save a pass through the image (Default 0, exact values).\n"
 "\n"
 ":return: list of floats\n"
 "\n"
@@ -2881,7 +3756,11 @@ static PyMethodDef ImageCalcMethods[] = {
 ":param useImgNoData: is a boolean specifying whether (if specified) the no data value specified in the band header\n"
 "               should be excluded from the histogram (Optional and if not specfied defaults to True).\n"
 ":param rescaleProbs: is a boolean specifying whether the probabilities should be rescaled to a range of 0-1 as values\n"
-"              can be very small when a number of variables are used. (Optional and if not specified the default is True)."
+"              can be very small when a number of variables are used. (Optional and if not specified the default is True).\n"
+"\n"
+"Only the occupied histogram bins are stored, so the memory used depends on the number of distinct bins within the\n"
+"mask rather than the number of bins in each band multiplied together, and the histogram is populated using\n"
+"RSGISLIB_NUM_THREADS threads.\n"
 "\n"
 },
 
@@ -3074,13 +3953,16 @@ static PyMethodDef ImageCalcMethods[] = {
 ":param gdalformat: is a string with the GDAL output file format.\n"
 ":param datatype: is an containing one of the values from rsgislib.TYPE_*\n"
 ":param sumstats: is a list of the type rsgislib.SUMTYPE_* and specifies the summary is calculated.\n"
-"           Each summary statastic is saved as a different image band."
+"           Each summary statastic is saved as a different image band. SUMTYPE_MEDIAN and SUMTYPE_MODE are supported.\n"
 ":param statsimageband: is an integer specifying the image band in the stats image to be used for the analysis. (Default: 1)\n"
 ":param usenodata: is a boolean specifying whether the image band no data value should be used. (Default: True)\n"
-":param iogridx: and iogridy are integers which control the image processing block size. The unit is pixels in the refimage. (Default: 16)\n"
-"                      where the pixel resolution between the two images is closer together these values can be increased but \n"
+":param iogridx: is no longer used; the image is processed in strips across the whole refimage width. (Default: 16)\n"
+":param iogridy: is an integer specifying the number of refimage rows in each strip. (Default: 16)\n"
+"                      where the pixel resolution between the two images is closer together this value can be increased\n"
 "                      but where the statsimage pixel size is much smaller than the ref image reducing this will reduce the memory\n"
-"                      footprint significantly.\n"
+"                      footprint significantly. The strips are processed in parallel using RSGISLIB_NUM_THREADS threads.\n"
+"\n"
+"Cells with no valid statsimage pixels are given the value 0. The standard deviation is of the population.\n"
 "\n"
 "\n"},
     
@@ -3117,6 +3999,27 @@ static PyMethodDef ImageCalcMethods[] = {
 ":return: float with mean value.\n"
 "\n"},
 
+#if PY_MAJOR_VERSION >= 3
+{"calcImageBlocks", (PyCFunction)ImageCalc_CalcImageBlocks, METH_VARARGS | METH_KEYWORDS,
+"rsgislib.imagecalc.calcImageBlocks(inputimgs=list, outputimg=string, gdalformat=string, datatype=int, numoutbands=int, blockfunc=function)\n"
+"Creates an output image by calling a Python function on each block of rows read by the image calc engine.\n"
+"The blocks are not copied; each image band is given as a memoryview onto the engine's buffers, which\n"
+"are only valid during the call (see calcImageBlocksNumpy to work with numpy arrays). The input images\n"
+"are read, and the output written, with the GIL released.\n"
+"\n"
+"Where:\n"
+"\n"
+":param inputimgs: is a list of input image files (or a single file); the bands of all the images are given in order.\n"
+":param outputimg: is a string specifying the output image file.\n"
+":param gdalformat: is a string with the GDAL output file format.\n"
+":param datatype: is an containing one of the values from rsgislib.TYPE_*\n"
+":param numoutbands: is the number of output image bands.\n"
+":param blockfunc: is a function blockfunc(inbands, outbands, width, nrows) where inbands is a list of read-only\n"
+"           memoryviews of float32 values and outbands a list of writable memoryviews of float64 values, one per\n"
+"           band with width * nrows values in row order.\n"
+"\n"},
+#endif
+
 {NULL}        /* Sentinel */
 };
 
@@ -170,7 +170,10 @@ static PyObject *ImageCalibration_landsat2Radiance(PyObject *self, PyObject *arg
     
     try
     {
-        rsgis::cmds::executeConvertLandsat2Radiance(pszOutputFile, pszGDALFormat, landsatRadGainOffs);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeConvertLandsat2Radiance(pszOutputFile, pszGDALFormat, landsatRadGainOffs);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -279,7 +282,10 @@ static PyObject *ImageCalibration_landsat2RadianceMultiAdd(PyObject *self, PyObj
     
     try
     {
-        rsgis::cmds::executeConvertLandsat2RadianceMultiAdd(pszOutputFile, pszGDALFormat, landsatRadGainOffs);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeConvertLandsat2RadianceMultiAdd(pszOutputFile, pszGDALFormat, landsatRadGainOffs);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -333,7 +339,10 @@ static PyObject *ImageCalibration_Radiance2TOARefl(PyObject *self, PyObject *arg
     try
     {
         rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)nDataType;
-        rsgis::cmds::executeConvertRadiance2TOARefl(pszInputFile, pszOutputFile, pszGDALFormat, type, scaleFactor, 0, false, year, month, day, (solarZenith*(M_PI/180)), solarIrradiance, numSolarIrrVals);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeConvertRadiance2TOARefl(pszInputFile, pszOutputFile, pszGDALFormat, type, scaleFactor, 0, false, year, month, day, (solarZenith*(M_PI/180)), solarIrradiance, numSolarIrrVals);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -420,7 +429,10 @@ static PyObject *ImageCalibration_TOARefl2Radiance(PyObject *self, PyObject *arg
     try
     {
         rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)nDataType;
-        rsgis::cmds::executeConvertTOARefl2Radiance(inputImgFiles, pszOutputFile, pszGDALFormat, type, scaleFactor, solarDistance, (solarZenith*(M_PI/180)), solarIrradiance, numSolarIrrVals);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeConvertTOARefl2Radiance(inputImgFiles, pszOutputFile, pszGDALFormat, type, scaleFactor, solarDistance, (solarZenith*(M_PI/180)), solarIrradiance, numSolarIrrVals);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -518,7 +530,10 @@ static PyObject *ImageCalibration_Apply6SCoefficentsSingleParam(PyObject *self,
     try
     {
         rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)nDataType;
-        rsgis::cmds::executeRad2SREFSingle6sParams(pszInputFile, pszOutputFile, pszGDALFormat, type, scaleFactor, imageBands, aX, bX, cX, numValues, noDataVal, useNoDataVal);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeRad2SREFSingle6sParams(pszInputFile, pszOutputFile, pszGDALFormat, type, scaleFactor, imageBands, aX, bX, cX, numValues, noDataVal, useNoDataVal);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -652,7 +667,10 @@ static PyObject *ImageCalibration_Apply6SCoefficentsElevLUTParam(PyObject *self,
     try
     {
         rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)nDataType;
-        rsgis::cmds::executeRad2SREFElevLUT6sParams(std::string(pszInputRadFile), std::string(pszInputDEMFile), std::string(pszOutputFile), std::string(pszGDALFormat), type, scaleFactor, elevLUT, noDataVal, useNoDataVal);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeRad2SREFElevLUT6sParams(std::string(pszInputRadFile), std::string(pszInputDEMFile), std::string(pszOutputFile), std::string(pszGDALFormat), type, scaleFactor, elevLUT, noDataVal, useNoDataVal);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -672,26 +690,12 @@ static PyObject *ImageCalibration_Apply6SCoefficentsElevLUTParam(PyObject *self,
     Py_RETURN_NONE;
 }
 
-static PyObject *ImageCalibration_Apply6SCoefficentsElevAOTLUTParam(PyObject *self, PyObject *args)
+// Read a sequence of ElevLUTFeat objects (each with a sequence of AOTLUTFeat) into elevAOTLUT,
+// setting the Python error and returning false if it is not valid.
+static bool ExtractElevAOTLUTFromSequence(PyObject *self, PyObject *pLUTObj, std::vector<rsgis::cmds::Cmds6SBaseElevAOTLUT> *elevAOTLUT)
 {
-    const char *pszInputRadFile, *pszInputDEMFile, *pszInputAOTFile, *pszOutputFile, *pszGDALFormat;
-    int nDataType, useNoDataVal;
-    float scaleFactor, noDataVal;
-    PyObject *pLUTObj;
-    if( !PyArg_ParseTuple(args, "sssssiffiO:apply6SCoeffElevAOTLUTParam", &pszInputRadFile, &pszInputDEMFile, &pszInputAOTFile, &pszOutputFile, &pszGDALFormat, &nDataType, &scaleFactor, &noDataVal, &useNoDataVal, &pLUTObj))
-    {
-        return NULL;
-    }
-    
-    if( !PySequence_Check(pLUTObj))
-    {
-        PyErr_SetString(GETSTATE(self)->error, "Last argument must be a sequence");
-        return NULL;
-    }
-    
     Py_ssize_t nLUTDefns = PySequence_Size(pLUTObj);
     
-    std::vector<rsgis::cmds::Cmds6SBaseElevAOTLUT> *elevAOTLUT = new std::vector<rsgis::cmds::Cmds6SBaseElevAOTLUT>();
     elevAOTLUT->reserve(nLUTDefns);
     
     for( Py_ssize_t n = 0; n < nLUTDefns; ++n )
@@ -705,7 +709,7 @@ static PyObject *ImageCalibration_Apply6SCoefficentsElevAOTLUTParam(PyObject *se
             PyErr_SetString(GETSTATE(self)->error, "Could not find float attribute \'Elev\' for the LUT (make sure it is a float!)" );
             Py_XDECREF(pElev);
             Py_DECREF(pElevLUTValuesObj);
-            return NULL;
+            return false;
         }
         lutElevVal.elev = RSGISPY_FLOAT_EXTRACT(pElev);
         Py_DECREF(pElev);
@@ -716,7 +720,7 @@ static PyObject *ImageCalibration_Apply6SCoefficentsElevAOTLUTParam(PyObject *se
         if( !PySequence_Check(pAOTLUTValuesObj))
         {
             PyErr_SetString(GETSTATE(self)->error, "Each element in the Elevation LUT have a sequence of AOT \'Coeffs\'.");
-            return NULL;
+            return false;
         }
         Py_ssize_t nAOTLUTDefns = PySequence_Size(pAOTLUTValuesObj);
         lutElevVal.aotLUT = std::vector<rsgis::cmds::Cmds6SAOTLUT>();
@@ -734,7 +738,7 @@ static PyObject *ImageCalibration_Apply6SCoefficentsElevAOTLUTParam(PyObject *se
                 Py_XDECREF(pAOT);
                 Py_DECREF(pAOTValuesObj);
                 Py_DECREF(pElevLUTValuesObj);
-                return NULL;
+                return false;
             }
             lutAOTVal.aot = RSGISPY_FLOAT_EXTRACT(pAOT);
             Py_DECREF(pAOT);
@@ -746,7 +750,7 @@ static PyObject *ImageCalibration_Apply6SCoefficentsElevAOTLUTParam(PyObject *se
                 PyErr_SetString(GETSTATE(self)->error, "Each element in the AOT LUT have a sequence \'Coeffs\'.");
                 Py_DECREF(pAOTValuesObj);
                 Py_DECREF(pElevLUTValuesObj);
-                return NULL;
+                return false;
             }
             Py_ssize_t nBandValDefns = PySequence_Size(pBandValuesObj);
             
@@ -767,7 +771,7 @@ static PyObject *ImageCalibration_Apply6SCoefficentsElevAOTLUTParam(PyObject *se
                     Py_DECREF(o);
                     Py_DECREF(pAOTValuesObj);
                     Py_DECREF(pElevLUTValuesObj);
-                    return NULL;
+                    return false;
                 }
                 
                 PyObject *pAX = PyObject_GetAttrString(o, "aX");
@@ -779,7 +783,7 @@ static PyObject *ImageCalibration_Apply6SCoefficentsElevAOTLUTParam(PyObject *se
                     Py_DECREF(o);
                     Py_DECREF(pAOTValuesObj);
                     Py_DECREF(pElevLUTValuesObj);
-                    return NULL;
+                    return false;
                 }
                 
                 PyObject *pBX = PyObject_GetAttrString(o, "bX");
@@ -792,7 +796,7 @@ static PyObject *ImageCalibration_Apply6SCoefficentsElevAOTLUTParam(PyObject *se
                     Py_DECREF(o);
                     Py_DECREF(pAOTValuesObj);
                     Py_DECREF(pElevLUTValuesObj);
-                    return NULL;
+                    return false;
                 }
                 
                 PyObject *pCX = PyObject_GetAttrString(o, "cX");
@@ -806,7 +810,7 @@ static PyObject *ImageCalibration_Apply6SCoefficentsElevAOTLUTParam(PyObject *se
                     Py_DECREF(o);
                     Py_DECREF(pAOTValuesObj);
                     Py_DECREF(pElevLUTValuesObj);
-                    return NULL;
+                    return false;
                 }
                 
                 lutAOTVal.imageBands[m] = RSGISPY_INT_EXTRACT(pBand);
@@ -830,17 +834,11 @@ static PyObject *ImageCalibration_Apply6SCoefficentsElevAOTLUTParam(PyObject *se
         Py_DECREF(pElevLUTValuesObj);
     }
     
-    try
-    {
-        rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)nDataType;
-        rsgis::cmds::executeRad2SREFElevAOTLUT6sParams(std::string(pszInputRadFile), std::string(pszInputDEMFile), std::string(pszInputAOTFile), std::string(pszOutputFile), std::string(pszGDALFormat), type, scaleFactor, elevAOTLUT, noDataVal, useNoDataVal);
-    }
-    catch(rsgis::cmds::RSGISCmdException &e)
-    {
-        PyErr_SetString(GETSTATE(self)->error, e.what());
-        return NULL;
-    }
-    
+    return true;
+}
+
+static void FreeElevAOTLUT(std::vector<rsgis::cmds::Cmds6SBaseElevAOTLUT> *elevAOTLUT)
+{
     for(std::vector<rsgis::cmds::Cmds6SBaseElevAOTLUT>::iterator iterLUT = elevAOTLUT->begin(); iterLUT != elevAOTLUT->end(); ++iterLUT)
     {
         for(std::vector<rsgis::cmds::Cmds6SAOTLUT>::iterator iterAOTLUT = (*iterLUT).aotLUT.begin(); iterAOTLUT != (*iterLUT).aotLUT.end(); ++iterAOTLUT)
@@ -852,10 +850,97 @@ static PyObject *ImageCalibration_Apply6SCoefficentsElevAOTLUTParam(PyObject *se
         }
     }
     delete elevAOTLUT;
+}
+
+static PyObject *ImageCalibration_Apply6SCoefficentsElevAOTLUTParam(PyObject *self, PyObject *args)
+{
+    const char *pszInputRadFile, *pszInputDEMFile, *pszInputAOTFile, *pszOutputFile, *pszGDALFormat;
+    int nDataType, useNoDataVal;
+    float scaleFactor, noDataVal;
+    float elevQuantStep = 0;
+    PyObject *pLUTObj;
+    if( !PyArg_ParseTuple(args, "sssssiffiO|f:apply6SCoeffElevAOTLUTParam", &pszInputRadFile, &pszInputDEMFile, &pszInputAOTFile, &pszOutputFile, &pszGDALFormat, &nDataType, &scaleFactor, &noDataVal, &useNoDataVal, &pLUTObj, &elevQuantStep))
+    {
+        return NULL;
+    }
+    
+    if( !PySequence_Check(pLUTObj))
+    {
+        PyErr_SetString(GETSTATE(self)->error, "Last argument must be a sequence");
+        return NULL;
+    }
+    
+    std::vector<rsgis::cmds::Cmds6SBaseElevAOTLUT> *elevAOTLUT = new std::vector<rsgis::cmds::Cmds6SBaseElevAOTLUT>();
+    if(!ExtractElevAOTLUTFromSequence(self, pLUTObj, elevAOTLUT))
+    {
+        FreeElevAOTLUT(elevAOTLUT);
+        return NULL;
+    }
+    
+    try
+    {
+        rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)nDataType;
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeRad2SREFElevAOTLUT6sParams(std::string(pszInputRadFile), std::string(pszInputDEMFile), std::string(pszInputAOTFile), std::string(pszOutputFile), std::string(pszGDALFormat), type, scaleFactor, elevAOTLUT, noDataVal, useNoDataVal, elevQuantStep);
+        }
+    }
+    catch(rsgis::cmds::RSGISCmdException &e)
+    {
+        PyErr_SetString(GETSTATE(self)->error, e.what());
+        return NULL;
+    }
+    
+    FreeElevAOTLUT(elevAOTLUT);
     
     Py_RETURN_NONE;
 }
 
+static PyObject *ImageCalibration_EstimateDarkTargetAOT(PyObject *self, PyObject *args)
+{
+    const char *pszInputRadFile, *pszInputDEMFile, *pszOutputFile, *pszGDALFormat;
+    PyObject *pLUTObj;
+    unsigned int radBand, regionSize;
+    float darkPercentile, darkTargetRefl;
+    unsigned int minPxls = 100;
+    float noDataVal = 0;
+    int useNoDataVal = true;
+    if( !PyArg_ParseTuple(args, "ssssOIIff|IfI:estimateDarkTargetAOT", &pszInputRadFile, &pszInputDEMFile, &pszOutputFile, &pszGDALFormat, &pLUTObj, &radBand, &regionSize, &darkPercentile, &darkTargetRefl, &minPxls, &noDataVal, &useNoDataVal))
+    {
+        return NULL;
+    }
+    
+    if( !PySequence_Check(pLUTObj))
+    {
+        PyErr_SetString(GETSTATE(self)->error, "The LUT must be a sequence");
+        return NULL;
+    }
+    
+    std::vector<rsgis::cmds::Cmds6SBaseElevAOTLUT> *elevAOTLUT = new std::vector<rsgis::cmds::Cmds6SBaseElevAOTLUT>();
+    if(!ExtractElevAOTLUTFromSequence(self, pLUTObj, elevAOTLUT))
+    {
+        FreeElevAOTLUT(elevAOTLUT);
+        return NULL;
+    }
+    
+    float imageAOT = 0;
+    try
+    {
+        RSGISPyReleaseGIL releaseGIL;
+        imageAOT = rsgis::cmds::executeEstimateDarkTargetAOT(std::string(pszInputRadFile), std::string(pszInputDEMFile), std::string(pszOutputFile), std::string(pszGDALFormat), elevAOTLUT, radBand, regionSize, darkPercentile, darkTargetRefl, minPxls, noDataVal, (bool)useNoDataVal);
+    }
+    catch(rsgis::cmds::RSGISCmdException &e)
+    {
+        FreeElevAOTLUT(elevAOTLUT);
+        PyErr_SetString(GETSTATE(self)->error, e.what());
+        return NULL;
+    }
+    
+    FreeElevAOTLUT(elevAOTLUT);
+    
+    return Py_BuildValue("f", imageAOT);
+}
+
 static PyObject *ImageCalibration_ApplySubtractOffsets(PyObject *self, PyObject *args)
 {
     const char *pszInputFile, *pszInputOffsetsFile, *pszOutputFile, *pszGDALFormat;
@@ -870,7 +955,10 @@ static PyObject *ImageCalibration_ApplySubtractOffsets(PyObject *self, PyObject
     try
     {
         rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)nDataType;
-        rsgis::cmds::executeApplySubtractOffsets(std::string(pszInputFile), std::string(pszOutputFile), std::string(pszInputOffsetsFile), (bool)nonNegativeInt, std::string(pszGDALFormat), type, noDataVal, (bool)useNoDataValInt, darkObjReflVal);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeApplySubtractOffsets(std::string(pszInputFile), std::string(pszOutputFile), std::string(pszInputOffsetsFile), (bool)nonNegativeInt, std::string(pszGDALFormat), type, noDataVal, (bool)useNoDataValInt, darkObjReflVal);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -927,7 +1015,10 @@ static PyObject *ImageCalibration_ApplySubtractSingleOffsets(PyObject *self, PyO
     try
     {
         rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)nDataType;
-        rsgis::cmds::executeApplySubtractSingleOffsets(std::string(pszInputFile), std::string(pszOutputFile), imageOffsVals, (bool)nonNegativeInt, std::string(pszGDALFormat), type, noDataVal, (bool)useNoDataValInt, darkObjReflVal);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeApplySubtractSingleOffsets(std::string(pszInputFile), std::string(pszOutputFile), imageOffsVals, (bool)nonNegativeInt, std::string(pszGDALFormat), type, noDataVal, (bool)useNoDataValInt, darkObjReflVal);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1020,7 +1111,10 @@ static PyObject *ImageCalibration_SaturatedPixelsMask(PyObject *self, PyObject *
     
     try
     {
-        rsgis::cmds::executeGenerateSaturationMask(pszOutputFile, pszGDALFormat, satBandPxlInfo);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeGenerateSaturationMask(pszOutputFile, pszGDALFormat, satBandPxlInfo);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1116,7 +1210,10 @@ static PyObject *ImageCalibration_landsatThermalRad2Brightness(PyObject *self, P
     try
     {
         rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)nDataType;
-        rsgis::cmds::executeLandsatThermalRad2ThermalBrightness(std::string(pszInputFile), std::string(pszOutputFile), std::string(pszGDALFormat), type, scaleFactor, thermBandPxlInfo);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeLandsatThermalRad2ThermalBrightness(std::string(pszInputFile), std::string(pszOutputFile), std::string(pszGDALFormat), type, scaleFactor, thermBandPxlInfo);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1134,16 +1231,20 @@ static PyObject *ImageCalibration_applyLandsatTMCloudFMask(PyObject *self, PyObj
     float scaleFactor;
     float whitenessThreshold = 0.7;
     int rmTmpImages = true;
+    int fusedPasses = false;
     
     
-    if( !PyArg_ParseTuple(args, "ssssssfffffss|fi:applyLandsatTMCloudFMask", &pszInputTOAFile, &pszInputThermalFile, &pszInputSatFile, &pszValidAreaImg, &pszOutputFile, &pszGDALFormat, &sunAz, &sunZen, &senAz, &senZen, &scaleFactor, &pszTmpImgsBase, &pszTmpImgsFileExt, &whitenessThreshold, &rmTmpImages))
+    if( !PyArg_ParseTuple(args, "ssssssfffffss|fii:applyLandsatTMCloudFMask", &pszInputTOAFile, &pszInputThermalFile, &pszInputSatFile, &pszValidAreaImg, &pszOutputFile, &pszGDALFormat, &sunAz, &sunZen, &senAz, &senZen, &scaleFactor, &pszTmpImgsBase, &pszTmpImgsFileExt, &whitenessThreshold, &rmTmpImages, &fusedPasses))
     {
         return NULL;
     }
     
     try
     {
-        rsgis::cmds::executeLandsatTMCloudFMask(std::string(pszInputTOAFile), std::string(pszInputThermalFile), std::string(pszInputSatFile), std::string(pszValidAreaImg), std::string(pszOutputFile), std::string(pszGDALFormat), sunAz, sunZen, senAz, senZen, whitenessThreshold, scaleFactor, std::string(pszTmpImgsBase), std::string(pszTmpImgsFileExt), (bool)rmTmpImages);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeLandsatTMCloudFMask(std::string(pszInputTOAFile), std::string(pszInputThermalFile), std::string(pszInputSatFile), std::string(pszValidAreaImg), std::string(pszOutputFile), std::string(pszGDALFormat), sunAz, sunZen, senAz, senZen, whitenessThreshold, scaleFactor, std::string(pszTmpImgsBase), std::string(pszTmpImgsFileExt), (bool)rmTmpImages, (bool)fusedPasses);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1237,7 +1338,10 @@ static PyObject *ImageCalibration_worldview2ToRadiance(PyObject *self, PyObject
     
     try
     {
-        rsgis::cmds::executeConvertWorldView2ToRadiance(std::string(pszInputFile), std::string(pszOutputFile), std::string(pszGDALFormat), wv2RadGainOffs);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeConvertWorldView2ToRadiance(std::string(pszInputFile), std::string(pszOutputFile), std::string(pszGDALFormat), wv2RadGainOffs);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1331,7 +1435,10 @@ static PyObject *ImageCalibration_spot5ToRadiance(PyObject *self, PyObject *args
     
     try
     {
-        rsgis::cmds::executeConvertSPOT5ToRadiance(std::string(pszInputFile), std::string(pszOutputFile), std::string(pszGDALFormat), spot5RadGainOffs);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeConvertSPOT5ToRadiance(std::string(pszInputFile), std::string(pszOutputFile), std::string(pszGDALFormat), spot5RadGainOffs);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1355,7 +1462,10 @@ static PyObject *ImageCalibration_calcNadirImgViewAngle(PyObject *self, PyObject
     
     try
     {
-        rsgis::cmds::executeCalcNadirImageViewAngle(std::string(pszImgFootprint), std::string(pszOutViewAngleImg), std::string(pszGDALFormat), sateAltitude, std::string(pszMinXXCol), std::string(pszMinXYCol), std::string(pszMaxXXCol), std::string(pszMaxXYCol), std::string(pszMinYXCol), std::string(pszMinYYCol), std::string(pszMaxYXCol), std::string(pszMaxYYCol));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCalcNadirImageViewAngle(std::string(pszImgFootprint), std::string(pszOutViewAngleImg), std::string(pszGDALFormat), sateAltitude, std::string(pszMinXXCol), std::string(pszMinXYCol), std::string(pszMaxXXCol), std::string(pszMaxXYCol), std::string(pszMinYXCol), std::string(pszMinYYCol), std::string(pszMaxYXCol), std::string(pszMaxYYCol));
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1489,7 +1599,10 @@ static PyObject *ImageCalibration_CalcIrradianceElevLUT(PyObject *self, PyObject
     
     try
     {
-        rsgis::cmds::executeCalcIrradianceElevLUT(std::string(pszInputDataMaskImg), std::string(pszInputDEMFile), std::string(pszInputIncidenceAngleImg), std::string(pszInputSlopeImg), std::string(pszShadowMaskImg), std::string(pszSrefInputImage), std::string(pszOutputFile), std::string(pszGDALFormat), solarZenith, reflScaleFactor, elevLUT);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCalcIrradianceElevLUT(std::string(pszInputDataMaskImg), std::string(pszInputDEMFile), std::string(pszInputIncidenceAngleImg), std::string(pszInputSlopeImg), std::string(pszShadowMaskImg), std::string(pszSrefInputImage), std::string(pszOutputFile), std::string(pszGDALFormat), solarZenith, reflScaleFactor, elevLUT);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1527,7 +1640,10 @@ static PyObject *ImageCalibration_CalcStandardisedReflectanceSD2010(PyObject *se
     
     try
     {
-        rsgis::cmds::executeCalcStandardisedReflectanceSD2010(std::string(pszInputDataMaskImg), std::string(pszSrefInputImage), std::string(pszInputSolarIrradiance), std::string(pszInputIncidenceAngleImg), std::string(pszInputExitanceAngleImg), std::string(pszOutputFile), std::string(pszGDALFormat), brdfBeta, outIncidenceAngle, outExitanceAngle, reflScaleFactor);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCalcStandardisedReflectanceSD2010(std::string(pszInputDataMaskImg), std::string(pszSrefInputImage), std::string(pszInputSolarIrradiance), std::string(pszInputIncidenceAngleImg), std::string(pszInputExitanceAngleImg), std::string(pszOutputFile), std::string(pszGDALFormat), brdfBeta, outIncidenceAngle, outExitanceAngle, reflScaleFactor);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1549,7 +1665,10 @@ static PyObject *ImageCalibration_GetJulianDay(PyObject *self, PyObject *args)
     unsigned int julianDay = 0;
     try
     {
-        julianDay = rsgis::cmds::executeGetJulianDay(year, month, day);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            julianDay = rsgis::cmds::executeGetJulianDay(year, month, day);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1571,7 +1690,10 @@ static PyObject *ImageCalibration_CalcSolarDistance(PyObject *self, PyObject *ar
     float solarDistance = 0;
     try
     {
-        solarDistance = rsgis::cmds::executeGetEarthSunDistance(julianDay);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            solarDistance = rsgis::cmds::executeGetEarthSunDistance(julianDay);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1600,7 +1722,10 @@ static PyObject *ImageCalibration_calcCloudShadowMask(PyObject *self, PyObject *
     try
     {
         bool rmTmpImgs = (bool)rmTmpImages;
-        rsgis::cmds::executePerformCloudShadowMasking(std::string(pszInputCloudMaskFile), std::string(pszInputReflFile), std::string(pszValidAreaImg), darkImgBand, std::string(pszOutputFile), std::string(pszGDALFormat), scaleFactor, std::string(pszTmpImgsBase), std::string(pszTmpImgsFileExt), rmTmpImgs, sunAz, sunZen, senAz, senZen);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePerformCloudShadowMasking(std::string(pszInputCloudMaskFile), std::string(pszInputReflFile), std::string(pszValidAreaImg), darkImgBand, std::string(pszOutputFile), std::string(pszGDALFormat), scaleFactor, std::string(pszTmpImgsBase), std::string(pszTmpImgsFileExt), rmTmpImgs, sunAz, sunZen, senAz, senZen);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1726,7 +1851,7 @@ static PyMethodDef ImageCalibrationMethods[] = {
 "\n"},
 
 {"apply6SCoeffElevAOTLUTParam", ImageCalibration_Apply6SCoefficentsElevAOTLUTParam, METH_VARARGS,
-"imagecalibration.apply6SCoeffElevLUTParam(inputRadFile, inputDEMFile, inputAOTImage, outputFile, gdalFormat, datatype, scaleFactor, noDataValue, useNoDataValue, lutElevAOT)\n"
+"imagecalibration.apply6SCoeffElevLUTParam(inputRadFile, inputDEMFile, inputAOTImage, outputFile, gdalFormat, datatype, scaleFactor, noDataValue, useNoDataValue, lutElevAOT, elevQuantStep)\n"
 "Converts at sensor radiance values to surface reflectance by applying coefficients from the 6S model for each band (aX, bX, cX), where the coefficients can be varied for surface elevation.\n"
 "\n"
 "Where:\n"
@@ -1748,6 +1873,28 @@ static PyMethodDef ImageCalibrationMethods[] = {
 "                            * \'aX\' - A float for the aX coefficient.\n"
 "                            * \'bX\' - A float for the bX coefficient.\n"
 "                            * \'cX\' - A float for the cX coefficient.\n"
+":param elevQuantStep: is an optional float; if greater than 0 the elevations are quantised to this step (in metres) and the LUT entry for each step is precomputed, which is faster for large images (Default 0; the exact elevation is used).\n"
+"\n"},
+
+{"estimateDarkTargetAOT", ImageCalibration_EstimateDarkTargetAOT, METH_VARARGS,
+"imagecalibration.estimateDarkTargetAOT(inputRadFile, inputDEMFile, outputAOTFile, gdalformat, lutElevAOT, band, regionSize, darkPercentile, darkTargetRefl, minPxls, noDataValue, useNoDataValue)\n"
+"Estimates the aerosol optical thickness (AOT) of a radiance image from dark targets. The image is divided into square regions and, in a single (multi-threaded; see RSGISLIB_NUM_THREADS) pass, the darkPercentile percentile of the band within each region is found and taken as a dark target with a surface reflectance of darkTargetRefl. The AOT of each region is that for which the 6S coefficients (interpolated between the AOTs of the LUT) give the dark target that reflectance.\n"
+"\n"
+"Where:\n"
+"\n"
+":param inputRadFile: is a string containing the name of the input Radiance image file\n"
+":param inputDEMFile: is a string containing the name of the input DEM image file (the same size as the radiance image), used to select the elevation of the LUT for each region. If empty ('') the first elevation of the LUT is used.\n"
+":param outputAOTFile: is a string containing the name of the output AOT image file, which has a pixel for each region.\n"
+":param gdalformat: is a string containing the GDAL format for the output file - eg 'KEA'\n"
+":param lutElevAOT: is a sequence of elevation and AOT LUT objects, as for apply6SCoeffElevAOTLUTParam, where the band numbers are those of the radiance image (starting at 1).\n"
+":param band: is an int specifying the band (starting at 1) of the radiance image used for the dark targets.\n"
+":param regionSize: is an int specifying the size (in pixels) of the square regions an AOT is estimated for.\n"
+":param darkPercentile: is a float (0 - 1) specifying the percentile of each region taken as the dark target (e.g., 0.01).\n"
+":param darkTargetRefl: is a float specifying the surface reflectance (0 - 1) assumed for the dark targets.\n"
+":param minPxls: is an optional int specifying the minimum number of valid pixels for a region to be estimated; other regions are given the AOT of the image (Default 100).\n"
+":param noDataValue: is an optional float specifying the no data value of the radiance image (Default 0).\n"
+":param useNoDataValue: is an optional boolean as to whether the no data value is used (Default True).\n"
+":return: the AOT of the image (the median of the regions).\n"
 "\n"},
 
 {"applySubtractSingleOffsets", ImageCalibration_ApplySubtractSingleOffsets, METH_VARARGS,
@@ -1818,7 +1965,7 @@ static PyMethodDef ImageCalibrationMethods[] = {
 "\n"},
     
 {"applyLandsatTMCloudFMask", ImageCalibration_applyLandsatTMCloudFMask, METH_VARARGS,
-"imagecalibration.applyLandsatTMCloudFMask(inputTOAImage, inputThermalImage, inputSaturateImage, inValidAreaImage, outputImage, gdalFormat, sunAz, sunZen, senAz, senZen, scaleFactorIn, tmpImgsBase, tmpImgsFileExt, rmTmpImgs)\n"
+"imagecalibration.applyLandsatTMCloudFMask(inputTOAImage, inputThermalImage, inputSaturateImage, inValidAreaImage, outputImage, gdalFormat, sunAz, sunZen, senAz, senZen, scaleFactorIn, tmpImgsBase, tmpImgsFileExt, whitenessThreshold, rmTmpImgs, fusedPasses)\n"
 "Applies the FMASK (Zhu and Woodcock 2012, RSE 118, pp83-94) cloud masking algorithm to the input image returning an output image with the cloud (pixel value 1) and shadow (pixel value 2).\n"
 "\n"
 "Where:\n"
@@ -1838,6 +1985,7 @@ static PyMethodDef ImageCalibrationMethods[] = {
 ":param tmpImgsFileExt: is a string for the file extention of the output images (e.g., .kea)\n"
 ":param whitenessThreshold: is a float specifying the whiteness threshold (default is 0.7; Equation 2), this parameter is optional.\n"
 ":param rmTmpImgs: is a bool specifying whether the tmp images should be deleted at the end of the processing (Optional; Default = True)\n"
+":param fusedPasses: is a bool specifying that the per-pixel passes up to the initial cloud mask are calculated together in tiles (in parallel; RSGISLIB_NUM_THREADS) from one read of the input images, with the intermediate values held in memory (about 13 bytes per pixel) and the scene percentiles calculated from streaming histograms rather than from intermediate images. (Optional; Default = False)\n"
 "\n"
 "Example::\n"
 "\n"
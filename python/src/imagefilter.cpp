@@ -186,7 +186,10 @@ static PyObject *ImageFilter_Filter(PyObject *self, PyObject *args)
     try
     {
         rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType) dataType;
-        rsgis::cmds::executeFilter(pszInputImage, filterParameters, pszOutputImageBase, pszImageFormat, pszImageExt, type);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeFilter(pszInputImage, filterParameters, pszOutputImageBase, pszImageFormat, pszImageExt, type);
+        }
 
         // Delete filter parameters
         for(std::vector<rsgis::cmds::RSGISFilterParameters*>::iterator iterFilter = filterParameters->begin(); iterFilter != filterParameters->end(); ++iterFilter)
@@ -225,7 +228,10 @@ static PyObject *ImageFilter_LeungMalikFilterBank(PyObject *self, PyObject *args
         
         // Excecute
         rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType) dataType;
-        rsgis::cmds::executeFilter(pszInputImage, filterParameters, pszOutputImageBase, pszImageFormat, pszImageExt, type);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeFilter(pszInputImage, filterParameters, pszOutputImageBase, pszImageFormat, pszImageExt, type);
+        }
 
         // Delete filter parameters
         for(std::vector<rsgis::cmds::RSGISFilterParameters*>::iterator iterFilter = filterParameters->begin(); iterFilter != filterParameters->end(); ++iterFilter)
@@ -244,6 +250,105 @@ static PyObject *ImageFilter_LeungMalikFilterBank(PyObject *self, PyObject *args
     Py_RETURN_NONE;
 }
 
+static PyObject *ImageFilter_GLCMTextures(PyObject *self, PyObject *args, PyObject *keywds)
+{
+    const char *pszInputImage, *pszOutputImage;
+    const char *pszImageFormat = "KEA";
+    PyObject *measuresObj;
+    unsigned int band = 1;
+    unsigned int numLevels = 32;
+    unsigned int winSize = 7;
+    int xOffset = 1;
+    int yOffset = 0;
+    double minVal = 0.0;
+    double maxVal = 0.0;
+    int dataType = 9; // Default to 32 bit float
+    static char *kwlist[] = {"inputimage", "outputimage", "measures", "band", "nlevels", "winsize", "xoffset", "yoffset", "minval", "maxval", "gdalformat", "datatype", NULL};
+    if( !PyArg_ParseTupleAndKeywords(args, keywds, "ssO|IIIiiddsi:glcmTextures", kwlist, &pszInputImage, &pszOutputImage, &measuresObj, &band, &numLevels, &winSize, &xOffset, &yOffset, &minVal, &maxVal, &pszImageFormat, &dataType))
+    {
+        return NULL;
+    }
+    
+    if( !PySequence_Check(measuresObj))
+    {
+        PyErr_SetString(GETSTATE(self)->error, "measures argument must be a sequence");
+        return NULL;
+    }
+    
+    std::vector<rsgis::cmds::RSGISGLCMMeasureType> measures;
+    Py_ssize_t nMeasures = PySequence_Size(measuresObj);
+    for( Py_ssize_t n = 0; n < nMeasures; n++ )
+    {
+        PyObject *o = PySequence_GetItem(measuresObj, n);
+        if( ( o == NULL ) || ( o == Py_None ) || !RSGISPY_CHECK_STRING(o) )
+        {
+            PyErr_SetString(GETSTATE(self)->error, "value in measures was not a string." );
+            Py_XDECREF(o);
+            return NULL;
+        }
+        std::string measureName = RSGISPY_STRING_EXTRACT(o);
+        Py_DECREF(o);
+        
+        if(measureName == "contrast")
+        {
+            measures.push_back(rsgis::cmds::rsgis_glcm_contrast);
+        }
+        else if(measureName == "dissimilarity")
+        {
+            measures.push_back(rsgis::cmds::rsgis_glcm_dissimilarity);
+        }
+        else if(measureName == "homogeneity")
+        {
+            measures.push_back(rsgis::cmds::rsgis_glcm_homogeneity);
+        }
+        else if(measureName == "asm")
+        {
+            measures.push_back(rsgis::cmds::rsgis_glcm_asm);
+        }
+        else if(measureName == "energy")
+        {
+            measures.push_back(rsgis::cmds::rsgis_glcm_energy);
+        }
+        else if(measureName == "entropy")
+        {
+            measures.push_back(rsgis::cmds::rsgis_glcm_entropy);
+        }
+        else if(measureName == "mean")
+        {
+            measures.push_back(rsgis::cmds::rsgis_glcm_mean);
+        }
+        else if(measureName == "variance")
+        {
+            measures.push_back(rsgis::cmds::rsgis_glcm_variance);
+        }
+        else if(measureName == "correlation")
+        {
+            measures.push_back(rsgis::cmds::rsgis_glcm_correlation);
+        }
+        else
+        {
+            PyErr_SetString(GETSTATE(self)->error, "measures must be one of 'contrast', 'dissimilarity', 'homogeneity', 'asm', 'energy', 'entropy', 'mean', 'variance' or 'correlation'." );
+            return NULL;
+        }
+    }
+    
+    try
+    {
+        rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType) dataType;
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeGLCMTextures(std::string(pszInputImage), band, std::string(pszOutputImage), measures, numLevels, winSize, xOffset, yOffset, minVal, maxVal, std::string(pszImageFormat), type);
+        }
+    }
+    catch(rsgis::cmds::RSGISCmdException &e)
+    {
+        PyErr_SetString(GETSTATE(self)->error, e.what());
+        return NULL;
+    }
+    
+    Py_RETURN_NONE;
+}
+
 // Our list of functions in this module
 static PyMethodDef ImageFilterMethods[] = {
     {"applyfilters", ImageFilter_Filter, METH_VARARGS, 
@@ -297,6 +402,8 @@ static PyMethodDef ImageFilterMethods[] = {
 "   filters.append(imagefilter.FilterParameters(filterType = 'NormVarSqrt', fileEnding = 'normvarsqrt', size=3) )\n"
 "   filters.append(imagefilter.FilterParameters(filterType = 'NormVarLn', fileEnding = 'normvarln', size=3) )\n"
 "   filters.append(imagefilter.FilterParameters(filterType = 'TextureVar', fileEnding = 'texturevar', size=3) )\n"
+"   # Several SAR textures in one image (a band for each texture of each input band) from the same window moments\n"
+"   filters.append(imagefilter.FilterParameters(filterType = 'SARTextures', fileEnding = 'sartex', size=3, option = 'NormVar,NormVarLn,NormLn,TextureVar') )\n"
 "   # Apply filters\n"
 "   imagefilter.applyfilters(inputImage, outputImageBase, filters, gdalformat, outExt, datatype)\n"
 "\n"},
@@ -323,6 +430,36 @@ static PyMethodDef ImageFilterMethods[] = {
 "   outExt = 'kea'\n"
 "   datatype = rsgislib.TYPE_32FLOAT\n"
 "   imagefilter.LeungMalikFilterBank(inputImage, outputImageBase, gdalformat, outExt, datatype)\n"
+"\n"},
+
+    {"glcmTextures", (PyCFunction)ImageFilter_GLCMTextures, METH_VARARGS | METH_KEYWORDS, 
+"imagefilter.glcmTextures(inputimage, outputimage, measures, band=1, nlevels=32, winsize=7, xoffset=1, yoffset=0, minval=0, maxval=0, gdalformat='KEA', datatype=rsgislib.TYPE_32FLOAT)\n"
+"Calculates grey level co-occurrence matrix (GLCM) texture measures (Haralick et al., 1973) within a moving window,\n"
+"with one output band per measure. The band is quantised to nlevels grey levels and the (symmetric) co-occurrence\n"
+"counts are updated incrementally as the window slides along each row (a column of pixel pairs is removed and one\n"
+"added), so all the measures come from the same counts. Rows are processed in parallel (RSGISLIB_NUM_THREADS).\n"
+"Pixels which are NaN or the no data value of the band are not counted.\n"
+"\n"
+"Where:\n"
+"\n"
+":param inputimage: is a string containing the name of the input image\n"
+":param outputimage: is a string containing the name of the output image\n"
+":param measures: is a list of the measures to output, in band order: 'contrast', 'dissimilarity', 'homogeneity', 'asm', 'energy', 'entropy', 'mean', 'variance' and 'correlation'.\n"
+":param band: is an int specifying the image band (starting at 1).\n"
+":param nlevels: is an int with the number of grey levels (2 - 256).\n"
+":param winsize: is an odd int with the size of the window.\n"
+":param xoffset: is an int with the x offset of the second pixel in each pair.\n"
+":param yoffset: is an int with the y offset of the second pixel in each pair.\n"
+":param minval: is a float with the value quantised to the first grey level.\n"
+":param maxval: is a float with the value quantised to the last grey level (if maxval <= minval the range of the band is used).\n"
+":param gdalformat: is a string containing the GDAL format for the output file - eg 'KEA'\n"
+":param datatype: is an int containing one of the values from rsgislib.TYPE_*\n"
+"\n"
+"Example::\n"
+"\n"
+"   import rsgislib\n"
+"   from rsgislib import imagefilter\n"
+"   imagefilter.glcmTextures('injune_p142_casi_sub_utm.kea', 'injune_p142_casi_sub_utm_glcm.kea', ['contrast', 'homogeneity', 'entropy', 'correlation'], band=1, nlevels=32, winsize=7)\n"
 "\n"},
 
     {NULL}        /* Sentinel */
@@ -42,10 +42,12 @@ static PyObject *ImageRegistration_BasicRegistration(PyObject *self, PyObject *a
     const char *pszInputReferenceImage, *pszInputFloatingmage, *pszOutputGCPFile;
     int pixelGap, windowSize, searchArea, subPixelResolution, metricType, outputType;
     float threshold, stdDevRefThreshold, stdDevFloatThreshold;
+    unsigned int pyramidLevels = 0;
+    int useFFTCorrelation = 0;
     
-    if( !PyArg_ParseTuple(args, "ssifiiffiiis:basicregistration", &pszInputReferenceImage, &pszInputFloatingmage, &pixelGap, 
+    if( !PyArg_ParseTuple(args, "ssifiiffiiis|Ii:basicregistration", &pszInputReferenceImage, &pszInputFloatingmage, &pixelGap, 
                                 &threshold, &windowSize, &searchArea, &stdDevRefThreshold, &stdDevFloatThreshold, &subPixelResolution, 
-                                &metricType, &outputType, &pszOutputGCPFile))
+                                &metricType, &outputType, &pszOutputGCPFile, &pyramidLevels, &useFFTCorrelation))
         return NULL;
 
     try
@@ -53,7 +55,7 @@ static PyObject *ImageRegistration_BasicRegistration(PyObject *self, PyObject *a
         rsgis::cmds:: excecuteBasicRegistration(pszInputReferenceImage, pszInputFloatingmage, pixelGap,
                                     threshold, windowSize, searchArea, stdDevRefThreshold,
                                     stdDevFloatThreshold, subPixelResolution, metricType,
-                                    outputType, pszOutputGCPFile);
+                                    outputType, pszOutputGCPFile, pyramidLevels, (useFFTCorrelation != 0));
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -71,11 +73,13 @@ static PyObject *ImageRegistration_SingleLayerRegistration(PyObject *self, PyObj
         outputType, maxNumIterations, distanceThreshold;
     float threshold, stdDevRefThreshold, stdDevFloatThreshold, moveChangeThreshold,
         pSmoothness;
+    unsigned int pyramidLevels = 0;
+    int useFFTCorrelation = 0;
     
-    if( !PyArg_ParseTuple(args, "ssifiiffiiiffiis:singlelayerregistration", &pszInputReferenceImage, &pszInputFloatingmage, &pixelGap, 
+    if( !PyArg_ParseTuple(args, "ssifiiffiiiffiis|Ii:singlelayerregistration", &pszInputReferenceImage, &pszInputFloatingmage, &pixelGap, 
                                 &threshold, &windowSize, &searchArea, &stdDevRefThreshold, &stdDevFloatThreshold, &subPixelResolution,
                                 &distanceThreshold, &maxNumIterations, &moveChangeThreshold, &pSmoothness,
-                                &metricType, &outputType, &pszOutputGCPFile))
+                                &metricType, &outputType, &pszOutputGCPFile, &pyramidLevels, &useFFTCorrelation))
         return NULL;
 
     try
@@ -84,7 +88,7 @@ static PyObject *ImageRegistration_SingleLayerRegistration(PyObject *self, PyObj
                                     threshold, windowSize, searchArea, stdDevRefThreshold,
                                     stdDevFloatThreshold, subPixelResolution, distanceThreshold,
                                     maxNumIterations, moveChangeThreshold, pSmoothness, metricType,
-                                    outputType, pszOutputGCPFile);
+                                    outputType, pszOutputGCPFile, pyramidLevels, (useFFTCorrelation != 0));
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -100,15 +104,16 @@ static PyObject *ImageRegistration_TriangularWarp(PyObject *self, PyObject *args
 	const char *pszInputImage, *pszInputGCPFile, *pszOutputFile, *pszProjFile, *pszGDALFormat;
 	float nResolution;
 	int genTransformImage = false;
+	float maxTransformError = 0;
     
-    if( !PyArg_ParseTuple(args, "ssssfs|i:triangularwarp", &pszInputImage, &pszInputGCPFile, &pszOutputFile, &pszProjFile, 
-                        &nResolution, &pszGDALFormat, &genTransformImage))
+    if( !PyArg_ParseTuple(args, "ssssfs|if:triangularwarp", &pszInputImage, &pszInputGCPFile, &pszOutputFile, &pszProjFile, 
+                        &nResolution, &pszGDALFormat, &genTransformImage, &maxTransformError))
         return NULL;
 
     try
     {
         rsgis::cmds::excecuteTriangularWarp(pszInputImage, pszOutputFile, pszProjFile, pszInputGCPFile,
-                        nResolution, pszGDALFormat, genTransformImage);
+                        nResolution, pszGDALFormat, genTransformImage, maxTransformError);
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -149,15 +154,16 @@ static PyObject *ImageRegistration_PolyWarp(PyObject *self, PyObject *args)
 	float nResolution;
 	int nPolyOrder;
 	int genTransformImage = false;
+	float maxTransformError = 0;
     
-    if( !PyArg_ParseTuple(args, "ssssfis|i:polywarp", &pszInputImage, &pszInputGCPFile, &pszOutputFile, &pszProjFile, 
-                        &nResolution, &nPolyOrder, &pszGDALFormat, &genTransformImage))
+    if( !PyArg_ParseTuple(args, "ssssfis|if:polywarp", &pszInputImage, &pszInputGCPFile, &pszOutputFile, &pszProjFile, 
+                        &nResolution, &nPolyOrder, &pszGDALFormat, &genTransformImage, &maxTransformError))
         return NULL;
 
     try
     {
         rsgis::cmds::excecutePolyWarp(pszInputImage, pszOutputFile, pszProjFile, pszInputGCPFile,
-                        nResolution, nPolyOrder, pszGDALFormat, genTransformImage);
+                        nResolution, nPolyOrder, pszGDALFormat, genTransformImage, maxTransformError);
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -200,7 +206,10 @@ static PyObject *ImageRegistration_ApplyOffset2Image(PyObject *self, PyObject *a
     
     try
     {
-        rsgis::cmds::executeApplyOffset2Image(std::string(pszInputImage), std::string(pszOutputImage), std::string(pszGDALFormat), (rsgis::RSGISLibDataType) nOutDataType, xOff, yOff);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeApplyOffset2Image(std::string(pszInputImage), std::string(pszOutputImage), std::string(pszGDALFormat), (rsgis::RSGISLibDataType) nOutDataType, xOff, yOff);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -214,7 +223,7 @@ static PyObject *ImageRegistration_ApplyOffset2Image(PyObject *self, PyObject *a
 // Our list of functions in this module
 static PyMethodDef ImageRegistrationMethods[] = {
     {"basicregistration", ImageRegistration_BasicRegistration, METH_VARARGS, 
-"imageregistration.basicregistration(reference, floating, pixelGap, threshold, window, search, stddevRef, stddevFloat, subpixelresolution, metric, outputType, output)\n"
+"imageregistration.basicregistration(reference, floating, pixelGap, threshold, window, search, stddevRef, stddevFloat, subpixelresolution, metric, outputType, output, pyramidLevels=0, fftCorrelation=False)\n"
 "Generate tie points between floating and reference image using basic algorithm.\n"
 "\n"
 "Where:\n"
@@ -231,6 +240,8 @@ static PyMethodDef ImageRegistrationMethods[] = {
 ":param metric: is an the similarity metric used to compare images of type rsgislib.imageregistration.METRIC_* \n"
 ":param outputType: is an the format of the output file of type rsgislib.imageregistration.TYPE_* \n"
 ":param output: is a string giving specifying the output file, containing the generated tie points\n"
+":param pyramidLevels: is an int giving the number of levels (each decimating the images by 2) over which the offsets are first searched coarse to fine, before a local search at full resolution. 0 (default) searches every offset at full resolution.\n"
+":param fftCorrelation: is a bool specifying that, when the correlation metric is used, the metric for every offset is calculated at once using FFTs (default False). The result is the same as the search but faster for large search areas.\n"
 "\n"
 "Example::\n"
 "\n"
@@ -251,7 +262,7 @@ static PyMethodDef ImageRegistrationMethods[] = {
 },
 
     {"singlelayerregistration", ImageRegistration_SingleLayerRegistration, METH_VARARGS, 
-"imageregistration.singlelayerregistration(reference, floating, pixelGap, threshold, window, search, stddevRef, stddevFloat, subpixelresolution, distanceThreshold, maxiterations, movementThreshold, pSmoothness, metric, outputType, output)\n"
+"imageregistration.singlelayerregistration(reference, floating, pixelGap, threshold, window, search, stddevRef, stddevFloat, subpixelresolution, distanceThreshold, maxiterations, movementThreshold, pSmoothness, metric, outputType, output, pyramidLevels=0, fftCorrelation=False)\n"
 "Generate tie points between floating and reference image using a single connected layer of tie points.\n"
 "\n"
 "Where:\n"
@@ -271,6 +282,8 @@ static PyMethodDef ImageRegistrationMethods[] = {
 ":param metric: is an the similarity metric used to compare images of type rsgislib.imageregistration.METRIC_* \n"
 ":param outputType: is an the format of the output file of type rsgislib.imageregistration.TYPE_* \n"
 ":param output: is a string giving specifying the output file, containing the generated tie points\n"
+":param pyramidLevels: is an int giving the number of levels (each decimating the images by 2) over which the offsets are first searched coarse to fine, before a local search at full resolution. 0 (default) searches every offset at full resolution.\n"
+":param fftCorrelation: is a bool specifying that, when the correlation metric is used, the metric for every offset is calculated at once using FFTs (default False). The result is the same as the search but faster for large search areas.\n"
 "\n"
 "Example::\n"
 "\n"
@@ -292,7 +305,7 @@ static PyMethodDef ImageRegistrationMethods[] = {
 },
 
     {"triangularwarp", ImageRegistration_TriangularWarp, METH_VARARGS, 
-"imageregistration.triangularwarp(inputimage, inputgcps, outputimage, wktStringFile, resolution, gdalformat, transformImage=False)\n"
+"imageregistration.triangularwarp(inputimage, inputgcps, outputimage, wktStringFile, resolution, gdalformat, transformImage=False, transformError=0)\n"
 "Warp image from tie points using triangular interpolation.\n"
 "\n"
 "Where:\n"
@@ -304,6 +317,7 @@ static PyMethodDef ImageRegistrationMethods[] = {
 ":param resolution: is a float providing the resolution of the output file\n"
 ":param gdalformat: is a string providing the output format (e.g., KEA).\n"
 ":param transformImage: is a bool, if set to true will generate an image providing the transform for each pixel, rather than warping the input image \n"
+":param transformError: is a float giving the maximum error (in input pixels) allowed when the transform is interpolated between the nodes of a grid, rather than calculated for every pixel. 0 (default) calculates the transform for every pixel.\n"
 "\n"
 "Example::\n"
 "\n"
@@ -346,7 +360,7 @@ static PyMethodDef ImageRegistrationMethods[] = {
 },  
 
     {"polywarp", ImageRegistration_PolyWarp, METH_VARARGS, 
-"imageregistration.polywarp(inputimage, inputgcps, outputimage, wktStringFile, resolution, polyOrder, gdalformat, transformImage=False)\n"
+"imageregistration.polywarp(inputimage, inputgcps, outputimage, wktStringFile, resolution, polyOrder, gdalformat, transformImage=False, transformError=0)\n"
 "Warp image from tie points using a polynomial interpolation.\n"
 "\n"
 "Where:\n"
@@ -359,6 +373,7 @@ static PyMethodDef ImageRegistrationMethods[] = {
 ":param polyOrder: is an int specifying the order of polynomial to use.\n"
 ":param gdalformat: is a string providing the output format (e.g., KEA).\n"
 ":param transformImage: is a bool, if set to true will generate an image providing the transform for each pixel, rather than warping the input image \n"
+":param transformError: is a float giving the maximum error (in input pixels) allowed when the transform is interpolated between the nodes of a grid, rather than calculated for every pixel. 0 (default) calculates the transform for every pixel.\n"
 "\n"
 "Example::\n"
 "\n"
@@ -23,6 +23,7 @@
 #include "rsgispy_common.h"
 #include "cmds/RSGISCmdImageUtils.h"
 #include <vector>
+#include <memory>
 
 /* An exception object for this module */
 /* created in the init function */
@@ -113,20 +114,25 @@ static std::vector<int> ExtractIntVectorFromSequence(PyObject *sequence)
 
 static PyObject *ImageUtils_StretchImage(PyObject *self, PyObject *args, PyObject *keywds)
 {
-    static char *kwlist[] = {"inputimage", "outputimage", "saveoutstats", "outstatsfile", "ignorezeros", "onepasssd", "gdalformat", "datatype", "stretchtype", "stretchparam", NULL};
+    static char *kwlist[] = {"inputimage", "outputimage", "saveoutstats", "outstatsfile", "ignorezeros", "onepasssd", "gdalformat", "datatype", "stretchtype", "stretchparam", "statssampling", "usepercentiles", NULL};
     const char *pszInputImage, *pszOutputFile, *pszGDALFormat, *pszOutStatsFile;
     int saveOutStats, ignoreZeros, onePassSD;
     int nOutDataType, nStretchType;
     float fStretchParam = 2.0;
+    unsigned int statsSampling = 1;
+    int usePercentiles = false;
     
-    if( !PyArg_ParseTupleAndKeywords(args, keywds, "ssisiisii|f:stretchImage", kwlist, &pszInputImage, &pszOutputFile, &saveOutStats, &pszOutStatsFile, &ignoreZeros, &onePassSD, &pszGDALFormat, &nOutDataType, &nStretchType, &fStretchParam))
+    if( !PyArg_ParseTupleAndKeywords(args, keywds, "ssisiisii|fIi:stretchImage", kwlist, &pszInputImage, &pszOutputFile, &saveOutStats, &pszOutStatsFile, &ignoreZeros, &onePassSD, &pszGDALFormat, &nOutDataType, &nStretchType, &fStretchParam, &statsSampling, &usePercentiles))
     {
         return NULL;
     }
 
     try
     {
-        rsgis::cmds::executeStretchImage(pszInputImage, pszOutputFile, saveOutStats, pszOutStatsFile, ignoreZeros, onePassSD, pszGDALFormat, (rsgis::RSGISLibDataType)nOutDataType, (rsgis::cmds::RSGISStretches)nStretchType, fStretchParam);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeStretchImage(pszInputImage, pszOutputFile, saveOutStats, pszOutStatsFile, ignoreZeros, onePassSD, pszGDALFormat, (rsgis::RSGISLibDataType)nOutDataType, (rsgis::cmds::RSGISStretches)nStretchType, fStretchParam, statsSampling, usePercentiles);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -139,21 +145,26 @@ static PyObject *ImageUtils_StretchImage(PyObject *self, PyObject *args, PyObjec
 
 static PyObject *ImageUtils_StretchImageNoData(PyObject *self, PyObject *args, PyObject *keywds)
 {
-    static char *kwlist[] = {"inputimage", "outputimage", "saveoutstats", "outstatsfile", "nodataval", "onepasssd", "gdalformat", "datatype", "stretchtype", "stretchparam", NULL};
+    static char *kwlist[] = {"inputimage", "outputimage", "saveoutstats", "outstatsfile", "nodataval", "onepasssd", "gdalformat", "datatype", "stretchtype", "stretchparam", "statssampling", "usepercentiles", NULL};
     const char *pszInputImage, *pszOutputFile, *pszGDALFormat, *pszOutStatsFile;
     int saveOutStats, onePassSD;
     int nOutDataType, nStretchType;
     float fStretchParam = 2.0;
     float inNoData = 0.0;
+    unsigned int statsSampling = 1;
+    int usePercentiles = false;
     
-    if( !PyArg_ParseTupleAndKeywords(args, keywds, "ssisfisii|f:stretchImageNoData", kwlist, &pszInputImage, &pszOutputFile, &saveOutStats, &pszOutStatsFile, &inNoData, &onePassSD, &pszGDALFormat, &nOutDataType, &nStretchType, &fStretchParam))
+    if( !PyArg_ParseTupleAndKeywords(args, keywds, "ssisfisii|fIi:stretchImageNoData", kwlist, &pszInputImage, &pszOutputFile, &saveOutStats, &pszOutStatsFile, &inNoData, &onePassSD, &pszGDALFormat, &nOutDataType, &nStretchType, &fStretchParam, &statsSampling, &usePercentiles))
     {
         return NULL;
     }
 
     try
     {
-        rsgis::cmds::executeStretchImageNoData(pszInputImage, pszOutputFile, inNoData, saveOutStats, pszOutStatsFile, onePassSD, pszGDALFormat, (rsgis::RSGISLibDataType)nOutDataType, (rsgis::cmds::RSGISStretches)nStretchType, fStretchParam);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeStretchImageNoData(pszInputImage, pszOutputFile, inNoData, saveOutStats, pszOutStatsFile, onePassSD, pszGDALFormat, (rsgis::RSGISLibDataType)nOutDataType, (rsgis::cmds::RSGISStretches)nStretchType, fStretchParam, statsSampling, usePercentiles);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -179,7 +190,10 @@ static PyObject *ImageUtils_StretchImageWithStats(PyObject *self, PyObject *args
 
     try
     {
-        rsgis::cmds::executeStretchImageWithStats(pszInputImage, pszOutputFile, pszInStatsFile, pszGDALFormat, (rsgis::RSGISLibDataType)nOutDataType, (rsgis::cmds::RSGISStretches)nStretchType, fStretchParam);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeStretchImageWithStats(pszInputImage, pszOutputFile, pszInStatsFile, pszGDALFormat, (rsgis::RSGISLibDataType)nOutDataType, (rsgis::cmds::RSGISStretches)nStretchType, fStretchParam);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -206,7 +220,10 @@ static PyObject *ImageUtils_StretchImageWithStatsNoData(PyObject *self, PyObject
 
     try
     {
-        rsgis::cmds::executeStretchImageWithStatsNoData(pszInputImage, pszOutputFile, pszInStatsFile, pszGDALFormat, (rsgis::RSGISLibDataType)nOutDataType, (rsgis::cmds::RSGISStretches)nStretchType, fStretchParam, nodataval);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeStretchImageWithStatsNoData(pszInputImage, pszOutputFile, pszInStatsFile, pszGDALFormat, (rsgis::RSGISLibDataType)nOutDataType, (rsgis::cmds::RSGISStretches)nStretchType, fStretchParam, nodataval);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -235,7 +252,10 @@ static PyObject *ImageUtils_NormaliseImagePxlVals(PyObject *self, PyObject *args
     
     try
     {
-        rsgis::cmds::executeNormaliseImgPxlVals(std::string(pszInputImage), std::string(pszOutputFile), std::string(pszGDALFormat), (rsgis::RSGISLibDataType)nOutDataType, inNoDataVal, outNoDataVal, outMinVal, outMaxVal, (rsgis::cmds::RSGISStretches)nStretchType, fStretchParam);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeNormaliseImgPxlVals(std::string(pszInputImage), std::string(pszOutputFile), std::string(pszGDALFormat), (rsgis::RSGISLibDataType)nOutDataType, inNoDataVal, outNoDataVal, outMinVal, outMaxVal, (rsgis::cmds::RSGISStretches)nStretchType, fStretchParam);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -292,7 +312,10 @@ static PyObject *ImageUtils_maskImage(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeMaskImage(pszInputImage, pszImageMask, pszOutputImage, pszGDALFormat, (rsgis::RSGISLibDataType)nDataType, outValue, maskValues);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeMaskImage(pszInputImage, pszImageMask, pszOutputImage, pszGDALFormat, (rsgis::RSGISLibDataType)nDataType, outValue, maskValues);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -319,7 +342,10 @@ static PyObject *ImageUtils_createTiles(PyObject *self, PyObject *args)
     try
     {
         std::vector<std::string> outFileNames;
-        rsgis::cmds::executeCreateTiles(pszInputImage, pszImageBase, imgWidth, imgHeight, imgTileOverlap, offsetTiling, pszGDALFormat, (rsgis::RSGISLibDataType)nDataType, pszExt, &outFileNames);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCreateTiles(pszInputImage, pszImageBase, imgWidth, imgHeight, imgTileOverlap, offsetTiling, pszGDALFormat, (rsgis::RSGISLibDataType)nDataType, pszExt, &outFileNames);
+        }
         
         pOutList = PyList_New(outFileNames.size());
         Py_ssize_t nIndex = 0;
@@ -368,8 +394,11 @@ static PyObject *ImageUtils_createImageMosaic(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeImageMosaic(inputImages, numImages, pszOutputImage, backgroundVal, 
-                    skipVal, skipBand-1, overlapBehaviour, pszGDALFormat, (rsgis::RSGISLibDataType)nDataType);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeImageMosaic(inputImages, numImages, pszOutputImage, backgroundVal, 
+                        skipVal, skipBand-1, overlapBehaviour, pszGDALFormat, (rsgis::RSGISLibDataType)nDataType);
+        }
 
     }
     catch(rsgis::cmds::RSGISCmdException &e)
@@ -449,7 +478,10 @@ static PyObject *ImageUtils_IncludeImages(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeImageInclude(inputImages, numImages, pszBaseImage, bandsDefined, imgBands, skipVal, useSkipVal);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeImageInclude(inputImages, numImages, pszBaseImage, bandsDefined, imgBands, skipVal, useSkipVal);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -490,7 +522,10 @@ static PyObject *ImageUtils_IncludeImagesOverlap(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeImageIncludeOverlap(inputImages, numImages, pszBaseImage, pxlOverlap);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeImageIncludeOverlap(inputImages, numImages, pszBaseImage, pxlOverlap);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -530,7 +565,10 @@ static PyObject *ImageUtils_IncludeImagesIndImgIntersect(PyObject *self, PyObjec
     
     try
     {
-        rsgis::cmds::executeImageIncludeIndImgIntersect(inputImages, numImages, pszBaseImage);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeImageIncludeIndImgIntersect(inputImages, numImages, pszBaseImage);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -584,7 +622,10 @@ static PyObject *ImageUtils_CombineImageOverview(PyObject *self, PyObject *args,
     
     try
     {
-        rsgis::cmds::executeImageIncludeOverviews(std::string(pszBaseImage), inputImages, pyraScaleVals);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeImageIncludeOverviews(std::string(pszBaseImage), inputImages, pyraScaleVals);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -632,7 +673,10 @@ static PyObject *ImageUtils_PopImageStats(PyObject *self, PyObject *args, PyObje
     
     try
     {
-        rsgis::cmds::executePopulateImgStats(pszInputImage, useNoDataValue, noDataValue, buildPyramids, pyraScaleVals);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePopulateImgStats(pszInputImage, useNoDataValue, noDataValue, buildPyramids, pyraScaleVals);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -680,7 +724,10 @@ static PyObject *ImageUtils_AssignProj(PyObject *self, PyObject *args, PyObject
     
     try
     {
-        rsgis::cmds::executeAssignProj(pszInputImage, pszInputProj, readWKTFromFile, pszInputProjFile);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeAssignProj(pszInputImage, pszInputProj, readWKTFromFile, pszInputProjFile);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -701,7 +748,10 @@ static PyObject *ImageUtils_CopyProjFromImage(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeCopyProj(pszInputImage, pszInputRefImage);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCopyProj(pszInputImage, pszInputRefImage);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -722,7 +772,10 @@ static PyObject *ImageUtils_CopySpatialAndProjFromImage(PyObject *self, PyObject
     
     try
     {
-        rsgis::cmds::executeCopyProjSpatial(pszInputImage, pszInputRefImage);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCopyProjSpatial(pszInputImage, pszInputRefImage);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -817,7 +870,10 @@ static PyObject *ImageUtils_AssignSpatialInfo(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeAssignSpatialInfo(pszInputImage, xTL, yTL, xRes, yRes, xRot, yRot, xTLDef, yTLDef, xResDef, yResDef, xRotDef, yRotDef);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeAssignSpatialInfo(pszInputImage, xTL, yTL, xRes, yRes, xRot, yRot, xTLDef, yTLDef, xResDef, yResDef, xRotDef, yRotDef);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -845,7 +901,10 @@ static PyObject *ImageUtils_ExtractZoneImageValues2HDF(PyObject *self, PyObject
     
     try
     {
-        rsgis::cmds::executeImageRasterZone2HDF(std::string(pszInputImage), std::string(pszInputMaskImage), std::string(pszOutputFile), maskValue, type);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeImageRasterZone2HDF(std::string(pszInputImage), std::string(pszInputMaskImage), std::string(pszOutputFile), maskValue, type);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -938,7 +997,106 @@ static PyObject *ImageUtils_ExtractZoneImageBandValues2HDF(PyObject *self, PyObj
     
     try
     {
-        rsgis::cmds::executeImageBandRasterZone2HDF(imageFilesInfo, std::string(pszInputMaskImage), std::string(pszOutputFile), maskValue, type);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeImageBandRasterZone2HDF(imageFilesInfo, std::string(pszInputMaskImage), std::string(pszOutputFile), maskValue, type);
+        }
+    }
+    catch(rsgis::cmds::RSGISCmdException &e)
+    {
+        PyErr_SetString(GETSTATE(self)->error, e.what());
+        return NULL;
+    }
+    
+    Py_RETURN_NONE;
+}
+
+static PyObject *ImageUtils_ExtractPointsImageBandValues2HDF(PyObject *self, PyObject *args)
+{
+    PyObject *inputImageFileInfoObj;
+    const char *pszInputVector;
+    const char *pszInputVecLyr;
+    const char *pszOutputFile;
+    int nDataType = 9;
+    
+    if( !PyArg_ParseTuple(args, "Osss|i:extractPointsImageBandValues2HDF", &inputImageFileInfoObj, &pszInputVector, &pszInputVecLyr, &pszOutputFile, &nDataType))
+    {
+        return NULL;
+    }
+    
+    if( !PySequence_Check(inputImageFileInfoObj))
+    {
+        PyErr_SetString(GETSTATE(self)->error, "First argument (imageFileInfo) must be a sequence");
+        return NULL;
+    }
+    
+    rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)nDataType;
+    
+    Py_ssize_t nFileInfo = PySequence_Size(inputImageFileInfoObj);
+    std::vector<std::pair<std::string, std::vector<unsigned int> > > imageFilesInfo;
+    imageFilesInfo.reserve(nFileInfo);
+    std::string tmpFileName = "";
+    
+    for( Py_ssize_t n = 0; n < nFileInfo; n++ )
+    {
+        PyObject *o = PySequence_GetItem(inputImageFileInfoObj, n);
+        
+        PyObject *pFileName = PyObject_GetAttrString(o, "fileName");
+        if( ( pFileName == NULL ) || ( pFileName == Py_None ) || !RSGISPY_CHECK_STRING(pFileName) )
+        {
+            PyErr_SetString(GETSTATE(self)->error, "Could not find string attribute \'fileName\'" );
+            Py_XDECREF(pFileName);
+            Py_DECREF(o);
+            return NULL;
+        }
+        
+        PyObject *pBands = PyObject_GetAttrString(o, "bands");
+        if( ( pBands == NULL ) || ( pBands == Py_None ) || !PySequence_Check(pBands) )
+        {
+            PyErr_SetString(GETSTATE(self)->error, "Could not find sequence attribute \'bands\'" );
+            Py_DECREF(pFileName);
+            Py_XDECREF(pBands);
+            Py_DECREF(o);
+            return NULL;
+        }
+        
+        Py_ssize_t nBands = PySequence_Size(pBands);
+        if(nBands == 0)
+        {
+            PyErr_SetString(GETSTATE(self)->error, "Sequence attribute \'bands\' is empty." );
+            Py_DECREF(pFileName);
+            Py_DECREF(pBands);
+            Py_DECREF(o);
+            return NULL;
+        }
+        std::vector<unsigned int> bandsVec = std::vector<unsigned int>();
+        bandsVec.reserve(nBands);
+        for( Py_ssize_t i = 0; i < nBands; i++ )
+        {
+            PyObject *bO = PySequence_GetItem(pBands, i);
+            if( ( bO == NULL ) || ( bO == Py_None ) || !RSGISPY_CHECK_INT(bO) )
+            {
+                PyErr_SetString(GETSTATE(self)->error, "Element of 'bands' list was not an integer." );
+                Py_XDECREF(bO);
+                
+                Py_DECREF(pFileName);
+                Py_DECREF(pBands);
+                Py_DECREF(o);
+                return NULL;
+            }
+            bandsVec.push_back(RSGISPY_INT_EXTRACT(bO));
+        }
+        
+        tmpFileName = std::string(RSGISPY_STRING_EXTRACT(pFileName));
+        imageFilesInfo.push_back(std::pair<std::string, std::vector<unsigned int> >(tmpFileName, bandsVec));
+    }
+    
+    try
+    {
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeImageBandPoints2HDF(imageFilesInfo, std::string(pszInputVector), std::string(pszInputVecLyr), std::string(pszOutputFile), type);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -986,7 +1144,10 @@ static PyObject *ImageUtils_SelectImageBands(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeSubsetImageBands(std::string(pszInputImage), std::string(pszOutputFile), imgBands, std::string(pszGDALFormat), (rsgis::RSGISLibDataType)nDataType);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeSubsetImageBands(std::string(pszInputImage), std::string(pszOutputFile), imgBands, std::string(pszGDALFormat), (rsgis::RSGISLibDataType)nDataType);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1007,7 +1168,10 @@ static PyObject *ImageUtils_Subset(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeSubset(pszInputImage, pszInputVector, pszOutputImage, pszGDALFormat, (rsgis::RSGISLibDataType)nOutDataType);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeSubset(pszInputImage, pszInputVector, pszOutputImage, pszGDALFormat, (rsgis::RSGISLibDataType)nOutDataType);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1029,7 +1193,10 @@ static PyObject *ImageUtils_SubsetBBox(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeSubsetBBox(pszInputImage, pszOutputImage, pszGDALFormat, (rsgis::RSGISLibDataType)nOutDataType, xMin, xMax, yMin, yMax);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeSubsetBBox(pszInputImage, pszOutputImage, pszGDALFormat, (rsgis::RSGISLibDataType)nOutDataType, xMin, xMax, yMin, yMax);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1053,7 +1220,10 @@ static PyObject *ImageUtils_Subset2Polys(PyObject *self, PyObject *args)
     {
         std::vector<std::string> outFileNames;
         
-        rsgis::cmds::executeSubset2Polys(pszInputImage, pszInputVector, pszAttribute, pszOutputImageBase, pszGDALFormat, (rsgis::RSGISLibDataType)nOutDataType, pszOutputExt, &outFileNames);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeSubset2Polys(pszInputImage, pszInputVector, pszAttribute, pszOutputImageBase, pszGDALFormat, (rsgis::RSGISLibDataType)nOutDataType, pszOutputExt, &outFileNames);
+        }
      
         pOutList = PyList_New(outFileNames.size());
         Py_ssize_t nIndex = 0;
@@ -1083,7 +1253,10 @@ static PyObject *ImageUtils_Subset2Img(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeSubset2Img(pszInputImage, pszInputROI, pszOutputImage, pszGDALFormat, (rsgis::RSGISLibDataType)nOutDataType);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeSubset2Img(pszInputImage, pszInputROI, pszOutputImage, pszGDALFormat, (rsgis::RSGISLibDataType)nOutDataType);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1159,7 +1332,10 @@ static PyObject *ImageUtils_StackImageBands(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeStackImageBands(inputImages, imageBandNames, numImages, std::string(pszOutputFile), skipPixels, skipValue, noDataValue, std::string(pszGDALFormat), (rsgis::RSGISLibDataType)nDataType, replaceBandNames);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeStackImageBands(inputImages, imageBandNames, numImages, std::string(pszOutputFile), skipPixels, skipValue, noDataValue, std::string(pszGDALFormat), (rsgis::RSGISLibDataType)nDataType, replaceBandNames);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1184,7 +1360,10 @@ static PyObject *ImageUtils_CreateBlankImage(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeCreateBlankImage(std::string(pszOutputImage), numBands, width, height, tlX, tlY, res, pxlVal, std::string(wktFile), std::string(wktString), std::string(pszGDALFormat), (rsgis::RSGISLibDataType)nOutDataType);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCreateBlankImage(std::string(pszOutputImage), numBands, width, height, tlX, tlY, res, pxlVal, std::string(wktFile), std::string(wktString), std::string(pszGDALFormat), (rsgis::RSGISLibDataType)nOutDataType);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1207,7 +1386,10 @@ static PyObject *ImageUtils_CreateCopyImage(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeCreateCopyBlankImage(std::string(pszInputImage), std::string(pszOutputImage), numBands, pxlVal, std::string(pszGDALFormat), (rsgis::RSGISLibDataType)nOutDataType);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCreateCopyBlankImage(std::string(pszInputImage), std::string(pszOutputImage), numBands, pxlVal, std::string(pszGDALFormat), (rsgis::RSGISLibDataType)nOutDataType);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1233,7 +1415,10 @@ static PyObject *ImageUtils_CreateCopyImageDefExtent(PyObject *self, PyObject *a
     
     try
     {
-        rsgis::cmds::executeCreateCopyBlankImage(std::string(pszInputImage), std::string(pszOutputImage), numBands, xMin, xMax, yMin, yMax, xRes, yRes, pxlVal, std::string(pszGDALFormat), (rsgis::RSGISLibDataType)nOutDataType);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCreateCopyBlankImage(std::string(pszInputImage), std::string(pszOutputImage), numBands, xMin, xMax, yMin, yMax, xRes, yRes, pxlVal, std::string(pszGDALFormat), (rsgis::RSGISLibDataType)nOutDataType);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1256,7 +1441,10 @@ static PyObject *ImageUtils_CreateCopyImageVecExtent(PyObject *self, PyObject *a
     
     try
     {
-        rsgis::cmds::executeCreateCopyBlankImageVecExtent(std::string(pszInputImage), std::string(pszExtentShp), std::string(pszOutputImage), numBands, pxlVal, std::string(pszGDALFormat), (rsgis::RSGISLibDataType)nOutDataType);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCreateCopyBlankImageVecExtent(std::string(pszInputImage), std::string(pszExtentShp), std::string(pszOutputImage), numBands, pxlVal, std::string(pszGDALFormat), (rsgis::RSGISLibDataType)nOutDataType);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1291,7 +1479,10 @@ static PyObject *ImageUtils_StackStats(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeStackStats(pszInputImage, pszOutputImage, pszCalcStat, allBands, numBands, std::string(pszGDALFormat), (rsgis::RSGISLibDataType)nOutDataType);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeStackStats(pszInputImage, pszOutputImage, pszCalcStat, allBands, numBands, std::string(pszGDALFormat), (rsgis::RSGISLibDataType)nOutDataType);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1306,9 +1497,10 @@ static PyObject *ImageUtils_OrderImagesUsingPropValidData(PyObject *self, PyObje
 {
     float noDataValue;
     PyObject *pInputImages; // List of input images
+    int exactCount = 0;
     
     // Check parameters are present and of correct type
-    if( !PyArg_ParseTuple(args, "Of:orderImageUsingPropValidPxls", &pInputImages, &noDataValue))
+    if( !PyArg_ParseTuple(args, "Of|i:orderImageUsingPropValidPxls", &pInputImages, &noDataValue, &exactCount))
         return NULL;
     
     // TODO: Look into this function - doesn't seem to catch when only a single image is provided.
@@ -1329,7 +1521,11 @@ static PyObject *ImageUtils_OrderImagesUsingPropValidData(PyObject *self, PyObje
     PyObject *outImagesList = NULL;
     try
     {
-        std::vector<std::string> orderedInputImages = rsgis::cmds::executeOrderImageUsingValidDataProp(inputImages, noDataValue);
+        std::vector<std::string> orderedInputImages;
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            orderedInputImages = rsgis::cmds::executeOrderImageUsingValidDataProp(inputImages, noDataValue, (exactCount != 0));
+        }
         
         outImagesList = PyTuple_New(orderedInputImages.size());
         
@@ -1372,7 +1568,10 @@ static PyObject *ImageUtils_GenSamplingGrid(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeProduceRegularGridImage(std::string(pszInputImage), std::string(pszOutputImage), std::string(pszGDALFormat), pxlRes, minVal, maxVal, (bool)singleLine);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeProduceRegularGridImage(std::string(pszInputImage), std::string(pszOutputImage), std::string(pszGDALFormat), pxlRes, minVal, maxVal, (bool)singleLine);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1399,7 +1598,10 @@ static PyObject *ImageUtils_GenFiniteMask(PyObject *self, PyObject *args, PyObje
     
     try
     {
-        rsgis::cmds::executeFiniteImageMask(std::string(pszInputImage), std::string(pszOutputImage), std::string(pszGDALFormat));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeFiniteImageMask(std::string(pszInputImage), std::string(pszOutputImage), std::string(pszGDALFormat));
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1454,7 +1656,10 @@ static PyObject *ImageUtils_GenValidMask(PyObject *self, PyObject *args, PyObjec
     
     try
     {
-        rsgis::cmds::executeValidImageMask(inputImages, std::string(pszOutputImage), std::string(pszGDALFormat), noDataVal);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeValidImageMask(inputImages, std::string(pszOutputImage), std::string(pszGDALFormat), noDataVal);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1507,7 +1712,10 @@ static PyObject *ImageUtils_CombineImages2Band(PyObject *self, PyObject *args, P
     
     try
     {
-        rsgis::cmds::executeCombineImagesSingleBandIgnoreNoData(inputImages, std::string(pszOutputImage), noDataVal, std::string(pszGDALFormat), type);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCombineImagesSingleBandIgnoreNoData(inputImages, std::string(pszOutputImage), noDataVal, std::string(pszGDALFormat), type);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1568,7 +1776,10 @@ static PyObject *ImageUtils_PerformRandomPxlSample(PyObject *self, PyObject *arg
     
     try
     {
-        rsgis::cmds::executePerformRandomPxlSample(std::string(pszInputImage), std::string(pszOutputImage), std::string(pszGDALFormat), maskVals, numSamples);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePerformRandomPxlSample(std::string(pszInputImage), std::string(pszOutputImage), std::string(pszGDALFormat), maskVals, numSamples);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1629,7 +1840,10 @@ static PyObject *ImageUtils_PerformRandomPxlSampleSmallPxlCount(PyObject *self,
     
     try
     {
-        rsgis::cmds::executePerformRandomPxlSampleSmallPxlCount(std::string(pszInputImage), std::string(pszOutputImage), std::string(pszGDALFormat), maskVals, numSamples, rndSeed);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePerformRandomPxlSampleSmallPxlCount(std::string(pszInputImage), std::string(pszOutputImage), std::string(pszGDALFormat), maskVals, numSamples, rndSeed);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1660,7 +1874,46 @@ static PyObject *ImageUtils_PanSharpenHCS(PyObject *self, PyObject *args, PyObje
     try
     {
         bool useNaiveMeth = (bool)useNaiveMethInt;
-        rsgis::cmds::executePerformHCSPanSharpen(std::string(pszInputImage), std::string(pszOutputImage), std::string(pszGDALFormat), type, winSize, useNaiveMeth);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePerformHCSPanSharpen(std::string(pszInputImage), std::string(pszOutputImage), std::string(pszGDALFormat), type, winSize, useNaiveMeth);
+        }
+    }
+    catch(rsgis::cmds::RSGISCmdException &e)
+    {
+        PyErr_SetString(GETSTATE(self)->error, e.what());
+        return NULL;
+    }
+    
+    Py_RETURN_NONE;
+}
+
+static PyObject *ImageUtils_PanSharpenHCSFused(PyObject *self, PyObject *args, PyObject *keywds)
+{
+    static char *kwlist[] = {"msimage", "panimage", "outimage", "gdalformat", "datatype", "winsize", "useNaiveMethod", "statsdecimation", NULL};
+    const char *pszMSImage = "";
+    const char *pszPanImage = "";
+    const char *pszOutputImage = "";
+    const char *pszGDALFormat = "";
+    int nDataType;
+    unsigned int winSize = 7;
+    int useNaiveMethInt = false;
+    unsigned int statsDecimation = 1;
+    
+    if( !PyArg_ParseTupleAndKeywords(args, keywds, "ssssi|IiI:panSharpenHCSFused", kwlist, &pszMSImage, &pszPanImage, &pszOutputImage, &pszGDALFormat, &nDataType, &winSize, &useNaiveMethInt, &statsDecimation))
+    {
+        return NULL;
+    }
+    
+    rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)nDataType;
+    
+    try
+    {
+        bool useNaiveMeth = (bool)useNaiveMethInt;
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePerformHCSPanSharpenFused(std::string(pszMSImage), std::string(pszPanImage), std::string(pszOutputImage), std::string(pszGDALFormat), type, winSize, useNaiveMeth, statsDecimation);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1771,7 +2024,10 @@ static PyObject *ImageUtils_SharpenLowResImageBands(PyObject *self, PyObject *ar
     
     try
     {
-        rsgis::cmds::executeSharpenLowResImgBands(std::string(pszInputImage), std::string(pszOutputImage), bandInfo, winSize, nodata, std::string(pszGDALFormat), type);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeSharpenLowResImgBands(std::string(pszInputImage), std::string(pszOutputImage), bandInfo, winSize, nodata, std::string(pszGDALFormat), type);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1824,7 +2080,10 @@ static PyObject *ImageUtils_CreateMaxNDVICompositeImg(PyObject *self, PyObject *
     
     try
     {
-        rsgis::cmds::executeCreateMaxNDVICompsiteImage(inputImages, std::string(pszOutputImage), redBand, nirBand, std::string(pszGDALFormat), type);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCreateMaxNDVICompsiteImage(inputImages, std::string(pszOutputImage), redBand, nirBand, std::string(pszGDALFormat), type);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1877,7 +2136,10 @@ static PyObject *ImageUtils_CreateRefImageCompositeImg(PyObject *self, PyObject
     
     try
     {
-        rsgis::cmds::executeCreateRefImgCompsiteImage(inputImages, std::string(pszOutputImage), std::string(pszRefImage), std::string(pszGDALFormat), type, outNoData);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCreateRefImgCompsiteImage(inputImages, std::string(pszOutputImage), std::string(pszRefImage), std::string(pszGDALFormat), type, outNoData);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -1985,7 +2247,10 @@ static PyObject *ImageUtils_GenTimeseriesFillCompositeImg(PyObject *self, PyObje
     try
     {
         rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)nDataType;
-        rsgis::cmds::executeGenTimeseriesFillCompositeImg(inCompInfo, std::string(pszValidMaskImage), std::string(pszOutRefFillImage), std::string(pszOutCompImage), std::string(pszOutCompRefImage), std::string(pszGDALFormat), type);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeGenTimeseriesFillCompositeImg(inCompInfo, std::string(pszValidMaskImage), std::string(pszOutRefFillImage), std::string(pszOutCompImage), std::string(pszOutCompRefImage), std::string(pszGDALFormat), type);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -2014,7 +2279,10 @@ static PyObject *ImageUtils_ExportSingleMergedImgBand(PyObject *self, PyObject *
     try
     {
         rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)nDataType;
-        rsgis::cmds::executeExportSingleMergedImgBand(std::string(pInputImg), std::string(pInputBandRefImg), std::string(pOutputImg), std::string(pszGDALFormat), type);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeExportSingleMergedImgBand(std::string(pInputImg), std::string(pInputBandRefImg), std::string(pOutputImg), std::string(pszGDALFormat), type);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -2043,7 +2311,10 @@ static PyObject *ImageUtils_RandomSampleHDF5File(PyObject *self, PyObject *args,
     
     try
     {
-        rsgis::cmds::executeRandomSampleH5File(std::string(pInputH5), std::string(pOutputH5), sampleSize, seed, type);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeRandomSampleH5File(std::string(pInputH5), std::string(pOutputH5), sampleSize, seed, type);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -2073,7 +2344,10 @@ static PyObject *ImageUtils_SplitSampleHDF5File(PyObject *self, PyObject *args,
     
     try
     {
-        rsgis::cmds::executeSplitSampleH5File(std::string(pInputH5), std::string(pOutputP1H5), std::string(pOutputP2H5), sampleSize, seed, type);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeSplitSampleH5File(std::string(pInputH5), std::string(pOutputP1H5), std::string(pOutputP2H5), sampleSize, seed, type);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -2098,7 +2372,11 @@ static PyObject *ImageUtils_GetGDALImageCreationOpts(PyObject *self, PyObject *a
     PyObject *out_info_dict = NULL;
     try
     {
-        std::map<std::string, std::string> gdalCreationOpts = rsgis::cmds::executeGetGDALImageCreationOpts(std::string(pGDALFormat));
+        std::map<std::string, std::string> gdalCreationOpts;
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            gdalCreationOpts = rsgis::cmds::executeGetGDALImageCreationOpts(std::string(pGDALFormat));
+        }
         
         if(gdalCreationOpts.size() > 0)
         {
@@ -2127,11 +2405,240 @@ static PyObject *ImageUtils_GetGDALImageCreationOpts(PyObject *self, PyObject *a
     }
 }
 
+static PyObject *ImageUtils_SetProfiling(PyObject *self, PyObject *args, PyObject *keywds)
+{
+    static char *kwlist[] = {"enable", "printsummary", NULL};
+    int enable = 1;
+    int printSummary = 0;
+
+    if( !PyArg_ParseTupleAndKeywords(args, keywds, "i|i:setProfiling", kwlist, &enable, &printSummary))
+    {
+        return NULL;
+    }
+    
+    rsgis::cmds::executeSetProfiling(enable != 0, printSummary != 0);
+    
+    Py_RETURN_NONE;
+}
+
+static PyObject *ImageUtils_GetProfileCounters(PyObject *self, PyObject *args)
+{
+    std::map<std::string, rsgis::RSGISProfileCounter> counters = rsgis::cmds::executeGetProfileCounters();
+    
+    PyObject *out_counters_dict = PyDict_New();
+    for(std::map<std::string, rsgis::RSGISProfileCounter>::iterator iterCounter = counters.begin(); iterCounter != counters.end(); ++iterCounter)
+    {
+        PyObject *counterDict = Py_BuildValue("{s:K,s:d,s:K,s:K}", "calls", (unsigned long long)iterCounter->second.calls, "seconds", iterCounter->second.seconds, "count", (unsigned long long)iterCounter->second.count, "bytes", (unsigned long long)iterCounter->second.bytes);
+        PyDict_SetItemString(out_counters_dict, (iterCounter->first).c_str(), counterDict);
+        Py_DECREF(counterDict);
+    }
+    
+    return out_counters_dict;
+}
+
+static PyObject *ImageUtils_ResetProfileCounters(PyObject *self, PyObject *args)
+{
+    rsgis::cmds::executeResetProfileCounters();
+    Py_RETURN_NONE;
+}
+
+static PyObject *ImageUtils_SetProgressCallback(PyObject *self, PyObject *args, PyObject *keywds)
+{
+    static char *kwlist[] = {"func", NULL};
+    PyObject *pFunc;
+
+    if( !PyArg_ParseTupleAndKeywords(args, keywds, "O:setProgressCallback", kwlist, &pFunc))
+    {
+        return NULL;
+    }
+    
+    if(pFunc == Py_None)
+    {
+        rsgis::cmds::executeSetProgressCallback(rsgis::RSGISProgressCallback());
+        Py_RETURN_NONE;
+    }
+    
+    if(!PyCallable_Check(pFunc))
+    {
+        PyErr_SetString(GETSTATE(self)->error, "func must be callable or None");
+        return NULL;
+    }
+    
+    // a counter may still hold the previous callback so the reference is
+    // released (with the GIL) when the last copy is destroyed.
+    Py_INCREF(pFunc);
+    std::shared_ptr<PyObject> func(pFunc, [](PyObject *obj){
+        PyGILState_STATE gstate = PyGILState_Ensure();
+        Py_DECREF(obj);
+        PyGILState_Release(gstate);
+    });
+    
+    rsgis::cmds::executeSetProgressCallback([func](const std::string &label, unsigned long long done, unsigned long long total){
+        // the calling thread holds the GIL while a command is not running
+        // (and would be waiting for this reporter) so do not wait for it.
+        if(!rsgis::RSGISProgressCounter::inCallbackScope())
+        {
+            return;
+        }
+        PyGILState_STATE gstate = PyGILState_Ensure();
+        PyObject *pResult = PyObject_CallFunction(func.get(), "sKK", label.c_str(), done, total);
+        if(pResult == NULL)
+        {
+            // an error in the callback does not stop the processing
+            PyErr_Print();
+        }
+        else
+        {
+            Py_DECREF(pResult);
+        }
+        PyGILState_Release(gstate);
+    });
+    
+    Py_RETURN_NONE;
+}
+
+static PyObject *ImageUtils_SetDatasetCacheSize(PyObject *self, PyObject *args, PyObject *keywds)
+{
+    static char *kwlist[] = {"maxdatasets", NULL};
+    unsigned int maxDatasets = 0;
+
+    if( !PyArg_ParseTupleAndKeywords(args, keywds, "I:setDatasetCacheSize", kwlist, &maxDatasets))
+    {
+        return NULL;
+    }
+    
+    {
+        RSGISPyReleaseGIL releaseGIL;
+        rsgis::cmds::executeSetDatasetCacheSize(maxDatasets);
+    }
+    
+    Py_RETURN_NONE;
+}
+
+static PyObject *ImageUtils_InvalidateDatasetCache(PyObject *self, PyObject *args, PyObject *keywds)
+{
+    static char *kwlist[] = {"inputimage", NULL};
+    const char *pInputImage = "";
+
+    if( !PyArg_ParseTupleAndKeywords(args, keywds, "|s:invalidateDatasetCache", kwlist, &pInputImage))
+    {
+        return NULL;
+    }
+    
+    {
+        RSGISPyReleaseGIL releaseGIL;
+        rsgis::cmds::executeInvalidateDatasetCache(std::string(pInputImage));
+    }
+    
+    Py_RETURN_NONE;
+}
+
+static PyObject *ImageUtils_CreateImageFootprintIndex(PyObject *self, PyObject *args, PyObject *keywds)
+{
+    static char *kwlist[] = {"inputimages", "indexfile", "ignorefailed", "nthreads", NULL};
+    PyObject *pInputImages;
+    const char *pszIndexFile;
+    int ignoreFailed = false;
+    unsigned int numThreads = 1;
+    
+    if( !PyArg_ParseTupleAndKeywords(args, keywds, "Os|iI:createImageFootprintIndex", kwlist, &pInputImages, &pszIndexFile, &ignoreFailed, &numThreads))
+    {
+        return NULL;
+    }
+    
+    if(!PySequence_Check(pInputImages))
+    {
+        PyErr_SetString(GETSTATE(self)->error, "inputimages argument must be a list of strings for image paths.");
+        return NULL;
+    }
+    std::vector<std::string> inputImages = ExtractStringVectorFromSequence(pInputImages);
+    
+    try
+    {
+        RSGISPyReleaseGIL releaseGIL;
+        rsgis::cmds::executeCreateImageFootprintIndex(inputImages, std::string(pszIndexFile), ignoreFailed, numThreads);
+    }
+    catch(rsgis::cmds::RSGISCmdException &e)
+    {
+        PyErr_SetString(GETSTATE(self)->error, e.what());
+        return NULL;
+    }
+    
+    Py_RETURN_NONE;
+}
+
+static PyObject *ImageUtils_QueryImageFootprintIndex(PyObject *self, PyObject *args, PyObject *keywds)
+{
+    static char *kwlist[] = {"indexfile", "bbox", "point", NULL};
+    const char *pszIndexFile;
+    PyObject *pBBOX = Py_None;
+    PyObject *pPoint = Py_None;
+    
+    if( !PyArg_ParseTupleAndKeywords(args, keywds, "s|OO:queryImageFootprintIndex", kwlist, &pszIndexFile, &pBBOX, &pPoint))
+    {
+        return NULL;
+    }
+    
+    double bbox[4] = {0, 0, 0, 0};
+    double pt[2] = {0, 0};
+    bool usePoint = false;
+    if(pBBOX != Py_None)
+    {
+        if(!PyArg_ParseTuple(pBBOX, "dddd", &bbox[0], &bbox[1], &bbox[2], &bbox[3]))
+        {
+            PyErr_SetString(GETSTATE(self)->error, "bbox must be a tuple (xMin, xMax, yMin, yMax).");
+            return NULL;
+        }
+    }
+    else if(pPoint != Py_None)
+    {
+        if(!PyArg_ParseTuple(pPoint, "dd", &pt[0], &pt[1]))
+        {
+            PyErr_SetString(GETSTATE(self)->error, "point must be a tuple (x, y).");
+            return NULL;
+        }
+        usePoint = true;
+    }
+    else
+    {
+        PyErr_SetString(GETSTATE(self)->error, "Either bbox or point must be provided.");
+        return NULL;
+    }
+    
+    std::vector<std::string> images;
+    try
+    {
+        RSGISPyReleaseGIL releaseGIL;
+        if(usePoint)
+        {
+            images = rsgis::cmds::executeQueryImageFootprintIndexPoint(std::string(pszIndexFile), pt[0], pt[1]);
+        }
+        else
+        {
+            images = rsgis::cmds::executeQueryImageFootprintIndex(std::string(pszIndexFile), bbox[0], bbox[1], bbox[2], bbox[3]);
+        }
+    }
+    catch(rsgis::cmds::RSGISCmdException &e)
+    {
+        PyErr_SetString(GETSTATE(self)->error, e.what());
+        return NULL;
+    }
+    
+    PyObject *pOutList = PyList_New(images.size());
+    Py_ssize_t nIndex = 0;
+    for(std::vector<std::string>::iterator itr = images.begin(); itr != images.end(); itr++)
+    {
+        PyList_SetItem(pOutList, nIndex, RSGISPY_CREATE_STRING((*itr).c_str())); // steals a reference
+        nIndex++;
+    }
+    return pOutList;
+}
+
 
 // Our list of functions in this module
 static PyMethodDef ImageUtilsMethods[] = {
 {"stretchImage", (PyCFunction)ImageUtils_StretchImage, METH_VARARGS | METH_KEYWORDS,
-"rsgislib.imageutils.stretchImage(inputimage, outputimage, saveoutstats, outstatsfile, ignorezeros, onepasssd, gdalformat, datatype, stretchtype, stretchparam)\n"
+"rsgislib.imageutils.stretchImage(inputimage, outputimage, saveoutstats, outstatsfile, ignorezeros, onepasssd, gdalformat, datatype, stretchtype, stretchparam, statssampling, usepercentiles)\n"
 "Stretches (scales) pixel values to a range of 0 - 255, which is typically for visualisation but the function can also be used for normalisation.\n"
 "\n"
 "Where:\n"
@@ -2151,7 +2658,10 @@ static PyMethodDef ImageUtilsMethods[] = {
 "        * imageutils.STRETCH_EXPONENTIAL - Exponential stretch between mean - 2*sd to mean + 2*sd. No parameter.\n"
 "        * imageutils.STRETCH_LOGARITHMIC - Logarithmic stretch between mean - 2*sd to mean + 2*sd. No parameter.\n"
 "        * imageutils.STRETCH_POWERLAW - Power law stretch between mean - 2*sd to mean + 2*sd. Parameter defines power.\n"
+"        * imageutils.STRETCH_HISTOGRAM - Histogram equalisation (8 and 16 bit integer images only). No parameter.\n"
 ":param stretchparam: is a float, providing the input parameter to the stretch (if required).\n"
+":param statssampling: is an int; the statistics for the linear stretches are calculated from every statssampling'th pixel and line (using an overview where available), which is faster for large images. The default of 1 uses all the pixels.\n"
+":param usepercentiles: is a bool; if True the STRETCH_LINEARPERCENT limits are the stretchparam and 100-stretchparam percentiles of each band rather than estimated from the mean, min and max (default False).\n"
 "\n"
 "Example::\n"
 "\n"
@@ -2165,7 +2675,7 @@ static PyMethodDef ImageUtilsMethods[] = {
 "\n"},
     
 {"stretchImageNoData", (PyCFunction)ImageUtils_StretchImageNoData, METH_VARARGS | METH_KEYWORDS,
-"rsgislib.imageutils.stretchImageNoData(inputimage, outputimage, saveoutstats, outstatsfile, nodataval, onepasssd, gdalformat, datatype, stretchtype, stretchparam)\n"
+"rsgislib.imageutils.stretchImageNoData(inputimage, outputimage, saveoutstats, outstatsfile, nodataval, onepasssd, gdalformat, datatype, stretchtype, stretchparam, statssampling, usepercentiles)\n"
 "Stretches (scales) pixel values to a range of 0 - 255, which is typically for visualisation but the function can also be used for normalisation.\n"
 "\n"
 "Where:\n"
@@ -2185,7 +2695,10 @@ static PyMethodDef ImageUtilsMethods[] = {
 "        * imageutils.STRETCH_EXPONENTIAL - Exponential stretch between mean - 2*sd to mean + 2*sd. No parameter.\n"
 "        * imageutils.STRETCH_LOGARITHMIC - Logarithmic stretch between mean - 2*sd to mean + 2*sd. No parameter.\n"
 "        * imageutils.STRETCH_POWERLAW - Power law stretch between mean - 2*sd to mean + 2*sd. Parameter defines power.\n"
+"        * imageutils.STRETCH_HISTOGRAM - Histogram equalisation (8 and 16 bit integer images only). No parameter.\n"
 ":param stretchparam: is a float, providing the input parameter to the stretch (if required).\n"
+":param statssampling: is an int; the statistics for the linear stretches are calculated from every statssampling'th pixel and line (using an overview where available), which is faster for large images. The default of 1 uses all the pixels.\n"
+":param usepercentiles: is a bool; if True the STRETCH_LINEARPERCENT limits are the stretchparam and 100-stretchparam percentiles of each band rather than estimated from the mean, min and max (default False).\n"
 "\n"
 "Example::\n"
 "\n"
@@ -2629,9 +3142,34 @@ static PyMethodDef ImageUtilsMethods[] = {
 "   rsgislib.imageutils.extractZoneImageBandValues2HDF(fileInfo, 'ClassMask.kea', 'ForestRefl.h5', 1.0)\n"
 "\n"},
 
+{"extractPointsImageBandValues2HDF", ImageUtils_ExtractPointsImageBandValues2HDF, METH_VARARGS,
+"rsgislib.imageutils.extractPointsImageBandValues2HDF(inputImageInfo, vectorFile, vectorLyr, outputHDF, datatype)\n"
+"Extract the pixel values at a set of points to a HDF5 file (1 row for each point and 1 column for each image band).\n"
+"The points are sorted by image block so each block is read only once, and the images are sampled in parallel\n"
+"using the number of threads specified by the RSGISLIB_NUM_THREADS environment variable. For geometries other\n"
+"than points the centre of the envelope is used and points outside any of the images are not exported.\n"
+"\n"
+"Where:\n"
+"\n"
+":param inputImageInfo: is a list of rsgislib::imageutils::ImageBandInfo objects with the file names and list of image bands within that file to be extracted.\n"
+":param vectorFile: is a string containing the name and path of the input vector file with the points.\n"
+":param vectorLyr: is a string containing the name of the vector layer.\n"
+":param outputHDF: is a string containing the name and path of the output HDF5 file\n"
+":param datatype: is a rsgislib.TYPE_* value providing the data type of the output image.\n"
+"\n"
+"Example::\n"
+"\n"
+"   import rsgislib.imageutils\n"
+"   fileInfo = []\n"
+"   fileInfo.append(rsgislib.imageutils.ImageBandInfo('InputImg1.kea', 'Image1', [1,3,4]))\n"
+"   fileInfo.append(rsgislib.imageutils.ImageBandInfo('InputImg2.kea', 'Image2', [2]))\n"
+"   rsgislib.imageutils.extractPointsImageBandValues2HDF(fileInfo, 'FieldPlots.gpkg', 'plots', 'PlotRefl.h5')\n"
+"\n"},
+
 {"randomSampleHDF5File", (PyCFunction)ImageUtils_RandomSampleHDF5File, METH_VARARGS | METH_KEYWORDS,
 "rsgislib.imageutils.randomSampleHDF5File(inputh5, outputh5, sample, seed, datatype)\n"
-"A function which randomly samples a HDF5 of extracted values.\n"
+"A function which randomly samples a HDF5 of extracted values. The rows are sampled without replacement and "
+"written in the order of the input file, which is read a block at a time so the memory used does not depend on its size.\n"
 "\n"
 "Where:\n"
 "\n"
@@ -2645,7 +3183,8 @@ static PyMethodDef ImageUtilsMethods[] = {
 
 {"splitSampleHDF5File", (PyCFunction)ImageUtils_SplitSampleHDF5File, METH_VARARGS | METH_KEYWORDS,
 "rsgislib.imageutils.splitSampleHDF5File(inputh5, outputp1h5, outputp2h5, sample, seed, datatype)\n"
-"A function which splits samples a HDF5 of extracted values.\n"
+"A function which splits samples a HDF5 of extracted values. The sampled rows (without replacement) are written to "
+"outputp1h5 and the remaining rows to outputp2h5, both in the order of the input file which is read a block at a time.\n"
 "\n"
 "Where:\n"
 "\n"
@@ -2929,14 +3468,18 @@ For example, can be used to produce monthly composite images from a stack with i
 "\n"},
 
 {"orderImageUsingValidPxls", ImageUtils_OrderImagesUsingPropValidData, METH_VARARGS,
-"rsgislib.imageutils.orderImageUsingValidPxls(inputImages, noDataVal)\n"
+"rsgislib.imageutils.orderImageUsingValidPxls(inputImages, noDataVal, exactCount=False)\n"
 "Order the list of input images based on the their proportion of valid image pixels.\n"
 "The primary use of this function is expected to be order (rank) images ahead of mosaicing.\n"
+"The images are processed in parallel (RSGISLIB_NUM_THREADS) and the proportion is taken from the\n"
+"cheapest source available: the statistics or histograms stored for the bands (where their no data\n"
+"value is noDataVal), an overview or a decimated read of the image.\n"
 "\n"
 "Where:\n"
 "\n"
 ":param inputImages: is a list of string containing the name and path for the input images.\n"
 ":param noDataVal: is a float which specifies the no data value used to defined \'invalid\' pixels.\n"
+":param exactCount: is a boolean specifying that every pixel is counted at full resolution rather than the proportion being estimated (Default: False).\n"
 "\n"
 ":return: a list of images ordered, from low to high (i.e., the first image will be the image with the smallest number of valid image pixels).\n"
 "\n"},
@@ -3075,6 +3618,36 @@ For example, can be used to produce monthly composite images from a stack with i
 "    rsgislib.imageutils.popImageStats('StackPanImgSharp.kea', usenodataval=True, nodataval=0, calcpyramids=True)\n"
 "\n"
 "\n"},
+
+{"panSharpenHCSFused", (PyCFunction)ImageUtils_PanSharpenHCSFused, METH_VARARGS | METH_KEYWORDS,
+"rsgislib.imageutils.panSharpenHCSFused(msimage=string, panimage=string, outimage=string, gdalformat=string, datatype=int, winsize=unsigned int, useNaiveMethod=boolean, statsdecimation=unsigned int)\n"
+"A function which performs a Hyperspherical Colour Space (HSC) Pan Sharpening straight from the multispectral\n"
+"and panchromatic images, without resampling and stacking them first (see panSharpenHCS). The multispectral\n"
+"bands are bilinearly resampled to the panchromatic grid as they are read, the statistics are calculated in a\n"
+"single pass and the sharpening is run on RSGISLIB_NUM_THREADS threads.\n"
+"Padwick, C., Deskevich, M., Pacifici, F., Smallwood, S. 2010. WorldView-2 Pan-Sharpening.\n"
+"ASPRS 2010 Annual Conference, San Diego, California (2010) pp. 26-30.\n"
+"\n"
+"Where:\n"
+"\n"
+":param msimage: is a string for the input multispectral image.\n"
+":param panimage: is a string for the input (single band) panchromatic image, which defines the output grid.\n"
+":param outimage: is a string with the name and path of the output image.\n"
+":param gdalformat: is a string with the GDAL output file format.\n"
+":param datatype: is an containing one of the values from rsgislib.TYPE_*\n"
+":param winsize: is an optional integer, which must be an odd number, specifying the window size used for the analysis (Default = 7; Only used if useNaiveMethod=False).\n"
+":param useNaiveMethod: is an optional boolean option to specify whether the naive or smart method should be used - False=Smart (Default), True=Naive Method.\n"
+":param statsdecimation: is an optional integer; the statistics are calculated from every nth row and column of the panchromatic image (Default = 1; all pixels).\n"
+"\n"
+"\nExample::\n"
+"\n"
+"    import rsgislib\n"
+"    import rsgislib.imageutils\n"
+"\n"
+"    rsgislib.imageutils.panSharpenHCSFused(msimage='./14SEP03025718-M2AS-054000253010_01_P001.TIF', panimage='./14SEP03025718-P2AS-054000253010_01_P001.TIF',\n"
+"                                           outimage='PanImgSharp.kea', gdalformat='KEA', datatype=rsgislib.TYPE_16UINT, statsdecimation=4)\n"
+"\n"
+"\n"},
     
 {"sharpenLowResBands", (PyCFunction)ImageUtils_SharpenLowResImageBands, METH_VARARGS | METH_KEYWORDS,
 "rsgislib.imageutils.sharpenLowResBands(inimage=string, outimage=string, bandinfo=list, winsize=unsigned int, nodata=int, gdalformat=string, datatype=int)\n"
@@ -3251,6 +3824,121 @@ For example, can be used to produce monthly composite images from a stack with i
 "\n"
 "\n"},
     
+{"setProfiling", (PyCFunction)ImageUtils_SetProfiling, METH_VARARGS | METH_KEYWORDS,
+"rsgislib.imageutils.setProfiling(enable=bool, printsummary=bool)\n"
+"Switches on (or off) the recording of the time spent reading, calculating and writing blocks \n"
+"(and the bytes and blocks/pixels processed) by the image calculation engine and other instrumented \n"
+"functions. Profiling can also be enabled with the RSGISLIB_PROFILE environment variable (1 to record, \n"
+"2 to also print summaries).\n"
+"\n"
+"Where:\n"
+"\n"
+":param enable: is a boolean to switch profiling on or off.\n"
+":param printsummary: is a boolean specifying whether a summary is printed at the end of each instrumented command (Default: False).\n"
+"\n"
+"Example::\n"
+"\n"
+"    import rsgislib.imageutils\n"
+"    rsgislib.imageutils.setProfiling(True)\n"
+"    rsgislib.imagecalc.imageMath('in.kea', 'out.kea', 'b1*2', 'KEA', rsgislib.TYPE_32FLOAT)\n"
+"    print(rsgislib.imageutils.getProfileCounters()['calcimage.read'])\n"
+"\n"},
+    
+{"getProfileCounters", (PyCFunction)ImageUtils_GetProfileCounters, METH_NOARGS,
+"rsgislib.imageutils.getProfileCounters()\n"
+"Returns the counters recorded while profiling is enabled as a dict keyed by counter name \n"
+"(e.g., 'calcimage.read', 'calcimage.compute', 'calcimage.write') where each value is a \n"
+"dict with 'calls', 'seconds', 'count' and 'bytes'.\n"
+"\n"
+":returns: a dict of the counters.\n"
+"\n"},
+    
+{"resetProfileCounters", (PyCFunction)ImageUtils_ResetProfileCounters, METH_NOARGS,
+"rsgislib.imageutils.resetProfileCounters()\n"
+"Resets the profiling counters to zero.\n"
+"\n"},
+    
+{"setProgressCallback", (PyCFunction)ImageUtils_SetProgressCallback, METH_VARARGS | METH_KEYWORDS,
+"rsgislib.imageutils.setProgressCallback(func)\n"
+"Sets a function which is given the progress of the parallel image processing engines (e.g., \n"
+"rsgislib.imagecalc.imageMath and the tiled mosaic functions) in place of watching the \n"
+"progress bar. It is called as func(label, done, total) at most every \n"
+"RSGISLIB_PROGRESS_INTERVAL_MS milliseconds (Default 250) from a separate thread, and only \n"
+"when the progress has changed. Errors raised by func are printed and otherwise ignored.\n"
+"\n"
+"Where:\n"
+"\n"
+":param func: is a callable taking (label, done, total) or None to remove the callback.\n"
+"\n"
+"Example::\n"
+"\n"
+"    import rsgislib.imageutils\n"
+"    def printProgress(label, done, total):\n"
+"        print('{}: {} of {}'.format(label, done, total))\n"
+"    rsgislib.imageutils.setProgressCallback(printProgress)\n"
+"\n"},
+    
+{"setDatasetCacheSize", (PyCFunction)ImageUtils_SetDatasetCacheSize, METH_VARARGS | METH_KEYWORDS,
+"rsgislib.imageutils.setDatasetCacheSize(maxdatasets=int)\n"
+"Keeps up to maxdatasets images open between calls so that a sequence of functions reading the \n"
+"same image (e.g., rsgislib.rastergis functions reading the attribute table of a KEA clumps file) \n"
+"do not re-open it and re-read its metadata and attribute table each time. Only images opened read \n"
+"only are kept; functions which update an image open it themselves. The cache is off by default (0); \n"
+"it can also be set with the RSGISLIB_DATASET_CACHE environment variable. Images are re-opened if the \n"
+"file has changed on disk, but if an image is re-created outside of RSGISLib (e.g., with the GDAL \n"
+"python bindings) call invalidateDatasetCache first as some formats (e.g., KEA) can not re-create \n"
+"an image which is open.\n"
+"\n"
+"Where:\n"
+"\n"
+":param maxdatasets: is an unsigned int with the maximum number of idle images to keep open (0 switches the cache off).\n"
+"\n"},
+    
+{"invalidateDatasetCache", (PyCFunction)ImageUtils_InvalidateDatasetCache, METH_VARARGS | METH_KEYWORDS,
+"rsgislib.imageutils.invalidateDatasetCache(inputimage=string)\n"
+"Closes the cached handle of an image so it is re-opened by the next function which uses it.\n"
+"\n"
+"Where:\n"
+"\n"
+":param inputimage: is a string with the image file, if not provided all cached images are closed.\n"
+"\n"},
+    
+{"createImageFootprintIndex", (PyCFunction)ImageUtils_CreateImageFootprintIndex, METH_VARARGS | METH_KEYWORDS,
+"rsgislib.imageutils.createImageFootprintIndex(inputimages, indexfile, ignorefailed=False, nthreads=1)\n"
+"Creates a spatial index of the bounding boxes of a set of images, so the images intersecting \n"
+"an area can be found (see queryImageFootprintIndex) without opening them. Only the image headers \n"
+"are read. The images must all have the same projection, which is also the projection of the \n"
+"queries.\n"
+"\n"
+"Where:\n"
+"\n"
+":param inputimages: is a list of image files.\n"
+":param indexfile: is a string with the output index file.\n"
+":param ignorefailed: is a bool specifying that images which cannot be opened or have no projection are left out (otherwise an exception is raised).\n"
+":param nthreads: is an unsigned int with the number of threads reading the image headers (0 uses all the cores).\n"
+"\n"
+"Example::\n"
+"\n"
+"   import glob\n"
+"   import rsgislib.imageutils\n"
+"   rsgislib.imageutils.createImageFootprintIndex(glob.glob('./Tiles/*.kea'), 'tiles_idx.fpi', nthreads=8)\n"
+"   imgs = rsgislib.imageutils.queryImageFootprintIndex('tiles_idx.fpi', bbox=(300000, 310000, 800000, 810000))\n"
+"\n"},
+    
+{"queryImageFootprintIndex", (PyCFunction)ImageUtils_QueryImageFootprintIndex, METH_VARARGS | METH_KEYWORDS,
+"rsgislib.imageutils.queryImageFootprintIndex(indexfile, bbox=None, point=None)\n"
+"Returns the list of images in a footprint index (see createImageFootprintIndex) which intersect \n"
+"the bbox or contain the point. The index is kept in memory after the first query so repeated \n"
+"queries are fast.\n"
+"\n"
+"Where:\n"
+"\n"
+":param indexfile: is a string with the index file.\n"
+":param bbox: is a tuple (xMin, xMax, yMin, yMax) in the projection of the images.\n"
+":param point: is a tuple (x, y) in the projection of the images (used if bbox is not provided).\n"
+":return: list of image files.\n"
+"\n"},
+    
 {NULL}        /* Sentinel */
 };
 
@@ -90,7 +90,10 @@ static PyObject *RasterGIS_PopulateStats(PyObject *self, PyObject *args, PyObjec
 
     try
     {
-        rsgis::cmds::executePopulateStats(std::string(clumpsImage), addColourTable2Img, calcImgPyramids, ignoreZeroVal, ratBand);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePopulateStats(std::string(clumpsImage), addColourTable2Img, calcImgPyramids, ignoreZeroVal, ratBand);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -112,7 +115,10 @@ static PyObject *RasterGIS_CopyRAT(PyObject *self, PyObject *args, PyObject *key
 
     try
     {
-        rsgis::cmds::executeCopyRAT(std::string(clumpsImage), std::string(inputImage),ratBand);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCopyRAT(std::string(clumpsImage), std::string(inputImage),ratBand);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -147,7 +153,10 @@ static PyObject *RasterGIS_CopyGDALATTColumns(PyObject *self, PyObject *args, Py
 
     try
     {
-        rsgis::cmds::executeCopyGDALATTColumns(std::string(inputImage), std::string(clumpsImage), fields, copyColours, copyHist, ratBand);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCopyGDALATTColumns(std::string(inputImage), std::string(clumpsImage), fields, copyColours, copyHist, ratBand);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -171,7 +180,10 @@ static PyObject *RasterGIS_SpatialLocation(PyObject *self, PyObject *args, PyObj
 
     try
     {
-        rsgis::cmds::executeSpatialLocation(std::string(inputImage), ratBand, std::string(eastingsField), std::string(northingsField));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeSpatialLocation(std::string(inputImage), ratBand, std::string(eastingsField), std::string(northingsField));
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -195,7 +207,10 @@ static PyObject *RasterGIS_SpatialExtent(PyObject *self, PyObject *args, PyObjec
     
     try
     {
-        rsgis::cmds::executeSpatialLocationExtent(std::string(inputImage), ratBand, std::string(minXXCol), std::string(minXYCol), std::string(maxXXCol), std::string(maxXYCol), std::string(minYXCol), std::string(minYYCol), std::string(maxYXCol), std::string(maxYYCol));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeSpatialLocationExtent(std::string(inputImage), ratBand, std::string(minXXCol), std::string(minXYCol), std::string(maxXXCol), std::string(maxXYCol), std::string(minYXCol), std::string(minYYCol), std::string(maxYXCol), std::string(maxYYCol));
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -305,7 +320,10 @@ static PyObject *RasterGIS_PopulateRATWithStats(PyObject *self, PyObject *args,
 
     try
     {
-        rsgis::cmds::executePopulateRATWithStats(std::string(inputImage), std::string(clumpsImage), &bandStatsCmds, ratBand);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePopulateRATWithStats(std::string(inputImage), std::string(clumpsImage), &bandStatsCmds, ratBand);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -401,7 +419,10 @@ static PyObject *RasterGIS_PopulateRATWithPercentiles(PyObject *self, PyObject *
 
     try
     {
-        rsgis::cmds::executePopulateRATWithPercentiles(std::string(inputImage), std::string(clumpsImage), band, &bandPercentilesCmds, ratBand, numHistBins);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePopulateRATWithPercentiles(std::string(inputImage), std::string(clumpsImage), band, &bandPercentilesCmds, ratBand, numHistBins);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -441,8 +462,11 @@ static PyObject *RasterGIS_PopulateCategoryProportions(PyObject *self, PyObject
 
     try
     {
-        rsgis::cmds::executePopulateCategoryProportions(std::string(categoriesImage), std::string(clumpsImage), std::string(outColsName), std::string(majorityColName),
-                                                        (copyClassNames != 0), std::string(majClassNameField), std::string(classNameField), ratBandClumps, ratBandCats);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePopulateCategoryProportions(std::string(categoriesImage), std::string(clumpsImage), std::string(outColsName), std::string(majorityColName),
+                                                            (copyClassNames != 0), std::string(majClassNameField), std::string(classNameField), ratBandClumps, ratBandCats);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -473,7 +497,10 @@ static PyObject *RasterGIS_PopulateRATWithMode(PyObject *self, PyObject *args, P
     {
         bool useNoDataBool = (bool) useNoDataVal;
         bool outNoDataBool = (bool) outNoDataVal;
-        rsgis::cmds::executePopulateRATWithMode(std::string(inputImage), std::string(clumpsImage), std::string(outColsName), useNoDataBool, noDataVal, outNoDataBool, modeBand, ratBand);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePopulateRATWithMode(std::string(inputImage), std::string(clumpsImage), std::string(outColsName), useNoDataBool, noDataVal, outNoDataBool, modeBand, ratBand);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -492,7 +519,10 @@ static PyObject *RasterGIS_CopyCategoriesColours(PyObject *self, PyObject *args)
         return NULL;
 
     try {
-        rsgis::cmds::executeCopyCategoriesColours(std::string(categoriesImage), std::string(clumpsImage), std::string(classField));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCopyCategoriesColours(std::string(categoriesImage), std::string(clumpsImage), std::string(classField));
+        }
     } catch (rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -518,7 +548,10 @@ static PyObject *RasterGIS_ExportCol2GDALImage(PyObject *self, PyObject *args, P
 
     try
     {
-        rsgis::cmds::executeExportCols2GDALImage(std::string(inputImage), std::string(outputFile), std::string(imageFormat), type, std::string(field), ratBand);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeExportCols2GDALImage(std::string(inputImage), std::string(outputFile), std::string(imageFormat), type, std::string(field), ratBand);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -550,7 +583,10 @@ static PyObject *RasterGIS_Export2Ascii(PyObject *self, PyObject *args, PyObject
     if(fields.size() == 0) { return NULL; }
     try
     {
-        rsgis::cmds::executeExport2Ascii(std::string(inputImage), std::string(outputFile), fields, ratBand);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeExport2Ascii(std::string(inputImage), std::string(outputFile), fields, ratBand);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -587,7 +623,10 @@ static PyObject *RasterGIS_ClassTranslate(PyObject *self, PyObject *args) {
     }
 
     try {
-        rsgis::cmds::executeClassTranslate(std::string(inputImage), std::string(classInField), std::string(classOutField), classPairs);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeClassTranslate(std::string(inputImage), std::string(classInField), std::string(classOutField), classPairs);
+        }
     } catch (rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -688,11 +727,17 @@ static PyObject *RasterGIS_ColourClasses(PyObject *self, PyObject *args, PyObjec
     {
         if(intKet)
         {
-            rsgis::cmds::executeColourClasses(std::string(inputImage), std::string(classInField), classPairsInt, ratBand);
+            {
+                RSGISPyReleaseGIL releaseGIL;
+                rsgis::cmds::executeColourClasses(std::string(inputImage), std::string(classInField), classPairsInt, ratBand);
+            }
         }
         else
         {
-            rsgis::cmds::executeColourStrClasses(std::string(inputImage), std::string(classInField), classPairsStr, ratBand);
+            {
+                RSGISPyReleaseGIL releaseGIL;
+                rsgis::cmds::executeColourStrClasses(std::string(inputImage), std::string(classInField), classPairsStr, ratBand);
+            }
         }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
@@ -714,7 +759,10 @@ static PyObject *RasterGIS_GenerateColourTable(PyObject *self, PyObject *args) {
 
 
     try {
-        rsgis::cmds::executeGenerateColourTable(std::string(inputImage), std::string(clumpsImage), redBand, greenBand, blueBand);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeGenerateColourTable(std::string(inputImage), std::string(clumpsImage), redBand, greenBand, blueBand);
+        }
     } catch (rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -740,7 +788,10 @@ static PyObject *RasterGIS_StrClassMajority(PyObject *self, PyObject *args, PyOb
 
     try
     {
-        rsgis::cmds::executeStrClassMajority(std::string(baseSegment), std::string(infoSegment), std::string(baseClassCol), std::string(infoClassCol), infoRatBand, baseRatBand, infoRatBand);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeStrClassMajority(std::string(baseSegment), std::string(infoSegment), std::string(baseClassCol), std::string(infoClassCol), infoRatBand, baseRatBand, infoRatBand);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -775,7 +826,10 @@ static PyObject *RasterGIS_SpecDistMajorityClassifier(PyObject *self, PyObject *
     rsgis::cmds::SpectralDistanceMethodCmds method = (rsgis::cmds::SpectralDistanceMethodCmds)distMethod;
 
     try {
-        rsgis::cmds::executeSpecDistMajorityClassifier(std::string(inputImage), std::string(inClassNameField), std::string(outClassNameField), std::string(trainingSelectCol), std::string(eastingsField), std::string(northingsField), std::string(areaField), std::string(majWeightField), fields, distThreshold, specDistThreshold, method, specThreshOriginDist);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeSpecDistMajorityClassifier(std::string(inputImage), std::string(inClassNameField), std::string(outClassNameField), std::string(trainingSelectCol), std::string(eastingsField), std::string(northingsField), std::string(areaField), std::string(majWeightField), fields, distThreshold, specDistThreshold, method, specThreshOriginDist);
+        }
     } catch (rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -806,8 +860,11 @@ static PyObject *RasterGIS_MaxLikelihoodClassifier(PyObject *self, PyObject *arg
     rsgis::cmds::rsgismlpriorscmds method = (rsgis::cmds::rsgismlpriorscmds)priorsMethod;
 
     try {
-        rsgis::cmds::executeMaxLikelihoodClassifier(std::string(inputImage), std::string(inClassNameField), std::string(outClassNameField), std::string(trainingSelectCol),
-            std::string(classifySelectCol), std::string(areaField), fields, method, priorStrs);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeMaxLikelihoodClassifier(std::string(inputImage), std::string(inClassNameField), std::string(outClassNameField), std::string(trainingSelectCol),
+                std::string(classifySelectCol), std::string(areaField), fields, method, priorStrs);
+        }
     } catch (rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -842,8 +899,11 @@ static PyObject *RasterGIS_MaxLikelihoodClassifierLocalPriors(PyObject *self, Py
     bool forceChangeInClassification = (iforceChangeInClassification != 0);
 
     try {
-        rsgis::cmds::executeMaxLikelihoodClassifierLocalPriors(std::string(inputImage), std::string(inClassNameField), std::string(outClassNameField), std::string(trainingSelectCol),
-            std::string(classifySelectCol), std::string(areaField), fields, std::string(eastingsField), std::string(northingsField), distThreshold, method, weightA, allowZeroPriors, forceChangeInClassification);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeMaxLikelihoodClassifierLocalPriors(std::string(inputImage), std::string(inClassNameField), std::string(outClassNameField), std::string(trainingSelectCol),
+                std::string(classifySelectCol), std::string(areaField), fields, std::string(eastingsField), std::string(northingsField), distThreshold, method, weightA, allowZeroPriors, forceChangeInClassification);
+        }
     } catch (rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -864,7 +924,10 @@ static PyObject *RasterGIS_ClassMask(PyObject *self, PyObject *args) {
     rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType) dataType;
 
     try {
-        rsgis::cmds::executeClassMask(std::string(inputImage), std::string(classField), std::string(className), std::string(outputFile), std::string(imageFormat), type);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeClassMask(std::string(inputImage), std::string(classField), std::string(className), std::string(outputFile), std::string(imageFormat), type);
+        }
     } catch (rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -886,7 +949,10 @@ static PyObject *RasterGIS_FindNeighbours(PyObject *self, PyObject *args)
 
     try
     {
-        rsgis::cmds::executeFindNeighbours(std::string(inputImage), ratBand);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeFindNeighbours(std::string(inputImage), ratBand);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -910,7 +976,10 @@ static PyObject *RasterGIS_FindBoundaryPixels(PyObject *self, PyObject *args)
 
     try
     {
-        rsgis::cmds::executeFindBoundaryPixels(std::string(inputImage), ratBand, std::string(outputFile), std::string(imageFormat));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeFindBoundaryPixels(std::string(inputImage), ratBand, std::string(outputFile), std::string(imageFormat));
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -933,7 +1002,38 @@ static PyObject *RasterGIS_CalcBorderLength(PyObject *self, PyObject *args)
 
     try
     {
-        rsgis::cmds::executeCalcBorderLength(std::string(inputImage), (iIgnoreZeroEdges != 0), std::string(outColsName));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCalcBorderLength(std::string(inputImage), (iIgnoreZeroEdges != 0), std::string(outColsName));
+        }
+    }
+    catch (rsgis::cmds::RSGISCmdException &e)
+    {
+        PyErr_SetString(GETSTATE(self)->error, e.what());
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *RasterGIS_CalcClumpGeometry(PyObject *self, PyObject *args, PyObject *keywds)
+{
+    const char *inputImage;
+    unsigned int ratBand = 1;
+    int iIgnoreZeroEdges = 0;
+    static char *kwlist[] = {"clumps", "ratband", "ignorezeroedges", NULL};
+
+    if(!PyArg_ParseTupleAndKeywords(args, keywds, "s|Ii:calcClumpGeometry", kwlist, &inputImage, &ratBand, &iIgnoreZeroEdges))
+    {
+        return NULL;
+    }
+
+    try
+    {
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCalcClumpGeometry(std::string(inputImage), ratBand, (iIgnoreZeroEdges != 0));
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -956,7 +1056,10 @@ static PyObject *RasterGIS_CalcRelBorder(PyObject *self, PyObject *args)
 
     try
     {
-        rsgis::cmds::executeCalcRelBorder(std::string(inputImage), std::string(outColsName), std::string(classNameField), std::string(className), (iIgnoreZeroEdges != 0));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCalcRelBorder(std::string(inputImage), std::string(outColsName), std::string(classNameField), std::string(className), (iIgnoreZeroEdges != 0));
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -1031,7 +1134,10 @@ static PyObject *RasterGIS_CalcShapeIndices(PyObject *self, PyObject *args) {
     }
 
     try {
-        rsgis::cmds::executeCalcShapeIndices(std::string(inputImage), shapeIndexes);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCalcShapeIndices(std::string(inputImage), shapeIndexes);
+        }
     } catch (rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -1050,7 +1156,10 @@ static PyObject *RasterGIS_DefineClumpTilePositions(PyObject *self, PyObject *ar
     }
 
     try {
-        rsgis::cmds::executeDefineClumpTilePositions(std::string(clumpsImage), std::string(tileImage), std::string(outColsName), tileOverlap, tileBoundary, tileBody);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeDefineClumpTilePositions(std::string(clumpsImage), std::string(tileImage), std::string(outColsName), tileOverlap, tileBoundary, tileBody);
+        }
     } catch (rsgis::cmds::RSGISCmdException &e) {
         PyErr_SetString(GETSTATE(self)->error, e.what());
         return NULL;
@@ -1069,7 +1178,10 @@ static PyObject *RasterGIS_DefineBorderClumps(PyObject *self, PyObject *args) {
 
     try
     {
-        rsgis::cmds::executeDefineBorderClumps(std::string(clumpsImage), std::string(outColsName));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeDefineBorderClumps(std::string(clumpsImage), std::string(outColsName));
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -1155,7 +1267,10 @@ static PyObject *RasterGIS_FindChangeClumpsFromStdDev(PyObject *self, PyObject *
 
     try
     {
-        rsgis::cmds::executeFindChangeClumpsFromStdDev(std::string(clumpsImage), std::string(classField), std::string(changeField), attFields, classFields, ratBand);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeFindChangeClumpsFromStdDev(std::string(clumpsImage), std::string(classField), std::string(changeField), attFields, classFields, ratBand);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -1222,7 +1337,10 @@ static PyObject *RasterGIS_GetGlobalClassStats(PyObject *self, PyObject *args, P
 
     try
     {
-        rsgis::cmds::executeGetGlobalClassStats(std::string(clumpsImage), std::string(classField), attFields, classFields, ratBand);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeGetGlobalClassStats(std::string(clumpsImage), std::string(classField), attFields, classFields, ratBand);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -1245,7 +1363,10 @@ static PyObject *RasterGIS_SelectClumpsOnGrid(PyObject *self, PyObject *args)
 
     try
     {
-        rsgis::cmds::executeIdentifyClumpExtremesOnGrid(std::string(clumpsImage), std::string(inSelectField), std::string(outSelectField), std::string(eastingsCol), std::string(northingsCol), std::string(methodStr), rows, cols, std::string(metricField));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeIdentifyClumpExtremesOnGrid(std::string(clumpsImage), std::string(inSelectField), std::string(outSelectField), std::string(eastingsCol), std::string(northingsCol), std::string(methodStr), rows, cols, std::string(metricField));
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -1270,7 +1391,10 @@ static PyObject *RasterGIS_InterpolateClumpValues2Img(PyObject *self, PyObject *
     try
     {
         rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType) dataType;
-        rsgis::cmds::executeInterpolateClumpValuesToImage(std::string(clumpsImage), std::string(selectField), std::string(eastingsField), std::string(northingsField), std::string(methodStr), std::string(valueField), std::string(outputFile), std::string(imageFormat), type, ratBand);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeInterpolateClumpValuesToImage(std::string(clumpsImage), std::string(selectField), std::string(eastingsField), std::string(northingsField), std::string(methodStr), std::string(valueField), std::string(outputFile), std::string(imageFormat), type, ratBand);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -1361,7 +1485,10 @@ static PyObject *RasterGIS_CalcRelDiffNeighbourStats(PyObject *self, PyObject *a
     
     try
     {
-        rsgis::cmds::executeCalcRelDiffNeighbourStats(std::string(clumpsImage), cmdObj, (useAbsDiff != 0), ratBand);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCalcRelDiffNeighbourStats(std::string(clumpsImage), cmdObj, (useAbsDiff != 0), ratBand);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -1384,7 +1511,10 @@ static PyObject *RasterGIS_BinaryClassification(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeBinaryClassify(std::string(clumpsImage), ratBand, std::string(xmlBlock), std::string(outColumn));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeBinaryClassify(std::string(clumpsImage), ratBand, std::string(xmlBlock), std::string(outColumn));
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -1408,7 +1538,10 @@ static PyObject *RasterGIS_RegionGrowClass(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeClassRegionGrowing(std::string(clumpsImage), ratBand, std::string(classColumn), std::string(classVal), maxNumIter, std::string(xmlBlock));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeClassRegionGrowing(std::string(clumpsImage), ratBand, std::string(classColumn), std::string(classVal), maxNumIter, std::string(xmlBlock));
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -1439,7 +1572,11 @@ static PyObject *RasterGIS_FindGlobalSegmentationScore(PyObject *self, PyObject
 
         std::vector<rsgis::cmds::RSGISJXSegQualityScoreBandCmds> *scoreBandComps = new std::vector<rsgis::cmds::RSGISJXSegQualityScoreBandCmds>();
 
-        float segScore = rsgis::cmds::executeFindGlobalSegmentationScore4Clumps(std::string(clumpsImage), std::string(inputImage), std::string(colPrefix), calcNeighbours, minNormV, maxNormV, minNormMI, maxNormMI, scoreBandComps);
+        float segScore = 0;
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            segScore = rsgis::cmds::executeFindGlobalSegmentationScore4Clumps(std::string(clumpsImage), std::string(inputImage), std::string(colPrefix), calcNeighbours, minNormV, maxNormV, minNormMI, maxNormMI, scoreBandComps);
+        }
 
         Py_ssize_t listLen = scoreBandComps->size() * 4;
         scoreCompsList = PyList_New(listLen);
@@ -1576,7 +1713,10 @@ static PyObject *RasterGIS_PopulateRATWithMeanLitStats(PyObject *self, PyObject
     
     try
     {
-        rsgis::cmds::executePopulateRATWithMeanLitStats(std::string(inputImage), std::string(clumpsImage), std::string(meanLitImage), meanlitBand, std::string(meanLitCol), std::string(pxlCountCol), &bandStatsCmds, ratBand);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePopulateRATWithMeanLitStats(std::string(inputImage), std::string(clumpsImage), std::string(meanLitImage), meanlitBand, std::string(meanLitCol), std::string(pxlCountCol), &bandStatsCmds, ratBand);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -1610,7 +1750,10 @@ static PyObject *RasterGIS_CollapseRAT(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeCollapseRAT(std::string(clumpsImage), ratBand, std::string(selectField), std::string(outputFile), std::string(imageFormat));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCollapseRAT(std::string(clumpsImage), ratBand, std::string(selectField), std::string(outputFile), std::string(imageFormat));
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -1653,7 +1796,10 @@ static PyObject *RasterGIS_ImportVecAtts(PyObject *self, PyObject *args, PyObjec
             }
         }
         
-        rsgis::cmds::executeImportShpAtts(std::string(clumpsImage), ratBand, std::string(vectorFile), std::string(vectorLyrName), std::string(fidColName), colNames);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeImportShpAtts(std::string(clumpsImage), ratBand, std::string(vectorFile), std::string(vectorLyrName), std::string(fidColName), colNames);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -1677,7 +1823,10 @@ static PyObject *RasterGIS_RegionGrowClassNeighCritera(PyObject *self, PyObject
     
     try
     {
-        rsgis::cmds::executeClassRegionGrowingNeighCritera(std::string(clumpsImage), ratBand, std::string(classColumn), std::string(classVal), maxNumIter, std::string(xmlBlockGrowCriteria), std::string(xmlBlockNeighCriteria));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeClassRegionGrowingNeighCritera(std::string(clumpsImage), ratBand, std::string(classColumn), std::string(classVal), maxNumIter, std::string(xmlBlockGrowCriteria), std::string(xmlBlockNeighCriteria));
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -1735,7 +1884,10 @@ static PyObject *RasterGIS_ApplyKNN(PyObject *self, PyObject *args, PyObject *ke
         rsgis::cmds::rsgisKNNDistCmd distKNN = static_cast<rsgis::cmds::rsgisKNNDistCmd>(distKNNInt);
         rsgis::cmds::rsgisKNNSummeriseCmd summeriseKNN = static_cast<rsgis::cmds::rsgisKNNSummeriseCmd>(summeriseKNNInt);
         
-        rsgis::cmds::executeApplyKNN(std::string(inClumpsImage), ratBand, std::string(inExtrapField), std::string(outExtrapField), std::string(trainRegionsField), applyRegionsField, applyRegions, fields, kFeatures, distKNN, distThreshold, summeriseKNN);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeApplyKNN(std::string(inClumpsImage), ratBand, std::string(inExtrapField), std::string(outExtrapField), std::string(trainRegionsField), applyRegionsField, applyRegions, fields, kFeatures, distKNN, distThreshold, summeriseKNN);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -1774,7 +1926,10 @@ static PyObject *RasterGIS_HistoSampling(PyObject *self, PyObject *args, PyObjec
     
     try
     {
-        rsgis::cmds::executeHistSampling(std::string(inClumpsImage), ratBand, std::string(varCol), std::string(outSelectCol), propOfSample, binWidth, classRestrict, classColumn, std::string(classVal));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeHistSampling(std::string(inClumpsImage), ratBand, std::string(varCol), std::string(outSelectCol), propOfSample, binWidth, classRestrict, classColumn, std::string(classVal));
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -1814,7 +1969,10 @@ static PyObject *RasterGIS_FitHistGausianMixtureModel(PyObject *self, PyObject *
     
     try
     {
-        rsgis::cmds::executeFitHistGausianMixtureModel(std::string(inClumpsImage), ratBand, std::string(outH5File), std::string(varCol), binWidth, std::string(classColumn), std::string(classVal), outputHist, outHistFile);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeFitHistGausianMixtureModel(std::string(inClumpsImage), ratBand, std::string(outH5File), std::string(varCol), binWidth, std::string(classColumn), std::string(classVal), outputHist, outHistFile);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -1845,7 +2003,10 @@ static PyObject *RasterGIS_ClassSplitFitHistGausianMixtureModel(PyObject *self,
     
     try
     {
-        rsgis::cmds::executeClassSplitFitHistGausianMixtureModel(std::string(inClumpsImage), ratBand, std::string(outColumn), std::string(varCol), binWidth, std::string(classColumn), std::string(classVal));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeClassSplitFitHistGausianMixtureModel(std::string(inClumpsImage), ratBand, std::string(outColumn), std::string(varCol), binWidth, std::string(classColumn), std::string(classVal));
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -1871,7 +2032,10 @@ static PyObject *RasterGIS_PopulateRATWithPropValidPxls(PyObject *self, PyObject
     
     try
     {
-        rsgis::cmds::executeCalcPropOfValidPixelsInClump(std::string(inputImage), std::string(clumpsImage), ratBand, std::string(outColsName), noDataVal);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCalcPropOfValidPixelsInClump(std::string(inputImage), std::string(clumpsImage), ratBand, std::string(outColsName), noDataVal);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -1899,7 +2063,11 @@ static PyObject *RasterGIS_Calc1DJMDistance(PyObject *self, PyObject *args, PyOb
     PyObject *outVal = PyTuple_New(1);
     try
     {
-        double dist = rsgis::cmds::executeCalc1DJMDistance(std::string(clumpsImage), std::string(varCol), binWidth, std::string(classCol), std::string(class1Val), std::string(class2Val), ratBand);
+        double dist = 0;
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            dist = rsgis::cmds::executeCalc1DJMDistance(std::string(clumpsImage), std::string(varCol), binWidth, std::string(classCol), std::string(class1Val), std::string(class2Val), ratBand);
+        }
         
         if(PyTuple_SetItem(outVal, 0, Py_BuildValue("d", dist)) == -1)
         {
@@ -1932,7 +2100,11 @@ static PyObject *RasterGIS_Calc2DJMDistance(PyObject *self, PyObject *args, PyOb
     PyObject *outVal = PyTuple_New(1);
     try
     {
-        double dist = rsgis::cmds::executeCalc2DJMDistance(std::string(clumpsImage), std::string(var1Col), std::string(var2Col), var1BinWidth, var2BinWidth, std::string(classCol), std::string(class1Val), std::string(class2Val), ratBand);
+        double dist = 0;
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            dist = rsgis::cmds::executeCalc2DJMDistance(std::string(clumpsImage), std::string(var1Col), std::string(var2Col), var1BinWidth, var2BinWidth, std::string(classCol), std::string(class1Val), std::string(class2Val), ratBand);
+        }
         
         if(PyTuple_SetItem(outVal, 0, Py_BuildValue("d", dist)) == -1)
         {
@@ -1963,7 +2135,11 @@ static PyObject *RasterGIS_CalcBhattacharyyaDistance(PyObject *self, PyObject *a
     PyObject *outVal = PyTuple_New(1);
     try
     {
-        double dist = rsgis::cmds::executeCalcBhattacharyyaDistance(std::string(clumpsImage), std::string(varCol), std::string(classCol), std::string(class1Val), std::string(class2Val), ratBand);
+        double dist = 0;
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            dist = rsgis::cmds::executeCalcBhattacharyyaDistance(std::string(clumpsImage), std::string(varCol), std::string(classCol), std::string(class1Val), std::string(class2Val), ratBand);
+        }
         
         if(PyTuple_SetItem(outVal, 0, Py_BuildValue("d", dist)) == -1)
         {
@@ -1994,7 +2170,10 @@ static PyObject *RasterGIS_ExportClumps2Images(PyObject *self, PyObject *args, P
     
     try
     {
-        rsgis::cmds::executeExportClumps2Images(std::string(inputImage), std::string(outputBaseName), std::string(outFileExt), std::string(imageFormat), (bool)binaryOut, ratBand);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeExportClumps2Images(std::string(inputImage), std::string(outputBaseName), std::string(outFileExt), std::string(imageFormat), (bool)binaryOut, ratBand);
+        }
     }
     catch (rsgis::cmds::RSGISCmdException &e)
     {
@@ -2005,6 +2184,177 @@ static PyObject *RasterGIS_ExportClumps2Images(PyObject *self, PyObject *args, P
     Py_RETURN_NONE;
 }
 
+static PyObject *RasterGIS_GetRATColumnInfo(PyObject *self, PyObject *args, PyObject *keywds)
+{
+    const char *clumpsImage, *column;
+    unsigned int ratBand = 1;
+    
+    static char *kwlist[] = {"clumps", "column", "ratband", NULL};
+    
+    if(!PyArg_ParseTupleAndKeywords(args, keywds, "ss|I:getRATColumnInfo", kwlist, &clumpsImage, &column, &ratBand))
+    {
+        return NULL;
+    }
+    
+    size_t nRows = 0;
+    bool isInt = false;
+    try
+    {
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeGetRATColumnInfo(std::string(clumpsImage), std::string(column), &nRows, &isInt, ratBand);
+        }
+    }
+    catch (rsgis::cmds::RSGISCmdException &e)
+    {
+        PyErr_SetString(GETSTATE(self)->error, e.what());
+        return NULL;
+    }
+    
+    return Py_BuildValue("nO", (Py_ssize_t)nRows, isInt?Py_True:Py_False);
+}
+
+// Gets a C contiguous buffer of float64 or int32 values for a RAT column. Returns
+// false, with the Python error set, if the object does not provide one.
+static bool RasterGIS_GetColumnBuffer(PyObject *self, PyObject *pBufferObj, bool writable, Py_buffer *view, bool *isInt)
+{
+    int flags = PyBUF_FORMAT | PyBUF_C_CONTIGUOUS;
+    if(writable)
+    {
+        flags = flags | PyBUF_WRITABLE;
+    }
+    if(PyObject_GetBuffer(pBufferObj, view, flags) != 0)
+    {
+        return false;
+    }
+    // Skip the native byte order / alignment prefix.
+    const char *format = (view->format == NULL)?"B":view->format;
+    if((format[0] == '@') || (format[0] == '='))
+    {
+        ++format;
+    }
+    std::string formatStr = std::string(format);
+    if(((formatStr == "d") && (view->itemsize == sizeof(double))))
+    {
+        *isInt = false;
+    }
+    else if(((formatStr == "i") || (formatStr == "l")) && (view->itemsize == sizeof(int)))
+    {
+        *isInt = true;
+    }
+    else
+    {
+        PyBuffer_Release(view);
+        PyErr_SetString(GETSTATE(self)->error, "The buffer must contain float64 or int32 values.");
+        return false;
+    }
+    return true;
+}
+
+static PyObject *RasterGIS_ReadRATColumnToBuffer(PyObject *self, PyObject *args, PyObject *keywds)
+{
+    const char *clumpsImage, *column;
+    PyObject *pBufferObj;
+    Py_ssize_t startRow = 0;
+    unsigned int ratBand = 1;
+    
+    static char *kwlist[] = {"clumps", "column", "buffer", "startrow", "ratband", NULL};
+    
+    if(!PyArg_ParseTupleAndKeywords(args, keywds, "ssO|nI:readRATColumnToBuffer", kwlist, &clumpsImage, &column, &pBufferObj, &startRow, &ratBand))
+    {
+        return NULL;
+    }
+    if(startRow < 0)
+    {
+        PyErr_SetString(GETSTATE(self)->error, "startrow must not be negative.");
+        return NULL;
+    }
+    
+    Py_buffer view;
+    bool isInt = false;
+    if(!RasterGIS_GetColumnBuffer(self, pBufferObj, true, &view, &isInt))
+    {
+        return NULL;
+    }
+    
+    size_t nRows = view.len / view.itemsize;
+    try
+    {
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            if(isInt)
+            {
+                rsgis::cmds::executeReadRATColumn(std::string(clumpsImage), std::string(column), startRow, nRows, (int*)view.buf, ratBand);
+            }
+            else
+            {
+                rsgis::cmds::executeReadRATColumn(std::string(clumpsImage), std::string(column), startRow, nRows, (double*)view.buf, ratBand);
+            }
+        }
+    }
+    catch (rsgis::cmds::RSGISCmdException &e)
+    {
+        PyBuffer_Release(&view);
+        PyErr_SetString(GETSTATE(self)->error, e.what());
+        return NULL;
+    }
+    PyBuffer_Release(&view);
+    
+    Py_RETURN_NONE;
+}
+
+static PyObject *RasterGIS_WriteRATColumnFromBuffer(PyObject *self, PyObject *args, PyObject *keywds)
+{
+    const char *clumpsImage, *column;
+    PyObject *pBufferObj;
+    Py_ssize_t startRow = 0;
+    unsigned int ratBand = 1;
+    
+    static char *kwlist[] = {"clumps", "column", "buffer", "startrow", "ratband", NULL};
+    
+    if(!PyArg_ParseTupleAndKeywords(args, keywds, "ssO|nI:writeRATColumnFromBuffer", kwlist, &clumpsImage, &column, &pBufferObj, &startRow, &ratBand))
+    {
+        return NULL;
+    }
+    if(startRow < 0)
+    {
+        PyErr_SetString(GETSTATE(self)->error, "startrow must not be negative.");
+        return NULL;
+    }
+    
+    Py_buffer view;
+    bool isInt = false;
+    if(!RasterGIS_GetColumnBuffer(self, pBufferObj, false, &view, &isInt))
+    {
+        return NULL;
+    }
+    
+    size_t nRows = view.len / view.itemsize;
+    try
+    {
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            if(isInt)
+            {
+                rsgis::cmds::executeWriteRATColumn(std::string(clumpsImage), std::string(column), startRow, nRows, (int*)view.buf, ratBand);
+            }
+            else
+            {
+                rsgis::cmds::executeWriteRATColumn(std::string(clumpsImage), std::string(column), startRow, nRows, (double*)view.buf, ratBand);
+            }
+        }
+    }
+    catch (rsgis::cmds::RSGISCmdException &e)
+    {
+        PyBuffer_Release(&view);
+        PyErr_SetString(GETSTATE(self)->error, e.what());
+        return NULL;
+    }
+    PyBuffer_Release(&view);
+    
+    Py_RETURN_NONE;
+}
+
 
 static PyMethodDef RasterGISMethods[] = {
     {"populateStats", (PyCFunction)RasterGIS_PopulateStats, METH_VARARGS | METH_KEYWORDS,
@@ -2452,6 +2802,28 @@ static PyMethodDef RasterGISMethods[] = {
 ":param inputImage: is a string containing the name of the input image file\n"
 ":param ignoreZeroEdges: is a bool\n"
 ":param outColsName: is a string\n"
+"\n"},
+
+    {"calcClumpGeometry", (PyCFunction)RasterGIS_CalcClumpGeometry, METH_VARARGS | METH_KEYWORDS,
+"rastergis.calcClumpGeometry(clumps=string, ratband=int, ignorezeroedges=bool)\n"
+"Calculates the geometry of the clumps in a single pass over the image (using RSGISLIB_NUM_THREADS threads)\n"
+"and writes the columns PxlCount, Eastings, Northings (centroid), MinXPxl, MaxXPxl, MinYPxl, MaxYPxl (pixel extent),\n"
+"MinXX, MinXY, MaxXX, MaxXY, MinYX, MinYY, MaxYX, MaxYY (as spatialExtent), Perimeter (in pixel edges),\n"
+"BorderLength (as calcBorderLength), MajorAxisLen, MinorAxisLen (in pixels), Orientation (degrees clockwise\n"
+"from the x axis), Eccentricity, Compactness (4 pi area / perimeter^2), ContourLength (through the centres of\n"
+"the edge pixels, as a chain code), BoundaryPxls, Circularity (4 pi area / contour length^2), Elongation\n"
+"(1 - minor / major axis) and Rectangularity (proportion of the bounding box in the clump).\n"
+"\n"
+"Where:\n"
+"\n"
+":param clumps: is a string containing the name of the input clumps image file\n"
+":param ratband: is an integer containing the band number for the RAT (Optional, default = 1)\n"
+":param ignorezeroedges: is a bool specifying that edges with no data (0) or the image edge are not included in the border length (Optional, default = False)\n"
+"\n"
+"Example::\n"
+"\n"
+"   from rsgislib import rastergis\n"
+"   rastergis.calcClumpGeometry('injune_p142_casi_sub_utm_segs.kea', ignorezeroedges=True)\n"
 "\n"},
 
     {"calcRelBorder", RasterGIS_CalcRelBorder, METH_VARARGS,
@@ -2608,7 +2980,7 @@ static PyMethodDef RasterGISMethods[] = {
 ":param selectField: is a string which defines the column name where a value of 1 defines the clumps which will be included in the analysis.\n"
 ":param eastingsField: is a string which defines a column with a eastings for each clump.\n"
 ":param northingsField: is a string which defines a column with a northings for each clump.\n"
-":param methodStr: is a string which defines a column with a value for each clump which will be used for the distance, nearestneighbour or naturalneighbour or naturalnearestneighbour or knearestneighbour or idwall anaylsis.\n"
+":param methodStr: is a string which defines a column with a value for each clump which will be used for the distance, nearestneighbour or naturalneighbour or naturalnearestneighbour or knearestneighbour or idwall or idwknn (inverse distance weighting using the 12 nearest clumps) anaylsis.\n"
 ":param valueField: is a string which defines a column containing the values to be interpolated creating the new image.\n"
 ":param outputFile: is a string for the path to the output image file.\n"
 ":param gdalformat: is string defining the GDAL format of the output image.\n"
@@ -3037,6 +3409,48 @@ static PyMethodDef RasterGISMethods[] = {
 "   gdalformat = 'KEA'\n"
 "   binaryOut = False\n"
 "   rastergis.exportClumps2Images(clumps, outimgbase, binaryOut, outimgext, gdalformat, ratband)\n"
+"\n"},
+    
+    {"getRATColumnInfo", (PyCFunction)RasterGIS_GetRATColumnInfo, METH_VARARGS | METH_KEYWORDS,
+"rastergis.getRATColumnInfo(clumps=string, column=string, ratband=int)\n"
+"Gets the number of rows in the RAT and whether a column is an integer column.\n"
+"\n"
+"Where:\n"
+"\n"
+":param clumps: is a string containing the name of the input clump file\n"
+":param column: is a string containing the name of the column\n"
+":param ratband: is an optional (default = 1) integer parameter specifying the image band to which the RAT is associated.\n"
+"\n"
+":return: a tuple (number of rows, True if the column is an integer column)\n"
+"\n"},
+
+    {"readRATColumnToBuffer", (PyCFunction)RasterGIS_ReadRATColumnToBuffer, METH_VARARGS | METH_KEYWORDS,
+"rastergis.readRATColumnToBuffer(clumps=string, column=string, buffer=object, startrow=int, ratband=int)\n"
+"Reads rows of a RAT column straight into a writable buffer (e.g., a numpy array) without an intermediate copy.\n"
+"The number of rows read is the length of the buffer, see rastergis.readRATColumn.\n"
+"\n"
+"Where:\n"
+"\n"
+":param clumps: is a string containing the name of the input clump file\n"
+":param column: is a string containing the name of the column\n"
+":param buffer: is a C contiguous buffer of float64 or int32 values (e.g., a numpy array)\n"
+":param startrow: is the first row to be read (Optional, default = 0)\n"
+":param ratband: is an optional (default = 1) integer parameter specifying the image band to which the RAT is associated.\n"
+"\n"},
+
+    {"writeRATColumnFromBuffer", (PyCFunction)RasterGIS_WriteRATColumnFromBuffer, METH_VARARGS | METH_KEYWORDS,
+"rastergis.writeRATColumnFromBuffer(clumps=string, column=string, buffer=object, startrow=int, ratband=int)\n"
+"Writes rows of a RAT column straight from a buffer (e.g., a numpy array) without an intermediate copy.\n"
+"The column is created (as a real column for float64 or an integer column for int32 values) if it does not\n"
+"exist and the RAT is extended if required, see rastergis.writeRATColumn.\n"
+"\n"
+"Where:\n"
+"\n"
+":param clumps: is a string containing the name of the input clump file\n"
+":param column: is a string containing the name of the column\n"
+":param buffer: is a C contiguous buffer of float64 or int32 values (e.g., a numpy array)\n"
+":param startrow: is the first row to be written (Optional, default = 0)\n"
+":param ratband: is an optional (default = 1) integer parameter specifying the image band to which the RAT is associated.\n"
 "\n"},
     
     {NULL}        /* Sentinel */
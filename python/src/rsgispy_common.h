@@ -29,6 +29,7 @@
 #include <string.h>
 
 #include "common/RSGISCommons.h"
+#include "common/RSGISProgressCounter.h"
 
 // hides differences between Python2 and 3. 
 // PyString for Python2 - PyUnicode for Python3
@@ -111,4 +112,27 @@ inline double RSGISPY_FLOAT_EXTRACT(PyObject *o)
 #endif
 }
 
+// releases the GIL for the lifetime of the object so other Python threads can
+// run while long running C++ code executes. Nothing within the scope may touch
+// Python objects. The GIL is re-acquired even if an exception is thrown.
+class RSGISPyReleaseGIL
+{
+public:
+    RSGISPyReleaseGIL()
+    {
+        m_pThreadState = PyEval_SaveThread();
+        // progress callbacks into Python can only be made while the GIL is released
+        rsgis::RSGISProgressCounter::beginCallbackScope();
+    }
+    ~RSGISPyReleaseGIL()
+    {
+        rsgis::RSGISProgressCounter::endCallbackScope();
+        PyEval_RestoreThread(m_pThreadState);
+    }
+private:
+    RSGISPyReleaseGIL(const RSGISPyReleaseGIL&);
+    RSGISPyReleaseGIL& operator=(const RSGISPyReleaseGIL&);
+    PyThreadState *m_pThreadState;
+};
+
 #endif // RSGISPY_COMMON_H
@@ -48,8 +48,11 @@ static PyObject *Segmentation_labelPixelsFromClusterCentres(PyObject *self, PyOb
 
     try
     {
-        rsgis::cmds::executeLabelPixelsFromClusterCentres(pszInputImage, pszOutputImage, pszClusterCentres,
-                        ignoreZeros, pszgdalformat );
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeLabelPixelsFromClusterCentres(pszInputImage, pszOutputImage, pszClusterCentres,
+                            ignoreZeros, pszgdalformat );
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -73,7 +76,10 @@ static PyObject *Segmentation_eliminateSinglePixels(PyObject *self, PyObject *ar
 
     try
     {
-        rsgis::cmds::executeEliminateSinglePixels(pszInputImage, pszClumpsImage, pszOutputImage, pszTempImage, pszgdalformat, processInMemory, ignoreZeros);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeEliminateSinglePixels(pszInputImage, pszClumpsImage, pszOutputImage, pszTempImage, pszgdalformat, processInMemory, ignoreZeros);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -92,8 +98,9 @@ static PyObject *Segmentation_clump(PyObject *self, PyObject *args)
     bool nodataprovided;
     float fnodata;
     int addRatPxlVals = false;
+    unsigned int numThreads = 1;
     PyObject *pNoData = Py_None; //could be none or a number
-    if( !PyArg_ParseTuple(args, "sss|iOi:clump", &pszInputImage, &pszOutputImage, &pszgdalformat, &processInMemory, &pNoData, &addRatPxlVals))
+    if( !PyArg_ParseTuple(args, "sss|iOiI:clump", &pszInputImage, &pszOutputImage, &pszgdalformat, &processInMemory, &pNoData, &addRatPxlVals, &numThreads))
         return NULL;
     
     if( pNoData == Py_None )
@@ -118,8 +125,11 @@ static PyObject *Segmentation_clump(PyObject *self, PyObject *args)
 
     try
     {
-        rsgis::cmds::executeClump(pszInputImage, pszOutputImage, pszgdalformat,
-                                processInMemory, nodataprovided, fnodata, addRatPxlVals);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeClump(pszInputImage, pszOutputImage, pszgdalformat,
+                                    processInMemory, nodataprovided, fnodata, addRatPxlVals, numThreads);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -131,20 +141,71 @@ static PyObject *Segmentation_clump(PyObject *self, PyObject *args)
 }
 
 
+static PyObject *Segmentation_spectralGroupClump(PyObject *self, PyObject *args)
+{
+    const char *pszInputImage, *pszOutputImage, *pszgdalformat;
+    float specThreshold;
+    bool nodataprovided;
+    float fnodata;
+    unsigned int numThreads = 1;
+    PyObject *pNoData = Py_None; //could be none or a number
+    if( !PyArg_ParseTuple(args, "sssf|OI:spectralGroupClump", &pszInputImage, &pszOutputImage, &pszgdalformat, &specThreshold, &pNoData, &numThreads))
+        return NULL;
+    
+    if( pNoData == Py_None )
+    {
+        nodataprovided = false;
+        fnodata = 0;
+    }
+    else
+    {
+        // convert to a float if needed
+        PyObject *pFloatNoData = PyNumber_Float(pNoData);
+        if( pFloatNoData == NULL )
+        {
+            PyErr_SetString(GETSTATE(self)->error, "nodata parameter must be None or a valid number\n");
+            return NULL;
+        }
+
+        nodataprovided = true;
+        fnodata = PyFloat_AsDouble(pFloatNoData);
+        Py_DECREF(pFloatNoData);
+    }
+
+    try
+    {
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeSpectralGroupClumps(pszInputImage, pszOutputImage, pszgdalformat, specThreshold, nodataprovided, fnodata, numThreads);
+        }
+    }
+    catch(rsgis::cmds::RSGISCmdException &e)
+    {
+        PyErr_SetString(GETSTATE(self)->error, e.what());
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
 static PyObject *Segmentation_RMSmallClumpsStepwise(PyObject *self, PyObject *args)
 {
     const char *pszInputImage, *pszClumpsImage, *pszOutputImage, *pszgdalformat, *pszStretchStatsFile;
     int storeMean,processInMemory,stretchStatsAvail;
     unsigned int minClumpSize;
     float specThreshold;                   
-    if( !PyArg_ParseTuple(args, "ssssisiiIf:rmSmallClumpsStepwise", &pszInputImage, &pszClumpsImage, &pszOutputImage, &pszgdalformat,
-                    &stretchStatsAvail, &pszStretchStatsFile, &storeMean, &processInMemory, &minClumpSize, &specThreshold))            
+    int usePriorityQueue = false;
+    if( !PyArg_ParseTuple(args, "ssssisiiIf|i:rmSmallClumpsStepwise", &pszInputImage, &pszClumpsImage, &pszOutputImage, &pszgdalformat,
+                    &stretchStatsAvail, &pszStretchStatsFile, &storeMean, &processInMemory, &minClumpSize, &specThreshold, &usePriorityQueue))            
         return NULL;
     
     try
     {
-        rsgis::cmds::executeRMSmallClumpsStepwise(pszInputImage, pszClumpsImage, pszOutputImage, pszgdalformat,
-                                stretchStatsAvail, pszStretchStatsFile, storeMean, processInMemory, minClumpSize, specThreshold);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeRMSmallClumpsStepwise(pszInputImage, pszClumpsImage, pszOutputImage, pszgdalformat,
+                                    stretchStatsAvail, pszStretchStatsFile, storeMean, processInMemory, minClumpSize, specThreshold, usePriorityQueue);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -166,8 +227,11 @@ static PyObject *Segmentation_relabelClumps(PyObject *self, PyObject *args)
 
     try
     {
-        rsgis::cmds::executeRelabelClumps(pszInputImage, pszOutputImage,
-                    pszgdalformat, processInMemory);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeRelabelClumps(pszInputImage, pszOutputImage,
+                        pszgdalformat, processInMemory);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -240,7 +304,10 @@ static PyObject *Segmentation_unionOfClumps(PyObject *self, PyObject *args)
     try
     {
                         
-        rsgis::cmds::executeUnionOfClumps(inputImagePaths, pszOutputImage, pszgdalformat, nodataprovided, fnodata, addRatPxlVals);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeUnionOfClumps(inputImagePaths, pszOutputImage, pszgdalformat, nodataprovided, fnodata, addRatPxlVals);
+        }
 
     }
     catch(rsgis::cmds::RSGISCmdException &e)
@@ -291,8 +358,11 @@ static PyObject *Segmentation_mergeSegmentationTiles(PyObject *self, PyObject *a
     try
     {
                         
-        rsgis::cmds::executeMergeSegmentationTiles(pszOutputImage, pszBorderMaskImage, inputImagePaths,
-                        tileBoundary, tileOverlap, tileBody, pszColsName);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeMergeSegmentationTiles(pszOutputImage, pszBorderMaskImage, inputImagePaths,
+                            tileBoundary, tileOverlap, tileBody, pszColsName);
+        }
 
     }
     catch(rsgis::cmds::RSGISCmdException &e)
@@ -339,7 +409,10 @@ static PyObject *Segmentation_mergeClumpImages(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeMergeClumpImages(inputImagePaths, pszOutputImage, mergeRATs);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeMergeClumpImages(inputImagePaths, pszOutputImage, mergeRATs);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -389,8 +462,11 @@ static PyObject *Segmentation_findTileBordersMask(PyObject *self, PyObject *args
     try
     {
                         
-        rsgis::cmds::executeFindTileBordersMask(inputImagePaths, pszBorderMaskImage,
-                        tileBoundary, tileOverlap, tileBody, pszColsName);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeFindTileBordersMask(inputImagePaths, pszBorderMaskImage,
+                            tileBoundary, tileOverlap, tileBody, pszColsName);
+        }
 
     }
     catch(rsgis::cmds::RSGISCmdException &e)
@@ -412,7 +488,10 @@ static PyObject *Segmentation_rmSmallClumps(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeRMSmallClumps(pszInputClumps, pszOutputClumps, areaThreshold, pszgdalformat);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeRMSmallClumps(pszInputClumps, pszOutputClumps, areaThreshold, pszgdalformat);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -434,7 +513,55 @@ static PyObject *Segmentation_meanImage(PyObject *self, PyObject *args)
     try
     {
         rsgis::RSGISLibDataType type = (rsgis::RSGISLibDataType)nDataType;
-        rsgis::cmds::executeMeanImage(pszInputImage, pszInputClumps, pszOutputImage, pszgdalformat, type, false);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeMeanImage(pszInputImage, pszInputClumps, pszOutputImage, pszgdalformat, type, false);
+        }
+    }
+    catch(rsgis::cmds::RSGISCmdException &e)
+    {
+        PyErr_SetString(GETSTATE(self)->error, e.what());
+        return NULL;
+    }
+    
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *Segmentation_clumpMeans2RAT(PyObject *self, PyObject *args)
+{
+    const char *pszInputImage, *pszInputClumps;
+    PyObject *colNamesObj;
+    if( !PyArg_ParseTuple(args, "ssO:clumpMeans2RAT", &pszInputImage, &pszInputClumps, &colNamesObj))
+    {
+        return NULL;
+    }
+    
+    Py_ssize_t nCols = PyList_Size(colNamesObj);
+    if( nCols < 0)
+    {
+        PyErr_SetString(GETSTATE(self)->error, "last argument must be a list");
+        return NULL;
+    }
+    
+    std::vector<std::string> colNames;
+    for(Py_ssize_t n = 0; n < nCols; n++)
+    {
+        PyObject *strObj = PyList_GetItem(colNamesObj, n);
+        if( !RSGISPY_CHECK_STRING(strObj) )
+        {
+            PyErr_SetString(GETSTATE(self)->error, "must pass a list of strings");
+            return NULL;
+        }
+        colNames.push_back(RSGISPY_STRING_EXTRACT(strObj));
+    }
+    
+    try
+    {
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeClumpMeans2RAT(std::string(pszInputImage), std::string(pszInputClumps), colNames);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -458,7 +585,10 @@ static PyObject *Segmentation_GenerateRegularGrid(PyObject *self, PyObject *args
     
     try
     {
-        rsgis::cmds::executeGenerateRegularGrid(std::string(pszInputImage), std::string(pszOutputImage), std::string(pszgdalformat), numXPxls, numYPxls, (bool)offset);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeGenerateRegularGrid(std::string(pszInputImage), std::string(pszOutputImage), std::string(pszgdalformat), numXPxls, numYPxls, (bool)offset);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -481,7 +611,10 @@ static PyObject *Segmentation_IncludeRegionsInClumps(PyObject *self, PyObject *a
     
     try
     {
-        rsgis::cmds::executeIncludeClumpedRegion(std::string(pszClumpsImage), std::string(pszRegionsImage), std::string(pszOutputImage), std::string(pszgdalformat));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeIncludeClumpedRegion(std::string(pszClumpsImage), std::string(pszRegionsImage), std::string(pszOutputImage), std::string(pszgdalformat));
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -502,7 +635,102 @@ static PyObject *Segmentation_mergeSegments2Neighbours(PyObject *self, PyObject
     
     try
     {
-        rsgis::cmds::executeMergeSelectClumps2Neighbour(std::string(pszInputSpecImage), std::string(pszInputClumpsImage), std::string(pszOutputImage), std::string(pszgdalformat), std::string(selectClumpsCol), std::string(noDataClumpsCol));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeMergeSelectClumps2Neighbour(std::string(pszInputSpecImage), std::string(pszInputClumpsImage), std::string(pszOutputImage), std::string(pszgdalformat), std::string(selectClumpsCol), std::string(noDataClumpsCol));
+        }
+    }
+    catch(rsgis::cmds::RSGISCmdException &e)
+    {
+        PyErr_SetString(GETSTATE(self)->error, e.what());
+        return NULL;
+    }
+    
+    Py_RETURN_NONE;
+}
+
+static PyObject *Segmentation_hierarchicalSegmentation(PyObject *self, PyObject *args)
+{
+    const char *pszInputImage, *pszInputClumps, *pszgdalformat;
+    PyObject *outImgsObj, *minPxlsObj, *distThresObj;
+    if( !PyArg_ParseTuple(args, "ssOOOs:hierarchicalSegmentation", &pszInputImage, &pszInputClumps, &outImgsObj, &minPxlsObj, &distThresObj, &pszgdalformat))
+    {
+        return NULL;
+    }
+    
+    Py_ssize_t nOutImgs = PyList_Size(outImgsObj);
+    if((nOutImgs < 0) || (PyList_Size(minPxlsObj) != nOutImgs) || (PyList_Size(distThresObj) != nOutImgs))
+    {
+        PyErr_SetString(GETSTATE(self)->error, "outputClumps, minPxls and distThres must be lists of the same length");
+        return NULL;
+    }
+    
+    std::vector<std::string> outputImages;
+    std::vector<unsigned int> minPxls;
+    std::vector<float> distThresholds;
+    for(Py_ssize_t n = 0; n < nOutImgs; n++)
+    {
+        PyObject *strObj = PyList_GetItem(outImgsObj, n);
+        if( !RSGISPY_CHECK_STRING(strObj) )
+        {
+            PyErr_SetString(GETSTATE(self)->error, "outputClumps must be a list of strings");
+            return NULL;
+        }
+        outputImages.push_back(RSGISPY_STRING_EXTRACT(strObj));
+        
+        PyObject *minPxlsItem = PyList_GetItem(minPxlsObj, n);
+        if( !RSGISPY_CHECK_INT(minPxlsItem) )
+        {
+            PyErr_SetString(GETSTATE(self)->error, "minPxls must be a list of integers");
+            return NULL;
+        }
+        minPxls.push_back(RSGISPY_UINT_EXTRACT(minPxlsItem));
+        
+        PyObject *distItem = PyList_GetItem(distThresObj, n);
+        double distVal = RSGISPY_FLOAT_EXTRACT(distItem);
+        if(PyErr_Occurred())
+        {
+            PyErr_SetString(GETSTATE(self)->error, "distThres must be a list of numbers");
+            return NULL;
+        }
+        distThresholds.push_back(distVal);
+    }
+    
+    try
+    {
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeHierarchicalSegmentation(std::string(pszInputImage), std::string(pszInputClumps), outputImages, minPxls, distThresholds, std::string(pszgdalformat));
+        }
+    }
+    catch(rsgis::cmds::RSGISCmdException &e)
+    {
+        PyErr_SetString(GETSTATE(self)->error, e.what());
+        return NULL;
+    }
+    
+    Py_RETURN_NONE;
+}
+
+static PyObject *Segmentation_tiledSegmentation(PyObject *self, PyObject *args)
+{
+    const char *pszInputImage, *pszClusterCentres, *pszOutputClumps, *pszOutputBorders, *pszgdalformat;
+    unsigned int tileWidth = 2000;
+    unsigned int tileHeight = 2000;
+    unsigned int minPxls = 100;
+    float distThres = 100;
+    unsigned int nThreads = 0;
+    if( !PyArg_ParseTuple(args, "sssss|IIIfI:tiledSegmentation", &pszInputImage, &pszClusterCentres, &pszOutputClumps, &pszOutputBorders, &pszgdalformat, &tileWidth, &tileHeight, &minPxls, &distThres, &nThreads))
+    {
+        return NULL;
+    }
+    
+    try
+    {
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeTiledSegmentation(std::string(pszInputImage), std::string(pszClusterCentres), std::string(pszOutputClumps), std::string(pszOutputBorders), std::string(pszgdalformat), tileWidth, tileHeight, minPxls, distThres, nThreads);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -523,7 +751,10 @@ static PyObject *Segmentation_dropSelectedSegments(PyObject *self, PyObject *arg
     
     try
     {
-        rsgis::cmds::executeDropSelectedClumps(std::string(pszInputClumpsImage), std::string(pszOutputImage), std::string(pszgdalformat), std::string(selectClumpsCol));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeDropSelectedClumps(std::string(pszInputClumpsImage), std::string(pszOutputImage), std::string(pszgdalformat), std::string(selectClumpsCol));
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -566,7 +797,10 @@ static PyObject *Segmentation_mergeEquivalentClumps(PyObject *self, PyObject *ar
     
     try
     {
-        rsgis::cmds::executeMergeClumpsEquivalentVal(std::string(pszInputClumpsImage), std::string(pszOutputImage), std::string(pszgdalformat), cols);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeMergeClumpsEquivalentVal(std::string(pszInputClumpsImage), std::string(pszOutputImage), std::string(pszgdalformat), cols);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -636,7 +870,10 @@ static PyObject *Segmentation_PxlGrowRegions(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executePxlGrowRegions(std::string(pszInputClumpsImage), std::string(pszValsImage), std::string(pszOutputImage), std::string(pszgdalformat), std::string(pszMuParseCriteria), varNameBandPairs);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePxlGrowRegions(std::string(pszInputClumpsImage), std::string(pszValsImage), std::string(pszOutputImage), std::string(pszgdalformat), std::string(pszMuParseCriteria), varNameBandPairs);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -673,14 +910,14 @@ static PyMethodDef SegmentationMethods[] = {
 ":param inputimage: is a string containing the name of the input file\n"
 ":param clumpsimage: is a string containing the name of the clump file\n"
 ":param outputimage: is a string containing the name of the output file\n"
-":param tempfile: is a string containing the name of the temporary file to use\n"
+":param tempfile: is a string containing the name of the temporary file to use; the temporary data are held in memory, or in an unnamed scratch file within the directory of tempfile where too large (see RSGISLIB_SCRATCH_MEM_MB)\n"
 ":param gdalformat: is a string containing the GDAL format for the output file - eg 'KEA'\n"
 ":param processinmemory: is a bool specifying if processing should be carried out in memory (faster if sufficient RAM is available, set to False if unsure).\n"
 ":param ignorezeros: is a bool\n"
 "\n"},
 
     {"clump", Segmentation_clump, METH_VARARGS,
-"segmentation.clump(inputimage, outputimage, gdalformat, processinmemory, nodata, addPxlVal2Rat)\n"
+"segmentation.clump(inputimage, outputimage, gdalformat, processinmemory, nodata, addPxlVal2Rat, nthreads)\n"
 "A function which clumps an input image (of int pixel data type) to identify connected independent sets of pixels.\n"
 "\n"
 "Where:\n"
@@ -691,10 +928,26 @@ static PyMethodDef SegmentationMethods[] = {
 ":param processinmemory: is a bool specifying if processing should be carried out in memory (faster if sufficient RAM is available, set to False if unsure).\n"
 ":param nodata: is None or float\n"
 ":param addPxlVal2Rat: is a boolean specifying whether the pixel value (from inputimage) should be added as a RAT.\n"
+":param nthreads: is the number of threads used to clump the image as tiles in memory (default 1; 0 uses all cores). The result is the same as with a single thread but the labels for the whole image are held in memory.\n"
+"\n"},
+
+    {"spectralGroupClump", Segmentation_spectralGroupClump, METH_VARARGS,
+"segmentation.spectralGroupClump(inputimage, outputimage, gdalformat, specthreshold, nodata=None, nthreads=1)\n"
+"A function which groups neighbouring pixels into clumps, where each pixel is within specthreshold\n"
+"(Euclidean distance over all the bands) of the seed pixel of its clump.\n"
+"\n"
+"Where:\n"
+"\n"
+":param inputimage: is a string containing the name of the input (spectral) file\n"
+":param outputimage: is a string containing the name of the output clumps file\n"
+":param gdalformat: is a string containing the GDAL format for the output file - eg 'KEA'\n"
+":param specthreshold: is a float with the maximum spectral distance of a pixel from the seed of its clump.\n"
+":param nodata: is None or float\n"
+":param nthreads: is the number of threads (default 1; 0 uses all cores). With more than one thread the image is grouped as strips of rows in memory and the groups on either side of a seam are joined where they are within the threshold, so the clumps can differ from those of a single thread near the seams.\n"
 "\n"},
 
     {"rmSmallClumpsStepwise", Segmentation_RMSmallClumpsStepwise, METH_VARARGS,
-"segmentation.rmSmallClumpsStepwise(inputimage, clumpsimage, outputimage, gdalformat, stretchstatsavail, stretchstatsfile, storemean, processinmemory, minclumpsize, specThreshold)\n"
+"segmentation.rmSmallClumpsStepwise(inputimage, clumpsimage, outputimage, gdalformat, stretchstatsavail, stretchstatsfile, storemean, processinmemory, minclumpsize, specThreshold, usepriorityqueue)\n"
 "eliminate clumps smaller than a given size from the scene, small clumps will be combined with their spectrally closest neighbouring  clump in a stepwise fashion unless over spectral distance threshold\n"
 "\n"
 "Where:\n"
@@ -709,6 +962,7 @@ static PyMethodDef SegmentationMethods[] = {
 ":param processinmemory: is a bool specifying if processing should be carried out in memory (faster if sufficient RAM is available, set to False if unsure).\n"
 ":param minclumpsize: is an unsigned integer providing the minimum size for clumps.\n"
 ":param specThreshold: is a float providing the maximum (Euclidian distance) spectral separation for which to merge clumps. Set to a large value to ignore spectral separation and always merge.\n"
+":param usepriorityqueue: is an optional bool (default False). If True (and storemean is True) the small clumps are merged smallest first from a priority queue, updating the clump neighbours and means after each merge, so the images are read once at the start and the output written once at the end.\n"
 "\n"},
 
     {"relabelClumps", Segmentation_relabelClumps, METH_VARARGS,
@@ -801,6 +1055,17 @@ static PyMethodDef SegmentationMethods[] = {
 ":param outputImage: is a string containing the name of the output image.\n"
 ":param gdalformat: is a string defining the format of the output image.\n"
 ":param datatype: is an containing one of the values from rsgislib.TYPE_*\n"
+"\n"},
+
+    {"clumpMeans2RAT", Segmentation_clumpMeans2RAT, METH_VARARGS,
+"segmentation.clumpMeans2RAT(inputImage, inputClumps, colNames)\n"
+"A function to write the mean value of each band of an image for each clump to columns of the clumps RAT. The image is read once.\n"
+"\n"
+"Where:\n"
+"\n"
+":param inputImage: is a string containing the name of the input image file from which the mean is taken.\n"
+":param inputClumps: is a string containing the name of the input clumps file, the RAT of which is updated.\n"
+":param colNames: is a list of column names, one for each band of the input image.\n"
 "\n"},
 
 {"generateRegularGrid", Segmentation_GenerateRegularGrid, METH_VARARGS,
@@ -856,6 +1121,52 @@ static PyMethodDef SegmentationMethods[] = {
 ":param selectClumpsCol: is a string defining the binary column for defining the segments to be merged (1 == selected clumps).\n"
 "\n"},
     
+{"hierarchicalSegmentation", Segmentation_hierarchicalSegmentation, METH_VARARGS,
+"segmentation.hierarchicalSegmentation(inputImage, clumpsImage, outputClumps, minPxls, distThres, gdalformat)\n"
+"A function to produce segmentations at several scales from one merge tree of an initial clumps image (e.g., the clumps of the k-means labels within the Shepherd segmentation), "
+"reading the spectral image and merging only once. At each scale the regions with fewer than minPxls pixels are merged with their spectrally closest neighbour where the distance is less than distThres.\n"
+"\n"
+"Where:\n"
+"\n"
+":param inputImage: is a string containing the filepath for the input image used to define 'distance'.\n"
+":param clumpsImage: is a string containing the filepath for the initial clumps image.\n"
+":param outputClumps: is a list of the output clumps images, one for each scale.\n"
+":param minPxls: is a list of the minimum clump sizes (in pixels), one for each scale.\n"
+":param distThres: is a list of the spectral distance thresholds, one for each scale.\n"
+":param gdalformat: is a string defining the format of the output images.\n"
+"\n"
+"Example::\n"
+"\n"
+"    from rsgislib import segmentation\n"
+"    segmentation.hierarchicalSegmentation('stretched.kea', 'initClumps.kea', ['segs_50.kea', 'segs_100.kea'], [50, 100], [100, 100], 'KEA')\n"
+"\n"},
+    
+{"tiledSegmentation", Segmentation_tiledSegmentation, METH_VARARGS,
+"segmentation.tiledSegmentation(inputImage, clusterCentres, outputClumps, outputBorders, gdalformat, tileWidth=2000, tileHeight=2000, minPxls=100, distThres=100, nThreads=0)\n"
+"A function to segment an image as a grid of tiles, with the tiles segmented in parallel in memory using the steps of the Shepherd segmentation "
+"(label the pixels from the k-means cluster centres, eliminate single pixels, clump and eliminate the small clumps). The clumps of each tile are "
+"written to the output image, numbered on from the previous tiles, and the clumps touching the edge of another tile are written to the border mask, "
+"so no tile images are written to disk. The outputs are those of the first stage of the tiled segmentation, ready for the border clumps to be re-segmented.\n"
+"\n"
+"Where:\n"
+"\n"
+":param inputImage: is a string containing the filepath for the input image (e.g., the stretched image used to calculate the cluster centres).\n"
+":param clusterCentres: is a string containing the filepath for the k-means cluster centres of the whole image (as for labelPixelsFromClusterCentres).\n"
+":param outputClumps: is a string containing the filepath for the output clumps image.\n"
+":param outputBorders: is a string containing the filepath for the output mask of the tile border clumps ('' to not output the mask).\n"
+":param gdalformat: is a string defining the format of the output images.\n"
+":param tileWidth: is the width of the tiles in pixels (a remainder less than half a tile is added to the last tile).\n"
+":param tileHeight: is the height of the tiles in pixels.\n"
+":param minPxls: is the minimum clump size (in pixels).\n"
+":param distThres: is the spectral distance threshold for merging small clumps.\n"
+":param nThreads: is the number of tiles segmented at once (0 uses the number of cores).\n"
+"\n"
+"Example::\n"
+"\n"
+"    from rsgislib import segmentation\n"
+"    segmentation.tiledSegmentation('stretched.kea', 'kcentres.gmtxt', 'clumps.kea', 'borders.kea', 'KEA', 2000, 2000, 100, 100)\n"
+"\n"},
+    
 {"mergeEquivClumps", Segmentation_mergeEquivalentClumps, METH_VARARGS,
 "segmentation.mergeEquivClumps(clumpsImage, outputClumps, gdalformat, valClumpsCols)\n"
 "A function to merge neighbouring clumps which have the same value - for example when merging across tile boundaries.\n"
@@ -71,8 +71,11 @@ static PyObject *VectorUtils_GenerateConvexHullsGroups(PyObject *self, PyObject
 
     try
     {
-        rsgis::cmds::executeGenerateConvexHullsGroups(pszInputFile, pszOutputVector, pszOutVecProj, force, 
-                eastingsColIdx, northingsColIdx, attributeColIdx);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeGenerateConvexHullsGroups(pszInputFile, pszOutputVector, pszOutVecProj, force, 
+                    eastingsColIdx, northingsColIdx, attributeColIdx);
+        }
      
     }
     catch(rsgis::cmds::RSGISCmdException &e)
@@ -93,7 +96,10 @@ static PyObject *VectorUtils_RemoveAttributes(PyObject *self, PyObject *args)
 
     try
     {
-        rsgis::cmds::executeRemoveAttributes(pszInputVector, pszOutputVector, force);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeRemoveAttributes(pszInputVector, pszOutputVector, force);
+        }
      
     }
     catch(rsgis::cmds::RSGISCmdException &e)
@@ -113,7 +119,10 @@ static PyObject *VectorUtils_PrintPolyGeom(PyObject *self, PyObject *args)
 
     try
     {
-        rsgis::cmds::executePrintPolyGeom(pszInputVector);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePrintPolyGeom(pszInputVector);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -135,7 +144,10 @@ static PyObject *VectorUtils_BufferVector(PyObject *self, PyObject *args)
 
     try
     {
-        rsgis::cmds::executeBufferVector(std::string(pszInputVector), std::string(pszVectorLyrName), std::string(pszOutputVector), std::string(pszVectorOutLyrName), std::string(pszDriver), bufferDist);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeBufferVector(std::string(pszInputVector), std::string(pszVectorLyrName), std::string(pszOutputVector), std::string(pszVectorOutLyrName), std::string(pszDriver), bufferDist);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -154,7 +166,10 @@ static PyObject *VectorUtils_FindReplaceText(PyObject *self, PyObject *args)
 
     try
     {
-        rsgis::cmds::executeFindReplaceText(pszInputVector, pszAttribute, pszFind, pszReplace);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeFindReplaceText(pszInputVector, pszAttribute, pszFind, pszReplace);
+        }
      
     }
     catch(rsgis::cmds::RSGISCmdException &e)
@@ -175,7 +190,10 @@ static PyObject *VectorUtils_CalcArea(PyObject *self, PyObject *args)
 
     try
     {
-        rsgis::cmds::executeCalcPolyArea(pszInputVector, pszOutputVector, force);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCalcPolyArea(pszInputVector, pszOutputVector, force);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -195,7 +213,10 @@ static PyObject *VectorUtils_PolygonsInPolygon(PyObject *self, PyObject *args)
 
     try
     {
-        rsgis::cmds::executePolygonsInPolygon(pszInputVector, pszInputCoverVector, pszOutputDIR, pszAttributeName, force);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePolygonsInPolygon(pszInputVector, pszInputCoverVector, pszOutputDIR, pszAttributeName, force);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -216,7 +237,10 @@ static PyObject *VectorUtils_PopulateGeomZField(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executePopulateGeomZField(pszInputVector, pszInputImage, imgBand, pszOutputVector, force);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePopulateGeomZField(pszInputVector, pszInputImage, imgBand, pszOutputVector, force);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -284,7 +308,10 @@ static PyObject *VectorUtils_VectorMaths(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeVectorMaths(std::string(pszInputVector), std::string(pszOutputVector), std::string(pszOutColName), std::string(pszExpression), force, vars);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeVectorMaths(std::string(pszInputVector), std::string(pszOutputVector), std::string(pszOutColName), std::string(pszExpression), force, vars);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -307,7 +334,10 @@ static PyObject *VectorUtils_AddFIDColumn(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeAddFIDColumn(std::string(pszInputVector), std::string(pszOutputVector), force);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeAddFIDColumn(std::string(pszInputVector), std::string(pszOutputVector), force);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -339,7 +369,10 @@ static PyObject *VectorUtils_FindCommonImgExtent(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeFindCommonImgExtent(inputImages, std::string(pszOutputVector), force);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeFindCommonImgExtent(inputImages, std::string(pszOutputVector), force);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -362,7 +395,10 @@ static PyObject *VectorUtils_SplitFeatures(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeSplitFeatures(std::string(pszInputVector), std::string(pszOutputVectorBase), ((bool)force));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeSplitFeatures(std::string(pszInputVector), std::string(pszOutputVectorBase), ((bool)force));
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -386,7 +422,10 @@ static PyObject *VectorUtils_ExportPxls2Pts(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeExportPxls2Pts(pszInputImg, pszOutputVector, force, maskVal);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeExportPxls2Pts(pszInputImg, pszOutputVector, force, maskVal);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -414,7 +453,11 @@ static PyObject *VectorUtils_Dist2NearestGeom(PyObject *self, PyObject *args)
     {
         bool force = (bool) forceInt;
         bool useIdx = (bool) useIdxInt;
-        double dist = rsgis::cmds::executeCalcDist2NearestGeom(std::string(pszInputVector), std::string(pszOutputVector), std::string(pszOutColName), force, useIdx, maxSearchDist);
+        double dist = 0;
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            dist = rsgis::cmds::executeCalcDist2NearestGeom(std::string(pszInputVector), std::string(pszOutputVector), std::string(pszOutColName), force, useIdx, maxSearchDist);
+        }
         if(PyTuple_SetItem(outVal, 0, Py_BuildValue("d", dist)) == -1)
         {
             throw rsgis::cmds::RSGISCmdException("Failed to add \'distance\' value to the list...");
@@ -446,7 +489,11 @@ static PyObject *VectorUtils_Dist2NearestSecGeomSet(PyObject *self, PyObject *ar
     {
         bool force = (bool) forceInt;
         bool useIdx = (bool) useIdxInt;
-        double dist = rsgis::cmds::executeCalcDist2NearestGeom(std::string(pszInputVector), std::string(pszInDistToVector), std::string(pszOutputVector), std::string(pszOutColName), force, useIdx, maxSearchDist);
+        double dist = 0;
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            dist = rsgis::cmds::executeCalcDist2NearestGeom(std::string(pszInputVector), std::string(pszInDistToVector), std::string(pszOutputVector), std::string(pszOutColName), force, useIdx, maxSearchDist);
+        }
         if(PyTuple_SetItem(outVal, 0, Py_BuildValue("d", dist)) == -1)
         {
             throw rsgis::cmds::RSGISCmdException("Failed to add \'distance\' value to the list...");
@@ -473,7 +520,11 @@ static PyObject *VectorUtils_CalcMaxDist2NearestGeom(PyObject *self, PyObject *a
     PyObject *outVal = PyTuple_New(1);
     try
     {
-        double dist = rsgis::cmds::executeCalcMaxDist2NearestGeom(std::string(pszInputVector));
+        double dist = 0;
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            dist = rsgis::cmds::executeCalcMaxDist2NearestGeom(std::string(pszInputVector));
+        }
         if(PyTuple_SetItem(outVal, 0, Py_BuildValue("d", dist)) == -1)
         {
             throw rsgis::cmds::RSGISCmdException("Failed to add \'distance\' value to the list...");
@@ -532,7 +583,10 @@ static PyObject *VectorUtils_SpatialGraphClusterGeoms(PyObject *self, PyObject *
     
     try
     {
-        rsgis::cmds::executeSpatialGraphClusterGeoms(std::string(pszInputVector), std::string(pszOutputVector), useMinSpanTree, sdEdgeLen, maxEdgeLen, force, shpFileEdges, outShpEdges, h5EdgeLengths, outH5EdgeLens);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeSpatialGraphClusterGeoms(std::string(pszInputVector), std::string(pszOutputVector), useMinSpanTree, sdEdgeLen, maxEdgeLen, force, shpFileEdges, outShpEdges, h5EdgeLengths, outH5EdgeLens);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -558,7 +612,10 @@ static PyObject *VectorUtils_FitPolygon2Points(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeFitPolygonToPoints(std::string(pszInputVector), std::string(pszOutputVector), alphaVal, force);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeFitPolygonToPoints(std::string(pszInputVector), std::string(pszOutputVector), alphaVal, force);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -585,7 +642,10 @@ static PyObject *VectorUtils_FitPolygons2PointClusters(PyObject *self, PyObject
     
     try
     {
-        rsgis::cmds::executeFitPolygonsToPointClusters(std::string(pszInputVector), std::string(pszOutputVector), std::string(clustersField), alphaVal, force);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeFitPolygonsToPointClusters(std::string(pszInputVector), std::string(pszOutputVector), std::string(clustersField), alphaVal, force);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -611,7 +671,10 @@ static PyObject *VectorUtils_CreateLinesOfPoints(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeCreateLinesOfPoints(std::string(pszInputVector), std::string(pszOutputVector), step, force);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCreateLinesOfPoints(std::string(pszInputVector), std::string(pszOutputVector), step, force);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -640,7 +703,10 @@ static PyObject *VectorUtils_FitActiveContourBoundaries(PyObject *self, PyObject
     
     try
     {
-        rsgis::cmds::executeFitActiveContourBoundaries(std::string(pszInputVector), std::string(pszOutputVector), std::string(pszExterForceImg), alphaVal, betaVal, gammaVal, minExtThresVal, bool(force));
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeFitActiveContourBoundaries(std::string(pszInputVector), std::string(pszOutputVector), std::string(pszExterForceImg), alphaVal, betaVal, gammaVal, minExtThresVal, bool(force));
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -667,7 +733,10 @@ static PyObject *VectorUtils_CheckValidateGeometries(PyObject *self, PyObject *a
     try
     {
         bool printGeomErrs = (bool) printGeomErrsInt;
-        rsgis::cmds::executeCheckValidateGeometries(std::string(pszInputVector), std::string(pszVectorLyrName), std::string(pszOutputVector), std::string(pszDriver), printGeomErrs);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeCheckValidateGeometries(std::string(pszInputVector), std::string(pszVectorLyrName), std::string(pszOutputVector), std::string(pszDriver), printGeomErrs);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -678,6 +747,37 @@ static PyObject *VectorUtils_CheckValidateGeometries(PyObject *self, PyObject *a
     Py_RETURN_NONE;
 }
 
+static PyObject *VectorUtils_PolygoniseClumps(PyObject *self, PyObject *args)
+{
+    const char *pszInputImage;
+    unsigned int imgBand = 1;
+    const char *pszOutputVector;
+    const char *pszOutVecLyr;
+    const char *pszDriver;
+    const char *pszPxlValField = "PXLVAL";
+    int useNoDataInt = true;
+
+    if( !PyArg_ParseTuple(args, "sIsss|si:polygoniseClumps", &pszInputImage, &imgBand, &pszOutputVector, &pszOutVecLyr, &pszDriver, &pszPxlValField, &useNoDataInt))
+    {
+        return NULL;
+    }
+
+    try
+    {
+        bool useNoData = (bool) useNoDataInt;
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePolygoniseClumps(std::string(pszInputImage), imgBand, std::string(pszOutputVector), std::string(pszOutVecLyr), std::string(pszDriver), std::string(pszPxlValField), useNoData);
+        }
+    }
+    catch(rsgis::cmds::RSGISCmdException &e)
+    {
+        PyErr_SetString(GETSTATE(self)->error, e.what());
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
 
 // Our list of functions in this module
 static PyMethodDef VectorUtilsMethods[] = {
@@ -1019,6 +1119,23 @@ static PyMethodDef VectorUtilsMethods[] = {
 ":param outVecDriver: is a string specifying the output vector GDAL/OGR driver (e.g., GPKG).\n"
 ":param printGeomErrs: is a bool, specifying whether were errors are found they are printed to the console.\n"
 "\n"},
+
+{"polygoniseClumps", VectorUtils_PolygoniseClumps, METH_VARARGS,
+"vectorutils.polygoniseClumps(inputImg, imgBand, outputVector, outVecLyr, outVecDriver, pxlValField='PXLVAL', useNoData=True)\n"
+"A command to polygonise a clumps (or other integer) image by tracing the boundaries between clumps, where\n"
+"neighbouring polygons share the same vertices along their boundaries. The image is processed a strip of rows\n"
+"at a time and each polygon is written once complete, so large segmentations can be polygonised.\n"
+"The output layer is a MultiPolygon layer, as a value may have more than one outer ring.\n\n"
+"Where:\n"
+"\n"
+":param inputImg: is a string containing the name and path of the input clumps image.\n"
+":param imgBand: is an unsigned int specifying the image band to be polygonised.\n"
+":param outputVector: is a string containing the name and path of the output vector.\n"
+":param outVecLyr: is a string specifying the name of the output vector layer.\n"
+":param outVecDriver: is a string specifying the output vector GDAL/OGR driver (e.g., GPKG).\n"
+":param pxlValField: is a string specifying the name of the output column with the clump value.\n"
+":param useNoData: is a bool, specifying whether the no data value of the image band is not polygonised.\n"
+"\n"},
     
 {NULL}        /* Sentinel */
 };
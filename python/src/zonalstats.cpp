@@ -55,7 +55,10 @@ static PyObject *ZonalStats_PointValue2SHP(PyObject *self, PyObject *args)
 
     try
     {
-        rsgis::cmds::executePointValue(pszInputImage, pszInputVector, pszOutputVector, false, force, useBandNames);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePointValue(pszInputImage, pszInputVector, pszOutputVector, false, force, useBandNames);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -77,7 +80,10 @@ static PyObject *ZonalStats_PointValue2TXT(PyObject *self, PyObject *args)
 
     try
     {
-        rsgis::cmds::executePointValue(pszInputImage, pszInputVector, pszOutputTxt, true, false, useBandNames, shortenBandNames);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePointValue(pszInputImage, pszInputVector, pszOutputTxt, true, false, useBandNames, shortenBandNames);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -97,7 +103,10 @@ static PyObject *ZonalStats_PixelVals2TXT(PyObject *self, PyObject *args)
         return NULL;
     try
     {
-        rsgis::cmds::executePixelVals2txt(pszInputImage, pszInputVector, pszOutputTextBase, pzsPolyAttribute, "csv", noProjWarning, pixelInPolyMethod);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePixelVals2txt(pszInputImage, pszInputVector, pszOutputTextBase, pzsPolyAttribute, "csv", noProjWarning, pixelInPolyMethod);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -193,8 +202,11 @@ static PyObject *ZonalStats_PixelStats2SHP(PyObject *self, PyObject *args)
   
     try
     {
-        rsgis::cmds::executePixelStats(pszInputImage, pszInputVector, pszOutputVector, zonalAtts, 
-            "", false, force, useBandNames, noProjWarning, pixelInPolyMethod);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePixelStats(pszInputImage, pszInputVector, pszOutputVector, zonalAtts, 
+                "", false, force, useBandNames, noProjWarning, pixelInPolyMethod);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -459,7 +471,10 @@ static PyObject *ZonalStats_PolyPixelStatsVecLyr(PyObject *self, PyObject *args,
     try
     {
         bool noProjWarningBool = (bool)noProjWarning;
-        rsgis::cmds::executePixelBandStatsVecLyr(std::string(pszInputImage), std::string(pszVector), std::string(pszVectorLyr), bandZonalAttsVec, pixelInPolyMethod, noProjWarningBool);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePixelBandStatsVecLyr(std::string(pszInputImage), std::string(pszVector), std::string(pszVectorLyr), bandZonalAttsVec, pixelInPolyMethod, noProjWarningBool);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -556,8 +571,11 @@ static PyObject *ZonalStats_PixelStats2TXT(PyObject *self, PyObject *args)
   
     try
     {
-        rsgis::cmds::executePixelStats(pszInputImage, pszInputVector, pszOutputTxt, zonalAtts, 
-            "", true, false, useBandNames, noProjWarning, pixelInPolyMethod, shortenBandNames);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executePixelStats(pszInputImage, pszInputVector, pszOutputTxt, zonalAtts, 
+                "", true, false, useBandNames, noProjWarning, pixelInPolyMethod, shortenBandNames);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -578,7 +596,10 @@ static PyObject *ZonalStats_ImageZoneToHDF(PyObject *self, PyObject *args)
         return NULL;
     try
     {
-        rsgis::cmds::executeZonesImage2HDF5(pszInputImage, pszInputVector, pszOutputHDF, noProjWarning, pixelInPolyMethod);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeZonesImage2HDF5(pszInputImage, pszInputVector, pszOutputHDF, noProjWarning, pixelInPolyMethod);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -601,7 +622,10 @@ static PyObject *ZonalStats_ExtractAvgEndMembers(PyObject *self, PyObject *args)
     
     try
     {
-        rsgis::cmds::executeExtractAvgEndMembers(pszInputImage, pszInputVector, pszOutputMatrix, pixelInPolyMethod);
+        {
+            RSGISPyReleaseGIL releaseGIL;
+            rsgis::cmds::executeExtractAvgEndMembers(pszInputImage, pszInputVector, pszOutputMatrix, pixelInPolyMethod);
+        }
     }
     catch(rsgis::cmds::RSGISCmdException &e)
     {
@@ -43,10 +43,13 @@ try:
     from rsgislib import zonalstats
     from rsgislib import imageregistration
     from rsgislib import imagefilter
+    from rsgislib import imagecalibration
     from rsgislib import segmentation
     from rsgislib.segmentation import segutils
     from rsgislib.imagecalc import BandDefn
     from rsgislib import tools
+    import numpy
+    from osgeo import gdal
 except ImportError as err:
     print(err)
     sys.exit()
@@ -89,6 +92,8 @@ class RSGISTests:
         shutil.copy2('RATS/injune_p142_casi_sub_utm_segs.kea', 'TestOutputs/RasterGIS/injune_p142_casi_sub_utm_segs_col.kea')
         shutil.copy2('RATS/injune_p142_casi_sub_utm_segs.kea', 'TestOutputs/RasterGIS/injune_p142_casi_sub_utm_segs_col_str.kea')
         shutil.copy2('RATS/injune_p142_casi_sub_utm_segs.kea', 'TestOutputs/RasterGIS/injune_p142_casi_sub_utm_segs_change.kea')
+        shutil.copy2('RATS/injune_p142_casi_sub_utm_segs.kea', 'TestOutputs/RasterGIS/injune_p142_casi_sub_utm_segs_ratcols.kea')
+        shutil.copy2('RATS/injune_p142_casi_sub_utm_segs.kea', 'TestOutputs/RasterGIS/injune_p142_casi_sub_utm_segs_clumpmeans.kea')
         shutil.copy2('Rasters/injune_p142_casi_sub_utm.kea', 'TestOutputs/injune_p142_casi_sub_utm.kea')
         
         shutil.copy2('RATS/injune_p142_casi_sub_utm_segs_nostats.kea', 'TestOutputs/RasterGIS/injune_p142_casi_sub_utm_segs_nostats_addstats.kea')
@@ -173,6 +178,22 @@ class RSGISTests:
     def testPCA(self):
         print("PYTHON TEST: unable to test PCA - awaiting eigenvectors")
 
+    def testCalcImagePCA(self):
+        print("PYTHON TEST: calcImagePCA")
+        outputImage = path + "TestOutputs/PSU142_pca.kea"
+        outEigenVecs = path + "TestOutputs/PSU142_pca_eigenvecs.mtxt"
+        varProps = imagecalc.calcImagePCA(inFileName, outputImage, outEigenVecs, 0, "KEA", rsgislib.TYPE_32FLOAT)
+        if abs(sum(varProps) - 1) > 1e-6:
+            raise Exception("The proportions of the variance do not sum to 1.")
+        if any(varProps[i] < varProps[i+1] for i in range(len(varProps)-1)):
+            raise Exception("The components are not in order of the variance explained.")
+        outputImage = path + "TestOutputs/PSU142_pca_rand3.kea"
+        randVarProps = imagecalc.calcImagePCA(inFileName, outputImage, "", 3, "KEA", rsgislib.TYPE_32FLOAT, randomised=True)
+        if len(randVarProps) != 3:
+            raise Exception("The randomised PCA did not give 3 components.")
+        if abs(randVarProps[0] - varProps[0]) > 1e-3:
+            raise Exception("The first randomised component differs from the exact component.")
+
     def testStandardise(self):
         print("PYTHON TEST: Testing standardise")
         outImage = path + "TestOutputs/PSU142_Standarised.env"
@@ -191,6 +212,35 @@ class RSGISTests:
         bandDefns.append(BandDefn("b2", inFileName, 2))
         imagecalc.bandMath(outputImage, expression, gdalformat, dataType, bandDefns)
 
+    def testBandMathPipeline(self):
+        print("PYTHON TEST: Testing bandMathPipeline")
+        ndviImage = path + "TestOutputs/PSU142_pipeline_ndvi.kea"
+        vegImage = path + "TestOutputs/PSU142_pipeline_veg.kea"
+        inputs = [("casi", inFileName)]
+        ndviBands = [BandDefn("red", "casi", 3), BandDefn("nir", "casi", 4)]
+        diffBands = [BandDefn("red", "casi", 3), BandDefn("nir", "casi", 4)]
+        vegBands = [BandDefn("ndvi", "ndvi", 1), BandDefn("diff", "diff", 1)]
+        steps = [("ndvi", "(nir-red)/(nir+red)", ndviBands, ndviImage),
+                 ("diff", "nir-red", diffBands, None),
+                 ("veg", "(ndvi>0.5)&&(diff>0)?1:0", vegBands, vegImage)]
+        imagecalc.bandMathPipeline(inputs, steps, "KEA", rsgislib.TYPE_32FLOAT, path + "TestOutputs")
+
+        inDS = gdal.Open(inFileName)
+        red = inDS.GetRasterBand(3).ReadAsArray().astype(numpy.float64)
+        nir = inDS.GetRasterBand(4).ReadAsArray().astype(numpy.float64)
+        ndvi = gdal.Open(ndviImage).GetRasterBand(1).ReadAsArray().astype(numpy.float64)
+        veg = gdal.Open(vegImage).GetRasterBand(1).ReadAsArray()
+        # Pixels where nir+red is 0 have no defined NDVI.
+        valid = (nir + red) != 0
+        refNDVI = (nir[valid] - red[valid]) / (nir[valid] + red[valid])
+        if not numpy.allclose(ndvi[valid], refNDVI, rtol=1e-6, atol=1e-7):
+            raise Exception("The NDVI image does not match (nir-red)/(nir+red).")
+        # Pixels (almost) exactly at the threshold may round either way in single precision.
+        clear = valid & (numpy.abs(ndvi - 0.5) > 1e-6)
+        refVeg = numpy.where((ndvi > 0.5) & ((nir - red) > 0), 1, 0)
+        if not numpy.array_equal(veg[clear], refVeg[clear]):
+            raise Exception("The vegetation image does not match (ndvi>0.5)&&(diff>0)?1:0.")
+
     def testImageMaths(self):
         print("PYTHON TEST: Testing imageMath")
         outputImage = path + "TestOutputs/PSU142_multi1000.kea"
@@ -250,7 +300,32 @@ class RSGISTests:
         print("PYTHON TEST: unconLinearSpecUnmix - skipping due to lack of test data")
 
     def testExhConLinearSpecUnmix(self):
-        print("PYTHON TEST: exhConinearSpecUnmix - skipping due to lack of test data")
+        print("PYTHON TEST: exhconLinearSpecUnmix")
+        data = gdal.Open(inFileName).ReadAsArray().astype(numpy.float64)
+        # Three pixels of the image are used as the endmembers (a column per endmember).
+        endmembers = data[:, [20, 75, 130], [50, 250, 450]]
+        endmembersFile = path + "TestOutputs/injune_p142_casi_endmembers.mtxt"
+        with open(endmembersFile, 'w') as f:
+            f.write('m=3\nn=14\n' + ','.join(str(v) for v in endmembers.ravel()) + '\n')
+        output = path + "TestOutputs/injune_p142_casi_sub_utm_exhcon_unmix.kea"
+        imagecalc.exhconLinearSpecUnmix(inFileName, "KEA", rsgislib.TYPE_32FLOAT, output, endmembersFile, 0.1)
+        outData = gdal.Open(output).ReadAsArray().astype(numpy.float64)
+
+        # Reference: every combination of abundances in steps of 0.1 summing to at most 1,
+        # fitted to the normalised spectra of a sample of the pixels.
+        combs = numpy.array([[i, j, k] for i in range(11) for j in range(11) for k in range(11) if (i + j + k) <= 10]) / 10.0
+        spectra = numpy.dot(endmembers / numpy.linalg.norm(endmembers, axis=0), combs.T)
+        pxls = data[:, ::7, ::7].reshape(14, -1)
+        outPxls = outData[:, ::7, ::7].reshape(4, -1)
+        valid = numpy.linalg.norm(pxls, axis=0) > 0
+        pxls = pxls[:, valid] / numpy.linalg.norm(pxls[:, valid], axis=0)
+        outPxls = outPxls[:, valid]
+        errors = numpy.sqrt(((spectra[:, :, numpy.newaxis] - pxls[:, numpy.newaxis, :])**2).mean(axis=0))
+        if not numpy.all(outPxls[3] <= (errors.min(axis=0) + 1e-4)):
+            raise Exception("The unmixing did not select the combination with the smallest error.")
+        outSpectra = numpy.dot(endmembers / numpy.linalg.norm(endmembers, axis=0), outPxls[:3])
+        if not numpy.allclose(numpy.sqrt(((outSpectra - pxls)**2).mean(axis=0)), outPxls[3], atol=1e-4):
+            raise Exception("The unmixing error is not that of the output abundances.")
 
     def testConSum1LinearSpecUnmix(self):
         print("PYTHON TEST: ConSum1LinearSpecUnmix - skipping due to lack of test data")
@@ -344,6 +419,61 @@ class RSGISTests:
         dataType = rsgislib.TYPE_32FLOAT
         imagecalc.correlationWindow(image, output, window, bandA, bandB, gdalformat, dataType)
 
+    def testCorrelationWindowBands(self):
+        print("PYTHON TEST: correlationWindow between bands")
+        output = path + "TestOutputs/injune_p142_casi_sub_utm_correlation_b1b4.kea"
+        imagecalc.correlationWindow(inFileName, output, 9, 1, 4, "KEA", rsgislib.TYPE_32FLOAT)
+        outCorr = gdal.Open(output).GetRasterBand(1).ReadAsArray().astype(numpy.float64)
+        # Reference: the correlation from the sums over each 9x9 window (summed area tables),
+        # for the pixels whose window is within the image.
+        data = gdal.Open(inFileName).ReadAsArray().astype(numpy.float64)
+        a = data[0]
+        b = data[3]
+        def winSums(vals):
+            sat = numpy.pad(vals.cumsum(axis=0).cumsum(axis=1), ((1, 0), (1, 0)), mode='constant')
+            return sat[9:, 9:] - sat[:-9, 9:] - sat[9:, :-9] + sat[:-9, :-9]
+        n = 81.0
+        sumA = winSums(a)
+        sumB = winSums(b)
+        cov = (n * winSums(a * b)) - (sumA * sumB)
+        varA = (n * winSums(a * a)) - (sumA * sumA)
+        varB = (n * winSums(b * b)) - (sumB * sumB)
+        refCorr = numpy.zeros_like(cov)
+        valid = (varA > 0) & (varB > 0)
+        refCorr[valid] = cov[valid] / numpy.sqrt(varA[valid] * varB[valid])
+        if not numpy.allclose(outCorr[4:-4, 4:-4], refCorr, atol=1e-4):
+            raise Exception("The window correlation differs from that of the window sums.")
+
+
+    def testIdentifyMinPxlValueInWin(self):
+        print("PYTHON TEST: identifyMinPxlValueInWin")
+        image = path + "Rasters/injune_p142_casi_sub_maskedto0_utm.kea"
+        output = path + "TestOutputs/injune_p142_casi_sub_utm_minwin.kea"
+        outputRef = path + "TestOutputs/injune_p142_casi_sub_utm_minwin_ref.kea"
+        bands = [1, 4, 8]
+        imagecalc.identifyMinPxlValueInWin(image, output, outputRef, bands, 7, 'KEA', 0, True)
+        # Reference: the minimum of each band over the 7x7 windows, with the no data
+        # value (and outside the image, which is 0) ignored, then the band with the
+        # smallest minimum (the first listed on ties).
+        data = gdal.Open(image).ReadAsArray().astype(numpy.float64)
+        height, width = data.shape[1:]
+        bandMins = []
+        for band in bands:
+            padded = numpy.pad(data[band-1], 3, mode='constant')
+            padded[padded == 0] = numpy.inf
+            bandMins.append(numpy.array([padded[y:y+height, x:x+width] for y in range(7) for x in range(7)]).min(axis=0))
+        bandMins = numpy.array(bandMins)
+        minIdx = bandMins.argmin(axis=0)
+        refMin = numpy.take_along_axis(bandMins, minIdx[numpy.newaxis], axis=0)[0]
+        refBand = numpy.array(bands)[minIdx]
+        # Nothing valid in the window, or the centre pixel no data in all the bands, gives 0.
+        outside = numpy.isinf(refMin) | (data == 0).all(axis=0)
+        refMin[outside] = 0
+        refBand[outside] = 0
+        if not numpy.array_equal(gdal.Open(output).GetRasterBand(1).ReadAsArray(), refMin):
+            raise Exception("The window minima differ from the reference.")
+        if not numpy.array_equal(gdal.Open(outputRef).GetRasterBand(1).ReadAsArray(), refBand):
+            raise Exception("The bands of the window minima differ from the reference.")
 
     def testImagePixelLinearFit(self):
         print("PYTHON TEST: imagePixelLinearFit")
@@ -360,6 +490,133 @@ class RSGISTests:
 
         imagecalc.imagePixelLinearFit(image, output, gdalformat, bandValuesFile, 0, True)
 
+    def testImagePixelModelFit(self):
+        print("PYTHON TEST: imagePixelModelFit")
+        image = path + "Rasters/injune_p142_casi_sub_utm.kea"
+        bandValues = [446,530,549,569,598,633,680,696,714,732,741,752,800,838]
+        bandValuesFile =  path + "TestOutputs/injune_p142_casi_wavelengths_modelfit.txt"
+        with open(bandValuesFile,'w') as f:
+            for bandVal in bandValues:
+                f.write(str(bandVal) + '\n')
+        polyOutput = path + "TestOutputs/injune_p142_casi_sub_utm_poly_fit.kea"
+        imagecalc.imagePixelModelFit(image, polyOutput, "KEA", bandValuesFile, 'polynomial', 2, nodata=0)
+        harmOutput = path + "TestOutputs/injune_p142_casi_sub_utm_harmonic_fit.kea"
+        imagecalc.imagePixelModelFit(image, harmOutput, "KEA", bandValuesFile, 'harmonic', 1, period=400)
+
+        x = numpy.array(bandValues, dtype=numpy.float64)
+        inData = gdal.Open(image).ReadAsArray().astype(numpy.float64)
+        polyData = gdal.Open(polyOutput).ReadAsArray().astype(numpy.float64)
+        harmData = gdal.Open(harmOutput).ReadAsArray().astype(numpy.float64)
+        polyDesign = numpy.vstack([x**k for k in range(3)]).T
+        harmDesign = numpy.vstack([numpy.ones_like(x), x, numpy.cos(2 * numpy.pi * x / 400), numpy.sin(2 * numpy.pi * x / 400)]).T
+        # The coefficients are compared through the fitted values, as the
+        # higher order coefficients are small.
+        def checkFit(name, design, yVals, coeffs, rmse, refCoeffs):
+            refFitted = design.dot(refCoeffs)
+            refRMSE = numpy.sqrt(numpy.mean((yVals - refFitted)**2))
+            tol = 1e-4 * max(1.0, numpy.abs(yVals).max())
+            if numpy.abs(design.dot(coeffs) - refFitted).max() > tol:
+                raise Exception("The {} fit does not match numpy.".format(name))
+            if abs(rmse - refRMSE) > tol:
+                raise Exception("The {} RMSE does not match numpy.".format(name))
+        for row, col in [(10, 10), (75, 250), (140, 480), (30, 333)]:
+            y = inData[:, row, col]
+            valid = y != 0
+            if valid.sum() >= 3:
+                refCoeffs = numpy.polyfit(x[valid], y[valid], 2)[::-1]
+                checkFit('polynomial', polyDesign[valid], y[valid], polyData[:3, row, col], polyData[3, row, col], refCoeffs)
+            elif numpy.any(polyData[:, row, col] != 0):
+                raise Exception("A pixel with too few valid values has a polynomial fit.")
+            refCoeffs = numpy.linalg.lstsq(harmDesign, y, rcond=None)[0]
+            checkFit('harmonic', harmDesign, y, harmData[:4, row, col], harmData[4, row, col], refCoeffs)
+
+    def testImagePixelRobustModelFit(self):
+        print("PYTHON TEST: imagePixelRobustModelFit")
+        image = path + "Rasters/injune_p142_casi_sub_utm.kea"
+        bandValues = [446,530,549,569,598,633,680,696,714,732,741,752,800,838]
+        bandValuesFile =  path + "TestOutputs/injune_p142_casi_wavelengths_robustfit.txt"
+        with open(bandValuesFile,'w') as f:
+            for bandVal in bandValues:
+                f.write(str(bandVal) + '\n')
+        output = path + "TestOutputs/injune_p142_casi_sub_utm_robust_poly_fit.kea"
+        imagecalc.imagePixelRobustModelFit(image, output, "KEA", bandValuesFile, 'polynomial', 2, nodata=0)
+        output = path + "TestOutputs/injune_p142_casi_sub_utm_robust_harmonic_fit.kea"
+        imagecalc.imagePixelRobustModelFit(image, output, "KEA", bandValuesFile, 'harmonic', 1, period=400, maxiters=10, outlierthres=500, outliers=False)
+
+        # Synthetic pixels exactly on a quadratic (exact in single precision)...
+        x = numpy.array(bandValues, dtype=numpy.float64)
+        rows, cols = numpy.mgrid[0:10, 0:20]
+        refCoeffs = numpy.array([500.0, 0.5, 1.0/1024.0])
+        cleanData = numpy.array([refCoeffs[0] + rows + (2 * cols) + (refCoeffs[1] * xVal) + (refCoeffs[2] * xVal * xVal) for xVal in x])
+        # ...and the same with an outlier in band 6 of a third of the pixels.
+        outlierMask = ((rows + cols) % 3) == 0
+        outlierData = cleanData.copy()
+        outlierData[5][outlierMask] += 3000
+        def writeImage(outputImage, data):
+            outDS = gdal.GetDriverByName('KEA').Create(outputImage, data.shape[2], data.shape[1], data.shape[0], gdal.GDT_Float32)
+            outDS.SetGeoTransform((0, 1, 0, 0, 0, -1))
+            for b in range(data.shape[0]):
+                outDS.GetRasterBand(b+1).WriteArray(data[b])
+            outDS = None
+        cleanImage = path + "TestOutputs/robustfit_clean.kea"
+        writeImage(cleanImage, cleanData)
+        outlierImage = path + "TestOutputs/robustfit_outliers.kea"
+        writeImage(outlierImage, outlierData)
+        refC0 = refCoeffs[0] + rows + (2 * cols)
+
+        lsClean = path + "TestOutputs/robustfit_clean_ls.kea"
+        imagecalc.imagePixelModelFit(cleanImage, lsClean, "KEA", bandValuesFile, 'polynomial', 2)
+        robustClean = path + "TestOutputs/robustfit_clean_robust.kea"
+        imagecalc.imagePixelRobustModelFit(cleanImage, robustClean, "KEA", bandValuesFile, 'polynomial', 2, outliers=False)
+        lsOutliers = path + "TestOutputs/robustfit_outliers_ls.kea"
+        imagecalc.imagePixelModelFit(outlierImage, lsOutliers, "KEA", bandValuesFile, 'polynomial', 2)
+        robustOutliers = path + "TestOutputs/robustfit_outliers_robust.kea"
+        imagecalc.imagePixelRobustModelFit(outlierImage, robustOutliers, "KEA", bandValuesFile, 'polynomial', 2, outlierthres=100, outliers=True)
+
+        def checkCoeffs(name, coeffs, expC0):
+            for k, expected in enumerate([expC0, refCoeffs[1], refCoeffs[2]]):
+                if not numpy.allclose(coeffs[k], expected, rtol=1e-5, atol=1e-6 * (refCoeffs[0] / (x.max()**k))):
+                    raise Exception("Coefficient {} of the {} does not match.".format(k, name))
+        lsCleanData = gdal.Open(lsClean).ReadAsArray().astype(numpy.float64)
+        robustCleanData = gdal.Open(robustClean).ReadAsArray().astype(numpy.float64)
+        checkCoeffs("least squares fit", lsCleanData, refC0)
+        # With no outliers the robust fit must be the least squares fit.
+        if not numpy.allclose(robustCleanData[:3], lsCleanData[:3], rtol=1e-5, atol=1e-9):
+            raise Exception("The robust fit of data without outliers differs from the least squares fit.")
+
+        # The outlier pulls the least squares fit but the robust fit must reject it.
+        lsOutlierData = gdal.Open(lsOutliers).ReadAsArray().astype(numpy.float64)
+        if numpy.abs(lsOutlierData[0][outlierMask] - refC0[outlierMask]).min() < 1:
+            raise Exception("The injected outliers do not change the least squares fit.")
+        robustOutlierData = gdal.Open(robustOutliers).ReadAsArray().astype(numpy.float64)
+        checkCoeffs("robust fit with outliers", robustOutlierData, refC0)
+        if numpy.abs(robustOutlierData[3]).max() > 1e-2:
+            raise Exception("The RMSE of the observations which are not outliers is not 0.")
+        outlierBands = robustOutlierData[4:] != 0
+        refOutlierBands = numpy.zeros_like(outlierBands)
+        refOutlierBands[5] = outlierMask
+        if not numpy.array_equal(outlierBands, refOutlierBands):
+            raise Exception("The outlier bands do not flag exactly the injected outliers.")
+
+    def testCalcImageBlocks(self):
+        print("PYTHON TEST: calcImageBlocks")
+        outputImage = path + "TestOutputs/PSU142_blocks_b1x2.kea"
+        def doubleBand1(inbands, outbands, width, nrows):
+            inBand = inbands[0].cast('f')
+            outBand = outbands[0].cast('d')
+            for i in range(width * nrows):
+                outBand[i] = inBand[i] * 2
+        imagecalc.calcImageBlocks([inFileName], outputImage, "KEA", rsgislib.TYPE_32FLOAT, 1, doubleBand1)
+
+    def testCalcImageBlocksNumpy(self):
+        print("PYTHON TEST: calcImageBlocksNumpy")
+        outputImage = path + "TestOutputs/PSU142_blocks_ndvi.kea"
+        def calcNDVI(inblocks, outblocks):
+            red = inblocks[2]
+            nir = inblocks[3]
+            numpy.divide(nir - red, nir + red, out=outblocks[0], where=(nir + red) != 0)
+        imagecalc.calcImageBlocksNumpy([inFileName], outputImage, "KEA", rsgislib.TYPE_32FLOAT, 1, calcNDVI)
+
     # Raster GIS
 
     def testCopyGDLATT(self):
@@ -432,6 +689,25 @@ class RSGISTests:
         bp.append(rastergis.BandAttPercentiles(percentile=75.0, fieldName="B1Per75"))
         rastergis.populateRATWithPercentiles(input, clumps, 1, bp)
 
+    def testReadWriteRATColumn(self):
+        print("PYTHON TEST: readRATColumn and writeRATColumn")
+        clumps = "./TestOutputs/RasterGIS/injune_p142_casi_sub_utm_segs_ratcols.kea"
+        nRows = rastergis.getRATLength(clumps)
+        intVals = numpy.arange(nRows, dtype=numpy.int32)
+        floatVals = numpy.arange(nRows, dtype=numpy.float64) / 2
+        rastergis.writeRATColumn(clumps, "IntTest", intVals)
+        rastergis.writeRATColumn(clumps, "FloatTest", floatVals)
+        # Write the second half again as a chunk.
+        half = nRows // 2
+        rastergis.writeRATColumn(clumps, "FloatTest", floatVals[half:] * 2, start_row=half)
+        floatVals[half:] *= 2
+        if not numpy.array_equal(rastergis.readRATColumn(clumps, "IntTest"), intVals):
+            raise Exception("The integer column read back differs from that written.")
+        if not numpy.array_equal(rastergis.readRATColumn(clumps, "FloatTest"), floatVals):
+            raise Exception("The float column read back differs from that written.")
+        if not numpy.array_equal(rastergis.readRATColumn(clumps, "FloatTest", start_row=half, n_rows=nRows-half), floatVals[half:]):
+            raise Exception("The range of rows read back differs from that written.")
+
     def testExport2Ascii(self):
         print("PYTHON TEST: export2Ascii")
         table="./RATS/injune_p142_casi_sub_utm_segs.kea"
@@ -632,6 +908,34 @@ class RSGISTests:
         dataType = rsgislib.TYPE_8INT
         imageutils.stretchImage(inputImage, outputImage, False, "", True, False, gdalformat, dataType, imageutils.STRETCH_LINEARSTDDEV, 2)
 
+    def testStretchImagePercentiles(self):
+        print("PYTHON TEST: stretchImage with percentiles")
+        inputImage = './Rasters/injune_p142_casi_sub_utm.kea'
+        outputImage = './TestOutputs/injune_p142_casi_sub_utm_2pc.kea'
+        gdalformat = 'KEA'
+        dataType = rsgislib.TYPE_8INT
+        imageutils.stretchImage(inputImage, outputImage, False, "", True, False, gdalformat, dataType, imageutils.STRETCH_LINEARPERCENT, 2, usepercentiles=True)
+
+    def testImageFootprintIndex(self):
+        print("PYTHON TEST: createImageFootprintIndex and queryImageFootprintIndex")
+        leftImage = './Rasters/injune_p142_casi_sub_left_utm.kea'
+        rightImage = './Rasters/injune_p142_casi_sub_right_utm.kea'
+        fullImage = './Rasters/injune_p142_casi_sub_utm.kea'
+        indexFile = './TestOutputs/injune_p142_footprints.idx'
+        imageutils.createImageFootprintIndex([leftImage, rightImage, fullImage], indexFile, nthreads=2)
+        # The left and right images are 50 m shorter than the full image on the right and left.
+        bbox = rsgislib.RSGISPyUtils().getImageBBOX(fullImage)
+        midY = (bbox[2] + bbox[3]) / 2
+        found = imageutils.queryImageFootprintIndex(indexFile, point=(bbox[0] + 10, midY))
+        if sorted(found) != sorted([leftImage, fullImage]):
+            raise Exception("The images at the left edge are not as expected: " + str(found))
+        found = imageutils.queryImageFootprintIndex(indexFile, bbox=(bbox[1] - 20, bbox[1] - 10, midY - 10, midY + 10))
+        if sorted(found) != sorted([rightImage, fullImage]):
+            raise Exception("The images at the right edge are not as expected: " + str(found))
+        found = imageutils.queryImageFootprintIndex(indexFile, point=(bbox[1] + 1000, midY))
+        if len(found) != 0:
+            raise Exception("Images were found outside of the footprints: " + str(found))
+
     def testSetBandNames(self):
         print("PYTHON TEST: setBandNames")
         inputImage = './TestOutputs/injune_p142_casi_sub_utm.kea'
@@ -860,6 +1164,65 @@ class RSGISTests:
 
         imagefilter.applyfilters(inputImage, outputImageBase, filters, gdalFormat, outExt, dataType)
     
+    def testGLCMTextures(self):
+        print("PYTHON TEST: glcmTextures")
+        outputImage = './TestOutputs/injune_p142_casi_sub_utm_glcm.kea'
+        measures = ['contrast', 'dissimilarity', 'homogeneity', 'asm', 'energy', 'entropy', 'mean', 'variance', 'correlation']
+        imagefilter.glcmTextures(inFileName, outputImage, measures, band=1, nlevels=32, winsize=7)
+        outputImage = './TestOutputs/injune_p142_casi_sub_utm_glcm_diag.kea'
+        imagefilter.glcmTextures(inFileName, outputImage, ['contrast', 'entropy'], band=4, nlevels=16, winsize=5, xoffset=1, yoffset=1, minval=0, maxval=5000)
+        # Reference: the symmetric GLCM of a few 5x5 windows (including the image
+        # corners, where the pixels outside the image are not counted) built directly.
+        bandObj = gdal.Open(inFileName).GetRasterBand(4)
+        data = bandObj.ReadAsArray().astype(numpy.float64)
+        valid = ~numpy.isnan(data)
+        if bandObj.GetNoDataValue() is not None:
+            valid &= (data != bandObj.GetNoDataValue())
+        levels = numpy.clip(numpy.floor(data * (16 / 5000.0)), 0, 15).astype(int)
+        glcm = gdal.Open(outputImage).ReadAsArray().astype(numpy.float64)
+        for row, col in [(75, 250), (0, 0), (149, 499), (2, 497)]:
+            counts = numpy.zeros((16, 16))
+            # The first pixel of each pair (its second at +1, +1) with both in the window.
+            for y in range(row - 2, row + 2):
+                for x in range(col - 2, col + 2):
+                    if (y < 0) or (x < 0) or (y + 1 >= data.shape[0]) or (x + 1 >= data.shape[1]):
+                        continue
+                    if valid[y, x] and valid[y+1, x+1]:
+                        counts[levels[y, x], levels[y+1, x+1]] += 1
+                        counts[levels[y+1, x+1], levels[y, x]] += 1
+            # Windows without any pairs are given 0.
+            refContrast = 0.0
+            refEntropy = 0.0
+            if counts.sum() > 0:
+                probs = counts / counts.sum()
+                i, j = numpy.indices(probs.shape)
+                refContrast = (probs * (i - j)**2).sum()
+                nonZero = probs[probs > 0]
+                refEntropy = -(nonZero * numpy.log(nonZero)).sum()
+            if not numpy.allclose(glcm[:, row, col], [refContrast, refEntropy], rtol=1e-5, atol=1e-6):
+                raise Exception("The GLCM contrast and entropy at ({}, {}) do not match the directly built GLCM.".format(row, col))
+
+    def testMedianModeFilters(self):
+        print("PYTHON TEST: median and mode filters")
+        inputImage = './Rasters/injune_p142_casi_sub_utm_single_band.vrt'
+        outputImageBase = './TestOutputs/injune_p142_casi_sub_utm_single_band'
+        filters = [imagefilter.FilterParameters(filterType = 'Median', fileEnding = '_median5', size=5),
+                   imagefilter.FilterParameters(filterType = 'Mode', fileEnding = '_mode5', size=5)]
+        imagefilter.applyfilters(inputImage, outputImageBase, filters, 'KEA', 'kea', rsgislib.TYPE_32FLOAT)
+        # Reference: the sorted 5x5 windows, with the image padded with 0.
+        data = gdal.Open(inputImage).GetRasterBand(1).ReadAsArray().astype(numpy.float32)
+        padded = numpy.pad(data, 2, mode='constant')
+        windows = numpy.sort(numpy.array([padded[y:y+data.shape[0], x:x+data.shape[1]] for y in range(5) for x in range(5)]), axis=0)
+        median = gdal.Open(outputImageBase + '_median5.kea').GetRasterBand(1).ReadAsArray()
+        if not numpy.array_equal(median, windows[12]):
+            raise Exception("The median filter differs from the median of the sorted windows.")
+        # The mode is the most common value, the lowest on ties (the first in sorted order).
+        counts = numpy.array([(windows == windows[i]).sum(axis=0) for i in range(25)])
+        refMode = numpy.take_along_axis(windows, counts.argmax(axis=0)[numpy.newaxis], axis=0)[0]
+        mode = gdal.Open(outputImageBase + '_mode5.kea').GetRasterBand(1).ReadAsArray()
+        if not numpy.array_equal(mode, refMode):
+            raise Exception("The mode filter differs from the most common value of the windows.")
+
     def testLeungMalikFilterBank(self):
         inputImage = './Rasters/injune_p142_casi_sub_utm_single_band.vrt'
         outputImageBase = './TestOutputs/injune_p142_casi_sub_utm_single_band'
@@ -886,6 +1249,217 @@ class RSGISTests:
         segmentation.segutils.runShepherdSegmentation(inputImage, clumpsFile,
                        meanImage, numClusters=100, minPxls=100)
 
+    def testHierarchicalSegmentation(self):
+        print("PYTHON TEST: hierarchicalSegmentation")
+        clumps = './RATS/injune_p142_casi_sub_utm_segs.kea'
+        outputClumps = ['./TestOutputs/injune_p142_casi_sub_utm_segs_h50.kea', './TestOutputs/injune_p142_casi_sub_utm_segs_h200.kea']
+        segmentation.hierarchicalSegmentation(inFileName, clumps, outputClumps, [50, 200], [10000, 10000], 'KEA')
+        # Each level only merges the clumps of the one before, so every h50 clump
+        # must lie within a single h200 clump.
+        h50 = gdal.Open(outputClumps[0]).GetRasterBand(1).ReadAsArray().astype(numpy.int64)
+        h200 = gdal.Open(outputClumps[1]).GetRasterBand(1).ReadAsArray().astype(numpy.int64)
+        if not numpy.array_equal(h50 == 0, h200 == 0):
+            raise Exception("The h50 and h200 clumps do not cover the same pixels.")
+        pairs = numpy.unique(numpy.stack([h50[h50 != 0], h200[h50 != 0]]), axis=1)
+        if pairs.shape[1] != numpy.unique(pairs[0]).size:
+            raise Exception("An h50 clump is split between several h200 clumps.")
+
+    def testTiledSegmentation(self):
+        print("PYTHON TEST: tiledSegmentation")
+        kMeansCentres = './TestOutputs/injune_p142_casi_sub_utm_tiledseg_kcentres'
+        imagecalc.kMeansClustering(inFileName, kMeansCentres, 30, 200, 10, True, 0.0025, rsgislib.INITCLUSTER_DIAGONAL_FULL_ATTACH)
+        clumpsFile = './TestOutputs/injune_p142_casi_sub_utm_tiledseg.kea'
+        bordersFile = './TestOutputs/injune_p142_casi_sub_utm_tiledseg_borders.kea'
+        # Small tiles so the image is split into several.
+        segmentation.tiledSegmentation(inFileName, kMeansCentres + '.gmtxt', clumpsFile, bordersFile, 'KEA', 100, 100, 50, 10000, 2)
+
+        clumps = gdal.Open(clumpsFile).GetRasterBand(1).ReadAsArray().astype(numpy.int64)
+        borders = gdal.Open(bordersFile).GetRasterBand(1).ReadAsArray()
+        # The 500x150 image is split into 5 columns of 100 pixels and rows of 100 and 50.
+        xSeams = [100, 200, 300, 400]
+        ySeams = [100]
+        # Each tile numbers its own clumps so no clump may cross a seam...
+        for x in xSeams:
+            left = clumps[:, x-1]
+            right = clumps[:, x]
+            if numpy.any((left != 0) & (left == right)):
+                raise Exception("A clump crosses the tile seam at x = {}.".format(x))
+        for y in ySeams:
+            above = clumps[y-1, :]
+            below = clumps[y, :]
+            if numpy.any((above != 0) & (above == below)):
+                raise Exception("A clump crosses the tile seam at y = {}.".format(y))
+        # ...or be found in two tiles.
+        tileIds = []
+        for yRange in [(0, 100), (100, 150)]:
+            for xOff in range(0, 500, 100):
+                ids = numpy.unique(clumps[yRange[0]:yRange[1], xOff:xOff+100])
+                tileIds.append(ids[ids != 0])
+        allIds = numpy.concatenate(tileIds)
+        if allIds.size != numpy.unique(allIds).size:
+            raise Exception("A clump ID is used in more than one tile.")
+        # Each clump must be a single 4-connected region: give every pixel the
+        # smallest pixel index of its clump reachable from it.
+        region = numpy.arange(clumps.size, dtype=numpy.int64).reshape(clumps.shape)
+        changed = True
+        while changed:
+            changed = False
+            for axis in [0, 1]:
+                for shift in [1, -1]:
+                    nbrClumps = numpy.roll(clumps, shift, axis=axis)
+                    nbrRegion = numpy.roll(region, shift, axis=axis)
+                    valid = (nbrClumps == clumps)
+                    # Do not wrap around the image edge.
+                    edge = 0 if shift == 1 else -1
+                    if axis == 0:
+                        valid[edge, :] = False
+                    else:
+                        valid[:, edge] = False
+                    newRegion = numpy.where(valid, numpy.minimum(region, nbrRegion), region)
+                    if numpy.any(newRegion != region):
+                        region = newRegion
+                        changed = True
+        numRegions = numpy.unique(region[clumps != 0]).size
+        if numRegions != allIds.size:
+            raise Exception("There are {} clumps but {} connected regions; a clump is split.".format(allIds.size, numRegions))
+        # The border mask must hold exactly the clumps touching a seam.
+        seamIds = set()
+        for x in xSeams:
+            seamIds.update(numpy.unique(clumps[:, [x-1, x]]))
+        for y in ySeams:
+            seamIds.update(numpy.unique(clumps[[y-1, y], :]))
+        seamIds.discard(0)
+        refBorders = numpy.isin(clumps, list(seamIds))
+        if not numpy.array_equal(borders != 0, refBorders):
+            raise Exception("The border mask does not match the clumps touching the tile seams.")
+
+    def testEliminateSinglePixels(self):
+        print("PYTHON TEST: eliminateSinglePixels")
+        kMeansCentres = './TestOutputs/injune_p142_casi_sub_utm_elimsgls_kcentres'
+        imagecalc.kMeansClustering(inFileName, kMeansCentres, 30, 200, 10, True, 0.0025, rsgislib.INITCLUSTER_DIAGONAL_FULL_ATTACH)
+        labelsImage = './TestOutputs/injune_p142_casi_sub_utm_elimsgls_labels.kea'
+        segmentation.labelPixelsFromClusterCentres(inFileName, labelsImage, kMeansCentres + '.gmtxt', True, 'KEA')
+        outputImage = './TestOutputs/injune_p142_casi_sub_utm_elimsgls.kea'
+        segmentation.eliminateSinglePixels(inFileName, labelsImage, outputImage, './TestOutputs/injune_p142_casi_sub_utm_elimsgls_tmp.kea', 'KEA', True, True)
+
+        # A single pixel has no 4-connected neighbour with its label (outside the image is 0).
+        def findSingles(labels):
+            padded = numpy.pad(labels, 1, mode='constant')
+            singles = labels != 0
+            for dy, dx in [(0, 1), (2, 1), (1, 0), (1, 2)]:
+                singles &= padded[dy:dy+labels.shape[0], dx:dx+labels.shape[1]] != labels
+            return singles
+        inLabels = gdal.Open(labelsImage).GetRasterBand(1).ReadAsArray()
+        outLabels = gdal.Open(outputImage).GetRasterBand(1).ReadAsArray()
+        inSingles = findSingles(inLabels)
+        if not numpy.array_equal(outLabels[~inSingles], inLabels[~inSingles]):
+            raise Exception("Pixels which were not single pixels have been relabelled.")
+        # The single pixels left must have no neighbour to merge into: each neighbour
+        # is outside the image, no data (0 in all bands) or itself a single pixel.
+        outSingles = findSingles(outLabels)
+        specNoData = (gdal.Open(inFileName).ReadAsArray() == 0).all(axis=0)
+        notCandidate = numpy.pad(specNoData | outSingles, 1, mode='constant', constant_values=True)
+        for dy, dx in [(0, 1), (2, 1), (1, 0), (1, 2)]:
+            if numpy.any(outSingles & ~notCandidate[dy:dy+outLabels.shape[0], dx:dx+outLabels.shape[1]]):
+                raise Exception("A single pixel remains next to a clump it could have been merged into.")
+
+    def testMeanImage(self):
+        print("PYTHON TEST: meanImage")
+        clumps = './RATS/injune_p142_casi_sub_utm_segs.kea'
+        outputImage = './TestOutputs/injune_p142_casi_sub_utm_segs_mean.kea'
+        segmentation.meanImage(inFileName, clumps, outputImage, 'KEA', rsgislib.TYPE_32FLOAT)
+        # The segments' RAT has the means of the first three bands (as testClumpMeans2RAT).
+        clumpIDs = gdal.Open(clumps).GetRasterBand(1).ReadAsArray().astype(numpy.int64)
+        inClump = clumpIDs != 0
+        meanData = gdal.Open(outputImage).ReadAsArray()
+        for i in range(3):
+            refMeans = rastergis.readRATColumn(clumps, 'b%dMean'%(i+1))
+            if not numpy.allclose(meanData[i][inClump], refMeans[clumpIDs[inClump]], rtol=1e-4):
+                raise Exception("The mean image of band %d differs from the clump means of the RAT."%(i+1))
+
+    def testClumpMeans2RAT(self):
+        print("PYTHON TEST: clumpMeans2RAT")
+        clumps = './TestOutputs/RasterGIS/injune_p142_casi_sub_utm_segs_clumpmeans.kea'
+        colNames = ['ClumpMeanB%d'%(i+1) for i in range(14)]
+        segmentation.clumpMeans2RAT(inFileName, clumps, colNames)
+        # The segments already have the means of the first three bands.
+        for i in range(3):
+            means = rastergis.readRATColumn(clumps, colNames[i])
+            refMeans = rastergis.readRATColumn(clumps, 'b%dMean'%(i+1))
+            if not numpy.allclose(means[1:], refMeans[1:], rtol=1e-4):
+                raise Exception("The clump means of band %d differ from those of the RAT."%(i+1))
+
+    # Image calibration
+    def createBandImage(self, refImage, outputImage, data, noDataVal):
+        """ Write data to a single band float image with the size and position of refImage. """
+        refDS = gdal.Open(refImage)
+        outDS = gdal.GetDriverByName('KEA').Create(outputImage, refDS.RasterXSize, refDS.RasterYSize, 1, gdal.GDT_Float32)
+        outDS.SetGeoTransform(refDS.GetGeoTransform())
+        outDS.SetProjection(refDS.GetProjection())
+        outDS.GetRasterBand(1).SetNoDataValue(noDataVal)
+        outDS.GetRasterBand(1).WriteArray(data)
+        outDS = None
+
+    def testApply6SCoeffElevLUTFewerCoeffs(self):
+        print("PYTHON TEST: apply6SCoeffElevLUTParam with fewer coefficients than bands")
+        radData = gdal.Open(inFileName).ReadAsArray().astype(numpy.float64)
+        demImage = './TestOutputs/injune_p142_casi_sub_utm_dem.kea'
+        self.createBandImage(inFileName, demImage, numpy.tile(numpy.linspace(0, 1000, radData.shape[2]), (radData.shape[1], 1)), -9999)
+        # Coefficients for only 3 of the 14 bands; the same at both elevations so the
+        # interpolation gives the same reflectance.
+        Band6S = collections.namedtuple('Band6SCoeff', ['band', 'aX', 'bX', 'cX'])
+        LUTElev = collections.namedtuple('LUTElev', ['Elev', 'Coeffs'])
+        coeffs = [Band6S(band=b, aX=0.0001, bX=0.0, cX=0.0) for b in [1, 2, 3]]
+        lut = [LUTElev(Elev=0, Coeffs=coeffs), LUTElev(Elev=1000, Coeffs=coeffs)]
+        outputImage = './TestOutputs/injune_p142_casi_sub_utm_srefelev_3coeffs.kea'
+        imagecalibration.apply6SCoeffElevLUTParam(inFileName, demImage, outputImage, 'KEA', rsgislib.TYPE_32FLOAT, 1000, 0, True, lut)
+        outData = gdal.Open(outputImage).ReadAsArray().astype(numpy.float64)
+        # With a no data value of 0 the reflectances are offset by 1 (and at least 1).
+        refData = radData[:3] * 0.1
+        refData = numpy.minimum(numpy.where(refData < 1, 1.0, refData + 1.0), 1000)
+        refData[:, (radData == 0).all(axis=0)] = 0
+        if not numpy.allclose(outData[:3], refData, rtol=1e-5):
+            raise Exception("The bands with coefficients differ from the reference reflectances.")
+        if numpy.any(outData[3:] != 0):
+            raise Exception("The bands without coefficients are not 0.")
+
+    def testApply6SCoeffElevAOTLUTFewerCoeffs(self):
+        print("PYTHON TEST: apply6SCoeffElevAOTLUTParam with fewer coefficients than bands")
+        radData = gdal.Open(inFileName).ReadAsArray().astype(numpy.float64)
+        demImage = './TestOutputs/injune_p142_casi_sub_utm_dem_flat.kea'
+        self.createBandImage(inFileName, demImage, numpy.zeros(radData.shape[1:]), -9999)
+        # The left half of the image uses the AOT 0.1 entry and the right half the 0.5 entry.
+        aotData = numpy.full(radData.shape[1:], 0.1)
+        aotData[:, radData.shape[2]//2:] = 0.5
+        aotImage = './TestOutputs/injune_p142_casi_sub_utm_aot_halves.kea'
+        self.createBandImage(inFileName, aotImage, aotData, -9999)
+        # Each entry has its own number of coefficients, fewer than the 14 bands.
+        Band6S = collections.namedtuple('Band6SCoeff', ['band', 'aX', 'bX', 'cX'])
+        LUTElevAOT = collections.namedtuple('LUTElevAOT', ['Elev', 'AOT', 'Coeffs'])
+        lut = [LUTElevAOT(Elev=0, AOT=0.1, Coeffs=[Band6S(band=b, aX=0.0001, bX=0.0, cX=0.0) for b in range(1, 4)]),
+               LUTElevAOT(Elev=0, AOT=0.5, Coeffs=[Band6S(band=b, aX=0.0001, bX=0.0, cX=0.0) for b in range(1, 6)])]
+        outputImage = './TestOutputs/injune_p142_casi_sub_utm_srefaot_fewcoeffs.kea'
+        imagecalibration.apply6SCoeffElevAOTLUTParam(inFileName, demImage, aotImage, outputImage, 'KEA', rsgislib.TYPE_32FLOAT, 1000, 0, False, lut)
+        outData = gdal.Open(outputImage).ReadAsArray().astype(numpy.float64)
+        refData = numpy.zeros_like(radData)
+        refData[:5] = numpy.minimum(radData[:5] * 0.1, 1000)
+        refData[3:5, aotData < 0.3] = 0
+        if not numpy.allclose(outData, refData, rtol=1e-5):
+            raise Exception("The reflectances differ from the reference; the bands without coefficients should be 0.")
+
+    def testEstimateDarkTargetAOT(self):
+        print("PYTHON TEST: estimateDarkTargetAOT")
+        outputImage = './TestOutputs/injune_p142_casi_sub_utm_aot.kea'
+        # The test image is reflectance * 10000, so the LUT takes its values as
+        # radiance with an offset (path radiance) increasing with the AOT.
+        Band6S = collections.namedtuple('Band6SCoeff', ['band', 'aX', 'bX', 'cX'])
+        LUTElevAOT = collections.namedtuple('LUTElevAOT', ['Elev', 'AOT', 'Coeffs'])
+        aots = [0.05, 0.2, 0.5]
+        lut = [LUTElevAOT(Elev=0, AOT=aot, Coeffs=[Band6S(band=1, aX=0.0001, bX=aot*0.04, cX=0.0)]) for aot in aots]
+        aot = imagecalibration.estimateDarkTargetAOT(inFileName, '', outputImage, 'KEA', lut, 1, 50, 0.01, 0.01, 100, 0, True)
+        if (aot < aots[0]) or (aot > aots[-1]):
+            raise Exception("The AOT of the image is outside of the LUT: " + str(aot))
+
     # Tools
     def testMetres2Degrees(self):
         print(tools.metres_to_degrees(52,1,1))
@@ -898,6 +1472,7 @@ if __name__ == '__main__':
     parser = argparse.ArgumentParser()
     parser.add_argument("--all", action='store_true', default=False, help="Run all tests")
     parser.add_argument("--imagecalc", action='store_true', default=False, help="Run imagecalc tests")
+    parser.add_argument("--imagecalibration", action='store_true', default=False, help="Run imagecalibration tests")
     parser.add_argument("--imagefilter", action='store_true', default=False, help="Run imagefilter tests")
     parser.add_argument("--imageregistration", action='store_true', default=False, help="Run imageregistration tests")
     parser.add_argument("--imageutils", action='store_true', default=False, help="Run imageutils tests")
@@ -924,8 +1499,10 @@ if __name__ == '__main__':
         t.tryFuncAndCatch(t.testCalcRMSE)
         t.tryFuncAndCatch(t.testMeanVector)
         t.tryFuncAndCatch(t.testPCA)
+        t.tryFuncAndCatch(t.testCalcImagePCA)
         t.tryFuncAndCatch(t.testStandardise)
         t.tryFuncAndCatch(t.testBandMath)
+        t.tryFuncAndCatch(t.testBandMathPipeline)
         t.tryFuncAndCatch(t.testImageMaths)
         t.tryFuncAndCatch(t.testReplaceValuesLessThan)
         t.tryFuncAndCatch(t.testUnitArea)
@@ -951,7 +1528,13 @@ if __name__ == '__main__':
         t.tryFuncAndCatch(t.testMahalanobisDistImg2Window)
         t.tryFuncAndCatch(t.testCalcPxlColStats)
         t.tryFuncAndCatch(t.testCorrelationWindow)
+        t.tryFuncAndCatch(t.testCorrelationWindowBands)
+        t.tryFuncAndCatch(t.testIdentifyMinPxlValueInWin)
         t.tryFuncAndCatch(t.testImagePixelLinearFit)
+        t.tryFuncAndCatch(t.testImagePixelModelFit)
+        t.tryFuncAndCatch(t.testImagePixelRobustModelFit)
+        t.tryFuncAndCatch(t.testCalcImageBlocks)
+        t.tryFuncAndCatch(t.testCalcImageBlocksNumpy)
         
     if args.all or args.imageutils:
         
@@ -967,6 +1550,8 @@ if __name__ == '__main__':
         t.tryFuncAndCatch(t.testStackStats)
         t.tryFuncAndCatch(t.testCreateCopyImage)
         t.tryFuncAndCatch(t.testStretchImage)
+        t.tryFuncAndCatch(t.testStretchImagePercentiles)
+        t.tryFuncAndCatch(t.testImageFootprintIndex)
         t.tryFuncAndCatch(t.testSetBandNames)
         t.tryFuncAndCatch(t.testGetRSGISLibDataType)
         t.tryFuncAndCatch(t.testGetGDALDataType)
@@ -984,6 +1569,7 @@ if __name__ == '__main__':
         #t.tryFuncAndCatch(t.testFindSpecClose)
         t.tryFuncAndCatch(t.testPopulateRATWithStats)
         t.tryFuncAndCatch(t.testPopulateRATWithPercentiles)
+        t.tryFuncAndCatch(t.testReadWriteRATColumn)
         t.tryFuncAndCatch(t.testExport2Ascii)
         t.tryFuncAndCatch(t.testExportCol2GDALImage)
         t.tryFuncAndCatch(t.testExportCols2GDALImage)
@@ -1028,13 +1614,26 @@ if __name__ == '__main__':
     if args.all or args.imagefilter:
         """ Image filter functions """ 
         t.tryFuncAndCatch(t.testFilter)
+        t.tryFuncAndCatch(t.testGLCMTextures)
+        t.tryFuncAndCatch(t.testMedianModeFilters)
         #t.tryFuncAndCatch(t.testLeungMalikFilterBank) # Skip as it takes a while
     
     if args.all or args.segmentation:
         """ Image filter functions """ 
         t.tryFuncAndCatch(t.testUnionOfClumps)
         t.tryFuncAndCatch(t.testRunShepherdSegmentation)
-
+        t.tryFuncAndCatch(t.testHierarchicalSegmentation)
+        t.tryFuncAndCatch(t.testTiledSegmentation)
+        t.tryFuncAndCatch(t.testEliminateSinglePixels)
+        t.tryFuncAndCatch(t.testMeanImage)
+        t.tryFuncAndCatch(t.testClumpMeans2RAT)
+
+
+    if args.all or args.imagecalibration:
+        """ Image calibration functions """
+        t.tryFuncAndCatch(t.testApply6SCoeffElevLUTFewerCoeffs)
+        t.tryFuncAndCatch(t.testApply6SCoeffElevAOTLUTFewerCoeffs)
+        t.tryFuncAndCatch(t.testEstimateDarkTargetAOT)
 
     if args.all or args.tools:
         t.tryFuncAndCatch(t.testMetres2Degrees)    
@@ -110,6 +110,60 @@ namespace rsgis{namespace calib{
         
     }
     
+    void RSGISApply6SCoefficientsSingleParam::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        if(numValues != this->numOutBands)
+        {
+            throw rsgis::img::RSGISImageCalcException("The number of input image bands needs to be equal to the number of output image bands.");
+        }
+        
+        if(numBands != numValues)
+        {
+            throw rsgis::img::RSGISImageCalcException("The number of input values needs to be equal to the number of input image bands.");
+        }
+        
+        for(unsigned int i = 0; i < this->numValues; ++i)
+        {
+            if(imageBands[i] > numBands)
+            {
+                std::cout << "Image band: " << imageBands[i] << std::endl;
+                throw rsgis::img::RSGISImageCalcException("Image band is not within image.");
+            }
+            
+            const float *inPlane = bandPlanes[imageBands[i]];
+            double *outPlane = outPlanes[i];
+            const double a = aX[i];
+            const double b = bX[i];
+            const double c = cX[i];
+            double tmpVal = 0;
+            for(size_t j = 0; j < nPxls; ++j)
+            {
+                tmpVal = a*inPlane[j]-b;
+                outPlane[j] = (tmpVal/(1.0+c*tmpVal))*this->scaleFactor;
+                if(this->useNoDataVal & (this->noDataVal == 0.0))
+                {
+                    if(outPlane[j] < 1)
+                    {
+                        outPlane[j] = 1.0;
+                    }
+                    else
+                    {
+                        outPlane[j] = outPlane[j] + 1.0;
+                    }
+                }
+                if(outPlane[j] > this->scaleFactor)
+                {
+                    outPlane[j] = this->scaleFactor;
+                }
+            }
+        }
+        
+        if(this->useNoDataVal)
+        {
+            rsgisZeroOutputsWhereBandsEqual(bandPlanes, 0, numBands, this->noDataVal, nPxls, outPlanes, this->numValues);
+        }
+    }
+    
     RSGISApply6SCoefficientsSingleParam::~RSGISApply6SCoefficientsSingleParam()
     {
         
@@ -122,6 +176,7 @@ namespace rsgis{namespace calib{
         this->demNoDataVal = demNoDataVal;
         this->noDataVal = noDataVal;
         this->useNoDataVal = useNoDataVal;
+        this->numValues = 0;
         
         double minElev = 0;
         for(unsigned int i = 0; i < lut->size(); ++i)
@@ -130,12 +185,24 @@ namespace rsgis{namespace calib{
             {
                 minElev = lut->at(i).elev;
                 minElevCoeffs = lut->at(i);
+                this->numValues = lut->at(i).numValues;
             }
             else if(lut->at(i).elev < minElev)
             {
                 minElev = lut->at(i).elev;
                 minElevCoeffs = lut->at(i);
             }
+            
+            // Pixels are interpolated between two entries so the entries must have the same coefficients.
+            if(lut->at(i).numValues != this->numValues)
+            {
+                throw rsgis::img::RSGISImageCalcException("All the elevations of the LUT need the same number of coefficients.");
+            }
+        }
+        
+        if(this->numValues > this->numOutBands)
+        {
+            throw rsgis::img::RSGISImageCalcException("The LUT has more coefficients than there are output image bands.");
         }
     }
     
@@ -180,67 +247,17 @@ namespace rsgis{namespace calib{
         }
         else
         {
-            LUT6SElevation lutVal;
-            float dist = 0.0;
-            float minDist = 0.0;
             unsigned int lutIdx = 0;
-            
-            LUT6SElevation lutVal2;
             unsigned int lutIdx2 = 0;
-            
-            for(unsigned int i = 0; i < lut->size(); ++i)
-            {
-                dist = (lut->at(i).elev - elevVal) * (lut->at(i).elev - elevVal);
-                if(i == 0)
-                {
-                    minDist = dist;
-                    lutIdx = i;
-                }
-                else if(dist < minDist)
-                {
-                    minDist = dist;
-                    lutIdx = i;
-                }
-            }
-            lutVal = lut->at(lutIdx);
-            
-            
-            float elevLUTDiff = 0.0;
-            float elevLUTDiff1 = 0.0;
-            float elevLUTDiff2 = 0.0;
-            
             float elevProp1 = 0.0;
             float elevProp2 = 0.0;
+            this->findElevLUTPair(elevVal, &lutIdx, &lutIdx2, &elevProp1, &elevProp2);
             
+            LUT6SElevation lutVal = lut->at(lutIdx);
+            LUT6SElevation lutVal2;
             if(lut->size() > 1)
             {
-                if(lutIdx == 0)
-                {
-                    lutIdx2 = 1;
-                }
-                else if(lutIdx == (lut->size()-1))
-                {
-                    lutIdx2 = lutIdx-1;
-                }
-                else
-                {
-                    if((elevVal - lut->at(lutIdx).elev) < 0)
-                    {
-                        lutIdx2 = lutIdx-1;
-                    }
-                    else
-                    {
-                        lutIdx2 = lutIdx+1;
-                    }
-                }
                 lutVal2 = lut->at(lutIdx2);
-                
-                elevLUTDiff = fabs(lutVal.elev - lutVal2.elev);
-                elevLUTDiff1 = fabs(elevVal - lutVal.elev);
-                elevLUTDiff2 = fabs(elevVal - lutVal2.elev);
-                
-                elevProp1 = 1-(elevLUTDiff1/elevLUTDiff);
-                elevProp2 = 1-(elevLUTDiff2/elevLUTDiff);
             }
             
             double tmpVal = 0;
@@ -287,10 +304,176 @@ namespace rsgis{namespace calib{
                     output[i] = this->scaleFactor;
                 }
             }
+            
+            // Output bands without coefficients are 0.
+            for(unsigned int i = lutVal.numValues; i < this->numOutBands; ++i)
+            {
+                output[i] = 0;
+            }
         }
         
     }
     
+    void RSGISApply6SCoefficientsElevLUTParam::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        if(numBands-1 != this->numOutBands)
+        {
+            throw rsgis::img::RSGISImageCalcException("The number of input image bands needs to be equal to the number of output image bands.");
+        }
+        
+        // Find the LUT entries and weights for each pixel once, reusing them while
+        // the elevation is unchanged (as it often is along a row), then apply the
+        // coefficients band by band.
+        std::vector<unsigned int> lutIdxs(nPxls);
+        std::vector<unsigned int> lutIdxs2(nPxls);
+        std::vector<float> elevProps1(nPxls);
+        std::vector<float> elevProps2(nPxls);
+        unsigned int lutIdx = 0;
+        unsigned int lutIdx2 = 0;
+        float elevProp1 = 0.0;
+        float elevProp2 = 0.0;
+        float prevElevVal = 0.0;
+        bool first = true;
+        for(size_t j = 0; j < nPxls; ++j)
+        {
+            float elevVal = bandPlanes[0][j];
+            if(elevVal == demNoDataVal)
+            {
+                elevVal = minElevCoeffs.elev;
+            }
+            if(first || (elevVal != prevElevVal))
+            {
+                this->findElevLUTPair(elevVal, &lutIdx, &lutIdx2, &elevProp1, &elevProp2);
+                prevElevVal = elevVal;
+                first = false;
+            }
+            lutIdxs[j] = lutIdx;
+            lutIdxs2[j] = lutIdx2;
+            elevProps1[j] = elevProp1;
+            elevProps2[j] = elevProp2;
+        }
+        
+        for(std::vector<LUT6SElevation>::iterator iterLUT = lut->begin(); iterLUT != lut->end(); ++iterLUT)
+        {
+            for(unsigned int i = 0; i < (*iterLUT).numValues; ++i)
+            {
+                if((*iterLUT).imageBands[i] > numBands)
+                {
+                    std::cout << "Image band: " << (*iterLUT).imageBands[i] << std::endl;
+                    throw rsgis::img::RSGISImageCalcException("Image band is not within image.");
+                }
+            }
+        }
+        
+        const bool interpolate = lut->size() > 1;
+        double tmpVal = 0;
+        double reflVal1 = 0.0;
+        double reflVal2 = 0.0;
+        for(unsigned int i = 0; i < this->numValues; ++i)
+        {
+            double *outPlane = outPlanes[i];
+            for(size_t j = 0; j < nPxls; ++j)
+            {
+                const LUT6SElevation &lutVal = (*lut)[lutIdxs[j]];
+                tmpVal=lutVal.aX[i]*bandPlanes[lutVal.imageBands[i]][j]-lutVal.bX[i];
+                reflVal1 = (tmpVal/(1.0+lutVal.cX[i]*tmpVal))*this->scaleFactor;
+                if(interpolate)
+                {
+                    const LUT6SElevation &lutVal2 = (*lut)[lutIdxs2[j]];
+                    tmpVal=lutVal2.aX[i]*bandPlanes[lutVal2.imageBands[i]][j]-lutVal2.bX[i];
+                    reflVal2 = (tmpVal/(1.0+lutVal2.cX[i]*tmpVal))*this->scaleFactor;
+                    outPlane[j] = (reflVal1*elevProps1[j]) + (reflVal2*elevProps2[j]);
+                }
+                else
+                {
+                    outPlane[j] = reflVal1;
+                }
+                if(this->useNoDataVal & (this->noDataVal == 0.0))
+                {
+                    if(outPlane[j] < 1)
+                    {
+                        outPlane[j] = 1.0;
+                    }
+                    else
+                    {
+                        outPlane[j] = outPlane[j] + 1.0;
+                    }
+                }
+                if(outPlane[j] > this->scaleFactor)
+                {
+                    outPlane[j] = this->scaleFactor;
+                }
+            }
+        }
+        
+        
+        // Output bands without coefficients are 0, as for calcImageValue.
+        for(unsigned int i = this->numValues; i < this->numOutBands; ++i)
+        {
+            std::fill(outPlanes[i], outPlanes[i] + nPxls, 0.0);
+        }
+        
+        if(this->useNoDataVal)
+        {
+            rsgisZeroOutputsWhereBandsEqual(bandPlanes, 1, numBands, this->noDataVal, nPxls, outPlanes, this->numOutBands);
+        }
+    }
+    
+    void RSGISApply6SCoefficientsElevLUTParam::findElevLUTPair(float elevVal, unsigned int *lutIdx, unsigned int *lutIdx2, float *elevProp1, float *elevProp2)
+    {
+        float dist = 0.0;
+        float minDist = 0.0;
+        *lutIdx = 0;
+        *lutIdx2 = 0;
+        *elevProp1 = 0.0;
+        *elevProp2 = 0.0;
+        
+        for(unsigned int i = 0; i < lut->size(); ++i)
+        {
+            dist = (lut->at(i).elev - elevVal) * (lut->at(i).elev - elevVal);
+            if(i == 0)
+            {
+                minDist = dist;
+                *lutIdx = i;
+            }
+            else if(dist < minDist)
+            {
+                minDist = dist;
+                *lutIdx = i;
+            }
+        }
+        
+        if(lut->size() > 1)
+        {
+            if(*lutIdx == 0)
+            {
+                *lutIdx2 = 1;
+            }
+            else if(*lutIdx == (lut->size()-1))
+            {
+                *lutIdx2 = *lutIdx-1;
+            }
+            else
+            {
+                if((elevVal - lut->at(*lutIdx).elev) < 0)
+                {
+                    *lutIdx2 = *lutIdx-1;
+                }
+                else
+                {
+                    *lutIdx2 = *lutIdx+1;
+                }
+            }
+            
+            float elevLUTDiff = fabs(lut->at(*lutIdx).elev - lut->at(*lutIdx2).elev);
+            float elevLUTDiff1 = fabs(elevVal - lut->at(*lutIdx).elev);
+            float elevLUTDiff2 = fabs(elevVal - lut->at(*lutIdx2).elev);
+            
+            *elevProp1 = 1-(elevLUTDiff1/elevLUTDiff);
+            *elevProp2 = 1-(elevLUTDiff2/elevLUTDiff);
+        }
+    }
+    
     RSGISApply6SCoefficientsElevLUTParam::~RSGISApply6SCoefficientsElevLUTParam()
     {
         
@@ -299,12 +482,50 @@ namespace rsgis{namespace calib{
     
     
     
-    RSGISApply6SCoefficientsElevAOTLUTParam::RSGISApply6SCoefficientsElevAOTLUTParam(unsigned int numOutBands, std::vector<LUT6SBaseElevAOT> *lut, float noDataVal, bool useNoDataVal, float scaleFactor):rsgis::img::RSGISCalcImageValue(numOutBands)
+    RSGISApply6SCoefficientsElevAOTLUTParam::RSGISApply6SCoefficientsElevAOTLUTParam(unsigned int numOutBands, std::vector<LUT6SBaseElevAOT> *lut, float noDataVal, bool useNoDataVal, float scaleFactor, float elevQuantStep):rsgis::img::RSGISCalcImageValue(numOutBands)
     {
 		this->lut = lut;
         this->scaleFactor = scaleFactor;
         this->noDataVal = noDataVal;
         this->useNoDataVal = useNoDataVal;
+        this->elevQuantStep = 0.0;
+        this->elevQuantMin = 0.0;
+        
+        for(std::vector<LUT6SBaseElevAOT>::iterator iterLUT = lut->begin(); iterLUT != lut->end(); ++iterLUT)
+        {
+            for(std::vector<LUT6SAOT>::iterator iterAOTLUT = (*iterLUT).aotLUT.begin(); iterAOTLUT != (*iterLUT).aotLUT.end(); ++iterAOTLUT)
+            {
+                if((*iterAOTLUT).numValues > this->numOutBands)
+                {
+                    throw rsgis::img::RSGISImageCalcException("The LUT has more coefficients than there are output image bands.");
+                }
+            }
+        }
+        
+        if((elevQuantStep > 0) && (lut->size() > 0))
+        {
+            float minElev = lut->at(0).elev;
+            float maxElev = lut->at(0).elev;
+            for(std::vector<LUT6SBaseElevAOT>::iterator iterLUT = lut->begin(); iterLUT != lut->end(); ++iterLUT)
+            {
+                minElev = std::min(minElev, (*iterLUT).elev);
+                maxElev = std::max(maxElev, (*iterLUT).elev);
+            }
+            double numSteps = floor((maxElev - minElev) / elevQuantStep) + 2;
+            if(numSteps > 10000000)
+            {
+                throw rsgis::img::RSGISImageCalcException("The elevation quantisation step is too small for the range of the LUT.");
+            }
+            
+            // Elevations outside of the LUT range are clamped to the end steps, which map to the end entries.
+            this->elevQuantStep = elevQuantStep;
+            this->elevQuantMin = minElev;
+            this->elevQuantLUTIdxs.resize((size_t)numSteps);
+            for(size_t i = 0; i < this->elevQuantLUTIdxs.size(); ++i)
+            {
+                this->elevQuantLUTIdxs[i] = this->findElevLUTIdx(minElev + (i * elevQuantStep));
+            }
+        }
     }
     
     void RSGISApply6SCoefficientsElevAOTLUTParam::calcImageValue(float *bandValues, int numBands, double *output) 
@@ -346,95 +567,200 @@ namespace rsgis{namespace calib{
         }
         else
         {
-            LUT6SBaseElevAOT elevLUTVal;
-            unsigned int elevLUTIdx = 0;
-            float dist = 0.0;
-            float minDist = 0.0;
-                        
-            for(unsigned int i = 0; i < lut->size(); ++i)
+            unsigned int elevLUTIdx = this->getElevLUTIdx(elevVal);
+            const LUT6SAOT &aotLUTVal = lut->at(elevLUTIdx).aotLUT.at(this->findAOTLUTIdx(elevLUTIdx, aotVal));
+            
+            for(unsigned int i = 0; i < aotLUTVal.numValues; ++i)
             {
-                dist = (lut->at(i).elev - elevVal) * (lut->at(i).elev - elevVal);
-                if(i == 0)
+                if(aotLUTVal.imageBands[i] > numBands)
                 {
-                    minDist = dist;
-                    elevLUTIdx = i;
+                    std::cout << "Image band: " << aotLUTVal.imageBands[i] << std::endl;
+                    throw rsgis::img::RSGISImageCalcException("Image band is not within image.");
                 }
-                else if(dist < minDist)
+                
+                tmpVal=aotLUTVal.aX[i]*bandValues[aotLUTVal.imageBands[i]]-aotLUTVal.bX[i];
+                output[i] = (tmpVal/(1.0+aotLUTVal.cX[i]*tmpVal))*this->scaleFactor;
+
+                if(this->useNoDataVal & (this->noDataVal == 0.0))
                 {
-                    minDist = dist;
-                    elevLUTIdx = i;
+                    if(output[i] < 1)
+                    {
+                        output[i] = 1.0;
+                    }
+                    else
+                    {
+                        output[i] = output[i] + 1.0;
+                    }
+                }
+                if(output[i] > this->scaleFactor)
+                {
+                    output[i] = this->scaleFactor;
                 }
             }
             
-            if(elevLUTIdx >= lut->size())
+            // Output bands without coefficients are 0.
+            for(unsigned int i = aotLUTVal.numValues; i < this->numOutBands; ++i)
             {
-                std::cerr << "elevVal = " << elevVal << std::endl;
-                std::cerr << "elevLUTIdx = " << elevLUTIdx << std::endl;
-                std::cerr << "lut->size() = " << lut->size() << std::endl;
-                
-                throw rsgis::img::RSGISImageCalcException("Elevation value is not within the LUT.");
+                output[i] = 0;
             }
-            
-            elevLUTVal = lut->at(elevLUTIdx);
-            
-            LUT6SAOT aotLUTVal;
-            unsigned int aotLUTIdx = 0;
-            
-            for(unsigned int i = 0; i < elevLUTVal.aotLUT.size(); ++i)
+        }
+        
+    }
+    
+    void RSGISApply6SCoefficientsElevAOTLUTParam::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        if(numBands-2 != this->numOutBands)
+        {
+            throw rsgis::img::RSGISImageCalcException("The number of input image bands needs to be equal to the number of output image bands.");
+        }
+        
+        for(std::vector<LUT6SBaseElevAOT>::iterator iterLUT = lut->begin(); iterLUT != lut->end(); ++iterLUT)
+        {
+            for(std::vector<LUT6SAOT>::iterator iterAOTLUT = (*iterLUT).aotLUT.begin(); iterAOTLUT != (*iterLUT).aotLUT.end(); ++iterAOTLUT)
             {
-                dist = (elevLUTVal.aotLUT.at(i).aot - aotVal) * (elevLUTVal.aotLUT.at(i).aot - aotVal);
-                if(i == 0)
+                for(unsigned int i = 0; i < (*iterAOTLUT).numValues; ++i)
                 {
-                    minDist = dist;
-                    aotLUTIdx = i;
-                }
-                else if(dist < minDist)
-                {
-                    minDist = dist;
-                    aotLUTIdx = i;
+                    if((*iterAOTLUT).imageBands[i] > numBands)
+                    {
+                        std::cout << "Image band: " << (*iterAOTLUT).imageBands[i] << std::endl;
+                        throw rsgis::img::RSGISImageCalcException("Image band is not within image.");
+                    }
                 }
             }
-                        
-            if(aotLUTIdx >= elevLUTVal.aotLUT.size())
+        }
+        
+        // Neighbouring pixels nearly always share the same LUT entry so the
+        // entry is only searched for when the elevation or AOT changes.
+        std::vector<const LUT6SAOT*> pxlLUTVals(nPxls);
+        const LUT6SAOT *aotLUTVal = NULL;
+        float prevElevVal = 0.0;
+        float prevAOTVal = 0.0;
+        for(size_t j = 0; j < nPxls; ++j)
+        {
+            const float elevVal = bandPlanes[0][j];
+            const float aotVal = bandPlanes[1][j];
+            if((aotLUTVal == NULL) || (elevVal != prevElevVal) || (aotVal != prevAOTVal))
             {
-                std::cerr << "aotVal = " << aotVal << std::endl;
-                std::cerr << "aotLUTIdx = " << aotLUTIdx << std::endl;
-                std::cerr << "elevLUTVal.aotLUT.size() = " << elevLUTVal.aotLUT.size() << std::endl;
-                
-                throw rsgis::img::RSGISImageCalcException("AOT value is not within the LUT.");
+                unsigned int elevLUTIdx = this->getElevLUTIdx(elevVal);
+                aotLUTVal = &lut->at(elevLUTIdx).aotLUT.at(this->findAOTLUTIdx(elevLUTIdx, aotVal));
+                prevElevVal = elevVal;
+                prevAOTVal = aotVal;
             }
-            
-            aotLUTVal = elevLUTVal.aotLUT.at(aotLUTIdx);
-            
-            for(unsigned int i = 0; i < aotLUTVal.numValues; ++i)
+            pxlLUTVals[j] = aotLUTVal;
+        }
+        
+        double tmpVal = 0;
+        for(unsigned int i = 0; i < this->numOutBands; ++i)
+        {
+            double *outPlane = outPlanes[i];
+            for(size_t j = 0; j < nPxls; ++j)
             {
-                if(aotLUTVal.imageBands[i] > numBands)
+                // Each entry has its own number of coefficients; the bands without are 0, as for calcImageValue.
+                const LUT6SAOT *pxlLUTVal = pxlLUTVals[j];
+                if(i >= pxlLUTVal->numValues)
                 {
-                    std::cout << "Image band: " << aotLUTVal.imageBands[i] << std::endl;
-                    throw rsgis::img::RSGISImageCalcException("Image band is not within image.");
+                    outPlane[j] = 0;
+                    continue;
                 }
+                tmpVal=pxlLUTVal->aX[i]*bandPlanes[pxlLUTVal->imageBands[i]][j]-pxlLUTVal->bX[i];
+                outPlane[j] = (tmpVal/(1.0+pxlLUTVal->cX[i]*tmpVal))*this->scaleFactor;
                 
-                tmpVal=aotLUTVal.aX[i]*bandValues[aotLUTVal.imageBands[i]]-aotLUTVal.bX[i];
-                output[i] = (tmpVal/(1.0+aotLUTVal.cX[i]*tmpVal))*this->scaleFactor;
-
                 if(this->useNoDataVal & (this->noDataVal == 0.0))
                 {
-                    if(output[i] < 1)
+                    if(outPlane[j] < 1)
                     {
-                        output[i] = 1.0;
+                        outPlane[j] = 1.0;
                     }
                     else
                     {
-                        output[i] = output[i] + 1.0;
+                        outPlane[j] = outPlane[j] + 1.0;
                     }
                 }
-                if(output[i] > this->scaleFactor)
+                if(outPlane[j] > this->scaleFactor)
                 {
-                    output[i] = this->scaleFactor;
+                    outPlane[j] = this->scaleFactor;
                 }
             }
         }
         
+        if(this->useNoDataVal)
+        {
+            rsgisZeroOutputsWhereBandsEqual(bandPlanes, 2, numBands, this->noDataVal, nPxls, outPlanes, this->numOutBands);
+        }
+    }
+    
+    unsigned int RSGISApply6SCoefficientsElevAOTLUTParam::findElevLUTIdx(float elevVal)
+    {
+        if(lut->empty())
+        {
+            throw rsgis::img::RSGISImageCalcException("Elevation value is not within the LUT.");
+        }
+        
+        unsigned int elevLUTIdx = 0;
+        float dist = 0.0;
+        float minDist = 0.0;
+        for(unsigned int i = 0; i < lut->size(); ++i)
+        {
+            dist = ((*lut)[i].elev - elevVal) * ((*lut)[i].elev - elevVal);
+            if(i == 0)
+            {
+                minDist = dist;
+                elevLUTIdx = i;
+            }
+            else if(dist < minDist)
+            {
+                minDist = dist;
+                elevLUTIdx = i;
+            }
+        }
+        return elevLUTIdx;
+    }
+    
+    unsigned int RSGISApply6SCoefficientsElevAOTLUTParam::findAOTLUTIdx(unsigned int elevLUTIdx, float aotVal)
+    {
+        const std::vector<LUT6SAOT> &aotLUT = (*lut)[elevLUTIdx].aotLUT;
+        if(aotLUT.empty())
+        {
+            std::cerr << "elevLUTIdx = " << elevLUTIdx << std::endl;
+            throw rsgis::img::RSGISImageCalcException("AOT value is not within the LUT.");
+        }
+        
+        unsigned int aotLUTIdx = 0;
+        float dist = 0.0;
+        float minDist = 0.0;
+        for(unsigned int i = 0; i < aotLUT.size(); ++i)
+        {
+            dist = (aotLUT[i].aot - aotVal) * (aotLUT[i].aot - aotVal);
+            if(i == 0)
+            {
+                minDist = dist;
+                aotLUTIdx = i;
+            }
+            else if(dist < minDist)
+            {
+                minDist = dist;
+                aotLUTIdx = i;
+            }
+        }
+        return aotLUTIdx;
+    }
+    
+    unsigned int RSGISApply6SCoefficientsElevAOTLUTParam::getElevLUTIdx(float elevVal)
+    {
+        if(this->elevQuantStep > 0)
+        {
+            double step = floor(((elevVal - this->elevQuantMin) / this->elevQuantStep) + 0.5);
+            if(!(step > 0))
+            {
+                return this->elevQuantLUTIdxs.front();
+            }
+            else if(step >= this->elevQuantLUTIdxs.size())
+            {
+                return this->elevQuantLUTIdxs.back();
+            }
+            return this->elevQuantLUTIdxs[(size_t)step];
+        }
+        return this->findElevLUTIdx(elevVal);
     }
     
     RSGISApply6SCoefficientsElevAOTLUTParam::~RSGISApply6SCoefficientsElevAOTLUTParam()
@@ -526,6 +852,84 @@ namespace rsgis{namespace calib{
         }
 
     }
+    
+    void RSGISApply6SCoefficients::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        if(numValues != this->numOutBands)
+        {
+            throw rsgis::img::RSGISImageCalcException("The number of input image bands needs to be equal to the number of output image bands.");
+        }
+        
+        if(numBands <= numValues)
+        {
+            throw rsgis::img::RSGISImageCalcException("The number of input values needs to be equal to or less than the number of input image bands.");
+        }
+        
+        for(unsigned int i = 0; i < this->numValues; ++i)
+        {
+            if(imageBands[i]+bandOffset > numBands)
+            {
+                std::cout << "Image band: " << imageBands[i] << std::endl;
+                throw rsgis::img::RSGISImageCalcException("Image band is not within image.");
+            }
+        }
+        
+        if(this->useTopo6S)
+        {
+            // The elevation band selects the coefficients per pixel.
+            std::vector<unsigned int> elvs(nPxls, 0);
+            for(size_t j = 0; j < nPxls; ++j)
+            {
+                // Round to nearest 50 m
+                double elevationScale = bandPlanes[0][j] / 100.0;
+                elevationScale = int(elevationScale + 0.5);
+                int elevationInt = elevationScale * 100;
+                
+                if(elevationInt >= this->elevationThresh[0])
+                {
+                    for(unsigned int d = 1; d < numElevation; ++d)
+                    {
+                        if((elevationInt >= this->elevationThresh[d - 1]) && (elevationInt < this->elevationThresh[d]))
+                        {
+                            elvs[j] = d;
+                        }
+                    }
+                }
+            }
+            
+            double tmpVal = 0;
+            for(unsigned int i = 0; i < this->numValues; ++i)
+            {
+                const float *inPlane = bandPlanes[imageBands[i]+bandOffset];
+                double *outPlane = outPlanes[i];
+                for(size_t j = 0; j < nPxls; ++j)
+                {
+                    tmpVal=aX[i][elvs[j]]*inPlane[j]-bX[i][elvs[j]];
+                    outPlane[j] = (tmpVal/(1.0+cX[i][elvs[j]]*tmpVal))*this->scaleFactor;
+                }
+            }
+        }
+        else
+        {
+            for(unsigned int i = 0; i < this->numValues; ++i)
+            {
+                const float *inPlane = bandPlanes[imageBands[i]];
+                double *outPlane = outPlanes[i];
+                const double a = aX[i][0];
+                const double b = bX[i][0];
+                const double c = cX[i][0];
+                double tmpVal = 0;
+                for(size_t j = 0; j < nPxls; ++j)
+                {
+                    tmpVal = a*inPlane[j]-b;
+                    outPlane[j] = (tmpVal/(1.0+c*tmpVal))*this->scaleFactor;
+                }
+            }
+        }
+        
+        // If first band == 0, assume image border
+        rsgisZeroOutputsWhereBandsEqual(bandPlanes, this->bandOffset, this->bandOffset+1, 0, nPxls, outPlanes, this->numValues);
+    }
         
     RSGISApply6SCoefficients::~RSGISApply6SCoefficients()
     {
@@ -29,6 +29,9 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <math.h>
 
 #include "gdal_priv.h"
 
@@ -37,6 +40,8 @@
 #include "img/RSGISCalcImageValue.h"
 #include "img/RSGISCalcImage.h"
 
+#include "calibration/RSGISStandardDN2RadianceCalibration.h"
+
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
 #undef DllExport
@@ -90,6 +95,8 @@ namespace rsgis{namespace calib{
     public: 
         RSGISApply6SCoefficientsSingleParam(unsigned int *imageBands, float *aX, float *bX, float *cX, int numValues, float noDataVal = 0.0, bool useNoDataVal=false, float scaleFactor = 1.0);
         void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        bool isThreadSafe(){return true;};
         void calcImageValue(float *bandValues, int numBands) {throw rsgis::img::RSGISImageCalcException("Not implmented.");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
@@ -118,6 +125,8 @@ namespace rsgis{namespace calib{
     public:
         RSGISApply6SCoefficientsElevLUTParam(unsigned int numOutBands, std::vector<LUT6SElevation> *lut, float demNoDataVal, float noDataVal = 0.0, bool useNoDataVal=false, float scaleFactor = 1.0);
         void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        bool isThreadSafe(){return true;};
         void calcImageValue(float *bandValues, int numBands) {throw rsgis::img::RSGISImageCalcException("Not implmented.");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
@@ -129,20 +138,31 @@ namespace rsgis{namespace calib{
         bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw rsgis::img::RSGISImageCalcException("Not implmented.");};
         ~RSGISApply6SCoefficientsElevLUTParam();
     protected:
+        /** Find the nearest LUT entry to the elevation and the neighbouring entry used to interpolate between them. */
+        void findElevLUTPair(float elevVal, unsigned int *lutIdx, unsigned int *lutIdx2, float *elevProp1, float *elevProp2);
         std::vector<LUT6SElevation> *lut;
         LUT6SElevation minElevCoeffs;
         float scaleFactor;
         float demNoDataVal;
         float noDataVal;
         bool useNoDataVal;
+        /** The number of coefficients of each LUT entry */
+        unsigned int numValues;
     };
     
     
     class DllExport RSGISApply6SCoefficientsElevAOTLUTParam : public rsgis::img::RSGISCalcImageValue
     {
     public:
-        RSGISApply6SCoefficientsElevAOTLUTParam(unsigned int numOutBands, std::vector<LUT6SBaseElevAOT> *lut, float noDataVal = 0.0, bool useNoDataVal=false, float scaleFactor = 1.0);
+        /**
+         * If elevQuantStep is greater than 0 the elevations are quantised to that step and
+         * the nearest elevation LUT entry for each step is precomputed, so the lookup is an
+         * index calculation. Otherwise the nearest entry to the exact elevation is used.
+         */
+        RSGISApply6SCoefficientsElevAOTLUTParam(unsigned int numOutBands, std::vector<LUT6SBaseElevAOT> *lut, float noDataVal = 0.0, bool useNoDataVal=false, float scaleFactor = 1.0, float elevQuantStep = 0.0);
         void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        bool isThreadSafe(){return true;};
         void calcImageValue(float *bandValues, int numBands) {throw rsgis::img::RSGISImageCalcException("Not implmented.");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
@@ -154,10 +174,16 @@ namespace rsgis{namespace calib{
         bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw rsgis::img::RSGISImageCalcException("Not implmented.");};
         ~RSGISApply6SCoefficientsElevAOTLUTParam();
     protected:
+        unsigned int findElevLUTIdx(float elevVal);
+        unsigned int findAOTLUTIdx(unsigned int elevLUTIdx, float aotVal);
+        unsigned int getElevLUTIdx(float elevVal);
         std::vector<LUT6SBaseElevAOT> *lut;
         float scaleFactor;
         float noDataVal;
         bool useNoDataVal;
+        float elevQuantStep;
+        float elevQuantMin;
+        std::vector<unsigned int> elevQuantLUTIdxs;
     };
     
     
@@ -190,6 +216,8 @@ namespace rsgis{namespace calib{
     public:
         RSGISApply6SCoefficients(int numberOutBands, unsigned int *imageBands, float **aX, float **bX, float **cX, int numValues, float *elevationThresh = NULL, int numElevation = 0, float scaleFactor = 1.0);
         void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        bool isThreadSafe(){return true;};
         void calcImageValue(float *bandValues, int numBands) {throw rsgis::img::RSGISImageCalcException("Not implmented.");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
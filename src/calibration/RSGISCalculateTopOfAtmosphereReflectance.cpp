@@ -47,6 +47,27 @@ namespace rsgis{namespace calib{
         }
     }
     
+    void RSGISCalculateTopOfAtmosphereReflectance::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        if(numBands != this->numOutBands)
+        {
+            throw rsgis::img::RSGISImageCalcException("The number of input and output image bands needs to be the same.");
+        }
+        
+        // The solar geometry, distance and scale are folded into a single factor per band.
+        const double cosSolarZen = cos(solarZenith);
+        for(int i = 0; i < this->numOutBands; ++i)
+        {
+            const float *inPlane = bandPlanes[i];
+            double *outPlane = outPlanes[i];
+            const double factor = ((M_PI * distSq)/(solarIrradiance[i] * cosSolarZen)) * this->scaleFactor;
+            for(size_t j = 0; j < nPxls; ++j)
+            {
+                outPlane[j] = inPlane[j] * factor;
+            }
+        }
+    }
+    
     RSGISCalculateTopOfAtmosphereReflectance::~RSGISCalculateTopOfAtmosphereReflectance()
     {
         
@@ -86,6 +107,33 @@ namespace rsgis{namespace calib{
         
     }
     
+    void RSGISCalculateTOAThermalBrightness::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        if(numBands != this->numOutBands)
+        {
+            throw rsgis::img::RSGISImageCalcException("The number of input and output image bands needs to be the same.");
+        }
+        
+        for(int i = 0; i < numBands; ++i)
+        {
+            const float *inPlane = bandPlanes[i];
+            double *outPlane = outPlanes[i];
+            const double bandK1 = k1[i];
+            const double bandK2 = k2[i];
+            for(size_t j = 0; j < nPxls; ++j)
+            {
+                if(inPlane[j] != 0.0)
+                {
+                    outPlane[j] = ((bandK2 / log((bandK1 / inPlane[j]) + 1.0)) - 273.15) * this->scaleFactor;
+                }
+                else
+                {
+                    outPlane[j] = 0.0;
+                }
+            }
+        }
+    }
+    
     RSGISCalculateTOAThermalBrightness::~RSGISCalculateTOAThermalBrightness()
     {
         
@@ -117,6 +165,26 @@ namespace rsgis{namespace calib{
         }
     }
     
+    void RSGISCalculateRadianceFromTOAReflectance::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        if(numBands != this->numOutBands)
+        {
+            throw rsgis::img::RSGISImageCalcException("The number of input and output image bands needs to be the same.");
+        }
+        
+        const double cosSolarZen = cos(solarZenith);
+        for(int i = 0; i < this->numOutBands; ++i)
+        {
+            const float *inPlane = bandPlanes[i];
+            double *outPlane = outPlanes[i];
+            const double factor = (solarIrradiance[i] * cosSolarZen) / (M_PI * distSq * scaleFactor);
+            for(size_t j = 0; j < nPxls; ++j)
+            {
+                outPlane[j] = inPlane[j] * factor;
+            }
+        }
+    }
+    
     RSGISCalculateRadianceFromTOAReflectance::~RSGISCalculateRadianceFromTOAReflectance()
     {
         
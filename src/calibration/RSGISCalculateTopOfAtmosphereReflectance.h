@@ -101,6 +101,8 @@ namespace rsgis{namespace calib{
     public: 
         RSGISCalculateTopOfAtmosphereReflectance(int numberOutBands, float *solarIrradiance, double distance, float solarZenith, float scaleFactor = 1);
         void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        bool isThreadSafe(){return true;};
         void calcImageValue(float *bandValues, int numBands) {throw rsgis::img::RSGISImageCalcException("Not implmented.");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
@@ -124,6 +126,8 @@ namespace rsgis{namespace calib{
     public:
         RSGISCalculateTOAThermalBrightness(int numberOutBands, float *k1, float *k2, float scaleFactor = 1);
         void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        bool isThreadSafe(){return true;};
         void calcImageValue(float *bandValues, int numBands) {throw rsgis::img::RSGISImageCalcException("Not implmented.");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
@@ -146,6 +150,8 @@ namespace rsgis{namespace calib{
     public:
         RSGISCalculateRadianceFromTOAReflectance(int numberOutBands, float *solarIrradiance, double distance, float solarZenith, float scaleFactor = 1);
         void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        bool isThreadSafe(){return true;};
         void calcImageValue(float *bandValues, int numBands) {throw rsgis::img::RSGISImageCalcException("Not implmented.");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
@@ -297,12 +297,385 @@ namespace rsgis{namespace calib{
         }
     }
     
+    void RSGISLandsatFMaskPass1CloudMasking::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        // calcImageValue edits the band values in place so a per-pixel copy is
+        // still required but the per-pixel kernel is called non-virtually.
+        float *inDataColumn = new float[numBands];
+        double *outDataColumn = new double[this->numOutBands];
+        for(size_t i = 0; i < nPxls; ++i)
+        {
+            for(int n = 0; n < numBands; ++n)
+            {
+                inDataColumn[n] = bandPlanes[n][i];
+            }
+            
+            this->RSGISLandsatFMaskPass1CloudMasking::calcImageValue(inDataColumn, numBands, outDataColumn);
+            
+            for(int n = 0; n < this->numOutBands; ++n)
+            {
+                outPlanes[n][i] = outDataColumn[n];
+            }
+        }
+        delete[] inDataColumn;
+        delete[] outDataColumn;
+    }
+    
     RSGISLandsatFMaskPass1CloudMasking::~RSGISLandsatFMaskPass1CloudMasking()
     {
         
     }
     
     
+    RSGISLandsatFMaskFusedPasses::RSGISLandsatFMaskFusedPasses(unsigned int scaleFactor, unsigned int numLSBands, double whitenessThreshold)
+    {
+        this->scaleFactor = scaleFactor;
+        this->numLSBands = numLSBands;
+        this->pass1 = new RSGISLandsatFMaskPass1CloudMasking(scaleFactor, numLSBands, whitenessThreshold);
+        
+        if(numLSBands == 9)
+        {
+            this->nirIdx = 4;
+            this->swir1Idx = 5;
+            this->therm1Idx = 7;
+        }
+        else
+        {
+            this->nirIdx = 3;
+            this->swir1Idx = 4;
+            this->therm1Idx = 6;
+        }
+        
+        this->tileRows = 256;
+        this->numThreads = rsgis::utils::getNumThreads();
+        
+        this->width = 0;
+        this->height = 0;
+        this->numValidPxls = 0.0;
+        this->numPCPPxls = 0.0;
+        this->lowerWaterThres = 0.0;
+        this->upperWaterThres = 0.0;
+        this->lowerLandThres = 0.0;
+        this->upperLandThres = 0.0;
+        this->landCloudProbUpperThres = 0.0;
+        this->waterCloudProbUpperThres = 0.0;
+        this->landNIRLower = 0.0;
+        this->landSWIRLower = 0.0;
+    }
+    
+    void RSGISLandsatFMaskFusedPasses::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+    
+    void RSGISLandsatFMaskFusedPasses::runTiles(std::function<void(long, long)> calcTile, long height)
+    {
+        long numTiles = (height + this->tileRows - 1) / this->tileRows;
+        rsgis::utils::parallelFor(numTiles, this->numThreads, [this, &calcTile, height](size_t tile, unsigned int)
+        {
+            long yOff = tile * this->tileRows;
+            calcTile(yOff, std::min((long)this->tileRows, height - yOff));
+        });
+    }
+    
+    void RSGISLandsatFMaskFusedPasses::calcPass1(GDALDataset *reflDataset, GDALDataset *thermDataset, GDALDataset *saturateDataset, GDALDataset *validAreaDataset, GDALDataset *landWaterDataset)
+    {
+        this->width = reflDataset->GetRasterXSize();
+        this->height = reflDataset->GetRasterYSize();
+        GDALDataset *inDatasets[4] = {reflDataset, thermDataset, saturateDataset, validAreaDataset};
+        for(int i = 0; i < 4; ++i)
+        {
+            if((inDatasets[i]->GetRasterXSize() != this->width) || (inDatasets[i]->GetRasterYSize() != this->height))
+            {
+                throw rsgis::img::RSGISImageCalcException("The input images must all be the same size.");
+            }
+        }
+        const int numReflBands = reflDataset->GetRasterCount();
+        const int numThermBands = thermDataset->GetRasterCount();
+        const int numSatBands = saturateDataset->GetRasterCount();
+        const int numBands = numReflBands + numThermBands + numSatBands;
+        if(((unsigned int)(numReflBands + numThermBands)) != this->numLSBands)
+        {
+            throw rsgis::img::RSGISImageCalcException("The number of reflectance and thermal bands does not match the number of Landsat bands.");
+        }
+        
+        size_t numPxls = ((size_t)this->width) * this->height;
+        this->thermVals.assign(numPxls, 0);
+        this->swir1Vals.assign(numPxls, 0);
+        this->varProbVals.assign(numPxls, 0);
+        this->pxlFlags.assign(numPxls, 0);
+        
+        rsgis::img::RSGISStreamHistogram landTempHist;
+        rsgis::img::RSGISStreamHistogram waterTempHist;
+        rsgis::img::RSGISStreamHistogram landNIRHist;
+        rsgis::img::RSGISStreamHistogram landSWIRHist;
+        double numValid = 0.0;
+        double numPCP = 0.0;
+        std::mutex ioMutex;
+        std::mutex statsMutex;
+        
+        auto calcTile = [&](long yOff, long tileHeight)
+        {
+            size_t numTilePxls = ((size_t)this->width) * tileHeight;
+            std::vector<float> inData(numTilePxls * numBands);
+            std::vector<float> validData(numTilePxls);
+            std::vector<unsigned int> landWaterData(numTilePxls, 0);
+            {
+                std::lock_guard<std::mutex> lock(ioMutex);
+                if((reflDataset->RasterIO(GF_Read, 0, yOff, this->width, tileHeight, inData.data(), this->width, tileHeight, GDT_Float32, numReflBands, NULL, 0, 0, 0) != CE_None) ||
+                   (thermDataset->RasterIO(GF_Read, 0, yOff, this->width, tileHeight, &inData[numTilePxls * numReflBands], this->width, tileHeight, GDT_Float32, numThermBands, NULL, 0, 0, 0) != CE_None) ||
+                   (saturateDataset->RasterIO(GF_Read, 0, yOff, this->width, tileHeight, &inData[numTilePxls * (numReflBands + numThermBands)], this->width, tileHeight, GDT_Float32, numSatBands, NULL, 0, 0, 0) != CE_None) ||
+                   (validAreaDataset->GetRasterBand(1)->RasterIO(GF_Read, 0, yOff, this->width, tileHeight, validData.data(), this->width, tileHeight, GDT_Float32, 0, 0) != CE_None))
+                {
+                    throw rsgis::img::RSGISImageCalcException("Could not read the input images.");
+                }
+            }
+            
+            rsgis::img::RSGISStreamHistogram tileLandTempHist;
+            rsgis::img::RSGISStreamHistogram tileWaterTempHist;
+            rsgis::img::RSGISStreamHistogram tileLandNIRHist;
+            rsgis::img::RSGISStreamHistogram tileLandSWIRHist;
+            double tileNumValid = 0.0;
+            double tileNumPCP = 0.0;
+            
+            std::vector<float> bandValues(numBands);
+            double pass1Out[16];
+            for(size_t i = 0; i < numTilePxls; ++i)
+            {
+                bool allZero = true;
+                for(int n = 0; n < numBands; ++n)
+                {
+                    bandValues[n] = inData[(n * numTilePxls) + i];
+                    if((n < ((int)this->numLSBands)) && (bandValues[n] != 0.0))
+                    {
+                        allZero = false;
+                    }
+                }
+                float therm1Raw = bandValues[this->therm1Idx];
+                float nirRaw = bandValues[this->nirIdx];
+                float swir1Raw = bandValues[this->swir1Idx];
+                
+                // calcImageValue scales the band values in place.
+                this->pass1->RSGISLandsatFMaskPass1CloudMasking::calcImageValue(bandValues.data(), numBands, pass1Out);
+                
+                unsigned char flags = 0;
+                if(pass1Out[15] == 1)
+                {
+                    flags |= fmask_water;
+                    landWaterData[i] = 2;
+                }
+                else if(pass1Out[9] == 1)
+                {
+                    flags |= fmask_land;
+                    landWaterData[i] = 1;
+                }
+                if(pass1Out[8] == 1)
+                {
+                    flags |= fmask_pcp;
+                    tileNumPCP += 1.0;
+                }
+                if(pass1Out[7] == 1)
+                {
+                    flags |= fmask_watertest;
+                }
+                if(allZero || ((this->numLSBands == 7) && (therm1Raw == 0)))
+                {
+                    flags |= fmask_nodata;
+                }
+                if(validData[i] == 1)
+                {
+                    tileNumValid += 1.0;
+                }
+                
+                size_t pxlIdx = (((size_t)yOff) * this->width) + i;
+                this->thermVals[pxlIdx] = therm1Raw / this->scaleFactor;
+                this->swir1Vals[pxlIdx] = swir1Raw / this->scaleFactor;
+                this->varProbVals[pxlIdx] = pass1Out[11];
+                this->pxlFlags[pxlIdx] = flags;
+                
+                if(flags & fmask_land)
+                {
+                    tileLandTempHist.add(this->thermVals[pxlIdx]);
+                    tileLandNIRHist.add(nirRaw);
+                    tileLandSWIRHist.add(swir1Raw);
+                }
+                else if(flags & fmask_water)
+                {
+                    tileWaterTempHist.add(this->thermVals[pxlIdx]);
+                }
+            }
+            
+            {
+                std::lock_guard<std::mutex> lock(statsMutex);
+                landTempHist.merge(tileLandTempHist);
+                waterTempHist.merge(tileWaterTempHist);
+                landNIRHist.merge(tileLandNIRHist);
+                landSWIRHist.merge(tileLandSWIRHist);
+                numValid += tileNumValid;
+                numPCP += tileNumPCP;
+            }
+            
+            std::lock_guard<std::mutex> lock(ioMutex);
+            if(landWaterDataset->GetRasterBand(1)->RasterIO(GF_Write, 0, yOff, this->width, tileHeight, landWaterData.data(), this->width, tileHeight, GDT_UInt32, 0, 0) != CE_None)
+            {
+                throw rsgis::img::RSGISImageCalcException("Could not write the land and water image.");
+            }
+        };
+        this->runTiles(calcTile, this->height);
+        
+        this->numValidPxls = numValid;
+        this->numPCPPxls = numPCP;
+        
+        // Equation 8 and 13 percentiles (Zhu and Woodcock 2012, RSE 118, pp83-94), 0 where there are no pixels in the class:
+        auto percentile = [](const rsgis::img::RSGISStreamHistogram &hist, double percent)
+        {
+            return (hist.getCount() == 0)?0.0:hist.getPercentile(percent);
+        };
+        this->lowerWaterThres = percentile(waterTempHist, 17.5);
+        this->upperWaterThres = percentile(waterTempHist, 82.5);
+        this->lowerLandThres = percentile(landTempHist, 17.5);
+        this->upperLandThres = percentile(landTempHist, 82.5);
+        this->landNIRLower = percentile(landNIRHist, 17.5);
+        this->landSWIRLower = percentile(landSWIRHist, 17.5);
+    }
+    
+    double RSGISLandsatFMaskFusedPasses::propOfPCPPixels()
+    {
+        double outPCPProp = 0.0;
+        if(this->numValidPxls > 0)
+        {
+            outPCPProp = this->numPCPPxls / this->numValidPxls;
+        }
+        return outPCPProp;
+    }
+    
+    void RSGISLandsatFMaskFusedPasses::calcPass2(GDALDataset *cloudMaskDataset)
+    {
+        if(this->pxlFlags.empty())
+        {
+            throw rsgis::img::RSGISImageCalcException("The first pass has not been calculated.");
+        }
+        if((cloudMaskDataset->GetRasterXSize() != this->width) || (cloudMaskDataset->GetRasterYSize() != this->height))
+        {
+            throw rsgis::img::RSGISImageCalcException("The cloud mask image must be the same size as the input images.");
+        }
+        
+        const double water82ndThres = this->upperWaterThres;
+        const double land82ndThres = this->upperLandThres;
+        const double land17thThres = this->lowerLandThres;
+        
+        // Equation 9, 10, 11, 14 and 16 (Zhu and Woodcock 2012, RSE 118, pp83-94):
+        auto calcCloudProbs = [&](size_t pxlIdx, double *waterCloudProb, double *landCloudProb)
+        {
+            if(this->pxlFlags[pxlIdx] & fmask_nodata)
+            {
+                *waterCloudProb = 0;
+                *landCloudProb = 0;
+                return;
+            }
+            double wTempProb = (water82ndThres - this->thermVals[pxlIdx]) / 4;
+            double brightnessProb = std::min(this->swir1Vals[pxlIdx], 0.11f) / 0.11;
+            *waterCloudProb = wTempProb * brightnessProb;
+            double landTempProb = (land82ndThres + (4-this->thermVals[pxlIdx])) / (land82ndThres + (4 - (land17thThres - 4)));
+            *landCloudProb = this->varProbVals[pxlIdx] * landTempProb;
+        };
+        
+        // Equation 17 (Zhu and Woodcock 2012, RSE 118, pp83-94) percentiles from the values in memory:
+        rsgis::img::RSGISStreamHistogram landCloudProbHist;
+        rsgis::img::RSGISStreamHistogram waterCloudProbHist;
+        std::mutex statsMutex;
+        auto calcProbTile = [&](long yOff, long tileHeight)
+        {
+            rsgis::img::RSGISStreamHistogram tileLandCloudProbHist;
+            rsgis::img::RSGISStreamHistogram tileWaterCloudProbHist;
+            size_t startIdx = ((size_t)yOff) * this->width;
+            size_t endIdx = startIdx + (((size_t)tileHeight) * this->width);
+            double waterCloudProb = 0.0;
+            double landCloudProb = 0.0;
+            for(size_t i = startIdx; i < endIdx; ++i)
+            {
+                if(this->pxlFlags[i] & fmask_land)
+                {
+                    calcCloudProbs(i, &waterCloudProb, &landCloudProb);
+                    tileLandCloudProbHist.add(landCloudProb);
+                }
+                else if(this->pxlFlags[i] & fmask_water)
+                {
+                    calcCloudProbs(i, &waterCloudProb, &landCloudProb);
+                    tileWaterCloudProbHist.add(waterCloudProb);
+                }
+            }
+            std::lock_guard<std::mutex> lock(statsMutex);
+            landCloudProbHist.merge(tileLandCloudProbHist);
+            waterCloudProbHist.merge(tileWaterCloudProbHist);
+        };
+        this->runTiles(calcProbTile, this->height);
+        
+        // Equation 18 threshold of 0.5 used in Zhu and Woodcock 2012, RSE 118, pp83-94 changed in Zhu et al (2015) RSE 159 pp269-277 to be dynamic:
+        this->landCloudProbUpperThres = ((landCloudProbHist.getCount() == 0)?0.0:landCloudProbHist.getPercentile(82.5)) + 0.2;
+        this->waterCloudProbUpperThres = ((waterCloudProbHist.getCount() == 0)?0.0:waterCloudProbHist.getPercentile(82.5)) + 0.2;
+        if(this->waterCloudProbUpperThres > 0.5)
+        {
+            this->waterCloudProbUpperThres = 0.5;
+        }
+        
+        const double landProbThres = this->landCloudProbUpperThres;
+        const double waterProbThres = this->waterCloudProbUpperThres;
+        const double lowerTempThres = this->lowerLandThres - 35;
+        std::mutex ioMutex;
+        auto calcMaskTile = [&](long yOff, long tileHeight)
+        {
+            size_t startIdx = ((size_t)yOff) * this->width;
+            size_t numTilePxls = ((size_t)tileHeight) * this->width;
+            std::vector<int> cloudData(numTilePxls, 0);
+            double waterCloudProb = 0.0;
+            double landCloudProb = 0.0;
+            for(size_t i = 0; i < numTilePxls; ++i)
+            {
+                size_t pxlIdx = startIdx + i;
+                unsigned char flags = this->pxlFlags[pxlIdx];
+                if(flags & fmask_nodata)
+                {
+                    continue;
+                }
+                calcCloudProbs(pxlIdx, &waterCloudProb, &landCloudProb);
+                bool pcp = flags & fmask_pcp;
+                bool waterTest = flags & fmask_watertest;
+                
+                // Equation 18 (Zhu and Woodcock 2012, RSE 118, pp83-94):
+                if(pcp && waterTest && (waterCloudProb > waterProbThres))
+                {
+                    cloudData[i] = 1;
+                }
+                else if(pcp && !waterTest && (landCloudProb > landProbThres))
+                {
+                    cloudData[i] = 1;
+                }
+                else if(!waterTest && (landCloudProb > 0.99))
+                {
+                    cloudData[i] = 1;
+                }
+                else if(this->thermVals[pxlIdx] < lowerTempThres)
+                {
+                    cloudData[i] = 1;
+                }
+            }
+            
+            std::lock_guard<std::mutex> lock(ioMutex);
+            if(cloudMaskDataset->GetRasterBand(1)->RasterIO(GF_Write, 0, yOff, this->width, tileHeight, cloudData.data(), this->width, tileHeight, GDT_Int32, 0, 0) != CE_None)
+            {
+                throw rsgis::img::RSGISImageCalcException("Could not write the cloud mask image.");
+            }
+        };
+        this->runTiles(calcMaskTile, this->height);
+    }
+    
+    RSGISLandsatFMaskFusedPasses::~RSGISLandsatFMaskFusedPasses()
+    {
+        delete this->pass1;
+    }
+    
+    
     RSGISLandsatFMaskExportPass1LandWaterCloudMasking::RSGISLandsatFMaskExportPass1LandWaterCloudMasking():rsgis::img::RSGISCalcImageValue(1)
     {
         this->numValidPxls = 0.0;
@@ -332,6 +705,27 @@ namespace rsgis{namespace calib{
         
     }
     
+    void RSGISLandsatFMaskExportPass1LandWaterCloudMasking::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        const float *validPlane = bandPlanes[0];
+        const float *pcpPlane = bandPlanes[9];
+        const float *landPlane = bandPlanes[10];
+        const float *waterPlane = bandPlanes[16];
+        double *outPlane = outPlanes[0];
+        
+        double numValid = 0.0;
+        double numPCP = 0.0;
+        for(size_t i = 0; i < nPxls; ++i)
+        {
+            double outVal = (landPlane[i] == 1)?1.0:0.0; // land
+            outPlane[i] = (waterPlane[i] == 1)?2.0:outVal; // water
+            numValid += (validPlane[i] == 1)?1.0:0.0;
+            numPCP += (pcpPlane[i] == 1)?1.0:0.0;
+        }
+        this->numValidPxls = this->numValidPxls + numValid;
+        this->numPCPPxls = this->numPCPPxls + numPCP;
+    }
+    
     double RSGISLandsatFMaskExportPass1LandWaterCloudMasking::propOfPCPPixels()
     {
         double outPCPProp = 0.0;
@@ -777,6 +1171,16 @@ namespace rsgis{namespace calib{
     
     
     
+    RSGISCalcCloudParams::RSGISCalcCloudParams()
+    {
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+    
+    void RSGISCalcCloudParams::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+    
     void RSGISCalcCloudParams::calcCloudHeights(GDALDataset *thermal, GDALDataset *cloudClumpsDS, GDALDataset *initCloudHeights, double lowerLandThres, double upperLandThres, float scaleFactor)
     {
         try
@@ -1159,6 +1563,340 @@ namespace rsgis{namespace calib{
     }
     
     
+    void RSGISCalcCloudParams::projFitCloudShadowInMem(GDALDataset *cloudClumpsDS, GDALDataset *initCloudHeights, GDALDataset *potentCloudShadowRegions, GDALDataset *cloudShadowRegionsDS, double sunAz, double sunZen, double senAz, double senZen)
+    {
+        try
+        {
+            long width = cloudClumpsDS->GetRasterXSize();
+            long height = cloudClumpsDS->GetRasterYSize();
+            GDALDataset *imgDatasets[3] = {initCloudHeights, potentCloudShadowRegions, cloudShadowRegionsDS};
+            for(int n = 0; n < 3; ++n)
+            {
+                if((imgDatasets[n]->GetRasterXSize() != width) | (imgDatasets[n]->GetRasterYSize() != height))
+                {
+                    throw rsgis::img::RSGISImageCalcException("The cloud clumps, cloud heights, potential shadow and output images must have the same dimensions.");
+                }
+            }
+            if(initCloudHeights->GetRasterCount() < 2)
+            {
+                throw rsgis::img::RSGISImageCalcException("The cloud heights image must have 2 bands.");
+            }
+            
+            rsgis::rastergis::RSGISRasterAttUtils attUtils;
+            GDALRasterAttributeTable *cloudsRAT = cloudClumpsDS->GetRasterBand(1)->GetDefaultRAT();
+            size_t numClumps = 0;
+            int *cloudsRATHisto = attUtils.readIntColumn(cloudsRAT, "Histogram", &numClumps);
+            double *hBaseMin = attUtils.readDoubleColumn(cloudsRAT, "hBaseMin", &numClumps);
+            double *hBaseMax = attUtils.readDoubleColumn(cloudsRAT, "hBaseMax", &numClumps);
+            
+            double *trans = new double[6];
+            cloudClumpsDS->GetGeoTransform(trans);
+            double tlX = trans[0];
+            double tlY = trans[3];
+            double xRes = trans[1];
+            double yRes = trans[5];
+            if(yRes < 0)
+            {
+                yRes = yRes * (-1);
+            }
+            delete[] trans;
+            double brX = tlX + (width * xRes);
+            double brY = tlY - (height * yRes);
+            
+            // Pixels of each cloud clump (column, row, cloud height above the base)
+            // and a per-pixel class: 1 cloud, 2 potential shadow outside of cloud.
+            struct CloudPxl
+            {
+                unsigned int x;
+                unsigned int y;
+                float hgt;
+            };
+            std::vector<std::vector<CloudPxl> > cloudPxls(numClumps);
+            for(size_t i = 1; i < numClumps; ++i)
+            {
+                cloudPxls[i].reserve(cloudsRATHisto[i]);
+            }
+            std::vector<unsigned char> pxlClass(width * height, 0);
+            
+            std::cout << "Reading cloud clumps and potential shadow regions\n";
+            GDALRasterBand *clumpsBand = cloudClumpsDS->GetRasterBand(1);
+            GDALRasterBand *hgtsBand = initCloudHeights->GetRasterBand(2);
+            GDALRasterBand *potentBand = potentCloudShadowRegions->GetRasterBand(1);
+            unsigned int *clumpsRow = new unsigned int[width];
+            float *hgtsRow = new float[width];
+            int *potentRow = new int[width];
+            for(long y = 0; y < height; ++y)
+            {
+                if((clumpsBand->RasterIO(GF_Read, 0, y, width, 1, clumpsRow, width, 1, GDT_UInt32, 0, 0) != CE_None) |
+                   (hgtsBand->RasterIO(GF_Read, 0, y, width, 1, hgtsRow, width, 1, GDT_Float32, 0, 0) != CE_None) |
+                   (potentBand->RasterIO(GF_Read, 0, y, width, 1, potentRow, width, 1, GDT_Int32, 0, 0) != CE_None))
+                {
+                    delete[] clumpsRow;
+                    delete[] hgtsRow;
+                    delete[] potentRow;
+                    throw rsgis::img::RSGISImageCalcException("Could not read the cloud clumps, heights or potential shadow images.");
+                }
+                for(long x = 0; x < width; ++x)
+                {
+                    if(clumpsRow[x] != 0)
+                    {
+                        pxlClass[(y*width)+x] = 1;
+                        if(clumpsRow[x] < numClumps)
+                        {
+                            CloudPxl pxl;
+                            pxl.x = x;
+                            pxl.y = y;
+                            pxl.hgt = hgtsRow[x];
+                            cloudPxls[clumpsRow[x]].push_back(pxl);
+                        }
+                    }
+                    else if(potentRow[x] == 1)
+                    {
+                        pxlClass[(y*width)+x] = 2;
+                    }
+                }
+            }
+            delete[] clumpsRow;
+            delete[] hgtsRow;
+            delete[] potentRow;
+            
+            // Projection of a cloud pixel centre (calculation taken from python-fmask) onto the image grid.
+            double tanSunZen = tan(sunZen);
+            double sinSunAz = sin(sunAz);
+            double cosSunAz = cos(sunAz);
+            auto projectPxl = [&](const CloudPxl &pxl, double baseHeight, double *xDash, double *yDash, size_t *idx) -> bool
+            {
+                double d = ((baseHeight + pxl.hgt) * 1000) * tanSunZen; // Convert to metres.
+                *xDash = (tlX + ((pxl.x + 0.5) * xRes)) - d * sinSunAz;
+                *yDash = (tlY - ((pxl.y + 0.5) * yRes)) - d * cosSunAz;
+                if((*xDash < tlX) | (*xDash > brX) | (*yDash > tlY) | (*yDash < brY))
+                {
+                    return false;
+                }
+                long xPxlLoc = floor(((*xDash - tlX) / xRes) + 0.5);
+                long yPxlLoc = floor(((tlY - *yDash) / yRes) + 0.5);
+                if((xPxlLoc < 0) | (xPxlLoc >= width) | (yPxlLoc < 0) | (yPxlLoc >= height))
+                {
+                    return false;
+                }
+                *idx = (yPxlLoc * width) + xPxlLoc;
+                return true;
+            };
+            
+            double *bestFitBaseLine = new double[numClumps];
+            bestFitBaseLine[0] = 0.0;
+            std::vector<size_t> clumpOrder;
+            clumpOrder.reserve(numClumps);
+            for(size_t i = 1; i < numClumps; ++i)
+            {
+                clumpOrder.push_back(i);
+            }
+            std::sort(clumpOrder.begin(), clumpOrder.end(), [&cloudPxls](size_t a, size_t b){return cloudPxls[a].size() > cloudPxls[b].size();});
+            
+            std::cout << "Finding optimal cloud heights for " << clumpOrder.size() << " clumps\n";
+            rsgis::utils::RSGISWorkerPool pool(std::max((size_t)1, std::min((size_t)this->numThreads, clumpOrder.size())));
+            std::vector<std::vector<size_t> > workerShadIdxs(pool.getNumThreads());
+            try
+            {
+                pool.parallelFor(clumpOrder.size(), [&](size_t n, unsigned int t)
+                {
+                    std::vector<size_t> &shadIdxs = workerShadIdxs[t];
+                    double xDash = 0.0;
+                    double yDash = 0.0;
+                    size_t idx = 0;
+                    size_t i = clumpOrder[n];
+                    bool first = true;
+                    double maxH = hBaseMin[i];
+                    double maxProp = 0.0;
+                    for(double baseHeight = hBaseMin[i]; baseHeight < hBaseMax[i]; baseHeight += 0.25)
+                    {
+                        shadIdxs.clear();
+                        geos::geom::Envelope extent;
+                        for(std::vector<CloudPxl>::const_iterator iterPxl = cloudPxls[i].begin(); iterPxl != cloudPxls[i].end(); ++iterPxl)
+                        {
+                            if(projectPxl(*iterPxl, baseHeight, &xDash, &yDash, &idx))
+                            {
+                                shadIdxs.push_back(idx);
+                                extent.expandToInclude(xDash, yDash);
+                            }
+                        }
+                        
+                        // As RSGISEditCloudShadowImg::calcCorrelation, the shadow must be
+                        // at least 2 pixels across and overlap some non-cloud pixels.
+                        bool insideImg = (!extent.isNull()) && (extent.getWidth() >= (xRes*2)) && (extent.getHeight() >= (yRes*2));
+                        double cloudPropOverlap = 0.0;
+                        if(insideImg)
+                        {
+                            // projFitCloudShadow counts the shadow pixels within the window
+                            // RSGISImageUtils::getImageOverlapCut2Env gives for the envelope of
+                            // the projected points, so the same window is used here (projected
+                            // pixels on its right and bottom edges are not counted).
+                            long winXOff = 0;
+                            long winYOff = 0;
+                            if(fabs(extent.getMinX() - tlX) >= 0.0001)
+                            {
+                                winXOff = floor(((extent.getMinX() - tlX)/xRes)+0.5);
+                            }
+                            if(fabs(tlY - extent.getMaxY()) >= 0.0001)
+                            {
+                                winYOff = floor(((tlY - extent.getMaxY())/yRes)+0.5);
+                            }
+                            long winWidth = floor((extent.getWidth()/xRes)+0.5);
+                            long winHeight = floor((extent.getHeight()/yRes)+0.5);
+                            double winMaxX = tlX + ((winXOff + winWidth) * xRes);
+                            double winMinY = tlY - ((winYOff + winHeight) * yRes);
+                            if(winMaxX > extent.getMaxX())
+                            {
+                                winWidth -= std::max(0L, (long)floor(((winMaxX - extent.getMaxX())/xRes)+0.5));
+                            }
+                            if(winMinY < extent.getMinY())
+                            {
+                                winHeight -= std::max(0L, (long)floor(((extent.getMinY() - winMinY)/yRes)+0.5));
+                            }
+                            
+                            std::sort(shadIdxs.begin(), shadIdxs.end());
+                            shadIdxs.erase(std::unique(shadIdxs.begin(), shadIdxs.end()), shadIdxs.end());
+                            unsigned long nShadPxls = 0;
+                            unsigned long nShadPxlsInPotent = 0;
+                            for(std::vector<size_t>::iterator iterIdx = shadIdxs.begin(); iterIdx != shadIdxs.end(); ++iterIdx)
+                            {
+                                long xPxl = (*iterIdx) % width;
+                                long yPxl = (*iterIdx) / width;
+                                if((xPxl < winXOff) | (xPxl >= (winXOff + winWidth)) | (yPxl < winYOff) | (yPxl >= (winYOff + winHeight)))
+                                {
+                                    continue;
+                                }
+                                if(pxlClass[*iterIdx] != 1)
+                                {
+                                    ++nShadPxls;
+                                    if(pxlClass[*iterIdx] == 2)
+                                    {
+                                        ++nShadPxlsInPotent;
+                                    }
+                                }
+                            }
+                            if(nShadPxls == 0)
+                            {
+                                insideImg = false;
+                            }
+                            else
+                            {
+                                cloudPropOverlap = ((double)nShadPxlsInPotent)/((double)nShadPxls);
+                            }
+                        }
+                        
+                        if(insideImg)
+                        {
+                            if(first || (cloudPropOverlap > maxProp))
+                            {
+                                maxH = baseHeight;
+                                maxProp = cloudPropOverlap;
+                                first = false;
+                            }
+                        }
+                        else
+                        {
+                            if(first)
+                            {
+                                maxH = baseHeight;
+                            }
+                            break;
+                        }
+                    }
+                    // Shadow best fit base height is 'maxH'
+                    bestFitBaseLine[i] = maxH;
+                });
+            }
+            catch(...)
+            {
+                delete[] bestFitBaseLine;
+                delete[] cloudsRATHisto;
+                delete[] hBaseMin;
+                delete[] hBaseMax;
+                throw;
+            }
+            attUtils.writeRealColumn(cloudsRAT, "FitBaseLine", bestFitBaseLine, numClumps);
+            
+            rsgis::math::RSGISMathsUtils mathUtils;
+            double histMinVal = 0.0;
+            double histMaxVal = 0.0;
+            unsigned int histNumBins = 0;
+            double histBinWidth = 0.1;
+            unsigned int *hist = NULL;
+            bool gotHist = true;
+            try
+            {
+                hist = mathUtils.calcHistogram(bestFitBaseLine, numClumps, histBinWidth, &histMinVal, &histMaxVal, &histNumBins, true);
+            }
+            catch(rsgis::math::RSGISMathException &e)
+            {
+                gotHist = false;
+            }
+            if(gotHist)
+            {
+                double bestFitBaseLineLowQuat = mathUtils.calcPercentile(25, histMinVal, histBinWidth, histNumBins, hist);
+                double bestFitBaseLineMedian = mathUtils.calcPercentile(50, histMinVal, histBinWidth, histNumBins, hist);
+                double bestFitBaseLineUpQuat = mathUtils.calcPercentile(75, histMinVal, histBinWidth, histNumBins, hist);
+                delete [] hist;
+                
+                for(size_t i = 1; i < numClumps; ++i)
+                {
+                    if(bestFitBaseLine[i] < bestFitBaseLineLowQuat)
+                    {
+                        bestFitBaseLine[i] = bestFitBaseLineMedian;
+                    }
+                    else if(bestFitBaseLine[i] > bestFitBaseLineUpQuat)
+                    {
+                        bestFitBaseLine[i] = bestFitBaseLineMedian;
+                    }
+                }
+            }
+            attUtils.writeRealColumn(cloudsRAT, "FitBaseLineEdit", bestFitBaseLine, numClumps);
+            
+            std::cout << "Producing cloud shadow mask using optimal heights\n";
+            std::vector<unsigned char> shadowMask(width * height, 0);
+            double xDash = 0.0;
+            double yDash = 0.0;
+            size_t idx = 0;
+            for(size_t i = 1; i < numClumps; ++i)
+            {
+                for(std::vector<CloudPxl>::const_iterator iterPxl = cloudPxls[i].begin(); iterPxl != cloudPxls[i].end(); ++iterPxl)
+                {
+                    if(projectPxl(*iterPxl, bestFitBaseLine[i], &xDash, &yDash, &idx))
+                    {
+                        shadowMask[idx] = 1;
+                    }
+                }
+            }
+            GDALRasterBand *shadowBand = cloudShadowRegionsDS->GetRasterBand(1);
+            for(long y = 0; y < height; ++y)
+            {
+                if(shadowBand->RasterIO(GF_Write, 0, y, width, 1, &shadowMask[y*width], width, 1, GDT_Byte, 0, 0) != CE_None)
+                {
+                    throw rsgis::img::RSGISImageCalcException("Could not write the cloud shadow image.");
+                }
+            }
+            
+            delete[] bestFitBaseLine;
+            delete[] cloudsRATHisto;
+            delete[] hBaseMin;
+            delete[] hBaseMax;
+        }
+        catch (rsgis::img::RSGISImageCalcException &e)
+        {
+            throw e;
+        }
+        catch(rsgis::RSGISException &e)
+        {
+            throw rsgis::img::RSGISImageCalcException(e.what());
+        }
+        catch(std::exception &e)
+        {
+            throw rsgis::img::RSGISImageCalcException(e.what());
+        }
+    }
+    
+    
     RSGISEditCloudShadowImg::RSGISEditCloudShadowImg(GDALDataset *testImg, int band)
     {
         this->testImg = testImg;
@@ -26,6 +26,14 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <functional>
+#include <cstdlib>
 #include <math.h>
 
 #include "gdal_priv.h"
@@ -34,12 +42,14 @@
 
 #include "common/rsgis-tqdm.h"
 #include "common/RSGISException.h"
+#include "common/RSGISParallel.h"
 
 #include "img/RSGISImageCalcException.h"
 #include "img/RSGISCalcImageValue.h"
 #include "img/RSGISCalcImage.h"
 #include "img/RSGISImageStatistics.h"
 #include "img/RSGISExtractImageValues.h"
+#include "img/RSGISSinglePassImageStats.h"
 
 #include "rastergis/RSGISPopRATWithStats.h"
 #include "rastergis/RSGISRasterAttUtils.h"
@@ -67,6 +77,7 @@ namespace rsgis{namespace calib{
     public:
         RSGISLandsatFMaskPass1CloudMasking(unsigned int scaleFactor, unsigned int numLSBands, double whitenessThreshold=0.7);
         void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
         void calcImageValue(float *bandValues, int numBands) {throw rsgis::img::RSGISImageCalcException("Not implmented.");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
@@ -110,11 +121,78 @@ namespace rsgis{namespace calib{
         double whitenessThreshold;
     };
     
+    /**
+     * Fuses the per-pixel FMask passes (RSGISLandsatFMaskPass1CloudMasking,
+     * RSGISLandsatFMaskExportPass1LandWaterCloudMasking,
+     * RSGISLandsatFMaskPass2ClearSkyCloudProbCloudMasking and
+     * RSGISLandsatFMaskPass2CloudMasking) so the input bands are read once.
+     *
+     * calcPass1 reads the reflectance, thermal, saturation and valid area
+     * images in tiles of rows, shared between threads (RSGISLIB_NUM_THREADS
+     * or setNumThreads), writing the land (1) / water (2) clear sky image
+     * and keeping the values needed by the second pass (thermal, SWIR1,
+     * variability probability and test flags; 13 bytes per pixel) in memory.
+     * The scene percentiles (land and water temperature, land NIR and SWIR1)
+     * are accumulated from the tiles with mergeable streaming histograms
+     * (rsgis::img::RSGISStreamHistogram) rather than a further pass over a
+     * written image. calcPass2 calculates the cloud probability percentiles
+     * and the cloud mask from the values held in memory.
+     */
+    class DllExport RSGISLandsatFMaskFusedPasses
+    {
+    public:
+        RSGISLandsatFMaskFusedPasses(unsigned int scaleFactor, unsigned int numLSBands, double whitenessThreshold=0.7);
+        void setNumThreads(unsigned int numThreads);
+        void setTileRows(unsigned int tileRows){this->tileRows = (tileRows == 0)?1:tileRows;};
+        void calcPass1(GDALDataset *reflDataset, GDALDataset *thermDataset, GDALDataset *saturateDataset, GDALDataset *validAreaDataset, GDALDataset *landWaterDataset);
+        double propOfPCPPixels();
+        void calcPass2(GDALDataset *cloudMaskDataset);
+        double getLowerWaterThres(){return lowerWaterThres;};
+        double getUpperWaterThres(){return upperWaterThres;};
+        double getLowerLandThres(){return lowerLandThres;};
+        double getUpperLandThres(){return upperLandThres;};
+        double getLandCloudProbUpperThres(){return landCloudProbUpperThres;};
+        double getWaterCloudProbUpperThres(){return waterCloudProbUpperThres;};
+        /** The 17.5th percentile of the (unscaled) land NIR reflectance. */
+        double getLandNIRLower(){return landNIRLower;};
+        /** The 17.5th percentile of the (unscaled) land SWIR1 reflectance. */
+        double getLandSWIRLower(){return landSWIRLower;};
+        ~RSGISLandsatFMaskFusedPasses();
+    protected:
+        enum FMaskPxlFlags {fmask_land=1, fmask_water=2, fmask_pcp=4, fmask_watertest=8, fmask_nodata=16};
+        void runTiles(std::function<void(long, long)> calcTile, long height);
+        RSGISLandsatFMaskPass1CloudMasking *pass1;
+        unsigned int scaleFactor;
+        unsigned int numLSBands;
+        unsigned int nirIdx;
+        unsigned int swir1Idx;
+        unsigned int therm1Idx;
+        unsigned int numThreads;
+        unsigned int tileRows;
+        long width;
+        long height;
+        std::vector<float> thermVals;
+        std::vector<float> swir1Vals;
+        std::vector<float> varProbVals;
+        std::vector<unsigned char> pxlFlags;
+        double numValidPxls;
+        double numPCPPxls;
+        double lowerWaterThres;
+        double upperWaterThres;
+        double lowerLandThres;
+        double upperLandThres;
+        double landCloudProbUpperThres;
+        double waterCloudProbUpperThres;
+        double landNIRLower;
+        double landSWIRLower;
+    };
+    
     class DllExport RSGISLandsatFMaskExportPass1LandWaterCloudMasking : public rsgis::img::RSGISCalcImageValue
     {
     public:
         RSGISLandsatFMaskExportPass1LandWaterCloudMasking();
         void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
         void calcImageValue(float *bandValues, int numBands) {throw rsgis::img::RSGISImageCalcException("Not implmented.");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
@@ -276,11 +354,25 @@ namespace rsgis{namespace calib{
     class DllExport RSGISCalcCloudParams
     {
     public:
-        RSGISCalcCloudParams(){};
+        RSGISCalcCloudParams();
+        void setNumThreads(unsigned int numThreads);
         void calcCloudHeights(GDALDataset *thermal, GDALDataset *cloudClumpsDS, GDALDataset *initCloudHeights, double lowerLandThres, double upperLandThres, float scaleFactor);
         void calcCloudHeightsNoThermal(GDALDataset *cloudClumpsDS, GDALDataset *initCloudHeightsDS);
         void projFitCloudShadow(GDALDataset *cloudClumpsDS, GDALDataset *initCloudHeights, GDALDataset *potentCloudShadowRegions, GDALDataset *cloudShadowTestRegionsDS, GDALDataset *cloudShadowRegionsDS, double sunAz, double sunZen, double senAz, double senZen);
+        /**
+         * The same fit as projFitCloudShadow but without an image pass per clump and
+         * candidate height. The cloud clumps, cloud heights (band 2) and potential
+         * shadow images are read once; the pixels of each clump are held as a list
+         * and the potential shadow regions as an in-memory bitmap. Each candidate
+         * base height shifts the clump's pixel list and counts the overlap of the
+         * (non-cloud) projected pixels with the potential shadows, over the same
+         * window of the shadow's envelope as projFitCloudShadow. Clumps are
+         * fitted in parallel (RSGISLIB_NUM_THREADS or setNumThreads), largest first.
+         */
+        void projFitCloudShadowInMem(GDALDataset *cloudClumpsDS, GDALDataset *initCloudHeights, GDALDataset *potentCloudShadowRegions, GDALDataset *cloudShadowRegionsDS, double sunAz, double sunZen, double senAz, double senZen);
         ~RSGISCalcCloudParams(){};
+    protected:
+        unsigned int numThreads;
     };
     
     class DllExport RSGISCalcCloudShadowCorrespondance : public rsgis::img::RSGISCalcImageValue
@@ -746,6 +746,217 @@ namespace rsgis{namespace calib{
     }
     
     
+    RSGISCalcShadowMaskHorizonSweep::RSGISCalcShadowMaskHorizonSweep(float ewRes, float nsRes, float sunZenith, float sunAzimuth, double noDataVal)
+    {
+        this->ewRes = ewRes;
+        this->nsRes = nsRes;
+        this->sunZenith = sunZenith;
+        this->sunAzimuth = sunAzimuth;
+        this->noDataVal = noDataVal;
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+    
+    void RSGISCalcShadowMaskHorizonSweep::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+    
+    void RSGISCalcShadowMaskHorizonSweep::calcShadowMask(GDALDataset *dem, unsigned int band, GDALDataset *outMask)
+    {
+        if((band == 0) || (band > ((unsigned int)dem->GetRasterCount())))
+        {
+            throw rsgis::img::RSGISImageCalcException("Specified image band is not within the image.");
+        }
+        if((outMask->GetRasterXSize() != dem->GetRasterXSize()) || (outMask->GetRasterYSize() != dem->GetRasterYSize()))
+        {
+            throw rsgis::img::RSGISImageCalcException("The output shadow mask must be the same size as the DEM.");
+        }
+        
+        const long width = dem->GetRasterXSize();
+        const long height = dem->GetRasterYSize();
+        
+        std::vector<float> demVals(width * height);
+        std::vector<unsigned char> mask(width * height, 0);
+        if(dem->GetRasterBand(band)->RasterIO(GF_Read, 0, 0, width, height, demVals.data(), width, height, GDT_Float32, 0, 0) != CE_None)
+        {
+            throw rsgis::img::RSGISImageCalcException("Could not read the DEM.");
+        }
+        
+        const double degreesToRadians = M_PI / 180.0;
+        const double sunZenRad = sunZenith * degreesToRadians;
+        const double sunAzRad = sunAzimuth * degreesToRadians;
+        
+        // Direction of travel (away from the sun) in image pixels, rows increase southwards.
+        const double dirX = -sin(sunAzRad);
+        const double dirY = cos(sunAzRad);
+        
+        // The lines step one pixel at a time along the major axis, so every pixel falls on exactly one line.
+        const bool xMajor = (fabs(dirX) >= fabs(dirY));
+        const long majorLen = xMajor?width:height;
+        const long minorLen = xMajor?height:width;
+        const long majorStep = ((xMajor?dirX:dirY) >= 0)?1:-1;
+        const long majorStart = (majorStep > 0)?0:(majorLen-1);
+        const double minorStep = xMajor?(dirY/fabs(dirX)):(dirX/fabs(dirY));
+        const double stepDist = xMajor?sqrt((ewRes * ewRes) + (minorStep * nsRes * minorStep * nsRes)):sqrt((nsRes * nsRes) + (minorStep * ewRes * minorStep * ewRes));
+        
+        // With the sun at the zenith (or below the horizon) there is no cast shadow to sweep.
+        const bool castShadow = (sin(sunZenRad) > 1e-6) && (cos(sunZenRad) > 0);
+        const double heightDropPerStep = castShadow?(stepDist * (cos(sunZenRad) / sin(sunZenRad))):0;
+        const double minorDrift = (majorLen-1) * minorStep;
+        const long firstLine = ((long)floor(std::min(0.0, -minorDrift))) - 1;
+        const long lastLine = ((long)ceil(std::max(0.0, -minorDrift))) + minorLen;
+        const long numLines = castShadow?(lastLine - firstLine + 1):0;
+        
+        const long linesPerChunk = 256;
+        const long rowsPerChunk = 64;
+        const long numLineChunks = (numLines + linesPerChunk - 1) / linesPerChunk;
+        const long numRowChunks = (height + rowsPerChunk - 1) / rowsPerChunk;
+        rsgis::utils::RSGISWorkerPool pool(this->numThreads);
+        
+        auto selfShadow = [&](size_t chunkIdx, unsigned int)
+        {
+            long chunk = chunkIdx;
+            this->calcSelfShadowRows(demVals, mask, width, height, chunk * rowsPerChunk, std::min(height, (chunk+1) * rowsPerChunk));
+        };
+        
+        auto sweepLines = [&](size_t chunkIdx, unsigned int)
+        {
+            long chunk = chunkIdx;
+            long endLine = std::min(firstLine + numLines, firstLine + ((chunk+1) * linesPerChunk));
+            for(long line = firstLine + (chunk * linesPerChunk); line < endLine; ++line)
+            {
+                double shadowHeight = -std::numeric_limits<double>::infinity();
+                bool onImage = false;
+                for(long k = 0; k < majorLen; ++k)
+                {
+                    long minor = (long)floor(line + (k * minorStep) + 0.5);
+                    if((minor < 0) || (minor >= minorLen))
+                    {
+                        if(onImage)
+                        {
+                            break;
+                        }
+                        continue;
+                    }
+                    onImage = true;
+                    long major = majorStart + (k * majorStep);
+                    size_t idx = xMajor?((minor * width) + major):((major * width) + minor);
+                    
+                    shadowHeight -= heightDropPerStep;
+                    float elev = demVals[idx];
+                    if((elev == noDataVal) || std::isnan(elev))
+                    {
+                        continue;
+                    }
+                    if(elev < shadowHeight)
+                    {
+                        mask[idx] = 1;
+                    }
+                    else
+                    {
+                        shadowHeight = elev;
+                    }
+                }
+            }
+        };
+        
+        pool.parallelFor(numRowChunks, selfShadow);
+        if(numLines > 0)
+        {
+            pool.parallelFor(numLineChunks, sweepLines);
+        }
+        
+        if(outMask->GetRasterBand(1)->RasterIO(GF_Write, 0, 0, width, height, mask.data(), width, height, GDT_Byte, 0, 0) != CE_None)
+        {
+            throw rsgis::img::RSGISImageCalcException("Could not write the shadow mask.");
+        }
+    }
+    
+    void RSGISCalcShadowMaskHorizonSweep::calcSelfShadowRows(const std::vector<float> &dem, std::vector<unsigned char> &mask, long width, long height, long startRow, long endRow)
+    {
+        const double degreesToRadians = M_PI / 180.0;
+        const double sunZenRad = sunZenith * degreesToRadians;
+        const double sunAzRad = sunAzimuth * degreesToRadians;
+        double z[3][3];
+        bool valid[3][3];
+        
+        for(long y = startRow; y < endRow; ++y)
+        {
+            for(long x = 0; x < width; ++x)
+            {
+                float centre = dem[(y * width) + x];
+                if((centre == noDataVal) || std::isnan(centre))
+                {
+                    continue;
+                }
+                
+                // Pixels outside the image are treated as no data and filled with the window mean.
+                double sumVals = 0.0;
+                int nVals = 0;
+                for(int i = 0; i < 3; ++i)
+                {
+                    for(int j = 0; j < 3; ++j)
+                    {
+                        long wy = y + i - 1;
+                        long wx = x + j - 1;
+                        valid[i][j] = false;
+                        if((wy >= 0) && (wy < height) && (wx >= 0) && (wx < width))
+                        {
+                            z[i][j] = dem[(wy * width) + wx];
+                            valid[i][j] = (z[i][j] != noDataVal) && !std::isnan(z[i][j]);
+                        }
+                        if(valid[i][j])
+                        {
+                            sumVals += z[i][j];
+                            ++nVals;
+                        }
+                    }
+                }
+                if(nVals <= 1)
+                {
+                    continue;
+                }
+                double meanVal = sumVals / nVals;
+                for(int i = 0; i < 3; ++i)
+                {
+                    for(int j = 0; j < 3; ++j)
+                    {
+                        if(!valid[i][j])
+                        {
+                            z[i][j] = meanVal;
+                        }
+                    }
+                }
+                
+                double dx = ((z[0][2] + z[1][2] + z[1][2] + z[2][2]) - (z[0][0] + z[1][0] + z[1][0] + z[2][0]))/ewRes;
+                double dy = ((z[2][0] + z[2][1] + z[2][1] + z[2][2]) - (z[0][0] + z[0][1] + z[0][1] + z[0][2]))/nsRes;
+                if((dx == 0) && (dy == 0))
+                {
+                    continue;
+                }
+                
+                double slopeRad = atan(sqrt((dx * dx) + (dy * dy))/8);
+                double aspectRad = atan2(-dx, dy);
+                if(aspectRad < 0)
+                {
+                    aspectRad += 2 * M_PI;
+                }
+                
+                double ic = (cos(sunZenRad) * cos(slopeRad)) + (sin(sunZenRad) * sin(slopeRad) * cos(sunAzRad - aspectRad));
+                if(ic < 0)
+                {
+                    mask[(y * width) + x] = 1;
+                }
+            }
+        }
+    }
+    
+    RSGISCalcShadowMaskHorizonSweep::~RSGISCalcShadowMaskHorizonSweep()
+    {
+        
+    }
+    
+    
     
     
 
@@ -1197,6 +1408,229 @@ namespace rsgis{namespace calib{
     
     
     
+    RSGISCalcDEMDerivatives::RSGISCalcDEMDerivatives(std::vector<RSGISDEMDerivative> derivatives, unsigned int band, float ewRes, float nsRes, double noDataVal, float sunZenith, float sunAzimuth, float viewZenith, float viewAzimuth) : rsgis::img::RSGISCalcImageValue(derivatives.size())
+    {
+        this->derivatives = derivatives;
+        this->band = band;
+        this->ewRes = ewRes;
+        this->nsRes = nsRes;
+        this->noDataVal = noDataVal;
+        this->sunZenith = sunZenith;
+        this->sunAzimuth = sunAzimuth;
+        this->viewZenith = viewZenith;
+        this->viewAzimuth = viewAzimuth;
+    }
+    
+    void RSGISCalcDEMDerivatives::calcGradientRow(const rsgis::img::RSGISImageWindowView &rowWindow, int width)
+    {
+        if(rowWindow.getWinSize() != 3)
+        {
+            throw rsgis::img::RSGISImageCalcException("Window size must be equal to 3 for the calculate of slope.");
+        }
+        
+        if(!(band < rowWindow.getNumBands()))
+        {
+            throw rsgis::img::RSGISImageCalcException("Specified image band is not within the image.");
+        }
+        
+        this->gradEW.resize(width);
+        this->gradSN.resize(width);
+        this->validPxl.resize(width);
+        
+        const float *rowN = rowWindow.getRow(band, 0);
+        const float *rowC = rowWindow.getRow(band, 1);
+        const float *rowS = rowWindow.getRow(band, 2);
+        const float noData = this->noDataVal;
+        float z[9];
+        for(int x = 0; x < width; ++x)
+        {
+            z[0] = rowN[x]; z[1] = rowN[x+1]; z[2] = rowN[x+2];
+            z[3] = rowC[x]; z[4] = rowC[x+1]; z[5] = rowC[x+2];
+            z[6] = rowS[x]; z[7] = rowS[x+1]; z[8] = rowS[x+2];
+            
+            bool hasNoDataVal = false;
+            for(int i = 0; i < 9; ++i)
+            {
+                hasNoDataVal = hasNoDataVal | (z[i] == noData);
+            }
+            
+            int nVals = 9;
+            if(hasNoDataVal)
+            {
+                // As with the per-pixel calculators, no data values are replaced by the window mean.
+                double sumVals = 0.0;
+                nVals = 0;
+                for(int i = 0; i < 9; ++i)
+                {
+                    if(z[i] != noData)
+                    {
+                        sumVals += z[i];
+                        ++nVals;
+                    }
+                }
+                if(nVals > 1)
+                {
+                    float meanVal = sumVals / nVals;
+                    for(int i = 0; i < 9; ++i)
+                    {
+                        if(z[i] == noData)
+                        {
+                            z[i] = meanVal;
+                        }
+                    }
+                }
+            }
+            
+            this->validPxl[x] = (nVals > 1);
+            this->gradEW[x] = (z[2] + z[5] + z[5] + z[8]) - (z[0] + z[3] + z[3] + z[6]);
+            this->gradSN[x] = (z[6] + z[7] + z[7] + z[8]) - (z[0] + z[1] + z[1] + z[2]);
+        }
+    }
+    
+    void RSGISCalcDEMDerivatives::calcImageWindowRow(const rsgis::img::RSGISImageWindowView &rowWindow, int width, double **outRows)
+    {
+        const double degreesToRadians = M_PI / 180.0;
+        const double radiansToDegrees = 180.0 / M_PI;
+        const double nan = std::numeric_limits<double>::signaling_NaN();
+        
+        this->calcGradientRow(rowWindow, width);
+        
+        bool needSlope = false;
+        bool needAspect = false;
+        for(std::vector<RSGISDEMDerivative>::iterator iterDeriv = derivatives.begin(); iterDeriv != derivatives.end(); ++iterDeriv)
+        {
+            bool rayAngle = ((*iterDeriv) == rsgis_dem_incidence) || ((*iterDeriv) == rsgis_dem_exitance);
+            needSlope = needSlope || rayAngle || ((*iterDeriv) == rsgis_dem_slope_deg) || ((*iterDeriv) == rsgis_dem_slope_rad);
+            needAspect = needAspect || rayAngle || ((*iterDeriv) == rsgis_dem_aspect);
+        }
+        
+        const double *gEW = this->gradEW.data();
+        const double *gSN = this->gradSN.data();
+        if(needSlope)
+        {
+            this->slopeRad.resize(width);
+            for(int x = 0; x < width; ++x)
+            {
+                const double dx = gEW[x] / ewRes;
+                const double dy = gSN[x] / nsRes;
+                this->slopeRad[x] = atan(sqrt((dx * dx) + (dy * dy))/8);
+            }
+        }
+        if(needAspect)
+        {
+            // Aspect in radians [0, 2pi), NaN for flat areas.
+            this->aspectRad.resize(width);
+            for(int x = 0; x < width; ++x)
+            {
+                double aspect = atan2(-(gEW[x] / ewRes), gSN[x] / nsRes)*radiansToDegrees;
+                if(aspect < 0)
+                {
+                    aspect += 360.0;
+                }
+                if(aspect == 360.0)
+                {
+                    aspect = 0.0;
+                }
+                this->aspectRad[x] = ((gEW[x] == 0) && (gSN[x] == 0))?nan:(aspect * degreesToRadians);
+            }
+        }
+        
+        for(size_t n = 0; n < derivatives.size(); ++n)
+        {
+            double *out = outRows[n];
+            switch(derivatives[n])
+            {
+                case rsgis_dem_slope_deg:
+                {
+                    for(int x = 0; x < width; ++x)
+                    {
+                        out[x] = this->validPxl[x]?(this->slopeRad[x] * radiansToDegrees):0.0;
+                    }
+                    break;
+                }
+                case rsgis_dem_slope_rad:
+                {
+                    for(int x = 0; x < width; ++x)
+                    {
+                        out[x] = this->validPxl[x]?this->slopeRad[x]:0.0;
+                    }
+                    break;
+                }
+                case rsgis_dem_aspect:
+                {
+                    for(int x = 0; x < width; ++x)
+                    {
+                        out[x] = this->validPxl[x]?(this->aspectRad[x] * radiansToDegrees):nan;
+                    }
+                    break;
+                }
+                case rsgis_dem_hillshade:
+                {
+                    double hsSunAzimuth = (360 - this->sunAzimuth) + 90;
+                    if(hsSunAzimuth > 360)
+                    {
+                        hsSunAzimuth = hsSunAzimuth - 360;
+                    }
+                    const double sunZenRad = sunZenith * degreesToRadians;
+                    const double sinSunZen = sin(sunZenRad);
+                    const double cosSunZen = cos(sunZenRad);
+                    const double sunAzRad = hsSunAzimuth * degreesToRadians;
+                    for(int x = 0; x < width; ++x)
+                    {
+                        const double dx = gEW[x] / (ewRes*8);
+                        const double dy = -gSN[x] / (nsRes*8);
+                        const double xx_plus_yy = dx * dx + dy * dy;
+                        const double aspect = atan2(dy,dx);
+                        double cang = (sinSunZen - cosSunZen * sqrt(xx_plus_yy) * sin(aspect - (sunAzRad-M_PI/2))) / sqrt(1 + 1 * xx_plus_yy);
+                        cang = (cang <= 0.0)?1.0:(1.0 + (254.0 * cang));
+                        out[x] = this->validPxl[x]?cang:1.0;
+                    }
+                    break;
+                }
+                case rsgis_dem_incidence:
+                case rsgis_dem_exitance:
+                {
+                    const bool incidence = (derivatives[n] == rsgis_dem_incidence);
+                    const double rayZenRad = (incidence?sunZenith:viewZenith) * degreesToRadians;
+                    const double rayAzRad = (incidence?sunAzimuth:viewAzimuth) * degreesToRadians;
+                    // For incidence invalid and flat pixels take the solar zenith, for exitance
+                    // flat pixels use an aspect of 0 and invalid pixels are 0.
+                    const double invalidVal = incidence?sunZenith:0.0;
+                    const double flatAspect = incidence?nan:0.0;
+                    
+                    // UNIT VECTOR FOR INCIDENT / EXITANCE RAY
+                    const double rA = sin(rayZenRad) * cos(rayAzRad);
+                    const double rB = sin(rayZenRad) * sin(rayAzRad);
+                    const double rC = cos(rayZenRad);
+                    for(int x = 0; x < width; ++x)
+                    {
+                        const double aspRad = boost::math::isnan(this->aspectRad[x])?flatAspect:this->aspectRad[x];
+                        // UNIT VECTOR FOR SURFACE
+                        const double pA = sin(this->slopeRad[x]) * cos(aspRad);
+                        const double pB = sin(this->slopeRad[x]) * sin(aspRad);
+                        const double pC = cos(this->slopeRad[x]);
+                        double angle = acos((pA*rA)+(pB*rB)+(pC*rC)) * radiansToDegrees;
+                        if(boost::math::isnan(angle) || !this->validPxl[x])
+                        {
+                            angle = invalidVal;
+                        }
+                        out[x] = angle;
+                    }
+                    break;
+                }
+                default:
+                    throw rsgis::img::RSGISImageCalcException("DEM derivative is not recognised.");
+            }
+        }
+    }
+    
+    RSGISCalcDEMDerivatives::~RSGISCalcDEMDerivatives()
+    {
+        
+    }
+    
+    
+    
     
     
     
@@ -1292,6 +1726,259 @@ namespace rsgis{namespace calib{
     
     
     
+    RSGISFillDEMVoids::RSGISFillDEMVoids(double holeValue, bool laplacian, unsigned int maxIterations, double tolerance)
+    {
+        this->holeValue = holeValue;
+        this->laplacian = laplacian;
+        this->maxIterations = maxIterations;
+        this->tolerance = tolerance;
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+    
+    void RSGISFillDEMVoids::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+    
+    void RSGISFillDEMVoids::fillVoids(GDALDataset *dem, unsigned int band, GDALDataset *outDEM)
+    {
+        if((band == 0) || (band > ((unsigned int)dem->GetRasterCount())))
+        {
+            throw rsgis::img::RSGISImageCalcException("Specified image band is not within the image.");
+        }
+        if((outDEM->GetRasterXSize() != dem->GetRasterXSize()) || (outDEM->GetRasterYSize() != dem->GetRasterYSize()))
+        {
+            throw rsgis::img::RSGISImageCalcException("The output image must be the same size as the DEM.");
+        }
+        
+        const long width = dem->GetRasterXSize();
+        const long height = dem->GetRasterYSize();
+        
+        std::vector<float> demVals(width * height);
+        if(dem->GetRasterBand(band)->RasterIO(GF_Read, 0, 0, width, height, demVals.data(), width, height, GDT_Float32, 0, 0) != CE_None)
+        {
+            throw rsgis::img::RSGISImageCalcException("Could not read the DEM.");
+        }
+        
+        std::vector< std::vector<size_t> > voids;
+        this->labelVoids(demVals, width, height, voids);
+        std::cout << "Found " << voids.size() << " voids\n";
+        
+        // Each void only writes to its own pixels and reads its own pixels or valid
+        // pixels, so the voids can be filled concurrently.
+        std::vector<unsigned char> known(width * height, 0);
+        for(size_t i = 0; i < demVals.size(); ++i)
+        {
+            known[i] = this->isHole(demVals[i])?0:1;
+        }
+        
+        // Fill the largest voids first so they are not left to the end on one thread.
+        std::vector<size_t> voidOrder(voids.size());
+        for(size_t i = 0; i < voids.size(); ++i)
+        {
+            voidOrder[i] = i;
+        }
+        std::sort(voidOrder.begin(), voidOrder.end(), [&voids](size_t a, size_t b){return voids[a].size() > voids[b].size();});
+        
+        rsgis::utils::parallelFor(voids.size(), this->numThreads, [&](size_t i, unsigned int)
+        {
+            const std::vector<size_t> &voidPxls = voids[voidOrder[i]];
+            this->fillVoidWavefront(demVals, known, voidPxls, width, height);
+            if(this->laplacian)
+            {
+                this->fillVoidLaplacian(demVals, known, voidPxls, width, height);
+            }
+        });
+        
+        if(outDEM->GetRasterBand(1)->RasterIO(GF_Write, 0, 0, width, height, demVals.data(), width, height, GDT_Float32, 0, 0) != CE_None)
+        {
+            throw rsgis::img::RSGISImageCalcException("Could not write the filled DEM.");
+        }
+        outDEM->GetRasterBand(1)->SetNoDataValue(holeValue);
+    }
+    
+    void RSGISFillDEMVoids::labelVoids(const std::vector<float> &demVals, long width, long height, std::vector< std::vector<size_t> > &voids)
+    {
+        std::vector<unsigned char> visited(width * height, 0);
+        std::vector<size_t> stack;
+        for(size_t start = 0; start < demVals.size(); ++start)
+        {
+            if(visited[start] || !this->isHole(demVals[start]))
+            {
+                continue;
+            }
+            
+            voids.push_back(std::vector<size_t>());
+            std::vector<size_t> &voidPxls = voids.back();
+            visited[start] = 1;
+            stack.push_back(start);
+            while(!stack.empty())
+            {
+                size_t idx = stack.back();
+                stack.pop_back();
+                voidPxls.push_back(idx);
+                
+                long x = idx % width;
+                long y = idx / width;
+                for(long ny = std::max(0l, y-1); ny <= std::min(height-1, y+1); ++ny)
+                {
+                    for(long nx = std::max(0l, x-1); nx <= std::min(width-1, x+1); ++nx)
+                    {
+                        size_t nIdx = (ny * width) + nx;
+                        if(!visited[nIdx] && this->isHole(demVals[nIdx]))
+                        {
+                            visited[nIdx] = 1;
+                            stack.push_back(nIdx);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    
+    void RSGISFillDEMVoids::fillVoidWavefront(std::vector<float> &demVals, std::vector<unsigned char> &known, const std::vector<size_t> &voidPxls, long width, long height)
+    {
+        // known: 0 = hole, 1 = valid or filled, 2 = hole queued in the current wavefront.
+        std::vector<size_t> front;
+        for(std::vector<size_t>::const_iterator iterPxl = voidPxls.begin(); iterPxl != voidPxls.end(); ++iterPxl)
+        {
+            long x = (*iterPxl) % width;
+            long y = (*iterPxl) / width;
+            bool onBoundary = false;
+            for(long ny = std::max(0l, y-1); (ny <= std::min(height-1, y+1)) && !onBoundary; ++ny)
+            {
+                for(long nx = std::max(0l, x-1); nx <= std::min(width-1, x+1); ++nx)
+                {
+                    if(known[(ny * width) + nx] == 1)
+                    {
+                        onBoundary = true;
+                        break;
+                    }
+                }
+            }
+            if(onBoundary)
+            {
+                known[*iterPxl] = 2;
+                front.push_back(*iterPxl);
+            }
+        }
+        
+        std::vector<size_t> nextFront;
+        std::vector<float> frontVals;
+        while(!front.empty())
+        {
+            // Calculate the whole ring before updating it so the fill does not depend on the pixel order.
+            frontVals.resize(front.size());
+            for(size_t i = 0; i < front.size(); ++i)
+            {
+                long x = front[i] % width;
+                long y = front[i] / width;
+                double sumVals = 0.0;
+                unsigned int nVals = 0;
+                for(long ny = std::max(0l, y-1); ny <= std::min(height-1, y+1); ++ny)
+                {
+                    for(long nx = std::max(0l, x-1); nx <= std::min(width-1, x+1); ++nx)
+                    {
+                        size_t nIdx = (ny * width) + nx;
+                        if(known[nIdx] == 1)
+                        {
+                            sumVals += demVals[nIdx];
+                            ++nVals;
+                        }
+                    }
+                }
+                frontVals[i] = sumVals / nVals;
+            }
+            
+            nextFront.clear();
+            for(size_t i = 0; i < front.size(); ++i)
+            {
+                demVals[front[i]] = frontVals[i];
+                known[front[i]] = 1;
+            }
+            for(size_t i = 0; i < front.size(); ++i)
+            {
+                long x = front[i] % width;
+                long y = front[i] / width;
+                for(long ny = std::max(0l, y-1); ny <= std::min(height-1, y+1); ++ny)
+                {
+                    for(long nx = std::max(0l, x-1); nx <= std::min(width-1, x+1); ++nx)
+                    {
+                        size_t nIdx = (ny * width) + nx;
+                        if(known[nIdx] == 0)
+                        {
+                            known[nIdx] = 2;
+                            nextFront.push_back(nIdx);
+                        }
+                    }
+                }
+            }
+            front.swap(nextFront);
+        }
+    }
+    
+    void RSGISFillDEMVoids::fillVoidLaplacian(std::vector<float> &demVals, const std::vector<unsigned char> &known, const std::vector<size_t> &voidPxls, long width, long height)
+    {
+        if(known[voidPxls.front()] != 1)
+        {
+            // No valid boundary - the void was not filled.
+            return;
+        }
+        
+        const double omega = 1.8;
+        for(unsigned int iter = 0; iter < maxIterations; ++iter)
+        {
+            double maxChange = 0.0;
+            for(std::vector<size_t>::const_iterator iterPxl = voidPxls.begin(); iterPxl != voidPxls.end(); ++iterPxl)
+            {
+                long x = (*iterPxl) % width;
+                long y = (*iterPxl) / width;
+                double sumVals = 0.0;
+                unsigned int nVals = 0;
+                if(x > 0)
+                {
+                    sumVals += demVals[(*iterPxl)-1];
+                    ++nVals;
+                }
+                if(x < (width-1))
+                {
+                    sumVals += demVals[(*iterPxl)+1];
+                    ++nVals;
+                }
+                if(y > 0)
+                {
+                    sumVals += demVals[(*iterPxl)-width];
+                    ++nVals;
+                }
+                if(y < (height-1))
+                {
+                    sumVals += demVals[(*iterPxl)+width];
+                    ++nVals;
+                }
+                if(nVals == 0)
+                {
+                    continue;
+                }
+                double change = omega * ((sumVals / nVals) - demVals[*iterPxl]);
+                demVals[*iterPxl] += change;
+                maxChange = std::max(maxChange, fabs(change));
+            }
+            if(maxChange < tolerance)
+            {
+                break;
+            }
+        }
+    }
+    
+    RSGISFillDEMVoids::~RSGISFillDEMVoids()
+    {
+        
+    }
+    
+    
+    
+    
+    
     RSGISFilterDTMWithAspectMedianFilter::RSGISFilterDTMWithAspectMedianFilter(float aspectRange, double noDataVal) : rsgis::img::RSGISCalcImageValue(1)
     {
         this->aspectRange = aspectRange;
@@ -26,7 +26,16 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <cstdlib>
 #include <math.h>
+#include <cmath>
 
 #include "gdal_priv.h"
 
@@ -39,6 +48,7 @@
 
 #include "img/RSGISImageCalcException.h"
 #include "img/RSGISCalcImageValue.h"
+#include "img/RSGISImageRowRingBuffer.h"
 #include "img/RSGISImageUtils.h"
 #include "img/RSGISExtractImagePixelsInPolygon.h"
 
@@ -48,6 +58,7 @@
 #include "math/RSGISMathsUtils.h"
 
 #include <boost/math/special_functions/fpclassify.hpp>
+#include "common/RSGISParallel.h"
 
 #ifndef M_PI
 # define M_PI  3.1415926535897932384626433832795
@@ -219,6 +230,40 @@ namespace rsgis{namespace calib{
         rsgis::img::RSGISExtractImagePixelsOnLine *extractPixels;
 	};
     
+    /**
+     * Calculates a binary shadow mask (1 = shadow) by sweeping along lines
+     * aligned with the sun azimuth rather than tracing a ray from every pixel.
+     * Along each line, travelling away from the sun, the height of the shadow
+     * surface cast by the terrain already passed is carried forward (dropping
+     * by the tangent of the sun elevation for each step) so a pixel is in cast
+     * shadow where it is below that height. Every pixel is therefore visited
+     * once for the cast shadow, and pixels facing away from the sun are also
+     * masked (self shadow). The lines are shared between threads
+     * (RSGISLIB_NUM_THREADS or setNumThreads). The DEM band is read into
+     * memory as a whole.
+     */
+    class DllExport RSGISCalcShadowMaskHorizonSweep
+	{
+	public:
+		RSGISCalcShadowMaskHorizonSweep(float ewRes, float nsRes, float sunZenith, float sunAzimuth, double noDataVal);
+        void setNumThreads(unsigned int numThreads);
+        /**
+         * Calculate the shadow mask for band (starting at 1) of the DEM and
+         * write it to the first band of the output dataset, which must have
+         * the same size as the DEM.
+         */
+		void calcShadowMask(GDALDataset *dem, unsigned int band, GDALDataset *outMask);
+		~RSGISCalcShadowMaskHorizonSweep();
+    protected:
+        void calcSelfShadowRows(const std::vector<float> &dem, std::vector<unsigned char> &mask, long width, long height, long startRow, long endRow);
+        float ewRes;
+        float nsRes;
+        float sunZenith;
+        float sunAzimuth;
+        double noDataVal;
+        unsigned int numThreads;
+	};
+    
     class DllExport RSGISCalcRayIncidentAngle : public rsgis::img::RSGISCalcImageValue
 	{
 	public: 
@@ -294,6 +339,48 @@ namespace rsgis{namespace calib{
 	};
     
     
+    enum RSGISDEMDerivative
+    {
+        rsgis_dem_slope_deg,
+        rsgis_dem_slope_rad,
+        rsgis_dem_aspect,
+        rsgis_dem_hillshade,
+        rsgis_dem_incidence,
+        rsgis_dem_exitance
+    };
+    
+    /**
+     * Calculates any set of DEM derivatives (one output band per derivative, in the
+     * order given) in a single pass with a 3x3 window. The gradient is calculated once
+     * per pixel for a whole image row and each derivative is then calculated from the
+     * gradient row. The outputs match RSGISCalcSlope, RSGISCalcAspect, RSGISCalcHillShade,
+     * RSGISCalcRayIncidentAngle and RSGISCalcRayExitanceAngle.
+     */
+    class DllExport RSGISCalcDEMDerivatives : public rsgis::img::RSGISCalcImageValue
+	{
+	public:
+		RSGISCalcDEMDerivatives(std::vector<RSGISDEMDerivative> derivatives, unsigned int band, float ewRes, float nsRes, double noDataVal, float sunZenith=0, float sunAzimuth=0, float viewZenith=0, float viewAzimuth=0);
+        bool useImageWindowRows(){return true;};
+        void calcImageWindowRow(const rsgis::img::RSGISImageWindowView &rowWindow, int width, double **outRows);
+		~RSGISCalcDEMDerivatives();
+    protected:
+        void calcGradientRow(const rsgis::img::RSGISImageWindowView &rowWindow, int width);
+        std::vector<RSGISDEMDerivative> derivatives;
+        unsigned int band;
+        float ewRes;
+        float nsRes;
+        double noDataVal;
+        float sunZenith;
+        float sunAzimuth;
+        float viewZenith;
+        float viewAzimuth;
+        /** Horn gradients (east minus west, south minus north) without the resolution scaling. */
+        std::vector<double> gradEW;
+        std::vector<double> gradSN;
+        std::vector<unsigned char> validPxl;
+        std::vector<double> slopeRad;
+        std::vector<double> aspectRad;
+	};
     
     
     class DllExport RSGISFillDEMHoles : public rsgis::img::RSGISCalcImageValue
@@ -340,6 +427,43 @@ namespace rsgis{namespace calib{
         float holeValue;
 	};
     
+    /**
+     * Fills the voids (pixels equal to the hole value) within a DEM. Each void
+     * (8-connected region of hole pixels) is labelled once and then filled
+     * independently, with the voids shared between threads (RSGISLIB_NUM_THREADS
+     * or setNumThreads), so the cost depends on the void area rather than the
+     * image area times the number of passes.
+     *
+     * Voids are filled inwards from their boundary as a wavefront, each ring
+     * taking the mean of its already known 8-neighbours. If laplacian is true
+     * the wavefront fill is then used as the starting surface for a successive
+     * over-relaxation solution of Laplace's equation over the void, giving a
+     * smooth surface matching the void boundary. Voids with no valid pixels
+     * around them are left as holes. The DEM band is read into memory.
+     */
+    class DllExport RSGISFillDEMVoids
+	{
+	public:
+		RSGISFillDEMVoids(double holeValue, bool laplacian=false, unsigned int maxIterations=1000, double tolerance=0.001);
+        void setNumThreads(unsigned int numThreads);
+        /**
+         * Fill the voids in band (starting at 1) of the DEM, writing the result
+         * to the first band of the output dataset (same size as the DEM).
+         */
+		void fillVoids(GDALDataset *dem, unsigned int band, GDALDataset *outDEM);
+		~RSGISFillDEMVoids();
+    protected:
+        bool isHole(float val){return (val == holeValue) || std::isnan(val);};
+        void labelVoids(const std::vector<float> &demVals, long width, long height, std::vector< std::vector<size_t> > &voids);
+        void fillVoidWavefront(std::vector<float> &demVals, std::vector<unsigned char> &known, const std::vector<size_t> &voidPxls, long width, long height);
+        void fillVoidLaplacian(std::vector<float> &demVals, const std::vector<unsigned char> &known, const std::vector<size_t> &voidPxls, long width, long height);
+        double holeValue;
+        bool laplacian;
+        unsigned int maxIterations;
+        double tolerance;
+        unsigned int numThreads;
+	};
+    
     class DllExport RSGISFilterDTMWithAspectMedianFilter : public rsgis::img::RSGISCalcImageValue
 	{
 	public:
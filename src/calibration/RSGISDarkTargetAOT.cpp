@@ -0,0 +1,346 @@
+/*
+ *  RSGISDarkTargetAOT.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISDarkTargetAOT.h"
+
+namespace rsgis{namespace calib{
+
+    RSGISDarkTargetAOTEstimator::RSGISDarkTargetAOTEstimator(std::vector<LUT6SBaseElevAOT> *lut, unsigned int radBand, unsigned int regionSize, float darkPercentile, float darkTargetRefl, unsigned int minPxls, unsigned int numBins)
+    {
+        if((lut == NULL) || lut->empty())
+        {
+            throw rsgis::img::RSGISImageCalcException("The LUT must have at least one elevation.");
+        }
+        if(regionSize == 0)
+        {
+            throw rsgis::img::RSGISImageCalcException("The region size must be greater than zero.");
+        }
+        if((darkPercentile < 0) || (darkPercentile > 1))
+        {
+            throw rsgis::img::RSGISImageCalcException("The dark target percentile must be between 0 and 1.");
+        }
+        this->radBand = radBand;
+        this->regionSize = regionSize;
+        this->darkPercentile = darkPercentile;
+        this->darkTargetRefl = darkTargetRefl;
+        this->minPxls = std::max<unsigned int>(minPxls, 1);
+        this->numBins = std::max<unsigned int>(numBins, 1);
+        this->numRegX = 0;
+        this->numRegY = 0;
+
+        // The coefficients of the dark target band, in order of AOT, for each elevation.
+        float radMax = 0;
+        bool first = true;
+        for(std::vector<LUT6SBaseElevAOT>::iterator iterLUT = lut->begin(); iterLUT != lut->end(); ++iterLUT)
+        {
+            if((*iterLUT).aotLUT.empty())
+            {
+                throw rsgis::img::RSGISImageCalcException("Each elevation of the LUT must have at least one AOT.");
+            }
+            std::vector<DarkTargetCoeffs> elevCoeffs;
+            for(std::vector<LUT6SAOT>::iterator iterAOTLUT = (*iterLUT).aotLUT.begin(); iterAOTLUT != (*iterLUT).aotLUT.end(); ++iterAOTLUT)
+            {
+                bool found = false;
+                for(unsigned int i = 0; i < (*iterAOTLUT).numValues; ++i)
+                {
+                    if((*iterAOTLUT).imageBands[i] == radBand)
+                    {
+                        DarkTargetCoeffs aotCoeffs;
+                        aotCoeffs.aot = (*iterAOTLUT).aot;
+                        aotCoeffs.aX = (*iterAOTLUT).aX[i];
+                        aotCoeffs.bX = (*iterAOTLUT).bX[i];
+                        aotCoeffs.cX = (*iterAOTLUT).cX[i];
+                        if(aotCoeffs.aX == 0)
+                        {
+                            throw rsgis::img::RSGISImageCalcException("The aX coefficient of the dark target band must not be zero.");
+                        }
+                        elevCoeffs.push_back(aotCoeffs);
+                        found = true;
+                        break;
+                    }
+                }
+                if(!found)
+                {
+                    throw rsgis::img::RSGISImageCalcException("The dark target band does not have coefficients for every AOT of the LUT.");
+                }
+
+                // The radiances giving surface reflectances of 0 and 1.
+                const DarkTargetCoeffs &aotCoeffs = elevCoeffs.back();
+                float rad0 = aotCoeffs.bX / aotCoeffs.aX;
+                float rad1 = rad0;
+                if(aotCoeffs.cX < 1)
+                {
+                    rad1 = ((1.0 / (1.0 - aotCoeffs.cX)) + aotCoeffs.bX) / aotCoeffs.aX;
+                }
+                if(first)
+                {
+                    this->radMin = std::min(rad0, rad1);
+                    radMax = std::max(rad0, rad1);
+                    first = false;
+                }
+                this->radMin = std::min(this->radMin, std::min(rad0, rad1));
+                radMax = std::max(radMax, std::max(rad0, rad1));
+            }
+            std::stable_sort(elevCoeffs.begin(), elevCoeffs.end(), [](const DarkTargetCoeffs &a, const DarkTargetCoeffs &b){return a.aot < b.aot;});
+            this->elevs.push_back((*iterLUT).elev);
+            this->coeffs.push_back(elevCoeffs);
+        }
+        if(radMax <= this->radMin)
+        {
+            radMax = this->radMin + 1;
+        }
+        this->binWidth = (radMax - this->radMin) / this->numBins;
+
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+
+    void RSGISDarkTargetAOTEstimator::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+
+    float RSGISDarkTargetAOTEstimator::estimateAOT(GDALDataset *radDS, GDALDataset *demDS, float noDataVal, bool useNoDataVal, std::string outputImage, std::string gdalFormat)
+    {
+        int width = radDS->GetRasterXSize();
+        int height = radDS->GetRasterYSize();
+        if((this->radBand == 0) || (this->radBand > ((unsigned int)radDS->GetRasterCount())))
+        {
+            throw rsgis::img::RSGISImageCalcException("The dark target band is not within the radiance image.");
+        }
+        if((demDS != NULL) && ((demDS->GetRasterXSize() != width) || (demDS->GetRasterYSize() != height)))
+        {
+            throw rsgis::img::RSGISImageCalcException("The DEM must be the same size as the radiance image.");
+        }
+
+        this->numRegX = ((width - 1) / this->regionSize) + 1;
+        this->numRegY = ((height - 1) / this->regionSize) + 1;
+        std::vector<float> regionAOT(((size_t)this->numRegX) * this->numRegY, std::numeric_limits<float>::quiet_NaN());
+
+        // Each thread takes whole rows of regions so every region is built
+        // by one thread and no histograms need to be merged.
+        std::mutex ioMutex;
+        rsgis::utils::parallelFor(this->numRegY, this->numThreads, [&](size_t regRow, unsigned int)
+        {
+            this->processRegionRow(regRow, radDS, demDS, noDataVal, useNoDataVal, &ioMutex, &regionAOT);
+        });
+
+        // The AOT of the image is the median of the regions.
+        std::vector<float> validAOT;
+        for(size_t i = 0; i < regionAOT.size(); ++i)
+        {
+            if(!std::isnan(regionAOT[i]))
+            {
+                validAOT.push_back(regionAOT[i]);
+            }
+        }
+        if(validAOT.empty())
+        {
+            throw rsgis::img::RSGISImageCalcException("No region had enough valid pixels to estimate the AOT.");
+        }
+        std::sort(validAOT.begin(), validAOT.end());
+        size_t midIdx = validAOT.size() / 2;
+        float imageAOT = validAOT[midIdx];
+        if((validAOT.size() % 2) == 0)
+        {
+            imageAOT = (validAOT[midIdx-1] + validAOT[midIdx]) / 2;
+        }
+        for(size_t i = 0; i < regionAOT.size(); ++i)
+        {
+            if(std::isnan(regionAOT[i]))
+            {
+                regionAOT[i] = imageAOT;
+            }
+        }
+        std::cout << "AOT estimated for " << validAOT.size() << " of " << regionAOT.size() << " regions, image AOT: " << imageAOT << std::endl;
+
+        double trans[6];
+        radDS->GetGeoTransform(trans);
+        trans[1] *= this->regionSize;
+        trans[2] *= this->regionSize;
+        trans[4] *= this->regionSize;
+        trans[5] *= this->regionSize;
+        rsgis::img::RSGISImageUtils imgUtils;
+        GDALDataset *outDS = NULL;
+        try
+        {
+            outDS = imgUtils.createBlankImage(outputImage, trans, this->numRegX, this->numRegY, 1, std::string(radDS->GetProjectionRef()), 0, gdalFormat, GDT_Float32);
+        }
+        catch(rsgis::RSGISImageException &e)
+        {
+            throw rsgis::img::RSGISImageCalcException(e.what());
+        }
+        CPLErr err = outDS->GetRasterBand(1)->RasterIO(GF_Write, 0, 0, this->numRegX, this->numRegY, regionAOT.data(), this->numRegX, this->numRegY, GDT_Float32, 0, 0);
+        GDALClose(outDS);
+        if(err != CE_None)
+        {
+            throw rsgis::img::RSGISImageCalcException("Could not write the AOT image.");
+        }
+
+        return imageAOT;
+    }
+
+    void RSGISDarkTargetAOTEstimator::processRegionRow(unsigned int regRow, GDALDataset *radDS, GDALDataset *demDS, float noDataVal, bool useNoDataVal, std::mutex *ioMutex, std::vector<float> *regionAOT)
+    {
+        int width = radDS->GetRasterXSize();
+        int height = radDS->GetRasterYSize();
+        int yStart = regRow * this->regionSize;
+        int nRows = std::min<int>(this->regionSize, height - yStart);
+        int chunkRows = std::min(nRows, 256);
+
+        std::vector< std::vector<unsigned long long> > hists(this->numRegX, std::vector<unsigned long long>(this->numBins, 0));
+        std::vector<unsigned long long> counts(this->numRegX, 0);
+        std::vector<double> elevSums(this->numRegX, 0);
+        std::vector<float> radVals(((size_t)width) * chunkRows);
+        std::vector<float> demVals((demDS != NULL)?radVals.size():0);
+
+        GDALRasterBand *radBandObj = radDS->GetRasterBand(this->radBand);
+        GDALRasterBand *demBandObj = (demDS != NULL)?demDS->GetRasterBand(1):NULL;
+        const float maxBin = this->numBins - 1;
+        for(int yOff = 0; yOff < nRows; yOff += chunkRows)
+        {
+            int nChunkRows = std::min(chunkRows, nRows - yOff);
+            {
+                std::lock_guard<std::mutex> lock(*ioMutex);
+                if(radBandObj->RasterIO(GF_Read, 0, yStart + yOff, width, nChunkRows, radVals.data(), width, nChunkRows, GDT_Float32, 0, 0) != CE_None)
+                {
+                    throw rsgis::img::RSGISImageCalcException("Could not read the radiance image.");
+                }
+                if((demBandObj != NULL) && (demBandObj->RasterIO(GF_Read, 0, yStart + yOff, width, nChunkRows, demVals.data(), width, nChunkRows, GDT_Float32, 0, 0) != CE_None))
+                {
+                    throw rsgis::img::RSGISImageCalcException("Could not read the DEM.");
+                }
+            }
+
+            for(unsigned int rx = 0; rx < this->numRegX; ++rx)
+            {
+                int xStart = rx * this->regionSize;
+                int xEnd = std::min<int>(xStart + this->regionSize, width);
+                unsigned long long *hist = hists[rx].data();
+                unsigned long long count = 0;
+                double elevSum = 0;
+                for(int r = 0; r < nChunkRows; ++r)
+                {
+                    size_t rowOff = ((size_t)r) * width;
+                    for(int x = xStart; x < xEnd; ++x)
+                    {
+                        float val = radVals[rowOff + x];
+                        if(std::isnan(val) || (useNoDataVal && (val == noDataVal)))
+                        {
+                            continue;
+                        }
+                        float binPos = (val - this->radMin) / this->binWidth;
+                        binPos = (binPos < 0)?0:binPos;
+                        binPos = (binPos > maxBin)?maxBin:binPos;
+                        ++hist[(unsigned int)binPos];
+                        ++count;
+                        if(demBandObj != NULL)
+                        {
+                            elevSum += demVals[rowOff + x];
+                        }
+                    }
+                }
+                counts[rx] += count;
+                elevSums[rx] += elevSum;
+            }
+        }
+
+        for(unsigned int rx = 0; rx < this->numRegX; ++rx)
+        {
+            if(counts[rx] < this->minPxls)
+            {
+                continue;
+            }
+            float darkRad = this->findDarkTarget(hists[rx], counts[rx]);
+            unsigned int elevIdx = (demBandObj != NULL)?this->findElevIdx(elevSums[rx] / counts[rx]):0;
+            regionAOT->at((((size_t)regRow) * this->numRegX) + rx) = this->invertAOT(elevIdx, darkRad);
+        }
+    }
+
+    float RSGISDarkTargetAOTEstimator::findDarkTarget(const std::vector<unsigned long long> &hist, unsigned long long count)
+    {
+        // The value at the percentile, interpolated within its bin.
+        double target = this->darkPercentile * count;
+        unsigned long long cumCount = 0;
+        for(unsigned int i = 0; i < this->numBins; ++i)
+        {
+            if((hist[i] > 0) && ((cumCount + hist[i]) >= target))
+            {
+                double binProp = (target - cumCount) / hist[i];
+                return this->radMin + ((i + binProp) * this->binWidth);
+            }
+            cumCount += hist[i];
+        }
+        return this->radMin + (this->numBins * this->binWidth);
+    }
+
+    float RSGISDarkTargetAOTEstimator::invertAOT(unsigned int elevIdx, float darkRad)
+    {
+        // The surface reflectance of the dark target for each AOT, as
+        // RSGISApply6SCoefficientsElevAOTLUTParam, falls as the AOT (and so
+        // the path radiance removed) increases; the AOT giving darkTargetRefl
+        // is interpolated between the pair of AOTs either side of it.
+        const std::vector<DarkTargetCoeffs> &elevCoeffs = this->coeffs[elevIdx];
+        double prevRefl = 0;
+        double closestDiff = 0;
+        float closestAOT = elevCoeffs[0].aot;
+        for(size_t k = 0; k < elevCoeffs.size(); ++k)
+        {
+            double tmpVal = (elevCoeffs[k].aX * darkRad) - elevCoeffs[k].bX;
+            double refl = tmpVal / (1.0 + (elevCoeffs[k].cX * tmpVal));
+            if((k > 0) && (((prevRefl - this->darkTargetRefl) * (refl - this->darkTargetRefl)) <= 0) && (prevRefl != refl))
+            {
+                double prop = (this->darkTargetRefl - prevRefl) / (refl - prevRefl);
+                return elevCoeffs[k-1].aot + (prop * (elevCoeffs[k].aot - elevCoeffs[k-1].aot));
+            }
+            double diff = std::fabs(refl - this->darkTargetRefl);
+            if((k == 0) || (diff < closestDiff))
+            {
+                closestDiff = diff;
+                closestAOT = elevCoeffs[k].aot;
+            }
+            prevRefl = refl;
+        }
+        // Outside the range of the LUT so the nearest AOT is used.
+        return closestAOT;
+    }
+
+    unsigned int RSGISDarkTargetAOTEstimator::findElevIdx(float elev)
+    {
+        unsigned int elevIdx = 0;
+        float minDiff = std::fabs(this->elevs[0] - elev);
+        for(unsigned int i = 1; i < this->elevs.size(); ++i)
+        {
+            float diff = std::fabs(this->elevs[i] - elev);
+            if(diff < minDiff)
+            {
+                minDiff = diff;
+                elevIdx = i;
+            }
+        }
+        return elevIdx;
+    }
+
+    RSGISDarkTargetAOTEstimator::~RSGISDarkTargetAOTEstimator()
+    {
+
+    }
+
+}}
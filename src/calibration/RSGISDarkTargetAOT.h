@@ -0,0 +1,124 @@
+/*
+ *  RSGISDarkTargetAOT.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISDarkTargetAOT_H
+#define RSGISDarkTargetAOT_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+#include "gdal_priv.h"
+
+#include "common/RSGISImageException.h"
+#include "common/RSGISParallel.h"
+
+#include "img/RSGISImageCalcException.h"
+#include "img/RSGISImageUtils.h"
+
+#include "calibration/RSGISApply6SCoefficients.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_calib_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace calib{
+
+    /**
+     * Estimates the aerosol optical thickness (AOT) of a radiance image from
+     * dark targets. The image is divided into square regions of regionSize
+     * pixels and, in a single pass over the image (with the rows of regions
+     * shared between numThreads threads), a histogram of the radiance of the
+     * dark target band is built for each region. The darkPercentile
+     * percentile of each region is taken as its dark target and the AOT of
+     * the region is that for which the 6S coefficients (interpolated between
+     * the AOTs of the LUT, at the elevation of the LUT nearest the mean of
+     * the region) give the dark target a surface reflectance of
+     * darkTargetRefl.
+     *
+     * The LUT is as given to RSGISApply6SCoefficientsElevAOTLUTParam except
+     * that the imageBands are the band numbers (from 1) of the radiance
+     * image; radBand selects the dark target band. The histograms span the
+     * radiances the LUT maps to reflectances of 0 to 1, in numBins bins.
+     */
+    class DllExport RSGISDarkTargetAOTEstimator
+    {
+    public:
+        RSGISDarkTargetAOTEstimator(std::vector<LUT6SBaseElevAOT> *lut, unsigned int radBand, unsigned int regionSize, float darkPercentile, float darkTargetRefl, unsigned int minPxls, unsigned int numBins=4096);
+        /// Set the number of threads (0 uses the number of cores); the default is 1 or RSGISLIB_NUM_THREADS.
+        void setNumThreads(unsigned int numThreads);
+        /**
+         * Estimate the AOT of each region of radDS, written to outputImage (a
+         * pixel per region), and return the AOT of the image (the median of
+         * the regions). Regions with fewer than minPxls valid pixels are given
+         * the AOT of the image. demDS (which may be NULL, when the first
+         * elevation of the LUT is used) must be the same size as radDS.
+         */
+        float estimateAOT(GDALDataset *radDS, GDALDataset *demDS, float noDataVal, bool useNoDataVal, std::string outputImage, std::string gdalFormat);
+        ~RSGISDarkTargetAOTEstimator();
+    protected:
+        /** The coefficients of the dark target band for an AOT of the LUT */
+        struct DarkTargetCoeffs
+        {
+            float aot;
+            float aX;
+            float bX;
+            float cX;
+        };
+        void processRegionRow(unsigned int regRow, GDALDataset *radDS, GDALDataset *demDS, float noDataVal, bool useNoDataVal, std::mutex *ioMutex, std::vector<float> *regionAOT);
+        float findDarkTarget(const std::vector<unsigned long long> &hist, unsigned long long count);
+        float invertAOT(unsigned int elevIdx, float darkRad);
+        unsigned int findElevIdx(float elev);
+        std::vector<float> elevs;
+        std::vector< std::vector<DarkTargetCoeffs> > coeffs;
+        unsigned int radBand;
+        unsigned int regionSize;
+        float darkPercentile;
+        float darkTargetRefl;
+        unsigned int minPxls;
+        unsigned int numBins;
+        float radMin;
+        float binWidth;
+        unsigned int numRegX;
+        unsigned int numRegY;
+        unsigned int numThreads;
+    };
+
+}}
+
+#endif
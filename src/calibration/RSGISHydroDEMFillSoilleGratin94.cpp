@@ -34,90 +34,31 @@ namespace rsgis{namespace calib{
     {
         try
         {
-            int numBands = inDEMImgDS->GetRasterCount();
-            if(numBands != 1)
-            {
-                rsgis::img::RSGISImageCalcException("The image to be filled should only have 1 image band.");
-            }
-            
-            
-            GDALDataset **datasets = new GDALDataset*[3];
-            datasets[0] = inDEMImgDS;
-            datasets[1] = inValidImgDS;
-            datasets[2] = outImgDS;
-            
-            rsgis::img::RSGISImageUtils imgUtils;
-            if(!imgUtils.doImageSpatAndExtMatch(datasets, 3))
-            {
-                rsgis::img::RSGISImageCalcException("The images provided do not all have the same size and/or spaital header. The input image (e.g., DEM) and valid area image must be excatly the same.");
-            }
-            delete[] datasets;
-            
-            rsgis::img::ImageStats *stats = new rsgis::img::ImageStats();
-            
-            int useNoData = false;
-            double noDataVal = inDEMImgDS->GetRasterBand(1)->GetNoDataValue(&useNoData);
+            double noDataVal = 0.0;
+            std::vector<Q2DPxl> seedPxls;
+            borderVal = this->initFill(inDEMImgDS, inValidImgDS, outImgDS, calcBorderVal, borderVal, &noDataVal, &seedPxls);
             
-            if(useNoData)
-            {
-                std::cout << "Fill layer has a no data value of " << noDataVal << std::endl;
-            }
-            
-            if(calcBorderVal)
-            {
-                rsgis::img::RSGISImageStatistics imgStats;
-                imgStats.calcImageStatisticsMask(inDEMImgDS, inValidImgDS, 1, &stats, &noDataVal, useNoData, 1, true);
-                
-                if((stats->mean - stats->stddev) > stats->min)
-                {
-                    borderVal = floor((stats->mean - stats->stddev)+0.5);
-                }
-                else
-                {
-                    borderVal = floor((stats->mean)+0.5);
-                }
-                std::cout << "Calculated Border Value is " << borderVal << std::endl;
-            }
-            else
-            {
-                rsgis::img::RSGISImageStatistics imgStats;
-                imgStats.calcImageStatisticsMask(inDEMImgDS, inValidImgDS, 1, &stats, &noDataVal, useNoData, 1, false);
-            }
-            
-            minVal = (long)stats->min;
-            maxVal = (long)stats->max;
-            delete stats;
-           
             numLevels = (maxVal - minVal)+1;
-            
             std::cout << "Range of Values [" << minVal << ", " << maxVal << "] Needs " << numLevels << " Levels." << std::endl;
             
-            if(!useNoData)
-            {
-                noDataVal = 0.0;
-            }
+            rsgis::img::RSGISRandomAccessRaster<float> demImg(inDEMImgDS->GetRasterBand(1));
+            rsgis::img::RSGISRandomAccessRaster<float> validImg(inValidImgDS->GetRasterBand(1));
+            rsgis::img::RSGISRandomAccessRaster<float> outImg(outImgDS->GetRasterBand(1));
             
-            // Create the hierarchical queue.
-            pxQ = new std::list<Q2DPxl>*[numLevels];
-            for(long n = 0; n < numLevels; ++n)
+            if(seedPxls.size() == 0)
             {
-                pxQ[n] = new std::list<Q2DPxl>();
+                this->getImagesEdgesToInitFill(&outImg, borderVal, &seedPxls);
             }
             
-            
-            // Initialise the output image.
-            std::cout << "Initalise the Output Image and find boundary pixels.\n";
-            RSGISInitOutputImageSoilleGratin94 initOutImg = RSGISInitOutputImageSoilleGratin94(noDataVal, maxVal, borderVal, pxQ[0]);
-            rsgis::img::RSGISCalcImage calcImage = rsgis::img::RSGISCalcImage(&initOutImg);
-            calcImage.calcImageWindowData(&inValidImgDS, 1, outImgDS, 3, true);
-            
-            if(pxQ[0]->size() == 0)
-            {
-                this->getImagesEdgesToInitFill(outImgDS->GetRasterBand(1), borderVal, pxQ[0]);
-                //throw rsgis::img::RSGISImageCalcException("The were no edge pixels with the valid mask.");
-            }
+            // Create the hierarchical queue, the boundary pixels start in the lowest level.
+            pxQ.clear();
+            pxQ.resize(numLevels);
+            pxQHead.assign(numLevels, 0);
+            pxQ[0].swap(seedPxls);
             
             Q2DPxl pxl;
+            Q2DPxl nPxls[8];
+            unsigned int numNPxls = 0;
             long hcrt = minVal;
             long imgVal = 0;
             long img2Val = 0;
@@ -132,35 +73,143 @@ namespace rsgis{namespace calib{
                     pxl = this->qPopFront(hcrt);
 
                     // Get Neightbours
-                    std::list<Q2DPxl> *nPxls = this->getNeighbours(pxl, inValidImgDS->GetRasterBand(1));
-                    for(std::list<Q2DPxl>::iterator iterNPxls = nPxls->begin(); iterNPxls != nPxls->end(); ++iterNPxls)
+                    numNPxls = this->getNeighbours(pxl, &validImg, nPxls);
+                    for(unsigned int i = 0; i < numNPxls; ++i)
                     {
-                        imgVal = this->getPxlVal((*iterNPxls), inDEMImgDS->GetRasterBand(1));
-                        img2Val = this->getPxlVal((*iterNPxls), outImgDS->GetRasterBand(1));
+                        imgVal = (long)demImg.get(nPxls[i].x, nPxls[i].y);
+                        img2Val = (long)outImg.get(nPxls[i].x, nPxls[i].y);
 
                         if(img2Val == maxVal)
                         {
                             img2Val = this->rtnMax(hcrt, imgVal);
-                            this->setPxlVal((*iterNPxls), img2Val, outImgDS->GetRasterBand(1));
+                            outImg.set(nPxls[i].x, nPxls[i].y, img2Val);
                             if(img2Val < maxVal)
                             {
-                                this->qPushBack(img2Val, (*iterNPxls));
+                                this->qPushBack(img2Val, nPxls[i]);
                             }
                         }
                     }
-                    delete nPxls;
-                    
                 }
                 
+                // The level is complete so free its memory.
+                std::vector<Q2DPxl>().swap(pxQ[n]);
                 ++hcrt;
             }
             pbar.finish();
             
-            for(long n = 0; n < numLevels; ++n)
+            outImg.flush();
+            pxQ.clear();
+            pxQHead.clear();
+        }
+        catch (rsgis::img::RSGISImageCalcException &e)
+        {
+            throw e;
+        }
+        catch (rsgis::RSGISException &e)
+        {
+            throw rsgis::img::RSGISImageCalcException(e.what());
+        }
+        catch (std::exception &e)
+        {
+            throw rsgis::img::RSGISImageCalcException(e.what());
+        }
+    }
+    
+    void RSGISHydroDEMFillSoilleGratin94::performPriorityFloodFill(GDALDataset *inDEMImgDS, GDALDataset *inValidImgDS, GDALDataset *outImgDS, bool calcBorderVal, double borderVal, double epsilon)
+    {
+        try
+        {
+            if(epsilon < 0)
+            {
+                throw rsgis::img::RSGISImageCalcException("Epsilon must not be negative.");
+            }
+            
+            double noDataVal = 0.0;
+            std::vector<Q2DPxl> seedPxls;
+            borderVal = this->initFill(inDEMImgDS, inValidImgDS, outImgDS, calcBorderVal, borderVal, &noDataVal, &seedPxls);
+            
+            rsgis::img::RSGISRandomAccessRaster<float> demImg(inDEMImgDS->GetRasterBand(1));
+            rsgis::img::RSGISRandomAccessRaster<float> validImg(inValidImgDS->GetRasterBand(1));
+            rsgis::img::RSGISRandomAccessRaster<float> outImg(outImgDS->GetRasterBand(1));
+            
+            if(seedPxls.size() == 0)
+            {
+                this->getImagesEdgesToInitFill(&outImg, borderVal, &seedPxls);
+            }
+            
+            long width = outImg.getXSize();
+            long height = outImg.getYSize();
+            std::vector<bool> visited(((size_t)width)*height, false);
+            
+            // The boundary pixels are below all others (as they are the lowest level
+            // of the hierarchical queue) so each pixel next to them keeps its elevation.
+            std::priority_queue<PFPxl, std::vector<PFPxl>, std::greater<PFPxl> > openQ;
+            std::queue<PFPxl> pitQ;
+            for(std::vector<Q2DPxl>::iterator iterPxls = seedPxls.begin(); iterPxls != seedPxls.end(); ++iterPxls)
             {
-                delete pxQ[n];
+                visited[((*iterPxls).y * width) + (*iterPxls).x] = true;
+                openQ.push(PFPxl(-std::numeric_limits<float>::infinity(), (*iterPxls).x, (*iterPxls).y));
             }
-            delete[] pxQ;            
+            std::vector<Q2DPxl>().swap(seedPxls);
+            
+            Q2DPxl nPxls[8];
+            unsigned int numNPxls = 0;
+            size_t numPxls = ((size_t)width)*height;
+            size_t numProcessed = 0;
+            std::cout << "Perform Fill:\n";
+            rsgis_tqdm pbar;
+            while((!openQ.empty()) || (!pitQ.empty()))
+            {
+                PFPxl pxl = PFPxl(0, 0, 0);
+                // Pixels within a depression are at their spill elevation so do not need ordering.
+                if(!pitQ.empty())
+                {
+                    pxl = pitQ.front();
+                    pitQ.pop();
+                }
+                else
+                {
+                    pxl = openQ.top();
+                    openQ.pop();
+                }
+                
+                if(((++numProcessed) % 65536) == 0)
+                {
+                    pbar.progress(numProcessed, numPxls);
+                }
+                
+                numNPxls = this->getNeighbours(Q2DPxl(pxl.x, pxl.y), &validImg, nPxls);
+                for(unsigned int i = 0; i < numNPxls; ++i)
+                {
+                    size_t idx = (nPxls[i].y * width) + nPxls[i].x;
+                    if(visited[idx])
+                    {
+                        continue;
+                    }
+                    visited[idx] = true;
+                    
+                    float demVal = demImg.get(nPxls[i].x, nPxls[i].y);
+                    float fillVal = pxl.elev + epsilon;
+                    if((epsilon > 0) && (fillVal <= pxl.elev) && std::isfinite(pxl.elev))
+                    {
+                        // epsilon is below the float precision at this elevation so step to the next float.
+                        fillVal = std::nextafter(pxl.elev, std::numeric_limits<float>::infinity());
+                    }
+                    if(demVal <= fillVal)
+                    {
+                        outImg.set(nPxls[i].x, nPxls[i].y, fillVal);
+                        pitQ.push(PFPxl(fillVal, nPxls[i].x, nPxls[i].y));
+                    }
+                    else
+                    {
+                        outImg.set(nPxls[i].x, nPxls[i].y, demVal);
+                        openQ.push(PFPxl(demVal, nPxls[i].x, nPxls[i].y));
+                    }
+                }
+            }
+            pbar.finish();
+            
+            outImg.flush();
         }
         catch (rsgis::img::RSGISImageCalcException &e)
         {
@@ -176,33 +225,98 @@ namespace rsgis{namespace calib{
         }
     }
     
+    double RSGISHydroDEMFillSoilleGratin94::initFill(GDALDataset *inDEMImgDS, GDALDataset *inValidImgDS, GDALDataset *outImgDS, bool calcBorderVal, double borderVal, double *noDataVal, std::vector<Q2DPxl> *seedPxls)
+    {
+        int numBands = inDEMImgDS->GetRasterCount();
+        if(numBands != 1)
+        {
+            throw rsgis::img::RSGISImageCalcException("The image to be filled should only have 1 image band.");
+        }
+        
+        GDALDataset **datasets = new GDALDataset*[3];
+        datasets[0] = inDEMImgDS;
+        datasets[1] = inValidImgDS;
+        datasets[2] = outImgDS;
+        
+        rsgis::img::RSGISImageUtils imgUtils;
+        bool imgsMatch = imgUtils.doImageSpatAndExtMatch(datasets, 3);
+        delete[] datasets;
+        if(!imgsMatch)
+        {
+            throw rsgis::img::RSGISImageCalcException("The images provided do not all have the same size and/or spaital header. The input image (e.g., DEM) and valid area image must be excatly the same.");
+        }
+        
+        rsgis::img::ImageStats *stats = new rsgis::img::ImageStats();
+        
+        int useNoData = false;
+        *noDataVal = inDEMImgDS->GetRasterBand(1)->GetNoDataValue(&useNoData);
+        
+        if(useNoData)
+        {
+            std::cout << "Fill layer has a no data value of " << *noDataVal << std::endl;
+        }
+        
+        if(calcBorderVal)
+        {
+            rsgis::img::RSGISImageStatistics imgStats;
+            imgStats.calcImageStatisticsMask(inDEMImgDS, inValidImgDS, 1, &stats, noDataVal, useNoData, 1, true);
+            
+            if((stats->mean - stats->stddev) > stats->min)
+            {
+                borderVal = floor((stats->mean - stats->stddev)+0.5);
+            }
+            else
+            {
+                borderVal = floor((stats->mean)+0.5);
+            }
+            std::cout << "Calculated Border Value is " << borderVal << std::endl;
+        }
+        else
+        {
+            rsgis::img::RSGISImageStatistics imgStats;
+            imgStats.calcImageStatisticsMask(inDEMImgDS, inValidImgDS, 1, &stats, noDataVal, useNoData, 1, false);
+        }
+        
+        minVal = (long)stats->min;
+        maxVal = (long)stats->max;
+        delete stats;
+        
+        if(!useNoData)
+        {
+            *noDataVal = 0.0;
+        }
+        
+        // Initialise the output image.
+        std::cout << "Initalise the Output Image and find boundary pixels.\n";
+        RSGISInitOutputImageSoilleGratin94 initOutImg = RSGISInitOutputImageSoilleGratin94(*noDataVal, maxVal, borderVal, seedPxls);
+        rsgis::img::RSGISCalcImage calcImage = rsgis::img::RSGISCalcImage(&initOutImg);
+        calcImage.calcImageWindowData(&inValidImgDS, 1, outImgDS, 3, true);
+        
+        return borderVal;
+    }
+    
     bool RSGISHydroDEMFillSoilleGratin94::qEmpty(long hcrt)
     {
         long qIdx = hcrt - this->minVal;
-        bool empty = pxQ[qIdx]->empty();
-        return empty;
+        return pxQHead[qIdx] >= pxQ[qIdx].size();
     }
     
     Q2DPxl RSGISHydroDEMFillSoilleGratin94::qPopFront(long hcrt)
     {
         long qIdx = hcrt - this->minVal;
-        Q2DPxl pxl = pxQ[qIdx]->front();
-        pxQ[qIdx]->pop_front();
-        return pxl;
+        return pxQ[qIdx][pxQHead[qIdx]++];
     }
     
     void RSGISHydroDEMFillSoilleGratin94::qPushBack(long hcrt, Q2DPxl pxl)
     {
         long qIdx = hcrt - this->minVal;
-        pxQ[qIdx]->push_back(pxl);
+        pxQ[qIdx].push_back(pxl);
     }
     
-    std::list<Q2DPxl>* RSGISHydroDEMFillSoilleGratin94::getNeighbours(Q2DPxl pxl, GDALRasterBand *inValidImg) 
+    unsigned int RSGISHydroDEMFillSoilleGratin94::getNeighbours(Q2DPxl pxl, rsgis::img::RSGISRandomAccessRaster<float> *validImg, Q2DPxl *nPxls)
     {
-        std::list<Q2DPxl> *nPxls = new std::list<Q2DPxl>();
-        
-        long width = inValidImg->GetXSize();
-        long height = inValidImg->GetYSize();
+        long width = validImg->getXSize();
+        long height = validImg->getYSize();
         
         long minXPxl = pxl.x - 1;
         long maxXPxl = pxl.x + 1;
@@ -225,46 +339,23 @@ namespace rsgis{namespace calib{
         {
             maxYPxl = height-1;
         }
-
-        int nWidth = (maxXPxl - minXPxl)+1;
-        int nHeight = (maxYPxl - minYPxl)+1;
         
-        float dataVal = 0;
-        long cPxlX = 0;
-        long cPxlY = minYPxl;
-        for(int i = 0; i < nHeight; ++i)
+        unsigned int numNPxls = 0;
+        for(long cPxlY = minYPxl; cPxlY <= maxYPxl; ++cPxlY)
         {
-            cPxlX = minXPxl;
-            for(int j = 0; j < nWidth; ++j)
+            for(long cPxlX = minXPxl; cPxlX <= maxXPxl; ++cPxlX)
             {
                 if(!((cPxlX == pxl.x) & (cPxlY == pxl.y)))
                 {
-                    inValidImg->RasterIO(GF_Read, cPxlX, cPxlY, 1, 1, &dataVal, 1, 1, GDT_Float32, 0, 0);
-
-                    if(dataVal == 1)
+                    if(validImg->get(cPxlX, cPxlY) == 1)
                     {
-                        nPxls->push_back(Q2DPxl(cPxlX, cPxlY));
+                        nPxls[numNPxls++] = Q2DPxl(cPxlX, cPxlY);
                     }
                 }
-                ++cPxlX;
             }
-            ++cPxlY;
         }
         
-        return nPxls;
-    }
-    
-    long RSGISHydroDEMFillSoilleGratin94::getPxlVal(Q2DPxl pxl, GDALRasterBand *imgData)
-    {
-        float outVal = 0;
-        imgData->RasterIO(GF_Read, pxl.x, pxl.y, 1, 1, &outVal, 1, 1, GDT_Float32, 0, 0);
-        return (long)outVal;
-    }
-    
-    void RSGISHydroDEMFillSoilleGratin94::setPxlVal(Q2DPxl pxl, long val, GDALRasterBand *imgData)
-    {
-        float outVal = val;
-        imgData->RasterIO(GF_Write, pxl.x, pxl.y, 1, 1, &outVal, 1, 1, GDT_Float32, 0, 0);
+        return numNPxls;
     }
     
     long RSGISHydroDEMFillSoilleGratin94::rtnMax(long val1, long val2)
@@ -277,43 +368,36 @@ namespace rsgis{namespace calib{
         return outVal;
     }
     
-    void RSGISHydroDEMFillSoilleGratin94::getImagesEdgesToInitFill(GDALRasterBand *imgData, double borderVal, std::list<Q2DPxl> *pxQ)
+    void RSGISHydroDEMFillSoilleGratin94::getImagesEdgesToInitFill(rsgis::img::RSGISRandomAccessRaster<float> *imgData, double borderVal, std::vector<Q2DPxl> *pxQ)
     {
         try
         {
-            unsigned int xSize = imgData->GetXSize();
-            unsigned int ySize = imgData->GetYSize();
+            long xSize = imgData->getXSize();
+            long ySize = imgData->getYSize();
             
-            //std::cout << "[" << xSize << ", " << ySize << "]\n";
-            
-            for(unsigned int x = 0; x < xSize; ++x)
+            for(long x = 0; x < xSize; ++x)
             {
-                Q2DPxl q2Pxl = Q2DPxl(x, 0);
-                this->setPxlVal(q2Pxl, borderVal, imgData);
-                pxQ->push_back(q2Pxl);
+                imgData->set(x, 0, borderVal);
+                pxQ->push_back(Q2DPxl(x, 0));
             }
             
-            for(unsigned int x = 0; x < xSize; ++x)
+            for(long x = 0; x < xSize; ++x)
             {
-                Q2DPxl q2Pxl = Q2DPxl(x, (ySize-1));
-                this->setPxlVal(q2Pxl, borderVal, imgData);
-                pxQ->push_back(q2Pxl);
+                imgData->set(x, (ySize-1), borderVal);
+                pxQ->push_back(Q2DPxl(x, (ySize-1)));
             }
             
-            for(unsigned int y = 0; y < ySize; ++y)
+            for(long y = 0; y < ySize; ++y)
             {
-                Q2DPxl q2Pxl = Q2DPxl(0, y);
-                this->setPxlVal(q2Pxl, borderVal, imgData);
-                pxQ->push_back(q2Pxl);
+                imgData->set(0, y, borderVal);
+                pxQ->push_back(Q2DPxl(0, y));
             }
             
-            for(unsigned int y = 0; y < ySize; ++y)
+            for(long y = 0; y < ySize; ++y)
             {
-                Q2DPxl q2Pxl = Q2DPxl((xSize-1), y);
-                this->setPxlVal(q2Pxl, borderVal, imgData);
-                pxQ->push_back(q2Pxl);
+                imgData->set((xSize-1), y, borderVal);
+                pxQ->push_back(Q2DPxl((xSize-1), y));
             }
-
         }
         catch (rsgis::img::RSGISImageCalcException &e)
         {
@@ -335,7 +419,7 @@ namespace rsgis{namespace calib{
     }
     
 
-    RSGISInitOutputImageSoilleGratin94::RSGISInitOutputImageSoilleGratin94(double noDataVal, double dataVal, double borderVal, std::list<Q2DPxl> *pxQ): rsgis::img::RSGISCalcImageValue(1)
+    RSGISInitOutputImageSoilleGratin94::RSGISInitOutputImageSoilleGratin94(double noDataVal, double dataVal, double borderVal, std::vector<Q2DPxl> *pxQ): rsgis::img::RSGISCalcImageValue(1)
     {
         this->noDataVal = noDataVal;
         this->dataVal = dataVal;
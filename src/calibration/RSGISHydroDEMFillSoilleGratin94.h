@@ -34,7 +34,11 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <queue>
+#include <limits>
 #include <math.h>
+#include <cmath>
 
 #include "gdal_priv.h"
 
@@ -45,6 +49,7 @@
 #include "img/RSGISImageUtils.h"
 #include "img/RSGISExtractImagePixelsInPolygon.h"
 #include "img/RSGISImageStatistics.h"
+#include "img/RSGISRandomAccessRaster.h"
 
 #include "math/RSGISMathsUtils.h"
 
@@ -88,17 +93,39 @@ namespace rsgis{namespace calib{
     public:
         RSGISHydroDEMFillSoilleGratin94();
         void performSoilleGratin94Fill(GDALDataset *inDEMImgDS, GDALDataset *inValidImgDS, GDALDataset *outImgDS, bool calcBorderVal, long borderVal=0);
+        /**
+         * Fill the DEM with the priority-flood algorithm (Barnes et al. 2014),
+         * which does not need integer elevations. The fill is seeded from the
+         * same boundary pixels as performSoilleGratin94Fill and, if epsilon is
+         * greater than zero, filled areas are given a gradient of epsilon per
+         * pixel (at least one float step, where epsilon is smaller than the
+         * precision of the elevation) so there is a drainage path out of every
+         * depression.
+         *
+         * Barnes, R., Lehman, C., and Mulla, D. (2014). Priority-flood: An optimal
+         * depression-filling and watershed-labeling algorithm for digital elevation
+         * models. Computers & Geosciences. 62. 117-127.
+         */
+        void performPriorityFloodFill(GDALDataset *inDEMImgDS, GDALDataset *inValidImgDS, GDALDataset *outImgDS, bool calcBorderVal, double borderVal=0, double epsilon=0);
         ~RSGISHydroDEMFillSoilleGratin94();
     protected:
+        struct PFPxl
+        {
+            PFPxl(float elev, long x, long y): elev(elev), x(x), y(y){};
+            bool operator>(const PFPxl &pxl) const {return elev > pxl.elev;};
+            float elev;
+            long x;
+            long y;
+        };
+        double initFill(GDALDataset *inDEMImgDS, GDALDataset *inValidImgDS, GDALDataset *outImgDS, bool calcBorderVal, double borderVal, double *noDataVal, std::vector<Q2DPxl> *seedPxls);
         bool qEmpty(long hcrt);
         Q2DPxl qPopFront(long hcrt);
         void qPushBack(long hcrt, Q2DPxl pxl);
-        std::list<Q2DPxl>* getNeighbours(Q2DPxl pxl, GDALRasterBand *inValidImg);
-        long getPxlVal(Q2DPxl pxl, GDALRasterBand *imgData);
-        void setPxlVal(Q2DPxl pxl, long val, GDALRasterBand *imgData);
+        unsigned int getNeighbours(Q2DPxl pxl, rsgis::img::RSGISRandomAccessRaster<float> *validImg, Q2DPxl *nPxls);
         long rtnMax(long val1, long val2);
-        void getImagesEdgesToInitFill(GDALRasterBand *imgData, double borderVal, std::list<Q2DPxl> *pxQ);
-        std::list<Q2DPxl> **pxQ;
+        void getImagesEdgesToInitFill(rsgis::img::RSGISRandomAccessRaster<float> *imgData, double borderVal, std::vector<Q2DPxl> *pxQ);
+        std::vector<std::vector<Q2DPxl> > pxQ;
+        std::vector<size_t> pxQHead;
         long minVal;
         long maxVal;
         long numLevels;
@@ -108,7 +135,7 @@ namespace rsgis{namespace calib{
     class DllExport RSGISInitOutputImageSoilleGratin94 : public rsgis::img::RSGISCalcImageValue
     {
     public:
-        RSGISInitOutputImageSoilleGratin94(double noDataVal, double dataVal, double borderVal, std::list<Q2DPxl> *pxQ);
+        RSGISInitOutputImageSoilleGratin94(double noDataVal, double dataVal, double borderVal, std::vector<Q2DPxl> *pxQ);
         void calcImageValue(float *bandValues, int numBands, double *output) {throw rsgis::img::RSGISImageCalcException("Not implmented.");};
         void calcImageValue(float *bandValues, int numBands) {throw rsgis::img::RSGISImageCalcException("Not implmented.");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
@@ -124,7 +151,7 @@ namespace rsgis{namespace calib{
         double noDataVal;
         double dataVal;
         double borderVal;
-        std::list<Q2DPxl> *pxQ;
+        std::vector<Q2DPxl> *pxQ;
     };
     
 }}
@@ -62,6 +62,30 @@ namespace rsgis{namespace calib{
         }
     }
     
+    void RSGISLandsatRadianceCalibration::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        for(unsigned int i = 0; i < this->numOutBands; ++i)
+        {
+            if(this->radGainOff[i].band > numBands)
+            {
+                throw rsgis::img::RSGISImageCalcException("Band is not within input image bands.");
+            }
+        }
+        for(unsigned int i = 0; i < this->numOutBands; ++i)
+        {
+            const float *inPlane = bandPlanes[i];
+            double *outPlane = outPlanes[i];
+            const double gain = (this->radGainOff[i].lMax - this->radGainOff[i].lMin)/(this->radGainOff[i].qCalMax - this->radGainOff[i].qCalMin);
+            const double offset = this->radGainOff[i].lMin - (gain * this->radGainOff[i].qCalMin);
+            for(size_t j = 0; j < nPxls; ++j)
+            {
+                outPlane[j] = (gain * inPlane[j]) + offset;
+            }
+        }
+        // If pixels values are 0 - consider image border
+        rsgisZeroOutputsWhereBandsEqual(bandPlanes, 0, numBands, 0, nPxls, outPlanes, this->numOutBands);
+    }
+    
     
     void RSGISLandsatRadianceCalibrationMultiAdd::calcImageValue(float *bandValues, int numBands, double *output) 
     {        
@@ -96,6 +120,30 @@ namespace rsgis{namespace calib{
         }
     }
     
+    void RSGISLandsatRadianceCalibrationMultiAdd::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        for(unsigned int i = 0; i < this->numOutBands; ++i)
+        {
+            if(this->radGainOff[i].band > numBands)
+            {
+                throw rsgis::img::RSGISImageCalcException("Band is not within input image bands.");
+            }
+        }
+        for(unsigned int i = 0; i < this->numOutBands; ++i)
+        {
+            const float *inPlane = bandPlanes[i];
+            double *outPlane = outPlanes[i];
+            const double gain = this->radGainOff[i].multiVal;
+            const double offset = this->radGainOff[i].addVal;
+            for(size_t j = 0; j < nPxls; ++j)
+            {
+                outPlane[j] = (gain * inPlane[j]) + offset;
+            }
+        }
+        // If pixels values are 0 - consider image border
+        rsgisZeroOutputsWhereBandsEqual(bandPlanes, 0, numBands, 0, nPxls, outPlanes, this->numOutBands);
+    }
+    
     void RSGISSPOTRadianceCalibration::calcImageValue(float *bandValues, int numBands, double *output) 
     {
         for(unsigned int i = 0; i < this->numOutBands; ++i)
@@ -108,6 +156,28 @@ namespace rsgis{namespace calib{
         }
     }
     
+    void RSGISSPOTRadianceCalibration::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        for(unsigned int i = 0; i < this->numOutBands; ++i)
+        {
+            if(this->radGainOff[i].band > numBands)
+            {
+                throw rsgis::img::RSGISImageCalcException("Band is not within input image bands.");
+            }
+        }
+        for(unsigned int i = 0; i < this->numOutBands; ++i)
+        {
+            const float *inPlane = bandPlanes[i];
+            double *outPlane = outPlanes[this->radGainOff[i].band-1];
+            const double gain = 1.0/this->radGainOff[i].gain;
+            const double offset = this->radGainOff[i].bias;
+            for(size_t j = 0; j < nPxls; ++j)
+            {
+                outPlane[j] = (gain * inPlane[j]) + offset;
+            }
+        }
+    }
+    
     void RSGISIkonosRadianceCalibration::calcImageValue(float *bandValues, int numBands, double *output) 
     {
         for(unsigned int i = 0; i < this->numOutBands; ++i)
@@ -120,6 +190,27 @@ namespace rsgis{namespace calib{
         }
     }
     
+    void RSGISIkonosRadianceCalibration::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        for(unsigned int i = 0; i < this->numOutBands; ++i)
+        {
+            if(this->radGainOff[i].band > numBands)
+            {
+                throw rsgis::img::RSGISImageCalcException("Band is not within input image bands.");
+            }
+        }
+        for(unsigned int i = 0; i < this->numOutBands; ++i)
+        {
+            const float *inPlane = bandPlanes[i];
+            double *outPlane = outPlanes[i];
+            const double gain = 100000.0/(this->radGainOff[i].calCoef * this->radGainOff[i].bandwidth);
+            for(size_t j = 0; j < nPxls; ++j)
+            {
+                outPlane[j] = gain * inPlane[j];
+            }
+        }
+    }
+    
     void RSGISASTERRadianceCalibration::calcImageValue(float *bandValues, int numBands, double *output) 
     {
         for(unsigned int i = 0; i < this->numOutBands; ++i)
@@ -132,6 +223,27 @@ namespace rsgis{namespace calib{
         }
     }
     
+    void RSGISASTERRadianceCalibration::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        for(unsigned int i = 0; i < this->numOutBands; ++i)
+        {
+            if(this->radGainOff[i].band > numBands)
+            {
+                throw rsgis::img::RSGISImageCalcException("Band is not within input image bands.");
+            }
+        }
+        for(unsigned int i = 0; i < this->numOutBands; ++i)
+        {
+            const float *inPlane = bandPlanes[i];
+            double *outPlane = outPlanes[i];
+            const double gain = this->radGainOff[i].unitConCoef;
+            for(size_t j = 0; j < nPxls; ++j)
+            {
+                outPlane[j] = (inPlane[j] - 1.0) * gain;
+            }
+        }
+    }
+    
     void RSGISIRSRadianceCalibration::calcImageValue(float *bandValues, int numBands, double *output) 
     {
         double gain = 0;
@@ -147,6 +259,28 @@ namespace rsgis{namespace calib{
         }
     }
     
+    void RSGISIRSRadianceCalibration::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        for(unsigned int i = 0; i < this->numOutBands; ++i)
+        {
+            if(this->radGainOff[i].band > numBands)
+            {
+                throw rsgis::img::RSGISImageCalcException("Band is not within input image bands.");
+            }
+        }
+        for(unsigned int i = 0; i < this->numOutBands; ++i)
+        {
+            const float *inPlane = bandPlanes[i];
+            double *outPlane = outPlanes[i];
+            const double gain = (this->radGainOff[i].lMax - this->radGainOff[i].lMin)/(this->radGainOff[i].qCalMax - this->radGainOff[i].qCalMin);
+            const double offset = this->radGainOff[i].lMin - (gain * this->radGainOff[i].qCalMin);
+            for(size_t j = 0; j < nPxls; ++j)
+            {
+                outPlane[j] = (gain * inPlane[j]) + offset;
+            }
+        }
+    }
+    
     void RSGISQuickbird16bitRadianceCalibration::calcImageValue(float *bandValues, int numBands, double *output) 
     {
         for(unsigned int i = 0; i < this->numOutBands; ++i)
@@ -159,6 +293,27 @@ namespace rsgis{namespace calib{
         }
     }
     
+    void RSGISQuickbird16bitRadianceCalibration::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        for(unsigned int i = 0; i < this->numOutBands; ++i)
+        {
+            if(this->radGainOff[i].band > numBands)
+            {
+                throw rsgis::img::RSGISImageCalcException("Band is not within input image bands.");
+            }
+        }
+        for(unsigned int i = 0; i < this->numOutBands; ++i)
+        {
+            const float *inPlane = bandPlanes[i];
+            double *outPlane = outPlanes[i];
+            const double gain = ((double)this->radGainOff[i].calFactor)/this->radGainOff[i].bandIntegrate;
+            for(size_t j = 0; j < nPxls; ++j)
+            {
+                outPlane[j] = gain * inPlane[j];
+            }
+        }
+    }
+    
     void RSGISQuickbird8bitRadianceCalibration::calcImageValue(float *bandValues, int numBands, double *output) 
     {
         for(unsigned int i = 0; i < this->numOutBands; ++i)
@@ -171,6 +326,27 @@ namespace rsgis{namespace calib{
         }
     }
     
+    void RSGISQuickbird8bitRadianceCalibration::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        for(unsigned int i = 0; i < this->numOutBands; ++i)
+        {
+            if(this->radGainOff[i].band > numBands)
+            {
+                throw rsgis::img::RSGISImageCalcException("Band is not within input image bands.");
+            }
+        }
+        for(unsigned int i = 0; i < this->numOutBands; ++i)
+        {
+            const float *inPlane = bandPlanes[i];
+            double *outPlane = outPlanes[i];
+            const double gain = (((double)this->radGainOff[i].calFactor) * this->radGainOff[i].k)/this->radGainOff[i].bandIntegrate;
+            for(size_t j = 0; j < nPxls; ++j)
+            {
+                outPlane[j] = gain * inPlane[j];
+            }
+        }
+    }
+    
     void RSGISWorldView2RadianceCalibration::calcImageValue(float *bandValues, int numBands, double *output) 
     {
         for(unsigned int i = 0; i < this->numOutBands; ++i)
@@ -183,6 +359,27 @@ namespace rsgis{namespace calib{
         }
     }
     
+    void RSGISWorldView2RadianceCalibration::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        for(unsigned int i = 0; i < this->numOutBands; ++i)
+        {
+            if(this->radGainOff[i].band > numBands)
+            {
+                throw rsgis::img::RSGISImageCalcException("Band is not within input image bands.");
+            }
+        }
+        for(unsigned int i = 0; i < this->numOutBands; ++i)
+        {
+            const float *inPlane = bandPlanes[this->radGainOff[i].band-1];
+            double *outPlane = outPlanes[i];
+            const double gain = this->radGainOff[i].absCalFact/this->radGainOff[i].effBandWidth;
+            for(size_t j = 0; j < nPxls; ++j)
+            {
+                outPlane[j] = gain * inPlane[j];
+            }
+        }
+    }
+    
     
     void RSGISIdentifySaturatePixels::calcImageValue(float *bandValues, int numBands, double *output) 
     {
@@ -49,6 +49,33 @@
 
 namespace rsgis{namespace calib{
     
+    /**
+     * Sets the outputs of a block to 0 for the pixels where all the input bands
+     * from sBand up to (not including) eBand are equal to val (i.e., no data).
+     */
+    inline void rsgisZeroOutputsWhereBandsEqual(const float* const* bandPlanes, int sBand, int eBand, float val, size_t nPxls, double** outPlanes, int numOutBands)
+    {
+        for(size_t j = 0; j < nPxls; ++j)
+        {
+            bool nodata = true;
+            for(int n = sBand; n < eBand; ++n)
+            {
+                if(bandPlanes[n][j] != val)
+                {
+                    nodata = false;
+                    break;
+                }
+            }
+            if(nodata)
+            {
+                for(int n = 0; n < numOutBands; ++n)
+                {
+                    outPlanes[n][j] = 0;
+                }
+            }
+        }
+    }
+    
 	struct DllExport LandsatRadianceGainsOffsets
     {
         unsigned int band;
@@ -136,6 +163,8 @@ namespace rsgis{namespace calib{
             this->radGainOff = radGainOff;
         };
         void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        bool isThreadSafe(){return true;};
         void calcImageValue(float *bandValues, int numBands) {throw rsgis::img::RSGISImageCalcException("Not implmented.");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
@@ -158,6 +187,8 @@ namespace rsgis{namespace calib{
             this->radGainOff = radGainOff;
         };
         void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        bool isThreadSafe(){return true;};
         void calcImageValue(float *bandValues, int numBands) {throw rsgis::img::RSGISImageCalcException("Not implmented.");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
@@ -180,6 +211,8 @@ namespace rsgis{namespace calib{
             this->radGainOff = radGainOff;
         };
         void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        bool isThreadSafe(){return true;};
         void calcImageValue(float *bandValues, int numBands) {throw rsgis::img::RSGISImageCalcException("Not implmented.");};
         void calcImageValue(float *bandValues, int numBands, geos::geom::Envelope extent) {throw rsgis::img::RSGISImageCalcException("Not implmented.");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
@@ -202,6 +235,8 @@ namespace rsgis{namespace calib{
             this->radGainOff = radGainOff;
         };
         void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        bool isThreadSafe(){return true;};
         void calcImageValue(float *bandValues, int numBands) {throw rsgis::img::RSGISImageCalcException("Not implmented.");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
@@ -224,6 +259,8 @@ namespace rsgis{namespace calib{
             this->radGainOff = radGainOff;
         };
         void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        bool isThreadSafe(){return true;};
         void calcImageValue(float *bandValues, int numBands) {throw rsgis::img::RSGISImageCalcException("Not implmented.");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
@@ -246,6 +283,8 @@ namespace rsgis{namespace calib{
             this->radGainOff = radGainOff;
         };
         void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        bool isThreadSafe(){return true;};
         void calcImageValue(float *bandValues, int numBands) {throw rsgis::img::RSGISImageCalcException("Not implmented.");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
@@ -268,6 +307,8 @@ namespace rsgis{namespace calib{
             this->radGainOff = radGainOff;
         };
         void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        bool isThreadSafe(){return true;};
         void calcImageValue(float *bandValues, int numBands) {throw rsgis::img::RSGISImageCalcException("Not implmented.");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
@@ -290,6 +331,8 @@ namespace rsgis{namespace calib{
             this->radGainOff = radGainOff;
         };
         void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        bool isThreadSafe(){return true;};
         void calcImageValue(float *bandValues, int numBands) {throw rsgis::img::RSGISImageCalcException("Not implmented.");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
@@ -312,6 +355,8 @@ namespace rsgis{namespace calib{
             this->radGainOff = radGainOff;
         };
         void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        bool isThreadSafe(){return true;};
         void calcImageValue(float *bandValues, int numBands) {throw rsgis::img::RSGISImageCalcException("Not implmented.");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
@@ -31,6 +31,97 @@ namespace rsgis{ namespace classifier{
 		this->numVariables = trainingData[0]->data->n;
 	}
 	
+	const size_t RSGISClassifier::pxlChunkSize = 1024;
+	const size_t RSGISClassifier::refChunkSize = 512;
+	
+	void RSGISClassifier::getClassIDs(const float* const* varPlanes, int numVars, size_t nPxls, double *classIDs)
+	{
+		rsgis::RSGISScratchScope scratch;
+		float *pxlVals = scratch.alloc<float>(numVars);
+		for(size_t p = 0; p < nPxls; ++p)
+		{
+			for(int j = 0; j < numVars; ++j)
+			{
+				pxlVals[j] = varPlanes[j][p];
+			}
+			try
+			{
+				classIDs[p] = this->getClassID(pxlVals, numVars);
+			}
+			catch(RSGISClassificationException &e)
+			{
+				classIDs[p] = -1;
+			}
+		}
+	}
+	
+	void RSGISClassifier::findNearestRefs(const std::vector<double> &refVecs, const std::vector<double> &refSqNorms, size_t numRefs, const float* const* varPlanes, int numVars, size_t nPxls, unsigned int *nearestIdx)
+	{
+		if(numRefs == 0)
+		{
+			throw RSGISClassificationException("There are no reference vectors to classify the pixels with.");
+		}
+		if(nPxls == 0)
+		{
+			return;
+		}
+		
+		// The references are taken in chunks too so the score matrix stays in
+		// cache when there are many (e.g., all the training samples).
+		rsgis::RSGISScratchScope scratch;
+		size_t chunkSize = std::min(nPxls, pxlChunkSize);
+		size_t refChunk = std::min(numRefs, refChunkSize);
+		double *xVals = scratch.alloc<double>(numVars * chunkSize);
+		double *scores = scratch.alloc<double>(refChunk * chunkSize);
+		double *minScores = scratch.alloc<double>(chunkSize);
+		
+		for(size_t start = 0; start < nPxls; start += chunkSize)
+		{
+			size_t nChunk = std::min(chunkSize, nPxls - start);
+			for(int j = 0; j < numVars; ++j)
+			{
+				const float *inPlane = varPlanes[j] + start;
+				double *xRow = xVals + (j * nChunk);
+				for(size_t p = 0; p < nChunk; ++p)
+				{
+					xRow[p] = inPlane[p];
+				}
+			}
+			unsigned int *idxChunk = nearestIdx + start;
+			for(size_t p = 0; p < nChunk; ++p)
+			{
+				minScores[p] = std::numeric_limits<double>::infinity();
+				idxChunk[p] = 0;
+			}
+			
+			gsl_matrix_view xMat = gsl_matrix_view_array(xVals, numVars, nChunk);
+			for(size_t refStart = 0; refStart < numRefs; refStart += refChunk)
+			{
+				size_t nRefs = std::min(refChunk, numRefs - refStart);
+				gsl_matrix_const_view rMat = gsl_matrix_const_view_array(&refVecs[refStart * numVars], nRefs, numVars);
+				gsl_matrix_view sMat = gsl_matrix_view_array(scores, nRefs, nChunk);
+				int status = gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, -2.0, &rMat.matrix, &xMat.matrix, 0.0, &sMat.matrix);
+				if(status != 0)
+				{
+					throw RSGISClassificationException(gsl_strerror(status));
+				}
+				for(size_t r = 0; r < nRefs; ++r)
+				{
+					const double *sRow = scores + (r * nChunk);
+					double refSqNorm = refSqNorms[refStart + r];
+					unsigned int refIdx = refStart + r;
+					for(size_t p = 0; p < nChunk; ++p)
+					{
+						double score = sRow[p] + refSqNorm;
+						bool nearer = score < minScores[p];
+						minScores[p] = nearer?score:minScores[p];
+						idxChunk[p] = nearer?refIdx:idxChunk[p];
+					}
+				}
+			}
+		}
+	}
+	
 	int RSGISClassifier::getNumVariables()
 	{
 		return this->numVariables;
@@ -97,11 +188,136 @@ namespace rsgis{ namespace classifier{
 		throw rsgis::img::RSGISImageCalcException("Not implemented");
 	}
 	
+	void RSGISApplyClassifier::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+	{
+		if(numBands != classifier->getNumVariables())
+		{
+			throw rsgis::img::RSGISImageCalcException("The number of input variables is not equal to the number of training variables.");
+		}
+		try
+		{
+			classifier->getClassIDs(bandPlanes, numBands, nPxls, outPlanes[0]);
+		}
+		catch(RSGISClassificationException &e)
+		{
+			throw rsgis::img::RSGISImageCalcException(e.what());
+		}
+	}
+	
 	
 	RSGISApplyClassifier::~RSGISApplyClassifier()
 	{
 		
 	}
+    
+    
+    RSGISClassifierPxlData::RSGISClassifierPxlData(): numPxls(0), numBands(0)
+    {
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+    
+    bool RSGISClassifierPxlData::readImages(GDALDataset **datasets, unsigned int numDatasets, unsigned int subSample, double maxMemMB)
+    {
+        this->clear();
+        if(numDatasets == 0)
+        {
+            throw RSGISClassificationException("No images were provided to be read.");
+        }
+        if(subSample == 0)
+        {
+            subSample = 1;
+        }
+        
+        unsigned int width = datasets[0]->GetRasterXSize();
+        unsigned int height = datasets[0]->GetRasterYSize();
+        unsigned int totalNumBands = 0;
+        for(unsigned int n = 0; n < numDatasets; ++n)
+        {
+            if((datasets[n]->GetRasterXSize() != width) || (datasets[n]->GetRasterYSize() != height))
+            {
+                throw RSGISClassificationException("The images must all be the same size.");
+            }
+            totalNumBands += datasets[n]->GetRasterCount();
+        }
+        
+        size_t totalNumPxls = ((size_t)width) * height;
+        size_t numSamplePxls = (totalNumPxls + subSample - 1) / subSample;
+        double memMB = (((double)numSamplePxls) * totalNumBands * sizeof(float)) / (1024.0 * 1024.0);
+        if((numSamplePxls == 0) || (totalNumBands == 0) || (memMB > maxMemMB))
+        {
+            return false;
+        }
+        
+        this->numBands = totalNumBands;
+        this->pxlVals.resize(numSamplePxls * totalNumBands);
+        
+        // Each row is read with the bands interleaved so the sampled pixels can be copied across.
+        std::vector<float> rowVals(((size_t)width) * totalNumBands);
+        GSpacing pxlSpace = totalNumBands * sizeof(float);
+        size_t pxlIdx = 0;
+        size_t outIdx = 0;
+        for(unsigned int y = 0; y < height; ++y)
+        {
+            unsigned int bandOffset = 0;
+            for(unsigned int n = 0; n < numDatasets; ++n)
+            {
+                int numImgBands = datasets[n]->GetRasterCount();
+                if(datasets[n]->RasterIO(GF_Read, 0, y, width, 1, &rowVals[bandOffset], width, 1, GDT_Float32, numImgBands, NULL, pxlSpace, pxlSpace * width, sizeof(float), NULL) != CE_None)
+                {
+                    this->clear();
+                    throw RSGISClassificationException("Could not read the image data into memory.");
+                }
+                bandOffset += numImgBands;
+            }
+            for(unsigned int x = 0; x < width; ++x, ++pxlIdx)
+            {
+                if((pxlIdx % subSample) == 0)
+                {
+                    std::copy(&rowVals[((size_t)x) * totalNumBands], &rowVals[((size_t)x) * totalNumBands] + totalNumBands, &this->pxlVals[outIdx * totalNumBands]);
+                    ++outIdx;
+                }
+            }
+        }
+        this->numPxls = outIdx;
+        return true;
+    }
+    
+    void RSGISClassifierPxlData::clear()
+    {
+        std::vector<float>().swap(this->pxlVals);
+        this->numPxls = 0;
+        this->numBands = 0;
+    }
+    
+    void RSGISClassifierPxlData::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+    
+    void RSGISClassifierPxlData::processInThreads(std::function<void(size_t, size_t)> func)
+    {
+        size_t nThreads = std::min<size_t>(this->numThreads, this->numPxls);
+        if(nThreads <= 1)
+        {
+            func(0, this->numPxls);
+            return;
+        }
+        
+        // The pixels are split into a fixed range for each thread.
+        size_t pxlsPerThread = (this->numPxls + nThreads - 1) / nThreads;
+        size_t numRanges = (this->numPxls + pxlsPerThread - 1) / pxlsPerThread;
+        size_t numPxls = this->numPxls;
+        rsgis::utils::parallelFor(numRanges, nThreads, [&func, pxlsPerThread, numPxls](size_t t, unsigned int)
+        {
+            size_t start = t * pxlsPerThread;
+            func(start, std::min(start + pxlsPerThread, numPxls));
+        });
+    }
+    
+    RSGISClassifierPxlData::~RSGISClassifierPxlData()
+    {
+        
+    }
 	
 }}
 
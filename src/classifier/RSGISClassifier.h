@@ -26,11 +26,24 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <stdlib.h>
+#include "gdal_priv.h"
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_errno.h>
 #include "math/RSGISMatrices.h"
 #include "math/RSGISVectors.h"
 #include "img/RSGISCalcImageValue.h"
 #include "img/RSGISImageCalcException.h"
+#include "common/RSGISScratchArena.h"
 #include "common/RSGISClassificationException.h"
+#include "common/RSGISParallel.h"
 #include "utils/RSGIS_ENVI_ASCII_ROI.h"
 
 // mark all exported classes/functions with DllExport to have
@@ -80,10 +93,35 @@ namespace rsgis{ namespace classifier{
 		RSGISClassifier(ClassData **trainingData, int numClasses);
 		virtual int getClassID(float *variables, int numVars) = 0;
 		virtual std::string getClassName(float *variables, int numVars) = 0;
+		/**
+		 * Classify a block of nPxls pixels given as planes of the variables
+		 * (varPlanes[var][pxl]), writing the class IDs to classIDs, with -1 for
+		 * pixels which could not be classified. The default calls getClassID
+		 * for each pixel; classifiers which compare pixels with a set of
+		 * reference vectors override it to score whole blocks at once.
+		 */
+		virtual void getClassIDs(const float* const* varPlanes, int numVars, size_t nPxls, double *classIDs);
+		/**
+		 * Whether getClassID and getClassIDs can be called from several threads
+		 * at once (i.e., they do not change the classifier).
+		 */
+		virtual bool isThreadSafe(){return false;};
 		int getNumVariables();
 		void printClassIDs();
 		virtual ~RSGISClassifier();
 	protected:
+		/**
+		 * Find the index of the nearest (Euclidean) of the numRefs reference
+		 * vectors (refVecs, row major with numVars values per reference) to each
+		 * pixel. As |x-r|^2 = |x|^2 - 2r.x + |r|^2, and |x|^2 is the same for
+		 * every reference, the nearest reference is the one minimising
+		 * |r|^2 - 2r.x, so the distances for a chunk of pixels come from one
+		 * matrix product. Ties go to the first reference, as for the per pixel
+		 * searches.
+		 */
+		static void findNearestRefs(const std::vector<double> &refVecs, const std::vector<double> &refSqNorms, size_t numRefs, const float* const* varPlanes, int numVars, size_t nPxls, unsigned int *nearestIdx);
+		static const size_t pxlChunkSize;
+		static const size_t refChunkSize;
 		ClassData **trainingData;
 		int numClasses;
 		int numVariables;
@@ -103,10 +141,52 @@ namespace rsgis{ namespace classifier{
 		void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output);
         void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output, geos::geom::Envelope extent) {throw rsgis::img::RSGISImageCalcException("No implemented");};
 		bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output);
+		/**
+		 * Classifies the whole block through RSGISClassifier::getClassIDs.
+		 */
+		void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+		bool isThreadSafe(){return this->classifier->isThreadSafe();};
 		~RSGISApplyClassifier();
 	protected:
 		RSGISClassifier *classifier;
 	};
+    
+    /**
+     * The pixel values of images (or every subSample'th pixel), with the bands of
+     * all the images for each pixel, held in memory as a row major matrix so
+     * iterative classifiers can process them in parallel rather than reading
+     * the images for every iteration.
+     */
+    class DllExport RSGISClassifierPxlData
+    {
+    public:
+        RSGISClassifierPxlData();
+        /**
+         * Read the pixel values, returning false (without reading them) if they
+         * would need more than maxMemMB megabytes.
+         */
+        bool readImages(GDALDataset **datasets, unsigned int numDatasets, unsigned int subSample, double maxMemMB);
+        void clear();
+        bool hasData() const {return (numPxls > 0);};
+        size_t getNumPxls() const {return numPxls;};
+        unsigned int getNumBands() const {return numBands;};
+        float* getPxlVals(size_t pxl) {return &pxlVals[pxl*numBands];};
+        /**
+         * Set the number of threads used by processInThreads (0 uses the number of
+         * cores). Defaults to RSGISLIB_NUM_THREADS or 1.
+         */
+        void setNumThreads(unsigned int numThreads);
+        /**
+         * Call func(start, end) for ranges of the pixels split across the threads.
+         */
+        void processInThreads(std::function<void(size_t, size_t)> func);
+        ~RSGISClassifierPxlData();
+    protected:
+        std::vector<float> pxlVals;
+        size_t numPxls;
+        unsigned int numBands;
+        unsigned int numThreads;
+    };
 }}
 
 #endif
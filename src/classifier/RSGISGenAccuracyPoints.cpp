@@ -331,87 +331,64 @@ namespace rsgis{namespace classifier{
             }
             
             
-            srand(seed);
+            // The class index of each RAT row.
+            std::vector<std::string> classNamesVec(classes->begin(), classes->end());
+            std::vector<long> rowClassIdx(numRows, -1);
+            std::map<std::string, size_t>::iterator iterMap;
+            for(int i = 1; i < numRows; ++i)
+            {
+                iterMap = classesLookUp.find(boost::trim_all_copy(std::string(attTable->GetValueAsString(i, inClassColIdx))));
+                if(iterMap != classesLookUp.end())
+                {
+                    rowClassIdx[i] = iterMap->second;
+                }
+            }
+            
+            std::cout << "Number of points to be generated: " << (classes->size() * numPts) << std::endl;
+            std::vector<std::vector<std::pair<unsigned int, unsigned int> > > classPxls;
+            this->selectStratifiedPxls(inputImage, rowClassIdx, classNamesVec, numPts, seed, &classPxls);
             
-            unsigned int xPxl = 0;
-            unsigned int yPxl = 0;
             double eastings = 0;
             double northings = 0;
             float demVal = 0;
-            std::string classVal = "";
-            std::map<std::string, size_t>::iterator iterMap;
-            
             RSGISAccPoint *tmpAccPt = NULL;
-            
-            unsigned long totalNumPtsRequired = classes->size() * numPts;
             unsigned long ptsCount = 0;
-            
-            
-            std::cout << "Number of points to be generated: " << totalNumPtsRequired << std::endl;
-            
-            while(ptsCount < totalNumPtsRequired)
+            for(size_t i = 0; i < classPxls.size(); ++i)
             {
-                std::cout << "Completed " << floor((((double)ptsCount)/((double)totalNumPtsRequired))*100) << " %\r" << std::flush;
-                
-                xPxl = rand() % imgSizeX;
-                yPxl = rand() % imgSizeY;
-                                
-                eastings = tlX + (((double)xPxl)*xRes);
-                northings = tlY - (((double)yPxl)*yRes);
-                                
-                try
+                for(std::vector<std::pair<unsigned int, unsigned int> >::iterator iterPxl = classPxls[i].begin(); iterPxl != classPxls[i].end(); ++iterPxl)
                 {
-                    classVal = findClassVal(inputImage, 1, attTable, inClassColIdx, xPxl, yPxl);
-                                       
-                    iterMap = classesLookUp.find(classVal);
+                    eastings = tlX + (((double)iterPxl->first)*xRes);
+                    northings = tlY - (((double)iterPxl->second)*yRes);
                     
-                    if(iterMap == classesLookUp.end())
+                    if(demProvided)
                     {
-                        rsgis::RSGISImageException("Class name was not found!");
-                    }
-                    
-                    idx = iterMap->second;
-                    
-                    if(accClassPts->at(idx).size() < numPts)
-                    {
-                        if(demProvided)
+                        try
                         {
-                            try
-                            {
-                                demVal = findPixelVal(inputDEM, 1, eastings, northings, demTlX, demTlY, demXRes, demYRes, demSizeX, demSizeY);
-                            }
-                            catch (rsgis::RSGISImageException &e)
-                            {
-                                demVal = -99999;
-                            }
+                            demVal = findPixelVal(inputDEM, 1, eastings, northings, demTlX, demTlY, demXRes, demYRes, demSizeX, demSizeY);
                         }
-                        else
+                        catch (rsgis::RSGISImageException &e)
                         {
-                            demVal = 0;
+                            demVal = -99999;
                         }
-                        
-                        tmpAccPt = new RSGISAccPoint();
-                        tmpAccPt->ptID = ptsCount+1;
-                        tmpAccPt->eastings = eastings;
-                        tmpAccPt->northings = northings;
-                        tmpAccPt->elevation = demVal;
-                        tmpAccPt->mapClassName = classVal;
-                        tmpAccPt->trueClassName = classVal;
-                        tmpAccPt->status = -1;
-                        tmpAccPt->comment = "";
-                        
-                        accClassPts->at(idx).push_back(tmpAccPt);
-                        
-                        ++ptsCount;
-                    }                    
-                }
-                catch (rsgis::RSGISImageException &e)
-                {
-                    // Ignore as class not found...
-                }
-                catch (std::exception &e)
-                {
-                    throw rsgis::RSGISImageException(e.what());
+                    }
+                    else
+                    {
+                        demVal = 0;
+                    }
+                    
+                    tmpAccPt = new RSGISAccPoint();
+                    tmpAccPt->ptID = ptsCount+1;
+                    tmpAccPt->eastings = eastings;
+                    tmpAccPt->northings = northings;
+                    tmpAccPt->elevation = demVal;
+                    tmpAccPt->mapClassName = classNamesVec[i];
+                    tmpAccPt->trueClassName = classNamesVec[i];
+                    tmpAccPt->status = -1;
+                    tmpAccPt->comment = "";
+                    
+                    accClassPts->at(i).push_back(tmpAccPt);
+                    
+                    ++ptsCount;
                 }
             }
             
@@ -697,75 +674,42 @@ namespace rsgis{namespace classifier{
             
             delete[] trans;
             
-            srand(seed);
+            // The class index of each RAT row.
+            std::vector<std::string> classNamesVec(classNames->begin(), classNames->end());
+            std::vector<long> rowClassIdx(imgClassColVals->size(), -1);
+            std::map<std::string, size_t>::iterator iterMap;
+            for(size_t i = 1; i < imgClassColVals->size(); ++i)
+            {
+                iterMap = classesLookUp.find(imgClassColVals->at(i));
+                if(iterMap != classesLookUp.end())
+                {
+                    rowClassIdx[i] = iterMap->second;
+                }
+            }
             
-            unsigned int xPxl = 0;
-            unsigned int yPxl = 0;
-            double eastings = 0;
-            double northings = 0;
-            std::string classVal = "";
-            long pxlVal = 0.0;
+            std::cout << "Number of points to be generated: " << (classNames->size() * numPts) << std::endl;
+            std::vector<std::vector<std::pair<unsigned int, unsigned int> > > classPxls;
+            this->selectStratifiedPxls(inputImage, rowClassIdx, classNamesVec, numPts, seed, &classPxls);
             
             RSGISAccPoint *tmpAccPt = NULL;
-            std::map<std::string, size_t>::iterator iterMap;
-            
-            unsigned long totalNumPtsRequired = classNames->size() * numPts;
             unsigned long ptsCount = 0;
-            
-            std::cout << "Number of points to be generated: " << totalNumPtsRequired << std::endl;
-            
-            while(ptsCount < totalNumPtsRequired)
+            for(size_t i = 0; i < classPxls.size(); ++i)
             {
-                std::cout << "Completed " << floor((((double)ptsCount)/((double)totalNumPtsRequired))*100) << " %\r" << std::flush;
-                
-                xPxl = rand() % imgSizeX;
-                yPxl = rand() % imgSizeY;
-                
-                eastings = tlX + (((double)xPxl)*xRes);
-                northings = tlY - (((double)yPxl)*yRes);
-                
-                try
+                for(std::vector<std::pair<unsigned int, unsigned int> >::iterator iterPxl = classPxls[i].begin(); iterPxl != classPxls[i].end(); ++iterPxl)
                 {
-                    pxlVal = long(this->findPixelVal(inputImage, 1, eastings, northings, tlX, tlY, xRes, yRes, imgSizeX, imgSizeY));
+                    tmpAccPt = new RSGISAccPoint();
+                    tmpAccPt->ptID = ptsCount+1;
+                    tmpAccPt->eastings = tlX + (((double)iterPxl->first)*xRes);
+                    tmpAccPt->northings = tlY - (((double)iterPxl->second)*yRes);
+                    tmpAccPt->elevation = 0.0;
+                    tmpAccPt->mapClassName = classNamesVec[i];
+                    tmpAccPt->trueClassName = "";
+                    tmpAccPt->status = -1;
+                    tmpAccPt->comment = "";
                     
-                    if((pxlVal > 0) & (pxlVal < imgClassColVals->size()))
-                    {
-                        classVal = imgClassColVals->at(pxlVal);
-                        
-                        iterMap = classesLookUp.find(classVal);
-                        
-                        if(iterMap == classesLookUp.end())
-                        {
-                            rsgis::RSGISImageException("Class name was not found!");
-                        }
-                        
-                        idx = iterMap->second;
-                        
-                        if(accClassPts->at(idx).size() < numPts)
-                        {
-                            tmpAccPt = new RSGISAccPoint();
-                            tmpAccPt->ptID = ptsCount+1;
-                            tmpAccPt->eastings = eastings;
-                            tmpAccPt->northings = northings;
-                            tmpAccPt->elevation = 0.0;
-                            tmpAccPt->mapClassName = classVal;
-                            tmpAccPt->trueClassName = "";
-                            tmpAccPt->status = -1;
-                            tmpAccPt->comment = "";
-                        
-                            accClassPts->at(idx).push_back(tmpAccPt);
-                            
-                            ++ptsCount;
-                        }
-                    }
-                }
-                catch (rsgis::RSGISImageException &e)
-                {
-                    // Ignore as class not found...
-                }
-                catch (std::exception &e)
-                {
-                    throw rsgis::RSGISImageException(e.what());
+                    accClassPts->at(i).push_back(tmpAccPt);
+                    
+                    ++ptsCount;
                 }
             }
             
@@ -1016,32 +960,6 @@ namespace rsgis{namespace classifier{
             rsgis::rastergis::RSGISRasterAttUtils ratUtils;
             std::vector<std::string> *imgClassColVals = ratUtils.readStrColumnAsVec(attTable, imgClassCol);
             
-            double tlX = 0;
-            double tlY = 0;
-            double xRes = 0;
-            double yRes = 0;
-            unsigned int imgSizeX = 0;
-            unsigned int imgSizeY = 0;
-            
-            // Get Transformation for Image
-            double *trans = new double[6];
-            inputImage->GetGeoTransform(trans);
-            tlX = trans[0];
-            tlY = trans[3];
-            xRes = trans[1];
-            yRes = trans[5];
-            if(yRes < 0)
-            {
-                yRes = yRes * (-1);
-            }
-            imgSizeX = inputImage->GetRasterXSize();
-            imgSizeY = inputImage->GetRasterYSize();
-            
-            delete[] trans;
-            
-            double eastings = 0.0;
-            double northings = 0.0;
-            
             OGRFieldDefn imgClassField(vecClassImgCol.c_str(), OFTString);
             imgClassField.SetWidth(254);
             if( inputVecLayer->CreateField( &imgClassField, false ) != OGRERR_NONE )
@@ -1082,8 +1000,50 @@ namespace rsgis{namespace classifier{
             
             int numFeatures = inputVecLayer->GetFeatureCount(TRUE);
             
+            // Stream the point locations through the chunk reader, sampling the image
+            // for a chunk of points at a time (reading each image block once per chunk
+            // rather than a pixel for each feature), so only the sampled values and
+            // not the geometries of the whole layer are held.
+            std::vector<long> ptFIDs;
+            std::vector<float> ptPxlVals;
+            std::vector<unsigned char> ptsInImage;
+            {
+                rsgis::img::RSGISImagePointSampler ptSampler;
+                rsgis::vec::RSGISOGRChunkReader chunkReader(inputVecLayer);
+                std::vector<OGRGeometry*> chunkGeoms;
+                std::vector<long> chunkFIDs;
+                std::vector<double> xCoords;
+                std::vector<double> yCoords;
+                std::vector<float> chunkPxlVals;
+                std::vector<unsigned char> chunkInImage;
+                OGREnvelope ogrEnv;
+                while(chunkReader.nextChunk(&chunkGeoms, &chunkFIDs))
+                {
+                    xCoords.clear();
+                    yCoords.clear();
+                    for(std::vector<OGRGeometry*>::iterator iterGeoms = chunkGeoms.begin(); iterGeoms != chunkGeoms.end(); ++iterGeoms)
+                    {
+                        if(wkbFlatten((*iterGeoms)->getGeometryType()) == wkbPoint)
+                        {
+                            xCoords.push_back(((OGRPoint *) *iterGeoms)->getX());
+                            yCoords.push_back(((OGRPoint *) *iterGeoms)->getY());
+                        }
+                        else
+                        {
+                            (*iterGeoms)->getEnvelope(&ogrEnv);
+                            xCoords.push_back(ogrEnv.MinX + ((ogrEnv.MaxX - ogrEnv.MinX)/2));
+                            yCoords.push_back(ogrEnv.MinY + ((ogrEnv.MaxY - ogrEnv.MinY)/2));
+                        }
+                    }
+                    ptSampler.samplePoints(inputImage, std::vector<unsigned int>(1, 1), xCoords, yCoords, &chunkPxlVals, &chunkInImage);
+                    ptFIDs.insert(ptFIDs.end(), chunkFIDs.begin(), chunkFIDs.end());
+                    ptPxlVals.insert(ptPxlVals.end(), chunkPxlVals.begin(), chunkPxlVals.end());
+                    ptsInImage.insert(ptsInImage.end(), chunkInImage.begin(), chunkInImage.end());
+                }
+            }
+            size_t ptIdx = 0;
+            
             bool nullGeometry = false;
-            OGREnvelope *ogrEnv = NULL;
             OGRGeometry *geometry = NULL;
             std::string classVal = "";
             std::string emptyStr = "";
@@ -1100,28 +1060,24 @@ namespace rsgis{namespace classifier{
                 // Get Geometry.
                 nullGeometry = false;
                 geometry = featObj->GetGeometryRef();
-                if( geometry != NULL && wkbFlatten(geometry->getGeometryType()) == wkbPoint )
-                {
-                    OGRPoint *pt = (OGRPoint *) geometry;
-                    eastings = pt->getX();
-                    northings = pt->getY();
-                }
-                else if(geometry != NULL)
-                {
-                    ogrEnv = new OGREnvelope();
-                    geometry->getEnvelope(ogrEnv);
-                    eastings = ogrEnv->MinX + ((ogrEnv->MaxX - ogrEnv->MinX)/2);
-                    northings = ogrEnv->MinY + ((ogrEnv->MaxY - ogrEnv->MinY)/2);
-                }
-                else
+                if((geometry == NULL) || geometry->IsEmpty())
                 {
                     nullGeometry = true;
                     std::cout << "WARNING: NULL Geometry Present within input file - IGNORED\n";
                 }
+                else if((ptIdx >= ptFIDs.size()) || (ptFIDs.at(ptIdx) != featObj->GetFID()))
+                {
+                    throw rsgis::RSGISImageException("The features were not read in the same order as when they were sampled.");
+                }
                 
                 if(!nullGeometry)
                 {
-                    pxlVal = long(this->findPixelVal(inputImage, 1, eastings, northings, tlX, tlY, xRes, yRes, imgSizeX, imgSizeY));
+                    if(ptsInImage.at(ptIdx) == 0)
+                    {
+                        throw rsgis::RSGISImageException("Point not found within the scene.");
+                    }
+                    pxlVal = long(ptPxlVals.at(ptIdx));
+                    ++ptIdx;
                     if((pxlVal > 0) & (pxlVal < imgClassColVals->size()))
                     {
                         classVal = imgClassColVals->at(pxlVal);
@@ -1291,6 +1247,102 @@ namespace rsgis{namespace classifier{
         return classes;
     }
     
+    void RSGISGenAccuracyPoints::selectStratifiedPxls(GDALDataset *image, const std::vector<long> &rowClassIdx, const std::vector<std::string> &classNames, unsigned int numPts, unsigned int seed, std::vector<std::vector<std::pair<unsigned int, unsigned int> > > *classPxls)
+    {
+        size_t numClasses = classNames.size();
+        unsigned int xSize = image->GetRasterXSize();
+        unsigned int ySize = image->GetRasterYSize();
+        int blockXSize = 0;
+        int blockYSize = 0;
+        image->GetRasterBand(1)->GetBlockSize(&blockXSize, &blockYSize);
+        unsigned int stripRows = (blockYSize > 0)?blockYSize:1;
+        std::vector<unsigned int> rowVals;
+        
+        // First pass: count the pixels of each class.
+        std::cout << "Counting the pixels in each class\n";
+        std::vector<unsigned long> classCounts(numClasses, 0);
+        for(unsigned int yStart = 0; yStart < ySize; yStart += stripRows)
+        {
+            unsigned int numRows = std::min(stripRows, ySize - yStart);
+            this->readClassRows(image, yStart, numRows, &rowVals);
+            for(size_t i = 0; i < rowVals.size(); ++i)
+            {
+                if(rowVals[i] < rowClassIdx.size())
+                {
+                    long classIdx = rowClassIdx[rowVals[i]];
+                    if(classIdx >= 0)
+                    {
+                        ++classCounts[classIdx];
+                    }
+                }
+            }
+        }
+        
+        // Draw the ordinals (within each class) of the pixels to sample.
+        rsgis::utils::RSGISTextUtils txtUtils;
+        std::mt19937 rng(seed);
+        std::vector<std::vector<unsigned long> > selOrdinals(numClasses);
+        for(size_t c = 0; c < numClasses; ++c)
+        {
+            if(classCounts[c] < numPts)
+            {
+                throw rsgis::RSGISImageException("There are only "+txtUtils.sizettostring(classCounts[c])+" pixels for class \""+classNames[c]+"\" within the image, so "+txtUtils.sizettostring(numPts)+" points cannot be sampled.");
+            }
+            std::set<unsigned long> selected;
+            for(unsigned long j = classCounts[c] - numPts; j < classCounts[c]; ++j)
+            {
+                std::uniform_int_distribution<unsigned long> ordDist(0, j);
+                unsigned long ordinal = ordDist(rng);
+                if(!selected.insert(ordinal).second)
+                {
+                    selected.insert(j);
+                }
+            }
+            selOrdinals[c].assign(selected.begin(), selected.end());
+        }
+        
+        // Second pass: find the locations of the selected pixels.
+        std::cout << "Finding the locations of the sampled pixels\n";
+        classPxls->assign(numClasses, std::vector<std::pair<unsigned int, unsigned int> >());
+        std::vector<unsigned long> classOrdinals(numClasses, 0);
+        std::vector<size_t> nextSel(numClasses, 0);
+        for(unsigned int yStart = 0; yStart < ySize; yStart += stripRows)
+        {
+            unsigned int numRows = std::min(stripRows, ySize - yStart);
+            this->readClassRows(image, yStart, numRows, &rowVals);
+            for(size_t i = 0; i < rowVals.size(); ++i)
+            {
+                if(rowVals[i] >= rowClassIdx.size())
+                {
+                    continue;
+                }
+                long classIdx = rowClassIdx[rowVals[i]];
+                if(classIdx < 0)
+                {
+                    continue;
+                }
+                size_t selIdx = nextSel[classIdx];
+                if((selIdx < selOrdinals[classIdx].size()) && (selOrdinals[classIdx][selIdx] == classOrdinals[classIdx]))
+                {
+                    classPxls->at(classIdx).push_back(std::pair<unsigned int, unsigned int>(i % xSize, yStart + (i / xSize)));
+                    ++nextSel[classIdx];
+                }
+                ++classOrdinals[classIdx];
+            }
+        }
+    }
+    
+    void RSGISGenAccuracyPoints::readClassRows(GDALDataset *image, unsigned int yStart, unsigned int numRows, std::vector<unsigned int> *rowVals)
+    {
+        unsigned int xSize = image->GetRasterXSize();
+        rowVals->resize(((size_t)xSize) * numRows);
+        CPLErr err = image->GetRasterBand(1)->RasterIO(GF_Read, 0, yStart, xSize, numRows, &(*rowVals)[0], xSize, numRows, GDT_UInt32, 0, 0);
+        if(err != CE_None)
+        {
+            throw rsgis::RSGISImageException("Could not read the classification image.");
+        }
+    }
+    
     RSGISGenAccuracyPoints::~RSGISGenAccuracyPoints()
     {
         
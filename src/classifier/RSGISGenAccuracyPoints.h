@@ -30,6 +30,9 @@
 #include <vector>
 #include <map>
 #include <utility>
+#include <random>
+#include <set>
+#include <algorithm>
 
 #include "gdal_priv.h"
 #include "gdal_rat.h"
@@ -39,6 +42,10 @@
 #include "common/RSGISImageException.h"
 #include "utils/RSGISTextUtils.h"
 
+#include "img/RSGISImagePointSampler.h"
+
+#include "vec/RSGISOGRChunkReader.h"
+
 #include "rastergis/RSGISRasterAttUtils.h"
 
 #include <boost/algorithm/string/trim_all.hpp>
@@ -118,6 +125,23 @@ namespace rsgis{namespace classifier{
         float findPixelVal(GDALDataset *image, unsigned int band, double eastings, double northings, double tlX, double tlY, double xRes, double yRes, unsigned int xSize, unsigned int ySize);
         std::string findClassVal(GDALDataset *image, unsigned int band, GDALRasterAttributeTable *attTable, unsigned int classNameColIdx, unsigned int xPxl, unsigned int yPxl);
         std::list<std::string>* findUniqueClasses(GDALRasterAttributeTable *attTable, unsigned int classNameColIdx, int histoColIdx);
+        /**
+         * Select numPts pixels at random (without replacement) from each class
+         * in two sequential reads of the first band of the image, rather than
+         * testing randomly drawn pixels until every class has enough. The
+         * first read counts the pixels of each class (rowClassIdx gives the
+         * class index of each pixel value, or -1 for no class), the ordinals
+         * of the pixels to sample within each class are then drawn (Floyd's
+         * algorithm) and the second read picks out the (x, y) pixel locations
+         * of those ordinals, in image order. An exception is thrown if a class
+         * has fewer than numPts pixels.
+         */
+        void selectStratifiedPxls(GDALDataset *image, const std::vector<long> &rowClassIdx, const std::vector<std::string> &classNames, unsigned int numPts, unsigned int seed, std::vector<std::vector<std::pair<unsigned int, unsigned int> > > *classPxls);
+        /**
+         * Read rows [yStart, yStart+numRows) of the first band of the image as
+         * unsigned integers (the RAT row of each pixel).
+         */
+        void readClassRows(GDALDataset *image, unsigned int yStart, unsigned int numRows, std::vector<unsigned int> *rowVals);
     };
     
     class DllExport RSGISExtractClassPxllocs : public rsgis::img::RSGISCalcImageValue
@@ -243,6 +243,117 @@ namespace rsgis{ namespace classifier{
 		hasInitClusterCentres = true;
 	}
 	
+	bool RSGISISODATAClassifier::loadImageData(unsigned int subSample, double maxMemMB)
+	{
+		if(!hasInitClusterCentres)
+		{
+			throw RSGISClassificationException("The cluster centres have not been initialised.");
+		}
+		return this->pxlData.readImages(this->datasets, this->numDatasets, subSample, maxMemMB);
+	}
+    
+	void RSGISISODATAClassifier::setNumThreads(unsigned int numThreads)
+	{
+		this->pxlData.setNumThreads(numThreads);
+	}
+    
+	void RSGISISODATAClassifier::calcNewCentresInMemory(RSGISISODATACalcPixelClusterCalcImageVal *calcClusterCentre)
+	{
+		// Each range of pixels is summed separately and the sums added in order so
+		// the centres do not depend on the order the threads finish.
+		std::vector<std::pair<size_t, RSGISISODATACalcPixelClusterCalcImageVal*> > rangeCalcs;
+		std::mutex rangeCalcsMutex;
+		try
+		{
+			this->pxlData.processInThreads([this, &rangeCalcs, &rangeCalcsMutex](size_t start, size_t end)
+			{
+				RSGISISODATACalcPixelClusterCalcImageVal *rangeCalc = new RSGISISODATACalcPixelClusterCalcImageVal(0, this->clusterCentres, this->numImageBands);
+				{
+					std::lock_guard<std::mutex> lock(rangeCalcsMutex);
+					rangeCalcs.push_back(std::pair<size_t, RSGISISODATACalcPixelClusterCalcImageVal*>(start, rangeCalc));
+				}
+				for(size_t i = start; i < end; ++i)
+				{
+					rangeCalc->calcImageValue(this->pxlData.getPxlVals(i), this->numImageBands);
+				}
+			});
+		}
+		catch(...)
+		{
+			for(std::vector<std::pair<size_t, RSGISISODATACalcPixelClusterCalcImageVal*> >::iterator iterCalcs = rangeCalcs.begin(); iterCalcs != rangeCalcs.end(); ++iterCalcs)
+			{
+				delete (*iterCalcs).second;
+			}
+			throw;
+		}
+		
+		std::sort(rangeCalcs.begin(), rangeCalcs.end());
+		for(std::vector<std::pair<size_t, RSGISISODATACalcPixelClusterCalcImageVal*> >::iterator iterCalcs = rangeCalcs.begin(); iterCalcs != rangeCalcs.end(); ++iterCalcs)
+		{
+			calcClusterCentre->addCalcValues((*iterCalcs).second);
+			delete (*iterCalcs).second;
+		}
+	}
+    
+	void RSGISISODATAClassifier::calcStdDevsInMemory(std::vector<ClusterCentreISO*> *centres)
+	{
+		// Sum the squared differences to the nearest centre for each range of
+		// pixels and add them to the centres in order, as for the centres.
+		size_t numCentres = centres->size();
+		if(numCentres == 0)
+		{
+			return;
+		}
+		unsigned int numBands = this->numImageBands;
+		std::vector<std::pair<size_t, std::vector<double> > > rangeSums;
+		std::mutex rangeSumsMutex;
+		this->pxlData.processInThreads([this, centres, numCentres, numBands, &rangeSums, &rangeSumsMutex](size_t start, size_t end)
+		{
+			std::vector<double> sums(numCentres * numBands, 0.0);
+			for(size_t i = start; i < end; ++i)
+			{
+				float *bandValues = this->pxlData.getPxlVals(i);
+				double minDistance = 0;
+				size_t minIdx = 0;
+				for(size_t c = 0; c < numCentres; ++c)
+				{
+					double *centre = (*centres)[c]->data->vector;
+					double sum = 0;
+					for(unsigned int j = 0; j < numBands; ++j)
+					{
+						sum += ((centre[j] - bandValues[j])*(centre[j] - bandValues[j]));
+					}
+					double distance = sum/numBands;
+					if((c == 0) || (distance < minDistance))
+					{
+						minDistance = distance;
+						minIdx = c;
+					}
+				}
+				double *centre = (*centres)[minIdx]->data->vector;
+				for(unsigned int j = 0; j < numBands; ++j)
+				{
+					sums[(minIdx*numBands)+j] += (centre[j] - bandValues[j])*(centre[j] - bandValues[j]);
+				}
+			}
+			std::lock_guard<std::mutex> lock(rangeSumsMutex);
+			rangeSums.push_back(std::pair<size_t, std::vector<double> >(start, std::vector<double>()));
+			rangeSums.back().second.swap(sums);
+		});
+		
+		std::sort(rangeSums.begin(), rangeSums.end());
+		for(std::vector<std::pair<size_t, std::vector<double> > >::iterator iterSums = rangeSums.begin(); iterSums != rangeSums.end(); ++iterSums)
+		{
+			for(size_t c = 0; c < numCentres; ++c)
+			{
+				for(unsigned int j = 0; j < numBands; ++j)
+				{
+					(*centres)[c]->stddev->vector[j] += (*iterSums).second[(c*numBands)+j];
+				}
+			}
+		}
+	}
+	
 	void RSGISISODATAClassifier::calcClusterCentres(double terminalThreshold, unsigned int maxIterations, unsigned int minNumVals, double minDistanceBetweenCentres, double stddevThres, float propOverAvgDist)
 	{
 		if(hasInitClusterCentres)
@@ -273,7 +384,14 @@ namespace rsgis{ namespace classifier{
 					averageDistance = 0;
 					
 					// Identify new centres
-					calcImageClusterCentres->calcImage(datasets, numDatasets);
+					if(this->pxlData.hasData())
+					{
+						this->calcNewCentresInMemory(calcClusterCentre);
+					}
+					else
+					{
+						calcImageClusterCentres->calcImage(datasets, numDatasets);
+					}
 					newClusterCentres = calcClusterCentre->getNewClusterCentres();					
 					// Calculate distance between new and old centres.
 					iterNewCentres = newClusterCentres->begin();
@@ -313,7 +431,14 @@ namespace rsgis{ namespace classifier{
 					{
 						// Calc cluster std devs
 						calcClusterStdDevs->reset(newClusterCentres);
-						calcImageClusterStddevs->calcImage(datasets, numDatasets);
+						if(this->pxlData.hasData())
+						{
+							this->calcStdDevsInMemory(newClusterCentres);
+						}
+						else
+						{
+							calcImageClusterStddevs->calcImage(datasets, numDatasets);
+						}
 						for(iterNewCentres = newClusterCentres->begin(); iterNewCentres != newClusterCentres->end(); ++iterNewCentres)
 						{
 							for(unsigned int i = 0; i < this->numImageBands; ++i)
@@ -681,6 +806,27 @@ namespace rsgis{ namespace classifier{
 		return sumDist/numVals;
 	}
 	
+	void RSGISISODATACalcPixelClusterCalcImageVal::addCalcValues(RSGISISODATACalcPixelClusterCalcImageVal *calcVals)
+	{
+		if(calcVals->newClusterCentres->size() != this->newClusterCentres->size())
+		{
+			throw rsgis::img::RSGISImageCalcException("The number of clusters are not the same.");
+		}
+		std::vector<ClusterCentreISO*>::iterator iterCentres = newClusterCentres->begin();
+		std::vector<ClusterCentreISO*>::iterator iterCalcCentres = calcVals->newClusterCentres->begin();
+		for(; iterCentres != newClusterCentres->end(); ++iterCentres, ++iterCalcCentres)
+		{
+			for(unsigned int i = 0; i < numImageBands; ++i)
+			{
+				(*iterCentres)->data->vector[i] += (*iterCalcCentres)->data->vector[i];
+			}
+			(*iterCentres)->numVals += (*iterCalcCentres)->numVals;
+			(*iterCentres)->avgDist += (*iterCalcCentres)->avgDist;
+		}
+		sumDist += calcVals->sumDist;
+		numVals += calcVals->numVals;
+	}
+	
 	RSGISISODATACalcPixelClusterCalcImageVal::~RSGISISODATACalcPixelClusterCalcImageVal()
 	{
 		rsgis::math::RSGISVectors vecUtils;
@@ -31,6 +31,7 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <mutex>
 
 #include "img/RSGISCalcImageValue.h"
 #include "img/RSGISImageCalcException.h"
@@ -61,16 +62,32 @@
 
 namespace rsgis{ namespace classifier{
 	
+    class RSGISISODATACalcPixelClusterCalcImageVal;
+    
 	class DllExport RSGISISODATAClassifier
 	{
 	public:
 		RSGISISODATAClassifier(std::string inputImageFile, bool printinfo);
 		void initClusterCentresRandom(unsigned int numClusters);
 		void initClusterCentresKpp(unsigned int numClusters);
+        /**
+         * Read the image (every subSample'th pixel) into memory, if it needs no more
+         * than maxMemMB, so calcClusterCentres iterates over it in parallel rather
+         * than reading the image twice for every iteration. Returns whether it was
+         * read. The cluster centres must be initialised first.
+         */
+        bool loadImageData(unsigned int subSample=1, double maxMemMB=1024);
+        /**
+         * Set the number of threads used for the data in memory (0 uses the number of cores).
+         */
+        void setNumThreads(unsigned int numThreads);
 		void calcClusterCentres(double terminalThreshold, unsigned int maxIterations, unsigned int minNumVals, double minDistanceBetweenCentres, double stddevThres, float propOverAvgDist);
 		void generateOutputImage(std::string outputImageFile);
 		~RSGISISODATAClassifier();
 	protected:
+        void calcNewCentresInMemory(RSGISISODATACalcPixelClusterCalcImageVal *calcClusterCentre);
+        void calcStdDevsInMemory(std::vector<ClusterCentreISO*> *centres);
+        RSGISClassifierPxlData pxlData;
 		std::string inputImageFile;
 		std::vector<ClusterCentreISO*> *clusterCentres;
 		bool hasInitClusterCentres;
@@ -98,6 +115,10 @@ namespace rsgis{ namespace classifier{
 		std::vector<ClusterCentreISO*>* getNewClusterCentres();
 		void reset(std::vector<ClusterCentreISO*> *clusterCentres);
 		double getAverageDistance();
+        /**
+         * Add the sums, pixel counts and distances of calcVals (for the same centres) to these.
+         */
+        void addCalcValues(RSGISISODATACalcPixelClusterCalcImageVal *calcVals);
 		~RSGISISODATACalcPixelClusterCalcImageVal();
 	protected:
 		std::vector<ClusterCentreISO*> *clusterCentres;
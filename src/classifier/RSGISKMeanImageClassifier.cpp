@@ -238,6 +238,58 @@ namespace rsgis{ namespace classifier{
 		hasInitClusterCentres = true;
 	}
 	
+	bool RSGISKMeansClassifier::loadImageData(unsigned int subSample, double maxMemMB)
+	{
+		if(!hasInitClusterCentres)
+		{
+			throw RSGISClassificationException("The cluster centres have not been initialised.");
+		}
+		return this->pxlData.readImages(this->datasets, this->numDatasets, subSample, maxMemMB);
+	}
+    
+	void RSGISKMeansClassifier::setNumThreads(unsigned int numThreads)
+	{
+		this->pxlData.setNumThreads(numThreads);
+	}
+    
+	void RSGISKMeansClassifier::calcNewCentresInMemory(RSGISKMeanCalcPixelClusterCalcImageVal *calcClusterCentre)
+	{
+		// Each range of pixels is summed separately and the sums added in order so
+		// the centres do not depend on the order the threads finish.
+		std::vector<std::pair<size_t, RSGISKMeanCalcPixelClusterCalcImageVal*> > rangeCalcs;
+		std::mutex rangeCalcsMutex;
+		try
+		{
+			this->pxlData.processInThreads([this, &rangeCalcs, &rangeCalcsMutex](size_t start, size_t end)
+			{
+				RSGISKMeanCalcPixelClusterCalcImageVal *rangeCalc = new RSGISKMeanCalcPixelClusterCalcImageVal(0, this->clusterCentres, this->numClusters, this->numImageBands);
+				{
+					std::lock_guard<std::mutex> lock(rangeCalcsMutex);
+					rangeCalcs.push_back(std::pair<size_t, RSGISKMeanCalcPixelClusterCalcImageVal*>(start, rangeCalc));
+				}
+				for(size_t i = start; i < end; ++i)
+				{
+					rangeCalc->calcImageValue(this->pxlData.getPxlVals(i), this->numImageBands);
+				}
+			});
+		}
+		catch(...)
+		{
+			for(std::vector<std::pair<size_t, RSGISKMeanCalcPixelClusterCalcImageVal*> >::iterator iterCalcs = rangeCalcs.begin(); iterCalcs != rangeCalcs.end(); ++iterCalcs)
+			{
+				delete (*iterCalcs).second;
+			}
+			throw;
+		}
+		
+		std::sort(rangeCalcs.begin(), rangeCalcs.end());
+		for(std::vector<std::pair<size_t, RSGISKMeanCalcPixelClusterCalcImageVal*> >::iterator iterCalcs = rangeCalcs.begin(); iterCalcs != rangeCalcs.end(); ++iterCalcs)
+		{
+			calcClusterCentre->addCalcValues((*iterCalcs).second);
+			delete (*iterCalcs).second;
+		}
+	}
+	
 	void RSGISKMeansClassifier::calcClusterCentres(double terminalThreshold, unsigned int maxIterations, bool saveCentres, std::string outCentresFileName)
 	{
 		if(hasInitClusterCentres)
@@ -263,7 +315,14 @@ namespace rsgis{ namespace classifier{
 					centreMoveDistance = 0;
 					
 					// Identify new centres
-					calcImage->calcImage(datasets, numDatasets);
+					if(this->pxlData.hasData())
+					{
+						this->calcNewCentresInMemory(calcClusterCentre);
+					}
+					else
+					{
+						calcImage->calcImage(datasets, numDatasets);
+					}
 					newClusterCentres = calcClusterCentre->getNewClusterCentres();
 					numPxlsInCluster = calcClusterCentre->getPxlsInClusters();
 					
@@ -477,6 +536,22 @@ namespace rsgis{ namespace classifier{
 		return newClusterCentres;
 	}
 	
+	void RSGISKMeanCalcPixelClusterCalcImageVal::addCalcValues(RSGISKMeanCalcPixelClusterCalcImageVal *calcVals)
+	{
+		if(calcVals->numClusters != this->numClusters)
+		{
+			throw rsgis::img::RSGISImageCalcException("The number of clusters are not the same.");
+		}
+		for(unsigned int i = 0; i < numClusters; ++i)
+		{
+			for(unsigned int j = 0; j < numImageBands; ++j)
+			{
+				newClusterCentres[i]->data->vector[j] += calcVals->newClusterCentres[i]->data->vector[j];
+			}
+			numPxlInClusters[i] += calcVals->numPxlInClusters[i];
+		}
+	}
+	
 	void RSGISKMeanCalcPixelClusterCalcImageVal::reset()
 	{
 		for(unsigned int i = 0; i < numClusters; ++i)
@@ -625,6 +700,16 @@ namespace rsgis{ namespace classifier{
 	{
 		this->clusterCentres = clusterCentres;
 		this->numClusters = numClusters;
+        // The centres one after another for RSGISKernels::nearestCentre.
+        this->numCentreVals = (numClusters > 0)?clusterCentres[0]->data->n:0;
+        this->centreVals.resize(((size_t)numClusters) * this->numCentreVals);
+        for(unsigned int i = 0; i < numClusters; ++i)
+        {
+            for(unsigned int j = 0; j < this->numCentreVals; ++j)
+            {
+                this->centreVals[(((size_t)i) * this->numCentreVals) + j] = clusterCentres[i]->data->vector[j];
+            }
+        }
 	}
 	
 	void RSGISApplyKMeanClassifierCalcImageVal::calcImageValue(float *bandValues, int numBands, double *output) 
@@ -641,7 +726,9 @@ namespace rsgis{ namespace classifier{
 			{
 				sum += ((clusterCentres[i]->data->vector[j] - bandValues[j])*(clusterCentres[i]->data->vector[j] - bandValues[j]));
 			}
-			distance = sum/numBands;
+			// The squared distance (not divided by numBands, which only adds
+			// rounding) so calcImageBlock gives the same centres.
+			distance = sum;
 			
 			if(first)
 			{
@@ -657,6 +744,21 @@ namespace rsgis{ namespace classifier{
 		}
 		output[0] = minIdx;
 	}
+    
+    void RSGISApplyKMeanClassifierCalcImageVal::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        if((numClusters == 0) || (((unsigned int)numBands) != numCentreVals))
+        {
+            RSGISCalcImageValue::calcImageBlock(bandPlanes, numBands, nPxls, outPlanes);
+            return;
+        }
+        std::vector<unsigned int> minIdxs(nPxls);
+        rsgis::RSGISKernels::nearestCentre(bandPlanes, numBands, nPxls, centreVals.data(), numClusters, minIdxs.data(), (double*)NULL);
+        for(size_t i = 0; i < nPxls; ++i)
+        {
+            outPlanes[0][i] = minIdxs[i];
+        }
+    }
 	
 	RSGISApplyKMeanClassifierCalcImageVal::~RSGISApplyKMeanClassifierCalcImageVal()
 	{
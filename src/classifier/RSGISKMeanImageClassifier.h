@@ -29,12 +29,15 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
+#include <mutex>
 
 #include "img/RSGISCalcImageValue.h"
 #include "img/RSGISImageCalcException.h"
 #include "img/RSGISImageStatistics.h"
 
 #include "common/RSGISClassificationException.h"
+#include "common/RSGISKernels.h"
 
 #include "utils/RSGISExportForPlotting.h"
 
@@ -47,7 +50,7 @@
 #include <boost/random/variate_generator.hpp>
 
 // mark all exported classes/functions with DllExport to have
-// them exported by Visual Studio
+// them exported by Visual Studio
 #undef DllExport
 #ifdef _MSC_VER
     #ifdef rsgis_classify_EXPORTS
@@ -61,16 +64,31 @@
 
 namespace rsgis{ namespace classifier{
 	
+    class RSGISKMeanCalcPixelClusterCalcImageVal;
+    
 	class DllExport RSGISKMeansClassifier
 	{
 	public:
 		RSGISKMeansClassifier(std::string inputImageFile, bool printinfo);
 		void initClusterCentresRandom(unsigned int numClusters);
 		void initClusterCentresKpp(unsigned int numClusters);
+        /**
+         * Read the image (every subSample'th pixel) into memory, if it needs no more
+         * than maxMemMB, so calcClusterCentres iterates over it in parallel rather
+         * than reading the image for every iteration. Returns whether it was read.
+         * The cluster centres must be initialised first.
+         */
+        bool loadImageData(unsigned int subSample=1, double maxMemMB=1024);
+        /**
+         * Set the number of threads used for the data in memory (0 uses the number of cores).
+         */
+        void setNumThreads(unsigned int numThreads);
 		void calcClusterCentres(double terminalThreshold, unsigned int maxIterations, bool saveCentres = false, std::string outCentresFileName = "");
 		void generateOutputImage(std::string outputImageFile);
 		~RSGISKMeansClassifier();
 	protected:
+        void calcNewCentresInMemory(RSGISKMeanCalcPixelClusterCalcImageVal *calcClusterCentre);
+        RSGISClassifierPxlData pxlData;
 		std::string inputImageFile;
 		ClusterCentre **clusterCentres;
 		unsigned int numClusters;
@@ -97,6 +115,10 @@ namespace rsgis{ namespace classifier{
 		bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw rsgis::img::RSGISImageCalcException("Not Implemented");};
 		unsigned long* getPxlsInClusters();
 		ClusterCentre** getNewClusterCentres();
+        /**
+         * Add the sums and pixel counts of calcVals (for the same centres) to these.
+         */
+        void addCalcValues(RSGISKMeanCalcPixelClusterCalcImageVal *calcVals);
 		void reset();
 		~RSGISKMeanCalcPixelClusterCalcImageVal();
 	protected:
@@ -160,6 +182,12 @@ namespace rsgis{ namespace classifier{
 	public: 
 		RSGISApplyKMeanClassifierCalcImageVal(int numOutBands, ClusterCentre **clusterCentres, unsigned int numClusters);
 		void calcImageValue(float *bandValues, int numBands, double *output);
+        /**
+         * Classifies the block with RSGISKernels::nearestCentre, summing the
+         * distances in double precision as calcImageValue does so both give
+         * the same centre for every pixel.
+         */
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
 		void calcImageValue(float *bandValues, int numBands) {throw rsgis::img::RSGISImageCalcException("Not Implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
@@ -173,6 +201,8 @@ namespace rsgis{ namespace classifier{
 	protected:
 		ClusterCentre **clusterCentres;
 		unsigned int numClusters;
+        unsigned int numCentreVals;
+        std::vector<double> centreVals;
 	};
 }}
 
@@ -64,7 +64,7 @@ namespace rsgis{ namespace classifier{
 						sum += trainingData[i]->data->matrix[matrixIndex];
 						matrixIndex += trainingData[i]->data->n;
 					}
-					clusterCentres[i].data->matrix[j] = sum/clusterCentres[i].data->n;
+					clusterCentres[i].data->matrix[j] = sum/trainingData[i]->data->m;
 				}
 			}
 		}
@@ -103,7 +103,7 @@ namespace rsgis{ namespace classifier{
 						}
 						matrixIndex += trainingData[i]->data->n;
 					}
-					clusterCentres[i].data->matrix[j] = (max - min)/2;
+					clusterCentres[i].data->matrix[j] = (max + min)/2;
 				}
 			}
 		}
@@ -112,6 +112,18 @@ namespace rsgis{ namespace classifier{
 			throw RSGISClassificationException("Centre type is not defined");
 		}
 		
+		this->centreVecs.assign(((size_t)numClasses) * numVariables, 0);
+		this->centreSqNorms.assign(numClasses, 0);
+		for(int i = 0; i < numClasses; i++)
+		{
+			for(int j = 0; j < numVariables; j++)
+			{
+				double centreVal = clusterCentres[i].data->matrix[j];
+				this->centreVecs[(((size_t)i) * numVariables) + j] = centreVal;
+				this->centreSqNorms[i] += centreVal * centreVal;
+			}
+		}
+		
 		std::cout << "CLUSTER CENTRES:\n";
 		for(int i = 0; i < numClasses; i++)
 		{
@@ -135,7 +147,7 @@ namespace rsgis{ namespace classifier{
 			sqSum = 0;
 			for(int j = 0; j < numVars; j++)
 			{
-				sumPair = clusterCentres->data->matrix[i] - variables[j]; 
+				sumPair = clusterCentres[i].data->matrix[j] - variables[j];
 				sqSum += (sumPair*sumPair);
 			}
 			distance = sqrt(sqSum);
@@ -157,6 +169,21 @@ namespace rsgis{ namespace classifier{
 		return minDistClass;
 	}
 	
+	void RSGISMinimumDistanceClassifier::getClassIDs(const float* const* varPlanes, int numVars, size_t nPxls, double *classIDs)
+	{
+		if(numVars != numVariables)
+		{
+			throw RSGISClassificationException("The number of variables is not equal to the number of training variables.");
+		}
+		rsgis::RSGISScratchScope scratch;
+		unsigned int *nearestIdx = scratch.alloc<unsigned int>(nPxls);
+		findNearestRefs(this->centreVecs, this->centreSqNorms, numClasses, varPlanes, numVars, nPxls, nearestIdx);
+		for(size_t p = 0; p < nPxls; ++p)
+		{
+			classIDs[p] = clusterCentres[nearestIdx[p]].classID;
+		}
+	}
+	
 	RSGISMinimumDistanceClassifier::~RSGISMinimumDistanceClassifier()
 	{
 		
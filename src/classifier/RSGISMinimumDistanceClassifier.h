@@ -56,12 +56,21 @@ namespace rsgis{ namespace classifier{
 			RSGISMinimumDistanceClassifier(ClassData **trainingData, int numClasses, MinDistCentreType centreType);
 			virtual int getClassID(float *variables, int numVars);
 			virtual std::string getClassName(float *variables, int numVars);
+			/**
+			 * Assigns each pixel the class of the nearest cluster centre, with
+			 * the distances to all the centres from one matrix product.
+			 */
+			virtual void getClassIDs(const float* const* varPlanes, int numVars, size_t nPxls, double *classIDs);
+			bool isThreadSafe(){return true;};
 			~RSGISMinimumDistanceClassifier();
 		protected:
 			void calcClusterCentres();
 			ClassData* findClass(float *variables, int numVars);
 			ClassData *clusterCentres;
 			MinDistCentreType centreType;
+			// The cluster centres (classes x variables, row major) and their squared norms.
+			std::vector<double> centreVecs;
+			std::vector<double> centreSqNorms;
 		};
 	
 }}
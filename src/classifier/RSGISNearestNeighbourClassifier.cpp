@@ -26,7 +26,22 @@ namespace rsgis{ namespace classifier{
 
 	RSGISNearestNeighbourClassifier::RSGISNearestNeighbourClassifier(ClassData **trainingData, int numClasses) : RSGISClassifier(trainingData, numClasses)
 	{
-
+		for(int i = 0; i < this->numClasses; i++)
+		{
+			rsgis::math::Matrix *samples = trainingData[i]->data;
+			for(int k = 0; k < samples->m; k++)
+			{
+				double sqNorm = 0;
+				for(int j = 0; j < numVariables; j++)
+				{
+					double sampleVal = samples->matrix[(k * samples->n) + j];
+					this->sampleVecs.push_back(sampleVal);
+					sqNorm += sampleVal * sampleVal;
+				}
+				this->sampleSqNorms.push_back(sqNorm);
+				this->sampleClassIDs.push_back(trainingData[i]->classID);
+			}
+		}
 	}
 	
 	int RSGISNearestNeighbourClassifier::getClassID(float *variables, int numVars)
@@ -99,6 +114,21 @@ namespace rsgis{ namespace classifier{
 		return minDistance;
 	}
 	
+	void RSGISNearestNeighbourClassifier::getClassIDs(const float* const* varPlanes, int numVars, size_t nPxls, double *classIDs)
+	{
+		if(numVars != numVariables)
+		{
+			throw RSGISClassificationException("The number of variables is not equal to the number of training variables.");
+		}
+		rsgis::RSGISScratchScope scratch;
+		unsigned int *nearestIdx = scratch.alloc<unsigned int>(nPxls);
+		findNearestRefs(this->sampleVecs, this->sampleSqNorms, this->sampleClassIDs.size(), varPlanes, numVars, nPxls, nearestIdx);
+		for(size_t p = 0; p < nPxls; ++p)
+		{
+			classIDs[p] = this->sampleClassIDs[nearestIdx[p]];
+		}
+	}
+	
 	RSGISNearestNeighbourClassifier::~RSGISNearestNeighbourClassifier()
 	{
 		
@@ -51,10 +51,21 @@ namespace rsgis{ namespace classifier{
 			RSGISNearestNeighbourClassifier(ClassData **trainingData, int numClasses);
 			virtual int getClassID(float *variables, int numVars);
 			virtual std::string getClassName(float *variables, int numVars);
+			/**
+			 * Assigns each pixel the class of the nearest training sample, with
+			 * the distances to all the samples from matrix products.
+			 */
+			virtual void getClassIDs(const float* const* varPlanes, int numVars, size_t nPxls, double *classIDs);
+			bool isThreadSafe(){return true;};
 			~RSGISNearestNeighbourClassifier();
 		protected:
 			ClassData* findClass(float *variables, int numVars);
 			double findClosestPointInClass(ClassData *data, float *variables, int numVars);
+			// All the training samples (samples x variables, row major), their
+			// squared norms and the class ID of each.
+			std::vector<double> sampleVecs;
+			std::vector<double> sampleSqNorms;
+			std::vector<int> sampleClassIDs;
 		};
 
 }}
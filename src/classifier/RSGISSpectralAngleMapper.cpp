@@ -30,17 +30,11 @@ namespace rsgis { namespace classifier {
 	{
 		this->refSpectra = refSpectra;
 		std::cout << "Number of Refference Spectra = " << refSpectra->size2 << std::endl;
-		this->imageSpecArray = new double[refSpectra->size1];
+		this->refUnitSpectra = normaliseRefSpectra(refSpectra, false);
 	}
 	void RSGISSpectralAngleMapperRule::calcImageValue(float *bandValues, int numBands, double *output) 
 	{
 
-		// Load pixel into memory - saves time on disk reads when comparing to a large number of refference spectra.
-		for(unsigned int b = 0; b < refSpectra->size1; b++)
-		{
-			this->imageSpecArray[b] = bandValues[b];
-		}
-		
 		// Loop through output spectra
 		for(unsigned int i = 0; i < refSpectra->size2; i++)
 		{
@@ -52,7 +46,7 @@ namespace rsgis { namespace classifier {
 			// Calculate angle for each spectra in reffernce library
 			for(unsigned int b = 0; b < refSpectra->size1; b++)
 			{
-				double image = imageSpecArray[b];
+				double image = bandValues[b];
 				double ref = gsl_matrix_get(refSpectra, b, i);
 				
 				sumImageRef = sumImageRef + (image * ref);
@@ -66,15 +60,41 @@ namespace rsgis { namespace classifier {
 			output[i] = angle;
 		}
 	}
+	void RSGISSpectralAngleMapperRule::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+	{
+		if(numBands != ((int)refSpectra->size1))
+		{
+			throw rsgis::img::RSGISImageCalcException("The number of image bands is not equal to the number of bands in the reference spectra.");
+		}
+		size_t numRefs = refSpectra->size2;
+		rsgis::RSGISScratchScope scratch(this->getScratchArena());
+		size_t chunkSize = std::min<size_t>(nPxls, 1024);
+		double *xVals = scratch.alloc<double>(numBands * chunkSize);
+		double *cosVals = scratch.alloc<double>(numRefs * chunkSize);
+		for(size_t start = 0; start < nPxls; start += chunkSize)
+		{
+			size_t nChunk = std::min(chunkSize, nPxls - start);
+			calcSpectraCosines(this->refUnitSpectra, numRefs, bandPlanes, numBands, start, nChunk, false, xVals, cosVals);
+			for(size_t i = 0; i < numRefs; ++i)
+			{
+				const double *cosRow = cosVals + (i * nChunk);
+				double *outPlane = outPlanes[i] + start;
+				for(size_t p = 0; p < nChunk; ++p)
+				{
+					outPlane[p] = acos(cosRow[p]);
+				}
+			}
+		}
+	}
 	RSGISSpectralAngleMapperRule::~RSGISSpectralAngleMapperRule()
 	{
-		delete imageSpecArray;
 	}
 	
 	RSGISSpectralAngleMapperED::RSGISSpectralAngleMapperED(int numOutBands, gsl_matrix *refSpectra) : RSGISCalcImageValue(numOutBands)
 	{
 		this->refSpectra = refSpectra;
 		std::cout << "Number of Refference Spectra = " << refSpectra->size2 << std::endl;
+		this->refUnitSpectra = normaliseRefSpectra(refSpectra, false);
 	}
 	void RSGISSpectralAngleMapperED::calcImageValue(float *bandValues, int numBands, double *output) 
 	{
@@ -105,6 +125,33 @@ namespace rsgis { namespace classifier {
 			output[i] = euclidianDistance;
 		}
 	}
+	void RSGISSpectralAngleMapperED::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+	{
+		if(numBands != ((int)refSpectra->size1))
+		{
+			throw rsgis::img::RSGISImageCalcException("The number of image bands is not equal to the number of bands in the reference spectra.");
+		}
+		size_t numRefs = refSpectra->size2;
+		rsgis::RSGISScratchScope scratch(this->getScratchArena());
+		size_t chunkSize = std::min<size_t>(nPxls, 1024);
+		double *xVals = scratch.alloc<double>(numBands * chunkSize);
+		double *cosVals = scratch.alloc<double>(numRefs * chunkSize);
+		for(size_t start = 0; start < nPxls; start += chunkSize)
+		{
+			size_t nChunk = std::min(chunkSize, nPxls - start);
+			calcSpectraCosines(this->refUnitSpectra, numRefs, bandPlanes, numBands, start, nChunk, false, xVals, cosVals);
+			for(size_t i = 0; i < numRefs; ++i)
+			{
+				const double *cosRow = cosVals + (i * nChunk);
+				double *outPlane = outPlanes[i] + start;
+				for(size_t p = 0; p < nChunk; ++p)
+				{
+					// 2.sin(angle/2) = sqrt(2 - 2.cos(angle))
+					outPlane[p] = sqrt(2.0 - (2.0 * cosRow[p]));
+				}
+			}
+		}
+	}
 	RSGISSpectralAngleMapperED::~RSGISSpectralAngleMapperED()
 	{
 		
@@ -140,9 +187,148 @@ namespace rsgis { namespace classifier {
 		}
 
 	}
+	void RSGISSpectralAngleMapperClassifier::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+	{
+		// The class is held in the output plane while the minimum is found.
+		rsgis::RSGISScratchScope scratch(this->getScratchArena());
+		double *minAngles = scratch.alloc<double>(nPxls);
+		double *outClasses = outPlanes[0];
+		for(size_t p = 0; p < nPxls; ++p)
+		{
+			minAngles[p] = 100;
+			outClasses[p] = 0;
+		}
+		for(int i = 0; i < numBands; i++)
+		{
+			const float *inPlane = bandPlanes[i];
+			double classVal = i + 1;
+			for(size_t p = 0; p < nPxls; ++p)
+			{
+				double angle = inPlane[p];
+				bool smaller = angle < minAngles[p];
+				minAngles[p] = smaller?angle:minAngles[p];
+				outClasses[p] = smaller?classVal:outClasses[p];
+			}
+		}
+		for(size_t p = 0; p < nPxls; ++p)
+		{
+			outClasses[p] = (minAngles[p] < this->threashold)?outClasses[p]:0;
+		}
+	}
 	RSGISSpectralAngleMapperClassifier::~RSGISSpectralAngleMapperClassifier()
 	{
 		
 	}
+	
+	std::vector<double> normaliseRefSpectra(const gsl_matrix *refSpectra, bool centre)
+	{
+		size_t numBands = refSpectra->size1;
+		size_t numRefs = refSpectra->size2;
+		std::vector<double> refUnitSpectra(numRefs * numBands, 0);
+		for(size_t i = 0; i < numRefs; ++i)
+		{
+			double *refVec = &refUnitSpectra[i * numBands];
+			double mean = 0;
+			for(size_t b = 0; b < numBands; ++b)
+			{
+				refVec[b] = gsl_matrix_get(refSpectra, b, i);
+				mean += refVec[b];
+			}
+			mean = centre?(mean / numBands):0;
+			double sqSum = 0;
+			for(size_t b = 0; b < numBands; ++b)
+			{
+				refVec[b] -= mean;
+				sqSum += refVec[b] * refVec[b];
+			}
+			// A zero reference gives NaN for every pixel, as the per pixel calculations do.
+			double scale = 1.0 / sqrt(sqSum);
+			for(size_t b = 0; b < numBands; ++b)
+			{
+				refVec[b] *= scale;
+			}
+		}
+		return refUnitSpectra;
+	}
+	
+	void calcSpectraCosines(const std::vector<double> &refUnitSpectra, size_t numRefs, const float* const* bandPlanes, size_t numBands, size_t start, size_t nPxls, bool centre, double *xVals, double *cosVals)
+	{
+		if((numRefs == 0) || (nPxls == 0))
+		{
+			return;
+		}
+		for(size_t b = 0; b < numBands; ++b)
+		{
+			const float *inPlane = bandPlanes[b] + start;
+			double *xRow = xVals + (b * nPxls);
+			for(size_t p = 0; p < nPxls; ++p)
+			{
+				xRow[p] = inPlane[p];
+			}
+		}
+		if(centre)
+		{
+			// The band means are accumulated in the first row of cosVals.
+			double *means = cosVals;
+			for(size_t p = 0; p < nPxls; ++p)
+			{
+				means[p] = 0;
+			}
+			for(size_t b = 0; b < numBands; ++b)
+			{
+				const double *xRow = xVals + (b * nPxls);
+				for(size_t p = 0; p < nPxls; ++p)
+				{
+					means[p] += xRow[p];
+				}
+			}
+			for(size_t b = 0; b < numBands; ++b)
+			{
+				double *xRow = xVals + (b * nPxls);
+				for(size_t p = 0; p < nPxls; ++p)
+				{
+					xRow[p] -= means[p] / numBands;
+				}
+			}
+		}
+		
+		gsl_matrix_const_view rMat = gsl_matrix_const_view_array(&refUnitSpectra[0], numRefs, numBands);
+		gsl_matrix_view xMat = gsl_matrix_view_array(xVals, numBands, nPxls);
+		gsl_matrix_view cMat = gsl_matrix_view_array(cosVals, numRefs, nPxls);
+		int status = gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, &rMat.matrix, &xMat.matrix, 0.0, &cMat.matrix);
+		if(status != 0)
+		{
+			throw rsgis::img::RSGISImageCalcException(gsl_strerror(status));
+		}
+		
+		// The pixel norms are only needed after the product so the (already
+		// used) first band row of xVals holds the inverse norms.
+		double *invNorms = xVals;
+		for(size_t p = 0; p < nPxls; ++p)
+		{
+			invNorms[p] *= invNorms[p];
+		}
+		for(size_t b = 1; b < numBands; ++b)
+		{
+			const double *xRow = xVals + (b * nPxls);
+			for(size_t p = 0; p < nPxls; ++p)
+			{
+				invNorms[p] += xRow[p] * xRow[p];
+			}
+		}
+		for(size_t p = 0; p < nPxls; ++p)
+		{
+			invNorms[p] = 1.0 / sqrt(invNorms[p]);
+		}
+		for(size_t i = 0; i < numRefs; ++i)
+		{
+			double *cosRow = cosVals + (i * nPxls);
+			for(size_t p = 0; p < nPxls; ++p)
+			{
+				// Rounding can take the cosine of (nearly) identical spectra past +/-1.
+				cosRow[p] = std::max(std::min(cosRow[p] * invNorms[p], 1.0), -1.0);
+			}
+		}
+	}
 				
 }}
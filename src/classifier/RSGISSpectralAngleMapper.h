@@ -25,7 +25,11 @@
 #define RSGISSpectralAngleMapper_H
 
 #include <math.h>
+#include <vector>
+#include <algorithm>
 #include <gsl/gsl_matrix.h>
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_errno.h>
 
 #include "img/RSGISCalcImage.h"
 #include "img/RSGISCalcImageValue.h"
@@ -61,10 +65,18 @@ namespace rsgis { namespace classifier {
 		void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output, geos::geom::Envelope extent) {throw rsgis::img::RSGISImageCalcException("No implemented");};
 		bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};												
+		/**
+		 * The angles for a block of pixels. The reference spectra are normalised
+		 * once so, with the pixel norms, the cosines of the angles to all the
+		 * references come from one matrix product for each chunk of pixels.
+		 */
+		void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+		bool isThreadSafe(){return true;};
 		~RSGISSpectralAngleMapperRule();
 	private:
-		double *imageSpecArray;
 		gsl_matrix *refSpectra;
+		// The unit reference spectra (spectra x bands, row major).
+		std::vector<double> refUnitSpectra;
 	};
 	
 	class DllExport RSGISSpectralAngleMapperED : public rsgis::img::RSGISCalcImageValue
@@ -81,11 +93,34 @@ namespace rsgis { namespace classifier {
 		void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output, geos::geom::Envelope extent) {throw rsgis::img::RSGISImageCalcException("No implemented");};
 		bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};															
+		/**
+		 * The distances for a block of pixels, from the cosines of the angles
+		 * calculated as for RSGISSpectralAngleMapperRule::calcImageBlock.
+		 */
+		void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+		bool isThreadSafe(){return true;};
 		~RSGISSpectralAngleMapperED();
 	private:
 		gsl_matrix *refSpectra;
+		std::vector<double> refUnitSpectra;
 	};
 	
+	/**
+	 * The reference spectra (the columns of refSpectra, bands x spectra) as
+	 * unit vectors (spectra x bands, row major), optionally centred on their
+	 * means first (for the spectral correlation mapper).
+	 */
+	DllExport std::vector<double> normaliseRefSpectra(const gsl_matrix *refSpectra, bool centre);
+	
+	/**
+	 * The cosines of the angles between nPxls pixels, starting at pxl start,
+	 * and the unit reference spectra, written to cosVals (spectra x nPxls, row
+	 * major) with xVals (bands x nPxls) used as workspace. Pixels with zero
+	 * norm give NaN, as for the per pixel calculations. If centre is true each
+	 * pixel spectrum is centred on its mean first.
+	 */
+	DllExport void calcSpectraCosines(const std::vector<double> &refUnitSpectra, size_t numRefs, const float* const* bandPlanes, size_t numBands, size_t start, size_t nPxls, bool centre, double *xVals, double *cosVals);
+	
 	/// Classify rule image produced by SAM
 	class DllExport RSGISSpectralAngleMapperClassifier : public rsgis::img::RSGISCalcImageValue
 	{
@@ -101,6 +136,12 @@ namespace rsgis { namespace classifier {
 		void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output, geos::geom::Envelope extent) {throw rsgis::img::RSGISImageCalcException("No implemented");};
 		bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};															
+		/**
+		 * Finds the minimum angle a band at a time so the comparisons run
+		 * along the pixels.
+		 */
+		void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+		bool isThreadSafe(){return true;};
 		~RSGISSpectralAngleMapperClassifier();
 	private:
 		double threashold;
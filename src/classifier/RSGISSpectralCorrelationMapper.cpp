@@ -30,17 +30,11 @@ namespace rsgis { namespace classifier {
 	{
 		this->refSpectra = refSpectra;
 		std::cout << "Number of Refference Spectra = " << refSpectra->size2 << std::endl;
-		this->imageSpecArray = new double[refSpectra->size1];
+		this->refUnitSpectra = normaliseRefSpectra(refSpectra, true);
 	}
 	void RSGISSpectralCorrelationMapperRule::calcImageValue(float *bandValues, int numBands, double *output) 
 	{
 		
-		// Load pixel into memory - saves time on disk reads when comparing to a large number of refference spectra.
-		for(unsigned int b = 0; b < refSpectra->size1; b++)
-		{
-			this->imageSpecArray[b] = bandValues[b];
-		}
-		
 		// Loop through output spectra
 		for(unsigned int i = 0; i < refSpectra->size2; i++)
 		{
@@ -52,7 +46,7 @@ namespace rsgis { namespace classifier {
 			// Calc mean
 			for(unsigned int b = 0;b < refSpectra->size1; b++)
 			{
-				sumX = sumX + imageSpecArray[b];
+				sumX = sumX + bandValues[b];
 				sumY = sumY + gsl_matrix_get(refSpectra, b, i);
 			}
 			
@@ -66,7 +60,7 @@ namespace rsgis { namespace classifier {
 			for(unsigned int b = 0; b < refSpectra->size1; b++)
 			{
 				
-				double dataX = imageSpecArray[b];
+				double dataX = bandValues[b];
 				double dataY = gsl_matrix_get(refSpectra, b, i);
 				
 				ssXY = ssXY + ((dataX - xMean)*(dataY - yMean));
@@ -80,9 +74,34 @@ namespace rsgis { namespace classifier {
 			output[i] = scm;
 		}
 	}
+	void RSGISSpectralCorrelationMapperRule::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+	{
+		if(numBands != ((int)refSpectra->size1))
+		{
+			throw rsgis::img::RSGISImageCalcException("The number of image bands is not equal to the number of bands in the reference spectra.");
+		}
+		size_t numRefs = refSpectra->size2;
+		rsgis::RSGISScratchScope scratch(this->getScratchArena());
+		size_t chunkSize = std::min<size_t>(nPxls, 1024);
+		double *xVals = scratch.alloc<double>(numBands * chunkSize);
+		double *cosVals = scratch.alloc<double>(numRefs * chunkSize);
+		for(size_t start = 0; start < nPxls; start += chunkSize)
+		{
+			size_t nChunk = std::min(chunkSize, nPxls - start);
+			calcSpectraCosines(this->refUnitSpectra, numRefs, bandPlanes, numBands, start, nChunk, true, xVals, cosVals);
+			for(size_t i = 0; i < numRefs; ++i)
+			{
+				const double *cosRow = cosVals + (i * nChunk);
+				double *outPlane = outPlanes[i] + start;
+				for(size_t p = 0; p < nChunk; ++p)
+				{
+					outPlane[p] = fabs(cosRow[p]);
+				}
+			}
+		}
+	}
 	RSGISSpectralCorrelationMapperRule::~RSGISSpectralCorrelationMapperRule()
 	{
-		delete imageSpecArray;
 	}
 	
 	RSGISSpectralCorrelationMapperClassifier::RSGISSpectralCorrelationMapperClassifier(int numOutBands, double threashold) : RSGISCalcImageValue(numOutBands)
@@ -115,6 +134,34 @@ namespace rsgis { namespace classifier {
 		}
 		
 	}
+	void RSGISSpectralCorrelationMapperClassifier::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+	{
+		// The class is held in the output plane while the maximum is found.
+		rsgis::RSGISScratchScope scratch(this->getScratchArena());
+		double *maxCorrelations = scratch.alloc<double>(nPxls);
+		double *outClasses = outPlanes[0];
+		for(size_t p = 0; p < nPxls; ++p)
+		{
+			maxCorrelations[p] = 0;
+			outClasses[p] = 0;
+		}
+		for(int i = 0; i < numBands; i++)
+		{
+			const float *inPlane = bandPlanes[i];
+			double classVal = i + 1;
+			for(size_t p = 0; p < nPxls; ++p)
+			{
+				double correlation = inPlane[p];
+				bool larger = correlation > maxCorrelations[p];
+				maxCorrelations[p] = larger?correlation:maxCorrelations[p];
+				outClasses[p] = larger?classVal:outClasses[p];
+			}
+		}
+		for(size_t p = 0; p < nPxls; ++p)
+		{
+			outClasses[p] = (maxCorrelations[p] > this->threashold)?outClasses[p]:0;
+		}
+	}
 	RSGISSpectralCorrelationMapperClassifier::~RSGISSpectralCorrelationMapperClassifier()
 	{
 		
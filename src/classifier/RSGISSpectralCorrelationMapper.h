@@ -25,6 +25,8 @@
 #define RSGISSpectralCorrelationMapper_H
 
 #include <math.h>
+#include <vector>
+#include <algorithm>
 #include <gsl/gsl_matrix.h>
 
 #include "img/RSGISCalcImage.h"
@@ -32,6 +34,8 @@
 #include "img/RSGISImageBandException.h"
 #include "img/RSGISImageCalcException.h"
 
+#include "classifier/RSGISSpectralAngleMapper.h"
+
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
 #undef DllExport
@@ -71,10 +75,19 @@ namespace rsgis { namespace classifier {
 		void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output, geos::geom::Envelope extent) {throw rsgis::img::RSGISImageCalcException("No implemented");};
 		bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};															
+		/**
+		 * The correlations for a block of pixels. The correlation is the cosine
+		 * of the angle between the mean centred spectra so the centred reference
+		 * spectra are normalised once and the correlations with all of them come
+		 * from one matrix product for each chunk of pixels.
+		 */
+		void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+		bool isThreadSafe(){return true;};
 		~RSGISSpectralCorrelationMapperRule();
 	private:
-		double *imageSpecArray;
 		gsl_matrix *refSpectra;
+		// The centred unit reference spectra (spectra x bands, row major).
+		std::vector<double> refUnitSpectra;
 	};
 		
 	/// Classify rule image produced by SAM
@@ -92,6 +105,12 @@ namespace rsgis { namespace classifier {
 		void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output, geos::geom::Envelope extent) {throw rsgis::img::RSGISImageCalcException("No implemented");};
 		bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};															
+		/**
+		 * Finds the maximum correlation a band at a time so the comparisons
+		 * run along the pixels.
+		 */
+		void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+		bool isThreadSafe(){return true;};
 		~RSGISSpectralCorrelationMapperClassifier();
 	private:
 		double threashold;
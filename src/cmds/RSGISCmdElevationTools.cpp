@@ -63,7 +63,9 @@ namespace rsgis{ namespace cmds {
             
             delete[] transformation;
             
-            rsgis::calib::RSGISCalcSlope *calcSlope = new rsgis::calib::RSGISCalcSlope(1, 0, imageEWRes, imageNSRes, outAngleUnit, demNoDataVal);
+            std::vector<rsgis::calib::RSGISDEMDerivative> derivatives;
+            derivatives.push_back((outAngleUnit == rsgis_degrees)?rsgis::calib::rsgis_dem_slope_deg:rsgis::calib::rsgis_dem_slope_rad);
+            rsgis::calib::RSGISCalcDEMDerivatives *calcSlope = new rsgis::calib::RSGISCalcDEMDerivatives(derivatives, 0, imageEWRes, imageNSRes, demNoDataVal);
             
             rsgis::img::RSGISCalcImage calcImage = rsgis::img::RSGISCalcImage(calcSlope, "", true);
             calcImage.calcImageWindowData(&dataset, 1, outputImage, 3, outImageFormat, GDT_Float32);
@@ -115,7 +117,9 @@ namespace rsgis{ namespace cmds {
             
             delete[] transformation;
             
-            rsgis::calib::RSGISCalcAspect *calcAspect = new rsgis::calib::RSGISCalcAspect(1, 0, imageEWRes, imageNSRes, demNoDataVal);
+            std::vector<rsgis::calib::RSGISDEMDerivative> derivatives;
+            derivatives.push_back(rsgis::calib::rsgis_dem_aspect);
+            rsgis::calib::RSGISCalcDEMDerivatives *calcAspect = new rsgis::calib::RSGISCalcDEMDerivatives(derivatives, 0, imageEWRes, imageNSRes, demNoDataVal);
             
             rsgis::img::RSGISCalcImage calcImage = rsgis::img::RSGISCalcImage(calcAspect, "", true);
             calcImage.calcImageWindowData(&dataset, 1, outputImage, 3, outImageFormat, GDT_Float32);
@@ -206,7 +210,9 @@ namespace rsgis{ namespace cmds {
             
             delete[] transformation;
             
-            rsgis::calib::RSGISCalcHillShade *calcHillshade = new rsgis::calib::RSGISCalcHillShade(1, 0, imageEWRes, imageNSRes, solarZenith, solarAzimuth, demNoDataVal);
+            std::vector<rsgis::calib::RSGISDEMDerivative> derivatives;
+            derivatives.push_back(rsgis::calib::rsgis_dem_hillshade);
+            rsgis::calib::RSGISCalcDEMDerivatives *calcHillshade = new rsgis::calib::RSGISCalcDEMDerivatives(derivatives, 0, imageEWRes, imageNSRes, demNoDataVal, solarZenith, solarAzimuth);
             
             rsgis::img::RSGISCalcImage calcImage = rsgis::img::RSGISCalcImage(calcHillshade, "", true);
             calcImage.calcImageWindowData(&dataset, 1, outputImage, 3, outImageFormat, GDT_Byte);
@@ -222,7 +228,7 @@ namespace rsgis{ namespace cmds {
     }
 
     
-    void executeCalcShadowMask(std::string demImage, std::string outputImage, float solarAzimuth, float solarZenith, float maxHeight, std::string outImageFormat)
+    void executeCalcShadowMask(std::string demImage, std::string outputImage, float solarAzimuth, float solarZenith, float maxHeight, std::string outImageFormat, bool horizonSweep)
     {
         try
         {
@@ -268,14 +274,37 @@ namespace rsgis{ namespace cmds {
             
             delete[] transformation;
             
-            rsgis::calib::RSGISCalcShadowBinaryMask *calcShadowMask = new rsgis::calib::RSGISCalcShadowBinaryMask(1, dataset, 0, imageEWRes, imageNSRes, solarZenith, solarAzimuth, maxHeight, demNoDataVal);
-            
-            rsgis::img::RSGISCalcImage calcImage = rsgis::img::RSGISCalcImage(calcShadowMask, "", true);
-            
-            calcImage.calcImageWindowDataExtent(&dataset, 1, outputImage, 3, outImageFormat, GDT_Byte);
-            
-            GDALClose(dataset);
-            delete calcShadowMask;
+            if(horizonSweep)
+            {
+                rsgis::img::RSGISImageUtils imgUtils;
+                GDALDataset *outDataset = imgUtils.createCopy(dataset, 1, outputImage, outImageFormat, GDT_Byte);
+                
+                try
+                {
+                    rsgis::calib::RSGISCalcShadowMaskHorizonSweep calcShadowMask(imageEWRes, imageNSRes, solarZenith, solarAzimuth, demNoDataVal);
+                    calcShadowMask.calcShadowMask(dataset, 1, outDataset);
+                }
+                catch(rsgis::RSGISException &e)
+                {
+                    GDALClose(outDataset);
+                    GDALClose(dataset);
+                    throw e;
+                }
+                
+                GDALClose(outDataset);
+                GDALClose(dataset);
+            }
+            else
+            {
+                rsgis::calib::RSGISCalcShadowBinaryMask *calcShadowMask = new rsgis::calib::RSGISCalcShadowBinaryMask(1, dataset, 0, imageEWRes, imageNSRes, solarZenith, solarAzimuth, maxHeight, demNoDataVal);
+                
+                rsgis::img::RSGISCalcImage calcImage = rsgis::img::RSGISCalcImage(calcShadowMask, "", true);
+                
+                calcImage.calcImageWindowDataExtent(&dataset, 1, outputImage, 3, outImageFormat, GDT_Byte);
+                
+                GDALClose(dataset);
+                delete calcShadowMask;
+            }
         }
         catch(rsgis::RSGISException &e)
         {
@@ -320,7 +349,9 @@ namespace rsgis{ namespace cmds {
             
             delete[] transformation;
             
-            rsgis::calib::RSGISCalcRayIncidentAngle *calcIncidAngle = new rsgis::calib::RSGISCalcRayIncidentAngle(1, 0, imageEWRes, imageNSRes, solarZenith, solarAzimuth, demNoDataVal);
+            std::vector<rsgis::calib::RSGISDEMDerivative> derivatives;
+            derivatives.push_back(rsgis::calib::rsgis_dem_incidence);
+            rsgis::calib::RSGISCalcDEMDerivatives *calcIncidAngle = new rsgis::calib::RSGISCalcDEMDerivatives(derivatives, 0, imageEWRes, imageNSRes, demNoDataVal, solarZenith, solarAzimuth);
             
             rsgis::img::RSGISCalcImage calcImage = rsgis::img::RSGISCalcImage(calcIncidAngle, "", true);
             calcImage.calcImageWindowData(&dataset, 1, outputImage, 3, outImageFormat, GDT_Float32);
@@ -372,7 +403,9 @@ namespace rsgis{ namespace cmds {
             
             delete[] transformation;
             
-            rsgis::calib::RSGISCalcRayExitanceAngle *calcExitAngle = new rsgis::calib::RSGISCalcRayExitanceAngle(1, 0, imageEWRes, imageNSRes, viewZenith, viewAzimuth, demNoDataVal);
+            std::vector<rsgis::calib::RSGISDEMDerivative> derivatives;
+            derivatives.push_back(rsgis::calib::rsgis_dem_exitance);
+            rsgis::calib::RSGISCalcDEMDerivatives *calcExitAngle = new rsgis::calib::RSGISCalcDEMDerivatives(derivatives, 0, imageEWRes, imageNSRes, demNoDataVal, 0, 0, viewZenith, viewAzimuth);
             
             rsgis::img::RSGISCalcImage calcImage = rsgis::img::RSGISCalcImage(calcExitAngle, "", true);
             calcImage.calcImageWindowData(&dataset, 1, outputImage, 3, outImageFormat, GDT_Float32);
@@ -387,6 +420,90 @@ namespace rsgis{ namespace cmds {
         }
     }
             
+    void executeCalcDEMDerivatives(std::string demImage, std::string outputImage, std::vector<RSGISDEMDerivativeType> derivatives, float solarAzimuth, float solarZenith, float viewAzimuth, float viewZenith, std::string outImageFormat)
+    {
+        try
+        {
+            GDALAllRegister();
+            
+            if(derivatives.empty())
+            {
+                throw rsgis::RSGISException("At least one DEM derivative must be specified.");
+            }
+            
+            std::cout << "Open " << demImage << std::endl;
+            GDALDataset *dataset = (GDALDataset *) GDALOpen(demImage.c_str(), GA_ReadOnly);
+            if(dataset == NULL)
+            {
+                std::string message = std::string("Could not open image ") + demImage;
+                throw rsgis::RSGISImageException(message.c_str());
+            }
+            
+            double demNoDataVal = 0.0;
+            int demNoDataValAvail = false;
+            demNoDataVal = dataset->GetRasterBand(1)->GetNoDataValue(&demNoDataValAvail);
+            if(!demNoDataValAvail)
+            {
+                GDALClose(dataset);
+                throw rsgis::RSGISException("The DEM image file does not have a no data value defined. ");
+            }
+            
+            double *transformation = new double[6];
+            dataset->GetGeoTransform(transformation);
+            
+            float imageEWRes = transformation[1];
+            float imageNSRes = transformation[5];
+            
+            if(imageNSRes < 0)
+            {
+                imageNSRes = imageNSRes * (-1);
+            }
+            
+            delete[] transformation;
+            
+            std::vector<rsgis::calib::RSGISDEMDerivative> demDerivatives;
+            for(std::vector<RSGISDEMDerivativeType>::iterator iterDeriv = derivatives.begin(); iterDeriv != derivatives.end(); ++iterDeriv)
+            {
+                switch(*iterDeriv)
+                {
+                    case rsgis_deriv_slope_deg:
+                        demDerivatives.push_back(rsgis::calib::rsgis_dem_slope_deg);
+                        break;
+                    case rsgis_deriv_slope_rad:
+                        demDerivatives.push_back(rsgis::calib::rsgis_dem_slope_rad);
+                        break;
+                    case rsgis_deriv_aspect:
+                        demDerivatives.push_back(rsgis::calib::rsgis_dem_aspect);
+                        break;
+                    case rsgis_deriv_hillshade:
+                        demDerivatives.push_back(rsgis::calib::rsgis_dem_hillshade);
+                        break;
+                    case rsgis_deriv_incidence:
+                        demDerivatives.push_back(rsgis::calib::rsgis_dem_incidence);
+                        break;
+                    case rsgis_deriv_exitance:
+                        demDerivatives.push_back(rsgis::calib::rsgis_dem_exitance);
+                        break;
+                    default:
+                        GDALClose(dataset);
+                        throw rsgis::RSGISException("DEM derivative is not recognised.");
+                }
+            }
+            
+            rsgis::calib::RSGISCalcDEMDerivatives *calcDerivs = new rsgis::calib::RSGISCalcDEMDerivatives(demDerivatives, 0, imageEWRes, imageNSRes, demNoDataVal, solarZenith, solarAzimuth, viewZenith, viewAzimuth);
+            
+            rsgis::img::RSGISCalcImage calcImage = rsgis::img::RSGISCalcImage(calcDerivs, "", true);
+            calcImage.calcImageWindowData(&dataset, 1, outputImage, 3, outImageFormat, GDT_Float32);
+            
+            GDALClose(dataset);
+            delete calcDerivs;
+        }
+        catch(rsgis::RSGISException &e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+    }
+    
     void executeDTMAspectMedianFilter(std::string demImage, std::string aspectImage, std::string outputImage, float aspectRange, int winHSize, std::string outImageFormat)
     {
         try
@@ -486,6 +603,90 @@ namespace rsgis{ namespace cmds {
         }
     }
     
+    void executeDEMFillPriorityFlood(std::string inImage, std::string validDataImg, std::string outputImage, std::string outImageFormat, double epsilon)
+    {
+        try
+        {
+            GDALAllRegister();
+            
+            std::cout << "Open " << inImage << std::endl;
+            GDALDataset *inImgDS = (GDALDataset *) GDALOpen(inImage.c_str(), GA_ReadOnly);
+            if(inImgDS == NULL)
+            {
+                std::string message = std::string("Could not open image ") + inImage;
+                throw rsgis::RSGISImageException(message.c_str());
+            }
+            std::cout << "Open " << validDataImg << std::endl;
+            GDALDataset *inValidImgDS = (GDALDataset *) GDALOpen(validDataImg.c_str(), GA_ReadOnly);
+            if(inValidImgDS == NULL)
+            {
+                std::string message = std::string("Could not open image ") + validDataImg;
+                throw rsgis::RSGISImageException(message.c_str());
+            }
+            
+            // The filled surface is not restricted to integer values so the output is always float.
+            rsgis::img::RSGISImageUtils imgUtils;
+            GDALDataset *outImgDS = imgUtils.createCopy(inImgDS, 1, outputImage, outImageFormat, GDT_Float32);
+            
+            rsgis::calib::RSGISHydroDEMFillSoilleGratin94 fillDEMInst;
+            fillDEMInst.performPriorityFloodFill(inImgDS, inValidImgDS, outImgDS, true, 0, epsilon);
+            
+            GDALClose(inImgDS);
+            GDALClose(inValidImgDS);
+            GDALClose(outImgDS);
+        }
+        catch(rsgis::RSGISException &e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+        catch(std::exception &e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+    }
+    
+    void executeDEMFillVoids(std::string inImage, std::string outputImage, std::string outImageFormat, float holeValue, bool laplacian, unsigned int maxIterations, float tolerance)
+    {
+        try
+        {
+            GDALAllRegister();
+            
+            std::cout << "Open " << inImage << std::endl;
+            GDALDataset *inImgDS = (GDALDataset *) GDALOpen(inImage.c_str(), GA_ReadOnly);
+            if(inImgDS == NULL)
+            {
+                std::string message = std::string("Could not open image ") + inImage;
+                throw rsgis::RSGISImageException(message.c_str());
+            }
+            
+            rsgis::img::RSGISImageUtils imgUtils;
+            GDALDataset *outImgDS = imgUtils.createCopy(inImgDS, 1, outputImage, outImageFormat, GDT_Float32);
+            
+            try
+            {
+                rsgis::calib::RSGISFillDEMVoids fillVoids(holeValue, laplacian, maxIterations, tolerance);
+                fillVoids.fillVoids(inImgDS, 1, outImgDS);
+            }
+            catch(rsgis::RSGISException &e)
+            {
+                GDALClose(inImgDS);
+                GDALClose(outImgDS);
+                throw e;
+            }
+            
+            GDALClose(inImgDS);
+            GDALClose(outImgDS);
+        }
+        catch(rsgis::RSGISException &e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+        catch(std::exception &e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+    }
+    
     void executePlaneFitDetreadDEM(std::string demImage, std::string outputImage, std::string outImageFormat, int winSize)
     {
         try
@@ -52,6 +52,16 @@ namespace rsgis{ namespace cmds {
         rsgis_radians = 1
     };
     
+    enum RSGISDEMDerivativeType
+    {
+        rsgis_deriv_slope_deg = 0,
+        rsgis_deriv_slope_rad = 1,
+        rsgis_deriv_aspect = 2,
+        rsgis_deriv_hillshade = 3,
+        rsgis_deriv_incidence = 4,
+        rsgis_deriv_exitance = 5
+    };
+    
     /** A function to generate a slope layer */
     DllExport void executeCalcSlope(std::string demImage, std::string outputImage, RSGISAngleMeasure outAngleUnit, std::string outImageFormat);
     /** A function to generate an aspect layer */
@@ -60,16 +70,23 @@ namespace rsgis{ namespace cmds {
     DllExport void executeCatagoriseAspect(std::string aspectImage, std::string outputImage, std::string outImageFormat);
     /** A function to generate a hillshade layer */
     DllExport void executeCalcHillshade(std::string demImage, std::string outputImage, float solarAzimuth, float solarZenith, std::string outImageFormat);
-    /** A function to generate a shadow mask layer */
-    DllExport void executeCalcShadowMask(std::string demImage, std::string outputImage, float solarAzimuth, float solarZenith, float maxHeight, std::string outImageFormat);
+    /** A function to generate a shadow mask layer. If horizonSweep is true the mask is calculated by sweeping
+        along lines aligned with the solar azimuth (each pixel visited once) rather than tracing a ray from every pixel, and maxHeight is not used. */
+    DllExport void executeCalcShadowMask(std::string demImage, std::string outputImage, float solarAzimuth, float solarZenith, float maxHeight, std::string outImageFormat, bool horizonSweep=false);
     /** A function to generate a local incidence angle layer given the sun position */
     DllExport void executeCalcLocalIncidenceAngle(std::string demImage, std::string outputImage, float solarAzimuth, float solarZenith, std::string outImageFormat);
     /** A function to generate a local exitance angle layer given a viewers position */
     DllExport void executeCalcLocalExitanceAngle(std::string demImage, std::string outputImage, float viewAzimuth, float viewZenith, std::string outImageFormat);
+    /** A function to generate a set of DEM derivatives (one band each, in the order given) in a single pass */
+    DllExport void executeCalcDEMDerivatives(std::string demImage, std::string outputImage, std::vector<RSGISDEMDerivativeType> derivatives, float solarAzimuth, float solarZenith, float viewAzimuth, float viewZenith, std::string outImageFormat);
     /** A function to filter a DTM using a variable filter with respect to aspect */
     DllExport void executeDTMAspectMedianFilter(std::string demImage, std::string aspectImage, std::string outputImage, float aspectRange, int winHSize, std::string outImageFormat);
     /** A function to fill a DEM using the Soille and Gratin 1994 algorthm */
     DllExport void executeDEMFillSoilleGratin1994(std::string inImage, std::string validDataImg, std::string outputImage, std::string outImageFormat);
+    /** A function to fill a DEM using the priority-flood algorithm with an optional epsilon gradient across filled areas */
+    DllExport void executeDEMFillPriorityFlood(std::string inImage, std::string validDataImg, std::string outputImage, std::string outImageFormat, double epsilon=0);
+    /** A function to fill the voids (pixels equal to holeValue) in a DEM, either with an inward wavefront fill or, if laplacian is true, a smooth (Laplace) surface fitted to the void boundary */
+    DllExport void executeDEMFillVoids(std::string inImage, std::string outputImage, std::string outImageFormat, float holeValue, bool laplacian=false, unsigned int maxIterations=1000, float tolerance=0.001);
     /** A function which detreads an elevation model using local plane fitting */
     DllExport void executePlaneFitDetreadDEM(std::string demImage, std::string outputImage, std::string outImageFormat, int winSize);
 }}
@@ -23,6 +23,7 @@
 
 #include "RSGISCmdFilterImages.h"
 #include "RSGISCmdParent.h"
+#include "common/RSGISProfiler.h"
 
 #include "filtering/RSGISFilterBank.h"
 #include "filtering/RSGISImageFilter.h"
@@ -34,12 +35,14 @@
 #include "filtering/RSGISStatsFilters.h"
 #include "filtering/RSGISSpeckleFilters.h"
 #include "filtering/RSGISSARTextureFilters.h"
+#include "filtering/RSGISGLCMTextures.h"
 
 
 namespace rsgis{ namespace cmds {
 
     void executeFilter(std::string inputImage, std::vector<rsgis::cmds::RSGISFilterParameters*> *filterParameters, std::string outputImageBase, std::string imageFormat, std::string imageExt, RSGISLibDataType outDataType) 
     {
+        rsgis::RSGISProfileSummaryScope profileSummary("executeFilter");
         try
         {
             // Set up filter bank
@@ -220,6 +223,49 @@ namespace rsgis{ namespace cmds {
                     rsgis::filter::RSGISImageFilter *filter = new rsgis::filter::RSGISTextureVar(0, (*iterFilter)->size, (*iterFilter)->fileEnding);
                     filterBank->addFilter(filter);
                 }
+                else if((*iterFilter)->type == "SARTextures")
+                {
+                    // Several SAR textures (a comma separated list in the option) from one set of window moments.
+                    std::vector<rsgis::filter::RSGISSARTexture> textures;
+                    std::string texOptions = (*iterFilter)->option + ",";
+                    size_t texStart = 0;
+                    size_t texEnd = 0;
+                    while((texEnd = texOptions.find(',', texStart)) != std::string::npos)
+                    {
+                        std::string texName = texOptions.substr(texStart, texEnd - texStart);
+                        texStart = texEnd + 1;
+                        if(texName == "")
+                        {
+                            continue;
+                        }
+                        else if((texName == "NormVar") | (texName == "NormVarPower"))
+                        {
+                            textures.push_back(rsgis::filter::sartex_normvarpower);
+                        }
+                        else if((texName == "NormVarSqrt") | (texName == "NormVarAmplitude"))
+                        {
+                            textures.push_back(rsgis::filter::sartex_normvaramplitude);
+                        }
+                        else if((texName == "NormVarLn") | (texName == "NormVarLnPower"))
+                        {
+                            textures.push_back(rsgis::filter::sartex_normvarlnpower);
+                        }
+                        else if(texName == "NormLn")
+                        {
+                            textures.push_back(rsgis::filter::sartex_normln);
+                        }
+                        else if(texName == "TextureVar")
+                        {
+                            textures.push_back(rsgis::filter::sartex_texturevar);
+                        }
+                        else
+                        {
+                            throw RSGISCmdException("SAR texture '" + texName + "' not recognised.");
+                        }
+                    }
+                    rsgis::filter::RSGISImageFilter *filter = new rsgis::filter::RSGISSARTextureFilter(0, (*iterFilter)->size, (*iterFilter)->fileEnding, textures);
+                    filterBank->addFilter(filter);
+                }
                 else if((*iterFilter)->type == "MeanDiff")
                 {
                     rsgis::filter::RSGISImageFilter *filter = new rsgis::filter::RSGISMeanDiffFilter(0, (*iterFilter)->size, (*iterFilter)->fileEnding);
@@ -540,4 +586,56 @@ namespace rsgis{ namespace cmds {
         }
     }
     
+    void executeGLCMTextures(std::string inputImage, unsigned int band, std::string outputImage, std::vector<RSGISGLCMMeasureType> measures, unsigned int numLevels, unsigned int winSize, int xOffset, int yOffset, double minVal, double maxVal, std::string imageFormat, RSGISLibDataType outDataType)
+    {
+        rsgis::RSGISProfileSummaryScope profileSummary("executeGLCMTextures");
+        try
+        {
+            GDALAllRegister();
+            
+            std::vector<rsgis::filter::RSGISGLCMMeasure> glcmMeasures;
+            for(std::vector<RSGISGLCMMeasureType>::iterator iterMeasure = measures.begin(); iterMeasure != measures.end(); ++iterMeasure)
+            {
+                glcmMeasures.push_back((rsgis::filter::RSGISGLCMMeasure)(*iterMeasure));
+            }
+            rsgis::filter::RSGISGLCMTextures glcmTextures(numLevels, winSize, glcmMeasures, xOffset, yOffset);
+            
+            std::cout << "Open " << inputImage << std::endl;
+            GDALDataset *dataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_ReadOnly);
+            if(dataset == NULL)
+            {
+                std::string message = std::string("Could not open image ") + inputImage;
+                throw rsgis::RSGISImageException(message.c_str());
+            }
+            
+            // Pixels with the band's no data value are not counted in the co-occurrences.
+            int noDataValAvail = false;
+            double noDataVal = 0.0;
+            if((band > 0) && (((int)band) <= dataset->GetRasterCount()))
+            {
+                noDataVal = dataset->GetRasterBand(band)->GetNoDataValue(&noDataValAvail);
+            }
+            
+            try
+            {
+                glcmTextures.calcTextures(dataset, band, outputImage, imageFormat, RSGIS_to_GDAL_Type(outDataType), minVal, maxVal, noDataValAvail, noDataVal);
+            }
+            catch(rsgis::RSGISException &e)
+            {
+                GDALClose(dataset);
+                throw;
+            }
+            
+            GDALClose(dataset);
+        }
+        catch(rsgis::RSGISException &e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+        catch(std::exception &e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+    }
+    
 }}
@@ -65,6 +65,22 @@ namespace rsgis{ namespace cmds {
     /** Function to set up LeuncMalik Filter Band */
     DllExport std::vector<rsgis::cmds::RSGISFilterParameters*> *createLeungMalikFilterBank();
     
+    enum RSGISGLCMMeasureType
+    {
+        rsgis_glcm_contrast = 0,
+        rsgis_glcm_dissimilarity = 1,
+        rsgis_glcm_homogeneity = 2,
+        rsgis_glcm_asm = 3,
+        rsgis_glcm_energy = 4,
+        rsgis_glcm_entropy = 5,
+        rsgis_glcm_mean = 6,
+        rsgis_glcm_variance = 7,
+        rsgis_glcm_correlation = 8
+    };
+    
+    /** Function to calculate GLCM (Haralick) texture measures of an image band, with one output band per measure */
+    DllExport void executeGLCMTextures(std::string inputImage, unsigned int band, std::string outputImage, std::vector<RSGISGLCMMeasureType> measures, unsigned int numLevels, unsigned int winSize, int xOffset, int yOffset, double minVal, double maxVal, std::string imageFormat, RSGISLibDataType outDataType);
+    
 }}
 
 
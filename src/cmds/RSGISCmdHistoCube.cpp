@@ -83,7 +83,7 @@ namespace rsgis{ namespace cmds {
         }
     }
     
-    void executePopulateSingleHistoCubeLayer(std::string histCubeFile, std::string layerName, std::string clumpsImg, std::string valsImg, unsigned int imgBand, bool inMem)
+    void executePopulateSingleHistoCubeLayer(std::string histCubeFile, std::string layerName, std::string clumpsImg, std::string valsImg, unsigned int imgBand, bool inMem, double maxMemMB)
     {
         GDALAllRegister();
         try
@@ -94,7 +94,7 @@ namespace rsgis{ namespace cmds {
             }
             
             rsgis::histocube::RSGISHistoCubeFile histoCubeFileObj = rsgis::histocube::RSGISHistoCubeFile();
-            histoCubeFileObj.openFile(histCubeFile, true);
+            histoCubeFileObj.openFile(histCubeFile, true, rsgis::histocube::hcRowAccess);
             
             std::vector<rsgis::histocube::RSGISHistCubeLayerMeta*> *cubeLayers = histoCubeFileObj.getCubeLayersList();
             rsgis::histocube::RSGISHistCubeLayerMeta *cubeLayer = NULL;
@@ -147,25 +147,28 @@ namespace rsgis{ namespace cmds {
             unsigned int bandIdx = imgBand-1;
             unsigned int maxRow = histoCubeFileObj.getNumFeatures()-1;
             
-            if(inMem)
+            // Hold the whole layer in memory if requested or if it fits within the memory limit.
+            double layerMB = (((double)maxRow)+1) * cubeLayer->bins.size() * sizeof(unsigned int) / (1024.0 * 1024.0);
+            if(inMem || (layerMB <= maxMemMB))
             {
                 unsigned int nBins = cubeLayer->bins.size();
                 unsigned long dataArrLen = (maxRow*nBins)+nBins;
                 unsigned int *dataArr = new unsigned int[dataArrLen];
-                histoCubeFileObj.getHistoRows(layerName, 0, maxRow, dataArr, dataArrLen);
+                histoCubeFileObj.getHistoRows(layerName, 0, maxRow+1, dataArr, dataArrLen);
                 
                 rsgis::histocube::RSGISPopHistoCubeLayerFromImgBandInMem popCubeLyrMem = rsgis::histocube::RSGISPopHistoCubeLayerFromImgBandInMem(dataArr, dataArrLen, bandIdx, maxRow, cubeLayer->scale, cubeLayer->offset, cubeLayer->bins);
                 rsgis::img::RSGISCalcImage calcImgPopCubeMem = rsgis::img::RSGISCalcImage(&popCubeLyrMem);
                 calcImgPopCubeMem.calcImage(datasets, 1, 1);
                 
-                histoCubeFileObj.setHistoRows(layerName, 0, maxRow, dataArr, dataArrLen);
+                histoCubeFileObj.setHistoRows(layerName, 0, maxRow+1, dataArr, dataArrLen);
                 delete[] dataArr;
             }
             else
             {
-                rsgis::histocube::RSGISPopHistoCubeLayerFromImgBand popCubeLyr = rsgis::histocube::RSGISPopHistoCubeLayerFromImgBand(&histoCubeFileObj, layerName, bandIdx, maxRow, cubeLayer->scale, cubeLayer->offset, cubeLayer->bins);
+                rsgis::histocube::RSGISPopHistoCubeLayerFromImgBand popCubeLyr = rsgis::histocube::RSGISPopHistoCubeLayerFromImgBand(&histoCubeFileObj, layerName, bandIdx, maxRow, cubeLayer->scale, cubeLayer->offset, cubeLayer->bins, maxMemMB);
                 rsgis::img::RSGISCalcImage calcImgPopCube = rsgis::img::RSGISCalcImage(&popCubeLyr);
                 calcImgPopCube.calcImage(datasets, 1, 1);
+                popCubeLyr.flushHistoRows();
             }
             histoCubeFileObj.closeFile();
             GDALClose(datasets[0]);
@@ -182,13 +185,100 @@ namespace rsgis{ namespace cmds {
         }
     }
     
+    void executePopulateHistoCubeLayers(std::string histCubeFile, std::vector<std::string> layerNames, std::string clumpsImg, std::vector<std::string> valsImgs, std::vector<unsigned int> imgBands, double maxMemMB)
+    {
+        GDALAllRegister();
+        std::map<std::string, GDALDataset*> valsDatasets;
+        GDALDataset *clumpsDataset = NULL;
+        try
+        {
+            if((layerNames.size() != valsImgs.size()) || (layerNames.size() != imgBands.size()))
+            {
+                throw rsgis::RSGISHistoCubeException("The same number of layer names, images and bands must be provided.");
+            }
+            
+            clumpsDataset = (GDALDataset *) GDALOpen(clumpsImg.c_str(), GA_ReadOnly);
+            if(clumpsDataset == NULL)
+            {
+                std::string message = std::string("Could not open image ") + clumpsImg;
+                throw rsgis::RSGISImageException(message.c_str());
+            }
+            if(clumpsDataset->GetRasterCount() != 1)
+            {
+                throw rsgis::RSGISImageException("The clumps image must only have 1 image band.");
+            }
+            
+            // Each image is only opened once, even if it provides several layers.
+            std::vector<rsgis::histocube::RSGISHistoCubeLayerImgBand> layers;
+            for(size_t i = 0; i < layerNames.size(); ++i)
+            {
+                if(valsDatasets.count(valsImgs.at(i)) == 0)
+                {
+                    GDALDataset *valsDataset = (GDALDataset *) GDALOpen(valsImgs.at(i).c_str(), GA_ReadOnly);
+                    if(valsDataset == NULL)
+                    {
+                        std::string message = std::string("Could not open image ") + valsImgs.at(i);
+                        throw rsgis::RSGISImageException(message.c_str());
+                    }
+                    valsDatasets[valsImgs.at(i)] = valsDataset;
+                }
+                if((imgBands.at(i) == 0) || (imgBands.at(i) > valsDatasets[valsImgs.at(i)]->GetRasterCount()))
+                {
+                    throw rsgis::RSGISImageException("The band specified is not within the values image.");
+                }
+                rsgis::histocube::RSGISHistoCubeLayerImgBand layer;
+                layer.layerName = layerNames.at(i);
+                layer.valsDataset = valsDatasets[valsImgs.at(i)];
+                layer.bandIdx = imgBands.at(i)-1;
+                layers.push_back(layer);
+            }
+            
+            rsgis::histocube::RSGISHistoCubeFile histoCubeFileObj = rsgis::histocube::RSGISHistoCubeFile();
+            histoCubeFileObj.openFile(histCubeFile, true, rsgis::histocube::hcRowAccess);
+            
+            rsgis::histocube::RSGISPopHistoCubeLayersFromImgBands popCubeLyrs = rsgis::histocube::RSGISPopHistoCubeLayersFromImgBands(&histoCubeFileObj);
+            popCubeLyrs.populateLayers(clumpsDataset, layers, maxMemMB);
+            
+            histoCubeFileObj.closeFile();
+        }
+        catch(rsgis::RSGISImageException &e)
+        {
+            for(std::map<std::string, GDALDataset*>::iterator iterImgs = valsDatasets.begin(); iterImgs != valsDatasets.end(); ++iterImgs)
+            {
+                GDALClose(iterImgs->second);
+            }
+            if(clumpsDataset != NULL)
+            {
+                GDALClose(clumpsDataset);
+            }
+            throw RSGISCmdException(e.what());
+        }
+        catch(rsgis::RSGISHistoCubeException &e)
+        {
+            for(std::map<std::string, GDALDataset*>::iterator iterImgs = valsDatasets.begin(); iterImgs != valsDatasets.end(); ++iterImgs)
+            {
+                GDALClose(iterImgs->second);
+            }
+            if(clumpsDataset != NULL)
+            {
+                GDALClose(clumpsDataset);
+            }
+            throw RSGISCmdException(e.what());
+        }
+        for(std::map<std::string, GDALDataset*>::iterator iterImgs = valsDatasets.begin(); iterImgs != valsDatasets.end(); ++iterImgs)
+        {
+            GDALClose(iterImgs->second);
+        }
+        GDALClose(clumpsDataset);
+    }
+    
     void executeExportHistBins2Img(std::string histCubeFile, std::string layerName, std::string clumpsImg, std::string outputImg, std::string gdalFormat, std::vector<unsigned int> exportBins) 
     {
         GDALAllRegister();
         try
         {
             rsgis::histocube::RSGISHistoCubeFile histoCubeFileObj = rsgis::histocube::RSGISHistoCubeFile();
-            histoCubeFileObj.openFile(histCubeFile, true);
+            histoCubeFileObj.openFile(histCubeFile, true, rsgis::histocube::hcRowAccess);
             
             std::vector<rsgis::histocube::RSGISHistCubeLayerMeta*> *cubeLayers = histoCubeFileObj.getCubeLayersList();
             rsgis::histocube::RSGISHistCubeLayerMeta *cubeLayer = NULL;
@@ -225,7 +315,7 @@ namespace rsgis{ namespace cmds {
             unsigned int nBins = cubeLayer->bins.size();
             unsigned long dataArrLen = (maxRow*nBins)+nBins;
             unsigned int *dataArr = new unsigned int[dataArrLen];
-            histoCubeFileObj.getHistoRows(layerName, 0, maxRow, dataArr, dataArrLen);
+            histoCubeFileObj.getHistoRows(layerName, 0, maxRow+1, dataArr, dataArrLen);
             
             rsgis::histocube::RSGISExportBins2ImgBands expBins2Img = rsgis::histocube::RSGISExportBins2ImgBands(exportBins.size(), dataArr, dataArrLen, nBins, exportBins);
             rsgis::img::RSGISCalcImage calcImg = rsgis::img::RSGISCalcImage(&expBins2Img);
@@ -319,7 +409,7 @@ namespace rsgis{ namespace cmds {
             }
             
             rsgis::histocube::RSGISHistoCubeFile histoCubeFileObj = rsgis::histocube::RSGISHistoCubeFile();
-            histoCubeFileObj.openFile(histCubeFile, true);
+            histoCubeFileObj.openFile(histCubeFile, true, rsgis::histocube::hcRowAccess);
             
             std::vector<rsgis::histocube::RSGISHistCubeLayerMeta*> *cubeLayers = histoCubeFileObj.getCubeLayersList();
             rsgis::histocube::RSGISHistCubeLayerMeta *cubeLayer = NULL;
@@ -356,7 +446,7 @@ namespace rsgis{ namespace cmds {
             unsigned int nBins = cubeLayer->bins.size();
             unsigned long dataArrLen = (maxRow*nBins)+nBins;
             unsigned int *dataArr = new unsigned int[dataArrLen];
-            histoCubeFileObj.getHistoRows(layerName, 0, maxRow, dataArr, dataArrLen);
+            histoCubeFileObj.getHistoRows(layerName, 0, maxRow+1, dataArr, dataArrLen);
             
             std::cout << "Scale = " << cubeLayer->scale << std::endl;
             std::cout << "Offset = " << cubeLayer->offset << std::endl;
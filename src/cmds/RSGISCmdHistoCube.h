@@ -65,8 +65,13 @@ namespace rsgis{ namespace cmds {
     /** A function to create a zero'd histocube layer */
     DllExport void executeCreateHistoCubeLayer(std::string histCubeFile, std::string layerName, int lowBin, int upBin, float scale, float offset, bool hasDateTime, std::string dataTime);
     
-    /** A function to populate a single histogram layer from multiple input files */
-    DllExport void executePopulateSingleHistoCubeLayer(std::string histCubeFile, std::string layerName, std::string clumpsImg, std::string valsImg, unsigned int imgBand, bool inMem);
+    /** A function to populate a single histogram layer from multiple input files.
+        The layer is held in memory if inMem is true or it fits within maxMemMB, otherwise
+        the bin counts are buffered in maxMemMB and written back in runs of rows. */
+    DllExport void executePopulateSingleHistoCubeLayer(std::string histCubeFile, std::string layerName, std::string clumpsImg, std::string valsImg, unsigned int imgBand, bool inMem, double maxMemMB=1024);
+    
+    /** A function to populate several layers (e.g., a time series) in a single pass through the clumps image, imgBands start at 1 */
+    DllExport void executePopulateHistoCubeLayers(std::string histCubeFile, std::vector<std::string> layerNames, std::string clumpsImg, std::vector<std::string> valsImgs, std::vector<unsigned int> imgBands, double maxMemMB=1024);
     
     /** A function to export histogram columns as a multi-band image dataset */
     DllExport void executeExportHistBins2Img(std::string histCubeFile, std::string layerName, std::string clumpsImg, std::string outputImg, std::string gdalFormat, std::vector<unsigned int> exportBins);
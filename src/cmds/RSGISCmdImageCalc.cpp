@@ -22,6 +22,7 @@
 
 #include "RSGISCmdImageCalc.h"
 #include "RSGISCmdParent.h"
+#include "common/RSGISProfiler.h"
 
 #include "common/RSGISImageException.h"
 
@@ -30,12 +31,17 @@
 #include "img/RSGISImageCalcException.h"
 #include "img/RSGISCalcImageValue.h"
 #include "img/RSGISCalcImage.h"
+#include "img/RSGISCalcImageValueChain.h"
+#include "img/RSGISMaskImage.h"
+#include "img/RSGISStretchImage.h"
+#include "img/RSGISImagePipeline.h"
 #include "img/RSGISImageClustering.h"
 #include "img/RSGISImageWindowStats.h"
 #include "img/RSGISImageStatistics.h"
 #include "img/RSGISCalcCovariance.h"
 #include "img/RSGISCalcEditImage.h"
 #include "img/RSGISCalcDist2Geom.h"
+#include "img/RSGISEuclideanDistTransform.h"
 #include "img/RSGISCalcCorrelationCoefficient.h"
 #include "img/RSGISMeanVector.h"
 #include "img/RSGISCalcImageMatrix.h"
@@ -43,6 +49,7 @@
 #include "img/RSGISImageNormalisation.h"
 #include "img/RSGISStandardiseImage.h"
 #include "img/RSGISApplyEigenvectors.h"
+#include "img/RSGISImagePCA.h"
 #include "img/RSGISReplaceValuesLessThanGivenValue.h"
 #include "img/RSGISConvertSpectralToUnitArea.h"
 #include "img/RSGISCalculateImageMovementSpeed.h"
@@ -76,10 +83,14 @@
 
 #include "muParser.h"
 
+#include <map>
+#include <algorithm>
+
 namespace rsgis{ namespace cmds {
 
     void executeBandMaths(VariableStruct *variables, unsigned int numVars, std::string outputImage, std::string mathsExpression, std::string gdalFormat, RSGISLibDataType outDataType, bool useExpAsbandName, bool editOutputImg)
     {
+        rsgis::RSGISProfileSummaryScope profileSummary("executeBandMaths");
         GDALAllRegister();
         GDALDataset **datasets = NULL;
         GDALDataset *outDataset = NULL;
@@ -243,8 +254,292 @@ namespace rsgis{ namespace cmds {
         }
     }
 
+    void executeBandMathsMaskStretch(VariableStruct *variables, unsigned int numVars, std::string imageMask, std::vector<float> maskValues, float maskOutValue, double inMin, double inMax, double outMin, double outMax, std::string outputImage, std::string mathsExpression, std::string gdalFormat, RSGISLibDataType outDataType)
+    {
+        rsgis::RSGISProfileSummaryScope profileSummary("executeBandMathsMaskStretch");
+        GDALAllRegister();
+        try
+        {
+            std::list<std::string> file_names = std::list<std::string>();
+            for(int i = 0; i < numVars; ++i)
+            {
+                variables[i].defined = false;
+                file_names.push_back(variables[i].image);
+            }
+            file_names.sort();
+            file_names.unique();
+            
+            // The mask is the last image so its band follows those of the band maths inputs.
+            int total_n_imgs = file_names.size() + 1;
+            GDALDataset **datasets = new GDALDataset*[total_n_imgs];
+            for(int i = 0; i < total_n_imgs; ++i)
+            {
+                datasets[i] = NULL;
+            }
+            std::vector<rsgis::img::VariableBands*> processVaribles(numVars, NULL);
+            mu::Parser *muParser = new mu::Parser();
+            std::vector<mu::value_type> inVals(numVars, 0);
+            rsgis::img::RSGISBandMath *bandmaths = NULL;
+            
+            double *stretchInMin = new double[1];
+            double *stretchInMax = new double[1];
+            double *stretchOutMin = new double[1];
+            double *stretchOutMax = new double[1];
+            stretchInMin[0] = inMin;
+            stretchInMax[0] = inMax;
+            stretchOutMin[0] = outMin;
+            stretchOutMax[0] = outMax;
+            
+            try
+            {
+                int totalNumRasterBands = 0;
+                int n_img = 0;
+                for(std::list<std::string>::iterator iter_filenames = file_names.begin(); iter_filenames != file_names.end(); ++iter_filenames)
+                {
+                    datasets[n_img] = (GDALDataset *) GDALOpen((*iter_filenames).c_str(), GA_ReadOnly);
+                    if(datasets[n_img] == NULL)
+                    {
+                        std::string message = std::string("Could not open image ") + (*iter_filenames);
+                        throw rsgis::RSGISImageException(message.c_str());
+                    }
+                    int numRasterBands = datasets[n_img]->GetRasterCount();
+                    for(int i = 0; i < numVars; ++i)
+                    {
+                        if((variables[i].image == (*iter_filenames)) & !variables[i].defined)
+                        {
+                            if((variables[i].bandNum < 1) | (variables[i].bandNum > numRasterBands))
+                            {
+                                std::string message = std::string("You have specified a band for variable ") + variables[i].name + std::string("' which is not within the image ") + variables[i].image;
+                                throw rsgis::RSGISImageException(message);
+                            }
+                            processVaribles[i] = new rsgis::img::VariableBands();
+                            processVaribles[i]->name = variables[i].name;
+                            processVaribles[i]->band = totalNumRasterBands + (variables[i].bandNum - 1);
+                            variables[i].defined = true;
+                        }
+                    }
+                    totalNumRasterBands += numRasterBands;
+                    ++n_img;
+                }
+                
+                for(int i = 0; i < numVars; ++i)
+                {
+                    if(!variables[i].defined)
+                    {
+                        std::string message = std::string("Specified variable is not defined for variable '") + variables[i].name + std::string("' within image ") + variables[i].image;
+                        throw rsgis::RSGISImageException(message.c_str());
+                    }
+                }
+                
+                datasets[n_img] = (GDALDataset *) GDALOpen(imageMask.c_str(), GA_ReadOnly);
+                if(datasets[n_img] == NULL)
+                {
+                    std::string message = std::string("Could not open image ") + imageMask;
+                    throw rsgis::RSGISImageException(message.c_str());
+                }
+                
+                for(int i = 0; i < numVars; ++i)
+                {
+                    muParser->DefineVar(_T(processVaribles[i]->name.c_str()), &inVals[i]);
+                }
+                muParser->SetExpr(mathsExpression.c_str());
+                bandmaths = new rsgis::img::RSGISBandMath(1, processVaribles.data(), numVars, muParser);
+                
+                // Band maths, then the mask (band 1 of the mask image with the band maths
+                // output), then the stretch, evaluated together on each block so the
+                // intermediate images are never written.
+                rsgis::img::RSGISApplyImageMask applyMask(1, maskOutValue, maskValues);
+                rsgis::img::RSGISLinearStretchImage linStretch(1, stretchInMax, stretchInMin, stretchOutMax, stretchOutMin, true, maskOutValue, maskOutValue);
+                rsgis::img::RSGISCalcImageValueChain calcChain;
+                calcChain.addStage(bandmaths);
+                std::vector<rsgis::img::RSGISCalcChainBand> maskInBands;
+                maskInBands.push_back(rsgis::img::RSGISCalcChainBand(-1, totalNumRasterBands));
+                maskInBands.push_back(rsgis::img::RSGISCalcChainBand(0, 0));
+                calcChain.addStage(&applyMask, maskInBands);
+                calcChain.addStage(&linStretch);
+                
+                rsgis::img::RSGISCalcImage calcImage(&calcChain, "", true);
+                calcImage.calcImage(datasets, total_n_imgs, outputImage, false, NULL, gdalFormat, RSGIS_to_GDAL_Type(outDataType));
+            }
+            catch(...)
+            {
+                for(int i = 0; i < total_n_imgs; ++i)
+                {
+                    if(datasets[i] != NULL)
+                    {
+                        GDALClose(datasets[i]);
+                    }
+                }
+                delete[] datasets;
+                for(int i = 0; i < numVars; ++i)
+                {
+                    delete processVaribles[i];
+                }
+                delete bandmaths;
+                delete muParser;
+                delete[] stretchInMin;
+                delete[] stretchInMax;
+                delete[] stretchOutMin;
+                delete[] stretchOutMax;
+                throw;
+            }
+            
+            for(int i = 0; i < total_n_imgs; ++i)
+            {
+                GDALClose(datasets[i]);
+            }
+            delete[] datasets;
+            for(int i = 0; i < numVars; ++i)
+            {
+                delete processVaribles[i];
+            }
+            delete bandmaths;
+            delete muParser;
+            delete[] stretchInMin;
+            delete[] stretchInMax;
+            delete[] stretchOutMin;
+            delete[] stretchOutMax;
+        }
+        catch(rsgis::RSGISException &e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+        catch (mu::ParserError &e)
+        {
+            std::string message = std::string("ERROR: ") + std::string(e.GetMsg()) + std::string(":\t \'") + std::string(e.GetExpr()) + std::string("\'");
+            throw RSGISCmdException(message);
+        }
+        catch (std::exception &e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+    }
+
+    void executeBandMathsPipeline(std::vector<std::pair<std::string, std::string> > inputImages, std::vector<BandMathsPipelineStep> steps, std::string gdalFormat, RSGISLibDataType outDataType, std::string tempDIR)
+    {
+        rsgis::RSGISProfileSummaryScope profileSummary("executeBandMathsPipeline");
+        GDALAllRegister();
+        // The band maths calculators (and their parsers and variables) need to
+        // outlive the pipeline, which does not take ownership of them.
+        std::vector<std::vector<rsgis::img::VariableBands> > stepVars(steps.size());
+        std::vector<std::vector<rsgis::img::VariableBands*> > stepVarPtrs(steps.size());
+        std::vector<std::vector<mu::value_type> > stepInVals(steps.size());
+        std::vector<mu::Parser*> parsers(steps.size(), NULL);
+        std::vector<rsgis::img::RSGISBandMath*> bandMaths(steps.size(), NULL);
+        try
+        {
+            rsgis::img::RSGISImagePipeline pipeline;
+            if(tempDIR != "")
+            {
+                pipeline.setTempDIR(tempDIR);
+            }
+            
+            // The number of bands of each dataset, so the variables can be
+            // mapped to the bands of the inputs of their step.
+            std::map<std::string, int> numDSBands;
+            for(std::vector<std::pair<std::string, std::string> >::iterator iterInput = inputImages.begin(); iterInput != inputImages.end(); ++iterInput)
+            {
+                GDALDataset *dataset = (GDALDataset *) GDALOpen(iterInput->second.c_str(), GA_ReadOnly);
+                if(dataset == NULL)
+                {
+                    std::string message = std::string("Could not open image ") + iterInput->second;
+                    throw rsgis::RSGISImageException(message.c_str());
+                }
+                numDSBands[iterInput->first] = dataset->GetRasterCount();
+                GDALClose(dataset);
+                pipeline.addInput(iterInput->first, iterInput->second);
+            }
+            
+            for(size_t s = 0; s < steps.size(); ++s)
+            {
+                // The inputs of the step are the datasets of its variables, in
+                // the order they are first used.
+                std::vector<std::string> stepInputs;
+                std::vector<int> stepInputOffs;
+                int numStepBands = 0;
+                for(std::vector<VariableStruct>::iterator iterVar = steps[s].variables.begin(); iterVar != steps[s].variables.end(); ++iterVar)
+                {
+                    if(numDSBands.count(iterVar->image) == 0)
+                    {
+                        std::string message = std::string("Variable '") + iterVar->name + std::string("' of step '") + steps[s].name + std::string("' refers to '") + iterVar->image + std::string("' which is not an input or an earlier step.");
+                        throw rsgis::RSGISImageException(message);
+                    }
+                    if(std::find(stepInputs.begin(), stepInputs.end(), iterVar->image) == stepInputs.end())
+                    {
+                        stepInputs.push_back(iterVar->image);
+                        stepInputOffs.push_back(numStepBands);
+                        numStepBands += numDSBands[iterVar->image];
+                    }
+                }
+                
+                stepVars[s].resize(steps[s].variables.size());
+                stepInVals[s].resize(steps[s].variables.size(), 0);
+                parsers[s] = new mu::Parser();
+                for(size_t i = 0; i < steps[s].variables.size(); ++i)
+                {
+                    VariableStruct &var = steps[s].variables[i];
+                    if((var.bandNum < 1) | (var.bandNum > numDSBands[var.image]))
+                    {
+                        std::string message = std::string("You have specified a band for variable ") + var.name + std::string("' which is not within ") + var.image;
+                        throw rsgis::RSGISImageException(message);
+                    }
+                    size_t inIdx = std::find(stepInputs.begin(), stepInputs.end(), var.image) - stepInputs.begin();
+                    stepVars[s][i].name = var.name;
+                    stepVars[s][i].band = stepInputOffs[inIdx] + (var.bandNum - 1);
+                    stepVarPtrs[s].push_back(&stepVars[s][i]);
+                    parsers[s]->DefineVar(_T(var.name.c_str()), &stepInVals[s][i]);
+                }
+                parsers[s]->SetExpr(steps[s].mathsExpression.c_str());
+                bandMaths[s] = new rsgis::img::RSGISBandMath(1, stepVarPtrs[s].data(), stepVarPtrs[s].size(), parsers[s]);
+                
+                pipeline.addCalcStep(steps[s].name, bandMaths[s], stepInputs);
+                numDSBands[steps[s].name] = 1;
+                if(steps[s].outputImage != "")
+                {
+                    pipeline.persist(steps[s].name, steps[s].outputImage, gdalFormat, RSGIS_to_GDAL_Type(outDataType));
+                }
+            }
+            
+            pipeline.execute();
+        }
+        catch(rsgis::RSGISException &e)
+        {
+            for(size_t s = 0; s < steps.size(); ++s)
+            {
+                delete bandMaths[s];
+                delete parsers[s];
+            }
+            throw RSGISCmdException(e.what());
+        }
+        catch (mu::ParserError &e)
+        {
+            for(size_t s = 0; s < steps.size(); ++s)
+            {
+                delete bandMaths[s];
+                delete parsers[s];
+            }
+            std::string message = std::string("ERROR: ") + std::string(e.GetMsg()) + std::string(":\t \'") + std::string(e.GetExpr()) + std::string("\'");
+            throw RSGISCmdException(message);
+        }
+        catch (std::exception &e)
+        {
+            for(size_t s = 0; s < steps.size(); ++s)
+            {
+                delete bandMaths[s];
+                delete parsers[s];
+            }
+            throw RSGISCmdException(e.what());
+        }
+        for(size_t s = 0; s < steps.size(); ++s)
+        {
+            delete bandMaths[s];
+            delete parsers[s];
+        }
+    }
+
     void executeImageMaths(std::string inputImage, std::string outputImage, std::string mathsExpression, std::string imageFormat, RSGISLibDataType outDataType, bool useExpAsbandName, bool editOutputImg)
     {
+        rsgis::RSGISProfileSummaryScope profileSummary("executeImageMaths");
         GDALAllRegister();
         GDALDataset **datasets = NULL;
         GDALDataset *outDataset = NULL;
@@ -464,7 +759,7 @@ namespace rsgis{ namespace cmds {
         }
     }
 
-    void executeKMeansClustering(std::string inputImage, std::string outputMatrixFile, unsigned int numClusters, unsigned int maxNumIterations, unsigned int subSample, bool ignoreZeros, float degreeOfChange, RSGISInitClustererMethods initClusterMethod)
+    void executeKMeansClustering(std::string inputImage, std::string outputMatrixFile, unsigned int numClusters, unsigned int maxNumIterations, unsigned int subSample, bool ignoreZeros, float degreeOfChange, RSGISInitClustererMethods initClusterMethod, unsigned int miniBatchSize)
     {
         
         std::cout << "inputImage = " << inputImage << std::endl;
@@ -473,6 +768,10 @@ namespace rsgis{ namespace cmds {
         std::cout << "maxNumIterations = " << maxNumIterations << std::endl;
         std::cout << "subSample = " << subSample << std::endl;
         std::cout << "degreeOfChange = " << degreeOfChange << std::endl;
+        if(miniBatchSize > 0)
+        {
+            std::cout << "miniBatchSize = " << miniBatchSize << std::endl;
+        }
         if(ignoreZeros)
         {
             std::cout << "Ignoring Zeros\n";
@@ -517,7 +816,7 @@ namespace rsgis{ namespace cmds {
             }
 
             rsgis::img::RSGISImageClustering imgClustering;
-            imgClustering.findKMeansCentres(dataset, outputMatrixFile, numClusters, maxNumIterations, subSample, ignoreZeros, degreeOfChange, initMethod);
+            imgClustering.findKMeansCentres(dataset, outputMatrixFile, numClusters, maxNumIterations, subSample, ignoreZeros, degreeOfChange, initMethod, miniBatchSize);
 
             GDALClose(dataset);
         }
@@ -623,6 +922,37 @@ namespace rsgis{ namespace cmds {
         }
     }
 
+    void executeLocalMahalanobisDistFilter(std::string inputImage, std::string outputImage, unsigned int winSize, std::string gdalFormat, RSGISLibDataType outDataType)
+    {
+        try
+        {
+            GDALAllRegister();
+            GDALDataset **datasets = new GDALDataset*[1];
+
+            datasets[0] = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_ReadOnly);
+            if(datasets[0] == NULL)
+            {
+                std::string message = std::string("Could not open image ") + inputImage;
+                throw rsgis::RSGISImageException(message.c_str());
+            }
+
+            rsgis::img::RSGISCalcLocalMahalanobisDist calcLocalDist(datasets[0]->GetRasterCount());
+            rsgis::img::RSGISCalcImage calcImage(&calcLocalDist, "", true);
+            calcImage.calcImageWindowData(datasets, 1, outputImage, winSize, gdalFormat, RSGIS_to_GDAL_Type(outDataType));
+
+            GDALClose(datasets[0]);
+            delete[] datasets;
+        }
+        catch(rsgis::RSGISException &e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+        catch(std::exception &e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+    }
+
     void executeMahalanobisDist2ImgFilter(std::string inputImage, std::string outputImage, unsigned int winSize, std::string gdalFormat, RSGISLibDataType outDataType)
     {
         try
@@ -733,29 +1063,13 @@ namespace rsgis{ namespace cmds {
             // Create blank image
             rsgis::img::RSGISImageUtils imageUtils;
             GDALDataset *outImage = imageUtils.createCopy(imgDataset, 1, outputImage, gdalFormat, GDT_Float32);
-            imageUtils.copyFloatGDALDataset(imgDataset, outImage);
 
             double *transform = new double[6];
             outImage->GetGeoTransform(transform);
 
-            rsgis::img::RSGISCalcDistViaIterativeGrowth *calcDist = new rsgis::img::RSGISCalcDistViaIterativeGrowth(transform[1]);
-            rsgis::img::RSGISCalcEditImage *calcEditImage = new rsgis::img::RSGISCalcEditImage(calcDist);
-
-            bool change = true;
-            unsigned int dist = 1;
-            while(change)
-            {
-                std::cout << "Distance " << dist << ":\t" << std::flush;
-                calcDist->resetChange();
-                calcEditImage->calcImageWindowData(outImage, 3, -2);
-                change = calcDist->changeOccurred();
-                calcDist->incrementCounter();
-                dist += 1;
-            }
-
-            // Translate to distance...
-            std::cout << "Multiple by pixel size\n";
-            calcEditImage->calcImageUseOut(outImage);
+            // The pixels with the value -1 are given the distance to the nearest other pixel.
+            rsgis::img::RSGISEuclideanDistTransform calcDist;
+            calcDist.calcDistance(imgDataset, 1, -1, outImage, fabs(transform[1]), fabs(transform[5]));
 
             // Clean up memory.
             GDALClose(outImage);
@@ -881,6 +1195,37 @@ namespace rsgis{ namespace cmds {
         }
     }
 
+    static std::vector<float> readPixelFitXValues(std::string bandValues, GDALDataset *imgDataset)
+    {
+        rsgis::utils::RSGISTextUtils textUtils;
+        std::vector<std::string> strValues = textUtils.readFileToStringVector(bandValues);
+        std::vector<float> bandXValues;
+        for(std::vector<std::string>::iterator iterStrVals = strValues.begin(); iterStrVals != strValues.end(); ++iterStrVals)
+        {
+            if((*iterStrVals) != "")
+            {
+                try
+                {
+                    bandXValues.push_back(textUtils.strtofloat(*iterStrVals));
+                }
+                catch (rsgis::RSGISException &e)
+                {
+                    // ignore.
+                    std::cout << "Warning \'" << *iterStrVals << "\' could not be converted to an float.\n";
+                }
+            }
+        }
+
+        if(bandXValues.size() != imgDataset->GetRasterCount())
+        {
+            std::cout << "bandXValues.size() = " << bandXValues.size() << std::endl;
+            std::cout << "imgDataset->GetRasterCount() = " << imgDataset->GetRasterCount() << std::endl;
+            GDALClose(imgDataset);
+            throw RSGISException("The number of image bands and x values are not the same.");
+        }
+        return bandXValues;
+    }
+
     void executeImagePixelLinearFit(std::string inputImage, std::string outputImage, std::string gdalFormat, std::string bandValues, float noDataValue, bool useNoDataValue)
     {
         try
@@ -893,32 +1238,7 @@ namespace rsgis{ namespace cmds {
                 throw rsgis::RSGISImageException(message.c_str());
             }
 
-            rsgis::utils::RSGISTextUtils textUtils;
-            std::vector<std::string> strValues = textUtils.readFileToStringVector(bandValues);
-            std::vector<float> bandXValues;
-            for(std::vector<std::string>::iterator iterStrVals = strValues.begin(); iterStrVals != strValues.end(); ++iterStrVals)
-            {
-                if((*iterStrVals) != "")
-                {
-                    try
-                    {
-                        bandXValues.push_back(textUtils.strtofloat(*iterStrVals));
-                    }
-                    catch (rsgis::RSGISException &e)
-                    {
-                        // ignore.
-                        std::cout << "Warning \'" << *iterStrVals << "\' could not be converted to an float.\n";
-                    }
-                }
-            }
-
-            if(bandXValues.size() != imgDataset->GetRasterCount())
-            {
-                std::cout << "bandXValues.size() = " << bandXValues.size() << std::endl;
-                std::cout << "imgDataset->GetRasterCount() = " << imgDataset->GetRasterCount() << std::endl;
-                GDALClose(imgDataset);
-                throw RSGISException("The number of image bands and x values are not the same.");
-            }
+            std::vector<float> bandXValues = readPixelFitXValues(bandValues, imgDataset);
 
             std::string *bandNames = new std::string[3];
             bandNames[0] = "Intercept";
@@ -946,6 +1266,72 @@ namespace rsgis{ namespace cmds {
         }
     }
 
+    void executeImagePixelModelFit(std::string inputImage, std::string outputImage, std::string gdalFormat, std::string bandValues, bool harmonic, unsigned int numTerms, float period, float noDataValue, bool useNoDataValue)
+    {
+        try
+        {
+            GDALAllRegister();
+            GDALDataset *imgDataset = (GDALDataset *) GDALOpenShared(inputImage.c_str(), GA_ReadOnly);
+            if(imgDataset == NULL)
+            {
+                std::string message = std::string("Could not open image ") + inputImage;
+                throw rsgis::RSGISImageException(message.c_str());
+            }
+
+            std::vector<float> bandXValues = readPixelFitXValues(bandValues, imgDataset);
+
+            rsgis::img::RSGISLinearModelType modelType = harmonic?rsgis::img::rsgis_linmodel_harmonic:rsgis::img::rsgis_linmodel_polynomial;
+            rsgis::img::RSGISLinearModelFit2Pxls modelFit(bandXValues, modelType, numTerms, period, noDataValue, useNoDataValue);
+
+            std::vector<std::string> bandNames = modelFit.getOutBandNames();
+            rsgis::img::RSGISCalcImage calcImage = rsgis::img::RSGISCalcImage(&modelFit, "", true);
+            calcImage.calcImage(&imgDataset, 1, outputImage, true, &bandNames[0], gdalFormat, GDT_Float32);
+
+            GDALClose(imgDataset);
+        }
+        catch(rsgis::RSGISException &e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+        catch(std::exception &e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+    }
+
+    void executeImagePixelRobustModelFit(std::string inputImage, std::string outputImage, std::string gdalFormat, std::string bandValues, bool harmonic, unsigned int numTerms, float period, unsigned int maxIters, float tuning, float outlierThreshold, bool outputOutliers, float noDataValue, bool useNoDataValue)
+    {
+        try
+        {
+            GDALAllRegister();
+            GDALDataset *imgDataset = (GDALDataset *) GDALOpenShared(inputImage.c_str(), GA_ReadOnly);
+            if(imgDataset == NULL)
+            {
+                std::string message = std::string("Could not open image ") + inputImage;
+                throw rsgis::RSGISImageException(message.c_str());
+            }
+
+            std::vector<float> bandXValues = readPixelFitXValues(bandValues, imgDataset);
+
+            rsgis::img::RSGISLinearModelType modelType = harmonic?rsgis::img::rsgis_linmodel_harmonic:rsgis::img::rsgis_linmodel_polynomial;
+            rsgis::img::RSGISRobustModelFit2Pxls modelFit(bandXValues, modelType, numTerms, period, maxIters, tuning, outlierThreshold, outputOutliers, noDataValue, useNoDataValue);
+
+            std::vector<std::string> bandNames = modelFit.getOutBandNames();
+            rsgis::img::RSGISCalcImage calcImage = rsgis::img::RSGISCalcImage(&modelFit, "", true);
+            calcImage.calcImage(&imgDataset, 1, outputImage, true, &bandNames[0], gdalFormat, GDT_Float32);
+
+            GDALClose(imgDataset);
+        }
+        catch(rsgis::RSGISException &e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+        catch(std::exception &e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+    }
+
     void executeNormalisation(std::vector<std::string> inputImages, std::vector<std::string> outputImages, bool calcInMinMax, double inMin, double inMax, double outMin, double outMax)
     {
         GDALAllRegister();
@@ -1353,6 +1739,50 @@ namespace rsgis{ namespace cmds {
         delete [] datasets;
     }
 
+    std::vector<double> executeImagePCA(std::string inputImage, std::string outputImage, std::string outEigenvectors, unsigned int numComponents, std::string gdalFormat, RSGISLibDataType outDataType, bool useNoData, float noDataVal, bool randomised)
+    {
+        GDALAllRegister();
+        GDALDataset *dataset = NULL;
+        std::vector<double> varExplained;
+        try
+        {
+            dataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_ReadOnly);
+            if(dataset == NULL)
+            {
+                std::string message = std::string("Could not open image ") + inputImage;
+                throw rsgis::RSGISImageException(message.c_str());
+            }
+
+            rsgis::img::RSGISImagePCA imgPCA(randomised);
+            imgPCA.calcComponents(dataset, numComponents, useNoData, noDataVal);
+            for(unsigned int i = 0; i < imgPCA.getNumComponents(); ++i)
+            {
+                varExplained.push_back(imgPCA.getVarianceExplained(i));
+            }
+
+            if(outEigenvectors != "")
+            {
+                rsgis::math::RSGISMatrices matrixUtils;
+                rsgis::math::Matrix *eigenvectors = imgPCA.getEigenvectors();
+                matrixUtils.saveMatrix2txt(eigenvectors, outEigenvectors);
+                matrixUtils.freeMatrix(eigenvectors);
+            }
+
+            imgPCA.applyComponents(dataset, outputImage, gdalFormat, RSGIS_to_GDAL_Type(outDataType));
+
+            GDALClose(dataset);
+        }
+        catch(rsgis::RSGISException &e)
+        {
+            if(dataset != NULL)
+            {
+                GDALClose(dataset);
+            }
+            throw RSGISCmdException(e.what());
+        }
+        return varExplained;
+    }
+
     void executeStandardise(std::string meanvectorStr, std::string inputImage, std::string outputImage)
     {
         GDALAllRegister();
@@ -2209,7 +2639,7 @@ namespace rsgis{ namespace cmds {
         return bins;
     }
 
-    std::vector<double> executeBandPercentile(std::string inputImage, float percentile, float noDataValue, bool noDataValueSpecified)
+    std::vector<double> executeBandPercentile(std::string inputImage, float percentile, float noDataValue, bool noDataValueSpecified, float maxError)
     {
         std::vector<double> outVals;
         try
@@ -2229,6 +2659,7 @@ namespace rsgis{ namespace cmds {
 
             rsgis::math::RSGISMatrices matrixUtils;
             rsgis::img::RSGISImagePercentiles calcPercentiles;
+            calcPercentiles.setMaxError(maxError);
 
             rsgis::math::Matrix *bandPercentiles = calcPercentiles.getPercentilesForAllBands(imageDataset, percentile, noDataValue, noDataValueSpecified);
             
@@ -3393,10 +3824,15 @@ namespace rsgis{ namespace cmds {
             
             GDALDataType gdalDataType = dataset->GetRasterBand(1)->GetRasterDataType();
             
-            rsgis::img::RSGISCalcLocalMinInWin calcLclWinMin = rsgis::img::RSGISCalcLocalMinInWin(bands, noDataValue, useNoDataValue);
-            rsgis::img::RSGISCalcImage calcImage = rsgis::img::RSGISCalcImage(&calcLclWinMin, "", true);
-            calcImage.calcImageWindowData(&dataset, 1, outputImg, outputRefImg, winSize, gdalFormat, gdalDataType);
+            rsgis::img::RSGISImageUtils imageUtils;
+            GDALDataset *outDataset = imageUtils.createCopy(dataset, 1, outputImg, gdalFormat, gdalDataType);
+            GDALDataset *outRefDataset = imageUtils.createCopy(dataset, 1, outputRefImg, gdalFormat, GDT_UInt32);
+            
+            rsgis::img::RSGISLocalMinInWinFilter lclWinMinFilter = rsgis::img::RSGISLocalMinInWinFilter(bands, noDataValue, useNoDataValue);
+            lclWinMinFilter.calcLocalMinInWin(dataset, winSize, outDataset, outRefDataset);
             
+            GDALClose(outDataset);
+            GDALClose(outRefDataset);
             GDALClose(dataset);
         }
         catch(rsgis::RSGISImageException &e)
@@ -3464,6 +3900,135 @@ namespace rsgis{ namespace cmds {
         }
         return outImgVal;
     }
+    
+    /** Passes the blocks from RSGISCalcImage to a RSGISCmdImageBlockFunction */
+    class RSGISCmdCalcImageBlockFunction : public rsgis::img::RSGISCalcImageValue
+    {
+    public:
+        RSGISCmdCalcImageBlockFunction(int numOutBands, unsigned int width, RSGISCmdImageBlockFunction *blockFunc) : rsgis::img::RSGISCalcImageValue(numOutBands)
+        {
+            this->width = width;
+            this->blockFunc = blockFunc;
+        };
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+        {
+            try
+            {
+                this->blockFunc->calcBlock(bandPlanes, numBands, outPlanes, this->numOutBands, this->width, nPxls/this->width);
+            }
+            catch(RSGISCmdException &e)
+            {
+                throw rsgis::img::RSGISImageCalcException(e.what());
+            }
+        };
+        void calcImageValue(float *bandValues, int numBands, double *output)
+        {
+            throw rsgis::img::RSGISImageCalcException("Only whole blocks can be given to the block function.");
+        };
+        bool useWholeBlocks(){return true;};
+        ~RSGISCmdCalcImageBlockFunction(){};
+    protected:
+        unsigned int width;
+        RSGISCmdImageBlockFunction *blockFunc;
+    };
+    
+    void executeImageBlockCalc(std::vector<std::string> inputImgs, std::string outputImg, std::string gdalFormat, RSGISLibDataType outDataType, unsigned int numOutBands, RSGISCmdImageBlockFunction *blockFunc)
+    {
+        GDALDataset **datasets = NULL;
+        unsigned int nImgs = inputImgs.size();
+        try
+        {
+            GDALAllRegister();
+            if((nImgs == 0) || (numOutBands == 0))
+            {
+                throw RSGISCmdException("At least one input image and one output band are required.");
+            }
+            
+            datasets = new GDALDataset*[nImgs];
+            for(unsigned int i = 0; i < nImgs; ++i)
+            {
+                datasets[i] = NULL;
+            }
+            for(unsigned int i = 0; i < nImgs; ++i)
+            {
+                datasets[i] = (GDALDataset *) GDALOpen(inputImgs.at(i).c_str(), GA_ReadOnly);
+                if(datasets[i] == NULL)
+                {
+                    std::string message = std::string("Could not open image ") + inputImgs.at(i);
+                    throw rsgis::RSGISImageException(message.c_str());
+                }
+            }
+            
+            // The block width is the width of the overlapping region of the inputs.
+            rsgis::img::RSGISImageUtils imgUtils;
+            int **dsOffsets = new int*[nImgs];
+            for(unsigned int i = 0; i < nImgs; ++i)
+            {
+                dsOffsets[i] = new int[2];
+            }
+            double gdalTranslation[6];
+            int width = 0;
+            int height = 0;
+            try
+            {
+                imgUtils.getImageOverlap(datasets, nImgs, dsOffsets, &width, &height, gdalTranslation);
+            }
+            catch(rsgis::img::RSGISImageBandException &e)
+            {
+                for(unsigned int i = 0; i < nImgs; ++i)
+                {
+                    delete[] dsOffsets[i];
+                }
+                delete[] dsOffsets;
+                throw;
+            }
+            for(unsigned int i = 0; i < nImgs; ++i)
+            {
+                delete[] dsOffsets[i];
+            }
+            delete[] dsOffsets;
+            
+            RSGISCmdCalcImageBlockFunction calcBlockFunc = RSGISCmdCalcImageBlockFunction(numOutBands, width, blockFunc);
+            rsgis::img::RSGISCalcImage calcImage = rsgis::img::RSGISCalcImage(&calcBlockFunc, "", true);
+            calcImage.calcImage(datasets, nImgs, outputImg, false, NULL, gdalFormat, RSGIS_to_GDAL_Type(outDataType));
+            
+            for(unsigned int i = 0; i < nImgs; ++i)
+            {
+                GDALClose(datasets[i]);
+            }
+            delete[] datasets;
+        }
+        catch(RSGISCmdException &e)
+        {
+            if(datasets != NULL)
+            {
+                for(unsigned int i = 0; i < nImgs; ++i)
+                {
+                    if(datasets[i] != NULL)
+                    {
+                        GDALClose(datasets[i]);
+                    }
+                }
+                delete[] datasets;
+            }
+            throw e;
+        }
+        catch(rsgis::RSGISException &e)
+        {
+            if(datasets != NULL)
+            {
+                for(unsigned int i = 0; i < nImgs; ++i)
+                {
+                    if(datasets[i] != NULL)
+                    {
+                        GDALClose(datasets[i]);
+                    }
+                }
+                delete[] datasets;
+            }
+            throw RSGISCmdException(e.what());
+        }
+    }
                 
 }}
 
@@ -27,6 +27,7 @@
 #include <string>
 #include <vector>
 #include <list>
+#include <utility>
 
 #include "common/RSGISCommons.h"
 #include "RSGISCmdException.h"
@@ -55,6 +56,20 @@ namespace rsgis{ namespace cmds {
         bool defined;
     };
     
+    /**
+     * A band maths step of executeBandMathsPipeline. The image of each
+     * variable is the name of a pipeline input or of an earlier step (which
+     * has one band). The output of the step is written to outputImage unless
+     * it is empty.
+     */
+    struct DllExport BandMathsPipelineStep
+    {
+        std::string name;
+        std::string mathsExpression;
+        std::vector<VariableStruct> variables;
+        std::string outputImage;
+    };
+    
     struct DllExport ImageStatsCmds
 	{
 		double mean;
@@ -90,26 +105,60 @@ namespace rsgis{ namespace cmds {
         rsgiscmds_stat_count
     };
 
+    /**
+     * A function applied to each block of rows by executeImageBlockCalc. The
+     * input (as float) and output (as double) are given as one plane per band
+     * of width * nRows values in row order. The planes belong to the image
+     * calc engine and are only valid during the call.
+     */
+    class DllExport RSGISCmdImageBlockFunction
+    {
+    public:
+        virtual void calcBlock(const float* const* inPlanes, unsigned int numInBands, double **outPlanes, unsigned int numOutBands, unsigned int width, unsigned int nRows) = 0;
+        virtual ~RSGISCmdImageBlockFunction(){};
+    };
+
     /** Function to run the band maths tools */
     DllExport void executeBandMaths(VariableStruct *variables, unsigned int numVars, std::string outputImage, std::string mathsExpression, std::string gdalFormat, RSGISLibDataType outDataType, bool useExpAsbandName, bool editOutputImg=false);
+    /**
+     * Band maths, then a mask (values of band 1 of imageMask in maskValues are
+     * set to maskOutValue), then a linear stretch from [inMin, inMax] to
+     * [outMin, outMax] (masked pixels keep maskOutValue), evaluated together
+     * on each block so no intermediate image is written.
+     */
+    DllExport void executeBandMathsMaskStretch(VariableStruct *variables, unsigned int numVars, std::string imageMask, std::vector<float> maskValues, float maskOutValue, double inMin, double inMax, double outMin, double outMax, std::string outputImage, std::string mathsExpression, std::string gdalFormat, RSGISLibDataType outDataType);
+    /**
+     * Run a workflow of band maths steps with rsgis::img::RSGISImagePipeline.
+     * inputImages are the (name, image file) pairs the steps refer to. Only
+     * the steps with an outputImage are written; the steps they depend on are
+     * fused into as few passes over the images as possible. tempDIR is used
+     * for any temporary images (the system temporary directory if empty).
+     */
+    DllExport void executeBandMathsPipeline(std::vector<std::pair<std::string, std::string> > inputImages, std::vector<BandMathsPipelineStep> steps, std::string gdalFormat, RSGISLibDataType outDataType, std::string tempDIR="");
     /** Function to run the image maths tools */
     DllExport void executeImageMaths(std::string inputImage, std::string outputImage, std::string mathsExpression, std::string imageFormat, RSGISLibDataType outDataType, bool useExpAsbandName, bool editOutputImg=false);
     /** Function to run the image band maths tools */
     DllExport void executeImageBandMaths(std::string inputImage, std::string outputImage, std::string mathsExpression, std::string imageFormat, RSGISLibDataType outDataType, bool useExpAsbandName, bool editOutputImg=false);
     /** Function to run the KMeans tool */
-    DllExport void executeKMeansClustering(std::string inputImage, std::string outputMatrixFile, unsigned int numClusters, unsigned int maxNumIterations, unsigned int subSample, bool ignoreZeros, float degreeOfChange, RSGISInitClustererMethods initClusterMethod);
+    DllExport void executeKMeansClustering(std::string inputImage, std::string outputMatrixFile, unsigned int numClusters, unsigned int maxNumIterations, unsigned int subSample, bool ignoreZeros, float degreeOfChange, RSGISInitClustererMethods initClusterMethod, unsigned int miniBatchSize=0);
     /** Function to run the KMeans tool */
     DllExport void executeISODataClustering(std::string inputImage, std::string outputMatrixFile, unsigned int numClusters, unsigned int maxNumIterations, unsigned int subSample, bool ignoreZeros, float degreeOfChange, RSGISInitClustererMethods initClusterMethod, float minDistBetweenClusters, unsigned int minNumFeatures, float maxStdDev, unsigned int minNumClusters, unsigned int startIteration, unsigned int endIteration);
     /** Function to run mahalanobis distance Window Filter */
     DllExport void executeMahalanobisDistFilter(std::string inputImage, std::string outputImage, unsigned int winSize, std::string gdalFormat, RSGISLibDataType outDataType);
     /** Function to run mahalanobis distance Image to Window Filter */
     DllExport void executeMahalanobisDist2ImgFilter(std::string inputImage, std::string outputImage, unsigned int winSize, std::string gdalFormat, RSGISLibDataType outDataType);
+    /** Function to run the mahalanobis distance of each pixel to its window (local RX) filter */
+    DllExport void executeLocalMahalanobisDistFilter(std::string inputImage, std::string outputImage, unsigned int winSize, std::string gdalFormat, RSGISLibDataType outDataType);
     /** Function to run image calculate distance command */
     DllExport void executeImageCalcDistance(std::string inputImage, std::string outputImage, std::string gdalFormat);
     /** Function to calculate summary statistics for a column of pixels */
     DllExport void executeImagePixelColumnSummary(std::string inputImage, std::string outputImage, rsgis::cmds::RSGISCmdStatsSummary summaryStats, std::string gdalFormat, RSGISLibDataType outDataType, float noDataValue, bool useNoDataValue);
     /** Function to perform a linear regression on each column of pixels */
     DllExport void executeImagePixelLinearFit(std::string inputImage, std::string outputImage, std::string gdalFormat, std::string bandValues, float noDataValue, bool useNoDataValue);
+    /** Function to fit a polynomial (of degree numTerms) or harmonic model (with numTerms harmonics of period) to each column of pixels */
+    DllExport void executeImagePixelModelFit(std::string inputImage, std::string outputImage, std::string gdalFormat, std::string bandValues, bool harmonic, unsigned int numTerms, float period, float noDataValue, bool useNoDataValue);
+    /** Function to fit a polynomial or harmonic model to each column of pixels robustly (IRLS with Tukey's biweight), outputting the coefficients, RMSE and optionally an outlier mask band for each input band */
+    DllExport void executeImagePixelRobustModelFit(std::string inputImage, std::string outputImage, std::string gdalFormat, std::string bandValues, bool harmonic, unsigned int numTerms, float period, unsigned int maxIters, float tuning, float outlierThreshold, bool outputOutliers, float noDataValue, bool useNoDataValue);
     /** Function to perform image normalisation */
     DllExport void executeNormalisation(std::vector<std::string> inputImages, std::vector<std::string> outputImages, bool calcInMinMax, double inMin, double inMax, double outMin, double outMax);
     /** Function to calculate the correlation between 2 images */
@@ -120,6 +169,9 @@ namespace rsgis{ namespace cmds {
     DllExport void executeMeanVector(std::string inputImage, std::string outputMatrix);
     /** Function to perform principal components analysis of an image */
     DllExport void executePCA(std::string inputImage, std::string eigenvectors, std::string outputImage, int numComponents, std::string gdalFormat, RSGISLibDataType outDataType);
+    /** Function to calculate the principal components of an image in one pass over it (with the covariance of all the bands) and apply them,
+        returns the proportion of the variance explained by each component. The eigenvectors are saved if outEigenvectors is not empty. */
+    DllExport std::vector<double> executeImagePCA(std::string inputImage, std::string outputImage, std::string outEigenvectors, unsigned int numComponents, std::string gdalFormat, RSGISLibDataType outDataType, bool useNoData=false, float noDataVal=0, bool randomised=false);
     /** Function to generate a standardised image using the mean vector provided */
     DllExport void executeStandardise(std::string meanvectorStr, std::string inputImage, std::string outputImage);
     /** Function to replace values less then given, using a threshold */
@@ -161,7 +213,7 @@ namespace rsgis{ namespace cmds {
     /** Function to generate a histogram and return it */
     DllExport unsigned int* executeGetHistogram(std::string inputImage, unsigned int imgBand, double binWidth, unsigned int *nBins, bool calcInMinMax, double *inMin, double *inMax);
     /** Function to calculate image band percentiles */
-    DllExport std::vector<double> executeBandPercentile(std::string inputImage, float percentile, float noDataValue, bool noDataValueSpecified);
+    DllExport std::vector<double> executeBandPercentile(std::string inputImage, float percentile, float noDataValue, bool noDataValueSpecified, float maxError=0);
     /** Function to calculate the distance to the nearest geometry for every pixel in an image */
     DllExport void executeImageDist2Geoms(std::string inputImage, std::string inputVector, std::string imageFormat, std::string outputImage);
     /** Function to calculate correlation for windows */
@@ -192,6 +244,8 @@ namespace rsgis{ namespace cmds {
     DllExport void executeIdentifyMinPxlValueInWin(std::string inputImg, std::string outputImg, std::string outputRefImg, std::vector<unsigned int> bands, unsigned int winSize, std::string gdalFormat, float noDataValue, bool useNoDataValue);
     /** A function to calculate a mean value across a number of image bands within a mask */
     DllExport float executeCalcImgMeanInMask(std::string inputImg, std::string inputImgMsk, int mskValue, std::vector<unsigned int> bands, float noDataValue, bool useNoDataValue);
+    /** A function to create an output image by applying a function to the blocks read and written by the image calc engine */
+    DllExport void executeImageBlockCalc(std::vector<std::string> inputImgs, std::string outputImg, std::string gdalFormat, RSGISLibDataType outDataType, unsigned int numOutBands, RSGISCmdImageBlockFunction *blockFunc);
 
 
 }}
@@ -30,6 +30,7 @@
 #include "calibration/RSGISCloudMasking.h"
 #include "calibration/RSGISHydroDEMFillSoilleGratin94.h"
 #include "calibration/RSGISImgCalibUtils.h"
+#include "calibration/RSGISDarkTargetAOT.h"
 
 #include "img/RSGISImageCalcException.h"
 #include "img/RSGISCalcImageValue.h"
@@ -466,7 +467,7 @@ namespace rsgis{ namespace cmds {
         }
     }
                 
-    void executeRad2SREFElevAOTLUT6sParams(std::string inputRadImage, std::string inputDEM, std::string inputAOTImg, std::string outputImage, std::string gdalFormat, rsgis::RSGISLibDataType rsgisOutDataType, float scaleFactor, std::vector<Cmds6SBaseElevAOTLUT> *lut, float noDataVal, bool useNoDataVal)
+    void executeRad2SREFElevAOTLUT6sParams(std::string inputRadImage, std::string inputDEM, std::string inputAOTImg, std::string outputImage, std::string gdalFormat, rsgis::RSGISLibDataType rsgisOutDataType, float scaleFactor, std::vector<Cmds6SBaseElevAOTLUT> *lut, float noDataVal, bool useNoDataVal, float elevQuantStep)
     {
         try
         {
@@ -544,7 +545,7 @@ namespace rsgis{ namespace cmds {
             
             std::cout << "Apply Coefficients to input image...\n";
             
-            rsgis::calib::RSGISApply6SCoefficientsElevAOTLUTParam *apply6SCoefficients = new rsgis::calib::RSGISApply6SCoefficientsElevAOTLUTParam(numRasterBands, rsgisLUT, noDataVal, useNoDataVal, scaleFactor);
+            rsgis::calib::RSGISApply6SCoefficientsElevAOTLUTParam *apply6SCoefficients = new rsgis::calib::RSGISApply6SCoefficientsElevAOTLUTParam(numRasterBands, rsgisLUT, noDataVal, useNoDataVal, scaleFactor, elevQuantStep);
             
             rsgis::img::RSGISCalcImage *calcImage = new rsgis::img::RSGISCalcImage(apply6SCoefficients, "", true);
             calcImage->calcImage(datasets, 3, outputImage, false, NULL, gdalFormat, RSGIS_to_GDAL_Type(rsgisOutDataType));
@@ -578,6 +579,90 @@ namespace rsgis{ namespace cmds {
             throw RSGISCmdException(e.what());
         }
     }
+    
+    float executeEstimateDarkTargetAOT(std::string inputRadImage, std::string inputDEM, std::string outputAOTImg, std::string gdalFormat, std::vector<Cmds6SBaseElevAOTLUT> *lut, unsigned int radBand, unsigned int regionSize, float darkPercentile, float darkTargetRefl, unsigned int minPxls, float noDataVal, bool useNoDataVal)
+    {
+        float imageAOT = 0;
+        GDALDataset *radDataset = NULL;
+        GDALDataset *demDataset = NULL;
+        try
+        {
+            GDALAllRegister();
+            std::cout << "Open Radiance image: \'" << inputRadImage << "\'" << std::endl;
+            radDataset = (GDALDataset *) GDALOpen(inputRadImage.c_str(), GA_ReadOnly);
+            if(radDataset == NULL)
+            {
+                std::string message = std::string("Could not open image ") + inputRadImage;
+                throw rsgis::RSGISImageException(message.c_str());
+            }
+            
+            if(inputDEM != "")
+            {
+                std::cout << "Open DEM image: \'" << inputDEM << "\'" << std::endl;
+                demDataset = (GDALDataset *) GDALOpen(inputDEM.c_str(), GA_ReadOnly);
+                if(demDataset == NULL)
+                {
+                    std::string message = std::string("Could not open image ") + inputDEM;
+                    throw rsgis::RSGISImageException(message.c_str());
+                }
+            }
+            
+            // The estimator only reads the coefficients so they are not copied.
+            std::vector<rsgis::calib::LUT6SBaseElevAOT> rsgisLUT;
+            for(std::vector<Cmds6SBaseElevAOTLUT>::iterator iterElevLUT = lut->begin(); iterElevLUT != lut->end(); ++iterElevLUT)
+            {
+                rsgis::calib::LUT6SBaseElevAOT lutElevVal = rsgis::calib::LUT6SBaseElevAOT();
+                lutElevVal.elev = (*iterElevLUT).elev;
+                for(std::vector<Cmds6SAOTLUT>::iterator iterAOTLUT = (*iterElevLUT).aotLUT.begin(); iterAOTLUT != (*iterElevLUT).aotLUT.end(); ++iterAOTLUT)
+                {
+                    rsgis::calib::LUT6SAOT aotLUTVal = rsgis::calib::LUT6SAOT();
+                    aotLUTVal.aot = (*iterAOTLUT).aot;
+                    aotLUTVal.numValues = (*iterAOTLUT).numValues;
+                    aotLUTVal.imageBands = (*iterAOTLUT).imageBands;
+                    aotLUTVal.aX = (*iterAOTLUT).aX;
+                    aotLUTVal.bX = (*iterAOTLUT).bX;
+                    aotLUTVal.cX = (*iterAOTLUT).cX;
+                    lutElevVal.aotLUT.push_back(aotLUTVal);
+                }
+                rsgisLUT.push_back(lutElevVal);
+            }
+            
+            std::cout << "Estimate AOT from dark targets...\n";
+            rsgis::calib::RSGISDarkTargetAOTEstimator estimateAOT(&rsgisLUT, radBand, regionSize, darkPercentile, darkTargetRefl, minPxls);
+            imageAOT = estimateAOT.estimateAOT(radDataset, demDataset, noDataVal, useNoDataVal, outputAOTImg, gdalFormat);
+            
+            GDALClose(radDataset);
+            if(demDataset != NULL)
+            {
+                GDALClose(demDataset);
+            }
+        }
+        catch(rsgis::RSGISException &e)
+        {
+            if(radDataset != NULL)
+            {
+                GDALClose(radDataset);
+            }
+            if(demDataset != NULL)
+            {
+                GDALClose(demDataset);
+            }
+            throw RSGISCmdException(e.what());
+        }
+        catch(std::exception &e)
+        {
+            if(radDataset != NULL)
+            {
+                GDALClose(radDataset);
+            }
+            if(demDataset != NULL)
+            {
+                GDALClose(demDataset);
+            }
+            throw RSGISCmdException(e.what());
+        }
+        return imageAOT;
+    }
                 
     void executeApplySubtractOffsets(std::string inputImage, std::string outputImage, std::string offsetImage, bool nonNegative, std::string gdalFormat, rsgis::RSGISLibDataType rsgisOutDataType, float noDataVal, bool useNoDataVal, float darkObjReflVal) 
     {
@@ -762,7 +847,7 @@ namespace rsgis{ namespace cmds {
         }
     }
     
-    void executeLandsatTMCloudFMask(std::string inputTOAImage, std::string inputThermalImage, std::string inputSaturateImage, std::string validImg, std::string outputImage, std::string gdalFormat, double sunAz, double sunZen, double senAz, double senZen, float whitenessThreshold, float scaleFactorIn, std::string tmpImgsBase, std::string tmpImgFileExt, bool rmTmpImgs) 
+    void executeLandsatTMCloudFMask(std::string inputTOAImage, std::string inputThermalImage, std::string inputSaturateImage, std::string validImg, std::string outputImage, std::string gdalFormat, double sunAz, double sunZen, double senAz, double senZen, float whitenessThreshold, float scaleFactorIn, std::string tmpImgsBase, std::string tmpImgFileExt, bool rmTmpImgs, bool fusedPasses) 
     {
         GDALAllRegister();
         try
@@ -785,7 +870,6 @@ namespace rsgis{ namespace cmds {
             std::string tmpCloudsClumpRMSmall = tmpImgsBase + "_baseCloudClumpsRMSmall"+tmpImgFileExt;
             std::string tmpCloudsClumpRMSmallRelabel = tmpImgsBase + "_baseCloudClumpsRMSmallRelabel"+tmpImgFileExt;
             std::string tmpCloudsInitHeights = tmpImgsBase + "_baseCloudInitHeights"+tmpImgFileExt;
-            std::string tmpCloudsShadowTestRegions = tmpImgsBase + "_testShadowRegions"+tmpImgFileExt;
             std::string tmpCloudsShadows = tmpImgsBase + "_shadowRegions"+tmpImgFileExt;
             std::string tmpFinalShadowsDialate = tmpImgsBase + "_finalShadowsDialate"+tmpImgFileExt;
             std::string tmpFinalClouds = tmpImgsBase + "_finalClouds"+tmpImgFileExt;
@@ -847,155 +931,215 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISPopulateWithImageStats popImageStats;
             rsgis::rastergis::RSGISRasterAttUtils attUtils;
 
-            std::cout << "Apply first pass FMask to classifiy initial clear sky regions...\n";
-            rsgis::calib::RSGISLandsatFMaskPass1CloudMasking cloudMaskPass1 = rsgis::calib::RSGISLandsatFMaskPass1CloudMasking(scaleFactorIn, (numReflBands+numThermBands), whitenessThreshold);
-            rsgis::img::RSGISCalcImage *calcImage = new rsgis::img::RSGISCalcImage(&cloudMaskPass1, "", true);
-            datasets = new GDALDataset*[3];
-            datasets[0] = reflDataset;
-            datasets[1] = thermDataset;
-            datasets[2] = saturateDataset;
-            GDALDataset *pass1DS = imgUtils.createCopy(datasets, 3, 16, pass1TmpOutImage, gdalFormat, GDT_Float32);
-            calcImage->calcImage(datasets, 3, pass1DS);
-            delete calcImage;
-            delete[] datasets;
-            
+            GDALDataset *pass1DS = NULL;
+            GDALDataset *landWaterClearSkyDS = NULL;
+            rsgis::calib::RSGISLandsatFMaskFusedPasses *fusedFMask = NULL;
+            rsgis::img::RSGISCalcImage *calcImage = NULL;
+            double propPCP = 0.0;
             std::vector<std::string> bandNames;
-            bandNames.push_back("ndsi");
-            bandNames.push_back("ndvi");
-            bandNames.push_back("basicTest");
-            bandNames.push_back("meanVis");
-            bandNames.push_back("whitenessTest");
-            bandNames.push_back("hotTest");
-            bandNames.push_back("nirswirTest");
-            bandNames.push_back("waterTest");
-            bandNames.push_back("pcp");
-            bandNames.push_back("clearSkyLand");
-            bandNames.push_back("snowTest");
-            bandNames.push_back("varProb");
-            bandNames.push_back("modNDVI");
-            bandNames.push_back("modNDSI");
-            bandNames.push_back("whiteness");
-            bandNames.push_back("clearSkyWater");
-            imgUtils.setImageBandNames(pass1DS, bandNames, true);
-            
-            
-            std::cout << "Export Land and Water regions and check PCP coverage.\n";
-            GDALDataset *landWaterClearSkyDS = imgUtils.createCopy(pass1DS, 1, landWaterTmpOutImage, gdalFormat, GDT_UInt32);
-            rsgis::calib::RSGISLandsatFMaskExportPass1LandWaterCloudMasking exportLandWaterRegions = rsgis::calib::RSGISLandsatFMaskExportPass1LandWaterCloudMasking();
-            datasets = new GDALDataset*[2];
-            datasets[0] = validAreaDataset;
-            datasets[1] = pass1DS;
-            calcImage = new rsgis::img::RSGISCalcImage(&exportLandWaterRegions, "", true);
-            calcImage->calcImage(datasets, 2, landWaterClearSkyDS);
-            double propPCP = exportLandWaterRegions.propOfPCPPixels();
-            delete calcImage;
-            delete[] datasets;
+            if(fusedPasses)
+            {
+                std::cout << "Apply fused first pass FMask to classifiy initial clear sky regions...\n";
+                landWaterClearSkyDS = imgUtils.createCopy(validAreaDataset, 1, landWaterTmpOutImage, gdalFormat, GDT_UInt32);
+                fusedFMask = new rsgis::calib::RSGISLandsatFMaskFusedPasses(scaleFactorIn, (numReflBands+numThermBands), whitenessThreshold);
+                fusedFMask->calcPass1(reflDataset, thermDataset, saturateDataset, validAreaDataset, landWaterClearSkyDS);
+                propPCP = fusedFMask->propOfPCPPixels();
+            }
+            else
+            {
+                std::cout << "Apply first pass FMask to classifiy initial clear sky regions...\n";
+                rsgis::calib::RSGISLandsatFMaskPass1CloudMasking cloudMaskPass1 = rsgis::calib::RSGISLandsatFMaskPass1CloudMasking(scaleFactorIn, (numReflBands+numThermBands), whitenessThreshold);
+                calcImage = new rsgis::img::RSGISCalcImage(&cloudMaskPass1, "", true);
+                datasets = new GDALDataset*[3];
+                datasets[0] = reflDataset;
+                datasets[1] = thermDataset;
+                datasets[2] = saturateDataset;
+                pass1DS = imgUtils.createCopy(datasets, 3, 16, pass1TmpOutImage, gdalFormat, GDT_Float32);
+                calcImage->calcImage(datasets, 3, pass1DS);
+                delete calcImage;
+                delete[] datasets;
+            
+                bandNames.push_back("ndsi");
+                bandNames.push_back("ndvi");
+                bandNames.push_back("basicTest");
+                bandNames.push_back("meanVis");
+                bandNames.push_back("whitenessTest");
+                bandNames.push_back("hotTest");
+                bandNames.push_back("nirswirTest");
+                bandNames.push_back("waterTest");
+                bandNames.push_back("pcp");
+                bandNames.push_back("clearSkyLand");
+                bandNames.push_back("snowTest");
+                bandNames.push_back("varProb");
+                bandNames.push_back("modNDVI");
+                bandNames.push_back("modNDSI");
+                bandNames.push_back("whiteness");
+                bandNames.push_back("clearSkyWater");
+                imgUtils.setImageBandNames(pass1DS, bandNames, true);
+            
+            
+                std::cout << "Export Land and Water regions and check PCP coverage.\n";
+                landWaterClearSkyDS = imgUtils.createCopy(pass1DS, 1, landWaterTmpOutImage, gdalFormat, GDT_UInt32);
+                rsgis::calib::RSGISLandsatFMaskExportPass1LandWaterCloudMasking exportLandWaterRegions = rsgis::calib::RSGISLandsatFMaskExportPass1LandWaterCloudMasking();
+                datasets = new GDALDataset*[2];
+                datasets[0] = validAreaDataset;
+                datasets[1] = pass1DS;
+                calcImage = new rsgis::img::RSGISCalcImage(&exportLandWaterRegions, "", true);
+                calcImage->calcImage(datasets, 2, landWaterClearSkyDS);
+                propPCP = exportLandWaterRegions.propOfPCPPixels();
+                delete calcImage;
+                delete[] datasets;
+            
+            }
+            // Image used to define the size and projection of the intermediate images.
+            GDALDataset *imgTemplateDS = fusedPasses?landWaterClearSkyDS:pass1DS;
             
             std::cout << "Proportion of PCP coverage of the scene is " << propPCP << std::endl;
             
             if(propPCP < 0.95)
             {
                 
-                popImageStats.populateImageWithRasterGISStats(landWaterClearSkyDS, true, true, 1);
-                
-                std::cout << "Populating RAT with Thermal Stats\n";
-                // Equation 8 and 13 calc percentiles (Zhu and Woodcock 2012, RSE 118, pp83-94):
-                std::vector<rsgis::rastergis::RSGISBandAttPercentiles *> *bandPercentStats = new std::vector<rsgis::rastergis::RSGISBandAttPercentiles *>();
-                rsgis::rastergis::RSGISBandAttPercentiles *tempUpperPercent = new rsgis::rastergis::RSGISBandAttPercentiles();
-                tempUpperPercent->fieldName = "UpperTempThres";
-                tempUpperPercent->percentile = 82.5;
-                bandPercentStats->push_back(tempUpperPercent);
-                rsgis::rastergis::RSGISBandAttPercentiles *tempLowerPercent = new rsgis::rastergis::RSGISBandAttPercentiles();
-                tempLowerPercent->fieldName = "LowerTempThres";
-                tempLowerPercent->percentile = 17.5;
-                bandPercentStats->push_back(tempLowerPercent);
-                calcClumpStats.populateRATWithPercentileStats(landWaterClearSkyDS, thermDataset, 1, bandPercentStats, 1, 200);
-                delete tempUpperPercent;
-                delete tempLowerPercent;
-                delete bandPercentStats;
-                
-                std::cout << "Get Thresholds From the RAT\n";
-                const GDALRasterAttributeTable *landWaterRAT = landWaterClearSkyDS->GetRasterBand(1)->GetDefaultRAT();
-                double lowerWaterThres = ratUtils.readDoubleColumnVal(landWaterRAT, "LowerTempThres", 2)/scaleFactorIn;
-                double upperWaterThres = ratUtils.readDoubleColumnVal(landWaterRAT, "UpperTempThres", 2)/scaleFactorIn;
-                double lowerLandThres = ratUtils.readDoubleColumnVal(landWaterRAT, "LowerTempThres", 1)/scaleFactorIn;
-                double upperLandThres = ratUtils.readDoubleColumnVal(landWaterRAT, "UpperTempThres", 1)/scaleFactorIn;
-                
-                std::cout << "Lower Water Threshold = " << lowerWaterThres << std::endl;
-                std::cout << "Upper Water Threshold = " << upperWaterThres << std::endl;
-                
-                std::cout << "Lower Land Threshold = " << lowerLandThres << std::endl;
-                std::cout << "Upper Land Threshold = " << upperLandThres << std::endl;
-                
-                std::cout << "Calculate the cloud probability over the land area...\n";
-                rsgis::calib::RSGISLandsatFMaskPass2ClearSkyCloudProbCloudMasking cloudMaskPass2Part1 = rsgis::calib::RSGISLandsatFMaskPass2ClearSkyCloudProbCloudMasking(scaleFactorIn, (numReflBands+numThermBands), upperWaterThres, upperLandThres, lowerLandThres);
-                calcImage = new rsgis::img::RSGISCalcImage(&cloudMaskPass2Part1, "", true);
-                datasets = new GDALDataset*[4];
-                datasets[0] = landWaterClearSkyDS;
-                datasets[1] = reflDataset;
-                datasets[2] = thermDataset;
-                datasets[3] = pass1DS;
-                GDALDataset *pass2DS = imgUtils.createCopy(pass1DS, 6, cloudLandProbTmpOutImage, gdalFormat, GDT_Float32);
-                calcImage->calcImage(datasets, 4, pass2DS);
-                delete calcImage;
-                delete[] datasets;
-                
-                bandNames = std::vector<std::string>();
-                bandNames.push_back("wTempProb");
-                bandNames.push_back("brightnessProb");
-                bandNames.push_back("waterCloudProb");
-                bandNames.push_back("landTempProb");
-                bandNames.push_back("varProb");
-                bandNames.push_back("landCloudProb");
-                imgUtils.setImageBandNames(pass2DS, bandNames, true);
-                
-                
-                // Equation 17 (Zhu and Woodcock 2012, RSE 118, pp83-94):
-                std::cout << "Calculate percentile probability thresholds for water and land...\n";
-                bandPercentStats = new std::vector<rsgis::rastergis::RSGISBandAttPercentiles *>();
-                rsgis::rastergis::RSGISBandAttPercentiles *landCloudProbPercent = new rsgis::rastergis::RSGISBandAttPercentiles();
-                landCloudProbPercent->fieldName = "UpperCloudLandThres";
-                landCloudProbPercent->percentile = 82.5; // THRESHOLD FOR DIFFERENCIATING LAND AND CLOUD
-                bandPercentStats->push_back(landCloudProbPercent);
-                calcClumpStats.populateRATWithPercentileStats(landWaterClearSkyDS, pass2DS, 6, bandPercentStats, 1, 200);
-                delete landCloudProbPercent;
-                delete bandPercentStats;
-                double landCloudProbUpperThres = ratUtils.readDoubleColumnVal(landWaterRAT, "UpperCloudLandThres", 1);
-                
-                // Equation 18 threshold of 0.5 used in Zhu and Woodcock 2012, RSE 118, pp83-94 changed in Zhu et al (2015) RSE 159 pp269-277 to be dynamic:
-                bandPercentStats = new std::vector<rsgis::rastergis::RSGISBandAttPercentiles *>();
-                rsgis::rastergis::RSGISBandAttPercentiles *waterCloudProbPercent = new rsgis::rastergis::RSGISBandAttPercentiles();
-                waterCloudProbPercent->fieldName = "UpperCloudWaterThres";
-                waterCloudProbPercent->percentile = 82.5; // THRESHOLD FOR DIFFERENCIATING LAND AND WATER
-                bandPercentStats->push_back(waterCloudProbPercent);
-                calcClumpStats.populateRATWithPercentileStats(landWaterClearSkyDS, pass2DS, 3, bandPercentStats, 1, 200);
-                delete waterCloudProbPercent;
-                delete bandPercentStats;
-                double waterCloudProbUpperThres = ratUtils.readDoubleColumnVal(landWaterRAT, "UpperCloudWaterThres", 2);
-                
-                landCloudProbUpperThres = landCloudProbUpperThres + 0.2;
-                waterCloudProbUpperThres = waterCloudProbUpperThres + 0.2;
-                if (waterCloudProbUpperThres > 0.5)
+                const GDALRasterAttributeTable *landWaterRAT = NULL;
+                double lowerWaterThres = 0.0;
+                double upperWaterThres = 0.0;
+                double lowerLandThres = 0.0;
+                double upperLandThres = 0.0;
+                double landCloudProbUpperThres = 0.0;
+                double waterCloudProbUpperThres = 0.0;
+                double landNIR175Val = 0.0;
+                double landSWIR175Val = 0.0;
+                GDALDataset *pass2DS = NULL;
+                GDALDataset *cloudMaskDS = NULL;
+                if(fusedPasses)
                 {
-                    waterCloudProbUpperThres = 0.5;
+                    lowerWaterThres = fusedFMask->getLowerWaterThres();
+                    upperWaterThres = fusedFMask->getUpperWaterThres();
+                    lowerLandThres = fusedFMask->getLowerLandThres();
+                    upperLandThres = fusedFMask->getUpperLandThres();
+                    
+                    std::cout << "Lower Water Threshold = " << lowerWaterThres << std::endl;
+                    std::cout << "Upper Water Threshold = " << upperWaterThres << std::endl;
+                    
+                    std::cout << "Lower Land Threshold = " << lowerLandThres << std::endl;
+                    std::cout << "Upper Land Threshold = " << upperLandThres << std::endl;
+                    
+                    std::cout << "Apply fused second pass FMask to classify final clouds mask...\n";
+                    cloudMaskDS = imgUtils.createCopy(imgTemplateDS, 1, tmpCloudsExtent, gdalFormat, GDT_Int32);
+                    fusedFMask->calcPass2(cloudMaskDS);
+                    landCloudProbUpperThres = fusedFMask->getLandCloudProbUpperThres();
+                    waterCloudProbUpperThres = fusedFMask->getWaterCloudProbUpperThres();
+                    landNIR175Val = fusedFMask->getLandNIRLower();
+                    landSWIR175Val = fusedFMask->getLandSWIRLower();
+                    delete fusedFMask;
+                    fusedFMask = NULL;
+                    
+                    std::cout << "Upper Land Cloud Prob Threshold = " << landCloudProbUpperThres << std::endl;
+                    std::cout << "Upper Water Cloud Prob Threshold = " << waterCloudProbUpperThres << std::endl;
                 }
+                else
+                {
+                    popImageStats.populateImageWithRasterGISStats(landWaterClearSkyDS, true, true, 1);
+                
+                    std::cout << "Populating RAT with Thermal Stats\n";
+                    // Equation 8 and 13 calc percentiles (Zhu and Woodcock 2012, RSE 118, pp83-94):
+                    std::vector<rsgis::rastergis::RSGISBandAttPercentiles *> *bandPercentStats = new std::vector<rsgis::rastergis::RSGISBandAttPercentiles *>();
+                    rsgis::rastergis::RSGISBandAttPercentiles *tempUpperPercent = new rsgis::rastergis::RSGISBandAttPercentiles();
+                    tempUpperPercent->fieldName = "UpperTempThres";
+                    tempUpperPercent->percentile = 82.5;
+                    bandPercentStats->push_back(tempUpperPercent);
+                    rsgis::rastergis::RSGISBandAttPercentiles *tempLowerPercent = new rsgis::rastergis::RSGISBandAttPercentiles();
+                    tempLowerPercent->fieldName = "LowerTempThres";
+                    tempLowerPercent->percentile = 17.5;
+                    bandPercentStats->push_back(tempLowerPercent);
+                    calcClumpStats.populateRATWithPercentileStats(landWaterClearSkyDS, thermDataset, 1, bandPercentStats, 1, 200);
+                    delete tempUpperPercent;
+                    delete tempLowerPercent;
+                    delete bandPercentStats;
+                
+                    std::cout << "Get Thresholds From the RAT\n";
+                    landWaterRAT = landWaterClearSkyDS->GetRasterBand(1)->GetDefaultRAT();
+                    lowerWaterThres = ratUtils.readDoubleColumnVal(landWaterRAT, "LowerTempThres", 2)/scaleFactorIn;
+                    upperWaterThres = ratUtils.readDoubleColumnVal(landWaterRAT, "UpperTempThres", 2)/scaleFactorIn;
+                    lowerLandThres = ratUtils.readDoubleColumnVal(landWaterRAT, "LowerTempThres", 1)/scaleFactorIn;
+                    upperLandThres = ratUtils.readDoubleColumnVal(landWaterRAT, "UpperTempThres", 1)/scaleFactorIn;
+                
+                    std::cout << "Lower Water Threshold = " << lowerWaterThres << std::endl;
+                    std::cout << "Upper Water Threshold = " << upperWaterThres << std::endl;
+                
+                    std::cout << "Lower Land Threshold = " << lowerLandThres << std::endl;
+                    std::cout << "Upper Land Threshold = " << upperLandThres << std::endl;
+                
+                    std::cout << "Calculate the cloud probability over the land area...\n";
+                    rsgis::calib::RSGISLandsatFMaskPass2ClearSkyCloudProbCloudMasking cloudMaskPass2Part1 = rsgis::calib::RSGISLandsatFMaskPass2ClearSkyCloudProbCloudMasking(scaleFactorIn, (numReflBands+numThermBands), upperWaterThres, upperLandThres, lowerLandThres);
+                    calcImage = new rsgis::img::RSGISCalcImage(&cloudMaskPass2Part1, "", true);
+                    datasets = new GDALDataset*[4];
+                    datasets[0] = landWaterClearSkyDS;
+                    datasets[1] = reflDataset;
+                    datasets[2] = thermDataset;
+                    datasets[3] = pass1DS;
+                    pass2DS = imgUtils.createCopy(pass1DS, 6, cloudLandProbTmpOutImage, gdalFormat, GDT_Float32);
+                    calcImage->calcImage(datasets, 4, pass2DS);
+                    delete calcImage;
+                    delete[] datasets;
+                
+                    bandNames = std::vector<std::string>();
+                    bandNames.push_back("wTempProb");
+                    bandNames.push_back("brightnessProb");
+                    bandNames.push_back("waterCloudProb");
+                    bandNames.push_back("landTempProb");
+                    bandNames.push_back("varProb");
+                    bandNames.push_back("landCloudProb");
+                    imgUtils.setImageBandNames(pass2DS, bandNames, true);
+                
+                
+                    // Equation 17 (Zhu and Woodcock 2012, RSE 118, pp83-94):
+                    std::cout << "Calculate percentile probability thresholds for water and land...\n";
+                    bandPercentStats = new std::vector<rsgis::rastergis::RSGISBandAttPercentiles *>();
+                    rsgis::rastergis::RSGISBandAttPercentiles *landCloudProbPercent = new rsgis::rastergis::RSGISBandAttPercentiles();
+                    landCloudProbPercent->fieldName = "UpperCloudLandThres";
+                    landCloudProbPercent->percentile = 82.5; // THRESHOLD FOR DIFFERENCIATING LAND AND CLOUD
+                    bandPercentStats->push_back(landCloudProbPercent);
+                    calcClumpStats.populateRATWithPercentileStats(landWaterClearSkyDS, pass2DS, 6, bandPercentStats, 1, 200);
+                    delete landCloudProbPercent;
+                    delete bandPercentStats;
+                    landCloudProbUpperThres = ratUtils.readDoubleColumnVal(landWaterRAT, "UpperCloudLandThres", 1);
+                
+                    // Equation 18 threshold of 0.5 used in Zhu and Woodcock 2012, RSE 118, pp83-94 changed in Zhu et al (2015) RSE 159 pp269-277 to be dynamic:
+                    bandPercentStats = new std::vector<rsgis::rastergis::RSGISBandAttPercentiles *>();
+                    rsgis::rastergis::RSGISBandAttPercentiles *waterCloudProbPercent = new rsgis::rastergis::RSGISBandAttPercentiles();
+                    waterCloudProbPercent->fieldName = "UpperCloudWaterThres";
+                    waterCloudProbPercent->percentile = 82.5; // THRESHOLD FOR DIFFERENCIATING LAND AND WATER
+                    bandPercentStats->push_back(waterCloudProbPercent);
+                    calcClumpStats.populateRATWithPercentileStats(landWaterClearSkyDS, pass2DS, 3, bandPercentStats, 1, 200);
+                    delete waterCloudProbPercent;
+                    delete bandPercentStats;
+                    waterCloudProbUpperThres = ratUtils.readDoubleColumnVal(landWaterRAT, "UpperCloudWaterThres", 2);
+                
+                    landCloudProbUpperThres = landCloudProbUpperThres + 0.2;
+                    waterCloudProbUpperThres = waterCloudProbUpperThres + 0.2;
+                    if (waterCloudProbUpperThres > 0.5)
+                    {
+                        waterCloudProbUpperThres = 0.5;
+                    }
                 
-                std::cout << "Upper Land Cloud Prob Threshold = " << landCloudProbUpperThres << std::endl;
-                std::cout << "Upper Water Cloud Prob Threshold = " << waterCloudProbUpperThres << std::endl;
+                    std::cout << "Upper Land Cloud Prob Threshold = " << landCloudProbUpperThres << std::endl;
+                    std::cout << "Upper Water Cloud Prob Threshold = " << waterCloudProbUpperThres << std::endl;
 
-                std::cout << "Apply second pass FMask to classify final clouds mask...\n";
-                rsgis::calib::RSGISLandsatFMaskPass2CloudMasking cloudMaskPass2Part2 = rsgis::calib::RSGISLandsatFMaskPass2CloudMasking(scaleFactorIn, (numReflBands+numThermBands), landCloudProbUpperThres, waterCloudProbUpperThres, lowerLandThres);
-                calcImage = new rsgis::img::RSGISCalcImage(&cloudMaskPass2Part2, "", true);
-                datasets = new GDALDataset*[5];
-                datasets[0] = landWaterClearSkyDS;
-                datasets[1] = reflDataset;
-                datasets[2] = thermDataset;
-                datasets[3] = pass1DS;
-                datasets[4] = pass2DS;
-                GDALDataset *cloudMaskDS = imgUtils.createCopy(pass1DS, 1, tmpCloudsExtent, gdalFormat, GDT_Int32);
-                calcImage->calcImage(datasets, 5, cloudMaskDS);
-                delete calcImage;
-                delete[] datasets;
+                    std::cout << "Apply second pass FMask to classify final clouds mask...\n";
+                    rsgis::calib::RSGISLandsatFMaskPass2CloudMasking cloudMaskPass2Part2 = rsgis::calib::RSGISLandsatFMaskPass2CloudMasking(scaleFactorIn, (numReflBands+numThermBands), landCloudProbUpperThres, waterCloudProbUpperThres, lowerLandThres);
+                    calcImage = new rsgis::img::RSGISCalcImage(&cloudMaskPass2Part2, "", true);
+                    datasets = new GDALDataset*[5];
+                    datasets[0] = landWaterClearSkyDS;
+                    datasets[1] = reflDataset;
+                    datasets[2] = thermDataset;
+                    datasets[3] = pass1DS;
+                    datasets[4] = pass2DS;
+                    cloudMaskDS = imgUtils.createCopy(pass1DS, 1, tmpCloudsExtent, gdalFormat, GDT_Int32);
+                    calcImage->calcImage(datasets, 5, cloudMaskDS);
+                    delete calcImage;
+                    delete[] datasets;
+                
+                }
                 
                 std::cout << "Apply cloud majority filter...\n";
                 rsgis::calib::RSGISCalcImageCloudMajorityFilter cloudMajFilter = rsgis::calib::RSGISCalcImageCloudMajorityFilter();
@@ -1004,7 +1148,7 @@ namespace rsgis{ namespace cmds {
                 
                 
                 std::cout << "Get cloud objects\n";
-                GDALDataset *cloudClumpsDS = imgUtils.createCopy(pass1DS, 1, tmpCloudsClump, gdalFormat, GDT_UInt32);
+                GDALDataset *cloudClumpsDS = imgUtils.createCopy(imgTemplateDS, 1, tmpCloudsClump, gdalFormat, GDT_UInt32);
                 rsgis::segment::RSGISClumpPxls clumpImg;
                 clumpImg.performClump(cloudMaskDS, cloudClumpsDS, true, 0.0, NULL);
                 popImageStats.populateImageWithRasterGISStats(cloudClumpsDS, true, true, true, 1);
@@ -1015,16 +1159,15 @@ namespace rsgis{ namespace cmds {
                 
                 size_t numcloudsRATHistoRows = 0;
                 int *cloudsRATHisto = attUtils.readIntColumn(cloudsRAT, "Histogram", &numcloudsRATHistoRows);
-                GDALDataset *cloudClumpsRMSmallDS = imgUtils.createCopy(pass1DS, 1, tmpCloudsClumpRMSmall, gdalFormat, GDT_UInt32);
+                GDALDataset *cloudClumpsRMSmallDS = imgUtils.createCopy(imgTemplateDS, 1, tmpCloudsClumpRMSmall, gdalFormat, GDT_UInt32);
                 rsgis::segment::RSGISRemoveClumpsBelowThreshold rmClumpBelowSize = rsgis::segment::RSGISRemoveClumpsBelowThreshold(smallCloudThreshold, cloudsRATHisto, numcloudsRATHistoRows);
                 rsgis::img::RSGISCalcImage calcImgRmSmallClump = rsgis::img::RSGISCalcImage(&rmClumpBelowSize);
                 calcImgRmSmallClump.calcImage(&cloudClumpsDS, 1, 0, cloudClumpsRMSmallDS);
                 delete[] cloudsRATHisto;
                 
                 rsgis::segment::RSGISRelabelClumps relabelImg;
-                GDALDataset *cloudClumpsRMSmallReLblDS = imgUtils.createCopy(pass1DS, 1, tmpCloudsClumpRMSmallRelabel, gdalFormat, GDT_UInt32);
-                relabelImg.relabelClumpsCalcImg(cloudClumpsRMSmallDS, cloudClumpsRMSmallReLblDS);
-                popImageStats.populateImageWithRasterGISStats(cloudClumpsRMSmallReLblDS, true, true, 1);
+                GDALDataset *cloudClumpsRMSmallReLblDS = imgUtils.createCopy(imgTemplateDS, 1, tmpCloudsClumpRMSmallRelabel, gdalFormat, GDT_UInt32);
+                relabelImg.relabelClumpsCalcImg(cloudClumpsRMSmallDS, cloudClumpsRMSmallReLblDS, true);
 
                 std::cout << "Calculate Shadow Mask\n";
                 int nirIdx = 4;
@@ -1033,15 +1176,18 @@ namespace rsgis{ namespace cmds {
                     nirIdx = 5;
                 }
                 
-                bandPercentStats = new std::vector<rsgis::rastergis::RSGISBandAttPercentiles *>();
-                rsgis::rastergis::RSGISBandAttPercentiles *landNIRPercent = new rsgis::rastergis::RSGISBandAttPercentiles();
-                landNIRPercent->fieldName = "LowerNIRLandValue175";
-                landNIRPercent->percentile = 17.5; // NIR LAND THRESHOLD 17.5 %
-                bandPercentStats->push_back(landNIRPercent);
-                calcClumpStats.populateRATWithPercentileStats(landWaterClearSkyDS, reflDataset, nirIdx, bandPercentStats, 1, 200);
-                delete landNIRPercent;
-                delete bandPercentStats;
-                double landNIR175Val = ratUtils.readDoubleColumnVal(landWaterRAT, "LowerNIRLandValue175", 1);
+                if(!fusedPasses)
+                {
+                    std::vector<rsgis::rastergis::RSGISBandAttPercentiles *> *bandPercentStats = new std::vector<rsgis::rastergis::RSGISBandAttPercentiles *>();
+                    rsgis::rastergis::RSGISBandAttPercentiles *landNIRPercent = new rsgis::rastergis::RSGISBandAttPercentiles();
+                    landNIRPercent->fieldName = "LowerNIRLandValue175";
+                    landNIRPercent->percentile = 17.5; // NIR LAND THRESHOLD 17.5 %
+                    bandPercentStats->push_back(landNIRPercent);
+                    calcClumpStats.populateRATWithPercentileStats(landWaterClearSkyDS, reflDataset, nirIdx, bandPercentStats, 1, 200);
+                    delete landNIRPercent;
+                    delete bandPercentStats;
+                    landNIR175Val = ratUtils.readDoubleColumnVal(landWaterRAT, "LowerNIRLandValue175", 1);
+                }
                 std::cout << "Land NIR 17.5% Percentile = " << landNIR175Val << std::endl;
                 
                 // Extract NIR band.
@@ -1068,15 +1214,18 @@ namespace rsgis{ namespace cmds {
                 {
                     swirIdx = 6;
                 }
-                bandPercentStats = new std::vector<rsgis::rastergis::RSGISBandAttPercentiles *>();
-                rsgis::rastergis::RSGISBandAttPercentiles *landSWIRPercent = new rsgis::rastergis::RSGISBandAttPercentiles();
-                landSWIRPercent->fieldName = "LowerSWIRLandValue175";
-                landSWIRPercent->percentile = 17.5; // SWIR LAND THRESHOLD 17.5 %
-                bandPercentStats->push_back(landSWIRPercent);
-                calcClumpStats.populateRATWithPercentileStats(landWaterClearSkyDS, reflDataset, swirIdx, bandPercentStats, 1, 200);
-                delete landSWIRPercent;
-                delete bandPercentStats;
-                double landSWIR175Val = ratUtils.readDoubleColumnVal(landWaterRAT, "LowerSWIRLandValue175", 1);
+                if(!fusedPasses)
+                {
+                    std::vector<rsgis::rastergis::RSGISBandAttPercentiles *> *bandPercentStats = new std::vector<rsgis::rastergis::RSGISBandAttPercentiles *>();
+                    rsgis::rastergis::RSGISBandAttPercentiles *landSWIRPercent = new rsgis::rastergis::RSGISBandAttPercentiles();
+                    landSWIRPercent->fieldName = "LowerSWIRLandValue175";
+                    landSWIRPercent->percentile = 17.5; // SWIR LAND THRESHOLD 17.5 %
+                    bandPercentStats->push_back(landSWIRPercent);
+                    calcClumpStats.populateRATWithPercentileStats(landWaterClearSkyDS, reflDataset, swirIdx, bandPercentStats, 1, 200);
+                    delete landSWIRPercent;
+                    delete bandPercentStats;
+                    landSWIR175Val = ratUtils.readDoubleColumnVal(landWaterRAT, "LowerSWIRLandValue175", 1);
+                }
                 std::cout << "Land SWIR 17.5% Percentile = " << landSWIR175Val << std::endl;
                 
                 // Extract SWIR band.
@@ -1114,14 +1263,13 @@ namespace rsgis{ namespace cmds {
                 delete[] datasets;
                 
 
-                GDALDataset *initCloudHeightsDS = imgUtils.createCopy(pass1DS, 2, tmpCloudsInitHeights, gdalFormat, GDT_Float32);
+                GDALDataset *initCloudHeightsDS = imgUtils.createCopy(imgTemplateDS, 2, tmpCloudsInitHeights, gdalFormat, GDT_Float32);
                 rsgis::calib::RSGISCalcCloudParams calcCloudParams;
                 calcCloudParams.calcCloudHeights(thermDataset, cloudClumpsRMSmallReLblDS, initCloudHeightsDS, lowerLandThres, upperLandThres, scaleFactorIn);
                 
-                GDALDataset *cloudShadowTestRegionsDS = imgUtils.createCopy(pass1DS, 1, tmpCloudsShadowTestRegions, gdalFormat, GDT_Byte);
-                GDALDataset *cloudShadowRegionsDS = imgUtils.createCopy(pass1DS, 1, tmpCloudsShadows, gdalFormat, GDT_Byte);
+                GDALDataset *cloudShadowRegionsDS = imgUtils.createCopy(imgTemplateDS, 1, tmpCloudsShadows, gdalFormat, GDT_Byte);
                 
-                calcCloudParams.projFitCloudShadow(cloudClumpsRMSmallReLblDS, initCloudHeightsDS, potentCloudShadowDS, cloudShadowTestRegionsDS, cloudShadowRegionsDS, sunAz, sunZen, senAz, senZen);
+                calcCloudParams.projFitCloudShadowInMem(cloudClumpsRMSmallReLblDS, initCloudHeightsDS, potentCloudShadowDS, cloudShadowRegionsDS, sunAz, sunZen, senAz, senZen);
                 
                 
                 std::cout << "Apply cloud shadow majority filter...\n";
@@ -1154,11 +1302,9 @@ namespace rsgis{ namespace cmds {
                 attUtils.writeIntColumn(cloudsRATRelbl, "CloudMask", cloudsRATHisto, numcloudsRATHistoRows);
                 delete[] cloudsRATHisto;
                 
-                unsigned int columnIndex = attUtils.findColumnIndex(cloudsRATRelbl, "CloudMask");
-                rsgis::rastergis::RSGISExportColumns2ImageCalcImage calcImageVal = rsgis::rastergis::RSGISExportColumns2ImageCalcImage(1, cloudsRATRelbl, columnIndex);
-                rsgis::img::RSGISCalcImage calcImageExportRATCol(&calcImageVal);
-                GDALDataset *finalCloudsDS = imgUtils.createCopy(pass1DS, 1, tmpFinalClouds, gdalFormat, GDT_Byte);
-                calcImageExportRATCol.calcImage(&cloudClumpsRMSmallReLblDS, 1, 0, finalCloudsDS);
+                GDALDataset *finalCloudsDS = imgUtils.createCopy(imgTemplateDS, 1, tmpFinalClouds, gdalFormat, GDT_Byte);
+                rsgis::rastergis::RSGISRATLUTImage lutImage;
+                lutImage.exportColumns(cloudClumpsRMSmallReLblDS, 1, std::vector<std::string>(1, "CloudMask"), finalCloudsDS);
       
                 
                 morphDialate.dilateImage(&finalCloudsDS, tmpFinalCloudsDialate, matrixMorphOperator, gdalFormat, GDT_Byte);
@@ -1170,7 +1316,7 @@ namespace rsgis{ namespace cmds {
                 }
                 matrixUtils.freeMatrix(matrixMorphOperator);
                 
-                GDALDataset *finalResultDS = imgUtils.createCopy(pass1DS, 1, outputImage, gdalFormat, GDT_Byte);
+                GDALDataset *finalResultDS = imgUtils.createCopy(imgTemplateDS, 1, outputImage, gdalFormat, GDT_Byte);
                 datasets = new GDALDataset*[2];
                 datasets[0] = finalCloudsDialateDS;
                 datasets[1] = finalShadowsDialateDS;
@@ -1213,9 +1359,15 @@ namespace rsgis{ namespace cmds {
                 delete[] blue;
                 delete[] classNames;
                 
-                GDALClose(pass1DS);
+                if(pass1DS != NULL)
+                {
+                    GDALClose(pass1DS);
+                }
                 GDALClose(landWaterClearSkyDS);
-                GDALClose(pass2DS);
+                if(pass2DS != NULL)
+                {
+                    GDALClose(pass2DS);
+                }
                 GDALClose(nirBandDS);
                 GDALClose(nirBandFillDS);
                 GDALClose(potentCloudShadowDS);
@@ -1224,7 +1376,6 @@ namespace rsgis{ namespace cmds {
                 GDALClose(cloudClumpsRMSmallDS);
                 GDALClose(cloudClumpsRMSmallReLblDS);
                 GDALClose(initCloudHeightsDS);
-                GDALClose(cloudShadowTestRegionsDS);
                 GDALClose(cloudShadowRegionsDS);
                 GDALClose(finalShadowsDialateDS);
                 GDALClose(finalCloudsDS);
@@ -1245,9 +1396,12 @@ namespace rsgis{ namespace cmds {
                         throw RSGISImageException("Image driver is not available.");
                     }
                     
-                    poDriver->Delete(pass1TmpOutImage.c_str());
+                    if(!fusedPasses)
+                    {
+                        poDriver->Delete(pass1TmpOutImage.c_str());
+                        poDriver->Delete(cloudLandProbTmpOutImage.c_str());
+                    }
                     poDriver->Delete(landWaterTmpOutImage.c_str());
-                    poDriver->Delete(cloudLandProbTmpOutImage.c_str());
                     poDriver->Delete(tmpNIRBandImg.c_str());
                     poDriver->Delete(tmpNIRFillBandImg.c_str());
                     poDriver->Delete(tmpPotentShadows.c_str());
@@ -1256,7 +1410,6 @@ namespace rsgis{ namespace cmds {
                     poDriver->Delete(tmpCloudsClumpRMSmall.c_str());
                     poDriver->Delete(tmpCloudsClumpRMSmallRelabel.c_str());
                     poDriver->Delete(tmpCloudsInitHeights.c_str());
-                    poDriver->Delete(tmpCloudsShadowTestRegions.c_str());
                     poDriver->Delete(tmpCloudsShadows.c_str());
                     poDriver->Delete(tmpFinalShadowsDialate.c_str());
                     poDriver->Delete(tmpFinalClouds.c_str());
@@ -1306,7 +1459,14 @@ namespace rsgis{ namespace cmds {
                 delete[] classNames;
                 
                 
-                GDALClose(pass1DS);
+                if(fusedFMask != NULL)
+                {
+                    delete fusedFMask;
+                }
+                if(pass1DS != NULL)
+                {
+                    GDALClose(pass1DS);
+                }
                 GDALClose(landWaterClearSkyDS);
                 GDALClose(reflDataset);
                 GDALClose(thermDataset);
@@ -1322,7 +1482,10 @@ namespace rsgis{ namespace cmds {
                         throw RSGISImageException("Image driver is not available.");
                     }
                     
-                    poDriver->Delete(pass1TmpOutImage.c_str());
+                    if(!fusedPasses)
+                    {
+                        poDriver->Delete(pass1TmpOutImage.c_str());
+                    }
                     poDriver->Delete(landWaterTmpOutImage.c_str());
                 }
             }
@@ -1849,7 +2012,6 @@ namespace rsgis{ namespace cmds {
             std::string tmpDarkFillBandImg = tmpImgsBase + "_darkbandfill"+tmpImgFileExt;
             std::string tmpPotentShadows = tmpImgsBase + "_potentshadows"+tmpImgFileExt;
             std::string tmpClumpClouds = tmpImgsBase + "_cloudclumps"+tmpImgFileExt;
-            std::string tmpCloudsShadowTestRegions = tmpImgsBase + "_testShadowRegions"+tmpImgFileExt;
             std::string tmpCloudsShadows = tmpImgsBase + "_shadowRegions"+tmpImgFileExt;
             std::string tmpCloudsInitHeights = tmpImgsBase + "_baseCloudInitHeights"+tmpImgFileExt;
             
@@ -1899,12 +2061,11 @@ namespace rsgis{ namespace cmds {
             GDALDataset *initCloudHeightsDS = imgUtils.createCopy(validDataset, 2, tmpCloudsInitHeights, gdalFormat, GDT_Float32);
             imgUtils.assignValGDALDataset(initCloudHeightsDS, 0.0);
             
-            GDALDataset *cloudShadowTestRegionsDS = imgUtils.createCopy(validDataset, 1, tmpCloudsShadowTestRegions, gdalFormat, GDT_Byte);
             GDALDataset *cloudShadowRegionsDS = imgUtils.createCopy(validDataset, 1, tmpCloudsShadows, gdalFormat, GDT_Byte);
             
             rsgis::calib::RSGISCalcCloudParams calcCloudParams;
             calcCloudParams.calcCloudHeightsNoThermal(tmpClumpCloudsDS, initCloudHeightsDS);
-            calcCloudParams.projFitCloudShadow(tmpClumpCloudsDS, initCloudHeightsDS, potentCloudShadowDS, cloudShadowTestRegionsDS, cloudShadowRegionsDS, sunAz, sunZen, senAz, senZen);
+            calcCloudParams.projFitCloudShadowInMem(tmpClumpCloudsDS, initCloudHeightsDS, potentCloudShadowDS, cloudShadowRegionsDS, sunAz, sunZen, senAz, senZen);
 
             std::cout << "Apply cloud shadow majority filter...\n";
             rsgis::calib::RSGISCalcImageCloudMajorityFilter cloudShadowMajFilter = rsgis::calib::RSGISCalcImageCloudMajorityFilter();
@@ -1921,7 +2082,6 @@ namespace rsgis{ namespace cmds {
             GDALClose(darkBandFillDS);
             GDALClose(potentCloudShadowDS);
             GDALClose(initCloudHeightsDS);
-            GDALClose(cloudShadowTestRegionsDS);
             GDALClose(cloudShadowRegionsDS);
             GDALClose(tmpClumpCloudsDS);
             
@@ -1937,7 +2097,6 @@ namespace rsgis{ namespace cmds {
                 poDriver->Delete(tmpDarkFillBandImg.c_str());
                 poDriver->Delete(tmpPotentShadows.c_str());
                 poDriver->Delete(tmpClumpClouds.c_str());
-                poDriver->Delete(tmpCloudsShadowTestRegions.c_str());
                 poDriver->Delete(tmpCloudsShadows.c_str());
                 poDriver->Delete(tmpCloudsInitHeights.c_str());
             }
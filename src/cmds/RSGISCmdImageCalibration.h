@@ -153,8 +153,18 @@ namespace rsgis{ namespace cmds {
     /** Function to convert radiance into surface reflectance using a LUT for surface elevation of 6S */
     DllExport void executeRad2SREFElevLUT6sParams(std::string inputRadImage, std::string inputDEM, std::string outputImage, std::string gdalFormat, rsgis::RSGISLibDataType rsgisOutDataType, float scaleFactor, std::vector<Cmds6SElevationLUT> *lut, float noDataVal, bool useNoDataVal);
     
-    /** Function to convert radiance into surface reflectance using a LUT for surface elevation and AOT of 6S */
-    DllExport void executeRad2SREFElevAOTLUT6sParams(std::string inputRadImage, std::string inputDEM, std::string inputAOTImg, std::string outputImage, std::string gdalFormat, rsgis::RSGISLibDataType rsgisOutDataType, float scaleFactor, std::vector<Cmds6SBaseElevAOTLUT> *lut, float noDataVal, bool useNoDataVal);
+    /** Function to convert radiance into surface reflectance using a LUT for surface elevation and AOT of 6S (elevQuantStep > 0 quantises the elevations to that step when selecting the LUT entry) */
+    DllExport void executeRad2SREFElevAOTLUT6sParams(std::string inputRadImage, std::string inputDEM, std::string inputAOTImg, std::string outputImage, std::string gdalFormat, rsgis::RSGISLibDataType rsgisOutDataType, float scaleFactor, std::vector<Cmds6SBaseElevAOTLUT> *lut, float noDataVal, bool useNoDataVal, float elevQuantStep=0);
+    
+    /**
+     * Function to estimate the AOT of a radiance image from dark targets: the darkPercentile (0-1)
+     * percentile of radBand within each region of regionSize x regionSize pixels is taken as a dark
+     * target of surface reflectance darkTargetRefl and the AOT for which the LUT gives it that
+     * reflectance is written to outputAOTImg (a pixel per region). The band numbers of the LUT are
+     * those of the radiance image (from 1) and inputDEM may be empty. Returns the AOT of the image
+     * (the median of the regions), which is also given to regions with fewer than minPxls valid pixels.
+     */
+    DllExport float executeEstimateDarkTargetAOT(std::string inputRadImage, std::string inputDEM, std::string outputAOTImg, std::string gdalFormat, std::vector<Cmds6SBaseElevAOTLUT> *lut, unsigned int radBand, unsigned int regionSize, float darkPercentile, float darkTargetRefl, unsigned int minPxls, float noDataVal, bool useNoDataVal);
     
     /** Function to apply an offset image within the context of dark object subtraction */
     DllExport void executeApplySubtractOffsets(std::string inputImage, std::string outputImage, std::string offsetImage, bool nonNegative, std::string gdalFormat, rsgis::RSGISLibDataType rsgisOutDataType, float noDataVal, bool useNoDataVal, float darkObjReflVal);
@@ -165,8 +175,10 @@ namespace rsgis{ namespace cmds {
     /** Function to generate a per-band image band mask of the saturated image pixels */
     DllExport void executeGenerateSaturationMask(std::string outputImage, std::string gdalFormat, std::vector<CmdsSaturatedPixel> imgBandInfo);
     
-    /** Function to apply the FMask algorithm for classifying cloud for Landsat TM and ETM+ data */
-    DllExport void executeLandsatTMCloudFMask(std::string inputTOAImage, std::string inputThermalImage, std::string inputSaturateImage, std::string validImg, std::string outputImage, std::string gdalFormat, double sunAz, double sunZen, double senAz, double senZen, float whitenessThreshold, float scaleFactorIn, std::string tmpImgsBase, std::string tmpImgFileExt, bool rmTmpImgs=true);
+    /** Function to apply the FMask algorithm for classifying cloud for Landsat TM and ETM+ data. If fusedPasses is true the
+        per-pixel passes up to the initial cloud mask are calculated in parallel tiles from one read of the input images, with
+        the scene percentiles from streaming histograms, rather than writing and re-reading intermediate images. */
+    DllExport void executeLandsatTMCloudFMask(std::string inputTOAImage, std::string inputThermalImage, std::string inputSaturateImage, std::string validImg, std::string outputImage, std::string gdalFormat, double sunAz, double sunZen, double senAz, double senZen, float whitenessThreshold, float scaleFactorIn, std::string tmpImgsBase, std::string tmpImgFileExt, bool rmTmpImgs=true, bool fusedPasses=false);
     
     /** Function to apply DOS offsets (per band) to the input image */
     DllExport void executeApplySubtractSingleOffsets(std::string inputImage, std::string outputImage, std::vector<double> offsetValues, bool nonNegative, std::string gdalFormat, rsgis::RSGISLibDataType rsgisOutDataType, float noDataVal, bool useNoDataVal, float darkObjReflVal);
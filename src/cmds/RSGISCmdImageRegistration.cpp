@@ -47,7 +47,7 @@ namespace rsgis{ namespace cmds {
     void excecuteBasicRegistration(std::string inputReferenceImage, std::string inputFloatingmage, int gcpGap,
                                                   float metricThreshold, int windowSize, int searchArea, float stdDevRefThreshold,
                                                   float stdDevFloatThreshold, int subPixelResolution, unsigned int metricTypeInt,
-                                                  unsigned int outputType, std::string outputGCPFile) 
+                                                  unsigned int outputType, std::string outputGCPFile, unsigned int numPyramidLevels, bool useFFTCorrelation) 
     {
         
         try
@@ -96,6 +96,8 @@ namespace rsgis{ namespace cmds {
                                                                                                       windowSize, searchArea, similarityMetric, stdDevRefThreshold,
                                                                                                       stdDevFloatThreshold, subPixelResolution);
             
+            regImgs->setNumPyramidLevels(numPyramidLevels);
+            regImgs->setUseFFTCorrelation(useFFTCorrelation);
             regImgs->runCompleteRegistration();
             
             if(outputType == 1) // envi_img2img
@@ -135,7 +137,7 @@ namespace rsgis{ namespace cmds {
                                                   float metricThreshold, int windowSize, int searchArea, float stdDevRefThreshold,
                                                   float stdDevFloatThreshold, int subPixelResolution, int distanceThreshold,
                                                   int maxNumIterations, float moveChangeThreshold, float pSmoothness, unsigned int metricTypeInt,
-                                                  unsigned int outputType, std::string outputGCPFile) 
+                                                  unsigned int outputType, std::string outputGCPFile, unsigned int numPyramidLevels, bool useFFTCorrelation) 
     {
                 
         try
@@ -187,6 +189,8 @@ namespace rsgis{ namespace cmds {
                                                                                                                    distanceThreshold, maxNumIterations,
                                                                                                                    moveChangeThreshold, pSmoothness);
             
+            regImgs->setNumPyramidLevels(numPyramidLevels);
+            regImgs->setUseFFTCorrelation(useFFTCorrelation);
             regImgs->runCompleteRegistration();
             
             if(outputType == 1) // envi_img2img
@@ -259,7 +263,7 @@ namespace rsgis{ namespace cmds {
         }
     }
     
-    void excecuteTriangularWarp(std::string inputImage, std::string outputImage, std::string projFile, std::string inputGCPs, float resolution, std::string imageFormat, bool genTransformImage) 
+    void excecuteTriangularWarp(std::string inputImage, std::string outputImage, std::string projFile, std::string inputGCPs, float resolution, std::string imageFormat, bool genTransformImage, float maxTransformError) 
     {
         
         try
@@ -276,6 +280,7 @@ namespace rsgis{ namespace cmds {
             }
             
             warp = new rsgis::reg::RSGISWarpImageUsingTriangulation(inputImage, outputImage, projWKTStr, inputGCPs, resolution, interpolator, imageFormat);
+            warp->setTransformApproximation(16, maxTransformError);
             if(genTransformImage)
             {
                 warp->generateTransformImage();
@@ -297,7 +302,7 @@ namespace rsgis{ namespace cmds {
     }
     
     
-    void excecutePolyWarp(std::string inputImage, std::string outputImage, std::string projFile, std::string inputGCPs, float resolution, int polyOrder, std::string imageFormat, bool genTransformImage) 
+    void excecutePolyWarp(std::string inputImage, std::string outputImage, std::string projFile, std::string inputGCPs, float resolution, int polyOrder, std::string imageFormat, bool genTransformImage, float maxTransformError) 
     {
         
         try
@@ -314,6 +319,7 @@ namespace rsgis{ namespace cmds {
             }
             
             warp = new rsgis::reg::RSGISPolynomialImageWarp(inputImage, outputImage, projWKTStr, inputGCPs, resolution, interpolator, polyOrder, imageFormat);
+            warp->setTransformApproximation(16, maxTransformError);
             if(genTransformImage)
             {
                 warp->generateTransformImage();
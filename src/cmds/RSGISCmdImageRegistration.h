@@ -49,18 +49,18 @@ namespace rsgis{ namespace cmds {
     DllExport void excecuteBasicRegistration(std::string inputReferenceImage, std::string inputFloatingmage, int gcpGap,
                                    float metricThreshold, int windowSize, int searchArea, float stdDevRefThreshold,
                                    float stdDevFloatThreshold, int subPixelResolution, unsigned int metricTypeInt,
-                                   unsigned int outputType, std::string outputGCPFile);
+                                   unsigned int outputType, std::string outputGCPFile, unsigned int numPyramidLevels=0, bool useFFTCorrelation=false);
     
     /** Single connected layer image registration */
     DllExport void excecuteSingleLayerConnectedRegistration(std::string inputReferenceImage, std::string inputFloatingmage, int gcpGap,
                                                   float metricThreshold, int windowSize, int searchArea, float stdDevRefThreshold,
                                                   float stdDevFloatThreshold, int subPixelResolution, int distanceThreshold,
                                                   int maxNumIterations, float moveChangeThreshold, float pSmoothness, unsigned int metricTypeInt,
-                                                  unsigned int outputType, std::string outputGCPFile);
+                                                  unsigned int outputType, std::string outputGCPFile, unsigned int numPyramidLevels=0, bool useFFTCorrelation=false);
 
     /** Warp image using triangulation interpolation */
     DllExport void excecuteTriangularWarp(std::string inputImage, std::string outputImage, std::string projFile, std::string inputGCPs,
-                        float resolution, std::string imageFormat = "KEA", bool genTransformImage = false);
+                        float resolution, std::string imageFormat = "KEA", bool genTransformImage = false, float maxTransformError = 0);
     
     /** Warp image using NN interpolation */
     DllExport void excecuteNNWarp(std::string inputImage, std::string outputImage, std::string projFile, std::string inputGCPs,
@@ -68,7 +68,7 @@ namespace rsgis{ namespace cmds {
     
     /** Warp image using polynominal interpolation */
     DllExport void excecutePolyWarp(std::string inputImage, std::string outputImage, std::string projFile, std::string inputGCPs,
-                        float resolution, int polyOrder = 3, std::string imageFormat = "KEA", bool genTransformImage = false);
+                        float resolution, int polyOrder = 3, std::string imageFormat = "KEA", bool genTransformImage = false, float maxTransformError = 0);
     
     /** Add tie points to GCP */
     DllExport void excecuteAddGCPsGDAL(std::string inputImage, std::string inputGCPs, std::string outputImage, std::string gdalFormat, RSGISLibDataType outDataType);
@@ -35,9 +35,12 @@
 #include "img/RSGISCalcImageValue.h"
 #include "img/RSGISCalcImage.h"
 #include "img/RSGISCopyImage.h"
+#include "img/RSGISBatchImageSubset.h"
 #include "img/RSGISStretchImage.h"
 #include "img/RSGISMaskImage.h"
 #include "img/RSGISImageMosaic.h"
+#include "img/RSGISDatasetCache.h"
+#include "img/RSGISImageFootprintIndex.h"
 #include "img/RSGISPopWithStats.h"
 #include "img/RSGISAddBands.h"
 #include "img/RSGISExtractImageValues.h"
@@ -60,7 +63,7 @@
 
 namespace rsgis{ namespace cmds {
 
-    void executeStretchImage(std::string inputImage, std::string outputImage, bool saveOutStats, std::string outStatsFile, bool ignoreZeros, bool onePassSD, std::string gdalFormat, RSGISLibDataType outDataType, RSGISStretches stretchType, float stretchParam)
+    void executeStretchImage(std::string inputImage, std::string outputImage, bool saveOutStats, std::string outStatsFile, bool ignoreZeros, bool onePassSD, std::string gdalFormat, RSGISLibDataType outDataType, RSGISStretches stretchType, float stretchParam, unsigned int statsSampling, bool usePercentiles)
     {
         try
         {
@@ -84,13 +87,14 @@ namespace rsgis{ namespace cmds {
             }
 
             rsgis::img::RSGISStretchImage stretchImg = rsgis::img::RSGISStretchImage(inDataset, outputImage, saveOutStats, outStatsFile, onePassSD, gdalFormat, RSGIS_to_GDAL_Type(outDataType), 0, 255, useNoData, inNoData, outNoData);
+            stretchImg.setStatsSampling(statsSampling);
             if(stretchType == linearMinMax)
             {
                 stretchImg.executeLinearMinMaxStretch();
             }
             else if(stretchType == linearPercent)
             {
-                stretchImg.executeLinearPercentStretch(stretchParam);
+                stretchImg.executeLinearPercentStretch(stretchParam, usePercentiles);
             }
             else if(stretchType == linearStdDev)
             {
@@ -129,7 +133,7 @@ namespace rsgis{ namespace cmds {
         }
     }
 
-    void executeStretchImageNoData(std::string inputImage, std::string outputImage, double inNoData, bool saveOutStats, std::string outStatsFile, bool onePassSD, std::string gdalFormat, RSGISLibDataType outDataType, RSGISStretches stretchType, float stretchParam)
+    void executeStretchImageNoData(std::string inputImage, std::string outputImage, double inNoData, bool saveOutStats, std::string outStatsFile, bool onePassSD, std::string gdalFormat, RSGISLibDataType outDataType, RSGISStretches stretchType, float stretchParam, unsigned int statsSampling, bool usePercentiles)
     {
         try
         {
@@ -145,13 +149,14 @@ namespace rsgis{ namespace cmds {
             double outNoData = 0.0;
             
             rsgis::img::RSGISStretchImage stretchImg = rsgis::img::RSGISStretchImage(inDataset, outputImage, saveOutStats, outStatsFile, onePassSD, gdalFormat, RSGIS_to_GDAL_Type(outDataType), 0, 255, true, inNoData, outNoData);
+            stretchImg.setStatsSampling(statsSampling);
             if(stretchType == linearMinMax)
             {
                 stretchImg.executeLinearMinMaxStretch();
             }
             else if(stretchType == linearPercent)
             {
-                stretchImg.executeLinearPercentStretch(stretchParam);
+                stretchImg.executeLinearPercentStretch(stretchParam, usePercentiles);
             }
             else if(stretchType == linearStdDev)
             {
@@ -1002,14 +1007,14 @@ void executeStretchImageWithStatsNoData(std::string inputImage, std::string outp
         }
     }
 
-    std::vector<std::string> executeOrderImageUsingValidDataProp(std::vector<std::string> images, float noDataValue) 
+    std::vector<std::string> executeOrderImageUsingValidDataProp(std::vector<std::string> images, float noDataValue, bool exactCount)
     {
         GDALAllRegister();
         std::vector<std::string> orderedImages;
         try
         {
             rsgis::img::RSGISImageMosaic mosaic;
-            mosaic.orderInImagesValidData(images, &orderedImages, noDataValue);
+            mosaic.orderInImagesValidData(images, &orderedImages, noDataValue, exactCount);
         }
         catch (RSGISImageException& e)
         {
@@ -1456,6 +1461,53 @@ void executeStretchImageWithStatsNoData(std::string inputImage, std::string outp
         }
     }
                 
+    void executeImageBandPoints2HDF(std::vector<std::pair<std::string, std::vector<unsigned int> > > imageFiles, std::string inputVector, std::string inputVecLyr, std::string outputHDF, RSGISLibDataType dataType)
+    {
+        try
+        {
+            GDALAllRegister();
+            OGRRegisterAll();
+            
+            GDALDataset *inputVecDS = (GDALDataset*) GDALOpenEx(inputVector.c_str(), GDAL_OF_VECTOR, NULL, NULL, NULL);
+            if(inputVecDS == NULL)
+            {
+                std::string message = std::string("Could not open vector file ") + inputVector;
+                throw RSGISFileException(message.c_str());
+            }
+            OGRLayer *inputVecLayer = inputVecDS->GetLayerByName(inputVecLyr.c_str());
+            if(inputVecLayer == NULL)
+            {
+                GDALClose(inputVecDS);
+                std::string message = std::string("Could not open vector layer ") + inputVecLyr;
+                throw RSGISFileException(message.c_str());
+            }
+            
+            try
+            {
+                rsgis::img::RSGISExtractImageValues extractVals;
+                extractVals.extractImgBandDataAtPoints2HDF(imageFiles, inputVecLayer, outputHDF, dataType);
+            }
+            catch (RSGISException& e)
+            {
+                GDALClose(inputVecDS);
+                throw;
+            }
+            GDALClose(inputVecDS);
+        }
+        catch (RSGISImageException& e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+        catch (RSGISException& e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+        catch(std::exception& e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+    }
+    
     void executeRandomSampleH5File(std::string inputH5, std::string outputH5, unsigned int nSample, int seed, RSGISLibDataType dataType)
     {
         try
@@ -1671,9 +1723,6 @@ void executeStretchImageWithStatsNoData(std::string inputImage, std::string outp
             GDALDataset *inputVecDS = NULL;
             OGRLayer *inputVecLayer = NULL;
 
-            rsgis::img::RSGISCopyImage *copyImage = NULL;
-            rsgis::img::RSGISCalcImage *calcImage = NULL;
-
             rsgis::vec::RSGISVectorIO vecIO;
             rsgis::vec::RSGISPolygonData **polyData = NULL;
             rsgis::vec::RSGISImageTileVector **data = NULL;
@@ -1685,7 +1734,6 @@ void executeStretchImageWithStatsNoData(std::string inputImage, std::string outp
             std::string vectorLayerName = vecUtils.getLayerName(inputVector);
             int numImageBands = 0;
             int numFeatures = 0;
-            std::string outputFilePath;
 
             // Open Image
             dataset = new GDALDataset*[1];
@@ -1731,43 +1779,51 @@ void executeStretchImageWithStatsNoData(std::string inputImage, std::string outp
             }
             delete[] polyData;
 
-            copyImage = new rsgis::img::RSGISCopyImage(numImageBands);
-            calcImage = new rsgis::img::RSGISCalcImage(copyImage, "", true);
+            // All the chips are written in one pass over the image.
+            std::vector<rsgis::img::RSGISImageChip> chips(numFeatures);
+            for(int i = 0; i < numFeatures; i++)
+            {
+                chips[i].outputImage = outputImageBase + data[i]->getFileName() + "." + outFileExtension;
+                chips[i].env = *data[i]->getBBox();
+                delete data[i];
+            }
+            delete[] data;
+
+            std::cout << "Subsetting the image to " << numFeatures << " polygons\n";
+            rsgis::img::RSGISBatchImageSubset batchSubset;
+            batchSubset.subsetImage(dataset[0], &chips, imageFormat, RSGIS_to_GDAL_Type(outDataType));
 
             unsigned int failCount = 0;
             for(int i = 0; i < numFeatures; i++)
             {
-                outputFilePath = outputImageBase + data[i]->getFileName() + "." + outFileExtension;
-                std::cout << i << ": " << outputFilePath << std::endl;
-                try
+                if(chips[i].valid)
                 {
-                    calcImage->calcImageInEnv(dataset, 1, outputFilePath, data[i]->getBBox(), false, NULL, imageFormat, RSGIS_to_GDAL_Type(outDataType));
-                    if(outFileNames != NULL){outFileNames->push_back(outputFilePath);}
+                    if(outFileNames != NULL){outFileNames->push_back(chips[i].outputImage);}
                 }
-                catch (rsgis::img::RSGISImageBandException &e)
+                else
                 {
                     ++failCount;
                     if(failCount <= 100)
                     {
-                        std::cerr << "RSGISException caught: " << e.what() << std::endl;
-                        std::cerr << "Check output path exists and is writable and all polygons in shapefile:" << std::endl;
-                        std::cerr << " " << inputVector << std::endl;
-                        std::cerr << "Are completely within:" << std::endl;
-                        std::cerr << " " << inputImage << std::endl;
-                    }
-                    else
-                    {
-                        std::cerr << "Over 100 exceptions have been caught, exiting" << std::endl;
-                        throw e;
+                        std::cerr << i << ": " << chips[i].outputImage << ": " << chips[i].error << std::endl;
                     }
                 }
             }
+            if(failCount > 0)
+            {
+                std::cerr << failCount << " polygons could not be subset. Check output path exists and is writable and all polygons in:" << std::endl;
+                std::cerr << " " << inputVector << std::endl;
+                std::cerr << "Are completely within:" << std::endl;
+                std::cerr << " " << inputImage << std::endl;
+                if(failCount > 100)
+                {
+                    throw rsgis::img::RSGISImageBandException("Over 100 polygons could not be subset.");
+                }
+            }
 
             GDALClose(dataset[0]);
             delete[] dataset;
             GDALClose(inputVecDS);
-            delete calcImage;
-            delete copyImage;
         }
         catch (RSGISImageException& e)
         {
@@ -2465,6 +2521,57 @@ void executeStretchImageWithStatsNoData(std::string inputImage, std::string outp
             throw RSGISCmdException(e.what());
         }
     }
+    
+    void executePerformHCSPanSharpenFused(std::string msImage, std::string panImage, std::string outputImage, std::string gdalFormat, RSGISLibDataType outDataType, unsigned int winSize, bool useNaiveMethod, unsigned int statsDecimation)
+    {
+        try
+        {
+            GDALAllRegister();
+            GDALDataset *msDataset = (GDALDataset *) GDALOpen(msImage.c_str(), GA_ReadOnly);
+            if(msDataset == NULL)
+            {
+                std::string message = std::string("Could not open image ") + msImage;
+                throw RSGISImageException(message.c_str());
+            }
+            GDALDataset *panDataset = (GDALDataset *) GDALOpen(panImage.c_str(), GA_ReadOnly);
+            if(panDataset == NULL)
+            {
+                GDALClose(msDataset);
+                std::string message = std::string("Could not open image ") + panImage;
+                throw RSGISImageException(message.c_str());
+            }
+            
+            try
+            {
+                rsgis::img::RSGISHCSPanSharpenFused panSharpen(winSize, useNaiveMethod, statsDecimation);
+                std::cout << "Calculating image statistics.." << std::endl;
+                panSharpen.calcStats(msDataset, panDataset);
+                std::cout << "Pan sharpening.." << std::endl;
+                panSharpen.panSharpen(msDataset, panDataset, outputImage, gdalFormat, RSGIS_to_GDAL_Type(outDataType));
+            }
+            catch (RSGISException& e)
+            {
+                GDALClose(msDataset);
+                GDALClose(panDataset);
+                throw e;
+            }
+            
+            GDALClose(msDataset);
+            GDALClose(panDataset);
+        }
+        catch (RSGISImageException& e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+        catch (RSGISException& e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+        catch(std::exception& e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+    }
                 
     void executeSharpenLowResImgBands(std::string inputImage, std::string outputImage, std::vector<RSGISInitSharpenBandInfo> bandInfo, unsigned int winSize, int noDataVal, std::string gdalFormat, RSGISLibDataType outDataType) 
     {
@@ -2668,10 +2775,8 @@ void executeStretchImageWithStatsNoData(std::string inputImage, std::string outp
                 ++imgIdx;
             }
             
-            rsgis::img::RSGISMaxNDVIImageComposite imgCompPxlCalc = rsgis::img::RSGISMaxNDVIImageComposite(numImgBands, redBand, nirBand, inputImages.size());
-            
-            rsgis::img::RSGISCalcImage calcImg = rsgis::img::RSGISCalcImage(&imgCompPxlCalc, "", true);
-            calcImg.calcImage(datasets, inputImages.size(), outputImage, false, NULL, gdalFormat, RSGIS_to_GDAL_Type(outDataType));
+            rsgis::img::RSGISSelectionImageComposite imgComposite;
+            imgComposite.createMaxNDVIComposite(datasets, inputImages.size(), redBand, nirBand, outputImage, gdalFormat, RSGIS_to_GDAL_Type(outDataType));
             
             // Tidy up
             for(int i = 0; i < inputImages.size(); ++i)
@@ -2751,10 +2856,8 @@ void executeStretchImageWithStatsNoData(std::string inputImage, std::string outp
                 ++imgIdx;
             }
             
-            rsgis::img::RSGISRefImgImageComposite imgCompPxlCalc = rsgis::img::RSGISRefImgImageComposite(numImgBands, inputImages.size(), outNoDataVal);
-            
-            rsgis::img::RSGISCalcImage calcImg = rsgis::img::RSGISCalcImage(&imgCompPxlCalc, "", true);
-            calcImg.calcImage(datasets, 1, inputImages.size(), outputImage, false, NULL, gdalFormat, RSGIS_to_GDAL_Type(outDataType));
+            rsgis::img::RSGISSelectionImageComposite imgComposite;
+            imgComposite.createRefImgComposite(datasets[0], &datasets[1], inputImages.size(), outputImage, gdalFormat, RSGIS_to_GDAL_Type(outDataType), outNoDataVal);
             
             // Tidy up
             for(int i = 0; i < totNumImgs; ++i)
@@ -2978,9 +3081,8 @@ void executeStretchImageWithStatsNoData(std::string inputImage, std::string outp
                 ++imgIdxAll;
             }
             
-            rsgis::img::RSGISTimeseriesFillImgImageComposite imgFillCompCalc = rsgis::img::RSGISTimeseriesFillImgImageComposite(compInfoVec, imgIdxLUT, totNumImgs, nBands);
-            calcImg = rsgis::img::RSGISCalcImage(&imgFillCompCalc, "", true);
-            calcImg.calcImage(datasets, 1, (imgIdx-1), outCompImg, false, NULL, gdalFormat, RSGIS_to_GDAL_Type(outDataType));
+            rsgis::img::RSGISSelectionImageComposite imgFillComposite;
+            imgFillComposite.createTimeseriesFillComposite(datasets[0], &datasets[1], (imgIdx-1), imgIdxLUT, totNumImgs, outCompImg, gdalFormat, RSGIS_to_GDAL_Type(outDataType));
             delete[] imgIdxLUT;
             // Tidy up
             for(int i = 0; i < imgIdx; ++i)
@@ -3176,6 +3278,95 @@ void executeStretchImageWithStatsNoData(std::string inputImage, std::string outp
         }
         return gdalCreationOpts;
     }
+    
+    void executeSetProfiling(bool enable, bool printSummary)
+    {
+        rsgis::RSGISProfiler::setEnabled(enable);
+        rsgis::RSGISProfiler::setPrintSummary(printSummary);
+    }
+    
+    std::map<std::string, rsgis::RSGISProfileCounter> executeGetProfileCounters()
+    {
+        return rsgis::RSGISProfiler::getCounters();
+    }
+    
+    void executeSetProgressCallback(rsgis::RSGISProgressCallback callback)
+    {
+        rsgis::RSGISProgressCounter::setCallback(callback);
+    }
+    
+    void executeResetProfileCounters()
+    {
+        rsgis::RSGISProfiler::reset();
+    }
+    
+    void executeSetDatasetCacheSize(unsigned int maxDatasets)
+    {
+        rsgis::img::RSGISDatasetCache::setMaxDatasets(maxDatasets);
+    }
+    
+    void executeInvalidateDatasetCache(std::string imagePath)
+    {
+        if(imagePath == "")
+        {
+            rsgis::img::RSGISDatasetCache::invalidateAll();
+        }
+        else
+        {
+            rsgis::img::RSGISDatasetCache::invalidate(imagePath);
+        }
+    }
+    
+    void executeCreateImageFootprintIndex(std::vector<std::string> inputImages, std::string indexFile, bool ignoreFailed, unsigned int numThreads)
+    {
+        try
+        {
+            rsgis::img::RSGISImageFootprintIndex footprintIdx;
+            footprintIdx.setNumThreads(numThreads);
+            footprintIdx.addImages(inputImages, ignoreFailed);
+            footprintIdx.save(indexFile);
+        }
+        catch (RSGISException& e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+        catch(std::exception& e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+    }
+    
+    std::vector<std::string> executeQueryImageFootprintIndex(std::string indexFile, double xMin, double xMax, double yMin, double yMax)
+    {
+        try
+        {
+            return rsgis::img::RSGISImageFootprintIndex::openIndex(indexFile)->queryEnvelope(xMin, xMax, yMin, yMax);
+        }
+        catch (RSGISException& e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+        catch(std::exception& e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+    }
+    
+    std::vector<std::string> executeQueryImageFootprintIndexPoint(std::string indexFile, double x, double y)
+    {
+        try
+        {
+            return rsgis::img::RSGISImageFootprintIndex::openIndex(indexFile)->queryPoint(x, y);
+        }
+        catch (RSGISException& e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+        catch(std::exception& e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+    }
 
 }}
 
@@ -29,6 +29,8 @@
 #include <map>
 
 #include "common/RSGISCommons.h"
+#include "common/RSGISProfiler.h"
+#include "common/RSGISProgressCounter.h"
 #include "RSGISCmdException.h"
 
 // mark all exported classes/functions with DllExport to have
@@ -80,10 +82,10 @@ namespace rsgis{ namespace cmds {
         bool outRef;
     };
     
-    /** Function to run the stretch image command */
-    DllExport void executeStretchImage(std::string inputImage, std::string outputImage, bool saveOutStats, std::string outStatsFile, bool ignoreZeros, bool onePassSD, std::string gdalFormat, RSGISLibDataType outDataType, RSGISStretches stretchType, float stretchParam);
+    /** Function to run the stretch image command (the linear stretch statistics are from every statsSampling'th pixel and line; usePercentiles takes the linear percent stretch limits from the band percentiles) */
+    DllExport void executeStretchImage(std::string inputImage, std::string outputImage, bool saveOutStats, std::string outStatsFile, bool ignoreZeros, bool onePassSD, std::string gdalFormat, RSGISLibDataType outDataType, RSGISStretches stretchType, float stretchParam, unsigned int statsSampling=1, bool usePercentiles=false);
 
-DllExport void executeStretchImageNoData(std::string inputImage, std::string outputImage, double inNoData, bool saveOutStats, std::string outStatsFile, bool onePassSD, std::string gdalFormat, RSGISLibDataType outDataType, RSGISStretches stretchType, float stretchParam);
+DllExport void executeStretchImageNoData(std::string inputImage, std::string outputImage, double inNoData, bool saveOutStats, std::string outStatsFile, bool onePassSD, std::string gdalFormat, RSGISLibDataType outDataType, RSGISStretches stretchType, float stretchParam, unsigned int statsSampling=1, bool usePercentiles=false);
     
     /** Function to run the stretch image command with predefined stretch parameters*/
     DllExport void executeStretchImageWithStats(std::string inputImage, std::string outputImage, std::string inStatsFile, std::string gdalFormat, RSGISLibDataType outDataType, RSGISStretches stretchType, float stretchParam);
@@ -127,8 +129,9 @@ DllExport void executeStretchImageWithStatsNoData(std::string inputImage, std::s
     /** A command to create overview images in the base image by mosaicking the overviews from the tiles/subsets images */
     DllExport void executeImageIncludeOverviews(std::string baseImage, std::vector<std::string> inputImages, std::vector<int> pyraScaleVals);
     
-    /** A command to order a set of input images based on the proportion of valid data within each of the scenes */
-    DllExport std::vector<std::string> executeOrderImageUsingValidDataProp(std::vector<std::string> images, float noDataValue);
+    /** A command to order a set of input images based on the proportion of valid data within each of the scenes.
+        The proportion is estimated from stored statistics, overviews or a decimated read unless exactCount is true. */
+    DllExport std::vector<std::string> executeOrderImageUsingValidDataProp(std::vector<std::string> images, float noDataValue, bool exactCount=false);
     
     /** A function to assign the projection on an image file */
     DllExport void executeAssignProj(std::string inputImage, std::string wktStr, bool readWKTFromFile=false, std::string wktFile="");
@@ -151,6 +154,9 @@ DllExport void executeStretchImageWithStatsNoData(std::string inputImage, std::s
     /** A function to extract image band values to a HDF file */
     DllExport void executeImageBandRasterZone2HDF(std::vector<std::pair<std::string, std::vector<unsigned int> > > imageFiles, std::string maskImage, std::string outputHDF, float maskVal, RSGISLibDataType dataType);
 
+    /** A function to extract image band values at the points of a vector layer to a HDF file */
+    DllExport void executeImageBandPoints2HDF(std::vector<std::pair<std::string, std::vector<unsigned int> > > imageFiles, std::string inputVector, std::string inputVecLyr, std::string outputHDF, RSGISLibDataType dataType);
+
     /** A function to sample a list of values saved in a HDF5 file */
     DllExport void executeRandomSampleH5File(std::string inputH5, std::string outputH5, unsigned int nSample, int seed, RSGISLibDataType dataType);
 
@@ -207,6 +213,8 @@ DllExport void executeStretchImageWithStatsNoData(std::string inputImage, std::s
     
     /** A function to perform a pan-sharpening using a Hyperspherical Colour Space technique */
     DllExport void executePerformHCSPanSharpen(std::string inputImage, std::string outputImage, std::string gdalFormat, RSGISLibDataType outDataType, unsigned int winSize=7, bool useNaiveMethod=false);
+    /** A function to perform a HCS pan-sharpening from separate multispectral and panchromatic images, resampling the multispectral image as it is read */
+    DllExport void executePerformHCSPanSharpenFused(std::string msImage, std::string panImage, std::string outputImage, std::string gdalFormat, RSGISLibDataType outDataType, unsigned int winSize=7, bool useNaiveMethod=false, unsigned int statsDecimation=1);
     
     /** A function to sharpen nn resampled lower resolution image bands using high native resolution image bands in the same stack */
     DllExport void executeSharpenLowResImgBands(std::string inputImage, std::string outputImage, std::vector<RSGISInitSharpenBandInfo> bandInfo, unsigned int winSize, int noDataVal, std::string gdalFormat, RSGISLibDataType outDataType);
@@ -226,6 +234,33 @@ DllExport void executeStretchImageWithStatsNoData(std::string inputImage, std::s
     /** A function to get the GDAL image creation options for a given format via the defined environmental variable */
     DllExport std::map<std::string, std::string> executeGetGDALImageCreationOpts(std::string gdalFormat);
     
+    /** A function to switch the phase timing and I/O counters on or off, optionally printing a summary at the end of each instrumented command */
+    DllExport void executeSetProfiling(bool enable, bool printSummary);
+    
+    /** A function to get the timing and I/O counters recorded since profiling was enabled or the counters last reset */
+    DllExport std::map<std::string, rsgis::RSGISProfileCounter> executeGetProfileCounters();
+    
+    /** A function to set (or with an empty function clear) the callback given the progress of the parallel processing engines */
+    DllExport void executeSetProgressCallback(rsgis::RSGISProgressCallback callback);
+    
+    /** A function to reset the timing and I/O counters */
+    DllExport void executeResetProfileCounters();
+    
+    /** A function to set the maximum number of idle datasets kept open for re-use between commands (0 switches the cache off) */
+    DllExport void executeSetDatasetCacheSize(unsigned int maxDatasets);
+    
+    /** A function to close the cached handle of an image (or of all images if the path is empty) so it is re-opened by the next command */
+    DllExport void executeInvalidateDatasetCache(std::string imagePath);
+    
+    /** A function to create a spatial index of the bounding boxes of a set of images (read from the headers on numThreads threads, 0 for all cores), saved to indexFile */
+    DllExport void executeCreateImageFootprintIndex(std::vector<std::string> inputImages, std::string indexFile, bool ignoreFailed=false, unsigned int numThreads=1);
+    
+    /** A function to find the images in a footprint index which intersect an envelope */
+    DllExport std::vector<std::string> executeQueryImageFootprintIndex(std::string indexFile, double xMin, double xMax, double yMin, double yMax);
+    
+    /** A function to find the images in a footprint index which contain a point */
+    DllExport std::vector<std::string> executeQueryImageFootprintIndexPoint(std::string indexFile, double x, double y);
+    
 }}
 
 
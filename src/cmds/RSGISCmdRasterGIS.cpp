@@ -22,6 +22,7 @@
 
 #include "RSGISCmdRasterGIS.h"
 #include "RSGISCmdParent.h"
+#include "common/RSGISProfiler.h"
 
 #include <boost/filesystem.hpp>
 
@@ -34,6 +35,8 @@
 #include "utils/RSGISTextUtils.h"
 
 #include "img/RSGISCalcImage.h"
+#include "img/RSGISImageUtils.h"
+#include "img/RSGISDatasetCache.h"
 
 #include "vec/RSGISVectorUtils.h"
 
@@ -49,6 +52,7 @@
 #include "rastergis/RSGISRATCalc.h"
 #include "rastergis/RSGISFindInfoBetweenLayers.h"
 #include "rastergis/RSGISClumpBorders.h"
+#include "rastergis/RSGISClumpGeometry.h"
 #include "rastergis/RSGISInterpolateClumpValues2Image.h"
 #include "rastergis/RSGISCalcNeighbourStats.h"
 #include "rastergis/RSGISBinaryClassifyClumps.h"
@@ -66,11 +70,12 @@ namespace rsgis{ namespace cmds {
 
     void executePopulateStats(std::string clumpsImage, bool addColourTable2Img, bool calcImgPyramids, bool ignoreZero, unsigned int ratBand)
     {
+        rsgis::RSGISProfileSummaryScope profileSummary("executePopulateStats");
         try
         {
             GDALAllRegister();
 
-            GDALDataset *clumpsDataset = (GDALDataset *) GDALOpen(clumpsImage.c_str(), GA_Update);
+            GDALDataset *clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
@@ -103,7 +108,7 @@ namespace rsgis{ namespace cmds {
                 popImageStats.calcPyramids(clumpsDataset);
             }
 
-            GDALClose(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
         }
         catch(rsgis::RSGISException &e)
         {
@@ -120,14 +125,14 @@ namespace rsgis{ namespace cmds {
         try
         {
             GDALAllRegister();
-            GDALDataset *inputDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_ReadOnly);
+            GDALDataset *inputDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_ReadOnly);
             if(inputDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + inputImage;
                 throw rsgis::RSGISImageException(message.c_str());
             }
 
-            GDALDataset *outRATDataset = (GDALDataset *) GDALOpen(clumpsImage.c_str(), GA_Update);
+            GDALDataset *outRATDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(outRATDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
@@ -141,8 +146,8 @@ namespace rsgis{ namespace cmds {
             outRATDataset->GetRasterBand(ratBand)->SetDefaultRAT(gdalAtt);
             outRATDataset->GetRasterBand(ratBand)->SetMetadataItem("LAYER_TYPE", "thematic");
 
-            GDALClose(inputDataset);
-            GDALClose(outRATDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(inputDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(outRATDataset);
         }
         catch(rsgis::RSGISException &e)
         {
@@ -159,14 +164,14 @@ namespace rsgis{ namespace cmds {
         try
         {
             GDALAllRegister();
-            GDALDataset *inputDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_ReadOnly);
+            GDALDataset *inputDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_ReadOnly);
             if(inputDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + inputImage;
                 throw rsgis::RSGISImageException(message.c_str());
             }
 
-            GDALDataset *outRATDataset = (GDALDataset *) GDALOpen(clumpsImage.c_str(), GA_Update);
+            GDALDataset *outRATDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(outRATDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
@@ -178,8 +183,8 @@ namespace rsgis{ namespace cmds {
 
             outRATDataset->GetRasterBand(ratBand)->SetMetadataItem("LAYER_TYPE", "thematic");
 
-            GDALClose(inputDataset);
-            GDALClose(outRATDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(inputDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(outRATDataset);
         }
         catch(rsgis::RSGISException &e)
         {
@@ -197,7 +202,7 @@ namespace rsgis{ namespace cmds {
         {
             GDALAllRegister();
 
-            GDALDataset *inputDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_Update);
+            GDALDataset *inputDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_Update);
             if(inputDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + inputImage;
@@ -207,7 +212,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISCalcClusterLocation calcLoc;
             calcLoc.populateAttWithClumpLocation(inputDataset, ratBand, eastingsField, northingsField);
 
-            GDALClose(inputDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(inputDataset);
         }
         catch(rsgis::RSGISException &e)
         {
@@ -225,7 +230,7 @@ namespace rsgis{ namespace cmds {
         {
             GDALAllRegister();
             
-            GDALDataset *inputDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_Update);
+            GDALDataset *inputDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_Update);
             if(inputDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + inputImage;
@@ -235,7 +240,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISCalcClusterLocation calcLoc;
             calcLoc.populateAttWithClumpLocationExtent(inputDataset, ratBand, minXColX, minXColY, maxXColX, maxXColY, minYColX, minYColY, maxYColX, maxYColY);
             
-            GDALClose(inputDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(inputDataset);
         }
         catch(rsgis::RSGISException &e)
         {
@@ -249,17 +254,18 @@ namespace rsgis{ namespace cmds {
 
     void executePopulateRATWithStats(std::string inputImage, std::string clumpsImage, std::vector<rsgis::cmds::RSGISBandAttStatsCmds*> *bandStatsCmds, unsigned int ratBand)
     {
+        rsgis::RSGISProfileSummaryScope profileSummary("executePopulateRATWithStats");
         try
         {
             GDALAllRegister();
 
-            GDALDataset *clumpsDataset = (GDALDataset *) GDALOpenShared(clumpsImage.c_str(), GA_Update);
+            GDALDataset *clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
                 throw rsgis::RSGISImageException(message.c_str());
             }
-            GDALDataset *imageDataset = (GDALDataset *) GDALOpenShared(inputImage.c_str(), GA_ReadOnly);
+            GDALDataset *imageDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_ReadOnly);
             if(imageDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + inputImage;
@@ -299,8 +305,8 @@ namespace rsgis{ namespace cmds {
 
             clumpsDataset->GetRasterBand(ratBand)->SetMetadataItem("LAYER_TYPE", "thematic");
 
-            GDALClose(clumpsDataset);
-            GDALClose(imageDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(imageDataset);
         }
         catch(rsgis::RSGISException &e)
         {
@@ -318,13 +324,13 @@ namespace rsgis{ namespace cmds {
         {
             GDALAllRegister();
 
-            GDALDataset *clumpsDataset = (GDALDataset *) GDALOpenShared(clumpsImage.c_str(), GA_Update);
+            GDALDataset *clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
                 throw rsgis::RSGISImageException(message.c_str());
             }
-            GDALDataset *imageDataset = (GDALDataset *) GDALOpenShared(inputImage.c_str(), GA_ReadOnly);
+            GDALDataset *imageDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_ReadOnly);
             if(imageDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + inputImage;
@@ -357,8 +363,8 @@ namespace rsgis{ namespace cmds {
 
             clumpsDataset->GetRasterBand(ratBand)->SetMetadataItem("LAYER_TYPE", "thematic");
 
-            GDALClose(clumpsDataset);
-            GDALClose(imageDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(imageDataset);
         }
         catch(rsgis::RSGISException &e)
         {
@@ -376,14 +382,14 @@ namespace rsgis{ namespace cmds {
         {
             GDALAllRegister();
             std::cout << "Opening Clumps Image: " << clumpsImage << std::endl;
-            GDALDataset *clumpsDataset = (GDALDataset *) GDALOpenShared(clumpsImage.c_str(), GA_Update);
+            GDALDataset *clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
                 throw rsgis::RSGISImageException(message.c_str());
             }
             std::cout << "Opening Cats Image: " << categoriesImage << std::endl;
-            GDALDataset *catsDataset = (GDALDataset *) GDALOpenShared(categoriesImage.c_str(), GA_ReadOnly);
+            GDALDataset *catsDataset = rsgis::img::RSGISDatasetCache::openDataset(categoriesImage, GA_ReadOnly);
             if(catsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + categoriesImage;
@@ -395,8 +401,8 @@ namespace rsgis{ namespace cmds {
 
             clumpsDataset->GetRasterBand(ratBandClumps)->SetMetadataItem("LAYER_TYPE", "thematic");
 
-            GDALClose(clumpsDataset);
-            GDALClose(catsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(catsDataset);
         }
         catch(rsgis::RSGISException &e)
         {
@@ -414,14 +420,14 @@ namespace rsgis{ namespace cmds {
         {
             GDALAllRegister();
             std::cout << "Opening Clumps Image: " << clumpsImage << std::endl;
-            GDALDataset *clumpsDataset = (GDALDataset *) GDALOpenShared(clumpsImage.c_str(), GA_Update);
+            GDALDataset *clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
                 throw rsgis::RSGISImageException(message.c_str());
             }
             std::cout << "Opening Input Image: " << inputImage << std::endl;
-            GDALDataset *inDataset = (GDALDataset *) GDALOpenShared(inputImage.c_str(), GA_ReadOnly);
+            GDALDataset *inDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_ReadOnly);
             if(inDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + inputImage;
@@ -433,8 +439,8 @@ namespace rsgis{ namespace cmds {
             
             clumpsDataset->GetRasterBand(ratBand)->SetMetadataItem("LAYER_TYPE", "thematic");
             
-            GDALClose(clumpsDataset);
-            GDALClose(inDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(inDataset);
         }
         catch(rsgis::RSGISException &e)
         {
@@ -453,13 +459,13 @@ namespace rsgis{ namespace cmds {
         {
             GDALAllRegister();
 
-            GDALDataset *clumpsDataset = (GDALDataset *) GDALOpenShared(clumpsImage.c_str(), GA_Update);
+            GDALDataset *clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
                 throw rsgis::RSGISImageException(message.c_str());
             }
-            GDALDataset *catsDataset = (GDALDataset *) GDALOpenShared(categoriesImage.c_str(), GA_ReadOnly);
+            GDALDataset *catsDataset = rsgis::img::RSGISDatasetCache::openDataset(categoriesImage, GA_ReadOnly);
             if(catsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + categoriesImage;
@@ -471,8 +477,8 @@ namespace rsgis{ namespace cmds {
 
             clumpsDataset->GetRasterBand(1)->SetMetadataItem("LAYER_TYPE", "thematic");
 
-            GDALClose(clumpsDataset);
-            GDALClose(catsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(catsDataset);
         }
         catch(rsgis::RSGISException &e)
         {
@@ -490,31 +496,24 @@ namespace rsgis{ namespace cmds {
         {
             GDALAllRegister();
 
-            GDALDataset *inputDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_Update);
+            GDALDataset *inputDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_Update);
             if(inputDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + inputImage;
                 throw rsgis::RSGISImageException(message.c_str());
             }
 
-            rsgis::rastergis::RSGISRasterAttUtils attUtils;
-            GDALRasterAttributeTable *gdalATT = inputDataset->GetRasterBand(ratBand)->GetDefaultRAT();
-
-            std::string *bandNames = new std::string[1];
-            bandNames[0] = field;
+            rsgis::img::RSGISImageUtils imgUtils;
+            GDALDataset *outputDataset = imgUtils.createCopy(inputDataset, 1, outputFile, imageFormat, RSGIS_to_GDAL_Type(outDataType));
+            outputDataset->GetRasterBand(1)->SetDescription(field.c_str());
 
-            // Get column intex in RAT
-            unsigned int columnIndex = attUtils.findColumnIndex(gdalATT, field);
+            std::vector<std::string> columns;
+            columns.push_back(field);
+            rsgis::rastergis::RSGISRATLUTImage lutImage;
+            lutImage.exportColumns(inputDataset, ratBand, columns, outputDataset);
 
-            rsgis::rastergis::RSGISExportColumns2ImageCalcImage *calcImageVal = new rsgis::rastergis::RSGISExportColumns2ImageCalcImage(1, gdalATT, columnIndex);
-            rsgis::img::RSGISCalcImage calcImage(calcImageVal);
-
-            calcImage.calcImage(&inputDataset, 1, 0, outputFile, true, bandNames, imageFormat, RSGIS_to_GDAL_Type(outDataType));
-
-            delete calcImageVal;
-            delete[] bandNames;
-
-            GDALClose(inputDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(outputDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(inputDataset);
         }
         catch(rsgis::RSGISException &e)
         {
@@ -531,7 +530,7 @@ namespace rsgis{ namespace cmds {
         GDALDataset *inputDataset;
 
         try {
-            inputDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_Update);
+            inputDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_Update);
             if(inputDataset == NULL) {
                 std::string message = std::string("Could not open image ") + inputImage;
                 throw rsgis::RSGISImageException(message.c_str());
@@ -540,7 +539,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISCalcEucDistanceInAttTable calcDist;
             calcDist.calcEucDist(inputDataset, fid, outputField, fields);
 
-            GDALClose(inputDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(inputDataset);
         } catch(rsgis::RSGISException &e) {
             throw RSGISCmdException(e.what());
         }
@@ -551,7 +550,7 @@ namespace rsgis{ namespace cmds {
         GDALDataset *inputDataset;
 
         try {
-            inputDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_Update);
+            inputDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_Update);
 
             if(inputDataset == NULL) {
                 std::string message = std::string("Could not open image ") + inputImage;
@@ -561,7 +560,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISFindTopNWithinDist calcTopN;
             calcTopN.calcMinDistTopN(inputDataset, spatialDistField, distanceField, outputField, nFeatures, distThreshold);
 
-            GDALClose(inputDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(inputDataset);
         } catch(rsgis::RSGISException &e) {
             throw RSGISCmdException(e.what());
         }
@@ -572,7 +571,7 @@ namespace rsgis{ namespace cmds {
         GDALDataset *inputDataset;
 
         try {
-            inputDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_Update);
+            inputDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_Update);
 
             if(inputDataset == NULL) {
                 std::string message = std::string("Could not open image ") + inputImage;
@@ -582,7 +581,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISFindClosestSpecSpatialFeats findFeats;
             findFeats.calcFeatsWithinSpatSpecThresholds(inputDataset, spatialDistField, distanceField, outputField, specDistThreshold, distThreshold);
 
-            GDALClose(inputDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(inputDataset);
         } catch(rsgis::RSGISException &e) {
             throw RSGISCmdException(e.what());
         }
@@ -596,7 +595,7 @@ namespace rsgis{ namespace cmds {
 
         try
         {
-            clumpsDataset = (GDALDataset *) GDALOpen(inClumpsImage.c_str(), GA_Update);
+            clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(inClumpsImage, GA_Update);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + inClumpsImage;
@@ -664,7 +663,7 @@ namespace rsgis{ namespace cmds {
             applyKNN.applyKNNExtrapolation(clumpsDataset, inExtrapField, outExtrapField, trainRegionsField, applyRegionsField, useApplyField, fields, kFeatures, distKNN, distThreshold, summeriseKNN, ratBand);
             std::cout << "Completed KNN\n";
             
-            GDALClose(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
         }
         catch(rsgis::RSGISException &e)
         {
@@ -687,7 +686,7 @@ namespace rsgis{ namespace cmds {
         GDALDataset *inputDataset;
 
         try {
-            inputDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_Update);
+            inputDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_Update);
 
             if(inputDataset == NULL) {
                 std::string message = std::string("Could not open image ") + inputImage;
@@ -697,7 +696,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISRasterAttUtils attUtils;
             attUtils.exportColumns2ASCII(inputDataset, outputFile, fields);
 
-            GDALClose(inputDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(inputDataset);
         }
         catch(rsgis::RSGISException &e) {
             throw RSGISCmdException(e.what());
@@ -709,7 +708,7 @@ namespace rsgis{ namespace cmds {
         GDALDataset *inputDataset;
 
         try {
-            inputDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_Update);
+            inputDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_Update);
 
             if(inputDataset == NULL) {
                 std::string message = std::string("Could not open image ") + inputImage;
@@ -719,7 +718,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISRasterAttUtils attUtils;
             attUtils.translateClasses(inputDataset, classInField, classOutField, classPairs);
 
-            GDALClose(inputDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(inputDataset);
         } catch(rsgis::RSGISException &e) {
             throw RSGISCmdException(e.what());
         }
@@ -732,7 +731,7 @@ namespace rsgis{ namespace cmds {
 
         try
         {
-            inputDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_Update);
+            inputDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_Update);
 
             if(inputDataset == NULL)
             {
@@ -756,7 +755,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISRasterAttUtils attUtils;
             attUtils.applyClassColours(inputDataset, classInField, ccPairs, ratBand);
 
-            GDALClose(inputDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(inputDataset);
         }
         catch(rsgis::RSGISException &e)
         {
@@ -770,7 +769,7 @@ namespace rsgis{ namespace cmds {
         GDALDataset *inputDataset;
         try
         {
-            inputDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_Update);
+            inputDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_Update);
 
             if(inputDataset == NULL)
             {
@@ -793,7 +792,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISRasterAttUtils attUtils;
             attUtils.applyClassStrColours(inputDataset, classInField, ccPairs, ratBand);
 
-            GDALClose(inputDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(inputDataset);
         }
         catch(rsgis::RSGISException &e)
         {
@@ -805,13 +804,13 @@ namespace rsgis{ namespace cmds {
         GDALAllRegister();
         GDALDataset *inputDataset, *clumpsDataset;
         try {
-            inputDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_Update);
+            inputDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_Update);
             if(inputDataset == NULL) {
                 std::string message = std::string("Could not open image ") + inputImage;
                 throw rsgis::RSGISImageException(message.c_str());
             }
 
-            clumpsDataset = (GDALDataset *) GDALOpenShared(clumpsImage.c_str(), GA_Update);
+            clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL) {
                 std::string message = std::string("Could not open image ") + clumpsImage;
                 throw rsgis::RSGISImageException(message.c_str());
@@ -822,8 +821,8 @@ namespace rsgis{ namespace cmds {
 
             clumpsDataset->GetRasterBand(1)->SetMetadataItem("LAYER_TYPE", "thematic");
 
-            GDALClose(inputDataset);
-            GDALClose(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(inputDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
         } catch (rsgis::RSGISException &e) {
             throw e;
         }
@@ -837,14 +836,14 @@ namespace rsgis{ namespace cmds {
         GDALDataset *baseSegDataset, *infoSegDataset;
         try
         {
-            baseSegDataset = (GDALDataset *) GDALOpen(baseSegment.c_str(), GA_Update);
+            baseSegDataset = rsgis::img::RSGISDatasetCache::openDataset(baseSegment, GA_Update);
             if(baseSegDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + baseSegment;
                 throw rsgis::RSGISImageException(message.c_str());
             }
 
-            infoSegDataset = (GDALDataset *) GDALOpen(infoSegment.c_str(), GA_Update);
+            infoSegDataset = rsgis::img::RSGISDatasetCache::openDataset(infoSegment, GA_Update);
             if(infoSegDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + infoSegment;
@@ -854,8 +853,8 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISFindInfoBetweenLayers findClassMajority;
             findClassMajority.findClassMajority(baseSegDataset, infoSegDataset, baseClassCol, infoClassCol, ignoreZero, baseRatBand, infoRatBand);
 
-            GDALClose(baseSegDataset);
-            GDALClose(infoSegDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(baseSegDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(infoSegDataset);
         }
         catch(rsgis::RSGISException &e)
         {
@@ -868,7 +867,7 @@ namespace rsgis{ namespace cmds {
         GDALAllRegister();
         GDALDataset *inputDataset;
         try {
-            inputDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_Update);
+            inputDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_Update);
             if(inputDataset == NULL) {
                 std::string message = std::string("Could not open image ") + inputImage;
                 throw rsgis::RSGISImageException(message.c_str());
@@ -879,7 +878,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISFindClosestSpecSpatialFeats findFeats;
             findFeats.applyMajorityClassifier(inputDataset, inClassNameField, outClassNameField, trainingSelectCol, eastingsField, northingsField, areaField, majWeightField, fields, distThreshold, specDistThreshold, distThresMethod, specThresOriginDist);
 
-            GDALClose(inputDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(inputDataset);
         } catch(rsgis::RSGISException &e) {
             throw RSGISCmdException(e.what());
         }
@@ -892,7 +891,7 @@ namespace rsgis{ namespace cmds {
         std::vector<float> priors;
         try
         {
-            inputDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_Update);
+            inputDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_Update);
 
             if(inputDataset == NULL) {
                 std::string message = std::string("Could not open image ") + inputImage;
@@ -916,7 +915,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISMaxLikelihoodRATClassification mlRat;
             mlRat.applyMLClassifier(inputDataset, inClassNameField, outClassNameField, trainingSelectCol, classifySelectCol, areaField, fields, priMeth, priors);
 
-            GDALClose(inputDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(inputDataset);
         } catch(rsgis::RSGISException &e) {
             throw RSGISCmdException(e.what());
         }
@@ -928,7 +927,7 @@ namespace rsgis{ namespace cmds {
         GDALAllRegister();
         GDALDataset *inputDataset;
         try {
-            inputDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_Update);
+            inputDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_Update);
             if(inputDataset == NULL) {
                 std::string message = std::string("Could not open image ") + inputImage;
                 throw rsgis::RSGISImageException(message.c_str());
@@ -941,7 +940,7 @@ namespace rsgis{ namespace cmds {
             mlRat.applyMLClassifierLocalPriors(inputDataset, inClassNameField, outClassNameField, trainingSelectCol, classifySelectCol, areaField,
                     fields, eastingsField, northingsField, distThreshold, priMeth, weightA, allowZeroPriors, forceChangeInClassification);
 
-            GDALClose(inputDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(inputDataset);
         } catch(rsgis::RSGISException &e) {
             throw RSGISCmdException(e.what());
         }
@@ -951,7 +950,7 @@ namespace rsgis{ namespace cmds {
         GDALAllRegister();
         GDALDataset *inputDataset;
         try {
-            inputDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_Update);
+            inputDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_Update);
             if(inputDataset == NULL) {
                 std::string message = std::string("Could not open image ") + inputImage;
                 throw rsgis::RSGISImageException(message.c_str());
@@ -973,7 +972,7 @@ namespace rsgis{ namespace cmds {
             delete calcImageVal;
             delete[] bandNames;
 
-            GDALClose(inputDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(inputDataset);
         } catch(rsgis::RSGISException &e) {
             throw RSGISCmdException(e.what());
         }
@@ -986,7 +985,7 @@ namespace rsgis{ namespace cmds {
         try
         {
             std::cout << "Opening Dataset " << inputImage << std::endl;
-            inputDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_Update);
+            inputDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_Update);
             if(inputDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + inputImage;
@@ -996,7 +995,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISFindClumpNeighbours findNeighboursObj;
             findNeighboursObj.findNeighboursKEAImageCalc(inputDataset, ratBand);
 
-            GDALClose(inputDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(inputDataset);
         }
         catch(rsgis::RSGISException &e)
         {
@@ -1010,7 +1009,7 @@ namespace rsgis{ namespace cmds {
         GDALDataset *inputDataset;
         try
         {
-            inputDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_Update);
+            inputDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_Update);
             if(inputDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + inputImage;
@@ -1022,7 +1021,7 @@ namespace rsgis{ namespace cmds {
 
             imgCalc.calcImageWindowData(&inputDataset, 1, outputFile, 3, imageFormat, GDT_Byte);
 
-            GDALClose(inputDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(inputDataset);
             delete findBoundaries;
         }
         catch(rsgis::RSGISException &e)
@@ -1037,7 +1036,7 @@ namespace rsgis{ namespace cmds {
         GDALDataset *inputDataset;
         try
         {
-            inputDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_Update);
+            inputDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_Update);
             if(inputDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + inputImage;
@@ -1047,7 +1046,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISClumpBorders clumpBorders;
             clumpBorders.calcClumpBorderLength(inputDataset, !ignoreZeroEdges, outColsName);
 
-            GDALClose(inputDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(inputDataset);
         }
         catch(rsgis::RSGISException &e)
         {
@@ -1056,13 +1055,71 @@ namespace rsgis{ namespace cmds {
 
     }
 
+    void executeCalcClumpGeometry(std::string inputImage, unsigned int ratBand, bool ignoreZeroEdges)
+    {
+        GDALAllRegister();
+        try
+        {
+            GDALDataset *inputDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_Update);
+            if(inputDataset == NULL)
+            {
+                std::string message = std::string("Could not open image ") + inputImage;
+                throw rsgis::RSGISImageException(message.c_str());
+            }
+
+            rsgis::rastergis::RSGISClumpGeometryCols cols;
+            cols.pxlCountCol = "PxlCount";
+            cols.eastCol = "Eastings";
+            cols.northCol = "Northings";
+            cols.minXPxlCol = "MinXPxl";
+            cols.maxXPxlCol = "MaxXPxl";
+            cols.minYPxlCol = "MinYPxl";
+            cols.maxYPxlCol = "MaxYPxl";
+            cols.minXColX = "MinXX";
+            cols.minXColY = "MinXY";
+            cols.maxXColX = "MaxXX";
+            cols.maxXColY = "MaxXY";
+            cols.minYColX = "MinYX";
+            cols.minYColY = "MinYY";
+            cols.maxYColX = "MaxYX";
+            cols.maxYColY = "MaxYY";
+            cols.perimeterCol = "Perimeter";
+            cols.borderLenCol = "BorderLength";
+            cols.borderIncludeZeroEdges = !ignoreZeroEdges;
+            cols.majorAxisCol = "MajorAxisLen";
+            cols.minorAxisCol = "MinorAxisLen";
+            cols.orientationCol = "Orientation";
+            cols.eccentricityCol = "Eccentricity";
+            cols.compactnessCol = "Compactness";
+            cols.contourLenCol = "ContourLength";
+            cols.boundaryPxlsCol = "BoundaryPxls";
+            cols.circularityCol = "Circularity";
+            cols.elongationCol = "Elongation";
+            cols.rectangularityCol = "Rectangularity";
+
+            rsgis::rastergis::RSGISClumpGeometry clumpGeom;
+            clumpGeom.calcGeometry(inputDataset, ratBand);
+            clumpGeom.writeToRAT(inputDataset, ratBand, &cols);
+
+            rsgis::img::RSGISDatasetCache::closeDataset(inputDataset);
+        }
+        catch(rsgis::RSGISException &e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+        catch(std::exception &e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+    }
+
     void executeCalcRelBorder(std::string inputImage, std::string outColsName, std::string classNameField, std::string className, bool ignoreZeroEdges)
     {
         GDALAllRegister();
         GDALDataset *inputDataset;
         try
         {
-            inputDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_Update);
+            inputDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_Update);
             if(inputDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + inputImage;
@@ -1072,7 +1129,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISClumpBorders clumpBorders;
             clumpBorders.calcClumpRelBorderLen2Class(inputDataset, !ignoreZeroEdges, outColsName, classNameField, className);
 
-            GDALClose(inputDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(inputDataset);
         }
         catch(rsgis::RSGISException &e)
         {
@@ -1085,7 +1142,7 @@ namespace rsgis{ namespace cmds {
         GDALDataset *inputDataset;
         try
         {
-            inputDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_Update);
+            inputDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_Update);
             if(inputDataset == NULL) {
                 std::string message = std::string("Could not open image ") + inputImage;
                 throw rsgis::RSGISImageException(message.c_str());
@@ -1114,7 +1171,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISCalcClumpShapeParameters calcShapeParams;
             calcShapeParams.calcClumpShapeParams(inputDataset, &shapes);
 
-            GDALClose(inputDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(inputDataset);
             delete[] shapeStore;
         }
         catch(rsgis::RSGISException &e) {
@@ -1127,13 +1184,13 @@ namespace rsgis{ namespace cmds {
         GDALAllRegister();
         GDALDataset *clumpsDataset, *tileDataset;
         try {
-            clumpsDataset = (GDALDataset *) GDALOpen(clumpsImage.c_str(), GA_Update);
+            clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL) {
                 std::string message = std::string("Could not open image ") + clumpsImage;
                 throw rsgis::RSGISImageException(message.c_str());
             }
 
-            tileDataset = (GDALDataset *) GDALOpen(tileImage.c_str(), GA_ReadOnly);
+            tileDataset = rsgis::img::RSGISDatasetCache::openDataset(tileImage, GA_ReadOnly);
             if(tileDataset == NULL) {
                 std::string message = std::string("Could not open image ") + tileImage;
                 throw rsgis::RSGISImageException(message.c_str());
@@ -1142,8 +1199,8 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISDefineClumpsInTiles defineSegsInTile;
             defineSegsInTile.defineSegmentTilePos(clumpsDataset, tileDataset, outColsName, tileOverlap, tileBoundary, tileBody);
 
-            GDALClose(clumpsDataset);
-            GDALClose(tileDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(tileDataset);
         } catch(rsgis::RSGISException &e) {
             throw RSGISCmdException(e.what());
         }
@@ -1155,7 +1212,7 @@ namespace rsgis{ namespace cmds {
 
         try
         {
-            GDALDataset *clumpsDataset = (GDALDataset *) GDALOpen(clumpsImage.c_str(), GA_Update);
+            GDALDataset *clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
@@ -1165,7 +1222,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISDefineClumpsInTiles defineSegsInTile;
             defineSegsInTile.defineBorderSegments(clumpsDataset, outColsName);
 
-            GDALClose(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
         }
         catch(rsgis::RSGISException &e)
         {
@@ -1179,7 +1236,7 @@ namespace rsgis{ namespace cmds {
         {
             std::cout << "Opening RAT" << std::endl;
             GDALAllRegister();
-            GDALDataset *clumpsDataset = (GDALDataset *) GDALOpen(clumpsImage.c_str(), GA_Update);
+            GDALDataset *clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
@@ -1233,7 +1290,7 @@ namespace rsgis{ namespace cmds {
             ratCalc->calcRATValues(ratCalcVal->attTable, inRealColIdx, inIntColIdx, inStrColIdx, outRealColIdx, outIntColIdx, outStrColIdx);
 
             // Close GDAL Dataset
-            GDALClose(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
 
             // Tidy up
             for(std::vector<rastergis::RSGISClassChangeFields*>::iterator classIter = classFields->begin(); classIter != classFields->end(); ++classIter)
@@ -1257,7 +1314,7 @@ namespace rsgis{ namespace cmds {
         {
             std::cout << "Opening RAT" << std::endl;
             GDALAllRegister();
-            GDALDataset *clumpsDataset = (GDALDataset *) GDALOpen(clumpsImage.c_str(), GA_Update);
+            GDALDataset *clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
@@ -1312,7 +1369,7 @@ namespace rsgis{ namespace cmds {
             clumpsDataset->GetRasterBand(ratBand)->SetDefaultRAT(ratCalcVal->attTable);
 
             // Close GDAL Dataset
-            GDALClose(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
 
             // Tidy up
             for(std::vector<rastergis::RSGISClassChangeFields*>::iterator classIter = classFields->begin(); classIter != classFields->end(); ++classIter)
@@ -1355,7 +1412,7 @@ namespace rsgis{ namespace cmds {
                 throw rsgis::RSGISAttributeTableException("Method was not recognised. Must be \'min\', \'max\' or \'mean\'.");
             }
 
-            clumpsDataset = (GDALDataset *) GDALOpen(clumpsImage.c_str(), GA_Update);
+            clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
@@ -1365,7 +1422,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISSelectClumpsOnGrid selectClumps;
             selectClumps.selectClumpsOnGrid(clumpsDataset, inSelectField, outSelectField, eastingsCol, northingsCol, metricField, rows, cols, method);
 
-            GDALClose(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
         }
         catch(rsgis::RSGISAttributeTableException &e)
         {
@@ -1407,6 +1464,10 @@ namespace rsgis{ namespace cmds {
             {
                 interpolator = new rsgis::math::RSGISAllPointsIDWInterpolator(8);
             }
+            else if(methodStr == "idwknn")
+            {
+                interpolator = new rsgis::math::RSGISKNearestIDW2DInterpolator(12, 8);
+            }
             else if(methodStr == "plane")
             {
                 interpolator = new rsgis::math::RSGISLinearTrendInterpolator();
@@ -1421,11 +1482,11 @@ namespace rsgis{ namespace cmds {
             }
             else
             {
-                std::cerr << "Available Interpolators: \'nearestneighbour\', \'naturalneighbour\', \'naturalnearestneighbour\', \'knearestneighbour\', \'idwall\'\n";
+                std::cerr << "Available Interpolators: \'nearestneighbour\', \'naturalneighbour\', \'naturalnearestneighbour\', \'knearestneighbour\', \'idwall\', \'idwknn\'\n";
                 throw rsgis::RSGISAttributeTableException("The interpolated specified was not recognised.");
             }
 
-            clumpsDataset = (GDALDataset *) GDALOpen(clumpsImage.c_str(), GA_ReadOnly);
+            clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_ReadOnly);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
@@ -1437,7 +1498,7 @@ namespace rsgis{ namespace cmds {
 
             delete interpolator;
 
-            GDALClose(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
         }
         catch(rsgis::RSGISAttributeTableException &e)
         {
@@ -1464,14 +1525,14 @@ namespace rsgis{ namespace cmds {
             std::cout.precision(12);
             rsgis::utils::RSGISTextUtils txtUtils;
 
-            clumpsDataset = (GDALDataset *) GDALOpen(clumpsImage.c_str(), GA_Update);
+            clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
                 throw rsgis::RSGISImageException(message.c_str());
             }
 
-            inputImageDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_ReadOnly);
+            inputImageDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_ReadOnly);
             if(inputImageDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + inputImage;
@@ -1544,8 +1605,8 @@ namespace rsgis{ namespace cmds {
             }
             delete scoreComponents;
 
-            GDALClose(clumpsDataset);
-            GDALClose(inputImageDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(inputImageDataset);
         }
         catch(rsgis::RSGISAttributeTableException &e)
         {
@@ -1568,7 +1629,7 @@ namespace rsgis{ namespace cmds {
             GDALAllRegister();
             std::cout.precision(12);
             
-            GDALDataset *clumpsDataset = (GDALDataset *) GDALOpen(clumpsImage.c_str(), GA_Update);
+            GDALDataset *clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
@@ -1594,7 +1655,7 @@ namespace rsgis{ namespace cmds {
             delete fieldStatsCmds;
             delete fieldStats;
                 
-            GDALClose(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
         }
         catch(rsgis::RSGISAttributeTableException &e)
         {
@@ -1613,7 +1674,7 @@ namespace rsgis{ namespace cmds {
             GDALAllRegister();
             std::cout.precision(12);
             
-            GDALDataset *clumpsDataset = (GDALDataset *) GDALOpen(clumpsImage.c_str(), GA_Update);
+            GDALDataset *clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
@@ -1623,7 +1684,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISClumpRegionGrowing growClumpRegions;
             growClumpRegions.growClassRegion(clumpsDataset, classColumn, classVal, maxIter, ratBand, xmlBlock);
             
-            GDALClose(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
         }
         catch(rsgis::RSGISAttributeTableException &e)
         {
@@ -1642,7 +1703,7 @@ namespace rsgis{ namespace cmds {
             GDALAllRegister();
             std::cout.precision(12);
             
-            GDALDataset *clumpsDataset = (GDALDataset *) GDALOpen(clumpsImage.c_str(), GA_Update);
+            GDALDataset *clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
@@ -1652,7 +1713,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISBinaryClassifyClumps classClumps;
             classClumps.classifyClumps(clumpsDataset, ratBand, xmlBlock, outColumn);
             
-            GDALClose(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
         }
         catch(rsgis::RSGISAttributeTableException &e)
         {
@@ -1670,19 +1731,19 @@ namespace rsgis{ namespace cmds {
         {
             GDALAllRegister();
             
-            GDALDataset *clumpsDataset = (GDALDataset *) GDALOpenShared(clumpsImage.c_str(), GA_Update);
+            GDALDataset *clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
                 throw rsgis::RSGISImageException(message.c_str());
             }
-            GDALDataset *imageDataset = (GDALDataset *) GDALOpenShared(inputImage.c_str(), GA_ReadOnly);
+            GDALDataset *imageDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_ReadOnly);
             if(imageDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + inputImage;
                 throw rsgis::RSGISImageException(message.c_str());
             }
-            GDALDataset *imageMeanLitDataset = (GDALDataset *) GDALOpenShared(inputMeanLitImage.c_str(), GA_ReadOnly);
+            GDALDataset *imageMeanLitDataset = rsgis::img::RSGISDatasetCache::openDataset(inputMeanLitImage, GA_ReadOnly);
             if(imageMeanLitDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + inputMeanLitImage;
@@ -1726,9 +1787,9 @@ namespace rsgis{ namespace cmds {
             
             clumpsDataset->GetRasterBand(ratBand)->SetMetadataItem("LAYER_TYPE", "thematic");
             
-            GDALClose(clumpsDataset);
-            GDALClose(imageDataset);
-            GDALClose(imageMeanLitDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(imageDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(imageMeanLitDataset);
         }
         catch(rsgis::RSGISException &e)
         {
@@ -1746,7 +1807,7 @@ namespace rsgis{ namespace cmds {
         {
             GDALAllRegister();
             
-            GDALDataset *clumpsDataset = (GDALDataset *) GDALOpenShared(clumpsImage.c_str(), GA_ReadOnly);
+            GDALDataset *clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_ReadOnly);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
@@ -1756,7 +1817,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISCollapseRAT collapseRat = rsgis::rastergis::RSGISCollapseRAT();
             collapseRat.classifyClumps(clumpsDataset, ratBand, selectColumn, outImage, gdalFormat);
             
-            GDALClose(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
         }
         catch(rsgis::RSGISException &e)
         {
@@ -1780,7 +1841,7 @@ namespace rsgis{ namespace cmds {
             GDALAllRegister();
             OGRRegisterAll();
             
-            GDALDataset *clumpsDataset = (GDALDataset *) GDALOpenShared(clumpsImage.c_str(), GA_Update);
+            GDALDataset *clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
@@ -1818,7 +1879,7 @@ namespace rsgis{ namespace cmds {
             copyShpAtts2RAT.copyVectorAtt2Rat(clumpsDataset, ratBand, inputVecLyr, fidColStr, colNames);
             
             delete colNames;
-            GDALClose(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
             GDALClose(inputVecDS);
         }
         catch(rsgis::RSGISException &e)
@@ -1838,7 +1899,7 @@ namespace rsgis{ namespace cmds {
             GDALAllRegister();
             std::cout.precision(12);
             
-            GDALDataset *clumpsDataset = (GDALDataset *) GDALOpen(clumpsImage.c_str(), GA_Update);
+            GDALDataset *clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
@@ -1848,7 +1909,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISClumpRegionGrowing growClumpRegions;
             growClumpRegions.growClassRegionNeighCriteria(clumpsDataset, classColumn, classVal, maxIter, ratBand, xmlBlockGrowCriteria, xmlBlockNeighCriteria);
             
-            GDALClose(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
         }
         catch(rsgis::RSGISAttributeTableException &e)
         {
@@ -1873,7 +1934,7 @@ namespace rsgis{ namespace cmds {
             GDALAllRegister();
             std::cout.precision(12);
             
-            GDALDataset *clumpsDataset = (GDALDataset *) GDALOpen(clumpsImage.c_str(), GA_Update);
+            GDALDataset *clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
@@ -1883,7 +1944,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISStatsSamplingClumps statsSampling;
             statsSampling.histogramSampling(clumpsDataset, varCol, outSelectCol, propOfSample, binWidth, classRestrict, classColumn, classVal, ratBand);
             
-            GDALClose(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
         }
         catch(rsgis::RSGISAttributeTableException &e)
         {
@@ -1903,7 +1964,7 @@ namespace rsgis{ namespace cmds {
             GDALAllRegister();
             std::cout.precision(12);
             
-            GDALDataset *clumpsDataset = (GDALDataset *) GDALOpen(clumpsImage.c_str(), GA_Update);
+            GDALDataset *clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
@@ -1913,7 +1974,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISFitHistGausianMixtureModel fitGauModel;
             fitGauModel.performFit(clumpsDataset, outH5File, varCol, binWidth, classColumn, classVal, outputHist, outHistFile);
             
-            GDALClose(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
         }
         catch(rsgis::RSGISAttributeTableException &e)
         {
@@ -1932,7 +1993,7 @@ namespace rsgis{ namespace cmds {
             GDALAllRegister();
             std::cout.precision(12);
             
-            GDALDataset *clumpsDataset = (GDALDataset *) GDALOpen(clumpsImage.c_str(), GA_Update);
+            GDALDataset *clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
@@ -1942,7 +2003,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISSelectClumpsGMMSplit classGMMSampling;
             classGMMSampling.splitClassUsingGMM(clumpsDataset, outColumn, varCol, binWidth, classColumn, classVal, ratBand);
             
-            GDALClose(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
         }
         catch(rsgis::RSGISAttributeTableException &e)
         {
@@ -1962,7 +2023,7 @@ namespace rsgis{ namespace cmds {
             std::cout.precision(12);
             
             std::cout << "Opening Clumps Image: " << clumpsImage << std::endl;
-            GDALDataset *clumpsDataset = (GDALDataset *) GDALOpen(clumpsImage.c_str(), GA_Update);
+            GDALDataset *clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
@@ -1970,7 +2031,7 @@ namespace rsgis{ namespace cmds {
             }
             
             std::cout << "Opening Input Image: " << inputImage << std::endl;
-            GDALDataset *inDataset = (GDALDataset *) GDALOpenShared(inputImage.c_str(), GA_ReadOnly);
+            GDALDataset *inDataset = rsgis::img::RSGISDatasetCache::openDataset(inputImage, GA_ReadOnly);
             if(inDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + inputImage;
@@ -1982,8 +2043,8 @@ namespace rsgis{ namespace cmds {
             
             clumpsDataset->GetRasterBand(ratBand)->SetMetadataItem("LAYER_TYPE", "thematic");
             
-            GDALClose(clumpsDataset);
-            GDALClose(inDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(inDataset);
         }
         catch(rsgis::RSGISAttributeTableException &e)
         {
@@ -2006,7 +2067,7 @@ namespace rsgis{ namespace cmds {
             std::cout.precision(12);
             
             std::cout << "Opening Clumps Image: " << clumpsImage << std::endl;
-            GDALDataset *clumpsDataset = (GDALDataset *) GDALOpen(clumpsImage.c_str(), GA_Update);
+            GDALDataset *clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
@@ -2016,7 +2077,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISRATStats calcRATStats;
             dist = calcRATStats.calc1DJMDistance(clumpsDataset, varCol, binWidth, classColumn, class1Val, class2Val, ratBand);
             
-            GDALClose(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
         }
         catch(rsgis::RSGISAttributeTableException &e)
         {
@@ -2039,7 +2100,7 @@ namespace rsgis{ namespace cmds {
             std::cout.precision(12);
             
             std::cout << "Opening Clumps Image: " << clumpsImage << std::endl;
-            GDALDataset *clumpsDataset = (GDALDataset *) GDALOpen(clumpsImage.c_str(), GA_Update);
+            GDALDataset *clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
@@ -2049,7 +2110,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISRATStats calcRATStats;
             dist =  calcRATStats.calc2DJMDistance(clumpsDataset, var1Col, var2Col, var1binWidth, var2binWidth, classColumn, class1Val, class2Val, ratBand);
 
-            GDALClose(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
         }
         catch(rsgis::RSGISAttributeTableException &e)
         {
@@ -2072,7 +2133,7 @@ namespace rsgis{ namespace cmds {
             std::cout.precision(12);
             
             std::cout << "Opening Clumps Image: " << clumpsImage << std::endl;
-            GDALDataset *clumpsDataset = (GDALDataset *) GDALOpen(clumpsImage.c_str(), GA_Update);
+            GDALDataset *clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
@@ -2082,7 +2143,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISRATStats calcRATStats;
             dist = calcRATStats.calcBhattacharyyaDistance(clumpsDataset, varCol, classColumn, class1Val, class2Val, ratBand);
             
-            GDALClose(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
         }
         catch(rsgis::RSGISAttributeTableException &e)
         {
@@ -2105,7 +2166,7 @@ namespace rsgis{ namespace cmds {
             std::cout.precision(12);
             
             std::cout << "Opening Clumps Image: " << clumpsImage << std::endl;
-            GDALDataset *clumpsDataset = (GDALDataset *) GDALOpen(clumpsImage.c_str(), GA_Update);
+            GDALDataset *clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_Update);
             if(clumpsDataset == NULL)
             {
                 std::string message = std::string("Could not open image ") + clumpsImage;
@@ -2119,7 +2180,7 @@ namespace rsgis{ namespace cmds {
             rsgis::rastergis::RSGISExportClumps2Images exportClumps;
             exportClumps.exportClumps2Images(clumpsDataset, outImgBase, imgFileExt, imageFormat, binaryOut, "MinXPxl", "MaxXPxl", "MinYPxl", "MaxYPxl", "MinXX", "MaxYY", ratBand);
             
-            GDALClose(clumpsDataset);
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
         }
         catch(rsgis::RSGISAttributeTableException &e)
         {
@@ -2130,6 +2191,113 @@ namespace rsgis{ namespace cmds {
             throw RSGISCmdException(e.what());
         }
     }
+    
+    template <typename T> static void ratColumnRangeIO(std::string clumpsImage, std::string column, size_t startRow, size_t nRows, T *data, unsigned int ratBand, bool write)
+    {
+        GDALDataset *clumpsDataset = NULL;
+        try
+        {
+            GDALAllRegister();
+            clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, write?GA_Update:GA_ReadOnly);
+            if(clumpsDataset == NULL)
+            {
+                std::string message = std::string("Could not open image ") + clumpsImage;
+                throw rsgis::RSGISImageException(message.c_str());
+            }
+            if((ratBand == 0) || (ratBand > ((unsigned int)clumpsDataset->GetRasterCount())))
+            {
+                throw rsgis::RSGISAttributeTableException("RAT Band is not within the image.");
+            }
+            GDALRasterAttributeTable *attTable = clumpsDataset->GetRasterBand(ratBand)->GetDefaultRAT();
+            if(attTable == NULL)
+            {
+                throw rsgis::RSGISAttributeTableException("The image does not have a raster attribute table.");
+            }
             
+            rsgis::rastergis::RSGISRasterAttUtils attUtils;
+            if(write)
+            {
+                attUtils.writeColumnRange(attTable, column, startRow, nRows, data);
+            }
+            else
+            {
+                attUtils.readColumnRange(attTable, column, startRow, nRows, data);
+            }
+            
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
+        }
+        catch(rsgis::RSGISAttributeTableException &e)
+        {
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
+            throw RSGISCmdException(e.what());
+        }
+        catch (rsgis::RSGISException &e)
+        {
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
+            throw RSGISCmdException(e.what());
+        }
+    }
+    
+    void executeGetRATColumnInfo(std::string clumpsImage, std::string column, size_t *nRows, bool *isInt, unsigned int ratBand)
+    {
+        GDALDataset *clumpsDataset = NULL;
+        try
+        {
+            GDALAllRegister();
+            clumpsDataset = rsgis::img::RSGISDatasetCache::openDataset(clumpsImage, GA_ReadOnly);
+            if(clumpsDataset == NULL)
+            {
+                std::string message = std::string("Could not open image ") + clumpsImage;
+                throw rsgis::RSGISImageException(message.c_str());
+            }
+            if((ratBand == 0) || (ratBand > ((unsigned int)clumpsDataset->GetRasterCount())))
+            {
+                throw rsgis::RSGISAttributeTableException("RAT Band is not within the image.");
+            }
+            GDALRasterAttributeTable *attTable = clumpsDataset->GetRasterBand(ratBand)->GetDefaultRAT();
+            if(attTable == NULL)
+            {
+                throw rsgis::RSGISAttributeTableException("The image does not have a raster attribute table.");
+            }
+            
+            rsgis::rastergis::RSGISRasterAttUtils attUtils;
+            unsigned int colIdx = attUtils.findColumnIndex(attTable, column);
+            *nRows = attTable->GetRowCount();
+            *isInt = (attTable->GetTypeOfCol(colIdx) == GFT_Integer);
+            
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
+        }
+        catch(rsgis::RSGISAttributeTableException &e)
+        {
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
+            throw RSGISCmdException(e.what());
+        }
+        catch (rsgis::RSGISException &e)
+        {
+            rsgis::img::RSGISDatasetCache::closeDataset(clumpsDataset);
+            throw RSGISCmdException(e.what());
+        }
+    }
+    
+    void executeReadRATColumn(std::string clumpsImage, std::string column, size_t startRow, size_t nRows, double *data, unsigned int ratBand)
+    {
+        ratColumnRangeIO<double>(clumpsImage, column, startRow, nRows, data, ratBand, false);
+    }
+    
+    void executeReadRATColumn(std::string clumpsImage, std::string column, size_t startRow, size_t nRows, int *data, unsigned int ratBand)
+    {
+        ratColumnRangeIO<int>(clumpsImage, column, startRow, nRows, data, ratBand, false);
+    }
+    
+    void executeWriteRATColumn(std::string clumpsImage, std::string column, size_t startRow, size_t nRows, double *data, unsigned int ratBand)
+    {
+        ratColumnRangeIO<double>(clumpsImage, column, startRow, nRows, data, ratBand, true);
+    }
+    
+    void executeWriteRATColumn(std::string clumpsImage, std::string column, size_t startRow, size_t nRows, int *data, unsigned int ratBand)
+    {
+        ratColumnRangeIO<int>(clumpsImage, column, startRow, nRows, data, ratBand, true);
+    }
+    
 }}
 
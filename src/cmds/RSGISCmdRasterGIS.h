@@ -267,6 +267,9 @@ namespace rsgis{ namespace cmds {
     /** Function to calculate the border length of the clumps */
     DllExport void executeCalcBorderLength(std::string inputImage, bool ignoreZeroEdges, std::string outColsName);
 
+    /** Function to calculate the pixel count, centroid, extents, perimeter, border length and shape of the clumps in one pass */
+    DllExport void executeCalcClumpGeometry(std::string inputImage, unsigned int ratBand, bool ignoreZeroEdges);
+
     /** Function to calculate the relative border length of the clumps to a class */
     DllExport void executeCalcRelBorder(std::string inputImage, std::string outColsName, std::string classNameField, std::string className, bool ignoreZeroEdges);
 
@@ -339,6 +342,17 @@ namespace rsgis{ namespace cmds {
     /** Function to export each clump to an individual image file */
     DllExport void executeExportClumps2Images(std::string clumpsImage, std::string outImgBase, std::string imgFileExt, std::string imageFormat, bool binaryOut, unsigned int ratBand=1);
     
+    /** Function to get the number of rows in a RAT and whether a column is an integer column */
+    DllExport void executeGetRATColumnInfo(std::string clumpsImage, std::string column, size_t *nRows, bool *isInt, unsigned int ratBand=1);
+    
+    /** Functions to read a range of rows of a RAT column straight into an array */
+    DllExport void executeReadRATColumn(std::string clumpsImage, std::string column, size_t startRow, size_t nRows, double *data, unsigned int ratBand=1);
+    DllExport void executeReadRATColumn(std::string clumpsImage, std::string column, size_t startRow, size_t nRows, int *data, unsigned int ratBand=1);
+    
+    /** Functions to write a range of rows of a RAT column from an array, the column is created if needed */
+    DllExport void executeWriteRATColumn(std::string clumpsImage, std::string column, size_t startRow, size_t nRows, double *data, unsigned int ratBand=1);
+    DllExport void executeWriteRATColumn(std::string clumpsImage, std::string column, size_t startRow, size_t nRows, int *data, unsigned int ratBand=1);
+    
     
 }}
 
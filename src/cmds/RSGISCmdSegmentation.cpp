@@ -22,6 +22,7 @@
 
 #include "RSGISCmdSegmentation.h"
 #include "RSGISCmdParent.h"
+#include "common/RSGISProfiler.h"
 
 #include "common/RSGISImageException.h"
 
@@ -30,10 +31,12 @@
 #include "img/RSGISCalcImage.h"
 #include "img/RSGISStretchImage.h"
 #include "img/RSGISImageUtils.h"
+#include "img/RSGISScratchRaster.h"
 
 #include "segmentation/RSGISLabelPixelsUsingClusters.h"
 #include "segmentation/RSGISEliminateSinglePixels.h"
 #include "segmentation/RSGISClumpPxls.h"
+#include "segmentation/RSGISSpecGroupSegmentation.h"
 #include "segmentation/RSGISEliminateSmallClumps.h"
 #include "segmentation/RSGISGenMeanSegImage.h"
 #include "segmentation/RSGISRandomColourClumps.h"
@@ -44,6 +47,8 @@
 #include "segmentation/RSGISCreateImageGrid.h"
 #include "segmentation/RSGISDropClumps.h"
 #include "segmentation/RSGISRegionGrowSegmentsPixels.h"
+#include "segmentation/RSGISHierarchicalSegmentation.h"
+#include "segmentation/RSGISTiledSegmentation.h"
 
 #include "rastergis/RSGISRasterAttUtils.h"
 #include "rastergis/RSGISCalcImageStatsAndPyramids.h"
@@ -104,27 +109,25 @@ namespace rsgis{ namespace cmds {
                 throw rsgis::RSGISImageException(message.c_str());
             }
             
-            GDALDataset *pixelMaskDataset = NULL;
-            if(processInMemory)
+            // The pixel mask is only used while eliminating so is a scratch raster,
+            // backed by a file alongside the temporary image if too large for memory.
+            std::string tempDir = "";
+            size_t dirEnd = tempImage.find_last_of("/\\");
+            if(dirEnd != std::string::npos)
             {
-                pixelMaskDataset = imgUtils.createCopy(clumpsDataset, 1, "", "MEM", GDT_Byte , true, "");
+                tempDir = tempImage.substr(0, dirEnd);
             }
-            else
-            {
-                pixelMaskDataset = imgUtils.createCopy(clumpsDataset, 1, tempImage, imageFormat, GDT_Byte, true, "");
-            }
-            
+            rsgis::img::RSGISScratchRaster pixelMask(clumpsDataset, 1, GDT_Byte, processInMemory, tempDir);
             
             std::cout << "Eliminating Individual Pixels\n";
             rsgis::segment::RSGISEliminateSinglePixels eliminate;
-            eliminate.eliminateBlocks(spectralDataset, clumpsDataset, pixelMaskDataset, outputImage, 0, ignoreZeros, true, "", imageFormat);
+            eliminate.eliminateBlocks(spectralDataset, clumpsDataset, pixelMask.getDataset(), outputImage, 0, ignoreZeros, true, "", imageFormat);
             
             clumpsDataset->GetRasterBand(1)->SetMetadataItem("LAYER_TYPE", "thematic");
             
             // Tidy up
             GDALClose(spectralDataset);
             GDALClose(clumpsDataset);
-            GDALClose(pixelMaskDataset);
         }
         catch (rsgis::RSGISException &e)
         {
@@ -136,8 +139,9 @@ namespace rsgis{ namespace cmds {
         }
     }
     
-    void executeClump(std::string inputImage, std::string outputImage, std::string imageFormat, bool processInMemory, bool noDataValProvided, float noDataVal, bool addRatPxlVals) 
+    void executeClump(std::string inputImage, std::string outputImage, std::string imageFormat, bool processInMemory, bool noDataValProvided, float noDataVal, bool addRatPxlVals, unsigned int numThreads) 
     {        
+        rsgis::RSGISProfileSummaryScope profileSummary("executeClump");
         try
         {
             GDALAllRegister();
@@ -175,7 +179,15 @@ namespace rsgis{ namespace cmds {
             
             std::cout << "Performing Clump\n";
             rsgis::segment::RSGISClumpPxls clumpImg;
-            clumpImg.performClump(catagoryDataset, resultDataset, noDataValProvided, noDataVal, clumpPxlVals);
+            if(numThreads != 1)
+            {
+                clumpImg.setNumThreads(numThreads);
+                clumpImg.performParallelClump(catagoryDataset, resultDataset, noDataValProvided, noDataVal, clumpPxlVals);
+            }
+            else
+            {
+                clumpImg.performClump(catagoryDataset, resultDataset, noDataValProvided, noDataVal, clumpPxlVals);
+            }
             
             if(processInMemory)
             {
@@ -239,7 +251,58 @@ namespace rsgis{ namespace cmds {
         }
     }
     
-    void executeRMSmallClumpsStepwise(std::string inputImage, std::string clumpsImage, std::string outputImage, std::string imageFormat, bool stretchStatsAvail, std::string stretchStatsFile, bool storeMean, bool processInMemory, unsigned int minClumpSize, float specThreshold)
+    void executeSpectralGroupClumps(std::string inputImage, std::string outputImage, std::string imageFormat, float specThreshold, bool noDataValProvided, float noDataVal, unsigned int numThreads)
+    {
+        try
+        {
+            GDALAllRegister();
+            GDALDataset *inDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_ReadOnly);
+            if(inDataset == NULL)
+            {
+                std::string message = std::string("Could not open image ") + inputImage;
+                throw rsgis::RSGISImageException(message.c_str());
+            }
+            
+            rsgis::img::RSGISImageUtils imgUtils;
+            GDALDataset *resultDataset = imgUtils.createCopy(inDataset, 1, outputImage, imageFormat, GDT_UInt32, true, "");
+            
+            try
+            {
+                std::cout << "Performing Spectral Grouping\n";
+                rsgis::segment::RSGISSpecGroupSegmentation specGroupSeg;
+                if(numThreads != 1)
+                {
+                    specGroupSeg.setNumThreads(numThreads);
+                    specGroupSeg.performParallelSimpleClump(inDataset, resultDataset, specThreshold, noDataValProvided, noDataVal);
+                }
+                else
+                {
+                    specGroupSeg.performSimpleClump(inDataset, resultDataset, specThreshold, noDataValProvided, noDataVal);
+                }
+                resultDataset->GetRasterBand(1)->SetMetadataItem("LAYER_TYPE", "thematic");
+            }
+            catch(...)
+            {
+                GDALClose(inDataset);
+                GDALClose(resultDataset);
+                throw;
+            }
+            
+            // Tidy up
+            GDALClose(inDataset);
+            GDALClose(resultDataset);
+        }
+        catch (rsgis::RSGISException &e)
+        {
+            throw rsgis::cmds::RSGISCmdException(e.what());
+        }
+        catch (std::exception &e)
+        {
+            throw rsgis::cmds::RSGISCmdException(e.what());
+        }
+    }
+    
+    void executeRMSmallClumpsStepwise(std::string inputImage, std::string clumpsImage, std::string outputImage, std::string imageFormat, bool stretchStatsAvail, std::string stretchStatsFile, bool storeMean, bool processInMemory, unsigned int minClumpSize, float specThreshold, bool usePriorityQueue)
     {
         try
         {
@@ -290,7 +353,11 @@ namespace rsgis{ namespace cmds {
             
             std::cout << "Eliminant Clumps\n";
             rsgis::segment::RSGISEliminateSmallClumps eliminate;
-            if(storeMean)
+            if(storeMean && usePriorityQueue)
+            {
+                eliminate.priorityEliminateSmallClumps(spectralDataset, resultDataset, minClumpSize, specThreshold, bandStretchStats, stretchStatsAvail);
+            }
+            else if(storeMean)
             {
                 //eliminate.stepwiseEliminateSmallClumps(spectralDataset, resultDataset, minClumpSize, specThreshold, bandStretchStats, stretchStatsAvail);
                 eliminate.stepwiseIterativeEliminateSmallClumps(spectralDataset, resultDataset, minClumpSize, specThreshold, bandStretchStats, stretchStatsAvail);
@@ -438,7 +505,7 @@ namespace rsgis{ namespace cmds {
             
             std::cout << "Calculating Mean Image\n";
             rsgis::segment::RSGISGenMeanSegImage genMeanImg;
-            genMeanImg.generateMeanImageUsingCalcImage(spectralDataset, clumpsDataset, resultDataset);
+            genMeanImg.generateMeanImageSinglePass(spectralDataset, clumpsDataset, resultDataset);
             
             if(processInMemory)
             {
@@ -465,6 +532,41 @@ namespace rsgis{ namespace cmds {
         }
     }
 
+    void executeClumpMeans2RAT(std::string inputImage, std::string clumpsImage, std::vector<std::string> colNames)
+    {
+        try
+        {
+            GDALAllRegister();
+            GDALDataset *inDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_ReadOnly);
+            if(inDataset == NULL)
+            {
+                std::string message = std::string("Could not open image ") + inputImage;
+                throw rsgis::RSGISImageException(message.c_str());
+            }
+            
+            GDALDataset *clumpsDataset = (GDALDataset *) GDALOpen(clumpsImage.c_str(), GA_Update);
+            if(clumpsDataset == NULL)
+            {
+                std::string message = std::string("Could not open image ") + clumpsImage;
+                throw rsgis::RSGISImageException(message.c_str());
+            }
+            
+            rsgis::segment::RSGISGenMeanSegImage genMeanImg;
+            genMeanImg.populateRATWithMeans(inDataset, clumpsDataset, colNames);
+            
+            GDALClose(inDataset);
+            GDALClose(clumpsDataset);
+        }
+        catch (rsgis::RSGISException &e)
+        {
+            throw rsgis::cmds::RSGISCmdException(e.what());
+        }
+        catch (std::exception &e)
+        {
+            throw rsgis::cmds::RSGISCmdException(e.what());
+        }
+    }
+
     void executeRandomColourClumps(std::string inputImage, std::string outputImage, std::string imageFormat, bool processInMemory, std::string importLUTFile, bool importLUT, std::string exportLUTFile, bool exportLUT)
     {
         try
@@ -892,17 +994,11 @@ namespace rsgis{ namespace cmds {
             rsgis::segment::RSGISMergeSegments mergeSegs;
             mergeSegs.mergeSelectedClumps(clumpDataset, spectralDataset, selectClumpsCol, noDataClumpsCol);
             
-            rsgis::rastergis::RSGISRasterAttUtils attUtils;
-            GDALRasterAttributeTable *gdalATT = clumpDataset->GetRasterBand(1)->GetDefaultRAT();
-            
-            // Get column intex in RAT
-            unsigned int columnIndex = attUtils.findColumnIndex(gdalATT, "OutClumpIDs");
-            
-            rsgis::rastergis::RSGISExportColumns2ImageCalcImage *calcImageVal = new rsgis::rastergis::RSGISExportColumns2ImageCalcImage(1, gdalATT, columnIndex);
-            rsgis::img::RSGISCalcImage calcImage(calcImageVal);
-            
-            calcImage.calcImage(&clumpDataset, 1, 0, outputImage, false, NULL, imageFormat, GDT_UInt32);
-            delete calcImageVal;
+            rsgis::img::RSGISImageUtils imgUtils;
+            GDALDataset *relabelledDS = imgUtils.createCopy(clumpDataset, 1, outputImage, imageFormat, GDT_UInt32);
+            rsgis::rastergis::RSGISRATLUTImage lutImage;
+            lutImage.exportColumns(clumpDataset, 1, std::vector<std::string>(1, "OutClumpIDs"), relabelledDS);
+            GDALClose(relabelledDS);
             
             GDALDataset *outputClumpsDS = (GDALDataset *) GDALOpen(outputImage.c_str(), GA_Update);
             if(outputClumpsDS == NULL)
@@ -959,6 +1055,97 @@ namespace rsgis{ namespace cmds {
         }
     }
             
+    void executeHierarchicalSegmentation(std::string inputImage, std::string clumpsImage, std::vector<std::string> outputImages, std::vector<unsigned int> minPxls, std::vector<float> distThresholds, std::string imageFormat)
+    {
+        try
+        {
+            if((outputImages.size() != minPxls.size()) || (outputImages.size() != distThresholds.size()))
+            {
+                throw rsgis::RSGISException("The number of output images, minimum sizes and distance thresholds must be the same.");
+            }
+            
+            GDALAllRegister();
+            GDALDataset *inDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_ReadOnly);
+            if(inDataset == NULL)
+            {
+                std::string message = std::string("Could not open image ") + inputImage;
+                throw rsgis::RSGISImageException(message.c_str());
+            }
+            
+            GDALDataset *clumpDataset = (GDALDataset *) GDALOpen(clumpsImage.c_str(), GA_ReadOnly);
+            if(clumpDataset == NULL)
+            {
+                std::string message = std::string("Could not open image ") + clumpsImage;
+                throw rsgis::RSGISImageException(message.c_str());
+            }
+            
+            rsgis::segment::RSGISHierarchicalSegmentation hierSeg;
+            hierSeg.buildMergeTree(inDataset, clumpDataset);
+            for(size_t i = 0; i < outputImages.size(); ++i)
+            {
+                hierSeg.writeCut(clumpDataset, outputImages.at(i), imageFormat, minPxls.at(i), distThresholds.at(i));
+            }
+            
+            GDALClose(inDataset);
+            GDALClose(clumpDataset);
+        }
+        catch (rsgis::RSGISException &e)
+        {
+            throw rsgis::cmds::RSGISCmdException(e.what());
+        }
+        catch (std::exception &e)
+        {
+            throw rsgis::cmds::RSGISCmdException(e.what());
+        }
+    }
+    
+    void executeTiledSegmentation(std::string inputImage, std::string clusterCentresFile, std::string outputClumps, std::string outputBorders, std::string imageFormat, unsigned int tileWidth, unsigned int tileHeight, unsigned int minPxls, float distThres, unsigned int numThreads)
+    {
+        try
+        {
+            GDALAllRegister();
+            GDALDataset *inDataset = (GDALDataset *) GDALOpen(inputImage.c_str(), GA_ReadOnly);
+            if(inDataset == NULL)
+            {
+                std::string message = std::string("Could not open image ") + inputImage;
+                throw rsgis::RSGISImageException(message.c_str());
+            }
+            
+            rsgis::math::RSGISMatrices matrixUtils;
+            rsgis::math::Matrix *clusterCentres = matrixUtils.readMatrixFromGridTxt(clusterCentresFile);
+            
+            rsgis::img::RSGISImageUtils imgUtils;
+            GDALDataset *clumpsDataset = imgUtils.createCopy(inDataset, 1, outputClumps, imageFormat, GDT_UInt32, true, "");
+            GDALDataset *bordersDataset = NULL;
+            if(outputBorders != "")
+            {
+                bordersDataset = imgUtils.createCopy(inDataset, 1, outputBorders, imageFormat, GDT_Byte, true, "");
+            }
+            
+            rsgis::segment::RSGISTiledSegmentation tiledSeg(tileWidth, tileHeight);
+            tiledSeg.setNumThreads(numThreads);
+            tiledSeg.segmentTiles(inDataset, clusterCentres, minPxls, distThres, clumpsDataset, bordersDataset);
+            
+            clumpsDataset->GetRasterBand(1)->SetMetadataItem("LAYER_TYPE", "thematic");
+            GDALClose(clumpsDataset);
+            if(bordersDataset != NULL)
+            {
+                bordersDataset->GetRasterBand(1)->SetMetadataItem("LAYER_TYPE", "thematic");
+                GDALClose(bordersDataset);
+            }
+            matrixUtils.freeMatrix(clusterCentres);
+            GDALClose(inDataset);
+        }
+        catch (rsgis::RSGISException &e)
+        {
+            throw rsgis::cmds::RSGISCmdException(e.what());
+        }
+        catch (std::exception &e)
+        {
+            throw rsgis::cmds::RSGISCmdException(e.what());
+        }
+    }
+    
     void executeMergeClumpsEquivalentVal(std::string clumpsImage, std::string outputImage, std::string imageFormat, std::vector<std::string> clumpsValCols)
     {
         try
@@ -975,17 +1162,11 @@ namespace rsgis{ namespace cmds {
             rsgis::segment::RSGISMergeSegments mergeSegs;
             mergeSegs.mergeEquivlentClumpsInRAT(clumpDataset, clumpsValCols);
             
-            rsgis::rastergis::RSGISRasterAttUtils attUtils;
-            GDALRasterAttributeTable *gdalATT = clumpDataset->GetRasterBand(1)->GetDefaultRAT();
-            
-            // Get column intex in RAT
-            unsigned int columnIndex = attUtils.findColumnIndex(gdalATT, "OutClumpIDs");
-            
-            rsgis::rastergis::RSGISExportColumns2ImageCalcImage *calcImageVal = new rsgis::rastergis::RSGISExportColumns2ImageCalcImage(1, gdalATT, columnIndex);
-            rsgis::img::RSGISCalcImage calcImage(calcImageVal);
-            
-            calcImage.calcImage(&clumpDataset, 1, 0, outputImage, false, NULL, imageFormat, GDT_UInt32);
-            delete calcImageVal;
+            rsgis::img::RSGISImageUtils imgUtils;
+            GDALDataset *relabelledDS = imgUtils.createCopy(clumpDataset, 1, outputImage, imageFormat, GDT_UInt32);
+            rsgis::rastergis::RSGISRATLUTImage lutImage;
+            lutImage.exportColumns(clumpDataset, 1, std::vector<std::string>(1, "OutClumpIDs"), relabelledDS);
+            GDALClose(relabelledDS);
             
             GDALDataset *outputClumpsDS = (GDALDataset *) GDALOpen(outputImage.c_str(), GA_Update);
             if(outputClumpsDS == NULL)
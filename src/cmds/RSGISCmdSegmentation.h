@@ -68,11 +68,14 @@ namespace rsgis{ namespace cmds {
     /** Function to run the eliminate single pixels command */
     DllExport void executeEliminateSinglePixels(std::string inputImage, std::string clumpsImage, std::string outputImage, std::string tempImage, std::string imageFormat, bool processInMemory, bool ignoreZeros);
     
-    /** Function to run the clump command */
-    DllExport void executeClump(std::string inputImage, std::string outputImage, std::string imageFormat, bool processInMemory, bool noDataValProvided, float noDataVal, bool addRatPxlVals=true);
+    /** Function to run the clump command. If numThreads is not 1 the image is clumped as tiles in parallel (0 uses the number of cores) */
+    DllExport void executeClump(std::string inputImage, std::string outputImage, std::string imageFormat, bool processInMemory, bool noDataValProvided, float noDataVal, bool addRatPxlVals=true, unsigned int numThreads=1);
+    
+    /** Function to group neighbouring pixels within specThreshold (Euclidean distance) of a seed pixel into clumps; numThreads other than 1 groups strips of rows concurrently */
+    DllExport void executeSpectralGroupClumps(std::string inputImage, std::string outputImage, std::string imageFormat, float specThreshold, bool noDataValProvided, float noDataVal, unsigned int numThreads=1);
 
-    /** Function to run the iterative stepwise elimination command */
-    DllExport void executeRMSmallClumpsStepwise(std::string inputImage, std::string clumpsImage, std::string outputImage, std::string imageFormat, bool stretchStatsAvail, std::string stretchStatsFile, bool storeMean, bool processInMemory, unsigned int minClumpSize, float specThreshold);
+    /** Function to run the iterative stepwise elimination command. If usePriorityQueue (and storeMean) the event driven (min-heap) elimination is used */
+    DllExport void executeRMSmallClumpsStepwise(std::string inputImage, std::string clumpsImage, std::string outputImage, std::string imageFormat, bool stretchStatsAvail, std::string stretchStatsFile, bool storeMean, bool processInMemory, unsigned int minClumpSize, float specThreshold, bool usePriorityQueue=false);
     
     /** Function to run the relabel clumps command */
     DllExport void executeRelabelClumps(std::string inputImage, std::string outputImage, std::string imageFormat, bool processInMemory);
@@ -80,6 +83,9 @@ namespace rsgis{ namespace cmds {
     /** Function to run generate mean image command */
     DllExport void executeMeanImage(std::string inputImage, std::string clumpsImage, std::string outputImage, std::string imageFormat, RSGISLibDataType outDataType, bool processInMemory);
     
+    /** Function to write the mean of each band of an image for each clump to columns of the clumps RAT */
+    DllExport void executeClumpMeans2RAT(std::string inputImage, std::string clumpsImage, std::vector<std::string> colNames);
+    
     /** Function to run assign random colours to clumps commands */
     DllExport void executeRandomColourClumps(std::string inputImage, std::string outputImage, std::string imageFormat, bool processInMemory, std::string importLUTFile, bool importLUT, std::string exportLUTFile, bool exportLUT);
     
@@ -113,6 +119,12 @@ namespace rsgis{ namespace cmds {
     /** Function to drop selected clumps from the segmentation */
     DllExport void executeDropSelectedClumps(std::string clumpsImage, std::string outputImage, std::string imageFormat, std::string selectClumpsCol);
     
+    /** Function to produce clumps at several scales (minimum clump size and spectral distance threshold) from one merge tree of an initial clumps image */
+    DllExport void executeHierarchicalSegmentation(std::string inputImage, std::string clumpsImage, std::vector<std::string> outputImages, std::vector<unsigned int> minPxls, std::vector<float> distThresholds, std::string imageFormat);
+    
+    /** Function to segment an image as tiles in parallel (0 threads uses the number of cores), writing the clumps and a mask of the clumps on the tile borders */
+    DllExport void executeTiledSegmentation(std::string inputImage, std::string clusterCentresFile, std::string outputClumps, std::string outputBorders, std::string imageFormat, unsigned int tileWidth, unsigned int tileHeight, unsigned int minPxls, float distThres, unsigned int numThreads=0);
+    
     /** Function merge clumps with same value */
     DllExport void executeMergeClumpsEquivalentVal(std::string clumpsImage, std::string outputImage, std::string imageFormat, std::vector<std::string> clumpsValCols);
     
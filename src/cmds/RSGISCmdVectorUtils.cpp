@@ -49,6 +49,7 @@
 #include "vec/RSGISGetAttributeValues.h"
 #include "vec/RSGISFitActiveContour4Polys.h"
 #include "vec/RSGISCopyCheckPolygons.h"
+#include "vec/RSGISPolygoniseClumps.h"
 
 #include "geom/RSGISFitPolygon2Points.h"
 #include "geom/RSGISMinSpanTreeClustererStdDevThreshold.h"
@@ -86,8 +87,8 @@ namespace rsgis{ namespace cmds {
             
             for(std::vector<std::pair<std::string,std::vector<geos::geom::Coordinate>* >* >::iterator iterGrps = coordGrps->begin(); iterGrps != coordGrps->end(); ++iterGrps)
             {
-                delete (*iterGrps);
                 delete (*iterGrps)->second;
+                delete (*iterGrps);
             }
             delete coordGrps;
         }
@@ -270,7 +271,9 @@ namespace rsgis{ namespace cmds {
                 std::string message = std::string("Could not create vector file ") + outputVector;
                 throw rsgis::vec::RSGISVectorOutputException(message.c_str());
             }
-            OGRLayer *outputVecLayer = outputVecDS->CreateLayer(outLyrName.c_str(), inputSpatialRef, wkbPolygon, NULL );
+            char **lyrOptions = rsgis::vec::RSGISOGRBatchWriter::getBulkLayerOptions(ogrVecDriver);
+            OGRLayer *outputVecLayer = outputVecDS->CreateLayer(outLyrName.c_str(), inputSpatialRef, wkbPolygon, lyrOptions );
+            CSLDestroy(lyrOptions);
             if( outputVecLayer == NULL )
             {
                 std::string message = std::string("Could not create vector layer ") + outLyrName;
@@ -281,6 +284,7 @@ namespace rsgis{ namespace cmds {
             processVector = new rsgis::vec::RSGISProcessGeometry(processGeom);
             
             processVector->processGeometryPolygonOutput(inputVecLayer, outputVecLayer, true, false);
+            rsgis::vec::RSGISOGRBatchWriter::createDeferredSpatialIndex(ogrVecDriver, outputVecDS, outputVecLayer);
             
             GDALClose(inputVecDS);
             GDALClose(outputVecDS);
@@ -626,6 +630,9 @@ namespace rsgis{ namespace cmds {
             /********************************************
              * Loop through features in input shapefile *
              ********************************************/
+            // Index the input polygons once so each cover polygon only tests those it may contain.
+            rsgis::vec::RSGISOGRLayerSpatialIndex inputPolysIdx(inputVecLayer, false);
+            
             OGRFeature *inCoverFeature = NULL;
             while( (inCoverFeature = inputCoverSHPLayer->GetNextFeature()) != NULL )
             {
@@ -690,7 +697,7 @@ namespace rsgis{ namespace cmds {
                 long unsigned numPolygonsInCover = 0;
                 try
                 {
-                    numPolygonsInCover = copyPolysinPoly.copyPolygonsInPoly(inputVecLayer, outputVecLayer, coverGeometry);
+                    numPolygonsInCover = copyPolysinPoly.copyPolygonsInPoly(inputVecLayer, &inputPolysIdx, outputVecLayer, coverGeometry);
                     GDALClose(outputVecDS);
                 }
                 catch (RSGISVectorException &e)
@@ -2257,7 +2264,9 @@ namespace rsgis{ namespace cmds {
                 std::string message = std::string("Could not create vector file ") + outputVec;
                 throw rsgis::vec::RSGISVectorOutputException(message.c_str());
             }
-            OGRLayer *outputVecLayer = outputVecDS->CreateLayer(lyrName.c_str(), spatialRef, inFeatureDefn->GetGeomType(), NULL );
+            char **lyrOptions = rsgis::vec::RSGISOGRBatchWriter::getBulkLayerOptions(gdaldriver);
+            OGRLayer *outputVecLayer = outputVecDS->CreateLayer(lyrName.c_str(), spatialRef, inFeatureDefn->GetGeomType(), lyrOptions );
+            CSLDestroy(lyrOptions);
             if( outputVecLayer == NULL )
             {
                 std::string message = std::string("Could not create vector layer ") + lyrName;
@@ -2267,6 +2276,7 @@ namespace rsgis{ namespace cmds {
             std::cout.precision(12);
             rsgis::vec::RSGISCopyCheckPolygons checkPolys;
             checkPolys.copyCheckPolygons(inputVecLayer, outputVecLayer, printGeomErrs);
+            rsgis::vec::RSGISOGRBatchWriter::createDeferredSpatialIndex(gdaldriver, outputVecDS, outputVecLayer);
 
             GDALClose(inputVecDS);
             GDALClose(outputVecDS);
@@ -2285,5 +2295,96 @@ namespace rsgis{ namespace cmds {
         }
     }
             
+    void executePolygoniseClumps(std::string inputImg, unsigned int imgBand, std::string outputVec, std::string outLyrName, std::string vecDriver, std::string pxlValFieldName, bool useNoData)
+    {
+        try
+        {
+            // Convert to absolute path
+            outputVec = boost::filesystem::absolute(outputVec).string();
+
+            OGRRegisterAll();
+            GDALAllRegister();
+
+            GDALDataset *inputImgDS = (GDALDataset *) GDALOpen(inputImg.c_str(), GA_ReadOnly);
+            if(inputImgDS == NULL)
+            {
+                std::string message = std::string("Could not open image ") + inputImg;
+                throw RSGISImageException(message.c_str());
+            }
+            if((imgBand == 0) || (imgBand > ((unsigned int)inputImgDS->GetRasterCount())))
+            {
+                GDALClose(inputImgDS);
+                throw RSGISImageException("The image band specified is not within the image.");
+            }
+
+            OGRSpatialReference *imgSpatialRef = NULL;
+            const char *imgProjWKT = inputImgDS->GetProjectionRef();
+            if((imgProjWKT != NULL) && (std::string(imgProjWKT) != ""))
+            {
+                imgSpatialRef = new OGRSpatialReference(imgProjWKT);
+            }
+
+            /////////////////////////////////////
+            //
+            // Create Output Vector.
+            //
+            /////////////////////////////////////
+            GDALDriver *gdaldriver = GetGDALDriverManager()->GetDriverByName(vecDriver.c_str());
+            if( gdaldriver == NULL )
+            {
+                std::string message = std::string("Driver not avaiable: ") + vecDriver;
+                throw rsgis::vec::RSGISVectorOutputException(message.c_str());
+            }
+            GDALDataset *outputVecDS = gdaldriver->Create(outputVec.c_str(), 0, 0, 0, GDT_Unknown, NULL);
+            if( outputVecDS == NULL )
+            {
+                std::string message = std::string("Could not create vector file ") + outputVec;
+                throw rsgis::vec::RSGISVectorOutputException(message.c_str());
+            }
+            char **lyrOptions = rsgis::vec::RSGISOGRBatchWriter::getBulkLayerOptions(gdaldriver);
+            OGRLayer *outputVecLayer = outputVecDS->CreateLayer(outLyrName.c_str(), imgSpatialRef, wkbMultiPolygon, lyrOptions );
+            CSLDestroy(lyrOptions);
+            if( outputVecLayer == NULL )
+            {
+                std::string message = std::string("Could not create vector layer ") + outLyrName;
+                throw rsgis::vec::RSGISVectorOutputException(message.c_str());
+            }
+
+            rsgis::vec::RSGISPolygoniseClumps polygoniseClumps;
+            if(useNoData)
+            {
+                int hasNoData = false;
+                double noDataVal = inputImgDS->GetRasterBand(imgBand)->GetNoDataValue(&hasNoData);
+                if(hasNoData)
+                {
+                    polygoniseClumps.setNoDataValue(true, (uint32_t)noDataVal);
+                }
+            }
+            unsigned long numPolys = polygoniseClumps.polygonise(inputImgDS, imgBand, outputVecLayer, pxlValFieldName);
+            std::cout << numPolys << " polygons were created.\n";
+
+            rsgis::vec::RSGISOGRBatchWriter::createDeferredSpatialIndex(gdaldriver, outputVecDS, outputVecLayer);
+
+            GDALClose(outputVecDS);
+            GDALClose(inputImgDS);
+            if(imgSpatialRef != NULL)
+            {
+                OGRSpatialReference::DestroySpatialReference(imgSpatialRef);
+            }
+        }
+        catch(rsgis::RSGISVectorException &e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+        catch(rsgis::RSGISException &e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+        catch (std::exception &e)
+        {
+            throw RSGISCmdException(e.what());
+        }
+    }
+            
 }}
             
@@ -96,6 +96,8 @@ namespace rsgis{ namespace cmds{
     DllExport void executeFitActiveContourBoundaries(std::string inputPolysVec, std::string outputPolysVec, std::string externalForceImg, double interAlpha, double interBeta, double interGamma, double minExtThres, bool force);
     /** Function to check and validate the geometries within the vector file */
     DllExport void executeCheckValidateGeometries(std::string inputVec, std::string lyrName, std::string outputVec, std::string vecDriver, bool printGeomErrs);
+    /** Function to polygonise the clumps of an image by tracing the boundaries between clumps */
+    DllExport void executePolygoniseClumps(std::string inputImg, unsigned int imgBand, std::string outputVec, std::string outLyrName, std::string vecDriver, std::string pxlValFieldName, bool useNoData);
 }}
 
 
@@ -879,7 +879,7 @@ namespace rsgis{ namespace cmds {
             delete zonBandAtts;
 
             rsgis::vec::ZonalStats zonalStatsObj = rsgis::vec::ZonalStats();
-            zonalStatsObj.zonalStatsFeatsVectorLyr(inImageDS, vecLayer, rsgisZonalBandAtts, pixelInPolyMethod);
+            zonalStatsObj.zonalStatsFeatsVectorLyrBatched(inImageDS, vecLayer, rsgisZonalBandAtts, pixelInPolyMethod);
 
             delete rsgisZonalBandAtts;
             delete vecDS;
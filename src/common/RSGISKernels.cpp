@@ -0,0 +1,414 @@
+/*
+ *  RSGISKernels.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISKernels.h"
+
+#include <atomic>
+#include <limits>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    #define RSGIS_KERNELS_X86_DISPATCH 1
+#endif
+
+// Fused multiply-adds (part of AVX-512) would change the results of the
+// variants so are not used: the file is built with -ffp-contract=off (see
+// src/CMakeLists.txt).
+
+namespace rsgis
+{
+    namespace
+    {
+        // The kernels are written as plain loops which the compiler
+        // vectorises for the instruction set of each variant below.
+        const unsigned int numLanes = 16;
+        const size_t chunkPxls = 1024;
+
+        inline void affineKernel(const float *in, float *out, size_t n, float scale, float offset)
+        {
+            for(size_t i = 0; i < n; ++i)
+            {
+                out[i] = (in[i] * scale) + offset;
+            }
+        }
+
+        template <typename T>
+        inline void scaleToIntKernel(const float *in, T *out, size_t n, float scale, float offset)
+        {
+            const float maxVal = (float)std::numeric_limits<T>::max();
+            for(size_t i = 0; i < n; ++i)
+            {
+                float v = (in[i] * scale) + offset;
+                // NaN fails both comparisons so is set to 0.
+                v = (v > 0.0f)?v:0.0f;
+                v = (v < maxVal)?v:maxVal;
+                out[i] = (T)(v + 0.5f);
+            }
+        }
+
+        inline void maskedSelectKernel(const unsigned char *mask, const float *a, const float *b, float *out, size_t n)
+        {
+            for(size_t i = 0; i < n; ++i)
+            {
+                out[i] = (mask[i] != 0)?a[i]:b[i];
+            }
+        }
+
+        inline size_t reduceMinMaxSumKernel(const float *in, size_t n, bool useNoData, float noDataVal, float *minVal, float *maxVal, double *sum)
+        {
+            // Each lane accumulates every numLanes'th value so the order of
+            // the sums is the same whatever the vector width.
+            float laneMin[numLanes];
+            float laneMax[numLanes];
+            double laneSum[numLanes];
+            size_t laneCount[numLanes];
+            for(unsigned int l = 0; l < numLanes; ++l)
+            {
+                laneMin[l] = std::numeric_limits<float>::max();
+                laneMax[l] = -std::numeric_limits<float>::max();
+                laneSum[l] = 0;
+                laneCount[l] = 0;
+            }
+            size_t i = 0;
+            for(; (i + numLanes) <= n; i += numLanes)
+            {
+                for(unsigned int l = 0; l < numLanes; ++l)
+                {
+                    float v = in[i + l];
+                    bool valid = (v == v) && !(useNoData && (v == noDataVal));
+                    laneMin[l] = (valid && (v < laneMin[l]))?v:laneMin[l];
+                    laneMax[l] = (valid && (v > laneMax[l]))?v:laneMax[l];
+                    laneSum[l] += valid?((double)v):0.0;
+                    laneCount[l] += valid?1:0;
+                }
+            }
+            for(unsigned int l = 0; i < n; ++i, ++l)
+            {
+                float v = in[i];
+                bool valid = (v == v) && !(useNoData && (v == noDataVal));
+                laneMin[l] = (valid && (v < laneMin[l]))?v:laneMin[l];
+                laneMax[l] = (valid && (v > laneMax[l]))?v:laneMax[l];
+                laneSum[l] += valid?((double)v):0.0;
+                laneCount[l] += valid?1:0;
+            }
+
+            size_t count = 0;
+            double total = 0;
+            for(unsigned int l = 0; l < numLanes; ++l)
+            {
+                if(laneCount[l] == 0)
+                {
+                    continue;
+                }
+                if(count == 0)
+                {
+                    *minVal = laneMin[l];
+                    *maxVal = laneMax[l];
+                }
+                else
+                {
+                    *minVal = std::min(*minVal, laneMin[l]);
+                    *maxVal = std::max(*maxVal, laneMax[l]);
+                }
+                count += laneCount[l];
+                total += laneSum[l];
+            }
+            *sum = total;
+            return count;
+        }
+
+        inline void histogramKernel(const float *in, size_t n, float minVal, float binWidth, unsigned int numBins, unsigned long long *hist)
+        {
+            // The bins are found for a chunk of values (vectorised) before
+            // the counts are added.
+            int bins[chunkPxls];
+            const float fNumBins = (float)numBins;
+            for(size_t start = 0; start < n; start += chunkPxls)
+            {
+                size_t nChunk = std::min(chunkPxls, n - start);
+                const float *chunk = in + start;
+                for(size_t i = 0; i < nChunk; ++i)
+                {
+                    float t = (chunk[i] - minVal) / binWidth;
+                    // NaN fails the comparison so is outside the bins.
+                    bool inside = (t >= 0.0f) && (t < fNumBins);
+                    bins[i] = inside?((int)(inside?t:0.0f)):-1;
+                }
+                for(size_t i = 0; i < nChunk; ++i)
+                {
+                    if(bins[i] >= 0)
+                    {
+                        ++hist[bins[i]];
+                    }
+                }
+            }
+        }
+
+        // T is the type of the centres, in which the distances are summed.
+        template <typename T>
+        inline void nearestCentreKernel(const float* const* bands, unsigned int numBands, size_t n, const T *centres, unsigned int numCentres, unsigned int *outIdx, T *outDist)
+        {
+            // Pixels are processed in chunks so the distances stay in cache
+            // while every centre is compared.
+            T bestDist[chunkPxls];
+            T dist[chunkPxls];
+            for(size_t start = 0; start < n; start += chunkPxls)
+            {
+                size_t nChunk = std::min(chunkPxls, n - start);
+                unsigned int *chunkIdx = outIdx + start;
+                for(size_t i = 0; i < nChunk; ++i)
+                {
+                    bestDist[i] = std::numeric_limits<T>::infinity();
+                    chunkIdx[i] = 0;
+                }
+                for(unsigned int c = 0; c < numCentres; ++c)
+                {
+                    const T *centre = centres + (((size_t)c) * numBands);
+                    for(size_t i = 0; i < nChunk; ++i)
+                    {
+                        dist[i] = 0;
+                    }
+                    for(unsigned int b = 0; b < numBands; ++b)
+                    {
+                        const float *band = bands[b] + start;
+                        const T centreVal = centre[b];
+                        for(size_t i = 0; i < nChunk; ++i)
+                        {
+                            T diff = centreVal - band[i];
+                            dist[i] += diff * diff;
+                        }
+                    }
+                    for(size_t i = 0; i < nChunk; ++i)
+                    {
+                        bool closer = dist[i] < bestDist[i];
+                        bestDist[i] = closer?dist[i]:bestDist[i];
+                        chunkIdx[i] = closer?c:chunkIdx[i];
+                    }
+                }
+                if(outDist != NULL)
+                {
+                    std::memcpy(outDist + start, bestDist, sizeof(T) * nChunk);
+                }
+            }
+        }
+
+        inline void lutGatherKernel(const unsigned int *idx, size_t n, const float *lut, size_t lutSize, float outOfRange, float *out)
+        {
+            for(size_t i = 0; i < n; ++i)
+            {
+                unsigned int j = idx[i];
+                out[i] = (j < lutSize)?lut[j]:outOfRange;
+            }
+        }
+
+        struct RSGISKernelTable
+        {
+            void (*affine)(const float*, float*, size_t, float, float);
+            void (*scaleToUInt8)(const float*, unsigned char*, size_t, float, float);
+            void (*scaleToUInt16)(const float*, unsigned short*, size_t, float, float);
+            void (*maskedSelect)(const unsigned char*, const float*, const float*, float*, size_t);
+            size_t (*reduceMinMaxSum)(const float*, size_t, bool, float, float*, float*, double*);
+            void (*histogram)(const float*, size_t, float, float, unsigned int, unsigned long long*);
+            void (*nearestCentre)(const float* const*, unsigned int, size_t, const float*, unsigned int, unsigned int*, float*);
+            void (*nearestCentreDbl)(const float* const*, unsigned int, size_t, const double*, unsigned int, unsigned int*, double*);
+            void (*lutGather)(const unsigned int*, size_t, const float*, size_t, float, float*);
+        };
+
+        // Defines the kernels of one variant (compiled with the attributes
+        // ATTRS, which inline the kernels above into each) and its table.
+        #define RSGIS_DEFINE_KERNEL_VARIANT(SUFFIX, ATTRS) \
+            ATTRS void affine_##SUFFIX(const float *in, float *out, size_t n, float scale, float offset) \
+                { affineKernel(in, out, n, scale, offset); } \
+            ATTRS void scaleToUInt8_##SUFFIX(const float *in, unsigned char *out, size_t n, float scale, float offset) \
+                { scaleToIntKernel<unsigned char>(in, out, n, scale, offset); } \
+            ATTRS void scaleToUInt16_##SUFFIX(const float *in, unsigned short *out, size_t n, float scale, float offset) \
+                { scaleToIntKernel<unsigned short>(in, out, n, scale, offset); } \
+            ATTRS void maskedSelect_##SUFFIX(const unsigned char *mask, const float *a, const float *b, float *out, size_t n) \
+                { maskedSelectKernel(mask, a, b, out, n); } \
+            ATTRS size_t reduceMinMaxSum_##SUFFIX(const float *in, size_t n, bool useNoData, float noDataVal, float *minVal, float *maxVal, double *sum) \
+                { return reduceMinMaxSumKernel(in, n, useNoData, noDataVal, minVal, maxVal, sum); } \
+            ATTRS void histogram_##SUFFIX(const float *in, size_t n, float minVal, float binWidth, unsigned int numBins, unsigned long long *hist) \
+                { histogramKernel(in, n, minVal, binWidth, numBins, hist); } \
+            ATTRS void nearestCentre_##SUFFIX(const float* const* bands, unsigned int numBands, size_t n, const float *centres, unsigned int numCentres, unsigned int *outIdx, float *outDist) \
+                { nearestCentreKernel<float>(bands, numBands, n, centres, numCentres, outIdx, outDist); } \
+            ATTRS void nearestCentreDbl_##SUFFIX(const float* const* bands, unsigned int numBands, size_t n, const double *centres, unsigned int numCentres, unsigned int *outIdx, double *outDist) \
+                { nearestCentreKernel<double>(bands, numBands, n, centres, numCentres, outIdx, outDist); } \
+            ATTRS void lutGather_##SUFFIX(const unsigned int *idx, size_t n, const float *lut, size_t lutSize, float outOfRange, float *out) \
+                { lutGatherKernel(idx, n, lut, lutSize, outOfRange, out); } \
+            const RSGISKernelTable kernelTable_##SUFFIX = {affine_##SUFFIX, scaleToUInt8_##SUFFIX, scaleToUInt16_##SUFFIX, maskedSelect_##SUFFIX, \
+                reduceMinMaxSum_##SUFFIX, histogram_##SUFFIX, nearestCentre_##SUFFIX, nearestCentreDbl_##SUFFIX, lutGather_##SUFFIX};
+
+        #ifdef RSGIS_KERNELS_X86_DISPATCH
+            RSGIS_DEFINE_KERNEL_VARIANT(scalar, __attribute__((flatten)))
+            RSGIS_DEFINE_KERNEL_VARIANT(sse4, __attribute__((target("sse4.2"), flatten)))
+            RSGIS_DEFINE_KERNEL_VARIANT(avx2, __attribute__((target("avx2"), flatten)))
+            RSGIS_DEFINE_KERNEL_VARIANT(avx512, __attribute__((target("avx512f,avx512bw,avx512vl"), flatten)))
+        #else
+            RSGIS_DEFINE_KERNEL_VARIANT(scalar, )
+        #endif
+
+        const RSGISKernelTable* getKernelTable(RSGISKernelISA isa)
+        {
+        #ifdef RSGIS_KERNELS_X86_DISPATCH
+            switch(isa)
+            {
+                case rsgis_isa_avx512:
+                    return &kernelTable_avx512;
+                case rsgis_isa_avx2:
+                    return &kernelTable_avx2;
+                case rsgis_isa_sse4:
+                    return &kernelTable_sse4;
+                default:
+                    return &kernelTable_scalar;
+            }
+        #else
+            return &kernelTable_scalar;
+        #endif
+        }
+
+        RSGISKernelISA defaultISA()
+        {
+            RSGISKernelISA isa = RSGISKernels::getSupportedISA();
+            if(const char* env_p = std::getenv("RSGISLIB_SIMD"))
+            {
+                std::string envISA = env_p;
+                RSGISKernelISA capISA = isa;
+                if(envISA == "scalar")
+                {
+                    capISA = rsgis_isa_scalar;
+                }
+                else if(envISA == "sse4")
+                {
+                    capISA = rsgis_isa_sse4;
+                }
+                else if(envISA == "avx2")
+                {
+                    capISA = rsgis_isa_avx2;
+                }
+                isa = std::min(isa, capISA);
+            }
+            return isa;
+        }
+
+        std::atomic<int>& activeISA()
+        {
+            static std::atomic<int> isa(defaultISA());
+            return isa;
+        }
+
+        inline const RSGISKernelTable* kernels()
+        {
+            return getKernelTable((RSGISKernelISA)activeISA().load(std::memory_order_relaxed));
+        }
+    }
+
+    void RSGISKernels::affine(const float *in, float *out, size_t n, float scale, float offset)
+    {
+        kernels()->affine(in, out, n, scale, offset);
+    }
+
+    void RSGISKernels::scaleToUInt8(const float *in, unsigned char *out, size_t n, float scale, float offset)
+    {
+        kernels()->scaleToUInt8(in, out, n, scale, offset);
+    }
+
+    void RSGISKernels::scaleToUInt16(const float *in, unsigned short *out, size_t n, float scale, float offset)
+    {
+        kernels()->scaleToUInt16(in, out, n, scale, offset);
+    }
+
+    void RSGISKernels::maskedSelect(const unsigned char *mask, const float *a, const float *b, float *out, size_t n)
+    {
+        kernels()->maskedSelect(mask, a, b, out, n);
+    }
+
+    size_t RSGISKernels::reduceMinMaxSum(const float *in, size_t n, bool useNoData, float noDataVal, float *minVal, float *maxVal, double *sum)
+    {
+        return kernels()->reduceMinMaxSum(in, n, useNoData, noDataVal, minVal, maxVal, sum);
+    }
+
+    void RSGISKernels::histogram(const float *in, size_t n, float minVal, float binWidth, unsigned int numBins, unsigned long long *hist)
+    {
+        kernels()->histogram(in, n, minVal, binWidth, numBins, hist);
+    }
+
+    void RSGISKernels::nearestCentre(const float* const* bands, unsigned int numBands, size_t n, const float *centres, unsigned int numCentres, unsigned int *outIdx, float *outDist)
+    {
+        kernels()->nearestCentre(bands, numBands, n, centres, numCentres, outIdx, outDist);
+    }
+
+    void RSGISKernels::nearestCentre(const float* const* bands, unsigned int numBands, size_t n, const double *centres, unsigned int numCentres, unsigned int *outIdx, double *outDist)
+    {
+        kernels()->nearestCentreDbl(bands, numBands, n, centres, numCentres, outIdx, outDist);
+    }
+
+    void RSGISKernels::lutGather(const unsigned int *idx, size_t n, const float *lut, size_t lutSize, float outOfRange, float *out)
+    {
+        kernels()->lutGather(idx, n, lut, lutSize, outOfRange, out);
+    }
+
+    RSGISKernelISA RSGISKernels::getISA()
+    {
+        return (RSGISKernelISA)activeISA().load();
+    }
+
+    std::string RSGISKernels::getISAName()
+    {
+        switch(getISA())
+        {
+            case rsgis_isa_avx512:
+                return "avx512";
+            case rsgis_isa_avx2:
+                return "avx2";
+            case rsgis_isa_sse4:
+                return "sse4";
+            default:
+                return "scalar";
+        }
+    }
+
+    void RSGISKernels::setISA(RSGISKernelISA isa)
+    {
+        activeISA().store(std::min(isa, getSupportedISA()));
+    }
+
+    RSGISKernelISA RSGISKernels::getSupportedISA()
+    {
+    #ifdef RSGIS_KERNELS_X86_DISPATCH
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl"))
+        {
+            return rsgis_isa_avx512;
+        }
+        if(__builtin_cpu_supports("avx2"))
+        {
+            return rsgis_isa_avx2;
+        }
+        if(__builtin_cpu_supports("sse4.2"))
+        {
+            return rsgis_isa_sse4;
+        }
+    #endif
+        return rsgis_isa_scalar;
+    }
+}
@@ -0,0 +1,118 @@
+/*
+ *  RSGISKernels.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISKernels_H
+#define RSGISKernels_H
+
+#include <iostream>
+#include <string>
+#include <cstddef>
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_commons_EXPORTS
+        #define DllExport __declspec( dllexport )
+    #else
+        #define DllExport __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis
+{
+    /**
+     * The instruction sets the kernels are compiled for, in increasing order.
+     */
+    enum RSGISKernelISA
+    {
+        rsgis_isa_scalar = 0,
+        rsgis_isa_sse4 = 1,
+        rsgis_isa_avx2 = 2,
+        rsgis_isa_avx512 = 3
+    };
+
+    /**
+     * Vectorised kernels for the primitives shared by the image processing
+     * modules. Each kernel is compiled once per instruction set (SSE4.2, AVX2
+     * and AVX-512 on x86-64 with GCC or Clang, otherwise only the default
+     * build, which uses NEON on ARM64) and the best supported by the CPU is
+     * chosen at run time, so a single binary uses the best instructions on
+     * each node. The choice can be capped with the RSGISLIB_SIMD environment
+     * variable (scalar, sse4, avx2 or avx512), e.g., to compare results.
+     *
+     * The variants do the same arithmetic in the same order (FMA is not
+     * enabled and the reductions use a fixed number of lanes) so they give
+     * identical results on every CPU.
+     *
+     * Bands are given as planes (as RSGISCalcImageValue::calcImageBlock) and
+     * no-data/NaN handling is as described for each kernel.
+     */
+    class DllExport RSGISKernels
+    {
+    public:
+        /// out = (in * scale) + offset
+        static void affine(const float *in, float *out, size_t n, float scale, float offset);
+        /// out = round((in * scale) + offset) clamped to 0 - 255 (NaN gives 0)
+        static void scaleToUInt8(const float *in, unsigned char *out, size_t n, float scale, float offset);
+        /// out = round((in * scale) + offset) clamped to 0 - 65535 (NaN gives 0)
+        static void scaleToUInt16(const float *in, unsigned short *out, size_t n, float scale, float offset);
+        /// out = mask != 0 ? a : b
+        static void maskedSelect(const unsigned char *mask, const float *a, const float *b, float *out, size_t n);
+        /**
+         * The minimum, maximum and sum of the values which are not NaN (nor
+         * noDataVal if useNoData), returning the number of values used. The
+         * minimum and maximum are left unchanged if there are none.
+         */
+        static size_t reduceMinMaxSum(const float *in, size_t n, bool useNoData, float noDataVal, float *minVal, float *maxVal, double *sum);
+        /**
+         * Add the values to hist, where bin k is
+         * [minVal + k*binWidth, minVal + (k+1)*binWidth). NaN values and
+         * those outside the numBins bins are ignored.
+         */
+        static void histogram(const float *in, size_t n, float minVal, float binWidth, unsigned int numBins, unsigned long long *hist);
+        /**
+         * The index of the nearest (squared Euclidean distance) of the
+         * numCentres centres (numBands values each, one centre after another)
+         * to each pixel, the first centre winning ties. outDist (the squared
+         * distance) may be NULL.
+         */
+        static void nearestCentre(const float* const* bands, unsigned int numBands, size_t n, const float *centres, unsigned int numCentres, unsigned int *outIdx, float *outDist);
+        /**
+         * As nearestCentre but with double precision centres and distances,
+         * each summed over the bands in order as sum += (centre - value)^2.
+         */
+        static void nearestCentre(const float* const* bands, unsigned int numBands, size_t n, const double *centres, unsigned int numCentres, unsigned int *outIdx, double *outDist);
+        /// out = lut[idx] or outOfRange where idx >= lutSize
+        static void lutGather(const unsigned int *idx, size_t n, const float *lut, size_t lutSize, float outOfRange, float *out);
+        /// The instruction set in use
+        static RSGISKernelISA getISA();
+        static std::string getISAName();
+        /// Use the given instruction set, or the best supported below it
+        static void setISA(RSGISKernelISA isa);
+        /// The best instruction set supported by the CPU
+        static RSGISKernelISA getSupportedISA();
+    };
+}
+
+#endif
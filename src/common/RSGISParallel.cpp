@@ -0,0 +1,214 @@
+/*
+ *  RSGISParallel.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISParallel.h"
+
+namespace rsgis{namespace utils{
+
+    static thread_local bool rsgisInWorker = false;
+
+    unsigned int getNumThreads()
+    {
+        unsigned int numThreads = 1;
+        if(const char* env_p = std::getenv("RSGISLIB_NUM_THREADS"))
+        {
+            int envNumThreads = atoi(env_p);
+            if(envNumThreads > 1)
+            {
+                numThreads = envNumThreads;
+            }
+        }
+        return numThreads;
+    }
+
+    unsigned int resolveNumThreads(unsigned int numThreads)
+    {
+        if(numThreads == 0)
+        {
+            numThreads = std::thread::hardware_concurrency();
+        }
+        return (numThreads == 0)?1:numThreads;
+    }
+
+    bool inWorkerThread()
+    {
+        return rsgisInWorker;
+    }
+
+    RSGISWorkerPool::RSGISWorkerPool(unsigned int numThreads): generation(0), numActive(0), stopping(false), itemFunc(NULL), eachFunc(NULL), numItems(0), nextItem(0), error(nullptr)
+    {
+        this->numThreads = rsgisInWorker?1:resolveNumThreads(numThreads);
+        for(unsigned int t = 1; t < this->numThreads; ++t)
+        {
+            this->threads.push_back(std::thread(&RSGISWorkerPool::workerLoop, this, t));
+        }
+    }
+
+    void RSGISWorkerPool::parallelFor(size_t numItems, const std::function<void(size_t item, unsigned int worker)> &func)
+    {
+        if(numItems == 0)
+        {
+            return;
+        }
+        if(this->threads.empty() || (numItems == 1))
+        {
+            for(size_t i = 0; i < numItems; ++i)
+            {
+                func(i, 0);
+            }
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(this->poolMutex);
+            this->itemFunc = &func;
+            this->eachFunc = NULL;
+            this->numItems = numItems;
+            this->nextItem = 0;
+        }
+        this->runAll();
+    }
+
+    void RSGISWorkerPool::runOnEach(const std::function<void(unsigned int worker)> &func)
+    {
+        if(this->threads.empty())
+        {
+            func(0);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(this->poolMutex);
+            this->itemFunc = NULL;
+            this->eachFunc = &func;
+            this->numItems = 0;
+            this->nextItem = 0;
+        }
+        this->runAll();
+    }
+
+    void RSGISWorkerPool::runAll()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->poolMutex);
+            this->error = nullptr;
+            this->numActive = this->threads.size();
+            ++this->generation;
+        }
+        this->startCond.notify_all();
+        this->runJob(0);
+        std::exception_ptr jobError = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(this->poolMutex);
+            this->doneCond.wait(lock, [this]{return this->numActive == 0;});
+            jobError = this->error;
+            this->error = nullptr;
+            this->itemFunc = NULL;
+            this->eachFunc = NULL;
+        }
+        if(jobError)
+        {
+            std::rethrow_exception(jobError);
+        }
+    }
+
+    void RSGISWorkerPool::runJob(unsigned int worker)
+    {
+        bool wasInWorker = rsgisInWorker;
+        rsgisInWorker = true;
+        try
+        {
+            if(this->eachFunc != NULL)
+            {
+                (*this->eachFunc)(worker);
+            }
+            else
+            {
+                for(size_t i = this->nextItem++; i < this->numItems; i = this->nextItem++)
+                {
+                    (*this->itemFunc)(i, worker);
+                }
+            }
+        }
+        catch(...)
+        {
+            std::lock_guard<std::mutex> lock(this->poolMutex);
+            if(!this->error)
+            {
+                this->error = std::current_exception();
+            }
+            this->nextItem = this->numItems;
+        }
+        rsgisInWorker = wasInWorker;
+    }
+
+    void RSGISWorkerPool::workerLoop(unsigned int worker)
+    {
+        unsigned long long seen = 0;
+        for(;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(this->poolMutex);
+                this->startCond.wait(lock, [this, seen]{return this->stopping || (this->generation != seen);});
+                if(this->stopping)
+                {
+                    return;
+                }
+                seen = this->generation;
+            }
+            this->runJob(worker);
+            {
+                std::lock_guard<std::mutex> lock(this->poolMutex);
+                if(--this->numActive == 0)
+                {
+                    this->doneCond.notify_all();
+                }
+            }
+        }
+    }
+
+    RSGISWorkerPool::~RSGISWorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->poolMutex);
+            this->stopping = true;
+        }
+        this->startCond.notify_all();
+        for(std::vector<std::thread>::iterator iterThread = this->threads.begin(); iterThread != this->threads.end(); ++iterThread)
+        {
+            iterThread->join();
+        }
+    }
+
+    void parallelFor(size_t numItems, unsigned int numThreads, const std::function<void(size_t item, unsigned int worker)> &func)
+    {
+        if(numItems == 0)
+        {
+            return;
+        }
+        numThreads = resolveNumThreads(numThreads);
+        if(numThreads > numItems)
+        {
+            numThreads = numItems;
+        }
+        RSGISWorkerPool pool(numThreads);
+        pool.parallelFor(numItems, func);
+    }
+
+}}
@@ -0,0 +1,129 @@
+/*
+ *  RSGISParallel.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISParallel_H
+#define RSGISParallel_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <algorithm>
+#include <cstdlib>
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_commons_EXPORTS
+        #define DllExport __declspec( dllexport )
+    #else
+        #define DllExport __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace utils{
+
+    /**
+     * The default number of threads: the RSGISLIB_NUM_THREADS environment
+     * variable where it is greater than 1, otherwise 1.
+     */
+    DllExport unsigned int getNumThreads();
+
+    /**
+     * The number of threads to use for a requested number: 0 is the number
+     * of cores (and the result is at least 1).
+     */
+    DllExport unsigned int resolveNumThreads(unsigned int numThreads);
+
+    /**
+     * Whether the calling thread is a worker of a RSGISWorkerPool.
+     */
+    DllExport bool inWorkerThread();
+
+    /**
+     * A pool of numThreads workers, kept for the life of the pool so the
+     * threads are not created again for each job (e.g., each strip of an
+     * image). The calling thread is worker 0, so numThreads-1 threads are
+     * created.
+     *
+     * The pools share the one thread budget: a pool created from within a
+     * worker of another pool has one worker and runs its jobs on the
+     * calling thread, so nested parallel code (e.g., a calcImage within a
+     * pipeline stage) does not multiply the number of threads.
+     *
+     * The first exception thrown by a job is rethrown from parallelFor (or
+     * runOnEach) once all the workers have stopped; no more items are
+     * started after it.
+     */
+    class DllExport RSGISWorkerPool
+    {
+    public:
+        /// numThreads as for resolveNumThreads
+        RSGISWorkerPool(unsigned int numThreads);
+        unsigned int getNumThreads(){return this->numThreads;};
+        /**
+         * Calls func(item, worker) for each item in [0, numItems), the
+         * items being handed out in order as workers become free. Returns
+         * once all the items are done.
+         */
+        void parallelFor(size_t numItems, const std::function<void(size_t item, unsigned int worker)> &func);
+        /**
+         * Calls func(worker) once on each worker.
+         */
+        void runOnEach(const std::function<void(unsigned int worker)> &func);
+        ~RSGISWorkerPool();
+    protected:
+        void workerLoop(unsigned int worker);
+        void runJob(unsigned int worker);
+        void runAll();
+        unsigned int numThreads;
+        std::vector<std::thread> threads;
+        std::mutex poolMutex;
+        std::condition_variable startCond;
+        std::condition_variable doneCond;
+        unsigned long long generation;
+        unsigned int numActive;
+        bool stopping;
+        const std::function<void(size_t, unsigned int)> *itemFunc;
+        const std::function<void(unsigned int)> *eachFunc;
+        size_t numItems;
+        std::atomic<size_t> nextItem;
+        std::exception_ptr error;
+    };
+
+    /**
+     * Calls func(item, worker) for each item in [0, numItems) on a pool of
+     * up to numThreads workers (as for resolveNumThreads) created for the
+     * call.
+     */
+    DllExport void parallelFor(size_t numItems, unsigned int numThreads, const std::function<void(size_t item, unsigned int worker)> &func);
+
+}}
+
+#endif
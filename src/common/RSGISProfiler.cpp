@@ -0,0 +1,186 @@
+/*
+ *  RSGISProfiler.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISProfiler.h"
+
+namespace rsgis
+{
+    static int profileEnvLevel()
+    {
+        if(const char* env_p = std::getenv("RSGISLIB_PROFILE"))
+        {
+            return atoi(env_p);
+        }
+        return 0;
+    }
+
+    std::atomic<bool> RSGISProfiler::enabled(profileEnvLevel() > 0);
+    std::atomic<bool> RSGISProfiler::printSummaries(profileEnvLevel() > 1);
+    std::mutex RSGISProfiler::countersMutex;
+    std::map<std::string, RSGISProfileCounter> RSGISProfiler::counters;
+
+    void RSGISProfiler::setEnabled(bool enable)
+    {
+        enabled = enable;
+    }
+
+    bool RSGISProfiler::getPrintSummary()
+    {
+        return printSummaries;
+    }
+
+    void RSGISProfiler::setPrintSummary(bool printSummary)
+    {
+        printSummaries = printSummary;
+    }
+
+    void RSGISProfiler::record(const std::string &name, double seconds, uint64_t count, uint64_t bytes)
+    {
+        if(!isEnabled())
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(countersMutex);
+        RSGISProfileCounter &counter = counters[name];
+        counter.calls += 1;
+        counter.seconds += seconds;
+        counter.count += count;
+        counter.bytes += bytes;
+    }
+
+    void RSGISProfiler::addCount(const std::string &name, uint64_t count)
+    {
+        if(!isEnabled())
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(countersMutex);
+        RSGISProfileCounter &counter = counters[name];
+        counter.calls += 1;
+        counter.count += count;
+    }
+
+    std::map<std::string, RSGISProfileCounter> RSGISProfiler::getCounters()
+    {
+        std::lock_guard<std::mutex> lock(countersMutex);
+        return counters;
+    }
+
+    void RSGISProfiler::reset()
+    {
+        std::lock_guard<std::mutex> lock(countersMutex);
+        counters.clear();
+    }
+
+    void RSGISProfiler::printSummary(std::ostream &out, const std::map<std::string, RSGISProfileCounter> &counters)
+    {
+        for(std::map<std::string, RSGISProfileCounter>::const_iterator iterCounter = counters.begin(); iterCounter != counters.end(); ++iterCounter)
+        {
+            const RSGISProfileCounter &counter = iterCounter->second;
+            out << "  " << iterCounter->first << ": " << counter.calls << " calls";
+            if(counter.seconds > 0)
+            {
+                out << ", " << counter.seconds << " s";
+            }
+            if(counter.count > 0)
+            {
+                out << ", count " << counter.count;
+            }
+            if(counter.bytes > 0)
+            {
+                out << ", " << (((double)counter.bytes) / (1024.0 * 1024.0)) << " MiB";
+                if(counter.seconds > 0)
+                {
+                    out << " (" << ((((double)counter.bytes) / (1024.0 * 1024.0)) / counter.seconds) << " MiB/s)";
+                }
+            }
+            out << std::endl;
+        }
+    }
+
+    RSGISScopedTimer::RSGISScopedTimer(const char *name)
+    {
+        this->name = name;
+        this->active = RSGISProfiler::isEnabled();
+        this->count = 0;
+        this->bytes = 0;
+        if(this->active)
+        {
+            this->start = std::chrono::steady_clock::now();
+        }
+    }
+
+    void RSGISScopedTimer::stop()
+    {
+        if(this->active)
+        {
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - this->start;
+            RSGISProfiler::record(this->name, elapsed.count(), this->count, this->bytes);
+            this->active = false;
+        }
+    }
+
+    RSGISScopedTimer::~RSGISScopedTimer()
+    {
+        this->stop();
+    }
+
+    RSGISProfileSummaryScope::RSGISProfileSummaryScope(std::string label)
+    {
+        this->label = label;
+        this->active = RSGISProfiler::isEnabled() && RSGISProfiler::getPrintSummary();
+        if(this->active)
+        {
+            this->startCounters = RSGISProfiler::getCounters();
+        }
+    }
+
+    RSGISProfileSummaryScope::~RSGISProfileSummaryScope()
+    {
+        if(!this->active)
+        {
+            return;
+        }
+        // Only report what was recorded within this scope.
+        std::map<std::string, RSGISProfileCounter> counters = RSGISProfiler::getCounters();
+        for(std::map<std::string, RSGISProfileCounter>::iterator iterCounter = counters.begin(); iterCounter != counters.end(); )
+        {
+            std::map<std::string, RSGISProfileCounter>::iterator iterStart = this->startCounters.find(iterCounter->first);
+            if(iterStart != this->startCounters.end())
+            {
+                iterCounter->second.calls -= iterStart->second.calls;
+                iterCounter->second.seconds -= iterStart->second.seconds;
+                iterCounter->second.count -= iterStart->second.count;
+                iterCounter->second.bytes -= iterStart->second.bytes;
+            }
+            if(iterCounter->second.calls == 0)
+            {
+                iterCounter = counters.erase(iterCounter);
+            }
+            else
+            {
+                ++iterCounter;
+            }
+        }
+        std::cout << "Profile of " << this->label << ":" << std::endl;
+        RSGISProfiler::printSummary(std::cout, counters);
+    }
+}
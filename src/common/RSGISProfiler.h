@@ -0,0 +1,134 @@
+/*
+ *  RSGISProfiler.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISProfiler_H
+#define RSGISProfiler_H
+
+#include <iostream>
+#include <string>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <stdint.h>
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_commons_EXPORTS
+        #define DllExport __declspec( dllexport )
+    #else
+        #define DllExport __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis
+{
+    /**
+     * A named counter: the number of times it was recorded (e.g., blocks),
+     * the total time in seconds, a count of items (e.g., pixels or calls to
+     * a virtual function) and the number of bytes transferred.
+     */
+    struct DllExport RSGISProfileCounter
+    {
+        uint64_t calls;
+        double seconds;
+        uint64_t count;
+        uint64_t bytes;
+    };
+
+    /**
+     * Process wide, opt-in timing and I/O counters. Profiling is off unless
+     * the RSGISLIB_PROFILE environment variable is set to a value > 0 or
+     * setEnabled is called; a value of 2 also sets print summary. While off
+     * the record functions return immediately and RSGISScopedTimer does not
+     * read the clock, so instrumentation should be placed around blocks or
+     * rows rather than individual pixels.
+     *
+     * Counter names are '<module>.<phase>', e.g., 'calcimage.read'.
+     */
+    class DllExport RSGISProfiler
+    {
+    public:
+        static bool isEnabled() {return enabled.load(std::memory_order_relaxed);};
+        static void setEnabled(bool enable);
+        /**
+         * Print a summary of the counters recorded within each
+         * RSGISProfileSummaryScope (i.e., each instrumented command).
+         */
+        static bool getPrintSummary();
+        static void setPrintSummary(bool printSummary);
+        static void record(const std::string &name, double seconds, uint64_t count=0, uint64_t bytes=0);
+        static void addCount(const std::string &name, uint64_t count);
+        static std::map<std::string, RSGISProfileCounter> getCounters();
+        static void reset();
+        static void printSummary(std::ostream &out, const std::map<std::string, RSGISProfileCounter> &counters);
+    protected:
+        static std::atomic<bool> enabled;
+        static std::atomic<bool> printSummaries;
+        static std::mutex countersMutex;
+        static std::map<std::string, RSGISProfileCounter> counters;
+    };
+
+    /**
+     * Times its own lifetime into the named counter. The count and bytes
+     * can be added as the scope progresses.
+     */
+    class DllExport RSGISScopedTimer
+    {
+    public:
+        RSGISScopedTimer(const char *name);
+        void addCount(uint64_t count) {this->count += count;};
+        void addBytes(uint64_t bytes) {this->bytes += bytes;};
+        /**
+         * Record now rather than at the end of the scope.
+         */
+        void stop();
+        ~RSGISScopedTimer();
+    protected:
+        const char *name;
+        bool active;
+        uint64_t count;
+        uint64_t bytes;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    /**
+     * Prints the counters recorded during its lifetime when profiling and
+     * print summary are enabled.
+     */
+    class DllExport RSGISProfileSummaryScope
+    {
+    public:
+        RSGISProfileSummaryScope(std::string label);
+        ~RSGISProfileSummaryScope();
+    protected:
+        std::string label;
+        bool active;
+        std::map<std::string, RSGISProfileCounter> startCounters;
+    };
+}
+
+#endif
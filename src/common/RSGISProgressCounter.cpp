@@ -0,0 +1,134 @@
+/*
+ *  RSGISProgressCounter.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISProgressCounter.h"
+
+namespace rsgis
+{
+    std::mutex RSGISProgressCounter::callbackMutex;
+    RSGISProgressCallback RSGISProgressCounter::globalCallback;
+    std::atomic<int> RSGISProgressCounter::callbackScopes(0);
+
+    RSGISProgressCounter::RSGISProgressCounter(unsigned long long total, std::string label): done(0)
+    {
+        this->total = total;
+        this->lastReported = ULLONG_MAX;
+        this->label = label;
+        this->stopped = false;
+        this->finished = false;
+        int intervalMs = 250;
+        if(const char* env_p = std::getenv("RSGISLIB_PROGRESS_INTERVAL_MS"))
+        {
+            intervalMs = std::max(atoi(env_p), 10);
+        }
+        this->interval = std::chrono::milliseconds(intervalMs);
+        // The bar is only drawn by the reporter so is drawn every time it is given.
+        this->pbar.set_fixed_period(1);
+        if(label != "")
+        {
+            this->pbar.set_label(label);
+        }
+        // The callback is fixed for the life of the counter so a callback
+        // changed part way through is not given a partial job.
+        this->callback = getCallback();
+        this->reporter = std::thread(&RSGISProgressCounter::runReporter, this);
+    }
+
+    void RSGISProgressCounter::runReporter()
+    {
+        std::unique_lock<std::mutex> lock(this->stopMutex);
+        while(!this->stopped)
+        {
+            this->stopCond.wait_for(lock, this->interval);
+            if(this->stopped)
+            {
+                break;
+            }
+            lock.unlock();
+            this->report(this->done.load(std::memory_order_relaxed));
+            lock.lock();
+        }
+    }
+
+    void RSGISProgressCounter::report(unsigned long long curr)
+    {
+        if(curr == this->lastReported)
+        {
+            return;
+        }
+        this->lastReported = curr;
+        curr = std::min(curr, this->total);
+        if(this->total > 0)
+        {
+            // rsgis_tqdm counts with an int so very large totals are scaled.
+            unsigned long long scale = (this->total / INT_MAX) + 1;
+            this->pbar.progress((int)(curr / scale), (int)(this->total / scale));
+        }
+        if(this->callback)
+        {
+            try
+            {
+                this->callback(this->label, curr, this->total);
+            }
+            catch(...)
+            {
+                // A failing callback must not stop the processing.
+            }
+        }
+    }
+
+    void RSGISProgressCounter::finish()
+    {
+        if(this->finished)
+        {
+            return;
+        }
+        this->finished = true;
+        {
+            std::lock_guard<std::mutex> lock(this->stopMutex);
+            this->stopped = true;
+        }
+        this->stopCond.notify_all();
+        this->reporter.join();
+        this->report(this->done.load(std::memory_order_relaxed));
+        if(this->total > 0)
+        {
+            this->pbar.finish();
+        }
+    }
+
+    void RSGISProgressCounter::setCallback(RSGISProgressCallback callback)
+    {
+        std::lock_guard<std::mutex> lock(callbackMutex);
+        globalCallback = callback;
+    }
+
+    RSGISProgressCallback RSGISProgressCounter::getCallback()
+    {
+        std::lock_guard<std::mutex> lock(callbackMutex);
+        return globalCallback;
+    }
+
+    RSGISProgressCounter::~RSGISProgressCounter()
+    {
+        this->finish();
+    }
+}
@@ -0,0 +1,114 @@
+/*
+ *  RSGISProgressCounter.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISProgressCounter_H
+#define RSGISProgressCounter_H
+
+#include <iostream>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+
+#include "common/rsgis-tqdm.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_commons_EXPORTS
+        #define DllExport __declspec( dllexport )
+    #else
+        #define DllExport __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis
+{
+    /**
+     * Called with the label, the amount done and the total of a
+     * RSGISProgressCounter (from its reporter thread).
+     */
+    typedef std::function<void(const std::string &label, unsigned long long done, unsigned long long total)> RSGISProgressCallback;
+
+    /**
+     * A progress counter which can be updated from any number of worker
+     * threads without locking (a relaxed atomic add). A reporter thread wakes
+     * every intervalMs milliseconds (the RSGISLIB_PROGRESS_INTERVAL_MS
+     * environment variable, default 250) and, if the count has changed, draws
+     * the progress bar (rsgis_tqdm) and calls the callback set with
+     * setCallback (e.g., from Python). The output is therefore never garbled
+     * and its cost does not depend on the number of blocks.
+     *
+     * finish (or the destructor) stops the reporter and reports the end.
+     */
+    class DllExport RSGISProgressCounter
+    {
+    public:
+        RSGISProgressCounter(unsigned long long total, std::string label="");
+        void add(unsigned long long n=1){this->done.fetch_add(n, std::memory_order_relaxed);};
+        /// Set the amount done (e.g., where the work is resumed part way through)
+        void set(unsigned long long n){this->done.store(n, std::memory_order_relaxed);};
+        unsigned long long getDone(){return this->done.load(std::memory_order_relaxed);};
+        unsigned long long getTotal(){return this->total;};
+        void finish();
+        ~RSGISProgressCounter();
+        /// Set (or with an empty function clear) the callback given the progress of every counter
+        static void setCallback(RSGISProgressCallback callback);
+        /**
+         * Callers which can only take a callback at certain times (e.g., the
+         * Python bindings, which can only be called back while the GIL is
+         * released) mark those times with begin/endCallbackScope and check
+         * inCallbackScope within the callback.
+         */
+        static void beginCallbackScope(){callbackScopes.fetch_add(1);};
+        static void endCallbackScope(){callbackScopes.fetch_sub(1);};
+        static bool inCallbackScope(){return callbackScopes.load() > 0;};
+    protected:
+        void runReporter();
+        void report(unsigned long long curr);
+        static RSGISProgressCallback getCallback();
+        std::atomic<unsigned long long> done;
+        unsigned long long total;
+        unsigned long long lastReported;
+        std::string label;
+        std::chrono::milliseconds interval;
+        rsgis_tqdm pbar;
+        RSGISProgressCallback callback;
+        std::mutex stopMutex;
+        std::condition_variable stopCond;
+        bool stopped;
+        bool finished;
+        std::thread reporter;
+        static std::mutex callbackMutex;
+        static RSGISProgressCallback globalCallback;
+        static std::atomic<int> callbackScopes;
+    };
+}
+
+#endif
@@ -0,0 +1,193 @@
+/*
+ *  RSGISReduction.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISReduction_H
+#define RSGISReduction_H
+
+#include <iostream>
+#include <vector>
+#include <map>
+#include <utility>
+#include <mutex>
+#include <functional>
+#include <cmath>
+
+#include "common/RSGISException.h"
+
+namespace rsgis
+{
+    /**
+     * Neumaier's compensated sum: the rounding error of each addition is
+     * accumulated separately (comp) and added back in value(), so the sum of
+     * many values of differing magnitude keeps (nearly) full precision.
+     */
+    struct RSGISCompensatedSum
+    {
+        double sum;
+        double comp;
+        RSGISCompensatedSum(): sum(0), comp(0){};
+        inline void add(double val){RSGISCompensatedSum::add(this->sum, this->comp, val);};
+        inline void merge(const RSGISCompensatedSum &other)
+        {
+            RSGISCompensatedSum::add(this->sum, this->comp, other.sum);
+            this->comp += other.comp;
+        };
+        inline double value() const {return this->sum + this->comp;};
+        /**
+         * Add val to a sum held in place (e.g., within an array of values)
+         * with its compensation.
+         */
+        static inline void add(double &sum, double &comp, double val)
+        {
+            double t = sum + val;
+            if(std::fabs(sum) >= std::fabs(val))
+            {
+                comp += (sum - t) + val;
+            }
+            else
+            {
+                comp += (val - t) + sum;
+            }
+            sum = t;
+        };
+    };
+
+    /**
+     * Combines the partial results of numParts parts of a job (e.g., fixed
+     * blocks of rows of an image) in a fixed binary tree over the part
+     * indices, so the result does not depend on the number of threads nor on
+     * the order in which the parts are finished: floating point results are
+     * the same on every run.
+     *
+     * Parts are given with addPart (from any thread) as they are finished
+     * and are merged as soon as their sibling is available, with the merge
+     * function given the left then the right part (the right merged into
+     * the left). Only the parts waiting for a sibling are held so, where
+     * the parts are taken roughly in order, few are held at once. Where
+     * numParts is not a power of 2 the complete sub-trees are merged left
+     * to right by getResult.
+     */
+    template<typename T>
+    class RSGISTreeReduction
+    {
+    public:
+        typedef std::function<void(T &left, T &right)> MergeFunc;
+        RSGISTreeReduction(size_t numParts, MergeFunc mergeFunc)
+        {
+            this->numParts = numParts;
+            this->mergeFunc = mergeFunc;
+        };
+        /**
+         * Add the partial result of a part (numbered from 0), which is moved
+         * into the reduction.
+         */
+        void addPart(size_t partIdx, T &part)
+        {
+            if(partIdx >= this->numParts)
+            {
+                throw RSGISException("Part index is outside of the reduction.");
+            }
+            T curr(std::move(part));
+            unsigned int level = 0;
+            size_t idx = partIdx;
+            while(true)
+            {
+                // The parent covers [(idx/2) * 2^(level+1), ((idx/2)+1) * 2^(level+1)).
+                bool parentComplete = ((((idx >> 1) + 1) << (level + 1)) <= this->numParts);
+                T sibling;
+                {
+                    std::lock_guard<std::mutex> lock(this->pendingMutex);
+                    if(!parentComplete)
+                    {
+                        this->pending.insert(std::make_pair(std::make_pair(level, idx), std::move(curr)));
+                        return;
+                    }
+                    typename std::map<std::pair<unsigned int, size_t>, T>::iterator iterSibling = this->pending.find(std::make_pair(level, idx ^ 1));
+                    if(iterSibling == this->pending.end())
+                    {
+                        this->pending.insert(std::make_pair(std::make_pair(level, idx), std::move(curr)));
+                        return;
+                    }
+                    sibling = std::move(iterSibling->second);
+                    this->pending.erase(iterSibling);
+                }
+                if((idx & 1) == 0)
+                {
+                    this->mergeFunc(curr, sibling);
+                }
+                else
+                {
+                    this->mergeFunc(sibling, curr);
+                    curr = std::move(sibling);
+                }
+                idx = idx >> 1;
+                ++level;
+            }
+        };
+        /**
+         * Once all the parts have been added, the result of merging them.
+         */
+        void getResult(T *result)
+        {
+            std::lock_guard<std::mutex> lock(this->pendingMutex);
+            if(this->numParts == 0)
+            {
+                throw RSGISException("There are no parts to reduce.");
+            }
+            // The remaining (complete) sub-trees in order of their first part.
+            std::map<size_t, std::pair<size_t, T*> > roots;
+            for(typename std::map<std::pair<unsigned int, size_t>, T>::iterator iterPart = this->pending.begin(); iterPart != this->pending.end(); ++iterPart)
+            {
+                size_t rootSize = ((size_t)1) << iterPart->first.first;
+                roots[iterPart->first.second * rootSize] = std::make_pair(rootSize, &iterPart->second);
+            }
+            size_t expected = 0;
+            for(typename std::map<size_t, std::pair<size_t, T*> >::iterator iterRoot = roots.begin(); iterRoot != roots.end(); ++iterRoot)
+            {
+                if(iterRoot->first != expected)
+                {
+                    throw RSGISException("Not all the parts have been added to the reduction.");
+                }
+                expected += iterRoot->second.first;
+            }
+            if(expected != this->numParts)
+            {
+                throw RSGISException("Not all the parts have been added to the reduction.");
+            }
+            typename std::map<size_t, std::pair<size_t, T*> >::iterator iterRoot = roots.begin();
+            T &first = *iterRoot->second.second;
+            for(++iterRoot; iterRoot != roots.end(); ++iterRoot)
+            {
+                this->mergeFunc(first, *iterRoot->second.second);
+            }
+            *result = std::move(first);
+            this->pending.clear();
+        };
+        ~RSGISTreeReduction(){};
+    protected:
+        size_t numParts;
+        MergeFunc mergeFunc;
+        std::mutex pendingMutex;
+        std::map<std::pair<unsigned int, size_t>, T> pending;
+    };
+}
+
+#endif
@@ -0,0 +1,153 @@
+/*
+ *  RSGISScratchArena.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISScratchArena.h"
+
+#include <new>
+
+namespace rsgis
+{
+    static const size_t scratchAlignment = sizeof(long double) > sizeof(void*) ? sizeof(long double) : sizeof(void*);
+
+    RSGISScratchArena::RSGISScratchArena(size_t chunkSize)
+    {
+        this->chunkSize = (chunkSize == 0)?65536:chunkSize;
+        this->currentChunk = 0;
+        this->offset = 0;
+        this->numScopes = 0;
+    }
+
+    void* RSGISScratchArena::allocate(size_t bytes)
+    {
+        if(bytes == 0)
+        {
+            bytes = 1;
+        }
+        size_t start = (this->offset + scratchAlignment - 1) & ~(scratchAlignment - 1);
+        if((this->currentChunk < this->chunks.size()) && ((start + bytes) <= this->chunks[this->currentChunk].size))
+        {
+            this->offset = start + bytes;
+            return this->chunks[this->currentChunk].data + start;
+        }
+
+        // Move to the next chunk, dropping any (left from before a rewind)
+        // which are too small.
+        size_t nextChunk = this->chunks.empty()?0:(this->currentChunk + 1);
+        while((nextChunk < this->chunks.size()) && (this->chunks[nextChunk].size < bytes))
+        {
+            free(this->chunks[nextChunk].data);
+            this->chunks.erase(this->chunks.begin() + nextChunk);
+        }
+        if(nextChunk == this->chunks.size())
+        {
+            Chunk chunk;
+            chunk.size = (bytes > this->chunkSize)?bytes:this->chunkSize;
+            chunk.data = (char *) malloc(chunk.size);
+            if(chunk.data == NULL)
+            {
+                throw std::bad_alloc();
+            }
+            this->chunks.push_back(chunk);
+        }
+        this->currentChunk = nextChunk;
+        this->offset = bytes;
+        return this->chunks[nextChunk].data;
+    }
+
+    RSGISScratchMark RSGISScratchArena::getMark()
+    {
+        RSGISScratchMark mark;
+        mark.chunk = this->currentChunk;
+        mark.offset = this->offset;
+        return mark;
+    }
+
+    void RSGISScratchArena::rewind(const RSGISScratchMark &mark)
+    {
+        this->currentChunk = mark.chunk;
+        this->offset = mark.offset;
+    }
+
+    void RSGISScratchArena::reset()
+    {
+        if(this->numScopes > 0)
+        {
+            return;
+        }
+        if(this->chunks.size() > 1)
+        {
+            size_t totalSize = 0;
+            for(std::vector<Chunk>::iterator iterChunk = this->chunks.begin(); iterChunk != this->chunks.end(); ++iterChunk)
+            {
+                totalSize += (*iterChunk).size;
+                free((*iterChunk).data);
+            }
+            this->chunks.clear();
+            Chunk chunk;
+            chunk.size = totalSize;
+            chunk.data = (char *) malloc(chunk.size);
+            if(chunk.data == NULL)
+            {
+                throw std::bad_alloc();
+            }
+            this->chunks.push_back(chunk);
+        }
+        this->currentChunk = 0;
+        this->offset = 0;
+    }
+
+    size_t RSGISScratchArena::getCapacity()
+    {
+        size_t totalSize = 0;
+        for(std::vector<Chunk>::iterator iterChunk = this->chunks.begin(); iterChunk != this->chunks.end(); ++iterChunk)
+        {
+            totalSize += (*iterChunk).size;
+        }
+        return totalSize;
+    }
+
+    RSGISScratchArena* RSGISScratchArena::getThreadArena()
+    {
+        static thread_local RSGISScratchArena threadArena;
+        return &threadArena;
+    }
+
+    RSGISScratchArena::~RSGISScratchArena()
+    {
+        for(std::vector<Chunk>::iterator iterChunk = this->chunks.begin(); iterChunk != this->chunks.end(); ++iterChunk)
+        {
+            free((*iterChunk).data);
+        }
+    }
+
+    RSGISScratchScope::RSGISScratchScope(RSGISScratchArena *arena)
+    {
+        this->arena = arena;
+        this->mark = arena->getMark();
+        arena->enterScope();
+    }
+
+    RSGISScratchScope::~RSGISScratchScope()
+    {
+        this->arena->exitScope();
+        this->arena->rewind(this->mark);
+    }
+}
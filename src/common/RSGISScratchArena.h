@@ -0,0 +1,117 @@
+/*
+ *  RSGISScratchArena.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISScratchArena_H
+#define RSGISScratchArena_H
+
+#include <iostream>
+#include <vector>
+#include <cstddef>
+#include <cstdlib>
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_commons_EXPORTS
+        #define DllExport __declspec( dllexport )
+    #else
+        #define DllExport __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis
+{
+    /**
+     * A position within a RSGISScratchArena to rewind to.
+     */
+    struct DllExport RSGISScratchMark
+    {
+        size_t chunk;
+        size_t offset;
+    };
+
+    /**
+     * A bump allocator for short lived scratch memory (e.g., the temporary
+     * arrays needed to calculate a single pixel) so that a kernel does not
+     * need a malloc/free pair per call. Memory is only released by rewinding
+     * to a mark (see RSGISScratchScope) or by reset; no destructors are run
+     * so it is only suitable for trivial types.
+     *
+     * Each thread has its own arena (getThreadArena) so no locking is needed.
+     */
+    class DllExport RSGISScratchArena
+    {
+    public:
+        RSGISScratchArena(size_t chunkSize=65536);
+        void* allocate(size_t bytes);
+        template <typename T> T* alloc(size_t n) {return static_cast<T*>(this->allocate(sizeof(T) * n));};
+        RSGISScratchMark getMark();
+        void rewind(const RSGISScratchMark &mark);
+        /**
+         * Release everything, merging the chunks into one large enough for
+         * the peak use so far. Does nothing while a RSGISScratchScope is open.
+         */
+        void reset();
+        size_t getCapacity();
+        void enterScope() {++this->numScopes;};
+        void exitScope() {--this->numScopes;};
+        /**
+         * The calling thread's arena.
+         */
+        static RSGISScratchArena* getThreadArena();
+        ~RSGISScratchArena();
+    protected:
+        struct Chunk
+        {
+            char *data;
+            size_t size;
+        };
+        RSGISScratchArena(const RSGISScratchArena&);
+        RSGISScratchArena& operator=(const RSGISScratchArena&);
+        std::vector<Chunk> chunks;
+        size_t chunkSize;
+        size_t currentChunk;
+        size_t offset;
+        unsigned int numScopes;
+    };
+
+    /**
+     * Allocates from an arena, rewinding it to where it was at the end of
+     * the scope.
+     */
+    class DllExport RSGISScratchScope
+    {
+    public:
+        RSGISScratchScope(RSGISScratchArena *arena=RSGISScratchArena::getThreadArena());
+        template <typename T> T* alloc(size_t n) {return this->arena->alloc<T>(n);};
+        ~RSGISScratchScope();
+    protected:
+        RSGISScratchScope(const RSGISScratchScope&);
+        RSGISScratchScope& operator=(const RSGISScratchScope&);
+        RSGISScratchArena *arena;
+        RSGISScratchMark mark;
+    };
+}
+
+#endif
@@ -0,0 +1,222 @@
+/*
+ *  RSGISTextScanner.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISTextScanner.h"
+
+namespace rsgis
+{
+    static const char textCacheMagic[8] = {'R', 'S', 'G', 'T', 'X', 'C', '0', '1'};
+
+    RSGISTextScanner::RSGISTextScanner(): buffer(), fileSize(0), pos(0)
+    {
+
+    }
+
+    void RSGISTextScanner::openFile(std::string filepath)
+    {
+        std::ifstream inputFile(filepath.c_str(), std::ios::in | std::ios::binary);
+        if(!inputFile.is_open())
+        {
+            throw RSGISInputStreamException("Could not open input text file: " + filepath);
+        }
+        inputFile.seekg(0, std::ios::end);
+        std::streamoff length = inputFile.tellg();
+        inputFile.seekg(0, std::ios::beg);
+        if(length < 0)
+        {
+            throw RSGISInputStreamException("Could not read input text file: " + filepath);
+        }
+        this->fileSize = static_cast<size_t>(length);
+        this->buffer.resize(this->fileSize + 1);
+        if((this->fileSize > 0) && (!inputFile.read(this->buffer.data(), this->fileSize)))
+        {
+            throw RSGISInputStreamException("Could not read input text file: " + filepath);
+        }
+        this->buffer[this->fileSize] = '\0';
+        this->pos = 0;
+    }
+
+    bool RSGISTextScanner::nextLine(const char **lineStart, const char **lineEnd)
+    {
+        if(this->pos >= this->fileSize)
+        {
+            return false;
+        }
+        const char *data = this->buffer.data();
+        const char *start = data + this->pos;
+        const char *fileEnd = data + this->fileSize;
+        const char *end = start;
+        while((end < fileEnd) && (*end != '\n') && (*end != '\r'))
+        {
+            ++end;
+        }
+        *lineStart = start;
+        *lineEnd = end;
+
+        if((end < fileEnd) && (*end == '\r'))
+        {
+            ++end;
+        }
+        if((end < fileEnd) && (*end == '\n'))
+        {
+            ++end;
+        }
+        this->pos = end - data;
+        return true;
+    }
+
+    bool RSGISTextScanner::endOfFile()
+    {
+        return this->pos >= this->fileSize;
+    }
+
+    size_t RSGISTextScanner::parseValues(const char *start, const char *end, char delimiter, std::vector<double> *values)
+    {
+        size_t numVals = 0;
+        const char *tokStart = start;
+        while(tokStart <= end)
+        {
+            const char *tokEnd = static_cast<const char*>(memchr(tokStart, delimiter, end - tokStart));
+            if(tokEnd == NULL)
+            {
+                tokEnd = end;
+            }
+            char *numEnd = NULL;
+            double value = strtod(tokStart, &numEnd);
+            if((numEnd == tokStart) || (numEnd > tokEnd))
+            {
+                value = 0;
+            }
+            values->push_back(value);
+            ++numVals;
+            tokStart = tokEnd + 1;
+        }
+        return numVals;
+    }
+
+    std::string RSGISTextScanner::getCacheFilePath(std::string textFile)
+    {
+        return textFile + std::string(".rsgiscache");
+    }
+
+    bool RSGISTextScanner::getFileStamp(std::string filepath, uint64_t *fileSize, int64_t *lastWrite)
+    {
+        boost::system::error_code ec;
+        boost::filesystem::path path(filepath);
+        *fileSize = boost::filesystem::file_size(path, ec);
+        if(ec)
+        {
+            return false;
+        }
+        *lastWrite = boost::filesystem::last_write_time(path, ec);
+        return !ec;
+    }
+
+    bool RSGISTextScanner::readValuesCache(std::string textFile, std::vector<int64_t> *header, std::vector<double> *values)
+    {
+        uint64_t textSize = 0;
+        int64_t textWrite = 0;
+        if(!RSGISTextScanner::getFileStamp(textFile, &textSize, &textWrite))
+        {
+            return false;
+        }
+        std::ifstream cacheFile(RSGISTextScanner::getCacheFilePath(textFile).c_str(), std::ios::in | std::ios::binary);
+        if(!cacheFile.is_open())
+        {
+            return false;
+        }
+
+        char magic[8];
+        uint64_t cacheTextSize = 0;
+        int64_t cacheTextWrite = 0;
+        uint64_t numHeader = 0;
+        cacheFile.read(magic, 8);
+        cacheFile.read((char *) &cacheTextSize, sizeof(uint64_t));
+        cacheFile.read((char *) &cacheTextWrite, sizeof(int64_t));
+        cacheFile.read((char *) &numHeader, sizeof(uint64_t));
+        if((!cacheFile) || (memcmp(magic, textCacheMagic, 8) != 0) || (cacheTextSize != textSize) || (cacheTextWrite != textWrite) || (numHeader > 1024))
+        {
+            return false;
+        }
+        header->resize(numHeader);
+        if(numHeader > 0)
+        {
+            cacheFile.read((char *) header->data(), sizeof(int64_t) * numHeader);
+        }
+        uint64_t numValues = 0;
+        cacheFile.read((char *) &numValues, sizeof(uint64_t));
+        // The values cannot take more space than the text they were parsed from.
+        if((!cacheFile) || (numValues > textSize))
+        {
+            return false;
+        }
+        values->resize(numValues);
+        if(numValues > 0)
+        {
+            cacheFile.read((char *) values->data(), sizeof(double) * numValues);
+        }
+        return !cacheFile.fail();
+    }
+
+    bool RSGISTextScanner::writeValuesCache(std::string textFile, const std::vector<int64_t> &header, const std::vector<double> &values)
+    {
+        uint64_t textSize = 0;
+        int64_t textWrite = 0;
+        if(!RSGISTextScanner::getFileStamp(textFile, &textSize, &textWrite))
+        {
+            return false;
+        }
+        std::ofstream cacheFile(RSGISTextScanner::getCacheFilePath(textFile).c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if(!cacheFile.is_open())
+        {
+            return false;
+        }
+        uint64_t numHeader = header.size();
+        uint64_t numValues = values.size();
+        cacheFile.write(textCacheMagic, 8);
+        cacheFile.write((const char *) &textSize, sizeof(uint64_t));
+        cacheFile.write((const char *) &textWrite, sizeof(int64_t));
+        cacheFile.write((const char *) &numHeader, sizeof(uint64_t));
+        if(numHeader > 0)
+        {
+            cacheFile.write((const char *) header.data(), sizeof(int64_t) * numHeader);
+        }
+        cacheFile.write((const char *) &numValues, sizeof(uint64_t));
+        if(numValues > 0)
+        {
+            cacheFile.write((const char *) values.data(), sizeof(double) * numValues);
+        }
+        cacheFile.close();
+        return !cacheFile.fail();
+    }
+
+    void RSGISTextScanner::closeFile()
+    {
+        std::vector<char>().swap(this->buffer);
+        this->fileSize = 0;
+        this->pos = 0;
+    }
+
+    RSGISTextScanner::~RSGISTextScanner()
+    {
+
+    }
+}
@@ -0,0 +1,108 @@
+/*
+ *  RSGISTextScanner.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISTextScanner_H
+#define RSGISTextScanner_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+
+#include <boost/filesystem.hpp>
+
+#include "common/RSGISInputStreamException.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_commons_EXPORTS
+        #define DllExport __declspec( dllexport )
+    #else
+        #define DllExport __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis
+{
+    /**
+     * Scans a text file which has been read into memory with a single read,
+     * returning the lines as pointers into the buffer and parsing numbers in
+     * place (strtod on the buffer) so no std::string is created for each
+     * line or value. The buffer is NUL terminated so parsing a value cannot
+     * run past the end of the file.
+     *
+     * A binary cache of the values parsed from a text file can be written
+     * alongside it (the text file path with '.rsgiscache' appended), which is
+     * only used while the size and modification time of the text file are
+     * those recorded in the cache.
+     */
+    class DllExport RSGISTextScanner
+    {
+    public:
+        RSGISTextScanner();
+        /**
+         * Read the whole file into memory, throwing RSGISInputStreamException
+         * if it cannot be read.
+         */
+        void openFile(std::string filepath);
+        /**
+         * The next line, [lineStart, lineEnd), without its line ending (\n,
+         * \r\n or \r). Returns false once all the lines have been read.
+         */
+        bool nextLine(const char **lineStart, const char **lineEnd);
+        bool endOfFile();
+        /**
+         * Append the values of the tokens of [start, end), separated by the
+         * delimiter, to values and return the number of tokens. end must be
+         * at a delimiter or line end. As with strtod on each token, leading
+         * whitespace is skipped, anything after the number is ignored and a
+         * token which does not start with a number is 0.
+         */
+        static size_t parseValues(const char *start, const char *end, char delimiter, std::vector<double> *values);
+        static std::string getCacheFilePath(std::string textFile);
+        /**
+         * Read the cache of textFile into header and values, returning false
+         * if there is no cache or it is out of date.
+         */
+        static bool readValuesCache(std::string textFile, std::vector<int64_t> *header, std::vector<double> *values);
+        /**
+         * Write the cache of textFile, returning false (rather than throwing)
+         * if it could not be written as the cache is optional.
+         */
+        static bool writeValuesCache(std::string textFile, const std::vector<int64_t> &header, const std::vector<double> &values);
+        void closeFile();
+        ~RSGISTextScanner();
+    protected:
+        static bool getFileStamp(std::string filepath, uint64_t *fileSize, int64_t *lastWrite);
+        std::vector<char> buffer;
+        size_t fileSize;
+        size_t pos;
+    };
+}
+
+#endif
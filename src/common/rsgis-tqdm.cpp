@@ -86,6 +86,12 @@ namespace rsgis {
         this->use_colors = true;
     }
 
+    void rsgis_tqdm::set_fixed_period(int period_)
+    {
+        this->period = std::max(period_, 1);
+        this->learn_period = false;
+    }
+
     void rsgis_tqdm::finish()
     {
         this->progress(total_,total_);
@@ -129,7 +135,7 @@ namespace rsgis {
 
             // learn an appropriate period length to avoid spamming stdout
             // and slowing down the loop, shoot for ~25Hz and smooth over 3 seconds
-            if (nupdates > 10)
+            if (learn_period && (nupdates > 10))
             {
                 period = (int)( std::min(std::max((1.0/25)*curr/dt_tot,1.0), 5e5));
                 smoothing = 25*3;
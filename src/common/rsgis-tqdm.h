@@ -57,6 +57,8 @@ namespace rsgis
             void set_theme_basic();
             void set_label(std::string label_);
             void enable_colors();
+            // Update on every call of progress (every period'th value) rather than learning the period
+            void set_fixed_period(int period_);
             void finish();
             void progress(int curr, int tot);
             ~rsgis_tqdm();
@@ -71,6 +73,7 @@ namespace rsgis
             int nupdates = 0;
             int total_ = 0;
             int period = 1;
+            bool learn_period = true;
             unsigned int smoothing = 50;
             bool use_ema = true;
             float alpha_ema = 0.1;
@@ -0,0 +1,380 @@
+/*
+ *  RSGISGLCMTextures.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISGLCMTextures.h"
+
+namespace rsgis{namespace filter{
+    
+    RSGISGLCMTextures::RSGISGLCMTextures(unsigned int numLevels, unsigned int winSize, std::vector<RSGISGLCMMeasure> measures, int xOffset, int yOffset)
+    {
+        if((numLevels < 2) || (numLevels > 256))
+        {
+            throw rsgis::img::RSGISImageCalcException("The number of grey levels must be between 2 and 256.");
+        }
+        if((winSize % 2 == 0) || (winSize < 3))
+        {
+            throw rsgis::img::RSGISImageCalcException("Window size needs to be an odd number (min = 3).");
+        }
+        if(((xOffset == 0) && (yOffset == 0)) || (((unsigned int)std::abs(xOffset)) >= winSize) || (((unsigned int)std::abs(yOffset)) >= winSize))
+        {
+            throw rsgis::img::RSGISImageCalcException("The pixel offset must not be 0 and must be within the window.");
+        }
+        if(measures.empty())
+        {
+            throw rsgis::img::RSGISImageCalcException("At least one GLCM measure must be specified.");
+        }
+        this->numLevels = numLevels;
+        this->winSize = winSize;
+        this->measures = measures;
+        this->xOffset = xOffset;
+        this->yOffset = yOffset;
+        this->calcEntropy = (std::find(measures.begin(), measures.end(), glcm_entropy) != measures.end());
+        
+        this->homogWeights.resize(numLevels);
+        for(unsigned int d = 0; d < numLevels; ++d)
+        {
+            this->homogWeights[d] = 1.0/(1.0 + (((double)d) * d));
+        }
+        // A cell of the symmetric matrix can be counted twice for each pair in the window.
+        size_t maxCount = 2 * ((size_t)winSize) * winSize;
+        this->countLnCount.resize(maxCount + 1, 0.0);
+        for(size_t c = 1; c <= maxCount; ++c)
+        {
+            this->countLnCount[c] = c * log((double)c);
+        }
+        
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+    
+    void RSGISGLCMTextures::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+    
+    std::string RSGISGLCMTextures::getMeasureName(RSGISGLCMMeasure measure)
+    {
+        switch(measure)
+        {
+            case glcm_contrast:
+                return "Contrast";
+            case glcm_dissimilarity:
+                return "Dissimilarity";
+            case glcm_homogeneity:
+                return "Homogeneity";
+            case glcm_asm:
+                return "ASM";
+            case glcm_energy:
+                return "Energy";
+            case glcm_entropy:
+                return "Entropy";
+            case glcm_mean:
+                return "Mean";
+            case glcm_variance:
+                return "Variance";
+            case glcm_correlation:
+                return "Correlation";
+        }
+        throw rsgis::img::RSGISImageCalcException("GLCM measure not recognised.");
+    }
+    
+    void RSGISGLCMTextures::calcTextures(GDALDataset *inputImageDS, unsigned int band, std::string outputImage, std::string gdalFormat, GDALDataType gdalDataType, double minVal, double maxVal, bool useNoData, float noDataVal)
+    {
+        rsgis::img::RSGISImageUtils imgUtils;
+        GDALDataset *outputImageDS = NULL;
+        try
+        {
+            if((band == 0) || (((int)band) > inputImageDS->GetRasterCount()))
+            {
+                throw rsgis::img::RSGISImageCalcException("The band specified is not within the image. Band numbering starts at 1.");
+            }
+            GDALRasterBand *inputBand = inputImageDS->GetRasterBand(band);
+            int width = inputImageDS->GetRasterXSize();
+            int height = inputImageDS->GetRasterYSize();
+            
+            if(minVal >= maxVal)
+            {
+                double minMax[2];
+                if(inputBand->ComputeRasterMinMax(FALSE, minMax) != CE_None)
+                {
+                    throw rsgis::img::RSGISImageCalcException("Could not calculate the minimum and maximum of the band.");
+                }
+                minVal = minMax[0];
+                maxVal = minMax[1];
+            }
+            double levelScale = (maxVal > minVal)?(this->numLevels / (maxVal - minVal)):0.0;
+            std::cout << "Quantising [" << minVal << ", " << maxVal << "] to " << this->numLevels << " grey levels\n";
+            
+            // Create new Image
+            GDALDriver *gdalDriver = GetGDALDriverManager()->GetDriverByName(gdalFormat.c_str());
+            if(gdalDriver == NULL)
+            {
+                throw rsgis::img::RSGISImageBandException("Driver does not exists..");
+            }
+            char **papszOptions = imgUtils.getGDALCreationOptionsForFormat(gdalFormat);
+            unsigned int numMeasures = this->measures.size();
+            std::cout << "New image width = " << width << " height = " << height << " bands = " << numMeasures << std::endl;
+            outputImageDS = gdalDriver->Create(outputImage.c_str(), width, height, numMeasures, gdalDataType, papszOptions);
+            if(outputImageDS == NULL)
+            {
+                throw rsgis::img::RSGISImageBandException("Output image could not be created. Check filepath.");
+            }
+            double gdalTranslation[6];
+            inputImageDS->GetGeoTransform(gdalTranslation);
+            outputImageDS->SetGeoTransform(gdalTranslation);
+            outputImageDS->SetProjection(inputImageDS->GetProjectionRef());
+            std::vector<GDALRasterBand*> outputRasterBands;
+            for(unsigned int i = 0; i < numMeasures; ++i)
+            {
+                outputRasterBands.push_back(outputImageDS->GetRasterBand(i+1));
+                outputRasterBands[i]->SetDescription(getMeasureName(this->measures[i]).c_str());
+            }
+            
+            int winRad = this->winSize / 2;
+            int xBlockSize = 0;
+            int yBlockSize = 0;
+            inputBand->GetBlockSize(&xBlockSize, &yBlockSize);
+            yBlockSize = std::max(yBlockSize, 16);
+            unsigned int nBlocks = (height + yBlockSize - 1) / yBlockSize;
+            
+            std::mutex ioMutex;
+            unsigned int nBlocksDone = 0;
+            rsgis_tqdm pbar;
+            try
+            {
+                rsgis::utils::parallelFor(nBlocks, this->numThreads, [&](size_t blk, unsigned int)
+                {
+                    // The block with winRad rows and columns of padding (-1, i.e., not counted).
+                    int padWidth = width + 2*winRad;
+                    std::vector<float> readData(((size_t)width) * (yBlockSize + 2*winRad));
+                    std::vector<short> quantData(((size_t)padWidth) * (yBlockSize + 2*winRad));
+                    std::vector<float> outData(((size_t)width) * yBlockSize * numMeasures);
+                    std::vector<float*> outRows(numMeasures);
+                    GLCMAccum accum;
+                    accum.counts.resize(((size_t)this->numLevels) * this->numLevels);
+
+                    int yOff = blk * yBlockSize;
+                    int nRows = std::min(yBlockSize, height - yOff);
+                    int readStart = std::max(yOff - winRad, 0);
+                    int readEnd = std::min(yOff + nRows + winRad, height);
+                    {
+                        std::lock_guard<std::mutex> lock(ioMutex);
+                        if(inputBand->RasterIO(GF_Read, 0, readStart, width, readEnd - readStart, readData.data(), width, readEnd - readStart, GDT_Float32, 0, 0, NULL) != CE_None)
+                        {
+                            throw rsgis::RSGISImageException("Could not read a block of the input image.");
+                        }
+                    }
+                    
+                    std::fill(quantData.begin(), quantData.end(), -1);
+                    for(int r = readStart; r < readEnd; ++r)
+                    {
+                        const float *inRow = readData.data() + (((size_t)(r - readStart)) * width);
+                        short *qRow = quantData.data() + (((size_t)(r - (yOff - winRad))) * padWidth) + winRad;
+                        for(int c = 0; c < width; ++c)
+                        {
+                            float val = inRow[c];
+                            if(std::isnan(val) || (useNoData && (val == noDataVal)))
+                            {
+                                continue;
+                            }
+                            int level = (int)floor((val - minVal) * levelScale);
+                            qRow[c] = (short)std::min(std::max(level, 0), ((int)this->numLevels) - 1);
+                        }
+                    }
+                    
+                    for(int r = 0; r < nRows; ++r)
+                    {
+                        for(unsigned int m = 0; m < numMeasures; ++m)
+                        {
+                            outRows[m] = outData.data() + (((size_t)m) * width * yBlockSize) + (((size_t)r) * width);
+                        }
+                        this->calcRow(quantData.data(), padWidth, width, r, accum, outRows.data());
+                    }
+                    
+                    std::lock_guard<std::mutex> lock(ioMutex);
+                    for(unsigned int m = 0; m < numMeasures; ++m)
+                    {
+                        if(outputRasterBands[m]->RasterIO(GF_Write, 0, yOff, width, nRows, outData.data() + (((size_t)m) * width * yBlockSize), width, nRows, GDT_Float32, 0, 0, NULL) != CE_None)
+                        {
+                            throw rsgis::RSGISImageException("Could not write a block of the output image.");
+                        }
+                    }
+                    pbar.progress(++nBlocksDone, nBlocks);
+                });
+            }
+            catch(...)
+            {
+                pbar.finish();
+                throw;
+            }
+            pbar.finish();
+            
+            GDALClose(outputImageDS);
+            outputImageDS = NULL;
+        }
+        catch(rsgis::RSGISException& e)
+        {
+            if(outputImageDS != NULL)
+            {
+                GDALClose(outputImageDS);
+            }
+            throw;
+        }
+    }
+    
+    void RSGISGLCMTextures::updateColumn(const short *quantData, int padWidth, int col, int rowStart, int rowEnd, long long sign, GLCMAccum &accum) const
+    {
+        long long levels = this->numLevels;
+        long pairOff = (((long)this->yOffset) * padWidth) + this->xOffset;
+        for(int r = rowStart; r <= rowEnd; ++r)
+        {
+            size_t idx = (((size_t)r) * padWidth) + col;
+            long long a = quantData[idx];
+            long long b = quantData[idx + pairOff];
+            if((a < 0) || (b < 0))
+            {
+                continue;
+            }
+            long long diff = (a > b)?(a - b):(b - a);
+            // Symmetric, so the pair is counted as (a, b) and (b, a).
+            long long *cellAB = &accum.counts[(a*levels)+b];
+            long long *cellBA = &accum.counts[(b*levels)+a];
+            if(this->calcEntropy)
+            {
+                accum.sumCountLnCount -= this->countLnCount[*cellAB];
+                if(cellBA != cellAB)
+                {
+                    accum.sumCountLnCount -= this->countLnCount[*cellBA];
+                }
+            }
+            accum.sumCountSq -= ((*cellAB) * (*cellAB));
+            if(cellBA != cellAB)
+            {
+                accum.sumCountSq -= ((*cellBA) * (*cellBA));
+            }
+            *cellAB += sign;
+            *cellBA += sign;
+            accum.sumCountSq += ((*cellAB) * (*cellAB));
+            if(cellBA != cellAB)
+            {
+                accum.sumCountSq += ((*cellBA) * (*cellBA));
+            }
+            if(this->calcEntropy)
+            {
+                accum.sumCountLnCount += this->countLnCount[*cellAB];
+                if(cellBA != cellAB)
+                {
+                    accum.sumCountLnCount += this->countLnCount[*cellBA];
+                }
+            }
+            
+            accum.n += 2*sign;
+            accum.sumContrast += 2*sign*(diff*diff);
+            accum.sumDissim += 2*sign*diff;
+            accum.sumHomog += 2*sign*this->homogWeights[diff];
+            accum.sumI += sign*(a + b);
+            accum.sumISq += sign*((a*a) + (b*b));
+            accum.sumIJ += 2*sign*(a*b);
+        }
+    }
+    
+    void RSGISGLCMTextures::calcRow(const short *quantData, int padWidth, int width, int winTop, GLCMAccum &accum, float **outRows) const
+    {
+        std::fill(accum.counts.begin(), accum.counts.end(), 0);
+        accum.n = 0;
+        accum.sumContrast = 0;
+        accum.sumDissim = 0;
+        accum.sumI = 0;
+        accum.sumISq = 0;
+        accum.sumIJ = 0;
+        accum.sumCountSq = 0;
+        accum.sumHomog = 0;
+        accum.sumCountLnCount = 0;
+        
+        // The first pixels of the pairs with both pixels in the window.
+        int win = this->winSize;
+        int rowStart = winTop + std::max(0, -this->yOffset);
+        int rowEnd = winTop + win - 1 - std::max(0, this->yOffset);
+        int colLo = std::max(0, -this->xOffset);
+        int colHi = win - 1 - std::max(0, this->xOffset);
+        for(int c = colLo; c <= colHi; ++c)
+        {
+            this->updateColumn(quantData, padWidth, c, rowStart, rowEnd, 1, accum);
+        }
+        
+        unsigned int numMeasures = this->measures.size();
+        for(int x = 0; x < width; ++x)
+        {
+            if(x > 0)
+            {
+                // Slide the window one column to the right.
+                this->updateColumn(quantData, padWidth, colLo + x - 1, rowStart, rowEnd, -1, accum);
+                this->updateColumn(quantData, padWidth, colHi + x, rowStart, rowEnd, 1, accum);
+            }
+            for(unsigned int m = 0; m < numMeasures; ++m)
+            {
+                outRows[m][x] = this->calcMeasure(this->measures[m], accum);
+            }
+        }
+    }
+    
+    double RSGISGLCMTextures::calcMeasure(RSGISGLCMMeasure measure, const GLCMAccum &accum) const
+    {
+        if(accum.n == 0)
+        {
+            return 0;
+        }
+        double n = accum.n;
+        // Each pair adds two to n and its two grey levels to sumI (and squares to sumISq).
+        double mean = accum.sumI / n;
+        double variance = std::max((accum.sumISq / n) - (mean * mean), 0.0);
+        switch(measure)
+        {
+            case glcm_contrast:
+                return accum.sumContrast / n;
+            case glcm_dissimilarity:
+                return accum.sumDissim / n;
+            case glcm_homogeneity:
+                return accum.sumHomog / n;
+            case glcm_asm:
+                return accum.sumCountSq / (n * n);
+            case glcm_energy:
+                return sqrt(accum.sumCountSq / (n * n));
+            case glcm_entropy:
+                return log(n) - (accum.sumCountLnCount / n);
+            case glcm_mean:
+                return mean;
+            case glcm_variance:
+                return variance;
+            case glcm_correlation:
+                if(variance > 0)
+                {
+                    return ((accum.sumIJ / n) - (mean * mean)) / variance;
+                }
+                return 0;
+        }
+        throw rsgis::img::RSGISImageCalcException("GLCM measure not recognised.");
+    }
+    
+    RSGISGLCMTextures::~RSGISGLCMTextures()
+    {
+        
+    }
+}}
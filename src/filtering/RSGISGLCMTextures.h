@@ -0,0 +1,148 @@
+/*
+ *  RSGISGLCMTextures.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISGLCMTextures_H
+#define RSGISGLCMTextures_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <exception>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#include "gdal_priv.h"
+
+#include "common/rsgis-tqdm.h"
+#include "common/RSGISImageException.h"
+#include "common/RSGISParallel.h"
+
+#include "img/RSGISImageCalcException.h"
+#include "img/RSGISImageUtils.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_filter_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace filter{
+
+    enum RSGISGLCMMeasure
+    {
+        glcm_contrast,
+        glcm_dissimilarity,
+        glcm_homogeneity,
+        glcm_asm,
+        glcm_energy,
+        glcm_entropy,
+        glcm_mean,
+        glcm_variance,
+        glcm_correlation
+    };
+
+	class DllExport RSGISGLCMTextures
+    {
+        /**
+            Grey level co-occurrence matrix (GLCM) texture measures (Haralick et al., 1973)
+            within a winSize x winSize window around each pixel of an image band.
+
+            The band is quantised to numLevels grey levels between minVal and maxVal and the
+            (symmetric) co-occurrence matrix of the pairs of pixels separated by the offset
+            (xOffset, yOffset) which are both within the window is kept as the window slides
+            along each row: the pairs of the column leaving the window are removed and those
+            of the column entering it added. The sums from which the measures are calculated
+            (e.g., sum of count x (i-j)^2 for the contrast, or of count^2 for the angular second
+            moment) are updated with the counts, so each pixel costs O(winSize) however many
+            grey levels or measures are used and all the measures come from the same matrix.
+
+            Pixels which are NaN or the no data value, and pixels outside the image, are not
+            counted and pixels whose window has no pairs are 0. The image is processed in blocks
+            of rows shared among threads (setNumThreads or the RSGISLIB_NUM_THREADS environment
+            variable).
+         */
+    public:
+        RSGISGLCMTextures(unsigned int numLevels, unsigned int winSize, std::vector<RSGISGLCMMeasure> measures, int xOffset=1, int yOffset=0);
+        /**
+         * The number of threads (0 uses the number of cores).
+         */
+        void setNumThreads(unsigned int numThreads);
+        /**
+         * Calculate the measures for a band (numbered from 1) of the image, with a band
+         * for each measure in the output image. If minVal >= maxVal the band minimum and
+         * maximum are used for the quantisation.
+         */
+        void calcTextures(GDALDataset *inputImageDS, unsigned int band, std::string outputImage, std::string gdalFormat="KEA", GDALDataType gdalDataType=GDT_Float32, double minVal=0, double maxVal=0, bool useNoData=false, float noDataVal=0);
+        static std::string getMeasureName(RSGISGLCMMeasure measure);
+        ~RSGISGLCMTextures();
+    protected:
+        /**
+         * The co-occurrence counts of a window and the sums of the measures over them.
+         */
+        struct GLCMAccum
+        {
+            std::vector<long long> counts;
+            long long n;
+            long long sumContrast;
+            long long sumDissim;
+            long long sumI;
+            long long sumISq;
+            long long sumIJ;
+            long long sumCountSq;
+            double sumHomog;
+            double sumCountLnCount;
+        };
+        /**
+         * Add (sign=1) or remove (sign=-1) the pairs whose first pixel is in column col and
+         * rows rowStart to rowEnd (inclusive) of the quantised data.
+         */
+        void updateColumn(const short *quantData, int padWidth, int col, int rowStart, int rowEnd, long long sign, GLCMAccum &accum) const;
+        /**
+         * Calculate the measures for the row of windows whose top is row winTop of the
+         * quantised data, with outRows[measure][x].
+         */
+        void calcRow(const short *quantData, int padWidth, int width, int winTop, GLCMAccum &accum, float **outRows) const;
+        double calcMeasure(RSGISGLCMMeasure measure, const GLCMAccum &accum) const;
+        unsigned int numLevels;
+        unsigned int winSize;
+        std::vector<RSGISGLCMMeasure> measures;
+        int xOffset;
+        int yOffset;
+        bool calcEntropy;
+        unsigned int numThreads;
+        // 1/(1+d^2) for each grey level difference d and c.ln(c) for each count c.
+        std::vector<double> homogWeights;
+        std::vector<double> countLnCount;
+    };
+}}
+
+#endif
@@ -45,6 +45,119 @@ namespace rsgis{namespace filter{
 		}
 	}
 	
+	void RSGISImageFilter::runBlockFilter(GDALDataset **datasets, int numDS, std::string outputImage, std::string gdalFormat, GDALDataType outDataType, BlockFilterFunc filterFunc)
+	{
+		if((this->size % 2 == 0) || (this->size < 3))
+		{
+			throw rsgis::img::RSGISImageCalcException("Window size needs to be 3 or greater and an odd number.");
+		}
+		
+		rsgis::img::RSGISImageUtils imgUtils;
+		double gdalTranslation[6];
+		int **dsOffsets = new int*[numDS];
+		for(int i = 0; i < numDS; i++)
+		{
+			dsOffsets[i] = new int[2];
+		}
+		GDALDataset *outputImageDS = NULL;
+		
+		try
+		{
+			int width = 0;
+			int height = 0;
+			int xBlockSize = 0;
+			int yBlockSize = 0;
+			imgUtils.getImageOverlap(datasets, numDS, dsOffsets, &width, &height, gdalTranslation, &xBlockSize, &yBlockSize);
+			
+			std::vector<GDALRasterBand*> inputBands;
+			std::vector<int> bandXOffs;
+			std::vector<int> bandYOffs;
+			for(int i = 0; i < numDS; i++)
+			{
+				for(int j = 0; j < datasets[i]->GetRasterCount(); j++)
+				{
+					inputBands.push_back(datasets[i]->GetRasterBand(j+1));
+					bandXOffs.push_back(dsOffsets[i][0]);
+					bandYOffs.push_back(dsOffsets[i][1]);
+				}
+			}
+			int numOutBands = this->getNumOutBands();
+			if(numOutBands > ((int)inputBands.size()))
+			{
+				throw rsgis::img::RSGISImageCalcException("There are more output bands than input image bands to be filtered.");
+			}
+			
+			GDALDriver *gdalDriver = GetGDALDriverManager()->GetDriverByName(gdalFormat.c_str());
+			if(gdalDriver == NULL)
+			{
+				throw rsgis::img::RSGISImageBandException("Driver does not exists..");
+			}
+			char **papszOptions = imgUtils.getGDALCreationOptionsForFormat(gdalFormat);
+			outputImageDS = gdalDriver->Create(outputImage.c_str(), width, height, numOutBands, outDataType, papszOptions);
+			if(outputImageDS == NULL)
+			{
+				throw rsgis::img::RSGISImageBandException("Output image could not be created. Check filepath.");
+			}
+			outputImageDS->SetGeoTransform(gdalTranslation);
+			outputImageDS->SetProjection(datasets[0]->GetProjectionRef());
+			
+			int winMid = this->size / 2;
+			// Blocks are at least the size of the window so the rows read
+			// around each block are a small part of the rows read.
+			int nBlockRows = std::max(std::max(yBlockSize, 1), this->size * 4);
+			size_t inWidth = ((size_t)width) + this->size - 1;
+			std::vector<float> inData(inWidth * (nBlockRows + this->size - 1));
+			std::vector<double> outData(((size_t)width) * nBlockRows);
+			
+			rsgis_tqdm pbar;
+			for(int yOff = 0; yOff < height; yOff += nBlockRows)
+			{
+				pbar.progress(yOff, height);
+				int nRows = std::min(nBlockRows, height - yOff);
+				// The rows of the window for the block, limited to the image.
+				int inStart = std::max(yOff - winMid, 0);
+				int inEnd = std::min(yOff + nRows + winMid, height);
+				int padTop = inStart - (yOff - winMid);
+				size_t nInRows = nRows + this->size - 1;
+				for(int n = 0; n < numOutBands; n++)
+				{
+					std::fill(inData.begin(), inData.begin() + (inWidth * nInRows), 0.0f);
+					float *inStartPxl = inData.data() + (padTop * inWidth) + winMid;
+					if(inputBands[n]->RasterIO(GF_Read, bandXOffs[n], bandYOffs[n] + inStart, width, (inEnd - inStart), inStartPxl, width, (inEnd - inStart), GDT_Float32, sizeof(float), inWidth * sizeof(float)) != CE_None)
+					{
+						throw rsgis::img::RSGISImageBandException("Could not read the image block to be filtered.");
+					}
+					filterFunc(inData.data(), width, nRows, outData.data());
+					if(outputImageDS->GetRasterBand(n+1)->RasterIO(GF_Write, 0, yOff, width, nRows, outData.data(), width, nRows, GDT_Float64, 0, 0) != CE_None)
+					{
+						throw rsgis::img::RSGISImageBandException("Could not write the filtered image block.");
+					}
+				}
+			}
+			pbar.finish();
+		}
+		catch(RSGISImageException &e)
+		{
+			if(outputImageDS != NULL)
+			{
+				GDALClose(outputImageDS);
+			}
+			for(int i = 0; i < numDS; i++)
+			{
+				delete[] dsOffsets[i];
+			}
+			delete[] dsOffsets;
+			throw e;
+		}
+		
+		GDALClose(outputImageDS);
+		for(int i = 0; i < numDS; i++)
+		{
+			delete[] dsOffsets[i];
+		}
+		delete[] dsOffsets;
+	}
+	
 	rsgis::img::RSGISCalcImage* RSGISImageFilter::getCalcImage()
 	{
 		return new rsgis::img::RSGISCalcImage(this, "", true);
@@ -25,6 +25,9 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
 
 #include "common/RSGISImageException.h"
 
@@ -32,6 +35,7 @@
 #include "img/RSGISImageCalcException.h"
 #include "img/RSGISCalcImage.h"
 #include "img/RSGISCalcImageValue.h"
+#include "img/RSGISImageUtils.h"
 
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
@@ -59,7 +63,7 @@ namespace rsgis{namespace filter{
 		{
 		public: 
 			RSGISImageFilter(int numberOutBands, int size, std::string filenameEnding);
-			void runFilter(GDALDataset **datasets, int numDS, std::string outputImage, std::string gdalFormat, GDALDataType outDataType);
+			virtual void runFilter(GDALDataset **datasets, int numDS, std::string outputImage, std::string gdalFormat, GDALDataType outDataType);
 			virtual rsgis::img::RSGISCalcImage* getCalcImage();
 			virtual void calcImageValue(float *bandValues, int numBands, double *output);
 			virtual void calcImageValue(float *bandValues, int numBands);
@@ -75,6 +79,17 @@ namespace rsgis{namespace filter{
 			virtual std::string getFileNameEnding();
 			~RSGISImageFilter();
 		protected:
+			/**
+			 * Filters a block of nRows rows: inData holds the (nRows + size - 1)
+			 * rows of (width + size - 1) values within the windows of the block
+			 * (0 outside the image) and outData is nRows x width.
+			 */
+			typedef std::function<void(const float *inData, int width, int nRows, double *outData)> BlockFilterFunc;
+			/**
+			 * Run a filter over each band one block of rows at a time, rather than
+			 * calling calcImageValue for the window of each pixel.
+			 */
+			void runBlockFilter(GDALDataset **datasets, int numDS, std::string outputImage, std::string gdalFormat, GDALDataType outDataType, BlockFilterFunc filterFunc);
 			int size;
 			std::string filenameEnding;
 		};
@@ -52,6 +52,19 @@ namespace rsgis{namespace filter{
 		}
 	}
 	
+	void RSGISImageKernelFilter::runFilter(GDALDataset **datasets, int numDS, std::string outputImage, std::string gdalFormat, GDALDataType outDataType)
+	{
+		if((this->filter == NULL) || (this->filter->size != this->size))
+		{
+			throw rsgis::img::RSGISImageCalcException("Filter Size and window size do not match.");
+		}
+		RSGISKernelConvolution convolution(this->filter);
+		this->runBlockFilter(datasets, numDS, outputImage, gdalFormat, outDataType, [&convolution](const float *inData, int width, int nRows, double *outData)
+		{
+			convolution.convolve(inData, width, nRows, outData);
+		});
+	}
+	
 	bool RSGISImageKernelFilter::calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) 
 	{
 		throw rsgis::img::RSGISImageCalcException("Not implemented");
@@ -25,6 +25,8 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <algorithm>
 
 #include "common/RSGISImageException.h"
 
@@ -33,6 +35,7 @@
 #include "img/RSGISCalcImage.h"
 #include "img/RSGISCalcImageValue.h"
 #include "filtering/RSGISImageFilter.h"
+#include "filtering/RSGISKernelConvolution.h"
 
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
@@ -50,10 +53,17 @@
 namespace rsgis{namespace filter{
 	
 	
+	/**
+	 * Applies a filter kernel to each image band. runFilter processes blocks
+	 * of rows (with runBlockFilter) using RSGISKernelConvolution (so separable and mean kernels are
+	 * not applied with a full size x size sum for each pixel) while
+	 * calcImageValue is still available for other uses of the filter.
+	 */
 	class DllExport RSGISImageKernelFilter : public RSGISImageFilter
 		{
 		public: 
 			RSGISImageKernelFilter(int numberOutBands, int size, std::string filenameEnding, ImageFilter *filter);
+			virtual void runFilter(GDALDataset **datasets, int numDS, std::string outputImage, std::string gdalFormat, GDALDataType outDataType);
 			virtual void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output);
 			virtual bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output);
 			virtual void exportAsImage(std::string filename);
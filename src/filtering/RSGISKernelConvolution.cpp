@@ -0,0 +1,206 @@
+/*
+ *  RSGISKernelConvolution.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2010 RSGISLib. All rights reserved.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISKernelConvolution.h"
+
+namespace rsgis{namespace filter{
+
+    RSGISKernelConvolution::RSGISKernelConvolution(ImageFilter *filter)
+    {
+        if((filter == NULL) || (filter->size < 1))
+        {
+            throw RSGISImageFilterException("A filter kernel must be provided.");
+        }
+        this->size = filter->size;
+        this->kernel.resize(((size_t)size) * size);
+        bool allSame = true;
+        int maxRow = 0;
+        int maxCol = 0;
+        double maxAbs = 0;
+        for(int j = 0; j < size; ++j)
+        {
+            for(int k = 0; k < size; ++k)
+            {
+                double val = filter->filter[j][k];
+                this->kernel[(j*size)+k] = val;
+                if(val != filter->filter[0][0])
+                {
+                    allSame = false;
+                }
+                if(std::fabs(val) > maxAbs)
+                {
+                    maxAbs = std::fabs(val);
+                    maxRow = j;
+                    maxCol = k;
+                }
+            }
+        }
+
+        if(allSame)
+        {
+            this->method = rsgis_kernel_box;
+            return;
+        }
+
+        // A rank one kernel is the product of the column and row through its
+        // largest value.
+        this->kernelCol.resize(size);
+        this->kernelRow.resize(size);
+        for(int j = 0; j < size; ++j)
+        {
+            this->kernelCol[j] = this->kernel[(j*size)+maxCol];
+        }
+        for(int k = 0; k < size; ++k)
+        {
+            this->kernelRow[k] = this->kernel[(maxRow*size)+k] / this->kernel[(maxRow*size)+maxCol];
+        }
+        this->method = rsgis_kernel_separable;
+        for(int j = 0; (j < size) && (this->method == rsgis_kernel_separable); ++j)
+        {
+            for(int k = 0; k < size; ++k)
+            {
+                if(std::fabs(this->kernel[(j*size)+k] - (this->kernelCol[j] * this->kernelRow[k])) > (maxAbs * 1e-6))
+                {
+                    this->method = rsgis_kernel_direct;
+                    break;
+                }
+            }
+        }
+    }
+
+    void RSGISKernelConvolution::convolve(const float *inData, int width, int nRows, double *outData)
+    {
+        size_t inWidth = ((size_t)width) + size - 1;
+        this->colData.resize(inWidth);
+        double *cols = this->colData.data();
+
+        if(this->method == rsgis_kernel_box)
+        {
+            // Running sums of size rows for each column and then of size columns.
+            double kernelVal = this->kernel[0];
+            for(size_t x = 0; x < inWidth; ++x)
+            {
+                cols[x] = 0;
+            }
+            for(int j = 0; j < (size-1); ++j)
+            {
+                const float *inRow = inData + (j * inWidth);
+                for(size_t x = 0; x < inWidth; ++x)
+                {
+                    cols[x] += inRow[x];
+                }
+            }
+            for(int y = 0; y < nRows; ++y)
+            {
+                const float *addRow = inData + ((y + size - 1) * inWidth);
+                for(size_t x = 0; x < inWidth; ++x)
+                {
+                    cols[x] += addRow[x];
+                }
+
+                double *outRow = outData + (((size_t)y) * width);
+                double sum = 0;
+                for(int k = 0; k < (size-1); ++k)
+                {
+                    sum += cols[k];
+                }
+                for(int x = 0; x < width; ++x)
+                {
+                    sum += cols[x + size - 1];
+                    outRow[x] = sum * kernelVal;
+                    sum -= cols[x];
+                }
+
+                const float *subRow = inData + (y * inWidth);
+                for(size_t x = 0; x < inWidth; ++x)
+                {
+                    cols[x] -= subRow[x];
+                }
+            }
+        }
+        else if(this->method == rsgis_kernel_separable)
+        {
+            for(int y = 0; y < nRows; ++y)
+            {
+                for(size_t x = 0; x < inWidth; ++x)
+                {
+                    cols[x] = 0;
+                }
+                for(int j = 0; j < size; ++j)
+                {
+                    const float *inRow = inData + ((y + j) * inWidth);
+                    double colVal = this->kernelCol[j];
+                    for(size_t x = 0; x < inWidth; ++x)
+                    {
+                        cols[x] += inRow[x] * colVal;
+                    }
+                }
+
+                double *outRow = outData + (((size_t)y) * width);
+                for(int x = 0; x < width; ++x)
+                {
+                    outRow[x] = 0;
+                }
+                for(int k = 0; k < size; ++k)
+                {
+                    double rowVal = this->kernelRow[k];
+                    const double *colsK = cols + k;
+                    for(int x = 0; x < width; ++x)
+                    {
+                        outRow[x] += colsK[x] * rowVal;
+                    }
+                }
+            }
+        }
+        else
+        {
+            for(int y = 0; y < nRows; ++y)
+            {
+                double *outRow = outData + (((size_t)y) * width);
+                for(int x = 0; x < width; ++x)
+                {
+                    outRow[x] = 0;
+                }
+                for(int j = 0; j < size; ++j)
+                {
+                    const float *inRow = inData + ((y + j) * inWidth);
+                    for(int k = 0; k < size; ++k)
+                    {
+                        double kernelVal = this->kernel[(j*size)+k];
+                        const float *inRowK = inRow + k;
+                        for(int x = 0; x < width; ++x)
+                        {
+                            outRow[x] += inRowK[x] * kernelVal;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    RSGISKernelConvolution::~RSGISKernelConvolution()
+    {
+
+    }
+
+}}
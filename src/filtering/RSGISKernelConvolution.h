@@ -0,0 +1,93 @@
+/*
+ *  RSGISKernelConvolution.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2010 RSGISLib. All rights reserved.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISKernelConvolution_H
+#define RSGISKernelConvolution_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+
+#include "filtering/RSGISImageFilter.h"
+#include "filtering/RSGISImageFilterException.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_filter_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace filter{
+
+    enum RSGISKernelConvolutionMethod
+    {
+        rsgis_kernel_direct, // full size x size multiply-add for each pixel.
+        rsgis_kernel_separable, // a column pass and a row pass of length size.
+        rsgis_kernel_box // running sums, independent of the kernel size.
+    };
+
+    /**
+     * Applies a filter kernel (as RSGISImageKernelFilter, i.e., without
+     * flipping the kernel) to whole rows of an image rather than one window
+     * at a time.
+     *
+     * The kernel is examined when it is constructed: kernels where all the
+     * values are the same (e.g., mean filters) are applied with running sums,
+     * kernels which are the outer product of a column and a row (e.g.,
+     * Gaussian kernels from RSGISGenerateFilter) are applied as a column pass
+     * followed by a row pass and other kernels are applied directly, with the
+     * inner loop over a row of pixels so it can be vectorised.
+     */
+    class DllExport RSGISKernelConvolution
+    {
+    public:
+        RSGISKernelConvolution(ImageFilter *filter);
+        RSGISKernelConvolutionMethod getMethod(){return method;};
+        /**
+         * Filter nRows rows of width pixels. inData holds the (nRows + size - 1)
+         * rows of (width + size - 1) values required, with the size/2 rows and
+         * columns around the block (0 outside the image), and outData is
+         * nRows x width.
+         */
+        void convolve(const float *inData, int width, int nRows, double *outData);
+        ~RSGISKernelConvolution();
+    protected:
+        int size;
+        RSGISKernelConvolutionMethod method;
+        std::vector<double> kernel;
+        std::vector<double> kernelCol;
+        std::vector<double> kernelRow;
+        std::vector<double> colData;
+    };
+
+}}
+
+#endif
@@ -35,6 +35,25 @@ namespace rsgis{namespace filter{
         {
             throw rsgis::img::RSGISImageCalcException("Morphological operator must be a square matrix.");
         }
+
+        if(RSGISMorphologyRectOps::isRectOperator(matrixOperator))
+        {
+            // Rectangular operators use running maximums rather than the full window.
+            rsgis::img::RSGISImageUtils imgUtils;
+            GDALDataset *outDataset = imgUtils.createCopy(datasets[0], outputImage, format, outDataType);
+            RSGISMorphologyRectOps rectOps(matrixOperator);
+            try
+            {
+                rectOps.applyOps(datasets[0], outDataset, std::vector<RSGISMorphologyOp>(1, rsgis_morph_dilate));
+            }
+            catch(RSGISImageException &e)
+            {
+                GDALClose(outDataset);
+                throw e;
+            }
+            GDALClose(outDataset);
+            return;
+        }
         
 		int numBands = datasets[0]->GetRasterCount();
 		RSGISMorphologyDilate *dilateImage = new RSGISMorphologyDilate(numBands, matrixOperator);
@@ -38,6 +38,31 @@ namespace rsgis{namespace filter{
             {
                 throw rsgis::img::RSGISImageCalcException("Morphological operator must be a square matrix.");
             }
+
+            if(RSGISMorphologyRectOps::isRectOperator(matrixOperator))
+            {
+                // Rectangular operators are applied to each block of rows in memory, so no temporary image is needed.
+                rsgis::img::RSGISImageUtils imgUtils;
+                GDALDataset *outDataset = imgUtils.createCopy(dataset, outputImage, format, outDataType);
+                std::vector<RSGISMorphologyOp> ops;
+                for(unsigned int i = 0; i < numIterations; ++i)
+                {
+                    ops.push_back(rsgis_morph_erode);
+                    ops.push_back(rsgis_morph_dilate);
+                }
+                RSGISMorphologyRectOps rectOps(matrixOperator);
+                try
+                {
+                    rectOps.applyOps(dataset, outDataset, ops);
+                }
+                catch(RSGISImageException &e)
+                {
+                    GDALClose(outDataset);
+                    throw e;
+                }
+                GDALClose(outDataset);
+                return;
+            }
             
             rsgis::img::RSGISImageUtils imgUtils;
             GDALDataset *outDataset = NULL;
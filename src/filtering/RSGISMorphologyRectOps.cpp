@@ -0,0 +1,361 @@
+/*
+ *  RSGISMorphologyRectOps.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2010 RSGISLib. All rights reserved.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISMorphologyRectOps.h"
+
+namespace rsgis{namespace filter{
+
+    struct RSGISMorphMinOp
+    {
+        inline float operator()(float a, float b) const {return (b < a)?b:a;};
+    };
+
+    struct RSGISMorphMaxOp
+    {
+        inline float operator()(float a, float b) const {return (b > a)?b:a;};
+    };
+
+    /**
+     * out[i] = op(in[i+start], ..., in[i+start+k-1]) for each of the n values,
+     * with 0 outside of in. Each line is split into sections of k values with
+     * the running value forwards (fwd) and backwards (bwd) within each section,
+     * so any window of k values is op(bwd[first], fwd[last]).
+     */
+    template <typename Op>
+    static void rsgisMorphVHGWLine(const float *inData, int n, int start, int k, float *outData, std::vector<float> *fwd, std::vector<float> *bwd)
+    {
+        Op op;
+        int pad = std::abs(start) + k;
+        int extLen = n + (2 * pad);
+        fwd->resize(extLen);
+        bwd->resize(extLen);
+        float *fwdVals = fwd->data();
+        float *bwdVals = bwd->data();
+        for(int e = 0; e < extLen; ++e)
+        {
+            int i = e - pad;
+            float val = ((i >= 0) && (i < n))?inData[i]:0.0f;
+            fwdVals[e] = ((e % k) == 0)?val:op(fwdVals[e-1], val);
+        }
+        for(int e = extLen-1; e >= 0; --e)
+        {
+            int i = e - pad;
+            float val = ((i >= 0) && (i < n))?inData[i]:0.0f;
+            bwdVals[e] = (((e % k) == (k-1)) || (e == (extLen-1)))?val:op(bwdVals[e+1], val);
+        }
+        for(int i = 0; i < n; ++i)
+        {
+            int e = i + start + pad;
+            outData[i] = op(bwdVals[e], fwdVals[e+k-1]);
+        }
+    }
+
+    /**
+     * As rsgisMorphVHGWLine but down the columns of nRows rows of width
+     * values, processing whole rows at a time.
+     */
+    template <typename Op>
+    static void rsgisMorphVHGWColumns(const float *inData, int width, int nRows, int start, int k, float *outData, std::vector<float> *fwd, std::vector<float> *bwd)
+    {
+        Op op;
+        int pad = std::abs(start) + k;
+        int extLen = nRows + (2 * pad);
+        size_t rowLen = width;
+        fwd->resize(extLen * rowLen);
+        bwd->resize(extLen * rowLen);
+        for(int e = 0; e < extLen; ++e)
+        {
+            int i = e - pad;
+            float *fwdRow = fwd->data() + (e * rowLen);
+            if((i >= 0) && (i < nRows))
+            {
+                const float *inRow = inData + (i * rowLen);
+                if((e % k) == 0)
+                {
+                    std::copy(inRow, inRow + rowLen, fwdRow);
+                }
+                else
+                {
+                    const float *prevRow = fwdRow - rowLen;
+                    for(size_t x = 0; x < rowLen; ++x)
+                    {
+                        fwdRow[x] = op(prevRow[x], inRow[x]);
+                    }
+                }
+            }
+            else
+            {
+                if((e % k) == 0)
+                {
+                    std::fill(fwdRow, fwdRow + rowLen, 0.0f);
+                }
+                else
+                {
+                    const float *prevRow = fwdRow - rowLen;
+                    for(size_t x = 0; x < rowLen; ++x)
+                    {
+                        fwdRow[x] = op(prevRow[x], 0.0f);
+                    }
+                }
+            }
+        }
+        for(int e = extLen-1; e >= 0; --e)
+        {
+            int i = e - pad;
+            float *bwdRow = bwd->data() + (e * rowLen);
+            bool sectionEnd = (((e % k) == (k-1)) || (e == (extLen-1)));
+            if((i >= 0) && (i < nRows))
+            {
+                const float *inRow = inData + (i * rowLen);
+                if(sectionEnd)
+                {
+                    std::copy(inRow, inRow + rowLen, bwdRow);
+                }
+                else
+                {
+                    const float *nextRow = bwdRow + rowLen;
+                    for(size_t x = 0; x < rowLen; ++x)
+                    {
+                        bwdRow[x] = op(nextRow[x], inRow[x]);
+                    }
+                }
+            }
+            else
+            {
+                if(sectionEnd)
+                {
+                    std::fill(bwdRow, bwdRow + rowLen, 0.0f);
+                }
+                else
+                {
+                    const float *nextRow = bwdRow + rowLen;
+                    for(size_t x = 0; x < rowLen; ++x)
+                    {
+                        bwdRow[x] = op(nextRow[x], 0.0f);
+                    }
+                }
+            }
+        }
+        for(int i = 0; i < nRows; ++i)
+        {
+            int e = i + start + pad;
+            const float *bwdRow = bwd->data() + (e * rowLen);
+            const float *fwdRow = fwd->data() + ((e + k - 1) * rowLen);
+            float *outRow = outData + (i * rowLen);
+            for(size_t x = 0; x < rowLen; ++x)
+            {
+                outRow[x] = op(bwdRow[x], fwdRow[x]);
+            }
+        }
+    }
+
+    RSGISMorphologyRectOps::RSGISMorphologyRectOps(rsgis::math::Matrix *matrixOperator)
+    {
+        if(!RSGISMorphologyRectOps::isRectOperator(matrixOperator))
+        {
+            throw rsgis::img::RSGISImageCalcException("The morphological operator is not a rectangle.");
+        }
+        int winSize = matrixOperator->n;
+        int minRow = winSize;
+        int maxRow = -1;
+        int minCol = winSize;
+        int maxCol = -1;
+        for(int i = 0; i < winSize; ++i)
+        {
+            for(int j = 0; j < winSize; ++j)
+            {
+                if(matrixOperator->matrix[(i*winSize)+j] > 0)
+                {
+                    minRow = std::min(minRow, i);
+                    maxRow = std::max(maxRow, i);
+                    minCol = std::min(minCol, j);
+                    maxCol = std::max(maxCol, j);
+                }
+            }
+        }
+        this->winMid = winSize / 2;
+        this->startX = minCol - this->winMid;
+        this->lenX = (maxCol - minCol) + 1;
+        this->startY = minRow - this->winMid;
+        this->lenY = (maxRow - minRow) + 1;
+    }
+
+    bool RSGISMorphologyRectOps::isRectOperator(rsgis::math::Matrix *matrixOperator)
+    {
+        if((matrixOperator == NULL) || (matrixOperator->n != matrixOperator->m) || (matrixOperator->n < 1))
+        {
+            return false;
+        }
+        int winSize = matrixOperator->n;
+        int minRow = winSize;
+        int maxRow = -1;
+        int minCol = winSize;
+        int maxCol = -1;
+        for(int i = 0; i < winSize; ++i)
+        {
+            for(int j = 0; j < winSize; ++j)
+            {
+                if(matrixOperator->matrix[(i*winSize)+j] > 0)
+                {
+                    minRow = std::min(minRow, i);
+                    maxRow = std::max(maxRow, i);
+                    minCol = std::min(minCol, j);
+                    maxCol = std::max(maxCol, j);
+                }
+            }
+        }
+        if(maxRow < 0)
+        {
+            return false;
+        }
+        for(int i = minRow; i <= maxRow; ++i)
+        {
+            for(int j = minCol; j <= maxCol; ++j)
+            {
+                if(!(matrixOperator->matrix[(i*winSize)+j] > 0))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    void RSGISMorphologyRectOps::applyOps(GDALDataset *dataset, GDALDataset *outDataset, std::vector<RSGISMorphologyOp> ops)
+    {
+        this->applyOpsBlocks(dataset, outDataset, ops, std::vector<RSGISMorphologyOp>(), false);
+    }
+
+    void RSGISMorphologyRectOps::applyOpsDiff(GDALDataset *dataset, GDALDataset *outDataset, std::vector<RSGISMorphologyOp> ops, std::vector<RSGISMorphologyOp> subOps)
+    {
+        this->applyOpsBlocks(dataset, outDataset, ops, subOps, true);
+    }
+
+    void RSGISMorphologyRectOps::applyOp(RSGISMorphologyOp op, const float *inData, int width, int nRows, float *outData)
+    {
+        this->rowPassBuf.resize(((size_t)width) * nRows);
+        float *rowPass = this->rowPassBuf.data();
+        if(op == rsgis_morph_erode)
+        {
+            for(int i = 0; i < nRows; ++i)
+            {
+                rsgisMorphVHGWLine<RSGISMorphMinOp>(inData + (((size_t)i) * width), width, this->startX, this->lenX, rowPass + (((size_t)i) * width), &this->fwdBuf, &this->bwdBuf);
+            }
+            rsgisMorphVHGWColumns<RSGISMorphMinOp>(rowPass, width, nRows, this->startY, this->lenY, outData, &this->fwdBuf, &this->bwdBuf);
+        }
+        else
+        {
+            for(int i = 0; i < nRows; ++i)
+            {
+                rsgisMorphVHGWLine<RSGISMorphMaxOp>(inData + (((size_t)i) * width), width, this->startX, this->lenX, rowPass + (((size_t)i) * width), &this->fwdBuf, &this->bwdBuf);
+            }
+            rsgisMorphVHGWColumns<RSGISMorphMaxOp>(rowPass, width, nRows, this->startY, this->lenY, outData, &this->fwdBuf, &this->bwdBuf);
+        }
+    }
+
+    void RSGISMorphologyRectOps::applyOpsChain(const std::vector<RSGISMorphologyOp> &ops, const float *inData, int width, int nRows, float *outData)
+    {
+        size_t nVals = ((size_t)width) * nRows;
+        if(ops.empty())
+        {
+            std::copy(inData, inData + nVals, outData);
+            return;
+        }
+        // Alternate between outData and chainBuf so the last operation writes
+        // to outData.
+        this->chainBuf.resize(nVals);
+        const float *opIn = inData;
+        for(size_t n = 0; n < ops.size(); ++n)
+        {
+            float *opOut = (((ops.size() - n) % 2) == 1)?outData:this->chainBuf.data();
+            this->applyOp(ops[n], opIn, width, nRows, opOut);
+            opIn = opOut;
+        }
+    }
+
+    void RSGISMorphologyRectOps::applyOpsBlocks(GDALDataset *dataset, GDALDataset *outDataset, std::vector<RSGISMorphologyOp> ops, std::vector<RSGISMorphologyOp> subOps, bool diff)
+    {
+        int width = dataset->GetRasterXSize();
+        int height = dataset->GetRasterYSize();
+        int numBands = dataset->GetRasterCount();
+        if((outDataset->GetRasterXSize() != width) || (outDataset->GetRasterYSize() != height) || (outDataset->GetRasterCount() != numBands))
+        {
+            throw rsgis::img::RSGISImageCalcException("The input and output images are not the same size.");
+        }
+
+        // Each operation needs winMid rows either side of its output, so the
+        // rows read around a block are enough for all the operations.
+        int numOps = std::max(ops.size(), subOps.size());
+        int haloRows = numOps * this->winMid;
+        int xBlockSize = 0;
+        int yBlockSize = 0;
+        dataset->GetRasterBand(1)->GetBlockSize(&xBlockSize, &yBlockSize);
+        int nBlockRows = std::max(std::max(yBlockSize, 1), haloRows * 4);
+
+        std::vector<float> inData;
+        std::vector<float> opsData;
+        std::vector<float> subOpsData;
+        for(int yOff = 0; yOff < height; yOff += nBlockRows)
+        {
+            int nRows = std::min(nBlockRows, height - yOff);
+            int inStart = std::max(yOff - haloRows, 0);
+            int inEnd = std::min(yOff + nRows + haloRows, height);
+            int nInRows = inEnd - inStart;
+            size_t nInVals = ((size_t)width) * nInRows;
+            size_t outOffset = ((size_t)(yOff - inStart)) * width;
+            inData.resize(nInVals);
+            opsData.resize(nInVals);
+            if(diff)
+            {
+                subOpsData.resize(nInVals);
+            }
+
+            for(int b = 0; b < numBands; ++b)
+            {
+                if(dataset->GetRasterBand(b+1)->RasterIO(GF_Read, 0, inStart, width, nInRows, inData.data(), width, nInRows, GDT_Float32, 0, 0) != CE_None)
+                {
+                    throw rsgis::img::RSGISImageBandException("Could not read the image block.");
+                }
+                this->applyOpsChain(ops, inData.data(), width, nInRows, opsData.data());
+                if(diff)
+                {
+                    this->applyOpsChain(subOps, inData.data(), width, nInRows, subOpsData.data());
+                    for(size_t i = outOffset; i < (outOffset + (((size_t)width) * nRows)); ++i)
+                    {
+                        opsData[i] = opsData[i] - subOpsData[i];
+                    }
+                }
+                if(outDataset->GetRasterBand(b+1)->RasterIO(GF_Write, 0, yOff, width, nRows, opsData.data() + outOffset, width, nRows, GDT_Float32, 0, 0) != CE_None)
+                {
+                    throw rsgis::img::RSGISImageBandException("Could not write the image block.");
+                }
+            }
+        }
+    }
+
+    RSGISMorphologyRectOps::~RSGISMorphologyRectOps()
+    {
+
+    }
+
+}}
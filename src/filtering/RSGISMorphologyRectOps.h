@@ -0,0 +1,117 @@
+/*
+ *  RSGISMorphologyRectOps.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2010 RSGISLib. All rights reserved.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISMorphologyRectOps_H
+#define RSGISMorphologyRectOps_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+#include "gdal_priv.h"
+
+#include "common/RSGISImageException.h"
+#include "img/RSGISImageCalcException.h"
+#include "img/RSGISImageBandException.h"
+#include "math/RSGISMatrices.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_filter_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace filter{
+
+    enum RSGISMorphologyOp
+    {
+        rsgis_morph_erode,
+        rsgis_morph_dilate
+    };
+
+    /**
+     * Erosion and dilation for operators where the non-zero values form a
+     * rectangle within the matrix (including square operators and horizontal
+     * or vertical lines) using the van Herk/Gil-Werman algorithm, so the cost
+     * per pixel does not depend on the operator size: a rectangle is a row
+     * pass followed by a column pass, each taking ~3 comparisons per pixel.
+     *
+     * Sequences of operations (e.g., opening and closing) and the differences
+     * used for the top-hat and gradient images are calculated for each block
+     * of rows in memory, reading the rows around the block required by all
+     * the operations, rather than writing an image for each step. As with the
+     * window based implementations (RSGISMorphologyErode, etc.) pixels outside
+     * the image are 0 for every operation.
+     */
+    class DllExport RSGISMorphologyRectOps
+    {
+    public:
+        RSGISMorphologyRectOps(rsgis::math::Matrix *matrixOperator);
+        /**
+         * Whether the values greater than 0 within the (square) operator form
+         * a rectangle, so it can be used with this class.
+         */
+        static bool isRectOperator(rsgis::math::Matrix *matrixOperator);
+        /**
+         * Apply the operations in turn to each band of dataset, writing the
+         * result to outDataset, which must be the same size.
+         */
+        void applyOps(GDALDataset *dataset, GDALDataset *outDataset, std::vector<RSGISMorphologyOp> ops);
+        /**
+         * Write the result of the ops minus the result of the subOps, where
+         * an empty list of operations is the input image (e.g., input -
+         * opening for a white top-hat or dilation - erosion for the gradient).
+         */
+        void applyOpsDiff(GDALDataset *dataset, GDALDataset *outDataset, std::vector<RSGISMorphologyOp> ops, std::vector<RSGISMorphologyOp> subOps);
+        /**
+         * Apply an operation to nRows rows of width values, with values
+         * outside of the data taken as 0.
+         */
+        void applyOp(RSGISMorphologyOp op, const float *inData, int width, int nRows, float *outData);
+        ~RSGISMorphologyRectOps();
+    protected:
+        void applyOpsBlocks(GDALDataset *dataset, GDALDataset *outDataset, std::vector<RSGISMorphologyOp> ops, std::vector<RSGISMorphologyOp> subOps, bool diff);
+        void applyOpsChain(const std::vector<RSGISMorphologyOp> &ops, const float *inData, int width, int nRows, float *outData);
+        int winMid;
+        int startX;
+        int lenX;
+        int startY;
+        int lenY;
+        std::vector<float> rowPassBuf;
+        std::vector<float> fwdBuf;
+        std::vector<float> bwdBuf;
+        std::vector<float> chainBuf;
+    };
+
+}}
+
+#endif
@@ -37,6 +37,28 @@ namespace rsgis{namespace filter{
             {
                 throw rsgis::img::RSGISImageCalcException("Morphological operator must be a square matrix.");
             }
+
+            if(RSGISMorphologyRectOps::isRectOperator(matrixOperator))
+            {
+                // Rectangular operators are applied to each block of rows in memory, so no temporary image is needed.
+                rsgis::img::RSGISImageUtils imgUtils;
+                GDALDataset *outDataset = imgUtils.createCopy(dataset, outputImage, format, outDataType);
+                std::vector<RSGISMorphologyOp> ops;
+                ops.push_back(rsgis_morph_dilate);
+                ops.push_back(rsgis_morph_erode);
+                RSGISMorphologyRectOps rectOps(matrixOperator);
+                try
+                {
+                    rectOps.applyOpsDiff(dataset, outDataset, ops, std::vector<RSGISMorphologyOp>());
+                }
+                catch(RSGISImageException &e)
+                {
+                    GDALClose(outDataset);
+                    throw e;
+                }
+                GDALClose(outDataset);
+                return;
+            }
             
             rsgis::img::RSGISImageUtils imgUtils;
             GDALDataset *outDataset = NULL;
@@ -106,6 +128,28 @@ namespace rsgis{namespace filter{
             {
                 throw rsgis::img::RSGISImageCalcException("Morphological operator must be a square matrix.");
             }
+
+            if(RSGISMorphologyRectOps::isRectOperator(matrixOperator))
+            {
+                // Rectangular operators are applied to each block of rows in memory, so no temporary image is needed.
+                rsgis::img::RSGISImageUtils imgUtils;
+                GDALDataset *outDataset = imgUtils.createCopy(dataset, outputImage, format, outDataType);
+                std::vector<RSGISMorphologyOp> ops;
+                ops.push_back(rsgis_morph_erode);
+                ops.push_back(rsgis_morph_dilate);
+                RSGISMorphologyRectOps rectOps(matrixOperator);
+                try
+                {
+                    rectOps.applyOpsDiff(dataset, outDataset, std::vector<RSGISMorphologyOp>(), ops);
+                }
+                catch(RSGISImageException &e)
+                {
+                    GDALClose(outDataset);
+                    throw e;
+                }
+                GDALClose(outDataset);
+                return;
+            }
             
             rsgis::img::RSGISImageUtils imgUtils;
             GDALDataset *outDataset = NULL;
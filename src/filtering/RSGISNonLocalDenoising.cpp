@@ -26,13 +26,19 @@ namespace rsgis{namespace filter{
     
     RSGISApplyNonLocalDenoising::RSGISApplyNonLocalDenoising()
     {
+        this->searchWindowSize = 0;
+        this->inputImageDS = NULL;
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+    
+    void RSGISApplyNonLocalDenoising::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
     }
     
     void RSGISApplyNonLocalDenoising::ApplyFilter(GDALDataset **inputImageDS, int numDS, std::string outputImage, unsigned int filterWindowSize, unsigned int searchWindowSize, double aPar, double hPar, std::string gdalFormat, GDALDataType gdalDataType)
 	{
-        
         rsgis::img::RSGISImageUtils imgUtils;
-        rsgis::math::RSGISVectors vectorUtils;
         
 		double *gdalTranslation = new double[6];
 		int **dsOffsets = new int*[numDS];
@@ -40,36 +46,18 @@ namespace rsgis{namespace filter{
 		{
 			dsOffsets[i] = new int[2];
 		}
-		int **bandOffsets = NULL;
 		int height = 0;
 		int width = 0;
-		unsigned int numInBands = 0;
-        unsigned int numOutBands;
+		unsigned int numBands = 0;
         int xBlockSize = 0;
         int yBlockSize = 0;
-        size_t numPxlsInSearchWindow = 0;
-		
-		float **inputDataSearchWindow = NULL;
-		float **outputData = NULL;
-
-        unsigned int searchWindowWidth = searchWindowSize;
-        unsigned int searchWindowHeight = searchWindowSize;
-        unsigned int searchWindowOverlap = 0;
-        
-        double invHParSq = -1.0/hPar*hPar;
-        
-        double *swPixelValues = NULL; // Pixel values for search window.
-        double *swPixelWeights = NULL; // Pixel weights for search window.
-		
-		GDALRasterBand **inputRasterBands = NULL;
-		GDALRasterBand **outputRasterBands = NULL;
         
         GDALDriver *gdalDriver = NULL;
         GDALDataset *outputImageDS = NULL;
 		
 		try
 		{
-			if(filterWindowSize % 2 == 0)
+			if((filterWindowSize % 2 == 0) || (filterWindowSize < 3))
 			{
 				throw rsgis::img::RSGISImageCalcException("Window size needs to be an odd number (min = 3).");
 			}
@@ -77,22 +65,51 @@ namespace rsgis{namespace filter{
 			{
 				throw rsgis::img::RSGISImageCalcException("Search window size needs to at least twice the filter window size");
 			}
-			unsigned int filterWinPix = floor((float)filterWindowSize / 2); // Number of pixels each side of middle pixel
-			unsigned int windowMid = floor(((float)filterWindowSize)/2.0); // Pixel at centre of block
+            if(hPar <= 0)
+            {
+                throw rsgis::img::RSGISImageCalcException("The filtering parameter (h) needs to be greater than 0.");
+            }
+            this->searchWindowSize = searchWindowSize;
+            this->inputImageDS = inputImageDS;
+            
+			int patchRad = filterWindowSize / 2;
+            int searchRad = searchWindowSize / 2;
+            int padRad = searchRad + patchRad;
+            double invHParSq = 1.0/(hPar*hPar);
             
-            std::cout << "Search window Size: " << searchWindowSize << std::endl;
-            std::cout << "Filter window Size: " << filterWindowSize << std::endl;
+            // 1D weights across the patch, normalised so the 2D (separable) weights sum to 1.
+            std::vector<float> patchWeights(filterWindowSize, 1.0);
+            double sumPatchWeights = 0;
+            for(int k = -patchRad; k <= patchRad; ++k)
+            {
+                if(aPar > 0)
+                {
+                    patchWeights[k+patchRad] = exp(-((double)(k*k))/(2.0*aPar*aPar));
+                }
+                sumPatchWeights += patchWeights[k+patchRad];
+            }
+            for(unsigned int k = 0; k < filterWindowSize; ++k)
+            {
+                patchWeights[k] /= sumPatchWeights;
+            }
             
 			// Find image overlap
             imgUtils.getImageOverlap(inputImageDS, numDS, dsOffsets, &width, &height, gdalTranslation, &xBlockSize, &yBlockSize);
 			
-			// Count number of image bands
+			// Get Image Input Bands
+            std::vector<GDALRasterBand*> inputRasterBands;
+            std::vector<int> bandXOffs;
+            std::vector<int> bandYOffs;
 			for(int i = 0; i < numDS; i++)
 			{
-				numInBands += inputImageDS[i]->GetRasterCount();
+				for(int j = 0; j < inputImageDS[i]->GetRasterCount(); j++)
+				{
+					inputRasterBands.push_back(inputImageDS[i]->GetRasterBand(j+1));
+                    bandXOffs.push_back(dsOffsets[i][0]);
+                    bandYOffs.push_back(dsOffsets[i][1]);
+				}
 			}
-            
-            numOutBands = numInBands;
+            numBands = inputRasterBands.size();
             
 			// Create new Image
 			gdalDriver = GetGDALDriverManager()->GetDriverByName(gdalFormat.c_str());
@@ -101,9 +118,9 @@ namespace rsgis{namespace filter{
 				throw rsgis::img::RSGISImageBandException("Driver does not exists..");
 			}
             char **papszOptions = imgUtils.getGDALCreationOptionsForFormat(gdalFormat);
-			std::cout << "New image width = " << width << " height = " << height << " bands = " << numOutBands << std::endl;
+			std::cout << "New image width = " << width << " height = " << height << " bands = " << numBands << std::endl;
             
-			outputImageDS = gdalDriver->Create(outputImage.c_str(), width, height, numOutBands, gdalDataType, papszOptions);
+			outputImageDS = gdalDriver->Create(outputImage.c_str(), width, height, numBands, gdalDataType, papszOptions);
 			
 			if(outputImageDS == NULL)
 			{
@@ -113,395 +130,225 @@ namespace rsgis{namespace filter{
             outputImageDS->SetGeoTransform(gdalTranslation);
             outputImageDS->SetProjection(inputImageDS[0]->GetProjectionRef());
             
-			// Get Image Input Bands
-			bandOffsets = new int*[numInBands];
-			inputRasterBands = new GDALRasterBand*[numInBands];
-			int counter = 0;
-			for(int i = 0; i < numDS; i++)
-			{
-				for(int j = 0; j < inputImageDS[i]->GetRasterCount(); j++)
-				{
-					inputRasterBands[counter] = inputImageDS[i]->GetRasterBand(j+1);
-					bandOffsets[counter] = new int[2];
-					bandOffsets[counter][0] = dsOffsets[i][0];
-					bandOffsets[counter][1] = dsOffsets[i][1];
-					counter++;
-				}
-			}
-			
-			//Get Image Output Bands
-			outputRasterBands = new GDALRasterBand*[numOutBands];
-			for(int i = 0; i < numOutBands; i++)
+            std::vector<GDALRasterBand*> outputRasterBands;
+			for(unsigned int i = 0; i < numBands; i++)
 			{
-				outputRasterBands[i] = outputImageDS->GetRasterBand(i+1);
+				outputRasterBands.push_back(outputImageDS->GetRasterBand(i+1));
 			}
             
-            // Subset window as multiple of block size.
-            int outXBlockSize = 0;
-            int outYBlockSize = 0;
-            inputRasterBands[0]->GetBlockSize (&outXBlockSize, &outYBlockSize);
+            yBlockSize = std::max(yBlockSize, 1);
+            unsigned int nBlocks = (height + yBlockSize - 1) / yBlockSize;
             
-            std::cout << "outXBlockSize = " << outXBlockSize << ", outYBlockSize = " << outYBlockSize << std::endl;
+            std::mutex ioMutex;
+            unsigned int nBlocksDone = 0;
+            rsgis_tqdm pbar;
+            try
+            {
+                rsgis::utils::parallelFor(nBlocks, this->numThreads, [&](size_t blk, unsigned int)
+                {
+                    int padWidth = width + 2*padRad;
+                    std::vector<float> padData(((size_t)padWidth) * (yBlockSize + 2*padRad));
+                    std::vector<float> outData(((size_t)width) * yBlockSize);
+                    
+                    int yOff = blk * yBlockSize;
+                    int nRows = std::min(yBlockSize, height - yOff);
+                    // Rows of the image read, including the padding.
+                    int readStart = std::max(yOff - padRad, 0);
+                    int readEnd = std::min(yOff + nRows + padRad, height);
+                    for(unsigned int n = 0; n < numBands; ++n)
+                    {
+                        {
+                            std::lock_guard<std::mutex> lock(ioMutex);
+                            float *readData = padData.data() + (((size_t)(readStart - (yOff - padRad))) * padWidth) + padRad;
+                            if(inputRasterBands[n]->RasterIO(GF_Read, bandXOffs[n], bandYOffs[n] + readStart, width, readEnd - readStart, readData, width, readEnd - readStart, GDT_Float32, sizeof(float), sizeof(float) * padWidth, NULL) != CE_None)
+                            {
+                                throw rsgis::RSGISImageException("Could not read a block of the input image.");
+                            }
+                        }
+                        
+                        // Pad with the nearest pixel of the image.
+                        int nPadRows = nRows + 2*padRad;
+                        for(int r = 0; r < nPadRows; ++r)
+                        {
+                            int imgRow = std::min(std::max(yOff - padRad + r, readStart), readEnd - 1);
+                            float *rowData = padData.data() + (((size_t)r) * padWidth);
+                            if(imgRow != (yOff - padRad + r))
+                            {
+                                const float *srcRow = padData.data() + (((size_t)(imgRow - (yOff - padRad))) * padWidth);
+                                std::copy(srcRow + padRad, srcRow + padRad + width, rowData + padRad);
+                            }
+                            std::fill(rowData, rowData + padRad, rowData[padRad]);
+                            std::fill(rowData + padRad + width, rowData + padWidth, rowData[padRad + width - 1]);
+                        }
+                        
+                        this->denoiseBlock(padData.data(), width, nRows, yOff, height, searchRad, patchRad, patchWeights, invHParSq, outData.data());
+                        
+                        {
+                            std::lock_guard<std::mutex> lock(ioMutex);
+                            if(outputRasterBands[n]->RasterIO(GF_Write, 0, yOff, width, nRows, outData.data(), width, nRows, GDT_Float32, 0, 0, NULL) != CE_None)
+                            {
+                                throw rsgis::RSGISImageException("Could not write a block of the output image.");
+                            }
+                        }
+                    }
+                    std::lock_guard<std::mutex> lock(ioMutex);
+                    pbar.progress(++nBlocksDone, nBlocks);
+                });
+            }
+            catch(...)
+            {
+                pbar.finish();
+                throw;
+            }
+            pbar.finish();
             
-            // Set search window height and width so multiples of block size
-            if(searchWindowWidth > outXBlockSize)
+            GDALClose(outputImageDS);
+            outputImageDS = NULL;
+		}
+		catch(rsgis::RSGISException& e)
+		{
+            if(outputImageDS != NULL)
+            {
+                GDALClose(outputImageDS);
+            }
+            delete[] gdalTranslation;
+            for(int i = 0; i < numDS; i++)
             {
-                searchWindowWidth =  floor((float)searchWindowWidth / outXBlockSize) + outXBlockSize;
+                delete[] dsOffsets[i];
             }
-            if(searchWindowHeight > outYBlockSize)
+            delete[] dsOffsets;
+			throw;
+		}
+		
+        delete[] gdalTranslation;
+        for(int i = 0; i < numDS; i++)
+        {
+            delete[] dsOffsets[i];
+        }
+        delete[] dsOffsets;
+	}
+    
+    void RSGISApplyNonLocalDenoising::denoiseBlock(const float *padData, int width, int nRows, int imgYOff, int imgHeight, int searchRad, int patchRad, const std::vector<float> &patchWeights, double invHParSq, float *outData)
+    {
+        int padRad = searchRad + patchRad;
+        size_t padWidth = width + 2*padRad;
+        int patchSize = 2*patchRad + 1;
+        bool uniformPatch = true;
+        for(int k = 1; k < patchSize; ++k)
+        {
+            if(patchWeights[k] != patchWeights[0])
             {
-                searchWindowHeight = floor((float)searchWindowHeight / outYBlockSize) + outYBlockSize;
+                uniformPatch = false;
             }
-            searchWindowOverlap = filterWindowSize*2;
-            if(searchWindowOverlap < outYBlockSize)
+        }
+        
+        // Squared differences for the rows and columns covered by the patches of the block.
+        int diffWidth = width + 2*patchRad;
+        int diffRows = nRows + 2*patchRad;
+        std::vector<float> diffData(((size_t)diffWidth) * diffRows);
+        std::vector<float> rowSumData(((size_t)width) * diffRows);
+        std::vector<float> distData(width);
+        std::vector<double> sumWeights(((size_t)width) * nRows, 0.0);
+        std::vector<double> sumWeightedVals(((size_t)width) * nRows, 0.0);
+        
+        for(int dy = -searchRad; dy <= searchRad; ++dy)
+        {
+            // Only rows where the candidate pixel is within the image.
+            int yStart = std::max(0, -(imgYOff + dy));
+            int yEnd = std::min(nRows, imgHeight - (imgYOff + dy));
+            if(yStart >= yEnd)
             {
-                searchWindowOverlap = outYBlockSize;
+                continue;
             }
-            
-			// Allocate memory
-            numPxlsInSearchWindow = searchWindowWidth*searchWindowHeight;
-            inputDataSearchWindow = new float*[numInBands];
-			for(int i = 0; i < numInBands; i++)
-			{
-                inputDataSearchWindow[i] = (float *) CPLMalloc(sizeof(float)*numPxlsInSearchWindow);
-                for(int k = 0; k < numPxlsInSearchWindow; k++)
+            for(int dx = -searchRad; dx <= searchRad; ++dx)
+            {
+                int xStart = std::max(0, -dx);
+                int xEnd = std::min(width, width - dx);
+                if(xStart >= xEnd)
                 {
-                    inputDataSearchWindow[i][k] = 0;
+                    continue;
                 }
-			}
-			
-			outputData = new float*[numOutBands];
-			for(int i = 0; i < numOutBands; i++)
-			{
-				outputData[i] = (float *) CPLMalloc(sizeof(float)*numPxlsInSearchWindow);
-			}
-			
-            // Set up GSL vector for data to be filtered.
-            gsl_vector *inDataVector =  gsl_vector_alloc(filterWindowSize*filterWindowSize);
-            gsl_vector *inSearchBlockVector =  gsl_vector_alloc(filterWindowSize*filterWindowSize);
-            
-            //gsl_matrix *gaussKernel = gsl_matrix_alloc(filterWindowSize*filterWindowSize,filterWindowSize*filterWindowSize);
-            
-            swPixelValues = new double[numPxlsInSearchWindow];
-            swPixelWeights = new double[numPxlsInSearchWindow];
-            
-            // Initialise top corner at common overlap.
-            unsigned int startSearchX = bandOffsets[0][0];
-            unsigned int startSearchY = bandOffsets[0][1];
-            
-            unsigned int maxSearchX = width - searchWindowWidth;
-            unsigned int maxSearchY = height - searchWindowHeight;
-            unsigned int searchWinOffsetX = 0; // Offset for start pixel in search window
-            //unsigned int searchWinOffsetY = 0; // Offset for end pixel in search window
-            
-            std::cout << "height = " << height << ", searchWindowHeight = " << searchWindowHeight << std::endl;
-            std::cout << "width = " << width << ", searchWindowWidth = " << searchWindowWidth << std::endl;
-            
-            //unsigned int feedback = height*width / 10.0;
-			//int feedbackCounter = 0;
-			std::cout << "Started" << std::flush;
-			
-            while (startSearchY < maxSearchY)
-            {
-                std::cout << "startSearchY = " << startSearchY << ", maxSearchY = " << maxSearchY << std::endl;
                 
-                startSearchX = 0; // Reset X
-                std::cout << "startSearchX = " << startSearchX << ", maxSearchX = " << maxSearchX << std::endl;
-                while (startSearchX < maxSearchX)
+                for(int r = yStart; r < (yEnd + 2*patchRad); ++r)
                 {
-                    
-                    // Read search window into memory
-                    for(int n = 0; n < numOutBands; n++)
+                    const float *pRow = padData + ((r + searchRad) * padWidth) + searchRad;
+                    const float *qRow = pRow + (dy * ((long)padWidth)) + dx;
+                    float *dRow = diffData.data() + (((size_t)r) * diffWidth);
+                    for(int c = 0; c < diffWidth; ++c)
                     {
-                        inputRasterBands[n]->RasterIO(GF_Read, startSearchX, startSearchY, searchWindowWidth, searchWindowHeight, inputDataSearchWindow[n], searchWindowWidth, searchWindowHeight, GDT_Float32, 0, 0);
+                        float diff = pRow[c] - qRow[c];
+                        dRow[c] = diff * diff;
                     }
-                    
-                    // Loop through pixels in search window
-                    unsigned int cPxl = 0;
-                    for(unsigned int i = 0; i < searchWindowHeight; ++i)
+                }
+                
+                // Sum across the patch along the rows.
+                for(int r = yStart; r < (yEnd + 2*patchRad); ++r)
+                {
+                    const float *dRow = diffData.data() + (((size_t)r) * diffWidth);
+                    float *sRow = rowSumData.data() + (((size_t)r) * width);
+                    if(uniformPatch)
                     {
-                        searchWinOffsetX = 0; // Reset x offset
-                        for(unsigned int j = 0; j < searchWindowWidth; ++j)
+                        double runSum = 0;
+                        for(int k = 0; k < patchSize; ++k)
                         {
-                            // Get data block
-                            int startDataBlockX = j - filterWinPix;
-                            int startDataBlockY = i - filterWinPix;
-                            int endDataBlockX = j + filterWinPix;
-                            int endDataBlockY = i + filterWinPix;
-                            
-                            if (startDataBlockX < 0)
-                            {
-                                startDataBlockX = 0;
-                                endDataBlockX = filterWindowSize;
-                            }
-                            if (startDataBlockY < 0)
-                            {
-                                startDataBlockY = 0;
-                                endDataBlockY = filterWindowSize;
-                            }
-                            if (endDataBlockX >= searchWindowWidth)
-                            {
-                                startDataBlockX = searchWindowWidth-filterWinPix;
-                                endDataBlockX = searchWindowWidth;
-                            }
-                            if (endDataBlockY >= searchWindowHeight)
-                            {
-                                startDataBlockY = searchWindowHeight-filterWinPix;
-                                endDataBlockY = searchWindowHeight;
-                            }
-                            
-                            for(int n = 0; n < numOutBands; n++)
+                            runSum += dRow[k];
+                        }
+                        sRow[0] = runSum;
+                        for(int c = 1; c < width; ++c)
+                        {
+                            runSum += dRow[c + patchSize - 1] - dRow[c - 1];
+                            sRow[c] = runSum;
+                        }
+                    }
+                    else
+                    {
+                        std::fill(sRow, sRow + width, 0.0f);
+                        for(int k = 0; k < patchSize; ++k)
+                        {
+                            float wk = patchWeights[k];
+                            const float *dk = dRow + k;
+                            for(int c = 0; c < width; ++c)
                             {
-                                
-                                // Get vector for data block
-                                unsigned int pixVecNum = 0;
-                                for(unsigned int y = startDataBlockY;y < endDataBlockY; ++y)
-                                {
-                                    for(unsigned int x = startDataBlockX; x < endDataBlockX; ++x)
-                                    {
-                                        double pixVal = inputDataSearchWindow[n][(y*searchWindowWidth)+x];
-                                        gsl_vector_set(inDataVector, pixVecNum, pixVal);
-                                        ++pixVecNum;
-                                    }
-                                }
-                                
-                                // Calculate pixel values and weights for all blocks in search window
-                                unsigned int swValNum = 0;
-                                for(unsigned int searchWinY = 0; searchWinY < searchWindowHeight; ++searchWinY)
-                                {
-                                    for(unsigned int searchWinX = 0; searchWinX < searchWindowWidth; ++searchWinX)
-                                    {
-                                        // Get data block
-                                        int startSearchBlockX = j - filterWinPix;
-                                        int startSearchBlockY = i - filterWinPix;
-                                        int endSearchBlockX = j + filterWinPix;
-                                        int endSearchBlockY = i + filterWinPix;
-                                        
-                                        if (startSearchBlockX < 0)
-                                        {
-                                            startSearchBlockX = 0;
-                                            endSearchBlockX = filterWindowSize;
-                                        }
-                                        if (startSearchBlockY < 0)
-                                        {
-                                            startSearchBlockY = 0;
-                                            endSearchBlockY = filterWindowSize;
-                                        }
-                                        if (endSearchBlockX >= searchWindowWidth)
-                                        {
-                                            startSearchBlockX = searchWindowWidth-filterWinPix;
-                                            endSearchBlockX = searchWindowWidth;
-                                        }
-                                        if (endSearchBlockY >= searchWindowHeight)
-                                        {
-                                            startSearchBlockY = searchWindowHeight-filterWinPix;
-                                            endSearchBlockY = searchWindowHeight;
-                                        }
-                                                                                    
-                                        // Add to GSL vector
-                                        unsigned int pixVecNum = 0;
-                                        for(unsigned int y = startSearchBlockY;y < endSearchBlockY; ++y)
-                                        {
-                                            for(unsigned int x = startSearchBlockX; x < endSearchBlockX; ++x)
-                                            {
-                                                double pixVal = inputDataSearchWindow[n][(y*searchWindowWidth)+x];
-                                                double pixelDiff = pixVal - gsl_vector_get(inDataVector, pixVecNum);
-                                                gsl_vector_set(inSearchBlockVector, pixVecNum, pixelDiff);
-                                                
-                                                if((x == windowMid) && (y == windowMid))
-                                                {
-                                                    // Add centre pixel value to vector.
-                                                    swPixelValues[swValNum] = pixVal;
-                                                }
-                                                
-                                                ++pixVecNum;
-                                            }
-                                        }
-                                        
-                                        // Calculate weights
-                                        // v(Ni) . Gauss . v(Nj)
-                                        double inBlockSearchBlockGDiff = vectorUtils.dotProductVectorVectorGSL(inSearchBlockVector, inSearchBlockVector);
-                                        double swPixWeight = exp(invHParSq * inBlockSearchBlockGDiff);
-                                        
-                                        swPixelWeights[swValNum] = swPixWeight;
-                                        ++swValNum;
-
-                                    }
-                                }
-                                
-                                // Estimate denoised pixel values
-                                
-                                // Calculate sum of weights
-                                double sumWeights = 0;
-                                for(unsigned int w=0; w < numPxlsInSearchWindow; ++w)
-                                {
-                                    sumWeights+=swPixelWeights[w];
-                                }
-                                
-                                // Calculate weighted mean
-                                double denoisedPixVal = 0;
-                                double weightPixVal = 0;
-                                
-                                for(unsigned int w=0; w < numPxlsInSearchWindow; ++w)
-                                {
-                                    weightPixVal = (1. / sumWeights) * swPixelWeights[w] * swPixelValues[w];
-                                    denoisedPixVal+= weightPixVal;
-                                }
- 
-                                // Save filterd pixel value to output column
-                                outputData[n][cPxl] = denoisedPixVal;
-                                
+                                sRow[c] += wk * dk[c];
                             }
-                            if(cPxl % 100 == 0){std::cout << cPxl << std::endl;}
-                            ++cPxl;
                         }
                     }
-                    
-                    for(int n = 0; n < numOutBands; n++)
+                }
+                
+                // Then down the columns, giving the distance and weight for each pixel.
+                for(int y = yStart; y < yEnd; ++y)
+                {
+                    std::fill(distData.begin(), distData.end(), 0.0f);
+                    for(int k = 0; k < patchSize; ++k)
                     {
-                        outputRasterBands[n]->RasterIO(GF_Write, startSearchX, startSearchY, searchWindowWidth, searchWindowHeight, outputData[n], searchWindowWidth, searchWindowHeight, GDT_Float32, 0, 0);
+                        float wk = uniformPatch?1.0f:patchWeights[k];
+                        const float *sRow = rowSumData.data() + (((size_t)(y + k)) * width);
+                        for(int c = xStart; c < xEnd; ++c)
+                        {
+                            distData[c] += wk * sRow[c];
+                        }
+                    }
+                    double distScale = uniformPatch?(patchWeights[0] * patchWeights[0]):1.0;
+                    const float *qRow = padData + ((y + padRad + dy) * padWidth) + padRad + dx;
+                    double *sumWRow = sumWeights.data() + (((size_t)y) * width);
+                    double *sumWVRow = sumWeightedVals.data() + (((size_t)y) * width);
+                    for(int c = xStart; c < xEnd; ++c)
+                    {
+                        double dist = std::max(distData[c] * distScale, 0.0);
+                        double weight = exp(-dist * invHParSq);
+                        sumWRow[c] += weight;
+                        sumWVRow[c] += weight * qRow[c];
                     }
-                    startSearchX+=searchWindowWidth;
                 }
-                startSearchY+=searchWindowWidth;
             }
-
-            std::cout << " Complete.\n";
-		}
-		catch(rsgis::img::RSGISImageCalcException& e)
-		{
-			if(gdalTranslation != NULL)
-			{
-				delete[] gdalTranslation;
-			}
-			
-			if(dsOffsets != NULL)
-			{
-				for(int i = 0; i < numDS; i++)
-				{
-					delete dsOffsets[i];
-				}
-				delete[] dsOffsets;
-			}
-			
-			if(bandOffsets != NULL)
-			{
-				for(int i = 0; i < numInBands; i++)
-				{
-					delete bandOffsets[i];
-				}
-				delete[] bandOffsets;
-			}
-            
-            if(inputDataSearchWindow != NULL)
-			{
-				for(int i = 0; i < numInBands; i++)
-				{
-					delete[] inputDataSearchWindow[i];
-				}
-				delete[] inputDataSearchWindow;
-			}
-			
-			if(outputData != NULL)
-			{
-				for(int i = 0; i < numOutBands; i++)
-				{
-					delete outputData[i];
-				}
-				delete outputData;
-			}
-            
-			throw e;
-		}
-		catch(rsgis::img::RSGISImageBandException& e)
-		{
-			if(gdalTranslation != NULL)
-			{
-				delete[] gdalTranslation;
-			}
-			
-			if(dsOffsets != NULL)
-			{
-				for(int i = 0; i < numDS; i++)
-				{
-					delete dsOffsets[i];
-				}
-				delete[] dsOffsets;
-			}
-			
-			if(bandOffsets != NULL)
-			{
-				for(int i = 0; i < numInBands; i++)
-				{
-					delete bandOffsets[i];
-				}
-				delete[] bandOffsets;
-			}
-            
-            if(inputDataSearchWindow != NULL)
-			{
-				for(int i = 0; i < numInBands; i++)
-				{
-					delete[] inputDataSearchWindow[i];
-				}
-				delete[] inputDataSearchWindow;
-			}
-			
-			if(outputData != NULL)
-			{
-				for(int i = 0; i < numOutBands; i++)
-				{
-					delete outputData[i];
-				}
-				delete outputData;
-			}
-			
-			throw e;
-		}
-		
-		if(gdalTranslation != NULL)
-		{
-			delete[] gdalTranslation;
-		}
-		
-		if(dsOffsets != NULL)
-		{
-			for(int i = 0; i < numDS; i++)
-			{
-				delete dsOffsets[i];
-			}
-			delete[] dsOffsets;
-		}
-		
-		if(bandOffsets != NULL)
-		{
-			for(int i = 0; i < numInBands; i++)
-			{
-				delete bandOffsets[i];
-			}
-			delete[] bandOffsets;
-		}
+        }
         
-        if(inputDataSearchWindow != NULL)
+        size_t numPxls = ((size_t)width) * nRows;
+        for(size_t i = 0; i < numPxls; ++i)
         {
-            for(int i = 0; i < numInBands; i++)
-            {
-                delete[] inputDataSearchWindow[i];
-            }
-            delete[] inputDataSearchWindow;
+            outData[i] = sumWeightedVals[i] / sumWeights[i];
         }
-        
-		if(outputData != NULL)
-		{
-			for(int i = 0; i < numOutBands; i++)
-			{
-				delete outputData[i];
-			}
-			delete outputData;
-		}
-		
-	}
-	
+    }
 	
 	RSGISApplyNonLocalDenoising::~RSGISApplyNonLocalDenoising()
 	{
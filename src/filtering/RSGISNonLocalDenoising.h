@@ -24,6 +24,12 @@
 #define RSGISNonLocalDenoising_H
 
 #include <iostream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <exception>
+#include <cmath>
 
 #include <gsl/gsl_vector.h>
 #include <gsl/gsl_matrix.h>
@@ -32,6 +38,7 @@
 
 #include "common/rsgis-tqdm.h"
 #include "common/RSGISImageException.h"
+#include "common/RSGISParallel.h"
 
 #include "math/RSGISMatrices.h"
 #include "math/RSGISVectors.h"
@@ -60,19 +67,43 @@ namespace rsgis{namespace filter{
     {
         /**
             Implemention of the Non-local image denoising algorithm described in:
-         
             Buades, A., Coll, B. & Morel, J.M., A non-local algorithm for image denoising. 2005.
             IEEE Computer Society Conference on Computer Vision and Pattern Recognition.
 
+            Each band is filtered separately. The output pixel is the mean of the
+            pixels within the search window (searchWindowSize x searchWindowSize)
+            weighted by exp(-d/hPar^2), where d is the mean squared difference
+            between the filterWindowSize x filterWindowSize patches around the two
+            pixels, weighted by a Gaussian with a standard deviation of aPar pixels
+            (or uniformly if aPar <= 0). Pixels outside of the image are the
+            nearest edge pixel within the patches, and are not used as candidates.
+
+            Rather than comparing each pair of patches, the distances for each
+            offset within the search window are found at once by summing the
+            image of the squared differences between the image and its shifted
+            copy over the patch, with separable (running sum for a uniform patch)
+            row and column passes. The image is processed in blocks of rows
+            shared among threads (setNumThreads or the RSGISLIB_NUM_THREADS
+            environment variable).
          */
-        
     public: 
         RSGISApplyNonLocalDenoising();
+        /**
+         * The number of threads (0 uses the number of cores).
+         */
+        void setNumThreads(unsigned int numThreads);
         void ApplyFilter(GDALDataset **inputImageDS, int numDS, std::string outputImage, unsigned int filterWindowSize, unsigned int searchWindowSize, double aPar=2.0, double hPar=2.0, std::string gdalFormat="ENVI", GDALDataType gdalDataType=GDT_Float32);
         ~RSGISApplyNonLocalDenoising();
     protected:
+        /**
+         * Denoise nRows rows of width pixels from padData, which has searchRad+patchRad
+         * pixels of padding on each side. imgYOff and imgHeight are used to limit the
+         * candidate pixels to those within the image.
+         */
+        void denoiseBlock(const float *padData, int width, int nRows, int imgYOff, int imgHeight, int searchRad, int patchRad, const std::vector<float> &patchWeights, double invHParSq, float *outData);
         unsigned int searchWindowSize; // Window size of search space
         GDALDataset **inputImageDS; // GDAL dataset for input image
+        unsigned int numThreads;
     };
 }}
 
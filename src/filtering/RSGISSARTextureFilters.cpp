@@ -24,294 +24,129 @@
 
 namespace rsgis{namespace filter{
 
-    RSGISNormVarPowerFilter::RSGISNormVarPowerFilter(int numberOutBands, int size, std::string filenameEnding) : RSGISImageFilter(numberOutBands, size, filenameEnding){}
-
-    void RSGISNormVarPowerFilter::calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) 
-	{
-        unsigned int middleVal = floor(((float)winSize) / 2);
-        unsigned int numVal = 0; // Number of values counted
-        double outI = 0;
-        double iMean = 0;
-        double iMeanSq = 0;
-        double iSqMean = 0;
-
-        for(int i = 0; i < numBands; i++)
+    RSGISSARTextureFilter::RSGISSARTextureFilter(int numberOutBands, int size, std::string filenameEnding, std::vector<RSGISSARTexture> textures) : RSGISImageFilter(numberOutBands * textures.size(), size, filenameEnding)
+    {
+        if(textures.empty())
         {
-            iMean = 0;
-            iMeanSq = 0;
-            iSqMean = 0;
-            numVal = 0;
-
-            // Check for data at the centre of the block (skip if no data to preserve scene edges)
-            if((dataBlock[i][middleVal][middleVal] == 0) | ((boost::math::isnan)(dataBlock[i][middleVal][middleVal])))
-            {
-                outI = 0;
-            }
-            else
-            {
-                for(int j = 0; j < size; j++)
-                {
-                    for(int k = 0; k < size; k++)
-                    {
-                         if((dataBlock[i][j][k] != 0) && ((boost::math::isnan)(dataBlock[i][j][k]) == false))
-                         {
-                             iMean = iMean + dataBlock[i][j][k];
-                             iSqMean = iSqMean + (dataBlock[i][j][k]*dataBlock[i][j][k]);
-
-                             ++numVal;
-                         }
-                    }
-                }
-
-                // Check there were at least three data values
-                if(numVal > 3)
-                {
-                    iMean = iMean / numVal;
-                    iMeanSq = iMean*iMean;
-                    iSqMean = iSqMean / numVal;
-                    outI = (iSqMean / iMeanSq) - 1;
-                }
-                else
-                {
-                    outI = 0;
-                }
-            }
-            output[i] = outI;
+            throw RSGISImageFilterException("At least one SAR texture must be specified.");
         }
-	}
-
-
-    RSGISNormVarAmplitudeFilter::RSGISNormVarAmplitudeFilter(int numberOutBands, int size, std::string filenameEnding) : RSGISImageFilter(numberOutBands, size, filenameEnding){}
-
-    void RSGISNormVarAmplitudeFilter::calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) 
-	{
-        unsigned int middleVal = floor(((float)winSize) / 2);
-        unsigned int numVal = 0; // Number of values counted
-        double outI = 0;
-        double iMean = 0;
-        double iMeanSq = 0;
-        double iSqMean = 0;
-
-        for(int i = 0; i < numBands; i++)
+        this->textures = textures;
+        this->calcTransformed = false;
+        for(std::vector<RSGISSARTexture>::iterator iterTex = this->textures.begin(); iterTex != this->textures.end(); ++iterTex)
         {
-            iMean = 0;
-            iMeanSq = 0;
-            iSqMean = 0;
-            numVal = 0;
-
-            // Check for data at the centre of the block (skip if no data to preserve scene edges)
-            if((dataBlock[i][middleVal][middleVal] == 0) | ((boost::math::isnan)(dataBlock[i][middleVal][middleVal])))
+            if((*iterTex) != sartex_normvarpower && (*iterTex) != sartex_texturevar)
             {
-                outI = 0;
+                this->calcTransformed = true;
             }
-            else
-            {
-                for(int j = 0; j < size; j++)
-                {
-                    for(int k = 0; k < size; k++)
-                    {
-                        if((dataBlock[i][j][k] != 0) && ((boost::math::isnan)(dataBlock[i][j][k]) == false))
-                        {
-                            iMean = iMean + sqrt(dataBlock[i][j][k]);
-                            iSqMean = iSqMean + dataBlock[i][j][k];
-
-                            ++numVal;
-                        }
-                    }
-                }
-
-                // Check there were at least three data values
-                if(numVal > 3)
-                {
-
-                    iMean = iMean / numVal;
-                    iMeanSq = iMean*iMean;
-                    iSqMean = iSqMean / numVal;
-
-                    outI = (iSqMean / iMeanSq) - 1;
-                }
-                else{outI = 0;}
-            }
-            output[i] = outI;
         }
-	}
-
-
-    RSGISNormVarLnPowerFilter::RSGISNormVarLnPowerFilter(int numberOutBands, int size, std::string filenameEnding) : RSGISImageFilter(numberOutBands, size, filenameEnding){}
+        this->windowMoments = new rsgis::img::RSGISWindowBandMoments(this->calcTransformed);
+    }
+
+    void RSGISSARTextureFilter::setNumOutBands(int bands)
+    {
+        RSGISImageFilter::setNumOutBands(bands * this->textures.size());
+    }
+
+    double RSGISSARTextureFilter::calcTexture(RSGISSARTexture texture, const rsgis::img::RSGISWindowBandMoments::BandSums &sums)
+    {
+        double numVal = floor(sums.n + 0.5);
+        // Check there were at least three data values
+        if(numVal <= 3)
+        {
+            return 0;
+        }
 
-    void RSGISNormVarLnPowerFilter::calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) 
-	{
-        unsigned int middleVal = floor(((float)winSize) / 2);
-        unsigned int numVal = 0; // Number of values counted
         double outI = 0;
-        double iMean = 0;
-        double iMeanSq = 0;
-        double iSqMean = 0;
-
+        if(texture == sartex_normvarpower)
+        {
+            double iMean = sums.sum / numVal;
+            outI = ((sums.sumSq / numVal) / (iMean*iMean)) - 1;
+        }
+        else if(texture == sartex_normvaramplitude)
+        {
+            double iMean = sums.sumSqrt / numVal;
+            outI = ((sums.sum / numVal) / (iMean*iMean)) - 1;
+        }
+        else if(texture == sartex_normvarlnpower)
+        {
+            double iMean = sums.sumLn / numVal;
+            outI = ((sums.sumLnSq / numVal) / (iMean*iMean)) - 1;
+        }
+        else if(texture == sartex_normln)
+        {
+            outI = (sums.sumLn / numVal) - log(sums.sum / numVal);
+        }
+        else if(texture == sartex_texturevar)
+        {
+            double iMean = sums.sum / numVal;
+            double variance = std::max((sums.sumSq / numVal) - (iMean*iMean), 0.0);
+            outI = ((variance / (iMean*iMean)) - (1/numVal)) / (1 + (1/numVal));
+        }
+        else
+        {
+            throw RSGISImageFilterException("SAR texture not recognised.");
+        }
+        return outI;
+    }
+
+    void RSGISSARTextureFilter::calcImageWindowRow(const rsgis::img::RSGISImageWindowView &rowWindow, int width, double **outRows)
+    {
+        int numBands = rowWindow.getNumBands();
+        int middleVal = rowWindow.getWinSize() / 2;
+        this->windowMoments->update(rowWindow, width);
         for(int i = 0; i < numBands; i++)
         {
-            iMean = 0;
-            iMeanSq = 0;
-            iSqMean = 0;
-            numVal = 0;
-
-            // Check for data at the centre of the block (skip if no data to preserve scene edges)
-            if((dataBlock[i][middleVal][middleVal] == 0) | ((boost::math::isnan)(dataBlock[i][middleVal][middleVal])))
+            const float *centreRow = rowWindow.getRow(i, middleVal) + middleVal;
+            for(int x = 0; x < width; ++x)
             {
-                outI = 0;
-            }
-            else
-            {
-                for(int j = 0; j < size; j++)
+                // Check for data at the centre of the window (skip if no data to preserve scene edges)
+                bool noData = (centreRow[x] == 0) || (boost::math::isnan)(centreRow[x]);
+                rsgis::img::RSGISWindowBandMoments::BandSums sums;
+                if(!noData)
                 {
-                    for(int k = 0; k < size; k++)
-                    {
-                        if((dataBlock[i][j][k] != 0) && ((boost::math::isnan)(dataBlock[i][j][k]) == false))
-                        {
-                            iMean = iMean + log(dataBlock[i][j][k]);
-                            iSqMean = iSqMean + log(dataBlock[i][j][k])*log(dataBlock[i][j][k]);
-
-                            ++numVal;
-                        }
-                    }
+                    sums = this->windowMoments->getSums(i, x);
                 }
-
-                // Check there were at least three data values
-                if(numVal > 3)
+                for(size_t t = 0; t < this->textures.size(); ++t)
                 {
-
-                    iMean = iMean / numVal;
-                    iMeanSq = iMean*iMean;
-                    iSqMean = iSqMean / numVal;
-
-                    outI = (iSqMean / iMeanSq) - 1;
+                    outRows[(t*numBands)+i][x] = noData?0:calcTexture(this->textures[t], sums);
                 }
-                else{outI = 0;}
             }
-            output[i] = outI;
         }
-	}
+    }
 
-    RSGISNormLnFilter::RSGISNormLnFilter(int numberOutBands, int size, std::string filenameEnding) : RSGISImageFilter(numberOutBands, size, filenameEnding){}
-
-    void RSGISNormLnFilter::calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) 
+    void RSGISSARTextureFilter::calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) 
 	{
         unsigned int middleVal = floor(((float)winSize) / 2);
-        unsigned int numVal = 0; // Number of values counted
-        double outI = 0;
-        double iMean = 0;
-        double iMeanLn = 0;
-        double iLnMean = 0;
-
         for(int i = 0; i < numBands; i++)
         {
-            iMean = 0;
-            iMeanLn = 0;
-            iLnMean = 0;
-            numVal = 0;
-
             // Check for data at the centre of the block (skip if no data to preserve scene edges)
-            if((dataBlock[i][middleVal][middleVal] == 0) | ((boost::math::isnan)(dataBlock[i][middleVal][middleVal])))
+            bool noData = (dataBlock[i][middleVal][middleVal] == 0) | ((boost::math::isnan)(dataBlock[i][middleVal][middleVal]));
+            rsgis::img::RSGISWindowBandMoments::BandSums sums;
+            if(!noData)
             {
-                outI = 0;
+                sums = rsgis::img::RSGISWindowBandMoments::sumWindow(dataBlock, i, winSize, this->calcTransformed);
             }
-            else
+            for(size_t t = 0; t < this->textures.size(); ++t)
             {
-                for(int j = 0; j < size; j++)
-                {
-                    for(int k = 0; k < size; k++)
-                    {
-                        if((dataBlock[i][j][k] != 0) && ((boost::math::isnan)(dataBlock[i][j][k]) == false))
-                        {
-                            iMean = iMean + dataBlock[i][j][k];
-                            iLnMean = iLnMean + log(dataBlock[i][j][k]);
-
-                            ++numVal;
-                        }
-                    }
-                }
-
-                // Check there were at least three data values
-                if(numVal > 3)
-                {
-
-                    iMean = iMean / numVal;
-                    iMeanLn = log(iMean);
-                    iLnMean = iLnMean / numVal;
-
-                    outI = iLnMean - iMeanLn;
-                }
-                else{outI = 0;}
+                output[(t*numBands)+i] = noData?0:calcTexture(this->textures[t], sums);
             }
-            output[i] = outI;
         }
 	}
 
-    RSGISTextureVar::RSGISTextureVar(int numberOutBands, int size, std::string filenameEnding) : RSGISImageFilter(numberOutBands, size, filenameEnding){}
+    RSGISSARTextureFilter::~RSGISSARTextureFilter()
+    {
+        delete this->windowMoments;
+    }
 
-    void RSGISTextureVar::calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) 
-	{
-        unsigned int middleVal = floor(((float)winSize) / 2);
-        unsigned int numVal = 0; // Number of values counted
-        double outI = 0;
-        double stDev = 0;
-        double iMean = 0;
-        double iSum = 0;
-        double iMinusMeanSqSum = 0;
 
-        for(int i = 0; i < numBands; i++)
-        {
-            iMean = 0;
-            iSum = 0;
-            iMinusMeanSqSum = 0;
-            numVal = 0;
+    RSGISNormVarPowerFilter::RSGISNormVarPowerFilter(int numberOutBands, int size, std::string filenameEnding) : RSGISSARTextureFilter(numberOutBands, size, filenameEnding, std::vector<RSGISSARTexture>(1, sartex_normvarpower)){}
 
-            // Check for data at the centre of the block (skip if no data to preserve scene edges)
-            if((dataBlock[i][middleVal][middleVal] == 0) | ((boost::math::isnan)(dataBlock[i][middleVal][middleVal])))
-            {
-                outI = 0;
-            }
-            else
-            {
-                for(int j = 0; j < size; j++)
-                {
-                    for(int k = 0; k < size; k++)
-                    {
-                         if((dataBlock[i][j][k] != 0) && ((boost::math::isnan)(dataBlock[i][j][k]) == false))
-                         {
-                             iSum = iSum + dataBlock[i][j][k];
-                             ++numVal;
-                         }
-                    }
-                }
-
-                // Check there were at least three data values
-                if(numVal > 3)
-                {
-                    iMean = iSum / numVal;
+    RSGISNormVarAmplitudeFilter::RSGISNormVarAmplitudeFilter(int numberOutBands, int size, std::string filenameEnding) : RSGISSARTextureFilter(numberOutBands, size, filenameEnding, std::vector<RSGISSARTexture>(1, sartex_normvaramplitude)){}
 
-                    for(int j = 0; j < size; j++)
-                    {
-                        for(int k = 0; k < size; k++)
-                        {
-                             if((dataBlock[i][j][k] != 0) && ((boost::math::isnan)(dataBlock[i][j][k]) == false))
-                             {
-                                 iMinusMeanSqSum = iMinusMeanSqSum + pow((dataBlock[i][j][k] - iMean),2);
-                             }
-                        }
-                    }
+    RSGISNormVarLnPowerFilter::RSGISNormVarLnPowerFilter(int numberOutBands, int size, std::string filenameEnding) : RSGISSARTextureFilter(numberOutBands, size, filenameEnding, std::vector<RSGISSARTexture>(1, sartex_normvarlnpower)){}
 
+    RSGISNormLnFilter::RSGISNormLnFilter(int numberOutBands, int size, std::string filenameEnding) : RSGISSARTextureFilter(numberOutBands, size, filenameEnding, std::vector<RSGISSARTexture>(1, sartex_normln)){}
 
-                    stDev = iMinusMeanSqSum / numVal; // Variance
-                    stDev = sqrt(stDev); // Standard deviation
-
-                    outI = (pow((stDev / iMean),2)-(1/numVal))/(1+(1/numVal));
-
-                }
-                else{outI = 0;}
-            }
-            output[i] = outI;
-        }
-	}
+    RSGISTextureVar::RSGISTextureVar(int numberOutBands, int size, std::string filenameEnding) : RSGISSARTextureFilter(numberOutBands, size, filenameEnding, std::vector<RSGISSARTexture>(1, sartex_texturevar)){}
 
 }}
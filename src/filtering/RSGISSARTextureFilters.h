@@ -24,12 +24,16 @@
 #define RSGISSARTextureFilters_H
 
 #include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
 
 #include "common/RSGISImageException.h"
 
 #include "filtering/RSGISImageFilterException.h"
 #include "img/RSGISImageCalcException.h"
 #include "img/RSGISCalcImageValue.h"
+#include "img/RSGISImageWindowStats.h"
 #include "filtering/RSGISImageFilter.h"
 
 #include <boost/math/special_functions/fpclassify.hpp>
@@ -49,7 +53,48 @@
 
 namespace rsgis{namespace filter{
 
-	class DllExport RSGISNormVarPowerFilter : public RSGISImageFilter
+    enum RSGISSARTexture
+    {
+        sartex_normvarpower,
+        sartex_normvaramplitude,
+        sartex_normvarlnpower,
+        sartex_normln,
+        sartex_texturevar
+    };
+
+    /**
+     * SAR texture measures calculated from the moments of the valid (non-zero)
+     * pixels within the window of each pixel, which come from
+     * RSGISWindowBandMoments so the cost per pixel does not depend on the window
+     * size. Several textures can be calculated at once from the same window
+     * moments, giving an output band for each texture of each input band (all
+     * the bands for the first texture, then the second, etc.).
+     *
+     * Pixels which are 0 or NaN, or where the window has no more than 3 valid
+     * values, are 0. Where the texture uses logs or square roots only positive
+     * pixels are valid.
+     */
+    class DllExport RSGISSARTextureFilter : public RSGISImageFilter
+    {
+    public:
+        RSGISSARTextureFilter(int numberOutBands, int size, std::string filenameEnding, std::vector<RSGISSARTexture> textures);
+        /** The number of input bands; there is an output band for each texture of each. */
+        virtual void setNumOutBands(int bands);
+        virtual bool useImageWindowRows(){return true;};
+        virtual void calcImageWindowRow(const rsgis::img::RSGISImageWindowView &rowWindow, int width, double **outRows);
+        virtual void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output);
+        virtual bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageFilterException("Not implemented for SAR texture filters!");};
+        virtual void exportAsImage(std::string filename){throw RSGISImageFilterException("No image to output!");};
+        /** The texture from the window sums. */
+        static double calcTexture(RSGISSARTexture texture, const rsgis::img::RSGISWindowBandMoments::BandSums &sums);
+        virtual ~RSGISSARTextureFilter();
+    protected:
+        std::vector<RSGISSARTexture> textures;
+        bool calcTransformed;
+        rsgis::img::RSGISWindowBandMoments *windowMoments;
+    };
+
+	class DllExport RSGISNormVarPowerFilter : public RSGISSARTextureFilter
     {
         /**
 
@@ -62,13 +107,10 @@ namespace rsgis{namespace filter{
     public:
 
         RSGISNormVarPowerFilter(int numberOutBands, int size, std::string filenameEnding);
-        virtual void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output);
-        virtual bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageFilterException("Not implemented for NVarPower filter!");};;
-        virtual void exportAsImage(std::string filename){throw RSGISImageFilterException("No image to output!");};
         ~RSGISNormVarPowerFilter(){};
     };
 
-    class DllExport RSGISNormVarAmplitudeFilter : public RSGISImageFilter
+    class DllExport RSGISNormVarAmplitudeFilter : public RSGISSARTextureFilter
     {
         /**
 
@@ -81,13 +123,10 @@ namespace rsgis{namespace filter{
     public:
 
         RSGISNormVarAmplitudeFilter(int numberOutBands, int size, std::string filenameEnding);
-        virtual void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output);
-        virtual bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageFilterException("Not implemented for NVarAmplitude filter!");};;
-        virtual void exportAsImage(std::string filename){throw RSGISImageFilterException("No image to output!");};
         ~RSGISNormVarAmplitudeFilter(){};
     };
 
-    class DllExport RSGISNormVarLnPowerFilter : public RSGISImageFilter
+    class DllExport RSGISNormVarLnPowerFilter : public RSGISSARTextureFilter
     {
         /**
 
@@ -100,13 +139,10 @@ namespace rsgis{namespace filter{
     public:
 
         RSGISNormVarLnPowerFilter(int numberOutBands, int size, std::string filenameEnding);
-        virtual void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output);
-        virtual bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageFilterException("Not implemented for NVarLogPower filter!");};;
-        virtual void exportAsImage(std::string filename){throw RSGISImageFilterException("No image to output!");};
         ~RSGISNormVarLnPowerFilter(){};
     };
 
-    class DllExport RSGISNormLnFilter : public RSGISImageFilter
+    class DllExport RSGISNormLnFilter : public RSGISSARTextureFilter
     {
         /**
 
@@ -119,13 +155,10 @@ namespace rsgis{namespace filter{
     public:
 
         RSGISNormLnFilter(int numberOutBands, int size, std::string filenameEnding);
-        virtual void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output);
-        virtual bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageFilterException("Not implemented for NVarLogPower filter!");};;
-        virtual void exportAsImage(std::string filename){throw RSGISImageFilterException("No image to output!");};
         ~RSGISNormLnFilter(){};
     };
 
-    class DllExport RSGISTextureVar : public RSGISImageFilter
+    class DllExport RSGISTextureVar : public RSGISSARTextureFilter
     {
         /**
 
@@ -140,9 +173,6 @@ namespace rsgis{namespace filter{
     public:
 
         RSGISTextureVar(int numberOutBands, int size, std::string filenameEnding);
-        virtual void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output);
-        virtual bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageFilterException("Not implemented for NVarLogPower filter!");};;
-        virtual void exportAsImage(std::string filename){throw RSGISImageFilterException("No image to output!");};
         ~RSGISTextureVar(){};
     };
 }}
@@ -0,0 +1,263 @@
+/*
+ *  RSGISSlidingWindowRank.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2010 RSGISLib. All rights reserved.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISSlidingWindowRank.h"
+
+namespace rsgis{namespace filter{
+
+    // NaN values are sorted after all other values so they have their own bin.
+    static inline bool rsgisRankValLess(float a, float b)
+    {
+        return (a < b) || ((!std::isnan(a)) && std::isnan(b));
+    }
+
+    static inline bool rsgisRankValEqual(float a, float b)
+    {
+        return (a == b) || (std::isnan(a) && std::isnan(b));
+    }
+
+    RSGISSlidingWindowRank::RSGISSlidingWindowRank(int winSize)
+    {
+        if(winSize < 1)
+        {
+            throw RSGISImageFilterException("The window size must be at least 1.");
+        }
+        this->winSize = winSize;
+        this->numBins = 0;
+        this->directBins = true;
+        this->binMin = 0;
+    }
+
+    void RSGISSlidingWindowRank::calcRank(const float *inData, int width, int nRows, unsigned int rank, double *outData)
+    {
+        if(rank >= ((unsigned int)(winSize * winSize)))
+        {
+            throw RSGISImageFilterException("The rank must be less than the number of values within the window.");
+        }
+        size_t inWidth = ((size_t)width) + winSize - 1;
+        this->binValues(inData, inWidth * (nRows + winSize - 1));
+        this->tree.assign(this->numBins + 1, 0);
+        const unsigned int *inBins = this->bins.data();
+
+        for(int y = 0; y < nRows; ++y)
+        {
+            for(int j = 0; j < winSize; ++j)
+            {
+                const unsigned int *rowBins = inBins + ((y + j) * inWidth);
+                for(int k = 0; k < winSize; ++k)
+                {
+                    this->addToTree(rowBins[k], 1);
+                }
+            }
+
+            double *outRow = outData + (((size_t)y) * width);
+            for(int x = 0; x < width; ++x)
+            {
+                outRow[x] = this->getBinValue(this->findRankBin(rank));
+                // Move the window along a column, or empty the tree at the end of the row.
+                const unsigned int *colBins = inBins + ((y * inWidth) + x);
+                if((x + 1) < width)
+                {
+                    for(int j = 0; j < winSize; ++j)
+                    {
+                        this->addToTree(colBins[j * inWidth], -1);
+                        this->addToTree(colBins[(j * inWidth) + winSize], 1);
+                    }
+                }
+                else
+                {
+                    for(int j = 0; j < winSize; ++j)
+                    {
+                        for(int k = 0; k < winSize; ++k)
+                        {
+                            this->addToTree(colBins[(j * inWidth) + k], -1);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    void RSGISSlidingWindowRank::calcMode(const float *inData, int width, int nRows, double *outData)
+    {
+        size_t inWidth = ((size_t)width) + winSize - 1;
+        this->binValues(inData, inWidth * (nRows + winSize - 1));
+        this->counts.assign(this->numBins, 0);
+        unsigned int *binCounts = this->counts.data();
+        const unsigned int *inBins = this->bins.data();
+
+        unsigned int modeBin = 0;
+        unsigned int modeCount = 0;
+        // The mode is only searched for again when a value is removed from the
+        // mode bin, otherwise added values can only replace it.
+        bool findMode = true;
+        for(int y = 0; y < nRows; ++y)
+        {
+            for(int j = 0; j < winSize; ++j)
+            {
+                const unsigned int *rowBins = inBins + ((y + j) * inWidth);
+                for(int k = 0; k < winSize; ++k)
+                {
+                    ++binCounts[rowBins[k]];
+                }
+            }
+            findMode = true;
+
+            double *outRow = outData + (((size_t)y) * width);
+            for(int x = 0; x < width; ++x)
+            {
+                const unsigned int *winBins = inBins + ((y * inWidth) + x);
+                if(findMode)
+                {
+                    modeCount = 0;
+                    for(int j = 0; j < winSize; ++j)
+                    {
+                        for(int k = 0; k < winSize; ++k)
+                        {
+                            unsigned int bin = winBins[(j * inWidth) + k];
+                            if((binCounts[bin] > modeCount) || ((binCounts[bin] == modeCount) && (bin < modeBin)))
+                            {
+                                modeBin = bin;
+                                modeCount = binCounts[bin];
+                            }
+                        }
+                    }
+                    findMode = false;
+                }
+                outRow[x] = this->getBinValue(modeBin);
+
+                if((x + 1) < width)
+                {
+                    for(int j = 0; j < winSize; ++j)
+                    {
+                        unsigned int remBin = winBins[j * inWidth];
+                        --binCounts[remBin];
+                        if(remBin == modeBin)
+                        {
+                            findMode = true;
+                        }
+                        unsigned int addBin = winBins[(j * inWidth) + winSize];
+                        ++binCounts[addBin];
+                        if((!findMode) && ((binCounts[addBin] > modeCount) || ((binCounts[addBin] == modeCount) && (addBin < modeBin))))
+                        {
+                            modeBin = addBin;
+                            modeCount = binCounts[addBin];
+                        }
+                    }
+                }
+                else
+                {
+                    for(int j = 0; j < winSize; ++j)
+                    {
+                        for(int k = 0; k < winSize; ++k)
+                        {
+                            --binCounts[winBins[(j * inWidth) + k]];
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    void RSGISSlidingWindowRank::binValues(const float *inData, size_t nVals)
+    {
+        this->bins.resize(nVals);
+        if(nVals == 0)
+        {
+            this->numBins = 0;
+            return;
+        }
+
+        bool allInts = true;
+        float minVal = inData[0];
+        float maxVal = inData[0];
+        for(size_t i = 0; i < nVals; ++i)
+        {
+            float val = inData[i];
+            if((!std::isfinite(val)) || (val != std::floor(val)))
+            {
+                allInts = false;
+                break;
+            }
+            if(val < minVal)
+            {
+                minVal = val;
+            }
+            if(val > maxVal)
+            {
+                maxVal = val;
+            }
+        }
+
+        if(allInts && ((((double)maxVal) - minVal) < 1048576.0))
+        {
+            this->directBins = true;
+            this->binMin = minVal;
+            this->numBins = ((size_t)(maxVal - minVal)) + 1;
+            for(size_t i = 0; i < nVals; ++i)
+            {
+                this->bins[i] = (unsigned int)(inData[i] - minVal);
+            }
+        }
+        else
+        {
+            this->directBins = false;
+            this->binVals.assign(inData, inData + nVals);
+            std::sort(this->binVals.begin(), this->binVals.end(), rsgisRankValLess);
+            this->binVals.erase(std::unique(this->binVals.begin(), this->binVals.end(), rsgisRankValEqual), this->binVals.end());
+            this->numBins = this->binVals.size();
+            for(size_t i = 0; i < nVals; ++i)
+            {
+                this->bins[i] = std::lower_bound(this->binVals.begin(), this->binVals.end(), inData[i], rsgisRankValLess) - this->binVals.begin();
+            }
+        }
+    }
+
+    unsigned int RSGISSlidingWindowRank::findRankBin(unsigned int rank)
+    {
+        // Descend the tree for the first bin where the cumulative count is
+        // greater than rank.
+        size_t step = 1;
+        while((step * 2) <= this->numBins)
+        {
+            step *= 2;
+        }
+        size_t pos = 0;
+        int remain = rank + 1;
+        for(; step > 0; step /= 2)
+        {
+            if(((pos + step) <= this->numBins) && (this->tree[pos + step] < remain))
+            {
+                pos += step;
+                remain -= this->tree[pos];
+            }
+        }
+        return pos;
+    }
+
+    RSGISSlidingWindowRank::~RSGISSlidingWindowRank()
+    {
+
+    }
+
+}}
@@ -0,0 +1,107 @@
+/*
+ *  RSGISSlidingWindowRank.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2010 RSGISLib. All rights reserved.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISSlidingWindowRank_H
+#define RSGISSlidingWindowRank_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include "filtering/RSGISImageFilterException.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_filter_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace filter{
+
+    /**
+     * Rank (e.g., median) and mode values of a winSize x winSize window
+     * moved along rows of pixels without sorting each window.
+     *
+     * The values of a block are converted to histogram bins: integer images
+     * (with a range of up to 2^20) use a bin per value and other images a
+     * bin per distinct value within the block (found with a single sort of
+     * the block). As the window moves along a row one column of values is
+     * removed from the histogram and one added, with the counts held in a
+     * binary indexed (Fenwick) tree so the bin with a given rank is found in
+     * log(number of bins) steps.
+     *
+     * The input is in the layout used by RSGISImageFilter::runBlockFilter,
+     * the (nRows + winSize - 1) rows of (width + winSize - 1) values within
+     * the windows of the block.
+     */
+    class DllExport RSGISSlidingWindowRank
+    {
+    public:
+        RSGISSlidingWindowRank(int winSize);
+        /**
+         * The value with the rank (from 0, in increasing order) within each
+         * window, i.e., sorted[rank] of the window values.
+         */
+        void calcRank(const float *inData, int width, int nRows, unsigned int rank, double *outData);
+        /**
+         * The most common value within each window, the lowest value where
+         * more than one value is the most common.
+         */
+        void calcMode(const float *inData, int width, int nRows, double *outData);
+        ~RSGISSlidingWindowRank();
+    protected:
+        void binValues(const float *inData, size_t nVals);
+        inline void addToTree(unsigned int bin, int delta)
+        {
+            for(size_t i = bin + 1; i <= this->numBins; i += (i & (~i + 1)))
+            {
+                this->tree[i] += delta;
+            }
+        };
+        unsigned int findRankBin(unsigned int rank);
+        inline double getBinValue(unsigned int bin)
+        {
+            return this->directBins?(((double)this->binMin) + bin):this->binVals[bin];
+        };
+        int winSize;
+        size_t numBins;
+        bool directBins;
+        float binMin;
+        std::vector<unsigned int> bins;
+        std::vector<float> binVals;
+        std::vector<int> tree;
+        std::vector<unsigned int> counts;
+    };
+
+}}
+
+#endif
@@ -28,68 +28,56 @@ namespace rsgis{namespace filter{
     {
         this->nLooks = nLooks;
         this->internalScaleFactor = internalScaleFactor;
+        this->windowMoments = new rsgis::img::RSGISWindowBandMoments(false);
+    }
+    
+    double RSGISLeeFilter::calcLeeValue(const rsgis::img::RSGISWindowBandMoments::BandSums &sums, double centreVal)
+    {
+        double numVal = floor(sums.n + 0.5);
+        if(numVal < 1)
+        {
+            return 0;
+        }
+      	double cU = sqrt(1. / this->nLooks); // Noise variation coefficient;
+		double nNoiseMean = 1; // Mean multiplicative noise
+        
+        // The moments of the values scaled by the internal scale factor.
+        double iVal = centreVal * this->internalScaleFactor;
+        double iMean = (sums.sum / numVal) * this->internalScaleFactor;
+        double iVar = std::max((sums.sumSq / numVal) - ((sums.sum / numVal) * (sums.sum / numVal)), 0.0) * this->internalScaleFactor * this->internalScaleFactor;
+        
+        double k = (nNoiseMean * iVar) / (iMean*iMean*cU + nNoiseMean*nNoiseMean*iVar);
+        double outI = iMean + k*(iVal - nNoiseMean + iMean);
+        return outI / this->internalScaleFactor;
     }
 	
+    void RSGISLeeFilter::calcImageWindowRow(const rsgis::img::RSGISImageWindowView &rowWindow, int width, double **outRows)
+    {
+        int numBands = rowWindow.getNumBands();
+        int middleVal = rowWindow.getWinSize() / 2;
+        this->windowMoments->update(rowWindow, width);
+        for(int i = 0; i < numBands; i++)
+        {
+            const float *centreRow = rowWindow.getRow(i, middleVal) + middleVal;
+            for(int x = 0; x < width; ++x)
+            {
+                outRows[i][x] = this->calcLeeValue(this->windowMoments->getSums(i, x), centreRow[x]);
+            }
+        }
+    }
+    
 	void RSGISLeeFilter::calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) 
 	{
-	
         unsigned int middleVal = floor(((float)winSize) / 2);
-		unsigned int numVal = 0; // Number of values counted
-        float outI = 0;
-        float iVal = 0;
-        float iMean = 0;
-        float iVar = 0;
-      	float cU = sqrt(1. / this->nLooks); // Noise variation coefficient;
-		float nNoiseMean = 1; // Mean multiplicative noise
-		float k = 0;
-        
         for(int i = 0; i < numBands; i++)
         {
-            iMean = 0;
-            iVar = 0;
-			numVal = 0;
-
-            // Calculate mean
-            for(int j = 0; j < size; j++)
-            {
-                for(int k = 0; k < size; k++)
-                {
-                    if(dataBlock[i][j][k] != 0)
-					{
-							iMean = iMean + dataBlock[i][j][k]*this->internalScaleFactor;
-							if((j == middleVal) && (k == middleVal))
-							{
-								iVal = dataBlock[i][j][k]*this->internalScaleFactor;
-							}
-							numVal++;
-					}
-                }
-            }
-            
-            iMean = iMean / numVal;
-            
-            // Calculate variance
-            for(int j = 0; j < size; j++)
-            {
-                for(int k = 0; k < size; k++)
-                {
-                     if(dataBlock[i][j][k] != 0)
-					 {
-					     iVar = iVar + pow((dataBlock[i][j][k]*this->internalScaleFactor - iMean), 2);
-					 }
-                }
-            }
-            
-            iVar = iVar / numVal;
-            
-            k = (nNoiseMean * iVar) / (iMean*iMean*cU + nNoiseMean*nNoiseMean*iVar);
-            outI = iMean + k*(iVal - nNoiseMean + iMean);
-            output[i] = outI / this->internalScaleFactor;
+            rsgis::img::RSGISWindowBandMoments::BandSums sums = rsgis::img::RSGISWindowBandMoments::sumWindow(dataBlock, i, winSize, false);
+            output[i] = this->calcLeeValue(sums, dataBlock[i][middleVal][middleVal]);
         }
 	}
 	
 	RSGISLeeFilter::~RSGISLeeFilter()
 	{
-		
+		delete this->windowMoments;
 	}
 }}
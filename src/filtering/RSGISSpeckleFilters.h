@@ -30,6 +30,7 @@
 #include "filtering/RSGISImageFilterException.h"
 #include "img/RSGISImageCalcException.h"
 #include "img/RSGISCalcImageValue.h"
+#include "img/RSGISImageWindowStats.h"
 #include "filtering/RSGISImageFilter.h"
 
 // mark all exported classes/functions with DllExport to have
@@ -60,18 +61,27 @@ namespace rsgis{namespace filter{
 
          http://resources.arcgis.com/en/help/main/10.1/index.html#/Speckle_function/009t000001z7000000/
 
+         The window mean and variance (of the non-zero pixels) come from
+         RSGISWindowBandMoments so the cost per pixel does not depend on the
+         window size. Pixels with no non-zero values in their window are 0.
+
          */
         
     public: 
         
         RSGISLeeFilter(int numberOutBands, int size, std::string filenameEnding, unsigned int nLooks, float internalScaleFactor=100);
+        virtual bool useImageWindowRows(){return true;};
+        virtual void calcImageWindowRow(const rsgis::img::RSGISImageWindowView &rowWindow, int width, double **outRows);
         virtual void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output);
         virtual bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageFilterException("Not implemented for Lee filter!");};;
         virtual void exportAsImage(std::string filename){throw RSGISImageFilterException("No image to output!");};
         ~RSGISLeeFilter();
     protected:
+        /** The filtered value from the window sums and the value of the centre pixel. */
+        double calcLeeValue(const rsgis::img::RSGISWindowBandMoments::BandSums &sums, double centreVal);
         unsigned int nLooks;
         float internalScaleFactor;
+        rsgis::img::RSGISWindowBandMoments *windowMoments;
     };
 }}
 
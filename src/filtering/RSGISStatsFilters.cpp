@@ -52,6 +52,30 @@ namespace rsgis{namespace filter{
 		}
 	}
 
+	void RSGISMeanFilter::calcImageWindowValue(const rsgis::img::RSGISImageWindowView &window, double *output)
+	{
+		if(this->size != window.getWinSize())
+		{
+			throw rsgis::img::RSGISImageCalcException("Window sizes are different");
+		}
+
+		double outputValue = 0;
+		int numberElements = this->size * this->size;
+		for(int i = 0; i < window.getNumBands(); i++)
+		{
+			outputValue = 0;
+			for(int j = 0; j < this->size; j++)
+			{
+				const float *row = window.getRow(i, j);
+				for(int k = 0; k < this->size; k++)
+				{
+					outputValue = outputValue + row[k];
+				}
+			}
+			output[i] = outputValue/numberElements;
+		}
+	}
+
 	bool RSGISMeanFilter::calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) 
 	{
 		throw rsgis::img::RSGISImageCalcException("Not implemented yet");
@@ -72,6 +96,17 @@ namespace rsgis{namespace filter{
 
 	}
 
+	void RSGISMedianFilter::runFilter(GDALDataset **datasets, int numDS, std::string outputImage, std::string gdalFormat, GDALDataType outDataType)
+	{
+		// The window is moved along each row with a sliding histogram rather than sorting each window.
+		RSGISSlidingWindowRank windowRank(this->size);
+		unsigned int median = (this->size * this->size) / 2;
+		this->runBlockFilter(datasets, numDS, outputImage, gdalFormat, outDataType, [&windowRank, median](const float *inData, int width, int nRows, double *outData)
+		{
+			windowRank.calcRank(inData, width, nRows, median, outData);
+		});
+	}
+	
 	void RSGISMedianFilter::calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) 
 	{
 		if(this->size != winSize)
@@ -122,6 +157,15 @@ namespace rsgis{namespace filter{
 
 	}
 
+	void RSGISModeFilter::runFilter(GDALDataset **datasets, int numDS, std::string outputImage, std::string gdalFormat, GDALDataType outDataType)
+	{
+		RSGISSlidingWindowRank windowRank(this->size);
+		this->runBlockFilter(datasets, numDS, outputImage, gdalFormat, outDataType, [&windowRank](const float *inData, int width, int nRows, double *outData)
+		{
+			windowRank.calcMode(inData, width, nRows, outData);
+		});
+	}
+	
 	void RSGISModeFilter::calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) 
 	{
 		if(this->size != winSize)
@@ -214,6 +258,38 @@ namespace rsgis{namespace filter{
 		}
 	}
 
+	void RSGISRangeFilter::calcImageWindowValue(const rsgis::img::RSGISImageWindowView &window, double *output)
+	{
+		if(this->size != window.getWinSize())
+		{
+			throw rsgis::img::RSGISImageCalcException("Window sizes are different");
+		}
+
+		float min = 0;
+		float max = 0;
+		for(int i = 0; i < window.getNumBands(); i++)
+		{
+			min = window.get(i, 0, 0);
+			max = min;
+			for(int j = 0; j < this->size; j++)
+			{
+				const float *row = window.getRow(i, j);
+				for(int k = 0; k < this->size; k++)
+				{
+					if(row[k] > max)
+					{
+						max = row[k];
+					}
+					else if(row[k] < min)
+					{
+						min = row[k];
+					}
+				}
+			}
+			output[i] = max-min;
+		}
+	}
+
 	bool RSGISRangeFilter::calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) 
 	{
 		throw rsgis::img::RSGISImageCalcException("Not implemented yet");
@@ -272,6 +348,45 @@ namespace rsgis{namespace filter{
 		}
 	}
 
+	void RSGISStdDevFilter::calcImageWindowValue(const rsgis::img::RSGISImageWindowView &window, double *output)
+	{
+		if(this->size != window.getWinSize())
+		{
+			throw rsgis::img::RSGISImageCalcException("Window sizes are different");
+		}
+
+		double outputValue = 0;
+		double squSum = 0;
+		float mean = 0;
+		int numberElements = this->size * this->size;
+		for(int i = 0; i < window.getNumBands(); i++)
+		{
+			outputValue = 0;
+			squSum = 0;
+			for(int j = 0; j < this->size; j++)
+			{
+				const float *row = window.getRow(i, j);
+				for(int k = 0; k < this->size; k++)
+				{
+					outputValue = outputValue + row[k];
+				}
+			}
+
+			mean = outputValue/numberElements;
+
+			for(int j = 0; j < this->size; j++)
+			{
+				const float *row = window.getRow(i, j);
+				for(int k = 0; k < this->size; k++)
+				{
+					squSum += ((row[k] - mean) * (row[k] - mean));
+				}
+			}
+
+			output[i] = sqrt(squSum/numberElements);
+		}
+	}
+
 	bool RSGISStdDevFilter::calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) 
 	{
 		throw rsgis::img::RSGISImageCalcException("Not implemented yet");
@@ -387,6 +502,32 @@ namespace rsgis{namespace filter{
 		}
 	}
 
+	void RSGISMinFilter::calcImageWindowValue(const rsgis::img::RSGISImageWindowView &window, double *output)
+	{
+		if(this->size != window.getWinSize())
+		{
+			throw rsgis::img::RSGISImageCalcException("Window sizes are different");
+		}
+
+		float min = 0;
+		for(int i = 0; i < window.getNumBands(); i++)
+		{
+			min = window.get(i, 0, 0);
+			for(int j = 0; j < this->size; j++)
+			{
+				const float *row = window.getRow(i, j);
+				for(int k = 0; k < this->size; k++)
+				{
+					if(row[k] < min)
+					{
+						min = row[k];
+					}
+				}
+			}
+			output[i] = min;
+		}
+	}
+
 	bool RSGISMinFilter::calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) 
 	{
 		throw rsgis::img::RSGISImageCalcException("Not implemented yet");
@@ -443,6 +584,32 @@ namespace rsgis{namespace filter{
 		}
 	}
 
+	void RSGISMaxFilter::calcImageWindowValue(const rsgis::img::RSGISImageWindowView &window, double *output)
+	{
+		if(this->size != window.getWinSize())
+		{
+			throw rsgis::img::RSGISImageCalcException("Window sizes are different");
+		}
+
+		float max = 0;
+		for(int i = 0; i < window.getNumBands(); i++)
+		{
+			max = window.get(i, 0, 0);
+			for(int j = 0; j < this->size; j++)
+			{
+				const float *row = window.getRow(i, j);
+				for(int k = 0; k < this->size; k++)
+				{
+					if(row[k] > max)
+					{
+						max = row[k];
+					}
+				}
+			}
+			output[i] = max;
+		}
+	}
+
 	bool RSGISMaxFilter::calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) 
 	{
 		throw rsgis::img::RSGISImageCalcException("Not implemented yet");
@@ -486,6 +653,29 @@ namespace rsgis{namespace filter{
 		}
 	}
 
+	void RSGISTotalFilter::calcImageWindowValue(const rsgis::img::RSGISImageWindowView &window, double *output)
+	{
+		if(this->size != window.getWinSize())
+		{
+			throw rsgis::img::RSGISImageCalcException("Window sizes are different");
+		}
+
+		double outputValue = 0;
+		for(int i = 0; i < window.getNumBands(); i++)
+		{
+			outputValue = 0;
+			for(int j = 0; j < this->size; j++)
+			{
+				const float *row = window.getRow(i, j);
+				for(int k = 0; k < this->size; k++)
+				{
+					outputValue = outputValue + row[k];
+				}
+			}
+			output[i] = outputValue;
+		}
+	}
+
 	bool RSGISTotalFilter::calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) 
 	{
 		throw rsgis::img::RSGISImageCalcException("Not implemented yet");
@@ -32,7 +32,9 @@
 #include "filtering/RSGISImageFilterException.h"
 #include "img/RSGISImageCalcException.h"
 #include "img/RSGISCalcImageValue.h"
+#include "img/RSGISImageRowRingBuffer.h"
 #include "filtering/RSGISImageFilter.h"
+#include "filtering/RSGISSlidingWindowRank.h"
 
 #include "datastruct/SortedGenericList.cpp"
 
@@ -56,6 +58,8 @@ namespace rsgis{namespace filter{
 		public:
 			RSGISMeanFilter(int numberOutBands, int size, std::string filenameEnding);
 			virtual void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output);
+			virtual bool useImageWindowView(){return true;};
+			virtual void calcImageWindowValue(const rsgis::img::RSGISImageWindowView &window, double *output);
 			virtual bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output);
 			virtual void exportAsImage(std::string filename);
 			~RSGISMeanFilter();
@@ -65,6 +69,7 @@ namespace rsgis{namespace filter{
 		{
 		public:
 			RSGISMedianFilter(int numberOutBands, int size, std::string filenameEnding);
+			virtual void runFilter(GDALDataset **datasets, int numDS, std::string outputImage, std::string gdalFormat, GDALDataType outDataType);
 			virtual void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output);
 			virtual bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output);
 			virtual void exportAsImage(std::string filename);
@@ -75,6 +80,7 @@ namespace rsgis{namespace filter{
 		{
 		public:
 			RSGISModeFilter(int numberOutBands, int size, std::string filenameEnding);
+			virtual void runFilter(GDALDataset **datasets, int numDS, std::string outputImage, std::string gdalFormat, GDALDataType outDataType);
 			virtual void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output);
 			virtual bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output);
 			virtual void exportAsImage(std::string filename);
@@ -86,6 +92,8 @@ namespace rsgis{namespace filter{
 		public:
 			RSGISRangeFilter(int numberOutBands, int size, std::string filenameEnding);
 			virtual void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output);
+			virtual bool useImageWindowView(){return true;};
+			virtual void calcImageWindowValue(const rsgis::img::RSGISImageWindowView &window, double *output);
 			virtual bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output);
 			virtual void exportAsImage(std::string filename);
 			~RSGISRangeFilter();
@@ -96,6 +104,8 @@ namespace rsgis{namespace filter{
 		public:
 			RSGISStdDevFilter(int numberOutBands, int size, std::string filenameEnding);
 			virtual void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output);
+			virtual bool useImageWindowView(){return true;};
+			virtual void calcImageWindowValue(const rsgis::img::RSGISImageWindowView &window, double *output);
 			virtual bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output);
 			virtual void exportAsImage(std::string filename);
 			~RSGISStdDevFilter();
@@ -122,6 +132,8 @@ namespace rsgis{namespace filter{
 		public:
 			RSGISMinFilter(int numberOutBands, int size, std::string filenameEnding);
 			virtual void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output);
+			virtual bool useImageWindowView(){return true;};
+			virtual void calcImageWindowValue(const rsgis::img::RSGISImageWindowView &window, double *output);
 			virtual bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output);
 			virtual void exportAsImage(std::string filename);
 			~RSGISMinFilter();
@@ -132,6 +144,8 @@ namespace rsgis{namespace filter{
 		public:
 			RSGISMaxFilter(int numberOutBands, int size, std::string filenameEnding);
 			virtual void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output);
+			virtual bool useImageWindowView(){return true;};
+			virtual void calcImageWindowValue(const rsgis::img::RSGISImageWindowView &window, double *output);
 			virtual bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output);
 			virtual void exportAsImage(std::string filename);
 			~RSGISMaxFilter();
@@ -142,6 +156,8 @@ namespace rsgis{namespace filter{
 		public:
 			RSGISTotalFilter(int numberOutBands, int size, std::string filenameEnding);
 			virtual void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output);
+			virtual bool useImageWindowView(){return true;};
+			virtual void calcImageWindowValue(const rsgis::img::RSGISImageWindowView &window, double *output);
 			virtual bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output);
 			virtual void exportAsImage(std::string filename);
 			~RSGISTotalFilter();
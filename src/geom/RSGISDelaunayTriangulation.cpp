@@ -34,6 +34,7 @@ namespace rsgis{namespace geom{
 		this->aOuter = a;
 		this->bOuter = b;
 		this->cOuter = c;
+		this->initLocate();
 	}
 	
 	RSGISDelaunayTriangulation::RSGISDelaunayTriangulation(RSGISTriangle *tri)
@@ -45,74 +46,72 @@ namespace rsgis{namespace geom{
 		this->aOuter = tri->getPointA();
 		this->bOuter = tri->getPointB();
 		this->cOuter = tri->getPointC();
+		this->initLocate();
 	}
 	
 	RSGISDelaunayTriangulation::RSGISDelaunayTriangulation(std::list<RSGIS2DPoint*> *data)
 	{
-		RSGISGeometry geomUtils;
-		RSGISTriangle *tri = geomUtils.findBoundingTriangle(data);
-		
 		this->triangleList = new std::list<RSGISTriangle*>();
-		triangleList->push_back(tri);
-		
 		this->bbox = new geos::geom::Envelope();
-		this->bbox->expandToInclude(tri->getBBox());
-		this->aOuter = tri->getPointA();
-		this->bOuter = tri->getPointB();
-		this->cOuter = tri->getPointC();
-				
-		int i = 0;
-		int feedback = data->size()/10;
-		int feedbackCounter = 0;
+		this->aOuter = NULL;
+		this->bOuter = NULL;
+		this->cOuter = NULL;
+		this->initLocate();
 		
-		std::cout << "Started" << std::flush;
-		std::list<RSGIS2DPoint*>::iterator iterData;
-		for(iterData = data->begin(); iterData != data->end(); ++iterData)
-		{
-			if((i % feedback) == 0)
-			{
-				std::cout << ".." << feedbackCounter << ".." << std::flush;
-				feedbackCounter = feedbackCounter + 10;
-			}
-			this->addVertex(*iterData);
-			++i;
-		}
-		std::cout << " Complete.\n";
-		this->finaliseTriangulation();
+		std::vector<RSGIS2DPoint*> dataVec(data->begin(), data->end());
+		this->createCGALTriangulation(&dataVec);
 	}
 	
 	RSGISDelaunayTriangulation::RSGISDelaunayTriangulation(std::vector<RSGIS2DPoint*> *data)
 	{
-		RSGISGeometry geomUtils;
-		RSGISTriangle *tri = geomUtils.findBoundingTriangle(data);
-		
 		this->triangleList = new std::list<RSGISTriangle*>();
-		triangleList->push_back(tri);
-		
 		this->bbox = new geos::geom::Envelope();
-		this->bbox->expandToInclude(tri->getBBox());
-		this->aOuter = tri->getPointA();
-		this->bOuter = tri->getPointB();
-		this->cOuter = tri->getPointC();
+		this->aOuter = NULL;
+		this->bOuter = NULL;
+		this->cOuter = NULL;
+		this->initLocate();
 		
-		int i = 0;
-		int feedback = data->size()/10;
-		int feedbackCounter = 0;
+		this->createCGALTriangulation(data);
+	}
+	
+	void RSGISDelaunayTriangulation::initLocate()
+	{
+		this->numThreads = rsgis::utils::getNumThreads();
+		this->locateIndexValid = false;
+		this->gridCols = 0;
+		this->gridRows = 0;
+		this->gridMinX = 0;
+		this->gridMinY = 0;
+		this->cellWidth = 0;
+		this->cellHeight = 0;
+	}
+	
+	void RSGISDelaunayTriangulation::createCGALTriangulation(std::vector<RSGIS2DPoint*> *data)
+	{
+		typedef CGAL::Exact_predicates_inexact_constructions_kernel K;
+		typedef CGAL::Triangulation_vertex_base_with_info_2<size_t, K> VertexBase;
+		typedef CGAL::Triangulation_data_structure_2<VertexBase> TDS;
+		typedef CGAL::Delaunay_triangulation_2<K, TDS> Delaunay;
 		
-		std::cout << "Started" << std::flush;
-		std::vector<RSGIS2DPoint*>::iterator iterData;
-		for(iterData = data->begin(); iterData != data->end(); ++iterData)
+		std::vector<std::pair<K::Point_2, size_t> > pts;
+		pts.reserve(data->size());
+		for(size_t i = 0; i < data->size(); ++i)
 		{
-			if((data->size() > 10) && ((i % feedback) == 0))
-			{
-				std::cout << ".." << feedbackCounter << ".." << std::flush;
-				feedbackCounter = feedbackCounter + 10;
-			}
-			this->addVertex(*iterData);
-			++i;
+			pts.push_back(std::pair<K::Point_2, size_t>(K::Point_2(data->at(i)->getX(), data->at(i)->getY()), i));
 		}
-		std::cout << " Complete.\n";
-		this->finaliseTriangulation();
+		
+		std::cout << "Triangulating " << data->size() << " points\n";
+		// The points are spatially sorted (Hilbert/BRIO) before insertion; coincident points are only inserted once.
+		Delaunay dt;
+		dt.insert(pts.begin(), pts.end());
+		
+		for(Delaunay::Finite_faces_iterator iterFace = dt.finite_faces_begin(); iterFace != dt.finite_faces_end(); ++iterFace)
+		{
+			RSGISTriangle *tri = new RSGISTriangle(data->at(iterFace->vertex(0)->info()), data->at(iterFace->vertex(1)->info()), data->at(iterFace->vertex(2)->info()));
+			this->triangleList->push_back(tri);
+			this->bbox->expandToInclude(tri->getBBox());
+		}
+		this->locateIndexValid = false;
 	}
 	
 	void RSGISDelaunayTriangulation::createDelaunayTriangulation(std::list<RSGIS2DPoint*> *data)
@@ -140,6 +139,7 @@ namespace rsgis{namespace geom{
 	void RSGISDelaunayTriangulation::addVertex(RSGIS2DPoint *pt)
 	{
 		RSGISGeometry geomUtils;
+		this->locateIndexValid = false;
 		try
 		{
 			std::list<RSGISTriangle*>::iterator iterTriangles;
@@ -246,6 +246,7 @@ namespace rsgis{namespace geom{
 	
 	void RSGISDelaunayTriangulation::finaliseTriangulation(std::list<RSGIS2DPoint*> *data)
 	{
+		this->locateIndexValid = false;
 		std::list<RSGISTriangle*>::iterator iterTriangles;
 		std::list<RSGIS2DPoint*>::iterator iterPts;
 		RSGISTriangle *tri = NULL;
@@ -308,6 +309,7 @@ namespace rsgis{namespace geom{
 	
 	void RSGISDelaunayTriangulation::finaliseTriangulation()
 	{
+		this->locateIndexValid = false;
 		std::list<RSGISTriangle*>::iterator iterTriangles;
 		RSGISTriangle *tri = NULL;
 		geos::geom::Envelope *env = new geos::geom::Envelope();
@@ -439,6 +441,162 @@ namespace rsgis{namespace geom{
 		delete lines;
 	}
 	
+	void RSGISDelaunayTriangulation::setNumThreads(unsigned int numThreads)
+	{
+		this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+	}
+	
+	void RSGISDelaunayTriangulation::buildLocateIndex()
+	{
+		this->locateTris.assign(this->triangleList->begin(), this->triangleList->end());
+		size_t numTris = this->locateTris.size();
+		this->locateCoords.resize(numTris * 6);
+		double minX = 0;
+		double maxX = 0;
+		double minY = 0;
+		double maxY = 0;
+		if(numTris > 0)
+		{
+			minX = maxX = this->locateTris[0]->getPointA()->getX();
+			minY = maxY = this->locateTris[0]->getPointA()->getY();
+		}
+		for(size_t i = 0; i < numTris; ++i)
+		{
+			RSGIS2DPoint *pts[3] = {this->locateTris[i]->getPointA(), this->locateTris[i]->getPointB(), this->locateTris[i]->getPointC()};
+			for(int j = 0; j < 3; ++j)
+			{
+				double x = pts[j]->getX();
+				double y = pts[j]->getY();
+				this->locateCoords[(i*6)+(j*2)] = x;
+				this->locateCoords[(i*6)+(j*2)+1] = y;
+				minX = std::min(minX, x);
+				maxX = std::max(maxX, x);
+				minY = std::min(minY, y);
+				maxY = std::max(maxY, y);
+			}
+		}
+		
+		// Around one triangle per cell.
+		double width = std::max(maxX - minX, 1e-12);
+		double height = std::max(maxY - minY, 1e-12);
+		double cellSize = sqrt((width * height) / std::max<size_t>(numTris, 1));
+		this->gridCols = std::max<unsigned int>(1, std::min<double>(ceil(width / cellSize), 4096));
+		this->gridRows = std::max<unsigned int>(1, std::min<double>(ceil(height / cellSize), 4096));
+		this->gridMinX = minX;
+		this->gridMinY = minY;
+		this->cellWidth = width / this->gridCols;
+		this->cellHeight = height / this->gridRows;
+		
+		// Count the triangles whose bounding box overlaps each cell, then fill the cells.
+		size_t numCells = ((size_t)this->gridCols) * this->gridRows;
+		this->cellStart.assign(numCells + 1, 0);
+		for(int pass = 0; pass < 2; ++pass)
+		{
+			std::vector<size_t> cellFill;
+			if(pass == 1)
+			{
+				for(size_t c = 0; c < numCells; ++c)
+				{
+					this->cellStart[c+1] += this->cellStart[c];
+				}
+				this->cellTris.resize(this->cellStart[numCells]);
+				cellFill.assign(this->cellStart.begin(), this->cellStart.end() - 1);
+			}
+			for(size_t i = 0; i < numTris; ++i)
+			{
+				const double *coords = &this->locateCoords[i*6];
+				double tMinX = std::min(coords[0], std::min(coords[2], coords[4]));
+				double tMaxX = std::max(coords[0], std::max(coords[2], coords[4]));
+				double tMinY = std::min(coords[1], std::min(coords[3], coords[5]));
+				double tMaxY = std::max(coords[1], std::max(coords[3], coords[5]));
+				unsigned int c0 = std::min<unsigned int>((tMinX - minX) / this->cellWidth, this->gridCols - 1);
+				unsigned int c1 = std::min<unsigned int>((tMaxX - minX) / this->cellWidth, this->gridCols - 1);
+				unsigned int r0 = std::min<unsigned int>((tMinY - minY) / this->cellHeight, this->gridRows - 1);
+				unsigned int r1 = std::min<unsigned int>((tMaxY - minY) / this->cellHeight, this->gridRows - 1);
+				for(unsigned int r = r0; r <= r1; ++r)
+				{
+					for(unsigned int c = c0; c <= c1; ++c)
+					{
+						size_t cell = (((size_t)r) * this->gridCols) + c;
+						if(pass == 0)
+						{
+							++this->cellStart[cell+1];
+						}
+						else
+						{
+							this->cellTris[cellFill[cell]++] = i;
+						}
+					}
+				}
+			}
+		}
+		this->locateIndexValid = true;
+	}
+	
+	long RSGISDelaunayTriangulation::findTriangle(double x, double y, double *wA, double *wB, double *wC) const
+	{
+		if(this->locateTris.empty())
+		{
+			return -1;
+		}
+		double colF = (x - this->gridMinX) / this->cellWidth;
+		double rowF = (y - this->gridMinY) / this->cellHeight;
+		if((colF < 0) || (rowF < 0) || (colF > this->gridCols) || (rowF > this->gridRows))
+		{
+			return -1;
+		}
+		size_t cell = (((size_t)std::min<unsigned int>(rowF, this->gridRows - 1)) * this->gridCols) + std::min<unsigned int>(colF, this->gridCols - 1);
+		for(size_t k = this->cellStart[cell]; k < this->cellStart[cell+1]; ++k)
+		{
+			const double *coords = &this->locateCoords[((size_t)this->cellTris[k])*6];
+			double det = ((coords[3] - coords[5]) * (coords[0] - coords[4])) + ((coords[4] - coords[2]) * (coords[1] - coords[5]));
+			if(det == 0)
+			{
+				continue;
+			}
+			double l1 = (((coords[3] - coords[5]) * (x - coords[4])) + ((coords[4] - coords[2]) * (y - coords[5]))) / det;
+			double l2 = (((coords[5] - coords[1]) * (x - coords[4])) + ((coords[0] - coords[4]) * (y - coords[5]))) / det;
+			double l3 = 1.0 - l1 - l2;
+			// Points on a shared edge are given to the first triangle found.
+			const double eps = -1e-12;
+			if((l1 >= eps) && (l2 >= eps) && (l3 >= eps))
+			{
+				*wA = l1;
+				*wB = l2;
+				*wC = l3;
+				return this->cellTris[k];
+			}
+		}
+		return -1;
+	}
+	
+	void RSGISDelaunayTriangulation::locatePoints(const std::vector<geos::geom::Coordinate> &pts, std::vector<RSGISTriangle*> *tris, std::vector<double> *weights)
+	{
+		if(!this->locateIndexValid)
+		{
+			this->buildLocateIndex();
+		}
+		size_t numPts = pts.size();
+		tris->assign(numPts, NULL);
+		weights->assign(numPts * 3, 0.0);
+		
+		const size_t ptsPerChunk = 4096;
+		size_t numChunks = (numPts + ptsPerChunk - 1) / ptsPerChunk;
+		rsgis::utils::parallelFor(numChunks, this->numThreads, [&](size_t chunk, unsigned int)
+		{
+			size_t end = std::min(numPts, (chunk + 1) * ptsPerChunk);
+			for(size_t i = chunk * ptsPerChunk; i < end; ++i)
+			{
+				double *w = &(*weights)[i*3];
+				long triIdx = this->findTriangle(pts[i].x, pts[i].y, &w[0], &w[1], &w[2]);
+				if(triIdx >= 0)
+				{
+					(*tris)[i] = this->locateTris[triIdx];
+				}
+			}
+		});
+	}
+	
 	RSGISDelaunayTriangulation::~RSGISDelaunayTriangulation()
 	{
 		std::list<RSGISTriangle*>::iterator iterTriangles;
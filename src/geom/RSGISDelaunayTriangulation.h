@@ -26,6 +26,13 @@
 #include <string>
 #include <iostream>
 #include <list>
+#include <vector>
+#include <utility>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <cstdlib>
+#include <cmath>
 
 #include "geom/RSGIS2DPoint.h"
 #include "geom/RSGISGeometryException.h"
@@ -35,9 +42,14 @@
 #include "geos/geom/Envelope.h"
 
 #include "common/rsgis-tqdm.h"
+#include "common/RSGISParallel.h"
 
 #include "math/RSGISMathsUtils.h"
 
+#include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
+#include <CGAL/Delaunay_triangulation_2.h>
+#include <CGAL/Triangulation_vertex_base_with_info_2.h>
+
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
 #undef DllExport
@@ -53,6 +65,16 @@
 
 namespace rsgis{namespace geom{
 	
+	/**
+	 * A Delaunay triangulation as a list of RSGISTriangle. Created from a
+	 * set of points, the triangulation is built by CGAL (with spatially sorted
+	 * insertion) and its finite faces copied to the list; created from a
+	 * bounding triangle the points are added one at a time with addVertex.
+	 *
+	 * locatePoints finds the triangle containing each of a batch of points,
+	 * and its barycentric weights for linear interpolation, through a grid
+	 * index of the triangles, sharing the points among several threads.
+	 */
 	class DllExport RSGISDelaunayTriangulation
 		{
 		public:
@@ -78,14 +100,54 @@ namespace rsgis{namespace geom{
 			void finaliseTriangulation();
 			std::list<RSGISTriangle*>* getTriangulation();
 			void plotTriangulationAsEdges(std::string filename);
+			/**
+			 * The number of threads used by locatePoints (default RSGISLIB_NUM_THREADS or 1); 0 uses the number of cores.
+			 */
+			void setNumThreads(unsigned int numThreads);
+			/**
+			 * Find the triangle containing each point (NULL if outside the
+			 * triangulation) and, in weights (3 per point), the barycentric
+			 * weights of its points a, b and c.
+			 */
+			void locatePoints(const std::vector<geos::geom::Coordinate> &pts, std::vector<RSGISTriangle*> *tris, std::vector<double> *weights);
 			~RSGISDelaunayTriangulation();
 		protected:
+			/**
+			 * Triangulate the points with CGAL and add the triangles to the list.
+			 */
+			void createCGALTriangulation(std::vector<RSGIS2DPoint*> *data);
+			/**
+			 * Read the number of threads and reset the point location index.
+			 */
+			void initLocate();
+			/**
+			 * Bin the triangles into a grid over the bounding box (in CSR form)
+			 * for locatePoints; rebuilt when the triangulation has changed.
+			 */
+			void buildLocateIndex();
+			/**
+			 * The triangle of the index containing a point and its weights.
+			 */
+			long findTriangle(double x, double y, double *wA, double *wB, double *wC) const;
 			std::list<RSGIS2DPoint*>* getPtsClockwise(std::list<RSGISTriangle*> *tris, RSGIS2DPoint *pt);
 			std::list<RSGISTriangle*> *triangleList;
             geos::geom::Envelope *bbox;
 			RSGIS2DPoint *aOuter;
 			RSGIS2DPoint *bOuter;
 			RSGIS2DPoint *cOuter;
+			unsigned int numThreads;
+			bool locateIndexValid;
+			std::vector<RSGISTriangle*> locateTris;
+			// The coordinates (ax, ay, bx, by, cx, cy) of the indexed triangles.
+			std::vector<double> locateCoords;
+			std::vector<size_t> cellStart;
+			std::vector<unsigned int> cellTris;
+			unsigned int gridCols;
+			unsigned int gridRows;
+			double gridMinX;
+			double gridMinY;
+			double cellWidth;
+			double cellHeight;
 		};
 
 }}
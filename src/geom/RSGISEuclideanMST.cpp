@@ -0,0 +1,215 @@
+/*
+ *  RSGISEuclideanMST.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISEuclideanMST.h"
+
+namespace rsgis{namespace geom{
+    
+    typedef CGAL::Exact_predicates_inexact_constructions_kernel EMSTKernel;
+    typedef CGAL::Triangulation_vertex_base_with_info_2<unsigned int, EMSTKernel> EMSTVertexBase;
+    typedef CGAL::Triangulation_data_structure_2<EMSTVertexBase> EMSTTDS;
+    typedef CGAL::Delaunay_triangulation_2<EMSTKernel, EMSTTDS> EMSTDelaunay;
+    
+    RSGISEuclideanMST::RSGISEuclideanMST()
+    {
+        this->numVertices = 0;
+    }
+    
+    void RSGISEuclideanMST::calcDelaunayEdges(std::vector<RSGIS2DPoint*> *data)
+    {
+        this->numVertices = data->size();
+        this->edges.clear();
+        
+        std::vector<std::pair<EMSTKernel::Point_2, unsigned int> > pts;
+        pts.reserve(data->size());
+        for(unsigned int i = 0; i < data->size(); ++i)
+        {
+            data->at(i)->setIndex(i);
+            pts.push_back(std::pair<EMSTKernel::Point_2, unsigned int>(EMSTKernel::Point_2(data->at(i)->getX(), data->at(i)->getY()), i));
+        }
+        
+        // Spatially sorted insertion; a coincident point is not given a vertex of its own.
+        EMSTDelaunay dt;
+        dt.insert(pts.begin(), pts.end());
+        
+        // A triangulation of n points has at most 3n edges.
+        this->edges.reserve((3 * ((size_t)this->numVertices)) + 1);
+        RSGISMSTEdge edge;
+        for(EMSTDelaunay::Finite_edges_iterator iterEdge = dt.finite_edges_begin(); iterEdge != dt.finite_edges_end(); ++iterEdge)
+        {
+            EMSTDelaunay::Vertex_handle vA = iterEdge->first->vertex(EMSTDelaunay::cw(iterEdge->second));
+            EMSTDelaunay::Vertex_handle vB = iterEdge->first->vertex(EMSTDelaunay::ccw(iterEdge->second));
+            edge.vertA = vA->info();
+            edge.vertB = vB->info();
+            edge.length = sqrt(CGAL::to_double(CGAL::squared_distance(vA->point(), vB->point())));
+            this->edges.push_back(edge);
+        }
+        
+        if(dt.number_of_vertices() < pts.size())
+        {
+            for(std::vector<std::pair<EMSTKernel::Point_2, unsigned int> >::iterator iterPt = pts.begin(); iterPt != pts.end(); ++iterPt)
+            {
+                EMSTDelaunay::Vertex_handle vh = dt.nearest_vertex(iterPt->first);
+                if(vh->info() != iterPt->second)
+                {
+                    edge.vertA = vh->info();
+                    edge.vertB = iterPt->second;
+                    edge.length = 0;
+                    this->edges.push_back(edge);
+                }
+            }
+        }
+    }
+    
+    void RSGISEuclideanMST::calcMinSpanTree()
+    {
+        std::sort(this->edges.begin(), this->edges.end(), [](const RSGISMSTEdge &a, const RSGISMSTEdge &b){return a.length < b.length;});
+        
+        std::vector<unsigned int> parent(this->numVertices);
+        std::vector<unsigned int> setSize(this->numVertices, 1);
+        for(unsigned int i = 0; i < this->numVertices; ++i)
+        {
+            parent[i] = i;
+        }
+        
+        // Kruskal: keep the edges (in order of length) which join two trees, compacting them to the front.
+        size_t numTreeEdges = 0;
+        for(size_t i = 0; i < this->edges.size(); ++i)
+        {
+            if(unionSets(parent, setSize, this->edges[i].vertA, this->edges[i].vertB))
+            {
+                this->edges[numTreeEdges++] = this->edges[i];
+                if(numTreeEdges == (this->numVertices - 1))
+                {
+                    break;
+                }
+            }
+        }
+        this->edges.resize(numTreeEdges);
+        this->edges.shrink_to_fit();
+    }
+    
+    void RSGISEuclideanMST::calcEdgeLengthStats(double *mean, double *stddev) const
+    {
+        *mean = 0;
+        *stddev = 0;
+        if(this->edges.empty())
+        {
+            return;
+        }
+        double total = 0;
+        for(std::vector<RSGISMSTEdge>::const_iterator iterEdge = this->edges.begin(); iterEdge != this->edges.end(); ++iterEdge)
+        {
+            total += iterEdge->length;
+        }
+        *mean = total / this->edges.size();
+        double totalSq = 0;
+        for(std::vector<RSGISMSTEdge>::const_iterator iterEdge = this->edges.begin(); iterEdge != this->edges.end(); ++iterEdge)
+        {
+            totalSq += (iterEdge->length - (*mean)) * (iterEdge->length - (*mean));
+        }
+        *stddev = sqrt(totalSq / this->edges.size());
+    }
+    
+    unsigned int RSGISEuclideanMST::calcComponents(double threshold, std::vector<unsigned int> *component) const
+    {
+        std::vector<unsigned int> parent(this->numVertices);
+        std::vector<unsigned int> setSize(this->numVertices, 1);
+        for(unsigned int i = 0; i < this->numVertices; ++i)
+        {
+            parent[i] = i;
+        }
+        for(std::vector<RSGISMSTEdge>::const_iterator iterEdge = this->edges.begin(); iterEdge != this->edges.end(); ++iterEdge)
+        {
+            if(iterEdge->length <= threshold)
+            {
+                unionSets(parent, setSize, iterEdge->vertA, iterEdge->vertB);
+            }
+        }
+        
+        // Number the roots in order of the first vertex of each component (setSize is reused for the labels).
+        unsigned int numComps = 0;
+        const unsigned int noLabel = this->numVertices;
+        std::fill(setSize.begin(), setSize.end(), noLabel);
+        component->resize(this->numVertices);
+        for(unsigned int i = 0; i < this->numVertices; ++i)
+        {
+            unsigned int root = findRoot(parent, i);
+            if(setSize[root] == noLabel)
+            {
+                setSize[root] = numComps++;
+            }
+            component->at(i) = setSize[root];
+        }
+        return numComps;
+    }
+    
+    std::list<RSGIS2DPoint*>** RSGISEuclideanMST::createClusters(std::vector<RSGIS2DPoint*> *data, const std::vector<unsigned int> &component, unsigned int numComps)
+    {
+        if(data->size() != component.size())
+        {
+            throw rsgis::math::RSGISClustererException("Input data and number of graph elements different.");
+        }
+        std::list<RSGIS2DPoint*> **outputClusters = new std::list<RSGIS2DPoint*>*[numComps];
+        for(unsigned int i = 0; i < numComps; i++)
+        {
+            outputClusters[i] = new std::list<RSGIS2DPoint*>();
+        }
+        for(unsigned int i = 0; i < data->size(); i++)
+        {
+            outputClusters[component[i]]->push_back(data->at(i));
+        }
+        return outputClusters;
+    }
+    
+    unsigned int RSGISEuclideanMST::findRoot(std::vector<unsigned int> &parent, unsigned int vert)
+    {
+        while(parent[vert] != vert)
+        {
+            parent[vert] = parent[parent[vert]];
+            vert = parent[vert];
+        }
+        return vert;
+    }
+    
+    bool RSGISEuclideanMST::unionSets(std::vector<unsigned int> &parent, std::vector<unsigned int> &setSize, unsigned int vertA, unsigned int vertB)
+    {
+        unsigned int rootA = findRoot(parent, vertA);
+        unsigned int rootB = findRoot(parent, vertB);
+        if(rootA == rootB)
+        {
+            return false;
+        }
+        if(setSize[rootA] < setSize[rootB])
+        {
+            std::swap(rootA, rootB);
+        }
+        parent[rootB] = rootA;
+        setSize[rootA] += setSize[rootB];
+        return true;
+    }
+    
+    RSGISEuclideanMST::~RSGISEuclideanMST()
+    {
+        
+    }
+    
+}}
@@ -0,0 +1,123 @@
+/*
+ *  RSGISEuclideanMST.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISEuclideanMST_H
+#define RSGISEuclideanMST_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <list>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+
+#include "geom/RSGIS2DPoint.h"
+
+#include "math/RSGISClustererException.h"
+
+#include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
+#include <CGAL/Delaunay_triangulation_2.h>
+#include <CGAL/Triangulation_vertex_base_with_info_2.h>
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_geom_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace geom{
+    
+    /**
+     * An edge between two points (their indexes in the input data).
+     */
+    struct DllExport RSGISMSTEdge
+    {
+        unsigned int vertA;
+        unsigned int vertB;
+        float length;
+    };
+    
+    /**
+     * A compact Euclidean minimum spanning tree for the graph clusterers.
+     * The Delaunay edges of the points are held in a flat array (12 bytes
+     * per edge), the tree is found with Kruskal's algorithm using a
+     * union-find over the vertex indexes, and the edges are reduced to the
+     * tree in place. Clusters are the components of the edges at or below a
+     * length threshold, again found with a union-find, so no graph with per
+     * vertex objects is built and 10^7 points only need a few hundred MB.
+     */
+    class DllExport RSGISEuclideanMST
+    {
+    public:
+        RSGISEuclideanMST();
+        /**
+         * Find the Delaunay edges of the points (CGAL, with the index of each
+         * point as the vertex info). Coincident points, which share a vertex
+         * of the triangulation, are joined to it by zero length edges.
+         */
+        void calcDelaunayEdges(std::vector<RSGIS2DPoint*> *data);
+        /**
+         * Reduce the edges to the minimum spanning tree (or forest), sorted
+         * by length.
+         */
+        void calcMinSpanTree();
+        /**
+         * The mean and (population) standard deviation of the edge lengths.
+         */
+        void calcEdgeLengthStats(double *mean, double *stddev) const;
+        /**
+         * Label the components of the graph of the edges with a length at or
+         * below the threshold, numbered in the order of their first vertex.
+         * Returns the number of components.
+         */
+        unsigned int calcComponents(double threshold, std::vector<unsigned int> *component) const;
+        /**
+         * Group the points into lists by component, as returned by the
+         * clusterers.
+         */
+        static std::list<RSGIS2DPoint*>** createClusters(std::vector<RSGIS2DPoint*> *data, const std::vector<unsigned int> &component, unsigned int numComps);
+        const std::vector<RSGISMSTEdge>& getEdges() const {return this->edges;};
+        unsigned int getNumVertices() const {return this->numVertices;};
+        ~RSGISEuclideanMST();
+    protected:
+        /**
+         * The root of a vertex's set, halving the path on the way.
+         */
+        static unsigned int findRoot(std::vector<unsigned int> &parent, unsigned int vert);
+        /**
+         * Merge the sets of two vertices (by size); false if already the same set.
+         */
+        static bool unionSets(std::vector<unsigned int> &parent, std::vector<unsigned int> &setSize, unsigned int vertA, unsigned int vertB);
+        unsigned int numVertices;
+        std::vector<RSGISMSTEdge> edges;
+    };
+    
+}}
+
+#endif
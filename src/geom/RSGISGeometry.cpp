@@ -1065,6 +1065,8 @@ namespace rsgis{namespace geom{
 			bool contains = false;
 			bool areaError = false;
 			int count = 0;
+			// Each polygon is tested against all the small polygons.
+			RSGISPreparedGeometryCache prepCache;
 			std::cout << "Merging neighboring polygons, this may take some time: \nStarted .." << std::flush;
 			while(change)
 			{
@@ -1080,6 +1082,7 @@ namespace rsgis{namespace geom{
 					if(poly->getArea() < 0.1)
 					{
 						polygons->erase(iterPolys);
+						prepCache.remove(poly);
 						delete poly;
 					}
 					else
@@ -1095,7 +1098,7 @@ namespace rsgis{namespace geom{
 								areaErrorPolygon = *iterSmallPolys;
 								break;
 							}
-							else if(poly->contains((*iterSmallPolys)))
+							else if(prepCache.contains(poly, (*iterSmallPolys)))
 							{
 								contains = true;
 								containedPolygon = *iterSmallPolys;
@@ -1133,6 +1136,7 @@ namespace rsgis{namespace geom{
 
 							iterPolys = polygons->begin();
 							
+							prepCache.remove(poly);
 							delete poly;
 							delete overlapPolygon;
 						}
@@ -1165,6 +1169,8 @@ namespace rsgis{namespace geom{
 		float minDistance = 0;
 		int minIndex = 0;
 		bool first = true;
+		// The distances from each polygon to be merged to every polygon use its facet index.
+		RSGISPreparedGeometryCache prepCache;
 		for(int i = 0; i < numPolygonsToMerge; i++)
 		{
 			poly = polygonsToMerge->at(i);
@@ -1172,7 +1178,7 @@ namespace rsgis{namespace geom{
 			for(int j = 0; j < numPolygons; j++)
 			{
 				tmpPoly = polygons->at(j);
-				distance = poly->distance(tmpPoly);
+				distance = prepCache.distance(poly, tmpPoly);
 				if(first)
 				{
 					minIndex = j;
@@ -1188,6 +1194,7 @@ namespace rsgis{namespace geom{
 			polygonsMerge->push_back(polygonsToMerge->at(i));
 			polygonsMerge->push_back(polygons->at(minIndex));
 			polygons->erase((polygons->begin()+minIndex));
+			prepCache.remove(poly);
 			polygons->push_back(identifyNonConvexPolygon->retrievePolygon(polygonsMerge));
 			polygonsMerge->clear();
 		}
@@ -1649,9 +1656,10 @@ namespace rsgis{namespace geom{
 		std::vector<geos::geom::Polygon*>::iterator iterPolys;
 		try
 		{
+			RSGISPreparedGeometryCache prepCache;
 			for(iterPolys = polygons->begin(); iterPolys != polygons->end(); iterPolys++)
 			{
-				if (outline->contains(*iterPolys) == true)
+				if (prepCache.contains(outline, *iterPolys) == true)
 				{
 					outPolygons->push_back(*iterPolys);
 				}
@@ -26,6 +26,7 @@
 #include "geom/RSGISTriangle.h"
 #include "geom/RSGISGeomTestExport.h"
 #include "geom/RSGISIdentifyNonConvexPolygons.h"
+#include "geom/RSGISPreparedGeometryCache.h"
 
 #include "utils/RSGISGEOSFactoryGenerator.h"
 #include "utils/RSGISExportForPlotting.h"
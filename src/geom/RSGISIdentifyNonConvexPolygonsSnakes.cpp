@@ -37,6 +37,7 @@ namespace rsgis{namespace geom{
 		this->gamma = gamma;
 		this->delta = delta;
 		this->maxNumIterations = maxNumIterations;
+		this->numStarts = 1;
 	}
 			
 	std::vector<geos::geom::Polygon*>* RSGISIdentifyNonConvexPolygonsSnakes::retrievePolygons(std::list<RSGIS2DPoint*> **clusters, int numClusters)
@@ -157,7 +158,7 @@ namespace rsgis{namespace geom{
 			std::vector<geos::geom::Coordinate*> *coordsVec = new std::vector<geos::geom::Coordinate*>();
 			
 			rsgis::math::RSGISGlobalOptimisationFunction *optimiseFunc = NULL;
-			rsgis::math::RSGISGlobalOptimiser2D *optimise = NULL;
+			rsgis::math::RSGISGlobalHillClimbingOptimiser2D *optimise = NULL;
 			
 			if(pxlPolys->size() == 1)
 			{
@@ -218,6 +219,7 @@ namespace rsgis{namespace geom{
 			std::cout << "CoordVec has " << coordsVec->size() << " nodes\n";
 			
 			std::cout << "Perform snakes based refinement of boundary\n";
+			optimise->setMultiStart(this->numStarts, resolution);
 			std::vector<geos::geom::Coordinate*> *coordsVecOp = optimise->optimise8Neighbor(coordsVec, resolution, imgBoundary);
 				
 			std::vector<geos::geom::Coordinate*>::iterator iterCoords;
@@ -371,7 +373,7 @@ namespace rsgis{namespace geom{
 			std::vector<geos::geom::Coordinate*> *coordsVec = new std::vector<geos::geom::Coordinate*>();
 			
 			rsgis::math::RSGISGlobalOptimisationFunction *optimiseFunc = NULL;
-			rsgis::math::RSGISGlobalOptimiser2D *optimise = NULL;
+			rsgis::math::RSGISGlobalHillClimbingOptimiser2D *optimise = NULL;
 			
 			if(pxlPolys->size() == 1)
 			{
@@ -433,6 +435,7 @@ namespace rsgis{namespace geom{
 			std::cout << "CoordVec has " << coordsVec->size() << " nodes\n";
 			
 			std::cout << "Perform snakes based refinement of boundary\n";
+			optimise->setMultiStart(this->numStarts, resolution);
 			std::vector<geos::geom::Coordinate*> *coordsVecOp = optimise->optimise8Neighbor(coordsVec, resolution, imgBoundary);
 			
 			std::vector<geos::geom::Coordinate*>::iterator iterCoords;
@@ -916,13 +919,12 @@ namespace rsgis{namespace geom{
 	
 	/***
 	 * 
-	 * RSGISSnakeNonConvexGlobalOptimisationFunction
+	 * RSGISSnakeImageSampler
 	 *
 	 */
 	
-	RSGISSnakeNonConvexGlobalOptimisationFunction::RSGISSnakeNonConvexGlobalOptimisationFunction(GDALDataset *image, double alpha, double beta, double gamma)
+	RSGISSnakeImageSampler::RSGISSnakeImageSampler(GDALDataset *image): rows(image->GetRasterYSize()), rowsRead(image->GetRasterYSize())
 	{
-		this->image = image;
 		this->imgWidth = image->GetRasterXSize();
 		this->imgHeight = image->GetRasterYSize();
 		
@@ -937,8 +939,68 @@ namespace rsgis{namespace geom{
 		double yMax = trans[3];
 		this->env->init(xMin, xMax, yMin, yMax);
 		delete[] trans;
-		this->data = (float *) CPLMalloc(sizeof(float)*imgWidth);
 		imageBand = image->GetRasterBand(1);
+		for(int i = 0; i < imgHeight; ++i)
+		{
+			rowsRead[i] = false;
+		}
+	}
+	
+	float RSGISSnakeImageSampler::getValue(const geos::geom::Coordinate &coord)
+	{
+        rsgis::math::RSGISMathsUtils mathUtils;
+		
+		int y = mathUtils.roundUp((env->getMaxY() - coord.y)/resolution);
+		int x = mathUtils.roundUp((coord.x - env->getMinX())/resolution);
+		
+		if((y < 0) | (y >= imgHeight))
+		{
+            std::cout << "Image Height: " << imgHeight << std::endl;
+            std::cout << "Image Width: " << imgWidth << std::endl;
+			std::string message = std::string("Y Does not fit within the image: ") + mathUtils.inttostring(y); 
+			throw rsgis::math::RSGISOptimisationException(message);
+		}
+		
+		if((x < 0) | (x >= imgWidth))
+		{
+            std::cout << "Image Height: " << imgHeight << std::endl;
+            std::cout << "Image Width: " << imgWidth << std::endl;
+			std::string message = std::string("X Does not fit within the image: ") + mathUtils.inttostring(x); 
+			throw rsgis::math::RSGISOptimisationException(message);
+		}
+		
+		if(!rowsRead[y].load(std::memory_order_acquire))
+		{
+			std::lock_guard<std::mutex> lock(readMutex);
+			if(!rowsRead[y].load(std::memory_order_relaxed))
+			{
+				rows[y].resize(imgWidth);
+				if(imageBand->RasterIO(GF_Read, 0, y, imgWidth, 1, rows[y].data(), imgWidth, 1, GDT_Float32, 0, 0) != CE_None)
+				{
+					throw rsgis::math::RSGISOptimisationException("Could not read a row of the image.");
+				}
+				rowsRead[y].store(true, std::memory_order_release);
+			}
+		}
+		return rows[y][x];
+	}
+	
+	RSGISSnakeImageSampler::~RSGISSnakeImageSampler()
+	{
+		delete env;
+	}
+	
+	
+	/***
+	 * 
+	 * RSGISSnakeNonConvexGlobalOptimisationFunction
+	 *
+	 */
+	
+	RSGISSnakeNonConvexGlobalOptimisationFunction::RSGISSnakeNonConvexGlobalOptimisationFunction(GDALDataset *image, double alpha, double beta, double gamma)
+	{
+		this->image = image;
+		this->sampler = new RSGISSnakeImageSampler(image);
 		this->alpha = alpha;
 		this->beta = beta;
 		this->gamma = gamma;
@@ -946,8 +1008,6 @@ namespace rsgis{namespace geom{
 	
 	double RSGISSnakeNonConvexGlobalOptimisationFunction::calcValue(std::vector<geos::geom::Coordinate*> *coords)
 	{
-        rsgis::math::RSGISMathsUtils mathUtils;
-		
 		double energyValue = 0;
 		double internalEnergy = 0;
 		double externalEnergy = 0;
@@ -958,16 +1018,8 @@ namespace rsgis{namespace geom{
 		double currentNextStiffY = 0;
 		double currentNextStiffPart = 0;
 		
-		int y = 0;
-		double diffY = 0;
-		int x = 0;
-		double diffX = 0;
-		
-		int nodeCount = 0;
-		
 		geos::geom::Coordinate *prev;
 		geos::geom::Coordinate *next;
-		geos::geom::Coordinate *current2 = new geos::geom::Coordinate();
 		
 		std::vector<geos::geom::Coordinate*>::iterator iterCoords;
 		for(iterCoords = coords->begin(); iterCoords != coords->end(); ++iterCoords)
@@ -987,86 +1039,68 @@ namespace rsgis{namespace geom{
 				next = (*(iterCoords+1));
 				prev = (*(iterCoords-1));
 			}
-
-			diffY = (env->getMaxY() - (*iterCoords)->y)/resolution;
-			y = mathUtils.roundUp(diffY);
-			diffX = ((*iterCoords)->x - env->getMinX())/resolution;
-			x = mathUtils.roundUp(diffX);
 			
-			if((y < 0) | (y >= imgHeight))
-			{
-                std::cout << "Image Height: " << imgHeight << std::endl;
-                std::cout << "Image Width: " << imgWidth << std::endl;
-				std::string message = std::string("Y Does not fit within the image: ") + mathUtils.inttostring(y); 
-				throw rsgis::math::RSGISOptimisationException(message);
-			}
-			
-			if((x < 0) | (x >= imgWidth))
-			{
-                std::cout << "Image Height: " << imgHeight << std::endl;
-                std::cout << "Image Width: " << imgWidth << std::endl;
-                
-				std::string message = std::string("X Does not fit within the image: ") + mathUtils.inttostring(x); 
-				throw rsgis::math::RSGISOptimisationException(message);
-			}
-						
-			imageBand->RasterIO(GF_Read, 0, y, imgWidth, 1, data, imgWidth, 1, GDT_Float32, 0, 0);
-			externalEnergy += (data[x] * gamma);
+			externalEnergy += (sampler->getValue(**iterCoords) * gamma);
 			
 			currentNextDist = sqrt(((next->x - (*iterCoords)->x)*(next->x - (*iterCoords)->x)) + (((next)->y - (*iterCoords)->y)*((next)->y - (*iterCoords)->y)));
 			currentNextElas = alpha * (currentNextDist * currentNextDist);
 			
-			current2->x = (*iterCoords)->x * 2;
-			current2->y = (*iterCoords)->y * 2;
-			
-			currentNextStiffX = next->x - current2->x + prev->x;
-			currentNextStiffY = next->y - current2->y + prev->y;
+			currentNextStiffX = next->x - ((*iterCoords)->x * 2) + prev->x;
+			currentNextStiffY = next->y - ((*iterCoords)->y * 2) + prev->y;
 			currentNextStiffPart = sqrt((currentNextStiffX * currentNextStiffX) + (currentNextStiffY * currentNextStiffY));
 			currentNextStiff = beta * (currentNextStiffPart * currentNextStiffPart);
 			
 			internalEnergy += (currentNextElas + currentNextStiff);
-						
-			++nodeCount;
 		}
-		delete current2;
 		
 		energyValue = externalEnergy + internalEnergy;
 		
 		return energyValue;
 	}
 	
+	double RSGISSnakeNonConvexGlobalOptimisationFunction::calcLocalValue(std::vector<geos::geom::Coordinate*> *coords, size_t idx)
+	{
+		// The external energy of the node, the elasticity of the two segments
+		// either side and the stiffness at the node and its neighbours.
+		size_t numCoords = coords->size();
+		if(numCoords < 3)
+		{
+			return this->calcValue(coords);
+		}
+		auto node = [coords, numCoords, idx](int offset){ return coords->at((idx + numCoords + offset) % numCoords); };
+		
+		double energyValue = sampler->getValue(*node(0)) * gamma;
+		for(int i = -1; i <= 0; ++i)
+		{
+			double dx = node(i+1)->x - node(i)->x;
+			double dy = node(i+1)->y - node(i)->y;
+			energyValue += alpha * ((dx * dx) + (dy * dy));
+		}
+		for(int i = -1; i <= 1; ++i)
+		{
+			double stiffX = node(i+1)->x - (node(i)->x * 2) + node(i-1)->x;
+			double stiffY = node(i+1)->y - (node(i)->y * 2) + node(i-1)->y;
+			energyValue += beta * ((stiffX * stiffX) + (stiffY * stiffY));
+		}
+		return energyValue;
+	}
+	
 	RSGISSnakeNonConvexGlobalOptimisationFunction::~RSGISSnakeNonConvexGlobalOptimisationFunction()
 	{
-		delete env;
-		CPLFree(data);
+		delete sampler;
 	}
 	
 	
 	/***
 	 * 
-	 * RSGISSnakeNonConvexGlobalOptimisationFunction
+	 * RSGISSnakeNonConvexLineProjGlobalOptimisationFunction
 	 *
 	 */
 	
 	RSGISSnakeNonConvexLineProjGlobalOptimisationFunction::RSGISSnakeNonConvexLineProjGlobalOptimisationFunction(GDALDataset *image, double alpha, double beta, double gamma, double delta, std::vector<geos::geom::LineSegment*> *lines)
 	{
 		this->image = image;
-		this->imgWidth = image->GetRasterXSize();
-		this->imgHeight = image->GetRasterYSize();
-		
-		this->env = new geos::geom::Envelope ();
-		double *trans = new double[6];
-		image->GetGeoTransform(trans);
-		this->resolution = trans[1];		
-		
-		double xMin = trans[0];
-		double xMax = trans[0]+(imgWidth*resolution);
-		double yMin = trans[3]-(imgHeight*resolution);
-		double yMax = trans[3];
-		this->env->init(xMin, xMax, yMin, yMax);
-		delete[] trans;
-		this->data = (float *) CPLMalloc(sizeof(float)*imgWidth);
-		imageBand = image->GetRasterBand(1);
+		this->sampler = new RSGISSnakeImageSampler(image);
 		this->alpha = alpha;
 		this->beta = beta;
 		this->gamma = gamma;
@@ -1076,8 +1110,6 @@ namespace rsgis{namespace geom{
 	
 	double RSGISSnakeNonConvexLineProjGlobalOptimisationFunction::calcValue(std::vector<geos::geom::Coordinate*> *coords)
 	{
-        rsgis::math::RSGISMathsUtils mathUtils;
-		
 		double energyValue = 0;
 		double internalEnergy = 0;
 		double externalEnergy = 0;
@@ -1088,17 +1120,9 @@ namespace rsgis{namespace geom{
 		double currentNextStiffY = 0;
 		double currentNextStiffPart = 0;
 		double currentNextDist2Line = 0;
-				
-		int y = 0;
-		double diffY = 0;
-		int x = 0;
-		double diffX = 0;
-		
-		int nodeCount = 0;
 		
         geos::geom::Coordinate *prev;
 		geos::geom::Coordinate *next;
-		geos::geom::Coordinate *current2 = new geos::geom::Coordinate();
 		
 		std::vector<geos::geom::Coordinate*>::iterator iterCoords;
 		std::vector<geos::geom::LineSegment*>::iterator iterLines;
@@ -1126,60 +1150,60 @@ namespace rsgis{namespace geom{
 				prev = (*(iterCoords-1));
 			}
 			
-			diffY = (env->getMaxY() - (*iterCoords)->y)/resolution;
-			y = mathUtils.roundUp(diffY);
-			diffX = ((*iterCoords)->x - env->getMinX())/resolution;
-			x = mathUtils.roundUp(diffX);
-			
-			if((y < 0) | (y >= imgHeight))
-			{
-				std::cout << "Image Height: " << imgHeight << std::endl;
-                std::cout << "Image Width: " << imgWidth << std::endl;
-				
-				std::string message = std::string("Y Does not fit within the image: ") + mathUtils.inttostring(y); 
-				throw rsgis::math::RSGISOptimisationException(message);
-			}
-			
-			if((x < 0) | (x >= imgWidth))
-			{
-				std::cout << "Image Height: " << imgHeight << std::endl;
-                std::cout << "Image Width: " << imgWidth << std::endl;
-				
-				std::string message = std::string("X Does not fit within the image: ") + mathUtils.inttostring(x); 
-				throw rsgis::math::RSGISOptimisationException(message);
-			}
-			
-			imageBand->RasterIO(GF_Read, 0, y, imgWidth, 1, data, imgWidth, 1, GDT_Float32, 0, 0);
-			externalEnergy += (data[x] * gamma);
+			externalEnergy += (sampler->getValue(**iterCoords) * gamma);
 			
 			currentNextDist = sqrt(((next->x - (*iterCoords)->x)*(next->x - (*iterCoords)->x)) + (((next)->y - (*iterCoords)->y)*((next)->y - (*iterCoords)->y)));
 			currentNextElas = alpha * (currentNextDist * currentNextDist);
 			
-			current2->x = (*iterCoords)->x * 2;
-			current2->y = (*iterCoords)->y * 2;
-			
-			currentNextStiffX = next->x - current2->x + prev->x;
-			currentNextStiffY = next->y - current2->y + prev->y;
+			currentNextStiffX = next->x - ((*iterCoords)->x * 2) + prev->x;
+			currentNextStiffY = next->y - ((*iterCoords)->y * 2) + prev->y;
 			currentNextStiffPart = sqrt((currentNextStiffX * currentNextStiffX) + (currentNextStiffY * currentNextStiffY));
 			currentNextStiff = beta * (currentNextStiffPart * currentNextStiffPart);
 			currentNextDist2Line = delta * ((*iterLines)->distancePerpendicular(*(*iterCoords)));
 			
 			internalEnergy += (currentNextElas + currentNextStiff + currentNextDist2Line);
 			
-			++nodeCount;
 			++iterLines;
 		}
-		delete current2;
 		energyValue = externalEnergy + internalEnergy;
 				
 		return energyValue;
 	}
 	
+	double RSGISSnakeNonConvexLineProjGlobalOptimisationFunction::calcLocalValue(std::vector<geos::geom::Coordinate*> *coords, size_t idx)
+	{
+		// As RSGISSnakeNonConvexGlobalOptimisationFunction::calcLocalValue
+		// plus the distance of the node to its projected line.
+		size_t numCoords = coords->size();
+		if(numCoords < 3)
+		{
+			return this->calcValue(coords);
+		}
+		if(idx >= lines->size())
+		{
+			throw RSGISGeometryException("Not enough projected lines.");
+		}
+		auto node = [coords, numCoords, idx](int offset){ return coords->at((idx + numCoords + offset) % numCoords); };
+		
+		double energyValue = sampler->getValue(*node(0)) * gamma;
+		for(int i = -1; i <= 0; ++i)
+		{
+			double dx = node(i+1)->x - node(i)->x;
+			double dy = node(i+1)->y - node(i)->y;
+			energyValue += alpha * ((dx * dx) + (dy * dy));
+		}
+		for(int i = -1; i <= 1; ++i)
+		{
+			double stiffX = node(i+1)->x - (node(i)->x * 2) + node(i-1)->x;
+			double stiffY = node(i+1)->y - (node(i)->y * 2) + node(i-1)->y;
+			energyValue += beta * ((stiffX * stiffX) + (stiffY * stiffY));
+		}
+		energyValue += delta * lines->at(idx)->distancePerpendicular(*node(0));
+		return energyValue;
+	}
+	
 	RSGISSnakeNonConvexLineProjGlobalOptimisationFunction::~RSGISSnakeNonConvexLineProjGlobalOptimisationFunction()
 	{
-		delete env;
-		CPLFree(data);
+		delete sampler;
 	}
 }}
-
-
@@ -28,6 +28,8 @@
 #include <list>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <mutex>
 
 #include "common/rsgis-tqdm.h"
 #include "common/RSGISImageException.h"
@@ -75,6 +77,12 @@ namespace rsgis{namespace geom{
 			virtual std::vector<geos::geom::Polygon*>* retrievePolygons(std::list<geos::geom::Polygon*> **clusters, int numClusters);
 			virtual geos::geom::Polygon* retrievePolygon(std::vector<geos::geom::Polygon*> *polygons);
 			virtual geos::geom::Polygon* retrievePolygon(std::list<geos::geom::Polygon*> *polygons);
+			/**
+			 * Fit each outline from numStarts starting contours (the initial
+			 * contour and copies with the nodes displaced by up to a pixel),
+			 * see rsgis::math::RSGISGlobalHillClimbingOptimiser2D::setMultiStart.
+			 */
+			void setNumStarts(unsigned int numStarts){this->numStarts = (numStarts == 0)?1:numStarts;};
 			virtual ~RSGISIdentifyNonConvexPolygonsSnakes();
 		private:
 			double resolution;
@@ -83,6 +91,7 @@ namespace rsgis{namespace geom{
 			double gamma;
 			double delta;
 			int maxNumIterations;
+			unsigned int numStarts;
 			OGRSpatialReference* spatialRef;
 			GDALDriver *gdalDriver;
 			GDALDataset* createDataset(GDALDriver *gdalDriver, geos::geom::Geometry *geom, std::string filename, float resolution, float constVal);
@@ -95,20 +104,41 @@ namespace rsgis{namespace geom{
 		};
 	
 	
-	class DllExport RSGISSnakeNonConvexGlobalOptimisationFunction : public rsgis::math::RSGISGlobalOptimisationFunction
+	/**
+	 * Reads the values of the first band of an image at coordinates, keeping
+	 * each row once read so contours can be evaluated repeatedly without
+	 * reading the image again. Safe to use from several threads.
+	 */
+	class DllExport RSGISSnakeImageSampler
 		{
 		public:
-			RSGISSnakeNonConvexGlobalOptimisationFunction(GDALDataset *image, double alpha, double beta, double gamma);
-			virtual double calcValue(std::vector<geos::geom::Coordinate*> *coords);
-			virtual ~RSGISSnakeNonConvexGlobalOptimisationFunction();
+			RSGISSnakeImageSampler(GDALDataset *image);
+			/** The value of the pixel containing the coordinate, throws a RSGISOptimisationException if outside the image. */
+			float getValue(const geos::geom::Coordinate &coord);
+			~RSGISSnakeImageSampler();
 		protected:
-			GDALDataset *image;
 			GDALRasterBand *imageBand;
 			int imgWidth;
 			int imgHeight;
 			double resolution;
 			geos::geom::Envelope *env;
-			float *data;
+			std::vector<std::vector<float> > rows;
+			std::vector<std::atomic<bool> > rowsRead;
+			std::mutex readMutex;
+		};
+	
+	class DllExport RSGISSnakeNonConvexGlobalOptimisationFunction : public rsgis::math::RSGISGlobalOptimisationFunction
+		{
+		public:
+			RSGISSnakeNonConvexGlobalOptimisationFunction(GDALDataset *image, double alpha, double beta, double gamma);
+			virtual double calcValue(std::vector<geos::geom::Coordinate*> *coords);
+			virtual bool hasLocalValue(){return true;};
+			virtual double calcLocalValue(std::vector<geos::geom::Coordinate*> *coords, size_t idx);
+			virtual bool isThreadSafe(){return true;};
+			virtual ~RSGISSnakeNonConvexGlobalOptimisationFunction();
+		protected:
+			GDALDataset *image;
+			RSGISSnakeImageSampler *sampler;
 			double alpha;
 			double beta;
 			double gamma;
@@ -119,16 +149,14 @@ namespace rsgis{namespace geom{
 		public:
 			RSGISSnakeNonConvexLineProjGlobalOptimisationFunction(GDALDataset *image, double alpha, double beta, double gamma, double delta, std::vector<geos::geom::LineSegment*> *lines);
 			virtual double calcValue(std::vector<geos::geom::Coordinate*> *coords);
+			virtual bool hasLocalValue(){return true;};
+			virtual double calcLocalValue(std::vector<geos::geom::Coordinate*> *coords, size_t idx);
+			virtual bool isThreadSafe(){return true;};
 			virtual ~RSGISSnakeNonConvexLineProjGlobalOptimisationFunction();
 		protected:
 			GDALDataset *image;
-			GDALRasterBand *imageBand;
+			RSGISSnakeImageSampler *sampler;
             std::vector<geos::geom::LineSegment*> *lines;
-			int imgWidth;
-			int imgHeight;
-			double resolution;
-			geos::geom::Envelope *env;
-			float *data;
 			double alpha;
 			double beta;
 			double gamma;
@@ -35,45 +35,17 @@ namespace rsgis{namespace geom{
 		try
 		{
 			std::cout << "Construct Delaunay Triangulation\n";
-			RSGISDelaunayTriangulation *tri = new RSGISDelaunayTriangulation(data);
-			ClusterGraph *cg = this->constructGraph(tri, data);
-			this->constructMinimumSpanningTree(cg);
-			
-            boost::property_map<ClusterGraph, boost::edge_weight_t>::type weight = boost::get(boost::edge_weight, *cg);
-			boost::graph_traits<ClusterGraph>::edge_iterator edgeIter, e_end;
+			RSGISEuclideanMST emst;
+			emst.calcDelaunayEdges(data);
+			std::cout << "Identifying the Minimum Spanning Tree\n";
+			emst.calcMinSpanTree();
 			
 			*threshold = lengththreshold;
 			
-			// Remove Edges
-			for (boost::tie(edgeIter, e_end) = edges(*cg); edgeIter != e_end; ++edgeIter)
-			{
-				if(boost::get(weight, *edgeIter) > lengththreshold)
-				{
-					boost::remove_edge(*edgeIter, *cg);
-				}
-			}
-			
-			// Find components (The clusters)
-            std::vector<int> component(boost::num_vertices(*cg));
-			int num_comp = boost::connected_components(*cg, boost::make_iterator_property_map(component.begin(), boost::get(boost::vertex_index, *cg)));
-			
-            std::list<RSGIS2DPoint*> **outputClusters = new std::list<RSGIS2DPoint*>*[num_comp];
-			for(int i = 0; i < num_comp; i++)
-			{
-				outputClusters[i] = new std::list<RSGIS2DPoint*>();
-			}
-			
-			if(data->size() != component.size())
-			{
-				throw rsgis::math::RSGISClustererException("Input data and number of graph elements different.");
-			}
-			
-			for(unsigned int i = 0; i < data->size(); i++)
-			{
-				outputClusters[component.at(i)]->push_back(data->at(i));
-			}
-			
-			delete tri;
+			// Find components (The clusters) of the edges not above the threshold
+			std::vector<unsigned int> component;
+			unsigned int num_comp = emst.calcComponents(lengththreshold, &component);
+			std::list<RSGIS2DPoint*> **outputClusters = RSGISEuclideanMST::createClusters(data, component, num_comp);
 			
 			*numclusters = num_comp;
 			return outputClusters;
@@ -93,114 +65,6 @@ namespace rsgis{namespace geom{
 		this->lengththreshold = lengththreshold;
 	}
 	
-	ClusterGraph* RSGISMinSpanTreeClustererEdgeLenThreshold::constructGraph(RSGISDelaunayTriangulation *tri, std::vector<RSGIS2DPoint*> *data)
-	{
-        std::vector<RSGIS2DPoint*>::iterator iterData;
-		int count = 0;
-		for(iterData = data->begin(); iterData != data->end(); iterData++)
-		{
-			(*iterData)->setIndex(count);
-			count++;
-		}
-		
-        std::list<RSGISTriangle*>* triangulation = tri->getTriangulation();
-        std::list<RSGISTriangle*>::iterator iterTri;
-		
-		// Create graph with vertex's
-		ClusterGraph *cg = new ClusterGraph(data->size());
-		
-		// Add edges
-		std::cout << "Adding Edges to Graph - may take some time ... ";
-		bool edge1Present = false;
-		bool edge2Present = false;
-		bool edge3Present = false;
-		boost::graph_traits<ClusterGraph>::vertex_descriptor u, v;
-		
-		RSGISTriangle *triangle = NULL;
-		ClusterGraph::edge_descriptor e1, e2, e3;
-		for(iterTri = triangulation->begin(); iterTri != triangulation->end(); iterTri++)
-		{
-			triangle = (*iterTri);
-			
-			// A - B (Edge 1)
-			u = boost::vertex(triangle->getPointA()->getIndex(), *cg);
-			v = boost::vertex(triangle->getPointB()->getIndex(), *cg);
-			tie(e1, edge1Present) = edge(u, v, *cg);
-			
-			// B - C (Edge 2)
-			u = boost::vertex(triangle->getPointB()->getIndex(), *cg);
-			v = boost::vertex(triangle->getPointC()->getIndex(), *cg);
-			boost::tie(e2, edge2Present) = edge(u, v, *cg);
-			
-			// A - B (Edge 1)
-			u = boost::vertex(triangle->getPointC()->getIndex(), *cg);
-			v = boost::vertex(triangle->getPointA()->getIndex(), *cg);
-			boost::tie(e3, edge3Present) = edge(u, v, *cg);
-			
-			
-			// Need to check whether edges are already present in the graph...
-			if(!edge1Present)
-			{
-				boost::add_edge(triangle->getPointA()->getIndex(), triangle->getPointB()->getIndex(), triangle->getPointA()->distance(triangle->getPointB()), *cg);
-			}
-			if(!edge2Present)
-			{
-				boost::add_edge(triangle->getPointB()->getIndex(), triangle->getPointC()->getIndex(), triangle->getPointB()->distance(triangle->getPointC()), *cg);
-			}
-			if(!edge3Present)
-			{
-				boost::add_edge(triangle->getPointC()->getIndex(), triangle->getPointA()->getIndex(), triangle->getPointC()->distance(triangle->getPointA()), *cg);
-			}
-			edge1Present = false;
-			edge2Present = false;
-			edge3Present = false;
-		}
-		std::cout << " Complete.\n";
-		return cg;
-	}
-	
-	void RSGISMinSpanTreeClustererEdgeLenThreshold::constructMinimumSpanningTree(ClusterGraph *cg)
-	{
-		std::cout << "Identifying the Minimum Spanning Tree\n";
-        std::vector<boost::graph_traits<ClusterGraph>::edge_descriptor> mst;
-		boost::kruskal_minimum_spanning_tree(*cg, back_inserter(mst));
-		
-		// Remove edges not within the spanning tree
-		std::cout << "Remove Edges not within the minimum spanning tree\n";
-		bool mstTreeEdge = false;
-        std::vector<boost::graph_traits<ClusterGraph>::edge_descriptor>::iterator iterMST;
-		boost::graph_traits<ClusterGraph>::edge_iterator edgeIter, e_end;
-		
-		int i = 0;
-		int feedback = num_edges(*cg)/10;
-		int feedbackCounter = 0;
-		
-		std::cout << "Started" << std::flush;		
-		for (boost::tie(edgeIter, e_end) = edges(*cg); edgeIter != e_end; ++edgeIter)
-		{
-			if((boost::num_edges(*cg) > 10) && ((i % feedback) == 0))
-			{
-				std::cout << ".." << feedbackCounter << ".." << std::flush;
-				feedbackCounter = feedbackCounter + 10;
-			}
-			
-			mstTreeEdge = false;
-			for(iterMST = mst.begin(); iterMST != mst.end(); iterMST++)
-			{
-				if(*iterMST == *edgeIter)
-				{
-					mstTreeEdge = true;
-				}
-			}
-			if(!mstTreeEdge)
-			{
-				remove_edge(*edgeIter, *cg);
-			}
-			i++;
-		}
-		std::cout << " Complete.\n";
-	}
-	
 	RSGISMinSpanTreeClustererEdgeLenThreshold::~RSGISMinSpanTreeClustererEdgeLenThreshold()
 	{
 		
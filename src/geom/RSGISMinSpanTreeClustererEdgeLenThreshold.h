@@ -29,18 +29,12 @@
 
 #include "geom/RSGIS2DPoint.h"
 #include "geom/RSGISSpatialClustererInterface.h"
-#include "geom/RSGISDelaunayTriangulation.h"
+#include "geom/RSGISEuclideanMST.h"
 
 #include "common/rsgis-tqdm.h"
 
 #include "math/RSGISClustererException.h"
 
-#include <boost/config.hpp>
-#include <boost/graph/adjacency_list.hpp>
-#include <boost/tuple/tuple.hpp>
-#include <boost/graph/kruskal_min_spanning_tree.hpp>
-#include <boost/graph/connected_components.hpp>
-
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
 #undef DllExport
@@ -58,9 +52,7 @@ namespace rsgis{namespace geom{
 	
 	/// Class that implments the abstract interface RSGISSpatialClustererInterface.
 	/// The clusterer calculates the minimum spanning tree from a delaunay triangulation 
-	/// and removes the edges above a length threshold.
-	
-	typedef boost::adjacency_list< boost::vecS, boost::vecS, boost::undirectedS, boost::property< boost::vertex_name_t, std::string >, boost::property< boost::edge_weight_t, float > > ClusterGraph;
+	/// (RSGISEuclideanMST) and removes the edges above a length threshold.
 	
 	class DllExport RSGISMinSpanTreeClustererEdgeLenThreshold : public RSGISSpatialClustererInterface
 		{
@@ -71,8 +63,6 @@ namespace rsgis{namespace geom{
 			virtual ~RSGISMinSpanTreeClustererEdgeLenThreshold();
 		protected:
 			float lengththreshold;
-			ClusterGraph* constructGraph(RSGISDelaunayTriangulation *tri, std::vector<RSGIS2DPoint*> *data);
-			void constructMinimumSpanningTree(ClusterGraph *cg);
 		};
 }}
 
@@ -33,26 +33,14 @@
 
 #include "geom/RSGIS2DPoint.h"
 #include "geom/RSGISSpatialClustererInterface.h"
-#include "geom/RSGISDelaunayTriangulation.h"
+#include "geom/RSGISEuclideanMST.h"
+#include "geom/RSGISGeomTestExport.h"
 
 #include "math/RSGISClustererException.h"
 
 #include "utils/RSGISExportData2HDF.h"
 
-#include <boost/config.hpp>
-#include <boost/graph/adjacency_list.hpp>
-#include <boost/tuple/tuple.hpp>
-#include <boost/graph/kruskal_min_spanning_tree.hpp>
-#include <boost/graph/connected_components.hpp>
-
-#include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
-#include <CGAL/Delaunay_triangulation_2.h>
-#include <CGAL/Interpolation_traits_2.h>
-#include <CGAL/natural_neighbor_coordinates_2.h>
-#include <CGAL/interpolation_functions.h>
-#include <CGAL/algorithm.h>
-#include <CGAL/Origin.h>
-#include <CGAL/squared_distance_2.h>
+#include "geos/geom/LineSegment.h"
 
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
@@ -68,24 +56,10 @@
 #endif
 
 namespace rsgis{namespace geom{
-
-    typedef CGAL::Exact_predicates_inexact_constructions_kernel K;
-    typedef K::FT                                         CGALCoordType;
-    typedef K::Vector_2                                   CGALVector;
-    typedef K::Point_2                                    CGALPoint;
-    
-    typedef CGAL::Delaunay_triangulation_2<K>             DelaunayTriangulation;
-    typedef CGAL::Interpolation_traits_2<K>               InterpTraits;
-    typedef CGAL::Delaunay_triangulation_2<K>::Vertex_handle    Vertex_handle;
-    
-    typedef std::vector< std::pair<CGALPoint, CGALCoordType> >   CoordinateVector;
-    typedef std::map<CGALPoint, CGALCoordType, K::Less_xy_2>     PointValueMap;
     
 	/// Class that implments the abstract interface RSGISSpatialClustererInterface.
 	/// The clusterer calculates the minimum spanning tree from a delaunay triangulation 
-	/// and removes the edges above a given number of standard deviations.
-	
-	typedef boost::adjacency_list< boost::vecS, boost::vecS, boost::undirectedS, boost::property< boost::vertex_name_t, std::string >, boost::property< boost::edge_weight_t, float > > ClusterGraph;
+	/// (RSGISEuclideanMST) and removes the edges above a given number of standard deviations.
 	
 	class DllExport RSGISMinSpanTreeClustererStdDevThreshold : public RSGISSpatialClustererInterface
 		{
@@ -96,8 +70,6 @@ namespace rsgis{namespace geom{
 		protected:
 			float stddevthreshold;
 			float maxEdgeLength;
-			ClusterGraph* constructGraph(RSGISDelaunayTriangulation *tri, std::vector<RSGIS2DPoint*> *data);
-			void constructMinimumSpanningTree(ClusterGraph *cg);
 		};
     
     
@@ -115,8 +87,6 @@ namespace rsgis{namespace geom{
         bool outShpEdges;
         std::string h5EdgeLengths;
         bool outH5EdgeLens;
-        ClusterGraph* constructGraph(DelaunayTriangulation *dt, PointValueMap *values, std::vector<RSGIS2DPoint*> *data);
-        void constructMinimumSpanningTree(ClusterGraph *cg);
     };
     
     
@@ -0,0 +1,171 @@
+/*
+ *  RSGISPreparedGeometryCache.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2010 RSGISLib. All rights reserved.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISPreparedGeometryCache.h"
+
+namespace rsgis{namespace geom{
+
+    RSGISPreparedGeometryCache::RSGISPreparedGeometryCache(size_t maxNumGeoms)
+    {
+        this->maxNumGeoms = maxNumGeoms;
+        this->useCounter = 0;
+    }
+
+    const geos::geom::prep::PreparedGeometry* RSGISPreparedGeometryCache::getPrepared(const geos::geom::Geometry *geom)
+    {
+        return this->getEntry(geom)->prepGeom;
+    }
+
+    bool RSGISPreparedGeometryCache::contains(const geos::geom::Geometry *geom, const geos::geom::Geometry *other)
+    {
+        try
+        {
+            return this->getEntry(geom)->prepGeom->contains(other);
+        }
+        catch(geos::util::TopologyException &e)
+        {
+            throw RSGISGeometryException(e.what());
+        }
+    }
+
+    bool RSGISPreparedGeometryCache::covers(const geos::geom::Geometry *geom, const geos::geom::Geometry *other)
+    {
+        try
+        {
+            return this->getEntry(geom)->prepGeom->covers(other);
+        }
+        catch(geos::util::TopologyException &e)
+        {
+            throw RSGISGeometryException(e.what());
+        }
+    }
+
+    bool RSGISPreparedGeometryCache::intersects(const geos::geom::Geometry *geom, const geos::geom::Geometry *other)
+    {
+        try
+        {
+            return this->getEntry(geom)->prepGeom->intersects(other);
+        }
+        catch(geos::util::TopologyException &e)
+        {
+            throw RSGISGeometryException(e.what());
+        }
+    }
+
+    double RSGISPreparedGeometryCache::distance(const geos::geom::Geometry *geom, const geos::geom::Geometry *other)
+    {
+        try
+        {
+            RSGISPrepGeomEntry *entry = this->getEntry(geom);
+            // The facet distance is between the boundaries, so is not 0 where
+            // one geometry is inside the other.
+            if(entry->prepGeom->intersects(other))
+            {
+                return 0;
+            }
+            if(entry->facetDist == NULL)
+            {
+                entry->facetDist = new geos::operation::distance::IndexedFacetDistance(geom);
+            }
+            return entry->facetDist->distance(other);
+        }
+        catch(geos::util::TopologyException &e)
+        {
+            throw RSGISGeometryException(e.what());
+        }
+    }
+
+    void RSGISPreparedGeometryCache::remove(const geos::geom::Geometry *geom)
+    {
+        std::unordered_map<const geos::geom::Geometry*, RSGISPrepGeomEntry>::iterator iterEntry = this->cache.find(geom);
+        if(iterEntry != this->cache.end())
+        {
+            this->destroyEntry(&iterEntry->second);
+            this->cache.erase(iterEntry);
+        }
+    }
+
+    void RSGISPreparedGeometryCache::clear()
+    {
+        for(std::unordered_map<const geos::geom::Geometry*, RSGISPrepGeomEntry>::iterator iterEntry = this->cache.begin(); iterEntry != this->cache.end(); ++iterEntry)
+        {
+            this->destroyEntry(&iterEntry->second);
+        }
+        this->cache.clear();
+    }
+
+    RSGISPreparedGeometryCache::RSGISPrepGeomEntry* RSGISPreparedGeometryCache::getEntry(const geos::geom::Geometry *geom)
+    {
+        if(geom == NULL)
+        {
+            throw RSGISGeometryException("Cannot prepare a NULL geometry.");
+        }
+        ++this->useCounter;
+        std::unordered_map<const geos::geom::Geometry*, RSGISPrepGeomEntry>::iterator iterEntry = this->cache.find(geom);
+        if(iterEntry != this->cache.end())
+        {
+            iterEntry->second.lastUse = this->useCounter;
+            return &iterEntry->second;
+        }
+
+        if((this->maxNumGeoms > 0) && (this->cache.size() >= this->maxNumGeoms))
+        {
+            std::unordered_map<const geos::geom::Geometry*, RSGISPrepGeomEntry>::iterator iterOldest = this->cache.begin();
+            for(iterEntry = this->cache.begin(); iterEntry != this->cache.end(); ++iterEntry)
+            {
+                if(iterEntry->second.lastUse < iterOldest->second.lastUse)
+                {
+                    iterOldest = iterEntry;
+                }
+            }
+            this->destroyEntry(&iterOldest->second);
+            this->cache.erase(iterOldest);
+        }
+
+        RSGISPrepGeomEntry entry;
+        entry.prepGeom = geos::geom::prep::PreparedGeometryFactory::prepare(geom);
+        entry.facetDist = NULL;
+        entry.lastUse = this->useCounter;
+        return &(this->cache[geom] = entry);
+    }
+
+    void RSGISPreparedGeometryCache::destroyEntry(RSGISPrepGeomEntry *entry)
+    {
+        if(entry->prepGeom != NULL)
+        {
+            geos::geom::prep::PreparedGeometryFactory::destroy(entry->prepGeom);
+            entry->prepGeom = NULL;
+        }
+        if(entry->facetDist != NULL)
+        {
+            delete entry->facetDist;
+            entry->facetDist = NULL;
+        }
+    }
+
+    RSGISPreparedGeometryCache::~RSGISPreparedGeometryCache()
+    {
+        this->clear();
+    }
+
+}}
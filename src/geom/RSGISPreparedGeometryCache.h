@@ -0,0 +1,105 @@
+/*
+ *  RSGISPreparedGeometryCache.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2010 RSGISLib. All rights reserved.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISPreparedGeometryCache_H
+#define RSGISPreparedGeometryCache_H
+
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+#include "geos/geom/Geometry.h"
+#include "geos/geom/prep/PreparedGeometry.h"
+#include "geos/geom/prep/PreparedGeometryFactory.h"
+#include "geos/operation/distance/IndexedFacetDistance.h"
+#include "geos/util/TopologyException.h"
+
+#include "geom/RSGISGeometryException.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_geom_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace geom{
+
+    /**
+     * A cache of prepared (indexed) versions of GEOS geometries, keyed on the
+     * geometry's address, for loops which test many geometries against the
+     * same geometry. The index of each geometry's segments is built on first
+     * use, so later contains/intersects/covers tests and distances against it
+     * do not visit every vertex.
+     *
+     * The geometries are not copied or owned: a geometry must be removed from
+     * the cache (or the cache cleared) before it is changed or deleted, as
+     * another geometry could later be given the same address. When
+     * maxNumGeoms is greater than 0 the least recently used geometry is
+     * dropped once it is reached.
+     *
+     * Queries build indexes on demand, so the cache is not thread safe.
+     */
+    class DllExport RSGISPreparedGeometryCache
+    {
+    public:
+        RSGISPreparedGeometryCache(size_t maxNumGeoms=0);
+        const geos::geom::prep::PreparedGeometry* getPrepared(const geos::geom::Geometry *geom);
+        /** Whether geom contains other. */
+        bool contains(const geos::geom::Geometry *geom, const geos::geom::Geometry *other);
+        /** Whether geom covers other. */
+        bool covers(const geos::geom::Geometry *geom, const geos::geom::Geometry *other);
+        /** Whether geom intersects other. */
+        bool intersects(const geos::geom::Geometry *geom, const geos::geom::Geometry *other);
+        /**
+         * The distance between geom and other, which (as Geometry::distance)
+         * is 0 where they intersect.
+         */
+        double distance(const geos::geom::Geometry *geom, const geos::geom::Geometry *other);
+        void remove(const geos::geom::Geometry *geom);
+        void clear();
+        size_t size() const {return cache.size();};
+        ~RSGISPreparedGeometryCache();
+    protected:
+        struct RSGISPrepGeomEntry
+        {
+            const geos::geom::prep::PreparedGeometry *prepGeom;
+            geos::operation::distance::IndexedFacetDistance *facetDist;
+            size_t lastUse;
+        };
+        RSGISPrepGeomEntry* getEntry(const geos::geom::Geometry *geom);
+        void destroyEntry(RSGISPrepGeomEntry *entry);
+        std::unordered_map<const geos::geom::Geometry*, RSGISPrepGeomEntry> cache;
+        size_t maxNumGeoms;
+        size_t useCounter;
+    };
+
+}}
+
+#endif
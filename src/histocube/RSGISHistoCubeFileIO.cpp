@@ -180,6 +180,18 @@ namespace rsgis {namespace histocube{
                         delete[] binVals;
                         layerMeta->bins = bins;
                         
+                        layerMeta->hasTransposed = false;
+                        layerMeta->transposedValid = false;
+                        if(H5Aexists(cubeLayerDataset.getId(), HC_CUBELAYER_TRANSPOSED_VALID.c_str()) > 0)
+                        {
+                            unsigned int transValid = 0;
+                            H5::Attribute transValidAttribute = cubeLayerDataset.openAttribute(HC_CUBELAYER_TRANSPOSED_VALID);
+                            transValidAttribute.read(H5::PredType::NATIVE_UINT, &transValid);
+                            transValidAttribute.close();
+                            layerMeta->hasTransposed = true;
+                            layerMeta->transposedValid = (transValid == 1);
+                        }
+                        
                         cubeLayers->push_back(layerMeta);
                         
                         cubeLayerDataset.close();
@@ -221,6 +233,15 @@ namespace rsgis {namespace histocube{
 
     }
     
+    void RSGISHistoCubeFile::openFile(std::string filePath, bool rwAccess, RSGISHistoCubeAccess access)
+    {
+        hsize_t rdccNElmts = HC_RDCC_NELMTS;
+        hsize_t rdccNBytes = HC_RDCC_NBYTES;
+        double rdccW0 = HC_RDCC_W0;
+        RSGISHistoCubeFile::getAccessCacheParams(access, &rdccNElmts, &rdccNBytes, &rdccW0);
+        this->openFile(filePath, rwAccess, HC_MDC_NELMTS, rdccNElmts, rdccNBytes, rdccW0);
+    }
+    
     void RSGISHistoCubeFile::createNewFile(std::string filePath, unsigned long numFeats, int mdcElmts, hsize_t rdccNElmts, hsize_t rdccNBytes, double rdccW0, hsize_t sieveBuf, hsize_t metaBlockSize)
     {
         try
@@ -287,7 +308,7 @@ namespace rsgis {namespace histocube{
         }
     }
     
-    void RSGISHistoCubeFile::createDataset(std::string name, std::vector<int> bins, float scale, float offset, bool hasDateTime, boost::posix_time::ptime *layerDateTime, unsigned int chunkSize, int deflate)
+    void RSGISHistoCubeFile::createDataset(std::string name, std::vector<int> bins, float scale, float offset, bool hasDateTime, boost::posix_time::ptime *layerDateTime, unsigned int chunkSize, int deflate, RSGISHistoCubeAccess access, bool createTransposed)
     {
         try
         {
@@ -332,6 +353,8 @@ namespace rsgis {namespace histocube{
             layerMeta->bins = bins;
             layerMeta->order = cubeLayers->size()+1;
             layerMeta->hasDateTime = hasDateTime;
+            layerMeta->hasTransposed = false;
+            layerMeta->transposedValid = false;
             
             if(!hasDateTime)
             {
@@ -345,13 +368,28 @@ namespace rsgis {namespace histocube{
             unsigned int numBins = bins.size();
             std::string datasetName = "/DATA/"+name;
             
+            // Choose the chunk shape from the access pattern.
+            hsize_t chunkBins = numBins;
             hsize_t fileChuckSize = chunkSize;
-            if(this->numOfFeats < chunkSize)
+            if(access == hcColumnAccess)
+            {
+                chunkBins = 1;
+                fileChuckSize = HC_CHUNK_NBYTES / sizeof(uint32_t);
+            }
+            else if(access == hcMixedAccess)
+            {
+                if(chunkBins > 16)
+                {
+                    chunkBins = 16;
+                }
+                fileChuckSize = HC_CHUNK_NBYTES / (sizeof(uint32_t) * chunkBins);
+            }
+            if(this->numOfFeats < fileChuckSize)
             {
                 fileChuckSize = this->numOfFeats;
             }
             
-            hsize_t dimsDataChunkSize[] = { fileChuckSize, numBins };
+            hsize_t dimsDataChunkSize[] = { fileChuckSize, chunkBins };
             H5::DSetCreatPropList initParamsCubeLayer;
             initParamsCubeLayer.setChunk(2, dimsDataChunkSize);
             initParamsCubeLayer.setShuffle();
@@ -410,6 +448,13 @@ namespace rsgis {namespace histocube{
             cubeLayerDataSpace.close();
             
             cubeLayers->push_back(layerMeta);
+            
+            if(createTransposed)
+            {
+                this->createTransposedDataset(name, numBins, deflate);
+                // Both copies are filled with zeros so start in sync.
+                this->setTransposedValid(name, true);
+            }
         }
         catch( H5::AttributeIException &e )
         {
@@ -451,7 +496,7 @@ namespace rsgis {namespace histocube{
         try
         {
             std::string cubeLayerName = HC_DATASETNAME_DATA + "/" + name;
-            H5::DataSet cubeLayerDataset = hcH5File->openDataSet( cubeLayerName );
+            H5::DataSet cubeLayerDataset = this->getLayerDataset( cubeLayerName );
             H5::DataSpace cubeLayerDataspace = cubeLayerDataset.getSpace();
             
             hsize_t *cubeLayerDIMS = new hsize_t[2];
@@ -495,7 +540,6 @@ namespace rsgis {namespace histocube{
             
             readCubeLayerDataspace.close();
             cubeLayerDataspace.close();
-            cubeLayerDataset.close();
         }
         catch( H5::AttributeIException &e )
         {
@@ -541,8 +585,10 @@ namespace rsgis {namespace histocube{
         
         try
         {
+            this->setTransposedValid(name, false);
+            
             std::string cubeLayerName = HC_DATASETNAME_DATA + "/" + name;
-            H5::DataSet cubeLayerDataset = hcH5File->openDataSet( cubeLayerName );
+            H5::DataSet cubeLayerDataset = this->getLayerDataset( cubeLayerName );
             H5::DataSpace cubeLayerDataspace = cubeLayerDataset.getSpace();
             
             hsize_t *cubeLayerDIMS = new hsize_t[2];
@@ -586,7 +632,6 @@ namespace rsgis {namespace histocube{
             
             writeCubeLayerDataspace.close();
             cubeLayerDataspace.close();
-            cubeLayerDataset.close();
         }
         catch( H5::AttributeIException &e )
         {
@@ -634,7 +679,7 @@ namespace rsgis {namespace histocube{
             unsigned int nRows = eRow - sRow;
             
             std::string cubeLayerName = HC_DATASETNAME_DATA + "/" + name;
-            H5::DataSet cubeLayerDataset = hcH5File->openDataSet( cubeLayerName );
+            H5::DataSet cubeLayerDataset = this->getLayerDataset( cubeLayerName );
             H5::DataSpace cubeLayerDataspace = cubeLayerDataset.getSpace();
             
             hsize_t *cubeLayerDIMS = new hsize_t[2];
@@ -645,7 +690,7 @@ namespace rsgis {namespace histocube{
                 throw rsgis::RSGISHistoCubeException("Cube Layer has the wrong dimensions.");
             }
             
-            if(eRow >= cubeLayerDIMS[0])
+            if(eRow > cubeLayerDIMS[0])
             {
                 std::cerr << "ROW = " << eRow << " Max. = " << cubeLayerDIMS[0] << std::endl;
                 throw rsgis::RSGISHistoCubeException("Row is not within the cube layer.");
@@ -678,7 +723,6 @@ namespace rsgis {namespace histocube{
             
             readCubeLayerDataspace.close();
             cubeLayerDataspace.close();
-            cubeLayerDataset.close();
         }
         catch( H5::AttributeIException &e )
         {
@@ -724,6 +768,8 @@ namespace rsgis {namespace histocube{
         
         try
         {
+            this->setTransposedValid(name, false);
+            
             if(sRow >= eRow)
             {
                 throw rsgis::RSGISHistoCubeException("The start row must be before the end row.");
@@ -731,7 +777,7 @@ namespace rsgis {namespace histocube{
             unsigned int nRows = eRow - sRow;
             
             std::string cubeLayerName = HC_DATASETNAME_DATA + "/" + name;
-            H5::DataSet cubeLayerDataset = hcH5File->openDataSet( cubeLayerName );
+            H5::DataSet cubeLayerDataset = this->getLayerDataset( cubeLayerName );
             H5::DataSpace cubeLayerDataspace = cubeLayerDataset.getSpace();
             
             hsize_t *cubeLayerDIMS = new hsize_t[2];
@@ -742,7 +788,7 @@ namespace rsgis {namespace histocube{
                 throw rsgis::RSGISHistoCubeException("Cube Layer has the wrong dimensions.");
             }
             
-            if(eRow >= cubeLayerDIMS[0])
+            if(eRow > cubeLayerDIMS[0])
             {
                 std::cerr << "ROW = " << eRow << " Max. = " << cubeLayerDIMS[0] << std::endl;
                 throw rsgis::RSGISHistoCubeException("Row is not within the cube layer.");
@@ -775,7 +821,6 @@ namespace rsgis {namespace histocube{
             
             writeCubeLayerDataspace.close();
             cubeLayerDataspace.close();
-            cubeLayerDataset.close();
         }
         catch( H5::AttributeIException &e )
         {
@@ -819,12 +864,305 @@ namespace rsgis {namespace histocube{
     
     void RSGISHistoCubeFile::closeFile()
     {
+        for(std::map<std::string, H5::DataSet>::iterator iterDS = this->layerDatasets.begin(); iterDS != this->layerDatasets.end(); ++iterDS)
+        {
+            iterDS->second.close();
+        }
+        this->layerDatasets.clear();
         this->hcH5File->close();
         delete this->hcH5File;
         this->hcH5File = NULL;
         this->fileOpen = false;
     }
     
+    void RSGISHistoCubeFile::getAccessCacheParams(RSGISHistoCubeAccess access, hsize_t *rdccNElmts, hsize_t *rdccNBytes, double *rdccW0)
+    {
+        if(access == hcRowAccess)
+        {
+            // A few row chunks, each of which is read once by a scan through the features.
+            *rdccNElmts = 1009;
+            *rdccNBytes = 16 * HC_CHUNK_NBYTES;
+            *rdccW0 = 1.0;
+        }
+        else if(access == hcColumnAccess)
+        {
+            // Every chunk down a column is revisited for the next bin so hold as many as possible.
+            *rdccNElmts = 12421;
+            *rdccNBytes = 256 * HC_CHUNK_NBYTES;
+            *rdccW0 = 0.75;
+        }
+        else
+        {
+            *rdccNElmts = 4001;
+            *rdccNBytes = 64 * HC_CHUNK_NBYTES;
+            *rdccW0 = 0.75;
+        }
+    }
+    
+    H5::DataSet RSGISHistoCubeFile::getLayerDataset(std::string datasetPath)
+    {
+        std::map<std::string, H5::DataSet>::iterator iterDS = this->layerDatasets.find(datasetPath);
+        if(iterDS != this->layerDatasets.end())
+        {
+            return iterDS->second;
+        }
+        H5::DataSet dataset = hcH5File->openDataSet( datasetPath );
+        this->layerDatasets[datasetPath] = dataset;
+        return dataset;
+    }
+    
+    RSGISHistCubeLayerMeta* RSGISHistoCubeFile::getLayerMeta(std::string name)
+    {
+        for(std::vector<RSGISHistCubeLayerMeta*>::iterator iterLayers = cubeLayers->begin(); iterLayers != cubeLayers->end(); ++iterLayers)
+        {
+            if((*iterLayers)->name == name)
+            {
+                return (*iterLayers);
+            }
+        }
+        return NULL;
+    }
+    
+    void RSGISHistoCubeFile::createTransposedDataset(std::string name, unsigned int numBins, int deflate)
+    {
+        if(H5Lexists(hcH5File->getId(), HC_DATASETNAME_TRANSPOSED.c_str(), H5P_DEFAULT) <= 0)
+        {
+            hcH5File->createGroup( HC_DATASETNAME_TRANSPOSED );
+        }
+        
+        hsize_t fileChuckSize = HC_CHUNK_NBYTES / sizeof(uint32_t);
+        if(this->numOfFeats < fileChuckSize)
+        {
+            fileChuckSize = this->numOfFeats;
+        }
+        hsize_t dimsDataChunkSize[] = { 1, fileChuckSize };
+        H5::DSetCreatPropList initParamsTransLayer;
+        initParamsTransLayer.setChunk(2, dimsDataChunkSize);
+        initParamsTransLayer.setShuffle();
+        initParamsTransLayer.setDeflate(deflate);
+        int initFillVal = 0;
+        initParamsTransLayer.setFillValue( H5::PredType::NATIVE_INT, &initFillVal);
+        
+        hsize_t dataLayerDims[] = { numBins, this->numOfFeats };
+        H5::DataSpace transLayerDataSpace(2, dataLayerDims);
+        H5::DataSet transLayerDataSet = hcH5File->createDataSet(HC_DATASETNAME_TRANSPOSED + "/" + name, H5::PredType::STD_U32LE, transLayerDataSpace, initParamsTransLayer);
+        transLayerDataSet.close();
+        transLayerDataSpace.close();
+        
+        RSGISHistCubeLayerMeta *layerMeta = this->getLayerMeta(name);
+        if(layerMeta != NULL)
+        {
+            layerMeta->hasTransposed = true;
+        }
+    }
+    
+    void RSGISHistoCubeFile::setTransposedValid(std::string name, bool valid)
+    {
+        RSGISHistCubeLayerMeta *layerMeta = this->getLayerMeta(name);
+        if((layerMeta == NULL) || (!layerMeta->hasTransposed) || (layerMeta->transposedValid == valid))
+        {
+            return;
+        }
+        
+        H5::DataSet cubeLayerDataset = this->getLayerDataset( HC_DATASETNAME_DATA + "/" + name );
+        H5::Attribute transValidAttribute;
+        if(H5Aexists(cubeLayerDataset.getId(), HC_CUBELAYER_TRANSPOSED_VALID.c_str()) > 0)
+        {
+            transValidAttribute = cubeLayerDataset.openAttribute(HC_CUBELAYER_TRANSPOSED_VALID);
+        }
+        else
+        {
+            H5::DataSpace attrScalarDataSpace = H5::DataSpace(H5S_SCALAR);
+            transValidAttribute = cubeLayerDataset.createAttribute(HC_CUBELAYER_TRANSPOSED_VALID, H5::PredType::STD_U8LE, attrScalarDataSpace);
+            attrScalarDataSpace.close();
+        }
+        unsigned int transValid = valid;
+        transValidAttribute.write(H5::PredType::NATIVE_UINT, &transValid);
+        transValidAttribute.close();
+        layerMeta->transposedValid = valid;
+    }
+    
+    void RSGISHistoCubeFile::getHistoBinColumn(std::string name, unsigned int binIdx, unsigned int sRow, unsigned int eRow, unsigned int *data, unsigned int dataLen)
+    {
+        if(!this->fileOpen)
+        {
+            throw rsgis::RSGISHistoCubeException("File was not open.");
+        }
+        
+        try
+        {
+            if(sRow >= eRow)
+            {
+                throw rsgis::RSGISHistoCubeException("The start row must be before the end row.");
+            }
+            unsigned int nRows = eRow - sRow;
+            if(dataLen < nRows)
+            {
+                throw rsgis::RSGISHistoCubeException("Data array is smaller than the number of rows requested.");
+            }
+            
+            RSGISHistCubeLayerMeta *layerMeta = this->getLayerMeta(name);
+            if(layerMeta == NULL)
+            {
+                throw rsgis::RSGISHistoCubeException("Layer was not found within the histogram cube.");
+            }
+            if(binIdx >= layerMeta->bins.size())
+            {
+                throw rsgis::RSGISHistoCubeException("Bin is not within the cube layer.");
+            }
+            if(eRow > this->numOfFeats)
+            {
+                throw rsgis::RSGISHistoCubeException("Row is not within the cube layer.");
+            }
+            
+            bool useTransposed = layerMeta->hasTransposed && layerMeta->transposedValid;
+            H5::DataSet cubeLayerDataset;
+            hsize_t cubeLayerOffset[2];
+            hsize_t dataInDims[2];
+            if(useTransposed)
+            {
+                cubeLayerDataset = this->getLayerDataset( HC_DATASETNAME_TRANSPOSED + "/" + name );
+                cubeLayerOffset[0] = binIdx;
+                cubeLayerOffset[1] = sRow;
+                dataInDims[0] = 1;
+                dataInDims[1] = nRows;
+            }
+            else
+            {
+                cubeLayerDataset = this->getLayerDataset( HC_DATASETNAME_DATA + "/" + name );
+                cubeLayerOffset[0] = sRow;
+                cubeLayerOffset[1] = binIdx;
+                dataInDims[0] = nRows;
+                dataInDims[1] = 1;
+            }
+            H5::DataSpace cubeLayerDataspace = cubeLayerDataset.getSpace();
+            cubeLayerDataspace.selectHyperslab(H5S_SELECT_SET, dataInDims, cubeLayerOffset);
+            
+            hsize_t dataDims[1];
+            dataDims[0] = nRows;
+            H5::DataSpace readCubeLayerDataspace = H5::DataSpace(1, dataDims);
+            
+            cubeLayerDataset.read(data, H5::PredType::NATIVE_UINT, readCubeLayerDataspace, cubeLayerDataspace);
+            
+            readCubeLayerDataspace.close();
+            cubeLayerDataspace.close();
+        }
+        catch( H5::Exception &e )
+        {
+            throw rsgis::RSGISHistoCubeException(e.getCDetailMsg());
+        }
+        catch ( rsgis::RSGISHistoCubeException &e)
+        {
+            throw e;
+        }
+        catch ( std::exception &e)
+        {
+            throw rsgis::RSGISHistoCubeException(e.what());
+        }
+    }
+    
+    void RSGISHistoCubeFile::updateTransposedLayer(std::string name, double maxMemMB)
+    {
+        if(!this->fileOpen)
+        {
+            throw rsgis::RSGISHistoCubeException("File was not open.");
+        }
+        
+        if(!this->rwAccess)
+        {
+            throw rsgis::RSGISHistoCubeException("HCF file was not opened in Read/Write mode.");
+        }
+        
+        try
+        {
+            RSGISHistCubeLayerMeta *layerMeta = this->getLayerMeta(name);
+            if(layerMeta == NULL)
+            {
+                throw rsgis::RSGISHistoCubeException("Layer was not found within the histogram cube.");
+            }
+            unsigned int numBins = layerMeta->bins.size();
+            
+            if(!layerMeta->hasTransposed)
+            {
+                this->createTransposedDataset(name, numBins, HC_DEFLATE);
+            }
+            
+            // Two buffers (row and transposed) of nRowsBlock x numBins.
+            double rowsInMem = (maxMemMB * 1024.0 * 1024.0) / (2.0 * sizeof(unsigned int) * numBins);
+            unsigned long nRowsBlock = 1;
+            if(rowsInMem > 1)
+            {
+                nRowsBlock = rowsInMem;
+            }
+            if(nRowsBlock > this->numOfFeats)
+            {
+                nRowsBlock = this->numOfFeats;
+            }
+            
+            unsigned int *rowData = new unsigned int[nRowsBlock * numBins];
+            unsigned int *transData = new unsigned int[nRowsBlock * numBins];
+            try
+            {
+                H5::DataSet transLayerDataset = this->getLayerDataset( HC_DATASETNAME_TRANSPOSED + "/" + name );
+                for(unsigned long sRow = 0; sRow < this->numOfFeats; sRow += nRowsBlock)
+                {
+                    unsigned long eRow = sRow + nRowsBlock;
+                    if(eRow > this->numOfFeats)
+                    {
+                        eRow = this->numOfFeats;
+                    }
+                    unsigned long nRows = eRow - sRow;
+                    this->getHistoRows(name, sRow, eRow, rowData, nRows * numBins);
+                    
+                    for(unsigned long r = 0; r < nRows; ++r)
+                    {
+                        for(unsigned int b = 0; b < numBins; ++b)
+                        {
+                            transData[(b * nRows) + r] = rowData[(r * numBins) + b];
+                        }
+                    }
+                    
+                    H5::DataSpace transLayerDataspace = transLayerDataset.getSpace();
+                    hsize_t transLayerOffset[2];
+                    transLayerOffset[0] = 0;
+                    transLayerOffset[1] = sRow;
+                    hsize_t dataOutDims[2];
+                    dataOutDims[0] = numBins;
+                    dataOutDims[1] = nRows;
+                    transLayerDataspace.selectHyperslab(H5S_SELECT_SET, dataOutDims, transLayerOffset);
+                    H5::DataSpace writeTransLayerDataspace = H5::DataSpace(2, dataOutDims);
+                    
+                    transLayerDataset.write(transData, H5::PredType::NATIVE_UINT, writeTransLayerDataspace, transLayerDataspace);
+                    
+                    writeTransLayerDataspace.close();
+                    transLayerDataspace.close();
+                }
+            }
+            catch(...)
+            {
+                delete[] rowData;
+                delete[] transData;
+                throw;
+            }
+            delete[] rowData;
+            delete[] transData;
+            
+            this->setTransposedValid(name, true);
+        }
+        catch( H5::Exception &e )
+        {
+            throw rsgis::RSGISHistoCubeException(e.getCDetailMsg());
+        }
+        catch ( rsgis::RSGISHistoCubeException &e)
+        {
+            throw e;
+        }
+        catch ( std::exception &e)
+        {
+            throw rsgis::RSGISHistoCubeException(e.what());
+        }
+    }
+    
     RSGISHistoCubeFile::~RSGISHistoCubeFile()
     {
         if(!cubeLayers->empty())
@@ -60,6 +60,7 @@
 #include <string>
 #include <iostream>
 #include <vector>
+#include <map>
 #include "common/RSGISHistoCubeException.h"
 
 #include "H5Cpp.h"
@@ -77,12 +78,14 @@ namespace rsgis {namespace histocube{
     static const hsize_t  HC_META_BLOCKSIZE( 2048 ); // 2048
     static const unsigned int HC_DEFLATE( 1 ); // 1
     static const unsigned int HC_COMPRESS_CHUNK( 1000 ); // 1000
+    static const hsize_t  HC_CHUNK_NBYTES( 1048576 ); // Target chunk size for column / mixed access layouts
     
     static const std::string HC_FILE_FILETYPE( "FILETYPE" );
     static const std::string HC_FILE_VERSION( "VERSION" );
     
     static const std::string HC_DATASETNAME_DATA( "/DATA" );
     static const std::string HC_DATASETNAME_METADATA( "/METADATA" );
+    static const std::string HC_DATASETNAME_TRANSPOSED( "/DATA_TRANSPOSED" );
     static const std::string HC_NUM_OF_FEATS( "/METADATA/NUM_OF_FEATS" );
     
     static const std::string HC_CUBELAYER_ORDER( "ORDER" );
@@ -92,6 +95,19 @@ namespace rsgis {namespace histocube{
     static const std::string HC_CUBELAYER_NUMBINS( "NUMBINS" );
     static const std::string HC_CUBELAYER_HAS_DATE_TIME( "HAS_DATE_TIME" );
     static const std::string HC_CUBELAYER_DATE_TIME( "DATE_TIME" );
+    static const std::string HC_CUBELAYER_TRANSPOSED_VALID( "TRANSPOSED_VALID" );
+    
+    /**
+     * How a histocube is going to be read / written. hcRowAccess reads whole
+     * feature histograms (population, export), hcColumnAccess reads a bin for a
+     * run of features (e.g., time-series) and hcMixedAccess does both.
+     */
+    enum RSGISHistoCubeAccess
+    {
+        hcRowAccess,
+        hcColumnAccess,
+        hcMixedAccess
+    };
     
     struct DllExport RSGISHistCubeLayerMeta
     {
@@ -102,6 +118,8 @@ namespace rsgis {namespace histocube{
         std::vector<int> bins;
         bool hasDateTime;
         boost::posix_time::ptime layerDateTime;
+        bool hasTransposed; // A [bins x features] copy of the layer is present
+        bool transposedValid; // The transposed copy matches the layer
     };
     
     class DllExport RSGISHistoCubeFile
@@ -109,22 +127,41 @@ namespace rsgis {namespace histocube{
     public:
         RSGISHistoCubeFile();
         virtual void openFile(std::string filePath, bool rwAccess, int mdcElmts=HC_MDC_NELMTS, hsize_t rdccNElmts=HC_RDCC_NELMTS, hsize_t rdccNBytes=HC_RDCC_NBYTES, double rdccW0=HC_RDCC_W0, hsize_t sieveBuf=HC_SIEVE_BUF, hsize_t metaBlockSize=HC_META_BLOCKSIZE);
+        /** Open a file with a chunk cache sized for the access pattern (see getAccessCacheParams). */
+        virtual void openFile(std::string filePath, bool rwAccess, RSGISHistoCubeAccess access);
         virtual void createNewFile(std::string filePath, unsigned long numFeats, int mdcElmts=HC_MDC_NELMTS, hsize_t rdccNElmts=HC_RDCC_NELMTS, hsize_t rdccNBytes=HC_RDCC_NBYTES, double rdccW0=HC_RDCC_W0, hsize_t sieveBuf=HC_SIEVE_BUF, hsize_t metaBlockSize=HC_META_BLOCKSIZE);
-        virtual void createDataset(std::string name, std::vector<int> bins, float scale=1, float offset=0, bool hasDateTime=false, boost::posix_time::ptime *layerDateTime=NULL, unsigned int chunkSize=HC_COMPRESS_CHUNK, int deflate=HC_DEFLATE);
+        /**
+         * Create a cube layer. For hcRowAccess chunks are chunkSize features by all the bins,
+         * for hcColumnAccess a single bin for HC_CHUNK_NBYTES worth of features and for
+         * hcMixedAccess up to 16 bins. If createTransposed is true a [bins x features]
+         * copy is also created so per-bin reads are contiguous (see getHistoBinColumn).
+         */
+        virtual void createDataset(std::string name, std::vector<int> bins, float scale=1, float offset=0, bool hasDateTime=false, boost::posix_time::ptime *layerDateTime=NULL, unsigned int chunkSize=HC_COMPRESS_CHUNK, int deflate=HC_DEFLATE, RSGISHistoCubeAccess access=hcRowAccess, bool createTransposed=false);
         virtual void getHistoRow(std::string name, unsigned int row, unsigned int *data, unsigned int dataLen);
         virtual void setHistoRow(std::string name, unsigned int row, unsigned int *data, unsigned int dataLen);
         virtual void getHistoRows(std::string name, unsigned int sRow, unsigned int eRow, unsigned int *data, unsigned int dataLen);
         virtual void setHistoRows(std::string name, unsigned int sRow, unsigned int eRow, unsigned int *data, unsigned int dataLen);
+        /** Read the counts for a single bin for features [sRow, eRow), from the transposed copy if it is up to date. */
+        virtual void getHistoBinColumn(std::string name, unsigned int binIdx, unsigned int sRow, unsigned int eRow, unsigned int *data, unsigned int dataLen);
+        /** (Re)build the transposed copy of a layer from the layer, reading up to maxMemMB of rows at a time. */
+        virtual void updateTransposedLayer(std::string name, double maxMemMB=256);
         virtual std::vector<RSGISHistCubeLayerMeta*>* getCubeLayersList();
         virtual unsigned long getNumFeatures();
         virtual void closeFile();
+        /** Chunk cache parameters which hold enough chunks for the access pattern. */
+        static void getAccessCacheParams(RSGISHistoCubeAccess access, hsize_t *rdccNElmts, hsize_t *rdccNBytes, double *rdccW0);
         virtual ~RSGISHistoCubeFile();
     protected:
+        H5::DataSet getLayerDataset(std::string datasetPath);
+        RSGISHistCubeLayerMeta* getLayerMeta(std::string name);
+        void createTransposedDataset(std::string name, unsigned int numBins, int deflate);
+        void setTransposedValid(std::string name, bool valid);
         bool fileOpen;
         bool rwAccess;
         H5::H5File *hcH5File;
         unsigned long numOfFeats;
         std::vector<RSGISHistCubeLayerMeta*> *cubeLayers;
+        std::map<std::string, H5::DataSet> layerDatasets; // Kept open so the chunk cache is reused between calls
     };
     
     
@@ -26,7 +26,7 @@
 namespace rsgis {namespace histocube{
     
     
-    RSGISPopHistoCubeLayerFromImgBand::RSGISPopHistoCubeLayerFromImgBand(RSGISHistoCubeFile *hcFile, std::string layerName, unsigned int bandIdx, unsigned int maxRow, float scale, float offset, std::vector<int> bins) : rsgis::img::RSGISCalcImageValue(0)
+    RSGISPopHistoCubeLayerFromImgBand::RSGISPopHistoCubeLayerFromImgBand(RSGISHistoCubeFile *hcFile, std::string layerName, unsigned int bandIdx, unsigned int maxRow, float scale, float offset, std::vector<int> bins, double maxBufferMB) : rsgis::img::RSGISCalcImageValue(0)
     {
         this->hcFile = hcFile;
         this->layerName = layerName;
@@ -36,8 +36,30 @@ namespace rsgis {namespace histocube{
         this->offset = offset;
         this->bins = bins;
         this->hcUtils = RSGISHistoCubeUtils();
-        this->dataArrLen = bins.size();
+        this->rowLen = bins.size();
+        
+        // Half of the buffer is used for the pending increments and half for the rows being updated.
+        double bufferBytes = (maxBufferMB * 1024.0 * 1024.0) / 2.0;
+        this->maxPending = bufferBytes / sizeof(unsigned long);
+        if(this->maxPending < 1)
+        {
+            this->maxPending = 1;
+        }
+        double maxWinRows = bufferBytes / (sizeof(unsigned int) * this->rowLen);
+        if(maxWinRows < 1)
+        {
+            maxWinRows = 1;
+        }
+        if(maxWinRows > (((double)maxRow) + 1))
+        {
+            maxWinRows = ((double)maxRow) + 1;
+        }
+        this->maxWindowRows = maxWinRows;
+        this->maxRowGap = 256;
+        
+        this->dataArrLen = ((unsigned long)this->maxWindowRows) * this->rowLen;
         this->dataArr = new unsigned int[this->dataArrLen];
+        this->pending.reserve(std::min<size_t>(this->maxPending, 1048576));
     }
     
     void RSGISPopHistoCubeLayerFromImgBand::calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) 
@@ -51,11 +73,13 @@ namespace rsgis {namespace histocube{
                 int bandValInt = floor(bandVal + 0.5);
                 long idx = this->hcUtils.getBinsIndex(bandValInt, this->bins);
                 
-                if((idx >= 0) | (idx < this->dataArrLen))
+                if((idx >= 0) & (idx < this->rowLen))
                 {
-                    this->hcFile->getHistoRow(this->layerName, row, this->dataArr, this->dataArrLen);
-                    this->dataArr[idx] = this->dataArr[idx] + 1;
-                    this->hcFile->setHistoRow(this->layerName, row, this->dataArr, this->dataArrLen);
+                    this->pending.push_back((((unsigned long)row) * this->rowLen) + idx);
+                    if(this->pending.size() >= this->maxPending)
+                    {
+                        this->flushHistoRows();
+                    }
                 }
             }
         }
@@ -63,6 +87,50 @@ namespace rsgis {namespace histocube{
         {
             throw e;
         }
+        catch(rsgis::RSGISHistoCubeException &e)
+        {
+            throw rsgis::img::RSGISImageCalcException(e.what());
+        }
+    }
+    
+    void RSGISPopHistoCubeLayerFromImgBand::flushHistoRows()
+    {
+        if(this->pending.empty())
+        {
+            return;
+        }
+        std::sort(this->pending.begin(), this->pending.end());
+        
+        size_t nPending = this->pending.size();
+        size_t i = 0;
+        while(i < nPending)
+        {
+            // Group the following increments into one run of rows [sRow, eRow).
+            unsigned long sRow = this->pending[i] / this->rowLen;
+            unsigned long eRow = sRow + 1;
+            size_t j = i;
+            while(j < nPending)
+            {
+                unsigned long row = this->pending[j] / this->rowLen;
+                if((row >= (sRow + this->maxWindowRows)) || (row > (eRow - 1 + this->maxRowGap)))
+                {
+                    break;
+                }
+                eRow = row + 1;
+                ++j;
+            }
+            
+            unsigned int dataLen = (eRow - sRow) * this->rowLen;
+            this->hcFile->getHistoRows(this->layerName, sRow, eRow, this->dataArr, dataLen);
+            unsigned long sIdx = sRow * this->rowLen;
+            for(size_t k = i; k < j; ++k)
+            {
+                this->dataArr[this->pending[k] - sIdx] = this->dataArr[this->pending[k] - sIdx] + 1;
+            }
+            this->hcFile->setHistoRows(this->layerName, sRow, eRow, this->dataArr, dataLen);
+            i = j;
+        }
+        this->pending.clear();
     }
     
     RSGISPopHistoCubeLayerFromImgBand::~RSGISPopHistoCubeLayerFromImgBand()
@@ -78,12 +146,12 @@ namespace rsgis {namespace histocube{
         this->rowLen = bins.size();
         if((this->dataArrLen % this->rowLen) != 0)
         {
-            rsgis::RSGISHistoCubeException("The data array did not a multiple of the number of bins.");
+            throw rsgis::RSGISHistoCubeException("The data array did not a multiple of the number of bins.");
         }
         
-        if((this->dataArrLen / this->rowLen) != maxRow)
+        if((this->dataArrLen / this->rowLen) != (((unsigned long)maxRow)+1))
         {
-            rsgis::RSGISHistoCubeException("The data array is not the same length as the number of rows.");
+            throw rsgis::RSGISHistoCubeException("The data array is not the same length as the number of rows.");
         }
         
         this->dataArr = dataArr;
@@ -107,7 +175,7 @@ namespace rsgis {namespace histocube{
                 int bandValInt = floor(bandVal + 0.5);
                 long binIdx = this->hcUtils.getBinsIndex(bandValInt, this->bins);
                 
-                if((binIdx >= 0) | (binIdx < this->rowLen))
+                if((binIdx >= 0) & (binIdx < this->rowLen))
                 {
                     if(row == 0)
                     {
@@ -133,6 +201,298 @@ namespace rsgis {namespace histocube{
     }
     
     
+    RSGISPopHistoCubeLayersFromImgBands::RSGISPopHistoCubeLayersFromImgBands(RSGISHistoCubeFile *hcFile)
+    {
+        this->hcFile = hcFile;
+        this->hcUtils = RSGISHistoCubeUtils();
+        this->numFeats = hcFile->getNumFeatures();
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+    
+    void RSGISPopHistoCubeLayersFromImgBands::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+    
+    void RSGISPopHistoCubeLayersFromImgBands::populateLayers(GDALDataset *clumpsDataset, std::vector<RSGISHistoCubeLayerImgBand> layers, double maxMemMB, unsigned int blockRows)
+    {
+        if(layers.empty())
+        {
+            return;
+        }
+        if(blockRows == 0)
+        {
+            blockRows = 1;
+        }
+        
+        int width = clumpsDataset->GetRasterXSize();
+        int height = clumpsDataset->GetRasterYSize();
+        
+        // Look up the layer definitions before any threads use the file.
+        std::vector<RSGISHistCubeLayerMeta*> *cubeLayers = this->hcFile->getCubeLayersList();
+        std::vector<LayerCounts> allLayers;
+        for(std::vector<RSGISHistoCubeLayerImgBand>::iterator iterLayer = layers.begin(); iterLayer != layers.end(); ++iterLayer)
+        {
+            RSGISHistCubeLayerMeta *cubeLayer = NULL;
+            for(std::vector<RSGISHistCubeLayerMeta*>::iterator iterMeta = cubeLayers->begin(); iterMeta != cubeLayers->end(); ++iterMeta)
+            {
+                if((*iterMeta)->name == (*iterLayer).layerName)
+                {
+                    cubeLayer = (*iterMeta);
+                    break;
+                }
+            }
+            if(cubeLayer == NULL)
+            {
+                throw rsgis::RSGISHistoCubeException("Layer '" + (*iterLayer).layerName + "' was not found within the histogram cube.");
+            }
+            if(((*iterLayer).valsDataset->GetRasterXSize() != width) || ((*iterLayer).valsDataset->GetRasterYSize() != height))
+            {
+                throw rsgis::RSGISHistoCubeException("The values image for layer '" + (*iterLayer).layerName + "' is not the same size as the clumps image.");
+            }
+            if(((int)(*iterLayer).bandIdx) >= (*iterLayer).valsDataset->GetRasterCount())
+            {
+                throw rsgis::RSGISHistoCubeException("The band specified for layer '" + (*iterLayer).layerName + "' is not within the values image.");
+            }
+            
+            LayerCounts layer;
+            layer.layerName = (*iterLayer).layerName;
+            layer.valsDataset = (*iterLayer).valsDataset;
+            layer.bandIdx = (*iterLayer).bandIdx;
+            layer.scale = cubeLayer->scale;
+            layer.offset = cubeLayer->offset;
+            layer.bins = cubeLayer->bins;
+            layer.consecutiveBins = true;
+            for(size_t b = 1; b < layer.bins.size(); ++b)
+            {
+                if(layer.bins.at(b) != (layer.bins.at(b-1) + 1))
+                {
+                    layer.consecutiveBins = false;
+                    break;
+                }
+            }
+            layer.counts = NULL;
+            allLayers.push_back(layer);
+        }
+        
+        // Split the layers into groups which fit within half the memory, the other half is for the group being written.
+        std::vector< std::vector<LayerCounts> > groups;
+        double groupMB = 0;
+        for(std::vector<LayerCounts>::iterator iterLayer = allLayers.begin(); iterLayer != allLayers.end(); ++iterLayer)
+        {
+            double layerMB = (((double)this->numFeats) * (*iterLayer).bins.size() * sizeof(unsigned int)) / (1024.0 * 1024.0);
+            if(groups.empty() || ((groupMB + layerMB) > (maxMemMB / 2.0)))
+            {
+                groups.push_back(std::vector<LayerCounts>());
+                groupMB = 0;
+            }
+            groups.back().push_back(*iterLayer);
+            groupMB += layerMB;
+        }
+        
+        GDALRasterBand *clumpsBand = clumpsDataset->GetRasterBand(1);
+        unsigned int *clumpsBlock = (unsigned int *) CPLMalloc(sizeof(unsigned int)*width*blockRows);
+        
+        std::thread writer;
+        std::exception_ptr writerError = nullptr;
+        
+        try
+        {
+            for(std::vector< std::vector<LayerCounts> >::iterator iterGroup = groups.begin(); iterGroup != groups.end(); ++iterGroup)
+            {
+                std::vector<LayerCounts> *group = &(*iterGroup);
+                for(std::vector<LayerCounts>::iterator iterLayer = group->begin(); iterLayer != group->end(); ++iterLayer)
+                {
+                    (*iterLayer).counts = new unsigned int[this->numFeats * (*iterLayer).bins.size()]();
+                }
+                
+                // Each value image is read by one worker at a time as GDAL datasets are not thread safe.
+                std::vector<GDALDataset*> imgs;
+                std::vector< std::vector<LayerCounts*> > imgLayers;
+                for(std::vector<LayerCounts>::iterator iterLayer = group->begin(); iterLayer != group->end(); ++iterLayer)
+                {
+                    size_t imgIdx = std::find(imgs.begin(), imgs.end(), (*iterLayer).valsDataset) - imgs.begin();
+                    if(imgIdx == imgs.size())
+                    {
+                        imgs.push_back((*iterLayer).valsDataset);
+                        imgLayers.push_back(std::vector<LayerCounts*>());
+                    }
+                    imgLayers.at(imgIdx).push_back(&(*iterLayer));
+                }
+                rsgis::utils::RSGISWorkerPool pool(std::max<size_t>(std::min<size_t>(this->numThreads, imgs.size()), 1));
+                std::vector<float*> valsBlocks;
+                for(unsigned int t = 0; t < pool.getNumThreads(); ++t)
+                {
+                    valsBlocks.push_back((float *) CPLMalloc(sizeof(float)*width*blockRows));
+                }
+                
+                try
+                {
+                    for(int rowOffset = 0; rowOffset < height; rowOffset += blockRows)
+                    {
+                        int nRows = std::min<int>(blockRows, height - rowOffset);
+                        size_t nPxls = ((size_t)width) * nRows;
+                        if(clumpsBand->RasterIO(GF_Read, 0, rowOffset, width, nRows, clumpsBlock, width, nRows, GDT_UInt32, 0, 0) != CE_None)
+                        {
+                            throw rsgis::RSGISHistoCubeException("Could not read the clumps image.");
+                        }
+                        
+                        pool.parallelFor(imgs.size(), [&](size_t imgIdx, unsigned int t)
+                        {
+                            for(std::vector<LayerCounts*>::iterator iterLayer = imgLayers.at(imgIdx).begin(); iterLayer != imgLayers.at(imgIdx).end(); ++iterLayer)
+                            {
+                                GDALRasterBand *valsBand = imgs.at(imgIdx)->GetRasterBand((*iterLayer)->bandIdx+1);
+                                if(valsBand->RasterIO(GF_Read, 0, rowOffset, width, nRows, valsBlocks.at(t), width, nRows, GDT_Float32, 0, 0) != CE_None)
+                                {
+                                    throw rsgis::RSGISHistoCubeException("Could not read the values image for layer '" + (*iterLayer)->layerName + "'.");
+                                }
+                                this->countBlock(*iterLayer, clumpsBlock, valsBlocks.at(t), nPxls);
+                            }
+                        });
+                    }
+                }
+                catch(...)
+                {
+                    for(std::vector<float*>::iterator iterBlock = valsBlocks.begin(); iterBlock != valsBlocks.end(); ++iterBlock)
+                    {
+                        CPLFree(*iterBlock);
+                    }
+                    throw;
+                }
+                for(std::vector<float*>::iterator iterBlock = valsBlocks.begin(); iterBlock != valsBlocks.end(); ++iterBlock)
+                {
+                    CPLFree(*iterBlock);
+                }
+                
+                // Wait for the previous group to be written then hand this one to the writer.
+                if(writer.joinable())
+                {
+                    writer.join();
+                    if(writerError)
+                    {
+                        std::rethrow_exception(writerError);
+                    }
+                }
+                writer = std::thread([this, group, &writerError]()
+                {
+                    try
+                    {
+                        this->addCountsToFile(group);
+                    }
+                    catch(...)
+                    {
+                        writerError = std::current_exception();
+                    }
+                });
+            }
+            if(writer.joinable())
+            {
+                writer.join();
+            }
+        }
+        catch(...)
+        {
+            if(writer.joinable())
+            {
+                writer.join();
+            }
+            CPLFree(clumpsBlock);
+            for(std::vector< std::vector<LayerCounts> >::iterator iterGroup = groups.begin(); iterGroup != groups.end(); ++iterGroup)
+            {
+                for(std::vector<LayerCounts>::iterator iterLayer = (*iterGroup).begin(); iterLayer != (*iterGroup).end(); ++iterLayer)
+                {
+                    delete[] (*iterLayer).counts;
+                    (*iterLayer).counts = NULL;
+                }
+            }
+            throw;
+        }
+        CPLFree(clumpsBlock);
+        
+        if(writerError)
+        {
+            std::rethrow_exception(writerError);
+        }
+    }
+    
+    void RSGISPopHistoCubeLayersFromImgBands::countBlock(LayerCounts *layer, unsigned int *clumps, float *vals, size_t nPxls)
+    {
+        size_t nBins = layer->bins.size();
+        int firstBin = layer->bins.at(0);
+        for(size_t i = 0; i < nPxls; ++i)
+        {
+            if((clumps[i] >= this->numFeats) || std::isnan(vals[i]))
+            {
+                continue;
+            }
+            float bandVal = (vals[i] * layer->scale) + layer->offset;
+            int bandValInt = floor(bandVal + 0.5);
+            long binIdx = -1;
+            if(layer->consecutiveBins)
+            {
+                if((bandValInt >= firstBin) && (((long)bandValInt - firstBin) < ((long)nBins)))
+                {
+                    binIdx = bandValInt - firstBin;
+                }
+            }
+            else
+            {
+                binIdx = this->hcUtils.getBinsIndex(bandValInt, layer->bins);
+            }
+            if(binIdx >= 0)
+            {
+                ++layer->counts[(((size_t)clumps[i]) * nBins) + binIdx];
+            }
+        }
+    }
+    
+    void RSGISPopHistoCubeLayersFromImgBands::addCountsToFile(std::vector<LayerCounts> *group)
+    {
+        for(std::vector<LayerCounts>::iterator iterLayer = group->begin(); iterLayer != group->end(); ++iterLayer)
+        {
+            // Add the counts to those already in the file, reading / writing up to 64 MB of rows at a time.
+            size_t nBins = (*iterLayer).bins.size();
+            unsigned long nRowsBlock = (64 * 1024 * 1024) / (sizeof(unsigned int) * nBins);
+            if(nRowsBlock < 1)
+            {
+                nRowsBlock = 1;
+            }
+            if(nRowsBlock > this->numFeats)
+            {
+                nRowsBlock = this->numFeats;
+            }
+            unsigned int *fileRows = new unsigned int[nRowsBlock * nBins];
+            try
+            {
+                for(unsigned long sRow = 0; sRow < this->numFeats; sRow += nRowsBlock)
+                {
+                    unsigned long eRow = std::min(sRow + nRowsBlock, this->numFeats);
+                    unsigned int dataLen = (eRow - sRow) * nBins;
+                    this->hcFile->getHistoRows((*iterLayer).layerName, sRow, eRow, fileRows, dataLen);
+                    unsigned int *layerRows = (*iterLayer).counts + (sRow * nBins);
+                    for(unsigned int i = 0; i < dataLen; ++i)
+                    {
+                        fileRows[i] += layerRows[i];
+                    }
+                    this->hcFile->setHistoRows((*iterLayer).layerName, sRow, eRow, fileRows, dataLen);
+                }
+            }
+            catch(...)
+            {
+                delete[] fileRows;
+                throw;
+            }
+            delete[] fileRows;
+            delete[] (*iterLayer).counts;
+            (*iterLayer).counts = NULL;
+        }
+    }
+    
+    RSGISPopHistoCubeLayersFromImgBands::~RSGISPopHistoCubeLayersFromImgBands()
+    {
+        
+    }
+    
 }}
 
 
@@ -42,9 +42,16 @@
 #include <string>
 #include <iostream>
 #include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <cmath>
 #include <math.h>
 
 #include "common/RSGISHistoCubeException.h"
+#include "common/RSGISParallel.h"
 
 #include "img/RSGISCalcImage.h"
 #include "img/RSGISCalcImageValue.h"
@@ -55,10 +62,18 @@
 namespace rsgis {namespace histocube{
     
     
+    /**
+     * Populates a histocube layer which is too large to be held in memory. Bin
+     * increments are buffered as sorted (row, bin) indexes and applied with one
+     * getHistoRows / setHistoRows per run of nearby rows, rather than reading and
+     * writing a histogram row for every pixel. The buffer is flushed when it
+     * reaches maxBufferMB and by flushHistoRows, which must be called once the
+     * image has been processed.
+     */
     class DllExport RSGISPopHistoCubeLayerFromImgBand : public rsgis::img::RSGISCalcImageValue
     {
     public:
-        RSGISPopHistoCubeLayerFromImgBand(RSGISHistoCubeFile *hcFile, std::string layerName, unsigned int bandIdx, unsigned int maxRow, float scale, float offset, std::vector<int> bins);
+        RSGISPopHistoCubeLayerFromImgBand(RSGISHistoCubeFile *hcFile, std::string layerName, unsigned int bandIdx, unsigned int maxRow, float scale, float offset, std::vector<int> bins, double maxBufferMB=256);
         void calcImageValue(float *bandValues, int numBands, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(float *bandValues, int numBands) {throw rsgis::img::RSGISImageCalcException("No implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals);
@@ -69,6 +84,8 @@ namespace rsgis {namespace histocube{
         void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) {throw rsgis::img::RSGISImageCalcException("No implemented");};
         void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output, geos::geom::Envelope extent) {throw rsgis::img::RSGISImageCalcException("No implemented");};
         bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw rsgis::img::RSGISImageCalcException("No implemented");};
+        /** Apply all the buffered increments to the histocube file. */
+        void flushHistoRows();
         ~RSGISPopHistoCubeLayerFromImgBand();
     protected:
         RSGISHistoCubeFile *hcFile;
@@ -80,7 +97,12 @@ namespace rsgis {namespace histocube{
         std::vector<int> bins;
         RSGISHistoCubeUtils hcUtils;
         unsigned int *dataArr;
-        unsigned int dataArrLen;
+        unsigned long dataArrLen;
+        unsigned int rowLen;
+        unsigned int maxWindowRows; // Max. number of rows read / written at once
+        unsigned int maxRowGap; // Max. gap between rows within a single read / write
+        size_t maxPending;
+        std::vector<unsigned long> pending; // row * rowLen + bin for each increment
     };
     
     class DllExport RSGISPopHistoCubeLayerFromImgBandInMem : public rsgis::img::RSGISCalcImageValue
@@ -111,6 +133,51 @@ namespace rsgis {namespace histocube{
         unsigned int rowLen;
     };
     
+    /** A cube layer to be populated from an image band (bandIdx starts at 0). */
+    struct DllExport RSGISHistoCubeLayerImgBand
+    {
+        std::string layerName;
+        GDALDataset *valsDataset;
+        unsigned int bandIdx;
+    };
+    
+    /**
+     * Populates several cube layers (e.g., the dates of a time series) in a single
+     * pass through the clumps image. Each block of clumps is read once and the value
+     * images for the block are read and binned in parallel, one image per worker
+     * thread. The layers are counted in memory, in groups which fit within half of
+     * maxMemMB, and each finished group is added to the file by one writer thread
+     * while the next group is counted. All the images must be the same size as the
+     * clumps image.
+     */
+    class DllExport RSGISPopHistoCubeLayersFromImgBands
+    {
+    public:
+        RSGISPopHistoCubeLayersFromImgBands(RSGISHistoCubeFile *hcFile);
+        void populateLayers(GDALDataset *clumpsDataset, std::vector<RSGISHistoCubeLayerImgBand> layers, double maxMemMB=1024, unsigned int blockRows=256);
+        /** Set the number of worker threads (0 uses all the available cores). */
+        void setNumThreads(unsigned int numThreads);
+        ~RSGISPopHistoCubeLayersFromImgBands();
+    protected:
+        struct LayerCounts
+        {
+            std::string layerName;
+            GDALDataset *valsDataset;
+            unsigned int bandIdx;
+            float scale;
+            float offset;
+            std::vector<int> bins;
+            bool consecutiveBins;
+            unsigned int *counts;
+        };
+        void countBlock(LayerCounts *layer, unsigned int *clumps, float *vals, size_t nPxls);
+        void addCountsToFile(std::vector<LayerCounts> *group);
+        RSGISHistoCubeFile *hcFile;
+        RSGISHistoCubeUtils hcUtils;
+        unsigned long numFeats;
+        unsigned int numThreads;
+    };
+    
 }}
 
 #endif
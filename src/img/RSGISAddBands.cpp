@@ -117,6 +117,7 @@ namespace rsgis{namespace img{
         
         // Create new file. 
         GDALDataset *outputImage = NULL;
+        RSGISDatasetCache::invalidate(*outputFile);
         outputImage = poDriver->Create(outputFile->c_str(), inputXSize, inputYSize, numBands, GDT_Float32, papszOptions);
         outputImage->SetGeoTransform(inputTrans);
         outputImage->SetProjection(input->GetProjectionRef());
@@ -275,6 +276,7 @@ namespace rsgis{namespace img{
         char **papszOptions = imgUtils.getGDALCreationOptionsForFormat("ENVI");
         
         // Create new file. 
+        RSGISDatasetCache::invalidate(*outputFile);
         outputImage = poDriver->Create(outputFile->c_str(), inputXSize, inputYSize, numBands, GDT_Float32, papszOptions);
         outputImage->SetGeoTransform(inputTrans);
         outputImage->SetProjection(input->GetProjectionRef());
@@ -373,6 +375,7 @@ namespace rsgis{namespace img{
             char **papszOptions = imgUtils.getGDALCreationOptionsForFormat(gdalFormat);
 			std::cout << "New image width = " << width << " height = " << height << " bands = " << numInBands << std::endl;
 			
+			RSGISDatasetCache::invalidate(outputImage);
 			outputImageDS = gdalDriver->Create(outputImage.c_str(), width, height, numInBands, gdalDataType, papszOptions);
 			
 			if(outputImageDS == NULL)
@@ -24,27 +24,86 @@
 
 namespace rsgis{namespace img{
 
-	RSGISApplyEigenvectors::RSGISApplyEigenvectors(int numberOutBands, rsgis::math::Matrix *eigenvectors) : RSGISCalcImageValue(numberOutBands)
+    const size_t RSGISApplyEigenvectors::pxlChunkSize = 4096;
+
+	RSGISApplyEigenvectors::RSGISApplyEigenvectors(int numberOutBands, rsgis::math::Matrix *eigenvectors, std::vector<double> means) : RSGISCalcImageValue(numberOutBands)
 	{
 		this->eigenvectors = eigenvectors;
+		if(this->numOutBands > this->eigenvectors->n)
+		{
+			throw RSGISImageCalcException("There are no enough eigenvectors for the number of output bands");
+		}
+		if((!means.empty()) && (means.size() != ((size_t)eigenvectors->m)))
+		{
+			throw RSGISImageCalcException("The number of means is not the same as the length of the eigenvectors.");
+		}
+		this->means = means;
+		this->components = gsl_matrix_alloc(this->numOutBands, eigenvectors->m);
+		for(int i = 0; i < this->numOutBands; i++)
+		{
+			for(int j = 0; j < eigenvectors->m; j++)
+			{
+				gsl_matrix_set(this->components, i, j, eigenvectors->matrix[(i*eigenvectors->m)+j]);
+			}
+		}
 	}
 	
 	void RSGISApplyEigenvectors::calcImageValue(float *bandValues, int numBands, double *output) 
 	{
-		if(this->numOutBands > this->eigenvectors->n)
+		if(numBands != eigenvectors->m)
 		{
-			RSGISImageCalcException("There are no enough eigenvectors for the number of output bands");
+			throw RSGISImageCalcException("The number of image bands is not the same as the length of the eigenvectors.");
 		}
 		
-		int eigenIndex = 0;
 		for(int i = 0; i < this->numOutBands; i++)
 		{
+			const double *component = gsl_matrix_const_ptr(this->components, i, 0);
 			output[i] = 0;
+			for(int j = 0; j < numBands; j++)
+			{
+				double val = this->means.empty()?bandValues[j]:(bandValues[j] - this->means[j]);
+				output[i] += (val * component[j]);
+			}
+		}
+	}
+	
+	void RSGISApplyEigenvectors::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+	{
+		if(numBands != eigenvectors->m)
+		{
+			throw RSGISImageCalcException("The number of image bands is not the same as the length of the eigenvectors.");
+		}
+		
+		rsgis::RSGISScratchScope scratch(this->getScratchArena());
+		size_t chunkSize = std::min(nPxls, pxlChunkSize);
+		double *bandVals = scratch.alloc<double>(numBands * chunkSize);
+		double *compVals = scratch.alloc<double>(this->numOutBands * chunkSize);
+		
+		for(size_t start = 0; start < nPxls; start += chunkSize)
+		{
+			size_t nChunk = std::min(chunkSize, nPxls - start);
+			for(int j = 0; j < numBands; j++)
+			{
+				const float *inPlane = bandPlanes[j] + start;
+				double *bandRow = bandVals + (j * nChunk);
+				double mean = this->means.empty()?0:this->means[j];
+				for(size_t p = 0; p < nChunk; p++)
+				{
+					bandRow[p] = inPlane[p] - mean;
+				}
+			}
 			
-			for(int j = 0; j < eigenvectors->m; j++)
+			gsl_matrix_view bandMat = gsl_matrix_view_array(bandVals, numBands, nChunk);
+			gsl_matrix_view compMat = gsl_matrix_view_array(compVals, this->numOutBands, nChunk);
+			int status = gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, this->components, &bandMat.matrix, 0.0, &compMat.matrix);
+			if(status != 0)
 			{
-				eigenIndex = (i*eigenvectors->m)+j;
-				output[i] += (bandValues[j] * eigenvectors->matrix[eigenIndex]);
+				throw RSGISImageCalcException(gsl_strerror(status));
+			}
+			
+			for(int i = 0; i < this->numOutBands; i++)
+			{
+				std::copy(compVals + (i * nChunk), compVals + ((i+1) * nChunk), outPlanes[i] + start);
 			}
 		}
 	}
@@ -76,7 +135,7 @@ namespace rsgis{namespace img{
 
 	RSGISApplyEigenvectors::~RSGISApplyEigenvectors()
 	{
-		
+		gsl_matrix_free(this->components);
 	}
 
 }}
@@ -24,6 +24,8 @@
 #define RSGISApplyEigenvectors_H
 
 #include <iostream>
+#include <vector>
+#include <algorithm>
 
 #include "img/RSGISImageCalcException.h"
 #include "img/RSGISCalcImageValue.h"
@@ -32,6 +34,10 @@
 
 #include <geos/geom/Envelope.h>
 
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_errno.h>
+
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
 #undef DllExport
@@ -49,11 +55,19 @@ namespace rsgis
 {
 	namespace img
 	{
+        /**
+         * Projects the pixels onto the first numberOutBands eigenvectors (the
+         * rows of the matrix), optionally after subtracting the band means.
+         * Blocks are projected as a matrix multiplication (components x bands)
+         * .(bands x pixels) and can be processed by several threads.
+         */
 		class DllExport RSGISApplyEigenvectors : public RSGISCalcImageValue
 			{
 			public: 
-				RSGISApplyEigenvectors(int numberOutBands, rsgis::math::Matrix *eigenvectors);
+				RSGISApplyEigenvectors(int numberOutBands, rsgis::math::Matrix *eigenvectors, std::vector<double> means=std::vector<double>());
 				void calcImageValue(float *bandValues, int numBands, double *output);
+                void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+                bool isThreadSafe(){return true;};
 				void calcImageValue(float *bandValues, int numBands);
                 void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw RSGISImageCalcException("Not implemented");};
                 void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw RSGISImageCalcException("Not implemented");};
@@ -65,7 +79,11 @@ namespace rsgis
 				bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output);
 				~RSGISApplyEigenvectors();
 			protected:
+                static const size_t pxlChunkSize;
                 rsgis::math::Matrix *eigenvectors;
+                // The first numOutBands eigenvectors (numOutBands x bands).
+                gsl_matrix *components;
+                std::vector<double> means;
 			};
 	}
 }
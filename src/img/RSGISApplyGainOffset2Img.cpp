@@ -52,6 +52,27 @@ namespace rsgis{namespace img{
         }
     }
     
+    void RSGISRescaleImageData::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        const float inNoData = this->cNoDataVal;
+        const double outNoData = this->nNoDataVal;
+        const float inOffset = this->cOffset;
+        const float inGain = this->cGain;
+        const float outOffset = this->nOffset;
+        const float outGain = this->nGain;
+        for(int i = 0; i < numBands; ++i)
+        {
+            const float *inPlane = bandPlanes[i];
+            double *outPlane = outPlanes[i];
+            for(size_t j = 0; j < nPxls; ++j)
+            {
+                // Branch free so the loop can be vectorised.
+                const double val = (((inPlane[j]-inOffset)/inGain) * outGain) + outOffset;
+                outPlane[j] = (inPlane[j] == inNoData)?outNoData:val;
+            }
+        }
+    }
+    
     RSGISRescaleImageData::~RSGISRescaleImageData()
     {
         
@@ -56,6 +56,7 @@ namespace rsgis{namespace img{
     public:
         RSGISRescaleImageData(int numOutputBands, float cNoDataVal, float cOffset, float cGain, float nNoDataVal, float nOffset, float nGain);
         void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
         void calcImageValue(float *bandValues, int numBands) {throw RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw RSGISImageCalcException("Not implemented");};
@@ -65,6 +66,7 @@ namespace rsgis{namespace img{
         void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageCalcException("Not implemented");};
         void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output, geos::geom::Envelope extent) {throw RSGISImageCalcException("No implemented");};
         bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageCalcException("Not implemented");};
+        bool isThreadSafe(){return true;};
         ~RSGISRescaleImageData();
     protected:
         float cNoDataVal;
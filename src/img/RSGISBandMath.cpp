@@ -30,7 +30,15 @@ namespace rsgis{namespace img{
 		this->numVariables = numVariables;
 		
 		this->muParser = muParser;
+        this->ownParser = false;
 		this->inVals = new mu::value_type[numVariables];
+        this->bulkVals = new mu::value_type*[numVariables];
+        for(int i = 0; i < numVariables; ++i)
+        {
+            this->bulkVals[i] = NULL;
+        }
+        this->numBulkPxls = 0;
+        this->bulkVarsDefined = false;
 		for(int i = 0; i < numVariables; ++i)
 		{
 			muParser->DefineVar(_T(variables[i]->name.c_str()), &inVals[i]);
@@ -47,6 +55,10 @@ namespace rsgis{namespace img{
 		
 		try 
 		{
+            if(this->bulkVarsDefined)
+            {
+                this->defineParserVars(false);
+            }
 			for(int i = 0; i < numVariables; ++i)
 			{
 				inVals[i] = bandValues[variables[i]->band];
@@ -62,10 +74,113 @@ namespace rsgis{namespace img{
 			throw RSGISImageCalcException(message);
 		}
 	}
+    
+    void RSGISBandMath::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        if(numOutBands != 1)
+        {
+            throw RSGISImageCalcException("Incorrect number of output Image bands (should be equal to 1).");
+        }
+        
+        try
+        {
+            if(nPxls > this->numBulkPxls)
+            {
+                for(int i = 0; i < numVariables; ++i)
+                {
+                    if(this->bulkVals[i] != NULL)
+                    {
+                        delete[] this->bulkVals[i];
+                    }
+                    this->bulkVals[i] = new mu::value_type[nPxls];
+                }
+                this->numBulkPxls = nPxls;
+                this->bulkVarsDefined = false;
+            }
+            if(!this->bulkVarsDefined)
+            {
+                this->defineParserVars(true);
+            }
+            
+            for(int i = 0; i < numVariables; ++i)
+            {
+                const float *inPlane = bandPlanes[variables[i]->band];
+                mu::value_type *varVals = this->bulkVals[i];
+                for(size_t j = 0; j < nPxls; ++j)
+                {
+                    varVals[j] = inPlane[j];
+                }
+            }
+            
+            // muparser bulk mode evaluates the compiled bytecode over the whole block.
+            muParser->Eval(outPlanes[0], (int)nPxls);
+        }
+        catch (mu::ParserError &e)
+        {
+            std::string message = std::string("ERROR: ") + std::string(e.GetMsg()) + std::string(":\t \'") + std::string(e.GetExpr()) + std::string("\'");
+            throw RSGISImageCalcException(message);
+        }
+    }
+    
+    void RSGISBandMath::defineParserVars(bool useBulkVals)
+    {
+        for(int i = 0; i < numVariables; ++i)
+        {
+            if(useBulkVals)
+            {
+                muParser->DefineVar(_T(variables[i]->name.c_str()), this->bulkVals[i]);
+            }
+            else
+            {
+                muParser->DefineVar(_T(variables[i]->name.c_str()), &inVals[i]);
+            }
+        }
+        this->bulkVarsDefined = useBulkVals;
+    }
+
+    RSGISCalcImageValue* RSGISBandMath::getThreadClone()
+    {
+        // The parser binds its variables to inVals so each thread needs its own parser.
+        RSGISBandMath *clone = new RSGISBandMath(this->numOutBands, this->variables, this->numVariables, new mu::Parser());
+        clone->ownParser = true;
+        try
+        {
+            clone->muParser->SetExpr(this->muParser->GetExpr());
+        }
+        catch (mu::ParserError &e)
+        {
+            delete clone;
+            std::string message = std::string("ERROR: ") + std::string(e.GetMsg()) + std::string(":\t \'") + std::string(e.GetExpr()) + std::string("\'");
+            throw RSGISImageCalcException(message);
+        }
+        return clone;
+    }
+
+    std::string RSGISBandMath::getParameterHash()
+    {
+        std::string params = this->muParser->GetExpr();
+        for(int i = 0; i < this->numVariables; ++i)
+        {
+            params += std::string(";") + this->variables[i]->name + std::string("=") + std::to_string(this->variables[i]->band);
+        }
+        return params;
+    }
 
 	RSGISBandMath::~RSGISBandMath()
 	{
         delete[] inVals;
+        for(int i = 0; i < numVariables; ++i)
+        {
+            if(this->bulkVals[i] != NULL)
+            {
+                delete[] this->bulkVals[i];
+            }
+        }
+        delete[] bulkVals;
+        if(this->ownParser)
+        {
+            delete muParser;
+        }
 	}
     
     
@@ -61,12 +61,20 @@ namespace rsgis{namespace img{
 		public: 
 			RSGISBandMath(int numberOutBands, VariableBands **variables, int numVariables, mu::Parser *muParser);
 			void calcImageValue(float *bandValues, int numBands, double *output);
+            void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+            RSGISCalcImageValue* getThreadClone();
+            std::string getParameterHash();
 			~RSGISBandMath();
 		private:
+            void defineParserVars(bool useBulkVals);
 			VariableBands **variables;
 			int numVariables;
             mu::Parser *muParser;
             mu::value_type *inVals;
+            mu::value_type **bulkVals;
+            size_t numBulkPxls;
+            bool bulkVarsDefined;
+            bool ownParser;
 		};
     
     
@@ -0,0 +1,223 @@
+/*
+ *  RSGISBatchImageSubset.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISBatchImageSubset.h"
+
+namespace rsgis{namespace img{
+
+    RSGISBatchImageSubset::RSGISBatchImageSubset()
+    {
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+
+    void RSGISBatchImageSubset::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+
+    size_t RSGISBatchImageSubset::subsetImage(GDALDataset *dataset, std::vector<RSGISImageChip> *chips, std::string gdalFormat, GDALDataType gdalDataType)
+    {
+        RSGISImageUtils imgUtils;
+        int imgWidth = dataset->GetRasterXSize();
+        int imgHeight = dataset->GetRasterYSize();
+        int numBands = dataset->GetRasterCount();
+
+        // Find the pixel window of each chip.
+        int *dsOffsets[1];
+        int offsets[2] = {0, 0};
+        dsOffsets[0] = offsets;
+        std::vector<size_t> chipOrder;
+        for(size_t i = 0; i < chips->size(); ++i)
+        {
+            RSGISImageChip &chip = chips->at(i);
+            chip.valid = false;
+            chip.dataset = NULL;
+            try
+            {
+                imgUtils.getImageOverlapCut2Env(&dataset, 1, dsOffsets, &chip.width, &chip.height, chip.transform, &chip.env);
+                chip.xOff = offsets[0];
+                chip.yOff = offsets[1];
+                if((chip.width <= 0) || (chip.height <= 0))
+                {
+                    chip.error = "The envelope is smaller than a pixel.";
+                }
+                else if((chip.xOff < 0) || (chip.yOff < 0) || ((chip.xOff + chip.width) > imgWidth) || ((chip.yOff + chip.height) > imgHeight))
+                {
+                    chip.error = "The envelope is not within the image.";
+                }
+                else
+                {
+                    chip.valid = true;
+                    chipOrder.push_back(i);
+                }
+            }
+            catch(RSGISImageBandException &e)
+            {
+                chip.error = e.what();
+            }
+        }
+        std::stable_sort(chipOrder.begin(), chipOrder.end(), [chips](size_t a, size_t b){return chips->at(a).yOff < chips->at(b).yOff;});
+
+        int xBlockSize = 0;
+        int yBlockSize = 0;
+        dataset->GetRasterBand(1)->GetBlockSize(&xBlockSize, &yBlockSize);
+        int stripHeight = yBlockSize * std::max(1, 128 / std::max(yBlockSize, 1));
+        stripHeight = std::min(stripHeight, imgHeight);
+
+        std::vector<float*> stripData(numBands, NULL);
+        std::vector<size_t> openChips;
+        size_t numWritten = 0;
+        try
+        {
+            for(int n = 0; n < numBands; ++n)
+            {
+                stripData[n] = (float *) CPLMalloc(sizeof(float)*(((size_t)imgWidth)*stripHeight));
+            }
+
+            rsgis::utils::RSGISWorkerPool pool(this->numThreads);
+            rsgis_tqdm pbar;
+            size_t nextChip = 0;
+            int yStart = 0;
+            while((nextChip < chipOrder.size()) || (!openChips.empty()))
+            {
+                if(openChips.empty())
+                {
+                    // Skip the strips which no chip overlaps.
+                    int firstRow = chips->at(chipOrder[nextChip]).yOff;
+                    yStart = std::max(yStart, (firstRow / stripHeight) * stripHeight);
+                }
+                int nRows = std::min(stripHeight, imgHeight - yStart);
+                int yEnd = yStart + nRows;
+
+                while((nextChip < chipOrder.size()) && (chips->at(chipOrder[nextChip]).yOff < yEnd))
+                {
+                    RSGISImageChip *chip = &chips->at(chipOrder[nextChip]);
+                    if(this->createChipImage(dataset, chip, gdalFormat, gdalDataType))
+                    {
+                        openChips.push_back(chipOrder[nextChip]);
+                    }
+                    ++nextChip;
+                }
+
+                if(!openChips.empty())
+                {
+                    for(int n = 0; n < numBands; ++n)
+                    {
+                        if(dataset->GetRasterBand(n+1)->RasterIO(GF_Read, 0, yStart, imgWidth, nRows, stripData[n], imgWidth, nRows, GDT_Float32, 0, 0) != CE_None)
+                        {
+                            throw RSGISImageCalcException("Could not read the input image.");
+                        }
+                    }
+
+                    // The rows of the strip are written to each open chip, the chips being shared among the threads.
+                    pool.parallelFor(openChips.size(), [&](size_t idx, unsigned int)
+                    {
+                        RSGISImageChip *chip = &chips->at(openChips[idx]);
+                        int r0 = std::max(chip->yOff, yStart);
+                        int r1 = std::min(chip->yOff + chip->height, yEnd);
+                        for(int n = 0; n < numBands; ++n)
+                        {
+                            float *rowsData = stripData[n] + (((size_t)(r0 - yStart)) * imgWidth) + chip->xOff;
+                            if(chip->dataset->GetRasterBand(n+1)->RasterIO(GF_Write, 0, r0 - chip->yOff, chip->width, r1 - r0, rowsData, chip->width, r1 - r0, GDT_Float32, 0, sizeof(float)*imgWidth) != CE_None)
+                            {
+                                throw RSGISImageCalcException("Could not write to the image " + chip->outputImage);
+                            }
+                        }
+                        if(r1 == (chip->yOff + chip->height))
+                        {
+                            GDALClose(chip->dataset);
+                            chip->dataset = NULL;
+                        }
+                    });
+
+                    std::vector<size_t> stillOpen;
+                    for(std::vector<size_t>::iterator iterOpen = openChips.begin(); iterOpen != openChips.end(); ++iterOpen)
+                    {
+                        if(chips->at(*iterOpen).dataset != NULL)
+                        {
+                            stillOpen.push_back(*iterOpen);
+                        }
+                        else
+                        {
+                            ++numWritten;
+                        }
+                    }
+                    openChips = stillOpen;
+                }
+                yStart = yEnd;
+                pbar.progress(yStart, imgHeight);
+            }
+            pbar.finish();
+        }
+        catch(RSGISException &e)
+        {
+            for(std::vector<size_t>::iterator iterOpen = openChips.begin(); iterOpen != openChips.end(); ++iterOpen)
+            {
+                if(chips->at(*iterOpen).dataset != NULL)
+                {
+                    GDALClose(chips->at(*iterOpen).dataset);
+                    chips->at(*iterOpen).dataset = NULL;
+                }
+            }
+            for(int n = 0; n < numBands; ++n)
+            {
+                CPLFree(stripData[n]);
+            }
+            throw;
+        }
+        for(int n = 0; n < numBands; ++n)
+        {
+            CPLFree(stripData[n]);
+        }
+        return numWritten;
+    }
+
+    bool RSGISBatchImageSubset::createChipImage(GDALDataset *dataset, RSGISImageChip *chip, std::string gdalFormat, GDALDataType gdalDataType)
+    {
+        GDALDriver *gdalDriver = GetGDALDriverManager()->GetDriverByName(gdalFormat.c_str());
+        if(gdalDriver == NULL)
+        {
+            throw RSGISImageCalcException("Requested GDAL driver does not exists..");
+        }
+        RSGISImageUtils imgUtils;
+        char **papszOptions = imgUtils.getGDALCreationOptionsForFormat(gdalFormat);
+        RSGISDatasetCache::invalidate(chip->outputImage);
+        chip->dataset = gdalDriver->Create(chip->outputImage.c_str(), chip->width, chip->height, dataset->GetRasterCount(), gdalDataType, papszOptions);
+        CSLDestroy(papszOptions);
+        if(chip->dataset == NULL)
+        {
+            chip->valid = false;
+            chip->error = "Output image could not be created. Check filepath.";
+            return false;
+        }
+        chip->dataset->SetGeoTransform(chip->transform);
+        chip->dataset->SetProjection(dataset->GetProjectionRef());
+        return true;
+    }
+
+    RSGISBatchImageSubset::~RSGISBatchImageSubset()
+    {
+
+    }
+
+}}
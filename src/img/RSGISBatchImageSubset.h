@@ -0,0 +1,122 @@
+/*
+ *  RSGISBatchImageSubset.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISBatchImageSubset_H
+#define RSGISBatchImageSubset_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+#include <cstdlib>
+
+#include "gdal_priv.h"
+
+#include "common/rsgis-tqdm.h"
+#include "common/RSGISImageException.h"
+#include "common/RSGISParallel.h"
+
+#include "img/RSGISImageBandException.h"
+#include "img/RSGISImageCalcException.h"
+#include "img/RSGISImageUtils.h"
+#include "img/RSGISDatasetCache.h"
+
+#include "geos/geom/Envelope.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_img_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace img{
+
+    /**
+     * A subset (chip) of the image to be written to its own file.
+     */
+    struct DllExport RSGISImageChip
+    {
+        std::string outputImage;
+        geos::geom::Envelope env;
+        // Set by createChips: the pixel window within the image and the geotransform.
+        int xOff;
+        int yOff;
+        int width;
+        int height;
+        double transform[6];
+        bool valid;
+        std::string error;
+        GDALDataset *dataset;
+    };
+
+    /**
+     * Subset an image to many envelopes in one pass over the image. The chips
+     * are sorted by their first row and the image read in strips of block
+     * rows; each chip is created when the strip containing its first row is
+     * read, the rows of every open chip within the strip are copied out of
+     * the strip and written (the chips being written by several threads, as
+     * set with setNumThreads or RSGISLIB_NUM_THREADS) and the chip is closed
+     * once its last row has been written. Each block of the image is
+     * therefore read once however many chips overlap it.
+     *
+     * The chips have the same extent (the envelope cut to the image and
+     * snapped to the pixels) as with RSGISCalcImage::calcImageInEnv.
+     */
+    class DllExport RSGISBatchImageSubset
+    {
+    public:
+        RSGISBatchImageSubset();
+        /**
+         * The number of chips written at once (0 uses the number of cores).
+         */
+        void setNumThreads(unsigned int numThreads);
+        /**
+         * Write the chips of all the bands of the dataset. Chips which cannot be
+         * created (e.g., the envelope is outside the image or the file cannot be
+         * created) are marked as not valid, with the reason in their error.
+         * Returns the number of chips written.
+         */
+        size_t subsetImage(GDALDataset *dataset, std::vector<RSGISImageChip> *chips, std::string gdalFormat, GDALDataType gdalDataType);
+        ~RSGISBatchImageSubset();
+    protected:
+        /**
+         * Create the output image of a chip; returns false (with the chip's
+         * error set) if it could not be created.
+         */
+        bool createChipImage(GDALDataset *dataset, RSGISImageChip *chip, std::string gdalFormat, GDALDataType gdalDataType);
+        unsigned int numThreads;
+    };
+
+}}
+
+#endif
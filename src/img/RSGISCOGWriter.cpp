@@ -0,0 +1,193 @@
+/*
+ *  RSGISCOGWriter.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISCOGWriter.h"
+
+#include "img/RSGISImageUtils.h"
+#include "img/RSGISDatasetCache.h"
+
+#include <boost/algorithm/string.hpp>
+
+namespace rsgis{namespace img{
+
+    RSGISCOGWriter::RSGISCOGWriter(std::string outputImage)
+    {
+        this->outputImage = outputImage;
+        this->tmpImage = outputImage + ".tmp.tif";
+        this->tmpDS = NULL;
+        this->tileSize = 512;
+        this->nearest = false;
+        this->overviews = NULL;
+        this->finished = false;
+    }
+
+    bool RSGISCOGWriter::isCOGFormat(std::string gdalFormat)
+    {
+        return boost::to_upper_copy(gdalFormat) == "COG";
+    }
+
+    GDALDataset* RSGISCOGWriter::create(int width, int height, int numBands, GDALDataType dataType)
+    {
+        RSGISImageUtils imgUtils;
+        this->creationOpts = imgUtils.getCreateGDALImgEnvVars("COG");
+        if(this->creationOpts.count("BLOCKSIZE") > 0)
+        {
+            this->tileSize = atoi(this->creationOpts["BLOCKSIZE"].c_str());
+            if(this->tileSize < 16)
+            {
+                throw RSGISImageBandException("The COG BLOCKSIZE must be at least 16.");
+            }
+        }
+        if(this->creationOpts.count("COMPRESS") == 0)
+        {
+            this->creationOpts["COMPRESS"] = "DEFLATE";
+        }
+        if(this->creationOpts.count("BIGTIFF") == 0)
+        {
+            this->creationOpts["BIGTIFF"] = "IF_SAFER";
+        }
+        imgUtils.setCompressionThreads("COG", &this->creationOpts);
+        if(this->creationOpts.count("RESAMPLING") > 0)
+        {
+            this->nearest = boost::to_upper_copy(this->creationOpts["RESAMPLING"]) == "NEAREST";
+        }
+        GDALDriver *gtiffDriver = GetGDALDriverManager()->GetDriverByName("GTiff");
+        if(gtiffDriver == NULL)
+        {
+            throw RSGISImageBandException("The GTiff GDAL driver is not available.");
+        }
+        std::string tileSizeStr = std::to_string(this->tileSize);
+        char **papszOptions = NULL;
+        papszOptions = CSLSetNameValue(papszOptions, "TILED", "YES");
+        papszOptions = CSLSetNameValue(papszOptions, "BLOCKXSIZE", tileSizeStr.c_str());
+        papszOptions = CSLSetNameValue(papszOptions, "BLOCKYSIZE", tileSizeStr.c_str());
+        const char *passOpts[] = {"COMPRESS", "PREDICTOR", "ZLEVEL", "BIGTIFF", "NUM_THREADS"};
+        for(unsigned int i = 0; i < 5; ++i)
+        {
+            if(this->creationOpts.count(passOpts[i]) > 0)
+            {
+                papszOptions = CSLSetNameValue(papszOptions, passOpts[i], this->creationOpts[passOpts[i]].c_str());
+            }
+        }
+        this->tmpDS = gtiffDriver->Create(this->tmpImage.c_str(), width, height, numBands, dataType, papszOptions);
+        CSLDestroy(papszOptions);
+        if(this->tmpDS == NULL)
+        {
+            throw RSGISImageBandException("Output image could not be created. Check filepath.");
+        }
+
+        // Overview levels halve the image until it fits within a single tile.
+        std::vector<int> factors;
+        int levelWidth = width;
+        int levelHeight = height;
+        int factor = 1;
+        while((levelWidth > this->tileSize) || (levelHeight > this->tileSize))
+        {
+            factor *= 2;
+            levelWidth = (levelWidth + 1) / 2;
+            levelHeight = (levelHeight + 1) / 2;
+            factors.push_back(factor);
+        }
+        RSGISStreamOverviewBuilder::createOverviews(this->tmpDS, factors);
+        this->overviews = new RSGISStreamOverviewBuilder(this->tmpDS, factors, this->nearest, this->tileSize);
+        return this->tmpDS;
+    }
+
+    void RSGISCOGWriter::addRows(double **outputData, int numBands, int width, int rowOffset, int nRows)
+    {
+        if((this->overviews == NULL) || (numBands != this->tmpDS->GetRasterCount()) || (width != this->tmpDS->GetRasterXSize()))
+        {
+            throw RSGISImageBandException("The rows given to the COG writer do not match the image.");
+        }
+        this->overviews->addRows(outputData, rowOffset, nRows);
+    }
+
+    void RSGISCOGWriter::finish()
+    {
+        if(this->tmpDS == NULL)
+        {
+            throw RSGISImageBandException("The COG output has not been created.");
+        }
+        this->overviews->finish();
+        GDALClose(this->tmpDS);
+        this->tmpDS = NULL;
+
+        GDALDataset *srcDS = (GDALDataset *) GDALOpen(this->tmpImage.c_str(), GA_ReadOnly);
+        if(srcDS == NULL)
+        {
+            throw RSGISImageBandException("Could not re-open the temporary COG image.");
+        }
+        GDALDriver *gtiffDriver = GetGDALDriverManager()->GetDriverByName("GTiff");
+        std::string tileSizeStr = std::to_string(this->tileSize);
+        char **papszOptions = NULL;
+        papszOptions = CSLSetNameValue(papszOptions, "TILED", "YES");
+        papszOptions = CSLSetNameValue(papszOptions, "COPY_SRC_OVERVIEWS", "YES");
+        papszOptions = CSLSetNameValue(papszOptions, "BLOCKXSIZE", tileSizeStr.c_str());
+        papszOptions = CSLSetNameValue(papszOptions, "BLOCKYSIZE", tileSizeStr.c_str());
+        const char *passOpts[] = {"COMPRESS", "PREDICTOR", "ZLEVEL", "BIGTIFF", "NUM_THREADS"};
+        for(unsigned int i = 0; i < 5; ++i)
+        {
+            if(this->creationOpts.count(passOpts[i]) > 0)
+            {
+                papszOptions = CSLSetNameValue(papszOptions, passOpts[i], this->creationOpts[passOpts[i]].c_str());
+            }
+        }
+        RSGISDatasetCache::invalidate(this->outputImage);
+        GDALDataset *cogDS = gtiffDriver->CreateCopy(this->outputImage.c_str(), srcDS, FALSE, papszOptions, NULL, NULL);
+        CSLDestroy(papszOptions);
+        GDALClose(srcDS);
+        if(cogDS == NULL)
+        {
+            throw RSGISImageBandException("Could not create the COG output image.");
+        }
+        GDALClose(cogDS);
+        gtiffDriver->Delete(this->tmpImage.c_str());
+        this->finished = true;
+    }
+
+    void RSGISCOGWriter::cleanUp()
+    {
+        if(this->overviews != NULL)
+        {
+            delete this->overviews;
+            this->overviews = NULL;
+        }
+        if(this->tmpDS != NULL)
+        {
+            GDALClose(this->tmpDS);
+            this->tmpDS = NULL;
+        }
+        if(!this->finished)
+        {
+            VSIStatBufL statBuf;
+            if(VSIStatL(this->tmpImage.c_str(), &statBuf) == 0)
+            {
+                VSIUnlink(this->tmpImage.c_str());
+            }
+        }
+    }
+
+    RSGISCOGWriter::~RSGISCOGWriter()
+    {
+        this->cleanUp();
+    }
+
+}}
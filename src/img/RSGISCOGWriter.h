@@ -0,0 +1,96 @@
+/*
+ *  RSGISCOGWriter.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISCOGWriter_H
+#define RSGISCOGWriter_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "gdal_priv.h"
+
+#include "img/RSGISImageBandException.h"
+#include "img/RSGISStreamOverviewBuilder.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_img_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace img{
+
+    /**
+     * Writes a Cloud Optimised GeoTIFF (COG) in a single pass of the
+     * calculation. The image is written to a temporary internally tiled,
+     * compressed GeoTIFF alongside the output while the overview levels
+     * (factors 2, 4, 8, ... until the image fits within a tile) are built
+     * from the output rows as they are produced (RSGISStreamOverviewBuilder). At finish the
+     * temporary file and its overviews are copied into the COG layout (GTiff
+     * with COPY_SRC_OVERVIEWS=YES) and removed.
+     *
+     * Creation options are read from RSGISLIB_IMG_CRT_OPTS_COG (as for the
+     * other formats); COMPRESS (default DEFLATE), BLOCKSIZE (default 512),
+     * PREDICTOR, ZLEVEL and BIGTIFF are used. The overview resampling is
+     * AVERAGE (NaN values are ignored) unless RESAMPLING=NEAREST is given.
+     */
+    class DllExport RSGISCOGWriter : public RSGISImageOutputSink
+    {
+    public:
+        RSGISCOGWriter(std::string outputImage);
+        static bool isCOGFormat(std::string gdalFormat);
+        /**
+         * Create the temporary image, the caller sets its geotransform,
+         * projection and band descriptions and writes the full resolution
+         * data to it but must not close it.
+         */
+        GDALDataset* create(int width, int height, int numBands, GDALDataType dataType);
+        void addRows(double **outputData, int numBands, int width, int rowOffset, int nRows);
+        /**
+         * Write any remaining overview rows and create the COG, which
+         * requires all the image rows to have been given to addRows.
+         */
+        void finish();
+        ~RSGISCOGWriter();
+    protected:
+        void cleanUp();
+        std::string outputImage;
+        std::string tmpImage;
+        GDALDataset *tmpDS;
+        int tileSize;
+        bool nearest;
+        std::map<std::string, std::string> creationOpts;
+        RSGISStreamOverviewBuilder *overviews;
+        bool finished;
+    };
+
+}}
+
+#endif
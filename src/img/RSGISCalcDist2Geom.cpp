@@ -30,26 +30,27 @@ namespace rsgis{namespace img{
     {
         this->geomCollection = geomCollection;
         this->geomOrigCollection = geomOrigCollection;
+        this->geosGeoms = this->convertOGRGeometry2GEOS(geomCollection);
+        this->geosOrigGeoms = this->convertOGRGeometry2GEOS(geomOrigCollection);
     }
 
     void RSGISCalcDist2Geom::calcImageValue(float *bandValues, int numBands, geos::geom::Envelope extent) 
     {
         try 
         {
+            const geos::geom::GeometryFactory *geomFactory = rsgis::utils::RSGISGEOSFactoryGenerator::getInstance()->getFactory();
+            geos::geom::Coordinate ptCoord((extent.getMinX() + (extent.getMaxX() - extent.getMinX())/2), (extent.getMinY() + (extent.getMaxY() - extent.getMinY())/2));
+            geos::geom::Point *pt = geomFactory->createPoint(ptCoord);
             
-            OGRPoint pt;
-            pt.setX((extent.getMinX() + (extent.getMaxX() - extent.getMinX())/2));
-            pt.setY((extent.getMinY() + (extent.getMaxY() - extent.getMinY())/2));
-            
-            
-            if(geomOrigCollection->Contains(&pt))
+            if(prepCache.contains(geosOrigGeoms, pt))
             {
                 bandValues[0]  *= (-1);
             }
             else
             {
-                bandValues[0] = pt.Distance(geomCollection);
+                bandValues[0] = prepCache.distance(geosGeoms, pt);
             }
+            delete pt;
         } 
         catch (std::exception &e) 
         {
@@ -57,9 +58,22 @@ namespace rsgis{namespace img{
         }
     }
     
+    geos::geom::Geometry* RSGISCalcDist2Geom::convertOGRGeometry2GEOS(OGRGeometry *geom)
+    {
+        int wkbSize = geom->WkbSize();
+        unsigned char *wkb = new unsigned char[wkbSize];
+        geom->exportToWkb(wkbNDR, wkb);
+        std::istringstream wkbStream(std::string((char*)wkb, wkbSize));
+        delete[] wkb;
+        geos::io::WKBReader wkbReader(*rsgis::utils::RSGISGEOSFactoryGenerator::getInstance()->getFactory());
+        return wkbReader.read(wkbStream);
+    }
+    
     RSGISCalcDist2Geom::~RSGISCalcDist2Geom()
     {
-        
+        prepCache.clear();
+        delete geosGeoms;
+        delete geosOrigGeoms;
     }
     
     
@@ -27,6 +27,7 @@
 
 #include <iostream>
 #include <string>
+#include <sstream>
 #include <math.h>
 
 #include "gdal_priv.h"
@@ -39,6 +40,12 @@
 #include "geos/geom/Coordinate.h"
 #include "geos/geom/CoordinateArraySequence.h"
 #include "geos/geom/PrecisionModel.h"
+#include "geos/geom/GeometryFactory.h"
+#include "geos/io/WKBReader.h"
+
+#include "geom/RSGISPreparedGeometryCache.h"
+
+#include "utils/RSGISGEOSFactoryGenerator.h"
 
 #include "img/RSGISImageCalcException.h"
 #include "img/RSGISCalcImageValue.h"
@@ -74,8 +81,14 @@ namespace rsgis{namespace img{
 		bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageCalcException("No implemented");};
 		~RSGISCalcDist2Geom();
 	private:
+        geos::geom::Geometry* convertOGRGeometry2GEOS(OGRGeometry *geom);
         OGRGeometryCollection *geomCollection;
         OGRGeometryCollection *geomOrigCollection;
+        // GEOS copies of the geometries, which are queried through their
+        // prepared versions rather than converted for every pixel.
+        geos::geom::Geometry *geosGeoms;
+        geos::geom::Geometry *geosOrigGeoms;
+        rsgis::geom::RSGISPreparedGeometryCache prepCache;
 	};
     
     class DllExport RSGISCalcDistViaIterativeGrowth : public RSGISCalcImageValue
@@ -21,6 +21,9 @@
  */
 
 #include "RSGISCalcImage.h"
+#include "RSGISOutputStatsSink.h"
+#include "RSGISCalcImageTileQueue.h"
+#include "RSGISPopWithStats.h"
 
 namespace rsgis{namespace img{
 	
@@ -30,11 +33,68 @@ namespace rsgis{namespace img{
 		this->numOutBands = valueCalc->getNumOutBands();
 		this->proj = proj;
 		this->useImageProj = useImageProj;
+        this->numThreads = rsgis::utils::getNumThreads();
+        this->calcOutputStats = false;
+        this->calcOutputPyramids = true;
+        this->outputThematic = false;
+        this->outputStatsUseNoData = false;
+        this->outputStatsNoDataVal = 0;
+        if(const char* env_p = std::getenv("RSGISLIB_OUTPUT_STATS"))
+        {
+            this->calcOutputStats = (atoi(env_p) > 0);
+        }
+        this->usePipelinedIO = false;
+        if(const char* env_p = std::getenv("RSGISLIB_PIPELINE_IO"))
+        {
+            this->usePipelinedIO = (atoi(env_p) > 0);
+        }
+        this->tileQueueDIR = "";
+        this->tileQueueSize = 0;
+        this->tileQueueClaimTimeout = 600;
+        this->checkpointSecs = 0;
+        this->checkpointResume = false;
+        this->checkpointFile = "";
+        this->activeCheckpoint = NULL;
+        if(const char* env_p = std::getenv("RSGISLIB_CHECKPOINT_SECS"))
+        {
+            int envCheckpointSecs = atoi(env_p);
+            if(envCheckpointSecs > 0)
+            {
+                this->checkpointSecs = envCheckpointSecs;
+            }
+        }
+        if(const char* env_p = std::getenv("RSGISLIB_CHECKPOINT_RESUME"))
+        {
+            this->checkpointResume = (atoi(env_p) > 0);
+        }
+        this->skipEmptyBlocks = false;
+        this->skipLeaveSparse = false;
+        this->skipNoDataVal = 0;
+        this->skipMaskDataset = NULL;
+        if(const char* env_p = std::getenv("RSGISLIB_SKIP_EMPTY_BLOCKS"))
+        {
+            int envSkipEmpty = atoi(env_p);
+            this->skipEmptyBlocks = (envSkipEmpty > 0);
+            this->skipLeaveSparse = (envSkipEmpty > 1);
+        }
+        this->quickLookFactor = 1;
 	}
     
     
     void RSGISCalcImage::calcImage(GDALDataset **datasets, int numDS, std::string outputImage, bool setOutNames, std::string *bandNames, std::string gdalFormat, GDALDataType gdalDataType)
     {
+        if(this->tileQueueDIR != "")
+        {
+            RSGISCalcImageTileQueue tileQueue(this, this->tileQueueDIR, this->tileQueueSize, this->tileQueueClaimTimeout);
+            tileQueue.calcImage(datasets, numDS, outputImage, setOutNames, bandNames, gdalFormat, gdalDataType);
+            return;
+        }
+        if(this->quickLookFactor > 1)
+        {
+            std::cerr << "WARNING: writing a quick look at 1/" << this->quickLookFactor << " of the resolution to " << outputImage << " rather than the full resolution output." << std::endl;
+            this->calcImageQuickLook(datasets, numDS, outputImage, this->quickLookFactor, setOutNames, bandNames, gdalFormat, gdalDataType);
+            return;
+        }
         GDALAllRegister();
 		RSGISImageUtils imgUtils;
 		double *gdalTranslation = new double[6];
@@ -59,6 +119,11 @@ namespace rsgis{namespace img{
 		GDALRasterBand **inputRasterBands = NULL;
 		GDALRasterBand **outputRasterBands = NULL;
 		GDALDriver *gdalDriver = NULL;
+        std::unique_ptr<RSGISCOGWriter> cogWriter;
+        std::unique_ptr<RSGISOutputStatsSink> statsSink;
+        std::unique_ptr<RSGISCalcImageCheckpoint> checkpoint;
+        bool resumed = false;
+        RSGISCalcImageJobScope jobScope(&this->outputSinks, &this->activeCheckpoint);
         
         try
 		{
@@ -66,21 +131,60 @@ namespace rsgis{namespace img{
 			imgUtils.getImageOverlap(datasets, numDS, dsOffsets, &width, &height, gdalTranslation, &xBlockSize, &yBlockSize);
                         
 			// Count number of image bands
+			std::vector<std::string> inputFiles;
 			for(int i = 0; i < numDS; i++)
 			{
 				numInBands += datasets[i]->GetRasterCount();
+				inputFiles.push_back(datasets[i]->GetDescription());
 			}
             
 			// Create new Image
-			gdalDriver = GetGDALDriverManager()->GetDriverByName(gdalFormat.c_str());
-			if(gdalDriver == NULL)
+			std::cout << "New image width = " << width << " height = " << height << " bands = " << this->numOutBands << std::endl;
+			if(RSGISCOGWriter::isCOGFormat(gdalFormat))
 			{
-				throw RSGISImageBandException("Requested GDAL driver does not exists..");
+				if(this->checkpointSecs > 0)
+				{
+					std::cout << "Checkpointing is not available for COG outputs so the job cannot be resumed." << std::endl;
+				}
+				// The COG driver cannot write directly so a tiled GeoTIFF, with
+				// overviews built as the rows are written, is converted at the end.
+				cogWriter.reset(new RSGISCOGWriter(outputImage));
+				outputImageDS = cogWriter->create(width, height, this->numOutBands, gdalDataType);
+				this->outputSinks.push_back(cogWriter.get());
+			}
+			else
+			{
+				if(this->checkpointSecs > 0)
+				{
+					std::string ckptFile = (this->checkpointFile != "")?this->checkpointFile:(outputImage + std::string(".rsgisckpt"));
+					checkpoint.reset(new RSGISCalcImageCheckpoint(ckptFile, this->checkpointSecs));
+					if(this->checkpointResume && checkpoint->exists())
+					{
+						RSGISDatasetCache::invalidate(outputImage);
+						outputImageDS = (GDALDataset *) GDALOpen(outputImage.c_str(), GA_Update);
+						if((outputImageDS != NULL) && (outputImageDS->GetRasterXSize() == width) && (outputImageDS->GetRasterYSize() == height) && checkpoint->load(width, height, this->numOutBands, gdalDataType, inputFiles, this->calc))
+						{
+							resumed = true;
+						}
+						else if(outputImageDS != NULL)
+						{
+							GDALClose(outputImageDS);
+							outputImageDS = NULL;
+						}
+					}
+				}
+				if(!resumed)
+				{
+					gdalDriver = GetGDALDriverManager()->GetDriverByName(gdalFormat.c_str());
+					if(gdalDriver == NULL)
+					{
+						throw RSGISImageBandException("Requested GDAL driver does not exists..");
+					}
+					char **papszOptions = imgUtils.getGDALCreationOptionsForFormat(gdalFormat);
+					RSGISDatasetCache::invalidate(outputImage);
+					outputImageDS = gdalDriver->Create(outputImage.c_str(), width, height, this->numOutBands, gdalDataType, papszOptions);
+				}
 			}
-            char **papszOptions = imgUtils.getGDALCreationOptionsForFormat(gdalFormat);
-			std::cout << "New image width = " << width << " height = " << height << " bands = " << this->numOutBands << std::endl;
-			
-			outputImageDS = gdalDriver->Create(outputImage.c_str(), width, height, this->numOutBands, gdalDataType, papszOptions);
 			
 			if(outputImageDS == NULL)
 			{
@@ -122,6 +226,13 @@ namespace rsgis{namespace img{
 					outputRasterBands[i]->SetDescription(bandNames[i].c_str());
 				}
 			}
+            // The rows written before a resumed job are not seen by the stats
+            // sink so the statistics are calculated from the image at the end.
+            if(this->calcOutputStats && (!resumed))
+            {
+                statsSink.reset(new RSGISOutputStatsSink(outputImageDS, (this->calcOutputPyramids && (!cogWriter)), this->outputThematic, this->outputStatsUseNoData, this->outputStatsNoDataVal));
+                this->outputSinks.push_back(statsSink.get());
+            }
             int outXBlockSize = 0;
             int outYBlockSize = 0;
             outputRasterBands[0]->GetBlockSize (&outXBlockSize, &outYBlockSize);
@@ -131,99 +242,125 @@ namespace rsgis{namespace img{
                 yBlockSize = outYBlockSize;
             }
             
-			// Allocate memory
-			inputData = new float*[numInBands];
-			for(int i = 0; i < numInBands; i++)
-			{
-				inputData[i] = (float *) CPLMalloc(sizeof(float)*(width*yBlockSize));
-			}
-			inDataColumn = new float[numInBands];
+            RSGISImageBlockPlan blockPlan = this->planBlocks(inputRasterBands, numInBands, outputRasterBands, width, height, yBlockSize);
+            yBlockSize = blockPlan.rows;
+            RSGISGDALCacheScope gdalCacheScope(blockPlan.gdalCacheBytes);
+            if(resumed)
+            {
+                // The completed blocks were recorded with the block size of the original run.
+                yBlockSize = checkpoint->getBlockRows();
+                std::cout << "Resuming from row " << std::min(checkpoint->getBlocksDone() * yBlockSize, height) << " using the checkpoint." << std::endl;
+            }
+            else if(checkpoint)
+            {
+                checkpoint->start(width, height, this->numOutBands, gdalDataType, yBlockSize, inputFiles, this->calc);
+            }
             
-			outputData = new double*[this->numOutBands];
-			for(int i = 0; i < this->numOutBands; i++)
-			{
-				outputData[i] = (double *) CPLMalloc(sizeof(double)*(width*yBlockSize));
-			}
-			outDataColumn = new double[this->numOutBands];
-                      
-            int nYBlocks = floor(((double)height) / ((double)yBlockSize));
-            int remainRows = height - (nYBlocks * yBlockSize);
-            int rowOffset = 0;
+            if(this->skipEmptyBlocks)
+            {
+                this->prepareSkipEmptyBlocks(outputRasterBands, width, height);
+            }
             
-			rsgis_tqdm pbar;
-			// Loop images to process data
-			for(int i = 0; i < nYBlocks; i++)
-			{
-				for(int n = 0; n < numInBands; n++)
-				{
-                    rowOffset = bandOffsets[n][1] + (yBlockSize * i);
-					inputRasterBands[n]->RasterIO(GF_Read, bandOffsets[n][0], rowOffset, width, yBlockSize, inputData[n], width, yBlockSize, GDT_Float32, 0, 0);
-				}
-                
-                for(int m = 0; m < yBlockSize; ++m)
+            if(this->useMultiThreaded() || checkpoint || (this->skipEmptyBlocks && !this->canPipelineIO(inputRasterBands, numInBands, outputRasterBands)))
+            {
+                // The multi-threaded path records the completed blocks and
+                // skips the empty blocks (with one worker if only a single
+                // thread is used). jobScope resets the active checkpoint.
+                this->activeCheckpoint = checkpoint.get();
+                this->calcImageBlocksMultiThreaded(inputRasterBands, bandOffsets, numInBands, outputRasterBands, width, height, yBlockSize);
+                this->activeCheckpoint = NULL;
+            }
+            else if(this->canPipelineIO(inputRasterBands, numInBands, outputRasterBands))
+            {
+                this->calcImageBlocksPipelined(inputRasterBands, bandOffsets, numInBands, outputRasterBands, width, height, yBlockSize);
+            }
+            else if(!this->calcImageBlocksNativeTypes(inputRasterBands, bandOffsets, numInBands, outputRasterBands, width, height, yBlockSize))
+            {
+                // Allocate memory
+                inputData = new float*[numInBands];
+                for(int i = 0; i < numInBands; i++)
                 {
-                    pbar.progress((i*yBlockSize)+m, height);
-                                        
-                    for(int j = 0; j < width; j++)
-                    {
-                        for(int n = 0; n < numInBands; n++)
-                        {
-                            inDataColumn[n] = inputData[n][(m*width)+j];
-                        }
-                        
-                        this->calc->calcImageValue(inDataColumn, numInBands, outDataColumn);
-                        
-                        for(int n = 0; n < this->numOutBands; n++)
-                        {
-                            outputData[n][(m*width)+j] = outDataColumn[n];
-                        }
-                        
-                    }
+                    inputData[i] = (float *) CPLMalloc(sizeof(float)*(width*yBlockSize));
+                }
+                inDataColumn = new float[numInBands];
+
+                outputData = new double*[this->numOutBands];
+                for(int i = 0; i < this->numOutBands; i++)
+                {
+                    outputData[i] = (double *) CPLMalloc(sizeof(double)*(width*yBlockSize));
                 }
+                outDataColumn = new double[this->numOutBands];
+                
+                int nYBlocks = floor(((double)height) / ((double)yBlockSize));
+                int remainRows = height - (nYBlocks * yBlockSize);
+                int rowOffset = 0;
+                RSGISImageReadPlanner readPlanner(inputRasterBands, bandOffsets, numInBands, width, height, yBlockSize);
+            
+    			rsgis_tqdm pbar;
+    			// Loop images to process data
+    			for(int i = 0; i < nYBlocks; i++)
+    			{
+                    readPlanner.prefetch(i);
+    				rsgis::RSGISScopedTimer readTimer("calcimage.read");
+    				for(int n = 0; n < numInBands; n++)
+    				{
+                        rowOffset = bandOffsets[n][1] + (yBlockSize * i);
+    					inputRasterBands[n]->RasterIO(GF_Read, bandOffsets[n][0], rowOffset, width, yBlockSize, inputData[n], width, yBlockSize, GDT_Float32, 0, 0);
+    				}
+                    readTimer.addBytes(sizeof(float)*numInBands*((size_t)width)*yBlockSize);
+                    readTimer.stop();
+                
+                    pbar.progress(i*yBlockSize, height);
+                    rsgis::RSGISScopedTimer calcTimer("calcimage.compute");
+                    calcTimer.addCount(((size_t)width)*yBlockSize);
+                    this->calc->calcImageBlock(inputData, numInBands, ((size_t)width)*yBlockSize, outputData);
+                    calcTimer.stop();
 				
-				for(int n = 0; n < this->numOutBands; n++)
-				{
-                    rowOffset = yBlockSize * i;
-					outputRasterBands[n]->RasterIO(GF_Write, 0, rowOffset, width, yBlockSize, outputData[n], width, yBlockSize, GDT_Float64, 0, 0);
-				}
-			}
+                    rsgis::RSGISScopedTimer writeTimer("calcimage.write");
+    				for(int n = 0; n < this->numOutBands; n++)
+    				{
+                        rowOffset = yBlockSize * i;
+    					outputRasterBands[n]->RasterIO(GF_Write, 0, rowOffset, width, yBlockSize, outputData[n], width, yBlockSize, GDT_Float64, 0, 0);
+    				}
+                    for(std::vector<RSGISImageOutputSink*>::iterator iterSink = this->outputSinks.begin(); iterSink != this->outputSinks.end(); ++iterSink)
+                    {
+                        (*iterSink)->addRows(outputData, this->numOutBands, width, yBlockSize * i, yBlockSize);
+                    }
+                    writeTimer.addBytes(sizeof(double)*this->numOutBands*((size_t)width)*yBlockSize);
+    			}
             
-            if(remainRows > 0)
-            {
-                for(int n = 0; n < numInBands; n++)
-				{
-                    rowOffset = bandOffsets[n][1] + (yBlockSize * nYBlocks);
-					inputRasterBands[n]->RasterIO(GF_Read, bandOffsets[n][0], rowOffset, width, remainRows, inputData[n], width, remainRows, GDT_Float32, 0, 0);
-				}
-                                
-                for(int m = 0; m < remainRows; ++m)
+                if(remainRows > 0)
                 {
-                    pbar.progress((nYBlocks*yBlockSize)+m, height);
-                    
-                    for(int j = 0; j < width; j++)
+                    readPlanner.prefetch(nYBlocks);
+                    rsgis::RSGISScopedTimer readTimer("calcimage.read");
+                    for(int n = 0; n < numInBands; n++)
+    				{
+                        rowOffset = bandOffsets[n][1] + (yBlockSize * nYBlocks);
+    					inputRasterBands[n]->RasterIO(GF_Read, bandOffsets[n][0], rowOffset, width, remainRows, inputData[n], width, remainRows, GDT_Float32, 0, 0);
+    				}
+                    readTimer.addBytes(sizeof(float)*numInBands*((size_t)width)*remainRows);
+                    readTimer.stop();
+                                
+                    pbar.progress(nYBlocks*yBlockSize, height);
+                    rsgis::RSGISScopedTimer calcTimer("calcimage.compute");
+                    calcTimer.addCount(((size_t)width)*remainRows);
+                    this->calc->calcImageBlock(inputData, numInBands, ((size_t)width)*remainRows, outputData);
+                    calcTimer.stop();
+				
+                    rsgis::RSGISScopedTimer writeTimer("calcimage.write");
+    				for(int n = 0; n < this->numOutBands; n++)
+    				{
+                        rowOffset = (yBlockSize * nYBlocks);
+    					outputRasterBands[n]->RasterIO(GF_Write, 0, rowOffset, width, remainRows, outputData[n], width, remainRows, GDT_Float64, 0, 0);
+    				}
+                    for(std::vector<RSGISImageOutputSink*>::iterator iterSink = this->outputSinks.begin(); iterSink != this->outputSinks.end(); ++iterSink)
                     {
-                        for(int n = 0; n < numInBands; n++)
-                        {
-                            inDataColumn[n] = inputData[n][(m*width)+j];
-                        }
-                        
-                        this->calc->calcImageValue(inDataColumn, numInBands, outDataColumn);
-                        
-                        for(int n = 0; n < this->numOutBands; n++)
-                        {
-                            outputData[n][(m*width)+j] = outDataColumn[n];
-                        }
-                        
+                        (*iterSink)->addRows(outputData, this->numOutBands, width, yBlockSize * nYBlocks, remainRows);
                     }
+                    writeTimer.addBytes(sizeof(double)*this->numOutBands*((size_t)width)*remainRows);
                 }
-				
-				for(int n = 0; n < this->numOutBands; n++)
-				{
-                    rowOffset = (yBlockSize * nYBlocks);
-					outputRasterBands[n]->RasterIO(GF_Write, 0, rowOffset, width, remainRows, outputData[n], width, remainRows, GDT_Float64, 0, 0);
-				}
+    			pbar.finish();
             }
-			pbar.finish();
 		}
 		catch(RSGISImageCalcException& e)
 		{
@@ -299,6 +436,7 @@ namespace rsgis{namespace img{
 			{
 				delete[] outputRasterBands;
 			}
+			
 			throw e;
 		}
 		catch(RSGISImageBandException& e)
@@ -375,10 +513,53 @@ namespace rsgis{namespace img{
 			{
 				delete[] outputRasterBands;
 			}
+			
 			throw e;
 		}
 		
-		GDALClose(outputImageDS);
+		this->outputSinks.clear();
+		if(statsSink)
+		{
+			try
+			{
+				statsSink->finish();
+			}
+			catch(RSGISImageBandException &e)
+			{
+				statsSink.reset();
+				if(!cogWriter)
+				{
+					GDALClose(outputImageDS);
+				}
+				throw RSGISImageCalcException(e.what());
+			}
+			statsSink.reset();
+		}
+		if(cogWriter)
+		{
+			try
+			{
+				cogWriter->finish();
+			}
+			catch(RSGISImageBandException &e)
+			{
+				throw RSGISImageCalcException(e.what());
+			}
+			cogWriter.reset();
+		}
+		else
+		{
+			if(resumed && this->calcOutputStats)
+			{
+				RSGISPopWithStats popWithStats;
+				popWithStats.calcPopStats(outputImageDS, this->outputStatsUseNoData, this->outputStatsNoDataVal, this->calcOutputPyramids);
+			}
+			GDALClose(outputImageDS);
+		}
+		if(checkpoint)
+		{
+			checkpoint->finish();
+		}
 		
 		if(gdalTranslation != NULL)
 		{
@@ -456,62 +637,69 @@ namespace rsgis{namespace img{
     
     
     
-    void RSGISCalcImage::calcImage(GDALDataset **datasets, int numDS, std::string outputImage, std::string outputRefIntImage, std::string gdalFormat, GDALDataType gdalDataType)
+    void RSGISCalcImage::calcImageTile(GDALDataset **datasets, int numDS, std::string outputImage, int xOff, int yOff, int tileWidth, int tileHeight, bool setOutNames, std::string *bandNames, std::string gdalFormat, GDALDataType gdalDataType)
     {
         GDALAllRegister();
         RSGISImageUtils imgUtils;
-        double *gdalTranslation = new double[6];
-        int **dsOffsets = new int*[numDS];
+        double gdalTranslation[6];
+        std::vector<int> dsOffsetVals(numDS * 2, 0);
+        std::vector<int*> dsOffsets(numDS);
         for(int i = 0; i < numDS; i++)
         {
-            dsOffsets[i] = new int[2];
+            dsOffsets[i] = &dsOffsetVals[i * 2];
         }
-        int **bandOffsets = NULL;
-        int height = 0;
         int width = 0;
-        int numInBands = 0;
+        int height = 0;
         int xBlockSize = 0;
         int yBlockSize = 0;
+        imgUtils.getImageOverlap(datasets, numDS, dsOffsets.data(), &width, &height, gdalTranslation, &xBlockSize, &yBlockSize);
+        if((xOff < 0) || (yOff < 0) || (tileWidth <= 0) || (tileHeight <= 0) || ((xOff + tileWidth) > width) || ((yOff + tileHeight) > height))
+        {
+            throw RSGISImageCalcException("The tile is not within the overlap of the input images.");
+        }
+        if(RSGISCOGWriter::isCOGFormat(gdalFormat))
+        {
+            throw RSGISImageCalcException("Tiles cannot be written as COG, use a format such as GTiff.");
+        }
         
-        float **inputData = NULL;
-        double **outputData = NULL;
-        double *outputRefData = NULL;
-        float *inDataColumn = NULL;
-        double *outDataColumn = NULL;
-        double outRefData = 0;
-        
-        GDALDataset *outputImageDS = NULL;
-        GDALDataset *outputRefImageDS = NULL;
-        GDALRasterBand **inputRasterBands = NULL;
-        GDALRasterBand **outputRasterBands = NULL;
-        GDALRasterBand *outputRefRasterBand = NULL;
-        GDALDriver *gdalDriver = NULL;
+        // The tile is a window of the grid calcImage would write so the geotransform is shifted to its corner.
+        gdalTranslation[0] += (xOff * gdalTranslation[1]) + (yOff * gdalTranslation[2]);
+        gdalTranslation[3] += (xOff * gdalTranslation[4]) + (yOff * gdalTranslation[5]);
         
-        try
+        std::vector<GDALRasterBand*> inputRasterBands;
+        std::vector<int> bandOffsetVals;
+        for(int i = 0; i < numDS; i++)
         {
-            // Find image overlap
-            imgUtils.getImageOverlap(datasets, numDS, dsOffsets, &width, &height, gdalTranslation, &xBlockSize, &yBlockSize);
-            
-            // Count number of image bands
-            for(int i = 0; i < numDS; i++)
-            {
-                numInBands += datasets[i]->GetRasterCount();
-            }
-            
-            // Create new Image
-            gdalDriver = GetGDALDriverManager()->GetDriverByName(gdalFormat.c_str());
-            if(gdalDriver == NULL)
-            {
-                throw RSGISImageBandException("Requested GDAL driver does not exists..");
-            }
-            char **papszOptions = imgUtils.getGDALCreationOptionsForFormat(gdalFormat);
-            std::cout << "New image width = " << width << " height = " << height << " bands = " << this->numOutBands << std::endl;
-            
-            outputImageDS = gdalDriver->Create(outputImage.c_str(), width, height, this->numOutBands, gdalDataType, papszOptions);
-            if(outputImageDS == NULL)
+            for(int j = 0; j < datasets[i]->GetRasterCount(); j++)
             {
-                throw RSGISImageBandException("Output image could not be created. Check filepath.");
+                inputRasterBands.push_back(datasets[i]->GetRasterBand(j+1));
+                bandOffsetVals.push_back(dsOffsets[i][0] + xOff);
+                bandOffsetVals.push_back(dsOffsets[i][1] + yOff);
             }
+        }
+        int numInBands = inputRasterBands.size();
+        std::vector<int*> bandOffsets(numInBands);
+        for(int n = 0; n < numInBands; n++)
+        {
+            bandOffsets[n] = &bandOffsetVals[n * 2];
+        }
+        
+        GDALDriver *gdalDriver = GetGDALDriverManager()->GetDriverByName(gdalFormat.c_str());
+        if(gdalDriver == NULL)
+        {
+            throw RSGISImageCalcException("Requested GDAL driver does not exists..");
+        }
+        char **papszOptions = imgUtils.getGDALCreationOptionsForFormat(gdalFormat);
+        RSGISDatasetCache::invalidate(outputImage);
+        GDALDataset *outputImageDS = gdalDriver->Create(outputImage.c_str(), tileWidth, tileHeight, this->numOutBands, gdalDataType, papszOptions);
+        CSLDestroy(papszOptions);
+        if(outputImageDS == NULL)
+        {
+            throw RSGISImageCalcException("Output image could not be created. Check filepath.");
+        }
+        
+        try
+        {
             outputImageDS->SetGeoTransform(gdalTranslation);
             if(useImageProj)
             {
@@ -522,23 +710,298 @@ namespace rsgis{namespace img{
                 outputImageDS->SetProjection(proj.c_str());
             }
             
-            outputRefImageDS = gdalDriver->Create(outputRefIntImage.c_str(), width, height, 1, GDT_UInt32, papszOptions);
-            if(outputRefImageDS == NULL)
+            std::vector<GDALRasterBand*> outputRasterBands(this->numOutBands);
+            for(int i = 0; i < this->numOutBands; i++)
             {
-                throw RSGISImageBandException("Output reference image could not be created. Check filepath.");
+                outputRasterBands[i] = outputImageDS->GetRasterBand(i+1);
+                if(setOutNames)
+                {
+                    outputRasterBands[i]->SetDescription(bandNames[i].c_str());
+                }
             }
-            outputRefImageDS->SetGeoTransform(gdalTranslation);
-            if(useImageProj)
+            int outXBlockSize = 0;
+            int outYBlockSize = 0;
+            outputRasterBands[0]->GetBlockSize(&outXBlockSize, &outYBlockSize);
+            if(outYBlockSize > yBlockSize)
             {
-                outputRefImageDS->SetProjection(datasets[0]->GetProjectionRef());
+                yBlockSize = outYBlockSize;
             }
-            else
+            
+            RSGISImageBlockPlan blockPlan = this->planBlocks(inputRasterBands.data(), numInBands, outputRasterBands.data(), tileWidth, tileHeight, yBlockSize);
+            yBlockSize = blockPlan.rows;
+            RSGISGDALCacheScope gdalCacheScope(blockPlan.gdalCacheBytes);
+            
+            // The multi-threaded path also serves as the fallback as with a
+            // single worker it processes the blocks in order.
+            if((!this->useMultiThreaded()) && this->canPipelineIO(inputRasterBands.data(), numInBands, outputRasterBands.data()))
             {
-                outputRefImageDS->SetProjection(proj.c_str());
+                this->calcImageBlocksPipelined(inputRasterBands.data(), bandOffsets.data(), numInBands, outputRasterBands.data(), tileWidth, tileHeight, yBlockSize);
             }
-            
-            // Get Image Input Bands
-            bandOffsets = new int*[numInBands];
+            else if(this->useMultiThreaded() || (!this->calcImageBlocksNativeTypes(inputRasterBands.data(), bandOffsets.data(), numInBands, outputRasterBands.data(), tileWidth, tileHeight, yBlockSize)))
+            {
+                this->calcImageBlocksMultiThreaded(inputRasterBands.data(), bandOffsets.data(), numInBands, outputRasterBands.data(), tileWidth, tileHeight, yBlockSize);
+            }
+        }
+        catch(RSGISImageException &e)
+        {
+            GDALClose(outputImageDS);
+            throw;
+        }
+        GDALClose(outputImageDS);
+    }
+    
+    
+    
+    void RSGISCalcImage::calcImageQuickLook(GDALDataset **datasets, int numDS, std::string outputImage, unsigned int factor, bool setOutNames, std::string *bandNames, std::string gdalFormat, GDALDataType gdalDataType)
+    {
+        GDALAllRegister();
+        RSGISImageUtils imgUtils;
+        double gdalTranslation[6];
+        std::vector<int> dsOffsetVals(numDS * 2, 0);
+        std::vector<int*> dsOffsets(numDS);
+        for(int i = 0; i < numDS; i++)
+        {
+            dsOffsets[i] = &dsOffsetVals[i * 2];
+        }
+        int width = 0;
+        int height = 0;
+        int xBlockSize = 0;
+        int yBlockSize = 0;
+        imgUtils.getImageOverlap(datasets, numDS, dsOffsets.data(), &width, &height, gdalTranslation, &xBlockSize, &yBlockSize);
+        if(factor == 0)
+        {
+            factor = 1;
+        }
+        
+        // The last quick look pixel may cover fewer than factor input pixels
+        // so the pixel size is that of the whole overlap over the reduced grid.
+        int qlWidth = std::max<int>((width + factor - 1) / factor, 1);
+        int qlHeight = std::max<int>((height + factor - 1) / factor, 1);
+        double xScale = ((double)width) / qlWidth;
+        double yScale = ((double)height) / qlHeight;
+        gdalTranslation[1] *= xScale;
+        gdalTranslation[2] *= yScale;
+        gdalTranslation[4] *= xScale;
+        gdalTranslation[5] *= yScale;
+        
+        std::vector<GDALRasterBand*> inputRasterBands;
+        std::vector<int> bandXOffs;
+        std::vector<int> bandYOffs;
+        for(int i = 0; i < numDS; i++)
+        {
+            for(int j = 0; j < datasets[i]->GetRasterCount(); j++)
+            {
+                inputRasterBands.push_back(datasets[i]->GetRasterBand(j+1));
+                bandXOffs.push_back(dsOffsets[i][0]);
+                bandYOffs.push_back(dsOffsets[i][1]);
+            }
+        }
+        int numInBands = inputRasterBands.size();
+        
+        if(RSGISCOGWriter::isCOGFormat(gdalFormat))
+        {
+            std::cout << "The quick look is written as a GeoTIFF rather than a COG." << std::endl;
+            gdalFormat = "GTiff";
+        }
+        GDALDriver *gdalDriver = GetGDALDriverManager()->GetDriverByName(gdalFormat.c_str());
+        if(gdalDriver == NULL)
+        {
+            throw RSGISImageCalcException("Requested GDAL driver does not exists..");
+        }
+        std::cout << "Quick look (1/" << factor << ") width = " << qlWidth << " height = " << qlHeight << " bands = " << this->numOutBands << std::endl;
+        char **papszOptions = imgUtils.getGDALCreationOptionsForFormat(gdalFormat);
+        RSGISDatasetCache::invalidate(outputImage);
+        GDALDataset *outputImageDS = gdalDriver->Create(outputImage.c_str(), qlWidth, qlHeight, this->numOutBands, gdalDataType, papszOptions);
+        CSLDestroy(papszOptions);
+        if(outputImageDS == NULL)
+        {
+            throw RSGISImageCalcException("Output image could not be created. Check filepath.");
+        }
+        
+        std::vector<float*> inputData(numInBands, NULL);
+        std::vector<double*> outputData(this->numOutBands, NULL);
+        try
+        {
+            // Tagged so the quick look cannot be mistaken for a full resolution output.
+            outputImageDS->SetMetadataItem("RSGISLIB_QUICKLOOK_FACTOR", std::to_string(factor).c_str());
+            outputImageDS->SetGeoTransform(gdalTranslation);
+            if(useImageProj)
+            {
+                outputImageDS->SetProjection(datasets[0]->GetProjectionRef());
+            }
+            else
+            {
+                outputImageDS->SetProjection(proj.c_str());
+            }
+            
+            std::vector<GDALRasterBand*> outputRasterBands(this->numOutBands);
+            for(int i = 0; i < this->numOutBands; i++)
+            {
+                outputRasterBands[i] = outputImageDS->GetRasterBand(i+1);
+                if(setOutNames)
+                {
+                    outputRasterBands[i]->SetDescription(bandNames[i].c_str());
+                }
+            }
+            int outXBlockSize = 0;
+            int outYBlockSize = 0;
+            outputRasterBands[0]->GetBlockSize(&outXBlockSize, &outYBlockSize);
+            RSGISImageBlockPlan blockPlan = this->planBlocks(inputRasterBands.data(), numInBands, outputRasterBands.data(), qlWidth, qlHeight, std::max(outYBlockSize, 1), true);
+            int qlBlockRows = blockPlan.rows;
+            RSGISGDALCacheScope gdalCacheScope(blockPlan.gdalCacheBytes);
+            
+            size_t numPxlsInBlock = ((size_t)qlWidth)*qlBlockRows;
+            for(int n = 0; n < numInBands; n++)
+            {
+                inputData[n] = (float *) CPLMalloc(sizeof(float)*numPxlsInBlock);
+            }
+            for(int n = 0; n < this->numOutBands; n++)
+            {
+                outputData[n] = (double *) CPLMalloc(sizeof(double)*numPxlsInBlock);
+            }
+            
+            rsgis_tqdm pbar;
+            for(int qlRow = 0; qlRow < qlHeight; qlRow += qlBlockRows)
+            {
+                int nRows = std::min(qlBlockRows, qlHeight - qlRow);
+                // The input rows covered by the block of quick look rows.
+                int inRowStart = (int)floor(qlRow * yScale);
+                int inRowEnd = std::min((int)floor((qlRow + nRows) * yScale), height);
+                pbar.progress(qlRow, qlHeight);
+                
+                rsgis::RSGISScopedTimer readTimer("calcimage.read");
+                for(int n = 0; n < numInBands; n++)
+                {
+                    inputRasterBands[n]->RasterIO(GF_Read, bandXOffs[n], bandYOffs[n] + inRowStart, width, (inRowEnd - inRowStart), inputData[n], qlWidth, nRows, GDT_Float32, 0, 0);
+                }
+                readTimer.addBytes(sizeof(float)*numInBands*((size_t)qlWidth)*nRows);
+                readTimer.stop();
+                
+                rsgis::RSGISScopedTimer calcTimer("calcimage.compute");
+                calcTimer.addCount(((size_t)qlWidth)*nRows);
+                this->calc->calcImageBlock(inputData.data(), numInBands, ((size_t)qlWidth)*nRows, outputData.data());
+                calcTimer.stop();
+                
+                rsgis::RSGISScopedTimer writeTimer("calcimage.write");
+                writeTimer.addBytes(sizeof(double)*this->numOutBands*((size_t)qlWidth)*nRows);
+                for(int n = 0; n < this->numOutBands; n++)
+                {
+                    outputRasterBands[n]->RasterIO(GF_Write, 0, qlRow, qlWidth, nRows, outputData[n], qlWidth, nRows, GDT_Float64, 0, 0);
+                }
+            }
+            pbar.finish();
+        }
+        catch(...)
+        {
+            for(std::vector<float*>::iterator iterData = inputData.begin(); iterData != inputData.end(); ++iterData)
+            {
+                CPLFree(*iterData);
+            }
+            for(std::vector<double*>::iterator iterData = outputData.begin(); iterData != outputData.end(); ++iterData)
+            {
+                CPLFree(*iterData);
+            }
+            GDALClose(outputImageDS);
+            throw;
+        }
+        for(std::vector<float*>::iterator iterData = inputData.begin(); iterData != inputData.end(); ++iterData)
+        {
+            CPLFree(*iterData);
+        }
+        for(std::vector<double*>::iterator iterData = outputData.begin(); iterData != outputData.end(); ++iterData)
+        {
+            CPLFree(*iterData);
+        }
+        GDALClose(outputImageDS);
+    }
+    
+    
+    
+    void RSGISCalcImage::calcImage(GDALDataset **datasets, int numDS, std::string outputImage, std::string outputRefIntImage, std::string gdalFormat, GDALDataType gdalDataType)
+    {
+        GDALAllRegister();
+        RSGISImageUtils imgUtils;
+        double *gdalTranslation = new double[6];
+        int **dsOffsets = new int*[numDS];
+        for(int i = 0; i < numDS; i++)
+        {
+            dsOffsets[i] = new int[2];
+        }
+        int **bandOffsets = NULL;
+        int height = 0;
+        int width = 0;
+        int numInBands = 0;
+        int xBlockSize = 0;
+        int yBlockSize = 0;
+        
+        float **inputData = NULL;
+        double **outputData = NULL;
+        double *outputRefData = NULL;
+        float *inDataColumn = NULL;
+        double *outDataColumn = NULL;
+        double outRefData = 0;
+        
+        GDALDataset *outputImageDS = NULL;
+        GDALDataset *outputRefImageDS = NULL;
+        GDALRasterBand **inputRasterBands = NULL;
+        GDALRasterBand **outputRasterBands = NULL;
+        GDALRasterBand *outputRefRasterBand = NULL;
+        GDALDriver *gdalDriver = NULL;
+        
+        try
+        {
+            // Find image overlap
+            imgUtils.getImageOverlap(datasets, numDS, dsOffsets, &width, &height, gdalTranslation, &xBlockSize, &yBlockSize);
+            
+            // Count number of image bands
+            for(int i = 0; i < numDS; i++)
+            {
+                numInBands += datasets[i]->GetRasterCount();
+            }
+            
+            // Create new Image
+            gdalDriver = GetGDALDriverManager()->GetDriverByName(gdalFormat.c_str());
+            if(gdalDriver == NULL)
+            {
+                throw RSGISImageBandException("Requested GDAL driver does not exists..");
+            }
+            char **papszOptions = imgUtils.getGDALCreationOptionsForFormat(gdalFormat);
+            std::cout << "New image width = " << width << " height = " << height << " bands = " << this->numOutBands << std::endl;
+            
+            RSGISDatasetCache::invalidate(outputImage);
+            outputImageDS = gdalDriver->Create(outputImage.c_str(), width, height, this->numOutBands, gdalDataType, papszOptions);
+            if(outputImageDS == NULL)
+            {
+                throw RSGISImageBandException("Output image could not be created. Check filepath.");
+            }
+            outputImageDS->SetGeoTransform(gdalTranslation);
+            if(useImageProj)
+            {
+                outputImageDS->SetProjection(datasets[0]->GetProjectionRef());
+            }
+            else
+            {
+                outputImageDS->SetProjection(proj.c_str());
+            }
+            
+            RSGISDatasetCache::invalidate(outputRefIntImage);
+            outputRefImageDS = gdalDriver->Create(outputRefIntImage.c_str(), width, height, 1, GDT_UInt32, papszOptions);
+            if(outputRefImageDS == NULL)
+            {
+                throw RSGISImageBandException("Output reference image could not be created. Check filepath.");
+            }
+            outputRefImageDS->SetGeoTransform(gdalTranslation);
+            if(useImageProj)
+            {
+                outputRefImageDS->SetProjection(datasets[0]->GetProjectionRef());
+            }
+            else
+            {
+                outputRefImageDS->SetProjection(proj.c_str());
+            }
+            
+            // Get Image Input Bands
+            bandOffsets = new int*[numInBands];
             inputRasterBands = new GDALRasterBand*[numInBands];
             int counter = 0;
             for(int i = 0; i < numDS; i++)
@@ -1000,99 +1463,99 @@ namespace rsgis{namespace img{
                 yBlockSize = outYBlockSize;
             }
             
-			// Allocate memory
-			inputData = new float*[numInBands];
-			for(int i = 0; i < numInBands; i++)
-			{
-				inputData[i] = (float *) CPLMalloc(sizeof(float)*width*yBlockSize);
-			}
-			inDataColumn = new float[numInBands];
-            
-			outputData = new double*[this->numOutBands];
-			for(int i = 0; i < this->numOutBands; i++)
-			{
-				outputData[i] = (double *) CPLMalloc(sizeof(double)*width*yBlockSize);
-			}
-			outDataColumn = new double[this->numOutBands];
+            RSGISImageBlockPlan blockPlan = this->planBlocks(inputRasterBands, numInBands, outputRasterBands, width, height, yBlockSize);
+            yBlockSize = blockPlan.rows;
+            RSGISGDALCacheScope gdalCacheScope(blockPlan.gdalCacheBytes);
             
-			int nYBlocks = height / yBlockSize;
-            int remainRows = height - (nYBlocks * yBlockSize);
-            int rowOffset = 0;
+            if(this->skipEmptyBlocks)
+            {
+                this->prepareSkipEmptyBlocks(outputRasterBands, width, height);
+            }
             
-			rsgis_tqdm pbar;
-			// Loop images to process data
-			for(int i = 0; i < nYBlocks; i++)
-			{
-				for(int n = 0; n < numInBands; n++)
-				{
-                    rowOffset = bandOffsets[n][1] + (yBlockSize * i);
-					inputRasterBands[n]->RasterIO(GF_Read, bandOffsets[n][0], rowOffset, width, yBlockSize, inputData[n], width, yBlockSize, GDT_Float32, 0, 0);
-				}
-                
-                for(int m = 0; m < yBlockSize; ++m)
+            if(this->useMultiThreaded() || (this->skipEmptyBlocks && !this->canPipelineIO(inputRasterBands, numInBands, outputRasterBands)))
+            {
+                this->calcImageBlocksMultiThreaded(inputRasterBands, bandOffsets, numInBands, outputRasterBands, width, height, yBlockSize);
+            }
+            else if(this->canPipelineIO(inputRasterBands, numInBands, outputRasterBands))
+            {
+                this->calcImageBlocksPipelined(inputRasterBands, bandOffsets, numInBands, outputRasterBands, width, height, yBlockSize);
+            }
+            else if(!this->calcImageBlocksNativeTypes(inputRasterBands, bandOffsets, numInBands, outputRasterBands, width, height, yBlockSize))
+            {
+                // Allocate memory
+                inputData = new float*[numInBands];
+                for(int i = 0; i < numInBands; i++)
                 {
-                    pbar.progress((i*yBlockSize)+m, height);
-                    
-                    for(int j = 0; j < width; j++)
-                    {
-                        for(int n = 0; n < numInBands; n++)
-                        {
-                            inDataColumn[n] = inputData[n][(m*width)+j];
-                        }
-                        
-                        this->calc->calcImageValue(inDataColumn, numInBands, outDataColumn);
-                        
-                        for(int n = 0; n < this->numOutBands; n++)
-                        {
-                            outputData[n][(m*width)+j] = outDataColumn[n];
-                        }
-                        
-                    }
+                    inputData[i] = (float *) CPLMalloc(sizeof(float)*width*yBlockSize);
+                }
+                inDataColumn = new float[numInBands];
+
+                outputData = new double*[this->numOutBands];
+                for(int i = 0; i < this->numOutBands; i++)
+                {
+                    outputData[i] = (double *) CPLMalloc(sizeof(double)*width*yBlockSize);
                 }
+                outDataColumn = new double[this->numOutBands];
+                
+    			int nYBlocks = height / yBlockSize;
+                int remainRows = height - (nYBlocks * yBlockSize);
+                int rowOffset = 0;
+            
+    			rsgis_tqdm pbar;
+    			// Loop images to process data
+    			for(int i = 0; i < nYBlocks; i++)
+    			{
+    				rsgis::RSGISScopedTimer readTimer("calcimage.read");
+    				for(int n = 0; n < numInBands; n++)
+    				{
+                        rowOffset = bandOffsets[n][1] + (yBlockSize * i);
+    					inputRasterBands[n]->RasterIO(GF_Read, bandOffsets[n][0], rowOffset, width, yBlockSize, inputData[n], width, yBlockSize, GDT_Float32, 0, 0);
+    				}
+                    readTimer.addBytes(sizeof(float)*numInBands*((size_t)width)*yBlockSize);
+                    readTimer.stop();
+                
+                    pbar.progress(i*yBlockSize, height);
+                    rsgis::RSGISScopedTimer calcTimer("calcimage.compute");
+                    calcTimer.addCount(((size_t)width)*yBlockSize);
+                    this->calc->calcImageBlock(inputData, numInBands, ((size_t)width)*yBlockSize, outputData);
+                    calcTimer.stop();
 				
-				for(int n = 0; n < this->numOutBands; n++)
-				{
-                    rowOffset = yBlockSize * i;
-					outputRasterBands[n]->RasterIO(GF_Write, 0, rowOffset, width, yBlockSize, outputData[n], width, yBlockSize, GDT_Float64, 0, 0);
-				}
-			}
+                    rsgis::RSGISScopedTimer writeTimer("calcimage.write");
+    				for(int n = 0; n < this->numOutBands; n++)
+    				{
+                        rowOffset = yBlockSize * i;
+    					outputRasterBands[n]->RasterIO(GF_Write, 0, rowOffset, width, yBlockSize, outputData[n], width, yBlockSize, GDT_Float64, 0, 0);
+    				}
+                    writeTimer.addBytes(sizeof(double)*this->numOutBands*((size_t)width)*yBlockSize);
+    			}
             
-            if(remainRows > 0)
-            {
-                for(int n = 0; n < numInBands; n++)
-				{
-                    rowOffset = bandOffsets[n][1] + (yBlockSize * nYBlocks);
-					inputRasterBands[n]->RasterIO(GF_Read, bandOffsets[n][0], rowOffset, width, remainRows, inputData[n], width, remainRows, GDT_Float32, 0, 0);
-				}
-                
-                for(int m = 0; m < remainRows; ++m)
+                if(remainRows > 0)
                 {
-                    pbar.progress((nYBlocks*yBlockSize)+m, height);
-                    
-                    for(int j = 0; j < width; j++)
-                    {
-                        for(int n = 0; n < numInBands; n++)
-                        {
-                            inDataColumn[n] = inputData[n][(m*width)+j];
-                        }
-                        
-                        this->calc->calcImageValue(inDataColumn, numInBands, outDataColumn);
-                        
-                        for(int n = 0; n < this->numOutBands; n++)
-                        {
-                            outputData[n][(m*width)+j] = outDataColumn[n];
-                        }
-                        
-                    }
-                }
+                    rsgis::RSGISScopedTimer readTimer("calcimage.read");
+                    for(int n = 0; n < numInBands; n++)
+    				{
+                        rowOffset = bandOffsets[n][1] + (yBlockSize * nYBlocks);
+    					inputRasterBands[n]->RasterIO(GF_Read, bandOffsets[n][0], rowOffset, width, remainRows, inputData[n], width, remainRows, GDT_Float32, 0, 0);
+    				}
+                    readTimer.addBytes(sizeof(float)*numInBands*((size_t)width)*remainRows);
+                    readTimer.stop();
+                
+                    pbar.progress(nYBlocks*yBlockSize, height);
+                    rsgis::RSGISScopedTimer calcTimer("calcimage.compute");
+                    calcTimer.addCount(((size_t)width)*remainRows);
+                    this->calc->calcImageBlock(inputData, numInBands, ((size_t)width)*remainRows, outputData);
+                    calcTimer.stop();
 				
-				for(int n = 0; n < this->numOutBands; n++)
-				{
-                    rowOffset = (yBlockSize * nYBlocks);
-					outputRasterBands[n]->RasterIO(GF_Write, 0, rowOffset, width, remainRows, outputData[n], width, remainRows, GDT_Float64, 0, 0);
-				}
+                    rsgis::RSGISScopedTimer writeTimer("calcimage.write");
+    				for(int n = 0; n < this->numOutBands; n++)
+    				{
+                        rowOffset = (yBlockSize * nYBlocks);
+    					outputRasterBands[n]->RasterIO(GF_Write, 0, rowOffset, width, remainRows, outputData[n], width, remainRows, GDT_Float64, 0, 0);
+    				}
+                    writeTimer.addBytes(sizeof(double)*this->numOutBands*((size_t)width)*remainRows);
+                }
+    			pbar.finish();
             }
-			pbar.finish();
 		}
 		catch(RSGISImageCalcException& e)
 		{			
@@ -1321,6 +1784,68 @@ namespace rsgis{namespace img{
 		}
 	}
     
+    void RSGISCalcImage::calcImage(GDALDataset **datasets, int numDS, GDALDataset **outputImageDSs, int numOutDS)
+    {
+        GDALAllRegister();
+        RSGISImageUtils imgUtils;
+        double gdalTranslation[6];
+        std::vector<int> dsOffsetVals(numDS * 2, 0);
+        std::vector<int*> dsOffsets(numDS);
+        for(int i = 0; i < numDS; i++)
+        {
+            dsOffsets[i] = &dsOffsetVals[i * 2];
+        }
+        int width = 0;
+        int height = 0;
+        int xBlockSize = 0;
+        int yBlockSize = 0;
+        imgUtils.getImageOverlap(datasets, numDS, dsOffsets.data(), &width, &height, gdalTranslation, &xBlockSize, &yBlockSize);
+        
+        std::vector<GDALRasterBand*> inputRasterBands;
+        std::vector<int*> bandOffsets;
+        for(int i = 0; i < numDS; i++)
+        {
+            for(int j = 0; j < datasets[i]->GetRasterCount(); j++)
+            {
+                inputRasterBands.push_back(datasets[i]->GetRasterBand(j+1));
+                bandOffsets.push_back(dsOffsets[i]);
+            }
+        }
+        int numInBands = inputRasterBands.size();
+        
+        // The output bands are those of the output datasets in order.
+        std::vector<GDALRasterBand*> outputRasterBands;
+        for(int i = 0; i < numOutDS; i++)
+        {
+            if((outputImageDSs[i]->GetRasterXSize() != width) || (outputImageDSs[i]->GetRasterYSize() != height))
+            {
+                throw RSGISImageCalcException("The output datasets must be the size of the overlap of the input images.");
+            }
+            for(int j = 0; j < outputImageDSs[i]->GetRasterCount(); j++)
+            {
+                outputRasterBands.push_back(outputImageDSs[i]->GetRasterBand(j+1));
+            }
+        }
+        if((outputRasterBands.size() != ((size_t)this->numOutBands)) || (this->numOutBands == 0))
+        {
+            throw RSGISImageCalcException("The output datasets do not have the correct number of image bands.");
+        }
+        int outXBlockSize = 0;
+        int outYBlockSize = 0;
+        outputRasterBands[0]->GetBlockSize(&outXBlockSize, &outYBlockSize);
+        if(outYBlockSize > yBlockSize)
+        {
+            yBlockSize = outYBlockSize;
+        }
+        
+        RSGISImageBlockPlan blockPlan = this->planBlocks(inputRasterBands.data(), numInBands, outputRasterBands.data(), width, height, yBlockSize);
+        yBlockSize = blockPlan.rows;
+        RSGISGDALCacheScope gdalCacheScope(blockPlan.gdalCacheBytes);
+        
+        // With a single worker the multi-threaded path processes the blocks in order.
+        this->calcImageBlocksMultiThreaded(inputRasterBands.data(), bandOffsets.data(), numInBands, outputRasterBands.data(), width, height, yBlockSize);
+    }
+    
     void RSGISCalcImage::calcImagePartialOutput(GDALDataset **datasets, int numDS, GDALDataset *outputImageDS)
     {
         GDALAllRegister();
@@ -1784,6 +2309,7 @@ namespace rsgis{namespace img{
             char **papszOptions = imgUtils.getGDALCreationOptionsForFormat(gdalFormat);
 			std::cout << "New image width = " << width << " height = " << height << " bands = " << this->numOutBands << std::endl;
 			
+			RSGISDatasetCache::invalidate(outputImage);
 			outputImageDS = gdalDriver->Create(outputImage.c_str(), width, height, this->numOutBands, gdalDataType, papszOptions);
 			
 			if(outputImageDS == NULL)
@@ -2372,6 +2898,7 @@ namespace rsgis{namespace img{
             char **papszOptions = imgUtils.getGDALCreationOptionsForFormat(gdalFormat);
             std::cout << "New image width = " << width << " height = " << height << " bands = " << this->numOutBands << std::endl;
             
+            RSGISDatasetCache::invalidate(outputImage);
             outputImageDS = gdalDriver->Create(outputImage.c_str(), width, height, this->numOutBands, gdalDataType, papszOptions);
             if(outputImageDS == NULL)
             {
@@ -2387,6 +2914,7 @@ namespace rsgis{namespace img{
                 outputImageDS->SetProjection(proj.c_str());
             }
             
+            RSGISDatasetCache::invalidate(outputRefIntImage);
             outputRefImageDS = gdalDriver->Create(outputRefIntImage.c_str(), width, height, 1, GDT_UInt32, papszOptions);
             if(outputRefImageDS == NULL)
             {
@@ -3957,6 +4485,7 @@ namespace rsgis{namespace img{
         int yBlockSize = 0;
 		
 		GDALRasterBand **inputRasterBands = NULL;
+		std::unique_ptr<RSGISCalcImageCheckpoint> checkpoint;
 		
 		try
 		{
@@ -3964,9 +4493,11 @@ namespace rsgis{namespace img{
 			imgUtils.getImageOverlap(datasets, numDS, dsOffsets, &width, &height, gdalTranslation, &xBlockSize, &yBlockSize);
             
 			// Count number of image bands
+			std::vector<std::string> inputFiles;
 			for(int i = 0; i < numDS; i++)
 			{
 				numInBands += datasets[i]->GetRasterCount();
+				inputFiles.push_back(datasets[i]->GetDescription());
 			}
 			
 			// Get Image Input Bands
@@ -3985,6 +4516,27 @@ namespace rsgis{namespace img{
 				}
 			}
 			
+            RSGISImageBlockPlan blockPlan = this->planBlocks(inputRasterBands, numInBands, NULL, width, height, yBlockSize, true);
+            yBlockSize = blockPlan.rows;
+            RSGISGDALCacheScope gdalCacheScope(blockPlan.gdalCacheBytes);
+            
+            // Without an output image the checkpoint (of the calculator state) needs a file to be given.
+            int startBlock = 0;
+            if((this->checkpointSecs > 0) && (this->checkpointFile != ""))
+            {
+                checkpoint.reset(new RSGISCalcImageCheckpoint(this->checkpointFile, this->checkpointSecs));
+                if(this->checkpointResume && checkpoint->exists() && checkpoint->load(width, height, 0, GDT_Unknown, inputFiles, this->calc))
+                {
+                    yBlockSize = checkpoint->getBlockRows();
+                    startBlock = checkpoint->getBlocksDone();
+                    std::cout << "Resuming from row " << std::min(startBlock * yBlockSize, height) << " using the checkpoint." << std::endl;
+                }
+                else
+                {
+                    checkpoint->start(width, height, 0, GDT_Unknown, yBlockSize, inputFiles, this->calc);
+                }
+            }
+            
 			// Allocate memory
 			inputData = new float*[numInBands];
 			for(int i = 0; i < numInBands; i++)
@@ -3999,14 +4551,19 @@ namespace rsgis{namespace img{
             
 			rsgis_tqdm pbar;
 			// Loop images to process data
-			for(int i = 0; i < nYBlocks; i++)
+			for(int i = startBlock; i < nYBlocks; i++)
 			{
+				rsgis::RSGISScopedTimer readTimer("calcimage.read");
 				for(int n = 0; n < numInBands; n++)
 				{
                     rowOffset = bandOffsets[n][1] + (yBlockSize * i);
 					inputRasterBands[n]->RasterIO(GF_Read, bandOffsets[n][0], rowOffset, width, yBlockSize, inputData[n], width, yBlockSize, GDT_Float32, 0, 0);
 				}
+                readTimer.addBytes(sizeof(float)*numInBands*((size_t)width)*yBlockSize);
+                readTimer.stop();
                 
+                rsgis::RSGISScopedTimer calcTimer("calcimage.compute");
+                calcTimer.addCount(((size_t)width)*yBlockSize);
                 for(int m = 0; m < yBlockSize; ++m)
                 {
                     pbar.progress((i*yBlockSize)+m, height);
@@ -4020,17 +4577,26 @@ namespace rsgis{namespace img{
                         
                         this->calc->calcImageValue(inDataColumn, numInBands);
                     }
+                }
+                if(checkpoint && checkpoint->blockDone(i))
+                {
+                    checkpoint->write(NULL, this->calc);
                 }
 			}
             
-            if(remainRows > 0)
+            if((remainRows > 0) && (startBlock <= nYBlocks))
             {
+                rsgis::RSGISScopedTimer readTimer("calcimage.read");
                 for(int n = 0; n < numInBands; n++)
 				{
                     rowOffset = bandOffsets[n][1] + (yBlockSize * nYBlocks);
 					inputRasterBands[n]->RasterIO(GF_Read, bandOffsets[n][0], rowOffset, width, remainRows, inputData[n], width, remainRows, GDT_Float32, 0, 0);
 				}
+                readTimer.addBytes(sizeof(float)*numInBands*((size_t)width)*remainRows);
+                readTimer.stop();
                 
+                rsgis::RSGISScopedTimer calcTimer("calcimage.compute");
+                calcTimer.addCount(((size_t)width)*remainRows);
                 for(int m = 0; m < remainRows; ++m)
                 {
                     pbar.progress((nYBlocks*yBlockSize)+m, height);
@@ -4047,6 +4613,10 @@ namespace rsgis{namespace img{
                 }
             }
 			pbar.finish();
+            if(checkpoint)
+            {
+                checkpoint->finish();
+            }
 		}
 		catch(RSGISImageCalcException& e)
 		{
@@ -4256,6 +4826,7 @@ namespace rsgis{namespace img{
                 
                 std::cout << "New image width = " << width << " height = " << height << " bands = " << this->numOutBands << std::endl;
 				
+				RSGISDatasetCache::invalidate(outputImageFileName);
 				outputImageDS = gdalDriver->Create(outputImageFileName.c_str(), width, height, this->numOutBands, GDT_Float32, papszOptions);
 				
                 if(outputImageDS == NULL)
@@ -4493,6 +5064,7 @@ namespace rsgis{namespace img{
             char **papszOptions = imgUtils.getGDALCreationOptionsForFormat(gdalFormat);
 			std::cout << "New image width = " << width << " height = " << height << " bands = " << this->numOutBands << std::endl;
 			
+			RSGISDatasetCache::invalidate(outputImage);
 			outputImageDS = gdalDriver->Create(outputImage.c_str(), width, height, this->numOutBands, gdalDataType, papszOptions);
 			
 			if(outputImageDS == NULL)
@@ -5664,9 +6236,8 @@ namespace rsgis{namespace img{
             int remainRows = height - (nYBlocks * yBlockSize);
             int rowOffset = 0;
             
-            unsigned int xPxl = 0;
             unsigned int yPxl = 0;
-            geos::geom::Envelope extent;
+            std::vector<const float*> bandRows(numInBands);
 			rsgis_tqdm pbar;
 			// Loop images to process data
 			for(int i = 0; i < nYBlocks; i++)
@@ -5681,19 +6252,12 @@ namespace rsgis{namespace img{
                 {
                     pbar.progress((i*yBlockSize)+m, height);
                     
-                    xPxl = 0;
-                    for(int j = 0; j < width; j++)
+                    // The extent of each pixel is its position (x, x, y, y).
+                    for(int n = 0; n < numInBands; n++)
                     {
-                        for(int n = 0; n < numInBands; n++)
-                        {
-                            inDataColumn[n] = inputData[n][(m*width)+j];
-                        }
-                        
-                        extent.init(xPxl, xPxl, yPxl, yPxl);
-                        
-                        this->calc->calcImageValue(inDataColumn, numInBands, extent);
-                        ++xPxl;
+                        bandRows[n] = inputData[n] + (m*width);
                     }
+                    this->calc->calcImageRowExtent(bandRows.data(), numInBands, width, 0, yPxl, 1, 0, 0);
                     ++yPxl;
                 }
 			}
@@ -5710,19 +6274,12 @@ namespace rsgis{namespace img{
                 {
                     pbar.progress((nYBlocks*yBlockSize)+m, height);
                     
-                    xPxl = 0;
-                    for(int j = 0; j < width; j++)
+                    // The extent of each pixel is its position (x, x, y, y).
+                    for(int n = 0; n < numInBands; n++)
                     {
-                        for(int n = 0; n < numInBands; n++)
-                        {
-                            inDataColumn[n] = inputData[n][(m*width)+j];
-                        }
-                        
-                        extent.init(xPxl, xPxl, yPxl, yPxl);
-                        
-                        this->calc->calcImageValue(inDataColumn, numInBands, extent);
-                        ++xPxl;
+                        bandRows[n] = inputData[n] + (m*width);
                     }
+                    this->calc->calcImageRowExtent(bandRows.data(), numInBands, width, 0, yPxl, 1, 0, 0);
                     ++yPxl;
                 }
             }
@@ -6351,7 +6908,6 @@ namespace rsgis{namespace img{
 		
 		GDALRasterBand **inputRasterBands = NULL;
         
-        geos::geom::Envelope extent;
 		double pxlTLX = 0;
 		double pxlTLY = 0;
 		double pxlWidth = 0;
@@ -6427,21 +6983,8 @@ namespace rsgis{namespace img{
 					inputRasterBands[n]->RasterIO(GF_Read, bandOffsets[n][0], (bandOffsets[n][1]+i), width, 1, inputData[n], width, 1, GDT_Float32, 0, 0);
 				}
 
-                for(int j = 0; j < width; j++)
-				{
-                    for(int n = 0; n < numInBands; n++)
-					{
-						inDataColumn[n] = inputData[n][j];
-					}
-					
-					extent.init(pxlTLX, (pxlTLX+pxlWidth), pxlTLY, (pxlTLY-pxlHeight));
-					
-					this->calc->calcImageValue(inDataColumn, numInBands, extent);
-					
-					pxlTLX += pxlWidth;
-				}
+                this->calc->calcImageRowExtent(inputData, numInBands, width, pxlTLX, pxlTLY, pxlWidth, pxlWidth, pxlHeight);
 				pxlTLY -= pxlHeight;
-				pxlTLX = gdalTranslation[0];
 			}
             if(!quiet)
             {
@@ -7123,6 +7666,7 @@ namespace rsgis{namespace img{
 			}
             char **papszOptions = imgUtils.getGDALCreationOptionsForFormat(gdalFormat);
             
+			RSGISDatasetCache::invalidate(outputImage);
 			outputImageDS = gdalDriver->Create(outputImage.c_str(), width, height, this->numOutBands, gdalDataType, papszOptions);
 			
 			if(outputImageDS == NULL)
@@ -8333,9 +8877,7 @@ namespace rsgis{namespace img{
         int yBlockSize = 0;
         size_t numPxlsInBlock = 0;
 		
-        float **inputDataUpper = NULL;
-		float **inputDataMain = NULL;
-        float **inputDataLower = NULL;
+        RSGISImageRowRingBuffer *ringBuffer = NULL;
 		double **outputData = NULL;
 		float ***inDataBlock = NULL;
 		double *outDataColumn = NULL;
@@ -8355,7 +8897,6 @@ namespace rsgis{namespace img{
 			{
 				throw RSGISImageCalcException("Window size needs to be 3 or greater and an odd number.");
 			}
-			int windowMid = floor(((float)windowSize)/2.0); // Starting at 0!! NOT 1 otherwise would be ceil.
             
 			// Find image overlap
             imgUtils.getImageOverlap(datasets, numDS, dsOffsets, &width, &height, gdalTranslation, &xBlockSize, &yBlockSize);
@@ -8373,6 +8914,7 @@ namespace rsgis{namespace img{
 				throw RSGISImageBandException("Driver does not exists..");
 			}
             char **papszOptions = imgUtils.getGDALCreationOptionsForFormat(gdalFormat);
+			RSGISDatasetCache::invalidate(outputImage);
 			outputImageDS = gdalDriver->Create(outputImage.c_str(), width, height, this->numOutBands, gdalDataType, papszOptions);
 			
 			if(outputImageDS == NULL)
@@ -8421,53 +8963,27 @@ namespace rsgis{namespace img{
                 yBlockSize = outYBlockSize;
             }
             
-            int numOfLines = yBlockSize;
-            if(yBlockSize < windowSize)
-            {
-                numOfLines = ceil(((float)windowSize)/((float)yBlockSize))*yBlockSize;
-            }
+            // Each input row is read once into a ring of windowSize rows per band;
+            // the window then slides across the ring without copying.
+            ringBuffer = new RSGISImageRowRingBuffer(inputRasterBands, bandOffsets, numInBands, width, height, windowSize);
+            bool useWindowView = this->calc->useImageWindowView();
+            bool useWindowRows = this->calc->useImageWindowRows();
+            std::vector<double*> outRows(this->numOutBands);
             
 			// Allocate memory
-            numPxlsInBlock = width*numOfLines;
-			inputDataUpper = new float*[numInBands];
-			for(int i = 0; i < numInBands; i++)
-			{
-                inputDataUpper[i] = (float *) CPLMalloc(sizeof(float)*numPxlsInBlock);
-                for(int k = 0; k < numPxlsInBlock; k++)
-                {
-                    inputDataUpper[i][k] = 0;
-                }
-			}
-            
-            inputDataMain = new float*[numInBands];
-			for(int i = 0; i < numInBands; i++)
-			{
-                inputDataMain[i] = (float *) CPLMalloc(sizeof(float)*numPxlsInBlock);
-                for(int k = 0; k < numPxlsInBlock; k++)
-                {
-                    inputDataMain[i][k] = 0;
-                }
-			}
-            
-            inputDataLower = new float*[numInBands];
-			for(int i = 0; i < numInBands; i++)
-			{
-                inputDataLower[i] = (float *) CPLMalloc(sizeof(float)*numPxlsInBlock);
-                for(int k = 0; k < numPxlsInBlock; k++)
+            numPxlsInBlock = ((size_t)width)*yBlockSize;
+            if(!useWindowView && !useWindowRows)
+            {
+                inDataBlock = new float**[numInBands];
+                for(int i = 0; i < numInBands; i++)
                 {
-                    inputDataLower[i][k] = 0;
+                    inDataBlock[i] = new float*[windowSize];
+                    for(int j = 0; j < windowSize; j++)
+                    {
+                        inDataBlock[i][j] = new float[windowSize];
+                    }
                 }
-			}
-			
-			inDataBlock = new float**[numInBands];
-			for(int i = 0; i < numInBands; i++)
-			{
-				inDataBlock[i] = new float*[windowSize];
-				for(int j = 0; j < windowSize; j++)
-				{
-					inDataBlock[i][j] = new float[windowSize];
-				}
-			}
+            }
 			
 			outputData = new double*[this->numOutBands];
 			for(int i = 0; i < this->numOutBands; i++)
@@ -8476,800 +8992,139 @@ namespace rsgis{namespace img{
 			}
 			outDataColumn = new double[this->numOutBands];
 			
-            int nYBlocks = floor(((double)height) / ((double)numOfLines));
-            int remainRows = height - (nYBlocks * numOfLines);
-            int rowOffset = 0;
-            unsigned int line = 0;
-            long cLinePxl = 0;
-            long cPxl = 0;
-            long dLinePxls = 0;
-            int dWinX = 0;
-            int dWinY = 0;
+            int nYBlocks = floor(((double)height) / ((double)yBlockSize));
+            int remainRows = height - (nYBlocks * yBlockSize);
+            int numLinesInBlock = 0;
+            int line = 0;
+            size_t cPxl = 0;
             
             rsgis_tqdm pbar;
-            if(nYBlocks > 0)
+            for(int i = 0; i <= nYBlocks; i++)
             {
-                for(int i = 0; i < nYBlocks; i++)
+                numLinesInBlock = (i < nYBlocks)?yBlockSize:remainRows;
+                if(numLinesInBlock == 0)
                 {
-                    if(i == 0)
+                    break;
+                }
+                
+                for(int m = 0; m < numLinesInBlock; ++m)
+                {
+                    line = (i*yBlockSize)+m;
+                    pbar.progress(line, height);
+                    ringBuffer->moveToLine(line);
+                    
+                    cPxl = ((size_t)m)*width;
+                    if(useWindowRows)
                     {
-                        // Set Upper Block with Zeros.
-                        for(int n = 0; n < numInBands; n++)
-                        {
-                            for(int k = 0; k < numPxlsInBlock; k++)
-                            {
-                                inputDataUpper[n][k] = 0;
-                            }
-                        }
-                        
-                        // Read Main Block
-                        for(int n = 0; n < numInBands; n++)
-                        {
-                            rowOffset = bandOffsets[n][1] + (numOfLines * i);
-                            inputRasterBands[n]->RasterIO(GF_Read, bandOffsets[n][0], rowOffset, width, numOfLines, inputDataMain[n], width, numOfLines, GDT_Float32, 0, 0);
-                        }
-                        // Read Lower Block
-                        for(int n = 0; n < numInBands; n++)
+                        for(int n = 0; n < this->numOutBands; n++)
                         {
-                            if(nYBlocks == 1)
-                            {
-                                if(remainRows > 0)
-                                {
-                                    rowOffset = bandOffsets[n][1] + (numOfLines * (i+1));
-                                    inputRasterBands[n]->RasterIO(GF_Read, bandOffsets[n][0], rowOffset, width, remainRows, inputDataLower[n], width, remainRows, GDT_Float32, 0, 0);
-                                    for(int k = (remainRows*width); k < numPxlsInBlock; k++)
-                                    {
-                                        inputDataLower[n][k] = 0;
-                                    }
-                                }
-                                else
-                                {
-                                    for(int k = 0; k < numPxlsInBlock; k++)
-                                    {
-                                        inputDataLower[n][k] = 0;
-                                    }
-                                }
-                            }
-                            else
-                            {
-                                rowOffset = bandOffsets[n][1] + (numOfLines * (i+1));
-                                inputRasterBands[n]->RasterIO(GF_Read, bandOffsets[n][0], rowOffset, width, numOfLines, inputDataLower[n], width, numOfLines, GDT_Float32, 0, 0);
-                            }
+                            outRows[n] = outputData[n] + cPxl;
                         }
+                        this->calc->calcImageWindowRow(ringBuffer->getView(0), width, outRows.data());
+                        continue;
                     }
-                    else if(i == (nYBlocks-1))
+                    for(int j = 0; j < width; j++)
                     {
-                        // Shift Lower Block to Main Block
-                        for(int n = 0; n < numInBands; n++)
+                        const RSGISImageWindowView &window = ringBuffer->getView(j);
+                        if(useWindowView)
                         {
-                            for(int k = 0; k < numPxlsInBlock; k++)
-                            {
-                                inputDataUpper[n][k] = inputDataMain[n][k];
-                            }
+                            this->calc->calcImageWindowValue(window, outDataColumn);
                         }
-                        
-                        // Shift Lower Block to Main Block
-                        for(int n = 0; n < numInBands; n++)
+                        else
                         {
-                            for(int k = 0; k < numPxlsInBlock; k++)
-                            {
-                                inputDataMain[n][k] = inputDataLower[n][k];
-                            }
+                            window.copyTo(inDataBlock);
+                            this->calc->calcImageValue(inDataBlock, numInBands, windowSize, outDataColumn);
                         }
                         
-                        // Set Lower Block with Zeros.
-                        for(int n = 0; n < numInBands; n++)
+                        for(int n = 0; n < this->numOutBands; n++)
                         {
-                            if(remainRows > 0)
-                            {
-                                rowOffset = bandOffsets[n][1] + (numOfLines * (i+1));
-                                inputRasterBands[n]->RasterIO(GF_Read, bandOffsets[n][0], rowOffset, width, remainRows, inputDataLower[n], width, remainRows, GDT_Float32, 0, 0);
-                                for(int k = (remainRows*width); k < numPxlsInBlock; k++)
-                                {
-                                    inputDataLower[n][k] = 0;
-                                }
-                            }
-                            else
-                            {
-                                for(int k = 0; k < numPxlsInBlock; k++)
-                                {
-                                    inputDataLower[n][k] = 0;
-                                }
-                            }
+                            outputData[n][cPxl] = outDataColumn[n];
                         }
-                    }
-                    else
-                    {
-                        // Shift Lower Block to Main Block
-                        for(int n = 0; n < numInBands; n++)
-                        {
-                            for(int k = 0; k < numPxlsInBlock; k++)
-                            {
-                                inputDataUpper[n][k] = inputDataMain[n][k];
-                            }
-                        }
-                        
-                        // Shift Lower Block to Main Block
-                        for(int n = 0; n < numInBands; n++)
-                        {
-                            for(int k = 0; k < numPxlsInBlock; k++)
-                            {
-                                inputDataMain[n][k] = inputDataLower[n][k];
-                            }
-                        }
-                        
-                        // Read Lower Block
-                        for(int n = 0; n < numInBands; n++)
-                        {
-                            rowOffset = bandOffsets[n][1] + (numOfLines * (i+1));
-                            inputRasterBands[n]->RasterIO(GF_Read, bandOffsets[n][0], rowOffset, width, numOfLines, inputDataLower[n], width, numOfLines, GDT_Float32, 0, 0);
-                        }
-                    }
-                    
-                    for(int m = 0; m < numOfLines; ++m)
-                    {
-                        line = (i*numOfLines)+m;
-                        pbar.progress(line, height);
-                        
-                        cLinePxl = m*width;
-                        
-                        for(int j = 0; j < width; j++)
-                        {
-                            cPxl = cLinePxl+j;
-                            if(m < windowMid)
-                            {
-                                for(int y = 0; y < windowSize; y++)
-                                {
-                                    dWinY = y-windowMid;
-                                    dLinePxls = dWinY * width;
-                                    
-                                    if((cPxl + dLinePxls) < 0)
-                                    {
-                                        for(int x = 0; x < windowSize; x++)
-                                        {
-                                            dWinX = x-windowMid;
-                                            
-                                            if((j+dWinX) < 0)
-                                            {
-                                                for(int n = 0; n < numInBands; n++)
-                                                {
-                                                    inDataBlock[n][y][x] = 0;
-                                                }
-                                            }
-                                            else if((j+dWinX) >= width)
-                                            {
-                                                for(int n = 0; n < numInBands; n++)
-                                                {
-                                                    inDataBlock[n][y][x] = 0;
-                                                }
-                                            }
-                                            else
-                                            {
-                                                for(int n = 0; n < numInBands; n++)
-                                                {
-                                                    inDataBlock[n][y][x] = inputDataUpper[n][(numPxlsInBlock+(cPxl+dLinePxls))+dWinX];
-                                                }
-                                            }
-                                        }
-                                    }
-                                    else
-                                    {
-                                        for(int x = 0; x < windowSize; x++)
-                                        {
-                                            dWinX = x-windowMid;
-                                            
-                                            if((j+dWinX) < 0)
-                                            {
-                                                for(int n = 0; n < numInBands; n++)
-                                                {
-                                                    inDataBlock[n][y][x] = 0;
-                                                }
-                                            }
-                                            else if((j+dWinX) >= width)
-                                            {
-                                                for(int n = 0; n < numInBands; n++)
-                                                {
-                                                    inDataBlock[n][y][x] = 0;
-                                                }
-                                            }
-                                            else
-                                            {
-                                                for(int n = 0; n < numInBands; n++)
-                                                {
-                                                    inDataBlock[n][y][x] = inputDataMain[n][(cPxl+dLinePxls)+dWinX];
-                                                }
-                                            }
-                                        }
-                                    }
-                                }
-                            }
-                            else if(m > ((numOfLines-1)-windowMid))
-                            {
-                                for(int y = 0; y < windowSize; y++)
-                                {
-                                    dWinY = y-windowMid;
-                                    dLinePxls = dWinY * width;
-                                    
-                                    if((cPxl + dLinePxls) >= numPxlsInBlock)
-                                    {
-                                        for(int x = 0; x < windowSize; x++)
-                                        {
-                                            dWinX = x-windowMid;
-                                            
-                                            if((j+dWinX) < 0)
-                                            {
-                                                for(int n = 0; n < numInBands; n++)
-                                                {
-                                                    inDataBlock[n][y][x] = 0;
-                                                }
-                                            }
-                                            else if((j+dWinX) >= width)
-                                            {
-                                                for(int n = 0; n < numInBands; n++)
-                                                {
-                                                    inDataBlock[n][y][x] = 0;
-                                                }
-                                            }
-                                            else
-                                            {
-                                                for(int n = 0; n < numInBands; n++)
-                                                {
-                                                    inDataBlock[n][y][x] = inputDataLower[n][((cPxl+dLinePxls)-numPxlsInBlock)+dWinX];
-                                                }
-                                            }
-                                        }
-                                    }
-                                    else
-                                    {
-                                        for(int x = 0; x < windowSize; x++)
-                                        {
-                                            dWinX = x-windowMid;
-                                            
-                                            if((j+dWinX) < 0)
-                                            {
-                                                for(int n = 0; n < numInBands; n++)
-                                                {
-                                                    inDataBlock[n][y][x] = 0;
-                                                }
-                                            }
-                                            else if((j+dWinX) >= width)
-                                            {
-                                                for(int n = 0; n < numInBands; n++)
-                                                {
-                                                    inDataBlock[n][y][x] = 0;
-                                                }
-                                            }
-                                            else
-                                            {
-                                                for(int n = 0; n < numInBands; n++)
-                                                {
-                                                    inDataBlock[n][y][x] = inputDataMain[n][(cPxl+dLinePxls)+dWinX];
-                                                }
-                                            }
-                                        }
-                                    }
-                                }
-                            }
-                            else
-                            {
-                                for(int y = 0; y < windowSize; y++)
-                                {
-                                    dWinY = y-windowMid;
-                                    dLinePxls = dWinY * width;
-                                    
-                                    for(int x = 0; x < windowSize; x++)
-                                    {
-                                        dWinX = x-windowMid;
-                                        
-                                        if((j+dWinX) < 0)
-                                        {
-                                            for(int n = 0; n < numInBands; n++)
-                                            {
-                                                inDataBlock[n][y][x] = 0;
-                                            }
-                                        }
-                                        else if((j+dWinX) >= width)
-                                        {
-                                            for(int n = 0; n < numInBands; n++)
-                                            {
-                                                inDataBlock[n][y][x] = 0;
-                                            }
-                                        }
-                                        else
-                                        {
-                                            for(int n = 0; n < numInBands; n++)
-                                            {
-                                                inDataBlock[n][y][x] = inputDataMain[n][(cPxl+dLinePxls)+dWinX];
-                                            }
-                                        }
-                                    }
-                                }
-                            }
-                            
-                            this->calc->calcImageValue(inDataBlock, numInBands, windowSize, outDataColumn);
-                            
-                            for(int n = 0; n < this->numOutBands; n++)
-                            {
-                                outputData[n][cPxl] = outDataColumn[n];
-                            }
-                        }
-                    }
-                    
-                    for(int n = 0; n < this->numOutBands; n++)
-                    {
-                        outputRasterBands[n]->RasterIO(GF_Write, 0, (numOfLines * i), width, numOfLines, outputData[n], width, numOfLines, GDT_Float64, 0, 0);
+                        ++cPxl;
                     }
                 }
-                                
-                if(remainRows > 0)
+                
+                for(int n = 0; n < this->numOutBands; n++)
                 {
-                    // Shift Lower Block to Main Block
-                    for(int n = 0; n < numInBands; n++)
-                    {
-                        for(int k = 0; k < numPxlsInBlock; k++)
-                        {
-                            inputDataUpper[n][k] = inputDataMain[n][k];
-                        }
-                    }
-                    
-                    // Shift Lower Block to Main Block
-                    for(int n = 0; n < numInBands; n++)
-                    {
-                        for(int k = 0; k < numPxlsInBlock; k++)
-                        {
-                            inputDataMain[n][k] = inputDataLower[n][k];
-                        }
-                    }
-                    
-                    // Read Lower Block
-                    for(int n = 0; n < numInBands; n++)
-                    {
-                        for(int k = 0; k < numPxlsInBlock; k++)
-                        {
-                            inputDataLower[n][k] = 0;
-                        }
-                    }
-                    
-                    for(int m = 0; m < remainRows; ++m)
-                    {
-                        line = (nYBlocks*numOfLines)+m;
-                        pbar.progress(line, height);
-                        
-                        cLinePxl = m*width;
-                        
-                        for(int j = 0; j < width; j++)
-                        {
-                            cPxl = cLinePxl+j;
-                            if(m < windowMid)
-                            {
-                                for(int y = 0; y < windowSize; y++)
-                                {
-                                    dWinY = y-windowMid;
-                                    dLinePxls = dWinY * width;
-                                    
-                                    if((cPxl + dLinePxls) < 0)
-                                    {
-                                        for(int x = 0; x < windowSize; x++)
-                                        {
-                                            dWinX = x-windowMid;
-                                            
-                                            if((j+dWinX) < 0)
-                                            {
-                                                for(int n = 0; n < numInBands; n++)
-                                                {
-                                                    inDataBlock[n][y][x] = 0;
-                                                }
-                                            }
-                                            else if((j+dWinX) >= width)
-                                            {
-                                                for(int n = 0; n < numInBands; n++)
-                                                {
-                                                    inDataBlock[n][y][x] = 0;
-                                                }
-                                            }
-                                            else
-                                            {
-                                                for(int n = 0; n < numInBands; n++)
-                                                {
-                                                    inDataBlock[n][y][x] = inputDataUpper[n][(numPxlsInBlock+(cPxl+dLinePxls))+dWinX];
-                                                }
-                                            }
-                                        }
-                                    }
-                                    else
-                                    {
-                                        for(int x = 0; x < windowSize; x++)
-                                        {
-                                            dWinX = x-windowMid;
-                                            
-                                            if((j+dWinX) < 0)
-                                            {
-                                                for(int n = 0; n < numInBands; n++)
-                                                {
-                                                    inDataBlock[n][y][x] = 0;
-                                                }
-                                            }
-                                            else if((j+dWinX) >= width)
-                                            {
-                                                for(int n = 0; n < numInBands; n++)
-                                                {
-                                                    inDataBlock[n][y][x] = 0;
-                                                }
-                                            }
-                                            else
-                                            {
-                                                for(int n = 0; n < numInBands; n++)
-                                                {
-                                                    inDataBlock[n][y][x] = inputDataMain[n][(cPxl+dLinePxls)+dWinX];
-                                                }
-                                            }
-                                        }
-                                    }
-                                }
-                            }
-                            else if(m > ((numOfLines-1)-windowMid))
-                            {
-                                for(int y = 0; y < windowSize; y++)
-                                {
-                                    dWinY = y-windowMid;
-                                    dLinePxls = dWinY * width;
-                                    
-                                    if((cPxl + dLinePxls) >= numPxlsInBlock)
-                                    {
-                                        for(int x = 0; x < windowSize; x++)
-                                        {
-                                            dWinX = x-windowMid;
-                                            
-                                            if((j+dWinX) < 0)
-                                            {
-                                                for(int n = 0; n < numInBands; n++)
-                                                {
-                                                    inDataBlock[n][y][x] = 0;
-                                                }
-                                            }
-                                            else if((j+dWinX) >= width)
-                                            {
-                                                for(int n = 0; n < numInBands; n++)
-                                                {
-                                                    inDataBlock[n][y][x] = 0;
-                                                }
-                                            }
-                                            else
-                                            {
-                                                for(int n = 0; n < numInBands; n++)
-                                                {
-                                                    inDataBlock[n][y][x] = inputDataLower[n][((cPxl+dLinePxls)-numPxlsInBlock)+dWinX];
-                                                }
-                                            }
-                                        }
-                                    }
-                                    else
-                                    {
-                                        for(int x = 0; x < windowSize; x++)
-                                        {
-                                            dWinX = x-windowMid;
-                                            
-                                            if((j+dWinX) < 0)
-                                            {
-                                                for(int n = 0; n < numInBands; n++)
-                                                {
-                                                    inDataBlock[n][y][x] = 0;
-                                                }
-                                            }
-                                            else if((j+dWinX) >= width)
-                                            {
-                                                for(int n = 0; n < numInBands; n++)
-                                                {
-                                                    inDataBlock[n][y][x] = 0;
-                                                }
-                                            }
-                                            else
-                                            {
-                                                for(int n = 0; n < numInBands; n++)
-                                                {
-                                                    inDataBlock[n][y][x] = inputDataMain[n][(cPxl+dLinePxls)+dWinX];
-                                                }
-                                            }
-                                        }
-                                    }
-                                }
-                            }
-                            else
-                            {
-                                for(int y = 0; y < windowSize; y++)
-                                {
-                                    dWinY = y-windowMid;
-                                    dLinePxls = dWinY * width;
-                                    
-                                    for(int x = 0; x < windowSize; x++)
-                                    {
-                                        dWinX = x-windowMid;
-                                        
-                                        if((j+dWinX) < 0)
-                                        {
-                                            for(int n = 0; n < numInBands; n++)
-                                            {
-                                                inDataBlock[n][y][x] = 0;
-                                            }
-                                        }
-                                        else if((j+dWinX) >= width)
-                                        {
-                                            for(int n = 0; n < numInBands; n++)
-                                            {
-                                                inDataBlock[n][y][x] = 0;
-                                            }
-                                        }
-                                        else
-                                        {
-                                            for(int n = 0; n < numInBands; n++)
-                                            {
-                                                inDataBlock[n][y][x] = inputDataMain[n][(cPxl+dLinePxls)+dWinX];
-                                            }
-                                        }
-                                    }
-                                }
-                            }
-                            
-                            this->calc->calcImageValue(inDataBlock, numInBands, windowSize, outDataColumn);
-                            
-                            for(int n = 0; n < this->numOutBands; n++)
-                            {                                
-                                outputData[n][cPxl] = outDataColumn[n];
-                            }
-                        }
-                    }
-                    
-                    for(int n = 0; n < this->numOutBands; n++)
-                    {
-                        outputRasterBands[n]->RasterIO(GF_Write, 0, (nYBlocks*numOfLines), width, remainRows, outputData[n], width, remainRows, GDT_Float64, 0, 0);
-                    }
+                    outputRasterBands[n]->RasterIO(GF_Write, 0, (i*yBlockSize), width, numLinesInBlock, outputData[n], width, numLinesInBlock, GDT_Float64, 0, 0);
                 }
-                
             }
             pbar.finish();
 		}
 		catch(RSGISImageCalcException& e)
 		{
-			if(gdalTranslation != NULL)
+			this->freeWindowDataBuffers(gdalTranslation, dsOffsets, numDS, bandOffsets, numInBands, ringBuffer, inDataBlock, windowSize, outputData, outDataColumn);
+            GDALClose(outputImageDS);
+			throw e;
+		}
+		catch(RSGISImageBandException& e)
+		{
+			this->freeWindowDataBuffers(gdalTranslation, dsOffsets, numDS, bandOffsets, numInBands, ringBuffer, inDataBlock, windowSize, outputData, outDataColumn);
+            GDALClose(outputImageDS);
+			throw e;
+		}
+		
+		this->freeWindowDataBuffers(gdalTranslation, dsOffsets, numDS, bandOffsets, numInBands, ringBuffer, inDataBlock, windowSize, outputData, outDataColumn);
+		GDALClose(outputImageDS);
+	}
+    
+    void RSGISCalcImage::freeWindowDataBuffers(double *gdalTranslation, int **dsOffsets, int numDS, int **bandOffsets, int numInBands, RSGISImageRowRingBuffer *ringBuffer, float ***inDataBlock, int windowSize, double **outputData, double *outDataColumn)
+    {
+		if(gdalTranslation != NULL)
+		{
+			delete[] gdalTranslation;
+		}
+		
+		if(dsOffsets != NULL)
+		{
+			for(int i = 0; i < numDS; i++)
 			{
-				delete[] gdalTranslation;
+				delete[] dsOffsets[i];
 			}
-			
-			if(dsOffsets != NULL)
+			delete[] dsOffsets;
+		}
+		
+		if(bandOffsets != NULL)
+		{
+			for(int i = 0; i < numInBands; i++)
 			{
-				for(int i = 0; i < numDS; i++)
-				{
-					delete dsOffsets[i];
-				}
-				delete[] dsOffsets;
+				delete[] bandOffsets[i];
 			}
-			
-			if(bandOffsets != NULL)
+			delete[] bandOffsets;
+		}
+        
+        if(ringBuffer != NULL)
+        {
+            delete ringBuffer;
+        }
+		
+		if(inDataBlock != NULL)
+		{
+			for(int i = 0; i < numInBands; i++)
 			{
-				for(int i = 0; i < numInBands; i++)
+				for(int j = 0; j < windowSize; j++)
 				{
-					delete bandOffsets[i];
+					delete[] inDataBlock[i][j];
 				}
-				delete[] bandOffsets;
+				delete[] inDataBlock[i];
 			}
-			
-			if(inputDataUpper != NULL)
+			delete[] inDataBlock;
+		}
+		
+		if(outputData != NULL)
+		{
+			for(int i = 0; i < numOutBands; i++)
 			{
-				for(int i = 0; i < numInBands; i++)
-				{
-					delete[] inputDataUpper[i];
-				}
-				delete[] inputDataUpper;
+				CPLFree(outputData[i]);
 			}
-            
-            if(inputDataMain != NULL)
-			{
-				for(int i = 0; i < numInBands; i++)
-				{
-					delete[] inputDataMain[i];
-				}
-				delete[] inputDataMain;
-			}
-            
-            if(inputDataLower != NULL)
-			{
-				for(int i = 0; i < numInBands; i++)
-				{
-					delete[] inputDataLower[i];
-				}
-				delete[] inputDataLower;
-			}
-			
-			if(inDataBlock != NULL)
-			{
-				for(int i = 0; i < numInBands; i++)
-				{
-					for(int j = 0; j < windowSize; j++)
-					{
-						delete[] inDataBlock[i][j];
-					}
-					delete[] inDataBlock[i];
-				}
-				delete[] inDataBlock;
-			}
-			
-			if(outputData != NULL)
-			{
-				for(int i = 0; i < numOutBands; i++)
-				{
-					delete outputData[i];
-				}
-				delete outputData;
-			}
-			
-			if(outDataColumn != NULL)
-			{
-				delete[] outDataColumn;
-			}
-
-			throw e;
-		}
-		catch(RSGISImageBandException& e)
-		{
-			if(gdalTranslation != NULL)
-			{
-				delete[] gdalTranslation;
-			}
-			
-			if(dsOffsets != NULL)
-			{
-				for(int i = 0; i < numDS; i++)
-				{
-					delete dsOffsets[i];
-				}
-				delete[] dsOffsets;
-			}
-			
-			if(bandOffsets != NULL)
-			{
-				for(int i = 0; i < numInBands; i++)
-				{
-					delete bandOffsets[i];
-				}
-				delete[] bandOffsets;
-			}
-			
-			if(inputDataUpper != NULL)
-			{
-				for(int i = 0; i < numInBands; i++)
-				{
-					delete[] inputDataUpper[i];
-				}
-				delete[] inputDataUpper;
-			}
-            
-            if(inputDataMain != NULL)
-			{
-				for(int i = 0; i < numInBands; i++)
-				{
-					delete[] inputDataMain[i];
-				}
-				delete[] inputDataMain;
-			}
-            
-            if(inputDataLower != NULL)
-			{
-				for(int i = 0; i < numInBands; i++)
-				{
-					delete[] inputDataLower[i];
-				}
-				delete[] inputDataLower;
-			}
-			
-			if(inDataBlock != NULL)
-			{
-				for(int i = 0; i < numInBands; i++)
-				{
-					for(int j = 0; j < windowSize; j++)
-					{
-						delete[] inDataBlock[i][j];
-					}
-					delete[] inDataBlock[i];
-				}
-				delete[] inDataBlock;
-			}
-			
-			if(outputData != NULL)
-			{
-				for(int i = 0; i < numOutBands; i++)
-				{
-					delete outputData[i];
-				}
-				delete outputData;
-			}
-			
-			if(outDataColumn != NULL)
-			{
-				delete[] outDataColumn;
-			}
-			
-			throw e;
-		}
-		
-		if(gdalTranslation != NULL)
-		{
-			delete[] gdalTranslation;
-		}
-		
-		if(dsOffsets != NULL)
-		{
-			for(int i = 0; i < numDS; i++)
-			{
-				delete dsOffsets[i];
-			}
-			delete[] dsOffsets;
-		}
-		
-		if(bandOffsets != NULL)
-		{
-			for(int i = 0; i < numInBands; i++)
-			{
-				delete bandOffsets[i];
-			}
-			delete[] bandOffsets;
-		}
-		
-		if(inputDataUpper != NULL)
-        {
-            for(int i = 0; i < numInBands; i++)
-            {
-                delete[] inputDataUpper[i];
-            }
-            delete[] inputDataUpper;
-        }
-        
-        if(inputDataMain != NULL)
-        {
-            for(int i = 0; i < numInBands; i++)
-            {
-                delete[] inputDataMain[i];
-            }
-            delete[] inputDataMain;
-        }
-        
-        if(inputDataLower != NULL)
-        {
-            for(int i = 0; i < numInBands; i++)
-            {
-                delete[] inputDataLower[i];
-            }
-            delete[] inputDataLower;
-        }
-		
-		if(inDataBlock != NULL)
-		{
-			for(int i = 0; i < numInBands; i++)
-			{
-				for(int j = 0; j < windowSize; j++)
-				{
-					delete[] inDataBlock[i][j];
-				}
-				delete[] inDataBlock[i];
-			}
-			delete[] inDataBlock;
-		}
-		
-		if(outputData != NULL)
-		{
-			for(int i = 0; i < numOutBands; i++)
-			{
-				delete outputData[i];
-			}
-			delete outputData;
+			delete[] outputData;
 		}
 		
 		if(outDataColumn != NULL)
 		{
 			delete[] outDataColumn;
 		}
-		
-		GDALClose(outputImageDS);
-	}
+    }
     
     void RSGISCalcImage::calcImageWindowData(GDALDataset **datasets, int numDS, std::string outputImage, std::string outputRefIntImage, int windowSize, std::string gdalFormat, GDALDataType gdalDataType)
     {
@@ -9333,6 +9188,7 @@ namespace rsgis{namespace img{
                 throw RSGISImageBandException("Driver does not exists..");
             }
             char **papszOptions = imgUtils.getGDALCreationOptionsForFormat(gdalFormat);
+            RSGISDatasetCache::invalidate(outputImage);
             outputImageDS = gdalDriver->Create(outputImage.c_str(), width, height, this->numOutBands, gdalDataType, papszOptions);
             if(outputImageDS == NULL)
             {
@@ -9348,6 +9204,7 @@ namespace rsgis{namespace img{
                 outputImageDS->SetProjection(proj.c_str());
             }
             
+            RSGISDatasetCache::invalidate(outputRefIntImage);
             outputRefImageDS = gdalDriver->Create(outputRefIntImage.c_str(), width, height, 1, GDT_UInt32, papszOptions);
             if(outputRefImageDS == NULL)
             {
@@ -11301,6 +11158,7 @@ namespace rsgis{namespace img{
                 throw RSGISImageBandException("Driver does not exists..");
             }
             char **papszOptions = imgUtils.getGDALCreationOptionsForFormat(gdalFormat);
+            RSGISDatasetCache::invalidate(outputImage);
             outputImageDS = gdalDriver->Create(outputImage.c_str(), width, height, this->numOutBands, gdalDataType, papszOptions);
             
             if(outputImageDS == NULL)
@@ -12274,6 +12132,7 @@ namespace rsgis{namespace img{
 				throw RSGISImageBandException("ENVI driver does not exists..");
 			}
             char **papszOptions = imgUtils.getGDALCreationOptionsForFormat(gdalFormat);
+			RSGISDatasetCache::invalidate(outputImage);
 			outputImageDS = gdalDriver->Create(outputImage.c_str(), width, height, this->numOutBands, gdalDataType, papszOptions);
 			
 			if(outputImageDS == NULL)
@@ -13597,6 +13456,12 @@ namespace rsgis{namespace img{
 
     void RSGISCalcImage::calcImageWithinPolygonExtentInMem(GDALDataset **datasets, int numDS, geos::geom::Envelope *env, geos::geom::Polygon *poly, pixelInPolyOption pixelPolyOption)
     {
+        if(RSGISPolygonRasteriser::supportsMethod(pixelPolyOption))
+        {
+            // Scanline the polygon over the pixel grid rather than testing a geometry for each pixel.
+            this->calcImageWithinPolygonSpansInMem(datasets, numDS, env, poly, pixelPolyOption);
+            return;
+        }
         GDALAllRegister();
         RSGISImageUtils imgUtils;
         double *gdalTranslation = new double[6];
@@ -13981,6 +13846,72 @@ namespace rsgis{namespace img{
             delete[] inputRasterBands;
         }
     }
+
+    void RSGISCalcImage::calcImageWithinPolygonSpansInMem(GDALDataset **datasets, int numDS, geos::geom::Envelope *env, geos::geom::Polygon *poly, pixelInPolyOption pixelPolyOption)
+    {
+        GDALAllRegister();
+        RSGISImageUtils imgUtils;
+        double transformations[6];
+        datasets[0]->GetGeoTransform(transformations);
+        double pxlWidth = transformations[1];
+        double pxlHeight = fabs(transformations[5]);
+
+        // As for calcImageWithinPolygonExtentInMem, envelopes smaller than a pixel are buffered.
+        geos::geom::Envelope overlapEnv = *env;
+        if((env->getWidth() < pxlWidth) | (env->getHeight() < pxlHeight))
+        {
+            overlapEnv = geos::geom::Envelope(env->getMinX() - pxlWidth, env->getMaxX() + pxlWidth, env->getMinY() - pxlHeight, env->getMaxY() + pxlHeight);
+        }
+
+        double gdalTranslation[6];
+        std::vector<int*> dsOffsets(numDS);
+        std::vector<int> dsOffsetVals(numDS*2);
+        for(int i = 0; i < numDS; i++)
+        {
+            dsOffsets[i] = &dsOffsetVals[i*2];
+        }
+        int width = 0;
+        int height = 0;
+        int xBlockSize = 0;
+        int yBlockSize = 0;
+        imgUtils.getImageOverlapCut2Env(datasets, numDS, dsOffsets.data(), &width, &height, gdalTranslation, &overlapEnv, &xBlockSize, &yBlockSize);
+        pxlWidth = gdalTranslation[1];
+        pxlHeight = fabs(gdalTranslation[5]);
+
+        int numInBands = 0;
+        for(int i = 0; i < numDS; i++)
+        {
+            numInBands += datasets[i]->GetRasterCount();
+        }
+
+        std::vector< std::vector<float> > inputData(numInBands, std::vector<float>(((size_t)width)*height));
+        int counter = 0;
+        for(int i = 0; i < numDS; i++)
+        {
+            for(int j = 0; j < datasets[i]->GetRasterCount(); j++)
+            {
+                datasets[i]->GetRasterBand(j+1)->RasterIO(GF_Read, dsOffsets[i][0], dsOffsets[i][1], width, height, inputData[counter].data(), width, height, GDT_Float32, 0, 0);
+                counter++;
+            }
+        }
+
+        RSGISPolygonRasteriser polyRasteriser(gdalTranslation[0], gdalTranslation[3], pxlWidth, pxlHeight, width, height);
+        polyRasteriser.setPolygon(poly);
+        std::vector<RSGISPixelSpan> pxlSpans;
+        polyRasteriser.findPixelSpans(pixelPolyOption, &pxlSpans);
+        std::vector<const float*> spanRows(numInBands);
+        for(std::vector<RSGISPixelSpan>::iterator iterSpan = pxlSpans.begin(); iterSpan != pxlSpans.end(); ++iterSpan)
+        {
+            double spanTLY = gdalTranslation[3] - ((*iterSpan).row * pxlHeight);
+            double spanTLX = gdalTranslation[0] + ((*iterSpan).xStart * pxlWidth);
+            size_t pxlIdx = ((*iterSpan).row * width) + (*iterSpan).xStart;
+            for(int n = 0; n < numInBands; n++)
+            {
+                spanRows[n] = inputData[n].data() + pxlIdx;
+            }
+            this->calc->calcImageRowExtent(spanRows.data(), numInBands, ((*iterSpan).xEnd - (*iterSpan).xStart), spanTLX, spanTLY, pxlWidth, pxlWidth, pxlHeight);
+        }
+    }
 	
 	/* calcImageWithinRasterPolygon - takes existing output image */
 	void RSGISCalcImage::calcImageWithinRasterPolygon(GDALDataset **datasets, int numDS, geos::geom::Envelope *env, long fid)
@@ -14412,120 +14343,779 @@ namespace rsgis{namespace img{
 	
     void RSGISCalcImage::calcImageBorderPixels(GDALDataset *dataset, bool returnInt)
     {
-        GDALAllRegister();
+        GDALAllRegister();
+        
+        try
+        {
+            unsigned int imgWidth = dataset->GetRasterXSize();
+            unsigned int imgHeight = dataset->GetRasterYSize();
+            unsigned int numBands = dataset->GetRasterCount();
+            
+            GDALRasterBand **gdalBands = new GDALRasterBand*[numBands];
+            for(unsigned int i = 0; i < numBands; ++i)
+            {
+                gdalBands[i] = dataset->GetRasterBand(i+1);
+            }
+            
+            unsigned int numfloatVals = 0;
+            float *pxlFloatVals = NULL;
+            unsigned int numIntVals = 0;
+            long *pxlIntVals = NULL;
+            if(returnInt)
+            {
+                numIntVals = numBands;
+                pxlIntVals = new long[numIntVals];
+            }
+            else
+            {
+                numfloatVals = numBands;
+                pxlFloatVals = new float[numfloatVals];
+            }
+            
+            int tmpVal = 0;
+            
+            std::cout << "Processing Top and Bottom Pixels\n";
+            // Top and Bottom pixels
+            for(unsigned int x = 0; x < imgWidth; ++x)
+            {
+                // Top
+                for(unsigned int b = 0; b < numBands; ++b)
+                {
+                    if(returnInt)
+                    {
+                        gdalBands[b]->RasterIO(GF_Read, x, 0, 1, 1, &tmpVal, 1, 1, GDT_Int32, 0, 0);
+                        pxlIntVals[b] = tmpVal;
+                    }
+                    else
+                    {
+                        gdalBands[b]->RasterIO(GF_Read, x, 0, 1, 1, &pxlFloatVals[b], 1, 1, GDT_Float32, 0, 0);
+                    }
+                }
+                this->calc->calcImageValue(pxlIntVals, numIntVals, pxlFloatVals, numfloatVals);
+                
+                // Bottom
+                for(unsigned int b = 0; b < numBands; ++b)
+                {
+                    if(returnInt)
+                    {
+                        gdalBands[b]->RasterIO(GF_Read, x, (imgHeight-1), 1, 1, &tmpVal, 1, 1, GDT_Int32, 0, 0);
+                        pxlIntVals[b] = tmpVal;
+                    }
+                    else
+                    {
+                        gdalBands[b]->RasterIO(GF_Read, x, (imgHeight-1), 1, 1, &pxlFloatVals[b], 1, 1, GDT_Float32, 0, 0);
+                    }
+                }
+                this->calc->calcImageValue(pxlIntVals, numIntVals, pxlFloatVals, numfloatVals);
+            }
+            
+            std::cout << "Processing Left and Right Pixels\n";
+            // Left and right pixels
+            for(unsigned int y = 0; y < imgHeight; ++y)
+            {
+                // Left
+                for(unsigned int b = 0; b < numBands; ++b)
+                {
+                    if(returnInt)
+                    {
+                        gdalBands[b]->RasterIO(GF_Read, 0, y, 1, 1, &pxlIntVals[b], 1, 1, GDT_Int32, 0, 0);
+                    }
+                    else
+                    {
+                        gdalBands[b]->RasterIO(GF_Read, 0, y, 1, 1, &pxlFloatVals[b], 1, 1, GDT_Float32, 0, 0);
+                    }
+                }
+                this->calc->calcImageValue(pxlIntVals, numIntVals, pxlFloatVals, numfloatVals);
+                
+                // Right
+                for(unsigned int b = 0; b < numBands; ++b)
+                {
+                    if(returnInt)
+                    {
+                        gdalBands[b]->RasterIO(GF_Read, (imgWidth-1), y, 1, 1, &pxlIntVals[b], 1, 1, GDT_Int32, 0, 0);
+                    }
+                    else
+                    {
+                        gdalBands[b]->RasterIO(GF_Read, (imgWidth-1), y, 1, 1, &pxlFloatVals[b], 1, 1, GDT_Float32, 0, 0);
+                    }
+                }
+                this->calc->calcImageValue(pxlIntVals, numIntVals, pxlFloatVals, numfloatVals);
+            }
+            
+            delete[] gdalBands;
+            delete[] pxlFloatVals;
+            delete[] pxlIntVals;
+        }
+        catch (RSGISImageCalcException &e)
+        {
+            throw e;
+        }
+        catch (RSGISImageBandException &e)
+        {
+            throw e;
+        }
+        catch (RSGISException &e)
+        {
+            throw RSGISImageCalcException(e.what());
+        }
+    }
+    
+    void RSGISCalcImage::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+    
+    unsigned int RSGISCalcImage::getNumThreads()
+    {
+        return this->numThreads;
+    }
+    
+    void RSGISCalcImage::setUsePipelinedIO(bool usePipelinedIO)
+    {
+        this->usePipelinedIO = usePipelinedIO;
+    }
+    
+    bool RSGISCalcImage::getUsePipelinedIO()
+    {
+        return this->usePipelinedIO;
+    }
+    
+    void RSGISCalcImage::setMemoryBudget(size_t memoryBudget)
+    {
+        this->blockPlanner.setMemoryBudget(memoryBudget);
+    }
+    
+    size_t RSGISCalcImage::getMemoryBudget()
+    {
+        return this->blockPlanner.getMemoryBudget();
+    }
+    
+    void RSGISCalcImage::setTileQueue(std::string queueDIR, unsigned int tileSize, unsigned int claimTimeoutSecs)
+    {
+        this->tileQueueDIR = queueDIR;
+        this->tileQueueSize = tileSize;
+        this->tileQueueClaimTimeout = claimTimeoutSecs;
+    }
+    
+    void RSGISCalcImage::setCheckpoint(unsigned int intervalSecs, bool resume, std::string checkpointFile)
+    {
+        this->checkpointSecs = intervalSecs;
+        this->checkpointResume = resume;
+        this->checkpointFile = checkpointFile;
+    }
+    
+    void RSGISCalcImage::setOutputStats(bool calcStats, bool calcPyramids, bool thematic, bool useNoData, float noDataVal)
+    {
+        this->calcOutputStats = calcStats;
+        this->calcOutputPyramids = calcPyramids;
+        this->outputThematic = thematic;
+        this->outputStatsUseNoData = useNoData;
+        this->outputStatsNoDataVal = noDataVal;
+    }
+    
+    RSGISImageBlockPlan RSGISCalcImage::planBlocks(GDALRasterBand **inputRasterBands, int numInBands, GDALRasterBand **outputRasterBands, int width, int height, int yBlockSize, bool serialOnly)
+    {
+        size_t nativeBytesPerPxl = 0;
+        for(int n = 0; n < numInBands; n++)
+        {
+            nativeBytesPerPxl += GDALGetDataTypeSize(inputRasterBands[n]->GetRasterDataType()) / 8;
+        }
+        size_t bufferBytesPerPxl = sizeof(float) * numInBands;
+        if(outputRasterBands != NULL)
+        {
+            for(int n = 0; n < this->numOutBands; n++)
+            {
+                nativeBytesPerPxl += GDALGetDataTypeSize(outputRasterBands[n]->GetRasterDataType()) / 8;
+            }
+            bufferBytesPerPxl += sizeof(double) * this->numOutBands;
+        }
+        // Each worker thread holds its own buffers, the pipeline a ring of three.
+        unsigned int numBuffers = 1;
+        if(serialOnly)
+        {
+            numBuffers = 1;
+        }
+        else if(this->useMultiThreaded())
+        {
+            numBuffers = this->numThreads;
+        }
+        else if(this->usePipelinedIO)
+        {
+            numBuffers = 3;
+        }
+        return this->blockPlanner.plan(yBlockSize, width, height, bufferBytesPerPxl, numBuffers, nativeBytesPerPxl);
+    }
+    
+    void RSGISCalcImage::setSkipEmptyBlocks(bool skipEmptyBlocks, float outNoDataVal, bool leaveSparse, GDALDataset *maskDataset)
+    {
+        this->skipEmptyBlocks = skipEmptyBlocks;
+        this->skipNoDataVal = outNoDataVal;
+        this->skipLeaveSparse = leaveSparse;
+        this->skipMaskDataset = maskDataset;
+    }
+    
+    void RSGISCalcImage::setQuickLook(unsigned int factor)
+    {
+        this->quickLookFactor = (factor == 0)?1:factor;
+    }
+    
+    void RSGISCalcImage::prepareSkipEmptyBlocks(GDALRasterBand **outputRasterBands, int width, int height)
+    {
+        if(this->skipMaskDataset != NULL)
+        {
+            if((this->skipMaskDataset->GetRasterXSize() != width) || (this->skipMaskDataset->GetRasterYSize() != height))
+            {
+                throw RSGISImageCalcException("The mask used to skip empty blocks must have the same size as the output image.");
+            }
+        }
+        // Skipped blocks (including those left sparse) read as no data.
+        for(int n = 0; n < this->numOutBands; n++)
+        {
+            outputRasterBands[n]->SetNoDataValue(this->skipNoDataVal);
+        }
+    }
+    
+    bool RSGISCalcImage::isEmptyBlock(GDALRasterBand **inputRasterBands, int **bandOffsets, int numInBands, int width, int rowOffset, int nRows)
+    {
+        // Drivers without sparse blocks report the coverage as unimplemented
+        // and a block is only empty if no band reports any data.
+        bool allInputsEmpty = (numInBands > 0);
+        for(int n = 0; (n < numInBands) && allInputsEmpty; n++)
+        {
+            int status = inputRasterBands[n]->GetDataCoverageStatus(bandOffsets[n][0], bandOffsets[n][1] + rowOffset, width, nRows, 0, NULL);
+            allInputsEmpty = ((status & GDAL_DATA_COVERAGE_STATUS_EMPTY) != 0) && ((status & (GDAL_DATA_COVERAGE_STATUS_DATA | GDAL_DATA_COVERAGE_STATUS_UNIMPLEMENTED)) == 0);
+        }
+        if(allInputsEmpty || (this->skipMaskDataset == NULL))
+        {
+            return allInputsEmpty;
+        }
+        
+        std::vector<unsigned char> maskData(((size_t)width)*nRows);
+        this->skipMaskDataset->GetRasterBand(1)->RasterIO(GF_Read, 0, rowOffset, width, nRows, maskData.data(), width, nRows, GDT_Byte, 0, 0);
+        for(std::vector<unsigned char>::iterator iterMask = maskData.begin(); iterMask != maskData.end(); ++iterMask)
+        {
+            if(*iterMask != 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    void RSGISCalcImage::fillEmptyBlock(double **outputData, size_t numPxls)
+    {
+        for(int n = 0; n < this->numOutBands; n++)
+        {
+            std::fill(outputData[n], outputData[n]+numPxls, (double)this->skipNoDataVal);
+        }
+    }
+    
+    bool RSGISCalcImage::canPipelineIO(GDALRasterBand **inputRasterBands, int numInBands, GDALRasterBand **outputRasterBands)
+    {
+        if(!this->usePipelinedIO)
+        {
+            return false;
+        }
+        // Reading and writing happen on different threads so the output
+        // cannot also be one of the inputs.
+        GDALDataset *outDataset = outputRasterBands[0]->GetDataset();
+        for(int n = 0; n < numInBands; n++)
+        {
+            if(inputRasterBands[n]->GetDataset() == outDataset)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    void RSGISCalcImage::calcImageBlocksPipelined(GDALRasterBand **inputRasterBands, int **bandOffsets, int numInBands, GDALRasterBand **outputRasterBands, int width, int height, int yBlockSize)
+    {
+        int nYBlocks = height / yBlockSize;
+        int remainRows = height - (nYBlocks * yBlockSize);
+        unsigned int nBlocks = nYBlocks;
+        if(remainRows > 0)
+        {
+            ++nBlocks;
+        }
+        
+        RSGISImageBlockPipeline pipeline;
+        unsigned int numSlots = pipeline.getNumSlots();
+        size_t numPxlsInBlock = ((size_t)width)*yBlockSize;
+        
+        std::vector<float**> inputData(numSlots);
+        std::vector<double**> outputData(numSlots);
+        for(unsigned int s = 0; s < numSlots; ++s)
+        {
+            inputData[s] = new float*[numInBands];
+            for(int n = 0; n < numInBands; n++)
+            {
+                inputData[s][n] = (float *) CPLMalloc(sizeof(float)*numPxlsInBlock);
+            }
+            outputData[s] = new double*[this->numOutBands];
+            for(int n = 0; n < this->numOutBands; n++)
+            {
+                outputData[s][n] = (double *) CPLMalloc(sizeof(double)*numPxlsInBlock);
+            }
+        }
+        
+        // Whether the block in each slot was found to be empty and skipped.
+        std::vector<char> emptySlot(numSlots, 0);
+        RSGISImageReadPlanner readPlanner(inputRasterBands, bandOffsets, numInBands, width, height, yBlockSize);
+        
+        RSGISProgressCounter progress(height);
+        auto blockLines = [&](unsigned int block){ return (block < (unsigned int)nYBlocks)?yBlockSize:remainRows; };
+        
+        auto readBlock = [&](unsigned int block, unsigned int slot)
+        {
+            int numLines = blockLines(block);
+            emptySlot[slot] = this->skipEmptyBlocks && this->isEmptyBlock(inputRasterBands, bandOffsets, numInBands, width, (yBlockSize * block), numLines);
+            if(emptySlot[slot])
+            {
+                return;
+            }
+            readPlanner.prefetch(block);
+            rsgis::RSGISScopedTimer readTimer("calcimage.read");
+            readTimer.addBytes(sizeof(float)*numInBands*((size_t)width)*numLines);
+            for(int n = 0; n < numInBands; n++)
+            {
+                inputRasterBands[n]->RasterIO(GF_Read, bandOffsets[n][0], bandOffsets[n][1] + (yBlockSize * block), width, numLines, inputData[slot][n], width, numLines, GDT_Float32, 0, 0);
+            }
+        };
+        
+        auto calcBlock = [&](unsigned int block, unsigned int slot)
+        {
+            if(emptySlot[slot])
+            {
+                this->fillEmptyBlock(outputData[slot], ((size_t)width)*blockLines(block));
+                return;
+            }
+            rsgis::RSGISScopedTimer calcTimer("calcimage.compute");
+            calcTimer.addCount(((size_t)width)*blockLines(block));
+            this->calc->calcImageBlock(inputData[slot], numInBands, ((size_t)width)*blockLines(block), outputData[slot]);
+        };
+        
+        auto writeBlock = [&](unsigned int block, unsigned int slot)
+        {
+            int numLines = blockLines(block);
+            if(!(emptySlot[slot] && this->skipLeaveSparse))
+            {
+                rsgis::RSGISScopedTimer writeTimer("calcimage.write");
+                writeTimer.addBytes(sizeof(double)*this->numOutBands*((size_t)width)*numLines);
+                for(int n = 0; n < this->numOutBands; n++)
+                {
+                    outputRasterBands[n]->RasterIO(GF_Write, 0, (yBlockSize * block), width, numLines, outputData[slot][n], width, numLines, GDT_Float64, 0, 0);
+                }
+            }
+            for(std::vector<RSGISImageOutputSink*>::iterator iterSink = this->outputSinks.begin(); iterSink != this->outputSinks.end(); ++iterSink)
+            {
+                (*iterSink)->addRows(outputData[slot], this->numOutBands, width, (yBlockSize * block), numLines);
+            }
+            progress.add(numLines);
+        };
+        
+        std::exception_ptr error = nullptr;
+        try
+        {
+            pipeline.run(nBlocks, readBlock, calcBlock, writeBlock);
+            progress.finish();
+        }
+        catch(...)
+        {
+            error = std::current_exception();
+        }
+        
+        for(unsigned int s = 0; s < numSlots; ++s)
+        {
+            for(int n = 0; n < numInBands; n++)
+            {
+                CPLFree(inputData[s][n]);
+            }
+            delete[] inputData[s];
+            for(int n = 0; n < this->numOutBands; n++)
+            {
+                CPLFree(outputData[s][n]);
+            }
+            delete[] outputData[s];
+        }
+        
+        if(error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+    
+    bool RSGISCalcImage::calcImageBlocksNativeTypes(GDALRasterBand **inputRasterBands, int **bandOffsets, int numInBands, GDALRasterBand **outputRasterBands, int width, int height, int yBlockSize)
+    {
+        // The native path can only be used when all the input bands and all the
+        // output bands share a single data type. An output sink needs the
+        // values as double so also uses the float/double path, as does a
+        // calculator which needs whole blocks.
+        if((!this->outputSinks.empty()) || this->calc->useWholeBlocks())
+        {
+            return false;
+        }
+        GDALDataType inType = inputRasterBands[0]->GetRasterDataType();
+        for(int n = 1; n < numInBands; n++)
+        {
+            if(inputRasterBands[n]->GetRasterDataType() != inType)
+            {
+                return false;
+            }
+        }
+        GDALDataType outType = outputRasterBands[0]->GetRasterDataType();
+        for(int n = 1; n < this->numOutBands; n++)
+        {
+            if(outputRasterBands[n]->GetRasterDataType() != outType)
+            {
+                return false;
+            }
+        }
+        
+        // Float32 in and Float64 out are the types used by the generic path.
+        if((inType == GDT_Float32) && (outType == GDT_Float64))
+        {
+            return false;
+        }
+        
+        switch(inType)
+        {
+            case GDT_Byte:
+                return this->calcImageBlocksNativeOutType<unsigned char>(inputRasterBands, bandOffsets, numInBands, outputRasterBands, outType, width, height, yBlockSize);
+            case GDT_UInt16:
+                return this->calcImageBlocksNativeOutType<unsigned short>(inputRasterBands, bandOffsets, numInBands, outputRasterBands, outType, width, height, yBlockSize);
+            case GDT_Int16:
+                return this->calcImageBlocksNativeOutType<short>(inputRasterBands, bandOffsets, numInBands, outputRasterBands, outType, width, height, yBlockSize);
+            case GDT_UInt32:
+                return this->calcImageBlocksNativeOutType<unsigned int>(inputRasterBands, bandOffsets, numInBands, outputRasterBands, outType, width, height, yBlockSize);
+            case GDT_Int32:
+                return this->calcImageBlocksNativeOutType<int>(inputRasterBands, bandOffsets, numInBands, outputRasterBands, outType, width, height, yBlockSize);
+            case GDT_Float32:
+                return this->calcImageBlocksNativeOutType<float>(inputRasterBands, bandOffsets, numInBands, outputRasterBands, outType, width, height, yBlockSize);
+            case GDT_Float64:
+                return this->calcImageBlocksNativeOutType<double>(inputRasterBands, bandOffsets, numInBands, outputRasterBands, outType, width, height, yBlockSize);
+            default:
+                return false;
+        }
+    }
+    
+    template <typename InT>
+    bool RSGISCalcImage::calcImageBlocksNativeOutType(GDALRasterBand **inputRasterBands, int **bandOffsets, int numInBands, GDALRasterBand **outputRasterBands, GDALDataType outType, int width, int height, int yBlockSize)
+    {
+        switch(outType)
+        {
+            case GDT_Byte:
+                this->calcImageBlocksNative<InT, unsigned char>(inputRasterBands, bandOffsets, numInBands, outputRasterBands, width, height, yBlockSize);
+                return true;
+            case GDT_UInt16:
+                this->calcImageBlocksNative<InT, unsigned short>(inputRasterBands, bandOffsets, numInBands, outputRasterBands, width, height, yBlockSize);
+                return true;
+            case GDT_Int16:
+                this->calcImageBlocksNative<InT, short>(inputRasterBands, bandOffsets, numInBands, outputRasterBands, width, height, yBlockSize);
+                return true;
+            case GDT_UInt32:
+                this->calcImageBlocksNative<InT, unsigned int>(inputRasterBands, bandOffsets, numInBands, outputRasterBands, width, height, yBlockSize);
+                return true;
+            case GDT_Int32:
+                this->calcImageBlocksNative<InT, int>(inputRasterBands, bandOffsets, numInBands, outputRasterBands, width, height, yBlockSize);
+                return true;
+            case GDT_Float32:
+                this->calcImageBlocksNative<InT, float>(inputRasterBands, bandOffsets, numInBands, outputRasterBands, width, height, yBlockSize);
+                return true;
+            case GDT_Float64:
+                this->calcImageBlocksNative<InT, double>(inputRasterBands, bandOffsets, numInBands, outputRasterBands, width, height, yBlockSize);
+                return true;
+            default:
+                return false;
+        }
+    }
+    
+    template <typename InT, typename OutT>
+    void RSGISCalcImage::calcImageBlocksNative(GDALRasterBand **inputRasterBands, int **bandOffsets, int numInBands, GDALRasterBand **outputRasterBands, int width, int height, int yBlockSize)
+    {
+        size_t numPxlsInBlock = ((size_t)width)*yBlockSize;
+        GDALDataType inGDALType = RSGISGDALPixelType<InT>::gdalType();
+        GDALDataType outGDALType = RSGISGDALPixelType<OutT>::gdalType();
+        
+        // Blocks are held in their native types; only a single row is converted
+        // to float (and calculated as double) at a time for the calculator.
+        InT **inputData = new InT*[numInBands];
+        float **inRowScratch = new float*[numInBands];
+        const float **inRows = new const float*[numInBands];
+        for(int n = 0; n < numInBands; n++)
+        {
+            inputData[n] = (InT *) CPLMalloc(sizeof(InT)*numPxlsInBlock);
+            inRowScratch[n] = (float *) CPLMalloc(sizeof(float)*width);
+        }
+        
+        OutT **outputData = new OutT*[this->numOutBands];
+        double **outRowScratch = new double*[this->numOutBands];
+        double **outRows = new double*[this->numOutBands];
+        for(int n = 0; n < this->numOutBands; n++)
+        {
+            outputData[n] = (OutT *) CPLMalloc(sizeof(OutT)*numPxlsInBlock);
+            outRowScratch[n] = (double *) CPLMalloc(sizeof(double)*width);
+        }
+        
+        try
+        {
+            int nYBlocks = height / yBlockSize;
+            int remainRows = height - (nYBlocks * yBlockSize);
+            int numLinesInBlock = 0;
+            size_t rowStart = 0;
+            RSGISImageReadPlanner readPlanner(inputRasterBands, bandOffsets, numInBands, width, height, yBlockSize);
+            
+            rsgis_tqdm pbar;
+            for(int i = 0; i <= nYBlocks; i++)
+            {
+                numLinesInBlock = (i < nYBlocks)?yBlockSize:remainRows;
+                if(numLinesInBlock == 0)
+                {
+                    break;
+                }
+                
+                readPlanner.prefetch(i);
+                rsgis::RSGISScopedTimer readTimer("calcimage.read");
+                for(int n = 0; n < numInBands; n++)
+                {
+                    inputRasterBands[n]->RasterIO(GF_Read, bandOffsets[n][0], bandOffsets[n][1] + (yBlockSize * i), width, numLinesInBlock, inputData[n], width, numLinesInBlock, inGDALType, 0, 0);
+                }
+                readTimer.addBytes(sizeof(InT)*numInBands*((size_t)width)*numLinesInBlock);
+                readTimer.stop();
+                
+                pbar.progress(i*yBlockSize, height);
+                rsgis::RSGISScopedTimer calcTimer("calcimage.compute");
+                calcTimer.addCount(((size_t)width)*numLinesInBlock);
+                for(int r = 0; r < numLinesInBlock; ++r)
+                {
+                    rowStart = ((size_t)r)*width;
+                    for(int n = 0; n < numInBands; n++)
+                    {
+                        inRows[n] = rsgisPixelsAsFloat(inputData[n]+rowStart, inRowScratch[n], width);
+                    }
+                    for(int n = 0; n < this->numOutBands; n++)
+                    {
+                        outRows[n] = rsgisPixelsCalcBuffer(outputData[n]+rowStart, outRowScratch[n]);
+                    }
+                    
+                    this->calc->calcImageBlock(inRows, numInBands, width, outRows);
+                    
+                    for(int n = 0; n < this->numOutBands; n++)
+                    {
+                        rsgisStoreCalcPixels(outRows[n], outputData[n]+rowStart, width);
+                    }
+                }
+                calcTimer.stop();
+                
+                rsgis::RSGISScopedTimer writeTimer("calcimage.write");
+                writeTimer.addBytes(sizeof(OutT)*this->numOutBands*((size_t)width)*numLinesInBlock);
+                for(int n = 0; n < this->numOutBands; n++)
+                {
+                    outputRasterBands[n]->RasterIO(GF_Write, 0, (yBlockSize * i), width, numLinesInBlock, outputData[n], width, numLinesInBlock, outGDALType, 0, 0);
+                }
+            }
+            pbar.finish();
+        }
+        catch(...)
+        {
+            this->freeNativeBlockBuffers(inputData, inRowScratch, inRows, numInBands, outputData, outRowScratch, outRows);
+            throw;
+        }
+        this->freeNativeBlockBuffers(inputData, inRowScratch, inRows, numInBands, outputData, outRowScratch, outRows);
+    }
+    
+    template <typename InT, typename OutT>
+    void RSGISCalcImage::freeNativeBlockBuffers(InT **inputData, float **inRowScratch, const float **inRows, int numInBands, OutT **outputData, double **outRowScratch, double **outRows)
+    {
+        for(int n = 0; n < numInBands; n++)
+        {
+            CPLFree(inputData[n]);
+            CPLFree(inRowScratch[n]);
+        }
+        delete[] inputData;
+        delete[] inRowScratch;
+        delete[] inRows;
         
-        try
+        for(int n = 0; n < this->numOutBands; n++)
         {
-            unsigned int imgWidth = dataset->GetRasterXSize();
-            unsigned int imgHeight = dataset->GetRasterYSize();
-            unsigned int numBands = dataset->GetRasterCount();
-            
-            GDALRasterBand **gdalBands = new GDALRasterBand*[numBands];
-            for(unsigned int i = 0; i < numBands; ++i)
+            CPLFree(outputData[n]);
+            CPLFree(outRowScratch[n]);
+        }
+        delete[] outputData;
+        delete[] outRowScratch;
+        delete[] outRows;
+    }
+    
+    bool RSGISCalcImage::useMultiThreaded()
+    {
+        return this->numThreads > 1;
+    }
+    
+    void RSGISCalcImage::calcImageBlocksMultiThreaded(GDALRasterBand **inputRasterBands, int **bandOffsets, int numInBands, GDALRasterBand **outputRasterBands, int width, int height, int yBlockSize)
+    {
+        int nYBlocks = height / yBlockSize;
+        int remainRows = height - (nYBlocks * yBlockSize);
+        int nBlocks = nYBlocks;
+        if(remainRows > 0)
+        {
+            ++nBlocks;
+        }
+        
+        // Each worker needs its own calculator unless the calculator is thread safe.
+        std::vector<RSGISCalcImageValue*> workerCalcs;
+        std::vector<RSGISCalcImageValue*> clonedCalcs;
+        unsigned int nWorkers = std::min(this->numThreads, (unsigned int)nBlocks);
+        // The checkpointed state of an accumulating calculator must cover exactly the completed blocks.
+        if((this->activeCheckpoint != NULL) && this->calc->hasCheckpointState())
+        {
+            nWorkers = 1;
+        }
+        // A calcImage run from a worker of another pool (e.g., a pipeline stage) uses its one thread.
+        if(rsgis::utils::inWorkerThread())
+        {
+            nWorkers = 1;
+        }
+        workerCalcs.push_back(this->calc);
+        for(unsigned int t = 1; t < nWorkers; ++t)
+        {
+            if(this->calc->isThreadSafe())
             {
-                gdalBands[i] = dataset->GetRasterBand(i+1);
+                workerCalcs.push_back(this->calc);
             }
-            
-            unsigned int numfloatVals = 0;
-            float *pxlFloatVals = NULL;
-            unsigned int numIntVals = 0;
-            long *pxlIntVals = NULL;
-            if(returnInt)
+            else
             {
-                numIntVals = numBands;
-                pxlIntVals = new long[numIntVals];
+                RSGISCalcImageValue *clone = this->calc->getThreadClone();
+                if(clone == NULL)
+                {
+                    break;
+                }
+                clonedCalcs.push_back(clone);
+                workerCalcs.push_back(clone);
             }
-            else
+        }
+        nWorkers = workerCalcs.size();
+        
+        // GDAL dataset handles are not thread safe so all RasterIO calls are serialised.
+        std::mutex ioMutex;
+        int firstBlock = (this->activeCheckpoint != NULL)?this->activeCheckpoint->getBlocksDone():0;
+        RSGISImageReadPlanner readPlanner(inputRasterBands, bandOffsets, numInBands, width, height, yBlockSize);
+        // Workers add their rows to the counter, which reports from its own thread.
+        RSGISProgressCounter progress(height);
+        progress.set(std::min(firstBlock * yBlockSize, height));
+        
+        int nOutBands = this->numOutBands;
+        rsgis::utils::RSGISWorkerPool pool(nWorkers);
+        std::vector<float**> workerInputData;
+        std::vector<double**> workerOutputData;
+        for(unsigned int t = 0; t < pool.getNumThreads(); ++t)
+        {
+            float **inputData = new float*[numInBands];
+            for(int n = 0; n < numInBands; n++)
             {
-                numfloatVals = numBands;
-                pxlFloatVals = new float[numfloatVals];
+                inputData[n] = (float *) CPLMalloc(sizeof(float)*width*yBlockSize);
             }
-            
-            int tmpVal = 0;
-            
-            std::cout << "Processing Top and Bottom Pixels\n";
-            // Top and Bottom pixels
-            for(unsigned int x = 0; x < imgWidth; ++x)
+            workerInputData.push_back(inputData);
+            double **outputData = new double*[nOutBands];
+            for(int n = 0; n < nOutBands; n++)
             {
-                // Top
-                for(unsigned int b = 0; b < numBands; ++b)
+                outputData[n] = (double *) CPLMalloc(sizeof(double)*width*yBlockSize);
+            }
+            workerOutputData.push_back(outputData);
+        }
+        
+        std::exception_ptr error = nullptr;
+        try
+        {
+            pool.parallelFor(std::max(nBlocks - firstBlock, 0), [&](size_t item, unsigned int t)
+            {
+                int blockIdx = firstBlock + item;
+                RSGISCalcImageValue *workerCalc = workerCalcs.at(t);
+                float **inputData = workerInputData.at(t);
+                double **outputData = workerOutputData.at(t);
+                int rowOffset = yBlockSize * blockIdx;
+                int nRows = (blockIdx < nYBlocks)?yBlockSize:remainRows;
+                bool emptyBlock = false;
+            
                 {
-                    if(returnInt)
-                    {
-                        gdalBands[b]->RasterIO(GF_Read, x, 0, 1, 1, &tmpVal, 1, 1, GDT_Int32, 0, 0);
-                        pxlIntVals[b] = tmpVal;
-                    }
-                    else
+                    rsgis::RSGISScopedTimer waitTimer("calcimage.io_wait");
+                    std::lock_guard<std::mutex> ioLock(ioMutex);
+                    waitTimer.stop();
+                    emptyBlock = this->skipEmptyBlocks && this->isEmptyBlock(inputRasterBands, bandOffsets, numInBands, width, rowOffset, nRows);
+                    if(!emptyBlock)
                     {
-                        gdalBands[b]->RasterIO(GF_Read, x, 0, 1, 1, &pxlFloatVals[b], 1, 1, GDT_Float32, 0, 0);
+                        readPlanner.prefetch(blockIdx);
+                        rsgis::RSGISScopedTimer readTimer("calcimage.read");
+                        readTimer.addBytes(sizeof(float)*numInBands*((size_t)width)*nRows);
+                        for(int n = 0; n < numInBands; n++)
+                        {
+                            inputRasterBands[n]->RasterIO(GF_Read, bandOffsets[n][0], bandOffsets[n][1] + rowOffset, width, nRows, inputData[n], width, nRows, GDT_Float32, 0, 0);
+                        }
                     }
                 }
-                this->calc->calcImageValue(pxlIntVals, numIntVals, pxlFloatVals, numfloatVals);
-                
-                // Bottom
-                for(unsigned int b = 0; b < numBands; ++b)
+            
+                if(emptyBlock)
                 {
-                    if(returnInt)
-                    {
-                        gdalBands[b]->RasterIO(GF_Read, x, (imgHeight-1), 1, 1, &tmpVal, 1, 1, GDT_Int32, 0, 0);
-                        pxlIntVals[b] = tmpVal;
-                    }
-                    else
-                    {
-                        gdalBands[b]->RasterIO(GF_Read, x, (imgHeight-1), 1, 1, &pxlFloatVals[b], 1, 1, GDT_Float32, 0, 0);
-                    }
+                    this->fillEmptyBlock(outputData, ((size_t)width)*nRows);
+                }
+                else
+                {
+                    rsgis::RSGISScopedTimer calcTimer("calcimage.compute");
+                    calcTimer.addCount(((size_t)width)*nRows);
+                    workerCalc->calcImageBlock(inputData, numInBands, ((size_t)width)*nRows, outputData);
                 }
-                this->calc->calcImageValue(pxlIntVals, numIntVals, pxlFloatVals, numfloatVals);
-            }
             
-            std::cout << "Processing Left and Right Pixels\n";
-            // Left and right pixels
-            for(unsigned int y = 0; y < imgHeight; ++y)
-            {
-                // Left
-                for(unsigned int b = 0; b < numBands; ++b)
                 {
-                    if(returnInt)
-                    {
-                        gdalBands[b]->RasterIO(GF_Read, 0, y, 1, 1, &pxlIntVals[b], 1, 1, GDT_Int32, 0, 0);
-                    }
-                    else
+                    rsgis::RSGISScopedTimer waitTimer("calcimage.io_wait");
+                    std::lock_guard<std::mutex> ioLock(ioMutex);
+                    waitTimer.stop();
+                    if(!(emptyBlock && this->skipLeaveSparse))
                     {
-                        gdalBands[b]->RasterIO(GF_Read, 0, y, 1, 1, &pxlFloatVals[b], 1, 1, GDT_Float32, 0, 0);
+                        rsgis::RSGISScopedTimer writeTimer("calcimage.write");
+                        writeTimer.addBytes(sizeof(double)*nOutBands*((size_t)width)*nRows);
+                        for(int n = 0; n < nOutBands; n++)
+                        {
+                            outputRasterBands[n]->RasterIO(GF_Write, 0, rowOffset, width, nRows, outputData[n], width, nRows, GDT_Float64, 0, 0);
+                        }
                     }
-                }
-                this->calc->calcImageValue(pxlIntVals, numIntVals, pxlFloatVals, numfloatVals);
-                
-                // Right
-                for(unsigned int b = 0; b < numBands; ++b)
-                {
-                    if(returnInt)
+                    for(std::vector<RSGISImageOutputSink*>::iterator iterSink = this->outputSinks.begin(); iterSink != this->outputSinks.end(); ++iterSink)
                     {
-                        gdalBands[b]->RasterIO(GF_Read, (imgWidth-1), y, 1, 1, &pxlIntVals[b], 1, 1, GDT_Int32, 0, 0);
+                        (*iterSink)->addRows(outputData, nOutBands, width, rowOffset, nRows);
                     }
-                    else
+                    progress.add(nRows);
+                    if((this->activeCheckpoint != NULL) && this->activeCheckpoint->blockDone(blockIdx))
                     {
-                        gdalBands[b]->RasterIO(GF_Read, (imgWidth-1), y, 1, 1, &pxlFloatVals[b], 1, 1, GDT_Float32, 0, 0);
+                        this->activeCheckpoint->write(outputRasterBands[0]->GetDataset(), this->calc);
                     }
                 }
-                this->calc->calcImageValue(pxlIntVals, numIntVals, pxlFloatVals, numfloatVals);
-            }
-            
-            delete[] gdalBands;
-            delete[] pxlFloatVals;
-            delete[] pxlIntVals;
+            });
         }
-        catch (RSGISImageCalcException &e)
+        catch(...)
         {
-            throw e;
+            error = std::current_exception();
         }
-        catch (RSGISImageBandException &e)
+        progress.finish();
+        
+        for(unsigned int t = 0; t < workerInputData.size(); ++t)
         {
-            throw e;
+            for(int n = 0; n < numInBands; n++)
+            {
+                CPLFree(workerInputData[t][n]);
+            }
+            delete[] workerInputData[t];
+            for(int n = 0; n < nOutBands; n++)
+            {
+                CPLFree(workerOutputData[t][n]);
+            }
+            delete[] workerOutputData[t];
         }
-        catch (RSGISException &e)
+        for(std::vector<RSGISCalcImageValue*>::iterator iterCalcs = clonedCalcs.begin(); iterCalcs != clonedCalcs.end(); ++iterCalcs)
         {
-            throw RSGISImageCalcException(e.what());
+            delete *iterCalcs;
+        }
+        
+        if(error)
+        {
+            std::rethrow_exception(error);
         }
     }
     
@@ -14539,6 +15129,12 @@ namespace rsgis{namespace img{
     RSGISCalcImageMultiImgRes::RSGISCalcImageMultiImgRes(RSGISCalcValuesFromMultiResInputs *valueCalcSum)
     {
         this->valueCalcSum = valueCalcSum;
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+    
+    void RSGISCalcImageMultiImgRes::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
     }
     
     void RSGISCalcImageMultiImgRes::calcImageHighResForLowRegions(GDALDataset *refDataset, GDALDataset *statsDataset, unsigned int statsImgBand, std::string outputImage, std::string gdalFormat, GDALDataType gdalDataType, bool useNoDataVal, unsigned int xIOGrid, unsigned int yIOGrid, bool setOutNames, std::string *bandNames)
@@ -14661,14 +15257,9 @@ namespace rsgis{namespace img{
             long refPxlWidth = floor((xMaxOverlap - xMinOverlap)/xRefRes);
             long refPxlHeight = floor((yMaxOverlap - yMinOverlap)/yRefRes);
             
-            // Define the number of blocks in the X and Y needed to tranverse the image.
-            long nXBlocks = refPxlWidth / xIOGrid;
-            long remainCols = refPxlWidth - (nXBlocks * xIOGrid);
-            long remainColsStats = (remainCols * nXPxls);
-            
-            long nYBlocks = refPxlHeight / yIOGrid;
-            long remainRows = refPxlHeight - (nYBlocks * yIOGrid);
-            long remainRowsStats = (remainRows * nYPxls);
+            // The offset of the overlap within the stats image.
+            long statsXOff = (long)floor(((xMinOverlap - statsImgXMin)/xStatsRes) + 0.5);
+            long statsYOff = (long)floor(((statsImgYMax - yMaxOverlap)/yStatsRes) + 0.5);
             
             // Get Input Stats image band.
             GDALRasterBand *statsBand = statsDataset->GetRasterBand(statsImgBand);
@@ -14687,6 +15278,7 @@ namespace rsgis{namespace img{
             }
             std::cout << "New image width = " << refPxlWidth << " height = " << refPxlHeight << " bands = " << numOutImgBands << std::endl;
             char **papszOptions = imgUtils.getGDALCreationOptionsForFormat(gdalFormat);
+            RSGISDatasetCache::invalidate(outputImage);
             GDALDataset *outputImageDS = gdalDriver->Create(outputImage.c_str(), refPxlWidth, refPxlHeight, numOutImgBands, gdalDataType, papszOptions);
             
             if(outputImageDS == NULL)
@@ -14707,283 +15299,96 @@ namespace rsgis{namespace img{
             outputImageDS->SetGeoTransform(outImgTrans);
             outputImageDS->SetProjection(refDataset->GetProjectionRef());
             
-            // Block width in stats image pixels
-            long xIOGridStats = nXPxls * xIOGrid;
-            long yIOGridStats = nYPxls * yIOGrid;
-            long nStatsPixelsInRefPxl = nXPxls * nYPxls;
-            
-            // Create Data Arrays and open output bands
-            unsigned long numRefPxlsInBlock = xIOGrid * yIOGrid;
-            double **refDataArrOuts = new double*[numOutImgBands];
             GDALRasterBand **outBands = new GDALRasterBand*[numOutImgBands];
-            for(unsigned int i = 0; i < numOutImgBands; ++i)
+            for(int i = 0; i < numOutImgBands; ++i)
             {
                 outBands[i] = outputImageDS->GetRasterBand(i+1);
-                refDataArrOuts[i] = (double *) CPLMalloc(sizeof(double)*numRefPxlsInBlock);
-            }
-            
-            unsigned long numStatsPxlsInBlock = xIOGridStats * yIOGridStats;
-            float *statsDataArr = (float *) CPLMalloc(sizeof(float)*numStatsPxlsInBlock);
-            
-            float *statsPxlsInRefPxl = new float[nStatsPixelsInRefPxl];
-            double *outImgBandVals = new double[numOutImgBands];
-            
-            // Sort out stats for user feedback
-            long nBlocks = nXBlocks * nYBlocks;
-            if(remainCols > 0)
-            {
-                nBlocks += nYBlocks;
-            }
-            if(remainRows > 0)
-            {
-                nBlocks += nXBlocks;
-                if(remainCols > 0)
+                if(setOutNames && (bandNames != NULL))
                 {
-                    nBlocks += 1;
+                    outBands[i]->SetDescription(bandNames[i].c_str());
                 }
             }
             
-            int rowOffsetRef = 0;
-            int colOffsetRef = 0;
-            int rowOffsetStats = 0;
-            int colOffsetStats = 0;
+            // Strips of yIOGrid reference rows, split in the X axis only if too large.
+            size_t numCellPxls = ((size_t)nXPxls) * nYPxls;
+            long blockRows = std::max<long>(std::min<long>(yIOGrid, refPxlHeight), 1);
+            long blockCols = refPxlWidth;
+            if((((size_t)blockCols) * blockRows * numCellPxls) > maxBlockPxls)
+            {
+                blockCols = std::max<long>(maxBlockPxls / (blockRows * numCellPxls), 1);
+            }
+            long nXBlocks = (refPxlWidth + blockCols - 1) / blockCols;
+            long nYBlocks = (refPxlHeight + blockRows - 1) / blockRows;
+            long nBlocks = nXBlocks * nYBlocks;
             
-            int ib_rowOffStats = 0;
-            int ib_colOffStats = 0;
+            unsigned int numWorkers = this->valueCalcSum->isThreadSafe()?this->numThreads:1;
+            numWorkers = (unsigned int)std::max<long>(std::min<long>(numWorkers, nBlocks), 1);
             
-            long blockCounter = 0;
+            long blocksDone = 0;
+            std::mutex ioMutex;
+            std::exception_ptr error = NULL;
             rsgis_tqdm pbar;
-            for(long i = 0; i < nYBlocks; i++)
+            
+            rsgis::utils::RSGISWorkerPool pool(numWorkers);
+            std::vector<std::vector<float> > workerStatsVals(pool.getNumThreads(), std::vector<float>(((size_t)blockCols) * blockRows * numCellPxls));
+            std::vector<std::vector<double> > workerOutVals(pool.getNumThreads(), std::vector<double>(((size_t)blockCols) * blockRows * numOutImgBands));
+            std::vector<std::vector<double*> > workerOutPlanes(pool.getNumThreads(), std::vector<double*>(numOutImgBands));
+            try
             {
-                colOffsetStats = 0;
-                colOffsetRef = 0;
-                for(long j = 0; j < nXBlocks; j++)
+                pool.parallelFor(nBlocks, [&](size_t blockIdx, unsigned int t)
                 {
-                    pbar.progress(blockCounter, nBlocks);
-                    
-                    // Read Block
-                    if(statsBand->RasterIO(GF_Read, colOffsetStats, rowOffsetStats, xIOGridStats, yIOGridStats, statsDataArr, xIOGridStats, yIOGridStats, GDT_Float32, 0, 0))
-                    {
-                        throw RSGISImageException("Failed to read image data from stats band.");
-                    }
-                    
-                    // Process Block
-                    ib_rowOffStats = 0;
-                    ib_colOffStats = 0;
-                    for(int n = 0; n < yIOGrid; ++n)
-                    {
-                        ib_colOffStats = 0;
-                        for(int m = 0; m < xIOGrid; ++m)
-                        {
-                            for(int y = 0; y < nYPxls; ++y)
-                            {
-                                for(int x = 0; x < nXPxls; ++x)
-                                {
-                                    statsPxlsInRefPxl[(y*nYPxls)+x] = statsDataArr[(ib_colOffStats+x)+(ib_rowOffStats+(yIOGridStats*y))];
-                                }
-                            }
-                            
-                            valueCalcSum->calcImageValue(statsPxlsInRefPxl, nStatsPixelsInRefPxl, useNoDataVal, noDataVal, outImgBandVals);
-                            for(unsigned int b = 0; b < numOutImgBands; ++b)
-                            {
-                                refDataArrOuts[b][((n*xIOGrid)+m)] = outImgBandVals[b];
-                            }
-                            ib_colOffStats += nXPxls;
-                        }
-                        ib_rowOffStats += (nYPxls * (xIOGrid * nXPxls));
-                    }
-                    
-                    // Write Block
-                    for(unsigned int n = 0; n < numOutImgBands; ++n)
+                    std::vector<float> &statsVals = workerStatsVals[t];
+                    std::vector<double> &outVals = workerOutVals[t];
+                    std::vector<double*> &outPlanes = workerOutPlanes[t];
+                    long refRowOff = (blockIdx / nXBlocks) * blockRows;
+                    long refColOff = (blockIdx % nXBlocks) * blockCols;
+                    unsigned int numRows = std::min<long>(blockRows, refPxlHeight - refRowOff);
+                    unsigned int numCols = std::min<long>(blockCols, refPxlWidth - refColOff);
+                    size_t numBlockCells = ((size_t)numRows) * numCols;
+                    for(int b = 0; b < numOutImgBands; ++b)
                     {
-                        if(outBands[n]->RasterIO(GF_Write, colOffsetRef, rowOffsetRef, xIOGrid, yIOGrid, refDataArrOuts[n], xIOGrid, yIOGrid, GDT_Float64, 0, 0))
-                        {
-                            throw RSGISImageException("Failed to write image data to output image.");
-                        }
+                        outPlanes[b] = outVals.data() + (b * numBlockCells);
                     }
-                    
-                    ++blockCounter;
-                    colOffsetStats += xIOGridStats;
-                    colOffsetRef += xIOGrid;
-                }
                 
-                if(remainCols > 0)
-                {
-                    pbar.progress(blockCounter, nBlocks);
-                    
-                    // Read Block
-                    if(statsBand->RasterIO(GF_Read, colOffsetStats, rowOffsetStats, remainColsStats, yIOGridStats, statsDataArr, remainColsStats, yIOGridStats, GDT_Float32, 0, 0))
-                    {
-                        throw RSGISImageException("Failed to read image data from stats band.");
-                    }
-                    
-                    // Process Block
-                    ib_rowOffStats = 0;
-                    ib_colOffStats = 0;
-                    for(int n = 0; n < yIOGrid; ++n)
-                    {
-                        ib_colOffStats = 0;
-                        for(int m = 0; m < remainCols; ++m)
-                        {
-                            for(int y = 0; y < nYPxls; ++y)
-                            {
-                                for(int x = 0; x < nXPxls; ++x)
-                                {
-                                    statsPxlsInRefPxl[(y*nYPxls)+x] = statsDataArr[(ib_colOffStats+x)+(ib_rowOffStats+(yIOGridStats*y))];
-                                }
-                            }
-                            
-                            valueCalcSum->calcImageValue(statsPxlsInRefPxl, nStatsPixelsInRefPxl, useNoDataVal, noDataVal, outImgBandVals);
-                            for(unsigned int b = 0; b < numOutImgBands; ++b)
-                            {
-                                refDataArrOuts[b][((n*remainCols)+m)] = outImgBandVals[b];
-                            }
-                            ib_colOffStats += nXPxls;
-                        }
-                        ib_rowOffStats += (nYPxls * (remainCols * nXPxls));
-                    }
-                    
-                    // Write Block
-                    for(unsigned int n = 0; n < numOutImgBands; ++n)
                     {
-                        if(outBands[n]->RasterIO(GF_Write, colOffsetRef, rowOffsetRef, remainCols, yIOGrid, refDataArrOuts[n], remainCols, yIOGrid, GDT_Float64, 0, 0))
+                        std::lock_guard<std::mutex> lock(ioMutex);
+                        if(statsBand->RasterIO(GF_Read, statsXOff + (refColOff * nXPxls), statsYOff + (refRowOff * nYPxls), numCols * nXPxls, numRows * nYPxls, statsVals.data(), numCols * nXPxls, numRows * nYPxls, GDT_Float32, 0, 0) != CE_None)
                         {
-                            throw RSGISImageException("Failed to write image data to output image.");
+                            throw RSGISImageException("Failed to read image data from stats band.");
                         }
                     }
-                    
-                    ++blockCounter;
-                    colOffsetStats += remainColsStats;
-                    colOffsetRef += remainCols;
-                }
                 
-                rowOffsetStats += yIOGridStats;
-                rowOffsetRef += yIOGrid;
-            }
-            
-            if(remainRows > 0)
-            {
-                colOffsetStats = 0;
-                colOffsetRef = 0;
-                for(long j = 0; j < nXBlocks; j++)
-                {
-                    pbar.progress(blockCounter, nBlocks);
-                    
-                    // Read Block
-                    if(statsBand->RasterIO(GF_Read, colOffsetStats, rowOffsetStats, xIOGridStats, remainRowsStats, statsDataArr, xIOGridStats, remainRowsStats, GDT_Float32, 0, 0))
-                    {
-                        throw RSGISImageException("Failed to read image data from stats band.");
-                    }
-                    
-                    // Process Block
-                    ib_rowOffStats = 0;
-                    ib_colOffStats = 0;
-                    for(int n = 0; n < remainRows; ++n)
-                    {
-                        ib_colOffStats = 0;
-                        for(int m = 0; m < xIOGrid; ++m)
-                        {
-                            for(int y = 0; y < nYPxls; ++y)
-                            {
-                                for(int x = 0; x < nXPxls; ++x)
-                                {
-                                    statsPxlsInRefPxl[(y*nYPxls)+x] = statsDataArr[(ib_colOffStats+x)+(ib_rowOffStats+((remainRows*nYPxls)*y))];
-                                }
-                            }
-                            
-                            valueCalcSum->calcImageValue(statsPxlsInRefPxl, nStatsPixelsInRefPxl, useNoDataVal, noDataVal, outImgBandVals);
-                            for(unsigned int b = 0; b < numOutImgBands; ++b)
-                            {
-                                refDataArrOuts[b][((n*xIOGrid)+m)] = outImgBandVals[b];
-                            }
-                            ib_colOffStats += nXPxls;
-                        }
-                        ib_rowOffStats += (nYPxls * (xIOGrid * nXPxls));
-                    }
-                    
-                    // Write Block
-                    for(unsigned int n = 0; n < numOutImgBands; ++n)
-                    {
-                        if(outBands[n]->RasterIO(GF_Write, colOffsetRef, rowOffsetRef, xIOGrid, remainRows, refDataArrOuts[n], xIOGrid, remainRows, GDT_Float64, 0, 0))
-                        {
-                            throw RSGISImageException("Failed to write image data to output image.");
-                        }
-                    }
-                    
-                    ++blockCounter;
-                    colOffsetStats += xIOGridStats;
-                    colOffsetRef += xIOGrid;
-                }
+                    this->valueCalcSum->calcLowResBlock(statsVals.data(), numCols, numRows, nXPxls, nYPxls, useNoDataVal, noDataVal, outPlanes.data());
                 
-                if(remainCols > 0)
-                {
-                    pbar.progress(blockCounter, nBlocks);
-                    
-                    // Read Block
-                    if(statsBand->RasterIO(GF_Read, colOffsetStats, rowOffsetStats, remainColsStats, remainRowsStats, statsDataArr, remainColsStats, remainRowsStats, GDT_Float32, 0, 0))
-                    {
-                        throw RSGISImageException("Failed to read image data from stats band.");
-                    }
-                    
-                    // Process Block
-                    ib_rowOffStats = 0;
-                    ib_colOffStats = 0;
-                    for(int n = 0; n < remainRows; ++n)
-                    {
-                        ib_colOffStats = 0;
-                        for(int m = 0; m < remainCols; ++m)
-                        {
-                            for(int y = 0; y < nYPxls; ++y)
-                            {
-                                for(int x = 0; x < nXPxls; ++x)
-                                {
-                                    statsPxlsInRefPxl[(y*nYPxls)+x] = statsDataArr[(ib_colOffStats+x)+(ib_rowOffStats+((remainRows*nYPxls)*y))];
-                                }
-                            }
-                            
-                            valueCalcSum->calcImageValue(statsPxlsInRefPxl, nStatsPixelsInRefPxl, useNoDataVal, noDataVal, outImgBandVals);
-                            for(unsigned int b = 0; b < numOutImgBands; ++b)
-                            {
-                                refDataArrOuts[b][((n*remainCols)+m)] = outImgBandVals[b];
-                            }
-                            ib_colOffStats += nXPxls;
-                        }
-                        ib_rowOffStats += (nYPxls * (remainCols * nXPxls));
-                    }
-                    
-                    // Write Block
-                    for(unsigned int n = 0; n < numOutImgBands; ++n)
+                    std::lock_guard<std::mutex> lock(ioMutex);
+                    for(int b = 0; b < numOutImgBands; ++b)
                     {
-                        if(outBands[n]->RasterIO(GF_Write, colOffsetRef, rowOffsetRef, remainCols, remainRows, refDataArrOuts[n], remainCols, remainRows, GDT_Float64, 0, 0))
+                        if(outBands[b]->RasterIO(GF_Write, refColOff, refRowOff, numCols, numRows, outPlanes[b], numCols, numRows, GDT_Float64, 0, 0) != CE_None)
                         {
                             throw RSGISImageException("Failed to write image data to output image.");
                         }
                     }
-                    
-                    ++blockCounter;
-                    colOffsetStats += remainColsStats;
-                    colOffsetRef += remainCols;
-                }
-                rowOffsetStats += remainRowsStats;
-                rowOffsetRef += remainRows;
+                    pbar.progress(blocksDone++, nBlocks);
+                });
+            }
+            catch(...)
+            {
+                error = std::current_exception();
             }
-            pbar.finish();
-            
-            GDALClose(outputImageDS);
             
-            for(unsigned int i = 0; i < numOutImgBands; ++i)
+            if(error == NULL)
             {
-                delete[] refDataArrOuts[i];
+                pbar.finish();
             }
-            delete[] refDataArrOuts;
+            GDALClose(outputImageDS);
             delete[] outBands;
-            delete[] statsDataArr;
-            delete[] statsPxlsInRefPxl;
-            delete[] outImgBandVals;
-            
             delete[] refImgTrans;
             delete[] statsImgTrans;
             delete[] outImgTrans;
+            if(error != NULL)
+            {
+                std::rethrow_exception(error);
+            }
         }
         catch (RSGISImageException &e)
         {
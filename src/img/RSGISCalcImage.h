@@ -25,6 +25,14 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <exception>
+#include <algorithm>
+#include <cstdlib>
 
 #include "gdal_priv.h"
 
@@ -38,11 +46,23 @@
 #include "geos/geom/PrecisionModel.h"
 
 #include "common/rsgis-tqdm.h"
+#include "common/RSGISProfiler.h"
+#include "common/RSGISProgressCounter.h"
+#include "common/RSGISParallel.h"
 
 #include "img/RSGISPixelInPoly.h"
+#include "img/RSGISPolygonRasteriser.h"
 #include "img/RSGISImageCalcException.h"
 #include "img/RSGISCalcImageValue.h"
+#include "img/RSGISImageRowRingBuffer.h"
+#include "img/RSGISImageNativeIO.h"
+#include "img/RSGISImageBlockPipeline.h"
 #include "img/RSGISImageUtils.h"
+#include "img/RSGISDatasetCache.h"
+#include "img/RSGISImageBlockPlanner.h"
+#include "img/RSGISImageReadPlanner.h"
+#include "img/RSGISCOGWriter.h"
+#include "img/RSGISCalcImageCheckpoint.h"
 
 #include "math/RSGISMathsUtils.h"
 
@@ -63,6 +83,22 @@ namespace rsgis
 {
 	namespace img
 	{
+        /**
+         * Clears the output sinks and the active checkpoint of a RSGISCalcImage
+         * job when it leaves scope, however it exits, so a later (e.g., resumed)
+         * job on the same RSGISCalcImage is never given the (deleted) sinks or
+         * checkpoint of one which failed.
+         */
+        class DllExport RSGISCalcImageJobScope
+        {
+        public:
+            RSGISCalcImageJobScope(std::vector<RSGISImageOutputSink*> *outputSinks, RSGISCalcImageCheckpoint **activeCheckpoint): outputSinks(outputSinks), activeCheckpoint(activeCheckpoint){};
+            ~RSGISCalcImageJobScope(){this->outputSinks->clear(); *this->activeCheckpoint = NULL;};
+        protected:
+            std::vector<RSGISImageOutputSink*> *outputSinks;
+            RSGISCalcImageCheckpoint **activeCheckpoint;
+        };
+        
 		class DllExport RSGISCalcImage
 			{
 			public:
@@ -70,6 +106,13 @@ namespace rsgis
 				void calcImage(GDALDataset **datasets, int numDS, std::string outputImage, bool setOutNames = false, std::string *bandNames = NULL, std::string gdalFormat="KEA", GDALDataType gdalDataType=GDT_Float32);
                 void calcImage(GDALDataset **datasets, int numDS, std::string outputImage, std::string outputRefIntImage, std::string gdalFormat="KEA", GDALDataType gdalDataType=GDT_Float32);
 				void calcImage(GDALDataset **datasets, int numDS, GDALDataset *outputImageDS);
+                /**
+                 * Calculate the output bands into several datasets in one pass,
+                 * the bands of outputImageDSs being taken in order as the output
+                 * bands of the calculator. Each dataset must be the size of the
+                 * overlap of the inputs.
+                 */
+                void calcImage(GDALDataset **datasets, int numDS, GDALDataset **outputImageDSs, int numOutDS);
                 void calcImagePartialOutput(GDALDataset **datasets, int numDS, GDALDataset *outputImageDS);
 				void calcImage(GDALDataset **datasets, int numDS);
                 void calcImage(GDALDataset **datasets, int numIntDS, int numFloatDS, std::string outputImage, bool setOutNames = false, std::string *bandNames = NULL, std::string gdalFormat="KEA", GDALDataType gdalDataType=GDT_Float32);
@@ -90,29 +133,209 @@ namespace rsgis
                 void calcImageWindowData(GDALDataset **datasets, int numDS, std::string outputImage, std::string outputRefIntImage, int windowSize, std::string gdalFormat="KEA", GDALDataType gdalDataType=GDT_Float32);                
                 void calcImageWindowData(GDALDataset **datasets, int numDS, GDALDataset *outputImageDS, int windowSize, bool passPxlXY=false);
                 void calcImageWindowDataExtent(GDALDataset **datasets, int numDS, std::string outputImage, int windowSize, std::string gdalFormat="KEA", GDALDataType gdalDataType=GDT_Float32);
+                /**
+                 * calcImageWithinPolygon and calcImageWithinPolygonExtent test a
+                 * pixel geometry against the polygon for every pixel (with
+                 * RSGISPixelInPoly for most options) and only use the exterior
+                 * ring for those options; they are not used by the zonal stats.
+                 */
 				void calcImageWithinPolygon(GDALDataset **datasets, int numDS, std::string outputImage, geos::geom::Envelope *env, geos::geom::Polygon *poly, float nodata, pixelInPolyOption pixelPolyOption, std::string gdalFormat="KEA",  GDALDataType gdalDataType=GDT_Float32);
 				void calcImageWithinPolygon(GDALDataset **datasets, int numDS, geos::geom::Envelope *env, geos::geom::Polygon *poly, pixelInPolyOption pixelPolyOption);
                 void calcImageWithinPolygonExtent(GDALDataset **datasets, int numDS, geos::geom::Envelope *env, geos::geom::Polygon *poly, pixelInPolyOption pixelPolyOption);
+                /**
+                 * As calcImageWithinPolygonExtent but reading the envelope into
+                 * memory. The options supported by RSGISPolygonRasteriser find the
+                 * pixels by scanlining the polygon (honouring holes), a row span
+                 * at a time through calcImageRowExtent; the pixelAreaInPoly
+                 * option selects the pixels the polygon overlaps and, as before,
+                 * the calculator is given the pixel extent rather than the area.
+                 */
                 void calcImageWithinPolygonExtentInMem(GDALDataset **datasets, int numDS, geos::geom::Envelope *env, geos::geom::Polygon *poly, pixelInPolyOption pixelPolyOption);
 				void calcImageWithinRasterPolygon(GDALDataset **datasets, int numDS, geos::geom::Envelope *env, long fid);
                 void calcImageBorderPixels(GDALDataset *dataset, bool returnInt);
+                /**
+                 * Calculate the window (xOff, yOff, tileWidth, tileHeight) of the
+                 * output grid of calcImage, writing it to its own image (with
+                 * the geotransform of the window). The pixel values are those
+                 * calcImage would write for the window.
+                 */
+                void calcImageTile(GDALDataset **datasets, int numDS, std::string outputImage, int xOff, int yOff, int tileWidth, int tileHeight, bool setOutNames = false, std::string *bandNames = NULL, std::string gdalFormat="GTiff", GDALDataType gdalDataType=GDT_Float32);
+                /**
+                 * Calculate a quick look of calcImage at 1/factor of the
+                 * resolution of the input overlap. The inputs are read with
+                 * decimated RasterIO, so GDAL reads from an overview where the
+                 * inputs have one, and the same calculator is run on the
+                 * reduced grid. Intended as a preview so the blocks are
+                 * processed in order on a single thread without output
+                 * statistics, checkpoints or skipped blocks; a COG output is
+                 * written as a GeoTIFF. The output has the factor in its
+                 * RSGISLIB_QUICKLOOK_FACTOR metadata item.
+                 */
+                void calcImageQuickLook(GDALDataset **datasets, int numDS, std::string outputImage, unsigned int factor, bool setOutNames = false, std::string *bandNames = NULL, std::string gdalFormat="GTiff", GDALDataType gdalDataType=GDT_Float32);
+                /**
+                 * Set the number of worker threads used by calcImage. If the
+                 * RSGISCalcImageValue is neither thread safe nor provides a
+                 * thread clone then processing falls back to a single thread.
+                 * The default is read from the RSGISLIB_NUM_THREADS environment
+                 * variable (1 if not defined).
+                 */
+                void setNumThreads(unsigned int numThreads);
+                unsigned int getNumThreads();
+                /**
+                 * Overlap reading, calculating and writing blocks in calcImage
+                 * using separate reader and writer threads. Useful where I/O
+                 * latency is high (e.g., network storage). The default is read
+                 * from the RSGISLIB_PIPELINE_IO environment variable (off if
+                 * not defined).
+                 */
+                void setUsePipelinedIO(bool usePipelinedIO);
+                bool getUsePipelinedIO();
+                /**
+                 * Set the memory budget (in bytes) used to choose the number of
+                 * rows read per block in calcImage, 0 uses the
+                 * RSGISLIB_CALC_MEM_MB environment variable (in MB) or the
+                 * default. When a budget is given the GDAL block cache is also
+                 * resized while processing, see RSGISImageBlockPlanner.
+                 */
+                void setMemoryBudget(size_t memoryBudget);
+                size_t getMemoryBudget();
+                /**
+                 * Calculate the statistics and histograms (and optionally the
+                 * pyramids) of the output image from the blocks as they are
+                 * written, rather than reading the image again once complete.
+                 * Thematic outputs get a RAT histogram rather than binned
+                 * histograms. Only applies to calcImage with an output file
+                 * name and to non-COG pyramids (COG outputs always have
+                 * overviews). The default is read from the
+                 * RSGISLIB_OUTPUT_STATS environment variable (off if not
+                 * defined, >0 for statistics and pyramids).
+                 */
+                void setOutputStats(bool calcStats, bool calcPyramids=true, bool thematic=false, bool useNoData=false, float noDataVal=0);
+                /**
+                 * Run calcImage (with an output file name) as a work queue of
+                 * tiles within queueDIR on shared storage, so the same command
+                 * run on several nodes shares the work, see
+                 * RSGISCalcImageTileQueue. An empty queueDIR (the default)
+                 * turns the queue off; it is only used where set for the job.
+                 * A tileSize of 0 uses RSGISLIB_TILE_SIZE or 4096, and a claim
+                 * not touched for claimTimeoutSecs is taken over by another
+                 * process.
+                 */
+                void setTileQueue(std::string queueDIR, unsigned int tileSize=0, unsigned int claimTimeoutSecs=600);
+                /**
+                 * The calculator used for each pixel.
+                 */
+                RSGISCalcImageValue* getCalcImageValue(){return this->calc;};
+                /**
+                 * Checkpoint calcImage every intervalSecs seconds (0 turns
+                 * checkpointing off) so a job which fails can be resumed,
+                 * skipping the blocks already written, see
+                 * RSGISCalcImageCheckpoint. With resume true an existing
+                 * checkpoint of the same job is resumed, otherwise the job
+                 * starts again. The checkpoint is written alongside the output
+                 * image (with '.rsgisckpt' appended) unless checkpointFile is
+                 * given, which is needed to checkpoint the state of calculators
+                 * run without an output image. COG outputs cannot be
+                 * checkpointed. The defaults are read from the
+                 * RSGISLIB_CHECKPOINT_SECS and RSGISLIB_CHECKPOINT_RESUME (>0 to
+                 * resume) environment variables (off if not defined).
+                 */
+                void setCheckpoint(unsigned int intervalSecs, bool resume=true, std::string checkpointFile="");
+                /**
+                 * Skip the blocks of calcImage (with an output image) which
+                 * have no valid input. A block is empty when the driver
+                 * reports every input band as empty over it
+                 * (GDALGetDataCoverageStatus, e.g., sparse GeoTIFF or KEA
+                 * tiles which were never written) or, if maskDataset is given,
+                 * when band 1 of the mask (which must have the size of the
+                 * output image) is zero over the whole block. Empty blocks are
+                 * not read or calculated but filled with outNoDataVal, which is
+                 * set as the no data value of the output bands, or with
+                 * leaveSparse are not written at all so a driver supporting
+                 * sparse files leaves them unallocated. The calculator is
+                 * assumed to give outNoDataVal where there is no valid input.
+                 * The default is read from the RSGISLIB_SKIP_EMPTY_BLOCKS
+                 * environment variable (off if not defined, 2 to leave the
+                 * blocks sparse).
+                 */
+                void setSkipEmptyBlocks(bool skipEmptyBlocks, float outNoDataVal=0, bool leaveSparse=false, GDALDataset *maskDataset=NULL);
+                /**
+                 * Make calcImage (with an output file name) write a quick
+                 * look at 1/factor of the resolution, see calcImageQuickLook,
+                 * so a command can be previewed with unchanged inputs.
+                 * A factor of 0 or 1 (the default) turns quick looks off; it
+                 * is only used where set for the call. A warning is printed
+                 * when a quick look is written in place of the output.
+                 */
+                void setQuickLook(unsigned int factor);
                 virtual ~RSGISCalcImage();
 			private:
+                void calcImageWithinPolygonSpansInMem(GDALDataset **datasets, int numDS, geos::geom::Envelope *env, geos::geom::Polygon *poly, pixelInPolyOption pixelPolyOption);
+                bool useMultiThreaded();
+                RSGISImageBlockPlan planBlocks(GDALRasterBand **inputRasterBands, int numInBands, GDALRasterBand **outputRasterBands, int width, int height, int yBlockSize, bool serialOnly=false);
+                void calcImageBlocksMultiThreaded(GDALRasterBand **inputRasterBands, int **bandOffsets, int numInBands, GDALRasterBand **outputRasterBands, int width, int height, int yBlockSize);
+                bool canPipelineIO(GDALRasterBand **inputRasterBands, int numInBands, GDALRasterBand **outputRasterBands);
+                void prepareSkipEmptyBlocks(GDALRasterBand **outputRasterBands, int width, int height);
+                bool isEmptyBlock(GDALRasterBand **inputRasterBands, int **bandOffsets, int numInBands, int width, int rowOffset, int nRows);
+                void fillEmptyBlock(double **outputData, size_t numPxls);
+                void calcImageBlocksPipelined(GDALRasterBand **inputRasterBands, int **bandOffsets, int numInBands, GDALRasterBand **outputRasterBands, int width, int height, int yBlockSize);
+                bool calcImageBlocksNativeTypes(GDALRasterBand **inputRasterBands, int **bandOffsets, int numInBands, GDALRasterBand **outputRasterBands, int width, int height, int yBlockSize);
+                template <typename InT> bool calcImageBlocksNativeOutType(GDALRasterBand **inputRasterBands, int **bandOffsets, int numInBands, GDALRasterBand **outputRasterBands, GDALDataType outType, int width, int height, int yBlockSize);
+                template <typename InT, typename OutT> void calcImageBlocksNative(GDALRasterBand **inputRasterBands, int **bandOffsets, int numInBands, GDALRasterBand **outputRasterBands, int width, int height, int yBlockSize);
+                template <typename InT, typename OutT> void freeNativeBlockBuffers(InT **inputData, float **inRowScratch, const float **inRows, int numInBands, OutT **outputData, double **outRowScratch, double **outRows);
+                void freeWindowDataBuffers(double *gdalTranslation, int **dsOffsets, int numDS, int **bandOffsets, int numInBands, RSGISImageRowRingBuffer *ringBuffer, float ***inDataBlock, int windowSize, double **outputData, double *outDataColumn);
 				RSGISCalcImageValue *calc;
 				int numOutBands;
 				std::string proj;
 				bool useImageProj;
+                unsigned int numThreads;
+                bool usePipelinedIO;
+                RSGISImageBlockPlanner blockPlanner;
+                std::vector<RSGISImageOutputSink*> outputSinks;
+                bool calcOutputStats;
+                bool calcOutputPyramids;
+                bool outputThematic;
+                bool outputStatsUseNoData;
+                float outputStatsNoDataVal;
+                std::string tileQueueDIR;
+                unsigned int tileQueueSize;
+                unsigned int tileQueueClaimTimeout;
+                unsigned int checkpointSecs;
+                bool checkpointResume;
+                std::string checkpointFile;
+                RSGISCalcImageCheckpoint *activeCheckpoint;
+                bool skipEmptyBlocks;
+                bool skipLeaveSparse;
+                float skipNoDataVal;
+                GDALDataset *skipMaskDataset;
+                unsigned int quickLookFactor;
 			};
         
         
+        /**
+         * Calculate values for each pixel of a low resolution reference image
+         * from the pixels of a high resolution image within it. The high
+         * resolution image is read in strips of yIOGrid low resolution rows
+         * (split across the image width only where a strip would be more than
+         * maxBlockPxls pixels) which are reduced to the low resolution cells by
+         * RSGISCalcValuesFromMultiResInputs::calcLowResBlock, with the strips
+         * processed in parallel when the calculator is thread safe. xIOGrid is
+         * no longer used as the strips span the image.
+         */
         class DllExport RSGISCalcImageMultiImgRes
         {
         public:
             RSGISCalcImageMultiImgRes(RSGISCalcValuesFromMultiResInputs *valueCalcSum);
             void calcImageHighResForLowRegions(GDALDataset *refDataset, GDALDataset *statsDataset, unsigned int statsImgBand, std::string outputImage, std::string gdalFormat="KEA", GDALDataType gdalDataType=GDT_Float32, bool useNoDataVal=true, unsigned int xIOGrid=16, unsigned int yIOGrid=16, bool setOutNames = false, std::string *bandNames = NULL);
+            /**
+             * The number of strips processed at once (default RSGISLIB_NUM_THREADS or 1); 0 uses the number of cores.
+             */
+            void setNumThreads(unsigned int numThreads);
             virtual ~RSGISCalcImageMultiImgRes();
         protected:
+            static const size_t maxBlockPxls = 33554432;
             RSGISCalcValuesFromMultiResInputs *valueCalcSum;
+            unsigned int numThreads;
         };
         
         
@@ -0,0 +1,261 @@
+/*
+ *  RSGISCalcImageCheckpoint.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISCalcImageCheckpoint.h"
+
+namespace rsgis{namespace img{
+
+    RSGISCalcImageCheckpoint::RSGISCalcImageCheckpoint(std::string checkpointFile, unsigned int intervalSecs)
+    {
+        this->checkpointFile = checkpointFile;
+        this->stateFile = checkpointFile + std::string(".state");
+        this->intervalSecs = intervalSecs;
+        this->width = 0;
+        this->height = 0;
+        this->numOutBands = 0;
+        this->blockRows = 0;
+        this->blocksDone = 0;
+        this->lastWrite = std::chrono::steady_clock::now();
+    }
+
+    bool RSGISCalcImageCheckpoint::exists()
+    {
+        return boost::filesystem::exists(this->checkpointFile);
+    }
+
+    bool RSGISCalcImageCheckpoint::load(int width, int height, int numOutBands, GDALDataType gdalDataType, const std::vector<std::string> &inputs, RSGISCalcImageValue *calc)
+    {
+        std::ifstream manifest(this->checkpointFile.c_str());
+        if(!manifest.is_open())
+        {
+            return false;
+        }
+        std::string header;
+        std::getline(manifest, header);
+        if(header != "RSGISCalcImageCheckpoint 2")
+        {
+            return false;
+        }
+        int ckWidth = -1;
+        int ckHeight = -1;
+        int ckBands = -1;
+        int ckBlockRows = 0;
+        int ckBlocksDone = -1;
+        bool ckState = false;
+        std::vector<std::string> ckJobLines;
+        std::string line;
+        while(std::getline(manifest, line))
+        {
+            std::string key = line.substr(0, line.find(' '));
+            std::string value = (line.find(' ') == std::string::npos)?"":line.substr(line.find(' ') + 1);
+            if(key == "width") { ckWidth = atoi(value.c_str()); }
+            else if(key == "height") { ckHeight = atoi(value.c_str()); }
+            else if(key == "bands") { ckBands = atoi(value.c_str()); }
+            else if(key == "blockrows") { ckBlockRows = atoi(value.c_str()); }
+            else if(key == "blocksdone") { ckBlocksDone = atoi(value.c_str()); }
+            else if(key == "state") { ckState = (atoi(value.c_str()) > 0); }
+            else if((key == "datatype") || (key == "calculator") || (key == "params") || (key == "input")) { ckJobLines.push_back(line); }
+        }
+        std::vector<std::string> jobLines = RSGISCalcImageCheckpoint::createJobLines(gdalDataType, inputs, calc);
+        if((ckWidth != width) || (ckHeight != height) || (ckBands != numOutBands) || (ckBlockRows <= 0) || (ckBlocksDone < 0) || (ckState != calc->hasCheckpointState()))
+        {
+            return false;
+        }
+        if(ckJobLines != jobLines)
+        {
+            std::cout << "The checkpoint " << this->checkpointFile << " is of a different calculator, data type or inputs (or the inputs have changed) so is not resumed." << std::endl;
+            return false;
+        }
+
+        if(ckState)
+        {
+            std::ifstream stateStream(this->stateFile.c_str(), std::ios::in | std::ios::binary);
+            int64_t stateBlocks = -1;
+            stateStream.read((char *) &stateBlocks, sizeof(int64_t));
+            if((!stateStream) || (stateBlocks != ckBlocksDone))
+            {
+                return false;
+            }
+            calc->readCheckpointState(stateStream);
+            if(stateStream.fail())
+            {
+                throw RSGISImageCalcException("Could not read the calculator state from the checkpoint: " + this->stateFile);
+            }
+        }
+
+        this->width = width;
+        this->height = height;
+        this->numOutBands = numOutBands;
+        this->blockRows = ckBlockRows;
+        this->blocksDone = ckBlocksDone;
+        this->blocksDoneAfter.clear();
+        this->jobLines = jobLines;
+        this->lastWrite = std::chrono::steady_clock::now();
+        return true;
+    }
+
+    void RSGISCalcImageCheckpoint::start(int width, int height, int numOutBands, GDALDataType gdalDataType, int blockRows, const std::vector<std::string> &inputs, RSGISCalcImageValue *calc)
+    {
+        this->width = width;
+        this->height = height;
+        this->numOutBands = numOutBands;
+        this->blockRows = blockRows;
+        this->blocksDone = 0;
+        this->blocksDoneAfter.clear();
+        this->jobLines = RSGISCalcImageCheckpoint::createJobLines(gdalDataType, inputs, calc);
+        this->lastWrite = std::chrono::steady_clock::now();
+        boost::system::error_code ec;
+        boost::filesystem::remove(this->checkpointFile, ec);
+        boost::filesystem::remove(this->stateFile, ec);
+    }
+
+    int RSGISCalcImageCheckpoint::getBlockRows()
+    {
+        return this->blockRows;
+    }
+
+    int RSGISCalcImageCheckpoint::getBlocksDone()
+    {
+        return this->blocksDone;
+    }
+
+    bool RSGISCalcImageCheckpoint::blockDone(int blockIdx)
+    {
+        // Blocks can complete out of order (on several threads) so only the
+        // run of complete blocks from the start is checkpointed.
+        this->blocksDoneAfter.insert(blockIdx);
+        while((!this->blocksDoneAfter.empty()) && (*this->blocksDoneAfter.begin() == this->blocksDone))
+        {
+            this->blocksDoneAfter.erase(this->blocksDoneAfter.begin());
+            ++this->blocksDone;
+        }
+        return std::chrono::steady_clock::now() >= (this->lastWrite + std::chrono::seconds(this->intervalSecs));
+    }
+
+    void RSGISCalcImageCheckpoint::write(GDALDataset *outputDS, RSGISCalcImageValue *calc)
+    {
+        if(outputDS != NULL)
+        {
+            outputDS->FlushCache();
+        }
+        try
+        {
+            bool hasState = calc->hasCheckpointState();
+            if(hasState)
+            {
+                std::string tmpStateFile = this->stateFile + std::string(".tmp");
+                std::ofstream stateStream(tmpStateFile.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+                int64_t stateBlocks = this->blocksDone;
+                stateStream.write((const char *) &stateBlocks, sizeof(int64_t));
+                calc->writeCheckpointState(stateStream);
+                stateStream.close();
+                if(stateStream.fail())
+                {
+                    throw RSGISImageCalcException("Could not write the calculator state to the checkpoint: " + tmpStateFile);
+                }
+                boost::filesystem::rename(tmpStateFile, this->stateFile);
+            }
+
+            std::string tmpFile = this->checkpointFile + std::string(".tmp");
+            std::ofstream manifest(tmpFile.c_str(), std::ios::out | std::ios::trunc);
+            manifest << "RSGISCalcImageCheckpoint 2\n";
+            manifest << "width " << this->width << "\n";
+            manifest << "height " << this->height << "\n";
+            manifest << "bands " << this->numOutBands << "\n";
+            manifest << "blockrows " << this->blockRows << "\n";
+            manifest << "blocksdone " << this->blocksDone << "\n";
+            manifest << "state " << (hasState?1:0) << "\n";
+            for(std::vector<std::string>::iterator iterLine = this->jobLines.begin(); iterLine != this->jobLines.end(); ++iterLine)
+            {
+                manifest << *iterLine << "\n";
+            }
+            manifest.close();
+            if(manifest.fail())
+            {
+                throw RSGISImageCalcException("Could not write the checkpoint: " + tmpFile);
+            }
+            boost::filesystem::rename(tmpFile, this->checkpointFile);
+        }
+        catch(boost::filesystem::filesystem_error &e)
+        {
+            throw RSGISImageCalcException(e.what());
+        }
+        this->lastWrite = std::chrono::steady_clock::now();
+    }
+
+    void RSGISCalcImageCheckpoint::finish()
+    {
+        boost::system::error_code ec;
+        boost::filesystem::remove(this->checkpointFile, ec);
+        boost::filesystem::remove(this->stateFile, ec);
+    }
+
+    std::vector<std::string> RSGISCalcImageCheckpoint::createJobLines(GDALDataType gdalDataType, const std::vector<std::string> &inputs, RSGISCalcImageValue *calc)
+    {
+        std::vector<std::string> jobLines;
+        jobLines.push_back(std::string("datatype ") + GDALGetDataTypeName(gdalDataType));
+        jobLines.push_back(std::string("calculator ") + typeid(*calc).name());
+        jobLines.push_back(std::string("params ") + RSGISCalcImageCheckpoint::hashString(calc->getParameterHash()));
+        for(std::vector<std::string>::const_iterator iterInput = inputs.begin(); iterInput != inputs.end(); ++iterInput)
+        {
+            // The stamp goes first as the file name can contain spaces.
+            jobLines.push_back(std::string("input ") + RSGISCalcImageCheckpoint::getFileStamp(*iterInput) + std::string(" ") + *iterInput);
+        }
+        return jobLines;
+    }
+
+    std::string RSGISCalcImageCheckpoint::getFileStamp(std::string filePath)
+    {
+        boost::system::error_code ec;
+        boost::uintmax_t fileSize = boost::filesystem::file_size(filePath, ec);
+        if(ec)
+        {
+            fileSize = 0;
+        }
+        std::time_t modified = boost::filesystem::last_write_time(filePath, ec);
+        if(ec)
+        {
+            modified = 0;
+        }
+        return std::to_string(fileSize) + std::string(" ") + std::to_string((long long)modified);
+    }
+
+    std::string RSGISCalcImageCheckpoint::hashString(std::string value)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        for(std::string::iterator iterChar = value.begin(); iterChar != value.end(); ++iterChar)
+        {
+            hash ^= (unsigned char)(*iterChar);
+            hash *= 1099511628211ULL;
+        }
+        std::stringstream hashStr;
+        hashStr << std::hex << hash;
+        return hashStr.str();
+    }
+
+    RSGISCalcImageCheckpoint::~RSGISCalcImageCheckpoint()
+    {
+
+    }
+
+}}
@@ -0,0 +1,139 @@
+/*
+ *  RSGISCalcImageCheckpoint.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISCalcImageCheckpoint_H
+#define RSGISCalcImageCheckpoint_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <chrono>
+#include <ctime>
+#include <cstdint>
+#include <typeinfo>
+
+#include <boost/filesystem.hpp>
+
+#include "gdal_priv.h"
+
+#include "img/RSGISImageCalcException.h"
+#include "img/RSGISCalcImageValue.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_img_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace img{
+
+    /**
+     * The job state of a calcImage run so it can be resumed after a failure.
+     * The blocks of rows are recorded as they complete and, every intervalSecs
+     * seconds, the output is flushed and a small text manifest is written with
+     * the number of leading blocks which are complete, along with the job:
+     * the grid, block size and output data type, the calculator (its type and
+     * a hash of getParameterHash) and the inputs (file name, size and
+     * modification time), so a checkpoint of a different job, or of inputs
+     * which have since changed, is not resumed. The state of accumulating calculators (see
+     * RSGISCalcImageValue::hasCheckpointState) is written to a second file
+     * (the manifest path with '.state' appended) before the manifest, tagged
+     * with the number of blocks it covers. Both are written to a temporary
+     * file and renamed so a failure while checkpointing leaves the previous
+     * checkpoint.
+     */
+    class DllExport RSGISCalcImageCheckpoint
+    {
+    public:
+        RSGISCalcImageCheckpoint(std::string checkpointFile, unsigned int intervalSecs);
+        bool exists();
+        /**
+         * Read the checkpoint, returning false if there is none or it is not
+         * of a job with the same grid, number of output bands, output data
+         * type, calculator and inputs (with the same sizes and modification
+         * times). The calculator state is read into calc if it was
+         * checkpointed.
+         */
+        bool load(int width, int height, int numOutBands, GDALDataType gdalDataType, const std::vector<std::string> &inputs, RSGISCalcImageValue *calc);
+        /**
+         * Start a new job, processed in blocks of blockRows rows.
+         */
+        void start(int width, int height, int numOutBands, GDALDataType gdalDataType, int blockRows, const std::vector<std::string> &inputs, RSGISCalcImageValue *calc);
+        int getBlockRows();
+        /**
+         * The number of leading blocks which are complete (where a resumed job starts).
+         */
+        int getBlocksDone();
+        /**
+         * Record the block as complete, returning true if a checkpoint is due.
+         */
+        bool blockDone(int blockIdx);
+        /**
+         * Flush the output (if not NULL) and write the checkpoint.
+         */
+        void write(GDALDataset *outputDS, RSGISCalcImageValue *calc);
+        /**
+         * Remove the checkpoint files once the job is complete.
+         */
+        void finish();
+        /**
+         * The size and modification time of a file ("0 0" if it does not
+         * exist, e.g., a dataset which is not a file).
+         */
+        static std::string getFileStamp(std::string filePath);
+        /**
+         * FNV-1a hash of the value (the same on every platform), as hex.
+         */
+        static std::string hashString(std::string value);
+        ~RSGISCalcImageCheckpoint();
+    protected:
+        /**
+         * The calculator and inputs lines of the manifest.
+         */
+        static std::vector<std::string> createJobLines(GDALDataType gdalDataType, const std::vector<std::string> &inputs, RSGISCalcImageValue *calc);
+        std::string checkpointFile;
+        std::string stateFile;
+        unsigned int intervalSecs;
+        int width;
+        int height;
+        int numOutBands;
+        int blockRows;
+        int blocksDone;
+        std::set<int> blocksDoneAfter;
+        std::vector<std::string> jobLines;
+        std::chrono::steady_clock::time_point lastWrite;
+    };
+
+}}
+
+#endif
@@ -129,4 +129,320 @@ namespace rsgis{namespace img{
         delete[] this->first;
     }
     
+    
+    const size_t RSGISLocalMinInWinFilter::colChunkSize = 256;
+    
+    RSGISLocalMinInWinFilter::RSGISLocalMinInWinFilter(std::vector<unsigned int> bands, float noDataValue, bool useNoDataValue)
+    {
+        this->bands = bands;
+        this->noDataValue = noDataValue;
+        this->useNoDataValue = useNoDataValue;
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+    
+    void RSGISLocalMinInWinFilter::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+    
+    void RSGISLocalMinInWinFilter::calcRunningMin(const float *in, size_t inStride, size_t numOut, int winSize, float *out, size_t outStride, std::vector<size_t> &dequeBuf)
+    {
+        // The deque (dequeBuf[head] to dequeBuf[tail-1]) holds the indexes of
+        // increasing values, the first being the minimum of the window.
+        size_t numIn = numOut + winSize - 1;
+        if(dequeBuf.size() < numIn)
+        {
+            dequeBuf.resize(numIn);
+        }
+        size_t head = 0;
+        size_t tail = 0;
+        for(size_t i = 0; i < numIn; ++i)
+        {
+            float val = in[i * inStride];
+            while((tail > head) && (in[dequeBuf[tail-1] * inStride] >= val))
+            {
+                --tail;
+            }
+            dequeBuf[tail++] = i;
+            if((i + 1) >= ((size_t)winSize))
+            {
+                size_t outIdx = (i + 1) - winSize;
+                if(dequeBuf[head] < outIdx)
+                {
+                    ++head;
+                }
+                out[outIdx * outStride] = in[dequeBuf[head] * inStride];
+            }
+        }
+    }
+    
+    void RSGISLocalMinInWinFilter::calcLocalMinInWin(GDALDataset *inDataset, int winSize, GDALDataset *outDataset, GDALDataset *outRefDataset)
+    {
+        if(winSize % 2 == 0)
+        {
+            throw RSGISImageCalcException("Window size needs to be an odd number (min = 3).");
+        }
+        else if(winSize < 3)
+        {
+            throw RSGISImageCalcException("Window size needs to be 3 or greater and an odd number.");
+        }
+        int width = inDataset->GetRasterXSize();
+        int height = inDataset->GetRasterYSize();
+        int numBands = inDataset->GetRasterCount();
+        if((outDataset->GetRasterXSize() != width) || (outDataset->GetRasterYSize() != height) || (outRefDataset->GetRasterXSize() != width) || (outRefDataset->GetRasterYSize() != height))
+        {
+            throw RSGISImageCalcException("The output images must be the same size as the input image.");
+        }
+        if(this->bands.empty())
+        {
+            throw RSGISImageCalcException("At least one band must be specified.");
+        }
+        for(std::vector<unsigned int>::iterator iterBand = this->bands.begin(); iterBand != this->bands.end(); ++iterBand)
+        {
+            if((*iterBand == 0) || (*iterBand > ((unsigned int)numBands)))
+            {
+                throw RSGISImageCalcException("A band is not within the input image.");
+            }
+        }
+        if((width == 0) || (height == 0))
+        {
+            return;
+        }
+        
+        // Only the selected bands are read unless the centre pixel is
+        // checked for no data, which uses all of them.
+        std::vector<int> readBands;
+        std::vector<size_t> bandPlanes(this->bands.size());
+        if(this->useNoDataValue)
+        {
+            for(int n = 0; n < numBands; ++n)
+            {
+                readBands.push_back(n+1);
+            }
+            for(size_t n = 0; n < this->bands.size(); ++n)
+            {
+                bandPlanes[n] = this->bands[n] - 1;
+            }
+        }
+        else
+        {
+            for(size_t n = 0; n < this->bands.size(); ++n)
+            {
+                readBands.push_back(this->bands[n]);
+                bandPlanes[n] = n;
+            }
+        }
+        size_t numReadBands = readBands.size();
+        size_t numSelBands = this->bands.size();
+        
+        RSGISImageBlockPipeline pipeline;
+        unsigned int numSlots = pipeline.getNumSlots();
+        int xBlockSize = 0;
+        int yBlockSize = 0;
+        inDataset->GetRasterBand(1)->GetBlockSize(&xBlockSize, &yBlockSize);
+        size_t bufBytesPerPxl = (numReadBands + numSelBands + 2) * sizeof(float);
+        RSGISImageBlockPlanner planner;
+        RSGISImageBlockPlan blockPlan = planner.plan(yBlockSize, width, height, bufBytesPerPxl, numSlots, numReadBands * (GDALGetDataTypeSize(inDataset->GetRasterBand(1)->GetRasterDataType()) / 8));
+        int numRows = std::min(std::max(blockPlan.rows, winSize), height);
+        RSGISGDALCacheScope gdalCacheScope(blockPlan.gdalCacheBytes);
+        
+        // The input is held with winSize / 2 pixels of padding on each side.
+        const int halfWin = winSize / 2;
+        const size_t paddedWidth = width + (2 * halfWin);
+        const size_t paddedRows = numRows + (2 * halfWin);
+        const size_t paddedPlane = paddedWidth * paddedRows;
+        const size_t numPxlsInBlock = ((size_t)width) * numRows;
+        unsigned int nBlocks = (height + numRows - 1) / numRows;
+        std::vector<std::vector<float> > inBufs(numSlots);
+        std::vector<std::vector<float> > outBufs(numSlots);
+        std::vector<std::vector<unsigned int> > outRefBufs(numSlots);
+        for(unsigned int s = 0; s < numSlots; ++s)
+        {
+            inBufs[s].resize(paddedPlane * numReadBands);
+            outBufs[s].resize(numPxlsInBlock);
+            outRefBufs[s].resize(numPxlsInBlock);
+        }
+        // The minima of each selected band along the rows, and then over the window.
+        std::vector<float> winMins(numSelBands * paddedRows * width);
+        
+        auto blockLines = [&](unsigned int block){ return std::min(numRows, height - (int)(block * numRows)); };
+        
+        auto readBlock = [&](unsigned int block, unsigned int slot)
+        {
+            int numLines = blockLines(block);
+            int firstRow = (block * numRows) - halfWin;
+            int readStart = std::max(firstRow, 0);
+            int readEnd = std::min((int)(block * numRows) + numLines + halfWin, height);
+            std::fill(inBufs[slot].begin(), inBufs[slot].end(), 0.0f);
+            float *start = &inBufs[slot][(((size_t)(readStart - firstRow)) * paddedWidth) + halfWin];
+            if(inDataset->RasterIO(GF_Read, 0, readStart, width, readEnd - readStart, start, width, readEnd - readStart, GDT_Float32, numReadBands, readBands.data(), sizeof(float), paddedWidth * sizeof(float), paddedPlane * sizeof(float)) != CE_None)
+            {
+                throw RSGISImageCalcException("Could not read a block from the input image.");
+            }
+        };
+        
+        // The pool is kept for all the blocks (calcBlock is only called from this thread).
+        rsgis::utils::RSGISWorkerPool pool(this->numThreads);
+        auto calcBlock = [&](unsigned int block, unsigned int slot)
+        {
+            const size_t numLines = blockLines(block);
+            const size_t numInRows = numLines + (2 * halfWin);
+            const float *inBuf = inBufs[slot].data();
+            const float inf = std::numeric_limits<float>::infinity();
+            
+            // Along the rows, with no data as infinity.
+            const size_t rowChunk = std::max<size_t>(1, (numInRows + this->numThreads - 1) / this->numThreads);
+            const size_t numRowChunks = (numInRows + rowChunk - 1) / rowChunk;
+            pool.parallelFor(numSelBands * numRowChunks, [&](size_t task, unsigned int)
+            {
+                size_t n = task / numRowChunks;
+                size_t rowBegin = (task % numRowChunks) * rowChunk;
+                size_t rowEnd = std::min(rowBegin + rowChunk, numInRows);
+                std::vector<float> rowVals(paddedWidth);
+                std::vector<size_t> dequeBuf(paddedWidth);
+                for(size_t r = rowBegin; r < rowEnd; ++r)
+                {
+                    const float *inRow = &inBuf[(bandPlanes[n] * paddedPlane) + (r * paddedWidth)];
+                    for(size_t x = 0; x < paddedWidth; ++x)
+                    {
+                        float val = inRow[x];
+                        rowVals[x] = ((this->useNoDataValue && (val == this->noDataValue)) || std::isnan(val))?inf:val;
+                    }
+                    calcRunningMin(rowVals.data(), 1, width, winSize, &winMins[(n * paddedRows + r) * width], 1, dequeBuf);
+                }
+            });
+            
+            // Down the columns (van Herk / Gil-Werman): with runs of winSize
+            // rows, the window starting at row y is the minimum of the suffix
+            // minimum of y's run from y and the prefix minimum of the next
+            // run up to y + winSize - 1, which are found a row at a time.
+            const size_t numColChunks = (width + colChunkSize - 1) / colChunkSize;
+            pool.parallelFor(numSelBands * numColChunks, [&](size_t task, unsigned int)
+            {
+                size_t n = task / numColChunks;
+                size_t colBegin = (task % numColChunks) * colChunkSize;
+                size_t chunkWidth = std::min(colChunkSize, width - colBegin);
+                float *rowMins = &winMins[(n * paddedRows * width) + colBegin];
+                std::vector<float> prefixMins(numInRows * chunkWidth);
+                std::vector<float> suffixMins(numInRows * chunkWidth);
+                for(size_t r = 0; r < numInRows; ++r)
+                {
+                    const float *vals = &rowMins[r * width];
+                    float *prefix = &prefixMins[r * chunkWidth];
+                    if((r % winSize) == 0)
+                    {
+                        std::copy(vals, vals + chunkWidth, prefix);
+                    }
+                    else
+                    {
+                        const float *prevPrefix = prefix - chunkWidth;
+                        for(size_t x = 0; x < chunkWidth; ++x)
+                        {
+                            prefix[x] = std::min(prevPrefix[x], vals[x]);
+                        }
+                    }
+                }
+                for(size_t r = numInRows; r > 0; --r)
+                {
+                    const float *vals = &rowMins[(r - 1) * width];
+                    float *suffix = &suffixMins[(r - 1) * chunkWidth];
+                    if(((r % winSize) == 0) || (r == numInRows))
+                    {
+                        std::copy(vals, vals + chunkWidth, suffix);
+                    }
+                    else
+                    {
+                        const float *nextSuffix = suffix + chunkWidth;
+                        for(size_t x = 0; x < chunkWidth; ++x)
+                        {
+                            suffix[x] = std::min(nextSuffix[x], vals[x]);
+                        }
+                    }
+                }
+                for(size_t y = 0; y < numLines; ++y)
+                {
+                    const float *suffix = &suffixMins[y * chunkWidth];
+                    const float *prefix = &prefixMins[(y + winSize - 1) * chunkWidth];
+                    float *out = &rowMins[y * width];
+                    for(size_t x = 0; x < chunkWidth; ++x)
+                    {
+                        out[x] = std::min(suffix[x], prefix[x]);
+                    }
+                }
+            });
+            
+            // The band with the smallest minimum (the first if equal).
+            float *outBuf = outBufs[slot].data();
+            unsigned int *outRefBuf = outRefBufs[slot].data();
+            const size_t lineChunk = std::max<size_t>(1, (numLines + this->numThreads - 1) / this->numThreads);
+            const size_t numLineChunks = (numLines + lineChunk - 1) / lineChunk;
+            pool.parallelFor(numLineChunks, [&](size_t task, unsigned int)
+            {
+                size_t lineEnd = std::min((task + 1) * lineChunk, numLines);
+                for(size_t y = task * lineChunk; y < lineEnd; ++y)
+                {
+                    for(size_t x = 0; x < ((size_t)width); ++x)
+                    {
+                        size_t idx = (y * width) + x;
+                        float minVal = inf;
+                        unsigned int minBand = 0;
+                        for(size_t n = 0; n < numSelBands; ++n)
+                        {
+                            float val = winMins[(n * paddedRows * width) + idx];
+                            if(val < minVal)
+                            {
+                                minVal = val;
+                                minBand = this->bands[n];
+                            }
+                        }
+                        if(minBand == 0)
+                        {
+                            minVal = 0;
+                        }
+                        else if(this->useNoDataValue)
+                        {
+                            bool midPxlNoData = true;
+                            size_t midIdx = ((y + halfWin) * paddedWidth) + x + halfWin;
+                            for(size_t b = 0; b < numReadBands; ++b)
+                            {
+                                if(inBuf[(b * paddedPlane) + midIdx] != this->noDataValue)
+                                {
+                                    midPxlNoData = false;
+                                    break;
+                                }
+                            }
+                            if(midPxlNoData)
+                            {
+                                minVal = 0;
+                                minBand = 0;
+                            }
+                        }
+                        outBuf[idx] = minVal;
+                        outRefBuf[idx] = minBand;
+                    }
+                }
+            });
+        };
+        
+        auto writeBlock = [&](unsigned int block, unsigned int slot)
+        {
+            int numLines = blockLines(block);
+            if(outDataset->GetRasterBand(1)->RasterIO(GF_Write, 0, block * numRows, width, numLines, outBufs[slot].data(), width, numLines, GDT_Float32, 0, 0) != CE_None)
+            {
+                throw RSGISImageCalcException("Could not write a block to the output image.");
+            }
+            if(outRefDataset->GetRasterBand(1)->RasterIO(GF_Write, 0, block * numRows, width, numLines, outRefBufs[slot].data(), width, numLines, GDT_UInt32, 0, 0) != CE_None)
+            {
+                throw RSGISImageCalcException("Could not write a block to the output reference image.");
+            }
+        };
+        
+        pipeline.run(nBlocks, readBlock, calcBlock, writeBlock);
+    }
+    
+    RSGISLocalMinInWinFilter::~RSGISLocalMinInWinFilter()
+    {
+        
+    }
+    
 }}
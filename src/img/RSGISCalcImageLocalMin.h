@@ -26,9 +26,21 @@
 #include <iostream>
 #include <math.h>
 #include <stdlib.h>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <algorithm>
+
+#include "gdal_priv.h"
 
 #include "img/RSGISImageCalcException.h"
 #include "img/RSGISCalcImageValue.h"
+#include "img/RSGISImageBlockPipeline.h"
+#include "img/RSGISImageBlockPlanner.h"
+#include "common/RSGISParallel.h"
 
 
 // mark all exported classes/functions with DllExport to have
@@ -59,6 +71,51 @@ namespace rsgis{namespace img{
             double *minVals;
             bool *first;
         };
+        
+        /**
+         * Finds the same minimum and band as RSGISCalcLocalMinInWin for each
+         * pixel of an image, at a cost per pixel which does not depend on the
+         * window size. The minimum over a window is separable, so the minimum
+         * of each band is found along the rows with a monotonic deque and then
+         * down the columns (as the minimum of a suffix and a prefix minimum
+         * over runs of winSize rows, which works on whole rows at once) before
+         * the band with the smallest minimum is selected.
+         *
+         * The image is processed in strips of rows (with winSize / 2 rows
+         * above and below), read, filtered and written in a pipeline, with the
+         * rows and columns of a strip shared among threads (setNumThreads or
+         * the RSGISLIB_NUM_THREADS environment variable). As with the window
+         * of RSGISCalcImage, pixels outside the image are 0.
+         */
+        class DllExport RSGISLocalMinInWinFilter
+        {
+        public:
+            RSGISLocalMinInWinFilter(std::vector<unsigned int> bands, float noDataValue, bool useNoDataValue);
+            /**
+             * The number of threads (0 uses the number of cores).
+             */
+            void setNumThreads(unsigned int numThreads);
+            /**
+             * Write the minimum to the first band of outDataset and the band
+             * (numbered from 1) it was found in to the first band of
+             * outRefDataset, both 0 where there are no valid values in the
+             * window or the centre pixel is no data in all the bands.
+             */
+            void calcLocalMinInWin(GDALDataset *inDataset, int winSize, GDALDataset *outDataset, GDALDataset *outRefDataset);
+            /**
+             * The minimum over each run of winSize values (from numOut + winSize
+             * - 1 values, inStride apart) written to out (outStride apart).
+             * dequeBuf is working space.
+             */
+            static void calcRunningMin(const float *in, size_t inStride, size_t numOut, int winSize, float *out, size_t outStride, std::vector<size_t> &dequeBuf);
+            ~RSGISLocalMinInWinFilter();
+        protected:
+            static const size_t colChunkSize;
+            std::vector<unsigned int> bands;
+            float noDataValue;
+            bool useNoDataValue;
+            unsigned int numThreads;
+        };
     
 }}
 
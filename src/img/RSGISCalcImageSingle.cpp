@@ -633,143 +633,188 @@ namespace rsgis{namespace img{
 			}
 			inDataColumnA = new float[numInBands];
 			
-			int feedback = height/10;
-			if (feedback == 0) {feedback = 1;} // Set feedback to 1
-			int feedbackCounter = 0;
-			if(height > 100)
+			if(RSGISPolygonRasteriser::supportsMethod(pixelPolyOption))
 			{
-				std::cout << "\rStarted.." << std::flush;
-			}
-			// Loop images to process data
-			for(int i = 0; i < height; i++)
-			{
-				if (height > 100)
+				/* Find the pixels by scanning the polygon edges over the pixel grid rather
+				 * than building a geometry (and, for pixelAreaInPoly, intersecting it with
+				 * the polygon) for each pixel. For pixelAreaInPoly the weight is the exact
+				 * fraction of the pixel covered, 1 for the pixels within the polygon; for
+				 * the other methods it is 1. No pixel centre point is given (pt is NULL).
+				 */
+				RSGISPolygonRasteriser polyRasteriser(pxlTLX, pxlTLY, pxlWidth, pxlHeight, width, height);
+				polyRasteriser.setPolygon(poly);
+				std::vector<RSGISPixelSpan> pxlSpans;
+				std::vector<float> pxlWeights;
+				bool useWeights = (pixelPolyOption == pixelAreaInPoly);
+				polyRasteriser.findPixelSpans(pixelPolyOption, &pxlSpans, useWeights?&pxlWeights:NULL);
+				
+				size_t weightIdx = 0;
+				long currRow = -1;
+				for(std::vector<RSGISPixelSpan>::iterator iterSpan = pxlSpans.begin(); iterSpan != pxlSpans.end(); ++iterSpan)
 				{
-					if((i % feedback) == 0)
+					// The spans are in row order so each row is read once.
+					if((*iterSpan).row != currRow)
 					{
-						std::cout << ".." << feedbackCounter << ".." << std::flush;
-						feedbackCounter = feedbackCounter + 10;
+						currRow = (*iterSpan).row;
+						for(int n = 0; n < numInBands; n++)
+						{
+							inputRasterBandsA[n]->RasterIO(GF_Read, bandOffsetsA[n][0], (bandOffsetsA[n][1]+currRow), width, 1, inputDataA[n], width, 1, GDT_Float32, 0, 0);
+						}
+					}
+					for(long j = (*iterSpan).xStart; j < (*iterSpan).xEnd; ++j)
+					{
+						double pxlWeight = useWeights?pxlWeights[weightIdx++]:1;
+						if(pxlWeight > 0)
+						{
+							for(int n = 0; n < numInBands; n++)
+							{
+								inDataColumnA[n] = inputDataA[n][j];
+							}
+							this->valueCalc->calcImageValue(inDataColumnA, pxlWeight, numInBands, poly, NULL);
+						}
 					}
 				}
-				
-				for(int n = 0; n < numInBands; n++)
+			}
+			else
+			{
+				int feedback = height/10;
+				if (feedback == 0) {feedback = 1;} // Set feedback to 1
+				int feedbackCounter = 0;
+				if(height > 100)
 				{
-					inputRasterBandsA[n]->RasterIO(GF_Read, bandOffsetsA[n][0], (bandOffsetsA[n][1]+i), width, 1, inputDataA[n], width, 1, GDT_Float32, 0, 0);
+					std::cout << "\rStarted.." << std::flush;
 				}
- 				for(int j = 0; j < width; j++)
+				// Loop images to process data
+				for(int i = 0; i < height; i++)
 				{
+					if (height > 100)
+					{
+						if((i % feedback) == 0)
+						{
+							std::cout << ".." << feedbackCounter << ".." << std::flush;
+							feedbackCounter = feedbackCounter + 10;
+						}
+					}
+				
 					for(int n = 0; n < numInBands; n++)
 					{
-						inDataColumnA[n] = inputDataA[n][j];
+						inputRasterBandsA[n]->RasterIO(GF_Read, bandOffsetsA[n][0], (bandOffsetsA[n][1]+i), width, 1, inputDataA[n], width, 1, GDT_Float32, 0, 0);
 					}
-					geos::geom::Coordinate pxlCentre;
-                    const geos::geom::GeometryFactory *geomFactory = geos::geom::GeometryFactory::getDefaultInstance();
-					geos::geom::Point *pt = NULL;
+	 				for(int j = 0; j < width; j++)
+					{
+						for(int n = 0; n < numInBands; n++)
+						{
+							inDataColumnA[n] = inputDataA[n][j];
+						}
+						geos::geom::Coordinate pxlCentre;
+	                    const geos::geom::GeometryFactory *geomFactory = geos::geom::GeometryFactory::getDefaultInstance();
+						geos::geom::Point *pt = NULL;
 					
-					extent.init(pxlTLX, (pxlTLX+pxlWidth), pxlTLY, (pxlTLY-pxlHeight));
-					extent.centre(pxlCentre);
-					pt = geomFactory->createPoint(pxlCentre);
+						extent.init(pxlTLX, (pxlTLX+pxlWidth), pxlTLY, (pxlTLY-pxlHeight));
+						extent.centre(pxlCentre);
+						pt = geomFactory->createPoint(pxlCentre);
 					
-					/* It was previously hardcoded to use 'polyContainsPixelCenter'
-					 calculated here.
-					 As other methods, available from 'RSGISPixelInPoly' require conversion to 
-					 OGRGeometry and OGR Polygon the existing method has been retained to maintain performance.
-					 Dan Clewley - 17/06/2010
-					 */
+						/* It was previously hardcoded to use 'polyContainsPixelCenter'
+						 calculated here.
+						 As other methods, available from 'RSGISPixelInPoly' require conversion to 
+						 OGRGeometry and OGR Polygon the existing method has been retained to maintain performance.
+						 Dan Clewley - 17/06/2010
+						 */
 					
-					if (pixelPolyOption == polyContainsPixelCenter) 
-					{
-						if(poly->contains(pt)) // If polygon contains pixel center
+						if (pixelPolyOption == polyContainsPixelCenter) 
 						{
-							this->valueCalc->calcImageValue(inDataColumnA, 1, numInBands, poly, pt);
-						}
+							if(poly->contains(pt)) // If polygon contains pixel center
+							{
+								this->valueCalc->calcImageValue(inDataColumnA, 1, numInBands, poly, pt);
+							}
 
-					}
-					else if (pixelPolyOption == pixelAreaInPoly) 
-					{
-						geos::geom::CoordinateSequence *coords = NULL;
-						geos::geom::LinearRing *ring = NULL;
-						geos::geom::Polygon *pixelGeosPoly = NULL;
-						geos::geom::Geometry *intersectionGeom;
+						}
+						else if (pixelPolyOption == pixelAreaInPoly) 
+						{
+							geos::geom::CoordinateSequence *coords = NULL;
+							geos::geom::LinearRing *ring = NULL;
+							geos::geom::Polygon *pixelGeosPoly = NULL;
+							geos::geom::Geometry *intersectionGeom;
 						
-						coords = new geos::geom::CoordinateArraySequence();
-						coords->add(geos::geom::Coordinate(pxlTLX, pxlTLY, 0));
-						coords->add(geos::geom::Coordinate(pxlTLX + pxlWidth, pxlTLY, 0));
-						coords->add(geos::geom::Coordinate(pxlTLX + pxlWidth, pxlTLY - pxlHeight, 0));
-						coords->add(geos::geom::Coordinate(pxlTLX, pxlTLY - pxlHeight, 0));
-						coords->add(geos::geom::Coordinate(pxlTLX, pxlTLY, 0));
-						ring = geomFactory->createLinearRing(coords);
-						pixelGeosPoly = geomFactory->createPolygon(ring, NULL);
+							coords = new geos::geom::CoordinateArraySequence();
+							coords->add(geos::geom::Coordinate(pxlTLX, pxlTLY, 0));
+							coords->add(geos::geom::Coordinate(pxlTLX + pxlWidth, pxlTLY, 0));
+							coords->add(geos::geom::Coordinate(pxlTLX + pxlWidth, pxlTLY - pxlHeight, 0));
+							coords->add(geos::geom::Coordinate(pxlTLX, pxlTLY - pxlHeight, 0));
+							coords->add(geos::geom::Coordinate(pxlTLX, pxlTLY, 0));
+							ring = geomFactory->createLinearRing(coords);
+							pixelGeosPoly = geomFactory->createPolygon(ring, NULL);
 						
-						intersectionGeom = pixelGeosPoly->intersection(poly);
-						double intersectionArea = intersectionGeom->getArea()  / pixelGeosPoly->getArea();
+							intersectionGeom = pixelGeosPoly->intersection(poly);
+							double intersectionArea = intersectionGeom->getArea()  / pixelGeosPoly->getArea();
 						
-						if(intersectionArea > 0)
-						{
-							for(int n = 0; n < numInBands; n++)
+							if(intersectionArea > 0)
 							{
-								this->valueCalc->calcImageValue(inDataColumnA, intersectionArea, numInBands, poly, pt);
+								for(int n = 0; n < numInBands; n++)
+								{
+									this->valueCalc->calcImageValue(inDataColumnA, intersectionArea, numInBands, poly, pt);
+								}
 							}
 						}
-					}
-					else 
-					{
-						RSGISPixelInPoly *pixelInPoly;
-						OGRLinearRing *ring;
-						OGRPolygon *pixelPoly;
-						OGRPolygon *ogrPoly;
-						OGRGeometry *ogrGeom;
+						else 
+						{
+							RSGISPixelInPoly *pixelInPoly;
+							OGRLinearRing *ring;
+							OGRPolygon *pixelPoly;
+							OGRPolygon *ogrPoly;
+							OGRGeometry *ogrGeom;
 						
-						pixelInPoly = new RSGISPixelInPoly(pixelPolyOption);
+							pixelInPoly = new RSGISPixelInPoly(pixelPolyOption);
 						
-						ring = new OGRLinearRing();
-						ring->addPoint(pxlTLX, pxlTLY, 0);
-						ring->addPoint(pxlTLX + pxlWidth, pxlTLY, 0);
-						ring->addPoint(pxlTLX + pxlWidth, pxlTLY - pxlHeight, 0);
-						ring->addPoint(pxlTLX, pxlTLY - pxlHeight, 0);
-						ring->addPoint(pxlTLX, pxlTLY, 0);
+							ring = new OGRLinearRing();
+							ring->addPoint(pxlTLX, pxlTLY, 0);
+							ring->addPoint(pxlTLX + pxlWidth, pxlTLY, 0);
+							ring->addPoint(pxlTLX + pxlWidth, pxlTLY - pxlHeight, 0);
+							ring->addPoint(pxlTLX, pxlTLY - pxlHeight, 0);
+							ring->addPoint(pxlTLX, pxlTLY, 0);
 						
-						pixelPoly = new OGRPolygon();
-						pixelPoly->addRingDirectly(ring);
+							pixelPoly = new OGRPolygon();
+							pixelPoly->addRingDirectly(ring);
 												
-						//Convert GEOS Polygon to OGR Polygon
-						ogrPoly = new OGRPolygon();
-						const geos::geom::LineString *line = poly->getExteriorRing();
-						OGRLinearRing *ogrRing = new OGRLinearRing();
-						const geos::geom::CoordinateSequence *coords = line->getCoordinatesRO();
-						int numCoords = coords->getSize();
-						geos::geom::Coordinate coord;
-						for(int i = 0; i < numCoords; i++)
-						{
-							coord = coords->getAt(i);
-							ogrRing->addPoint(coord.x, coord.y, coord.z);
-						}
-						ogrPoly->addRing(ogrRing);
-						ogrGeom = (OGRGeometry *) ogrPoly;
+							//Convert GEOS Polygon to OGR Polygon
+							ogrPoly = new OGRPolygon();
+							const geos::geom::LineString *line = poly->getExteriorRing();
+							OGRLinearRing *ogrRing = new OGRLinearRing();
+							const geos::geom::CoordinateSequence *coords = line->getCoordinatesRO();
+							int numCoords = coords->getSize();
+							geos::geom::Coordinate coord;
+							for(int i = 0; i < numCoords; i++)
+							{
+								coord = coords->getAt(i);
+								ogrRing->addPoint(coord.x, coord.y, coord.z);
+							}
+							ogrPoly->addRing(ogrRing);
+							ogrGeom = (OGRGeometry *) ogrPoly;
 						
-						// Check if the pixel should be classed as part of the polygon using the specified method
-						if (pixelInPoly->findPixelInPoly(ogrGeom, pixelPoly)) 
-						{
-							this->valueCalc->calcImageValue(inDataColumnA, 1, numInBands, poly, pt);
-						}
+							// Check if the pixel should be classed as part of the polygon using the specified method
+							if (pixelInPoly->findPixelInPoly(ogrGeom, pixelPoly)) 
+							{
+								this->valueCalc->calcImageValue(inDataColumnA, 1, numInBands, poly, pt);
+							}
 						
-						// Tidy
-						delete pixelInPoly;
-						delete pixelPoly;
-						delete ogrPoly;
-					}
+							// Tidy
+							delete pixelInPoly;
+							delete pixelPoly;
+							delete ogrPoly;
+						}
 					
-					delete pt;
+						delete pt;
 					
-					pxlTLX += pxlWidth;
+						pxlTLX += pxlWidth;
+					}
+					pxlTLY -= pxlHeight;
+					pxlTLX = gdalTranslation[0];
+				}
+				if (height > 100) 
+				{
+					std::cout << "Complete\r" << std::flush;
+					std::cout << "\r                                                                                    \r" << std::flush;
 				}
-				pxlTLY -= pxlHeight;
-				pxlTLX = gdalTranslation[0];
-			}
-			if (height > 100) 
-			{
-				std::cout << "Complete\r" << std::flush;
-				std::cout << "\r                                                                                    \r" << std::flush;
 			}
 			if(output)
 			{	
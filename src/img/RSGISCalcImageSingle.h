@@ -25,6 +25,7 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include "gdal_priv.h"
 
@@ -44,6 +45,7 @@
 #include "img/RSGISCalcImageSingleValue.h"
 #include "img/RSGISImageUtils.h"
 #include "img/RSGISPixelInPoly.h"
+#include "img/RSGISPolygonRasteriser.h"
 
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
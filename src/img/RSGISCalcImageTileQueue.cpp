@@ -0,0 +1,442 @@
+/*
+ *  RSGISCalcImageTileQueue.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISCalcImageTileQueue.h"
+
+namespace rsgis{namespace img{
+
+    const unsigned int RSGISCalcImageTileQueue::pollMilliSecs = 2000;
+
+    RSGISCalcImageTileQueue::RSGISCalcImageTileQueue(RSGISCalcImage *calcImage, std::string queueDIR, unsigned int tileSize, unsigned int claimTimeoutSecs)
+    {
+        this->calcImg = calcImage;
+        this->queueDIR = queueDIR;
+        if(tileSize == 0)
+        {
+            tileSize = 4096;
+            if(const char* env_p = std::getenv("RSGISLIB_TILE_SIZE"))
+            {
+                int envTileSize = atoi(env_p);
+                if(envTileSize > 0)
+                {
+                    tileSize = envTileSize;
+                }
+            }
+        }
+        this->tileSize = tileSize;
+        this->claimTimeoutSecs = std::max<unsigned int>(claimTimeoutSecs, 4);
+    }
+
+    void RSGISCalcImageTileQueue::calcImage(GDALDataset **datasets, int numDS, std::string outputImage, bool setOutNames, std::string *bandNames, std::string gdalFormat, GDALDataType gdalDataType)
+    {
+        GDALAllRegister();
+        RSGISImageUtils imgUtils;
+        double gdalTransform[6];
+        std::vector<int> dsOffsetVals(numDS * 2, 0);
+        std::vector<int*> dsOffsets(numDS);
+        for(int i = 0; i < numDS; i++)
+        {
+            dsOffsets[i] = &dsOffsetVals[i * 2];
+        }
+        int width = 0;
+        int height = 0;
+        imgUtils.getImageOverlap(datasets, numDS, dsOffsets.data(), &width, &height, gdalTransform);
+        std::vector<RSGISCalcImageTile> tiles = RSGISCalcImageTileQueue::createTiles(width, height, this->tileSize);
+
+        std::string jobDesc = this->createJobDescription(datasets, numDS, width, height, gdalTransform, gdalFormat, gdalDataType);
+        std::stringstream jobName;
+        jobName << boost::filesystem::path(outputImage).filename().string() << "." << RSGISCalcImageCheckpoint::hashString(jobDesc) << ".tiles";
+
+        boost::system::error_code ec;
+        boost::filesystem::path jobDIR = boost::filesystem::absolute(boost::filesystem::path(this->queueDIR) / jobName.str());
+        boost::filesystem::create_directories(jobDIR, ec);
+        if(!boost::filesystem::is_directory(jobDIR))
+        {
+            throw RSGISImageCalcException("Could not create the tile queue directory: " + jobDIR.string());
+        }
+        this->checkJobDescription(jobDIR, jobDesc);
+        std::vector<std::string> tileFiles;
+        for(size_t i = 0; i < tiles.size(); ++i)
+        {
+            tileFiles.push_back((jobDIR / ("tile_" + std::to_string(i) + ".tif")).string());
+        }
+        std::cout << "Calculating " << tiles.size() << " tiles of " << this->tileSize << " pixels using the queue " << jobDIR.string() << std::endl;
+
+        // Take every unclaimed tile then wait for the tiles of the other
+        // processes, taking over any whose process failed (removing its claim)
+        // or whose claim has not been touched within the timeout.
+        unsigned int heartbeatSecs = this->claimTimeoutSecs / 4;
+        size_t numCalcd = 0;
+        for(int pass = 0; pass < 2; ++pass)
+        {
+            for(size_t i = 0; i < tiles.size(); ++i)
+            {
+                while(!boost::filesystem::exists(tileFiles[i]))
+                {
+                    if(RSGISCalcImageTileQueue::jobRemoved(jobDIR, outputImage))
+                    {
+                        std::cout << "The output has been assembled by another process." << std::endl;
+                        return;
+                    }
+                    std::string claimFile = tileFiles[i] + ".claim";
+                    if(RSGISCalcImageTileQueue::claimFile(claimFile))
+                    {
+                        // A name of its own so a process which took over a
+                        // stale claim of a live process does not share the file.
+                        std::string tmpFile = (jobDIR / boost::filesystem::unique_path("tile_" + std::to_string(i) + ".%%%%-%%%%-%%%%.tmp.tif")).string();
+                        try
+                        {
+                            RSGISClaimHeartbeat heartbeat(claimFile, heartbeatSecs);
+                            this->calcImg->calcImageTile(datasets, numDS, tmpFile, tiles[i].xOff, tiles[i].yOff, tiles[i].width, tiles[i].height, setOutNames, bandNames, "GTiff", gdalDataType);
+                            boost::filesystem::rename(tmpFile, tileFiles[i]);
+                        }
+                        catch(boost::filesystem::filesystem_error &e)
+                        {
+                            boost::filesystem::remove(tmpFile, ec);
+                            boost::filesystem::remove(claimFile, ec);
+                            throw RSGISImageCalcException(e.what());
+                        }
+                        catch(...)
+                        {
+                            boost::filesystem::remove(tmpFile, ec);
+                            boost::filesystem::remove(claimFile, ec);
+                            throw;
+                        }
+                        ++numCalcd;
+                    }
+                    else if(pass == 0)
+                    {
+                        break;
+                    }
+                    else if(this->isStaleClaim(claimFile))
+                    {
+                        std::cout << "Taking over the stale claim " << claimFile << std::endl;
+                        boost::filesystem::remove(claimFile, ec);
+                    }
+                    else
+                    {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(pollMilliSecs));
+                    }
+                }
+            }
+        }
+        std::cout << "Calculated " << numCalcd << " of the " << tiles.size() << " tiles." << std::endl;
+
+        bool vrtOutput = (boost::to_upper_copy(gdalFormat) == "VRT");
+        std::string assembleClaim = (jobDIR / "assemble.claim").string();
+        std::string assembledFile = (jobDIR / "assembled").string();
+        while(!boost::filesystem::exists(assembledFile))
+        {
+            if(RSGISCalcImageTileQueue::jobRemoved(jobDIR, outputImage))
+            {
+                return;
+            }
+            if(!RSGISCalcImageTileQueue::claimFile(assembleClaim))
+            {
+                if(this->isStaleClaim(assembleClaim))
+                {
+                    std::cout << "Taking over the stale claim " << assembleClaim << std::endl;
+                    boost::filesystem::remove(assembleClaim, ec);
+                }
+                else
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(pollMilliSecs));
+                }
+                continue;
+            }
+            GDALDataset *vrtDS = NULL;
+            try
+            {
+                RSGISClaimHeartbeat heartbeat(assembleClaim, heartbeatSecs);
+                GDALDataset *tileDS = (GDALDataset *) GDALOpen(tileFiles[0].c_str(), GA_ReadOnly);
+                if(tileDS == NULL)
+                {
+                    throw RSGISImageCalcException("Could not open the tile: " + tileFiles[0]);
+                }
+                std::string projWKT = tileDS->GetProjectionRef();
+                int numBands = tileDS->GetRasterCount();
+                GDALClose(tileDS);
+
+                std::cout << "Assembling the tiles into " << outputImage << std::endl;
+                if(vrtOutput)
+                {
+                    RSGISDatasetCache::invalidate(outputImage);
+                    this->writeVRT(outputImage, projWKT, gdalTransform, width, height, tiles, tileFiles, numBands, setOutNames, bandNames, gdalDataType);
+                }
+                else
+                {
+                    std::string vrtFile = (jobDIR / "tiles.vrt").string();
+                    this->writeVRT(vrtFile, projWKT, gdalTransform, width, height, tiles, tileFiles, numBands, setOutNames, bandNames, gdalDataType);
+                    vrtDS = (GDALDataset *) GDALOpen(vrtFile.c_str(), GA_ReadOnly);
+                    if(vrtDS == NULL)
+                    {
+                        throw RSGISImageCalcException("Could not open the tiles VRT: " + vrtFile);
+                    }
+                    GDALDriver *gdalDriver = GetGDALDriverManager()->GetDriverByName(gdalFormat.c_str());
+                    if(gdalDriver == NULL)
+                    {
+                        throw RSGISImageCalcException("Requested GDAL driver does not exists..");
+                    }
+                    char **papszOptions = imgUtils.getGDALCreationOptionsForFormat(gdalFormat);
+                    RSGISDatasetCache::invalidate(outputImage);
+                    GDALDataset *outputImageDS = gdalDriver->CreateCopy(outputImage.c_str(), vrtDS, FALSE, papszOptions, NULL, NULL);
+                    CSLDestroy(papszOptions);
+                    if(outputImageDS == NULL)
+                    {
+                        throw RSGISImageCalcException("Output image could not be created. Check filepath.");
+                    }
+                    GDALClose(outputImageDS);
+                    GDALClose(vrtDS);
+                    vrtDS = NULL;
+                }
+                if(!RSGISCalcImageTileQueue::claimFile(assembledFile))
+                {
+                    throw RSGISImageCalcException("Could not create the file marking the output as assembled: " + assembledFile);
+                }
+            }
+            catch(...)
+            {
+                if(vrtDS != NULL)
+                {
+                    GDALClose(vrtDS);
+                }
+                boost::filesystem::remove(assembleClaim, ec);
+                throw;
+            }
+            if(!vrtOutput)
+            {
+                // The output is a copy of the tiles so they are no longer needed.
+                boost::filesystem::remove_all(jobDIR, ec);
+            }
+            break;
+        }
+    }
+
+    std::vector<RSGISCalcImageTile> RSGISCalcImageTileQueue::createTiles(int width, int height, unsigned int tileSize)
+    {
+        std::vector<RSGISCalcImageTile> tiles;
+        int tileStep = std::max<int>(tileSize, 1);
+        for(int yOff = 0; yOff < height; yOff += tileStep)
+        {
+            for(int xOff = 0; xOff < width; xOff += tileStep)
+            {
+                RSGISCalcImageTile tile;
+                tile.xOff = xOff;
+                tile.yOff = yOff;
+                tile.width = std::min(tileStep, width - xOff);
+                tile.height = std::min(tileStep, height - yOff);
+                tiles.push_back(tile);
+            }
+        }
+        return tiles;
+    }
+
+    bool RSGISCalcImageTileQueue::claimFile(std::string filePath)
+    {
+        // Exclusive creation ("x") fails if the file exists, so only one process can make the claim.
+        FILE *claim = std::fopen(filePath.c_str(), "wx");
+        if(claim == NULL)
+        {
+            return false;
+        }
+        std::fclose(claim);
+        return true;
+    }
+
+    bool RSGISCalcImageTileQueue::isStaleClaim(std::string claimFile)
+    {
+        boost::system::error_code ec;
+        std::time_t touched = boost::filesystem::last_write_time(claimFile, ec);
+        if(ec)
+        {
+            return false;
+        }
+        return (std::difftime(std::time(NULL), touched) > this->claimTimeoutSecs);
+    }
+
+    std::string RSGISCalcImageTileQueue::createJobDescription(GDALDataset **datasets, int numDS, int width, int height, const double *gdalTransform, std::string gdalFormat, GDALDataType gdalDataType)
+    {
+        RSGISCalcImageValue *calc = this->calcImg->getCalcImageValue();
+        std::stringstream jobDesc;
+        jobDesc.precision(17);
+        jobDesc << "calculator " << typeid(*calc).name() << " " << calc->getNumOutBands() << "\n";
+        jobDesc << "params " << RSGISCalcImageCheckpoint::hashString(calc->getParameterHash()) << "\n";
+        for(int i = 0; i < numDS; ++i)
+        {
+            std::string inputFile = datasets[i]->GetDescription();
+            jobDesc << "input " << RSGISCalcImageCheckpoint::getFileStamp(inputFile) << " " << inputFile << "\n";
+        }
+        jobDesc << "grid " << width << " " << height;
+        for(int i = 0; i < 6; ++i)
+        {
+            jobDesc << " " << gdalTransform[i];
+        }
+        jobDesc << "\n";
+        jobDesc << "tiles " << this->tileSize << "\n";
+        jobDesc << "output " << gdalFormat << " " << GDALGetDataTypeName(gdalDataType) << "\n";
+        return jobDesc.str();
+    }
+
+    void RSGISCalcImageTileQueue::checkJobDescription(boost::filesystem::path jobDIR, std::string jobDesc)
+    {
+        boost::filesystem::path jobFile = jobDIR / "job.txt";
+        if(!boost::filesystem::exists(jobFile))
+        {
+            // Written to a file of its own and renamed so another process
+            // never reads part of the description.
+            boost::filesystem::path tmpFile = jobDIR / boost::filesystem::unique_path("job.%%%%-%%%%-%%%%.tmp");
+            std::ofstream jobOut(tmpFile.string().c_str(), std::ios::out | std::ios::trunc);
+            jobOut << jobDesc;
+            jobOut.close();
+            boost::system::error_code ec;
+            if(jobOut.fail())
+            {
+                boost::filesystem::remove(tmpFile, ec);
+                throw RSGISImageCalcException("Could not write the job file: " + jobFile.string());
+            }
+            boost::filesystem::rename(tmpFile, jobFile, ec);
+            if(ec)
+            {
+                boost::filesystem::remove(tmpFile, ec);
+                throw RSGISImageCalcException("Could not write the job file: " + jobFile.string());
+            }
+        }
+        std::ifstream jobIn(jobFile.string().c_str());
+        std::stringstream existingDesc;
+        existingDesc << jobIn.rdbuf();
+        if(existingDesc.str() != jobDesc)
+        {
+            throw RSGISImageCalcException("The tile queue directory " + jobDIR.string() + " is of a different job (the inputs, calculator or grid differ); it needs to be removed.");
+        }
+    }
+
+    bool RSGISCalcImageTileQueue::jobRemoved(boost::filesystem::path jobDIR, std::string outputImage)
+    {
+        if(boost::filesystem::is_directory(jobDIR))
+        {
+            return false;
+        }
+        if(!boost::filesystem::exists(outputImage))
+        {
+            throw RSGISImageCalcException("The tile queue directory " + jobDIR.string() + " was removed before the output was assembled.");
+        }
+        return true;
+    }
+
+    void RSGISCalcImageTileQueue::writeVRT(std::string vrtFile, std::string projWKT, const double *gdalTransform, int width, int height, const std::vector<RSGISCalcImageTile> &tiles, const std::vector<std::string> &tileFiles, int numBands, bool setOutNames, std::string *bandNames, GDALDataType gdalDataType)
+    {
+        std::ofstream vrt(vrtFile.c_str(), std::ios::out | std::ios::trunc);
+        if(!vrt.is_open())
+        {
+            throw RSGISImageCalcException("Could not create the VRT file: " + vrtFile);
+        }
+        vrt.precision(17);
+        vrt << "<VRTDataset rasterXSize=\"" << width << "\" rasterYSize=\"" << height << "\">\n";
+        if(projWKT != "")
+        {
+            vrt << "  <SRS>" << RSGISCalcImageTileQueue::escapeXML(projWKT) << "</SRS>\n";
+        }
+        vrt << "  <GeoTransform>" << gdalTransform[0];
+        for(int i = 1; i < 6; ++i)
+        {
+            vrt << ", " << gdalTransform[i];
+        }
+        vrt << "</GeoTransform>\n";
+        for(int n = 0; n < numBands; ++n)
+        {
+            vrt << "  <VRTRasterBand dataType=\"" << GDALGetDataTypeName(gdalDataType) << "\" band=\"" << (n+1) << "\">\n";
+            if(setOutNames)
+            {
+                vrt << "    <Description>" << RSGISCalcImageTileQueue::escapeXML(bandNames[n]) << "</Description>\n";
+            }
+            for(size_t i = 0; i < tiles.size(); ++i)
+            {
+                vrt << "    <SimpleSource>\n";
+                vrt << "      <SourceFilename relativeToVRT=\"0\">" << RSGISCalcImageTileQueue::escapeXML(tileFiles[i]) << "</SourceFilename>\n";
+                vrt << "      <SourceBand>" << (n+1) << "</SourceBand>\n";
+                vrt << "      <SrcRect xOff=\"0\" yOff=\"0\" xSize=\"" << tiles[i].width << "\" ySize=\"" << tiles[i].height << "\"/>\n";
+                vrt << "      <DstRect xOff=\"" << tiles[i].xOff << "\" yOff=\"" << tiles[i].yOff << "\" xSize=\"" << tiles[i].width << "\" ySize=\"" << tiles[i].height << "\"/>\n";
+                vrt << "    </SimpleSource>\n";
+            }
+            vrt << "  </VRTRasterBand>\n";
+        }
+        vrt << "</VRTDataset>\n";
+        vrt.close();
+        if(vrt.fail())
+        {
+            throw RSGISImageCalcException("Could not write the VRT file: " + vrtFile);
+        }
+    }
+
+    std::string RSGISCalcImageTileQueue::escapeXML(std::string value)
+    {
+        std::string escaped;
+        for(std::string::iterator iterChar = value.begin(); iterChar != value.end(); ++iterChar)
+        {
+            switch(*iterChar)
+            {
+                case '&': escaped += "&amp;"; break;
+                case '<': escaped += "&lt;"; break;
+                case '>': escaped += "&gt;"; break;
+                case '"': escaped += "&quot;"; break;
+                case '\'': escaped += "&apos;"; break;
+                default: escaped += *iterChar;
+            }
+        }
+        return escaped;
+    }
+
+    RSGISCalcImageTileQueue::RSGISClaimHeartbeat::RSGISClaimHeartbeat(std::string claimFile, unsigned int intervalSecs)
+    {
+        this->claimFile = claimFile;
+        this->intervalSecs = std::max<unsigned int>(intervalSecs, 1);
+        this->stopping = false;
+        this->beatThread = std::thread(&RSGISClaimHeartbeat::run, this);
+    }
+
+    void RSGISCalcImageTileQueue::RSGISClaimHeartbeat::run()
+    {
+        std::unique_lock<std::mutex> lock(this->beatMutex);
+        while(!this->beatCond.wait_for(lock, std::chrono::seconds(this->intervalSecs), [this]{return this->stopping;}))
+        {
+            boost::system::error_code ec;
+            boost::filesystem::last_write_time(this->claimFile, std::time(NULL), ec);
+        }
+    }
+
+    RSGISCalcImageTileQueue::RSGISClaimHeartbeat::~RSGISClaimHeartbeat()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->beatMutex);
+            this->stopping = true;
+        }
+        this->beatCond.notify_all();
+        this->beatThread.join();
+    }
+
+    RSGISCalcImageTileQueue::~RSGISCalcImageTileQueue()
+    {
+
+    }
+
+}}
@@ -0,0 +1,185 @@
+/*
+ *  RSGISCalcImageTileQueue.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISCalcImageTileQueue_H
+#define RSGISCalcImageTileQueue_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <ctime>
+#include <cstdio>
+#include <cstdlib>
+#include <typeinfo>
+#include <algorithm>
+
+#include <boost/filesystem.hpp>
+#include <boost/algorithm/string.hpp>
+
+#include "gdal_priv.h"
+
+#include "img/RSGISImageCalcException.h"
+#include "img/RSGISImageUtils.h"
+#include "img/RSGISDatasetCache.h"
+#include "img/RSGISCalcImage.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_img_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace img{
+
+    /**
+     * A tile (pixel window) of the output grid of RSGISCalcImage::calcImage.
+     */
+    struct DllExport RSGISCalcImageTile
+    {
+        int xOff;
+        int yOff;
+        int width;
+        int height;
+    };
+
+    /**
+     * Runs RSGISCalcImage::calcImage as a work queue over shared storage so
+     * the same command can be run on several nodes at once. The output grid
+     * is split into tiles and each process (node) claims tiles by creating a
+     * claim file in the job directory, calculating the claimed tiles with
+     * RSGISCalcImage::calcImageTile (using its threads) as GTiff files. Once
+     * every tile has been written one process, again chosen with a claim
+     * file, assembles the tiles into a VRT which is either the output (VRT
+     * format) or copied to the output format (e.g., KEA or COG); the other
+     * processes wait for the assembly before returning.
+     *
+     * The job directory (within the queue directory) is named after the
+     * output image and a hash of the job: the calculator (its type, number
+     * of output bands and getParameterHash), the inputs (file name, size and modification
+     * time), the grid, the tile size and the output format and data type.
+     * The job is also written to the directory, and a directory of a
+     * different job is never reused, so a changed input starts again rather
+     * than mixing tiles. Once a non-VRT output is assembled the job directory
+     * is removed; a VRT output refers to the tiles so it is kept.
+     *
+     * As each pixel is calculated by the same RSGISCalcImageValue from the
+     * same input pixels the output is identical to a single node run.
+     * Calculators which accumulate values across the image (rather than only
+     * writing the output) are not suitable as each process only sees its
+     * tiles.
+     *
+     * A process touches its claim every claimTimeoutSecs / 4 seconds while
+     * the tile is calculated. A claim not touched for claimTimeoutSecs (e.g.,
+     * of a node which was killed) is taken over by another process, so the
+     * timeout must be longer than any difference between the clocks of the
+     * nodes. If a process fails its claims are removed so another process can
+     * take the tiles over.
+     *
+     * RSGISCalcImage::calcImage only uses the queue when one has been set for
+     * the job (see RSGISCalcImage::setTileQueue).
+     */
+    class DllExport RSGISCalcImageTileQueue
+    {
+    public:
+        /**
+         * The tiles are tileSize x tileSize pixels; 0 uses the RSGISLIB_TILE_SIZE
+         * environment variable or 4096.
+         */
+        RSGISCalcImageTileQueue(RSGISCalcImage *calcImage, std::string queueDIR, unsigned int tileSize=0, unsigned int claimTimeoutSecs=600);
+        void calcImage(GDALDataset **datasets, int numDS, std::string outputImage, bool setOutNames = false, std::string *bandNames = NULL, std::string gdalFormat="KEA", GDALDataType gdalDataType=GDT_Float32);
+        /**
+         * Split a width x height grid into tiles of tileSize pixels, row by row.
+         */
+        static std::vector<RSGISCalcImageTile> createTiles(int width, int height, unsigned int tileSize);
+        ~RSGISCalcImageTileQueue();
+    protected:
+        /**
+         * Touches a claim file (sets its modification time to now) every
+         * intervalSecs seconds, from a thread of its own, until it is destroyed
+         * so other processes can tell a live claim from one left by a process
+         * which has died.
+         */
+        class DllExport RSGISClaimHeartbeat
+        {
+        public:
+            RSGISClaimHeartbeat(std::string claimFile, unsigned int intervalSecs);
+            ~RSGISClaimHeartbeat();
+        protected:
+            void run();
+            std::string claimFile;
+            unsigned int intervalSecs;
+            std::mutex beatMutex;
+            std::condition_variable beatCond;
+            bool stopping;
+            std::thread beatThread;
+        };
+        /**
+         * Create the file if it does not exist, returning false if it does (i.e.,
+         * another process has made the claim).
+         */
+        static bool claimFile(std::string filePath);
+        /**
+         * Whether the claim file exists and has not been touched for
+         * claimTimeoutSecs seconds.
+         */
+        bool isStaleClaim(std::string claimFile);
+        /**
+         * The description of the job from which the job directory is named.
+         */
+        std::string createJobDescription(GDALDataset **datasets, int numDS, int width, int height, const double *gdalTransform, std::string gdalFormat, GDALDataType gdalDataType);
+        /**
+         * Write the job description to the job directory, or check it matches
+         * the description written by another process.
+         */
+        void checkJobDescription(boost::filesystem::path jobDIR, std::string jobDesc);
+        /**
+         * Whether the job directory has been removed by the process which
+         * assembled the output (throwing an exception if the output does not
+         * exist, i.e., the directory was removed before the job completed).
+         */
+        static bool jobRemoved(boost::filesystem::path jobDIR, std::string outputImage);
+        void writeVRT(std::string vrtFile, std::string projWKT, const double *gdalTransform, int width, int height, const std::vector<RSGISCalcImageTile> &tiles, const std::vector<std::string> &tileFiles, int numBands, bool setOutNames, std::string *bandNames, GDALDataType gdalDataType);
+        static std::string escapeXML(std::string value);
+        static const unsigned int pollMilliSecs;
+        RSGISCalcImage *calcImg;
+        std::string queueDIR;
+        unsigned int tileSize;
+        unsigned int claimTimeoutSecs;
+    };
+
+}}
+
+#endif
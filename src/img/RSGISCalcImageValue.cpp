@@ -38,6 +38,55 @@ namespace rsgis{namespace img{
 	{
 		numOutBands = bands;
 	}
+    
+    void RSGISCalcImageValue::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        rsgis::RSGISProfiler::addCount("calcimagevalue.calcImageValue", nPxls);
+        this->getScratchArena()->reset();
+        float *inDataColumn = new float[numBands];
+        double *outDataColumn = new double[this->numOutBands];
+        try
+        {
+            for(size_t i = 0; i < nPxls; ++i)
+            {
+                for(int n = 0; n < numBands; ++n)
+                {
+                    inDataColumn[n] = bandPlanes[n][i];
+                }
+                
+                this->calcImageValue(inDataColumn, numBands, outDataColumn);
+                
+                for(int n = 0; n < this->numOutBands; ++n)
+                {
+                    outPlanes[n][i] = outDataColumn[n];
+                }
+            }
+        }
+        catch(RSGISImageCalcException &e)
+        {
+            delete[] inDataColumn;
+            delete[] outDataColumn;
+            throw e;
+        }
+        delete[] inDataColumn;
+        delete[] outDataColumn;
+    }
+
+    void RSGISCalcImageValue::calcImageRowExtent(const float* const* bandRows, int numBands, size_t nPxls, double originX, double originY, double xStep, double pxlWidth, double pxlHeight)
+    {
+        std::vector<float> inDataColumn(numBands);
+        geos::geom::Envelope extent;
+        for(size_t i = 0; i < nPxls; ++i)
+        {
+            for(int n = 0; n < numBands; ++n)
+            {
+                inDataColumn[n] = bandRows[n][i];
+            }
+            double pxlMinX = originX + (i * xStep);
+            extent.init(pxlMinX, (pxlMinX + pxlWidth), originY, (originY - pxlHeight));
+            this->calcImageValue(inDataColumn.data(), numBands, extent);
+        }
+    }
 
     
     
@@ -56,6 +105,30 @@ namespace rsgis{namespace img{
         numOutBands = bands;
     }
     
+    void RSGISCalcValuesFromMultiResInputs::calcLowResBlock(const float *highResVals, unsigned int numCols, unsigned int numRows, unsigned int nXPxls, unsigned int nYPxls, bool useNoData, float noDataVal, double **outPlanes)
+    {
+        size_t highResWidth = ((size_t)numCols) * nXPxls;
+        unsigned int numCellPxls = nXPxls * nYPxls;
+        std::vector<float> cellVals(numCellPxls);
+        std::vector<double> outVals(this->numOutBands);
+        for(unsigned int r = 0; r < numRows; ++r)
+        {
+            for(unsigned int c = 0; c < numCols; ++c)
+            {
+                const float *cellStart = highResVals + (((size_t)r) * nYPxls * highResWidth) + (((size_t)c) * nXPxls);
+                for(unsigned int y = 0; y < nYPxls; ++y)
+                {
+                    std::copy(cellStart + (y * highResWidth), cellStart + (y * highResWidth) + nXPxls, cellVals.begin() + (y * nXPxls));
+                }
+                this->calcImageValue(cellVals.data(), numCellPxls, useNoData, noDataVal, outVals.data());
+                for(int b = 0; b < this->numOutBands; ++b)
+                {
+                    outPlanes[b][(((size_t)r) * numCols) + c] = outVals[b];
+                }
+            }
+        }
+    }
+    
     RSGISCalcValuesFromMultiResInputs::~RSGISCalcValuesFromMultiResInputs()
     {
         
@@ -25,6 +25,11 @@
 
 #include <iostream>
 #include <string>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include "common/RSGISProfiler.h"
+#include "common/RSGISScratchArena.h"
 #include "img/RSGISImageCalcException.h"
 
 #include <geos/geom/Envelope.h>
@@ -44,6 +49,8 @@
 
 namespace rsgis{namespace img{
 
+    class RSGISImageWindowView;
+
     class DllExport RSGISCalcImageValue
     {
         public:
@@ -64,10 +71,99 @@ namespace rsgis{namespace img{
              */
             virtual void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output, geos::geom::Envelope extent) {throw RSGISImageCalcException("Not Implemented - RSGISCalcImageValue Base Class");};
             virtual bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageCalcException("Not Implemented - RSGISCalcImageValue Base Class");};
+            /**
+             * Return true if calcImageWindowValue is implemented, allowing the window
+             * to be read directly from the row buffer rather than copied into a
+             * dataBlock for calcImageValue(float ***dataBlock, ...).
+             */
+            virtual bool useImageWindowView(){return false;};
+            /**
+             * Calculate the output values from a view of the window. The view is
+             * read-only; get(band, y, x) matches dataBlock[band][y][x].
+             */
+            virtual void calcImageWindowValue(const RSGISImageWindowView &window, double *output) {throw RSGISImageCalcException("Not Implemented - RSGISCalcImageValue Base Class");};
+            /**
+             * Return true if calcImageWindowRow is implemented, so a whole image row
+             * of windows is calculated in a single call.
+             */
+            virtual bool useImageWindowRows(){return false;};
+            /**
+             * Calculate the output values for the width windows along an image row.
+             * rowWindow is the view of the window for column 0, so the window for
+             * column x is rowWindow.get(band, y, x+i) (or rowWindow.getRow(band, y)+x).
+             * The output for column x is written to outRows[band][x].
+             */
+            virtual void calcImageWindowRow(const RSGISImageWindowView &rowWindow, int width, double **outRows) {throw RSGISImageCalcException("Not Implemented - RSGISCalcImageValue Base Class");};
+            /**
+             * Calculate the output values for a block of nPxls pixels. The input is
+             * planar (bandPlanes[band][pxl]) as read from the image and the output
+             * is written to outPlanes[band][pxl]. The default implementation gathers
+             * each pixel and calls calcImageValue(float*, int, double*) so subclasses
+             * only need to override this for kernels which can work on whole planes.
+             * When profiling, the number of calcImageValue calls made by the default
+             * implementation is counted under 'calcimagevalue.calcImageValue'.
+             * The default implementation also resets the thread's scratch arena
+             * (see getScratchArena) at the start of each block.
+             */
+            virtual void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+            /**
+             * Process a run of nPxls consecutive pixels along a row, for the loops
+             * which pass each pixel's extent. The input is planar (bandRows[band][pxl])
+             * and pixel i has the extent minX = originX + (i * xStep), maxX = minX +
+             * pxlWidth, maxY = originY and minY = originY - pxlHeight, so the
+             * position of a pixel can be found without building an Envelope. The
+             * default implementation builds the envelope of each pixel and calls
+             * calcImageValue(float*, int, geos::geom::Envelope).
+             */
+            virtual void calcImageRowExtent(const float* const* bandRows, int numBands, size_t nPxls, double originX, double originY, double xStep, double pxlWidth, double pxlHeight);
+            /**
+             * Return true if calcImageBlock must be given whole blocks of rows
+             * (i.e., the native type path, which calls it once per row, is not
+             * used) because each call has a high fixed cost.
+             */
+            virtual bool useWholeBlocks(){return false;};
+            /**
+             * Return true if calcImageValue can be called concurrently on this
+             * instance from several threads (i.e., it has no mutable state).
+             */
+            virtual bool isThreadSafe(){return false;};
+            /**
+             * Return a new instance which can be used by a separate worker thread
+             * or NULL if this calculator cannot be copied. The caller takes ownership
+             * of the returned object.
+             */
+            virtual RSGISCalcImageValue* getThreadClone(){return NULL;};
+            /**
+             * Return true if the calculator accumulates values over the pixels
+             * (e.g., statistics) and implements writeCheckpointState and
+             * readCheckpointState, so a checkpointed calcImage can be resumed
+             * with the values accumulated before the checkpoint. Checkpointed
+             * runs of such calculators use a single worker so the state covers
+             * exactly the completed blocks.
+             */
+            virtual bool hasCheckpointState(){return false;};
+            virtual void writeCheckpointState(std::ostream &stateStream) {throw RSGISImageCalcException("Not Implemented - RSGISCalcImageValue Base Class");};
+            virtual void readCheckpointState(std::istream &stateStream) {throw RSGISImageCalcException("Not Implemented - RSGISCalcImageValue Base Class");};
+            /**
+             * A string identifying the parameters of the calculator (e.g., its
+             * expression), which is hashed into checkpoints and tile queue jobs
+             * so those of the same calculator type with other parameters are
+             * not resumed. The default (empty) only identifies the type.
+             */
+            virtual std::string getParameterHash(){return "";};
             virtual int getNumOutBands();
             virtual void setNumOutBands(int bands);
             virtual ~RSGISCalcImageValue(){};
         protected:
+            /**
+             * Scratch memory for temporary arrays within calcImageValue, so
+             * kernels do not allocate per pixel. Use through a RSGISScratchScope,
+             * e.g. rsgis::RSGISScratchScope scratch(this->getScratchArena());
+             * double *vals = scratch.alloc<double>(numBands);
+             * The arena belongs to the calling thread so this is safe for
+             * thread safe and cloned calculators.
+             */
+            rsgis::RSGISScratchArena* getScratchArena(){return rsgis::RSGISScratchArena::getThreadArena();};
             int numOutBands;
     };
     
@@ -78,6 +174,20 @@ namespace rsgis{namespace img{
     public:
         RSGISCalcValuesFromMultiResInputs(int numberOutBands);
         virtual void calcImageValue(float *bandValues, int numInVals, bool useNoData, float noDataVal, double *output)  = 0;
+        /**
+         * Calculate the values for a block of numRows x numCols low resolution
+         * cells, each covering nXPxls x nYPxls pixels of highResVals (row major,
+         * numCols*nXPxls wide). The values of a cell are written to
+         * outPlanes[band][(row*numCols)+col]. The default implementation gathers
+         * the pixels of each cell and calls calcImageValue, so subclasses only
+         * need to override this for kernels which can reduce whole rows.
+         */
+        virtual void calcLowResBlock(const float *highResVals, unsigned int numCols, unsigned int numRows, unsigned int nXPxls, unsigned int nYPxls, bool useNoData, float noDataVal, double **outPlanes);
+        /**
+         * Return true if calcLowResBlock can be called concurrently on this
+         * instance from several threads (i.e., it has no mutable state).
+         */
+        virtual bool isThreadSafe(){return false;};
         virtual int getNumOutBands();
         virtual void setNumOutBands(int bands);
         virtual ~RSGISCalcValuesFromMultiResInputs();
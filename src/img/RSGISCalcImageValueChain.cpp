@@ -0,0 +1,194 @@
+/*
+ *  RSGISCalcImageValueChain.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2010 RSGISLib. All rights reserved.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISCalcImageValueChain.h"
+
+namespace rsgis{namespace img{
+
+    RSGISCalcImageValueChain::RSGISCalcImageValueChain() : RSGISCalcImageValue(0)
+    {
+        this->numBufPxls = 0;
+    }
+
+    unsigned int RSGISCalcImageValueChain::addStage(RSGISCalcImageValue *calc)
+    {
+        std::vector<RSGISCalcChainBand> inBands;
+        if(!this->stages.empty())
+        {
+            int prevStage = this->stages.size() - 1;
+            int numPrevBands = this->stages.back().calc->getNumOutBands();
+            for(int i = 0; i < numPrevBands; ++i)
+            {
+                inBands.push_back(RSGISCalcChainBand(prevStage, i));
+            }
+        }
+        return this->addStage(calc, inBands);
+    }
+
+    unsigned int RSGISCalcImageValueChain::addStage(RSGISCalcImageValue *calc, std::vector<RSGISCalcChainBand> inBands)
+    {
+        if(calc == NULL)
+        {
+            throw RSGISImageCalcException("A stage of the calculation chain is NULL.");
+        }
+        int stageIdx = this->stages.size();
+        for(std::vector<RSGISCalcChainBand>::iterator iterBand = inBands.begin(); iterBand != inBands.end(); ++iterBand)
+        {
+            if((*iterBand).stage >= stageIdx)
+            {
+                throw RSGISImageCalcException("A stage can only take the outputs of earlier stages.");
+            }
+            if(((*iterBand).stage >= 0) && (((*iterBand).band < 0) || ((*iterBand).band >= this->stages[(*iterBand).stage].calc->getNumOutBands())))
+            {
+                throw RSGISImageCalcException("A stage input band is not an output of the stage it refers to.");
+            }
+        }
+        RSGISCalcChainStage stage;
+        stage.calc = calc;
+        stage.inBands = inBands;
+        this->stages.push_back(stage);
+        this->numOutBands = calc->getNumOutBands();
+        // The buffers are reallocated for the new stage on the next block.
+        this->numBufPxls = 0;
+        return stageIdx;
+    }
+
+    void RSGISCalcImageValueChain::allocBuffers(size_t nPxls)
+    {
+        for(std::vector<RSGISCalcChainStage>::iterator iterStage = this->stages.begin(); iterStage != this->stages.end(); ++iterStage)
+        {
+            size_t numIn = (*iterStage).inBands.size();
+            size_t numOut = (*iterStage).calc->getNumOutBands();
+            (*iterStage).inBuffer.assign(numIn * nPxls, 0);
+            (*iterStage).inPlanes.assign(numIn, NULL);
+            (*iterStage).outBuffer.assign(numOut * nPxls, 0);
+            (*iterStage).outPlanes.assign(numOut, NULL);
+            for(size_t i = 0; i < numOut; ++i)
+            {
+                (*iterStage).outPlanes[i] = (*iterStage).outBuffer.data() + (i * nPxls);
+            }
+        }
+        this->numBufPxls = nPxls;
+    }
+
+    void RSGISCalcImageValueChain::calcImageValue(float *bandValues, int numBands, double *output)
+    {
+        std::vector<const float*> bandPlanes(numBands, NULL);
+        for(int i = 0; i < numBands; ++i)
+        {
+            bandPlanes[i] = &bandValues[i];
+        }
+        std::vector<double*> outPlanes(this->numOutBands, NULL);
+        for(int i = 0; i < this->numOutBands; ++i)
+        {
+            outPlanes[i] = &output[i];
+        }
+        this->calcImageBlock(bandPlanes.data(), numBands, 1, outPlanes.data());
+    }
+
+    void RSGISCalcImageValueChain::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        if(this->stages.empty())
+        {
+            throw RSGISImageCalcException("The calculation chain has no stages.");
+        }
+        if(nPxls > this->numBufPxls)
+        {
+            this->allocBuffers(nPxls);
+        }
+
+        size_t numStages = this->stages.size();
+        for(size_t s = 0; s < numStages; ++s)
+        {
+            RSGISCalcChainStage &stage = this->stages[s];
+            std::vector<RSGISCalcChainBand> inBands = stage.inBands;
+            if((s == 0) && inBands.empty())
+            {
+                for(int i = 0; i < numBands; ++i)
+                {
+                    inBands.push_back(RSGISCalcChainBand(-1, i));
+                }
+            }
+            if(stage.inPlanes.size() < inBands.size())
+            {
+                stage.inPlanes.assign(inBands.size(), NULL);
+            }
+
+            for(size_t i = 0; i < inBands.size(); ++i)
+            {
+                if(inBands[i].stage < 0)
+                {
+                    if((inBands[i].band < 0) || (inBands[i].band >= numBands))
+                    {
+                        throw RSGISImageCalcException("A stage input band is not within the input image bands.");
+                    }
+                    stage.inPlanes[i] = bandPlanes[inBands[i].band];
+                }
+                else
+                {
+                    // Values passed between stages are converted to float planes.
+                    float *inPlane = stage.inBuffer.data() + (i * this->numBufPxls);
+                    const double *prevPlane = this->stages[inBands[i].stage].outPlanes[inBands[i].band];
+                    for(size_t j = 0; j < nPxls; ++j)
+                    {
+                        inPlane[j] = prevPlane[j];
+                    }
+                    stage.inPlanes[i] = inPlane;
+                }
+            }
+
+            double **stageOutPlanes = (s == (numStages-1))?outPlanes:stage.outPlanes.data();
+            stage.calc->calcImageBlock(stage.inPlanes.data(), inBands.size(), nPxls, stageOutPlanes);
+        }
+    }
+
+    RSGISCalcImageValue* RSGISCalcImageValueChain::getThreadClone()
+    {
+        RSGISCalcImageValueChain *clone = new RSGISCalcImageValueChain();
+        for(std::vector<RSGISCalcChainStage>::iterator iterStage = this->stages.begin(); iterStage != this->stages.end(); ++iterStage)
+        {
+            RSGISCalcImageValue *stageCalc = (*iterStage).calc;
+            if(!stageCalc->isThreadSafe())
+            {
+                stageCalc = stageCalc->getThreadClone();
+                if(stageCalc == NULL)
+                {
+                    delete clone;
+                    return NULL;
+                }
+                clone->ownedCalcs.push_back(stageCalc);
+            }
+            clone->addStage(stageCalc, (*iterStage).inBands);
+        }
+        return clone;
+    }
+
+    RSGISCalcImageValueChain::~RSGISCalcImageValueChain()
+    {
+        for(std::vector<RSGISCalcImageValue*>::iterator iterCalc = this->ownedCalcs.begin(); iterCalc != this->ownedCalcs.end(); ++iterCalc)
+        {
+            delete *iterCalc;
+        }
+    }
+
+}}
@@ -0,0 +1,111 @@
+/*
+ *  RSGISCalcImageValueChain.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2010 RSGISLib. All rights reserved.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISCalcImageValueChain_H
+#define RSGISCalcImageValueChain_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "img/RSGISImageCalcException.h"
+#include "img/RSGISCalcImageValue.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_img_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace img{
+
+    /**
+     * A band used as an input to a stage of a RSGISCalcImageValueChain:
+     * either a band of the input image(s) (stage = -1) or an output band of
+     * an earlier stage (indexed from 0).
+     */
+    struct DllExport RSGISCalcChainBand
+    {
+        RSGISCalcChainBand(){stage = -1; band = 0;};
+        RSGISCalcChainBand(int stage, int band){this->stage = stage; this->band = band;};
+        int stage;
+        int band;
+    };
+
+    /**
+     * Combines several RSGISCalcImageValue calculators (e.g., band maths,
+     * then a mask, then a stretch) into one so they are evaluated together
+     * on each block read by RSGISCalcImage, with the intermediate results
+     * kept in memory rather than written out as images.
+     *
+     * Each stage takes as its input bands any of the input image bands and
+     * the outputs of earlier stages (by default all the outputs of the
+     * previous stage, or the input bands for the first stage) and the
+     * output of the chain is the output of the last stage. The stages are
+     * called through calcImageBlock, so those with block implementations
+     * (e.g., the muparser bulk mode of RSGISBandMath) work on whole planes.
+     *
+     * As when written to a Float32 image, the intermediate values passed
+     * between stages are floats.
+     *
+     * The stages are not owned by the chain, except those of a thread clone.
+     */
+    class DllExport RSGISCalcImageValueChain : public RSGISCalcImageValue
+    {
+    public:
+        RSGISCalcImageValueChain();
+        /** Add a stage taking all the outputs of the previous stage; returns the stage index. */
+        unsigned int addStage(RSGISCalcImageValue *calc);
+        /** Add a stage taking the bands listed; returns the stage index. */
+        unsigned int addStage(RSGISCalcImageValue *calc, std::vector<RSGISCalcChainBand> inBands);
+        unsigned int getNumStages(){return stages.size();};
+        void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        RSGISCalcImageValue* getThreadClone();
+        ~RSGISCalcImageValueChain();
+    protected:
+        struct RSGISCalcChainStage
+        {
+            RSGISCalcImageValue *calc;
+            std::vector<RSGISCalcChainBand> inBands;
+            std::vector<float> inBuffer;
+            std::vector<const float*> inPlanes;
+            std::vector<double> outBuffer;
+            std::vector<double*> outPlanes;
+        };
+        void allocBuffers(size_t nPxls);
+        std::vector<RSGISCalcChainStage> stages;
+        std::vector<RSGISCalcImageValue*> ownedCalcs;
+        size_t numBufPxls;
+    };
+
+}}
+
+#endif
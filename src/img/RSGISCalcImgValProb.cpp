@@ -25,6 +25,15 @@
 
 namespace rsgis{namespace img{
     
+    RSGISCalcImgValProb::RSGISCalcImgValProb()
+    {
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+    
+    void RSGISCalcImgValProb::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
 
     void RSGISCalcImgValProb::calcMaskImgPxlValProb(GDALDataset *inImgDS, std::vector<unsigned int> inImgBandIdxs, GDALDataset *inMaskDS, int maskVal, std::string outputImage, std::string gdalFormat, std::vector<float> histBinWidths, bool calcHistBinWidth, bool useImgNoData, bool rescaleProbs)
     {
@@ -58,31 +67,42 @@ namespace rsgis{namespace img{
                 
                 noDataVals[i] = inImgDS->GetRasterBand(i+1)->GetNoDataValue();
             }
-            delete[] noDataVals;
             rsgis::img::RSGISImageStatistics imgStats;
             imgStats.calcImageStatisticsMask(inImgDS, inMaskDS, maskVal, stats, noDataVals, useImgNoData, numBands, false, false);
+            delete[] noDataVals;
             
-            
-            double *bandMin = new double[numHistDIMS];
-            double *bandMax = new double[numHistDIMS];
-            unsigned long *numBins = new unsigned long[numHistDIMS];
-            noDataVals = new double[numHistDIMS];
+            RSGISNDHistBinning binning;
+            binning.useNoData = useImgNoData;
+            unsigned long long totalNumBins = 1;
             for(unsigned int i = 0; i < numHistDIMS; ++i)
             {
-                bandMin[i] = stats[inImgBandIdxs.at(i)-1]->min;
-                bandMax[i] = stats[inImgBandIdxs.at(i)-1]->max;
-                double range = bandMax[i] - bandMin[i];
+                double bandMin = stats[inImgBandIdxs.at(i)-1]->min;
+                double bandMax = stats[inImgBandIdxs.at(i)-1]->max;
+                double range = bandMax - bandMin;
                 double numBinsFloatTmp = range/histBinWidths.at(i);
-                int numBinsTmp = ceil(numBinsFloatTmp);
+                unsigned long long numBinsTmp = ceil(numBinsFloatTmp);
                 double calcHistRange = numBinsTmp*histBinWidths.at(i);
-                if((bandMin[i] + calcHistRange) < bandMax[i])
+                if((bandMin + calcHistRange) < bandMax)
                 {
                     numBinsTmp = numBinsTmp + 1;
                 }
-                numBins[i] = numBinsTmp;
-                noDataVals[i] = inImgDS->GetRasterBand(inImgBandIdxs.at(i))->GetNoDataValue();
-                std::cout << "Band No Data = " << noDataVals[i] << std::endl;
-                std::cout << "Band " << inImgBandIdxs.at(i) << ":\t[" << bandMin[i] << ", " << bandMax[i] << "] (" << histBinWidths.at(i) << "): " << numBins[i] << std::endl;
+                if(numBinsTmp == 0)
+                {
+                    numBinsTmp = 1;
+                }
+                if(totalNumBins > (std::numeric_limits<unsigned long long>::max() / numBinsTmp))
+                {
+                    throw RSGISImageCalcException("The number of histogram bins is too large for the bin codes, use wider bins.");
+                }
+                totalNumBins = totalNumBins * numBinsTmp;
+                
+                binning.bandMin.push_back(bandMin);
+                binning.bandMax.push_back(bandMax);
+                binning.binWidths.push_back(histBinWidths.at(i));
+                binning.numBins.push_back(numBinsTmp);
+                binning.noDataVals.push_back(inImgDS->GetRasterBand(inImgBandIdxs.at(i))->GetNoDataValue());
+                std::cout << "Band No Data = " << binning.noDataVals[i] << std::endl;
+                std::cout << "Band " << inImgBandIdxs.at(i) << ":\t[" << bandMin << ", " << bandMax << "] (" << histBinWidths.at(i) << "): " << numBinsTmp << std::endl;
             }
                 
             for(int i = 0; i < numBands; ++i)
@@ -94,83 +114,40 @@ namespace rsgis{namespace img{
             
             std::cout << "Create and Populate n-d Histogram\n";
             
-            unsigned long totalNumBins = numBins[0];
-            for(unsigned int i = 1; i < numHistDIMS; ++i)
-            {
-                totalNumBins = totalNumBins * numBins[i];
-            }
-            double *hist = new double[totalNumBins];
-            for(unsigned long i = 0; i < totalNumBins; ++i)
-            {
-                hist[i] = 0.0;
-            }
-            
-            RSGISCalcImagePopNDHist calcImageStats = RSGISCalcImagePopNDHist(inImgBandIdxs, maskVal, noDataVals, useImgNoData, bandMin, bandMax, histBinWidths, numBins, hist, totalNumBins);
-            RSGISCalcImage calcImg = RSGISCalcImage(&calcImageStats, "", true);
-            
-            GDALDataset **datasets = new GDALDataset*[2];
-            datasets[0] = inMaskDS;
-            datasets[1] = inImgDS;
-            calcImg.calcImage(datasets, 1, 1);
-            delete[] datasets;
+            std::vector<unsigned long long> binCodes;
+            std::vector<double> hist;
+            this->popSparseNDHist(inImgDS, inImgBandIdxs, inMaskDS, maskVal, binning, &binCodes, &hist);
+            std::cout << "The histogram has " << binCodes.size() << " occupied bins of " << totalNumBins << std::endl;
             
-            unsigned long nPxl = 0;
-            for(unsigned long i = 0; i < totalNumBins; ++i)
+            double nPxl = 0;
+            for(size_t i = 0; i < hist.size(); ++i)
             {
                 nPxl += hist[i];
             }
             
-            for(unsigned long i = 0; i < totalNumBins; ++i)
+            double maxVal = 0;
+            for(size_t i = 0; i < hist.size(); ++i)
             {
-                if(hist[i] > 0)
+                hist[i] = hist[i] / nPxl;
+                if(hist[i] > maxVal)
                 {
-                    hist[i] = hist[i] / nPxl;
-                }
-                else
-                {
-                    hist[i] = 0.0;
+                    maxVal = hist[i];
                 }
             }
             
-            if(rescaleProbs)
+            if(rescaleProbs && (maxVal > 0))
             {
-                double maxVal = 0;
-                bool first = true;
-                for(unsigned long i = 0; i < totalNumBins; ++i)
-                {
-                    if(hist[i] > 0)
-                    {
-                        if(first)
-                        {
-                            maxVal = hist[i];
-                            first = false;
-                        }
-                        else if(hist[i] > maxVal)
-                        {
-                            maxVal = hist[i];
-                        }
-                    }
-                }
-                
                 double mulVal = 1/maxVal;
-                for(unsigned long i = 0; i < totalNumBins; ++i)
+                for(size_t i = 0; i < hist.size(); ++i)
                 {
-                    if(hist[i] > 0)
-                    {
-                        hist[i] = hist[i] * mulVal;
-                    }
+                    hist[i] = hist[i] * mulVal;
                 }
-                
             }
             
             std::cout << "Populate the output image\n";
+            RSGISCalcImagePopNDHist calcImageProbs = RSGISCalcImagePopNDHist(inImgBandIdxs, &binning, &binCodes, &hist);
+            RSGISCalcImage calcImg = RSGISCalcImage(&calcImageProbs, "", true);
             calcImg.calcImage(&inImgDS, 1, outputImage, false, NULL, gdalFormat, GDT_Float32);
-            
-            delete[] hist;
-            delete[] bandMin;
-            delete[] bandMax;
-            delete[] numBins;
-            delete[] noDataVals;
         }
         catch(RSGISImageCalcException &e)
         {
@@ -189,153 +166,145 @@ namespace rsgis{namespace img{
             throw RSGISImageCalcException(e.what());
         }
     }
-
-    
     
-    
-    RSGISCalcImagePopNDHist::RSGISCalcImagePopNDHist(std::vector<unsigned int> inImgBandIdxs, long maskVal, double *noDataVals, bool useNoData, double *bandMin, double *bandMax, std::vector<float> histBinWidths, unsigned long *numBins, double *hist, unsigned long totalNumBins):RSGISCalcImageValue(1)
-    {
-        this->inImgBandIdxs = inImgBandIdxs;
-        this->maskVal = maskVal;
-        this->noDataVals = noDataVals;
-        this->useNoData = useNoData;
-        this->bandMin = bandMin;
-        this->bandMax = bandMax;
-        this->histBinWidths = histBinWidths;
-        this->numBins = numBins;
-        this->hist = hist;
-        this->totalNumBins = totalNumBins;
-    }
-    
-    void RSGISCalcImagePopNDHist::calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals)
+    void RSGISCalcImgValProb::popSparseNDHist(GDALDataset *inImgDS, std::vector<unsigned int> inImgBandIdxs, GDALDataset *inMaskDS, int maskVal, const RSGISNDHistBinning &binning, std::vector<unsigned long long> *binCodes, std::vector<double> *binCounts)
     {
-        if(numIntVals != 1)
+        RSGISImageUtils imgUtils;
+        GDALDataset **datasets = new GDALDataset*[2];
+        datasets[0] = inMaskDS;
+        datasets[1] = inImgDS;
+        int **dsOffsets = new int*[2];
+        dsOffsets[0] = new int[2];
+        dsOffsets[1] = new int[2];
+        int width = 0;
+        int height = 0;
+        double *gdalTransform = new double[6];
+        int xBlockSize = 0;
+        int yBlockSize = 0;
+        try
+        {
+            imgUtils.getImageOverlap(datasets, 2, dsOffsets, &width, &height, gdalTransform, &xBlockSize, &yBlockSize);
+        }
+        catch(RSGISImageBandException &e)
         {
-            throw RSGISImageCalcException("The number of mask bands should be 1.");
+            delete[] dsOffsets[0];
+            delete[] dsOffsets[1];
+            delete[] dsOffsets;
+            delete[] datasets;
+            delete[] gdalTransform;
+            throw RSGISImageCalcException(e.what());
         }
+        int maskXOff = dsOffsets[0][0];
+        int maskYOff = dsOffsets[0][1];
+        int imgXOff = dsOffsets[1][0];
+        int imgYOff = dsOffsets[1][1];
+        delete[] dsOffsets[0];
+        delete[] dsOffsets[1];
+        delete[] dsOffsets;
+        delete[] datasets;
+        delete[] gdalTransform;
+        
+        std::vector<int> bandMap(inImgBandIdxs.begin(), inImgBandIdxs.end());
+        size_t numDims = bandMap.size();
+        yBlockSize = std::max(yBlockSize, 1);
+        unsigned int nBlocks = (height + yBlockSize - 1) / yBlockSize;
+        unsigned int nThreads = std::max<unsigned int>(std::min(this->numThreads, nBlocks), 1);
         
-        if(intBandValues[0] == this->maskVal)
+        std::vector<std::unordered_map<unsigned long long, double> > threadHists(nThreads);
+        std::mutex ioMutex;
+        rsgis::utils::RSGISWorkerPool pool(nThreads);
+        pool.parallelFor(nBlocks, [&](size_t blk, unsigned int t)
         {
-            unsigned int bIdx = 0;
-            unsigned long *binIdxs = new unsigned long[inImgBandIdxs.size()];
-            bool notValid = false;
-            for(unsigned int i = 0; i < inImgBandIdxs.size(); ++i)
+            std::unordered_map<unsigned long long, double> &threadHist = threadHists[t];
+            size_t bandStride = ((size_t)width) * yBlockSize;
+            std::vector<int> maskData(bandStride);
+            std::vector<float> imgData(bandStride * numDims);
+            std::vector<float> dimVals(numDims);
+            unsigned long long code = 0;
+            int yOff = blk * yBlockSize;
+            int numRows = std::min(yBlockSize, height - yOff);
             {
-                bIdx = inImgBandIdxs.at(i)-1;
-                if(!boost::math::isnan(floatBandValues[bIdx]))
+                std::lock_guard<std::mutex> lock(ioMutex);
+                if(inMaskDS->GetRasterBand(1)->RasterIO(GF_Read, maskXOff, maskYOff + yOff, width, numRows, maskData.data(), width, numRows, GDT_Int32, 0, 0) != CE_None)
                 {
-                    if((!useNoData) || (useNoData && (floatBandValues[bIdx] != this->noDataVals[i])))
-                    {
-                        double binF = (floatBandValues[bIdx] - bandMin[i])/histBinWidths.at(i);
-                        binIdxs[i] = floor(binF+0.5);
-                    }
-                    else
-                    {
-                        notValid = true;
-                        break;
-                    }
+                    throw RSGISImageCalcException("Could not read a block of the mask image.");
                 }
-                else
+                if(inImgDS->RasterIO(GF_Read, imgXOff, imgYOff + yOff, width, numRows, imgData.data(), width, numRows, GDT_Float32, numDims, bandMap.data(), sizeof(float), sizeof(float) * width, sizeof(float) * bandStride, NULL) != CE_None)
                 {
-                    notValid = true;
-                    break;
+                    throw RSGISImageCalcException("Could not read a block of the image.");
                 }
-                
             }
             
-            if(!notValid)
+            size_t numBlockPxls = ((size_t)width) * numRows;
+            for(size_t p = 0; p < numBlockPxls; ++p)
             {
-                unsigned long idx = 0;
-                unsigned long tDIMS = 0;
-                for(unsigned int i = 0; i < inImgBandIdxs.size(); ++i)
+                if(maskData[p] != maskVal)
+                {
+                    continue;
+                }
+                for(size_t d = 0; d < numDims; ++d)
                 {
-                    if(i == 0)
-                    {
-                        idx = binIdxs[i];
-                        tDIMS = this->numBins[i];
-                    }
-                    else
-                    {
-                        idx = idx + (binIdxs[i] * tDIMS);
-                        tDIMS = tDIMS * this->numBins[i];
-                    }
+                    dimVals[d] = imgData[(d * bandStride) + p];
                 }
-                if(idx < totalNumBins)
+                if(binning.getBinCode(dimVals.data(), &code))
                 {
-                    hist[idx] = hist[idx] + 1;
+                    threadHist[code] += 1;
                 }
             }
-            
-            delete[] binIdxs;
+        });
+        
+        // Merge the thread histograms into the first and sort by code.
+        std::unordered_map<unsigned long long, double> &hist = threadHists[0];
+        for(unsigned int t = 1; t < nThreads; ++t)
+        {
+            for(std::unordered_map<unsigned long long, double>::iterator iterBin = threadHists[t].begin(); iterBin != threadHists[t].end(); ++iterBin)
+            {
+                hist[iterBin->first] += iterBin->second;
+            }
+            threadHists[t].clear();
+        }
+        std::vector<std::pair<unsigned long long, double> > sortedBins(hist.begin(), hist.end());
+        hist.clear();
+        std::sort(sortedBins.begin(), sortedBins.end());
+        binCodes->resize(sortedBins.size());
+        binCounts->resize(sortedBins.size());
+        for(size_t i = 0; i < sortedBins.size(); ++i)
+        {
+            (*binCodes)[i] = sortedBins[i].first;
+            (*binCounts)[i] = sortedBins[i].second;
         }
     }
+
+    
+    
+    
+    RSGISCalcImagePopNDHist::RSGISCalcImagePopNDHist(std::vector<unsigned int> inImgBandIdxs, const RSGISNDHistBinning *binning, const std::vector<unsigned long long> *binCodes, const std::vector<double> *binVals):RSGISCalcImageValue(1)
+    {
+        this->inImgBandIdxs = inImgBandIdxs;
+        this->binning = binning;
+        this->binCodes = binCodes;
+        this->binVals = binVals;
+    }
     
     void RSGISCalcImagePopNDHist::calcImageValue(float *bandValues, int numBands, double *output) 
     {
         output[0] = 0.0;
-        unsigned long *binIdxs = new unsigned long[inImgBandIdxs.size()];
-        bool notValid = false;
-        unsigned int bIdx = 0;
+        rsgis::RSGISScratchScope scratch(this->getScratchArena());
+        float *dimVals = scratch.alloc<float>(inImgBandIdxs.size());
         for(unsigned int i = 0; i < inImgBandIdxs.size(); ++i)
         {
-            bIdx = inImgBandIdxs.at(i)-1;
-            if(!boost::math::isnan(bandValues[bIdx]))
-            {
-                if((bandValues[bIdx] >= bandMin[i]) & (bandValues[bIdx] <= bandMax[i]))
-                {
-                    if((!useNoData) || (useNoData && (bandValues[bIdx] != this->noDataVals[i])))
-                    {
-                        double binF = (bandValues[bIdx] - bandMin[i])/histBinWidths.at(i);
-                        binIdxs[i] = floor(binF+0.5);
-                    }
-                    else
-                    {
-                        notValid = true;
-                        break;
-                    }
-                }
-                else
-                {
-                    notValid = true;
-                    break;
-                }
-            }
-            else
-            {
-                notValid = true;
-                break;
-            }
-            
+            dimVals[i] = bandValues[inImgBandIdxs.at(i)-1];
         }
         
-        if(!notValid)
+        unsigned long long code = 0;
+        if(this->binning->getBinCode(dimVals, &code))
         {
-            unsigned long idx = 0;
-            unsigned long tDIMS = 0;
-            for(unsigned int i = 0; i < inImgBandIdxs.size(); ++i)
+            std::vector<unsigned long long>::const_iterator iterCode = std::lower_bound(this->binCodes->begin(), this->binCodes->end(), code);
+            if((iterCode != this->binCodes->end()) && ((*iterCode) == code))
             {
-                if(i == 0)
-                {
-                    idx = binIdxs[i];
-                    tDIMS = this->numBins[i];
-                }
-                else
-                {
-                    idx = idx + (binIdxs[i] * tDIMS);
-                    tDIMS = tDIMS * this->numBins[i];
-                }
-            }
-            if(idx < totalNumBins)
-            {
-                output[0] = hist[idx];
-            }
-            else
-            {
-                output[0] = 0;
+                output[0] = (*this->binVals)[iterCode - this->binCodes->begin()];
             }
         }
-        
-        delete[] binIdxs;
     }
     
     RSGISCalcImagePopNDHist::~RSGISCalcImagePopNDHist()
@@ -343,4 +312,3 @@ namespace rsgis{namespace img{
         
     }
 }}
-
@@ -25,6 +25,16 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <cstdlib>
+#include <cmath>
+#include <limits>
 
 #include "gdal_priv.h"
 
@@ -34,6 +44,7 @@
 #include "img/RSGISCalcImageValue.h"
 #include "img/RSGISCalcImage.h"
 #include "img/RSGISImageStatistics.h"
+#include "common/RSGISParallel.h"
 
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
@@ -50,40 +61,92 @@
 
 namespace rsgis{namespace img{
     
+    /**
+     * The bins of an N-dimensional histogram of image band values. Each
+     * dimension has numBins bins of binWidth from bandMin (a value is in
+     * the bin its offset from bandMin rounds to, clamped to the last bin)
+     * and the bins are packed into a single code, with the first dimension
+     * varying fastest, so the histogram can be stored sparsely as the codes
+     * of the occupied bins.
+     */
+    struct DllExport RSGISNDHistBinning
+    {
+        std::vector<double> bandMin;
+        std::vector<double> bandMax;
+        std::vector<double> binWidths;
+        std::vector<unsigned long long> numBins;
+        std::vector<double> noDataVals;
+        bool useNoData;
+        /**
+         * The code of the bin for the values of each dimension. Returns false
+         * if a value is NaN, no data or outside the range of its dimension.
+         */
+        bool getBinCode(const float *dimVals, unsigned long long *code) const
+        {
+            unsigned long long binCode = 0;
+            unsigned long long dimStride = 1;
+            for(size_t i = 0; i < numBins.size(); ++i)
+            {
+                float val = dimVals[i];
+                if(std::isnan(val) || (useNoData && (val == noDataVals[i])) || (val < bandMin[i]) || (val > bandMax[i]))
+                {
+                    return false;
+                }
+                unsigned long long binIdx = std::floor(((val - bandMin[i])/binWidths[i])+0.5);
+                binCode += std::min(binIdx, numBins[i]-1) * dimStride;
+                dimStride *= numBins[i];
+            }
+            *code = binCode;
+            return true;
+        };
+    };
+    
+    /**
+     * Calculate the probability of the pixel values of an image from an
+     * N-dimensional histogram of the values within a mask. The histogram is
+     * sparse (only the occupied bins are stored, sorted by bin code) so its
+     * memory depends on the number of distinct bins in the mask rather than
+     * the number of bins to the power of the number of bands, making masks
+     * of 6-8 bands practical. It is populated by threads (setNumThreads or
+     * the RSGISLIB_NUM_THREADS environment variable) reading blocks of the
+     * image, each counting into its own hash map, which are then merged.
+     */
     class DllExport RSGISCalcImgValProb
     {
     public:
-        RSGISCalcImgValProb(){};
+        RSGISCalcImgValProb();
+        /**
+         * The number of threads (0 uses the number of cores).
+         */
+        void setNumThreads(unsigned int numThreads);
         void calcMaskImgPxlValProb(GDALDataset *inImgDS, std::vector<unsigned int> inImgBandIdxs, GDALDataset *inMaskDS, int maskVal, std::string outputImage, std::string gdalFormat, std::vector<float> histBinWidths, bool calcHistBinWidth, bool useImgNoData, bool rescaleProbs);
         ~RSGISCalcImgValProb(){};
+    protected:
+        /**
+         * Count the pixels within the mask into the bins of the histogram,
+         * returning the codes of the occupied bins (sorted) and their counts.
+         */
+        void popSparseNDHist(GDALDataset *inImgDS, std::vector<unsigned int> inImgBandIdxs, GDALDataset *inMaskDS, int maskVal, const RSGISNDHistBinning &binning, std::vector<unsigned long long> *binCodes, std::vector<double> *binCounts);
+        unsigned int numThreads;
     };
   
+    /**
+     * Look up the value of the sparse N-dimensional histogram bin of each
+     * pixel (0 if the bin is empty or the pixel is not valid) by a binary
+     * search of the sorted bin codes.
+     */
     class DllExport RSGISCalcImagePopNDHist : public RSGISCalcImageValue
     {
     public:
-        RSGISCalcImagePopNDHist(std::vector<unsigned int> inImgBandIdxs, long maskVal, double *noDataVals, bool useNoData, double *bandMin, double *bandMax, std::vector<float> histBinWidths, unsigned long *numBins, double *hist, unsigned long totalNumBins);
+        RSGISCalcImagePopNDHist(std::vector<unsigned int> inImgBandIdxs, const RSGISNDHistBinning *binning, const std::vector<unsigned long long> *binCodes, const std::vector<double> *binVals);
         void calcImageValue(float *bandValues, int numBands, double *output);
-        void calcImageValue(float *bandValues, int numBands){throw RSGISImageCalcException("Not implemented");};
-        void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals);
-        void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw RSGISImageCalcException("Not implemented");};
-        void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, geos::geom::Envelope extent){throw rsgis::img::RSGISImageCalcException("Not implemented");};
-        void calcImageValue(float *bandValues, int numBands, geos::geom::Envelope extent) {throw RSGISImageCalcException("Not implemented");};
-        void calcImageValue(float *bandValues, int numBands, double *output, geos::geom::Envelope extent) {throw RSGISImageCalcException("Not implemented");};
-        void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageCalcException("Not implemented");};
-        void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output, geos::geom::Envelope extent) {throw RSGISImageCalcException("No implemented");};
-        bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageCalcException("Not implemented");};
+        bool isThreadSafe(){return true;};
         ~RSGISCalcImagePopNDHist();
     protected:
         std::vector<unsigned int> inImgBandIdxs;
-        long maskVal;
-        double *noDataVals;
-        bool useNoData;
-        double *bandMin;
-        double *bandMax;
-        std::vector<float> histBinWidths;
-        unsigned long *numBins;
-        double *hist;
-        unsigned long totalNumBins;
+        const RSGISNDHistBinning *binning;
+        const std::vector<unsigned long long> *binCodes;
+        const std::vector<double> *binVals;
     };
     
 }}
@@ -113,6 +113,66 @@ namespace rsgis{ namespace img{
     
     
 	
+    void RSGISColourUpImageLUT::colourUpImage(GDALDataset *inData, std::string outputImage, std::string imageFormat, ClassColour **classColour, int numClasses, bool singleBand)
+    {
+        if(!(numClasses > 0))
+        {
+            throw RSGISImageCalcException("The number of classes needs to be greater than zero.");
+        }
+        
+        // The band used by the classes (as indexed by RSGISColourUpImage).
+        int imgBand = singleBand?0:classColour[0]->imgBand;
+        bool oneBand = true;
+        for(int i = 1; (i < numClasses) && (!singleBand); i++)
+        {
+            oneBand = oneBand && (classColour[i]->imgBand == imgBand);
+        }
+        
+        int lutMin = 0;
+        unsigned int lutSize = 0;
+        if(oneBand && (imgBand >= 0) && (imgBand < inData->GetRasterCount()) && RSGISIntegerLUTImage::getIntegerRange(inData->GetRasterBand(imgBand+1)->GetRasterDataType(), &lutMin, &lutSize))
+        {
+            std::vector<double> red(lutSize, 0);
+            std::vector<double> green(lutSize, 0);
+            std::vector<double> blue(lutSize, 0);
+            for(unsigned int j = 0; j < lutSize; ++j)
+            {
+                float val = (float)(((long)lutMin) + j);
+                for(int i = 0; i < numClasses; i++)
+                {
+                    if((val > classColour[i]->lower) && (val <= classColour[i]->upper))
+                    {
+                        red[j] = classColour[i]->red;
+                        green[j] = classColour[i]->green;
+                        blue[j] = classColour[i]->blue;
+                        break;
+                    }
+                }
+            }
+            RSGISIntegerLUTImage lutImage(3, lutMin, lutSize);
+            lutImage.setBandLUT(0, imgBand, red);
+            lutImage.setBandLUT(1, imgBand, green);
+            lutImage.setBandLUT(2, imgBand, blue);
+            lutImage.apply(inData, outputImage, imageFormat, GDT_Byte);
+        }
+        else
+        {
+            GDALDataset *datasets[1] = {inData};
+            if(singleBand)
+            {
+                RSGISColourUpImageBand colourUp(3, classColour, numClasses);
+                RSGISCalcImage calcImg(&colourUp, "", true);
+                calcImg.calcImage(datasets, 1, outputImage, false, NULL, imageFormat, GDT_Byte);
+            }
+            else
+            {
+                RSGISColourUpImage colourUp(3, classColour, numClasses);
+                RSGISCalcImage calcImg(&colourUp, "", true);
+                calcImg.calcImage(datasets, 1, outputImage, false, NULL, imageFormat, GDT_Byte);
+            }
+        }
+    }
+    
 	RSGISClassColourReader::RSGISClassColourReader()
 	{
 		
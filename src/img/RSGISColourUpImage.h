@@ -27,6 +27,8 @@
 #include <fstream>
 #include <string>
 #include "img/RSGISCalcImageValue.h"
+#include "img/RSGISCalcImage.h"
+#include "img/RSGISIntegerLUTImage.h"
 #include "img/RSGISImageCalcException.h"
 #include "img/RSGISParseColourException.h"
 #include "math/RSGISMathsUtils.h"
@@ -107,6 +109,20 @@ namespace rsgis{ namespace img{
         int numClasses;
     };
 	
+    /**
+     * Colour an image with the classes into a byte RGB image. Where the image
+     * is 8 or 16 bit integer and all the classes refer to a single band (or
+     * singleBand is given, as RSGISColourUpImageBand, using the first band)
+     * the colour of every value is found once and the image is coloured with
+     * a lookup table, otherwise each pixel is coloured with
+     * RSGISColourUpImage.
+     */
+    class DllExport RSGISColourUpImageLUT
+    {
+    public:
+        static void colourUpImage(GDALDataset *inData, std::string outputImage, std::string imageFormat, ClassColour **classColour, int numClasses, bool singleBand=false);
+    };
+	
 	class DllExport RSGISClassColourReader
 	{
 	public:
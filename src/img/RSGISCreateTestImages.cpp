@@ -95,6 +95,107 @@ namespace rsgis{namespace img{
 		GDALClose(outputImageDS);
 	}
 			
+	void RSGISCreateTestImages::createSyntheticImage(std::string outputImage, std::string format, int width, int height, int numBands, double tlX, double tlY, unsigned int seed)
+	{
+		if((width < 1) || (height < 1))
+		{
+			throw RSGISImageException("Width and height must be at least 1 pixel");
+		}
+		if(numBands < 1)
+		{
+			throw RSGISImageException("At least one band must be created");
+		}
+		GDALAllRegister();
+		GDALDriver *poDriver = GetGDALDriverManager()->GetDriverByName(format.c_str());
+		if(poDriver == NULL)
+		{
+			throw RSGISImageException("The " + format + " image driver is not available.");
+		}
+		GDALDataset *outputImageDS = poDriver->Create(outputImage.c_str(), width, height, numBands, GDT_Float32, NULL);
+		if(outputImageDS == NULL)
+		{
+			throw RSGISImageException("Image could not be created.");
+		}
+		double transform[6] = {tlX, 1.0, 0.0, tlY, 0.0, -1.0};
+		outputImageDS->SetGeoTransform(transform);
+		
+		std::mt19937 randGen(seed);
+		std::uniform_real_distribution<float> noise(-10.0, 10.0);
+		std::vector<float> imgData(width);
+		for(int n = 0; n < numBands; ++n)
+		{
+			GDALRasterBand *imgBand = outputImageDS->GetRasterBand(n+1);
+			double period = 50.0 * (n+1);
+			for(int i = 0; i < height; ++i)
+			{
+				double y = tlY - i;
+				for(int j = 0; j < width; ++j)
+				{
+					double x = tlX + j;
+					imgData[j] = 100.0 + (50.0 * sin(x / period) * cos(y / period)) + noise(randGen);
+				}
+				if(imgBand->RasterIO(GF_Write, 0, i, width, 1, imgData.data(), width, 1, GDT_Float32, 0, 0) != CE_None)
+				{
+					GDALClose(outputImageDS);
+					throw RSGISImageException("Could not write to the image.");
+				}
+			}
+		}
+		GDALClose(outputImageDS);
+	}
+	
+	void RSGISCreateTestImages::createPatchImage(std::string outputImage, std::string format, int width, int height, int patchSize, unsigned int numClasses, unsigned int seed)
+	{
+		if((width < 1) || (height < 1))
+		{
+			throw RSGISImageException("Width and height must be at least 1 pixel");
+		}
+		if(patchSize < 1)
+		{
+			throw RSGISImageException("The patch size must be at least 1 pixel");
+		}
+		GDALAllRegister();
+		GDALDriver *poDriver = GetGDALDriverManager()->GetDriverByName(format.c_str());
+		if(poDriver == NULL)
+		{
+			throw RSGISImageException("The " + format + " image driver is not available.");
+		}
+		GDALDataset *outputImageDS = poDriver->Create(outputImage.c_str(), width, height, 1, GDT_UInt32, NULL);
+		if(outputImageDS == NULL)
+		{
+			throw RSGISImageException("Image could not be created.");
+		}
+		double transform[6] = {0.0, 1.0, 0.0, (double)height, 0.0, -1.0};
+		outputImageDS->SetGeoTransform(transform);
+		
+		size_t patchesX = (width + patchSize - 1) / patchSize;
+		size_t patchesY = (height + patchSize - 1) / patchSize;
+		std::vector<uint32_t> patchLabels(patchesX * patchesY);
+		std::mt19937 randGen(seed);
+		std::uniform_int_distribution<uint32_t> classDist(1, (numClasses == 0)?1:numClasses);
+		for(size_t i = 0; i < patchLabels.size(); ++i)
+		{
+			patchLabels[i] = (numClasses == 0)?(i+1):classDist(randGen);
+		}
+		
+		GDALRasterBand *imgBand = outputImageDS->GetRasterBand(1);
+		std::vector<uint32_t> imgData(width);
+		for(int i = 0; i < height; ++i)
+		{
+			const uint32_t *rowLabels = patchLabels.data() + ((i / patchSize) * patchesX);
+			for(int j = 0; j < width; ++j)
+			{
+				imgData[j] = rowLabels[j / patchSize];
+			}
+			if(imgBand->RasterIO(GF_Write, 0, i, width, 1, imgData.data(), width, 1, GDT_UInt32, 0, 0) != CE_None)
+			{
+				GDALClose(outputImageDS);
+				throw RSGISImageException("Could not write to the image.");
+			}
+		}
+		GDALClose(outputImageDS);
+	}
+	
 	RSGISCreateTestImages::~RSGISCreateTestImages()
 	{
 		
@@ -25,6 +25,10 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <random>
+#include <math.h>
+#include <stdint.h>
 
 #include "common/RSGISImageException.h"
 
@@ -50,6 +54,20 @@ namespace rsgis{namespace img{
 		public:
 			RSGISCreateTestImages();
 			void createRowMajorNumberedImage(std::string outputImage, int width, int height);
+			/**
+			 * Create a Float32 image with numBands bands of a smooth trend
+			 * (a different sinusoid per band) plus uniform noise, for
+			 * benchmarking. The top left corner is at (tlX, tlY) with 1 m
+			 * pixels so tiles of a larger image can be created for mosaicking.
+			 */
+			void createSyntheticImage(std::string outputImage, std::string format, int width, int height, int numBands, double tlX, double tlY, unsigned int seed);
+			/**
+			 * Create a UInt32 single band image of square patches of
+			 * patchSize pixels. If numClasses is 0 each patch gets its own
+			 * label (1, 2, ... row major), i.e. a clumps image, otherwise
+			 * each patch is given a random class between 1 and numClasses.
+			 */
+			void createPatchImage(std::string outputImage, std::string format, int width, int height, int patchSize, unsigned int numClasses, unsigned int seed);
 			~RSGISCreateTestImages();
 		};
 }}
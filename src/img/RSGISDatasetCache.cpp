@@ -0,0 +1,308 @@
+/*
+ *  RSGISDatasetCache.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISDatasetCache.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <boost/filesystem.hpp>
+
+namespace rsgis{namespace img{
+
+    RSGISDatasetCache::CacheState::CacheState()
+    {
+        this->maxDatasets = 0;
+        this->useCounter = 0;
+        if(const char* env_p = std::getenv("RSGISLIB_DATASET_CACHE"))
+        {
+            int envMaxDatasets = atoi(env_p);
+            if(envMaxDatasets > 0)
+            {
+                this->maxDatasets = envMaxDatasets;
+            }
+        }
+    }
+
+    RSGISDatasetCache::CacheState::~CacheState()
+    {
+        for(std::map<std::string, CachedDataset>::iterator iterDS = this->datasets.begin(); iterDS != this->datasets.end(); ++iterDS)
+        {
+            GDALClose(iterDS->second.dataset);
+        }
+        this->datasets.clear();
+    }
+
+    RSGISDatasetCache::CacheState& RSGISDatasetCache::getState()
+    {
+        static CacheState state;
+        return state;
+    }
+
+    std::string RSGISDatasetCache::cacheKey(const std::string &filePath)
+    {
+        // Only local files are cached; anything else (e.g., /vsi paths) is
+        // opened directly.
+        boost::system::error_code ec;
+        boost::filesystem::path canonicalPath = boost::filesystem::canonical(boost::filesystem::path(filePath), ec);
+        if(ec || !boost::filesystem::is_regular_file(canonicalPath, ec))
+        {
+            return "";
+        }
+        return canonicalPath.string();
+    }
+
+    bool RSGISDatasetCache::FileStamp::operator==(const FileStamp &other) const
+    {
+        return (this->modSecs == other.modSecs) && (this->modNSecs == other.modNSecs) && (this->changeSecs == other.changeSecs) && (this->changeNSecs == other.changeNSecs) && (this->fileSize == other.fileSize) && (this->inode == other.inode);
+    }
+
+    bool RSGISDatasetCache::getFileStamp(const std::string &key, FileStamp *stamp)
+    {
+#ifdef _MSC_VER
+        // Only whole seconds are available.
+        struct _stat64 fileStat;
+        if(_stat64(key.c_str(), &fileStat) != 0)
+        {
+            return false;
+        }
+        stamp->modNSecs = 0;
+        stamp->changeNSecs = 0;
+#else
+        struct stat fileStat;
+        if(stat(key.c_str(), &fileStat) != 0)
+        {
+            return false;
+        }
+#ifdef __APPLE__
+        stamp->modNSecs = fileStat.st_mtimespec.tv_nsec;
+        stamp->changeNSecs = fileStat.st_ctimespec.tv_nsec;
+#else
+        stamp->modNSecs = fileStat.st_mtim.tv_nsec;
+        stamp->changeNSecs = fileStat.st_ctim.tv_nsec;
+#endif
+#endif
+        stamp->modSecs = fileStat.st_mtime;
+        stamp->changeSecs = fileStat.st_ctime;
+        stamp->fileSize = fileStat.st_size;
+        stamp->inode = fileStat.st_ino;
+        return true;
+    }
+
+    GDALDataset* RSGISDatasetCache::openDataset(std::string filePath, GDALAccess access)
+    {
+        CacheState &state = getState();
+        std::lock_guard<std::mutex> lock(state.cacheMutex);
+        if(state.maxDatasets == 0)
+        {
+            return (GDALDataset *) GDALOpen(filePath.c_str(), access);
+        }
+        std::string key = cacheKey(filePath);
+        if(key == "")
+        {
+            return (GDALDataset *) GDALOpen(filePath.c_str(), access);
+        }
+
+        std::map<std::string, CachedDataset>::iterator iterDS = state.datasets.find(key);
+        if(access == GA_Update)
+        {
+            // The file is about to change, so a cached handle would be stale.
+            if(iterDS != state.datasets.end())
+            {
+                if(iterDS->second.refCount == 0)
+                {
+                    GDALClose(iterDS->second.dataset);
+                    state.datasets.erase(iterDS);
+                }
+                else
+                {
+                    iterDS->second.invalid = true;
+                }
+            }
+            return (GDALDataset *) GDALOpen(filePath.c_str(), access);
+        }
+
+        FileStamp stamp;
+        bool haveFileStamp = getFileStamp(key, &stamp);
+        if(iterDS != state.datasets.end())
+        {
+            CachedDataset &cached = iterDS->second;
+            if(cached.refCount > 0)
+            {
+                // GDAL handles must not be shared so a second user gets its own.
+                return (GDALDataset *) GDALOpen(filePath.c_str(), access);
+            }
+            if(cached.invalid || !haveFileStamp || !(cached.stamp == stamp))
+            {
+                GDALClose(cached.dataset);
+                state.datasets.erase(iterDS);
+            }
+            else
+            {
+                cached.refCount = 1;
+                cached.lastUsed = ++state.useCounter;
+                return cached.dataset;
+            }
+        }
+
+        GDALDataset *dataset = (GDALDataset *) GDALOpen(filePath.c_str(), access);
+        if((dataset == NULL) || !haveFileStamp)
+        {
+            return dataset;
+        }
+        CachedDataset cached;
+        cached.dataset = dataset;
+        cached.refCount = 1;
+        cached.stamp = stamp;
+        cached.lastUsed = ++state.useCounter;
+        cached.invalid = false;
+        state.datasets[key] = cached;
+        evictIdle(state, state.maxDatasets);
+        return dataset;
+    }
+
+    void RSGISDatasetCache::closeDataset(GDALDataset *dataset)
+    {
+        if(dataset == NULL)
+        {
+            return;
+        }
+        CacheState &state = getState();
+        std::lock_guard<std::mutex> lock(state.cacheMutex);
+        for(std::map<std::string, CachedDataset>::iterator iterDS = state.datasets.begin(); iterDS != state.datasets.end(); ++iterDS)
+        {
+            CachedDataset &cached = iterDS->second;
+            if(cached.dataset != dataset)
+            {
+                continue;
+            }
+            if(cached.refCount == 0)
+            {
+                // Already released.
+                return;
+            }
+            --cached.refCount;
+            if(cached.invalid || (state.maxDatasets == 0))
+            {
+                GDALClose(cached.dataset);
+                state.datasets.erase(iterDS);
+                return;
+            }
+            evictIdle(state, state.maxDatasets);
+            return;
+        }
+        GDALClose(dataset);
+    }
+
+    void RSGISDatasetCache::setMaxDatasets(unsigned int maxDatasets)
+    {
+        CacheState &state = getState();
+        std::lock_guard<std::mutex> lock(state.cacheMutex);
+        state.maxDatasets = maxDatasets;
+        evictIdle(state, maxDatasets);
+    }
+
+    unsigned int RSGISDatasetCache::getMaxDatasets()
+    {
+        CacheState &state = getState();
+        std::lock_guard<std::mutex> lock(state.cacheMutex);
+        return state.maxDatasets;
+    }
+
+    void RSGISDatasetCache::invalidate(std::string filePath)
+    {
+        CacheState &state = getState();
+        std::lock_guard<std::mutex> lock(state.cacheMutex);
+        if(state.datasets.empty())
+        {
+            return;
+        }
+        std::string key = cacheKey(filePath);
+        std::map<std::string, CachedDataset>::iterator iterDS = state.datasets.find(key);
+        if(iterDS == state.datasets.end())
+        {
+            return;
+        }
+        if(iterDS->second.refCount == 0)
+        {
+            GDALClose(iterDS->second.dataset);
+            state.datasets.erase(iterDS);
+        }
+        else
+        {
+            iterDS->second.invalid = true;
+        }
+    }
+
+    void RSGISDatasetCache::invalidateAll()
+    {
+        CacheState &state = getState();
+        std::lock_guard<std::mutex> lock(state.cacheMutex);
+        for(std::map<std::string, CachedDataset>::iterator iterDS = state.datasets.begin(); iterDS != state.datasets.end(); )
+        {
+            if(iterDS->second.refCount == 0)
+            {
+                GDALClose(iterDS->second.dataset);
+                iterDS = state.datasets.erase(iterDS);
+            }
+            else
+            {
+                iterDS->second.invalid = true;
+                ++iterDS;
+            }
+        }
+    }
+
+    size_t RSGISDatasetCache::getNumCached()
+    {
+        CacheState &state = getState();
+        std::lock_guard<std::mutex> lock(state.cacheMutex);
+        return state.datasets.size();
+    }
+
+    void RSGISDatasetCache::evictIdle(CacheState &state, size_t maxIdle)
+    {
+        // Close the least recently used idle datasets until at most maxIdle remain.
+        while(true)
+        {
+            size_t numIdle = 0;
+            std::map<std::string, CachedDataset>::iterator oldestDS = state.datasets.end();
+            for(std::map<std::string, CachedDataset>::iterator iterDS = state.datasets.begin(); iterDS != state.datasets.end(); ++iterDS)
+            {
+                if(iterDS->second.refCount == 0)
+                {
+                    ++numIdle;
+                    if((oldestDS == state.datasets.end()) || (iterDS->second.lastUsed < oldestDS->second.lastUsed))
+                    {
+                        oldestDS = iterDS;
+                    }
+                }
+            }
+            if(numIdle <= maxIdle)
+            {
+                return;
+            }
+            GDALClose(oldestDS->second.dataset);
+            state.datasets.erase(oldestDS);
+        }
+    }
+
+}}
@@ -0,0 +1,136 @@
+/*
+ *  RSGISDatasetCache.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISDatasetCache_H
+#define RSGISDatasetCache_H
+
+#include <iostream>
+#include <string>
+#include <map>
+#include <mutex>
+#include <cstdlib>
+#include <stdint.h>
+
+#include "gdal_priv.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_img_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace img{
+
+    /**
+     * A process wide cache of open GDAL datasets so that a sequence of
+     * commands on the same file (e.g., a series of rastergis functions on a
+     * KEA clumps image) re-use one handle, with its parsed metadata and RAT,
+     * rather than re-opening the file each time.
+     *
+     * The cache is off (openDataset is GDALOpen and closeDataset GDALClose)
+     * unless setMaxDatasets is given a value > 0 or the
+     * RSGISLIB_DATASET_CACHE environment variable is set to the maximum
+     * number of idle datasets to hold.
+     *
+     * Only read only handles are cached: an open for update closes any idle
+     * cached handle of the file and returns a handle of its own, so nothing
+     * written through the cache can be left unflushed or written back over a
+     * newer file. A cached handle is only given to one user at a time; a
+     * second open of a file already in use gets its own, uncached, handle.
+     *
+     * A cached handle is re-opened if the file has changed since it was
+     * opened: its modification time (to the nanosecond where the file system
+     * records it), status change time, size or inode differ. Files being
+     * (re)created by RSGISImageUtils, RSGISCalcImage and the other img
+     * writers are also invalidated before they are created, as some formats
+     * (e.g., KEA/HDF5) can not re-create a file which is still open.
+     */
+    class DllExport RSGISDatasetCache
+    {
+    public:
+        /**
+         * Open (or re-use) a dataset, returns NULL if it can not be opened.
+         * Every dataset returned must be given back with closeDataset.
+         */
+        static GDALDataset* openDataset(std::string filePath, GDALAccess access);
+        /**
+         * Release a dataset from openDataset; datasets which are not in the
+         * cache are closed.
+         */
+        static void closeDataset(GDALDataset *dataset);
+        /**
+         * The maximum number of idle datasets to keep open, 0 disables the
+         * cache and closes any idle datasets.
+         */
+        static void setMaxDatasets(unsigned int maxDatasets);
+        static unsigned int getMaxDatasets();
+        /**
+         * Close the cached handle of a file, or mark it to be closed when
+         * released if it is in use.
+         */
+        static void invalidate(std::string filePath);
+        static void invalidateAll();
+        static size_t getNumCached();
+    protected:
+        /** The state of a file a cached handle is checked against */
+        struct FileStamp
+        {
+            int64_t modSecs;
+            int64_t modNSecs;
+            int64_t changeSecs;
+            int64_t changeNSecs;
+            uint64_t fileSize;
+            uint64_t inode;
+            bool operator==(const FileStamp &other) const;
+        };
+        struct CachedDataset
+        {
+            GDALDataset *dataset;
+            unsigned int refCount;
+            FileStamp stamp;
+            uint64_t lastUsed;
+            bool invalid;
+        };
+        struct CacheState
+        {
+            CacheState();
+            ~CacheState();
+            std::mutex cacheMutex;
+            std::map<std::string, CachedDataset> datasets;
+            unsigned int maxDatasets;
+            uint64_t useCounter;
+        };
+        static CacheState& getState();
+        static std::string cacheKey(const std::string &filePath);
+        static bool getFileStamp(const std::string &key, FileStamp *stamp);
+        static void evictIdle(CacheState &state, size_t maxIdle);
+    };
+
+}}
+
+#endif
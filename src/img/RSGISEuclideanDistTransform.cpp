@@ -0,0 +1,205 @@
+/*
+ *  RSGISEuclideanDistTransform.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISEuclideanDistTransform.h"
+
+namespace rsgis{namespace img{
+
+    RSGISEuclideanDistTransform::RSGISEuclideanDistTransform()
+    {
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+
+    void RSGISEuclideanDistTransform::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+
+    void RSGISEuclideanDistTransform::calcDistance(GDALDataset *inDataset, unsigned int band, float calcVal, GDALDataset *outDataset, double xRes, double yRes)
+    {
+        if((band == 0) || (((int)band) > inDataset->GetRasterCount()))
+        {
+            throw RSGISImageCalcException("The band specified is not within the image. Band numbering starts at 1.");
+        }
+        unsigned int width = inDataset->GetRasterXSize();
+        unsigned int height = inDataset->GetRasterYSize();
+        if((outDataset->GetRasterXSize() != ((int)width)) || (outDataset->GetRasterYSize() != ((int)height)))
+        {
+            throw RSGISImageCalcException("The input and output images are not the same size.");
+        }
+        GDALRasterBand *inBand = inDataset->GetRasterBand(band);
+        GDALRasterBand *outBand = outDataset->GetRasterBand(1);
+
+        int xBlockSize = 0;
+        int yBlockSize = 0;
+        inBand->GetBlockSize(&xBlockSize, &yBlockSize);
+        unsigned int stripHeight = std::min<unsigned int>(std::max(yBlockSize, 256), height);
+        unsigned int numStrips = (height + stripHeight - 1) / stripHeight;
+
+        const float inf = std::numeric_limits<float>::infinity();
+        std::vector<float> stripData(((size_t)width) * stripHeight);
+        std::vector<float> runDists(width, inf);
+
+        rsgis_tqdm pbar;
+        unsigned int nStripsDone = 0;
+
+        // Top to bottom: the distance (in rows) to the nearest seed above or at each pixel.
+        for(unsigned int s = 0; s < numStrips; ++s)
+        {
+            unsigned int yOff = s * stripHeight;
+            unsigned int nRows = std::min(stripHeight, height - yOff);
+            if(inBand->RasterIO(GF_Read, 0, yOff, width, nRows, stripData.data(), width, nRows, GDT_Float32, 0, 0, NULL) != CE_None)
+            {
+                throw RSGISImageCalcException("Could not read the input image.");
+            }
+            for(unsigned int r = 0; r < nRows; ++r)
+            {
+                float *rowData = &stripData[((size_t)r) * width];
+                for(unsigned int x = 0; x < width; ++x)
+                {
+                    runDists[x] = (rowData[x] == calcVal)?(runDists[x] + 1):0;
+                    rowData[x] = runDists[x];
+                }
+            }
+            if(outBand->RasterIO(GF_Write, 0, yOff, width, nRows, stripData.data(), width, nRows, GDT_Float32, 0, 0, NULL) != CE_None)
+            {
+                throw RSGISImageCalcException("Could not write to the output image.");
+            }
+            pbar.progress(++nStripsDone, numStrips * 2);
+        }
+
+        // Bottom to top: the minimum with the distance to the nearest seed below
+        // gives the column distances of the strip, from which the rows are calculated.
+        std::vector<float> outData(((size_t)width) * stripHeight);
+        runDists.assign(width, inf);
+        rsgis::utils::RSGISWorkerPool pool(std::max<unsigned int>(std::min(this->numThreads, stripHeight), 1));
+        std::vector<std::vector<unsigned int> > vBufs(pool.getNumThreads(), std::vector<unsigned int>(width));
+        std::vector<std::vector<double> > zBufs(pool.getNumThreads(), std::vector<double>(width + 1));
+        for(unsigned int s = numStrips; s > 0; --s)
+        {
+            unsigned int yOff = (s - 1) * stripHeight;
+            unsigned int nRows = std::min(stripHeight, height - yOff);
+            if(outBand->RasterIO(GF_Read, 0, yOff, width, nRows, stripData.data(), width, nRows, GDT_Float32, 0, 0, NULL) != CE_None)
+            {
+                throw RSGISImageCalcException("Could not read the column distances from the output image.");
+            }
+            for(unsigned int r = nRows; r > 0; --r)
+            {
+                float *rowData = &stripData[((size_t)(r - 1)) * width];
+                for(unsigned int x = 0; x < width; ++x)
+                {
+                    runDists[x] = (rowData[x] == 0)?0:(runDists[x] + 1);
+                    rowData[x] = std::min(rowData[x], runDists[x]);
+                }
+            }
+
+            pool.parallelFor(nRows, [&](size_t r, unsigned int t)
+            {
+                size_t rowOff = ((size_t)r) * width;
+                RSGISEuclideanDistTransform::calcRowDistances(&stripData[rowOff], width, xRes, yRes, &outData[rowOff], vBufs[t], zBufs[t]);
+            });
+
+            if(outBand->RasterIO(GF_Write, 0, yOff, width, nRows, outData.data(), width, nRows, GDT_Float32, 0, 0, NULL) != CE_None)
+            {
+                throw RSGISImageCalcException("Could not write to the output image.");
+            }
+            pbar.progress(++nStripsDone, numStrips * 2);
+        }
+        pbar.finish();
+    }
+
+    void RSGISEuclideanDistTransform::calcRowDistances(const float *colDists, unsigned int width, double xRes, double yRes, float *outDists, std::vector<unsigned int> &vBuf, std::vector<double> &zBuf)
+    {
+        // Each column with a seed is a parabola (x - xq)^2 + (g(q) * yRes)^2; vBuf
+        // holds the columns of the parabolas making up the lower envelope and zBuf
+        // the x positions from which each of them is the lowest.
+        const double inf = std::numeric_limits<double>::infinity();
+        long k = -1;
+        for(unsigned int q = 0; q < width; ++q)
+        {
+            if(std::isinf(colDists[q]))
+            {
+                continue;
+            }
+            double xq = q * xRes;
+            double fq = (colDists[q] * yRes) * (colDists[q] * yRes);
+            if(k < 0)
+            {
+                k = 0;
+                vBuf[0] = q;
+                zBuf[0] = -inf;
+                zBuf[1] = inf;
+                continue;
+            }
+            double s = 0;
+            while(true)
+            {
+                unsigned int v = vBuf[k];
+                double xv = v * xRes;
+                double fv = (colDists[v] * yRes) * (colDists[v] * yRes);
+                s = ((fq + (xq * xq)) - (fv + (xv * xv))) / (2 * (xq - xv));
+                if((s <= zBuf[k]) && (k > 0))
+                {
+                    --k;
+                }
+                else
+                {
+                    break;
+                }
+            }
+            ++k;
+            vBuf[k] = q;
+            zBuf[k] = s;
+            zBuf[k+1] = inf;
+        }
+
+        if(k < 0)
+        {
+            for(unsigned int q = 0; q < width; ++q)
+            {
+                outDists[q] = -1;
+            }
+            return;
+        }
+
+        k = 0;
+        for(unsigned int q = 0; q < width; ++q)
+        {
+            double xq = q * xRes;
+            while(zBuf[k+1] < xq)
+            {
+                ++k;
+            }
+            unsigned int v = vBuf[k];
+            double dx = xq - (v * xRes);
+            double dy = colDists[v] * yRes;
+            outDists[q] = sqrt((dx * dx) + (dy * dy));
+        }
+    }
+
+    RSGISEuclideanDistTransform::~RSGISEuclideanDistTransform()
+    {
+
+    }
+
+}}
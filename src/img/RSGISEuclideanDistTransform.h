@@ -0,0 +1,108 @@
+/*
+ *  RSGISEuclideanDistTransform.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISEuclideanDistTransform_H
+#define RSGISEuclideanDistTransform_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "gdal_priv.h"
+
+#include "common/rsgis-tqdm.h"
+#include "common/RSGISParallel.h"
+
+#include "img/RSGISImageCalcException.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_img_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace img{
+
+    /**
+     * An exact Euclidean distance transform (Felzenszwalb and Huttenlocher,
+     * 2012), which is separable so costs O(1) per pixel whatever the
+     * distances.
+     *
+     * The image is read as strips of rows in two passes with only a row of
+     * running distances held between strips. The first pass (top to bottom)
+     * writes the distance in rows to the nearest seed above each pixel to
+     * the output. The second pass (bottom to top) reads those back, takes the
+     * minimum with the distance to the nearest seed below, which makes the
+     * column distances final, and then finds the distances along each row
+     * as the lower envelope of the parabolas of the column distances. The
+     * rows of a strip are shared among threads (setNumThreads or the
+     * RSGISLIB_NUM_THREADS environment variable).
+     */
+    class DllExport RSGISEuclideanDistTransform
+    {
+    public:
+        RSGISEuclideanDistTransform();
+        /**
+         * The number of threads (0 uses the number of cores).
+         */
+        void setNumThreads(unsigned int numThreads);
+        /**
+         * Calculate, for the pixels of the band (numbered from 1) equal to
+         * calcVal, the distance between the pixel centre and the centre of
+         * the nearest pixel with any other value (the seeds), which are 0.
+         * Distances are in the units of the pixel size (xRes, yRes) and -1
+         * where the image has no seeds. The output is the first band of
+         * outDataset, which must be the same size as the input and is also
+         * used to hold the column distances between the passes, so should
+         * be Float32 (or Float64).
+         */
+        void calcDistance(GDALDataset *inDataset, unsigned int band, float calcVal, GDALDataset *outDataset, double xRes=1, double yRes=1);
+        /**
+         * The distance along a row given the column distances (in rows,
+         * infinite if there is no seed in the column) of each pixel. The
+         * output is -1 if there are no seeds in any of the columns. The
+         * vectors are working space of at least width (+ 1 for zBuf).
+         */
+        static void calcRowDistances(const float *colDists, unsigned int width, double xRes, double yRes, float *outDists, std::vector<unsigned int> &vBuf, std::vector<double> &zBuf);
+        ~RSGISEuclideanDistTransform();
+    protected:
+        unsigned int numThreads;
+    };
+
+}}
+
+#endif
@@ -42,11 +42,14 @@ namespace rsgis{namespace img{
             }
             unsigned int numImageBands = image->GetRasterCount();
             
+            // The pixel values are written to the file (in blocks) as they are read.
+            rsgis::utils::RSGISExportColumnData2HDF exportCols2HDF;
+            H5::DataType h5DataType = exportCols2HDF.getH5DataType(dataType);
+            exportCols2HDF.createFile(outHDFFile, numImageBands, std::string("Pixels Extracted from ")+std::string(image->GetFileList()[0]), h5DataType);
+            rsgis::utils::RSGISExportColumnData2HDFProducer dataProducer(&exportCols2HDF, H5::PredType::NATIVE_FLOAT);
             
-            std::vector<float*> *pxlVals = new std::vector<float*>();
-            
-            RSGISExtractImageValuesWithMask *extractData = new RSGISExtractImageValuesWithMask(pxlVals, maskValue);
-            RSGISCalcImage calcImg = RSGISCalcImage(extractData, "", true);
+            RSGISExtractImageValuesWithMask extractData = RSGISExtractImageValuesWithMask(&dataProducer, maskValue);
+            RSGISCalcImage calcImg = RSGISCalcImage(&extractData, "", true);
             
             GDALDataset **datasets = new GDALDataset*[2];
 			datasets[0] = mask;
@@ -56,26 +59,8 @@ namespace rsgis{namespace img{
             
             delete[] datasets;
             
-            rsgis::utils::RSGISExportColumnData2HDF exportCols2HDF;
-            H5::DataType h5DataType = exportCols2HDF.getH5DataType(dataType);
-            exportCols2HDF.createFile(outHDFFile, numImageBands, std::string("Pixels Extracted from ")+std::string(image->GetFileList()[0]), h5DataType);
-            float *row = new float[numImageBands];
-            for(unsigned int j = 0; j < pxlVals->size(); ++j)
-            {
-                for(unsigned int i = 0; i < numImageBands; ++i)
-                {
-                    row[i] = pxlVals->at(j)[i];
-                }
-                exportCols2HDF.addDataRow(row, H5::PredType::NATIVE_FLOAT);
-            }
+            dataProducer.flush();
             exportCols2HDF.close();
-            delete[] row;
-            
-            for(std::vector<float*>::iterator iterVals = pxlVals->begin(); iterVals != pxlVals->end(); ++iterVals)
-            {
-                delete[] *iterVals;
-            }
-            delete pxlVals;
         }
         catch (RSGISImageException &e)
         {
@@ -140,10 +125,15 @@ namespace rsgis{namespace img{
                 cImgBandCount += datasets[i+1]->GetRasterCount();
             }
             
-            std::vector<float*> *pxlVals = new std::vector<float*>();
             unsigned int numOutImgBands = imgBands.size();
             
-            RSGISExtractImageBandValuesWithMask extractData = RSGISExtractImageBandValuesWithMask(pxlVals, imgBands, maskValue);
+            // The pixel values are written to the file (in blocks) as they are read.
+            rsgis::utils::RSGISExportColumnData2HDF exportCols2HDF;
+            H5::DataType h5DataType = exportCols2HDF.getH5DataType(dataType);
+            exportCols2HDF.createFile(outHDFFile, numOutImgBands, std::string("Pixels Extracted"), h5DataType);
+            rsgis::utils::RSGISExportColumnData2HDFProducer dataProducer(&exportCols2HDF, H5::PredType::NATIVE_FLOAT);
+            
+            RSGISExtractImageBandValuesWithMask extractData = RSGISExtractImageBandValuesWithMask(&dataProducer, imgBands, maskValue);
             RSGISCalcImage calcImg = RSGISCalcImage(&extractData, "", true);
             calcImg.calcImage(datasets, imageFiles.size()+1);
             
@@ -154,26 +144,8 @@ namespace rsgis{namespace img{
             }
             delete[] datasets;
             
-            rsgis::utils::RSGISExportColumnData2HDF exportCols2HDF;
-            H5::DataType h5DataType = exportCols2HDF.getH5DataType(dataType);
-            exportCols2HDF.createFile(outHDFFile, numOutImgBands, std::string("Pixels Extracted"), h5DataType);
-            float *row = new float[numOutImgBands];
-            for(unsigned int j = 0; j < pxlVals->size(); ++j)
-            {
-                for(unsigned int i = 0; i < numOutImgBands; ++i)
-                {
-                    row[i] = pxlVals->at(j)[i];
-                }
-                exportCols2HDF.addDataRow(row, H5::PredType::NATIVE_FLOAT);
-            }
+            dataProducer.flush();
             exportCols2HDF.close();
-            delete[] row;
-            
-            for(std::vector<float*>::iterator iterVals = pxlVals->begin(); iterVals != pxlVals->end(); ++iterVals)
-            {
-                delete[] *iterVals;
-            }
-            delete pxlVals;
             
         }
         catch (RSGISImageException &e)
@@ -190,92 +162,69 @@ namespace rsgis{namespace img{
         }
     }
     
-    void RSGISExtractImageValues::sampleExtractedHDFData(std::string inputH5, std::string outputH5, unsigned int nSamples, int seed, RSGISLibDataType dataType)
+    void RSGISExtractImageValues::extractImgBandDataAtPoints2HDF(std::vector<std::pair<std::string, std::vector<unsigned int> > > imageFiles, OGRLayer *ptsLayer, std::string outHDFFile, RSGISLibDataType dataType)
     {
         try
         {
-            rsgis::utils::RSGISReadHDFColumnData readHDFCol;
-            readHDFCol.openFile(inputH5);
-            unsigned int nRows = readHDFCol.getNumRows();
-            unsigned int nCols = readHDFCol.getNumCols();
-
-            if(nRows > nSamples)
+            GDALAllRegister();
+            if(imageFiles.size() == 0)
             {
-                unsigned int blockSize = 1000;
-                unsigned int nFullBlocks = (int)floor(((double)nRows)/((double)blockSize));
-                unsigned int remain = nRows - (blockSize*nFullBlocks);
-                float *dataBlock = new float[nRows*nCols];
-
-                float propSamples = ((float)nSamples) / ((float)nRows);
-
-                unsigned int samplesPerBlock = (unsigned int)(ceil(((float)blockSize) * propSamples));
-                unsigned int samples4Remain = (unsigned int)(ceil(((float)remain) * propSamples));
-                //unsigned int totalSamples = (samplesPerBlock * nFullBlocks) + samples4Remain;
-
-                rsgis::utils::RSGISExportColumnData2HDF exportCols2HDF;
-                H5::DataType h5DataType = exportCols2HDF.getH5DataType(dataType);
-                exportCols2HDF.createFile(outputH5, nCols, std::string("Sampled Pixels Extracted"), h5DataType);
-                float *row = new float[nCols];
-
-                boost::mt19937 randomGen;
-                randomGen.seed(seed);
-                boost::uniform_int<> randomDist(0, blockSize);
-                boost::variate_generator<boost::mt19937&, boost::uniform_int<> > randomVal(randomGen, randomDist);
-
-                unsigned int ranIdx = 0;
-                unsigned int nRowsOff = 0;
-                for(unsigned int i = 0; i < nFullBlocks; ++i)
-                {
-                    readHDFCol.getDataRows(dataBlock, nCols, blockSize, H5::PredType::NATIVE_FLOAT, nRowsOff, blockSize);
-
-                    for(unsigned int j = 0; j < samplesPerBlock; ++j)
-                    {
-                        ranIdx = randomVal();
-                        for(unsigned int n = 0; n < nCols; ++n)
-                        {
-                            row[n] = dataBlock[(ranIdx*nCols)+n];
-                        }
-                        exportCols2HDF.addDataRow(row, H5::PredType::NATIVE_FLOAT);
-                    }
-                    nRowsOff += blockSize;
-                }
-                if(remain > 0)
-                {
-                    boost::uniform_int<> randomDist(0, remain);
-                    boost::variate_generator<boost::mt19937&, boost::uniform_int<> > randomVal(randomGen, randomDist);
-
-                    readHDFCol.getDataRows(dataBlock, nCols, blockSize, H5::PredType::NATIVE_FLOAT, nRowsOff, remain);
-                    for(unsigned int j = 0; j < samples4Remain; ++j)
-                    {
-                        ranIdx = randomVal();
-                        for(unsigned int n = 0; n < nCols; ++n)
-                        {
-                            row[n] = dataBlock[(ranIdx*nCols)+n];
-                        }
-                        exportCols2HDF.addDataRow(row, H5::PredType::NATIVE_FLOAT);
-                    }
-                }
-                exportCols2HDF.close();
-                delete[] row;
-                delete[] dataBlock;
+                throw RSGISImageException("There were no images provided.");
             }
-            else
+            
+            std::vector<double> xCoords;
+            std::vector<double> yCoords;
+            RSGISImagePointSampler::readLayerPoints(ptsLayer, &xCoords, &yCoords, NULL);
+            
+            unsigned int numOutImgBands = 0;
+            for(unsigned int i = 0; i < imageFiles.size(); ++i)
             {
-                throw RSGISException("There are not enough rows to create that sample.");
+                numOutImgBands += imageFiles.at(i).second.size();
             }
-            readHDFCol.close();
+            
+            std::vector<float> pxlVals;
+            std::vector<unsigned char> validPts;
+            RSGISImagePointSampler ptSampler;
+            ptSampler.samplePoints(imageFiles, xCoords, yCoords, &pxlVals, &validPts);
+            
+            rsgis::utils::RSGISExportColumnData2HDF exportCols2HDF;
+            H5::DataType h5DataType = exportCols2HDF.getH5DataType(dataType);
+            exportCols2HDF.createFile(outHDFFile, numOutImgBands, std::string("Pixels Extracted"), h5DataType);
+            for(size_t j = 0; j < validPts.size(); ++j)
+            {
+                // Points outside any of the images are not exported.
+                if(validPts.at(j) != 0)
+                {
+                    exportCols2HDF.addDataRow(&pxlVals[j * numOutImgBands], H5::PredType::NATIVE_FLOAT);
+                }
+            }
+            exportCols2HDF.close();
         }
-        catch (RSGISException &e)
+        catch (RSGISImageException &e)
         {
             throw e;
         }
+        catch (RSGISException &e)
+        {
+            throw RSGISImageException(e.what());
+        }
         catch (std::exception &e)
         {
-            throw RSGISException(e.what());
+            throw RSGISImageException(e.what());
         }
     }
+    
+    void RSGISExtractImageValues::sampleExtractedHDFData(std::string inputH5, std::string outputH5, unsigned int nSamples, int seed, RSGISLibDataType dataType)
+    {
+        this->sampleHDFRows(inputH5, outputH5, "", false, nSamples, seed, dataType);
+    }
 
     void RSGISExtractImageValues::splitExtractedHDFData(std::string inputH5, std::string outputP1H5, std::string outputP2H5, unsigned int nSamples, int seed, RSGISLibDataType dataType)
+    {
+        this->sampleHDFRows(inputH5, outputP1H5, outputP2H5, true, nSamples, seed, dataType);
+    }
+
+    void RSGISExtractImageValues::sampleHDFRows(std::string inputH5, std::string outputSampleH5, std::string outputRemainH5, bool outputRemain, unsigned int nSamples, int seed, RSGISLibDataType dataType)
     {
         try
         {
@@ -286,116 +235,68 @@ namespace rsgis{namespace img{
 
             if(nRows > nSamples)
             {
-                unsigned int blockSize = 1000;
-                unsigned int nFullBlocks = (int)floor(((double)nRows)/((double)blockSize));
-                unsigned int remain = nRows - (blockSize*nFullBlocks);
-                float *dataBlock = new float[nRows*nCols];
-
-                float propSamples = ((float)nSamples) / ((float)nRows);
-
-                unsigned int samplesPerBlock = (unsigned int)(ceil(((float)blockSize) * propSamples));
-                unsigned int samples4Remain = (unsigned int)(ceil(((float)remain) * propSamples));
-                //unsigned int totalSamples = (samplesPerBlock * nFullBlocks) + samples4Remain;
-
-                rsgis::utils::RSGISExportColumnData2HDF exportCols2HDF_P1;
-                H5::DataType h5DataType = exportCols2HDF_P1.getH5DataType(dataType);
-                exportCols2HDF_P1.createFile(outputP1H5, nCols, std::string("Sampled Pixels Extracted"), h5DataType);
-                rsgis::utils::RSGISExportColumnData2HDF exportCols2HDF_P2;
-                exportCols2HDF_P2.createFile(outputP2H5, nCols, std::string("Sampled Pixels Extracted"), h5DataType);
-                float *row = new float[nCols];
-                unsigned int *ranIdxes = new unsigned int[samplesPerBlock];
+                // Read blocks of whole chunks (at least 1000 rows).
+                unsigned int chunkRows = readHDFCol.getChunkRows();
+                unsigned int blockSize = chunkRows * ((1000 + chunkRows - 1) / chunkRows);
+                std::vector<float> dataBlock(((size_t)blockSize)*nCols);
+                std::vector<unsigned char> selected(blockSize);
+
+                rsgis::utils::RSGISExportColumnData2HDF exportSample2HDF;
+                H5::DataType h5DataType = exportSample2HDF.getH5DataType(dataType);
+                exportSample2HDF.createFile(outputSampleH5, nCols, std::string("Sampled Pixels Extracted"), h5DataType);
+                rsgis::utils::RSGISExportColumnData2HDF exportRemain2HDF;
+                if(outputRemain)
+                {
+                    exportRemain2HDF.createFile(outputRemainH5, nCols, std::string("Sampled Pixels Extracted"), h5DataType);
+                }
 
+                // Selection sampling (Knuth's algorithm S): each row is selected with
+                // probability (samples still needed / rows remaining), giving exactly
+                // nSamples distinct rows in file order without holding any indexes.
                 boost::mt19937 randomGen;
                 randomGen.seed(seed);
-                boost::uniform_int<> randomDist(0, blockSize);
-                boost::variate_generator<boost::mt19937&, boost::uniform_int<> > randomVal(randomGen, randomDist);
+                boost::uniform_01<boost::mt19937&> randomVal(randomGen);
 
-                bool found = false;
-                unsigned int ranIdx = 0;
-                unsigned int nRowsOff = 0;
-                for(unsigned int i = 0; i < nFullBlocks; ++i)
+                unsigned int nSelected = 0;
+                for(unsigned int nRowsOff = 0; nRowsOff < nRows; nRowsOff += blockSize)
                 {
-                    readHDFCol.getDataRows(dataBlock, nCols, blockSize, H5::PredType::NATIVE_FLOAT, nRowsOff, blockSize);
-
-                    for(unsigned int j = 0; j < samplesPerBlock; ++j)
-                    {
-                        ranIdx = randomVal();
-                        for(unsigned int n = 0; n < nCols; ++n)
-                        {
-                            row[n] = dataBlock[(ranIdx*nCols)+n];
-                        }
-                        exportCols2HDF_P1.addDataRow(row, H5::PredType::NATIVE_FLOAT);
-                        ranIdxes[j] = ranIdx;
-                    }
-
-                    for(unsigned int j = 0; j < blockSize; ++j)
+                    unsigned int nBlockRows = std::min(blockSize, nRows - nRowsOff);
+                    unsigned int nBlockSelected = 0;
+                    for(unsigned int j = 0; j < nBlockRows; ++j)
                     {
-                        found = false;
-                        for(unsigned int k = 0; k < samplesPerBlock; ++k)
-                        {
-                            if(ranIdxes[k] == j)
-                            {
-                                found = true;
-                                break;
-                            }
-                        }
-
-                        if(!found)
+                        selected[j] = 0;
+                        if((nSelected < nSamples) && ((randomVal() * (nRows - (nRowsOff + j))) < (nSamples - nSelected)))
                         {
-                            for(unsigned int n = 0; n < nCols; ++n)
-                            {
-                                row[n] = dataBlock[(j*nCols)+n];
-                            }
-                            exportCols2HDF_P2.addDataRow(row, H5::PredType::NATIVE_FLOAT);
+                            selected[j] = 1;
+                            ++nSelected;
+                            ++nBlockSelected;
                         }
                     }
 
-                    nRowsOff += blockSize;
-                }
-                if(remain > 0)
-                {
-                    boost::uniform_int<> randomDist(0, remain);
-                    boost::variate_generator<boost::mt19937&, boost::uniform_int<> > randomVal(randomGen, randomDist);
-
-                    readHDFCol.getDataRows(dataBlock, nCols, blockSize, H5::PredType::NATIVE_FLOAT, nRowsOff, remain);
-                    for(unsigned int j = 0; j < samples4Remain; ++j)
+                    // Only the blocks which contribute rows are read.
+                    if((nBlockSelected == 0) && !outputRemain)
                     {
-                        ranIdx = randomVal();
-                        for(unsigned int n = 0; n < nCols; ++n)
-                        {
-                            row[n] = dataBlock[(ranIdx*nCols)+n];
-                        }
-                        exportCols2HDF_P1.addDataRow(row, H5::PredType::NATIVE_FLOAT);
-                        ranIdxes[j] = ranIdx;
+                        continue;
                     }
+                    readHDFCol.getDataRows(dataBlock.data(), nCols, blockSize, H5::PredType::NATIVE_FLOAT, nRowsOff, nBlockRows);
 
-                    for(unsigned int j = 0; j < remain; ++j)
+                    for(unsigned int j = 0; j < nBlockRows; ++j)
                     {
-                        found = false;
-                        for(unsigned int k = 0; k < samples4Remain; ++k)
+                        if(selected[j] != 0)
                         {
-                            if(ranIdxes[k] == j)
-                            {
-                                found = true;
-                                break;
-                            }
+                            exportSample2HDF.addDataRow(&dataBlock[((size_t)j)*nCols], H5::PredType::NATIVE_FLOAT);
                         }
-
-                        if(!found)
+                        else if(outputRemain)
                         {
-                            for(unsigned int n = 0; n < nCols; ++n)
-                            {
-                                row[n] = dataBlock[(j*nCols)+n];
-                            }
-                            exportCols2HDF_P2.addDataRow(row, H5::PredType::NATIVE_FLOAT);
+                            exportRemain2HDF.addDataRow(&dataBlock[((size_t)j)*nCols], H5::PredType::NATIVE_FLOAT);
                         }
                     }
                 }
-                exportCols2HDF_P1.close();
-                exportCols2HDF_P2.close();
-                delete[] row;
-                delete[] dataBlock;
-                delete[] ranIdxes;
+                exportSample2HDF.close();
+                if(outputRemain)
+                {
+                    exportRemain2HDF.close();
+                }
             }
             else
             {
@@ -420,9 +321,9 @@ namespace rsgis{namespace img{
     
     
 	
-    RSGISExtractImageValuesWithMask::RSGISExtractImageValuesWithMask(std::vector<float*> *pxlVals, float maskValue): RSGISCalcImageValue(0)
+    RSGISExtractImageValuesWithMask::RSGISExtractImageValuesWithMask(rsgis::utils::RSGISExportColumnData2HDFProducer *dataExport, float maskValue): RSGISCalcImageValue(0)
     {
-        this->pxlVals = pxlVals;
+        this->dataExport = dataExport;
         this->maskValue = maskValue;
     }
     
@@ -430,12 +331,8 @@ namespace rsgis{namespace img{
     {
         if(bandValues[0] == maskValue)
         {
-            float *data = new float[numBands-1];
-            for(unsigned i = 1; i < numBands; ++i)
-            {
-                data[i-1] = bandValues[i];
-            }
-            pxlVals->push_back(data);
+            // The image bands follow the mask.
+            dataExport->addDataRow(&bandValues[1]);
         }
     }
     
@@ -450,24 +347,24 @@ namespace rsgis{namespace img{
     
     
     
-    RSGISExtractImageBandValuesWithMask::RSGISExtractImageBandValuesWithMask(std::vector<float*> *pxlVals, std::vector<unsigned int> imgBands, float maskValue): RSGISCalcImageValue(0)
+    RSGISExtractImageBandValuesWithMask::RSGISExtractImageBandValuesWithMask(rsgis::utils::RSGISExportColumnData2HDFProducer *dataExport, std::vector<unsigned int> imgBands, float maskValue): RSGISCalcImageValue(0)
     {
-        this->pxlVals = pxlVals;
+        this->dataExport = dataExport;
         this->imgBands = imgBands;
         this->maskValue = maskValue;
         this->numOutVals = this->imgBands.size();
+        this->row.resize(this->numOutVals);
     }
     
     void RSGISExtractImageBandValuesWithMask::calcImageValue(float *bandValues, int numBands) 
     {
         if(bandValues[0] == maskValue)
         {
-            float *data = new float[numOutVals];
             for(unsigned i = 0; i < numOutVals; ++i)
             {
-                data[i] = bandValues[imgBands.at(i)];
+                row[i] = bandValues[imgBands[i]];
             }
-            pxlVals->push_back(data);
+            dataExport->addDataRow(row.data());
         }
     }
     
@@ -34,6 +34,7 @@
 #include "img/RSGISImageCalcException.h"
 #include "img/RSGISCalcImageValue.h"
 #include "img/RSGISCalcImage.h"
+#include "img/RSGISImagePointSampler.h"
 
 #include "utils/RSGISExportData2HDF.h"
 
@@ -41,6 +42,7 @@
 
 #include <boost/random/mersenne_twister.hpp>
 #include <boost/random/uniform_int.hpp>
+#include <boost/random/uniform_01.hpp>
 #include <boost/random/variate_generator.hpp>
 
 // mark all exported classes/functions with DllExport to have
@@ -65,16 +67,34 @@ namespace rsgis{namespace img{
         RSGISExtractImageValues();
         void extractDataWithinMask2HDF(GDALDataset *mask, GDALDataset *image, std::string outHDFFile, float maskValue, RSGISLibDataType dataType);
         void extractImgBandDataWithinMask2HDF(std::vector<std::pair<std::string, std::vector<unsigned int> > > imageFiles, std::string maskImage, std::string outHDFFile, float maskValue, RSGISLibDataType dataType);
+        void extractImgBandDataAtPoints2HDF(std::vector<std::pair<std::string, std::vector<unsigned int> > > imageFiles, OGRLayer *ptsLayer, std::string outHDFFile, RSGISLibDataType dataType);
+        /**
+         * Write a random sample of nSamples rows (without replacement, in file order) of the input file.
+         */
         void sampleExtractedHDFData(std::string inputH5, std::string outputH5, unsigned int nSamples, int seed, RSGISLibDataType dataType);
+        /**
+         * As sampleExtractedHDFData with the rows which are not sampled written to outputP2H5.
+         */
         void splitExtractedHDFData(std::string inputH5, std::string outputP1H5, std::string outputP2H5, unsigned int nSamples, int seed, RSGISLibDataType dataType);
         ~RSGISExtractImageValues();
+    protected:
+        /**
+         * Stream the input file a block of chunks at a time, selecting the rows
+         * to sample as it goes, so the memory used does not depend on the
+         * size of the file.
+         */
+        void sampleHDFRows(std::string inputH5, std::string outputSampleH5, std::string outputRemainH5, bool outputRemain, unsigned int nSamples, int seed, RSGISLibDataType dataType);
     };
     
 	
+    /**
+     * Writes the values of the pixels within the mask (the first band) to the
+     * producer as rows of the remaining bands.
+     */
 	class DllExport RSGISExtractImageValuesWithMask : public RSGISCalcImageValue
 	{
 	public:
-		RSGISExtractImageValuesWithMask(std::vector<float*> *pxlVals, float maskValue);
+		RSGISExtractImageValuesWithMask(rsgis::utils::RSGISExportColumnData2HDFProducer *dataExport, float maskValue);
 		void calcImageValue(float *bandValues, int numBands, double *output)  {throw RSGISImageCalcException("No implemented");};
 		void calcImageValue(float *bandValues, int numBands);
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw RSGISImageCalcException("Not implemented");};
@@ -87,7 +107,7 @@ namespace rsgis{namespace img{
 		bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output)  {throw RSGISImageCalcException("No implemented");};
 		~RSGISExtractImageValuesWithMask();
     private:
-        std::vector<float*> *pxlVals;
+        rsgis::utils::RSGISExportColumnData2HDFProducer *dataExport;
         float maskValue;
 	};
     
@@ -95,7 +115,7 @@ namespace rsgis{namespace img{
     class DllExport RSGISExtractImageBandValuesWithMask : public RSGISCalcImageValue
     {
     public:
-        RSGISExtractImageBandValuesWithMask(std::vector<float*> *pxlVals, std::vector<unsigned int> imgBands, float maskValue);
+        RSGISExtractImageBandValuesWithMask(rsgis::utils::RSGISExportColumnData2HDFProducer *dataExport, std::vector<unsigned int> imgBands, float maskValue);
         void calcImageValue(float *bandValues, int numBands, double *output)  {throw RSGISImageCalcException("No implemented");};
         void calcImageValue(float *bandValues, int numBands);
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw RSGISImageCalcException("Not implemented");};
@@ -108,8 +128,9 @@ namespace rsgis{namespace img{
         bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output)  {throw RSGISImageCalcException("No implemented");};
         ~RSGISExtractImageBandValuesWithMask();
     private:
-        std::vector<float*> *pxlVals;
+        rsgis::utils::RSGISExportColumnData2HDFProducer *dataExport;
         std::vector<unsigned int> imgBands;
+        std::vector<float> row;
         unsigned int numOutVals;
         float maskValue;
     };
@@ -28,8 +28,13 @@ namespace rsgis{namespace img{
 
 	RSGISFFTProcessing::RSGISFFTProcessing()
 	{
-		
+        this->numThreads = rsgis::utils::getNumThreads();
 	}
+    
+    void RSGISFFTProcessing::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
 	
     geos::geom::Polygon** RSGISFFTProcessing::findDominateFreq(rsgis::math::Matrix *magnitude, int startCircle, int endCircle, int *numPolys)
 	{
@@ -194,6 +199,145 @@ namespace rsgis{namespace img{
 		
 	}	
 	
+    void RSGISFFTProcessing::convolveImage(GDALDataset *dataset, rsgis::math::Matrix *kernel, std::string outputImage, std::string gdalFormat, GDALDataType outDataType, unsigned int tileSize)
+    {
+        if((kernel == NULL) || (kernel->m < 1) || (kernel->n < 1))
+        {
+            throw RSGISFFTException("The kernel must have at least one row and column.");
+        }
+        if(tileSize < 1)
+        {
+            throw RSGISFFTException("The tile size must be at least 1.");
+        }
+        
+        int xSize = dataset->GetRasterXSize();
+        int ySize = dataset->GetRasterYSize();
+        int numBands = dataset->GetRasterCount();
+        int kernelWidth = kernel->m;
+        int kernelHeight = kernel->n;
+        int kernelHalfWidth = kernelWidth/2;
+        int kernelHalfHeight = kernelHeight/2;
+        
+        // Overlap-save: the first (fft size - kernel size + 1) values of the circular
+        // correlation of each padded tile do not wrap around.
+        unsigned int fftWidth = rsgis::math::RSGISFFTWUtils::nextPowerOfTwo(tileSize + kernelWidth - 1);
+        unsigned int fftHeight = rsgis::math::RSGISFFTWUtils::nextPowerOfTwo(tileSize + kernelHeight - 1);
+        int outTileWidth = fftWidth - kernelWidth + 1;
+        int outTileHeight = fftHeight - kernelHeight + 1;
+        size_t numFFTVals = ((size_t)fftWidth) * fftHeight;
+        
+        // The correlation is IFFT(FFT(tile) . conj(FFT(kernel))).
+        rsgis::math::RSGISFFTWUtils fftUtils;
+        std::vector<std::complex<double> > kernelFFT(numFFTVals, std::complex<double>(0.0, 0.0));
+        for(int i = 0; i < kernelHeight; ++i)
+        {
+            for(int j = 0; j < kernelWidth; ++j)
+            {
+                kernelFFT[(((size_t)i) * fftWidth) + j] = kernel->matrix[(i * kernelWidth) + j];
+            }
+        }
+        fftUtils.fft2D(kernelFFT.data(), fftWidth, fftHeight, false);
+        for(size_t k = 0; k < numFFTVals; ++k)
+        {
+            kernelFFT[k] = std::conj(kernelFFT[k]);
+        }
+        
+        rsgis::img::RSGISImageUtils imgUtils;
+        GDALDataset *outDataset = imgUtils.createCopy(dataset, numBands, outputImage, gdalFormat, outDataType);
+        
+        int numTilesX = (xSize + outTileWidth - 1) / outTileWidth;
+        int numTilesY = (ySize + outTileHeight - 1) / outTileHeight;
+        int numBandPairs = (numBands + 1) / 2;
+        int numItems = numTilesX * numTilesY * numBandPairs;
+        
+        // GDAL dataset handles are not thread safe so all RasterIO calls are serialised.
+        std::mutex ioMutex;
+        rsgis::utils::RSGISWorkerPool pool(std::max(1u, std::min(this->numThreads, (unsigned int)numItems)));
+        std::vector<std::vector<std::complex<double> > > workerTiles(pool.getNumThreads(), std::vector<std::complex<double> >(numFFTVals));
+        std::vector<std::vector<float> > workerInData(pool.getNumThreads(), std::vector<float>(numFFTVals));
+        std::vector<std::vector<float> > workerOutData(pool.getNumThreads(), std::vector<float>(((size_t)outTileWidth) * outTileHeight));
+        try
+        {
+            pool.parallelFor(numItems, [&](size_t itemIdx, unsigned int t)
+            {
+                std::vector<std::complex<double> > &tile = workerTiles[t];
+                std::vector<float> &inData = workerInData[t];
+                std::vector<float> &outData = workerOutData[t];
+                int bandPair = itemIdx % numBandPairs;
+                int tileIdx = itemIdx / numBandPairs;
+                int colOff = (tileIdx % numTilesX) * outTileWidth;
+                int rowOff = (tileIdx / numTilesX) * outTileHeight;
+                int tileWidth = std::min(outTileWidth, xSize - colOff);
+                int tileHeight = std::min(outTileHeight, ySize - rowOff);
+                int inWidth = tileWidth + kernelWidth - 1;
+                int inHeight = tileHeight + kernelHeight - 1;
+                
+                // The part of the tile (with its margin) inside the image.
+                int readX0 = std::max(colOff - kernelHalfWidth, 0);
+                int readY0 = std::max(rowOff - kernelHalfHeight, 0);
+                int readWidth = std::min(colOff - kernelHalfWidth + inWidth, xSize) - readX0;
+                int readHeight = std::min(rowOff - kernelHalfHeight + inHeight, ySize) - readY0;
+                
+                int firstBand = bandPair * 2;
+                int numPairBands = std::min(2, numBands - firstBand);
+                std::fill(tile.begin(), tile.end(), std::complex<double>(0.0, 0.0));
+                for(int b = 0; b < numPairBands; ++b)
+                {
+                    {
+                        std::lock_guard<std::mutex> ioLock(ioMutex);
+                        dataset->GetRasterBand(firstBand + b + 1)->RasterIO(GF_Read, readX0, readY0, readWidth, readHeight, inData.data(), readWidth, readHeight, GDT_Float32, 0, 0);
+                    }
+                    for(int u = 0; u < inHeight; ++u)
+                    {
+                        int row = std::min(std::max(rowOff - kernelHalfHeight + u, 0), ySize - 1) - readY0;
+                        const float *inRow = inData.data() + (((size_t)row) * readWidth);
+                        std::complex<double> *tileRow = tile.data() + (((size_t)u) * fftWidth);
+                        for(int v = 0; v < inWidth; ++v)
+                        {
+                            int col = std::min(std::max(colOff - kernelHalfWidth + v, 0), xSize - 1) - readX0;
+                            if(b == 0)
+                            {
+                                tileRow[v].real(inRow[col]);
+                            }
+                            else
+                            {
+                                tileRow[v].imag(inRow[col]);
+                            }
+                        }
+                    }
+                }
+                
+                fftUtils.fft2D(tile.data(), fftWidth, fftHeight, false);
+                for(size_t k = 0; k < numFFTVals; ++k)
+                {
+                    tile[k] *= kernelFFT[k];
+                }
+                fftUtils.fft2D(tile.data(), fftWidth, fftHeight, true);
+                
+                for(int b = 0; b < numPairBands; ++b)
+                {
+                    for(int p = 0; p < tileHeight; ++p)
+                    {
+                        const std::complex<double> *tileRow = tile.data() + (((size_t)p) * fftWidth);
+                        float *outRow = outData.data() + (((size_t)p) * tileWidth);
+                        for(int q = 0; q < tileWidth; ++q)
+                        {
+                            outRow[q] = (b == 0)?tileRow[q].real():tileRow[q].imag();
+                        }
+                    }
+                    std::lock_guard<std::mutex> ioLock(ioMutex);
+                    outDataset->GetRasterBand(firstBand + b + 1)->RasterIO(GF_Write, colOff, rowOff, tileWidth, tileHeight, outData.data(), tileWidth, tileHeight, GDT_Float32, 0, 0);
+                }
+            });
+        }
+        catch(...)
+        {
+            GDALClose(outDataset);
+            throw;
+        }
+        GDALClose(outDataset);
+    }
+    
 	RSGISFFTProcessing::~RSGISFFTProcessing()
 	{
 		
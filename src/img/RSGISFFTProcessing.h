@@ -25,12 +25,25 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <complex>
+#include <cstdlib>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <exception>
+
+#include "gdal_priv.h"
+
 #include "math/RSGISMatrices.h"
+#include "math/RSGISFFTWUtils.h"
+#include "img/RSGISImageUtils.h"
 #include "geom/RSGISGeometry.h"
 //#include "datastruct/SortedGenericList.cpp"
 #include "img/RSGISFFTException.h"
 
 #include "geos/geom/Polygon.h"
+#include "common/RSGISParallel.h"
 
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
@@ -52,7 +65,29 @@ namespace rsgis{namespace img{
 		public:
 			RSGISFFTProcessing();
             geos::geom::Polygon** findDominateFreq(rsgis::math::Matrix *magnitude, int startCircle, int endCircle, int *numPolys);
+            /**
+             * The number of threads used by convolveImage (0 uses the number of
+             * cores). Defaults to RSGISLIB_NUM_THREADS.
+             */
+            void setNumThreads(unsigned int numThreads);
+            /**
+             * Apply the kernel (n rows x m columns, centred on the pixel) to each band
+             * of the image, i.e., out(r,c) = sum kernel(i,j).in(r+i-n/2, c+j-m/2), with
+             * the image edges extended, through the FFT.
+             *
+             * The image is processed in tiles (overlap-save) so memory is bounded by
+             * the tile size, whatever the size of the image: each tile of tileSize^2
+             * output pixels is read with a margin of the kernel size, padded to a
+             * power of 2 and filtered by multiplying by the kernel spectrum. All tiles
+             * have the same FFT size so the kernel spectrum and the FFT plan are made
+             * once and reused. As the kernel is real, two bands are filtered with one
+             * complex transform (as the real and imaginary parts), and tiles are
+             * shared between threads.
+             */
+            void convolveImage(GDALDataset *dataset, rsgis::math::Matrix *kernel, std::string outputImage, std::string gdalFormat, GDALDataType outDataType, unsigned int tileSize=512);
 			~RSGISFFTProcessing();
+        protected:
+            unsigned int numThreads;
 		};
 }}
 
@@ -35,8 +35,10 @@ namespace rsgis{namespace img{
     {
         try
         {
-            std::vector<double> *dataVals = new std::vector<double>();
-            std::vector<double> *xVals = new std::vector<double>();
+            rsgis::RSGISScratchScope scratch(this->getScratchArena());
+            double *dataVals = scratch.alloc<double>(numBands);
+            double *xVals = scratch.alloc<double>(numBands);
+            size_t numVals = 0;
             for(int i = 0; i < numBands; ++i)
             {
                 if(this->useNoDataValue & (bandValues[i] == this->noDataValue))
@@ -45,18 +47,13 @@ namespace rsgis{namespace img{
                 }
                 else
                 {
-                    dataVals->push_back(bandValues[i]);
-                    xVals->push_back(bandXValues.at(i));
+                    dataVals[numVals] = bandValues[i];
+                    xVals[numVals] = bandXValues.at(i);
+                    ++numVals;
                 }
             }
             
-            if(dataVals->size() != xVals->size())
-            {
-                std::cout << "dataVals->size() = " << dataVals->size() << std::endl;
-                std::cout << "xVals->size() = " << xVals->size() << std::endl;
-                throw RSGISImageCalcException("The X and Y vectors need to be of the same length.");
-            }
-            else if(dataVals->size() > 0)
+            if(numVals > 0)
             {
                 double c0 = 0.0;
                 double c1 = 0.0;
@@ -65,7 +62,7 @@ namespace rsgis{namespace img{
                 double cov11 = 0.0;
                 double sumsq = 0.0;
                 
-                gsl_fit_linear(&(*xVals)[0], 1, &(*dataVals)[0], 1, dataVals->size(), &c0, &c1, &cov00, &cov01, &cov11, &sumsq);
+                gsl_fit_linear(xVals, 1, dataVals, 1, numVals, &c0, &c1, &cov00, &cov01, &cov11, &sumsq);
                 
                 output[0] = c0;
                 output[1] = c1;
@@ -77,10 +74,6 @@ namespace rsgis{namespace img{
                 output[1] = 0.0;
                 output[2] = 0.0;
             }
-            
-            
-            delete dataVals;
-            delete xVals;
         }
         catch(RSGISException &e)
         {
@@ -98,4 +91,658 @@ namespace rsgis{namespace img{
     }
     
     
+    const size_t RSGISLinearModelFit2Pxls::maxCachedMasks = 4096;
+    const size_t RSGISLinearModelFit2Pxls::pxlChunkSize = 4096;
+    
+    RSGISLinearModelFit2Pxls::RSGISLinearModelFit2Pxls(std::vector<float> bandXValues, RSGISLinearModelType modelType, unsigned int numTerms, float period, float noDataValue, bool useNoDataValue):RSGISCalcImageValue(1)
+    {
+        this->bandXValues = bandXValues;
+        this->modelType = modelType;
+        this->numTerms = numTerms;
+        this->period = period;
+        this->noDataValue = noDataValue;
+        this->useNoDataValue = useNoDataValue;
+        
+        if(modelType == rsgis_linmodel_polynomial)
+        {
+            // numTerms is the degree of the polynomial.
+            this->numCoeffs = numTerms + 1;
+        }
+        else if(modelType == rsgis_linmodel_harmonic)
+        {
+            // numTerms is the number of harmonics, each with a cos and sin term, plus an intercept and slope.
+            if(period <= 0)
+            {
+                throw RSGISImageCalcException("The period of the harmonic model must be greater than zero.");
+            }
+            this->numCoeffs = 2 + (2 * numTerms);
+        }
+        else
+        {
+            throw RSGISImageCalcException("The model type was not recognised.");
+        }
+        this->numOutBands = this->numCoeffs + 1;
+    }
+    
+    void RSGISLinearModelFit2Pxls::calcModelTerms(double x, double *terms)
+    {
+        if(this->modelType == rsgis_linmodel_polynomial)
+        {
+            double xPow = 1.0;
+            for(unsigned int k = 0; k < this->numCoeffs; ++k)
+            {
+                terms[k] = xPow;
+                xPow *= x;
+            }
+        }
+        else
+        {
+            terms[0] = 1.0;
+            terms[1] = x;
+            double angFreq = (2.0 * M_PI) / this->period;
+            for(unsigned int k = 1; k <= this->numTerms; ++k)
+            {
+                terms[2*k] = cos(angFreq * k * x);
+                terms[(2*k)+1] = sin(angFreq * k * x);
+            }
+        }
+    }
+    
+    const RSGISLinearModelFit2Pxls::MaskFit& RSGISLinearModelFit2Pxls::getMaskFit(const std::vector<bool> &validMask)
+    {
+        std::map<std::vector<bool>, MaskFit>::iterator iterFit = this->maskFits.find(validMask);
+        if(iterFit != this->maskFits.end())
+        {
+            return iterFit->second;
+        }
+        if(this->maskFits.size() >= maxCachedMasks)
+        {
+            this->clearCache();
+        }
+        
+        MaskFit fit;
+        fit.design = NULL;
+        fit.pseudoInverse = NULL;
+        for(size_t i = 0; i < validMask.size(); ++i)
+        {
+            if(validMask[i])
+            {
+                fit.validBands.push_back(i);
+            }
+        }
+        size_t numValid = fit.validBands.size();
+        fit.solvable = (numValid >= this->numCoeffs);
+        
+        if(fit.solvable)
+        {
+            fit.design = gsl_matrix_alloc(numValid, this->numCoeffs);
+            for(size_t i = 0; i < numValid; ++i)
+            {
+                this->calcModelTerms(this->bandXValues.at(fit.validBands[i]), gsl_matrix_ptr(fit.design, i, 0));
+            }
+            
+            // P = V.diag(1/S).U', ignoring negligible singular values (e.g., repeated x values).
+            gsl_matrix *U = gsl_matrix_alloc(numValid, this->numCoeffs);
+            gsl_matrix_memcpy(U, fit.design);
+            gsl_matrix *V = gsl_matrix_alloc(this->numCoeffs, this->numCoeffs);
+            gsl_vector *S = gsl_vector_alloc(this->numCoeffs);
+            gsl_vector *work = gsl_vector_alloc(this->numCoeffs);
+            int status = gsl_linalg_SV_decomp(U, V, S, work);
+            if(status == 0)
+            {
+                double sTol = gsl_vector_get(S, 0) * numValid * GSL_DBL_EPSILON;
+                for(size_t k = 0; k < this->numCoeffs; ++k)
+                {
+                    double sVal = gsl_vector_get(S, k);
+                    gsl_vector_view col = gsl_matrix_column(V, k);
+                    gsl_vector_scale(&col.vector, (sVal > sTol)?(1.0/sVal):0.0);
+                }
+                fit.pseudoInverse = gsl_matrix_alloc(this->numCoeffs, numValid);
+                status = gsl_blas_dgemm(CblasNoTrans, CblasTrans, 1.0, V, U, 0.0, fit.pseudoInverse);
+            }
+            gsl_matrix_free(U);
+            gsl_matrix_free(V);
+            gsl_vector_free(S);
+            gsl_vector_free(work);
+            if(status != 0)
+            {
+                gsl_matrix_free(fit.design);
+                if(fit.pseudoInverse != NULL)
+                {
+                    gsl_matrix_free(fit.pseudoInverse);
+                }
+                throw RSGISImageCalcException(gsl_strerror(status));
+            }
+        }
+        
+        return this->maskFits.insert(std::pair<std::vector<bool>, MaskFit>(validMask, fit)).first->second;
+    }
+    
+    void RSGISLinearModelFit2Pxls::calcImageValue(float *bandValues, int numBands, double *output)
+    {
+        if(numBands != ((int)this->bandXValues.size()))
+        {
+            throw RSGISImageCalcException("The number of image bands and x values need to be equal.");
+        }
+        
+        std::vector<bool> validMask(numBands);
+        for(int i = 0; i < numBands; ++i)
+        {
+            validMask[i] = this->isValid(bandValues[i]);
+        }
+        const MaskFit &fit = this->getMaskFit(validMask);
+        if(!fit.solvable)
+        {
+            for(int j = 0; j < this->numOutBands; ++j)
+            {
+                output[j] = 0.0;
+            }
+            return;
+        }
+        
+        size_t numValid = fit.validBands.size();
+        for(unsigned int j = 0; j < this->numCoeffs; ++j)
+        {
+            const double *pinvRow = gsl_matrix_const_ptr(fit.pseudoInverse, j, 0);
+            double coeff = 0.0;
+            for(size_t i = 0; i < numValid; ++i)
+            {
+                coeff += pinvRow[i] * bandValues[fit.validBands[i]];
+            }
+            output[j] = coeff;
+        }
+        double sumSq = 0.0;
+        for(size_t i = 0; i < numValid; ++i)
+        {
+            const double *designRow = gsl_matrix_const_ptr(fit.design, i, 0);
+            double residual = bandValues[fit.validBands[i]];
+            for(unsigned int j = 0; j < this->numCoeffs; ++j)
+            {
+                residual -= designRow[j] * output[j];
+            }
+            sumSq += residual * residual;
+        }
+        output[this->numCoeffs] = sqrt(sumSq / numValid);
+    }
+    
+    void RSGISLinearModelFit2Pxls::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        if(numBands != ((int)this->bandXValues.size()))
+        {
+            throw RSGISImageCalcException("The number of image bands and x values need to be equal.");
+        }
+        
+        // Group the pixels by their pattern of valid bands; usually there are only a few patterns
+        // (e.g., all valid or a cloudy date) so most pixels are fitted with the same pseudo-inverse.
+        std::map<std::vector<bool>, std::vector<size_t> > maskPxls;
+        std::vector<bool> validMask(numBands);
+        for(size_t p = 0; p < nPxls; ++p)
+        {
+            for(int i = 0; i < numBands; ++i)
+            {
+                validMask[i] = this->isValid(bandPlanes[i][p]);
+            }
+            maskPxls[validMask].push_back(p);
+        }
+        
+        rsgis::RSGISScratchScope scratch(this->getScratchArena());
+        size_t chunkSize = std::min(nPxls, pxlChunkSize);
+        double *yVals = scratch.alloc<double>(numBands * chunkSize);
+        double *cVals = scratch.alloc<double>(this->numCoeffs * chunkSize);
+        
+        for(std::map<std::vector<bool>, std::vector<size_t> >::iterator iterMask = maskPxls.begin(); iterMask != maskPxls.end(); ++iterMask)
+        {
+            const std::vector<size_t> &pxls = iterMask->second;
+            const MaskFit &fit = this->getMaskFit(iterMask->first);
+            if(!fit.solvable)
+            {
+                for(int j = 0; j < this->numOutBands; ++j)
+                {
+                    double *outPlane = outPlanes[j];
+                    for(size_t g = 0; g < pxls.size(); ++g)
+                    {
+                        outPlane[pxls[g]] = 0.0;
+                    }
+                }
+                continue;
+            }
+            
+            size_t numValid = fit.validBands.size();
+            for(size_t start = 0; start < pxls.size(); start += chunkSize)
+            {
+                size_t nChunk = std::min(chunkSize, pxls.size() - start);
+                const size_t *chunkPxls = &pxls[start];
+                for(size_t i = 0; i < numValid; ++i)
+                {
+                    const float *inPlane = bandPlanes[fit.validBands[i]];
+                    double *yRow = yVals + (i * nChunk);
+                    for(size_t g = 0; g < nChunk; ++g)
+                    {
+                        yRow[g] = inPlane[chunkPxls[g]];
+                    }
+                }
+                
+                // C (coefficients x pixels) = P (coefficients x valid bands) . Y (valid bands x pixels)
+                // and then the residuals Y = Y - A.C
+                gsl_matrix_view yMat = gsl_matrix_view_array(yVals, numValid, nChunk);
+                gsl_matrix_view cMat = gsl_matrix_view_array(cVals, this->numCoeffs, nChunk);
+                int status = gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, fit.pseudoInverse, &yMat.matrix, 0.0, &cMat.matrix);
+                if(status == 0)
+                {
+                    status = gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, -1.0, fit.design, &cMat.matrix, 1.0, &yMat.matrix);
+                }
+                if(status != 0)
+                {
+                    throw RSGISImageCalcException(gsl_strerror(status));
+                }
+                
+                for(unsigned int j = 0; j < this->numCoeffs; ++j)
+                {
+                    const double *cRow = cVals + (j * nChunk);
+                    double *outPlane = outPlanes[j];
+                    for(size_t g = 0; g < nChunk; ++g)
+                    {
+                        outPlane[chunkPxls[g]] = cRow[g];
+                    }
+                }
+                
+                double *rmsePlane = outPlanes[this->numCoeffs];
+                for(size_t g = 0; g < nChunk; ++g)
+                {
+                    rmsePlane[chunkPxls[g]] = 0.0;
+                }
+                for(size_t i = 0; i < numValid; ++i)
+                {
+                    const double *rRow = yVals + (i * nChunk);
+                    for(size_t g = 0; g < nChunk; ++g)
+                    {
+                        rmsePlane[chunkPxls[g]] += rRow[g] * rRow[g];
+                    }
+                }
+                for(size_t g = 0; g < nChunk; ++g)
+                {
+                    rmsePlane[chunkPxls[g]] = sqrt(rmsePlane[chunkPxls[g]] / numValid);
+                }
+            }
+        }
+    }
+    
+    RSGISCalcImageValue* RSGISLinearModelFit2Pxls::getThreadClone()
+    {
+        // The cache of factorisations is not shared so each thread builds its own.
+        return new RSGISLinearModelFit2Pxls(this->bandXValues, this->modelType, this->numTerms, this->period, this->noDataValue, this->useNoDataValue);
+    }
+    
+    std::vector<std::string> RSGISLinearModelFit2Pxls::getOutBandNames()
+    {
+        std::vector<std::string> bandNames;
+        if(this->modelType == rsgis_linmodel_polynomial)
+        {
+            for(unsigned int k = 0; k < this->numCoeffs; ++k)
+            {
+                bandNames.push_back("c" + std::to_string(k));
+            }
+        }
+        else
+        {
+            bandNames.push_back("Intercept");
+            bandNames.push_back("Slope");
+            for(unsigned int k = 1; k <= this->numTerms; ++k)
+            {
+                bandNames.push_back("Cos" + std::to_string(k));
+                bandNames.push_back("Sin" + std::to_string(k));
+            }
+        }
+        bandNames.push_back("RMSE");
+        return bandNames;
+    }
+    
+    void RSGISLinearModelFit2Pxls::clearCache()
+    {
+        for(std::map<std::vector<bool>, MaskFit>::iterator iterFit = this->maskFits.begin(); iterFit != this->maskFits.end(); ++iterFit)
+        {
+            if(iterFit->second.design != NULL)
+            {
+                gsl_matrix_free(iterFit->second.design);
+            }
+            if(iterFit->second.pseudoInverse != NULL)
+            {
+                gsl_matrix_free(iterFit->second.pseudoInverse);
+            }
+        }
+        this->maskFits.clear();
+    }
+    
+    RSGISLinearModelFit2Pxls::~RSGISLinearModelFit2Pxls()
+    {
+        this->clearCache();
+    }
+    
+    
+    RSGISRobustModelFit2Pxls::RSGISRobustModelFit2Pxls(std::vector<float> bandXValues, RSGISLinearModelType modelType, unsigned int numTerms, float period, unsigned int maxIters, float tuning, float outlierThreshold, bool outputOutliers, float noDataValue, bool useNoDataValue):RSGISLinearModelFit2Pxls(bandXValues, modelType, numTerms, period, noDataValue, useNoDataValue)
+    {
+        if(tuning <= 0)
+        {
+            throw RSGISImageCalcException("The tuning constant of the biweight must be greater than zero.");
+        }
+        this->maxIters = maxIters;
+        this->tuning = tuning;
+        this->outlierThreshold = outlierThreshold;
+        this->outputOutliers = outputOutliers;
+        this->numOutBands = this->numCoeffs + 1 + (outputOutliers?bandXValues.size():0);
+    }
+    
+    bool RSGISRobustModelFit2Pxls::solveNormalEquations(double *ata, double *atb, unsigned int n)
+    {
+        // Cholesky factorisation of the lower triangle in place, then forward
+        // and back substitution leaving the solution in atb.
+        for(unsigned int j = 0; j < n; ++j)
+        {
+            double diag = ata[(j*n)+j];
+            for(unsigned int k = 0; k < j; ++k)
+            {
+                diag -= ata[(j*n)+k] * ata[(j*n)+k];
+            }
+            if(!(diag > (ata[(j*n)+j] * 1e-12)))
+            {
+                return false;
+            }
+            diag = sqrt(diag);
+            ata[(j*n)+j] = diag;
+            for(unsigned int i = j+1; i < n; ++i)
+            {
+                double val = ata[(i*n)+j];
+                for(unsigned int k = 0; k < j; ++k)
+                {
+                    val -= ata[(i*n)+k] * ata[(j*n)+k];
+                }
+                ata[(i*n)+j] = val / diag;
+            }
+        }
+        for(unsigned int i = 0; i < n; ++i)
+        {
+            double val = atb[i];
+            for(unsigned int k = 0; k < i; ++k)
+            {
+                val -= ata[(i*n)+k] * atb[k];
+            }
+            atb[i] = val / ata[(i*n)+i];
+        }
+        for(unsigned int i = n; i > 0; --i)
+        {
+            unsigned int r = i - 1;
+            double val = atb[r];
+            for(unsigned int k = r+1; k < n; ++k)
+            {
+                val -= ata[(k*n)+r] * atb[k];
+            }
+            atb[r] = val / ata[(r*n)+r];
+        }
+        return true;
+    }
+    
+    void RSGISRobustModelFit2Pxls::fitRobust(const MaskFit &fit, const double *yVals, size_t nChunk, double *cVals, double *rVals, double *wVals)
+    {
+        size_t numValid = fit.validBands.size();
+        unsigned int nCoeffs = this->numCoeffs;
+        rsgis::RSGISScratchScope scratch(this->getScratchArena());
+        double *absRes = scratch.alloc<double>(numValid);
+        double *ata = scratch.alloc<double>(nCoeffs * nCoeffs);
+        double *atb = scratch.alloc<double>(nCoeffs);
+        bool *active = scratch.alloc<bool>(nChunk);
+        for(size_t g = 0; g < nChunk; ++g)
+        {
+            active[g] = true;
+        }
+        
+        // The biweight of each observation of pixel g from the residuals, returning false
+        // if the residuals have no spread (the weights are then 1 for an exact fit, else 0).
+        auto calcWeights = [&](size_t g) -> bool
+        {
+            for(size_t i = 0; i < numValid; ++i)
+            {
+                absRes[i] = fabs(rVals[(i*nChunk)+g]);
+            }
+            std::nth_element(absRes, absRes + (numValid/2), absRes + numValid);
+            double cScale = this->tuning * (absRes[numValid/2] / 0.6745);
+            for(size_t i = 0; i < numValid; ++i)
+            {
+                double res = rVals[(i*nChunk)+g];
+                if(cScale > 0)
+                {
+                    double u = res / cScale;
+                    wVals[(i*nChunk)+g] = (fabs(u) < 1)?((1 - (u*u)) * (1 - (u*u))):0.0;
+                }
+                else
+                {
+                    wVals[(i*nChunk)+g] = (res == 0)?1.0:0.0;
+                }
+            }
+            return (cScale > 0);
+        };
+        
+        gsl_matrix_const_view yMat = gsl_matrix_const_view_array(yVals, numValid, nChunk);
+        gsl_matrix_view rMat = gsl_matrix_view_array(rVals, numValid, nChunk);
+        gsl_matrix_view cMat = gsl_matrix_view_array(cVals, nCoeffs, nChunk);
+        bool anyActive = true;
+        for(unsigned int iter = 0; ; ++iter)
+        {
+            // R = Y - A.C for all the pixels at once.
+            gsl_matrix_memcpy(&rMat.matrix, &yMat.matrix);
+            int status = gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, -1.0, fit.design, &cMat.matrix, 1.0, &rMat.matrix);
+            if(status != 0)
+            {
+                throw RSGISImageCalcException(gsl_strerror(status));
+            }
+            if((iter == this->maxIters) || (!anyActive))
+            {
+                break;
+            }
+            
+            anyActive = false;
+            for(size_t g = 0; g < nChunk; ++g)
+            {
+                if(!active[g])
+                {
+                    continue;
+                }
+                if(!calcWeights(g))
+                {
+                    active[g] = false;
+                    continue;
+                }
+                for(unsigned int j = 0; j < (nCoeffs * nCoeffs); ++j)
+                {
+                    ata[j] = 0.0;
+                }
+                for(unsigned int j = 0; j < nCoeffs; ++j)
+                {
+                    atb[j] = 0.0;
+                }
+                for(size_t i = 0; i < numValid; ++i)
+                {
+                    double weight = wVals[(i*nChunk)+g];
+                    if(weight == 0)
+                    {
+                        continue;
+                    }
+                    const double *designRow = gsl_matrix_const_ptr(fit.design, i, 0);
+                    double wy = weight * yVals[(i*nChunk)+g];
+                    for(unsigned int j = 0; j < nCoeffs; ++j)
+                    {
+                        double wa = weight * designRow[j];
+                        atb[j] += designRow[j] * wy;
+                        for(unsigned int k = 0; k <= j; ++k)
+                        {
+                            ata[(j*nCoeffs)+k] += wa * designRow[k];
+                        }
+                    }
+                }
+                // Too few observations with weight for the model; keep the last fit.
+                if(!RSGISRobustModelFit2Pxls::solveNormalEquations(ata, atb, nCoeffs))
+                {
+                    active[g] = false;
+                    continue;
+                }
+                double maxChange = 0.0;
+                double maxCoeff = 0.0;
+                for(unsigned int j = 0; j < nCoeffs; ++j)
+                {
+                    double *coeff = cVals + (j*nChunk) + g;
+                    maxChange = std::max(maxChange, fabs(atb[j] - *coeff));
+                    maxCoeff = std::max(maxCoeff, fabs(atb[j]));
+                    *coeff = atb[j];
+                }
+                active[g] = (maxChange > (1e-6 * (1 + maxCoeff)));
+                anyActive = anyActive || active[g];
+            }
+        }
+        
+        for(size_t g = 0; g < nChunk; ++g)
+        {
+            calcWeights(g);
+        }
+    }
+    
+    void RSGISRobustModelFit2Pxls::calcImageValue(float *bandValues, int numBands, double *output)
+    {
+        rsgis::RSGISScratchScope scratch(this->getScratchArena());
+        const float **bandPlanes = scratch.alloc<const float*>(numBands);
+        for(int i = 0; i < numBands; ++i)
+        {
+            bandPlanes[i] = &bandValues[i];
+        }
+        double **outPlanes = scratch.alloc<double*>(this->numOutBands);
+        for(int j = 0; j < this->numOutBands; ++j)
+        {
+            outPlanes[j] = &output[j];
+        }
+        this->calcImageBlock(bandPlanes, numBands, 1, outPlanes);
+    }
+    
+    void RSGISRobustModelFit2Pxls::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        if(numBands != ((int)this->bandXValues.size()))
+        {
+            throw RSGISImageCalcException("The number of image bands and x values need to be equal.");
+        }
+        
+        std::map<std::vector<bool>, std::vector<size_t> > maskPxls;
+        std::vector<bool> validMask(numBands);
+        for(size_t p = 0; p < nPxls; ++p)
+        {
+            for(int i = 0; i < numBands; ++i)
+            {
+                validMask[i] = this->isValid(bandPlanes[i][p]);
+            }
+            maskPxls[validMask].push_back(p);
+        }
+        for(int j = 0; j < this->numOutBands; ++j)
+        {
+            std::fill(outPlanes[j], outPlanes[j] + nPxls, 0.0);
+        }
+        
+        rsgis::RSGISScratchScope scratch(this->getScratchArena());
+        size_t chunkSize = std::min(nPxls, pxlChunkSize);
+        double *yVals = scratch.alloc<double>(numBands * chunkSize);
+        double *rVals = scratch.alloc<double>(numBands * chunkSize);
+        double *wVals = scratch.alloc<double>(numBands * chunkSize);
+        double *cVals = scratch.alloc<double>(this->numCoeffs * chunkSize);
+        
+        for(std::map<std::vector<bool>, std::vector<size_t> >::iterator iterMask = maskPxls.begin(); iterMask != maskPxls.end(); ++iterMask)
+        {
+            const std::vector<size_t> &pxls = iterMask->second;
+            const MaskFit &fit = this->getMaskFit(iterMask->first);
+            if(!fit.solvable)
+            {
+                continue;
+            }
+            
+            size_t numValid = fit.validBands.size();
+            for(size_t start = 0; start < pxls.size(); start += chunkSize)
+            {
+                size_t nChunk = std::min(chunkSize, pxls.size() - start);
+                const size_t *chunkPxls = &pxls[start];
+                for(size_t i = 0; i < numValid; ++i)
+                {
+                    const float *inPlane = bandPlanes[fit.validBands[i]];
+                    double *yRow = yVals + (i * nChunk);
+                    for(size_t g = 0; g < nChunk; ++g)
+                    {
+                        yRow[g] = inPlane[chunkPxls[g]];
+                    }
+                }
+                
+                // The least squares fit of all the pixels, C = P.Y, is the starting point.
+                gsl_matrix_view yMat = gsl_matrix_view_array(yVals, numValid, nChunk);
+                gsl_matrix_view cMat = gsl_matrix_view_array(cVals, this->numCoeffs, nChunk);
+                int status = gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, fit.pseudoInverse, &yMat.matrix, 0.0, &cMat.matrix);
+                if(status != 0)
+                {
+                    throw RSGISImageCalcException(gsl_strerror(status));
+                }
+                this->fitRobust(fit, yVals, nChunk, cVals, rVals, wVals);
+                
+                for(unsigned int j = 0; j < this->numCoeffs; ++j)
+                {
+                    const double *cRow = cVals + (j * nChunk);
+                    double *outPlane = outPlanes[j];
+                    for(size_t g = 0; g < nChunk; ++g)
+                    {
+                        outPlane[chunkPxls[g]] = cRow[g];
+                    }
+                }
+                
+                double *rmsePlane = outPlanes[this->numCoeffs];
+                for(size_t g = 0; g < nChunk; ++g)
+                {
+                    double sumSq = 0.0;
+                    size_t numInliers = 0;
+                    for(size_t i = 0; i < numValid; ++i)
+                    {
+                        double res = rVals[(i*nChunk)+g];
+                        bool outlier = (this->outlierThreshold > 0)?(fabs(res) > this->outlierThreshold):(wVals[(i*nChunk)+g] == 0);
+                        if(outlier)
+                        {
+                            if(this->outputOutliers)
+                            {
+                                outPlanes[this->numCoeffs + 1 + fit.validBands[i]][chunkPxls[g]] = 1;
+                            }
+                        }
+                        else
+                        {
+                            sumSq += res * res;
+                            ++numInliers;
+                        }
+                    }
+                    rmsePlane[chunkPxls[g]] = (numInliers > 0)?sqrt(sumSq / numInliers):0.0;
+                }
+            }
+        }
+    }
+    
+    RSGISCalcImageValue* RSGISRobustModelFit2Pxls::getThreadClone()
+    {
+        return new RSGISRobustModelFit2Pxls(this->bandXValues, this->modelType, this->numTerms, this->period, this->maxIters, this->tuning, this->outlierThreshold, this->outputOutliers, this->noDataValue, this->useNoDataValue);
+    }
+    
+    std::vector<std::string> RSGISRobustModelFit2Pxls::getOutBandNames()
+    {
+        std::vector<std::string> bandNames = RSGISLinearModelFit2Pxls::getOutBandNames();
+        if(this->outputOutliers)
+        {
+            for(size_t i = 0; i < this->bandXValues.size(); ++i)
+            {
+                bandNames.push_back("Outlier" + std::to_string(i + 1));
+            }
+        }
+        return bandNames;
+    }
+    
+    RSGISRobustModelFit2Pxls::~RSGISRobustModelFit2Pxls()
+    {
+        
+    }
+    
+    
 }}
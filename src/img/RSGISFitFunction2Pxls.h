@@ -25,6 +25,10 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <algorithm>
 
 #include "img/RSGISImageCalcException.h"
 #include "img/RSGISCalcImageValue.h"
@@ -34,6 +38,11 @@
 #include "math/RSGISMathsUtils.h"
 
 #include "gsl/gsl_fit.h"
+#include "gsl/gsl_matrix.h"
+#include "gsl/gsl_blas.h"
+#include "gsl/gsl_linalg.h"
+#include "gsl/gsl_math.h"
+#include "gsl/gsl_errno.h"
 
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
@@ -56,6 +65,7 @@ namespace rsgis{namespace img{
     public:
         RSGISLinearFit2Column(std::vector<float> bandXValues, float noDataValue=0, bool useNoDataValue=false);
         void calcImageValue(float *bandValues, int numBands, double *output);
+        bool isThreadSafe(){return true;};
         void calcImageValue(float *bandValues, int numBands) {throw RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw RSGISImageCalcException("Not implemented");};
@@ -72,6 +82,118 @@ namespace rsgis{namespace img{
         bool useNoDataValue;
     };
     
+    enum RSGISLinearModelType
+    {
+        rsgis_linmodel_polynomial = 0,
+        rsgis_linmodel_harmonic = 1
+    };
+    
+    /**
+     * Fits a model which is linear in its parameters to the values of each
+     * pixel (at the x value, e.g. day of year, of each band) by least squares
+     * and outputs the coefficients followed by the RMSE of the fit.
+     *
+     * The models are a polynomial (1, x, ..., x^degree) or a harmonic model
+     * (1, x, cos(2.pi.k.x/period), sin(2.pi.k.x/period) for k = 1..numHarmonics).
+     *
+     * The least squares solution only depends on the x values of the valid
+     * bands so the pseudo-inverse of the design matrix is calculated once for
+     * each pattern of valid bands (no data and NaN values are ignored) and the
+     * pixels of a block with the same pattern are fitted together as a matrix
+     * multiplication. The factorisations are cached in each instance, so each
+     * thread has its own (see getThreadClone). Pixels with fewer valid values
+     * than coefficients are given 0.
+     */
+    class DllExport RSGISLinearModelFit2Pxls: public RSGISCalcImageValue
+    {
+    public:
+        RSGISLinearModelFit2Pxls(std::vector<float> bandXValues, RSGISLinearModelType modelType, unsigned int numTerms, float period=365.25, float noDataValue=0, bool useNoDataValue=false);
+        void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        RSGISCalcImageValue* getThreadClone();
+        void calcImageValue(float *bandValues, int numBands) {throw RSGISImageCalcException("Not implemented");};
+        void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw RSGISImageCalcException("Not implemented");};
+        void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw RSGISImageCalcException("Not implemented");};
+        void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, geos::geom::Envelope extent){throw rsgis::img::RSGISImageCalcException("Not implemented");};
+        void calcImageValue(float *bandValues, int numBands, geos::geom::Envelope extent) {throw RSGISImageCalcException("Not implemented");};
+        void calcImageValue(float *bandValues, int numBands, double *output, geos::geom::Envelope extent) {throw RSGISImageCalcException("Not implemented");};
+        void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageCalcException("Not implemented");};
+        void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output, geos::geom::Envelope extent) {throw RSGISImageCalcException("No implemented");};
+        bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageCalcException("Not implemented");};
+        /** The number of model coefficients (the output has one more band, the RMSE). */
+        unsigned int getNumCoefficients(){return this->numCoeffs;};
+        /** The names of the coefficients followed by 'RMSE'. */
+        std::vector<std::string> getOutBandNames();
+        ~RSGISLinearModelFit2Pxls();
+    protected:
+        struct MaskFit
+        {
+            bool solvable;
+            // The indexes of the valid bands.
+            std::vector<int> validBands;
+            // The design matrix (valid bands x coefficients).
+            gsl_matrix *design;
+            // The pseudo-inverse of the design matrix (coefficients x valid bands).
+            gsl_matrix *pseudoInverse;
+        };
+        bool isValid(float val){return !(std::isnan(val) || (this->useNoDataValue && (val == this->noDataValue)));};
+        const MaskFit& getMaskFit(const std::vector<bool> &validMask);
+        void calcModelTerms(double x, double *terms);
+        void clearCache();
+        static const size_t maxCachedMasks;
+        static const size_t pxlChunkSize;
+        std::vector<float> bandXValues;
+        RSGISLinearModelType modelType;
+        unsigned int numTerms;
+        unsigned int numCoeffs;
+        float period;
+        float noDataValue;
+        bool useNoDataValue;
+        std::map<std::vector<bool>, MaskFit> maskFits;
+    };
+    
+    /**
+     * Fits the models of RSGISLinearModelFit2Pxls robustly by iteratively
+     * reweighted least squares with Tukey's biweight, so outliers (e.g.,
+     * cloud, shadow or snow in a time series) have no influence on the fit.
+     *
+     * The least squares fit, from the factorisation shared by the pixels with
+     * the same pattern of valid bands, is the starting point and each
+     * iteration reweights the observations of each pixel by their residuals,
+     * scaled by the median absolute residual (/0.6745), and solves the
+     * weighted normal equations of the pixel. Iteration stops after maxIters
+     * or once the coefficients of all the pixels of a block have converged.
+     *
+     * The output is the coefficients, the RMSE of the observations which are
+     * not outliers and, if outputOutliers, a band for each input band which
+     * is 1 where the observation is an outlier. An observation is an outlier
+     * where its absolute residual is greater than outlierThreshold or, if
+     * outlierThreshold is 0, where it is given no weight by the biweight.
+     */
+    class DllExport RSGISRobustModelFit2Pxls: public RSGISLinearModelFit2Pxls
+    {
+    public:
+        RSGISRobustModelFit2Pxls(std::vector<float> bandXValues, RSGISLinearModelType modelType, unsigned int numTerms, float period=365.25, unsigned int maxIters=5, float tuning=4.685, float outlierThreshold=0, bool outputOutliers=true, float noDataValue=0, bool useNoDataValue=false);
+        void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        RSGISCalcImageValue* getThreadClone();
+        /** The names of the coefficients followed by 'RMSE' and the outlier bands. */
+        std::vector<std::string> getOutBandNames();
+        ~RSGISRobustModelFit2Pxls();
+    protected:
+        /**
+         * Refine the least squares coefficients (coefficients x pixels) of
+         * the pixels of yVals (valid bands x pixels) by IRLS, leaving the
+         * residuals in rVals and the weights in wVals (valid bands x pixels).
+         */
+        void fitRobust(const MaskFit &fit, const double *yVals, size_t nChunk, double *cVals, double *rVals, double *wVals);
+        static bool solveNormalEquations(double *ata, double *atb, unsigned int n);
+        unsigned int maxIters;
+        float tuning;
+        float outlierThreshold;
+        bool outputOutliers;
+    };
+    
     
 }}
 
@@ -0,0 +1,159 @@
+/*
+ *  RSGISImageBlockPipeline.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2008 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISImageBlockPipeline.h"
+
+namespace rsgis{namespace img{
+
+    RSGISImageBlockPipeline::RSGISImageBlockPipeline(unsigned int numSlots)
+    {
+        // One slot per stage is needed for the stages to overlap.
+        this->numSlots = (numSlots < 3)?3:numSlots;
+        this->aborted = false;
+    }
+
+    void RSGISImageBlockPipeline::run(unsigned int nBlocks, BlockStage readBlock, BlockStage calcBlock, BlockStage writeBlock)
+    {
+        this->aborted = false;
+        this->error = nullptr;
+        this->freeSlots.clear();
+        this->readSlots.clear();
+        this->calcSlots.clear();
+        for(unsigned int s = 0; s < this->numSlots; ++s)
+        {
+            this->freeSlots.push_back(BlockSlot(0, s));
+        }
+
+        if(nBlocks == 0)
+        {
+            return;
+        }
+
+        std::thread reader([&]()
+        {
+            BlockSlot item;
+            for(unsigned int b = 0; b < nBlocks; ++b)
+            {
+                if(!this->pop(this->freeSlots, item))
+                {
+                    return;
+                }
+                item.first = b;
+                try
+                {
+                    readBlock(item.first, item.second);
+                }
+                catch(...)
+                {
+                    this->abort(std::current_exception());
+                    return;
+                }
+                this->push(this->readSlots, item);
+            }
+        });
+
+        std::thread writer([&]()
+        {
+            BlockSlot item;
+            for(unsigned int b = 0; b < nBlocks; ++b)
+            {
+                if(!this->pop(this->calcSlots, item))
+                {
+                    return;
+                }
+                try
+                {
+                    writeBlock(item.first, item.second);
+                }
+                catch(...)
+                {
+                    this->abort(std::current_exception());
+                    return;
+                }
+                this->push(this->freeSlots, item);
+            }
+        });
+
+        BlockSlot item;
+        for(unsigned int b = 0; b < nBlocks; ++b)
+        {
+            if(!this->pop(this->readSlots, item))
+            {
+                break;
+            }
+            try
+            {
+                calcBlock(item.first, item.second);
+            }
+            catch(...)
+            {
+                this->abort(std::current_exception());
+                break;
+            }
+            this->push(this->calcSlots, item);
+        }
+
+        reader.join();
+        writer.join();
+
+        if(this->error)
+        {
+            std::rethrow_exception(this->error);
+        }
+    }
+
+    bool RSGISImageBlockPipeline::pop(std::deque<BlockSlot> &queue, BlockSlot &item)
+    {
+        std::unique_lock<std::mutex> lock(this->queueMutex);
+        this->queueCond.wait(lock, [&]{ return this->aborted || !queue.empty(); });
+        if(this->aborted)
+        {
+            return false;
+        }
+        item = queue.front();
+        queue.pop_front();
+        return true;
+    }
+
+    void RSGISImageBlockPipeline::push(std::deque<BlockSlot> &queue, BlockSlot item)
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->queueMutex);
+            queue.push_back(item);
+        }
+        this->queueCond.notify_all();
+    }
+
+    void RSGISImageBlockPipeline::abort(std::exception_ptr error)
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->queueMutex);
+            if(!this->error)
+            {
+                this->error = error;
+            }
+            this->aborted = true;
+        }
+        this->queueCond.notify_all();
+    }
+
+}}
+
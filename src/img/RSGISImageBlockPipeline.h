@@ -0,0 +1,88 @@
+/*
+ *  RSGISImageBlockPipeline.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2008 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISImageBlockPipeline_H
+#define RSGISImageBlockPipeline_H
+
+#include <iostream>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_img_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace img{
+
+    /**
+     * Runs a read / calculate / write pipeline over a sequence of blocks.
+     * A reader thread prefetches block N+1 while block N is calculated on the
+     * calling thread and a writer thread flushes block N-1. Each stage works on
+     * a buffer slot (0 to numSlots-1) which is passed to the callbacks; slots
+     * are recycled once written so at most numSlots blocks are held at once.
+     *
+     * The read and write callbacks are called from different threads and so
+     * must not share a GDAL dataset.
+     */
+    class DllExport RSGISImageBlockPipeline
+    {
+    public:
+        typedef std::function<void(unsigned int block, unsigned int slot)> BlockStage;
+        RSGISImageBlockPipeline(unsigned int numSlots=3);
+        /**
+         * Process nBlocks blocks. Any exception thrown by a stage stops the
+         * pipeline and is rethrown on the calling thread.
+         */
+        void run(unsigned int nBlocks, BlockStage readBlock, BlockStage calcBlock, BlockStage writeBlock);
+        unsigned int getNumSlots(){return numSlots;};
+        ~RSGISImageBlockPipeline(){};
+    protected:
+        typedef std::pair<unsigned int, unsigned int> BlockSlot;
+        bool pop(std::deque<BlockSlot> &queue, BlockSlot &item);
+        void push(std::deque<BlockSlot> &queue, BlockSlot item);
+        void abort(std::exception_ptr error);
+        unsigned int numSlots;
+        std::mutex queueMutex;
+        std::condition_variable queueCond;
+        std::deque<BlockSlot> freeSlots;
+        std::deque<BlockSlot> readSlots;
+        std::deque<BlockSlot> calcSlots;
+        bool aborted;
+        std::exception_ptr error;
+    };
+
+}}
+
+#endif
+
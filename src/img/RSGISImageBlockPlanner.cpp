@@ -0,0 +1,183 @@
+/*
+ *  RSGISImageBlockPlanner.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISImageBlockPlanner.h"
+
+namespace rsgis{namespace img{
+
+    const size_t RSGISImageBlockPlanner::defaultMemoryBudget;
+    const size_t RSGISImageBlockPlanner::targetStripBytes;
+    const GIntBig RSGISImageBlockPlanner::minGDALCacheBytes;
+
+    RSGISImageBlockPlanner::RSGISImageBlockPlanner(size_t memoryBudget)
+    {
+        this->setMemoryBudget(memoryBudget);
+    }
+
+    void RSGISImageBlockPlanner::setMemoryBudget(size_t memoryBudget)
+    {
+        this->memoryBudget = defaultMemoryBudget;
+        this->budgetSet = false;
+        if(memoryBudget > 0)
+        {
+            this->memoryBudget = memoryBudget;
+            this->budgetSet = true;
+        }
+        else if(const char* env_p = std::getenv("RSGISLIB_CALC_MEM_MB"))
+        {
+            long envBudgetMB = atol(env_p);
+            if(envBudgetMB > 0)
+            {
+                this->memoryBudget = ((size_t)envBudgetMB) * 1024 * 1024;
+                this->budgetSet = true;
+            }
+        }
+    }
+
+    size_t RSGISImageBlockPlanner::getMemoryBudget()
+    {
+        return this->memoryBudget;
+    }
+
+    RSGISImageBlockPlan RSGISImageBlockPlanner::plan(int nativeRows, int width, int height, size_t bufferBytesPerPxl, unsigned int numBuffers, size_t nativeBytesPerPxl)
+    {
+        RSGISImageBlockPlan blockPlan;
+        blockPlan.rows = 1;
+        blockPlan.aligned = true;
+        blockPlan.gdalCacheBytes = 0;
+        if((width <= 0) || (height <= 0))
+        {
+            return blockPlan;
+        }
+        if(nativeRows < 1)
+        {
+            nativeRows = 1;
+        }
+        if(numBuffers < 1)
+        {
+            numBuffers = 1;
+        }
+        if(bufferBytesPerPxl < 1)
+        {
+            bufferBytesPerPxl = 1;
+        }
+        size_t bufferBytesPerRow = ((size_t)width) * bufferBytesPerPxl;
+
+        // Group short native blocks into strips of a useful size.
+        int rows = nativeRows;
+        size_t targetRows = (targetStripBytes + bufferBytesPerRow - 1) / bufferBytesPerRow;
+        if(((size_t)rows) < targetRows)
+        {
+            size_t nNativeBlocks = (targetRows + nativeRows - 1) / nativeRows;
+            rows = (int) std::min<size_t>(nNativeBlocks * nativeRows, (size_t)height);
+        }
+
+        // With multiple buffers (i.e., threads) keep enough blocks to share out.
+        if(numBuffers > 1)
+        {
+            int parallelRows = height / (2 * numBuffers);
+            if(rows > parallelRows)
+            {
+                rows = std::max(nativeRows, (parallelRows / nativeRows) * nativeRows);
+            }
+        }
+
+        // Stay within the memory budget, keeping to whole native blocks where possible.
+        size_t budgetRows = this->memoryBudget / (bufferBytesPerRow * numBuffers);
+        if(budgetRows < 1)
+        {
+            budgetRows = 1;
+        }
+        if(((size_t)rows) > budgetRows)
+        {
+            if(budgetRows >= ((size_t)nativeRows))
+            {
+                rows = (int)((budgetRows / nativeRows) * nativeRows);
+            }
+            else
+            {
+                rows = (int)budgetRows;
+            }
+        }
+
+        if(rows > height)
+        {
+            rows = height;
+        }
+        if(rows < 1)
+        {
+            rows = 1;
+        }
+        blockPlan.rows = rows;
+        blockPlan.aligned = ((rows % nativeRows) == 0) || (rows == height);
+
+        if(this->budgetSet && (nativeBytesPerPxl > 0))
+        {
+            GIntBig nativeBlockRowBytes = ((GIntBig)width) * nativeRows * ((GIntBig)nativeBytesPerPxl);
+            GIntBig currentCache = GDALGetCacheMax64();
+            if(blockPlan.aligned)
+            {
+                // Each native block is read once into the engine's buffers so
+                // GDAL only needs enough cache to stage a row of blocks.
+                GIntBig neededCache = std::max(nativeBlockRowBytes, minGDALCacheBytes);
+                if(neededCache < currentCache)
+                {
+                    blockPlan.gdalCacheBytes = neededCache;
+                }
+            }
+            else
+            {
+                // Partial blocks are read repeatedly so keep a row of native
+                // blocks cached, within the budget.
+                GIntBig neededCache = std::min(nativeBlockRowBytes, (GIntBig)this->memoryBudget);
+                if(neededCache > currentCache)
+                {
+                    blockPlan.gdalCacheBytes = neededCache;
+                }
+            }
+        }
+        return blockPlan;
+    }
+
+    RSGISGDALCacheScope::RSGISGDALCacheScope(GIntBig cacheBytes)
+    {
+        this->prevCacheBytes = 0;
+        this->changed = false;
+        if(cacheBytes > 0)
+        {
+            this->prevCacheBytes = GDALGetCacheMax64();
+            if(cacheBytes != this->prevCacheBytes)
+            {
+                GDALSetCacheMax64(cacheBytes);
+                this->changed = true;
+            }
+        }
+    }
+
+    RSGISGDALCacheScope::~RSGISGDALCacheScope()
+    {
+        if(this->changed)
+        {
+            GDALSetCacheMax64(this->prevCacheBytes);
+        }
+    }
+
+}}
@@ -0,0 +1,116 @@
+/*
+ *  RSGISImageBlockPlanner.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISImageBlockPlanner_H
+#define RSGISImageBlockPlanner_H
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+#include <stdint.h>
+
+#include "gdal_priv.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_img_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace img{
+
+    /**
+     * The number of rows to read per block and the GDAL block cache size
+     * (in bytes) to use while processing; a gdalCacheBytes of 0 leaves the
+     * GDAL cache unchanged.
+     */
+    struct DllExport RSGISImageBlockPlan
+    {
+        int rows;
+        bool aligned;
+        GIntBig gdalCacheBytes;
+    };
+
+    /**
+     * Chooses the number of rows read per block from a memory budget rather
+     * than only the native block height of the inputs. Strips of only a few
+     * rows (e.g., 1 row striped GeoTIFFs) are grouped into larger reads,
+     * while very tall blocks with many bands (e.g., 512 row KEA blocks) are
+     * split so the buffers stay within the budget.
+     *
+     * The budget (in bytes) covers all the buffers held by the engine and
+     * is read from the RSGISLIB_CALC_MEM_MB environment variable (in MB) if
+     * not set. Only when a budget has been given is the GDAL block cache
+     * adjusted: reduced when reads are aligned to the native blocks (the
+     * engine already holds the data) or increased, up to the budget, to
+     * hold one row of native blocks when they are not.
+     */
+    class DllExport RSGISImageBlockPlanner
+    {
+    public:
+        RSGISImageBlockPlanner(size_t memoryBudget=0);
+        /**
+         * Set the memory budget in bytes, 0 uses the RSGISLIB_CALC_MEM_MB
+         * environment variable or the default.
+         */
+        void setMemoryBudget(size_t memoryBudget);
+        size_t getMemoryBudget();
+        bool isBudgetSet(){return this->budgetSet;};
+        /**
+         * nativeRows is the native block height of the inputs and output,
+         * bufferBytesPerPxl the bytes the engine holds per pixel (over all
+         * bands) in each of its numBuffers buffers and nativeBytesPerPxl the
+         * bytes per pixel (over all bands) in the images' own data types.
+         */
+        RSGISImageBlockPlan plan(int nativeRows, int width, int height, size_t bufferBytesPerPxl, unsigned int numBuffers, size_t nativeBytesPerPxl);
+        static const size_t defaultMemoryBudget = 512 * 1024 * 1024;
+        static const size_t targetStripBytes = 16 * 1024 * 1024;
+        static const GIntBig minGDALCacheBytes = 16 * 1024 * 1024;
+    protected:
+        size_t memoryBudget;
+        bool budgetSet;
+    };
+
+    /**
+     * Sets the GDAL block cache size for its lifetime, restoring the
+     * previous value at the end of the scope. A size of 0 does nothing.
+     */
+    class DllExport RSGISGDALCacheScope
+    {
+    public:
+        RSGISGDALCacheScope(GIntBig cacheBytes);
+        ~RSGISGDALCacheScope();
+    protected:
+        GIntBig prevCacheBytes;
+        bool changed;
+    };
+
+}}
+
+#endif
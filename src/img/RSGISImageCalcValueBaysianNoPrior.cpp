@@ -35,11 +35,24 @@ namespace rsgis{namespace img{
 		this->lowerLimit = lowerLimit;
 		this->deltatype = deltatype;
 
+		statsTable = NULL;
 		baysianStats = new rsgis::math::RSGISBaysianStatsNoPrior(function, variance, interval, minVal, maxVal, lowerLimit, upperLimit, deltatype);
 	}
 	
 	void RSGISImageCalcValueBaysianNoPrior::calcImageValue(float *bandValues, int numBands, double *output) 
 	{				
+		if(statsTable != NULL)
+		{
+			double tableVals[3];
+			statsTable->getValues(bandValues[0], tableVals);
+			output[1] = tableVals[0]; // Maximum Likelyhood Value
+			output[0] = tableVals[1]; // Lower value
+			output[2] = tableVals[2]; // Upper value
+			output[3] = fabs(output[1] - output[0]);
+			output[4] = fabs(output[2] - output[1]);
+			return;
+		}
+		
 		outputVals = baysianStats->calcImageValueNoPrior(bandValues[0]);
 		
 		output[1] = outputVals[0]; // Maximum Likelyhood Value
@@ -78,9 +91,31 @@ namespace rsgis{namespace img{
 		throw RSGISImageCalcException("Not implemented");
 	}
 	
+	void RSGISImageCalcValueBaysianNoPrior::setTabulated(double tableMin, double tableMax, double tolerance)
+	{
+		if(statsTable != NULL)
+		{
+			delete statsTable;
+			statsTable = NULL;
+		}
+		rsgis::math::RSGISBaysianStatsNoPrior *stats = baysianStats;
+		try
+		{
+			statsTable = new rsgis::math::RSGISBaysianStatsTable([stats](float value){return stats->calcImageValueNoPrior(value);}, tableMin, tableMax, tolerance);
+		}
+		catch(rsgis::math::RSGISBaysianStatsException &e)
+		{
+			throw RSGISImageCalcException(e.what());
+		}
+	}
+	
 	RSGISImageCalcValueBaysianNoPrior::~RSGISImageCalcValueBaysianNoPrior()
 	{
 		delete baysianStats;
+		if(statsTable != NULL)
+		{
+			delete statsTable;
+		}
 	}
 }}
 
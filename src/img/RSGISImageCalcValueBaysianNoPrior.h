@@ -29,6 +29,7 @@
 #include "img/RSGISImageBandException.h"
 #include "img/RSGISImageCalcException.h"
 #include "math/RSGISBaysianStatsNoPrior.h"
+#include "math/RSGISBaysianStatsTable.h"
 #include "math/RSGISBaysianStatsException.h"
 #include "math/RSGISBaysianDeltaType.h"
 #include "common/RSGISImageException.h"
@@ -63,6 +64,14 @@ namespace rsgis{namespace img{
 			void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output);
             void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output, geos::geom::Envelope extent) {throw RSGISImageCalcException("No implemented");};
 			bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output);
+			/**
+			 * Tabulate the estimate for input values between tableMin and tableMax
+			 * (see rsgis::math::RSGISBaysianStatsTable) so each pixel is interpolated
+			 * from the table rather than integrated. The calculator is then thread
+			 * safe so the image can be processed by multiple threads.
+			 */
+			void setTabulated(double tableMin, double tableMax, double tolerance);
+			bool isThreadSafe(){return (this->statsTable != NULL);};
 			~RSGISImageCalcValueBaysianNoPrior();
 		protected:
 			rsgis::math::RSGISMathFunction *function;
@@ -76,6 +85,7 @@ namespace rsgis{namespace img{
 			double* outputVals;
 			rsgis::math::deltatypedef deltatype;
 			rsgis::math::RSGISBaysianStatsNoPrior *baysianStats;
+			rsgis::math::RSGISBaysianStatsTable *statsTable;
 		};	
 }}
 #endif
@@ -35,6 +35,7 @@ namespace rsgis{namespace img{
 		this->upperLimit = upperLimit;
 		this->lowerLimit = lowerLimit;
 		this->deltatype = deltatype;
+		statsTable = NULL;
 		baysianStats = new rsgis::math::RSGISBaysianStatsPrior(function, probDistro, variance, interval, minVal, maxVal, upperLimit, lowerLimit, deltatype);
 		std::cout << "Delta type " << deltatype << std::endl;
 	}
@@ -42,6 +43,18 @@ namespace rsgis{namespace img{
 	void RSGISImageCalcValueBaysianPrior::calcImageValue(float *bandValues, int numBands, double *output) 
 	{
 		
+		if(statsTable != NULL)
+		{
+			double tableVals[3];
+			statsTable->getValues(bandValues[0], tableVals);
+			output[1] = tableVals[0]; // Maximum Likelyhood Value
+			output[0] = tableVals[1]; // Lower value
+			output[2] = tableVals[2]; // Upper value
+			output[3] = fabs(output[1] - output[0]);
+			output[4] = fabs(output[2] - output[1]);
+			return;
+		}
+		
 		outputVals = baysianStats->calcImageValuePrior(bandValues[0]);
 		
 		output[1] = outputVals[0]; // Maximum Likelyhood Value
@@ -79,8 +92,30 @@ namespace rsgis{namespace img{
 		throw RSGISImageCalcException("Not implemented");
 	}
 	
+	void RSGISImageCalcValueBaysianPrior::setTabulated(double tableMin, double tableMax, double tolerance)
+	{
+		if(statsTable != NULL)
+		{
+			delete statsTable;
+			statsTable = NULL;
+		}
+		rsgis::math::RSGISBaysianStatsPrior *stats = baysianStats;
+		try
+		{
+			statsTable = new rsgis::math::RSGISBaysianStatsTable([stats](float value){return stats->calcImageValuePrior(value);}, tableMin, tableMax, tolerance);
+		}
+		catch(rsgis::math::RSGISBaysianStatsException &e)
+		{
+			throw RSGISImageCalcException(e.what());
+		}
+	}
+	
 	RSGISImageCalcValueBaysianPrior::~RSGISImageCalcValueBaysianPrior()
 	{
 		delete baysianStats;
+		if(statsTable != NULL)
+		{
+			delete statsTable;
+		}
 	}
 }}
@@ -31,17 +31,17 @@ namespace rsgis{namespace img{
         
     }
         
-    void RSGISImageClustering::findKMeansCentres(GDALDataset *dataset, std::string outputMatrix, unsigned int numClusters, unsigned int maxNumIterations, unsigned int subSample, bool ignoreZeros, float degreeOfChange, rsgis::math::InitClustererMethods initMethod)
+    void RSGISImageClustering::findKMeansCentres(GDALDataset *dataset, std::string outputMatrix, unsigned int numClusters, unsigned int maxNumIterations, unsigned int subSample, bool ignoreZeros, float degreeOfChange, rsgis::math::InitClustererMethods initMethod, unsigned int miniBatchSize)
     {
         try 
         {
             unsigned int numImgBands = dataset->GetRasterCount();
             std::cout << "Subsampling the image to read into memory\n";
-            std::vector< std::vector<float> > *pxlValues = this->sampleImage(dataset, subSample, ignoreZeros);
+            std::vector<float> *pxlValues = this->sampleImage(dataset, subSample, ignoreZeros);
             
             std::cout << "Performing clustering\n";
-            rsgis::math::RSGISKMeansClusterer clusterer(initMethod);
-            std::vector< rsgis::math::RSGISClusterCentre > *clusterCentres = clusterer.calcClusterCentres(pxlValues, numImgBands, numClusters, maxNumIterations, degreeOfChange);
+            rsgis::math::RSGISKMeansClusterer clusterer(initMethod, miniBatchSize);
+            std::vector< rsgis::math::RSGISClusterCentre > *clusterCentres = clusterer.calcClusterCentres(pxlValues->data(), pxlValues->size()/numImgBands, numImgBands, numClusters, maxNumIterations, degreeOfChange);
             
             std::cout << "Exporting cluster centres to output file\n";
             rsgis::math::RSGISMatrices matrixUtils;
@@ -77,11 +77,11 @@ namespace rsgis{namespace img{
         {
             unsigned int numImgBands = dataset->GetRasterCount();
             std::cout << "Subsampling the image to read into memory\n";
-            std::vector< std::vector<float> > *pxlValues = this->sampleImage(dataset, subSample, ignoreZeros);
+            std::vector<float> *pxlValues = this->sampleImage(dataset, subSample, ignoreZeros);
             
             std::cout << "Performing clustering\n";
             rsgis::math::RSGISISODataClusterer clusterer(initMethod, minDistBetweenClusters, minNumFeatures, maxStdDev, minNumClusters, startIteration, endIteration);
-            std::vector< rsgis::math::RSGISClusterCentre > *clusterCentres = clusterer.calcClusterCentres(pxlValues, dataset->GetRasterCount(), numClusters, maxNumIterations, degreeOfChange);
+            std::vector< rsgis::math::RSGISClusterCentre > *clusterCentres = clusterer.calcClusterCentres(pxlValues->data(), pxlValues->size()/numImgBands, numImgBands, numClusters, maxNumIterations, degreeOfChange);
             
             std::cout << "Exporting cluster centres to output file\n";
             rsgis::math::RSGISMatrices matrixUtils;
@@ -111,72 +111,114 @@ namespace rsgis{namespace img{
     }
     
     
-    std::vector< std::vector<float> >* RSGISImageClustering::sampleImage(GDALDataset *dataset, unsigned int subSample, bool ignoreZeros)
+    std::vector<float>* RSGISImageClustering::sampleImage(GDALDataset *dataset, unsigned int subSample, bool ignoreZeros)
     {
-        std::vector< std::vector<float> > *pxlValues = new std::vector< std::vector<float> >();
+        std::vector<float> *pxlValues = new std::vector<float>();
         
-        unsigned int numImgBands = dataset->GetRasterCount();
+        int numImgBands = dataset->GetRasterCount();
+        int width = dataset->GetRasterXSize();
+        int height = dataset->GetRasterYSize();
+        if((numImgBands == 0) || (width == 0) || (height == 0))
+        {
+            return pxlValues;
+        }
+        if(subSample == 0)
+        {
+            subSample = 1;
+        }
         
-        unsigned int width = dataset->GetRasterXSize();
-        unsigned int height = dataset->GetRasterYSize();
+        size_t numPxls = ((size_t)width) * height;
+        size_t capacity = (numPxls + subSample - 1) / subSample;
+        pxlValues->reserve(capacity * numImgBands);
         
-        float **dataRow = new float*[numImgBands];
-        GDALRasterBand **bands = new GDALRasterBand*[numImgBands];
-        for(unsigned n = 0; n < numImgBands; ++n)
+        // Reservoir sampling (Algorithm L, Li, 1994): once the reservoir is
+        // full the number of pixels to skip before the next replacement is
+        // drawn directly, so only the pixels which are kept use the generator.
+        std::mt19937 rng(numPxls);
+        std::uniform_real_distribution<double> uniDist(std::numeric_limits<double>::min(), 1.0);
+        std::uniform_int_distribution<size_t> slotDist(0, capacity-1);
+        double logW = 0;
+        size_t numSeen = 0;
+        size_t nextPxl = 0;
+        auto drawNext = [&]()
         {
-            bands[n] = dataset->GetRasterBand(n+1);
-            dataRow[n] = new float[width];
-        }
+            logW += log(uniDist(rng)) / capacity;
+            double skip = floor(log(uniDist(rng)) / log1p(-exp(logW)));
+            nextPxl = numSeen + ((skip < double(numPxls))?((size_t)skip):numPxls);
+        };
+        
+        RSGISImageBlockPipeline pipeline;
+        unsigned int numSlots = pipeline.getNumSlots();
+        int xBlockSize = 0;
+        int yBlockSize = 0;
+        dataset->GetRasterBand(1)->GetBlockSize(&xBlockSize, &yBlockSize);
+        RSGISImageBlockPlanner planner;
+        RSGISImageBlockPlan blockPlan = planner.plan(yBlockSize, width, height, numImgBands * sizeof(float), numSlots, numImgBands * (GDALGetDataTypeSize(dataset->GetRasterBand(1)->GetRasterDataType()) / 8));
+        int numRows = blockPlan.rows;
+        RSGISGDALCacheScope gdalCacheScope(blockPlan.gdalCacheBytes);
         
-        bool nonZeroFound = false;
-        unsigned long pxlCount = 0;
-        for(unsigned int i = 0; i < height; ++i)
+        unsigned int nBlocks = (height + numRows - 1) / numRows;
+        std::vector<std::vector<float> > blockBufs(numSlots, std::vector<float>(((size_t)width) * numRows * numImgBands));
+        auto blockLines = [&](unsigned int block){ return std::min(numRows, height - (int)(block * numRows)); };
+        
+        // The buffers are band sequential, so each band is a contiguous plane.
+        auto readBlock = [&](unsigned int block, unsigned int slot)
         {
-            for(unsigned n = 0; n < numImgBands; ++n)
+            int numLines = blockLines(block);
+            if(dataset->RasterIO(GF_Read, 0, block * numRows, width, numLines, blockBufs[slot].data(), width, numLines, GDT_Float32, numImgBands, NULL, 0, 0, 0) != CE_None)
             {
-                bands[n]->RasterIO(GF_Read, 0, i, width, 1, dataRow[n], width, 1, GDT_Float32, 0, 0);
+                throw rsgis::RSGISImageException("Could not read a block from the image.");
             }
-            
-            for(unsigned int j = 0; j < width; ++j)
+        };
+        
+        auto sampleBlock = [&](unsigned int block, unsigned int slot)
+        {
+            size_t numBlockPxls = ((size_t)width) * blockLines(block);
+            const float *buf = blockBufs[slot].data();
+            for(size_t i = 0; i < numBlockPxls; ++i)
             {
-                if((pxlCount % subSample) == 0)
+                if(ignoreZeros)
                 {
-                    nonZeroFound = false;
-                    std::vector<float> col;
-                    col.reserve(numImgBands);
-                    for(unsigned n = 0; n < numImgBands; ++n)
+                    bool nonZeroFound = false;
+                    for(int n = 0; n < numImgBands; ++n)
                     {
-                        col.push_back(dataRow[n][j]);
-                        if(dataRow[n][j] != 0)
-                        {
-                            nonZeroFound = true;
-                        }
+                        nonZeroFound |= (buf[(n * numBlockPxls) + i] != 0);
                     }
-                    
-                    if(ignoreZeros)
+                    if(!nonZeroFound)
                     {
-                        if(nonZeroFound)
-                        {
-                            pxlValues->push_back(col);
-                        }
+                        continue;
                     }
-                    else
+                }
+                
+                if(numSeen < capacity)
+                {
+                    for(int n = 0; n < numImgBands; ++n)
+                    {
+                        pxlValues->push_back(buf[(n * numBlockPxls) + i]);
+                    }
+                    if(++numSeen == capacity)
                     {
-                        pxlValues->push_back(col);
+                        drawNext();
                     }
+                    continue;
                 }
                 
-                ++pxlCount;
+                if(numSeen == nextPxl)
+                {
+                    float *row = &(*pxlValues)[slotDist(rng) * numImgBands];
+                    for(int n = 0; n < numImgBands; ++n)
+                    {
+                        row[n] = buf[(n * numBlockPxls) + i];
+                    }
+                    ++numSeen;
+                    drawNext();
+                    continue;
+                }
+                ++numSeen;
             }
-        }
-        
-        for(unsigned n = 0; n < numImgBands; ++n)
-        {
-            delete[] dataRow[n];
-        }
-        delete[] dataRow;
+        };
         
-        delete[] bands;
+        pipeline.run(nBlocks, readBlock, sampleBlock, [](unsigned int block, unsigned int slot){});
         
         return pxlValues;
     }
@@ -26,9 +26,16 @@
 #include <iostream>
 #include <string>
 #include <math.h>
+#include <vector>
+#include <random>
+#include <limits>
+#include <algorithm>
 
 #include "common/RSGISImageException.h"
 
+#include "img/RSGISImageBlockPipeline.h"
+#include "img/RSGISImageBlockPlanner.h"
+
 #include "math/RSGISClustering.h"
 #include "math/RSGISClustererException.h"
 #include "math/RSGISMatrices.h"
@@ -56,9 +63,19 @@ namespace rsgis{namespace img{
     {
     public:
         RSGISImageClustering();
-        void findKMeansCentres(GDALDataset *dataset, std::string outputMatrix, unsigned int numClusters, unsigned int maxNumIterations, unsigned int subSample, bool ignoreZeros, float degreeOfChange, rsgis::math::InitClustererMethods initMethod);
+        /**
+         * Find k-means cluster centres for a sample of the image pixels. If miniBatchSize
+         * is greater than 0 mini-batch k-means, with batches of that size, is used.
+         */
+        void findKMeansCentres(GDALDataset *dataset, std::string outputMatrix, unsigned int numClusters, unsigned int maxNumIterations, unsigned int subSample, bool ignoreZeros, float degreeOfChange, rsgis::math::InitClustererMethods initMethod, unsigned int miniBatchSize=0);
         void findISODataCentres(GDALDataset *dataset, std::string outputMatrix, unsigned int numClusters, unsigned int maxNumIterations, unsigned int subSample, bool ignoreZeros, float degreeOfChange, rsgis::math::InitClustererMethods initMethod, float minDistBetweenClusters, unsigned int minNumFeatures, float maxStdDev, unsigned int minNumClusters, unsigned int startIteration, unsigned int endIteration);
-        std::vector< std::vector<float> >* sampleImage(GDALDataset *dataset, unsigned int subSample, bool ignoreZeros);
+        /**
+         * A uniform random sample of up to (number of pixels / subSample) pixels
+         * of the image, as a row major matrix with a row of band values for each
+         * pixel. The image is read once, in blocks, into a reservoir (with a
+         * fixed seed) so only the sample is held in memory.
+         */
+        std::vector<float>* sampleImage(GDALDataset *dataset, unsigned int subSample, bool ignoreZeros);
         ~RSGISImageClustering();
     };
     
@@ -126,7 +126,7 @@ void RSGISImageComposite::calcImageValue(float *bandValues, int numBands, double
                     {
                         maxNDVI = ndviVal;
                         maxImgIdx = i;
-                        first = true;
+                        first = false;
                     }
                     else if(ndviVal > maxNDVI)
                     {
@@ -366,6 +366,300 @@ void RSGISImageComposite::calcImageValue(float *bandValues, int numBands, double
     
     
     
+    RSGISSelectionImageComposite::RSGISSelectionImageComposite()
+    {
+        this->refImg = NULL;
+        this->inputImgs = NULL;
+        this->numInImgs = 0;
+        this->width = 0;
+    }
+    
+    void RSGISSelectionImageComposite::createMaxNDVIComposite(GDALDataset **inputImgs, unsigned int numInImgs, unsigned int redBand, unsigned int nirBand, std::string outputImage, std::string gdalFormat, GDALDataType outDataType)
+    {
+        if((numInImgs > 0) && ((redBand < 1) || (nirBand < 1) || (redBand > inputImgs[0]->GetRasterCount()) || (nirBand > inputImgs[0]->GetRasterCount())))
+        {
+            throw RSGISImageCalcException("The red and NIR bands must be within the input images (band numbers start at 1).");
+        }
+        std::vector<float> maxNDVI;
+        std::vector<float> redNIRVals;
+        SelectImgFunc selectFunc = [this, redBand, nirBand, &maxNDVI, &redNIRVals](int yOff, int nRows, std::vector<int> *selImg)
+        {
+            size_t nPxls = ((size_t)this->width) * nRows;
+            maxNDVI.assign(nPxls, 0.0);
+            redNIRVals.resize(nPxls * 2);
+            float *redVals = redNIRVals.data();
+            float *nirVals = redNIRVals.data() + nPxls;
+            int bandMap[2] = {(int)redBand, (int)nirBand};
+            
+            // -1 marks pixels without a valid NDVI, which are given the first image.
+            selImg->assign(nPxls, -1);
+            for(unsigned int n = 0; n < this->numInImgs; ++n)
+            {
+                this->readImgBlock(n, 2, bandMap, yOff, nRows, redNIRVals.data());
+                for(size_t i = 0; i < nPxls; ++i)
+                {
+                    if((nirVals[i] != 0) & (redVals[i] != 0))
+                    {
+                        float ndviVal = (nirVals[i] - redVals[i]) / (nirVals[i] + redVals[i]);
+                        if(((*selImg)[i] < 0) || (ndviVal > maxNDVI[i]))
+                        {
+                            maxNDVI[i] = ndviVal;
+                            (*selImg)[i] = n;
+                        }
+                    }
+                }
+            }
+            for(size_t i = 0; i < nPxls; ++i)
+            {
+                if((*selImg)[i] < 0)
+                {
+                    (*selImg)[i] = 0;
+                }
+            }
+        };
+        this->createComposite(NULL, inputImgs, numInImgs, selectFunc, outputImage, gdalFormat, outDataType, 0.0);
+    }
+    
+    void RSGISSelectionImageComposite::createRefImgComposite(GDALDataset *refImg, GDALDataset **inputImgs, unsigned int numInImgs, std::string outputImage, std::string gdalFormat, GDALDataType outDataType, float outNoDataVal)
+    {
+        std::vector<int> refVals;
+        SelectImgFunc selectFunc = [this, &refVals](int yOff, int nRows, std::vector<int> *selImg)
+        {
+            this->readRefBlock(yOff, nRows, &refVals);
+            selImg->resize(refVals.size());
+            for(size_t i = 0; i < refVals.size(); ++i)
+            {
+                if(refVals[i] < 0)
+                {
+                    std::cerr << "Reference pixel = " << refVals[i] << std::endl;
+                    throw RSGISImageCalcException("Reference pixel values cannot be negative");
+                }
+                else if(((unsigned int)refVals[i]) > this->numInImgs)
+                {
+                    std::cerr << "Reference pixel = " << refVals[i] << std::endl;
+                    throw RSGISImageCalcException("Reference image is not within the stack.");
+                }
+                (*selImg)[i] = refVals[i] - 1;
+            }
+        };
+        this->createComposite(refImg, inputImgs, numInImgs, selectFunc, outputImage, gdalFormat, outDataType, outNoDataVal);
+    }
+    
+    void RSGISSelectionImageComposite::createTimeseriesFillComposite(GDALDataset *refImg, GDALDataset **inputImgs, unsigned int numInImgs, unsigned int *imgIdxLUT, unsigned int nLUT, std::string outputImage, std::string gdalFormat, GDALDataType outDataType)
+    {
+        std::vector<int> refVals;
+        SelectImgFunc selectFunc = [this, imgIdxLUT, nLUT, &refVals](int yOff, int nRows, std::vector<int> *selImg)
+        {
+            this->readRefBlock(yOff, nRows, &refVals);
+            selImg->resize(refVals.size());
+            for(size_t i = 0; i < refVals.size(); ++i)
+            {
+                unsigned int imgIdx = 0;
+                if(refVals[i] > 0)
+                {
+                    if(((unsigned int)refVals[i]) >= nLUT)
+                    {
+                        throw RSGISImageCalcException("LUT has incorrect valid.");
+                    }
+                    imgIdx = imgIdxLUT[refVals[i]];
+                    if((imgIdx >= nLUT) | (imgIdx > this->numInImgs))
+                    {
+                        throw RSGISImageCalcException("LUT has incorrect valid.");
+                    }
+                    if(imgIdx > 0)
+                    {
+                        imgIdx = imgIdx - 1;
+                    }
+                }
+                (*selImg)[i] = imgIdx;
+            }
+        };
+        this->createComposite(refImg, inputImgs, numInImgs, selectFunc, outputImage, gdalFormat, outDataType, 0.0);
+    }
+    
+    void RSGISSelectionImageComposite::createComposite(GDALDataset *refImg, GDALDataset **inputImgs, unsigned int numInImgs, SelectImgFunc selectFunc, std::string outputImage, std::string gdalFormat, GDALDataType outDataType, float outNoDataVal)
+    {
+        if(numInImgs == 0)
+        {
+            throw RSGISImageCalcException("No input images were provided for the composite.");
+        }
+        int nBands = inputImgs[0]->GetRasterCount();
+        for(unsigned int n = 1; n < numInImgs; ++n)
+        {
+            if(inputImgs[n]->GetRasterCount() != nBands)
+            {
+                throw RSGISImageCalcException("Input images have different number of image bands.");
+            }
+        }
+        if((refImg != NULL) && (refImg->GetRasterCount() != 1))
+        {
+            throw RSGISImageCalcException("The reference image should only have a single image band.");
+        }
+        
+        this->refImg = refImg;
+        this->inputImgs = inputImgs;
+        this->numInImgs = numInImgs;
+        
+        // The reference image is the last dataset so the offsets of the input
+        // images are indexed by the image.
+        unsigned int numDS = (refImg != NULL)?(numInImgs+1):numInImgs;
+        GDALDataset **datasets = new GDALDataset*[numDS];
+        int **dsOffsets = new int*[numDS];
+        for(unsigned int n = 0; n < numDS; ++n)
+        {
+            datasets[n] = (n < numInImgs)?inputImgs[n]:refImg;
+            dsOffsets[n] = new int[2];
+        }
+        
+        GDALDataset *outputImageDS = NULL;
+        try
+        {
+            RSGISImageUtils imgUtils;
+            double gdalTranslation[6];
+            int height = 0;
+            int xBlockSize = 0;
+            int yBlockSize = 0;
+            imgUtils.getImageOverlap(datasets, numDS, dsOffsets, &this->width, &height, gdalTranslation, &xBlockSize, &yBlockSize);
+            this->xOffsets.resize(numDS);
+            this->yOffsets.resize(numDS);
+            for(unsigned int n = 0; n < numDS; ++n)
+            {
+                this->xOffsets[n] = dsOffsets[n][0];
+                this->yOffsets[n] = dsOffsets[n][1];
+            }
+            if(yBlockSize < 1)
+            {
+                yBlockSize = 1;
+            }
+            
+            GDALDriver *gdalDriver = GetGDALDriverManager()->GetDriverByName(gdalFormat.c_str());
+            if(gdalDriver == NULL)
+            {
+                throw RSGISImageBandException("Requested GDAL driver does not exists..");
+            }
+            char **papszOptions = imgUtils.getGDALCreationOptionsForFormat(gdalFormat);
+            std::cout << "New image width = " << this->width << " height = " << height << " bands = " << nBands << std::endl;
+            RSGISDatasetCache::invalidate(outputImage);
+            outputImageDS = gdalDriver->Create(outputImage.c_str(), this->width, height, nBands, outDataType, papszOptions);
+            if(outputImageDS == NULL)
+            {
+                throw RSGISImageBandException("Output image could not be created. Check filepath.");
+            }
+            outputImageDS->SetGeoTransform(gdalTranslation);
+            outputImageDS->SetProjection(inputImgs[0]->GetProjectionRef());
+            
+            std::vector<int> selImg;
+            std::vector<unsigned char> imgUsed(numInImgs, 0);
+            std::vector<float> imgData;
+            std::vector<float> outData;
+            
+            rsgis_tqdm pbar;
+            for(int yOff = 0; yOff < height; yOff += yBlockSize)
+            {
+                pbar.progress(yOff, height);
+                int nRows = std::min(yBlockSize, height - yOff);
+                size_t nPxls = ((size_t)this->width) * nRows;
+                
+                selectFunc(yOff, nRows, &selImg);
+                
+                outData.assign(nPxls * nBands, outNoDataVal);
+                imgUsed.assign(numInImgs, 0);
+                for(size_t i = 0; i < nPxls; ++i)
+                {
+                    if(selImg[i] >= 0)
+                    {
+                        imgUsed[selImg[i]] = 1;
+                    }
+                }
+                
+                // Only the images selected within the block are read.
+                imgData.resize(nPxls * nBands);
+                for(unsigned int n = 0; n < numInImgs; ++n)
+                {
+                    if(imgUsed[n] == 0)
+                    {
+                        continue;
+                    }
+                    this->readImgBlock(n, nBands, NULL, yOff, nRows, imgData.data());
+                    for(size_t i = 0; i < nPxls; ++i)
+                    {
+                        if(selImg[i] == ((int)n))
+                        {
+                            for(int b = 0; b < nBands; ++b)
+                            {
+                                outData[(b * nPxls) + i] = imgData[(b * nPxls) + i];
+                            }
+                        }
+                    }
+                }
+                
+                if(outputImageDS->RasterIO(GF_Write, 0, yOff, this->width, nRows, outData.data(), this->width, nRows, GDT_Float32, nBands, NULL, 0, 0, 0) != CE_None)
+                {
+                    throw RSGISImageBandException("Could not write the composite image block.");
+                }
+            }
+            pbar.finish();
+        }
+        catch(RSGISImageCalcException &e)
+        {
+            if(outputImageDS != NULL)
+            {
+                GDALClose(outputImageDS);
+            }
+            for(unsigned int n = 0; n < numDS; ++n)
+            {
+                delete[] dsOffsets[n];
+            }
+            delete[] dsOffsets;
+            delete[] datasets;
+            throw e;
+        }
+        catch(RSGISImageException &e)
+        {
+            if(outputImageDS != NULL)
+            {
+                GDALClose(outputImageDS);
+            }
+            for(unsigned int n = 0; n < numDS; ++n)
+            {
+                delete[] dsOffsets[n];
+            }
+            delete[] dsOffsets;
+            delete[] datasets;
+            throw RSGISImageCalcException(e.what());
+        }
+        
+        GDALClose(outputImageDS);
+        for(unsigned int n = 0; n < numDS; ++n)
+        {
+            delete[] dsOffsets[n];
+        }
+        delete[] dsOffsets;
+        delete[] datasets;
+    }
+    
+    void RSGISSelectionImageComposite::readRefBlock(int yOff, int nRows, std::vector<int> *refVals)
+    {
+        refVals->resize(((size_t)this->width) * nRows);
+        if(this->refImg->GetRasterBand(1)->RasterIO(GF_Read, this->xOffsets[this->numInImgs], this->yOffsets[this->numInImgs] + yOff, this->width, nRows, refVals->data(), this->width, nRows, GDT_Int32, 0, 0) != CE_None)
+        {
+            throw RSGISImageCalcException("Could not read the reference image block.");
+        }
+    }
+    
+    void RSGISSelectionImageComposite::readImgBlock(unsigned int img, int nBands, int *bandMap, int yOff, int nRows, float *data)
+    {
+        if(this->inputImgs[img]->RasterIO(GF_Read, this->xOffsets[img], this->yOffsets[img] + yOff, this->width, nRows, data, this->width, nRows, GDT_Float32, nBands, bandMap, 0, 0, 0) != CE_None)
+        {
+            throw RSGISImageCalcException("Could not read the input image block.");
+        }
+    }
+    
+    RSGISSelectionImageComposite::~RSGISSelectionImageComposite()
+    {
+        
+    }
+    
     RSGISCombineImgBands2SingleBand::RSGISCombineImgBands2SingleBand(double noDataVal) : RSGISCalcImageValue(1)
     {
         this->noDataVal = noDataVal;
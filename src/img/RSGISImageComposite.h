@@ -22,6 +22,8 @@
  */
 
 #include <math.h>
+#include <vector>
+#include <functional>
 
 #include "common/RSGISException.h"
 #include "common/RSGISImageException.h"
@@ -29,6 +31,7 @@
 
 #include "img/RSGISCalcImage.h"
 #include "img/RSGISCalcImageValue.h"
+#include "img/RSGISImageUtils.h"
 
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
@@ -229,6 +232,62 @@ namespace rsgis { namespace img {
     };
     
     
+    /**
+     * Creates composites where each output pixel is copied from a single image
+     * within a stack (e.g., the date with the maximum NDVI or the date given
+     * by a reference image) without stacking every band of every image for
+     * each pixel.
+     *
+     * For each block of rows the input image to be used for every pixel is
+     * selected first, reading only the bands needed for the selection (the
+     * reference image, or the red and NIR bands one date at a time). Only the
+     * images selected by at least one pixel within the block are then read
+     * and only their values written to the output, so dates which are not
+     * used within a block are never read.
+     *
+     * The output has the extent of the overlap of all the images and the same
+     * number of bands as the input images, which must all have the same number
+     * of bands.
+     */
+    class DllExport RSGISSelectionImageComposite
+    {
+    public:
+        RSGISSelectionImageComposite();
+        /**
+         * For each pixel, the image with the maximum NDVI (bands numbered from 1),
+         * only using images where both the red and NIR values are not 0. Where
+         * no image has a valid NDVI the first image is used.
+         */
+        void createMaxNDVIComposite(GDALDataset **inputImgs, unsigned int numInImgs, unsigned int redBand, unsigned int nirBand, std::string outputImage, std::string gdalFormat, GDALDataType outDataType);
+        /**
+         * The single band reference image gives the image (numbered from 1) to be
+         * used for each pixel, where 0 is outputted as outNoDataVal.
+         */
+        void createRefImgComposite(GDALDataset *refImg, GDALDataset **inputImgs, unsigned int numInImgs, std::string outputImage, std::string gdalFormat, GDALDataType outDataType, float outNoDataVal);
+        /**
+         * The reference image values are converted to an image (numbered from 1)
+         * with imgIdxLUT (as RSGISTimeseriesFillImgImageComposite), with the
+         * first image used where the reference is 0 or the LUT gives 0.
+         */
+        void createTimeseriesFillComposite(GDALDataset *refImg, GDALDataset **inputImgs, unsigned int numInImgs, unsigned int *imgIdxLUT, unsigned int nLUT, std::string outputImage, std::string gdalFormat, GDALDataType outDataType);
+        ~RSGISSelectionImageComposite();
+    protected:
+        /**
+         * Fill selImg with the input image (from 0) to be used for each pixel of
+         * the block of rows, or -1 for no data.
+         */
+        typedef std::function<void(int yOff, int nRows, std::vector<int> *selImg)> SelectImgFunc;
+        void createComposite(GDALDataset *refImg, GDALDataset **inputImgs, unsigned int numInImgs, SelectImgFunc selectFunc, std::string outputImage, std::string gdalFormat, GDALDataType outDataType, float outNoDataVal);
+        void readRefBlock(int yOff, int nRows, std::vector<int> *refVals);
+        void readImgBlock(unsigned int img, int nBands, int *bandMap, int yOff, int nRows, float *data);
+        GDALDataset *refImg;
+        GDALDataset **inputImgs;
+        unsigned int numInImgs;
+        std::vector<int> xOffsets;
+        std::vector<int> yOffsets;
+        int width;
+    };
+    
     class DllExport RSGISCombineImgBands2SingleBand : public RSGISCalcImageValue
     {
     public:
@@ -0,0 +1,328 @@
+/*
+ *  RSGISImageFootprintIndex.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISImageFootprintIndex.h"
+
+namespace rsgis{namespace img{
+
+    static const char footprintIndexMagic[8] = {'R', 'S', 'G', 'F', 'P', 'I', '0', '1'};
+
+    RSGISImageFootprintIndex::RSGISImageFootprintIndex()
+    {
+        this->projWKT = "";
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+
+    void RSGISImageFootprintIndex::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+
+    bool RSGISImageFootprintIndex::readFootprint(std::string image, RSGISImageFootprint *footprint, std::string *projWKT, std::string *error)
+    {
+        GDALDataset *dataset = (GDALDataset *) GDALOpen(image.c_str(), GA_ReadOnly);
+        if(dataset == NULL)
+        {
+            *error = "Could not open image " + image;
+            return false;
+        }
+        double trans[6];
+        bool hasTrans = (dataset->GetGeoTransform(trans) == CE_None);
+        const char *wkt = dataset->GetProjectionRef();
+        *projWKT = (wkt == NULL)?"":std::string(wkt);
+        double width = dataset->GetRasterXSize();
+        double height = dataset->GetRasterYSize();
+        GDALClose(dataset);
+        if((!hasTrans) || ((*projWKT) == ""))
+        {
+            *error = "The image does not have a projection: " + image;
+            return false;
+        }
+
+        // The corners are used so rotated images are covered.
+        double cornerX[4] = {0, width, 0, width};
+        double cornerY[4] = {0, 0, height, height};
+        footprint->image = image;
+        for(int c = 0; c < 4; ++c)
+        {
+            double x = trans[0] + (cornerX[c] * trans[1]) + (cornerY[c] * trans[2]);
+            double y = trans[3] + (cornerX[c] * trans[4]) + (cornerY[c] * trans[5]);
+            footprint->minX = (c == 0)?x:std::min(footprint->minX, x);
+            footprint->maxX = (c == 0)?x:std::max(footprint->maxX, x);
+            footprint->minY = (c == 0)?y:std::min(footprint->minY, y);
+            footprint->maxY = (c == 0)?y:std::max(footprint->maxY, y);
+        }
+        return true;
+    }
+
+    void RSGISImageFootprintIndex::addImages(const std::vector<std::string> &images, bool ignoreFailed)
+    {
+        GDALAllRegister();
+        size_t numImgs = images.size();
+        std::vector<RSGISImageFootprint> imgFootprints(numImgs);
+        std::vector<std::string> imgProjs(numImgs);
+        std::vector<std::string> imgErrors(numImgs);
+        std::vector<char> imgValid(numImgs, 0);
+
+        // Only the headers are read, so the threads mostly wait on the file system.
+        rsgis::utils::parallelFor(numImgs, this->numThreads, [&](size_t i, unsigned int)
+        {
+            imgValid[i] = this->readFootprint(images[i], &imgFootprints[i], &imgProjs[i], &imgErrors[i]);
+        });
+
+        OGRSpatialReference indexSpatRef;
+        std::string refImage = "";
+        if(this->projWKT != "")
+        {
+            indexSpatRef.importFromWkt(this->projWKT.c_str());
+        }
+        std::vector<RSGISImageFootprint> added;
+        for(size_t i = 0; i < numImgs; ++i)
+        {
+            if(imgValid[i] && (this->projWKT == ""))
+            {
+                this->projWKT = imgProjs[i];
+                refImage = images[i];
+                indexSpatRef.importFromWkt(this->projWKT.c_str());
+            }
+            else if(imgValid[i] && (imgProjs[i] != this->projWKT))
+            {
+                OGRSpatialReference imgSpatRef;
+                imgSpatRef.importFromWkt(imgProjs[i].c_str());
+                if(!imgSpatRef.IsSame(&indexSpatRef))
+                {
+                    throw RSGISImageException("The projection of " + images[i] + " does not match the index" + ((refImage == "")?std::string("."):(" (from " + refImage + ").")));
+                }
+            }
+
+            if(imgValid[i])
+            {
+                added.push_back(imgFootprints[i]);
+            }
+            else if(ignoreFailed)
+            {
+                std::cerr << "Ignoring: " << imgErrors[i] << std::endl;
+            }
+            else
+            {
+                throw RSGISImageException(imgErrors[i]);
+            }
+        }
+        this->footprints.insert(this->footprints.end(), added.begin(), added.end());
+        this->buildTree();
+    }
+
+    void RSGISImageFootprintIndex::save(std::string indexFile)
+    {
+        std::ofstream indexStream(indexFile.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if(!indexStream.is_open())
+        {
+            throw RSGISImageException("Could not create the footprint index " + indexFile);
+        }
+        uint64_t numImgs = this->footprints.size();
+        uint32_t projLen = this->projWKT.size();
+        indexStream.write(footprintIndexMagic, 8);
+        indexStream.write((const char *) &numImgs, sizeof(uint64_t));
+        indexStream.write((const char *) &projLen, sizeof(uint32_t));
+        indexStream.write(this->projWKT.data(), projLen);
+        for(std::vector<RSGISImageFootprint>::iterator iterFP = this->footprints.begin(); iterFP != this->footprints.end(); ++iterFP)
+        {
+            double bbox[4] = {iterFP->minX, iterFP->maxX, iterFP->minY, iterFP->maxY};
+            uint32_t pathLen = iterFP->image.size();
+            indexStream.write((const char *) bbox, sizeof(double) * 4);
+            indexStream.write((const char *) &pathLen, sizeof(uint32_t));
+            indexStream.write(iterFP->image.data(), pathLen);
+        }
+        indexStream.close();
+        if(indexStream.fail())
+        {
+            throw RSGISImageException("Could not write the footprint index " + indexFile);
+        }
+    }
+
+    void RSGISImageFootprintIndex::load(std::string indexFile)
+    {
+        std::ifstream indexStream(indexFile.c_str(), std::ios::in | std::ios::binary);
+        if(!indexStream.is_open())
+        {
+            throw RSGISImageException("Could not open the footprint index " + indexFile);
+        }
+        indexStream.seekg(0, std::ios::end);
+        uint64_t fileSize = indexStream.tellg();
+        indexStream.seekg(0, std::ios::beg);
+
+        char magic[8];
+        uint64_t numImgs = 0;
+        uint32_t projLen = 0;
+        indexStream.read(magic, 8);
+        indexStream.read((char *) &numImgs, sizeof(uint64_t));
+        indexStream.read((char *) &projLen, sizeof(uint32_t));
+        // Each footprint takes at least its box and path length.
+        if((!indexStream) || (memcmp(magic, footprintIndexMagic, 8) != 0) || (projLen > fileSize) || (numImgs > (fileSize / ((sizeof(double) * 4) + sizeof(uint32_t)))))
+        {
+            throw RSGISImageException("The file is not a footprint index: " + indexFile);
+        }
+        std::string proj(projLen, '\0');
+        indexStream.read(&proj[0], projLen);
+
+        std::vector<RSGISImageFootprint> fileFootprints(numImgs);
+        for(uint64_t i = 0; i < numImgs; ++i)
+        {
+            double bbox[4];
+            uint32_t pathLen = 0;
+            indexStream.read((char *) bbox, sizeof(double) * 4);
+            indexStream.read((char *) &pathLen, sizeof(uint32_t));
+            if((!indexStream) || (pathLen > fileSize))
+            {
+                throw RSGISImageException("The footprint index is truncated: " + indexFile);
+            }
+            RSGISImageFootprint &footprint = fileFootprints[i];
+            footprint.minX = bbox[0];
+            footprint.maxX = bbox[1];
+            footprint.minY = bbox[2];
+            footprint.maxY = bbox[3];
+            footprint.image.resize(pathLen);
+            indexStream.read(&footprint.image[0], pathLen);
+        }
+        if(!indexStream)
+        {
+            throw RSGISImageException("The footprint index is truncated: " + indexFile);
+        }
+        this->projWKT = proj;
+        this->footprints.swap(fileFootprints);
+        this->buildTree();
+    }
+
+    void RSGISImageFootprintIndex::buildTree()
+    {
+        // The tree holds pointers to the envelopes and indexes, so they are only filled once.
+        this->tree.reset(new geos::index::strtree::STRtree());
+        this->envs.clear();
+        this->envs.reserve(this->footprints.size());
+        this->envIdxs.resize(this->footprints.size());
+        for(size_t i = 0; i < this->footprints.size(); ++i)
+        {
+            const RSGISImageFootprint &footprint = this->footprints[i];
+            this->envs.push_back(geos::geom::Envelope(footprint.minX, footprint.maxX, footprint.minY, footprint.maxY));
+            this->envIdxs[i] = i;
+        }
+        for(size_t i = 0; i < this->envs.size(); ++i)
+        {
+            this->tree->insert(&this->envs[i], &this->envIdxs[i]);
+        }
+        // The tree is bulk loaded by the first query, which is done here so
+        // later queries (possibly from several threads) only read it.
+        geos::geom::Envelope emptyEnv;
+        std::vector<void*> found;
+        this->tree->query(&emptyEnv, found);
+    }
+
+    std::vector<size_t> RSGISImageFootprintIndex::query(const geos::geom::Envelope &env)
+    {
+        std::vector<size_t> idxs;
+        if(this->tree.get() == NULL)
+        {
+            return idxs;
+        }
+        std::vector<void*> found;
+        this->tree->query(&env, found);
+        for(std::vector<void*>::iterator iterFound = found.begin(); iterFound != found.end(); ++iterFound)
+        {
+            idxs.push_back(*((size_t*)(*iterFound)));
+        }
+        std::sort(idxs.begin(), idxs.end());
+        return idxs;
+    }
+
+    std::vector<std::string> RSGISImageFootprintIndex::queryEnvelope(double minX, double maxX, double minY, double maxY)
+    {
+        geos::geom::Envelope env(minX, maxX, minY, maxY);
+        std::vector<size_t> idxs = this->query(env);
+        std::vector<std::string> images;
+        for(std::vector<size_t>::iterator iterIdx = idxs.begin(); iterIdx != idxs.end(); ++iterIdx)
+        {
+            if(this->envs[*iterIdx].intersects(&env))
+            {
+                images.push_back(this->footprints[*iterIdx].image);
+            }
+        }
+        return images;
+    }
+
+    std::vector<std::string> RSGISImageFootprintIndex::queryPoint(double x, double y)
+    {
+        geos::geom::Envelope env(x, x, y, y);
+        std::vector<size_t> idxs = this->query(env);
+        std::vector<std::string> images;
+        for(std::vector<size_t>::iterator iterIdx = idxs.begin(); iterIdx != idxs.end(); ++iterIdx)
+        {
+            if(this->envs[*iterIdx].contains(x, y))
+            {
+                images.push_back(this->footprints[*iterIdx].image);
+            }
+        }
+        return images;
+    }
+
+    std::shared_ptr<RSGISImageFootprintIndex> RSGISImageFootprintIndex::openIndex(std::string indexFile)
+    {
+        struct CachedIndex
+        {
+            int64_t lastWrite;
+            uint64_t fileSize;
+            std::shared_ptr<RSGISImageFootprintIndex> index;
+        };
+        static std::mutex cacheMutex;
+        static std::map<std::string, CachedIndex> cache;
+
+        boost::system::error_code ec;
+        boost::filesystem::path indexPath(indexFile);
+        uint64_t fileSize = boost::filesystem::file_size(indexPath, ec);
+        int64_t lastWrite = ec?0:boost::filesystem::last_write_time(indexPath, ec);
+        if(ec)
+        {
+            throw RSGISImageException("Could not open the footprint index " + indexFile);
+        }
+
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        std::map<std::string, CachedIndex>::iterator iterCache = cache.find(indexFile);
+        if((iterCache != cache.end()) && (iterCache->second.lastWrite == lastWrite) && (iterCache->second.fileSize == fileSize))
+        {
+            return iterCache->second.index;
+        }
+        std::shared_ptr<RSGISImageFootprintIndex> index(new RSGISImageFootprintIndex());
+        index->load(indexFile);
+        CachedIndex cached;
+        cached.lastWrite = lastWrite;
+        cached.fileSize = fileSize;
+        cached.index = index;
+        cache[indexFile] = cached;
+        return index;
+    }
+
+    RSGISImageFootprintIndex::~RSGISImageFootprintIndex()
+    {
+
+    }
+
+}}
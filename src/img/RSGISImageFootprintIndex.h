@@ -0,0 +1,139 @@
+/*
+ *  RSGISImageFootprintIndex.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISImageFootprintIndex_H
+#define RSGISImageFootprintIndex_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+
+#include <boost/filesystem.hpp>
+
+#include "gdal_priv.h"
+#include "ogrsf_frmts.h"
+
+#include "common/RSGISImageException.h"
+#include "common/RSGISParallel.h"
+
+#include "geos/geom/Envelope.h"
+#include "geos/index/strtree/STRtree.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_img_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace img{
+
+    /**
+     * The bounding box of an image (in the projection of the index).
+     */
+    struct DllExport RSGISImageFootprint
+    {
+        std::string image;
+        double minX;
+        double maxX;
+        double minY;
+        double maxY;
+    };
+
+    /**
+     * A spatial index (STR tree) of the bounding boxes of a set of images,
+     * for finding the images which overlap an area (e.g., to select the
+     * inputs of a mosaic or composite) without opening each of them.
+     *
+     * The footprints are read from the image headers by several threads
+     * (setNumThreads, default RSGISLIB_NUM_THREADS) and saved to a compact
+     * binary file (a header with the projection, then the bounding box and
+     * path of each image) from which the tree is bulk loaded. All the images
+     * must have the same projection. Indexes opened with openIndex are kept
+     * in memory (until the file changes) so repeated queries do not re-read
+     * the file.
+     */
+    class DllExport RSGISImageFootprintIndex
+    {
+    public:
+        RSGISImageFootprintIndex();
+        void setNumThreads(unsigned int numThreads);
+        /**
+         * Add the footprints of the images. Images which cannot be opened or
+         * have no projection throw a RSGISImageException unless ignoreFailed,
+         * in which case they are left out (and listed on the console).
+         */
+        void addImages(const std::vector<std::string> &images, bool ignoreFailed=false);
+        void save(std::string indexFile);
+        void load(std::string indexFile);
+        /**
+         * The images whose footprints intersect the envelope, in the order
+         * they were added.
+         */
+        std::vector<std::string> queryEnvelope(double minX, double maxX, double minY, double maxY);
+        /**
+         * The images whose footprints contain the point, in the order they
+         * were added.
+         */
+        std::vector<std::string> queryPoint(double x, double y);
+        size_t getNumImages(){return this->footprints.size();};
+        const RSGISImageFootprint& getFootprint(size_t idx){return this->footprints.at(idx);};
+        std::string getProjection(){return this->projWKT;};
+        /**
+         * The index saved in indexFile, shared with the other callers until
+         * the file is modified.
+         */
+        static std::shared_ptr<RSGISImageFootprintIndex> openIndex(std::string indexFile);
+        ~RSGISImageFootprintIndex();
+    protected:
+        bool readFootprint(std::string image, RSGISImageFootprint *footprint, std::string *projWKT, std::string *error);
+        std::vector<size_t> query(const geos::geom::Envelope &env);
+        void buildTree();
+        std::vector<RSGISImageFootprint> footprints;
+        std::vector<geos::geom::Envelope> envs;
+        std::vector<size_t> envIdxs;
+        std::unique_ptr<geos::index::strtree::STRtree> tree;
+        std::string projWKT;
+        unsigned int numThreads;
+    };
+
+}}
+
+#endif
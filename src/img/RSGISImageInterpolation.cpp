@@ -34,21 +34,12 @@ namespace rsgis{namespace img{
 															  double outputYResolution, 
 															  std::string filename)
 	{
-		// Image Data Stores.
-		float *scanline0 = NULL;
-		float *scanline1 = NULL;
-		float *scanline2 = NULL;
-		double *transformation = NULL;
-		float *newLine = NULL;
-		double *pixels = NULL;
 		GDALDriver *poDriver = NULL;
-		GDALRasterBand *outputRasterBand = NULL;
-		GDALRasterBand *rasterband = NULL;
 		try
 		{
 			GDALDataset *output;
 			/********************** Calculate Scaling *************************/
-			transformation = new double[6];
+			double transformation[6];
 			data->GetGeoTransform(transformation);	
 			
 			int dataXSize = data->GetRasterXSize();
@@ -81,200 +72,11 @@ namespace rsgis{namespace img{
 			output->SetGeoTransform(transformation);
 			output->SetProjection(data->GetProjectionRef());
 			
-			
-			scanline0 = (float *) CPLMalloc(sizeof(float)*dataXSize);
-			scanline1 = (float *) CPLMalloc(sizeof(float)*dataXSize);
-			scanline2 = (float *) CPLMalloc(sizeof(float)*dataXSize);
-			
-			newLine = (float *)CPLMalloc(sizeof(float)*xSize);
-			pixels = new double[9];
-			
-			int column = 0;
-			int row = 0;
-			double xShift = 0;
-			double yShift = 0;
-						
 			for(int n = 1; n <= bands; n++)
 			{
 				std::cout << "Interpolating band "  << n << ".." << std::endl;
-				outputRasterBand = output->GetRasterBand(n);
-				rasterband = data->GetRasterBand(n);
-				
-				int feedback = ySize/10;
-				int feedbackCounter = 0;
 				std::cout << "Started " << std::flush;
-				for( int i = 0; i < ySize; i++)
-				{
-					if((ySize > 10) && (i % feedback) == 0)
-					{
-						std::cout << ".." << feedbackCounter << ".." << std::flush;
-						feedbackCounter = feedbackCounter + 10;
-					}
-					
-					
-					yShift = this->findFloatingPointComponent(((i*outputYResolution)/inputYResolution),
-															  &row);
-					if(row == 0)
-					{
-						rasterband->RasterIO(GF_Read, 
-											 0, 
-											 row, 
-											 dataXSize, 
-											 1, 
-											 scanline0, 
-											 dataXSize, 
-											 1, 
-											 GDT_Float32, 
-											 0, 
-											 0);
-						rasterband->RasterIO(GF_Read, 
-											 0, 
-											 row, 
-											 dataXSize, 
-											 1, 
-											 scanline1, 
-											 dataXSize, 
-											 1, 
-											 GDT_Float32, 
-											 0, 
-											 0);
-						rasterband->RasterIO(GF_Read, 
-											 0, 
-											 row+1, 
-											 dataXSize, 
-											 1, 
-											 scanline2, 
-											 dataXSize, 
-											 1, 
-											 GDT_Float32, 
-											 0, 
-											 0);
-					}
-					else if(row == (dataYSize-1))
-					{
-						rasterband->RasterIO(GF_Read, 
-											 0, 
-											 row-1, 
-											 dataXSize, 
-											 1, 
-											 scanline0, 
-											 dataXSize, 
-											 1, 
-											 GDT_Float32, 
-											 0, 
-											 0);
-						rasterband->RasterIO(GF_Read, 
-											 0, 
-											 row, 
-											 dataXSize, 
-											 1, 
-											 scanline1, 
-											 dataXSize, 
-											 1, 
-											 GDT_Float32, 
-											 0, 
-											 0);
-						rasterband->RasterIO(GF_Read, 
-											 0, 
-											 row, 
-											 dataXSize, 
-											 1, 
-											 scanline2, 
-											 dataXSize, 
-											 1, 
-											 GDT_Float32, 
-											 0, 
-											 0);
-					}
-					else
-					{
-						rasterband->RasterIO(GF_Read, 
-											 0, 
-											 row-1, 
-											 dataXSize, 
-											 1, 
-											 scanline0, 
-											 dataXSize, 
-											 1, 
-											 GDT_Float32, 
-											 0, 
-											 0);
-						rasterband->RasterIO(GF_Read, 
-											 0, 
-											 row, 
-											 dataXSize, 
-											 1, 
-											 scanline1, 
-											 dataXSize, 
-											 1, 
-											 GDT_Float32, 
-											 0, 
-											 0);
-						rasterband->RasterIO(GF_Read, 
-											 0, 
-											 row+1, 
-											 dataXSize, 
-											 1, 
-											 scanline2, 
-											 dataXSize, 
-											 1, 
-											 GDT_Float32, 
-											 0, 
-											 0);
-					}
-					for(int j = 0; j < xSize; j++)
-					{
-						xShift = this->findFloatingPointComponent(((j*outputXResolution)/inputXResolution), 
-																  &column);
-						if(column == 0)
-						{
-							//Column 1
-							pixels[0] = scanline0[column];
-							pixels[3] = scanline1[column];
-							pixels[6] = scanline2[column];
-							//Column 2
-							pixels[1] = scanline0[column];
-							pixels[4] = scanline1[column];
-							pixels[7] = scanline2[column];
-							//Column 1
-							pixels[2] = scanline0[column+1];
-							pixels[5] = scanline1[column+1];
-							pixels[8] = scanline2[column+1];
-						}
-						else if(column == (dataXSize-1))
-						{
-							//Column 1
-							pixels[0] = scanline0[column-1];
-							pixels[3] = scanline1[column-1];
-							pixels[6] = scanline2[column-1];
-							//Column 2
-							pixels[1] = scanline0[column];
-							pixels[4] = scanline1[column];
-							pixels[7] = scanline2[column];
-							//Column 1
-							pixels[2] = scanline0[column];
-							pixels[5] = scanline1[column];
-							pixels[8] = scanline2[column];
-						}
-						else
-						{
-							//Column 1
-							pixels[0] = scanline0[column-1];
-							pixels[3] = scanline1[column-1];
-							pixels[6] = scanline2[column-1];
-							//Column 2
-							pixels[1] = scanline0[column];
-							pixels[4] = scanline1[column];
-							pixels[7] = scanline2[column];
-							//Column 1
-							pixels[2] = scanline0[column+1];
-							pixels[5] = scanline1[column+1];
-							pixels[8] = scanline2[column+1];
-						}
-						newLine[j] = interpolator->interpolate(xShift,yShift,pixels);
-					}
-					outputRasterBand->RasterIO(GF_Write, 0, i, xSize, 1, newLine, xSize, 1, GDT_Float32, 0, 0);
-				}
+				this->interpolateBand(data->GetRasterBand(n), output->GetRasterBand(n), dataXSize, dataYSize, xSize, ySize, inputXResolution, inputYResolution, outputXResolution, outputYResolution);
 				std::cout << " Completed\n";
 			}
 			GDALClose(output);
@@ -282,85 +84,12 @@ namespace rsgis{namespace img{
 		}
 		catch(rsgis::RSGISFileException &e)
 		{
-			if( transformation != NULL )
-			{
-				delete transformation;
-			}
-			if(newLine != NULL)
-			{
-				delete newLine;
-			}
-			if( pixels != NULL )
-			{
-				delete pixels;
-			}
-			if( scanline0 != NULL )
-			{
-				delete scanline0;
-			}
-			if( scanline1 != NULL )
-			{
-				delete scanline1;
-			}
-			if( scanline2 != NULL )
-			{
-				delete scanline2;
-			}
 			throw e;
 		}
 		catch(rsgis::RSGISImageException &e)
 		{
-			if( transformation != NULL )
-			{
-				delete transformation;
-			}
-			if(newLine != NULL)
-			{
-				delete newLine;
-			}
-			if( pixels != NULL )
-			{
-				delete pixels;
-			}
-			if( scanline0 != NULL )
-			{
-				delete scanline0;
-			}
-			if( scanline1 != NULL )
-			{
-				delete scanline1;
-			}
-			if( scanline2 != NULL )
-			{
-				delete scanline2;
-			}
 			throw e;
 		}
-		
-		if( transformation != NULL )
-		{
-			delete transformation;
-		}
-		if(newLine != NULL)
-		{
-			delete newLine;
-		}
-		if( pixels != NULL )
-		{
-			delete pixels;
-		}
-		if( scanline0 != NULL )
-		{
-			delete scanline0;
-		}
-		if( scanline1 != NULL )
-		{
-			delete scanline1;
-		}
-		if( scanline2 != NULL )
-		{
-			delete scanline2;
-		}
 	}
 	
 	void RSGISImageInterpolation::interpolateNewImage(GDALDataset *data,
@@ -369,21 +98,12 @@ namespace rsgis{namespace img{
 															  std::string filename,
 															  int band)
 	{
-		// Image Data Stores.
-		float *scanline0 = NULL;
-		float *scanline1 = NULL;
-		float *scanline2 = NULL;
-		double *transformation = NULL;
-		float *newLine = NULL;
-		double *pixels = NULL;
 		GDALDriver *poDriver = NULL;
-		GDALRasterBand *outputRasterBand = NULL;
-		GDALRasterBand *rasterband = NULL;
 		try
 		{
 			GDALDataset *output;
 			/********************** Calculate Scaling *************************/
-			transformation = new double[6];
+			double transformation[6];
 			data->GetGeoTransform(transformation);	
 			
 			int dataXSize = data->GetRasterXSize();
@@ -421,282 +141,68 @@ namespace rsgis{namespace img{
 			output->SetGeoTransform(transformation);
 			output->SetProjection(data->GetProjectionRef());
 			
-			
-			scanline0 = (float *) CPLMalloc(sizeof(float)*dataXSize);
-			scanline1 = (float *) CPLMalloc(sizeof(float)*dataXSize);
-			scanline2 = (float *) CPLMalloc(sizeof(float)*dataXSize);
-			
-			newLine = (float *)CPLMalloc(sizeof(float)*xSize);
-			pixels = new double[9];
-			
-			int column = 0;
-			int row = 0;
-			double xShift = 0;
-			double yShift = 0;
-			
-			outputRasterBand = output->GetRasterBand(1);
-			rasterband = data->GetRasterBand(band);
-			
-			
-			int feedback = ySize/10;
-			int feedbackCounter = 0;
 			std::cout << "Started Interpolating";
-			
-			for( int i = 0; i < ySize; i++)
-			{
-				if((ySize > 10) && (i % feedback) == 0)
-				{
-					std::cout << ".." << feedbackCounter << "..";
-					feedbackCounter = feedbackCounter + 10;
-				}
-				yShift = this->findFloatingPointComponent(((i*outputYResolution)/inputYResolution),
-														  &row);
-				if(row == 0)
-				{
-					rasterband->RasterIO(GF_Read, 
-										 0, 
-										 row, 
-										 dataXSize, 
-										 1, 
-										 scanline0, 
-										 dataXSize, 
-										 1, 
-										 GDT_Float32, 
-										 0, 
-										 0);
-					rasterband->RasterIO(GF_Read, 
-										 0, 
-										 row, 
-										 dataXSize, 
-										 1, 
-										 scanline1, 
-										 dataXSize, 
-										 1, 
-										 GDT_Float32, 
-										 0, 
-										 0);
-					rasterband->RasterIO(GF_Read, 
-										 0, 
-										 row+1, 
-										 dataXSize, 
-										 1, 
-										 scanline2, 
-										 dataXSize, 
-										 1, 
-										 GDT_Float32, 
-										 0, 
-										 0);
-				}
-				else if(row == (dataYSize-1))
-				{
-					rasterband->RasterIO(GF_Read, 
-										 0, 
-										 row-1, 
-										 dataXSize, 
-										 1, 
-										 scanline0, 
-										 dataXSize, 
-										 1, 
-										 GDT_Float32, 
-										 0, 
-										 0);
-					rasterband->RasterIO(GF_Read, 
-										 0, 
-										 row, 
-										 dataXSize, 
-										 1, 
-										 scanline1, 
-										 dataXSize, 
-										 1, 
-										 GDT_Float32, 
-										 0, 
-										 0);
-					rasterband->RasterIO(GF_Read, 
-										 0, 
-										 row, 
-										 dataXSize, 
-										 1, 
-										 scanline2, 
-										 dataXSize, 
-										 1, 
-										 GDT_Float32, 
-										 0, 
-										 0);
-				}
-				else
-				{
-					rasterband->RasterIO(GF_Read, 
-										 0, 
-										 row-1, 
-										 dataXSize, 
-										 1, 
-										 scanline0, 
-										 dataXSize, 
-										 1, 
-										 GDT_Float32, 
-										 0, 
-										 0);
-					rasterband->RasterIO(GF_Read, 
-										 0, 
-										 row, 
-										 dataXSize, 
-										 1, 
-										 scanline1, 
-										 dataXSize, 
-										 1, 
-										 GDT_Float32, 
-										 0, 
-										 0);
-					rasterband->RasterIO(GF_Read, 
-										 0, 
-										 row+1, 
-										 dataXSize, 
-										 1, 
-										 scanline2, 
-										 dataXSize, 
-										 1, 
-										 GDT_Float32, 
-										 0, 
-										 0);
-				}
-				for(int j = 0; j < xSize; j++)
-				{
-					xShift = this->findFloatingPointComponent(((j*outputXResolution)/inputXResolution), 
-															  &column);
-					if(column == 0)
-					{
-						//Column 1
-						pixels[0] = scanline0[column];
-						pixels[3] = scanline1[column];
-						pixels[6] = scanline2[column];
-						//Column 2
-						pixels[1] = scanline0[column];
-						pixels[4] = scanline1[column];
-						pixels[7] = scanline2[column];
-						//Column 1
-						pixels[2] = scanline0[column+1];
-						pixels[5] = scanline1[column+1];
-						pixels[8] = scanline2[column+1];
-					}
-					else if(column == (dataXSize-1))
-					{
-						//Column 1
-						pixels[0] = scanline0[column-1];
-						pixels[3] = scanline1[column-1];
-						pixels[6] = scanline2[column-1];
-						//Column 2
-						pixels[1] = scanline0[column];
-						pixels[4] = scanline1[column];
-						pixels[7] = scanline2[column];
-						//Column 1
-						pixels[2] = scanline0[column];
-						pixels[5] = scanline1[column];
-						pixels[8] = scanline2[column];
-					}
-					else
-					{
-						//Column 1
-						pixels[0] = scanline0[column-1];
-						pixels[3] = scanline1[column-1];
-						pixels[6] = scanline2[column-1];
-						//Column 2
-						pixels[1] = scanline0[column];
-						pixels[4] = scanline1[column];
-						pixels[7] = scanline2[column];
-						//Column 1
-						pixels[2] = scanline0[column+1];
-						pixels[5] = scanline1[column+1];
-						pixels[8] = scanline2[column+1];
-					}
-					newLine[j] = interpolator->interpolate(xShift,yShift,pixels);
-				}
-				outputRasterBand->RasterIO(GF_Write, 0, i, xSize, 1, newLine, xSize, 1, GDT_Float32, 0, 0);
-			}
+			this->interpolateBand(data->GetRasterBand(band), output->GetRasterBand(1), dataXSize, dataYSize, xSize, ySize, inputXResolution, inputYResolution, outputXResolution, outputYResolution);
 			GDALClose(output);
 			std::cout << ".. Complete." << std::endl;
 		}
 		catch(rsgis::RSGISFileException &e)
 		{
-			if( transformation != NULL )
-			{
-				delete transformation;
-			}
-			if(newLine != NULL)
-			{
-				delete newLine;
-			}
-			if( pixels != NULL )
-			{
-				delete pixels;
-			}
-			if( scanline0 != NULL )
-			{
-				delete scanline0;
-			}
-			if( scanline1 != NULL )
-			{
-				delete scanline1;
-			}
-			if( scanline2 != NULL )
-			{
-				delete scanline2;
-			}
 			throw e;
 		}
 		catch(rsgis::RSGISImageException &e)
 		{
-			if( transformation != NULL )
-			{
-				delete transformation;
-			}
-			if(newLine != NULL)
-			{
-				delete newLine;
-			}
-			if( pixels != NULL )
-			{
-				delete pixels;
-			}
-			if( scanline0 != NULL )
-			{
-				delete scanline0;
-			}
-			if( scanline1 != NULL )
-			{
-				delete scanline1;
-			}
-			if( scanline2 != NULL )
-			{
-				delete scanline2;
-			}
 			throw e;
 		}
-		
-		if( transformation != NULL )
-		{
-			delete transformation;
-		}
-		if(newLine != NULL)
-		{
-			delete newLine;
-		}
-		if( pixels != NULL )
-		{
-			delete pixels;
-		}
-		if( scanline0 != NULL )
-		{
-			delete scanline0;
-		}
-		if( scanline1 != NULL )
+	}
+	
+	void RSGISImageInterpolation::interpolateBand(GDALRasterBand *inBand, GDALRasterBand *outBand, int dataXSize, int dataYSize, int xSize, int ySize, double inputXResolution, double inputYResolution, double outputXResolution, double outputYResolution)
+	{
+		// The input column and shift of each output column are the same for every row.
+		std::vector<int> columns(xSize, 0);
+		std::vector<double> xShifts(xSize, 0);
+		for(int j = 0; j < xSize; j++)
 		{
-			delete scanline1;
+			xShifts[j] = this->findFloatingPointComponent(((j*outputXResolution)/inputXResolution), &columns[j]);
+			columns[j] = std::min(std::max(columns[j], 0), dataXSize-1);
 		}
-		if( scanline2 != NULL )
+		
+		// The rows above, at and below the input row, which are only read
+		// again when the input row changes.
+		std::vector<float> scanlines(3*((size_t)dataXSize), 0);
+		float *scanline[3] = {&scanlines[0], &scanlines[dataXSize], &scanlines[2*((size_t)dataXSize)]};
+		std::vector<float> newLine(xSize, 0);
+		int loadedRow = -1;
+		int row = 0;
+		double yShift = 0;
+		
+		int feedback = ySize/10;
+		int feedbackCounter = 0;
+		for(int i = 0; i < ySize; i++)
 		{
-			delete scanline2;
+			if((ySize > 10) && (i % feedback) == 0)
+			{
+				std::cout << ".." << feedbackCounter << ".." << std::flush;
+				feedbackCounter = feedbackCounter + 10;
+			}
+			
+			yShift = this->findFloatingPointComponent(((i*outputYResolution)/inputYResolution), &row);
+			row = std::min(std::max(row, 0), dataYSize-1);
+			if(row != loadedRow)
+			{
+				int rows[3] = {std::max(row-1, 0), row, std::min(row+1, dataYSize-1)};
+				for(int r = 0; r < 3; ++r)
+				{
+					if(inBand->RasterIO(GF_Read, 0, rows[r], dataXSize, 1, scanline[r], dataXSize, 1, GDT_Float32, 0, 0) != CE_None)
+					{
+						throw rsgis::RSGISImageException("Could not read the input image row.");
+					}
+				}
+				loadedRow = row;
+			}
+			this->interpolator->interpolateRow(yShift, scanline[0], scanline[1], scanline[2], dataXSize, columns.data(), xShifts.data(), newLine.data(), xSize);
+			outBand->RasterIO(GF_Write, 0, i, xSize, 1, newLine.data(), xSize, 1, GDT_Float32, 0, 0);
 		}
-
 	}
 	
 	double RSGISImageInterpolation::findFloatingPointComponent(double floatingPointNum, int *integer)
@@ -764,7 +270,12 @@ namespace rsgis{namespace img{
     
     RSGISPopulateImageFromInterpolator::RSGISPopulateImageFromInterpolator()
     {
-        
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+    
+    void RSGISPopulateImageFromInterpolator::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
     }
     
     void RSGISPopulateImageFromInterpolator::populateImage(rsgis::math::RSGIS2DInterpolator *interpolator, GDALDataset *image)
@@ -789,68 +300,59 @@ namespace rsgis{namespace img{
             
             int nYBlocks = floor(((double)height) / ((double)yBlockSize));
             int remainRows = height - (nYBlocks * yBlockSize);
-            int rowOffset = 0;
             
             double tlX = gdalTransform[0];
             double tlY = gdalTransform[3];
             double xRes = gdalTransform[1];
             double yRes = gdalTransform[5];
             
-            double cX = 0.0;
-            double cY = 0.0;
-            
+            // Interpolators which cannot be queried concurrently are run on a
+            // single thread.
+            unsigned int nThreads = 1;
+            if(interpolator->isThreadSafe())
+            {
+                nThreads = this->numThreads;
+            }
             
-			int feedback = height/10.0;
-			int feedbackCounter = 0;
-			std::cout << "Started" << std::flush;
-            cY = tlY;
-            for(int i = 0; i < nYBlocks; ++i)
-			{
-                for(int m = 0; m < yBlockSize; ++m)
+            rsgis::utils::RSGISWorkerPool pool(nThreads);
+            rsgis_tqdm pbar;
+            int numBlocks = nYBlocks + ((remainRows > 0)?1:0);
+            for(int i = 0; i < numBlocks; ++i)
+			{
+                pbar.progress(i, numBlocks);
+                int rowOffset = yBlockSize * i;
+                int nRows = (i < nYBlocks)?yBlockSize:remainRows;
+                
+                // The rows of the block are calculated by the threads in turn, a
+                // row at a time so interpolators can reuse each pixel's search.
+                auto calcRows = [interpolator, imgData, width, nRows, rowOffset, tlX, tlY, xRes, yRes](unsigned int startRow, unsigned int rowStep)
                 {
-                    if((feedback != 0) && (((i*yBlockSize)+m) % feedback) == 0)
+                    for(int m = startRow; m < nRows; m += rowStep)
                     {
-                        std::cout << "." << feedbackCounter << "." << std::flush;
-                        feedbackCounter = feedbackCounter + 10;
+                        double cY = tlY + (yRes * (rowOffset + m));
+                        interpolator->getRowValues(tlX, cY, xRes, width, &imgData[m*width]);
                     }
-                    cX = tlX;
-                    for(int j = 0; j < width; ++j)
+                };
+                
+                if((pool.getNumThreads() > 1) && (nRows > 1))
+                {
+                    unsigned int blockThreads = pool.getNumThreads();
+                    pool.runOnEach([&calcRows, blockThreads](unsigned int t)
                     {
-                        imgData[(m*width)+j] = interpolator->getValue(cX, cY);
-                        cX += xRes;
-                    }
-                    cY += yRes;
+                        calcRows(t, blockThreads);
+                    });
                 }
-				
-				rowOffset = yBlockSize * i;
-                outputRasterBand->RasterIO(GF_Write, 0, rowOffset, width, yBlockSize, imgData, width, yBlockSize, GDT_Float32, 0, 0);
-			}
-            
-            if(remainRows > 0)
-            {
-                for(int m = 0; m < remainRows; ++m)
+                else
                 {
-                    if((feedback != 0) && ((((nYBlocks*yBlockSize)+m) % feedback) == 0))
-                    {
-                        std::cout << "." << feedbackCounter << "." << std::flush;
-                        feedbackCounter = feedbackCounter + 10;
-                    }
-                    cX = tlX;
-                    for(int j = 0; j < width; ++j)
-                    {
-                        imgData[(m*width)+j] = interpolator->getValue(cX, cY);
-                        cX += xRes;
-                    }
-                    cY += yRes;
+                    calcRows(0, 1);
                 }
 				
-				rowOffset = (yBlockSize * nYBlocks);
-                outputRasterBand->RasterIO(GF_Write, 0, rowOffset, width, remainRows, imgData, width, remainRows, GDT_Float32, 0, 0);
-            }
-			std::cout << " Complete.\n";
+                outputRasterBand->RasterIO(GF_Write, 0, rowOffset, width, nRows, imgData, width, nRows, GDT_Float32, 0, 0);
+			}
+            pbar.finish();
                         
             delete[] gdalTransform;
-            delete[] imgData;
+            CPLFree(imgData);
             
         }
         catch(rsgis::math::RSGISInterpolationException &e)
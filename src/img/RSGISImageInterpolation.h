@@ -25,12 +25,18 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <thread>
+#include <exception>
+#include <cstdlib>
+#include <algorithm>
 
 #include "gdal_priv.h"
 
 #include "common/rsgis-tqdm.h"
 #include "common/RSGISFileException.h"
 #include "common/RSGISImageException.h"
+#include "common/RSGISParallel.h"
 
 #include "img/RSGISImageInterpolator.h"
 
@@ -70,6 +76,7 @@ namespace rsgis{namespace img{
 			~RSGISImageInterpolation();
 		protected:
 			double findFloatingPointComponent(double floatingPointNum, int *integer); 
+			void interpolateBand(GDALRasterBand *inBand, GDALRasterBand *outBand, int dataXSize, int dataYSize, int xSize, int ySize, double inputXResolution, double inputYResolution, double outputXResolution, double outputYResolution);
 			RSGISInterpolator *interpolator;
 		};
     
@@ -78,8 +85,15 @@ namespace rsgis{namespace img{
     {
     public:
         RSGISPopulateImageFromInterpolator();
+        /**
+         * The number of threads used to calculate the rows of each image block
+         * for interpolators which are thread safe (0 uses the number of cores).
+         */
+        void setNumThreads(unsigned int numThreads);
         void populateImage(rsgis::math::RSGIS2DInterpolator *interpolator, GDALDataset *image);
         ~RSGISPopulateImageFromInterpolator();
+    protected:
+        unsigned int numThreads;
     };
     
 }}
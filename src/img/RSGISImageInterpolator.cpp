@@ -30,6 +30,28 @@ namespace rsgis{namespace img{
 		
 	}
 	
+	void RSGISInterpolator::interpolateRow(double yShift, const float *row0, const float *row1, const float *row2, int rowWidth, const int *columns, const double *xShifts, float *outRow, int numOutVals)
+	{
+		double pixels[9];
+		int prevCol = 0;
+		int nextCol = 0;
+		for(int i = 0; i < numOutVals; ++i)
+		{
+			int column = columns[i];
+			windowColumns(column, rowWidth, &prevCol, &nextCol);
+			pixels[0] = row0[prevCol];
+			pixels[1] = row0[column];
+			pixels[2] = row0[nextCol];
+			pixels[3] = row1[prevCol];
+			pixels[4] = row1[column];
+			pixels[5] = row1[nextCol];
+			pixels[6] = row2[prevCol];
+			pixels[7] = row2[column];
+			pixels[8] = row2[nextCol];
+			outRow[i] = this->interpolate(xShifts[i], yShift, pixels);
+		}
+	}
+	
 	RSGISInterpolator::~RSGISInterpolator()
 	{
 		
@@ -75,6 +97,30 @@ namespace rsgis{namespace img{
 		return pixelValue;
 	}
 	
+	void RSGISCubicInterpolator::interpolateRow(double yShift, const float *row0, const float *row1, const float *row2, int rowWidth, const int *columns, const double *xShifts, float *outRow, int numOutVals)
+	{
+		std::vector<double> colVals(rowWidth);
+		double tmpPixels[3];
+		for(int c = 0; c < rowWidth; ++c)
+		{
+			tmpPixels[0] = row0[c];
+			tmpPixels[1] = row1[c];
+			tmpPixels[2] = row2[c];
+			colVals[c] = this->estimateNewValueFromCurve(tmpPixels, yShift);
+		}
+		
+		int prevCol = 0;
+		int nextCol = 0;
+		for(int i = 0; i < numOutVals; ++i)
+		{
+			windowColumns(columns[i], rowWidth, &prevCol, &nextCol);
+			tmpPixels[0] = colVals[prevCol];
+			tmpPixels[1] = colVals[columns[i]];
+			tmpPixels[2] = colVals[nextCol];
+			outRow[i] = this->estimateNewValueFromCurve(tmpPixels, xShifts[i]);
+		}
+	}
+	
 	double RSGISCubicInterpolator::estimateNewValueFromCurve(double *pixels, double shift)
 	{
 		double newValue = 0;
@@ -114,6 +160,22 @@ namespace rsgis{namespace img{
 		return pixelValue;
 	}
 	
+	void RSGISBilinearAreaInterpolator::interpolateRow(double yShift, const float *row0, const float *row1, const float *row2, int rowWidth, const int *columns, const double *xShifts, float *outRow, int numOutVals)
+	{
+		// As interpolate, which uses the first four values of the 3x3 window.
+		int prevCol = 0;
+		int nextCol = 0;
+		for(int i = 0; i < numOutVals; ++i)
+		{
+			windowColumns(columns[i], rowWidth, &prevCol, &nextCol);
+			double xShift = xShifts[i];
+			outRow[i] = ((1-xShift) * (1-yShift) * ((double)row0[prevCol])) + 
+			(xShift * (1-yShift) * ((double)row0[columns[i]])) +
+			((1-xShift) * yShift * ((double)row0[nextCol])) +
+			(xShift * yShift * ((double)row1[prevCol]));
+		}
+	}
+	
 	RSGISBilinearPointInterpolator::RSGISBilinearPointInterpolator()
 	{
 		
@@ -134,6 +196,21 @@ namespace rsgis{namespace img{
 		return pixelValue;
 	}
 	
+	void RSGISBilinearPointInterpolator::interpolateRow(double yShift, const float *row0, const float *row1, const float *row2, int rowWidth, const int *columns, const double *xShifts, float *outRow, int numOutVals)
+	{
+		// As interpolate, which uses the first four values of the 3x3 window.
+		int prevCol = 0;
+		int nextCol = 0;
+		for(int i = 0; i < numOutVals; ++i)
+		{
+			windowColumns(columns[i], rowWidth, &prevCol, &nextCol);
+			double xShift = xShifts[i];
+			double x1Linear = ((1-xShift)*((double)row0[prevCol])) + (xShift*((double)row0[columns[i]]));
+			double x2Linear = ((1-xShift)*((double)row0[nextCol])) + (xShift*((double)row1[prevCol]));
+			outRow[i] = ((1-yShift)*x1Linear)+(yShift * x2Linear);
+		}
+	}
+	
 	RSGISNearestNeighbourInterpolator::RSGISNearestNeighbourInterpolator()
 	{
 		
@@ -158,6 +235,38 @@ namespace rsgis{namespace img{
 		return pixelValue;
 	}
 	
+	void RSGISNearestNeighbourInterpolator::interpolateRow(double yShift, const float *row0, const float *row1, const float *row2, int rowWidth, const int *columns, const double *xShifts, float *outRow, int numOutVals)
+	{
+		// As interpolate, which selects from the first four values of the 3x3 window.
+		double pixelOverlaps[4];
+		int prevCol = 0;
+		int nextCol = 0;
+		for(int i = 0; i < numOutVals; ++i)
+		{
+			windowColumns(columns[i], rowWidth, &prevCol, &nextCol);
+			double xShift = xShifts[i];
+			pixelOverlaps[0] = (1-xShift) * (1-yShift);
+			pixelOverlaps[1] = xShift * (1-yShift);
+			pixelOverlaps[2] = (1-xShift) * yShift;
+			pixelOverlaps[3] = xShift * yShift;
+			switch(this->findIndexOfMax(pixelOverlaps, 4))
+			{
+				case 0:
+					outRow[i] = row0[prevCol];
+					break;
+				case 1:
+					outRow[i] = row0[columns[i]];
+					break;
+				case 2:
+					outRow[i] = row0[nextCol];
+					break;
+				default:
+					outRow[i] = row1[prevCol];
+					break;
+			}
+		}
+	}
+	
 	int RSGISNearestNeighbourInterpolator::findIndexOfMax(double *arr, int size)
 	{
 		double maxValue = arr[0];
@@ -25,6 +25,7 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include "common/RSGISImageException.h"
 
@@ -48,7 +49,21 @@ namespace rsgis{namespace img{
 		public:
 			RSGISInterpolator();
 			virtual double interpolate(double xShift, double yShift, double *pixels)=0;
+			/**
+			 * Interpolate a row of output values, where output value i is from
+			 * the 3x3 window centred on column columns[i] (repeating the edge
+			 * columns) of the input rows above (row0), at (row1) and below (row2)
+			 * the centre, with the shifts xShifts[i] and yShift. The default
+			 * builds each window and calls interpolate.
+			 */
+			virtual void interpolateRow(double yShift, const float *row0, const float *row1, const float *row2, int rowWidth, const int *columns, const double *xShifts, float *outRow, int numOutVals);
 			virtual ~RSGISInterpolator();
+		protected:
+			static void windowColumns(int column, int rowWidth, int *prevCol, int *nextCol)
+			{
+				*prevCol = (column > 0)?(column-1):0;
+				*nextCol = (column < (rowWidth-1))?(column+1):(rowWidth-1);
+			};
 		};
 	
 	class DllExport RSGISCubicInterpolator : public RSGISInterpolator
@@ -56,6 +71,8 @@ namespace rsgis{namespace img{
 		public:
 			RSGISCubicInterpolator();
 			double interpolate(double xShift, double yShift, double *pixels);
+			/** The curves through the columns only depend on yShift, so are fitted once per input column. */
+			void interpolateRow(double yShift, const float *row0, const float *row1, const float *row2, int rowWidth, const int *columns, const double *xShifts, float *outRow, int numOutVals);
 		protected:
 			double estimateNewValueFromCurve(double *pixels, double shift);
 		};
@@ -65,6 +82,7 @@ namespace rsgis{namespace img{
 		public:
 			RSGISBilinearAreaInterpolator();
 			double interpolate(double xShift, double yShift, double *pixels);
+			void interpolateRow(double yShift, const float *row0, const float *row1, const float *row2, int rowWidth, const int *columns, const double *xShifts, float *outRow, int numOutVals);
 		};
 	
 	class DllExport RSGISBilinearPointInterpolator : public RSGISInterpolator
@@ -72,6 +90,7 @@ namespace rsgis{namespace img{
 		public:
 			RSGISBilinearPointInterpolator();
 			double interpolate(double xShift, double yShift, double *pixels);
+			void interpolateRow(double yShift, const float *row0, const float *row1, const float *row2, int rowWidth, const int *columns, const double *xShifts, float *outRow, int numOutVals);
 		};
 	
 	class DllExport RSGISNearestNeighbourInterpolator : public RSGISInterpolator
@@ -79,6 +98,7 @@ namespace rsgis{namespace img{
 		public:
 			RSGISNearestNeighbourInterpolator();
 			double interpolate(double xShift, double yShift, double *pixels);
+			void interpolateRow(double yShift, const float *row0, const float *row1, const float *row2, int rowWidth, const int *columns, const double *xShifts, float *outRow, int numOutVals);
 		protected:
 			int findIndexOfMax(double *arr, int size);
 		};
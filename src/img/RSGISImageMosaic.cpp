@@ -34,968 +34,340 @@ namespace rsgis{namespace img{
 
 	RSGISImageMosaic::RSGISImageMosaic()
 	{
-
+        this->numThreads = rsgis::utils::getNumThreads();
 	}
 
+    void RSGISImageMosaic::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+
 	void RSGISImageMosaic::mosaic(std::string *inputImages, int numDS, std::string outputImage, float background, bool projFromImage, std::string proj, std::string format, GDALDataType imgDataType)
 	{
-		RSGISImageUtils imgUtils;
-        rsgis::math::RSGISMathsUtils mathsUtils;
-        GDALAllRegister();
-        GDALDataset *dataset = NULL;
-        GDALRasterBand *imgBand = NULL;
-		int width;
-		int height;
-		double *transformation = new double[6];
-		double *imgTransform = new double[6];
-		int numberBands = 0;
-		int tileXSize = 0;
-		int tileYSize = 0;
-		double xDiff = 0;
-		double yDiff = 0;
-		int xStart = 0;
-		int yStart = 0;
-		std::string projection = proj;
-		GDALDataset *outputDataset = NULL;
-		GDALRasterBand **inputRasterBands = NULL;
-		GDALRasterBand **outputRasterBands = NULL;
-		float **inputData = NULL;
-
-        std::vector<std::string> bandnames;
-
-		try
-		{
-			for(int i = 0; i < numDS; i++)
-			{
-                dataset = (GDALDataset *) GDALOpenShared(inputImages[i].c_str(), GA_ReadOnly);
-                if(dataset == NULL)
-                {
-                    std::string message = std::string("Could not open image ") + inputImages[i];
-                    throw RSGISImageException(message.c_str());
-                }
-
-				if(i == 0)
-				{
-					numberBands = dataset->GetRasterCount();
-                    for(int j = 0; j < numberBands; ++j)
-                    {
-                        imgBand = dataset->GetRasterBand(j+1);
-                        bandnames.push_back(std::string(imgBand->GetDescription()));
-                    }
-                    if(projFromImage)
-                    {
-                        projection = std::string(dataset->GetProjectionRef());
-                    }
-				}
-				else
-				{
-					if(dataset->GetRasterCount() != numberBands)
-					{
-						throw RSGISImageBandException("All input images need to have the same number of bands (" + mathsUtils.doubletostring(numberBands) + ").\n"
-                                    + inputImages[i] + " has " + mathsUtils.doubletostring(dataset->GetRasterCount()) );
-					}
-				}
-                GDALClose(dataset);
-			}
-
-			imgUtils.getImagesExtent(inputImages, numDS, &width, &height, transformation);
+        this->mosaicTiled(inputImages, numDS, outputImage, background, projFromImage, proj, 0, 0, 0, 0, 0, format, imgDataType);
+	}
 
-            // Create blank image
-			std::cout << "Create new image [" << width << "," << height << "] with projection: \n" << projection << std::endl;
+	void RSGISImageMosaic::mosaicSkipVals(std::string *inputImages, int numDS, std::string outputImage, float background, float skipVal, bool projFromImage, std::string proj, unsigned int skipBand, unsigned int overlapBehaviour, std::string format, GDALDataType imgDataType)
+	{
+        this->mosaicTiled(inputImages, numDS, outputImage, background, projFromImage, proj, 1, skipVal, 0, skipBand, overlapBehaviour, format, imgDataType);
+	}
 
-			outputDataset = imgUtils.createBlankImage(outputImage, transformation, width, height, numberBands, projection, background, bandnames, format, imgDataType);
+	void RSGISImageMosaic::mosaicSkipThresh(std::string *inputImages, int numDS, std::string outputImage, float background, float skipLowerThresh, float skipUpperThresh, bool projFromImage, std::string proj, unsigned int threshBand, unsigned int overlapBehaviour, std::string format, GDALDataType imgDataType)
+	{
+        this->mosaicTiled(inputImages, numDS, outputImage, background, projFromImage, proj, 2, skipLowerThresh, skipUpperThresh, threshBand, overlapBehaviour, format, imgDataType);
+	}
 
-			// COPY IMAGE DATA INTO THE BLANK IMAGE
+    void RSGISImageMosaic::mosaicTiled(std::string *inputImages, int numDS, std::string outputImage, float background, bool projFromImage, std::string proj, unsigned int skipMode, float skipVal, float skipUpperThresh, unsigned int skipBand, unsigned int overlapBehaviour, std::string format, GDALDataType imgDataType)
+    {
+        RSGISImageUtils imgUtils;
+        rsgis::math::RSGISMathsUtils mathsUtils;
+        GDALAllRegister();
+        GDALDataset *dataset = NULL;
+        GDALDataset *outputDataset = NULL;
+        int width = 0;
+        int height = 0;
+        double *transformation = new double[6];
+        double imgTransform[6];
+        int numberBands = 0;
+        std::string projection = proj;
+        std::vector<RSGISMosaicInputImg> inImgs;
 
-            //Get Image Output Bands
-            outputRasterBands = new GDALRasterBand*[numberBands];
-            for(int i = 0; i < numberBands; i++)
+        try
+        {
+            if(numDS < 1)
             {
-                outputRasterBands[i] = outputDataset->GetRasterBand(i+1);
+                throw RSGISImageException("No input images were provided to be mosaicked.");
             }
 
-            int xBlockSize = 0;
-            int yBlockSize = 0;
-            outputRasterBands[0]->GetBlockSize (&xBlockSize, &yBlockSize);
-
-			std::cout << "Started (total " << numDS << ") ." << std::flush;
-
-            for(int ds = 0; ds < numDS; ds++)
-			{
-				std::cout << "." << ds+1 << "." << std::flush;
+            imgUtils.getImagesExtent(inputImages, numDS, &width, &height, transformation);
+            double yResPos = fabs(transformation[5]);
 
-                dataset = (GDALDataset *) GDALOpenShared(inputImages[ds].c_str(), GA_ReadOnly);
+            // Only the headers are read here, the footprint of each image
+            // within the output is recorded so it can be found for each tile.
+            for(int i = 0; i < numDS; i++)
+            {
+                dataset = (GDALDataset *) GDALOpen(inputImages[i].c_str(), GA_ReadOnly);
                 if(dataset == NULL)
                 {
-                    std::string message = std::string("Could not open image ") + inputImages[ds];
+                    std::string message = std::string("Could not open image ") + inputImages[i];
                     throw RSGISImageException(message.c_str());
                 }
 
-                inputRasterBands = new GDALRasterBand*[numberBands];
-                for(int i = 0; i < numberBands; i++)
-                {
-                    inputRasterBands[i] = dataset->GetRasterBand(i+1);
-                }
-
-				dataset->GetGeoTransform(imgTransform);
-				tileXSize = dataset->GetRasterXSize();
-				tileYSize = dataset->GetRasterYSize();
-
-				xDiff = imgTransform[0] - transformation[0];
-				yDiff = transformation[3] - imgTransform[3];
-
-				xStart = floor((xDiff/transformation[1])+0.5);
-				yStart = floor((yDiff/transformation[1])+0.5);
-
-                // Allocate memory
-                inputData = new float*[numberBands];
-                for(int i = 0; i < numberBands; i++)
-                {
-                    inputData[i] = (float *) CPLMalloc(sizeof(float)*(tileXSize*yBlockSize));
-                }
-
-                int nYBlocks = tileYSize / yBlockSize;
-                int remainRows = tileYSize - (nYBlocks * yBlockSize);
-                int rowOffset = 0;
-
-                for(int i = 0; i < nYBlocks; i++)
-                {
-                    for(int n = 0; n < numberBands; n++)
-                    {
-                        rowOffset = yBlockSize * i;
-                        inputRasterBands[n]->RasterIO(GF_Read, 0, rowOffset, tileXSize, yBlockSize, inputData[n], tileXSize, yBlockSize, GDT_Float32, 0, 0);
-                        outputRasterBands[n]->RasterIO(GF_Write, xStart, (yStart + rowOffset), tileXSize, yBlockSize, inputData[n], tileXSize, yBlockSize, GDT_Float32, 0, 0);
-                    }
-
-                }
-
-                if(remainRows > 0)
+                if(i == 0)
                 {
-                    for(int n = 0; n < numberBands; n++)
-                    {
-                        rowOffset = yBlockSize * nYBlocks;
-                        inputRasterBands[n]->RasterIO(GF_Read, 0, rowOffset, tileXSize, remainRows, inputData[n], tileXSize, remainRows, GDT_Float32, 0, 0);
-                        outputRasterBands[n]->RasterIO(GF_Write, xStart, (yStart + rowOffset), tileXSize, remainRows, inputData[n], tileXSize, remainRows, GDT_Float32, 0, 0);
-                    }
-                }
-
-                // Tidy up
-                if(inputData != NULL)
-                {
-                    for(int i = 0; i < numberBands; i++)
+                    numberBands = dataset->GetRasterCount();
+                    if(projFromImage)
                     {
-                        if(inputData[i] != NULL)
-                        {
-                            delete[] inputData[i];
-                        }
+                        projection = std::string(dataset->GetProjectionRef());
                     }
-                    delete[] inputData;
                 }
-                if(inputRasterBands != NULL)
+                else if(dataset->GetRasterCount() != numberBands)
                 {
-                    delete[] inputRasterBands;
+                    std::string message = "All input images need to have the same number of bands (" + mathsUtils.doubletostring(numberBands) + ").\n"
+                                    + inputImages[i] + " has " + mathsUtils.doubletostring(dataset->GetRasterCount());
+                    GDALClose(dataset);
+                    throw RSGISImageBandException(message);
                 }
 
+                dataset->GetGeoTransform(imgTransform);
+                RSGISMosaicInputImg inImg;
+                inImg.imageFile = inputImages[i];
+                inImg.xOff = floor(((imgTransform[0] - transformation[0])/transformation[1])+0.5);
+                inImg.yOff = floor(((transformation[3] - imgTransform[3])/yResPos)+0.5);
+                inImg.xSize = dataset->GetRasterXSize();
+                inImg.ySize = dataset->GetRasterYSize();
+                inImgs.push_back(inImg);
                 GDALClose(dataset);
-			}
-			std::cout << ".complete\n";
-
-		}
-		catch(RSGISImageBandException &e)
-		{
-            if(inputData != NULL)
-            {
-                for(int i = 0; i < numberBands; i++)
-                {
-                    if(inputData[i] != NULL)
-                    {
-                        delete[] inputData[i];
-                    }
-                }
-                delete[] inputData;
+                dataset = NULL;
             }
-            if(inputRasterBands != NULL)
-            {
-                delete[] inputRasterBands;
-            }
-            if(outputRasterBands != NULL)
+
+            if(skipBand >= ((unsigned int)numberBands))
             {
-                delete[] outputRasterBands;
+                throw RSGISImageBandException("The band used to skip values is not within the input images.");
             }
-			if(transformation != NULL)
-			{
-				delete[] transformation;
-			}
-			if(imgTransform != NULL)
-			{
-				delete[] imgTransform;
-			}
-			throw e;
-		}
-
-        // Tidy
-        if(outputRasterBands != NULL)
-        {
-            delete[] outputRasterBands;
-        }
-
-		if(transformation != NULL)
-		{
-			delete[] transformation;
-		}
-		if(imgTransform != NULL)
-		{
-			delete[] imgTransform;
-		}
-		GDALClose(outputDataset);
-	}
-
-	void RSGISImageMosaic::mosaicSkipVals(std::string *inputImages, int numDS, std::string outputImage, float background, float skipVal, bool projFromImage, std::string proj, unsigned int skipBand, unsigned int overlapBehaviour, std::string format, GDALDataType imgDataType)
-	{
-		RSGISImageUtils imgUtils;
-		rsgis::math::RSGISMathsUtils mathsUtils;
 
-        GDALAllRegister();
-        GDALDataset *dataset = NULL;
-        GDALRasterBand *imgBand = NULL;
-		int width;
-		int height;
-		double *transformation = new double[6];
-		double *imgTransform = new double[6];
-		int numberBands = 0;
-		int tileXSize = 0;
-		int tileYSize = 0;
-		double xDiff = 0;
-		double yDiff = 0;
-		int xStart = 0;
-		int yStart = 0;
-		std::string projection = proj;
-		GDALDataset *outputDataset = NULL;
-		GDALRasterBand **inputRasterBands = NULL;
-		GDALRasterBand **outputRasterBands = NULL;
-		float **inputData = NULL;
-		float **outputData = NULL;
-		bool pixelsChanged;
+            std::cout << "Create new image [" << width << "," << height << "] with projection: \n" << projection << std::endl;
 
-        std::vector<std::string> bandnames;
-
-		try
-		{
-			for(int i = 0; i < numDS; i++)
-			{
-                dataset = (GDALDataset *) GDALOpenShared(inputImages[i].c_str(), GA_ReadOnly);
-                if(dataset == NULL)
-                {
-                    std::string message = std::string("Could not open image ") + inputImages[i];
-                    throw RSGISImageException(message.c_str());
-                }
-
-				if(i == 0)
-				{
-					numberBands = dataset->GetRasterCount();
-                    for(int j = 0; j < numberBands; ++j)
-                    {
-                        imgBand = dataset->GetRasterBand(j+1);
-                        bandnames.push_back(std::string(imgBand->GetDescription()));
-                    }
-                    if(projFromImage)
-                    {
-                        projection = std::string(dataset->GetProjectionRef());
-                    }
-				}
-				else
-				{
-					if(dataset->GetRasterCount() != numberBands)
-					{
-						throw RSGISImageBandException("All input images need to have the same number of bands (" + mathsUtils.doubletostring(numberBands) + ").\n"
-                                    + inputImages[i] + " has " + mathsUtils.doubletostring(dataset->GetRasterCount()) );
-					}
-				}
-                GDALClose(dataset);
-			}
-
-			imgUtils.getImagesExtent(inputImages, numDS, &width, &height, transformation);
-
-            // Create blank image
-			std::cout << "Create new image [" << width << "," << height << "] with projection: \n" << projection << std::endl;
-
-			outputDataset = imgUtils.createBlankImage(outputImage, transformation, width, height, numberBands, projection, background, bandnames, format, imgDataType);
-
-			// COPY IMAGE DATA INTO THE BLANK IMAGE
-
-            //Get Image Output Bands
-            outputRasterBands = new GDALRasterBand*[numberBands];
-            for(int i = 0; i < numberBands; i++)
+            // Every output tile is written once, so the image is not filled
+            // with the background value first.
+            GDALDriver *gdalDriver = GetGDALDriverManager()->GetDriverByName(format.c_str());
+            if(gdalDriver == NULL)
             {
-                outputRasterBands[i] = outputDataset->GetRasterBand(i+1);
+                throw RSGISImageException("Image driver is not available.");
             }
+            char **papszOptions = imgUtils.getGDALCreationOptionsForFormat(format);
+            RSGISDatasetCache::invalidate(outputImage);
+            outputDataset = gdalDriver->Create(outputImage.c_str(), width, height, numberBands, imgDataType, papszOptions);
+            if(outputDataset == NULL)
+            {
+                throw RSGISImageException("Image could not be created.");
+            }
+            outputDataset->SetGeoTransform(transformation);
+            outputDataset->SetProjection(projection.c_str());
 
-            int xBlockSize = 0;
-            int yBlockSize = 0;
-            outputRasterBands[0]->GetBlockSize (&xBlockSize, &yBlockSize);
-
-			std::cout << "Started (total " << numDS << ") ." << std::flush;
-
-            for(int ds = 0; ds < numDS; ds++)
-			{
-				std::cout << "." << ds+1 << "." << std::flush;
-
-                dataset = (GDALDataset *) GDALOpenShared(inputImages[ds].c_str(), GA_ReadOnly);
-                if(dataset == NULL)
-                {
-                    std::string message = std::string("Could not open image ") + inputImages[ds];
-                    throw RSGISImageException(message.c_str());
-                }
-
-                inputRasterBands = new GDALRasterBand*[numberBands];
-                for(int i = 0; i < numberBands; i++)
-                {
-                    inputRasterBands[i] = dataset->GetRasterBand(i+1);
-                }
-
-				dataset->GetGeoTransform(imgTransform);
-				tileXSize = dataset->GetRasterXSize();
-				tileYSize = dataset->GetRasterYSize();
-
-				xDiff = imgTransform[0] - transformation[0];
-				yDiff = transformation[3] - imgTransform[3];
-
-				xStart = floor((xDiff/transformation[1])+0.5);
-				yStart = floor((yDiff/transformation[1])+0.5);
-
-                // Allocate memory
-                inputData = new float*[numberBands];
-                outputData = new float*[numberBands];
-                for(int i = 0; i < numberBands; i++)
-                {
-                    inputData[i] = (float *) CPLMalloc(sizeof(float)*(tileXSize*yBlockSize));
-                    outputData[i] = (float *) CPLMalloc(sizeof(float)*(tileXSize*yBlockSize));
-                }
-
-                int nYBlocks = tileYSize / yBlockSize;
-                int remainRows = tileYSize - (nYBlocks * yBlockSize);
-                int rowOffset = 0;
-
-                for(int i = 0; i < nYBlocks; i++)
-                {
-                    // Read input and output data
-                    for(int n = 0; n < numberBands; n++)
-                    {
-                        rowOffset = yBlockSize * i;
-                        // Read input data
-                        inputRasterBands[n]->RasterIO(GF_Read, 0, rowOffset, tileXSize, yBlockSize, inputData[n], tileXSize, yBlockSize, GDT_Float32, 0, 0);
-                        // Read output data
-                        outputRasterBands[n]->RasterIO(GF_Read, xStart, (yStart + rowOffset), tileXSize, yBlockSize, outputData[n], tileXSize, yBlockSize, GDT_Float32, 0, 0);
-                    }
-
-                    pixelsChanged = false; // Keep track if there are changes that need writing out.
-
-                    for(int m = 0; m < yBlockSize; ++m)
-                    {
-                        for(int j = 0; j < tileXSize; j++)
-                        {
-                            // Check for skip value
-                            if(inputData[skipBand][(m*tileXSize)+j] != skipVal)
-                            {
-                                // Check if behaviour is defined for overlap and not the first image
-                                if( (overlapBehaviour > 0) && (ds > 0) )
-                                {
-                                    // Check if pixel is background value (no data has been written yet)
-                                    if( outputData[skipBand][(m*tileXSize)+j] == background )
-                                    {
-                                        for(int n = 0; n < numberBands; n++)
-                                        {
-                                            outputData[n][(m*tileXSize)+j] = inputData[n][(m*tileXSize)+j];
-                                        }
-                                        pixelsChanged = true;
-                                    }
-                                    // If data has been written - check if new value is less (min overlap behaviour)
-                                    else if( (overlapBehaviour == 1) &&  (inputData[skipBand][(m*tileXSize)+j] < outputData[skipBand][(m*tileXSize)+j]) )
-                                    {
-                                        for(int n = 0; n < numberBands; n++)
-                                        {
-                                            outputData[n][(m*tileXSize)+j] = inputData[n][(m*tileXSize)+j];
-                                        }
-                                        pixelsChanged = true;
-                                    }
-                                    // If data has been written - check if new value is greater (max overlap behaviour)
-                                    else if( (overlapBehaviour == 2) &&  (inputData[skipBand][(m*tileXSize)+j] > outputData[skipBand][(m*tileXSize)+j]) )
-                                    {
-                                        for(int n = 0; n < numberBands; n++)
-                                        {
-                                            outputData[n][(m*tileXSize)+j] = inputData[n][(m*tileXSize)+j];
-                                        }
-                                        pixelsChanged = true;
-                                    }
-                                }
-                                // If no overlap behaviour defined, write out,
-                                else
-                                {
-                                    for(int n = 0; n < numberBands; n++)
-                                    {
-                                        outputData[n][(m*tileXSize)+j] = inputData[n][(m*tileXSize)+j];
-                                    }
-                                    pixelsChanged = true;
-                                }
-
-
-                            }
-                        }
-                    }
-
-                    // Write out data to mosaic
-                    if(pixelsChanged)
-                    {
-                        for(int n = 0; n < numberBands; n++)
-                        {
-                            outputRasterBands[n]->RasterIO(GF_Write, xStart, (yStart + rowOffset), tileXSize, yBlockSize, outputData[n], tileXSize, yBlockSize, GDT_Float32, 0, 0);
-                        }
-                    }
-
-                }
-
-                if(remainRows > 0)
-                {
-                    for(int n = 0; n < numberBands; n++)
-                    {
-                        rowOffset = yBlockSize * nYBlocks;
-                        // Read input data
-                        inputRasterBands[n]->RasterIO(GF_Read, 0, rowOffset, tileXSize, remainRows, inputData[n], tileXSize, remainRows, GDT_Float32, 0, 0);
-                        // Read output data
-                        outputRasterBands[n]->RasterIO(GF_Read, xStart, (yStart + rowOffset), tileXSize, remainRows, outputData[n], tileXSize, remainRows, GDT_Float32, 0, 0);
-                    }
-
-                    pixelsChanged = false; // Keep track if there are changes that need writing out.
-
-                    for(int m = 0; m < remainRows; ++m)
-                    {
-                        for(int j = 0; j < tileXSize; j++)
-                        {
-                            // Check for skip value
-                            if(inputData[skipBand][(m*tileXSize)+j] != skipVal)
-                            {
-                                // Check if behaviour is defined for overlap and not the first image
-                                if( (overlapBehaviour > 0) && (ds > 0) )
-                                {
-                                    // Check if pixel is background value (no data has been written yet)
-                                    if( outputData[skipBand][(m*tileXSize)+j] == background )
-                                    {
-                                        for(int n = 0; n < numberBands; n++)
-                                        {
-                                            outputData[n][(m*tileXSize)+j] = inputData[n][(m*tileXSize)+j];
-                                        }
-                                        pixelsChanged = true;
-                                    }
-                                    // If data has been written - check if new value is less (min overlap behaviour)
-                                    else if( (overlapBehaviour == 1) &&  (inputData[skipBand][(m*tileXSize)+j] < outputData[skipBand][(m*tileXSize)+j]) )
-                                    {
-                                        for(int n = 0; n < numberBands; n++)
-                                        {
-                                            outputData[n][(m*tileXSize)+j] = inputData[n][(m*tileXSize)+j];
-                                        }
-                                        pixelsChanged = true;
-                                    }
-                                    // If data has been written - check if new value is greater (max overlap behaviour)
-                                    else if( (overlapBehaviour == 2) &&  (inputData[skipBand][(m*tileXSize)+j] > outputData[skipBand][(m*tileXSize)+j]) )
-                                    {
-                                        for(int n = 0; n < numberBands; n++)
-                                        {
-                                            outputData[n][(m*tileXSize)+j] = inputData[n][(m*tileXSize)+j];
-                                        }
-                                        pixelsChanged = true;
-                                    }
-                                }
-                                // If no overlap behaviour defined, write out,
-                                else
-                                {
-                                    for(int n = 0; n < numberBands; n++)
-                                    {
-                                        outputData[n][(m*tileXSize)+j] = inputData[n][(m*tileXSize)+j];
-                                    }
-                                    pixelsChanged = true;
-                                }
-
-
-                            }
-                        }
-                    }
-
-                    // Write out data
-                    if(pixelsChanged)
-                    {
-                        for(int n = 0; n < numberBands; n++)
-                        {
-                            outputRasterBands[n]->RasterIO(GF_Write, xStart, (yStart + rowOffset), tileXSize, remainRows, outputData[n], tileXSize, remainRows, GDT_Float32, 0, 0);
-                        }
-                    }
-
-                }
-
-                // Tidy up
-                if(inputData != NULL)
-                {
-                    for(int i = 0; i < numberBands; i++)
-                    {
-                        if(inputData[i] != NULL)
-                        {
-                            delete[] inputData[i];
-                        }
-                    }
-                    delete[] inputData;
-                }
-                if(outputData != NULL)
-                {
-                    for(int i = 0; i < numberBands; i++)
-                    {
-                        if(outputData[i] != NULL)
-                        {
-                            delete[] outputData[i];
-                        }
-                    }
-                    delete[] outputData;
-                }
-                if(inputRasterBands != NULL)
-                {
-                    delete[] inputRasterBands;
-                }
-
-                GDALClose(dataset);
-			}
-			std::cout << ".complete\n";
-
-		}
-		catch(RSGISImageBandException &e)
-		{
-            if(inputData != NULL)
+            // Types which do not fit within a float are staged as doubles.
+            if((imgDataType == GDT_Float64) || (imgDataType == GDT_Int32) || (imgDataType == GDT_UInt32))
             {
-                for(int i = 0; i < numberBands; i++)
-                {
-                    if(inputData[i] != NULL)
-                    {
-                        delete[] inputData[i];
-                    }
-                }
-                delete[] inputData;
+                this->mosaicTiles<double>(&inImgs, outputDataset, numberBands, background, skipMode, skipVal, skipUpperThresh, skipBand, overlapBehaviour, GDT_Float64);
             }
-            if(outputData != NULL)
+            else
             {
-                for(int i = 0; i < numberBands; i++)
-                {
-                    if(outputData[i] != NULL)
-                    {
-                        delete[] outputData[i];
-                    }
-                }
-                delete[] outputData;
+                this->mosaicTiles<float>(&inImgs, outputDataset, numberBands, background, skipMode, skipVal, skipUpperThresh, skipBand, overlapBehaviour, GDT_Float32);
             }
-            if(inputRasterBands != NULL)
+        }
+        catch(RSGISImageException &e)
+        {
+            if(dataset != NULL)
             {
-                delete[] inputRasterBands;
+                GDALClose(dataset);
             }
-            if(outputRasterBands != NULL)
+            if(outputDataset != NULL)
             {
-                delete[] outputRasterBands;
+                GDALClose(outputDataset);
             }
-			if(transformation != NULL)
-			{
-				delete[] transformation;
-			}
-			if(imgTransform != NULL)
-			{
-				delete[] imgTransform;
-			}
-			throw e;
-		}
-
-        // Tidy
-        if(outputRasterBands != NULL)
-        {
-            delete[] outputRasterBands;
+            delete[] transformation;
+            throw e;
         }
 
-		if(transformation != NULL)
-		{
-			delete[] transformation;
-		}
-		if(imgTransform != NULL)
-		{
-			delete[] imgTransform;
-		}
-		GDALClose(outputDataset);
-	}
-
-	void RSGISImageMosaic::mosaicSkipThresh(std::string *inputImages, int numDS, std::string outputImage, float background, float skipLowerThresh, float skipUpperThresh, bool projFromImage, std::string proj, unsigned int threshBand, unsigned int overlapBehaviour, std::string format, GDALDataType imgDataType)
-	{
-		RSGISImageUtils imgUtils;
-        rsgis::math::RSGISMathsUtils mathsUtils;
-        GDALAllRegister();
-        GDALDataset *dataset = NULL;
-        GDALRasterBand *imgBand = NULL;
-		int width;
-		int height;
-		double *transformation = new double[6];
-		double *imgTransform = new double[6];
-		int numberBands = 0;
-		int tileXSize = 0;
-		int tileYSize = 0;
-		double xDiff = 0;
-		double yDiff = 0;
-		int xStart = 0;
-		int yStart = 0;
-		std::string projection = proj;
-		GDALDataset *outputDataset = NULL;
-		GDALRasterBand **inputRasterBands = NULL;
-		GDALRasterBand **outputRasterBands = NULL;
-		float **inputData = NULL;
-		float **outputData = NULL;
-		bool pixelsChanged;
-
-        std::vector<std::string> bandnames;
-
-		try
-		{
-			for(int i = 0; i < numDS; i++)
-			{
-                dataset = (GDALDataset *) GDALOpenShared(inputImages[i].c_str(), GA_ReadOnly);
-                if(dataset == NULL)
-                {
-                    std::string message = std::string("Could not open image ") + inputImages[i];
-                    throw RSGISImageException(message.c_str());
-                }
-
-				if(i == 0)
-				{
-					numberBands = dataset->GetRasterCount();
-                    for(int j = 0; j < numberBands; ++j)
-                    {
-                        imgBand = dataset->GetRasterBand(j+1);
-                        bandnames.push_back(std::string(imgBand->GetDescription()));
-                    }
-                    if(projFromImage)
-                    {
-                        projection = std::string(dataset->GetProjectionRef());
-                    }
-				}
-				else
-				{
-					if(dataset->GetRasterCount() != numberBands)
-					{
-						throw RSGISImageBandException("All input images need to have the same number of bands (" + mathsUtils.doubletostring(numberBands) + ").\n"
-                                    + inputImages[i] + " has " + mathsUtils.doubletostring(dataset->GetRasterCount()) );
-					}
-				}
-                GDALClose(dataset);
-			}
-
-			imgUtils.getImagesExtent(inputImages, numDS, &width, &height, transformation);
-
-            // Create blank image
-			std::cout << "Create new image [" << width << "," << height << "] with projection: \n" << projection << std::endl;
-
-			outputDataset = imgUtils.createBlankImage(outputImage, transformation, width, height, numberBands, projection, background, bandnames, format, imgDataType);
-
-			// COPY IMAGE DATA INTO THE BLANK IMAGE
+        delete[] transformation;
+        GDALClose(outputDataset);
+    }
 
-            //Get Image Output Bands
-            outputRasterBands = new GDALRasterBand*[numberBands];
-            for(int i = 0; i < numberBands; i++)
+    template <typename T>
+    void RSGISImageMosaic::mosaicTiles(std::vector<RSGISMosaicInputImg> *inImgs, GDALDataset *outputDataset, int numberBands, T background, unsigned int skipMode, T skipVal, T skipUpperThresh, unsigned int skipBand, unsigned int overlapBehaviour, GDALDataType stageType)
+    {
+        int width = outputDataset->GetRasterXSize();
+        int height = outputDataset->GetRasterYSize();
+
+        // Tiles are a whole number of output blocks of around 512 x 512
+        // pixels, formats with strips of a whole row use more rows instead.
+        int xBlockSize = 0;
+        int yBlockSize = 0;
+        outputDataset->GetRasterBand(1)->GetBlockSize(&xBlockSize, &yBlockSize);
+        xBlockSize = std::max(xBlockSize, 1);
+        yBlockSize = std::max(yBlockSize, 1);
+        int tileXSize = std::min(width, xBlockSize * std::max(1, 512/xBlockSize));
+        int tileYSize = std::max(yBlockSize, ((512*512)/tileXSize)/yBlockSize * yBlockSize);
+        tileYSize = std::min(height, tileYSize);
+        size_t nXTiles = (width + tileXSize - 1) / tileXSize;
+        size_t nYTiles = (height + tileYSize - 1) / tileYSize;
+        size_t nTiles = nXTiles * nYTiles;
+
+        // The input footprints are indexed so each tile is given just the
+        // images which overlap it, in the order they were provided.
+        std::vector<std::vector<size_t> > tileImgs(nTiles);
+        {
+            geos::index::strtree::STRtree imgIdx;
+            std::vector<geos::geom::Envelope*> imgEnvs;
+            std::vector<size_t> imgIdxs(inImgs->size());
+            for(size_t i = 0; i < inImgs->size(); ++i)
             {
-                outputRasterBands[i] = outputDataset->GetRasterBand(i+1);
+                imgIdxs[i] = i;
+                RSGISMosaicInputImg *inImg = &inImgs->at(i);
+                geos::geom::Envelope *env = new geos::geom::Envelope(inImg->xOff, inImg->xOff + inImg->xSize, inImg->yOff, inImg->yOff + inImg->ySize);
+                imgEnvs.push_back(env);
+                imgIdx.insert(env, &imgIdxs[i]);
             }
 
-            int xBlockSize = 0;
-            int yBlockSize = 0;
-            outputRasterBands[0]->GetBlockSize (&xBlockSize, &yBlockSize);
-
-			std::cout << "Started (total " << numDS << ") ." << std::flush;
-
-            for(int ds = 0; ds < numDS; ds++)
-			{
-				std::cout << "." << ds+1 << "." << std::flush;
-
-                dataset = (GDALDataset *) GDALOpenShared(inputImages[ds].c_str(), GA_ReadOnly);
-                if(dataset == NULL)
-                {
-                    std::string message = std::string("Could not open image ") + inputImages[ds];
-                    throw RSGISImageException(message.c_str());
-                }
-
-                inputRasterBands = new GDALRasterBand*[numberBands];
-                for(int i = 0; i < numberBands; i++)
+            std::vector<void*> found;
+            for(size_t tile = 0; tile < nTiles; ++tile)
+            {
+                int tXOff = (tile % nXTiles) * tileXSize;
+                int tYOff = (tile / nXTiles) * tileYSize;
+                geos::geom::Envelope tileEnv(tXOff, tXOff + tileXSize, tYOff, tYOff + tileYSize);
+                found.clear();
+                imgIdx.query(&tileEnv, found);
+                for(std::vector<void*>::iterator iterFound = found.begin(); iterFound != found.end(); ++iterFound)
                 {
-                    inputRasterBands[i] = dataset->GetRasterBand(i+1);
+                    tileImgs[tile].push_back(*((size_t*)(*iterFound)));
                 }
+                std::sort(tileImgs[tile].begin(), tileImgs[tile].end());
+            }
 
-				dataset->GetGeoTransform(imgTransform);
-				tileXSize = dataset->GetRasterXSize();
-				tileYSize = dataset->GetRasterYSize();
-
-				xDiff = imgTransform[0] - transformation[0];
-				yDiff = transformation[3] - imgTransform[3];
-
-				xStart = floor((xDiff/transformation[1])+0.5);
-				yStart = floor((yDiff/transformation[1])+0.5);
+            for(std::vector<geos::geom::Envelope*>::iterator iterEnv = imgEnvs.begin(); iterEnv != imgEnvs.end(); ++iterEnv)
+            {
+                delete *iterEnv;
+            }
+        }
 
-                // Allocate memory
-                inputData = new float*[numberBands];
-                outputData = new float*[numberBands];
-                for(int i = 0; i < numberBands; i++)
+        std::cout << "Mosaicking " << inImgs->size() << " images as " << nTiles << " tiles using " << this->numThreads << " threads." << std::endl;
+
+        // GDAL and some drivers are not thread safe, so every GDAL call
+        // (opening, reading, writing and closing) is made under ioMutex and
+        // only the compositing of the tiles runs in parallel.
+        std::mutex ioMutex;
+        RSGISProgressCounter progress(nTiles);
+        rsgis::utils::RSGISWorkerPool pool(std::max<unsigned int>(1, std::min<size_t>(this->numThreads, nTiles)));
+        // Each worker has its own datasets for the inputs, the most recently
+        // used are kept open as neighbouring tiles will generally need the
+        // same images.
+        std::vector<std::deque<std::pair<size_t, GDALDataset*> > > threadOpenImgs(pool.getNumThreads());
+        const size_t maxOpenImgs = 32;
+        std::vector<std::vector<T> > threadOutData(pool.getNumThreads());
+        std::vector<std::vector<T> > threadInData(pool.getNumThreads());
+        GSpacing pxlSpace = numberBands * sizeof(T);
+        auto closeOpenImgs = [&threadOpenImgs]()
+        {
+            for(size_t t = 0; t < threadOpenImgs.size(); ++t)
+            {
+                for(std::deque<std::pair<size_t, GDALDataset*> >::iterator iterOpen = threadOpenImgs[t].begin(); iterOpen != threadOpenImgs[t].end(); ++iterOpen)
                 {
-                    inputData[i] = (float *) CPLMalloc(sizeof(float)*(tileXSize*yBlockSize));
-                    outputData[i] = (float *) CPLMalloc(sizeof(float)*(tileXSize*yBlockSize));
+                    GDALClose(iterOpen->second);
                 }
-
-                int nYBlocks = tileYSize / yBlockSize;
-                int remainRows = tileYSize - (nYBlocks * yBlockSize);
-                int rowOffset = 0;
-
-                for(int i = 0; i < nYBlocks; i++)
-                {
-                    // Read input and output data
-                    for(int n = 0; n < numberBands; n++)
-                    {
-                        rowOffset = yBlockSize * i;
-                        // Read input data
-                        inputRasterBands[n]->RasterIO(GF_Read, 0, rowOffset, tileXSize, yBlockSize, inputData[n], tileXSize, yBlockSize, GDT_Float32, 0, 0);
-                        // Read output data
-                        outputRasterBands[n]->RasterIO(GF_Read, xStart, (yStart + rowOffset), tileXSize, yBlockSize, outputData[n], tileXSize, yBlockSize, GDT_Float32, 0, 0);
-                    }
-
-                    pixelsChanged = false; // Keep track if there are changes that need writing out.
-
-                    for(int m = 0; m < yBlockSize; ++m)
-                    {
-                        for(int j = 0; j < tileXSize; j++)
-                        {
-                            // Check value is between upper and lower limits
-                            if((inputData[threshBand][(m*tileXSize)+j] > skipLowerThresh) && (inputData[threshBand][(m*tileXSize)+j] < skipUpperThresh))
-                            {
-                                // Check if behaviour is defined for overlap and not the first image
-                                if( (overlapBehaviour > 0) && (ds > 0) )
-                                {
-                                    // Check if pixel is background value (no data has been written yet)
-                                    if( outputData[threshBand][(m*tileXSize)+j] == background )
-                                    {
-                                        for(int n = 0; n < numberBands; n++)
-                                        {
-                                            outputData[n][(m*tileXSize)+j] = inputData[n][(m*tileXSize)+j];
-                                        }
-                                        pixelsChanged = true;
-                                    }
-                                    // If data has been written - check if new value is less (min overlap behaviour)
-                                    else if( (overlapBehaviour == 1) &&  (inputData[threshBand][(m*tileXSize)+j] < outputData[threshBand][(m*tileXSize)+j]) )
-                                    {
-                                        for(int n = 0; n < numberBands; n++)
-                                        {
-                                            outputData[n][(m*tileXSize)+j] = inputData[n][(m*tileXSize)+j];
-                                        }
-                                        pixelsChanged = true;
-                                    }
-                                    // If data has been written - check if new value is greater (max overlap behaviour)
-                                    else if( (overlapBehaviour == 2) &&  (inputData[threshBand][(m*tileXSize)+j] > outputData[threshBand][(m*tileXSize)+j]) )
-                                    {
-                                        for(int n = 0; n < numberBands; n++)
-                                        {
-                                            outputData[n][(m*tileXSize)+j] = inputData[n][(m*tileXSize)+j];
-                                        }
-                                        pixelsChanged = true;
-                                    }
-                                }
-                                // If no overlap behaviour defined, write out,
-                                else
-                                {
-                                    for(int n = 0; n < numberBands; n++)
-                                    {
-                                        outputData[n][(m*tileXSize)+j] = inputData[n][(m*tileXSize)+j];
-                                    }
-                                    pixelsChanged = true;
-                                }
-
-
-                            }
-                        }
-                    }
-
-                    // Write out data to mosaic
-                    if(pixelsChanged)
-                    {
-                        for(int n = 0; n < numberBands; n++)
-                        {
-                            outputRasterBands[n]->RasterIO(GF_Write, xStart, (yStart + rowOffset), tileXSize, yBlockSize, outputData[n], tileXSize, yBlockSize, GDT_Float32, 0, 0);
-                        }
-                    }
-
-                }
-
-                if(remainRows > 0)
-                {
-                    for(int n = 0; n < numberBands; n++)
-                    {
-                        rowOffset = yBlockSize * nYBlocks;
-                        // Read input data
-                        inputRasterBands[n]->RasterIO(GF_Read, 0, rowOffset, tileXSize, remainRows, inputData[n], tileXSize, remainRows, GDT_Float32, 0, 0);
-                        // Read output data
-                        outputRasterBands[n]->RasterIO(GF_Read, xStart, (yStart + rowOffset), tileXSize, remainRows, outputData[n], tileXSize, remainRows, GDT_Float32, 0, 0);
-                    }
-
-                    pixelsChanged = false; // Keep track if there are changes that need writing out.
-
-                    for(int m = 0; m < remainRows; ++m)
-                    {
-                        for(int j = 0; j < tileXSize; j++)
-                        {
-                            // Check value is between upper and lower limits
-                            if((inputData[threshBand][(m*tileXSize)+j] > skipLowerThresh) && (inputData[threshBand][(m*tileXSize)+j] < skipUpperThresh))
-                            {
-                                // Check if behaviour is defined for overlap and not the first image
-                                if( (overlapBehaviour > 0) && (ds > 0) )
-                                {
-                                    // Check if pixel is background value (no data has been written yet)
-                                    if( outputData[threshBand][(m*tileXSize)+j] == background )
-                                    {
-                                        for(int n = 0; n < numberBands; n++)
-                                        {
-                                            outputData[n][(m*tileXSize)+j] = inputData[n][(m*tileXSize)+j];
-                                        }
-                                        pixelsChanged = true;
-                                    }
-                                    // If data has been written - check if new value is less (min overlap behaviour)
-                                    else if( (overlapBehaviour == 1) &&  (inputData[threshBand][(m*tileXSize)+j] < outputData[threshBand][(m*tileXSize)+j]) )
-                                    {
-                                        for(int n = 0; n < numberBands; n++)
-                                        {
-                                            outputData[n][(m*tileXSize)+j] = inputData[n][(m*tileXSize)+j];
-                                        }
-                                        pixelsChanged = true;
-                                    }
-                                    // If data has been written - check if new value is greater (max overlap behaviour)
-                                    else if( (overlapBehaviour == 2) &&  (inputData[threshBand][(m*tileXSize)+j] > outputData[threshBand][(m*tileXSize)+j]) )
-                                    {
-                                        for(int n = 0; n < numberBands; n++)
-                                        {
-                                            outputData[n][(m*tileXSize)+j] = inputData[n][(m*tileXSize)+j];
-                                        }
-                                        pixelsChanged = true;
-                                    }
-                                }
-                                // If no overlap behaviour defined, write out,
-                                else
-                                {
-                                    for(int n = 0; n < numberBands; n++)
-                                    {
-                                        outputData[n][(m*tileXSize)+j] = inputData[n][(m*tileXSize)+j];
-                                    }
-                                    pixelsChanged = true;
-                                }
-
-
-                            }
-                        }
+                threadOpenImgs[t].clear();
+            }
+        };
+        try
+        {
+            pool.parallelFor(nTiles, [&](size_t tile, unsigned int t)
+            {
+                std::deque<std::pair<size_t, GDALDataset*> > &openImgs = threadOpenImgs[t];
+                std::vector<T> &outData = threadOutData[t];
+                std::vector<T> &inData = threadInData[t];
+                int tXOff = (tile % nXTiles) * tileXSize;
+                int tYOff = (tile / nXTiles) * tileYSize;
+                int tXSize = std::min(tileXSize, width - tXOff);
+                int tYSize = std::min(tileYSize, height - tYOff);
+                outData.assign(((size_t)tXSize) * tYSize * numberBands, background);
+
+                for(std::vector<size_t>::iterator iterImg = tileImgs[tile].begin(); iterImg != tileImgs[tile].end(); ++iterImg)
+                {
+                    size_t ds = *iterImg;
+                    RSGISMosaicInputImg *inImg = &inImgs->at(ds);
+                    int xMin = std::max(tXOff, inImg->xOff);
+                    int xMax = std::min(tXOff + tXSize, inImg->xOff + inImg->xSize);
+                    int yMin = std::max(tYOff, inImg->yOff);
+                    int yMax = std::min(tYOff + tYSize, inImg->yOff + inImg->ySize);
+                    if((xMax <= xMin) || (yMax <= yMin))
+                    {
+                        continue;
                     }
+                    int winXSize = xMax - xMin;
+                    int winYSize = yMax - yMin;
 
-                    // Write out data
-                    if(pixelsChanged)
+                    std::unique_lock<std::mutex> ioLock(ioMutex);
+                    GDALDataset *inDataset = NULL;
+                    for(std::deque<std::pair<size_t, GDALDataset*> >::iterator iterOpen = openImgs.begin(); iterOpen != openImgs.end(); ++iterOpen)
                     {
-                        for(int n = 0; n < numberBands; n++)
+                        if(iterOpen->first == ds)
                         {
-                            outputRasterBands[n]->RasterIO(GF_Write, xStart, (yStart + rowOffset), tileXSize, remainRows, outputData[n], tileXSize, remainRows, GDT_Float32, 0, 0);
+                            inDataset = iterOpen->second;
+                            openImgs.erase(iterOpen);
+                            break;
                         }
                     }
-
-                }
-
-                // Tidy up
-                if(inputData != NULL)
-                {
-                    for(int i = 0; i < numberBands; i++)
+                    if(inDataset == NULL)
                     {
-                        if(inputData[i] != NULL)
+                        inDataset = (GDALDataset *) GDALOpen(inImg->imageFile.c_str(), GA_ReadOnly);
+                        if(inDataset == NULL)
                         {
-                            delete[] inputData[i];
+                            std::string message = std::string("Could not open image ") + inImg->imageFile;
+                            throw RSGISImageException(message.c_str());
                         }
                     }
-                    delete[] inputData;
-                }
-                if(outputData != NULL)
-                {
-                    for(int i = 0; i < numberBands; i++)
+                    openImgs.push_front(std::pair<size_t, GDALDataset*>(ds, inDataset));
+                    if(openImgs.size() > maxOpenImgs)
                     {
-                        if(outputData[i] != NULL)
-                        {
-                            delete[] outputData[i];
-                        }
+                        GDALClose(openImgs.back().second);
+                        openImgs.pop_back();
                     }
-                    delete[] outputData;
-                }
-                if(inputRasterBands != NULL)
-                {
-                    delete[] inputRasterBands;
-                }
-
-                GDALClose(dataset);
-			}
-			std::cout << ".complete\n";
 
-		}
-		catch(RSGISImageBandException &e)
-		{
-            if(inputData != NULL)
-            {
-                for(int i = 0; i < numberBands; i++)
-                {
-                    if(inputData[i] != NULL)
+                    inData.resize(((size_t)winXSize) * winYSize * numberBands);
+                    if(inDataset->RasterIO(GF_Read, xMin - inImg->xOff, yMin - inImg->yOff, winXSize, winYSize, inData.data(), winXSize, winYSize, stageType, numberBands, NULL, pxlSpace, pxlSpace * winXSize, sizeof(T), NULL) != CE_None)
                     {
-                        delete[] inputData[i];
+                        std::string message = std::string("Could not read image ") + inImg->imageFile;
+                        throw RSGISImageException(message.c_str());
                     }
-                }
-                delete[] inputData;
-            }
-            if(outputData != NULL)
-            {
-                for(int i = 0; i < numberBands; i++)
-                {
-                    if(outputData[i] != NULL)
+                    ioLock.unlock();
+
+                    for(int y = 0; y < winYSize; ++y)
                     {
-                        delete[] outputData[i];
+                        T *inPxl = &inData[((size_t)y) * winXSize * numberBands];
+                        T *outPxl = &outData[((((size_t)(yMin - tYOff + y)) * tXSize) + (xMin - tXOff)) * numberBands];
+                        for(int x = 0; x < winXSize; ++x, inPxl += numberBands, outPxl += numberBands)
+                        {
+                            T inVal = inPxl[skipBand];
+                            if((skipMode == 1) && (inVal == skipVal))
+                            {
+                                continue;
+                            }
+                            else if((skipMode == 2) && !((inVal > skipVal) && (inVal < skipUpperThresh)))
+                            {
+                                continue;
+                            }
+                            // Where overlap behaviour is defined, pixels already given a value by an earlier image are only replaced by a smaller (1) or larger (2) value.
+                            if((overlapBehaviour > 0) && (ds > 0))
+                            {
+                                T outVal = outPxl[skipBand];
+                                if(!((outVal == background) || ((overlapBehaviour == 1) && (inVal < outVal)) || ((overlapBehaviour == 2) && (inVal > outVal))))
+                                {
+                                    continue;
+                                }
+                            }
+                            for(int n = 0; n < numberBands; ++n)
+                            {
+                                outPxl[n] = inPxl[n];
+                            }
+                        }
                     }
                 }
-                delete[] outputData;
-            }
-            if(inputRasterBands != NULL)
-            {
-                delete[] inputRasterBands;
-            }
-            if(outputRasterBands != NULL)
-            {
-                delete[] outputRasterBands;
-            }
-			if(transformation != NULL)
-			{
-				delete[] transformation;
-			}
-			if(imgTransform != NULL)
-			{
-				delete[] imgTransform;
-			}
-			throw e;
-		}
 
-        // Tidy
-        if(outputRasterBands != NULL)
+                std::lock_guard<std::mutex> writeLock(ioMutex);
+                if(outputDataset->RasterIO(GF_Write, tXOff, tYOff, tXSize, tYSize, outData.data(), tXSize, tYSize, stageType, numberBands, NULL, pxlSpace, pxlSpace * tXSize, sizeof(T), NULL) != CE_None)
+                {
+                    throw RSGISImageException("Could not write a tile to the output image.");
+                }
+                progress.add();
+            });
+        }
+        catch(...)
         {
-            delete[] outputRasterBands;
+            closeOpenImgs();
+            throw;
         }
-
-		if(transformation != NULL)
-		{
-			delete[] transformation;
-		}
-		if(imgTransform != NULL)
-		{
-			delete[] imgTransform;
-		}
-		GDALClose(outputDataset);
-	}
+        closeOpenImgs();
+        progress.finish();
+    }
 
 	void RSGISImageMosaic::includeDatasets(GDALDataset *baseImage, std::string *inputImages, int numDS, std::vector<int> bands, bool bandsDefined)
 	{
@@ -1137,9 +509,12 @@ namespace rsgis{namespace img{
                 int nYBlocks = tileYSize / yBlockSize;
                 int remainRows = tileYSize - (nYBlocks * yBlockSize);
                 int rowOffset = 0;
+                // Remote inputs are read ahead in a few large requests, see RSGISImageReadPlanner.
+                RSGISImageReadPlanner readPlanner(dataset, 0, 0, tileXSize, tileYSize, yBlockSize);
 
                 for(int i = 0; i < nYBlocks; i++)
                 {
+                    readPlanner.prefetch(i);
                     rowOffset = yBlockSize * i;
                     if(bandsDefined)
                     {
@@ -1177,6 +552,7 @@ namespace rsgis{namespace img{
                 }
                 if(remainRows > 0)
                 {
+                    readPlanner.prefetch(nYBlocks);
                     rowOffset = yBlockSize * nYBlocks;
                     if(bandsDefined)
                     {
@@ -1386,9 +762,11 @@ namespace rsgis{namespace img{
                 int nYBlocks = (tileYSize / yBlockSize);
                 int remainRows = tileYSize - (nYBlocks * yBlockSize);
                 int rowOffset = 0;
+                RSGISImageReadPlanner readPlanner(dataset, 0, 0, tileXSize, tileYSize, yBlockSize);
                 
                 for(int j = 0; j < nYBlocks; j++)
                 {
+                    readPlanner.prefetch(j);
                     rowOffset = yBlockSize * j;
                     if(bandsDefined)
                     {
@@ -1447,6 +825,7 @@ namespace rsgis{namespace img{
                 
                 if(remainRows > 0)
                 {
+                    readPlanner.prefetch(nYBlocks);
                     for(unsigned long m = 0; m < numPxlsInBlock; ++m)
                     {
                         imgInData[m] = 0;
@@ -1672,9 +1051,11 @@ namespace rsgis{namespace img{
                 int nYBlocks = tileYSize / yBlockSize;
                 int remainRows = tileYSize - (nYBlocks * yBlockSize);
                 int rowOffset = 0;
+                RSGISImageReadPlanner readPlanner(dataset, numOverlapPxls, numOverlapPxls, tileXSize, tileYSize, yBlockSize);
                 
                 for(int i = 0; i < nYBlocks; i++)
                 {
+                    readPlanner.prefetch(i);
                     rowOffset = (yBlockSize * i);// + numOverlapPxls;
                     
                     for(int n = 1; n <= numberBands; n++)
@@ -1688,6 +1069,7 @@ namespace rsgis{namespace img{
                 }
                 if(remainRows > 0)
                 {
+                    readPlanner.prefetch(nYBlocks);
                     rowOffset = (yBlockSize * nYBlocks);// + numOverlapPxls;
                     
                     for(int n = 1; n <= numberBands; n++)
@@ -1730,72 +1112,55 @@ namespace rsgis{namespace img{
         }
     }
     
-    void RSGISImageMosaic::orderInImagesValidData(std::vector<std::string> images, std::vector<std::string> *orderedImages, float noDataValue)
+    void RSGISImageMosaic::orderInImagesValidData(std::vector<std::string> images, std::vector<std::string> *orderedImages, float noDataValue, bool exactCount)
     {
         try
         {
-            RSGISImageValidDataMetric *validPxlCountObj = new RSGISImageValidDataMetric();
-            RSGISCountValidPixels *calcImageValidPxlCount = new RSGISCountValidPixels(validPxlCountObj, noDataValue);
-			RSGISCalcImage calcImg = RSGISCalcImage(calcImageValidPxlCount, "", true);
-
-            std::list<RSGISImageValidDataMetric> validDataImageMetrics;
-            for(std::vector<std::string>::iterator iterImage = images.begin(); iterImage != images.end(); ++iterImage)
+            std::vector<RSGISImageValidDataMetric> validDataImageMetrics(images.size());
+            RSGISProgressCounter progress(images.size());
+            // GDAL is not thread safe so every GDAL call (opening, reading the
+            // metadata, reading and closing) is made under ioMutex; only the
+            // counting of the valid pixels runs in parallel.
+            std::mutex ioMutex;
+            rsgis::utils::parallelFor(images.size(), this->numThreads, [&](size_t i, unsigned int)
             {
-                // Calculate Valid Pixel Count.
-                validPxlCountObj->totalNumPxls = 0;
-                validPxlCountObj->validPxlCount = 0;
-                validPxlCountObj->noDataPxlCount = 0;
-                calcImageValidPxlCount->resetValidPxlsObj();
-
-                std::cout << "Processing Image: " << (*iterImage) << std::endl;
-                GDALDataset *dataset = (GDALDataset *) GDALOpen((*iterImage).c_str(), GA_ReadOnly);
+                GDALDataset *dataset = NULL;
+                {
+                    std::lock_guard<std::mutex> ioLock(ioMutex);
+                    dataset = (GDALDataset *) GDALOpen(images[i].c_str(), GA_ReadOnly);
+                }
                 if(dataset == NULL)
                 {
-                    std::string message = std::string("Could not open image ") + (*iterImage);
-                    throw rsgis::RSGISImageException(message.c_str());
+                    std::string message = std::string("Could not open image ") + images[i];
+                    throw RSGISImageException(message.c_str());
                 }
-
                 try
                 {
-                    calcImg.calcImage(&dataset, 1);
-
-                    RSGISImageValidDataMetric imgDataMetric;
-                    imgDataMetric.imageFile = (*iterImage);
-                    imgDataMetric.totalNumPxls = validPxlCountObj->totalNumPxls;
-                    imgDataMetric.validPxlCount = validPxlCountObj->validPxlCount;
-                    imgDataMetric.noDataPxlCount = validPxlCountObj->noDataPxlCount;
-                    imgDataMetric.validPxlFunc = ((double)validPxlCountObj->validPxlCount) / ((double)validPxlCountObj->totalNumPxls);
-
-                    validDataImageMetrics.push_back(imgDataMetric);
-
-                    GDALClose(dataset);
+                    validDataImageMetrics[i] = this->calcImageValidData(dataset, noDataValue, exactCount, &ioMutex);
                 }
-                catch (rsgis::RSGISException &e)
+                catch(...)
                 {
-                    delete validPxlCountObj;
-                    delete calcImageValidPxlCount;
+                    std::lock_guard<std::mutex> ioLock(ioMutex);
                     GDALClose(dataset);
-                    throw RSGISImageException(e.what());
+                    throw;
                 }
-                catch (std::exception &e)
                 {
-                    delete validPxlCountObj;
-                    delete calcImageValidPxlCount;
+                    std::lock_guard<std::mutex> ioLock(ioMutex);
                     GDALClose(dataset);
-                    throw RSGISImageException(e.what());
                 }
-            }
+                validDataImageMetrics[i].imageFile = images[i];
+                progress.add();
+            });
+            progress.finish();
 
-            validDataImageMetrics.sort(compare_ImageValidPxlCounts);
+            // Images with the same proportion stay in the order given.
+            std::stable_sort(validDataImageMetrics.begin(), validDataImageMetrics.end(), compare_ImageValidPxlCounts);
 
             orderedImages->clear();
-            for(std::list<RSGISImageValidDataMetric>::iterator iterImage = validDataImageMetrics.begin(); iterImage != validDataImageMetrics.end(); ++iterImage)
+            for(std::vector<RSGISImageValidDataMetric>::iterator iterImage = validDataImageMetrics.begin(); iterImage != validDataImageMetrics.end(); ++iterImage)
             {
                 orderedImages->push_back((*iterImage).imageFile);
             }
-
-            delete validPxlCountObj;
-            delete calcImageValidPxlCount;
         }
         catch (RSGISImageException &e)
         {
@@ -1811,6 +1176,264 @@ namespace rsgis{namespace img{
         }
     }
 
+    RSGISImageValidDataMetric RSGISImageMosaic::calcImageValidData(GDALDataset *dataset, float noDataValue, bool exactCount)
+    {
+        return this->calcImageValidData(dataset, noDataValue, exactCount, NULL);
+    }
+
+    RSGISImageValidDataMetric RSGISImageMosaic::calcImageValidData(GDALDataset *dataset, float noDataValue, bool exactCount, std::mutex *ioMutex)
+    {
+        // The lock is held for the metadata and the choice of the source, and
+        // released before the pixels are counted (countValidPixels takes it
+        // for each read).
+        std::unique_lock<std::mutex> ioLock;
+        if(ioMutex != NULL)
+        {
+            ioLock = std::unique_lock<std::mutex>(*ioMutex);
+        }
+        int numBands = dataset->GetRasterCount();
+        if(numBands == 0)
+        {
+            throw RSGISImageException("The image does not have any bands.");
+        }
+        int xSize = dataset->GetRasterXSize();
+        int ySize = dataset->GetRasterYSize();
+        std::vector<GDALRasterBand*> bands;
+        for(int n = 0; n < numBands; ++n)
+        {
+            bands.push_back(dataset->GetRasterBand(n+1));
+        }
+
+        RSGISImageValidDataMetric metric;
+        metric.validPxlCount = 0;
+        metric.noDataPxlCount = 0;
+        metric.totalNumPxls = 0;
+        metric.validPxlFunc = 0;
+        metric.source = rsgis_validdata_exact;
+
+        const int minSampleSize = 512;
+        const int maxSampleSize = 1024;
+        bool estimated = false;
+        unsigned long long validCount = 0;
+        unsigned long long totalCount = 0;
+        if(!exactCount)
+        {
+            double validFrac = 0;
+            if(this->validDataFromMetadata(dataset, noDataValue, &validFrac))
+            {
+                // The counts are for the whole image.
+                totalCount = ((unsigned long long)xSize) * ySize;
+                validCount = (unsigned long long) std::llround(validFrac * totalCount);
+                metric.source = rsgis_validdata_metadata;
+                estimated = true;
+            }
+
+            if((!estimated) && (bands[0]->GetOverviewCount() > 0))
+            {
+                // The coarsest overview with at least minSampleSize x minSampleSize
+                // pixels, or the finest if they are all smaller.
+                int ovIdx = -1;
+                unsigned long long ovPxls = 0;
+                for(int o = 0; o < bands[0]->GetOverviewCount(); ++o)
+                {
+                    GDALRasterBand *ovBand = bands[0]->GetOverview(o);
+                    if(ovBand == NULL)
+                    {
+                        continue;
+                    }
+                    unsigned long long nPxls = ((unsigned long long)ovBand->GetXSize()) * ovBand->GetYSize();
+                    bool largeEnough = (nPxls >= (((unsigned long long)minSampleSize) * minSampleSize));
+                    bool currLargeEnough = (ovPxls >= (((unsigned long long)minSampleSize) * minSampleSize));
+                    if((ovIdx < 0) || (largeEnough && ((!currLargeEnough) || (nPxls < ovPxls))) || ((!largeEnough) && (!currLargeEnough) && (nPxls > ovPxls)))
+                    {
+                        ovIdx = o;
+                        ovPxls = nPxls;
+                    }
+                }
+                std::vector<GDALRasterBand*> ovBands;
+                if(ovIdx >= 0)
+                {
+                    GDALRasterBand *firstOvBand = bands[0]->GetOverview(ovIdx);
+                    for(int n = 0; n < numBands; ++n)
+                    {
+                        GDALRasterBand *ovBand = (ovIdx < bands[n]->GetOverviewCount())?bands[n]->GetOverview(ovIdx):NULL;
+                        if((ovBand == NULL) || (ovBand->GetXSize() != firstOvBand->GetXSize()) || (ovBand->GetYSize() != firstOvBand->GetYSize()))
+                        {
+                            ovBands.clear();
+                            break;
+                        }
+                        ovBands.push_back(ovBand);
+                    }
+                }
+                if(!ovBands.empty())
+                {
+                    int ovXSize = ovBands[0]->GetXSize();
+                    int ovYSize = ovBands[0]->GetYSize();
+                    if(ioLock.owns_lock())
+                    {
+                        ioLock.unlock();
+                    }
+                    this->countValidPixels(ovBands, ovXSize, ovYSize, noDataValue, &validCount, &totalCount, ioMutex);
+                    metric.source = rsgis_validdata_overview;
+                    estimated = true;
+                }
+            }
+
+            if((!estimated) && (std::max(xSize, ySize) > maxSampleSize))
+            {
+                int step = (std::max(xSize, ySize) + maxSampleSize - 1) / maxSampleSize;
+                if(ioLock.owns_lock())
+                {
+                    ioLock.unlock();
+                }
+                this->countValidPixels(bands, std::max((xSize + step - 1) / step, 1), std::max((ySize + step - 1) / step, 1), noDataValue, &validCount, &totalCount, ioMutex);
+                metric.source = rsgis_validdata_sample;
+                estimated = true;
+            }
+        }
+
+        if(!estimated)
+        {
+            if(ioLock.owns_lock())
+            {
+                ioLock.unlock();
+            }
+            this->countValidPixels(bands, xSize, ySize, noDataValue, &validCount, &totalCount, ioMutex);
+            metric.source = rsgis_validdata_exact;
+        }
+        else if(totalCount > 0)
+        {
+            // Estimates are scaled to the full resolution image.
+            unsigned long long imgPxls = ((unsigned long long)xSize) * ySize;
+            validCount = (unsigned long long) std::llround((((double)validCount) / totalCount) * imgPxls);
+            totalCount = imgPxls;
+        }
+
+        metric.totalNumPxls = totalCount;
+        metric.validPxlCount = std::min(validCount, totalCount);
+        metric.noDataPxlCount = totalCount - metric.validPxlCount;
+        metric.validPxlFunc = (totalCount > 0)?(((double)metric.validPxlCount) / ((double)totalCount)):0;
+        return metric;
+    }
+
+    bool RSGISImageMosaic::validDataFromMetadata(GDALDataset *dataset, float noDataValue, double *validFrac)
+    {
+        // A pixel is valid where any band is, so the image has at least the
+        // proportion of the band with the most valid pixels (equal where the
+        // bands share a mask, as is usual).
+        unsigned long long imgPxls = ((unsigned long long)dataset->GetRasterXSize()) * dataset->GetRasterYSize();
+        if(imgPxls == 0)
+        {
+            return false;
+        }
+        double maxFrac = 0;
+        for(int n = 1; n <= dataset->GetRasterCount(); ++n)
+        {
+            GDALRasterBand *band = dataset->GetRasterBand(n);
+            // The stored statistics only exclude the no data value defined on the band.
+            int hasNoData = FALSE;
+            double bandNoData = band->GetNoDataValue(&hasNoData);
+            if((!hasNoData) || (((float)bandNoData) != noDataValue))
+            {
+                return false;
+            }
+
+            double bandFrac = -1;
+            const char *validPercent = band->GetMetadataItem("STATISTICS_VALID_PERCENT");
+            if(validPercent != NULL)
+            {
+                bandFrac = atof(validPercent) / 100.0;
+            }
+            else
+            {
+                double histMin = 0;
+                double histMax = 0;
+                int numBuckets = 0;
+                GUIntBig *histogram = NULL;
+                // Only a stored histogram is used (not forced to be calculated).
+                if((band->GetDefaultHistogram(&histMin, &histMax, &numBuckets, &histogram, FALSE, NULL, NULL) == CE_None) && (histogram != NULL))
+                {
+                    unsigned long long histCount = 0;
+                    for(int i = 0; i < numBuckets; ++i)
+                    {
+                        histCount += histogram[i];
+                    }
+                    bandFrac = ((double)histCount) / imgPxls;
+                }
+                if(histogram != NULL)
+                {
+                    CPLFree(histogram);
+                }
+            }
+            if((bandFrac < 0) || (bandFrac > 1))
+            {
+                return false;
+            }
+            maxFrac = std::max(maxFrac, bandFrac);
+        }
+        *validFrac = maxFrac;
+        return true;
+    }
+
+    void RSGISImageMosaic::countValidPixels(std::vector<GDALRasterBand*> &bands, int bufXSize, int bufYSize, float noDataValue, unsigned long long *validCount, unsigned long long *totalCount, std::mutex *ioMutex)
+    {
+        std::unique_lock<std::mutex> ioLock;
+        if(ioMutex != NULL)
+        {
+            ioLock = std::unique_lock<std::mutex>(*ioMutex);
+        }
+        size_t numBands = bands.size();
+        int xSize = bands[0]->GetXSize();
+        int ySize = bands[0]->GetYSize();
+        int xBlockSize = 0;
+        int yBlockSize = 0;
+        bands[0]->GetBlockSize(&xBlockSize, &yBlockSize);
+        if(ioMutex != NULL)
+        {
+            ioLock.unlock();
+        }
+        // Strips of whole blocks of the source rows.
+        int stripRows = std::max(1, (int)((((long long)std::max(yBlockSize, 1)) * bufYSize) / ySize));
+        stripRows = std::min(std::max(stripRows, 16), bufYSize);
+        std::vector<float> data(((size_t)bufXSize) * stripRows * numBands);
+        *validCount = 0;
+        *totalCount = 0;
+        for(int bufYOff = 0; bufYOff < bufYSize; bufYOff += stripRows)
+        {
+            int nBufRows = std::min(stripRows, bufYSize - bufYOff);
+            int yOff = (int)((((long long)bufYOff) * ySize) / bufYSize);
+            int yEnd = (int)((((long long)(bufYOff + nBufRows)) * ySize) / bufYSize);
+            size_t bandStride = ((size_t)bufXSize) * nBufRows;
+            if(ioMutex != NULL)
+            {
+                ioLock.lock();
+            }
+            for(size_t n = 0; n < numBands; ++n)
+            {
+                if(bands[n]->RasterIO(GF_Read, 0, yOff, xSize, yEnd - yOff, &data[n * bandStride], bufXSize, nBufRows, GDT_Float32, 0, 0) != CE_None)
+                {
+                    throw RSGISImageException("Could not read the image to count the valid pixels.");
+                }
+            }
+            if(ioMutex != NULL)
+            {
+                ioLock.unlock();
+            }
+            for(size_t i = 0; i < bandStride; ++i)
+            {
+                for(size_t n = 0; n < numBands; ++n)
+                {
+                    if(data[(n * bandStride) + i] != noDataValue)
+                    {
+                        ++(*validCount);
+                        break;
+                    }
+                }
+            }
+            *totalCount += bandStride;
+        }
+    }
+
 	RSGISImageMosaic::~RSGISImageMosaic()
 	{
 
@@ -1861,7 +1484,12 @@ namespace rsgis{namespace img{
 
     RSGISCombineImgTileOverview::RSGISCombineImgTileOverview()
     {
-        
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+    
+    void RSGISCombineImgTileOverview::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
     }
     
     void RSGISCombineImgTileOverview::combineKEAImgTileOverviews(GDALDataset *baseImg, std::vector<std::string> inputImages, std::vector<int> pyraScaleVals)
@@ -1871,7 +1499,6 @@ namespace rsgis{namespace img{
             RSGISImageUtils imgUtils;
             int numberBands = baseImg->GetRasterCount();
             int numOverviews = pyraScaleVals.size();
-            std::string projection;
             GDALDataset *dataset = NULL;
             
             if( numOverviews == 0 )
@@ -1881,7 +1508,7 @@ namespace rsgis{namespace img{
             
             for(std::vector<std::string>::iterator iterImgFile = inputImages.begin(); iterImgFile != inputImages.end(); ++iterImgFile)
             {                
-                dataset = (GDALDataset *) GDALOpenShared((*iterImgFile).c_str(), GA_ReadOnly);
+                dataset = (GDALDataset *) GDALOpen((*iterImgFile).c_str(), GA_ReadOnly);
                 if(dataset == NULL)
                 {
                     std::string message = std::string("Could not open image ") + (*iterImgFile);
@@ -1890,25 +1517,17 @@ namespace rsgis{namespace img{
                 
                 if(dataset->GetRasterCount() != numberBands)
                 {
+                    GDALClose(dataset);
                     throw RSGISImageBandException("All input images need to have the same number of bands.");
                 }
-  
-                // Check the number of overviews is the same for all input images and number of levels specified.
-                for(int i = 0; i < numberBands; ++i)
-                {
-                    if(dataset->GetRasterBand(i+1)->GetOverviewCount() != numOverviews)
-                    {
-                        throw RSGISImageBandException("All input images and bands need to have the same number of overviews as list provided.");
-                    }
-                }
                 
                 GDALClose(dataset);
             }
             
             int width;
             int height;
-            double *transformation = new double[6];
-            double *baseTransform = new double[6];
+            double transformation[6];
+            double baseTransform[6];
             
             imgUtils.getImagesExtent(inputImages, &width, &height, transformation);
             
@@ -1955,56 +1574,30 @@ namespace rsgis{namespace img{
             {
                 baseResY = baseResY * (-1);
             }
-            long tileWidth = 0;
-            long tileHeight = 0;
-            long overWidth = 0;
-            long overHeight = 0;
-            long calcOverWidth = 0;
-            long calcOverHeight = 0;
             
             std::cout << "Base Image " << ": [" << baseWidth << ", " << baseHeight << "]\n";
-            unsigned long **overviewImgsSize = new unsigned long*[numOverviews];
+            std::vector<unsigned long> overviewWidths(numOverviews);
+            std::vector<unsigned long> overviewHeights(numOverviews);
             for(int i = 0; i < numOverviews; ++i)
             {
-                overviewImgsSize[i] = new unsigned long[2];
-                overviewImgsSize[i][0] = baseWidth/pyraScaleVals.at(i);
-                overviewImgsSize[i][1] = baseHeight/pyraScaleVals.at(i);
-                std::cout << "Overview " << i << " (Level: " << pyraScaleVals.at(i) << ") [" << overviewImgsSize[i][0] << ", " << overviewImgsSize[i][1] << "]\n";
-            }
-            
-            for(std::vector<std::string>::iterator iterImgFile = inputImages.begin(); iterImgFile != inputImages.end(); ++iterImgFile)
-            {
-                dataset = (GDALDataset *) GDALOpenShared((*iterImgFile).c_str(), GA_ReadOnly);
-                if(dataset == NULL)
-                {
-                    std::string message = std::string("Could not open image ") + (*iterImgFile);
-                    throw RSGISImageException(message.c_str());
-                }
-                GDALRasterBand *imgBand = dataset->GetRasterBand(1);
-                GDALRasterBand *gdalBandOver = NULL;
-                tileWidth = dataset->GetRasterXSize();
-                tileHeight = dataset->GetRasterYSize();
-                for(int i = 0; i < numOverviews; ++i)
+                if(pyraScaleVals.at(i) < 1)
                 {
-                    gdalBandOver = imgBand->GetOverview(i);
-                    overWidth = gdalBandOver->GetXSize();
-                    overHeight = gdalBandOver->GetYSize();
-                    
-                    calcOverWidth = tileWidth / pyraScaleVals.at(i);
-                    calcOverHeight = tileHeight / pyraScaleVals.at(i);
-                    
-                    if((overWidth != calcOverWidth) | (overHeight != calcOverHeight))
-                    {
-                        std::cout << "Image: " << *iterImgFile << std::endl;
-                        std::cout << "Image DIMS: " << ": [" << tileWidth << ", " << tileHeight << "]\n";
-                        std::cout << "Overview (Img) " << i << ": [" << overWidth << ", " << overHeight << "]\n";
-                        std::cout << "Overview (Cal) " << i << ": [" << calcOverWidth << ", " << calcOverHeight << "]\n\n";
-                        throw RSGISImageException("Overview is not the correct size for the specified levels.");
-                    }
+                    throw RSGISImageException("The overview levels must be 1 or more.");
                 }
+                overviewWidths[i] = baseWidth/pyraScaleVals.at(i);
+                overviewHeights[i] = baseHeight/pyraScaleVals.at(i);
+                std::cout << "Overview " << i << " (Level: " << pyraScaleVals.at(i) << ") [" << overviewWidths[i] << ", " << overviewHeights[i] << "]\n";
             }
             
-            std::cout << "Inputs all seem correct, adding pyramids to base image\n";
+            // Thematic bands are sub-sampled (so the values remain valid
+            // classes) while continuous bands are averaged when an overview
+            // level is calculated from the tile.
+            std::vector<bool> thematicBands(numberBands);
+            for(int i = 0; i < numberBands; ++i)
+            {
+                const char *layerType = baseImg->GetRasterBand(i+1)->GetMetadataItem("LAYER_TYPE", "");
+                thematicBands[i] = ((layerType != NULL) && (std::string(layerType) == "thematic"));
+            }
             
             kealib::KEAImageIO *keaBaseImgIO;
             void *internalData = baseImg->GetInternalHandle("");
@@ -2029,93 +1622,162 @@ namespace rsgis{namespace img{
                 throw RSGISImageException("Internal data on GDAL Dataset was NULL - check input file is KEA.");
             }
             
-            float *data = NULL;
+            std::vector<float> zeroData;
             for(int j = 0; j < numOverviews; ++j)
             {
-                data = new float[overviewImgsSize[j][0]*overviewImgsSize[j][1]];
-                for(long n = 0; n < (overviewImgsSize[j][0]*overviewImgsSize[j][1]); ++n)
-                {
-                    data[n] = 0.0;
-                }
+                zeroData.assign(overviewWidths[j]*overviewHeights[j], 0.0);
                 for(int i = 0; i < numberBands; ++i)
                 {
-                    keaBaseImgIO->createOverview(i+1, j+1, overviewImgsSize[j][0], overviewImgsSize[j][1]);
-                    keaBaseImgIO->writeToOverview(i+1, j+1, data, 0, 0, overviewImgsSize[j][0], overviewImgsSize[j][1], overviewImgsSize[j][0], overviewImgsSize[j][1], kealib::kea_32float);
+                    keaBaseImgIO->createOverview(i+1, j+1, overviewWidths[j], overviewHeights[j]);
+                    keaBaseImgIO->writeToOverview(i+1, j+1, zeroData.data(), 0, 0, overviewWidths[j], overviewHeights[j], overviewWidths[j], overviewHeights[j], kealib::kea_32float);
                 }
-                delete[] data;
             }
+            std::vector<float>().swap(zeroData);
             
-            GDALRasterBand *imgBand = NULL;
-            GDALRasterBand *gdalBandOver = NULL;
-            double xDiff = 0.0;
-            double yDiff = 0.0;
-            long xDiffBasePxl = 0;
-            long yDiffBasePxl = 0;
-            long xDiffOvPxl = 0;
-            long yDiffOvPxl = 0;
-            double tileTLX = 0.0;
-            double tileTLY = 0.0;
-            for(std::vector<std::string>::iterator iterImgFile = inputImages.begin(); iterImgFile != inputImages.end(); ++iterImgFile)
+            std::cout << "Adding the overviews of " << inputImages.size() << " tiles using " << this->numThreads << " threads." << std::endl;
+            
+            // The tiles are processed in parallel, each into its own window
+            // of the overviews, but as GDAL, kealib and HDF5 are not thread
+            // safe every GDAL and kealib call (opening, finding the overviews,
+            // reading, writing and closing) is made under ioMutex, so only
+            // the averaging of the levels missing from a tile runs in parallel.
+            std::mutex ioMutex;
+            RSGISProgressCounter progress(inputImages.size());
+            rsgis::utils::parallelFor(inputImages.size(), this->numThreads, [&](size_t tile, unsigned int)
             {
-                std::cout << "Adding: " << *iterImgFile << std::endl;
-                dataset = (GDALDataset *) GDALOpenShared((*iterImgFile).c_str(), GA_ReadOnly);
-                if(dataset == NULL)
+                std::vector<float> data;
+                std::vector<float> fullResData;
+                std::unique_lock<std::mutex> ioLock(ioMutex);
+                GDALDataset *tileDataset = (GDALDataset *) GDALOpen(inputImages[tile].c_str(), GA_ReadOnly);
+                if(tileDataset == NULL)
                 {
-                    std::string message = std::string("Could not open image ") + (*iterImgFile);
+                    std::string message = std::string("Could not open image ") + inputImages[tile];
                     throw RSGISImageException(message.c_str());
                 }
-
-                tileWidth = dataset->GetRasterXSize();
-                tileHeight = dataset->GetRasterYSize();
-                dataset->GetGeoTransform(transformation);
-                tileTLX = transformation[0];
-                tileTLY = transformation[3];
-
-                xDiff = tileTLX - baseTLX;
-                yDiff = baseTLY - tileTLY;
-                
-                std::cout << "Diff = [" << xDiff << ", " << yDiff << "]\n";
-                
-                xDiffBasePxl = floor((xDiff/baseResX)+0.5);
-                yDiffBasePxl = floor((yDiff/baseResY)+0.5);
+                try
+                {
+                    long tileWidth = tileDataset->GetRasterXSize();
+                    long tileHeight = tileDataset->GetRasterYSize();
+                    double tileTransform[6];
+                    tileDataset->GetGeoTransform(tileTransform);
+                    ioLock.unlock();
                 
-                std::cout << "Base Pxl Diff = [" << xDiffBasePxl << ", " << yDiffBasePxl << "]\n";
+                    long xDiffBasePxl = floor(((tileTransform[0] - baseTLX)/baseResX)+0.5);
+                    long yDiffBasePxl = floor(((baseTLY - tileTransform[3])/baseResY)+0.5);
                 
-                for(int i = 0; i < numOverviews; ++i)
-                {
-                    xDiffOvPxl = xDiffBasePxl / pyraScaleVals.at(i);
-                    yDiffOvPxl = yDiffBasePxl / pyraScaleVals.at(i);
-                    std::cout << "\tBase Overview Diff = [" << xDiffOvPxl << ", " << yDiffOvPxl << "]\n";
-                    
-                    overWidth = tileWidth / pyraScaleVals.at(i);
-                    overHeight = tileHeight / pyraScaleVals.at(i);
-                    
-                    data = new float[overWidth*overHeight];
-                    
-                    for(int j = 0; j < numberBands; ++j)
+                    for(int i = 0; i < numOverviews; ++i)
                     {
-                        imgBand = dataset->GetRasterBand(j+1);
-                        gdalBandOver = imgBand->GetOverview(i);
-                        gdalBandOver->RasterIO(GF_Read, 0, 0, overWidth, overHeight, data, overWidth, overHeight, GDT_Float32, 0, 0);
-                        keaBaseImgIO->writeToOverview(j+1, i+1, data, xDiffOvPxl, yDiffOvPxl, overWidth, overHeight, overWidth, overHeight, kealib::kea_32float);
+                        long scale = pyraScaleVals.at(i);
+                        long xDiffOvPxl = xDiffBasePxl / scale;
+                        long yDiffOvPxl = yDiffBasePxl / scale;
+                        long overWidth = tileWidth / scale;
+                        long overHeight = tileHeight / scale;
+                        if((overWidth == 0) || (overHeight == 0))
+                        {
+                            continue;
+                        }
+                    
+                        data.resize(((size_t)overWidth)*overHeight);
+                        for(int j = 0; j < numberBands; ++j)
+                        {
+                            ioLock.lock();
+                            GDALRasterBand *imgBand = tileDataset->GetRasterBand(j+1);
+                        
+                            // Use the tile's own overview if it has one for this level.
+                            GDALRasterBand *gdalBandOver = NULL;
+                            for(int k = 0; k < imgBand->GetOverviewCount(); ++k)
+                            {
+                                GDALRasterBand *tileOverBand = imgBand->GetOverview(k);
+                                if((tileOverBand != NULL) && (tileOverBand->GetXSize() == overWidth) && (tileOverBand->GetYSize() == overHeight))
+                                {
+                                    gdalBandOver = tileOverBand;
+                                    break;
+                                }
+                            }
+                        
+                            if(gdalBandOver != NULL)
+                            {
+                                if(gdalBandOver->RasterIO(GF_Read, 0, 0, overWidth, overHeight, data.data(), overWidth, overHeight, GDT_Float32, 0, 0) != CE_None)
+                                {
+                                    std::string message = std::string("Could not read an overview of image ") + inputImages[tile];
+                                    throw RSGISImageException(message.c_str());
+                                }
+                                ioLock.unlock();
+                            }
+                            else
+                            {
+                                ioLock.unlock();
+                                // Otherwise calculate it from the full resolution
+                                // data, a strip of overview rows at a time.
+                                long stripRows = std::max<long>(1, (4*1024*1024) / (tileWidth * scale));
+                                for(long oy = 0; oy < overHeight; oy += stripRows)
+                                {
+                                    long nRows = std::min(stripRows, overHeight - oy);
+                                    fullResData.resize(((size_t)tileWidth) * nRows * scale);
+                                    ioLock.lock();
+                                    if(imgBand->RasterIO(GF_Read, 0, oy * scale, tileWidth, nRows * scale, fullResData.data(), tileWidth, nRows * scale, GDT_Float32, 0, 0) != CE_None)
+                                    {
+                                        std::string message = std::string("Could not read image ") + inputImages[tile];
+                                        throw RSGISImageException(message.c_str());
+                                    }
+                                    ioLock.unlock();
+                                    for(long r = 0; r < nRows; ++r)
+                                    {
+                                        float *outRow = &data[((size_t)(oy + r)) * overWidth];
+                                        for(long ox = 0; ox < overWidth; ++ox)
+                                        {
+                                            if(thematicBands[j])
+                                            {
+                                                outRow[ox] = fullResData[((size_t)((r * scale) + (scale/2)) * tileWidth) + (ox * scale) + (scale/2)];
+                                            }
+                                            else
+                                            {
+                                                double sum = 0.0;
+                                                for(long y = 0; y < scale; ++y)
+                                                {
+                                                    float *inPxl = &fullResData[((size_t)((r * scale) + y) * tileWidth) + (ox * scale)];
+                                                    for(long x = 0; x < scale; ++x)
+                                                    {
+                                                        sum += inPxl[x];
+                                                    }
+                                                }
+                                                outRow[ox] = sum / (scale * scale);
+                                            }
+                                        }
+                                    }
+                                }
+                            }
+                        
+                            ioLock.lock();
+                            keaBaseImgIO->writeToOverview(j+1, i+1, data.data(), xDiffOvPxl, yDiffOvPxl, overWidth, overHeight, overWidth, overHeight, kealib::kea_32float);
+                            ioLock.unlock();
+                        }
                     }
-                    delete[] data;
                 }
-                
-            }
-            
-            delete[] transformation;
-            delete[] baseTransform;
-            for(int i = 0; i < numOverviews; ++i)
-            {
-                delete[] overviewImgsSize[i];
-            }
-            
+                catch(...)
+                {
+                    if(!ioLock.owns_lock())
+                    {
+                        ioLock.lock();
+                    }
+                    GDALClose(tileDataset);
+                    throw;
+                }
+                ioLock.lock();
+                GDALClose(tileDataset);
+                ioLock.unlock();
+                progress.add();
+            });
+            progress.finish();
         }
         catch(RSGISImageException& e)
         {
             throw e;
         }
+        catch(kealib::KEAException& e)
+        {
+            throw RSGISImageException(e.what());
+        }
         catch(RSGISException& e)
         {
             throw RSGISImageException(e.what());
@@ -30,15 +30,29 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <cstdlib>
 
 #include "libkea/KEAImageIO.h"
 
+#include "geos/geom/Envelope.h"
+#include "geos/index/strtree/STRtree.h"
+
 #include "common/rsgis-tqdm.h"
+#include "common/RSGISProgressCounter.h"
+#include "common/RSGISParallel.h"
 
 #include "img/RSGISImageCalcException.h"
 #include "img/RSGISCalcImageValue.h"
 #include "img/RSGISImageUtils.h"
 #include "img/RSGISCalcImage.h"
+#include "img/RSGISImageReadPlanner.h"
 
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
@@ -55,13 +69,38 @@
 
 namespace rsgis{namespace img{
     
+    /**
+     * Where the proportion of valid pixels of an image was found, from the
+     * cheapest to the most expensive.
+     */
+    enum RSGISValidDataSource
+    {
+        rsgis_validdata_metadata = 0,
+        rsgis_validdata_overview = 1,
+        rsgis_validdata_sample = 2,
+        rsgis_validdata_exact = 3
+    };
+    
     struct DllExport RSGISImageValidDataMetric
     {
         std::string imageFile;
-        unsigned int validPxlCount;
-        unsigned int noDataPxlCount;
-        unsigned int totalNumPxls;
+        unsigned long long validPxlCount;
+        unsigned long long noDataPxlCount;
+        unsigned long long totalNumPxls;
         double validPxlFunc;
+        RSGISValidDataSource source;
+    };
+    
+    /**
+     * An image to be mosaicked, with its offset and size in pixels within the output image.
+     */
+    struct DllExport RSGISMosaicInputImg
+    {
+        std::string imageFile;
+        int xOff;
+        int yOff;
+        int xSize;
+        int ySize;
     };
     
     inline bool compare_ImageValidPxlCounts (const RSGISImageValidDataMetric& first, const RSGISImageValidDataMetric& second)
@@ -76,18 +115,67 @@ namespace rsgis{namespace img{
       1 - overwrite mosaic if new pixel value is smaller (min)
       2 - overwrite mosaic if new pixel value is larger (max)
      
+     The mosaic functions write the output a tile at a time, reading just
+     the parts of the input images which overlap each tile (found with an
+     index of the image footprints) and merging them in memory, so each
+     output tile is written once. The tiles are processed in parallel, with
+     the number of threads from setNumThreads or the RSGISLIB_NUM_THREADS
+     environment variable.
      */
     {
     public:
         RSGISImageMosaic();
+        /**
+         * The number of tiles to mosaic at once (0 uses the number of cores).
+         */
+        void setNumThreads(unsigned int numThreads);
         void mosaic(std::string *inputImages, int numDS, std::string outputImage, float background, bool projFromImage, std::string proj, std::string format="ENVI", GDALDataType imgDataType=GDT_Float32);
         void mosaicSkipVals(std::string *inputImages, int numDS, std::string outputImage, float background, float skipVal, bool projFromImage, std::string proj, unsigned int skipBand = 0, unsigned int overlapBehaviour = 0, std::string format="ENVI", GDALDataType imgDataType=GDT_Float32);
         void mosaicSkipThresh(std::string *inputImages, int numDS, std::string outputImage, float background, float skipLowerThresh, float skipUpperThresh, bool projFromImage, std::string proj, unsigned int threshBand = 0, unsigned int overlapBehaviour = 0, std::string format="ENVI", GDALDataType imgDataType=GDT_Float32);
         void includeDatasets(GDALDataset *baseImage, std::string *inputImages, int numDS, std::vector<int> bands, bool bandsDefined);
         void includeDatasetsSkipVals(GDALDataset *baseImage, std::string *inputImages, int numDS, std::vector<int> bands, bool bandsDefined, float skipVal);
         void includeDatasetsIgnoreOverlap(GDALDataset *baseImage, std::string *inputImages, int numDS, int numOverlapPxls);
-        void orderInImagesValidData(std::vector<std::string> images, std::vector<std::string> *orderedImages, float noDataValue);
+        /**
+         * Order the images by their proportion of valid pixels (those where any
+         * band is not noDataValue), smallest first. The images are processed in
+         * parallel and, unless exactCount, the proportion is taken from the
+         * cheapest source available for each image (see calcImageValidData).
+         */
+        void orderInImagesValidData(std::vector<std::string> images, std::vector<std::string> *orderedImages, float noDataValue, bool exactCount=false);
+        /**
+         * The proportion of valid pixels of an image. Unless exactCount, it is
+         * taken from (in order) the valid percentage (STATISTICS_VALID_PERCENT)
+         * or histograms stored for the bands, where their no data value is
+         * noDataValue; the pixels of an overview of at least 512 x 512 pixels
+         * (or the finest if all are smaller); or a read of the image decimated
+         * to no more than 1024 pixels across. Otherwise (or where the image is
+         * that small) every pixel is counted.
+         */
+        RSGISImageValidDataMetric calcImageValidData(GDALDataset *dataset, float noDataValue, bool exactCount=false);
         ~RSGISImageMosaic();
+    protected:
+        /**
+         * As calcImageValidData but, where ioMutex is not NULL, every GDAL call
+         * is made holding ioMutex so the images can be processed in parallel.
+         */
+        RSGISImageValidDataMetric calcImageValidData(GDALDataset *dataset, float noDataValue, bool exactCount, std::mutex *ioMutex);
+        bool validDataFromMetadata(GDALDataset *dataset, float noDataValue, double *validFrac);
+        /**
+         * Count the valid pixels of bands (all the same size) read into a buffer of
+         * bufXSize x bufYSize pixels, a strip of rows at a time. Where ioMutex is
+         * not NULL it is held for each read.
+         */
+        void countValidPixels(std::vector<GDALRasterBand*> &bands, int bufXSize, int bufYSize, float noDataValue, unsigned long long *validCount, unsigned long long *totalCount, std::mutex *ioMutex=NULL);
+        /**
+         skipMode:
+          0 - no values are skipped
+          1 - skip pixels where skipBand is equal to skipVal
+          2 - skip pixels where skipBand is not between skipVal and skipUpperThresh
+         */
+        void mosaicTiled(std::string *inputImages, int numDS, std::string outputImage, float background, bool projFromImage, std::string proj, unsigned int skipMode, float skipVal, float skipUpperThresh, unsigned int skipBand, unsigned int overlapBehaviour, std::string format, GDALDataType imgDataType);
+        template <typename T>
+        void mosaicTiles(std::vector<RSGISMosaicInputImg> *inImgs, GDALDataset *outputDataset, int numberBands, T background, unsigned int skipMode, T skipVal, T skipUpperThresh, unsigned int skipBand, unsigned int overlapBehaviour, GDALDataType stageType);
+        unsigned int numThreads;
     };
     
     class DllExport RSGISCountValidPixels : public RSGISCalcImageValue
@@ -111,12 +199,26 @@ namespace rsgis{namespace img{
         float noDataVal;
     };
     
+    /**
+     Adds the overviews of a set of tiles to the overviews of the KEA image
+     they were mosaicked into. The tiles are processed in parallel (with the
+     number of threads from setNumThreads or the RSGISLIB_NUM_THREADS
+     environment variable), each into its own window of the overviews. Where
+     a tile does not have an overview for a level it is calculated from the
+     tile's full resolution data (averaged, or sub-sampled for thematic bands).
+     */
     class DllExport RSGISCombineImgTileOverview
     {
     public:
         RSGISCombineImgTileOverview();
+        /**
+         * The number of tiles to process at once (0 uses the number of cores).
+         */
+        void setNumThreads(unsigned int numThreads);
         void combineKEAImgTileOverviews(GDALDataset *baseImg, std::vector<std::string> inputImages, std::vector<int> pyraScaleVals);
         ~RSGISCombineImgTileOverview();
+    protected:
+        unsigned int numThreads;
     };
     
     
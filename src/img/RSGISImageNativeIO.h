@@ -0,0 +1,106 @@
+/*
+ *  RSGISImageNativeIO.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2008 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISImageNativeIO_H
+#define RSGISImageNativeIO_H
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+#include "gdal_priv.h"
+
+namespace rsgis{namespace img{
+
+    /**
+     * Maps a C++ pixel type onto the matching GDAL data type.
+     */
+    template <typename T> struct RSGISGDALPixelType {};
+    template <> struct RSGISGDALPixelType<unsigned char> { static GDALDataType gdalType(){return GDT_Byte;}; };
+    template <> struct RSGISGDALPixelType<unsigned short> { static GDALDataType gdalType(){return GDT_UInt16;}; };
+    template <> struct RSGISGDALPixelType<short> { static GDALDataType gdalType(){return GDT_Int16;}; };
+    template <> struct RSGISGDALPixelType<unsigned int> { static GDALDataType gdalType(){return GDT_UInt32;}; };
+    template <> struct RSGISGDALPixelType<int> { static GDALDataType gdalType(){return GDT_Int32;}; };
+    template <> struct RSGISGDALPixelType<float> { static GDALDataType gdalType(){return GDT_Float32;}; };
+    template <> struct RSGISGDALPixelType<double> { static GDALDataType gdalType(){return GDT_Float64;}; };
+
+    /**
+     * Convert a calculated value to the output pixel type. Integer types are
+     * rounded to the nearest value and clamped to the range of the type (NaN
+     * becomes 0), matching the conversion GDAL applies when writing GDT_Float64.
+     */
+    template <typename OutT> inline OutT rsgisConvertPixelValue(double val)
+    {
+        if(std::isnan(val))
+        {
+            return 0;
+        }
+        if(val <= ((double)std::numeric_limits<OutT>::min()))
+        {
+            return std::numeric_limits<OutT>::min();
+        }
+        if(val >= ((double)std::numeric_limits<OutT>::max()))
+        {
+            return std::numeric_limits<OutT>::max();
+        }
+        return (OutT) ((val < 0)?(val - 0.5):(val + 0.5));
+    }
+    template <> inline float rsgisConvertPixelValue<float>(double val){return (float) val;};
+    template <> inline double rsgisConvertPixelValue<double>(double val){return val;};
+
+    /**
+     * Return a float representation of nPxls values from src. When the source
+     * is already float it is returned directly, otherwise it is converted into
+     * scratch (which must hold nPxls values) and scratch is returned.
+     */
+    template <typename InT> inline const float* rsgisPixelsAsFloat(const InT *src, float *scratch, size_t nPxls)
+    {
+        for(size_t i = 0; i < nPxls; ++i)
+        {
+            scratch[i] = (float) src[i];
+        }
+        return scratch;
+    }
+    inline const float* rsgisPixelsAsFloat(const float *src, float *scratch, size_t nPxls){return src;};
+
+    /**
+     * Return a buffer into which nPxls double values can be calculated before
+     * being stored in dst; dst is used directly when it is already double.
+     */
+    template <typename OutT> inline double* rsgisPixelsCalcBuffer(OutT *dst, double *scratch){return scratch;};
+    inline double* rsgisPixelsCalcBuffer(double *dst, double *scratch){return dst;};
+
+    /**
+     * Store nPxls calculated values into dst, a no-op if they were calculated in place.
+     */
+    template <typename OutT> inline void rsgisStoreCalcPixels(const double *calc, OutT *dst, size_t nPxls)
+    {
+        for(size_t i = 0; i < nPxls; ++i)
+        {
+            dst[i] = rsgisConvertPixelValue<OutT>(calc[i]);
+        }
+    }
+    inline void rsgisStoreCalcPixels(const double *calc, double *dst, size_t nPxls){};
+
+}}
+
+#endif
+
@@ -0,0 +1,272 @@
+/*
+ *  RSGISImagePCA.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2010 RSGISLib. All rights reserved.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISImagePCA.h"
+
+namespace rsgis{namespace img{
+
+    RSGISImagePCA::RSGISImagePCA(bool randomised, unsigned int numOversamples, unsigned int numPowerIters)
+    {
+        this->randomised = randomised;
+        this->numOversamples = numOversamples;
+        this->numPowerIters = numPowerIters;
+        this->numBands = 0;
+        this->totalVariance = 0;
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+
+    void RSGISImagePCA::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+
+    void RSGISImagePCA::calcComponents(GDALDataset *dataset, unsigned int numComponents, bool useNoData, float noDataVal)
+    {
+        RSGISSinglePassImageStats imgStats(false, true);
+        imgStats.setNumThreads(this->numThreads);
+        imgStats.calcStats(dataset, useNoData, noDataVal);
+        if(imgStats.getCovarianceCount() == 0)
+        {
+            throw RSGISImageCalcException("There were no valid pixels to calculate the principal components from.");
+        }
+
+        this->numBands = imgStats.getNumBands();
+        if((numComponents == 0) || (numComponents > this->numBands))
+        {
+            numComponents = this->numBands;
+        }
+
+        gsl_matrix *covariance = gsl_matrix_alloc(this->numBands, this->numBands);
+        this->means.assign(this->numBands, 0);
+        this->totalVariance = 0;
+        for(unsigned int i = 0; i < this->numBands; ++i)
+        {
+            this->means[i] = imgStats.getMean(i);
+            for(unsigned int j = i; j < this->numBands; ++j)
+            {
+                double covVal = imgStats.getCovariance(i, j);
+                gsl_matrix_set(covariance, i, j, covVal);
+                gsl_matrix_set(covariance, j, i, covVal);
+            }
+            this->totalVariance += gsl_matrix_get(covariance, i, i);
+        }
+
+        gsl_vector *eigenvalsGSL = NULL;
+        gsl_matrix *eigenvecsGSL = NULL;
+        try
+        {
+            // The randomised range finder is only worthwhile when it works on a
+            // subspace much smaller than the number of bands.
+            if(this->randomised && ((numComponents + this->numOversamples) < this->numBands))
+            {
+                eigenvalsGSL = gsl_vector_alloc(numComponents);
+                eigenvecsGSL = gsl_matrix_alloc(this->numBands, numComponents);
+                this->randomisedEigen(covariance, numComponents, eigenvalsGSL, eigenvecsGSL);
+            }
+            else
+            {
+                eigenvalsGSL = gsl_vector_alloc(this->numBands);
+                eigenvecsGSL = gsl_matrix_alloc(this->numBands, this->numBands);
+                this->symmetricEigen(covariance, eigenvalsGSL, eigenvecsGSL);
+            }
+        }
+        catch(RSGISImageCalcException &e)
+        {
+            gsl_matrix_free(covariance);
+            if(eigenvalsGSL != NULL)
+            {
+                gsl_vector_free(eigenvalsGSL);
+            }
+            if(eigenvecsGSL != NULL)
+            {
+                gsl_matrix_free(eigenvecsGSL);
+            }
+            throw e;
+        }
+
+        this->eigenvalues.assign(numComponents, 0);
+        this->components.assign(((size_t)numComponents) * this->numBands, 0);
+        for(unsigned int c = 0; c < numComponents; ++c)
+        {
+            this->eigenvalues[c] = gsl_vector_get(eigenvalsGSL, c);
+            for(unsigned int b = 0; b < this->numBands; ++b)
+            {
+                this->components[(((size_t)c) * this->numBands) + b] = gsl_matrix_get(eigenvecsGSL, b, c);
+            }
+        }
+
+        gsl_matrix_free(covariance);
+        gsl_vector_free(eigenvalsGSL);
+        gsl_matrix_free(eigenvecsGSL);
+    }
+
+    double RSGISImagePCA::getVarianceExplained(unsigned int idx) const
+    {
+        if(this->totalVariance <= 0)
+        {
+            return 0;
+        }
+        return this->eigenvalues.at(idx) / this->totalVariance;
+    }
+
+    rsgis::math::Matrix* RSGISImagePCA::getEigenvectors() const
+    {
+        if(this->eigenvalues.empty())
+        {
+            throw RSGISImageCalcException("The principal components have not been calculated.");
+        }
+        rsgis::math::RSGISMatrices matrixUtils;
+        rsgis::math::Matrix *eigenvectors = matrixUtils.createMatrix(this->eigenvalues.size(), this->numBands);
+        std::copy(this->components.begin(), this->components.end(), eigenvectors->matrix);
+        return eigenvectors;
+    }
+
+    void RSGISImagePCA::applyComponents(GDALDataset *dataset, std::string outputImage, std::string gdalFormat, GDALDataType gdalDataType, unsigned int numComponents)
+    {
+        if(this->eigenvalues.empty())
+        {
+            throw RSGISImageCalcException("The principal components have not been calculated.");
+        }
+        if(dataset->GetRasterCount() != ((int)this->numBands))
+        {
+            throw RSGISImageCalcException("The number of image bands is not the same as the number used to calculate the components.");
+        }
+        if((numComponents == 0) || (numComponents > this->eigenvalues.size()))
+        {
+            numComponents = this->eigenvalues.size();
+        }
+
+        rsgis::math::RSGISMatrices matrixUtils;
+        rsgis::math::Matrix *eigenvectors = this->getEigenvectors();
+        try
+        {
+            RSGISApplyEigenvectors applyPCA(numComponents, eigenvectors, this->means);
+            RSGISCalcImage calcImage(&applyPCA, "", true);
+            calcImage.setNumThreads(this->numThreads);
+            GDALDataset *datasets[1] = {dataset};
+            calcImage.calcImage(datasets, 1, outputImage, false, NULL, gdalFormat, gdalDataType);
+        }
+        catch(RSGISImageCalcException &e)
+        {
+            matrixUtils.freeMatrix(eigenvectors);
+            throw e;
+        }
+        matrixUtils.freeMatrix(eigenvectors);
+    }
+
+    void RSGISImagePCA::symmetricEigen(gsl_matrix *matrix, gsl_vector *eigenvalues, gsl_matrix *eigenvectors)
+    {
+        gsl_eigen_symmv_workspace *workspace = gsl_eigen_symmv_alloc(matrix->size1);
+        int status = gsl_eigen_symmv(matrix, eigenvalues, eigenvectors, workspace);
+        gsl_eigen_symmv_free(workspace);
+        if(status != 0)
+        {
+            throw RSGISImageCalcException(gsl_strerror(status));
+        }
+        gsl_eigen_symmv_sort(eigenvalues, eigenvectors, GSL_EIGEN_SORT_VAL_DESC);
+    }
+
+    void RSGISImagePCA::randomisedEigen(const gsl_matrix *covariance, unsigned int numComponents, gsl_vector *eigenvalues, gsl_matrix *eigenvectors)
+    {
+        size_t numBandsCov = covariance->size1;
+        size_t subspaceSize = std::min<size_t>(numComponents + this->numOversamples, numBandsCov);
+
+        // A fixed seed so the components are repeatable.
+        std::mt19937 rng(42);
+        std::normal_distribution<double> normDist(0.0, 1.0);
+        gsl_matrix *omega = gsl_matrix_alloc(numBandsCov, subspaceSize);
+        for(size_t i = 0; i < numBandsCov; ++i)
+        {
+            for(size_t j = 0; j < subspaceSize; ++j)
+            {
+                gsl_matrix_set(omega, i, j, normDist(rng));
+            }
+        }
+
+        // Q = orth(C^(q+1).omega), re-orthonormalising between the products.
+        gsl_matrix *basis = gsl_matrix_alloc(numBandsCov, subspaceSize);
+        gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, covariance, omega, 0.0, basis);
+        this->orthonormalise(basis);
+        for(unsigned int q = 0; q < this->numPowerIters; ++q)
+        {
+            gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, covariance, basis, 0.0, omega);
+            gsl_matrix_memcpy(basis, omega);
+            this->orthonormalise(basis);
+        }
+
+        // The eigenvectors of T = Q'.C.Q, mapped back by Q.
+        gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, covariance, basis, 0.0, omega);
+        gsl_matrix *projCov = gsl_matrix_alloc(subspaceSize, subspaceSize);
+        gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1.0, basis, omega, 0.0, projCov);
+        gsl_vector *projEigenvals = gsl_vector_alloc(subspaceSize);
+        gsl_matrix *projEigenvecs = gsl_matrix_alloc(subspaceSize, subspaceSize);
+        try
+        {
+            this->symmetricEigen(projCov, projEigenvals, projEigenvecs);
+        }
+        catch(RSGISImageCalcException &e)
+        {
+            gsl_matrix_free(omega);
+            gsl_matrix_free(basis);
+            gsl_matrix_free(projCov);
+            gsl_vector_free(projEigenvals);
+            gsl_matrix_free(projEigenvecs);
+            throw e;
+        }
+
+        gsl_matrix_const_view firstVecs = gsl_matrix_const_submatrix(projEigenvecs, 0, 0, subspaceSize, numComponents);
+        gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, basis, &firstVecs.matrix, 0.0, eigenvectors);
+        for(unsigned int c = 0; c < numComponents; ++c)
+        {
+            gsl_vector_set(eigenvalues, c, gsl_vector_get(projEigenvals, c));
+        }
+
+        gsl_matrix_free(omega);
+        gsl_matrix_free(basis);
+        gsl_matrix_free(projCov);
+        gsl_vector_free(projEigenvals);
+        gsl_matrix_free(projEigenvecs);
+    }
+
+    void RSGISImagePCA::orthonormalise(gsl_matrix *matrix)
+    {
+        size_t numRows = matrix->size1;
+        size_t numCols = matrix->size2;
+        gsl_vector *tau = gsl_vector_alloc(numCols);
+        gsl_matrix *q = gsl_matrix_alloc(numRows, numRows);
+        gsl_matrix *r = gsl_matrix_alloc(numRows, numCols);
+        gsl_linalg_QR_decomp(matrix, tau);
+        gsl_linalg_QR_unpack(matrix, tau, q, r);
+        gsl_matrix_const_view qCols = gsl_matrix_const_submatrix(q, 0, 0, numRows, numCols);
+        gsl_matrix_memcpy(matrix, &qCols.matrix);
+        gsl_vector_free(tau);
+        gsl_matrix_free(q);
+        gsl_matrix_free(r);
+    }
+
+    RSGISImagePCA::~RSGISImagePCA()
+    {
+
+    }
+
+}}
@@ -0,0 +1,146 @@
+/*
+ *  RSGISImagePCA.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2010 RSGISLib. All rights reserved.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISImagePCA_H
+#define RSGISImagePCA_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+
+#include "gdal_priv.h"
+
+#include "img/RSGISImageCalcException.h"
+#include "img/RSGISSinglePassImageStats.h"
+#include "img/RSGISApplyEigenvectors.h"
+#include "img/RSGISCalcImage.h"
+
+#include "math/RSGISMatrices.h"
+
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_eigen.h>
+#include <gsl/gsl_linalg.h>
+#include "common/RSGISParallel.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_img_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace img{
+
+    /**
+     * A principal component analysis of all the bands of an image. The
+     * means and the covariance matrix are accumulated in one pass over the
+     * image (RSGISSinglePassImageStats, with the blocks shared among
+     * threads) and the components are then applied to the image with
+     * RSGISApplyEigenvectors, which projects whole blocks as a matrix
+     * multiplication.
+     *
+     * The eigenvectors of the covariance are found with gsl_eigen_symmv or,
+     * in randomised mode, a randomised range finder (Halko et al., 2011)
+     * which only needs a few products with the covariance matrix, so is
+     * faster for hyperspectral data with hundreds of bands when only the
+     * first few components are wanted.
+     *
+     * The covariance is of the population (divided by the count), as for
+     * the other image statistics, and pixels with NaN or the no data value
+     * in any band are ignored.
+     */
+    class DllExport RSGISImagePCA
+    {
+    public:
+        RSGISImagePCA(bool randomised=false, unsigned int numOversamples=10, unsigned int numPowerIters=2);
+        /**
+         * The number of threads (0 uses the number of cores).
+         */
+        void setNumThreads(unsigned int numThreads);
+        /**
+         * Calculate the first numComponents (0 for all) principal components
+         * of the bands of the image.
+         */
+        void calcComponents(GDALDataset *dataset, unsigned int numComponents=0, bool useNoData=false, float noDataVal=0);
+        unsigned int getNumBands() const {return this->numBands;};
+        unsigned int getNumComponents() const {return this->eigenvalues.size();};
+        double getEigenvalue(unsigned int idx) const {return this->eigenvalues.at(idx);};
+        /**
+         * The proportion of the total variance (the sum of the band variances)
+         * explained by a component.
+         */
+        double getVarianceExplained(unsigned int idx) const;
+        const std::vector<double>& getMeans() const {return this->means;};
+        /**
+         * The components as a (components x bands) matrix, as used by
+         * RSGISApplyEigenvectors. The caller frees the matrix.
+         */
+        rsgis::math::Matrix* getEigenvectors() const;
+        /**
+         * Project the image (centred on the band means) onto the first
+         * numComponents (0 for all) components.
+         */
+        void applyComponents(GDALDataset *dataset, std::string outputImage, std::string gdalFormat, GDALDataType gdalDataType, unsigned int numComponents=0);
+        ~RSGISImagePCA();
+    protected:
+        /**
+         * All the eigenvalues and vectors (as columns) of the symmetric matrix
+         * (which is overwritten) in descending order of eigenvalue.
+         */
+        void symmetricEigen(gsl_matrix *matrix, gsl_vector *eigenvalues, gsl_matrix *eigenvectors);
+        /**
+         * The numComponents largest eigenvalues and vectors (as columns) of
+         * the covariance matrix by the randomised range finder.
+         */
+        void randomisedEigen(const gsl_matrix *covariance, unsigned int numComponents, gsl_vector *eigenvalues, gsl_matrix *eigenvectors);
+        /**
+         * Replace the columns of the matrix with an orthonormal basis of them.
+         */
+        void orthonormalise(gsl_matrix *matrix);
+        bool randomised;
+        unsigned int numOversamples;
+        unsigned int numPowerIters;
+        unsigned int numThreads;
+        unsigned int numBands;
+        double totalVariance;
+        std::vector<double> means;
+        std::vector<double> eigenvalues;
+        // The components (components x bands, row major).
+        std::vector<double> components;
+    };
+
+}}
+
+#endif
@@ -0,0 +1,727 @@
+/*
+ *  RSGISImagePipeline.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISImagePipeline.h"
+
+namespace rsgis{namespace img{
+
+    RSGISPipelineCalc::RSGISPipelineCalc(std::vector<RSGISCalcImageValue*> calcs, std::vector<std::vector<unsigned int> > inPlanes, unsigned int numInputPlanes, std::vector<unsigned int> outPlanes): RSGISCalcImageValue(outPlanes.size())
+    {
+        this->calcs = calcs;
+        this->inPlanes = inPlanes;
+        this->numInputPlanes = numInputPlanes;
+        this->outPlanes = outPlanes;
+        this->numPlanes = numInputPlanes;
+        for(size_t s = 0; s < calcs.size(); ++s)
+        {
+            this->stepPlanes.push_back(this->numPlanes);
+            this->numPlanes += calcs[s]->getNumOutBands();
+        }
+        this->planeOutBand.assign(this->numPlanes, -1);
+        for(size_t o = 0; o < outPlanes.size(); ++o)
+        {
+            if((outPlanes[o] < numInputPlanes) || (outPlanes[o] >= this->numPlanes) || (this->planeOutBand[outPlanes[o]] != -1))
+            {
+                throw RSGISImageCalcException("The output planes of the pipeline pass must each be a different step output.");
+            }
+            this->planeOutBand[outPlanes[o]] = o;
+        }
+        this->planeUsed.assign(this->numPlanes, false);
+        for(size_t s = 0; s < inPlanes.size(); ++s)
+        {
+            for(std::vector<unsigned int>::const_iterator iterPlane = inPlanes[s].begin(); iterPlane != inPlanes[s].end(); ++iterPlane)
+            {
+                if((*iterPlane >= this->numPlanes) || ((*iterPlane >= numInputPlanes) && (*iterPlane >= this->stepPlanes[s])))
+                {
+                    throw RSGISImageCalcException("A step of the pipeline pass can only use the inputs and earlier steps.");
+                }
+                this->planeUsed[*iterPlane] = true;
+            }
+        }
+    }
+
+    void RSGISPipelineCalc::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        if(((unsigned int)numBands) != this->numInputPlanes)
+        {
+            throw RSGISImageCalcException("The number of input bands does not match the pipeline pass.");
+        }
+        rsgis::RSGISScratchScope scratch;
+        const float **planes = scratch.alloc<const float*>(this->numPlanes);
+        for(unsigned int n = 0; n < this->numInputPlanes; ++n)
+        {
+            planes[n] = bandPlanes[n];
+        }
+        for(size_t s = 0; s < this->calcs.size(); ++s)
+        {
+            int nIn = this->inPlanes[s].size();
+            const float **stepIn = scratch.alloc<const float*>(nIn);
+            for(int n = 0; n < nIn; ++n)
+            {
+                stepIn[n] = planes[this->inPlanes[s][n]];
+            }
+            int nOut = this->calcs[s]->getNumOutBands();
+            double **stepOut = scratch.alloc<double*>(nOut);
+            for(int b = 0; b < nOut; ++b)
+            {
+                int outBand = this->planeOutBand[this->stepPlanes[s] + b];
+                stepOut[b] = (outBand >= 0)?outPlanes[outBand]:scratch.alloc<double>(nPxls);
+            }
+
+            this->calcs[s]->calcImageBlock(stepIn, nIn, nPxls, stepOut);
+
+            // The later steps are given the output as it would be read back from a float image.
+            for(int b = 0; b < nOut; ++b)
+            {
+                unsigned int p = this->stepPlanes[s] + b;
+                if(this->planeUsed[p])
+                {
+                    float *plane = scratch.alloc<float>(nPxls);
+                    for(size_t i = 0; i < nPxls; ++i)
+                    {
+                        plane[i] = stepOut[b][i];
+                    }
+                    planes[p] = plane;
+                }
+            }
+        }
+    }
+
+    void RSGISPipelineCalc::calcImageValue(float *bandValues, int numBands, double *output)
+    {
+        rsgis::RSGISScratchScope scratch;
+        const float **bandPlanes = scratch.alloc<const float*>(numBands);
+        for(int n = 0; n < numBands; ++n)
+        {
+            bandPlanes[n] = &bandValues[n];
+        }
+        double **outPlanes = scratch.alloc<double*>(this->numOutBands);
+        for(int n = 0; n < this->numOutBands; ++n)
+        {
+            outPlanes[n] = &output[n];
+        }
+        this->calcImageBlock(bandPlanes, numBands, 1, outPlanes);
+    }
+
+    bool RSGISPipelineCalc::useWholeBlocks()
+    {
+        for(std::vector<RSGISCalcImageValue*>::iterator iterCalc = this->calcs.begin(); iterCalc != this->calcs.end(); ++iterCalc)
+        {
+            if((*iterCalc)->useWholeBlocks())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool RSGISPipelineCalc::isThreadSafe()
+    {
+        for(std::vector<RSGISCalcImageValue*>::iterator iterCalc = this->calcs.begin(); iterCalc != this->calcs.end(); ++iterCalc)
+        {
+            if(!(*iterCalc)->isThreadSafe())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    RSGISCalcImageValue* RSGISPipelineCalc::getThreadClone()
+    {
+        // The thread safe steps are shared with the clone, the others cloned.
+        std::vector<RSGISCalcImageValue*> cloneCalcs;
+        std::vector<RSGISCalcImageValue*> clonedCalcs;
+        for(std::vector<RSGISCalcImageValue*>::iterator iterCalc = this->calcs.begin(); iterCalc != this->calcs.end(); ++iterCalc)
+        {
+            RSGISCalcImageValue *calc = *iterCalc;
+            if(!calc->isThreadSafe())
+            {
+                calc = calc->getThreadClone();
+                if(calc == NULL)
+                {
+                    for(std::vector<RSGISCalcImageValue*>::iterator iterClone = clonedCalcs.begin(); iterClone != clonedCalcs.end(); ++iterClone)
+                    {
+                        delete *iterClone;
+                    }
+                    return NULL;
+                }
+                clonedCalcs.push_back(calc);
+            }
+            cloneCalcs.push_back(calc);
+        }
+        RSGISPipelineCalc *clone = new RSGISPipelineCalc(cloneCalcs, this->inPlanes, this->numInputPlanes, this->outPlanes);
+        clone->ownedCalcs = clonedCalcs;
+        return clone;
+    }
+
+    RSGISPipelineCalc::~RSGISPipelineCalc()
+    {
+        for(std::vector<RSGISCalcImageValue*>::iterator iterCalc = this->ownedCalcs.begin(); iterCalc != this->ownedCalcs.end(); ++iterCalc)
+        {
+            delete *iterCalc;
+        }
+    }
+
+
+
+    RSGISImagePipeline::RSGISImagePipeline()
+    {
+        this->tempDIR = "";
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+
+    void RSGISImagePipeline::addInput(std::string name, std::string inputImage)
+    {
+        unsigned int idx = this->addNode(name, rsgis_pipe_input, std::vector<std::string>());
+        this->nodes[idx].image = inputImage;
+    }
+
+    void RSGISImagePipeline::addCalcStep(std::string name, RSGISCalcImageValue *calc, std::vector<std::string> inputs)
+    {
+        if(calc == NULL)
+        {
+            throw RSGISImageCalcException("The calculator of step '" + name + "' is NULL.");
+        }
+        if(calc->getNumOutBands() <= 0)
+        {
+            throw RSGISImageCalcException("The calculator of step '" + name + "' must have output bands.");
+        }
+        unsigned int idx = this->addNode(name, rsgis_pipe_calc, inputs);
+        this->nodes[idx].calc = calc;
+    }
+
+    void RSGISImagePipeline::addCommandStep(std::string name, RSGISPipelineCommand command, std::vector<std::string> inputs)
+    {
+        unsigned int idx = this->addNode(name, rsgis_pipe_command, inputs);
+        this->nodes[idx].command = command;
+    }
+
+    void RSGISImagePipeline::persist(std::string name, std::string outputImage, std::string gdalFormat, GDALDataType gdalDataType)
+    {
+        std::map<std::string, unsigned int>::iterator iterNode = this->nodeIdx.find(name);
+        if(iterNode == this->nodeIdx.end())
+        {
+            throw RSGISImageCalcException("There is no step '" + name + "' to persist.");
+        }
+        RSGISPipelineNode &node = this->nodes[iterNode->second];
+        if(node.type == rsgis_pipe_input)
+        {
+            throw RSGISImageCalcException("'" + name + "' is an input so cannot be persisted.");
+        }
+        if(node.persist)
+        {
+            throw RSGISImageCalcException("The step '" + name + "' has already been persisted.");
+        }
+        node.persist = true;
+        node.image = outputImage;
+        node.gdalFormat = gdalFormat;
+        node.gdalDataType = gdalDataType;
+    }
+
+    void RSGISImagePipeline::setTempDIR(std::string tempDIR)
+    {
+        this->tempDIR = tempDIR;
+    }
+
+    void RSGISImagePipeline::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+
+    void RSGISImagePipeline::execute()
+    {
+        GDALAllRegister();
+        this->planPasses();
+
+        // The tasks are the passes followed by the command steps.
+        unsigned int numPasses = this->passes.size();
+        std::vector<unsigned int> commands;
+        std::map<unsigned int, unsigned int> commandTask;
+        for(unsigned int i = 0; i < this->nodes.size(); ++i)
+        {
+            if(this->nodes[i].needed && (this->nodes[i].type == rsgis_pipe_command))
+            {
+                commandTask[i] = numPasses + commands.size();
+                commands.push_back(i);
+            }
+        }
+        unsigned int numTasks = numPasses + commands.size();
+
+        std::vector<std::vector<unsigned int> > taskInputs(numTasks);
+        for(unsigned int g = 0; g < numPasses; ++g)
+        {
+            for(std::vector<unsigned int>::iterator iterStep = this->passes[g].begin(); iterStep != this->passes[g].end(); ++iterStep)
+            {
+                taskInputs[g].insert(taskInputs[g].end(), this->nodes[*iterStep].inputs.begin(), this->nodes[*iterStep].inputs.end());
+            }
+        }
+        for(size_t c = 0; c < commands.size(); ++c)
+        {
+            taskInputs[numPasses + c] = this->nodes[commands[c]].inputs;
+        }
+        std::vector<std::vector<unsigned int> > dependents(numTasks);
+        std::vector<unsigned int> numDeps(numTasks, 0);
+        for(unsigned int t = 0; t < numTasks; ++t)
+        {
+            std::vector<unsigned int> deps;
+            for(std::vector<unsigned int>::iterator iterIn = taskInputs[t].begin(); iterIn != taskInputs[t].end(); ++iterIn)
+            {
+                const RSGISPipelineNode &input = this->nodes[*iterIn];
+                if(input.type == rsgis_pipe_command)
+                {
+                    deps.push_back(commandTask[*iterIn]);
+                }
+                else if((input.type == rsgis_pipe_calc) && (((unsigned int)input.group) != t))
+                {
+                    deps.push_back(input.group);
+                }
+            }
+            std::sort(deps.begin(), deps.end());
+            deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+            for(std::vector<unsigned int>::iterator iterDep = deps.begin(); iterDep != deps.end(); ++iterDep)
+            {
+                dependents[*iterDep].push_back(t);
+            }
+            numDeps[t] = deps.size();
+        }
+
+        std::deque<unsigned int> ready;
+        for(unsigned int t = 0; t < numTasks; ++t)
+        {
+            if(numDeps[t] == 0)
+            {
+                ready.push_back(t);
+            }
+        }
+
+        std::mutex taskMutex;
+        std::condition_variable taskCond;
+        unsigned int numDone = 0;
+        bool aborted = false;
+        rsgis::utils::RSGISWorkerPool pool(std::max<unsigned int>(std::min(this->numThreads, numTasks), 1));
+        try
+        {
+            pool.runOnEach([&](unsigned int)
+            {
+                try
+                {
+                    while(true)
+                    {
+                        unsigned int task = 0;
+                        {
+                            std::unique_lock<std::mutex> lock(taskMutex);
+                            taskCond.wait(lock, [&](){return aborted || (!ready.empty()) || (numDone == numTasks);});
+                            if(aborted || ready.empty())
+                            {
+                                break;
+                            }
+                            task = ready.front();
+                            ready.pop_front();
+                        }
+
+                        if(task < numPasses)
+                        {
+                            this->runPass(task);
+                        }
+                        else
+                        {
+                            this->runCommand(commands[task - numPasses]);
+                        }
+
+                        std::unique_lock<std::mutex> lock(taskMutex);
+                        ++numDone;
+                        for(std::vector<unsigned int>::iterator iterDep = dependents[task].begin(); iterDep != dependents[task].end(); ++iterDep)
+                        {
+                            if((--numDeps[*iterDep]) == 0)
+                            {
+                                ready.push_back(*iterDep);
+                            }
+                        }
+                        taskCond.notify_all();
+                    }
+                }
+                catch(...)
+                {
+                    std::unique_lock<std::mutex> lock(taskMutex);
+                    aborted = true;
+                    taskCond.notify_all();
+                    throw;
+                }
+            });
+        }
+        catch(...)
+        {
+            this->removeTemporaryImages();
+            throw;
+        }
+        this->removeTemporaryImages();
+    }
+
+    unsigned int RSGISImagePipeline::addNode(std::string name, RSGISPipelineNodeType type, std::vector<std::string> inputs)
+    {
+        if(name == "")
+        {
+            throw RSGISImageCalcException("The steps of a pipeline must be named.");
+        }
+        if(this->nodeIdx.count(name) > 0)
+        {
+            throw RSGISImageCalcException("There is already a step or input named '" + name + "'.");
+        }
+        if((type != rsgis_pipe_input) && inputs.empty())
+        {
+            throw RSGISImageCalcException("The step '" + name + "' has no inputs.");
+        }
+        RSGISPipelineNode node;
+        node.name = name;
+        node.type = type;
+        for(std::vector<std::string>::iterator iterIn = inputs.begin(); iterIn != inputs.end(); ++iterIn)
+        {
+            std::map<std::string, unsigned int>::iterator iterNode = this->nodeIdx.find(*iterIn);
+            if(iterNode == this->nodeIdx.end())
+            {
+                throw RSGISImageCalcException("The input '" + (*iterIn) + "' of step '" + name + "' has not been added.");
+            }
+            node.inputs.push_back(iterNode->second);
+        }
+        node.calc = NULL;
+        node.image = "";
+        node.gdalFormat = "KEA";
+        node.gdalDataType = GDT_Float32;
+        node.persist = false;
+        node.temporary = false;
+        node.needed = false;
+        node.level = 0;
+        node.group = -1;
+        unsigned int idx = this->nodes.size();
+        this->nodes.push_back(node);
+        this->nodeIdx[name] = idx;
+        return idx;
+    }
+
+    void RSGISImagePipeline::planPasses()
+    {
+        // The nodes were added after their inputs so are in dependency order.
+        bool anyPersisted = false;
+        for(std::vector<RSGISPipelineNode>::iterator iterNode = this->nodes.begin(); iterNode != this->nodes.end(); ++iterNode)
+        {
+            iterNode->needed = iterNode->persist;
+            iterNode->group = -1;
+            if(iterNode->temporary)
+            {
+                iterNode->image = "";
+                iterNode->gdalFormat = "KEA";
+                iterNode->gdalDataType = GDT_Float32;
+                iterNode->temporary = false;
+            }
+            anyPersisted = anyPersisted || iterNode->persist;
+        }
+        if(!anyPersisted)
+        {
+            throw RSGISImageCalcException("No outputs of the pipeline have been persisted.");
+        }
+        for(size_t i = this->nodes.size(); i > 0; --i)
+        {
+            if(this->nodes[i-1].needed)
+            {
+                for(std::vector<unsigned int>::iterator iterIn = this->nodes[i-1].inputs.begin(); iterIn != this->nodes[i-1].inputs.end(); ++iterIn)
+                {
+                    this->nodes[*iterIn].needed = true;
+                }
+            }
+        }
+
+        // The level of a node is the number of command steps it is after, the
+        // calc steps being fused with the calc steps they use at the same
+        // level so a pass never depends on a command which depends on it.
+        std::vector<unsigned int> groupOf(this->nodes.size());
+        for(unsigned int i = 0; i < this->nodes.size(); ++i)
+        {
+            RSGISPipelineNode &node = this->nodes[i];
+            groupOf[i] = i;
+            node.level = 0;
+            for(std::vector<unsigned int>::iterator iterIn = node.inputs.begin(); iterIn != node.inputs.end(); ++iterIn)
+            {
+                node.level = std::max(node.level, this->nodes[*iterIn].level);
+            }
+            if(node.type == rsgis_pipe_command)
+            {
+                ++node.level;
+            }
+            else if((node.type == rsgis_pipe_calc) && node.needed)
+            {
+                for(std::vector<unsigned int>::iterator iterIn = node.inputs.begin(); iterIn != node.inputs.end(); ++iterIn)
+                {
+                    const RSGISPipelineNode &input = this->nodes[*iterIn];
+                    if((input.type == rsgis_pipe_calc) && (input.level == node.level))
+                    {
+                        unsigned int a = *iterIn;
+                        while(groupOf[a] != a)
+                        {
+                            a = groupOf[a];
+                        }
+                        unsigned int b = i;
+                        while(groupOf[b] != b)
+                        {
+                            b = groupOf[b];
+                        }
+                        groupOf[std::max(a, b)] = std::min(a, b);
+                    }
+                }
+            }
+        }
+
+        this->passes.clear();
+        std::map<unsigned int, int> rootPass;
+        for(unsigned int i = 0; i < this->nodes.size(); ++i)
+        {
+            if(this->nodes[i].needed && (this->nodes[i].type == rsgis_pipe_calc))
+            {
+                unsigned int root = i;
+                while(groupOf[root] != root)
+                {
+                    root = groupOf[root];
+                }
+                if(rootPass.count(root) == 0)
+                {
+                    rootPass[root] = this->passes.size();
+                    this->passes.push_back(std::vector<unsigned int>());
+                }
+                this->nodes[i].group = rootPass[root];
+                this->passes[rootPass[root]].push_back(i);
+            }
+        }
+
+        // Everything read by a command step or another pass needs an image.
+        std::vector<bool> materialise(this->nodes.size(), false);
+        for(unsigned int i = 0; i < this->nodes.size(); ++i)
+        {
+            const RSGISPipelineNode &node = this->nodes[i];
+            if(!node.needed)
+            {
+                continue;
+            }
+            materialise[i] = materialise[i] || (node.type == rsgis_pipe_command);
+            for(std::vector<unsigned int>::const_iterator iterIn = node.inputs.begin(); iterIn != node.inputs.end(); ++iterIn)
+            {
+                if((node.type == rsgis_pipe_command) || (this->nodes[*iterIn].group != node.group))
+                {
+                    materialise[*iterIn] = true;
+                }
+            }
+        }
+        boost::filesystem::path tmpPath = (this->tempDIR == "")?boost::filesystem::temp_directory_path():boost::filesystem::path(this->tempDIR);
+        for(unsigned int i = 0; i < this->nodes.size(); ++i)
+        {
+            RSGISPipelineNode &node = this->nodes[i];
+            if(materialise[i] && (node.type != rsgis_pipe_input) && (!node.persist))
+            {
+                boost::filesystem::path imgPath = tmpPath / boost::filesystem::unique_path("rsgispipe_%%%%%%%%%%%%.kea");
+                node.image = imgPath.string();
+                node.temporary = true;
+            }
+        }
+    }
+
+    void RSGISImagePipeline::runPass(int group)
+    {
+        const std::vector<unsigned int> &steps = this->passes[group];
+
+        // The images read by the pass, in the order they are first used.
+        std::vector<unsigned int> sources;
+        std::map<unsigned int, size_t> sourceIdx;
+        for(std::vector<unsigned int>::const_iterator iterStep = steps.begin(); iterStep != steps.end(); ++iterStep)
+        {
+            const std::vector<unsigned int> &inputs = this->nodes[*iterStep].inputs;
+            for(std::vector<unsigned int>::const_iterator iterIn = inputs.begin(); iterIn != inputs.end(); ++iterIn)
+            {
+                if((this->nodes[*iterIn].group != group) && (sourceIdx.count(*iterIn) == 0))
+                {
+                    sourceIdx[*iterIn] = sources.size();
+                    sources.push_back(*iterIn);
+                }
+            }
+        }
+
+        std::vector<GDALDataset*> datasets(sources.size(), NULL);
+        std::vector<GDALDataset*> outDatasets;
+        try
+        {
+            std::vector<unsigned int> sourcePlanes;
+            unsigned int numInputPlanes = 0;
+            for(size_t k = 0; k < sources.size(); ++k)
+            {
+                const std::string &image = this->nodes[sources[k]].image;
+                datasets[k] = (GDALDataset *) GDALOpen(image.c_str(), GA_ReadOnly);
+                if(datasets[k] == NULL)
+                {
+                    throw RSGISImageCalcException("Could not open image " + image);
+                }
+                sourcePlanes.push_back(numInputPlanes);
+                numInputPlanes += datasets[k]->GetRasterCount();
+            }
+
+            std::vector<RSGISCalcImageValue*> calcs;
+            std::map<unsigned int, unsigned int> stepPlane;
+            unsigned int numPlanes = numInputPlanes;
+            for(std::vector<unsigned int>::const_iterator iterStep = steps.begin(); iterStep != steps.end(); ++iterStep)
+            {
+                calcs.push_back(this->nodes[*iterStep].calc);
+                stepPlane[*iterStep] = numPlanes;
+                numPlanes += this->nodes[*iterStep].calc->getNumOutBands();
+            }
+            std::vector<std::vector<unsigned int> > inPlanes;
+            std::vector<unsigned int> outPlanes;
+            for(std::vector<unsigned int>::const_iterator iterStep = steps.begin(); iterStep != steps.end(); ++iterStep)
+            {
+                std::vector<unsigned int> planes;
+                const std::vector<unsigned int> &inputs = this->nodes[*iterStep].inputs;
+                for(std::vector<unsigned int>::const_iterator iterIn = inputs.begin(); iterIn != inputs.end(); ++iterIn)
+                {
+                    unsigned int first = 0;
+                    unsigned int count = 0;
+                    if(this->nodes[*iterIn].group == group)
+                    {
+                        first = stepPlane[*iterIn];
+                        count = this->nodes[*iterIn].calc->getNumOutBands();
+                    }
+                    else
+                    {
+                        size_t k = sourceIdx[*iterIn];
+                        first = sourcePlanes[k];
+                        count = datasets[k]->GetRasterCount();
+                    }
+                    for(unsigned int p = 0; p < count; ++p)
+                    {
+                        planes.push_back(first + p);
+                    }
+                }
+                inPlanes.push_back(planes);
+                if(this->nodes[*iterStep].image != "")
+                {
+                    for(int b = 0; b < this->nodes[*iterStep].calc->getNumOutBands(); ++b)
+                    {
+                        outPlanes.push_back(stepPlane[*iterStep] + b);
+                    }
+                }
+            }
+
+            // The outputs are written on the grid of the overlap of the inputs, as calcImage.
+            RSGISImageUtils imgUtils;
+            double gdalTransform[6];
+            std::vector<int> dsOffsetVals(datasets.size() * 2, 0);
+            std::vector<int*> dsOffsets(datasets.size());
+            for(size_t k = 0; k < datasets.size(); ++k)
+            {
+                dsOffsets[k] = &dsOffsetVals[k * 2];
+            }
+            int width = 0;
+            int height = 0;
+            imgUtils.getImageOverlap(datasets.data(), datasets.size(), dsOffsets.data(), &width, &height, gdalTransform);
+
+            for(std::vector<unsigned int>::const_iterator iterStep = steps.begin(); iterStep != steps.end(); ++iterStep)
+            {
+                const RSGISPipelineNode &node = this->nodes[*iterStep];
+                if(node.image == "")
+                {
+                    continue;
+                }
+                GDALDriver *gdalDriver = GetGDALDriverManager()->GetDriverByName(node.gdalFormat.c_str());
+                if(gdalDriver == NULL)
+                {
+                    throw RSGISImageCalcException("Requested GDAL driver does not exists..");
+                }
+                char **papszOptions = imgUtils.getGDALCreationOptionsForFormat(node.gdalFormat);
+                RSGISDatasetCache::invalidate(node.image);
+                GDALDataset *outDataset = gdalDriver->Create(node.image.c_str(), width, height, node.calc->getNumOutBands(), node.gdalDataType, papszOptions);
+                CSLDestroy(papszOptions);
+                if(outDataset == NULL)
+                {
+                    throw RSGISImageCalcException("Output image could not be created. Check filepath: " + node.image);
+                }
+                outDatasets.push_back(outDataset);
+                outDataset->SetGeoTransform(gdalTransform);
+                outDataset->SetProjection(datasets[0]->GetProjectionRef());
+            }
+
+            RSGISPipelineCalc passCalc(calcs, inPlanes, numInputPlanes, outPlanes);
+            RSGISCalcImage calcImage(&passCalc);
+            calcImage.calcImage(datasets.data(), datasets.size(), outDatasets.data(), outDatasets.size());
+        }
+        catch(RSGISException &e)
+        {
+            for(std::vector<GDALDataset*>::iterator iterDS = outDatasets.begin(); iterDS != outDatasets.end(); ++iterDS)
+            {
+                GDALClose(*iterDS);
+            }
+            for(std::vector<GDALDataset*>::iterator iterDS = datasets.begin(); iterDS != datasets.end(); ++iterDS)
+            {
+                if(*iterDS != NULL)
+                {
+                    GDALClose(*iterDS);
+                }
+            }
+            throw;
+        }
+        for(std::vector<GDALDataset*>::iterator iterDS = outDatasets.begin(); iterDS != outDatasets.end(); ++iterDS)
+        {
+            GDALClose(*iterDS);
+        }
+        for(std::vector<GDALDataset*>::iterator iterDS = datasets.begin(); iterDS != datasets.end(); ++iterDS)
+        {
+            GDALClose(*iterDS);
+        }
+    }
+
+    void RSGISImagePipeline::runCommand(unsigned int node)
+    {
+        const RSGISPipelineNode &step = this->nodes[node];
+        std::vector<std::string> inputImages;
+        for(std::vector<unsigned int>::const_iterator iterIn = step.inputs.begin(); iterIn != step.inputs.end(); ++iterIn)
+        {
+            inputImages.push_back(this->nodes[*iterIn].image);
+        }
+        RSGISDatasetCache::invalidate(step.image);
+        step.command(inputImages, step.image, step.gdalFormat);
+    }
+
+    void RSGISImagePipeline::removeTemporaryImages()
+    {
+        for(std::vector<RSGISPipelineNode>::iterator iterNode = this->nodes.begin(); iterNode != this->nodes.end(); ++iterNode)
+        {
+            if(iterNode->temporary)
+            {
+                RSGISDatasetCache::invalidate(iterNode->image);
+                boost::system::error_code ec;
+                boost::filesystem::remove(iterNode->image, ec);
+                boost::filesystem::remove(iterNode->image + ".aux.xml", ec);
+            }
+        }
+    }
+
+    RSGISImagePipeline::~RSGISImagePipeline()
+    {
+
+    }
+
+}}
@@ -0,0 +1,205 @@
+/*
+ *  RSGISImagePipeline.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISImagePipeline_H
+#define RSGISImagePipeline_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <algorithm>
+#include <cstdlib>
+
+#include <boost/filesystem.hpp>
+
+#include "gdal_priv.h"
+
+#include "common/RSGISScratchArena.h"
+#include "common/RSGISParallel.h"
+
+#include "img/RSGISImageCalcException.h"
+#include "img/RSGISImageUtils.h"
+#include "img/RSGISDatasetCache.h"
+#include "img/RSGISCalcImageValue.h"
+#include "img/RSGISCalcImage.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_img_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace img{
+
+    /**
+     * A step of a RSGISImagePipeline which is not blockwise (e.g., a
+     * segmentation or one of the rsgis::cmds functions) and so reads its
+     * inputs from image files and writes its output to outputImage in the
+     * gdalFormat given.
+     */
+    typedef std::function<void(const std::vector<std::string> &inputImages, const std::string &outputImage, const std::string &gdalFormat)> RSGISPipelineCommand;
+
+    enum RSGISPipelineNodeType
+    {
+        rsgis_pipe_input,
+        rsgis_pipe_calc,
+        rsgis_pipe_command
+    };
+
+    /**
+     * A dataset of a RSGISImagePipeline: an input image or the output of a step.
+     */
+    struct DllExport RSGISPipelineNode
+    {
+        std::string name;
+        RSGISPipelineNodeType type;
+        std::vector<unsigned int> inputs;
+        RSGISCalcImageValue *calc;
+        RSGISPipelineCommand command;
+        // The image file of the dataset, if it is written (or an input).
+        std::string image;
+        std::string gdalFormat;
+        GDALDataType gdalDataType;
+        bool persist;
+        bool temporary;
+        // Set by RSGISImagePipeline::execute.
+        bool needed;
+        unsigned int level;
+        int group;
+    };
+
+    /**
+     * The calculator for a group of calc steps which are run in one pass
+     * (see RSGISImagePipeline). The block of the input images is passed
+     * through each step in turn, the outputs of a step being held in scratch
+     * memory for the steps which use it, and the outputs of the steps which
+     * are written copied to the output planes.
+     *
+     * inPlanes gives, for each step, the planes making up its input, where
+     * the planes are numbered with the bands of the input images first and
+     * then the output bands of each step in turn. outPlanes gives the planes
+     * to be written as the output bands.
+     */
+    class DllExport RSGISPipelineCalc : public RSGISCalcImageValue
+    {
+    public:
+        RSGISPipelineCalc(std::vector<RSGISCalcImageValue*> calcs, std::vector<std::vector<unsigned int> > inPlanes, unsigned int numInputPlanes, std::vector<unsigned int> outPlanes);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        void calcImageValue(float *bandValues, int numBands, double *output);
+        bool useWholeBlocks();
+        bool isThreadSafe();
+        RSGISCalcImageValue* getThreadClone();
+        ~RSGISPipelineCalc();
+    protected:
+        std::vector<RSGISCalcImageValue*> calcs;
+        std::vector<std::vector<unsigned int> > inPlanes;
+        unsigned int numInputPlanes;
+        std::vector<unsigned int> outPlanes;
+        // The first plane of the output of each step.
+        std::vector<unsigned int> stepPlanes;
+        unsigned int numPlanes;
+        // For each plane, the output band it is written to (or -1).
+        std::vector<int> planeOutBand;
+        std::vector<bool> planeUsed;
+        std::vector<RSGISCalcImageValue*> ownedCalcs;
+    };
+
+    /**
+     * Runs a workflow of image steps as a graph, without writing the
+     * datasets passed between steps where it can be avoided. Each step
+     * names the datasets (inputs or the outputs of other steps) it uses,
+     * which must have been added before it, and only the datasets marked
+     * with persist are kept once execute returns.
+     *
+     * Calc steps are pixel wise RSGISCalcImageValue calculators (the output
+     * of a pixel only depends on the input values of that pixel) and a group
+     * of connected calc steps is fused into one RSGISCalcImage pass, with the
+     * datasets between them held in memory one block at a time. Command
+     * steps (anything else, which needs image files) break the fusion: the
+     * datasets they read are written, to the temporary directory if not
+     * persisted, and removed when the pipeline has finished.
+     *
+     * The passes and command steps which do not depend on each other (e.g.,
+     * independent branches of the workflow) are run concurrently, up to the
+     * number set with setNumThreads (the default is rsgis::utils::
+     * getNumThreads()). The passes share that budget: when more than one
+     * task is run at a time each pass runs on a single thread, otherwise
+     * the pass uses the threads of RSGISCalcImage.
+     *
+     * Temporary datasets are written as KEA (32 bit float) to the directory
+     * set with setTempDIR (default the system temporary directory).
+     */
+    class DllExport RSGISImagePipeline
+    {
+    public:
+        RSGISImagePipeline();
+        void addInput(std::string name, std::string inputImage);
+        /**
+         * Add a pixel wise step, the input being the bands of the inputs in
+         * order. The pipeline does not take ownership of calc.
+         */
+        void addCalcStep(std::string name, RSGISCalcImageValue *calc, std::vector<std::string> inputs);
+        void addCommandStep(std::string name, RSGISPipelineCommand command, std::vector<std::string> inputs);
+        /**
+         * Write the output of the step to outputImage. For command steps the
+         * data type is chosen by the command.
+         */
+        void persist(std::string name, std::string outputImage, std::string gdalFormat="KEA", GDALDataType gdalDataType=GDT_Float32);
+        void setTempDIR(std::string tempDIR);
+        void setNumThreads(unsigned int numThreads);
+        /**
+         * Run the steps needed for the persisted datasets.
+         */
+        void execute();
+        ~RSGISImagePipeline();
+    protected:
+        unsigned int addNode(std::string name, RSGISPipelineNodeType type, std::vector<std::string> inputs);
+        void planPasses();
+        void runPass(int group);
+        void runCommand(unsigned int node);
+        void removeTemporaryImages();
+        std::vector<RSGISPipelineNode> nodes;
+        std::map<std::string, unsigned int> nodeIdx;
+        // The steps of each pass in the order they are run.
+        std::vector<std::vector<unsigned int> > passes;
+        std::string tempDIR;
+        unsigned int numThreads;
+    };
+
+}}
+
+#endif
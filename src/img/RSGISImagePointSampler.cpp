@@ -0,0 +1,297 @@
+/*
+ *  RSGISImagePointSampler.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2010 RSGISLib. All rights reserved.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISImagePointSampler.h"
+
+namespace rsgis{namespace img{
+
+    RSGISImagePointSampler::RSGISImagePointSampler()
+    {
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+
+    void RSGISImagePointSampler::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+
+    void RSGISImagePointSampler::samplePoints(GDALDataset *image, std::vector<unsigned int> bands, const std::vector<double> &xCoords, const std::vector<double> &yCoords, std::vector<float> *vals, std::vector<unsigned char> *validPts, float outVal)
+    {
+        this->samplePoints(image, bands, xCoords, yCoords, vals, validPts, outVal, NULL);
+    }
+
+    void RSGISImagePointSampler::samplePoints(GDALDataset *image, std::vector<unsigned int> bands, const std::vector<double> &xCoords, const std::vector<double> &yCoords, std::vector<float> *vals, std::vector<unsigned char> *validPts, float outVal, std::mutex *ioMutex)
+    {
+        std::unique_lock<std::mutex> ioLock;
+        if(ioMutex != NULL)
+        {
+            ioLock = std::unique_lock<std::mutex>(*ioMutex);
+        }
+        if(image == NULL)
+        {
+            throw RSGISImageCalcException("The image to be sampled is NULL.");
+        }
+        if(xCoords.size() != yCoords.size())
+        {
+            throw RSGISImageCalcException("The number of x and y point coordinates are not the same.");
+        }
+        if(bands.empty())
+        {
+            throw RSGISImageCalcException("No image bands were provided to be sampled.");
+        }
+        int numImgBands = image->GetRasterCount();
+        std::vector<int> bandMap;
+        for(std::vector<unsigned int>::iterator iterBands = bands.begin(); iterBands != bands.end(); ++iterBands)
+        {
+            if(((*iterBands) < 1) || ((*iterBands) > numImgBands))
+            {
+                throw RSGISImageCalcException("Band numbers start at 1 and must be equal or less than the number of bands within the image.");
+            }
+            bandMap.push_back(*iterBands);
+        }
+
+        size_t numPts = xCoords.size();
+        size_t numBands = bands.size();
+        vals->assign(numPts * numBands, outVal);
+        if(validPts != NULL)
+        {
+            validPts->assign(numPts, 0);
+        }
+        if(numPts == 0)
+        {
+            return;
+        }
+
+        double trans[6];
+        image->GetGeoTransform(trans);
+        long xSize = image->GetRasterXSize();
+        long ySize = image->GetRasterYSize();
+
+        // Points are grouped by the native block, limited in size so formats
+        // with very large blocks (or a single block) are not read in one go.
+        int blockXSize = 0;
+        int blockYSize = 0;
+        image->GetRasterBand(bandMap[0])->GetBlockSize(&blockXSize, &blockYSize);
+        if(ioMutex != NULL)
+        {
+            ioLock.unlock();
+        }
+        long tileXSize = std::min<long>(std::max<int>(blockXSize, 1), 512);
+        long tileYSize = std::min<long>(std::max<int>(blockYSize, 1), 512);
+        long nXTiles = (xSize + tileXSize - 1) / tileXSize;
+
+        std::vector<long> pxlX(numPts, 0);
+        std::vector<long> pxlY(numPts, 0);
+        std::vector<std::pair<long, size_t> > ptTiles;
+        ptTiles.reserve(numPts);
+        for(size_t i = 0; i < numPts; ++i)
+        {
+            double xPxlF = std::floor((xCoords[i] - trans[0]) / trans[1]);
+            double yPxlF = std::floor((yCoords[i] - trans[3]) / trans[5]);
+            if((xPxlF >= 0) && (yPxlF >= 0) && (xPxlF < xSize) && (yPxlF < ySize))
+            {
+                pxlX[i] = (long) xPxlF;
+                pxlY[i] = (long) yPxlF;
+                ptTiles.push_back(std::pair<long, size_t>(((pxlY[i] / tileYSize) * nXTiles) + (pxlX[i] / tileXSize), i));
+            }
+        }
+        std::sort(ptTiles.begin(), ptTiles.end());
+
+        std::vector<float> buffer;
+        size_t grpStart = 0;
+        while(grpStart < ptTiles.size())
+        {
+            size_t grpEnd = grpStart;
+            long minX = pxlX[ptTiles[grpStart].second];
+            long maxX = minX;
+            long minY = pxlY[ptTiles[grpStart].second];
+            long maxY = minY;
+            while((grpEnd < ptTiles.size()) && (ptTiles[grpEnd].first == ptTiles[grpStart].first))
+            {
+                size_t idx = ptTiles[grpEnd].second;
+                minX = std::min(minX, pxlX[idx]);
+                maxX = std::max(maxX, pxlX[idx]);
+                minY = std::min(minY, pxlY[idx]);
+                maxY = std::max(maxY, pxlY[idx]);
+                ++grpEnd;
+            }
+
+            // Only the window covering the points within the tile is read.
+            long winXSize = (maxX - minX) + 1;
+            long winYSize = (maxY - minY) + 1;
+            buffer.resize(((size_t)winXSize) * winYSize * numBands);
+            GSpacing pxlSpace = numBands * sizeof(float);
+            if(ioMutex != NULL)
+            {
+                ioLock.lock();
+            }
+            if(image->RasterIO(GF_Read, minX, minY, winXSize, winYSize, buffer.data(), winXSize, winYSize, GDT_Float32, numBands, bandMap.data(), pxlSpace, pxlSpace * winXSize, sizeof(float), NULL) != CE_None)
+            {
+                throw RSGISImageCalcException("Could not read the image block to be sampled.");
+            }
+            if(ioMutex != NULL)
+            {
+                ioLock.unlock();
+            }
+
+            for(size_t n = grpStart; n < grpEnd; ++n)
+            {
+                size_t idx = ptTiles[n].second;
+                size_t bufIdx = ((((size_t)(pxlY[idx] - minY)) * winXSize) + (pxlX[idx] - minX)) * numBands;
+                for(size_t b = 0; b < numBands; ++b)
+                {
+                    (*vals)[(idx * numBands) + b] = buffer[bufIdx + b];
+                }
+                if(validPts != NULL)
+                {
+                    (*validPts)[idx] = 1;
+                }
+            }
+            grpStart = grpEnd;
+        }
+    }
+
+    void RSGISImagePointSampler::samplePoints(std::vector<std::pair<std::string, std::vector<unsigned int> > > imageFiles, const std::vector<double> &xCoords, const std::vector<double> &yCoords, std::vector<float> *vals, std::vector<unsigned char> *validPts, float outVal)
+    {
+        if(imageFiles.empty())
+        {
+            throw RSGISImageCalcException("There were no images provided.");
+        }
+        size_t numImgs = imageFiles.size();
+        size_t numPts = xCoords.size();
+        size_t numBands = 0;
+        std::vector<size_t> bandOffsets(numImgs, 0);
+        for(size_t i = 0; i < numImgs; ++i)
+        {
+            bandOffsets[i] = numBands;
+            numBands += imageFiles[i].second.size();
+        }
+        vals->assign(numPts * numBands, outVal);
+        if(validPts != NULL)
+        {
+            validPts->assign(numPts, 1);
+        }
+
+        std::vector<std::vector<float> > imgVals(numImgs);
+        std::vector<std::vector<unsigned char> > imgValid(numImgs);
+        std::mutex ioMutex;
+        rsgis::utils::RSGISWorkerPool pool(this->numThreads);
+        for(size_t batchStart = 0; batchStart < numImgs; batchStart += pool.getNumThreads())
+        {
+            size_t batchEnd = std::min<size_t>(batchStart + pool.getNumThreads(), numImgs);
+            pool.parallelFor(batchEnd - batchStart, [&](size_t item, unsigned int)
+            {
+                size_t i = batchStart + item;
+                GDALDataset *dataset = NULL;
+                {
+                    std::lock_guard<std::mutex> lock(ioMutex);
+                    dataset = (GDALDataset *) GDALOpen(imageFiles[i].first.c_str(), GA_ReadOnly);
+                }
+                if(dataset == NULL)
+                {
+                    std::string message = std::string("Could not open image ") + imageFiles[i].first;
+                    throw RSGISImageCalcException(message);
+                }
+                try
+                {
+                    this->samplePoints(dataset, imageFiles[i].second, xCoords, yCoords, &imgVals[i], &imgValid[i], outVal, &ioMutex);
+                }
+                catch(...)
+                {
+                    std::lock_guard<std::mutex> lock(ioMutex);
+                    GDALClose(dataset);
+                    throw;
+                }
+                std::lock_guard<std::mutex> lock(ioMutex);
+                GDALClose(dataset);
+            });
+
+            for(size_t i = batchStart; i < batchEnd; ++i)
+            {
+                size_t numImgBands = imageFiles[i].second.size();
+                for(size_t p = 0; p < numPts; ++p)
+                {
+                    for(size_t b = 0; b < numImgBands; ++b)
+                    {
+                        (*vals)[(p * numBands) + bandOffsets[i] + b] = imgVals[i][(p * numImgBands) + b];
+                    }
+                    if((validPts != NULL) && (imgValid[i][p] == 0))
+                    {
+                        (*validPts)[p] = 0;
+                    }
+                }
+                std::vector<float>().swap(imgVals[i]);
+                std::vector<unsigned char>().swap(imgValid[i]);
+            }
+        }
+    }
+
+    void RSGISImagePointSampler::readLayerPoints(OGRLayer *layer, std::vector<double> *xCoords, std::vector<double> *yCoords, std::vector<long> *fids)
+    {
+        if(layer == NULL)
+        {
+            throw RSGISImageCalcException("The points layer is NULL.");
+        }
+        xCoords->clear();
+        yCoords->clear();
+        if(fids != NULL)
+        {
+            fids->clear();
+        }
+
+        OGREnvelope ogrEnv;
+        OGRFeature *feature = NULL;
+        layer->ResetReading();
+        while((feature = layer->GetNextFeature()) != NULL)
+        {
+            OGRGeometry *geometry = feature->GetGeometryRef();
+            if((geometry != NULL) && (!geometry->IsEmpty()))
+            {
+                if(wkbFlatten(geometry->getGeometryType()) == wkbPoint)
+                {
+                    OGRPoint *pt = (OGRPoint *) geometry;
+                    xCoords->push_back(pt->getX());
+                    yCoords->push_back(pt->getY());
+                }
+                else
+                {
+                    geometry->getEnvelope(&ogrEnv);
+                    xCoords->push_back(ogrEnv.MinX + ((ogrEnv.MaxX - ogrEnv.MinX)/2));
+                    yCoords->push_back(ogrEnv.MinY + ((ogrEnv.MaxY - ogrEnv.MinY)/2));
+                }
+                if(fids != NULL)
+                {
+                    fids->push_back(feature->GetFID());
+                }
+            }
+            OGRFeature::DestroyFeature(feature);
+        }
+        layer->ResetReading();
+    }
+
+    RSGISImagePointSampler::~RSGISImagePointSampler()
+    {
+
+    }
+
+}}
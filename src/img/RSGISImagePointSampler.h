@@ -0,0 +1,116 @@
+/*
+ *  RSGISImagePointSampler.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2010 RSGISLib. All rights reserved.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISImagePointSampler_H
+#define RSGISImagePointSampler_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <mutex>
+#include <exception>
+#include <cstdlib>
+
+#include "gdal_priv.h"
+#include "ogrsf_frmts.h"
+
+#include "common/RSGISImageException.h"
+#include "common/RSGISParallel.h"
+
+#include "img/RSGISImageCalcException.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_img_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace img{
+
+    /**
+     * Extracts the pixel values of image bands at a (large) set of points.
+     *
+     * The points are converted to pixel indices and sorted by the image block
+     * they fall within, so each block is read once (for all the bands being
+     * sampled) and all its points filled from it, rather than making a 1x1
+     * RasterIO call for each point.
+     *
+     * The values are returned as a row of values for each point (in the order
+     * the points were provided) with a column for each band. Points outside
+     * an image are given outVal and flagged as not valid.
+     *
+     * When several image files are sampled they are processed in parallel,
+     * with the number of threads from setNumThreads or the
+     * RSGISLIB_NUM_THREADS environment variable. All the GDAL calls (opening,
+     * reading and closing the images) are made under one lock, as GDAL and
+     * some drivers are not thread safe, so only the locating and sorting of
+     * the points and the copying of the values run in parallel.
+     */
+    class DllExport RSGISImagePointSampler
+    {
+    public:
+        RSGISImagePointSampler();
+        /**
+         * The number of images to sample at once (0 uses the number of cores).
+         */
+        void setNumThreads(unsigned int numThreads);
+        /**
+         * Sample the bands (numbered from 1) of the image at the points, which
+         * are in the coordinate system of the image. vals is resized to
+         * xCoords.size() * bands.size() and validPts (if not NULL) is set to 1
+         * for the points within the image and 0 otherwise.
+         */
+        void samplePoints(GDALDataset *image, std::vector<unsigned int> bands, const std::vector<double> &xCoords, const std::vector<double> &yCoords, std::vector<float> *vals, std::vector<unsigned char> *validPts=NULL, float outVal=0);
+        /**
+         * Sample a list of image files (with the bands to be sampled in each),
+         * with a column for each band of each image in the order provided.
+         * A point is only valid if it is within all the images.
+         */
+        void samplePoints(std::vector<std::pair<std::string, std::vector<unsigned int> > > imageFiles, const std::vector<double> &xCoords, const std::vector<double> &yCoords, std::vector<float> *vals, std::vector<unsigned char> *validPts=NULL, float outVal=0);
+        /**
+         * Read the coordinates of all the features of a layer in one pass;
+         * points are used directly and other geometries are represented by the
+         * centre of their envelope. Features without a geometry are skipped.
+         */
+        static void readLayerPoints(OGRLayer *layer, std::vector<double> *xCoords, std::vector<double> *yCoords, std::vector<long> *fids);
+        ~RSGISImagePointSampler();
+    protected:
+        /** samplePoints with the GDAL calls made while holding ioMutex (if not NULL). */
+        void samplePoints(GDALDataset *image, std::vector<unsigned int> bands, const std::vector<double> &xCoords, const std::vector<double> &yCoords, std::vector<float> *vals, std::vector<unsigned char> *validPts, float outVal, std::mutex *ioMutex);
+        unsigned int numThreads;
+    };
+
+}}
+
+#endif
@@ -0,0 +1,153 @@
+/*
+ *  RSGISImageReadPlanner.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISImageReadPlanner.h"
+
+namespace rsgis{namespace img{
+
+    RSGISImageReadPlanner::RSGISImageReadPlanner(GDALRasterBand **inputRasterBands, int **bandOffsets, int numInBands, int width, int height, int yBlockSize)
+    {
+        this->init(inputRasterBands, bandOffsets, numInBands, width, height, yBlockSize);
+    }
+    
+    RSGISImageReadPlanner::RSGISImageReadPlanner(GDALDataset *dataset, int xOff, int yOff, int width, int height, int yBlockSize)
+    {
+        int numBands = dataset->GetRasterCount();
+        std::vector<GDALRasterBand*> bands(numBands);
+        for(int n = 0; n < numBands; n++)
+        {
+            bands[n] = dataset->GetRasterBand(n+1);
+        }
+        int offset[2] = {xOff, yOff};
+        std::vector<int*> bandOffsets(numBands, offset);
+        this->init(bands.data(), bandOffsets.data(), numBands, width, height, yBlockSize);
+    }
+    
+    void RSGISImageReadPlanner::init(GDALRasterBand **inputRasterBands, int **bandOffsets, int numInBands, int width, int height, int yBlockSize)
+    {
+        this->width = width;
+        this->height = height;
+        this->yBlockSize = std::max(yBlockSize, 1);
+        this->nBlocks = (height + this->yBlockSize - 1) / this->yBlockSize;
+        this->readAheadBlocks = 0;
+        this->advisedEnd = 0;
+        
+        size_t readAheadBytes = defaultReadAheadBytes;
+        if(const char* env_p = std::getenv("RSGISLIB_READ_AHEAD_MB"))
+        {
+            readAheadBytes = ((size_t)std::max(atoi(env_p), 0)) * 1024 * 1024;
+        }
+        bool adviseLocal = false;
+        if(const char* env_p = std::getenv("RSGISLIB_READ_AHEAD_LOCAL"))
+        {
+            adviseLocal = (atoi(env_p) > 0);
+        }
+        
+        // The bands of each dataset with the same window are advised together.
+        size_t nativeBytesPerRow = 0;
+        for(int n = 0; n < numInBands; n++)
+        {
+            GDALDataset *dataset = inputRasterBands[n]->GetDataset();
+            if((dataset == NULL) || !(adviseLocal || isRemote(dataset)))
+            {
+                continue;
+            }
+            nativeBytesPerRow += ((size_t)width) * (GDALGetDataTypeSize(inputRasterBands[n]->GetRasterDataType()) / 8);
+            std::vector<DatasetRead>::iterator iterRead = this->dsReads.begin();
+            for(; iterRead != this->dsReads.end(); ++iterRead)
+            {
+                if((iterRead->dataset == dataset) && (iterRead->xOff == bandOffsets[n][0]) && (iterRead->yOff == bandOffsets[n][1]))
+                {
+                    break;
+                }
+            }
+            if(iterRead == this->dsReads.end())
+            {
+                DatasetRead dsRead;
+                dsRead.dataset = dataset;
+                dsRead.xOff = bandOffsets[n][0];
+                dsRead.yOff = bandOffsets[n][1];
+                this->dsReads.push_back(dsRead);
+                iterRead = this->dsReads.end() - 1;
+            }
+            iterRead->bandMap.push_back(inputRasterBands[n]->GetBand());
+        }
+        
+        if(nativeBytesPerRow > 0)
+        {
+            this->readAheadBlocks = readAheadBytes / (nativeBytesPerRow * this->yBlockSize);
+        }
+        if(this->readAheadBlocks == 0)
+        {
+            this->dsReads.clear();
+        }
+    }
+    
+    void RSGISImageReadPlanner::prefetch(unsigned int block)
+    {
+        if(this->dsReads.empty() || (block >= this->nBlocks))
+        {
+            return;
+        }
+        // Blocks are advised in batches, once half the read-ahead has been
+        // read, so each request covers several blocks.
+        unsigned int halfAhead = std::max<unsigned int>(this->readAheadBlocks / 2, 1);
+        if((block < this->advisedEnd) && ((this->advisedEnd - block) >= halfAhead))
+        {
+            return;
+        }
+        unsigned int startBlock = std::max(block, this->advisedEnd);
+        unsigned int endBlock = std::min(block + this->readAheadBlocks, this->nBlocks);
+        if(endBlock <= startBlock)
+        {
+            return;
+        }
+        int rowStart = startBlock * this->yBlockSize;
+        int numRows = std::min((int)(endBlock * this->yBlockSize), this->height) - rowStart;
+        for(std::vector<DatasetRead>::iterator iterRead = this->dsReads.begin(); iterRead != this->dsReads.end(); ++iterRead)
+        {
+            // Advice is only a hint so any error is ignored.
+            CPLPushErrorHandler(CPLQuietErrorHandler);
+            iterRead->dataset->AdviseRead(iterRead->xOff, iterRead->yOff + rowStart, this->width, numRows, this->width, numRows, GDT_Unknown, iterRead->bandMap.size(), iterRead->bandMap.data(), NULL);
+            CPLPopErrorHandler();
+        }
+        this->advisedEnd = endBlock;
+    }
+    
+    bool RSGISImageReadPlanner::isRemote(GDALDataset *dataset)
+    {
+        std::string fileName = dataset->GetDescription();
+        if((fileName.compare(0, 7, "http://") == 0) || (fileName.compare(0, 8, "https://") == 0))
+        {
+            return true;
+        }
+        const char *remoteFS[] = {"/vsicurl", "/vsis3", "/vsigs", "/vsiaz", "/vsiadls", "/vsioss", "/vsiswift", "/vsiwebhdfs"};
+        for(size_t i = 0; i < (sizeof(remoteFS) / sizeof(remoteFS[0])); ++i)
+        {
+            if(fileName.find(remoteFS[i]) != std::string::npos)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+}}
@@ -0,0 +1,102 @@
+/*
+ *  RSGISImageReadPlanner.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISImageReadPlanner_H
+#define RSGISImageReadPlanner_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+
+#include "gdal_priv.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_img_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace img{
+
+    /**
+     * Plans the reads of the blocks of rows processed by an engine so inputs
+     * on remote storage (e.g., /vsis3/ or /vsicurl/ COGs) are fetched ahead
+     * in a few large requests rather than many small ones. Before block N is
+     * read, prefetch(N) advises GDAL (GDALDataset::AdviseRead) of the window
+     * covering the blocks not yet advised within the read-ahead, once per
+     * dataset for all of its bands, which drivers such as GTiff turn into
+     * coalesced, parallel range requests.
+     *
+     * The read-ahead is bounded by a budget (in bytes of the native data of
+     * all the bands) read from the RSGISLIB_READ_AHEAD_MB environment
+     * variable (default 64 MB). Local files are only advised if
+     * RSGISLIB_READ_AHEAD_LOCAL is >0. prefetch must be called from the
+     * thread (or with the lock) used to read the datasets.
+     */
+    class DllExport RSGISImageReadPlanner
+    {
+    public:
+        /**
+         * bandOffsets are the (x, y) offsets of the window of each band,
+         * which is width pixels wide, and blocks are yBlockSize rows of the
+         * height rows.
+         */
+        RSGISImageReadPlanner(GDALRasterBand **inputRasterBands, int **bandOffsets, int numInBands, int width, int height, int yBlockSize);
+        /// Plan the reads of all the bands of a dataset within the window (xOff, yOff, width, height)
+        RSGISImageReadPlanner(GDALDataset *dataset, int xOff, int yOff, int width, int height, int yBlockSize);
+        /// True if any of the inputs will be read ahead
+        bool isActive(){return !this->dsReads.empty();};
+        /// Advise the reads of the blocks from block onwards within the read-ahead
+        void prefetch(unsigned int block);
+        /// Whether a dataset is read through a network file system of GDAL
+        static bool isRemote(GDALDataset *dataset);
+        static const size_t defaultReadAheadBytes = 64 * 1024 * 1024;
+        ~RSGISImageReadPlanner(){};
+    protected:
+        void init(GDALRasterBand **inputRasterBands, int **bandOffsets, int numInBands, int width, int height, int yBlockSize);
+        struct DatasetRead
+        {
+            GDALDataset *dataset;
+            std::vector<int> bandMap;
+            int xOff;
+            int yOff;
+        };
+        std::vector<DatasetRead> dsReads;
+        int width;
+        int height;
+        int yBlockSize;
+        unsigned int nBlocks;
+        unsigned int readAheadBlocks;
+        unsigned int advisedEnd;
+    };
+
+}}
+
+#endif
@@ -0,0 +1,152 @@
+/*
+ *  RSGISImageRowRingBuffer.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2008 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISImageRowRingBuffer.h"
+
+#include <atomic>
+
+namespace rsgis{namespace img{
+
+    static std::atomic<unsigned long long> nextRingBufferID(1);
+
+    void RSGISImageWindowView::copyTo(float ***dataBlock) const
+    {
+        for(int b = 0; b < numBands; ++b)
+        {
+            for(int y = 0; y < winSize; ++y)
+            {
+                const float *row = rows[(b*winSize)+y] + xOff;
+                for(int x = 0; x < winSize; ++x)
+                {
+                    dataBlock[b][y][x] = row[x];
+                }
+            }
+        }
+    }
+
+
+    RSGISImageRowRingBuffer::RSGISImageRowRingBuffer(GDALRasterBand **inputRasterBands, int **bandOffsets, int numBands, int width, int height, int winSize)
+    {
+        if((winSize % 2 == 0) | (winSize < 3))
+        {
+            throw RSGISImageCalcException("Window size needs to be 3 or greater and an odd number.");
+        }
+        this->inputRasterBands = inputRasterBands;
+        this->bandOffsets = bandOffsets;
+        this->numBands = numBands;
+        this->width = width;
+        this->height = height;
+        this->winSize = winSize;
+        this->winMid = (winSize-1)/2;
+        this->paddedWidth = width + (2*winMid);
+        this->currentLine = -1;
+        this->lastRowRead = -1;
+
+        unsigned int numRows = numBands * winSize;
+        rowBuffers = new float*[numRows];
+        viewRows = new const float*[numRows];
+        for(unsigned int i = 0; i < numRows; ++i)
+        {
+            rowBuffers[i] = (float *) CPLMalloc(sizeof(float)*paddedWidth);
+            for(int k = 0; k < paddedWidth; ++k)
+            {
+                rowBuffers[i][k] = 0;
+            }
+            viewRows[i] = rowBuffers[i];
+        }
+
+        view.rows = viewRows;
+        view.numBands = numBands;
+        view.winSize = winSize;
+        view.xOff = 0;
+        view.line = -1;
+        view.bufferID = nextRingBufferID++;
+    }
+
+    void RSGISImageRowRingBuffer::readRow(int row)
+    {
+        int slot = row % winSize;
+        for(int n = 0; n < numBands; ++n)
+        {
+            float *dst = rowBuffers[(n*winSize)+slot] + winMid;
+            if(row < height)
+            {
+                inputRasterBands[n]->RasterIO(GF_Read, bandOffsets[n][0], bandOffsets[n][1]+row, width, 1, dst, width, 1, GDT_Float32, 0, 0);
+            }
+            else
+            {
+                for(int k = 0; k < width; ++k)
+                {
+                    dst[k] = 0;
+                }
+            }
+        }
+        lastRowRead = row;
+    }
+
+    void RSGISImageRowRingBuffer::moveToLine(int line)
+    {
+        if(line < currentLine)
+        {
+            throw RSGISImageCalcException("Ring buffer lines must be visited in increasing order.");
+        }
+        if(line == currentLine)
+        {
+            return;
+        }
+
+        int firstRow = line - winMid;
+        if(firstRow <= lastRowRead)
+        {
+            firstRow = lastRowRead + 1;
+        }
+        // Rows before the top of the image are never read so their slots keep
+        // the zeros they were initialised with until they are reused.
+        for(int row = firstRow; row <= (line + winMid); ++row)
+        {
+            this->readRow(row);
+        }
+
+        for(int y = 0; y < winSize; ++y)
+        {
+            int row = line - winMid + y;
+            int slot = ((row % winSize) + winSize) % winSize;
+            for(int n = 0; n < numBands; ++n)
+            {
+                viewRows[(n*winSize)+y] = rowBuffers[(n*winSize)+slot];
+            }
+        }
+        currentLine = line;
+        view.line = line;
+    }
+
+    RSGISImageRowRingBuffer::~RSGISImageRowRingBuffer()
+    {
+        for(int i = 0; i < (numBands * winSize); ++i)
+        {
+            CPLFree(rowBuffers[i]);
+        }
+        delete[] rowBuffers;
+        delete[] viewRows;
+    }
+
+}}
+
@@ -0,0 +1,123 @@
+/*
+ *  RSGISImageRowRingBuffer.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2008 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISImageRowRingBuffer_H
+#define RSGISImageRowRingBuffer_H
+
+#include <iostream>
+#include <string>
+
+#include "gdal_priv.h"
+
+#include "img/RSGISImageCalcException.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_img_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace img{
+
+    /**
+     * A read-only view of a winSize x winSize neighbourhood for each band. The
+     * view references rows held by an RSGISImageRowRingBuffer so no pixel data
+     * is copied when the window is moved. Pixels outside the image are 0.
+     */
+    class DllExport RSGISImageWindowView
+    {
+    public:
+        RSGISImageWindowView():rows(NULL), numBands(0), winSize(0), xOff(0), line(-1), bufferID(0){};
+        inline float get(int band, int y, int x) const {return rows[(band*winSize)+y][xOff+x];};
+        inline const float* getRow(int band, int y) const {return rows[(band*winSize)+y]+xOff;};
+        inline int getNumBands() const {return numBands;};
+        inline int getWinSize() const {return winSize;};
+        /** The image row of the window centre. */
+        inline int getLine() const {return line;};
+        /**
+         * Identifies the ring buffer of the view (unique within the process), so
+         * with getLine the caller can tell whether the window has moved down a
+         * single row of the same image since the view it was last given.
+         */
+        inline unsigned long long getBufferID() const {return bufferID;};
+        /**
+         * Copy the window into the dataBlock[band][y][x] layout used by
+         * RSGISCalcImageValue::calcImageValue(float ***dataBlock, ...).
+         */
+        void copyTo(float ***dataBlock) const;
+        ~RSGISImageWindowView(){};
+    protected:
+        friend class RSGISImageRowRingBuffer;
+        const float * const *rows;
+        int numBands;
+        int winSize;
+        int xOff;
+        int line;
+        unsigned long long bufferID;
+    };
+
+    /**
+     * Holds the winSize rows of each input band required for a sliding window
+     * over an image. Rows are padded with winSize/2 zeros on either side and
+     * stored within a ring so each image row is only read from GDAL once.
+     */
+    class DllExport RSGISImageRowRingBuffer
+    {
+    public:
+        RSGISImageRowRingBuffer(GDALRasterBand **inputRasterBands, int **bandOffsets, int numBands, int width, int height, int winSize);
+        /**
+         * Move the window centre to image row line, reading any rows not
+         * already within the buffer. Lines must be visited in increasing order.
+         */
+        void moveToLine(int line);
+        /**
+         * Returns the view of the window centred on column x of the current line.
+         */
+        inline const RSGISImageWindowView& getView(int x){ view.xOff = x; return view; };
+        ~RSGISImageRowRingBuffer();
+    protected:
+        void readRow(int row);
+        GDALRasterBand **inputRasterBands;
+        int **bandOffsets;
+        int numBands;
+        int width;
+        int height;
+        int winSize;
+        int winMid;
+        int paddedWidth;
+        int currentLine;
+        int lastRowRead;
+        float **rowBuffers;
+        const float **viewRows;
+        RSGISImageWindowView view;
+    };
+
+}}
+
+#endif
+
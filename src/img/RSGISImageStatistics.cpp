@@ -31,6 +31,30 @@ namespace rsgis{namespace img{
 	
 	void RSGISImageStatistics::calcImageStatistics(GDALDataset **datasets, int numDS, ImageStats **stats, int numInputBands, bool stddev, bool useNoData, float noDataVal, bool onePassSD)
 	{
+        if((numDS == 1) && (numInputBands == datasets[0]->GetRasterCount()))
+        {
+            // A single image is summarised in one (multi-threaded) pass, with
+            // the standard deviation from a stable running variance.
+            RSGISSinglePassImageStats passStats;
+            try
+            {
+                passStats.calcStats(datasets[0], useNoData, noDataVal);
+            }
+            catch(RSGISImageException &e)
+            {
+                throw RSGISImageCalcException(e.what());
+            }
+            for(int i = 0; i < numInputBands; ++i)
+            {
+                stats[i]->mean = passStats.getMean(i);
+                stats[i]->min = passStats.getMin(i);
+                stats[i]->max = passStats.getMax(i);
+                stats[i]->sum = passStats.getSum(i);
+                stats[i]->stddev = stddev?passStats.getStdDev(i):0;
+            }
+            return;
+        }
+        
 		RSGISCalcImageStatistics *calcImageStats = NULL;
 		RSGISCalcImage *calcImg = NULL;
 		try
@@ -345,63 +369,29 @@ namespace rsgis{namespace img{
     
     void RSGISImageStatistics::calcImageBandStatistics(GDALDataset *dataset, int imgBand, ImageStats *stats, bool stddev, bool useNoData, float noDataVal, bool onePassSD)
     {
-        try
+        int numBands = dataset->GetRasterCount();
+        
+        if((imgBand < 1) | (imgBand > numBands))
         {
-            int numBands = dataset->GetRasterCount();
-            
-            if((imgBand < 1) | (imgBand > numBands))
-            {
-                throw RSGISImageBandException("The specified image band is not within the image.");
-            }
-            
-            RSGISCalcImageStatisticsNoData calcImageStats = RSGISCalcImageStatisticsNoData(numBands, false, NULL, useNoData, noDataVal, onePassSD);
-            RSGISCalcImage calcImg = RSGISCalcImage(&calcImageStats, "", true);
-            
-            if(stddev && onePassSD)
-            {
-                calcImageStats.calcStdDev();
-            }
-            
-            calcImg.calcImage(&dataset, 1);
-            
-            if(stddev && !onePassSD)
-            {
-                calcImageStats.calcStdDev();
-                calcImg.calcImage(&dataset, 1);
-            }
-            
-            ImageStats **bandStats = new ImageStats*[numBands];
-            for(int i = 0; i < numBands; ++i)
-            {
-                bandStats[i] = new ImageStats();
-                bandStats[i]->mean = 0;
-                bandStats[i]->max = 0;
-                bandStats[i]->min = 0;
-                bandStats[i]->stddev = 0;
-                bandStats[i]->sum = 0;
-            }
-            calcImageStats.getImageStats(bandStats, numBands);
-            
-            stats->mean = bandStats[imgBand-1]->mean;
-            stats->max = bandStats[imgBand-1]->max;
-            stats->min = bandStats[imgBand-1]->min;
-            stats->stddev = bandStats[imgBand-1]->stddev;
-            stats->sum = bandStats[imgBand-1]->sum;
-            
-            for(int i = 0; i < numBands; ++i)
-            {
-                delete bandStats[i];
-            }
-            delete[] bandStats;
+            throw RSGISImageBandException("The specified image band is not within the image.");
         }
-        catch(RSGISImageCalcException &e)
+        
+        // Only the band of interest is read, in a single pass.
+        RSGISSinglePassImageStats passStats;
+        try
         {
-            throw e;
+            passStats.calcStats(dataset, useNoData, noDataVal, std::vector<unsigned int>(1, imgBand));
         }
-        catch(RSGISImageBandException &e)
+        catch(RSGISImageException &e)
         {
-            throw e;
+            throw RSGISImageCalcException(e.what());
         }
+        
+        stats->mean = passStats.getMean(0);
+        stats->max = passStats.getMax(0);
+        stats->min = passStats.getMin(0);
+        stats->stddev = stddev?passStats.getStdDev(0):0;
+        stats->sum = passStats.getSum(0);
     }
     
     
@@ -582,6 +572,53 @@ namespace rsgis{namespace img{
 	{
 		calcSD = true;
 	}
+    
+    void RSGISCalcImageStatistics::writeCheckpointState(std::ostream &stateStream)
+    {
+        stateStream.write((const char *) &numInputBands, sizeof(int));
+        stateStream.write((const char *) &calcSD, sizeof(bool));
+        stateStream.write((const char *) &calcMean, sizeof(bool));
+        stateStream.write((const char *) &diffZ, sizeof(double));
+        stateStream.write((const char *) firstMean, sizeof(bool)*numInputBands);
+        stateStream.write((const char *) firstSD, sizeof(bool)*numInputBands);
+        stateStream.write((const char *) n, sizeof(unsigned long)*numInputBands);
+        stateStream.write((const char *) mean, sizeof(double)*numInputBands);
+        stateStream.write((const char *) meanSum, sizeof(double)*numInputBands);
+        stateStream.write((const char *) sumSq, sizeof(double)*numInputBands);
+        stateStream.write((const char *) min, sizeof(double)*numInputBands);
+        stateStream.write((const char *) max, sizeof(double)*numInputBands);
+        stateStream.write((const char *) sumDiffZ, sizeof(double)*numInputBands);
+    }
+    
+    std::string RSGISCalcImageStatistics::getParameterHash()
+    {
+        std::stringstream params;
+        params.precision(9);
+        params << numInputBands << " " << calcSD << " " << onePassSD << " " << useNoData << " " << noDataVal << " " << (func != NULL);
+        return params.str();
+    }
+    
+    void RSGISCalcImageStatistics::readCheckpointState(std::istream &stateStream)
+    {
+        int stateNumBands = 0;
+        stateStream.read((char *) &stateNumBands, sizeof(int));
+        if(stateNumBands != numInputBands)
+        {
+            throw RSGISImageCalcException("The checkpointed statistics are not for the same number of bands.");
+        }
+        stateStream.read((char *) &calcSD, sizeof(bool));
+        stateStream.read((char *) &calcMean, sizeof(bool));
+        stateStream.read((char *) &diffZ, sizeof(double));
+        stateStream.read((char *) firstMean, sizeof(bool)*numInputBands);
+        stateStream.read((char *) firstSD, sizeof(bool)*numInputBands);
+        stateStream.read((char *) n, sizeof(unsigned long)*numInputBands);
+        stateStream.read((char *) mean, sizeof(double)*numInputBands);
+        stateStream.read((char *) meanSum, sizeof(double)*numInputBands);
+        stateStream.read((char *) sumSq, sizeof(double)*numInputBands);
+        stateStream.read((char *) min, sizeof(double)*numInputBands);
+        stateStream.read((char *) max, sizeof(double)*numInputBands);
+        stateStream.read((char *) sumDiffZ, sizeof(double)*numInputBands);
+    }
 	
 	RSGISCalcImageStatistics::~RSGISCalcImageStatistics()
 	{
@@ -981,11 +1018,9 @@ namespace rsgis{namespace img{
         double percentileVal = 0.0;
         try
         {
-            RSGISImageUtils imageUtils;
-            std::vector<double> *dataVals = imageUtils.getImageBandValues(dataset, band, noDataDefined, noDataVal);
-            std::sort(dataVals->begin(), dataVals->end());            
-            percentileVal = gsl_stats_quantile_from_sorted_data(&(*dataVals)[0], 1, dataVals->size(), percentile);
-            delete dataVals;
+            std::vector<float> percentiles;
+            percentiles.push_back(percentile);
+            percentileVal = this->streamPercentiles.getPercentiles(dataset, band, percentiles, noDataVal, noDataDefined).at(0);
         }
         catch (rsgis::RSGISImageException &e)
         {
@@ -1073,6 +1108,29 @@ namespace rsgis{namespace img{
         return percentileVal;
     }
     
+    std::vector<double> RSGISImagePercentiles::getPercentiles(GDALDataset *dataset, unsigned int band, std::vector<float> percentiles, float noDataVal, bool noDataDefined)
+    {
+        std::vector<double> percentileVals;
+        try
+        {
+            percentileVals = this->streamPercentiles.getPercentiles(dataset, band, percentiles, noDataVal, noDataDefined);
+        }
+        catch (rsgis::RSGISImageException &e)
+        {
+            throw e;
+        }
+        catch (rsgis::RSGISException &e)
+        {
+            throw rsgis::RSGISImageException(e.what());
+        }
+        catch (std::exception &e)
+        {
+            throw rsgis::RSGISImageException(e.what());
+        }
+        
+        return percentileVals;
+    }
+    
     RSGISImagePercentiles::~RSGISImagePercentiles()
     {
         
@@ -1539,6 +1597,174 @@ namespace rsgis{namespace img{
         
     }
 
+    void RSGISCalcMultiImageStatSummaries::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        if(numBands != totNumInBands)
+        {
+            throw RSGISImageCalcException("Number of input image bands does not match the number expected.");
+        }
+        
+        if((sumType == rsgis::math::sumtype_median) || (sumType == rsgis::math::sumtype_mode))
+        {
+            // The values of each pixel are gathered into a column, a chunk of pixels at a time.
+            const size_t chunkPxls = 4096;
+            this->pxlCounts.resize(chunkPxls);
+            this->pxlColumns.resize(chunkPxls * this->numInImgs);
+            for(unsigned int i = 0; i < this->numInImgBands; ++i)
+            {
+                for(size_t chunkStart = 0; chunkStart < nPxls; chunkStart += chunkPxls)
+                {
+                    size_t nChunk = std::min(chunkPxls, nPxls - chunkStart);
+                    std::fill(this->pxlCounts.begin(), this->pxlCounts.begin() + nChunk, 0);
+                    for(unsigned int n = 0; n < this->numInImgs; ++n)
+                    {
+                        const float *plane = bandPlanes[(n * this->numInImgBands) + i] + chunkStart;
+                        for(size_t p = 0; p < nChunk; ++p)
+                        {
+                            if((!this->useNoDataValue) || (plane[p] != this->noDataValue))
+                            {
+                                this->pxlColumns[(p * this->numInImgs) + this->pxlCounts[p]++] = plane[p];
+                            }
+                        }
+                    }
+                    
+                    double *outVals = outPlanes[i] + chunkStart;
+                    for(size_t p = 0; p < nChunk; ++p)
+                    {
+                        float *column = &this->pxlColumns[p * this->numInImgs];
+                        unsigned int count = this->pxlCounts[p];
+                        if(count == 0)
+                        {
+                            outVals[p] = 0.0;
+                        }
+                        else if(count == 1)
+                        {
+                            outVals[p] = column[0];
+                        }
+                        else if(sumType == rsgis::math::sumtype_median)
+                        {
+                            outVals[p] = RSGISCalcMultiImageStatSummaries::calcMedian(column, count);
+                        }
+                        else
+                        {
+                            // The mode of the values rounded down, the lowest if there is a tie.
+                            std::sort(column, column + count);
+                            double modeVal = floor(column[0]);
+                            unsigned int modeCount = 0;
+                            unsigned int runStart = 0;
+                            for(unsigned int k = 1; k <= count; ++k)
+                            {
+                                if((k == count) || (floor(column[k]) != floor(column[runStart])))
+                                {
+                                    if((k - runStart) > modeCount)
+                                    {
+                                        modeCount = k - runStart;
+                                        modeVal = floor(column[runStart]);
+                                    }
+                                    runStart = k;
+                                }
+                            }
+                            outVals[p] = modeVal;
+                        }
+                    }
+                }
+            }
+            return;
+        }
+        
+        // Running reductions over the images; pxlAccumA holds the mean, sum or
+        // minimum and pxlAccumB the sum of squared differences from the mean or the maximum.
+        this->pxlCounts.resize(nPxls);
+        this->pxlAccumA.resize(nPxls);
+        this->pxlAccumB.resize(nPxls);
+        for(unsigned int i = 0; i < this->numInImgBands; ++i)
+        {
+            std::fill(this->pxlCounts.begin(), this->pxlCounts.begin() + nPxls, 0);
+            std::fill(this->pxlAccumA.begin(), this->pxlAccumA.begin() + nPxls, 0.0);
+            std::fill(this->pxlAccumB.begin(), this->pxlAccumB.begin() + nPxls, 0.0);
+            unsigned int *counts = this->pxlCounts.data();
+            double *accumA = this->pxlAccumA.data();
+            double *accumB = this->pxlAccumB.data();
+            for(unsigned int n = 0; n < this->numInImgs; ++n)
+            {
+                const float *plane = bandPlanes[(n * this->numInImgBands) + i];
+                for(size_t p = 0; p < nPxls; ++p)
+                {
+                    double val = plane[p];
+                    if(this->useNoDataValue && (plane[p] == this->noDataValue))
+                    {
+                        continue;
+                    }
+                    unsigned int count = ++counts[p];
+                    if((sumType == rsgis::math::sumtype_mean) || (sumType == rsgis::math::sumtype_stddev))
+                    {
+                        double delta = val - accumA[p];
+                        accumA[p] += delta / count;
+                        accumB[p] += delta * (val - accumA[p]);
+                    }
+                    else if(sumType == rsgis::math::sumtype_sum)
+                    {
+                        accumA[p] += val;
+                    }
+                    else if(count == 1)
+                    {
+                        accumA[p] = val;
+                        accumB[p] = val;
+                    }
+                    else
+                    {
+                        accumA[p] = std::min(accumA[p], val);
+                        accumB[p] = std::max(accumB[p], val);
+                    }
+                }
+            }
+            
+            double *outVals = outPlanes[i];
+            for(size_t p = 0; p < nPxls; ++p)
+            {
+                if(counts[p] < 2)
+                {
+                    // Either no values (0) or the single value.
+                    outVals[p] = accumA[p];
+                }
+                else if(sumType == rsgis::math::sumtype_stddev)
+                {
+                    outVals[p] = sqrt(accumB[p] / (counts[p] - 1));
+                }
+                else if(sumType == rsgis::math::sumtype_max)
+                {
+                    outVals[p] = accumB[p];
+                }
+                else if(sumType == rsgis::math::sumtype_range)
+                {
+                    outVals[p] = accumB[p] - accumA[p];
+                }
+                else
+                {
+                    outVals[p] = accumA[p];
+                }
+            }
+        }
+    }
+    
+    RSGISCalcImageValue* RSGISCalcMultiImageStatSummaries::getThreadClone()
+    {
+        return new RSGISCalcMultiImageStatSummaries(this->numOutBands, this->sumType, this->numInImgs, this->numInImgBands, this->noDataValue, this->useNoDataValue);
+    }
+    
+    double RSGISCalcMultiImageStatSummaries::calcMedian(float *vals, size_t n)
+    {
+        size_t mid = n / 2;
+        std::nth_element(vals, vals + mid, vals + n);
+        double median = vals[mid];
+        if((n % 2) == 0)
+        {
+            // The lower middle value is the largest of those before mid.
+            median = (median + ((double)*std::max_element(vals, vals + mid))) / 2.0;
+        }
+        return median;
+    }
+    
     RSGISCalcMultiImageStatSummaries::~RSGISCalcMultiImageStatSummaries()
     {
         delete this->mathUtils;
@@ -1683,6 +1909,71 @@ namespace rsgis{namespace img{
         }
     }
     
+    void RSGISCalcImgStackIdxForStat::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        double *outVals = outPlanes[0];
+        std::fill(outVals, outVals + nPxls, 0.0); // Zero is output no data value.
+        if((this->sumStat == rsgis::math::sumtype_min) || (this->sumStat == rsgis::math::sumtype_max))
+        {
+            // The output holds the index of the best value so far, kept in pxlBest; the first is kept on a tie.
+            bool useMin = (this->sumStat == rsgis::math::sumtype_min);
+            this->pxlBest.resize(nPxls);
+            float *best = this->pxlBest.data();
+            for(int n = 0; n < numBands; ++n)
+            {
+                const float *plane = bandPlanes[n];
+                for(size_t p = 0; p < nPxls; ++p)
+                {
+                    if(plane[p] != this->noDataVal)
+                    {
+                        if((outVals[p] == 0.0) || (useMin && (plane[p] < best[p])) || ((!useMin) && (plane[p] > best[p])))
+                        {
+                            best[p] = plane[p];
+                            outVals[p] = n+1; // Note, array indexes start at 0 while output indexes start as 1.
+                        }
+                    }
+                }
+            }
+        }
+        else if(this->sumStat == rsgis::math::sumtype_median)
+        {
+            this->pxlColumn.resize(numBands);
+            for(size_t p = 0; p < nPxls; ++p)
+            {
+                size_t count = 0;
+                for(int n = 0; n < numBands; ++n)
+                {
+                    if(bandPlanes[n][p] != this->noDataVal)
+                    {
+                        this->pxlColumn[count++] = bandPlanes[n][p];
+                    }
+                }
+                if(count == 0)
+                {
+                    continue;
+                }
+                double median = RSGISCalcMultiImageStatSummaries::calcMedian(this->pxlColumn.data(), count);
+                for(int n = 0; n < numBands; ++n)
+                {
+                    if((bandPlanes[n][p] != this->noDataVal) && (bandPlanes[n][p] == median))
+                    {
+                        outVals[p] = n+1; // Note, array indexes start at 0 while output indexes start as 1.
+                        break;
+                    }
+                }
+            }
+        }
+        else
+        {
+            throw RSGISImageCalcException("The summary type specified is unknown; note only min, max and median are supported.");
+        }
+    }
+    
+    RSGISCalcImageValue* RSGISCalcImgStackIdxForStat::getThreadClone()
+    {
+        return new RSGISCalcImgStackIdxForStat(this->noDataVal, this->sumStat);
+    }
+    
     RSGISCalcImgStackIdxForStat::~RSGISCalcImgStackIdxForStat()
     {
         if(this->sumStat == rsgis::math::sumtype_median)
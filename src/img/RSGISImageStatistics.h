@@ -25,6 +25,9 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <sstream>
+#include <algorithm>
 #include <math.h>
 
 #include "gdal_priv.h"
@@ -35,6 +38,8 @@
 #include "img/RSGISCalcImageValue.h"
 #include "img/RSGISImageUtils.h"
 #include "img/RSGISCalcImage.h"
+#include "img/RSGISStreamingPercentiles.h"
+#include "img/RSGISSinglePassImageStats.h"
 
 #include "math/RSGISMathFunction.h"
 #include "math/RSGISMatrices.h"
@@ -98,6 +103,13 @@ namespace rsgis{namespace img{
         bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageCalcException("Not implemented");};
         void getImageStats(ImageStats** inStats, int numInputBands);
         void calcStdDev();
+        /**
+         * The accumulated sums, counts and ranges of each band can be checkpointed.
+         */
+        bool hasCheckpointState(){return true;};
+        void writeCheckpointState(std::ostream &stateStream);
+        void readCheckpointState(std::istream &stateStream);
+        std::string getParameterHash();
         ~RSGISCalcImageStatistics();
     protected:
         bool useNoData;
@@ -191,15 +203,35 @@ namespace rsgis{namespace img{
         
     };
     
+    /**
+     * The percentiles of whole image bands are found with RSGISStreamingPercentiles,
+     * so do not need memory for every pixel value. They are exact unless a
+     * maximum error is set with setMaxError. The versions with a mask gather
+     * the values within the mask and sort them.
+     */
     class DllExport RSGISImagePercentiles
     {
     public:
         RSGISImagePercentiles();
+        /**
+         * The number of threads used to count the blocks of a band (0 uses the number of cores).
+         */
+        void setNumThreads(unsigned int numThreads){streamPercentiles.setNumThreads(numThreads);};
+        /**
+         * The largest absolute error accepted in a percentile, 0 (the default) for exact values.
+         */
+        void setMaxError(double maxError){streamPercentiles.setMaxError(maxError);};
         rsgis::math::Matrix* getPercentilesForAllBands(GDALDataset* dataset, float percentile, float noDataVal, bool noDataDefined);
         double getPercentile(GDALDataset *dataset, unsigned int band, float percentile, float noDataVal, bool noDataDefined);
         double getPercentile(GDALDataset *dataset, unsigned int band, GDALDataset *maskDS, int maskVal, float percentile, float noDataVal, bool noDataDefined);
         double getPercentile(GDALDataset *dataset, unsigned int band, GDALDataset *maskDS, int maskVal, float percentile, float noDataVal, bool noDataDefined, geos::geom::Envelope *env, bool quiet=false);
+        /**
+         * Several percentiles of a band from the same passes through the image.
+         */
+        std::vector<double> getPercentiles(GDALDataset *dataset, unsigned int band, std::vector<float> percentiles, float noDataVal, bool noDataDefined);
         ~RSGISImagePercentiles();
+    protected:
+        RSGISStreamingPercentiles streamPercentiles;
     };
     
     
@@ -320,6 +352,15 @@ namespace rsgis{namespace img{
     
     
     
+    /**
+     * A per-pixel summary of each band across a stack of images (the input
+     * bands are the images in turn). Whole blocks are summarised a plane at a
+     * time: the mean, standard deviation, sum, minimum, maximum and range are
+     * running reductions over the images and the median and mode are taken
+     * from the values of each pixel gathered into a contiguous column (the
+     * median with nth_element). Pixels with fewer than two values are given
+     * the value (or 0 if there are none).
+     */
     class DllExport RSGISCalcMultiImageStatSummaries: public RSGISCalcImageValue
     {
     public:
@@ -334,6 +375,13 @@ namespace rsgis{namespace img{
         void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageCalcException("Not implemented");};
         void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output, geos::geom::Envelope extent) {throw RSGISImageCalcException("No implemented");};
         bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageCalcException("Not implemented");};
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        RSGISCalcImageValue* getThreadClone();
+        /**
+         * The median of the first n values (which are reordered), the mean of
+         * the two middle values if n is even.
+         */
+        static double calcMedian(float *vals, size_t n);
         ~RSGISCalcMultiImageStatSummaries();
     protected:
         rsgis::math::rsgissummarytype sumType;
@@ -345,6 +393,11 @@ namespace rsgis{namespace img{
         rsgis::math::RSGISMathsUtils *mathUtils;
         rsgis::math::RSGISStatsSummary *statsSumObj;
         std::vector<double> *data;
+        // Working space for calcImageBlock.
+        std::vector<unsigned int> pxlCounts;
+        std::vector<double> pxlAccumA;
+        std::vector<double> pxlAccumB;
+        std::vector<float> pxlColumns;
     };
     
     
@@ -366,6 +419,12 @@ namespace rsgis{namespace img{
     };
     
     
+    /**
+     * The index (from 1, 0 if all the values are no data) of the image in the
+     * stack with the minimum, maximum or median value of each pixel. Whole
+     * blocks are processed a plane at a time, the median being found from the
+     * values of each pixel gathered into a contiguous column.
+     */
     class DllExport RSGISCalcImgStackIdxForStat: public RSGISCalcImageValue
     {
     public:
@@ -380,6 +439,8 @@ namespace rsgis{namespace img{
         void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageCalcException("Not implemented");};
         void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output, geos::geom::Envelope extent) {throw RSGISImageCalcException("No implemented");};
         bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageCalcException("Not implemented");};
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        RSGISCalcImageValue* getThreadClone();
         ~RSGISCalcImgStackIdxForStat();
     protected:
         float noDataVal;
@@ -387,6 +448,9 @@ namespace rsgis{namespace img{
         rsgis::math::RSGISMathsUtils *mathUtils;
         rsgis::math::RSGISStatsSummary *statsSumObj;
         std::vector<double> *data;
+        // Working space for calcImageBlock.
+        std::vector<float> pxlBest;
+        std::vector<float> pxlColumn;
     };
     
     
@@ -21,6 +21,8 @@
  */
 
 #include "RSGISImageUtils.h"
+#include "img/RSGISImageBlockPipeline.h"
+#include "img/RSGISImageBlockPlanner.h"
 
 namespace rsgis{namespace img{
 
@@ -3334,6 +3336,7 @@ namespace rsgis{namespace img{
 			
 			// Create new file. 
             char **papszOptions = this->getGDALCreationOptionsForFormat(gdalFormat);
+			RSGISDatasetCache::invalidate(imageFile);
 			outputImage = poDriver->Create(imageFile.c_str(), xSize, ySize, numBands, imgDataType, papszOptions);
 			
 			if(outputImage == NULL)
@@ -3452,6 +3455,7 @@ namespace rsgis{namespace img{
 			
 			// Create new file.
 			char **papszOptions = this->getGDALCreationOptionsForFormat(gdalFormat);
+			RSGISDatasetCache::invalidate(imageFile);
 			outputImage = poDriver->Create(imageFile.c_str(), xSize, ySize, numBands, imgDataType, papszOptions);
 			
 			if(outputImage == NULL)
@@ -3583,6 +3587,7 @@ namespace rsgis{namespace img{
 			
 			// Create new file.
             char **papszOptions = this->getGDALCreationOptionsForFormat(gdalFormat);
+			RSGISDatasetCache::invalidate(imageFile);
 			outputImage = poDriver->Create(imageFile.c_str(), xSize, ySize, numBands, imgDataType, papszOptions);
 			
 			if(outputImage == NULL)
@@ -3690,6 +3695,7 @@ namespace rsgis{namespace img{
 				*outStrStream << outputFilebase << "_b" << i << ".tif";
 				outImageFile = outStrStream->str();
 				std::cout << "File: " << outImageFile << std::endl;
+				RSGISDatasetCache::invalidate(outImageFile);
 				outputImage = gdalDriver->Create(outImageFile.c_str(), xSize, ySize, 1, GDT_Float32, papszOptions);
 				
 				if(outputImage == NULL)
@@ -3774,6 +3780,7 @@ namespace rsgis{namespace img{
 				std::cout << "Converting image " << inputImages[i] << std::endl;
 				numOutBands = inDatasets[i]->GetRasterCount();
                 
+				RSGISDatasetCache::invalidate(outputImages[i]);
 				outputImageDS = gdalDriver->Create(outputImages[i].c_str(), stackWidth, stackHeight, numOutBands, GDT_Float32, papszOptions);
 				
 				outputImageDS->SetGeoTransform(gdalTranslation);
@@ -3880,6 +3887,7 @@ namespace rsgis{namespace img{
 			{
 				std::cout << "Converting image " << inputImages[i-1] << std::endl;
 				numOutBands = inDatasets[i]->GetRasterCount();
+				RSGISDatasetCache::invalidate(outputImages[i-1]);
 				outputImageDS = gdalDriver->Create(outputImages[i-1].c_str(), stackWidth, stackHeight, numOutBands, GDT_Float32, papszOptions);
 				outputImageDS->SetGeoTransform(gdalTranslation);
 				outputImageDS->SetProjection(inDatasets[0]->GetProjectionRef());
@@ -3979,6 +3987,7 @@ namespace rsgis{namespace img{
 			}
 			
 			std::cout << "Creating image " << outputImage << std::endl;
+			RSGISDatasetCache::invalidate(outputImage);
 			outDataset = gdalDriver->CreateCopy(outputImage.c_str(), inDataset, FALSE, NULL, NULL, NULL);
 			if(outDataset == NULL)
 			{
@@ -4192,6 +4201,7 @@ namespace rsgis{namespace img{
 			transformation[5] = -1;
 			
 			std::cout << "Creating image " << outputImage << std::endl;
+			RSGISDatasetCache::invalidate(outputImage);
 			outDataset = gdalDriver->Create(outputImage.c_str(), width, height, numOutBands, GDT_Float32, papszOptions);
 			
 			if(outDataset == NULL)
@@ -4293,6 +4303,7 @@ namespace rsgis{namespace img{
 			transformation[5] = yRes;
 			
 			std::cout << "Creating image " << outputImage << std::endl;
+			RSGISDatasetCache::invalidate(outputImage);
 			outDataset = gdalDriver->Create(outputImage.c_str(), width, height, numOutBands, GDT_Float32, papszOptions);
 			if(outDataset == NULL)
 			{
@@ -4400,6 +4411,7 @@ namespace rsgis{namespace img{
             for(int i = 0; i < dataset->GetRasterYSize(); ++i)
             {
                 std::string outputImage = outputImageBase + mathUtils.inttostring(i) + std::string(".env");
+				RSGISDatasetCache::invalidate(outputImage);
 				outDataset = gdalDriver->Create(outputImage.c_str(), width, height, 1, GDT_Float32, papszOptions);
                 if(outDataset == NULL)
                 {
@@ -4429,501 +4441,215 @@ namespace rsgis{namespace img{
     
     void RSGISImageUtils::copyFloatGDALDataset(GDALDataset *inData, GDALDataset *outData)
     {
-        try
-        {
-            // Change dimensions are the same.
-            if(inData->GetRasterXSize() != outData->GetRasterXSize())
-            {
-                throw RSGISImageException("Widths are not the same");
-            }
-            if(inData->GetRasterYSize() != outData->GetRasterYSize())
-            {
-                throw RSGISImageException("Heights are not the same");
-            }
-            if(inData->GetRasterCount() != outData->GetRasterCount())
-            {
-                throw RSGISImageException("Number of bands are not the same");
-            }
-            
-            unsigned long width = inData->GetRasterXSize();
-            unsigned long height = inData->GetRasterYSize();
-            unsigned int numBands = inData->GetRasterCount();
-            
-            GDALRasterBand **inputRasterBands = new GDALRasterBand*[numBands];
-            GDALRasterBand **outputRasterBands = new GDALRasterBand*[numBands];
-            float *data = new float[width];
-            
-            for(unsigned int n = 0; n < numBands; ++n)
-            {
-                inputRasterBands[n] = inData->GetRasterBand(n+1);
-                outputRasterBands[n] = outData->GetRasterBand(n+1);
-            }
-            
-            for(unsigned long y = 0; y < height; ++y)
-            {
-                for(unsigned int n = 0; n < numBands; ++n)
-                {
-                    inputRasterBands[n]->RasterIO(GF_Read, 0, y, width, 1, data, width, 1, GDT_Float32, 0, 0);
-                    outputRasterBands[n]->RasterIO(GF_Write, 0, y, width, 1, data, width, 1, GDT_Float32, 0, 0);
-                }
-            }
-                
-            delete[] inputRasterBands;
-            delete[] outputRasterBands;
-            delete[] data;
-        }
-        catch(RSGISImageException &e)
-        {
-            throw e;
-        }
+        this->copyGDALDataset(inData, outData, GDT_Float32);
     }
     
     void RSGISImageUtils::copyIntGDALDataset(GDALDataset *inData, GDALDataset *outData)
     {
-        try
-        {
-            // Change dimensions are the same.
-            if(inData->GetRasterXSize() != outData->GetRasterXSize())
-            {
-                throw RSGISImageException("Widths are not the same");
-            }
-            if(inData->GetRasterYSize() != outData->GetRasterYSize())
-            {
-                throw RSGISImageException("Heights are not the same");
-            }
-            if(inData->GetRasterCount() != outData->GetRasterCount())
-            {
-                throw RSGISImageException("Number of bands are not the same");
-            }
-            
-            unsigned long width = inData->GetRasterXSize();
-            unsigned long height = inData->GetRasterYSize();
-            unsigned int numBands = inData->GetRasterCount();
-            
-            GDALRasterBand **inputRasterBands = new GDALRasterBand*[numBands];
-            GDALRasterBand **outputRasterBands = new GDALRasterBand*[numBands];
-            int *data = new int[width];
-            
-            for(unsigned int n = 0; n < numBands; ++n)
-            {
-                inputRasterBands[n] = inData->GetRasterBand(n+1);
-                outputRasterBands[n] = outData->GetRasterBand(n+1);
-            }
-            
-            for(unsigned long y = 0; y < height; ++y)
-            {
-                for(unsigned int n = 0; n < numBands; ++n)
-                {
-                    inputRasterBands[n]->RasterIO(GF_Read, 0, y, width, 1, data, width, 1, GDT_Int32, 0, 0);
-                    outputRasterBands[n]->RasterIO(GF_Write, 0, y, width, 1, data, width, 1, GDT_Int32, 0, 0);
-                }
-            }
-            
-            delete[] inputRasterBands;
-            delete[] outputRasterBands;
-            delete[] data;
-        }
-        catch(RSGISImageException &e)
-        {
-            throw e;
-        }
+        this->copyGDALDataset(inData, outData, GDT_Int32);
     }
     
     void RSGISImageUtils::copyUIntGDALDataset(GDALDataset *inData, GDALDataset *outData)
     {
-        try
-        {
-            // Change dimensions are the same.
-            if(inData->GetRasterXSize() != outData->GetRasterXSize())
-            {
-                throw RSGISImageException("Widths are not the same");
-            }
-            if(inData->GetRasterYSize() != outData->GetRasterYSize())
-            {
-                throw RSGISImageException("Heights are not the same");
-            }
-            if(inData->GetRasterCount() != outData->GetRasterCount())
-            {
-                throw RSGISImageException("Number of bands are not the same");
-            }
-            
-            unsigned long width = inData->GetRasterXSize();
-            unsigned long height = inData->GetRasterYSize();
-            unsigned int numBands = inData->GetRasterCount();
-            
-            GDALRasterBand **inputRasterBands = new GDALRasterBand*[numBands];
-            GDALRasterBand **outputRasterBands = new GDALRasterBand*[numBands];
-            unsigned int *data = new unsigned int[width];
-            
-            for(unsigned int n = 0; n < numBands; ++n)
-            {
-                inputRasterBands[n] = inData->GetRasterBand(n+1);
-                outputRasterBands[n] = outData->GetRasterBand(n+1);
-            }
-            
-            for(unsigned long y = 0; y < height; ++y)
-            {
-                for(unsigned int n = 0; n < numBands; ++n)
-                {
-                    inputRasterBands[n]->RasterIO(GF_Read, 0, y, width, 1, data, width, 1, GDT_UInt32, 0, 0);
-                    outputRasterBands[n]->RasterIO(GF_Write, 0, y, width, 1, data, width, 1, GDT_UInt32, 0, 0);
-                }
-            }
-            
-            delete[] inputRasterBands;
-            delete[] outputRasterBands;
-            delete[] data;
-        }
-        catch(RSGISImageException &e)
-        {
-            throw e;
-        }
+        this->copyGDALDataset(inData, outData, GDT_UInt32);
     }
     
     void RSGISImageUtils::copyFloat32GDALDataset(GDALDataset *inData, GDALDataset *outData)
     {
-        try
-        {
-            // Change dimensions are the same.
-            if(inData->GetRasterXSize() != outData->GetRasterXSize())
-            {
-                throw RSGISImageException("Widths are not the same");
-            }
-            if(inData->GetRasterYSize() != outData->GetRasterYSize())
-            {
-                throw RSGISImageException("Heights are not the same");
-            }
-            if(inData->GetRasterCount() != outData->GetRasterCount())
-            {
-                throw RSGISImageException("Number of bands are not the same");
-            }
-            
-            unsigned long width = inData->GetRasterXSize();
-            unsigned long height = inData->GetRasterYSize();
-            unsigned int numBands = inData->GetRasterCount();
-            
-            GDALRasterBand **inputRasterBands = new GDALRasterBand*[numBands];
-            GDALRasterBand **outputRasterBands = new GDALRasterBand*[numBands];
-            float *data = new float[width];
-            
-            for(unsigned int n = 0; n < numBands; ++n)
-            {
-                inputRasterBands[n] = inData->GetRasterBand(n+1);
-                outputRasterBands[n] = outData->GetRasterBand(n+1);
-            }
-            
-            for(unsigned long y = 0; y < height; ++y)
-            {
-                for(unsigned int n = 0; n < numBands; ++n)
-                {
-                    inputRasterBands[n]->RasterIO(GF_Read, 0, y, width, 1, data, width, 1, GDT_Float32, 0, 0);
-                    outputRasterBands[n]->RasterIO(GF_Write, 0, y, width, 1, data, width, 1, GDT_Float32, 0, 0);
-                }
-            }
-            
-            delete[] inputRasterBands;
-            delete[] outputRasterBands;
-            delete[] data;
-        }
-        catch(RSGISImageException &e)
-        {
-            throw e;
-        }
+        this->copyGDALDataset(inData, outData, GDT_Float32);
     }
     
     void RSGISImageUtils::copyByteGDALDataset(GDALDataset *inData, GDALDataset *outData)
     {
-        try
-        {
-            // Change dimensions are the same.
-            if(inData->GetRasterXSize() != outData->GetRasterXSize())
-            {
-                throw RSGISImageException("Widths are not the same");
-            }
-            if(inData->GetRasterYSize() != outData->GetRasterYSize())
-            {
-                throw RSGISImageException("Heights are not the same");
-            }
-            if(inData->GetRasterCount() != outData->GetRasterCount())
-            {
-                throw RSGISImageException("Number of bands are not the same");
-            }
-            
-            unsigned long width = inData->GetRasterXSize();
-            unsigned long height = inData->GetRasterYSize();
-            unsigned int numBands = inData->GetRasterCount();
-            
-            GDALRasterBand **inputRasterBands = new GDALRasterBand*[numBands];
-            GDALRasterBand **outputRasterBands = new GDALRasterBand*[numBands];
-            int *data = new int[width];
-            
-            for(unsigned int n = 0; n < numBands; ++n)
-            {
-                inputRasterBands[n] = inData->GetRasterBand(n+1);
-                outputRasterBands[n] = outData->GetRasterBand(n+1);
-            }
-            
-            for(unsigned long y = 0; y < height; ++y)
-            {
-                for(unsigned int n = 0; n < numBands; ++n)
-                {
-                    inputRasterBands[n]->RasterIO(GF_Read, 0, y, width, 1, data, width, 1, GDT_Byte, 0, 0);
-                    outputRasterBands[n]->RasterIO(GF_Write, 0, y, width, 1, data, width, 1, GDT_Byte, 0, 0);
-                }
-            }
-            
-            delete[] inputRasterBands;
-            delete[] outputRasterBands;
-            delete[] data;
-        }
-        catch(RSGISImageException &e)
-        {
-            throw e;
-        }
+        this->copyGDALDataset(inData, outData, GDT_Byte);
     }
     
     void RSGISImageUtils::zerosUIntGDALDataset(GDALDataset *data)
     {
-        try
-        {
-            unsigned long xSize = data->GetRasterXSize();
-            unsigned long ySize = data->GetRasterYSize();
-            unsigned int numBands = data->GetRasterCount();
-            int xBlockSize = 0;
-            int yBlockSize = 0;
-            
-            GDALRasterBand **rasterBands = new GDALRasterBand*[numBands];
-            for(int i = 0; i < numBands; i++)
-            {
-                rasterBands[i] = data->GetRasterBand(i+1);
-            }
-            rasterBands[0]->GetBlockSize(&xBlockSize, &yBlockSize);
-            
-            // Allocate memory
-            unsigned int *dataVals = new unsigned int[xSize*yBlockSize];
-            
-            for(unsigned int i = 0; i < (xSize*yBlockSize); ++i)
-            {
-                dataVals[i] = 0;
-            }
-            
-            int nYBlocks = ySize / yBlockSize;
-            int remainRows = ySize - (nYBlocks * yBlockSize);
-            int rowOffset = 0;
-            
-            rsgis_tqdm pbar;
-            // Loop images to process data
-            for(int i = 0; i < nYBlocks; i++)
-            {
-                pbar.progress(i, nYBlocks);
-                
-                for(int n = 0; n < numBands; n++)
-                {
-                    rowOffset = yBlockSize * i;
-                    rasterBands[n]->RasterIO(GF_Write, 0, rowOffset, xSize, yBlockSize, dataVals, xSize, yBlockSize, GDT_UInt32, 0, 0);
-                }
-            }
-            
-            if(remainRows > 0)
-            {
-                for(int n = 0; n < numBands; n++)
-                {
-                    rowOffset = (yBlockSize * nYBlocks);
-                    rasterBands[n]->RasterIO(GF_Write, 0, rowOffset, xSize, remainRows, dataVals, xSize, remainRows, GDT_UInt32, 0, 0);
-                }
-            }
-            pbar.finish();
-            
-            delete[] rasterBands;
-            delete[] dataVals;
-        }
-        catch(RSGISImageException &e)
-        {
-            throw e;
-        }
+        this->fillGDALDataset(data, 0, GDT_UInt32);
     }
     
     void RSGISImageUtils::zerosFloatGDALDataset(GDALDataset *data)
     {
-        try
+        this->fillGDALDataset(data, 0, GDT_Float32);
+    }
+    
+    void RSGISImageUtils::zerosByteGDALDataset(GDALDataset *data)
+    {
+        this->fillGDALDataset(data, 0, GDT_Byte);
+    }
+    
+    void RSGISImageUtils::assignValGDALDataset(GDALDataset *data, float value)
+    {
+        this->fillGDALDataset(data, value, GDT_Float32);
+    }
+    
+    void RSGISImageUtils::copyGDALDataset(GDALDataset *inData, GDALDataset *outData, GDALDataType bufType)
+    {
+        // Check dimensions are the same.
+        if(inData->GetRasterXSize() != outData->GetRasterXSize())
         {
-            unsigned long xSize = data->GetRasterXSize();
-            unsigned long ySize = data->GetRasterYSize();
-            unsigned int numBands = data->GetRasterCount();
-            int xBlockSize = 0;
-            int yBlockSize = 0;
-            
-            GDALRasterBand **rasterBands = new GDALRasterBand*[numBands];
-            for(int i = 0; i < numBands; i++)
-            {
-                rasterBands[i] = data->GetRasterBand(i+1);
-            }
-            rasterBands[0]->GetBlockSize(&xBlockSize, &yBlockSize);
-            
-            // Allocate memory
-            float *dataVals = new float[xSize*yBlockSize];
-            
-            for(unsigned int i = 0; i < (xSize*yBlockSize); ++i)
-            {
-                dataVals[i] = 0;
-            }
-            
-            int nYBlocks = ySize / yBlockSize;
-            int remainRows = ySize - (nYBlocks * yBlockSize);
-            int rowOffset = 0;
-            
-            rsgis_tqdm pbar;
-            // Loop images to process data
-            for(int i = 0; i < nYBlocks; i++)
-            {
-                pbar.progress(i, nYBlocks);
-                
-                for(int n = 0; n < numBands; n++)
-                {
-                    rowOffset = yBlockSize * i;
-                    rasterBands[n]->RasterIO(GF_Write, 0, rowOffset, xSize, yBlockSize, dataVals, xSize, yBlockSize, GDT_Float32, 0, 0);
-                }
-            }
-            
-            if(remainRows > 0)
+            throw RSGISImageException("Widths are not the same");
+        }
+        if(inData->GetRasterYSize() != outData->GetRasterYSize())
+        {
+            throw RSGISImageException("Heights are not the same");
+        }
+        if(inData->GetRasterCount() != outData->GetRasterCount())
+        {
+            throw RSGISImageException("Number of bands are not the same");
+        }
+        
+        int width = inData->GetRasterXSize();
+        int height = inData->GetRasterYSize();
+        int numBands = inData->GetRasterCount();
+        if((inData == outData) || (width == 0) || (height == 0) || (numBands == 0))
+        {
+            return;
+        }
+        
+        // The data type shared by all the bands (or Float64 if they differ).
+        auto datasetType = [numBands](GDALDataset *dataset)
+        {
+            GDALDataType dataType = dataset->GetRasterBand(1)->GetRasterDataType();
+            for(int n = 1; n < numBands; ++n)
             {
-                for(int n = 0; n < numBands; n++)
+                if(dataset->GetRasterBand(n+1)->GetRasterDataType() != dataType)
                 {
-                    rowOffset = (yBlockSize * nYBlocks);
-                    rasterBands[n]->RasterIO(GF_Write, 0, rowOffset, xSize, remainRows, dataVals, xSize, remainRows, GDT_Float32, 0, 0);
+                    return GDT_Float64;
                 }
             }
-            pbar.finish();
-            
-            delete[] rasterBands;
-            delete[] dataVals;
-        }
-        catch(RSGISImageException &e)
+            return dataType;
+        };
+        GDALDataType inType = bufType;
+        GDALDataType outType = bufType;
+        if(bufType == GDT_Unknown)
         {
-            throw e;
+            inType = datasetType(inData);
+            outType = datasetType(outData);
         }
-    }
-    
-    void RSGISImageUtils::zerosByteGDALDataset(GDALDataset *data)
-    {
-        try
+        bool convert = (inType != outType);
+        size_t inTypeSize = GDALGetDataTypeSize(inType) / 8;
+        size_t outTypeSize = GDALGetDataTypeSize(outType) / 8;
+        
+        RSGISImageBlockPipeline pipeline;
+        unsigned int numSlots = pipeline.getNumSlots();
+        
+        int xBlockSize = 0;
+        int yBlockSize = 0;
+        outData->GetRasterBand(1)->GetBlockSize(&xBlockSize, &yBlockSize);
+        size_t bufBytesPerPxl = numBands * (inTypeSize + (convert?outTypeSize:0));
+        RSGISImageBlockPlanner planner;
+        RSGISImageBlockPlan blockPlan = planner.plan(yBlockSize, width, height, bufBytesPerPxl, numSlots, numBands * inTypeSize);
+        int numRows = blockPlan.rows;
+        RSGISGDALCacheScope gdalCacheScope(blockPlan.gdalCacheBytes);
+        
+        unsigned int nBlocks = (height + numRows - 1) / numRows;
+        size_t numPxlsInBlock = ((size_t)width) * numRows;
+        std::vector<std::vector<unsigned char> > inBufs(numSlots);
+        std::vector<std::vector<unsigned char> > outBufs(numSlots);
+        for(unsigned int s = 0; s < numSlots; ++s)
         {
-            unsigned long xSize = data->GetRasterXSize();
-            unsigned long ySize = data->GetRasterYSize();
-            unsigned int numBands = data->GetRasterCount();
-            int xBlockSize = 0;
-            int yBlockSize = 0;
-            
-            GDALRasterBand **rasterBands = new GDALRasterBand*[numBands];
-            for(int i = 0; i < numBands; i++)
+            inBufs[s].resize(numPxlsInBlock * numBands * inTypeSize);
+            if(convert)
             {
-                rasterBands[i] = data->GetRasterBand(i+1);
+                outBufs[s].resize(numPxlsInBlock * numBands * outTypeSize);
             }
-            rasterBands[0]->GetBlockSize(&xBlockSize, &yBlockSize);
-            
-            // Allocate memory
-            int *dataVals = new int[xSize*yBlockSize];
-            
-            for(unsigned int i = 0; i < (xSize*yBlockSize); ++i)
+        }
+        
+        auto blockLines = [&](unsigned int block){ return std::min(numRows, height - (int)(block * numRows)); };
+        
+        // The buffers are band sequential, so each band is a contiguous plane.
+        auto readBlock = [&](unsigned int block, unsigned int slot)
+        {
+            int numLines = blockLines(block);
+            if(inData->RasterIO(GF_Read, 0, block * numRows, width, numLines, inBufs[slot].data(), width, numLines, inType, numBands, NULL, 0, 0, 0) != CE_None)
             {
-                dataVals[i] = 0;
+                throw RSGISImageException("Could not read a block from the input image.");
             }
-            
-            int nYBlocks = ySize / yBlockSize;
-            int remainRows = ySize - (nYBlocks * yBlockSize);
-            int rowOffset = 0;
-            
-            rsgis_tqdm pbar;
-            // Loop images to process data
-            for(int i = 0; i < nYBlocks; i++)
+        };
+        
+        auto convertBlock = [&](unsigned int block, unsigned int slot)
+        {
+            if(convert)
             {
-                pbar.progress(i, nYBlocks);
-                
-                for(int n = 0; n < numBands; n++)
+                size_t numPxls = ((size_t)width) * blockLines(block);
+                for(int n = 0; n < numBands; ++n)
                 {
-                    rowOffset = yBlockSize * i;
-                    rasterBands[n]->RasterIO(GF_Write, 0, rowOffset, xSize, yBlockSize, dataVals, xSize, yBlockSize, GDT_Byte, 0, 0);
+                    GDALCopyWords(inBufs[slot].data() + (n * numPxls * inTypeSize), inType, inTypeSize, outBufs[slot].data() + (n * numPxls * outTypeSize), outType, outTypeSize, numPxls);
                 }
             }
-            
-            if(remainRows > 0)
+        };
+        
+        auto writeBlock = [&](unsigned int block, unsigned int slot)
+        {
+            int numLines = blockLines(block);
+            unsigned char *outBuf = convert?outBufs[slot].data():inBufs[slot].data();
+            if(outData->RasterIO(GF_Write, 0, block * numRows, width, numLines, outBuf, width, numLines, outType, numBands, NULL, 0, 0, 0) != CE_None)
             {
-                for(int n = 0; n < numBands; n++)
-                {
-                    rowOffset = (yBlockSize * nYBlocks);
-                    rasterBands[n]->RasterIO(GF_Write, 0, rowOffset, xSize, remainRows, dataVals, xSize, remainRows, GDT_Byte, 0, 0);
-                }
+                throw RSGISImageException("Could not write a block to the output image.");
             }
-            pbar.finish();
-            
-            delete[] rasterBands;
-            delete[] dataVals;
-        }
-        catch(RSGISImageException &e)
-        {
-            throw e;
-        }
+        };
+        
+        pipeline.run(nBlocks, readBlock, convertBlock, writeBlock);
     }
     
-    void RSGISImageUtils::assignValGDALDataset(GDALDataset *data, float value)
+    void RSGISImageUtils::fillGDALDataset(GDALDataset *data, double value, GDALDataType bufType)
     {
-        try
+        int width = data->GetRasterXSize();
+        int height = data->GetRasterYSize();
+        int numBands = data->GetRasterCount();
+        if((width == 0) || (height == 0) || (numBands == 0))
         {
-            unsigned long xSize = data->GetRasterXSize();
-            unsigned long ySize = data->GetRasterYSize();
-            unsigned int numBands = data->GetRasterCount();
-            int xBlockSize = 0;
-            int yBlockSize = 0;
-            
-            GDALRasterBand **rasterBands = new GDALRasterBand*[numBands];
-            for(int i = 0; i < numBands; i++)
-            {
-                rasterBands[i] = data->GetRasterBand(i+1);
-            }
-            rasterBands[0]->GetBlockSize(&xBlockSize, &yBlockSize);
-            
-            // Allocate memory
-            float *dataVals = (float *) CPLMalloc(sizeof(float)*(xSize*yBlockSize));
-            
-            for(unsigned int i = 0; i < (xSize*yBlockSize); ++i)
-            {
-                dataVals[i] = value;
-            }
-            
-            int nYBlocks = ySize / yBlockSize;
-            int remainRows = ySize - (nYBlocks * yBlockSize);
-            int rowOffset = 0;
-            
-            rsgis_tqdm pbar;;
-            // Loop images to process data
-            for(int i = 0; i < nYBlocks; i++)
+            return;
+        }
+        
+        std::vector<GDALRasterBand*> rasterBands(numBands);
+        GDALDataType dataType = bufType;
+        for(int n = 0; n < numBands; ++n)
+        {
+            rasterBands[n] = data->GetRasterBand(n+1);
+        }
+        if(bufType == GDT_Unknown)
+        {
+            dataType = rasterBands[0]->GetRasterDataType();
+            for(int n = 1; n < numBands; ++n)
             {
-                pbar.progress(i, nYBlocks);
-                
-                for(int n = 0; n < numBands; n++)
+                if(rasterBands[n]->GetRasterDataType() != dataType)
                 {
-                    rowOffset = yBlockSize * i;
-                    rasterBands[n]->RasterIO(GF_Write, 0, rowOffset, xSize, yBlockSize, dataVals, xSize, yBlockSize, GDT_Float32, 0, 0);
+                    dataType = GDT_Float64;
                 }
             }
-            
-            if(remainRows > 0)
+        }
+        size_t typeSize = GDALGetDataTypeSize(dataType) / 8;
+        
+        int xBlockSize = 0;
+        int yBlockSize = 0;
+        rasterBands[0]->GetBlockSize(&xBlockSize, &yBlockSize);
+        RSGISImageBlockPlanner planner;
+        RSGISImageBlockPlan blockPlan = planner.plan(yBlockSize, width, height, typeSize, 1, numBands * typeSize);
+        int numRows = blockPlan.rows;
+        RSGISGDALCacheScope gdalCacheScope(blockPlan.gdalCacheBytes);
+        
+        // Fill the block once, it is the same for every block and band.
+        size_t numPxlsInBlock = ((size_t)width) * numRows;
+        std::vector<unsigned char> dataVals(numPxlsInBlock * typeSize);
+        GDALCopyWords(&value, GDT_Float64, 0, dataVals.data(), dataType, typeSize, numPxlsInBlock);
+        
+        rsgis_tqdm pbar;
+        for(int rowOffset = 0; rowOffset < height; rowOffset += numRows)
+        {
+            pbar.progress(rowOffset, height);
+            int numLines = std::min(numRows, height - rowOffset);
+            for(int n = 0; n < numBands; ++n)
             {
-                for(int n = 0; n < numBands; n++)
+                if(rasterBands[n]->RasterIO(GF_Write, 0, rowOffset, width, numLines, dataVals.data(), width, numLines, dataType, 0, 0) != CE_None)
                 {
-                    rowOffset = (yBlockSize * nYBlocks);
-                    rasterBands[n]->RasterIO(GF_Write, 0, rowOffset, xSize, remainRows, dataVals, xSize, remainRows, GDT_Float32, 0, 0);
+                    throw RSGISImageException("Could not write a block to the image.");
                 }
             }
-            pbar.finish();
-            
-            delete[] rasterBands;
-            delete[] dataVals;
-        }
-        catch(RSGISImageException &e)
-        {
-            throw e;
         }
+        pbar.finish();
     }
     
     GDALDataset* RSGISImageUtils::createCopy(GDALDataset *inData, std::string outputFilePath, std::string outputFormat, GDALDataType eType, bool useImgProj, std::string proj)
@@ -4945,6 +4671,7 @@ namespace rsgis{namespace img{
             throw RSGISImageException(message.c_str());
         }
         char **papszOptions = this->getGDALCreationOptionsForFormat(outputFormat);
+        RSGISDatasetCache::invalidate(outputFilePath);
         GDALDataset *dataset = gdalDriver->Create(outputFilePath.c_str(), width, height, numBands, eType, papszOptions);
         if(dataset == NULL)
         {
@@ -4985,6 +4712,7 @@ namespace rsgis{namespace img{
             throw RSGISImageException(message.c_str());
         }
         char **papszOptions = this->getGDALCreationOptionsForFormat(outputFormat);
+        RSGISDatasetCache::invalidate(outputFilePath);
         GDALDataset *dataset = gdalDriver->Create(outputFilePath.c_str(), width, height, numBands, eType, papszOptions);
         if(dataset == NULL)
         {
@@ -5069,6 +4797,7 @@ namespace rsgis{namespace img{
             }
             char **papszOptions = this->getGDALCreationOptionsForFormat(outputFormat);
             
+            RSGISDatasetCache::invalidate(outputFilePath);
             dataset = gdalDriver->Create(outputFilePath.c_str(), outImgWidth, outImgHeight, numBands, eType, papszOptions);
             if(dataset == NULL)
             {
@@ -5134,6 +4863,7 @@ namespace rsgis{namespace img{
             }
             char **papszOptions = this->getGDALCreationOptionsForFormat(outputFormat);
             
+            RSGISDatasetCache::invalidate(outputFilePath);
             dataset = gdalDriver->Create(outputFilePath.c_str(), outImgWidth, outImgHeight, numBands, eType, papszOptions);
             if(dataset == NULL)
             {
@@ -5191,6 +4921,7 @@ namespace rsgis{namespace img{
             }
             char **papszOptions = this->getGDALCreationOptionsForFormat(outputFormat);
             
+            RSGISDatasetCache::invalidate(outputFilePath);
             dataset = gdalDriver->Create(outputFilePath.c_str(), width, height, numBands, eType, papszOptions);
             if(dataset == NULL)
             {
@@ -5667,10 +5398,36 @@ namespace rsgis{namespace img{
     char** RSGISImageUtils::getGDALCreationOptionsForFormat(std::string gdalFormat)
     {
         std::map<std::string, std::string> gdal_creation_options = this->getCreateGDALImgEnvVars(gdalFormat);
+        this->setCompressionThreads(gdalFormat, &gdal_creation_options);
         char **papszOptions = this->getGDALCreationOptions(gdal_creation_options);
         return papszOptions;
     }
 
+    void RSGISImageUtils::setCompressionThreads(std::string gdalFormat, std::map<std::string, std::string> *gdal_creation_options)
+    {
+        // Only the GeoTIFF based drivers compress blocks in parallel, the KEA
+        // (HDF5) driver always compresses on the writing thread.
+        std::string format = boost::to_upper_copy(gdalFormat);
+        if((format != "GTIFF") && (format != "COG"))
+        {
+            return;
+        }
+        if(gdal_creation_options->count("NUM_THREADS") > 0)
+        {
+            return;
+        }
+        std::map<std::string, std::string>::iterator iterCompress = gdal_creation_options->find("COMPRESS");
+        if((iterCompress == gdal_creation_options->end()) || (boost::to_upper_copy(iterCompress->second) == "NONE"))
+        {
+            return;
+        }
+        unsigned int numThreads = rsgis::utils::getNumThreads();
+        if(numThreads > 1)
+        {
+            (*gdal_creation_options)["NUM_THREADS"] = std::to_string(numThreads);
+        }
+    }
+
 	RSGISImageUtils::~RSGISImageUtils()
 	{
 		
@@ -36,11 +36,13 @@
 #include "common/rsgis-tqdm.h"
 
 #include "img/RSGISImageBandException.h"
+#include "img/RSGISDatasetCache.h"
 
 #include "math/RSGISMathsUtils.h"
 
 #include "common/RSGISImageException.h"
 #include "common/RSGISOutputStreamException.h"
+#include "common/RSGISParallel.h"
 
 #include "utils/RSGISTextUtils.h"
 
@@ -191,6 +193,21 @@ namespace rsgis
                 void zerosFloatGDALDataset(GDALDataset *data);
                 void zerosByteGDALDataset(GDALDataset *data);
                 void assignValGDALDataset(GDALDataset *data, float value);
+                /**
+                 * Copy all the bands of inData to outData (which must have the same size and
+                 * number of bands). Blocks of whole native block rows (sized by
+                 * RSGISImageBlockPlanner) are read for all the bands in a single RasterIO
+                 * call, in the data type of the input, converted to the data type of the
+                 * output and written while the next block is read (RSGISImageBlockPipeline).
+                 * If bufType is given the values are read and written as that type instead.
+                 */
+                void copyGDALDataset(GDALDataset *inData, GDALDataset *outData, GDALDataType bufType=GDT_Unknown);
+                /**
+                 * Set all the pixels of all the bands to value. A single block holding the
+                 * value (in bufType, or the data type of the bands if not given) is filled
+                 * once and written to each block of each band.
+                 */
+                void fillGDALDataset(GDALDataset *data, double value, GDALDataType bufType=GDT_Unknown);
                 GDALDataset* createCopy(GDALDataset *inData, std::string outputFilePath, std::string outputFormat, GDALDataType eType, bool useImgProj=true, std::string proj="");
                 GDALDataset* createCopy(GDALDataset *inData, unsigned int numBands, std::string outputFilePath, std::string outputFormat, GDALDataType eType, bool useImgProj=true, std::string proj="");
                 GDALDataset* createCopy(GDALDataset *inData, unsigned int numBands, std::string outputFilePath, std::string outputFormat, GDALDataType eType, geos::geom::Envelope extent, bool useImgProj=true, std::string proj="");
@@ -207,6 +224,12 @@ namespace rsgis
                 std::map<std::string, std::string> getCreateGDALImgEnvVars(std::string gdalFormat);
                 char** getGDALCreationOptions(std::map<std::string, std::string> gdal_creation_options);
                 char** getGDALCreationOptionsForFormat(std::string gdalFormat);
+                /**
+                 * For a compressed GTiff or COG output, set NUM_THREADS so GDAL
+                 * compresses the blocks with RSGISLIB_NUM_THREADS worker threads,
+                 * unless NUM_THREADS has already been given.
+                 */
+                void setCompressionThreads(std::string gdalFormat, std::map<std::string, std::string> *gdal_creation_options);
                 ~RSGISImageUtils();
 			private:
                 double resDiffThresh; // Maximum difference between image resolutions (as a fraction).
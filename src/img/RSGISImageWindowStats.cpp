@@ -25,6 +25,244 @@
 
 namespace rsgis{namespace img{
     
+    const int RSGISWindowColumnSums::recomputeInterval = 64;
+    
+    RSGISWindowColumnSums::RSGISWindowColumnSums(int numSums)
+    {
+        this->numSums = numSums;
+        this->numSets = 0;
+        this->numBands = 0;
+        this->winSize = 0;
+        this->paddedWidth = 0;
+        this->rowsSinceRecompute = 0;
+        this->prevLine = -1;
+        this->prevBufferID = 0;
+    }
+    
+    void RSGISWindowColumnSums::update(const RSGISImageWindowView &rowWindow, int width)
+    {
+        // Each view row holds the window columns of every pixel along the image row.
+        int viewNumBands = rowWindow.getNumBands();
+        int viewWinSize = rowWindow.getWinSize();
+        int viewPaddedWidth = width + viewWinSize - 1;
+        bool sizeChanged = (viewNumBands != this->numBands) || (viewWinSize != this->winSize) || (viewPaddedWidth != this->paddedWidth);
+        if(sizeChanged)
+        {
+            this->initBands(viewNumBands);
+            this->numBands = viewNumBands;
+            this->winSize = viewWinSize;
+            this->paddedWidth = viewPaddedWidth;
+            this->colSums.assign(this->numSets * this->numSums * this->paddedWidth, 0.0);
+            this->prefixSums.assign(this->numSets * this->numSums * (this->paddedWidth+1), 0.0);
+            this->prevTopRows.assign(this->numBands, std::vector<float>());
+            this->bandRows.assign(this->numBands, NULL);
+        }
+        
+        // The window has moved down a row if the view is of the next line of the same ring buffer.
+        bool shifted = (!sizeChanged) && (this->rowsSinceRecompute < recomputeInterval) && (rowWindow.getBufferID() == this->prevBufferID) && (rowWindow.getLine() == (this->prevLine + 1));
+        if(shifted)
+        {
+            for(std::vector<int>::iterator iterBand = this->usedBands.begin(); iterBand != this->usedBands.end(); ++iterBand)
+            {
+                this->bandRows[*iterBand] = this->prevTopRows[*iterBand].data();
+            }
+            this->addRowValues(this->bandRows.data(), -1.0);
+            for(std::vector<int>::iterator iterBand = this->usedBands.begin(); iterBand != this->usedBands.end(); ++iterBand)
+            {
+                this->bandRows[*iterBand] = rowWindow.getRow(*iterBand, this->winSize-1);
+            }
+            this->addRowValues(this->bandRows.data(), 1.0);
+            ++this->rowsSinceRecompute;
+        }
+        else
+        {
+            std::fill(this->colSums.begin(), this->colSums.end(), 0.0);
+            for(int y = 0; y < this->winSize; ++y)
+            {
+                for(std::vector<int>::iterator iterBand = this->usedBands.begin(); iterBand != this->usedBands.end(); ++iterBand)
+                {
+                    this->bandRows[*iterBand] = rowWindow.getRow(*iterBand, y);
+                }
+                this->addRowValues(this->bandRows.data(), 1.0);
+            }
+            this->rowsSinceRecompute = 0;
+        }
+        this->prevLine = rowWindow.getLine();
+        this->prevBufferID = rowWindow.getBufferID();
+        
+        for(std::vector<int>::iterator iterBand = this->usedBands.begin(); iterBand != this->usedBands.end(); ++iterBand)
+        {
+            const float *topRow = rowWindow.getRow(*iterBand, 0);
+            this->prevTopRows[*iterBand].assign(topRow, topRow + this->paddedWidth);
+        }
+        
+        size_t numSumRows = this->numSets * this->numSums;
+        for(size_t s = 0; s < numSumRows; ++s)
+        {
+            const double *colRow = &this->colSums[s * this->paddedWidth];
+            double *preRow = &this->prefixSums[s * (this->paddedWidth+1)];
+            preRow[0] = 0.0;
+            for(int c = 0; c < this->paddedWidth; ++c)
+            {
+                preRow[c+1] = preRow[c] + colRow[c];
+            }
+        }
+    }
+    
+    RSGISWindowColumnSums::~RSGISWindowColumnSums()
+    {
+        
+    }
+    
+    
+    RSGISWindowMomentSums::RSGISWindowMomentSums(std::vector<std::pair<int, int> > bandPairs) : RSGISWindowColumnSums(6)
+    {
+        this->bandPairs = bandPairs;
+    }
+    
+    void RSGISWindowMomentSums::initBands(int numBands)
+    {
+        this->usedBands.clear();
+        for(std::vector<std::pair<int, int> >::iterator iterPair = this->bandPairs.begin(); iterPair != this->bandPairs.end(); ++iterPair)
+        {
+            if((iterPair->first < 0) || (iterPair->first >= numBands) || (iterPair->second < 0) || (iterPair->second >= numBands))
+            {
+                throw RSGISImageCalcException("Requested band not in image");
+            }
+            this->usedBands.push_back(iterPair->first);
+            this->usedBands.push_back(iterPair->second);
+        }
+        std::sort(this->usedBands.begin(), this->usedBands.end());
+        this->usedBands.erase(std::unique(this->usedBands.begin(), this->usedBands.end()), this->usedBands.end());
+        this->numSets = this->bandPairs.size();
+    }
+    
+    void RSGISWindowMomentSums::addRowValues(const float* const* bandRows, double sign)
+    {
+        for(size_t p = 0; p < this->bandPairs.size(); ++p)
+        {
+            const float *rowA = bandRows[this->bandPairs[p].first];
+            const float *rowB = bandRows[this->bandPairs[p].second];
+            double *nCol = this->getColSums(p, 0);
+            double *sumACol = this->getColSums(p, 1);
+            double *sumBCol = this->getColSums(p, 2);
+            double *sumAACol = this->getColSums(p, 3);
+            double *sumBBCol = this->getColSums(p, 4);
+            double *sumABCol = this->getColSums(p, 5);
+            for(int c = 0; c < this->paddedWidth; ++c)
+            {
+                double a = rowA[c];
+                double b = rowB[c];
+                if(std::isfinite(a) && std::isfinite(b))
+                {
+                    nCol[c] += sign;
+                    sumACol[c] += sign * a;
+                    sumBCol[c] += sign * b;
+                    sumAACol[c] += sign * (a * a);
+                    sumBBCol[c] += sign * (b * b);
+                    sumABCol[c] += sign * (a * b);
+                }
+            }
+        }
+    }
+    
+    RSGISWindowMomentSums::~RSGISWindowMomentSums()
+    {
+        
+    }
+    
+    
+    RSGISWindowBandMoments::RSGISWindowBandMoments(bool calcTransformed) : RSGISWindowColumnSums(calcTransformed?6:3)
+    {
+        this->calcTransformed = calcTransformed;
+    }
+    
+    void RSGISWindowBandMoments::initBands(int numBands)
+    {
+        this->usedBands.clear();
+        for(int b = 0; b < numBands; ++b)
+        {
+            this->usedBands.push_back(b);
+        }
+        this->numSets = numBands;
+    }
+    
+    void RSGISWindowBandMoments::addRowValues(const float* const* bandRows, double sign)
+    {
+        for(size_t b = 0; b < this->numSets; ++b)
+        {
+            const float *row = bandRows[b];
+            double *nCol = this->getColSums(b, 0);
+            double *sumCol = this->getColSums(b, 1);
+            double *sumSqCol = this->getColSums(b, 2);
+            if(this->calcTransformed)
+            {
+                double *sumSqrtCol = this->getColSums(b, 3);
+                double *sumLnCol = this->getColSums(b, 4);
+                double *sumLnSqCol = this->getColSums(b, 5);
+                for(int c = 0; c < this->paddedWidth; ++c)
+                {
+                    double val = row[c];
+                    if(std::isfinite(val) && (val > 0))
+                    {
+                        double lnVal = std::log(val);
+                        nCol[c] += sign;
+                        sumCol[c] += sign * val;
+                        sumSqCol[c] += sign * (val * val);
+                        sumSqrtCol[c] += sign * std::sqrt(val);
+                        sumLnCol[c] += sign * lnVal;
+                        sumLnSqCol[c] += sign * (lnVal * lnVal);
+                    }
+                }
+            }
+            else
+            {
+                for(int c = 0; c < this->paddedWidth; ++c)
+                {
+                    double val = row[c];
+                    if(std::isfinite(val) && (val != 0))
+                    {
+                        nCol[c] += sign;
+                        sumCol[c] += sign * val;
+                        sumSqCol[c] += sign * (val * val);
+                    }
+                }
+            }
+        }
+    }
+    
+    RSGISWindowBandMoments::BandSums RSGISWindowBandMoments::sumWindow(float ***dataBlock, int band, int winSize, bool calcTransformed)
+    {
+        BandSums sums = {0, 0, 0, 0, 0, 0};
+        for(int y = 0; y < winSize; ++y)
+        {
+            for(int x = 0; x < winSize; ++x)
+            {
+                double val = dataBlock[band][y][x];
+                if(std::isfinite(val) && (val != 0) && ((!calcTransformed) || (val > 0)))
+                {
+                    sums.n += 1;
+                    sums.sum += val;
+                    sums.sumSq += val * val;
+                    if(calcTransformed)
+                    {
+                        double lnVal = std::log(val);
+                        sums.sumSqrt += std::sqrt(val);
+                        sums.sumLn += lnVal;
+                        sums.sumLnSq += lnVal * lnVal;
+                    }
+                }
+            }
+        }
+        return sums;
+    }
+    
+    RSGISWindowBandMoments::~RSGISWindowBandMoments()
+    {
+        
+    }
+    
+    
     RSGISCalcImgPxlNeighboursDist::RSGISCalcImgPxlNeighboursDist() : RSGISCalcImageValue(4)
     {
         stats = new rsgis::math::RSGISStatsSummary();
@@ -229,6 +467,9 @@ namespace rsgis{namespace img{
     {
         this->bandA = bandA;
         this->bandB = bandB;
+        std::vector<std::pair<int, int> > bandPairs;
+        bandPairs.push_back(std::pair<int, int>(bandA, bandB));
+        this->windowSums = new RSGISWindowMomentSums(bandPairs);
     }
     
     void RSGISCalcImage2ImageCorrelation::calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) 
@@ -273,8 +514,119 @@ namespace rsgis{namespace img{
 
     }
     
+    void RSGISCalcImage2ImageCorrelation::calcImageWindowRow(const RSGISImageWindowView &rowWindow, int width, double **outRows)
+    {
+        if( (this->bandA >= rowWindow.getNumBands() ) | (this->bandB >= rowWindow.getNumBands()) )
+        {
+            throw rsgis::img::RSGISImageCalcException("Requested band not in image");
+        }
+        
+        this->windowSums->update(rowWindow, width);
+        for(int x = 0; x < width; ++x)
+        {
+            RSGISWindowMomentSums::PairSums sums = this->windowSums->getSums(0, x);
+            double nPixels = floor(sums.n + 0.5);
+            float blockCorrelation = 0;
+            if(nPixels > 1)
+            {
+                blockCorrelation = (((nPixels * sums.sumAB) - (sums.sumA * sums.sumB))/sqrt(((nPixels*sums.sumAA)-(sums.sumA*sums.sumA))*((nPixels*sums.sumBB)-(sums.sumB*sums.sumB))));
+            }
+            if( !(boost::math::isfinite)(blockCorrelation)){blockCorrelation = 0;}
+            outRows[0][x] = blockCorrelation;
+        }
+    }
+    
     
-    RSGISCalcImage2ImageCorrelation::~RSGISCalcImage2ImageCorrelation(){}
+    RSGISCalcImage2ImageCorrelation::~RSGISCalcImage2ImageCorrelation()
+    {
+        delete this->windowSums;
+    }
+    
+    
+    RSGISCalcLocalMahalanobisDist::RSGISCalcLocalMahalanobisDist(int numBands) : RSGISCalcImageValue(1)
+    {
+        if(numBands < 1)
+        {
+            throw RSGISImageCalcException("At least one image band is required.");
+        }
+        this->numBands = numBands;
+        std::vector<std::pair<int, int> > bandPairs;
+        for(int a = 0; a < numBands; ++a)
+        {
+            for(int b = a; b < numBands; ++b)
+            {
+                bandPairs.push_back(std::pair<int, int>(a, b));
+            }
+        }
+        this->windowSums = new RSGISWindowMomentSums(bandPairs);
+        this->covariance = gsl_matrix_alloc(numBands, numBands);
+        this->diff = gsl_vector_alloc(numBands);
+        gsl_set_error_handler_off();
+    }
+    
+    void RSGISCalcLocalMahalanobisDist::calcImageWindowRow(const RSGISImageWindowView &rowWindow, int width, double **outRows)
+    {
+        if(rowWindow.getNumBands() != this->numBands)
+        {
+            throw RSGISImageCalcException("The number of image bands is not the same as the number the filter was created for.");
+        }
+        
+        this->windowSums->update(rowWindow, width);
+        int winMid = rowWindow.getWinSize() / 2;
+        std::vector<double> diffVals(this->numBands);
+        for(int x = 0; x < width; ++x)
+        {
+            // The pairs are in the order (0,0), (0,1), ..., (0,n-1), (1,1), ...
+            bool valid = true;
+            size_t pairIdx = 0;
+            for(int a = 0; (a < this->numBands) && valid; ++a)
+            {
+                for(int b = a; b < this->numBands; ++b, ++pairIdx)
+                {
+                    RSGISWindowMomentSums::PairSums sums = this->windowSums->getSums(pairIdx, x);
+                    if(sums.n < 1.5)
+                    {
+                        valid = false;
+                        break;
+                    }
+                    double covVal = (sums.sumAB - ((sums.sumA * sums.sumB) / sums.n)) / sums.n;
+                    gsl_matrix_set(this->covariance, a, b, covVal);
+                    gsl_matrix_set(this->covariance, b, a, covVal);
+                    if(a == b)
+                    {
+                        double centreVal = rowWindow.getRow(a, winMid)[x + winMid];
+                        if(!std::isfinite(centreVal))
+                        {
+                            valid = false;
+                            break;
+                        }
+                        diffVals[a] = centreVal - (sums.sumA / sums.n);
+                        gsl_vector_set(this->diff, a, diffVals[a]);
+                    }
+                }
+            }
+            
+            // The window covariance is singular (e.g., a uniform window) if the decomposition fails.
+            if((!valid) || (gsl_linalg_cholesky_decomp(this->covariance) != 0) || (gsl_linalg_cholesky_svx(this->covariance, this->diff) != 0))
+            {
+                outRows[0][x] = 0;
+                continue;
+            }
+            double distSq = 0;
+            for(int a = 0; a < this->numBands; ++a)
+            {
+                distSq += diffVals[a] * gsl_vector_get(this->diff, a);
+            }
+            outRows[0][x] = sqrt(std::max(distSq, 0.0));
+        }
+    }
+    
+    RSGISCalcLocalMahalanobisDist::~RSGISCalcLocalMahalanobisDist()
+    {
+        delete this->windowSums;
+        gsl_matrix_free(this->covariance);
+        gsl_vector_free(this->diff);
+    }
 	
 }}
 
@@ -25,6 +25,10 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <utility>
+#include <cstring>
+#include <cmath>
 #include "img/RSGISImageCalcException.h"
 #include "img/RSGISCalcImageSingleValue.h"
 #include "img/RSGISCalcImageSingle.h"
@@ -34,11 +38,13 @@
 #include "img/RSGISCalcImageValue.h"
 #include "img/RSGISCalcCovariance.h"
 #include "img/RSGISCalcImage.h"
+#include "img/RSGISImageRowRingBuffer.h"
 
 #include <gsl/gsl_matrix.h>
 #include <gsl/gsl_vector.h>
 #include <gsl/gsl_linalg.h>
 #include <gsl/gsl_blas.h>
+#include <gsl/gsl_errno.h>
 
 #include <boost/math/special_functions/fpclassify.hpp>
 
@@ -57,6 +63,165 @@
 
 namespace rsgis{namespace img{
 
+    /**
+     * Sums over a sliding winSize x winSize window, for a number of sets (e.g.,
+     * bands or pairs of bands) of numSums values per pixel, along an image row.
+     *
+     * update() is called with the window view of column 0 of each image row (as
+     * given to RSGISCalcImageValue::calcImageWindowRow). The sums of each column
+     * over the window rows are kept and, when the view is of the next line of
+     * the same ring buffer as the previous call (RSGISImageWindowView::getLine
+     * and getBufferID), updated by removing the row which has left and adding
+     * the new row; otherwise (and every recomputeInterval rows, to bound
+     * rounding error) they are recomputed. The window sums along the row are
+     * then prefix sums of the column sums, so the sums of any window are O(1)
+     * for any window size.
+     *
+     * Subclasses say which bands they use and add a row's values to the column
+     * sums of each of their sets.
+     */
+    class DllExport RSGISWindowColumnSums
+    {
+    public:
+        RSGISWindowColumnSums(int numSums);
+        void update(const RSGISImageWindowView &rowWindow, int width);
+        virtual ~RSGISWindowColumnSums();
+    protected:
+        /**
+         * Called when the number of bands of the view changes: set usedBands
+         * and numSets (or throw if a band is not within the view).
+         */
+        virtual void initBands(int numBands) = 0;
+        /**
+         * Add (sign 1) or remove (sign -1) the values of a row, where
+         * bandRows[b] is the row (of paddedWidth values) of band b (only the
+         * usedBands are given), to the column sums of each set.
+         */
+        virtual void addRowValues(const float* const* bandRows, double sign) = 0;
+        /** The column sums of sum s of a set. */
+        inline double* getColSums(size_t set, int s){return &colSums[((set * numSums) + s) * paddedWidth];};
+        /** The prefix sums of a set, sum s at [s * (paddedWidth+1)]. */
+        inline const double* getPrefixSums(size_t set) const {return &prefixSums[set * numSums * (paddedWidth+1)];};
+        static const int recomputeInterval;
+        int numSums;
+        size_t numSets;
+        std::vector<int> usedBands;
+        int numBands;
+        int winSize;
+        int paddedWidth;
+        int rowsSinceRecompute;
+        // The line and ring buffer of the previous view.
+        int prevLine;
+        unsigned long long prevBufferID;
+        // The column sums (set, sum, column) and their prefix sums along the row.
+        std::vector<double> colSums;
+        std::vector<double> prefixSums;
+        // A copy of the first row of the previous view for each band, the row to
+        // be removed when the window moves down.
+        std::vector<std::vector<float> > prevTopRows;
+        std::vector<const float*> bandRows;
+    };
+    
+    /**
+     * Sums over a sliding winSize x winSize window for pairs of bands (a, b): the
+     * number of pixels where both are finite and, over those pixels, the sums of
+     * a, b, a^2, b^2 and a.b, from which windowed means, variances, covariances
+     * and correlations follow. The sums are updated a row at a time as for
+     * RSGISWindowColumnSums, so getSums is O(1) for any window size.
+     */
+    class DllExport RSGISWindowMomentSums : public RSGISWindowColumnSums
+    {
+    public:
+        struct PairSums
+        {
+            double n;
+            double sumA;
+            double sumB;
+            double sumAA;
+            double sumBB;
+            double sumAB;
+        };
+        RSGISWindowMomentSums(std::vector<std::pair<int, int> > bandPairs);
+        /** The sums for a band pair over the window centred on column x. */
+        inline PairSums getSums(size_t pairIdx, int x) const
+        {
+            const double *pre = getPrefixSums(pairIdx);
+            size_t lo = x;
+            size_t hi = x + winSize;
+            size_t stride = paddedWidth + 1;
+            PairSums sums;
+            sums.n = pre[hi] - pre[lo];
+            sums.sumA = pre[stride+hi] - pre[stride+lo];
+            sums.sumB = pre[(2*stride)+hi] - pre[(2*stride)+lo];
+            sums.sumAA = pre[(3*stride)+hi] - pre[(3*stride)+lo];
+            sums.sumBB = pre[(4*stride)+hi] - pre[(4*stride)+lo];
+            sums.sumAB = pre[(5*stride)+hi] - pre[(5*stride)+lo];
+            return sums;
+        };
+        size_t getNumPairs() const {return bandPairs.size();};
+        ~RSGISWindowMomentSums();
+    protected:
+        void initBands(int numBands);
+        void addRowValues(const float* const* bandRows, double sign);
+        std::vector<std::pair<int, int> > bandPairs;
+    };
+    
+    /**
+     * Sums over a sliding winSize x winSize window for each band of the number of
+     * valid pixels and, over those pixels, of x and x^2 and optionally of sqrt(x),
+     * ln(x) and ln(x)^2, from which the local moments used by the SAR speckle and
+     * texture filters follow. Pixels are valid if finite and non-zero (0 being no
+     * data for SAR images) and, when the transformed sums are calculated, also
+     * positive. The sums are updated a row at a time as for RSGISWindowColumnSums,
+     * so getSums is O(1) for any window size.
+     */
+    class DllExport RSGISWindowBandMoments : public RSGISWindowColumnSums
+    {
+    public:
+        struct BandSums
+        {
+            double n;
+            double sum;
+            double sumSq;
+            double sumSqrt;
+            double sumLn;
+            double sumLnSq;
+        };
+        RSGISWindowBandMoments(bool calcTransformed=false);
+        /** The sums for a band over the window centred on column x. */
+        inline BandSums getSums(int band, int x) const
+        {
+            size_t stride = paddedWidth + 1;
+            const double *pre = getPrefixSums(band);
+            size_t lo = x;
+            size_t hi = x + winSize;
+            BandSums sums;
+            sums.n = pre[hi] - pre[lo];
+            sums.sum = pre[stride+hi] - pre[stride+lo];
+            sums.sumSq = pre[(2*stride)+hi] - pre[(2*stride)+lo];
+            sums.sumSqrt = 0;
+            sums.sumLn = 0;
+            sums.sumLnSq = 0;
+            if(calcTransformed)
+            {
+                sums.sumSqrt = pre[(3*stride)+hi] - pre[(3*stride)+lo];
+                sums.sumLn = pre[(4*stride)+hi] - pre[(4*stride)+lo];
+                sums.sumLnSq = pre[(5*stride)+hi] - pre[(5*stride)+lo];
+            }
+            return sums;
+        };
+        /**
+         * The sums over a window held as dataBlock[band][y][x], for use where
+         * the window is not given as a row view.
+         */
+        static BandSums sumWindow(float ***dataBlock, int band, int winSize, bool calcTransformed);
+        ~RSGISWindowBandMoments();
+    protected:
+        void initBands(int numBands);
+        void addRowValues(const float* const* bandRows, double sign);
+        bool calcTransformed;
+    };
+    
     class DllExport RSGISCalcImgPxlNeighboursDist: public RSGISCalcImageValue
     {
     public:
@@ -111,6 +276,9 @@ namespace rsgis{namespace img{
      */
     public:
         RSGISCalcImage2ImageCorrelation(unsigned int bandA = 0, unsigned int bandB = 1);
+        /** The correlation along each row comes from RSGISWindowMomentSums. */
+        bool useImageWindowRows(){return true;};
+        void calcImageWindowRow(const RSGISImageWindowView &rowWindow, int width, double **outRows);
         void calcImageValue(float *bandValues, int numBands, double *output) {throw RSGISImageCalcException("Not Implemented");};
         void calcImageValue(float *bandValues, int numBands) {throw RSGISImageCalcException("Not Implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw RSGISImageCalcException("Not implemented");};
@@ -125,6 +293,39 @@ namespace rsgis{namespace img{
     private:
         unsigned int bandA;
         unsigned int bandB;
+        RSGISWindowMomentSums *windowSums;
+    };
+    
+    /**
+     * The Mahalanobis distance of each pixel from the mean of the window around it,
+     * using the covariance of the window (i.e., a local RX anomaly detector). The
+     * window means and covariances come from RSGISWindowMomentSums so the cost
+     * per pixel does not depend on the window size. Pixels outside the image are
+     * 0 and non-finite values are ignored (pairwise); pixels whose window
+     * covariance is singular are given 0.
+     */
+    class DllExport RSGISCalcLocalMahalanobisDist: public RSGISCalcImageValue
+    {
+    public:
+        RSGISCalcLocalMahalanobisDist(int numBands);
+        bool useImageWindowRows(){return true;};
+        void calcImageWindowRow(const RSGISImageWindowView &rowWindow, int width, double **outRows);
+        void calcImageValue(float *bandValues, int numBands, double *output) {throw RSGISImageCalcException("Not Implemented");};
+        void calcImageValue(float *bandValues, int numBands) {throw RSGISImageCalcException("Not Implemented");};
+        void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw RSGISImageCalcException("Not implemented");};
+        void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw RSGISImageCalcException("Not implemented");};
+        void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, geos::geom::Envelope extent){throw rsgis::img::RSGISImageCalcException("Not implemented");};
+        void calcImageValue(float *bandValues, int numBands, geos::geom::Envelope extent) {throw RSGISImageCalcException("Not Implemented");};
+        void calcImageValue(float *bandValues, int numBands, double *output, geos::geom::Envelope extent) {throw RSGISImageCalcException("Not Implemented");};
+        void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageCalcException("Not Implemented");};
+        void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output, geos::geom::Envelope extent) {throw RSGISImageCalcException("Not Implemented");};
+        bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageCalcException("Not Implemented");};
+        ~RSGISCalcLocalMahalanobisDist();
+    private:
+        int numBands;
+        RSGISWindowMomentSums *windowSums;
+        gsl_matrix *covariance;
+        gsl_vector *diff;
     };
     
     
@@ -61,161 +61,244 @@ namespace rsgis{namespace img{
     RSGISCalcHighResImgSummaryStats::RSGISCalcHighResImgSummaryStats(int numberOutBands, std::vector<rsgis::math::rsgissummarytype> sumStats) : rsgis::img::RSGISCalcValuesFromMultiResInputs(numberOutBands)
     {
         this->sumStats = sumStats;
+        this->needStdDev = false;
+        this->needSorted = false;
+        for(size_t i = 0; i < this->sumStats.size(); ++i)
+        {
+            switch(this->sumStats.at(i))
+            {
+                case rsgis::math::sumtype_min:
+                case rsgis::math::sumtype_max:
+                case rsgis::math::sumtype_mean:
+                case rsgis::math::sumtype_range:
+                case rsgis::math::sumtype_sum:
+                case rsgis::math::sumtype_count:
+                    break;
+                case rsgis::math::sumtype_stddev:
+                    this->needStdDev = true;
+                    break;
+                case rsgis::math::sumtype_median:
+                case rsgis::math::sumtype_mode:
+                    this->needSorted = true;
+                    break;
+                default:
+                    throw RSGISImageCalcException("The summary type specified is unknown.");
+            }
+        }
     }
     
     void RSGISCalcHighResImgSummaryStats::calcImageValue(float *bandValues, int numInVals, bool useNoData, float noDataVal, double *output) 
+    {
+        // A single cell of numInVals pixels.
+        std::vector<double*> outPlanes(this->sumStats.size());
+        for(size_t i = 0; i < this->sumStats.size(); ++i)
+        {
+            outPlanes[i] = &output[i];
+        }
+        this->calcLowResBlock(bandValues, 1, 1, numInVals, 1, useNoData, noDataVal, outPlanes.data());
+    }
+    
+    void RSGISCalcHighResImgSummaryStats::calcLowResBlock(const float *highResVals, unsigned int numCols, unsigned int numRows, unsigned int nXPxls, unsigned int nYPxls, bool useNoData, float noDataVal, double **outPlanes)
     {
         if(this->sumStats.size() != this->getNumOutBands())
         {
             throw RSGISImageCalcException("The number of output image bands and summary stats is not equal.");
         }
         
-        bool needBasic = false;
-        bool needStdDev = false;
-        for(int i = 0; i < this->sumStats.size(); ++i)
+        size_t numCells = ((size_t)numCols) * numRows;
+        size_t highResWidth = ((size_t)numCols) * nXPxls;
+        std::vector<double> count(numCells, 0.0);
+        std::vector<double> sum(numCells, 0.0);
+        std::vector<double> min(numCells, 0.0);
+        std::vector<double> max(numCells, 0.0);
+        std::vector<double> stdDev;
+        std::vector<double> median;
+        std::vector<double> mode;
+        
+        // Accumulate along each high resolution row into the cells it crosses.
+        for(unsigned int r = 0; r < numRows; ++r)
         {
-            if(this->sumStats.at(i) == rsgis::math::sumtype_min)
-            {
-                needBasic = true;
-            }
-            else if(this->sumStats.at(i) == rsgis::math::sumtype_max)
-            {
-                needBasic = true;
-            }
-            else if(this->sumStats.at(i) == rsgis::math::sumtype_mean)
-            {
-                needBasic = true;
-            }
-            else if(this->sumStats.at(i) == rsgis::math::sumtype_median)
-            {
-                throw RSGISImageCalcException("Sorry. Median is not yet implemented.");
-                needBasic = true;
-            }
-            else if(this->sumStats.at(i) == rsgis::math::sumtype_range)
-            {
-                needBasic = true;
-            }
-            else if(this->sumStats.at(i) == rsgis::math::sumtype_stddev)
-            {
-                needBasic = true;
-                needStdDev = true;
-            }
-            else if(this->sumStats.at(i) == rsgis::math::sumtype_sum)
+            size_t cellRowOff = ((size_t)r) * numCols;
+            for(unsigned int y = 0; y < nYPxls; ++y)
             {
-                needBasic = true;
-            }
-            else if(this->sumStats.at(i) == rsgis::math::sumtype_mode)
-            {
-                throw RSGISImageCalcException("Sorry. Mode is not yet implemented.");
-                needBasic = true;
+                const float *rowVals = highResVals + ((((size_t)r) * nYPxls) + y) * highResWidth;
+                for(unsigned int c = 0; c < numCols; ++c)
+                {
+                    const float *cellVals = rowVals + (((size_t)c) * nXPxls);
+                    size_t cellIdx = cellRowOff + c;
+                    double cellCount = count[cellIdx];
+                    double cellSum = sum[cellIdx];
+                    double cellMin = min[cellIdx];
+                    double cellMax = max[cellIdx];
+                    for(unsigned int x = 0; x < nXPxls; ++x)
+                    {
+                        double val = cellVals[x];
+                        if(useNoData && (cellVals[x] == noDataVal))
+                        {
+                            continue;
+                        }
+                        if(cellCount == 0)
+                        {
+                            cellMin = val;
+                            cellMax = val;
+                        }
+                        cellMin = (val < cellMin)?val:cellMin;
+                        cellMax = (val > cellMax)?val:cellMax;
+                        cellSum += val;
+                        cellCount += 1;
+                    }
+                    count[cellIdx] = cellCount;
+                    sum[cellIdx] = cellSum;
+                    min[cellIdx] = cellMin;
+                    max[cellIdx] = cellMax;
+                }
             }
-            else if(this->sumStats.at(i) == rsgis::math::sumtype_count)
+        }
+        
+        if(this->needStdDev)
+        {
+            std::vector<double> sqDiffSum(numCells, 0.0);
+            for(unsigned int r = 0; r < numRows; ++r)
             {
-                needBasic = true;
+                size_t cellRowOff = ((size_t)r) * numCols;
+                for(unsigned int y = 0; y < nYPxls; ++y)
+                {
+                    const float *rowVals = highResVals + ((((size_t)r) * nYPxls) + y) * highResWidth;
+                    for(unsigned int c = 0; c < numCols; ++c)
+                    {
+                        const float *cellVals = rowVals + (((size_t)c) * nXPxls);
+                        size_t cellIdx = cellRowOff + c;
+                        if(count[cellIdx] == 0)
+                        {
+                            continue;
+                        }
+                        double mean = sum[cellIdx] / count[cellIdx];
+                        double cellSqDiff = 0.0;
+                        for(unsigned int x = 0; x < nXPxls; ++x)
+                        {
+                            if(useNoData && (cellVals[x] == noDataVal))
+                            {
+                                continue;
+                            }
+                            double diff = cellVals[x] - mean;
+                            cellSqDiff += diff * diff;
+                        }
+                        sqDiffSum[cellIdx] += cellSqDiff;
+                    }
+                }
             }
-            else
+            stdDev.assign(numCells, 0.0);
+            for(size_t i = 0; i < numCells; ++i)
             {
-                throw RSGISImageCalcException("The summary type specified is unknown.");
+                if(count[i] > 0)
+                {
+                    stdDev[i] = std::sqrt(sqDiffSum[i] / count[i]);
+                }
             }
         }
         
-        double min = 0;
-        double max = 0;
-        double mean = 0;
-        double stdDev = 0;
-        double sum = 0;
-        double count = 0;
-        
-        if(needBasic)
+        if(this->needSorted)
         {
-            bool first = true;
-            
-            for(int i = 0; i < numInVals; ++i)
+            // The median and mode need the values of each cell, so they are
+            // gathered per cell and sorted.
+            median.assign(numCells, 0.0);
+            mode.assign(numCells, 0.0);
+            std::vector<float> cellVals;
+            cellVals.reserve(((size_t)nXPxls) * nYPxls);
+            for(unsigned int r = 0; r < numRows; ++r)
             {
-                if(!useNoData || (bandValues[i] != noDataVal))
+                for(unsigned int c = 0; c < numCols; ++c)
                 {
-                    if(first)
+                    size_t cellIdx = (((size_t)r) * numCols) + c;
+                    cellVals.clear();
+                    for(unsigned int y = 0; y < nYPxls; ++y)
                     {
-                        min = bandValues[i];
-                        max = bandValues[i];
-                        first = true;
+                        const float *rowVals = highResVals + ((((size_t)r) * nYPxls) + y) * highResWidth + (((size_t)c) * nXPxls);
+                        for(unsigned int x = 0; x < nXPxls; ++x)
+                        {
+                            if(!useNoData || (rowVals[x] != noDataVal))
+                            {
+                                cellVals.push_back(rowVals[x]);
+                            }
+                        }
                     }
-                    
-                    if(bandValues[i] < min)
+                    if(cellVals.empty())
                     {
-                        min = bandValues[i];
+                        continue;
                     }
                     
-                    if(bandValues[i] > max)
+                    std::sort(cellVals.begin(), cellVals.end());
+                    size_t nVals = cellVals.size();
+                    if((nVals % 2) == 0)
                     {
-                        max = bandValues[i];
+                        median[cellIdx] = (((double)cellVals[(nVals/2)-1]) + cellVals[nVals/2]) / 2.0;
+                    }
+                    else
+                    {
+                        median[cellIdx] = cellVals[nVals/2];
                     }
                     
-                    sum += bandValues[i];
-                    
-                    count = count + 1;
-                }
-            }
-            
-            mean = sum / count;
-            
-            if(needStdDev)
-            {
-                double sqDiffSum = 0.0;
-                for(int i = 0; i < numInVals; ++i)
-                {
-                    if(!useNoData || (bandValues[i] != noDataVal))
+                    // The longest run of equal values (the smallest value on a tie).
+                    size_t bestRun = 0;
+                    size_t runStart = 0;
+                    for(size_t i = 1; i <= nVals; ++i)
                     {
-                        sqDiffSum += ((bandValues[i] - mean) * (bandValues[i] - mean));
+                        if((i == nVals) || (cellVals[i] != cellVals[runStart]))
+                        {
+                            if((i - runStart) > bestRun)
+                            {
+                                bestRun = i - runStart;
+                                mode[cellIdx] = cellVals[runStart];
+                            }
+                            runStart = i;
+                        }
                     }
                 }
-                stdDev = std::sqrt(sqDiffSum);
             }
         }
         
-        for(int i = 0; i < this->sumStats.size(); ++i)
+        for(size_t i = 0; i < this->sumStats.size(); ++i)
         {
-            if(this->sumStats.at(i) == rsgis::math::sumtype_min)
-            {
-                output[i] = min;
-            }
-            else if(this->sumStats.at(i) == rsgis::math::sumtype_max)
-            {
-                output[i] = max;
-            }
-            else if(this->sumStats.at(i) == rsgis::math::sumtype_mean)
-            {
-                output[i] = mean;
-            }
-            else if(this->sumStats.at(i) == rsgis::math::sumtype_median)
-            {
-                throw RSGISImageCalcException("Sorry. Median is not yet implemented.");
-                //output[i] = min;
-            }
-            else if(this->sumStats.at(i) == rsgis::math::sumtype_range)
-            {
-                output[i] = max - min;
-            }
-            else if(this->sumStats.at(i) == rsgis::math::sumtype_stddev)
-            {
-                output[i] = stdDev;
-            }
-            else if(this->sumStats.at(i) == rsgis::math::sumtype_sum)
-            {
-                output[i] = sum;
-            }
-            else if(this->sumStats.at(i) == rsgis::math::sumtype_mode)
+            double *outPlane = outPlanes[i];
+            for(size_t n = 0; n < numCells; ++n)
             {
-                throw RSGISImageCalcException("Sorry. Mode is not yet implemented.");
-                //output[i] = min;
-            }
-            else if(this->sumStats.at(i) == rsgis::math::sumtype_count)
-            {
-                output[i] = count;
-            }
-            else
-            {
-                throw RSGISImageCalcException("The summary type specified is unknown.");
+                double out = 0.0;
+                if(count[n] > 0)
+                {
+                    switch(this->sumStats.at(i))
+                    {
+                        case rsgis::math::sumtype_min:
+                            out = min[n];
+                            break;
+                        case rsgis::math::sumtype_max:
+                            out = max[n];
+                            break;
+                        case rsgis::math::sumtype_mean:
+                            out = sum[n] / count[n];
+                            break;
+                        case rsgis::math::sumtype_median:
+                            out = median[n];
+                            break;
+                        case rsgis::math::sumtype_range:
+                            out = max[n] - min[n];
+                            break;
+                        case rsgis::math::sumtype_stddev:
+                            out = stdDev[n];
+                            break;
+                        case rsgis::math::sumtype_sum:
+                            out = sum[n];
+                            break;
+                        case rsgis::math::sumtype_mode:
+                            out = mode[n];
+                            break;
+                        case rsgis::math::sumtype_count:
+                            out = count[n];
+                            break;
+                        default:
+                            throw RSGISImageCalcException("The summary type specified is unknown.");
+                    }
+                }
+                outPlane[n] = out;
             }
         }
     }
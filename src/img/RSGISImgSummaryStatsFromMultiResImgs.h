@@ -25,6 +25,8 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <algorithm>
 #include <math.h>
 
 #include "common/RSGISImageException.h"
@@ -61,14 +63,27 @@ namespace rsgis{namespace img{
     
     
     
+    /**
+     * Summary statistics (min, max, mean, range, stddev, sum, count, median
+     * and mode) of the high resolution pixels within each low resolution
+     * pixel. Blocks are reduced a high resolution row at a time into the
+     * per-cell count, sum, min and max, with the standard deviation (of the
+     * population) from a second pass and the median and mode from the
+     * sorted values of each cell, only gathered when they are requested.
+     * Cells with no valid pixels are 0.
+     */
     class DllExport RSGISCalcHighResImgSummaryStats : public rsgis::img::RSGISCalcValuesFromMultiResInputs
     {
     public:
         RSGISCalcHighResImgSummaryStats(int numberOutBands, std::vector<rsgis::math::rsgissummarytype> sumStats);
         void calcImageValue(float *bandValues, int numInVals, bool useNoData, float noDataVal, double *output);
+        void calcLowResBlock(const float *highResVals, unsigned int numCols, unsigned int numRows, unsigned int nXPxls, unsigned int nYPxls, bool useNoData, float noDataVal, double **outPlanes);
+        bool isThreadSafe(){return true;};
         ~RSGISCalcHighResImgSummaryStats();
     protected:
         std::vector<rsgis::math::rsgissummarytype> sumStats;
+        bool needStdDev;
+        bool needSorted;
     };
     
     
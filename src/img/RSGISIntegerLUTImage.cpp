@@ -0,0 +1,368 @@
+/*
+ *  RSGISIntegerLUTImage.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISIntegerLUTImage.h"
+
+namespace rsgis{namespace img{
+
+    RSGISIntegerLUTImage::RSGISIntegerLUTImage(unsigned int numOutBands, int lutMin, unsigned int lutSize)
+    {
+        if(lutSize == 0)
+        {
+            throw RSGISImageCalcException("The lookup table must have at least one value.");
+        }
+        this->numOutBands = numOutBands;
+        this->lutMin = lutMin;
+        this->lutSize = lutSize;
+        this->inBands.assign(numOutBands, 0);
+        this->luts.assign(numOutBands, std::vector<double>(lutSize, 0));
+    }
+
+    void RSGISIntegerLUTImage::setBandLUT(unsigned int outBand, unsigned int inBand, const std::vector<double> &lut)
+    {
+        if(outBand >= this->numOutBands)
+        {
+            throw RSGISImageCalcException("The output band is not within the lookup tables.");
+        }
+        if(lut.size() != this->lutSize)
+        {
+            throw RSGISImageCalcException("The lookup table is not the expected size.");
+        }
+        this->inBands[outBand] = inBand;
+        this->luts[outBand] = lut;
+    }
+
+    void RSGISIntegerLUTImage::apply(GDALDataset *inData, std::string outputImage, std::string imageFormat, GDALDataType outDataType)
+    {
+        RSGISImageUtils imgUtils;
+        GDALDataset *outData = NULL;
+        try
+        {
+            outData = imgUtils.createCopy(inData, this->numOutBands, outputImage, imageFormat, outDataType);
+        }
+        catch(rsgis::RSGISImageException &e)
+        {
+            throw RSGISImageCalcException(e.what());
+        }
+
+        try
+        {
+            this->apply(inData, outData);
+        }
+        catch(RSGISImageCalcException &e)
+        {
+            GDALClose(outData);
+            throw e;
+        }
+        GDALClose(outData);
+    }
+
+    void RSGISIntegerLUTImage::apply(GDALDataset *inData, GDALDataset *outData)
+    {
+        if((inData->GetRasterXSize() != outData->GetRasterXSize()) || (inData->GetRasterYSize() != outData->GetRasterYSize()))
+        {
+            throw RSGISImageCalcException("The input and output images must be the same size.");
+        }
+        if(((unsigned int)outData->GetRasterCount()) != this->numOutBands)
+        {
+            throw RSGISImageCalcException("The output image does not have the number of bands of the lookup tables.");
+        }
+        for(unsigned int i = 0; i < this->numOutBands; ++i)
+        {
+            if(this->inBands[i] >= ((unsigned int)inData->GetRasterCount()))
+            {
+                throw RSGISImageCalcException("A lookup table refers to a band which is not in the input image.");
+            }
+        }
+
+        switch(getReadType(inData))
+        {
+            case GDT_Byte:
+                this->applyInType<unsigned char>(inData, outData);
+                break;
+            case GDT_UInt16:
+                this->applyInType<unsigned short>(inData, outData);
+                break;
+            case GDT_Int16:
+                this->applyInType<short>(inData, outData);
+                break;
+            case GDT_Int32:
+                this->applyInType<int>(inData, outData);
+                break;
+            default:
+                throw RSGISImageCalcException("A lookup table can only be applied to an 8 or 16 bit integer image.");
+        }
+    }
+
+    template <typename InT>
+    void RSGISIntegerLUTImage::applyInType(GDALDataset *inData, GDALDataset *outData)
+    {
+        // The output bands share a type (as they are created) so the first is used.
+        switch(outData->GetRasterBand(1)->GetRasterDataType())
+        {
+            case GDT_Byte:
+                this->applyTypes<InT, unsigned char>(inData, outData);
+                break;
+            case GDT_UInt16:
+                this->applyTypes<InT, unsigned short>(inData, outData);
+                break;
+            case GDT_Int16:
+                this->applyTypes<InT, short>(inData, outData);
+                break;
+            case GDT_UInt32:
+                this->applyTypes<InT, unsigned int>(inData, outData);
+                break;
+            case GDT_Int32:
+                this->applyTypes<InT, int>(inData, outData);
+                break;
+            case GDT_Float32:
+                this->applyTypes<InT, float>(inData, outData);
+                break;
+            default:
+                this->applyTypes<InT, double>(inData, outData);
+                break;
+        }
+    }
+
+    template <typename InT, typename OutT>
+    void RSGISIntegerLUTImage::applyTypes(GDALDataset *inData, GDALDataset *outData)
+    {
+        int width = inData->GetRasterXSize();
+        int height = inData->GetRasterYSize();
+        int yBlockSize = getBlockRows(inData);
+        size_t numBlockPxls = ((size_t)width) * yBlockSize;
+        GDALDataType inGDALType = RSGISGDALPixelType<InT>::gdalType();
+        GDALDataType outGDALType = RSGISGDALPixelType<OutT>::gdalType();
+
+        // The tables are converted to the output type once.
+        std::vector< std::vector<OutT> > outLUTs(this->numOutBands);
+        for(unsigned int i = 0; i < this->numOutBands; ++i)
+        {
+            outLUTs[i].resize(this->lutSize);
+            for(unsigned int j = 0; j < this->lutSize; ++j)
+            {
+                outLUTs[i][j] = rsgisConvertPixelValue<OutT>(this->luts[i][j]);
+            }
+        }
+
+        // Each input band is only read once however many output bands use it.
+        unsigned int numInBands = inData->GetRasterCount();
+        std::vector<bool> bandUsed(numInBands, false);
+        for(unsigned int i = 0; i < this->numOutBands; ++i)
+        {
+            bandUsed[this->inBands[i]] = true;
+        }
+        std::vector< std::vector<InT> > inBlocks(numInBands);
+        for(unsigned int n = 0; n < numInBands; ++n)
+        {
+            if(bandUsed[n])
+            {
+                inBlocks[n].resize(numBlockPxls);
+            }
+        }
+        std::vector<OutT> outBlock(numBlockPxls);
+
+        const int maxIdx = this->lutSize - 1;
+        const int lutOff = this->lutMin;
+        rsgis_tqdm pbar;
+        for(int yOff = 0; yOff < height; yOff += yBlockSize)
+        {
+            int nRows = std::min(yBlockSize, height - yOff);
+            size_t nPxls = ((size_t)width) * nRows;
+            pbar.progress(yOff, height);
+            for(unsigned int n = 0; n < numInBands; ++n)
+            {
+                if(bandUsed[n] && (inData->GetRasterBand(n+1)->RasterIO(GF_Read, 0, yOff, width, nRows, inBlocks[n].data(), width, nRows, inGDALType, 0, 0) != CE_None))
+                {
+                    throw RSGISImageCalcException("Could not read a block from the input image.");
+                }
+            }
+            for(unsigned int i = 0; i < this->numOutBands; ++i)
+            {
+                const InT *inPxls = inBlocks[this->inBands[i]].data();
+                const OutT *lut = outLUTs[i].data();
+                OutT *outPxls = outBlock.data();
+                for(size_t j = 0; j < nPxls; ++j)
+                {
+                    // Branch free (a gather from the table) so the loop can be vectorised.
+                    int idx = ((int)inPxls[j]) - lutOff;
+                    idx = (idx < 0)?0:idx;
+                    idx = (idx > maxIdx)?maxIdx:idx;
+                    outPxls[j] = lut[idx];
+                }
+                if(outData->GetRasterBand(i+1)->RasterIO(GF_Write, 0, yOff, width, nRows, outBlock.data(), width, nRows, outGDALType, 0, 0) != CE_None)
+                {
+                    throw RSGISImageCalcException("Could not write a block to the output image.");
+                }
+            }
+        }
+        pbar.finish();
+    }
+
+    bool RSGISIntegerLUTImage::getIntegerRange(GDALDataType dataType, int *lutMin, unsigned int *lutSize)
+    {
+        switch(dataType)
+        {
+            case GDT_Byte:
+                *lutMin = 0;
+                *lutSize = 256;
+                return true;
+            case GDT_UInt16:
+                *lutMin = 0;
+                *lutSize = 65536;
+                return true;
+            case GDT_Int16:
+                *lutMin = -32768;
+                *lutSize = 65536;
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    bool RSGISIntegerLUTImage::getIntegerRange(GDALDataset *inData, int *lutMin, unsigned int *lutSize)
+    {
+        long minVal = 0;
+        long maxVal = 0;
+        int bandMin = 0;
+        unsigned int bandSize = 0;
+        for(int n = 0; n < inData->GetRasterCount(); ++n)
+        {
+            if(!getIntegerRange(inData->GetRasterBand(n+1)->GetRasterDataType(), &bandMin, &bandSize))
+            {
+                return false;
+            }
+            minVal = std::min<long>(minVal, bandMin);
+            maxVal = std::max<long>(maxVal, ((long)bandMin) + bandSize - 1);
+        }
+        *lutMin = (int)minVal;
+        *lutSize = (unsigned int)((maxVal - minVal) + 1);
+        return true;
+    }
+
+    void RSGISIntegerLUTImage::calcHistograms(GDALDataset *inData, int lutMin, unsigned int lutSize, std::vector< std::vector<unsigned long long> > *hists)
+    {
+        switch(getReadType(inData))
+        {
+            case GDT_Byte:
+                calcHistogramsInType<unsigned char>(inData, lutMin, lutSize, hists);
+                break;
+            case GDT_UInt16:
+                calcHistogramsInType<unsigned short>(inData, lutMin, lutSize, hists);
+                break;
+            case GDT_Int16:
+                calcHistogramsInType<short>(inData, lutMin, lutSize, hists);
+                break;
+            case GDT_Int32:
+                calcHistogramsInType<int>(inData, lutMin, lutSize, hists);
+                break;
+            default:
+                throw RSGISImageCalcException("An integer histogram can only be calculated for an 8 or 16 bit integer image.");
+        }
+    }
+
+    template <typename InT>
+    void RSGISIntegerLUTImage::calcHistogramsInType(GDALDataset *inData, int lutMin, unsigned int lutSize, std::vector< std::vector<unsigned long long> > *hists)
+    {
+        int width = inData->GetRasterXSize();
+        int height = inData->GetRasterYSize();
+        int numBands = inData->GetRasterCount();
+        int yBlockSize = getBlockRows(inData);
+        GDALDataType inGDALType = RSGISGDALPixelType<InT>::gdalType();
+
+        hists->assign(numBands, std::vector<unsigned long long>(lutSize, 0));
+        std::vector<InT> inBlock(((size_t)width) * yBlockSize);
+        const long maxVal = ((long)lutMin) + lutSize - 1;
+        for(int n = 0; n < numBands; ++n)
+        {
+            GDALRasterBand *band = inData->GetRasterBand(n+1);
+            unsigned long long *hist = hists->at(n).data();
+            for(int yOff = 0; yOff < height; yOff += yBlockSize)
+            {
+                int nRows = std::min(yBlockSize, height - yOff);
+                size_t nPxls = ((size_t)width) * nRows;
+                if(band->RasterIO(GF_Read, 0, yOff, width, nRows, inBlock.data(), width, nRows, inGDALType, 0, 0) != CE_None)
+                {
+                    throw RSGISImageCalcException("Could not read a block from the input image.");
+                }
+                for(size_t j = 0; j < nPxls; ++j)
+                {
+                    long val = (long)inBlock[j];
+                    if((val >= lutMin) && (val <= maxVal))
+                    {
+                        ++hist[val - lutMin];
+                    }
+                }
+            }
+        }
+    }
+
+    GDALDataType RSGISIntegerLUTImage::getReadType(GDALDataset *inData)
+    {
+        // The smallest type holding the values of all the bands.
+        bool allByte = true;
+        bool anyUInt16 = false;
+        bool anyInt16 = false;
+        for(int n = 0; n < inData->GetRasterCount(); ++n)
+        {
+            GDALDataType dataType = inData->GetRasterBand(n+1)->GetRasterDataType();
+            if(dataType == GDT_UInt16)
+            {
+                anyUInt16 = true;
+            }
+            else if(dataType == GDT_Int16)
+            {
+                anyInt16 = true;
+            }
+            else if(dataType != GDT_Byte)
+            {
+                return GDT_Unknown;
+            }
+            allByte = allByte && (dataType == GDT_Byte);
+        }
+        if(allByte)
+        {
+            return GDT_Byte;
+        }
+        if(anyUInt16 && anyInt16)
+        {
+            return GDT_Int32;
+        }
+        return anyInt16?GDT_Int16:GDT_UInt16;
+    }
+
+    int RSGISIntegerLUTImage::getBlockRows(GDALDataset *inData)
+    {
+        // Whole rows of the native blocks, at least 256 rows at a time.
+        int xBlockSize = 0;
+        int yBlockSize = 0;
+        inData->GetRasterBand(1)->GetBlockSize(&xBlockSize, &yBlockSize);
+        yBlockSize = std::max(yBlockSize, 1);
+        yBlockSize = ((255 / yBlockSize) + 1) * yBlockSize;
+        return std::max(std::min(yBlockSize, inData->GetRasterYSize()), 1);
+    }
+
+    RSGISIntegerLUTImage::~RSGISIntegerLUTImage()
+    {
+
+    }
+
+}}
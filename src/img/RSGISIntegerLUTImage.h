@@ -0,0 +1,109 @@
+/*
+ *  RSGISIntegerLUTImage.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISIntegerLUTImage_H
+#define RSGISIntegerLUTImage_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "gdal_priv.h"
+
+#include "common/RSGISImageException.h"
+#include "common/rsgis-tqdm.h"
+
+#include "img/RSGISImageCalcException.h"
+#include "img/RSGISImageUtils.h"
+#include "img/RSGISImageNativeIO.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_img_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace img{
+
+    /**
+     * Maps an 8 or 16 bit integer image through a lookup table, with a table
+     * of lutSize values (for the input values lutMin to lutMin+lutSize-1) for
+     * each output band, each output band taking its values from one of the
+     * input bands (so a single band can be expanded to RGB). The blocks are
+     * read and written in their native data types and each pixel is a
+     * single (branch free) gather from the table, so there is no per-pixel
+     * function call and no double precision copy of the output. Input values
+     * outside the table are clamped to it.
+     */
+    class DllExport RSGISIntegerLUTImage
+    {
+    public:
+        RSGISIntegerLUTImage(unsigned int numOutBands, int lutMin, unsigned int lutSize);
+        /// Set the table (of lutSize values) for output band outBand, looked up with input band inBand (both from 0)
+        void setBandLUT(unsigned int outBand, unsigned int inBand, const std::vector<double> &lut);
+        unsigned int getNumOutBands(){return this->numOutBands;};
+        int getLUTMin(){return this->lutMin;};
+        unsigned int getLUTSize(){return this->lutSize;};
+        /// Apply the tables to inData, writing to outData (which must be the same size with numOutBands bands)
+        void apply(GDALDataset *inData, GDALDataset *outData);
+        /// Apply the tables to inData, creating the output image
+        void apply(GDALDataset *inData, std::string outputImage, std::string imageFormat, GDALDataType outDataType);
+        /**
+         * Whether the band data type can be looked up (8 or 16 bit
+         * integers) and, if so, the range of values it has.
+         */
+        static bool getIntegerRange(GDALDataType dataType, int *lutMin, unsigned int *lutSize);
+        /**
+         * Whether all the bands of the image can be looked up and, if so, the
+         * range of values covering all of them.
+         */
+        static bool getIntegerRange(GDALDataset *inData, int *lutMin, unsigned int *lutSize);
+        /**
+         * The histogram of each band of an 8 or 16 bit integer image, with a bin
+         * for each of the values lutMin to lutMin+lutSize-1 (values outside the
+         * range are ignored).
+         */
+        static void calcHistograms(GDALDataset *inData, int lutMin, unsigned int lutSize, std::vector< std::vector<unsigned long long> > *hists);
+        ~RSGISIntegerLUTImage();
+    protected:
+        template <typename InT> void applyInType(GDALDataset *inData, GDALDataset *outData);
+        template <typename InT, typename OutT> void applyTypes(GDALDataset *inData, GDALDataset *outData);
+        template <typename InT> static void calcHistogramsInType(GDALDataset *inData, int lutMin, unsigned int lutSize, std::vector< std::vector<unsigned long long> > *hists);
+        static GDALDataType getReadType(GDALDataset *inData);
+        static int getBlockRows(GDALDataset *inData);
+        unsigned int numOutBands;
+        int lutMin;
+        unsigned int lutSize;
+        std::vector<unsigned int> inBands;
+        std::vector< std::vector<double> > luts;
+    };
+
+}}
+
+#endif
@@ -68,21 +68,19 @@ namespace rsgis{namespace img{
             {
                 throw RSGISImageCalcException(gsl_strerror(status));
             }
-            
-            gsl_vector *b = gsl_vector_alloc(endmembers->size1);
-            gsl_vector *x = gsl_vector_alloc(endmembers->size2);
-            
-            RSGISUnconstrainedLinearSpectralUnmixing *calcUnconstrained = new RSGISUnconstrainedLinearSpectralUnmixing(endmembers->size2, endmembers, V, S, work, b, x, this->gain, this->offset);
-            RSGISCalcImage calcImage(calcUnconstrained);
-            calcImage.calcImage(datasets, numDatasets, outputImage, false, NULL, gdalFormat, gdalDataType);
+            gsl_matrix *pseudoInverse = RSGISPseudoInverseLinearSpectralUnmixing::calcPseudoInverse(endmembers, V, S);
             
             gsl_matrix_free(endmembers);
             gsl_matrix_free(V);
             gsl_vector_free(S);
             gsl_vector_free(work);
-            gsl_vector_free(b);
-            gsl_vector_free(x);
             
+            RSGISUnconstrainedLinearSpectralUnmixing *calcUnconstrained = new RSGISUnconstrainedLinearSpectralUnmixing(pseudoInverse, this->gain, this->offset);
+            gsl_matrix_free(pseudoInverse);
+            RSGISCalcImage calcImage(calcUnconstrained);
+            calcImage.calcImage(datasets, numDatasets, outputImage, false, NULL, gdalFormat, gdalDataType);
+            
+            delete calcUnconstrained;
         }
         catch(RSGISException &e)
         {
@@ -141,22 +139,20 @@ namespace rsgis{namespace img{
             {
                 throw RSGISImageCalcException(gsl_strerror(status));
             }
-            
-            gsl_vector *b = gsl_vector_alloc(endmembers->size1);
-            gsl_vector *x = gsl_vector_alloc(endmembers->size2);
-            
-            RSGISPartConstrainedLinearSpectralUnmixing *calcPartConstrained = new RSGISPartConstrainedLinearSpectralUnmixing(endmembers->size2, weight, endmembers, V, S, work, b, x, this->gain, this->offset);
-            RSGISCalcImage calcImage(calcPartConstrained);
-            calcImage.calcImage(datasets, numDatasets, outputImage, false, NULL, gdalFormat, gdalDataType);
+            gsl_matrix *pseudoInverse = RSGISPseudoInverseLinearSpectralUnmixing::calcPseudoInverse(endmembers, V, S);
             
             gsl_matrix_free(endmembersIn);
             gsl_matrix_free(endmembers);
             gsl_matrix_free(V);
             gsl_vector_free(S);
             gsl_vector_free(work);
-            gsl_vector_free(b);
-            gsl_vector_free(x);
             
+            RSGISPartConstrainedLinearSpectralUnmixing *calcPartConstrained = new RSGISPartConstrainedLinearSpectralUnmixing(pseudoInverse, weight, this->gain, this->offset);
+            gsl_matrix_free(pseudoInverse);
+            RSGISCalcImage calcImage(calcPartConstrained);
+            calcImage.calcImage(datasets, numDatasets, outputImage, false, NULL, gdalFormat, gdalDataType);
+            
+            delete calcPartConstrained;
         }
         catch(RSGISException &e)
         {
@@ -174,7 +170,6 @@ namespace rsgis{namespace img{
                 numOfImageBands += datasets[i]->GetRasterCount();
             }            
             
-            rsgis::math::RSGISVectors vecUtils;
             rsgis::math::RSGISMatrices matrixUtils;
             gsl_matrix *endmembersIn = matrixUtils.readGSLMatrixFromTxt(endmembersFilePath);
             matrixUtils.printGSLMatrix(endmembersIn);
@@ -182,6 +177,7 @@ namespace rsgis{namespace img{
             
             if(endmembersIn->size1 != numOfImageBands)
             {
+                gsl_matrix_free(endmembersIn);
                 throw RSGISImageCalcException("The number of image bands and wavelengths within the endmemebers should match.");
             }
             
@@ -190,93 +186,13 @@ namespace rsgis{namespace img{
                 gsl_matrix_free(endmembersIn);
                 throw RSGISImageCalcException("The number of endmember samples should be less than the number of input image bands.");
             }
-                                    
-            int m = endmembersIn->size1+1;
-            int n = endmembersIn->size2;
-            
-            std::cout << "m = " << m << std::endl;
-            std::cout << "n = " << n << std::endl;
-            
-            int mda = m;
-            
-            double* a = new double[m*n];
-            double *b = new double[m];
-            double *x = new double[n];
-            double rNorm = 0;
-            double *w = new double[n];
-            double *zz = new double[m];
-            int *index = new int[n];
-            int mode = 0;
-            
-            for(unsigned int i = 0; i < endmembersIn->size1; ++i)
-            {
-                for(unsigned int j = 0; j < endmembersIn->size2; ++j)
-                {
-                    a[(i*endmembersIn->size2)+j] = gsl_matrix_get(endmembersIn, i, j);
-                }
-            }
-            for(unsigned int j = 0; j < endmembersIn->size2; ++j)
-            {
-                a[(endmembersIn->size1*endmembersIn->size2)+j] = weight;
-            }
-            
-            for(unsigned int i = 0; i < m; ++i)
-            {
-                for(unsigned int j = 0; j < n; ++j)
-                {
-                    if( j == 0 )
-                    {
-                        std::cout << a[(i*n)+j];
-                    }
-                    else
-                    {
-                        std::cout << "," << a[(i*n)+j];
-                    }
-                }
-                std::cout << "\n";
-            }
-            
-            float e1 = 0.5;
-            float e2 = 0.2;
-            float e3 = 0.3;
-            b[0] = ((50.4*e1)+(29.45*e2)+(209.964*e3));
-            b[1] = ((81.85*e1)+(65.45*e2)+(244.321*e3));
-            b[2] = ((107.85*e1)+(23.4*e2)+(267.25*e3));
-            b[3] = ((177.1*e1)+(112.8*e2)+(278.679*e3));
-            b[4] = ((281.35*e1)+(524.2*e2)+(305.429*e3));
-            b[5] = ((324.2*e1)+(653.25*e2)+(299.036*e3));
-            b[6] = ((362.45*e1)+(680.6*e2)+(309.036*e3));
-            b[7] = ((394.55*e1)+(692.25*e2)+(303.036*e3));
-            b[8] = ((404.55*e1)+(258.6*e2)+(301.143*e3));
-            b[9] = ((237.25*e1)+(114.35*e2)+(273.643*e3));
-            b[10] = weight;
-            
-            /*
-            50.4,29.45,209.964
-            81.85,65.45,244.321
-            107.85,23.4,267.25
-            177.1,112.8,278.679
-             281.35,524.2,305.429
-             324.2,653.25,299.036
-             362.45,680.6,309.036
-             394.55,692.25,303.036
-             404.55,258.6,301.143
-             237.25,114.35,273.643
-            */
-            std::cout << "B: [" << b[0] << "," << b[1] << "," << b[2] << "," << b[3] << "," << b[4] << "," << b[5] << "," << b[6] << "," << b[7] << "," << b[8] << "," << b[9] << "," << b[10] << "]\n";
             
-            rsgis::math::RSGISNNLS nnls;
-            
-            //double* a, int* mda, int* m, int* n, double* b, double* x, double* rnorm, double* w, double* zz, int* index, int* mode
-            
-            int outVal = nnls.nnls_c(a, &mda, &m, &n, b, x, &rNorm, w, zz, index, &mode); 
-            std::cout << "outVal = " << outVal << std::endl;
-            std::cout << "rNorm = " << rNorm << std::endl;
-            std::cout << "mode = " << mode << std::endl;
+            RSGISNNConstrainedLinearSpectralUnmixing *calcNNConstrained = new RSGISNNConstrainedLinearSpectralUnmixing(endmembersIn, weight, this->gain, this->offset);
+            gsl_matrix_free(endmembersIn);
+            RSGISCalcImage calcImage(calcNNConstrained);
+            calcImage.calcImage(datasets, numDatasets, outputImage, false, NULL, gdalFormat, gdalDataType);
             
-            std::cout << "E: [" << e1 << "," << e2 << "," << e3 << "]\n";
-            std::cout << "X: [" << x[0] << "," << x[1] << "," << x[2] << "]\n";
-                        
+            delete calcNNConstrained;
         }
         catch(RSGISException &e)
         {
@@ -340,116 +256,254 @@ namespace rsgis{namespace img{
     }
     
     
-    RSGISUnconstrainedLinearSpectralUnmixing::RSGISUnconstrainedLinearSpectralUnmixing(int numberOutBands, gsl_matrix *endmembers, gsl_matrix *V, gsl_vector *S, gsl_vector *work, gsl_vector *b, gsl_vector *x, float gain, float offset):RSGISCalcImageValue(numberOutBands)
+    const size_t RSGISPseudoInverseLinearSpectralUnmixing::pxlChunkSize = 4096;
+
+    RSGISPseudoInverseLinearSpectralUnmixing::RSGISPseudoInverseLinearSpectralUnmixing(const gsl_matrix *pseudoInverse, unsigned int numInBands, const double *constTerm, float gain, float offset):RSGISCalcImageValue(pseudoInverse->size1)
     {
-        this->endmembers = endmembers;
-        this->V = V;
-        this->S = S;
-        this->work = work;
-        this->b = b;
-        this->x = x;
+        if(numInBands > pseudoInverse->size2)
+        {
+            throw RSGISImageCalcException("The pseudo-inverse has fewer columns than the number of input image bands.");
+        }
+        this->numInBands = numInBands;
+        this->pseudoInverse = gsl_matrix_alloc(pseudoInverse->size1, numInBands);
+        gsl_matrix_const_view bandCols = gsl_matrix_const_submatrix(pseudoInverse, 0, 0, pseudoInverse->size1, numInBands);
+        gsl_matrix_memcpy(this->pseudoInverse, &bandCols.matrix);
+        this->constTerm.assign(pseudoInverse->size1, 0.0);
+        if(constTerm != NULL)
+        {
+            this->constTerm.assign(constTerm, constTerm + pseudoInverse->size1);
+        }
         this->gain = gain;
         this->offset = offset;
     }
-        
-    void RSGISUnconstrainedLinearSpectralUnmixing::calcImageValue(float *bandValues, int numBands, double *output) 
+
+    void RSGISPseudoInverseLinearSpectralUnmixing::calcImageValue(float *bandValues, int numBands, double *output)
     {
-        try 
+        if(numBands != this->numInBands)
         {
-            if(b->size != numBands)
-            {
-                throw RSGISImageCalcException("The size vector of for the input data is not equal to the number image bands.");
-            }
-            
-            if(x->size != this->numOutBands)
+            throw RSGISImageCalcException("The size vector of for the input data is not equal to the number image bands.");
+        }
+
+        for(int j = 0; j < this->numOutBands; ++j)
+        {
+            const double *pinvRow = gsl_matrix_const_ptr(this->pseudoInverse, j, 0);
+            double x = this->constTerm[j];
+            for(int i = 0; i < numBands; ++i)
             {
-                throw RSGISImageCalcException("The size of the output vector is not the same of the number of output image bands.");
+                x += pinvRow[i] * bandValues[i];
             }
-            
+            output[j] = offset + (x*gain);
+        }
+    }
+
+    void RSGISPseudoInverseLinearSpectralUnmixing::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        if(numBands != this->numInBands)
+        {
+            throw RSGISImageCalcException("The size vector of for the input data is not equal to the number image bands.");
+        }
+
+        // Unmix chunks of pixels as X (endmembers x pixels) = P (endmembers x bands) . B (bands x pixels)
+        // so the chunk buffers stay in cache.
+        rsgis::RSGISScratchScope scratch(this->getScratchArena());
+        size_t chunkSize = std::min(nPxls, pxlChunkSize);
+        double *bVals = scratch.alloc<double>(this->numInBands * chunkSize);
+        double *xVals = scratch.alloc<double>(this->numOutBands * chunkSize);
+
+        for(size_t start = 0; start < nPxls; start += chunkSize)
+        {
+            size_t nChunk = std::min(chunkSize, nPxls - start);
             for(int i = 0; i < numBands; ++i)
             {
-                gsl_vector_set(b, i, bandValues[i]);
+                const float *inPlane = bandPlanes[i] + start;
+                double *bRow = bVals + (i * nChunk);
+                for(size_t p = 0; p < nChunk; ++p)
+                {
+                    bRow[p] = inPlane[p];
+                }
             }
-            
-            int status = gsl_linalg_SV_solve(endmembers, V, S, b, x);
+
+            gsl_matrix_view bMat = gsl_matrix_view_array(bVals, this->numInBands, nChunk);
+            gsl_matrix_view xMat = gsl_matrix_view_array(xVals, this->numOutBands, nChunk);
+            int status = gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, this->pseudoInverse, &bMat.matrix, 0.0, &xMat.matrix);
             if(status != 0)
             {
                 throw RSGISImageCalcException(gsl_strerror(status));
             }
-            
-            for(int i = 0; i < x->size; ++i)
+
+            for(int j = 0; j < this->numOutBands; ++j)
             {
-                output[i] = offset + (gsl_vector_get(x, i)*gain);
+                const double *xRow = xVals + (j * nChunk);
+                double *outPlane = outPlanes[j] + start;
+                double constVal = this->constTerm[j];
+                for(size_t p = 0; p < nChunk; ++p)
+                {
+                    outPlane[p] = offset + ((xRow[p] + constVal)*gain);
+                }
             }
         }
-        catch (RSGISImageCalcException &e) 
+    }
+
+    gsl_matrix* RSGISPseudoInverseLinearSpectralUnmixing::calcPseudoInverse(const gsl_matrix *U, const gsl_matrix *V, const gsl_vector *S)
+    {
+        // P = V.diag(1/S).U'
+        gsl_matrix *VSInv = gsl_matrix_alloc(V->size1, V->size2);
+        gsl_matrix_memcpy(VSInv, V);
+        for(size_t k = 0; k < S->size; ++k)
+        {
+            double s = gsl_vector_get(S, k);
+            gsl_vector_view col = gsl_matrix_column(VSInv, k);
+            gsl_vector_scale(&col.vector, (s != 0.0)?(1.0/s):0.0);
+        }
+        gsl_matrix *pseudoInverse = gsl_matrix_alloc(V->size1, U->size1);
+        int status = gsl_blas_dgemm(CblasNoTrans, CblasTrans, 1.0, VSInv, U, 0.0, pseudoInverse);
+        gsl_matrix_free(VSInv);
+        if(status != 0)
         {
-            throw e;
+            gsl_matrix_free(pseudoInverse);
+            throw RSGISImageCalcException(gsl_strerror(status));
         }
+        return pseudoInverse;
     }
-    
+
+    RSGISPseudoInverseLinearSpectralUnmixing::~RSGISPseudoInverseLinearSpectralUnmixing()
+    {
+        gsl_matrix_free(this->pseudoInverse);
+    }
+
+
+    RSGISUnconstrainedLinearSpectralUnmixing::RSGISUnconstrainedLinearSpectralUnmixing(const gsl_matrix *pseudoInverse, float gain, float offset):RSGISPseudoInverseLinearSpectralUnmixing(pseudoInverse, pseudoInverse->size2, NULL, gain, offset)
+    {
+
+    }
+
     RSGISUnconstrainedLinearSpectralUnmixing::~RSGISUnconstrainedLinearSpectralUnmixing()
     {
-        
+
     }
-    
-    
-    RSGISPartConstrainedLinearSpectralUnmixing::RSGISPartConstrainedLinearSpectralUnmixing(int numberOutBands, float weight, gsl_matrix *endmembers, gsl_matrix *V, gsl_vector *S, gsl_vector *work, gsl_vector *b, gsl_vector *x, float gain, float offset):RSGISCalcImageValue(numberOutBands)
+
+
+    RSGISPartConstrainedLinearSpectralUnmixing::RSGISPartConstrainedLinearSpectralUnmixing(const gsl_matrix *pseudoInverse, float weight, float gain, float offset):RSGISPseudoInverseLinearSpectralUnmixing(pseudoInverse, pseudoInverse->size2-1, &calcWeightTerm(pseudoInverse, weight)[0], gain, offset)
+    {
+
+    }
+
+    std::vector<double> RSGISPartConstrainedLinearSpectralUnmixing::calcWeightTerm(const gsl_matrix *pseudoInverse, float weight)
+    {
+        // The last element of b is always the weight so its contribution is constant.
+        std::vector<double> weightTerm(pseudoInverse->size1);
+        for(size_t j = 0; j < pseudoInverse->size1; ++j)
+        {
+            weightTerm[j] = gsl_matrix_get(pseudoInverse, j, pseudoInverse->size2-1) * weight;
+        }
+        return weightTerm;
+    }
+
+    RSGISPartConstrainedLinearSpectralUnmixing::~RSGISPartConstrainedLinearSpectralUnmixing()
+    {
+
+    }
+
+
+    RSGISNNConstrainedLinearSpectralUnmixing::RSGISNNConstrainedLinearSpectralUnmixing(const gsl_matrix *endmembers, float weight, float gain, float offset):RSGISCalcImageValue(endmembers->size2)
     {
+        this->numRows = endmembers->size1+1;
+        this->numEndmembers = endmembers->size2;
         this->weight = weight;
-        this->endmembers = endmembers;
-        this->V = V;
-        this->S = S;
-        this->work = work;
-        this->b = b;
-        this->x = x;
         this->gain = gain;
         this->offset = offset;
-    }
-    
-    void RSGISPartConstrainedLinearSpectralUnmixing::calcImageValue(float *bandValues, int numBands, double *output) 
-    {
-        try 
+
+        this->endmembersColMajor.resize(this->numRows * this->numEndmembers);
+        for(int j = 0; j < this->numEndmembers; ++j)
         {
-            if((b->size-1) != numBands)
-            {
-                throw RSGISImageCalcException("The size vector of for the input data is not equal to the number image bands.");
-            }
-            
-            if(x->size != this->numOutBands)
+            for(size_t i = 0; i < endmembers->size1; ++i)
             {
-                throw RSGISImageCalcException("The size of the output vector is not the same of the number of output image bands.");
+                this->endmembersColMajor[i + (j * this->numRows)] = gsl_matrix_get(endmembers, i, j);
             }
-            
+            this->endmembersColMajor[endmembers->size1 + (j * this->numRows)] = weight;
+        }
+    }
+
+    void RSGISNNConstrainedLinearSpectralUnmixing::calcImageValue(float *bandValues, int numBands, double *output)
+    {
+        if(numBands != (this->numRows-1))
+        {
+            throw RSGISImageCalcException("The size vector of for the input data is not equal to the number image bands.");
+        }
+
+        rsgis::RSGISScratchScope scratch(this->getScratchArena());
+        Workspace ws = this->allocWorkspace(scratch);
+        for(int i = 0; i < numBands; ++i)
+        {
+            ws.b[i] = bandValues[i];
+        }
+        this->solve(ws);
+        for(int j = 0; j < this->numEndmembers; ++j)
+        {
+            output[j] = offset + (ws.x[j]*gain);
+        }
+    }
+
+    void RSGISNNConstrainedLinearSpectralUnmixing::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        if(numBands != (this->numRows-1))
+        {
+            throw RSGISImageCalcException("The size vector of for the input data is not equal to the number image bands.");
+        }
+
+        rsgis::RSGISScratchScope scratch(this->getScratchArena());
+        Workspace ws = this->allocWorkspace(scratch);
+        for(size_t p = 0; p < nPxls; ++p)
+        {
             for(int i = 0; i < numBands; ++i)
             {
-                gsl_vector_set(b, i, bandValues[i]);
-            }
-            gsl_vector_set(b, numBands, weight);
-            
-            int status = gsl_linalg_SV_solve(endmembers, V, S, b, x);
-            if(status != 0)
-            {
-                throw RSGISImageCalcException(gsl_strerror(status));
+                ws.b[i] = bandPlanes[i][p];
             }
-            
-            for(int i = 0; i < x->size; ++i)
+            this->solve(ws);
+            for(int j = 0; j < this->numEndmembers; ++j)
             {
-                output[i] = offset + (gsl_vector_get(x, i)*gain);
+                outPlanes[j][p] = offset + (ws.x[j]*gain);
             }
         }
-        catch (RSGISImageCalcException &e) 
+    }
+
+    RSGISNNConstrainedLinearSpectralUnmixing::Workspace RSGISNNConstrainedLinearSpectralUnmixing::allocWorkspace(rsgis::RSGISScratchScope &scratch)
+    {
+        Workspace ws;
+        ws.a = scratch.alloc<double>(this->endmembersColMajor.size());
+        ws.b = scratch.alloc<double>(this->numRows);
+        ws.x = scratch.alloc<double>(this->numEndmembers);
+        ws.w = scratch.alloc<double>(this->numEndmembers);
+        ws.zz = scratch.alloc<double>(this->numRows);
+        ws.index = scratch.alloc<int>(this->numEndmembers);
+        return ws;
+    }
+
+    void RSGISNNConstrainedLinearSpectralUnmixing::solve(Workspace &ws)
+    {
+        // nnls_c overwrites a and b so they are reset for each solve.
+        std::copy(this->endmembersColMajor.begin(), this->endmembersColMajor.end(), ws.a);
+        ws.b[this->numRows-1] = this->weight;
+
+        int mda = this->numRows;
+        int m = this->numRows;
+        int n = this->numEndmembers;
+        double rNorm = 0;
+        int mode = 0;
+        rsgis::math::RSGISNNLS nnls;
+        nnls.nnls_c(ws.a, &mda, &m, &n, ws.b, ws.x, &rNorm, ws.w, ws.zz, ws.index, &mode);
+        if(mode == 2)
         {
-            throw e;
+            throw RSGISImageCalcException("The dimensions of the NNLS problem are not valid.");
         }
     }
-    
-    RSGISPartConstrainedLinearSpectralUnmixing::~RSGISPartConstrainedLinearSpectralUnmixing()
+
+    RSGISNNConstrainedLinearSpectralUnmixing::~RSGISNNConstrainedLinearSpectralUnmixing()
     {
-        
+
     }
-    
-    
+
+
     RSGISExhaustiveLinearSpectralUnmixing::RSGISExhaustiveLinearSpectralUnmixing(int numberOutBands, gsl_matrix *endmembers, float stepRes, float gain, float offset):RSGISCalcImageValue(numberOutBands)
     {
         this->endmembers = endmembers;
@@ -457,211 +511,191 @@ namespace rsgis{namespace img{
         this->numOfEndMembers = endmembers->size2;
         this->gain = gain;
         this->offset = offset;
+        this->numCombinations = 0;
+        if((this->numOfEndMembers != 2) && (this->numOfEndMembers != 3))
+        {
+            throw RSGISImageCalcException("Unmixing is only implemented for 2 or 3 endmembers.");
+        }
+        this->buildCombinationsTable();
     }
     
-    void RSGISExhaustiveLinearSpectralUnmixing::calcImageValue(float *bandValues, int numBands, double *output) 
+    void RSGISExhaustiveLinearSpectralUnmixing::buildCombinationsTable()
     {
-        // All values have to be greater than zero.
-        
-        // Find the linear combination which is closest to 1 but less than 1. 
-        
-        // Also find the linear combination which is closest to 1 but greater than 1.
-        
-        // Provide option to except greater than 1 if closer result than less than 1 and under some threshold.
-        
+        // The combinations are enumerated, and the abundances and spectra calculated,
+        // exactly as the per pixel search did so the same combination is selected.
         unsigned int numOfSteps = (1/this->stepRes)+1;
-        
         float threshold = 1 + this->stepRes;
+        unsigned int numBands = this->endmembers->size1;
         
-        float *normBandVals = new float[numBands];
-        
-        double sqSum = 0;
-        for(int i = 0; i < numBands; ++i)
-        {
-            sqSum += (bandValues[i]*bandValues[i]);
-        }
-        
-        float normVal = sqrt(sqSum);
+        this->combAbundances.clear();
+        this->combSpectra.clear();
         
-        if(this->numOfEndMembers == 2)
+        float emVals[3] = {0, 0, 0};
+        unsigned int numInnerSteps = (this->numOfEndMembers == 3)?numOfSteps:1;
+        emVals[0] = 0;
+        for(unsigned int i = 0; i < numOfSteps; ++i)
         {
-            float em1Val = 0;
-            float em2Val = 0;
-            
-            bool first = true;
-            float distVal = 0;
-            float minError = 0;
-            float minEM1Val = 0;
-            float minEM2Val = 0;
-            
-            if( normVal > 0)
+            emVals[1] = 0;
+            for(unsigned int j = 0; j < numOfSteps; ++j)
             {
-                for(int i = 0; i < numBands; ++i)
-                {
-                    normBandVals[i] = bandValues[i]/normVal;
-                }
-                
-                for(unsigned int i = 0; i < numOfSteps; ++i)
+                emVals[2] = 0;
+                for(unsigned int k = 0; k < numInnerSteps; ++k)
                 {
-                    em2Val = 0;
-                    for(unsigned int j = 0; j < numOfSteps; ++j)
+                    bool valid = false;
+                    if(this->numOfEndMembers == 2)
+                    {
+                        valid = ((emVals[0]+emVals[1]) < threshold);
+                    }
+                    else
+                    {
+                        valid = ((emVals[0]+emVals[1]+emVals[2]) < threshold);
+                    }
+                    
+                    if(valid)
                     {
-                        if((em1Val+em2Val) < threshold)
+                        for(unsigned int e = 0; e < this->numOfEndMembers; ++e)
                         {
-                            distVal = this->calcDistance2MeasuredSpectra(em1Val, em2Val, normBandVals, numBands);
-                            
-                            if(first)
+                            this->combAbundances.push_back(emVals[e]);
+                        }
+                        for(unsigned int b = 0; b < numBands; ++b)
+                        {
+                            if(this->numOfEndMembers == 2)
                             {
-                                minError = distVal;
-                                minEM1Val = em1Val;
-                                minEM2Val = em2Val;
-                                first = false;
+                                this->combSpectra.push_back((gsl_matrix_get(endmembers, b, 0) * emVals[0]) + (gsl_matrix_get(endmembers, b, 1) * emVals[1]));
                             }
-                            else if(distVal < minError)
+                            else
                             {
-                                minError = distVal;
-                                minEM1Val = em1Val;
-                                minEM2Val = em2Val;
+                                this->combSpectra.push_back((gsl_matrix_get(endmembers, b, 0) * emVals[0]) + (gsl_matrix_get(endmembers, b, 1) * emVals[1]) + (gsl_matrix_get(endmembers, b, 2) * emVals[2]));
                             }
                         }
-                        em2Val += this->stepRes;
+                        ++this->numCombinations;
                     }
-                    em1Val += this->stepRes;
+                    emVals[2] += this->stepRes;
                 }
+                emVals[1] += this->stepRes;
             }
-            
-            if(!first)
-            {
-                output[0] = offset + (minEM1Val * gain);
-                output[1] = offset + (minEM2Val * gain);
-                output[2] = offset + (minError * gain);
-            }
-            else
-            {
-                output[0] = 0;
-                output[1] = 0;
-                output[2] = 0;
-            }
+            emVals[0] += this->stepRes;
         }
-        else if(this->numOfEndMembers == 3)
+    }
+    
+    long RSGISExhaustiveLinearSpectralUnmixing::findBestCombination(float *bandValues, int numBands, float *normBandVals, float *minError)
+    {
+        double sqSum = 0;
+        for(int i = 0; i < numBands; ++i)
         {
-            float em1Val = 0;
-            float em2Val = 0;
-            float em3Val = 0;
-            
-            bool first = true;
-            float distVal = 0;
-            float minError = 0;
-            float minEM1Val = 0;
-            float minEM2Val = 0;
-            float minEM3Val = 0;
-                        
-            if( normVal > 0)
-            {
-                for(int i = 0; i < numBands; ++i)
-                {
-                    normBandVals[i] = bandValues[i]/normVal;
-                }
-                
-                for(unsigned int i = 0; i < numOfSteps; ++i)
+            sqSum += (bandValues[i]*bandValues[i]);
+        }
+        
+        float normVal = sqrt(sqSum);
+        if(normVal <= 0)
+        {
+            return -1;
+        }
+        
+        for(int i = 0; i < numBands; ++i)
+        {
+            normBandVals[i] = bandValues[i]/normVal;
+        }
+        
+        long minIdx = -1;
+        float minErrorSum = 0;
+        *minError = 0;
+        for(size_t c = 0; c < this->numCombinations; ++c)
+        {
+            const float *genSpectra = &this->combSpectra[c * numBands];
+            float errorVal = 0;
+            int i = 0;
+            for(; i < numBands; ++i)
+            {
+                errorVal += ((genSpectra[i] - normBandVals[i])*(genSpectra[i] - normBandVals[i]));
+                // The sum can only grow so once it reaches the best sum this combination can not be better.
+                if((minIdx >= 0) && (errorVal >= minErrorSum))
                 {
-                    em2Val = 0;
-                    for(unsigned int j = 0; j < numOfSteps; ++j)
-                    {
-                        em3Val = 0;
-                        for(unsigned int k = 0; k < numOfSteps; ++k)
-                        {
-                            if((em1Val+em2Val+em3Val) < threshold)
-                            {
-                                distVal = this->calcDistance2MeasuredSpectra(em1Val, em2Val, em3Val, normBandVals, numBands);
-                                
-                                if(first)
-                                {
-                                    minError = distVal;
-                                    minEM1Val = em1Val;
-                                    minEM2Val = em2Val;
-                                    minEM3Val = em3Val;
-                                    first = false;
-                                }
-                                else if(distVal < minError)
-                                {
-                                    minError = distVal;
-                                    minEM1Val = em1Val;
-                                    minEM2Val = em2Val;
-                                    minEM3Val = em3Val; 
-                                }
-                            }
-                            em3Val += this->stepRes;
-                        }
-                        em2Val += this->stepRes;
-                    }
-                    em1Val += this->stepRes;
+                    break;
                 }
             }
-            
-            if(!first)
+            if(i < numBands)
             {
-                output[0] = offset + (minEM1Val * gain);
-                output[1] = offset + (minEM2Val * gain);
-                output[2] = offset + (minEM3Val * gain);
-                output[3] = offset + (minError * gain);
+                continue;
             }
-            else
+            
+            float distVal = sqrt(errorVal/numBands);
+            if((minIdx < 0) || (distVal < *minError))
             {
-                output[0] = 0;
-                output[1] = 0;
-                output[2] = 0;
-                output[3] = 0;
+                *minError = distVal;
+                minErrorSum = errorVal;
+                minIdx = c;
             }
         }
-        else
-        {
-            throw RSGISImageCalcException("Unmixing is only implemented for 3 endmembers.");
-        }
-                
-        delete[] normBandVals;
+        return minIdx;
     }
     
-    float RSGISExhaustiveLinearSpectralUnmixing::calcDistance2MeasuredSpectra(float em1Val, float em2Val, float em3Val, float *normSpectra, unsigned int numBands) 
+    void RSGISExhaustiveLinearSpectralUnmixing::calcImageValue(float *bandValues, int numBands, double *output) 
     {
-        float *genSpectra = new float[numBands];
-        for(unsigned int i = 0; i < numBands; ++i)
+        if(numBands != this->endmembers->size1)
         {
-            genSpectra[i] = (gsl_matrix_get(endmembers, i, 0) * em1Val) + (gsl_matrix_get(endmembers, i, 1) * em2Val) + (gsl_matrix_get(endmembers, i, 2) * em3Val);
+            throw RSGISImageCalcException("The number of image bands and wavelengths within the endmemebers should match.");
         }
         
-        float errorVal = 0;
-        for(unsigned int i = 0; i < numBands; ++i)
+        rsgis::RSGISScratchScope scratch(this->getScratchArena());
+        float *normBandVals = scratch.alloc<float>(numBands);
+        
+        float minError = 0;
+        long minIdx = this->findBestCombination(bandValues, numBands, normBandVals, &minError);
+        if(minIdx >= 0)
+        {
+            const float *abundances = &this->combAbundances[minIdx * this->numOfEndMembers];
+            for(unsigned int e = 0; e < this->numOfEndMembers; ++e)
+            {
+                output[e] = offset + (abundances[e] * gain);
+            }
+            output[this->numOfEndMembers] = offset + (minError * gain);
+        }
+        else
         {
-            errorVal += ((genSpectra[i] - normSpectra[i])*(genSpectra[i] - normSpectra[i]));
+            for(unsigned int e = 0; e <= this->numOfEndMembers; ++e)
+            {
+                output[e] = 0;
+            }
         }
-        
-        delete[] genSpectra;
-        
-        errorVal = sqrt(errorVal/numBands);
-        
-        return errorVal;
     }
     
-    float RSGISExhaustiveLinearSpectralUnmixing::calcDistance2MeasuredSpectra(float em1Val, float em2Val, float *normSpectra, unsigned int numBands) 
+    void RSGISExhaustiveLinearSpectralUnmixing::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
     {
-        float *genSpectra = new float[numBands];
-        for(unsigned int i = 0; i < numBands; ++i)
+        if(numBands != this->endmembers->size1)
         {
-            genSpectra[i] = (gsl_matrix_get(endmembers, i, 0) * em1Val) + (gsl_matrix_get(endmembers, i, 1) * em2Val);
+            throw RSGISImageCalcException("The number of image bands and wavelengths within the endmemebers should match.");
         }
         
-        float errorVal = 0;
-        for(unsigned int i = 0; i < numBands; ++i)
+        rsgis::RSGISScratchScope scratch(this->getScratchArena());
+        float *bandValues = scratch.alloc<float>(numBands);
+        float *normBandVals = scratch.alloc<float>(numBands);
+        
+        float minError = 0;
+        for(size_t p = 0; p < nPxls; ++p)
         {
-            errorVal += ((genSpectra[i] - normSpectra[i])*(genSpectra[i] - normSpectra[i]));
+            for(int i = 0; i < numBands; ++i)
+            {
+                bandValues[i] = bandPlanes[i][p];
+            }
+            long minIdx = this->findBestCombination(bandValues, numBands, normBandVals, &minError);
+            if(minIdx >= 0)
+            {
+                const float *abundances = &this->combAbundances[minIdx * this->numOfEndMembers];
+                for(unsigned int e = 0; e < this->numOfEndMembers; ++e)
+                {
+                    outPlanes[e][p] = offset + (abundances[e] * gain);
+                }
+                outPlanes[this->numOfEndMembers][p] = offset + (minError * gain);
+            }
+            else
+            {
+                for(unsigned int e = 0; e <= this->numOfEndMembers; ++e)
+                {
+                    outPlanes[e][p] = 0;
+                }
+            }
         }
-                
-        delete[] genSpectra;
-        
-        errorVal = sqrt(errorVal/numBands);
-        
-        return errorVal;
     }
     
     RSGISExhaustiveLinearSpectralUnmixing::~RSGISExhaustiveLinearSpectralUnmixing()
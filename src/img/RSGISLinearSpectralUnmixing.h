@@ -27,6 +27,8 @@
 #include <string>
 #include <math.h>
 #include <stdlib.h>
+#include <vector>
+#include <algorithm>
 
 #include "img/RSGISImageCalcException.h"
 #include "img/RSGISCalcImageValue.h"
@@ -80,11 +82,26 @@ namespace rsgis{namespace img{
     };
     
     
-    class DllExport RSGISUnconstrainedLinearSpectralUnmixing : public RSGISCalcImageValue
+    /**
+     * Least squares unmixing with a fixed set of endmembers, applied as a
+     * multiplication by the pseudo-inverse of the endmember matrix (from its
+     * SVD) which is calculated once. Whole blocks are unmixed as a single
+     * matrix multiplication (endmembers x bands).(bands x pixels) and, as
+     * there is no mutable state, blocks can be processed by several threads.
+     */
+    class DllExport RSGISPseudoInverseLinearSpectralUnmixing : public RSGISCalcImageValue
     {
-    public: 
-        RSGISUnconstrainedLinearSpectralUnmixing(int numberOutBands, gsl_matrix *endmembers, gsl_matrix *V, gsl_vector *S, gsl_vector *work, gsl_vector *b, gsl_vector *x, float gain, float offset);
+    public:
+        /**
+         * pseudoInverse is the (endmembers x bands) pseudo-inverse, of which
+         * the first numInBands columns are copied, and constTerm (may be NULL)
+         * a value per endmember added to the solution (e.g., for a constraint
+         * row of the endmember matrix).
+         */
+        RSGISPseudoInverseLinearSpectralUnmixing(const gsl_matrix *pseudoInverse, unsigned int numInBands, const double *constTerm, float gain, float offset);
         void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        bool isThreadSafe(){return true;};
         void calcImageValue(float *bandValues, int numBands) {throw RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw RSGISImageCalcException("Not implemented");};
@@ -94,50 +111,107 @@ namespace rsgis{namespace img{
         void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageCalcException("Not implemented");};
         void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output, geos::geom::Envelope extent) {throw RSGISImageCalcException("No implemented");};
         bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageCalcException("Not implemented");};
-        ~RSGISUnconstrainedLinearSpectralUnmixing();
+        /**
+         * Calculate the (n x m) pseudo-inverse V.diag(1/S).U' of a (m x n)
+         * matrix from its SVD (as given by gsl_linalg_SV_decomp), zero singular
+         * values are ignored as in gsl_linalg_SV_solve.
+         */
+        static gsl_matrix* calcPseudoInverse(const gsl_matrix *U, const gsl_matrix *V, const gsl_vector *S);
+        ~RSGISPseudoInverseLinearSpectralUnmixing();
     protected:
-        gsl_matrix *endmembers;
-        gsl_matrix *V;
-        gsl_vector *S;
-        gsl_vector *work;
-        gsl_vector *b;
-        gsl_vector *x;
+        static const size_t pxlChunkSize;
+        gsl_matrix *pseudoInverse;
+        std::vector<double> constTerm;
+        unsigned int numInBands;
         float gain;
         float offset;
     };
     
-    class DllExport RSGISPartConstrainedLinearSpectralUnmixing : public RSGISCalcImageValue
+    class DllExport RSGISUnconstrainedLinearSpectralUnmixing : public RSGISPseudoInverseLinearSpectralUnmixing
+    {
+    public: 
+        RSGISUnconstrainedLinearSpectralUnmixing(const gsl_matrix *pseudoInverse, float gain, float offset);
+        ~RSGISUnconstrainedLinearSpectralUnmixing();
+    };
+    
+    /**
+     * Unconstrained unmixing with an extra row (the weight for each endmember)
+     * in the endmember matrix, so the abundances are pushed to sum to one.
+     * pseudoInverse is for the augmented (bands+1 x endmembers) matrix.
+     */
+    class DllExport RSGISPartConstrainedLinearSpectralUnmixing : public RSGISPseudoInverseLinearSpectralUnmixing
     {
     public: 
-        RSGISPartConstrainedLinearSpectralUnmixing(int numberOutBands, float weight, gsl_matrix *endmembers, gsl_matrix *V, gsl_vector *S, gsl_vector *work, gsl_vector *b, gsl_vector *x, float gain, float offset);
+        RSGISPartConstrainedLinearSpectralUnmixing(const gsl_matrix *pseudoInverse, float weight, float gain, float offset);
+        ~RSGISPartConstrainedLinearSpectralUnmixing();
+    protected:
+        static std::vector<double> calcWeightTerm(const gsl_matrix *pseudoInverse, float weight);
+    };
+    
+    /**
+     * Non-negative least squares unmixing (with the sum to one weight row) by
+     * the active set method of RSGISNNLS. Each pixel is an independent solve
+     * using workspaces allocated once per block from the thread's scratch
+     * arena, so blocks can be processed by several threads.
+     */
+    class DllExport RSGISNNConstrainedLinearSpectralUnmixing : public RSGISCalcImageValue
+    {
+    public:
+        RSGISNNConstrainedLinearSpectralUnmixing(const gsl_matrix *endmembers, float weight, float gain, float offset);
         void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        bool isThreadSafe(){return true;};
         void calcImageValue(float *bandValues, int numBands) {throw RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw RSGISImageCalcException("Not implemented");};
-       void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, geos::geom::Envelope extent){throw rsgis::img::RSGISImageCalcException("Not implemented");};
+        void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, geos::geom::Envelope extent){throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(float *bandValues, int numBands, geos::geom::Envelope extent) {throw RSGISImageCalcException("Not implemented");};
         void calcImageValue(float *bandValues, int numBands, double *output, geos::geom::Envelope extent) {throw RSGISImageCalcException("Not implemented");};
         void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageCalcException("Not implemented");};
         void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output, geos::geom::Envelope extent) {throw RSGISImageCalcException("No implemented");};
         bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageCalcException("Not implemented");};
-        ~RSGISPartConstrainedLinearSpectralUnmixing();
+        ~RSGISNNConstrainedLinearSpectralUnmixing();
     protected:
+        struct Workspace
+        {
+            double *a;
+            double *b;
+            double *x;
+            double *w;
+            double *zz;
+            int *index;
+        };
+        Workspace allocWorkspace(rsgis::RSGISScratchScope &scratch);
+        /**
+         * Solve for the spectra in ws.b (the band values), the abundances are
+         * returned in ws.x.
+         */
+        void solve(Workspace &ws);
+        // The augmented endmember matrix (bands+1 x endmembers) in column major order.
+        std::vector<double> endmembersColMajor;
+        int numRows;
+        int numEndmembers;
         float weight;
-        gsl_matrix *endmembers;
-        gsl_matrix *V;
-        gsl_vector *S;
-        gsl_vector *work;
-        gsl_vector *b;
-        gsl_vector *x;
         float gain;
         float offset;
     };
     
+    /**
+     * Exhaustive search of the abundances (at stepRes intervals, summing to
+     * no more than 1 + stepRes) of 2 or 3 endmembers for the modelled
+     * spectrum closest to each (normalised) pixel spectrum. The modelled
+     * spectra are calculated once, in the constructor, into a table which is
+     * scanned for each pixel, stopping the sum for a combination once it can
+     * not beat the best so far. The table is read only so blocks can be
+     * processed by several threads.
+     */
     class DllExport RSGISExhaustiveLinearSpectralUnmixing : public RSGISCalcImageValue
     {
     public: 
         RSGISExhaustiveLinearSpectralUnmixing(int numberOutBands, gsl_matrix *endmembers, float stepRes, float gain, float offset);
         void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        bool isThreadSafe(){return true;};
         void calcImageValue(float *bandValues, int numBands) {throw RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw RSGISImageCalcException("Not implemented");};
@@ -149,13 +223,22 @@ namespace rsgis{namespace img{
         bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageCalcException("Not implemented");};
         ~RSGISExhaustiveLinearSpectralUnmixing();
     protected:
-        float calcDistance2MeasuredSpectra(float em1Val, float em2Val, float em3Val, float *normSpectra, unsigned int numBands);
-        float calcDistance2MeasuredSpectra(float em1Val, float em2Val, float *normSpectra, unsigned int numBands);
+        void buildCombinationsTable();
+        /**
+         * Returns the index of the best combination (or -1 if the spectrum is
+         * all zero) and its error.
+         */
+        long findBestCombination(float *bandValues, int numBands, float *normBandVals, float *minError);
         gsl_matrix *endmembers;
         float stepRes;
         unsigned int numOfEndMembers;
         float gain;
         float offset;
+        size_t numCombinations;
+        // The endmember abundances of each combination (numCombinations x numOfEndMembers).
+        std::vector<float> combAbundances;
+        // The modelled spectrum of each combination (numCombinations x bands).
+        std::vector<float> combSpectra;
     };
     
     
@@ -139,6 +139,46 @@ namespace rsgis{namespace img{
 		}
 	}
 		
+	void RSGISApplyImageMask::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+	{
+        if(numBands != (numOutBands + 1))
+        {
+            throw RSGISImageCalcException("The mask and image must be provided (i.e., the number of input bands should be the number of output bands + 1).");
+        }
+        
+        rsgis::RSGISScratchScope scratch(this->getScratchArena());
+        // Compare the mask against the mask values once for each pixel.
+        unsigned char *masked = scratch.alloc<unsigned char>(nPxls);
+        memset(masked, 0, nPxls);
+        const float *maskPlane = bandPlanes[0];
+        for(std::vector<float>::iterator iterVals = maskValues.begin(); iterVals != maskValues.end(); ++iterVals)
+        {
+            const float maskVal = *iterVals;
+            for(size_t j = 0; j < nPxls; ++j)
+            {
+                masked[j] |= (unsigned char)(maskPlane[j] == maskVal);
+            }
+        }
+        
+        // Blend with bit masks, as the compiler will not vectorise the conditional.
+        uint64_t outBits;
+        memcpy(&outBits, &this->outputValue, sizeof(double));
+        for(int i = 0; i < numOutBands; ++i)
+        {
+            const float *inPlane = bandPlanes[i+1];
+            double *outPlane = outPlanes[i];
+            for(size_t j = 0; j < nPxls; ++j)
+            {
+                const double inVal = inPlane[j];
+                uint64_t inBits;
+                memcpy(&inBits, &inVal, sizeof(double));
+                const uint64_t selMask = ((uint64_t) 0) - ((uint64_t) masked[j]);
+                const uint64_t bits = (inBits & ~selMask) | (outBits & selMask);
+                memcpy(&outPlane[j], &bits, sizeof(double));
+            }
+        }
+	}
+    
 	RSGISApplyImageMask::~RSGISApplyImageMask()
 	{
 		
@@ -172,6 +212,32 @@ namespace rsgis{namespace img{
         }
     }
     
+    void RSGISCreateFiniteImageMask::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        rsgis::RSGISScratchScope scratch(this->getScratchArena());
+        uint32_t *finite = scratch.alloc<uint32_t>(nPxls);
+        for(size_t j = 0; j < nPxls; ++j)
+        {
+            finite[j] = 1;
+        }
+        for(int i = 0; i < numBands; ++i)
+        {
+            const float *inPlane = bandPlanes[i];
+            for(size_t j = 0; j < nPxls; ++j)
+            {
+                // Inf and NaN have all the exponent bits set.
+                uint32_t bits;
+                memcpy(&bits, &inPlane[j], sizeof(float));
+                finite[j] &= (uint32_t)((bits & 0x7F800000) != 0x7F800000);
+            }
+        }
+        double *outPlane = outPlanes[0];
+        for(size_t j = 0; j < nPxls; ++j)
+        {
+            outPlane[j] = finite[j];
+        }
+    }
+    
     RSGISCreateFiniteImageMask::~RSGISCreateFiniteImageMask()
     {
         
@@ -205,6 +271,37 @@ namespace rsgis{namespace img{
         }
     }
     
+    void RSGISGenValidImageMask::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        rsgis::RSGISScratchScope scratch(this->getScratchArena());
+        uint32_t *valid = scratch.alloc<uint32_t>(nPxls);
+        for(size_t j = 0; j < nPxls; ++j)
+        {
+            valid[j] = 1;
+        }
+        const float noDataVal = this->noDataVal;
+        for(int i = 0; i < numBands; ++i)
+        {
+            const float *inPlane = bandPlanes[i];
+            uint32_t anyValid = 0;
+            for(size_t j = 0; j < nPxls; ++j)
+            {
+                valid[j] &= (uint32_t)(inPlane[j] != noDataVal);
+                anyValid |= valid[j];
+            }
+            if(anyValid == 0)
+            {
+                // The remaining bands cannot make any pixel valid.
+                break;
+            }
+        }
+        double *outPlane = outPlanes[0];
+        for(size_t j = 0; j < nPxls; ++j)
+        {
+            outPlane[j] = valid[j];
+        }
+    }
+    
     RSGISGenValidImageMask::~RSGISGenValidImageMask()
     {
         
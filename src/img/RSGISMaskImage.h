@@ -25,6 +25,8 @@
 
 #include <iostream>
 #include <string>
+#include <cstring>
+#include <cstdint>
 
 #include "gdal_priv.h"
 
@@ -63,6 +65,9 @@ namespace rsgis{namespace img{
 		public: 
 			RSGISApplyImageMask(int numberOutBands, double outputValue, std::vector<float> maskValues);
 			void calcImageValue(float *bandValues, int numBands, double *output);
+            /** Finds the masked pixels of the block once then selects between the output value and each band plane. */
+            void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+            bool isThreadSafe(){return true;};
             void calcImageValue(float *bandValues, int numBands) {throw RSGISImageCalcException("Not implemented");};
             void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw RSGISImageCalcException("Not implemented");};
             void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw RSGISImageCalcException("Not implemented");};
@@ -83,6 +88,9 @@ namespace rsgis{namespace img{
     public:
         RSGISCreateFiniteImageMask();
         void calcImageValue(float *bandValues, int numBands, double *output);
+        /** ANDs the finite test (on the exponent bits) of each band plane. */
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        bool isThreadSafe(){return true;};
         void calcImageValue(float *bandValues, int numBands) {throw RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw RSGISImageCalcException("Not implemented");};
@@ -100,6 +108,9 @@ namespace rsgis{namespace img{
     public:
         RSGISGenValidImageMask(float noDataVal);
         void calcImageValue(float *bandValues, int numBands, double *output);
+        /** ANDs the valid test of each band plane, stopping once no pixel in the block is valid. */
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        bool isThreadSafe(){return true;};
         void calcImageValue(float *bandValues, int numBands) {throw RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw RSGISImageCalcException("Not implemented");};
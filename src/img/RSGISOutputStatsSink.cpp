@@ -0,0 +1,179 @@
+/*
+ *  RSGISOutputStatsSink.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISOutputStatsSink.h"
+
+#include "img/RSGISPopWithStats.h"
+#include "utils/RSGISTextUtils.h"
+
+namespace rsgis{namespace img{
+
+    RSGISOutputStatsSink::RSGISOutputStatsSink(GDALDataset *dataset, bool calcPyramids, bool thematic, bool useNoData, float noDataVal)
+    {
+        this->dataset = dataset;
+        this->thematic = thematic;
+        this->useNoData = useNoData;
+        this->noDataVal = noDataVal;
+        this->overviews = NULL;
+        this->passStats = new RSGISSinglePassImageStats(!thematic, false, thematic);
+        this->passStats->startStream(dataset->GetRasterCount(), useNoData, noDataVal);
+        for(int i = 0; i < dataset->GetRasterCount(); ++i)
+        {
+            this->bandTypes.push_back(dataset->GetRasterBand(i+1)->GetRasterDataType());
+        }
+        this->typedPlanes.resize(dataset->GetRasterCount(), NULL);
+        if(calcPyramids)
+        {
+            std::vector<int> factors = RSGISPopWithStats::getDefaultPyramidLevels(dataset->GetRasterXSize(), dataset->GetRasterYSize());
+            RSGISStreamOverviewBuilder::createOverviews(dataset, factors);
+            this->overviews = new RSGISStreamOverviewBuilder(dataset, factors, thematic);
+        }
+    }
+
+    void RSGISOutputStatsSink::addRows(double **outputData, int numBands, int width, int rowOffset, int nRows)
+    {
+        if(numBands != this->dataset->GetRasterCount())
+        {
+            throw RSGISImageBandException("The rows given to the statistics do not match the image.");
+        }
+        size_t nPxls = ((size_t)width) * nRows;
+        this->typedData.resize(nPxls * numBands);
+        for(int n = 0; n < numBands; ++n)
+        {
+            double *typedBand = &this->typedData[n * nPxls];
+            GDALDataType dataType = this->bandTypes[n];
+            if((dataType == GDT_Float64) || (dataType == GDT_CFloat64))
+            {
+                std::copy(outputData[n], outputData[n] + nPxls, typedBand);
+            }
+            else if((dataType == GDT_Float32) || (dataType == GDT_CFloat32))
+            {
+                for(size_t i = 0; i < nPxls; ++i)
+                {
+                    typedBand[i] = (float)outputData[n][i];
+                }
+            }
+            else
+            {
+                for(size_t i = 0; i < nPxls; ++i)
+                {
+                    typedBand[i] = std::isnan(outputData[n][i])?0:GDALAdjustValueToDataType(dataType, outputData[n][i], NULL, NULL);
+                }
+            }
+            this->typedPlanes[n] = typedBand;
+        }
+        this->passStats->addBlock(this->typedPlanes.data(), nPxls);
+        if(this->overviews != NULL)
+        {
+            this->overviews->addRows(outputData, rowOffset, nRows);
+        }
+    }
+
+    void RSGISOutputStatsSink::finish()
+    {
+        if(this->overviews != NULL)
+        {
+            this->overviews->finish();
+        }
+        if(this->thematic)
+        {
+            this->writeThematicStats();
+        }
+        else
+        {
+            RSGISPopWithStats popWithStats;
+            popWithStats.setImageStats(this->dataset, *this->passStats, this->useNoData, this->noDataVal);
+        }
+    }
+
+    void RSGISOutputStatsSink::writeThematicStats()
+    {
+        rsgis::utils::RSGISTextUtils textUtils;
+        for(int i = 0; i < this->dataset->GetRasterCount(); ++i)
+        {
+            GDALRasterBand *band = this->dataset->GetRasterBand(i+1);
+            band->SetMetadataItem("LAYER_TYPE", "thematic");
+            if(this->useNoData)
+            {
+                band->SetNoDataValue(this->noDataVal);
+            }
+            if(this->passStats->getCount(i) > 0)
+            {
+                band->SetMetadataItem("STATISTICS_MINIMUM", textUtils.doubletostring(this->passStats->getMin(i)).c_str(), NULL);
+                band->SetMetadataItem("STATISTICS_MAXIMUM", textUtils.doubletostring(this->passStats->getMax(i)).c_str(), NULL);
+                band->SetMetadataItem("STATISTICS_MEAN", textUtils.doubletostring(this->passStats->getMean(i)).c_str(), NULL);
+                band->SetMetadataItem("STATISTICS_STDDEV", textUtils.doubletostring(this->passStats->getStdDev(i)).c_str(), NULL);
+            }
+
+            const std::vector<unsigned long long> *directHist = this->passStats->getDirectHistogram(i);
+            size_t numRows = std::max<size_t>(directHist->size(), 1);
+            std::vector<double> histData(numRows, 0);
+            for(size_t j = 0; j < directHist->size(); ++j)
+            {
+                histData[j] = (*directHist)[j];
+            }
+            band->SetMetadataItem("STATISTICS_HISTOBINFUNCTION", "direct");
+            band->SetMetadataItem("STATISTICS_HISTOMIN", "0");
+            band->SetMetadataItem("STATISTICS_HISTOMAX", textUtils.int64bittostring(numRows-1).c_str());
+            band->SetMetadataItem("STATISTICS_HISTONUMBINS", textUtils.int64bittostring(numRows).c_str());
+
+            GDALRasterAttributeTable *attTable = band->GetDefaultRAT();
+            if(attTable == NULL)
+            {
+                GDALDefaultRasterAttributeTable defaultRAT;
+                band->SetDefaultRAT(&defaultRAT);
+                attTable = band->GetDefaultRAT();
+            }
+            if(attTable->GetRowCount() < ((int)numRows))
+            {
+                attTable->SetRowCount(numRows);
+            }
+            int histoColIdx = -1;
+            for(int c = 0; c < attTable->GetColumnCount(); ++c)
+            {
+                if(std::string(attTable->GetNameOfCol(c)) == "Histogram")
+                {
+                    histoColIdx = c;
+                    break;
+                }
+            }
+            if(histoColIdx < 0)
+            {
+                attTable->CreateColumn("Histogram", GFT_Real, GFU_PixelCount);
+                histoColIdx = attTable->GetColumnCount() - 1;
+            }
+            if(attTable->ValuesIO(GF_Write, histoColIdx, 0, numRows, histData.data()) != CE_None)
+            {
+                throw RSGISImageBandException("Could not write the histogram to the attribute table.");
+            }
+        }
+    }
+
+    RSGISOutputStatsSink::~RSGISOutputStatsSink()
+    {
+        delete this->passStats;
+        if(this->overviews != NULL)
+        {
+            delete this->overviews;
+        }
+    }
+
+}}
@@ -0,0 +1,84 @@
+/*
+ *  RSGISOutputStatsSink.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISOutputStatsSink_H
+#define RSGISOutputStatsSink_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "gdal_priv.h"
+
+#include "img/RSGISImageBandException.h"
+#include "img/RSGISStreamOverviewBuilder.h"
+#include "img/RSGISSinglePassImageStats.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_img_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace img{
+
+    /**
+     * Calculates the statistics, histograms and (optionally) pyramids of an
+     * image from its rows as they are written by RSGISCalcImage, so the
+     * image is complete when closed without being read again.
+     *
+     * Athematic images get the same metadata as RSGISPopWithStats and
+     * AVERAGE pyramids with the default levels. Thematic images are marked
+     * as such and get a direct histogram in the RAT 'Histogram' column (as
+     * rastergis populateStats, without a colour table) and NEAREST pyramids.
+     * Values are rounded and clamped to the output data type before being
+     * counted so the statistics match the stored values.
+     */
+    class DllExport RSGISOutputStatsSink : public RSGISImageOutputSink
+    {
+    public:
+        RSGISOutputStatsSink(GDALDataset *dataset, bool calcPyramids, bool thematic=false, bool useNoData=false, float noDataVal=0);
+        void addRows(double **outputData, int numBands, int width, int rowOffset, int nRows);
+        void finish();
+        ~RSGISOutputStatsSink();
+    protected:
+        void writeThematicStats();
+        GDALDataset *dataset;
+        bool thematic;
+        bool useNoData;
+        float noDataVal;
+        RSGISSinglePassImageStats *passStats;
+        RSGISStreamOverviewBuilder *overviews;
+        std::vector<GDALDataType> bandTypes;
+        std::vector<double> typedData;
+        std::vector<const double*> typedPlanes;
+    };
+
+}}
+
+#endif
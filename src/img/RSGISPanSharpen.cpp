@@ -238,5 +238,401 @@ namespace rsgis { namespace img {
 		this->outStats[2] = sqrt(this->sumMS / this->nPix);
 		this->outStats[3] = sqrt(this->sumPAN / this->nPix);
 	}
+	
+	
+	const int RSGISHCSPanSharpenFused::stripHeight = 256;
+	
+	RSGISHCSPanSharpenFused::RSGISHCSPanSharpenFused(unsigned int winSize, bool useNaiveMethod, unsigned int statsDecimation)
+	{
+		if((!useNaiveMethod) && ((winSize < 1) || ((winSize % 2) == 0)))
+		{
+			throw RSGISImageCalcException("The window size must be an odd number.");
+		}
+		this->winSize = winSize;
+		this->useNaiveMethod = useNaiveMethod;
+		this->statsDecimation = (statsDecimation == 0)?1:statsDecimation;
+		this->statsCalculated = false;
+		for(int i = 0; i < 4; ++i)
+		{
+			this->imageStats[i] = 0;
+		}
+		this->numThreads = rsgis::utils::getNumThreads();
+	}
+	
+	void RSGISHCSPanSharpenFused::setNumThreads(unsigned int numThreads)
+	{
+		this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+	}
+	
+	void RSGISHCSPanSharpenFused::checkDatasets(GDALDataset *msDataset, GDALDataset *panDataset)
+	{
+		if(panDataset->GetRasterCount() != 1)
+		{
+			throw RSGISImageCalcException("The panchromatic image must have a single band.");
+		}
+		if(msDataset->GetRasterCount() < 2)
+		{
+			throw RSGISImageCalcException("The multispectral image must have at least 2 bands.");
+		}
+		msDataset->GetGeoTransform(this->msTransform);
+		panDataset->GetGeoTransform(this->panTransform);
+		if((this->msTransform[2] != 0) || (this->msTransform[4] != 0) || (this->panTransform[2] != 0) || (this->panTransform[4] != 0))
+		{
+			throw RSGISImageCalcException("Rotated images are not supported.");
+		}
+	}
+	
+	RSGISHCSPanSharpenFused::ResampleAxis RSGISHCSPanSharpenFused::calcResampleAxis(const std::vector<double> &panCoords, double panOrigin, double panRes, double msOrigin, double msRes, int msSize)
+	{
+		ResampleAxis axis;
+		axis.idx0.resize(panCoords.size());
+		axis.idx1.resize(panCoords.size());
+		axis.weight.resize(panCoords.size());
+		axis.minIdx = msSize - 1;
+		axis.maxIdx = 0;
+		for(size_t i = 0; i < panCoords.size(); ++i)
+		{
+			// The position in multispectral pixels where the pixel centres are at integers.
+			double msCoord = (((panOrigin + (panCoords[i] * panRes)) - msOrigin) / msRes) - 0.5;
+			msCoord = std::min(std::max(msCoord, 0.0), (double)(msSize - 1));
+			int idx0 = std::min((int)floor(msCoord), msSize - 1);
+			axis.idx0[i] = idx0;
+			axis.idx1[i] = std::min(idx0 + 1, msSize - 1);
+			axis.weight[i] = msCoord - idx0;
+			axis.minIdx = std::min(axis.minIdx, idx0);
+			axis.maxIdx = std::max(axis.maxIdx, axis.idx1[i]);
+		}
+		return axis;
+	}
+	
+	void RSGISHCSPanSharpenFused::readResampledMS(GDALDataset *msDataset, const ResampleAxis &xAxis, const ResampleAxis &yAxis, std::vector<float> &msData, float **msPlanes, std::mutex &ioMutex)
+	{
+		int readWidth = xAxis.maxIdx - xAxis.minIdx + 1;
+		int readHeight = yAxis.maxIdx - yAxis.minIdx + 1;
+		size_t numOutX = xAxis.idx0.size();
+		size_t numOutY = yAxis.idx0.size();
+		msData.resize(((size_t)readWidth) * readHeight);
+		for(int b = 0; b < msDataset->GetRasterCount(); ++b)
+		{
+			{
+				std::lock_guard<std::mutex> ioLock(ioMutex);
+				msDataset->GetRasterBand(b+1)->RasterIO(GF_Read, xAxis.minIdx, yAxis.minIdx, readWidth, readHeight, msData.data(), readWidth, readHeight, GDT_Float32, 0, 0);
+			}
+			float *outPlane = msPlanes[b];
+			for(size_t y = 0; y < numOutY; ++y)
+			{
+				const float *row0 = msData.data() + (((size_t)(yAxis.idx0[y] - yAxis.minIdx)) * readWidth) - xAxis.minIdx;
+				const float *row1 = msData.data() + (((size_t)(yAxis.idx1[y] - yAxis.minIdx)) * readWidth) - xAxis.minIdx;
+				float wy = yAxis.weight[y];
+				float *outRow = outPlane + (y * numOutX);
+				for(size_t x = 0; x < numOutX; ++x)
+				{
+					float wx = xAxis.weight[x];
+					float top = row0[xAxis.idx0[x]] + (wx * (row0[xAxis.idx1[x]] - row0[xAxis.idx0[x]]));
+					float bottom = row1[xAxis.idx0[x]] + (wx * (row1[xAxis.idx1[x]] - row1[xAxis.idx0[x]]));
+					outRow[x] = top + (wy * (bottom - top));
+				}
+			}
+		}
+	}
+	
+	void RSGISHCSPanSharpenFused::calcStats(GDALDataset *msDataset, GDALDataset *panDataset)
+	{
+		this->checkDatasets(msDataset, panDataset);
+		int numMSBands = msDataset->GetRasterCount();
+		int panWidth = panDataset->GetRasterXSize();
+		int panHeight = panDataset->GetRasterYSize();
+		int msWidth = msDataset->GetRasterXSize();
+		int msHeight = msDataset->GetRasterYSize();
+		
+		// The pan image is read with GDAL decimating by statsDecimation, and the
+		// multispectral image resampled at the centres of the pixels GDAL samples.
+		int decimation = this->statsDecimation;
+		int bufWidth = (panWidth + decimation - 1) / decimation;
+		int statsStripHeight = stripHeight * decimation;
+		int numStrips = (panHeight + statsStripHeight - 1) / statsStripHeight;
+		std::vector<double> panCols(bufWidth);
+		for(int i = 0; i < bufWidth; ++i)
+		{
+			panCols[i] = (i + 0.5) * (((double)panWidth) / bufWidth);
+		}
+		ResampleAxis xAxis = calcResampleAxis(panCols, this->panTransform[0], this->panTransform[1], this->msTransform[0], this->msTransform[1], msWidth);
+		
+		// The count, mean and sum of squared differences of the squared intensity and
+		// pan values, with each strip merged in as it is finished (Chan et al.).
+		double totalN = 0;
+		double meanMS = 0;
+		double m2MS = 0;
+		double meanPAN = 0;
+		double m2PAN = 0;
+		
+		std::mutex ioMutex;
+		std::mutex statsMutex;
+		rsgis::utils::RSGISWorkerPool pool(std::max(1u, std::min(this->numThreads, (unsigned int)numStrips)));
+		pool.parallelFor(numStrips, [&](size_t stripIdx, unsigned int)
+		{
+			std::vector<float> panData;
+			std::vector<float> msData;
+			std::vector<float> msResampled;
+			std::vector<float*> msPlanes(numMSBands);
+			std::vector<double> intensitySq;
+			std::vector<double> panSq;
+			int rowOff = stripIdx * statsStripHeight;
+			int numRows = std::min(statsStripHeight, panHeight - rowOff);
+			int bufHeight = (numRows + decimation - 1) / decimation;
+			size_t numBufPxls = ((size_t)bufWidth) * bufHeight;
+			
+			panData.resize(numBufPxls);
+			{
+				std::lock_guard<std::mutex> ioLock(ioMutex);
+				panDataset->GetRasterBand(1)->RasterIO(GF_Read, 0, rowOff, panWidth, numRows, panData.data(), bufWidth, bufHeight, GDT_Float32, 0, 0);
+			}
+			
+			std::vector<double> panRows(bufHeight);
+			for(int j = 0; j < bufHeight; ++j)
+			{
+				panRows[j] = rowOff + ((j + 0.5) * (((double)numRows) / bufHeight));
+			}
+			ResampleAxis yAxis = calcResampleAxis(panRows, this->panTransform[3], this->panTransform[5], this->msTransform[3], this->msTransform[5], msHeight);
+			msResampled.resize(numBufPxls * numMSBands);
+			for(int b = 0; b < numMSBands; ++b)
+			{
+				msPlanes[b] = msResampled.data() + (b * numBufPxls);
+			}
+			this->readResampledMS(msDataset, xAxis, yAxis, msData, msPlanes.data(), ioMutex);
+			
+			intensitySq.clear();
+			panSq.clear();
+			for(size_t p = 0; p < numBufPxls; ++p)
+			{
+				if(msPlanes[0][p] > 0)
+				{
+					double iSq = 0;
+					for(int b = 0; b < numMSBands; ++b)
+					{
+						iSq += msPlanes[b][p] * msPlanes[b][p];
+					}
+					intensitySq.push_back(iSq);
+					panSq.push_back(((double)panData[p]) * panData[p]);
+				}
+			}
+			if(intensitySq.empty())
+			{
+				return;
+			}
+			
+			double stripN = intensitySq.size();
+			double stripMeanMS = 0;
+			double stripMeanPAN = 0;
+			for(size_t p = 0; p < intensitySq.size(); ++p)
+			{
+				stripMeanMS += intensitySq[p];
+				stripMeanPAN += panSq[p];
+			}
+			stripMeanMS /= stripN;
+			stripMeanPAN /= stripN;
+			double stripM2MS = 0;
+			double stripM2PAN = 0;
+			for(size_t p = 0; p < intensitySq.size(); ++p)
+			{
+				stripM2MS += (intensitySq[p] - stripMeanMS) * (intensitySq[p] - stripMeanMS);
+				stripM2PAN += (panSq[p] - stripMeanPAN) * (panSq[p] - stripMeanPAN);
+			}
+			
+			std::lock_guard<std::mutex> statsLock(statsMutex);
+			double newN = totalN + stripN;
+			double deltaMS = stripMeanMS - meanMS;
+			double deltaPAN = stripMeanPAN - meanPAN;
+			meanMS += deltaMS * (stripN / newN);
+			meanPAN += deltaPAN * (stripN / newN);
+			m2MS += stripM2MS + (deltaMS * deltaMS * ((totalN * stripN) / newN));
+			m2PAN += stripM2PAN + (deltaPAN * deltaPAN * ((totalN * stripN) / newN));
+			totalN = newN;
+		});
+		if(totalN == 0)
+		{
+			throw RSGISImageCalcException("There were no valid pixels to calculate the pan-sharpening statistics from.");
+		}
+		
+		this->imageStats[0] = meanMS;
+		this->imageStats[1] = meanPAN;
+		this->imageStats[2] = sqrt(m2MS / totalN);
+		this->imageStats[3] = sqrt(m2PAN / totalN);
+		if(this->imageStats[3] == 0)
+		{
+			throw RSGISImageCalcException("The panchromatic image has no variation so cannot be used for pan-sharpening.");
+		}
+		this->statsCalculated = true;
+	}
+	
+	void RSGISHCSPanSharpenFused::panSharpen(GDALDataset *msDataset, GDALDataset *panDataset, std::string outputImage, std::string gdalFormat, GDALDataType outDataType)
+	{
+		if(!this->statsCalculated)
+		{
+			this->calcStats(msDataset, panDataset);
+		}
+		this->checkDatasets(msDataset, panDataset);
+		int numMSBands = msDataset->GetRasterCount();
+		int panWidth = panDataset->GetRasterXSize();
+		int panHeight = panDataset->GetRasterYSize();
+		int msWidth = msDataset->GetRasterXSize();
+		int msHeight = msDataset->GetRasterYSize();
+		int halo = this->useNaiveMethod?0:(this->winSize / 2);
+		int numStrips = (panHeight + stripHeight - 1) / stripHeight;
+		
+		float meanMS = this->imageStats[0];
+		float meanPAN = this->imageStats[1];
+		float sdMS = this->imageStats[2];
+		float sdPAN = this->imageStats[3];
+		float statsGain = sdMS / sdPAN;
+		float statsOffset = (statsGain * (sdPAN - meanPAN)) + (meanMS - sdMS);
+		
+		std::vector<double> panCols(panWidth);
+		for(int i = 0; i < panWidth; ++i)
+		{
+			panCols[i] = i + 0.5;
+		}
+		ResampleAxis xAxis = calcResampleAxis(panCols, this->panTransform[0], this->panTransform[1], this->msTransform[0], this->msTransform[1], msWidth);
+		
+		rsgis::img::RSGISImageUtils imgUtils;
+		GDALDataset *outDataset = imgUtils.createCopy(panDataset, numMSBands, outputImage, gdalFormat, outDataType);
+		
+		// GDAL dataset handles are not thread safe so all RasterIO calls are serialised.
+		std::mutex ioMutex;
+		rsgis::utils::RSGISWorkerPool pool(std::max(1u, std::min(this->numThreads, (unsigned int)numStrips)));
+		try
+		{
+			pool.parallelFor(numStrips, [&](size_t stripIdx, unsigned int)
+			{
+				std::vector<float> panData;
+				std::vector<float> panSmooth;
+				std::vector<double> colSums;
+				std::vector<float> msData;
+				std::vector<float> msResampled;
+				std::vector<float*> msPlanes(numMSBands);
+				std::vector<float> scale;
+				int rowOff = stripIdx * stripHeight;
+				int numRows = std::min(stripHeight, panHeight - rowOff);
+				size_t numPxls = ((size_t)panWidth) * numRows;
+				
+				// The pan rows of the strip with a halo for the smoothing window.
+				int readRowOff = std::max(rowOff - halo, 0);
+				int readRows = std::min(rowOff + numRows + halo, panHeight) - readRowOff;
+				panData.resize(((size_t)panWidth) * readRows);
+				{
+					std::lock_guard<std::mutex> ioLock(ioMutex);
+					panDataset->GetRasterBand(1)->RasterIO(GF_Read, 0, readRowOff, panWidth, readRows, panData.data(), panWidth, readRows, GDT_Float32, 0, 0);
+				}
+				const float *pan = panData.data() + (((size_t)(rowOff - readRowOff)) * panWidth);
+				
+				std::vector<double> panRows(numRows);
+				for(int j = 0; j < numRows; ++j)
+				{
+					panRows[j] = rowOff + j + 0.5;
+				}
+				ResampleAxis yAxis = calcResampleAxis(panRows, this->panTransform[3], this->panTransform[5], this->msTransform[3], this->msTransform[5], msHeight);
+				msResampled.resize(numPxls * numMSBands);
+				for(int b = 0; b < numMSBands; ++b)
+				{
+					msPlanes[b] = msResampled.data() + (b * numPxls);
+				}
+				this->readResampledMS(msDataset, xAxis, yAxis, msData, msPlanes.data(), ioMutex);
+				
+				if(!this->useNaiveMethod)
+				{
+					// The mean of the window (clipped at the image edges) from the sums of
+					// the window's rows for each column, slid along the row.
+					panSmooth.resize(numPxls);
+					colSums.resize(panWidth);
+					for(int y = 0; y < numRows; ++y)
+					{
+						int winRow0 = std::max(rowOff + y - halo, 0) - readRowOff;
+						int winRow1 = std::min(rowOff + y + halo, panHeight - 1) - readRowOff;
+						std::fill(colSums.begin(), colSums.end(), 0.0);
+						for(int r = winRow0; r <= winRow1; ++r)
+						{
+							const float *panRow = panData.data() + (((size_t)r) * panWidth);
+							for(int x = 0; x < panWidth; ++x)
+							{
+								colSums[x] += panRow[x];
+							}
+						}
+						int numWinRows = winRow1 - winRow0 + 1;
+						double winSum = 0;
+						for(int x = 0; x < std::min(halo, panWidth); ++x)
+						{
+							winSum += colSums[x];
+						}
+						float *smoothRow = panSmooth.data() + (((size_t)y) * panWidth);
+						for(int x = 0; x < panWidth; ++x)
+						{
+							if((x + halo) < panWidth)
+							{
+								winSum += colSums[x + halo];
+							}
+							if((x - halo - 1) >= 0)
+							{
+								winSum -= colSums[x - halo - 1];
+							}
+							int numWinCols = std::min(x + halo, panWidth - 1) - std::max(x - halo, 0) + 1;
+							smoothRow[x] = winSum / (numWinRows * numWinCols);
+						}
+					}
+				}
+				
+				// The intensity scale factor iAdj/I for each pixel.
+				scale.assign(numPxls, 0.0f);
+				for(int b = 0; b < numMSBands; ++b)
+				{
+					const float *msPlane = msPlanes[b];
+					for(size_t p = 0; p < numPxls; ++p)
+					{
+						scale[p] += msPlane[p] * msPlane[p];
+					}
+				}
+				for(size_t p = 0; p < numPxls; ++p)
+				{
+					float iSq = scale[p];
+					float pSq = (statsGain * (pan[p] * pan[p])) + statsOffset;
+					float iAdjSq = 0;
+					if(this->useNaiveMethod)
+					{
+						iAdjSq = pSq;
+					}
+					else
+					{
+						float pSqSmooth = (statsGain * (panSmooth[p] * panSmooth[p])) + statsOffset;
+						iAdjSq = (pSqSmooth != 0)?((pSq / pSqSmooth) * iSq):0;
+					}
+					scale[p] = ((iSq > 0) && (iAdjSq > 0))?sqrt(iAdjSq / iSq):0;
+				}
+				for(int b = 0; b < numMSBands; ++b)
+				{
+					float *msPlane = msPlanes[b];
+					for(size_t p = 0; p < numPxls; ++p)
+					{
+						msPlane[p] *= scale[p];
+					}
+				}
+				
+				std::lock_guard<std::mutex> ioLock(ioMutex);
+				for(int b = 0; b < numMSBands; ++b)
+				{
+					outDataset->GetRasterBand(b+1)->RasterIO(GF_Write, 0, rowOff, panWidth, numRows, msPlanes[b], panWidth, numRows, GDT_Float32, 0, 0);
+				}
+			});
+		}
+		catch(...)
+		{
+			GDALClose(outDataset);
+			throw;
+		}
+		GDALClose(outDataset);
+	}
+	
+	RSGISHCSPanSharpenFused::~RSGISHCSPanSharpenFused()
+	{
+		
+	}
 
 }}
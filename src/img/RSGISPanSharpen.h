@@ -23,13 +23,25 @@
 
 #include <string>
 #include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <exception>
+
+#include "gdal_priv.h"
 
 #include "common/RSGISException.h"
 #include "common/RSGISImageException.h"
+#include "common/RSGISParallel.h"
 #include "img/RSGISImageCalcException.h"
 
 #include "img/RSGISCalcImage.h"
 #include "img/RSGISCalcImageValue.h"
+#include "img/RSGISImageUtils.h"
 
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
@@ -125,5 +137,80 @@ namespace rsgis { namespace img {
 		long int nPix;
 	};
 	
+	/**
+	 Hyperspherical Colour Space (HCS) pan-sharpening directly from the multispectral
+	 and panchromatic images, without first resampling the multispectral image to the
+	 panchromatic resolution and stacking them (as needed by RSGISHCSPanSharpen).
+	 
+	 The multispectral bands are bilinearly resampled to the panchromatic grid strip by
+	 strip as they are read. The statistics (the mean and standard deviation of the
+	 squared multispectral intensity and panchromatic values, over the pixels with a
+	 first band > 0) are accumulated in a single pass; with a statsDecimation of n
+	 only every nth pan row and column is read (GDAL decimates the read, so overviews
+	 are used where available). The sharpening pass then applies the transform to
+	 each strip on numThreads threads, with the (smart method) pan smoothing done with
+	 running sums.
+	 
+	 As the reverse transform uses the angles of the forward transform with the adjusted
+	 intensity, each pixel's multispectral vector is scaled by iAdj/I (Padwick et al.
+	 2010), so no trigonometric functions are needed.
+	 */
+	class DllExport RSGISHCSPanSharpenFused
+	{
+	public:
+		RSGISHCSPanSharpenFused(unsigned int winSize=7, bool useNaiveMethod=false, unsigned int statsDecimation=1);
+		/**
+		 The number of threads (0 uses the number of cores). Defaults to RSGISLIB_NUM_THREADS.
+		 */
+		void setNumThreads(unsigned int numThreads);
+		/**
+		 Calculate the statistics (meanMS, meanPAN, sdMS, sdPAN) used by panSharpen.
+		 */
+		void calcStats(GDALDataset *msDataset, GDALDataset *panDataset);
+		/**
+		 The statistics in the order used by RSGISHCSPanSharpen.
+		 */
+		const float* getImageStats() const {return this->imageStats;};
+		/**
+		 Create the pan-sharpened image, on the panchromatic grid, calculating the
+		 statistics first if they have not been.
+		 */
+		void panSharpen(GDALDataset *msDataset, GDALDataset *panDataset, std::string outputImage, std::string gdalFormat, GDALDataType outDataType);
+		~RSGISHCSPanSharpenFused();
+	protected:
+		/**
+		 The pair of multispectral pixels and the weight of the second used for each
+		 position along one axis of the panchromatic grid.
+		 */
+		struct ResampleAxis
+		{
+			std::vector<int> idx0;
+			std::vector<int> idx1;
+			std::vector<float> weight;
+			int minIdx;
+			int maxIdx;
+		};
+		/**
+		 The axis for positions (in panchromatic pixels from the image origin) given the
+		 image origins and pixel sizes along the axis.
+		 */
+		static ResampleAxis calcResampleAxis(const std::vector<double> &panCoords, double panOrigin, double panRes, double msOrigin, double msRes, int msSize);
+		/**
+		 Read (under ioMutex) and resample the multispectral bands to the positions
+		 of the axes, writing a plane of xAxis x yAxis values for each band.
+		 */
+		void readResampledMS(GDALDataset *msDataset, const ResampleAxis &xAxis, const ResampleAxis &yAxis, std::vector<float> &msData, float **msPlanes, std::mutex &ioMutex);
+		void checkDatasets(GDALDataset *msDataset, GDALDataset *panDataset);
+		static const int stripHeight;
+		unsigned int winSize;
+		bool useNaiveMethod;
+		unsigned int statsDecimation;
+		unsigned int numThreads;
+		bool statsCalculated;
+		float imageStats[4];
+		double msTransform[6];
+		double panTransform[6];
+	};
+	
 }}
 
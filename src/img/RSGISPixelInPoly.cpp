@@ -158,6 +158,19 @@ namespace rsgis{namespace img {
         }
     }
 
+    void RSGISGetPixelsInPoly::calcImageRowExtent(const float* const* bandRows, int numBands, size_t nPxls, double originX, double originY, double xStep, double pxlWidth, double pxlHeight)
+    {
+        if(numBands != nBands)
+        {
+            throw RSGISImageCalcException("The number of bands being returned is not the same as the inputted pxlVals structure.");
+        }
+
+        for(unsigned int i = 0; i < nBands; ++i)
+        {
+            pxlVals[i]->insert(pxlVals[i]->end(), bandRows[i], bandRows[i] + nPxls);
+        }
+    }
+
     RSGISGetPixelsInPoly::~RSGISGetPixelsInPoly()
     {
 
@@ -170,6 +170,10 @@ namespace rsgis{namespace img {
         void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageCalcException("Not implemented");};
         void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output, geos::geom::Envelope extent) {throw RSGISImageCalcException("No implemented");};
         bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageCalcException("Not implemented");};
+        /**
+         * Append the values of a run of pixels to pxlVals a band at a time.
+         */
+        void calcImageRowExtent(const float* const* bandRows, int numBands, size_t nPxls, double originX, double originY, double xStep, double pxlWidth, double pxlHeight);
         ~RSGISGetPixelsInPoly();
     protected:
         std::vector<float> **pxlVals;
@@ -47,7 +47,13 @@ namespace rsgis{namespace img{
 	
 	void RSGISPolygonPixelCount::calcImageValue(float *bandValuesImage, double interceptArea, int numBands, geos::geom::Polygon *poly, geos::geom::Point *pt) 
 	{
-		if(poly->contains(pt))
+		if(pt == NULL)
+		{
+			// The pixels were found by RSGISPolygonRasteriser; the area
+			// in pixels for pixelAreaInPoly, otherwise the count.
+			n += interceptArea;
+		}
+		else if(poly->contains(pt))
 		{
 			n++;
 		}
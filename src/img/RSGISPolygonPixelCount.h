@@ -56,7 +56,7 @@ namespace rsgis{namespace img{
 			void reset();
 			~RSGISPolygonPixelCount();
 		protected:
-			int n;
+			double n;
 		};
 }}
 
@@ -0,0 +1,488 @@
+/*
+ *  RSGISPolygonRasteriser.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2008 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISPolygonRasteriser.h"
+
+namespace rsgis{namespace img{
+
+    // Tolerance on the covered fraction of a pixel for the area based options.
+    static const double RSGIS_RASTER_COVER_TOL = 1e-6;
+
+    RSGISPolygonRasteriser::RSGISPolygonRasteriser(double tlX, double tlY, double pxlWidth, double pxlHeight, long width, long height)
+    {
+        if((pxlWidth <= 0) || (pxlHeight <= 0))
+        {
+            throw RSGISImageCalcException("The pixel size for rasterising a polygon must be positive.");
+        }
+        this->tlX = tlX;
+        this->tlY = tlY;
+        this->pxlWidth = pxlWidth;
+        this->pxlHeight = pxlHeight;
+        this->width = (width < 0)?0:width;
+        this->height = (height < 0)?0:height;
+        this->polyArea = 0;
+        this->edgesSorted = true;
+    }
+
+    bool RSGISPolygonRasteriser::supportsMethod(pixelInPolyOption method)
+    {
+        return (method == polyContainsPixel) || (method == polyContainsPixelCenter) || (method == polyOverlapsPixel) || (method == polyOverlapsOrContainsPixel) || (method == envelope) || (method == pixelAreaInPoly);
+    }
+
+    bool RSGISPolygonRasteriser::supportsGeometry(OGRGeometry *geom)
+    {
+        if(geom == NULL)
+        {
+            return false;
+        }
+        OGRwkbGeometryType geomType = wkbFlatten(geom->getGeometryType());
+        return (geomType == wkbPolygon) || (geomType == wkbMultiPolygon);
+    }
+
+    void RSGISPolygonRasteriser::setPolygon(OGRGeometry *geom)
+    {
+        if(!RSGISPolygonRasteriser::supportsGeometry(geom))
+        {
+            throw RSGISImageCalcException("Only polygons and multi-polygons can be rasterised.");
+        }
+        this->clear();
+
+        std::vector<OGRPolygon*> polys;
+        if(wkbFlatten(geom->getGeometryType()) == wkbPolygon)
+        {
+            polys.push_back((OGRPolygon*) geom);
+        }
+        else
+        {
+            OGRGeometryCollection *geomColl = (OGRGeometryCollection*) geom;
+            for(int i = 0; i < geomColl->getNumGeometries(); ++i)
+            {
+                polys.push_back((OGRPolygon*) geomColl->getGeometryRef(i));
+            }
+        }
+
+        std::vector<double> xCoords;
+        std::vector<double> yCoords;
+        for(std::vector<OGRPolygon*>::iterator iterPolys = polys.begin(); iterPolys != polys.end(); ++iterPolys)
+        {
+            for(int r = -1; r < (*iterPolys)->getNumInteriorRings(); ++r)
+            {
+                OGRLinearRing *ring = (r < 0)?(*iterPolys)->getExteriorRing():(*iterPolys)->getInteriorRing(r);
+                if(ring == NULL)
+                {
+                    continue;
+                }
+                int numPts = ring->getNumPoints();
+                xCoords.resize(numPts);
+                yCoords.resize(numPts);
+                for(int i = 0; i < numPts; ++i)
+                {
+                    xCoords[i] = ring->getX(i);
+                    yCoords[i] = ring->getY(i);
+                }
+                this->addRing(xCoords, yCoords, (r >= 0));
+            }
+        }
+    }
+
+    void RSGISPolygonRasteriser::setPolygon(const geos::geom::Polygon *poly)
+    {
+        this->clear();
+        std::vector<double> xCoords;
+        std::vector<double> yCoords;
+        long numInteriorRings = poly->getNumInteriorRing();
+        for(long r = -1; r < numInteriorRings; ++r)
+        {
+            const geos::geom::LineString *ring = (r < 0)?poly->getExteriorRing():poly->getInteriorRingN(r);
+            const geos::geom::CoordinateSequence *coords = ring->getCoordinatesRO();
+            size_t numPts = coords->getSize();
+            xCoords.resize(numPts);
+            yCoords.resize(numPts);
+            for(size_t i = 0; i < numPts; ++i)
+            {
+                xCoords[i] = coords->getX(i);
+                yCoords[i] = coords->getY(i);
+            }
+            this->addRing(xCoords, yCoords, (r >= 0));
+        }
+    }
+
+    void RSGISPolygonRasteriser::addRing(const std::vector<double> &xCoords, const std::vector<double> &yCoords, bool hole)
+    {
+        size_t numPts = std::min(xCoords.size(), yCoords.size());
+        if(numPts < 3)
+        {
+            return;
+        }
+
+        // To pixel coordinates (y down the rows).
+        this->ringX.resize(numPts);
+        this->ringY.resize(numPts);
+        for(size_t i = 0; i < numPts; ++i)
+        {
+            this->ringX[i] = (xCoords[i] - this->tlX) / this->pxlWidth;
+            this->ringY[i] = (this->tlY - yCoords[i]) / this->pxlHeight;
+        }
+
+        // Orient the exterior rings positive and the holes negative so holes cancel.
+        double ringArea = 0;
+        for(size_t i = 0; i < numPts; ++i)
+        {
+            size_t j = (i+1) % numPts;
+            ringArea += (this->ringX[i] * this->ringY[j]) - (this->ringX[j] * this->ringY[i]);
+        }
+        ringArea /= 2;
+        if(ringArea == 0)
+        {
+            return;
+        }
+        int ringDir = (ringArea > 0)?1:-1;
+        if(hole)
+        {
+            ringDir = -ringDir;
+            this->polyArea -= fabs(ringArea);
+        }
+        else
+        {
+            this->polyArea += fabs(ringArea);
+        }
+
+        // The ring may or may not be closed.
+        for(size_t i = 0; i < numPts; ++i)
+        {
+            size_t j = (i+1) % numPts;
+            this->addSegment(this->ringX[i], this->ringY[i], this->ringX[j], this->ringY[j], ringDir);
+        }
+        this->edgesSorted = false;
+    }
+
+    void RSGISPolygonRasteriser::clear()
+    {
+        this->edges.clear();
+        this->polyArea = 0;
+        this->edgesSorted = true;
+    }
+
+    void RSGISPolygonRasteriser::findPixelSpans(pixelInPolyOption method, std::vector<RSGISPixelSpan> *spans, std::vector<float> *weights)
+    {
+        if(!RSGISPolygonRasteriser::supportsMethod(method))
+        {
+            throw RSGISImageCalcException("The pixel in polygon method is not supported by the polygon rasteriser.");
+        }
+        spans->clear();
+        if(weights != NULL)
+        {
+            weights->clear();
+        }
+        if((this->width == 0) || (this->height == 0))
+        {
+            return;
+        }
+
+        RSGISPixelSpan span;
+        if(method == envelope)
+        {
+            for(long row = 0; row < this->height; ++row)
+            {
+                span.row = row;
+                span.xStart = 0;
+                span.xEnd = this->width;
+                spans->push_back(span);
+            }
+            if(weights != NULL)
+            {
+                weights->assign(this->width * this->height, 1.0);
+            }
+            return;
+        }
+
+        if(!this->edgesSorted)
+        {
+            std::sort(this->edges.begin(), this->edges.end(), [](const RSGISRasterEdge &a, const RSGISRasterEdge &b){return a.y0 < b.y0;});
+            this->edgesSorted = true;
+        }
+
+        // Two extra entries as an edge on the right of the grid accumulates past the last pixel.
+        std::vector<double> acc(this->width+2, 0.0);
+        std::vector<std::pair<double, int> > crossings;
+        std::vector<size_t> activeEdges;
+        size_t nextEdge = 0;
+        for(long row = 0; row < this->height; ++row)
+        {
+            // Update the edges crossing this row.
+            size_t numActive = 0;
+            for(size_t i = 0; i < activeEdges.size(); ++i)
+            {
+                if(this->edges[activeEdges[i]].y1 > row)
+                {
+                    activeEdges[numActive++] = activeEdges[i];
+                }
+            }
+            activeEdges.resize(numActive);
+            while((nextEdge < this->edges.size()) && (this->edges[nextEdge].y0 < (row+1)))
+            {
+                if(this->edges[nextEdge].y1 > row)
+                {
+                    activeEdges.push_back(nextEdge);
+                }
+                ++nextEdge;
+            }
+            if(activeEdges.empty())
+            {
+                if(nextEdge == this->edges.size())
+                {
+                    break;
+                }
+                continue;
+            }
+
+            span.row = row;
+            if(method == polyContainsPixelCenter)
+            {
+                // Non-zero winding at the centre of the row.
+                double yCentre = row + 0.5;
+                crossings.clear();
+                for(std::vector<size_t>::iterator iterEdge = activeEdges.begin(); iterEdge != activeEdges.end(); ++iterEdge)
+                {
+                    const RSGISRasterEdge &edge = this->edges[*iterEdge];
+                    if((edge.y0 <= yCentre) && (yCentre < edge.y1))
+                    {
+                        double x = edge.x0 + ((yCentre - edge.y0) * (edge.x1 - edge.x0) / (edge.y1 - edge.y0));
+                        crossings.push_back(std::pair<double, int>(x, edge.dir));
+                    }
+                }
+                std::sort(crossings.begin(), crossings.end());
+                int winding = 0;
+                double spanStartX = 0;
+                for(std::vector<std::pair<double, int> >::iterator iterCross = crossings.begin(); iterCross != crossings.end(); ++iterCross)
+                {
+                    int prevWinding = winding;
+                    winding += (*iterCross).second;
+                    if((prevWinding == 0) && (winding != 0))
+                    {
+                        spanStartX = (*iterCross).first;
+                    }
+                    else if((prevWinding != 0) && (winding == 0))
+                    {
+                        // Pixels with their centre in [spanStartX, x).
+                        span.xStart = std::max<long>((long)ceil(spanStartX - 0.5), 0);
+                        span.xEnd = std::min<long>((long)ceil((*iterCross).first - 0.5), this->width);
+                        if(span.xEnd > span.xStart)
+                        {
+                            spans->push_back(span);
+                            if(weights != NULL)
+                            {
+                                weights->insert(weights->end(), span.xEnd - span.xStart, 1.0);
+                            }
+                        }
+                    }
+                }
+            }
+            else
+            {
+                std::fill(acc.begin(), acc.end(), 0.0);
+                for(std::vector<size_t>::iterator iterEdge = activeEdges.begin(); iterEdge != activeEdges.end(); ++iterEdge)
+                {
+                    this->accumulateEdge(this->edges[*iterEdge], row, acc.data());
+                }
+                double winding = 0;
+                span.xStart = -1;
+                for(long x = 0; x < this->width; ++x)
+                {
+                    winding += acc[x];
+                    double cover = std::min(fabs(winding), 1.0);
+                    if(this->coverSelected(method, cover))
+                    {
+                        if(span.xStart < 0)
+                        {
+                            span.xStart = x;
+                        }
+                        if(weights != NULL)
+                        {
+                            weights->push_back(cover);
+                        }
+                    }
+                    else if(span.xStart >= 0)
+                    {
+                        span.xEnd = x;
+                        spans->push_back(span);
+                        span.xStart = -1;
+                    }
+                }
+                if(span.xStart >= 0)
+                {
+                    span.xEnd = this->width;
+                    spans->push_back(span);
+                }
+            }
+        }
+    }
+
+    void RSGISPolygonRasteriser::addSegment(double x0, double y0, double x1, double y1, int dir)
+    {
+        // Split the segment where it crosses the left and right of the grid and
+        // clamp the parts outside onto the grid edge; a part on the left still
+        // covers the pixels to its right and a part on the right covers none.
+        double gridMaxX = this->width;
+        double splitT[2];
+        unsigned int numSplits = 0;
+        if(x0 != x1)
+        {
+            double t = (0 - x0) / (x1 - x0);
+            if((t > 0) && (t < 1))
+            {
+                splitT[numSplits++] = t;
+            }
+            t = (gridMaxX - x0) / (x1 - x0);
+            if((t > 0) && (t < 1))
+            {
+                splitT[numSplits++] = t;
+            }
+            if((numSplits == 2) && (splitT[1] < splitT[0]))
+            {
+                std::swap(splitT[0], splitT[1]);
+            }
+        }
+
+        double prevX = x0;
+        double prevY = y0;
+        for(unsigned int i = 0; i <= numSplits; ++i)
+        {
+            double nextX = x1;
+            double nextY = y1;
+            if(i < numSplits)
+            {
+                nextX = x0 + (splitT[i] * (x1 - x0));
+                nextY = y0 + (splitT[i] * (y1 - y0));
+            }
+            this->addEdge(std::min(std::max(prevX, 0.0), gridMaxX), prevY, std::min(std::max(nextX, 0.0), gridMaxX), nextY, dir);
+            prevX = nextX;
+            prevY = nextY;
+        }
+    }
+
+    void RSGISPolygonRasteriser::addEdge(double x0, double y0, double x1, double y1, int dir)
+    {
+        if(y0 == y1)
+        {
+            return;
+        }
+        RSGISRasterEdge edge;
+        if(y0 < y1)
+        {
+            edge.x0 = x0;
+            edge.y0 = y0;
+            edge.x1 = x1;
+            edge.y1 = y1;
+            edge.dir = dir;
+        }
+        else
+        {
+            edge.x0 = x1;
+            edge.y0 = y1;
+            edge.x1 = x0;
+            edge.y1 = y0;
+            edge.dir = -dir;
+        }
+        this->edges.push_back(edge);
+    }
+
+    void RSGISPolygonRasteriser::accumulateEdge(const RSGISRasterEdge &edge, long row, double *acc)
+    {
+        // The part of the edge within the row.
+        double yA = std::max<double>(row, edge.y0);
+        double yB = std::min<double>(row+1, edge.y1);
+        if(yB <= yA)
+        {
+            return;
+        }
+        double dxdy = (edge.x1 - edge.x0) / (edge.y1 - edge.y0);
+        double gridMaxX = this->width;
+        double xA = std::min(std::max(edge.x0 + ((yA - edge.y0) * dxdy), 0.0), gridMaxX);
+        double xB = std::min(std::max(edge.x0 + ((yB - edge.y0) * dxdy), 0.0), gridMaxX);
+        double d = (yB - yA) * edge.dir;
+
+        // Add the area covered to the right of the edge in each pixel it passes
+        // through, the running sum along the row then gives the cover of each pixel.
+        double xMin = std::min(xA, xB);
+        double xMax = std::max(xA, xB);
+        double xMinFloor = floor(xMin);
+        long xMinIdx = (long)xMinFloor;
+        double xMaxCeil = ceil(xMax);
+        long xMaxIdx = (long)xMaxCeil;
+        if(xMaxIdx <= (xMinIdx + 1))
+        {
+            double xMidFrac = (0.5 * (xA + xB)) - xMinFloor;
+            acc[xMinIdx] += d - (d * xMidFrac);
+            acc[xMinIdx+1] += d * xMidFrac;
+        }
+        else
+        {
+            double s = 1.0 / (xMax - xMin);
+            double xMinFrac = xMin - xMinFloor;
+            double aMin = 0.5 * s * (1 - xMinFrac) * (1 - xMinFrac);
+            double xMaxFrac = xMax - xMaxCeil + 1;
+            double aMax = 0.5 * s * xMaxFrac * xMaxFrac;
+            acc[xMinIdx] += d * aMin;
+            if(xMaxIdx == (xMinIdx + 2))
+            {
+                acc[xMinIdx+1] += d * (1 - aMin - aMax);
+            }
+            else
+            {
+                double a1 = s * (1.5 - xMinFrac);
+                acc[xMinIdx+1] += d * (a1 - aMin);
+                for(long x = xMinIdx+2; x < (xMaxIdx-1); ++x)
+                {
+                    acc[x] += d * s;
+                }
+                double a2 = a1 + ((xMaxIdx - xMinIdx - 3) * s);
+                acc[xMaxIdx-1] += d * (1 - a2 - aMax);
+            }
+            acc[xMaxIdx] += d * aMax;
+        }
+    }
+
+    bool RSGISPolygonRasteriser::coverSelected(pixelInPolyOption method, double cover)
+    {
+        // Whether the whole polygon is within the pixel, in which case the pixel contains it rather than overlaps it.
+        bool polyInPixel = (cover < (1 - RSGIS_RASTER_COVER_TOL)) && (fabs(cover - this->polyArea) < RSGIS_RASTER_COVER_TOL);
+        if(method == polyContainsPixel)
+        {
+            return cover >= (1 - RSGIS_RASTER_COVER_TOL);
+        }
+        else if(method == polyOverlapsPixel)
+        {
+            return (cover > RSGIS_RASTER_COVER_TOL) && (cover < (1 - RSGIS_RASTER_COVER_TOL)) && !polyInPixel;
+        }
+        else if(method == polyOverlapsOrContainsPixel)
+        {
+            return (cover > RSGIS_RASTER_COVER_TOL) && !polyInPixel;
+        }
+        return cover > RSGIS_RASTER_COVER_TOL;
+    }
+
+    RSGISPolygonRasteriser::~RSGISPolygonRasteriser()
+    {
+
+    }
+
+}}
@@ -0,0 +1,142 @@
+/*
+ *  RSGISPolygonRasteriser.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2008 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISPolygonRasteriser_H
+#define RSGISPolygonRasteriser_H
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+#include "ogrsf_frmts.h"
+#include "geos/geom/Polygon.h"
+#include "geos/geom/LineString.h"
+#include "geos/geom/CoordinateSequence.h"
+
+#include "img/RSGISPixelInPoly.h"
+#include "img/RSGISImageCalcException.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_img_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace img{
+
+    /**
+     * A run of pixels, xStart to xEnd-1, on a row of the pixel grid.
+     */
+    struct DllExport RSGISPixelSpan
+    {
+        long row;
+        long xStart;
+        long xEnd;
+    };
+
+    /**
+     * Finds the pixels of a grid selected by a polygon (with holes) or
+     * multi-polygon for a pixelInPolyOption with a single scanline pass over
+     * the polygon edges, rather than testing a pixel geometry against the
+     * polygon for every pixel (RSGISPixelInPoly).
+     *
+     * The area of each pixel covered by the polygon is calculated exactly by
+     * accumulating the signed area under each edge along the rows, so the
+     * area based options are given the covered fraction of each pixel as a
+     * weight. Rings are oriented so holes cancel whatever their winding in
+     * the input.
+     *
+     * The pixelContainsPoly, pixelContainsPolyCenter and adaptive options are
+     * not supported (see supportsMethod) and should be handled by
+     * RSGISPixelInPoly.
+     */
+    class DllExport RSGISPolygonRasteriser
+    {
+    public:
+        /**
+         * The pixel grid, defined by its top left corner, the (positive) pixel
+         * width and height and the number of columns and rows.
+         */
+        RSGISPolygonRasteriser(double tlX, double tlY, double pxlWidth, double pxlHeight, long width, long height);
+        static bool supportsMethod(pixelInPolyOption method);
+        /**
+         * Whether the geometry is a polygon or multi-polygon.
+         */
+        static bool supportsGeometry(OGRGeometry *geom);
+        /**
+         * Replace the polygon with a polygon or multi-polygon.
+         */
+        void setPolygon(OGRGeometry *geom);
+        void setPolygon(const geos::geom::Polygon *poly);
+        /**
+         * Add a ring, in the coordinates of the grid, to the polygon.
+         */
+        void addRing(const std::vector<double> &xCoords, const std::vector<double> &yCoords, bool hole);
+        void clear();
+        /**
+         * The pixels selected by method, as spans in row order. If weights is
+         * not NULL it is given, for every pixel of the spans in order, the
+         * fraction of the pixel covered by the polygon (1 for the
+         * polyContainsPixelCenter and envelope options).
+         */
+        void findPixelSpans(pixelInPolyOption method, std::vector<RSGISPixelSpan> *spans, std::vector<float> *weights=NULL);
+        /**
+         * The area of the polygon in pixels.
+         */
+        double getPolyArea() const {return polyArea;};
+        ~RSGISPolygonRasteriser();
+    protected:
+        struct RSGISRasterEdge
+        {
+            // Pixel coordinates with y0 < y1.
+            double x0;
+            double y0;
+            double x1;
+            double y1;
+            int dir;
+        };
+        void addSegment(double x0, double y0, double x1, double y1, int dir);
+        void addEdge(double x0, double y0, double x1, double y1, int dir);
+        void accumulateEdge(const RSGISRasterEdge &edge, long row, double *acc);
+        bool coverSelected(pixelInPolyOption method, double cover);
+        double tlX;
+        double tlY;
+        double pxlWidth;
+        double pxlHeight;
+        long width;
+        long height;
+        double polyArea;
+        bool edgesSorted;
+        std::vector<RSGISRasterEdge> edges;
+        std::vector<double> ringX;
+        std::vector<double> ringY;
+    };
+
+}}
+
+#endif
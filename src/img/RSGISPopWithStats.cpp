@@ -29,10 +29,6 @@ namespace rsgis { namespace img {
     
     void RSGISPopWithStats::calcPopStats( GDALDataset *imgDS, bool useNoDataVal, float noDataVal, bool calcPyramid, std::vector<int> decimatFactors )
     {
-        rsgis::utils::RSGISTextUtils textUtils;
-        
-        int numBands = imgDS->GetRasterCount();
-        GDALRasterBand *band = NULL;
         const char *layerType = imgDS->GetRasterBand( 1 )->GetMetadataItem( "LAYER_TYPE" );
         if( layerType != NULL )
         {
@@ -43,27 +39,43 @@ namespace rsgis { namespace img {
             }
         }
         
-        // Iteration 1 through image: Min, Max and Mean
-        double *minVal = new double[numBands];
-        double *maxVal = new double[numBands];
-        double *meanVal = new double[numBands];
-        unsigned long *nVals = new unsigned long[numBands];
+        // A single pass through the image gives the min, max, mean and
+        // standard deviation along with a histogram of each band, which is
+        // then binned into 256 bins once the range is known.
+        RSGISSinglePassImageStats passStats(true);
+        passStats.calcStats(imgDS, useNoDataVal, noDataVal);
+        this->setImageStats(imgDS, passStats, useNoDataVal, noDataVal);
         
-        for(int i = 0; i < numBands; ++i)
+        if(calcPyramid)
         {
-            minVal[i] = 0;
-            maxVal[i] = 0;
-            meanVal[i] = 0;
-            nVals[i] = 0;
+            std::cout << "Calculating Image Pyramids.\n";
+            if(decimatFactors.size() == 0)
+            {
+                decimatFactors = RSGISPopWithStats::getDefaultPyramidLevels(imgDS->GetRasterXSize(), imgDS->GetRasterYSize());
+            }
+            
+            this->addPyramids(imgDS, decimatFactors);
         }
+    }
+    
+    void RSGISPopWithStats::setImageStats(GDALDataset *imgDS, const RSGISSinglePassImageStats &passStats, bool useNoDataVal, float noDataVal)
+    {
+        rsgis::utils::RSGISTextUtils textUtils;
+        int numBands = imgDS->GetRasterCount();
+        GDALRasterBand *band = NULL;
+        
         
-        RSGISCalcImageMinMaxMean calcImageStats = RSGISCalcImageMinMaxMean(numBands, useNoDataVal, noDataVal, minVal, maxVal, meanVal, nVals);
-        RSGISCalcImage calcImg = RSGISCalcImage(&calcImageStats, "", true);
-        calcImg.calcImage(&imgDS, 1);
+        double *minVal = new double[numBands];
+        double *maxVal = new double[numBands];
+        double *meanVal = new double[numBands];
+        unsigned long *nVals = new unsigned long[numBands];
         
         for(int i = 0; i < numBands; ++i)
         {
-            meanVal[i] = meanVal[i] / nVals[i];
+            minVal[i] = passStats.getMin(i);
+            maxVal[i] = passStats.getMax(i);
+            meanVal[i] = passStats.getMean(i);
+            nVals[i] = passStats.getCount(i);
             
             band = imgDS->GetRasterBand(i+1);
             band->SetMetadataItem( "STATISTICS_MINIMUM", textUtils.doubletostring(minVal[i]).c_str(), NULL );
@@ -77,7 +89,6 @@ namespace rsgis { namespace img {
             }
         }
         
-        // Iteration 2 through image: Std Dev + Histogram
         unsigned int numHistBins = 256;
         unsigned int **bandHist = new unsigned int*[numBands];
         
@@ -134,25 +145,22 @@ namespace rsgis { namespace img {
         
         double *stdDevVal = new double[numBands];
         unsigned long *nVals2 = new unsigned long[numBands];
+        std::vector<unsigned long long> binCounts;
         for(int i = 0; i < numBands; ++i)
         {
-            stdDevVal[i] = 0;
-            nVals2[i] = 0;
+            stdDevVal[i] = passStats.getStdDev(i);
+            nVals2[i] = passStats.getCount(i);
+            // Bins are centred on the minimum plus a multiple of the bin width.
+            passStats.getHistogram(i)->getBinCounts(minVal[i] - (histWidth[i]/2), histWidth[i], numHistBins, &binCounts);
             bandHist[i] = new unsigned int[numHistBins];
             for(unsigned int j = 0; j < numHistBins; ++j)
             {
-                bandHist[i][j] = 0;
+                bandHist[i][j] = binCounts[j];
             }
         }
-        RSGISCalcImageStdDevPopHist calcImageHistSD = RSGISCalcImageStdDevPopHist(numBands, useNoDataVal, noDataVal, minVal, maxVal, meanVal, stdDevVal, nVals2, histMin, histMax, histWidth, bandHist, numHistBins);
-        calcImg = RSGISCalcImage(&calcImageHistSD, "", true);
-        calcImg.calcImage(&imgDS, 1);
-        
         
         for(int i = 0; i < numBands; ++i)
         {
-            stdDevVal[i] = sqrt(stdDevVal[i] / nVals2[i]);
-            
             band = imgDS->GetRasterBand(i+1);
             band->SetMetadataItem( "STATISTICS_STDDEV", textUtils.doubletostring(stdDevVal[i]).c_str(), NULL );
             band->SetMetadataItem( "STATISTICS_HISTOMIN", textUtils.doubletostring(minVal[i]).c_str(), NULL );
@@ -220,32 +228,28 @@ namespace rsgis { namespace img {
             unsigned int histoColIdx = this->findColumnIndexOrCreate(attTable, "Histogram", GFT_Real, GFU_PixelCount);
             attTable->ValuesIO(GF_Write, histoColIdx, 0, 256, (int*) bandHist[i]);
         }
+    }
+    
+    std::vector<int> RSGISPopWithStats::getDefaultPyramidLevels(int xSize, int ySize)
+    {
+        std::vector<int> decimatFactors;
+        int minOverviewDim = 33;
         
-        if(calcPyramid)
+        int minDim = xSize;
+        if(ySize < minDim)
         {
-            std::cout << "Calculating Image Pyramids.\n";
-            if(decimatFactors.size() == 0)
+            minDim = ySize;
+        }
+        
+        int nLevels[] = { 4, 8, 16, 32, 64, 128, 256, 512 };
+        for(int i = 0; i < 8; i++)
+        {
+            if( (minDim/nLevels[i]) > minOverviewDim )
             {
-                int minOverviewDim = 33;
-                
-                int minDim = imgDS->GetRasterXSize();
-                if(imgDS->GetRasterYSize() < minDim)
-                {
-                    minDim = imgDS->GetRasterYSize();
-                }
-                
-                int nLevels[] = { 4, 8, 16, 32, 64, 128, 256, 512 };
-                for(int i = 0; i < 8; i++)
-                {
-                    if( (minDim/nLevels[i]) > minOverviewDim )
-                    {
-                        decimatFactors.push_back(nLevels[i]);
-                    }
-                }
+                decimatFactors.push_back(nLevels[i]);
             }
-            
-            this->addPyramids(imgDS, decimatFactors);
         }
+        return decimatFactors;
     }
     
     void RSGISPopWithStats::addPyramids(GDALDataset *imgDS, std::vector<int> decimatFactors)
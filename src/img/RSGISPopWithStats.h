@@ -46,6 +46,7 @@
 #include "img/RSGISCalcImageValue.h"
 #include "img/RSGISImageUtils.h"
 #include "img/RSGISCalcImage.h"
+#include "img/RSGISSinglePassImageStats.h"
 
 #include "utils/RSGISTextUtils.h"
 
@@ -151,6 +152,15 @@ namespace rsgis { namespace img {
     public:
         RSGISPopWithStats(){};
         void calcPopStats( GDALDataset *imgDS, bool useNoDataVal, float noDataVal, bool calcPyramid, std::vector<int> decimatFactors=std::vector<int>());
+        /**
+         * Write the statistics and histogram metadata of the bands of an
+         * image from statistics already calculated (with histograms).
+         */
+        void setImageStats(GDALDataset *imgDS, const RSGISSinglePassImageStats &passStats, bool useNoDataVal, float noDataVal);
+        /**
+         * The decimation factors used for the pyramids when none are given.
+         */
+        static std::vector<int> getDefaultPyramidLevels(int xSize, int ySize);
         ~RSGISPopWithStats(){};
     private:
         void addPyramids(GDALDataset *imgDS, std::vector<int> decimatFactors);
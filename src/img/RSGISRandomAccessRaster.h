@@ -0,0 +1,215 @@
+/*
+ *  RSGISRandomAccessRaster.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2008 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISRandomAccessRaster_H
+#define RSGISRandomAccessRaster_H
+
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+#include "gdal_priv.h"
+
+#include "img/RSGISImageCalcException.h"
+#include "img/RSGISImageNativeIO.h"
+
+namespace rsgis{namespace img{
+
+    /**
+     * Random pixel access to an image band through an LRU cache of square
+     * tiles, for algorithms which walk pixel neighbourhoods (region growing,
+     * flood filling, clump merging) and would otherwise make a 1x1 RasterIO
+     * call for every pixel visited.
+     *
+     * Tiles are read, as type T, on first access and when the memory budget
+     * is used the least recently used tile is dropped, being written back
+     * first if it has been changed. Changes are only guaranteed to be in the
+     * band once flush() has been called; the destructor does not flush.
+     *
+     * The band should not be accessed by other means while there are
+     * unflushed changes and the cache is not thread safe.
+     */
+    template <typename T> class RSGISRandomAccessRaster
+    {
+    public:
+        /**
+         * memBudget is the maximum number of bytes of tiles to hold (at least
+         * four tiles are always allowed so a neighbourhood across a tile corner
+         * does not thrash).
+         */
+        RSGISRandomAccessRaster(GDALRasterBand *band, size_t memBudget=256*1024*1024, unsigned int tileSize=256)
+        {
+            if(band == NULL)
+            {
+                throw RSGISImageCalcException("The image band for random access is NULL.");
+            }
+            this->band = band;
+            this->xSize = band->GetXSize();
+            this->ySize = band->GetYSize();
+            this->tileSize = (tileSize == 0)?256:tileSize;
+            this->nXTiles = (this->xSize + this->tileSize - 1) / this->tileSize;
+            this->nYTiles = (this->ySize + this->tileSize - 1) / this->tileSize;
+            this->tileSlots.assign(((size_t)this->nXTiles) * this->nYTiles, -1);
+            size_t tileBytes = ((size_t)this->tileSize) * this->tileSize * sizeof(T);
+            this->maxNumTiles = std::min<size_t>(std::max<size_t>(memBudget/tileBytes, 4), this->tileSlots.size());
+            // Reserved so pointers to the tiles are not invalidated as tiles are added.
+            this->tiles.reserve(this->maxNumTiles);
+            this->useCounter = 0;
+            this->numTileReads = 0;
+            this->numTileWrites = 0;
+            this->lastTileIdx = -1;
+            this->lastTile = NULL;
+        };
+        inline T get(long x, long y)
+        {
+            return this->getTile(x, y, false)[((y % this->tileSize) * this->tileSize) + (x % this->tileSize)];
+        };
+        inline void set(long x, long y, T val)
+        {
+            this->getTile(x, y, true)[((y % this->tileSize) * this->tileSize) + (x % this->tileSize)] = val;
+        };
+        inline bool inImage(long x, long y) const
+        {
+            return (x >= 0) && (y >= 0) && (x < this->xSize) && (y < this->ySize);
+        };
+        long getXSize() const {return xSize;};
+        long getYSize() const {return ySize;};
+        size_t getNumTileReads() const {return numTileReads;};
+        size_t getNumTileWrites() const {return numTileWrites;};
+        /**
+         * Write all the changed tiles back to the band.
+         */
+        void flush()
+        {
+            for(typename std::vector<RATile>::iterator iterTiles = this->tiles.begin(); iterTiles != this->tiles.end(); ++iterTiles)
+            {
+                if((*iterTiles).dirty)
+                {
+                    this->tileIO(GF_Write, &(*iterTiles));
+                    (*iterTiles).dirty = false;
+                }
+            }
+        };
+        ~RSGISRandomAccessRaster(){};
+    protected:
+        struct RATile
+        {
+            long tileIdx;
+            bool dirty;
+            size_t lastUse;
+            std::vector<T> data;
+        };
+        inline T* getTile(long x, long y, bool write)
+        {
+            long tileIdx = ((y / this->tileSize) * this->nXTiles) + (x / this->tileSize);
+            if(tileIdx != this->lastTileIdx)
+            {
+                this->lastTile = this->loadTile(tileIdx);
+                this->lastTileIdx = tileIdx;
+            }
+            if(write)
+            {
+                this->lastTile->dirty = true;
+            }
+            return this->lastTile->data.data();
+        };
+        RATile* loadTile(long tileIdx)
+        {
+            ++this->useCounter;
+            long slot = this->tileSlots[tileIdx];
+            if(slot >= 0)
+            {
+                this->tiles[slot].lastUse = this->useCounter;
+                return &this->tiles[slot];
+            }
+
+            if(this->tiles.size() < this->maxNumTiles)
+            {
+                this->tiles.push_back(RATile());
+                slot = this->tiles.size()-1;
+                this->tiles[slot].data.resize(((size_t)this->tileSize) * this->tileSize);
+            }
+            else
+            {
+                // Drop the least recently used tile.
+                slot = 0;
+                for(size_t i = 1; i < this->tiles.size(); ++i)
+                {
+                    if(this->tiles[i].lastUse < this->tiles[slot].lastUse)
+                    {
+                        slot = i;
+                    }
+                }
+                if(this->tiles[slot].dirty)
+                {
+                    this->tileIO(GF_Write, &this->tiles[slot]);
+                }
+                this->tileSlots[this->tiles[slot].tileIdx] = -1;
+            }
+
+            RATile *tile = &this->tiles[slot];
+            tile->tileIdx = tileIdx;
+            tile->dirty = false;
+            tile->lastUse = this->useCounter;
+            this->tileIO(GF_Read, tile);
+            this->tileSlots[tileIdx] = slot;
+            return tile;
+        };
+        void tileIO(GDALRWFlag rwFlag, RATile *tile)
+        {
+            long xOff = (tile->tileIdx % this->nXTiles) * this->tileSize;
+            long yOff = (tile->tileIdx / this->nXTiles) * this->tileSize;
+            int width = std::min<long>(this->tileSize, this->xSize - xOff);
+            int height = std::min<long>(this->tileSize, this->ySize - yOff);
+            // The line spacing is always the tile size so edge tiles are indexed as the others.
+            if(this->band->RasterIO(rwFlag, xOff, yOff, width, height, tile->data.data(), width, height, RSGISGDALPixelType<T>::gdalType(), sizeof(T), sizeof(T)*this->tileSize) != CE_None)
+            {
+                throw RSGISImageCalcException("Failed to read or write a tile of the image band.");
+            }
+            if(rwFlag == GF_Read)
+            {
+                ++this->numTileReads;
+            }
+            else
+            {
+                ++this->numTileWrites;
+            }
+        };
+        GDALRasterBand *band;
+        long xSize;
+        long ySize;
+        long tileSize;
+        long nXTiles;
+        long nYTiles;
+        size_t maxNumTiles;
+        size_t useCounter;
+        size_t numTileReads;
+        size_t numTileWrites;
+        std::vector<long> tileSlots;
+        std::vector<RATile> tiles;
+        long lastTileIdx;
+        RATile *lastTile;
+    };
+
+}}
+
+#endif
+
@@ -18,70 +18,163 @@ namespace rsgis{namespace img{
 		this->order = order;
 		this->window = window;
 		this->imagebandValues = imagebandValues;
-	}
-	
-	void RSGISSavitzkyGolaySmoothingFilters::calcImageValue(float *bandValues, int numBands, double *output) 
-	{
-		if(numBands != numOutBands)
+		if(this->order < 1)
 		{
-			throw RSGISImageCalcException("The number of input and output image bands needs to be equal.");
+			throw RSGISImageCalcException("The order must be at least 1.");
 		}
-		
-		if(numBands != imagebandValues->n)
+		if(this->window < 0)
 		{
-			throw RSGISImageCalcException("The number of input images bands and defined values need to be equal");
+			throw RSGISImageCalcException("The window must not be negative.");
 		}
-		
-		int numCols = 2;
-		int numRows = 0;
-		int startVal = 0;
-		
-        rsgis::math::RSGISPolyFit polyFit;
-		gsl_vector *coefficients = NULL;
-		gsl_matrix *inputValues = NULL;
-		
+		this->calcCoefficients();
+	}
+
+	void RSGISSavitzkyGolaySmoothingFilters::calcCoefficients()
+	{
+		int numBands = imagebandValues->n;
+		this->bandWinStart.assign(numBands, 0);
+		this->bandCoeffSet.assign(numBands, 0);
+		this->coeffSets.clear();
+
+		std::map<std::vector<double>, size_t> offsetPatterns;
 		for(int i = 0; i < numBands; ++i)
 		{
-			if((i-window) < 0)
+			int startVal = std::max(i - window, 0);
+			int endVal = std::min(i + window, numBands - 1);
+
+			// The fit is made relative to the band being smoothed so bands with
+			// the same pattern of offsets share coefficients.
+			std::vector<double> xOffsets;
+			for(int j = startVal; j <= endVal; ++j)
 			{
-				numRows = (window + 1) + i;
-				startVal = 0;
+				xOffsets.push_back(imagebandValues->vector[j] - imagebandValues->vector[i]);
 			}
-			else if((i+window) >= numBands)
+
+			std::map<std::vector<double>, size_t>::iterator iterPattern = offsetPatterns.find(xOffsets);
+			if(iterPattern == offsetPatterns.end())
 			{
-				numRows = (window + 1) + (numBands - i);
-				startVal = i - window;
+				this->coeffSets.push_back(this->calcWindowCoefficients(xOffsets));
+				iterPattern = offsetPatterns.insert(std::pair<std::vector<double>, size_t>(xOffsets, this->coeffSets.size()-1)).first;
 			}
-			else 
+			this->bandWinStart[i] = startVal;
+			this->bandCoeffSet[i] = iterPattern->second;
+		}
+	}
+
+	std::vector<double> RSGISSavitzkyGolaySmoothingFilters::calcWindowCoefficients(const std::vector<double> &xOffsets)
+	{
+		// The smoothed value is the constant term of the polynomial fitted to the
+		// offsets, i.e., the first row of the pseudo-inverse of the (rows x order)
+		// matrix of powers of the offsets, calculated through its SVD.
+		size_t numRows = xOffsets.size();
+		size_t numCoeffs = std::min<size_t>(this->order, numRows);
+
+		gsl_matrix *xPows = gsl_matrix_alloc(numRows, numCoeffs);
+		for(size_t j = 0; j < numRows; ++j)
+		{
+			for(size_t k = 0; k < numCoeffs; ++k)
 			{
-				numRows = (window * 2) + 1;
-				startVal = i - window;
+				gsl_matrix_set(xPows, j, k, pow(xOffsets[j], (double)k));
 			}
-				
-			inputValues = gsl_matrix_alloc (numRows,numCols);
-			for(int j = 0; j < numRows; ++j)
+		}
+		gsl_matrix *V = gsl_matrix_alloc(numCoeffs, numCoeffs);
+		gsl_vector *S = gsl_vector_alloc(numCoeffs);
+		gsl_vector *work = gsl_vector_alloc(numCoeffs);
+		int status = gsl_linalg_SV_decomp(xPows, V, S, work);
+		if(status != 0)
+		{
+			gsl_matrix_free(xPows);
+			gsl_matrix_free(V);
+			gsl_vector_free(S);
+			gsl_vector_free(work);
+			throw RSGISImageCalcException(gsl_strerror(status));
+		}
+
+		// Singular values which are negligible (e.g., repeated band values) are ignored.
+		double sTol = gsl_vector_get(S, 0) * numRows * GSL_DBL_EPSILON;
+		std::vector<double> coeffs(numRows, 0);
+		for(size_t k = 0; k < numCoeffs; ++k)
+		{
+			double sVal = gsl_vector_get(S, k);
+			if(sVal <= sTol)
+			{
+				continue;
+			}
+			double scale = gsl_matrix_get(V, 0, k) / sVal;
+			for(size_t j = 0; j < numRows; ++j)
 			{
-				gsl_matrix_set (inputValues, j, 0, imagebandValues->vector[(startVal+j)]);
-				gsl_matrix_set (inputValues, j, 1, bandValues[(startVal+j)]);
+				coeffs[j] += scale * gsl_matrix_get(xPows, j, k);
 			}
-			
-			coefficients = polyFit.PolyfitOneDimensionQuiet(this->order, inputValues);	
-			
+		}
+
+		gsl_matrix_free(xPows);
+		gsl_matrix_free(V);
+		gsl_vector_free(S);
+		gsl_vector_free(work);
+		return coeffs;
+	}
+
+	void RSGISSavitzkyGolaySmoothingFilters::calcImageValue(float *bandValues, int numBands, double *output)
+	{
+		if(numBands != numOutBands)
+		{
+			throw RSGISImageCalcException("The number of input and output image bands needs to be equal.");
+		}
+
+		if(numBands != imagebandValues->n)
+		{
+			throw RSGISImageCalcException("The number of input images bands and defined values need to be equal");
+		}
+
+		for(int i = 0; i < numBands; ++i)
+		{
+			const std::vector<double> &coeffs = this->coeffSets[this->bandCoeffSet[i]];
+			const float *winVals = bandValues + this->bandWinStart[i];
 			double yPredicted = 0;
-			for(int j = 0; j < order; j++)
+			for(size_t j = 0; j < coeffs.size(); ++j)
 			{
-				double xPow = pow(imagebandValues->vector[i], j); // x^n;
-				double coeff = gsl_vector_get(coefficients, j); // a_n
-				double coeffXPow = coeff * xPow; // a_n * x^n				
-				yPredicted = yPredicted + coeffXPow;
+				yPredicted += coeffs[j] * winVals[j];
 			}
 			output[i] = yPredicted;
-			
-			gsl_matrix_free(inputValues);
-			gsl_vector_free(coefficients);
 		}
 	}
-	
+
+	void RSGISSavitzkyGolaySmoothingFilters::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+	{
+		if(numBands != numOutBands)
+		{
+			throw RSGISImageCalcException("The number of input and output image bands needs to be equal.");
+		}
+
+		if(numBands != imagebandValues->n)
+		{
+			throw RSGISImageCalcException("The number of input images bands and defined values need to be equal");
+		}
+
+		// Each output plane is a weighted sum of the input planes in its window,
+		// accumulated a plane at a time so the inner loops run along the pixels.
+		for(int i = 0; i < numBands; ++i)
+		{
+			const std::vector<double> &coeffs = this->coeffSets[this->bandCoeffSet[i]];
+			double *outPlane = outPlanes[i];
+			const float *inPlane = bandPlanes[this->bandWinStart[i]];
+			double coeff = coeffs[0];
+			for(size_t p = 0; p < nPxls; ++p)
+			{
+				outPlane[p] = coeff * inPlane[p];
+			}
+			for(size_t j = 1; j < coeffs.size(); ++j)
+			{
+				inPlane = bandPlanes[this->bandWinStart[i] + j];
+				coeff = coeffs[j];
+				for(size_t p = 0; p < nPxls; ++p)
+				{
+					outPlane[p] += coeff * inPlane[p];
+				}
+			}
+		}
+	}
+
 	void RSGISSavitzkyGolaySmoothingFilters::calcImageValue(float *bandValues, int numBands) 
 	{
 		throw RSGISImageCalcException("Not implemented");
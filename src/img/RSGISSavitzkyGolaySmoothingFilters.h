@@ -26,11 +26,17 @@
 #include <iostream>
 #include <string>
 #include <math.h>
+#include <vector>
+#include <map>
+#include <algorithm>
 
 #include "gdal_priv.h"
 
 #include <gsl/gsl_matrix.h>
 #include <gsl/gsl_vector.h>
+#include <gsl/gsl_linalg.h>
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_errno.h>
 
 #include "img/RSGISImageCalcException.h"
 #include "img/RSGISCalcImageValue.h"
@@ -60,6 +66,19 @@ namespace rsgis{namespace img{
 	 *
 	 * Smoothing is undertaken through a process of polynominal fitting.
 	 *
+	 * As the band values (e.g., wavelengths or dates) are the same for every
+	 * pixel the least squares fit is a fixed linear combination of the values
+	 * within the window, so the convolution coefficients for each band are
+	 * calculated once in the constructor. Windows are clipped at the first and
+	 * last bands (giving asymmetric coefficients) and, for irregularly spaced
+	 * band values, a set of coefficients is calculated for each unique pattern
+	 * of offsets within the window and shared between the bands with that
+	 * pattern. Blocks are smoothed a band plane at a time and can be processed
+	 * by several threads.
+	 *
+	 * order is the number of polynomial coefficients (i.e., the degree + 1)
+	 * and window the number of bands either side of each band.
+	 *
 	 */
 	
 	class DllExport RSGISSavitzkyGolaySmoothingFilters : public RSGISCalcImageValue
@@ -67,6 +86,8 @@ namespace rsgis{namespace img{
 	public: 
 		RSGISSavitzkyGolaySmoothingFilters(int numberOutBands, int order, int window, rsgis::math::Vector *imagebandValues);
 		void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+        bool isThreadSafe(){return true;};
 		void calcImageValue(float *bandValues, int numBands);
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw RSGISImageCalcException("Not implemented");};
@@ -76,11 +97,19 @@ namespace rsgis{namespace img{
 		void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output);
         void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output, geos::geom::Envelope extent) {throw RSGISImageCalcException("No implemented");};
 		bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output);
+        /** The number of unique sets of coefficients. */
+        size_t getNumCoefficientSets(){return this->coeffSets.size();};
 		~RSGISSavitzkyGolaySmoothingFilters();
 	private:
+        void calcCoefficients();
+        std::vector<double> calcWindowCoefficients(const std::vector<double> &xOffsets);
 		int order;
 		int window;
-        rsgis::math::Vector *imagebandValues; 
+        rsgis::math::Vector *imagebandValues;
+        // The first band of the window, and the coefficient set, for each band.
+        std::vector<int> bandWinStart;
+        std::vector<size_t> bandCoeffSet;
+        std::vector< std::vector<double> > coeffSets;
 	};
 	
 }}
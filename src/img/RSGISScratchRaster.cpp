@@ -0,0 +1,225 @@
+/*
+ *  RSGISScratchRaster.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISScratchRaster.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <vector>
+#endif
+
+namespace rsgis{namespace img{
+
+    RSGISScratchRaster::RSGISScratchRaster(int xSize, int ySize, unsigned int numBands, GDALDataType dataType, bool inMemory, std::string tmpDir)
+    {
+        this->init(xSize, ySize, numBands, dataType, inMemory, tmpDir);
+    }
+
+    RSGISScratchRaster::RSGISScratchRaster(GDALDataset *templateDS, unsigned int numBands, GDALDataType dataType, bool inMemory, std::string tmpDir)
+    {
+        if(templateDS == NULL)
+        {
+            throw RSGISImageException("The template image for the scratch raster is NULL.");
+        }
+        this->init(templateDS->GetRasterXSize(), templateDS->GetRasterYSize(), numBands, dataType, inMemory, tmpDir);
+        double trans[6];
+        if(templateDS->GetGeoTransform(trans) == CE_None)
+        {
+            this->dataset->SetGeoTransform(trans);
+        }
+        const char *proj = templateDS->GetProjectionRef();
+        if((proj != NULL) && (proj[0] != '\0'))
+        {
+            this->dataset->SetProjection(proj);
+        }
+    }
+
+    void RSGISScratchRaster::init(int xSize, int ySize, unsigned int numBands, GDALDataType dataType, bool inMemory, std::string tmpDir)
+    {
+        if((xSize <= 0) || (ySize <= 0) || (numBands == 0))
+        {
+            throw RSGISImageException("The scratch raster must have at least one pixel and band.");
+        }
+        int pxlBytes = GDALGetDataTypeSize(dataType) / 8;
+        if(pxlBytes <= 0)
+        {
+            throw RSGISImageException("The data type of the scratch raster is not known.");
+        }
+        this->xSize = xSize;
+        this->ySize = ySize;
+        this->numBands = numBands;
+        this->dataType = dataType;
+        this->bandBytes = ((size_t)xSize) * ((size_t)ySize) * pxlBytes;
+        this->totalBytes = this->bandBytes * numBands;
+        this->data = NULL;
+        this->fileBacked = false;
+        this->mapped = false;
+        this->dataset = NULL;
+
+        this->allocate(inMemory, tmpDir);
+
+        try
+        {
+            GDALDriver *memDriver = GetGDALDriverManager()->GetDriverByName("MEM");
+            if(memDriver == NULL)
+            {
+                throw RSGISImageException("The GDAL MEM driver is not available.");
+            }
+            this->dataset = memDriver->Create("", xSize, ySize, 0, dataType, NULL);
+            if(this->dataset == NULL)
+            {
+                throw RSGISImageException("Could not create the dataset for the scratch raster.");
+            }
+            // The bands are added over the data rather than allocated by GDAL.
+            for(unsigned int n = 0; n < numBands; ++n)
+            {
+                char ptrStr[64];
+                int ptrLen = CPLPrintPointer(ptrStr, this->data + (n * this->bandBytes), sizeof(ptrStr) - 1);
+                ptrStr[ptrLen] = '\0';
+                char **options = NULL;
+                options = CSLSetNameValue(options, "DATAPOINTER", ptrStr);
+                options = CSLSetNameValue(options, "PIXELOFFSET", CPLSPrintf("%d", pxlBytes));
+                options = CSLSetNameValue(options, "LINEOFFSET", CPLSPrintf("%lld", ((long long)xSize) * pxlBytes));
+                CPLErr err = this->dataset->AddBand(dataType, options);
+                CSLDestroy(options);
+                if(err != CE_None)
+                {
+                    throw RSGISImageException("Could not add a band to the scratch raster dataset.");
+                }
+            }
+        }
+        catch(RSGISImageException &e)
+        {
+            this->release();
+            throw e;
+        }
+    }
+
+    void RSGISScratchRaster::allocate(bool inMemory, std::string tmpDir)
+    {
+        size_t memLimit = ((size_t)1024) * 1024 * 1024;
+        if(const char* env_p = std::getenv("RSGISLIB_SCRATCH_MEM_MB"))
+        {
+            long long envMemMB = atoll(env_p);
+            if(envMemMB >= 0)
+            {
+                memLimit = ((size_t)envMemMB) * 1024 * 1024;
+            }
+        }
+#ifdef _WIN32
+        this->data = (unsigned char *) VSICalloc(1, this->totalBytes);
+        if(this->data == NULL)
+        {
+            throw RSGISImageException("Could not allocate the memory for the scratch raster.");
+        }
+#else
+        if(inMemory || (this->totalBytes <= memLimit))
+        {
+            void *mem = mmap(NULL, this->totalBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(mem == MAP_FAILED)
+            {
+                throw RSGISImageException("Could not allocate the memory for the scratch raster.");
+            }
+            this->data = (unsigned char *) mem;
+            this->mapped = true;
+            return;
+        }
+
+        if(tmpDir == "")
+        {
+            if(const char* env_p = std::getenv("RSGISLIB_SCRATCH_DIR"))
+            {
+                tmpDir = env_p;
+            }
+            else if(const char* env_p = std::getenv("TMPDIR"))
+            {
+                tmpDir = env_p;
+            }
+            else
+            {
+                tmpDir = "/tmp";
+            }
+        }
+        std::string fileTemplate = tmpDir + "/rsgislib_scratch_XXXXXX";
+        std::vector<char> fileName(fileTemplate.begin(), fileTemplate.end());
+        fileName.push_back('\0');
+        int fd = mkstemp(fileName.data());
+        if(fd < 0)
+        {
+            throw RSGISImageException(("Could not create a scratch file in " + tmpDir).c_str());
+        }
+        // The file is removed once mapped; the mapping keeps its data.
+        unlink(fileName.data());
+        if(ftruncate(fd, (off_t)this->totalBytes) != 0)
+        {
+            close(fd);
+            throw RSGISImageException(("Could not size the scratch file in " + tmpDir).c_str());
+        }
+        void *mem = mmap(NULL, this->totalBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if(mem == MAP_FAILED)
+        {
+            throw RSGISImageException("Could not map the scratch file.");
+        }
+        this->data = (unsigned char *) mem;
+        this->mapped = true;
+        this->fileBacked = true;
+#endif
+    }
+
+    void* RSGISScratchRaster::getBandData(unsigned int band)
+    {
+        if((band == 0) || (band > this->numBands))
+        {
+            throw RSGISImageException("The band is not within the scratch raster.");
+        }
+        return this->data + ((band - 1) * this->bandBytes);
+    }
+
+    void RSGISScratchRaster::release()
+    {
+        if(this->dataset != NULL)
+        {
+            GDALClose(this->dataset);
+            this->dataset = NULL;
+        }
+        if(this->data != NULL)
+        {
+#ifdef _WIN32
+            VSIFree(this->data);
+#else
+            if(this->mapped)
+            {
+                munmap(this->data, this->totalBytes);
+            }
+#endif
+            this->data = NULL;
+        }
+    }
+
+    RSGISScratchRaster::~RSGISScratchRaster()
+    {
+        this->release();
+    }
+
+}}
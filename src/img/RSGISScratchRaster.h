@@ -0,0 +1,106 @@
+/*
+ *  RSGISScratchRaster.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISScratchRaster_H
+#define RSGISScratchRaster_H
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include "gdal_priv.h"
+#include "cpl_string.h"
+
+#include "common/RSGISImageException.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_img_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace img{
+
+    /**
+     * A raster for the intermediate images of multi-step processing, held
+     * uncompressed with each band a contiguous row-major plane. Where the
+     * raster is no larger than the RSGISLIB_SCRATCH_MEM_MB environment
+     * variable (default 1024 MB), or inMemory is given, it is held in
+     * anonymous memory; otherwise it is a memory-mapped file in tmpDir (or
+     * RSGISLIB_SCRATCH_DIR, TMPDIR or /tmp), which is unlinked once it is
+     * mapped so it is removed however the process ends. Either way the
+     * reads and writes are at memory (page cache) speed, with the OS paging
+     * a large raster out to the file as needed. On Windows the raster is
+     * always held in memory.
+     *
+     * getDataset gives the raster as a GDAL MEM dataset over the same data
+     * (so it can be passed to any function taking a GDALDataset) and
+     * getBandData a pointer to a band for code which can use it directly.
+     * The dataset is owned by the scratch raster and must not be closed.
+     */
+    class DllExport RSGISScratchRaster
+    {
+    public:
+        RSGISScratchRaster(int xSize, int ySize, unsigned int numBands, GDALDataType dataType, bool inMemory=false, std::string tmpDir="");
+        /**
+         * A scratch raster with the size, geotransform and projection of an image.
+         */
+        RSGISScratchRaster(GDALDataset *templateDS, unsigned int numBands, GDALDataType dataType, bool inMemory=false, std::string tmpDir="");
+        GDALDataset* getDataset(){return dataset;};
+        /** The data of a band (numbered from 1), getXSize() pixels per row. */
+        void* getBandData(unsigned int band);
+        template <typename T>
+        T* getBandDataAs(unsigned int band){return (T*) this->getBandData(band);};
+        int getXSize() const {return xSize;};
+        int getYSize() const {return ySize;};
+        unsigned int getNumBands() const {return numBands;};
+        GDALDataType getDataType() const {return dataType;};
+        /** True where the raster is backed by a (memory-mapped) file. */
+        bool isFileBacked() const {return fileBacked;};
+        ~RSGISScratchRaster();
+    protected:
+        void init(int xSize, int ySize, unsigned int numBands, GDALDataType dataType, bool inMemory, std::string tmpDir);
+        void allocate(bool inMemory, std::string tmpDir);
+        void release();
+        int xSize;
+        int ySize;
+        unsigned int numBands;
+        GDALDataType dataType;
+        size_t bandBytes;
+        size_t totalBytes;
+        unsigned char *data;
+        bool fileBacked;
+        bool mapped;
+        GDALDataset *dataset;
+    };
+
+}}
+
+#endif
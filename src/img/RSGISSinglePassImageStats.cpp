@@ -0,0 +1,676 @@
+/*
+ *  RSGISSinglePassImageStats.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2010 RSGISLib. All rights reserved.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISSinglePassImageStats.h"
+
+namespace rsgis{namespace img{
+
+    RSGISStreamHistogram::RSGISStreamHistogram(unsigned int numBins)
+    {
+        this->numBins = (numBins < 2)?2:numBins;
+        // Start with fine bins; they are widened as the range of values grows.
+        this->binExp = -32;
+        this->startIdx = 0;
+        this->minIdx = 0;
+        this->maxIdx = 0;
+        this->total = 0;
+    }
+
+    long long RSGISStreamHistogram::getBinIdx(double val)
+    {
+        // The index must fit within a long long, so very large values widen the bins.
+        double scaled = std::ldexp(val, -this->binExp);
+        if(std::fabs(scaled) >= 4.0e18)
+        {
+            int newBinExp = this->binExp;
+            while(std::fabs(std::ldexp(val, -newBinExp)) >= 4.0e18)
+            {
+                ++newBinExp;
+            }
+            if(this->total > 0)
+            {
+                int shift = newBinExp - this->binExp;
+                this->rebin(newBinExp, floorDivPow2(this->startIdx, shift));
+            }
+            else
+            {
+                this->binExp = newBinExp;
+            }
+            scaled = std::ldexp(val, -this->binExp);
+        }
+        return (long long) std::floor(scaled);
+    }
+
+    void RSGISStreamHistogram::add(double val)
+    {
+        long long idx = this->getBinIdx(val);
+        if(this->total == 0)
+        {
+            if(this->counts.empty())
+            {
+                this->counts.assign(this->numBins, 0);
+            }
+            this->startIdx = idx - (this->numBins/2);
+            this->minIdx = idx;
+            this->maxIdx = idx;
+        }
+        else if((idx < this->startIdx) || (idx >= (this->startIdx + ((long long)this->numBins))))
+        {
+            long long lower = std::min(this->minIdx, idx);
+            long long upper = std::max(this->maxIdx, idx);
+            int newBinExp = this->binExp;
+            while(((upper - lower) + 1) > ((long long)this->numBins))
+            {
+                lower = floorDivPow2(lower, 1);
+                upper = floorDivPow2(upper, 1);
+                ++newBinExp;
+            }
+            // Centre the range so it can grow either way before needing to move again.
+            this->rebin(newBinExp, lower - ((((long long)this->numBins) - ((upper - lower) + 1))/2));
+            idx = (long long) std::floor(std::ldexp(val, -this->binExp));
+        }
+        ++this->counts[idx - this->startIdx];
+        ++this->total;
+        this->minIdx = std::min(this->minIdx, idx);
+        this->maxIdx = std::max(this->maxIdx, idx);
+    }
+
+    void RSGISStreamHistogram::rebin(int newBinExp, long long newStartIdx)
+    {
+        int shift = newBinExp - this->binExp;
+        std::vector<unsigned long long> newCounts(this->numBins, 0);
+        for(long long i = this->minIdx; i <= this->maxIdx; ++i)
+        {
+            unsigned long long count = this->counts[i - this->startIdx];
+            if(count > 0)
+            {
+                newCounts[floorDivPow2(i, shift) - newStartIdx] += count;
+            }
+        }
+        this->counts.swap(newCounts);
+        this->minIdx = floorDivPow2(this->minIdx, shift);
+        this->maxIdx = floorDivPow2(this->maxIdx, shift);
+        this->binExp = newBinExp;
+        this->startIdx = newStartIdx;
+    }
+
+    void RSGISStreamHistogram::merge(const RSGISStreamHistogram &other)
+    {
+        if(other.total == 0)
+        {
+            return;
+        }
+        if(this->numBins != other.numBins)
+        {
+            throw RSGISImageException("Histograms with a different number of bins cannot be merged.");
+        }
+        if(this->total == 0)
+        {
+            *this = other;
+            return;
+        }
+
+        // Both histograms are brought to the wider bins, widened further if needed.
+        int newBinExp = std::max(this->binExp, other.binExp);
+        long long lower = std::min(floorDivPow2(this->minIdx, newBinExp - this->binExp), floorDivPow2(other.minIdx, newBinExp - other.binExp));
+        long long upper = std::max(floorDivPow2(this->maxIdx, newBinExp - this->binExp), floorDivPow2(other.maxIdx, newBinExp - other.binExp));
+        while(((upper - lower) + 1) > ((long long)this->numBins))
+        {
+            lower = floorDivPow2(lower, 1);
+            upper = floorDivPow2(upper, 1);
+            ++newBinExp;
+        }
+        this->rebin(newBinExp, lower - ((((long long)this->numBins) - ((upper - lower) + 1))/2));
+
+        int shift = newBinExp - other.binExp;
+        for(long long i = other.minIdx; i <= other.maxIdx; ++i)
+        {
+            unsigned long long count = other.counts[i - other.startIdx];
+            if(count > 0)
+            {
+                this->counts[floorDivPow2(i, shift) - this->startIdx] += count;
+            }
+        }
+        this->minIdx = std::min(this->minIdx, floorDivPow2(other.minIdx, shift));
+        this->maxIdx = std::max(this->maxIdx, floorDivPow2(other.maxIdx, shift));
+        this->total += other.total;
+    }
+
+    void RSGISStreamHistogram::getBinCounts(double binLower, double binWidth, unsigned int numOutBins, std::vector<unsigned long long> *outCounts) const
+    {
+        outCounts->assign(numOutBins, 0);
+        if((this->total == 0) || (numOutBins == 0))
+        {
+            return;
+        }
+        for(long long i = this->minIdx; i <= this->maxIdx; ++i)
+        {
+            unsigned long long count = this->counts[i - this->startIdx];
+            if(count == 0)
+            {
+                continue;
+            }
+            double outIdx = 0;
+            if(binWidth > 0)
+            {
+                outIdx = std::floor((std::ldexp((double)i, this->binExp) - binLower) / binWidth);
+            }
+            if(outIdx < 0)
+            {
+                outIdx = 0;
+            }
+            else if(outIdx >= numOutBins)
+            {
+                outIdx = numOutBins - 1;
+            }
+            (*outCounts)[(size_t)outIdx] += count;
+        }
+    }
+
+    double RSGISStreamHistogram::getPercentile(double percentile) const
+    {
+        if(this->total == 0)
+        {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        unsigned long long percentileValCount = (unsigned long long) std::floor(((double)this->total) * (percentile / 100.0));
+        long long binIdx = this->minIdx;
+        unsigned long long valCount = 0;
+        for(long long i = this->minIdx; i <= this->maxIdx; ++i)
+        {
+            valCount += this->counts[i - this->startIdx];
+            binIdx = i;
+            if(valCount >= percentileValCount)
+            {
+                break;
+            }
+        }
+        return std::ldexp(((double)binIdx) + 0.5, this->binExp);
+    }
+
+
+    const size_t RSGISSinglePassImageStats::covChunkSize = 4096;
+
+    RSGISSinglePassImageStats::RSGISSinglePassImageStats(bool calcHistograms, bool calcCovariance, bool directHistograms, unsigned int numHistBins)
+    {
+        this->calcHistograms = calcHistograms;
+        this->calcCovariance = calcCovariance;
+        this->directHistograms = directHistograms;
+        this->numHistBins = numHistBins;
+        this->covAccum.n = 0;
+        this->subSample = 1;
+        this->streamUseNoData = false;
+        this->streamNoDataVal = 0;
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+
+    void RSGISSinglePassImageStats::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+
+    void RSGISSinglePassImageStats::initAccums(std::vector<RSGISBandStatsAccum> *accums, RSGISCovarianceAccum *cov, size_t numBands)
+    {
+        RSGISBandStatsAccum accum;
+        accum.n = 0;
+        accum.min = std::numeric_limits<double>::quiet_NaN();
+        accum.max = std::numeric_limits<double>::quiet_NaN();
+        accum.sum = 0;
+        accum.sumComp = 0;
+        accum.mean = std::numeric_limits<double>::quiet_NaN();
+        accum.m2 = 0;
+        accum.m2Comp = 0;
+        accum.hist = RSGISStreamHistogram(this->numHistBins);
+        accums->assign(numBands, accum);
+
+        cov->n = 0;
+        cov->means.clear();
+        cov->coMoments.clear();
+        if(this->calcCovariance)
+        {
+            cov->means.assign(numBands, 0);
+            cov->coMoments.assign(numBands * numBands, 0);
+        }
+    }
+
+    void RSGISSinglePassImageStats::mergeAccums(std::vector<RSGISBandStatsAccum> *accums, RSGISCovarianceAccum *cov, const std::vector<RSGISBandStatsAccum> &other, const RSGISCovarianceAccum &otherCov)
+    {
+        for(size_t b = 0; b < accums->size(); ++b)
+        {
+            RSGISBandStatsAccum &accum = (*accums)[b];
+            const RSGISBandStatsAccum &otherAccum = other[b];
+            if(otherAccum.n > 0)
+            {
+                if(accum.n == 0)
+                {
+                    accum.min = otherAccum.min;
+                    accum.max = otherAccum.max;
+                    accum.mean = otherAccum.mean;
+                    accum.m2 = otherAccum.m2;
+                    accum.m2Comp = otherAccum.m2Comp;
+                }
+                else
+                {
+                    double n = ((double)accum.n) + otherAccum.n;
+                    double delta = otherAccum.mean - accum.mean;
+                    accum.mean += delta * (otherAccum.n / n);
+                    rsgis::RSGISCompensatedSum::add(accum.m2, accum.m2Comp, otherAccum.m2);
+                    rsgis::RSGISCompensatedSum::add(accum.m2, accum.m2Comp, delta * delta * ((((double)accum.n) * otherAccum.n) / n));
+                    accum.m2Comp += otherAccum.m2Comp;
+                    accum.min = std::min(accum.min, otherAccum.min);
+                    accum.max = std::max(accum.max, otherAccum.max);
+                }
+                accum.n += otherAccum.n;
+                rsgis::RSGISCompensatedSum::add(accum.sum, accum.sumComp, otherAccum.sum);
+                accum.sumComp += otherAccum.sumComp;
+            }
+            if(this->calcHistograms)
+            {
+                accum.hist.merge(otherAccum.hist);
+            }
+            if(this->directHistograms)
+            {
+                if(otherAccum.directHist.size() > accum.directHist.size())
+                {
+                    accum.directHist.resize(otherAccum.directHist.size(), 0);
+                }
+                for(size_t i = 0; i < otherAccum.directHist.size(); ++i)
+                {
+                    accum.directHist[i] += otherAccum.directHist[i];
+                }
+            }
+        }
+
+        if(this->calcCovariance && (otherCov.n > 0))
+        {
+            std::vector<double> deltas(accums->size(), 0);
+            this->mergeCovariance(cov, otherCov.n, otherCov.means.data(), otherCov.coMoments.data(), deltas.data());
+        }
+    }
+
+    void RSGISSinglePassImageStats::mergeCovariance(RSGISCovarianceAccum *cov, unsigned long long otherN, const double *otherMeans, const double *otherCoMoments, double *deltas)
+    {
+        // Only the upper triangle (j >= i) of the co-moments is used.
+        size_t numBands = cov->means.size();
+        if(cov->n == 0)
+        {
+            cov->n = otherN;
+            for(size_t i = 0; i < numBands; ++i)
+            {
+                cov->means[i] = otherMeans[i];
+                for(size_t j = i; j < numBands; ++j)
+                {
+                    cov->coMoments[(i*numBands)+j] = otherCoMoments[(i*numBands)+j];
+                }
+            }
+            return;
+        }
+        double n = ((double)cov->n) + otherN;
+        double factor = (((double)cov->n) * otherN) / n;
+        for(size_t i = 0; i < numBands; ++i)
+        {
+            deltas[i] = otherMeans[i] - cov->means[i];
+        }
+        for(size_t i = 0; i < numBands; ++i)
+        {
+            for(size_t j = i; j < numBands; ++j)
+            {
+                cov->coMoments[(i*numBands)+j] += otherCoMoments[(i*numBands)+j] + (deltas[i] * deltas[j] * factor);
+            }
+            cov->means[i] += deltas[i] * (otherN / n);
+        }
+        cov->n += otherN;
+    }
+
+    void RSGISSinglePassImageStats::accumulateCovChunk(RSGISCovarianceAccum &cov, double *chunk, size_t numChunkPxls, size_t numBands, double *chunkMeans, double *chunkCoMoments, double *deltas)
+    {
+        for(size_t b = 0; b < numBands; ++b)
+        {
+            chunkMeans[b] = 0;
+        }
+        for(size_t i = 0; i < numChunkPxls; ++i)
+        {
+            const double *pxl = chunk + (i * numBands);
+            for(size_t b = 0; b < numBands; ++b)
+            {
+                chunkMeans[b] += pxl[b];
+            }
+        }
+        for(size_t b = 0; b < numBands; ++b)
+        {
+            chunkMeans[b] /= numChunkPxls;
+        }
+        for(size_t i = 0; i < numChunkPxls; ++i)
+        {
+            double *pxl = chunk + (i * numBands);
+            for(size_t b = 0; b < numBands; ++b)
+            {
+                pxl[b] -= chunkMeans[b];
+            }
+        }
+
+        // The co-moments of the centred chunk as a rank-k update, C = X'.X
+        gsl_matrix_view chunkMat = gsl_matrix_view_array(chunk, numChunkPxls, numBands);
+        gsl_matrix_view coMomentsMat = gsl_matrix_view_array(chunkCoMoments, numBands, numBands);
+        gsl_blas_dsyrk(CblasUpper, CblasTrans, 1.0, &chunkMat.matrix, 0.0, &coMomentsMat.matrix);
+
+        this->mergeCovariance(&cov, numChunkPxls, chunkMeans, chunkCoMoments, deltas);
+    }
+
+    void RSGISSinglePassImageStats::accumulateBlock(std::vector<RSGISBandStatsAccum> &accums, RSGISCovarianceAccum &cov, const double* const* bandPlanes, size_t numBands, size_t numBlockPxls, bool useNoData, float noDataVal, std::vector<double> &deltas, bool addDirectHists)
+    {
+        for(size_t b = 0; b < numBands; ++b)
+        {
+            RSGISBandStatsAccum &accum = accums[b];
+            const double *bandData = bandPlanes[b];
+            for(size_t i = 0; i < numBlockPxls; ++i)
+            {
+                double val = bandData[i];
+                if(std::isnan(val) || (useNoData && (((float)val) == noDataVal)))
+                {
+                    continue;
+                }
+                if(accum.n == 0)
+                {
+                    accum.min = val;
+                    accum.max = val;
+                    accum.mean = 0;
+                }
+                else if(val < accum.min)
+                {
+                    accum.min = val;
+                }
+                else if(val > accum.max)
+                {
+                    accum.max = val;
+                }
+                ++accum.n;
+                rsgis::RSGISCompensatedSum::add(accum.sum, accum.sumComp, val);
+                double delta = val - accum.mean;
+                accum.mean += delta / accum.n;
+                rsgis::RSGISCompensatedSum::add(accum.m2, accum.m2Comp, delta * (val - accum.mean));
+                if(this->calcHistograms)
+                {
+                    accum.hist.add(val);
+                }
+                if(addDirectHists && (val >= 0))
+                {
+                    size_t histIdx = (size_t) val;
+                    if(histIdx >= accum.directHist.size())
+                    {
+                        accum.directHist.resize(histIdx + 1, 0);
+                    }
+                    ++accum.directHist[histIdx];
+                }
+            }
+        }
+
+        if(this->calcCovariance)
+        {
+            // The pixels valid in all bands are gathered into chunks (pixels x
+            // bands) and each chunk is merged into the accumulator.
+            rsgis::RSGISScratchScope scratch;
+            size_t chunkSize = std::max<size_t>(std::min(numBlockPxls, covChunkSize), 1);
+            double *chunk = scratch.alloc<double>(chunkSize * numBands);
+            double *chunkMeans = scratch.alloc<double>(numBands);
+            double *chunkCoMoments = scratch.alloc<double>(numBands * numBands);
+            size_t numChunkPxls = 0;
+            for(size_t i = 0; i < numBlockPxls; ++i)
+            {
+                bool valid = true;
+                for(size_t b = 0; b < numBands; ++b)
+                {
+                    double val = bandPlanes[b][i];
+                    if(std::isnan(val) || (useNoData && (((float)val) == noDataVal)))
+                    {
+                        valid = false;
+                        break;
+                    }
+                }
+                if(!valid)
+                {
+                    continue;
+                }
+                double *pxl = chunk + (numChunkPxls * numBands);
+                for(size_t b = 0; b < numBands; ++b)
+                {
+                    pxl[b] = bandPlanes[b][i];
+                }
+                if(++numChunkPxls == chunkSize)
+                {
+                    this->accumulateCovChunk(cov, chunk, numChunkPxls, numBands, chunkMeans, chunkCoMoments, deltas.data());
+                    numChunkPxls = 0;
+                }
+            }
+            if(numChunkPxls > 0)
+            {
+                this->accumulateCovChunk(cov, chunk, numChunkPxls, numBands, chunkMeans, chunkCoMoments, deltas.data());
+            }
+        }
+    }
+
+    void RSGISSinglePassImageStats::addDirectHistBlock(const double* const* bandPlanes, size_t numBands, size_t numBlockPxls, bool useNoData, float noDataVal, std::vector<std::pair<size_t, unsigned long long> > &runs, std::vector<std::vector<unsigned long long> > *hists, std::mutex *histMutex)
+    {
+        for(size_t b = 0; b < numBands; ++b)
+        {
+            runs.clear();
+            const double *bandData = bandPlanes[b];
+            for(size_t i = 0; i < numBlockPxls; ++i)
+            {
+                double val = bandData[i];
+                if(std::isnan(val) || (useNoData && (((float)val) == noDataVal)) || (val < 0))
+                {
+                    continue;
+                }
+                size_t histIdx = (size_t) val;
+                if(!runs.empty() && (runs.back().first == histIdx))
+                {
+                    ++runs.back().second;
+                }
+                else
+                {
+                    runs.push_back(std::pair<size_t, unsigned long long>(histIdx, 1));
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(*histMutex);
+            std::vector<unsigned long long> &hist = (*hists)[b];
+            for(std::vector<std::pair<size_t, unsigned long long> >::iterator iterRuns = runs.begin(); iterRuns != runs.end(); ++iterRuns)
+            {
+                if(iterRuns->first >= hist.size())
+                {
+                    hist.resize(iterRuns->first + 1, 0);
+                }
+                hist[iterRuns->first] += iterRuns->second;
+            }
+        }
+    }
+
+    void RSGISSinglePassImageStats::startStream(unsigned int numBands, bool useNoData, float noDataVal)
+    {
+        this->initAccums(&this->bandAccums, &this->covAccum, numBands);
+        this->streamUseNoData = useNoData;
+        this->streamNoDataVal = noDataVal;
+        this->streamDeltas.assign(numBands, 0);
+    }
+
+    void RSGISSinglePassImageStats::addBlock(const double* const* bandPlanes, size_t nPxls)
+    {
+        this->accumulateBlock(this->bandAccums, this->covAccum, bandPlanes, this->bandAccums.size(), nPxls, this->streamUseNoData, this->streamNoDataVal, this->streamDeltas, this->directHistograms);
+    }
+
+    void RSGISSinglePassImageStats::calcStats(GDALDataset *dataset, bool useNoData, float noDataVal, std::vector<unsigned int> bands)
+    {
+        if(dataset == NULL)
+        {
+            throw RSGISImageException("The image dataset is NULL.");
+        }
+        int numImgBands = dataset->GetRasterCount();
+        if(bands.empty())
+        {
+            for(int i = 1; i <= numImgBands; ++i)
+            {
+                bands.push_back(i);
+            }
+        }
+        std::vector<int> bandMap;
+        for(std::vector<unsigned int>::iterator iterBands = bands.begin(); iterBands != bands.end(); ++iterBands)
+        {
+            if(((*iterBands) < 1) || (((int)(*iterBands)) > numImgBands))
+            {
+                throw RSGISImageException("Band numbers start at 1 and must be equal or less than the number of bands within the image.");
+            }
+            bandMap.push_back(*iterBands);
+        }
+        size_t numBands = bandMap.size();
+        int imgWidth = dataset->GetRasterXSize();
+        int imgHeight = dataset->GetRasterYSize();
+        // The blocks are of lines in the (decimated) buffer.
+        int step = this->subSample;
+        int width = (imgWidth + step - 1) / step;
+        int height = (imgHeight + step - 1) / step;
+
+        int xBlockSize = 0;
+        int yBlockSize = 0;
+        dataset->GetRasterBand(bandMap[0])->GetBlockSize(&xBlockSize, &yBlockSize);
+        yBlockSize = std::max(yBlockSize, 1);
+        unsigned int nBlocks = (height + yBlockSize - 1) / yBlockSize;
+        unsigned int nThreads = std::max<unsigned int>(std::min(this->numThreads, nBlocks), 1);
+
+        // Each block is accumulated separately and the blocks are merged in a
+        // fixed order so the result does not depend on the number of threads.
+        rsgis::RSGISTreeReduction<RSGISBlockAccums> reduction(nBlocks, [this](RSGISBlockAccums &left, RSGISBlockAccums &right)
+        {
+            this->mergeAccums(&left.bands, &left.cov, right.bands, right.cov);
+        });
+
+        // The direct histograms (e.g., of clump IDs) are counts, so they are
+        // added to one shared table per band rather than one per block.
+        std::vector<std::vector<unsigned long long> > directHists(numBands);
+        std::mutex histMutex;
+
+        std::mutex ioMutex;
+        size_t bandStride = ((size_t)width) * yBlockSize;
+        rsgis::utils::RSGISWorkerPool pool(nThreads);
+        std::vector<std::vector<double> > threadBlockData(pool.getNumThreads());
+        std::vector<std::vector<double> > threadDeltas(pool.getNumThreads(), std::vector<double>(numBands, 0));
+        std::vector<std::vector<const double*> > threadBandPlanes(pool.getNumThreads(), std::vector<const double*>(numBands, NULL));
+        std::vector<std::vector<std::pair<size_t, unsigned long long> > > threadRuns(pool.getNumThreads());
+        pool.parallelFor(nBlocks, [&](size_t blk, unsigned int t)
+        {
+            std::vector<double> &blockData = threadBlockData[t];
+            std::vector<const double*> &bandPlanes = threadBandPlanes[t];
+            blockData.resize(bandStride * numBands);
+            int yOff = blk * yBlockSize;
+            int numRows = std::min(yBlockSize, height - yOff);
+            {
+                std::lock_guard<std::mutex> lock(ioMutex);
+                int imgYOff = yOff * step;
+                int imgRows = std::min(numRows * step, imgHeight - imgYOff);
+                if(dataset->RasterIO(GF_Read, 0, imgYOff, imgWidth, imgRows, blockData.data(), width, numRows, GDT_Float64, numBands, bandMap.data(), sizeof(double), sizeof(double) * width, sizeof(double) * bandStride, NULL) != CE_None)
+                {
+                    throw RSGISImageException("Could not read a block of the image.");
+                }
+            }
+
+            size_t numBlockPxls = ((size_t)width) * numRows;
+            for(size_t b = 0; b < numBands; ++b)
+            {
+                bandPlanes[b] = blockData.data() + (b * bandStride);
+            }
+            RSGISBlockAccums blockAccums;
+            this->initAccums(&blockAccums.bands, &blockAccums.cov, numBands);
+            this->accumulateBlock(blockAccums.bands, blockAccums.cov, bandPlanes.data(), numBands, numBlockPxls, useNoData, noDataVal, threadDeltas[t], false);
+            if(this->directHistograms)
+            {
+                this->addDirectHistBlock(bandPlanes.data(), numBands, numBlockPxls, useNoData, noDataVal, threadRuns[t], &directHists, &histMutex);
+            }
+            reduction.addPart(blk, blockAccums);
+        });
+
+        if(nBlocks == 0)
+        {
+            this->initAccums(&this->bandAccums, &this->covAccum, numBands);
+            return;
+        }
+        RSGISBlockAccums result;
+        reduction.getResult(&result);
+        this->bandAccums.swap(result.bands);
+        this->covAccum = result.cov;
+        for(size_t b = 0; b < numBands; ++b)
+        {
+            this->bandAccums[b].directHist.swap(directHists[b]);
+        }
+    }
+
+    double RSGISSinglePassImageStats::getVariance(unsigned int idx) const
+    {
+        const RSGISBandStatsAccum &accum = this->bandAccums.at(idx);
+        if(accum.n == 0)
+        {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        return (accum.m2 + accum.m2Comp) / accum.n;
+    }
+
+    const RSGISStreamHistogram* RSGISSinglePassImageStats::getHistogram(unsigned int idx) const
+    {
+        if(!this->calcHistograms)
+        {
+            throw RSGISImageException("The histograms were not calculated.");
+        }
+        return &this->bandAccums.at(idx).hist;
+    }
+
+    const std::vector<unsigned long long>* RSGISSinglePassImageStats::getDirectHistogram(unsigned int idx) const
+    {
+        if(!this->directHistograms)
+        {
+            throw RSGISImageException("The direct histograms were not calculated.");
+        }
+        return &this->bandAccums.at(idx).directHist;
+    }
+
+    double RSGISSinglePassImageStats::getCovariance(unsigned int idxA, unsigned int idxB) const
+    {
+        if(!this->calcCovariance)
+        {
+            throw RSGISImageException("The covariance was not calculated.");
+        }
+        size_t numBands = this->bandAccums.size();
+        if((idxA >= numBands) || (idxB >= numBands))
+        {
+            throw RSGISImageException("Band index is out of range for the covariance.");
+        }
+        if(this->covAccum.n == 0)
+        {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        if(idxA > idxB)
+        {
+            std::swap(idxA, idxB);
+        }
+        return this->covAccum.coMoments[(idxA*numBands)+idxB] / this->covAccum.n;
+    }
+
+}}
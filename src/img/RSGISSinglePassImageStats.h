@@ -0,0 +1,253 @@
+/*
+ *  RSGISSinglePassImageStats.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2010 RSGISLib. All rights reserved.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISSinglePassImageStats_H
+#define RSGISSinglePassImageStats_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <cstdlib>
+#include <utility>
+
+#include "gdal_priv.h"
+
+#include "common/RSGISImageException.h"
+#include "common/RSGISScratchArena.h"
+#include "common/RSGISReduction.h"
+#include "common/RSGISParallel.h"
+
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_blas.h>
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_img_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace img{
+
+    /**
+     * A histogram built in one pass without knowing the range of the values
+     * beforehand. The bins have a width which is a power of 2 and start at
+     * a multiple of it, so when a value falls outside numBins bins the width
+     * is doubled (merging pairs of bins) until the range fits. Histograms
+     * built separately (e.g., on different threads) can be merged.
+     *
+     * getBinCounts re-bins the counts to a histogram with a given range,
+     * each bin being counted by its lower edge. This is exact where the
+     * values are multiples of the final bin width (e.g., integers with a
+     * range of no more than numBins), otherwise a value may be counted in
+     * the neighbouring output bin if it is within one bin width of its edge.
+     */
+    class DllExport RSGISStreamHistogram
+    {
+    public:
+        RSGISStreamHistogram(unsigned int numBins=65536);
+        void add(double val);
+        void merge(const RSGISStreamHistogram &other);
+        unsigned long long getCount() const {return total;};
+        /** The current bin width. */
+        double getBinWidth() const {return std::ldexp(1.0, binExp);};
+        /**
+         * Count the values into numOutBins bins, bin b covering
+         * binLower + (b * binWidth) to binLower + ((b+1) * binWidth). Values
+         * outside the range are counted in the first or last bin.
+         */
+        void getBinCounts(double binLower, double binWidth, unsigned int numOutBins, std::vector<unsigned long long> *outCounts) const;
+        /**
+         * The percentile (0-100) of the values, as the centre of the bin in
+         * which the cumulative count reaches floor(count * percentile / 100)
+         * (as RSGISMathsUtils::calcPercentile). Returns NaN if there are no values.
+         */
+        double getPercentile(double percentile) const;
+        ~RSGISStreamHistogram(){};
+    protected:
+        long long getBinIdx(double val);
+        static long long floorDivPow2(long long idx, int shift)
+        {
+            if(shift <= 0)
+            {
+                return idx;
+            }
+            if(shift >= 63)
+            {
+                return (idx < 0)?-1:0;
+            }
+            return (idx >= 0) ? (idx >> shift) : (-((-(idx + 1)) >> shift) - 1);
+        };
+        void rebin(int newBinExp, long long newStartIdx);
+        unsigned int numBins;
+        int binExp;
+        long long startIdx;
+        long long minIdx;
+        long long maxIdx;
+        unsigned long long total;
+        std::vector<unsigned long long> counts;
+    };
+
+    /**
+     * Calculates the statistics of the bands of an image in a single pass:
+     * count, min, max, sum, mean and variance (Welford) for each band, with
+     * optionally a histogram of each band (RSGISStreamHistogram, or a
+     * direct histogram of the integer values for thematic images) and the
+     * covariance between the bands (using the pixels valid in all bands).
+     *
+     * The image is read a block of rows at a time, with the blocks shared
+     * among threads (setNumThreads or the RSGISLIB_NUM_THREADS environment
+     * variable). The partial results of each block are merged (Chan et al.)
+     * in a fixed tree over the blocks (rsgis::RSGISTreeReduction) and the
+     * sums are compensated (rsgis::RSGISCompensatedSum) so the results do
+     * not lose precision on large images and are identical whatever the
+     * number of threads. The direct histograms are counts, so there is one
+     * table per band, shared by the threads, rather than one per block.
+     * NaN values, and the no data value if used, are ignored.
+     *
+     * The variance is of the population (divided by the count), as for
+     * the other image statistics.
+     */
+    class DllExport RSGISSinglePassImageStats
+    {
+    public:
+        RSGISSinglePassImageStats(bool calcHistograms=false, bool calcCovariance=false, bool directHistograms=false, unsigned int numHistBins=65536);
+        /**
+         * The number of threads (0 uses the number of cores).
+         */
+        void setNumThreads(unsigned int numThreads);
+        /**
+         * Only use every step'th pixel and line (a decimated read, so GDAL
+         * will use an overview where there is a suitable one) giving an
+         * estimate of the statistics. The default of 1 uses all the pixels.
+         */
+        void setSubSample(unsigned int step){this->subSample = (step == 0)?1:step;};
+        /**
+         * Calculate the statistics for the bands (numbered from 1) of the
+         * image, all the bands if none are given.
+         */
+        void calcStats(GDALDataset *dataset, bool useNoData=false, float noDataVal=0, std::vector<unsigned int> bands=std::vector<unsigned int>());
+        /**
+         * Start calculating the statistics of numBands bands from blocks of
+         * data given to addBlock (e.g., as an image is written) rather than
+         * reading an image. The results are available after each block.
+         */
+        void startStream(unsigned int numBands, bool useNoData=false, float noDataVal=0);
+        /**
+         * Add nPxls pixels of each band, bandPlanes[band][pxl].
+         */
+        void addBlock(const double* const* bandPlanes, size_t nPxls);
+        /** The number of bands the statistics were calculated for (indexed from 0 in the order given). */
+        unsigned int getNumBands() const {return bandAccums.size();};
+        unsigned long long getCount(unsigned int idx) const {return bandAccums.at(idx).n;};
+        double getMin(unsigned int idx) const {return bandAccums.at(idx).min;};
+        double getMax(unsigned int idx) const {return bandAccums.at(idx).max;};
+        double getSum(unsigned int idx) const {return bandAccums.at(idx).sum + bandAccums.at(idx).sumComp;};
+        double getMean(unsigned int idx) const {return bandAccums.at(idx).mean;};
+        double getVariance(unsigned int idx) const;
+        double getStdDev(unsigned int idx) const {return std::sqrt(this->getVariance(idx));};
+        const RSGISStreamHistogram* getHistogram(unsigned int idx) const;
+        /**
+         * The direct histogram (the count of each integer value from 0) of a band.
+         */
+        const std::vector<unsigned long long>* getDirectHistogram(unsigned int idx) const;
+        /**
+         * The covariance between two bands, over the pixels valid in all the bands.
+         */
+        double getCovariance(unsigned int idxA, unsigned int idxB) const;
+        unsigned long long getCovarianceCount() const {return covAccum.n;};
+        ~RSGISSinglePassImageStats(){};
+    protected:
+        struct RSGISBandStatsAccum
+        {
+            unsigned long long n;
+            double min;
+            double max;
+            double sum;
+            double sumComp;
+            double mean;
+            double m2;
+            double m2Comp;
+            RSGISStreamHistogram hist;
+            std::vector<unsigned long long> directHist;
+        };
+        struct RSGISCovarianceAccum
+        {
+            unsigned long long n;
+            std::vector<double> means;
+            std::vector<double> coMoments;
+        };
+        struct RSGISBlockAccums
+        {
+            std::vector<RSGISBandStatsAccum> bands;
+            RSGISCovarianceAccum cov;
+        };
+        void initAccums(std::vector<RSGISBandStatsAccum> *accums, RSGISCovarianceAccum *cov, size_t numBands);
+        void mergeAccums(std::vector<RSGISBandStatsAccum> *accums, RSGISCovarianceAccum *cov, const std::vector<RSGISBandStatsAccum> &other, const RSGISCovarianceAccum &otherCov);
+        /**
+         * Merge the count, means and (upper triangle) co-moments of a set of
+         * pixels into a covariance accumulator. deltas is numBands workspace.
+         */
+        void mergeCovariance(RSGISCovarianceAccum *cov, unsigned long long otherN, const double *otherMeans, const double *otherCoMoments, double *deltas);
+        /**
+         * Add a chunk (pixels x bands, row major, which is overwritten) of pixels
+         * to the covariance, with the co-moments of the chunk as a rank-k update.
+         */
+        void accumulateCovChunk(RSGISCovarianceAccum &cov, double *chunk, size_t numChunkPxls, size_t numBands, double *chunkMeans, double *chunkCoMoments, double *deltas);
+        void accumulateBlock(std::vector<RSGISBandStatsAccum> &accums, RSGISCovarianceAccum &cov, const double* const* bandPlanes, size_t numBands, size_t numBlockPxls, bool useNoData, float noDataVal, std::vector<double> &deltas, bool addDirectHists);
+        /**
+         * Add a block of each band to the shared direct histograms (hists,
+         * one per band), as runs of equal values found without the lock so
+         * only the runs are added while holding histMutex. runs is workspace.
+         */
+        void addDirectHistBlock(const double* const* bandPlanes, size_t numBands, size_t numBlockPxls, bool useNoData, float noDataVal, std::vector<std::pair<size_t, unsigned long long> > &runs, std::vector<std::vector<unsigned long long> > *hists, std::mutex *histMutex);
+        static const size_t covChunkSize;
+        bool calcHistograms;
+        bool calcCovariance;
+        bool directHistograms;
+        unsigned int numHistBins;
+        unsigned int numThreads;
+        unsigned int subSample;
+        std::vector<RSGISBandStatsAccum> bandAccums;
+        RSGISCovarianceAccum covAccum;
+        bool streamUseNoData;
+        float streamNoDataVal;
+        std::vector<double> streamDeltas;
+    };
+
+}}
+
+#endif
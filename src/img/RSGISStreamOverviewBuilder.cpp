@@ -0,0 +1,263 @@
+/*
+ *  RSGISStreamOverviewBuilder.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISStreamOverviewBuilder.h"
+
+#include <algorithm>
+
+namespace rsgis{namespace img{
+
+    void RSGISStreamOverviewBuilder::createOverviews(GDALDataset *dataset, std::vector<int> factors)
+    {
+        if(factors.empty())
+        {
+            return;
+        }
+        // Allocate the overviews only, their data comes from addRows.
+        if(dataset->BuildOverviews("NONE", factors.size(), factors.data(), 0, NULL, NULL, NULL) != CE_None)
+        {
+            throw RSGISImageBandException("Could not create the overviews for the output image.");
+        }
+    }
+
+    RSGISStreamOverviewBuilder::RSGISStreamOverviewBuilder(GDALDataset *dataset, std::vector<int> factors, bool nearest, int stripRows)
+    {
+        this->dataset = dataset;
+        this->width = dataset->GetRasterXSize();
+        this->height = dataset->GetRasterYSize();
+        this->numBands = dataset->GetRasterCount();
+        this->stripRows = std::max(stripRows, 1);
+        this->nearest = nearest;
+        this->nextRow = 0;
+
+        int maxFactor = 1;
+        for(std::vector<int>::iterator iterFactor = factors.begin(); iterFactor != factors.end(); ++iterFactor)
+        {
+            if(((*iterFactor) < 2) || (((*iterFactor) & ((*iterFactor) - 1)) != 0))
+            {
+                throw RSGISImageBandException("Overviews built while writing must have decimation factors which are powers of 2.");
+            }
+            maxFactor = std::max(maxFactor, *iterFactor);
+        }
+
+        GDALRasterBand *band = dataset->GetRasterBand(1);
+        int levelWidth = this->width;
+        int levelHeight = this->height;
+        for(int factor = 2; factor <= maxFactor; factor *= 2)
+        {
+            int prevWidth = levelWidth;
+            levelWidth = (levelWidth + 1) / 2;
+            levelHeight = (levelHeight + 1) / 2;
+
+            OverviewLevel level;
+            level.width = levelWidth;
+            level.height = levelHeight;
+            level.overviewIdx = -1;
+            if(std::find(factors.begin(), factors.end(), factor) != factors.end())
+            {
+                for(int i = 0; i < band->GetOverviewCount(); ++i)
+                {
+                    GDALRasterBand *ovBand = band->GetOverview(i);
+                    if((ovBand->GetXSize() == levelWidth) && (ovBand->GetYSize() == levelHeight))
+                    {
+                        level.overviewIdx = i;
+                        break;
+                    }
+                }
+                if(level.overviewIdx < 0)
+                {
+                    throw RSGISImageBandException("The output image does not have an overview of the expected size.");
+                }
+            }
+            level.pairRow.resize(((size_t)this->numBands) * prevWidth);
+            level.havePairRow = false;
+            // Levels which are not stored only need to hold the row being passed on.
+            int levelStripRows = (level.overviewIdx < 0)?1:this->stripRows;
+            level.strip.resize(((size_t)this->numBands) * levelStripRows * levelWidth);
+            level.stripStartRow = 0;
+            level.stripNumRows = 0;
+            level.nextRow = 0;
+            this->levels.push_back(level);
+        }
+        this->rowBuffer.resize(((size_t)this->numBands) * this->width);
+    }
+
+    void RSGISStreamOverviewBuilder::addRows(double **outputData, int rowOffset, int nRows)
+    {
+        if(rowOffset != this->nextRow)
+        {
+            // Overviews are built in row order so hold blocks which arrive early.
+            size_t bandSize = ((size_t)this->width) * nRows;
+            std::vector<double> &block = this->pendingBlocks[rowOffset];
+            block.resize(bandSize * this->numBands);
+            for(int n = 0; n < this->numBands; ++n)
+            {
+                std::copy(outputData[n], outputData[n] + bandSize, block.begin() + (n * bandSize));
+            }
+            return;
+        }
+        for(int r = 0; r < nRows; ++r)
+        {
+            this->processRow(outputData, ((size_t)r) * this->width);
+        }
+
+        std::map<int, std::vector<double> >::iterator iterBlock = this->pendingBlocks.begin();
+        std::vector<double*> bandPtrs(this->numBands);
+        while((iterBlock != this->pendingBlocks.end()) && (iterBlock->first == this->nextRow))
+        {
+            size_t bandSize = iterBlock->second.size() / this->numBands;
+            int blockRows = bandSize / this->width;
+            for(int n = 0; n < this->numBands; ++n)
+            {
+                bandPtrs[n] = &iterBlock->second[n * bandSize];
+            }
+            for(int r = 0; r < blockRows; ++r)
+            {
+                this->processRow(bandPtrs.data(), ((size_t)r) * this->width);
+            }
+            this->pendingBlocks.erase(iterBlock);
+            iterBlock = this->pendingBlocks.begin();
+        }
+    }
+
+    void RSGISStreamOverviewBuilder::processRow(double **outputData, size_t rowStart)
+    {
+        ++this->nextRow;
+        if(this->levels.empty())
+        {
+            return;
+        }
+        for(int n = 0; n < this->numBands; ++n)
+        {
+            std::copy(outputData[n] + rowStart, outputData[n] + rowStart + this->width, this->rowBuffer.begin() + (((size_t)n) * this->width));
+        }
+        this->pushRow(0, this->rowBuffer.data(), this->width, this->nextRow == this->height);
+    }
+
+    void RSGISStreamOverviewBuilder::pushRow(unsigned int level, const double *row, int rowWidth, bool lastRow)
+    {
+        OverviewLevel &ovLevel = this->levels[level];
+        const double *row1 = row;
+        const double *row2 = row;
+        if(ovLevel.havePairRow)
+        {
+            row1 = ovLevel.pairRow.data();
+            ovLevel.havePairRow = false;
+        }
+        else if(!lastRow)
+        {
+            std::copy(row, row + (((size_t)this->numBands) * rowWidth), ovLevel.pairRow.begin());
+            ovLevel.havePairRow = true;
+            return;
+        }
+
+        // Rows are stored band interleaved so each strip row can be passed on to the next level.
+        double *outRow = &ovLevel.strip[((size_t)ovLevel.stripNumRows) * this->numBands * ovLevel.width];
+        for(int n = 0; n < this->numBands; ++n)
+        {
+            const double *band1 = row1 + (((size_t)n) * rowWidth);
+            const double *band2 = row2 + (((size_t)n) * rowWidth);
+            double *outBand = outRow + (((size_t)n) * ovLevel.width);
+            for(int x = 0; x < ovLevel.width; ++x)
+            {
+                int x1 = x * 2;
+                int x2 = (x1 + 1 < rowWidth)?(x1 + 1):x1;
+                if(this->nearest)
+                {
+                    outBand[x] = band1[x1];
+                }
+                else
+                {
+                    outBand[x] = this->combine(band1[x1], band1[x2], band2[x1], band2[x2]);
+                }
+            }
+        }
+        ++ovLevel.stripNumRows;
+        ++ovLevel.nextRow;
+        bool levelLastRow = (ovLevel.nextRow == ovLevel.height);
+
+        if((level + 1) < this->levels.size())
+        {
+            this->pushRow(level + 1, outRow, ovLevel.width, levelLastRow);
+        }
+        if(ovLevel.overviewIdx < 0)
+        {
+            ovLevel.stripNumRows = 0;
+        }
+        else if((ovLevel.stripNumRows == this->stripRows) || levelLastRow)
+        {
+            this->flushStrip(level);
+        }
+    }
+
+    void RSGISStreamOverviewBuilder::flushStrip(unsigned int level)
+    {
+        OverviewLevel &ovLevel = this->levels[level];
+        if((ovLevel.stripNumRows == 0) || (ovLevel.overviewIdx < 0))
+        {
+            return;
+        }
+        GSpacing lineSpace = sizeof(double) * ((GSpacing)this->numBands) * ovLevel.width;
+        for(int n = 0; n < this->numBands; ++n)
+        {
+            GDALRasterBand *ovBand = this->dataset->GetRasterBand(n+1)->GetOverview(ovLevel.overviewIdx);
+            if(ovBand->RasterIO(GF_Write, 0, ovLevel.stripStartRow, ovLevel.width, ovLevel.stripNumRows, &ovLevel.strip[((size_t)n) * ovLevel.width], ovLevel.width, ovLevel.stripNumRows, GDT_Float64, sizeof(double), lineSpace) != CE_None)
+            {
+                throw RSGISImageBandException("Could not write the overviews of the output image.");
+            }
+        }
+        ovLevel.stripStartRow += ovLevel.stripNumRows;
+        ovLevel.stripNumRows = 0;
+    }
+
+    double RSGISStreamOverviewBuilder::combine(double v1, double v2, double v3, double v4)
+    {
+        double sum = 0;
+        unsigned int count = 0;
+        const double vals[] = {v1, v2, v3, v4};
+        for(unsigned int i = 0; i < 4; ++i)
+        {
+            if(!std::isnan(vals[i]))
+            {
+                sum += vals[i];
+                ++count;
+            }
+        }
+        if(count == 0)
+        {
+            return std::nan("");
+        }
+        return sum / count;
+    }
+
+    void RSGISStreamOverviewBuilder::finish()
+    {
+        if(this->nextRow != this->height)
+        {
+            throw RSGISImageBandException("Not all the rows of the image were given to the overview builder.");
+        }
+        for(unsigned int i = 0; i < this->levels.size(); ++i)
+        {
+            this->flushStrip(i);
+        }
+    }
+
+}}
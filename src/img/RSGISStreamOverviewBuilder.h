@@ -0,0 +1,121 @@
+/*
+ *  RSGISStreamOverviewBuilder.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISStreamOverviewBuilder_H
+#define RSGISStreamOverviewBuilder_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+
+#include "gdal_priv.h"
+
+#include "img/RSGISImageBandException.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_img_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace img{
+
+    /**
+     * Receives each block of output rows once it has been written to the
+     * output image by RSGISCalcImage. outputData[band][(row*width)+col];
+     * blocks may arrive out of order when multi-threaded. finish is called
+     * once all the rows have been written and before the image is closed.
+     */
+    class DllExport RSGISImageOutputSink
+    {
+    public:
+        virtual void addRows(double **outputData, int numBands, int width, int rowOffset, int nRows) = 0;
+        virtual void finish() = 0;
+        virtual ~RSGISImageOutputSink(){};
+    };
+
+    /**
+     * Builds the overviews of an image from its rows as they are written,
+     * rather than re-reading the image (i.e., GDALDataset::BuildOverviews).
+     * Each level is made from the previous one by halving, so the
+     * decimation factors must be powers of 2; intermediate levels which
+     * were not requested are built but not stored. Values are the average
+     * of the (non-NaN) pixels or, if nearest, the top left pixel. Rows are
+     * used in order so blocks which arrive early are held until needed.
+     */
+    class DllExport RSGISStreamOverviewBuilder
+    {
+    public:
+        /**
+         * Create the (empty) overviews of the image for the factors.
+         */
+        static void createOverviews(GDALDataset *dataset, std::vector<int> factors);
+        /**
+         * The overviews for the factors must already exist (createOverviews).
+         */
+        RSGISStreamOverviewBuilder(GDALDataset *dataset, std::vector<int> factors, bool nearest, int stripRows=512);
+        void addRows(double **outputData, int rowOffset, int nRows);
+        /**
+         * Write the remaining overview rows, requires all the image rows.
+         */
+        void finish();
+        ~RSGISStreamOverviewBuilder(){};
+    protected:
+        struct OverviewLevel
+        {
+            int width;
+            int height;
+            int overviewIdx;
+            std::vector<double> pairRow;
+            bool havePairRow;
+            std::vector<double> strip;
+            int stripStartRow;
+            int stripNumRows;
+            int nextRow;
+        };
+        void processRow(double **outputData, size_t rowStart);
+        void pushRow(unsigned int level, const double *row, int rowWidth, bool lastRow);
+        void flushStrip(unsigned int level);
+        double combine(double v1, double v2, double v3, double v4);
+        GDALDataset *dataset;
+        int width;
+        int height;
+        int numBands;
+        int stripRows;
+        bool nearest;
+        std::vector<OverviewLevel> levels;
+        std::vector<double> rowBuffer;
+        int nextRow;
+        std::map<int, std::vector<double> > pendingBlocks;
+    };
+
+}}
+
+#endif
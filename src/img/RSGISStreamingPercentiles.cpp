@@ -0,0 +1,340 @@
+/*
+ *  RSGISStreamingPercentiles.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2010 RSGISLib. All rights reserved.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISStreamingPercentiles.h"
+
+namespace rsgis{namespace img{
+
+    RSGISStreamingPercentiles::RSGISStreamingPercentiles(unsigned int numBins, size_t maxExactVals)
+    {
+        this->numBins = std::max<unsigned int>(numBins, 2);
+        this->maxExactVals = std::max<size_t>(maxExactVals, 1);
+        this->maxError = 0;
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+
+    void RSGISStreamingPercentiles::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+
+    void RSGISStreamingPercentiles::setMaxError(double maxError)
+    {
+        if(maxError < 0)
+        {
+            throw RSGISImageException("The maximum error of a percentile cannot be negative.");
+        }
+        this->maxError = maxError;
+    }
+
+    std::vector<double> RSGISStreamingPercentiles::getPercentiles(GDALDataset *dataset, unsigned int band, std::vector<float> percentiles, float noDataVal, bool noDataDefined)
+    {
+        if(dataset == NULL)
+        {
+            throw RSGISImageException("The image dataset is NULL.");
+        }
+        if((band < 1) || (band > ((unsigned int)dataset->GetRasterCount())))
+        {
+            throw RSGISImageException("The band is not within the image (band numbers start at 1).");
+        }
+        for(std::vector<float>::iterator iterPercent = percentiles.begin(); iterPercent != percentiles.end(); ++iterPercent)
+        {
+            if(!((*iterPercent) >= 0) || ((*iterPercent) > 1))
+            {
+                throw RSGISImageException("Percentile values must be between 0 - 1.");
+            }
+        }
+        unsigned int nThreads = this->numThreads;
+
+        // Pass 1: the number of valid values and their range.
+        std::vector<unsigned long long> thCounts(nThreads, 0);
+        std::vector<double> thMins(nThreads, std::numeric_limits<double>::max());
+        std::vector<double> thMaxs(nThreads, -std::numeric_limits<double>::max());
+        this->readBand(dataset, band, noDataVal, noDataDefined, nThreads, [&](unsigned int t, const double *vals, size_t numVals)
+        {
+            for(size_t i = 0; i < numVals; ++i)
+            {
+                thMins[t] = std::min(thMins[t], vals[i]);
+                thMaxs[t] = std::max(thMaxs[t], vals[i]);
+            }
+            thCounts[t] += numVals;
+        });
+        unsigned long long numVals = 0;
+        double minVal = std::numeric_limits<double>::max();
+        double maxVal = -std::numeric_limits<double>::max();
+        for(unsigned int t = 0; t < nThreads; ++t)
+        {
+            numVals += thCounts[t];
+            minVal = std::min(minVal, thMins[t]);
+            maxVal = std::max(maxVal, thMaxs[t]);
+        }
+        if(numVals == 0)
+        {
+            throw RSGISImageException("There are no valid pixel values within the image band.");
+        }
+
+        // Each percentile is interpolated between the values at two ranks.
+        std::vector<RSGISPercentileRankSearch> searches;
+        std::vector<unsigned long long> lowerRanks;
+        std::vector<double> rankFracs;
+        for(std::vector<float>::iterator iterPercent = percentiles.begin(); iterPercent != percentiles.end(); ++iterPercent)
+        {
+            double index = ((double)(*iterPercent)) * (numVals - 1);
+            unsigned long long lowerRank = std::min<unsigned long long>((unsigned long long)index, numVals - 1);
+            lowerRanks.push_back(lowerRank);
+            rankFracs.push_back(index - lowerRank);
+        }
+        std::vector<unsigned long long> ranks;
+        for(size_t i = 0; i < lowerRanks.size(); ++i)
+        {
+            ranks.push_back(lowerRanks[i]);
+            if(lowerRanks[i] < (numVals - 1))
+            {
+                ranks.push_back(lowerRanks[i] + 1);
+            }
+        }
+        std::sort(ranks.begin(), ranks.end());
+        ranks.erase(std::unique(ranks.begin(), ranks.end()), ranks.end());
+        for(std::vector<unsigned long long>::iterator iterRank = ranks.begin(); iterRank != ranks.end(); ++iterRank)
+        {
+            RSGISPercentileRankSearch search;
+            search.rank = *iterRank;
+            search.offset = 0;
+            search.count = numVals;
+            search.lower = minVal;
+            search.upper = maxVal;
+            search.found = false;
+            search.value = 0;
+            searches.push_back(search);
+        }
+
+        // Refine the range of each rank until its values can be selected exactly.
+        while(true)
+        {
+            std::vector<size_t> histSearches;
+            std::vector<size_t> gatherSearches;
+            for(size_t s = 0; s < searches.size(); ++s)
+            {
+                RSGISPercentileRankSearch *search = &searches[s];
+                if(search->found)
+                {
+                    continue;
+                }
+                if(search->lower == search->upper)
+                {
+                    search->value = search->lower;
+                    search->found = true;
+                }
+                else if(search->count <= this->maxExactVals)
+                {
+                    gatherSearches.push_back(s);
+                }
+                else if((this->maxError > 0) && ((search->upper - search->lower) <= this->maxError))
+                {
+                    search->value = search->lower + ((search->upper - search->lower) * ((((double)(search->rank - search->offset)) + 0.5) / search->count));
+                    search->found = true;
+                }
+                else
+                {
+                    histSearches.push_back(s);
+                }
+            }
+            if(histSearches.empty() && gatherSearches.empty())
+            {
+                break;
+            }
+
+            size_t numHists = histSearches.size();
+            std::vector<double> binWidths(numHists, 0);
+            for(size_t h = 0; h < numHists; ++h)
+            {
+                binWidths[h] = (searches[histSearches[h]].upper - searches[histSearches[h]].lower) / this->numBins;
+            }
+            std::vector<std::vector<unsigned long long> > thBinCounts(nThreads * numHists);
+            std::vector<std::vector<double> > thBinMins(nThreads * numHists);
+            std::vector<std::vector<double> > thBinMaxs(nThreads * numHists);
+            for(size_t i = 0; i < (nThreads * numHists); ++i)
+            {
+                thBinCounts[i].assign(this->numBins, 0);
+                thBinMins[i].assign(this->numBins, std::numeric_limits<double>::max());
+                thBinMaxs[i].assign(this->numBins, -std::numeric_limits<double>::max());
+            }
+            std::vector<std::vector<double> > thGathered(nThreads * gatherSearches.size());
+
+            this->readBand(dataset, band, noDataVal, noDataDefined, nThreads, [&](unsigned int t, const double *vals, size_t numVals)
+            {
+                for(size_t h = 0; h < numHists; ++h)
+                {
+                    const RSGISPercentileRankSearch &search = searches[histSearches[h]];
+                    unsigned long long *binCounts = thBinCounts[(t * numHists) + h].data();
+                    double *binMins = thBinMins[(t * numHists) + h].data();
+                    double *binMaxs = thBinMaxs[(t * numHists) + h].data();
+                    for(size_t i = 0; i < numVals; ++i)
+                    {
+                        if(this->inSearch(search, vals[i]))
+                        {
+                            size_t bin = this->getBin(vals[i], search.lower, binWidths[h]);
+                            ++binCounts[bin];
+                            binMins[bin] = std::min(binMins[bin], vals[i]);
+                            binMaxs[bin] = std::max(binMaxs[bin], vals[i]);
+                        }
+                    }
+                }
+                for(size_t g = 0; g < gatherSearches.size(); ++g)
+                {
+                    const RSGISPercentileRankSearch &search = searches[gatherSearches[g]];
+                    std::vector<double> *gathered = &thGathered[(t * gatherSearches.size()) + g];
+                    for(size_t i = 0; i < numVals; ++i)
+                    {
+                        if(this->inSearch(search, vals[i]))
+                        {
+                            gathered->push_back(vals[i]);
+                        }
+                    }
+                }
+            });
+
+            for(size_t h = 0; h < numHists; ++h)
+            {
+                RSGISPercentileRankSearch *search = &searches[histSearches[h]];
+                unsigned long long cumCount = 0;
+                unsigned long long targetRank = search->rank - search->offset;
+                bool binFound = false;
+                for(size_t bin = 0; bin < this->numBins; ++bin)
+                {
+                    unsigned long long binCount = 0;
+                    double binMin = std::numeric_limits<double>::max();
+                    double binMax = -std::numeric_limits<double>::max();
+                    for(unsigned int t = 0; t < nThreads; ++t)
+                    {
+                        binCount += thBinCounts[(t * numHists) + h][bin];
+                        binMin = std::min(binMin, thBinMins[(t * numHists) + h][bin]);
+                        binMax = std::max(binMax, thBinMaxs[(t * numHists) + h][bin]);
+                    }
+                    if((cumCount + binCount) > targetRank)
+                    {
+                        RSGISPercentileBinLevel level;
+                        level.lower = search->lower;
+                        level.binWidth = binWidths[h];
+                        level.bin = bin;
+                        search->levels.push_back(level);
+                        search->offset += cumCount;
+                        search->count = binCount;
+                        search->lower = binMin;
+                        search->upper = binMax;
+                        binFound = true;
+                        break;
+                    }
+                    cumCount += binCount;
+                }
+                if(!binFound)
+                {
+                    throw RSGISImageException("The pixel values of the band changed while the percentiles were being calculated.");
+                }
+            }
+
+            for(size_t g = 0; g < gatherSearches.size(); ++g)
+            {
+                RSGISPercentileRankSearch *search = &searches[gatherSearches[g]];
+                std::vector<double> gathered;
+                gathered.reserve(search->count);
+                for(unsigned int t = 0; t < nThreads; ++t)
+                {
+                    std::vector<double> *thVals = &thGathered[(t * gatherSearches.size()) + g];
+                    gathered.insert(gathered.end(), thVals->begin(), thVals->end());
+                    std::vector<double>().swap(*thVals);
+                }
+                unsigned long long targetRank = search->rank - search->offset;
+                if(gathered.size() != search->count)
+                {
+                    throw RSGISImageException("The pixel values of the band changed while the percentiles were being calculated.");
+                }
+                std::nth_element(gathered.begin(), gathered.begin() + targetRank, gathered.end());
+                search->value = gathered[targetRank];
+                search->found = true;
+            }
+        }
+
+        std::vector<double> outVals;
+        for(size_t i = 0; i < lowerRanks.size(); ++i)
+        {
+            size_t s = std::lower_bound(ranks.begin(), ranks.end(), lowerRanks[i]) - ranks.begin();
+            double val = searches[s].value;
+            if(lowerRanks[i] < (numVals - 1))
+            {
+                val = ((1 - rankFracs[i]) * val) + (rankFracs[i] * searches[s+1].value);
+            }
+            outVals.push_back(val);
+        }
+        return outVals;
+    }
+
+    void RSGISStreamingPercentiles::readBand(GDALDataset *dataset, unsigned int band, float noDataVal, bool noDataDefined, unsigned int nThreads, BlockFunc func)
+    {
+        GDALRasterBand *gdalBand = dataset->GetRasterBand(band);
+        int width = dataset->GetRasterXSize();
+        int height = dataset->GetRasterYSize();
+        int xBlockSize = 0;
+        int yBlockSize = 0;
+        gdalBand->GetBlockSize(&xBlockSize, &yBlockSize);
+        yBlockSize = std::max(yBlockSize, 1);
+        unsigned int nBlocks = (height + yBlockSize - 1) / yBlockSize;
+
+        std::mutex ioMutex;
+        rsgis::utils::RSGISWorkerPool pool(nThreads);
+        std::vector<std::vector<double> > threadBlockData(pool.getNumThreads());
+        pool.parallelFor(nBlocks, [&](size_t blk, unsigned int t)
+        {
+            std::vector<double> &blockData = threadBlockData[t];
+            blockData.resize(((size_t)width) * yBlockSize);
+            int yOff = blk * yBlockSize;
+            int numRows = std::min(yBlockSize, height - yOff);
+            {
+                std::lock_guard<std::mutex> lock(ioMutex);
+                if(gdalBand->RasterIO(GF_Read, 0, yOff, width, numRows, blockData.data(), width, numRows, GDT_Float64, 0, 0) != CE_None)
+                {
+                    throw RSGISImageException("Could not read a block of the image band.");
+                }
+            }
+            // Only the valid values are passed on.
+            size_t numBlockVals = ((size_t)width) * numRows;
+            size_t numValid = 0;
+            for(size_t i = 0; i < numBlockVals; ++i)
+            {
+                double val = blockData[i];
+                if(std::isnan(val) || (noDataDefined && (((float)val) == noDataVal)))
+                {
+                    continue;
+                }
+                blockData[numValid++] = val;
+            }
+            func(t, blockData.data(), numValid);
+        });
+    }
+
+    RSGISStreamingPercentiles::~RSGISStreamingPercentiles()
+    {
+
+    }
+
+}}
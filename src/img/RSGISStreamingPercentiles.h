@@ -0,0 +1,144 @@
+/*
+ *  RSGISStreamingPercentiles.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2010 RSGISLib. All rights reserved.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISStreamingPercentiles_H
+#define RSGISStreamingPercentiles_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <cstdlib>
+#include <limits>
+
+#include "gdal_priv.h"
+
+#include "common/RSGISImageException.h"
+#include "common/RSGISParallel.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_img_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace img{
+
+    /**
+     * Finds percentiles of an image band in bounded memory, without holding
+     * (or sorting) all of its pixel values.
+     *
+     * The first pass over the band finds the number of valid pixels and
+     * their range. The percentiles are then the values at known ranks, each
+     * found by counting the pixels into a fixed-bin histogram and refining
+     * the range to the bin holding the rank. Once the bin has no more than
+     * maxExactVals pixels they are read and the value selected exactly, so
+     * with a maxError of 0 the result is the same as sorting the pixels
+     * (interpolated between ranks as gsl_stats_quantile_from_sorted_data).
+     * Where maxError is greater than 0 the refinement stops when the bin is
+     * narrower than maxError, generally saving a pass.
+     *
+     * Each pass reads the band block by block, with the blocks counted in
+     * parallel using setNumThreads or the RSGISLIB_NUM_THREADS environment
+     * variable.
+     */
+    class DllExport RSGISStreamingPercentiles
+    {
+    public:
+        RSGISStreamingPercentiles(unsigned int numBins=16384, size_t maxExactVals=4194304);
+        /**
+         * The number of threads used to count the blocks (0 uses the number of cores).
+         */
+        void setNumThreads(unsigned int numThreads);
+        /**
+         * The largest absolute error accepted in a percentile, 0 for exact values.
+         */
+        void setMaxError(double maxError);
+        /**
+         * The percentiles (between 0 and 1) of a band (numbered from 1).
+         * NaN values, and the no data value if defined, are ignored.
+         */
+        std::vector<double> getPercentiles(GDALDataset *dataset, unsigned int band, std::vector<float> percentiles, float noDataVal, bool noDataDefined);
+        ~RSGISStreamingPercentiles();
+    protected:
+        struct RSGISPercentileBinLevel
+        {
+            double lower;
+            double binWidth;
+            size_t bin;
+        };
+        struct RSGISPercentileRankSearch
+        {
+            unsigned long long rank;
+            unsigned long long offset;
+            unsigned long long count;
+            double lower;
+            double upper;
+            bool found;
+            double value;
+            std::vector<RSGISPercentileBinLevel> levels;
+        };
+        typedef std::function<void(unsigned int thread, const double *vals, size_t numVals)> BlockFunc;
+        void readBand(GDALDataset *dataset, unsigned int band, float noDataVal, bool noDataDefined, unsigned int nThreads, BlockFunc func);
+        inline size_t getBin(double val, double lower, double binWidth)
+        {
+            double binF = (val - lower) / binWidth;
+            if(!(binF > 0))
+            {
+                return 0;
+            }
+            return (binF >= this->numBins) ? (this->numBins - 1) : ((size_t)binF);
+        };
+        inline bool inSearch(const RSGISPercentileRankSearch &search, double val)
+        {
+            for(std::vector<RSGISPercentileBinLevel>::const_iterator iterLevel = search.levels.begin(); iterLevel != search.levels.end(); ++iterLevel)
+            {
+                if(this->getBin(val, iterLevel->lower, iterLevel->binWidth) != iterLevel->bin)
+                {
+                    return false;
+                }
+            }
+            return true;
+        };
+        unsigned int numBins;
+        size_t maxExactVals;
+        double maxError;
+        unsigned int numThreads;
+    };
+
+}}
+
+#endif
@@ -39,15 +39,78 @@ namespace rsgis { namespace img {
         this->useNoData = useNoData;
         this->inNoData = inNoData;
         this->outNoData = outNoData;
+        this->statsSampleStep = 1;
 	}
+    
+    void RSGISStretchImage::calcStretchStats(GDALDataset **datasets, ImageStats **stats, int numBands, bool stddev)
+    {
+        if(this->statsSampleStep <= 1)
+        {
+            RSGISImageStatistics calcImageStats;
+            calcImageStats.calcImageStatistics(datasets, 1, stats, numBands, stddev, this->useNoData, this->inNoData, onePassSD);
+            return;
+        }
+        
+        RSGISSinglePassImageStats passStats;
+        passStats.setSubSample(this->statsSampleStep);
+        try
+        {
+            passStats.calcStats(datasets[0], this->useNoData, this->inNoData);
+        }
+        catch(RSGISImageException &e)
+        {
+            throw RSGISImageCalcException(e.what());
+        }
+        for(int i = 0; i < numBands; i++)
+        {
+            stats[i]->mean = passStats.getMean(i);
+            stats[i]->min = passStats.getMin(i);
+            stats[i]->max = passStats.getMax(i);
+            stats[i]->sum = passStats.getSum(i);
+            stats[i]->stddev = stddev?passStats.getStdDev(i):0;
+        }
+    }
+    
+    void RSGISStretchImage::applyLinearStretch(GDALDataset **datasets, double *imageMax, double *imageMin, double *outMax, double *outMin)
+    {
+        int numBands = datasets[0]->GetRasterCount();
+        RSGISLinearStretchImage linearStretchImage = RSGISLinearStretchImage(numBands, imageMax, imageMin, outMax, outMin, this->useNoData, this->inNoData, this->outNoData);
+        
+        // Integer inputs of up to 16 bits are stretched with a lookup table,
+        // filled by the per-pixel stretch so the output is unchanged.
+        int lutMin = 0;
+        unsigned int lutSize = 0;
+        if(RSGISIntegerLUTImage::getIntegerRange(datasets[0], &lutMin, &lutSize))
+        {
+            std::vector< std::vector<double> > luts(numBands, std::vector<double>(lutSize, 0));
+            std::vector<float> bandValues(numBands, 0);
+            std::vector<double> output(numBands, 0);
+            for(unsigned int j = 0; j < lutSize; ++j)
+            {
+                bandValues.assign(numBands, (float)(lutMin + ((long)j)));
+                linearStretchImage.calcImageValue(bandValues.data(), numBands, output.data());
+                for(int i = 0; i < numBands; ++i)
+                {
+                    luts[i][j] = output[i];
+                }
+            }
+            RSGISIntegerLUTImage lutImage(numBands, lutMin, lutSize);
+            for(int i = 0; i < numBands; ++i)
+            {
+                lutImage.setBandLUT(i, i, luts[i]);
+            }
+            lutImage.apply(datasets[0], this->outputImage, this->imageFormat, this->outDataType);
+            return;
+        }
+        
+        RSGISCalcImage calcImg = RSGISCalcImage(&linearStretchImage, "", true);
+        calcImg.calcImage(datasets, 1, outputImage, false, NULL, imageFormat, outDataType);
+    }
 	
 	void RSGISStretchImage::executeLinearMinMaxStretch() 
 	{
 		GDALDataset **datasets = NULL;
-		RSGISImageStatistics *calcImageStats = NULL;
 		ImageStats **stats = NULL;
-		RSGISCalcImage *calcImg = NULL;
-		RSGISLinearStretchImage *linearStretchImage = NULL;
 		double *imageMax = NULL;
 		double *imageMin = NULL;
 		double *outMax = NULL;
@@ -68,9 +131,8 @@ namespace rsgis { namespace img {
 			{
 				stats[i] = new ImageStats();
 			}
-			calcImageStats = new RSGISImageStatistics();
             
-			calcImageStats->calcImageStatistics(datasets, 1, stats, numBands, false, this->useNoData, this->inNoData, onePassSD);
+			this->calcStretchStats(datasets, stats, numBands, false);
 			
             std::ofstream outTxtFile;
             if(this->outStats)
@@ -108,11 +170,8 @@ namespace rsgis { namespace img {
 				delete stats[i];
 			}
 			delete[] stats;
-			delete calcImageStats;
 
-			linearStretchImage = new RSGISLinearStretchImage(numBands, imageMax, imageMin, outMax, outMin, this->useNoData, this->inNoData, this->outNoData);
-			calcImg = new RSGISCalcImage(linearStretchImage, "", true);
-			calcImg->calcImage(datasets, 1, outputImage, false, NULL, imageFormat, outDataType);
+			this->applyLinearStretch(datasets, imageMax, imageMin, outMax, outMin);
 			
 		}
 		catch(RSGISImageCalcException &e)
@@ -137,8 +196,6 @@ namespace rsgis { namespace img {
 		delete[] outMax;
 		delete[] outMin;
 		
-		delete linearStretchImage;
-		delete calcImg;
 		
 		if(datasets != NULL)
 		{
@@ -146,13 +203,10 @@ namespace rsgis { namespace img {
 		}
 	}
 	
-	void RSGISStretchImage::executeLinearPercentStretch(float percent) 
+	void RSGISStretchImage::executeLinearPercentStretch(float percent, bool usePercentiles) 
 	{
 		GDALDataset **datasets = NULL;
-		RSGISImageStatistics *calcImageStats = NULL;
 		ImageStats **stats = NULL;
-		RSGISCalcImage *calcImg = NULL;
-		RSGISLinearStretchImage *linearStretchImage = NULL;
 		double *imageMax = NULL;
 		double *imageMin = NULL;
 		double *outMax = NULL;
@@ -173,8 +227,10 @@ namespace rsgis { namespace img {
 			{
 				stats[i] = new ImageStats();
 			}
-			calcImageStats = new RSGISImageStatistics();
-			calcImageStats->calcImageStatistics(datasets, 1, stats, numBands, false, this->useNoData, this->inNoData, onePassSD);
+            if(!usePercentiles)
+            {
+                this->calcStretchStats(datasets, stats, numBands, false);
+            }
 			
 			double onePercent = 0;
 			double onePercentUpper = 0;
@@ -192,15 +248,28 @@ namespace rsgis { namespace img {
                 outTxtFile << "#band,img_min,img_max,out_min,out_max\n";
             }
             
+            RSGISImagePercentiles calcPercentiles;
+            std::vector<float> percentiles;
+            percentiles.push_back(percent/100);
+            percentiles.push_back(1 - (percent/100));
 			for(int i = 0; i < numBands; i++)
-			{				
-				onePercent = (stats[i]->max - stats[i]->min)/100;
-				
-				onePercentUpper = (stats[i]->max - stats[i]->mean)/50;
-				onePercentLower = (stats[i]->mean - stats[i]->min)/50;
-				
-				imageMin[i] = stats[i]->min + (onePercentLower * percent);
-				imageMax[i] = stats[i]->max - (onePercentUpper * percent);
+			{
+                if(usePercentiles)
+                {
+                    std::vector<double> bandPercentiles = calcPercentiles.getPercentiles(inputImage, i+1, percentiles, this->inNoData, this->useNoData);
+                    imageMin[i] = bandPercentiles[0];
+                    imageMax[i] = bandPercentiles[1];
+                }
+                else
+                {
+                    onePercent = (stats[i]->max - stats[i]->min)/100;
+                    
+                    onePercentUpper = (stats[i]->max - stats[i]->mean)/50;
+                    onePercentLower = (stats[i]->mean - stats[i]->min)/50;
+                    
+                    imageMin[i] = stats[i]->min + (onePercentLower * percent);
+                    imageMax[i] = stats[i]->max - (onePercentUpper * percent);
+                }
 				outMax[i] = this->outMaxVal;
 				outMin[i] = this->outMinVal;
                 
@@ -221,11 +290,8 @@ namespace rsgis { namespace img {
 				delete stats[i];
 			}
 			delete[] stats;
-			delete calcImageStats;
 			
-			linearStretchImage = new RSGISLinearStretchImage(numBands, imageMax, imageMin, outMax, outMin, this->useNoData, this->inNoData, this->outNoData);
-			calcImg = new RSGISCalcImage(linearStretchImage, "", true);
-			calcImg->calcImage(datasets, 1, outputImage, false, NULL, imageFormat, outDataType);
+			this->applyLinearStretch(datasets, imageMax, imageMin, outMax, outMin);
 			
 		}
 		catch(RSGISImageCalcException &e)
@@ -250,8 +316,6 @@ namespace rsgis { namespace img {
 		delete[] outMax;
 		delete[] outMin;
 		
-		delete linearStretchImage;
-		delete calcImg;
 		
 		if(datasets != NULL)
 		{
@@ -263,10 +327,7 @@ namespace rsgis { namespace img {
 	void RSGISStretchImage::executeLinearStdDevStretch(float stddev) 
 	{
 		GDALDataset **datasets = NULL;
-		RSGISImageStatistics *calcImageStats = NULL;
 		ImageStats **stats = NULL;
-		RSGISCalcImage *calcImg = NULL;
-		RSGISLinearStretchImage *linearStretchImage = NULL;
 		double *imageMax = NULL;
 		double *imageMin = NULL;
 		double *outMax = NULL;
@@ -287,8 +348,7 @@ namespace rsgis { namespace img {
 			{
 				stats[i] = new ImageStats();
 			}
-			calcImageStats = new RSGISImageStatistics();
-			calcImageStats->calcImageStatistics(datasets, 1, stats, numBands, true, this->useNoData, this->inNoData, onePassSD);
+			this->calcStretchStats(datasets, stats, numBands, true);
 			
             std::ofstream outTxtFile;
             if(this->outStats)
@@ -338,11 +398,8 @@ namespace rsgis { namespace img {
 				delete stats[i];
 			}
 			delete[] stats;
-			delete calcImageStats;
 			
-			linearStretchImage = new RSGISLinearStretchImage(numBands, imageMax, imageMin, outMax, outMin, this->useNoData, this->inNoData, this->outNoData);
-			calcImg = new RSGISCalcImage(linearStretchImage, "", true);
-			calcImg->calcImage(datasets, 1, outputImage, false, NULL, imageFormat, outDataType);
+			this->applyLinearStretch(datasets, imageMax, imageMin, outMax, outMin);
 			
 		}
 		catch(RSGISImageCalcException &e)
@@ -367,8 +424,6 @@ namespace rsgis { namespace img {
 		delete[] outMax;
 		delete[] outMin;
 		
-		delete linearStretchImage;
-		delete calcImg;
 		
 		if(datasets != NULL)
 		{
@@ -378,7 +433,100 @@ namespace rsgis { namespace img {
 	
 	void RSGISStretchImage::executeHistogramStretch() 
 	{
-		throw RSGISImageCalcException("Histogram Stretch is not implmented yet\n");
+        // Histogram equalisation: each value is mapped through the cumulative
+        // histogram of its band, which needs (and is only implemented for) an
+        // integer image where there is a bin for every value.
+        int lutMin = 0;
+        unsigned int lutSize = 0;
+        if(!RSGISIntegerLUTImage::getIntegerRange(this->inputImage, &lutMin, &lutSize))
+        {
+            throw RSGISImageCalcException("The histogram stretch is only available for 8 and 16 bit integer images.");
+        }
+        int numBands = this->inputImage->GetRasterCount();
+        
+        std::vector< std::vector<unsigned long long> > hists;
+        RSGISIntegerLUTImage::calcHistograms(this->inputImage, lutMin, lutSize, &hists);
+        
+        long noDataIdx = -1;
+        if(this->useNoData && (this->inNoData == std::floor(this->inNoData)) && (this->inNoData >= lutMin) && (this->inNoData < (((double)lutMin) + lutSize)))
+        {
+            noDataIdx = ((long)this->inNoData) - lutMin;
+        }
+        bool intOutput = (this->outDataType != GDT_Float32) && (this->outDataType != GDT_Float64);
+        
+        std::ofstream outTxtFile;
+        if(this->outStats)
+        {
+            outTxtFile.open(this->outStatsFile.c_str());
+            if(!outTxtFile.is_open())
+            {
+                throw RSGISImageCalcException("Output file for the statistics could not be opened.");
+            }
+            outTxtFile << "#histogram\n";
+            outTxtFile << "#band,img_val,out_val\n";
+        }
+        
+        RSGISIntegerLUTImage lutImage(numBands, lutMin, lutSize);
+        std::vector<double> lut(lutSize, this->outMinVal);
+        double outRange = this->outMaxVal - this->outMinVal;
+        for(int i = 0; i < numBands; i++)
+        {
+            std::vector<unsigned long long> &hist = hists[i];
+            if(noDataIdx >= 0)
+            {
+                hist[noDataIdx] = 0;
+            }
+            unsigned long long total = 0;
+            unsigned long long cdfMin = 0;
+            for(unsigned int j = 0; j < lutSize; ++j)
+            {
+                if((cdfMin == 0) && (hist[j] > 0))
+                {
+                    cdfMin = hist[j];
+                }
+                total += hist[j];
+            }
+            
+            unsigned long long cdf = 0;
+            double outVal = 0;
+            for(unsigned int j = 0; j < lutSize; ++j)
+            {
+                cdf += hist[j];
+                if((cdf <= cdfMin) || (total == cdfMin))
+                {
+                    outVal = this->outMinVal;
+                }
+                else
+                {
+                    outVal = this->outMinVal + ((((double)(cdf - cdfMin)) / ((double)(total - cdfMin))) * outRange);
+                }
+                
+                // As with the linear stretch a valid value is not given the no data value.
+                if(this->useNoData && (intOutput?(std::fabs(outVal - this->outNoData) < 0.5):(outVal == this->outNoData)))
+                {
+                    outVal = (this->outNoData == this->outMaxVal)?(outVal - 1):(outVal + 1);
+                }
+                lut[j] = outVal;
+                
+                if(this->outStats && (hist[j] > 0))
+                {
+                    outTxtFile << i+1 << "," << (((long)lutMin) + j) << "," << outVal << std::endl;
+                }
+            }
+            if(noDataIdx >= 0)
+            {
+                lut[noDataIdx] = this->outNoData;
+            }
+            lutImage.setBandLUT(i, i, lut);
+        }
+        
+        if(this->outStats)
+        {
+            outTxtFile.flush();
+            outTxtFile.close();
+        }
+        
+        lutImage.apply(this->inputImage, this->outputImage, this->imageFormat, this->outDataType);
 	}
 	
 	void RSGISStretchImage::executeExponentialStretch() 
@@ -28,6 +28,7 @@
 #include <fstream>
 #include <math.h>
 #include <float.h>
+#include <vector>
 
 #include "common/RSGISFileException.h"
 
@@ -39,6 +40,8 @@
 #include "img/RSGISImageCalcException.h"
 #include "img/RSGISImageUtils.h"
 #include "img/RSGISImageStatistics.h"
+#include "img/RSGISSinglePassImageStats.h"
+#include "img/RSGISIntegerLUTImage.h"
 
 #include "math/RSGISMathFunction.h"
 #include "math/RSGISMathException.h"
@@ -87,9 +90,28 @@ namespace rsgis { namespace img {
 	{
 	public:
 		RSGISStretchImage(GDALDataset *inputImage, std::string outputImage, bool outStats, std::string outStatsFile, bool onePassSD, std::string imageFormat, GDALDataType outDataType, float outMinVal, float outMaxVal, bool useNoData, double inNoData, double outNoData);
+        /**
+         * Calculate the statistics for the linear stretches from every
+         * sampleStep'th pixel and line (using an overview where the image has
+         * a suitable one) rather than from the whole image. The default of 1
+         * uses all the pixels.
+         */
+        void setStatsSampling(unsigned int sampleStep){this->statsSampleStep = (sampleStep == 0)?1:sampleStep;};
 		void executeLinearMinMaxStretch();
-		void executeLinearPercentStretch(float percent);
+        /**
+         * Stretch between percent % from the top and bottom of the range. By default the
+         * limits are estimated from the mean, min and max; with usePercentiles the
+         * percent and 100-percent percentiles of each band are used.
+         */
+		void executeLinearPercentStretch(float percent, bool usePercentiles=false);
 		void executeLinearStdDevStretch(float stddev);
+        /**
+         * Equalise the histogram of each band, mapping each value through the
+         * cumulative histogram of its band to the output range. Only available
+         * for 8 and 16 bit integer images, for which the mapping is a lookup
+         * table applied in the native data types. The stats file (if written)
+         * lists the output value for each value in the image.
+         */
 		void executeHistogramStretch();
 		void executeExponentialStretch();
 		void executeLogrithmicStretch();
@@ -156,11 +178,14 @@ namespace rsgis { namespace img {
         };
 		~RSGISStretchImage();
 	protected:
+        void calcStretchStats(GDALDataset **datasets, ImageStats **stats, int numBands, bool stddev);
+        void applyLinearStretch(GDALDataset **datasets, double *imageMax, double *imageMin, double *outMax, double *outMin);
 		GDALDataset *inputImage;
         std::string outputImage;
         bool outStats;
         std::string outStatsFile;
         bool onePassSD;
+        unsigned int statsSampleStep;
         std::string imageFormat;
         GDALDataType outDataType;
         float outMinVal;
@@ -175,6 +200,13 @@ namespace rsgis { namespace img {
 	public:
 		RSGISStretchImageWithStats(GDALDataset *inputImage, std::string outputImage, std::string inStatsFile, std::string imageFormat, GDALDataType outDataType, float outMinVal, float outMaxVal, bool useNoData, double inNoData, double outNoData);
 		void executeLinearMinMaxStretch();
+        /**
+         * Equalise the histogram of each band, mapping each value through the
+         * cumulative histogram of its band to the output range. Only available
+         * for 8 and 16 bit integer images, for which the mapping is a lookup
+         * table applied in the native data types. The stats file (if written)
+         * lists the output value for each value in the image.
+         */
 		void executeHistogramStretch();
 		void executeExponentialStretch();
 		void executeLogrithmicStretch();
@@ -304,6 +336,7 @@ namespace rsgis { namespace img {
 		void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageCalcException("No implemented");};
         void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output, geos::geom::Envelope extent) {throw RSGISImageCalcException("No implemented");};
 		bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw RSGISImageCalcException("No implemented");};
+        bool isThreadSafe(){return true;};
 		~RSGISLinearStretchImage();
 	protected:
 		double *imageMax;
@@ -26,10 +26,21 @@
 
 namespace rsgis {namespace math{
     
+    void RSGIS2DInterpolator::getRowValues(double eastings, double northings, double xStep, size_t numVals, float *vals)
+    {
+        for(size_t i = 0; i < numVals; ++i)
+        {
+            vals[i] = this->getValue(eastings + (xStep * i), northings);
+        }
+    }
+    
     
     RSGISSearchKNN2DInterpolator::RSGISSearchKNN2DInterpolator(unsigned int k): RSGIS2DInterpolator()
     {
         this->k = k;
+        this->dataPTS = NULL;
+        this->kdTree = NULL;
+        this->initialised = false;
     }
     
     void RSGISSearchKNN2DInterpolator::initInterpolator(std::vector<RSGISInterpolatorDataPoint> *pts)
@@ -42,59 +53,69 @@ namespace rsgis {namespace math{
             }
             
             this->dataPTS = pts;
+            
+            // Build the index once so each query only visits the points near it.
+            std::vector<double> ptCoords(pts->size()*2);
+            std::vector<double*> ptRows(pts->size());
+            for(size_t i = 0; i < pts->size(); ++i)
+            {
+                ptCoords[(i*2)] = pts->at(i).x;
+                ptCoords[(i*2)+1] = pts->at(i).y;
+                ptRows[i] = &ptCoords[(i*2)];
+            }
+            if(this->kdTree != NULL)
+            {
+                delete this->kdTree;
+            }
+            this->kdTree = new RSGISKNNKDTree(ptRows.data(), pts->size(), 0, 2, rsgis_euclidean);
         }
         catch(RSGISInterpolationException &e)
         {
             throw e;
         }
+        catch(RSGISMathException &e)
+        {
+            throw RSGISInterpolationException(e.what());
+        }
         initialised = true;
     }
     
     
-    std::list<std::pair<double,RSGISInterpolatorDataPoint> >* RSGISSearchKNN2DInterpolator::findKNN(double eastings, double northings)
+    std::list<std::pair<double,RSGISInterpolatorDataPoint> >* RSGISSearchKNN2DInterpolator::findKNN(double eastings, double northings, double maxDist)
     {
-        std::list<std::pair<double,RSGISInterpolatorDataPoint> > *knn = new std::list<std::pair<double,RSGISInterpolatorDataPoint> >();
-        try
+        if(this->kdTree == NULL)
         {
-            double dist = 0.0;
-            for(std::vector<RSGISInterpolatorDataPoint>::iterator iterPts = dataPTS->begin(); iterPts != dataPTS->end(); ++iterPts)
-            {
-                dist = sqrt(pow((eastings-(*iterPts).x),2) + pow((northings-(*iterPts).y),2));
-                
-                if(knn->empty())
-                {
-                    knn->push_back(std::pair<double,RSGISInterpolatorDataPoint>(dist, *iterPts));
-                }
-                else
-                {
-                    for(std::list<std::pair<double,RSGISInterpolatorDataPoint> >::iterator iterK = knn->begin(); iterK != knn->end(); ++iterK)
-                    {
-                        if((*iterK).first > dist)
-                        {
-                            knn->insert(iterK, std::pair<double,RSGISInterpolatorDataPoint>(dist, *iterPts));
-                            break;
-                        }
-                    }
-                }
-
-                if(knn->size() < k)
-                {
-                    knn->push_back(std::pair<double,RSGISInterpolatorDataPoint>(dist, *iterPts));
-                }
-                else if(knn->size() > k)
-                {
-                    knn->pop_back();
-                }
-            }
+            throw RSGISInterpolationException("The interpolator has not been initialised.");
         }
-        catch(RSGISInterpolationException &e)
+        // The tree's euclidean distance is normalised by the number of
+        // dimensions (as RSGISCalcDistMetric), so is scaled by sqrt(2) here.
+        const double distScale = sqrt(2.0);
+        double treeMaxDist = std::numeric_limits<double>::infinity();
+        if(maxDist > 0)
         {
-            delete knn;
-            throw e;
+            treeMaxDist = maxDist / distScale;
+        }
+        
+        double query[2] = {eastings, northings};
+        std::vector<std::pair<double, size_t> > kNearest;
+        this->kdTree->findKNearest(query, this->k, treeMaxDist, &kNearest);
+        
+        std::list<std::pair<double,RSGISInterpolatorDataPoint> > *knn = new std::list<std::pair<double,RSGISInterpolatorDataPoint> >();
+        for(std::vector<std::pair<double, size_t> >::iterator iterK = kNearest.begin(); iterK != kNearest.end(); ++iterK)
+        {
+            knn->push_back(std::pair<double,RSGISInterpolatorDataPoint>((*iterK).first * distScale, dataPTS->at((*iterK).second)));
         }
         return knn;
     }
     
+    RSGISSearchKNN2DInterpolator::~RSGISSearchKNN2DInterpolator()
+    {
+        if(this->kdTree != NULL)
+        {
+            delete this->kdTree;
+        }
+    }
+    
     
     
     void RSGIS2DTriagulatorInterpolator::initInterpolator(std::vector<RSGISInterpolatorDataPoint> *pts)
@@ -152,16 +173,33 @@ namespace rsgis {namespace math{
         initialised = true;
     }
     
+    double RSGIS2DTriagulatorInterpolator::getValue(double eastings, double northings)
+    {
+        Face_handle face;
+        return this->getValueFromFace(CGALPoint(eastings, northings), &face);
+    }
+    
+    void RSGIS2DTriagulatorInterpolator::getRowValues(double eastings, double northings, double xStep, size_t numVals, float *vals)
+    {
+        // Neighbouring pixels are in the same or an adjacent triangle so each
+        // walk starts from where the last one finished.
+        Face_handle face;
+        for(size_t i = 0; i < numVals; ++i)
+        {
+            vals[i] = this->getValueFromFace(CGALPoint(eastings + (xStep * i), northings), &face);
+        }
+    }
+    
     
     
     
-    double RSGISNearestNeighbour2DInterpolator::getValue(double eastings, double northings)
+    double RSGISNearestNeighbour2DInterpolator::getValueFromFace(const CGALPoint &p, Face_handle *face)
     {
         double outValue = std::numeric_limits<double>::signaling_NaN();
 		if(initialised)
 		{
-            CGALPoint p(eastings, northings);
-            Vertex_handle vh = dt->nearest_vertex(p);
+            *face = dt->locate(p, *face);
+            Vertex_handle vh = dt->nearest_vertex(p, *face);
             CGALPoint nearestPt = vh->point();
             PointValueMap::iterator iterVal = values->find(nearestPt);
             outValue = (*iterVal).second;
@@ -176,19 +214,19 @@ namespace rsgis {namespace math{
     
     
     
-    double RSGISNaturalNeighbor2DInterpolator::getValue(double eastings, double northings)
+    double RSGISNaturalNeighbor2DInterpolator::getValueFromFace(const CGALPoint &p, Face_handle *face)
     {
         float outValue = std::numeric_limits<float>::signaling_NaN();
         if(initialised)
         {
             try
             {
-                K::Point_2 p(eastings, northings);
+                *face = dt->locate(p, *face);
                 CoordinateVector coords;
-                CGAL::Triple<std::back_insert_iterator<CoordinateVector>, K::FT, bool> result = CGAL::natural_neighbor_coordinates_2(*dt, p, std::back_inserter(coords));
+                CGAL::Triple<std::back_insert_iterator<CoordinateVector>, K::FT, bool> result = CGAL::natural_neighbor_coordinates_2(*dt, p, std::back_inserter(coords), *face);
                 if(!result.third)
                 {
-                    Vertex_handle vh = dt->nearest_vertex(p);
+                    Vertex_handle vh = dt->nearest_vertex(p, *face);
                     CGALPoint nearestPt = vh->point();
                     PointValueMap::iterator iterVal = values->find(nearestPt);
                     outValue = (*iterVal).second;
@@ -213,16 +251,16 @@ namespace rsgis {namespace math{
     
     
     
-    double RSGISNaturalNearestNeighbor2DInterpolator::getValue(double eastings, double northings)
+    double RSGISNaturalNearestNeighbor2DInterpolator::getValueFromFace(const CGALPoint &p, Face_handle *face)
     {
         float outValue = std::numeric_limits<float>::signaling_NaN();
         if(initialised)
         {
             try
             {
-                K::Point_2 p(eastings, northings);
+                *face = dt->locate(p, *face);
                 CoordinateVector coords;
-                CGAL::Triple<std::back_insert_iterator<CoordinateVector>, K::FT, bool> result = CGAL::natural_neighbor_coordinates_2(*dt, p, std::back_inserter(coords));
+                CGAL::Triple<std::back_insert_iterator<CoordinateVector>, K::FT, bool> result = CGAL::natural_neighbor_coordinates_2(*dt, p, std::back_inserter(coords), *face);
                 if(!result.third)
                 {
                     outValue = std::numeric_limits<float>::signaling_NaN();
@@ -276,6 +314,40 @@ namespace rsgis {namespace math{
     
     
     
+    double RSGISKNearestIDW2DInterpolator::getValue(double eastings, double northings)
+    {
+        float outValue = std::numeric_limits<float>::signaling_NaN();
+        if(initialised)
+        {
+            std::list<std::pair<double,RSGISInterpolatorDataPoint> > *knn = this->findKNN(eastings, northings, this->maxDist);
+            if(!knn->empty())
+            {
+                if(knn->front().first == 0)
+                {
+                    // On a data point.
+                    outValue = knn->front().second.value;
+                }
+                else
+                {
+                    double totalWeight = 0.0;
+                    double totalValue = 0.0;
+                    double weight = 0.0;
+                    for(std::list<std::pair<double,RSGISInterpolatorDataPoint> >::iterator iterK = knn->begin(); iterK != knn->end(); ++iterK)
+                    {
+                        weight = 1 / pow((*iterK).first, (double)this->p);
+                        totalWeight += weight;
+                        totalValue += (*iterK).second.value * weight;
+                    }
+                    outValue = totalValue / totalWeight;
+                }
+            }
+            delete knn;
+        }
+        return outValue;
+    }
+    
+    
+    
     void RSGISAllPointsIDWInterpolator::initInterpolator(std::vector<RSGISInterpolatorDataPoint> *pts)
     {
         this->pts = pts;
@@ -469,6 +541,29 @@ namespace rsgis {namespace math{
         }
     }
     
+    void RSGISCombine2DInterpolators::getRowValues(double eastings, double northings, double xStep, size_t numVals, float *vals)
+    {
+        try
+        {
+            this->interp1->getRowValues(eastings, northings, xStep, numVals, vals);
+            for(size_t i = 0; i < numVals; ++i)
+            {
+                if((vals[i] > upperThres) | (vals[i] < lowerThres))
+                {
+                    vals[i] = this->interp2->getValue(eastings + (xStep * i), northings);
+                }
+            }
+        }
+        catch(std::exception &e)
+        {
+            throw RSGISInterpolationException(e.what());
+        }
+        catch(RSGISInterpolationException &e)
+        {
+            throw e;
+        }
+    }
+    
     double RSGISCombine2DInterpolators::getValue(double eastings, double northings)
     {
         double outVal = 0.0;
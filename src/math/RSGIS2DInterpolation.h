@@ -28,8 +28,11 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
+#include <list>
+#include <limits>
 
 #include "RSGISMathsUtils.h"
+#include "RSGISKNNKDTree.h"
 
 #include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
 #include <CGAL/Delaunay_triangulation_2.h>
@@ -61,6 +64,7 @@ typedef K::Point_2                                    CGALPoint;
 typedef CGAL::Delaunay_triangulation_2<K>             DelaunayTriangulation;
 typedef CGAL::Interpolation_traits_2<K>               InterpTraits;
 typedef CGAL::Delaunay_triangulation_2<K>::Vertex_handle    Vertex_handle;
+typedef CGAL::Delaunay_triangulation_2<K>::Face_handle      Face_handle;
 
 typedef std::vector< std::pair<CGALPoint, CGALCoordType> >   CoordinateVector;
 typedef std::map<CGALPoint, CGALCoordType, K::Less_xy_2>     PointValueMap;
@@ -94,6 +98,17 @@ namespace rsgis {namespace math{
 		RSGIS2DInterpolator(){};
 		virtual void initInterpolator(std::vector<RSGISInterpolatorDataPoint> *pts) = 0;
 		virtual double getValue(double eastings, double northings) = 0;
+        /**
+         * Whether getValue can be called from several threads at once once the
+         * interpolator has been initialised.
+         */
+        virtual bool isThreadSafe(){return false;};
+        /**
+         * The values of numVals locations along a row, starting at (eastings,
+         * northings) and xStep apart. Interpolators which can start the search
+         * for a location from that of the previous one override this.
+         */
+        virtual void getRowValues(double eastings, double northings, double xStep, size_t numVals, float *vals);
 		virtual ~RSGIS2DInterpolator(){};
 	protected:
 		bool initialised;
@@ -105,21 +120,40 @@ namespace rsgis {namespace math{
 		RSGISSearchKNN2DInterpolator(unsigned int k);
 		virtual void initInterpolator(std::vector<RSGISInterpolatorDataPoint> *pts);
         virtual double getValue(double eastings, double northings) = 0;
-		virtual ~RSGISSearchKNN2DInterpolator(){};
+        virtual bool isThreadSafe(){return true;};
+		virtual ~RSGISSearchKNN2DInterpolator();
 	protected:
-        virtual std::list<std::pair<double,RSGISInterpolatorDataPoint> >* findKNN(double eastings, double northings);
+        /**
+         * The (up to) k points nearest to the location, nearest first, within
+         * maxDist (when greater than 0), found with a KD-tree of the points.
+         */
+        virtual std::list<std::pair<double,RSGISInterpolatorDataPoint> >* findKNN(double eastings, double northings, double maxDist=0);
 		unsigned int k;
         std::vector<RSGISInterpolatorDataPoint> *dataPTS;
+        RSGISKNNKDTree *kdTree;
 	};
     
+    /**
+     * Interpolators using a Delaunay triangulation of the points, built once
+     * by initInterpolator and only read afterwards so values can be found
+     * from several threads at once. Along a row the triangle containing each
+     * location is found by walking from the previous location's triangle.
+     */
     class DllExport RSGIS2DTriagulatorInterpolator: public RSGIS2DInterpolator
 	{
 	public:
 		RSGIS2DTriagulatorInterpolator():RSGIS2DInterpolator(){};
 		virtual void initInterpolator(std::vector<RSGISInterpolatorDataPoint> *pts);
-		virtual double getValue(double eastings, double northings) = 0;
+		virtual double getValue(double eastings, double northings);
+        virtual void getRowValues(double eastings, double northings, double xStep, size_t numVals, float *vals);
+        virtual bool isThreadSafe(){return true;};
 		virtual ~RSGIS2DTriagulatorInterpolator(){};
 	protected:
+        /**
+         * The value at p, with face the triangle to start the search from
+         * (or a null handle) which is updated to the one containing p.
+         */
+        virtual double getValueFromFace(const CGALPoint &p, Face_handle *face) = 0;
 		DelaunayTriangulation *dt;
         PointValueMap *values;
 	};
@@ -128,24 +162,27 @@ namespace rsgis {namespace math{
 	{
 	public:
 		RSGISNearestNeighbour2DInterpolator():RSGIS2DTriagulatorInterpolator(){};
-		double getValue(double eastings, double northings);
 		~RSGISNearestNeighbour2DInterpolator(){};
+    protected:
+        double getValueFromFace(const CGALPoint &p, Face_handle *face);
 	};
     
     class DllExport RSGISNaturalNeighbor2DInterpolator :public RSGIS2DTriagulatorInterpolator
 	{
 	public:
 		RSGISNaturalNeighbor2DInterpolator():RSGIS2DTriagulatorInterpolator(){};
-		double getValue(double eastings, double northings);
 		~RSGISNaturalNeighbor2DInterpolator(){};
+    protected:
+        double getValueFromFace(const CGALPoint &p, Face_handle *face);
 	};
     
     class DllExport RSGISNaturalNearestNeighbor2DInterpolator :public RSGIS2DTriagulatorInterpolator
 	{
 	public:
 		RSGISNaturalNearestNeighbor2DInterpolator():RSGIS2DTriagulatorInterpolator(){};
-		double getValue(double eastings, double northings);
 		~RSGISNaturalNearestNeighbor2DInterpolator(){};
+    protected:
+        double getValueFromFace(const CGALPoint &p, Face_handle *face);
 	};
     
     
@@ -157,6 +194,23 @@ namespace rsgis {namespace math{
 		~RSGISKNearestNeighbour2DInterpolator(){};
 	};
     
+    /**
+     * Inverse distance weighting using only the k nearest points which are
+     * within maxDist (if greater than 0) of the location, rather than every
+     * point as with RSGISAllPointsIDWInterpolator. Locations with no points
+     * within maxDist are given a value of NaN.
+     */
+    class DllExport RSGISKNearestIDW2DInterpolator : public RSGISSearchKNN2DInterpolator
+	{
+	public:
+		RSGISKNearestIDW2DInterpolator(unsigned int k, float p, double maxDist=0):RSGISSearchKNN2DInterpolator(k){this->p = p; this->maxDist = maxDist;};
+		double getValue(double eastings, double northings);
+		~RSGISKNearestIDW2DInterpolator(){};
+    protected:
+        float p;
+        double maxDist;
+	};
+    
     
     class DllExport RSGISAllPointsIDWInterpolator : public RSGIS2DInterpolator
 	{
@@ -164,6 +218,7 @@ namespace rsgis {namespace math{
 		RSGISAllPointsIDWInterpolator(float p):RSGIS2DInterpolator(){this->p = p;};
         void initInterpolator(std::vector<RSGISInterpolatorDataPoint> *pts);
 		double getValue(double eastings, double northings);
+        bool isThreadSafe(){return true;};
 		~RSGISAllPointsIDWInterpolator(){};
     protected:
         std::vector<RSGISInterpolatorDataPoint> *pts;
@@ -176,6 +231,7 @@ namespace rsgis {namespace math{
 		RSGISLinearTrendInterpolator():RSGIS2DInterpolator(){};
         void initInterpolator(std::vector<RSGISInterpolatorDataPoint> *pts);
 		double getValue(double eastings, double northings);
+        bool isThreadSafe(){return true;};
 		~RSGISLinearTrendInterpolator(){};
     protected:
         double a;
@@ -194,6 +250,8 @@ namespace rsgis {namespace math{
         };
         void initInterpolator(std::vector<RSGISInterpolatorDataPoint> *pts);
 		double getValue(double eastings, double northings);
+        bool isThreadSafe(){return (this->interp1->isThreadSafe() && this->interp2->isThreadSafe());};
+        void getRowValues(double eastings, double northings, double xStep, size_t numVals, float *vals);
 		~RSGISCombine2DInterpolators()
         {
             delete interp1;
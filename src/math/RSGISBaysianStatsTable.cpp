@@ -0,0 +1,135 @@
+/*
+ *  RSGISBaysianStatsTable.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISBaysianStatsTable.h"
+
+namespace rsgis{namespace math{
+	
+	RSGISBaysianStatsTable::RSGISBaysianStatsTable(RSGISBaysianStatsFunc calcStats, double tableMin, double tableMax, double tolerance, unsigned int maxPoints)
+	{
+		if(!(tableMax > tableMin))
+		{
+			throw RSGISBaysianStatsException("The maximum of the table must be greater than the minimum.");
+		}
+		if(!(tolerance > 0))
+		{
+			throw RSGISBaysianStatsException("The tolerance of the table must be greater than 0.");
+		}
+		this->tableMin = tableMin;
+		this->tableMax = tableMax;
+		this->numPoints = 257;
+		this->step = (tableMax - tableMin) / (numPoints - 1);
+		this->table.resize(numPoints * 3);
+		for(unsigned int i = 0; i < numPoints; ++i)
+		{
+			this->calcPoint(calcStats, tableMin + (i * step), &table[i*3]);
+		}
+		
+		std::vector<double> midTable;
+		std::vector<double> newTable;
+		double midVals[3];
+		while(true)
+		{
+			// Integrate at the midpoints and compare with the interpolated values.
+			midTable.resize((numPoints - 1) * 3);
+			this->maxError = 0;
+			for(unsigned int i = 0; i < (numPoints - 1); ++i)
+			{
+				this->calcPoint(calcStats, tableMin + ((i + 0.5) * step), &midTable[i*3]);
+				for(unsigned int n = 0; n < 3; ++n)
+				{
+					midVals[n] = (table[(i*3)+n] + table[((i+1)*3)+n]) / 2;
+					double error = fabs(midVals[n] - midTable[(i*3)+n]);
+					if(error > this->maxError)
+					{
+						this->maxError = error;
+					}
+				}
+			}
+			if((this->maxError <= tolerance) || (((2 * numPoints) - 1) > maxPoints))
+			{
+				break;
+			}
+			
+			// Add the midpoints to the table.
+			newTable.resize(((2 * numPoints) - 1) * 3);
+			for(unsigned int i = 0; i < numPoints; ++i)
+			{
+				for(unsigned int n = 0; n < 3; ++n)
+				{
+					newTable[((2*i)*3)+n] = table[(i*3)+n];
+					if(i < (numPoints - 1))
+					{
+						newTable[(((2*i)+1)*3)+n] = midTable[(i*3)+n];
+					}
+				}
+			}
+			table.swap(newTable);
+			numPoints = (2 * numPoints) - 1;
+			step = step / 2;
+		}
+		if(this->maxError > tolerance)
+		{
+			std::cerr << "WARNING: The Bayesian table is only within " << this->maxError << " of the integrated values using " << numPoints << " points.\n";
+		}
+	}
+	
+	void RSGISBaysianStatsTable::calcPoint(RSGISBaysianStatsFunc &calcStats, double value, double *output)
+	{
+		double *outVals = calcStats(value);
+		for(unsigned int n = 0; n < 3; ++n)
+		{
+			output[n] = outVals[n];
+		}
+		delete[] outVals;
+	}
+	
+	void RSGISBaysianStatsTable::getValues(float value, double *output) const
+	{
+		if(value != value)
+		{
+			output[0] = NAN;
+			output[1] = NAN;
+			output[2] = NAN;
+			return;
+		}
+		double pos = (value - tableMin) / step;
+		if(pos <= 0)
+		{
+			std::copy(table.begin(), table.begin() + 3, output);
+			return;
+		}
+		if(pos >= (numPoints - 1))
+		{
+			std::copy(table.end() - 3, table.end(), output);
+			return;
+		}
+		unsigned int idx = (unsigned int)pos;
+		double frac = pos - idx;
+		const double *lower = &table[idx*3];
+		const double *upper = &table[(idx+1)*3];
+		for(unsigned int n = 0; n < 3; ++n)
+		{
+			output[n] = lower[n] + ((upper[n] - lower[n]) * frac);
+		}
+	}
+	
+}}
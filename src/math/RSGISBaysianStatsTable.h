@@ -0,0 +1,93 @@
+/*
+ *  RSGISBaysianStatsTable.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISBaysianStatsTable_H
+#define RSGISBaysianStatsTable_H
+
+#include <iostream>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <math.h>
+
+#include "math/RSGISBaysianStatsException.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_maths_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis
+{
+	namespace math
+	{
+		/**
+		 * The Bayesian estimate for an input value, returned as a new
+		 * double[3] (value, lower, upper) as RSGISBaysianStatsPrior::calcImageValuePrior
+		 * and RSGISBaysianStatsNoPrior::calcImageValueNoPrior.
+		 */
+		typedef std::function<double*(float)> RSGISBaysianStatsFunc;
+		
+		/**
+		 * A table of the Bayesian estimate (value, lower and upper) on a
+		 * regular grid of the input value between tableMin and tableMax, which
+		 * is linearly interpolated in place of integrating the probability
+		 * functions for every input value.
+		 *
+		 * The grid starts with 257 values and is doubled (the new values being
+		 * the midpoints, where the interpolation is least accurate) until the
+		 * interpolated midpoints are all within tolerance of the integrated
+		 * values or maxPoints is reached (getMaxError gives the error of the
+		 * last check). Input values outside the table take the value at its
+		 * nearest end, NaN gives NaN.
+		 *
+		 * Once built, getValues does not change the table so it can be called
+		 * from any number of threads.
+		 */
+		class DllExport RSGISBaysianStatsTable
+			{
+			public:
+				RSGISBaysianStatsTable(RSGISBaysianStatsFunc calcStats, double tableMin, double tableMax, double tolerance, unsigned int maxPoints=1048577);
+				void getValues(float value, double *output) const;
+				unsigned int getNumPoints() const {return numPoints;};
+				double getMaxError() const {return maxError;};
+				~RSGISBaysianStatsTable(){};
+			protected:
+				void calcPoint(RSGISBaysianStatsFunc &calcStats, double value, double *output);
+				double tableMin;
+				double tableMax;
+				double step;
+				unsigned int numPoints;
+				double maxError;
+				std::vector<double> table;
+			};
+	}
+}
+
+#endif
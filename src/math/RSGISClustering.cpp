@@ -25,99 +25,246 @@
 
 namespace rsgis {namespace math{
 
-    void RSGISClusterer::calcDataRanges(std::vector< std::vector<float> > *input, unsigned int numFeatures, float *min, float *max)
+    RSGISNearestClusterCentre::RSGISNearestClusterCentre(std::vector< RSGISClusterCentre > *clusterCentres)
     {
-        bool first = true;
-        std::vector< std::vector<float> >::iterator iterFeatures;
-        for(iterFeatures = input->begin(); iterFeatures != input->end(); ++iterFeatures)
+        this->numCentres = clusterCentres->size();
+        this->numFeatures = (this->numCentres > 0)?clusterCentres->at(0).centre.size():0;
+        this->centres.resize(((size_t)this->numCentres)*this->numFeatures);
+        for(unsigned int c = 0; c < this->numCentres; ++c)
         {
-            if(first)
+            for(unsigned int f = 0; f < this->numFeatures; ++f)
+            {
+                this->centres[(((size_t)f)*this->numCentres)+c] = clusterCentres->at(c).centre[f];
+            }
+        }
+    }
+    
+    RSGISNearestClusterCentre::RSGISNearestClusterCentre(const double *centres, unsigned int numCentres, unsigned int numFeatures)
+    {
+        this->numCentres = numCentres;
+        this->numFeatures = numFeatures;
+        this->centres.assign(centres, centres+(((size_t)numCentres)*numFeatures));
+    }
+    
+    unsigned int RSGISNearestClusterCentre::findNearest(const float *vals, float *distScratch) const
+    {
+        const unsigned int nCentres = this->numCentres;
+        if(nCentres == 0)
+        {
+            return 0;
+        }
+        for(unsigned int c = 0; c < nCentres; ++c)
+        {
+            distScratch[c] = 0;
+        }
+        for(unsigned int f = 0; f < this->numFeatures; ++f)
+        {
+            const float val = vals[f];
+            const float *fCentres = &this->centres[((size_t)f)*nCentres];
+            for(unsigned int c = 0; c < nCentres; ++c)
+            {
+                const float diff = val - fCentres[c];
+                distScratch[c] += diff * diff;
+            }
+        }
+        
+        // Squared distances have the same order so no sqrt is needed; the first of equal distances is used.
+        unsigned int nearest = 0;
+        float minDist = distScratch[0];
+        for(unsigned int c = 1; c < nCentres; ++c)
+        {
+            if(distScratch[c] < minDist)
+            {
+                minDist = distScratch[c];
+                nearest = c;
+            }
+        }
+        return nearest;
+    }
+    
+    void RSGISNearestClusterCentre::findNearest(const float* const* featPlanes, size_t nPts, unsigned int *nearest) const
+    {
+        std::vector<float> vals(this->numFeatures);
+        std::vector<float> distScratch(this->numCentres);
+        for(size_t i = 0; i < nPts; ++i)
+        {
+            for(unsigned int f = 0; f < this->numFeatures; ++f)
+            {
+                vals[f] = featPlanes[f][i];
+            }
+            nearest[i] = this->findNearest(vals.data(), distScratch.data());
+        }
+    }
+    
+    RSGISNearestClusterCentre::~RSGISNearestClusterCentre()
+    {
+        
+    }
+    
+    
+    RSGISClusterer::RSGISClusterer()
+    {
+        this->minCentreShift = 0;
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+    
+    void RSGISClusterer::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+    
+    void RSGISClusterer::processInThreads(size_t nItems, std::function<void(size_t, size_t)> func)
+    {
+        this->processRangesInThreads(nItems, [&func](size_t, size_t start, size_t end)
+        {
+            func(start, end);
+        });
+    }
+    
+    size_t RSGISClusterer::getNumThreadRanges(size_t nItems)
+    {
+        size_t nThreads = std::min<size_t>(this->numThreads, nItems);
+        if(nThreads <= 1)
+        {
+            return 1;
+        }
+        size_t itemsPerThread = (nItems + nThreads - 1) / nThreads;
+        return (nItems + itemsPerThread - 1) / itemsPerThread;
+    }
+    
+    void RSGISClusterer::processRangesInThreads(size_t nItems, std::function<void(size_t, size_t, size_t)> func)
+    {
+        size_t nThreads = std::min<size_t>(this->numThreads, nItems);
+        if(nThreads <= 1)
+        {
+            func(0, 0, nItems);
+            return;
+        }
+        
+        // The items are split into a fixed range for each thread.
+        size_t itemsPerThread = (nItems + nThreads - 1) / nThreads;
+        size_t numRanges = this->getNumThreadRanges(nItems);
+        rsgis::utils::parallelFor(numRanges, nThreads, [&func, itemsPerThread, nItems](size_t t, unsigned int)
+        {
+            size_t start = t * itemsPerThread;
+            func(t, start, std::min(start + itemsPerThread, nItems));
+        });
+    }
+
+    bool RSGISClusterer::centresConverged(const std::vector<float> &centreShifts)
+    {
+        for(std::vector<float>::const_iterator iterShift = centreShifts.begin(); iterShift != centreShifts.end(); ++iterShift)
+        {
+            if((*iterShift) > this->minCentreShift)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector< RSGISClusterCentre >* RSGISClusterer::calcClusterCentres(std::vector< std::vector<float> > *input, unsigned int numFeatures, unsigned int numClusters, unsigned int maxNumIterations, float degreeOfChange)
+    {
+        std::vector<float> data(input->size() * numFeatures);
+        for(size_t i = 0; i < input->size(); ++i)
+        {
+            if((*input)[i].size() < numFeatures)
+            {
+                throw RSGISClustererException("The input data has fewer values than the number of features.");
+            }
+            std::copy((*input)[i].begin(), (*input)[i].begin() + numFeatures, &data[i*numFeatures]);
+        }
+        return this->calcClusterCentres(data.data(), input->size(), numFeatures, numClusters, maxNumIterations, degreeOfChange);
+    }
+
+    void RSGISClusterer::calcDataRanges(const float *data, size_t numVals, unsigned int numFeatures, float *min, float *max)
+    {
+        for(size_t n = 0; n < numVals; ++n)
+        {
+            const float *vals = &data[n*numFeatures];
+            if(n == 0)
             {
                 for(unsigned int i = 0; i < numFeatures; ++i)
                 {
-                    min[i] = (*iterFeatures)[i];
-                    max[i] = (*iterFeatures)[i];
+                    min[i] = vals[i];
+                    max[i] = vals[i];
                 }
-                first = false;
             }
             else
             {
                 for(unsigned int i = 0; i < numFeatures; ++i)
                 {
-                    if((*iterFeatures)[i] < min[i])
+                    if(vals[i] < min[i])
                     {
-                         min[i] = (*iterFeatures)[i];
+                         min[i] = vals[i];
                     }
-                    else if((*iterFeatures)[i] > max[i])
+                    else if(vals[i] > max[i])
                     {
-                        max[i] = (*iterFeatures)[i];
+                        max[i] = vals[i];
                     }
                 }
             }
         }
     }
     
-    void RSGISClusterer::calcDataStats(std::vector< std::vector<float> > *input, unsigned int numFeatures, float *min, float *max, float *mean, float *stddev)
+    void RSGISClusterer::calcDataStats(const float *data, size_t numVals, unsigned int numFeatures, float *min, float *max, float *mean, float *stddev)
     {
-        bool first = true;
-        std::vector< std::vector<float> >::iterator iterFeatures;
-        for(iterFeatures = input->begin(); iterFeatures != input->end(); ++iterFeatures)
+        for(size_t n = 0; n < numVals; ++n)
         {
-            if(first)
+            const float *vals = &data[n*numFeatures];
+            if(n == 0)
             {
                 for(unsigned int i = 0; i < numFeatures; ++i)
                 {
-                    min[i] = (*iterFeatures)[i];
-                    max[i] = (*iterFeatures)[i];
-                    mean[i] = (*iterFeatures)[i];
+                    min[i] = vals[i];
+                    max[i] = vals[i];
+                    mean[i] = vals[i];
                 }
-                first = false;
             }
             else
             {
                 for(unsigned int i = 0; i < numFeatures; ++i)
                 {
-                    if((*iterFeatures)[i] < min[i])
+                    if(vals[i] < min[i])
                     {
-                        min[i] = (*iterFeatures)[i];
+                        min[i] = vals[i];
                     }
-                    else if((*iterFeatures)[i] > max[i])
+                    else if(vals[i] > max[i])
                     {
-                        max[i] = (*iterFeatures)[i];
+                        max[i] = vals[i];
                     }
-                    mean[i] += (*iterFeatures)[i];
+                    mean[i] += vals[i];
                 }
             }
         }
         
         for(unsigned int i = 0; i < numFeatures; ++i)
         {
-            mean[i] = mean[i]/input->size();
+            mean[i] = mean[i]/numVals;
         }
         
-        first = true;
-        for(iterFeatures = input->begin(); iterFeatures != input->end(); ++iterFeatures)
+        for(size_t n = 0; n < numVals; ++n)
         {
-            if(first)
+            const float *vals = &data[n*numFeatures];
+            if(n == 0)
             {
                 for(unsigned int i = 0; i < numFeatures; ++i)
                 {
-                    stddev[i] = (((*iterFeatures)[i] - mean[i]) * ((*iterFeatures)[i] - mean[i]));
+                    stddev[i] = ((vals[i] - mean[i]) * (vals[i] - mean[i]));
                 }
-                first = false;
             }
             else
             {
                 for(unsigned int i = 0; i < numFeatures; ++i)
                 {
-                    stddev[i] += (((*iterFeatures)[i] - mean[i]) * ((*iterFeatures)[i] - mean[i]));
+                    stddev[i] += ((vals[i] - mean[i]) * (vals[i] - mean[i]));
                 }
             }
         }
         
         for(unsigned int i = 0; i < numFeatures; ++i)
         {
-            stddev[i] = sqrt(stddev[i]/input->size());
+            stddev[i] = sqrt(stddev[i]/numVals);
         }
         
     }
@@ -159,7 +306,7 @@ namespace rsgis {namespace math{
         return clusterCentres;
     }
     
-    std::vector< RSGISClusterCentre >* RSGISClusterer::initializeClusterCentresRandom(std::vector< std::vector<float> > *input, unsigned int numFeatures, unsigned int numClusters)
+    std::vector< RSGISClusterCentre >* RSGISClusterer::initializeClusterCentresRandom(const float *data, size_t numVals, unsigned int numFeatures, unsigned int numClusters)
     {
         std::vector< RSGISClusterCentre > *clusterCentres = new std::vector< RSGISClusterCentre >();
         clusterCentres->reserve(numClusters);
@@ -167,7 +314,6 @@ namespace rsgis {namespace math{
         RSGISPsudoRandDistroUniformDouble probDist(0, 1);
         
         unsigned int sampleIndex = 0;
-        size_t numVals = input->size(); 
         
         if(numVals < numClusters)
         {
@@ -203,7 +349,7 @@ namespace rsgis {namespace math{
                     sameSeed = true;
                     for(unsigned int j = 0; j < numFeatures; ++j)
                     {
-                        if(input->at(*iterIdxs)[j] != input->at(sampleIndex)[j])
+                        if(data[((*iterIdxs)*numFeatures)+j] != data[(((size_t)sampleIndex)*numFeatures)+j])
                         {
                             sameSeed = false;
                         }
@@ -224,7 +370,7 @@ namespace rsgis {namespace math{
                 }
             }
             
-            std::vector<float> sample = input->at(sampleIndex);
+            const float *sample = &data[((size_t)sampleIndex)*numFeatures];
             
             for(unsigned int j = 0; j < numFeatures; ++j)
             {
@@ -401,7 +547,7 @@ namespace rsgis {namespace math{
         return clusterCentres;
     }
     
-    std::vector< RSGISClusterCentre >* RSGISClusterer::initializeClusterCentresDiagonal(std::vector< std::vector<float> > *input, unsigned int numFeatures, float *min, float *max, unsigned int numClusters)
+    std::vector< RSGISClusterCentre >* RSGISClusterer::initializeClusterCentresDiagonal(const float *data, size_t numVals, unsigned int numFeatures, float *min, float *max, unsigned int numClusters)
     {
         std::vector< RSGISClusterCentre > *clusterCentres = new std::vector< RSGISClusterCentre >();
         clusterCentres->reserve(numClusters);
@@ -430,7 +576,7 @@ namespace rsgis {namespace math{
                     cCentre.stdDev.push_back(0);
                 }
 
-                this->assign2ClosestDataPoint(&cCentre, input, numFeatures, clusterCentres);
+                this->assign2ClosestDataPoint(&cCentre, data, numVals, numFeatures, clusterCentres);
                 clusterCentres->push_back(cCentre);
             }
             
@@ -444,7 +590,7 @@ namespace rsgis {namespace math{
         return clusterCentres;
     }
     
-    std::vector< RSGISClusterCentre >* RSGISClusterer::initializeClusterCentresDiagonal(std::vector< std::vector<float> > *input, unsigned int numFeatures, float *min, float *max, float *mean, float *stddev, unsigned int numClusters)
+    std::vector< RSGISClusterCentre >* RSGISClusterer::initializeClusterCentresDiagonal(const float *data, size_t numVals, unsigned int numFeatures, float *min, float *max, float *mean, float *stddev, unsigned int numClusters)
     {
         std::vector< RSGISClusterCentre > *clusterCentres = new std::vector< RSGISClusterCentre >();
         clusterCentres->reserve(numClusters);
@@ -506,7 +652,7 @@ namespace rsgis {namespace math{
                 cCentreMin.centre.push_back(max[j]);
                 cCentreMin.stdDev.push_back(0);
             }
-            this->assign2ClosestDataPoint(&cCentreMin, input, numFeatures, clusterCentres);
+            this->assign2ClosestDataPoint(&cCentreMin, data, numVals, numFeatures, clusterCentres);
             clusterCentres->push_back(cCentreMin);
             
             RSGISClusterCentre cCentreMinMid;
@@ -518,7 +664,7 @@ namespace rsgis {namespace math{
                 cCentreMinMid.centre.push_back(min[j] + ((m2StdDev[j]-min[j])/2));
                 cCentreMinMid.stdDev.push_back(0);
             }
-            this->assign2ClosestDataPoint(&cCentreMinMid, input, numFeatures, clusterCentres);
+            this->assign2ClosestDataPoint(&cCentreMinMid, data, numVals, numFeatures, clusterCentres);
             clusterCentres->push_back(cCentreMinMid);
         }        
         
@@ -535,7 +681,7 @@ namespace rsgis {namespace math{
                 cCentre.centre.push_back(value);
                 cCentre.stdDev.push_back(0);
             }
-            this->assign2ClosestDataPoint(&cCentre, input, numFeatures, clusterCentres);
+            this->assign2ClosestDataPoint(&cCentre, data, numVals, numFeatures, clusterCentres);
             clusterCentres->push_back(cCentre);
         }
         
@@ -550,7 +696,7 @@ namespace rsgis {namespace math{
                 cCentreMaxMid.centre.push_back(p2StdDev[j] + ((max[j]-p2StdDev[j])/2));
                 cCentreMaxMid.stdDev.push_back(0);
             }
-            this->assign2ClosestDataPoint(&cCentreMaxMid, input, numFeatures, clusterCentres);
+            this->assign2ClosestDataPoint(&cCentreMaxMid, data, numVals, numFeatures, clusterCentres);
             clusterCentres->push_back(cCentreMaxMid);
             
             RSGISClusterCentre cCentreMax;
@@ -562,7 +708,7 @@ namespace rsgis {namespace math{
                 cCentreMax.centre.push_back(max[j]);
                 cCentreMax.stdDev.push_back(0);
             }
-            this->assign2ClosestDataPoint(&cCentreMax, input, numFeatures, clusterCentres);
+            this->assign2ClosestDataPoint(&cCentreMax, data, numVals, numFeatures, clusterCentres);
             clusterCentres->push_back(cCentreMax);            
         }
         
@@ -574,157 +720,464 @@ namespace rsgis {namespace math{
         return clusterCentres;
     }
         
-    std::vector< RSGISClusterCentre >* RSGISClusterer::initializeClusterCentresKPP(std::vector< std::vector<float> > *input, unsigned int numFeatures, float *min, float *max, unsigned int numClusters)
+    std::vector< RSGISClusterCentre >* RSGISClusterer::initializeClusterCentresKPP(const float *data, size_t numVals, unsigned int numFeatures, float *min, float *max, unsigned int numClusters)
     {
-        throw RSGISClustererException("initializeClusterCentresKPP is not implemented.");
-        return NULL;
-    }
+        if(numVals < numClusters)
+        {
+            throw RSGISClustererException("There are fewer data points than clusters requested.");
+        }
         
-    std::vector< std::pair< unsigned int, std::vector<float> > >* RSGISClusterer::createClusterDataInitClusterIDs(std::vector< std::vector<float> > *input, std::vector< RSGISClusterCentre > *clusterCentres)
-    {
-        float dist = 0;
-        float minDist = 0;
-        unsigned int clusterID = 0;
+        std::vector< RSGISClusterCentre > *clusterCentres = new std::vector< RSGISClusterCentre >();
+        if(numClusters == 0)
+        {
+            return clusterCentres;
+        }
+        clusterCentres->reserve(numClusters);
+        
+        const unsigned int numRounds = 5;
+        const double overSample = 2.0 * numClusters;
         
-        std::vector< std::pair< unsigned int, std::vector<float> > > *clusterData = new std::vector< std::pair< unsigned int, std::vector<float> > >();
-        for(std::vector< std::vector<float> >::iterator iterInData = input->begin(); iterInData != input->end(); ++iterInData)
+        std::mt19937 rng(numVals);
+        std::uniform_int_distribution<size_t> idxDist(0, numVals-1);
+        // Each point is accepted by a uniform hashed from its index and the
+        // round, so the candidates are the same however the points are split.
+        const uint64_t seed = rng();
+        auto pointUniform = [seed](size_t idx, unsigned int round)
         {
-            dist = 0;
-            minDist = 0;
-            clusterID = 0;
+            uint64_t z = seed + ((((uint64_t)round) << 48) ^ ((uint64_t)idx)) * 0x9E3779B97F4A7C15ULL;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            z = z ^ (z >> 31);
+            return double(z >> 11) * (1.0 / 9007199254740992.0);
+        };
+        auto sqDist = [numFeatures](const float *d1, const float *d2)
+        {
+            float dist = 0;
+            for(unsigned int j = 0; j < numFeatures; ++j)
+            {
+                float diff = d1[j] - d2[j];
+                dist += diff * diff;
+            }
+            return dist;
+        };
+        
+        std::vector<size_t> candIdxs;
+        candIdxs.push_back(idxDist(rng));
+        // The squared distance from each point to the nearest candidate.
+        std::vector<float> minDists(numVals, std::numeric_limits<float>::max());
+        size_t numCandsDone = 0;
+        std::mutex mergeMutex;
+        for(unsigned int r = 0; r <= numRounds; ++r)
+        {
+            // Only the candidates added in the last round need to be checked.
+            const size_t firstCand = numCandsDone;
+            const size_t lastCand = candIdxs.size();
+            // Each range's cost is added in range order so the sum is the
+            // same whichever thread finishes first.
+            std::vector<double> rangeCosts(this->getNumThreadRanges(numVals), 0.0);
+            this->processRangesInThreads(numVals, [&](size_t range, size_t start, size_t end)
+            {
+                double rangeCost = 0;
+                for(size_t i = start; i < end; ++i)
+                {
+                    const float *pt = &data[i*numFeatures];
+                    float minDist = minDists[i];
+                    for(size_t c = firstCand; c < lastCand; ++c)
+                    {
+                        minDist = std::min(minDist, sqDist(pt, &data[candIdxs[c]*numFeatures]));
+                    }
+                    minDists[i] = minDist;
+                    rangeCost += minDist;
+                }
+                rangeCosts[range] = rangeCost;
+            });
+            double cost = 0;
+            for(size_t range = 0; range < rangeCosts.size(); ++range)
+            {
+                cost += rangeCosts[range];
+            }
+            numCandsDone = lastCand;
             
-            for(unsigned int i = 0; i < clusterCentres->size(); ++i)
+            if((r == numRounds) || (cost <= 0))
             {
-                dist = 0;
-                for(unsigned int j = 0; j < clusterCentres->at(i).centre.size(); ++j)
+                break;
+            }
+            
+            std::vector<size_t> newIdxs;
+            this->processInThreads(numVals, [&](size_t start, size_t end)
+            {
+                std::vector<size_t> rangeIdxs;
+                for(size_t i = start; i < end; ++i)
                 {
-                    dist += ((*iterInData)[j] - clusterCentres->at(i).centre[j]) * ((*iterInData)[j] - clusterCentres->at(i).centre[j]); 
+                    if((minDists[i] > 0) && (pointUniform(i, r) < ((overSample * minDists[i]) / cost)))
+                    {
+                        rangeIdxs.push_back(i);
+                    }
                 }
-                
-                dist = sqrt(dist);
-                
-                if(i == 0)
+                std::lock_guard<std::mutex> lock(mergeMutex);
+                newIdxs.insert(newIdxs.end(), rangeIdxs.begin(), rangeIdxs.end());
+            });
+            std::sort(newIdxs.begin(), newIdxs.end());
+            candIdxs.insert(candIdxs.end(), newIdxs.begin(), newIdxs.end());
+        }
+        std::vector<float>().swap(minDists);
+        
+        // Weight each candidate by the number of points nearest to it.
+        const size_t numCands = candIdxs.size();
+        std::vector<RSGISClusterCentre> candCentres(numCands);
+        for(size_t c = 0; c < numCands; ++c)
+        {
+            candCentres[c].centre.assign(&data[candIdxs[c]*numFeatures], &data[(candIdxs[c]+1)*numFeatures]);
+        }
+        RSGISNearestClusterCentre nearestCand(&candCentres);
+        std::vector<double> candWeights(numCands, 0);
+        this->processInThreads(numVals, [&](size_t start, size_t end)
+        {
+            std::vector<size_t> rangeCounts(numCands, 0);
+            std::vector<float> distScratch(numCands);
+            for(size_t i = start; i < end; ++i)
+            {
+                ++rangeCounts[nearestCand.findNearest(&data[i*numFeatures], distScratch.data())];
+            }
+            std::lock_guard<std::mutex> lock(mergeMutex);
+            for(size_t c = 0; c < numCands; ++c)
+            {
+                candWeights[c] += rangeCounts[c];
+            }
+        });
+        
+        // Weighted k-means++ over the candidates.
+        std::vector<size_t> chosen;
+        std::vector<bool> candUsed(numCands, false);
+        std::vector<double> candDists(numCands, std::numeric_limits<double>::max());
+        std::uniform_real_distribution<double> uniDist(0.0, 1.0);
+        size_t lastChosen = 0;
+        for(unsigned int k = 0; k < numClusters; ++k)
+        {
+            double total = 0;
+            for(size_t c = 0; c < numCands; ++c)
+            {
+                if(k > 0)
                 {
-                    minDist = dist;
-                    clusterID = i;
+                    candDists[c] = std::min<double>(candDists[c], sqDist(&data[candIdxs[c]*numFeatures], &data[candIdxs[lastChosen]*numFeatures]));
                 }
-                else if(dist < minDist)
+                if(!candUsed[c])
                 {
-                    minDist = dist;
-                    clusterID = i;
+                    total += candWeights[c] * ((k > 0)?candDists[c]:1.0);
                 }
             }
-            
-            ++clusterCentres->at(clusterID).numPxl;
-            clusterData->push_back(std::pair< unsigned int, std::vector<float> >(clusterID, *iterInData));
+            if(total <= 0)
+            {
+                // Fewer distinct candidates than clusters.
+                break;
+            }
+            double target = uniDist(rng) * total;
+            size_t pick = numCands;
+            double cumulative = 0;
+            for(size_t c = 0; c < numCands; ++c)
+            {
+                if(candUsed[c])
+                {
+                    continue;
+                }
+                double weight = candWeights[c] * ((k > 0)?candDists[c]:1.0);
+                if(weight <= 0)
+                {
+                    continue;
+                }
+                pick = c;
+                cumulative += weight;
+                if(cumulative >= target)
+                {
+                    break;
+                }
+            }
+            candUsed[pick] = true;
+            chosen.push_back(candIdxs[pick]);
+            lastChosen = pick;
+        }
+        
+        // Make up any remaining centres with random points.
+        while(chosen.size() < numClusters)
+        {
+            chosen.push_back(idxDist(rng));
+        }
+        
+        for(std::vector<size_t>::iterator iterIdx = chosen.begin(); iterIdx != chosen.end(); ++iterIdx)
+        {
+            RSGISClusterCentre cCentre;
+            cCentre.numPxl = 0;
+            const float *sample = &data[(*iterIdx)*numFeatures];
+            for(unsigned int j = 0; j < numFeatures; ++j)
+            {
+                cCentre.centre.push_back(sample[j]);
+                cCentre.stdDev.push_back(0);
+            }
+            clusterCentres->push_back(cCentre);
         }
         
-        return clusterData;
+        return clusterCentres;
     }
-    
-    unsigned int RSGISClusterer::reassignClusterIDs( std::vector< std::pair< unsigned int, std::vector<float> > > *clusterData, std::vector< RSGISClusterCentre > *clusterCentres)
+        
+    unsigned int RSGISClusterer::reassignClusterIDs(const float *data, size_t numVals, std::vector< RSGISClusterCentre > *clusterCentres, unsigned int *clusterIDs, const std::vector<float> *centreShifts)
     {
-        unsigned int nChange = 0;
-        float dist = 0;
-        float minDist = 0;
-        unsigned int clusterID = 0;
+        if(clusterCentres->empty())
+        {
+            throw RSGISClustererException("There are no cluster centres to assign the data to.");
+        }
         
-        for(std::vector< std::pair< unsigned int, std::vector<float> > >::iterator iterData = clusterData->begin(); iterData != clusterData->end(); ++iterData)
+        const unsigned int numCentres = clusterCentres->size();
+        const unsigned int numFeatures = clusterCentres->at(0).centre.size();
+        std::vector<float> centres(((size_t)numCentres)*numFeatures);
+        for(unsigned int c = 0; c < numCentres; ++c)
         {
-            dist = 0;
-            minDist = 0;
-            clusterID = 0;
-            
-            for(unsigned int i = 0; i < clusterCentres->size(); ++i)
+            std::copy(clusterCentres->at(c).centre.begin(), clusterCentres->at(c).centre.end(), &centres[((size_t)c)*numFeatures]);
+        }
+        
+        // The bounds can only be used if they are from the previous assignment
+        // to these centres, which have moved by centreShifts since.
+        bool useBounds = (centreShifts != NULL) && (centreShifts->size() == numCentres) && (this->upperBounds.size() == numVals) && (this->lowerBounds.size() == numVals);
+        if(!useBounds)
+        {
+            this->upperBounds.assign(numVals, 0);
+            this->lowerBounds.assign(numVals, 0);
+        }
+        
+        // Half the distance from each centre to the nearest other centre; a point
+        // within that of its centre cannot be nearer to another centre.
+        std::vector<float> halfCentreDists(numCentres, std::numeric_limits<float>::max());
+        float maxShift = 0;
+        if(useBounds)
+        {
+            for(unsigned int c = 0; c < numCentres; ++c)
             {
-                dist = 0;
-                for(unsigned int j = 0; j < clusterCentres->at(i).centre.size(); ++j)
+                for(unsigned int c2 = c+1; c2 < numCentres; ++c2)
                 {
-                    dist += ((*iterData).second[j] - clusterCentres->at(i).centre[j]) * ((*iterData).second[j] - clusterCentres->at(i).centre[j]); 
+                    float dist = 0;
+                    for(unsigned int f = 0; f < numFeatures; ++f)
+                    {
+                        float diff = centres[(((size_t)c)*numFeatures)+f] - centres[(((size_t)c2)*numFeatures)+f];
+                        dist += diff * diff;
+                    }
+                    dist = sqrt(dist)/2;
+                    halfCentreDists[c] = std::min(halfCentreDists[c], dist);
+                    halfCentreDists[c2] = std::min(halfCentreDists[c2], dist);
+                }
+                maxShift = std::max(maxShift, (*centreShifts)[c]);
+            }
+        }
+        
+        std::atomic<unsigned int> nChange(0);
+        this->processInThreads(numVals, [&](size_t start, size_t end)
+        {
+            // A small margin so rounding in the bounds cannot skip a point which
+            // is (within rounding) as near to another centre.
+            const float boundMargin = 1.0001f;
+            unsigned int nRangeChange = 0;
+            for(size_t i = start; i < end; ++i)
+            {
+                const float *vals = &data[i*numFeatures];
+                unsigned int clusterID = clusterIDs[i];
+                if(useBounds)
+                {
+                    float upper = this->upperBounds[i] + (*centreShifts)[clusterID];
+                    float lower = this->lowerBounds[i] - maxShift;
+                    float bound = std::max(halfCentreDists[clusterID], lower);
+                    if((upper * boundMargin) < bound)
+                    {
+                        this->upperBounds[i] = upper;
+                        this->lowerBounds[i] = lower;
+                        continue;
+                    }
+                    const float *cVals = &centres[((size_t)clusterID)*numFeatures];
+                    upper = 0;
+                    for(unsigned int f = 0; f < numFeatures; ++f)
+                    {
+                        float diff = vals[f] - cVals[f];
+                        upper += diff * diff;
+                    }
+                    upper = sqrt(upper);
+                    if((upper * boundMargin) < bound)
+                    {
+                        this->upperBounds[i] = upper;
+                        this->lowerBounds[i] = lower;
+                        continue;
+                    }
                 }
                 
-                dist = sqrt(dist);
-                
-                if(i == 0)
+                // Compare with every centre, keeping the nearest (the first of
+                // equal distances) and the second nearest.
+                unsigned int nearest = 0;
+                float minDist = std::numeric_limits<float>::max();
+                float secondDist = std::numeric_limits<float>::max();
+                for(unsigned int c = 0; c < numCentres; ++c)
                 {
-                    minDist = dist;
-                    clusterID = i;
+                    const float *cVals = &centres[((size_t)c)*numFeatures];
+                    float dist = 0;
+                    for(unsigned int f = 0; f < numFeatures; ++f)
+                    {
+                        float diff = vals[f] - cVals[f];
+                        dist += diff * diff;
+                    }
+                    if(dist < minDist)
+                    {
+                        secondDist = minDist;
+                        minDist = dist;
+                        nearest = c;
+                    }
+                    else if(dist < secondDist)
+                    {
+                        secondDist = dist;
+                    }
                 }
-                else if(dist < minDist)
+                this->upperBounds[i] = sqrt(minDist);
+                this->lowerBounds[i] = (numCentres > 1)?sqrt(secondDist):std::numeric_limits<float>::max();
+                
+                if(nearest != clusterID)
                 {
-                    minDist = dist;
-                    clusterID = i;
+                    clusterIDs[i] = nearest;
+                    ++nRangeChange;
                 }
             }
-            
-            if(clusterID != (*iterData).first)
-            {
-                (*iterData).first = clusterID;
-                ++nChange;
-            }
-        }
+            nChange += nRangeChange;
+        });
         
         return nChange;
     }
     
-    void RSGISClusterer::recalcClusterCentres( std::vector< std::pair< unsigned int, std::vector<float> > > *clusterData, std::vector< RSGISClusterCentre > *clusterCentres, bool calcStdDev)
+    void RSGISClusterer::recalcClusterCentres(const float *data, size_t numVals, unsigned int *clusterIDs, std::vector< RSGISClusterCentre > *clusterCentres, bool calcStdDev, std::vector<float> *centreShifts)
     {
-        for(std::vector< RSGISClusterCentre >::iterator iterClusters = clusterCentres->begin(); iterClusters != clusterCentres->end(); ++iterClusters)
+        const unsigned int numCentres = clusterCentres->size();
+        if(numCentres == 0)
         {
-            for(unsigned int i = 0; i < (*iterClusters).centre.size(); ++i)
-            {
-                (*iterClusters).centre[i] = 0;
-                (*iterClusters).stdDev[i] = 0;
-            }
-            (*iterClusters).numPxl = 0;
+            throw RSGISClustererException("There are no cluster centres to recalculate.");
         }
+        const unsigned int numFeatures = clusterCentres->at(0).centre.size();
+        const size_t numSums = ((size_t)numCentres)*numFeatures;
         
-        for(std::vector< std::pair< unsigned int, std::vector<float> > >::iterator iterData = clusterData->begin(); iterData != clusterData->end(); ++iterData)
+        // Each range sums its points, the ranges then being added in range
+        // order (not the order the threads finish) so the centres are the
+        // same every run.
+        const size_t numRanges = this->getNumThreadRanges(numVals);
+        std::vector< std::vector<double> > rangeSums(numRanges, std::vector<double>(numSums, 0.0));
+        std::vector< std::vector<size_t> > rangeCounts(numRanges, std::vector<size_t>(numCentres, 0));
+        this->processRangesInThreads(numVals, [&](size_t range, size_t start, size_t end)
         {
-            ++clusterCentres->at((*iterData).first).numPxl;
-            for(unsigned int i = 0; i < (*iterData).second.size(); ++i)
+            std::vector<double> &rSums = rangeSums[range];
+            std::vector<size_t> &rCounts = rangeCounts[range];
+            for(size_t i = start; i < end; ++i)
             {
-                clusterCentres->at((*iterData).first).centre[i] += (*iterData).second[i];
+                const float *vals = &data[i*numFeatures];
+                double *cSums = &rSums[((size_t)clusterIDs[i])*numFeatures];
+                ++rCounts[clusterIDs[i]];
+                for(unsigned int f = 0; f < numFeatures; ++f)
+                {
+                    cSums[f] += vals[f];
+                }
+            }
+        });
+        std::vector<double> sums(numSums, 0.0);
+        std::vector<size_t> counts(numCentres, 0);
+        for(size_t range = 0; range < numRanges; ++range)
+        {
+            for(size_t n = 0; n < numSums; ++n)
+            {
+                sums[n] += rangeSums[range][n];
+            }
+            for(unsigned int c = 0; c < numCentres; ++c)
+            {
+                counts[c] += rangeCounts[range][c];
             }
         }
-
-        for(std::vector< RSGISClusterCentre >::iterator iterClusters = clusterCentres->begin(); iterClusters != clusterCentres->end(); )
+        std::vector< std::vector<double> >().swap(rangeSums);
+        
+        // Find the new centres, removing those without any points.
+        std::vector<unsigned int> newIdxs(numCentres, 0);
+        if(centreShifts != NULL)
         {
-            if((*iterClusters).numPxl == 0)
+            centreShifts->clear();
+        }
+        unsigned int numKept = 0;
+        for(unsigned int c = 0; c < numCentres; ++c)
+        {
+            if(counts[c] == 0)
             {
-                iterClusters = clusterCentres->erase(iterClusters);
+                continue;
             }
-            else
+            RSGISClusterCentre *cc = &clusterCentres->at(c);
+            float shift = 0;
+            for(unsigned int f = 0; f < numFeatures; ++f)
             {
-                for(unsigned int i = 0; i < (*iterClusters).centre.size(); ++i)
-                {
-                    (*iterClusters).centre[i] = (*iterClusters).centre[i]/(*iterClusters).numPxl;
-                }
-                ++iterClusters;
+                float value = sums[(((size_t)c)*numFeatures)+f]/counts[c];
+                shift += (value - cc->centre[f]) * (value - cc->centre[f]);
+                cc->centre[f] = value;
+                cc->stdDev[f] = 0;
+            }
+            cc->numPxl = counts[c];
+            if(centreShifts != NULL)
+            {
+                centreShifts->push_back(sqrt(shift));
+            }
+            newIdxs[c] = numKept;
+            if(numKept != c)
+            {
+                clusterCentres->at(numKept) = *cc;
+            }
+            ++numKept;
+        }
+        if(numKept != numCentres)
+        {
+            clusterCentres->resize(numKept);
+            for(size_t i = 0; i < numVals; ++i)
+            {
+                clusterIDs[i] = newIdxs[clusterIDs[i]];
             }
         }
         
         if(calcStdDev)
         {
-            for(std::vector< std::pair< unsigned int, std::vector<float> > >::iterator iterData = clusterData->begin(); iterData != clusterData->end(); ++iterData)
+            const size_t numKeptSums = ((size_t)numKept)*numFeatures;
+            std::vector<float> centres(numKeptSums);
+            for(unsigned int c = 0; c < numKept; ++c)
             {
-                for(unsigned int i = 0; i < (*iterData).second.size(); ++i)
+                std::copy(clusterCentres->at(c).centre.begin(), clusterCentres->at(c).centre.end(), &centres[((size_t)c)*numFeatures]);
+            }
+            std::vector< std::vector<double> > rangeSqSums(numRanges, std::vector<double>(numKeptSums, 0.0));
+            this->processRangesInThreads(numVals, [&](size_t range, size_t start, size_t end)
+            {
+                std::vector<double> &rSqSums = rangeSqSums[range];
+                for(size_t i = start; i < end; ++i)
                 {
-                    clusterCentres->at((*iterData).first).stdDev[i] += (clusterCentres->at((*iterData).first).centre[i] - (*iterData).second[i])*(clusterCentres->at((*iterData).first).centre[i] - (*iterData).second[i]);
+                    const float *vals = &data[i*numFeatures];
+                    const float *cVals = &centres[((size_t)clusterIDs[i])*numFeatures];
+                    double *cSqSums = &rSqSums[((size_t)clusterIDs[i])*numFeatures];
+                    for(unsigned int f = 0; f < numFeatures; ++f)
+                    {
+                        cSqSums[f] += (cVals[f] - vals[f]) * (cVals[f] - vals[f]);
+                    }
+                }
+            });
+            std::vector<double> sqSums(numKeptSums, 0.0);
+            for(size_t range = 0; range < numRanges; ++range)
+            {
+                for(size_t n = 0; n < numKeptSums; ++n)
+                {
+                    sqSums[n] += rangeSqSums[range][n];
                 }
             }
             
-            for(std::vector< RSGISClusterCentre >::iterator iterClusters = clusterCentres->begin(); iterClusters != clusterCentres->end(); ++iterClusters)
+            for(unsigned int c = 0; c < numKept; ++c)
             {
-                for(unsigned int i = 0; i < (*iterClusters).stdDev.size(); ++i)
+                RSGISClusterCentre *cc = &clusterCentres->at(c);
+                for(unsigned int f = 0; f < numFeatures; ++f)
                 {
-                    (*iterClusters).stdDev[i] = sqrt((*iterClusters).stdDev[i]/(*iterClusters).numPxl);
+                    cc->stdDev[f] = sqrt(sqSums[(((size_t)c)*numFeatures)+f]/cc->numPxl);
                 }
             }
         }
     }
     
-    void RSGISClusterer::assign2ClosestDataPoint(RSGISClusterCentre *cc, std::vector< std::vector<float> > *input, unsigned int numFeatures, std::vector< RSGISClusterCentre > *used)
+    void RSGISClusterer::assign2ClosestDataPoint(RSGISClusterCentre *cc, const float *data, size_t numVals, unsigned int numFeatures, std::vector< RSGISClusterCentre > *used)
     {
         bool first = true;
         bool alreadyUsed = 0;
@@ -738,8 +1191,9 @@ namespace rsgis {namespace math{
         }
         try 
         {
-            for(std::vector< std::vector<float> >::iterator iterData = input->begin(); iterData != input->end(); ++iterData)
+            for(size_t n = 0; n < numVals; ++n)
             {
+                const float *vals = &data[n*numFeatures];
                 if(first)
                 {
                     if(used->size() > 0)
@@ -749,7 +1203,7 @@ namespace rsgis {namespace math{
                             alreadyUsed = true;
                             for(unsigned int i = 0; i < numFeatures; ++i)
                             {
-                                if((*iterData)[i] != (*iterCC).centre[i])
+                                if(vals[i] != (*iterCC).centre[i])
                                 {
                                     alreadyUsed = false;
                                 }
@@ -767,17 +1221,17 @@ namespace rsgis {namespace math{
                     
                     if(!alreadyUsed)
                     {
-                        minDist = this->calcEucDistance(cc->centre, (*iterData));
+                        minDist = this->calcEucDistance(cc->centre.data(), vals, numFeatures);
                         for(unsigned int i = 0; i < numFeatures; ++i)
                         {
-                            cClosest[i] = (*iterData)[i];
+                            cClosest[i] = vals[i];
                         }
                         first = false;
                     }
                 }
                 else
                 {
-                    dist = this->calcEucDistance(cc->centre, (*iterData));
+                    dist = this->calcEucDistance(cc->centre.data(), vals, numFeatures);
                     
                     if(dist < minDist)
                     {
@@ -788,7 +1242,7 @@ namespace rsgis {namespace math{
                                 alreadyUsed = true;
                                 for(unsigned int i = 0; i < numFeatures; ++i)
                                 {
-                                    if((*iterData)[i] != (*iterCC).centre[i])
+                                    if(vals[i] != (*iterCC).centre[i])
                                     {
                                         alreadyUsed = false;
                                     }
@@ -809,7 +1263,7 @@ namespace rsgis {namespace math{
                             minDist = dist;
                             for(unsigned int i = 0; i < numFeatures; ++i)
                             {
-                                cClosest[i] = (*iterData)[i];
+                                cClosest[i] = vals[i];
                             }
                         }
                     }
@@ -837,12 +1291,13 @@ namespace rsgis {namespace math{
     
 
 
-    RSGISKMeansClusterer::RSGISKMeansClusterer(InitClustererMethods initCentres)
+    RSGISKMeansClusterer::RSGISKMeansClusterer(InitClustererMethods initCentres, unsigned int miniBatchSize)
     {
         this->initCentres = initCentres;
+        this->miniBatchSize = miniBatchSize;
     }
         
-    std::vector< RSGISClusterCentre >* RSGISKMeansClusterer::calcClusterCentres(std::vector< std::vector<float> > *input, unsigned int numFeatures, unsigned int numClusters, unsigned int maxNumIterations, float degreeOfChange)
+    std::vector< RSGISClusterCentre >* RSGISKMeansClusterer::calcClusterCentres(const float *data, size_t numVals, unsigned int numFeatures, unsigned int numClusters, unsigned int maxNumIterations, float degreeOfChange)
     {
         std::vector< RSGISClusterCentre > *clusterCentres = NULL;
         try 
@@ -852,13 +1307,13 @@ namespace rsgis {namespace math{
                        
             if(this->initCentres == init_random)
             {
-                //this->calcDataRanges(input, numFeatures, minVals, maxVals);
+                //this->calcDataRanges(data, numVals, numFeatures, minVals, maxVals);
                 //clusterCentres = this->initializeClusterCentresRandom(numFeatures, minVals, maxVals, numClusters);
-                clusterCentres = this->initializeClusterCentresRandom(input, numFeatures, numClusters);
+                clusterCentres = this->initializeClusterCentresRandom(data, numVals, numFeatures, numClusters);
             }
             else if(this->initCentres == init_diagonal_full)
             {
-                this->calcDataRanges(input, numFeatures, minVals, maxVals);
+                this->calcDataRanges(data, numVals, numFeatures, minVals, maxVals);
                 clusterCentres = this->initializeClusterCentresDiagonal(numFeatures, minVals, maxVals, numClusters);
             }
             else if(this->initCentres == init_diagonal_stddev)
@@ -866,7 +1321,7 @@ namespace rsgis {namespace math{
                 float *meanVals = new float[numFeatures];
                 float *stddevVals = new float[numFeatures];
                 
-                this->calcDataStats(input, numFeatures, minVals, maxVals, meanVals, stddevVals);
+                this->calcDataStats(data, numVals, numFeatures, minVals, maxVals, meanVals, stddevVals);
                 clusterCentres = this->initializeClusterCentresDiagonal(numFeatures, minVals, maxVals, meanVals, stddevVals, numClusters);
                 
                 delete[] meanVals;
@@ -874,24 +1329,24 @@ namespace rsgis {namespace math{
             }
             else if(this->initCentres == init_diagonal_full_attach)
             {
-                this->calcDataRanges(input, numFeatures, minVals, maxVals);
-                clusterCentres = this->initializeClusterCentresDiagonal(input, numFeatures, minVals, maxVals, numClusters);
+                this->calcDataRanges(data, numVals, numFeatures, minVals, maxVals);
+                clusterCentres = this->initializeClusterCentresDiagonal(data, numVals, numFeatures, minVals, maxVals, numClusters);
             }
             else if(this->initCentres == init_diagonal_stddev_attach)
             {
                 float *meanVals = new float[numFeatures];
                 float *stddevVals = new float[numFeatures];
                 
-                this->calcDataStats(input, numFeatures, minVals, maxVals, meanVals, stddevVals);
-                clusterCentres = this->initializeClusterCentresDiagonal(input, numFeatures, minVals, maxVals, meanVals, stddevVals, numClusters);
+                this->calcDataStats(data, numVals, numFeatures, minVals, maxVals, meanVals, stddevVals);
+                clusterCentres = this->initializeClusterCentresDiagonal(data, numVals, numFeatures, minVals, maxVals, meanVals, stddevVals, numClusters);
                 
                 delete[] meanVals;
                 delete[] stddevVals;
             }
             else if(this->initCentres == init_kpp)
             {
-                this->calcDataRanges(input, numFeatures, minVals, maxVals);
-                clusterCentres = this->initializeClusterCentresKPP(input, numFeatures, minVals, maxVals, numClusters);
+                this->calcDataRanges(data, numVals, numFeatures, minVals, maxVals);
+                clusterCentres = this->initializeClusterCentresKPP(data, numVals, numFeatures, minVals, maxVals, numClusters);
             }
             else
             {
@@ -901,7 +1356,15 @@ namespace rsgis {namespace math{
             delete[] minVals;
             delete[] maxVals;
             
-            std::vector< std::pair< unsigned int, std::vector<float> > > *clusterData = this->createClusterDataInitClusterIDs(input, clusterCentres);
+            if((this->miniBatchSize > 0) && (this->miniBatchSize < numVals))
+            {
+                this->miniBatchClusterCentres(data, numVals, clusterCentres, maxNumIterations, degreeOfChange);
+                return clusterCentres;
+            }
+            
+            std::vector<unsigned int> clusterIDs(numVals, std::numeric_limits<unsigned int>::max());
+            std::vector<float> centreShifts;
+            this->reassignClusterIDs(data, numVals, clusterCentres, clusterIDs.data());
             
             unsigned int nIter = 0;
             unsigned int nChange = 0;
@@ -913,11 +1376,17 @@ namespace rsgis {namespace math{
             {
                 contProcess = false;
                 
-                this->recalcClusterCentres(clusterData, clusterCentres, false);
+                this->recalcClusterCentres(data, numVals, clusterIDs.data(), clusterCentres, false, &centreShifts);
+                
+                if(this->centresConverged(centreShifts))
+                {
+                    std::cout << "Iteration " << nIter << " the cluster centres have converged (" << clusterCentres->size() << " clusters).\n";
+                    break;
+                }
                 
-                nChange = this->reassignClusterIDs(clusterData, clusterCentres);
+                nChange = this->reassignClusterIDs(data, numVals, clusterCentres, clusterIDs.data(), &centreShifts);
                 
-                amountOfChange = ((float)nChange)/clusterData->size();
+                amountOfChange = ((float)nChange)/numVals;
                 
                 std::cout << "Iteration " << nIter << " has change " << amountOfChange*100 << " % of data clump IDs (" << clusterCentres->size() << " clusters).\n";
                 
@@ -936,6 +1405,116 @@ namespace rsgis {namespace math{
         return clusterCentres;
     }
     
+    void RSGISKMeansClusterer::miniBatchClusterCentres(const float *data, size_t numVals, std::vector< RSGISClusterCentre > *clusterCentres, unsigned int maxNumIterations, float degreeOfChange)
+    {
+        if(clusterCentres->empty())
+        {
+            throw RSGISClustererException("There are no cluster centres to assign the data to.");
+        }
+        
+        size_t batchSize = this->miniBatchSize;
+        unsigned int numFeatures = clusterCentres->at(0).centre.size();
+        // The number of points used to update each centre so far; the learning rate is its inverse.
+        std::vector<size_t> centreCounts(clusterCentres->size(), 0);
+        std::vector<size_t> batchIdxs(batchSize);
+        std::vector<unsigned int> batchIDs(batchSize);
+        std::vector<unsigned int> updatedIDs(batchSize);
+        
+        // A fixed seed so the centres are reproducible.
+        std::mt19937 rng(numVals);
+        std::uniform_int_distribution<size_t> idxDist(0, numVals-1);
+        
+        auto assignBatch = [this, data, numFeatures, clusterCentres, &batchIdxs](std::vector<unsigned int> *ids)
+        {
+            RSGISNearestClusterCentre nearestCentre(clusterCentres);
+            this->processInThreads(batchIdxs.size(), [data, numFeatures, &nearestCentre, &batchIdxs, ids](size_t start, size_t end)
+            {
+                std::vector<float> distScratch(nearestCentre.getNumCentres());
+                for(size_t i = start; i < end; ++i)
+                {
+                    (*ids)[i] = nearestCentre.findNearest(&data[batchIdxs[i]*numFeatures], distScratch.data());
+                }
+            });
+        };
+        
+        unsigned int nIter = 0;
+        float amountOfChange = 0;
+        std::cout << "Starting Mini-Batch Iterative processing (batch size " << batchSize << ")...\n";
+        bool contProcess = true;
+        while(contProcess)
+        {
+            contProcess = false;
+            
+            for(size_t i = 0; i < batchSize; ++i)
+            {
+                batchIdxs[i] = idxDist(rng);
+            }
+            assignBatch(&batchIDs);
+            
+            for(size_t i = 0; i < batchSize; ++i)
+            {
+                RSGISClusterCentre *cc = &clusterCentres->at(batchIDs[i]);
+                const float *pxl = &data[batchIdxs[i]*numFeatures];
+                float learnRate = 1.0f / (++centreCounts[batchIDs[i]]);
+                for(unsigned int j = 0; j < numFeatures; ++j)
+                {
+                    cc->centre[j] += learnRate * (pxl[j] - cc->centre[j]);
+                }
+            }
+            
+            // The change is the proportion of the batch assigned to a different centre after the update.
+            assignBatch(&updatedIDs);
+            size_t nChange = 0;
+            for(size_t i = 0; i < batchSize; ++i)
+            {
+                if(updatedIDs[i] != batchIDs[i])
+                {
+                    ++nChange;
+                }
+            }
+            amountOfChange = ((float)nChange)/batchSize;
+            
+            std::cout << "Iteration " << nIter << " has change " << amountOfChange*100 << " % of batch clump IDs (" << clusterCentres->size() << " clusters).\n";
+            
+            if((nIter < maxNumIterations) && (amountOfChange > degreeOfChange))
+            {
+                contProcess = true;
+            }
+            ++nIter;
+        }
+        
+        // Assign all the data to find the number of pixels in each cluster and remove those which are empty.
+        RSGISNearestClusterCentre nearestCentre(clusterCentres);
+        std::vector<unsigned int> clusterIDs(numVals);
+        this->processInThreads(numVals, [data, numFeatures, &nearestCentre, &clusterIDs](size_t start, size_t end)
+        {
+            std::vector<float> distScratch(nearestCentre.getNumCentres());
+            for(size_t i = start; i < end; ++i)
+            {
+                clusterIDs[i] = nearestCentre.findNearest(&data[i*numFeatures], distScratch.data());
+            }
+        });
+        for(std::vector< RSGISClusterCentre >::iterator iterClusters = clusterCentres->begin(); iterClusters != clusterCentres->end(); ++iterClusters)
+        {
+            (*iterClusters).numPxl = 0;
+        }
+        for(size_t i = 0; i < numVals; ++i)
+        {
+            ++clusterCentres->at(clusterIDs[i]).numPxl;
+        }
+        for(std::vector< RSGISClusterCentre >::iterator iterClusters = clusterCentres->begin(); iterClusters != clusterCentres->end(); )
+        {
+            if((*iterClusters).numPxl == 0)
+            {
+                iterClusters = clusterCentres->erase(iterClusters);
+            }
+            else
+            {
+                ++iterClusters;
+            }
+        }
+    }
+    
     RSGISKMeansClusterer::~RSGISKMeansClusterer()
     {
         
@@ -957,7 +1536,7 @@ namespace rsgis {namespace math{
         this->endIteration = endIteration;
     }
     
-    std::vector< RSGISClusterCentre >* RSGISISODataClusterer::calcClusterCentres(std::vector< std::vector<float> > *input, unsigned int numFeatures, unsigned int numClusters, unsigned int maxNumIterations, float degreeOfChange)
+    std::vector< RSGISClusterCentre >* RSGISISODataClusterer::calcClusterCentres(const float *data, size_t numVals, unsigned int numFeatures, unsigned int numClusters, unsigned int maxNumIterations, float degreeOfChange)
     {
         std::vector< RSGISClusterCentre > *clusterCentres = NULL;
         try 
@@ -967,13 +1546,13 @@ namespace rsgis {namespace math{
             
             if(this->initCentres == init_random)
             {
-                //this->calcDataRanges(input, numFeatures, minVals, maxVals);
+                //this->calcDataRanges(data, numVals, numFeatures, minVals, maxVals);
                 //clusterCentres = this->initializeClusterCentresRandom(numFeatures, minVals, maxVals, numClusters);
-                clusterCentres = this->initializeClusterCentresRandom(input, numFeatures, numClusters);
+                clusterCentres = this->initializeClusterCentresRandom(data, numVals, numFeatures, numClusters);
             }
             else if(this->initCentres == init_diagonal_full)
             {
-                this->calcDataRanges(input, numFeatures, minVals, maxVals);
+                this->calcDataRanges(data, numVals, numFeatures, minVals, maxVals);
                 clusterCentres = this->initializeClusterCentresDiagonal(numFeatures, minVals, maxVals, numClusters);
             }
             else if(this->initCentres == init_diagonal_stddev)
@@ -981,7 +1560,7 @@ namespace rsgis {namespace math{
                 float *meanVals = new float[numFeatures];
                 float *stddevVals = new float[numFeatures];
                 
-                this->calcDataStats(input, numFeatures, minVals, maxVals, meanVals, stddevVals);
+                this->calcDataStats(data, numVals, numFeatures, minVals, maxVals, meanVals, stddevVals);
                 clusterCentres = this->initializeClusterCentresDiagonal(numFeatures, minVals, maxVals, numClusters);
                 
                 delete[] meanVals;
@@ -989,24 +1568,24 @@ namespace rsgis {namespace math{
             }
             else if(this->initCentres == init_diagonal_full_attach)
             {
-                this->calcDataRanges(input, numFeatures, minVals, maxVals);
-                clusterCentres = this->initializeClusterCentresDiagonal(input, numFeatures, minVals, maxVals, numClusters);
+                this->calcDataRanges(data, numVals, numFeatures, minVals, maxVals);
+                clusterCentres = this->initializeClusterCentresDiagonal(data, numVals, numFeatures, minVals, maxVals, numClusters);
             }
             else if(this->initCentres == init_diagonal_stddev_attach)
             {
                 float *meanVals = new float[numFeatures];
                 float *stddevVals = new float[numFeatures];
                 
-                this->calcDataStats(input, numFeatures, minVals, maxVals, meanVals, stddevVals);
-                clusterCentres = this->initializeClusterCentresDiagonal(input, numFeatures, minVals, maxVals, meanVals, stddevVals, numClusters);
+                this->calcDataStats(data, numVals, numFeatures, minVals, maxVals, meanVals, stddevVals);
+                clusterCentres = this->initializeClusterCentresDiagonal(data, numVals, numFeatures, minVals, maxVals, meanVals, stddevVals, numClusters);
                 
                 delete[] meanVals;
                 delete[] stddevVals;
             }
             else if(this->initCentres == init_kpp)
             {
-                this->calcDataRanges(input, numFeatures, minVals, maxVals);
-                clusterCentres = this->initializeClusterCentresKPP(input, numFeatures, minVals, maxVals, numClusters);
+                this->calcDataRanges(data, numVals, numFeatures, minVals, maxVals);
+                clusterCentres = this->initializeClusterCentresKPP(data, numVals, numFeatures, minVals, maxVals, numClusters);
             }
             else
             {
@@ -1016,7 +1595,9 @@ namespace rsgis {namespace math{
             delete[] minVals;
             delete[] maxVals;
             
-            std::vector< std::pair< unsigned int, std::vector<float> > > *clusterData = this->createClusterDataInitClusterIDs(input, clusterCentres);
+            std::vector<unsigned int> clusterIDs(numVals, std::numeric_limits<unsigned int>::max());
+            std::vector<float> centreShifts;
+            this->reassignClusterIDs(data, numVals, clusterCentres, clusterIDs.data());
             
             unsigned int nIter = 0;
             unsigned int nChange = 0;
@@ -1028,16 +1609,27 @@ namespace rsgis {namespace math{
             {
                 contProcess = false;
                 
-                this->recalcClusterCentres(clusterData, clusterCentres, true);
+                this->recalcClusterCentres(data, numVals, clusterIDs.data(), clusterCentres, true, &centreShifts);
                 
-                if((nIter > this->startIteration) & (nIter < this->endIteration))
+                bool addRemove = (nIter > this->startIteration) & (nIter < this->endIteration);
+                if((!addRemove) && this->centresConverged(centreShifts))
                 {
-                    this->addRemoveClusters(clusterCentres);
-                }                
+                    std::cout << "Iteration " << nIter << " the cluster centres have converged (" << clusterCentres->size() << " clusters).\n";
+                    break;
+                }
                 
-                nChange = this->reassignClusterIDs(clusterData, clusterCentres);
+                if(addRemove)
+                {
+                    // The centres no longer match the shifts so all are checked.
+                    this->addRemoveClusters(clusterCentres);
+                    nChange = this->reassignClusterIDs(data, numVals, clusterCentres, clusterIDs.data());
+                }
+                else
+                {
+                    nChange = this->reassignClusterIDs(data, numVals, clusterCentres, clusterIDs.data(), &centreShifts);
+                }
                 
-                amountOfChange = ((float)nChange)/clusterData->size();
+                amountOfChange = ((float)nChange)/numVals;
                 
                 std::cout << "Iteration " << nIter << " has change " << amountOfChange*100 << " % of data clump IDs for " << clusterCentres->size() << " cluster centres.\n";
                 
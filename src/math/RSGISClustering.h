@@ -26,13 +26,24 @@
 #include <iostream>
 #include <math.h>
 #include <vector>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <limits>
+#include <exception>
+#include <functional>
+#include <cstdint>
+#include <random>
+#include <stdlib.h>
 
 #include "math/RSGISProbabilityDistributions.h"
 #include "math/RSGISRandomDistro.h"
 #include "math/RSGISClustererException.h"
+#include "common/RSGISParallel.h"
 
 // mark all exported classes/functions with DllExport to have
-// them exported by Visual Studio
+// them exported by Visual Studio
 #undef DllExport
 #ifdef _MSC_VER
     #ifdef rsgis_maths_EXPORTS
@@ -53,35 +64,128 @@ namespace rsgis {namespace math{
         std::vector<float> stdDev;
     };
     
+    /**
+     * Finds the nearest (euclidean) cluster centre to points. The centres are
+     * held feature-major so the distances to all the centres are accumulated
+     * together in a loop over the centres which can be vectorised. Queries do
+     * not modify the object so it can be shared between threads.
+     */
+    class DllExport RSGISNearestClusterCentre
+    {
+    public:
+        RSGISNearestClusterCentre(std::vector< RSGISClusterCentre > *clusterCentres);
+        /**
+         * centres[(feature*numCentres)+centre], the layout of the matrix saved by RSGISImageClustering.
+         */
+        RSGISNearestClusterCentre(const double *centres, unsigned int numCentres, unsigned int numFeatures);
+        unsigned int getNumCentres() const {return numCentres;};
+        unsigned int getNumFeatures() const {return numFeatures;};
+        /**
+         * The index of the centre nearest to vals (getNumFeatures() values);
+         * distScratch must hold getNumCentres() values.
+         */
+        unsigned int findNearest(const float *vals, float *distScratch) const;
+        /**
+         * The index of the nearest centre for each of nPts points held as planes
+         * of features (featPlanes[feature][pt]).
+         */
+        void findNearest(const float* const* featPlanes, size_t nPts, unsigned int *nearest) const;
+        ~RSGISNearestClusterCentre();
+    protected:
+        unsigned int numCentres;
+        unsigned int numFeatures;
+        std::vector<float> centres;
+    };
+    
     class DllExport RSGISClusterer
 	{
 	public:
-		RSGISClusterer(){};
-        virtual std::vector< RSGISClusterCentre >* calcClusterCentres(std::vector< std::vector<float> > *input, unsigned int numFeatures, unsigned int numClusters, unsigned int maxNumIterations, float degreeOfChange) = 0;
-        void calcDataRanges(std::vector< std::vector<float> > *input, unsigned int numFeatures, float *min, float *max);
-        void calcDataStats(std::vector< std::vector<float> > *input, unsigned int numFeatures, float *min, float *max, float *mean, float *stddev);
+		RSGISClusterer();
+        /**
+         * Find the cluster centres for numVals points of numFeatures values, held
+         * row major (data[(point*numFeatures)+feature]).
+         */
+        virtual std::vector< RSGISClusterCentre >* calcClusterCentres(const float *data, size_t numVals, unsigned int numFeatures, unsigned int numClusters, unsigned int maxNumIterations, float degreeOfChange) = 0;
+        /**
+         * Copies the input into a single matrix and finds the cluster centres for it.
+         */
+        std::vector< RSGISClusterCentre >* calcClusterCentres(std::vector< std::vector<float> > *input, unsigned int numFeatures, unsigned int numClusters, unsigned int maxNumIterations, float degreeOfChange);
+        void calcDataRanges(const float *data, size_t numVals, unsigned int numFeatures, float *min, float *max);
+        void calcDataStats(const float *data, size_t numVals, unsigned int numFeatures, float *min, float *max, float *mean, float *stddev);
         std::vector< RSGISClusterCentre >* initializeClusterCentresRandom(unsigned int numFeatures, float *min, float *max, unsigned int numClusters);
-        std::vector< RSGISClusterCentre >* initializeClusterCentresRandom(std::vector< std::vector<float> > *input, unsigned int numFeatures, unsigned int numClusters);
+        std::vector< RSGISClusterCentre >* initializeClusterCentresRandom(const float *data, size_t numVals, unsigned int numFeatures, unsigned int numClusters);
         std::vector< RSGISClusterCentre >* initializeClusterCentresDiagonal(unsigned int numFeatures, float *min, float *max, unsigned int numClusters);
         std::vector< RSGISClusterCentre >* initializeClusterCentresDiagonal(unsigned int numFeatures, float *min, float *max, float *mean, float *stddev, unsigned int numClusters);
-        std::vector< RSGISClusterCentre >* initializeClusterCentresDiagonal(std::vector< std::vector<float> > *input, unsigned int numFeatures, float *min, float *max, unsigned int numClusters);
-        std::vector< RSGISClusterCentre >* initializeClusterCentresDiagonal(std::vector< std::vector<float> > *input, unsigned int numFeatures, float *min, float *max, float *mean, float *stddev, unsigned int numClusters);
-        std::vector< RSGISClusterCentre >* initializeClusterCentresKPP(std::vector< std::vector<float> > *input, unsigned int numFeatures, float *min, float *max, unsigned int numClusters);
+        std::vector< RSGISClusterCentre >* initializeClusterCentresDiagonal(const float *data, size_t numVals, unsigned int numFeatures, float *min, float *max, unsigned int numClusters);
+        std::vector< RSGISClusterCentre >* initializeClusterCentresDiagonal(const float *data, size_t numVals, unsigned int numFeatures, float *min, float *max, float *mean, float *stddev, unsigned int numClusters);
+        /**
+         * k-means++ seeding, computed as k-means|| (Bahmani et al., 2012): a few
+         * passes over the data, split between the threads, each sample about
+         * 2 * numClusters candidates with a probability proportional to their
+         * squared distance from the candidates so far. The candidates, weighted
+         * by the number of points nearest to them, are then reduced to
+         * numClusters centres with (weighted) k-means++. The sampling uses a
+         * fixed seed so the centres do not depend on the number of threads.
+         */
+        std::vector< RSGISClusterCentre >* initializeClusterCentresKPP(const float *data, size_t numVals, unsigned int numFeatures, float *min, float *max, unsigned int numClusters);
         
-        std::vector< std::pair< unsigned int, std::vector<float> > >* createClusterDataInitClusterIDs(std::vector< std::vector<float> > *input, std::vector< RSGISClusterCentre > *clusterCentres);
-        unsigned int reassignClusterIDs( std::vector< std::pair< unsigned int, std::vector<float> > > *clusterData, std::vector< RSGISClusterCentre > *clusterCentres);
-        void recalcClusterCentres( std::vector< std::pair< unsigned int, std::vector<float> > > *clusterData, std::vector< RSGISClusterCentre > *clusterCentres, bool calcStdDev);
-        void assign2ClosestDataPoint(RSGISClusterCentre *cc, std::vector< std::vector<float> > *input, unsigned int numFeatures, std::vector< RSGISClusterCentre > *used);
+        /**
+         * Assign each point to its nearest centre, returning the number of points
+         * whose clusterIDs changed. If centreShifts holds the distance each centre
+         * moved since the previous call (from recalcClusterCentres) the bounds
+         * kept from that call are used to skip the points which cannot have
+         * changed centre (Hamerly, 2010), otherwise every centre is checked.
+         */
+        unsigned int reassignClusterIDs(const float *data, size_t numVals, std::vector< RSGISClusterCentre > *clusterCentres, unsigned int *clusterIDs, const std::vector<float> *centreShifts=NULL);
+        /**
+         * Recalculate the centres (and numPxl) from the points assigned to them.
+         * Centres without any points are removed and the clusterIDs updated to
+         * the new indexes. If centreShifts is not NULL it is set to the distance
+         * each remaining centre moved.
+         */
+        void recalcClusterCentres(const float *data, size_t numVals, unsigned int *clusterIDs, std::vector< RSGISClusterCentre > *clusterCentres, bool calcStdDev, std::vector<float> *centreShifts=NULL);
+        void assign2ClosestDataPoint(RSGISClusterCentre *cc, const float *data, size_t numVals, unsigned int numFeatures, std::vector< RSGISClusterCentre > *used);
+        /**
+         * Set the number of threads used to assign the data to the cluster centres
+         * and recalculate the centres (0 uses the number of cores). Defaults to
+         * RSGISLIB_NUM_THREADS or 1.
+         */
+        void setNumThreads(unsigned int numThreads);
+        /**
+         * Stop iterating once no centre moves (euclidean distance) more than
+         * minShift in an iteration, as well as on degreeOfChange. Defaults to 0
+         * (only stop when the centres do not move).
+         */
+        void setMinCentreShift(float minShift){this->minCentreShift = minShift;};
         
-        ~RSGISClusterer(){};
+        virtual ~RSGISClusterer(){};
     protected:
-        double calcEucDistance(std::vector<float> d1, std::vector<float> d2)
+        /**
+         * Call func(start, end) for ranges of [0, nItems) split across the threads.
+         */
+        void processInThreads(size_t nItems, std::function<void(size_t, size_t)> func);
+        /**
+         * The number of ranges processRangesInThreads splits nItems into.
+         */
+        size_t getNumThreadRanges(size_t nItems);
+        /**
+         * As processInThreads but calling func(range, start, end) so each
+         * range can keep its result (e.g., sums) to be combined in range order,
+         * which, unlike the order the threads finish, is the same every run.
+         */
+        void processRangesInThreads(size_t nItems, std::function<void(size_t, size_t, size_t)> func);
+        /**
+         * True if none of the centreShifts are greater than minCentreShift.
+         */
+        bool centresConverged(const std::vector<float> &centreShifts);
+        unsigned int numThreads;
+        float minCentreShift;
+        // For each point, the distance to its centre and a lower bound on the
+        // distance to any other centre, as of the last reassignClusterIDs.
+        std::vector<float> upperBounds;
+        std::vector<float> lowerBounds;
+        double calcEucDistance(const float *d1, const float *d2, unsigned int numVals)
         {
-            unsigned int numVals = d1.size(); 
-            if(numVals != d2.size())
-            {
-                throw RSGISClustererException("Cannot calculate Euclidean distance for vectors of different length.");
-            }
             double dist = 0;
             for(unsigned int i = 0; i < numVals; ++i)
             {
@@ -110,18 +214,27 @@ namespace rsgis {namespace math{
     class DllExport RSGISKMeansClusterer: public RSGISClusterer
     {
     public:
-		RSGISKMeansClusterer(InitClustererMethods initCentres);
-        std::vector< RSGISClusterCentre >* calcClusterCentres(std::vector< std::vector<float> > *input, unsigned int numFeatures, unsigned int numClusters, unsigned int maxNumIterations, float degreeOfChange);
+        /**
+         * If miniBatchSize is greater than 0 (and smaller than the data) the centres
+         * are found with mini-batch k-means (Sculley, 2010), updating the centres
+         * from random batches of miniBatchSize points each iteration.
+         */
+		RSGISKMeansClusterer(InitClustererMethods initCentres, unsigned int miniBatchSize=0);
+        using RSGISClusterer::calcClusterCentres;
+        std::vector< RSGISClusterCentre >* calcClusterCentres(const float *data, size_t numVals, unsigned int numFeatures, unsigned int numClusters, unsigned int maxNumIterations, float degreeOfChange);
 		~RSGISKMeansClusterer();
     private:
+        void miniBatchClusterCentres(const float *data, size_t numVals, std::vector< RSGISClusterCentre > *clusterCentres, unsigned int maxNumIterations, float degreeOfChange);
         InitClustererMethods initCentres;
+        unsigned int miniBatchSize;
     };
     
     class DllExport RSGISISODataClusterer: public RSGISClusterer
     {
     public:
 		RSGISISODataClusterer(InitClustererMethods initCentres, float minDistBetweenClusters, unsigned int minNumFeatures, float maxStdDev, unsigned int minNumClusters, unsigned int startIteration, unsigned int endIteration);
-        std::vector< RSGISClusterCentre >* calcClusterCentres(std::vector< std::vector<float> > *input, unsigned int numFeatures, unsigned int numClusters, unsigned int maxNumIterations, float degreeOfChange);
+        using RSGISClusterer::calcClusterCentres;
+        std::vector< RSGISClusterCentre >* calcClusterCentres(const float *data, size_t numVals, unsigned int numFeatures, unsigned int numClusters, unsigned int maxNumIterations, float degreeOfChange);
 		void addRemoveClusters(std::vector< RSGISClusterCentre > *clusterCentres);
         ~RSGISISODataClusterer();
     private:
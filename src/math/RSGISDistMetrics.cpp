@@ -26,6 +26,87 @@
 
 namespace rsgis{namespace math{
     
+    // The squared Euclidean distances between the points and centres, scaled by
+    // norm, with the squared lengths calculated once and the dot products over
+    // blocks of centres small enough to stay in cache. The values are taken
+    // about the mean of the centres so the expansion does not lose precision
+    // where the values are large relative to the distances.
+    static void calcEuclideanDistMatrix(const double *pts, size_t numPts, const double *centres, size_t numCentres, size_t numDims, double norm, double *dists)
+    {
+        const size_t blockSize = 64;
+        std::vector<double> offset(numDims, 0.0);
+        for(size_t c = 0; c < numCentres; ++c)
+        {
+            for(size_t d = 0; d < numDims; ++d)
+            {
+                offset[d] += centres[(c*numDims)+d];
+            }
+        }
+        for(size_t d = 0; d < numDims; ++d)
+        {
+            offset[d] /= numCentres;
+        }
+        
+        std::vector<double> cVals(numCentres*numDims);
+        std::vector<double> cNorms(numCentres, 0.0);
+        for(size_t c = 0; c < numCentres; ++c)
+        {
+            for(size_t d = 0; d < numDims; ++d)
+            {
+                double val = centres[(c*numDims)+d] - offset[d];
+                cVals[(c*numDims)+d] = val;
+                cNorms[c] += val * val;
+            }
+        }
+        
+        std::vector<double> pVals(numDims);
+        for(size_t p = 0; p < numPts; ++p)
+        {
+            double pNorm = 0;
+            for(size_t d = 0; d < numDims; ++d)
+            {
+                pVals[d] = pts[(p*numDims)+d] - offset[d];
+                pNorm += pVals[d] * pVals[d];
+            }
+            double *pDists = &dists[p*numCentres];
+            for(size_t cStart = 0; cStart < numCentres; cStart += blockSize)
+            {
+                size_t cEnd = std::min(cStart + blockSize, numCentres);
+                for(size_t c = cStart; c < cEnd; ++c)
+                {
+                    const double *cVal = &cVals[c*numDims];
+                    double dot = 0;
+                    for(size_t d = 0; d < numDims; ++d)
+                    {
+                        dot += pVals[d] * cVal[d];
+                    }
+                    double sqDist = (pNorm - (2 * dot)) + cNorms[c];
+                    pDists[c] = sqrt(((sqDist < 0)?0:sqDist) * norm);
+                }
+            }
+        }
+    }
+    
+    void RSGISCalcDistMetric::calcDistMatrix(const double *pts, size_t numPts, const double *centres, size_t numCentres, size_t numDims, double *dists)
+    {
+        std::vector<double> pVals(numDims);
+        std::vector<double> cVals(centres, centres + (numCentres*numDims));
+        for(size_t p = 0; p < numPts; ++p)
+        {
+            std::copy(pts + (p*numDims), pts + ((p+1)*numDims), pVals.begin());
+            for(size_t c = 0; c < numCentres; ++c)
+            {
+                dists[(p*numCentres)+c] = this->calcDist(pVals.data(), 0, numDims, cVals.data(), c*numDims, (c+1)*numDims);
+            }
+        }
+    }
+    
+    void RSGISCalcDistMetric::calcDistMatrix(const float *pts, size_t numPts, const float *centres, size_t numCentres, size_t numDims, double *dists)
+    {
+        std::vector<double> pVals(pts, pts + (numPts*numDims));
+        std::vector<double> cVals(centres, centres + (numCentres*numDims));
+        this->calcDistMatrix(pVals.data(), numPts, cVals.data(), numCentres, numDims, dists);
+    }
     
 
     RSGISCalcEuclideanDistMetric::RSGISCalcEuclideanDistMetric(): RSGISCalcDistMetric()
@@ -71,6 +152,19 @@ namespace rsgis{namespace math{
         return dist;
     }
     
+    void RSGISCalcEuclideanDistMetric::calcDistMatrix(const double *pts, size_t numPts, const double *centres, size_t numCentres, size_t numDims, double *dists)
+    {
+        if(!this->initalised)
+        {
+            throw RSGISMathException("The metric calulator was not initialised.");
+        }
+        if((numPts == 0) || (numCentres == 0))
+        {
+            return;
+        }
+        calcEuclideanDistMatrix(pts, numPts, centres, numCentres, numDims, 1.0/numDims, dists);
+    }
+    
     RSGISCalcEuclideanDistMetric::~RSGISCalcEuclideanDistMetric()
     {
         
@@ -120,6 +214,28 @@ namespace rsgis{namespace math{
         return dist;
     }
     
+    void RSGISCalcManhattenDistMetric::calcDistMatrix(const double *pts, size_t numPts, const double *centres, size_t numCentres, size_t numDims, double *dists)
+    {
+        if(!this->initalised)
+        {
+            throw RSGISMathException("The metric calulator was not initialised.");
+        }
+        for(size_t p = 0; p < numPts; ++p)
+        {
+            const double *pVal = &pts[p*numDims];
+            for(size_t c = 0; c < numCentres; ++c)
+            {
+                const double *cVal = &centres[c*numDims];
+                double dist = 0;
+                for(size_t d = 0; d < numDims; ++d)
+                {
+                    dist += fabs(pVal[d] - cVal[d]);
+                }
+                dists[(p*numCentres)+c] = sqrt(dist/numDims);
+            }
+        }
+    }
+    
     RSGISCalcManhattenDistMetric::~RSGISCalcManhattenDistMetric()
     {
         
@@ -130,6 +246,7 @@ namespace rsgis{namespace math{
     {
         this->covarMatrix = covarMatrix;
         this->n = n;
+        this->cholCovarianceMatrix = NULL;
     }
     
     void RSGISCalcMahalanobisDistMetric::init()
@@ -151,7 +268,31 @@ namespace rsgis{namespace math{
         gsl_linalg_LU_decomp(coVarGSL, p, &signum);
         gsl_linalg_LU_invert (coVarGSL, p, this->invCovarianceMatrix);
         gsl_permutation_free(p);
-        gsl_matrix_free(coVarGSL);
+        
+        // The Cholesky factor is only available where the covariance matrix is
+        // positive definite, otherwise calcDistMatrix uses calcDist.
+        idx = 0;
+        for(size_t i = 0; i < n; ++i)
+        {
+            for(size_t j = 0; j < n; ++j)
+            {
+                coVarGSL->data[idx++] = this->covarMatrix[i][j];
+            }
+        }
+        gsl_error_handler_t *errHandler = gsl_set_error_handler_off();
+        if(gsl_linalg_cholesky_decomp(coVarGSL) == GSL_SUCCESS)
+        {
+            if(this->cholCovarianceMatrix != NULL)
+            {
+                gsl_matrix_free(this->cholCovarianceMatrix);
+            }
+            this->cholCovarianceMatrix = coVarGSL;
+        }
+        else
+        {
+            gsl_matrix_free(coVarGSL);
+        }
+        gsl_set_error_handler(errHandler);
 
         this->diffVals = gsl_vector_alloc(this->n);
         this->tmpVec = gsl_vector_alloc(this->n);
@@ -194,6 +335,43 @@ namespace rsgis{namespace math{
         return dist;
     }
     
+    void RSGISCalcMahalanobisDistMetric::whitenVals(const double *vals, size_t numVals, std::vector<double> *whiteVals)
+    {
+        whiteVals->assign(vals, vals + (numVals*n));
+        for(size_t i = 0; i < numVals; ++i)
+        {
+            gsl_vector_view whiteVec = gsl_vector_view_array(&(*whiteVals)[i*n], n);
+            gsl_blas_dtrsv(CblasLower, CblasNoTrans, CblasNonUnit, this->cholCovarianceMatrix, &whiteVec.vector);
+        }
+    }
+    
+    void RSGISCalcMahalanobisDistMetric::calcDistMatrix(const double *pts, size_t numPts, const double *centres, size_t numCentres, size_t numDims, double *dists)
+    {
+        if(!this->initalised)
+        {
+            throw RSGISMathException("The metric calulator was not initialised.");
+        }
+        if(numDims != n)
+        {
+            throw RSGISMathException("The length of the two arrays and covariance matrix dimensions must be the same for the distance to be calculated.");
+        }
+        if(this->cholCovarianceMatrix == NULL)
+        {
+            RSGISCalcDistMetric::calcDistMatrix(pts, numPts, centres, numCentres, numDims, dists);
+            return;
+        }
+        if((numPts == 0) || (numCentres == 0))
+        {
+            return;
+        }
+        
+        std::vector<double> whitePts;
+        std::vector<double> whiteCentres;
+        this->whitenVals(pts, numPts, &whitePts);
+        this->whitenVals(centres, numCentres, &whiteCentres);
+        calcEuclideanDistMatrix(whitePts.data(), numPts, whiteCentres.data(), numCentres, numDims, 1.0, dists);
+    }
+    
     RSGISCalcMahalanobisDistMetric::~RSGISCalcMahalanobisDistMetric()
     {
         for(size_t i = 0; i < n; ++i)
@@ -204,6 +382,10 @@ namespace rsgis{namespace math{
         gsl_matrix_free(this->invCovarianceMatrix);
         gsl_vector_free(this->diffVals);
         gsl_vector_free(this->tmpVec);
+        if(this->cholCovarianceMatrix != NULL)
+        {
+            gsl_matrix_free(this->cholCovarianceMatrix);
+        }
     }
     
     
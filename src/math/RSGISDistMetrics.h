@@ -36,6 +36,7 @@
 #include <gsl/gsl_vector.h>
 #include <gsl/gsl_linalg.h>
 #include <gsl/gsl_blas.h>
+#include <gsl/gsl_errno.h>
 
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
@@ -59,6 +60,15 @@ namespace rsgis{namespace math{
         RSGISCalcDistMetric(){this->initalised = false;};
         virtual void init() = 0;
         virtual double calcDist(double *vals1, size_t sIdx1, size_t eIdx1, double *vals2, size_t sIdx2, size_t eIdx2) = 0;
+        /**
+         * The distances between each of numPts points and each of numCentres
+         * centres, with numDims contiguous values per point (and centre), into
+         * dists as a numPts x numCentres (row major) matrix. The distances are
+         * those of calcDist, which the default calls for each pair. The float
+         * version converts the values and calls the double version.
+         */
+        virtual void calcDistMatrix(const double *pts, size_t numPts, const double *centres, size_t numCentres, size_t numDims, double *dists);
+        virtual void calcDistMatrix(const float *pts, size_t numPts, const float *centres, size_t numCentres, size_t numDims, double *dists);
         virtual ~RSGISCalcDistMetric(){};
     protected:
         bool initalised;
@@ -71,6 +81,12 @@ namespace rsgis{namespace math{
         RSGISCalcEuclideanDistMetric();
         virtual void init();
         virtual double calcDist(double *vals1, size_t sIdx1, size_t eIdx1, double *vals2, size_t sIdx2, size_t eIdx2);
+        using RSGISCalcDistMetric::calcDistMatrix;
+        /**
+         * Uses |x|^2 - 2x.c + |c|^2 (about the mean of the centres), with the
+         * dot products over blocks of centres.
+         */
+        virtual void calcDistMatrix(const double *pts, size_t numPts, const double *centres, size_t numCentres, size_t numDims, double *dists);
         virtual ~RSGISCalcEuclideanDistMetric();
     };
     
@@ -80,6 +96,8 @@ namespace rsgis{namespace math{
         RSGISCalcManhattenDistMetric();
         virtual void init();
         virtual double calcDist(double *vals1, size_t sIdx1, size_t eIdx1, double *vals2, size_t sIdx2, size_t eIdx2);
+        using RSGISCalcDistMetric::calcDistMatrix;
+        virtual void calcDistMatrix(const double *pts, size_t numPts, const double *centres, size_t numCentres, size_t numDims, double *dists);
         virtual ~RSGISCalcManhattenDistMetric();
     };
     
@@ -89,8 +107,19 @@ namespace rsgis{namespace math{
         RSGISCalcMahalanobisDistMetric(double **covarMatrixm, size_t n);
         virtual void init();
         virtual double calcDist(double *vals1, size_t sIdx1, size_t eIdx1, double *vals2, size_t sIdx2, size_t eIdx2);
+        using RSGISCalcDistMetric::calcDistMatrix;
+        /**
+         * With the Cholesky factor (L) of the covariance matrix, the distance is
+         * the Euclidean distance between L^-1 x and L^-1 c, so the points and
+         * centres are whitened once and compared as for the Euclidean metric.
+         * If the covariance matrix is not positive definite each pair is
+         * calculated with calcDist.
+         */
+        virtual void calcDistMatrix(const double *pts, size_t numPts, const double *centres, size_t numCentres, size_t numDims, double *dists);
         virtual ~RSGISCalcMahalanobisDistMetric();
     protected:
+        void whitenVals(const double *vals, size_t numVals, std::vector<double> *whiteVals);
+        gsl_matrix *cholCovarianceMatrix;
         double **covarMatrix;
         gsl_matrix *invCovarianceMatrix;
         gsl_vector *diffVals;
@@ -30,8 +30,125 @@ namespace rsgis{namespace math{
 		
 	}
 	
-	RSGISFFTWUtils::~RSGISFFTWUtils()
+	unsigned int RSGISFFTWUtils::nextPowerOfTwo(unsigned int n)
 	{
+		unsigned int p = 1;
+		while(p < n)
+		{
+			p <<= 1;
+		}
+		return p;
+	}
+	
+	const RSGISFFTWUtils::RSGISFFTPlan* RSGISFFTWUtils::getPlan(unsigned int n)
+	{
+		std::lock_guard<std::mutex> lock(this->plansMutex);
+		std::map<unsigned int, RSGISFFTPlan*>::iterator iterPlan = this->plans.find(n);
+		if(iterPlan != this->plans.end())
+		{
+			return iterPlan->second;
+		}
+		
+		RSGISFFTPlan *plan = new RSGISFFTPlan();
+		unsigned int numBits = 0;
+		while((1u << numBits) < n)
+		{
+			++numBits;
+		}
+		plan->bitReverse.resize(n);
+		for(unsigned int i = 0; i < n; ++i)
+		{
+			unsigned int rev = 0;
+			for(unsigned int b = 0; b < numBits; ++b)
+			{
+				if(i & (1u << b))
+				{
+					rev |= 1u << (numBits - 1 - b);
+				}
+			}
+			plan->bitReverse[i] = rev;
+		}
+		// exp(-2 pi i k / n) for the forward transform.
+		plan->twiddles.resize(n/2);
+		for(unsigned int k = 0; k < n/2; ++k)
+		{
+			double angle = (-2.0 * M_PI * k) / n;
+			plan->twiddles[k] = std::complex<double>(cos(angle), sin(angle));
+		}
+		this->plans[n] = plan;
+		return plan;
+	}
+	
+	void RSGISFFTWUtils::fft(std::complex<double> *data, unsigned int n, unsigned int stride, bool inverse)
+	{
+		if((n == 0) || ((n & (n - 1)) != 0))
+		{
+			throw RSGISMatricesException("The FFT length must be a power of 2.");
+		}
+		if(n == 1)
+		{
+			return;
+		}
+		const RSGISFFTPlan *plan = this->getPlan(n);
+		
+		for(unsigned int i = 0; i < n; ++i)
+		{
+			unsigned int j = plan->bitReverse[i];
+			if(i < j)
+			{
+				std::swap(data[i*stride], data[j*stride]);
+			}
+		}
 		
+		for(unsigned int len = 2; len <= n; len <<= 1)
+		{
+			unsigned int half = len / 2;
+			unsigned int twStep = n / len;
+			for(unsigned int start = 0; start < n; start += len)
+			{
+				for(unsigned int k = 0; k < half; ++k)
+				{
+					std::complex<double> w = plan->twiddles[k*twStep];
+					if(inverse)
+					{
+						w = std::conj(w);
+					}
+					std::complex<double> &a = data[(start + k)*stride];
+					std::complex<double> &b = data[(start + k + half)*stride];
+					std::complex<double> t = w * b;
+					b = a - t;
+					a = a + t;
+				}
+			}
+		}
+		
+		if(inverse)
+		{
+			double scale = 1.0 / n;
+			for(unsigned int i = 0; i < n; ++i)
+			{
+				data[i*stride] *= scale;
+			}
+		}
+	}
+	
+	void RSGISFFTWUtils::fft2D(std::complex<double> *data, unsigned int width, unsigned int height, bool inverse)
+	{
+		for(unsigned int y = 0; y < height; ++y)
+		{
+			this->fft(data + (((size_t)y) * width), width, 1, inverse);
+		}
+		for(unsigned int x = 0; x < width; ++x)
+		{
+			this->fft(data + x, height, width, inverse);
+		}
+	}
+	
+	RSGISFFTWUtils::~RSGISFFTWUtils()
+	{
+		for(std::map<unsigned int, RSGISFFTPlan*>::iterator iterPlan = this->plans.begin(); iterPlan != this->plans.end(); ++iterPlan)
+		{
+			delete iterPlan->second;
+		}
 	}
 }}
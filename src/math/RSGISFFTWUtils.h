@@ -26,6 +26,9 @@
 #include <complex>
 //#include <fftw3.h>
 #include <math.h>
+#include <map>
+#include <vector>
+#include <mutex>
 #include "RSGISMatrices.h"
 #include "RSGISMatricesException.h"
 
@@ -44,12 +47,38 @@
 
 namespace rsgis{namespace math{
 	    
+	/**
+	 * Fast Fourier transforms of complex data, with lengths padded to a
+	 * power of 2 (nextPowerOfTwo). FFTW is not linked, so these use an
+	 * in-place radix-2 transform. The bit reversal and twiddle factors for
+	 * each length (the plan) are made on first use and cached, so reusing
+	 * the same object for the same sizes only computes the transforms.
+	 * The plans are created under a mutex so an object can be shared
+	 * between threads.
+	 */
 	class DllExport RSGISFFTWUtils
 		{
 		public:
 			RSGISFFTWUtils();
-
+			/** The smallest power of 2 greater or equal to n. */
+			static unsigned int nextPowerOfTwo(unsigned int n);
+			/**
+			 * In place transform of n (a power of 2) values, stride values apart.
+			 * The inverse is scaled by 1/n so it reverses the forward transform.
+			 */
+			void fft(std::complex<double> *data, unsigned int n, unsigned int stride, bool inverse);
+			/** In place transform of a row major width x height array (both powers of 2). */
+			void fft2D(std::complex<double> *data, unsigned int width, unsigned int height, bool inverse);
 			~RSGISFFTWUtils();
+		protected:
+			struct RSGISFFTPlan
+			{
+				std::vector<unsigned int> bitReverse;
+				std::vector<std::complex<double> > twiddles;
+			};
+			const RSGISFFTPlan* getPlan(unsigned int n);
+			std::map<unsigned int, RSGISFFTPlan*> plans;
+			std::mutex plansMutex;
 		};
 }}
 
@@ -26,34 +26,86 @@ namespace rsgis{namespace math{
     
     RSGISFitGaussianMixModel::RSGISFitGaussianMixModel()
     {
-        
+        this->numThreads = rsgis::utils::getNumThreads();
     }
     
     std::vector<GaussianModelParams> RSGISFitGaussianMixModel::performFit(std::vector<std::pair<double, double> > *hist, float binWidth, double peakThres, double ampVar, unsigned int peakLocVar, unsigned int initWidth, double minWidth, double maxWidth, bool debug_info)
+    {
+        GaussianModelHistBatch histBatch;
+        histBatch.addHist(hist);
+        GaussianModelFitWorkspace workspace;
+        return this->fitHistogram(histBatch.binCentres.data(), histBatch.binFreqs.data(), hist->size(), binWidth, peakThres, ampVar, peakLocVar, initWidth, minWidth, maxWidth, debug_info, &workspace, false);
+    }
+    
+    void RSGISFitGaussianMixModel::performFits(GaussianModelHistBatch *hists, float binWidth, std::function<void(size_t, std::vector< std::vector<GaussianModelParams> >*)> outputChunk, size_t chunkSize, double peakThres, double ampVar, unsigned int peakLocVar, unsigned int initWidth, double minWidth, double maxWidth, bool warmStart)
+    {
+        if(chunkSize == 0)
+        {
+            chunkSize = 1;
+        }
+        size_t numHists = hists->getNumHists();
+        std::vector< std::vector<GaussianModelParams> > chunkParams;
+        rsgis::utils::RSGISWorkerPool pool(this->numThreads);
+        std::vector<GaussianModelFitWorkspace> workspaces(pool.getNumThreads());
+        // When warm starting the threads take runs of neighbouring histograms.
+        size_t runLen = warmStart?32:1;
+        for(size_t chunkStart = 0; chunkStart < numHists; chunkStart += chunkSize)
+        {
+            size_t chunkLen = std::min(chunkSize, numHists - chunkStart);
+            chunkParams.assign(chunkLen, std::vector<GaussianModelParams>());
+            
+            // The fits take very different times so the threads take the next
+            // run of histograms in the chunk as they finish rather than a fixed range.
+            size_t numRuns = (chunkLen + runLen - 1) / runLen;
+            pool.parallelFor(numRuns, [&, this](size_t run, unsigned int t)
+            {
+                GaussianModelFitWorkspace *workspace = &workspaces[t];
+                size_t runStart = run * runLen;
+                size_t runEnd = std::min(runStart + runLen, chunkLen);
+                for(size_t i = runStart; i < runEnd; ++i)
+                {
+                    size_t histIdx = chunkStart + i;
+                    size_t start = hists->histOffsets[histIdx];
+                    size_t numBins = hists->histOffsets[histIdx+1] - start;
+                    chunkParams[i] = this->fitHistogram(hists->binCentres.data() + start, hists->binFreqs.data() + start, numBins, binWidth, peakThres, ampVar, peakLocVar, initWidth, minWidth, maxWidth, false, workspace, (warmStart && (i > runStart)));
+                }
+            });
+            
+            outputChunk(chunkStart, &chunkParams);
+        }
+    }
+    
+    void RSGISFitGaussianMixModel::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+    
+    std::vector<GaussianModelParams> RSGISFitGaussianMixModel::fitHistogram(const double *binCentres, const double *binFreqs, size_t numBins, float binWidth, double peakThres, double ampVar, unsigned int peakLocVar, unsigned int initWidth, double minWidth, double maxWidth, bool debug_info, GaussianModelFitWorkspace *workspace, bool warmStart)
     {
         std::vector<GaussianModelParams> outGauParams;
         try
         {
-            if(hist->size() < 4)
+            if(numBins < 4)
             {
                 throw RSGISMathException("RSGISFitGaussianMixModel: There must be at least 4 histogram bins.");
             }
             
             
             // Count the number of peaks...
-            std::vector<unsigned int> peakIdxs = std::vector<unsigned int>();
+            std::vector<unsigned int> &peakIdxs = workspace->peakIdxs;
+            peakIdxs.clear();
             
-            unsigned int histLenLess1 = hist->size()-1;
+            unsigned int histLenLess1 = numBins-1;
             double forGrad = 0;
             double backGrad = 0;
 
             for(unsigned int i = 1; i < histLenLess1; ++i)
             {
-                forGrad = hist->at(i).second - hist->at(i-1).second;
-                backGrad = hist->at(i+1).second - hist->at(i).second;
+                forGrad = binFreqs[i] - binFreqs[i-1];
+                backGrad = binFreqs[i+1] - binFreqs[i];
                 if((forGrad > 0) & (backGrad < 0))
                 {
-                    if(hist->at(i).second > peakThres)
+                    if(binFreqs[i] > peakThres)
                     {
                         peakIdxs.push_back(i);
                     }
@@ -65,13 +117,14 @@ namespace rsgis{namespace math{
                 std::cout << "Number of Peaks: " << peakIdxs.size() << std::endl;
                 for(std::vector<unsigned int>::iterator iterPeaks = peakIdxs.begin(); iterPeaks != peakIdxs.end(); ++iterPeaks)
                 {
-                    std::cout << *iterPeaks << ": " << hist->at(*iterPeaks).first << ", " << hist->at(*iterPeaks).second << std::endl;
+                    std::cout << *iterPeaks << ": " << binCentres[*iterPeaks] << ", " << binFreqs[*iterPeaks] << std::endl;
                 }
             }
             
             if(peakIdxs.size() > 0)
             {
-                rsgis_mp_config *mpConfigValues = new rsgis_mp_config();
+                rsgis_mp_config mpConfig = rsgis_mp_config();
+                rsgis_mp_config *mpConfigValues = &mpConfig;
                 mpConfigValues->ftol = 1e-10;
                 mpConfigValues->xtol = 1e-10;
                 mpConfigValues->gtol = 1e-10;
@@ -85,7 +138,8 @@ namespace rsgis{namespace math{
                 mpConfigValues->nofinitecheck = 0;
                 mpConfigValues->iterproc = 0;
                 
-                rsgis_mp_result *mpResultsValues = new rsgis_mp_result();
+                rsgis_mp_result mpResults = rsgis_mp_result();
+                rsgis_mp_result *mpResultsValues = &mpResults;
                 mpResultsValues->bestnorm = 0;
                 mpResultsValues->orignorm = 0;
                 mpResultsValues->niter = 0;
@@ -106,10 +160,20 @@ namespace rsgis{namespace math{
                  * p[2] = time offset
                  * p[3] = width
                  */
-                double *parameters = new double[numOfParams];
-                mp_par *paramConstraints = new mp_par[numOfParams];
+                workspace->parameters.assign(numOfParams, 0.0);
+                workspace->paramConstraints.assign(numOfParams, mp_par());
+                double *parameters = workspace->parameters.data();
+                mp_par *paramConstraints = workspace->paramConstraints.data();
+                
+                // The previous fit, to warm start from.
+                std::vector<GaussianModelParams> &lastFit = workspace->lastFit;
+                bool useLastFit = warmStart && (!lastFit.empty());
                 
                 parameters[0] = peakThres/3;
+                if(useLastFit)
+                {
+                    parameters[0] = std::min(std::max(lastFit.front().noise, 0.0), peakThres);
+                }
                 paramConstraints[0].fixed = false;
                 paramConstraints[0].limited[0] = true;
                 paramConstraints[0].limited[1] = true;
@@ -125,7 +189,7 @@ namespace rsgis{namespace math{
                 for(unsigned int i = 0; i < peakIdxs.size(); ++i)
                 {
                     idx = (i*3)+1;
-                    parameters[idx] = hist->at(peakIdxs.at(i)).second; // Amplitude
+                    parameters[idx] = binFreqs[peakIdxs.at(i)]; // Amplitude
                     paramConstraints[idx].fixed = false;
                     paramConstraints[idx].limited[0] = true;
                     paramConstraints[idx].limited[1] = true;
@@ -141,7 +205,7 @@ namespace rsgis{namespace math{
                     paramConstraints[idx].side = 0;
                     paramConstraints[idx].deriv_debug = 0;
                     
-                    parameters[idx+1] = hist->at(peakIdxs.at(i)).first; // X Value
+                    parameters[idx+1] = binCentres[peakIdxs.at(i)]; // X Value
                     paramConstraints[idx+1].fixed = false;
                     paramConstraints[idx+1].limited[0] = true;
                     paramConstraints[idx+1].limited[1] = true;
@@ -154,6 +218,20 @@ namespace rsgis{namespace math{
                     paramConstraints[idx+1].deriv_debug = 0;
                     
                     parameters[idx+2] = initWidth * binWidth;
+                    if(useLastFit)
+                    {
+                        // The width of the previous fit's nearest peak, if it is close enough.
+                        double minDist = peakLocVar*binWidth;
+                        for(std::vector<GaussianModelParams>::iterator iterLast = lastFit.begin(); iterLast != lastFit.end(); ++iterLast)
+                        {
+                            double dist = fabs((*iterLast).offset - parameters[idx+1]);
+                            if(dist <= minDist)
+                            {
+                                minDist = dist;
+                                parameters[idx+2] = std::min(std::max((*iterLast).fwhm, minWidth), maxWidth);
+                            }
+                        }
+                    }
                     paramConstraints[idx+2].fixed = false;
                     paramConstraints[idx+2].limited[0] = true;
                     paramConstraints[idx+2].limited[1] = true;
@@ -181,14 +259,18 @@ namespace rsgis{namespace math{
 
                 
                 // Contruct data for decomposition
-                GaussianModelData *decompData = new GaussianModelData();
-                decompData->xVal = new double[hist->size()];
-                decompData->amplitude = new double[hist->size()];
-                decompData->error = new double[hist->size()];
-                for(unsigned int i = 0; i < hist->size(); ++i)
+                workspace->xVal.resize(numBins);
+                workspace->amplitude.resize(numBins);
+                workspace->error.resize(numBins);
+                GaussianModelData modelData;
+                GaussianModelData *decompData = &modelData;
+                decompData->xVal = workspace->xVal.data();
+                decompData->amplitude = workspace->amplitude.data();
+                decompData->error = workspace->error.data();
+                for(unsigned int i = 0; i < numBins; ++i)
                 {
-                    decompData->xVal[i] = hist->at(i).first;
-                    decompData->amplitude[i] = hist->at(i).second;
+                    decompData->xVal[i] = binCentres[i];
+                    decompData->amplitude[i] = binFreqs[i];
                     decompData->error[i] = 1.0;
                 }
                 
@@ -203,7 +285,7 @@ namespace rsgis{namespace math{
                  * void *private_data - Waveform data structure
                  * mp_result *result - diagnostic info from function
                  */
-                int returnCode = rsgis_mpfit(gaussianSum, hist->size(), numOfParams, parameters, paramConstraints, mpConfigValues, decompData, mpResultsValues);
+                int returnCode = rsgis_mpfit(gaussianSum, numBins, numOfParams, parameters, paramConstraints, mpConfigValues, decompData, mpResultsValues);
                 
                 if(debug_info)
                 {
@@ -329,18 +411,11 @@ namespace rsgis{namespace math{
                     params.fwhm = parameters[idx+2];
                     outGauParams.push_back(params);
                 }
-                
-                
-                delete[] decompData->xVal;
-                delete[] decompData->amplitude;
-                delete[] decompData->error;
-                delete decompData;
-                
-                delete[] parameters;
-                delete[] paramConstraints;
-                
-                delete mpConfigValues;
-                delete mpResultsValues;
+                lastFit = outGauParams;
+            }
+            else
+            {
+                workspace->lastFit.clear();
             }
         }
         catch (RSGISMathException &e)
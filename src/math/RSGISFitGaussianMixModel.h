@@ -27,10 +27,16 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <stdlib.h>
 #include <math.h>
 
 #include "math/RSGISMathException.h"
 #include "math/cmpfit/rsgis_mpfit.h"
+#include "common/RSGISParallel.h"
 
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
@@ -62,6 +68,47 @@ namespace rsgis{namespace math{
         double fwhm;
     };
     
+    /**
+     * A set of histograms packed into contiguous arrays. The bins of histogram
+     * i are binCentres[histOffsets[i]] to binCentres[histOffsets[i+1]-1] (with
+     * the frequencies in binFreqs), so histOffsets has one more value than
+     * there are histograms.
+     */
+    struct DllExport GaussianModelHistBatch
+    {
+        std::vector<double> binCentres;
+        std::vector<double> binFreqs;
+        std::vector<size_t> histOffsets;
+        
+        GaussianModelHistBatch(): histOffsets(1, 0){};
+        size_t getNumHists() const {return histOffsets.size()-1;};
+        void addHist(std::vector<std::pair<double, double> > *hist)
+        {
+            for(std::vector<std::pair<double, double> >::iterator iterHist = hist->begin(); iterHist != hist->end(); ++iterHist)
+            {
+                binCentres.push_back((*iterHist).first);
+                binFreqs.push_back((*iterHist).second);
+            }
+            histOffsets.push_back(binCentres.size());
+        };
+    };
+    
+    /**
+     * The buffers used by a fit, kept by each thread and reused for each of
+     * its histograms, along with the parameters of its last fit to warm start
+     * the next one.
+     */
+    struct DllExport GaussianModelFitWorkspace
+    {
+        std::vector<unsigned int> peakIdxs;
+        std::vector<double> parameters;
+        std::vector<mp_par> paramConstraints;
+        std::vector<double> xVal;
+        std::vector<double> amplitude;
+        std::vector<double> error;
+        std::vector<GaussianModelParams> lastFit;
+    };
+    
     /*
      * int m     - number of data points
      * int n     - number of parameters
@@ -108,8 +155,29 @@ namespace rsgis{namespace math{
     public:
         RSGISFitGaussianMixModel();
         std::vector<GaussianModelParams> performFit(std::vector<std::pair<double, double> > *hist, float binWidth, double peakThres=0.005, double ampVar=0.01, unsigned int peakLocVar=2, unsigned int initWidth=2, double minWidth=0.01, double maxWidth=10, bool debug_info=false);
+        /**
+         * Fit each of the histograms in hists, in parallel across the threads.
+         * The histograms are fitted in chunks of chunkSize and, once a chunk is
+         * complete, outputChunk is called (on the calling thread, in histogram
+         * order) with the index of its first histogram and the fitted
+         * parameters for each histogram in it, so only one chunk of results is
+         * held in memory.
+         *
+         * With warmStart, neighbouring histograms (e.g., those of neighbouring
+         * objects) are fitted on the same thread and the noise and the width
+         * of each peak start from those of the previous fit (the nearest peak
+         * within peakLocVar bins) rather than from initWidth.
+         */
+        void performFits(GaussianModelHistBatch *hists, float binWidth, std::function<void(size_t, std::vector< std::vector<GaussianModelParams> >*)> outputChunk, size_t chunkSize=1000, double peakThres=0.005, double ampVar=0.01, unsigned int peakLocVar=2, unsigned int initWidth=2, double minWidth=0.01, double maxWidth=10, bool warmStart=false);
+        /**
+         * Set the number of threads used by performFits (0 uses the number of
+         * cores). Defaults to RSGISLIB_NUM_THREADS or 1.
+         */
+        void setNumThreads(unsigned int numThreads);
         ~RSGISFitGaussianMixModel();
-        
+    protected:
+        std::vector<GaussianModelParams> fitHistogram(const double *binCentres, const double *binFreqs, size_t numBins, float binWidth, double peakThres, double ampVar, unsigned int peakLocVar, unsigned int initWidth, double minWidth, double maxWidth, bool debug_info, GaussianModelFitWorkspace *workspace, bool warmStart);
+        unsigned int numThreads;
     };
     
     
@@ -29,903 +29,295 @@ namespace rsgis{namespace math{
 	RSGISGlobalHillClimbingOptimiser2D::RSGISGlobalHillClimbingOptimiser2D(RSGISGlobalOptimisationFunction *func, bool maximise, int maxNumIterations) : RSGISGlobalOptimiser2D(func, maximise)
 	{
 		this->maxNumIterations = maxNumIterations;
+		this->numStarts = 1;
+		this->startOffset = 0;
+		this->invalidOnError = false;
+		this->numThreads = rsgis::utils::getNumThreads();
+	}
+	
+	void RSGISGlobalHillClimbingOptimiser2D::setMultiStart(unsigned int numStarts, double startOffset)
+	{
+		this->numStarts = (numStarts == 0)?1:numStarts;
+		this->startOffset = startOffset;
+	}
+	
+	void RSGISGlobalHillClimbingOptimiser2D::setNumThreads(unsigned int numThreads)
+	{
+		this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
 	}
 	
     std::vector<geos::geom::Coordinate*>* RSGISGlobalHillClimbingOptimiser2D::optimise4Neighbor(std::vector<geos::geom::Coordinate*> *coords, double step, geos::geom::Envelope *boundary)
 	{
-        std::vector<geos::geom::Coordinate*> *outCoords = new std::vector<geos::geom::Coordinate*>();
-		try
+		return this->optimise(coords, step, boundary, false);
+	}
+	
+    std::vector<geos::geom::Coordinate*>* RSGISGlobalHillClimbingOptimiser2D::optimise8Neighbor(std::vector<geos::geom::Coordinate*> *coords, double step, geos::geom::Envelope *boundary)
+	{
+		return this->optimise(coords, step, boundary, true);
+	}
+	
+    std::vector<geos::geom::Coordinate*>* RSGISGlobalHillClimbingOptimiser2D::optimise(std::vector<geos::geom::Coordinate*> *coords, double step, geos::geom::Envelope *boundary, bool eightNeighbours)
+	{
+		geos::geom::Envelope minBoundary(boundary->getMinX(), (boundary->getMaxX()-step), boundary->getMinY(), (boundary->getMaxY()-step));
+		
+		// The first start is the contour as given, the others are displaced copies.
+		std::vector<std::vector<geos::geom::Coordinate*>*> starts(this->numStarts);
+		for(unsigned int s = 0; s < this->numStarts; ++s)
 		{
-            std::vector<geos::geom::Coordinate*>::iterator iterCoords;
-			for(iterCoords = coords->begin(); iterCoords != coords->end(); ++iterCoords)
+			starts[s] = new std::vector<geos::geom::Coordinate*>();
+			starts[s]->reserve(coords->size());
+			std::mt19937 rng(s);
+			std::uniform_real_distribution<double> offsetDist(-this->startOffset, this->startOffset);
+			for(std::vector<geos::geom::Coordinate*>::iterator iterCoords = coords->begin(); iterCoords != coords->end(); ++iterCoords)
 			{
-				outCoords->push_back(new geos::geom::Coordinate((*iterCoords)->x, (*iterCoords)->y, (*iterCoords)->z));
+				geos::geom::Coordinate *coord = new geos::geom::Coordinate((*iterCoords)->x, (*iterCoords)->y, (*iterCoords)->z);
+				if(s > 0)
+				{
+					coord->x += offsetDist(rng);
+					coord->y += offsetDist(rng);
+					if(!minBoundary.contains(*coord))
+					{
+						coord->x = (*iterCoords)->x;
+						coord->y = (*iterCoords)->y;
+					}
+				}
+				starts[s]->push_back(coord);
 			}
-			
-			/*
-			 * 0 - Current Pixel
-			 * 1 - X-1
-			 * 2 - Y+1
-			 * 3 - X+1
-			 * 4 - Y-1
-			 */
-			double value = 0;
-			double selectValue = 0;
-			int selectIdx = 0;
-			bool first = true;
-			geos::geom::Coordinate *coord = new geos::geom::Coordinate();
-			int numIteration = 0;
-			int nodeCount = 0;
-			
-			geos::geom::Envelope *minBoundary = new geos::geom::Envelope(boundary->getMinX(), (boundary->getMaxX()-step), boundary->getMinY(), (boundary->getMaxY()-step));
-						
-            std::cout << "Started " << std::flush;
-			
-			bool change = true;
-			while(change)
+		}
+		auto deleteCoords = [](std::vector<geos::geom::Coordinate*> *startCoords)
+		{
+			for(std::vector<geos::geom::Coordinate*>::iterator iterCoords = startCoords->begin(); iterCoords != startCoords->end(); ++iterCoords)
+			{
+				delete *iterCoords;
+			}
+			delete startCoords;
+		};
+		
+		if(this->numStarts == 1)
+		{
+			try
+			{
+				this->climb(starts[0], step, &minBoundary, eightNeighbours, true);
+			}
+			catch(...)
+			{
+				deleteCoords(starts[0]);
+				throw;
+			}
+			return starts[0];
+		}
+		
+		std::cout << "Started " << this->numStarts << " starts" << std::flush;
+		std::vector<double> values(this->numStarts, 0);
+		std::vector<char> valid(this->numStarts, 0);
+		unsigned int nThreads = this->func->isThreadSafe()?this->numThreads:1;
+		try
+		{
+			rsgis::utils::parallelFor(this->numStarts, nThreads, [&](size_t s, unsigned int)
 			{
-				if(numIteration == maxNumIterations)
+				this->climb(starts[s], step, &minBoundary, eightNeighbours, false);
+				try
 				{
-					break;
+					values[s] = this->func->calcValue(starts[s]);
+					valid[s] = 1;
 				}
-                std::cout << "." << std::flush;
-				
-				change = false;
-				nodeCount = 0;
-				for(iterCoords = outCoords->begin(); iterCoords != outCoords->end(); ++iterCoords)
+				catch(RSGISOptimisationException &e)
 				{
-					coord->x = (*iterCoords)->x;
-					coord->y = (*iterCoords)->y;
-					coord->z = (*iterCoords)->z;
-					first = true;
-					for(int i = 0; i < 5; ++i)
-					{
-						if(i == 0)
-						{
-							(*iterCoords)->x = coord->x;
-							(*iterCoords)->y = coord->y;
-							(*iterCoords)->z = coord->z;
-						}
-						else if(i == 1)
-						{
-							(*iterCoords)->x = coord->x - step;
-							(*iterCoords)->y = coord->y;
-							(*iterCoords)->z = coord->z;
-						}
-						else if(i == 2)
-						{
-							(*iterCoords)->x = coord->x;
-							(*iterCoords)->y = coord->y + step;
-							(*iterCoords)->z = coord->z;
-						}
-						else if(i == 3)
-						{
-							(*iterCoords)->x = coord->x + step;
-							(*iterCoords)->y = coord->y;
-							(*iterCoords)->z = coord->z;
-						}
-						else if(i == 4)
-						{
-							(*iterCoords)->x = coord->x;
-							(*iterCoords)->y = coord->y - step;
-							(*iterCoords)->z = coord->z;
-						}
-						
-						if(minBoundary->contains(**iterCoords))
-						{
-							value = this->func->calcValue(outCoords);
-						}
-						else
-						{
-							value = -1;
-						}
-						
-						if(value != -1)
-						{
-							if(first)
-							{
-								selectValue = value;
-								selectIdx = i;
-								first = false;
-							}
-							else if(maximise)
-							{
-								if(value > selectValue)
-								{
-									selectValue = value;
-									selectIdx = i;
-								}
-							}
-							else
-							{
-								if(value < selectValue)
-								{
-									selectValue = value;
-									selectIdx = i;
-								}
-							}
-						}
-					}
-					
-					if(selectIdx == 0)
-					{
-						(*iterCoords)->x = coord->x;
-						(*iterCoords)->y = coord->y;
-						(*iterCoords)->z = coord->z;
-					}
-					else if(selectIdx == 1)
-					{
-						change = true;
-						(*iterCoords)->x = coord->x - step;
-						(*iterCoords)->y = coord->y;
-						(*iterCoords)->z = coord->z;
-					}
-					else if(selectIdx == 2)
-					{
-						change = true;
-						(*iterCoords)->x = coord->x;
-						(*iterCoords)->y = coord->y + step;
-						(*iterCoords)->z = coord->z;
-					}
-					else if(selectIdx == 3)
-					{
-						change = true;
-						(*iterCoords)->x = coord->x + step;
-						(*iterCoords)->y = coord->y;
-						(*iterCoords)->z = coord->z;
-					}
-					else if(selectIdx == 4)
-					{
-						change = true;
-						(*iterCoords)->x = coord->x;
-						(*iterCoords)->y = coord->y - step;
-						(*iterCoords)->z = coord->z;
-					}
-					++nodeCount;
-				}	
-				++numIteration;
+					valid[s] = 0;
+				}
+			});
+		}
+		catch(...)
+		{
+			for(unsigned int s = 0; s < this->numStarts; ++s)
+			{
+				deleteCoords(starts[s]);
 			}
-			
-            std::cout << " Complete\n";
-			
-			delete minBoundary;
-			delete coord;			
+			throw;
 		}
-		catch(RSGISOptimisationException &e)
+		
+		unsigned int bestStart = 0;
+		for(unsigned int s = 1; s < this->numStarts; ++s)
+		{
+			if(valid[s] && ((!valid[bestStart]) || (maximise?(values[s] > values[bestStart]):(values[s] < values[bestStart]))))
+			{
+				bestStart = s;
+			}
+		}
+		for(unsigned int s = 0; s < this->numStarts; ++s)
 		{
-			throw e;
+			if(s != bestStart)
+			{
+				deleteCoords(starts[s]);
+			}
 		}
+		std::cout << " Complete (start " << bestStart << ")\n";
 		
-		return outCoords;
+		return starts[bestStart];
 	}
 	
-    std::vector<geos::geom::Coordinate*>* RSGISGlobalHillClimbingOptimiser2D::optimise8Neighbor(std::vector<geos::geom::Coordinate*> *coords, double step, geos::geom::Envelope *boundary)
+	void RSGISGlobalHillClimbingOptimiser2D::climb(std::vector<geos::geom::Coordinate*> *coords, double step, geos::geom::Envelope *minBoundary, bool eightNeighbours, bool verbose)
 	{
-        std::vector<geos::geom::Coordinate*> *outCoords = new std::vector<geos::geom::Coordinate*>();
-		try
+		if(verbose)
 		{
-            std::vector<geos::geom::Coordinate*>::iterator iterCoords;
-			for(iterCoords = coords->begin(); iterCoords != coords->end(); ++iterCoords)
+			std::cout << "Started " << std::flush;
+		}
+		
+		int numIteration = 0;
+		bool change = true;
+		while(change)
+		{
+			if(numIteration == maxNumIterations)
 			{
-				outCoords->push_back(new geos::geom::Coordinate((*iterCoords)->x, (*iterCoords)->y, (*iterCoords)->z));
+				break;
+			}
+			if(verbose)
+			{
+				std::cout << "." << std::flush;
 			}
 			
-			/*
-			 * 0 - Current Pixel
-			 * 1 - X-1
-			 * 2 - X-1 Y+1
-			 * 3 - Y+1
-			 * 4 - X+1 Y+1
-			 * 5 - X+1
-			 * 6 - X+1 Y-1
-			 * 7 - Y-1
-			 * 8 - X-1 Y-1
-			 */
-			double value = 0;
-			double selectValue = 0;
-			int selectIdx = 0;
-			bool first = true;
-			geos::geom::Coordinate *coord = new geos::geom::Coordinate();
-			int numIteration = 0;
-			int nodeCount = 0;
-			
-			geos::geom::Envelope *minBoundary = new geos::geom::Envelope(boundary->getMinX(), (boundary->getMaxX()-step), boundary->getMinY(), (boundary->getMaxY()-step));
-						
-            std::cout << "Started " << std::flush;
-			
-			bool change = true;
-			while(change)
+			change = false;
+			for(size_t i = 0; i < coords->size(); ++i)
 			{
-				if(numIteration == maxNumIterations)
-				{
-					break;
-				}
-                std::cout << "." << std::flush;
-				
-				change = false;
-				nodeCount = 0;
-				for(iterCoords = outCoords->begin(); iterCoords != outCoords->end(); ++iterCoords)
+				if(this->moveNode(coords, i, step, minBoundary, eightNeighbours))
 				{
-					coord->x = (*iterCoords)->x;
-					coord->y = (*iterCoords)->y;
-					coord->z = (*iterCoords)->z;
-					first = true;
-					for(int i = 0; i < 9; ++i)
-					{
-						if(i == 0)
-						{
-							(*iterCoords)->x = coord->x;
-							(*iterCoords)->y = coord->y;
-							(*iterCoords)->z = coord->z;
-						}
-						else if(i == 1)
-						{
-							(*iterCoords)->x = coord->x - step;
-							(*iterCoords)->y = coord->y;
-							(*iterCoords)->z = coord->z;
-						}
-						else if(i == 2)
-						{
-							(*iterCoords)->x = coord->x - step;
-							(*iterCoords)->y = coord->y + step;
-							(*iterCoords)->z = coord->z;
-						}
-						else if(i == 3)
-						{
-							(*iterCoords)->x = coord->x;
-							(*iterCoords)->y = coord->y + step;
-							(*iterCoords)->z = coord->z;
-						}
-						else if(i == 4)
-						{
-							(*iterCoords)->x = coord->x + step;
-							(*iterCoords)->y = coord->y + step;
-							(*iterCoords)->z = coord->z;
-						}
-						else if(i == 5)
-						{
-							(*iterCoords)->x = coord->x + step;
-							(*iterCoords)->y = coord->y;
-							(*iterCoords)->z = coord->z;
-						}
-						else if(i == 6)
-						{
-							(*iterCoords)->x = coord->x + step;
-							(*iterCoords)->y = coord->y - step;
-							(*iterCoords)->z = coord->z;
-						}
-						else if(i == 7)
-						{
-							(*iterCoords)->x = coord->x;
-							(*iterCoords)->y = coord->y - step;
-							(*iterCoords)->z = coord->z;
-						}
-						else if(i == 8)
-						{
-							(*iterCoords)->x = coord->x - step;
-							(*iterCoords)->y = coord->y - step;
-							(*iterCoords)->z = coord->z;
-						}
-						
-						if(minBoundary->contains(**iterCoords))
-						{
-							value = this->func->calcValue(outCoords);
-						}
-						else
-						{
-							value = -1;
-						}
-												
-						if(value != -1)
-						{
-							if(first)
-							{
-								selectValue = value;
-								selectIdx = i;
-								first = false;
-							}
-							else if(maximise)
-							{
-								if(value > selectValue)
-								{
-									selectValue = value;
-									selectIdx = i;
-								}
-							}
-							else
-							{
-								if(value < selectValue)
-								{
-									selectValue = value;
-									selectIdx = i;
-								}
-							}
-						}
-					}
-					
-					if(selectIdx == 0)
-					{
-						(*iterCoords)->x = coord->x;
-						(*iterCoords)->y = coord->y;
-						(*iterCoords)->z = coord->z;
-					}
-					else if(selectIdx == 1)
-					{
-						change = true;
-						(*iterCoords)->x = coord->x - step;
-						(*iterCoords)->y = coord->y;
-						(*iterCoords)->z = coord->z;
-					}
-					else if(selectIdx == 2)
-					{
-						change = true;
-						(*iterCoords)->x = coord->x - step;
-						(*iterCoords)->y = coord->y + step;
-						(*iterCoords)->z = coord->z;
-					}
-					else if(selectIdx == 3)
-					{
-						change = true;
-						(*iterCoords)->x = coord->x;
-						(*iterCoords)->y = coord->y + step;
-						(*iterCoords)->z = coord->z;
-					}
-					else if(selectIdx == 4)
-					{
-						change = true;
-						(*iterCoords)->x = coord->x + step;
-						(*iterCoords)->y = coord->y + step;
-						(*iterCoords)->z = coord->z;
-					}
-					else if(selectIdx == 5)
-					{
-						change = true;
-						(*iterCoords)->x = coord->x + step;
-						(*iterCoords)->y = coord->y;
-						(*iterCoords)->z = coord->z;
-					}
-					else if(selectIdx == 6)
-					{
-						change = true;
-						(*iterCoords)->x = coord->x + step;
-						(*iterCoords)->y = coord->y - step;
-						(*iterCoords)->z = coord->z;
-					}
-					else if(selectIdx == 7)
-					{
-						change = true;
-						(*iterCoords)->x = coord->x;
-						(*iterCoords)->y = coord->y - step;
-						(*iterCoords)->z = coord->z;
-					}
-					else if(selectIdx == 8)
-					{
-						change = true;
-						(*iterCoords)->x = coord->x - step;
-						(*iterCoords)->y = coord->y - step;
-						(*iterCoords)->z = coord->z;
-					}
-					++nodeCount;
+					change = true;
 				}
-				
-				++numIteration;
 			}
+			this->adjustNodes(coords);
 			
-            std::cout << " Complete\n";
-			
-			delete minBoundary;
-			delete coord;			
+			++numIteration;
 		}
-		catch(RSGISOptimisationException &e)
+		
+		if(verbose)
 		{
-			throw e;
+			std::cout << " Complete\n";
 		}
-		
-		return outCoords;
 	}
 	
-	RSGISGlobalHillClimbingOptimiser2D::~RSGISGlobalHillClimbingOptimiser2D()
+	bool RSGISGlobalHillClimbingOptimiser2D::moveNode(std::vector<geos::geom::Coordinate*> *coords, size_t idx, double step, geos::geom::Envelope *minBoundary, bool eightNeighbours)
 	{
+		/*
+		 * 4 neighbours:           8 neighbours:
+		 * 0 - Current Pixel       0 - Current Pixel
+		 * 1 - X-1                 1 - X-1
+		 * 2 - Y+1                 2 - X-1 Y+1
+		 * 3 - X+1                 3 - Y+1
+		 * 4 - Y-1                 4 - X+1 Y+1
+		 *                         5 - X+1
+		 *                         6 - X+1 Y-1
+		 *                         7 - Y-1
+		 *                         8 - X-1 Y-1
+		 */
+		static const int moves4[5][2] = {{0,0}, {-1,0}, {0,1}, {1,0}, {0,-1}};
+		static const int moves8[9][2] = {{0,0}, {-1,0}, {-1,1}, {0,1}, {1,1}, {1,0}, {1,-1}, {0,-1}, {-1,-1}};
+		const int (*moves)[2] = eightNeighbours?moves8:moves4;
+		int numMoves = eightNeighbours?9:5;
 		
+		geos::geom::Coordinate *node = coords->at(idx);
+		double startX = node->x;
+		double startY = node->y;
+		double value = 0;
+		double selectValue = 0;
+		int selectIdx = 0;
+		bool first = true;
+		for(int i = 0; i < numMoves; ++i)
+		{
+			node->x = startX + (moves[i][0] * step);
+			node->y = startY + (moves[i][1] * step);
+			if(this->calcNodeValue(coords, idx, minBoundary, &value))
+			{
+				if(first || (maximise?(value > selectValue):(value < selectValue)))
+				{
+					selectValue = value;
+					selectIdx = i;
+					first = false;
+				}
+			}
+		}
+		node->x = startX + (moves[selectIdx][0] * step);
+		node->y = startY + (moves[selectIdx][1] * step);
+		return (selectIdx != 0);
 	}
 	
-	
-	
-	RSGISGlobalHillClimbingOptimiser2DVaryNumPts::RSGISGlobalHillClimbingOptimiser2DVaryNumPts(RSGISGlobalOptimisationFunction *func, bool maximise, int maxNumIterations) : RSGISGlobalOptimiser2D(func, maximise)
-	{
-		this->maxNumIterations = maxNumIterations;
-	}
-	
-    std::vector<geos::geom::Coordinate*>* RSGISGlobalHillClimbingOptimiser2DVaryNumPts::optimise4Neighbor(std::vector<geos::geom::Coordinate*> *coords, double step, geos::geom::Envelope *boundary)
+	bool RSGISGlobalHillClimbingOptimiser2D::calcNodeValue(std::vector<geos::geom::Coordinate*> *coords, size_t idx, geos::geom::Envelope *minBoundary, double *value)
 	{
-        std::vector<geos::geom::Coordinate*> *outCoords = new std::vector<geos::geom::Coordinate*>();
+		if(!minBoundary->contains(*coords->at(idx)))
+		{
+			return false;
+		}
 		try
 		{
-            std::vector<geos::geom::Coordinate*>::iterator iterCoords;
-			for(iterCoords = coords->begin(); iterCoords != coords->end(); ++iterCoords)
+			if(this->func->hasLocalValue())
 			{
-				outCoords->push_back(new geos::geom::Coordinate((*iterCoords)->x, (*iterCoords)->y, (*iterCoords)->z));
+				*value = this->func->calcLocalValue(coords, idx);
 			}
-			
-			/*
-			 * 0 - Current Pixel
-			 * 1 - X-1
-			 * 2 - Y+1
-			 * 3 - X+1
-			 * 4 - Y-1
-			 */
-			double value = 0;
-			double distance = 0;
-			double selectValue = 0;
-			int selectIdx = 0;
-			bool first = true;
-			geos::geom::Coordinate *coord = new geos::geom::Coordinate();
-			int numIteration = 0;
-			int nodeCount = 0;
-			geos::geom::Coordinate *tmpCoord = NULL;
-			
-			geos::geom::Envelope *minBoundary = new geos::geom::Envelope(boundary->getMinX(), (boundary->getMaxX()-step), boundary->getMinY(), (boundary->getMaxY()-step));
-			
-            std::cout << "Started " << std::flush;
-			
-			bool change = true;
-			while(change)
+			else
 			{
-				if(numIteration == maxNumIterations)
-				{
-					break;
-				}
-                std::cout << "." << std::flush;
-				
-				change = false;
-				nodeCount = 0;
-				
-				for(iterCoords = outCoords->begin(); iterCoords != outCoords->end(); ++iterCoords)
-				{
-					coord->x = (*iterCoords)->x;
-					coord->y = (*iterCoords)->y;
-					coord->z = (*iterCoords)->z;
-					first = true;
-					for(int i = 0; i < 5; ++i)
-					{
-						if(i == 0)
-						{
-							(*iterCoords)->x = coord->x;
-							(*iterCoords)->y = coord->y;
-							(*iterCoords)->z = coord->z;
-						}
-						else if(i == 1)
-						{
-							(*iterCoords)->x = coord->x - step;
-							(*iterCoords)->y = coord->y;
-							(*iterCoords)->z = coord->z;
-						}
-						else if(i == 2)
-						{
-							(*iterCoords)->x = coord->x;
-							(*iterCoords)->y = coord->y + step;
-							(*iterCoords)->z = coord->z;
-						}
-						else if(i == 3)
-						{
-							(*iterCoords)->x = coord->x + step;
-							(*iterCoords)->y = coord->y;
-							(*iterCoords)->z = coord->z;
-						}
-						else if(i == 4)
-						{
-							(*iterCoords)->x = coord->x;
-							(*iterCoords)->y = coord->y - step;
-							(*iterCoords)->z = coord->z;
-						}
-						
-						try 
-						{
-							if(minBoundary->contains(**iterCoords))
-							{
-								value = this->func->calcValue(outCoords);
-							}
-							else
-							{
-								value = -1;
-							}
-						}
-						catch (RSGISOptimisationException &e) 
-						{
-							value = -1;
-						}
-						
-						
-						if(value != -1)
-						{
-							if(first)
-							{
-								selectValue = value;
-								selectIdx = i;
-								first = false;
-							}
-							else if(maximise)
-							{
-								if(value > selectValue)
-								{
-									selectValue = value;
-									selectIdx = i;
-								}
-							}
-							else
-							{
-								if(value < selectValue)
-								{
-									selectValue = value;
-									selectIdx = i;
-								}
-							}
-						}
-					}
-					
-					if(selectIdx == 0)
-					{
-						(*iterCoords)->x = coord->x;
-						(*iterCoords)->y = coord->y;
-						(*iterCoords)->z = coord->z;
-					}
-					else if(selectIdx == 1)
-					{
-						change = true;
-						(*iterCoords)->x = coord->x - step;
-						(*iterCoords)->y = coord->y;
-						(*iterCoords)->z = coord->z;
-					}
-					else if(selectIdx == 2)
-					{
-						change = true;
-						(*iterCoords)->x = coord->x;
-						(*iterCoords)->y = coord->y + step;
-						(*iterCoords)->z = coord->z;
-					}
-					else if(selectIdx == 3)
-					{
-						change = true;
-						(*iterCoords)->x = coord->x + step;
-						(*iterCoords)->y = coord->y;
-						(*iterCoords)->z = coord->z;
-					}
-					else if(selectIdx == 4)
-					{
-						change = true;
-						(*iterCoords)->x = coord->x;
-						(*iterCoords)->y = coord->y - step;
-						(*iterCoords)->z = coord->z;
-					}
-					++nodeCount;
-				}	
-				
-				// Iterate through the coordinate and remove pts which are too
-				// close to one another and introduce new points where gaps are 
-				// too large.
-				
-				first = true;
-				for(iterCoords = outCoords->begin(); iterCoords != outCoords->end(); )
-				{
-					if(first)
-					{
-						coord->x = (*iterCoords)->x;
-						coord->y = (*iterCoords)->y;
-						coord->z = (*iterCoords)->z;
-						first = false;
-					}
-					else
-					{
-						distance = (*iterCoords)->distance(*coord);
-						if((distance < 0.5) & (outCoords->size() > 3))
-						{
-							outCoords->erase(iterCoords);
-						}
-						else if(distance > 3)
-						{
-							float tmpDist = distance/2;
-							tmpCoord = new geos::geom::Coordinate();
-							this->findPointOnLine(coord, (*iterCoords), tmpDist, tmpCoord);
-							iterCoords = outCoords->insert(iterCoords,tmpCoord);
-						}
-						else 
-						{
-							coord->x = (*iterCoords)->x;
-							coord->y = (*iterCoords)->y;
-							coord->z = (*iterCoords)->z;
-							++iterCoords;
-						}
-					}					
-				}
-				
-				++numIteration;
+				*value = this->func->calcValue(coords);
 			}
-			
-            std::cout << " Complete\n";
-			
-			delete minBoundary;
-			delete coord;			
 		}
 		catch(RSGISOptimisationException &e)
 		{
-			throw e;
+			if(!this->invalidOnError)
+			{
+				throw;
+			}
+			return false;
 		}
+		return true;
+	}
+	
+	RSGISGlobalHillClimbingOptimiser2D::~RSGISGlobalHillClimbingOptimiser2D()
+	{
 		
-		return outCoords;
 	}
 	
-    std::vector<geos::geom::Coordinate*>* RSGISGlobalHillClimbingOptimiser2DVaryNumPts::optimise8Neighbor(std::vector<geos::geom::Coordinate*> *coords, double step, geos::geom::Envelope *boundary)
+	
+	
+	RSGISGlobalHillClimbingOptimiser2DVaryNumPts::RSGISGlobalHillClimbingOptimiser2DVaryNumPts(RSGISGlobalOptimisationFunction *func, bool maximise, int maxNumIterations) : RSGISGlobalHillClimbingOptimiser2D(func, maximise, maxNumIterations)
 	{
-        std::vector<geos::geom::Coordinate*> *outCoords = new std::vector<geos::geom::Coordinate*>();
-		try
+		this->invalidOnError = true;
+	}
+	
+	void RSGISGlobalHillClimbingOptimiser2DVaryNumPts::adjustNodes(std::vector<geos::geom::Coordinate*> *coords)
+	{
+		// Iterate through the coordinate and remove pts which are too
+		// close to one another and introduce new points where gaps are 
+		// too large.
+		geos::geom::Coordinate prevCoord;
+		bool first = true;
+		double distance = 0;
+		for(std::vector<geos::geom::Coordinate*>::iterator iterCoords = coords->begin(); iterCoords != coords->end(); )
 		{
-            std::vector<geos::geom::Coordinate*>::iterator iterCoords;
-			for(iterCoords = coords->begin(); iterCoords != coords->end(); ++iterCoords)
+			if(first)
 			{
-				outCoords->push_back(new geos::geom::Coordinate((*iterCoords)->x, (*iterCoords)->y, (*iterCoords)->z));
+				prevCoord = **iterCoords;
+				first = false;
+				++iterCoords;
 			}
-			
-			/*
-			 * 0 - Current Pixel
-			 * 1 - X-1
-			 * 2 - X-1 Y+1
-			 * 3 - Y+1
-			 * 4 - X+1 Y+1
-			 * 5 - X+1
-			 * 6 - X+1 Y-1
-			 * 7 - Y-1
-			 * 8 - X-1 Y-1
-			 */
-			double value = 0;
-			double selectValue = 0;
-			double distance = 0;
-			int selectIdx = 0;
-			bool first = true;
-			geos::geom::Coordinate *coord = new geos::geom::Coordinate();
-			geos::geom::Coordinate *tmpCoord = NULL;
-			int numIteration = 0;
-			int nodeCount = 0;
-			
-			geos::geom::Envelope *minBoundary = new geos::geom::Envelope(boundary->getMinX(), (boundary->getMaxX()-step), boundary->getMinY(), (boundary->getMaxY()-step));
-			
-            std::cout << "Started " << std::flush;
-			
-			bool change = true;
-			while(change)
+			else
 			{
-				if(numIteration == maxNumIterations)
+				distance = (*iterCoords)->distance(prevCoord);
+				if((distance < 0.5) & (coords->size() > 3))
 				{
-					break;
+					delete *iterCoords;
+					iterCoords = coords->erase(iterCoords);
 				}
-                std::cout << "." << std::flush;
-				
-				change = false;
-				nodeCount = 0;
-				
-				for(iterCoords = outCoords->begin(); iterCoords != outCoords->end(); ++iterCoords)
+				else if(distance > 3)
 				{
-					coord->x = (*iterCoords)->x;
-					coord->y = (*iterCoords)->y;
-					coord->z = (*iterCoords)->z;
-					first = true;
-					for(int i = 0; i < 9; ++i)
-					{
-						if(i == 0)
-						{
-							(*iterCoords)->x = coord->x;
-							(*iterCoords)->y = coord->y;
-							(*iterCoords)->z = coord->z;
-						}
-						else if(i == 1)
-						{
-							(*iterCoords)->x = coord->x - step;
-							(*iterCoords)->y = coord->y;
-							(*iterCoords)->z = coord->z;
-						}
-						else if(i == 2)
-						{
-							(*iterCoords)->x = coord->x - step;
-							(*iterCoords)->y = coord->y + step;
-							(*iterCoords)->z = coord->z;
-						}
-						else if(i == 3)
-						{
-							(*iterCoords)->x = coord->x;
-							(*iterCoords)->y = coord->y + step;
-							(*iterCoords)->z = coord->z;
-						}
-						else if(i == 4)
-						{
-							(*iterCoords)->x = coord->x + step;
-							(*iterCoords)->y = coord->y + step;
-							(*iterCoords)->z = coord->z;
-						}
-						else if(i == 5)
-						{
-							(*iterCoords)->x = coord->x + step;
-							(*iterCoords)->y = coord->y;
-							(*iterCoords)->z = coord->z;
-						}
-						else if(i == 6)
-						{
-							(*iterCoords)->x = coord->x + step;
-							(*iterCoords)->y = coord->y - step;
-							(*iterCoords)->z = coord->z;
-						}
-						else if(i == 7)
-						{
-							(*iterCoords)->x = coord->x;
-							(*iterCoords)->y = coord->y - step;
-							(*iterCoords)->z = coord->z;
-						}
-						else if(i == 8)
-						{
-							(*iterCoords)->x = coord->x - step;
-							(*iterCoords)->y = coord->y - step;
-							(*iterCoords)->z = coord->z;
-						}
-						
-						try 
-						{
-							if(minBoundary->contains(**iterCoords))
-							{
-								value = this->func->calcValue(outCoords);
-							}
-							else
-							{
-								value = -1;
-							}
-						}
-						catch (RSGISOptimisationException &e) 
-						{
-							value = -1;
-						}
-						
-						if(value != -1)
-						{
-							if(first)
-							{
-								selectValue = value;
-								selectIdx = i;
-								first = false;
-							}
-							else if(maximise)
-							{
-								if(value > selectValue)
-								{
-									selectValue = value;
-									selectIdx = i;
-								}
-							}
-							else
-							{
-								if(value < selectValue)
-								{
-									selectValue = value;
-									selectIdx = i;
-								}
-							}
-						}
-					}
-					
-					if(selectIdx == 0)
-					{
-						(*iterCoords)->x = coord->x;
-						(*iterCoords)->y = coord->y;
-						(*iterCoords)->z = coord->z;
-					}
-					else if(selectIdx == 1)
-					{
-						change = true;
-						(*iterCoords)->x = coord->x - step;
-						(*iterCoords)->y = coord->y;
-						(*iterCoords)->z = coord->z;
-					}
-					else if(selectIdx == 2)
-					{
-						change = true;
-						(*iterCoords)->x = coord->x - step;
-						(*iterCoords)->y = coord->y + step;
-						(*iterCoords)->z = coord->z;
-					}
-					else if(selectIdx == 3)
-					{
-						change = true;
-						(*iterCoords)->x = coord->x;
-						(*iterCoords)->y = coord->y + step;
-						(*iterCoords)->z = coord->z;
-					}
-					else if(selectIdx == 4)
-					{
-						change = true;
-						(*iterCoords)->x = coord->x + step;
-						(*iterCoords)->y = coord->y + step;
-						(*iterCoords)->z = coord->z;
-					}
-					else if(selectIdx == 5)
-					{
-						change = true;
-						(*iterCoords)->x = coord->x + step;
-						(*iterCoords)->y = coord->y;
-						(*iterCoords)->z = coord->z;
-					}
-					else if(selectIdx == 6)
-					{
-						change = true;
-						(*iterCoords)->x = coord->x + step;
-						(*iterCoords)->y = coord->y - step;
-						(*iterCoords)->z = coord->z;
-					}
-					else if(selectIdx == 7)
-					{
-						change = true;
-						(*iterCoords)->x = coord->x;
-						(*iterCoords)->y = coord->y - step;
-						(*iterCoords)->z = coord->z;
-					}
-					else if(selectIdx == 8)
-					{
-						change = true;
-						(*iterCoords)->x = coord->x - step;
-						(*iterCoords)->y = coord->y - step;
-						(*iterCoords)->z = coord->z;
-					}
-					++nodeCount;
+					float tmpDist = distance/2;
+					geos::geom::Coordinate *tmpCoord = new geos::geom::Coordinate();
+					this->findPointOnLine(&prevCoord, (*iterCoords), tmpDist, tmpCoord);
+					iterCoords = coords->insert(iterCoords,tmpCoord);
 				}
-				
-				// Iterate through the coordinate and remove pts which are too
-				// close to one another and introduce new points where gaps are 
-				// too large.
-				
-				first = true;
-				for(iterCoords = outCoords->begin(); iterCoords != outCoords->end(); )
+				else 
 				{
-					if(first)
-					{
-						coord->x = (*iterCoords)->x;
-						coord->y = (*iterCoords)->y;
-						coord->z = (*iterCoords)->z;
-						first = false;
-					}
-					else
-					{
-						distance = (*iterCoords)->distance(*coord);
-						if((distance < 0.5) & (outCoords->size() > 3))
-						{
-							outCoords->erase(iterCoords);
-						}
-						else if(distance > 3)
-						{
-							float tmpDist = distance/2;
-							tmpCoord = new geos::geom::Coordinate();
-							this->findPointOnLine(coord, (*iterCoords), tmpDist, tmpCoord);
-							iterCoords = outCoords->insert(iterCoords,tmpCoord);
-						}
-						else 
-						{
-							coord->x = (*iterCoords)->x;
-							coord->y = (*iterCoords)->y;
-							coord->z = (*iterCoords)->z;
-							++iterCoords;
-						}
-					}					
+					prevCoord = **iterCoords;
+					++iterCoords;
 				}
-				
-				
-				
-				++numIteration;
 			}
-            std::cout << " Complete\n";
-			
-			delete minBoundary;
-			delete coord;	
 		}
-		catch(RSGISOptimisationException &e)
-		{
-			throw e;
-		}
-		
-		return outCoords;
 	}
 	
 	void RSGISGlobalHillClimbingOptimiser2DVaryNumPts::findPointOnLine(geos::geom::Coordinate *p1, geos::geom::Coordinate *p2, float distance, geos::geom::Coordinate *p3)
@@ -972,4 +364,3 @@ namespace rsgis{namespace math{
 		
 	}
 }}
-
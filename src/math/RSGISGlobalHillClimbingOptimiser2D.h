@@ -25,9 +25,17 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <random>
+#include <algorithm>
+#include <cstdlib>
 #include <math.h>
 
 #include "common/rsgis-tqdm.h"
+#include "common/RSGISParallel.h"
 
 #include "math/RSGISGlobalOptimiser2D.h"
 #include "math/RSGISGlobalOptimisationFunction.h"
@@ -51,26 +59,61 @@
 
 namespace rsgis{namespace math{
 	
+	/**
+	 * Moves each node of a contour in turn by step to whichever of its 4 or 8
+	 * neighbouring positions (or where it is) gives the best value of the
+	 * function, until no node moves or after maxNumIterations passes. When the
+	 * function provides local values (RSGISGlobalOptimisationFunction::hasLocalValue)
+	 * the moves of a node are compared using only the terms which depend on it.
+	 *
+	 * With setMultiStart the climb is also run from numStarts - 1 copies of the
+	 * contour with each node displaced by up to startOffset (drawn from a generator
+	 * seeded with the start number) and the result with the best value is returned
+	 * (the earliest start if equal). If the function is thread safe the starts are
+	 * shared among threads (setNumThreads or RSGISLIB_NUM_THREADS); the result does
+	 * not depend on the number of threads.
+	 */
 	class DllExport RSGISGlobalHillClimbingOptimiser2D : public RSGISGlobalOptimiser2D
 		{
 		public:
 			RSGISGlobalHillClimbingOptimiser2D(RSGISGlobalOptimisationFunction *func, bool maximise, int maxNumIterations);
+			void setMultiStart(unsigned int numStarts, double startOffset);
+			/**
+			 * The number of threads (0 uses the number of cores).
+			 */
+			void setNumThreads(unsigned int numThreads);
 			virtual std::vector<geos::geom::Coordinate*>* optimise4Neighbor(std::vector<geos::geom::Coordinate*> *coords, double step, geos::geom::Envelope *boundary);
 			virtual std::vector<geos::geom::Coordinate*>* optimise8Neighbor(std::vector<geos::geom::Coordinate*> *coords, double step, geos::geom::Envelope *boundary);
 			virtual ~RSGISGlobalHillClimbingOptimiser2D();
-		private:
+		protected:
+			std::vector<geos::geom::Coordinate*>* optimise(std::vector<geos::geom::Coordinate*> *coords, double step, geos::geom::Envelope *boundary, bool eightNeighbours);
+			void climb(std::vector<geos::geom::Coordinate*> *coords, double step, geos::geom::Envelope *minBoundary, bool eightNeighbours, bool verbose);
+			/** Move the node to its best position, returning true if it moved. */
+			bool moveNode(std::vector<geos::geom::Coordinate*> *coords, size_t idx, double step, geos::geom::Envelope *minBoundary, bool eightNeighbours);
+			bool calcNodeValue(std::vector<geos::geom::Coordinate*> *coords, size_t idx, geos::geom::Envelope *minBoundary, double *value);
+			/** Called after each pass over the nodes. */
+			virtual void adjustNodes(std::vector<geos::geom::Coordinate*> *coords){};
 			int maxNumIterations;
+			unsigned int numStarts;
+			double startOffset;
+			unsigned int numThreads;
+			// Treat positions where the function throws a RSGISOptimisationException as invalid.
+			bool invalidOnError;
 		};
 	
-	class DllExport RSGISGlobalHillClimbingOptimiser2DVaryNumPts : public RSGISGlobalOptimiser2D
+	/**
+	 * As RSGISGlobalHillClimbingOptimiser2D but, after each pass, nodes closer
+	 * than 0.5 to the previous node are removed and nodes are added where the
+	 * gap is greater than 3.
+	 */
+	class DllExport RSGISGlobalHillClimbingOptimiser2DVaryNumPts : public RSGISGlobalHillClimbingOptimiser2D
 	{
 	public:
 		RSGISGlobalHillClimbingOptimiser2DVaryNumPts(RSGISGlobalOptimisationFunction *func, bool maximise, int maxNumIterations);
-		virtual std::vector<geos::geom::Coordinate*>* optimise4Neighbor(std::vector<geos::geom::Coordinate*> *coords, double step, geos::geom::Envelope *boundary);
-		virtual std::vector<geos::geom::Coordinate*>* optimise8Neighbor(std::vector<geos::geom::Coordinate*> *coords, double step, geos::geom::Envelope *boundary);
 		virtual ~RSGISGlobalHillClimbingOptimiser2DVaryNumPts();
+	protected:
+		virtual void adjustNodes(std::vector<geos::geom::Coordinate*> *coords);
 	private:
-		int maxNumIterations;
 		void findPointOnLine(geos::geom::Coordinate *p1, geos::geom::Coordinate *p2, float distance, geos::geom::Coordinate *p3);
 	};
 }}
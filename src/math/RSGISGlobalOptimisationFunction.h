@@ -25,6 +25,7 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
 #include <math.h>
 
 #include "math/RSGISOptimisationException.h"
@@ -50,6 +51,16 @@ namespace rsgis{namespace math{
 		{
 		public:
 			virtual double calcValue(std::vector<geos::geom::Coordinate*> *coords) = 0;
+			/** True if calcLocalValue is implemented. */
+			virtual bool hasLocalValue(){return false;};
+			/**
+			 * The sum of the terms of calcValue which depend on coordinate idx, so
+			 * positions of that coordinate alone can be compared without
+			 * evaluating the whole contour.
+			 */
+			virtual double calcLocalValue(std::vector<geos::geom::Coordinate*> *coords, size_t idx){throw RSGISOptimisationException("Not Implemented - RSGISGlobalOptimisationFunction Base Class");};
+			/** True if calcValue and calcLocalValue can be called from several threads at once. */
+			virtual bool isThreadSafe(){return false;};
 			virtual ~RSGISGlobalOptimisationFunction(){};
 		};
 }}
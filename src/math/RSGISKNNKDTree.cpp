@@ -0,0 +1,276 @@
+/*
+ *  RSGISKNNKDTree.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2015 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISKNNKDTree.h"
+
+namespace rsgis{namespace math{
+
+    RSGISKNNKDTree::RSGISKNNKDTree(double **pts, size_t nPts, size_t sIdx, size_t eIdx, rsgisdistmetrics distMetric, double **covarMatrix, unsigned int leafSize)
+    {
+        if(!RSGISKNNKDTree::supportsMetric(distMetric))
+        {
+            throw RSGISMathException("The distance metric is not supported by the KD-tree.");
+        }
+        if(eIdx <= sIdx)
+        {
+            throw RSGISMathException("The KD-tree needs at least one dimension.");
+        }
+        this->distMetric = distMetric;
+        this->nPts = nPts;
+        this->sIdx = sIdx;
+        this->nDims = eIdx - sIdx;
+        this->leafSize = (leafSize == 0)?1:leafSize;
+        // The manhatten metric of RSGISCalcManhattenDistMetric is sqrt(sum(|diff|)/n).
+        this->useL1 = (distMetric == rsgis_manhatten);
+
+        if(distMetric == rsgis_mahalanobis)
+        {
+            if(covarMatrix == NULL)
+            {
+                throw RSGISMathException("A covariance matrix is needed for the mahalanobis distance.");
+            }
+            // Cholesky decomposition, covar = L L^T, so |L^-1 (x-y)|^2 is the squared mahalanobis distance.
+            this->choleskyL.assign(this->nDims * this->nDims, 0.0);
+            for(unsigned int i = 0; i < this->nDims; ++i)
+            {
+                for(unsigned int j = 0; j <= i; ++j)
+                {
+                    double sum = covarMatrix[i][j];
+                    for(unsigned int n = 0; n < j; ++n)
+                    {
+                        sum -= this->choleskyL[(i*this->nDims)+n] * this->choleskyL[(j*this->nDims)+n];
+                    }
+                    if(i == j)
+                    {
+                        if(sum <= 0)
+                        {
+                            throw RSGISMathException("The covariance matrix is not positive definite.");
+                        }
+                        this->choleskyL[(i*this->nDims)+i] = sqrt(sum);
+                    }
+                    else
+                    {
+                        this->choleskyL[(i*this->nDims)+j] = sum / this->choleskyL[(j*this->nDims)+j];
+                    }
+                }
+            }
+        }
+
+        std::vector<double> ptVals(this->nPts * this->nDims, 0.0);
+        this->ptIdxs.resize(this->nPts);
+        for(size_t i = 0; i < this->nPts; ++i)
+        {
+            this->whitenPoint(&pts[i][sIdx], &ptVals[i*this->nDims]);
+            this->ptIdxs[i] = i;
+        }
+
+        if(this->nPts > 0)
+        {
+            this->buildNode(0, this->nPts, ptVals);
+        }
+
+        // Store the points in tree order so each leaf is contiguous in memory.
+        this->coords.resize(this->nPts * this->nDims);
+        for(size_t i = 0; i < this->nPts; ++i)
+        {
+            std::copy(&ptVals[this->ptIdxs[i]*this->nDims], &ptVals[this->ptIdxs[i]*this->nDims] + this->nDims, &this->coords[i*this->nDims]);
+        }
+    }
+
+    bool RSGISKNNKDTree::supportsMetric(rsgisdistmetrics distMetric)
+    {
+        return (distMetric == rsgis_euclidean) || (distMetric == rsgis_manhatten) || (distMetric == rsgis_mahalanobis);
+    }
+
+    size_t RSGISKNNKDTree::buildNode(size_t start, size_t end, const std::vector<double> &ptVals)
+    {
+        size_t nodeIdx = this->nodes.size();
+        RSGISKDTreeNode node;
+        node.start = start;
+        node.end = end;
+        node.splitDim = 0;
+        node.splitVal = 0;
+        node.left = 0;
+        node.right = 0;
+        node.leaf = ((end - start) <= this->leafSize);
+        this->nodes.push_back(node);
+        if(node.leaf)
+        {
+            return nodeIdx;
+        }
+
+        // Split on the dimension with the largest spread.
+        unsigned int nDims = this->nDims;
+        unsigned int splitDim = 0;
+        double maxSpread = -1;
+        for(unsigned int d = 0; d < nDims; ++d)
+        {
+            double minVal = ptVals[(this->ptIdxs[start]*nDims)+d];
+            double maxVal = minVal;
+            for(size_t i = start+1; i < end; ++i)
+            {
+                double val = ptVals[(this->ptIdxs[i]*nDims)+d];
+                if(val < minVal)
+                {
+                    minVal = val;
+                }
+                else if(val > maxVal)
+                {
+                    maxVal = val;
+                }
+            }
+            if((maxVal - minVal) > maxSpread)
+            {
+                maxSpread = maxVal - minVal;
+                splitDim = d;
+            }
+        }
+
+        size_t mid = start + ((end - start) / 2);
+        std::nth_element(this->ptIdxs.begin()+start, this->ptIdxs.begin()+mid, this->ptIdxs.begin()+end, [&ptVals, nDims, splitDim](size_t a, size_t b)
+        {
+            return ptVals[(a*nDims)+splitDim] < ptVals[(b*nDims)+splitDim];
+        });
+
+        // Set before building the children as they reorder the indexes.
+        this->nodes[nodeIdx].splitDim = splitDim;
+        this->nodes[nodeIdx].splitVal = ptVals[(this->ptIdxs[mid]*nDims)+splitDim];
+        size_t left = this->buildNode(start, mid, ptVals);
+        size_t right = this->buildNode(mid, end, ptVals);
+        this->nodes[nodeIdx].left = left;
+        this->nodes[nodeIdx].right = right;
+        return nodeIdx;
+    }
+
+    void RSGISKNNKDTree::findKNearest(double *query, unsigned int k, double maxDist, std::vector<std::pair<double, size_t> > *kNearest) const
+    {
+        kNearest->clear();
+        if((k == 0) || (this->nPts == 0))
+        {
+            return;
+        }
+
+        std::vector<double> queryVals(this->nDims);
+        this->whitenPoint(&query[this->sIdx], queryVals.data());
+
+        // Max-heap of the current k nearest, by reduced distance.
+        std::vector<KNNItem> heap;
+        heap.reserve(k+1);
+        this->searchNode(0, queryVals.data(), k, this->distToReduced(maxDist), &heap);
+
+        std::sort_heap(heap.begin(), heap.end());
+        for(std::vector<KNNItem>::iterator iterItem = heap.begin(); iterItem != heap.end(); ++iterItem)
+        {
+            kNearest->push_back(std::pair<double, size_t>(this->reducedToDist((*iterItem).first), this->ptIdxs[(*iterItem).second]));
+        }
+    }
+
+    void RSGISKNNKDTree::searchNode(size_t nodeIdx, const double *query, unsigned int k, double maxRDist, std::vector<KNNItem> *heap) const
+    {
+        const RSGISKDTreeNode &node = this->nodes[nodeIdx];
+        if(node.leaf)
+        {
+            for(size_t i = node.start; i < node.end; ++i)
+            {
+                double bound = (heap->size() < k)?maxRDist:heap->front().first;
+                const double *pt = &this->coords[i*this->nDims];
+                double rDist = 0;
+                for(unsigned int d = 0; (d < this->nDims) && (rDist < bound); ++d)
+                {
+                    rDist += this->axisRDist(query[d] - pt[d]);
+                }
+                if(rDist < bound)
+                {
+                    if(heap->size() == k)
+                    {
+                        std::pop_heap(heap->begin(), heap->end());
+                        heap->pop_back();
+                    }
+                    heap->push_back(KNNItem(rDist, i));
+                    std::push_heap(heap->begin(), heap->end());
+                }
+            }
+            return;
+        }
+
+        double diff = query[node.splitDim] - node.splitVal;
+        size_t nearNode = (diff < 0)?node.left:node.right;
+        size_t farNode = (diff < 0)?node.right:node.left;
+        this->searchNode(nearNode, query, k, maxRDist, heap);
+        double bound = (heap->size() < k)?maxRDist:heap->front().first;
+        if(this->axisRDist(diff) < bound)
+        {
+            this->searchNode(farNode, query, k, maxRDist, heap);
+        }
+    }
+
+    void RSGISKNNKDTree::whitenPoint(const double *vals, double *out) const
+    {
+        if(this->choleskyL.empty())
+        {
+            std::copy(vals, vals+this->nDims, out);
+            return;
+        }
+        // Forward substitution, out = L^-1 vals.
+        for(unsigned int i = 0; i < this->nDims; ++i)
+        {
+            double sum = vals[i];
+            for(unsigned int j = 0; j < i; ++j)
+            {
+                sum -= this->choleskyL[(i*this->nDims)+j] * out[j];
+            }
+            out[i] = sum / this->choleskyL[(i*this->nDims)+i];
+        }
+    }
+
+    double RSGISKNNKDTree::axisRDist(double diff) const
+    {
+        return this->useL1?fabs(diff):(diff*diff);
+    }
+
+    double RSGISKNNKDTree::reducedToDist(double rDist) const
+    {
+        if(this->distMetric == rsgis_mahalanobis)
+        {
+            return sqrt(rDist);
+        }
+        return sqrt(rDist/this->nDims);
+    }
+
+    double RSGISKNNKDTree::distToReduced(double dist) const
+    {
+        if(dist <= 0)
+        {
+            return 0;
+        }
+        if(this->distMetric == rsgis_mahalanobis)
+        {
+            return dist * dist;
+        }
+        return dist * dist * this->nDims;
+    }
+
+    RSGISKNNKDTree::~RSGISKNNKDTree()
+    {
+
+    }
+
+}}
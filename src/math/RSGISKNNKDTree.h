@@ -0,0 +1,109 @@
+/*
+ *  RSGISKNNKDTree.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2015 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISKNNKDTree_H
+#define RSGISKNNKDTree_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+#include "math/RSGISMathsUtils.h"
+#include "math/RSGISMathException.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_maths_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace math{
+
+    /**
+     * A KD-tree over a set of points for k nearest neighbour queries. The
+     * distances returned match those of the RSGISCalcDistMetric classes for
+     * the euclidean, manhatten and mahalanobis metrics. For the mahalanobis
+     * metric the points are whitened with the Cholesky factor of the
+     * covariance matrix so the tree is searched with euclidean distances.
+     *
+     * Queries do not modify the tree so can be run concurrently.
+     */
+    class DllExport RSGISKNNKDTree
+    {
+    public:
+        /**
+         * Build the tree from nPts points, using values sIdx to eIdx-1 of each
+         * point. The covariance matrix ((eIdx-sIdx) square) is required for
+         * the mahalanobis metric. The points are copied so do not need to be
+         * kept for the lifetime of the tree.
+         */
+        RSGISKNNKDTree(double **pts, size_t nPts, size_t sIdx, size_t eIdx, rsgisdistmetrics distMetric, double **covarMatrix=NULL, unsigned int leafSize=16);
+        static bool supportsMetric(rsgisdistmetrics distMetric);
+        /**
+         * Find the (up to) k points with a distance to query values sIdx to
+         * eIdx-1 less than maxDist. The result is sorted nearest first as
+         * pairs of distance and point index.
+         */
+        void findKNearest(double *query, unsigned int k, double maxDist, std::vector<std::pair<double, size_t> > *kNearest) const;
+        size_t getNumPts() const {return nPts;};
+        ~RSGISKNNKDTree();
+    protected:
+        struct RSGISKDTreeNode
+        {
+            size_t start;
+            size_t end;
+            unsigned int splitDim;
+            double splitVal;
+            size_t left;
+            size_t right;
+            bool leaf;
+        };
+        typedef std::pair<double, size_t> KNNItem;
+        size_t buildNode(size_t start, size_t end, const std::vector<double> &ptVals);
+        void searchNode(size_t nodeIdx, const double *query, unsigned int k, double maxRDist, std::vector<KNNItem> *heap) const;
+        void whitenPoint(const double *vals, double *out) const;
+        double axisRDist(double diff) const;
+        double reducedToDist(double rDist) const;
+        double distToReduced(double dist) const;
+        rsgisdistmetrics distMetric;
+        size_t nPts;
+        size_t sIdx;
+        unsigned int nDims;
+        unsigned int leafSize;
+        bool useL1;
+        std::vector<double> coords;
+        std::vector<size_t> ptIdxs;
+        std::vector<double> choleskyL;
+        std::vector<RSGISKDTreeNode> nodes;
+    };
+
+}}
+
+#endif
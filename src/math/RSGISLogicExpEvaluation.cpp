@@ -22,6 +22,8 @@
 
 #include "RSGISLogicExpEvaluation.h"
 
+#include <algorithm>
+
 namespace rsgis{namespace math{
 
 
@@ -343,6 +345,288 @@ namespace rsgis{namespace math{
         return outVal;
     }
     
+    void RSGISLogicAndExpression::compile(RSGISLogicProgram *prog)
+    {
+        for(std::vector<RSGISLogicExpression*>::iterator iterExps = exps->begin(); iterExps != exps->end(); ++iterExps)
+        {
+            (*iterExps)->compile(prog);
+        }
+        prog->addOperation(rsgis_logic_and, exps->size());
+    }
+    
+    void RSGISLogicOrExpression::compile(RSGISLogicProgram *prog)
+    {
+        for(std::vector<RSGISLogicExpression*>::iterator iterExps = exps->begin(); iterExps != exps->end(); ++iterExps)
+        {
+            (*iterExps)->compile(prog);
+        }
+        prog->addOperation(rsgis_logic_or, exps->size());
+    }
+    
+    void RSGISLogicNotExpression::compile(RSGISLogicProgram *prog)
+    {
+        exp->compile(prog);
+        prog->addOperation(rsgis_logic_not, 1);
+    }
+    
+    void RSGISLogicEqualsExpression::compile(RSGISLogicProgram *prog)
+    {
+        for(std::vector<RSGISLogicExpression*>::iterator iterExps = exps->begin(); iterExps != exps->end(); ++iterExps)
+        {
+            (*iterExps)->compile(prog);
+        }
+        prog->addOperation(rsgis_logic_equal, exps->size());
+    }
+    
+    void RSGISLogicEqualsValueExpression::compile(RSGISLogicProgram *prog)
+    {
+        prog->addCompare(rsgis_logic_eq, val1, val2);
+    }
+    
+    void RSGISLogicGreaterThanValueExpression::compile(RSGISLogicProgram *prog)
+    {
+        prog->addCompare(rsgis_logic_gt, val1, val2);
+    }
+    
+    void RSGISLogicLessThanValueExpression::compile(RSGISLogicProgram *prog)
+    {
+        prog->addCompare(rsgis_logic_lt, val1, val2);
+    }
+    
+    void RSGISLogicGreaterEqualToValueExpression::compile(RSGISLogicProgram *prog)
+    {
+        prog->addCompare(rsgis_logic_gteq, val1, val2);
+    }
+    
+    void RSGISLogicLessEqualToValueExpression::compile(RSGISLogicProgram *prog)
+    {
+        prog->addCompare(rsgis_logic_lteq, val1, val2);
+    }
+    
+    void RSGISLogicNotValueExpression::compile(RSGISLogicProgram *prog)
+    {
+        prog->addCompare(rsgis_logic_noteq, val1, val2);
+    }
+    
+    
+    RSGISLogicProgram::RSGISLogicProgram(RSGISLogicExpression *exp, size_t chunkSize)
+    {
+        this->chunkSize = (chunkSize == 0)?1:chunkSize;
+        this->stackDepth = 0;
+        this->maxStackDepth = 0;
+        exp->compile(this);
+        if(this->stackDepth != 1)
+        {
+            throw RSGISMathLogicException("The compiled logic expression does not produce a single value.");
+        }
+        this->stackVals.resize(this->maxStackDepth * this->chunkSize);
+        this->stackErrs.resize(this->maxStackDepth * this->chunkSize);
+        this->tmpMask.resize(this->chunkSize);
+    }
+    
+    unsigned int RSGISLogicProgram::getOperandIdx(double *address)
+    {
+        for(unsigned int i = 0; i < this->operandAddrs.size(); ++i)
+        {
+            if(this->operandAddrs.at(i) == address)
+            {
+                return i;
+            }
+        }
+        this->operandAddrs.push_back(address);
+        this->operandVals.push_back(NULL);
+        this->constVals.resize(this->constVals.size() + this->chunkSize);
+        return this->operandAddrs.size()-1;
+    }
+    
+    void RSGISLogicProgram::addCompare(RSGISLogicOpCode op, double *val1, double *val2)
+    {
+        if(op > rsgis_logic_lteq)
+        {
+            throw RSGISMathLogicException("A comparison must be eq, noteq, gt, lt, gteq or lteq.");
+        }
+        RSGISLogicInstruction instruct;
+        instruct.op = op;
+        instruct.val1Idx = this->getOperandIdx(val1);
+        instruct.val2Idx = this->getOperandIdx(val2);
+        instruct.numChildren = 0;
+        this->instructions.push_back(instruct);
+        
+        ++this->stackDepth;
+        this->maxStackDepth = std::max(this->maxStackDepth, this->stackDepth);
+    }
+    
+    void RSGISLogicProgram::addOperation(RSGISLogicOpCode op, unsigned int numChildren)
+    {
+        if(op < rsgis_logic_and)
+        {
+            throw RSGISMathLogicException("Comparisons should be added with addCompare.");
+        }
+        if((numChildren == 0) | (numChildren > this->stackDepth) | ((op == rsgis_logic_not) & (numChildren != 1)))
+        {
+            throw RSGISMathLogicException("The number of child expressions is not valid for the operation.");
+        }
+        RSGISLogicInstruction instruct;
+        instruct.op = op;
+        instruct.val1Idx = 0;
+        instruct.val2Idx = 0;
+        instruct.numChildren = numChildren;
+        this->instructions.push_back(instruct);
+        
+        this->stackDepth = this->stackDepth - (numChildren - 1);
+    }
+    
+    void RSGISLogicProgram::bindValues(double *address, const double *values)
+    {
+        bool found = false;
+        for(unsigned int i = 0; i < this->operandAddrs.size(); ++i)
+        {
+            if(this->operandAddrs.at(i) == address)
+            {
+                this->operandVals.at(i) = values;
+                found = true;
+            }
+        }
+        if(!found)
+        {
+            throw RSGISMathLogicException("The value address is not used within the logic expression.");
+        }
+    }
+    
+    void RSGISLogicProgram::evaluate(size_t startIdx, size_t numVals, unsigned char *outVals, unsigned char *outErrs)
+    {
+        size_t numOperands = this->operandAddrs.size();
+        std::vector<const double*> opVals(numOperands, NULL);
+        for(size_t i = 0; i < numOperands; ++i)
+        {
+            if(this->operandVals.at(i) == NULL)
+            {
+                std::fill(this->constVals.begin() + (i * this->chunkSize), this->constVals.begin() + ((i+1) * this->chunkSize), *this->operandAddrs.at(i));
+            }
+        }
+        
+        bool foundErr = false;
+        for(size_t chunkStart = 0; chunkStart < numVals; chunkStart += this->chunkSize)
+        {
+            size_t n = std::min(this->chunkSize, numVals - chunkStart);
+            for(size_t i = 0; i < numOperands; ++i)
+            {
+                if(this->operandVals.at(i) == NULL)
+                {
+                    opVals.at(i) = &this->constVals[i * this->chunkSize];
+                }
+                else
+                {
+                    opVals.at(i) = this->operandVals.at(i) + startIdx + chunkStart;
+                }
+            }
+            
+            unsigned int sp = 0;
+            for(std::vector<RSGISLogicInstruction>::iterator iterInst = this->instructions.begin(); iterInst != this->instructions.end(); ++iterInst)
+            {
+                if((*iterInst).numChildren == 0)
+                {
+                    const double *a = opVals.at((*iterInst).val1Idx);
+                    const double *b = opVals.at((*iterInst).val2Idx);
+                    unsigned char *v = &this->stackVals[sp * this->chunkSize];
+                    unsigned char *e = &this->stackErrs[sp * this->chunkSize];
+                    switch((*iterInst).op)
+                    {
+                        case rsgis_logic_eq:
+                            for(size_t k = 0; k < n; ++k){v[k] = (a[k] == b[k]);}
+                            break;
+                        case rsgis_logic_noteq:
+                            for(size_t k = 0; k < n; ++k){v[k] = (a[k] != b[k]);}
+                            break;
+                        case rsgis_logic_gt:
+                            for(size_t k = 0; k < n; ++k){v[k] = (a[k] > b[k]);}
+                            break;
+                        case rsgis_logic_lt:
+                            for(size_t k = 0; k < n; ++k){v[k] = (a[k] < b[k]);}
+                            break;
+                        case rsgis_logic_gteq:
+                            for(size_t k = 0; k < n; ++k){v[k] = (a[k] >= b[k]);}
+                            break;
+                        case rsgis_logic_lteq:
+                            for(size_t k = 0; k < n; ++k){v[k] = (a[k] <= b[k]);}
+                            break;
+                        default:
+                            throw RSGISMathLogicException("Comparison operator not recognised.");
+                    }
+                    for(size_t k = 0; k < n; ++k){e[k] = (boost::math::isnan)(a[k]) | (boost::math::isnan)(b[k]);}
+                    ++sp;
+                }
+                else
+                {
+                    unsigned int base = sp - (*iterInst).numChildren;
+                    unsigned char *v0 = &this->stackVals[base * this->chunkSize];
+                    unsigned char *e0 = &this->stackErrs[base * this->chunkSize];
+                    unsigned char *r = &this->tmpMask[0];
+                    if((*iterInst).op == rsgis_logic_not)
+                    {
+                        for(size_t k = 0; k < n; ++k){v0[k] = !v0[k];}
+                    }
+                    else if((*iterInst).op == rsgis_logic_and)
+                    {
+                        // v0 is true while all the children so far are true, i.e., while the next child would be evaluated.
+                        for(unsigned int c = 1; c < (*iterInst).numChildren; ++c)
+                        {
+                            unsigned char *vc = &this->stackVals[(base + c) * this->chunkSize];
+                            unsigned char *ec = &this->stackErrs[(base + c) * this->chunkSize];
+                            for(size_t k = 0; k < n; ++k){e0[k] |= v0[k] & ec[k]; v0[k] &= vc[k];}
+                        }
+                    }
+                    else if((*iterInst).op == rsgis_logic_or)
+                    {
+                        // r is true while no child so far is true.
+                        for(size_t k = 0; k < n; ++k){r[k] = !v0[k];}
+                        for(unsigned int c = 1; c < (*iterInst).numChildren; ++c)
+                        {
+                            unsigned char *vc = &this->stackVals[(base + c) * this->chunkSize];
+                            unsigned char *ec = &this->stackErrs[(base + c) * this->chunkSize];
+                            for(size_t k = 0; k < n; ++k){e0[k] |= r[k] & ec[k]; r[k] &= !vc[k];}
+                        }
+                        for(size_t k = 0; k < n; ++k){v0[k] = !r[k];}
+                    }
+                    else if((*iterInst).op == rsgis_logic_equal)
+                    {
+                        // r is true while all the children so far equal the first.
+                        for(size_t k = 0; k < n; ++k){r[k] = 1;}
+                        for(unsigned int c = 1; c < (*iterInst).numChildren; ++c)
+                        {
+                            unsigned char *vc = &this->stackVals[(base + c) * this->chunkSize];
+                            unsigned char *ec = &this->stackErrs[(base + c) * this->chunkSize];
+                            for(size_t k = 0; k < n; ++k){e0[k] |= r[k] & ec[k]; r[k] &= (vc[k] == v0[k]);}
+                        }
+                        for(size_t k = 0; k < n; ++k){v0[k] = r[k];}
+                    }
+                    else
+                    {
+                        throw RSGISMathLogicException("Logic operation not recognised.");
+                    }
+                    sp = base + 1;
+                }
+            }
+            
+            std::copy(this->stackVals.begin(), this->stackVals.begin() + n, outVals + chunkStart);
+            if(outErrs != NULL)
+            {
+                std::copy(this->stackErrs.begin(), this->stackErrs.begin() + n, outErrs + chunkStart);
+            }
+            else
+            {
+                for(size_t k = 0; k < n; ++k)
+                {
+                    foundErr = foundErr | (this->stackErrs[k] != 0);
+                }
+                if(foundErr)
+                {
+                    throw RSGISMathLogicException("A value within the logic expression is NaN.");
+                }
+            }
+        }
+    }
+    
     
 }}
 
@@ -51,11 +51,17 @@ namespace rsgis{namespace math{
     };
     
     
+    class RSGISLogicProgram;
+    
 	class DllExport RSGISLogicExpression
     {
     public:
         RSGISLogicExpression(std::string expName){this->expName = expName;};
         virtual bool evaluate() = 0;
+        /**
+         * Append the expression (children first) to a compiled program.
+         */
+        virtual void compile(RSGISLogicProgram *prog){throw RSGISMathLogicException("The expression '" + expName + "' cannot be compiled.");};
         std::string getExpName(){return expName;};
         virtual ~RSGISLogicExpression(){};
     protected:
@@ -71,6 +77,7 @@ namespace rsgis{namespace math{
             this->exps = exps;
         };
         bool evaluate();
+        void compile(RSGISLogicProgram *prog);
         ~RSGISLogicAndExpression()
         {
             for(std::vector<RSGISLogicExpression*>::iterator iterExps = exps->begin(); iterExps != exps->end(); ++iterExps)
@@ -91,6 +98,7 @@ namespace rsgis{namespace math{
             this->exps = exps;
         };
         bool evaluate();
+        void compile(RSGISLogicProgram *prog);
         ~RSGISLogicOrExpression()
         {
             for(std::vector<RSGISLogicExpression*>::iterator iterExps = exps->begin(); iterExps != exps->end(); ++iterExps)
@@ -111,6 +119,7 @@ namespace rsgis{namespace math{
             this->exp = exp;
         };
         bool evaluate();
+        void compile(RSGISLogicProgram *prog);
         ~RSGISLogicNotExpression()
         {
             delete exp;
@@ -127,6 +136,7 @@ namespace rsgis{namespace math{
             this->exps = exps;
         };
         bool evaluate();
+        void compile(RSGISLogicProgram *prog);
         ~RSGISLogicEqualsExpression()
         {
             for(std::vector<RSGISLogicExpression*>::iterator iterExps = exps->begin(); iterExps != exps->end(); ++iterExps)
@@ -148,6 +158,7 @@ namespace rsgis{namespace math{
             this->val2 = val2;
         };
         bool evaluate();
+        void compile(RSGISLogicProgram *prog);
         ~RSGISLogicEqualsValueExpression(){};
     protected:
         double *val1;
@@ -163,6 +174,7 @@ namespace rsgis{namespace math{
             this->val2 = val2;
         };
         bool evaluate();
+        void compile(RSGISLogicProgram *prog);
         
         ~RSGISLogicGreaterThanValueExpression(){};
     protected:
@@ -180,6 +192,7 @@ namespace rsgis{namespace math{
             this->val2 = val2;
         };
         bool evaluate();
+        void compile(RSGISLogicProgram *prog);
         ~RSGISLogicLessThanValueExpression(){};
     protected:
         double *val1;
@@ -196,6 +209,7 @@ namespace rsgis{namespace math{
             this->val2 = val2;
         };
         bool evaluate();
+        void compile(RSGISLogicProgram *prog);
         ~RSGISLogicGreaterEqualToValueExpression(){};
     protected:
         double *val1;
@@ -212,6 +226,7 @@ namespace rsgis{namespace math{
             this->val2 = val2;
         };
         bool evaluate();
+        void compile(RSGISLogicProgram *prog);
         ~RSGISLogicLessEqualToValueExpression(){};
     protected:
         double *val1;
@@ -227,6 +242,7 @@ namespace rsgis{namespace math{
             this->val2 = val2;
         };
         bool evaluate();
+        void compile(RSGISLogicProgram *prog);
         ~RSGISLogicNotValueExpression(){};
     protected:
         double *val1;
@@ -234,6 +250,73 @@ namespace rsgis{namespace math{
     };
     
     
+    enum DllExport RSGISLogicOpCode
+    {
+        rsgis_logic_eq = 0,
+        rsgis_logic_noteq = 1,
+        rsgis_logic_gt = 2,
+        rsgis_logic_lt = 3,
+        rsgis_logic_gteq = 4,
+        rsgis_logic_lteq = 5,
+        rsgis_logic_and = 6,
+        rsgis_logic_or = 7,
+        rsgis_logic_equal = 8,
+        rsgis_logic_not = 9
+    };
+    
+    struct DllExport RSGISLogicInstruction
+    {
+        RSGISLogicOpCode op;
+        unsigned int val1Idx;
+        unsigned int val2Idx;
+        unsigned int numChildren;
+    };
+    
+    /**
+     * A logic expression tree compiled to a flat postfix program which is
+     * evaluated a column at a time: for a chunk of rows each comparison is a
+     * loop over contiguous arrays producing a byte mask, and and/or/equal/not
+     * combine the masks of their children.
+     *
+     * The comparisons are identified by the value addresses the expression was
+     * built with (e.g., RSGISColumnLogicIdxs::col1Val); bindValues gives the
+     * array of values to read for an address (element i for row i). Addresses
+     * which are not bound are constants (e.g., a threshold) read when evaluate
+     * is called.
+     *
+     * The result is the same as calling evaluate() on the tree for each row,
+     * including the exception for NaN values, which is only raised where the
+     * short-circuiting tree evaluation would have reached the comparison. Use
+     * one program per thread; the evaluation buffers are held by the object.
+     */
+    class DllExport RSGISLogicProgram
+    {
+    public:
+        RSGISLogicProgram(RSGISLogicExpression *exp, size_t chunkSize=4096);
+        void addCompare(RSGISLogicOpCode op, double *val1, double *val2);
+        void addOperation(RSGISLogicOpCode op, unsigned int numChildren);
+        void bindValues(double *address, const double *values);
+        /**
+         * Evaluate rows startIdx to startIdx+numVals-1 of the bound arrays, writing
+         * 1 (true) or 0 (false) to outVals[0..numVals-1]. If outErrs is provided it
+         * is set to 1 for the rows where the tree evaluation would have thrown (NaN
+         * values) and no exception is thrown.
+         */
+        void evaluate(size_t startIdx, size_t numVals, unsigned char *outVals, unsigned char *outErrs=NULL);
+        ~RSGISLogicProgram(){};
+    protected:
+        unsigned int getOperandIdx(double *address);
+        std::vector<RSGISLogicInstruction> instructions;
+        std::vector<double*> operandAddrs;
+        std::vector<const double*> operandVals;
+        size_t chunkSize;
+        unsigned int stackDepth;
+        unsigned int maxStackDepth;
+        std::vector<unsigned char> stackVals;
+        std::vector<unsigned char> stackErrs;
+        std::vector<unsigned char> tmpMask;
+        std::vector<double> constVals;
+    };
     
 }}
 
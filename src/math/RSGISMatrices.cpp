@@ -115,53 +115,46 @@ namespace rsgis{namespace math{
         }
     }
 	
+	gsl_matrix_view RSGISMatrices::viewAsGSLMatrix(Matrix *matrix)
+	{
+		return gsl_matrix_view_array(matrix->matrix, matrix->m, matrix->n);
+	}
+	
 	double RSGISMatrices::determinant(Matrix *matrix)
 	{
-		double sum = 0;
 		if(matrix->n != matrix->m)
 		{
 			throw RSGISMatricesException("To calculate a determinant the matrix needs to be symatical");
 		}
 		
-		if(matrix->n == 2)
+		const double *a = matrix->matrix;
+		double det = 0;
+		if(matrix->n == 1)
+		{
+			det = a[0];
+		}
+		else if(matrix->n == 2)
 		{
-			sum = (matrix->matrix[0] * matrix->matrix[3]) - (matrix->matrix[1] * matrix->matrix[2]);
+			det = (a[0] * a[3]) - (a[1] * a[2]);
+		}
+		else if(matrix->n == 3)
+		{
+			det = (a[0] * ((a[4] * a[8]) - (a[5] * a[7]))) - (a[1] * ((a[3] * a[8]) - (a[5] * a[6]))) + (a[2] * ((a[3] * a[7]) - (a[4] * a[6])));
 		}
 		else
 		{
-			Matrix *tmpMatrix = NULL;
-			double value = 0;
-			int index = 0;
-			for(int i = 0; i < matrix->n; i++)
-			{
-
-				index = 0;
-				tmpMatrix = this->createMatrix((matrix->n-1), (matrix->m-1));
-				
-				// Populate new matrix
-				for(int n = 1; n < matrix->n; n++)
-				{
-					for(int m = 0; m < matrix->m; m++)
-					{
-						if(i == m)
-						{
-							continue;
-						}
-						
-						tmpMatrix->matrix[index] = matrix->matrix[(n*matrix->n)+m];
-						index++;
-					}
-				}
-				// Calculate the determinant of the new matrix
-				value = this->determinant(tmpMatrix);
-				
-				// add to sum
-				sum = sum + (pow(-1.0,i) * value * matrix->matrix[i]);
-				
-				this->freeMatrix(tmpMatrix);
-			}
+			// LU decomposition (with partial pivoting) of a copy of the matrix.
+			gsl_matrix_view inView = this->viewAsGSLMatrix(matrix);
+			gsl_matrix *luMatrix = gsl_matrix_alloc(matrix->n, matrix->n);
+			gsl_matrix_memcpy(luMatrix, &inView.matrix);
+			gsl_permutation *perm = gsl_permutation_alloc(matrix->n);
+			int signum = 0;
+			gsl_linalg_LU_decomp(luMatrix, perm, &signum);
+			det = gsl_linalg_LU_det(luMatrix, signum);
+			gsl_permutation_free(perm);
+			gsl_matrix_free(luMatrix);
 		}
-		return sum;
+		return det;
 	}
 	
 	Matrix* RSGISMatrices::cofactors(Matrix *matrix)
@@ -170,33 +163,74 @@ namespace rsgis{namespace math{
 		{
 			throw RSGISMatricesException("To calculate cofactors the matrix needs to be symatical");
 		}
-		Matrix *newMatrix = NULL;
-		newMatrix = this->createMatrix(matrix->n, matrix->m);
+		int size = matrix->n;
+		Matrix *newMatrix = this->createMatrix(size, size);
+		if(size == 1)
+		{
+			newMatrix->matrix[0] = 1;
+			return newMatrix;
+		}
+		
+		if(size > 3)
+		{
+			// For a non-singular matrix the cofactors are det(A) * inverse(A)^T,
+			// found from a single LU decomposition.
+			gsl_matrix_view inView = this->viewAsGSLMatrix(matrix);
+			gsl_matrix *luMatrix = gsl_matrix_alloc(size, size);
+			gsl_matrix_memcpy(luMatrix, &inView.matrix);
+			gsl_permutation *perm = gsl_permutation_alloc(size);
+			int signum = 0;
+			gsl_linalg_LU_decomp(luMatrix, perm, &signum);
+			double det = gsl_linalg_LU_det(luMatrix, signum);
+			bool inverted = false;
+			if((det != 0) && boost::math::isfinite(det))
+			{
+				gsl_matrix *invMatrix = gsl_matrix_alloc(size, size);
+				gsl_linalg_LU_invert(luMatrix, perm, invMatrix);
+				for(int i = 0; i < size; i++)
+				{
+					for(int j = 0; j < size; j++)
+					{
+						newMatrix->matrix[(i*size)+j] = det * gsl_matrix_get(invMatrix, j, i);
+					}
+				}
+				gsl_matrix_free(invMatrix);
+				inverted = true;
+			}
+			gsl_permutation_free(perm);
+			gsl_matrix_free(luMatrix);
+			if(inverted)
+			{
+				return newMatrix;
+			}
+		}
 		
+		// Small or singular matrices: the determinant of each minor.
 		int index = 0;
-		Matrix *tmpMatrix = this->createMatrix((matrix->n-1), (matrix->m-1));
-		for(int i = 0; i < matrix->n; i++)
+		Matrix *tmpMatrix = this->createMatrix((size-1), (size-1));
+		for(int i = 0; i < size; i++)
 		{
-			for(int j = 0; j < matrix->m; j++)
+			for(int j = 0; j < size; j++)
 			{
 				index = 0;
-				for(int n = 0; n < matrix->n; n++)
+				for(int n = 0; n < size; n++)
 				{
 					if(i == n)
 					{
 						continue;
 					}
-					for(int m = 0; m < matrix->m; m++)
+					for(int m = 0; m < size; m++)
 					{
 						if(j == m)
 						{
 							continue;
 						}
-						tmpMatrix->matrix[index] = matrix->matrix[(n*matrix->n)+m];
+						tmpMatrix->matrix[index] = matrix->matrix[(n*size)+m];
 						index++;
 					}
 				}
-				newMatrix->matrix[(i*matrix->n)+j] = (pow(-1.0,((i*matrix->n)+j))) * this->determinant(tmpMatrix);
+				double sign = (((i + j) % 2) == 0)?1.0:-1.0;
+				newMatrix->matrix[(i*size)+j] = sign * this->determinant(tmpMatrix);
 			}
 		}
 		this->freeMatrix(tmpMatrix);
@@ -205,15 +239,10 @@ namespace rsgis{namespace math{
 	
 	Matrix* RSGISMatrices::transpose(Matrix *matrix)
 	{
-		Matrix *newMatrix = NULL;
-		newMatrix = this->createMatrix(matrix->m, matrix->n);
-		for(int i = 0; i < matrix->n; i++)
-		{
-			for(int j = 0; j < matrix->m; j++)
-			{
-				newMatrix->matrix[i+(j*matrix->n)] = matrix->matrix[(i*matrix->n)+j];
-			}
-		}
+		Matrix *newMatrix = this->createMatrix(matrix->m, matrix->n);
+		gsl_matrix_view inView = this->viewAsGSLMatrix(matrix);
+		gsl_matrix_view outView = this->viewAsGSLMatrix(newMatrix);
+		gsl_matrix_transpose_memcpy(&outView.matrix, &inView.matrix);
 		return newMatrix;
 	}
 
@@ -312,27 +341,10 @@ namespace rsgis{namespace math{
 		}
         
 		Matrix *newMatrix = this->createMatrix(matrix2->n, matrix1->m);
-		
-		double value = 0;
-		int row = 0;
-		int col = 0;
-		int index = 0;
-		for(int i = 0; i < matrix1->m; i++)
-		{
-			for(int j = 0; j < matrix2->n; j++)
-			{
-				value = 0;
-				for(int n = 0; n < matrix1->n; n++)
-				{
-					row = (i * matrix1->n) + n;
-					col = (n * matrix2->n) + j;
-
-                    value += matrix1->matrix[row] * matrix2->matrix[col];
-				}
-				newMatrix->matrix[index] = value;
-				index++;
-			}
-		}
+		gsl_matrix_view view1 = this->viewAsGSLMatrix(matrix1);
+		gsl_matrix_view view2 = this->viewAsGSLMatrix(matrix2);
+		gsl_matrix_view outView = this->viewAsGSLMatrix(newMatrix);
+		gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, &view1.matrix, &view2.matrix, 0.0, &outView.matrix);
 		
 		return newMatrix;
 	}
@@ -584,189 +596,114 @@ namespace rsgis{namespace math{
 		matrixOutput.close();
 	}
 	
-	Matrix* RSGISMatrices::readMatrixFromTxt(std::string filepath)
+	Matrix* RSGISMatrices::readMatrixFromTxt(std::string filepath, bool useCache)
 	{
-		Matrix *matrix = new Matrix();
-		std::ifstream inputMatrix;
-		inputMatrix.open(filepath.c_str());
-		if(!inputMatrix.is_open())
-		{
-			throw RSGISInputStreamException("Could not open input text file.");
-		}
-		else
-		{
-			std::string strLine;
-			std::string word;
-			int number;
-			float value;
-			int lineCounter = 0;
-			inputMatrix.seekg(std::ios_base::beg);
-			while(!inputMatrix.eof())
-			{
-				getline(inputMatrix, strLine, '\n');
-				if(strLine.length() > 0)
-				{
-					if(lineCounter == 0)
-					{
-						// m
-						word = strLine.substr(2);
-						number = strtol(word.c_str(), NULL, 10);
-						matrix->m = number;
-					}
-					else if(lineCounter == 1)
-					{
-						// n
-						word = strLine.substr(2);
-						number = strtol(word.c_str(), NULL, 10);
-						matrix->n = number;
-					}
-					else if(lineCounter == 2)
-					{
-						// data
-						int dataCounter = 0;
-						int start = 0;
-						int lineLength = strLine.length();
-						int numDataPoints = matrix->n*matrix->m;
-						matrix->matrix = new double[numDataPoints];
-						for(int i = 0; i < lineLength; i++)
-						{
-							if(strLine.at(i) == ',')
-							{
-								word = strLine.substr(start, i-start);								
-								value = strtod(word.c_str(), NULL);
-								if(boost::math::isnan(value))
-								{
-									value = 0;
-								}
-								matrix->matrix[dataCounter] = value;
-								dataCounter++;
-								
-								start = start + i-start+1;
-							}
-							
-							if(dataCounter >= numDataPoints)
-							{
-								throw RSGISMatricesException("Too many data values, compared to header.");
-							}
-						}
-						word = strLine.substr(start);
-						value = strtod(word.c_str(), NULL);
-						matrix->matrix[dataCounter] = value;
-						dataCounter++;
-												
-						if(dataCounter != (matrix->n*matrix->m))
-						{
-							throw RSGISMatricesException("An incorrect number of data points were read in.");
-						}
-						
-					}
-					else
-					{
-						break;
-					}
-				}
-				lineCounter++;
-			}
-			
-			if(lineCounter < 3)
-			{
-				throw RSGISMatricesException("A complete matrix has not been reconstructed.");
-			}
-			inputMatrix.close();
-		}
-		return matrix;
+		return this->readMatrixValuesFromTxt(filepath, false, useCache);
 	}
 	
-	Matrix* RSGISMatrices::readMatrixFromGridTxt(std::string filepath)
+	Matrix* RSGISMatrices::readMatrixFromGridTxt(std::string filepath, bool useCache)
 	{
-		Matrix *matrix = new Matrix();
-		std::ifstream inputMatrix;
-		inputMatrix.open(filepath.c_str());
-		if(!inputMatrix.is_open())
+		return this->readMatrixValuesFromTxt(filepath, true, useCache);
+	}
+	
+	Matrix* RSGISMatrices::readMatrixValuesFromTxt(std::string filepath, bool grid, bool useCache)
+	{
+		std::vector<int64_t> header;
+		std::vector<double> values;
+		if(useCache && rsgis::RSGISTextScanner::readValuesCache(filepath, &header, &values))
 		{
-			throw RSGISInputStreamException("Could not open input text file.");
+			if((header.size() == 2) && (header[0] > 0) && (header[1] > 0) && (values.size() == ((size_t)(header[0] * header[1]))))
+			{
+				Matrix *matrix = this->createMatrix(header[1], header[0]);
+				std::copy(values.begin(), values.end(), matrix->matrix);
+				return matrix;
+			}
+			header.clear();
+			values.clear();
 		}
-		else
+		
+		rsgis::RSGISTextScanner scanner;
+		scanner.openFile(filepath);
+		
+		int m = 0;
+		int n = 0;
+		int lineCounter = 0;
+		const char *lineStart = NULL;
+		const char *lineEnd = NULL;
+		while(scanner.nextLine(&lineStart, &lineEnd))
 		{
-			std::string strLine;
-			std::string wholeline;
-			std::string word;
-			int number;
-			float value;
-			int lineCounter = 0;
-			bool first = true;
-			inputMatrix.seekg(std::ios_base::beg);
-			while(!inputMatrix.eof())
+			if(lineStart == lineEnd)
 			{
-				getline(inputMatrix, strLine, '\n');
-				if(strLine.length() > 0)
+				continue;
+			}
+			
+			if(lineCounter < 2)
+			{
+				// m= and n=
+				if((lineEnd - lineStart) < 3)
 				{
-					if(lineCounter == 0)
-					{
-						// m
-						word = strLine.substr(2);
-						number = strtol(word.c_str(), NULL, 10);
-						matrix->m = number;
-					}
-					else if(lineCounter == 1)
-					{
-						// n
-						word = strLine.substr(2);
-						number = strtol(word.c_str(), NULL, 10);
-						matrix->n = number;
-					}
-					else 
+					throw RSGISMatricesException("The matrix header was not recognised.");
+				}
+				int number = strtol(lineStart + 2, NULL, 10);
+				if(lineCounter == 0)
+				{
+					m = number;
+				}
+				else
+				{
+					n = number;
+					if((m < 1) || (n < 1))
 					{
-						if(first)
-						{
-							wholeline = strLine;
-							first = false;
-						}
-						else 
-						{
-							wholeline = wholeline + std::string(",") + strLine;
-						}
+						throw RSGISMatricesException("Sizes of m and n must be at least 1.");
 					}
-					lineCounter++;
+					values.reserve(((size_t)m) * n);
 				}
 			}
-			inputMatrix.close();
-			
-			// data
-			int dataCounter = 0;
-			int start = 0;
-			int lineLength = wholeline.length();;
-			int numDataPoints = matrix->n*matrix->m;
-			matrix->matrix = new double[numDataPoints];
-			
-			for(int i = 0; i < lineLength; i++)
+			else if(grid || (lineCounter == 2))
 			{
-				if(wholeline.at(i) == ',')
-				{
-					word = wholeline.substr(start, i-start);								
-					value = strtod(word.c_str(), NULL);
-					matrix->matrix[dataCounter] = value;
-					dataCounter++;
-					
-					start = start + i-start+1;
-				}
-				
-				if(dataCounter >= numDataPoints)
+				// data; either a single line or (grid) a line per row.
+				rsgis::RSGISTextScanner::parseValues(lineStart, lineEnd, ',', &values);
+				if(values.size() > (((size_t)m) * n))
 				{
 					throw RSGISMatricesException("Too many data values, compared to header.");
 				}
 			}
-			
-			word = wholeline.substr(start);
-			value = strtod(word.c_str(), NULL);
-			matrix->matrix[dataCounter] = value;
-			dataCounter++;
-			
-			if(dataCounter != (matrix->n*matrix->m))
+			else
+			{
+				break;
+			}
+			lineCounter++;
+		}
+		scanner.closeFile();
+		
+		if(lineCounter < 3)
+		{
+			throw RSGISMatricesException("A complete matrix has not been reconstructed.");
+		}
+		if(values.size() != (((size_t)m) * n))
+		{
+			throw RSGISMatricesException("An incorrect number of data points were read in.");
+		}
+		if(!grid)
+		{
+			for(std::vector<double>::iterator iterVal = values.begin(); iterVal != values.end(); ++iterVal)
 			{
-				throw RSGISMatricesException("An incorrect number of data points were read in.");
+				if(boost::math::isnan(*iterVal))
+				{
+					*iterVal = 0;
+				}
 			}
 		}
+		
+		if(useCache)
+		{
+			header.push_back(m);
+			header.push_back(n);
+			rsgis::RSGISTextScanner::writeValuesCache(filepath, header, values);
+		}
+		
+		Matrix *matrix = this->createMatrix(n, m);
+		std::copy(values.begin(), values.end(), matrix->matrix);
 		return matrix;
 	}
 	
@@ -807,21 +744,21 @@ namespace rsgis{namespace math{
 		return matrix;
 	}
 	
-	gsl_matrix* RSGISMatrices::readGSLMatrixFromTxt(std::string filepath)
+	gsl_matrix* RSGISMatrices::readGSLMatrixFromTxt(std::string filepath, bool useCache)
 	{
 		Matrix *rsgisMatrix;
 		gsl_matrix *gslMatrix;
-		rsgisMatrix = this->readMatrixFromTxt(filepath);
+		rsgisMatrix = this->readMatrixFromTxt(filepath, useCache);
 		gslMatrix = this->convertRSGIS2GSLMatrix(rsgisMatrix);
 		this->freeMatrix(rsgisMatrix);
 		return gslMatrix;
 	}
 
-	gsl_matrix* RSGISMatrices::readGSLMatrixFromGridTxt(std::string filepath)
+	gsl_matrix* RSGISMatrices::readGSLMatrixFromGridTxt(std::string filepath, bool useCache)
 	{
 		Matrix *rsgisMatrix;
 		gsl_matrix *gslMatrix;
-		rsgisMatrix = this->readMatrixFromGridTxt(filepath);
+		rsgisMatrix = this->readMatrixFromGridTxt(filepath, useCache);
 		gslMatrix = this->convertRSGIS2GSLMatrix(rsgisMatrix);
 		this->freeMatrix(rsgisMatrix);
 		return gslMatrix;
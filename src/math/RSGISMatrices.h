@@ -26,6 +26,9 @@
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
 #include <math.h>
 #include <gsl/gsl_matrix.h>
 #include <gsl/gsl_vector.h>
@@ -34,9 +37,13 @@
 #include "math/RSGISMatricesException.h"
 #include "common/RSGISInputStreamException.h"
 #include "common/RSGISOutputStreamException.h"
+#include "common/RSGISTextScanner.h"
 
 #include <gsl/gsl_eigen.h>
 #include <gsl/gsl_math.h>
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_linalg.h>
+#include <gsl/gsl_permutation.h>
 
 #include <boost/math/special_functions/fpclassify.hpp>
 
@@ -84,13 +91,30 @@ namespace rsgis{namespace math{
 			Matrix* copyMatrix(Matrix *matrix);
 			void freeMatrix(Matrix *matrix);
             void setValues(Matrix *matrix, double val);
+			/**
+			 * A gsl_matrix view of the data of the matrix (not a copy), with
+			 * matrix->m rows of matrix->n values as used by multiplication and
+			 * transpose, so the GSL (BLAS) functions can be used on it directly.
+			 */
+			gsl_matrix_view viewAsGSLMatrix(Matrix *matrix);
+			/**
+			 * The determinant of a square matrix; matrices larger than 3 x 3 use
+			 * an LU decomposition rather than cofactor expansion.
+			 */
 			double determinant(Matrix *matrix);
+			/**
+			 * The cofactors of a square matrix, from the inverse (LU decomposition)
+			 * for non-singular matrices larger than 3 x 3.
+			 */
 			Matrix* cofactors(Matrix *matrix);
 			Matrix* transpose(Matrix *matrix);
 			void transposeGSL(gsl_matrix *inMatrix, gsl_matrix *outMatrix);
 			void transposeNonSquareGSL(gsl_matrix *inMatrix, gsl_matrix *outMatrix);
 			void inv2x2GSLMatrix(gsl_matrix * inMatrix, gsl_matrix *outMatrix);
 			void multipleSingle(Matrix *matrix, double multiple);
+			/**
+			 * The product of the matrices (BLAS dgemm on views of the matrices).
+			 */
 			Matrix* multiplication(Matrix *matrixA, Matrix *matrixB);
 			void productMatrixVectorGSL(gsl_matrix *inMatrix, gsl_vector *inVector, gsl_vector *outVector);
 			void printMatrix(Matrix *matrix);
@@ -104,11 +128,17 @@ namespace rsgis{namespace math{
 			void saveGSLMatrix2Txt(gsl_matrix *gslMatrix, std::string filepath);
 			void saveGSLMatrix2CSV(gsl_matrix *gslMatrix, std::string filepath);
             void exportAsImage(Matrix *matrix, std::string filepath, std::string format="KEA");
-			Matrix* readMatrixFromTxt(std::string filepath);
-			Matrix* readMatrixFromGridTxt(std::string filepath);
+			/**
+			 * Read a matrix text file (m= and n= lines followed by the values).
+			 * If useCache is true the values are read from a binary cache
+			 * alongside the file (see rsgis::RSGISTextScanner) when it is up to
+			 * date and otherwise the cache is written after parsing the text.
+			 */
+			Matrix* readMatrixFromTxt(std::string filepath, bool useCache=false);
+			Matrix* readMatrixFromGridTxt(std::string filepath, bool useCache=false);
 			Matrix* readMatrixFromBinary(std::string filepath);
-			gsl_matrix* readGSLMatrixFromTxt(std::string filepath);
-			gsl_matrix* readGSLMatrixFromGridTxt(std::string filepath);
+			gsl_matrix* readGSLMatrixFromTxt(std::string filepath, bool useCache=false);
+			gsl_matrix* readGSLMatrixFromGridTxt(std::string filepath, bool useCache=false);
 			gsl_matrix* readGSLMatrixFromBinary(std::string filepath);
 			void calcEigenVectorValue(Matrix *matrix, Matrix *eigenvalues, Matrix *eigenvectors);
 			Matrix* normalisedMatrix(Matrix *matrix, double min, double max);
@@ -120,6 +150,11 @@ namespace rsgis{namespace math{
             void makeCircularBinaryMatrix(Matrix *matrix);
 			~RSGISMatrices();
         protected:
+            /**
+             * Read the values of a matrix text file; grid files have a line per
+             * row rather than all the values on one line.
+             */
+            Matrix* readMatrixValuesFromTxt(std::string filepath, bool grid, bool useCache);
             std::string getFileExt(std::string filepath)
             {
                 int strSize = filepath.size();
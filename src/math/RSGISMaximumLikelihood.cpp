@@ -470,5 +470,197 @@ namespace rsgis {namespace math{
     }
     
     
+    const size_t RSGISMaximumLikelihoodClassifier::tileSize;
+    
+    RSGISMaximumLikelihoodClassifier::RSGISMaximumLikelihoodClassifier(MaximumLikelihood *ml)
+    {
+        this->numClasses = ml->nclasses;
+        this->numFeatures = ml->d;
+        this->numThreads = rsgis::utils::getNumThreads();
+        
+        const unsigned int nf = this->numFeatures;
+        this->classIDs.assign(ml->classes, ml->classes + this->numClasses);
+        this->means.resize(((size_t)this->numClasses) * nf);
+        this->chols.assign(((size_t)this->numClasses) * nf * nf, 0.0);
+        this->logConsts.resize(this->numClasses);
+        for(unsigned int c = 0; c < this->numClasses; ++c)
+        {
+            for(unsigned int i = 0; i < nf; ++i)
+            {
+                this->means[(c*nf)+i] = ml->mean[c][i];
+            }
+            
+            // Cholesky-Banachiewicz, covar = L L^T
+            double *L = &this->chols[((size_t)c)*nf*nf];
+            double logDet = 0;
+            for(unsigned int i = 0; i < nf; ++i)
+            {
+                for(unsigned int j = 0; j <= i; ++j)
+                {
+                    double sum = ml->covar[c][i][j];
+                    for(unsigned int k = 0; k < j; ++k)
+                    {
+                        sum -= L[(i*nf)+k] * L[(j*nf)+k];
+                    }
+                    if(i == j)
+                    {
+                        if(!(sum > 0.0))
+                        {
+                            std::string msg = std::string("RSGISMaximumLikelihoodClassifier: cov. matrix of class ") + NumberToString(ml->classes[c]) + " is not positive definite";
+                            throw RSGISMaximumLikelihoodException(msg);
+                        }
+                        L[(i*nf)+i] = sqrt(sum);
+                        logDet += 2.0 * log(L[(i*nf)+i]);
+                    }
+                    else
+                    {
+                        L[(i*nf)+j] = sum / L[(j*nf)+j];
+                    }
+                }
+            }
+            for(unsigned int i = 0; i < nf; ++i)
+            {
+                L[(i*nf)+i] = 1.0 / L[(i*nf)+i];
+            }
+            this->logConsts[c] = log(ml->priors[c]) - (0.5 * logDet);
+        }
+    }
+    
+    void RSGISMaximumLikelihoodClassifier::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+    
+    void RSGISMaximumLikelihoodClassifier::classify(const float* const* featPlanes, size_t nPts, int *classes, float *posteriors) const
+    {
+        if((nPts == 0) || (this->numClasses == 0))
+        {
+            return;
+        }
+        
+        const size_t nTiles = (nPts + tileSize - 1) / tileSize;
+        rsgis::utils::RSGISWorkerPool pool(std::max<unsigned int>(1, std::min<size_t>(this->numThreads, nTiles)));
+        std::vector<std::vector<double> > zPlanes(pool.getNumThreads());
+        std::vector<std::vector<double> > scorePlanes(pool.getNumThreads());
+        pool.parallelFor(nTiles, [&](size_t tile, unsigned int t)
+        {
+            zPlanes[t].resize(((size_t)this->numFeatures) * tileSize);
+            scorePlanes[t].resize(((size_t)this->numClasses) * tileSize);
+            size_t start = tile * tileSize;
+            this->classifyTile(featPlanes, start, std::min(tileSize, nPts - start), nPts, zPlanes[t].data(), scorePlanes[t].data(), classes, posteriors);
+        });
+    }
+    
+    void RSGISMaximumLikelihoodClassifier::classifyTile(const float* const* featPlanes, size_t start, size_t nTilePts, size_t nPts, double *zPlanes, double *scorePlanes, int *classes, float *posteriors) const
+    {
+        const unsigned int nf = this->numFeatures;
+        for(unsigned int c = 0; c < this->numClasses; ++c)
+        {
+            const double *mean = &this->means[((size_t)c)*nf];
+            const double *L = &this->chols[((size_t)c)*nf*nf];
+            double *score = &scorePlanes[((size_t)c)*tileSize];
+            for(size_t p = 0; p < nTilePts; ++p)
+            {
+                score[p] = 0;
+            }
+            // Forward substitution across the tile, one feature at a time.
+            for(unsigned int i = 0; i < nf; ++i)
+            {
+                double *z = &zPlanes[((size_t)i)*tileSize];
+                const float *x = featPlanes[i] + start;
+                const double m = mean[i];
+                for(size_t p = 0; p < nTilePts; ++p)
+                {
+                    z[p] = x[p] - m;
+                }
+                for(unsigned int j = 0; j < i; ++j)
+                {
+                    const double l = L[(i*nf)+j];
+                    const double *zj = &zPlanes[((size_t)j)*tileSize];
+                    for(size_t p = 0; p < nTilePts; ++p)
+                    {
+                        z[p] -= l * zj[p];
+                    }
+                }
+                const double invDiag = L[(i*nf)+i];
+                for(size_t p = 0; p < nTilePts; ++p)
+                {
+                    z[p] *= invDiag;
+                    score[p] += z[p] * z[p];
+                }
+            }
+            const double logConst = this->logConsts[c];
+            for(size_t p = 0; p < nTilePts; ++p)
+            {
+                score[p] = logConst - (0.5 * score[p]);
+            }
+        }
+        
+        // Arg max of the log posteriors. The index is blended with a mask made
+        // from the sign bit of (best - score), which is set only if the score
+        // is larger (ties keep the first class, as predict_ml), so the loop
+        // vectorises without 64 bit integer compares.
+        double best[tileSize];
+        uint64_t bestIdx[tileSize];
+        for(size_t p = 0; p < nTilePts; ++p)
+        {
+            best[p] = scorePlanes[p];
+            bestIdx[p] = 0;
+        }
+        for(unsigned int c = 1; c < this->numClasses; ++c)
+        {
+            const double *score = &scorePlanes[((size_t)c)*tileSize];
+            const uint64_t cIdx = c;
+            for(size_t p = 0; p < nTilePts; ++p)
+            {
+                const double s = score[p];
+                const double b = best[p];
+                const double diff = b - s;
+                uint64_t bits;
+                memcpy(&bits, &diff, sizeof(bits));
+                const uint64_t better = 0 - (bits >> 63);
+                bestIdx[p] = (bestIdx[p] & ~better) | (cIdx & better);
+                best[p] = std::max(s, b);
+            }
+        }
+        for(size_t p = 0; p < nTilePts; ++p)
+        {
+            classes[start+p] = this->classIDs[bestIdx[p]];
+        }
+        
+        if(posteriors != NULL)
+        {
+            double sum[tileSize];
+            for(size_t p = 0; p < nTilePts; ++p)
+            {
+                sum[p] = 0;
+            }
+            for(unsigned int c = 0; c < this->numClasses; ++c)
+            {
+                double *score = &scorePlanes[((size_t)c)*tileSize];
+                for(size_t p = 0; p < nTilePts; ++p)
+                {
+                    score[p] = exp(score[p] - best[p]);
+                    sum[p] += score[p];
+                }
+            }
+            for(unsigned int c = 0; c < this->numClasses; ++c)
+            {
+                const double *score = &scorePlanes[((size_t)c)*tileSize];
+                float *post = &posteriors[(((size_t)c)*nPts) + start];
+                for(size_t p = 0; p < nTilePts; ++p)
+                {
+                    post[p] = score[p] / sum[p];
+                }
+            }
+        }
+    }
+    
+    RSGISMaximumLikelihoodClassifier::~RSGISMaximumLikelihoodClassifier()
+    {
+        
+    }
+    
+    
 }}
 
@@ -34,10 +34,19 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <limits>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <algorithm>
 
 #include "RSGISMathsUtils.h"
 #include "math/RSGISMathException.h"
 #include "math/RSGISMaximumLikelihoodException.h"
+#include "common/RSGISParallel.h"
 
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
@@ -567,6 +576,51 @@ namespace rsgis {namespace math{
         };
     };
     
+    /**
+     * Classifies blocks of points with a model from RSGISMaximumLikelihood::compute_ml.
+     * The Cholesky factor (L, covar = L L^T) of each class covariance matrix and
+     * the constant part of the log posterior (log prior - log(det) / 2) are
+     * computed once. Tiles of points are then whitened with a forward
+     * substitution (z = L^-1 (x - mean), so the Mahalanobis distance is |z|^2)
+     * run across the points, one feature at a time, so the loops over the
+     * points vectorise. The tiles are split between threads (setNumThreads,
+     * defaulting to RSGISLIB_NUM_THREADS or 1).
+     */
+    class DllExport RSGISMaximumLikelihoodClassifier
+    {
+    public:
+        /**
+         * Throws RSGISMaximumLikelihoodException if a covariance matrix is not
+         * positive definite.
+         */
+        RSGISMaximumLikelihoodClassifier(MaximumLikelihood *ml);
+        void setNumThreads(unsigned int numThreads);
+        unsigned int getNumClasses() const {return numClasses;};
+        unsigned int getNumFeatures() const {return numFeatures;};
+        /**
+         * Classify nPts points held as planes of features (featPlanes[feature][pt]),
+         * writing the class (ml->classes) with the largest posterior to classes.
+         * If posteriors is not NULL the normalised posterior probabilities are
+         * written to it as planes (posteriors[(class*nPts)+pt]).
+         */
+        void classify(const float* const* featPlanes, size_t nPts, int *classes, float *posteriors=NULL) const;
+        ~RSGISMaximumLikelihoodClassifier();
+    protected:
+        void classifyTile(const float* const* featPlanes, size_t start, size_t nTilePts, size_t nPts, double *zPlanes, double *scorePlanes, int *classes, float *posteriors) const;
+        static const size_t tileSize = 256;
+        unsigned int numClasses;
+        unsigned int numFeatures;
+        unsigned int numThreads;
+        std::vector<int> classIDs;
+        // means[(class*numFeatures)+feature]
+        std::vector<double> means;
+        // The lower triangle of L for each class, row major, with the diagonal
+        // held as its reciprocal: chols[(class*numFeatures*numFeatures)+(i*numFeatures)+j]
+        std::vector<double> chols;
+        // log(prior) - log(det(covar)) / 2
+        std::vector<double> logConsts;
+    };
+    
 }}
 
 #endif
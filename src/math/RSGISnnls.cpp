@@ -105,19 +105,19 @@ namespace rsgis{namespace math{
         
         /* Local variables */
         //extern double diff_(); - COMMENTED OUT!
-        static int iter;
-        static double temp, wmax;
-        static int i__, j, l;
-        static double t, alpha, asave;
-        static int itmax, izmax, nsetp;
+        int iter = 0;
+        double temp = 0, wmax = 0;
+        int i__ = 0, j = 0, l = 0;
+        double t = 0, alpha = 0, asave = 0;
+        int itmax = 0, izmax = 0, nsetp = 0;
         //extern int g1_(); /* Subroutine */
-        static double dummy, unorm, ztest, cc;
+        double dummy = 0, unorm = 0, ztest = 0, cc = 0;
         //extern int h12_(); /* Subroutine */
-        static int ii, jj, ip;
-        static double sm;
-        static int iz, jz;
-        static double up, ss;
-        static int rtnkey, iz1, iz2, npp1;
+        int ii = 0, jj = 0, ip = 0;
+        double sm = 0;
+        int iz = 0, jz = 0;
+        double up = 0, ss = 0;
+        int rtnkey = 0, iz1 = 0, iz2 = 0, npp1 = 0;
         
         /* Fortran I/O blocks */
         /* The following line was commented out after the f2c translation */
@@ -540,7 +540,7 @@ namespace rsgis{namespace math{
         /* double sqrt(), d_sign(); */
         
         /* Local variables */
-        static double xr, yr;
+        double xr = 0, yr = 0;
         
         
         /*     COMPUTE ORTHOGONAL ROTATION MATRIX.. */
@@ -639,12 +639,12 @@ namespace rsgis{namespace math{
         /* double sqrt(); */
         
         /* Local variables */
-        static int incr;
-        static double b;
-        static int i__, j;
-        static double clinv;
-        static int i2, i3, i4;
-        static double cl, sm;
+        int incr = 0;
+        double b = 0;
+        int i__ = 0, j = 0;
+        double clinv = 0;
+        int i2 = 0, i3 = 0, i4 = 0;
+        double cl = 0, sm = 0;
         
         /*     ------------------------------------------------------------------ 
          */
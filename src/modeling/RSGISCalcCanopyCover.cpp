@@ -50,6 +50,12 @@ namespace rsgis { namespace modeling {
 						
 		return canopyCover;
 	}
+	double RSGISCalcCanopyCover::calcCanopyCoverVoxels()
+	{
+		RSGISTransectProfile profile(transect);
+		profile.calcProfile();
+		return profile.getCanopyCover();
+	}
 	void RSGISCalcCanopyCover::exportCanopyPoly(std::string outFile)
 	{
 		rsgis::vec::RSGISVectorIO vectorIO;
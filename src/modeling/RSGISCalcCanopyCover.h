@@ -29,6 +29,7 @@
 #include "geos/geom/CoordinateArraySequence.h"
 
 #include "modeling/RSGISTransect.h"
+#include "modeling/RSGISTransectProfile.h"
 #include "geom/RSGISGeometry.h"
 #include "vec/RSGISVectorIO.h"
 
@@ -61,6 +62,8 @@ namespace rsgis { namespace modeling {
 	public:
 		RSGISCalcCanopyCover(RSGISTransect *transect, std::vector<geos::geom::Polygon*> *canopyPoly);
 		double calcCanopyCover();
+		/// Crown cover from the voxels of the transect (percentage of columns containing a branch or leaf), without the polygons
+		double calcCanopyCoverVoxels();
 		void exportCanopyPoly(std::string outFile);
 		~RSGISCalcCanopyCover();
 	private:
@@ -28,6 +28,25 @@ namespace rsgis { namespace modeling {
 	RSGISCalcFPC::RSGISCalcFPC(RSGISTransect *transect)
 	{
 		this->transect = transect;
+		this->profile = NULL;
+	}
+	RSGISTransectProfile* RSGISCalcFPC::getProfile()
+	{
+		if(this->profile == NULL)
+		{
+			this->profile = new RSGISTransectProfile(this->transect);
+			this->profile->calcProfile();
+		}
+		return this->profile;
+	}
+	double RSGISCalcFPC::calcFPCGroundHits(unsigned int leafHits, unsigned int branchHits, unsigned int nMeas)
+	{
+		double percentLeafHits = double(leafHits) / double(nMeas);
+		double percentBranchHits = double(branchHits) / double(nMeas);
+		
+		double fpc = (100 * percentLeafHits) / (1 - percentBranchHits);
+		
+		return fpc;
 	}
 	double RSGISCalcFPC::calcFPCGroundRand(unsigned int nMeas, double randSeed)
 	{
@@ -39,9 +58,9 @@ namespace rsgis { namespace modeling {
 		gsl_rng *rand = gsl_rng_alloc (gsl_rng_taus2);
 		gsl_rng_set (rand, randSeed);
 		
+		RSGISTransectProfile *profile = this->getProfile();
 		unsigned int numX = transect->getWidth();
 		unsigned int numY = transect->getLenth();
-		unsigned int numZ = transect->getHeight();
 		unsigned int branchHits = 0;
 		unsigned int leafHits = 0;
 		unsigned int startX = 0;
@@ -52,37 +71,27 @@ namespace rsgis { namespace modeling {
 			startX = gsl_rng_uniform_int (rand, numX);
 			startY = gsl_rng_uniform_int (rand, numY);
 			
-			for(unsigned int z = 0; z < numZ; z++) // Continue untill something is hit
+			char element = profile->getGroundHit(startX, startY); // First hit from the ground
+			if(element == 1)
 			{
-				char element = transect->getValue(startX, startY, z);
-				
-				if(element == 1)
-				{
-					branchHits++;
-					break;
-				}
-				else if(element == 2)
-				{
-					leafHits++;
-					break;
-				}
+				branchHits++;
+			}
+			else if(element == 2)
+			{
+				leafHits++;
 			}
 		}	
+		gsl_rng_free(rand);
 		
-		double percentLeafHits = double(leafHits) / double(nMeas);
-		double percentBranchHits = double(branchHits) / double(nMeas);
-		
-		double fpc = (100 * percentLeafHits) / (1 - percentBranchHits);
-		
-		return fpc;
+		return this->calcFPCGroundHits(leafHits, branchHits, nMeas);
 	}
 	
 	double RSGISCalcFPC::calcFPCGroundTrans(unsigned int spaceing)
 	{
 		// Get transect dimensions
+		RSGISTransectProfile *profile = this->getProfile();
 		unsigned int numX = transect->getWidth();
 		unsigned int numY = transect->getLenth();
-		unsigned int numZ = transect->getHeight();
 		unsigned int branchHits = 0;
 		unsigned int leafHits = 0;
 		
@@ -94,131 +103,65 @@ namespace rsgis { namespace modeling {
 		
 		while (startY < numY)
 		{
-			for(unsigned int z = 0; z < numZ; z++) // Continue untill something is hit
+			char element = profile->getGroundHit(startX, startY, true); // Stems are counted as branches
+			if(element == 1)
 			{
-				char element = transect->getValue(startX, startY, z);
-				
-				if((element == 1) | (element == 3))
-				{
-					branchHits++;
-					break;
-				}
-				else if(element == 2)
-				{
-					leafHits++;
-					break;
-				}
+				branchHits++;
+			}
+			else if(element == 2)
+			{
+				leafHits++;
 			}
 			startY = startY + spaceing;
 		}	
 		
 		// Calculate FPC based on hits
-		double percentLeafHits = double(leafHits) / double(nMeas);
-		double percentBranchHits = double(branchHits) / double(nMeas);
-		
-		double fpc = (100 * percentLeafHits) / (1 - percentBranchHits);
-		
-		return fpc;
+		return this->calcFPCGroundHits(leafHits, branchHits, nMeas);
 	}
 	
 	double RSGISCalcFPC::calcFPCGroundAll()
 	{
 		// Get transect dimensions
+		RSGISTransectProfile *profile = this->getProfile();
 		unsigned int numX = transect->getWidth();
 		unsigned int numY = transect->getLenth();
-		unsigned int numZ = transect->getHeight();
 		unsigned int branchHits = 0;
 		unsigned int leafHits = 0;
 		
 		unsigned int nMeas = numX * numY;
 		
-		
 		for (unsigned int x = 0; x < numX; x++)
 		{
 			for (unsigned int y = 0; y < numY; y++)
 			{
-				for(unsigned int z = 0; z < numZ; z++) // Continue untill something is hit
+				char element = profile->getGroundHit(x, y);
+				if(element == 1)
 				{
-					char element = transect->getValue(x, y, z);
-					
-					if(element == 1)
-					{
-						branchHits++;
-						break;
-					}
-					else if(element == 2)
-					{
-						leafHits++;
-						break;
-					}
+					branchHits++;
+				}
+				else if(element == 2)
+				{
+					leafHits++;
 				}
 			}	
 		}
 		
 		// Calculate FPC based on hits
-		double percentLeafHits = double(leafHits) / double(nMeas);
-		double percentBranchHits = double(branchHits) / double(nMeas);
-		
-		double fpc = (100 * percentLeafHits) / (1 - percentBranchHits);
-		
-		return fpc;
+		return this->calcFPCGroundHits(leafHits, branchHits, nMeas);
 	}
 	
 	
 	double RSGISCalcFPC::calcFPCHeightRand(unsigned int nMeas, double randSeed)
 	{
-		
-		/* SET UP THE RANDOM NUMBER GENERATOR
-		 * The GSL libary is used for the random number generation (see http://www.gnu.org/software/gsl/manual/html_node/Random-Number-Generation.html)
-		 * The seed is passed in as input parameter.
-		 */
-		gsl_rng *rand = gsl_rng_alloc (gsl_rng_taus2);
-		gsl_rng_set (rand, randSeed);
-		
-		unsigned int numX = transect->getWidth();
-		unsigned int numY = transect->getLenth();
-		unsigned int numZ = transect->getHeight();
-		unsigned int branchHits = 0;
-		unsigned int leafHits = 0;
-		unsigned int startX = 0;
-		unsigned int startY = 0;
-		
-		for(unsigned int i = 0; i < nMeas; i++)
-		{
-			startX = gsl_rng_uniform_int (rand, numX);
-			startY = gsl_rng_uniform_int (rand, numY);
-			
-			for(unsigned int z = 0; z < numZ; z++) // Continue untill something is hit
-			{
-				char element = transect->getValue(startX, startY, z);
-				
-				if(element == 1)
-				{
-					branchHits++;
-					break;
-				}
-				else if(element == 2)
-				{
-					leafHits++;
-					break;
-				}
-			}
-		}	
-		
-		double percentLeafHits = double(leafHits) / double(nMeas);
-		double percentBranchHits = double(branchHits) / double(nMeas);
-		
-		double fpc = (100 * percentLeafHits) / (1 - percentBranchHits);
-		
-		return fpc;
+		return this->calcFPCGroundRand(nMeas, randSeed);
 	}
 	
 	double RSGISCalcFPC::calcFPCHeightTrans(unsigned int spaceing)
 	{
 		// Get transect dimensions
+		RSGISTransectProfile *profile = this->getProfile();
 		unsigned int numX = transect->getWidth();
 		unsigned int numY = transect->getLenth();
-		unsigned int numZ = transect->getHeight();
 		unsigned int branchHits = 0;
 		unsigned int leafHits = 0;
 		
@@ -230,31 +173,20 @@ namespace rsgis { namespace modeling {
 		
 		while (startY < numY)
 		{
-			for(unsigned int z = 0; z < numZ; z++) // Continue untill something is hit
+			char element = profile->getGroundHit(startX, startY);
+			if(element == 1)
 			{
-				char element = transect->getValue(startX, startY, z);
-				
-				if(element == 1)
-				{
-					branchHits++;
-					break;
-				}
-				else if(element == 2)
-				{
-					leafHits++;
-					break;
-				}
+				branchHits++;
+			}
+			else if(element == 2)
+			{
+				leafHits++;
 			}
 			startY = startY + spaceing;
 		}	
 		
 		// Calculate FPC based on hits
-		double percentLeafHits = double(leafHits) / double(nMeas);
-		double percentBranchHits = double(branchHits) / double(nMeas);
-		
-		double fpc = (100 * percentLeafHits) / (1 - percentBranchHits);
-		
-		return fpc;
+		return this->calcFPCGroundHits(leafHits, branchHits, nMeas);
 	}
 	
 	double RSGISCalcFPC::calcFPCTopRand(unsigned int nMeas, double randSeed)
@@ -267,9 +199,9 @@ namespace rsgis { namespace modeling {
 		gsl_rng *rand = gsl_rng_alloc (gsl_rng_taus2);
 		gsl_rng_set (rand, randSeed);
 		
+		RSGISTransectProfile *profile = this->getProfile();
 		unsigned int numX = transect->getWidth();
 		unsigned int numY = transect->getLenth();
-		unsigned int numZ = transect->getHeight();
 		unsigned int leafHits = 0;
 		unsigned int startX = 0;
 		unsigned int startY = 0;
@@ -279,32 +211,25 @@ namespace rsgis { namespace modeling {
 			startX = gsl_rng_uniform_int (rand, numX);
 			startY = gsl_rng_uniform_int (rand, numY);
 			
-			for(unsigned int z = (numZ - 1); z > 0; z--) // Start from the top and work down until something is hit.
+			if(profile->getTopLeafHit(startX, startY)) // Looking down from the top
 			{
-				char element = transect->getValue(startX, startY, z);
-				
-				if(element == 2)
-				{
-					leafHits++;
-					break;
-				}
+				leafHits++;
 			}
 		}	
+		gsl_rng_free(rand);
 		
 		// Calculate FPC based on hits		
 		double fpc = 100 * (double(leafHits) / double(nMeas));
 		
 		return fpc;
-		
-		return fpc;
 	}
 	
 	double RSGISCalcFPC::calcFPCTopTrans(unsigned int spaceing)
 	{
 		// Get transect dimensions
+		RSGISTransectProfile *profile = this->getProfile();
 		unsigned int numX = transect->getWidth();
 		unsigned int numY = transect->getLenth();
-		unsigned int numZ = transect->getHeight();
 		unsigned int leafHits = 0;
 		
 		unsigned int startX = numX / 2; // Set start x to middle of transect
@@ -315,15 +240,9 @@ namespace rsgis { namespace modeling {
 		
 		while (startY < numY)
 		{
-			for(unsigned int z = (numZ - 1); z > 0; z--) // Start from the top and work down until something is hit.
+			if(profile->getTopLeafHit(startX, startY)) // Looking down from the top
 			{
-				char element = transect->getValue(startX, startY, z);
-				
-				if(element == 2)
-				{
-					leafHits++;
-					break;
-				}
+				leafHits++;
 			}
 			startY = startY + spaceing;
 		}	
@@ -334,5 +253,12 @@ namespace rsgis { namespace modeling {
 		return fpc;
 	}
 	
+	RSGISCalcFPC::~RSGISCalcFPC()
+	{
+		if(this->profile != NULL)
+		{
+			delete this->profile;
+		}
+	}
+	
 }}
-
@@ -27,6 +27,7 @@
 
 #include <gsl/gsl_rng.h>
 #include "modeling/RSGISTransect.h"
+#include "modeling/RSGISTransectProfile.h"
 
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
@@ -49,6 +50,8 @@ namespace rsgis { namespace modeling {
 	 * Armston et al. Prediction and validation of foliage projective cover from Landsat-5 TM and Landsat-7 ETM+ imagery. <br>
 	 * J. Appl. Remote Sens. (2009) vol. 3 (1) pp. 033540<br>
 	 * Takes RSGISTransect, to which trees have been added.<br>
+	 * The transect is read once (RSGISTransectProfile) on the first call and the
+	 * samples taken from the first hits of each column.<br>
 	 */
 	class DllExport RSGISCalcFPC
 	{
@@ -68,9 +71,13 @@ namespace rsgis { namespace modeling {
 		double calcFPCTopRand(unsigned int nMeas, double randSeed);
 		/// Calculate FPC by sampling point along the lenght (y) of the transect in the center (sizeX / 2)
 		double calcFPCTopTrans(unsigned int spaceing);
+		/// The profile of the transect (calculated on first use)
+		RSGISTransectProfile* getProfile();
 		~RSGISCalcFPC();
 	private:
+		double calcFPCGroundHits(unsigned int leafHits, unsigned int branchHits, unsigned int nMeas);
 		RSGISTransect *transect;
+		RSGISTransectProfile *profile;
 	};
 	
 }}
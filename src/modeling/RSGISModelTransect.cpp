@@ -31,6 +31,8 @@ namespace rsgis{ namespace modeling  {
 		this->transectWidth = transect->getWidth();
 		this->transectHeight = transect->getHeight();
 		this->transectRes = transect->getRes();
+		this->canopyPoly = NULL;
+		this->convexHull = false;
 		
 		// TO DO: Add check to ensure array will fit into memory.
 	}
@@ -129,5 +131,32 @@ namespace rsgis{ namespace modeling  {
 	}
 	
 	RSGISModelTransect::~RSGISModelTransect(){}
+	
+	RSGISModelStands::RSGISModelStands()
+	{
+		this->numThreads = rsgis::utils::getNumThreads();
+	}
+	
+	void RSGISModelStands::setNumThreads(unsigned int numThreads)
+	{
+		this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+	}
+	
+	void RSGISModelStands::populateSingleSizeSpecies(std::vector<RSGISModelStand> *stands)
+	{
+		size_t numStands = stands->size();
+		rsgis::utils::parallelFor(numStands, this->numThreads, [&](size_t i, unsigned int)
+		{
+			RSGISModelStand &stand = stands->at(i);
+			RSGISModelTransect modelTransect(stand.transect);
+			if(stand.canopyPoly != NULL)
+			{
+				modelTransect.createConvexHull(stand.canopyPoly);
+			}
+			modelTransect.populateSingleSizeSpecies(stand.quadratSize, stand.numTrees, stand.vegDistro, stand.treePosXDistro, stand.treePosYDistro, stand.addVeg);
+		});
+	}
+	
+	RSGISModelStands::~RSGISModelStands(){}
 }}
 
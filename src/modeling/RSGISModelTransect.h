@@ -26,6 +26,11 @@
 
 #include <vector>
 #include <iostream>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <cstdlib>
+#include <algorithm>
 #include "geos/geom/Polygon.h"
 
 #include "math/RSGISRandomDistro.h"
@@ -33,6 +38,7 @@
 #include "RSGISTransect.h"
 #include "RSGISModelingException.h"
 #include "RSGISModelAddVegetation.h"
+#include "common/RSGISParallel.h"
 
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
@@ -78,6 +84,40 @@ namespace rsgis{ namespace modeling  {
         std::vector<geos::geom::Polygon*> *canopyPoly;
 		bool convexHull;
 	};
+	
+	/// A stand to be populated by RSGISModelStands
+	/**
+	 * Each stand must have its own transect, vegetation and distributions (each 
+	 * RSGISProbDistro holds its own generator) so stands do not share any state.
+	 * If canopyPoly is not NULL the convex hulls of the canopies are saved to it.
+	 */
+	struct DllExport RSGISModelStand
+	{
+		RSGISTransect *transect;
+		double quadratSize;
+		unsigned int numTrees;
+		rsgis::math::RSGISProbDistro *vegDistro;
+		rsgis::math::RSGISProbDistro *treePosXDistro;
+		rsgis::math::RSGISProbDistro *treePosYDistro;
+		RSGISModelAddVegetation *addVeg;
+		std::vector<geos::geom::Polygon*> *canopyPoly;
+	};
+	
+	/// Class to populate a set of independent stands (e.g., for a LUT) in parallel
+	/**
+	 * The stands are shared between threads (setNumThreads, default RSGISLIB_NUM_THREADS), 
+	 * each being populated with RSGISModelTransect::populateSingleSizeSpecies.
+	 */
+	class DllExport RSGISModelStands
+	{
+	public:
+		RSGISModelStands();
+		void setNumThreads(unsigned int numThreads);
+		void populateSingleSizeSpecies(std::vector<RSGISModelStand> *stands);
+		~RSGISModelStands();
+	private:
+		unsigned int numThreads;
+	};
 }}
 
 #endif
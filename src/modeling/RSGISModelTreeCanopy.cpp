@@ -75,11 +75,7 @@ namespace rsgis { namespace modeling{
 		unsigned int rX = 0;
 		unsigned int rY = 0;
 		unsigned int rZ = 0;
-		unsigned int xItt = 0;
-		unsigned int yItt = 0;
 		unsigned int rItt = 0;
-		unsigned int x = 0;
-		unsigned int y = 0;
 		unsigned int rYLeaf = 0;
 		unsigned int rZLeaf = 0;
 		unsigned int rLeafItt = 0;
@@ -94,6 +90,8 @@ namespace rsgis { namespace modeling{
 		double largeBranchTheta = 0;
 		double largeBranchPhi = 0;
 		
+		std::vector<RSGISBranchRun> branchRuns;
+		
 		double transectRes = transect->getRes();
 		
 		// Convert lenghts for parameters from meters to voxels, based on transect resolution
@@ -174,32 +172,14 @@ namespace rsgis { namespace modeling{
 					rY = 0;
 				}
 				
-				// SET START POINT OF BRANCH SECTION
-				transect->setValue(branchX, branchY, branchZ, 1);
-				
-				/* GROW OUT BRANCHES
-				 * If the branch radius is less than one voxel this will not run
-				 */
-				x = branchX; // Initialy set x to branch start , if x > numX, x goes to zero (bondary condition).
-				xItt = 0; // xItt advances by on each time until a the branch has been grown to the correct number of voxels
-				
-				while(xItt < smallBranchRadiusVox)
-				{
-					y = branchY; // Initialy set y to branch start , if y > numY, y goes to zero (bondary condition).
-					yItt = 0; // yItt advances by on each time until a the branch has been grown to the correct number of voxels
-					
-					while (yItt < smallBranchRadiusVox) 
-					{
-						transect->setValue(x, y, branchZ , 1);
-						
-						y++; yItt++; 
-					}
-					x++; xItt++;
-				}
+				// ADD BRANCH SECTION (grown out to the radius as columns in addBranchRuns)
+				this->addBranchSection(&branchRuns, branchX, branchY, branchZ);
 				
 				// Add leaves to end of branch.
 				if(rItt == (smallBranchLenghtVox - 1))
 				{
+					// Add the branch before its leaves
+					this->addBranchRuns(transect, &branchRuns, smallBranchRadiusVox, 1);
 					for(unsigned int l = 0; l < (leafDensityInt / smallBranchDensityInt);l++)
 					{
 						unsigned int leafStartX = leafPosHDistro->calcRand() + branchX;
@@ -239,6 +219,7 @@ namespace rsgis { namespace modeling{
 				}
 				rX++; rY++; rZ++; rItt++;
 			}
+			this->addBranchRuns(transect, &branchRuns, smallBranchRadiusVox, 1);
 		}
 		
 		/********************************
@@ -265,34 +246,12 @@ namespace rsgis { namespace modeling{
 				branchY = startY + (rY * sin(largeBranchPhi) * sin(largeBranchTheta) + 0.5);
 				branchZ = startZ + (rZ * cos(largeBranchTheta) + 0.5);
 				
-				// SET START POINT OF BRANCH SECTION
-				transect->setValue(branchX, branchY, branchZ, 1); 
-				
-				/* GROW OUT BRANCHES
-				 * If the branch radius is less than one voxel this will not run
-				 *
-				 */
-				x = branchX; // Initialy set x to branch start , if x > numX, x goes to zero (bondary condition).
-				xItt = 0; // xItt advances by on each time until a the branch has been grown to the correct number of voxels
-				
-				while(xItt < largeBranchRadiusVox)
-				{
-					
-					y = branchY; // Initialy set y to branch start , if y > numY, y goes to zero (bondary condition).
-					yItt = 0; // yItt advances by on each time until a the branch has been grown to the correct number of voxels
-					
-					while (yItt < largeBranchRadiusVox) 
-					{
-
-						transect->setValue(x, y, branchZ, 1);
-						
-						y++; yItt++; 
-					}
-					x++; xItt++;
-				}
+				// ADD BRANCH SECTION (grown out to the radius as columns in addBranchRuns)
+				this->addBranchSection(&branchRuns, branchX, branchY, branchZ);
 				
 				rX++; rY++; rZ++; rItt++;
 			}
+			this->addBranchRuns(transect, &branchRuns, largeBranchRadiusVox, 1);
 			
 		}
 
@@ -310,11 +269,7 @@ namespace rsgis { namespace modeling{
 		unsigned int rX = 0;
 		unsigned int rY = 0;
 		unsigned int rZ = 0;
-		unsigned int xItt = 0;
-		unsigned int yItt = 0;
 		unsigned int rItt = 0;
-		unsigned int x = 0;
-		unsigned int y = 0;
 		unsigned int rYLeaf = 0;
 		unsigned int rZLeaf = 0;
 		unsigned int rLeafItt = 0;
@@ -331,6 +286,8 @@ namespace rsgis { namespace modeling{
 		
 		std::vector<geos::geom::Coordinate> *coordinates = new std::vector<geos::geom::Coordinate>;
 		
+		std::vector<RSGISBranchRun> branchRuns;
+		
 		double transectRes = transect->getRes();
 		
 		// Convert lenghts for parameters from meters to voxels, based on transect resolution
@@ -374,34 +331,12 @@ namespace rsgis { namespace modeling{
 					branchY = startY + (rY * sin(largeBranchPhi) * sin(largeBranchTheta) + 0.5);
 					branchZ = startZ + (rZ * cos(largeBranchTheta) + 0.5);
 					
-					// SET START POINT OF BRANCH SECTION
-					transect->setValue(branchX, branchY, branchZ, 3); 
-					
-					/* GROW OUT BRANCHES
-					 * If the branch radius is less than one voxel this will not run
-					 *
-					 */
-					x = branchX; // Initialy set x to branch start , if x > numX, x goes to zero (bondary condition).
-					xItt = 0; // xItt advances by on each time until a the branch has been grown to the correct number of voxels
-					
-					while(xItt < largeBranchRadiusVox)
-					{
-						
-						y = branchY; // Initialy set y to branch start , if y > numY, y goes to zero (bondary condition).
-						yItt = 0; // yItt advances by on each time until a the branch has been grown to the correct number of voxels
-						
-						while (yItt < largeBranchRadiusVox) 
-						{
-							
-							transect->setValue(x, y, branchZ, 3);
-							
-							y++; yItt++; 
-						}
-						x++; xItt++;
-					}
+					// ADD BRANCH SECTION (grown out to the radius as columns in addBranchRuns)
+					this->addBranchSection(&branchRuns, branchX, branchY, branchZ);
 					
 					rX++; rY++; rZ++; rItt++;
 				}
+				this->addBranchRuns(transect, &branchRuns, largeBranchRadiusVox, 3);
 				
 			}
 			
@@ -445,32 +380,14 @@ namespace rsgis { namespace modeling{
 						rY = 0;
 					}
 					
-					// SET START POINT OF BRANCH SECTION
-					transect->setValue(branchX, branchY, branchZ, 1);
-					
-					/* GROW OUT BRANCHES
-					 * If the branch radius is less than one voxel this will not run
-					 */
-					x = branchX; // Initialy set x to branch start , if x > numX, x goes to zero (bondary condition).
-					xItt = 0; // xItt advances by on each time until a the branch has been grown to the correct number of voxels
-					
-					while(xItt < smallBranchRadiusVox)
-					{
-						y = branchY; // Initialy set y to branch start , if y > numY, y goes to zero (bondary condition).
-						yItt = 0; // yItt advances by on each time until a the branch has been grown to the correct number of voxels
-						
-						while (yItt < smallBranchRadiusVox) 
-						{
-							transect->setValue(x, y, branchZ , 1);
-							
-							y++; yItt++; 
-						}
-						x++; xItt++;
-					}
+					// ADD BRANCH SECTION (grown out to the radius as columns in addBranchRuns)
+					this->addBranchSection(&branchRuns, branchX, branchY, branchZ);
 					
 					// Add leaves to end of branch.
 					if(rItt == (smallBranchLenghtVox - 1))
 					{
+						// Add the branch before its leaves
+						this->addBranchRuns(transect, &branchRuns, smallBranchRadiusVox, 1);
 						for(unsigned int l = 0; l < (leafDensityInt / smallBranchDensityInt);l++)
 						{
 							unsigned int leafStartX = leafPosHDistro->calcRand() + branchX;
@@ -526,6 +443,7 @@ namespace rsgis { namespace modeling{
 					}
 					rX++; rY++; rZ++; rItt++;
 				}
+				this->addBranchRuns(transect, &branchRuns, smallBranchRadiusVox, 1);
 			}
 			
 		}
@@ -555,34 +473,12 @@ namespace rsgis { namespace modeling{
 					branchY = startY + (rY * sin(largeBranchPhi) * sin(largeBranchTheta) + 0.5);
 					branchZ = startZ + (rZ * cos(largeBranchTheta) + 0.5);
 					
-					// SET START POINT OF BRANCH SECTION
-					transect->setValue(branchX, branchY, branchZ, 3); 
-					
-					/* GROW OUT BRANCHES
-					 * If the branch radius is less than one voxel this will not run
-					 *
-					 */
-					x = branchX; // Initialy set x to branch start , if x > numX, x goes to zero (bondary condition).
-					xItt = 0; // xItt advances by on each time until a the branch has been grown to the correct number of voxels
-					
-					while(xItt < largeBranchRadiusVox)
-					{
-						
-						y = branchY; // Initialy set y to branch start , if y > numY, y goes to zero (bondary condition).
-						yItt = 0; // yItt advances by on each time until a the branch has been grown to the correct number of voxels
-						
-						while (yItt < largeBranchRadiusVox) 
-						{
-							
-							transect->setValue(x, y, branchZ, 3);
-							
-							y++; yItt++; 
-						}
-						x++; xItt++;
-					}
+					// ADD BRANCH SECTION (grown out to the radius as columns in addBranchRuns)
+					this->addBranchSection(&branchRuns, branchX, branchY, branchZ);
 					
 					rX++; rY++; rZ++; rItt++;
 				}
+				this->addBranchRuns(transect, &branchRuns, largeBranchRadiusVox, 3);
 				
 				/********************************
 				 * ADD SMALL BRANCHES TO CANOPY *
@@ -622,32 +518,14 @@ namespace rsgis { namespace modeling{
 							rY = 0;
 						}
 						
-						// SET START POINT OF BRANCH SECTION
-						transect->setValue(branchX, branchY, branchZ, 1);
-						
-						/* GROW OUT BRANCHES
-						 * If the branch radius is less than one voxel this will not run
-						 */
-						x = branchX; // Initialy set x to branch start , if x > numX, x goes to zero (bondary condition).
-						xItt = 0; // xItt advances by on each time until a the branch has been grown to the correct number of voxels
-						
-						while(xItt < smallBranchRadiusVox)
-						{
-							y = branchY; // Initialy set y to branch start , if y > numY, y goes to zero (bondary condition).
-							yItt = 0; // yItt advances by on each time until a the branch has been grown to the correct number of voxels
-							
-							while (yItt < smallBranchRadiusVox) 
-							{
-								transect->setValue(x, y, branchZ , 1);
-								
-								y++; yItt++; 
-							}
-							x++; xItt++;
-						}
+						// ADD BRANCH SECTION (grown out to the radius as columns in addBranchRuns)
+						this->addBranchSection(&branchRuns, branchX, branchY, branchZ);
 						
 						// Add leaves to end of branch.
 						if(rItt == (smallBranchLenghtVox - 1))
 						{
+							// Add the branch before its leaves
+							this->addBranchRuns(transect, &branchRuns, smallBranchRadiusVox, 1);
 							for(unsigned int l = 0; l < (leafDensityInt / smallBranchDensityInt);l++)
 							{
 								unsigned int leafStartX = leafPosHDistro->calcRand() + branchX;
@@ -704,6 +582,7 @@ namespace rsgis { namespace modeling{
 						}
 						rX++; rY++; rZ++; rItt++;
 					}
+					this->addBranchRuns(transect, &branchRuns, smallBranchRadiusVox, 1);
 				}
 				
 			}
@@ -728,6 +607,37 @@ namespace rsgis { namespace modeling{
 		delete coordinates;
 		
 	}
+	void RSGISModelTreeCanopy::addBranchSection(std::vector<RSGISBranchRun> *branchRuns, unsigned int x, unsigned int y, unsigned int z)
+	{
+		/* Each section moves at most one voxel in z, so sections in the same column
+		 * form a contiguous span which can be filled in one go. */
+		if(!branchRuns->empty())
+		{
+			RSGISBranchRun &lastRun = branchRuns->back();
+			if((lastRun.x == x) && (lastRun.y == y) && ((((unsigned long long) z) + 1) >= lastRun.zMin) && (z <= (((unsigned long long) lastRun.zMax) + 1)))
+			{
+				lastRun.zMin = std::min(lastRun.zMin, z);
+				lastRun.zMax = std::max(lastRun.zMax, z);
+				return;
+			}
+		}
+		RSGISBranchRun run;
+		run.x = x;
+		run.y = y;
+		run.zMin = z;
+		run.zMax = z;
+		branchRuns->push_back(run);
+	}
+	void RSGISModelTreeCanopy::addBranchRuns(RSGISTransect *transect, std::vector<RSGISBranchRun> *branchRuns, unsigned int radiusVox, char value)
+	{
+		// If the branch radius is less than one voxel only the centre of the section is set
+		unsigned int sizeVox = std::max<unsigned int>(radiusVox, 1);
+		for(std::vector<RSGISBranchRun>::iterator iterRun = branchRuns->begin(); iterRun != branchRuns->end(); ++iterRun)
+		{
+			transect->setBlock((*iterRun).x, (*iterRun).x + (sizeVox - 1), (*iterRun).y, (*iterRun).y + (sizeVox - 1), (*iterRun).zMin, (*iterRun).zMax, value);
+		}
+		branchRuns->clear();
+	}
 	RSGISModelTreeCanopy::~RSGISModelTreeCanopy()
 	{
 		
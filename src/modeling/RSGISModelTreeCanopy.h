@@ -26,6 +26,7 @@
 #define RSGISModelTreeCanopy_H
 
 #include <vector>
+#include <algorithm>
 #include "geos/geom/Coordinate.h"
 #include "geos/geom/CoordinateArraySequence.h"
 
@@ -50,6 +51,15 @@
 
 namespace rsgis { namespace modeling{
     
+	/// Consecutive sections of a branch in the same column (x, y), from zMin to zMax
+	struct DllExport RSGISBranchRun
+	{
+		unsigned int x;
+		unsigned int y;
+		unsigned int zMin;
+		unsigned int zMax;
+	};
+	
 	/// Class to create tree canopy
 	/**
 	 * Class to create a tree canopy based on statistical distrobutions and tree parameters<br>
@@ -91,6 +101,10 @@ namespace rsgis { namespace modeling{
 		virtual void addVegTransConvexHull(RSGISTransect *transect, unsigned int centerX, unsigned int centerY, unsigned int sizeX, unsigned int sizeY, std::vector<geos::geom::Polygon*> *canopyPolys);
 		virtual ~RSGISModelTreeCanopy();
 	private:
+		/// Add a section to the runs of the branch, extending the last run if it is in the same column
+		void addBranchSection(std::vector<RSGISBranchRun> *branchRuns, unsigned int x, unsigned int y, unsigned int z);
+		/// Grow the runs out to radiusVox (at least one voxel) in x and y, fill the columns in the transect and clear the runs
+		void addBranchRuns(RSGISTransect *transect, std::vector<RSGISBranchRun> *branchRuns, unsigned int radiusVox, char value);
 		double leafLenght, leafWidth, leafThickness, leafDensity;
 		double smallBranchLenght, smallBranchRadius, smallBranchDensity;
 		double largeBranchLenght, largeBranchRadius, largeBranchDensity;
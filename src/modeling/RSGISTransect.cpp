@@ -32,50 +32,21 @@ namespace rsgis{ namespace modeling  {
 		this->transectHeight = transectHeight;
 		this->transectRes = transectRes;
 		
-		// Allocate memory for the array
-		this->transectData = new char**[transectWidth];
-		for(unsigned int i = 0; i < transectWidth; ++i)
-		{
-			transectData[i] = new char*[transectLength];
-			for(unsigned int j = 0; j < transectLength; ++j)
-			{
-				transectData[i][j] = new char[transectHeight];
-				for(unsigned int k = 0; k < transectHeight; ++k)
-				{
-					transectData[i][j][k] = 0;
-				}
-			}
-		}
-		
-		// TO DO: Add check to ensure array will fit into memory.
+		// Allocate memory for the array, column (x, y) starts at ((x * length) + y) * height
+		size_t numVoxels = ((size_t) transectWidth) * transectLength * transectHeight;
+		this->transectData = new char[numVoxels];
+		memset(this->transectData, 0, numVoxels);
 	}
 	void RSGISTransect::setZero()
 	{
 		// Set all values of the array to zero
-		for(unsigned int i = 0; i < transectWidth; ++i)
-		{
-			for(unsigned int j = 0; j < transectLength; ++j)
-			{
-				for(unsigned int k = 0; k < transectHeight; ++k)
-				{
-					transectData[i][j][k] = 0;
-				}
-			}
-		}
+		this->setVal(0);
 	}
 	void RSGISTransect::setVal(char newVal)
 	{
 		// Set all values of the array to newVal
-		for(unsigned int i = 0; i < transectWidth; ++i)
-		{
-			for(unsigned int j = 0; j < transectLength; ++j)
-			{
-				for(unsigned int k = 0; k < transectHeight; ++k)
-				{
-					transectData[i][j][k] = newVal;
-				}
-			}
-		}
+		size_t numVoxels = ((size_t) transectWidth) * transectLength * transectHeight;
+		memset(this->transectData, newVal, numVoxels);
 	}
 	unsigned int RSGISTransect::getWidth()
 	{
@@ -113,10 +84,28 @@ namespace rsgis{ namespace modeling  {
 			throw RSGISModelingException("Height greater than transect max!");
 		}
 		
-		char transectVal = transectData[xCord][yCord][this->transectHeight - zCord];
+		if(zCord == 0)
+		{
+			// Level 0 is never set (and is outside the column)
+			return 0;
+		}
+		
+		char transectVal = transectData[((((size_t) xCord) * transectLength) + yCord) * transectHeight + (this->transectHeight - zCord)];
 		return transectVal;
 		
 	}
+	const char* RSGISTransect::getColumn(unsigned int xCord, unsigned int yCord)
+	{
+		if(xCord >= transectWidth)
+		{
+			throw RSGISModelingException("Width greater than transect max!");
+		}
+		if(yCord >= transectLength)
+		{
+			throw RSGISModelingException("Lenght greater than transect max!");
+		}
+		return &transectData[((((size_t) xCord) * transectLength) + yCord) * transectHeight];
+	}
 	void RSGISTransect::setValue(unsigned int xCord, unsigned int yCord, unsigned int zCord, char transectVal)
 	{
 		// Only sets value if within transect, ignore is outside.
@@ -125,7 +114,36 @@ namespace rsgis{ namespace modeling  {
 		{
 			if((xCord < transectWidth) & (yCord < transectLength) & (zCord < transectHeight))
 			{
-				transectData[xCord][yCord][this->transectHeight - zCord] = transectVal;
+				transectData[((((size_t) xCord) * transectLength) + yCord) * transectHeight + (this->transectHeight - zCord)] = transectVal;
+			}
+		}
+	}
+	void RSGISTransect::setColumnSpan(unsigned int xCord, unsigned int yCord, unsigned int zMin, unsigned int zMax, char transectVal)
+	{
+		// Only sets values within transect (as setValue), ignore is outside.
+		if((xCord == 0) | (yCord == 0) | (xCord >= transectWidth) | (yCord >= transectLength) | (transectHeight < 2))
+		{
+			return;
+		}
+		zMin = std::max<unsigned int>(zMin, 1);
+		zMax = std::min<unsigned int>(zMax, transectHeight - 1);
+		if(zMin > zMax)
+		{
+			return;
+		}
+		// Heights are stored in reverse so the span runs from height - zMax to height - zMin
+		char *column = &transectData[((((size_t) xCord) * transectLength) + yCord) * transectHeight];
+		memset(&column[transectHeight - zMax], transectVal, (zMax - zMin) + 1);
+	}
+	void RSGISTransect::setBlock(unsigned int xMin, unsigned int xMax, unsigned int yMin, unsigned int yMax, unsigned int zMin, unsigned int zMax, char transectVal)
+	{
+		xMax = std::min<unsigned int>(xMax, transectWidth - 1);
+		yMax = std::min<unsigned int>(yMax, transectLength - 1);
+		for(unsigned int x = std::max<unsigned int>(xMin, 1); x <= xMax; ++x)
+		{
+			for(unsigned int y = std::max<unsigned int>(yMin, 1); y <= yMax; ++y)
+			{
+				this->setColumnSpan(x, y, zMin, zMax, transectVal);
 			}
 		}
 	}
@@ -133,19 +151,10 @@ namespace rsgis{ namespace modeling  {
 	{
 		unsigned int nPoints = 0;
 		
-		for(unsigned int i = 0; i < transectWidth; ++i)
+		size_t numVoxels = ((size_t) transectWidth) * transectLength * transectHeight;
+		for(size_t i = 0; i < numVoxels; ++i)
 		{
-			for(unsigned int j = 0; j < transectLength; ++j)
-			{
-				for(unsigned int k = 0; k < transectHeight; ++k)
-				{
-					unsigned int melement = transectData[i][j][k];
-					if(melement > 0)
-					{
-						nPoints++;
-					}
-				}
-			}
+			nPoints += (transectData[i] != 0);
 		}
 		
 		return nPoints;
@@ -165,7 +174,7 @@ namespace rsgis{ namespace modeling  {
 			{
 				for(unsigned int k = 0; k < transectHeight; k++)
 				{
-					mElement = transectData[j][i][k];
+					mElement = transectData[((((size_t) j) * transectLength) + i) * transectHeight + k];
 					if(mElement != 0)
 					{
 						imageMatrix->matrix[mIndex] = mElement;
@@ -204,7 +213,7 @@ namespace rsgis{ namespace modeling  {
 			{
 				for(unsigned int k = 0; k < transectHeight; k++)
 				{
-					unsigned int mElement = transectData[i][j][k];
+					unsigned int mElement = transectData[((((size_t) i) * transectLength) + j) * transectHeight + k];
 					if(mElement != 0)
 					{
 						xCoord[pIndex] = i;
@@ -230,15 +239,6 @@ namespace rsgis{ namespace modeling  {
 	
 	RSGISTransect::~RSGISTransect()
 	{
-		for(unsigned int i = 0; i < transectWidth; ++i)
-		{
-			for(unsigned int j = 0; j < transectLength; ++j)
-			{
-				delete[] transectData[i][j];
-			}
-			delete[] transectData[i];
-		}
 		delete[] transectData;
 	}
 }}
-
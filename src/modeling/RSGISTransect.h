@@ -25,6 +25,8 @@
 #define RSGISTransect_H
 
 #include <vector>
+#include <cstring>
+#include <algorithm>
 #include "modeling/RSGISModelingException.h"
 #include "math/RSGISMatrices.h"
 #include "utils/RSGISExportForPlotting.h"
@@ -45,7 +47,8 @@
 namespace rsgis{namespace modeling {
     
 	/** Class to store transect data
-	 * Data is stored as char.
+	 * Data is stored as char, in a single block with the columns (z) innermost
+	 * so a column can be read or filled (setColumnSpan) as one contiguous span.
 	 */
 	class DllExport RSGISTransect
 	{
@@ -65,8 +68,14 @@ namespace rsgis{namespace modeling {
 		double getRes();
 		/// Get transect value at point (x, y, z)
 		char getValue(unsigned int xCord, unsigned int yCord, unsigned int zCord);
+		/// Get the values of column (x, y), the value at height z (0 < z < height) is column[height - z]
+		const char* getColumn(unsigned int xCord, unsigned int yCord);
 		/// Get set point (x, y, z) to transectVal
 		void setValue(unsigned int xCord, unsigned int yCord, unsigned int zCord, char transectVal);
+		/// Set points (x, y, zMin) to (x, y, zMax) inclusive to transectVal, clipped as setValue
+		void setColumnSpan(unsigned int xCord, unsigned int yCord, unsigned int zMin, unsigned int zMax, char transectVal);
+		/// Set the points within [xMin, xMax], [yMin, yMax], [zMin, zMax] (inclusive) to transectVal, clipped as setValue
+		void setBlock(unsigned int xMin, unsigned int xMax, unsigned int yMin, unsigned int yMax, unsigned int zMin, unsigned int zMax, char transectVal);
 		/// Count the number of points in the transect
 		unsigned int countPoints();
 		/// Export transect as an image
@@ -81,7 +90,7 @@ namespace rsgis{namespace modeling {
 		unsigned int transectWidth;
 		unsigned int transectHeight;
 		double transectRes;
-		char ***transectData;
+		char *transectData;
 	};
 }}
 
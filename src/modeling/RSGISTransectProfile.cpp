@@ -0,0 +1,208 @@
+/*
+ *  RSGISTransectProfile.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISTransectProfile.h"
+
+namespace rsgis { namespace modeling {
+
+	RSGISTransectProfile::RSGISTransectProfile(RSGISTransect *transect)
+	{
+		this->transect = transect;
+		this->numX = transect->getWidth();
+		this->numY = transect->getLenth();
+		this->numZ = transect->getHeight();
+		this->numVegVoxels = 0;
+		this->numVegColumns = 0;
+		this->numThreads = rsgis::utils::getNumThreads();
+	}
+
+	void RSGISTransectProfile::setNumThreads(unsigned int numThreads)
+	{
+		this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+	}
+
+	void RSGISTransectProfile::calcProfile()
+	{
+		size_t numCols = ((size_t) this->numX) * this->numY;
+		this->groundHit.assign(numCols, 0);
+		this->groundHitStem.assign(numCols, 0);
+		this->topLeafHit.assign(numCols, 0);
+		this->topLevel.assign(numCols, -1);
+		this->vegLevelHist.assign(this->numZ, 0);
+		this->topLevelHist.assign(this->numZ, 0);
+		this->numVegVoxels = 0;
+		this->numVegColumns = 0;
+
+		rsgis::utils::RSGISWorkerPool pool(std::max<unsigned int>(std::min<unsigned int>(this->numThreads, this->numX), 1));
+		std::vector<std::vector<unsigned long long> > workerVegHists(pool.getNumThreads(), std::vector<unsigned long long>(this->numZ, 0));
+		std::vector<std::vector<unsigned long long> > workerTopHists(pool.getNumThreads(), std::vector<unsigned long long>(this->numZ, 0));
+		std::vector<unsigned long long> workerVegVoxels(pool.getNumThreads(), 0);
+		std::vector<unsigned long long> workerVegColumns(pool.getNumThreads(), 0);
+		pool.parallelFor(this->numX, [&](size_t x, unsigned int t)
+		{
+			std::vector<unsigned long long> &vegHist = workerVegHists[t];
+			std::vector<unsigned long long> &topHist = workerTopHists[t];
+			unsigned long long &vegVoxels = workerVegVoxels[t];
+			unsigned long long &vegColumns = workerVegColumns[t];
+			for(unsigned int y = 0; y < this->numY; ++y)
+			{
+				size_t idx = (((size_t) x) * this->numY) + y;
+				const char *column = this->transect->getColumn(x, y);
+				char ground = 0;
+				char groundStem = 0;
+				char topLeaf = 0;
+				int top = -1;
+				// Levels 1 to numZ-1 are held (in reverse) in column, level 0 is never set.
+				for(unsigned int z = this->numZ - 1; z > 0; --z)
+				{
+					char element = column[this->numZ - z];
+					if(element == 0)
+					{
+						continue;
+					}
+					++vegHist[z];
+					++vegVoxels;
+					if(top < 0)
+					{
+						top = z;
+					}
+					if(element == 2)
+					{
+						topLeaf = 1;
+					}
+					// Looking down, the last hit is the first from the ground.
+					if((element == 1) || (element == 2))
+					{
+						ground = element;
+						groundStem = element;
+					}
+					else if(element == 3)
+					{
+						groundStem = 1;
+					}
+				}
+				this->groundHit[idx] = ground;
+				this->groundHitStem[idx] = groundStem;
+				this->topLeafHit[idx] = topLeaf;
+				this->topLevel[idx] = top;
+				if(top >= 0)
+				{
+					++topHist[top];
+				}
+				if(ground != 0)
+				{
+					++vegColumns;
+				}
+			}
+		});
+		for(unsigned int t = 0; t < pool.getNumThreads(); ++t)
+		{
+			for(unsigned int z = 0; z < this->numZ; ++z)
+			{
+				this->vegLevelHist[z] += workerVegHists[t][z];
+				this->topLevelHist[z] += workerTopHists[t][z];
+			}
+			this->numVegVoxels += workerVegVoxels[t];
+			this->numVegColumns += workerVegColumns[t];
+		}
+	}
+
+	double RSGISTransectProfile::getCanopyCover()
+	{
+		size_t numCols = ((size_t) this->numX) * this->numY;
+		if(numCols == 0)
+		{
+			return 0;
+		}
+		return (double(this->numVegColumns) / double(numCols)) * 100;
+	}
+
+	double RSGISTransectProfile::histPercentile(const std::vector<unsigned long long> &hist, unsigned long long total, double percentile)
+	{
+		if(total == 0)
+		{
+			return 0;
+		}
+		// Nearest rank
+		unsigned long long rank = (unsigned long long) ceil((percentile / 100) * total);
+		rank = std::max<unsigned long long>(rank, 1);
+		unsigned long long count = 0;
+		for(unsigned int z = 0; z < hist.size(); ++z)
+		{
+			count += hist[z];
+			if(count >= rank)
+			{
+				return z * this->transect->getRes();
+			}
+		}
+		return (hist.size() - 1) * this->transect->getRes();
+	}
+
+	double RSGISTransectProfile::getCanopyHeightPercentile(double percentile)
+	{
+		unsigned long long numTops = 0;
+		for(std::vector<unsigned long long>::iterator iterHist = this->topLevelHist.begin(); iterHist != this->topLevelHist.end(); ++iterHist)
+		{
+			numTops += *iterHist;
+		}
+		return this->histPercentile(this->topLevelHist, numTops, percentile);
+	}
+
+	double RSGISTransectProfile::getMeanCanopyHeight()
+	{
+		unsigned long long numTops = 0;
+		double sumLevels = 0;
+		for(unsigned int z = 0; z < this->topLevelHist.size(); ++z)
+		{
+			numTops += this->topLevelHist[z];
+			sumLevels += double(z) * this->topLevelHist[z];
+		}
+		if(numTops == 0)
+		{
+			return 0;
+		}
+		return (sumLevels / numTops) * this->transect->getRes();
+	}
+
+	double RSGISTransectProfile::getMaxCanopyHeight()
+	{
+		for(unsigned int z = this->topLevelHist.size(); z > 0; --z)
+		{
+			if(this->topLevelHist[z-1] > 0)
+			{
+				return (z-1) * this->transect->getRes();
+			}
+		}
+		return 0;
+	}
+
+	double RSGISTransectProfile::getVegHeightPercentile(double percentile)
+	{
+		return this->histPercentile(this->vegLevelHist, this->numVegVoxels, percentile);
+	}
+
+	RSGISTransectProfile::~RSGISTransectProfile()
+	{
+
+	}
+
+}}
+
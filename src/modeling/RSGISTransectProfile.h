@@ -0,0 +1,108 @@
+/*
+ *  RSGISTransectProfile.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISTransectProfile_H
+#define RSGISTransectProfile_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+
+#include "modeling/RSGISTransect.h"
+#include "modeling/RSGISModelingException.h"
+#include "common/RSGISParallel.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_modeling_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis { namespace modeling {
+
+	/** Class to summarise the vertical columns of a transect in one pass.
+	 * Each (x, y) column is read once (the columns are split between threads, set
+	 * with setNumThreads or RSGISLIB_NUM_THREADS) and the first hit from the
+	 * ground and from the top, the canopy top and histograms of the heights of the
+	 * vegetation are stored in flat arrays, from which FPC (RSGISCalcFPC), cover
+	 * and the height metrics are derived without reading the transect again.
+	 * Heights are given as z * resolution.
+	 */
+	class DllExport RSGISTransectProfile
+	{
+	public:
+		RSGISTransectProfile(RSGISTransect *transect);
+		void setNumThreads(unsigned int numThreads);
+		/// Read the transect (again, if it has been modified)
+		void calcProfile();
+		/// First branch (1) or leaf (2) hit looking up from the ground (0 if none), optionally counting stems as branches
+		char getGroundHit(unsigned int x, unsigned int y, bool stemIsBranch=false)
+		{
+			return stemIsBranch?this->groundHitStem[(x * this->numY) + y]:this->groundHit[(x * this->numY) + y];
+		};
+		/// True if a leaf is hit looking down from the top
+		bool getTopLeafHit(unsigned int x, unsigned int y){return this->topLeafHit[(x * this->numY) + y] != 0;};
+		/// Level of the highest vegetation in the column (-1 if none)
+		int getTopLevel(unsigned int x, unsigned int y){return this->topLevel[(x * this->numY) + y];};
+		/// Percentage of the columns containing a branch or leaf (crown cover at the resolution of the transect)
+		double getCanopyCover();
+		/// Percentile (0 - 100) of the canopy top height of the columns containing vegetation
+		double getCanopyHeightPercentile(double percentile);
+		double getMeanCanopyHeight();
+		double getMaxCanopyHeight();
+		/// Percentile (0 - 100) of the heights of all the vegetation voxels
+		double getVegHeightPercentile(double percentile);
+		unsigned long long getNumVegVoxels(){return this->numVegVoxels;};
+		~RSGISTransectProfile();
+	protected:
+		double histPercentile(const std::vector<unsigned long long> &hist, unsigned long long total, double percentile);
+		RSGISTransect *transect;
+		unsigned int numX;
+		unsigned int numY;
+		unsigned int numZ;
+		unsigned int numThreads;
+		std::vector<char> groundHit;
+		std::vector<char> groundHitStem;
+		std::vector<char> topLeafHit;
+		std::vector<int> topLevel;
+		// Counts per level of the vegetation voxels and of the column tops
+		std::vector<unsigned long long> vegLevelHist;
+		std::vector<unsigned long long> topLevelHist;
+		unsigned long long numVegVoxels;
+		unsigned long long numVegColumns;
+	};
+
+}}
+
+#endif
+
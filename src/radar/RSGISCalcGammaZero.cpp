@@ -26,21 +26,28 @@
 
 namespace rsgis{namespace radar{
 	
-	RSGISCalcGammaZero::RSGISCalcGammaZero(int numberOutBands, bool deg) : RSGISCalcImageValue(numberOutBands)
+	RSGISCalcGammaZero::RSGISCalcGammaZero(int numberOutBands, bool deg, bool inBeta0, bool outputLinear) : RSGISCalcImageValue(numberOutBands)
 	{
 		this->deg = deg;
+		this->inBeta0 = inBeta0;
+		this->outputLinear = outputLinear;
 	}
 	
-	void RSGISCalcGammaZero::calcImageValue(float *bandValues, int numBands, double *output) 
+	void RSGISCalcGammaZero::checkNumBands(int numBands)
 	{
 		// Input bands
 		// Incidence Angle
 		// SAR data
-		
-		if(this->numOutBands != numBands-1)
+		int numSARBands = numBands-1;
+		if(this->numOutBands != (this->outputLinear?(2*numSARBands):numSARBands))
 		{
-			throw rsgis::img::RSGISImageCalcException("Number of input and output bands are the same!");
+			throw rsgis::img::RSGISImageCalcException("The number of output bands does not match the number of SAR bands (plus the linear bands if output).");
 		}
+	}
+	
+	void RSGISCalcGammaZero::calcImageValue(float *bandValues, int numBands, double *output) 
+	{
+		this->checkNumBands(numBands);
 		
 		double pi = 3.14159265358979323846;
 		double angle = 0;
@@ -53,10 +60,67 @@ namespace rsgis{namespace radar{
 		{
 			angle = bandValues[0];
 		}
+		double factor = this->inBeta0?tan(angle):(1/cos(angle));
 		
+		int dBOff = this->outputLinear?(numBands-1):0;
 		for(int i = 1; i < numBands; i++)
 		{
-			output[i-1] = 10*log10(bandValues[i]/cos(angle));
+			double gamma0 = bandValues[i] * factor;
+			if(this->outputLinear)
+			{
+				output[i-1] = gamma0;
+			}
+			output[dBOff+i-1] = (gamma0 > 0)?(10*log10(gamma0)):0;
+		}
+	}
+	
+	void RSGISCalcGammaZero::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+	{
+		this->checkNumBands(numBands);
+		
+		// The angle term is calculated once per pixel and shared by the SAR bands.
+		rsgis::RSGISScratchScope scratch(this->getScratchArena());
+		float *factor = scratch.alloc<float>(nPxls);
+		const float *anglePlane = bandPlanes[0];
+		const float angleScale = this->deg?(3.14159265358979323846/180):1;
+		if(this->inBeta0)
+		{
+			for(size_t j = 0; j < nPxls; ++j)
+			{
+				const float angle = anglePlane[j] * angleScale;
+				factor[j] = rsgisFastCos(angle - 1.57079633f) / rsgisFastCos(angle);
+			}
+		}
+		else
+		{
+			for(size_t j = 0; j < nPxls; ++j)
+			{
+				factor[j] = 1.0f / rsgisFastCos(anglePlane[j] * angleScale);
+			}
+		}
+		
+		int dBOff = this->outputLinear?(numBands-1):0;
+		for(int i = 1; i < numBands; ++i)
+		{
+			const float *inPlane = bandPlanes[i];
+			double *dBPlane = outPlanes[dBOff+i-1];
+			if(this->outputLinear)
+			{
+				double *linPlane = outPlanes[i-1];
+				for(size_t j = 0; j < nPxls; ++j)
+				{
+					const float gamma0 = inPlane[j] * factor[j];
+					linPlane[j] = gamma0;
+					dBPlane[j] = rsgisFastDB(gamma0);
+				}
+			}
+			else
+			{
+				for(size_t j = 0; j < nPxls; ++j)
+				{
+					dBPlane[j] = rsgisFastDB(inPlane[j] * factor[j]);
+				}
+			}
 		}
 	}
 	
@@ -31,6 +31,8 @@
 #include "img/RSGISCalcImageValue.h"
 #include "img/RSGISImageBandException.h"
 #include "img/RSGISImageCalcException.h"
+#include "common/RSGISScratchArena.h"
+#include "radar/RSGISRadarUtils.h"
 
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
@@ -50,10 +52,23 @@ namespace rsgis
 	namespace radar
 	{        
 		class DllExport RSGISCalcGammaZero : public rsgis::img::RSGISCalcImageValue
+			/**
+			 * Converts sigma0 (or beta0 if inBeta0) to gamma0 in dB:<br>
+			 * gamma0 = sigma0 / cos(incidence) = beta0 * tan(incidence)<br>
+			 * The first input band is the incidence angle (degrees if deg, otherwise
+			 * radians) and the rest the SAR bands in linear power. If outputLinear the
+			 * linear gamma0 bands are written first followed by the dB bands, so the
+			 * number of output bands is twice the number of SAR bands. Pixels where
+			 * gamma0 <= 0 are given 0 dB.<br>
+			 * calcImageBlock computes the whole calibration chain in one pass over
+			 * each plane with rsgisFastCos and rsgisFastDB (within 1e-4 dB).
+			 */
 			{
 			public: 
-				RSGISCalcGammaZero(int numberOutBands, bool deg);
+				RSGISCalcGammaZero(int numberOutBands, bool deg, bool inBeta0=false, bool outputLinear=false);
 				void calcImageValue(float *bandValues, int numBands, double *output);
+				void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
+				bool isThreadSafe(){return true;};
 				void calcImageValue(float *bandValues, int numBands);
                 void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
                 void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
@@ -64,7 +79,10 @@ namespace rsgis
 				bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output){throw rsgis::img::RSGISImageCalcException("Not implemented");};
 				~RSGISCalcGammaZero();
 			protected:
+				void checkNumBands(int numBands);
 				bool deg;
+				bool inBeta0;
+				bool outputLinear;
 			};
 	}
 }
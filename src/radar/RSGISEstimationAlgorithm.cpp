@@ -1972,6 +1972,13 @@ namespace rsgis {namespace radar
 				throw RSGISException("Must specify min / max values.");
 			}
 
+			this->ownedOptimiser = NULL;
+			this->inSigma0dB = NULL;
+			this->outPar = gsl_vector_alloc(this->numOutputPar + 1); // Output parameters + error
+			this->warmStartPar = gsl_vector_alloc(initialPar->size);
+			gsl_vector_memcpy(this->warmStartPar, initialPar);
+			this->useWarmStart = false;
+			this->havePrevPar = false;
 		}
 		void RSGISEstimationAlgorithmSingleSpecies::calcImageValue(float *bandValues, int numBands, double *output) 
 		{
@@ -1979,10 +1986,18 @@ namespace rsgis {namespace radar
 			rsgis::utils::RSGISAllometricEquations allometric = rsgis::utils::RSGISAllometricEquations();
 
 			species = rsgis::utils::aHarpophylla;
-			gsl_vector *inSigma0dB;
-			gsl_vector *outPar;
-			outPar = gsl_vector_alloc(this->numOutputPar + 1); // Output parameters + error
-			inSigma0dB = gsl_vector_alloc(numBands);
+			if((this->inSigma0dB == NULL) || (this->inSigma0dB->size != ((size_t) numBands)))
+			{
+				if(this->inSigma0dB != NULL){gsl_vector_free(this->inSigma0dB);}
+				this->inSigma0dB = gsl_vector_alloc(numBands);
+			}
+			gsl_vector *inSigma0dB = this->inSigma0dB;
+			gsl_vector *outPar = this->outPar;
+			gsl_vector *startPar = initialPar;
+			if(this->useWarmStart && this->havePrevPar)
+			{
+				startPar = this->warmStartPar;
+			}
 
 			// Check for no data (image borders)
 			if((bandValues[1] < -100) | (boost::math::isnan(bandValues[1])))
@@ -1991,6 +2006,7 @@ namespace rsgis {namespace radar
 				{
 					output[i] = 0;
 				}
+				this->havePrevPar = false;
 			}
 			else // Start Estimation
 			{
@@ -2002,7 +2018,8 @@ namespace rsgis {namespace radar
 				if(parameters == heightDensity) // Retrieve stem diameter and density
 				{
 
-					estOptimiser->minimise(inSigma0dB, initialPar, outPar);
+					estOptimiser->minimise(inSigma0dB, startPar, outPar);
+					this->updateWarmStart();
 
 					double height = gsl_vector_get(outPar, 0);
 					double density = gsl_vector_get(outPar, 1);
@@ -2048,7 +2065,8 @@ namespace rsgis {namespace radar
 				}
 				else if(parameters == cDepthDensity)  // Retrieve Canopy Depth and Stem densty
 				{
-					estOptimiser->minimise(inSigma0dB, initialPar, outPar);
+					estOptimiser->minimise(inSigma0dB, startPar, outPar);
+					this->updateWarmStart();
 
 					double height;
 					double cDepth = gsl_vector_get(outPar, 0);
@@ -2094,7 +2112,8 @@ namespace rsgis {namespace radar
 				}
 				else if(parameters == dielectricDensityHeight)
 				{
-					estOptimiser->minimise(inSigma0dB, initialPar, outPar);
+					estOptimiser->minimise(inSigma0dB, startPar, outPar);
+					this->updateWarmStart();
 
 					double height = gsl_vector_get(outPar, 0);
 					double density = gsl_vector_get(outPar, 1);
@@ -2127,13 +2146,52 @@ namespace rsgis {namespace radar
 
 			}
 
-			gsl_vector_free(inSigma0dB);
-			gsl_vector_free(outPar);
-
+		}
+		void RSGISEstimationAlgorithmSingleSpecies::updateWarmStart()
+		{
+			// Only start the next pixel from this one if the fit converged within the min / max values
+			this->havePrevPar = false;
+			if(!this->useWarmStart)
+			{
+				return;
+			}
+			double error = gsl_vector_get(this->outPar, this->numOutputPar);
+			if(boost::math::isnan(error) || boost::math::isinf(error))
+			{
+				return;
+			}
+			for(int i = 0; i < this->numOutputPar; i++)
+			{
+				double val = gsl_vector_get(this->outPar, i);
+				if(boost::math::isnan(val) || (val < this->minMaxVals[i][0]) || (val > this->minMaxVals[i][1]))
+				{
+					return;
+				}
+			}
+			for(int i = 0; (i < this->numOutputPar) && (i < ((int) this->warmStartPar->size)); i++)
+			{
+				gsl_vector_set(this->warmStartPar, i, gsl_vector_get(this->outPar, i));
+			}
+			this->havePrevPar = true;
+		}
+		rsgis::img::RSGISCalcImageValue* RSGISEstimationAlgorithmSingleSpecies::getThreadClone()
+		{
+			RSGISEstimationOptimiser *optClone = this->estOptimiser->getThreadClone();
+			if(optClone == NULL)
+			{
+				return NULL;
+			}
+			RSGISEstimationAlgorithmSingleSpecies *calcClone = new RSGISEstimationAlgorithmSingleSpecies(this->getNumOutBands(), this->initialPar, optClone, this->parameters, this->minMaxVals);
+			calcClone->ownedOptimiser = optClone;
+			calcClone->setWarmStart(this->useWarmStart);
+			return calcClone;
 		}
 		RSGISEstimationAlgorithmSingleSpecies::~RSGISEstimationAlgorithmSingleSpecies()
 		{
-
+			if(this->inSigma0dB != NULL){gsl_vector_free(this->inSigma0dB);}
+			gsl_vector_free(this->outPar);
+			gsl_vector_free(this->warmStartPar);
+			if(this->ownedOptimiser != NULL){delete this->ownedOptimiser;}
 		}
 
 		/***********************************
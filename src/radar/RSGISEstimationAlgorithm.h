@@ -270,8 +270,16 @@ namespace rsgis
 			virtual void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
             void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output, geos::geom::Envelope extent) {throw rsgis::img::RSGISImageCalcException("No implemented");};
 			virtual bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};													
+			/**
+			 * Start each pixel from the parameters retrieved for the previous pixel
+			 * (the neighbouring pixel on the row) when that fit converged within the
+			 * min / max values, rather than from the fixed initial parameters.
+			 */
+			void setWarmStart(bool useWarmStart){this->useWarmStart = useWarmStart; this->havePrevPar = false;};
+			rsgis::img::RSGISCalcImageValue* getThreadClone();
 			~RSGISEstimationAlgorithmSingleSpecies();
 		protected:
+			void updateWarmStart();
 			gsl_vector *initialPar;
 			estParameters parameters;
 			rsgis::utils::treeSpecies species;
@@ -280,6 +288,12 @@ namespace rsgis
 			int numOutputBands;
 			double **minMaxVals;  // Array of arrays to hold min, max values for estimation
 			bool useDefaultMinMax; // Use default min-max values for parameters
+			RSGISEstimationOptimiser *ownedOptimiser; // Optimiser created for a thread clone
+			gsl_vector *inSigma0dB;
+			gsl_vector *outPar;
+			gsl_vector *warmStartPar;
+			bool useWarmStart;
+			bool havePrevPar;
 		};
 		
 		class DllExport RSGISEstimationAlgorithmSingleSpeciesMask : public rsgis::img::RSGISCalcImageValue
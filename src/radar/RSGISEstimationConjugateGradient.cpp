@@ -913,19 +913,19 @@ namespace rsgis {namespace radar
 			double alpha = 0;
 
 			// Allocate vectors and matrices
-			estimatedPar = gsl_vector_alloc(nPar);
-			frechet = gsl_matrix_alloc(nPar,nData);
-			frechetT = gsl_matrix_alloc(nData,nPar);
-			dPredictMeas = gsl_vector_alloc(nData);
-			predicted = gsl_vector_alloc(nData);
-			gamma = gsl_vector_alloc(nPar);
-			aux1 = gsl_vector_alloc(nData);
-			aux2 = gsl_vector_alloc(nPar);
-			aux3 = gsl_vector_alloc(nData);
-			xPowers = gsl_vector_alloc(order);
-			yPowers = gsl_vector_alloc(order);
-			dxPowers = gsl_vector_alloc(order);
-			dyPowers = gsl_vector_alloc(order);
+			estimatedPar = this->workspace.getVector(0, nPar);
+			frechet = this->workspace.getMatrix(0, nPar,nData);
+			frechetT = this->workspace.getMatrix(1, nData,nPar);
+			dPredictMeas = this->workspace.getVector(1, nData);
+			predicted = this->workspace.getVector(2, nData);
+			gamma = this->workspace.getVector(3, nPar);
+			aux1 = this->workspace.getVector(4, nData);
+			aux2 = this->workspace.getVector(5, nPar);
+			aux3 = this->workspace.getVector(6, nData);
+			xPowers = this->workspace.getVector(7, order);
+			yPowers = this->workspace.getVector(8, order);
+			dxPowers = this->workspace.getVector(9, order);
+			dyPowers = this->workspace.getVector(10, order);
 
 			double height = 0.0;
 			double density = 0.0;
@@ -1117,21 +1117,6 @@ namespace rsgis {namespace radar
 				gsl_vector_set(outParError, nPar, error);
 			}
 
-			// FREE MATRICES
-			gsl_vector_free(estimatedPar);
-			gsl_matrix_free(frechet);
-			gsl_matrix_free(frechetT);
-			gsl_vector_free(dPredictMeas);
-			gsl_vector_free(predicted);
-			gsl_vector_free(gamma);
-			gsl_vector_free(aux1);
-			gsl_vector_free(aux2);
-			gsl_vector_free(aux3);
-			gsl_vector_free(xPowers);
-			gsl_vector_free(yPowers);
-			gsl_vector_free(dxPowers);
-			gsl_vector_free(dyPowers);
-
 			return 1;
 		}
 		RSGISEstimationConjugateGradient2DPoly2Channel::~RSGISEstimationConjugateGradient2DPoly2Channel()
@@ -1139,6 +1124,11 @@ namespace rsgis {namespace radar
 			gsl_matrix_free(invCovMatrixP);
 		}
 
+		RSGISEstimationOptimiser* RSGISEstimationConjugateGradient2DPoly2Channel::getThreadClone()
+		{
+			return new RSGISEstimationConjugateGradient2DPoly2Channel(this->coeffHH, this->coeffHV, this->covMatrixP, this->invCovMatrixD, this->ittmax);
+		}
+
 
 		RSGISEstimationConjugateGradient3DPoly3Channel::RSGISEstimationConjugateGradient3DPoly3Channel(gsl_matrix *coeffHH, gsl_matrix *coeffHV, gsl_matrix *coeffVV,
 																									   int orderX, int orderY, int orderZ,
@@ -1185,21 +1175,21 @@ namespace rsgis {namespace radar
 			double alpha = 0;
 
 			// Allocate vectors and matrices
-			estimatedPar = gsl_vector_alloc(nPar);
-			frechet = gsl_matrix_alloc(nPar,nData);
-			frechetT = gsl_matrix_alloc(nData,nPar);
-			dPredictMeas = gsl_vector_alloc(nData);
-			predicted = gsl_vector_alloc(nData);
-			gamma = gsl_vector_alloc(nPar);
-			xPowers = gsl_vector_alloc(orderX);
-			yPowers = gsl_vector_alloc(orderY);
-			zPowers = gsl_vector_alloc(orderZ);
-			dxPowers = gsl_vector_alloc(orderX);
-			dyPowers = gsl_vector_alloc(orderY);
-			dzPowers = gsl_vector_alloc(orderZ);
-			aux1 = gsl_vector_alloc(nData);
-			aux2 = gsl_vector_alloc(nPar);
-			aux3 = gsl_vector_alloc(nData);
+			estimatedPar = this->workspace.getVector(0, nPar);
+			frechet = this->workspace.getMatrix(0, nPar,nData);
+			frechetT = this->workspace.getMatrix(1, nData,nPar);
+			dPredictMeas = this->workspace.getVector(1, nData);
+			predicted = this->workspace.getVector(2, nData);
+			gamma = this->workspace.getVector(3, nPar);
+			xPowers = this->workspace.getVector(4, orderX);
+			yPowers = this->workspace.getVector(5, orderY);
+			zPowers = this->workspace.getVector(6, orderZ);
+			dxPowers = this->workspace.getVector(7, orderX);
+			dyPowers = this->workspace.getVector(8, orderY);
+			dzPowers = this->workspace.getVector(9, orderZ);
+			aux1 = this->workspace.getVector(10, nData);
+			aux2 = this->workspace.getVector(11, nPar);
+			aux3 = this->workspace.getVector(12, nData);
 
 			// Set vectors and matrices to zero
 			gsl_vector_set_zero(estimatedPar);
@@ -1448,21 +1438,6 @@ namespace rsgis {namespace radar
 					}
 					gsl_vector_set(outParError, nPar, error);
 
-					gsl_vector_free(estimatedPar);
-					gsl_matrix_free(frechet);
-					gsl_matrix_free(frechetT);
-					gsl_vector_free(predicted);
-					gsl_vector_free(dPredictMeas);
-					gsl_vector_free(gamma);
-					gsl_vector_free(xPowers);
-					gsl_vector_free(yPowers);
-					gsl_vector_free(zPowers);
-					gsl_vector_free(dxPowers);
-					gsl_vector_free(dyPowers);
-					gsl_vector_free(dzPowers);
-					gsl_vector_free(aux1);
-					gsl_vector_free(aux2);
-					gsl_vector_free(aux3);
 
 					if (error < minError)
 					{
@@ -1520,23 +1495,6 @@ namespace rsgis {namespace radar
 				}
 			}
 
-			// FREE MATRICES
-			gsl_vector_free(estimatedPar);
-			gsl_matrix_free(frechet);
-			gsl_matrix_free(frechetT);
-			gsl_vector_free(predicted);
-			gsl_vector_free(dPredictMeas);
-			gsl_vector_free(gamma);
-			gsl_vector_free(xPowers);
-			gsl_vector_free(yPowers);
-			gsl_vector_free(zPowers);
-			gsl_vector_free(dxPowers);
-			gsl_vector_free(dyPowers);
-			gsl_vector_free(dzPowers);
-			gsl_vector_free(aux1);
-			gsl_vector_free(aux2);
-			gsl_vector_free(aux3);
-
 			return 0;
 		}
 		RSGISEstimationConjugateGradient3DPoly3Channel::~RSGISEstimationConjugateGradient3DPoly3Channel()
@@ -1544,6 +1502,11 @@ namespace rsgis {namespace radar
 			gsl_matrix_free(invCovMatrixP);
 		}
 
+		RSGISEstimationOptimiser* RSGISEstimationConjugateGradient3DPoly3Channel::getThreadClone()
+		{
+			return new RSGISEstimationConjugateGradient3DPoly3Channel(this->coeffHH, this->coeffHV, this->coeffVV, this->orderX, this->orderY, this->orderZ, this->aPrioriPar, this->covMatrixP, this->invCovMatrixD, this->minError, this->ittmax);
+		}
+
 		RSGISEstimationConjugateGradient3DPoly4Channel::RSGISEstimationConjugateGradient3DPoly4Channel(gsl_matrix *coeffA, gsl_matrix *coeffB, gsl_matrix *coeffC, gsl_matrix *coeffD,
 																									   int orderX, int orderY, int orderZ,
 																									   gsl_vector *aPrioriPar, gsl_matrix *covMatrixP, gsl_matrix *invCovMatrixD,
@@ -1589,21 +1552,21 @@ namespace rsgis {namespace radar
 			double alpha = 0;
 
 			// Allocate vectors and matrices
-			estimatedPar = gsl_vector_alloc(nPar);
-			frechet = gsl_matrix_alloc(nPar,nData);
-			frechetT = gsl_matrix_alloc(nData,nPar);
-			dPredictMeas = gsl_vector_alloc(nData);
-			predicted = gsl_vector_alloc(nData);
-			gamma = gsl_vector_alloc(nPar);
-			xPowers = gsl_vector_alloc(orderX);
-			yPowers = gsl_vector_alloc(orderY);
-			zPowers = gsl_vector_alloc(orderZ);
-			dxPowers = gsl_vector_alloc(orderX);
-			dyPowers = gsl_vector_alloc(orderY);
-			dzPowers = gsl_vector_alloc(orderZ);
-			aux1 = gsl_vector_alloc(nData);
-			aux2 = gsl_vector_alloc(nPar);
-			aux3 = gsl_vector_alloc(nData);
+			estimatedPar = this->workspace.getVector(0, nPar);
+			frechet = this->workspace.getMatrix(0, nPar,nData);
+			frechetT = this->workspace.getMatrix(1, nData,nPar);
+			dPredictMeas = this->workspace.getVector(1, nData);
+			predicted = this->workspace.getVector(2, nData);
+			gamma = this->workspace.getVector(3, nPar);
+			xPowers = this->workspace.getVector(4, orderX);
+			yPowers = this->workspace.getVector(5, orderY);
+			zPowers = this->workspace.getVector(6, orderZ);
+			dxPowers = this->workspace.getVector(7, orderX);
+			dyPowers = this->workspace.getVector(8, orderY);
+			dzPowers = this->workspace.getVector(9, orderZ);
+			aux1 = this->workspace.getVector(10, nData);
+			aux2 = this->workspace.getVector(11, nPar);
+			aux3 = this->workspace.getVector(12, nData);
 
 			// Set vectors and matrices to zero
 			gsl_vector_set_zero(estimatedPar);
@@ -1903,21 +1866,6 @@ namespace rsgis {namespace radar
 					}
 					gsl_vector_set(outParError, nPar, error);
 
-					gsl_vector_free(estimatedPar);
-					gsl_matrix_free(frechet);
-					gsl_vector_free(predicted);
-					gsl_matrix_free(frechetT);
-					gsl_vector_free(dPredictMeas);
-					gsl_vector_free(gamma);
-					gsl_vector_free(xPowers);
-					gsl_vector_free(yPowers);
-					gsl_vector_free(zPowers);
-					gsl_vector_free(dxPowers);
-					gsl_vector_free(dyPowers);
-					gsl_vector_free(dzPowers);
-					gsl_vector_free(aux1);
-					gsl_vector_free(aux2);
-					gsl_vector_free(aux3);
 
 					if (error < minError)
 					{
@@ -1973,23 +1921,6 @@ namespace rsgis {namespace radar
 				}
 			}
 
-			// FREE MATRICES
-			gsl_vector_free(estimatedPar);
-			gsl_matrix_free(frechet);
-			gsl_matrix_free(frechetT);
-			gsl_vector_free(predicted);
-			gsl_vector_free(dPredictMeas);
-			gsl_vector_free(gamma);
-			gsl_vector_free(xPowers);
-			gsl_vector_free(yPowers);
-			gsl_vector_free(zPowers);
-			gsl_vector_free(dxPowers);
-			gsl_vector_free(dyPowers);
-			gsl_vector_free(dzPowers);
-			gsl_vector_free(aux1);
-			gsl_vector_free(aux2);
-			gsl_vector_free(aux3);
-
 			return 0;
 		}
 		RSGISEstimationConjugateGradient3DPoly4Channel::~RSGISEstimationConjugateGradient3DPoly4Channel()
@@ -1997,6 +1928,11 @@ namespace rsgis {namespace radar
 			gsl_matrix_free(invCovMatrixP);
 		}
 
+		RSGISEstimationOptimiser* RSGISEstimationConjugateGradient3DPoly4Channel::getThreadClone()
+		{
+			return new RSGISEstimationConjugateGradient3DPoly4Channel(this->coeffA, this->coeffB, this->coeffC, this->coeffD, this->orderX, this->orderY, this->orderZ, this->aPrioriPar, this->covMatrixP, this->invCovMatrixD, this->minError, this->ittmax);
+		}
+
 		RSGISEstimationConjugateGradient2Var2Data::RSGISEstimationConjugateGradient2Var2Data(
 																							 rsgis::math::RSGISMathTwoVariableFunction *functionA,
 																							 rsgis::math::RSGISMathTwoVariableFunction *functionB,
@@ -2038,15 +1974,15 @@ namespace rsgis {namespace radar
 			double alpha = 0;
 
 			// Allocate vectors and matrices
-			estimatedPar = gsl_vector_alloc(nPar);
-			predicted = gsl_vector_alloc(nData);
-			frechet = gsl_matrix_alloc(nPar,nData);
-			frechetT = gsl_matrix_alloc(nData,nPar);
-			dPredictMeas = gsl_vector_alloc(nData);
-			gamma = gsl_vector_alloc(nPar);
-			aux1 = gsl_vector_alloc(nData);
-			aux2 = gsl_vector_alloc(nPar);
-			aux3 = gsl_vector_alloc(nData);
+			estimatedPar = this->workspace.getVector(0, nPar);
+			predicted = this->workspace.getVector(1, nData);
+			frechet = this->workspace.getMatrix(0, nPar,nData);
+			frechetT = this->workspace.getMatrix(1, nData,nPar);
+			dPredictMeas = this->workspace.getVector(2, nData);
+			gamma = this->workspace.getVector(3, nPar);
+			aux1 = this->workspace.getVector(4, nData);
+			aux2 = this->workspace.getVector(5, nPar);
+			aux3 = this->workspace.getVector(6, nData);
 
 			double height = 0.0;
 			double density = 0.0;
@@ -2123,15 +2059,6 @@ namespace rsgis {namespace radar
                         gsl_vector_set(outParError, nPar,9999);
                     }
 
-					gsl_vector_free(estimatedPar);
-					gsl_vector_free(predicted);
-					gsl_matrix_free(frechet);
-					gsl_matrix_free(frechetT);
-					gsl_vector_free(dPredictMeas);
-					gsl_vector_free(gamma);
-					gsl_vector_free(aux1);
-					gsl_vector_free(aux2);
-					gsl_vector_free(aux3);
 
 					if (error < minError)
 					{
@@ -2185,17 +2112,6 @@ namespace rsgis {namespace radar
 				}
 			}
 
-            // FREE MATRICES
-			gsl_vector_free(estimatedPar);
-			gsl_vector_free(predicted);
-			gsl_matrix_free(frechet);
-			gsl_matrix_free(frechetT);
-			gsl_vector_free(dPredictMeas);
-			gsl_vector_free(gamma);
-			gsl_vector_free(aux1);
-			gsl_vector_free(aux2);
-			gsl_vector_free(aux3);
-
 			return 0;
 		}
 
@@ -2205,6 +2121,11 @@ namespace rsgis {namespace radar
 			gsl_vector_free(this->aPrioriPar);
 		}
 
+		RSGISEstimationOptimiser* RSGISEstimationConjugateGradient2Var2Data::getThreadClone()
+		{
+			return new RSGISEstimationConjugateGradient2Var2Data(this->functionA, this->functionB, this->aPrioriPar, this->covMatrixP, this->invCovMatrixD, this->minError, this->ittmax);
+		}
+
 		RSGISEstimationConjugateGradient2Var3Data::RSGISEstimationConjugateGradient2Var3Data(
 																							 rsgis::math::RSGISMathTwoVariableFunction *functionA,
 																							 rsgis::math::RSGISMathTwoVariableFunction *functionB,
@@ -2250,15 +2171,15 @@ namespace rsgis {namespace radar
 			double alpha = 0;
 
 			// Allocate vectors and matrices
-			estimatedPar = gsl_vector_alloc(nPar);
-			predicted = gsl_vector_alloc(nData);
-			frechet = gsl_matrix_alloc(nPar,nData);
-			frechetT = gsl_matrix_alloc(nData,nPar);
-			dPredictMeas = gsl_vector_alloc(nData);
-			gamma = gsl_vector_alloc(nPar);
-			aux1 = gsl_vector_alloc(nData);
-			aux2 = gsl_vector_alloc(nPar);
-			aux3 = gsl_vector_alloc(nData);
+			estimatedPar = this->workspace.getVector(0, nPar);
+			predicted = this->workspace.getVector(1, nData);
+			frechet = this->workspace.getMatrix(0, nPar,nData);
+			frechetT = this->workspace.getMatrix(1, nData,nPar);
+			dPredictMeas = this->workspace.getVector(2, nData);
+			gamma = this->workspace.getVector(3, nPar);
+			aux1 = this->workspace.getVector(4, nData);
+			aux2 = this->workspace.getVector(5, nPar);
+			aux3 = this->workspace.getVector(6, nData);
 
 			double height = 0.0;
 			double density = 0.0;
@@ -2329,15 +2250,6 @@ namespace rsgis {namespace radar
 					}
 					gsl_vector_set(outParError, nPar, error);
 
-					gsl_vector_free(estimatedPar);
-					gsl_vector_free(predicted);
-					gsl_matrix_free(frechet);
-					gsl_matrix_free(frechetT);
-					gsl_vector_free(dPredictMeas);
-					gsl_vector_free(gamma);
-					gsl_vector_free(aux1);
-					gsl_vector_free(aux2);
-					gsl_vector_free(aux3);
 
 					if (error < minError)
 					{
@@ -2391,17 +2303,6 @@ namespace rsgis {namespace radar
 				}
 			}
 
-			// FREE MATRICES
-			gsl_vector_free(estimatedPar);
-			gsl_vector_free(predicted);
-			gsl_matrix_free(frechet);
-			gsl_matrix_free(frechetT);
-			gsl_vector_free(dPredictMeas);
-			gsl_vector_free(gamma);
-			gsl_vector_free(aux1);
-			gsl_vector_free(aux2);
-			gsl_vector_free(aux3);
-
 			return 0;
 		}
 		RSGISEstimationConjugateGradient2Var3Data::~RSGISEstimationConjugateGradient2Var3Data()
@@ -2410,6 +2311,11 @@ namespace rsgis {namespace radar
 			gsl_vector_free(this->aPrioriPar);
 		}
 
+		RSGISEstimationOptimiser* RSGISEstimationConjugateGradient2Var3Data::getThreadClone()
+		{
+			return new RSGISEstimationConjugateGradient2Var3Data(this->functionA, this->functionB, this->functionC, this->aPrioriPar, this->covMatrixP, this->invCovMatrixD, this->minError, this->ittmax);
+		}
+
 		RSGISEstimationConjugateGradient2Var2DataWithRestarts::RSGISEstimationConjugateGradient2Var2DataWithRestarts(
 																													 rsgis::math::RSGISMathTwoVariableFunction *functionA,
 																													 rsgis::math::RSGISMathTwoVariableFunction *functionB,
@@ -2447,8 +2353,8 @@ namespace rsgis {namespace radar
 			gsl_vector *currentParError;
 			gsl_vector *testInitialPar;
 
-			currentParError = gsl_vector_alloc(3);
-			testInitialPar = gsl_vector_alloc(2);
+			currentParError = this->workspace.getVector(0, 3);
+			testInitialPar = this->workspace.getVector(1, 2);
 
 			gsl_vector_set(outParError, 0, gsl_vector_get(initialPar, 0));
 			gsl_vector_set(outParError, 1, gsl_vector_get(initialPar, 1));
@@ -2465,8 +2371,6 @@ namespace rsgis {namespace radar
 			{
 				// If initial parameters are less than target error only one
 				// run is required.
-				gsl_vector_free(currentParError);
-				gsl_vector_free(testInitialPar);
 				return 1;
 			}
 
@@ -2492,9 +2396,7 @@ namespace rsgis {namespace radar
 
 							if (gsl_vector_get(outParError, 2) < minError)
 							{
-								// free memory and terminate if target error is reached.
-								gsl_vector_free(currentParError);
-								gsl_vector_free(testInitialPar);
+								// terminate if target error is reached.
 								return 1;
 							}
 						}
@@ -2518,16 +2420,12 @@ namespace rsgis {namespace radar
 
 					if (gsl_vector_get(outParError, 2) < minError)
 					{
-						// free memory and terminate if target error is reached.
-						gsl_vector_free(currentParError);
-						gsl_vector_free(testInitialPar);
+						// terminate if target error is reached.
 						return 1;
 					}
 				}
 			}
 
-			gsl_vector_free(currentParError);
-			gsl_vector_free(testInitialPar);
 
 			return 0;
 		}
@@ -2538,6 +2436,11 @@ namespace rsgis {namespace radar
 			gsl_matrix_free(invCovMatrixP);
 		}
 
+		RSGISEstimationOptimiser* RSGISEstimationConjugateGradient2Var2DataWithRestarts::getThreadClone()
+		{
+			return new RSGISEstimationConjugateGradient2Var2DataWithRestarts(this->functionA, this->functionB, this->minMaxIntervalA, this->minMaxIntervalB, this->aPrioriPar, this->covMatrixP, this->invCovMatrixD, this->minError, this->ittmax, this->nRestarts);
+		}
+
 		RSGISEstimationConjugateGradient2Var3DataWithRestarts::RSGISEstimationConjugateGradient2Var3DataWithRestarts(
 																													 rsgis::math::RSGISMathTwoVariableFunction *functionA,
 																													 rsgis::math::RSGISMathTwoVariableFunction *functionB,
@@ -2576,8 +2479,8 @@ namespace rsgis {namespace radar
 			gsl_vector *currentParError;
 			gsl_vector *testInitialPar;
 
-			currentParError = gsl_vector_alloc(3);
-			testInitialPar = gsl_vector_alloc(2);
+			currentParError = this->workspace.getVector(0, 3);
+			testInitialPar = this->workspace.getVector(1, 2);
 
 			gsl_vector_set(outParError, 0, gsl_vector_get(initialPar, 0));
 			gsl_vector_set(outParError, 1, gsl_vector_get(initialPar, 1));
@@ -2596,8 +2499,6 @@ namespace rsgis {namespace radar
 			{
 				// If initial parameters are less than target error only one
 				// run is required.
-				gsl_vector_free(currentParError);
-				gsl_vector_free(testInitialPar);
 				return 1;
 			}
 
@@ -2624,9 +2525,7 @@ namespace rsgis {namespace radar
 
 							if (gsl_vector_get(outParError, 2) < minError)
 							{
-								// free memory and terminate if target error is reached.
-								gsl_vector_free(currentParError);
-								gsl_vector_free(testInitialPar);
+								// terminate if target error is reached.
 								return 1;
 							}
 						}
@@ -2651,16 +2550,12 @@ namespace rsgis {namespace radar
 
 					if (gsl_vector_get(outParError, 2) < minError)
 					{
-						// free memory and terminate if target error is reached.
-						gsl_vector_free(currentParError);
-						gsl_vector_free(testInitialPar);
+						// terminate if target error is reached.
 						return 1;
 					}
 				}
 			}
 
-			gsl_vector_free(currentParError);
-			gsl_vector_free(testInitialPar);
 
 			return 0;
 
@@ -2671,6 +2566,11 @@ namespace rsgis {namespace radar
 			gsl_matrix_free(invCovMatrixP);
 		}
 
+		RSGISEstimationOptimiser* RSGISEstimationConjugateGradient2Var3DataWithRestarts::getThreadClone()
+		{
+			return new RSGISEstimationConjugateGradient2Var3DataWithRestarts(this->functionA, this->functionB, this->functionC, this->minMaxIntervalA, this->minMaxIntervalB, this->aPrioriPar, this->covMatrixP, this->invCovMatrixD, this->minError, this->ittmax, this->nRestarts);
+		}
+
 		RSGISEstimationConjugateGradient3Var3DataWithRestarts::RSGISEstimationConjugateGradient3Var3DataWithRestarts(gsl_matrix *coeffHH, gsl_matrix *coeffHV, gsl_matrix *coeffVV,
 																													 int orderX, int orderY, int orderZ,
 																													 double *minMaxIntervalA,
@@ -2685,6 +2585,12 @@ namespace rsgis {namespace radar
 																													 )
 		{
 			rsgis::math::RSGISMatrices matrixUtils;
+			this->coeffHH = coeffHH;
+			this->coeffHV = coeffHV;
+			this->coeffVV = coeffVV;
+			this->orderX = orderX;
+			this->orderY = orderY;
+			this->orderZ = orderZ;
 			this->minMaxIntervalA = minMaxIntervalA;
 			this->minMaxIntervalB = minMaxIntervalB;
 			this->minMaxIntervalC = minMaxIntervalC;
@@ -2703,8 +2609,8 @@ namespace rsgis {namespace radar
 			gsl_vector *currentParError;
 			gsl_vector *testInitialPar;
 
-			currentParError = gsl_vector_alloc(4);
-			testInitialPar = gsl_vector_alloc(3);
+			currentParError = this->workspace.getVector(0, 4);
+			testInitialPar = this->workspace.getVector(1, 3);
 
 			gsl_vector_set(outParError, 0, gsl_vector_get(initialPar, 0));
 			gsl_vector_set(outParError, 1, gsl_vector_get(initialPar, 1));
@@ -2727,9 +2633,7 @@ namespace rsgis {namespace radar
 
                 if (gsl_vector_get(outParError, 3) < minError)
                 {
-                    // free memory and terminate if target error is reached.
-                    gsl_vector_free(currentParError);
-                    gsl_vector_free(testInitialPar);
+                    // terminate if target error is reached.
                     return 1;
                 }
             }
@@ -2764,9 +2668,7 @@ namespace rsgis {namespace radar
 
 								if (gsl_vector_get(outParError, 3) < minError)
 								{
-									// free memory and terminate if target error is reached.
-									gsl_vector_free(currentParError);
-									gsl_vector_free(testInitialPar);
+									// terminate if target error is reached.
 									return 1;
 								}
 							}
@@ -2795,16 +2697,12 @@ namespace rsgis {namespace radar
 
 					if (gsl_vector_get(outParError, 3) < minError)
 					{
-						// free memory and terminate if target error is reached.
-						gsl_vector_free(currentParError);
-						gsl_vector_free(testInitialPar);
+						// terminate if target error is reached.
 						return 1;
 					}
 				}
 			}
 
-			gsl_vector_free(currentParError);
-			gsl_vector_free(testInitialPar);
 
 			return 0;
 		}
@@ -2813,6 +2711,11 @@ namespace rsgis {namespace radar
 			delete conjGradOpt;
 		}
 
+		RSGISEstimationOptimiser* RSGISEstimationConjugateGradient3Var3DataWithRestarts::getThreadClone()
+		{
+			return new RSGISEstimationConjugateGradient3Var3DataWithRestarts(this->coeffHH, this->coeffHV, this->coeffVV, this->orderX, this->orderY, this->orderZ, this->minMaxIntervalA, this->minMaxIntervalB, this->minMaxIntervalC, this->aPrioriPar, this->covMatrixP, this->invCovMatrixD, this->minError, this->ittmax, this->nRestarts);
+		}
+
 		RSGISEstimationConjugateGradient3Var4DataWithRestarts::RSGISEstimationConjugateGradient3Var4DataWithRestarts(gsl_matrix *coeffA, gsl_matrix *coeffB, gsl_matrix *coeffC, gsl_matrix *coeffD,
 																													 int orderX, int orderY, int orderZ,
 																													 double *minMaxIntervalA,
@@ -2827,6 +2730,13 @@ namespace rsgis {namespace radar
 																													 )
 		{
 			rsgis::math::RSGISMatrices matrixUtils;
+			this->coeffA = coeffA;
+			this->coeffB = coeffB;
+			this->coeffC = coeffC;
+			this->coeffD = coeffD;
+			this->orderX = orderX;
+			this->orderY = orderY;
+			this->orderZ = orderZ;
 			this->minMaxIntervalA = minMaxIntervalA;
 			this->minMaxIntervalB = minMaxIntervalB;
 			this->minMaxIntervalC = minMaxIntervalC;
@@ -2845,8 +2755,8 @@ namespace rsgis {namespace radar
 			gsl_vector *currentParError;
 			gsl_vector *testInitialPar;
 
-			currentParError = gsl_vector_alloc(4);
-			testInitialPar = gsl_vector_alloc(3);
+			currentParError = this->workspace.getVector(0, 4);
+			testInitialPar = this->workspace.getVector(1, 3);
 
 			gsl_vector_set(outParError, 0, gsl_vector_get(initialPar, 0));
 			gsl_vector_set(outParError, 1, gsl_vector_get(initialPar, 1));
@@ -2870,9 +2780,7 @@ namespace rsgis {namespace radar
 
                 if (gsl_vector_get(outParError, 3) < minError)
                 {
-                    // free memory and terminate if target error is reached.
-                    gsl_vector_free(currentParError);
-                    gsl_vector_free(testInitialPar);
+                    // terminate if target error is reached.
                     return 1;
                 }
             }
@@ -2905,9 +2813,7 @@ namespace rsgis {namespace radar
 
 								if (gsl_vector_get(outParError, 3) < minError)
 								{
-									// free memory and terminate if target error is reached.
-									gsl_vector_free(currentParError);
-									gsl_vector_free(testInitialPar);
+									// terminate if target error is reached.
 									return 1;
 								}
 							}
@@ -2936,16 +2842,12 @@ namespace rsgis {namespace radar
 
 					if (gsl_vector_get(outParError, 2) < minError)
 					{
-						// free memory and terminate if target error is reached.
-						gsl_vector_free(currentParError);
-						gsl_vector_free(testInitialPar);
+						// terminate if target error is reached.
 						return 1;
 					}
 				}
 			}
 
-			gsl_vector_free(currentParError);
-			gsl_vector_free(testInitialPar);
 
 			return 0;
 		}
@@ -2954,5 +2856,10 @@ namespace rsgis {namespace radar
 			delete conjGradOpt;
 		}
 
+		RSGISEstimationOptimiser* RSGISEstimationConjugateGradient3Var4DataWithRestarts::getThreadClone()
+		{
+			return new RSGISEstimationConjugateGradient3Var4DataWithRestarts(this->coeffA, this->coeffB, this->coeffC, this->coeffD, this->orderX, this->orderY, this->orderZ, this->minMaxIntervalA, this->minMaxIntervalB, this->minMaxIntervalC, this->aPrioriPar, this->covMatrixP, this->invCovMatrixD, this->minError, this->ittmax, this->nRestarts);
+		}
+
 	}}
 
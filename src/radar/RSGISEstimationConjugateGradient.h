@@ -89,6 +89,7 @@ namespace rsgis {namespace radar{
 		void modifyAPriori(gsl_vector *newAPrioriPar){};
 		virtual estOptimizerType getOptimiserType(){return conjugateGradient;};
 		virtual void printOptimiser(){std::cout << "Conjugate gradient (Polynomial) - 2 Var 2 Data" << std::endl;};
+		RSGISEstimationOptimiser* getThreadClone();
 		~RSGISEstimationConjugateGradient2DPoly2Channel();
 	private:
 		gsl_matrix *coeffHH;
@@ -114,6 +115,7 @@ namespace rsgis {namespace radar{
 		gsl_vector* getAPrioriPar(){return this->aPrioriPar;};
 		virtual estOptimizerType getOptimiserType(){return conjugateGradient;};
 		virtual void printOptimiser(){std::cout << "Conjugate gradient (Polynomial) - 3 Var 3 Data" << std::endl;};
+		RSGISEstimationOptimiser* getThreadClone();
 		~RSGISEstimationConjugateGradient3DPoly3Channel();
 	private:
 		gsl_matrix *coeffHH;
@@ -144,6 +146,7 @@ namespace rsgis {namespace radar{
 		gsl_vector* getAPrioriPar(){return this->aPrioriPar;};
 		virtual estOptimizerType getOptimiserType(){return conjugateGradient;};
 		virtual void printOptimiser(){std::cout << "Conjugate gradient (Polynomial) - 3 Var 4 Data" << std::endl;};
+		RSGISEstimationOptimiser* getThreadClone();
 		~RSGISEstimationConjugateGradient3DPoly4Channel();
 	private:
 		gsl_matrix *coeffA;
@@ -184,6 +187,7 @@ namespace rsgis {namespace radar{
 		gsl_vector* getAPrioriPar(){return this->aPrioriPar;};
 		virtual estOptimizerType getOptimiserType(){return conjugateGradient;}; 
 		virtual void printOptimiser(){std::cout << "Conjugate gradient - 2 Var 2 Data" << std::endl;};
+		RSGISEstimationOptimiser* getThreadClone();
 		~RSGISEstimationConjugateGradient2Var2Data();
 	private:
 		rsgis::math::RSGISMathTwoVariableFunction *functionA; 
@@ -217,6 +221,7 @@ namespace rsgis {namespace radar{
 		gsl_vector* getAPrioriPar(){return this->aPrioriPar;};
 		virtual estOptimizerType getOptimiserType(){return conjugateGradient;}; 
 		virtual void printOptimiser(){std::cout << "Conjugate gradient - 2 Var 3 Data" << std::endl;};
+		RSGISEstimationOptimiser* getThreadClone();
 		~RSGISEstimationConjugateGradient2Var3Data();
 	private:
 		rsgis::math::RSGISMathTwoVariableFunction *functionA; 
@@ -248,6 +253,7 @@ namespace rsgis {namespace radar{
 		gsl_vector* getAPrioriPar(){return this->aPrioriPar;};
 		virtual estOptimizerType getOptimiserType(){return conjugateGradient;}; 
 		virtual void printOptimiser(){std::cout << "Conjugate gradient - 2 Var 2 Data, with Restarts" << std::endl;};
+		RSGISEstimationOptimiser* getThreadClone();
 		~RSGISEstimationConjugateGradient2Var2DataWithRestarts();
 	private:
 		rsgis::math::RSGISMathTwoVariableFunction *functionA;
@@ -283,6 +289,7 @@ namespace rsgis {namespace radar{
 		gsl_vector* getAPrioriPar(){return this->aPrioriPar;};
 		virtual estOptimizerType getOptimiserType(){return conjugateGradient;}; 
 		virtual void printOptimiser(){std::cout << "Conjugate gradient - 2 Var 3 Data, with Restarts" << std::endl;};
+		RSGISEstimationOptimiser* getThreadClone();
 		~RSGISEstimationConjugateGradient2Var3DataWithRestarts();
 	private:
 		rsgis::math::RSGISMathTwoVariableFunction *functionA;
@@ -319,8 +326,15 @@ namespace rsgis {namespace radar{
 		gsl_vector* getAPrioriPar(){return this->aPrioriPar;};
 		virtual estOptimizerType getOptimiserType(){return conjugateGradient;}; 
 		virtual void printOptimiser(){std::cout << "Conjugate gradient - 3 Var 3 Data, with Restarts" << std::endl;};
+		RSGISEstimationOptimiser* getThreadClone();
 		~RSGISEstimationConjugateGradient3Var3DataWithRestarts();
 	private:
+		gsl_matrix *coeffHH;
+		gsl_matrix *coeffHV;
+		gsl_matrix *coeffVV;
+		int orderX;
+		int orderY;
+		int orderZ;
 		double *minMaxIntervalA;
 		double *minMaxIntervalB;
 		double *minMaxIntervalC;
@@ -352,8 +366,16 @@ namespace rsgis {namespace radar{
 		gsl_vector* getAPrioriPar(){return this->aPrioriPar;};
 		virtual estOptimizerType getOptimiserType(){return conjugateGradient;}; 
 		virtual void printOptimiser(){std::cout << "Conjugate gradient - 3 Var 4 Data, with Restarts" << std::endl;};
+		RSGISEstimationOptimiser* getThreadClone();
 		~RSGISEstimationConjugateGradient3Var4DataWithRestarts();
 	private:
+		gsl_matrix *coeffA;
+		gsl_matrix *coeffB;
+		gsl_matrix *coeffC;
+		gsl_matrix *coeffD;
+		int orderX;
+		int orderY;
+		int orderZ;
 		double *minMaxIntervalA;
 		double *minMaxIntervalB;
 		double *minMaxIntervalC;
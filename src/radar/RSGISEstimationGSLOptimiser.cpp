@@ -95,20 +95,18 @@ namespace rsgis { namespace radar {
 	{
 		//this->functionHH = functionHH;
 		//this->functionHV = functionHV;
-		
+		this->s = gsl_multimin_fdfminimizer_alloc(gsl_multimin_fdfminimizer_conjugate_pr, 2);
 	}
 	int RSGISEstimationGSLOptimiser::minimise(gsl_vector *inData, gsl_vector *initialPar, gsl_vector *outParError)
 	{
 		unsigned int ittMax = 10;
 		int status = 0;
-		double *inDataDouble = new double[2];
+		double *inDataDouble = this->workspace.getArray(0, 2);
 		inDataDouble[0] = gsl_vector_get(inData, 0);
 		inDataDouble[1] = gsl_vector_get(inData, 1);
 				
 		gsl_vector *predictParams;
-		predictParams = gsl_vector_alloc(2);
-		gsl_vector *df;
-		df = gsl_vector_alloc(2);
+		predictParams = this->workspace.getVector(0, 2);
 		
 		// set inital parameters
 		gsl_vector_set(predictParams, 0, gsl_vector_get(initialPar, 0));
@@ -121,11 +119,7 @@ namespace rsgis { namespace radar {
 		minFunction.fdf = &completeFunction;
 		minFunction.params = (void *) inDataDouble;
 		
-		const gsl_multimin_fdfminimizer_type *T;
-		gsl_multimin_fdfminimizer *s;
-		
-		T = gsl_multimin_fdfminimizer_conjugate_pr;
-		s = gsl_multimin_fdfminimizer_alloc(T, 2);
+		gsl_multimin_fdfminimizer *s = this->s;
 		
 		gsl_multimin_fdfminimizer_set(s, &minFunction, predictParams, 0.01, 0.1);
 		
@@ -139,34 +133,31 @@ namespace rsgis { namespace radar {
 		gsl_vector_set(outParError, 1, gsl_vector_get(s->x, 1));
 		gsl_vector_set(outParError, 2, gsl_multimin_fdfminimizer_minimum(s)); // Error
 		
-		gsl_vector_free(df);
-		gsl_vector_free(predictParams);
-		gsl_multimin_fdfminimizer_free(s);
-		delete[] inDataDouble;
-					   
 		return 0;
 	}
+	RSGISEstimationOptimiser* RSGISEstimationGSLOptimiser::getThreadClone()
+	{
+		return new RSGISEstimationGSLOptimiser();
+	}
 	RSGISEstimationGSLOptimiser::~RSGISEstimationGSLOptimiser()
 	{
-		
+		gsl_multimin_fdfminimizer_free(this->s);
 	}
 	
 	RSGISEstimationGSLOptimiserNoGradient::RSGISEstimationGSLOptimiserNoGradient()
 	{
-		
+		this->s = gsl_multimin_fminimizer_alloc(gsl_multimin_fminimizer_nmsimplex, 2);
 	}
 	int RSGISEstimationGSLOptimiserNoGradient::minimise(gsl_vector *inData, gsl_vector *initialPar, gsl_vector *outParError)
 	{
 		unsigned int ittMax = 1000;
 		int status = 0;
-		double *inDataDouble = new double[2];
+		double *inDataDouble = this->workspace.getArray(0, 2);
 		inDataDouble[0] = gsl_vector_get(inData, 0);
 		inDataDouble[1] = gsl_vector_get(inData, 1);
 		
 		gsl_vector *predictParams;
-		predictParams = gsl_vector_alloc(2);
-		gsl_vector *df;
-		df = gsl_vector_alloc(2);
+		predictParams = this->workspace.getVector(0, 2);
 		
 		// set inital parameters
 		gsl_vector_set(predictParams, 0, gsl_vector_get(initialPar, 0));
@@ -177,15 +168,11 @@ namespace rsgis { namespace radar {
 		minFunction.f = &function;
 		minFunction.params = (void *) inDataDouble;
 		
-		const gsl_multimin_fminimizer_type *T;
-		gsl_multimin_fminimizer *s;
-		
-		T = gsl_multimin_fminimizer_nmsimplex;
-		s = gsl_multimin_fminimizer_alloc(T, 2);
+		gsl_multimin_fminimizer *s = this->s;
 		
 		gsl_vector *stepSize;
 		
-		stepSize = gsl_vector_alloc(2);
+		stepSize = this->workspace.getVector(1, 2);
 		gsl_vector_set(stepSize, 0, 0.1);
 		gsl_vector_set(stepSize, 1, 0.1);
 		
@@ -201,9 +188,13 @@ namespace rsgis { namespace radar {
 		
 		return 0;
 	}
+	RSGISEstimationOptimiser* RSGISEstimationGSLOptimiserNoGradient::getThreadClone()
+	{
+		return new RSGISEstimationGSLOptimiserNoGradient();
+	}
 	RSGISEstimationGSLOptimiserNoGradient::~RSGISEstimationGSLOptimiserNoGradient()
 	{
-		
+		gsl_multimin_fminimizer_free(this->s);
 	}
 
 	
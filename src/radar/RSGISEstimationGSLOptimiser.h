@@ -71,7 +71,10 @@ namespace rsgis {namespace radar{
 		virtual void modifyAPriori(gsl_vector *newAPrioriPar){};
 		virtual estOptimizerType getOptimiserType(){return unknown;}; 
 		virtual void printOptimiser(){std::cout << "GSL Optimiser" << std::endl;};
+		RSGISEstimationOptimiser* getThreadClone();
 		~RSGISEstimationGSLOptimiser();
+	private:
+		gsl_multimin_fdfminimizer *s;
 	};
 	
 	class DllExport RSGISEstimationGSLOptimiserNoGradient : public RSGISEstimationOptimiser
@@ -82,7 +85,10 @@ namespace rsgis {namespace radar{
 		virtual void modifyAPriori(gsl_vector *newAPrioriPar){};
 		virtual estOptimizerType getOptimiserType(){return unknown;}; 
 		virtual void printOptimiser(){std::cout << "GSL Optimiser - no gradients" << std::endl;};
+		RSGISEstimationOptimiser* getThreadClone();
 		~RSGISEstimationGSLOptimiserNoGradient();
+	private:
+		gsl_multimin_fminimizer *s;
 	};
 	
 }}
@@ -24,6 +24,10 @@
 #ifndef RSGISEstimationOptimiser_H
 #define RSGISEstimationOptimiser_H
 
+#include <vector>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_matrix.h>
+
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
 #undef DllExport
@@ -50,6 +54,78 @@ namespace rsgis {namespace radar{
 		unknown
 	};
 	
+	/// Vectors, matrices and arrays kept between calls to an optimiser
+	/**
+	 * Each slot is allocated on first use and reused by later calls which ask
+	 * for the same size, so minimise does not allocate for each pixel. Each
+	 * thread needs its own optimiser (see getThreadClone) and so workspace.
+	 */
+	class DllExport RSGISEstimationWorkspace
+	{
+	public:
+		RSGISEstimationWorkspace(){};
+		gsl_vector* getVector(unsigned int slot, size_t size)
+		{
+			if(slot >= vectors.size())
+			{
+				vectors.resize(slot+1, NULL);
+			}
+			if((vectors[slot] != NULL) && (vectors[slot]->size != size))
+			{
+				gsl_vector_free(vectors[slot]);
+				vectors[slot] = NULL;
+			}
+			if(vectors[slot] == NULL)
+			{
+				vectors[slot] = gsl_vector_alloc(size);
+			}
+			return vectors[slot];
+		};
+		gsl_matrix* getMatrix(unsigned int slot, size_t size1, size_t size2)
+		{
+			if(slot >= matrices.size())
+			{
+				matrices.resize(slot+1, NULL);
+			}
+			if((matrices[slot] != NULL) && ((matrices[slot]->size1 != size1) || (matrices[slot]->size2 != size2)))
+			{
+				gsl_matrix_free(matrices[slot]);
+				matrices[slot] = NULL;
+			}
+			if(matrices[slot] == NULL)
+			{
+				matrices[slot] = gsl_matrix_alloc(size1, size2);
+			}
+			return matrices[slot];
+		};
+		double* getArray(unsigned int slot, size_t size)
+		{
+			if(slot >= arrays.size())
+			{
+				arrays.resize(slot+1);
+			}
+			arrays[slot].resize(size);
+			return arrays[slot].data();
+		};
+		~RSGISEstimationWorkspace()
+		{
+			for(std::vector<gsl_vector*>::iterator iterVec = vectors.begin(); iterVec != vectors.end(); ++iterVec)
+			{
+				if(*iterVec != NULL){gsl_vector_free(*iterVec);}
+			}
+			for(std::vector<gsl_matrix*>::iterator iterMat = matrices.begin(); iterMat != matrices.end(); ++iterMat)
+			{
+				if(*iterMat != NULL){gsl_matrix_free(*iterMat);}
+			}
+		};
+	private:
+		RSGISEstimationWorkspace(const RSGISEstimationWorkspace&);
+		RSGISEstimationWorkspace& operator=(const RSGISEstimationWorkspace&);
+		std::vector<gsl_vector*> vectors;
+		std::vector<gsl_matrix*> matrices;
+		std::vector< std::vector<double> > arrays;
+	};
+	
 	class DllExport RSGISEstimationOptimiser
 	{
 	public:
@@ -59,7 +135,15 @@ namespace rsgis {namespace radar{
 		virtual void modifyAPriori(gsl_vector *newAPrioriPar) = 0;
 		virtual gsl_vector* getAPrioriPar(){throw RSGISException("Not available for this optimiser");};
 		virtual void printOptimiser() = 0;
+		/**
+		 * Return a new optimiser with the same configuration (and its own
+		 * workspace) for use by a separate worker thread, or NULL if the
+		 * optimiser cannot be copied. The caller takes ownership.
+		 */
+		virtual RSGISEstimationOptimiser* getThreadClone(){return NULL;};
 		virtual ~RSGISEstimationOptimiser(){};
+	protected:
+		RSGISEstimationWorkspace workspace;
 	};
 }}
 
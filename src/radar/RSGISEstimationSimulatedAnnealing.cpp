@@ -140,11 +140,14 @@ namespace rsgis {namespace radar{
             dataPow = dataPow + pow(gsl_vector_get(this->inputData, d),2);
         }
 
-        std::vector<double> *currentParError = new std::vector<double>();
-        std::vector<double> *bestParError = new std::vector<double>();
-        std::vector<double> *testPar = new std::vector<double>();
-        double *accepted = new double[this->nPar];
-        double *stepSize = new double[this->nPar];
+        std::vector<double> *currentParError = &this->currentParErrorVals;
+        std::vector<double> *bestParError = &this->bestParErrorVals;
+        std::vector<double> *testPar = &this->testParVals;
+        currentParError->clear();
+        bestParError->clear();
+        testPar->clear();
+        double *accepted = this->workspace.getArray(0, this->nPar);
+        double *stepSize = this->workspace.getArray(1, this->nPar);
 
         // Set current and best parameters to inital values
         for (unsigned int j = 0; j < this->nPar; j++)
@@ -247,13 +250,6 @@ namespace rsgis {namespace radar{
                                         gsl_vector_set(outParError, k, bestParError->at(k));
                                     }
 
-                                    // Tidy
-                                    delete currentParError;
-                                    delete testPar;
-                                    delete bestParError;
-                                    delete[] accepted;
-                                    delete[] stepSize;
-
                                     // Exit
                                     return 1;
                                 }
@@ -317,13 +313,6 @@ namespace rsgis {namespace radar{
 			gsl_vector_set(outParError, j, bestParError->at(j));
         }
 
-        // Tidy
-        delete currentParError;
-        delete testPar;
-        delete bestParError;
-        delete[] accepted;
-        delete[] stepSize;
-
         // Exit
         return 0;
 
@@ -365,6 +354,10 @@ namespace rsgis {namespace radar{
         return (diffD + diffX) / 2;
 
     }
+    RSGISEstimationOptimiser* RSGISEstimationSimulatedAnnealingWithAP::getThreadClone()
+    {
+        return new RSGISEstimationSimulatedAnnealingWithAP(this->allFunctions, this->minMaxIntervalAll, this->minEnergy, this->startTemp, this->runsStep, this->runsTemp, this->cooling, this->maxItt, this->covMatrixP, this->invCovMatrixD, this->aPrioriPar);
+    }
     RSGISEstimationSimulatedAnnealingWithAP::~RSGISEstimationSimulatedAnnealingWithAP()
     {
         delete[] initialStepSize;
@@ -75,6 +75,7 @@ namespace rsgis {namespace radar{
         virtual estOptimizerType getOptimiserType(){return simulatedAnnealing;};
         virtual void printOptimiser(){std::cout << "Simulated Annealing" << std::endl;};
         double calcLeastSquares(std::vector<double> *values);
+        RSGISEstimationOptimiser* getThreadClone();
         ~RSGISEstimationSimulatedAnnealingWithAP();
     private:
         double startTemp;
@@ -98,6 +99,9 @@ namespace rsgis {namespace radar{
         gsl_vector *tempD;
         gsl_vector *tempX;
         gsl_vector *inputData;
+        std::vector<double> currentParErrorVals;
+        std::vector<double> bestParErrorVals;
+        std::vector<double> testParVals;
         bool useAP;
     };
 }}
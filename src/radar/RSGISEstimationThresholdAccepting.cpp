@@ -71,14 +71,14 @@ namespace rsgis {namespace radar{
 		double newEnergy = 0.0;
 
 		
-		double *currentParError = new double[nPar + 1];
-		double *testPar = new double[nPar];
-		double *bestParError = new double[nPar + 1];
-		double *accepted = new double[nPar];
-		double *stepSize = new double[nPar];
-		double *minStepSize = new double[nPar];
-		double *lowerLimit = new double[nPar];
-		double *upperLimit = new double[nPar];
+		double *currentParError = this->workspace.getArray(0, nPar + 1);
+		double *testPar = this->workspace.getArray(1, nPar);
+		double *bestParError = this->workspace.getArray(2, nPar + 1);
+		double *accepted = this->workspace.getArray(3, nPar);
+		double *stepSize = this->workspace.getArray(4, nPar);
+		double *minStepSize = this->workspace.getArray(5, nPar);
+		double *lowerLimit = this->workspace.getArray(6, nPar);
+		double *upperLimit = this->workspace.getArray(7, nPar);
 		
 		// Set upper and lower limits
 		lowerLimit[0] = minMaxIntervalA[0];
@@ -185,14 +185,6 @@ namespace rsgis {namespace radar{
 										}
 										
 										// Tidy
-										delete[] currentParError;
-										delete[] testPar;
-										delete[] bestParError;
-										delete[] accepted;
-										delete[] stepSize;
-										delete[] lowerLimit;
-										delete[] upperLimit;
-										delete[] minStepSize;
 										delete leastSquares;
 										
 										// Exit
@@ -257,14 +249,6 @@ namespace rsgis {namespace radar{
 		}
 		
 		// Tidy
-		delete[] currentParError;
-		delete[] testPar;
-		delete[] bestParError;
-		delete[] accepted;
-		delete[] stepSize;
-		delete[] lowerLimit;
-		delete[] upperLimit;
-		delete[] minStepSize;
 		delete leastSquares;
 		
 		// Exit
@@ -277,6 +261,11 @@ namespace rsgis {namespace radar{
 		gsl_rng_free(randgsl);
 	}
 	
+	RSGISEstimationOptimiser* RSGISEstimationThresholdAccepting2Var2Data::getThreadClone()
+	{
+		return new RSGISEstimationThresholdAccepting2Var2Data(this->functionHH, this->functionHV, this->minMaxIntervalA, this->minMaxIntervalB, this->minEnergy, this->startThreshold, this->runsStep, this->runsThreshold, this->cooling, this->maxItt);
+	}
+	
 	RSGISEstimationThresholdAccepting2Var2DataWithAP::RSGISEstimationThresholdAccepting2Var2DataWithAP(
 																										 rsgis::math::RSGISMathTwoVariableFunction *functionHH, 
 																										 rsgis::math::RSGISMathTwoVariableFunction *functionHV,
@@ -338,14 +327,14 @@ namespace rsgis {namespace radar{
 		double newEnergy = 0.0;
 
 		
-		double *currentParError = new double[nPar + 1];
-		double *testPar = new double[nPar];
-		double *bestParError = new double[nPar + 1];
-		double *accepted = new double[nPar];
-		double *stepSize = new double[nPar];
-		double *minStepSize = new double[nPar];
-		double *lowerLimit = new double[nPar];
-		double *upperLimit = new double[nPar];
+		double *currentParError = this->workspace.getArray(0, nPar + 1);
+		double *testPar = this->workspace.getArray(1, nPar);
+		double *bestParError = this->workspace.getArray(2, nPar + 1);
+		double *accepted = this->workspace.getArray(3, nPar);
+		double *stepSize = this->workspace.getArray(4, nPar);
+		double *minStepSize = this->workspace.getArray(5, nPar);
+		double *lowerLimit = this->workspace.getArray(6, nPar);
+		double *upperLimit = this->workspace.getArray(7, nPar);
 		
 		// Set upper and lower limits
 		lowerLimit[0] = minMaxIntervalA[0];
@@ -452,14 +441,6 @@ namespace rsgis {namespace radar{
 										}
 										
 										// Tidy
-										delete[] currentParError;
-										delete[] testPar;
-										delete[] bestParError;
-										delete[] accepted;
-										delete[] stepSize;
-										delete[] lowerLimit;
-										delete[] upperLimit;
-										delete[] minStepSize;
 										delete leastSquares;
 										
 										// Exit
@@ -530,14 +511,6 @@ namespace rsgis {namespace radar{
 		}
 		
 		// Tidy
-		delete[] currentParError;
-		delete[] testPar;
-		delete[] bestParError;
-		delete[] accepted;
-		delete[] stepSize;
-		delete[] lowerLimit;
-		delete[] upperLimit;
-		delete[] minStepSize;
 		delete leastSquares;
 		
 		// Exit
@@ -551,6 +524,11 @@ namespace rsgis {namespace radar{
 		gsl_matrix_free(invCovMatrixP);
 	}
 	
+	RSGISEstimationOptimiser* RSGISEstimationThresholdAccepting2Var2DataWithAP::getThreadClone()
+	{
+		return new RSGISEstimationThresholdAccepting2Var2DataWithAP(this->functionHH, this->functionHV, this->minMaxIntervalA, this->minMaxIntervalB, this->minEnergy, this->startThreshold, this->runsStep, this->runsThreshold, this->cooling, this->maxItt, this->covMatrixP, this->invCovMatrixD, this->aPrioriPar);
+	}
+	
 	RSGISEstimationThresholdAccepting2Var3Data::RSGISEstimationThresholdAccepting2Var3Data(
 																							 rsgis::math::RSGISMathTwoVariableFunction *functionHH, 
 																							 rsgis::math::RSGISMathTwoVariableFunction *functionHV,
@@ -599,14 +577,14 @@ namespace rsgis {namespace radar{
 		double newEnergy = 0.0;
 
 		
-		double *currentParError = new double[nPar + 1];
-		double *testPar = new double[nPar];
-		double *bestParError = new double[nPar + 1];
-		double *accepted = new double[nPar];
-		double *stepSize = new double[nPar];
-		double *minStepSize = new double[nPar];
-		double *lowerLimit = new double[nPar];
-		double *upperLimit = new double[nPar];
+		double *currentParError = this->workspace.getArray(0, nPar + 1);
+		double *testPar = this->workspace.getArray(1, nPar);
+		double *bestParError = this->workspace.getArray(2, nPar + 1);
+		double *accepted = this->workspace.getArray(3, nPar);
+		double *stepSize = this->workspace.getArray(4, nPar);
+		double *minStepSize = this->workspace.getArray(5, nPar);
+		double *lowerLimit = this->workspace.getArray(6, nPar);
+		double *upperLimit = this->workspace.getArray(7, nPar);
 		
 		// Set upper and lower limits
 		lowerLimit[0] = minMaxIntervalA[0];
@@ -721,14 +699,6 @@ namespace rsgis {namespace radar{
 										}
 										
 										// Tidy
-										delete[] currentParError;
-										delete[] testPar;
-										delete[] bestParError;
-										delete[] accepted;
-										delete[] stepSize;
-										delete[] lowerLimit;
-										delete[] upperLimit;
-										delete[] minStepSize;
 										delete leastSquares;
 										
 										// Exit
@@ -801,14 +771,6 @@ namespace rsgis {namespace radar{
 		}
 		
 		// Tidy
-		delete[] currentParError;
-		delete[] testPar;
-		delete[] bestParError;
-		delete[] accepted;
-		delete[] stepSize;
-		delete[] lowerLimit;
-		delete[] upperLimit;
-		delete[] minStepSize;
 		delete leastSquares;
 		
 		// Exit
@@ -821,6 +783,11 @@ namespace rsgis {namespace radar{
 		gsl_rng_free(randgsl);
 	}
 	
+	RSGISEstimationOptimiser* RSGISEstimationThresholdAccepting2Var3Data::getThreadClone()
+	{
+		return new RSGISEstimationThresholdAccepting2Var3Data(this->functionHH, this->functionHV, this->functionVV, this->minMaxIntervalA, this->minMaxIntervalB, this->minEnergy, this->startThreshold, this->runsStep, this->runsThreshold, this->cooling, this->maxItt);
+	}
+	
 	RSGISEstimationThresholdAccepting2Var3DataWithAP::RSGISEstimationThresholdAccepting2Var3DataWithAP(
 																										 rsgis::math::RSGISMathTwoVariableFunction *functionHH, 
 																										 rsgis::math::RSGISMathTwoVariableFunction *functionHV,
@@ -882,14 +849,14 @@ namespace rsgis {namespace radar{
 		double newEnergy = 0.0;
 
 		
-		double *currentParError = new double[nPar + 1];
-		double *testPar = new double[nPar];
-		double *bestParError = new double[nPar + 1];
-		double *accepted = new double[nPar];
-		double *stepSize = new double[nPar];
-		double *minStepSize = new double[nPar];
-		double *lowerLimit = new double[nPar];
-		double *upperLimit = new double[nPar];
+		double *currentParError = this->workspace.getArray(0, nPar + 1);
+		double *testPar = this->workspace.getArray(1, nPar);
+		double *bestParError = this->workspace.getArray(2, nPar + 1);
+		double *accepted = this->workspace.getArray(3, nPar);
+		double *stepSize = this->workspace.getArray(4, nPar);
+		double *minStepSize = this->workspace.getArray(5, nPar);
+		double *lowerLimit = this->workspace.getArray(6, nPar);
+		double *upperLimit = this->workspace.getArray(7, nPar);
 		
 		// Set upper and lower limits
 		lowerLimit[0] = minMaxIntervalA[0];
@@ -1001,14 +968,6 @@ namespace rsgis {namespace radar{
 										}
 										
 										// Tidy
-										delete[] currentParError;
-										delete[] testPar;
-										delete[] bestParError;
-										delete[] accepted;
-										delete[] stepSize;
-										delete[] lowerLimit;
-										delete[] upperLimit;
-										delete[] minStepSize;
 										delete leastSquares;
 										
 										// Exit
@@ -1081,14 +1040,6 @@ namespace rsgis {namespace radar{
 		}
 		
 		// Tidy
-		delete[] currentParError;
-		delete[] testPar;
-		delete[] bestParError;
-		delete[] accepted;
-		delete[] stepSize;
-		delete[] lowerLimit;
-		delete[] upperLimit;
-		delete[] minStepSize;
 		delete leastSquares;
 		
 		// Exit
@@ -1102,6 +1053,11 @@ namespace rsgis {namespace radar{
 		gsl_matrix_free(invCovMatrixP);
 	}
 	
+	RSGISEstimationOptimiser* RSGISEstimationThresholdAccepting2Var3DataWithAP::getThreadClone()
+	{
+		return new RSGISEstimationThresholdAccepting2Var3DataWithAP(this->functionHH, this->functionHV, this->functionVV, this->minMaxIntervalA, this->minMaxIntervalB, this->minEnergy, this->startThreshold, this->runsStep, this->runsThreshold, this->cooling, this->maxItt, this->covMatrixP, this->invCovMatrixD, this->aPrioriPar);
+	}
+	
 	RSGISEstimationThresholdAccepting3Var3DataWithAP::RSGISEstimationThresholdAccepting3Var3DataWithAP(
 																										 rsgis::math::RSGISMathThreeVariableFunction *functionHH, 
 																										 rsgis::math::RSGISMathThreeVariableFunction *functionHV,
@@ -1167,14 +1123,14 @@ namespace rsgis {namespace radar{
 		double newEnergy = 0.0;
 
 		
-		double *currentParError = new double[nPar + 1];
-		double *testPar = new double[nPar];
-		double *bestParError = new double[nPar + 1];
-		double *accepted = new double[nPar];
-		double *stepSize = new double[nPar];
-		double *minStepSize = new double[nPar];
-		double *lowerLimit = new double[nPar];
-		double *upperLimit = new double[nPar];
+		double *currentParError = this->workspace.getArray(0, nPar + 1);
+		double *testPar = this->workspace.getArray(1, nPar);
+		double *bestParError = this->workspace.getArray(2, nPar + 1);
+		double *accepted = this->workspace.getArray(3, nPar);
+		double *stepSize = this->workspace.getArray(4, nPar);
+		double *minStepSize = this->workspace.getArray(5, nPar);
+		double *lowerLimit = this->workspace.getArray(6, nPar);
+		double *upperLimit = this->workspace.getArray(7, nPar);
 		
 		// Set upper and lower limits
 		lowerLimit[0] = minMaxIntervalA[0];
@@ -1290,14 +1246,6 @@ namespace rsgis {namespace radar{
 										}
 										
 										// Tidy
-										delete[] currentParError;
-										delete[] testPar;
-										delete[] bestParError;
-										delete[] accepted;
-										delete[] stepSize;
-										delete[] lowerLimit;
-										delete[] upperLimit;
-										delete[] minStepSize;
 										delete leastSquares;
 										
 										// Exit
@@ -1371,14 +1319,6 @@ namespace rsgis {namespace radar{
 		}
 		
 		// Tidy
-		delete[] currentParError;
-		delete[] testPar;
-		delete[] bestParError;
-		delete[] accepted;
-		delete[] stepSize;
-		delete[] lowerLimit;
-		delete[] upperLimit;
-		delete[] minStepSize;
 		delete leastSquares;
 		
 		// Exit
@@ -1392,6 +1332,11 @@ namespace rsgis {namespace radar{
 		gsl_matrix_free(invCovMatrixP);
 	}
 	
+	RSGISEstimationOptimiser* RSGISEstimationThresholdAccepting3Var3DataWithAP::getThreadClone()
+	{
+		return new RSGISEstimationThresholdAccepting3Var3DataWithAP(this->functionHH, this->functionHV, this->functionVV, this->minMaxIntervalA, this->minMaxIntervalB, this->minMaxIntervalC, this->minEnergy, this->startThreshold, this->runsStep, this->runsThreshold, this->cooling, this->maxItt, this->covMatrixP, this->invCovMatrixD, this->aPrioriPar);
+	}
+	
 	RSGISEstimationThresholdAccepting3Var4DataWithAP::RSGISEstimationThresholdAccepting3Var4DataWithAP(
 																										 rsgis::math::RSGISMathThreeVariableFunction *function1, 
 																										 rsgis::math::RSGISMathThreeVariableFunction *function2, 
@@ -1459,14 +1404,14 @@ namespace rsgis {namespace radar{
 		double newEnergy = 0.0;
 
 		
-		double *currentParError = new double[nPar + 1];
-		double *testPar = new double[nPar];
-		double *bestParError = new double[nPar + 1];
-		double *accepted = new double[nPar];
-		double *stepSize = new double[nPar];
-		double *minStepSize = new double[nPar];
-		double *lowerLimit = new double[nPar];
-		double *upperLimit = new double[nPar];
+		double *currentParError = this->workspace.getArray(0, nPar + 1);
+		double *testPar = this->workspace.getArray(1, nPar);
+		double *bestParError = this->workspace.getArray(2, nPar + 1);
+		double *accepted = this->workspace.getArray(3, nPar);
+		double *stepSize = this->workspace.getArray(4, nPar);
+		double *minStepSize = this->workspace.getArray(5, nPar);
+		double *lowerLimit = this->workspace.getArray(6, nPar);
+		double *upperLimit = this->workspace.getArray(7, nPar);
 		
 		// Set upper and lower limits
 		lowerLimit[0] = minMaxIntervalA[0];
@@ -1581,14 +1526,6 @@ namespace rsgis {namespace radar{
 										}
 										
 										// Tidy
-										delete[] currentParError;
-										delete[] testPar;
-										delete[] bestParError;
-										delete[] accepted;
-										delete[] stepSize;
-										delete[] lowerLimit;
-										delete[] upperLimit;
-										delete[] minStepSize;
 										delete leastSquares;
 										
 										// Exit
@@ -1665,14 +1602,6 @@ namespace rsgis {namespace radar{
 		}
 		
 		// Tidy
-		delete[] currentParError;
-		delete[] testPar;
-		delete[] bestParError;
-		delete[] accepted;
-		delete[] stepSize;
-		delete[] lowerLimit;
-		delete[] upperLimit;
-		delete[] minStepSize;
 		delete leastSquares;
 				
 		// Exit
@@ -1686,4 +1615,9 @@ namespace rsgis {namespace radar{
 		gsl_matrix_free(invCovMatrixP);
 	}
 	
+	RSGISEstimationOptimiser* RSGISEstimationThresholdAccepting3Var4DataWithAP::getThreadClone()
+	{
+		return new RSGISEstimationThresholdAccepting3Var4DataWithAP(this->function1, this->function2, this->function3, this->function4, this->minMaxIntervalA, this->minMaxIntervalB, this->minMaxIntervalC, this->minEnergy, this->startThreshold, this->runsStep, this->runsThreshold, this->cooling, this->maxItt, this->covMatrixP, this->invCovMatrixD, this->aPrioriPar);
+	}
+	
 }}
@@ -71,6 +71,7 @@ namespace rsgis {namespace radar{
 		virtual void modifyAPriori(gsl_vector *newAPrioriPar){};
 		virtual estOptimizerType getOptimiserType(){return simulatedAnnealing;}; 
 		virtual void printOptimiser(){std::cout << "Simulated Annealing - 2 Var 2 Data" << std::endl;};
+		RSGISEstimationOptimiser* getThreadClone();
 		~RSGISEstimationThresholdAccepting2Var2Data();
 	private:
 		double startThreshold;
@@ -110,6 +111,7 @@ namespace rsgis {namespace radar{
 		gsl_vector* getAPrioriPar(){return this->aPrioriPar;};
 		virtual estOptimizerType getOptimiserType(){return simulatedAnnealing;}; 
 		virtual void printOptimiser(){std::cout << "Simulated Annealing - 2 Var 2 Data (with a Priori)" << std::endl;};
+		RSGISEstimationOptimiser* getThreadClone();
 		~RSGISEstimationThresholdAccepting2Var2DataWithAP();
 	private:
 		double startThreshold;
@@ -151,6 +153,7 @@ namespace rsgis {namespace radar{
 		virtual void modifyAPriori(gsl_vector *newAPrioriPar){};
 		virtual estOptimizerType getOptimiserType(){return simulatedAnnealing;}; 
 		virtual void printOptimiser(){std::cout << "Simulated Annealing - 2 Var 3 Data" << std::endl;};
+		RSGISEstimationOptimiser* getThreadClone();
 		~RSGISEstimationThresholdAccepting2Var3Data();
 	private:
 		double startThreshold;
@@ -192,6 +195,7 @@ namespace rsgis {namespace radar{
 		gsl_vector* getAPrioriPar(){return this->aPrioriPar;};
 		virtual estOptimizerType getOptimiserType(){return simulatedAnnealing;}; 
 		virtual void printOptimiser(){std::cout << "Simulated Annealing - 2 Var 3 Data (with a Priori)" << std::endl;};
+		RSGISEstimationOptimiser* getThreadClone();
 		~RSGISEstimationThresholdAccepting2Var3DataWithAP();
 	private:
 		double startThreshold;
@@ -238,6 +242,7 @@ namespace rsgis {namespace radar{
 		gsl_vector* getAPrioriPar(){return this->aPrioriPar;};
 		virtual estOptimizerType getOptimiserType(){return simulatedAnnealing;}; 
 		virtual void printOptimiser(){std::cout << "Simulated Annealing - 3 Var 3 Data (with a Priori)" << std::endl;};
+		RSGISEstimationOptimiser* getThreadClone();
 		~RSGISEstimationThresholdAccepting3Var3DataWithAP();
 	private:
 		double startThreshold;
@@ -285,6 +290,7 @@ namespace rsgis {namespace radar{
 		virtual void modifyAPriori(gsl_vector *newAPrioriPar){this->aPrioriPar = newAPrioriPar;};
 		virtual estOptimizerType getOptimiserType(){return simulatedAnnealing;}; 
 		virtual void printOptimiser(){std::cout << "Simulated Annealing - 3 Var 4 Data (with a Priori)" << std::endl;};
+		RSGISEstimationOptimiser* getThreadClone();
 		~RSGISEstimationThresholdAccepting3Var4DataWithAP();
 	private:
 		double startThreshold;
@@ -1190,6 +1190,456 @@ namespace rsgis{namespace radar{
 		}
 	}
 
+	RSGISObjectBasedEstimationClumpStats::RSGISObjectBasedEstimationClumpStats(int numSARBands) : rsgis::img::RSGISCalcImageValue(0)
+	{
+		this->numSARBands = numSARBands;
+	}
+
+	void RSGISObjectBasedEstimationClumpStats::calcImageValue(float *bandValues, int numBands)
+	{
+		if(boost::math::isnan(bandValues[0]) || (bandValues[0] < 1))
+		{
+			return;
+		}
+		for(int i = 1; i < numBands; i++)
+		{
+			if(boost::math::isnan(bandValues[i]))
+			{
+				return;
+			}
+		}
+
+		size_t obj = (size_t) bandValues[0];
+		if(obj >= this->counts.size())
+		{
+			this->counts.resize(obj+1, 0);
+			this->sums.resize((obj+1) * this->numSARBands, 0);
+			this->modes.resize((obj+1) * this->numSARBands, 0);
+		}
+
+		size_t idx = obj * this->numSARBands;
+		for(int i = 0; i < this->numSARBands; i++, idx++)
+		{
+			float val = bandValues[i+1];
+			if(this->modes[idx] == 0)
+			{
+				// 1: dB, averaged as power; 2: power < 1, mean converted to dB; 3: power
+				this->modes[idx] = (val <= 0)?1:((val < 1)?2:3);
+			}
+			if(this->modes[idx] == 1)
+			{
+				this->sums[idx] += pow(10, (val / 10));
+			}
+			else
+			{
+				this->sums[idx] += val;
+			}
+		}
+		++this->counts[obj];
+	}
+
+	void RSGISObjectBasedEstimationClumpStats::getObjectMean(size_t obj, float *meanVals)
+	{
+		size_t idx = obj * this->numSARBands;
+		for(int i = 0; i < this->numSARBands; i++, idx++)
+		{
+			double mean = this->sums[idx] / this->counts[obj];
+			if(this->modes[idx] == 3)
+			{
+				meanVals[i] = mean;
+			}
+			else
+			{
+				meanVals[i] = 10*log10(mean);
+			}
+		}
+	}
+
+	RSGISObjectBasedEstimationClumpPxls::RSGISObjectBasedEstimationClumpPxls(int numOutputBands, const std::vector<double> *objPar, const std::vector<char> *objValid, const std::vector<unsigned int> *objClass, std::vector<gsl_vector*> *initialPar, std::vector<RSGISEstimationOptimiser*> optimisers, estParameters parameters, double ***minMaxVals, bool ownOptimisers) : rsgis::img::RSGISCalcImageValue(numOutputBands)
+	{
+		this->numOutputPar = numOutputBands - 2;
+		this->objPar = objPar;
+		this->objValid = objValid;
+		this->objClass = objClass;
+		this->initialPar = initialPar;
+		this->optimisers = optimisers;
+		this->parameters = parameters;
+		this->minMaxVals = minMaxVals;
+		this->ownOptimisers = ownOptimisers;
+		this->currentObj = -1;
+
+		// The estimation of every class starts from startPar, which is set for each object.
+		this->startPar = gsl_vector_alloc(initialPar->at(0)->size);
+		gsl_vector_memcpy(this->startPar, initialPar->at(0));
+		for(unsigned int c = 0; c < this->optimisers.size(); c++)
+		{
+			this->classCalcs.push_back(new RSGISEstimationAlgorithmSingleSpecies(numOutputBands, this->startPar, this->optimisers.at(c), this->parameters, this->minMaxVals[c]));
+		}
+	}
+
+	void RSGISObjectBasedEstimationClumpPxls::calcImageValue(float *bandValues, int numBands, double *output)
+	{
+		if(boost::math::isnan(bandValues[0]) || (bandValues[0] < 1) || (((size_t) bandValues[0]) >= this->objClass->size()))
+		{
+			for(int i = 0; i < this->numOutBands; i++)
+			{
+				output[i] = 0;
+			}
+			return;
+		}
+
+		size_t obj = (size_t) bandValues[0];
+		unsigned int estClass = this->objClass->at(obj);
+		if(((long long) obj) != this->currentObj)
+		{
+			gsl_vector *classPar = this->initialPar->at(estClass);
+			for(size_t i = 0; (i < this->startPar->size) && (i < classPar->size); i++)
+			{
+				gsl_vector_set(this->startPar, i, gsl_vector_get(classPar, i));
+			}
+			if(this->objValid->at(obj))
+			{
+				for(int i = 0; (i < this->numOutputPar) && (i < ((int) this->startPar->size)); i++)
+				{
+					gsl_vector_set(this->startPar, i, this->objPar->at((obj * this->numOutBands) + i));
+				}
+			}
+			this->optimisers.at(estClass)->modifyAPriori(this->startPar);
+			this->currentObj = obj;
+		}
+		this->classCalcs.at(estClass)->calcImageValue(&bandValues[1], numBands-1, output);
+	}
+
+	rsgis::img::RSGISCalcImageValue* RSGISObjectBasedEstimationClumpPxls::getThreadClone()
+	{
+		std::vector<RSGISEstimationOptimiser*> clones;
+		for(std::vector<RSGISEstimationOptimiser*>::iterator iterOpt = this->optimisers.begin(); iterOpt != this->optimisers.end(); ++iterOpt)
+		{
+			RSGISEstimationOptimiser *clone = (*iterOpt)->getThreadClone();
+			if(clone == NULL)
+			{
+				for(std::vector<RSGISEstimationOptimiser*>::iterator iterClone = clones.begin(); iterClone != clones.end(); ++iterClone)
+				{
+					delete *iterClone;
+				}
+				return NULL;
+			}
+			clones.push_back(clone);
+		}
+		return new RSGISObjectBasedEstimationClumpPxls(this->numOutBands, this->objPar, this->objValid, this->objClass, this->initialPar, clones, this->parameters, this->minMaxVals, true);
+	}
+
+	RSGISObjectBasedEstimationClumpPxls::~RSGISObjectBasedEstimationClumpPxls()
+	{
+		for(unsigned int c = 0; c < this->optimisers.size(); c++)
+		{
+			delete this->classCalcs.at(c);
+			if(this->ownOptimisers)
+			{
+				delete this->optimisers.at(c);
+			}
+			else
+			{
+				// The optimiser may keep a pointer to startPar.
+				this->optimisers.at(c)->modifyAPriori(this->initialPar->at(c));
+			}
+		}
+		gsl_vector_free(this->startPar);
+	}
+
+	RSGISObjectBasedEstimationClumps::RSGISObjectBasedEstimationClumps(GDALDataset *clumpsImage, GDALDataset *inputImage, std::vector<gsl_vector*> *initialPar, std::vector<RSGISEstimationOptimiser*> *slowOptimiser, std::vector<RSGISEstimationOptimiser*> *fastOptimiser, estParameters parameters, double ***minMaxVals, std::string classColumn)
+	{
+		this->clumpsImage = clumpsImage;
+		this->inputImage = inputImage;
+		this->initialPar = initialPar;
+		this->slowOptimiser = slowOptimiser;
+		this->fastOptimiser = fastOptimiser;
+		this->parameters = parameters;
+		this->minMaxVals = minMaxVals;
+		this->classColumn = classColumn;
+
+		if ((this->parameters == cDepthDensity) | (this->parameters == heightDensity))
+		{
+			this->numOutputPar = 2;
+		}
+		else if(this->parameters == dielectricDensityHeight)
+		{
+			this->numOutputPar = 3;
+		}
+		else
+		{
+			throw RSGISException("Parameters not recognised");
+		}
+		this->numOutputBands = numOutputPar + 2; // Extra bands for biomass and error
+
+		if((initialPar->size() == 0) || (slowOptimiser->size() != initialPar->size()) || (fastOptimiser->size() != initialPar->size()))
+		{
+			throw RSGISException("The initial parameters and optimisers must be given for each class.");
+		}
+		if(this->minMaxVals == NULL)
+		{
+			throw RSGISException("Must specify min / max values.");
+		}
+
+		this->numThreads = rsgis::utils::getNumThreads();
+	}
+
+	void RSGISObjectBasedEstimationClumps::setNumThreads(unsigned int numThreads)
+	{
+		this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+	}
+
+	void RSGISObjectBasedEstimationClumps::estimate(GDALDataset *outputImage)
+	{
+		GDALRasterAttributeTable *rat = this->clumpsImage->GetRasterBand(1)->GetDefaultRAT();
+		if(rat == NULL)
+		{
+			throw RSGISException("The clumps image does not have an attribute table.");
+		}
+
+		GDALDataset **datasets = new GDALDataset*[2];
+		datasets[0] = this->clumpsImage;
+		datasets[1] = this->inputImage;
+		try
+		{
+			// Collect the backscatter of every object in one pass
+			std::cout << "Calculating the object statistics" << std::endl;
+			RSGISObjectBasedEstimationClumpStats stats(this->inputImage->GetRasterCount());
+			rsgis::img::RSGISCalcImage calcStats(&stats, "", true);
+			calcStats.calcImage(datasets, 2);
+
+			size_t numObjects = std::max<size_t>(stats.getNumObjects(), rat->GetRowCount());
+			this->readObjectClasses(rat, numObjects);
+
+			std::cout << "Estimating the parameters of " << numObjects << " objects" << std::endl;
+			this->estimateObjects(&stats);
+			this->writeObjectColumns(rat);
+
+			if(outputImage != NULL)
+			{
+				std::cout << "Estimating the parameters of the pixels" << std::endl;
+				RSGISObjectBasedEstimationClumpPxls calcPxls(this->numOutputBands, &this->objPar, &this->objValid, &this->objClass, this->initialPar, *this->fastOptimiser, this->parameters, this->minMaxVals);
+				rsgis::img::RSGISCalcImage calcImage(&calcPxls, "", true);
+				calcImage.calcImage(datasets, 2, outputImage);
+			}
+		}
+		catch(...)
+		{
+			delete[] datasets;
+			throw;
+		}
+		delete[] datasets;
+	}
+
+	void RSGISObjectBasedEstimationClumps::readObjectClasses(GDALRasterAttributeTable *rat, size_t numObjects)
+	{
+		unsigned int numClasses = this->initialPar->size();
+		this->objClass.assign(numObjects, 0);
+		if(this->classColumn == "")
+		{
+			return;
+		}
+
+		int colIdx = -1;
+		for(int i = 0; i < rat->GetColumnCount(); i++)
+		{
+			if(std::string(rat->GetNameOfCol(i)) == this->classColumn)
+			{
+				colIdx = i;
+				break;
+			}
+		}
+		if(colIdx < 0)
+		{
+			throw RSGISException("Could not find the class column '" + this->classColumn + "' in the attribute table.");
+		}
+
+		size_t numRows = std::min<size_t>(numObjects, rat->GetRowCount());
+		std::vector<int> classVals(numRows, 0);
+		if((numRows > 0) && (rat->ValuesIO(GF_Read, colIdx, 0, numRows, classVals.data()) != CE_None))
+		{
+			throw RSGISException("Could not read the class column '" + this->classColumn + "'.");
+		}
+		size_t numOutOfRange = 0;
+		for(size_t i = 1; i < numRows; i++)
+		{
+			if((classVals[i] < 1) || (((unsigned int) classVals[i]) > numClasses))
+			{
+				this->objClass[i] = numClasses - 1;
+				++numOutOfRange;
+			}
+			else
+			{
+				this->objClass[i] = classVals[i] - 1;
+			}
+		}
+		if(numOutOfRange > 0)
+		{
+			std::cout << numOutOfRange << " objects have a class number greater than number classes parameterised for. Using last available class.\n";
+		}
+	}
+
+	void RSGISObjectBasedEstimationClumps::estimateObjects(RSGISObjectBasedEstimationClumpStats *stats)
+	{
+		size_t numObjects = this->objClass.size();
+		unsigned int numClasses = this->initialPar->size();
+		int numBands = this->inputImage->GetRasterCount();
+		this->objPar.assign(numObjects * this->numOutputBands, 0);
+		this->objValid.assign(numObjects, 0);
+
+		// Each thread needs its own copy of the slow optimisers, if they cannot
+		// be copied the objects are estimated on a single thread.
+		size_t numThreads = std::max<size_t>(std::min<size_t>(this->numThreads, numObjects), 1);
+		if(rsgis::utils::inWorkerThread())
+		{
+			numThreads = 1;
+		}
+		std::vector<std::vector<RSGISEstimationOptimiser*> > threadOptimisers(1, *this->slowOptimiser);
+		for(size_t t = 1; t < numThreads; t++)
+		{
+			std::vector<RSGISEstimationOptimiser*> clones;
+			for(unsigned int c = 0; c < numClasses; c++)
+			{
+				RSGISEstimationOptimiser *clone = this->slowOptimiser->at(c)->getThreadClone();
+				if(clone == NULL)
+				{
+					break;
+				}
+				clones.push_back(clone);
+			}
+			if(clones.size() != numClasses)
+			{
+				for(std::vector<RSGISEstimationOptimiser*>::iterator iterClone = clones.begin(); iterClone != clones.end(); ++iterClone)
+				{
+					delete *iterClone;
+				}
+				break;
+			}
+			threadOptimisers.push_back(clones);
+		}
+		numThreads = threadOptimisers.size();
+
+		rsgis::utils::RSGISWorkerPool pool(numThreads);
+		std::vector<std::vector<rsgis::img::RSGISCalcImageValue*> > workerCalcs(pool.getNumThreads(), std::vector<rsgis::img::RSGISCalcImageValue*>(numClasses, NULL));
+		std::vector<std::vector<float> > workerInData(pool.getNumThreads(), std::vector<float>(numBands));
+		std::vector<std::vector<double> > workerOutData(pool.getNumThreads(), std::vector<double>(this->numOutputBands));
+		auto deleteWorkerCalcs = [&]()
+		{
+			for(size_t t = 0; t < workerCalcs.size(); t++)
+			{
+				for(unsigned int c = 0; c < numClasses; c++)
+				{
+					if(workerCalcs[t][c] != NULL){delete workerCalcs[t][c];}
+				}
+			}
+			for(size_t t = 1; t < threadOptimisers.size(); t++)
+			{
+				for(std::vector<RSGISEstimationOptimiser*>::iterator iterOpt = threadOptimisers[t].begin(); iterOpt != threadOptimisers[t].end(); ++iterOpt)
+				{
+					delete *iterOpt;
+				}
+			}
+		};
+		try
+		{
+			for(size_t t = 0; t < workerCalcs.size(); t++)
+			{
+				for(unsigned int c = 0; c < numClasses; c++)
+				{
+					RSGISEstimationOptimiser *opt = threadOptimisers[t][c];
+					if(opt->getOptimiserType() != rsgis::radar::noOptimiser)
+					{
+						workerCalcs[t][c] = new RSGISEstimationAlgorithmSingleSpecies(this->numOutputBands, this->initialPar->at(c), opt, this->parameters, this->minMaxVals[c]);
+					}
+				}
+			}
+			
+			// The objects are numbered from 1.
+			pool.parallelFor((numObjects > 0)?(numObjects - 1):0, [&](size_t item, unsigned int t)
+			{
+				size_t obj = item + 1;
+				std::vector<rsgis::img::RSGISCalcImageValue*> &classCalcs = workerCalcs[t];
+				std::vector<float> &inData = workerInData[t];
+				std::vector<double> &outData = workerOutData[t];
+				rsgis::img::RSGISCalcImageValue *calc = classCalcs[this->objClass[obj]];
+				if((calc == NULL) || (obj >= stats->getNumObjects()) || (stats->getObjectCount(obj) == 0))
+				{
+					return;
+				}
+				stats->getObjectMean(obj, inData.data());
+				calc->calcImageValue(inData.data(), numBands, outData.data());
+
+				double error = outData[this->numOutputBands - 1];
+				for(unsigned int i = 0; i < this->numOutputBands; i++)
+				{
+					this->objPar[(obj * this->numOutputBands) + i] = outData[i];
+				}
+				// Only start the pixels from the object if the fit converged
+				this->objValid[obj] = ((error < 1e-8) && (error > 0))?1:0;
+			});
+		}
+		catch(...)
+		{
+			deleteWorkerCalcs();
+			throw;
+		}
+		deleteWorkerCalcs();
+	}
+
+	void RSGISObjectBasedEstimationClumps::writeObjectColumns(GDALRasterAttributeTable *rat)
+	{
+		size_t numObjects = this->objClass.size();
+		if(((size_t) rat->GetRowCount()) < numObjects)
+		{
+			rat->SetRowCount(numObjects);
+		}
+
+		std::vector<std::string> colNames;
+		std::vector<unsigned int> colBands;
+		if(this->parameters == heightDensity)
+		{
+			colNames = {"objHeight", "objDens", "objBiomass", "objError"};
+			colBands = {0, 1, 2, 3};
+		}
+		else if(this->parameters == cDepthDensity)
+		{
+			colNames = {"objCDepth", "objDens", "objBiomass", "objError"};
+			colBands = {0, 1, 2, 3};
+		}
+		else
+		{
+			colNames = {"objHeight", "objDens", "objEps", "objError"};
+			colBands = {0, 1, 2, 4};
+		}
+
+		std::vector<double> colVals(numObjects, 0);
+		for(size_t n = 0; n < colNames.size(); n++)
+		{
+			int colIdx = -1;
+			for(int i = 0; i < rat->GetColumnCount(); i++)
+			{
+				if(std::string(rat->GetNameOfCol(i)) == colNames[n])
+				{
+					colIdx = i;
+					break;
+				}
+			}
+			if(colIdx < 0)
+			{
+				rat->CreateColumn(colNames[n].c_str(), GFT_Real, GFU_Generic);
+				colIdx = rat->GetColumnCount() - 1;
+			}
+			for(size_t obj = 0; obj < numObjects; obj++)
+			{
+				colVals[obj] = this->objPar[(obj * this->numOutputBands) + colBands[n]];
+			}
+			if(rat->ValuesIO(GF_Write, colIdx, 0, numObjects, colVals.data()) != CE_None)
+			{
+				throw RSGISException("Could not write the column '" + colNames[n] + "' to the attribute table.");
+			}
+		}
+	}
+
 	int RSGISEstimationAssignAP::minimise(gsl_vector *inData, gsl_vector *initialPar, gsl_vector *outParError)
 	{
 		for (unsigned int i = 0; i < initialPar->size; ++i)
@@ -26,11 +26,18 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+#include <cstdlib>
 
 #include "gdal_priv.h"
 #include "ogrsf_frmts.h"
 
 #include "common/RSGISVectorException.h"
+#include "common/RSGISParallel.h"
 
 #include "vec/RSGISVectorOutputException.h"
 #include "vec/RSGISVectorIO.h"
@@ -43,6 +50,8 @@
 #include "img/RSGISCalcImageSingle.h"
 #include "img/RSGISImageCalcException.h"
 #include "img/RSGISPixelInPoly.h"
+#include "img/RSGISCalcImageValue.h"
+#include "img/RSGISCalcImage.h"
 
 #include "geos/geom/Envelope.h"
 #include "geos/geom/Polygon.h"
@@ -161,6 +170,92 @@ namespace rsgis{namespace radar{
 		int numInBands;
 	};
 
+	/// Accumulates the backscatter of the pixels within each clump in one pass
+	/** - The first band is the clump ID (0 is ignored) and the rest the SAR bands.
+	    - Values <= 0 are taken as dB and averaged as power, as for the polygon based
+	      estimation, and the mean is returned in dB unless the object is in power >= 1. */
+	class DllExport RSGISObjectBasedEstimationClumpStats : public rsgis::img::RSGISCalcImageValue
+	{
+	public:
+		RSGISObjectBasedEstimationClumpStats(int numSARBands);
+		void calcImageValue(float *bandValues, int numBands);
+		size_t getNumObjects(){return this->counts.size();};
+		unsigned long long getObjectCount(size_t obj){return this->counts[obj];};
+		void getObjectMean(size_t obj, float *meanVals);
+		~RSGISObjectBasedEstimationClumpStats(){};
+	protected:
+		int numSARBands;
+		std::vector<unsigned long long> counts;
+		std::vector<double> sums;
+		// For each object and band, how the values are averaged (set by the first pixel)
+		std::vector<unsigned char> modes;
+	};
+
+	/// Runs the pixel inversion within each clump starting from the parameters of the clump
+	/** - The first band is the clump ID and the rest the SAR bands.
+	    - objPar holds the output of the object inversion (numOutputBands values per
+	      clump) and objValid whether it converged, otherwise the initial parameters of
+	      the class are used.
+	    - optimisers are the fast optimisers of each class, deleted with the calculator
+	      if ownOptimisers. */
+	class DllExport RSGISObjectBasedEstimationClumpPxls : public rsgis::img::RSGISCalcImageValue
+	{
+	public:
+		RSGISObjectBasedEstimationClumpPxls(int numOutputBands, const std::vector<double> *objPar, const std::vector<char> *objValid, const std::vector<unsigned int> *objClass, std::vector<gsl_vector*> *initialPar, std::vector<RSGISEstimationOptimiser*> optimisers, estParameters parameters, double ***minMaxVals, bool ownOptimisers=false);
+		void calcImageValue(float *bandValues, int numBands, double *output);
+		rsgis::img::RSGISCalcImageValue* getThreadClone();
+		~RSGISObjectBasedEstimationClumpPxls();
+	protected:
+		int numOutputPar;
+		const std::vector<double> *objPar;
+		const std::vector<char> *objValid;
+		const std::vector<unsigned int> *objClass;
+		std::vector<gsl_vector*> *initialPar;
+		estParameters parameters;
+		double ***minMaxVals;
+		bool ownOptimisers;
+		std::vector<RSGISEstimationOptimiser*> optimisers;
+		std::vector<rsgis::img::RSGISCalcImageValue*> classCalcs;
+		gsl_vector *startPar;
+		long long currentObj;
+	};
+
+	/// Object based estimation over a clumps image and its attribute table
+	/** Rather than reading the pixels of each polygon separately (RSGISObjectBasedEstimation)
+	    the mean backscatter of every clump is collected in one pass over the image, the
+	    object inversions are then run in parallel (each thread with its own clones of the
+	    slow optimisers, so their workspaces are not shared) and the results written to the
+	    attribute table (objHeight / objCDepth, objDens, objEps, objBiomass and objError).
+	    If an output image is given the pixel inversion, started from the parameters of the
+	    object, is then run with RSGISCalcImage (which uses clones of the fast optimisers).
+	    The class of each object (1 to the number of classes) is read from classColumn if
+	    given. The number of threads is read from RSGISLIB_NUM_THREADS (default 1). */
+	class DllExport RSGISObjectBasedEstimationClumps
+	{
+	public:
+		RSGISObjectBasedEstimationClumps(GDALDataset *clumpsImage, GDALDataset *inputImage, std::vector<gsl_vector*> *initialPar, std::vector<RSGISEstimationOptimiser*> *slowOptimiser, std::vector<RSGISEstimationOptimiser*> *fastOptimiser, estParameters parameters, double ***minMaxVals, std::string classColumn = "");
+		void setNumThreads(unsigned int numThreads);
+		void estimate(GDALDataset *outputImage = NULL);
+		~RSGISObjectBasedEstimationClumps(){};
+	protected:
+		void readObjectClasses(GDALRasterAttributeTable *rat, size_t numObjects);
+		void estimateObjects(RSGISObjectBasedEstimationClumpStats *stats);
+		void writeObjectColumns(GDALRasterAttributeTable *rat);
+		GDALDataset *clumpsImage;
+		GDALDataset *inputImage;
+		std::vector<gsl_vector*> *initialPar;
+		std::vector<RSGISEstimationOptimiser*> *slowOptimiser;
+		std::vector<RSGISEstimationOptimiser*> *fastOptimiser;
+		estParameters parameters;
+		double ***minMaxVals;
+		std::string classColumn;
+		unsigned int numOutputPar;
+		unsigned int numOutputBands;
+		unsigned int numThreads;
+		std::vector<unsigned int> objClass;
+		std::vector<double> objPar;
+		std::vector<char> objValid;
+	};
 
 	class DllExport RSGISEstimationAssignAP : public RSGISEstimationOptimiser
 	{
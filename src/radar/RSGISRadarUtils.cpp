@@ -50,6 +50,20 @@ namespace rsgis { namespace radar{
 		}
 	}
 	
+	void RSGISConvert2dB::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+	{
+		const float calFactor = this->calFactor;
+		for(int i = 0; i < numBands; ++i)
+		{
+			const float *inPlane = bandPlanes[i];
+			double *outPlane = outPlanes[i];
+			for(size_t j = 0; j < nPxls; ++j)
+			{
+				outPlane[j] = rsgisFastDB(inPlane[j], calFactor);
+			}
+		}
+	}
+	
 	RSGISConvert2dB::~RSGISConvert2dB()
 	{
 		
@@ -575,41 +575,38 @@ namespace rsgis{namespace rastergis{
             std::vector<rsgis::rastergis::RSGISColumnLogicIdxs*> *colIdxes = new std::vector<rsgis::rastergis::RSGISColumnLogicIdxs*>();
             rsgis::math::RSGISLogicExpression* exp = parseLogicXMLObj.parseLogicXML(xmlBlock, colIdxes);
             
-            unsigned outColIdx = attUtils.findColumnIndexOrCreate(rat, outColumn, GFT_Integer);
-            
-            std::vector<unsigned int> inRealColIdx;
-            std::vector<unsigned int> inIntColIdx;
-            std::vector<unsigned int> inStrColIdx;
-            std::vector<unsigned int> outRealColIdx;
-            std::vector<unsigned int> outIntColIdx;
-            outIntColIdx.push_back(outColIdx);
-            std::vector<unsigned int> outStrColIdx;
-            
+            // The expression is compiled and evaluated over chunks of rows with the
+            // columns held in memory rather than walking the tree for each row.
+            rsgis::math::RSGISLogicProgram logicProg(exp);
+            RSGISRATColumnCache ratColCache(rat);
             for(std::vector<rsgis::rastergis::RSGISColumnLogicIdxs*>::iterator iterColIdx = colIdxes->begin(); iterColIdx != colIdxes->end(); ++iterColIdx)
             {
                 if((*iterColIdx)->useThreshold)
                 {
                     (*iterColIdx)->col1Idx = attUtils.findColumnIndex(rat, (*iterColIdx)->column1Name);
                     std::cout << (*iterColIdx)->column1Name << " = " << (*iterColIdx)->col1Idx << std::endl;
-                    inRealColIdx.push_back((*iterColIdx)->col1Idx);
-                    (*iterColIdx)->col1Idx = inRealColIdx.size()-1;
+                    logicProg.bindValues(&(*iterColIdx)->col1Val, ratColCache.getRealColumn((*iterColIdx)->column1Name));
                 }
                 else
                 {
                     (*iterColIdx)->col1Idx = attUtils.findColumnIndex(rat, (*iterColIdx)->column1Name);
                     std::cout << (*iterColIdx)->column1Name << " = " << (*iterColIdx)->col1Idx << std::endl;
-                    inRealColIdx.push_back((*iterColIdx)->col1Idx);
-                    (*iterColIdx)->col1Idx = inRealColIdx.size()-1;
+                    logicProg.bindValues(&(*iterColIdx)->col1Val, ratColCache.getRealColumn((*iterColIdx)->column1Name));
                     (*iterColIdx)->col2Idx = attUtils.findColumnIndex(rat, (*iterColIdx)->column2Name);
                     std::cout << (*iterColIdx)->column2Name << " = " << (*iterColIdx)->col2Idx << std::endl;
-                    inRealColIdx.push_back((*iterColIdx)->col2Idx);
-                    (*iterColIdx)->col2Idx = inRealColIdx.size()-1;
+                    logicProg.bindValues(&(*iterColIdx)->col2Val, ratColCache.getRealColumn((*iterColIdx)->column2Name));
                 }
             }
             
-            RSGISBinaryClumpClassifier binClumpClassifier(colIdxes, exp);
-            RSGISRATCalc ratCalc(&binClumpClassifier);
-            ratCalc.calcRATValues(rat, inRealColIdx, inIntColIdx, inStrColIdx, outRealColIdx, outIntColIdx, outStrColIdx);
+            int *outColVals = ratColCache.getIntColumn(outColumn, true);
+            std::vector<unsigned char> outMask(numRows, 0);
+            logicProg.evaluate(0, numRows, outMask.data());
+            for(size_t i = 0; i < numRows; ++i)
+            {
+                outColVals[i] = outMask[i];
+            }
+            ratColCache.setColumnChanged(outColumn);
+            ratColCache.flush();
             
             for(std::vector<rsgis::rastergis::RSGISColumnLogicIdxs*>::iterator iterColIdx = colIdxes->begin(); iterColIdx != colIdxes->end(); ++iterColIdx)
             {
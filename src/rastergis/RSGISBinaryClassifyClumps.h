@@ -38,6 +38,7 @@
 #include "rastergis/RSGISRasterAttUtils.h"
 #include "rastergis/RSGISRATCalcValue.h"
 #include "rastergis/RSGISRATCalc.h"
+#include "rastergis/RSGISRATColumnCache.h"
 
 #include <xercesc/dom/DOM.hpp>
 #include <xercesc/parsers/XercesDOMParser.hpp>
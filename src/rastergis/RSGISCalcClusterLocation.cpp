@@ -41,104 +41,15 @@ namespace rsgis{namespace rastergis{
             {
                 throw rsgis::RSGISAttributeTableException("RAT Band is larger than the number of bands within the image.");
             }
-            RSGISRasterAttUtils attUtils;
             
-            GDALRasterAttributeTable *attTable = dataset->GetRasterBand(ratBand)->GetDefaultRAT();
+            RSGISClumpGeometryCols cols;
+            cols.borderIncludeZeroEdges = false;
+            cols.eastCol = eastColumn;
+            cols.northCol = northColumn;
             
-            size_t numRows = attTable->GetRowCount();
-            
-            long minVal = 0;
-            long maxVal = 0;
-            attUtils.getImageBandMinMax(dataset, 1, &minVal, &maxVal);
-            
-            if(maxVal > numRows)
-            {                
-                attTable->SetRowCount(maxVal+1);
-                numRows = maxVal+1;
-            }
-            
-            int histColIdx = attUtils.findColumnIndex(attTable, "Histogram");
-            int eastColIdx = attUtils.findColumnIndexOrCreate(attTable, eastColumn, GFT_Real);
-            int northColIdx = attUtils.findColumnIndexOrCreate(attTable, northColumn, GFT_Real);
-            
-            double **spatialLoc = new double*[numRows];
-            for(size_t i = 0; i < numRows; ++i)
-            {
-                spatialLoc[i] = new double[2];
-                spatialLoc[i][0] = 0.0;
-                spatialLoc[i][1] = 0.0;
-            }
-            
-            RSGISCalcClusterLocationCalcValue *calcLoc = new RSGISCalcClusterLocationCalcValue(spatialLoc, ratBand);
-            rsgis::img::RSGISCalcImage calcImage(calcLoc);
-            calcImage.calcImageExtent(&dataset, 1, 0);
-            delete calcLoc;
-            
-            std::cout << "Writing data to output RAT\n";
-            size_t numBlocks = floor((double)numRows/(double)RAT_BLOCK_LENGTH);
-            size_t rowsRemain = numRows - (numBlocks * RAT_BLOCK_LENGTH);
-            
-            rsgis::math::RSGISMathsUtils mathUtils;
-            double *dataEastBlock = new double[RAT_BLOCK_LENGTH];
-            double *dataNorthBlock = new double[RAT_BLOCK_LENGTH];
-            double *histDataBlock = new double[RAT_BLOCK_LENGTH];
-            size_t startRow = 0;
-            size_t rowID = 0;
-            for(size_t i = 0; i < numBlocks; ++i)
-            {
-                attTable->ValuesIO(GF_Read, histColIdx, startRow, RAT_BLOCK_LENGTH, histDataBlock);
-                rowID = startRow;
-                for(size_t j = 0; j < RAT_BLOCK_LENGTH; ++j)
-                {
-                    if(histDataBlock[j] > 0)
-                    {
-                        dataEastBlock[j] = spatialLoc[rowID][0] / histDataBlock[j];
-                        dataNorthBlock[j] = spatialLoc[rowID][1] / histDataBlock[j];
-                    }
-                    else
-                    {
-                        dataEastBlock[j] = 0.0;
-                        dataNorthBlock[j] = 0.0;
-                    }
-                    ++rowID;
-                }
-                attTable->ValuesIO(GF_Write, eastColIdx, startRow, RAT_BLOCK_LENGTH, dataEastBlock);
-                attTable->ValuesIO(GF_Write, northColIdx, startRow, RAT_BLOCK_LENGTH, dataNorthBlock);
-                
-                
-                startRow += RAT_BLOCK_LENGTH;
-            }
-            if(rowsRemain > 0)
-            {
-                attTable->ValuesIO(GF_Read, histColIdx, startRow, rowsRemain, histDataBlock);
-                rowID = startRow;
-                for(size_t j = 0; j < rowsRemain; ++j)
-                {
-                    if(histDataBlock[j] > 0)
-                    {
-                        dataEastBlock[j] = spatialLoc[rowID][0] / histDataBlock[j];
-                        dataNorthBlock[j] = spatialLoc[rowID][1] / histDataBlock[j];
-                    }
-                    else
-                    {
-                        dataEastBlock[j] = 0.0;
-                        dataNorthBlock[j] = 0.0;
-                    }
-                    ++rowID;
-                }
-                attTable->ValuesIO(GF_Write, eastColIdx, startRow, rowsRemain, dataEastBlock);
-                attTable->ValuesIO(GF_Write, northColIdx, startRow, rowsRemain, dataNorthBlock);
-            }
-            
-            delete[] histDataBlock;
-            delete[] dataEastBlock;
-            delete[] dataNorthBlock;
-            
-            for(size_t i = 0; i < numRows; ++i)
-            {
-                delete[] spatialLoc[i];
-            }
-            delete[] spatialLoc;
+            RSGISClumpGeometry clumpGeom;
+            clumpGeom.calcGeometry(dataset, ratBand);
+            clumpGeom.writeToRAT(dataset, ratBand, &cols);
             
             dataset->GetRasterBand(ratBand)->SetMetadataItem("LAYER_TYPE", "thematic");
         }
@@ -168,132 +79,21 @@ namespace rsgis{namespace rastergis{
             {
                 throw rsgis::RSGISAttributeTableException("RAT Band is larger than the number of bands within the image.");
             }
-            RSGISRasterAttUtils attUtils;
-            
-            GDALRasterAttributeTable *attTable = dataset->GetRasterBand(ratBand)->GetDefaultRAT();
-            
-            size_t numRows = attTable->GetRowCount();
-            
-            long minVal = 0;
-            long maxVal = 0;
-            attUtils.getImageBandMinMax(dataset, 1, &minVal, &maxVal);
-            
-            if(maxVal > numRows)
-            {
-                attTable->SetRowCount(maxVal+1);
-                numRows = maxVal+1;
-            }
-            
-            int minXColXIdx = attUtils.findColumnIndexOrCreate(attTable, minXColX, GFT_Real);
-            int minXColYIdx = attUtils.findColumnIndexOrCreate(attTable, minXColY, GFT_Real);
-            int maxXColXIdx = attUtils.findColumnIndexOrCreate(attTable, maxXColX, GFT_Real);
-            int maxXColYIdx = attUtils.findColumnIndexOrCreate(attTable, maxXColY, GFT_Real);
-            int minYColXIdx = attUtils.findColumnIndexOrCreate(attTable, minYColX, GFT_Real);
-            int minYColYIdx = attUtils.findColumnIndexOrCreate(attTable, minYColY, GFT_Real);
-            int maxYColXIdx = attUtils.findColumnIndexOrCreate(attTable, maxYColX, GFT_Real);
-            int maxYColYIdx = attUtils.findColumnIndexOrCreate(attTable, maxYColY, GFT_Real);
             
-            double **spatialLoc = new double*[numRows];
-            bool *first = new bool[numRows];
-            for(size_t i = 0; i < numRows; ++i)
-            {
-                first[i] = true;
-                spatialLoc[i] = new double[8];
-                spatialLoc[i][0] = 0.0;
-                spatialLoc[i][1] = 0.0;
-                spatialLoc[i][2] = 0.0;
-                spatialLoc[i][3] = 0.0;
-                spatialLoc[i][4] = 0.0;
-                spatialLoc[i][5] = 0.0;
-                spatialLoc[i][6] = 0.0;
-                spatialLoc[i][7] = 0.0;
-            }
-            
-            RSGISCalcClusterExtentCalcValue *calcLoc = new RSGISCalcClusterExtentCalcValue(spatialLoc, first, ratBand);
-            rsgis::img::RSGISCalcImage calcImage(calcLoc);
-            calcImage.calcImageExtent(&dataset, 1, 0);
-            delete calcLoc;
-            
-            std::cout << "Writing data to output RAT\n";
-            size_t numBlocks = floor((double)numRows/(double)RAT_BLOCK_LENGTH);
-            size_t rowsRemain = numRows - (numBlocks * RAT_BLOCK_LENGTH);
-            
-            rsgis::math::RSGISMathsUtils mathUtils;
-            double *dataMinXXBlock = new double[RAT_BLOCK_LENGTH];
-            double *dataMinXYBlock = new double[RAT_BLOCK_LENGTH];
-            double *dataMaxXXBlock = new double[RAT_BLOCK_LENGTH];
-            double *dataMaxXYBlock = new double[RAT_BLOCK_LENGTH];
-            double *dataMinYXBlock = new double[RAT_BLOCK_LENGTH];
-            double *dataMinYYBlock = new double[RAT_BLOCK_LENGTH];
-            double *dataMaxYXBlock = new double[RAT_BLOCK_LENGTH];
-            double *dataMaxYYBlock = new double[RAT_BLOCK_LENGTH];
-            size_t startRow = 0;
-            size_t rowID = 0;
-            for(size_t i = 0; i < numBlocks; ++i)
-            {
-                rowID = startRow;
-                for(size_t j = 0; j < RAT_BLOCK_LENGTH; ++j)
-                {
-                    dataMinXXBlock[j] = spatialLoc[rowID][0];
-                    dataMinXYBlock[j] = spatialLoc[rowID][1];
-                    dataMaxXXBlock[j] = spatialLoc[rowID][2];
-                    dataMaxXYBlock[j] = spatialLoc[rowID][3];
-                    dataMinYXBlock[j] = spatialLoc[rowID][4];
-                    dataMinYYBlock[j] = spatialLoc[rowID][5];
-                    dataMaxYXBlock[j] = spatialLoc[rowID][6];
-                    dataMaxYYBlock[j] = spatialLoc[rowID][7];
-                    ++rowID;
-                }
-                attTable->ValuesIO(GF_Write, minXColXIdx, startRow, RAT_BLOCK_LENGTH, dataMinXXBlock);
-                attTable->ValuesIO(GF_Write, minXColYIdx, startRow, RAT_BLOCK_LENGTH, dataMinXYBlock);
-                attTable->ValuesIO(GF_Write, maxXColXIdx, startRow, RAT_BLOCK_LENGTH, dataMaxXXBlock);
-                attTable->ValuesIO(GF_Write, maxXColYIdx, startRow, RAT_BLOCK_LENGTH, dataMaxXYBlock);
-                attTable->ValuesIO(GF_Write, minYColXIdx, startRow, RAT_BLOCK_LENGTH, dataMinYXBlock);
-                attTable->ValuesIO(GF_Write, minYColYIdx, startRow, RAT_BLOCK_LENGTH, dataMinYYBlock);
-                attTable->ValuesIO(GF_Write, maxYColXIdx, startRow, RAT_BLOCK_LENGTH, dataMaxYXBlock);
-                attTable->ValuesIO(GF_Write, maxYColYIdx, startRow, RAT_BLOCK_LENGTH, dataMaxYYBlock);
-                
-                startRow += RAT_BLOCK_LENGTH;
-            }
-            if(rowsRemain > 0)
-            {
-                rowID = startRow;
-                for(size_t j = 0; j < rowsRemain; ++j)
-                {
-                    dataMinXXBlock[j] = spatialLoc[rowID][0];
-                    dataMinXYBlock[j] = spatialLoc[rowID][1];
-                    dataMaxXXBlock[j] = spatialLoc[rowID][2];
-                    dataMaxXYBlock[j] = spatialLoc[rowID][3];
-                    dataMinYXBlock[j] = spatialLoc[rowID][4];
-                    dataMinYYBlock[j] = spatialLoc[rowID][5];
-                    dataMaxYXBlock[j] = spatialLoc[rowID][6];
-                    dataMaxYYBlock[j] = spatialLoc[rowID][7];
-                    ++rowID;
-                }
-                attTable->ValuesIO(GF_Write, minXColXIdx, startRow, rowsRemain, dataMinXXBlock);
-                attTable->ValuesIO(GF_Write, minXColYIdx, startRow, rowsRemain, dataMinXYBlock);
-                attTable->ValuesIO(GF_Write, maxXColXIdx, startRow, rowsRemain, dataMaxXXBlock);
-                attTable->ValuesIO(GF_Write, maxXColYIdx, startRow, rowsRemain, dataMaxXYBlock);
-                attTable->ValuesIO(GF_Write, minYColXIdx, startRow, rowsRemain, dataMinYXBlock);
-                attTable->ValuesIO(GF_Write, minYColYIdx, startRow, rowsRemain, dataMinYYBlock);
-                attTable->ValuesIO(GF_Write, maxYColXIdx, startRow, rowsRemain, dataMaxYXBlock);
-                attTable->ValuesIO(GF_Write, maxYColYIdx, startRow, rowsRemain, dataMaxYYBlock);
-            }
-            
-            delete[] dataMinXXBlock;
-            delete[] dataMinXYBlock;
-            delete[] dataMaxXXBlock;
-            delete[] dataMaxXYBlock;
-            delete[] dataMinYXBlock;
-            delete[] dataMinYYBlock;
-            delete[] dataMaxYXBlock;
-            delete[] dataMaxYYBlock;
-            
-            for(size_t i = 0; i < numRows; ++i)
-            {
-                delete[] spatialLoc[i];
-            }
-            delete[] spatialLoc;
+            RSGISClumpGeometryCols cols;
+            cols.borderIncludeZeroEdges = false;
+            cols.minXColX = minXColX;
+            cols.minXColY = minXColY;
+            cols.maxXColX = maxXColX;
+            cols.maxXColY = maxXColY;
+            cols.minYColX = minYColX;
+            cols.minYColY = minYColY;
+            cols.maxYColX = maxYColX;
+            cols.maxYColY = maxYColY;
+            
+            RSGISClumpGeometry clumpGeom;
+            clumpGeom.calcGeometry(dataset, ratBand);
+            clumpGeom.writeToRAT(dataset, ratBand, &cols);
             
             dataset->GetRasterBand(ratBand)->SetMetadataItem("LAYER_TYPE", "thematic");
         }
@@ -323,100 +123,17 @@ namespace rsgis{namespace rastergis{
             {
                 throw rsgis::RSGISAttributeTableException("RAT Band is larger than the number of bands within the image.");
             }
-            RSGISRasterAttUtils attUtils;
-            
-            GDALRasterAttributeTable *attTable = dataset->GetRasterBand(ratBand)->GetDefaultRAT();
-            
-            size_t numRows = attTable->GetRowCount();
-            
-            long minVal = 0;
-            long maxVal = 0;
-            attUtils.getImageBandMinMax(dataset, 1, &minVal, &maxVal);
-            
-            if(maxVal > numRows)
-            {
-                attTable->SetRowCount(maxVal+1);
-                numRows = maxVal+1;
-            }
             
-            int minXIdx = attUtils.findColumnIndexOrCreate(attTable, minXCol, GFT_Real);
-            int maxXIdx = attUtils.findColumnIndexOrCreate(attTable, maxXCol, GFT_Real);
-            int minYIdx = attUtils.findColumnIndexOrCreate(attTable, minYCol, GFT_Real);
-            int maxYIdx = attUtils.findColumnIndexOrCreate(attTable, maxYCol, GFT_Real);
+            RSGISClumpGeometryCols cols;
+            cols.borderIncludeZeroEdges = false;
+            cols.minXPxlCol = minXCol;
+            cols.maxXPxlCol = maxXCol;
+            cols.minYPxlCol = minYCol;
+            cols.maxYPxlCol = maxYCol;
             
-            unsigned long **pxlLoc = new unsigned long*[numRows];
-            bool *first = new bool[numRows];
-            for(size_t i = 0; i < numRows; ++i)
-            {
-                first[i] = true;
-                pxlLoc[i] = new unsigned long[4];
-                pxlLoc[i][0] = 0;
-                pxlLoc[i][1] = 0;
-                pxlLoc[i][2] = 0;
-                pxlLoc[i][3] = 0;
-            }
-            
-            RSGISCalcClusterPxlExtentCalcValue *calcLoc = new RSGISCalcClusterPxlExtentCalcValue(pxlLoc, first, ratBand);
-            rsgis::img::RSGISCalcImage calcImage(calcLoc);
-            calcImage.calcImagePosPxl(&dataset, 1, 0);
-            delete calcLoc;
-            
-            std::cout << "Writing data to output RAT\n";
-            size_t numBlocks = floor((double)numRows/(double)RAT_BLOCK_LENGTH);
-            size_t rowsRemain = numRows - (numBlocks * RAT_BLOCK_LENGTH);
-            
-            rsgis::math::RSGISMathsUtils mathUtils;
-            double *dataMinXBlock = new double[RAT_BLOCK_LENGTH];
-            double *dataMaxXBlock = new double[RAT_BLOCK_LENGTH];
-            double *dataMinYBlock = new double[RAT_BLOCK_LENGTH];
-            double *dataMaxYBlock = new double[RAT_BLOCK_LENGTH];
-            size_t startRow = 0;
-            size_t rowID = 0;
-            for(size_t i = 0; i < numBlocks; ++i)
-            {
-                rowID = startRow;
-                for(size_t j = 0; j < RAT_BLOCK_LENGTH; ++j)
-                {
-                    dataMinXBlock[j] = pxlLoc[rowID][0];
-                    dataMinYBlock[j] = pxlLoc[rowID][1];
-                    dataMaxXBlock[j] = pxlLoc[rowID][2];
-                    dataMaxYBlock[j] = pxlLoc[rowID][3];
-                    ++rowID;
-                }
-                attTable->ValuesIO(GF_Write, minXIdx, startRow, RAT_BLOCK_LENGTH, dataMinXBlock);
-                attTable->ValuesIO(GF_Write, minYIdx, startRow, RAT_BLOCK_LENGTH, dataMinYBlock);
-                attTable->ValuesIO(GF_Write, maxXIdx, startRow, RAT_BLOCK_LENGTH, dataMaxXBlock);
-                attTable->ValuesIO(GF_Write, maxYIdx, startRow, RAT_BLOCK_LENGTH, dataMaxYBlock);
-                
-                startRow += RAT_BLOCK_LENGTH;
-            }
-            if(rowsRemain > 0)
-            {
-                rowID = startRow;
-                for(size_t j = 0; j < rowsRemain; ++j)
-                {
-                    dataMinXBlock[j] = pxlLoc[rowID][0];
-                    dataMinYBlock[j] = pxlLoc[rowID][1];
-                    dataMaxXBlock[j] = pxlLoc[rowID][2];
-                    dataMaxYBlock[j] = pxlLoc[rowID][3];
-                    ++rowID;
-                }
-                attTable->ValuesIO(GF_Write, minXIdx, startRow, rowsRemain, dataMinXBlock);
-                attTable->ValuesIO(GF_Write, minYIdx, startRow, rowsRemain, dataMinYBlock);
-                attTable->ValuesIO(GF_Write, maxXIdx, startRow, rowsRemain, dataMaxXBlock);
-                attTable->ValuesIO(GF_Write, maxYIdx, startRow, rowsRemain, dataMaxYBlock);
-            }
-            
-            delete[] dataMinXBlock;
-            delete[] dataMinYBlock;
-            delete[] dataMaxXBlock;
-            delete[] dataMaxYBlock;
-            
-            for(size_t i = 0; i < numRows; ++i)
-            {
-                delete[] pxlLoc[i];
-            }
-            delete[] pxlLoc;
+            RSGISClumpGeometry clumpGeom;
+            clumpGeom.calcGeometry(dataset, ratBand);
+            clumpGeom.writeToRAT(dataset, ratBand, &cols);
             
             dataset->GetRasterBand(ratBand)->SetMetadataItem("LAYER_TYPE", "thematic");
         }
@@ -33,6 +33,7 @@
 #include "common/RSGISAttributeTableException.h"
 
 #include "rastergis/RSGISRasterAttUtils.h"
+#include "rastergis/RSGISClumpGeometry.h"
 
 #include "img/RSGISImageCalcException.h"
 #include "img/RSGISCalcImageValue.h"
@@ -56,6 +57,10 @@
 
 namespace rsgis{namespace rastergis{
 	
+    /**
+     * Spatial location and extent columns for each clump, calculated with
+     * RSGISClumpGeometry in a single, multi-threaded pass over the clumps image.
+     */
     class DllExport RSGISCalcClusterLocation
     {
     public:
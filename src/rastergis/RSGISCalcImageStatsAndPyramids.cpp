@@ -67,9 +67,65 @@ namespace rsgis{namespace rastergis{
                 throw rsgis::RSGISAttributeTableException("RAT Band is larger than the number of bands within the image.");
             }
             
+            // The min, max and histogram of the clumps come from one pass
+            // through the band.
+            std::cout << "Get Image Min, Max and Histogram.\n";
+            rsgis::img::RSGISSinglePassImageStats passStats(false, false, true);
+            passStats.calcStats(clumpsDataset, false, 0, std::vector<unsigned int>(1, ratBand));
+            long max = 0;
+            long min = 0;
+            if(passStats.getCount(0) > 0)
+            {
+                min = (long) passStats.getMin(0);
+                max = (long) passStats.getMax(0);
+            }
+            
+            std::vector<unsigned long long> histo;
+            if(!((min == 0) & (max == 0)))
+            {
+                if(min < 0)
+                {
+                    throw rsgis::RSGISImageException("The minimum value is less than zero.");
+                }
+                const std::vector<unsigned long long> *passHisto = passStats.getDirectHistogram(0);
+                histo.assign(max+1, 0);
+                for(size_t i = 0; (i < histo.size()) && (i < passHisto->size()); ++i)
+                {
+                    histo[i] = (*passHisto)[i];
+                }
+            }
+            this->writeHistogramToRAT(clumpsDataset, histo, addColourTable, ignoreZero, ratBand);
+        }
+        catch(rsgis::RSGISImageException &e)
+        {
+            throw e;
+        }
+        catch(rsgis::RSGISException &e)
+        {
+            throw rsgis::RSGISImageException(e.what());
+        }
+        catch(std::exception &e)
+        {
+            throw rsgis::RSGISImageException(e.what());
+        }
+    }
+    
+    void RSGISPopulateWithImageStats::writeHistogramToRAT(GDALDataset *clumpsDataset, const std::vector<unsigned long long> &histogram, bool addColourTable, bool ignoreZero, unsigned int ratBand)
+    {
+        try
+        {
+            if(ratBand == 0)
+            {
+                throw rsgis::RSGISAttributeTableException("RAT Band must be greater than zero.");
+            }
+            if(ratBand > clumpsDataset->GetRasterCount())
+            {
+                throw rsgis::RSGISAttributeTableException("RAT Band is larger than the number of bands within the image.");
+            }
+            
             rsgis::utils::RSGISTextUtils txtUtils;
             RSGISRasterAttUtils attUtils;
-                        
+            
             GDALRasterBand *band = clumpsDataset->GetRasterBand(ratBand);
             
             band->SetMetadataItem("LAYER_TYPE", "thematic");
@@ -79,15 +135,7 @@ namespace rsgis{namespace rastergis{
                 band->SetNoDataValue(0.0);
             }
             
-            long max = 0;
-            long min = 0;
-            std::cout << "Get Image Min and Max.\n";
-            RSGISCalcImgMinMax calcMinMac = RSGISCalcImgMinMax(&min, &max, ratBand-1);
-            rsgis::img::RSGISCalcImage calcImageMinMax(&calcMinMac);
-            calcImageMinMax.calcImage(&clumpsDataset, 1, 0);
-            
-            
-            if((min == 0) & (max == 0))
+            if(histogram.size() <= 1)
             {
                 band->SetMetadataItem("STATISTICS_HISTOBINFUNCTION", "direct");
                 band->SetMetadataItem("STATISTICS_HISTOMIN", "0");
@@ -139,23 +187,8 @@ namespace rsgis{namespace rastergis{
             }
             else
             {
-                if(min < 0)
-                {
-                    throw rsgis::RSGISImageException("The minimum value is less than zero.");
-                }
-                
-                size_t maxHistVal = max+1;
-                size_t *histo = new size_t[maxHistVal];
-                
-                for(size_t i = 0; i < maxHistVal; ++i)
-                {
-                    histo[i] = 0;
-                }
-                
-                std::cout << "Get Image Histogram.\n";
-                RSGISGetClumpsHistogram calcImgHisto = RSGISGetClumpsHistogram(histo, maxHistVal, (ratBand-1));
-                rsgis::img::RSGISCalcImage calcImageStats(&calcImgHisto);
-                calcImageStats.calcImage(&clumpsDataset, 1, 0);
+                size_t maxHistVal = histogram.size();
+                std::vector<double> histo(histogram.begin(), histogram.end());
                 
                 if(ignoreZero)
                 {
@@ -278,10 +311,8 @@ namespace rsgis{namespace rastergis{
                         attTable->ValuesIO(GF_Write, alphaColIdx, startRow, rowsRemain, alphaBlock);
                     }
                 }
-                delete[] histo;
             }
 
-            
         }
         catch(rsgis::RSGISImageException &e)
         {
@@ -38,6 +38,7 @@
 #include "img/RSGISImageCalcException.h"
 #include "img/RSGISCalcImageValue.h"
 #include "img/RSGISCalcImage.h"
+#include "img/RSGISSinglePassImageStats.h"
 
 #include <boost/numeric/conversion/cast.hpp>
 #include <boost/lexical_cast.hpp>
@@ -64,6 +65,13 @@ namespace rsgis{namespace rastergis{
         RSGISPopulateWithImageStats();
         void populateImageWithRasterGISStats(GDALDataset *clumpsDataset, bool addColourTable, bool calcImagePyramids, bool ignoreZero, unsigned int ratBand);
         void populateImageWithRasterGISStats(GDALDataset *clumpsDataset, bool addColourTable, bool ignoreZero, unsigned int ratBand);
+        /**
+         * Write a direct histogram of the clumps (one count per clump ID, e.g.,
+         * accumulated while the clumps were written) to the Histogram column of
+         * the RAT, with a random colour table if addColourTable, so the band
+         * does not need to be read again.
+         */
+        void writeHistogramToRAT(GDALDataset *clumpsDataset, const std::vector<unsigned long long> &histogram, bool addColourTable, bool ignoreZero, unsigned int ratBand);
         void calcPyramids(GDALDataset *clumpsDataset);
         ~RSGISPopulateWithImageStats();
     };
@@ -26,21 +26,24 @@ namespace rsgis{namespace rastergis{
     
     RSGISCalcNeighbourStats::RSGISCalcNeighbourStats()
     {
-        
+        this->clumpBlockSize = 10000;
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+    
+    void RSGISCalcNeighbourStats::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
     }
     
     void RSGISCalcNeighbourStats::populateStatsDiff2Neighbours(GDALDataset *inputClumps, RSGISFieldAttStats *fieldStats, bool useAbsDiff, unsigned int ratBand)
+    {
+        this->populateStatsDiff2Neighbours(inputClumps, std::vector<RSGISFieldAttStats*>(1, fieldStats), useAbsDiff, ratBand);
+    }
+    
+    void RSGISCalcNeighbourStats::populateStatsDiff2Neighbours(GDALDataset *inputClumps, std::vector<RSGISFieldAttStats*> fieldStats, bool useAbsDiff, unsigned int ratBand)
     {
         try
         {
-            RSGISRasterAttUtils attUtils;
-            rsgis::math::RSGISMathsUtils mathUtils;
-            double *minDiffCol = NULL;
-            double *maxDiffCol = NULL;
-            double *sumDiffCol = NULL;
-            double *meanDiffCol = NULL;
-            double *stddevDiffCol = NULL;
-            
             if(ratBand == 0)
             {
                 throw rsgis::RSGISAttributeTableException("RAT Band must be greater than zero.");
@@ -58,159 +61,151 @@ namespace rsgis{namespace rastergis{
                 throw rsgis::RSGISAttributeTableException("RAT has no rows, i.e., it is empty!");
             }
             
-            fieldStats->fieldIdx = attUtils.findColumnIndex(rat, fieldStats->field);
-            
-            std::vector<std::vector<size_t>* > *neighbours = attUtils.getRATNeighbours(inputClumps, ratBand);
-            
-            if(numRows != neighbours->size())
+            RSGISRegionAdjacencyGraph rag;
+            rag.readOrBuild(inputClumps, ratBand, true);
+            size_t numNodes = rag.getNumNodes();
+            if(numNodes > numRows)
             {
-                for(std::vector<std::vector<size_t>* >::iterator iterNeigh = neighbours->begin(); iterNeigh != neighbours->end(); ++iterNeigh)
-                {
-                    delete *iterNeigh;
-                }
-                delete neighbours;
-                
                 throw rsgis::RSGISAttributeTableException("RAT size is different to the number of neighbours retrieved.");
             }
             
-            size_t colLen = 0;
-            double *dataVals = attUtils.readDoubleColumn(rat, fieldStats->field, &colLen);
-            
-            if(colLen != numRows)
-            {
-                for(std::vector<std::vector<size_t>* >::iterator iterNeigh = neighbours->begin(); iterNeigh != neighbours->end(); ++iterNeigh)
+            RSGISRasterAttUtils attUtils;
+            RSGISRATColumnCache colCache(rat);
+            std::vector<FieldStatCols> cols;
+            for(std::vector<RSGISFieldAttStats*>::iterator iterField = fieldStats.begin(); iterField != fieldStats.end(); ++iterField)
+            {
+                RSGISFieldAttStats *field = *iterField;
+                FieldStatCols fieldCols;
+                field->fieldIdx = attUtils.findColumnIndex(rat, field->field);
+                fieldCols.vals = colCache.getRealColumn(field->field);
+                fieldCols.minCol = NULL;
+                fieldCols.maxCol = NULL;
+                fieldCols.meanCol = NULL;
+                fieldCols.stdDevCol = NULL;
+                fieldCols.sumCol = NULL;
+                if(field->calcMin)
                 {
-                    delete *iterNeigh;
+                    fieldCols.minCol = colCache.getRealColumn(field->minField, true);
+                    colCache.setColumnChanged(field->minField);
                 }
-                delete neighbours;
-                delete[] dataVals;
-                throw rsgis::RSGISAttributeTableException("The column does not have enough values ");
-            }
-            
-            std::vector<double> *diffClumpVals = new std::vector<double>();
-            rsgis::math::RSGISStatsSummary *stats2Calc = new rsgis::math::RSGISStatsSummary();
-            
-            if(fieldStats->calcMin)
-            {
-                stats2Calc->calcMin = true;
-                fieldStats->minFieldIdx = attUtils.findColumnIndexOrCreate(rat, fieldStats->minField, GFT_Real);
-                minDiffCol = new double[numRows];
-            }
-            if(fieldStats->calcMax)
-            {
-                stats2Calc->calcMax = true;
-                fieldStats->maxFieldIdx = attUtils.findColumnIndexOrCreate(rat, fieldStats->maxField, GFT_Real);
-                maxDiffCol = new double[numRows];
-            }
-            if(fieldStats->calcMean)
-            {
-                stats2Calc->calcMean = true;
-                fieldStats->meanFieldIdx = attUtils.findColumnIndexOrCreate(rat, fieldStats->meanField, GFT_Real);
-                meanDiffCol = new double[numRows];
-            }
-            if(fieldStats->calcStdDev)
-            {
-                stats2Calc->calcStdDev = true;
-                fieldStats->stdDevFieldIdx = attUtils.findColumnIndexOrCreate(rat, fieldStats->stdDevField, GFT_Real);
-                stddevDiffCol = new double[numRows];
-            }
-            if(fieldStats->calcSum)
-            {
-                stats2Calc->calcSum = true;
-                fieldStats->sumFieldIdx = attUtils.findColumnIndexOrCreate(rat, fieldStats->sumField, GFT_Real);
-                sumDiffCol = new double[numRows];
+                if(field->calcMax)
+                {
+                    fieldCols.maxCol = colCache.getRealColumn(field->maxField, true);
+                    colCache.setColumnChanged(field->maxField);
+                }
+                if(field->calcMean)
+                {
+                    fieldCols.meanCol = colCache.getRealColumn(field->meanField, true);
+                    colCache.setColumnChanged(field->meanField);
+                }
+                if(field->calcStdDev)
+                {
+                    fieldCols.stdDevCol = colCache.getRealColumn(field->stdDevField, true);
+                    colCache.setColumnChanged(field->stdDevField);
+                }
+                if(field->calcSum)
+                {
+                    fieldCols.sumCol = colCache.getRealColumn(field->sumField, true);
+                    colCache.setColumnChanged(field->sumField);
+                }
+                cols.push_back(fieldCols);
             }
             
-            for(size_t i  = 0; i <  numRows; ++i)
-            {
-                diffClumpVals->clear();
-                std::vector<size_t> *clumpNeigh = neighbours->at(i);
-                diffClumpVals->reserve(clumpNeigh->size());
-                stats2Calc->min = 0.0;
-                stats2Calc->max = 0.0;
-                stats2Calc->mean = 0.0;
-                stats2Calc->stdDev = 0.0;
-                stats2Calc->sum = 0.0;
-                for(std::vector<size_t>::iterator iterNeigh = clumpNeigh->begin(); iterNeigh != clumpNeigh->end(); ++iterNeigh)
+            size_t numBlocks = (numRows + this->clumpBlockSize - 1) / this->clumpBlockSize;
+            rsgis::utils::RSGISWorkerPool pool(std::max<size_t>(1, std::min<size_t>(this->numThreads, numBlocks)));
+            std::vector<std::vector<double> > threadDiffs(pool.getNumThreads());
+            pool.parallelFor(numBlocks, [&](size_t block, unsigned int t)
+            {
+                std::vector<double> &diffs = threadDiffs[t];
+                size_t endFID = std::min(numRows, (block+1) * this->clumpBlockSize);
+                for(size_t fid = block * this->clumpBlockSize; fid < endFID; ++fid)
                 {
-                    if(useAbsDiff)
+                    if(fid < numNodes)
                     {
-                        diffClumpVals->push_back(fabs(dataVals[i] - dataVals[*iterNeigh]));
+                        this->calcClumpStats(fid, rag.getNeighbours(fid), rag.getNumNeighbours(fid), cols, useAbsDiff, diffs);
                     }
                     else
                     {
-                        diffClumpVals->push_back((dataVals[i] - dataVals[*iterNeigh]));
+                        this->calcClumpStats(fid, NULL, 0, cols, useAbsDiff, diffs);
                     }
                 }
-                
-                mathUtils.generateStats(diffClumpVals, stats2Calc);
-                if(stats2Calc->calcMin)
-                {
-                    minDiffCol[i] = stats2Calc->min;
-                }
-                if(stats2Calc->calcMax)
-                {
-                    maxDiffCol[i] = stats2Calc->max;
-                }
-                if(stats2Calc->calcMean)
-                {
-                    meanDiffCol[i] = stats2Calc->mean;
-                }
-                if(stats2Calc->calcStdDev)
+            });
+            
+            colCache.flush();
+        }
+        catch(RSGISAttributeTableException &e)
+        {
+            throw e;
+        }
+        catch(RSGISException &e)
+        {
+            throw RSGISAttributeTableException(e.what());
+        }
+        catch(std::exception &e)
+        {
+            throw RSGISAttributeTableException(e.what());
+        }
+    }
+    
+    void RSGISCalcNeighbourStats::calcClumpStats(size_t fid, const unsigned int *neighbours, size_t numNeighbours, std::vector<FieldStatCols> &cols, bool useAbsDiff, std::vector<double> &diffs)
+    {
+        diffs.resize(numNeighbours);
+        for(std::vector<FieldStatCols>::iterator iterCols = cols.begin(); iterCols != cols.end(); ++iterCols)
+        {
+            const double *vals = (*iterCols).vals;
+            double minVal = 0.0;
+            double maxVal = 0.0;
+            double sum = 0.0;
+            double mean = 0.0;
+            double stdDev = 0.0;
+            if(numNeighbours > 0)
+            {
+                minVal = std::numeric_limits<double>::max();
+                maxVal = -std::numeric_limits<double>::max();
+                for(size_t n = 0; n < numNeighbours; ++n)
                 {
-                    stddevDiffCol[i] = stats2Calc->stdDev;
+                    double diff = vals[fid] - vals[neighbours[n]];
+                    if(useAbsDiff)
+                    {
+                        diff = fabs(diff);
+                    }
+                    diffs[n] = diff;
+                    minVal = std::min(minVal, diff);
+                    maxVal = std::max(maxVal, diff);
+                    sum += diff;
                 }
-                if(stats2Calc->calcSum)
+                mean = sum / numNeighbours;
+                if((*iterCols).stdDevCol != NULL)
                 {
-                    sumDiffCol[i] = stats2Calc->sum;
+                    // Two-pass sample standard deviation, as gsl_stats_sd_m.
+                    double sumSq = 0.0;
+                    for(size_t n = 0; n < numNeighbours; ++n)
+                    {
+                        sumSq += (diffs[n] - mean) * (diffs[n] - mean);
+                    }
+                    stdDev = sqrt(sumSq / (numNeighbours - 1.0));
                 }
             }
-            
-            if(fieldStats->calcMin)
+            if((*iterCols).minCol != NULL)
             {
-                rat->ValuesIO(GF_Write, fieldStats->minFieldIdx, 0, numRows, minDiffCol);
-                delete[] minDiffCol;
+                (*iterCols).minCol[fid] = minVal;
             }
-            if(fieldStats->calcMax)
+            if((*iterCols).maxCol != NULL)
             {
-                rat->ValuesIO(GF_Write, fieldStats->maxFieldIdx, 0, numRows, maxDiffCol);
-                delete[] maxDiffCol;
+                (*iterCols).maxCol[fid] = maxVal;
             }
-            if(fieldStats->calcMean)
+            if((*iterCols).meanCol != NULL)
             {
-                rat->ValuesIO(GF_Write, fieldStats->meanFieldIdx, 0, numRows, meanDiffCol);
-                delete[] meanDiffCol;
+                (*iterCols).meanCol[fid] = mean;
             }
-            if(fieldStats->calcStdDev)
+            if((*iterCols).stdDevCol != NULL)
             {
-                rat->ValuesIO(GF_Write, fieldStats->stdDevFieldIdx, 0, numRows, stddevDiffCol);
-                delete[] stddevDiffCol;
+                (*iterCols).stdDevCol[fid] = stdDev;
             }
-            if(fieldStats->calcSum)
+            if((*iterCols).sumCol != NULL)
             {
-                rat->ValuesIO(GF_Write, fieldStats->sumFieldIdx, 0, numRows, sumDiffCol);
-                delete[] sumDiffCol;
+                (*iterCols).sumCol[fid] = sum;
             }
-            delete stats2Calc;
-            
-            for(std::vector<std::vector<size_t>* >::iterator iterNeigh = neighbours->begin(); iterNeigh != neighbours->end(); ++iterNeigh)
-            {
-                delete *iterNeigh;
-            }
-            delete neighbours;
-            
-        }
-        catch(RSGISAttributeTableException &e)
-        {
-            throw e;
-        }
-        catch(RSGISException &e)
-        {
-            throw RSGISAttributeTableException(e.what());
-        }
-        catch(std::exception &e)
-        {
-            throw RSGISAttributeTableException(e.what());
         }
     }
     
@@ -26,15 +26,23 @@
 #include <string>
 #include <vector>
 #include <math.h>
+#include <limits>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <cstdlib>
 
 #include "gdal_priv.h"
 #include "gdal_rat.h"
 
 #include "common/RSGISAttributeTableException.h"
+#include "common/RSGISParallel.h"
 
 #include "math/RSGISMathsUtils.h"
 
 #include "rastergis/RSGISRasterAttUtils.h"
+#include "rastergis/RSGISRATColumnCache.h"
+#include "rastergis/RSGISRegionAdjacencyGraph.h"
 
 #include <boost/numeric/conversion/cast.hpp>
 #include <boost/lexical_cast.hpp>
@@ -76,12 +84,39 @@ namespace rsgis{namespace rastergis{
         unsigned int sumFieldIdx;
     };
     
+    /**
+     * Calculates, for each clump, statistics of the difference between the
+     * clump's value and the values of its neighbours.
+     *
+     * The neighbours are taken from the region adjacency graph (read from the
+     * KEA neighbours table if it has been cached, otherwise built from the
+     * image) and the columns are held in memory, so the clumps are processed
+     * in ranges across threads (RSGISLIB_NUM_THREADS).
+     */
     class DllExport RSGISCalcNeighbourStats
     {
     public:
         RSGISCalcNeighbourStats();
+        void setNumThreads(unsigned int numThreads);
         void populateStatsDiff2Neighbours(GDALDataset *inputClumps, RSGISFieldAttStats *fieldStats, bool useAbsDiff, unsigned int ratBand);
+        /**
+         * Calculate the statistics for several fields in one traversal of the neighbours.
+         */
+        void populateStatsDiff2Neighbours(GDALDataset *inputClumps, std::vector<RSGISFieldAttStats*> fieldStats, bool useAbsDiff, unsigned int ratBand);
         ~RSGISCalcNeighbourStats();
+    protected:
+        struct FieldStatCols
+        {
+            const double *vals;
+            double *minCol;
+            double *maxCol;
+            double *meanCol;
+            double *stdDevCol;
+            double *sumCol;
+        };
+        void calcClumpStats(size_t fid, const unsigned int *neighbours, size_t numNeighbours, std::vector<FieldStatCols> &cols, bool useAbsDiff, std::vector<double> &diffs);
+        unsigned int numThreads;
+        size_t clumpBlockSize;
     };
     
 }}
@@ -33,50 +33,14 @@ namespace rsgis{namespace rastergis{
     {
         try
         {
-            RSGISRasterAttUtils attUtils;
-            GDALRasterAttributeTable *attTable = clumpImage->GetRasterBand(1)->GetDefaultRAT();
-            
-            // Make sure it is long enough and extend if required.
-            int numRows = attTable->GetRowCount();
-            
-            long maxVal = 0;
-            long minVal = 0;
-            attUtils.getImageBandMinMax(clumpImage, 1, &minVal, &maxVal);
-            
-            if(maxVal > numRows)
-            {
-                attTable->SetRowCount(maxVal+1);
-            }
-            numRows = attTable->GetRowCount();
-            
-            double *trans = new double[6];
-            clumpImage->GetGeoTransform(trans);
-            
-            double xRes = trans[1];
-            double yRes = trans[5];
-            if(yRes < 0)
-            {
-                yRes = yRes * (-1);
-            }
-            delete[] trans;
-            
-            double *borderLenPxls = new double[numRows];
-            for(size_t i = 0; i < numRows; ++i)
-            {
-                borderLenPxls[i] = 0;
-            }
-            
-            rsgis::img::RSGISCalcImageValue *calcBorderLen = new RSGISCalcBorderLenInPixels(borderLenPxls, numRows, xRes, yRes, includeZeroEdges);
-            rsgis::img::RSGISCalcImage imgCalc = rsgis::img::RSGISCalcImage(calcBorderLen);
-            
-            imgCalc.calcImageWindowData(&clumpImage, 1, 3);
-            
-            
-            unsigned int borderLenColIdx = attUtils.findColumnIndexOrCreate(attTable, colName, GFT_Real);
-            
-            attTable->ValuesIO(GF_Write, borderLenColIdx, 0, numRows, borderLenPxls);
+            // Edges with other clumps (and, optionally, no data or the image edge) in one pass.
+            RSGISClumpGeometryCols cols;
+            cols.borderLenCol = colName;
+            cols.borderIncludeZeroEdges = includeZeroEdges;
             
-            delete[] borderLenPxls;
+            RSGISClumpGeometry clumpGeom;
+            clumpGeom.calcGeometry(clumpImage, 1);
+            clumpGeom.writeToRAT(clumpImage, 1, &cols);
         }
         catch (rsgis::img::RSGISImageCalcException &e)
         {
@@ -35,6 +35,7 @@
 #include "img/RSGISCalcImageValue.h"
 #include "img/RSGISCalcImage.h"
 #include "rastergis/RSGISRasterAttUtils.h"
+#include "rastergis/RSGISClumpGeometry.h"
 
 #include "gdal_priv.h"
 #include "ogrsf_frmts.h"
@@ -0,0 +1,614 @@
+/*
+ *  RSGISClumpGeometry.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISClumpGeometry.h"
+
+namespace rsgis{namespace rastergis{
+
+    const size_t RSGISClumpGeometry::groupRows = 64;
+
+    RSGISClumpGeometry::RSGISClumpGeometry()
+    {
+        this->numThreads = rsgis::utils::getNumThreads();
+        for(int i = 0; i < 6; ++i)
+        {
+            this->transform[i] = 0.0;
+        }
+    }
+
+    void RSGISClumpGeometry::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+
+    void RSGISClumpGeometry::calcGeometry(GDALDataset *clumpsImage, unsigned int ratBand)
+    {
+        if((ratBand == 0) || (ratBand > ((unsigned int)clumpsImage->GetRasterCount())))
+        {
+            throw RSGISAttributeTableException("The RAT band is not within the clumps image.");
+        }
+        GDALRasterBand *clumpsBand = clumpsImage->GetRasterBand(ratBand);
+        GDALRasterAttributeTable *attTable = clumpsBand->GetDefaultRAT();
+
+        // Make sure the RAT is long enough and extend if required.
+        RSGISRasterAttUtils attUtils;
+        size_t numRows = attTable->GetRowCount();
+        long minVal = 0;
+        long maxVal = 0;
+        attUtils.getImageBandMinMax(clumpsImage, ratBand, &minVal, &maxVal);
+        if((maxVal >= 0) && (((size_t)maxVal) >= numRows))
+        {
+            attTable->SetRowCount(maxVal+1);
+            numRows = maxVal+1;
+        }
+
+        clumpsImage->GetGeoTransform(this->transform);
+        ClumpGeom emptyGeom;
+        this->initClumpGeom(&emptyGeom);
+        this->geom.assign(numRows, emptyGeom);
+
+        size_t width = clumpsImage->GetRasterXSize();
+        size_t height = clumpsImage->GetRasterYSize();
+        int xBlockSize = 0;
+        int yBlockSize = 0;
+        clumpsBand->GetBlockSize(&xBlockSize, &yBlockSize);
+
+        // Strips of whole blocks with the row above and below (zero outside the
+        // image). Strips are a whole number of groups, with enough groups to
+        // share between the threads.
+        rsgis::utils::RSGISWorkerPool pool(this->numThreads);
+        size_t stripRows = std::max<size_t>(std::max<size_t>(std::max(yBlockSize, 1), 256), groupRows * pool.getNumThreads());
+        stripRows = ((stripRows + groupRows - 1) / groupRows) * groupRows;
+        std::vector<uint32_t> rows((stripRows+2) * width, 0);
+        std::vector<ClumpGeomGroup> groups(stripRows / groupRows);
+        rsgis_tqdm pbar;
+        for(size_t stripStart = 0; stripStart < height; stripStart += stripRows)
+        {
+            pbar.progress(stripStart, height);
+            size_t nRows = std::min(stripRows, height - stripStart);
+            size_t readStart = (stripStart > 0)?(stripStart-1):0;
+            size_t readEnd = std::min(stripStart + nRows + 1, height);
+            uint32_t *readPtr = rows.data() + ((stripStart > 0)?0:width);
+            std::fill(rows.begin(), rows.end(), 0);
+            if(clumpsBand->RasterIO(GF_Read, 0, readStart, width, readEnd-readStart, readPtr, width, readEnd-readStart, GDT_UInt32, 0, 0) != CE_None)
+            {
+                throw RSGISAttributeTableException("Could not read the clumps image.");
+            }
+
+            size_t numGroups = (nRows + groupRows - 1) / groupRows;
+            pool.parallelFor(numGroups, [&](size_t grp, unsigned int t)
+            {
+                size_t rowStart = grp * groupRows;
+                this->accumulateRows(rows.data(), width, rowStart, std::min(rowStart + groupRows, nRows), stripStart, &groups[grp]);
+            });
+
+            // Merge the groups in image order.
+            for(size_t grp = 0; grp < numGroups; ++grp)
+            {
+                ClumpGeomGroup &group = groups[grp];
+                for(size_t i = 0; i < group.fids.size(); ++i)
+                {
+                    this->mergeClumpGeom(&this->geom[group.fids[i]], group.geoms[i]);
+                }
+            }
+        }
+        pbar.finish();
+    }
+
+    void RSGISClumpGeometry::initClumpGeom(ClumpGeom *g) const
+    {
+        g->n = 0;
+        g->refCol = 0;
+        g->refRow = 0;
+        g->sumX = 0;
+        g->sumY = 0;
+        g->sumXX = 0;
+        g->sumYY = 0;
+        g->sumXY = 0;
+        g->minCol = 0;
+        g->minColRow = 0;
+        g->maxCol = 0;
+        g->maxColRow = 0;
+        g->maxRow = 0;
+        g->maxRowCol = 0;
+        g->edgesLR = 0;
+        g->edgesUD = 0;
+        g->zeroEdgesLR = 0;
+        g->zeroEdgesUD = 0;
+        g->boundaryPxls = 0;
+        g->contourLen = 0;
+    }
+
+    void RSGISClumpGeometry::mergeClumpGeom(ClumpGeom *g, const ClumpGeom &other) const
+    {
+        if(other.n == 0)
+        {
+            return;
+        }
+        if(g->n == 0)
+        {
+            *g = other;
+            return;
+        }
+        // Move the sums of other to be relative to the reference pixel of g.
+        double offX = ((double)other.refCol) - g->refCol;
+        double offY = ((double)other.refRow) - g->refRow;
+        double n = other.n;
+        g->sumXX += other.sumXX + (2 * offX * other.sumX) + (n * offX * offX);
+        g->sumYY += other.sumYY + (2 * offY * other.sumY) + (n * offY * offY);
+        g->sumXY += other.sumXY + (offX * other.sumY) + (offY * other.sumX) + (n * offX * offY);
+        g->sumX += other.sumX + (n * offX);
+        g->sumY += other.sumY + (n * offY);
+        g->n += other.n;
+
+        // Strict comparisons keep the first pixel found, in image order.
+        if(other.minCol < g->minCol)
+        {
+            g->minCol = other.minCol;
+            g->minColRow = other.minColRow;
+        }
+        if(other.maxCol > g->maxCol)
+        {
+            g->maxCol = other.maxCol;
+            g->maxColRow = other.maxColRow;
+        }
+        if(other.maxRow > g->maxRow)
+        {
+            g->maxRow = other.maxRow;
+            g->maxRowCol = other.maxRowCol;
+        }
+        g->edgesLR += other.edgesLR;
+        g->edgesUD += other.edgesUD;
+        g->zeroEdgesLR += other.zeroEdgesLR;
+        g->zeroEdgesUD += other.zeroEdgesUD;
+        g->boundaryPxls += other.boundaryPxls;
+        g->contourLen += other.contourLen;
+    }
+
+    void RSGISClumpGeometry::accumulateRows(const uint32_t *rows, size_t width, size_t rowStart, size_t rowEnd, size_t stripStart, ClumpGeomGroup *group)
+    {
+        size_t numClumps = this->geom.size();
+        group->fids.clear();
+        group->geoms.clear();
+        group->index.clear();
+        ClumpGeom emptyGeom;
+        this->initClumpGeom(&emptyGeom);
+        uint32_t prevFid = 0;
+        size_t prevIdx = 0;
+        for(size_t r = rowStart; r < rowEnd; ++r)
+        {
+            const uint32_t *row = rows + ((r+1) * width);
+            const uint32_t *above = row - width;
+            const uint32_t *below = row + width;
+            uint32_t imgRow = stripStart + r;
+            for(size_t j = 0; j < width; ++j)
+            {
+                uint32_t fid = row[j];
+                if((fid == 0) || (fid >= numClumps))
+                {
+                    continue;
+                }
+                if(fid != prevFid)
+                {
+                    std::unordered_map<uint32_t, size_t>::iterator iterIdx = group->index.find(fid);
+                    if(iterIdx == group->index.end())
+                    {
+                        prevIdx = group->geoms.size();
+                        group->index[fid] = prevIdx;
+                        group->fids.push_back(fid);
+                        group->geoms.push_back(emptyGeom);
+                    }
+                    else
+                    {
+                        prevIdx = iterIdx->second;
+                    }
+                    prevFid = fid;
+                }
+                ClumpGeom &g = group->geoms[prevIdx];
+                uint32_t col = j;
+                if(g.n == 0)
+                {
+                    g.refCol = col;
+                    g.refRow = imgRow;
+                    g.minCol = col;
+                    g.minColRow = imgRow;
+                    g.maxCol = col;
+                    g.maxColRow = imgRow;
+                    g.maxRow = imgRow;
+                    g.maxRowCol = col;
+                }
+                else
+                {
+                    // Strict comparisons keep the first pixel found, in image order.
+                    if(col < g.minCol)
+                    {
+                        g.minCol = col;
+                        g.minColRow = imgRow;
+                    }
+                    if(col > g.maxCol)
+                    {
+                        g.maxCol = col;
+                        g.maxColRow = imgRow;
+                    }
+                    if(imgRow > g.maxRow)
+                    {
+                        g.maxRow = imgRow;
+                        g.maxRowCol = col;
+                    }
+                }
+                ++g.n;
+                double dx = ((double)col) - g.refCol;
+                double dy = ((double)imgRow) - g.refRow;
+                g.sumX += dx;
+                g.sumY += dy;
+                g.sumXX += dx * dx;
+                g.sumYY += dy * dy;
+                g.sumXY += dx * dy;
+
+                uint32_t left = (j > 0)?row[j-1]:0;
+                uint32_t right = ((j+1) < width)?row[j+1]:0;
+                if(left != fid)
+                {
+                    ++g.edgesLR;
+                    g.zeroEdgesLR += (left == 0);
+                }
+                if(right != fid)
+                {
+                    ++g.edgesLR;
+                    g.zeroEdgesLR += (right == 0);
+                }
+                if(above[j] != fid)
+                {
+                    ++g.edgesUD;
+                    g.zeroEdgesUD += (above[j] == 0);
+                }
+                if(below[j] != fid)
+                {
+                    ++g.edgesUD;
+                    g.zeroEdgesUD += (below[j] == 0);
+                }
+
+                bool inLeft = (left == fid);
+                bool inRight = (right == fid);
+                bool inAbove = (above[j] == fid);
+                bool inBelow = (below[j] == fid);
+                bool inAboveLeft = (j > 0) && (above[j-1] == fid);
+                bool inAboveRight = ((j+1) < width) && (above[j+1] == fid);
+                bool inBelowLeft = (j > 0) && (below[j-1] == fid);
+                bool inBelowRight = ((j+1) < width) && (below[j+1] == fid);
+                if(!(inLeft && inRight && inAbove && inBelow))
+                {
+                    ++g.boundaryPxls;
+                }
+                else if(inAboveLeft && inAboveRight && inBelowLeft && inBelowRight)
+                {
+                    // Interior pixel, none of its windows cross the contour.
+                    continue;
+                }
+
+                // Each of the four 2x2 windows containing the pixel is counted
+                // once, by the first of its pixels (in image order) in the clump.
+                g.contourLen += this->windowContourLength(true, inRight, inBelow, inBelowRight);
+                if(!inLeft)
+                {
+                    g.contourLen += this->windowContourLength(false, true, inBelowLeft, inBelow);
+                }
+                if(!inAbove && !inAboveRight)
+                {
+                    g.contourLen += this->windowContourLength(false, false, true, inRight);
+                }
+                if(!inAboveLeft && !inAbove && !inLeft)
+                {
+                    g.contourLen += this->windowContourLength(false, false, false, true);
+                }
+            }
+        }
+    }
+
+    double RSGISClumpGeometry::windowContourLength(bool tl, bool tr, bool bl, bool br) const
+    {
+        // Marching squares: a corner cut for one or three pixels, a straight
+        // section for two adjacent pixels and two corners for a diagonal pair.
+        unsigned int count = tl + tr + bl + br;
+        if((count == 1) || (count == 3))
+        {
+            return M_SQRT1_2;
+        }
+        else if(count == 2)
+        {
+            return (tl == br)?M_SQRT2:1.0;
+        }
+        return 0.0;
+    }
+
+    void RSGISClumpGeometry::writeToRAT(GDALDataset *clumpsImage, unsigned int ratBand, RSGISClumpGeometryCols *cols)
+    {
+        if((ratBand == 0) || (ratBand > ((unsigned int)clumpsImage->GetRasterCount())))
+        {
+            throw RSGISAttributeTableException("The RAT band is not within the clumps image.");
+        }
+        GDALRasterAttributeTable *attTable = clumpsImage->GetRasterBand(ratBand)->GetDefaultRAT();
+        size_t numRows = this->geom.size();
+        if(((size_t)attTable->GetRowCount()) < numRows)
+        {
+            attTable->SetRowCount(numRows);
+        }
+
+        double xRes = this->transform[1];
+        double yRes = fabs(this->transform[5]);
+        std::vector<double> vals(numRows, 0.0);
+
+        if(cols->pxlCountCol != "")
+        {
+            for(size_t i = 0; i < numRows; ++i)
+            {
+                vals[i] = this->geom[i].n;
+            }
+            this->writeColumn(attTable, cols->pxlCountCol, vals);
+        }
+        if((cols->eastCol != "") || (cols->northCol != ""))
+        {
+            std::vector<double> northVals(numRows, 0.0);
+            for(size_t i = 0; i < numRows; ++i)
+            {
+                const ClumpGeom &g = this->geom[i];
+                vals[i] = 0.0;
+                northVals[i] = 0.0;
+                if(g.n > 0)
+                {
+                    double meanCol = g.refCol + (g.sumX / g.n) + 0.5;
+                    double meanRow = g.refRow + (g.sumY / g.n) + 0.5;
+                    vals[i] = this->transform[0] + (meanCol * this->transform[1]) + (meanRow * this->transform[2]);
+                    northVals[i] = this->transform[3] + (meanCol * this->transform[4]) + (meanRow * this->transform[5]);
+                }
+            }
+            if(cols->eastCol != "")
+            {
+                this->writeColumn(attTable, cols->eastCol, vals);
+            }
+            if(cols->northCol != "")
+            {
+                this->writeColumn(attTable, cols->northCol, northVals);
+            }
+        }
+
+        // Pixel extents.
+        std::string pxlCols[4] = {cols->minXPxlCol, cols->maxXPxlCol, cols->minYPxlCol, cols->maxYPxlCol};
+        for(int c = 0; c < 4; ++c)
+        {
+            if(pxlCols[c] == "")
+            {
+                continue;
+            }
+            for(size_t i = 0; i < numRows; ++i)
+            {
+                const ClumpGeom &g = this->geom[i];
+                switch(c)
+                {
+                    case 0:
+                        vals[i] = g.minCol;
+                        break;
+                    case 1:
+                        vals[i] = g.maxCol;
+                        break;
+                    case 2:
+                        vals[i] = g.refRow;
+                        break;
+                    default:
+                        vals[i] = g.maxRow;
+                        break;
+                }
+            }
+            this->writeColumn(attTable, pxlCols[c], vals);
+        }
+
+        // Map extents (for a north up image): the top left corner of the left most pixel,
+        // bottom right of the right most, bottom left of the bottom most and top right of the top most.
+        std::string mapCols[8] = {cols->minXColX, cols->minXColY, cols->maxXColX, cols->maxXColY, cols->minYColX, cols->minYColY, cols->maxYColX, cols->maxYColY};
+        for(int c = 0; c < 8; ++c)
+        {
+            if(mapCols[c] == "")
+            {
+                continue;
+            }
+            for(size_t i = 0; i < numRows; ++i)
+            {
+                const ClumpGeom &g = this->geom[i];
+                if(g.n == 0)
+                {
+                    vals[i] = 0.0;
+                    continue;
+                }
+                switch(c)
+                {
+                    case 0:
+                        vals[i] = this->transform[0] + (g.minCol * this->transform[1]);
+                        break;
+                    case 1:
+                        vals[i] = this->transform[3] + (g.minColRow * this->transform[5]);
+                        break;
+                    case 2:
+                        vals[i] = this->transform[0] + ((g.maxCol+1.0) * this->transform[1]);
+                        break;
+                    case 3:
+                        vals[i] = this->transform[3] + ((g.maxColRow+1.0) * this->transform[5]);
+                        break;
+                    case 4:
+                        vals[i] = this->transform[0] + (g.maxRowCol * this->transform[1]);
+                        break;
+                    case 5:
+                        vals[i] = this->transform[3] + ((g.maxRow+1.0) * this->transform[5]);
+                        break;
+                    case 6:
+                        vals[i] = this->transform[0] + ((g.refCol+1.0) * this->transform[1]);
+                        break;
+                    default:
+                        vals[i] = this->transform[3] + (g.refRow * this->transform[5]);
+                        break;
+                }
+            }
+            this->writeColumn(attTable, mapCols[c], vals);
+        }
+
+        if(cols->perimeterCol != "")
+        {
+            for(size_t i = 0; i < numRows; ++i)
+            {
+                vals[i] = ((double)this->geom[i].edgesLR) + this->geom[i].edgesUD;
+            }
+            this->writeColumn(attTable, cols->perimeterCol, vals);
+        }
+        if(cols->borderLenCol != "")
+        {
+            for(size_t i = 0; i < numRows; ++i)
+            {
+                const ClumpGeom &g = this->geom[i];
+                double edgesLR = g.edgesLR;
+                double edgesUD = g.edgesUD;
+                if(!cols->borderIncludeZeroEdges)
+                {
+                    edgesLR -= g.zeroEdgesLR;
+                    edgesUD -= g.zeroEdgesUD;
+                }
+                vals[i] = (edgesLR * xRes) + (edgesUD * yRes);
+            }
+            this->writeColumn(attTable, cols->borderLenCol, vals);
+        }
+
+        // Shape from the eigenvalues of the covariance of the pixel locations.
+        std::string shapeCols[5] = {cols->majorAxisCol, cols->minorAxisCol, cols->orientationCol, cols->eccentricityCol, cols->compactnessCol};
+        for(int c = 0; c < 5; ++c)
+        {
+            if(shapeCols[c] == "")
+            {
+                continue;
+            }
+            for(size_t i = 0; i < numRows; ++i)
+            {
+                const ClumpGeom &g = this->geom[i];
+                vals[i] = 0.0;
+                if(g.n == 0)
+                {
+                    continue;
+                }
+                double meanX = g.sumX / g.n;
+                double meanY = g.sumY / g.n;
+                double cxx = std::max(0.0, (g.sumXX / g.n) - (meanX * meanX));
+                double cyy = std::max(0.0, (g.sumYY / g.n) - (meanY * meanY));
+                double cxy = (g.sumXY / g.n) - (meanX * meanY);
+                double halfTrace = (cxx + cyy) / 2;
+                double disc = sqrt((((cxx - cyy) / 2) * ((cxx - cyy) / 2)) + (cxy * cxy));
+                double lambda1 = halfTrace + disc;
+                double lambda2 = std::max(0.0, halfTrace - disc);
+                switch(c)
+                {
+                    case 0:
+                        vals[i] = 4 * sqrt(lambda1);
+                        break;
+                    case 1:
+                        vals[i] = 4 * sqrt(lambda2);
+                        break;
+                    case 2:
+                        vals[i] = 0.5 * atan2(2 * cxy, cxx - cyy) * (180.0 / M_PI);
+                        break;
+                    case 3:
+                        vals[i] = (lambda1 > 0)?sqrt(1 - (lambda2 / lambda1)):0.0;
+                        break;
+                    default:
+                    {
+                        double perimeter = ((double)g.edgesLR) + g.edgesUD;
+                        vals[i] = (4 * M_PI * g.n) / (perimeter * perimeter);
+                        break;
+                    }
+                }
+            }
+            this->writeColumn(attTable, shapeCols[c], vals);
+        }
+
+        // Descriptors from the boundary contour.
+        std::string boundaryCols[5] = {cols->contourLenCol, cols->boundaryPxlsCol, cols->circularityCol, cols->elongationCol, cols->rectangularityCol};
+        for(int c = 0; c < 5; ++c)
+        {
+            if(boundaryCols[c] == "")
+            {
+                continue;
+            }
+            for(size_t i = 0; i < numRows; ++i)
+            {
+                const ClumpGeom &g = this->geom[i];
+                vals[i] = 0.0;
+                if(g.n == 0)
+                {
+                    continue;
+                }
+                switch(c)
+                {
+                    case 0:
+                        vals[i] = g.contourLen;
+                        break;
+                    case 1:
+                        vals[i] = g.boundaryPxls;
+                        break;
+                    case 2:
+                        vals[i] = (4 * M_PI * g.n) / (g.contourLen * g.contourLen);
+                        break;
+                    case 3:
+                    {
+                        double meanX = g.sumX / g.n;
+                        double meanY = g.sumY / g.n;
+                        double cxx = std::max(0.0, (g.sumXX / g.n) - (meanX * meanX));
+                        double cyy = std::max(0.0, (g.sumYY / g.n) - (meanY * meanY));
+                        double cxy = (g.sumXY / g.n) - (meanX * meanY);
+                        double halfTrace = (cxx + cyy) / 2;
+                        double disc = sqrt((((cxx - cyy) / 2) * ((cxx - cyy) / 2)) + (cxy * cxy));
+                        double lambda1 = halfTrace + disc;
+                        double lambda2 = std::max(0.0, halfTrace - disc);
+                        vals[i] = (lambda1 > 0)?(1 - sqrt(lambda2 / lambda1)):0.0;
+                        break;
+                    }
+                    default:
+                    {
+                        double bboxArea = (((double)g.maxCol) - g.minCol + 1) * (((double)g.maxRow) - g.refRow + 1);
+                        vals[i] = g.n / bboxArea;
+                        break;
+                    }
+                }
+            }
+            this->writeColumn(attTable, boundaryCols[c], vals);
+        }
+    }
+
+    void RSGISClumpGeometry::writeColumn(GDALRasterAttributeTable *attTable, std::string colName, std::vector<double> &vals)
+    {
+        RSGISRasterAttUtils attUtils;
+        unsigned int colIdx = attUtils.findColumnIndexOrCreate(attTable, colName, GFT_Real);
+        if(attTable->ValuesIO(GF_Write, colIdx, 0, vals.size(), vals.data()) != CE_None)
+        {
+            throw RSGISAttributeTableException("Could not write column " + colName + " to the RAT.");
+        }
+    }
+
+    RSGISClumpGeometry::~RSGISClumpGeometry()
+    {
+
+    }
+
+}}
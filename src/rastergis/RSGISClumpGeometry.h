@@ -0,0 +1,207 @@
+/*
+ *  RSGISClumpGeometry.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISClumpGeometry_H
+#define RSGISClumpGeometry_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <unordered_map>
+#include <exception>
+#include <algorithm>
+#include <cstdlib>
+#include <stdint.h>
+#include <math.h>
+
+#include "gdal_priv.h"
+#include "gdal_rat.h"
+
+#include "common/RSGISAttributeTableException.h"
+#include "common/rsgis-tqdm.h"
+#include "common/RSGISParallel.h"
+
+#include "rastergis/RSGISRasterAttUtils.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_rastergis_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace rastergis{
+
+    /**
+     * The names of the columns written by RSGISClumpGeometry::writeToRAT;
+     * columns with an empty name are not written.
+     *
+     * The extents (minXColX etc.) are those of RSGISCalcClusterLocation, i.e.
+     * the coordinates of the corner of the left most, right most, bottom most
+     * and top most pixels. Perimeter is in pixel edges and the border length,
+     * as RSGISClumpBorders, is the number of left/right edges * x resolution
+     * plus up/down edges * y resolution. Axis lengths are in pixels and the
+     * orientation in degrees clockwise from the image x axis.
+     *
+     * The contour length is that of the boundary through the centres of the
+     * edge pixels (as traced by an 8 direction chain code, with the corners
+     * cut), so diagonal edges are not over estimated as they are by the
+     * perimeter in pixel edges. Boundary pixels are those with a 4 connected
+     * neighbour outside the clump. Circularity is 4 pi area / contour length^2,
+     * elongation is 1 - minor / major axis (0 for a disk, 1 for a line) and
+     * rectangularity is the proportion of the bounding box in the clump.
+     */
+    struct DllExport RSGISClumpGeometryCols
+    {
+        std::string pxlCountCol;
+        std::string eastCol;
+        std::string northCol;
+        std::string minXPxlCol;
+        std::string maxXPxlCol;
+        std::string minYPxlCol;
+        std::string maxYPxlCol;
+        std::string minXColX;
+        std::string minXColY;
+        std::string maxXColX;
+        std::string maxXColY;
+        std::string minYColX;
+        std::string minYColY;
+        std::string maxYColX;
+        std::string maxYColY;
+        std::string perimeterCol;
+        std::string borderLenCol;
+        bool borderIncludeZeroEdges;
+        std::string majorAxisCol;
+        std::string minorAxisCol;
+        std::string orientationCol;
+        std::string eccentricityCol;
+        std::string compactnessCol;
+        std::string contourLenCol;
+        std::string boundaryPxlsCol;
+        std::string circularityCol;
+        std::string elongationCol;
+        std::string rectangularityCol;
+    };
+
+    /**
+     * Calculates the geometry of every clump (pixel count, centroid, pixel
+     * and map extents, perimeter, border length and second moment shape
+     * descriptors) in a single pass over the clumps image.
+     *
+     * The image is read in strips of rows on the calling thread and each
+     * strip is split into fixed groups of rows, accumulated by the threads
+     * (RSGISLIB_NUM_THREADS or setNumThreads) of one pool. Each group holds
+     * only the clumps it contains and the groups are merged into the one
+     * accumulator per clump in image order, so the results (including the
+     * first found pixel of the extents) do not depend on the number of
+     * threads. The contour is only traced
+     * at the boundary pixels of each clump, so the boundary descriptors cost
+     * little more than the moments.
+     */
+    class DllExport RSGISClumpGeometry
+    {
+    public:
+        RSGISClumpGeometry();
+        /**
+         * Number of threads, 0 uses the number of cores.
+         */
+        void setNumThreads(unsigned int numThreads);
+        /**
+         * Accumulate the geometry of the clumps in band ratBand. The RAT is
+         * extended if the image has clump IDs beyond its last row.
+         */
+        void calcGeometry(GDALDataset *clumpsImage, unsigned int ratBand);
+        /**
+         * Write the chosen columns to the RAT of the band used for calcGeometry.
+         */
+        void writeToRAT(GDALDataset *clumpsImage, unsigned int ratBand, RSGISClumpGeometryCols *cols);
+        size_t getNumClumps() const {return geom.size();};
+        ~RSGISClumpGeometry();
+    protected:
+        /**
+         * Sums are relative to the first pixel found (refCol, refRow) to
+         * keep the precision of the second moments.
+         */
+        struct ClumpGeom
+        {
+            uint64_t n;
+            uint32_t refCol;
+            uint32_t refRow;
+            double sumX;
+            double sumY;
+            double sumXX;
+            double sumYY;
+            double sumXY;
+            uint32_t minCol;
+            uint32_t minColRow;
+            uint32_t maxCol;
+            uint32_t maxColRow;
+            uint32_t maxRow;
+            uint32_t maxRowCol;
+            uint32_t edgesLR;
+            uint32_t edgesUD;
+            uint32_t zeroEdgesLR;
+            uint32_t zeroEdgesUD;
+            uint32_t boundaryPxls;
+            double contourLen;
+        };
+        /**
+         * The clumps found in a group of rows, in the order they were found.
+         */
+        struct ClumpGeomGroup
+        {
+            std::vector<uint32_t> fids;
+            std::vector<ClumpGeom> geoms;
+            std::unordered_map<uint32_t, size_t> index;
+        };
+        static const size_t groupRows;
+        void initClumpGeom(ClumpGeom *g) const;
+        /**
+         * Accumulate rows [rowStart, rowEnd) of a strip (held with the rows
+         * above and below) into group.
+         */
+        void accumulateRows(const uint32_t *rows, size_t width, size_t rowStart, size_t rowEnd, size_t stripStart, ClumpGeomGroup *group);
+        /**
+         * Merge the geometry of pixels later in image order (other) into g.
+         */
+        void mergeClumpGeom(ClumpGeom *g, const ClumpGeom &other) const;
+        /**
+         * The length of the contour through the pixel centres within a 2x2 window
+         * given which of the top left, top right, bottom left and bottom right
+         * pixels are in the clump.
+         */
+        double windowContourLength(bool tl, bool tr, bool bl, bool br) const;
+        void writeColumn(GDALRasterAttributeTable *attTable, std::string colName, std::vector<double> &vals);
+        unsigned int numThreads;
+        double transform[6];
+        std::vector<ClumpGeom> geom;
+    };
+
+}}
+
+#endif
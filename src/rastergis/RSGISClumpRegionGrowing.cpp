@@ -53,24 +53,21 @@ namespace rsgis{namespace rastergis{
                 throw rsgis::RSGISAttributeTableException("RAT has no rows, i.e., it is empty!");
             }
             
+            // Columns are held by the cache so are not deleted with ratCols.
+            RSGISRATColumnCache ratColCache(rat);
             std::vector<double*> *ratCols = new std::vector<double*>();
             
             rsgis::rastergis::RSGISRATLogicXMLParse parseLogicXMLObj;
             std::vector<rsgis::rastergis::RSGISColumnLogicIdxs*> *colIdxes = new std::vector<rsgis::rastergis::RSGISColumnLogicIdxs*>();
             rsgis::math::RSGISLogicExpression* exp = parseLogicXMLObj.parseLogicXML(xmlBlock, colIdxes);
             
-            size_t colLenTmp = 0;
             for(std::vector<rsgis::rastergis::RSGISColumnLogicIdxs*>::iterator iterColIdx = colIdxes->begin(); iterColIdx != colIdxes->end(); ++iterColIdx)
             {
                 if((*iterColIdx)->useThreshold)
                 {
                     (*iterColIdx)->col1Idx = attUtils.findColumnIndex(rat, (*iterColIdx)->column1Name);
                     std::cout << (*iterColIdx)->column1Name << " = " << (*iterColIdx)->col1Idx << std::endl;
-                    ratCols->push_back(attUtils.readDoubleColumn(rat, (*iterColIdx)->column1Name, &colLenTmp));
-                    if(colLenTmp != numRows)
-                    {
-                        throw rsgis::RSGISAttributeTableException("The returned column array is not the same length as the RAT.");
-                    }
+                    ratCols->push_back(ratColCache.getRealColumn((*iterColIdx)->column1Name));
                     (*iterColIdx)->col1Idx = ratCols->size()-1;
                 }
                 else if((*iterColIdx)->singleCol)
@@ -81,23 +78,22 @@ namespace rsgis{namespace rastergis{
                 {
                     (*iterColIdx)->col1Idx = attUtils.findColumnIndex(rat, (*iterColIdx)->column1Name);
                     std::cout << (*iterColIdx)->column1Name << " = " << (*iterColIdx)->col1Idx << std::endl;
-                    ratCols->push_back(attUtils.readDoubleColumn(rat, (*iterColIdx)->column1Name, &colLenTmp));
-                    if(colLenTmp != numRows)
-                    {
-                        throw rsgis::RSGISAttributeTableException("The returned column array is not the same length as the RAT.");
-                    }
+                    ratCols->push_back(ratColCache.getRealColumn((*iterColIdx)->column1Name));
                     (*iterColIdx)->col1Idx = ratCols->size()-1;
                     (*iterColIdx)->col2Idx = attUtils.findColumnIndex(rat, (*iterColIdx)->column2Name);
                     std::cout << (*iterColIdx)->column2Name << " = " << (*iterColIdx)->col2Idx << std::endl;
-                    ratCols->push_back(attUtils.readDoubleColumn(rat, (*iterColIdx)->column2Name, &colLenTmp));
-                    if(colLenTmp != numRows)
-                    {
-                        throw rsgis::RSGISAttributeTableException("The returned column array is not the same length as the RAT.");
-                    }
+                    ratCols->push_back(ratColCache.getRealColumn((*iterColIdx)->column2Name));
                     (*iterColIdx)->col2Idx = ratCols->size()-1;
                 }
             }
             
+            // The criteria only depend on the neighbour's attributes, which do not change,
+            // so they are evaluated for every row once with the compiled expression. As
+            // with evaluating the tree, a NaN is only an error for a row which is tested.
+            std::vector<unsigned char> critMask(numRows, 0);
+            std::vector<unsigned char> critErrs(numRows, 0);
+            this->evaluateCriteria(exp, colIdxes, ratCols, numRows, critMask.data(), critErrs.data());
+            
             std::vector<std::vector<size_t>* > *neighbours = attUtils.getRATNeighbours(inputClumps, ratBand);
             
             if(numRows != neighbours->size())
@@ -111,25 +107,13 @@ namespace rsgis{namespace rastergis{
                 throw rsgis::RSGISAttributeTableException("RAT size is different to the number of neighbours retrieved.");
             }
             
-            size_t colLen = 0;
-            std::string *classColVals = attUtils.readStrColumnStdStr(rat, classColumn, &colLen);
-            std::string *classColValsTmp = new std::string[colLen];
+            std::string *classColVals = ratColCache.getStrColumn(classColumn);
+            std::string *classColValsTmp = new std::string[numRows];
             for(size_t i = 0; i < numRows; ++i)
             {
                 classColValsTmp[i] = "";
             }
             
-            if(colLen != numRows)
-            {
-                for(std::vector<std::vector<size_t>* >::iterator iterNeigh = neighbours->begin(); iterNeigh != neighbours->end(); ++iterNeigh)
-                {
-                    delete *iterNeigh;
-                }
-                delete neighbours;
-                delete[] classColVals;
-                throw rsgis::RSGISAttributeTableException("The column does not have enough values ");
-            }
-            
             bool changeFound = true;
             unsigned int numChangeFeats = 0;
             bool maxIterDef = false;
@@ -163,20 +147,11 @@ namespace rsgis{namespace rastergis{
                             if(classColVals[*iterNeigh] != classVal)
                             {
                                 // Check if condition is met, if met then 'grow' and set change flag...
-                                for(std::vector<rsgis::rastergis::RSGISColumnLogicIdxs*>::iterator iterColIdx = colIdxes->begin(); iterColIdx != colIdxes->end(); ++iterColIdx)
+                                if(critErrs[*iterNeigh])
                                 {
-                                    if((*iterColIdx)->useThreshold)
-                                    {
-                                        (*iterColIdx)->col1Val = ratCols->at((*iterColIdx)->col1Idx)[*iterNeigh];
-                                    }
-                                    else
-                                    {
-                                        (*iterColIdx)->col1Val = ratCols->at((*iterColIdx)->col1Idx)[*iterNeigh];
-                                        (*iterColIdx)->col2Val = ratCols->at((*iterColIdx)->col2Idx)[*iterNeigh];
-                                    }
+                                    throw rsgis::math::RSGISMathLogicException("A value within the logic expression is NaN.");
                                 }
-                                
-                                if(exp->evaluate())
+                                if(critMask[*iterNeigh])
                                 {
                                     classColValsTmp[*iterNeigh] = classVal;
                                     changeFound = true;
@@ -209,11 +184,11 @@ namespace rsgis{namespace rastergis{
             }
             std::cout << "Writing classification column\n";
             
-            attUtils.writeStrColumn(rat, classColumn, classColVals, colLen);
+            ratColCache.setColumnChanged(classColumn);
+            ratColCache.flush();
             
             std::cout << "Tidying up...\n";
             
-            delete[] classColVals;
             delete[] classColValsTmp;
             for(std::vector<std::vector<size_t>* >::iterator iterNeigh = neighbours->begin(); iterNeigh != neighbours->end(); ++iterNeigh)
             {
@@ -226,10 +201,6 @@ namespace rsgis{namespace rastergis{
             }
             delete colIdxes;
             delete exp;
-            for(std::vector<double*>::iterator iterCols = ratCols->begin(); iterCols != ratCols->end(); ++iterCols)
-            {
-                delete[] *iterCols;
-            }
             delete ratCols;
             std::cout << "Completed.\n";
         }
@@ -271,6 +242,8 @@ namespace rsgis{namespace rastergis{
                 throw rsgis::RSGISAttributeTableException("RAT has no rows, i.e., it is empty!");
             }
             
+            // Columns are held by the cache so are not deleted with ratCols.
+            RSGISRATColumnCache ratColCache(rat);
             std::vector<double*> *ratCols = new std::vector<double*>();
             
             rsgis::rastergis::RSGISRATLogicXMLParse parseLogicXMLObj;
@@ -280,18 +253,13 @@ namespace rsgis{namespace rastergis{
             std::vector<rsgis::rastergis::RSGISColumnLogicIdxs*> *colIdxesNeighExp = new std::vector<rsgis::rastergis::RSGISColumnLogicIdxs*>();
             rsgis::math::RSGISLogicExpression* expNeigh = parseLogicXMLObj.parseLogicXML(xmlBlockNeighCriteria, colIdxesNeighExp);
             
-            size_t colLenTmp = 0;
             for(std::vector<rsgis::rastergis::RSGISColumnLogicIdxs*>::iterator iterColIdx = colIdxesCritExp->begin(); iterColIdx != colIdxesCritExp->end(); ++iterColIdx)
             {
                 if((*iterColIdx)->useThreshold)
                 {
                     (*iterColIdx)->col1Idx = attUtils.findColumnIndex(rat, (*iterColIdx)->column1Name);
                     std::cout << (*iterColIdx)->column1Name << " = " << (*iterColIdx)->col1Idx << std::endl;
-                    ratCols->push_back(attUtils.readDoubleColumn(rat, (*iterColIdx)->column1Name, &colLenTmp));
-                    if(colLenTmp != numRows)
-                    {
-                        throw rsgis::RSGISAttributeTableException("The returned column array is not the same length as the RAT.");
-                    }
+                    ratCols->push_back(ratColCache.getRealColumn((*iterColIdx)->column1Name));
                     (*iterColIdx)->col1Idx = ratCols->size()-1;
                 }
                 else if((*iterColIdx)->singleCol)
@@ -302,24 +270,15 @@ namespace rsgis{namespace rastergis{
                 {
                     (*iterColIdx)->col1Idx = attUtils.findColumnIndex(rat, (*iterColIdx)->column1Name);
                     std::cout << (*iterColIdx)->column1Name << " = " << (*iterColIdx)->col1Idx << std::endl;
-                    ratCols->push_back(attUtils.readDoubleColumn(rat, (*iterColIdx)->column1Name, &colLenTmp));
-                    if(colLenTmp != numRows)
-                    {
-                        throw rsgis::RSGISAttributeTableException("The returned column array is not the same length as the RAT.");
-                    }
+                    ratCols->push_back(ratColCache.getRealColumn((*iterColIdx)->column1Name));
                     (*iterColIdx)->col1Idx = ratCols->size()-1;
                     (*iterColIdx)->col2Idx = attUtils.findColumnIndex(rat, (*iterColIdx)->column2Name);
                     std::cout << (*iterColIdx)->column2Name << " = " << (*iterColIdx)->col2Idx << std::endl;
-                    ratCols->push_back(attUtils.readDoubleColumn(rat, (*iterColIdx)->column2Name, &colLenTmp));
-                    if(colLenTmp != numRows)
-                    {
-                        throw rsgis::RSGISAttributeTableException("The returned column array is not the same length as the RAT.");
-                    }
+                    ratCols->push_back(ratColCache.getRealColumn((*iterColIdx)->column2Name));
                     (*iterColIdx)->col2Idx = ratCols->size()-1;
                 }
             }
             
-            colLenTmp = 0;
             for(std::vector<rsgis::rastergis::RSGISColumnLogicIdxs*>::iterator iterColIdx = colIdxesNeighExp->begin(); iterColIdx != colIdxesNeighExp->end(); ++iterColIdx)
             {
                 if((*iterColIdx)->useThreshold)
@@ -330,11 +289,7 @@ namespace rsgis{namespace rastergis{
                 {
                     (*iterColIdx)->col1Idx = attUtils.findColumnIndex(rat, (*iterColIdx)->column1Name);
                     std::cout << (*iterColIdx)->column1Name << " = " << (*iterColIdx)->col1Idx << std::endl;
-                    ratCols->push_back(attUtils.readDoubleColumn(rat, (*iterColIdx)->column1Name, &colLenTmp));
-                    if(colLenTmp != numRows)
-                    {
-                        throw rsgis::RSGISAttributeTableException("The returned column array is not the same length as the RAT.");
-                    }
+                    ratCols->push_back(ratColCache.getRealColumn((*iterColIdx)->column1Name));
                     (*iterColIdx)->col1Idx = ratCols->size()-1;
                 }
                 else
@@ -343,6 +298,27 @@ namespace rsgis{namespace rastergis{
                 }
             }
             
+            // The criteria only depend on the neighbour's attributes so are evaluated once for all rows.
+            std::vector<unsigned char> critMask(numRows, 0);
+            std::vector<unsigned char> critErrs(numRows, 0);
+            this->evaluateCriteria(expCrit, colIdxesCritExp, ratCols, numRows, critMask.data(), critErrs.data());
+            
+            // The neighbour criteria compare a clump (col2Val) with its neighbour (col1Val); the values
+            // for a chunk of clump-neighbour pairs are gathered so the compiled expression can be
+            // evaluated over the chunk.
+            size_t pairChunkSize = 4096;
+            rsgis::math::RSGISLogicProgram neighLogicProg(expNeigh, pairChunkSize);
+            std::vector<std::vector<double> > neighVals(colIdxesNeighExp->size(), std::vector<double>(pairChunkSize));
+            std::vector<std::vector<double> > clumpVals(colIdxesNeighExp->size(), std::vector<double>(pairChunkSize));
+            for(size_t n = 0; n < colIdxesNeighExp->size(); ++n)
+            {
+                neighLogicProg.bindValues(&colIdxesNeighExp->at(n)->col1Val, neighVals.at(n).data());
+                neighLogicProg.bindValues(&colIdxesNeighExp->at(n)->col2Val, clumpVals.at(n).data());
+            }
+            std::vector<size_t> pairClumps;
+            std::vector<size_t> pairNeighs;
+            std::vector<unsigned char> pairMask;
+            std::vector<unsigned char> pairErrs;
             
             std::vector<std::vector<size_t>* > *neighbours = attUtils.getRATNeighbours(inputClumps, ratBand);
             
@@ -357,25 +333,13 @@ namespace rsgis{namespace rastergis{
                 throw rsgis::RSGISAttributeTableException("RAT size is different to the number of neighbours retrieved.");
             }
             
-            size_t colLen = 0;
-            std::string *classColVals = attUtils.readStrColumnStdStr(rat, classColumn, &colLen);
-            std::string *classColValsTmp = new std::string[colLen];
+            std::string *classColVals = ratColCache.getStrColumn(classColumn);
+            std::string *classColValsTmp = new std::string[numRows];
             for(size_t i = 0; i < numRows; ++i)
             {
                 classColValsTmp[i] = "";
             }
             
-            if(colLen != numRows)
-            {
-                for(std::vector<std::vector<size_t>* >::iterator iterNeigh = neighbours->begin(); iterNeigh != neighbours->end(); ++iterNeigh)
-                {
-                    delete *iterNeigh;
-                }
-                delete neighbours;
-                delete[] classColVals;
-                throw rsgis::RSGISAttributeTableException("The column does not have enough values ");
-            }
-            
             bool changeFound = true;
             unsigned int numChangeFeats = 0;
             bool maxIterDef = false;
@@ -392,6 +356,8 @@ namespace rsgis{namespace rastergis{
                 std::cout << "Started " << std::flush;
                 feedbackCounter = 0;
                 numChangeFeats = 0;
+                pairClumps.clear();
+                pairNeighs.clear();
                 for(size_t i = 0; i < numRows; ++i)
                 {
                     if((feedback != 0) && ((i % feedback) == 0))
@@ -408,47 +374,45 @@ namespace rsgis{namespace rastergis{
                         {
                             if(classColVals[*iterNeigh] != classVal)
                             {
-                                // ALSO NEEDS TO MEET THE SECOND CRITERIA COMPARING CURRENT OBJECT TO NEIGHBOUR...
-                                for(std::vector<rsgis::rastergis::RSGISColumnLogicIdxs*>::iterator iterColIdx = colIdxesNeighExp->begin(); iterColIdx != colIdxesNeighExp->end(); ++iterColIdx)
-                                {
-                                    if(((*iterColIdx)->singleCol) & (!(*iterColIdx)->thresholdVal))
-                                    {
-                                        (*iterColIdx)->col1Val = ratCols->at((*iterColIdx)->col1Idx)[*iterNeigh];
-                                        (*iterColIdx)->col2Val = ratCols->at((*iterColIdx)->col1Idx)[i];
-                                    }
-                                    else
-                                    {
-                                        throw rsgis::RSGISAttributeTableException("Could not populate expression values as only single columns without threshold supported for neighbours");
-                                    }
-                                }
-                                
-                                if(expNeigh->evaluate())
-                                {
-                                    // Check if condition is met, if met then 'grow' and set change flag...
-                                    for(std::vector<rsgis::rastergis::RSGISColumnLogicIdxs*>::iterator iterColIdx = colIdxesCritExp->begin(); iterColIdx != colIdxesCritExp->end(); ++iterColIdx)
-                                    {
-                                        if((*iterColIdx)->useThreshold)
-                                        {
-                                            (*iterColIdx)->col1Val = ratCols->at((*iterColIdx)->col1Idx)[*iterNeigh];
-                                        }
-                                        else
-                                        {
-                                            (*iterColIdx)->col1Val = ratCols->at((*iterColIdx)->col1Idx)[*iterNeigh];
-                                            (*iterColIdx)->col2Val = ratCols->at((*iterColIdx)->col2Idx)[*iterNeigh];
-                                        }
-                                    }
-                                    
-                                    if(expCrit->evaluate())
-                                    {
-                                        classColValsTmp[*iterNeigh] = classVal;
-                                        changeFound = true;
-                                        ++numChangeFeats;
-                                    }
-                                }
+                                pairClumps.push_back(i);
+                                pairNeighs.push_back(*iterNeigh);
                             }
                         }
                     }
                 }
+                
+                // Evaluate the neighbour criteria comparing each clump to its neighbour.
+                pairMask.assign(pairClumps.size(), 0);
+                pairErrs.assign(pairClumps.size(), 0);
+                for(size_t chunkStart = 0; chunkStart < pairClumps.size(); chunkStart += pairChunkSize)
+                {
+                    size_t numPairs = std::min(pairChunkSize, pairClumps.size() - chunkStart);
+                    for(size_t n = 0; n < colIdxesNeighExp->size(); ++n)
+                    {
+                        double *colVals = ratCols->at(colIdxesNeighExp->at(n)->col1Idx);
+                        for(size_t k = 0; k < numPairs; ++k)
+                        {
+                            neighVals.at(n)[k] = colVals[pairNeighs[chunkStart+k]];
+                            clumpVals.at(n)[k] = colVals[pairClumps[chunkStart+k]];
+                        }
+                    }
+                    neighLogicProg.evaluate(0, numPairs, &pairMask[chunkStart], &pairErrs[chunkStart]);
+                }
+                
+                for(size_t p = 0; p < pairClumps.size(); ++p)
+                {
+                    if(pairErrs[p] || (pairMask[p] && critErrs[pairNeighs[p]]))
+                    {
+                        throw rsgis::math::RSGISMathLogicException("A value within the logic expression is NaN.");
+                    }
+                    // Check if condition is met, if met then 'grow' and set change flag...
+                    if(pairMask[p] && critMask[pairNeighs[p]])
+                    {
+                        classColValsTmp[pairNeighs[p]] = classVal;
+                        changeFound = true;
+                        ++numChangeFeats;
+                    }
+                }
                 std::cout << ".Completed\n";
                 std::cout << "Iteration " << numIter << " changed " << numChangeFeats << " features\n";
                 
@@ -472,11 +436,11 @@ namespace rsgis{namespace rastergis{
             }
             std::cout << "Writing classification column\n";
             
-            attUtils.writeStrColumn(rat, classColumn, classColVals, colLen);
+            ratColCache.setColumnChanged(classColumn);
+            ratColCache.flush();
             
             std::cout << "Tidying up...\n";
             
-            delete[] classColVals;
             delete[] classColValsTmp;
             for(std::vector<std::vector<size_t>* >::iterator iterNeigh = neighbours->begin(); iterNeigh != neighbours->end(); ++iterNeigh)
             {
@@ -495,10 +459,6 @@ namespace rsgis{namespace rastergis{
             }
             delete colIdxesNeighExp;
             delete expNeigh;
-            for(std::vector<double*>::iterator iterCols = ratCols->begin(); iterCols != ratCols->end(); ++iterCols)
-            {
-                delete[] *iterCols;
-            }
             delete ratCols;
             std::cout << "Completed.\n";
         }
@@ -516,6 +476,20 @@ namespace rsgis{namespace rastergis{
         }
     }
     
+    void RSGISClumpRegionGrowing::evaluateCriteria(rsgis::math::RSGISLogicExpression *exp, std::vector<rsgis::rastergis::RSGISColumnLogicIdxs*> *colIdxes, std::vector<double*> *ratCols, size_t numRows, unsigned char *critMask, unsigned char *critErrs)
+    {
+        rsgis::math::RSGISLogicProgram logicProg(exp);
+        for(std::vector<rsgis::rastergis::RSGISColumnLogicIdxs*>::iterator iterColIdx = colIdxes->begin(); iterColIdx != colIdxes->end(); ++iterColIdx)
+        {
+            logicProg.bindValues(&(*iterColIdx)->col1Val, ratCols->at((*iterColIdx)->col1Idx));
+            if(!(*iterColIdx)->useThreshold)
+            {
+                logicProg.bindValues(&(*iterColIdx)->col2Val, ratCols->at((*iterColIdx)->col2Idx));
+            }
+        }
+        logicProg.evaluate(0, numRows, critMask, critErrs);
+    }
+    
     RSGISClumpRegionGrowing::~RSGISClumpRegionGrowing()
     {
         
@@ -25,6 +25,7 @@
 
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <math.h>
 
 #include "gdal_priv.h"
@@ -37,6 +38,7 @@
 #include "math/RSGISLogicExpEvaluation.h"
 
 #include "rastergis/RSGISRasterAttUtils.h"
+#include "rastergis/RSGISRATColumnCache.h"
 #include "rastergis/RSGISBinaryClassifyClumps.h"
 
 // mark all exported classes/functions with DllExport to have
@@ -61,6 +63,13 @@ namespace rsgis{namespace rastergis{
         void growClassRegion(GDALDataset *inputClumps, std::string classColumn, std::string classVal, int maxIter, unsigned int ratBand, std::string xmlBlock);
         void growClassRegionNeighCriteria(GDALDataset *inputClumps, std::string classColumn, std::string classVal, int maxIter, unsigned int ratBand, std::string xmlBlockCriteria, std::string xmlBlockNeighCriteria);
         ~RSGISClumpRegionGrowing();
+    protected:
+        /**
+         * Evaluate a criteria expression for all rows with the compiled logic
+         * evaluator, giving a mask of the rows meeting it and of the rows for
+         * which it could not be evaluated (NaN values).
+         */
+        void evaluateCriteria(rsgis::math::RSGISLogicExpression *exp, std::vector<rsgis::rastergis::RSGISColumnLogicIdxs*> *colIdxes, std::vector<double*> *ratCols, size_t numRows, unsigned char *critMask, unsigned char *critErrs);
     };
     
 }}
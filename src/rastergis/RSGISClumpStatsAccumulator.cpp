@@ -0,0 +1,252 @@
+/*
+ *  RSGISClumpStatsAccumulator.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISClumpStatsAccumulator.h"
+
+namespace rsgis{namespace rastergis{
+
+    RSGISClumpStatsAccumulator::RSGISClumpStatsAccumulator(unsigned int numBands, const std::vector<bool> &calcSum, const std::vector<bool> &calcM2, const std::vector<bool> &calcMin, const std::vector<bool> &calcMax)
+    {
+        this->numBands = numBands;
+        this->calcSum = calcSum;
+        this->calcM2 = calcM2;
+        this->calcMin = calcMin;
+        this->calcMax = calcMax;
+
+        // Per band the layout is: count, [sum, [m2]], [min], [max], [sum compensation, [m2 compensation]]
+        this->stride = 0;
+        for(unsigned int b = 0; b < numBands; ++b)
+        {
+            if(this->calcM2[b])
+            {
+                this->calcSum[b] = true;
+            }
+            this->bandOffsets.push_back(this->stride);
+            unsigned int bandStride = 1;
+            if(this->calcSum[b])
+            {
+                bandStride += this->calcM2[b]?2:1;
+            }
+            if(this->calcMin[b])
+            {
+                bandStride += 1;
+            }
+            if(this->calcMax[b])
+            {
+                bandStride += 1;
+            }
+            this->compOffsets.push_back(bandStride);
+            if(this->calcSum[b])
+            {
+                bandStride += this->calcM2[b]?2:1;
+            }
+            this->stride += bandStride;
+        }
+        this->startFID = 0;
+        this->numFIDs = 0;
+    }
+
+    void RSGISClumpStatsAccumulator::growRange(size_t fid)
+    {
+        size_t newStart = fid;
+        size_t newNum = 1024;
+        if(this->numFIDs > 0)
+        {
+            size_t endFID = this->startFID + this->numFIDs;
+            newStart = this->startFID;
+            size_t newEnd = endFID;
+            if(fid < this->startFID)
+            {
+                // Grow by at least the current size to keep reallocations rare.
+                newStart = (this->startFID > this->numFIDs)?(this->startFID - this->numFIDs):0;
+                if(fid < newStart)
+                {
+                    newStart = fid;
+                }
+            }
+            else
+            {
+                newEnd = this->startFID + (2 * this->numFIDs);
+                if(newEnd <= fid)
+                {
+                    newEnd = fid + 1;
+                }
+            }
+            newNum = newEnd - newStart;
+        }
+
+        std::vector<double> newVals(newNum * this->stride, 0.0);
+        if(this->numFIDs > 0)
+        {
+            std::copy(this->vals.begin(), this->vals.end(), newVals.begin() + ((this->startFID - newStart) * this->stride));
+        }
+        this->vals.swap(newVals);
+        this->startFID = newStart;
+        this->numFIDs = newNum;
+    }
+
+    const double* RSGISClumpStatsAccumulator::findClumpVals(size_t fid) const
+    {
+        if((this->numFIDs == 0) || (fid < this->startFID) || (fid >= (this->startFID+this->numFIDs)))
+        {
+            return NULL;
+        }
+        return &this->vals[(fid-this->startFID)*this->stride];
+    }
+
+    void RSGISClumpStatsAccumulator::merge(const RSGISClumpStatsAccumulator &other)
+    {
+        for(size_t i = 0; i < other.numFIDs; ++i)
+        {
+            const double *oVals = &other.vals[i*other.stride];
+            bool hasVals = false;
+            for(unsigned int b = 0; b < this->numBands; ++b)
+            {
+                if(oVals[this->bandOffsets[b]] > 0)
+                {
+                    hasVals = true;
+                    break;
+                }
+            }
+            if(!hasVals)
+            {
+                continue;
+            }
+
+            double *tVals = this->getClumpVals(other.startFID + i);
+            for(unsigned int b = 0; b < this->numBands; ++b)
+            {
+                const double *o = oVals + this->bandOffsets[b];
+                double *t = tVals + this->bandOffsets[b];
+                double nB = o[0];
+                if(nB == 0)
+                {
+                    continue;
+                }
+                double nA = t[0];
+                if(nA == 0)
+                {
+                    for(unsigned int k = this->bandOffsets[b]; k < ((b+1 < this->numBands)?this->bandOffsets[b+1]:this->stride); ++k)
+                    {
+                        tVals[k] = oVals[k];
+                    }
+                    continue;
+                }
+
+                double n = nA + nB;
+                t[0] = n;
+                unsigned int idx = 1;
+                if(this->calcSum[b])
+                {
+                    const double *oComp = o + this->compOffsets[b];
+                    double *tComp = t + this->compOffsets[b];
+                    if(this->calcM2[b])
+                    {
+                        double delta = ((o[idx] + oComp[0])/nB) - ((t[idx] + tComp[0])/nA);
+                        rsgis::RSGISCompensatedSum::add(t[idx+1], tComp[1], o[idx+1]);
+                        rsgis::RSGISCompensatedSum::add(t[idx+1], tComp[1], delta * delta * nA * nB / n);
+                        tComp[1] += oComp[1];
+                    }
+                    rsgis::RSGISCompensatedSum::add(t[idx], tComp[0], o[idx]);
+                    tComp[0] += oComp[0];
+                    idx += this->calcM2[b]?2:1;
+                }
+                if(this->calcMin[b])
+                {
+                    if(o[idx] < t[idx])
+                    {
+                        t[idx] = o[idx];
+                    }
+                    ++idx;
+                }
+                if(this->calcMax[b])
+                {
+                    if(o[idx] > t[idx])
+                    {
+                        t[idx] = o[idx];
+                    }
+                }
+            }
+        }
+    }
+
+    double RSGISClumpStatsAccumulator::getCount(size_t fid, unsigned int band) const
+    {
+        const double *v = this->findClumpVals(fid);
+        return (v == NULL)?0.0:v[this->bandOffsets[band]];
+    }
+
+    double RSGISClumpStatsAccumulator::getSum(size_t fid, unsigned int band) const
+    {
+        const double *v = this->findClumpVals(fid);
+        if((v == NULL) || (!this->calcSum[band]))
+        {
+            return 0.0;
+        }
+        return v[this->bandOffsets[band]+1] + v[this->bandOffsets[band]+this->compOffsets[band]];
+    }
+
+    double RSGISClumpStatsAccumulator::getM2(size_t fid, unsigned int band) const
+    {
+        const double *v = this->findClumpVals(fid);
+        if((v == NULL) || (!this->calcM2[band]))
+        {
+            return 0.0;
+        }
+        return v[this->bandOffsets[band]+2] + v[this->bandOffsets[band]+this->compOffsets[band]+1];
+    }
+
+    double RSGISClumpStatsAccumulator::getMin(size_t fid, unsigned int band) const
+    {
+        const double *v = this->findClumpVals(fid);
+        if((v == NULL) || (!this->calcMin[band]))
+        {
+            return 0.0;
+        }
+        unsigned int idx = 1;
+        if(this->calcSum[band])
+        {
+            idx += this->calcM2[band]?2:1;
+        }
+        return v[this->bandOffsets[band]+idx];
+    }
+
+    double RSGISClumpStatsAccumulator::getMax(size_t fid, unsigned int band) const
+    {
+        const double *v = this->findClumpVals(fid);
+        if((v == NULL) || (!this->calcMax[band]))
+        {
+            return 0.0;
+        }
+        unsigned int idx = 1;
+        if(this->calcSum[band])
+        {
+            idx += this->calcM2[band]?2:1;
+        }
+        if(this->calcMin[band])
+        {
+            idx += 1;
+        }
+        return v[this->bandOffsets[band]+idx];
+    }
+
+}}
+
@@ -0,0 +1,144 @@
+/*
+ *  RSGISClumpStatsAccumulator.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISClumpStatsAccumulator_H
+#define RSGISClumpStatsAccumulator_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+#include "common/RSGISReduction.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_rastergis_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace rastergis{
+
+    /**
+     * Accumulates the count, sum, sum of squared differences (Welford), min and
+     * max of a number of bands for each clump in a single pass. Values are held
+     * for a contiguous range of clump IDs which grows as new IDs are seen, so an
+     * accumulator for a strip of a clumps image only holds the clumps within it.
+     * Partial accumulators can be merged (Chan et al.) into a final result.
+     * The sums and sums of squared differences are compensated
+     * (rsgis::RSGISCompensatedSum).
+     */
+    class DllExport RSGISClumpStatsAccumulator
+    {
+    public:
+        /**
+         * numBands is the number of bands accumulated; calcSum, calcM2, calcMin
+         * and calcMax select which values are stored for each of them.
+         */
+        RSGISClumpStatsAccumulator(unsigned int numBands, const std::vector<bool> &calcSum, const std::vector<bool> &calcM2, const std::vector<bool> &calcMin, const std::vector<bool> &calcMax);
+        inline void addValue(size_t fid, unsigned int band, double val)
+        {
+            double *v = this->getClumpVals(fid) + bandOffsets[band];
+            double n = v[0] + 1;
+            v[0] = n;
+            unsigned int idx = 1;
+            if(calcSum[band])
+            {
+                double *comp = v + compOffsets[band];
+                if(calcM2[band])
+                {
+                    double meanOld = (n > 1)?((v[idx] + comp[0])/(n-1)):0.0;
+                    double delta = val - meanOld;
+                    rsgis::RSGISCompensatedSum::add(v[idx], comp[0], val);
+                    rsgis::RSGISCompensatedSum::add(v[idx+1], comp[1], delta * (val - ((v[idx] + comp[0])/n)));
+                    ++idx;
+                }
+                else
+                {
+                    rsgis::RSGISCompensatedSum::add(v[idx], comp[0], val);
+                }
+                ++idx;
+            }
+            if(calcMin[band])
+            {
+                if((n == 1) || (val < v[idx]))
+                {
+                    v[idx] = val;
+                }
+                ++idx;
+            }
+            if(calcMax[band])
+            {
+                if((n == 1) || (val > v[idx]))
+                {
+                    v[idx] = val;
+                }
+            }
+        };
+        /**
+         * Add the values of other into this accumulator.
+         */
+        void merge(const RSGISClumpStatsAccumulator &other);
+        double getCount(size_t fid, unsigned int band) const;
+        double getSum(size_t fid, unsigned int band) const;
+        /**
+         * Sum of squared differences from the mean of the accumulated values.
+         */
+        double getM2(size_t fid, unsigned int band) const;
+        double getMin(size_t fid, unsigned int band) const;
+        double getMax(size_t fid, unsigned int band) const;
+        ~RSGISClumpStatsAccumulator(){};
+    protected:
+        double* getClumpVals(size_t fid)
+        {
+            if((numFIDs == 0) || (fid < startFID) || (fid >= (startFID+numFIDs)))
+            {
+                this->growRange(fid);
+            }
+            return &vals[(fid-startFID)*stride];
+        };
+        const double* findClumpVals(size_t fid) const;
+        void growRange(size_t fid);
+        unsigned int numBands;
+        std::vector<bool> calcSum;
+        std::vector<bool> calcM2;
+        std::vector<bool> calcMin;
+        std::vector<bool> calcMax;
+        std::vector<unsigned int> bandOffsets;
+        std::vector<unsigned int> compOffsets;
+        unsigned int stride;
+        size_t startFID;
+        size_t numFIDs;
+        std::vector<double> vals;
+    };
+
+}}
+
+#endif
+
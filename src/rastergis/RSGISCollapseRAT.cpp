@@ -60,12 +60,20 @@ namespace rsgis{namespace rastergis{
             
             size_t outAttRowCount = fidCount;
             
-            rsgis::img::RSGISCalcImageValue *collapseGenNewImg = new RSGISCollapseRATPopNewImage(collapsedIDs, numRows, ratBand);
-            rsgis::img::RSGISCalcImage imgCalc = rsgis::img::RSGISCalcImage(collapseGenNewImg);
-            imgCalc.calcImage(&inputClumps, 1, 0, outImage, false, NULL, gdalFormat, GDT_UInt32);
-            delete collapseGenNewImg;
+            double *collapsedLUT = new double[numRows];
+            for(size_t i = 0; i < numRows; ++i)
+            {
+                collapsedLUT[i] = collapsedIDs[i];
+            }
             delete[] collapsedIDs;
             
+            rsgis::img::RSGISImageUtils imgUtils;
+            GDALDataset *collapsedDS = imgUtils.createCopy(inputClumps, 1, outImage, gdalFormat, GDT_UInt32);
+            RSGISRATLUTImage lutImage;
+            lutImage.populateImage(inputClumps, ratBand, std::vector<double*>(1, collapsedLUT), numRows, collapsedDS, true);
+            GDALClose(collapsedDS);
+            delete[] collapsedLUT;
+            
             GDALDataset *outClumpsDataset = (GDALDataset *) GDALOpenShared(outImage.c_str(), GA_Update);
             if(outClumpsDataset == NULL)
             {
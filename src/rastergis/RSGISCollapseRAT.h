@@ -34,6 +34,7 @@
 
 #include "rastergis/RSGISRasterAttUtils.h"
 #include "rastergis/RSGISCalcImageStatsAndPyramids.h"
+#include "rastergis/RSGISExportColumns2Image.h"
 
 #include "img/RSGISImageUtils.h"
 #include "img/RSGISImageCalcException.h"
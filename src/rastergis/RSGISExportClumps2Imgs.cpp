@@ -27,7 +27,13 @@ namespace rsgis{namespace rastergis{
     
     RSGISExportClumps2Images::RSGISExportClumps2Images()
     {
-        
+        this->numThreads = rsgis::utils::getNumThreads();
+        this->stripRows = 256;
+    }
+    
+    void RSGISExportClumps2Images::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
     }
     
     void RSGISExportClumps2Images::exportClumps2Images(GDALDataset *clumpsDataset, std::string outImgBase, std::string imgFileExt, std::string imageFormat, bool binaryOut, std::string minXPxl, std::string maxXPxl, std::string minYPxl, std::string maxYPxl, std::string tlX, std::string tlY, unsigned int ratBand)
@@ -60,55 +66,163 @@ namespace rsgis{namespace rastergis{
 
             std::cout << "Res: [" << geoTransform[1] << ", " << geoTransform[5] << "]\n";
             
-            unsigned int xSize = 0;
-            unsigned int ySize = 0;
-            double *outTransform = new double[6];
-            outTransform[0] = 0.0; // X Origin.
-            outTransform[1] = geoTransform[1];
-            outTransform[2] = geoTransform[2];
-            outTransform[3] = 0.0; // Y Origin.
-            outTransform[4] = geoTransform[4];
-            outTransform[5] = geoTransform[5];
+            long imgXSize = clumpsDataset->GetRasterXSize();
+            long imgYSize = clumpsDataset->GetRasterYSize();
+            std::string projRef = clumpsDataset->GetProjectionRef();
             
-            GDALDataset *outClumpImg = NULL;
-            GDALDataset **datasets = new GDALDataset*[2];
-            datasets[0] = clumpsDataset;
-            RSGISPopulateWithImageStats addClrTab;
-            RSGISCopyImageBand4ClumpExport valueCalc = RSGISCopyImageBand4ClumpExport(ratBand, 0, binaryOut);
-            rsgis::img::RSGISCalcImage calcImage = rsgis::img::RSGISCalcImage(&valueCalc);
-            rsgis::img::RSGISImageUtils imgUtils;
-            rsgis::utils::RSGISTextUtils textUtils;
+            // The bounding box of each clump (from the RAT) gives the rows of the
+            // clumps image it needs; clumps are ordered by their first row so a
+            // single pass down the image in strips fills the chips overlapping each
+            // strip, and each chip is written once the pass has moved below it.
+            struct ClumpChip
+            {
+                size_t fid;
+                long minX;
+                long minY;
+                long maxY;
+                long xSize;
+                long ySize;
+                std::vector<unsigned int> data;
+            };
+            std::vector<ClumpChip*> chips;
             for(size_t i = 1; i < numRows; ++i)
             {
                 if( (maxXPxlVals->at(i) > 0) | (maxYPxlVals->at(i) > 0) )
                 {
-                    std::string outImgFileName = outImgBase + "C" + textUtils.sizettostring(i) + "." + imgFileExt;
+                    ClumpChip *chip = new ClumpChip();
+                    chip->fid = i;
+                    chip->minX = std::max(minXPxlVals->at(i), 0);
+                    chip->minY = std::max(minYPxlVals->at(i), 0);
+                    chip->maxY = std::min((long)maxYPxlVals->at(i), imgYSize-1);
+                    chip->xSize = (maxXPxlVals->at(i) - minXPxlVals->at(i)) + 1;
+                    chip->ySize = (maxYPxlVals->at(i) - minYPxlVals->at(i)) + 1;
+                    chips.push_back(chip);
+                }
+            }
+            std::stable_sort(chips.begin(), chips.end(), [](const ClumpChip *a, const ClumpChip *b){return a->minY < b->minY;});
+            std::cout << "Exporting " << chips.size() << " clumps\n";
+            
+            std::mutex printMutex;
+            auto writeChip = [&](ClumpChip *chip)
+            {
+                rsgis::img::RSGISImageUtils imgUtils;
+                rsgis::utils::RSGISTextUtils textUtils;
+                RSGISPopulateWithImageStats addClrTab;
+                std::string outImgFileName = outImgBase + "C" + textUtils.sizettostring(chip->fid) + "." + imgFileExt;
+                {
+                    std::lock_guard<std::mutex> lock(printMutex);
                     std::cout << "Output Img: " << outImgFileName << std::endl;
-                    
-                    xSize = (maxXPxlVals->at(i) - minXPxlVals->at(i)) + 1;
-                    ySize = (maxYPxlVals->at(i) - minYPxlVals->at(i)) + 1;
-                    
-                    std::cout << "Size: [" << xSize << ", " << ySize << "]\n";
-                    std::cout << "TL: [" << tlXVals->at(i) << ", " << tlYVals->at(i) << "]\n";
-                    
-                    outTransform[0] = tlXVals->at(i);
-                    outTransform[3] = tlYVals->at(i);
-                    
-                    outClumpImg = imgUtils.createBlankImage(outImgFileName, outTransform, xSize, ySize, 1, "", 0.0, imageFormat, GDT_UInt32);
-                    outClumpImg->SetProjection(clumpsDataset->GetProjectionRef());
-                    GDALClose(outClumpImg);
-                    
-                    valueCalc.setFid(i);
-                    outClumpImg = (GDALDataset *) GDALOpen(outImgFileName.c_str(), GA_Update);
-                    datasets[1] = outClumpImg;
-                    calcImage.calcImage(datasets, 2, 0, outClumpImg);
-                    addClrTab.populateImageWithRasterGISStats(outClumpImg, true, true, 1);
+                    std::cout << "Size: [" << chip->xSize << ", " << chip->ySize << "]\n";
+                    std::cout << "TL: [" << tlXVals->at(chip->fid) << ", " << tlYVals->at(chip->fid) << "]\n";
+                }
+                
+                double outTransform[6];
+                outTransform[0] = tlXVals->at(chip->fid); // X Origin.
+                outTransform[1] = geoTransform[1];
+                outTransform[2] = geoTransform[2];
+                outTransform[3] = tlYVals->at(chip->fid); // Y Origin.
+                outTransform[4] = geoTransform[4];
+                outTransform[5] = geoTransform[5];
+                
+                GDALDataset *outClumpImg = imgUtils.createBlankImage(outImgFileName, outTransform, chip->xSize, chip->ySize, 1, "", 0.0, imageFormat, GDT_UInt32);
+                if(outClumpImg == NULL)
+                {
+                    throw rsgis::RSGISImageException("Could not create image " + outImgFileName);
+                }
+                outClumpImg->SetProjection(projRef.c_str());
+                if(outClumpImg->GetRasterBand(1)->RasterIO(GF_Write, 0, 0, chip->xSize, chip->ySize, chip->data.data(), chip->xSize, chip->ySize, GDT_UInt32, 0, 0) != CE_None)
+                {
                     GDALClose(outClumpImg);
-                    
+                    throw rsgis::RSGISImageException("Could not write image " + outImgFileName);
                 }
+                addClrTab.populateImageWithRasterGISStats(outClumpImg, true, true, 1);
+                GDALClose(outClumpImg);
+                
+                std::vector<unsigned int>().swap(chip->data);
+            };
+            
+            GDALRasterBand *clumpsBand = clumpsDataset->GetRasterBand(ratBand);
+            std::vector<unsigned int> stripData(this->stripRows * imgXSize);
+            std::vector<ClumpChip*> activeChips;
+            std::vector<ClumpChip*> finishedChips;
+            size_t nextChip = 0;
+            rsgis::utils::RSGISWorkerPool pool(this->numThreads);
+            for(long stripY = 0; (stripY < imgYSize) && ((nextChip < chips.size()) || (!activeChips.empty())); stripY += this->stripRows)
+            {
+                long stripHeight = std::min((long)this->stripRows, imgYSize - stripY);
+                long stripEnd = stripY + stripHeight - 1;
+                
+                while((nextChip < chips.size()) && (chips.at(nextChip)->minY <= stripEnd))
+                {
+                    chips.at(nextChip)->data.assign(chips.at(nextChip)->xSize * chips.at(nextChip)->ySize, 0);
+                    activeChips.push_back(chips.at(nextChip));
+                    ++nextChip;
+                }
+                if(activeChips.empty())
+                {
+                    continue;
+                }
+                
+                if(clumpsBand->RasterIO(GF_Read, 0, stripY, imgXSize, stripHeight, stripData.data(), imgXSize, stripHeight, GDT_UInt32, 0, 0) != CE_None)
+                {
+                    throw rsgis::RSGISImageException("Could not read the clumps image.");
+                }
+                
+                // Scatter the strip into the chips which overlap it.
+                pool.parallelFor(activeChips.size(), [&](size_t n, unsigned int)
+                {
+                    ClumpChip *chip = activeChips.at(n);
+                    long rowStart = std::max(stripY, chip->minY);
+                    long rowEnd = std::min(stripEnd, chip->maxY);
+                    long colEnd = std::min(chip->minX + chip->xSize, imgXSize);
+                    unsigned int fidVal = chip->fid;
+                    unsigned int outVal = binaryOut?1:fidVal;
+                    for(long y = rowStart; y <= rowEnd; ++y)
+                    {
+                        const unsigned int *inRow = &stripData[(y - stripY) * imgXSize];
+                        unsigned int *outRow = &chip->data[(y - chip->minY) * chip->xSize];
+                        for(long x = chip->minX; x < colEnd; ++x)
+                        {
+                            outRow[x - chip->minX] = (inRow[x] == fidVal)?outVal:0;
+                        }
+                    }
+                });
+                
+                // Write the chips which are complete.
+                finishedChips.clear();
+                std::vector<ClumpChip*> stillActive;
+                for(std::vector<ClumpChip*>::iterator iterChip = activeChips.begin(); iterChip != activeChips.end(); ++iterChip)
+                {
+                    if((*iterChip)->maxY <= stripEnd)
+                    {
+                        finishedChips.push_back(*iterChip);
+                    }
+                    else
+                    {
+                        stillActive.push_back(*iterChip);
+                    }
+                }
+                activeChips.swap(stillActive);
+                pool.parallelFor(finishedChips.size(), [&](size_t n, unsigned int){writeChip(finishedChips.at(n));});
             }
-            delete[] datasets;
+            // Any clumps with rows outside of the image.
+            for(; nextChip < chips.size(); ++nextChip)
+            {
+                chips.at(nextChip)->data.assign(chips.at(nextChip)->xSize * chips.at(nextChip)->ySize, 0);
+                activeChips.push_back(chips.at(nextChip));
+            }
+            pool.parallelFor(activeChips.size(), [&](size_t n, unsigned int){writeChip(activeChips.at(n));});
             
+            for(std::vector<ClumpChip*>::iterator iterChip = chips.begin(); iterChip != chips.end(); ++iterChip)
+            {
+                delete *iterChip;
+            }
+            delete minXPxlVals;
+            delete maxXPxlVals;
+            delete minYPxlVals;
+            delete maxYPxlVals;
+            delete tlXVals;
+            delete tlYVals;
         }
         catch(RSGISAttributeTableException &e)
         {
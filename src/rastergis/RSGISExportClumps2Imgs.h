@@ -27,12 +27,20 @@
 #include <string>
 #include <math.h>
 #include <algorithm>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <functional>
+#include <cstdlib>
 
 #include "gdal_priv.h"
 #include "gdal_rat.h"
 
 #include "common/RSGISAttributeTableException.h"
 #include "common/RSGISImageException.h"
+#include "common/RSGISParallel.h"
 
 #include "img/RSGISImageCalcException.h"
 #include "img/RSGISCalcImageValue.h"
@@ -62,12 +70,24 @@
 
 namespace rsgis{namespace rastergis{
     
+    /**
+     * Export each clump to its own image, cropped to the clump's bounding box
+     * (pixel columns from the RAT). The clumps image is read once, in strips
+     * of rows; the strip is copied into every clump image overlapping it
+     * (held in memory) and the clump images are written once the strips have
+     * passed them. Copying and writing are shared between threads
+     * (RSGISLIB_NUM_THREADS or setNumThreads).
+     */
     class DllExport RSGISExportClumps2Images
     {
     public:
         RSGISExportClumps2Images();
+        void setNumThreads(unsigned int numThreads);
         void exportClumps2Images(GDALDataset *clumpsDataset, std::string outImgBase, std::string imgFileExt, std::string imageFormat, bool binaryOut, std::string minXPxl, std::string maxXPxl, std::string minYPxl, std::string maxYPxl, std::string tlX, std::string tlY, unsigned int ratBand=1);
         ~RSGISExportClumps2Images();
+    protected:
+        unsigned int numThreads;
+        unsigned int stripRows;
     };
     
     
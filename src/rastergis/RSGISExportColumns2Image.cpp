@@ -120,6 +120,168 @@ namespace rsgis{namespace rastergis{
     {
         delete[] this->columnData;
     }
+    
+    
+    RSGISRATLUTImage::RSGISRATLUTImage()
+    {
+        this->tileRows = 256;
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+    
+    void RSGISRATLUTImage::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+    
+    void RSGISRATLUTImage::populateImage(GDALDataset *clumpsDataset, unsigned int clumpsBand, std::vector<double*> luts, size_t lutSize, GDALDataset *outDataset, bool outOfRangeErr)
+    {
+        if((clumpsBand == 0) || (clumpsBand > (unsigned int)clumpsDataset->GetRasterCount()))
+        {
+            throw rsgis::img::RSGISImageCalcException("The clumps band is not within the clumps image.");
+        }
+        if(luts.size() != (size_t)outDataset->GetRasterCount())
+        {
+            throw rsgis::img::RSGISImageCalcException("The number of look-up tables must match the number of output image bands.");
+        }
+        if(lutSize > 0xFFFFFFFF)
+        {
+            throw rsgis::img::RSGISImageCalcException("The look-up table is longer than the range of clump IDs.");
+        }
+        long width = clumpsDataset->GetRasterXSize();
+        long height = clumpsDataset->GetRasterYSize();
+        if((outDataset->GetRasterXSize() != width) || (outDataset->GetRasterYSize() != height))
+        {
+            throw rsgis::img::RSGISImageCalcException("The clumps and output images must have the same dimensions.");
+        }
+        
+        // Convert each LUT to the output band's data type, with a trailing 0 for clumps outside of the LUT.
+        size_t numBands = luts.size();
+        std::vector<GDALDataType> outTypes(numBands);
+        std::vector<int> typeSizes(numBands);
+        std::vector<std::vector<unsigned char> > typedLUTs(numBands);
+        int maxTypeSize = 1;
+        for(size_t b = 0; b < numBands; ++b)
+        {
+            outTypes[b] = outDataset->GetRasterBand(b+1)->GetRasterDataType();
+            typeSizes[b] = GDALGetDataTypeSize(outTypes[b]) / 8;
+            if((typeSizes[b] != 1) && (typeSizes[b] != 2) && (typeSizes[b] != 4) && (typeSizes[b] != 8) && (typeSizes[b] != 16))
+            {
+                throw rsgis::img::RSGISImageCalcException("The output image data type is not supported.");
+            }
+            maxTypeSize = std::max(maxTypeSize, typeSizes[b]);
+            typedLUTs[b].assign((lutSize+1) * typeSizes[b], 0);
+            if(lutSize > 0)
+            {
+                GDALCopyWords(luts[b], GDT_Float64, sizeof(double), typedLUTs[b].data(), outTypes[b], typeSizes[b], lutSize);
+            }
+        }
+        
+        GDALRasterBand *inBand = clumpsDataset->GetRasterBand(clumpsBand);
+        long numTiles = (height + this->tileRows - 1) / this->tileRows;
+        std::atomic<bool> foundOutOfRange(false);
+        std::mutex gdalMutex;
+        rsgis::utils::RSGISWorkerPool pool(std::max(1l, std::min((long)this->numThreads, numTiles)));
+        std::vector<std::vector<unsigned int> > threadClumpVals(pool.getNumThreads());
+        std::vector<std::vector<unsigned char> > threadOutVals(pool.getNumThreads());
+        pool.parallelFor(numTiles, [&](size_t tile, unsigned int t)
+        {
+            std::vector<unsigned int> &clumpVals = threadClumpVals[t];
+            std::vector<unsigned char> &outVals = threadOutVals[t];
+            clumpVals.resize(width * this->tileRows);
+            outVals.resize(width * this->tileRows * maxTypeSize);
+            
+            long yOff = tile * this->tileRows;
+            long rows = std::min((long)this->tileRows, height - yOff);
+            size_t numPxls = width * rows;
+            {
+                std::lock_guard<std::mutex> lock(gdalMutex);
+                if(inBand->RasterIO(GF_Read, 0, yOff, width, rows, clumpVals.data(), width, rows, GDT_UInt32, 0, 0) != CE_None)
+                {
+                    throw rsgis::img::RSGISImageCalcException("Could not read the clumps image.");
+                }
+            }
+            for(size_t b = 0; b < numBands; ++b)
+            {
+                bool inRange = true;
+                switch(typeSizes[b])
+                {
+                    case 1:
+                        inRange = this->gatherLUT<uint8_t>(clumpVals.data(), numPxls, (const uint8_t*)typedLUTs[b].data(), lutSize, (uint8_t*)outVals.data());
+                        break;
+                    case 2:
+                        inRange = this->gatherLUT<uint16_t>(clumpVals.data(), numPxls, (const uint16_t*)typedLUTs[b].data(), lutSize, (uint16_t*)outVals.data());
+                        break;
+                    case 4:
+                        inRange = this->gatherLUT<uint32_t>(clumpVals.data(), numPxls, (const uint32_t*)typedLUTs[b].data(), lutSize, (uint32_t*)outVals.data());
+                        break;
+                    case 8:
+                        inRange = this->gatherLUT<uint64_t>(clumpVals.data(), numPxls, (const uint64_t*)typedLUTs[b].data(), lutSize, (uint64_t*)outVals.data());
+                        break;
+                    default:
+                        inRange = this->gatherLUT<LUTVal16>(clumpVals.data(), numPxls, (const LUTVal16*)typedLUTs[b].data(), lutSize, (LUTVal16*)outVals.data());
+                        break;
+                }
+                if(!inRange)
+                {
+                    foundOutOfRange = true;
+                    if(outOfRangeErr)
+                    {
+                        throw rsgis::img::RSGISImageCalcException("Image pixel value was not within the attribute table.");
+                    }
+                }
+                std::lock_guard<std::mutex> lock(gdalMutex);
+                if(outDataset->GetRasterBand(b+1)->RasterIO(GF_Write, 0, yOff, width, rows, outVals.data(), width, rows, outTypes[b], 0, 0) != CE_None)
+                {
+                    throw rsgis::img::RSGISImageCalcException("Could not write the output image.");
+                }
+            }
+        });
+        if(foundOutOfRange)
+        {
+            std::cerr << "Warning: some clump values are not within the attribute table and have been given 0.\n";
+        }
+    }
+    
+    void RSGISRATLUTImage::exportColumns(GDALDataset *clumpsDataset, unsigned int ratBand, std::vector<std::string> columns, GDALDataset *outDataset)
+    {
+        GDALRasterAttributeTable *attTable = clumpsDataset->GetRasterBand(ratBand)->GetDefaultRAT();
+        size_t lutSize = attTable->GetRowCount();
+        if(lutSize == 0)
+        {
+            throw rsgis::RSGISAttributeTableException("There are no rows in the input attribute table.");
+        }
+        
+        RSGISRasterAttUtils attUtils;
+        std::vector<double*> luts;
+        try
+        {
+            for(std::vector<std::string>::iterator iterCol = columns.begin(); iterCol != columns.end(); ++iterCol)
+            {
+                unsigned int colIdx = attUtils.findColumnIndex(attTable, *iterCol);
+                if(attTable->GetTypeOfCol(colIdx) == GFT_String)
+                {
+                    throw rsgis::RSGISAttributeTableException("Can't export a column containing strings to an image");
+                }
+                size_t colLen = 0;
+                double *colVals = attUtils.readDoubleColumn(attTable, *iterCol, &colLen);
+                colVals[0] = 0.0;
+                luts.push_back(colVals);
+            }
+            this->populateImage(clumpsDataset, ratBand, luts, lutSize, outDataset, false);
+        }
+        catch(...)
+        {
+            for(std::vector<double*>::iterator iterLUT = luts.begin(); iterLUT != luts.end(); ++iterLUT)
+            {
+                delete[] *iterLUT;
+            }
+            throw;
+        }
+        for(std::vector<double*>::iterator iterLUT = luts.begin(); iterLUT != luts.end(); ++iterLUT)
+        {
+            delete[] *iterLUT;
+        }
+    }
 
 }}
 
@@ -127,3 +289,4 @@ namespace rsgis{namespace rastergis{
 
 
 
+
@@ -27,12 +27,21 @@
 #include <string>
 #include <math.h>
 #include <algorithm>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <functional>
+#include <cstdlib>
+#include <cstdint>
 
 #include "gdal_priv.h"
 #include "gdal_rat.h"
 
 #include "common/rsgis-tqdm.h"
 #include "common/RSGISAttributeTableException.h"
+#include "common/RSGISParallel.h"
 
 #include "math/RSGISMathException.h"
 
@@ -80,6 +89,59 @@ namespace rsgis{namespace rastergis{
         unsigned int nRows;
         double *columnData;
 	};
+    
+    /**
+     * Renders look-up tables indexed by clump ID to an image (out = lut[clump]),
+     * e.g., RAT columns or a relabelling of the clumps. Each LUT is converted
+     * once to the data type of its output band (with GDALCopyWords, so the
+     * values are as if written through GDAL) and the pixels are a typed gather
+     * from uint32 clump rows, with the output written in its own data type.
+     * Tiles of rows are shared between threads (RSGISLIB_NUM_THREADS or
+     * setNumThreads), with the GDAL reads and writes under a mutex, and all the
+     * output bands are produced from a single read of the clumps.
+     */
+    class DllExport RSGISRATLUTImage
+    {
+    public:
+        RSGISRATLUTImage();
+        void setNumThreads(unsigned int numThreads);
+        void setTileRows(unsigned int tileRows){this->tileRows = (tileRows == 0)?1:tileRows;};
+        /**
+         * Populate the bands of outDataset, one LUT (of lutSize values) per band.
+         * Clump values outside of the LUT are an error if outOfRangeErr is true,
+         * otherwise they are given 0.
+         */
+        void populateImage(GDALDataset *clumpsDataset, unsigned int clumpsBand, std::vector<double*> luts, size_t lutSize, GDALDataset *outDataset, bool outOfRangeErr);
+        /**
+         * Export RAT columns to the bands of outDataset (one per column).
+         * Clump 0 (no data) is given 0.
+         */
+        void exportColumns(GDALDataset *clumpsDataset, unsigned int ratBand, std::vector<std::string> columns, GDALDataset *outDataset);
+        ~RSGISRATLUTImage(){};
+    protected:
+        struct LUTVal16
+        {
+            uint64_t v[2];
+        };
+        /**
+         * lut has lutSize+1 values, the last being 0 which is used for clump
+         * values outside of the LUT. Returns false if any were found.
+         */
+        template <typename T> bool gatherLUT(const unsigned int *clumps, size_t numPxls, const T *lut, size_t lutSize, T *out)
+        {
+            unsigned int maxIdx = lutSize;
+            size_t numOutOfRange = 0;
+            for(size_t i = 0; i < numPxls; ++i)
+            {
+                unsigned int idx = std::min(clumps[i], maxIdx);
+                numOutOfRange += (idx == maxIdx);
+                out[i] = lut[idx];
+            }
+            return (numOutOfRange == 0);
+        };
+        unsigned int numThreads;
+        unsigned int tileRows;
+    };
 	
 }}
 
@@ -57,17 +57,32 @@ namespace rsgis{namespace rastergis{
             GDALRasterAttributeTable *attTableClumps = clumpsDS->GetRasterBand(ratBandClumps)->GetDefaultRAT();
             GDALRasterAttributeTable *attTableCats = catsDS->GetRasterBand(ratBandCats)->GetDefaultRAT();
             
-            // Make sure it is long enough and extend if required.
-            int numRows = attTableClumps->GetRowCount();
+            // The categories are cross tabulated as unsigned integers so, where
+            // the band type can hold negative values, check there are none.
+            std::cout << "Find the available categories\n";
+            GDALDataType catsDataType = catsDS->GetRasterBand(ratBandCats)->GetRasterDataType();
+            if((catsDataType != GDT_Byte) && (catsDataType != GDT_UInt16) && (catsDataType != GDT_UInt32))
+            {
+                long minVal = 0;
+                long maxVal = 0;
+                attUtils.getImageBandMinMax(catsDS, ratBandCats, &minVal, &maxVal);
+                if(minVal < 0)
+                {
+                    throw rsgis::RSGISAttributeTableException("Minimum class value is 0, values less than zero are invalid.");
+                }
+            }
             
-            long minVal = 0;
-            long maxVal = 0;
-            attUtils.getImageBandMinMax(clumpsDS, ratBandClumps, &minVal, &maxVal);
+            // Count the pixels of each clump in each category in one pass.
+            RSGISLabelCrossTabulation crossTab;
+            std::vector<GDALDataset*> layerImages(1, catsDS);
+            std::vector<unsigned int> layerBands(1, ratBandCats);
+            crossTab.crossTabulate(clumpsDS, ratBandClumps, layerImages, layerBands);
             
-            if(maxVal > numRows)
+            // Make sure it is long enough and extend if required.
+            size_t numRows = attTableClumps->GetRowCount();
+            if(crossTab.getNumBaseLabels() > numRows)
             {
-                attTableClumps->SetRowCount(maxVal+1);
-                numRows = maxVal+1;
+                attTableClumps->SetRowCount(crossTab.getNumBaseLabels());
             }
             numRows = attTableClumps->GetRowCount();
             
@@ -80,38 +95,32 @@ namespace rsgis{namespace rastergis{
                 majClassNameColIdx = attUtils.findColumnIndexOrCreate(attTableClumps, majClassNameField, GFT_String, GFU_Name);
             }
             
-            // Find the range of category values. 
-            std::cout << "Find the available categories\n";
-            minVal = 0;
-            maxVal = 0;
-            attUtils.getImageBandMinMax(catsDS, ratBandCats, &minVal, &maxVal);
-            
-            if(minVal < 0)
+            // The categories with pixels anywhere within the clumps image (including clump 0).
+            size_t minCat = 0;
+            size_t numCatVals = ((size_t)crossTab.getMaxLayerLabel(0)) + 1;
+            std::vector<size_t> catsCount(numCatVals, 0);
+            const uint32_t *catLabels = NULL;
+            const uint64_t *catCounts = NULL;
+            for(size_t i = 0; i < crossTab.getNumBaseLabels(); ++i)
             {
-                throw rsgis::RSGISAttributeTableException("Minimum class value is 0, values less than zero are invalid.");
+                size_t numOverlaps = crossTab.getOverlaps(0, i, &catLabels, &catCounts);
+                for(size_t n = 0; n < numOverlaps; ++n)
+                {
+                    catsCount[catLabels[n]-minCat] += catCounts[n];
+                }
             }
             
-            size_t minCat = 0;
-            size_t maxCat = boost::lexical_cast<size_t>(maxVal);
-            size_t numCatVals = (maxCat - minCat)+1;
-            
-            size_t *catsCount = new size_t[numCatVals];
-            for(size_t i = 0; i < numCatVals; ++i)
+            // Read the class names in one go rather than a row lookup per category.
+            RSGISRATColumnCache catsColCache(attTableCats);
+            std::string *catClassNames = NULL;
+            if(copyClassName)
             {
-                catsCount[i] = 0;
+                catClassNames = catsColCache.getStrColumn(classNameField);
             }
             
-            // Get Image Values
-            GDALDataset **datasets = new GDALDataset*[2];
-            datasets[0] = catsDS;
-            datasets[1] = clumpsDS;
-            
-            RSGISCountNumPxlsInCats *calcCatsCounts = new RSGISCountNumPxlsInCats(catsCount, minCat, numCatVals, ratBandCats);
-            rsgis::img::RSGISCalcImage calcImageCatCounts(calcCatsCounts);
-            calcImageCatCounts.calcImage(datasets, 2, 0);
-            delete calcCatsCounts;
-            
             std::map<size_t,CategoryField> *cats = new std::map<size_t,CategoryField>();
+            std::vector<long> catLocalIdxs(numCatVals, -1);
+            size_t numCats = 0;
             for(size_t i = 0; i < numCatVals; ++i)
             {
                 if(catsCount[i] > 0)
@@ -120,13 +129,18 @@ namespace rsgis{namespace rastergis{
                     catField.category = minCat+i;
                     catField.fieldName = outColsName + std::string("_") + txtUtils.sizettostring(catField.category);
                     catField.fieldIdx = attUtils.findColumnIndexOrCreate(attTableClumps, catField.fieldName, GFT_Real);
-                    catField.localIdx = i;
+                    catField.localIdx = numCats++;
                     
                     if(copyClassName)
                     {
-                        catField.className = attUtils.readStringColumnVal(attTableCats, classNameField, catField.category);
+                        if(catField.category >= catsColCache.getNumRows())
+                        {
+                            throw RSGISAttributeTableException("Row is not within the RAT.");
+                        }
+                        catField.className = catClassNames[catField.category];
                     }
                     
+                    catLocalIdxs[i] = catField.localIdx;
                     cats->insert(std::pair<size_t,CategoryField>(catField.category, catField));
                 }
             }
@@ -138,27 +152,6 @@ namespace rsgis{namespace rastergis{
             }
             std::cout << std::endl;
             
-            // Calculate the ratios.
-            unsigned int **catStats = new unsigned int*[numRows];
-            for(size_t i = 0; i < numRows; ++i)
-            {
-                catStats[i] = new unsigned int[numCatVals];
-                for(unsigned int j = 0; j < numCatVals; ++j)
-                {
-                    catStats[i][j] = 0;
-                }
-            }
-            
-            unsigned int ratClumpsBandIdx = ratBandClumps - 1;
-            unsigned int ratCatsBandIdx = clumpsDS->GetRasterCount() + ratBandCats - 1;
-            datasets[0] = clumpsDS;
-            datasets[1] = catsDS;
-            RSGISCountNumPxlsInCatsPerClump *calcCatClumpCounts = new RSGISCountNumPxlsInCatsPerClump(catStats, cats, ratClumpsBandIdx, ratCatsBandIdx);
-            rsgis::img::RSGISCalcImage calcImageCatClumpCounts(calcCatClumpCounts);
-            calcImageCatClumpCounts.calcImage(datasets, 2, 0);
-            delete calcCatClumpCounts;
-            delete[] datasets;
-            
             std::cout << "Writing Majority Values to Output RAT\n";
             size_t numBlocks = floor((double)numRows/(double)RAT_BLOCK_LENGTH);
             size_t rowsRemain = numRows - (numBlocks * RAT_BLOCK_LENGTH);
@@ -166,6 +159,9 @@ namespace rsgis{namespace rastergis{
             rsgis::math::RSGISMathsUtils mathUtils;
             double *dataBlock = new double[RAT_BLOCK_LENGTH];
             double *histDataBlock = new double[RAT_BLOCK_LENGTH];
+            // The pixel counts of the block's clumps in each category, from the cross
+            // tabulation; clump 0 is left with no pixels.
+            std::vector<uint64_t> blockCatCounts(RAT_BLOCK_LENGTH * numCats);
             
             int *majBlock = new int[RAT_BLOCK_LENGTH];
             double *majBlockProp = new double[RAT_BLOCK_LENGTH];
@@ -182,11 +178,19 @@ namespace rsgis{namespace rastergis{
                 majClassNamesBlock = new char*[RAT_BLOCK_LENGTH];
             }
             size_t startRow = 0;
-            size_t rowID = 0;
             
             for(size_t i = 0; i < numBlocks; ++i)
             {
                 attTableClumps->ValuesIO(GF_Read, histoIdx, startRow, RAT_BLOCK_LENGTH, histDataBlock);
+                std::fill(blockCatCounts.begin(), blockCatCounts.end(), 0);
+                for(size_t j = ((startRow == 0)?1:0); j < RAT_BLOCK_LENGTH; ++j)
+                {
+                    size_t numOverlaps = crossTab.getOverlaps(0, startRow + j, &catLabels, &catCounts);
+                    for(size_t n = 0; n < numOverlaps; ++n)
+                    {
+                        blockCatCounts[(j * numCats) + catLocalIdxs[catLabels[n]]] = catCounts[n];
+                    }
+                }
                 for(size_t j = 0; j < RAT_BLOCK_LENGTH; ++j)
                 {
                     majBlock[j] = -1;
@@ -199,12 +203,11 @@ namespace rsgis{namespace rastergis{
                 }
                 for(std::map<size_t,CategoryField>::iterator iterCats = cats->begin(); iterCats != cats->end(); ++iterCats)
                 {
-                    rowID = startRow;
                     for(size_t j = 0; j < RAT_BLOCK_LENGTH; ++j)
                     {
                         if(histDataBlock[j] > 0)
                         {
-                            dataBlock[j] = ((double)catStats[rowID][(*iterCats).second.localIdx]) / ((double)histDataBlock[j]);
+                            dataBlock[j] = ((double)blockCatCounts[(j * numCats) + (*iterCats).second.localIdx]) / ((double)histDataBlock[j]);
 
                             if(majBlockFirst[j])
                             {
@@ -233,7 +236,6 @@ namespace rsgis{namespace rastergis{
                         {
                             dataBlock[j] = 0.0;
                         }
-                        ++rowID;
                     }
                     attTableClumps->ValuesIO(GF_Write, (*iterCats).second.fieldIdx, startRow, RAT_BLOCK_LENGTH, dataBlock);
                 }
@@ -248,6 +250,15 @@ namespace rsgis{namespace rastergis{
             if(rowsRemain > 0)
             {
                 attTableClumps->ValuesIO(GF_Read, histoIdx, startRow, rowsRemain, histDataBlock);
+                std::fill(blockCatCounts.begin(), blockCatCounts.end(), 0);
+                for(size_t j = ((startRow == 0)?1:0); j < rowsRemain; ++j)
+                {
+                    size_t numOverlaps = crossTab.getOverlaps(0, startRow + j, &catLabels, &catCounts);
+                    for(size_t n = 0; n < numOverlaps; ++n)
+                    {
+                        blockCatCounts[(j * numCats) + catLocalIdxs[catLabels[n]]] = catCounts[n];
+                    }
+                }
                 for(size_t j = 0; j < RAT_BLOCK_LENGTH; ++j)
                 {
                     majBlock[j] = -1;
@@ -260,12 +271,11 @@ namespace rsgis{namespace rastergis{
                 }
                 for(std::map<size_t,CategoryField>::iterator iterCats = cats->begin(); iterCats != cats->end(); ++iterCats)
                 {
-                    rowID = startRow;
                     for(size_t j = 0; j < rowsRemain; ++j)
                     {
                         if(histDataBlock[j] > 0)
                         {
-                            dataBlock[j] = ((double)catStats[rowID][(*iterCats).second.localIdx]) / ((double)histDataBlock[j]);
+                            dataBlock[j] = ((double)blockCatCounts[(j * numCats) + (*iterCats).second.localIdx]) / ((double)histDataBlock[j]);
 
                             if(majBlockFirst[j])
                             {
@@ -294,8 +304,6 @@ namespace rsgis{namespace rastergis{
                         {
                             dataBlock[j] = 0.0;
                         }
-                        
-                        ++rowID;
                     }
                     attTableClumps->ValuesIO(GF_Write, (*iterCats).second.fieldIdx, startRow, rowsRemain, dataBlock);
                 }
@@ -316,14 +324,7 @@ namespace rsgis{namespace rastergis{
             {
                 delete[] majClassNamesBlock;
             }
-            
-            
-            
-            for(size_t i = 0; i < numRows; ++i)
-            {
-                delete[] catStats[i];
-            }
-            delete[] catStats;
+            delete cats;
         }
         catch(rsgis::img::RSGISImageBandException &e)
         {
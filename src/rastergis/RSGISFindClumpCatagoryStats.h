@@ -37,6 +37,8 @@
 #include "math/RSGISMathException.h"
 
 #include "rastergis/RSGISRasterAttUtils.h"
+#include "rastergis/RSGISRATColumnCache.h"
+#include "rastergis/RSGISLabelCrossTabulation.h"
 
 #include "utils/RSGISTextUtils.h"
 
@@ -34,185 +34,34 @@ namespace rsgis{namespace rastergis{
         std::vector<std::list<size_t>* > *neighbours = new std::vector<std::list<size_t>* >();
         try
         {
+            // Each row is only compared with the row above and the pixel to the left.
+            RSGISRegionAdjacencyGraph rag;
+            rag.buildFromClumps(clumpImage, ratBand);
             
-            unsigned int width = clumpImage->GetRasterXSize();
-            unsigned int height = clumpImage->GetRasterYSize();
-            GDALRasterBand *imgBand = clumpImage->GetRasterBand(ratBand);
-            
-            unsigned int *clumpIdxs = new unsigned int[width];
-            unsigned long maxClumpIdx = 0;
-            
-            rsgis_tqdm pbar;
-            for(unsigned int i = 0; i < height; ++i)
-            {
-                pbar.progress(i, height);
-                imgBand->RasterIO(GF_Read, 0, i, width, 1, clumpIdxs, width, 1, GDT_UInt32, 0, 0);
-                for(unsigned int j = 0; j < width; ++j)
-                {
-                    if((i == 0) & (j == 0))
-                    {
-                        maxClumpIdx = clumpIdxs[j];
-                    }
-                    else if(clumpIdxs[j] > maxClumpIdx)
-                    {
-                        maxClumpIdx = clumpIdxs[j];
-                    }
-                }
-            }
-            pbar.finish();
-            delete[] clumpIdxs;
-            
+            size_t maxClumpIdx = (rag.getNumNodes() > 0)?(rag.getNumNodes()-1):0;
             std::cout << "Number of clumps = " << maxClumpIdx << std::endl;
             
+            // Lists are indexed from clump 1 (i.e., clump ID - 1).
             neighbours->reserve(maxClumpIdx);
-            
-            for(unsigned long i = 0; i < maxClumpIdx; ++i)
-            {
-                neighbours->push_back(new std::list<size_t>());
-            }
-            
-            int windowSize = 3;
-            
-            unsigned int **inputData = new unsigned int*[3];
-			for(int i = 0; i < windowSize; i++)
+            for(size_t fid = 1; fid <= maxClumpIdx; ++fid)
             {
-                inputData[i] = new unsigned int[width];
-                for(int j = 0; j < width; j++)
+                std::list<size_t> *clumpNeighbours = new std::list<size_t>();
+                const unsigned int *fidNeighbours = rag.getNeighbours(fid);
+                for(size_t n = 0; n < rag.getNumNeighbours(fid); ++n)
                 {
-                    inputData[i][j] = 0;
+                    clumpNeighbours->push_back(fidNeighbours[n]-1);
                 }
-            }
-            
-            unsigned int **dataBlock = new unsigned int*[windowSize];
-            for(int i = 0; i < windowSize; i++)
-            {
-                dataBlock[i] = new unsigned int[windowSize];
-            }
-            
-            unsigned long clumpID = 0;
-            
-			pbar.reset();
-			// Loop images to process data
-			for(int i = 0; i < height; i++)
-			{				
-				pbar.progress(i, height);
-				                
-				for(int m = 0; m < windowSize; m++)
-				{
-					if(m == 0)
-					{
-						if(i == 0)
-						{
-							for(int k = 0; k < width; k++)
-                            {
-                                inputData[m][k] = 0;
-                            }
-						}
-						else
-						{
-							imgBand->RasterIO(GF_Read, 0, i-1, width, 1, inputData[m], width, 1, GDT_UInt32, 0, 0);
-						}
-					}
-					else if(m == 2)
-					{
-						if((i + 1) >= height)
-						{
-							for(int k = 0; k < width; k++)
-                            {
-                                inputData[m][k] = 0;
-                            }
-						}
-						else
-						{
-							imgBand->RasterIO(GF_Read, 0, i+1, width, 1, inputData[m], width, 1, GDT_UInt32, 0, 0);
-						}
-					}
-					else
-					{
-						imgBand->RasterIO(GF_Read, 0, i, width, 1, inputData[m], width, 1, GDT_UInt32, 0, 0);
-					}
-				}
-				
-				for(int j = 0; j < width; j++)
-				{
-					for(int m = 0; m < windowSize; m++)
-					{
-						for(int k = 0; k < windowSize; k++)
-						{
-                            
-							if(k == 0)
-							{
-								if(j == 0)
-								{
-									dataBlock[m][k] = 0;
-								}
-								else
-								{
-									dataBlock[m][k] = inputData[m][(j-1)];
-								}
-							}
-							else if(k == 2)
-							{
-								if((j + 1) >= width)
-								{
-									dataBlock[m][k] = 0;
-								}
-								else
-								{
-                                    dataBlock[m][k] = inputData[m][(j+1)];
-								}
-							}
-							else
-							{
-								dataBlock[m][k] = inputData[m][j];
-							}
-						}
-					}
-					
-					
-                    // Process Window.
-                    clumpID = dataBlock[1][1];
-                    if(clumpID > 0)
-                    {
-                        if((dataBlock[0][1] > 0) & (dataBlock[0][1] != clumpID))
-                        {
-                            neighbours->at(clumpID-1)->push_back(dataBlock[0][1]-1);
-                        }
-                        if((dataBlock[1][0] > 0) & (dataBlock[1][0] != clumpID))
-                        {
-                            neighbours->at(clumpID-1)->push_back(dataBlock[1][0]-1);
-                        }
-                        if((dataBlock[1][2] > 0) & (dataBlock[1][2] != clumpID))
-                        {
-                            neighbours->at(clumpID-1)->push_back(dataBlock[1][2]-1);
-                        }
-                        if((dataBlock[2][1] > 0) & (dataBlock[2][1] != clumpID))
-                        {
-                            neighbours->at(clumpID-1)->push_back(dataBlock[2][1]-1);
-                        }
-                    }
-				}
-			}
-			pbar.finish();
-            
-			for(int i = 0; i < windowSize; i++)
-            {
-                delete[] dataBlock[i];
-                delete[] inputData[i];
-            }
-            delete[] dataBlock;
-            delete[] inputData;
-            
-            for(unsigned long i = 0; i < maxClumpIdx; ++i)
-            {
-                neighbours->at(i)->sort();
-                neighbours->at(i)->unique();
+                neighbours->push_back(clumpNeighbours);
             }
         }
         catch(rsgis::img::RSGISImageCalcException &e)
         {
             throw e;
         }
+        catch(rsgis::RSGISException &e)
+        {
+            throw rsgis::img::RSGISImageCalcException(e.what());
+        }
         
         return neighbours;
     }
@@ -221,75 +70,10 @@ namespace rsgis{namespace rastergis{
     {
         try
         {
-            kealib::KEAImageIO *keaImgIO;
-            void *internalData = clumpImage->GetInternalHandle("");
-            if(internalData != NULL)
-            {
-                try
-                {
-                    keaImgIO = static_cast<kealib::KEAImageIO*>(internalData);
-                    
-                    if((keaImgIO == NULL) | (keaImgIO == 0))
-                    {
-                        throw rsgis::img::RSGISImageCalcException("Could not get hold of the internal KEA Image IO Object - was ");
-                    }
-                }
-                catch(boost::numeric::negative_overflow& e)
-                {
-                    throw rsgis::img::RSGISImageCalcException(e.what());
-                }
-                catch(boost::numeric::positive_overflow& e)
-                {
-                    throw rsgis::img::RSGISImageCalcException(e.what());
-                }
-                catch(boost::numeric::bad_numeric_cast& e)
-                {
-                    throw rsgis::img::RSGISImageCalcException(e.what());
-                }
-            }
-            else
-            {
-                throw rsgis::img::RSGISImageCalcException("Internal data on GDAL Dataset was NULL - check input file is KEA.");
-            }
-            
-            kealib::KEAAttributeTable *keaAtt = keaImgIO->getAttributeTable(kealib::kea_att_file, ratBand);
-            size_t numRows = keaAtt->getSize();
-            
-            std::vector<std::vector<size_t>* > *neighbours = new std::vector<std::vector<size_t>* >();
-            neighbours->reserve(numRows);
-            for(size_t i = 0; i < numRows; ++i)
-            {
-                neighbours->push_back(new std::vector<size_t>());
-            }
-            
-            
-            rsgis::img::RSGISCalcImageValue *findNeighbours = new RSGISFindNeighboursCalcImage(numRows, neighbours, ratBand);
-            rsgis::img::RSGISCalcImage imgCalc = rsgis::img::RSGISCalcImage(findNeighbours);
-            
-            imgCalc.calcImageWindowData(&clumpImage, 1, 3);
-            
-            if(!keaAtt->hasField("NumNeighbours"))
-            {
-                keaAtt->addAttIntField("NumNeighbours", 0, "");
-            }
-            size_t numNeighboursIdx = keaAtt->getFieldIndex("NumNeighbours");
-            
-            keaAtt->setNeighbours(0, neighbours->size(), neighbours);
-            
-            int64_t *numNeighbours = new int64_t[neighbours->size()];
-            unsigned int i = 0;
-            for(std::vector<std::vector<size_t>* >::iterator iterClumps = neighbours->begin(); iterClumps != neighbours->end(); ++iterClumps)
-            {
-                numNeighbours[i++] = (*iterClumps)->size();
-            }
-            
-            keaAtt->setIntFields(0, neighbours->size(), numNeighboursIdx, numNeighbours);
-            
-            for(std::vector<std::vector<size_t>* >::iterator iterClumps = neighbours->begin(); iterClumps != neighbours->end(); ++iterClumps)
-            {
-                delete *iterClumps;
-            }
-            delete neighbours;
+            // Built in a single pass over the image and stored in the KEA neighbours table.
+            RSGISRegionAdjacencyGraph rag;
+            rag.buildFromClumps(clumpImage, ratBand);
+            rag.writeToKEA(clumpImage, ratBand);
         }
         catch (rsgis::img::RSGISImageCalcException &e)
         {
@@ -40,6 +40,7 @@
 #include "common/rsgis-tqdm.h"
 
 #include "rastergis/RSGISRasterAttUtils.h"
+#include "rastergis/RSGISRegionAdjacencyGraph.h"
 
 #include "gdal_priv.h"
 #include "ogrsf_frmts.h"
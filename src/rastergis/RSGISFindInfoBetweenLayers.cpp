@@ -111,61 +111,76 @@ namespace rsgis{namespace rastergis{
             unsigned int numClasses = classes.size();
 
 
-            // Create a data structure to whole the data for each clump.
-            unsigned int **clumpCounter = new unsigned int*[numBaseRows];
-            for(unsigned int i = 0; i < numBaseRows; ++i)
+            // Class index of each info clump.
+            std::map<std::string, unsigned int> classIdxs;
+            for(unsigned int j = 0; j < numClasses; ++j)
             {
-                clumpCounter[i] = new unsigned int[numClasses];
-                for(unsigned int j = 0; j < numClasses; ++j)
-                {
-                    clumpCounter[i][j] = 0;
-                }
+                classIdxs[classes.at(j)] = j;
+            }
+            std::vector<unsigned int> infoClassIdxs(numInfoRows);
+            for(size_t i = 0; i < numInfoRows; ++i)
+            {
+                infoClassIdxs[i] = classIdxs[infoColData[i]];
             }
 
-            // Iterate through the images to populate the data structure.
-            GDALDataset **datasets = new GDALDataset*[2];
-            datasets[0] = baseSegmentsDS;
-            datasets[1] = infoSegmentsDS;
-
-            RSGISCalcClumpClassMajorities *calcImgClumpClassStats = new RSGISCalcClumpClassMajorities(baseColData, infoColData, classes, clumpCounter, ignoreZero);
-            rsgis::img::RSGISCalcImage calcImageStats(calcImgClumpClassStats);
-            calcImageStats.calcImage(datasets, 2);
-            delete calcImgClumpClassStats;
-            delete[] datasets;
+            // Count the pixels of each base clump in each info clump in one pass.
+            RSGISLabelCrossTabulation crossTab;
+            std::vector<GDALDataset*> layerImages(1, infoSegmentsDS);
+            std::vector<unsigned int> layerBands(1, infoRatBand);
+            crossTab.crossTabulate(baseSegmentsDS, baseRatBand, layerImages, layerBands);
             
             std::cout << "Finding majority" << std::endl;
 
             // Find the majority column
+            std::vector<uint64_t> classCounts(numClasses, 0);
+            const uint32_t *infoLabels = NULL;
+            const uint64_t *overlapCounts = NULL;
             unsigned int maxIdx = 0;
-            unsigned int maxVal = 0;
+            uint64_t maxVal = 0;
             int *clumpMajorityIdx = new int[numBaseRows];
-            for(unsigned int i = 0; i < numBaseRows; ++i)
+            for(size_t i = 0; i < numBaseRows; ++i)
             {
-                for(unsigned int j = 0; j < numClasses; ++j)
+                clumpMajorityIdx[i] = -1;
+                if(i == 0)
                 {
-                    if(j == 0)
+                    continue;
+                }
+                size_t numOverlaps = crossTab.getOverlaps(0, i, &infoLabels, &overlapCounts);
+                if(numOverlaps == 0)
+                {
+                    continue;
+                }
+                for(size_t n = 0; n < numOverlaps; ++n)
+                {
+                    if(ignoreZero && (infoLabels[n] == 0))
                     {
-                        maxIdx = 0;
-                        maxVal = clumpCounter[i][j];
+                        continue;
                     }
-                    else if(clumpCounter[i][j] > maxVal)
+                    if(infoLabels[n] >= numInfoRows)
                     {
-                        maxIdx = j;
-                        maxVal = clumpCounter[i][j];
+                        delete[] clumpMajorityIdx;
+                        throw RSGISAttributeTableException("The info image has a clump which is not within its RAT.");
                     }
+                    classCounts[infoClassIdxs[infoLabels[n]]] += overlapCounts[n];
                 }
 
-                if(maxVal == 0)
+                // The first class with the largest count.
+                maxIdx = 0;
+                maxVal = 0;
+                for(unsigned int j = 0; j < numClasses; ++j)
                 {
-                    clumpMajorityIdx[i] = -1;
+                    if(classCounts[j] > maxVal)
+                    {
+                        maxIdx = j;
+                        maxVal = classCounts[j];
+                    }
+                    classCounts[j] = 0;
                 }
-                else
+                if(maxVal > 0)
                 {
                     clumpMajorityIdx[i] = maxIdx;
                 }
-                delete[] clumpCounter[i];
             }
-            delete[] clumpCounter;
 
             std::cout << "Exporting" << std::endl;
             // Export to large objects.
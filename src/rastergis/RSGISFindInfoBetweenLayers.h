@@ -27,11 +27,14 @@
 #include <string>
 #include <math.h>
 #include <list>
+#include <vector>
+#include <map>
 
 #include "gdal_priv.h"
 #include "gdal_rat.h"
 
 #include "rastergis/RSGISRasterAttUtils.h"
+#include "rastergis/RSGISLabelCrossTabulation.h"
 
 #include "common/RSGISAttributeTableException.h"
 
@@ -68,117 +68,146 @@ namespace rsgis{namespace rastergis{
                 std::cout << "Number of RAT Rows    = " << numRows << std::endl;
                 throw RSGISAttributeTableException("The number of rows within the vector attribute table and the number of RAT features is not the same.");
             }
-            std::cout << "Importing columns: \n";
-            int *intDataVal = new int[numRows];
-            double *realDataVal = new double[numRows];
-            std::string *strDataVal = new std::string[numRows];
-
             OGRFeatureDefn *ogrFeatDef = vecLayer->GetLayerDefn();
             int fididx = ogrFeatDef->GetFieldIndex(fidColStr.c_str());
-            int fid = 0;
-            OGRFieldDefn *fieldDef = NULL;
-            OGRFeature *feat = NULL;
-            int fieldIdx = 0;
+            if(fididx < 0)
+            {
+                throw RSGISAttributeTableException("The FID column '" + fidColStr + "' is not within the vector layer.");
+            }
+            
+            // The values of each column are gathered, indexed by the RAT row
+            // given by the FID column, in a single pass over the layer.
+            std::vector<int> fieldIdxs;
+            std::vector<OGRFieldType> fieldTypes;
+            std::vector<std::vector<int> > intCols;
+            std::vector<std::vector<double> > realCols;
+            std::vector<std::vector<std::string> > strCols;
+            std::vector<size_t> colIdxs;
             for(std::vector<std::string>::iterator iterColNames = colNames->begin(); iterColNames != colNames->end(); ++iterColNames)
             {
-                std::cout << *iterColNames << std::endl;
-                fieldIdx = ogrFeatDef->GetFieldIndex((*iterColNames).c_str());
-                fieldDef = ogrFeatDef->GetFieldDefn(fieldIdx);
-                if(fieldDef->GetType() == OFTInteger)
+                int fieldIdx = ogrFeatDef->GetFieldIndex((*iterColNames).c_str());
+                if(fieldIdx < 0)
                 {
-                    for(int i = 0; i < numRows; ++i)
-                    {
-                        intDataVal[i] = 0;
-                    }
-
-                    int feedbackstep = numVecFeats/10;
-                    int nextfeedback = feedbackstep;
-                    int feedbackCounter = 0;
-                    int i = 0;
-                    std::cout << "\tStarted" << std::flush;
-                    vecLayer->ResetReading();
-                    while( (feat = vecLayer->GetNextFeature()) != NULL )
-                    {
-                        if((numVecFeats > 10) && (i == nextfeedback))
-                        {
-                            std::cout << "." << feedbackCounter << "." << std::flush;
-                            feedbackCounter = feedbackCounter + 10;
-                            nextfeedback = nextfeedback + feedbackstep;
-                        }
-                        fid = feat->GetFieldAsInteger(fididx);
-                        intDataVal[fid] = feat->GetFieldAsInteger(fieldIdx);
-                        ++i;
-                    }
-                    std::cout << " Complete.\n";
-                    ratUtils.writeIntColumn(rat, (*iterColNames), intDataVal, numRows);
+                    throw RSGISAttributeTableException("The column '" + (*iterColNames) + "' is not within the vector layer.");
                 }
-                else if(fieldDef->GetType() == OFTReal)
+                OGRFieldType fieldType = ogrFeatDef->GetFieldDefn(fieldIdx)->GetType();
+                if(fieldType == OFTInteger)
                 {
-                    for(int i = 0; i < numRows; ++i)
-                    {
-                        realDataVal[i] = 0;
-                    }
-
-                    int feedbackstep = numVecFeats/10;
-                    int nextfeedback = feedbackstep;
-                    int feedbackCounter = 0;
-                    int i = 0;
-                    std::cout << "\tStarted" << std::flush;
-                    vecLayer->ResetReading();
-                    while( (feat = vecLayer->GetNextFeature()) != NULL )
-                    {
-                        if((numVecFeats > 10) && (i == nextfeedback))
-                        {
-                            std::cout << "." << feedbackCounter << "." << std::flush;
-                            feedbackCounter = feedbackCounter + 10;
-                            nextfeedback = nextfeedback + feedbackstep;
-                        }
-                        fid = feat->GetFieldAsInteger(fididx);
-                        realDataVal[fid] = feat->GetFieldAsDouble(fieldIdx);
-                        ++i;
-                    }
-                    std::cout << " Complete.\n";
-                    ratUtils.writeRealColumn(rat, (*iterColNames), realDataVal, numRows);
+                    colIdxs.push_back(intCols.size());
+                    intCols.push_back(std::vector<int>(numRows, 0));
+                }
+                else if(fieldType == OFTReal)
+                {
+                    colIdxs.push_back(realCols.size());
+                    realCols.push_back(std::vector<double>(numRows, 0));
+                }
+                else if(fieldType == OFTString)
+                {
+                    colIdxs.push_back(strCols.size());
+                    strCols.push_back(std::vector<std::string>(numRows));
+                }
+                else
+                {
+                    std::string message = "Data type could not be represented in RAT for field '" + (*iterColNames) + "'.";
+                    throw RSGISAttributeTableException(message);
+                }
+                fieldIdxs.push_back(fieldIdx);
+                fieldTypes.push_back(fieldType);
+            }
+            
+            // Only read the FID and selected columns (not the geometries).
+            std::vector<std::string> ignoredNames;
+            ignoredNames.push_back("OGR_GEOMETRY");
+            ignoredNames.push_back("OGR_STYLE");
+            for(int i = 0; i < ogrFeatDef->GetFieldCount(); ++i)
+            {
+                if((i != fididx) && (std::find(fieldIdxs.begin(), fieldIdxs.end(), i) == fieldIdxs.end()))
+                {
+                    ignoredNames.push_back(ogrFeatDef->GetFieldDefn(i)->GetNameRef());
                 }
-                else if(fieldDef->GetType() == OFTString)
+            }
+            std::vector<const char*> ignoredFields;
+            for(std::vector<std::string>::iterator iterNames = ignoredNames.begin(); iterNames != ignoredNames.end(); ++iterNames)
+            {
+                ignoredFields.push_back(iterNames->c_str());
+            }
+            ignoredFields.push_back(NULL);
+            vecLayer->SetIgnoredFields(ignoredFields.data());
+            
+            std::cout << "Reading columns:";
+            for(std::vector<std::string>::iterator iterColNames = colNames->begin(); iterColNames != colNames->end(); ++iterColNames)
+            {
+                std::cout << " " << *iterColNames;
+            }
+            std::cout << std::endl;
+            
+            try
+            {
+                size_t feedbackstep = numVecFeats/10;
+                size_t nextfeedback = feedbackstep;
+                int feedbackCounter = 0;
+                size_t i = 0;
+                std::cout << "\tStarted" << std::flush;
+                OGRFeature *feat = NULL;
+                vecLayer->ResetReading();
+                while( (feat = vecLayer->GetNextFeature()) != NULL )
                 {
-                    for(int i = 0; i < numRows; ++i)
+                    if((numVecFeats > 10) && (i == nextfeedback))
                     {
-                        strDataVal[i] = std::string("");
+                        std::cout << "." << feedbackCounter << "." << std::flush;
+                        feedbackCounter = feedbackCounter + 10;
+                        nextfeedback = nextfeedback + feedbackstep;
                     }
-
-                    int feedbackstep = numVecFeats/10;
-                    int nextfeedback = feedbackstep;
-                    int feedbackCounter = 0;
-                    int i = 0;
-                    std::cout << "\tStarted" << std::flush;
-                    vecLayer->ResetReading();
-                    while( (feat = vecLayer->GetNextFeature()) != NULL )
+                    GIntBig fid = feat->GetFieldAsInteger64(fididx);
+                    if((fid < 0) || (fid >= ((GIntBig)numRows)))
                     {
-                        if((numVecFeats > 10) && (i == nextfeedback))
+                        OGRFeature::DestroyFeature(feat);
+                        throw RSGISAttributeTableException("A value of the FID column is not a row of the RAT.");
+                    }
+                    for(size_t n = 0; n < fieldIdxs.size(); ++n)
+                    {
+                        if(fieldTypes[n] == OFTInteger)
+                        {
+                            intCols[colIdxs[n]][fid] = feat->GetFieldAsInteger(fieldIdxs[n]);
+                        }
+                        else if(fieldTypes[n] == OFTReal)
                         {
-                            std::cout << "." << feedbackCounter << "." << std::flush;
-                            feedbackCounter = feedbackCounter + 10;
-                            nextfeedback = nextfeedback + feedbackstep;
+                            realCols[colIdxs[n]][fid] = feat->GetFieldAsDouble(fieldIdxs[n]);
+                        }
+                        else
+                        {
+                            strCols[colIdxs[n]][fid] = feat->GetFieldAsString(fieldIdxs[n]);
                         }
-                        fid = feat->GetFieldAsInteger(fididx);
-                        strDataVal[fid] = std::string(feat->GetFieldAsString(fieldIdx));
-                        ++i;
                     }
-                    std::cout << " Complete.\n";
-                    ratUtils.writeStrColumn(rat, (*iterColNames), strDataVal, numRows);
+                    OGRFeature::DestroyFeature(feat);
+                    ++i;
+                }
+                std::cout << " Complete.\n";
+            }
+            catch(RSGISAttributeTableException &e)
+            {
+                vecLayer->SetIgnoredFields(NULL);
+                throw e;
+            }
+            vecLayer->SetIgnoredFields(NULL);
+            
+            // Each column is written once, in blocks of rows.
+            std::cout << "Writing columns to the RAT\n";
+            for(size_t n = 0; n < fieldIdxs.size(); ++n)
+            {
+                if(fieldTypes[n] == OFTInteger)
+                {
+                    ratUtils.writeIntColumn(rat, colNames->at(n), intCols[colIdxs[n]].data(), numRows);
+                }
+                else if(fieldTypes[n] == OFTReal)
+                {
+                    ratUtils.writeRealColumn(rat, colNames->at(n), realCols[colIdxs[n]].data(), numRows);
                 }
                 else
                 {
-                    std::string message = "Data type could not be represented in RAT for field '" + (*iterColNames) + "'.";
-                    throw RSGISAttributeTableException(message);
+                    ratUtils.writeStrColumn(rat, colNames->at(n), strCols[colIdxs[n]].data(), numRows);
                 }
             }
-
-            delete[] intDataVal;
-            delete[] realDataVal;
-            delete[] strDataVal;
-
         }
         catch(RSGISAttributeTableException &e)
         {
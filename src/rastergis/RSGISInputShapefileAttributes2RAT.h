@@ -28,6 +28,8 @@
 #include <string>
 #include <stdio.h>
 #include <list>
+#include <vector>
+#include <algorithm>
 
 #include "ogrsf_frmts.h"
 #include "ogr_api.h"
@@ -53,6 +55,12 @@
 
 namespace rsgis{namespace rastergis{
     
+    /**
+     * Copies columns of a vector layer to the RAT of a clumps image, the
+     * row of each feature being given by its FID column. The layer is read
+     * once (without geometries or the other columns) and each column is
+     * then written to the RAT in blocks.
+     */
     class DllExport RSGISInputShapefileAttributes2RAT
     {
     public:
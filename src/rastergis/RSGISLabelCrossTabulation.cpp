@@ -0,0 +1,241 @@
+/*
+ *  RSGISLabelCrossTabulation.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISLabelCrossTabulation.h"
+
+namespace rsgis{namespace rastergis{
+
+    RSGISLabelCrossTabulation::RSGISLabelCrossTabulation()
+    {
+        this->numThreads = rsgis::utils::getNumThreads();
+        this->numBaseLabels = 0;
+    }
+
+    void RSGISLabelCrossTabulation::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+
+    void RSGISLabelCrossTabulation::crossTabulate(GDALDataset *baseImage, unsigned int baseBand, std::vector<GDALDataset*> layerImages, std::vector<unsigned int> layerBands)
+    {
+        if((baseBand == 0) || (baseBand > ((unsigned int)baseImage->GetRasterCount())))
+        {
+            throw RSGISAttributeTableException("The base band is not within the base image.");
+        }
+        if(layerImages.empty() || (layerImages.size() != layerBands.size()))
+        {
+            throw RSGISAttributeTableException("A band must be given for each of the (one or more) layer images.");
+        }
+        size_t numLayers = layerImages.size();
+        for(size_t l = 0; l < numLayers; ++l)
+        {
+            if((layerBands[l] == 0) || (layerBands[l] > ((unsigned int)layerImages[l]->GetRasterCount())))
+            {
+                throw RSGISAttributeTableException("A layer band is not within its image.");
+            }
+        }
+
+        size_t numDS = numLayers + 1;
+        GDALDataset **datasets = new GDALDataset*[numDS];
+        int **dsOffsets = new int*[numDS];
+        datasets[0] = baseImage;
+        for(size_t l = 0; l < numLayers; ++l)
+        {
+            datasets[l+1] = layerImages[l];
+        }
+        for(size_t i = 0; i < numDS; ++i)
+        {
+            dsOffsets[i] = new int[2];
+        }
+        int width = 0;
+        int height = 0;
+        int xBlockSize = 0;
+        int yBlockSize = 0;
+        double gdalTransform[6];
+        std::vector<int> xOffs(numDS);
+        std::vector<int> yOffs(numDS);
+        rsgis::img::RSGISImageUtils imgUtils;
+        try
+        {
+            imgUtils.getImageOverlap(datasets, numDS, dsOffsets, &width, &height, gdalTransform, &xBlockSize, &yBlockSize);
+            for(size_t i = 0; i < numDS; ++i)
+            {
+                xOffs[i] = dsOffsets[i][0];
+                yOffs[i] = dsOffsets[i][1];
+            }
+        }
+        catch(rsgis::RSGISException &e)
+        {
+            for(size_t i = 0; i < numDS; ++i)
+            {
+                delete[] dsOffsets[i];
+            }
+            delete[] dsOffsets;
+            delete[] datasets;
+            throw RSGISAttributeTableException(e.what());
+        }
+        for(size_t i = 0; i < numDS; ++i)
+        {
+            delete[] dsOffsets[i];
+        }
+        delete[] dsOffsets;
+        delete[] datasets;
+
+        GDALRasterBand *baseRasterBand = baseImage->GetRasterBand(baseBand);
+        std::vector<GDALRasterBand*> layerRasterBands(numLayers);
+        for(size_t l = 0; l < numLayers; ++l)
+        {
+            layerRasterBands[l] = layerImages[l]->GetRasterBand(layerBands[l]);
+        }
+
+        // Each thread counts into its own maps (one per layer), merged at the end.
+        rsgis::utils::RSGISWorkerPool pool(this->numThreads);
+        unsigned int numParts = pool.getNumThreads();
+        std::vector<std::vector<PairCounts> > threadCounts(numParts, std::vector<PairCounts>(numLayers));
+
+        // Read strips of whole blocks, at least enough rows to share between the threads.
+        size_t stripRows = std::max<size_t>(std::max(yBlockSize, 1), this->numThreads);
+        std::vector<uint32_t> baseVals(stripRows * width);
+        std::vector<std::vector<uint32_t> > layerVals(numLayers, std::vector<uint32_t>(stripRows * width));
+        rsgis_tqdm pbar;
+        for(size_t stripStart = 0; stripStart < ((size_t)height); stripStart += stripRows)
+        {
+            pbar.progress(stripStart, height);
+            size_t nRows = std::min<size_t>(stripRows, height - stripStart);
+            if(baseRasterBand->RasterIO(GF_Read, xOffs[0], yOffs[0] + stripStart, width, nRows, baseVals.data(), width, nRows, GDT_UInt32, 0, 0) != CE_None)
+            {
+                throw RSGISAttributeTableException("Could not read the base image.");
+            }
+            for(size_t l = 0; l < numLayers; ++l)
+            {
+                if(layerRasterBands[l]->RasterIO(GF_Read, xOffs[l+1], yOffs[l+1] + stripStart, width, nRows, layerVals[l].data(), width, nRows, GDT_UInt32, 0, 0) != CE_None)
+                {
+                    throw RSGISAttributeTableException("Could not read a layer image.");
+                }
+            }
+
+            pool.parallelFor(numParts, [&](size_t t, unsigned int)
+            {
+                size_t startIdx = ((nRows * t) / numParts) * width;
+                size_t endIdx = ((nRows * (t+1)) / numParts) * width;
+                this->accumulatePixels(baseVals.data(), layerVals, startIdx, endIdx, &threadCounts[t]);
+            });
+        }
+        pbar.finish();
+
+        // Merge the threads' maps into sorted (base label, layer label) pairs.
+        std::vector<std::vector<std::pair<uint64_t, uint64_t> > > pairs(numLayers);
+        this->numBaseLabels = 0;
+        for(size_t l = 0; l < numLayers; ++l)
+        {
+            PairCounts &merged = threadCounts[0][l];
+            for(unsigned int t = 1; t < numParts; ++t)
+            {
+                for(PairCounts::iterator iterPair = threadCounts[t][l].begin(); iterPair != threadCounts[t][l].end(); ++iterPair)
+                {
+                    merged[iterPair->first] += iterPair->second;
+                }
+                PairCounts().swap(threadCounts[t][l]);
+            }
+            pairs[l].assign(merged.begin(), merged.end());
+            PairCounts().swap(merged);
+            std::sort(pairs[l].begin(), pairs[l].end());
+            if(!pairs[l].empty())
+            {
+                this->numBaseLabels = std::max<size_t>(this->numBaseLabels, (pairs[l].back().first >> 32) + 1);
+            }
+        }
+
+        this->tabs.assign(numLayers, CrossTab());
+        for(size_t l = 0; l < numLayers; ++l)
+        {
+            CrossTab &tab = this->tabs[l];
+            size_t numPairs = pairs[l].size();
+            tab.offsets.assign(this->numBaseLabels + 1, 0);
+            tab.labels.resize(numPairs);
+            tab.counts.resize(numPairs);
+            tab.maxLabel = 0;
+            for(size_t i = 0; i < numPairs; ++i)
+            {
+                uint64_t key = pairs[l][i].first;
+                ++tab.offsets[(key >> 32) + 1];
+                tab.labels[i] = (uint32_t)(key & 0xFFFFFFFF);
+                tab.counts[i] = pairs[l][i].second;
+                tab.maxLabel = std::max(tab.maxLabel, tab.labels[i]);
+            }
+            for(size_t i = 0; i < this->numBaseLabels; ++i)
+            {
+                tab.offsets[i+1] += tab.offsets[i];
+            }
+            std::vector<std::pair<uint64_t, uint64_t> >().swap(pairs[l]);
+        }
+    }
+
+    size_t RSGISLabelCrossTabulation::getOverlaps(size_t layer, size_t baseLabel, const uint32_t **labels, const uint64_t **counts) const
+    {
+        const CrossTab &tab = this->tabs.at(layer);
+        if(baseLabel >= this->numBaseLabels)
+        {
+            *labels = NULL;
+            *counts = NULL;
+            return 0;
+        }
+        uint64_t start = tab.offsets[baseLabel];
+        *labels = tab.labels.data() + start;
+        *counts = tab.counts.data() + start;
+        return tab.offsets[baseLabel+1] - start;
+    }
+
+    void RSGISLabelCrossTabulation::accumulatePixels(const uint32_t *baseVals, const std::vector<std::vector<uint32_t> > &layerVals, size_t startIdx, size_t endIdx, std::vector<PairCounts> *counts)
+    {
+        if(startIdx >= endIdx)
+        {
+            return;
+        }
+        // Neighbouring pixels mostly share both labels so count runs of a pair
+        // and only go to the hash map when the pair changes.
+        for(size_t l = 0; l < layerVals.size(); ++l)
+        {
+            const uint32_t *vals = layerVals[l].data();
+            PairCounts &pairCounts = (*counts)[l];
+            uint64_t runKey = (((uint64_t)baseVals[startIdx]) << 32) | vals[startIdx];
+            uint64_t runLen = 0;
+            for(size_t i = startIdx; i < endIdx; ++i)
+            {
+                uint64_t key = (((uint64_t)baseVals[i]) << 32) | vals[i];
+                if(key != runKey)
+                {
+                    pairCounts[runKey] += runLen;
+                    runKey = key;
+                    runLen = 0;
+                }
+                ++runLen;
+            }
+            pairCounts[runKey] += runLen;
+        }
+    }
+
+    RSGISLabelCrossTabulation::~RSGISLabelCrossTabulation()
+    {
+
+    }
+
+}}
@@ -0,0 +1,123 @@
+/*
+ *  RSGISLabelCrossTabulation.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISLabelCrossTabulation_H
+#define RSGISLabelCrossTabulation_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <utility>
+#include <unordered_map>
+#include <thread>
+#include <exception>
+#include <algorithm>
+#include <cstdlib>
+#include <stdint.h>
+
+#include "gdal_priv.h"
+
+#include "common/RSGISAttributeTableException.h"
+#include "common/rsgis-tqdm.h"
+#include "common/RSGISParallel.h"
+
+#include "img/RSGISImageUtils.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_rastergis_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace rastergis{
+
+    /**
+     * Cross-tabulates a base label (clumps) band against the label bands of
+     * one or more other images in a single pass over their overlap, giving
+     * for every base label the labels of each layer it overlaps and the
+     * number of pixels in common.
+     *
+     * Strips are read on the calling thread and the rows shared between the
+     * threads (RSGISLIB_NUM_THREADS or setNumThreads), each counting into its
+     * own hash map of (base label, layer label) pairs which are merged into a
+     * sparse table, sorted by base label then layer label, at the end. Labels
+     * are read as unsigned 32 bit integers (so negative labels are clamped
+     * to 0 by GDAL and must be rejected by the caller) and base label 0 is
+     * counted like any other; it is up to the caller to ignore it.
+     */
+    class DllExport RSGISLabelCrossTabulation
+    {
+    public:
+        RSGISLabelCrossTabulation();
+        /**
+         * Number of threads, 0 uses the number of cores.
+         */
+        void setNumThreads(unsigned int numThreads);
+        /**
+         * Cross-tabulate baseBand of baseImage with band layerBands[i] of
+         * each of layerImages.
+         */
+        void crossTabulate(GDALDataset *baseImage, unsigned int baseBand, std::vector<GDALDataset*> layerImages, std::vector<unsigned int> layerBands);
+        size_t getNumLayers() const {return tabs.size();};
+        /**
+         * The largest base label found + 1.
+         */
+        size_t getNumBaseLabels() const {return numBaseLabels;};
+        /**
+         * The largest label found in the layer.
+         */
+        uint32_t getMaxLayerLabel(size_t layer) const {return tabs.at(layer).maxLabel;};
+        /**
+         * The number of distinct layer labels overlapping the base label,
+         * with labels and counts pointed at the (ascending) labels and their
+         * pixel counts.
+         */
+        size_t getOverlaps(size_t layer, size_t baseLabel, const uint32_t **labels, const uint64_t **counts) const;
+        ~RSGISLabelCrossTabulation();
+    protected:
+        typedef std::unordered_map<uint64_t, uint64_t> PairCounts;
+        /**
+         * Compressed rows, the overlaps of base label i are from offsets[i]
+         * to offsets[i+1].
+         */
+        struct CrossTab
+        {
+            std::vector<uint64_t> offsets;
+            std::vector<uint32_t> labels;
+            std::vector<uint64_t> counts;
+            uint32_t maxLabel;
+        };
+        void accumulatePixels(const uint32_t *baseVals, const std::vector<std::vector<uint32_t> > &layerVals, size_t startIdx, size_t endIdx, std::vector<PairCounts> *counts);
+        unsigned int numThreads;
+        size_t numBaseLabels;
+        std::vector<CrossTab> tabs;
+    };
+
+}}
+
+#endif
@@ -28,7 +28,7 @@ namespace rsgis{namespace rastergis{
     
     RSGISPopRATWithStats::RSGISPopRATWithStats()
     {
-        
+        this->numThreads = rsgis::utils::getNumThreads();
     }
     
     void RSGISPopRATWithStats::populateRATWithBasicStats(GDALDataset *inputClumps, GDALDataset *inputValsImage, std::vector<RSGISBandAttStats*> *bandStats, unsigned int ratBand)
@@ -57,7 +57,7 @@ namespace rsgis{namespace rastergis{
                 rat->SetRowCount(numRows);
             }
             
-            // Check whether a standard deviation is to be created (requires second iteration of image).
+            // Find or create the output columns.
             bool calcMins = false;
             bool calcMaxs = false;
             bool calcMeans = false;
@@ -108,35 +108,25 @@ namespace rsgis{namespace rastergis{
             
             unsigned int histoIdx = attUtils.findColumnIndex(rat, "Histogram");
             
-            bool *firstVal = new bool[numRows];
-            for(int i = 0; i < numRows; ++i)
-            {
-                firstVal[i] = true;
-            }
-            
-            GDALDataset **datasets = new GDALDataset*[2];
-            datasets[0] = inputClumps;
-            datasets[1] = inputValsImage;
-            
-            double **statsData = new double*[numRows];
-            for(unsigned int i = 0; i < numRows; ++i)
+            // Accumulate all the statistics, including the standard deviation, in a single pass.
+            std::vector<bool> accSum;
+            std::vector<bool> accM2;
+            std::vector<bool> accMin;
+            std::vector<bool> accMax;
+            for(std::vector<rsgis::rastergis::RSGISBandAttStats*>::iterator iterBands = bandStats->begin(); iterBands != bandStats->end(); ++iterBands)
             {
-                statsData[i] = new double[numFeats2Calc];
-                for(unsigned int j = 0; j < numFeats2Calc; ++j)
-                {
-                    statsData[i][j] = 0.0;
-                }
+                accSum.push_back((*iterBands)->calcMean | (*iterBands)->calcSum);
+                accM2.push_back((*iterBands)->calcStdDev);
+                accMin.push_back((*iterBands)->calcMin);
+                accMax.push_back((*iterBands)->calcMax);
             }
-            
-            RSGISCalcClusterPxlValueStats *calcImgValStats = new RSGISCalcClusterPxlValueStats(statsData, bandStats, firstVal, ratBand);
-            rsgis::img::RSGISCalcImage calcImageStats(calcImgValStats);
-            calcImageStats.calcImage(datasets, 1, 1);
-            delete calcImgValStats;
+            RSGISClumpStatsAccumulator *clumpStats = this->accumulateClumpStats(inputClumps, inputValsImage, bandStats, ratBand, accSum, accM2, accMin, accMax);
             
             std::cout << "Writing Stats (";
             if(calcMins){std::cout << "Min, ";}
             if(calcMaxs){std::cout << "Max, ";}
             if(calcMeans){std::cout << "Mean, ";}
+            if(calcStdDevs){std::cout << "StdDev, ";}
             if(calcSums){std::cout << "Sum";}
             std::cout << ") to Output RAT\n";
             
@@ -147,274 +137,251 @@ namespace rsgis{namespace rastergis{
             double *histDataBlock = new double[RAT_BLOCK_LENGTH];
             size_t startRow = 0;
             size_t rowID = 0;
-            for(size_t i = 0; i < numBlocks; ++i)
+            size_t numRowsInBlock = 0;
+            unsigned int statsBand = 0;
+            double pxlCount = 0.0;
+            double mean = 0.0;
+            double meanDiff = 0.0;
+            for(size_t i = 0; i <= numBlocks; ++i)
             {
-                rat->ValuesIO(GF_Read, histoIdx, startRow, RAT_BLOCK_LENGTH, histDataBlock);
-                for(std::vector<rsgis::rastergis::RSGISBandAttStats*>::iterator iterBands = bandStats->begin(); iterBands != bandStats->end(); ++iterBands)
+                numRowsInBlock = (i < numBlocks)?RAT_BLOCK_LENGTH:rowsRemain;
+                if(numRowsInBlock == 0)
+                {
+                    break;
+                }
+                
+                rat->ValuesIO(GF_Read, histoIdx, startRow, numRowsInBlock, histDataBlock);
+                statsBand = 0;
+                for(std::vector<rsgis::rastergis::RSGISBandAttStats*>::iterator iterBands = bandStats->begin(); iterBands != bandStats->end(); ++iterBands, ++statsBand)
                 {
                     if((*iterBands)->calcMin)
                     {
                         rowID = startRow;
-                        for(size_t j = 0; j < RAT_BLOCK_LENGTH; ++j)
+                        for(size_t j = 0; j < numRowsInBlock; ++j)
                         {
-                            if(histDataBlock[j] > 0)
-                            {
-                                dataBlock[j] = statsData[rowID][(*iterBands)->minLocalIdx];
-                            }
-                            else
-                            {
-                                dataBlock[j] = 0.0;
-                            }
+                            dataBlock[j] = (histDataBlock[j] > 0)?clumpStats->getMin(rowID, statsBand):0.0;
                             ++rowID;
                         }
-                        rat->ValuesIO(GF_Write, (*iterBands)->minFieldIdx, startRow, RAT_BLOCK_LENGTH, dataBlock);
+                        rat->ValuesIO(GF_Write, (*iterBands)->minFieldIdx, startRow, numRowsInBlock, dataBlock);
                     }
                     
                     if((*iterBands)->calcMax)
                     {
                         rowID = startRow;
-                        for(size_t j = 0; j < RAT_BLOCK_LENGTH; ++j)
+                        for(size_t j = 0; j < numRowsInBlock; ++j)
                         {
-                            if(histDataBlock[j] > 0)
-                            {
-                                dataBlock[j] = statsData[rowID][(*iterBands)->maxLocalIdx];
-                            }
-                            else
-                            {
-                                dataBlock[j] = 0.0;
-                            }
+                            dataBlock[j] = (histDataBlock[j] > 0)?clumpStats->getMax(rowID, statsBand):0.0;
                             ++rowID;
                         }
-                        rat->ValuesIO(GF_Write, (*iterBands)->maxFieldIdx, startRow, RAT_BLOCK_LENGTH, dataBlock);
+                        rat->ValuesIO(GF_Write, (*iterBands)->maxFieldIdx, startRow, numRowsInBlock, dataBlock);
                     }
                     
+                    // The mean (and the standard deviation about it) are normalised
+                    // by the clump histogram, i.e., all the pixels within the clump.
                     if((*iterBands)->calcMean)
                     {
                         rowID = startRow;
-                        for(size_t j = 0; j < RAT_BLOCK_LENGTH; ++j)
-                        {
-                            if(histDataBlock[j] > 0)
-                            {
-                                statsData[rowID][(*iterBands)->meanLocalIdx] = statsData[rowID][(*iterBands)->meanLocalIdx] / histDataBlock[j];
-                                dataBlock[j] = statsData[rowID][(*iterBands)->meanLocalIdx];
-                            }
-                            else
-                            {
-                                dataBlock[j] = 0.0;
-                            }
-                            ++rowID;
-                        }
-                        rat->ValuesIO(GF_Write, (*iterBands)->meanFieldIdx, startRow, RAT_BLOCK_LENGTH, dataBlock);
-                    }
-                    
-                    if((*iterBands)->calcSum)
-                    {
-                        rowID = startRow;
-                        for(size_t j = 0; j < RAT_BLOCK_LENGTH; ++j)
-                        {
-                            if(histDataBlock[j] > 0)
-                            {
-                                dataBlock[j] = statsData[rowID][(*iterBands)->sumLocalIdx];
-                            }
-                            else
-                            {
-                                dataBlock[j] = 0.0;
-                            }
-                            ++rowID;
-                        }
-                        rat->ValuesIO(GF_Write, (*iterBands)->sumFieldIdx, startRow, RAT_BLOCK_LENGTH, dataBlock);
-                    }
-                }
-                startRow += RAT_BLOCK_LENGTH;
-            }
-            if(rowsRemain > 0)
-            {
-                rat->ValuesIO(GF_Read, histoIdx, startRow, rowsRemain, histDataBlock);
-                for(std::vector<rsgis::rastergis::RSGISBandAttStats*>::iterator iterBands = bandStats->begin(); iterBands != bandStats->end(); ++iterBands)
-                {
-                    if((*iterBands)->calcMin)
-                    {
-                        rowID = startRow;
-                        for(size_t j = 0; j < rowsRemain; ++j)
-                        {
-                            if(histDataBlock[j] > 0)
-                            {
-                                dataBlock[j] = statsData[rowID][(*iterBands)->minLocalIdx];
-                            }
-                            else
-                            {
-                                dataBlock[j] = 0.0;
-                            }
-                            ++rowID;
-                        }
-                        rat->ValuesIO(GF_Write, (*iterBands)->minFieldIdx, startRow, rowsRemain, dataBlock);
-                    }
-                    
-                    if((*iterBands)->calcMax)
-                    {
-                        rowID = startRow;
-                        for(size_t j = 0; j < rowsRemain; ++j)
+                        for(size_t j = 0; j < numRowsInBlock; ++j)
                         {
-                            if(histDataBlock[j] > 0)
-                            {
-                                dataBlock[j] = statsData[rowID][(*iterBands)->maxLocalIdx];
-                            }
-                            else
-                            {
-                                dataBlock[j] = 0.0;
-                            }
+                            dataBlock[j] = (histDataBlock[j] > 0)?(clumpStats->getSum(rowID, statsBand) / histDataBlock[j]):0.0;
                             ++rowID;
                         }
-                        rat->ValuesIO(GF_Write, (*iterBands)->maxFieldIdx, startRow, rowsRemain, dataBlock);
+                        rat->ValuesIO(GF_Write, (*iterBands)->meanFieldIdx, startRow, numRowsInBlock, dataBlock);
                     }
                     
-                    if((*iterBands)->calcMean)
+                    if((*iterBands)->calcStdDev)
                     {
                         rowID = startRow;
-                        for(size_t j = 0; j < rowsRemain; ++j)
+                        for(size_t j = 0; j < numRowsInBlock; ++j)
                         {
-                            if(histDataBlock[j] > 0)
-                            {
-                                statsData[rowID][(*iterBands)->meanLocalIdx] = statsData[rowID][(*iterBands)->meanLocalIdx] / histDataBlock[j];
-                                dataBlock[j] = statsData[rowID][(*iterBands)->meanLocalIdx];
-                            }
-                            else
+                            dataBlock[j] = 0.0;
+                            pxlCount = clumpStats->getCount(rowID, statsBand);
+                            if((histDataBlock[j] > 0) & (pxlCount > 0))
                             {
-                                dataBlock[j] = 0.0;
+                                mean = clumpStats->getSum(rowID, statsBand) / histDataBlock[j];
+                                meanDiff = (clumpStats->getSum(rowID, statsBand) / pxlCount) - mean;
+                                dataBlock[j] = sqrt((clumpStats->getM2(rowID, statsBand) + (pxlCount * meanDiff * meanDiff)) / histDataBlock[j]);
                             }
                             ++rowID;
                         }
-                        rat->ValuesIO(GF_Write, (*iterBands)->meanFieldIdx, startRow, rowsRemain, dataBlock);
+                        rat->ValuesIO(GF_Write, (*iterBands)->stdDevFieldIdx, startRow, numRowsInBlock, dataBlock);
                     }
                     
                     if((*iterBands)->calcSum)
                     {
                         rowID = startRow;
-                        for(size_t j = 0; j < rowsRemain; ++j)
+                        for(size_t j = 0; j < numRowsInBlock; ++j)
                         {
-                            if(histDataBlock[j] > 0)
-                            {
-                                dataBlock[j] = statsData[rowID][(*iterBands)->sumLocalIdx];
-                            }
-                            else
-                            {
-                                dataBlock[j] = 0.0;
-                            }
+                            dataBlock[j] = (histDataBlock[j] > 0)?clumpStats->getSum(rowID, statsBand):0.0;
                             ++rowID;
                         }
-                        rat->ValuesIO(GF_Write, (*iterBands)->sumFieldIdx, startRow, rowsRemain, dataBlock);
+                        rat->ValuesIO(GF_Write, (*iterBands)->sumFieldIdx, startRow, numRowsInBlock, dataBlock);
                     }
                 }
+                startRow += numRowsInBlock;
             }
             
-            if(calcStdDevs)
+            delete clumpStats;
+            delete[] dataBlock;
+            delete[] histDataBlock;
+        }
+        catch(RSGISAttributeTableException &e)
+        {
+            throw e;
+        }
+        catch(RSGISException &e)
+        {
+            throw RSGISAttributeTableException(e.what());
+        }
+        catch(std::exception &e)
+        {
+            throw RSGISAttributeTableException(e.what());
+        }
+    }
+    
+    void RSGISPopRATWithStats::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+    
+    RSGISClumpStatsAccumulator* RSGISPopRATWithStats::accumulateClumpStats(GDALDataset *inputClumps, GDALDataset *inputValsImage, std::vector<RSGISBandAttStats*> *bandStats, unsigned int ratBand, const std::vector<bool> &accSum, const std::vector<bool> &accM2, const std::vector<bool> &accMin, const std::vector<bool> &accMax)
+    {
+        unsigned int numStatsBands = bandStats->size();
+        std::vector<GDALRasterBand*> valBands;
+        for(std::vector<rsgis::rastergis::RSGISBandAttStats*>::iterator iterBands = bandStats->begin(); iterBands != bandStats->end(); ++iterBands)
+        {
+            if(((*iterBands)->band == 0) || ((*iterBands)->band > inputValsImage->GetRasterCount()))
             {
-                for(int i = 0; i < numRows; ++i)
-                {
-                    firstVal[i] = true;
-                }
-
-                // Get Image Values
-                double **stdDevData = new double*[numRows];
-                for(unsigned int i = 0; i < numRows; ++i)
-                {
-                    stdDevData[i] = new double[numStdDevs2Calc];
-                    for(unsigned int j = 0; j < numStdDevs2Calc; ++j)
-                    {
-                        stdDevData[i][j] = 0.0;
-                    }
-                }
-                RSGISCalcClusterPxlValueStdDev *calcImgValStdDev = new RSGISCalcClusterPxlValueStdDev(stdDevData, statsData, bandStats, firstVal, ratBand);
-                rsgis::img::RSGISCalcImage calcImageStdDev(calcImgValStdDev);
-                calcImageStdDev.calcImage(datasets, 1, 1);
-                delete calcImgValStdDev;
+                throw rsgis::RSGISAttributeTableException("Band specified for statistics is not within the image.");
+            }
+            valBands.push_back(inputValsImage->GetRasterBand((*iterBands)->band));
+        }
+        GDALRasterBand *clumpBand = inputClumps->GetRasterBand(ratBand);
+        
+        GDALDataset **datasets = new GDALDataset*[2];
+        datasets[0] = inputClumps;
+        datasets[1] = inputValsImage;
+        int **dsOffsets = new int*[2];
+        dsOffsets[0] = new int[2];
+        dsOffsets[1] = new int[2];
+        double *gdalTranslation = new double[6];
+        int width = 0;
+        int height = 0;
+        int xBlockSize = 0;
+        int yBlockSize = 0;
+        
+        RSGISClumpStatsAccumulator *accum = NULL;
+        std::exception_ptr error = nullptr;
+        try
+        {
+            rsgis::img::RSGISImageUtils imgUtils;
+            imgUtils.getImageOverlap(datasets, 2, dsOffsets, &width, &height, gdalTranslation, &xBlockSize, &yBlockSize);
+            
+            int nYBlocks = height / yBlockSize;
+            int remainRows = height - (nYBlocks * yBlockSize);
+            unsigned int nBlocks = nYBlocks + ((remainRows > 0)?1:0);
+            // The image is accumulated in strips of blocks (of at least 256 rows),
+            // independent of the number of threads, so the range of clump IDs
+            // within each strip's accumulator stays compact and the strips can be
+            // merged in a fixed order.
+            unsigned int stripBlocks = std::max<unsigned int>((256 + yBlockSize - 1) / yBlockSize, 1);
+            unsigned int nStrips = (nBlocks + stripBlocks - 1) / stripBlocks;
 
-                std::cout << "Writing Standard Deviation Stats to Output RAT\n";
-                startRow = 0;
-                for(size_t i = 0; i < numBlocks; ++i)
+            rsgis::RSGISTreeReduction<std::unique_ptr<RSGISClumpStatsAccumulator> > reduction(std::max<unsigned int>(nStrips, 1), [](std::unique_ptr<RSGISClumpStatsAccumulator> &left, std::unique_ptr<RSGISClumpStatsAccumulator> &right)
+            {
+                left->merge(*right);
+                right.reset();
+            });
+            
+            std::mutex ioMutex;
+            unsigned int blocksDone = 0;
+            rsgis_tqdm pbar;
+            
+            if(nStrips == 0)
+            {
+                std::unique_ptr<RSGISClumpStatsAccumulator> emptyAccum(new RSGISClumpStatsAccumulator(numStatsBands, accSum, accM2, accMin, accMax));
+                reduction.addPart(0, emptyAccum);
+            }
+            else
+            {
+                rsgis::utils::RSGISWorkerPool pool(std::min(this->numThreads, nStrips));
+                size_t numPxlsInBlock = ((size_t)width)*yBlockSize;
+                std::vector<std::vector<unsigned int> > threadClumpData(pool.getNumThreads());
+                std::vector<std::vector<float> > threadValData(pool.getNumThreads());
+                // GDAL datasets are not thread safe so reading is serialised.
+                pool.parallelFor(nStrips, [&](size_t strip, unsigned int t)
                 {
-                    rat->ValuesIO(GF_Read, histoIdx, startRow, RAT_BLOCK_LENGTH, histDataBlock);
-                    for(std::vector<rsgis::rastergis::RSGISBandAttStats*>::iterator iterBands = bandStats->begin(); iterBands != bandStats->end(); ++iterBands)
+                    std::vector<unsigned int> &clumpData = threadClumpData[t];
+                    std::vector<float> &valData = threadValData[t];
+                    clumpData.resize(numPxlsInBlock);
+                    valData.resize(numPxlsInBlock * numStatsBands);
+                    
+                    std::unique_ptr<RSGISClumpStatsAccumulator> stripAccum(new RSGISClumpStatsAccumulator(numStatsBands, accSum, accM2, accMin, accMax));
+                    unsigned int firstBlock = strip * stripBlocks;
+                    unsigned int lastBlock = std::min(firstBlock + stripBlocks, nBlocks);
+                    for(unsigned int blk = firstBlock; blk < lastBlock; ++blk)
                     {
-                        if((*iterBands)->calcStdDev)
+                        int numLines = (blk < (unsigned int)nYBlocks)?yBlockSize:remainRows;
                         {
-                            rowID = startRow;
-                            for(size_t j = 0; j < RAT_BLOCK_LENGTH; ++j)
+                            std::lock_guard<std::mutex> lock(ioMutex);
+                            clumpBand->RasterIO(GF_Read, dsOffsets[0][0], dsOffsets[0][1] + (blk * yBlockSize), width, numLines, clumpData.data(), width, numLines, GDT_UInt32, 0, 0);
+                            for(unsigned int b = 0; b < numStatsBands; ++b)
                             {
-                                if(histDataBlock[j] > 0)
-                                {
-                                    stdDevData[rowID][(*iterBands)->stdDevLocalIdx] = sqrt(stdDevData[rowID][(*iterBands)->stdDevLocalIdx] / histDataBlock[j]);
-                                    dataBlock[j] = stdDevData[rowID][(*iterBands)->stdDevLocalIdx];
-                                }
-                                else
-                                {
-                                    dataBlock[j] = 0.0;
-                                }
-                                ++rowID;
+                                valBands[b]->RasterIO(GF_Read, dsOffsets[1][0], dsOffsets[1][1] + (blk * yBlockSize), width, numLines, &valData[b*numPxlsInBlock], width, numLines, GDT_Float32, 0, 0);
                             }
-                            rat->ValuesIO(GF_Write, (*iterBands)->stdDevFieldIdx, startRow, RAT_BLOCK_LENGTH, dataBlock);
                         }
                         
-                    }
-                    startRow += RAT_BLOCK_LENGTH;
-                }
-                if(rowsRemain > 0)
-                {
-                    rat->ValuesIO(GF_Read, histoIdx, startRow, rowsRemain, histDataBlock);
-                    for(std::vector<rsgis::rastergis::RSGISBandAttStats*>::iterator iterBands = bandStats->begin(); iterBands != bandStats->end(); ++iterBands)
-                    {
-                        if((*iterBands)->calcStdDev)
+                        size_t nPxls = ((size_t)width)*numLines;
+                        for(size_t i = 0; i < nPxls; ++i)
                         {
-                            rowID = startRow;
-                            for(size_t j = 0; j < rowsRemain; ++j)
+                            if(clumpData[i] > 0)
                             {
-                                if(histDataBlock[j] > 0)
-                                {
-                                    stdDevData[rowID][(*iterBands)->stdDevLocalIdx] = sqrt(stdDevData[rowID][(*iterBands)->stdDevLocalIdx] / histDataBlock[j]);
-                                    dataBlock[j] = stdDevData[rowID][(*iterBands)->stdDevLocalIdx];
-                                }
-                                else
+                                for(unsigned int b = 0; b < numStatsBands; ++b)
                                 {
-                                    dataBlock[j] = 0.0;
+                                    float val = valData[(b*numPxlsInBlock) + i];
+                                    if((boost::math::isfinite)(val))
+                                    {
+                                        stripAccum->addValue(clumpData[i], b, val);
+                                    }
                                 }
-                                ++rowID;
                             }
-                            rat->ValuesIO(GF_Write, (*iterBands)->stdDevFieldIdx, startRow, rowsRemain, dataBlock);
+                        }
+                        
+                        {
+                            std::lock_guard<std::mutex> lock(ioMutex);
+                            ++blocksDone;
+                            pbar.progress(std::min(blocksDone*yBlockSize, (unsigned int)height), height);
                         }
                     }
-                }
-                
-                for(unsigned int i = 0; i < numRows; ++i)
-                {
-                    delete[] stdDevData[i];
-                }
-                delete[] stdDevData;
+                    reduction.addPart(strip, stripAccum);
+                });
             }
+            pbar.finish();
             
-            for(unsigned int i = 0; i < numRows; ++i)
-            {
-                delete[] statsData[i];
-            }
-            delete[] statsData;
-            delete[] firstVal;
-            
-            
-            delete[] dataBlock;
-            delete[] histDataBlock;
-            delete[] datasets;
+            std::unique_ptr<RSGISClumpStatsAccumulator> result;
+            reduction.getResult(&result);
+            accum = result.release();
         }
-        catch(RSGISAttributeTableException &e)
+        catch(...)
         {
-            throw e;
+            error = std::current_exception();
         }
-        catch(RSGISException &e)
-        {
-            throw RSGISAttributeTableException(e.what());
-        }
-        catch(std::exception &e)
+        
+        delete[] dsOffsets[0];
+        delete[] dsOffsets[1];
+        delete[] dsOffsets;
+        delete[] gdalTranslation;
+        delete[] datasets;
+        
+        if(error)
         {
-            throw RSGISAttributeTableException(e.what());
+            if(accum != NULL)
+            {
+                delete accum;
+            }
+            std::rethrow_exception(error);
         }
+        return accum;
     }
     
     void RSGISPopRATWithStats::populateRATWithPercentileStats(GDALDataset *inputClumps, GDALDataset *inputValsImage, unsigned int band, std::vector<RSGISBandAttPercentiles*> *bandStats, unsigned int ratBand, unsigned int numHistBins)
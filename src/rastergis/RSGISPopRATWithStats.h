@@ -25,16 +25,25 @@
 
 #include <string>
 #include <vector>
+#include <thread>
+#include <mutex>
+#include <exception>
+#include <atomic>
+#include <memory>
+#include <cstdlib>
 #include <math.h>
 
 #include "gdal_priv.h"
 #include "gdal_rat.h"
 
 #include "common/RSGISAttributeTableException.h"
+#include "common/RSGISReduction.h"
+#include "common/RSGISParallel.h"
 
 #include "math/RSGISMathsUtils.h"
 
 #include "rastergis/RSGISRasterAttUtils.h"
+#include "rastergis/RSGISClumpStatsAccumulator.h"
 
 #include "img/RSGISImageCalcException.h"
 #include "img/RSGISCalcImageValue.h"
@@ -125,7 +134,18 @@ namespace rsgis{namespace rastergis{
         void populateRATWithMeanLitStats(GDALDataset *inputClumps, GDALDataset *inputValsImage, GDALDataset *inputMeanLitImage, unsigned int meanLitBand, std::string meanLitCol, std::string pxlCountCol, std::vector<RSGISBandAttStats*> *bandStats, unsigned int ratBand);
         void populateRATWithModeStats(GDALDataset *inputClumps, GDALDataset *inputValsImage, std::string outColsName, bool useNoDataVal, long noDataVal, bool outNoDataVal, unsigned int modeBand, unsigned int ratBand);
         void populateRATWithPopValidPixels(GDALDataset *inputClumps, GDALDataset *inputValsImage, std::string outColsName, double noDataVal, unsigned int ratBand);
+        /**
+         * Set the number of threads used to accumulate the basic statistics.
+         * The default is read from the RSGISLIB_NUM_THREADS environment
+         * variable (1 if not defined); 0 uses all the available cores.
+         * The image is accumulated in fixed strips merged in a fixed order
+         * so the statistics are identical whatever the number of threads.
+         */
+        void setNumThreads(unsigned int numThreads);
         ~RSGISPopRATWithStats();
+    protected:
+        RSGISClumpStatsAccumulator* accumulateClumpStats(GDALDataset *inputClumps, GDALDataset *inputValsImage, std::vector<RSGISBandAttStats*> *bandStats, unsigned int ratBand, const std::vector<bool> &accSum, const std::vector<bool> &accM2, const std::vector<bool> &accMin, const std::vector<bool> &accMax);
+        unsigned int numThreads;
     };
     
     class DllExport RSGISCalcClusterPxlValueStats : public rsgis::img::RSGISCalcImageValue
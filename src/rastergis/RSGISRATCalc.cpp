@@ -28,394 +28,229 @@ namespace rsgis{namespace rastergis{
     RSGISRATCalc::RSGISRATCalc(RSGISRATCalcValue *ratCalcVal)
     {
         this->ratCalcVal = ratCalcVal;
+        this->chunkSize = RAT_BLOCK_LENGTH;
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+    
+    void RSGISRATCalc::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+    
+    void RSGISRATCalc::setChunkSize(size_t chunkSize)
+    {
+        this->chunkSize = (chunkSize == 0)?RAT_BLOCK_LENGTH:chunkSize;
     }
     
     void RSGISRATCalc::calcRATValues(GDALRasterAttributeTable *gdalRAT, std::vector<unsigned int> inRealColIdx, std::vector<unsigned int> inIntColIdx, std::vector<unsigned int> inStrColIdx, std::vector<unsigned int> outRealColIdx, std::vector<unsigned int> outIntColIdx, std::vector<unsigned int> outStrColIdx)
     {
+        RSGISRATCalcChunk chunk;
+        chunk.numInReal = inRealColIdx.size();
+        chunk.numInInt = inIntColIdx.size();
+        chunk.numInStr = inStrColIdx.size();
+        chunk.numOutReal = outRealColIdx.size();
+        chunk.numOutInt = outIntColIdx.size();
+        chunk.numOutStr = outStrColIdx.size();
+        char **outStrData = NULL;
+        size_t numInStrRead = 0;
         try
         {
-            unsigned int numInRealCols = inRealColIdx.size();
-            unsigned int numInIntCols = inIntColIdx.size();
-            unsigned int numInStrCols = inStrColIdx.size();
-            unsigned int numOutRealCols = outRealColIdx.size();
-            unsigned int numOutIntCols = outIntColIdx.size();
-            unsigned int numOutStrCols = outStrColIdx.size();
-            
-            double *dCalcInVals = NULL;
-            if(numInRealCols > 0)
-            {
-                dCalcInVals = new double[numInRealCols];
-            }
-            int *iCalcInVals = NULL;
-            if(numInIntCols > 0)
-            {
-                iCalcInVals = new int[numInIntCols];
-            }
-            std::string *sCalcInVals = NULL;
-            if(numInStrCols > 0)
+            size_t nRows = gdalRAT->GetRowCount();
+            chunk.chunkSize = std::min(this->chunkSize, nRows);
+            if(nRows == 0)
             {
-                sCalcInVals = new std::string[numInStrCols];
+                return;
             }
             
-            double *dCalcOutVals = NULL;
-            if(numOutRealCols > 0)
-            {
-                dCalcOutVals = new double[numOutRealCols];
-            }
-            int *iCalcOutVals = NULL;
-            if(numOutIntCols > 0)
-            {
-                iCalcOutVals = new int[numOutIntCols];
-            }
-            std::string *sCalcOutVals = NULL;
-            if(numOutStrCols > 0)
+            // Allocate Memory
+            chunk.inReal.assign(chunk.numInReal * chunk.chunkSize, 0.0);
+            chunk.inInt.assign(chunk.numInInt * chunk.chunkSize, 0);
+            chunk.inStr.assign(chunk.numInStr * chunk.chunkSize, NULL);
+            chunk.outReal.assign(chunk.numOutReal * chunk.chunkSize, 0.0);
+            chunk.outInt.assign(chunk.numOutInt * chunk.chunkSize, 0);
+            // Strings keep their capacity between chunks so are rarely reallocated.
+            chunk.outStr.assign(chunk.numOutStr * chunk.chunkSize, "");
+            if(chunk.numOutStr > 0)
             {
-                sCalcOutVals = new std::string[numOutStrCols];
+                outStrData = new char*[chunk.chunkSize];
             }
             
-            // Iterate through blocks
-            size_t nRows = gdalRAT->GetRowCount();
-            unsigned int nBlocks = floor(((double) nRows) / ((double) RAT_BLOCK_LENGTH));
-            unsigned int remainRows = nRows - (nBlocks * RAT_BLOCK_LENGTH );
+            bool useThreads = (this->numThreads > 1) && this->ratCalcVal->isStateless();
+            rsgis::utils::RSGISWorkerPool pool(useThreads?this->numThreads:1);
             
-            // Allocate Memory
-            double **inRealData = NULL;
-            if(numInRealCols > 0)
-            {
-                inRealData = new double*[numInRealCols];
-                for(unsigned int i = 0; i < numInRealCols; ++i)
-                {
-                    inRealData[i] = new double[RAT_BLOCK_LENGTH];
-                    for(int j = 0; j < RAT_BLOCK_LENGTH; ++j)
-                    {
-                        inRealData[i][j] = 0.0;
-                    }
-                }
-            }
-            double **outRealData = NULL;
-            if(numOutRealCols > 0)
-            {
-                outRealData = new double*[numOutRealCols];
-                for(unsigned int i = 0; i < numOutRealCols; ++i)
-                {
-                    outRealData[i] = new double[RAT_BLOCK_LENGTH];
-                    for(int j = 0; j < RAT_BLOCK_LENGTH; ++j)
-                    {
-                        outRealData[i][j] = 0.0;
-                    }
-                }
-            }
-            int **inIntData = NULL;
-            if(numInIntCols > 0)
-            {
-                inIntData = new int*[numInIntCols];
-                for(unsigned int i = 0; i < numInIntCols; ++i)
-                {
-                    inIntData[i] = new int[RAT_BLOCK_LENGTH];
-                    for(int j = 0; j < RAT_BLOCK_LENGTH; ++j)
-                    {
-                        inIntData[i][j] = 0.0;
-                    }
-                }
-            }
-            int **outIntData = NULL;
-            if(numOutIntCols > 0)
+            rsgis_tqdm pbar;
+            for(size_t startRow = 0; startRow < nRows; startRow += chunk.chunkSize)
             {
-                outIntData = new int*[numOutIntCols];
-                for(unsigned int i = 0; i < numOutIntCols; ++i)
+                pbar.progress(startRow, nRows);
+                size_t nChunkRows = std::min(chunk.chunkSize, nRows - startRow);
+                
+                // Read chunks
+                for(unsigned int n = 0; n < chunk.numInReal; ++n)
                 {
-                    outIntData[i] = new int[RAT_BLOCK_LENGTH];
-                    for(int j = 0; j < RAT_BLOCK_LENGTH; ++j)
+                    if(gdalRAT->ValuesIO(GF_Read, inRealColIdx[n], startRow, nChunkRows, &chunk.inReal[n*chunk.chunkSize]) != CE_None)
                     {
-                        outIntData[i][j] = 0.0;
+                        throw RSGISAttributeTableException("Failed to read a chunk of the RAT.");
                     }
                 }
-            }
-            char ***inStrData = NULL;
-            if(numInStrCols > 0)
-            {
-                inStrData = new char**[numInStrCols];
-                for(unsigned int i = 0; i < numInStrCols; ++i)
+                
+                for(unsigned int n = 0; n < chunk.numInInt; ++n)
                 {
-                    inStrData[i] = new char*[RAT_BLOCK_LENGTH];
-                    for(int j = 0; j < RAT_BLOCK_LENGTH; ++j)
+                    if(gdalRAT->ValuesIO(GF_Read, inIntColIdx[n], startRow, nChunkRows, &chunk.inInt[n*chunk.chunkSize]) != CE_None)
                     {
-                        inStrData[i][j] = "";
+                        throw RSGISAttributeTableException("Failed to read a chunk of the RAT.");
                     }
                 }
-            }
-            char ***outStrData = NULL;
-            if(numOutStrCols > 0)
-            {
-                outStrData = new char**[numOutStrCols];
-                for(unsigned int i = 0; i < numOutStrCols; ++i)
+                
+                for(unsigned int n = 0; n < chunk.numInStr; ++n)
                 {
-                    outStrData[i] = new char*[RAT_BLOCK_LENGTH];
-                    for(int j = 0; j < RAT_BLOCK_LENGTH; ++j)
+                    if(gdalRAT->ValuesIO(GF_Read, inStrColIdx[n], startRow, nChunkRows, &chunk.inStr[n*chunk.chunkSize]) != CE_None)
                     {
-                        outStrData[i][j] = "";
+                        throw RSGISAttributeTableException("Failed to read a chunk of the RAT.");
                     }
-                }
-            }
-            
-            rsgis_tqdm pbar;
-            size_t startRow = 0;
-            size_t rowID = 0;
-            for(int i = 0; i < nBlocks; i++)
-            {
-                // Read blocks
-                for(unsigned int n = 0; n < numInRealCols; ++n)
-                {
-                    gdalRAT->ValuesIO(GF_Read, inRealColIdx[n], startRow, RAT_BLOCK_LENGTH, inRealData[n]);
-                }
-                
-                for(unsigned int n = 0; n < numInIntCols; ++n)
-                {
-                    gdalRAT->ValuesIO(GF_Read, inIntColIdx[n], startRow, RAT_BLOCK_LENGTH, inIntData[n]);
-                }
-                
-                for(unsigned int n = 0; n < numInStrCols; ++n)
-                {
-                    gdalRAT->ValuesIO(GF_Read, inStrColIdx[n], startRow, RAT_BLOCK_LENGTH, inStrData[n]);
+                    numInStrRead = n+1;
                 }
                 
-                // Loop through block
-                for(int j = 0; j < RAT_BLOCK_LENGTH; ++j)
+                // Calculate chunk
+                size_t nWorkers = std::min<size_t>(pool.getNumThreads(), nChunkRows);
+                size_t rowsPerWorker = (nChunkRows + nWorkers - 1) / nWorkers;
+                pool.parallelFor((nChunkRows + rowsPerWorker - 1) / rowsPerWorker, [this, &chunk, startRow, rowsPerWorker, nChunkRows](size_t w, unsigned int)
                 {
-                    // Show progress
-                    pbar.progress(rowID, nRows);
-                    
-                    for(unsigned int n = 0; n < numInRealCols; ++n)
-                    {
-                        dCalcInVals[n] = inRealData[n][j];
-                    }
-                    
-                    for(unsigned int n = 0; n < numInIntCols; ++n)
-                    {
-                        iCalcInVals[n] = inIntData[n][j];
-                    }
-                    
-                    for(unsigned int n = 0; n < numInStrCols; ++n)
-                    {
-                        sCalcInVals[n] = std::string(inStrData[n][j]);
-                    }
-                    
-                    this->ratCalcVal->calcRATValue(rowID, dCalcInVals, numInRealCols, iCalcInVals, numInIntCols, sCalcInVals, numInStrCols, dCalcOutVals, numOutRealCols, iCalcOutVals, numOutIntCols, sCalcOutVals, numOutStrCols);
-                    
-                    for(unsigned int n = 0; n < numOutRealCols; ++n)
-                    {
-                        outRealData[n][j] = dCalcOutVals[n];
-                    }
-                    
-                    for(unsigned int n = 0; n < numOutIntCols; ++n)
-                    {
-                        outIntData[n][j] = iCalcOutVals[n];
-                    }
-                    
-                    for(unsigned int n = 0; n < numOutStrCols; ++n)
-                    {
-                        outStrData[n][j] = new char[sCalcOutVals[n].size()];
-                        strcpy(outStrData[n][j], sCalcOutVals[n].c_str());
-                        //outStrData[n][j] = const_cast<char*>(sCalcOutVals[n].c_str());
-                    }
-                    
-                    ++rowID;
-                }
+                    size_t startIdx = w * rowsPerWorker;
+                    this->calcChunkRows(&chunk, startRow, startIdx, std::min(startIdx + rowsPerWorker, nChunkRows));
+                });
                 
-                //Write blocks
-                for(unsigned int n = 0; n < numOutRealCols; ++n)
+                // The strings returned by ValuesIO are owned by the caller.
+                for(unsigned int n = 0; n < numInStrRead; ++n)
                 {
-                    gdalRAT->ValuesIO(GF_Write, outRealColIdx[n], startRow, RAT_BLOCK_LENGTH, outRealData[n]);
-                    for(int j = 0; j < RAT_BLOCK_LENGTH; ++j)
+                    for(size_t j = 0; j < nChunkRows; ++j)
                     {
-                        outRealData[n][j] = 0.0;
+                        CPLFree(chunk.inStr[(n*chunk.chunkSize)+j]);
+                        chunk.inStr[(n*chunk.chunkSize)+j] = NULL;
                     }
                 }
+                numInStrRead = 0;
                 
-                for(unsigned int n = 0; n < numOutIntCols; ++n)
+                // Write chunks
+                for(unsigned int n = 0; n < chunk.numOutReal; ++n)
                 {
-                    gdalRAT->ValuesIO(GF_Write, outIntColIdx[n], startRow, RAT_BLOCK_LENGTH, outIntData[n]);
-                    for(int j = 0; j < RAT_BLOCK_LENGTH; ++j)
+                    if(gdalRAT->ValuesIO(GF_Write, outRealColIdx[n], startRow, nChunkRows, &chunk.outReal[n*chunk.chunkSize]) != CE_None)
                     {
-                        outIntData[n][j] = 0.0;
+                        throw RSGISAttributeTableException("Failed to write a chunk of the RAT.");
                     }
                 }
                 
-                for(unsigned int n = 0; n < numOutStrCols; ++n)
+                for(unsigned int n = 0; n < chunk.numOutInt; ++n)
                 {
-                    gdalRAT->ValuesIO(GF_Write, outStrColIdx[n], startRow, RAT_BLOCK_LENGTH, outStrData[n]);
-                    for(int j = 0; j < RAT_BLOCK_LENGTH; ++j)
+                    if(gdalRAT->ValuesIO(GF_Write, outIntColIdx[n], startRow, nChunkRows, &chunk.outInt[n*chunk.chunkSize]) != CE_None)
                     {
-                        outStrData[n][j] = "";
+                        throw RSGISAttributeTableException("Failed to write a chunk of the RAT.");
                     }
                 }
                 
-                startRow += RAT_BLOCK_LENGTH;
-            }
-            if(remainRows > 0)
-            {
-                // Read blocks
-                for(unsigned int n = 0; n < numInRealCols; ++n)
-                {
-                    gdalRAT->ValuesIO(GF_Read, inRealColIdx[n], startRow, remainRows, inRealData[n]);
-                }
-                
-                for(unsigned int n = 0; n < numInIntCols; ++n)
-                {
-                    gdalRAT->ValuesIO(GF_Read, inIntColIdx[n], startRow, remainRows, inIntData[n]);
-                }
-                
-                for(unsigned int n = 0; n < numInStrCols; ++n)
-                {
-                    gdalRAT->ValuesIO(GF_Read, inStrColIdx[n], startRow, remainRows, inStrData[n]);
-                }
-                
-                // Loop through block
-                for(int j = 0; j < remainRows; ++j)
+                for(unsigned int n = 0; n < chunk.numOutStr; ++n)
                 {
-                    // Show progress
-                    pbar.progress(rowID, nRows);
-                    
-                    for(unsigned int n = 0; n < numInRealCols; ++n)
+                    // ValuesIO only reads the strings when writing so they can point into the chunk.
+                    for(size_t j = 0; j < nChunkRows; ++j)
                     {
-                        dCalcInVals[n] = inRealData[n][j];
+                        outStrData[j] = const_cast<char*>(chunk.outStr[(n*chunk.chunkSize)+j].c_str());
                     }
-                    
-                    for(unsigned int n = 0; n < numInIntCols; ++n)
+                    if(gdalRAT->ValuesIO(GF_Write, outStrColIdx[n], startRow, nChunkRows, outStrData) != CE_None)
                     {
-                        iCalcInVals[n] = inIntData[n][j];
+                        throw RSGISAttributeTableException("Failed to write a chunk of the RAT.");
                     }
-                    
-                    for(unsigned int n = 0; n < numInStrCols; ++n)
-                    {
-                        sCalcInVals[n] = std::string(inStrData[n][j]);
-                    }
-                    
-                    this->ratCalcVal->calcRATValue(rowID, dCalcInVals, numInRealCols, iCalcInVals, numInIntCols, sCalcInVals, numInStrCols, dCalcOutVals, numOutRealCols, iCalcOutVals, numOutIntCols, sCalcOutVals, numOutStrCols);
-                    
-                    for(unsigned int n = 0; n < numOutRealCols; ++n)
-                    {
-                        outRealData[n][j] = dCalcOutVals[n];
-                    }
-                    
-                    for(unsigned int n = 0; n < numOutIntCols; ++n)
-                    {
-                        outIntData[n][j] = iCalcOutVals[n];
-                    }
-                    
-                    for(unsigned int n = 0; n < numOutStrCols; ++n)
-                    {
-                        outStrData[n][j] = new char[sCalcOutVals[n].size()];
-                        strcpy(outStrData[n][j], sCalcOutVals[n].c_str());
-                        //outStrData[n][j] =  const_cast<char*>(sCalcOutVals[n].c_str());
-                    }
-                    
-                    ++rowID;
-                }
-                
-                // Write blocks
-                for(unsigned int n = 0; n < numOutRealCols; ++n)
-                {
-                    gdalRAT->ValuesIO(GF_Write, outRealColIdx[n], startRow, remainRows, outRealData[n]);
-                }
-                
-                for(unsigned int n = 0; n < numOutIntCols; ++n)
-                {
-                    gdalRAT->ValuesIO(GF_Write, outIntColIdx[n], startRow, remainRows, outIntData[n]);
-                }
-                
-                for(unsigned int n = 0; n < numOutStrCols; ++n)
-                {
-                    gdalRAT->ValuesIO(GF_Write, outStrColIdx[n], startRow, remainRows, outStrData[n]);
                 }
             }
             pbar.finish();
             
-            // Clean out and release memory...
-            if(numInRealCols > 0)
+            if(outStrData != NULL)
             {
-                for(unsigned int i = 0; i < numInRealCols; ++i)
-                {
-                    delete[] inRealData[i];
-                }
-                delete[] inRealData;
+                delete[] outStrData;
             }
-            if(numOutRealCols > 0)
+        }
+        catch (RSGISAttributeTableException &e)
+        {
+            for(size_t i = 0; i < chunk.inStr.size(); ++i)
             {
-                for(unsigned int i = 0; i < numOutRealCols; ++i)
-                {
-                    delete[] outRealData[i];
-                }
-                delete[] outRealData;
+                CPLFree(chunk.inStr[i]);
             }
-            if(numInIntCols > 0)
+            if(outStrData != NULL)
             {
-                for(unsigned int i = 0; i < numInIntCols; ++i)
-                {
-                    delete[] inIntData[i];
-                }
-                delete[] inIntData;
+                delete[] outStrData;
             }
-            if(numOutIntCols > 0)
+            throw e;
+        }
+        catch (RSGISException &e)
+        {
+            for(size_t i = 0; i < chunk.inStr.size(); ++i)
             {
-                for(unsigned int i = 0; i < numOutIntCols; ++i)
-                {
-                    delete[] outIntData[i];
-                }
-                delete[] outIntData;
+                CPLFree(chunk.inStr[i]);
             }
-            if(numInStrCols > 0)
+            if(outStrData != NULL)
             {
-                for(unsigned int i = 0; i < numInStrCols; ++i)
-                {
-                    delete[] inStrData[i];
-                }
-                delete[] inStrData;
+                delete[] outStrData;
             }
-            if(numOutStrCols > 0)
+            throw RSGISAttributeTableException(e.what());
+        }
+        catch (std::exception &e)
+        {
+            for(size_t i = 0; i < chunk.inStr.size(); ++i)
+            {
+                CPLFree(chunk.inStr[i]);
+            }
+            if(outStrData != NULL)
             {
-                for(unsigned int i = 0; i < numOutStrCols; ++i)
-                {
-                    delete[] outStrData[i];
-                }
                 delete[] outStrData;
             }
-            if(numInRealCols > 0)
+            throw RSGISAttributeTableException(e.what());
+        }
+    }
+    
+    void RSGISRATCalc::calcChunkRows(RSGISRATCalcChunk *chunk, size_t chunkStartRow, size_t startIdx, size_t endIdx)
+    {
+        // The row buffers are reused for every row; the strings keep their
+        // capacity so assigning to them does not normally allocate.
+        std::vector<double> dCalcInVals(chunk->numInReal, 0.0);
+        std::vector<int> iCalcInVals(chunk->numInInt, 0);
+        std::vector<std::string> sCalcInVals(chunk->numInStr);
+        std::vector<double> dCalcOutVals(chunk->numOutReal, 0.0);
+        std::vector<int> iCalcOutVals(chunk->numOutInt, 0);
+        std::vector<std::string> sCalcOutVals(chunk->numOutStr);
+        
+        size_t chunkSize = chunk->chunkSize;
+        for(size_t j = startIdx; j < endIdx; ++j)
+        {
+            for(unsigned int n = 0; n < chunk->numInReal; ++n)
             {
-                delete[] dCalcInVals;
+                dCalcInVals[n] = chunk->inReal[(n*chunkSize)+j];
             }
-            if(numInIntCols > 0)
+            
+            for(unsigned int n = 0; n < chunk->numInInt; ++n)
             {
-                delete[] iCalcInVals;
+                iCalcInVals[n] = chunk->inInt[(n*chunkSize)+j];
             }
-            if(numInStrCols > 0)
+            
+            for(unsigned int n = 0; n < chunk->numInStr; ++n)
             {
-                delete[] sCalcInVals;
+                const char *strVal = chunk->inStr[(n*chunkSize)+j];
+                sCalcInVals[n].assign((strVal == NULL)?"":strVal);
             }
-            if(numOutRealCols > 0)
+            
+            this->ratCalcVal->calcRATValue(chunkStartRow+j, dCalcInVals.data(), chunk->numInReal, iCalcInVals.data(), chunk->numInInt, sCalcInVals.data(), chunk->numInStr, dCalcOutVals.data(), chunk->numOutReal, iCalcOutVals.data(), chunk->numOutInt, sCalcOutVals.data(), chunk->numOutStr);
+            
+            for(unsigned int n = 0; n < chunk->numOutReal; ++n)
             {
-                delete[] dCalcOutVals;
+                chunk->outReal[(n*chunkSize)+j] = dCalcOutVals[n];
             }
-            if(numOutIntCols > 0)
+            
+            for(unsigned int n = 0; n < chunk->numOutInt; ++n)
             {
-                delete[] iCalcOutVals;
+                chunk->outInt[(n*chunkSize)+j] = iCalcOutVals[n];
             }
-            if(numOutStrCols > 0)
+            
+            for(unsigned int n = 0; n < chunk->numOutStr; ++n)
             {
-                delete[] sCalcOutVals;
-            }            
-        }
-        catch (RSGISAttributeTableException &e)
-        {
-            throw e;
-        }
-        catch (RSGISException &e)
-        {
-            throw RSGISAttributeTableException(e.what());
-        }
-        catch (std::exception &e)
-        {
-            throw RSGISAttributeTableException(e.what());
+                chunk->outStr[(n*chunkSize)+j].assign(sCalcOutVals[n]);
+            }
         }
     }
     
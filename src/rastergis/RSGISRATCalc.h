@@ -25,12 +25,17 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
 #include <math.h>
+#include <thread>
+#include <exception>
+#include <cstdlib>
 
 #include "gdal_priv.h"
 
 #include "common/rsgis-tqdm.h"
 #include "common/RSGISAttributeTableException.h"
+#include "common/RSGISParallel.h"
 
 #include "rastergis/RSGISRasterAttUtils.h"
 #include "rastergis/RSGISRATCalcValue.h"
@@ -50,14 +55,52 @@
 
 namespace rsgis{namespace rastergis{
     
+    /**
+     * Applies a RSGISRATCalcValue to each row of a RAT. The RAT is processed in
+     * chunks of rows: every input column is read for the chunk with ValuesIO,
+     * the rows are calculated and each output column is written back for the
+     * chunk. If the calculator is stateless the rows of a chunk are split
+     * across a number of threads (RSGISLIB_NUM_THREADS or setNumThreads).
+     */
     class DllExport RSGISRATCalc
     {
     public:
         RSGISRATCalc(RSGISRATCalcValue *ratCalcVal);
         virtual void calcRATValues(GDALRasterAttributeTable *gdalRAT, std::vector<unsigned int> inRealColIdx, std::vector<unsigned int> inIntColIdx, std::vector<unsigned int> inStrColIdx, std::vector<unsigned int> outRealColIdx, std::vector<unsigned int> outIntColIdx, std::vector<unsigned int> outStrColIdx);
+        /**
+         * Number of threads used for stateless calculators; 0 uses the number of cores.
+         */
+        void setNumThreads(unsigned int numThreads);
+        /**
+         * Number of rows read, calculated and written at once (default RAT_BLOCK_LENGTH).
+         */
+        void setChunkSize(size_t chunkSize);
         virtual ~RSGISRATCalc();
     protected:
+        /**
+         * The values of one chunk of rows; column n of a type is held at
+         * [n*chunkSize, (n+1)*chunkSize).
+         */
+        struct RSGISRATCalcChunk
+        {
+            size_t chunkSize;
+            std::vector<double> inReal;
+            std::vector<int> inInt;
+            std::vector<char*> inStr;
+            std::vector<double> outReal;
+            std::vector<int> outInt;
+            std::vector<std::string> outStr;
+            unsigned int numInReal;
+            unsigned int numInInt;
+            unsigned int numInStr;
+            unsigned int numOutReal;
+            unsigned int numOutInt;
+            unsigned int numOutStr;
+        };
+        void calcChunkRows(RSGISRATCalcChunk *chunk, size_t chunkStartRow, size_t startIdx, size_t endIdx);
         RSGISRATCalcValue *ratCalcVal;
+        unsigned int numThreads;
+        size_t chunkSize;
     };
     
 }}
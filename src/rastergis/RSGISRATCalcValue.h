@@ -50,6 +50,12 @@ namespace rsgis{namespace rastergis{
     {
     public:
         RSGISRATCalcValue(){};
+        /**
+         * Return true if calcRATValue only depends on the row passed to it and
+         * can be called concurrently from a number of threads, in which case
+         * RSGISRATCalc may process the rows of a chunk in parallel.
+         */
+        virtual bool isStateless(){return false;};
         virtual void calcRATValue(size_t fid, double *inRealCols, unsigned int numInRealCols, int *inIntCols, unsigned int numInIntCols, std::string *inStringCols, unsigned int numInStringCols, double *outRealCols, unsigned int numOutRealCols, int *outIntCols, unsigned int numOutIntCols, std::string *outStringCols, unsigned int numOutStringCols) = 0;
         virtual ~RSGISRATCalcValue(){};
     };
@@ -0,0 +1,292 @@
+/*
+ *  RSGISRATColumnCache.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISRATColumnCache.h"
+
+namespace rsgis{namespace rastergis{
+
+    RSGISRATColumnCache::RSGISRATColumnCache(GDALRasterAttributeTable *rat)
+    {
+        if(rat == NULL)
+        {
+            throw RSGISAttributeTableException("A RAT must be provided to the column cache.");
+        }
+        this->rat = rat;
+        this->numRows = rat->GetRowCount();
+    }
+
+    double* RSGISRATColumnCache::getRealColumn(std::string colName, bool create)
+    {
+        std::map<std::string, CachedColumn<double> >::iterator iterCol = this->realCols.find(colName);
+        if(iterCol == this->realCols.end())
+        {
+            CachedColumn<double> &col = this->realCols[colName];
+            col.data.assign(this->numRows, 0.0);
+            col.changed = false;
+            try
+            {
+                if(create && !this->columnExists(colName))
+                {
+                    col.changed = true;
+                }
+                else
+                {
+                    this->readColumn(this->attUtils.findColumnIndex(this->rat, colName), col.data.data());
+                }
+            }
+            catch(RSGISAttributeTableException &e)
+            {
+                this->realCols.erase(colName);
+                throw e;
+            }
+            return col.data.data();
+        }
+        return iterCol->second.data.data();
+    }
+
+    int* RSGISRATColumnCache::getIntColumn(std::string colName, bool create)
+    {
+        std::map<std::string, CachedColumn<int> >::iterator iterCol = this->intCols.find(colName);
+        if(iterCol == this->intCols.end())
+        {
+            CachedColumn<int> &col = this->intCols[colName];
+            col.data.assign(this->numRows, 0);
+            col.changed = false;
+            try
+            {
+                if(create && !this->columnExists(colName))
+                {
+                    col.changed = true;
+                }
+                else
+                {
+                    this->readColumn(this->attUtils.findColumnIndex(this->rat, colName), col.data.data());
+                }
+            }
+            catch(RSGISAttributeTableException &e)
+            {
+                this->intCols.erase(colName);
+                throw e;
+            }
+            return col.data.data();
+        }
+        return iterCol->second.data.data();
+    }
+
+    std::string* RSGISRATColumnCache::getStrColumn(std::string colName, bool create)
+    {
+        std::map<std::string, CachedColumn<std::string> >::iterator iterCol = this->strCols.find(colName);
+        if(iterCol == this->strCols.end())
+        {
+            CachedColumn<std::string> &col = this->strCols[colName];
+            col.data.assign(this->numRows, "");
+            col.changed = false;
+            try
+            {
+                if(create && !this->columnExists(colName))
+                {
+                    col.changed = true;
+                }
+                else
+                {
+                    this->readColumn(this->attUtils.findColumnIndex(this->rat, colName), col.data.data());
+                }
+            }
+            catch(RSGISAttributeTableException &e)
+            {
+                this->strCols.erase(colName);
+                throw e;
+            }
+            return col.data.data();
+        }
+        return iterCol->second.data.data();
+    }
+
+    void RSGISRATColumnCache::setColumnChanged(std::string colName)
+    {
+        bool found = false;
+        if(this->realCols.count(colName) > 0)
+        {
+            this->realCols[colName].changed = true;
+            found = true;
+        }
+        if(this->intCols.count(colName) > 0)
+        {
+            this->intCols[colName].changed = true;
+            found = true;
+        }
+        if(this->strCols.count(colName) > 0)
+        {
+            this->strCols[colName].changed = true;
+            found = true;
+        }
+        if(!found)
+        {
+            throw RSGISAttributeTableException("The column " + colName + " is not held within the cache.");
+        }
+    }
+
+    void RSGISRATColumnCache::flush()
+    {
+        for(std::map<std::string, CachedColumn<double> >::iterator iterCol = this->realCols.begin(); iterCol != this->realCols.end(); ++iterCol)
+        {
+            if(iterCol->second.changed)
+            {
+                unsigned int colIdx = this->attUtils.findColumnIndexOrCreate(this->rat, iterCol->first, GFT_Real);
+                this->writeColumn(colIdx, iterCol->second.data.data());
+                iterCol->second.changed = false;
+            }
+        }
+        for(std::map<std::string, CachedColumn<int> >::iterator iterCol = this->intCols.begin(); iterCol != this->intCols.end(); ++iterCol)
+        {
+            if(iterCol->second.changed)
+            {
+                unsigned int colIdx = this->attUtils.findColumnIndexOrCreate(this->rat, iterCol->first, GFT_Integer);
+                this->writeColumn(colIdx, iterCol->second.data.data());
+                iterCol->second.changed = false;
+            }
+        }
+        for(std::map<std::string, CachedColumn<std::string> >::iterator iterCol = this->strCols.begin(); iterCol != this->strCols.end(); ++iterCol)
+        {
+            if(iterCol->second.changed)
+            {
+                unsigned int colIdx = this->attUtils.findColumnIndexOrCreate(this->rat, iterCol->first, GFT_String);
+                this->writeColumn(colIdx, iterCol->second.data.data());
+                iterCol->second.changed = false;
+            }
+        }
+    }
+
+    void RSGISRATColumnCache::releaseColumn(std::string colName)
+    {
+        this->realCols.erase(colName);
+        this->intCols.erase(colName);
+        this->strCols.erase(colName);
+    }
+
+    bool RSGISRATColumnCache::columnExists(std::string colName)
+    {
+        int numColumns = this->rat->GetColumnCount();
+        for(int i = 0; i < numColumns; ++i)
+        {
+            if(std::string(this->rat->GetNameOfCol(i)) == colName)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void RSGISRATColumnCache::readColumn(unsigned int colIdx, double *data)
+    {
+        for(size_t startRow = 0; startRow < this->numRows; startRow += RAT_BLOCK_LENGTH)
+        {
+            size_t nRows = std::min<size_t>(RAT_BLOCK_LENGTH, this->numRows - startRow);
+            if(this->rat->ValuesIO(GF_Read, colIdx, startRow, nRows, &data[startRow]) != CE_None)
+            {
+                throw RSGISAttributeTableException("Failed to read a block of the RAT.");
+            }
+        }
+    }
+
+    void RSGISRATColumnCache::readColumn(unsigned int colIdx, int *data)
+    {
+        for(size_t startRow = 0; startRow < this->numRows; startRow += RAT_BLOCK_LENGTH)
+        {
+            size_t nRows = std::min<size_t>(RAT_BLOCK_LENGTH, this->numRows - startRow);
+            if(this->rat->ValuesIO(GF_Read, colIdx, startRow, nRows, &data[startRow]) != CE_None)
+            {
+                throw RSGISAttributeTableException("Failed to read a block of the RAT.");
+            }
+        }
+    }
+
+    void RSGISRATColumnCache::readColumn(unsigned int colIdx, std::string *data)
+    {
+        char **blockData = new char*[RAT_BLOCK_LENGTH];
+        for(size_t startRow = 0; startRow < this->numRows; startRow += RAT_BLOCK_LENGTH)
+        {
+            size_t nRows = std::min<size_t>(RAT_BLOCK_LENGTH, this->numRows - startRow);
+            if(this->rat->ValuesIO(GF_Read, colIdx, startRow, nRows, blockData) != CE_None)
+            {
+                delete[] blockData;
+                throw RSGISAttributeTableException("Failed to read a block of the RAT.");
+            }
+            for(size_t i = 0; i < nRows; ++i)
+            {
+                data[startRow+i] = std::string(blockData[i]);
+                CPLFree(blockData[i]);
+            }
+        }
+        delete[] blockData;
+    }
+
+    void RSGISRATColumnCache::writeColumn(unsigned int colIdx, double *data)
+    {
+        for(size_t startRow = 0; startRow < this->numRows; startRow += RAT_BLOCK_LENGTH)
+        {
+            size_t nRows = std::min<size_t>(RAT_BLOCK_LENGTH, this->numRows - startRow);
+            if(this->rat->ValuesIO(GF_Write, colIdx, startRow, nRows, &data[startRow]) != CE_None)
+            {
+                throw RSGISAttributeTableException("Failed to write a block of the RAT.");
+            }
+        }
+    }
+
+    void RSGISRATColumnCache::writeColumn(unsigned int colIdx, int *data)
+    {
+        for(size_t startRow = 0; startRow < this->numRows; startRow += RAT_BLOCK_LENGTH)
+        {
+            size_t nRows = std::min<size_t>(RAT_BLOCK_LENGTH, this->numRows - startRow);
+            if(this->rat->ValuesIO(GF_Write, colIdx, startRow, nRows, &data[startRow]) != CE_None)
+            {
+                throw RSGISAttributeTableException("Failed to write a block of the RAT.");
+            }
+        }
+    }
+
+    void RSGISRATColumnCache::writeColumn(unsigned int colIdx, std::string *data)
+    {
+        // ValuesIO only reads the strings when writing so they can point into the cache.
+        char **blockData = new char*[RAT_BLOCK_LENGTH];
+        for(size_t startRow = 0; startRow < this->numRows; startRow += RAT_BLOCK_LENGTH)
+        {
+            size_t nRows = std::min<size_t>(RAT_BLOCK_LENGTH, this->numRows - startRow);
+            for(size_t i = 0; i < nRows; ++i)
+            {
+                blockData[i] = const_cast<char*>(data[startRow+i].c_str());
+            }
+            if(this->rat->ValuesIO(GF_Write, colIdx, startRow, nRows, blockData) != CE_None)
+            {
+                delete[] blockData;
+                throw RSGISAttributeTableException("Failed to write a block of the RAT.");
+            }
+        }
+        delete[] blockData;
+    }
+
+    RSGISRATColumnCache::~RSGISRATColumnCache()
+    {
+
+    }
+
+}}
+
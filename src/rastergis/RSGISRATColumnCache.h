@@ -0,0 +1,114 @@
+/*
+ *  RSGISRATColumnCache.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISRATColumnCache_H
+#define RSGISRATColumnCache_H
+
+#include <iostream>
+#include <string>
+#include <map>
+#include <vector>
+#include <algorithm>
+
+#include "gdal_priv.h"
+#include "gdal_rat.h"
+
+#include "common/RSGISAttributeTableException.h"
+
+#include "rastergis/RSGISRasterAttUtils.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_rastergis_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace rastergis{
+
+    /**
+     * Holds whole RAT columns in memory as contiguous typed arrays so
+     * algorithms can index them directly rather than going through the RAT
+     * for each row. Columns are read on first request using ValuesIO in blocks
+     * of RAT_BLOCK_LENGTH rows straight into the array; columns marked as
+     * changed are written back in the same way by flush(). A column is only
+     * held once, however many times it is requested.
+     *
+     * Pointers returned remain valid for the lifetime of the cache.
+     */
+    class DllExport RSGISRATColumnCache
+    {
+    public:
+        RSGISRATColumnCache(GDALRasterAttributeTable *rat);
+        size_t getNumRows(){return numRows;};
+        /**
+         * Get a column, reading it from the RAT if it is not already held.
+         * If create is true and the column does not exist it is created (as
+         * zeros or empty strings) and marked as changed, otherwise an
+         * exception is thrown.
+         */
+        double* getRealColumn(std::string colName, bool create=false);
+        int* getIntColumn(std::string colName, bool create=false);
+        std::string* getStrColumn(std::string colName, bool create=false);
+        /**
+         * Mark a held column as changed so it is written back by flush().
+         */
+        void setColumnChanged(std::string colName);
+        /**
+         * Write all changed columns back to the RAT.
+         */
+        void flush();
+        /**
+         * Release the memory for a column; it is not written back.
+         */
+        void releaseColumn(std::string colName);
+        ~RSGISRATColumnCache();
+    protected:
+        template <typename T> struct CachedColumn
+        {
+            std::vector<T> data;
+            bool changed;
+        };
+        bool columnExists(std::string colName);
+        void readColumn(unsigned int colIdx, double *data);
+        void readColumn(unsigned int colIdx, int *data);
+        void readColumn(unsigned int colIdx, std::string *data);
+        void writeColumn(unsigned int colIdx, double *data);
+        void writeColumn(unsigned int colIdx, int *data);
+        void writeColumn(unsigned int colIdx, std::string *data);
+        GDALRasterAttributeTable *rat;
+        size_t numRows;
+        RSGISRasterAttUtils attUtils;
+        std::map<std::string, CachedColumn<double> > realCols;
+        std::map<std::string, CachedColumn<int> > intCols;
+        std::map<std::string, CachedColumn<std::string> > strCols;
+    };
+
+}}
+
+#endif
+
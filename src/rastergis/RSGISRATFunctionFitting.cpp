@@ -30,7 +30,7 @@ namespace rsgis{namespace rastergis{
         try
         {
             std::cout << "Import attribute tables to memory.\n";
-            GDALRasterAttributeTable *gdalRAT = clumpsDataset->GetRasterBand(1)->GetDefaultRAT();
+            GDALRasterAttributeTable *gdalRAT = clumpsDataset->GetRasterBand(ratBand)->GetDefaultRAT();
             
             RSGISRasterAttUtils ratUtils;
             rsgis::math::RSGISMathsUtils mathUtils;
@@ -65,24 +65,32 @@ namespace rsgis{namespace rastergis{
             unsigned int initWidth = 2;
             double minWidth = 0.01;
             double maxWidth = 10.0;
-            bool debug_info = false;
-            std::vector<rsgis::math::GaussianModelParams> outGauParams = fitGausModel.performFit(hist, binWidth, peakThres, ampVar, peakLocVar, initWidth, minWidth, maxWidth, debug_info);
+            
+            rsgis::math::GaussianModelHistBatch histBatch;
+            histBatch.addHist(hist);
             
             rsgis::utils::RSGISExportColumnData2HDF exportGauParams2HDF;
             exportGauParams2HDF.createFile(outH5File, 4, "Output Parameters for Gaussian Models", H5::PredType::IEEE_F64LE);
-            double *gausParams = new double[4];
             
-            std::cout << "Number of Gaussians: " << outGauParams.size() << std::endl;
-            for(std::vector<rsgis::math::GaussianModelParams>::iterator iterGauParams = outGauParams.begin(); iterGauParams != outGauParams.end(); ++iterGauParams)
+            // The parameters are written as each chunk of histograms is fitted.
+            std::vector<double> gausParams;
+            fitGausModel.performFits(&histBatch, binWidth, [&exportGauParams2HDF, &gausParams](size_t firstHist, std::vector< std::vector<rsgis::math::GaussianModelParams> > *chunkParams)
             {
-                std::cout << "\tOFF: " << (*iterGauParams).offset << "\tAMP: " << (*iterGauParams).amplitude << "\tFWHM: " << (*iterGauParams).fwhm << "\tNOISE: " << (*iterGauParams).noise << std::endl;
-                gausParams[0] = (*iterGauParams).offset;
-                gausParams[1] = (*iterGauParams).amplitude;
-                gausParams[2] = (*iterGauParams).fwhm;
-                gausParams[3] = (*iterGauParams).noise;
-                exportGauParams2HDF.addDataRow(gausParams, H5::PredType::NATIVE_DOUBLE);
-            }
-            delete[] gausParams;
+                gausParams.clear();
+                for(std::vector< std::vector<rsgis::math::GaussianModelParams> >::iterator iterHists = chunkParams->begin(); iterHists != chunkParams->end(); ++iterHists)
+                {
+                    std::cout << "Number of Gaussians: " << (*iterHists).size() << std::endl;
+                    for(std::vector<rsgis::math::GaussianModelParams>::iterator iterGauParams = (*iterHists).begin(); iterGauParams != (*iterHists).end(); ++iterGauParams)
+                    {
+                        std::cout << "\tOFF: " << (*iterGauParams).offset << "\tAMP: " << (*iterGauParams).amplitude << "\tFWHM: " << (*iterGauParams).fwhm << "\tNOISE: " << (*iterGauParams).noise << std::endl;
+                        gausParams.push_back((*iterGauParams).offset);
+                        gausParams.push_back((*iterGauParams).amplitude);
+                        gausParams.push_back((*iterGauParams).fwhm);
+                        gausParams.push_back((*iterGauParams).noise);
+                    }
+                }
+                exportGauParams2HDF.addDataRows(gausParams.data(), gausParams.size()/4, H5::PredType::NATIVE_DOUBLE);
+            }, 1000, peakThres, ampVar, peakLocVar, initWidth, minWidth, maxWidth);
             exportGauParams2HDF.close();
             
             if(outputHist)
@@ -137,6 +137,7 @@ namespace rsgis{namespace rastergis{
             }
             
             rsgis::math::RSGISCalcDistMetric *calcDist = NULL;
+            double **covarMatrix = NULL;
             if(distKNN == rsgis::math::rsgis_euclidean)
             {
                 calcDist = new rsgis::math::RSGISCalcEuclideanDistMetric();
@@ -150,7 +151,7 @@ namespace rsgis{namespace rastergis{
             else if(distKNN == rsgis::math::rsgis_mahalanobis)
             {
                 double *meanVec = mathUtils.calcMeanVector(trainData, numTrainFeats, numFloatVals, 1, numFloatVals);
-                double **covarMatrix = mathUtils.calcCovarianceMatrix(trainData, meanVec, numTrainFeats, numFloatVals, 1, numFloatVals);
+                covarMatrix = mathUtils.calcCovarianceMatrix(trainData, meanVec, numTrainFeats, numFloatVals, 1, numFloatVals);
                 size_t numVals = numFloatVals - 1;
                 delete[] meanVec;
                 calcDist = new rsgis::math::RSGISCalcMahalanobisDistMetric(covarMatrix, numVals);
@@ -171,6 +172,21 @@ namespace rsgis{namespace rastergis{
                 throw RSGISAttributeTableException("Distance method is not supported and/or known.");
             }
             
+            // Index the training data (the covariance matrix is owned by calcDist).
+            rsgis::math::RSGISKNNKDTree *kdTree = NULL;
+            if(rsgis::math::RSGISKNNKDTree::supportsMetric(distKNN))
+            {
+                std::cout << "Build KD-Tree\n";
+                try
+                {
+                    kdTree = new rsgis::math::RSGISKNNKDTree(trainData, numTrainFeats, 1, numFloatVals, distKNN, covarMatrix);
+                }
+                catch (rsgis::math::RSGISMathException &e)
+                {
+                    std::cerr << "WARNING: Could not build KD-Tree (" << e.what() << "), comparing against all training samples.\n";
+                    kdTree = NULL;
+                }
+            }
                 
             // Perform KNN
             std::cout << "Perform KNN\n";
@@ -180,7 +196,7 @@ namespace rsgis{namespace rastergis{
                 inIntColIdx.push_back(applyRegFieldIdx);
             }
             outRealColIdx.push_back(outExtrapFieldIdx);
-            RSGISPerformKNNCalcValues performKNN = RSGISPerformKNNCalcValues(trainData, numTrainFeats, numFloatVals, kFeatures, calcDist, distThreshold, mathSumStats);
+            RSGISPerformKNNCalcValues performKNN = RSGISPerformKNNCalcValues(trainData, numTrainFeats, numFloatVals, kFeatures, calcDist, distThreshold, mathSumStats, kdTree);
             ratCalc = RSGISRATCalc(&performKNN);
             ratCalc.calcRATValues(gdalAtt, inRealColIdx, inIntColIdx, inStrColIdx, outRealColIdx, outIntColIdx, outStrColIdx);
             
@@ -192,6 +208,10 @@ namespace rsgis{namespace rastergis{
             delete[]trainData;
             delete mathSumStats;
             delete calcDist;
+            if(kdTree != NULL)
+            {
+                delete kdTree;
+            }
         }
         catch (RSGISAttributeTableException &e)
         {
@@ -283,8 +303,9 @@ namespace rsgis{namespace rastergis{
     
     
 
-    RSGISPerformKNNCalcValues::RSGISPerformKNNCalcValues(double **trainData, size_t n, size_t m, unsigned int kFeatures, rsgis::math::RSGISCalcDistMetric *calcDist, float distThreshold, rsgis::math::RSGISStatsSummary *mathSumStats):RSGISRATCalcValue()
+    RSGISPerformKNNCalcValues::RSGISPerformKNNCalcValues(double **trainData, size_t n, size_t m, unsigned int kFeatures, rsgis::math::RSGISCalcDistMetric *calcDist, float distThreshold, rsgis::math::RSGISStatsSummary *mathSumStats, rsgis::math::RSGISKNNKDTree *kdTree):RSGISRATCalcValue()
     {
+        this->kdTree = kdTree;
         this->trainData = trainData;
         this->n = n;
         this->m = m;
@@ -292,6 +313,15 @@ namespace rsgis{namespace rastergis{
         this->calcDist = calcDist;
         this->distThreshold = distThreshold;
         this->mathSumStats = mathSumStats;
+        if((this->kdTree == NULL) && (m > 1))
+        {
+            this->trainFeatVals.resize(n * (m-1));
+            for(size_t i = 0; i < n; ++i)
+            {
+                std::copy(trainData[i] + 1, trainData[i] + m, &this->trainFeatVals[i*(m-1)]);
+            }
+            this->distVals.resize(n);
+        }
     }
     
     void RSGISPerformKNNCalcValues::calcRATValue(size_t fid, double *inRealCols, unsigned int numInRealCols, int *inIntCols, unsigned int numInIntCols, std::string *inStringCols, unsigned int numInStringCols, double *outRealCols, unsigned int numOutRealCols, int *outIntCols, unsigned int numOutIntCols, std::string *outStringCols, unsigned int numOutStringCols)
@@ -319,52 +349,60 @@ namespace rsgis{namespace rastergis{
             if(performKNN)
             {
                 // Find K NN samples from training data
-                std::list<std::pair<double, double*> > *kVals = new std::list<std::pair<double, double*> >();
-                this->findKVals(kVals, inRealCols);
+                std::vector<std::pair<double, size_t> > kVals;
+                if(this->kdTree != NULL)
+                {
+                    this->kdTree->findKNearest(inRealCols, this->kFeatures, this->distThreshold, &kVals);
+                }
+                else
+                {
+                    this->findKVals(&kVals, inRealCols);
+                }
                 
                 // Derive new value from K NN samples
                 std::vector<double> data;
-                for(std::list<std::pair<double, double*> >::iterator iterFeat = kVals->begin(); iterFeat != kVals->end(); ++iterFeat)
+                for(std::vector<std::pair<double, size_t> >::iterator iterFeat = kVals.begin(); iterFeat != kVals.end(); ++iterFeat)
                 {
-                    data.push_back((*iterFeat).second[0]);
+                    data.push_back(this->trainData[(*iterFeat).second][0]);
                 }
+                // Summarise into a local copy so rows can be calculated concurrently.
+                rsgis::math::RSGISStatsSummary sumStats = *this->mathSumStats;
                 rsgis::math::RSGISMathsUtils mathUtils;
-                mathUtils.generateStats(&data, this->mathSumStats);
+                mathUtils.generateStats(&data, &sumStats);
                 
                 // Write to output column
-                if(this->mathSumStats->calcMean)
+                if(sumStats.calcMean)
                 {
-                    outRealCols[0] = this->mathSumStats->mean;
+                    outRealCols[0] = sumStats.mean;
                 }
-                else if(this->mathSumStats->calcMedian)
+                else if(sumStats.calcMedian)
                 {
-                    outRealCols[0] = this->mathSumStats->median;
+                    outRealCols[0] = sumStats.median;
                 }
-                else if(this->mathSumStats->calcMax)
+                else if(sumStats.calcMax)
                 {
-                    outRealCols[0] = this->mathSumStats->max;
+                    outRealCols[0] = sumStats.max;
                 }
-                else if(this->mathSumStats->calcMin)
+                else if(sumStats.calcMin)
                 {
-                    outRealCols[0] = this->mathSumStats->min;
+                    outRealCols[0] = sumStats.min;
                 }
-                else if(this->mathSumStats->calcMode)
+                else if(sumStats.calcMode)
                 {
-                    outRealCols[0] = this->mathSumStats->mode;
+                    outRealCols[0] = sumStats.mode;
                 }
-                else if(this->mathSumStats->calcStdDev)
+                else if(sumStats.calcStdDev)
                 {
-                    outRealCols[0] = this->mathSumStats->stdDev;
+                    outRealCols[0] = sumStats.stdDev;
                 }
-                else if(this->mathSumStats->calcSum)
+                else if(sumStats.calcSum)
                 {
-                    outRealCols[0] = this->mathSumStats->sum;
+                    outRealCols[0] = sumStats.sum;
                 }
                 else
                 {
                     throw RSGISAttributeTableException("Summarise option unknown.");
                 }
-                delete kVals;
             }
             else
             {
@@ -387,38 +425,38 @@ namespace rsgis{namespace rastergis{
         
     }
     
-    void RSGISPerformKNNCalcValues::findKVals(std::list<std::pair<double, double*> > *kVals, double *featVals)
+    void RSGISPerformKNNCalcValues::findKVals(std::vector<std::pair<double, size_t> > *kVals, double *featVals)
     {
         try
         {
+            // Bounded max-heap of the nearest samples found so far.
+            kVals->clear();
+            if((this->n == 0) || (this->trainFeatVals.size() != (this->n * (m-1))))
+            {
+                return;
+            }
+            this->calcDist->calcDistMatrix(featVals + 1, 1, this->trainFeatVals.data(), this->n, m-1, this->distVals.data());
             double dist = 0.0;
             for(size_t i = 0; i < this->n; ++i)
             {
-                dist = this->calcDist->calcDist(this->trainData[i], 1, m, featVals, 1, m);
+                dist = this->distVals[i];
 
                 if(dist < this->distThreshold)
                 {
-                    if(kVals->empty())
+                    if(kVals->size() < this->kFeatures)
                     {
-                        kVals->push_back(std::pair<double, double*>(dist, this->trainData[i]));
+                        kVals->push_back(std::pair<double, size_t>(dist, i));
+                        std::push_heap(kVals->begin(), kVals->end());
                     }
-                    else
+                    else if((this->kFeatures > 0) && (dist < kVals->front().first))
                     {
-                        for(std::list<std::pair<double, double*> >::iterator iterFeat = kVals->begin(); iterFeat != kVals->end(); ++iterFeat)
-                        {
-                            if(dist < (*iterFeat).first)
-                            {
-                                kVals->insert(iterFeat, std::pair<double, double*>(dist, this->trainData[i]));
-                                break;
-                            }
-                        }
-                        if(kVals->size() > this->kFeatures)
-                        {
-                            kVals->pop_back();
-                        }
+                        std::pop_heap(kVals->begin(), kVals->end());
+                        kVals->back() = std::pair<double, size_t>(dist, i);
+                        std::push_heap(kVals->begin(), kVals->end());
                     }
                 }
             }
+            std::sort_heap(kVals->begin(), kVals->end());
         }
         catch (RSGISAttributeTableException &e)
         {
@@ -39,6 +39,7 @@
 
 #include "math/RSGISMathsUtils.h"
 #include "math/RSGISDistMetrics.h"
+#include "math/RSGISKNNKDTree.h"
 
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
@@ -91,9 +92,20 @@ namespace rsgis{namespace rastergis{
     class DllExport RSGISPerformKNNCalcValues : public RSGISRATCalcValue
     {
     public:
-        RSGISPerformKNNCalcValues(double **trainData, size_t n, size_t m, unsigned int kFeatures, rsgis::math::RSGISCalcDistMetric *calcDist, float distThreshold, rsgis::math::RSGISStatsSummary *mathSumStats);
+        /**
+         * If kdTree is provided (built over trainData) it is used to find the
+         * neighbours, otherwise the distances to every training sample are calculated
+         * together with calcDist->calcDistMatrix.
+         */
+        RSGISPerformKNNCalcValues(double **trainData, size_t n, size_t m, unsigned int kFeatures, rsgis::math::RSGISCalcDistMetric *calcDist, float distThreshold, rsgis::math::RSGISStatsSummary *mathSumStats, rsgis::math::RSGISKNNKDTree *kdTree=NULL);
+        // The distance metrics are not thread safe so only the KD-tree queries can be run in parallel.
+        bool isStateless(){return (this->kdTree != NULL);};
         void calcRATValue(size_t fid, double *inRealCols, unsigned int numInRealCols, int *inIntCols, unsigned int numInIntCols, std::string *inStringCols, unsigned int numInStringCols, double *outRealCols, unsigned int numOutRealCols, int *outIntCols, unsigned int numOutIntCols, std::string *outStringCols, unsigned int numOutStringCols);
-        void findKVals(std::list<std::pair<double, double*> > *kVals, double *featVals);
+        /**
+         * Find the (up to) kFeatures nearest training samples, as pairs of
+         * distance and training sample index sorted nearest first.
+         */
+        void findKVals(std::vector<std::pair<double, size_t> > *kVals, double *featVals);
         ~RSGISPerformKNNCalcValues();
     private:
         double **trainData;
@@ -103,6 +115,11 @@ namespace rsgis{namespace rastergis{
         rsgis::math::RSGISCalcDistMetric *calcDist;
         float distThreshold;
         rsgis::math::RSGISStatsSummary *mathSumStats;
+        rsgis::math::RSGISKNNKDTree *kdTree;
+        // Without a KD-tree the training features are held contiguously so the
+        // distances to all the samples are calculated in one batch.
+        std::vector<double> trainFeatVals;
+        std::vector<double> distVals;
     };
     
     
@@ -2574,6 +2574,59 @@ namespace rsgis{namespace rastergis{
         }
     }
     
+    template <typename T> static void columnRangeIO(GDALRasterAttributeTable *attTable, GDALRWFlag rwFlag, int colIdx, size_t startRow, size_t nRows, T *data)
+    {
+        // Each block is read/written straight from/to the caller's array.
+        for(size_t row = 0; row < nRows; row += RAT_BLOCK_LENGTH)
+        {
+            size_t blockRows = std::min<size_t>(RAT_BLOCK_LENGTH, nRows - row);
+            if(attTable->ValuesIO(rwFlag, colIdx, startRow + row, blockRows, &data[row]) != CE_None)
+            {
+                throw RSGISAttributeTableException("Failed to read or write a block of the column.");
+            }
+        }
+    }
+    
+    void RSGISRasterAttUtils::readColumnRange(GDALRasterAttributeTable *attTable, std::string colName, size_t startRow, size_t nRows, double *data)
+    {
+        if((startRow + nRows) > ((size_t)attTable->GetRowCount()))
+        {
+            throw RSGISAttributeTableException("The rows requested are beyond the end of the RAT.");
+        }
+        unsigned int colIdx = this->findColumnIndex(attTable, colName);
+        columnRangeIO<double>(attTable, GF_Read, colIdx, startRow, nRows, data);
+    }
+    
+    void RSGISRasterAttUtils::readColumnRange(GDALRasterAttributeTable *attTable, std::string colName, size_t startRow, size_t nRows, int *data)
+    {
+        if((startRow + nRows) > ((size_t)attTable->GetRowCount()))
+        {
+            throw RSGISAttributeTableException("The rows requested are beyond the end of the RAT.");
+        }
+        unsigned int colIdx = this->findColumnIndex(attTable, colName);
+        columnRangeIO<int>(attTable, GF_Read, colIdx, startRow, nRows, data);
+    }
+    
+    void RSGISRasterAttUtils::writeColumnRange(GDALRasterAttributeTable *attTable, std::string colName, size_t startRow, size_t nRows, double *data)
+    {
+        if((startRow + nRows) > ((size_t)attTable->GetRowCount()))
+        {
+            attTable->SetRowCount(startRow + nRows);
+        }
+        unsigned int colIdx = this->findColumnIndexOrCreate(attTable, colName, GFT_Real);
+        columnRangeIO<double>(attTable, GF_Write, colIdx, startRow, nRows, data);
+    }
+    
+    void RSGISRasterAttUtils::writeColumnRange(GDALRasterAttributeTable *attTable, std::string colName, size_t startRow, size_t nRows, int *data)
+    {
+        if((startRow + nRows) > ((size_t)attTable->GetRowCount()))
+        {
+            attTable->SetRowCount(startRow + nRows);
+        }
+        unsigned int colIdx = this->findColumnIndexOrCreate(attTable, colName, GFT_Integer);
+        columnRangeIO<int>(attTable, GF_Write, colIdx, startRow, nRows, data);
+    }
+    
     void RSGISRasterAttUtils::getImageBandMinMax(GDALDataset *inImage, int band, long *minVal, long *maxVal)
     {
         try
@@ -202,6 +202,18 @@ namespace rsgis{namespace rastergis{
         void writeStrColumn(GDALRasterAttributeTable *attTable, std::string colName, std::string *strDataVal, size_t colLen);
         void writeIntColumn(GDALRasterAttributeTable *attTable, std::string colName, int *intDataVal, size_t colLen);
         void writeRealColumn(GDALRasterAttributeTable *attTable, std::string colName, double *realDataVal, size_t colLen);
+        /**
+         * Read nRows rows of a column, from startRow, straight into data (no
+         * intermediate copy is made), in blocks of RAT_BLOCK_LENGTH rows.
+         */
+        void readColumnRange(GDALRasterAttributeTable *attTable, std::string colName, size_t startRow, size_t nRows, double *data);
+        void readColumnRange(GDALRasterAttributeTable *attTable, std::string colName, size_t startRow, size_t nRows, int *data);
+        /**
+         * Write nRows rows of a column from startRow, creating the column (as
+         * real or integer) and extending the RAT if required.
+         */
+        void writeColumnRange(GDALRasterAttributeTable *attTable, std::string colName, size_t startRow, size_t nRows, double *data);
+        void writeColumnRange(GDALRasterAttributeTable *attTable, std::string colName, size_t startRow, size_t nRows, int *data);
         std::vector<RSGISRATCol>* getRatColumnsList(GDALRasterAttributeTable *gdalATT);
         std::vector<RSGISRATCol>* getVectorColumns(OGRLayer *layer, bool ignoreErr=false);
         void getImageBandMinMax(GDALDataset *inImage, int band, long *minVal, long *maxVal);
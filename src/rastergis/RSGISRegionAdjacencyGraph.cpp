@@ -0,0 +1,453 @@
+/*
+ *  RSGISRegionAdjacencyGraph.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISRegionAdjacencyGraph.h"
+
+namespace rsgis{namespace rastergis{
+
+    RSGISRegionAdjacencyGraph::RSGISRegionAdjacencyGraph()
+    {
+        this->numNodes = 0;
+        this->keaBlockSize = 100000;
+        this->calcBorderLengths = false;
+        this->compactSize = 0;
+        this->maxFID = 0;
+        this->adjStart.assign(1, 0);
+    }
+
+    void RSGISRegionAdjacencyGraph::buildFromClumps(GDALDataset *clumpImage, unsigned int band, bool calcBorderLengths)
+    {
+        if((band == 0) || (band > ((unsigned int)clumpImage->GetRasterCount())))
+        {
+            throw RSGISAttributeTableException("The band specified is not within the clumps image.");
+        }
+        unsigned int width = clumpImage->GetRasterXSize();
+        unsigned int height = clumpImage->GetRasterYSize();
+        GDALRasterBand *clumpBand = clumpImage->GetRasterBand(band);
+
+        this->calcBorderLengths = calcBorderLengths;
+        this->maxFID = 0;
+        this->edges.clear();
+        this->compactSize = 16777216;
+
+        std::vector<unsigned int> row(width, 0);
+        std::vector<unsigned int> prevRow(width, 0);
+        rsgis_tqdm pbar;
+        for(unsigned int i = 0; i < height; ++i)
+        {
+            pbar.progress(i, height);
+            if(clumpBand->RasterIO(GF_Read, 0, i, width, 1, row.data(), width, 1, GDT_UInt32, 0, 0) != CE_None)
+            {
+                throw RSGISAttributeTableException("Could not read the clumps image.");
+            }
+            this->addRowEdges(row.data(), (i > 0)?prevRow.data():NULL, width);
+            row.swap(prevRow);
+        }
+        pbar.finish();
+
+        this->buildCSR();
+    }
+
+    void RSGISRegionAdjacencyGraph::buildFromLabels(const unsigned int *labels, unsigned int width, unsigned int height, bool calcBorderLengths)
+    {
+        this->calcBorderLengths = calcBorderLengths;
+        this->maxFID = 0;
+        this->edges.clear();
+        this->compactSize = 16777216;
+        for(unsigned int i = 0; i < height; ++i)
+        {
+            const unsigned int *row = &labels[((size_t)i)*width];
+            this->addRowEdges(row, (i > 0)?(row-width):NULL, width);
+        }
+        this->buildCSR();
+    }
+
+    void RSGISRegionAdjacencyGraph::addRowEdges(const unsigned int *row, const unsigned int *prevRow, unsigned int width)
+    {
+        // Horizontal then vertical so runs along a border are collapsed by addEdge.
+        for(unsigned int j = 0; j < width; ++j)
+        {
+            if(row[j] > this->maxFID)
+            {
+                this->maxFID = row[j];
+            }
+            if((j > 0) && (row[j] != 0) && (row[j-1] != 0) && (row[j] != row[j-1]))
+            {
+                this->addEdge(row[j-1], row[j]);
+            }
+        }
+        if(prevRow != NULL)
+        {
+            for(unsigned int j = 0; j < width; ++j)
+            {
+                if((row[j] != 0) && (prevRow[j] != 0) && (row[j] != prevRow[j]))
+                {
+                    this->addEdge(prevRow[j], row[j]);
+                }
+            }
+        }
+    }
+
+    void RSGISRegionAdjacencyGraph::addEdge(unsigned int fid1, unsigned int fid2)
+    {
+        uint64_t key = (fid1 < fid2)?((((uint64_t)fid1) << 32) | fid2):((((uint64_t)fid2) << 32) | fid1);
+        if((!this->edges.empty()) && (this->edges.back().first == key))
+        {
+            ++this->edges.back().second;
+            return;
+        }
+        this->edges.push_back(EdgeCount(key, 1));
+        if(this->edges.size() >= this->compactSize)
+        {
+            this->compactEdges();
+            // Keep the buffer at least half empty.
+            this->compactSize = std::max(this->compactSize, this->edges.size()*2);
+        }
+    }
+
+    void RSGISRegionAdjacencyGraph::compactEdges()
+    {
+        std::sort(this->edges.begin(), this->edges.end());
+        size_t outIdx = 0;
+        for(size_t i = 0; i < this->edges.size(); ++i)
+        {
+            if((outIdx > 0) && (this->edges[outIdx-1].first == this->edges[i].first))
+            {
+                this->edges[outIdx-1].second += this->edges[i].second;
+            }
+            else
+            {
+                this->edges[outIdx++] = this->edges[i];
+            }
+        }
+        this->edges.resize(outIdx);
+    }
+
+    void RSGISRegionAdjacencyGraph::buildCSR()
+    {
+        this->compactEdges();
+        this->numNodes = ((size_t)this->maxFID) + 1;
+
+        this->adjStart.assign(this->numNodes+1, 0);
+        for(std::vector<EdgeCount>::iterator iterEdge = this->edges.begin(); iterEdge != this->edges.end(); ++iterEdge)
+        {
+            ++this->adjStart[((*iterEdge).first >> 32)+1];
+            ++this->adjStart[((*iterEdge).first & 0xFFFFFFFF)+1];
+        }
+        for(size_t i = 1; i <= this->numNodes; ++i)
+        {
+            this->adjStart[i] += this->adjStart[i-1];
+        }
+
+        // The edges are sorted on (lower, upper) so each list is filled in ascending order.
+        this->adjacency.resize(this->adjStart[this->numNodes]);
+        this->borderLengths.clear();
+        if(this->calcBorderLengths)
+        {
+            this->borderLengths.resize(this->adjacency.size());
+        }
+        std::vector<size_t> fillIdx(this->adjStart.begin(), this->adjStart.end()-1);
+        for(std::vector<EdgeCount>::iterator iterEdge = this->edges.begin(); iterEdge != this->edges.end(); ++iterEdge)
+        {
+            unsigned int fid1 = (*iterEdge).first >> 32;
+            unsigned int fid2 = (*iterEdge).first & 0xFFFFFFFF;
+            if(this->calcBorderLengths)
+            {
+                this->borderLengths[fillIdx[fid1]] = (*iterEdge).second;
+                this->borderLengths[fillIdx[fid2]] = (*iterEdge).second;
+            }
+            this->adjacency[fillIdx[fid1]++] = fid2;
+            this->adjacency[fillIdx[fid2]++] = fid1;
+        }
+        std::vector<EdgeCount>().swap(this->edges);
+
+        this->resetMerges();
+    }
+
+    void RSGISRegionAdjacencyGraph::resetMerges()
+    {
+        this->mergedInto.resize(this->numNodes);
+        this->memberTail.resize(this->numNodes);
+        this->memberNext.assign(this->numNodes, 0);
+        for(size_t i = 0; i < this->numNodes; ++i)
+        {
+            this->mergedInto[i] = i;
+            this->memberTail[i] = i;
+        }
+    }
+
+    kealib::KEAAttributeTable* RSGISRegionAdjacencyGraph::getKEAAttributeTable(GDALDataset *clumpImage, unsigned int band)
+    {
+        void *internalData = clumpImage->GetInternalHandle("");
+        if(internalData == NULL)
+        {
+            throw RSGISAttributeTableException("Internal data on GDAL Dataset was NULL - check input file is KEA.");
+        }
+        kealib::KEAImageIO *keaImgIO = static_cast<kealib::KEAImageIO*>(internalData);
+        return keaImgIO->getAttributeTable(kealib::kea_att_file, band);
+    }
+
+    bool RSGISRegionAdjacencyGraph::readFromKEA(GDALDataset *clumpImage, unsigned int band)
+    {
+        // Read in blocks of rows so only one block of neighbour vectors is held at a time.
+        std::vector<std::vector<size_t>* > *neighbours = new std::vector<std::vector<size_t>* >();
+        try
+        {
+            kealib::KEAAttributeTable *keaAtt = this->getKEAAttributeTable(clumpImage, band);
+            if(!keaAtt->hasField("NumNeighbours"))
+            {
+                delete neighbours;
+                return false;
+            }
+            size_t numRows = keaAtt->getSize();
+
+            this->numNodes = numRows;
+            this->calcBorderLengths = false;
+            this->borderLengths.clear();
+            this->adjacency.clear();
+            this->adjStart.assign(this->numNodes+1, 0);
+            for(size_t startFID = 0; startFID < numRows; startFID += this->keaBlockSize)
+            {
+                size_t blockLen = std::min(this->keaBlockSize, numRows - startFID);
+                this->clearNeighbourVectors(neighbours);
+                keaAtt->getNeighbours(startFID, blockLen, neighbours);
+                for(size_t i = 0; i < blockLen; ++i)
+                {
+                    size_t fid = startFID + i;
+                    size_t blockStart = this->adjacency.size();
+                    if(i < neighbours->size())
+                    {
+                        this->adjacency.insert(this->adjacency.end(), neighbours->at(i)->begin(), neighbours->at(i)->end());
+                    }
+                    std::sort(this->adjacency.begin() + blockStart, this->adjacency.end());
+                    this->adjStart[fid+1] = this->adjacency.size();
+                }
+            }
+            std::vector<unsigned int>(this->adjacency).swap(this->adjacency);
+            this->resetMerges();
+        }
+        catch(RSGISAttributeTableException &e)
+        {
+            this->clearNeighbourVectors(neighbours);
+            delete neighbours;
+            throw e;
+        }
+        catch(kealib::KEAException &e)
+        {
+            this->clearNeighbourVectors(neighbours);
+            delete neighbours;
+            throw RSGISAttributeTableException(e.what());
+        }
+
+        this->clearNeighbourVectors(neighbours);
+        delete neighbours;
+        return true;
+    }
+
+    void RSGISRegionAdjacencyGraph::writeToKEA(GDALDataset *clumpImage, unsigned int band)
+    {
+        // Written in blocks of rows straight from the CSR arrays, so the
+        // neighbour vectors for only one block are held at a time.
+        std::vector<std::vector<size_t>* > *neighbours = new std::vector<std::vector<size_t>* >();
+        int64_t *numNeighbours = NULL;
+        try
+        {
+            kealib::KEAAttributeTable *keaAtt = this->getKEAAttributeTable(clumpImage, band);
+            size_t numRows = keaAtt->getSize();
+            if(numRows < this->numNodes)
+            {
+                throw RSGISAttributeTableException("The RAT has fewer rows than the number of clumps in the graph.");
+            }
+
+            if(!keaAtt->hasField("NumNeighbours"))
+            {
+                keaAtt->addAttIntField("NumNeighbours", 0, "");
+            }
+            size_t numNeighboursIdx = keaAtt->getFieldIndex("NumNeighbours");
+
+            numNeighbours = new int64_t[std::min(this->keaBlockSize, numRows)];
+            for(size_t startFID = 0; startFID < numRows; startFID += this->keaBlockSize)
+            {
+                size_t blockLen = std::min(this->keaBlockSize, numRows - startFID);
+                this->clearNeighbourVectors(neighbours);
+                neighbours->reserve(blockLen);
+                for(size_t i = 0; i < blockLen; ++i)
+                {
+                    size_t fid = startFID + i;
+                    if(fid < this->numNodes)
+                    {
+                        neighbours->push_back(new std::vector<size_t>(this->adjacency.begin()+this->adjStart[fid], this->adjacency.begin()+this->adjStart[fid+1]));
+                    }
+                    else
+                    {
+                        neighbours->push_back(new std::vector<size_t>());
+                    }
+                    numNeighbours[i] = neighbours->back()->size();
+                }
+                keaAtt->setNeighbours(startFID, blockLen, neighbours);
+                keaAtt->setIntFields(startFID, blockLen, numNeighboursIdx, numNeighbours);
+            }
+        }
+        catch(RSGISAttributeTableException &e)
+        {
+            this->clearNeighbourVectors(neighbours);
+            delete neighbours;
+            delete[] numNeighbours;
+            throw e;
+        }
+        catch(kealib::KEAException &e)
+        {
+            this->clearNeighbourVectors(neighbours);
+            delete neighbours;
+            delete[] numNeighbours;
+            throw RSGISAttributeTableException(e.what());
+        }
+
+        this->clearNeighbourVectors(neighbours);
+        delete neighbours;
+        delete[] numNeighbours;
+    }
+
+    void RSGISRegionAdjacencyGraph::clearNeighbourVectors(std::vector<std::vector<size_t>* > *neighbours)
+    {
+        for(std::vector<std::vector<size_t>* >::iterator iterClumps = neighbours->begin(); iterClumps != neighbours->end(); ++iterClumps)
+        {
+            delete *iterClumps;
+        }
+        neighbours->clear();
+    }
+
+    void RSGISRegionAdjacencyGraph::readOrBuild(GDALDataset *clumpImage, unsigned int band, bool cache)
+    {
+        bool isKEA = false;
+        if(clumpImage->GetDriver() != NULL)
+        {
+            isKEA = (std::string(clumpImage->GetDriver()->GetDescription()) == "KEA");
+        }
+        if(isKEA && this->readFromKEA(clumpImage, band))
+        {
+            std::cout << "Read the clump neighbours from the KEA file.\n";
+            return;
+        }
+        this->buildFromClumps(clumpImage, band, false);
+        if(isKEA && cache)
+        {
+            this->writeToKEA(clumpImage, band);
+        }
+    }
+
+    std::vector<std::vector<size_t>* >* RSGISRegionAdjacencyGraph::getNeighbourVectors() const
+    {
+        std::vector<std::vector<size_t>* > *neighbours = new std::vector<std::vector<size_t>* >();
+        neighbours->reserve(this->numNodes);
+        for(size_t i = 0; i < this->numNodes; ++i)
+        {
+            neighbours->push_back(new std::vector<size_t>(this->adjacency.begin()+this->adjStart[i], this->adjacency.begin()+this->adjStart[i+1]));
+        }
+        return neighbours;
+    }
+
+    void RSGISRegionAdjacencyGraph::mergeNodes(size_t fid, size_t intoFID)
+    {
+        if((fid >= this->numNodes) || (intoFID >= this->numNodes))
+        {
+            throw RSGISAttributeTableException("Node is not within the region adjacency graph.");
+        }
+        if((fid == 0) || (intoFID == 0))
+        {
+            throw RSGISAttributeTableException("Node 0 (no data) cannot be merged.");
+        }
+        if((this->mergedInto[fid] != fid) || (this->mergedInto[intoFID] != intoFID))
+        {
+            throw RSGISAttributeTableException("Nodes can only be merged if they have not been merged into another node.");
+        }
+        if(fid == intoFID)
+        {
+            return;
+        }
+        this->mergedInto[fid] = intoFID;
+        this->memberNext[this->memberTail[intoFID]] = fid;
+        this->memberTail[intoFID] = this->memberTail[fid];
+    }
+
+    size_t RSGISRegionAdjacencyGraph::findMergedNode(size_t fid)
+    {
+        // Path halving
+        while(this->mergedInto[fid] != fid)
+        {
+            this->mergedInto[fid] = this->mergedInto[this->mergedInto[fid]];
+            fid = this->mergedInto[fid];
+        }
+        return fid;
+    }
+
+    void RSGISRegionAdjacencyGraph::getMergedNeighbours(size_t fid, std::vector<size_t> *neighbours, std::vector<size_t> *borders)
+    {
+        fid = this->findMergedNode(fid);
+        bool useBorders = (borders != NULL) && this->hasBorderLengths();
+        std::vector<std::pair<size_t, size_t> > nbrs;
+        // Node 0 is never a member of another node so ends the list of members.
+        for(size_t m = fid; ; m = this->memberNext[m])
+        {
+            for(size_t e = this->adjStart[m]; e < this->adjStart[m+1]; ++e)
+            {
+                size_t nID = this->findMergedNode(this->adjacency[e]);
+                if(nID != fid)
+                {
+                    nbrs.push_back(std::pair<size_t, size_t>(nID, useBorders?this->borderLengths[e]:0));
+                }
+            }
+            if(this->memberNext[m] == 0)
+            {
+                break;
+            }
+        }
+        std::sort(nbrs.begin(), nbrs.end());
+
+        neighbours->clear();
+        if(borders != NULL)
+        {
+            borders->clear();
+        }
+        for(std::vector<std::pair<size_t, size_t> >::iterator iterNbr = nbrs.begin(); iterNbr != nbrs.end(); ++iterNbr)
+        {
+            if(neighbours->empty() || (neighbours->back() != (*iterNbr).first))
+            {
+                neighbours->push_back((*iterNbr).first);
+                if(borders != NULL)
+                {
+                    borders->push_back((*iterNbr).second);
+                }
+            }
+            else if(borders != NULL)
+            {
+                borders->back() += (*iterNbr).second;
+            }
+        }
+    }
+
+    RSGISRegionAdjacencyGraph::~RSGISRegionAdjacencyGraph()
+    {
+
+    }
+
+}}
+
@@ -0,0 +1,153 @@
+/*
+ *  RSGISRegionAdjacencyGraph.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISRegionAdjacencyGraph_H
+#define RSGISRegionAdjacencyGraph_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+
+#include "gdal_priv.h"
+
+#include "libkea/KEAImageIO.h"
+
+#include "common/RSGISAttributeTableException.h"
+#include "common/rsgis-tqdm.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_rastergis_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace rastergis{
+
+    /**
+     * The 4-connected region adjacency graph of a clumps image. Nodes are the
+     * clump IDs (RAT rows, 0 is no data and has no neighbours) and the
+     * neighbours of each node are held, sorted, in compressed sparse row form.
+     * Optionally the length (number of pixel edges) of the border shared with
+     * each neighbour is held.
+     *
+     * The graph is built with one pass over the rows of the image and can be
+     * cached in, and read back from, the neighbours table of a KEA file (the
+     * same table as RSGISFindClumpNeighbours::findNeighboursKEAImageCalc).
+     * Border lengths are not stored in the KEA file.
+     *
+     * Nodes can be merged, after which getMergedNeighbours gives the neighbours
+     * of the merged node; merges are recorded with a union-find so the adjacency
+     * is never rebuilt.
+     */
+    class DllExport RSGISRegionAdjacencyGraph
+    {
+    public:
+        RSGISRegionAdjacencyGraph();
+        /**
+         * Build the graph from band of clumpImage.
+         */
+        void buildFromClumps(GDALDataset *clumpImage, unsigned int band, bool calcBorderLengths=false);
+        /**
+         * Build the graph from clump labels held in memory (width x height, row major).
+         */
+        void buildFromLabels(const unsigned int *labels, unsigned int width, unsigned int height, bool calcBorderLengths=false);
+        /**
+         * Read the graph from the neighbours table of a KEA file. Returns false
+         * if the neighbours have not been calculated for the band.
+         */
+        bool readFromKEA(GDALDataset *clumpImage, unsigned int band);
+        /**
+         * Write the graph to the neighbours table (and NumNeighbours column) of a KEA file.
+         */
+        void writeToKEA(GDALDataset *clumpImage, unsigned int band);
+        /**
+         * Read the graph from the KEA file if it has been cached there, otherwise
+         * build it from the image and, if cache is true, write it to the file.
+         */
+        void readOrBuild(GDALDataset *clumpImage, unsigned int band, bool cache=true);
+
+        size_t getNumNodes() const {return numNodes;};
+        size_t getNumEdges() const {return adjacency.size()/2;};
+        bool hasBorderLengths() const {return !borderLengths.empty();};
+        size_t getNumNeighbours(size_t fid) const {return adjStart[fid+1] - adjStart[fid];};
+        /**
+         * The neighbours of a node (before any merges), getNumNeighbours(fid) values.
+         */
+        const unsigned int* getNeighbours(size_t fid) const {return adjacency.data() + adjStart[fid];};
+        /**
+         * The border lengths for the neighbours of a node, if hasBorderLengths().
+         */
+        const unsigned int* getBorderLengths(size_t fid) const {return borderLengths.data() + adjStart[fid];};
+        /**
+         * The neighbours of each node in the form used by the KEA neighbours table.
+         */
+        std::vector<std::vector<size_t>* >* getNeighbourVectors() const;
+
+        /**
+         * Merge node fid into node intoFID (both must not already have been merged into another node).
+         */
+        void mergeNodes(size_t fid, size_t intoFID);
+        /**
+         * The node which fid has been merged into (itself if not merged).
+         */
+        size_t findMergedNode(size_t fid);
+        /**
+         * The sorted neighbours of the merged node fid and, if available and
+         * borders is not NULL, the total border length with each of them.
+         */
+        void getMergedNeighbours(size_t fid, std::vector<size_t> *neighbours, std::vector<size_t> *borders=NULL);
+        ~RSGISRegionAdjacencyGraph();
+    protected:
+        typedef std::pair<uint64_t, unsigned int> EdgeCount;
+        void addEdge(unsigned int fid1, unsigned int fid2);
+        void addRowEdges(const unsigned int *row, const unsigned int *prevRow, unsigned int width);
+        void compactEdges();
+        void buildCSR();
+        void resetMerges();
+        kealib::KEAAttributeTable* getKEAAttributeTable(GDALDataset *clumpImage, unsigned int band);
+        void clearNeighbourVectors(std::vector<std::vector<size_t>* > *neighbours);
+        size_t numNodes;
+        size_t keaBlockSize;
+        bool calcBorderLengths;
+        size_t compactSize;
+        unsigned int maxFID;
+        std::vector<EdgeCount> edges;
+        std::vector<size_t> adjStart;
+        std::vector<unsigned int> adjacency;
+        std::vector<unsigned int> borderLengths;
+        std::vector<size_t> mergedInto;
+        std::vector<size_t> memberNext;
+        std::vector<size_t> memberTail;
+    };
+
+}}
+
+#endif
+
@@ -381,6 +381,106 @@ namespace rsgis{namespace rastergis{
     
     
     
+    RSGISClassColumnStream::RSGISClassColumnStream(GDALRasterAttributeTable *rat, std::string varCol, bool classRestrict, std::string classColumn, std::string classVal)
+    {
+        RSGISRasterAttUtils ratUtils;
+        this->rat = rat;
+        this->varColIdx = ratUtils.findColumnIndex(rat, varCol);
+        this->classRestrict = classRestrict;
+        this->classColIdx = 0;
+        if(classRestrict)
+        {
+            this->classColIdx = ratUtils.findColumnIndex(rat, classColumn);
+        }
+        this->classVal = classVal;
+    }
+    
+    void RSGISClassColumnStream::streamValues(std::function<void(size_t startRow, size_t numBlockRows, const size_t *fids, const double *vals, size_t numVals)> processBlock)
+    {
+        size_t numRows = this->rat->GetRowCount();
+        std::vector<double> blockVals(RAT_BLOCK_LENGTH);
+        std::vector<char*> blockClasses(RAT_BLOCK_LENGTH, NULL);
+        std::vector<size_t> fids(RAT_BLOCK_LENGTH);
+        std::vector<double> vals(RAT_BLOCK_LENGTH);
+        for(size_t startRow = 0; startRow < numRows; startRow += RAT_BLOCK_LENGTH)
+        {
+            size_t nBlockRows = std::min<size_t>(RAT_BLOCK_LENGTH, numRows - startRow);
+            if(this->rat->ValuesIO(GF_Read, this->varColIdx, startRow, nBlockRows, blockVals.data()) != CE_None)
+            {
+                throw RSGISAttributeTableException("Failed to read a chunk of the RAT.");
+            }
+            if(this->classRestrict)
+            {
+                if(this->rat->ValuesIO(GF_Read, this->classColIdx, startRow, nBlockRows, blockClasses.data()) != CE_None)
+                {
+                    throw RSGISAttributeTableException("Failed to read a chunk of the RAT.");
+                }
+            }
+            
+            size_t numVals = 0;
+            for(size_t j = ((startRow == 0)?1:0); j < nBlockRows; ++j)
+            {
+                if((!this->classRestrict) || (this->classVal == blockClasses[j]))
+                {
+                    fids[numVals] = startRow + j;
+                    vals[numVals] = blockVals[j];
+                    ++numVals;
+                }
+            }
+            
+            // The strings returned by ValuesIO are owned by the caller.
+            if(this->classRestrict)
+            {
+                for(size_t j = 0; j < nBlockRows; ++j)
+                {
+                    CPLFree(blockClasses[j]);
+                    blockClasses[j] = NULL;
+                }
+            }
+            
+            processBlock(startRow, nBlockRows, fids.data(), vals.data(), numVals);
+        }
+    }
+    
+    void RSGISClassColumnStream::calcMinMax(double *minVal, double *maxVal, size_t *numVals)
+    {
+        *minVal = 0.0;
+        *maxVal = 0.0;
+        *numVals = 0;
+        this->streamValues([minVal, maxVal, numVals](size_t startRow, size_t numBlockRows, const size_t *fids, const double *vals, size_t numBlockVals)
+        {
+            for(size_t i = 0; i < numBlockVals; ++i)
+            {
+                if((*numVals) == 0)
+                {
+                    *minVal = vals[i];
+                    *maxVal = vals[i];
+                }
+                else if(vals[i] < (*minVal))
+                {
+                    *minVal = vals[i];
+                }
+                else if(vals[i] > (*maxVal))
+                {
+                    *maxVal = vals[i];
+                }
+                ++(*numVals);
+            }
+        });
+    }
+    
+    void RSGISClassColumnStream::calcBinIdxs(const double *vals, size_t numVals, double minVal, double binWidth, size_t numBins, size_t *binIdxs)
+    {
+        double numBinsVal = numBins;
+        for(size_t i = 0; i < numVals; ++i)
+        {
+            double binPos = (vals[i] - minVal) / binWidth;
+            binIdxs[i] = ((binPos >= 0) && (binPos < numBinsVal))?static_cast<size_t>(binPos):numBins;
+        }
+    }
+    
+    
+    
     RSGISStatsSamplingClumps::RSGISStatsSamplingClumps()
     {
         
@@ -390,64 +490,96 @@ namespace rsgis{namespace rastergis{
     {
         try
         {
-            std::cout << "Import attribute tables to memory.\n";
-            GDALRasterAttributeTable *gdalRAT = clumpsDataset->GetRasterBand(1)->GetDefaultRAT();
+            GDALRasterAttributeTable *gdalRAT = clumpsDataset->GetRasterBand(ratBand)->GetDefaultRAT();
             size_t numClumps = gdalRAT->GetRowCount();
             
-            
             RSGISRasterAttUtils ratUtils;
-            rsgis::math::RSGISMathsUtils mathUtils;
-            
-            unsigned int varColIdx = ratUtils.findColumnIndex(gdalRAT, varCol);
-            unsigned int classNamesColIdx = 0;
+            RSGISClassColumnStream colStream(gdalRAT, varCol, classRestrict, classColumn, classVal);
             
             double minVal = 0.0;
             double maxVal = 0.0;
             size_t numVals = 0;
-            
-            RSGISCalcClassMinMax calcMinMaxStats = RSGISCalcClassMinMax(classRestrict, classVal, &minVal, &maxVal, &numVals);
-            RSGISRATCalc ratCalcMinMax = RSGISRATCalc(&calcMinMaxStats);
-            std::vector<unsigned int> inRealColIdx;
-            inRealColIdx.push_back(varColIdx);
-            std::vector<unsigned int> inIntColIdx;
-            std::vector<unsigned int> inStrColIdx;
-            if(classRestrict)
-            {
-                classNamesColIdx = ratUtils.findColumnIndex(gdalRAT, classColumn);
-                inStrColIdx.push_back(classNamesColIdx);
-            }
-            std::vector<unsigned int> outRealColIdx;
-            std::vector<unsigned int> outIntColIdx;
-            std::vector<unsigned int> outStrColIdx;
-            ratCalcMinMax.calcRATValues(gdalRAT, inRealColIdx, inIntColIdx, inStrColIdx, outRealColIdx, outIntColIdx, outStrColIdx);
+            colStream.calcMinMax(&minVal, &maxVal, &numVals);
             
             std::cout << "DATA [" << minVal << ", " << maxVal << "]: " << (maxVal-minVal) << "\t Num Vals = " << numVals << "\n";
             
-            std::vector<std::pair<size_t, double> > *dataPairs = new std::vector<std::pair<size_t, double> >();
-            dataPairs->reserve(numVals);
-            
-            RSGISCalcGenVecPairs genVecPairs = RSGISCalcGenVecPairs(classRestrict, classVal, dataPairs);
-            RSGISRATCalc ratGenVecPairs = RSGISRATCalc(&genVecPairs);
-            ratGenVecPairs.calcRATValues(gdalRAT, inRealColIdx, inIntColIdx, inStrColIdx, outRealColIdx, outIntColIdx, outStrColIdx);
-            
-            std::vector<std::pair<size_t, double> > *selClumps = mathUtils.sampleUseHistogramMethod(dataPairs, minVal, maxVal, binWidth, propOfSample);
-            delete dataPairs;
-            
-            unsigned int outFieldIdx = ratUtils.findColumnIndexOrCreate(gdalRAT, outSelectCol, GFT_Integer);
-            
-            int *outSelectData = new int[numClumps];
-            for(size_t i = 0; i < numClumps; ++i)
+            // Count the values in each bin.
+            size_t numBins = static_cast<size_t>((maxVal - minVal)/binWidth)+1;
+            std::vector<size_t> binCounts(numBins+1, 0);
+            std::vector<size_t> binIdxs(RAT_BLOCK_LENGTH);
+            colStream.streamValues([&binCounts, &binIdxs, minVal, binWidth, numBins](size_t startRow, size_t numBlockRows, const size_t *fids, const double *vals, size_t numBlockVals)
             {
-                outSelectData[i] = 0;
+                RSGISClassColumnStream::calcBinIdxs(vals, numBlockVals, minVal, binWidth, numBins, binIdxs.data());
+                for(size_t i = 0; i < numBlockVals; ++i)
+                {
+                    ++binCounts[binIdxs[i]];
+                }
+            });
+            
+            // One in every sampleStep values of each bin is selected, using a
+            // reservoir for each bin (with a fixed seed so runs are repeatable).
+            size_t sampleStep = std::max<size_t>(static_cast<size_t>(1/propOfSample), 1);
+            std::vector<size_t> sampleSizes(numBins);
+            std::vector<size_t> binSeen(numBins, 0);
+            std::vector<std::vector<size_t> > reservoirs(numBins);
+            for(size_t i = 0; i < numBins; ++i)
+            {
+                sampleSizes[i] = (binCounts[i] + sampleStep - 1) / sampleStep;
+                reservoirs[i].reserve(sampleSizes[i]);
             }
+            std::mt19937_64 rng(5489u);
+            colStream.streamValues([&](size_t startRow, size_t numBlockRows, const size_t *fids, const double *vals, size_t numBlockVals)
+            {
+                RSGISClassColumnStream::calcBinIdxs(vals, numBlockVals, minVal, binWidth, numBins, binIdxs.data());
+                for(size_t i = 0; i < numBlockVals; ++i)
+                {
+                    size_t bin = binIdxs[i];
+                    if(bin == numBins)
+                    {
+                        continue;
+                    }
+                    size_t seen = binSeen[bin]++;
+                    if(seen < sampleSizes[bin])
+                    {
+                        reservoirs[bin].push_back(fids[i]);
+                    }
+                    else
+                    {
+                        size_t j = std::uniform_int_distribution<size_t>(0, seen)(rng);
+                        if(j < sampleSizes[bin])
+                        {
+                            reservoirs[bin][j] = fids[i];
+                        }
+                    }
+                }
+            });
             
-            for(std::vector<std::pair<size_t, double> >::iterator iterClumps = selClumps->begin(); iterClumps != selClumps->end(); ++iterClumps)
+            std::vector<size_t> selFIDs;
+            for(size_t i = 0; i < numBins; ++i)
             {
-                outSelectData[(*iterClumps).first] = 1;
+                selFIDs.insert(selFIDs.end(), reservoirs[i].begin(), reservoirs[i].end());
+                std::vector<size_t>().swap(reservoirs[i]);
             }
-            delete selClumps;
+            std::sort(selFIDs.begin(), selFIDs.end());
+            std::cout << "Selected " << selFIDs.size() << " clumps.\n";
             
-            gdalRAT->ValuesIO(GF_Write, outFieldIdx, 0, numClumps, outSelectData);
+            // Write the selection a block at a time.
+            unsigned int outFieldIdx = ratUtils.findColumnIndexOrCreate(gdalRAT, outSelectCol, GFT_Integer);
+            std::vector<int> outSelectData(RAT_BLOCK_LENGTH);
+            std::vector<size_t>::iterator iterSel = selFIDs.begin();
+            for(size_t startRow = 0; startRow < numClumps; startRow += RAT_BLOCK_LENGTH)
+            {
+                size_t nBlockRows = std::min<size_t>(RAT_BLOCK_LENGTH, numClumps - startRow);
+                std::fill(outSelectData.begin(), outSelectData.end(), 0);
+                for(; (iterSel != selFIDs.end()) && ((*iterSel) < (startRow + nBlockRows)); ++iterSel)
+                {
+                    outSelectData[(*iterSel) - startRow] = 1;
+                }
+                if(gdalRAT->ValuesIO(GF_Write, outFieldIdx, startRow, nBlockRows, outSelectData.data()) != CE_None)
+                {
+                    throw RSGISAttributeTableException("Failed to write a chunk of the RAT.");
+                }
+            }
         }
         catch(rsgis::RSGISAttributeTableException &e)
         {
@@ -603,55 +735,39 @@ namespace rsgis{namespace rastergis{
     {
         try
         {
-            std::cout << "Import attribute tables to memory.\n";
-            GDALRasterAttributeTable *gdalRAT = clumpsDataset->GetRasterBand(1)->GetDefaultRAT();
-            
-            size_t ratLen = gdalRAT->GetRowCount();
+            GDALRasterAttributeTable *gdalRAT = clumpsDataset->GetRasterBand(ratBand)->GetDefaultRAT();
             
             RSGISRasterAttUtils ratUtils;
-            rsgis::math::RSGISMathsUtils mathUtils;
-            
-            unsigned int varColIdx = ratUtils.findColumnIndex(gdalRAT, varCol);
-            unsigned int classNamesColIdx = ratUtils.findColumnIndex(gdalRAT, classColumn);
+            RSGISClassColumnStream colStream(gdalRAT, varCol, true, classColumn, classVal);
             
             double minVal = 0.0;
             double maxVal = 0.0;
             size_t numVals = 0;
             
             std::cout << "Calculate Min / Max.\n";
-            RSGISCalcClassMinMax calcMinMaxStats = RSGISCalcClassMinMax(true, classVal, &minVal, &maxVal, &numVals);
-            RSGISRATCalc ratCalcMinMax = RSGISRATCalc(&calcMinMaxStats);
-            std::vector<unsigned int> inRealColIdx;
-            inRealColIdx.push_back(varColIdx);
-            std::vector<unsigned int> inIntColIdx;
-            std::vector<unsigned int> inStrColIdx;
-            classNamesColIdx = ratUtils.findColumnIndex(gdalRAT, classColumn);
-            inStrColIdx.push_back(classNamesColIdx);
-            std::vector<unsigned int> outRealColIdx;
-            std::vector<unsigned int> outIntColIdx;
-            std::vector<unsigned int> outStrColIdx;
-            ratCalcMinMax.calcRATValues(gdalRAT, inRealColIdx, inIntColIdx, inStrColIdx, outRealColIdx, outIntColIdx, outStrColIdx);
+            colStream.calcMinMax(&minVal, &maxVal, &numVals);
             
             std::cout << "DATA [" << minVal << ", " << maxVal << "]: " << (maxVal-minVal) << "\t Num Vals = " << numVals << "\n";
             
-            std::vector<std::pair<size_t, double> > *dataPairs = new std::vector<std::pair<size_t, double> >();
-            dataPairs->reserve(numVals);
-            
-            std::cout << "Reading in the data.\n";
-            RSGISCalcGenVecPairs genVecPairs = RSGISCalcGenVecPairs(true, classVal, dataPairs);
-            RSGISRATCalc ratGenVecPairs = RSGISRATCalc(&genVecPairs);
-            ratGenVecPairs.calcRATValues(gdalRAT, inRealColIdx, inIntColIdx, inStrColIdx, outRealColIdx, outIntColIdx, outStrColIdx);
-            
-            size_t numBins = 0;
-            std::vector<std::pair<size_t, double> > **pairsHist = mathUtils.calcHistogram(dataPairs, minVal, maxVal, binWidth, &numBins);
-            delete dataPairs;
+            std::cout << "Calculate the histogram.\n";
+            size_t numBins = static_cast<size_t>((maxVal - minVal)/binWidth)+1;
+            std::vector<size_t> binCounts(numBins+1, 0);
+            std::vector<size_t> binIdxs(RAT_BLOCK_LENGTH);
+            colStream.streamValues([&binCounts, &binIdxs, minVal, binWidth, numBins](size_t startRow, size_t numBlockRows, const size_t *fids, const double *vals, size_t numBlockVals)
+            {
+                RSGISClassColumnStream::calcBinIdxs(vals, numBlockVals, minVal, binWidth, numBins, binIdxs.data());
+                for(size_t i = 0; i < numBlockVals; ++i)
+                {
+                    ++binCounts[binIdxs[i]];
+                }
+            });
             
             std::vector<std::pair<double, double> > *hist = new std::vector<std::pair<double, double> >();
             double binCentre = minVal + (binWidth/2);
             double *binVals = new double[numBins];
             for(size_t i = 0; i < numBins; ++i)
             {
-                hist->push_back(std::pair<double, double>(binCentre, (((double)pairsHist[i]->size())/numVals)));
+                hist->push_back(std::pair<double, double>(binCentre, (((double)binCounts[i])/numVals)));
                 binVals[i] = binCentre;
                 binCentre += binWidth;
             }
@@ -733,23 +849,25 @@ namespace rsgis{namespace rastergis{
                 }
             }
             
+            // Write the sub-class of each row of the class a block at a time.
             unsigned int subClassesColIdx = ratUtils.findColumnIndexOrCreate(gdalRAT, outCol, GFT_Integer);
-            
-            int *dataPtClass = new int[ratLen];
-            for(unsigned int i = 0; i < ratLen; ++i)
+            std::vector<int> dataPtClass(RAT_BLOCK_LENGTH);
+            colStream.streamValues([&](size_t startRow, size_t numBlockRows, const size_t *fids, const double *vals, size_t numBlockVals)
             {
-                dataPtClass[i] = -1;
-            }
-            
-            for(unsigned int i = 0; i < hist->size(); ++i)
-            {
-                for(std::vector<std::pair<size_t, double> >::iterator iterHistBin = pairsHist[i]->begin(); iterHistBin != pairsHist[i]->end(); ++iterHistBin)
+                std::fill(dataPtClass.begin(), dataPtClass.end(), -1);
+                RSGISClassColumnStream::calcBinIdxs(vals, numBlockVals, minVal, binWidth, numBins, binIdxs.data());
+                for(size_t i = 0; i < numBlockVals; ++i)
+                {
+                    if(binIdxs[i] < numBins)
+                    {
+                        dataPtClass[fids[i] - startRow] = outGMMClass[binIdxs[i]];
+                    }
+                }
+                if(gdalRAT->ValuesIO(GF_Write, subClassesColIdx, startRow, numBlockRows, dataPtClass.data()) != CE_None)
                 {
-                    dataPtClass[(*iterHistBin).first] = outGMMClass[i];
+                    throw RSGISAttributeTableException("Failed to write a chunk of the RAT.");
                 }
-            }
-            
-            gdalRAT->ValuesIO(GF_Write, subClassesColIdx, 0, ratLen, dataPtClass);
+            });
             std::cout << "Exported subclasses to RAT.\n";
             
             
@@ -757,17 +875,11 @@ namespace rsgis{namespace rastergis{
             {
                 delete[] outGaussians[i];
             }
-            delete[] dataPtClass;
             delete[] outGaussians;
             delete[] outGMM;
             delete[] outGMMClass;
             delete[] binVals;
             delete hist;
-            for(size_t i = 0; i < numBins; ++i)
-            {
-                delete pairsHist[i];
-            }
-            delete[] pairsHist;
             std::cout << "Completed.\n";
         }
         catch(rsgis::RSGISAttributeTableException &e)
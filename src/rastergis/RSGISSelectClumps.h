@@ -30,6 +30,8 @@
 #include <list>
 #include <vector>
 #include <algorithm>
+#include <functional>
+#include <random>
 
 #include "common/RSGISAttributeTableException.h"
 
@@ -128,6 +130,46 @@ namespace rsgis{namespace rastergis{
     
     
     
+    /**
+     * Streams a real column of the RAT, for all the rows or only those of one
+     * class, in blocks of RAT_BLOCK_LENGTH rows so the column is never held
+     * in memory as a whole. Row 0 is skipped.
+     */
+    class DllExport RSGISClassColumnStream
+    {
+    public:
+        RSGISClassColumnStream(GDALRasterAttributeTable *rat, std::string varCol, bool classRestrict=false, std::string classColumn="", std::string classVal="");
+        /**
+         * For each block of the RAT, processBlock is called with the block's
+         * first row and number of rows and the FIDs and values of its rows
+         * within the class.
+         */
+        void streamValues(std::function<void(size_t startRow, size_t numBlockRows, const size_t *fids, const double *vals, size_t numVals)> processBlock);
+        /**
+         * The minimum, maximum and number of the values within the class.
+         */
+        void calcMinMax(double *minVal, double *maxVal, size_t *numVals);
+        /**
+         * The bin of each value for numBins bins binWidth wide from minVal;
+         * values outside of the bins (or NaN) are given numBins.
+         */
+        static void calcBinIdxs(const double *vals, size_t numVals, double minVal, double binWidth, size_t numBins, size_t *binIdxs);
+        ~RSGISClassColumnStream(){};
+    protected:
+        GDALRasterAttributeTable *rat;
+        unsigned int varColIdx;
+        bool classRestrict;
+        unsigned int classColIdx;
+        std::string classVal;
+    };
+    
+    
+    /**
+     * Selects a sample of propOfSample of the clumps from each bin of the
+     * histogram of varCol, picked at random within the bin (reservoir
+     * sampling while streaming the column) so memory depends only on the
+     * number of bins and the size of the sample.
+     */
     class DllExport RSGISStatsSamplingClumps
     {
     public:
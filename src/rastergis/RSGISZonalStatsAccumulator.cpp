@@ -0,0 +1,407 @@
+/*
+ *  RSGISZonalStatsAccumulator.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISZonalStatsAccumulator.h"
+
+namespace rsgis{namespace rastergis{
+
+    const size_t RSGISZonalStatsAccumulator::groupRows = 64;
+    const size_t RSGISZonalStatsAccumulator::maxGroupedBytes = 1048576;
+
+    RSGISZonalStatsAccumulator::RSGISZonalStatsAccumulator(size_t numZones)
+    {
+        this->numZones = numZones;
+        this->numBands = 0;
+        this->numThreads = rsgis::utils::getNumThreads();
+        this->numBins = 0;
+        this->histMin = 0;
+        this->histMax = 0;
+        this->useNoData = false;
+        this->noDataVal = 0;
+    }
+
+    void RSGISZonalStatsAccumulator::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+
+    void RSGISZonalStatsAccumulator::setHistogram(unsigned int numBins, double histMin, double histMax)
+    {
+        if((numBins > 0) && (histMax <= histMin))
+        {
+            throw RSGISAttributeTableException("The histogram maximum must be greater than the minimum.");
+        }
+        this->numBins = numBins;
+        this->histMin = histMin;
+        this->histMax = histMax;
+    }
+
+    void RSGISZonalStatsAccumulator::setImageNoData(bool useNoData, float noDataVal)
+    {
+        this->useNoData = useNoData;
+        this->noDataVal = noDataVal;
+    }
+
+    void RSGISZonalStatsAccumulator::calcZoneStats(GDALDataset *zonesImage, unsigned int zonesBand, GDALDataset *valsImage)
+    {
+        if((zonesBand == 0) || (zonesBand > ((unsigned int)zonesImage->GetRasterCount())))
+        {
+            throw RSGISAttributeTableException("The zones band is not within the zones image.");
+        }
+        this->numBands = valsImage->GetRasterCount();
+
+        GDALDataset **datasets = new GDALDataset*[2];
+        datasets[0] = zonesImage;
+        datasets[1] = valsImage;
+        int **dsOffsets = new int*[2];
+        dsOffsets[0] = new int[2];
+        dsOffsets[1] = new int[2];
+        int width = 0;
+        int height = 0;
+        int xBlockSize = 0;
+        int yBlockSize = 0;
+        double gdalTransform[6];
+        rsgis::img::RSGISImageUtils imgUtils;
+        try
+        {
+            imgUtils.getImageOverlap(datasets, 2, dsOffsets, &width, &height, gdalTransform, &xBlockSize, &yBlockSize);
+        }
+        catch(rsgis::RSGISException &e)
+        {
+            delete[] dsOffsets[0];
+            delete[] dsOffsets[1];
+            delete[] dsOffsets;
+            delete[] datasets;
+            throw RSGISAttributeTableException(e.what());
+        }
+        int zonesXOff = dsOffsets[0][0];
+        int zonesYOff = dsOffsets[0][1];
+        int valsXOff = dsOffsets[1][0];
+        int valsYOff = dsOffsets[1][1];
+        delete[] dsOffsets[0];
+        delete[] dsOffsets[1];
+        delete[] dsOffsets;
+        delete[] datasets;
+
+        GDALRasterBand *zonesRasterBand = zonesImage->GetRasterBand(zonesBand);
+        std::vector<GDALRasterBand*> valsBands(this->numBands);
+        for(unsigned int n = 0; n < this->numBands; ++n)
+        {
+            valsBands[n] = valsImage->GetRasterBand(n+1);
+        }
+
+        // The partitioning depends only on the image and zones, not the number
+        // of threads, so the statistics are the same however they are run.
+        bool groupRowsMode = ((this->numZones * this->numBands * (sizeof(RSGISZoneBandStats) + (this->numBins * sizeof(uint32_t)))) <= maxGroupedBytes);
+        size_t numGroups = (((size_t)height) + groupRows - 1) / groupRows;
+        rsgis::RSGISTreeReduction<RSGISZoneStatsPart> reduction(std::max<size_t>(numGroups, 1), [this](RSGISZoneStatsPart &left, RSGISZoneStatsPart &right)
+        {
+            this->mergeStats(left, right);
+        });
+        if(!groupRowsMode)
+        {
+            this->initStats(&this->stats);
+            this->hists.clear();
+            if(this->numBins > 0)
+            {
+                this->hists.assign(this->numZones * this->numBands * this->numBins, 0);
+            }
+        }
+
+        // Read strips of whole blocks (and groups of rows), at least enough to share between the threads.
+        size_t stripGroups = std::max<size_t>((std::max<size_t>(yBlockSize, 1) + groupRows - 1) / groupRows, groupRowsMode?this->numThreads:1);
+        size_t stripRows = stripGroups * groupRows;
+        if(!groupRowsMode)
+        {
+            stripRows = std::max<size_t>(std::max(yBlockSize, 1), this->numThreads);
+        }
+        std::vector<double> zoneVals(stripRows * width);
+        std::vector<float> vals(stripRows * width * this->numBands);
+        rsgis::utils::RSGISWorkerPool pool(this->numThreads);
+        rsgis_tqdm pbar;
+        for(size_t stripStart = 0; stripStart < ((size_t)height); stripStart += stripRows)
+        {
+            pbar.progress(stripStart, height);
+            size_t nRows = std::min<size_t>(stripRows, height - stripStart);
+            size_t bandStride = nRows * width;
+            rsgis::RSGISScopedTimer readTimer("zonalstats.read");
+            readTimer.addBytes((sizeof(double) + (sizeof(float) * this->numBands)) * bandStride);
+            if(zonesRasterBand->RasterIO(GF_Read, zonesXOff, zonesYOff + stripStart, width, nRows, zoneVals.data(), width, nRows, GDT_Float64, 0, 0) != CE_None)
+            {
+                throw RSGISAttributeTableException("Could not read the zones image.");
+            }
+            for(unsigned int n = 0; n < this->numBands; ++n)
+            {
+                if(valsBands[n]->RasterIO(GF_Read, valsXOff, valsYOff + stripStart, width, nRows, &vals[n*bandStride], width, nRows, GDT_Float32, 0, 0) != CE_None)
+                {
+                    throw RSGISAttributeTableException("Could not read the values image.");
+                }
+            }
+            readTimer.stop();
+
+            rsgis::RSGISScopedTimer calcTimer("zonalstats.compute");
+            calcTimer.addCount(bandStride);
+            size_t firstGroup = stripStart / groupRows;
+            size_t nStripGroups = (nRows + groupRows - 1) / groupRows;
+            if(groupRowsMode)
+            {
+                pool.parallelFor(nStripGroups, [&](size_t g, unsigned int)
+                {
+                    RSGISZoneStatsPart part;
+                    this->initStats(&part.stats);
+                    if(this->numBins > 0)
+                    {
+                        part.hists.assign(this->numZones * this->numBands * this->numBins, 0);
+                    }
+                    this->accumulateRows(zoneVals.data(), vals.data(), width, g * groupRows, std::min((g+1) * groupRows, nRows), bandStride, &part.stats, &part.hists);
+                    reduction.addPart(firstGroup + g, part);
+                });
+            }
+            else
+            {
+                // Each worker accumulates the zones it owns over the whole strip.
+                unsigned int numOwners = pool.getNumThreads();
+                pool.runOnEach([&](unsigned int t)
+                {
+                    this->accumulateRows(zoneVals.data(), vals.data(), width, 0, nRows, bandStride, &this->stats, &this->hists, numOwners, t);
+                });
+            }
+        }
+        pbar.finish();
+
+        if(groupRowsMode)
+        {
+            RSGISZoneStatsPart result;
+            if(numGroups == 0)
+            {
+                this->initStats(&result.stats);
+                if(this->numBins > 0)
+                {
+                    result.hists.assign(this->numZones * this->numBands * this->numBins, 0);
+                }
+                reduction.addPart(0, result);
+            }
+            reduction.getResult(&result);
+            this->stats.swap(result.stats);
+            this->hists.swap(result.hists);
+        }
+
+        // Add in the compensation of the sums.
+        for(std::vector<RSGISZoneBandStats>::iterator iterStats = this->stats.begin(); iterStats != this->stats.end(); ++iterStats)
+        {
+            iterStats->sum += iterStats->sumComp;
+            iterStats->sumComp = 0;
+            iterStats->m2 += iterStats->m2Comp;
+            iterStats->m2Comp = 0;
+        }
+    }
+
+    void RSGISZonalStatsAccumulator::mergeStats(RSGISZoneStatsPart &left, RSGISZoneStatsPart &right)
+    {
+        // Chan et al.
+        for(size_t i = 0; i < left.stats.size(); ++i)
+        {
+            RSGISZoneBandStats &a = left.stats[i];
+            const RSGISZoneBandStats &b = right.stats[i];
+            if(b.n == 0)
+            {
+                continue;
+            }
+            if(a.n == 0)
+            {
+                a = b;
+                continue;
+            }
+            size_t n = a.n + b.n;
+            double delta = b.mean - a.mean;
+            a.mean += delta * (((double)b.n) / n);
+            rsgis::RSGISCompensatedSum::add(a.m2, a.m2Comp, b.m2);
+            rsgis::RSGISCompensatedSum::add(a.m2, a.m2Comp, delta * delta * ((((double)a.n) * b.n) / n));
+            a.m2Comp += b.m2Comp;
+            a.min = std::min(a.min, b.min);
+            a.max = std::max(a.max, b.max);
+            rsgis::RSGISCompensatedSum::add(a.sum, a.sumComp, b.sum);
+            a.sumComp += b.sumComp;
+            a.n = n;
+        }
+        for(size_t i = 0; i < left.hists.size(); ++i)
+        {
+            left.hists[i] += right.hists[i];
+        }
+        std::vector<RSGISZoneBandStats>().swap(right.stats);
+        std::vector<uint32_t>().swap(right.hists);
+    }
+
+    void RSGISZonalStatsAccumulator::accumulateRows(const double *zoneVals, const float *vals, size_t rowLen, size_t startRow, size_t endRow, size_t bandStride, std::vector<RSGISZoneBandStats> *zoneStats, std::vector<uint32_t> *zoneHists, size_t zoneModulo, size_t zoneOwner)
+    {
+        bool useHist = (this->numBins > 0);
+        double binScale = useHist?(this->numBins / (this->histMax - this->histMin)):0;
+        for(size_t i = startRow * rowLen; i < (endRow * rowLen); ++i)
+        {
+            double zoneVal = zoneVals[i];
+            if(!((zoneVal >= 0) && (zoneVal < this->numZones)))
+            {
+                continue;
+            }
+            size_t zone = (size_t)zoneVal;
+            if((zoneModulo > 1) && ((zone % zoneModulo) != zoneOwner))
+            {
+                continue;
+            }
+            RSGISZoneBandStats *zStats = &(*zoneStats)[zone * this->numBands];
+            for(unsigned int n = 0; n < this->numBands; ++n)
+            {
+                float val = vals[(n*bandStride)+i];
+                if((this->useNoData && (val == this->noDataVal)) || boost::math::isnan(val))
+                {
+                    continue;
+                }
+                RSGISZoneBandStats &bStats = zStats[n];
+                ++bStats.n;
+                double delta = val - bStats.mean;
+                bStats.mean += delta / bStats.n;
+                rsgis::RSGISCompensatedSum::add(bStats.m2, bStats.m2Comp, delta * (val - bStats.mean));
+                if(val < bStats.min)
+                {
+                    bStats.min = val;
+                }
+                if(val > bStats.max)
+                {
+                    bStats.max = val;
+                }
+                rsgis::RSGISCompensatedSum::add(bStats.sum, bStats.sumComp, val);
+                if(useHist)
+                {
+                    long bin = (long)floor((val - this->histMin) * binScale);
+                    bin = std::min<long>(std::max<long>(bin, 0), this->numBins-1);
+                    ++(*zoneHists)[(((zone * this->numBands) + n) * this->numBins) + bin];
+                }
+            }
+        }
+    }
+
+    void RSGISZonalStatsAccumulator::initStats(std::vector<RSGISZoneBandStats> *zoneStats)
+    {
+        RSGISZoneBandStats emptyStats;
+        emptyStats.n = 0;
+        emptyStats.mean = 0;
+        emptyStats.m2 = 0;
+        emptyStats.m2Comp = 0;
+        emptyStats.min = std::numeric_limits<double>::max();
+        emptyStats.max = -std::numeric_limits<double>::max();
+        emptyStats.sum = 0;
+        emptyStats.sumComp = 0;
+        zoneStats->assign(this->numZones * this->numBands, emptyStats);
+    }
+
+    double RSGISZonalStatsAccumulator::getStdDev(size_t zone, unsigned int band) const
+    {
+        const RSGISZoneBandStats &bStats = this->stats[(zone*this->numBands)+band];
+        if(bStats.n == 0)
+        {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        return sqrt(bStats.m2 / bStats.n);
+    }
+
+    double RSGISZonalStatsAccumulator::getPercentile(size_t zone, unsigned int band, double percentile) const
+    {
+        if(this->numBins == 0)
+        {
+            throw RSGISAttributeTableException("A histogram is needed for percentiles.");
+        }
+        const RSGISZoneBandStats &bStats = this->stats[(zone*this->numBands)+band];
+        if(bStats.n == 0)
+        {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        const uint32_t *hist = &this->hists[((zone * this->numBands) + band) * this->numBins];
+        double binWidth = (this->histMax - this->histMin) / this->numBins;
+        double target = (std::min(std::max(percentile, 0.0), 100.0) / 100.0) * bStats.n;
+        double cumCount = 0;
+        for(unsigned int b = 0; b < this->numBins; ++b)
+        {
+            if((hist[b] > 0) && ((cumCount + hist[b]) >= target))
+            {
+                // Interpolate within the bin, limited to the range of the values.
+                double val = this->histMin + ((b + ((target - cumCount) / hist[b])) * binWidth);
+                return std::min(std::max(val, bStats.min), bStats.max);
+            }
+            cumCount += hist[b];
+        }
+        return bStats.max;
+    }
+
+    void RSGISZonalStatsAccumulator::writeToRAT(GDALDataset *zonesImage, unsigned int zonesBand, std::vector<std::string> *bandPrefixes)
+    {
+        if(bandPrefixes->size() != this->numBands)
+        {
+            throw RSGISAttributeTableException("A column name prefix is needed for each band.");
+        }
+        GDALRasterAttributeTable *attTable = zonesImage->GetRasterBand(zonesBand)->GetDefaultRAT();
+        if(attTable == NULL)
+        {
+            throw RSGISAttributeTableException("Could not get the RAT of the zones image.");
+        }
+        if(((size_t)attTable->GetRowCount()) < this->numZones)
+        {
+            attTable->SetRowCount(this->numZones);
+        }
+        size_t numRows = attTable->GetRowCount();
+
+        RSGISRasterAttUtils attUtils;
+        std::vector<double> colVals(numRows, 0.0);
+        unsigned int numCols = (this->numBins > 0)?7:6;
+        const char *colNames[7] = {"Count", "Min", "Max", "Mean", "StdDev", "Sum", "Median"};
+        for(unsigned int n = 0; n < this->numBands; ++n)
+        {
+            for(unsigned int c = 0; c < numCols; ++c)
+            {
+                for(size_t z = 0; z < this->numZones; ++z)
+                {
+                    const RSGISZoneBandStats &bStats = this->stats[(z*this->numBands)+n];
+                    double val = 0;
+                    if(bStats.n > 0)
+                    {
+                        switch(c)
+                        {
+                            case 0: val = bStats.n; break;
+                            case 1: val = bStats.min; break;
+                            case 2: val = bStats.max; break;
+                            case 3: val = bStats.mean; break;
+                            case 4: val = this->getStdDev(z, n); break;
+                            case 5: val = bStats.sum; break;
+                            default: val = this->getPercentile(z, n, 50); break;
+                        }
+                    }
+                    colVals[z] = val;
+                }
+                attUtils.writeRealColumn(attTable, (*bandPrefixes)[n] + colNames[c], colVals.data(), numRows);
+            }
+        }
+    }
+
+    RSGISZonalStatsAccumulator::~RSGISZonalStatsAccumulator()
+    {
+
+    }
+
+}}
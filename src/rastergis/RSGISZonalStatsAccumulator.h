@@ -0,0 +1,168 @@
+/*
+ *  RSGISZonalStatsAccumulator.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISZonalStatsAccumulator_H
+#define RSGISZonalStatsAccumulator_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <limits>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+#include <cstdlib>
+#include <stdint.h>
+#include <math.h>
+
+#include "gdal_priv.h"
+
+#include "common/RSGISAttributeTableException.h"
+#include "common/rsgis-tqdm.h"
+#include "common/RSGISProfiler.h"
+#include "common/RSGISReduction.h"
+#include "common/RSGISParallel.h"
+
+#include "img/RSGISImageUtils.h"
+
+#include "rastergis/RSGISRasterAttUtils.h"
+
+#include <boost/math/special_functions/fpclassify.hpp>
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_rastergis_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace rastergis{
+
+    /**
+     * The statistics of the values of one band within a zone, accumulated
+     * with Welford's method (m2 is the sum of squared differences from the mean).
+     * The rounding errors of sum and m2 are accumulated in sumComp and m2Comp
+     * (rsgis::RSGISCompensatedSum) and added in once all the values are given.
+     */
+    struct DllExport RSGISZoneBandStats
+    {
+        size_t n;
+        double mean;
+        double m2;
+        double m2Comp;
+        double min;
+        double max;
+        double sum;
+        double sumComp;
+    };
+
+    /**
+     * Zonal statistics of every band of an image for the zones of a zones
+     * image (e.g. rasterised polygons or clumps) in a single pass over both
+     * images. Zone values 0 to numZones-1 are used, other values (e.g. -1 or
+     * the no data value) are ignored.
+     *
+     * The images are read in strips of rows on the calling thread and shared
+     * between threads (RSGISLIB_NUM_THREADS or setNumThreads). The statistics
+     * are identical whatever the number of threads: where the statistics
+     * of all the zones take more than 1 MB each thread accumulates the zones
+     * it owns (zone % numThreads) in the order of the pixels, otherwise fixed
+     * groups of 64 rows are accumulated separately and merged (Chan et al.)
+     * in a fixed order (rsgis::RSGISTreeReduction). The memory used is
+     * numZones * numBands * 64 bytes (plus numBins * 4 bytes for each if a
+     * histogram is used).
+     *
+     * With setHistogram a fixed-bin histogram is also accumulated for each
+     * zone and band from which the median and percentiles are estimated;
+     * values outside the histogram range are counted in the end bins.
+     */
+    class DllExport RSGISZonalStatsAccumulator
+    {
+    public:
+        RSGISZonalStatsAccumulator(size_t numZones);
+        /**
+         * Number of threads, 0 uses the number of cores.
+         */
+        void setNumThreads(unsigned int numThreads);
+        void setHistogram(unsigned int numBins, double histMin, double histMax);
+        /**
+         * Ignore image values equal to noDataVal.
+         */
+        void setImageNoData(bool useNoData, float noDataVal);
+        /**
+         * Accumulate the statistics over the overlapping area of the zones and value images.
+         */
+        void calcZoneStats(GDALDataset *zonesImage, unsigned int zonesBand, GDALDataset *valsImage);
+        size_t getNumZones() const {return numZones;};
+        unsigned int getNumBands() const {return numBands;};
+        const RSGISZoneBandStats& getStats(size_t zone, unsigned int band) const {return stats[(zone*numBands)+band];};
+        /**
+         * The (population) standard deviation, NaN if the zone has no pixels.
+         */
+        double getStdDev(size_t zone, unsigned int band) const;
+        /**
+         * A percentile (0 - 100) from the histogram, NaN if the zone has no pixels.
+         */
+        double getPercentile(size_t zone, unsigned int band, double percentile) const;
+        /**
+         * Write the statistics to columns, named the band prefix followed by
+         * Count, Min, Max, Mean, StdDev, Sum and (with a histogram) Median, of
+         * the RAT of a band of the zones image.
+         */
+        void writeToRAT(GDALDataset *zonesImage, unsigned int zonesBand, std::vector<std::string> *bandPrefixes);
+        ~RSGISZonalStatsAccumulator();
+    protected:
+        void initStats(std::vector<RSGISZoneBandStats> *zoneStats);
+        /**
+         * Accumulate the pixels of the rows, only for the zones where
+         * zone % zoneModulo == zoneOwner.
+         */
+        void accumulateRows(const double *zoneVals, const float *vals, size_t rowLen, size_t startRow, size_t endRow, size_t bandStride, std::vector<RSGISZoneBandStats> *zoneStats, std::vector<uint32_t> *zoneHists, size_t zoneModulo=1, size_t zoneOwner=0);
+        struct RSGISZoneStatsPart
+        {
+            std::vector<RSGISZoneBandStats> stats;
+            std::vector<uint32_t> hists;
+        };
+        void mergeStats(RSGISZoneStatsPart &left, RSGISZoneStatsPart &right);
+        static const size_t groupRows;
+        static const size_t maxGroupedBytes;
+        size_t numZones;
+        unsigned int numBands;
+        unsigned int numThreads;
+        unsigned int numBins;
+        double histMin;
+        double histMax;
+        bool useNoData;
+        float noDataVal;
+        std::vector<RSGISZoneBandStats> stats;
+        std::vector<uint32_t> hists;
+    };
+
+}}
+
+#endif
@@ -120,34 +120,30 @@ namespace rsgis{namespace reg{
 			throw RSGISRegistrationException("The algorithm needs to be initialised before being executed.");
 		}
 		
-		unsigned int counter = 0;
-		unsigned int feedback = 0;
-		unsigned int feedbackVal = 0;
-		bool giveFeedback = false;
-		if(tiePoints->size() > 10)
-		{
-			feedback = tiePoints->size()/10;
-			giveFeedback = true;
-		}
-		
-		std::cout << "Started ." << std::flush;
+		// The tie points are independent so are shared among the threads.
+		std::vector<TiePoint*> tiePtsVec(tiePoints->begin(), tiePoints->end());
+		size_t numTiePts = tiePtsVec.size();
 		
-		float xShift = 0;
-		float yShift = 0;
-		
-		std::list<TiePoint*>::iterator iterTiePts;
-		for(iterTiePts = tiePoints->begin(); iterTiePts != tiePoints->end(); ++iterTiePts)
+		std::mutex feedbackMutex;
+		size_t numTiePtsDone = 0;
+		rsgis_tqdm pbar;
+		try
 		{
-			if(giveFeedback && ((counter % feedback) == 0))
+			rsgis::utils::parallelFor(numTiePts, this->numThreads, [&](size_t idx, unsigned int)
 			{
-				std::cout << "." << feedbackVal << "." << std::flush;
-				feedbackVal += 10;
-			}
-			
-			this->findTiePointLocation(*iterTiePts, windowSize, searchArea, metric, metricThreshold, subPixelResolution, &xShift, &yShift);            
-			++counter;
+				float xShift = 0;
+				float yShift = 0;
+				this->findTiePointLocation(tiePtsVec[idx], windowSize, searchArea, metric, metricThreshold, subPixelResolution, &xShift, &yShift);
+				std::lock_guard<std::mutex> lock(feedbackMutex);
+				pbar.progress(++numTiePtsDone, numTiePts);
+			});
+		}
+		catch(...)
+		{
+			pbar.finish();
+			throw;
 		}
-		std::cout << ". Complete\n";
+		pbar.finish();
 	}
 	
 	void RSGISBasicImageRegistration::finaliseRegistration()
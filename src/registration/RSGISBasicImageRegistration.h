@@ -30,6 +30,11 @@
 #include <string>
 #include <math.h>
 #include <list>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <exception>
 
 #include "gdal_priv.h"
 #include "ogrsf_frmts.h"
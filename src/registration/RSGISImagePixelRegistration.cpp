@@ -34,6 +34,7 @@ namespace rsgis{namespace reg{
         this->searchArea = searchArea;
         this->metric = metric;
         this->subPixelResolution = subPixelResolution;
+        this->useDenseMatching = false;
     }
     
     void RSGISImagePixelRegistration::initRegistration()
@@ -108,6 +109,11 @@ namespace rsgis{namespace reg{
     
     void RSGISImagePixelRegistration::executeRegistration()
     {
+        if(this->useDenseMatching)
+        {
+            this->executeDenseRegistration();
+            return;
+        }
         try
         {
             float *xShift = new float[this->overlap->xSize];
@@ -187,6 +193,320 @@ namespace rsgis{namespace reg{
         }
     }
     
+    void RSGISImagePixelRegistration::executeDenseRegistration()
+    {
+        try
+        {
+            const unsigned int width = this->overlap->xSize;
+            const unsigned int height = this->overlap->ySize;
+            const unsigned int nTilesX = (width + denseTileSize - 1) / denseTileSize;
+            const unsigned int nTilesY = (height + denseTileSize - 1) / denseTileSize;
+            const unsigned int nTiles = nTilesX * nTilesY;
+            if(nTiles == 0)
+            {
+                return;
+            }
+            
+            unsigned int numTilesDone = 0;
+            rsgis_tqdm pbar;
+            try
+            {
+                rsgis::utils::parallelFor(nTiles, this->numThreads, [&](size_t tile, unsigned int)
+                {
+                    std::vector<float> xShifts(denseTileSize * denseTileSize);
+                    std::vector<float> yShifts(denseTileSize * denseTileSize);
+                    std::vector<float> metricVals(denseTileSize * denseTileSize);
+                    unsigned int tileX = (tile % nTilesX) * denseTileSize;
+                    unsigned int tileY = (tile / nTilesX) * denseTileSize;
+                    unsigned int tileWidth = std::min(denseTileSize, width - tileX);
+                    unsigned int tileHeight = std::min(denseTileSize, height - tileY);
+                    this->matchTile(tileX, tileY, tileWidth, tileHeight, xShifts.data(), yShifts.data(), metricVals.data());
+                    
+                    std::lock_guard<std::mutex> lock(this->ioMutex);
+                    float *outBufs[3] = {xShifts.data(), yShifts.data(), metricVals.data()};
+                    for(int n = 0; n < 3; ++n)
+                    {
+                        if(this->outputImage->GetRasterBand(n+1)->RasterIO(GF_Write, tileX, tileY, tileWidth, tileHeight, outBufs[n], tileWidth, tileHeight, GDT_Float32, 0, 0) != CE_None)
+                        {
+                            throw RSGISRegistrationException("Could not write to the output image.");
+                        }
+                    }
+                    pbar.progress(++numTilesDone, nTiles);
+                });
+            }
+            catch(...)
+            {
+                pbar.finish();
+                throw;
+            }
+            pbar.finish();
+        }
+        catch (RSGISRegistrationException &e)
+        {
+            throw e;
+        }
+        catch (rsgis::RSGISImageException &e)
+        {
+            throw RSGISRegistrationException(e.what());
+        }
+        catch (rsgis::RSGISException &e)
+        {
+            throw RSGISRegistrationException(e.what());
+        }
+        catch (std::exception &e)
+        {
+            throw RSGISRegistrationException(e.what());
+        }
+    }
+    
+    void RSGISImagePixelRegistration::matchTile(unsigned int tileX, unsigned int tileY, unsigned int tileWidth, unsigned int tileHeight, float *xShifts, float *yShifts, float *metricVals)
+    {
+        const int hw = this->windowSize;
+        const int sa = this->searchArea;
+        const int winSize = (2 * hw) + 1;
+        const unsigned int numShifts = (2 * sa) + 1;
+        const unsigned int numBands = this->overlap->numRefBands;
+        const unsigned int numVals = winSize * winSize * numBands;
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        
+        // The reference region covers the windows of the tile pixels and the
+        // floating region those windows at every shift. The shift (dx, dy)
+        // compares reference region pixel (x, y) with floating region pixel
+        // (x + sa - dx, y + sa - dy), as a shift of the floating image's origin.
+        const int refWidth = tileWidth + (2 * hw);
+        const int refHeight = tileHeight + (2 * hw);
+        const int floatWidth = refWidth + (2 * sa);
+        const int floatHeight = refHeight + (2 * sa);
+        std::vector<float> refData;
+        std::vector<float> floatData;
+        this->readRegion(this->referenceIMG, ((int)floor(this->overlap->refXStart + 0.5)) + tileX - hw, ((int)floor(this->overlap->refYStart + 0.5)) + tileY - hw, refWidth, refHeight, &refData);
+        this->readRegion(this->floatingIMG, ((int)floor(this->overlap->floatXStart + 0.5)) + tileX - hw - sa, ((int)floor(this->overlap->floatYStart + 0.5)) + tileY - hw - sa, floatWidth, floatHeight, &floatData);
+        
+        // Summed-area tables (with a leading row and column of 0) of a plane.
+        auto calcSAT = [](const std::vector<double> &vals, int width, int height, std::vector<double> *sat)
+        {
+            size_t satWidth = width + 1;
+            sat->assign(satWidth * (height + 1), 0.0);
+            for(int y = 0; y < height; ++y)
+            {
+                double rowSum = 0;
+                const double *val = &vals[((size_t)y) * width];
+                const double *above = &(*sat)[((size_t)y) * satWidth];
+                double *out = &(*sat)[((size_t)(y + 1)) * satWidth];
+                for(int x = 0; x < width; ++x)
+                {
+                    rowSum += val[x];
+                    out[x+1] = above[x+1] + rowSum;
+                }
+            }
+        };
+        auto sumWindow = [winSize](const std::vector<double> &sat, int width, int x, int y)
+        {
+            size_t satWidth = width + 1;
+            size_t tl = (((size_t)y) * satWidth) + x;
+            size_t bl = tl + (((size_t)winSize) * satWidth);
+            return sat[bl + winSize] - sat[bl] - sat[tl + winSize] + sat[tl];
+        };
+        
+        // Less the mean (to limit the loss of precision in the tables), with
+        // pixels which are NaN in any band set to 0 and counted in a table of
+        // the invalid pixels.
+        auto prepareRegion = [numBands, &calcSAT](std::vector<float> *data, int width, int height, std::vector<double> *sat, std::vector<double> *satSq, std::vector<double> *satBad)
+        {
+            size_t numPxls = ((size_t)width) * height;
+            std::vector<double> valid(numPxls, 1.0);
+            double sum = 0;
+            size_t count = 0;
+            for(size_t i = 0; i < numPxls; ++i)
+            {
+                double pxlSum = 0;
+                for(unsigned int n = 0; n < numBands; ++n)
+                {
+                    float val = (*data)[(n * numPxls) + i];
+                    if(!std::isfinite(val))
+                    {
+                        valid[i] = 0.0;
+                        break;
+                    }
+                    pxlSum += val;
+                }
+                if(valid[i] != 0.0)
+                {
+                    sum += pxlSum;
+                    ++count;
+                }
+            }
+            double mean = (count > 0)?(sum / (((double)count) * numBands)):0.0;
+            std::vector<double> vals(numPxls, 0.0);
+            std::vector<double> valsSq(numPxls, 0.0);
+            std::vector<double> bad(numPxls, 0.0);
+            for(size_t i = 0; i < numPxls; ++i)
+            {
+                if(valid[i] == 0.0)
+                {
+                    bad[i] = 1.0;
+                    for(unsigned int n = 0; n < numBands; ++n)
+                    {
+                        (*data)[(n * numPxls) + i] = 0;
+                    }
+                    continue;
+                }
+                for(unsigned int n = 0; n < numBands; ++n)
+                {
+                    float val = (*data)[(n * numPxls) + i] - mean;
+                    (*data)[(n * numPxls) + i] = val;
+                    vals[i] += val;
+                    valsSq[i] += ((double)val) * val;
+                }
+            }
+            calcSAT(vals, width, height, sat);
+            calcSAT(valsSq, width, height, satSq);
+            calcSAT(bad, width, height, satBad);
+        };
+        std::vector<double> refSAT, refSATSq, refSATBad;
+        std::vector<double> floatSAT, floatSATSq, floatSATBad;
+        prepareRegion(&refData, refWidth, refHeight, &refSAT, &refSATSq, &refSATBad);
+        prepareRegion(&floatData, floatWidth, floatHeight, &floatSAT, &floatSATSq, &floatSATBad);
+        
+        // The best shift of each pixel and the metric at the shifts either side
+        // of it (for the sub-pixel fit), found from the metric planes of the
+        // current and previous rows of shifts.
+        const size_t numTilePxls = ((size_t)tileWidth) * tileHeight;
+        std::vector<float> best(numTilePxls, -std::numeric_limits<float>::infinity());
+        std::vector<int> bestDX(numTilePxls, sa + 2);
+        std::vector<int> bestDY(numTilePxls, sa + 2);
+        std::vector<float> leftVals(numTilePxls, nan);
+        std::vector<float> rightVals(numTilePxls, nan);
+        std::vector<float> topVals(numTilePxls, nan);
+        std::vector<float> bottomVals(numTilePxls, nan);
+        std::vector<std::vector<float> > prevRowVals(numShifts, std::vector<float>(numTilePxls, nan));
+        std::vector<std::vector<float> > curRowVals(numShifts, std::vector<float>(numTilePxls, nan));
+        
+        const size_t refPlane = ((size_t)refWidth) * refHeight;
+        const size_t floatPlane = ((size_t)floatWidth) * floatHeight;
+        std::vector<double> prod(refPlane);
+        std::vector<double> prodSAT;
+        for(unsigned int dyIdx = 0; dyIdx < numShifts; ++dyIdx)
+        {
+            const int dy = ((int)dyIdx) - sa;
+            prevRowVals.swap(curRowVals);
+            for(unsigned int dxIdx = 0; dxIdx < numShifts; ++dxIdx)
+            {
+                const int dx = ((int)dxIdx) - sa;
+                const int floatOffX = sa - dx;
+                const int floatOffY = sa - dy;
+                
+                std::fill(prod.begin(), prod.end(), 0.0);
+                for(unsigned int n = 0; n < numBands; ++n)
+                {
+                    for(int y = 0; y < refHeight; ++y)
+                    {
+                        const float *refRow = &refData[(n * refPlane) + (((size_t)y) * refWidth)];
+                        const float *floatRow = &floatData[(n * floatPlane) + (((size_t)(y + floatOffY)) * floatWidth) + floatOffX];
+                        double *prodRow = &prod[((size_t)y) * refWidth];
+                        for(int x = 0; x < refWidth; ++x)
+                        {
+                            prodRow[x] += refRow[x] * floatRow[x];
+                        }
+                    }
+                }
+                calcSAT(prod, refWidth, refHeight, &prodSAT);
+                
+                float *vals = curRowVals[dxIdx].data();
+                for(unsigned int j = 0; j < tileHeight; ++j)
+                {
+                    for(unsigned int i = 0; i < tileWidth; ++i)
+                    {
+                        size_t idx = (((size_t)j) * tileWidth) + i;
+                        float val = nan;
+                        if((sumWindow(refSATBad, refWidth, i, j) == 0) && (sumWindow(floatSATBad, floatWidth, i + floatOffX, j + floatOffY) == 0))
+                        {
+                            val = RSGISCorrelationSimilarityMetric::calcValueFromSums(sumWindow(prodSAT, refWidth, i, j), sumWindow(refSAT, refWidth, i, j), sumWindow(floatSAT, floatWidth, i + floatOffX, j + floatOffY), sumWindow(refSATSq, refWidth, i, j), sumWindow(floatSATSq, floatWidth, i + floatOffX, j + floatOffY), numVals);
+                        }
+                        vals[idx] = val;
+                        
+                        if((bestDX[idx] == (dx - 1)) && (bestDY[idx] == dy))
+                        {
+                            rightVals[idx] = val;
+                        }
+                        if((bestDX[idx] == dx) && (bestDY[idx] == (dy - 1)))
+                        {
+                            bottomVals[idx] = val;
+                        }
+                        if(val > best[idx])
+                        {
+                            best[idx] = val;
+                            bestDX[idx] = dx;
+                            bestDY[idx] = dy;
+                            leftVals[idx] = (dxIdx > 0)?curRowVals[dxIdx-1][idx]:nan;
+                            topVals[idx] = (dyIdx > 0)?prevRowVals[dxIdx][idx]:nan;
+                            rightVals[idx] = nan;
+                            bottomVals[idx] = nan;
+                        }
+                    }
+                }
+            }
+        }
+        
+        // Offset of the peak of a parabola through the values either side of the best.
+        auto subPixelOffset = [](float before, float centre, float after)
+        {
+            if(!(std::isfinite(before) && std::isfinite(after)))
+            {
+                return 0.0f;
+            }
+            float denom = before - (2 * centre) + after;
+            if(!(denom < 0))
+            {
+                return 0.0f;
+            }
+            float offset = (0.5f * (before - after)) / denom;
+            return std::max(-0.5f, std::min(0.5f, offset));
+        };
+        for(size_t idx = 0; idx < numTilePxls; ++idx)
+        {
+            if(!std::isfinite(best[idx]))
+            {
+                xShifts[idx] = 0;
+                yShifts[idx] = 0;
+                metricVals[idx] = nan;
+                continue;
+            }
+            float subX = 0;
+            float subY = 0;
+            if(this->subPixelResolution > 0)
+            {
+                subX = subPixelOffset(leftVals[idx], best[idx], rightVals[idx]);
+                subY = subPixelOffset(topVals[idx], best[idx], bottomVals[idx]);
+            }
+            xShifts[idx] = bestDX[idx] + subX;
+            yShifts[idx] = bestDY[idx] + subY;
+            metricVals[idx] = best[idx];
+        }
+    }
+    
+    void RSGISImagePixelRegistration::readRegion(GDALDataset *dataset, int xOff, int yOff, int width, int height, std::vector<float> *data)
+    {
+        // Band sequential, with NaN outside the image.
+        int numBands = dataset->GetRasterCount();
+        size_t numPxls = ((size_t)width) * height;
+        data->assign(numPxls * numBands, std::numeric_limits<float>::quiet_NaN());
+        int x0 = std::max(xOff, 0);
+        int y0 = std::max(yOff, 0);
+        int x1 = std::min(xOff + width, dataset->GetRasterXSize());
+        int y1 = std::min(yOff + height, dataset->GetRasterYSize());
+        if((x1 <= x0) || (y1 <= y0))
+        {
+            return;
+        }
+        float *start = &(*data)[(((size_t)(y0 - yOff)) * width) + (x0 - xOff)];
+        std::lock_guard<std::mutex> lock(this->ioMutex);
+        if(dataset->RasterIO(GF_Read, x0, y0, x1 - x0, y1 - y0, start, x1 - x0, y1 - y0, GDT_Float32, numBands, NULL, sizeof(float), ((GSpacing)width) * sizeof(float), ((GSpacing)numPxls) * sizeof(float)) != CE_None)
+        {
+            throw RSGISRegistrationException("Could not read a region of an image.");
+        }
+    }
+    
     void RSGISImagePixelRegistration::finaliseRegistration()
     {
         try
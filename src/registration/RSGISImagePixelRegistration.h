@@ -30,6 +30,13 @@
 #include <string>
 #include <math.h>
 #include <list>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <limits>
+#include <algorithm>
 
 #include "gdal_priv.h"
 #include "ogrsf_frmts.h"
@@ -40,6 +47,7 @@
 #include "img/RSGISImageUtils.h"
 
 #include "registration/RSGISImageRegistration.h"
+#include "registration/RSGISStandardImageSimilarityMetrics.h"
 
 #include "boost/math/special_functions/fpclassify.hpp"
 
@@ -58,10 +66,28 @@
 
 namespace rsgis{namespace reg{
     
+	/**
+	 * Finds the shift of the floating image for every pixel of the overlap,
+	 * writing an image with bands of the x and y shifts and the metric value.
+	 */
 	class DllExport RSGISImagePixelRegistration : public RSGISImageRegistration
 	{
 	public:
 		RSGISImagePixelRegistration(GDALDataset *reference, GDALDataset *floating, std::string outputImagePath, std::string outputFormat, unsigned int windowSize, unsigned int searchArea, RSGISImageSimilarityMetric *metric, unsigned int subPixelResolution);
+		/**
+		 * Dense block matching with the correlation metric (in place of metric):
+		 * the overlap is split into tiles, matched in parallel (setNumThreads).
+		 * For each shift within the search area the window sums of the product
+		 * of the reference and shifted floating images are taken from a
+		 * summed-area table, as are the sums of the values and their squares,
+		 * so the cost of each shift does not depend on the window size. The
+		 * metric band holds the correlation at the best shift, as a confidence,
+		 * and the sub-pixel shift (if subPixelResolution > 0) is from a parabola
+		 * through the correlations at the neighbouring shifts. Pixels whose
+		 * windows cross an image edge or contain NaNs are left with no shift
+		 * and a NaN metric.
+		 */
+		void setUseDenseMatching(bool useDenseMatching){this->useDenseMatching = useDenseMatching;};
 		void initRegistration();
 		void executeRegistration();
 		void finaliseRegistration();
@@ -71,6 +97,11 @@ namespace rsgis{namespace reg{
         void exportTiePointsRSGISMapOffs(std::string filepath);
 		~RSGISImagePixelRegistration();
 	private:
+		void executeDenseRegistration();
+		void matchTile(unsigned int tileX, unsigned int tileY, unsigned int tileWidth, unsigned int tileHeight, float *xShifts, float *yShifts, float *metricVals);
+		void readRegion(GDALDataset *dataset, int xOff, int yOff, int width, int height, std::vector<float> *data);
+		static const unsigned int denseTileSize = 128;
+		bool useDenseMatching;
 		std::string outputImagePath;
         std::string outputFormat;
         GDALDataset *outputImage;
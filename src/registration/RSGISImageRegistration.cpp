@@ -28,10 +28,26 @@
 namespace rsgis{namespace reg{
 
 		
-	RSGISImageRegistration::RSGISImageRegistration(GDALDataset *reference, GDALDataset *floating): referenceIMG(NULL), floatingIMG(NULL), overlap(NULL), overlapDefined(false)
+	RSGISImageRegistration::RSGISImageRegistration(GDALDataset *reference, GDALDataset *floating): referenceIMG(NULL), floatingIMG(NULL), overlap(NULL), overlapDefined(false), numPyramidLevels(0), numThreads(1), useFFTCorrelation(false)
 	{
 		this->referenceIMG = reference;
 		this->floatingIMG = floating;
+		this->numThreads = rsgis::utils::getNumThreads();
+	}
+	
+	void RSGISImageRegistration::setNumPyramidLevels(unsigned int numLevels)
+	{
+		this->numPyramidLevels = numLevels;
+	}
+	
+	void RSGISImageRegistration::setNumThreads(unsigned int numThreads)
+	{
+		this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+	}
+	
+	void RSGISImageRegistration::setUseFFTCorrelation(bool useFFTCorrelation)
+	{
+		this->useFFTCorrelation = useFFTCorrelation;
 	}
 	
 	void RSGISImageRegistration::runCompleteRegistration()
@@ -124,291 +140,635 @@ namespace rsgis{namespace reg{
 		}
 		
 		rsgis::img::RSGISImageUtils imgUtils;
-		try 
+		
+		unsigned int numSearchPoints = (searchArea*2)+1;
+		unsigned int numBands = overlap->numRefBands;
+		std::vector<float> similarityData(numSearchPoints*numSearchPoints, std::numeric_limits<float>::quiet_NaN());
+		std::vector<float*> imageSimilarity(numSearchPoints, NULL);
+		for(unsigned int i = 0; i < numSearchPoints; ++i)
 		{
-			// Setup overlapping region variables.
-			int **dsOffsets = new int*[2];
-			dsOffsets[0] = new int[2];
-			dsOffsets[1] = new int[2];
+			imageSimilarity[i] = &similarityData[i*numSearchPoints];
+		}
+		std::vector<bool> calculated(numSearchPoints*numSearchPoints, false);
+		std::vector<SearchBlock> searchBlocks(numSearchPoints*numSearchPoints);
+		
+		float **refData = NULL;
+		float **floatData = NULL;
+		
+		try
+		{
+			int refOffsets[2];
+			int floatOffsets[2];
+			int *dsOffsets[2] = {refOffsets, floatOffsets};
 			int overlapWidth = 0;
 			int overlapHeight = 0;
-			double *overlapTransform = new double[6];
+			double overlapTransform[6];
 			
 			double windowXWidth = (((double)windowSize)*overlap->xRes);
 			double windowYHeight = (((double)windowSize)*overlap->yRes);
 			
-			geos::geom::Envelope *env = new geos::geom::Envelope();
-			env->init((tiePt->eastings - windowXWidth), 
-					  (tiePt->eastings + windowXWidth + overlap->xRes), 
-					  (tiePt->northings - windowYHeight),
-					  (tiePt->northings + windowYHeight + +overlap->yRes));
-			
-			unsigned int numSearchPoints = (searchArea*2)+1;
-			float **imageSimilarity = new float*[numSearchPoints];
-			for(unsigned int i = 0; i < numSearchPoints; ++i)
-			{
-				imageSimilarity[i] = new float[numSearchPoints];
-			}
-			
-			int xShiftStart = searchArea * (-1);
-			int yShiftStart = searchArea * (-1);
-			int xShiftEnd = searchArea;
-			int yShiftEnd = searchArea;
-			
-			float **refDataBlock = NULL;
-			float **floatDataBlock = NULL;
-			unsigned int numRefDataVals = 0;
-			unsigned int numFloatDataVals = 0;
-			
-			bool first = true;
-			double currentMetricVal = 0;
-			double metricVal = 0;
-			int currentShiftX = 0;
-			int currentShiftY = 0;
-			
-			unsigned int xIdx = 0;
-			unsigned int yIdx = 0;
-			unsigned int currentXIdx = 0;
-			unsigned int currentYIdx = 0;
-            
-            // Set up variables to hold remainder from image overlap
-            float remainderX = 0;
-            float remainderY = 0;
-            // Remainder for heighest metric
-            float currentRemainderX = 0;
-            float currentRemainderY = 0;
-            
-            
+			geos::geom::Envelope env;
+			env.init((tiePt->eastings - windowXWidth),
+					 (tiePt->eastings + windowXWidth + overlap->xRes),
+					 (tiePt->northings - windowYHeight),
+					 (tiePt->northings + windowYHeight + overlap->yRes));
 			
-            // Move floating window over search space
-			for(int yShift = yShiftStart; yShift <= yShiftEnd; ++yShift)
+			// Find the blocks compared for each shift, and the regions of the
+			// images covering all of them so each image is only read once.
+			int refRegion[4] = {0, 0, 0, 0}; // minX, minY, maxX, maxY
+			int floatRegion[4] = {0, 0, 0, 0};
+			bool anyValid = false;
+			int searchAreaInt = searchArea;
+			for(int yShift = -searchAreaInt; yShift <= searchAreaInt; ++yShift)
 			{
-				xIdx = 0;
-				for(int xShift = xShiftStart; xShift <= xShiftEnd; ++xShift)
+				for(int xShift = -searchAreaInt; xShift <= searchAreaInt; ++xShift)
 				{
+					SearchBlock &block = searchBlocks[((yShift+searchAreaInt)*numSearchPoints)+(xShift+searchAreaInt)];
+					block.valid = false;
 					try
 					{
-						this->getImageOverlapWithFloatShift((((float)xShift)+tiePt->xShift), (((float)yShift)+tiePt->yShift), dsOffsets, &overlapWidth, &overlapHeight, overlapTransform, env, &remainderX, &remainderY);
+						float remainderX = 0;
+						float remainderY = 0;
+						this->getImageOverlapWithFloatShift((((float)xShift)+tiePt->xShift), (((float)yShift)+tiePt->yShift), dsOffsets, &overlapWidth, &overlapHeight, overlapTransform, &env, &remainderX, &remainderY);
 						
 						if((overlapWidth > 0) & (overlapHeight > 0))
 						{
-							numRefDataVals = 0;
-							numFloatDataVals = 0;
-							
-							refDataBlock = imgUtils.getImageDataBlock(referenceIMG, dsOffsets[0], overlapWidth, overlapHeight, &numRefDataVals);
-							floatDataBlock = imgUtils.getImageDataBlock(floatingIMG, dsOffsets[1], overlapWidth, overlapHeight, &numFloatDataVals);
+							block.valid = true;
+							block.refXOff = refOffsets[0];
+							block.refYOff = refOffsets[1];
+							block.floatXOff = floatOffsets[0];
+							block.floatYOff = floatOffsets[1];
+							block.width = overlapWidth;
+							block.height = overlapHeight;
+							block.remainderX = remainderX;
+							block.remainderY = remainderY;
 							
-							if(numRefDataVals != numFloatDataVals)
+							if(!anyValid)
 							{
-								throw RSGISRegistrationException("The number of data values read from the images does not match.");
+								refRegion[0] = block.refXOff;
+								refRegion[1] = block.refYOff;
+								refRegion[2] = block.refXOff + block.width;
+								refRegion[3] = block.refYOff + block.height;
+								floatRegion[0] = block.floatXOff;
+								floatRegion[1] = block.floatYOff;
+								floatRegion[2] = block.floatXOff + block.width;
+								floatRegion[3] = block.floatYOff + block.height;
+								anyValid = true;
 							}
-							
-							metricVal = metric->calcValue(refDataBlock, floatDataBlock, numRefDataVals, overlap->numRefBands);
-							
-							imageSimilarity[yIdx][xIdx] = metricVal;
-							
-							if(!((boost::math::isnan)(metricVal)))
+							else
 							{
-								if(first)
-								{
-									currentMetricVal = metricVal;
-									currentShiftX = xShift;
-									currentShiftY = yShift;
-									currentXIdx = xIdx;
-									currentYIdx = yIdx;
-                                    currentRemainderX = remainderX;
-                                    currentRemainderY = remainderY;
-									first = false;
-								}
-								else if(metric->findMin() & (metricVal < currentMetricVal))
-								{
-									currentMetricVal = metricVal;
-									currentShiftX = xShift;
-									currentShiftY = yShift;
-									currentXIdx = xIdx;
-									currentYIdx = yIdx;
-                                    currentRemainderX = remainderX;
-                                    currentRemainderY = remainderY;
-								}
-								else if(!metric->findMin() & (metricVal > currentMetricVal))
-								{
-									currentMetricVal = metricVal;
-									currentShiftX = xShift;
-									currentShiftY = yShift;
-									currentXIdx = xIdx;
-									currentYIdx = yIdx;
-                                    currentRemainderX = remainderX;
-                                    currentRemainderY = remainderY;
-								}
+								refRegion[0] = std::min(refRegion[0], block.refXOff);
+								refRegion[1] = std::min(refRegion[1], block.refYOff);
+								refRegion[2] = std::max(refRegion[2], block.refXOff + block.width);
+								refRegion[3] = std::max(refRegion[3], block.refYOff + block.height);
+								floatRegion[0] = std::min(floatRegion[0], block.floatXOff);
+								floatRegion[1] = std::min(floatRegion[1], block.floatYOff);
+								floatRegion[2] = std::max(floatRegion[2], block.floatXOff + block.width);
+								floatRegion[3] = std::max(floatRegion[3], block.floatYOff + block.height);
 							}
-							
-							for(unsigned int i = 0; i < overlap->numRefBands; ++i)
-							{
-								delete[] refDataBlock[i];
-								delete[] floatDataBlock[i];
-							}
-							delete[] refDataBlock;
-							delete[] floatDataBlock;
 						}
 					}
-					catch (RSGISRegistrationException &e) 
+					catch (RSGISRegistrationException &e)
 					{
 						// ignore
 						std::cerr << "Tie Point = [" << tiePt->xRef << "," << tiePt->yRef << "]\n";
 						std::cerr << "Shift = [" << (xShift+tiePt->xShift) << "," << (yShift+tiePt->yShift) << "]\n";
 						std::cerr << "WARNING: " << e.what() << std::endl;
 					}
-					xIdx++;
 				}
-				++yIdx;
 			}
 			
-			float subPixelXShift = 0;
-			float subPixelYShift = 0;
-			float subPixelXMetric = currentMetricVal;
-			float subPixelYMetric = currentMetricVal;
+			bool found = false;
+			double currentMetricVal = 0;
+			unsigned int currentXIdx = 0;
+			unsigned int currentYIdx = 0;
 			
-			rsgis::math::RSGISPolyFit polyFit;
-									
-			// Find subpixel component
-			if(searchArea == 1)
+			if(anyValid)
 			{
-				// 2nd Order Poly
-				// Find subpixel X
-				if((currentXIdx != 0) & (currentXIdx != (numSearchPoints-1)))
+				unsigned int refRegionWidth = refRegion[2] - refRegion[0];
+				unsigned int refRegionHeight = refRegion[3] - refRegion[1];
+				unsigned int floatRegionWidth = floatRegion[2] - floatRegion[0];
+				unsigned int floatRegionHeight = floatRegion[3] - floatRegion[1];
+				unsigned int numRefDataVals = 0;
+				unsigned int numFloatDataVals = 0;
 				{
-					gsl_matrix *inputDataMatrix = gsl_matrix_alloc(3,2);
-					gsl_matrix_set (inputDataMatrix, 0, 0, -1);
-					gsl_matrix_set (inputDataMatrix, 0, 1, imageSimilarity[currentYIdx][currentXIdx-1]);
-					gsl_matrix_set (inputDataMatrix, 1, 0, 0);
-					gsl_matrix_set (inputDataMatrix, 1, 1, imageSimilarity[currentYIdx][currentXIdx]);
-					gsl_matrix_set (inputDataMatrix, 2, 0, 1);
-					gsl_matrix_set (inputDataMatrix, 2, 1, imageSimilarity[currentYIdx][currentXIdx+1]);
-					
-					unsigned int order = 3; // 2nd Order - starts at zero.
-					gsl_vector *coefficients = polyFit.PolyfitOneDimensionQuiet(order, inputDataMatrix);
-					
-					subPixelXShift = findExtreme(metric->findMin(), coefficients, order, -1, 1, subPixelResolution, &subPixelXMetric);
-					
-					gsl_matrix_free(inputDataMatrix);
+					std::lock_guard<std::mutex> lock(this->ioMutex);
+					refData = imgUtils.getImageDataBlock(referenceIMG, refRegion, refRegionWidth, refRegionHeight, &numRefDataVals);
+					floatData = imgUtils.getImageDataBlock(floatingIMG, floatRegion, floatRegionWidth, floatRegionHeight, &numFloatDataVals);
 				}
-
-				// Find subpixel Y
-				if((currentYIdx != 0) & (currentYIdx != (numSearchPoints-1)))
+				
+				std::vector<float> refBlockData;
+				std::vector<float> floatBlockData;
+				std::vector<float*> refBlock(numBands, NULL);
+				std::vector<float*> floatBlock(numBands, NULL);
+				
+				// With the correlation metric the sums of each block are found from
+				// summed-area tables of the regions (of the values less the region
+				// mean), so only the sum of the products is calculated for each shift.
+				bool useSumTables = false;
+				double refMean = 0;
+				double floatMean = 0;
+				std::vector<double> refSAT;
+				std::vector<double> refSATSq;
+				std::vector<double> floatSAT;
+				std::vector<double> floatSATSq;
+				if(dynamic_cast<RSGISCorrelationSimilarityMetric*>(metric) != NULL)
 				{
-					gsl_matrix *inputDataMatrix = gsl_matrix_alloc(3,2);
-					gsl_matrix_set (inputDataMatrix, 0, 0, -1);
-					gsl_matrix_set (inputDataMatrix, 0, 1, imageSimilarity[currentYIdx-1][currentXIdx]);
-					gsl_matrix_set (inputDataMatrix, 1, 0, 0);
-					gsl_matrix_set (inputDataMatrix, 1, 1, imageSimilarity[currentYIdx][currentXIdx]);
-					gsl_matrix_set (inputDataMatrix, 2, 0, 1);
-					gsl_matrix_set (inputDataMatrix, 2, 1, imageSimilarity[currentYIdx+1][currentXIdx]);
-					
-					unsigned int order = 3; // 2nd Order - starts at zero.
-					gsl_vector *coefficients = polyFit.PolyfitOneDimensionQuiet(order, inputDataMatrix);
-					
-					subPixelYShift = findExtreme(metric->findMin(), coefficients, order, -1, 1, subPixelResolution, &subPixelYMetric);
-					
-					gsl_matrix_free(inputDataMatrix);
+					useSumTables = this->calcSummedAreaTables(refData, refRegionWidth, refRegionHeight, numBands, &refMean, &refSAT, &refSATSq) && this->calcSummedAreaTables(floatData, floatRegionWidth, floatRegionHeight, numBands, &floatMean, &floatSAT, &floatSATSq);
 				}
-			}
-			else
-			{
-				// 4th Order Poly
-				if((currentXIdx > 1) & (currentXIdx < (numSearchPoints-2)))
+				auto sumWindow = [](const std::vector<double> &sat, unsigned int regionWidth, int xOff, int yOff, int width, int height)
 				{
-					gsl_matrix *inputDataMatrix = gsl_matrix_alloc(5,2);
-					gsl_matrix_set (inputDataMatrix, 0, 0, -2);
-					gsl_matrix_set (inputDataMatrix, 0, 1, imageSimilarity[currentYIdx][currentXIdx-2]);
-					gsl_matrix_set (inputDataMatrix, 1, 0, -1);
-					gsl_matrix_set (inputDataMatrix, 1, 1, imageSimilarity[currentYIdx][currentXIdx-1]);
-					gsl_matrix_set (inputDataMatrix, 2, 0, 0);
-					gsl_matrix_set (inputDataMatrix, 2, 1, imageSimilarity[currentYIdx][currentXIdx]);
-					gsl_matrix_set (inputDataMatrix, 3, 0, 1);
-					gsl_matrix_set (inputDataMatrix, 3, 1, imageSimilarity[currentYIdx][currentXIdx+1]);
-					gsl_matrix_set (inputDataMatrix, 4, 0, 2);
-					gsl_matrix_set (inputDataMatrix, 4, 1, imageSimilarity[currentYIdx][currentXIdx+2]);
-					
-					unsigned int order = 4; // 3rd Order - starts at zero.
-					gsl_vector *coefficients = polyFit.PolyfitOneDimensionQuiet(order, inputDataMatrix);
-					
-					subPixelXShift = findExtreme(metric->findMin(), coefficients, order, -1, 1, subPixelResolution, &subPixelXMetric);
-					
-					gsl_matrix_free(inputDataMatrix);
-					gsl_vector_free(coefficients);
+					size_t satWidth = regionWidth + 1;
+					size_t tl = (((size_t)yOff) * satWidth) + xOff;
+					size_t bl = tl + (((size_t)height) * satWidth);
+					return sat[bl + width] - sat[bl] - sat[tl + width] + sat[tl];
+				};
+				
+				// Calculate the metric for a shift at full resolution (if not already calculated).
+				auto calcMetric = [&](unsigned int xIdx, unsigned int yIdx)
+				{
+					unsigned int idx = (yIdx*numSearchPoints)+xIdx;
+					if(calculated[idx])
+					{
+						return;
+					}
+					calculated[idx] = true;
+					const SearchBlock &block = searchBlocks[idx];
+					if(!block.valid)
+					{
+						return;
+					}
+					unsigned int numVals = block.width * block.height;
+					if(useSumTables)
+					{
+						int refX = block.refXOff - refRegion[0];
+						int refY = block.refYOff - refRegion[1];
+						int floatX = block.floatXOff - floatRegion[0];
+						int floatY = block.floatYOff - floatRegion[1];
+						double sumRF = 0;
+						for(unsigned int n = 0; n < numBands; ++n)
+						{
+							for(int r = 0; r < block.height; ++r)
+							{
+								const float *refRow = refData[n] + ((refY + r)*refRegionWidth) + refX;
+								const float *floatRow = floatData[n] + ((floatY + r)*floatRegionWidth) + floatX;
+								double rowSum = 0;
+								for(int c = 0; c < block.width; ++c)
+								{
+									rowSum += (refRow[c] - refMean) * (floatRow[c] - floatMean);
+								}
+								sumRF += rowSum;
+							}
+						}
+						imageSimilarity[yIdx][xIdx] = RSGISCorrelationSimilarityMetric::calcValueFromSums(sumRF, sumWindow(refSAT, refRegionWidth, refX, refY, block.width, block.height), sumWindow(floatSAT, floatRegionWidth, floatX, floatY, block.width, block.height), sumWindow(refSATSq, refRegionWidth, refX, refY, block.width, block.height), sumWindow(floatSATSq, floatRegionWidth, floatX, floatY, block.width, block.height), numVals*numBands);
+						return;
+					}
+					refBlockData.resize(numVals*numBands);
+					floatBlockData.resize(numVals*numBands);
+					for(unsigned int n = 0; n < numBands; ++n)
+					{
+						refBlock[n] = &refBlockData[n*numVals];
+						floatBlock[n] = &floatBlockData[n*numVals];
+						for(int r = 0; r < block.height; ++r)
+						{
+							float *refRow = refData[n] + (((block.refYOff - refRegion[1]) + r)*refRegionWidth) + (block.refXOff - refRegion[0]);
+							float *floatRow = floatData[n] + (((block.floatYOff - floatRegion[1]) + r)*floatRegionWidth) + (block.floatXOff - floatRegion[0]);
+							std::copy(refRow, refRow + block.width, refBlock[n] + (r*block.width));
+							std::copy(floatRow, floatRow + block.width, floatBlock[n] + (r*block.width));
+						}
+					}
+					imageSimilarity[yIdx][xIdx] = metric->calcValue(refBlock.data(), floatBlock.data(), numVals, numBands);
+				};
+				
+				// Find the best of the shifts calculated (in the same order as an exhaustive search).
+				auto findBest = [&](unsigned int *bestXIdx, unsigned int *bestYIdx, double *bestVal)
+				{
+					bool first = true;
+					for(unsigned int yIdx = 0; yIdx < numSearchPoints; ++yIdx)
+					{
+						for(unsigned int xIdx = 0; xIdx < numSearchPoints; ++xIdx)
+						{
+							float metricVal = imageSimilarity[yIdx][xIdx];
+							if((!calculated[(yIdx*numSearchPoints)+xIdx]) || ((boost::math::isnan)(metricVal)))
+							{
+								continue;
+							}
+							if(first || (metric->findMin() & (metricVal < *bestVal)) || (!metric->findMin() & (metricVal > *bestVal)))
+							{
+								*bestVal = metricVal;
+								*bestXIdx = xIdx;
+								*bestYIdx = yIdx;
+								first = false;
+							}
+						}
+					}
+					return !first;
+				};
+				
+				// Use the levels where the shift is within the search area and the decimated block is at least 4x4.
+				const SearchBlock &centreBlock = searchBlocks[(searchArea*numSearchPoints)+searchArea];
+				unsigned int numLevels = 0;
+				if(centreBlock.valid)
+				{
+					while((numLevels < this->numPyramidLevels) && ((2u << numLevels) <= searchArea) && ((centreBlock.width >> (numLevels+1)) >= 4) && ((centreBlock.height >> (numLevels+1)) >= 4))
+					{
+						++numLevels;
+					}
 				}
 				
-				if((currentYIdx > 1) & (currentYIdx < (numSearchPoints-2)))
+				if(this->useFFTCorrelation && (dynamic_cast<RSGISCorrelationSimilarityMetric*>(metric) != NULL) && this->calcCorrelationSurfaceFFT(refData, refRegion, floatData, floatRegion, searchBlocks, similarityData.data()))
 				{
-					gsl_matrix *inputDataMatrix = gsl_matrix_alloc(5,2);
-					gsl_matrix_set (inputDataMatrix, 0, 0, -2);
-					gsl_matrix_set (inputDataMatrix, 0, 1, imageSimilarity[currentYIdx-2][currentXIdx]);
-					gsl_matrix_set (inputDataMatrix, 1, 0, -1);
-					gsl_matrix_set (inputDataMatrix, 1, 1, imageSimilarity[currentYIdx-1][currentXIdx]);
-					gsl_matrix_set (inputDataMatrix, 2, 0, 0);
-					gsl_matrix_set (inputDataMatrix, 2, 1, imageSimilarity[currentYIdx][currentXIdx]);
-					gsl_matrix_set (inputDataMatrix, 3, 0, 1);
-					gsl_matrix_set (inputDataMatrix, 3, 1, imageSimilarity[currentYIdx+1][currentXIdx]);
-					gsl_matrix_set (inputDataMatrix, 4, 0, 2);
-					gsl_matrix_set (inputDataMatrix, 4, 1, imageSimilarity[currentYIdx+2][currentXIdx]);
-					
-					unsigned int order = 4; // 3rd Order - starts at zero.
-					gsl_vector *coefficients = polyFit.PolyfitOneDimensionQuiet(order, inputDataMatrix);
-					
-					subPixelYShift = findExtreme(metric->findMin(), coefficients, order, -1, 1, subPixelResolution, &subPixelYMetric);
+					calculated.assign(calculated.size(), true);
+					found = findBest(&currentXIdx, &currentYIdx, &currentMetricVal);
+				}
+				else if(numLevels == 0)
+				{
+					for(unsigned int yIdx = 0; yIdx < numSearchPoints; ++yIdx)
+					{
+						for(unsigned int xIdx = 0; xIdx < numSearchPoints; ++xIdx)
+						{
+							calcMetric(xIdx, yIdx);
+						}
+					}
+					found = findBest(&currentXIdx, &currentYIdx, &currentMetricVal);
+				}
+				else
+				{
+					// At the coarse levels the blocks are those at the current shift
+					// (the floating block moving by the shift), decimated in place.
+					int bestKX = 0;
+					int bestKY = 0;
+					bool firstLevel = true;
+					std::vector<float> decRefData;
+					std::vector<float> decFloatData;
+					for(int level = numLevels; level > 0; --level)
+					{
+						unsigned int factor = 1 << level;
+						unsigned int blockWidth = centreBlock.width / factor;
+						unsigned int blockHeight = centreBlock.height / factor;
+						unsigned int refXPhase = (centreBlock.refXOff - refRegion[0]) % factor;
+						unsigned int refYPhase = (centreBlock.refYOff - refRegion[1]) % factor;
+						unsigned int floatXPhase = (centreBlock.floatXOff - floatRegion[0]) % factor;
+						unsigned int floatYPhase = (centreBlock.floatYOff - floatRegion[1]) % factor;
+						unsigned int decRefWidth = (refRegionWidth - refXPhase) / factor;
+						unsigned int decRefHeight = (refRegionHeight - refYPhase) / factor;
+						unsigned int decFloatWidth = (floatRegionWidth - floatXPhase) / factor;
+						unsigned int decFloatHeight = (floatRegionHeight - floatYPhase) / factor;
+						decRefData.resize(decRefWidth*decRefHeight*numBands);
+						decFloatData.resize(decFloatWidth*decFloatHeight*numBands);
+						for(unsigned int n = 0; n < numBands; ++n)
+						{
+							this->decimateBlock(refData[n], refRegionWidth, refXPhase, refYPhase, factor, &decRefData[n*decRefWidth*decRefHeight], decRefWidth, decRefHeight);
+							this->decimateBlock(floatData[n], floatRegionWidth, floatXPhase, floatYPhase, factor, &decFloatData[n*decFloatWidth*decFloatHeight], decFloatWidth, decFloatHeight);
+						}
+						int refBlockX = (centreBlock.refXOff - refRegion[0]) / factor;
+						int refBlockY = (centreBlock.refYOff - refRegion[1]) / factor;
+						int floatBlockX = (centreBlock.floatXOff - floatRegion[0]) / factor;
+						int floatBlockY = (centreBlock.floatYOff - floatRegion[1]) / factor;
+						
+						int maxK = searchArea / factor;
+						int kXStart = -maxK;
+						int kXEnd = maxK;
+						int kYStart = -maxK;
+						int kYEnd = maxK;
+						if(!firstLevel)
+						{
+							kXStart = std::max(-maxK, (bestKX*2)-1);
+							kXEnd = std::min(maxK, (bestKX*2)+1);
+							kYStart = std::max(-maxK, (bestKY*2)-1);
+							kYEnd = std::min(maxK, (bestKY*2)+1);
+						}
+						
+						unsigned int numVals = blockWidth * blockHeight;
+						refBlockData.resize(numVals*numBands);
+						floatBlockData.resize(numVals*numBands);
+						bool levelFound = false;
+						double levelBestVal = 0;
+						int levelBestKX = 0;
+						int levelBestKY = 0;
+						for(int kY = kYStart; kY <= kYEnd; ++kY)
+						{
+							for(int kX = kXStart; kX <= kXEnd; ++kX)
+							{
+								// A shift moves the floating block back by the shift.
+								int xOff = floatBlockX - kX;
+								int yOff = floatBlockY - kY;
+								if((xOff < 0) || (yOff < 0) || ((xOff + blockWidth) > decFloatWidth) || ((yOff + blockHeight) > decFloatHeight))
+								{
+									continue;
+								}
+								for(unsigned int n = 0; n < numBands; ++n)
+								{
+									refBlock[n] = &refBlockData[n*numVals];
+									floatBlock[n] = &floatBlockData[n*numVals];
+									for(unsigned int r = 0; r < blockHeight; ++r)
+									{
+										float *refRow = &decRefData[(n*decRefWidth*decRefHeight) + ((refBlockY + r)*decRefWidth) + refBlockX];
+										float *floatRow = &decFloatData[(n*decFloatWidth*decFloatHeight) + ((yOff + r)*decFloatWidth) + xOff];
+										std::copy(refRow, refRow + blockWidth, refBlock[n] + (r*blockWidth));
+										std::copy(floatRow, floatRow + blockWidth, floatBlock[n] + (r*blockWidth));
+									}
+								}
+								float metricVal = metric->calcValue(refBlock.data(), floatBlock.data(), numVals, numBands);
+								if((boost::math::isnan)(metricVal))
+								{
+									continue;
+								}
+								if((!levelFound) || (metric->findMin() & (metricVal < levelBestVal)) || (!metric->findMin() & (metricVal > levelBestVal)))
+								{
+									levelBestVal = metricVal;
+									levelBestKX = kX;
+									levelBestKY = kY;
+									levelFound = true;
+								}
+							}
+						}
+						if(levelFound)
+						{
+							bestKX = levelBestKX;
+							bestKY = levelBestKY;
+						}
+						else
+						{
+							bestKX *= 2;
+							bestKY *= 2;
+						}
+						firstLevel = false;
+					}
 					
-					gsl_matrix_free(inputDataMatrix);
-					gsl_vector_free(coefficients);
+					// Refine at full resolution, moving while the best shift is not the
+					// centre of those calculated (which also gives the neighbours needed
+					// for the sub-pixel fit).
+					int localRad = (searchArea == 1)?1:2;
+					int bestX = std::min(std::max(searchAreaInt + (bestKX*2), 0), (int)numSearchPoints-1);
+					int bestY = std::min(std::max(searchAreaInt + (bestKY*2), 0), (int)numSearchPoints-1);
+					while(true)
+					{
+						for(int yIdx = std::max(bestY - localRad, 0); yIdx <= std::min(bestY + localRad, (int)numSearchPoints-1); ++yIdx)
+						{
+							for(int xIdx = std::max(bestX - localRad, 0); xIdx <= std::min(bestX + localRad, (int)numSearchPoints-1); ++xIdx)
+							{
+								calcMetric(xIdx, yIdx);
+							}
+						}
+						found = findBest(&currentXIdx, &currentYIdx, &currentMetricVal);
+						if((!found) || ((((int)currentXIdx) == bestX) && (((int)currentYIdx) == bestY)))
+						{
+							break;
+						}
+						bestX = currentXIdx;
+						bestY = currentYIdx;
+					}
 				}
 				
+				for(unsigned int i = 0; i < overlap->numRefBands; ++i)
+				{
+					delete[] refData[i];
+				}
+				delete[] refData;
+				refData = NULL;
+				for(unsigned int i = 0; i < overlap->numFloatBands; ++i)
+				{
+					delete[] floatData[i];
+				}
+				delete[] floatData;
+				floatData = NULL;
 			}
 			
-			currentMetricVal = (subPixelXMetric + subPixelYMetric)/2;
-            
-            // Calculate final shift, adding on offsets due to rounding in image overlap calculation
-            float finalXShift = (((float)currentShiftX) + subPixelXShift) + currentRemainderX;
-			float finalYShift = (((float)currentShiftY) + subPixelYShift) + currentRemainderY;
-            
-			distanceMoved = sqrt(((finalXShift*finalXShift)+(finalYShift*finalYShift))/2);
-			*moveInX = finalXShift;
-			*moveInY = finalYShift;
-            
-			if(metric->findMin() & (currentMetricVal < metricThreshold))
+			if(found)
 			{
-				tiePt->xShift += finalXShift;
-				tiePt->yShift += finalYShift;
-				tiePt->metricVal = currentMetricVal;
-			}
-			else if(!metric->findMin() & (currentMetricVal > metricThreshold))
-			{
-				tiePt->xShift += finalXShift;
-				tiePt->yShift += finalYShift;
-				tiePt->metricVal = currentMetricVal;
+				float subPixelXShift = 0;
+				float subPixelYShift = 0;
+				currentMetricVal = this->findSubPixelShift(imageSimilarity.data(), numSearchPoints, currentXIdx, currentYIdx, currentMetricVal, metric, subPixelResolution, &subPixelXShift, &subPixelYShift);
+				
+				// Calculate final shift, adding on offsets due to rounding in image overlap calculation
+				const SearchBlock &bestBlock = searchBlocks[(currentYIdx*numSearchPoints)+currentXIdx];
+				float finalXShift = ((((float)currentXIdx) - ((float)searchArea)) + subPixelXShift) + bestBlock.remainderX;
+				float finalYShift = ((((float)currentYIdx) - ((float)searchArea)) + subPixelYShift) + bestBlock.remainderY;
+				
+				distanceMoved = sqrt(((finalXShift*finalXShift)+(finalYShift*finalYShift))/2);
+				*moveInX = finalXShift;
+				*moveInY = finalYShift;
+				
+				if(metric->findMin() & (currentMetricVal < metricThreshold))
+				{
+					tiePt->xShift += finalXShift;
+					tiePt->yShift += finalYShift;
+					tiePt->metricVal = currentMetricVal;
+				}
+				else if(!metric->findMin() & (currentMetricVal > metricThreshold))
+				{
+					tiePt->xShift += finalXShift;
+					tiePt->yShift += finalYShift;
+					tiePt->metricVal = currentMetricVal;
+				}
+				else
+				{
+					found = false;
+				}
 			}
-			else
+			
+			if(!found)
 			{
 				tiePt->metricVal = std::numeric_limits<double>::signaling_NaN();//NAN;
 				distanceMoved = 0;
 				*moveInX = 0;
 				*moveInY = 0;
 			}
-			
-			
-			delete[] overlapTransform;
-			delete[] dsOffsets[0];
-			delete[] dsOffsets[1];
-			delete[] dsOffsets;
 		}
-		catch (rsgis::img::RSGISImageBandException &e) 
+		catch (rsgis::img::RSGISImageBandException &e)
 		{
 			throw RSGISRegistrationException(e.what());
 		}
-		catch (RSGISRegistrationException &e) 
+		
+		return distanceMoved;
+	}
+	
+	bool RSGISImageRegistration::calcSummedAreaTables(float **data, unsigned int width, unsigned int height, unsigned int numBands, double *mean, std::vector<double> *sat, std::vector<double> *satSq)
+	{
+		// The tables are summed over all the bands, of the values less the
+		// mean (to limit the loss of precision when differencing the sums),
+		// with a leading row and column of 0. Returns false if there are NaNs.
+		size_t numVals = ((size_t)width) * height;
+		double sum = 0;
+		for(unsigned int n = 0; n < numBands; ++n)
 		{
-			throw e;
+			for(size_t i = 0; i < numVals; ++i)
+			{
+				if((boost::math::isnan)(data[n][i]))
+				{
+					return false;
+				}
+				sum += data[n][i];
+			}
 		}
+		*mean = sum / (((double)numVals) * numBands);
 		
-		return distanceMoved;
+		size_t satWidth = width + 1;
+		sat->assign(satWidth * (height + 1), 0.0);
+		satSq->assign(satWidth * (height + 1), 0.0);
+		for(unsigned int y = 0; y < height; ++y)
+		{
+			double rowSum = 0;
+			double rowSumSq = 0;
+			size_t idx = ((y + 1) * satWidth) + 1;
+			for(unsigned int x = 0; x < width; ++x, ++idx)
+			{
+				for(unsigned int n = 0; n < numBands; ++n)
+				{
+					double val = data[n][(((size_t)y) * width) + x] - *mean;
+					rowSum += val;
+					rowSumSq += val * val;
+				}
+				(*sat)[idx] = (*sat)[idx - satWidth] + rowSum;
+				(*satSq)[idx] = (*satSq)[idx - satWidth] + rowSumSq;
+			}
+		}
+		return true;
+	}
+	
+	bool RSGISImageRegistration::calcCorrelationSurfaceFFT(float **refData, int *refRegion, float **floatData, int *floatRegion, const std::vector<SearchBlock> &searchBlocks, float *similarity)
+	{
+		// All the shifts must compare the same reference block with a floating
+		// block of the same size (i.e., none are clipped by the image edges).
+		const SearchBlock &firstBlock = searchBlocks[0];
+		for(std::vector<SearchBlock>::const_iterator iterBlock = searchBlocks.begin(); iterBlock != searchBlocks.end(); ++iterBlock)
+		{
+			if((!iterBlock->valid) || (iterBlock->width != firstBlock.width) || (iterBlock->height != firstBlock.height) || (iterBlock->refXOff != firstBlock.refXOff) || (iterBlock->refYOff != firstBlock.refYOff))
+			{
+				return false;
+			}
+		}
+		unsigned int numBands = overlap->numRefBands;
+		unsigned int blockWidth = firstBlock.width;
+		unsigned int blockHeight = firstBlock.height;
+		unsigned int refRegionWidth = refRegion[2] - refRegion[0];
+		unsigned int floatRegionWidth = floatRegion[2] - floatRegion[0];
+		unsigned int floatRegionHeight = floatRegion[3] - floatRegion[1];
+		size_t numFloatVals = ((size_t)floatRegionWidth) * floatRegionHeight;
+		
+		// The metric sums over all the bands, so the values are centred on
+		// the mean of all the bands (which does not change the correlation).
+		double refMean = 0;
+		double floatMean = 0;
+		for(unsigned int n = 0; n < numBands; ++n)
+		{
+			for(unsigned int y = 0; y < blockHeight; ++y)
+			{
+				float *refRow = refData[n] + (((firstBlock.refYOff - refRegion[1]) + y)*refRegionWidth) + (firstBlock.refXOff - refRegion[0]);
+				for(unsigned int x = 0; x < blockWidth; ++x)
+				{
+					if((boost::math::isnan)(refRow[x]))
+					{
+						return false;
+					}
+					refMean += refRow[x];
+				}
+			}
+		}
+		double numVals = ((double)blockWidth) * blockHeight * numBands;
+		refMean /= numVals;
+		// Summed-area tables of the floating values and their squares.
+		std::vector<double> satF;
+		std::vector<double> satFSq;
+		if(!this->calcSummedAreaTables(floatData, floatRegionWidth, floatRegionHeight, numBands, &floatMean, &satF, &satFSq))
+		{
+			return false;
+		}
+		
+		unsigned int fftWidth = rsgis::math::RSGISFFTWUtils::nextPowerOfTwo(floatRegionWidth);
+		unsigned int fftHeight = rsgis::math::RSGISFFTWUtils::nextPowerOfTwo(floatRegionHeight);
+		size_t numFFTVals = ((size_t)fftWidth) * fftHeight;
+		std::vector<std::complex<double> > refFFT(numFFTVals);
+		std::vector<std::complex<double> > floatFFT(numFFTVals);
+		std::vector<double> sumRF(numFloatVals, 0.0);
+		size_t satWidth = floatRegionWidth + 1;
+		double sumRSq = 0;
+		
+		for(unsigned int n = 0; n < numBands; ++n)
+		{
+			std::fill(refFFT.begin(), refFFT.end(), std::complex<double>(0, 0));
+			std::fill(floatFFT.begin(), floatFFT.end(), std::complex<double>(0, 0));
+			for(unsigned int y = 0; y < blockHeight; ++y)
+			{
+				float *refRow = refData[n] + (((firstBlock.refYOff - refRegion[1]) + y)*refRegionWidth) + (firstBlock.refXOff - refRegion[0]);
+				for(unsigned int x = 0; x < blockWidth; ++x)
+				{
+					double val = refRow[x] - refMean;
+					refFFT[(((size_t)y) * fftWidth) + x] = val;
+					sumRSq += val * val;
+				}
+			}
+			for(unsigned int y = 0; y < floatRegionHeight; ++y)
+			{
+				for(unsigned int x = 0; x < floatRegionWidth; ++x)
+				{
+					floatFFT[(((size_t)y) * fftWidth) + x] = floatData[n][(((size_t)y) * floatRegionWidth) + x] - floatMean;
+				}
+			}
+			
+			// Cross-correlation: IFFT(conj(FFT(ref)) * FFT(float)) at (x, y) is the
+			// sum of the products with the floating block starting at (x, y).
+			this->fftUtils.fft2D(refFFT.data(), fftWidth, fftHeight, false);
+			this->fftUtils.fft2D(floatFFT.data(), fftWidth, fftHeight, false);
+			for(size_t i = 0; i < numFFTVals; ++i)
+			{
+				floatFFT[i] = std::conj(refFFT[i]) * floatFFT[i];
+			}
+			this->fftUtils.fft2D(floatFFT.data(), fftWidth, fftHeight, true);
+			for(unsigned int y = 0; y < floatRegionHeight; ++y)
+			{
+				for(unsigned int x = 0; x < floatRegionWidth; ++x)
+				{
+					sumRF[(((size_t)y) * floatRegionWidth) + x] += floatFFT[(((size_t)y) * fftWidth) + x].real();
+				}
+			}
+		}
+		for(size_t i = 0; i < searchBlocks.size(); ++i)
+		{
+			size_t xOff = searchBlocks[i].floatXOff - floatRegion[0];
+			size_t yOff = searchBlocks[i].floatYOff - floatRegion[1];
+			size_t tl = (yOff * satWidth) + xOff;
+			size_t tr = tl + blockWidth;
+			size_t bl = tl + (blockHeight * satWidth);
+			size_t br = bl + blockWidth;
+			double sumF = satF[br] - satF[bl] - satF[tr] + satF[tl];
+			double sumFSq = satFSq[br] - satFSq[bl] - satFSq[tr] + satFSq[tl];
+			// As RSGISCorrelationSimilarityMetric, where the sum of the (centred) reference values is 0.
+			float val = (numVals * sumRF[(yOff * floatRegionWidth) + xOff])/sqrt((numVals*sumRSq)*((numVals*sumFSq)-(sumF*sumF)));
+			if(val < 0)
+			{
+				val *= -1;
+			}
+			similarity[i] = val;
+		}
+		return true;
+	}
+	
+	void RSGISImageRegistration::decimateBlock(float *inData, unsigned int inWidth, unsigned int xOff, unsigned int yOff, unsigned int factor, float *outData, unsigned int outWidth, unsigned int outHeight)
+	{
+		// Mean of the (non-NaN) values within each factor x factor cell.
+		for(unsigned int y = 0; y < outHeight; ++y)
+		{
+			for(unsigned int x = 0; x < outWidth; ++x)
+			{
+				double sum = 0;
+				unsigned int count = 0;
+				for(unsigned int j = 0; j < factor; ++j)
+				{
+					float *inRow = inData + ((yOff + (y*factor) + j)*inWidth) + xOff + (x*factor);
+					for(unsigned int i = 0; i < factor; ++i)
+					{
+						if(!((boost::math::isnan)(inRow[i])))
+						{
+							sum += inRow[i];
+							++count;
+						}
+					}
+				}
+				outData[(y*outWidth)+x] = (count > 0)?(sum/count):std::numeric_limits<float>::quiet_NaN();
+			}
+		}
 	}
     
     float RSGISImageRegistration::findTiePointLocation(TiePoint *tiePt, unsigned int windowSize, unsigned int searchArea, RSGISImageSimilarityMetric *metric, unsigned int subPixelResolution, float *moveInX, float *moveInY)
@@ -559,105 +919,7 @@ namespace rsgis{namespace reg{
 			
 			float subPixelXShift = 0;
 			float subPixelYShift = 0;
-			float subPixelXMetric = currentMetricVal;
-			float subPixelYMetric = currentMetricVal;
-			
-			rsgis::math::RSGISPolyFit polyFit;
-            
-			// Find subpixel component
-			if(searchArea == 1)
-			{
-				// 2nd Order Poly
-				// Find subpixel X
-				if((currentXIdx != 0) & (currentXIdx != (numSearchPoints-1)))
-				{
-					gsl_matrix *inputDataMatrix = gsl_matrix_alloc(3,2);
-					gsl_matrix_set (inputDataMatrix, 0, 0, -1);
-					gsl_matrix_set (inputDataMatrix, 0, 1, imageSimilarity[currentYIdx][currentXIdx-1]);
-					gsl_matrix_set (inputDataMatrix, 1, 0, 0);
-					gsl_matrix_set (inputDataMatrix, 1, 1, imageSimilarity[currentYIdx][currentXIdx]);
-					gsl_matrix_set (inputDataMatrix, 2, 0, 1);
-					gsl_matrix_set (inputDataMatrix, 2, 1, imageSimilarity[currentYIdx][currentXIdx+1]);
-					
-					unsigned int order = 3; // 2nd Order - starts at zero.
-					gsl_vector *coefficients = polyFit.PolyfitOneDimensionQuiet(order, inputDataMatrix);
-					
-					subPixelXShift = findExtreme(metric->findMin(), coefficients, order, -1, 1, subPixelResolution, &subPixelXMetric);
-					
-					gsl_matrix_free(inputDataMatrix);
-				}
-                
-				// Find subpixel Y
-				if((currentYIdx != 0) & (currentYIdx != (numSearchPoints-1)))
-				{
-					gsl_matrix *inputDataMatrix = gsl_matrix_alloc(3,2);
-					gsl_matrix_set (inputDataMatrix, 0, 0, -1);
-					gsl_matrix_set (inputDataMatrix, 0, 1, imageSimilarity[currentYIdx-1][currentXIdx]);
-					gsl_matrix_set (inputDataMatrix, 1, 0, 0);
-					gsl_matrix_set (inputDataMatrix, 1, 1, imageSimilarity[currentYIdx][currentXIdx]);
-					gsl_matrix_set (inputDataMatrix, 2, 0, 1);
-					gsl_matrix_set (inputDataMatrix, 2, 1, imageSimilarity[currentYIdx+1][currentXIdx]);
-					
-					unsigned int order = 3; // 2nd Order - starts at zero.
-					gsl_vector *coefficients = polyFit.PolyfitOneDimensionQuiet(order, inputDataMatrix);
-					
-					subPixelYShift = findExtreme(metric->findMin(), coefficients, order, -1, 1, subPixelResolution, &subPixelYMetric);
-					
-					gsl_matrix_free(inputDataMatrix);
-				}
-			}
-			else
-			{
-				// 4th Order Poly
-				if((currentXIdx > 1) & (currentXIdx < (numSearchPoints-2)))
-				{
-					gsl_matrix *inputDataMatrix = gsl_matrix_alloc(5,2);
-					gsl_matrix_set (inputDataMatrix, 0, 0, -2);
-					gsl_matrix_set (inputDataMatrix, 0, 1, imageSimilarity[currentYIdx][currentXIdx-2]);
-					gsl_matrix_set (inputDataMatrix, 1, 0, -1);
-					gsl_matrix_set (inputDataMatrix, 1, 1, imageSimilarity[currentYIdx][currentXIdx-1]);
-					gsl_matrix_set (inputDataMatrix, 2, 0, 0);
-					gsl_matrix_set (inputDataMatrix, 2, 1, imageSimilarity[currentYIdx][currentXIdx]);
-					gsl_matrix_set (inputDataMatrix, 3, 0, 1);
-					gsl_matrix_set (inputDataMatrix, 3, 1, imageSimilarity[currentYIdx][currentXIdx+1]);
-					gsl_matrix_set (inputDataMatrix, 4, 0, 2);
-					gsl_matrix_set (inputDataMatrix, 4, 1, imageSimilarity[currentYIdx][currentXIdx+2]);
-					
-					unsigned int order = 4; // 3th Order - starts at zero.
-					gsl_vector *coefficients = polyFit.PolyfitOneDimensionQuiet(order, inputDataMatrix);
-					
-					subPixelXShift = findExtreme(metric->findMin(), coefficients, order, -1, 1, subPixelResolution, &subPixelXMetric);
-					
-					gsl_matrix_free(inputDataMatrix);
-					gsl_vector_free(coefficients);
-				}
-				
-				if((currentYIdx > 1) & (currentYIdx < (numSearchPoints-2)))
-				{
-					gsl_matrix *inputDataMatrix = gsl_matrix_alloc(5,2);
-					gsl_matrix_set (inputDataMatrix, 0, 0, -2);
-					gsl_matrix_set (inputDataMatrix, 0, 1, imageSimilarity[currentYIdx-2][currentXIdx]);
-					gsl_matrix_set (inputDataMatrix, 1, 0, -1);
-					gsl_matrix_set (inputDataMatrix, 1, 1, imageSimilarity[currentYIdx-1][currentXIdx]);
-					gsl_matrix_set (inputDataMatrix, 2, 0, 0);
-					gsl_matrix_set (inputDataMatrix, 2, 1, imageSimilarity[currentYIdx][currentXIdx]);
-					gsl_matrix_set (inputDataMatrix, 3, 0, 1);
-					gsl_matrix_set (inputDataMatrix, 3, 1, imageSimilarity[currentYIdx+1][currentXIdx]);
-					gsl_matrix_set (inputDataMatrix, 4, 0, 2);
-					gsl_matrix_set (inputDataMatrix, 4, 1, imageSimilarity[currentYIdx+2][currentXIdx]);
-					
-					unsigned int order = 4; // 3th Order - starts at zero.
-					gsl_vector *coefficients = polyFit.PolyfitOneDimensionQuiet(order, inputDataMatrix);
-					
-					subPixelYShift = findExtreme(metric->findMin(), coefficients, order, -1, 1, subPixelResolution, &subPixelYMetric);
-					
-					gsl_matrix_free(inputDataMatrix);
-					gsl_vector_free(coefficients);
-				}
-				
-			}
-			
-			currentMetricVal = (subPixelXMetric + subPixelYMetric)/2;
+			currentMetricVal = this->findSubPixelShift(imageSimilarity, numSearchPoints, currentXIdx, currentYIdx, currentMetricVal, metric, subPixelResolution, &subPixelXShift, &subPixelYShift);
 			
             // Calculate final shift, adding on offsets due to rounding in image overlap calculation
             float finalXShift = (((float)currentShiftX) + subPixelXShift) + currentRemainderX;
@@ -688,6 +950,115 @@ namespace rsgis{namespace reg{
 		return distanceMoved;
 	}
 	
+	float RSGISImageRegistration::findSubPixelShift(float **imageSimilarity, unsigned int numSearchPoints, unsigned int currentXIdx, unsigned int currentYIdx, float currentMetricVal, RSGISImageSimilarityMetric *metric, unsigned int subPixelResolution, float *subPixelXShiftOut, float *subPixelYShiftOut)
+	{
+		float subPixelXShift = 0;
+		float subPixelYShift = 0;
+		float subPixelXMetric = currentMetricVal;
+		float subPixelYMetric = currentMetricVal;
+		
+		rsgis::math::RSGISPolyFit polyFit;
+								
+		// Find subpixel component
+		if(numSearchPoints == 3)
+		{
+			// 2nd Order Poly
+			// Find subpixel X
+			if((currentXIdx != 0) & (currentXIdx != (numSearchPoints-1)))
+			{
+				gsl_matrix *inputDataMatrix = gsl_matrix_alloc(3,2);
+				gsl_matrix_set (inputDataMatrix, 0, 0, -1);
+				gsl_matrix_set (inputDataMatrix, 0, 1, imageSimilarity[currentYIdx][currentXIdx-1]);
+				gsl_matrix_set (inputDataMatrix, 1, 0, 0);
+				gsl_matrix_set (inputDataMatrix, 1, 1, imageSimilarity[currentYIdx][currentXIdx]);
+				gsl_matrix_set (inputDataMatrix, 2, 0, 1);
+				gsl_matrix_set (inputDataMatrix, 2, 1, imageSimilarity[currentYIdx][currentXIdx+1]);
+				
+				unsigned int order = 3; // 2nd Order - starts at zero.
+				gsl_vector *coefficients = polyFit.PolyfitOneDimensionQuiet(order, inputDataMatrix);
+				
+				subPixelXShift = findExtreme(metric->findMin(), coefficients, order, -1, 1, subPixelResolution, &subPixelXMetric);
+				
+				gsl_matrix_free(inputDataMatrix);
+				gsl_vector_free(coefficients);
+			}
+
+			// Find subpixel Y
+			if((currentYIdx != 0) & (currentYIdx != (numSearchPoints-1)))
+			{
+				gsl_matrix *inputDataMatrix = gsl_matrix_alloc(3,2);
+				gsl_matrix_set (inputDataMatrix, 0, 0, -1);
+				gsl_matrix_set (inputDataMatrix, 0, 1, imageSimilarity[currentYIdx-1][currentXIdx]);
+				gsl_matrix_set (inputDataMatrix, 1, 0, 0);
+				gsl_matrix_set (inputDataMatrix, 1, 1, imageSimilarity[currentYIdx][currentXIdx]);
+				gsl_matrix_set (inputDataMatrix, 2, 0, 1);
+				gsl_matrix_set (inputDataMatrix, 2, 1, imageSimilarity[currentYIdx+1][currentXIdx]);
+				
+				unsigned int order = 3; // 2nd Order - starts at zero.
+				gsl_vector *coefficients = polyFit.PolyfitOneDimensionQuiet(order, inputDataMatrix);
+				
+				subPixelYShift = findExtreme(metric->findMin(), coefficients, order, -1, 1, subPixelResolution, &subPixelYMetric);
+				
+				gsl_matrix_free(inputDataMatrix);
+				gsl_vector_free(coefficients);
+			}
+		}
+		else
+		{
+			// 4th Order Poly
+			if((currentXIdx > 1) & (currentXIdx < (numSearchPoints-2)))
+			{
+				gsl_matrix *inputDataMatrix = gsl_matrix_alloc(5,2);
+				gsl_matrix_set (inputDataMatrix, 0, 0, -2);
+				gsl_matrix_set (inputDataMatrix, 0, 1, imageSimilarity[currentYIdx][currentXIdx-2]);
+				gsl_matrix_set (inputDataMatrix, 1, 0, -1);
+				gsl_matrix_set (inputDataMatrix, 1, 1, imageSimilarity[currentYIdx][currentXIdx-1]);
+				gsl_matrix_set (inputDataMatrix, 2, 0, 0);
+				gsl_matrix_set (inputDataMatrix, 2, 1, imageSimilarity[currentYIdx][currentXIdx]);
+				gsl_matrix_set (inputDataMatrix, 3, 0, 1);
+				gsl_matrix_set (inputDataMatrix, 3, 1, imageSimilarity[currentYIdx][currentXIdx+1]);
+				gsl_matrix_set (inputDataMatrix, 4, 0, 2);
+				gsl_matrix_set (inputDataMatrix, 4, 1, imageSimilarity[currentYIdx][currentXIdx+2]);
+				
+				unsigned int order = 4; // 3rd Order - starts at zero.
+				gsl_vector *coefficients = polyFit.PolyfitOneDimensionQuiet(order, inputDataMatrix);
+				
+				subPixelXShift = findExtreme(metric->findMin(), coefficients, order, -1, 1, subPixelResolution, &subPixelXMetric);
+				
+				gsl_matrix_free(inputDataMatrix);
+				gsl_vector_free(coefficients);
+			}
+			
+			if((currentYIdx > 1) & (currentYIdx < (numSearchPoints-2)))
+			{
+				gsl_matrix *inputDataMatrix = gsl_matrix_alloc(5,2);
+				gsl_matrix_set (inputDataMatrix, 0, 0, -2);
+				gsl_matrix_set (inputDataMatrix, 0, 1, imageSimilarity[currentYIdx-2][currentXIdx]);
+				gsl_matrix_set (inputDataMatrix, 1, 0, -1);
+				gsl_matrix_set (inputDataMatrix, 1, 1, imageSimilarity[currentYIdx-1][currentXIdx]);
+				gsl_matrix_set (inputDataMatrix, 2, 0, 0);
+				gsl_matrix_set (inputDataMatrix, 2, 1, imageSimilarity[currentYIdx][currentXIdx]);
+				gsl_matrix_set (inputDataMatrix, 3, 0, 1);
+				gsl_matrix_set (inputDataMatrix, 3, 1, imageSimilarity[currentYIdx+1][currentXIdx]);
+				gsl_matrix_set (inputDataMatrix, 4, 0, 2);
+				gsl_matrix_set (inputDataMatrix, 4, 1, imageSimilarity[currentYIdx+2][currentXIdx]);
+				
+				unsigned int order = 4; // 3rd Order - starts at zero.
+				gsl_vector *coefficients = polyFit.PolyfitOneDimensionQuiet(order, inputDataMatrix);
+				
+				subPixelYShift = findExtreme(metric->findMin(), coefficients, order, -1, 1, subPixelResolution, &subPixelYMetric);
+				
+				gsl_matrix_free(inputDataMatrix);
+				gsl_vector_free(coefficients);
+			}
+			
+		}
+		
+		*subPixelXShiftOut = subPixelXShift;
+		*subPixelYShiftOut = subPixelYShift;
+		return (subPixelXMetric + subPixelYMetric)/2;
+	}
+	
 	float RSGISImageRegistration::findExtreme(bool findMin, gsl_vector *coefficients, unsigned int order, float minRange, float maxRange, unsigned int resolution, float *extremeVal)
 	{
 		double division = ((float)1)/((float)resolution);
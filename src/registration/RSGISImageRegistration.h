@@ -30,18 +30,26 @@
 #include <string>
 #include <math.h>
 #include <list>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <thread>
+#include <mutex>
 
 #include "gdal_priv.h"
 #include "ogrsf_frmts.h"
 
 #include "common/RSGISRegistrationException.h"
+#include "common/RSGISParallel.h"
 
 #include "registration/RSGISImageSimilarityMetric.h"
+#include "registration/RSGISStandardImageSimilarityMetrics.h"
 
 #include "img/RSGISImageBandException.h"
 #include "img/RSGISImageUtils.h"
 
 #include "math/RSGISPolyFit.h"
+#include "math/RSGISFFTWUtils.h"
 
 #include "boost/math/special_functions/fpclassify.hpp"
 
@@ -136,8 +144,48 @@ namespace rsgis{namespace reg{
 			unsigned int numFloatBands;
 		};
 		
+		/**
+		 * The blocks of the reference and floating images compared for
+		 * a shift of the floating image.
+		 */
+		struct DllExport SearchBlock
+		{
+			bool valid;
+			int refXOff;
+			int refYOff;
+			int floatXOff;
+			int floatYOff;
+			int width;
+			int height;
+			float remainderX;
+			float remainderY;
+		};
+		
 		RSGISImageRegistration(GDALDataset *reference, GDALDataset *floating);
 		void runCompleteRegistration();
+		/**
+		 * Search for the tie point offsets coarse to fine: the offsets are first
+		 * found over images decimated (by a mean) by 2^numLevels, each level then
+		 * searching the neighbouring offsets at twice the resolution, before a local
+		 * search at full resolution. 0 (the default) searches every offset.
+		 */
+		void setNumPyramidLevels(unsigned int numLevels);
+		/**
+		 * The number of threads used to find tie points where they are independent
+		 * (0 uses the number of cores). The similarity metric must be thread safe.
+		 */
+		void setNumThreads(unsigned int numThreads);
+		/**
+		 * With the correlation metric, find the metric for every shift within
+		 * the search area at once from the cross-correlation of the reference
+		 * block and the floating image region, calculated with FFTs (and the
+		 * sums of the floating blocks from summed-area tables), so the cost does
+		 * not grow with the number of shifts. The values are those of
+		 * RSGISCorrelationSimilarityMetric and the sub-pixel fit is the same.
+		 * Tie points where the blocks are clipped by the image edges, or which
+		 * contain NaN values, are searched as normal.
+		 */
+		void setUseFFTCorrelation(bool useFFTCorrelation);
 		virtual void initRegistration()=0;
 		virtual void executeRegistration()=0;
 		virtual void finaliseRegistration()=0;
@@ -151,6 +199,10 @@ namespace rsgis{namespace reg{
 		void defineFirstTiePoint(unsigned int *startXOff, unsigned int *startYOff, unsigned int numXPts, unsigned int numYPts, unsigned int gap);
 		float findTiePointLocation(TiePoint *tiePt, unsigned int windowSize, unsigned int searchArea, RSGISImageSimilarityMetric *metric, float metricThreshold, unsigned int subPixelResolution, float *moveInX, float *moveInY);
         float findTiePointLocation(TiePoint *tiePt, unsigned int windowSize, unsigned int searchArea, RSGISImageSimilarityMetric *metric, unsigned int subPixelResolution, float *moveInX, float *moveInY);
+		float findSubPixelShift(float **imageSimilarity, unsigned int numSearchPoints, unsigned int currentXIdx, unsigned int currentYIdx, float currentMetricVal, RSGISImageSimilarityMetric *metric, unsigned int subPixelResolution, float *subPixelXShiftOut, float *subPixelYShiftOut);
+		bool calcSummedAreaTables(float **data, unsigned int width, unsigned int height, unsigned int numBands, double *mean, std::vector<double> *sat, std::vector<double> *satSq);
+		bool calcCorrelationSurfaceFFT(float **refData, int *refRegion, float **floatData, int *floatRegion, const std::vector<SearchBlock> &searchBlocks, float *similarity);
+		void decimateBlock(float *inData, unsigned int inWidth, unsigned int xOff, unsigned int yOff, unsigned int factor, float *outData, unsigned int outWidth, unsigned int outHeight);
 		float findExtreme(bool findMin, gsl_vector *coefficients, unsigned int order, float minRange, float maxRange, unsigned int resolution, float *extremeVal);
         void getImageOverlapFloat(GDALDataset **datasets, int numDS,  float **dsOffsets, int *width, int *height, double *gdalTransform);
 		void getImageOverlapWithFloatShift(float xShift, float yShift, int **dsOffsets, int *width, int *height, double *gdalTransform, geos::geom::Envelope *env, float *remainderX, float *remainderY);
@@ -164,6 +216,11 @@ namespace rsgis{namespace reg{
 		GDALDataset *floatingIMG;
 		OverlapRegion* overlap;
 		bool overlapDefined;
+		unsigned int numPyramidLevels;
+		unsigned int numThreads;
+		bool useFFTCorrelation;
+		rsgis::math::RSGISFFTWUtils fftUtils;
+		std::mutex ioMutex;
 	};
 }}
 
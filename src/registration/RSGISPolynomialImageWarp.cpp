@@ -31,6 +31,8 @@ namespace rsgis{namespace reg{
 	RSGISPolynomialImageWarp::RSGISPolynomialImageWarp(std::string inputImage, std::string outputImage, std::string outProjWKT, std::string gcpFilePath, float outImgRes, RSGISWarpImageInterpolator *interpolator, unsigned int polyOrder, std::string gdalFormat) : RSGISWarpImage(inputImage, outputImage, outProjWKT, gcpFilePath, outImgRes, interpolator, gdalFormat)
 	{
 		this->polyOrder = polyOrder;
+		this->continuousTransform = true;
+		this->threadSafeTransform = true;
         std::cout << "polyOrder = " << polyOrder << std::endl;
 	}
 	
@@ -230,6 +232,16 @@ namespace rsgis{namespace reg{
            Pixel x and y coordinates are found from polynominal model */
         double pX = 0;
         double pY = 0;
+        this->findPixelLocation(eastings, northings, &pX, &pY, inImgRes);
+    
+        *x = ceil(pX);
+		*y = ceil(pY);
+	}
+	
+	void RSGISPolynomialImageWarp::findPixelLocation(double eastings, double northings, double *x, double *y, float inImgRes)
+	{
+        double pX = 0;
+        double pY = 0;
         unsigned int offset = 0;
         
         // Add pixel values into vectors        
@@ -256,8 +268,14 @@ namespace rsgis{namespace reg{
         pY = pY + (gsl_vector_get(aY, offset) * pow(eastings, this->polyOrder));
         pY = pY + (gsl_vector_get(aY, offset+1) * pow(northings, this->polyOrder));
     
-        *x = ceil(pX);
-		*y = ceil(pY);
+        *x = pX;
+		*y = pY;
+	}
+	
+	void RSGISPolynomialImageWarp::roundPixelLocation(double x, double y, long *xPxl, long *yPxl)
+	{
+		*xPxl = (long) ceil(x);
+		*yPxl = (long) ceil(y);
 	}
 		
 	RSGISPolynomialImageWarp::~RSGISPolynomialImageWarp()
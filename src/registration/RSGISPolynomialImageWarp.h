@@ -68,6 +68,8 @@ namespace rsgis{namespace reg{
 	protected:
 		geos::geom::Envelope* newImageExtent(unsigned int width, unsigned int height);
 		void findNearestPixel(double eastings, double northings, unsigned int *x, unsigned int *y, float inImgRes);
+		void findPixelLocation(double eastings, double northings, double *x, double *y, float inImgRes);
+		void roundPixelLocation(double x, double y, long *xPxl, long *yPxl);
         int polyOrder; // Polynominal order
         gsl_vector *aX;
         gsl_vector *aY;
@@ -112,6 +112,11 @@ namespace rsgis{namespace reg{
 			}
 		}
 		
+		return RSGISCorrelationSimilarityMetric::calcValueFromSums(sumRF, sumR, sumF, sumRSq, sumFSq, n);
+	}
+	
+	float RSGISCorrelationSimilarityMetric::calcValueFromSums(double sumRF, double sumR, double sumF, double sumRSq, double sumFSq, unsigned int n)
+	{
 		float val = (((n * sumRF) - (sumR * sumF))/sqrt(((n*sumRSq)-(sumR*sumR))*((n*sumFSq)-(sumF*sumF))));
         
         if(val < 0)
@@ -80,6 +80,13 @@ namespace rsgis{namespace reg{
 	public:
 		RSGISCorrelationSimilarityMetric(){};
 		float calcValue(float **reference, float **floating, unsigned int numVals, unsigned int numDims);
+		/**
+		 * The metric from the sums over the n values (all dimensions) which
+		 * it is calculated from, so callers which already have the sums of
+		 * the blocks (e.g., from summed-area tables) only need the sum of
+		 * the products.
+		 */
+		static float calcValueFromSums(double sumRF, double sumR, double sumF, double sumRSq, double sumFSq, unsigned int n);
 		bool findMin(){return false;};
 		~RSGISCorrelationSimilarityMetric(){};
 	};
@@ -36,6 +36,22 @@ namespace rsgis{namespace reg{
 		this->interpolator = interpolator;
         this->gdalFormat = gdalFormat;
 		gcps = new std::vector<RSGISGCPImg2MapNode*>();
+		this->gridSpacing = 16;
+		this->maxTransformError = 0;
+		this->continuousTransform = false;
+		this->threadSafeTransform = false;
+		this->numThreads = rsgis::utils::getNumThreads();
+	}
+	
+	void RSGISWarpImage::setNumThreads(unsigned int numThreads)
+	{
+		this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+	}
+	
+	void RSGISWarpImage::setTransformApproximation(unsigned int gridSpacing, float maxError)
+	{
+		this->gridSpacing = (gridSpacing < 2)?2:gridSpacing;
+		this->maxTransformError = maxError;
 	}
 	
 	void RSGISWarpImage::performWarp()
@@ -206,11 +222,8 @@ namespace rsgis{namespace reg{
 	
 	void RSGISWarpImage::populateOutputImage()
 	{
-        rsgis::img::RSGISImageUtils imgUtils;
-		
 		GDALDataset *inputImageDS = NULL;
 		GDALDataset *outputImageDS = NULL;
-
 		
 		try 
 		{
@@ -234,119 +247,149 @@ namespace rsgis{namespace reg{
 			
 			unsigned int numBands = outputImageDS->GetRasterCount();
 			
-			double *gdalTransformation= new double[6];
+			double gdalTransformation[6];
 			inputImageDS->GetGeoTransform(gdalTransformation);
-			
-			//double inTLX = gdalTransformation[0];
-			//double inTLY = gdalTransformation[3];
-			//double inBRX = inTLX + (inputImageDS->GetRasterXSize() * gdalTransformation[1]);
-			//double inBRY = inTLY + (inputImageDS->GetRasterYSize() * gdalTransformation[5]);
 			float inImgRes = gdalTransformation[1];
 			
 			outputImageDS->GetGeoTransform(gdalTransformation);
-            
 			double outTLX = gdalTransformation[0];
 			double outTLY = gdalTransformation[3];
-			//double outBRX = outTLX + (outputImageDS->GetRasterXSize() * gdalTransformation[1]);
-			//double outBRY = outTLY + (outputImageDS->GetRasterYSize() * gdalTransformation[5]);
-
-			delete[] gdalTransformation;
             
-            unsigned int inWidth = inputImageDS->GetRasterXSize();
-			unsigned int inHeight = inputImageDS->GetRasterYSize();
+            long inWidth = inputImageDS->GetRasterXSize();
+			long inHeight = inputImageDS->GetRasterYSize();
 			unsigned int outWidth = outputImageDS->GetRasterXSize();
 			unsigned int outHeight = outputImageDS->GetRasterYSize();
 			
-			//Get Image Output Bands
-			GDALRasterBand **outputRasterBands = new GDALRasterBand*[numBands];
-			for(unsigned int i = 0; i < numBands; i++)
-			{
-				outputRasterBands[i] = outputImageDS->GetRasterBand(i+1);
-			}
-			
-			// Allocate memory			
-			float **outputData = new float*[numBands];
-			for(unsigned int i = 0; i < numBands; i++)
-			{
-				outputData[i] = (float *) CPLMalloc(sizeof(float)*outWidth);
-			}
-			float *outDataColumn = new float[numBands];
-			
 			double startEastings = outTLX - (this->outImgRes+(this->outImgRes/2));
 			double startNorthings = outTLY + (this->outImgRes+(this->outImgRes/2));
-			double currentEastings = startEastings;
-			double currentNorthings = startNorthings;
 			
-			unsigned int xPxl = 0;
-			unsigned int yPxl = 0;
+			const unsigned int tileSize = 256;
+			unsigned int numXTiles = (outWidth + tileSize - 1) / tileSize;
+			unsigned int numYTiles = (outHeight + tileSize - 1) / tileSize;
+			unsigned int numTiles = numXTiles * numYTiles;
 			
-			int feedback = outHeight/10;
+			std::mutex ioMutex;
+			std::mutex transformMutex;
+			unsigned int numTilesDone = 0;
 			int feedbackCounter = 0;
 			std::cout << "Started ." << std::flush;
-
-			for(unsigned int i = 0; i < outHeight; ++i)
+			
+			// The tiles are independent; the buffers are allocated per tile as a tile
+			// takes far longer to transform than to allocate.
+			rsgis::utils::parallelFor(numTiles, this->numThreads, [&](size_t tile, unsigned int)
 			{
-				if((outHeight > 10) && ((i % feedback) == 0))
+				std::vector<long> xPxls;
+				std::vector<long> yPxls;
+				std::vector<unsigned char> valid;
+				std::vector<float> inData;
+				std::vector<float*> inBands(numBands, NULL);
+				std::vector<float> outData;
+				std::vector<float> outVals(numBands, 0);
+				unsigned int xOff = (tile % numXTiles) * tileSize;
+				unsigned int yOff = (tile / numXTiles) * tileSize;
+				unsigned int width = std::min(tileSize, outWidth - xOff);
+				unsigned int height = std::min(tileSize, outHeight - yOff);
+				size_t numPxls = ((size_t)width) * height;
+				
+				xPxls.resize(numPxls);
+				yPxls.resize(numPxls);
+				valid.resize(numPxls);
+				this->findTilePixels(xOff, yOff, width, height, startEastings, startNorthings, inImgRes, xPxls.data(), yPxls.data(), valid.data(), &transformMutex);
+				
+				// The window of the input image the tile maps to.
+				bool anyInside = false;
+				long minX = 0;
+				long maxX = 0;
+				long minY = 0;
+				long maxY = 0;
+				for(size_t i = 0; i < numPxls; ++i)
 				{
-					std::cout << "." << feedbackCounter << "." << std::flush;
-					feedbackCounter = feedbackCounter + 10;
+					if(valid[i] && (xPxls[i] >= 0) && (yPxls[i] >= 0) && (xPxls[i] < inWidth) && (yPxls[i] < inHeight))
+					{
+						if(!anyInside)
+						{
+							minX = maxX = xPxls[i];
+							minY = maxY = yPxls[i];
+							anyInside = true;
+						}
+						else
+						{
+							minX = std::min(minX, xPxls[i]);
+							maxX = std::max(maxX, xPxls[i]);
+							minY = std::min(minY, yPxls[i]);
+							maxY = std::max(maxY, yPxls[i]);
+						}
+					}
 				}
-				currentEastings = startEastings;
-				for(unsigned int j = 0; j < outWidth; ++j)
+				
+				unsigned int winWidth = 0;
+				unsigned int winHeight = 0;
+				if(anyInside)
 				{
-					try 
+					winWidth = (maxX - minX) + 1;
+					winHeight = (maxY - minY) + 1;
+					size_t numWinPxls = ((size_t)winWidth) * winHeight;
+					inData.resize(numWinPxls * numBands);
+					for(unsigned int n = 0; n < numBands; ++n)
 					{
-						this->findNearestPixel(currentEastings, currentNorthings, &xPxl, &yPxl, inImgRes);
-                        
-                        // Check xPxl and yPxl are within input image.
-						if((xPxl < inWidth) && (yPxl < inHeight))
-                        {
-                            this->interpolator->calcValue(inputImageDS, outDataColumn, numBands, currentEastings, currentNorthings, xPxl, yPxl, inImgRes, outImgRes);
-                        }
-                        else
-                        {
-                            for(unsigned int n = 0; n < numBands; n++)
-                            {
-                                outDataColumn[n] = 0;
-                            }
-                        }
-                        
+						inBands[n] = &inData[n * numWinPxls];
 					}
-					catch (RSGISImageWarpException) 
+					std::lock_guard<std::mutex> lock(ioMutex);
+					if(inputImageDS->RasterIO(GF_Read, minX, minY, winWidth, winHeight, inData.data(), winWidth, winHeight, GDT_Float32, numBands, NULL, 0, 0, 0) != CE_None)
 					{
-						// ignore... - set output as NaN
-						for(unsigned int n = 0; n < numBands; n++)
-						{
-							outDataColumn[n] = std::numeric_limits<double>::signaling_NaN();//NAN;
-						}
+						throw RSGISImageWarpException("Could not read the input image window.");
 					}
-					
-					for(unsigned int n = 0; n < numBands; n++)
+				}
+				
+				outData.resize(numPxls * numBands);
+				for(unsigned int y = 0; y < height; ++y)
+				{
+					double northings = startNorthings - ((yOff + y) * this->outImgRes);
+					for(unsigned int x = 0; x < width; ++x)
 					{
-						outputData[n][j] = outDataColumn[n];
+						double eastings = startEastings + ((xOff + x) * this->outImgRes);
+						size_t idx = (((size_t)y) * width) + x;
+						if(!valid[idx])
+						{
+							// The transform failed - set output as NaN
+							std::fill(outVals.begin(), outVals.end(), std::numeric_limits<float>::signaling_NaN());
+						}
+						else if((xPxls[idx] >= 0) && (yPxls[idx] >= 0) && (xPxls[idx] < inWidth) && (yPxls[idx] < inHeight))
+						{
+							try
+							{
+								this->interpolator->calcValue(inBands.data(), winWidth, winHeight, outVals.data(), numBands, eastings, northings, xPxls[idx] - minX, yPxls[idx] - minY, inImgRes, this->outImgRes);
+							}
+							catch (RSGISImageWarpException&)
+							{
+								std::fill(outVals.begin(), outVals.end(), std::numeric_limits<float>::signaling_NaN());
+							}
+						}
+						else
+						{
+							std::fill(outVals.begin(), outVals.end(), 0);
+						}
+						for(unsigned int n = 0; n < numBands; ++n)
+						{
+							outData[(n * numPxls) + idx] = outVals[n];
+						}
 					}
-					
-					currentEastings += this->outImgRes;
 				}
 				
-				for(unsigned int n = 0; n < numBands; n++)
+				std::lock_guard<std::mutex> lock(ioMutex);
+				if(outputImageDS->RasterIO(GF_Write, xOff, yOff, width, height, outData.data(), width, height, GDT_Float32, numBands, NULL, 0, 0, 0) != CE_None)
 				{
-					outputRasterBands[n]->RasterIO(GF_Write, 0, i, outWidth, 1, outputData[n], outWidth, 1, GDT_Float32, 0, 0);
+					throw RSGISImageWarpException("Could not write the output image tile.");
 				}
-				
-				currentNorthings -= this->outImgRes;
-			}
+				++numTilesDone;
+				while((feedbackCounter < 100) && ((numTilesDone * 100) >= (feedbackCounter * numTiles)))
+				{
+					std::cout << "." << feedbackCounter << "." << std::flush;
+					feedbackCounter = feedbackCounter + 10;
+				}
+			});
 			std::cout << ". Complete\n";
 			
-			delete[] outputRasterBands;
-			
-			for(unsigned int i = 0; i < numBands; i++)
-			{
-				CPLFree(outputData[i]);
-			}
-			delete[] outputData;
-			delete[] outDataColumn;
-			
 			GDALClose(inputImageDS);
 			GDALClose(outputImageDS);
 		}
@@ -370,6 +413,180 @@ namespace rsgis{namespace reg{
 		} 
 	}
     
+	void RSGISWarpImage::findTilePixels(unsigned int xOff, unsigned int yOff, unsigned int width, unsigned int height, double startEastings, double startNorthings, float inImgRes, long *xPxls, long *yPxls, unsigned char *valid, std::mutex *transformMutex)
+	{
+		auto transformLocation = [&](double x, double y, double *inX, double *inY)
+		{
+			double eastings = startEastings + ((xOff + x) * this->outImgRes);
+			double northings = startNorthings - ((yOff + y) * this->outImgRes);
+			try
+			{
+				if(this->threadSafeTransform)
+				{
+					this->findPixelLocation(eastings, northings, inX, inY, inImgRes);
+				}
+				else
+				{
+					std::lock_guard<std::mutex> lock(*transformMutex);
+					this->findPixelLocation(eastings, northings, inX, inY, inImgRes);
+				}
+			}
+			catch (RSGISImageWarpException&)
+			{
+				return false;
+			}
+			return true;
+		};
+		auto exactPixels = [&](unsigned int x0, unsigned int x1, unsigned int y0, unsigned int y1)
+		{
+			for(unsigned int y = y0; y < y1; ++y)
+			{
+				double northings = startNorthings - ((yOff + y) * this->outImgRes);
+				for(unsigned int x = x0; x < x1; ++x)
+				{
+					size_t idx = (((size_t)y) * width) + x;
+					valid[idx] = this->findPixel(startEastings + ((xOff + x) * this->outImgRes), northings, inImgRes, &xPxls[idx], &yPxls[idx], transformMutex);
+				}
+			}
+		};
+		
+		if((!this->continuousTransform) || (this->maxTransformError <= 0) || (width < 2) || (height < 2))
+		{
+			exactPixels(0, width, 0, height);
+			return;
+		}
+		
+		// The grid nodes, which include the last row and column of the tile.
+		std::vector<unsigned int> nodeXs;
+		std::vector<unsigned int> nodeYs;
+		for(unsigned int x = 0; x < (width-1); x += this->gridSpacing)
+		{
+			nodeXs.push_back(x);
+		}
+		nodeXs.push_back(width-1);
+		for(unsigned int y = 0; y < (height-1); y += this->gridSpacing)
+		{
+			nodeYs.push_back(y);
+		}
+		nodeYs.push_back(height-1);
+		
+		size_t numNodeXs = nodeXs.size();
+		std::vector<double> nodeInX(numNodeXs * nodeYs.size(), 0);
+		std::vector<double> nodeInY(numNodeXs * nodeYs.size(), 0);
+		std::vector<bool> nodeValid(numNodeXs * nodeYs.size(), false);
+		for(size_t j = 0; j < nodeYs.size(); ++j)
+		{
+			for(size_t i = 0; i < numNodeXs; ++i)
+			{
+				size_t idx = (j * numNodeXs) + i;
+				nodeValid[idx] = transformLocation(nodeXs[i], nodeYs[j], &nodeInX[idx], &nodeInY[idx]);
+			}
+		}
+		
+		for(size_t j = 0; (j+1) < nodeYs.size(); ++j)
+		{
+			// Each cell covers up to (not including) the next node, apart from the last.
+			unsigned int y0 = nodeYs[j];
+			unsigned int y1 = ((j+2) == nodeYs.size())?height:nodeYs[j+1];
+			double cellHeight = nodeYs[j+1] - y0;
+			for(size_t i = 0; (i+1) < numNodeXs; ++i)
+			{
+				unsigned int x0 = nodeXs[i];
+				unsigned int x1 = ((i+2) == numNodeXs)?width:nodeXs[i+1];
+				double cellWidth = nodeXs[i+1] - x0;
+				size_t tl = (j * numNodeXs) + i;
+				size_t tr = tl + 1;
+				size_t bl = tl + numNodeXs;
+				size_t br = bl + 1;
+				
+				bool approx = nodeValid[tl] && nodeValid[tr] && nodeValid[bl] && nodeValid[br];
+				auto bilinear = [&](const std::vector<double> &vals, double fx, double fy)
+				{
+					return ((vals[tl] * (1-fx)) + (vals[tr] * fx)) * (1-fy) + ((vals[bl] * (1-fx)) + (vals[br] * fx)) * fy;
+				};
+				if(approx)
+				{
+					const double checkPts[5][2] = {{0.5, 0.5}, {0.5, 0}, {0.5, 1}, {0, 0.5}, {1, 0.5}};
+					for(unsigned int c = 0; (c < 5) && approx; ++c)
+					{
+						double inX = 0;
+						double inY = 0;
+						if(!transformLocation(x0 + (checkPts[c][0] * cellWidth), y0 + (checkPts[c][1] * cellHeight), &inX, &inY))
+						{
+							approx = false;
+						}
+						else if((fabs(inX - bilinear(nodeInX, checkPts[c][0], checkPts[c][1])) > this->maxTransformError) || (fabs(inY - bilinear(nodeInY, checkPts[c][0], checkPts[c][1])) > this->maxTransformError))
+						{
+							approx = false;
+						}
+					}
+				}
+				
+				if(approx)
+				{
+					for(unsigned int y = y0; y < y1; ++y)
+					{
+						double fy = (y - y0) / cellHeight;
+						for(unsigned int x = x0; x < x1; ++x)
+						{
+							double fx = (x - x0) / cellWidth;
+							size_t idx = (((size_t)y) * width) + x;
+							this->roundPixelLocation(bilinear(nodeInX, fx, fy), bilinear(nodeInY, fx, fy), &xPxls[idx], &yPxls[idx]);
+							valid[idx] = 1;
+						}
+					}
+				}
+				else
+				{
+					exactPixels(x0, x1, y0, y1);
+				}
+			}
+		}
+	}
+	
+	bool RSGISWarpImage::findPixel(double eastings, double northings, float inImgRes, long *xPxl, long *yPxl, std::mutex *transformMutex)
+	{
+		try
+		{
+			std::unique_lock<std::mutex> lock(*transformMutex, std::defer_lock);
+			if(!this->threadSafeTransform)
+			{
+				lock.lock();
+			}
+			if(this->continuousTransform)
+			{
+				double x = 0;
+				double y = 0;
+				this->findPixelLocation(eastings, northings, &x, &y, inImgRes);
+				this->roundPixelLocation(x, y, xPxl, yPxl);
+			}
+			else
+			{
+				unsigned int x = 0;
+				unsigned int y = 0;
+				this->findNearestPixel(eastings, northings, &x, &y, inImgRes);
+				*xPxl = x;
+				*yPxl = y;
+			}
+		}
+		catch (RSGISImageWarpException&)
+		{
+			return false;
+		}
+		return true;
+	}
+	
+	void RSGISWarpImage::findPixelLocation(double eastings, double northings, double *x, double *y, float inImgRes)
+	{
+		throw RSGISImageWarpException("The transform does not provide continuous pixel locations.");
+	}
+	
+	void RSGISWarpImage::roundPixelLocation(double x, double y, long *xPxl, long *yPxl)
+	{
+		*xPxl = (long) floor(x+0.5);
+		*yPxl = (long) floor(y+0.5);
+	}
+	
     void RSGISWarpImage::populateTransformImage()
 	{
 		rsgis::img::RSGISImageUtils imgUtils;
@@ -30,6 +30,13 @@
 #include <string>
 #include <math.h>
 #include <list>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <exception>
+#include <limits>
+#include <cstdlib>
 
 #include "gdal_priv.h"
 #include "ogrsf_frmts.h"
@@ -38,6 +45,7 @@
 
 #include "common/rsgis-tqdm.h"
 #include "common/RSGISImageException.h"
+#include "common/RSGISParallel.h"
 
 #include "utils/RSGISTextUtils.h"
 
@@ -65,10 +73,30 @@
 
 namespace rsgis{namespace reg{
     
+	/**
+	 * The output image is populated in tiles, shared between threads (the
+	 * RSGISLIB_NUM_THREADS environment variable or setNumThreads), where
+	 * each tile reads only the window of the input image it maps to.
+	 *
+	 * Where the transform is continuous (continuousTransform) it can be
+	 * evaluated exactly on a grid of nodes within each tile and bilinearly
+	 * interpolated between them (setTransformApproximation). The error of the
+	 * interpolation is checked at the centre and the middle of the edges of
+	 * each grid cell, and cells where it is greater than the tolerance
+	 * (in input pixels) are evaluated exactly for every pixel.
+	 */
 	class DllExport RSGISWarpImage
 	{
 	public:
 		RSGISWarpImage(std::string inputImage, std::string outputImage, std::string outProjWKT, std::string gcpFilePath, float outImgRes, RSGISWarpImageInterpolator *interpolator, std::string gdalFormat);
+		void setNumThreads(unsigned int numThreads);
+		/**
+		 * The spacing (in output pixels) of the grid on which the transform is
+		 * evaluated exactly and the maximum error (in input pixels) of the
+		 * interpolation between the nodes. A maxError of 0 (the default)
+		 * evaluates the transform for every pixel.
+		 */
+		void setTransformApproximation(unsigned int gridSpacing, float maxError);
 		void performWarp();
         void generateTransformImage();
 		void readGCPFile();
@@ -81,6 +109,15 @@ namespace rsgis{namespace reg{
 	protected:
 		virtual geos::geom::Envelope* newImageExtent(unsigned int width, unsigned int height) = 0;
 		virtual void findNearestPixel(double eastings, double northings, unsigned int *x, unsigned int *y, float inImgRes) = 0;
+		/**
+		 * The location, before rounding to a pixel, of a point within the input
+		 * image. Only used where continuousTransform is true, in which case
+		 * findNearestPixel should be roundPixelLocation of this location.
+		 */
+		virtual void findPixelLocation(double eastings, double northings, double *x, double *y, float inImgRes);
+		virtual void roundPixelLocation(double x, double y, long *xPxl, long *yPxl);
+		void findTilePixels(unsigned int xOff, unsigned int yOff, unsigned int width, unsigned int height, double startEastings, double startNorthings, float inImgRes, long *xPxls, long *yPxls, unsigned char *valid, std::mutex *transformMutex);
+		bool findPixel(double eastings, double northings, float inImgRes, long *xPxl, long *yPxl, std::mutex *transformMutex);
         std::string inputImage;
 		std::string outputImage;
 		std::string outProjWKT;
@@ -89,6 +126,11 @@ namespace rsgis{namespace reg{
 		float outImgRes;
 		RSGISWarpImageInterpolator *interpolator;
         std::string gdalFormat;
+		unsigned int numThreads;
+		unsigned int gridSpacing;
+		float maxTransformError;
+		bool continuousTransform;
+		bool threadSafeTransform;
 	};
 	
 }}
@@ -57,6 +57,20 @@ namespace rsgis{namespace reg{
         delete[] dataVals;
         delete[] dsOffsets;
 	}
+	
+	void RSGISWarpImageNNInterpolator::calcValue(float **inData, unsigned int inWidth, unsigned int inHeight, float *outValues, unsigned int numOutVals, double eastings, double northings, unsigned int xPxl, unsigned int yPxl, float inImgRes, float outImgRes)
+	{
+		if((xPxl >= inWidth) || (yPxl >= inHeight))
+		{
+			throw RSGISImageWarpException("The pixel is outside of the input image window.");
+		}
+		
+		size_t idx = (((size_t)yPxl) * inWidth) + xPxl;
+		for(unsigned int i = 0; i < numOutVals; ++i)
+		{
+			outValues[i] = inData[i][idx];
+		}
+	}
 
 }}
 
@@ -57,6 +57,11 @@ namespace rsgis{namespace reg{
 	{
 	public:
 		virtual void calcValue(GDALDataset *image, float *outValues, unsigned int numOutVals, double eastings, double northings, unsigned int xPxl, unsigned int yPxl, float inImgRes, float outImgRes) = 0;
+		/**
+		 * As calcValue but from a window of the input image which has already
+		 * been read (one array per band), where xPxl and yPxl are within the window.
+		 */
+		virtual void calcValue(float **inData, unsigned int inWidth, unsigned int inHeight, float *outValues, unsigned int numOutVals, double eastings, double northings, unsigned int xPxl, unsigned int yPxl, float inImgRes, float outImgRes) = 0;
 		virtual ~RSGISWarpImageInterpolator(){};
 	};
 		
@@ -65,6 +70,7 @@ namespace rsgis{namespace reg{
 	public:
 		RSGISWarpImageNNInterpolator(){};
 		void calcValue(GDALDataset *image, float *outValues, unsigned int numOutVals, double eastings, double northings, unsigned int xPxl, unsigned int yPxl, float inImgRes, float outImgRes);
+		void calcValue(float **inData, unsigned int inWidth, unsigned int inHeight, float *outValues, unsigned int numOutVals, double eastings, double northings, unsigned int xPxl, unsigned int yPxl, float inImgRes, float outImgRes);
 		~RSGISWarpImageNNInterpolator(){};
 	};
 	
@@ -28,7 +28,11 @@ namespace rsgis{namespace reg{
 
 	RSGISWarpImageUsingTriangulation::RSGISWarpImageUsingTriangulation(std::string inputImage, std::string outputImage, std::string outProjWKT, std::string gcpFilePath, float outImgRes, RSGISWarpImageInterpolator *interpolator, std::string gdalFormat) : RSGISWarpImage(inputImage, outputImage, outProjWKT, gcpFilePath, outImgRes, interpolator, gdalFormat), dt(NULL), values(NULL)
 	{
-        
+        // The planes are fitted to the triangles around the nearest GCP, so
+        // the transform is only piecewise continuous, and CGAL point location
+        // is not thread safe.
+        this->continuousTransform = true;
+        this->threadSafeTransform = false;
 	}
 	
 	void RSGISWarpImageUsingTriangulation::initWarp()
@@ -114,6 +118,15 @@ namespace rsgis{namespace reg{
 	}
 	
 	void RSGISWarpImageUsingTriangulation::findNearestPixel(double eastings, double northings, unsigned int *x, unsigned int *y, float inImgRes)
+	{
+		double pX = 0;
+		double pY = 0;
+		this->findPixelLocation(eastings, northings, &pX, &pY, inImgRes);
+		*x = floor(pX+0.5);
+		*y = floor(pY+0.5);
+	}
+	
+	void RSGISWarpImageUsingTriangulation::findPixelLocation(double eastings, double northings, double *x, double *y, float inImgRes)
 	{
 		CGALPoint p(eastings, northings);
         Vertex_handle vh = dt->nearest_vertex(p);
@@ -149,9 +162,9 @@ namespace rsgis{namespace reg{
 		double planeC = 0;
 		
 		this->fitPlane2XPoints(normTriPts, &planeA, &planeB, &planeC);
-		*x = floor(planeC+0.5);
+		*x = planeC;
 		this->fitPlane2YPoints(normTriPts, &planeA, &planeB, &planeC);
-		*y = floor(planeC+0.5);
+		*y = planeC;
 		
         std::list<RSGISGCPImg2MapNode*>::iterator iterGCPs;
 		for(iterGCPs = normTriPts->begin(); iterGCPs != normTriPts->end(); )
@@ -84,6 +84,7 @@ namespace rsgis{namespace reg{
 	protected:
         geos::geom::Envelope* newImageExtent(unsigned int width, unsigned int height);
 		void findNearestPixel(double eastings, double northings, unsigned int *x, unsigned int *y, float inImgRes);
+		void findPixelLocation(double eastings, double northings, double *x, double *y, float inImgRes);
 		std::list<RSGISGCPImg2MapNode*>* normGCPs(std::list<const RSGISGCPImg2MapNode*> *gcps, double eastings, double northings);
 		void fitPlane2XPoints(std::list<RSGISGCPImg2MapNode*> *normPts, double *a, double *b, double *c);
 		void fitPlane2YPoints(std::list<RSGISGCPImg2MapNode*> *normPts, double *a, double *b, double *c);
@@ -27,7 +27,18 @@ namespace rsgis{namespace segment{
     
     RSGISClumpPxls::RSGISClumpPxls()
     {
-        
+        this->numThreads = rsgis::utils::getNumThreads();
+        this->tileRows = 0;
+    }
+    
+    void RSGISClumpPxls::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+    
+    void RSGISClumpPxls::setTileRows(unsigned int tileRows)
+    {
+        this->tileRows = tileRows;
     }
         
     void RSGISClumpPxls::performClump(GDALDataset *catagories, GDALDataset *clumps, bool noDataValProvided, unsigned int noDataVal, std::vector<unsigned int> *clumpPxlVals) 
@@ -41,148 +52,14 @@ namespace rsgis{namespace segment{
             throw rsgis::img::RSGISImageCalcException("Heights are not the same");
         }
         
-        rsgis::img::RSGISImageUtils imgUtils;
-        imgUtils.zerosUIntGDALDataset(clumps);
-        
         unsigned int width = catagories->GetRasterXSize();
         unsigned int height = catagories->GetRasterYSize();
         
         GDALRasterBand *catagoryBand = catagories->GetRasterBand(1);
         GDALRasterBand *clumpBand = clumps->GetRasterBand(1);
         
-        unsigned long clumpIdx = 1;
-        std::vector<rsgis::img::PxlLoc> clumpPxls;
-        std::queue<rsgis::img::PxlLoc> clumpSearchPxls;
-        unsigned int catPxlVal = 0;
-        unsigned int catCPxlVal = 0;
-        
-        unsigned int uiPxlVal = 0;
-        
-        rsgis_tqdm pbar;
-        for(unsigned int i = 0; i < height; ++i)
-        {
-            pbar.progress(i, height);
-            
-            for(unsigned int j = 0; j < width; ++j)
-            {
-                // Get pixel value from clump image for (j,i)
-                clumpBand->RasterIO(GF_Read, j, i, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
-                
-                // if value is zero create new clump
-                if(uiPxlVal == 0) 
-                {
-                    catagoryBand->RasterIO(GF_Read, j, i, 1, 1, &catPxlVal, 1, 1, GDT_UInt32, 0, 0);
-                    if((!noDataValProvided) | (noDataValProvided & (catPxlVal != noDataVal)))
-                    {     
-                        // Make sure all lists are empty.
-                        clumpPxls.clear();
-                        if(!clumpSearchPxls.empty())
-                        {
-                            while(clumpSearchPxls.size() > 0)
-                            {
-                                clumpSearchPxls.pop();
-                            }
-                        }
-                        
-                        if(clumpPxlVals != NULL)
-                        {
-                            clumpPxlVals->push_back(catPxlVal);
-                        }
-                            
-                        clumpPxls.push_back(rsgis::img::PxlLoc(j, i));
-                        clumpSearchPxls.push(rsgis::img::PxlLoc(j, i));
-                        clumpBand->RasterIO(GF_Write, j, i, 1, 1, &clumpIdx, 1, 1, GDT_UInt32, 0, 0);
-                        
-                        // Add neigbouring pixels to clump.
-                        // If no more pixels to add then stop.
-                        while(clumpSearchPxls.size() > 0)
-                        {
-                            rsgis::img::PxlLoc pxl = clumpSearchPxls.front();
-                            clumpSearchPxls.pop();
-                            
-                            // Above
-                            if(((long)pxl.yPos)-1 >= 0)
-                            {
-                                clumpBand->RasterIO(GF_Read, pxl.xPos, pxl.yPos-1, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
-                                if(uiPxlVal == 0)
-                                {
-                                    catagoryBand->RasterIO(GF_Read, pxl.xPos, pxl.yPos-1, 1, 1, &catCPxlVal, 1, 1, GDT_UInt32, 0, 0);
-
-                                    if(catPxlVal == catCPxlVal)
-                                    {
-                                        clumpPxls.push_back(rsgis::img::PxlLoc(pxl.xPos, pxl.yPos-1));
-                                        clumpSearchPxls.push(rsgis::img::PxlLoc(pxl.xPos, pxl.yPos-1));
-                                        clumpBand->RasterIO(GF_Write, pxl.xPos, pxl.yPos-1, 1, 1, &clumpIdx, 1, 1, GDT_UInt32, 0, 0);
-                                    }
-                                }
-                            }
-                            // Below
-                            if((pxl.yPos+1) < height)
-                            {
-                                clumpBand->RasterIO(GF_Read, pxl.xPos, pxl.yPos+1, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
-                                if(uiPxlVal == 0)
-                                {
-                                    catagoryBand->RasterIO(GF_Read, pxl.xPos, pxl.yPos+1, 1, 1, &catCPxlVal, 1, 1, GDT_UInt32, 0, 0);
-                                    
-                                    if(catPxlVal == catCPxlVal)
-                                    {
-                                        clumpPxls.push_back(rsgis::img::PxlLoc(pxl.xPos, pxl.yPos+1));
-                                        clumpSearchPxls.push(rsgis::img::PxlLoc(pxl.xPos, pxl.yPos+1));
-                                        clumpBand->RasterIO(GF_Write, pxl.xPos, pxl.yPos+1, 1, 1, &clumpIdx, 1, 1, GDT_UInt32, 0, 0);
-                                    }
-                                }
-                                
-                            }
-                            // Left
-                            if(((long)pxl.xPos)-1 >= 0)
-                            {
-                                clumpBand->RasterIO(GF_Read, pxl.xPos-1, pxl.yPos, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
-                                if(uiPxlVal == 0)
-                                {
-                                    catagoryBand->RasterIO(GF_Read, pxl.xPos-1, pxl.yPos, 1, 1, &catCPxlVal, 1, 1, GDT_UInt32, 0, 0);
-                                    
-                                    if(catPxlVal == catCPxlVal)
-                                    {
-                                        clumpPxls.push_back(rsgis::img::PxlLoc(pxl.xPos-1, pxl.yPos));
-                                        clumpSearchPxls.push(rsgis::img::PxlLoc(pxl.xPos-1, pxl.yPos));
-                                        clumpBand->RasterIO(GF_Write, pxl.xPos-1, pxl.yPos, 1, 1, &clumpIdx, 1, 1, GDT_UInt32, 0, 0);
-                                    }
-                                }
-                            }
-                            // Right
-                            if((pxl.xPos+1) < width)
-                            {
-                                clumpBand->RasterIO(GF_Read, pxl.xPos+1, pxl.yPos, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
-                                if(uiPxlVal == 0)
-                                {
-                                    catagoryBand->RasterIO(GF_Read, pxl.xPos+1, pxl.yPos, 1, 1, &catCPxlVal, 1, 1, GDT_UInt32, 0, 0);
-                                    
-                                    if(catPxlVal == catCPxlVal)
-                                    {
-                                        clumpPxls.push_back(rsgis::img::PxlLoc(pxl.xPos+1, pxl.yPos));
-                                        clumpSearchPxls.push(rsgis::img::PxlLoc(pxl.xPos+1, pxl.yPos));
-                                        clumpBand->RasterIO(GF_Write, pxl.xPos+1, pxl.yPos, 1, 1, &clumpIdx, 1, 1, GDT_UInt32, 0, 0);
-                                    }
-                                }
-                            }
-                        }
-                        
-                        ++clumpIdx;
-                    }
-                }
-            }
-        }
-        pbar.finish();
-        std::cout << "(Generated " << clumpIdx-1 << " clumps).\n";
-        if(clumpPxlVals != NULL)
-        {
-            if(clumpPxlVals->size() != (clumpIdx-1))
-            {
-                std::cout << "Number of clump pixel values: " << clumpPxlVals->size() << std::endl;
-                throw rsgis::img::RSGISImageCalcException("Number of clump pixel values in list is not equal to the number of clumps.");
-            }
-        }
-        
+        unsigned long numClumps = this->labelClumps(&catagoryBand, NULL, 1, width, height, clumpBand, noDataValProvided, noDataVal, clumpPxlVals);
+        std::cout << "(Generated " << numClumps << " clumps).\n";
     }
     
     void RSGISClumpPxls::performClumpPosVals(GDALDataset *catagories, GDALDataset *clumps) 
@@ -196,134 +73,15 @@ namespace rsgis{namespace segment{
             throw rsgis::img::RSGISImageCalcException("Heights are not the same");
         }
         
-        rsgis::img::RSGISImageUtils imgUtils;
-        imgUtils.zerosUIntGDALDataset(clumps);
-        
         unsigned int width = catagories->GetRasterXSize();
         unsigned int height = catagories->GetRasterYSize();
         
         GDALRasterBand *catagoryBand = catagories->GetRasterBand(1);
         GDALRasterBand *clumpBand = clumps->GetRasterBand(1);
         
-        unsigned long clumpIdx = 1;
-        std::vector<rsgis::img::PxlLoc> clumpPxls;
-        std::queue<rsgis::img::PxlLoc> clumpSearchPxls;
-        unsigned int catPxlVal = 0;
-        unsigned int catCPxlVal = 0;
-        
-        unsigned int uiPxlVal = 0;
-        
-        rsgis_tqdm pbar;
-        for(unsigned int i = 0; i < height; ++i)
-        {
-            pbar.progress(i, height);
-            
-            for(unsigned int j = 0; j < width; ++j)
-            {
-                // Get pixel value from clump image for (j,i)
-                clumpBand->RasterIO(GF_Read, j, i, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
-                
-                // if value is zero create new clump
-                if(uiPxlVal == 0)
-                {
-                    catagoryBand->RasterIO(GF_Read, j, i, 1, 1, &catPxlVal, 1, 1, GDT_UInt32, 0, 0);
-                    if(catPxlVal > 0)
-                    {
-                        // Make sure all lists are empty.
-                        clumpPxls.clear();
-                        if(!clumpSearchPxls.empty())
-                        {
-                            while(clumpSearchPxls.size() > 0)
-                            {
-                                clumpSearchPxls.pop();
-                            }
-                        }
-                        
-                        clumpPxls.push_back(rsgis::img::PxlLoc(j, i));
-                        clumpSearchPxls.push(rsgis::img::PxlLoc(j, i));
-                        clumpBand->RasterIO(GF_Write, j, i, 1, 1, &clumpIdx, 1, 1, GDT_UInt32, 0, 0);
-                        
-                        // Add neigbouring pixels to clump.
-                        // If no more pixels to add then stop.
-                        while(clumpSearchPxls.size() > 0)
-                        {
-                            rsgis::img::PxlLoc pxl = clumpSearchPxls.front();
-                            clumpSearchPxls.pop();
-                            
-                            // Above
-                            if(((long)pxl.yPos)-1 >= 0)
-                            {
-                                clumpBand->RasterIO(GF_Read, pxl.xPos, pxl.yPos-1, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
-                                if(uiPxlVal == 0)
-                                {
-                                    catagoryBand->RasterIO(GF_Read, pxl.xPos, pxl.yPos-1, 1, 1, &catCPxlVal, 1, 1, GDT_UInt32, 0, 0);
-                                    
-                                    if(catPxlVal == catCPxlVal)
-                                    {
-                                        clumpPxls.push_back(rsgis::img::PxlLoc(pxl.xPos, pxl.yPos-1));
-                                        clumpSearchPxls.push(rsgis::img::PxlLoc(pxl.xPos, pxl.yPos-1));
-                                        clumpBand->RasterIO(GF_Write, pxl.xPos, pxl.yPos-1, 1, 1, &clumpIdx, 1, 1, GDT_UInt32, 0, 0);
-                                    }
-                                }
-                            }
-                            // Below
-                            if((pxl.yPos+1) < height)
-                            {
-                                clumpBand->RasterIO(GF_Read, pxl.xPos, pxl.yPos+1, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
-                                if(uiPxlVal == 0)
-                                {
-                                    catagoryBand->RasterIO(GF_Read, pxl.xPos, pxl.yPos+1, 1, 1, &catCPxlVal, 1, 1, GDT_UInt32, 0, 0);
-                                    
-                                    if(catPxlVal == catCPxlVal)
-                                    {
-                                        clumpPxls.push_back(rsgis::img::PxlLoc(pxl.xPos, pxl.yPos+1));
-                                        clumpSearchPxls.push(rsgis::img::PxlLoc(pxl.xPos, pxl.yPos+1));
-                                        clumpBand->RasterIO(GF_Write, pxl.xPos, pxl.yPos+1, 1, 1, &clumpIdx, 1, 1, GDT_UInt32, 0, 0);
-                                    }
-                                }
-                                
-                            }
-                            // Left
-                            if(((long)pxl.xPos)-1 >= 0)
-                            {
-                                clumpBand->RasterIO(GF_Read, pxl.xPos-1, pxl.yPos, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
-                                if(uiPxlVal == 0)
-                                {
-                                    catagoryBand->RasterIO(GF_Read, pxl.xPos-1, pxl.yPos, 1, 1, &catCPxlVal, 1, 1, GDT_UInt32, 0, 0);
-                                    
-                                    if(catPxlVal == catCPxlVal)
-                                    {
-                                        clumpPxls.push_back(rsgis::img::PxlLoc(pxl.xPos-1, pxl.yPos));
-                                        clumpSearchPxls.push(rsgis::img::PxlLoc(pxl.xPos-1, pxl.yPos));
-                                        clumpBand->RasterIO(GF_Write, pxl.xPos-1, pxl.yPos, 1, 1, &clumpIdx, 1, 1, GDT_UInt32, 0, 0);
-                                    }
-                                }
-                            }
-                            // Right
-                            if((pxl.xPos+1) < width)
-                            {
-                                clumpBand->RasterIO(GF_Read, pxl.xPos+1, pxl.yPos, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
-                                if(uiPxlVal == 0)
-                                {
-                                    catagoryBand->RasterIO(GF_Read, pxl.xPos+1, pxl.yPos, 1, 1, &catCPxlVal, 1, 1, GDT_UInt32, 0, 0);
-                                    
-                                    if(catPxlVal == catCPxlVal)
-                                    {
-                                        clumpPxls.push_back(rsgis::img::PxlLoc(pxl.xPos+1, pxl.yPos));
-                                        clumpSearchPxls.push(rsgis::img::PxlLoc(pxl.xPos+1, pxl.yPos));
-                                        clumpBand->RasterIO(GF_Write, pxl.xPos+1, pxl.yPos, 1, 1, &clumpIdx, 1, 1, GDT_UInt32, 0, 0);
-                                    }
-                                }
-                            }
-                        }
-                        
-                        ++clumpIdx;
-                    }
-                }
-            }
-        }
-        pbar.finish();
-        std::cout << "(Generated " << clumpIdx-1 << " clumps).\n";
+        // Only positive values are clumped, i.e., zero is no data.
+        unsigned long numClumps = this->labelClumps(&catagoryBand, NULL, 1, width, height, clumpBand, true, 0, NULL);
+        std::cout << "(Generated " << numClumps << " clumps).\n";
     }
     
     void RSGISClumpPxls::performMultiBandClump(std::vector<GDALDataset*> *catagories, std::string clumpsOutputPath, std::string outFormat, bool noDataValProvided, unsigned int noDataVal, bool addRatPxlVals) 
@@ -374,7 +132,6 @@ namespace rsgis{namespace segment{
 			}
 			clumpsDS->SetGeoTransform(gdalTransform);
 			clumpsDS->SetProjection(catagories->at(0)->GetProjectionRef());
-            imgUtils.zerosUIntGDALDataset(clumpsDS);
             
             // Count number of image bands
 			unsigned int numInBands = 0;
@@ -403,161 +160,37 @@ namespace rsgis{namespace segment{
 			GDALRasterBand *clumpBand = clumpsDS->GetRasterBand(1);
             clumpBand->SetDescription("Clumps");
                         
-            unsigned long clumpIdx = 1;
-            std::vector<rsgis::img::PxlLoc> clumpPxls;
-            std::queue<rsgis::img::PxlLoc> clumpSearchPxls;
-            unsigned int *catPxlVals = new unsigned int[numInBands];
-            unsigned int *catCPxlVals = new unsigned int[numInBands];
-            
-            unsigned int uiPxlVal = 0;
-            std::vector<int*> outRATVals;
-            
-            rsgis_tqdm pbar;
-            for(unsigned int i = 0; i < height; ++i)
+            // Reduce the categories to a single band of codes and clump those.
+            GDALDriver *memDriver = GetGDALDriverManager()->GetDriverByName("MEM");
+            GDALDataset *codesDS = memDriver->Create("", width, height, 1, GDT_UInt32, NULL);
+            if(codesDS == NULL)
             {
-                pbar.progress(i, height);
-                
-                for(unsigned int j = 0; j < width; ++j)
-                {
-                    // Get pixel value from clump image for (j,i)
-                    clumpBand->RasterIO(GF_Read, j, i, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
-                    
-                    // if value is zero create new clump
-                    if(uiPxlVal == 0)
-                    {
-                        for(unsigned int n = 0; n < numInBands; ++n)
-                        {
-                            catBands[n]->RasterIO(GF_Read, bandOffsets[n][0]+j, bandOffsets[n][1]+i, 1, 1, &catPxlVals[n], 1, 1, GDT_UInt32, 0, 0);
-                        }
-                        
-                        if((!noDataValProvided) | (noDataValProvided & (!this->allValueEqual(catPxlVals, numInBands, noDataVal))))
-                        {
-                            // Make sure all lists are empty.
-                            clumpPxls.clear();
-                            if(!clumpSearchPxls.empty())
-                            {
-                                while(clumpSearchPxls.size() > 0)
-                                {
-                                    clumpSearchPxls.pop();
-                                }
-                            }
-                            
-                            if(addRatPxlVals)
-                            {
-                                int *vals = new int[numInBands];
-                                for(unsigned int n = 0; n < numInBands; ++n)
-                                {
-                                    vals[n] = catPxlVals[n];
-                                }
-                                outRATVals.push_back(vals);
-                            }
-                            
-                            clumpPxls.push_back(rsgis::img::PxlLoc(j, i));
-                            clumpSearchPxls.push(rsgis::img::PxlLoc(j, i));
-                            clumpBand->RasterIO(GF_Write, j, i, 1, 1, &clumpIdx, 1, 1, GDT_UInt32, 0, 0);
-                            
-                            // Add neigbouring pixels to clump.
-                            // If no more pixels to add then stop.
-                            while(clumpSearchPxls.size() > 0)
-                            {
-                                rsgis::img::PxlLoc pxl = clumpSearchPxls.front();
-                                clumpSearchPxls.pop();
-                                
-                                // Above
-                                if(((long)pxl.yPos)-1 >= 0)
-                                {
-                                    clumpBand->RasterIO(GF_Read, pxl.xPos, pxl.yPos-1, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
-                                    if(uiPxlVal == 0)
-                                    {
-                                        for(unsigned int n = 0; n < numInBands; ++n)
-                                        {
-                                            catBands[n]->RasterIO(GF_Read, bandOffsets[n][0]+pxl.xPos, bandOffsets[n][1]+(pxl.yPos-1), 1, 1, &catCPxlVals[n], 1, 1, GDT_UInt32, 0, 0);
-                                        }
-                                        
-                                        if(this->allValueEqual(catPxlVals, catCPxlVals, numInBands))
-                                        {
-                                            clumpPxls.push_back(rsgis::img::PxlLoc(pxl.xPos, pxl.yPos-1));
-                                            clumpSearchPxls.push(rsgis::img::PxlLoc(pxl.xPos, pxl.yPos-1));
-                                            clumpBand->RasterIO(GF_Write, pxl.xPos, pxl.yPos-1, 1, 1, &clumpIdx, 1, 1, GDT_UInt32, 0, 0);
-                                        }
-                                    }
-                                }
-                                // Below
-                                if((pxl.yPos+1) < height)
-                                {
-                                    clumpBand->RasterIO(GF_Read, pxl.xPos, pxl.yPos+1, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
-                                    if(uiPxlVal == 0)
-                                    {
-                                        for(unsigned int n = 0; n < numInBands; ++n)
-                                        {
-                                            catBands[n]->RasterIO(GF_Read, bandOffsets[n][0]+pxl.xPos, bandOffsets[n][1]+(pxl.yPos+1), 1, 1, &catCPxlVals[n], 1, 1, GDT_UInt32, 0, 0);
-                                        }
-                                        
-                                        if(this->allValueEqual(catPxlVals, catCPxlVals, numInBands))
-                                        {
-                                            clumpPxls.push_back(rsgis::img::PxlLoc(pxl.xPos, pxl.yPos+1));
-                                            clumpSearchPxls.push(rsgis::img::PxlLoc(pxl.xPos, pxl.yPos+1));
-                                            clumpBand->RasterIO(GF_Write, pxl.xPos, pxl.yPos+1, 1, 1, &clumpIdx, 1, 1, GDT_UInt32, 0, 0);
-                                        }
-                                    }
-                                    
-                                }
-                                // Left
-                                if(((long)pxl.xPos)-1 >= 0)
-                                {
-                                    clumpBand->RasterIO(GF_Read, pxl.xPos-1, pxl.yPos, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
-                                    if(uiPxlVal == 0)
-                                    {
-                                        for(unsigned int n = 0; n < numInBands; ++n)
-                                        {
-                                            catBands[n]->RasterIO(GF_Read, bandOffsets[n][0]+(pxl.xPos-1), bandOffsets[n][1]+pxl.yPos, 1, 1, &catCPxlVals[n], 1, 1, GDT_UInt32, 0, 0);
-                                        }
-                                        
-                                        if(this->allValueEqual(catPxlVals, catCPxlVals, numInBands))
-                                        {
-                                            clumpPxls.push_back(rsgis::img::PxlLoc(pxl.xPos-1, pxl.yPos));
-                                            clumpSearchPxls.push(rsgis::img::PxlLoc(pxl.xPos-1, pxl.yPos));
-                                            clumpBand->RasterIO(GF_Write, pxl.xPos-1, pxl.yPos, 1, 1, &clumpIdx, 1, 1, GDT_UInt32, 0, 0);
-                                        }
-                                    }
-                                }
-                                // Right
-                                if((pxl.xPos+1) < width)
-                                {
-                                    clumpBand->RasterIO(GF_Read, pxl.xPos+1, pxl.yPos, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
-                                    if(uiPxlVal == 0)
-                                    {
-                                        for(unsigned int n = 0; n < numInBands; ++n)
-                                        {
-                                            catBands[n]->RasterIO(GF_Read, bandOffsets[n][0]+(pxl.xPos+1), bandOffsets[n][1]+pxl.yPos, 1, 1, &catCPxlVals[n], 1, 1, GDT_UInt32, 0, 0);
-                                        }
-                                        
-                                        if(this->allValueEqual(catPxlVals, catCPxlVals, numInBands))
-                                        {
-                                            clumpPxls.push_back(rsgis::img::PxlLoc(pxl.xPos+1, pxl.yPos));
-                                            clumpSearchPxls.push(rsgis::img::PxlLoc(pxl.xPos+1, pxl.yPos));
-                                            clumpBand->RasterIO(GF_Write, pxl.xPos+1, pxl.yPos, 1, 1, &clumpIdx, 1, 1, GDT_UInt32, 0, 0);
-                                        }
-                                    }
-                                }
-                            }
-                            
-                            ++clumpIdx;
-                        }
-                    }
-                }
+                throw rsgis::img::RSGISImageBandException("Could not create the in memory category codes image.");
             }
-            pbar.finish();
-            std::cout << "(Generated " << clumpIdx-1 << " clumps).\n";
+            std::vector<unsigned int> codeVals;
+            std::vector<unsigned int> clumpCodes;
+            unsigned long numClumps = 0;
+            try
+            {
+                unsigned int numCodes = this->hashCategoryTuples(catBands, bandOffsets, numInBands, width, height, codesDS->GetRasterBand(1), noDataValProvided, noDataVal, addRatPxlVals?(&codeVals):NULL);
+                std::cout << "(Found " << numCodes << " combinations of categories).\n";
+                numClumps = this->performParallelClump(codesDS, clumpsDS, true, 0, addRatPxlVals?(&clumpCodes):NULL);
+            }
+            catch(rsgis::RSGISException &e)
+            {
+                GDALClose(codesDS);
+                throw e;
+            }
+            GDALClose(codesDS);
             
             clumpBand->SetMetadataItem("LAYER_TYPE", "thematic");
             if(addRatPxlVals)
             {
                 GDALRasterAttributeTable *rat = clumpBand->GetDefaultRAT();
                 size_t numRows = rat->GetRowCount();
-                if((outRATVals.size()+1) > numRows)
+                if((numClumps+1) > numRows)
                 {
-                    numRows = outRATVals.size()+1;
+                    numRows = numClumps+1;
                     rat->SetRowCount(numRows);
                 }
                 rastergis::RSGISRasterAttUtils attUtils;
@@ -573,24 +206,16 @@ namespace rsgis{namespace segment{
                         }
                         else
                         {
-                            ratColVals[j] = outRATVals.at(j-1)[i];
+                            ratColVals[j] = codeVals.at(((clumpCodes.at(j-1)-1)*numInBands)+i);
                         }
                     }
                     attUtils.writeIntColumn(rat, "ClumpVal_"+txtUtils.sizettostring(i+1), ratColVals, numRows);
                 }
                 delete[] ratColVals;
-                
-                for(size_t i = 0; i < outRATVals.size(); ++i)
-                {
-                    delete[] outRATVals.at(i);
-                }
             }
             
             GDALClose(clumpsDS);
             
-            delete[] catPxlVals;
-            delete[] catCPxlVals;
-            
             delete[] catBands;
             for(unsigned int i = 0; i < numInBands; ++i)
             {
@@ -614,6 +239,552 @@ namespace rsgis{namespace segment{
         }
     }
     
+    unsigned long RSGISClumpPxls::performParallelClump(GDALDataset *catagories, GDALDataset *clumps, bool noDataValProvided, unsigned int noDataVal, std::vector<unsigned int> *clumpPxlVals)
+    {
+        if(catagories->GetRasterXSize() != clumps->GetRasterXSize())
+        {
+            throw rsgis::img::RSGISImageCalcException("Widths are not the same");
+        }
+        if(catagories->GetRasterYSize() != clumps->GetRasterYSize())
+        {
+            throw rsgis::img::RSGISImageCalcException("Heights are not the same");
+        }
+        
+        unsigned int width = catagories->GetRasterXSize();
+        unsigned int height = catagories->GetRasterYSize();
+        
+        GDALRasterBand *catagoryBand = catagories->GetRasterBand(1);
+        GDALRasterBand *clumpBand = clumps->GetRasterBand(1);
+        
+        // Tiles are strips of whole rows, a multiple of the block height of about 4M pixels by default.
+        size_t tileNRows = this->tileRows;
+        if(tileNRows == 0)
+        {
+            int blockXSize = 0;
+            int blockYSize = 0;
+            catagoryBand->GetBlockSize(&blockXSize, &blockYSize);
+            size_t blockRows = (blockYSize > 0)?blockYSize:1;
+            tileNRows = std::max<size_t>(((4194304 / width) / blockRows) * blockRows, blockRows);
+        }
+        if(tileNRows > height)
+        {
+            tileNRows = height;
+        }
+        if(tileNRows == 0)
+        {
+            tileNRows = 1;
+        }
+        size_t numTiles = (height + tileNRows - 1) / tileNRows;
+        
+        std::vector<RSGISClumpTile> tiles(numTiles);
+        for(size_t t = 0; t < numTiles; ++t)
+        {
+            tiles[t].startRow = t * tileNRows;
+            tiles[t].nRows = std::min<size_t>(tileNRows, height - tiles[t].startRow);
+            tiles[t].numLabels = 0;
+        }
+        
+        rsgis_tqdm pbar;
+        
+        // Label the tiles independently, numThreads at a time. The categories are read (and the
+        // clumps written) from this thread as GDAL datasets cannot be shared between threads.
+        std::vector<std::vector<unsigned int> > catVals(this->numThreads);
+        rsgis::utils::RSGISWorkerPool pool(this->numThreads);
+        for(size_t batchStart = 0; batchStart < numTiles; batchStart += this->numThreads)
+        {
+            pbar.progress(batchStart, numTiles*2);
+            size_t batchEnd = std::min<size_t>(batchStart + this->numThreads, numTiles);
+            for(size_t t = batchStart; t < batchEnd; ++t)
+            {
+                std::vector<unsigned int> &tileCatVals = catVals[t-batchStart];
+                tileCatVals.resize((tiles[t].nRows + 1) * width);
+                if(catagoryBand->RasterIO(GF_Read, 0, tiles[t].startRow, width, tiles[t].nRows, &tileCatVals[width], width, tiles[t].nRows, GDT_UInt32, 0, 0) != CE_None)
+                {
+                    throw rsgis::img::RSGISImageCalcException("Could not read the categories image.");
+                }
+            }
+            
+            pool.parallelFor(batchEnd - batchStart, [&](size_t i, unsigned int)
+            {
+                this->labelTile(&tiles[batchStart+i], catVals[i].data(), width, noDataValProvided, noDataVal, (clumpPxlVals != NULL));
+            });
+        }
+        catVals.clear();
+        
+        // Give each tile a contiguous range of global labels.
+        std::vector<size_t> labelOffsets(numTiles, 0);
+        size_t numProvLabels = 0;
+        for(size_t t = 0; t < numTiles; ++t)
+        {
+            labelOffsets[t] = numProvLabels;
+            numProvLabels += tiles[t].numLabels;
+        }
+        if(numProvLabels >= std::numeric_limits<unsigned int>::max())
+        {
+            throw rsgis::img::RSGISImageCalcException("The number of clumps is too large for a 32 bit clumps image.");
+        }
+        
+        // Join the clumps which touch across the seam between each pair of tiles.
+        std::vector<unsigned int> parent(numProvLabels+1);
+        for(size_t l = 0; l <= numProvLabels; ++l)
+        {
+            parent[l] = l;
+        }
+        for(size_t t = 1; t < numTiles; ++t)
+        {
+            const unsigned int *aboveLabels = &tiles[t-1].labels[tiles[t-1].nRows * width];
+            const unsigned int *belowLabels = &tiles[t].labels[width];
+            for(size_t x = 0; x < width; ++x)
+            {
+                if((aboveLabels[x] != 0) && (belowLabels[x] != 0) && (tiles[t-1].lastRowVals[x] == tiles[t].firstRowVals[x]))
+                {
+                    this->mergeLabels(&parent, labelOffsets[t-1]+aboveLabels[x], labelOffsets[t]+belowLabels[x]);
+                }
+            }
+        }
+        
+        // Number the clumps in order of their first pixel, as for performClump.
+        unsigned long numClumps = 0;
+        for(size_t t = 0; t < numTiles; ++t)
+        {
+            for(size_t l = 1; l <= tiles[t].numLabels; ++l)
+            {
+                size_t gl = labelOffsets[t] + l;
+                if(parent[gl] == gl)
+                {
+                    parent[gl] = ++numClumps;
+                    if(clumpPxlVals != NULL)
+                    {
+                        clumpPxlVals->push_back(tiles[t].labelVals[l]);
+                    }
+                }
+                else
+                {
+                    parent[gl] = parent[parent[gl]];
+                }
+            }
+        }
+        
+        // Write the final labels for each tile.
+        for(size_t t = 0; t < numTiles; ++t)
+        {
+            pbar.progress(numTiles+t, numTiles*2);
+            unsigned int *tileLabels = &tiles[t].labels[width];
+            size_t numPxls = tiles[t].nRows * width;
+            for(size_t i = 0; i < numPxls; ++i)
+            {
+                if(tileLabels[i] != 0)
+                {
+                    tileLabels[i] = parent[labelOffsets[t]+tileLabels[i]];
+                }
+            }
+            if(clumpBand->RasterIO(GF_Write, 0, tiles[t].startRow, width, tiles[t].nRows, tileLabels, width, tiles[t].nRows, GDT_UInt32, 0, 0) != CE_None)
+            {
+                throw rsgis::img::RSGISImageCalcException("Could not write to the clumps image.");
+            }
+            std::vector<unsigned int>().swap(tiles[t].labels);
+        }
+        pbar.finish();
+        std::cout << "(Generated " << numClumps << " clumps).\n";
+        
+        return numClumps;
+    }
+    
+    void RSGISClumpPxls::labelTile(RSGISClumpTile *tile, unsigned int *catVals, unsigned int width, bool noDataValProvided, unsigned int noDataVal, bool recordVals)
+    {
+        size_t bufLen = (tile->nRows + 1) * width;
+        tile->labels.assign(bufLen, 0);
+        
+        std::vector<unsigned int> parent;
+        parent.push_back(0);
+        std::vector<unsigned int> provVals;
+        if(recordVals)
+        {
+            provVals.push_back(0);
+        }
+        this->labelRows(catVals, bufLen, 1, width, tile->nRows, false, noDataValProvided, noDataVal, tile->labels.data(), &parent, recordVals?(&provVals):NULL);
+        
+        // Compact the labels within the tile to 1..numLabels in raster order.
+        unsigned int numLabels = 0;
+        tile->labelVals.clear();
+        tile->labelVals.push_back(0);
+        for(size_t l = 1; l < parent.size(); ++l)
+        {
+            if(parent[l] == l)
+            {
+                parent[l] = ++numLabels;
+                if(recordVals)
+                {
+                    tile->labelVals.push_back(provVals[l]);
+                }
+            }
+            else
+            {
+                parent[l] = parent[parent[l]];
+            }
+        }
+        for(size_t i = width; i < bufLen; ++i)
+        {
+            tile->labels[i] = parent[tile->labels[i]];
+        }
+        tile->numLabels = numLabels;
+        
+        tile->firstRowVals.assign(&catVals[width], &catVals[2*width]);
+        tile->lastRowVals.assign(&catVals[tile->nRows*width], &catVals[(tile->nRows+1)*width]);
+    }
+    
+    unsigned long RSGISClumpPxls::labelClumps(GDALRasterBand **catBands, int **bandOffsets, unsigned int numBands, unsigned int width, unsigned int height, GDALRasterBand *clumpBand, bool noDataValProvided, unsigned int noDataVal, std::vector<unsigned int> *clumpPxlVals)
+    {
+        // Read strips of the natural block height, limited so the buffers stay small for wide images.
+        int blockXSize = 0;
+        int blockYSize = 0;
+        catBands[0]->GetBlockSize(&blockXSize, &blockYSize);
+        size_t stripRows = (blockYSize > 0)?blockYSize:1;
+        size_t maxStripPxls = 16777216 / numBands;
+        if((stripRows * width) > maxStripPxls)
+        {
+            stripRows = std::max<size_t>(maxStripPxls / width, 1);
+        }
+        if(stripRows > height)
+        {
+            stripRows = height;
+        }
+        
+        // Row 0 of each buffer holds the last row of the previous strip.
+        size_t bandBufLen = (stripRows + 1) * width;
+        unsigned int *catVals = new unsigned int[numBands * bandBufLen];
+        unsigned int *labels = new unsigned int[bandBufLen];
+        
+        // Union-find over the provisional labels; every label points to itself or a lower label.
+        std::vector<unsigned int> parent;
+        parent.push_back(0);
+        std::vector<unsigned int> provVals;
+        if(clumpPxlVals != NULL)
+        {
+            provVals.assign(numBands, 0);
+        }
+        
+        rsgis_tqdm pbar;
+        try
+        {
+            // First pass: provisional labels from the pixel to the left and above.
+            for(size_t startRow = 0; startRow < height; startRow += stripRows)
+            {
+                pbar.progress(startRow, height*2);
+                size_t nRows = std::min<size_t>(stripRows, height - startRow);
+                for(unsigned int n = 0; n < numBands; ++n)
+                {
+                    int xOff = (bandOffsets == NULL)?0:bandOffsets[n][0];
+                    int yOff = (bandOffsets == NULL)?0:bandOffsets[n][1];
+                    if(catBands[n]->RasterIO(GF_Read, xOff, yOff+startRow, width, nRows, &catVals[(n*bandBufLen)+width], width, nRows, GDT_UInt32, 0, 0) != CE_None)
+                    {
+                        throw rsgis::img::RSGISImageCalcException("Could not read the categories image.");
+                    }
+                }
+                
+                this->labelRows(catVals, bandBufLen, numBands, width, nRows, (startRow > 0), noDataValProvided, noDataVal, labels, &parent, (clumpPxlVals != NULL)?(&provVals):NULL);
+                
+                if(clumpBand->RasterIO(GF_Write, 0, startRow, width, nRows, &labels[width], width, nRows, GDT_UInt32, 0, 0) != CE_None)
+                {
+                    throw rsgis::img::RSGISImageCalcException("Could not write to the clumps image.");
+                }
+                
+                for(unsigned int n = 0; n < numBands; ++n)
+                {
+                    std::copy(&catVals[(n*bandBufLen)+(nRows*width)], &catVals[(n*bandBufLen)+((nRows+1)*width)], &catVals[n*bandBufLen]);
+                }
+                std::copy(&labels[nRows*width], &labels[(nRows+1)*width], labels);
+            }
+            
+            // Number the clumps in order of their first pixel (i.e., the lowest
+            // provisional label), replacing each parent with the final label.
+            unsigned long numClumps = 0;
+            for(size_t l = 1; l < parent.size(); ++l)
+            {
+                if(parent[l] == l)
+                {
+                    parent[l] = ++numClumps;
+                    if(clumpPxlVals != NULL)
+                    {
+                        for(unsigned int n = 0; n < numBands; ++n)
+                        {
+                            clumpPxlVals->push_back(provVals[(l*numBands)+n]);
+                        }
+                    }
+                }
+                else
+                {
+                    parent[l] = parent[parent[l]];
+                }
+            }
+            
+            // Second pass: replace the provisional labels with the final labels.
+            for(size_t startRow = 0; startRow < height; startRow += stripRows)
+            {
+                pbar.progress(height+startRow, height*2);
+                size_t nRows = std::min<size_t>(stripRows, height - startRow);
+                if(clumpBand->RasterIO(GF_Read, 0, startRow, width, nRows, labels, width, nRows, GDT_UInt32, 0, 0) != CE_None)
+                {
+                    throw rsgis::img::RSGISImageCalcException("Could not read the clumps image.");
+                }
+                for(size_t i = 0; i < (nRows * width); ++i)
+                {
+                    labels[i] = parent[labels[i]];
+                }
+                if(clumpBand->RasterIO(GF_Write, 0, startRow, width, nRows, labels, width, nRows, GDT_UInt32, 0, 0) != CE_None)
+                {
+                    throw rsgis::img::RSGISImageCalcException("Could not write to the clumps image.");
+                }
+            }
+            pbar.finish();
+            
+            delete[] catVals;
+            delete[] labels;
+            return numClumps;
+        }
+        catch(rsgis::img::RSGISImageCalcException &e)
+        {
+            delete[] catVals;
+            delete[] labels;
+            throw e;
+        }
+    }
+    
+    void RSGISClumpPxls::labelRows(unsigned int *catVals, size_t bandStride, unsigned int numBands, unsigned int width, size_t nRows, bool hasAboveRow, bool noDataValProvided, unsigned int noDataVal, unsigned int *labels, std::vector<unsigned int> *parent, std::vector<unsigned int> *labelVals)
+    {
+        for(size_t r = 1; r <= nRows; ++r)
+        {
+            bool hasAbove = (hasAboveRow || (r > 1));
+            for(size_t x = 0; x < width; ++x)
+            {
+                size_t idx = (r * width) + x;
+                if(noDataValProvided && this->allValueEqual(catVals, idx, bandStride, numBands, noDataVal))
+                {
+                    labels[idx] = 0;
+                    continue;
+                }
+                
+                unsigned int label = 0;
+                if((x > 0) && (labels[idx-1] != 0) && this->allValueEqual(catVals, idx, idx-1, bandStride, numBands))
+                {
+                    label = labels[idx-1];
+                }
+                if(hasAbove && (labels[idx-width] != 0) && this->allValueEqual(catVals, idx, idx-width, bandStride, numBands))
+                {
+                    if(label == 0)
+                    {
+                        label = labels[idx-width];
+                    }
+                    else if(label != labels[idx-width])
+                    {
+                        this->mergeLabels(parent, label, labels[idx-width]);
+                    }
+                }
+                if(label == 0)
+                {
+                    if(parent->size() == std::numeric_limits<unsigned int>::max())
+                    {
+                        throw rsgis::img::RSGISImageCalcException("The number of clumps is too large for a 32 bit clumps image.");
+                    }
+                    label = parent->size();
+                    parent->push_back(label);
+                    if(labelVals != NULL)
+                    {
+                        for(unsigned int n = 0; n < numBands; ++n)
+                        {
+                            labelVals->push_back(catVals[(n*bandStride)+idx]);
+                        }
+                    }
+                }
+                labels[idx] = label;
+            }
+        }
+    }
+    
+    unsigned int RSGISClumpPxls::hashCategoryTuples(GDALRasterBand **catBands, int **bandOffsets, unsigned int numBands, unsigned int width, unsigned int height, GDALRasterBand *codeBand, bool noDataValProvided, unsigned int noDataVal, std::vector<unsigned int> *codeVals)
+    {
+        int blockXSize = 0;
+        int blockYSize = 0;
+        catBands[0]->GetBlockSize(&blockXSize, &blockYSize);
+        size_t stripRows = (blockYSize > 0)?blockYSize:1;
+        size_t maxStripPxls = 16777216 / numBands;
+        if((stripRows * width) > maxStripPxls)
+        {
+            stripRows = std::max<size_t>(maxStripPxls / width, 1);
+        }
+        if(stripRows > height)
+        {
+            stripRows = height;
+        }
+        size_t maxPxls = stripRows * width;
+        
+        std::vector<unsigned int> catVals(maxPxls * numBands);
+        std::vector<uint64_t> hashes(maxPxls);
+        std::vector<unsigned char> allNoData(maxPxls);
+        std::vector<unsigned int> codes(maxPxls);
+        std::unordered_map<uint64_t, unsigned int> hashCodes;
+        std::map<std::vector<unsigned int>, unsigned int> collisionCodes;
+        std::vector<unsigned int> tuple(numBands);
+        bool checkTuples = (codeVals != NULL);
+        unsigned int numCodes = 0;
+        
+        rsgis_tqdm pbar;
+        for(size_t startRow = 0; startRow < height; startRow += stripRows)
+        {
+            pbar.progress(startRow, height);
+            size_t nRows = std::min<size_t>(stripRows, height - startRow);
+            size_t numPxls = nRows * width;
+            for(unsigned int n = 0; n < numBands; ++n)
+            {
+                int xOff = (bandOffsets == NULL)?0:bandOffsets[n][0];
+                int yOff = (bandOffsets == NULL)?0:bandOffsets[n][1];
+                if(catBands[n]->RasterIO(GF_Read, xOff, yOff+startRow, width, nRows, &catVals[n*numPxls], width, nRows, GDT_UInt32, 0, 0) != CE_None)
+                {
+                    throw rsgis::img::RSGISImageCalcException("Could not read the categories image.");
+                }
+            }
+            
+            // Hash a band at a time so the inner loops run along the pixels.
+            std::fill(hashes.begin(), hashes.begin()+numPxls, 0xCBF29CE484222325ULL);
+            std::fill(allNoData.begin(), allNoData.begin()+numPxls, 1);
+            for(unsigned int n = 0; n < numBands; ++n)
+            {
+                const unsigned int *bandVals = &catVals[n*numPxls];
+                for(size_t p = 0; p < numPxls; ++p)
+                {
+                    uint64_t hash = (hashes[p] ^ bandVals[p]) * 0x9E3779B97F4A7C15ULL;
+                    hashes[p] = hash ^ (hash >> 29);
+                    allNoData[p] &= (bandVals[p] == noDataVal);
+                }
+            }
+            
+            for(size_t p = 0; p < numPxls; ++p)
+            {
+                if(noDataValProvided && allNoData[p])
+                {
+                    codes[p] = 0;
+                    continue;
+                }
+                // Runs of the same categories along a row reuse the code of the previous pixel.
+                if((p > 0) && (codes[p-1] != 0) && (hashes[p] == hashes[p-1]) && (!checkTuples || this->allValueEqual(&catVals[0], p, p-1, numPxls, numBands)))
+                {
+                    codes[p] = codes[p-1];
+                    continue;
+                }
+                
+                std::unordered_map<uint64_t, unsigned int>::iterator iterCode = hashCodes.find(hashes[p]);
+                bool newCode = (iterCode == hashCodes.end());
+                bool collision = false;
+                if(!newCode && checkTuples)
+                {
+                    const unsigned int *codeTuple = &(*codeVals)[((size_t)(iterCode->second-1))*numBands];
+                    for(unsigned int n = 0; n < numBands; ++n)
+                    {
+                        if(codeTuple[n] != catVals[(n*numPxls)+p])
+                        {
+                            collision = true;
+                            break;
+                        }
+                    }
+                }
+                if(!collision)
+                {
+                    if(newCode)
+                    {
+                        if(numCodes == (std::numeric_limits<unsigned int>::max()-1))
+                        {
+                            throw rsgis::img::RSGISImageCalcException("The number of combinations of categories is too large for a 32 bit image.");
+                        }
+                        iterCode = hashCodes.insert(std::pair<uint64_t, unsigned int>(hashes[p], ++numCodes)).first;
+                        if(checkTuples)
+                        {
+                            for(unsigned int n = 0; n < numBands; ++n)
+                            {
+                                codeVals->push_back(catVals[(n*numPxls)+p]);
+                            }
+                        }
+                    }
+                    codes[p] = iterCode->second;
+                    continue;
+                }
+                
+                // A different tuple with the same hash.
+                for(unsigned int n = 0; n < numBands; ++n)
+                {
+                    tuple[n] = catVals[(n*numPxls)+p];
+                }
+                std::map<std::vector<unsigned int>, unsigned int>::iterator iterCollision = collisionCodes.find(tuple);
+                if(iterCollision == collisionCodes.end())
+                {
+                    if(numCodes == (std::numeric_limits<unsigned int>::max()-1))
+                    {
+                        throw rsgis::img::RSGISImageCalcException("The number of combinations of categories is too large for a 32 bit image.");
+                    }
+                    iterCollision = collisionCodes.insert(std::pair<std::vector<unsigned int>, unsigned int>(tuple, ++numCodes)).first;
+                    codeVals->insert(codeVals->end(), tuple.begin(), tuple.end());
+                }
+                codes[p] = iterCollision->second;
+            }
+            
+            if(codeBand->RasterIO(GF_Write, 0, startRow, width, nRows, &codes[0], width, nRows, GDT_UInt32, 0, 0) != CE_None)
+            {
+                throw rsgis::img::RSGISImageCalcException("Could not write the category codes.");
+            }
+        }
+        pbar.finish();
+        
+        return numCodes;
+    }
+    
+    void RSGISClumpPxls::mergeLabels(std::vector<unsigned int> *parent, unsigned int label1, unsigned int label2)
+    {
+        unsigned int root1 = this->findLabelRoot(parent, label1);
+        unsigned int root2 = this->findLabelRoot(parent, label2);
+        if(root1 < root2)
+        {
+            (*parent)[root2] = root1;
+        }
+        else if(root2 < root1)
+        {
+            (*parent)[root1] = root2;
+        }
+    }
+    
+    unsigned int RSGISClumpPxls::findLabelRoot(std::vector<unsigned int> *parent, unsigned int label)
+    {
+        // Path halving
+        while((*parent)[label] != label)
+        {
+            (*parent)[label] = (*parent)[(*parent)[label]];
+            label = (*parent)[label];
+        }
+        return label;
+    }
+    
+    bool RSGISClumpPxls::allValueEqual(unsigned int *vals, size_t idx, size_t bandStride, unsigned int numBands, unsigned int equalVal)
+    {
+        for(unsigned int n = 0; n < numBands; ++n)
+        {
+            if(vals[(n*bandStride)+idx] != equalVal)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    bool RSGISClumpPxls::allValueEqual(unsigned int *vals, size_t idx1, size_t idx2, size_t bandStride, unsigned int numBands)
+    {
+        for(unsigned int n = 0; n < numBands; ++n)
+        {
+            if(vals[(n*bandStride)+idx1] != vals[(n*bandStride)+idx2])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    
     bool RSGISClumpPxls::allValueEqual(unsigned int *vals, unsigned int numVals, unsigned int equalVal)
     {
         for(unsigned int i = 0; i < numVals; ++i)
@@ -648,146 +819,190 @@ namespace rsgis{namespace segment{
     }
     
     
-    RSGISRelabelClumps::RSGISRelabelClumps()
+    RSGISClumpRelabeller::RSGISClumpRelabeller()
     {
-        
+        this->numThreads = rsgis::utils::getNumThreads();
     }
     
-    void RSGISRelabelClumps::relabelClumps(GDALDataset *catagories, GDALDataset *clumps) 
+    void RSGISClumpRelabeller::setNumThreads(unsigned int numThreads)
     {
-        if(catagories->GetRasterXSize() != clumps->GetRasterXSize())
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+    
+    unsigned int RSGISClumpRelabeller::buildCompactLUT(GDALRasterBand *clumpBand, std::vector<unsigned int> *lut)
+    {
+        // Each thread marks the IDs it finds in its own table.
+        std::vector<std::vector<unsigned char> > threadPresent(std::max<unsigned int>(this->numThreads, 1));
+        unsigned int nThreads = this->processStrips(clumpBand, NULL, [&](unsigned int *labels, size_t numPxls, unsigned int threadIdx)
         {
-            throw rsgis::img::RSGISImageCalcException("Widths are not the same");
+            std::vector<unsigned char> &present = threadPresent[threadIdx];
+            unsigned int maxLabel = *std::max_element(labels, labels+numPxls);
+            if(maxLabel >= present.size())
+            {
+                present.resize(((size_t)maxLabel)+1, 0);
+            }
+            for(size_t p = 0; p < numPxls; ++p)
+            {
+                present[labels[p]] = 1;
+            }
+        });
+        
+        size_t lutSize = 0;
+        for(unsigned int t = 0; t < nThreads; ++t)
+        {
+            lutSize = std::max(lutSize, threadPresent[t].size());
         }
-        if(catagories->GetRasterYSize() != clumps->GetRasterYSize())
+        lut->assign(std::max<size_t>(lutSize, 1), 0);
+        for(unsigned int t = 0; t < nThreads; ++t)
         {
-            throw rsgis::img::RSGISImageCalcException("Heights are not the same");
+            for(size_t i = 0; i < threadPresent[t].size(); ++i)
+            {
+                (*lut)[i] |= threadPresent[t][i];
+            }
         }
+        unsigned int nextID = 1;
+        (*lut)[0] = 0;
+        for(size_t i = 1; i < lut->size(); ++i)
+        {
+            if((*lut)[i] != 0)
+            {
+                (*lut)[i] = nextID++;
+            }
+        }
+        return nextID - 1;
+    }
+    
+    void RSGISClumpRelabeller::applyLUT(GDALRasterBand *inBand, GDALRasterBand *outBand, const std::vector<unsigned int> &lut, std::vector<unsigned long long> *histogram)
+    {
+        // IDs beyond the table are clamped onto an extra 0 entry so the gather
+        // has no branch.
+        std::vector<unsigned int> gatherLUT(lut);
+        gatherLUT.push_back(0);
+        const unsigned int *gatherVals = &gatherLUT[0];
+        unsigned int maxIdx = gatherLUT.size() - 1;
+        unsigned int maxNewID = *std::max_element(gatherLUT.begin(), gatherLUT.end());
+        std::vector<std::vector<unsigned long long> > threadHistos(std::max<unsigned int>(this->numThreads, 1));
         
-        rsgis::img::RSGISImageUtils imgUtils;
-        imgUtils.zerosUIntGDALDataset(clumps);
-        
-        unsigned int width = catagories->GetRasterXSize();
-        unsigned int height = catagories->GetRasterYSize();
-        
-        GDALRasterBand *catagoryBand = catagories->GetRasterBand(1);
-        GDALRasterBand *clumpBand = clumps->GetRasterBand(1);
-        
-        unsigned int *clumpIdxs = new unsigned int[width];
-        
-        unsigned long maxClumpIdx = 0;
-        
-        rsgis_tqdm pbar;
-        for(unsigned int i = 0; i < height; ++i)
+        unsigned int nThreads = this->processStrips(inBand, outBand, [&](unsigned int *labels, size_t numPxls, unsigned int threadIdx)
         {
-            pbar.progress(i, height);
-            catagoryBand->RasterIO(GF_Read, 0, i, width, 1, clumpIdxs, width, 1, GDT_UInt32, 0, 0);
-            for(unsigned int j = 0; j < width; ++j)
+            for(size_t p = 0; p < numPxls; ++p)
+            {
+                labels[p] = gatherVals[std::min(labels[p], maxIdx)];
+            }
+            if(histogram != NULL)
             {
-                if((i == 0) & (j == 0))
+                std::vector<unsigned long long> &histo = threadHistos[threadIdx];
+                if(histo.empty())
                 {
-                    maxClumpIdx = clumpIdxs[j];
+                    histo.assign(((size_t)maxNewID)+1, 0);
                 }
-                else if(clumpIdxs[j] > maxClumpIdx)
+                for(size_t p = 0; p < numPxls; ++p)
                 {
-                    maxClumpIdx = clumpIdxs[j];
+                    ++histo[labels[p]];
                 }
             }
-        }
-        pbar.finish();
-        std::vector<unsigned int> clumpTable;
-        clumpTable.reserve(maxClumpIdx);
-        
-        for(size_t i = 0; i < maxClumpIdx; ++i)
-        {
-            clumpTable.push_back(0);
-        }
+        });
         
-        pbar.reset();
-        for(unsigned int i = 0; i < height; ++i)
+        if(histogram != NULL)
         {
-            pbar.progress(i, height);
-            catagoryBand->RasterIO(GF_Read, 0, i, width, 1, clumpIdxs, width, 1, GDT_UInt32, 0, 0);
-            for(unsigned int j = 0; j < width; ++j)
+            histogram->assign(((size_t)maxNewID)+1, 0);
+            for(unsigned int t = 0; t < nThreads; ++t)
             {
-                if(clumpIdxs[j] != 0)
+                for(size_t i = 0; i < threadHistos[t].size(); ++i)
                 {
-                    clumpTable.at(clumpIdxs[j]-1) = 1;
+                    (*histogram)[i] += threadHistos[t][i];
                 }
             }
         }
-        pbar.finish();
-        
-        unsigned int idx = 1;
-        for(size_t i = 0; i < maxClumpIdx; ++i)
+    }
+    
+    unsigned int RSGISClumpRelabeller::processStrips(GDALRasterBand *inBand, GDALRasterBand *outBand, const std::function<void(unsigned int*, size_t, unsigned int)> &stripFunc)
+    {
+        unsigned int width = inBand->GetXSize();
+        unsigned int height = inBand->GetYSize();
+        if((outBand != NULL) && ((outBand->GetXSize() != ((int)width)) || (outBand->GetYSize() != ((int)height))))
         {
-            if(clumpTable.at(i) == 1)
-            {
-                clumpTable.at(i) = idx++;
-            }
+            throw rsgis::img::RSGISImageCalcException("The input and output clumps are not the same size.");
         }
+        int blockXSize = 0;
+        int blockYSize = 0;
+        inBand->GetBlockSize(&blockXSize, &blockYSize);
+        unsigned int stripRows = (blockYSize > 0)?blockYSize:1;
+        unsigned int numStrips = (height + stripRows - 1) / stripRows;
+        unsigned int nThreads = std::max<unsigned int>(1, std::min(this->numThreads, numStrips));
         
-        pbar.reset();
-        for(unsigned int i = 0; i < height; ++i)
+        std::mutex ioMutex;
+        rsgis::utils::RSGISWorkerPool pool(nThreads);
+        std::vector<std::vector<unsigned int> > threadLabels(pool.getNumThreads());
+        pool.parallelFor(numStrips, [&](size_t s, unsigned int threadIdx)
         {
-            pbar.progress(i, height);
-            catagoryBand->RasterIO(GF_Read, 0, i, width, 1, clumpIdxs, width, 1, GDT_UInt32, 0, 0);
-            for(unsigned int j = 0; j < width; ++j)
+            std::vector<unsigned int> &labels = threadLabels[threadIdx];
+            labels.resize(((size_t)width) * stripRows);
+            unsigned int yStart = s * stripRows;
+            unsigned int numRows = std::min(stripRows, height - yStart);
             {
-                if(clumpIdxs[j] != 0)
+                std::lock_guard<std::mutex> lock(ioMutex);
+                if(inBand->RasterIO(GF_Read, 0, yStart, width, numRows, &labels[0], width, numRows, GDT_UInt32, 0, 0) != CE_None)
                 {
-                    clumpIdxs[j] = clumpTable.at(clumpIdxs[j]-1);
+                    throw rsgis::img::RSGISImageCalcException("Could not read the clumps image.");
                 }
             }
-            clumpBand->RasterIO(GF_Write, 0, i, width, 1, clumpIdxs, width, 1, GDT_UInt32, 0, 0);
+            stripFunc(&labels[0], ((size_t)width) * numRows, threadIdx);
+            if(outBand != NULL)
+            {
+                std::lock_guard<std::mutex> lock(ioMutex);
+                if(outBand->RasterIO(GF_Write, 0, yStart, width, numRows, &labels[0], width, numRows, GDT_UInt32, 0, 0) != CE_None)
+                {
+                    throw rsgis::img::RSGISImageCalcException("Could not write to the output clumps image.");
+                }
+            }
+        });
+        return nThreads;
+    }
+    
+    RSGISClumpRelabeller::~RSGISClumpRelabeller()
+    {
+        
+    }
+    
+    
+    
+    RSGISRelabelClumps::RSGISRelabelClumps()
+    {
+        
+    }
+    
+    void RSGISRelabelClumps::relabelClumps(GDALDataset *catagories, GDALDataset *clumps, bool populateRAT) 
+    {
+        if(catagories->GetRasterXSize() != clumps->GetRasterXSize())
+        {
+            throw rsgis::img::RSGISImageCalcException("Widths are not the same");
+        }
+        if(catagories->GetRasterYSize() != clumps->GetRasterYSize())
+        {
+            throw rsgis::img::RSGISImageCalcException("Heights are not the same");
+        }
+        
+        RSGISClumpRelabeller relabeller;
+        std::vector<unsigned int> lut;
+        std::cout << "Creating Look up table.\n";
+        relabeller.buildCompactLUT(catagories->GetRasterBand(1), &lut);
+        
+        std::cout << "Applying Look up table.\n";
+        std::vector<unsigned long long> histogram;
+        relabeller.applyLUT(catagories->GetRasterBand(1), clumps->GetRasterBand(1), lut, populateRAT?(&histogram):NULL);
+        if(populateRAT)
+        {
+            rsgis::rastergis::RSGISPopulateWithImageStats popImageStats;
+            popImageStats.writeHistogramToRAT(clumps, histogram, true, true, 1);
         }
-        pbar.finish();
-                 
-        delete[] clumpIdxs;
     }
     
-    void RSGISRelabelClumps::relabelClumpsCalcImg(GDALDataset *catagories, GDALDataset *clumps) 
+    void RSGISRelabelClumps::relabelClumpsCalcImg(GDALDataset *catagories, GDALDataset *clumps, bool populateRAT) 
     {
         try
         {
-            if(catagories->GetRasterXSize() != clumps->GetRasterXSize())
-            {
-                throw rsgis::img::RSGISImageCalcException("Widths are not the same");
-            }
-            if(catagories->GetRasterYSize() != clumps->GetRasterYSize())
-            {
-                throw rsgis::img::RSGISImageCalcException("Heights are not the same");
-            }
-            
-            std::cout << "Finding maximum image value\n";
-            rsgis::rastergis::RSGISRasterAttUtils ratUtils;
-            long minVal = 0;
-            long maxVal = 0;
-            ratUtils.getImageBandMinMax(catagories, 1, &minVal, &maxVal);
-            
-            unsigned long maxClumpIdx = boost::lexical_cast<unsigned long>(maxVal)+1;
-            
-            unsigned long *clumpIdxLookUp = new unsigned long[maxClumpIdx];
-            for(unsigned int i = 0; i < maxClumpIdx; ++i)
-            {
-                clumpIdxLookUp[i] = 0;
-            }
-            
-            std::cout << "Creating Look up table.\n";
-            RSGISCreateRelabelLookupTable *createLookUp = new RSGISCreateRelabelLookupTable(clumpIdxLookUp, maxClumpIdx);
-            rsgis::img::RSGISCalcImage calcImgCreateLoopUp = rsgis::img::RSGISCalcImage(createLookUp);
-            calcImgCreateLoopUp.calcImage(&catagories, 1, 0);
-            delete createLookUp;
-            
-            
-            std::cout << "Applying Look up table.\n";
-            RSGISApplyRelabelLookupTable *applyLookUp = new RSGISApplyRelabelLookupTable(clumpIdxLookUp, maxClumpIdx);
-            rsgis::img::RSGISCalcImage calcImgApplyLookUp = rsgis::img::RSGISCalcImage(applyLookUp);
-            calcImgApplyLookUp.calcImage(&catagories, 1, 0, clumps);
-            delete applyLookUp;
-            
-            delete[] clumpIdxLookUp;
-            
+            this->relabelClumps(catagories, clumps, populateRAT);
         }
         catch(rsgis::img::RSGISImageCalcException &e)
         {
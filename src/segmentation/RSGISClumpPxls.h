@@ -25,12 +25,24 @@
 
 #include <iostream>
 #include <vector>
+#include <map>
+#include <unordered_map>
 #include <queue>
+#include <limits>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <cstdlib>
+#include <stdint.h>
 #include <math.h>
 
 #include "gdal_priv.h"
 
 #include "common/rsgis-tqdm.h"
+#include "common/RSGISParallel.h"
 
 #include "img/RSGISImageUtils.h"
 #include "img/RSGISImageCalcException.h"
@@ -39,6 +51,7 @@
 #include "img/RSGISCalcImage.h"
 
 #include "rastergis/RSGISRasterAttUtils.h"
+#include "rastergis/RSGISCalcImageStatsAndPyramids.h"
 
 #include "utils/RSGISTextUtils.h"
 
@@ -63,19 +76,127 @@ namespace rsgis{namespace segment{
         RSGISClumpPxls();
         void performClump(GDALDataset *catagories, GDALDataset *clumps, bool noDataValProvided, unsigned int noDataVal, std::vector<unsigned int> *clumpPxlVals=NULL);
         void performClumpPosVals(GDALDataset *catagories, GDALDataset *clumps);
+        /**
+         * Clump the pixels with the same categories in all the bands of the
+         * (overlapping) images. The category tuple of each pixel is first
+         * reduced to a single code (hashCategoryTuples), held in memory, and
+         * the code image is clumped with performParallelClump.
+         */
         void performMultiBandClump(std::vector<GDALDataset*> *catagories, std::string clumpsOutputPath, std::string outFormat, bool noDataValProvided, unsigned int noDataVal, bool addRatPxlVals=false);
+        /**
+         * Clump as performClump but labelling strips of rows (tiles) concurrently
+         * in memory. The tiles are joined using an equivalence table built from
+         * the rows either side of each seam and the output is written once. The
+         * clumps are numbered as by performClump. The labels for the whole image
+         * are held in memory (4 bytes per pixel). Returns the number of clumps.
+         */
+        unsigned long performParallelClump(GDALDataset *catagories, GDALDataset *clumps, bool noDataValProvided, unsigned int noDataVal, std::vector<unsigned int> *clumpPxlVals=NULL);
+        /**
+         * Number of threads used by performParallelClump (default RSGISLIB_NUM_THREADS or 1); 0 uses the number of cores.
+         */
+        void setNumThreads(unsigned int numThreads);
+        /**
+         * Number of rows in each tile for performParallelClump; 0 (default) picks a multiple of the block height.
+         */
+        void setTileRows(unsigned int tileRows);
         ~RSGISClumpPxls();
     protected:
+        struct RSGISClumpTile
+        {
+            size_t startRow;
+            size_t nRows;
+            unsigned int numLabels;
+            // (nRows+1)*width with the first row unused, labels 1..numLabels.
+            std::vector<unsigned int> labels;
+            std::vector<unsigned int> labelVals;
+            std::vector<unsigned int> firstRowVals;
+            std::vector<unsigned int> lastRowVals;
+        };
+        void labelTile(RSGISClumpTile *tile, unsigned int *catVals, unsigned int width, bool noDataValProvided, unsigned int noDataVal, bool recordVals);
+        /**
+         * Assign provisional labels to rows 1 to nRows of the buffers (row 0 is
+         * the row above if hasAboveRow), creating new labels in parent.
+         */
+        void labelRows(unsigned int *catVals, size_t bandStride, unsigned int numBands, unsigned int width, size_t nRows, bool hasAboveRow, bool noDataValProvided, unsigned int noDataVal, unsigned int *labels, std::vector<unsigned int> *parent, std::vector<unsigned int> *labelVals);
+        /**
+         * Label the 4-connected regions of equal category values (over all
+         * bands) into clumpBand, in two passes over strips of rows using
+         * union-find, so each pixel is read once and written twice. Pixels
+         * where all bands equal noDataVal (if provided) are given 0. Clumps
+         * are numbered in the order of their first pixel and, if clumpPxlVals
+         * is not NULL, the values of each clump are appended to it (numBands
+         * per clump). Returns the number of clumps.
+         */
+        unsigned long labelClumps(GDALRasterBand **catBands, int **bandOffsets, unsigned int numBands, unsigned int width, unsigned int height, GDALRasterBand *clumpBand, bool noDataValProvided, unsigned int noDataVal, std::vector<unsigned int> *clumpPxlVals);
+        /**
+         * Hash the category tuple of each pixel to a 64 bit code, a band at a
+         * time over strips of rows, and number the distinct codes 1..n in
+         * codeBand, with 0 where all bands are noDataVal (if provided). If
+         * codeVals is not NULL the tuple of each code is appended to it
+         * (numBands per code) and every lookup is checked against it, so
+         * tuples with colliding hashes get their own codes; otherwise equal
+         * hashes are taken as equal tuples. Returns n.
+         */
+        unsigned int hashCategoryTuples(GDALRasterBand **catBands, int **bandOffsets, unsigned int numBands, unsigned int width, unsigned int height, GDALRasterBand *codeBand, bool noDataValProvided, unsigned int noDataVal, std::vector<unsigned int> *codeVals);
+        void mergeLabels(std::vector<unsigned int> *parent, unsigned int label1, unsigned int label2);
+        unsigned int findLabelRoot(std::vector<unsigned int> *parent, unsigned int label);
+        inline bool allValueEqual(unsigned int *vals, size_t idx, size_t bandStride, unsigned int numBands, unsigned int equalVal);
+        inline bool allValueEqual(unsigned int *vals, size_t idx1, size_t idx2, size_t bandStride, unsigned int numBands);
         inline bool allValueEqual(unsigned int *vals, unsigned int numVals, unsigned int equalVal);
         inline bool allValueEqual(unsigned int *vals1, unsigned int *vals2, unsigned int numVals);
+        unsigned int numThreads;
+        unsigned int tileRows;
+    };
+    
+    /**
+     * Relabels a clumps band through a lookup table (old clump ID to new clump
+     * ID), the common step of relabelling, dropping and merging clumps. The
+     * band is processed in strips of block rows shared among threads, each
+     * strip read and written as uint32 with the lookup applied as a gather
+     * (IDs beyond the table become 0). The histogram of the new IDs is counted
+     * in the same pass so the output RAT can be populated without reading the
+     * output again.
+     */
+    class DllExport RSGISClumpRelabeller
+    {
+    public:
+        RSGISClumpRelabeller();
+        /**
+         * Number of threads (default RSGISLIB_NUM_THREADS or 1); 0 uses the number of cores.
+         */
+        void setNumThreads(unsigned int numThreads);
+        /**
+         * A lookup table numbering the clump IDs present in the band 1..n in
+         * order of ID, 0 remaining 0, from one pass over the band. Returns n.
+         */
+        unsigned int buildCompactLUT(GDALRasterBand *clumpBand, std::vector<unsigned int> *lut);
+        /**
+         * Write the IDs of inBand through lut to outBand. If histogram is not
+         * NULL it is set to the number of pixels with each new ID (max ID + 1 values).
+         */
+        void applyLUT(GDALRasterBand *inBand, GDALRasterBand *outBand, const std::vector<unsigned int> &lut, std::vector<unsigned long long> *histogram);
+        ~RSGISClumpRelabeller();
+    protected:
+        /**
+         * Call stripFunc(labels, numPxls, threadIdx) for each strip of rows of
+         * inBand, with the labels written to outBand (if not NULL) afterwards.
+         * Returns the number of threads used.
+         */
+        unsigned int processStrips(GDALRasterBand *inBand, GDALRasterBand *outBand, const std::function<void(unsigned int*, size_t, unsigned int)> &stripFunc);
+        unsigned int numThreads;
     };
     
     class DllExport RSGISRelabelClumps
     {
     public:
         RSGISRelabelClumps();
-        void relabelClumps(GDALDataset *catagories, GDALDataset *clumps);
-        void relabelClumpsCalcImg(GDALDataset *catagories, GDALDataset *clumps);
+        /**
+         * Renumber the clumps in the order of their IDs, so the IDs are
+         * contiguous, populating the histogram and colour table of the
+         * output RAT if populateRAT.
+         */
+        void relabelClumps(GDALDataset *catagories, GDALDataset *clumps, bool populateRAT=false);
+        void relabelClumpsCalcImg(GDALDataset *catagories, GDALDataset *clumps, bool populateRAT=false);
         ~RSGISRelabelClumps();
     };
     
@@ -36,142 +36,144 @@ namespace rsgis{namespace segment{
     {
         try
         {
-            GDALDataset **datasets = new GDALDataset*[1];
-            datasets[0] = inData;
+            std::vector<float> binMins;
+            std::vector<float> binMaxs;
+            unsigned int numCats = this->calcBandThresholds(inData, subDivision, &binMins, &binMaxs);
             
             rsgis::img::RSGISImageUtils imgUtils;
-            
             GDALDataset *outImageDataset = imgUtils.createCopy(inData, 1, outputImage, format, GDT_UInt32, projFromImage, proj);
-            imgUtils.zerosUIntGDALDataset(outImageDataset);
-            
-            int numBands = inData->GetRasterCount();
-            rsgis::img::ImageStats **stats = new rsgis::img::ImageStats*[numBands];
-            for(int n = 0; n < numBands; ++n)
-            {
-                stats[n] = new rsgis::img::ImageStats();
-                stats[n]->min = 0;
-                stats[n]->max = 0;
-                stats[n]->mean = 0;
-                stats[n]->sum = 0;
-                stats[n]->stddev = 0;
-            }
-            
-            std::cout << "Calc Image Stats\n";
-            rsgis::img::RSGISImageStatistics imgStats;
-            imgStats.calcImageStatistics(datasets, 1, stats, numBands, false);
-            
-            unsigned int numCats = subDivision;
-            for(int n = 0; n < numBands-1; ++n)
-            {
-                numCats *= subDivision;
-            }
             
-            std::cout << "Generating " << numCats << " categories\n";
+            std::cout << "Applying to output image\n";
+            this->assignToCategory(inData, outImageDataset, binMins, binMaxs, subDivision, numCats, noDataVal, noDataValProvided);
             
+            std::cout << "Completed\n";
+            GDALClose(outImageDataset);
+        }
+        catch(RSGISException &e)
+        {
+            throw e;
+        }
+    }
+    
+    unsigned long RSGISDefineSpectralDivision::findSpectralDivisionClumps(GDALDataset *inData, std::string outputImage, unsigned int subDivision, float noDataVal, bool noDataValProvided, bool projFromImage, std::string proj, std::string format)
+    {
+        unsigned long numClumps = 0;
+        try
+        {
+            std::vector<float> binMins;
+            std::vector<float> binMaxs;
+            unsigned int numCats = this->calcBandThresholds(inData, subDivision, &binMins, &binMaxs);
             
-            std::vector<std::pair<float, float> > **catThresholds = new std::vector<std::pair<float, float> >*[numBands];
-            std::vector<std::pair<float, float> > **bandThresholds = new std::vector<std::pair<float, float> >*[numBands];
+            rsgis::img::RSGISImageUtils imgUtils;
+            GDALDataset *catsDataset = imgUtils.createCopy(inData, 1, "", "MEM", GDT_UInt32, projFromImage, proj);
             
-            float bandStep = 0;
-            float bandMin = 0;
-            float bandMax = 0;
-            for(int n = 0; n < numBands; ++n)
-            {
-                catThresholds[n] = new std::vector<std::pair<float, float> >();
-                catThresholds[n]->reserve(numCats);
-                bandThresholds[n] = new std::vector<std::pair<float, float> >();
-                bandThresholds[n]->reserve(subDivision);
-                bandStep = (stats[n]->max - stats[n]->min)/subDivision;
-                bandMin = stats[n]->min;
-                bandMax = bandMin + bandStep;
-                for(unsigned j = 0; j < subDivision; ++j)
-                {
-                    bandThresholds[n]->push_back(std::pair<float,float>(bandMin, bandMax));
-                    bandMin += bandStep;
-                    bandMax += bandStep;
-                }
-            }
+            std::cout << "Applying to category image\n";
+            this->assignToCategory(inData, catsDataset, binMins, binMaxs, subDivision, numCats, noDataVal, noDataValProvided);
             
-            std::pair<float, float> *pThreshold = NULL;
-            for(unsigned j = 0; j < subDivision; ++j)
+            std::cout << "Clumping categories\n";
+            GDALDataset *outImageDataset = imgUtils.createCopy(inData, 1, outputImage, format, GDT_UInt32, projFromImage, proj);
+            try
             {
-                pThreshold = new std::pair<float, float>[numBands];
-                for(int n = 0; n < numBands; ++n)
-                {
-                    pThreshold[n] = std::pair<float, float>(0,0);
-                }
-                pThreshold[0] = std::pair<float,float>(bandThresholds[0]->at(j).first, bandThresholds[0]->at(j).second);
-                
-                this->generateSpectralDivThresholds(pThreshold, 1, numBands, subDivision, bandThresholds, catThresholds);
+                RSGISClumpPxls clumpImg;
+                numClumps = clumpImg.performParallelClump(catsDataset, outImageDataset, true, 0, NULL);
             }
-            
-            std::cout << "Number of categories: " << catThresholds[0]->size() << std::endl;
-            
-            if(catThresholds[0]->size() != numCats)
+            catch(RSGISException &e)
             {
-                throw rsgis::img::RSGISImageCalcException("The number of categories generated is not what was expected.");
+                GDALClose(catsDataset);
+                GDALClose(outImageDataset);
+                throw e;
             }
             
-            std::cout << "Applying to output image\n";
-            this->assignToCategory(inData, outImageDataset, catThresholds, numBands, numCats, noDataVal, noDataValProvided);
-            
             std::cout << "Completed\n";
+            GDALClose(catsDataset);
             GDALClose(outImageDataset);
-            for(int n = 0; n < numBands; ++n)
-            {
-                delete catThresholds[n];
-                delete bandThresholds[n];
-                delete stats[n];
-            }
-            delete[] stats;
-            delete[] catThresholds;
-            delete[] bandThresholds;
-            delete[] datasets;
         }
         catch(RSGISException &e)
         {
             throw e;
         }
+        return numClumps;
     }
     
-    void RSGISDefineSpectralDivision::generateSpectralDivThresholds(std::pair<float, float> *pThreshold, unsigned int bandIdx, unsigned int numBands, unsigned int subDivision, std::vector<std::pair<float, float> > **bandThresholds, std::vector<std::pair<float, float> > **catThresholds)
+    unsigned int RSGISDefineSpectralDivision::calcBandThresholds(GDALDataset *inData, unsigned int subDivision, std::vector<float> *binMins, std::vector<float> *binMaxs)
     {
-        if(bandIdx == numBands)
+        if(subDivision == 0)
         {
-            for(unsigned int n = 0; n < numBands; ++n)
+            throw rsgis::img::RSGISImageCalcException("The number of subdivisions must be greater than zero.");
+        }
+        
+        GDALDataset **datasets = new GDALDataset*[1];
+        datasets[0] = inData;
+        
+        int numBands = inData->GetRasterCount();
+        rsgis::img::ImageStats **stats = new rsgis::img::ImageStats*[numBands];
+        for(int n = 0; n < numBands; ++n)
+        {
+            stats[n] = new rsgis::img::ImageStats();
+            stats[n]->min = 0;
+            stats[n]->max = 0;
+            stats[n]->mean = 0;
+            stats[n]->sum = 0;
+            stats[n]->stddev = 0;
+        }
+        
+        std::cout << "Calc Image Stats\n";
+        rsgis::img::RSGISImageStatistics imgStats;
+        imgStats.calcImageStatistics(datasets, 1, stats, numBands, false);
+        
+        unsigned long long numCats = subDivision;
+        for(int n = 0; n < numBands-1; ++n)
+        {
+            numCats *= subDivision;
+            if(numCats >= std::numeric_limits<unsigned int>::max())
             {
-                catThresholds[n]->push_back(std::pair<float, float>(pThreshold[n].first, pThreshold[n].second));
+                for(int i = 0; i < numBands; ++i)
+                {
+                    delete stats[i];
+                }
+                delete[] stats;
+                delete[] datasets;
+                throw rsgis::img::RSGISImageCalcException("There are too many categories to be represented in the output image.");
             }
         }
-        else
+        
+        std::cout << "Generating " << numCats << " categories\n";
+        
+        binMins->assign(((size_t)numBands)*subDivision, 0);
+        binMaxs->assign(((size_t)numBands)*subDivision, 0);
+        float bandStep = 0;
+        float bandMin = 0;
+        float bandMax = 0;
+        for(int n = 0; n < numBands; ++n)
         {
-            std::pair<float, float> *cThreshold = NULL;
+            bandStep = (stats[n]->max - stats[n]->min)/subDivision;
+            bandMin = stats[n]->min;
+            bandMax = bandMin + bandStep;
             for(unsigned j = 0; j < subDivision; ++j)
             {
-                cThreshold = new std::pair<float, float>[numBands];
-                for(unsigned int n = 0; n < numBands; ++n)
-                {
-                    cThreshold[n] = std::pair<float, float>(0,0);
-                }
-                for(unsigned int n = 0; n < bandIdx; ++n)
-                {
-                    cThreshold[n] = std::pair<float, float>(pThreshold[n].first, pThreshold[n].second);
-                }
-                
-                cThreshold[bandIdx] = std::pair<float,float>(bandThresholds[bandIdx]->at(j).first, bandThresholds[bandIdx]->at(j).second);
-                
-                this->generateSpectralDivThresholds(cThreshold, bandIdx+1, numBands, subDivision, bandThresholds, catThresholds);
+                (*binMins)[(n*subDivision)+j] = bandMin;
+                (*binMaxs)[(n*subDivision)+j] = bandMax;
+                bandMin += bandStep;
+                bandMax += bandStep;
             }
         }
         
-        delete[] pThreshold;
+        for(int n = 0; n < numBands; ++n)
+        {
+            delete stats[n];
+        }
+        delete[] stats;
+        delete[] datasets;
+        
+        return numCats;
     }
     
-    void RSGISDefineSpectralDivision::assignToCategory(GDALDataset *reflDataset, GDALDataset *catsDataset, std::vector<std::pair<float, float> > **catThresholds, unsigned int numBands, unsigned int numCats, float noDataVal, bool noDataValProvided)
+    void RSGISDefineSpectralDivision::assignToCategory(GDALDataset *reflDataset, GDALDataset *catsDataset, const std::vector<float> &binMins, const std::vector<float> &binMaxs, unsigned int subDivision, unsigned int numCats, float noDataVal, bool noDataValProvided)
     {
         try 
         {
-            if(numBands != reflDataset->GetRasterCount())
+            unsigned int numBands = reflDataset->GetRasterCount();
+            if((((size_t)numBands)*subDivision) != binMins.size())
             {
                 throw rsgis::img::RSGISImageCalcException("The number of image bands does not match.");
             }
@@ -189,87 +191,86 @@ namespace rsgis{namespace segment{
             unsigned int width = reflDataset->GetRasterXSize();
             unsigned int height = reflDataset->GetRasterYSize();
             
-            unsigned int *catData = new unsigned int[width];
-            float **reflData = new float*[numBands];
-            
             GDALRasterBand *catBand = catsDataset->GetRasterBand(1);
-            GDALRasterBand **reflBands = new GDALRasterBand*[numBands];
-            
+            std::vector<GDALRasterBand*> reflBands(numBands);
             for(unsigned int n = 0; n < numBands; ++n)
             {
                 reflBands[n] = reflDataset->GetRasterBand(n+1);
-                reflData[n] = new float[width];
             }
             
-            bool foundCat = true;
-            bool noDataFound = false;
-            for(unsigned int i = 0; i < height; ++i)
+            int blockXSize = 0;
+            int blockYSize = 0;
+            reflBands[0]->GetBlockSize(&blockXSize, &blockYSize);
+            unsigned int stripRows = (blockYSize > 0)?blockYSize:1;
+            size_t stripPxls = ((size_t)width) * stripRows;
+            
+            // The category is the bins combined as digits (band 1 most
+            // significant), the same order in which the categories were numbered.
+            std::vector<unsigned int> bandMultiplier(numBands, 1);
+            for(int n = ((int)numBands)-2; n >= 0; --n)
             {
-                for(unsigned int n = 0; n < numBands; ++n)
-                {
-                    reflBands[n]->RasterIO(GF_Read, 0, i, width, 1, reflData[n], width, 1, GDT_Float32, 0, 0);
-                }
+                bandMultiplier[n] = bandMultiplier[n+1] * subDivision;
+            }
+            
+            std::vector<float> reflData(stripPxls);
+            std::vector<unsigned int> catCode(stripPxls);
+            std::vector<unsigned char> inRange(stripPxls);
+            std::vector<unsigned char> noData(stripPxls);
+            std::vector<unsigned int> catData(stripPxls);
+            
+            for(unsigned int yStart = 0; yStart < height; yStart += stripRows)
+            {
+                unsigned int numRows = std::min(stripRows, height - yStart);
+                size_t numPxls = ((size_t)width) * numRows;
+                std::fill(catCode.begin(), catCode.begin()+numPxls, 0);
+                std::fill(inRange.begin(), inRange.begin()+numPxls, 1);
+                std::fill(noData.begin(), noData.begin()+numPxls, noDataValProvided?1:0);
                 
-                for(unsigned int j = 0; j < width; ++j)
+                for(unsigned int n = 0; n < numBands; ++n)
                 {
-                    noDataFound = false;
-                    if(noDataValProvided)
+                    reflBands[n]->RasterIO(GF_Read, 0, yStart, width, numRows, &reflData[0], width, numRows, GDT_Float32, 0, 0);
+                    const float *mins = &binMins[n*subDivision];
+                    const float *maxs = &binMaxs[n*subDivision];
+                    float bandMin = mins[0];
+                    float bandStep = maxs[0] - mins[0];
+                    float invStep = (bandStep > 0)?(1.0f/bandStep):0.0f;
+                    unsigned int multiplier = bandMultiplier[n];
+                    int lastBin = subDivision-1;
+                    for(size_t p = 0; p < numPxls; ++p)
                     {
-                        noDataFound = true;
-                        for(unsigned int n = 0; n < numBands; ++n)
+                        float val = reflData[p];
+                        noData[p] &= (val == noDataVal);
+                        int bin = 0;
+                        // NaN is within every range, so is given the first bin.
+                        if(val == val)
                         {
-                            if(reflData[n][j] != noDataVal)
+                            float binEst = (val - bandMin) * invStep;
+                            bin = (binEst <= 0)?0:((binEst >= lastBin)?lastBin:((int)binEst));
+                            // The thresholds are inclusive with the lower bin
+                            // taking a boundary value, so correct the estimate
+                            // against them.
+                            while((bin > 0) && (maxs[bin-1] >= val))
                             {
-                                noDataFound = false;
-                                break;
+                                --bin;
                             }
-                        }
-                    }
-                    
-                    if(noDataFound)
-                    {
-                        catData[j] = 0;
-                    }
-                    else
-                    {
-                        for(unsigned int c = 0; c < numCats; ++c)
-                        {
-                            foundCat = true;
-                            for(unsigned int n = 0; n < numBands; ++n)
+                            while((bin < lastBin) && (maxs[bin] < val))
                             {
-                                if((reflData[n][j] < catThresholds[n]->at(c).first) | (reflData[n][j] > catThresholds[n]->at(c).second))
-                                {
-                                    foundCat = false;
-                                    break;
-                                }
+                                ++bin;
                             }
-                            
-                            if(foundCat)
-                            {
-                                catData[j] = c+1;
-                                break;
-                            }
-                        }
-                        
-                        if(!foundCat)
-                        {
-                            catData[j] = numCats;
+                            inRange[p] &= ((val >= mins[bin]) & (val <= maxs[bin]));
                         }
+                        catCode[p] += bin * multiplier;
                     }
                 }
                 
-                catBand->RasterIO(GF_Write, 0, i, width, 1, catData, width, 1, GDT_UInt32, 0, 0);
-            }
-            
-            
-            delete[] catData;
-            for(unsigned int n = 0; n < numBands; ++n)
-            {
-                delete[] reflData[n];
+                for(size_t p = 0; p < numPxls; ++p)
+                {
+                    unsigned int cat = inRange[p]?(catCode[p]+1):numCats;
+                    catData[p] = noData[p]?0:cat;
+                }
+                
+                catBand->RasterIO(GF_Write, 0, yStart, width, numRows, &catData[0], width, numRows, GDT_UInt32, 0, 0);
             }
-            delete[] reflData;
-            delete[] reflBands;
-            
         } 
         catch (RSGISException &e) 
         {
@@ -285,4 +286,3 @@ namespace rsgis{namespace segment{
 
     
 }}
-
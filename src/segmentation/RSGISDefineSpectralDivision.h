@@ -27,6 +27,9 @@
 #include <string>
 #include <math.h>
 #include <stdlib.h>
+#include <vector>
+#include <algorithm>
+#include <limits>
 
 #include "common/RSGISAttributeTableException.h"
 
@@ -39,6 +42,8 @@
 
 #include "math/RSGISMathsUtils.h"
 
+#include "segmentation/RSGISClumpPxls.h"
+
 #include "gdal_priv.h"
 #include "ogrsf_frmts.h"
 #include "ogr_api.h"
@@ -58,15 +63,34 @@
 
 namespace rsgis{namespace segment{
     
+    /**
+     * Divides the range of each band into subDivision equal bins and assigns
+     * each pixel the category of the combination of its bins (band 1 most
+     * significant, categories from 1, 0 for no data and numCats for pixels
+     * outside the ranges). The bin of each band is computed directly from
+     * the bin width and checked against the band's thresholds, and the bins
+     * are combined into the category a band at a time over strips of rows.
+     */
     class DllExport RSGISDefineSpectralDivision
     {
     public:
         RSGISDefineSpectralDivision();
         void findSpectralDivision(GDALDataset *inData, std::string outputImage, unsigned int subDivision, float noDataVal, bool noDataValProvided, bool projFromImage, std::string proj, std::string format);
+        /**
+         * As findSpectralDivision but the categories are clumped into
+         * outputImage, with the category image held in memory rather than
+         * written out. Returns the number of clumps.
+         */
+        unsigned long findSpectralDivisionClumps(GDALDataset *inData, std::string outputImage, unsigned int subDivision, float noDataVal, bool noDataValProvided, bool projFromImage, std::string proj, std::string format);
         ~RSGISDefineSpectralDivision();
     private:
-        void assignToCategory(GDALDataset *reflDataset, GDALDataset *catsDataset, std::vector<std::pair<float, float> > **catThresholds, unsigned int numBands, unsigned int numCats, float noDataVal, bool noDataValProvided);
-        void generateSpectralDivThresholds(std::pair<float, float> *pThreshold, unsigned int bandIdx, unsigned int numBands, unsigned int subDivision, std::vector<std::pair<float, float> > **bandThresholds, std::vector<std::pair<float, float> > **catThresholds);
+        /**
+         * The lower and upper thresholds of the subDivision bins of each band
+         * (subDivision values per band) from the band minimum and maximum.
+         * Returns the number of categories.
+         */
+        unsigned int calcBandThresholds(GDALDataset *inData, unsigned int subDivision, std::vector<float> *binMins, std::vector<float> *binMaxs);
+        void assignToCategory(GDALDataset *reflDataset, GDALDataset *catsDataset, const std::vector<float> &binMins, const std::vector<float> &binMaxs, unsigned int subDivision, unsigned int numCats, float noDataVal, bool noDataValProvided);
     };
     
 }}
@@ -50,35 +50,32 @@ namespace rsgis{namespace segment{
                 throw rsgis::img::RSGISImageCalcException("Number of rows read is not what was expected.");
             }
             
-            size_t *newClumpIds = new size_t[numRows];
-            size_t clumpID = 1;
+            std::vector<unsigned int> newClumpIds(numRows, 0);
+            unsigned int clumpID = 1;
             for(size_t i = 1; i < numRows; ++i)
             {
-                if(selectCol[i] == 1)
-                {
-                    newClumpIds[i] = 0;
-                }
-                else
+                if(selectCol[i] != 1)
                 {
                     newClumpIds[i] = clumpID++;
                 }
             }
+            delete[] selectCol;
             
-            RSGISDropClumpsRelabelling *calcImgValRelabel = new RSGISDropClumpsRelabelling(newClumpIds, numRows);
-            rsgis::img::RSGISCalcImage calcImageRelabel(calcImgValRelabel);
-            calcImageRelabel.calcImage(&clumpsImage, 1, 0, outputImage, false, NULL, gdalFormat, GDT_UInt32);
-            delete calcImgValRelabel;
-            
-            GDALDataset *outClumpsDataset = (GDALDataset *) GDALOpen(outputImage.c_str(), GA_Update);
+            rsgis::img::RSGISImageUtils imgUtils;
+            GDALDataset *outClumpsDataset = imgUtils.createCopy(clumpsImage, 1, outputImage, gdalFormat, GDT_UInt32);
             if(outClumpsDataset == NULL)
             {
-                std::string message = std::string("Could not open image ") + outputImage;
+                std::string message = std::string("Could not create image ") + outputImage;
                 throw rsgis::RSGISImageException(message.c_str());
             }
-            outClumpsDataset->GetRasterBand(1)->SetMetadataItem("LAYER_TYPE", "thematic");
+            
+            // The histogram of the new clumps is counted as they are written.
+            RSGISClumpRelabeller relabeller;
+            std::vector<unsigned long long> histogram;
+            relabeller.applyLUT(clumpBand, outClumpsDataset->GetRasterBand(1), newClumpIds, &histogram);
             
             rsgis::rastergis::RSGISPopulateWithImageStats popImageStats;
-            popImageStats.populateImageWithRasterGISStats(outClumpsDataset, true, true, 1);
+            popImageStats.writeHistogramToRAT(outClumpsDataset, histogram, true, true, 1);
             popImageStats.calcPyramids(outClumpsDataset);
             
             GDALClose(outClumpsDataset);
@@ -27,6 +27,7 @@
 #include <string>
 #include <math.h>
 #include <stdlib.h>
+#include <vector>
 
 #include "common/RSGISAttributeTableException.h"
 
@@ -46,6 +47,8 @@
 #include "rastergis/RSGISRasterAttUtils.h"
 #include "rastergis/RSGISCalcImageStatsAndPyramids.h"
 
+#include "segmentation/RSGISClumpPxls.h"
+
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
 #undef DllExport
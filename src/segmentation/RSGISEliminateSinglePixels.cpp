@@ -56,28 +56,7 @@ namespace rsgis{namespace segment{
             outData = imgUtils.createCopy(inClumpsData, outputImage, format, GDT_UInt32, projFromImage, proj);
             imgUtils.copyUIntGDALDataset(inClumpsData, outData);
             
-            unsigned long singlesCount = 0;
-            bool singlesRemoved = false;
-            
-            while(!singlesRemoved)
-            {
-                singlesCount = this->findSinglePixels(outData, tmpData, noDataVal, noDataValProvided);
-                if(singlesCount > 0)
-                {
-                    std::cout << "There are " << singlesCount << " single pixels within the image\n";
-                    if(!eliminateSinglePixels(inSpecData, outData, tmpData, outData, noDataVal, noDataValProvided))
-                    {
-                        singlesRemoved = true;
-                        break;
-                    }
-                }
-                else
-                {
-                    singlesRemoved = true;
-                    break;
-                }
-            }
-            std::cout << "Complete, all connected single pixels have been removed\n";
+            this->eliminateBlocks(inSpecData, outData, tmpData, noDataVal, noDataValProvided);
             
             GDALClose(outData);
             
@@ -119,48 +98,7 @@ namespace rsgis{namespace segment{
             outData = imgUtils.createCopy(inClumpsData, outputImage, format, GDT_UInt32, projFromImage, proj);
             imgUtils.copyUIntGDALDataset(inClumpsData, outData);
             
-            RSGISFindSinglePixels *findSingles = new RSGISFindSinglePixels(noDataVal, noDataValProvided);
-            rsgis::img::RSGISCalcImage imgCalcFindSingles = rsgis::img::RSGISCalcImage(findSingles);
-            
-            RSGISElimSinglePixelsCalcImg *elimSingles = new RSGISElimSinglePixelsCalcImg(noDataVal, noDataValProvided);
-            rsgis::img::RSGISCalcImage imgCalcElimSingles = rsgis::img::RSGISCalcImage(elimSingles);
-            
-            GDALDataset **inElimDatasets = new GDALDataset*[3];
-            inElimDatasets[0] = tmpData;
-            inElimDatasets[1] = outData;
-            inElimDatasets[2] = inSpecData;
-            
-            unsigned long singlesCount = 0;
-            bool singlesRemoved = false;
-            while(!singlesRemoved)
-            {
-                findSingles->resetCount();
-                imgCalcFindSingles.calcImageWindowData(&outData, 1, tmpData, 3);
-                singlesCount = findSingles->getCount();
-
-                if(singlesCount > 0)
-                {
-                    std::cout << "There are " << singlesCount << " single pixels within the image\n";
-                    elimSingles->resetChangeOccured();
-                    imgCalcElimSingles.calcImageWindowData(inElimDatasets, 3, outData, 3);
-                    
-                    if(!elimSingles->getChangeOccured())
-                    {
-                        singlesRemoved = true;
-                        break;
-                    }
-                }
-                else
-                {
-                    singlesRemoved = true;
-                    break;
-                }
-            }
-            std::cout << "Complete, all connected single pixels have been removed\n";
-            
-            delete findSingles;
-            delete elimSingles;
-            delete[] inElimDatasets;
+            this->eliminateBlocks(inSpecData, outData, tmpData, noDataVal, noDataValProvided);
             
             GDALClose(outData);
             
@@ -175,984 +113,309 @@ namespace rsgis{namespace segment{
         }
     }
     
-    unsigned long RSGISEliminateSinglePixels::findSinglePixels(GDALDataset *inClumpsData, GDALDataset *tmpData, float noDataVal, bool noDataValProvided) 
+    void RSGISEliminateSinglePixels::eliminateBlocks(GDALDataset *inSpecData, GDALDataset *clumpsData, GDALDataset *tmpData, float noDataVal, bool noDataValProvided)
     {
-        unsigned long countSingles = 0;
-        try 
+        try
         {
-            unsigned int width = inClumpsData->GetRasterXSize();
-            unsigned int height = inClumpsData->GetRasterYSize();
+            if(inSpecData->GetRasterXSize() != clumpsData->GetRasterXSize())
+            {
+                throw rsgis::img::RSGISImageCalcException("Widths are not the same (spectral and categories)");
+            }
+            if(inSpecData->GetRasterYSize() != clumpsData->GetRasterYSize())
+            {
+                throw rsgis::img::RSGISImageCalcException("Heights are not the same (spectral and categories)");
+            }
+            if(inSpecData->GetRasterXSize() != tmpData->GetRasterXSize())
+            {
+                throw rsgis::img::RSGISImageCalcException("Widths are not the same (spectral and temp)");
+            }
+            if(inSpecData->GetRasterYSize() != tmpData->GetRasterYSize())
+            {
+                throw rsgis::img::RSGISImageCalcException("Heights are not the same (spectral and temp)");
+            }
             
-            GDALRasterBand *clumpBand = inClumpsData->GetRasterBand(1);
-            GDALRasterBand *tmpBand = tmpData->GetRasterBand(1);
+            unsigned int width = clumpsData->GetRasterXSize();
+            unsigned int height = clumpsData->GetRasterYSize();
+            if((width == 0) || (height == 0))
+            {
+                return;
+            }
+            size_t numPxls = ((size_t)width) * height;
             
-            unsigned int **inData = new unsigned int*[3];
-            inData[0] = new unsigned int[width];
-            inData[1] = new unsigned int[width];
-            inData[2] = new unsigned int[width];
-            unsigned int *outData = new unsigned int[width];
-            bool notSingle = false;
+            GDALRasterBand *clumpBand = clumpsData->GetRasterBand(1);
+            std::vector<unsigned int> labels(numPxls);
+            if(clumpBand->RasterIO(GF_Read, 0, 0, width, height, labels.data(), width, height, GDT_UInt32, 0, 0) != CE_None)
+            {
+                throw rsgis::img::RSGISImageCalcException("Could not read the clumps image.");
+            }
             
-            rsgis_tqdm pbar;
-            for(unsigned int i = 0; i < height; ++i)
+            // Single pixels are found in raster order so the list is sorted by idx.
+            std::vector<unsigned char> singleFlags(numPxls, 0);
+            std::vector<RSGISSinglePixel> singles;
+            for(size_t idx = 0; idx < numPxls; ++idx)
             {
-                pbar.progress(i, height);
-                if(i == 0)
+                if(this->isSinglePixel(labels, width, height, idx, noDataVal, noDataValProvided))
                 {
-                    clumpBand->RasterIO(GF_Read, 0, i, width, 1, inData[1], width, 1, GDT_UInt32, 0, 0);
-                    clumpBand->RasterIO(GF_Read, 0, i+1, width, 1, inData[2], width, 1, GDT_UInt32, 0, 0);
-                    for(unsigned int j = 0; j < width; ++j)
-                    {
-                        notSingle = false;
-                        if((noDataValProvided & (inData[1][j] != noDataVal)) | !noDataValProvided)
-                        {
-                            if(j == 0)
-                            {
-                                //right
-                                if((j < width-1) && (inData[1][j+1] == inData[1][j]))
-                                {
-                                    notSingle = true;
-                                }
-                                //bottom
-                                else if(inData[2][j] == inData[1][j])
-                                {
-                                    notSingle = true;
-                                }
-                            }
-                            else if(j == (width-1))
-                            {
-                                //left
-                                if((j > 0) && (inData[1][j-1] == inData[1][j]))
-                                {
-                                    notSingle = true;
-                                }
-                                //bottom
-                                else if(inData[2][j] == inData[1][j])
-                                {
-                                    notSingle = true;
-                                }
-                            }
-                            else 
-                            {
-                                //left
-                                if((j > 0) && (inData[1][j-1] == inData[1][j]))
-                                {
-                                    notSingle = true;
-                                }
-                                //right
-                                else if((j < width-1) && (inData[1][j+1] == inData[1][j]))
-                                {
-                                    notSingle = true;
-                                }
-                                //bottom
-                                else if(inData[2][j] == inData[1][j])
-                                {
-                                    notSingle = true;
-                                }
-                            }
-                        }
-                        else
-                        {
-                            notSingle = true;
-                        }
-                        
-                        if(notSingle)
-                        {
-                            outData[j] = 0;
-                        }
-                        else
-                        {
-                            outData[j] = 1;
-                            ++countSingles;
-                        }
-                    }
+                    singleFlags[idx] = 1;
+                    RSGISSinglePixel pxl;
+                    pxl.idx = idx;
+                    pxl.validNbrs = 0;
+                    singles.push_back(pxl);
                 }
-                else if(i == (height-1))
+            }
+            std::cout << "There are " << singles.size() << " single pixels within the image\n";
+            
+            if(!singles.empty())
+            {
+                this->calcNeighbourDistances(inSpecData, width, height, noDataVal, noDataValProvided, &singles);
+                
+                std::vector<bool> rowChanged(height, false);
+                unsigned long numChanged = this->eliminateSinglePixels(&labels, &singleFlags, singles, width, height, noDataVal, noDataValProvided, &rowChanged);
+                std::cout << numChanged << " single pixels were merged into a neighbouring clump\n";
+                
+                // Write back the runs of rows which have changed.
+                unsigned int row = 0;
+                while(row < height)
                 {
-                    clumpBand->RasterIO(GF_Read, 0, i-1, width, 1, inData[0], width, 1, GDT_UInt32, 0, 0);
-                    clumpBand->RasterIO(GF_Read, 0, i, width, 1, inData[1], width, 1, GDT_UInt32, 0, 0);
-                    for(unsigned int j = 0; j < width; ++j)
+                    if(!rowChanged[row])
                     {
-                        notSingle = false;
-                        if((noDataValProvided & (inData[1][j] != noDataVal)) | !noDataValProvided)
-                        {
-                            if(j == 0)
-                            {
-                                //top
-                                if(inData[0][j] == inData[1][j])
-                                {
-                                    notSingle = true;
-                                }
-                                //right
-                                else if((j < width-1) && (inData[1][j+1] == inData[1][j]))
-                                {
-                                    notSingle = true;
-                                }
-                            }
-                            else if(j == (width-1))
-                            {
-                                //top
-                                if(inData[0][j] == inData[1][j])
-                                {
-                                    notSingle = true;
-                                }
-                                //left
-                                else if((j > 0) && (inData[1][j-1] == inData[1][j]))
-                                {
-                                    notSingle = true;
-                                }
-                            }
-                            else 
-                            {
-                                //top
-                                if(inData[0][j] == inData[1][j])
-                                {
-                                    notSingle = true;
-                                }
-                                //left
-                                else if((j > 0) && (inData[1][j-1] == inData[1][j]))
-                                {
-                                    notSingle = true;
-                                }
-                                //right
-                                else if((j < width-1) && (inData[1][j+1] == inData[1][j]))
-                                {
-                                    notSingle = true;
-                                }
-                            }
-                        }
-                        else
-                        {
-                            notSingle = true;
-                        }
-                        
-                        if(notSingle)
-                        {
-                            outData[j] = 0;
-                        }
-                        else
-                        {
-                            outData[j] = 1;
-                            ++countSingles;
-                        }
+                        ++row;
+                        continue;
                     }
-                }
-                else
-                {
-                    clumpBand->RasterIO(GF_Read, 0, i-1, width, 1, inData[0], width, 1, GDT_UInt32, 0, 0);
-                    clumpBand->RasterIO(GF_Read, 0, i, width, 1, inData[1], width, 1, GDT_UInt32, 0, 0);
-                    clumpBand->RasterIO(GF_Read, 0, i+1, width, 1, inData[2], width, 1, GDT_UInt32, 0, 0);
-                    for(unsigned int j = 0; j < width; ++j)
+                    unsigned int startRow = row;
+                    while((row < height) && rowChanged[row])
                     {
-                        notSingle = false;
-                        if((noDataValProvided & (inData[1][j] != noDataVal)) | !noDataValProvided)
-                        {
-                            if(j == 0)
-                            {
-                                //top
-                                if(inData[0][j] == inData[1][j])
-                                {
-                                    notSingle = true;
-                                }
-                                //right
-                                else if((j < width-1) && (inData[1][j+1] == inData[1][j]))
-                                {
-                                    notSingle = true;
-                                }
-                                //bottom
-                                else if(inData[2][j] == inData[1][j])
-                                {
-                                    notSingle = true;
-                                }
-                            }
-                            else if(j == (width-1))
-                            {
-                                //top
-                                if(inData[0][j] == inData[1][j])
-                                {
-                                    notSingle = true;
-                                }
-                                //left
-                                else if((j > 0) && (inData[1][j-1] == inData[1][j]))
-                                {
-                                    notSingle = true;
-                                }
-                                //bottom
-                                else if(inData[2][j] == inData[1][j])
-                                {
-                                    notSingle = true;
-                                }
-                            }
-                            else 
-                            {
-                                //top
-                                if(inData[0][j] == inData[1][j])
-                                {
-                                    notSingle = true;
-                                }
-                                //left
-                                else if((j > 0) && (inData[1][j-1] == inData[1][j]))
-                                {
-                                    notSingle = true;
-                                }
-                                //right
-                                else if((j < width-1) && (inData[1][j+1] == inData[1][j]))
-                                {
-                                    notSingle = true;
-                                }
-                                //bottom
-                                else if(inData[2][j] == inData[1][j])
-                                {
-                                    notSingle = true;
-                                }
-                            }
-                        }
-                        else
-                        {
-                            notSingle = true;
-                        }
-                        
-                        if(notSingle)
-                        {
-                            outData[j] = 0;
-                        }
-                        else
-                        {
-                            outData[j] = 1;
-                            ++countSingles;
-                        }
+                        ++row;
+                    }
+                    if(clumpBand->RasterIO(GF_Write, 0, startRow, width, row - startRow, &labels[((size_t)startRow) * width], width, row - startRow, GDT_UInt32, 0, 0) != CE_None)
+                    {
+                        throw rsgis::img::RSGISImageCalcException("Could not write to the clumps image.");
                     }
                 }
-                
-                tmpBand->RasterIO(GF_Write, 0, i, width, 1, outData, width, 1, GDT_UInt32, 0, 0);
             }
-            pbar.finish();
-            
-            delete[] inData[0];
-            delete[] inData[1];
-            delete[] inData[2];
-            delete[] inData;
-            delete[] outData;
+            std::cout << "Complete, all connected single pixels have been removed\n";
         }
-        catch (rsgis::img::RSGISImageCalcException &e)
+        catch(rsgis::img::RSGISImageCalcException &e)
         {
             throw e;
         }
-        
-        return countSingles;
+        catch(RSGISImageException &e)
+        {
+            throw rsgis::img::RSGISImageCalcException(e.what());
+        }
     }
     
-    bool RSGISEliminateSinglePixels::eliminateSinglePixels(GDALDataset *inSpecData, GDALDataset *inClumpsData, GDALDataset *tmpData, GDALDataset *outDataset, float noDataVal, bool noDataValProvided) 
+    bool RSGISEliminateSinglePixels::isSinglePixel(const std::vector<unsigned int> &labels, unsigned int width, unsigned int height, size_t idx, float noDataVal, bool noDataValProvided)
     {
-        bool hasChangeOccured = false;
-        try 
+        unsigned int label = labels[idx];
+        if(noDataValProvided && (((float)label) == noDataVal))
         {
-            unsigned int width = inClumpsData->GetRasterXSize();
-            unsigned int height = inClumpsData->GetRasterYSize();
-            unsigned int numBands = inSpecData->GetRasterCount();
-            
-            GDALRasterBand *clumpBand = inClumpsData->GetRasterBand(1);
-            GDALRasterBand *singlePxlBand = tmpData->GetRasterBand(1);
-            GDALRasterBand *outBand = outDataset->GetRasterBand(1);
-            GDALRasterBand **specBands = new GDALRasterBand*[numBands];
-            
-            unsigned int **inData = new unsigned int*[3];
-            inData[0] = new unsigned int[width];
-            inData[1] = new unsigned int[width];
-            inData[2] = new unsigned int[width];
-            
-            unsigned int **singlePxl = new unsigned int*[3];
-            singlePxl[0] = new unsigned int[width];
-            singlePxl[1] = new unsigned int[width];
-            singlePxl[2] = new unsigned int[width];
-                        
-            float ***specData = new float**[3];
-            specData[0] = new float*[numBands];
-            specData[1] = new float*[numBands];
-            specData[2] = new float*[numBands];
-            for(unsigned int i = 0; i < numBands; ++i)
+            return false;
+        }
+        unsigned int x = idx % width;
+        unsigned int y = idx / width;
+        // Outside the image is read as 0 (as the window passes padded the image).
+        unsigned int top = (y > 0)?labels[idx - width]:0;
+        unsigned int bottom = (y < (height-1))?labels[idx + width]:0;
+        unsigned int left = (x > 0)?labels[idx - 1]:0;
+        unsigned int right = (x < (width-1))?labels[idx + 1]:0;
+        return (top != label) && (bottom != label) && (left != label) && (right != label);
+    }
+    
+    void RSGISEliminateSinglePixels::calcNeighbourDistances(GDALDataset *inSpecData, unsigned int width, unsigned int height, float noDataVal, bool noDataValProvided, std::vector<RSGISSinglePixel> *singles)
+    {
+        unsigned int numBands = inSpecData->GetRasterCount();
+        if(numBands == 0)
+        {
+            throw rsgis::img::RSGISImageCalcException("The spectral image has no bands.");
+        }
+        
+        int xBlockSize = 0;
+        int yBlockSize = 0;
+        inSpecData->GetRasterBand(1)->GetBlockSize(&xBlockSize, &yBlockSize);
+        rsgis::img::RSGISImageBlockPlanner planner;
+        rsgis::img::RSGISImageBlockPlan blockPlan = planner.plan(yBlockSize, width, height, numBands * sizeof(float), 1, numBands * (GDALGetDataTypeSize(inSpecData->GetRasterBand(1)->GetRasterDataType()) / 8));
+        unsigned int numRows = blockPlan.rows;
+        rsgis::img::RSGISGDALCacheScope gdalCacheScope(blockPlan.gdalCacheBytes);
+        
+        // Each block is read with a row above and below, pixel interleaved so
+        // the band values of a pixel are contiguous.
+        std::vector<float> specData(((size_t)(numRows + 2)) * width * numBands);
+        const int nbrDX[4] = {0, 0, -1, 1};
+        const int nbrDY[4] = {-1, 1, 0, 0};
+        std::vector<RSGISSinglePixel>::iterator iterPxl = singles->begin();
+        rsgis_tqdm pbar;
+        for(unsigned int startRow = 0; (startRow < height) && (iterPxl != singles->end()); startRow += numRows)
+        {
+            pbar.progress(startRow, height);
+            unsigned int endRow = std::min(startRow + numRows, height);
+            size_t endIdx = ((size_t)endRow) * width;
+            if(iterPxl->idx >= endIdx)
             {
-                specData[0][i] = new float[width];
-                specData[1][i] = new float[width];
-                specData[2][i] = new float[width];
-                specBands[i] = inSpecData->GetRasterBand(i+1);
+                continue;
             }
             
-            unsigned int *outData = new unsigned int[width];
-            bool first = true;
-            float minDist = 0;
-            float dist = 0;
-            unsigned int minDistVal = 0;
+            unsigned int readStart = (startRow > 0)?(startRow - 1):0;
+            unsigned int readEnd = std::min(endRow + 1, height);
+            if(inSpecData->RasterIO(GF_Read, 0, readStart, width, readEnd - readStart, specData.data(), width, readEnd - readStart, GDT_Float32, numBands, NULL, numBands * sizeof(float), ((GSpacing)width) * numBands * sizeof(float), sizeof(float)) != CE_None)
+            {
+                throw rsgis::img::RSGISImageCalcException("Could not read the spectral image.");
+            }
             
-            int feedback = height/10;
-            int feedbackCounter = 0;
-            rsgis_tqdm pbar;
-            for(unsigned int i = 0; i < height; ++i)
+            for(; (iterPxl != singles->end()) && (iterPxl->idx < endIdx); ++iterPxl)
             {
-                pbar.progress(i, height);
-                if(i == 0)
+                int x = iterPxl->idx % width;
+                int y = iterPxl->idx / width;
+                const float *centre = &specData[((((size_t)(y - readStart)) * width) + x) * numBands];
+                iterPxl->validNbrs = 0;
+                for(unsigned int k = 0; k < 4; ++k)
                 {
-                    clumpBand->RasterIO(GF_Read, 0, i, width, 1, inData[1], width, 1, GDT_UInt32, 0, 0);
-                    clumpBand->RasterIO(GF_Read, 0, i+1, width, 1, inData[2], width, 1, GDT_UInt32, 0, 0);
-                    singlePxlBand->RasterIO(GF_Read, 0, i, width, 1, singlePxl[1], width, 1, GDT_UInt32, 0, 0);
-                    singlePxlBand->RasterIO(GF_Read, 0, i+1, width, 1, singlePxl[2], width, 1, GDT_UInt32, 0, 0);
-                    for(unsigned int n = 0; n < numBands; ++n)
+                    iterPxl->dist[k] = 0;
+                    int nX = x + nbrDX[k];
+                    int nY = y + nbrDY[k];
+                    if((nX < 0) || (nY < 0) || (nX >= ((int)width)) || (nY >= ((int)height)))
                     {
-                        specBands[n]->RasterIO(GF_Read, 0, i, width, 1, specData[1][n], width, 1, GDT_Float32, 0, 0);
-                        specBands[n]->RasterIO(GF_Read, 0, i+1, width, 1, specData[2][n], width, 1, GDT_Float32, 0, 0);
+                        continue;
                     }
-                    
-                    for(unsigned int j = 0; j < width; ++j)
+                    const float *nbr = &specData[((((size_t)(nY - readStart)) * width) + nX) * numBands];
+                    bool noDataNbr = noDataValProvided;
+                    for(unsigned int n = 0; (n < numBands) && noDataNbr; ++n)
                     {
-                        if((noDataValProvided & (inData[1][j] != noDataVal)) | !noDataValProvided)
-                        {
-                            if(singlePxl[1][j] == 1)
-                            {
-                                if(j == 0)
-                                {
-                                    first = true;
-                                    minDist = 0;
-                                    minDistVal = 0;
-                                    
-                                    //right
-                                    if((j < width-1) && (singlePxl[1][j+1] == 0))
-                                    {
-                                        dist = this->eucDistance(specData[1], specData[1], numBands, j+1, j);
-                                        if(first)
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[1][j+1];
-                                        }
-                                        else if(dist < minDist) 
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[1][j+1];
-                                        }
-                                    }
-                                    //bottom
-                                    else if(singlePxl[2][j] == 0)
-                                    {
-                                        dist = this->eucDistance(specData[2], specData[1], numBands, j, j);
-                                        if(first)
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[2][j];
-                                            first = false;
-                                        }
-                                        else if(dist < minDist) 
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[2][j];
-                                        }
-                                    }
-                                    
-                                    if(first)
-                                    {
-                                        outData[j] = inData[1][j];
-                                    }
-                                    else
-                                    {
-                                        outData[j] = minDistVal;
-                                        hasChangeOccured = true;
-                                    }
-                                }
-                                else if(j == (width-1))
-                                {
-                                    first = true;
-                                    minDist = 0;
-                                    minDistVal = 0;
-                                    
-                                    //left
-                                    if((j > 0) && (singlePxl[1][j-1] == 0))
-                                    {
-                                        dist = this->eucDistance(specData[1], specData[1], numBands, j-1, j);
-                                        if(first)
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[1][j-1];
-                                            first = false;
-                                        }
-                                        else if(dist < minDist) 
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[1][j-1];
-                                        }
-                                    }
-                                    //bottom
-                                    else if(singlePxl[2][j] == 0)
-                                    {
-                                        dist = this->eucDistance(specData[2], specData[1], numBands, j, j);
-                                        if(first)
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[2][j];
-                                            first = false;
-                                        }
-                                        else if(dist < minDist) 
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[2][j];
-                                        }
-                                    }
-                                    
-                                    if(first)
-                                    {
-                                        outData[j] = inData[1][j];
-                                    }
-                                    else
-                                    {
-                                        outData[j] = minDistVal;
-                                        hasChangeOccured = true;
-                                    }
-                                }
-                                else 
-                                {
-                                    first = true;
-                                    minDist = 0;
-                                    minDistVal = 0;
-                                    
-                                    //left
-                                    if((j > 0) && (singlePxl[1][j-1] == 0))
-                                    {
-                                        dist = this->eucDistance(specData[1], specData[1], numBands, j-1, j);
-                                        if(first)
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[1][j-1];
-                                            first = false;
-                                        }
-                                        else if(dist < minDist) 
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[1][j-1];
-                                        }
-                                    }
-                                    //right
-                                    else if((j < width-1) && (singlePxl[1][j+1] == 0))
-                                    {
-                                        dist = this->eucDistance(specData[1], specData[1], numBands, j+1, j);
-                                        if(first)
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[1][j+1];
-                                            first = false;
-                                        }
-                                        else if(dist < minDist) 
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[1][j+1];
-                                        }
-                                    }
-                                    //bottom
-                                    else if(singlePxl[2][j] == 0)
-                                    {
-                                        dist = this->eucDistance(specData[2], specData[1], numBands, j, j);
-                                        if(first)
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[2][j];
-                                            first = false;
-                                        }
-                                        else if(dist < minDist) 
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[2][j];
-                                        }
-                                    }
-                                    
-                                    if(first)
-                                    {
-                                        outData[j] = inData[1][j];
-                                    }
-                                    else
-                                    {
-                                        outData[j] = minDistVal;
-                                        hasChangeOccured = true;
-                                    }
-                                }
-                            }
-                            else
-                            {
-                                outData[j] = inData[1][j];
-                            }
-                        }
-                        else
-                        {
-                            outData[j] = inData[1][j];
-                        }
+                        noDataNbr = (nbr[n] == noDataVal);
                     }
-                    
-                }
-                else if(i == (height-1))
-                {
-                    clumpBand->RasterIO(GF_Read, 0, i-1, width, 1, inData[0], width, 1, GDT_UInt32, 0, 0);
-                    clumpBand->RasterIO(GF_Read, 0, i, width, 1, inData[1], width, 1, GDT_UInt32, 0, 0);
-                    singlePxlBand->RasterIO(GF_Read, 0, i-1, width, 1, singlePxl[0], width, 1, GDT_UInt32, 0, 0);
-                    singlePxlBand->RasterIO(GF_Read, 0, i, width, 1, singlePxl[1], width, 1, GDT_UInt32, 0, 0);
-                    for(unsigned int n = 0; n < numBands; ++n)
+                    if(!noDataNbr)
                     {
-                        specBands[n]->RasterIO(GF_Read, 0, i-1, width, 1, specData[0][n], width, 1, GDT_Float32, 0, 0);
-                        specBands[n]->RasterIO(GF_Read, 0, i, width, 1, specData[1][n], width, 1, GDT_Float32, 0, 0);
+                        iterPxl->dist[k] = this->eucDistance(centre, nbr, numBands);
+                        iterPxl->validNbrs |= (1 << k);
                     }
-                    
-                    for(unsigned int j = 0; j < width; ++j)
+                }
+            }
+        }
+        pbar.finish();
+    }
+    
+    unsigned long RSGISEliminateSinglePixels::eliminateSinglePixels(std::vector<unsigned int> *labels, std::vector<unsigned char> *singleFlags, const std::vector<RSGISSinglePixel> &singles, unsigned int width, unsigned int height, float noDataVal, bool noDataValProvided, std::vector<bool> *rowChanged)
+    {
+        auto nbrIdx = [width, height](size_t idx, unsigned int k, size_t *nIdx)
+        {
+            unsigned int x = idx % width;
+            unsigned int y = idx / width;
+            switch(k)
+            {
+                case 0: *nIdx = idx - width; return y > 0;
+                case 1: *nIdx = idx + width; return y < (height-1);
+                case 2: *nIdx = idx - 1; return x > 0;
+                default: *nIdx = idx + 1; return x < (width-1);
+            }
+        };
+        auto recordOf = [&singles](size_t idx)
+        {
+            std::vector<RSGISSinglePixel>::const_iterator iterPxl = std::lower_bound(singles.begin(), singles.end(), idx, [](const RSGISSinglePixel &pxl, size_t val){ return pxl.idx < val; });
+            return (size_t)(iterPxl - singles.begin());
+        };
+        
+        std::vector<size_t> worklist(singles.size());
+        for(size_t r = 0; r < singles.size(); ++r)
+        {
+            worklist[r] = r;
+        }
+        std::vector<unsigned char> queued(singles.size(), 0);
+        std::vector<std::pair<size_t, unsigned int> > changes;
+        std::vector<size_t> touched;
+        unsigned long numChanged = 0;
+        unsigned int nIter = 0;
+        while(!worklist.empty())
+        {
+            // Choose the new labels from the state at the start of the iteration.
+            changes.clear();
+            for(std::vector<size_t>::iterator iterWork = worklist.begin(); iterWork != worklist.end(); ++iterWork)
+            {
+                queued[*iterWork] = 0;
+                const RSGISSinglePixel &pxl = singles[*iterWork];
+                if((*singleFlags)[pxl.idx] == 0)
+                {
+                    continue;
+                }
+                bool found = false;
+                float minDist = 0;
+                unsigned int outLabel = 0;
+                size_t nIdx = 0;
+                for(unsigned int k = 0; k < 4; ++k)
+                {
+                    if((pxl.validNbrs & (1 << k)) && nbrIdx(pxl.idx, k, &nIdx) && ((*singleFlags)[nIdx] == 0))
                     {
-                        if((noDataValProvided & (inData[1][j] != noDataVal)) | !noDataValProvided)
+                        if((!found) || (pxl.dist[k] < minDist))
                         {
-                            if(singlePxl[1][j] == 1)
-                            {
-                                if(j == 0)
-                                {
-                                    first = true;
-                                    minDist = 0;
-                                    minDistVal = 0;
-                                    //top
-                                    if(singlePxl[0][j] == 0)
-                                    {
-                                        dist = this->eucDistance(specData[0], specData[1], numBands, j, j);
-                                        if(first)
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[0][j];
-                                            first = false;
-                                        }
-                                        else if(dist < minDist) 
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[0][j];
-                                        }
-                                    }
-                                    //right
-                                    else if((j < width-1) && (singlePxl[1][j+1] == 0))
-                                    {
-                                        dist = this->eucDistance(specData[1], specData[1], numBands, j+1, j);
-                                        if(first)
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[1][j+1];
-                                            first = false;
-                                        }
-                                        else if(dist < minDist) 
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[1][j+1];
-                                        }
-                                    }
-                                    
-                                    if(first)
-                                    {
-                                        outData[j] = inData[1][j];
-                                    }
-                                    else
-                                    {
-                                        outData[j] = minDistVal;
-                                        hasChangeOccured = true;
-                                    }
-                                }
-                                else if(j == (width-1))
-                                {
-                                    first = true;
-                                    minDist = 0;
-                                    minDistVal = 0;
-                                    //top
-                                    if(singlePxl[0][j] == 0)
-                                    {
-                                        dist = this->eucDistance(specData[0], specData[1], numBands, j, j);
-                                        if(first)
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[0][j];
-                                            first = false;
-                                        }
-                                        else if(dist < minDist) 
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[0][j];
-                                        }
-                                    }
-                                    //left
-                                    else if((j > 0) && (singlePxl[1][j-1] == 0))
-                                    {
-                                        dist = this->eucDistance(specData[1], specData[1], numBands, j-1, j);
-                                        if(first)
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[1][j-1];
-                                            first = false;
-                                        }
-                                        else if(dist < minDist) 
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[1][j-1];
-                                        }
-                                    }
-                                    
-                                    if(first)
-                                    {
-                                        outData[j] = inData[1][j];
-                                    }
-                                    else
-                                    {
-                                        outData[j] = minDistVal;
-                                        hasChangeOccured = true;
-                                    }
-                                }
-                                else 
-                                {
-                                    first = true;
-                                    minDist = 0;
-                                    minDistVal = 0;
-                                    //top
-                                    if(singlePxl[0][j] == 0)
-                                    {
-                                        dist = this->eucDistance(specData[0], specData[1], numBands, j, j);
-                                        if(first)
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[0][j];
-                                            first = false;
-                                        }
-                                        else if(dist < minDist) 
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[0][j];
-                                        }
-                                    }
-                                    //left
-                                    else if((j > 0) && (singlePxl[1][j-1] == 0))
-                                    {
-                                        dist = this->eucDistance(specData[1], specData[1], numBands, j-1, j);
-                                        if(first)
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[1][j-1];
-                                            first = false;
-                                        }
-                                        else if(dist < minDist) 
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[1][j-1];
-                                        }
-                                    }
-                                    //right
-                                    else if((j < width-1) && (singlePxl[1][j+1] == 0))
-                                    {
-                                        dist = this->eucDistance(specData[1], specData[1], numBands, j+1, j);
-                                        if(first)
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[1][j+1];
-                                            first = false;
-                                        }
-                                        else if(dist < minDist) 
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[1][j+1];
-                                        }
-                                    }
-                                    
-                                    if(first)
-                                    {
-                                        outData[j] = inData[1][j];
-                                    }
-                                    else
-                                    {
-                                        outData[j] = minDistVal;
-                                        hasChangeOccured = true;
-                                    }
-                                }                                
-                            }
-                            else
-                            {
-                                outData[j] = inData[1][j];
-                            }
-                        }
-                        else
-                        {
-                            outData[j] = inData[1][j];
+                            minDist = pxl.dist[k];
+                            outLabel = (*labels)[nIdx];
+                            found = true;
                         }
                     }
                 }
-                else
+                if(found)
                 {
-                    clumpBand->RasterIO(GF_Read, 0, i-1, width, 1, inData[0], width, 1, GDT_UInt32, 0, 0);
-                    clumpBand->RasterIO(GF_Read, 0, i, width, 1, inData[1], width, 1, GDT_UInt32, 0, 0);
-                    clumpBand->RasterIO(GF_Read, 0, i+1, width, 1, inData[2], width, 1, GDT_UInt32, 0, 0);
-                    singlePxlBand->RasterIO(GF_Read, 0, i-1, width, 1, singlePxl[0], width, 1, GDT_UInt32, 0, 0);
-                    singlePxlBand->RasterIO(GF_Read, 0, i, width, 1, singlePxl[1], width, 1, GDT_UInt32, 0, 0);
-                    singlePxlBand->RasterIO(GF_Read, 0, i+1, width, 1, singlePxl[2], width, 1, GDT_UInt32, 0, 0);
-                    for(unsigned int n = 0; n < numBands; ++n)
+                    changes.push_back(std::pair<size_t, unsigned int>(pxl.idx, outLabel));
+                }
+            }
+            if(changes.empty())
+            {
+                break;
+            }
+            
+            for(std::vector<std::pair<size_t, unsigned int> >::iterator iterChange = changes.begin(); iterChange != changes.end(); ++iterChange)
+            {
+                (*labels)[iterChange->first] = iterChange->second;
+                (*rowChanged)[iterChange->first / width] = true;
+            }
+            numChanged += changes.size();
+            
+            // Update the flags around the changed pixels; a pixel can only stop
+            // being single. The single pixels next to a pixel which changed label
+            // or flag are revisited in the next iteration.
+            touched.clear();
+            size_t nIdx = 0;
+            for(std::vector<std::pair<size_t, unsigned int> >::iterator iterChange = changes.begin(); iterChange != changes.end(); ++iterChange)
+            {
+                touched.push_back(iterChange->first);
+                (*singleFlags)[iterChange->first] = this->isSinglePixel(*labels, width, height, iterChange->first, noDataVal, noDataValProvided)?1:0;
+                for(unsigned int k = 0; k < 4; ++k)
+                {
+                    if(nbrIdx(iterChange->first, k, &nIdx) && ((*singleFlags)[nIdx] == 1) && !this->isSinglePixel(*labels, width, height, nIdx, noDataVal, noDataValProvided))
                     {
-                        specBands[n]->RasterIO(GF_Read, 0, i-1, width, 1, specData[0][n], width, 1, GDT_Float32, 0, 0);
-                        specBands[n]->RasterIO(GF_Read, 0, i, width, 1, specData[1][n], width, 1, GDT_Float32, 0, 0);
-                        specBands[n]->RasterIO(GF_Read, 0, i+1, width, 1, specData[2][n], width, 1, GDT_Float32, 0, 0);
+                        (*singleFlags)[nIdx] = 0;
+                        touched.push_back(nIdx);
                     }
-                    
-                    for(unsigned int j = 0; j < width; ++j)
+                }
+            }
+            worklist.clear();
+            for(std::vector<size_t>::iterator iterTouched = touched.begin(); iterTouched != touched.end(); ++iterTouched)
+            {
+                for(unsigned int k = 0; k < 4; ++k)
+                {
+                    if(nbrIdx(*iterTouched, k, &nIdx) && ((*singleFlags)[nIdx] == 1))
                     {
-                        if((noDataValProvided & (inData[1][j] != noDataVal)) | !noDataValProvided)
+                        size_t r = recordOf(nIdx);
+                        if(!queued[r])
                         {
-                            if(singlePxl[1][j] == 1)
-                            {
-                                if(j == 0)
-                                {
-                                    first = true;
-                                    minDist = 0;
-                                    minDistVal = 0;
-                                    //top
-                                    if(singlePxl[0][j] == 0)
-                                    {
-                                        dist = this->eucDistance(specData[0], specData[1], numBands, j, j);
-                                        if(first)
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[0][j];
-                                            first = false;
-                                        }
-                                        else if(dist < minDist) 
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[0][j];
-                                        }
-                                    }
-                                    //right
-                                    else if((j < width-1) && (singlePxl[1][j+1] == 0))
-                                    {
-                                        dist = this->eucDistance(specData[1], specData[1], numBands, j+1, j);
-                                        if(first)
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[1][j+1];
-                                            first = false;
-                                        }
-                                        else if(dist < minDist) 
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[1][j+1];
-                                        }
-                                    }
-                                    //bottom
-                                    else if(singlePxl[2][j] == 0)
-                                    {
-                                        dist = this->eucDistance(specData[2], specData[1], numBands, j, j);
-                                        if(first)
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[2][j];
-                                            first = false;
-                                        }
-                                        else if(dist < minDist) 
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[2][j];
-                                        }
-                                    }
-                                    
-                                    if(first)
-                                    {
-                                        outData[j] = inData[1][j];
-                                    }
-                                    else
-                                    {
-                                        outData[j] = minDistVal;
-                                        hasChangeOccured = true;
-                                    }
-                                }
-                                else if(j == (width-1))
-                                {
-                                    first = true;
-                                    minDist = 0;
-                                    minDistVal = 0;
-                                    //top
-                                    if(singlePxl[0][j] == 0)
-                                    {
-                                        dist = this->eucDistance(specData[0], specData[1], numBands, j, j);
-                                        if(first)
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[0][j];
-                                            first = false;
-                                        }
-                                        else if(dist < minDist) 
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[0][j];
-                                        }
-                                    }
-                                    //left
-                                    else if((j > 0) && (singlePxl[1][j-1] == 0))
-                                    {
-                                        dist = this->eucDistance(specData[1], specData[1], numBands, j-1, j);
-                                        if(first)
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[1][j-1];
-                                            first = false;
-                                        }
-                                        else if(dist < minDist) 
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[1][j-1];
-                                        }
-                                    }
-                                    //bottom
-                                    else if(singlePxl[2][j] == 0)
-                                    {
-                                        dist = this->eucDistance(specData[2], specData[1], numBands, j, j);
-                                        if(first)
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[2][j];
-                                            first = false;
-                                        }
-                                        else if(dist < minDist) 
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[2][j];
-                                        }
-                                    }
-                                    
-                                    if(first)
-                                    {
-                                        outData[j] = inData[1][j];
-                                    }
-                                    else
-                                    {
-                                        outData[j] = minDistVal;
-                                        hasChangeOccured = true;
-                                    }
-                                }
-                                else 
-                                {
-                                    first = true;
-                                    minDist = 0;
-                                    minDistVal = 0;
-                                    //top
-                                    if(singlePxl[0][j] == 0)
-                                    {
-                                        dist = this->eucDistance(specData[0], specData[1], numBands, j, j);
-                                        if(first)
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[0][j];
-                                            first = false;
-                                        }
-                                        else if(dist < minDist) 
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[0][j];
-                                        }
-                                    }
-                                    //left
-                                    else if((j > 0) && (singlePxl[1][j-1] == 0))
-                                    {
-                                        dist = this->eucDistance(specData[1], specData[1], numBands, j-1, j);
-                                        if(first)
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[1][j-1];
-                                            first = false;
-                                        }
-                                        else if(dist < minDist) 
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[1][j-1];
-                                        }
-                                    }
-                                    //right
-                                    else if((j < width-1) && (singlePxl[1][j+1] == 0))
-                                    {
-                                        dist = this->eucDistance(specData[1], specData[1], numBands, j+1, j);
-                                        if(first)
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[1][j+1];
-                                            first = false;
-                                        }
-                                        else if(dist < minDist) 
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[1][j+1];
-                                        }
-                                    }
-                                    //bottom
-                                    else if(singlePxl[2][j] == 0)
-                                    {
-                                        dist = this->eucDistance(specData[2], specData[1], numBands, j, j);
-                                        if(first)
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[2][j];
-                                            first = false;
-                                        }
-                                        else if(dist < minDist) 
-                                        {
-                                            minDist = dist;
-                                            minDistVal = inData[2][j];
-                                        }
-                                    }
-                                    
-                                    if(first)
-                                    {
-                                        outData[j] = inData[1][j];
-                                    }
-                                    else
-                                    {
-                                        outData[j] = minDistVal;
-                                        hasChangeOccured = true;
-                                    }
-                                }
-                            }
-                            else
-                            {
-                                outData[j] = inData[1][j];
-                            }
-                        }
-                        else
-                        {
-                            outData[j] = inData[1][j];
+                            queued[r] = 1;
+                            worklist.push_back(r);
                         }
                     }
                 }
-                
-                outBand->RasterIO(GF_Write, 0, i, width, 1, outData, width, 1, GDT_UInt32, 0, 0);
             }
-            pbar.finish();
             
-            delete[] inData[0];
-            delete[] inData[1];
-            delete[] inData[2];
-            delete[] inData;
-            delete[] singlePxl[0];
-            delete[] singlePxl[1];
-            delete[] singlePxl[2];
-            delete[] singlePxl;
-            for(unsigned int i = 0; i < numBands; ++i)
-            {
-                delete[] specData[0][i];
-                delete[] specData[1][i];
-                delete[] specData[2][i];
-            }
-            delete[] specData[0];
-            delete[] specData[1];
-            delete[] specData[2];
-            delete[] specData;
-            delete[] outData;
-        }
-        catch (rsgis::img::RSGISImageCalcException &e)
-        {
-            throw e;
+            std::cout << "Iteration " << nIter++ << " merged " << changes.size() << " single pixels, " << worklist.size() << " to revisit\n";
         }
         
-        return hasChangeOccured;
+        return numChanged;
     }
     
-    float RSGISEliminateSinglePixels::eucDistance(float **vals1, float **vals2, unsigned int numBands, unsigned int col1, unsigned int col2)
+    float RSGISEliminateSinglePixels::eucDistance(const float *vals1, const float *vals2, unsigned int numBands)
     {
         float dist = 0;
         for(unsigned int i = 0; i < numBands; ++i)
         {
-            dist += (vals1[i][col1] - vals2[i][col2]) * (vals1[i][col1] - vals2[i][col2]);
+            dist += (vals1[i] - vals2[i]) * (vals1[i] - vals2[i]);
         }
         
         if(dist > 0)
@@ -27,6 +27,8 @@
 #include <string>
 #include <math.h>
 #include <stdlib.h>
+#include <vector>
+#include <algorithm>
 
 #include "common/rsgis-tqdm.h"
 
@@ -36,6 +38,7 @@
 
 #include "img/RSGISCalcImageValue.h"
 #include "img/RSGISCalcImage.h"
+#include "img/RSGISImageBlockPlanner.h"
 
 #include "rastergis/RSGISRasterAttUtils.h"
 
@@ -58,17 +61,48 @@
 
 namespace rsgis{namespace segment{
     
+    /**
+     * A pixel with no (4-connected) neighbours with the same label and the
+     * spectral distance to each of its neighbours (top, bottom, left, right),
+     * which are only candidates to merge into if their bit is set in validNbrs.
+     */
+    struct DllExport RSGISSinglePixel
+    {
+        size_t idx;
+        float dist[4];
+        unsigned char validNbrs;
+    };
+    
+    /**
+     * Merges single pixels into the neighbouring clump (which is not itself
+     * a single pixel) with the most similar spectral values, repeating until
+     * no more can be merged.
+     *
+     * The labels are held in memory. The single pixels are found in one pass
+     * and the spectral image is then streamed once to calculate the distances
+     * to their neighbours. After that, each iteration only revisits the single
+     * pixels next to a pixel which changed label, or stopped being single, in
+     * the previous one; all the decisions in an iteration use the labels from
+     * its start, as the full image passes did. Only the rows which changed are
+     * written back. The tmpData images are no longer used but are still
+     * checked to match the input size.
+     */
     class DllExport RSGISEliminateSinglePixels
     {
     public:
         RSGISEliminateSinglePixels();
         void eliminate(GDALDataset *inSpecData, GDALDataset *inClumpsData, GDALDataset *tmpData, std::string outputImage, float noDataVal, bool noDataValProvided, bool projFromImage, std::string proj, std::string format);
         void eliminateBlocks(GDALDataset *inSpecData, GDALDataset *inClumpsData, GDALDataset *tmpData, std::string outputImage, float noDataVal, bool noDataValProvided, bool projFromImage, std::string proj, std::string format);
+        /**
+         * As eliminateBlocks but updating clumpsData in place (e.g., an in memory dataset).
+         */
+        void eliminateBlocks(GDALDataset *inSpecData, GDALDataset *clumpsData, GDALDataset *tmpData, float noDataVal, bool noDataValProvided);
         ~RSGISEliminateSinglePixels();
     private:
-        unsigned long findSinglePixels(GDALDataset *inClumpsData, GDALDataset *tmpData, float noDataVal, bool noDataValProvided);
-        bool eliminateSinglePixels(GDALDataset *inSpecData, GDALDataset *inClumpsData, GDALDataset *tmpData, GDALDataset *outDataset, float noDataVal, bool noDataValProvided);
-        inline float eucDistance(float **vals1, float **vals2, unsigned int numBands, unsigned int col1, unsigned int col2);
+        bool isSinglePixel(const std::vector<unsigned int> &labels, unsigned int width, unsigned int height, size_t idx, float noDataVal, bool noDataValProvided);
+        void calcNeighbourDistances(GDALDataset *inSpecData, unsigned int width, unsigned int height, float noDataVal, bool noDataValProvided, std::vector<RSGISSinglePixel> *singles);
+        unsigned long eliminateSinglePixels(std::vector<unsigned int> *labels, std::vector<unsigned char> *singleFlags, const std::vector<RSGISSinglePixel> &singles, unsigned int width, unsigned int height, float noDataVal, bool noDataValProvided, std::vector<bool> *rowChanged);
+        inline float eucDistance(const float *vals1, const float *vals2, unsigned int numBands);
     };
     
     
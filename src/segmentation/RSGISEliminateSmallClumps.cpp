@@ -44,6 +44,28 @@ namespace rsgis{namespace segment{
         unsigned int height = spectral->GetRasterYSize();
         unsigned int numSpecBands = spectral->GetRasterCount();
         
+        // Use the in memory implementation if the clumps image fits.
+        unsigned int *clumpLabels = new(std::nothrow) unsigned int[((size_t)width)*height];
+        if(clumpLabels != NULL)
+        {
+            try
+            {
+                this->eliminateSmallClumpsInMemory(spectral, clumps, clumpLabels, minClumpSize, specThreshold);
+            }
+            catch(std::bad_alloc &e)
+            {
+                delete[] clumpLabels;
+                throw rsgis::img::RSGISImageCalcException("Not enough memory to eliminate the small clumps.");
+            }
+            catch(rsgis::img::RSGISImageCalcException &e)
+            {
+                delete[] clumpLabels;
+                throw e;
+            }
+            delete[] clumpLabels;
+            return;
+        }
+        
         unsigned int *clumpIdxs = new unsigned int[width];
         float **spectralVals = new float*[numSpecBands];
         GDALRasterBand **spectralBands = new GDALRasterBand*[numSpecBands];
@@ -53,6 +75,7 @@ namespace rsgis{namespace segment{
             spectralVals[n] = new float[width];
         }
         GDALRasterBand *clumpBand = clumps->GetRasterBand(1);
+        rsgis::img::RSGISRandomAccessRaster<unsigned int> clumpRaster(clumpBand);
         
         unsigned int uiPxlVal = 0;
         
@@ -139,7 +162,7 @@ namespace rsgis{namespace segment{
             cClump = smallClumps.front();
             smallClumps.pop_front();
             // Check that the clump was not selected for a merging already and therefore over minimum size...
-            if((cClump->active) & (cClump->pxls->size() < minClumpSize))
+            if((cClump->active) && (cClump->pxls->size() < minClumpSize))
             {
                 // Get std::list of neighbours.
                 neighbours.clear();
@@ -148,7 +171,7 @@ namespace rsgis{namespace segment{
                     // Above
                     if(((long)(*iterPxls).yPos)-1 >= 0)
                     {
-                        clumpBand->RasterIO(GF_Read, (*iterPxls).xPos, (*iterPxls).yPos-1, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
+                        uiPxlVal = clumpRaster.get((*iterPxls).xPos, (*iterPxls).yPos-1);
                         if((uiPxlVal != cClump->clumpID) & (uiPxlVal != 0))
                         {
                             neighbours.push_back(uiPxlVal);
@@ -157,7 +180,7 @@ namespace rsgis{namespace segment{
                     // Below
                     if(((long)(*iterPxls).yPos)+1 < height)
                     {
-                        clumpBand->RasterIO(GF_Read, (*iterPxls).xPos, (*iterPxls).yPos+1, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
+                        uiPxlVal = clumpRaster.get((*iterPxls).xPos, (*iterPxls).yPos+1);
                         if((uiPxlVal != cClump->clumpID) & (uiPxlVal != 0))
                         {
                             neighbours.push_back(uiPxlVal);
@@ -166,7 +189,7 @@ namespace rsgis{namespace segment{
                     // Left
                     if(((long)(*iterPxls).xPos-1) >= 0)
                     {
-                        clumpBand->RasterIO(GF_Read, (*iterPxls).xPos-1, (*iterPxls).yPos, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
+                        uiPxlVal = clumpRaster.get((*iterPxls).xPos-1, (*iterPxls).yPos);
                         if((uiPxlVal != cClump->clumpID) & (uiPxlVal != 0))
                         {
                             neighbours.push_back(uiPxlVal);
@@ -175,7 +198,7 @@ namespace rsgis{namespace segment{
                     // Right
                     if(((long)(*iterPxls).xPos+1) < width)
                     {
-                        clumpBand->RasterIO(GF_Read, (*iterPxls).xPos+1, (*iterPxls).yPos, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
+                        uiPxlVal = clumpRaster.get((*iterPxls).xPos+1, (*iterPxls).yPos);
                         if((uiPxlVal != cClump->clumpID) & (uiPxlVal != 0))
                         {
                             neighbours.push_back(uiPxlVal);
@@ -227,7 +250,7 @@ namespace rsgis{namespace segment{
                             tLoc = cClump->pxls->at(n);
                             tClump->pxls->push_back(tLoc);
                             // Update Pixel Values - in clump image.
-                            clumpBand->RasterIO(GF_Write, tLoc.xPos, tLoc.yPos, 1, 1, &closestNeighbour, 1, 1, GDT_UInt32, 0, 0);
+                            clumpRaster.set(tLoc.xPos, tLoc.yPos, closestNeighbour);
                         }
                         for(unsigned int b = 0; b < numSpecBands; ++b)
                         {
@@ -253,6 +276,7 @@ namespace rsgis{namespace segment{
             ++smallClumpsCounter;
         }
         std::cout << "Eliminated " << smallClumpsCounter << " small clumps\n";
+        clumpRaster.flush();
         
         
         
@@ -281,6 +305,420 @@ namespace rsgis{namespace segment{
         delete[] spectralVals;
     }
     
+    void RSGISEliminateSmallClumps::eliminateSmallClumpsInMemory(GDALDataset *spectral, GDALDataset *clumps, unsigned int *clumpLabels, unsigned int minClumpSize, float specThreshold)
+    {
+        unsigned int width = spectral->GetRasterXSize();
+        unsigned int height = spectral->GetRasterYSize();
+        unsigned int numSpecBands = spectral->GetRasterCount();
+        
+        GDALRasterBand **spectralBands = new GDALRasterBand*[numSpecBands];
+        for(unsigned int n = 0; n < numSpecBands; ++n)
+        {
+            spectralBands[n] = spectral->GetRasterBand(n+1);
+        }
+        GDALRasterBand *clumpBand = clumps->GetRasterBand(1);
+        
+        rsgis::rastergis::RSGISRasterAttUtils ratUtils;
+        long minVal = 0;
+        long maxVal = 0;
+        ratUtils.getImageBandMinMax(clumps, 1, &minVal, &maxVal);
+        size_t numClumps = (maxVal > 0)?maxVal:0;
+        
+        // Values for each clump, indexed by clump ID (0 is unused).
+        std::vector<float> sumVals((numClumps+1)*numSpecBands, 0);
+        std::vector<float> meanVals((numClumps+1)*numSpecBands, 0);
+        std::vector<size_t> clumpSizes(numClumps+1, 0);
+        
+        std::cout << "Calculate Initial Clump Means\n";
+        std::vector<float> spectralVals(((size_t)width)*numSpecBands);
+        for(unsigned int i = 0; i < height; ++i)
+        {
+            unsigned int *rowLabels = &clumpLabels[((size_t)i)*width];
+            clumpBand->RasterIO(GF_Read, 0, i, width, 1, rowLabels, width, 1, GDT_UInt32, 0, 0);
+            for(unsigned int n = 0; n < numSpecBands; ++n)
+            {
+                spectralBands[n]->RasterIO(GF_Read, 0, i, width, 1, &spectralVals[((size_t)n)*width], width, 1, GDT_Float32, 0, 0);
+            }
+            for(unsigned int j = 0; j < width; ++j)
+            {
+                if(rowLabels[j] != 0)
+                {
+                    if(rowLabels[j] > numClumps)
+                    {
+                        delete[] spectralBands;
+                        throw rsgis::img::RSGISImageCalcException("Clump ID is larger than the maximum of the clumps image.");
+                    }
+                    for(unsigned int n = 0; n < numSpecBands; ++n)
+                    {
+                        sumVals[(rowLabels[j]*numSpecBands)+n] += spectralVals[(((size_t)n)*width)+j];
+                    }
+                    ++clumpSizes[rowLabels[j]];
+                }
+            }
+        }
+        std::vector<float>().swap(spectralVals);
+        delete[] spectralBands;
+        
+        // Adjacency of the input clumps, merges are recorded in the graph so the
+        // neighbours of a merged clump are those of any of its input clumps.
+        rsgis::rastergis::RSGISRegionAdjacencyGraph rag;
+        rag.buildFromLabels(clumpLabels, width, height);
+        
+        std::vector<bool> active(numClumps+1, true);
+        std::deque<unsigned int> smallClumps;
+        for(size_t c = 1; c <= numClumps; ++c)
+        {
+            for(unsigned int n = 0; n < numSpecBands; ++n)
+            {
+                meanVals[(c*numSpecBands)+n] = sumVals[(c*numSpecBands)+n] / clumpSizes[c];
+            }
+            if(clumpSizes[c] < minClumpSize)
+            {
+                smallClumps.push_back(c);
+            }
+        }
+        
+        std::cout << "There are " << numClumps << " clumps. " << smallClumps.size() << " are too small\n";
+        
+        std::vector<size_t> neighbours;
+        unsigned int closestNeighbour = 0;
+        bool firstNeighbourTested = true;
+        float closestNeighbourDist = 0;
+        float distance = 0;
+        
+        std::cout << "Eliminating Small Clumps." << std::endl;
+        long smallClumpsCounter = 0;
+        while(smallClumps.size() > 0)
+        {
+            if((smallClumpsCounter % 10000) == 0)
+            {
+                std::cout << "Eliminated " << smallClumpsCounter << " > " << smallClumps.size() << " to go...\r";
+            }
+            
+            unsigned int cID = smallClumps.front();
+            smallClumps.pop_front();
+            // Check that the clump was not selected for a merging already and therefore over minimum size...
+            // Clumps outside of the graph have no pixels so cannot be merged.
+            if(active[cID] && (clumpSizes[cID] < minClumpSize) && (cID < rag.getNumNodes()))
+            {
+                rag.getMergedNeighbours(cID, &neighbours);
+                
+                // Decide on which neighbour to measure with.
+                firstNeighbourTested = true;
+                const float *cMeans = &meanVals[((size_t)cID)*numSpecBands];
+                for(std::vector<size_t>::iterator iterClumps = neighbours.begin(); iterClumps != neighbours.end(); ++iterClumps)
+                {
+                    const float *nMeans = &meanVals[(*iterClumps)*numSpecBands];
+                    distance = 0;
+                    for(unsigned int b = 0; b < numSpecBands; ++b)
+                    {
+                        distance += (cMeans[b] - nMeans[b])*(cMeans[b] - nMeans[b]);
+                    }
+                    distance = sqrt(distance);
+                    if(firstNeighbourTested)
+                    {
+                        closestNeighbour = *iterClumps;
+                        closestNeighbourDist = distance;
+                        firstNeighbourTested = false;
+                    }
+                    else if(distance < closestNeighbourDist)
+                    {
+                        closestNeighbour = *iterClumps;
+                        closestNeighbourDist = distance;
+                    }
+                }
+                
+                // Perform Merge
+                if((!firstNeighbourTested) && (closestNeighbourDist < specThreshold))
+                {
+                    unsigned int tID = closestNeighbour;
+                    rag.mergeNodes(cID, tID);
+                    clumpSizes[tID] += clumpSizes[cID];
+                    for(unsigned int b = 0; b < numSpecBands; ++b)
+                    {
+                        sumVals[(((size_t)tID)*numSpecBands)+b] += sumVals[(((size_t)cID)*numSpecBands)+b];
+                        meanVals[(((size_t)tID)*numSpecBands)+b] = sumVals[(((size_t)tID)*numSpecBands)+b]/clumpSizes[tID];
+                    }
+                    active[cID] = false;
+                    
+                    // Is the new clump still to small?
+                    if(clumpSizes[tID] < minClumpSize)
+                    {
+                        smallClumps.push_back(tID);
+                    }
+                }
+            }
+            
+            ++smallClumpsCounter;
+        }
+        std::cout << "Eliminated " << smallClumpsCounter << " small clumps\n";
+        
+        // Write the merged clump IDs back to the clumps image.
+        for(unsigned int i = 0; i < height; ++i)
+        {
+            unsigned int *rowLabels = &clumpLabels[((size_t)i)*width];
+            for(unsigned int j = 0; j < width; ++j)
+            {
+                if(rowLabels[j] != 0)
+                {
+                    rowLabels[j] = rag.findMergedNode(rowLabels[j]);
+                }
+            }
+            clumpBand->RasterIO(GF_Write, 0, i, width, 1, rowLabels, width, 1, GDT_UInt32, 0, 0);
+        }
+    }
+    
+    void RSGISEliminateSmallClumps::priorityEliminateSmallClumps(GDALDataset *spectral, GDALDataset *clumps, unsigned int minClumpSize, float specThreshold, std::vector<rsgis::img::BandSpecThresholdStats> *bandStretchStats, bool bandStatsAvail)
+    {
+        if(spectral->GetRasterXSize() != clumps->GetRasterXSize())
+        {
+            throw rsgis::img::RSGISImageCalcException("Widths are not the same");
+        }
+        if(spectral->GetRasterYSize() != clumps->GetRasterYSize())
+        {
+            throw rsgis::img::RSGISImageCalcException("Heights are not the same");
+        }
+        
+        unsigned int width = spectral->GetRasterXSize();
+        unsigned int height = spectral->GetRasterYSize();
+        unsigned int numSpecBands = spectral->GetRasterCount();
+        
+        std::vector<double> stretch2reflOffs;
+        std::vector<double> stretch2reflGains;
+        if(bandStatsAvail && (numSpecBands != bandStretchStats->size()))
+        {
+            throw rsgis::img::RSGISImageCalcException("The number of image bands and the number band statistics are not the same.");
+        }
+        else if(bandStatsAvail)
+        {
+            for(unsigned int i = 0; i < numSpecBands; ++i)
+            {
+                stretch2reflOffs.push_back(bandStretchStats->at(i).origMin);
+                stretch2reflGains.push_back((bandStretchStats->at(i).origMax - bandStretchStats->at(i).origMin) / (bandStretchStats->at(i).imgMax - bandStretchStats->at(i).imgMin));
+            }
+        }
+        
+        GDALRasterBand *clumpBand = clumps->GetRasterBand(1);
+        std::vector<GDALRasterBand*> spectralBands;
+        for(unsigned int n = 0; n < numSpecBands; ++n)
+        {
+            spectralBands.push_back(spectral->GetRasterBand(n+1));
+        }
+        
+        std::cout << "Calc Number of clumps\n";
+        rsgis::rastergis::RSGISRasterAttUtils ratUtils;
+        long minVal = 0;
+        long maxVal = 0;
+        ratUtils.getImageBandMinMax(clumps, 1, &minVal, &maxVal);
+        size_t numClumps = (maxVal > 0)?maxVal:0;
+        std::cout << "There are " << numClumps << " initial clumps." << std::endl;
+        
+        // Single pass over the images for the clump sums, sizes and region adjacency graph.
+        std::cout << "Calculate Initial Clump Means and Neighbours\n";
+        std::vector<double> sumVals((numClumps+1)*numSpecBands, 0);
+        std::vector<size_t> clumpSizes(numClumps+1, 0);
+        std::vector<std::vector<unsigned int> > neighbours(numClumps+1);
+        std::vector<unsigned int> clumpIdxs(width);
+        std::vector<unsigned int> prevClumpIdxs(width, 0);
+        std::vector<float> spectralVals(((size_t)width)*numSpecBands);
+        rsgis_tqdm pbar;
+        for(unsigned int i = 0; i < height; ++i)
+        {
+            pbar.progress(i, height*2);
+            clumpBand->RasterIO(GF_Read, 0, i, width, 1, clumpIdxs.data(), width, 1, GDT_UInt32, 0, 0);
+            for(unsigned int n = 0; n < numSpecBands; ++n)
+            {
+                spectralBands[n]->RasterIO(GF_Read, 0, i, width, 1, &spectralVals[((size_t)n)*width], width, 1, GDT_Float32, 0, 0);
+            }
+            for(unsigned int j = 0; j < width; ++j)
+            {
+                unsigned int a = clumpIdxs[j];
+                if(a == 0)
+                {
+                    continue;
+                }
+                if(a > numClumps)
+                {
+                    throw rsgis::img::RSGISImageCalcException("Clump ID is larger than the maximum of the clumps image.");
+                }
+                ++clumpSizes[a];
+                for(unsigned int n = 0; n < numSpecBands; ++n)
+                {
+                    sumVals[(((size_t)a)*numSpecBands)+n] += spectralVals[(((size_t)n)*width)+j];
+                }
+                // Left and above; duplicates are removed once the graph is complete.
+                unsigned int nbrs[2] = {(j > 0)?clumpIdxs[j-1]:0, prevClumpIdxs[j]};
+                for(unsigned int k = 0; k < 2; ++k)
+                {
+                    unsigned int b = nbrs[k];
+                    if((b != 0) && (b != a) && (neighbours[a].empty() || (neighbours[a].back() != b)))
+                    {
+                        neighbours[a].push_back(b);
+                        neighbours[b].push_back(a);
+                    }
+                }
+            }
+            clumpIdxs.swap(prevClumpIdxs);
+        }
+        for(size_t c = 1; c <= numClumps; ++c)
+        {
+            std::sort(neighbours[c].begin(), neighbours[c].end());
+            neighbours[c].erase(std::unique(neighbours[c].begin(), neighbours[c].end()), neighbours[c].end());
+        }
+        
+        // Min-heap of the small clumps on size; entries are ignored when popped if the
+        // clump has since been merged or grown. Clumps which could not be merged are
+        // marked as blocked and only queued again if one of their neighbours changes.
+        std::vector<unsigned int> mergedInto(numClumps+1);
+        std::vector<bool> blocked(numClumps+1, false);
+        std::priority_queue<std::pair<size_t, unsigned int>, std::vector<std::pair<size_t, unsigned int> >, std::greater<std::pair<size_t, unsigned int> > > smallClumps;
+        for(size_t c = 0; c <= numClumps; ++c)
+        {
+            mergedInto[c] = c;
+            if((clumpSizes[c] > 0) && (clumpSizes[c] < minClumpSize))
+            {
+                smallClumps.push(std::pair<size_t, unsigned int>(clumpSizes[c], c));
+            }
+        }
+        std::cout << "There are " << smallClumps.size() << " small clumps to be eliminated." << std::endl;
+        
+        std::cout << "Eliminating Small Clumps." << std::endl;
+        unsigned long numMerged = 0;
+        while(!smallClumps.empty())
+        {
+            size_t cSize = smallClumps.top().first;
+            unsigned int cID = smallClumps.top().second;
+            smallClumps.pop();
+            if((mergedInto[cID] != cID) || (clumpSizes[cID] != cSize))
+            {
+                continue;
+            }
+            
+            // Closest neighbour, by the mean values, which is larger than this clump.
+            unsigned int closestNeighbour = 0;
+            double closestNeighbourDist = 0;
+            for(std::vector<unsigned int>::iterator iterNbr = neighbours[cID].begin(); iterNbr != neighbours[cID].end(); ++iterNbr)
+            {
+                if(clumpSizes[*iterNbr] > cSize)
+                {
+                    double distance = this->clumpMeanDist(sumVals, clumpSizes, numSpecBands, cID, *iterNbr, NULL, NULL);
+                    if((closestNeighbour == 0) || (distance < closestNeighbourDist))
+                    {
+                        closestNeighbour = *iterNbr;
+                        closestNeighbourDist = distance;
+                    }
+                }
+            }
+            if((closestNeighbour != 0) && bandStatsAvail)
+            {
+                closestNeighbourDist = this->clumpMeanDist(sumVals, clumpSizes, numSpecBands, cID, closestNeighbour, stretch2reflOffs.data(), stretch2reflGains.data());
+            }
+            if((closestNeighbour == 0) || (closestNeighbourDist >= specThreshold))
+            {
+                blocked[cID] = true;
+                continue;
+            }
+            
+            // Merge cID into tID, updating the graph locally.
+            unsigned int tID = closestNeighbour;
+            mergedInto[cID] = tID;
+            clumpSizes[tID] += clumpSizes[cID];
+            for(unsigned int n = 0; n < numSpecBands; ++n)
+            {
+                sumVals[(((size_t)tID)*numSpecBands)+n] += sumVals[(((size_t)cID)*numSpecBands)+n];
+            }
+            std::vector<unsigned int> mergedNbrs;
+            mergedNbrs.reserve(neighbours[tID].size() + neighbours[cID].size());
+            std::set_union(neighbours[tID].begin(), neighbours[tID].end(), neighbours[cID].begin(), neighbours[cID].end(), std::back_inserter(mergedNbrs));
+            mergedNbrs.erase(std::remove_if(mergedNbrs.begin(), mergedNbrs.end(), [cID, tID](unsigned int nID){return (nID == cID) || (nID == tID);}), mergedNbrs.end());
+            for(std::vector<unsigned int>::iterator iterNbr = neighbours[cID].begin(); iterNbr != neighbours[cID].end(); ++iterNbr)
+            {
+                if(*iterNbr == tID)
+                {
+                    continue;
+                }
+                std::vector<unsigned int> &nbrNbrs = neighbours[*iterNbr];
+                nbrNbrs.erase(std::lower_bound(nbrNbrs.begin(), nbrNbrs.end(), cID));
+                std::vector<unsigned int>::iterator iterPos = std::lower_bound(nbrNbrs.begin(), nbrNbrs.end(), tID);
+                if((iterPos == nbrNbrs.end()) || (*iterPos != tID))
+                {
+                    nbrNbrs.insert(iterPos, tID);
+                }
+            }
+            neighbours[tID].swap(mergedNbrs);
+            std::vector<unsigned int>().swap(neighbours[cID]);
+            ++numMerged;
+            
+            if(clumpSizes[tID] < minClumpSize)
+            {
+                blocked[tID] = false;
+                smallClumps.push(std::pair<size_t, unsigned int>(clumpSizes[tID], tID));
+            }
+            for(std::vector<unsigned int>::iterator iterNbr = neighbours[tID].begin(); iterNbr != neighbours[tID].end(); ++iterNbr)
+            {
+                if(blocked[*iterNbr])
+                {
+                    blocked[*iterNbr] = false;
+                    smallClumps.push(std::pair<size_t, unsigned int>(clumpSizes[*iterNbr], *iterNbr));
+                }
+            }
+        }
+        
+        unsigned long numBlocked = 0;
+        for(size_t c = 1; c <= numClumps; ++c)
+        {
+            if((mergedInto[c] == c) && (clumpSizes[c] > 0) && (clumpSizes[c] < minClumpSize))
+            {
+                ++numBlocked;
+            }
+        }
+        std::cout << "Eliminated " << numMerged << " small clumps, " << numBlocked << " could not be merged.\n";
+        
+        // Final relabel of the clumps image.
+        for(unsigned int i = 0; i < height; ++i)
+        {
+            pbar.progress(height+i, height*2);
+            clumpBand->RasterIO(GF_Read, 0, i, width, 1, clumpIdxs.data(), width, 1, GDT_UInt32, 0, 0);
+            for(unsigned int j = 0; j < width; ++j)
+            {
+                if(clumpIdxs[j] != 0)
+                {
+                    clumpIdxs[j] = this->findMergedClump(&mergedInto, clumpIdxs[j]);
+                }
+            }
+            clumpBand->RasterIO(GF_Write, 0, i, width, 1, clumpIdxs.data(), width, 1, GDT_UInt32, 0, 0);
+        }
+        pbar.finish();
+    }
+    
+    double RSGISEliminateSmallClumps::clumpMeanDist(const std::vector<double> &sumVals, const std::vector<size_t> &clumpSizes, unsigned int numSpecBands, unsigned int clumpID1, unsigned int clumpID2, const double *offs, const double *gains)
+    {
+        double distance = 0;
+        for(unsigned int b = 0; b < numSpecBands; ++b)
+        {
+            double mean1 = sumVals[(((size_t)clumpID1)*numSpecBands)+b] / clumpSizes[clumpID1];
+            double mean2 = sumVals[(((size_t)clumpID2)*numSpecBands)+b] / clumpSizes[clumpID2];
+            if(offs != NULL)
+            {
+                mean1 = offs[b] + (mean1 * gains[b]);
+                mean2 = offs[b] + (mean2 * gains[b]);
+            }
+            distance += (mean1 - mean2) * (mean1 - mean2);
+        }
+        return sqrt(distance);
+    }
+    
+    unsigned int RSGISEliminateSmallClumps::findMergedClump(std::vector<unsigned int> *mergedInto, unsigned int clumpID)
+    {
+        // Path halving
+        while((*mergedInto)[clumpID] != clumpID)
+        {
+            (*mergedInto)[clumpID] = (*mergedInto)[(*mergedInto)[clumpID]];
+            clumpID = (*mergedInto)[clumpID];
+        }
+        return clumpID;
+    }
+    
     void RSGISEliminateSmallClumps::stepwiseEliminateSmallClumps(GDALDataset *spectral, GDALDataset *clumps, unsigned int minClumpSize, float specThreshold, std::vector<rsgis::img::BandSpecThresholdStats> *bandStretchStats, bool bandStatsAvail) 
     {
         if(spectral->GetRasterXSize() != clumps->GetRasterXSize())
@@ -314,6 +752,7 @@ namespace rsgis{namespace segment{
         }
         
         GDALRasterBand *clumpBand = clumps->GetRasterBand(1);
+        rsgis::img::RSGISRandomAccessRaster<unsigned int> clumpRaster(clumpBand);
         
         unsigned int uiPxlVal = 0;
         
@@ -408,7 +847,7 @@ namespace rsgis{namespace segment{
                         // Above
                         if(((long)(*iterPxls).yPos)-1 >= 0)
                         {
-                            clumpBand->RasterIO(GF_Read, (*iterPxls).xPos, (*iterPxls).yPos-1, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
+                            uiPxlVal = clumpRaster.get((*iterPxls).xPos, (*iterPxls).yPos-1);
                             if((uiPxlVal != cClump->clumpID) & (uiPxlVal != 0))
                             {
                                 neighbours.push_back(uiPxlVal);
@@ -417,7 +856,7 @@ namespace rsgis{namespace segment{
                         // Below
                         if(((long)(*iterPxls).yPos)+1 < height)
                         {
-                            clumpBand->RasterIO(GF_Read, (*iterPxls).xPos, (*iterPxls).yPos+1, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
+                            uiPxlVal = clumpRaster.get((*iterPxls).xPos, (*iterPxls).yPos+1);
                             if((uiPxlVal != cClump->clumpID) & (uiPxlVal != 0))
                             {
                                 neighbours.push_back(uiPxlVal);
@@ -426,7 +865,7 @@ namespace rsgis{namespace segment{
                         // Left
                         if(((long)(*iterPxls).xPos-1) >= 0)
                         {
-                            clumpBand->RasterIO(GF_Read, (*iterPxls).xPos-1, (*iterPxls).yPos, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
+                            uiPxlVal = clumpRaster.get((*iterPxls).xPos-1, (*iterPxls).yPos);
                             if((uiPxlVal != cClump->clumpID) & (uiPxlVal != 0))
                             {
                                 neighbours.push_back(uiPxlVal);
@@ -435,7 +874,7 @@ namespace rsgis{namespace segment{
                         // Right
                         if(((long)(*iterPxls).xPos+1) < width)
                         {
-                            clumpBand->RasterIO(GF_Read, (*iterPxls).xPos+1, (*iterPxls).yPos, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
+                            uiPxlVal = clumpRaster.get((*iterPxls).xPos+1, (*iterPxls).yPos);
                             if((uiPxlVal != cClump->clumpID) & (uiPxlVal != 0))
                             {
                                 neighbours.push_back(uiPxlVal);
@@ -521,7 +960,7 @@ namespace rsgis{namespace segment{
                     pair2Merge.second->pxls->push_back(tLoc);
                      
                     // Update Pixel Values - in clump image.
-                    clumpBand->RasterIO(GF_Write, tLoc.xPos, tLoc.yPos, 1, 1, &closestNeighbour, 1, 1, GDT_UInt32, 0, 0);
+                    clumpRaster.set(tLoc.xPos, tLoc.yPos, closestNeighbour);
                 }
                 
                 for(unsigned int b = 0; b < numSpecBands; ++b)
@@ -539,6 +978,7 @@ namespace rsgis{namespace segment{
             smallClumps.clear();
             smallClumpsCounter = 0;
         }        
+        clumpRaster.flush();
         
         
         for(std::vector<rsgis::img::ImgClump*>::iterator iterClumps = clumpTable->begin(); iterClumps != clumpTable->end(); ++iterClumps)
@@ -596,6 +1036,7 @@ namespace rsgis{namespace segment{
         }
 
         GDALRasterBand *clumpBand = clumps->GetRasterBand(1);
+        rsgis::img::RSGISRandomAccessRaster<unsigned int> clumpRaster(clumpBand);
         
         unsigned int uiPxlVal = 0;
         
@@ -698,7 +1139,7 @@ namespace rsgis{namespace segment{
                             // Above
                             if(((long)(*iterPxls).yPos)-1 >= 0)
                             {
-                                clumpBand->RasterIO(GF_Read, (*iterPxls).xPos, (*iterPxls).yPos-1, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
+                                uiPxlVal = clumpRaster.get((*iterPxls).xPos, (*iterPxls).yPos-1);
                                 if((uiPxlVal != cClump->clumpID) & (uiPxlVal != 0))
                                 {
                                     neighbours.push_back(uiPxlVal);
@@ -707,7 +1148,7 @@ namespace rsgis{namespace segment{
                             // Below
                             if(((long)(*iterPxls).yPos)+1 < height)
                             {
-                                clumpBand->RasterIO(GF_Read, (*iterPxls).xPos, (*iterPxls).yPos+1, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
+                                uiPxlVal = clumpRaster.get((*iterPxls).xPos, (*iterPxls).yPos+1);
                                 if((uiPxlVal != cClump->clumpID) & (uiPxlVal != 0))
                                 {
                                     neighbours.push_back(uiPxlVal);
@@ -716,7 +1157,7 @@ namespace rsgis{namespace segment{
                             // Left
                             if(((long)(*iterPxls).xPos-1) >= 0)
                             {
-                                clumpBand->RasterIO(GF_Read, (*iterPxls).xPos-1, (*iterPxls).yPos, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
+                                uiPxlVal = clumpRaster.get((*iterPxls).xPos-1, (*iterPxls).yPos);
                                 if((uiPxlVal != cClump->clumpID) & (uiPxlVal != 0))
                                 {
                                     neighbours.push_back(uiPxlVal);
@@ -725,7 +1166,7 @@ namespace rsgis{namespace segment{
                             // Right
                             if(((long)(*iterPxls).xPos+1) < width)
                             {
-                                clumpBand->RasterIO(GF_Read, (*iterPxls).xPos+1, (*iterPxls).yPos, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
+                                uiPxlVal = clumpRaster.get((*iterPxls).xPos+1, (*iterPxls).yPos);
                                 if((uiPxlVal != cClump->clumpID) & (uiPxlVal != 0))
                                 {
                                     neighbours.push_back(uiPxlVal);
@@ -812,7 +1253,7 @@ namespace rsgis{namespace segment{
                         pair2Merge.second->pxls->push_back(tLoc);
                         
                         // Update Pixel Values - in clump image.
-                        clumpBand->RasterIO(GF_Write, tLoc.xPos, tLoc.yPos, 1, 1, &closestNeighbour, 1, 1, GDT_UInt32, 0, 0);
+                        clumpRaster.set(tLoc.xPos, tLoc.yPos, closestNeighbour);
                     }
                     
                     for(unsigned int b = 0; b < numSpecBands; ++b)
@@ -855,6 +1296,7 @@ namespace rsgis{namespace segment{
             
             std::cout << std::endl;
         }
+        clumpRaster.flush();
         
         
         for(std::vector<rsgis::img::ImgClump*>::iterator iterClumps = clumpTable->begin(); iterClumps != clumpTable->end(); ++iterClumps)
@@ -903,6 +1345,7 @@ namespace rsgis{namespace segment{
             spectralVals[n] = new float[width];
         }
         GDALRasterBand *clumpBand = clumps->GetRasterBand(1);
+        rsgis::img::RSGISRandomAccessRaster<unsigned int> clumpRaster(clumpBand);
         
         unsigned int uiPxlVal = 0;
         
@@ -999,7 +1442,7 @@ namespace rsgis{namespace segment{
                         // Above
                         if(((long)(*iterPxls).yPos)-1 >= 0)
                         {
-                            clumpBand->RasterIO(GF_Read, (*iterPxls).xPos, (*iterPxls).yPos-1, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
+                            uiPxlVal = clumpRaster.get((*iterPxls).xPos, (*iterPxls).yPos-1);
                             if((uiPxlVal != clumpTable[cClumpIdx]->clumpID) & (uiPxlVal != 0))
                             {
                                 neighbours.push_back(uiPxlVal);
@@ -1008,7 +1451,7 @@ namespace rsgis{namespace segment{
                         // Below
                         if(((long)(*iterPxls).yPos)+1 < height)
                         {
-                            clumpBand->RasterIO(GF_Read, (*iterPxls).xPos, (*iterPxls).yPos+1, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
+                            uiPxlVal = clumpRaster.get((*iterPxls).xPos, (*iterPxls).yPos+1);
                             if((uiPxlVal != clumpTable[cClumpIdx]->clumpID) & (uiPxlVal != 0))
                             {
                                 neighbours.push_back(uiPxlVal);
@@ -1017,7 +1460,7 @@ namespace rsgis{namespace segment{
                         // Left
                         if(((long)(*iterPxls).xPos-1) >= 0)
                         {
-                            clumpBand->RasterIO(GF_Read, (*iterPxls).xPos-1, (*iterPxls).yPos, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
+                            uiPxlVal = clumpRaster.get((*iterPxls).xPos-1, (*iterPxls).yPos);
                             if((uiPxlVal != clumpTable[cClumpIdx]->clumpID) & (uiPxlVal != 0))
                             {
                                 neighbours.push_back(uiPxlVal);
@@ -1026,7 +1469,7 @@ namespace rsgis{namespace segment{
                         // Right
                         if(((long)(*iterPxls).xPos+1) < width)
                         {
-                            clumpBand->RasterIO(GF_Read, (*iterPxls).xPos+1, (*iterPxls).yPos, 1, 1, &uiPxlVal, 1, 1, GDT_UInt32, 0, 0);
+                            uiPxlVal = clumpRaster.get((*iterPxls).xPos+1, (*iterPxls).yPos);
                             if((uiPxlVal != clumpTable[cClumpIdx]->clumpID) & (uiPxlVal != 0))
                             {
                                 neighbours.push_back(uiPxlVal);
@@ -1099,7 +1542,7 @@ namespace rsgis{namespace segment{
                     clumpTable[pair2Merge.second]->pxls->push_back(tLoc);
                     
                     // Update Pixel Values - in clump image.
-                    clumpBand->RasterIO(GF_Write, tLoc.xPos, tLoc.yPos, 1, 1, &closestNeighbour, 1, 1, GDT_UInt32, 0, 0);
+                    clumpRaster.set(tLoc.xPos, tLoc.yPos, closestNeighbour);
                 }
                 for(unsigned int b = 0; b < numSpecBands; ++b)
                 {
@@ -1114,6 +1557,7 @@ namespace rsgis{namespace segment{
             }
             std::cout << "Eliminated " << smallClumpsCounter << " small clumps\n";
         }
+        clumpRaster.flush();
         std::cout << "Finshed Elimination. " << smallClumpsCounter << " small clumps eliminated\n";
         
         
@@ -1201,6 +1645,34 @@ namespace rsgis{namespace segment{
         }
     }
 
+    void RSGISPopulateMeansPxlLocs::calcImageRowExtent(const float* const* bandRows, int numBands, size_t nPxls, double originX, double originY, double xStep, double pxlWidth, double pxlHeight)
+    {
+        try
+        {
+            unsigned int yPos = static_cast<unsigned int>(originY);
+            for(size_t i = 0; i < nPxls; ++i)
+            {
+                if(bandRows[0][i] > 0)
+                {
+                    size_t fid = static_cast<size_t>(bandRows[0][i]);
+                    
+                    rsgis::img::ImgClump *cClump = clumpTable->at(fid - 1);
+                    for(unsigned int n = 0; n < numSpecBands; ++n)
+                    {
+                        cClump->sumVals[n] += bandRows[n+1][i];
+                    }
+                    
+                    unsigned int xPos = static_cast<unsigned int>(originX + (i * xStep));
+                    cClump->pxls->push_back(rsgis::img::PxlLoc(xPos, yPos));
+                }
+            }
+        }
+        catch(std::out_of_range &e)
+        {
+            throw rsgis::img::RSGISImageCalcException("Clump ID is not within the clump table.");
+        }
+    }
+
     RSGISPopulateMeansPxlLocs::~RSGISPopulateMeansPxlLocs()
     {
         
@@ -29,22 +29,30 @@
 #include <queue>
 #include <deque>
 #include <list>
+#include <new>
+#include <stdexcept>
+#include <functional>
+#include <iterator>
+#include <algorithm>
 #include <math.h>
 
 #include "gdal_priv.h"
 
 #include "common/RSGISAttributeTableException.h"
 #include "common/RSGISFileException.h"
+#include "common/rsgis-tqdm.h"
 
 #include "utils/RSGISTextUtils.h"
 
 #include "img/RSGISImageUtils.h"
 #include "img/RSGISImageCalcException.h"
+#include "img/RSGISRandomAccessRaster.h"
 #include "img/RSGISCalcImageValue.h"
 #include "img/RSGISCalcImage.h"
 #include "img/RSGISStretchImage.h"
 
 #include "rastergis/RSGISRasterAttUtils.h"
+#include "rastergis/RSGISRegionAdjacencyGraph.h"
 
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
@@ -68,8 +76,27 @@ namespace rsgis{namespace segment{
         void eliminateSmallClumps(GDALDataset *spectral, GDALDataset *clumps, unsigned int minClumpSize, float specThreshold);
         void stepwiseEliminateSmallClumps(GDALDataset *spectral, GDALDataset *clumps, unsigned int minClumpSize, float specThreshold, std::vector<rsgis::img::BandSpecThresholdStats> *bandStretchStats, bool bandStatsAvail);
         void stepwiseIterativeEliminateSmallClumps(GDALDataset *spectral, GDALDataset *clumps, unsigned int minClumpSize, float specThreshold, std::vector<rsgis::img::BandSpecThresholdStats> *bandStretchStats, bool bandStatsAvail);
+        /**
+         * Event driven version of stepwiseIterativeEliminateSmallClumps. The small clumps are
+         * held in a min-heap on their size and the smallest is merged with its spectrally
+         * closest neighbour (which is larger than it), with the region adjacency graph
+         * and the mean values updated after each merge, until no clumps below minClumpSize
+         * can be merged. The images are read once at the start and the clumps image written
+         * once at the end.
+         */
+        void priorityEliminateSmallClumps(GDALDataset *spectral, GDALDataset *clumps, unsigned int minClumpSize, float specThreshold, std::vector<rsgis::img::BandSpecThresholdStats> *bandStretchStats, bool bandStatsAvail);
         void stepwiseEliminateSmallClumpsNoMean(GDALDataset *spectral, GDALDataset *clumps, unsigned int minClumpSize, float specThreshold, std::vector<rsgis::img::BandSpecThresholdStats> *bandStretchStats, bool bandStatsAvail);
         ~RSGISEliminateSmallClumps();
+    protected:
+        /**
+         * eliminateSmallClumps with the clumps image held in clumpLabels (width x height).
+         * The neighbours of each clump are found from an adjacency table of the input
+         * clumps built in a linear scan of the labels, rather than reading the pixels
+         * around each clump from the image, and the image is written once at the end.
+         */
+        void eliminateSmallClumpsInMemory(GDALDataset *spectral, GDALDataset *clumps, unsigned int *clumpLabels, unsigned int minClumpSize, float specThreshold);
+        unsigned int findMergedClump(std::vector<unsigned int> *mergedInto, unsigned int clumpID);
+        double clumpMeanDist(const std::vector<double> &sumVals, const std::vector<size_t> &clumpSizes, unsigned int numSpecBands, unsigned int clumpID1, unsigned int clumpID2, const double *offs, const double *gains);
     };
     
     class DllExport RSGISPopulateMeansPxlLocs : public rsgis::img::RSGISCalcImageValue
@@ -86,6 +113,11 @@ namespace rsgis{namespace segment{
         void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented.");};
         void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output, geos::geom::Envelope extent) {throw rsgis::img::RSGISImageCalcException("Not implemented.");};
         bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented.");};
+        /**
+         * With calcImagePosPxl the pixel position along the row is originX + (i * xStep)
+         * and the row originY, so no envelope is needed for each pixel.
+         */
+        void calcImageRowExtent(const float* const* bandRows, int numBands, size_t nPxls, double originX, double originY, double xStep, double pxlWidth, double pxlHeight);
         ~RSGISPopulateMeansPxlLocs();
     protected:
         std::vector<rsgis::img::ImgClump*> *clumpTable;
@@ -27,7 +27,7 @@ namespace rsgis{namespace segment{
     
     RSGISGenMeanSegImage::RSGISGenMeanSegImage()
     {
-        
+        this->numThreads = rsgis::utils::getNumThreads();
     }
     
     void RSGISGenMeanSegImage::generateMeanImage(GDALDataset *spectral, GDALDataset *clumps, GDALDataset *meanImg) 
@@ -247,6 +247,33 @@ namespace rsgis{namespace segment{
     }
     
     void RSGISGenMeanSegImage::generateMeanImageUsingClumpTable(GDALDataset *spectral, GDALDataset *clumps, GDALDataset *meanImg) 
+    {
+        // The clump table is now the flat array of means from calcClumpMeans.
+        this->generateMeanImageSinglePass(spectral, clumps, meanImg);
+    }
+    
+    void RSGISGenMeanSegImage::generateMeanImageUsingCalcImage(GDALDataset *spectral, GDALDataset *clumps, GDALDataset *meanImg) 
+    {
+        try
+        {
+            this->generateMeanImageSinglePass(spectral, clumps, meanImg);
+        }
+        catch(rsgis::img::RSGISImageCalcException &e)
+        {
+            throw e;
+        }
+        catch (rsgis::RSGISException &e)
+        {
+            throw rsgis::img::RSGISImageCalcException(e.what());
+        }
+        catch (std::exception &e)
+        {
+            throw rsgis::img::RSGISImageCalcException(e.what());
+        }
+    }
+    
+    
+    void RSGISGenMeanSegImage::generateMeanImageSinglePass(GDALDataset *spectral, GDALDataset *clumps, GDALDataset *meanImg, double maxMemMB)
     {
         if((spectral->GetRasterXSize() != clumps->GetRasterXSize()) |
            (spectral->GetRasterXSize() != meanImg->GetRasterXSize()))
@@ -258,238 +285,237 @@ namespace rsgis{namespace segment{
         {
             throw rsgis::img::RSGISImageCalcException("Heights are not the same");
         }
-        
         if(spectral->GetRasterCount() != meanImg->GetRasterCount())
         {
             throw rsgis::img::RSGISImageCalcException("The number of bands is not the same");
         }
         
-        rsgis::img::RSGISImageUtils imgUtils;
-        imgUtils.zerosFloatGDALDataset(meanImg);
-        
         unsigned int width = spectral->GetRasterXSize();
         unsigned int height = spectral->GetRasterYSize();
         unsigned int numSpecBands = spectral->GetRasterCount();
         
-        unsigned int *clumpIdxs = new unsigned int[width];
-        float **spectralVals = new float*[numSpecBands];
+        double labelsMB = (((double)width) * height * sizeof(unsigned int)) / (1024.0 * 1024.0);
+        bool keepLabels = (labelsMB <= maxMemMB);
+        std::vector<unsigned int> clumpLabels;
+        std::vector<double> means;
+        unsigned long numClumps = 0;
+        std::cout << "Calculating clump means\n";
+        this->calcClumpMeans(spectral, clumps, &means, &numClumps, keepLabels?(&clumpLabels):NULL);
         
-        GDALRasterBand **spectralBands = new GDALRasterBand*[numSpecBands];
-        GDALRasterBand **meanBands = new GDALRasterBand*[numSpecBands];
-        for(unsigned int n = 0; n < numSpecBands; ++n)
-        {
-            spectralBands[n] = spectral->GetRasterBand(n+1);
-            meanBands[n] = meanImg->GetRasterBand(n+1);
-            spectralVals[n] = new float[width]; 
-        }
+        std::cout << "Writing mean image\n";
         GDALRasterBand *clumpBand = clumps->GetRasterBand(1);
-
-        unsigned long maxClumpIdx = 0;
-        for(unsigned int i = 0; i < height; ++i)
-        {
-            clumpBand->RasterIO(GF_Read, 0, i, width, 1, clumpIdxs, width, 1, GDT_UInt32, 0, 0);
-            for(unsigned int j = 0; j < width; ++j)
+        int blockXSize = 0;
+        int blockYSize = 0;
+        clumpBand->GetBlockSize(&blockXSize, &blockYSize);
+        unsigned int stripRows = (blockYSize > 0)?blockYSize:1;
+        std::vector<unsigned int> stripLabels;
+        std::vector<float> outVals(((size_t)width) * stripRows);
+        size_t meansStride = numClumps + 1;
+        for(unsigned int yStart = 0; yStart < height; yStart += stripRows)
+        {
+            unsigned int numRows = std::min(stripRows, height - yStart);
+            size_t numPxls = ((size_t)width) * numRows;
+            const unsigned int *labels = NULL;
+            if(keepLabels)
             {
-                if((i == 0) & (j == 0))
+                labels = &clumpLabels[((size_t)width) * yStart];
+            }
+            else
+            {
+                stripLabels.resize(numPxls);
+                if(clumpBand->RasterIO(GF_Read, 0, yStart, width, numRows, &stripLabels[0], width, numRows, GDT_UInt32, 0, 0) != CE_None)
                 {
-                    maxClumpIdx = clumpIdxs[j];
+                    throw rsgis::img::RSGISImageCalcException("Could not read the clumps image.");
                 }
-                else if(clumpIdxs[j] > maxClumpIdx)
+                labels = &stripLabels[0];
+            }
+            for(unsigned int n = 0; n < numSpecBands; ++n)
+            {
+                const double *bandMeans = &means[n * meansStride];
+                for(size_t p = 0; p < numPxls; ++p)
+                {
+                    outVals[p] = bandMeans[labels[p]];
+                }
+                if(meanImg->GetRasterBand(n+1)->RasterIO(GF_Write, 0, yStart, width, numRows, &outVals[0], width, numRows, GDT_Float32, 0, 0) != CE_None)
                 {
-                    maxClumpIdx = clumpIdxs[j];
+                    throw rsgis::img::RSGISImageCalcException("Could not write to the mean image.");
                 }
             }
         }
+    }
+    
+    void RSGISGenMeanSegImage::populateRATWithMeans(GDALDataset *spectral, GDALDataset *clumps, std::vector<std::string> colNames)
+    {
+        if((spectral->GetRasterXSize() != clumps->GetRasterXSize()) | (spectral->GetRasterYSize() != clumps->GetRasterYSize()))
+        {
+            throw rsgis::img::RSGISImageCalcException("The spectral and clumps images are not the same size.");
+        }
+        unsigned int numSpecBands = spectral->GetRasterCount();
+        if(colNames.size() != numSpecBands)
+        {
+            throw rsgis::img::RSGISImageCalcException("A column name must be provided for each band of the spectral image.");
+        }
         
-        std::vector<rsgis::img::ImgClumpMean*> *clumpTab = new std::vector<rsgis::img::ImgClumpMean*>();
-        clumpTab->reserve(maxClumpIdx);
-        rsgis::img::ImgClumpMean *cClump;
-        for(unsigned int i = 0; i < maxClumpIdx; ++i)
-        {
-            cClump = new rsgis::img::ImgClumpMean(i+1);
-            cClump->sumVals = new float[numSpecBands];
-            cClump->meanVals = new float[numSpecBands];
-            for(unsigned int n = 0; n < numSpecBands; ++n)
-            {
-                cClump->sumVals[n] = 0;
-                cClump->meanVals[n] = 0;
-            }
-            clumpTab->push_back(cClump);
+        std::vector<double> means;
+        unsigned long numClumps = 0;
+        std::cout << "Calculating clump means\n";
+        this->calcClumpMeans(spectral, clumps, &means, &numClumps, NULL);
+        
+        GDALRasterAttributeTable *attTable = clumps->GetRasterBand(1)->GetDefaultRAT();
+        if(attTable == NULL)
+        {
+            throw rsgis::img::RSGISImageCalcException("The clumps image does not have an attribute table.");
+        }
+        size_t numRows = numClumps + 1;
+        if(((size_t)attTable->GetRowCount()) < numRows)
+        {
+            attTable->SetRowCount(numRows);
         }
+        // Any rows beyond the largest clump are given 0.
+        numRows = attTable->GetRowCount();
         
-        for(unsigned int i = 0; i < height; ++i)
+        rsgis::rastergis::RSGISRasterAttUtils ratUtils;
+        std::vector<double> colVals(numRows, 0);
+        for(unsigned int n = 0; n < numSpecBands; ++n)
         {
-            clumpBand->RasterIO(GF_Read, 0, i, width, 1, clumpIdxs, width, 1, GDT_UInt32, 0, 0);
-            for(unsigned int n = 0; n < numSpecBands; ++n)
-            {
-                spectralBands[n]->RasterIO(GF_Read, 0, i, width, 1, spectralVals[n], width, 1, GDT_Float32, 0, 0);
-            }
-            for(unsigned int j = 0; j < width; ++j)
-            {
-                if(clumpIdxs[j] != 0)
-                {
-                    cClump = clumpTab->at(clumpIdxs[j] - 1);
-                    for(unsigned int n = 0; n < numSpecBands; ++n)
-                    {
-                        cClump->sumVals[n] += spectralVals[n][j];
-                    }
-                    ++cClump->numPxls;
-                }
-            }
+            std::copy(means.begin() + (n * (numClumps + 1)), means.begin() + ((n + 1) * (numClumps + 1)), colVals.begin());
+            ratUtils.writeRealColumn(attTable, colNames.at(n), &colVals[0], numRows);
+        }
+    }
+    
+    void RSGISGenMeanSegImage::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+    
+    void RSGISGenMeanSegImage::calcClumpMeans(GDALDataset *spectral, GDALDataset *clumps, std::vector<double> *means, unsigned long *numClumps, std::vector<unsigned int> *clumpLabels)
+    {
+        unsigned int width = spectral->GetRasterXSize();
+        unsigned int height = spectral->GetRasterYSize();
+        unsigned int numSpecBands = spectral->GetRasterCount();
+        GDALRasterBand *clumpBand = clumps->GetRasterBand(1);
+        GDALRasterBand **spectralBands = new GDALRasterBand*[numSpecBands];
+        for(unsigned int n = 0; n < numSpecBands; ++n)
+        {
+            spectralBands[n] = spectral->GetRasterBand(n+1);
         }
         
-        for(std::vector<rsgis::img::ImgClumpMean*>::iterator iterClumps = clumpTab->begin(); iterClumps != clumpTab->end(); ++iterClumps)
+        int blockXSize = 0;
+        int blockYSize = 0;
+        clumpBand->GetBlockSize(&blockXSize, &blockYSize);
+        unsigned int stripRows = (blockYSize > 0)?blockYSize:1;
+        unsigned int numStrips = (height + stripRows - 1) / stripRows;
+        if(clumpLabels != NULL)
         {
-            for(unsigned int n = 0; n < numSpecBands; ++n)
-            {
-                (*iterClumps)->meanVals[n] = (*iterClumps)->sumVals[n] / (*iterClumps)->numPxls;
-            }
+            clumpLabels->assign(((size_t)width) * height, 0);
         }
         
-        for(unsigned int i = 0; i < height; ++i)
+        // Each thread sums into its own arrays (clump major, the count then the
+        // band sums for each clump), grown as larger clump IDs are found.
+        rsgis::utils::RSGISWorkerPool pool(std::max<unsigned int>(1, std::min(this->numThreads, numStrips)));
+        unsigned int nThreads = pool.getNumThreads();
+        std::vector<std::vector<double> > threadSums(nThreads);
+        std::vector<std::vector<unsigned int> > threadLabels(nThreads);
+        std::vector<std::vector<float> > threadStripVals(nThreads);
+        size_t clumpStride = numSpecBands + 1;
+        std::mutex ioMutex;
+        
+        try
         {
-            clumpBand->RasterIO(GF_Read, 0, i, width, 1, clumpIdxs, width, 1, GDT_UInt32, 0, 0);
-            
-            for(unsigned int j = 0; j < width; ++j)
+            pool.parallelFor(numStrips, [&](size_t s, unsigned int threadIdx)
             {
-                if(clumpIdxs[j] != 0)
+                std::vector<double> &sums = threadSums[threadIdx];
+                std::vector<unsigned int> &stripLabels = threadLabels[threadIdx];
+                std::vector<float> &stripVals = threadStripVals[threadIdx];
+                stripLabels.resize(((size_t)width) * stripRows);
+                stripVals.resize(((size_t)width) * stripRows * numSpecBands);
+                
+                unsigned int yStart = s * stripRows;
+                unsigned int numRows = std::min(stripRows, height - yStart);
+                size_t numPxls = ((size_t)width) * numRows;
+                unsigned int *labels = &stripLabels[0];
+                if(clumpLabels != NULL)
+                {
+                    labels = &(*clumpLabels)[((size_t)width) * yStart];
+                }
                 {
-                    cClump = clumpTab->at(clumpIdxs[j] - 1);
+                    std::lock_guard<std::mutex> lock(ioMutex);
+                    if(clumpBand->RasterIO(GF_Read, 0, yStart, width, numRows, labels, width, numRows, GDT_UInt32, 0, 0) != CE_None)
+                    {
+                        throw rsgis::img::RSGISImageCalcException("Could not read the clumps image.");
+                    }
                     for(unsigned int n = 0; n < numSpecBands; ++n)
                     {
-                        spectralVals[n][j] = cClump->meanVals[n];
+                        if(spectralBands[n]->RasterIO(GF_Read, 0, yStart, width, numRows, &stripVals[n * numPxls], width, numRows, GDT_Float32, 0, 0) != CE_None)
+                        {
+                            throw rsgis::img::RSGISImageCalcException("Could not read the spectral image.");
+                        }
                     }
                 }
-                else
+                
+                unsigned int maxLabel = 0;
+                for(size_t p = 0; p < numPxls; ++p)
+                {
+                    maxLabel = std::max(maxLabel, labels[p]);
+                }
+                if((((size_t)maxLabel) + 1) * clumpStride > sums.size())
                 {
-                    for(unsigned int n = 0; n < numSpecBands; ++n)
+                    sums.resize((((size_t)maxLabel) + 1) * clumpStride, 0);
+                }
+                for(size_t p = 0; p < numPxls; ++p)
+                {
+                    sums[((size_t)labels[p]) * clumpStride] += 1;
+                }
+                for(unsigned int n = 0; n < numSpecBands; ++n)
+                {
+                    const float *bandVals = &stripVals[n * numPxls];
+                    double *bandSums = &sums[n + 1];
+                    for(size_t p = 0; p < numPxls; ++p)
                     {
-                        spectralVals[n][j] = 0;
+                        bandSums[((size_t)labels[p]) * clumpStride] += bandVals[p];
                     }
                 }
-            }
-            
-            for(unsigned int n = 0; n < numSpecBands; ++n)
-            {
-                meanBands[n]->RasterIO(GF_Write, 0, i, width, 1, spectralVals[n], width, 1, GDT_Float32, 0, 0);
-            }
+            });
         }
-        
-        
-        delete[] clumpIdxs;
-        for(unsigned int n = 0; n < numSpecBands; ++n)
+        catch(...)
         {
-            delete[] spectralVals[n];
+            delete[] spectralBands;
+            throw;
         }
-        delete[] spectralVals;
-        
         delete[] spectralBands;
-        delete[] meanBands;
         
-        for(std::vector<rsgis::img::ImgClumpMean*>::iterator iterClumps = clumpTab->begin(); iterClumps != clumpTab->end(); ++iterClumps)
-        {
-            delete[] (*iterClumps)->meanVals;
-            delete[] (*iterClumps)->sumVals;
-            delete *iterClumps;
-        }
-        delete clumpTab;
-    }
-    
-    void RSGISGenMeanSegImage::generateMeanImageUsingCalcImage(GDALDataset *spectral, GDALDataset *clumps, GDALDataset *meanImg) 
-    {
-        try
+        // Add the threads' sums together.
+        std::vector<double> &totals = threadSums[0];
+        for(unsigned int t = 1; t < nThreads; ++t)
         {
-            if((spectral->GetRasterXSize() != clumps->GetRasterXSize()) |
-               (spectral->GetRasterXSize() != meanImg->GetRasterXSize()))
-            {
-                throw rsgis::img::RSGISImageCalcException("Widths are not the same");
-            }
-            if((spectral->GetRasterYSize() != clumps->GetRasterYSize()) |
-               (spectral->GetRasterYSize() != meanImg->GetRasterYSize()))
+            if(threadSums[t].size() > totals.size())
             {
-                throw rsgis::img::RSGISImageCalcException("Heights are not the same");
+                totals.resize(threadSums[t].size(), 0);
             }
-            if(spectral->GetRasterCount() != meanImg->GetRasterCount())
+            for(size_t i = 0; i < threadSums[t].size(); ++i)
             {
-                throw rsgis::img::RSGISImageCalcException("The number of bands is not the same");
+                totals[i] += threadSums[t][i];
             }
-            rsgis::rastergis::RSGISRasterAttUtils ratUtils;
-            
-            std::cout << "Finding maximum image value\n";
-            long maxVal = 0;
-            long minVal = 0;
-            ratUtils.getImageBandMinMax(clumps, 1, &minVal, &maxVal);
-            
-            unsigned int maxClumpIdx = boost::lexical_cast<unsigned long>(maxVal);
-            
-            unsigned int numSpecBands = spectral->GetRasterCount();
-                        
-            std::vector<rsgis::img::ImgClumpMean*> *clumpTable = new std::vector<rsgis::img::ImgClumpMean*>();
-            clumpTable->reserve(maxClumpIdx);
-            
-            std::cout << "Build clump table\n";
-            rsgis::img::ImgClumpMean *cClump = NULL;
-            for(unsigned int i = 0; i < maxClumpIdx; ++i)
-            {
-                cClump = new rsgis::img::ImgClumpMean(i+1);
-                cClump->sumVals = new float[numSpecBands];
-                cClump->meanVals = new float[numSpecBands];
-                cClump->numPxls = 0;
-                for(unsigned int n = 0; n < numSpecBands; ++n)
-                {
-                    cClump->sumVals[n] = 0;
-                    cClump->meanVals[n] = 0;
-                }
-                clumpTable->push_back(cClump);
-            }
-            
-            std::cout << "Creating Look up table.\n";
-            RSGISPopulateMeans *createLookUp = new RSGISPopulateMeans(clumpTable, numSpecBands, maxClumpIdx);
-            rsgis::img::RSGISCalcImage calcImgCreateLoopUp = rsgis::img::RSGISCalcImage(createLookUp);
-            GDALDataset **datasets = new GDALDataset*[2];
-            datasets[0] = clumps;
-            datasets[1] = spectral;
-            calcImgCreateLoopUp.calcImage(datasets, 2);
-            delete createLookUp;
-            
-            
-            
-            //for(unsigned int i = 0; i < maxClumpIdx; ++i)
-            for(std::vector<rsgis::img::ImgClumpMean*>::iterator iterClump = clumpTable->begin(); iterClump != clumpTable->end(); ++iterClump)
+            std::vector<double>().swap(threadSums[t]);
+        }
+        if(totals.empty())
+        {
+            totals.assign(clumpStride, 0);
+        }
+        
+        *numClumps = (totals.size() / clumpStride) - 1;
+        size_t meansStride = (*numClumps) + 1;
+        means->assign(meansStride * numSpecBands, 0);
+        for(size_t c = 1; c < meansStride; ++c)
+        {
+            const double *clumpSums = &totals[c * clumpStride];
+            if(clumpSums[0] > 0)
             {
                 for(unsigned int n = 0; n < numSpecBands; ++n)
                 {
-                    (*iterClump)->meanVals[n] = (*iterClump)->sumVals[n]/(*iterClump)->numPxls;
+                    (*means)[(n * meansStride) + c] = clumpSums[n + 1] / clumpSums[0];
                 }
             }
-            
-            std::cout << "Applying Look up table.\n";
-            RSGISApplyMeans2Output *applyMeansLookUp = new RSGISApplyMeans2Output(clumpTable, numSpecBands, maxClumpIdx);
-            rsgis::img::RSGISCalcImage calcImgApplyLookUp = rsgis::img::RSGISCalcImage(applyMeansLookUp);
-            calcImgApplyLookUp.calcImage(datasets, 2, meanImg);
-            delete applyMeansLookUp;
-            delete[] datasets;
-            
-            for(std::vector<rsgis::img::ImgClumpMean*>::iterator iterClump = clumpTable->begin(); iterClump != clumpTable->end(); ++iterClump)
-            {
-                delete[] (*iterClump)->meanVals;
-                delete[] (*iterClump)->sumVals;
-                delete (*iterClump);
-            }
-            delete clumpTable;
-            
-        }
-        catch(rsgis::img::RSGISImageCalcException &e)
-        {
-            throw e;
-        }
-        catch (rsgis::RSGISException &e)
-        {
-            throw rsgis::img::RSGISImageCalcException(e.what());
-        }
-        catch (std::exception &e)
-        {
-            throw rsgis::img::RSGISImageCalcException(e.what());
         }
     }
     
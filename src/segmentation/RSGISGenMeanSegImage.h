@@ -27,11 +27,18 @@
 #include <string>
 #include <vector>
 #include <queue>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <exception>
+#include <cstdlib>
 #include <math.h>
 
 #include "gdal_priv.h"
 
 #include "common/rsgis-tqdm.h"
+#include "common/RSGISParallel.h"
 
 #include "img/RSGISImageUtils.h"
 #include "img/RSGISImageCalcException.h"
@@ -62,7 +69,37 @@ namespace rsgis{namespace segment{
         void generateMeanImage(GDALDataset *spectral, GDALDataset *clumps, GDALDataset *meanImg);
         void generateMeanImageUsingClumpTable(GDALDataset *spectral, GDALDataset *clumps, GDALDataset *meanImg);
         void generateMeanImageUsingCalcImage(GDALDataset *spectral, GDALDataset *clumps, GDALDataset *meanImg);
+        /**
+         * Generate the mean image reading the spectral image only once. The
+         * per clump means are accumulated by calcClumpMeans and then gathered
+         * into the output a band at a time. The clump labels are held in memory
+         * between the two passes if they fit within maxMemMB, otherwise the
+         * clumps image is read a second time. Pixels with clump 0 are 0.
+         */
+        void generateMeanImageSinglePass(GDALDataset *spectral, GDALDataset *clumps, GDALDataset *meanImg, double maxMemMB=1024);
+        /**
+         * Write the mean of each band of the spectral image for each clump to
+         * the columns colNames (one per band) of the clumps RAT, extending the
+         * RAT if it has fewer rows than clumps.
+         */
+        void populateRATWithMeans(GDALDataset *spectral, GDALDataset *clumps, std::vector<std::string> colNames);
+        /**
+         * Number of threads used to accumulate the means (default RSGISLIB_NUM_THREADS or 1); 0 uses the number of cores.
+         */
+        void setNumThreads(unsigned int numThreads);
         ~RSGISGenMeanSegImage();
+    protected:
+        /**
+         * Calculate the mean of each band for every clump in one pass over
+         * strips of rows, with the strips shared among the threads, each
+         * summing into its own flat arrays which are added together at the
+         * end. The means are written band major, numClumps+1 values per band
+         * with index 0 (no clump) 0, so they can be gathered by the clump
+         * labels without a test. If clumpLabels is not NULL the labels of the
+         * whole image are also kept in it.
+         */
+        void calcClumpMeans(GDALDataset *spectral, GDALDataset *clumps, std::vector<double> *means, unsigned long *numClumps, std::vector<unsigned int> *clumpLabels);
+        unsigned int numThreads;
     };
     
     
@@ -0,0 +1,297 @@
+/*
+ *  RSGISHierarchicalSegmentation.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISHierarchicalSegmentation.h"
+
+namespace rsgis{namespace segment{
+    
+    RSGISHierarchicalSegmentation::RSGISHierarchicalSegmentation()
+    {
+        this->numClumps = 0;
+        this->numSpecBands = 0;
+    }
+    
+    void RSGISHierarchicalSegmentation::buildMergeTree(GDALDataset *spectral, GDALDataset *clumps)
+    {
+        if(spectral->GetRasterXSize() != clumps->GetRasterXSize())
+        {
+            throw rsgis::img::RSGISImageCalcException("Widths are not the same");
+        }
+        if(spectral->GetRasterYSize() != clumps->GetRasterYSize())
+        {
+            throw rsgis::img::RSGISImageCalcException("Heights are not the same");
+        }
+        
+        std::cout << "Building the clump adjacency graph\n";
+        rsgis::rastergis::RSGISRegionAdjacencyGraph rag;
+        rag.buildFromClumps(clumps, 1, false);
+        this->numClumps = rag.getNumNodes();
+        this->numSpecBands = spectral->GetRasterCount();
+        
+        // Regions 0..numClumps-1 are the initial clumps and each merge creates
+        // a new region, so there are fewer than 2*numClumps regions.
+        size_t maxRegions = 2 * std::max<size_t>(this->numClumps, 1);
+        std::vector<double> sums;
+        std::vector<unsigned long> numPxls;
+        std::cout << "Calculating clump statistics\n";
+        this->calcClumpSums(spectral, clumps, maxRegions, &sums, &numPxls);
+        this->clumpPxls.assign(numPxls.begin(), numPxls.begin() + this->numClumps);
+        
+        // The neighbours of each live region, with a pair of adjacent initial
+        // clumps (this region's first) for each.
+        typedef std::unordered_map<size_t, std::pair<unsigned int, unsigned int> > RegionNbrs;
+        std::vector<RegionNbrs> regionNbrs(maxRegions);
+        std::vector<bool> alive(maxRegions, false);
+        std::priority_queue<RSGISRegionPair, std::vector<RSGISRegionPair>, std::greater<RSGISRegionPair> > pairHeap;
+        for(size_t c = 1; c < this->numClumps; ++c)
+        {
+            alive[c] = (numPxls[c] > 0);
+            const unsigned int *nbrs = rag.getNeighbours(c);
+            for(size_t n = 0; n < rag.getNumNeighbours(c); ++n)
+            {
+                regionNbrs[c][nbrs[n]] = std::pair<unsigned int, unsigned int>(c, nbrs[n]);
+                if(c < nbrs[n])
+                {
+                    pairHeap.push(RSGISRegionPair(std::min(numPxls[c], numPxls[nbrs[n]]), this->calcRegionDist(sums, numPxls, c, nbrs[n]), c, nbrs[n]));
+                }
+            }
+        }
+        
+        std::cout << "Building the merge tree\n";
+        this->merges.clear();
+        this->merges.reserve(this->numClumps);
+        size_t nextRegion = this->numClumps;
+        while(!pairHeap.empty())
+        {
+            RSGISRegionPair regPair = pairHeap.top();
+            pairHeap.pop();
+            size_t a = regPair.regionA;
+            size_t b = regPair.regionB;
+            if(!alive[a] || !alive[b])
+            {
+                continue;
+            }
+            
+            RSGISTreeMerge merge;
+            merge.clumpA = regionNbrs[a][b].first;
+            merge.clumpB = regionNbrs[a][b].second;
+            merge.minRegionPxls = regPair.minPxls;
+            merge.specDist = regPair.dist;
+            this->merges.push_back(merge);
+            
+            size_t c = nextRegion++;
+            alive[a] = false;
+            alive[b] = false;
+            alive[c] = true;
+            numPxls[c] = numPxls[a] + numPxls[b];
+            for(unsigned int n = 0; n < this->numSpecBands; ++n)
+            {
+                sums[(c*this->numSpecBands)+n] = sums[(a*this->numSpecBands)+n] + sums[(b*this->numSpecBands)+n];
+            }
+            
+            // The larger neighbour table becomes that of the new region and the
+            // smaller is added to it.
+            size_t large = a;
+            size_t small = b;
+            if(regionNbrs[a].size() < regionNbrs[b].size())
+            {
+                large = b;
+                small = a;
+            }
+            RegionNbrs &cNbrs = regionNbrs[c];
+            cNbrs.swap(regionNbrs[large]);
+            cNbrs.erase(small);
+            for(RegionNbrs::iterator iterNbr = regionNbrs[small].begin(); iterNbr != regionNbrs[small].end(); ++iterNbr)
+            {
+                if(iterNbr->first != large)
+                {
+                    cNbrs.insert(*iterNbr);
+                }
+            }
+            RegionNbrs().swap(regionNbrs[small]);
+            
+            for(RegionNbrs::iterator iterNbr = cNbrs.begin(); iterNbr != cNbrs.end(); ++iterNbr)
+            {
+                RegionNbrs &xNbrs = regionNbrs[iterNbr->first];
+                xNbrs.erase(a);
+                xNbrs.erase(b);
+                xNbrs[c] = std::pair<unsigned int, unsigned int>(iterNbr->second.second, iterNbr->second.first);
+                pairHeap.push(RSGISRegionPair(std::min(numPxls[c], numPxls[iterNbr->first]), this->calcRegionDist(sums, numPxls, c, iterNbr->first), c, iterNbr->first));
+            }
+        }
+        std::cout << "The merge tree has " << this->merges.size() << " merges\n";
+    }
+    
+    unsigned int RSGISHierarchicalSegmentation::cutMergeTree(unsigned int minPxls, float distThres, std::vector<unsigned int> *lut)
+    {
+        // The merges are applied to the initial clumps through their pair of
+        // adjacent clumps so the output clumps are always connected.
+        std::vector<unsigned int> parent(this->numClumps);
+        for(size_t c = 0; c < this->numClumps; ++c)
+        {
+            parent[c] = c;
+        }
+        for(std::vector<RSGISTreeMerge>::const_iterator iterMerge = this->merges.begin(); iterMerge != this->merges.end(); ++iterMerge)
+        {
+            if(((*iterMerge).minRegionPxls < minPxls) && ((*iterMerge).specDist < distThres))
+            {
+                size_t rootA = this->findRoot(&parent, (*iterMerge).clumpA);
+                size_t rootB = this->findRoot(&parent, (*iterMerge).clumpB);
+                if(rootA != rootB)
+                {
+                    parent[std::max(rootA, rootB)] = std::min(rootA, rootB);
+                }
+            }
+        }
+        
+        // The output clumps are numbered in the order of their first initial clump.
+        lut->assign(std::max<size_t>(this->numClumps, 1), 0);
+        std::vector<unsigned int> rootIDs(this->numClumps, 0);
+        unsigned int nextID = 1;
+        for(size_t c = 1; c < this->numClumps; ++c)
+        {
+            if(this->clumpPxls[c] == 0)
+            {
+                continue;
+            }
+            size_t root = this->findRoot(&parent, c);
+            if(rootIDs[root] == 0)
+            {
+                rootIDs[root] = nextID++;
+            }
+            (*lut)[c] = rootIDs[root];
+        }
+        return nextID - 1;
+    }
+    
+    unsigned int RSGISHierarchicalSegmentation::writeCut(GDALDataset *clumps, std::string outputImage, std::string gdalFormat, unsigned int minPxls, float distThres)
+    {
+        std::vector<unsigned int> lut;
+        unsigned int numOutClumps = this->cutMergeTree(minPxls, distThres, &lut);
+        std::cout << "Writing " << numOutClumps << " clumps (minPxls = " << minPxls << ", distThres = " << distThres << ") to " << outputImage << std::endl;
+        
+        rsgis::img::RSGISImageUtils imgUtils;
+        GDALDataset *outDataset = imgUtils.createCopy(clumps, 1, outputImage, gdalFormat, GDT_UInt32);
+        if(outDataset == NULL)
+        {
+            std::string message = std::string("Could not create image ") + outputImage;
+            throw rsgis::RSGISImageException(message.c_str());
+        }
+        try
+        {
+            RSGISClumpRelabeller relabeller;
+            std::vector<unsigned long long> histogram;
+            relabeller.applyLUT(clumps->GetRasterBand(1), outDataset->GetRasterBand(1), lut, &histogram);
+            rsgis::rastergis::RSGISPopulateWithImageStats popImageStats;
+            popImageStats.writeHistogramToRAT(outDataset, histogram, true, true, 1);
+        }
+        catch(rsgis::RSGISException &e)
+        {
+            GDALClose(outDataset);
+            throw rsgis::img::RSGISImageCalcException(e.what());
+        }
+        GDALClose(outDataset);
+        return numOutClumps;
+    }
+    
+    void RSGISHierarchicalSegmentation::calcClumpSums(GDALDataset *spectral, GDALDataset *clumps, size_t numRegions, std::vector<double> *sums, std::vector<unsigned long> *numPxls)
+    {
+        unsigned int width = spectral->GetRasterXSize();
+        unsigned int height = spectral->GetRasterYSize();
+        sums->assign(numRegions * this->numSpecBands, 0);
+        numPxls->assign(numRegions, 0);
+        
+        GDALRasterBand *clumpBand = clumps->GetRasterBand(1);
+        std::vector<GDALRasterBand*> spectralBands(this->numSpecBands);
+        for(unsigned int n = 0; n < this->numSpecBands; ++n)
+        {
+            spectralBands[n] = spectral->GetRasterBand(n+1);
+        }
+        int blockXSize = 0;
+        int blockYSize = 0;
+        clumpBand->GetBlockSize(&blockXSize, &blockYSize);
+        unsigned int stripRows = (blockYSize > 0)?blockYSize:1;
+        std::vector<unsigned int> labels(((size_t)width) * stripRows);
+        std::vector<float> specVals(((size_t)width) * stripRows);
+        
+        for(unsigned int yStart = 0; yStart < height; yStart += stripRows)
+        {
+            unsigned int numRows = std::min(stripRows, height - yStart);
+            size_t stripPxls = ((size_t)width) * numRows;
+            clumpBand->RasterIO(GF_Read, 0, yStart, width, numRows, &labels[0], width, numRows, GDT_UInt32, 0, 0);
+            for(size_t p = 0; p < stripPxls; ++p)
+            {
+                if(labels[p] >= this->numClumps)
+                {
+                    throw rsgis::img::RSGISImageCalcException("Clump ID is larger than the number of clumps.");
+                }
+                ++(*numPxls)[labels[p]];
+            }
+            for(unsigned int n = 0; n < this->numSpecBands; ++n)
+            {
+                spectralBands[n]->RasterIO(GF_Read, 0, yStart, width, numRows, &specVals[0], width, numRows, GDT_Float32, 0, 0);
+                for(size_t p = 0; p < stripPxls; ++p)
+                {
+                    (*sums)[(((size_t)labels[p])*this->numSpecBands)+n] += specVals[p];
+                }
+            }
+        }
+    }
+    
+    double RSGISHierarchicalSegmentation::calcRegionDist(const std::vector<double> &sums, const std::vector<unsigned long> &numPxls, size_t regionA, size_t regionB)
+    {
+        if((numPxls[regionA] == 0) || (numPxls[regionB] == 0))
+        {
+            return 0;
+        }
+        const double *sumsA = &sums[regionA*this->numSpecBands];
+        const double *sumsB = &sums[regionB*this->numSpecBands];
+        double dist = 0;
+        for(unsigned int n = 0; n < this->numSpecBands; ++n)
+        {
+            double diff = (sumsA[n]/numPxls[regionA]) - (sumsB[n]/numPxls[regionB]);
+            dist += diff * diff;
+        }
+        return sqrt(dist);
+    }
+    
+    size_t RSGISHierarchicalSegmentation::findRoot(std::vector<unsigned int> *parent, size_t clump)
+    {
+        size_t root = clump;
+        while((*parent)[root] != root)
+        {
+            root = (*parent)[root];
+        }
+        while((*parent)[clump] != root)
+        {
+            size_t next = (*parent)[clump];
+            (*parent)[clump] = root;
+            clump = next;
+        }
+        return root;
+    }
+    
+    RSGISHierarchicalSegmentation::~RSGISHierarchicalSegmentation()
+    {
+        
+    }
+    
+}}
@@ -0,0 +1,149 @@
+/*
+ *  RSGISHierarchicalSegmentation.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISHierarchicalSegmentation_H
+#define RSGISHierarchicalSegmentation_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <queue>
+#include <functional>
+#include <unordered_map>
+#include <algorithm>
+#include <math.h>
+
+#include "gdal_priv.h"
+
+#include "img/RSGISImageUtils.h"
+#include "img/RSGISImageCalcException.h"
+
+#include "rastergis/RSGISRegionAdjacencyGraph.h"
+#include "rastergis/RSGISCalcImageStatsAndPyramids.h"
+
+#include "segmentation/RSGISClumpPxls.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_segmentation_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace segment{
+    
+    /**
+     * A merge of two regions of the merge tree: a pair of adjacent initial
+     * clumps, one in each region, the number of pixels in the smaller region
+     * and the spectral (Euclidean) distance between the region means.
+     */
+    struct RSGISTreeMerge
+    {
+        unsigned int clumpA;
+        unsigned int clumpB;
+        unsigned long minRegionPxls;
+        float specDist;
+    };
+    
+    /**
+     * Multi-scale segmentation from a single merge tree (a binary partition
+     * tree) over the region adjacency graph of an initial clumps image, e.g.,
+     * the clumps of the k-means labels in the Shepherd segmentation.
+     *
+     * The tree is built in one pass over the spectral image and one merge
+     * pass: the smallest region is repeatedly merged with its spectrally
+     * closest neighbour (a min-heap of region pairs ordered by the size of
+     * the smaller region then the distance), as the stepwise elimination of
+     * small clumps does, until each connected group of clumps is one region.
+     *
+     * A segmentation at a scale (minPxls, distThres) is then a cut of the
+     * tree, applying the merges where the smaller region has fewer than
+     * minPxls pixels and the regions are closer than distThres, so any
+     * number of scales are produced without reading the spectral image or
+     * merging again. The sizes and distances are those of the full tree, so
+     * a cut approximates rather than reproduces the stepwise elimination at
+     * that scale.
+     */
+    class DllExport RSGISHierarchicalSegmentation
+    {
+    public:
+        RSGISHierarchicalSegmentation();
+        /**
+         * Build the merge tree from the means of the spectral image within
+         * the clumps.
+         */
+        void buildMergeTree(GDALDataset *spectral, GDALDataset *clumps);
+        size_t getNumMerges() const {return merges.size();};
+        const std::vector<RSGISTreeMerge>& getMerges() const {return merges;};
+        /**
+         * Cut the tree at a scale, giving the output clump for each initial
+         * clump (0 for clump 0 and empty clumps). Returns the number of output clumps.
+         */
+        unsigned int cutMergeTree(unsigned int minPxls, float distThres, std::vector<unsigned int> *lut);
+        /**
+         * Cut the tree at a scale and write the output clumps, with their
+         * histogram and a colour table, relabelling the initial clumps.
+         */
+        unsigned int writeCut(GDALDataset *clumps, std::string outputImage, std::string gdalFormat, unsigned int minPxls, float distThres);
+        ~RSGISHierarchicalSegmentation();
+    protected:
+        struct RSGISRegionPair
+        {
+            RSGISRegionPair(unsigned long minPxls, double dist, size_t regionA, size_t regionB): minPxls(minPxls), dist(dist), regionA(regionA), regionB(regionB){};
+            unsigned long minPxls;
+            double dist;
+            size_t regionA;
+            size_t regionB;
+            bool operator>(const RSGISRegionPair &other) const
+            {
+                if(minPxls != other.minPxls)
+                {
+                    return minPxls > other.minPxls;
+                }
+                if(dist != other.dist)
+                {
+                    return dist > other.dist;
+                }
+                if(regionA != other.regionA)
+                {
+                    return regionA > other.regionA;
+                }
+                return regionB > other.regionB;
+            };
+        };
+        void calcClumpSums(GDALDataset *spectral, GDALDataset *clumps, size_t numClumps, std::vector<double> *sums, std::vector<unsigned long> *numPxls);
+        double calcRegionDist(const std::vector<double> &sums, const std::vector<unsigned long> &numPxls, size_t regionA, size_t regionB);
+        size_t findRoot(std::vector<unsigned int> *parent, size_t clump);
+        size_t numClumps;
+        unsigned int numSpecBands;
+        std::vector<unsigned long> clumpPxls;
+        std::vector<RSGISTreeMerge> merges;
+    };
+    
+}}
+
+#endif
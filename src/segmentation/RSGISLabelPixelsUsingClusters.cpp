@@ -73,54 +73,87 @@ namespace rsgis{namespace segment{
     
     
 
-    RSGISLabelPixelsUsingClustersCalcImg::RSGISLabelPixelsUsingClustersCalcImg(int numberOutBands, rsgis::math::Matrix *clusterCentres, bool ignoreZeros) : RSGISCalcImageValue(numberOutBands)
+    RSGISLabelPixelsUsingClustersCalcImg::RSGISLabelPixelsUsingClustersCalcImg(int numberOutBands, rsgis::math::Matrix *clusterCentres, bool ignoreZeros) : RSGISCalcImageValue(numberOutBands), nearestCentre(clusterCentres->matrix, clusterCentres->m, clusterCentres->n)
     {
-        this->clusterCentres = clusterCentres;
         this->ignoreZeros = ignoreZeros;
     }
     
     void RSGISLabelPixelsUsingClustersCalcImg::calcImageValue(float *bandValues, int numBands, double *output) 
     {
-        unsigned int clusterID = 0;
-        float minDist = 0;
-        float dist = 0;
-        int clustIdx = 0;
-        bool nonZeroFound = false;
+        this->checkNumBands(numBands);
         
-        for(int cluster = 0; cluster < clusterCentres->m; ++cluster)
+        bool nonZeroFound = false;
+        for(int i = 0; i < numBands; ++i)
         {
-            dist = 0;
-            for(int i = 0; i < numBands; ++i)
+            if(bandValues[i] != 0)
             {
-                clustIdx = (i*clusterCentres->m)+cluster;
-                dist += ((bandValues[i]-clusterCentres->matrix[clustIdx])*(bandValues[i]-clusterCentres->matrix[clustIdx]));
-                if(bandValues[i] != 0)
-                {
-                    nonZeroFound = true;
-                }
+                nonZeroFound = true;
+                break;
             }
-            
-            dist = sqrt(dist);
-            
-            if(cluster == 0)
+        }
+        
+        if((ignoreZeros && !nonZeroFound) || (nearestCentre.getNumCentres() == 0))
+        {
+            output[0] = 0;
+        }
+        else
+        {
+            std::vector<float> distScratch(nearestCentre.getNumCentres());
+            output[0] = nearestCentre.findNearest(bandValues, distScratch.data()) + 1;
+        }
+    }
+    
+    void RSGISLabelPixelsUsingClustersCalcImg::calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes)
+    {
+        this->checkNumBands(numBands);
+        
+        double *outPlane = outPlanes[0];
+        if(nearestCentre.getNumCentres() == 0)
+        {
+            for(size_t j = 0; j < nPxls; ++j)
             {
-                clusterID = cluster+1;
-                minDist = dist;
+                outPlane[j] = 0;
             }
-            else if(dist < minDist)
+            return;
+        }
+        
+        std::vector<unsigned int> nearest(nPxls);
+        nearestCentre.findNearest(bandPlanes, nPxls, nearest.data());
+        for(size_t j = 0; j < nPxls; ++j)
+        {
+            outPlane[j] = nearest[j] + 1;
+        }
+        
+        if(ignoreZeros)
+        {
+            std::vector<bool> nonZero(nPxls, false);
+            for(int i = 0; i < numBands; ++i)
             {
-                clusterID = cluster+1;
-                minDist = dist;
+                const float *inPlane = bandPlanes[i];
+                for(size_t j = 0; j < nPxls; ++j)
+                {
+                    if(inPlane[j] != 0)
+                    {
+                        nonZero[j] = true;
+                    }
+                }
             }
-            
-            if(ignoreZeros & !nonZeroFound)
+            for(size_t j = 0; j < nPxls; ++j)
             {
-                clusterID = 0;
-                break;
+                if(!nonZero[j])
+                {
+                    outPlane[j] = 0;
+                }
             }
         }
-        
-        output[0] = clusterID;
+    }
+    
+    void RSGISLabelPixelsUsingClustersCalcImg::checkNumBands(int numBands)
+    {
+        if(((unsigned int)numBands) != nearestCentre.getNumFeatures())
+        {
+            throw rsgis::img::RSGISImageCalcException("The number of image bands and the number of cluster centre dimensions are not the same.");
+        }
     }
     
     RSGISLabelPixelsUsingClustersCalcImg::~RSGISLabelPixelsUsingClustersCalcImg()
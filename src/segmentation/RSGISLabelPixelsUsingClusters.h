@@ -26,6 +26,7 @@
 #include <iostream>
 #include <string>
 #include <math.h>
+#include <vector>
 
 #include "common/RSGISImageException.h"
 
@@ -34,6 +35,7 @@
 #include "img/RSGISCalcImage.h"
 
 #include "math/RSGISMatrices.h"
+#include "math/RSGISClustering.h"
 
 #include "gdal_priv.h"
 #include "ogrsf_frmts.h"
@@ -67,6 +69,7 @@ namespace rsgis{namespace segment{
     public: 
         RSGISLabelPixelsUsingClustersCalcImg(int numberOutBands, rsgis::math::Matrix *clusterCentres, bool ignoreZeros);
         void calcImageValue(float *bandValues, int numBands, double *output);
+        void calcImageBlock(const float* const* bandPlanes, int numBands, size_t nPxls, double** outPlanes);
         void calcImageValue(float *bandValues, int numBands) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(long *intBandValues, unsigned int numIntVals, float *floatBandValues, unsigned int numfloatVals, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
@@ -76,9 +79,11 @@ namespace rsgis{namespace segment{
         void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
         void calcImageValue(float ***dataBlock, int numBands, int winSize, double *output, geos::geom::Envelope extent) {throw rsgis::img::RSGISImageCalcException("No implemented");};
         bool calcImageValueCondition(float ***dataBlock, int numBands, int winSize, double *output) {throw rsgis::img::RSGISImageCalcException("Not implemented");};
+        bool isThreadSafe(){return true;};
         ~RSGISLabelPixelsUsingClustersCalcImg();
     private:
-        rsgis::math::Matrix *clusterCentres;
+        void checkNumBands(int numBands);
+        rsgis::math::RSGISNearestClusterCentre nearestCentre;
         bool ignoreZeros;
     };
     
@@ -26,7 +26,7 @@ namespace rsgis{namespace segment{
     
     RSGISMergeSegmentationTiles::RSGISMergeSegmentationTiles()
     {
-        
+        this->numThreads = rsgis::utils::getNumThreads();
     }
     
     void RSGISMergeSegmentationTiles::createTileBorderClumpMask(GDALDataset *borderMaskDataset, std::vector<std::string> inputImagePaths, unsigned int tileBoundary, unsigned int tileOverlap, unsigned int tileBody, std::string colsName) 
@@ -88,52 +88,62 @@ namespace rsgis{namespace segment{
         }
     }
     
+    void RSGISMergeSegmentationTiles::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+    
     void RSGISMergeSegmentationTiles::mergeClumpBodies(GDALDataset *outputDataset, GDALDataset *borderMaskDataset, std::vector<std::string> inputImagePaths, unsigned int tileBoundary, unsigned int tileOverlap, unsigned int tileBody, std::string colsName) 
     {
         try
         {
-            rsgis::rastergis::RSGISRasterAttUtils ratUtils;
-            GDALRasterAttributeTable *attTable = NULL;
-            size_t numRows = 0;
-            long maxVal = 0;
-            long minVal = 0;
-            size_t clumpsOffset = 0;
-            size_t numClumps = 0;
-                           
-            for(std::vector<std::string>::iterator iterFiles = inputImagePaths.begin(); iterFiles != inputImagePaths.end(); ++iterFiles)
+            std::mutex ioMutex;
+            std::vector<RSGISMergeTileInfo> tiles;
+            this->initTiles(&tiles, inputImagePaths);
+            
+            std::cout << "Counting the body clumps of " << tiles.size() << " tiles\n";
+            this->processTiles(&tiles, false, &ioMutex, [this, outputDataset, &ioMutex, &colsName, tileBody](RSGISMergeTileInfo *tile, GDALDataset *tileDataset)
             {
-                std::cout << "\t Opening - " << (*iterFiles) << std::endl;
-                GDALDataset *inImage = (GDALDataset *) GDALOpen((*iterFiles).c_str(), GA_Update);
-                if(inImage == NULL)
+                size_t numRows = 0;
+                int *posVals = NULL;
                 {
-                    std::string message = std::string("Could not open image ") + (*iterFiles);
-                    throw rsgis::RSGISImageException(message.c_str());
+                    std::lock_guard<std::mutex> ioLock(ioMutex);
+                    GDALRasterAttributeTable *attTable = this->getTileRAT(tileDataset, tile);
+                    this->checkTileClumpIDs(tileDataset, tile);
+                    rsgis::rastergis::RSGISRasterAttUtils attUtils;
+                    posVals = attUtils.readIntColumn(attTable, colsName, &numRows);
                 }
-                
-                attTable = inImage->GetRasterBand(1)->GetDefaultRAT();
-                
-                if(attTable == NULL)
+                tile->numClumps = 0;
+                for(size_t i = 0; i < numRows; ++i)
                 {
-                    throw RSGISImageException("Input image does not have an attribute table.");
+                    if(posVals[i] == ((int)tileBody))
+                    {
+                        ++tile->numClumps;
+                    }
                 }
-                
-                numRows = attTable->GetRowCount();
-                
-                ratUtils.getImageBandMinMax(inImage, 1, &minVal, &maxVal);
-                
-                if(maxVal > numRows)
+                delete[] posVals;
+                this->findTileWindow(outputDataset, tileDataset, tile, &ioMutex);
+            });
+            
+            // Global clump IDs are allocated to the tiles in order.
+            size_t clumpsOffset = 0;
+            for(std::vector<RSGISMergeTileInfo>::iterator iterTiles = tiles.begin(); iterTiles != tiles.end(); ++iterTiles)
+            {
+                (*iterTiles).clumpsOffset = clumpsOffset;
+                clumpsOffset += (*iterTiles).numClumps;
+            }
+            
+            std::cout << "Merging the body clumps\n";
+            this->processTiles(&tiles, true, &ioMutex, [this, outputDataset, borderMaskDataset, &ioMutex, &colsName, tileBody, tileBoundary](RSGISMergeTileInfo *tile, GDALDataset *tileDataset)
+            {
+                GDALRasterAttributeTable *attTable = NULL;
                 {
-                    throw RSGISImageException("Number of rows and maximum image pixel value does not match.");
+                    std::lock_guard<std::mutex> ioLock(ioMutex);
+                    attTable = this->getTileRAT(tileDataset, tile);
+                    this->numberBodyClumps(attTable, "GlobalClumpID", colsName, tileBody, tile->clumpsOffset);
                 }
-                
-                numClumps = this->numberBodyClumps(attTable, "GlobalClumpID", colsName, tileBody, clumpsOffset);
-                
-                clumpsOffset += numClumps;
-                                
-                this->addTileBodyClumps(outputDataset, inImage, borderMaskDataset, attTable, "GlobalClumpID", colsName, tileBody, tileBoundary);
-                
-                GDALClose(inImage);
-            }
+                this->addTileBodyClumps(outputDataset, tileDataset, borderMaskDataset, attTable, "GlobalClumpID", colsName, tileBody, tileBoundary, &ioMutex);
+            });
         }
         catch (rsgis::img::RSGISImageCalcException &e)
         {
@@ -158,95 +168,106 @@ namespace rsgis{namespace segment{
         try
         {
             rsgis::rastergis::RSGISRasterAttUtils attUtils;
-            GDALRasterAttributeTable *attTable = NULL;
             GDALRasterAttributeTable *outAttTable = NULL;
             size_t numRows = 0;
             long maxVal = 0;
             long minVal = 0;
-            size_t clumpsOffset = 0;
-            size_t imageOffset = 0;
-            size_t numClumps = 0;
-            bool first = true;
+            std::mutex ioMutex;
             
             // Get maximum clumpid           
             attUtils.getImageBandMinMax(outputDataset, 1, &minVal, &maxVal);
-            clumpsOffset = maxVal;
-            imageOffset = maxVal;
             outAttTable = outputDataset->GetRasterBand(1)->GetDefaultRAT();
             numRows = outAttTable->GetRowCount();
             if(maxVal > numRows)
             {
-                outAttTable->SetRowCount(clumpsOffset);
+                outAttTable->SetRowCount(maxVal);
             }
-            std::vector<std::string> outRATCols;
             
-            for(std::vector<std::string>::iterator iterFiles = inputImagePaths.begin(); iterFiles != inputImagePaths.end(); ++iterFiles)
+            std::vector<RSGISMergeTileInfo> tiles;
+            this->initTiles(&tiles, inputImagePaths);
+            
+            std::cout << "Reading the size of " << tiles.size() << " tiles\n";
+            this->processTiles(&tiles, false, &ioMutex, [this, outputDataset, &ioMutex](RSGISMergeTileInfo *tile, GDALDataset *tileDataset)
             {
-                std::cout << "\t Opening - " << (*iterFiles) << std::endl;
-                GDALDataset *inImage = (GDALDataset *) GDALOpen((*iterFiles).c_str(), GA_Update);
-                if(inImage == NULL)
                 {
-                    std::string message = std::string("Could not open image ") + (*iterFiles);
-                    throw rsgis::RSGISImageException(message.c_str());
+                    std::lock_guard<std::mutex> ioLock(ioMutex);
+                    this->getTileRAT(tileDataset, tile);
+                    if(tile->numRows == 0)
+                    {
+                        throw RSGISImageException("Input image attribute table has no rows.");
+                    }
+                    this->checkTileClumpIDs(tileDataset, tile);
                 }
-                
-                attTable = inImage->GetRasterBand(1)->GetDefaultRAT();
-                
-                if(attTable == NULL)
+                tile->numClumps = tile->numRows;
+                this->findTileWindow(outputDataset, tileDataset, tile, &ioMutex);
+            });
+            
+            // The clump IDs of each image follow on from the previous image (row 0 is
+            // no data) and all the rows of the first image are copied to the output RAT
+            // but the first row of the rest is skipped.
+            size_t imageOffset = maxVal;
+            size_t ratOffset = maxVal;
+            for(std::vector<RSGISMergeTileInfo>::iterator iterTiles = tiles.begin(); iterTiles != tiles.end(); ++iterTiles)
+            {
+                (*iterTiles).clumpsOffset = imageOffset;
+                (*iterTiles).ratOffset = ratOffset;
+                if(iterTiles == tiles.begin())
                 {
-                    throw RSGISImageException("Input image does not have an attribute table.");
+                    (*iterTiles).firstRATRow = 0;
+                    ratOffset += (*iterTiles).numClumps;
                 }
-                
-                numRows = attTable->GetRowCount();
-                
-                maxVal = 0;
-                minVal = 0;
-                attUtils.getImageBandMinMax(inImage, 1, &minVal, &maxVal);
-                
-                if(maxVal > numRows)
+                else
                 {
-                    throw RSGISImageException("Number of rows and maximum image pixel value does not match.");
+                    (*iterTiles).firstRATRow = 1;
+                    ratOffset += ((*iterTiles).numClumps-1);
                 }
-                
-                numClumps = this->numberClumps(attTable, "GlobalClumpID", imageOffset);
-                
-                this->addImageClumps(outputDataset, inImage, attTable, "GlobalClumpID");
-                
-                if(first)
+                imageOffset += ((*iterTiles).numClumps-1);
+            }
+            
+            std::vector<std::string> outRATCols;
+            if(mergeRATs && (!tiles.empty()))
+            {
+                // The output columns are those of the first image along with the colour and histogram columns.
+                GDALDataset *inImage = (GDALDataset *) GDALOpen(tiles.at(0).path.c_str(), GA_ReadOnly);
+                if(inImage == NULL)
                 {
-                    if(mergeRATs)
-                    {
-                        int idx = 0;
-                        std::vector<rsgis::rastergis::RSGISRATCol> *inRATCols = attUtils.getRatColumnsList(attTable);
-                        for(std::vector<rsgis::rastergis::RSGISRATCol>::iterator iterCols = inRATCols->begin(); iterCols != inRATCols->end(); ++iterCols)
-                        {
-                            idx = attUtils.findColumnIndexOrCreate(outAttTable, (*iterCols).name, (*iterCols).type, (*iterCols).usage);
-                            outRATCols.push_back((*iterCols).name);
-                        }
-                        delete inRATCols;
-                    }
-                    
-                    if(mergeRATs)
-                    {
-                        attUtils.copyAttColumnsWithOff(attTable, outAttTable, outRATCols, clumpsOffset, false, true, true);
-                    }
-                    
-                    clumpsOffset += numClumps;
-                    first = false;
+                    std::string message = std::string("Could not open image ") + tiles.at(0).path;
+                    throw rsgis::RSGISImageException(message.c_str());
                 }
-                else
+                std::vector<rsgis::rastergis::RSGISRATCol> *inRATCols = attUtils.getRatColumnsList(inImage->GetRasterBand(1)->GetDefaultRAT());
+                for(std::vector<rsgis::rastergis::RSGISRATCol>::iterator iterCols = inRATCols->begin(); iterCols != inRATCols->end(); ++iterCols)
                 {
-                    if(mergeRATs)
-                    {
-                        attUtils.copyAttColumnsWithOff(attTable, outAttTable, outRATCols, clumpsOffset, true, true, true);
-                    }
-                    clumpsOffset += (numClumps-1);
+                    attUtils.findColumnIndexOrCreate(outAttTable, (*iterCols).name, (*iterCols).type, (*iterCols).usage);
+                    outRATCols.push_back((*iterCols).name);
                 }
+                delete inRATCols;
+                GDALClose(inImage);
                 
-                imageOffset += (numClumps-1);
+                attUtils.findColumnIndexOrCreate(outAttTable, "Red", GFT_Integer, GFU_Red);
+                attUtils.findColumnIndexOrCreate(outAttTable, "Green", GFT_Integer, GFU_Green);
+                attUtils.findColumnIndexOrCreate(outAttTable, "Blue", GFT_Integer, GFU_Blue);
+                attUtils.findColumnIndexOrCreate(outAttTable, "Alpha", GFT_Integer, GFU_Alpha);
+                attUtils.findColumnIndexOrCreate(outAttTable, "Histogram", GFT_Integer, GFU_PixelCount);
                 
-                GDALClose(inImage);
+                // Size the output RAT once rather than for each image.
+                outAttTable->SetRowCount(ratOffset);
             }
+            
+            std::cout << "Merging the clumps\n";
+            this->processTiles(&tiles, true, &ioMutex, [this, outputDataset, outAttTable, mergeRATs, &outRATCols, &ioMutex](RSGISMergeTileInfo *tile, GDALDataset *tileDataset)
+            {
+                GDALRasterAttributeTable *attTable = NULL;
+                {
+                    std::lock_guard<std::mutex> ioLock(ioMutex);
+                    attTable = this->getTileRAT(tileDataset, tile);
+                    this->numberClumps(attTable, "GlobalClumpID", tile->clumpsOffset);
+                }
+                this->addImageClumps(outputDataset, tileDataset, attTable, "GlobalClumpID", &ioMutex);
+                if(mergeRATs)
+                {
+                    this->copyTileRATColumns(attTable, outAttTable, &outRATCols, tile->firstRATRow, tile->ratOffset, &ioMutex);
+                }
+            });
         }
         catch (rsgis::img::RSGISImageCalcException &e)
         {
@@ -266,6 +287,160 @@ namespace rsgis{namespace segment{
         }
     }
     
+    void RSGISMergeSegmentationTiles::initTiles(std::vector<RSGISMergeTileInfo> *tiles, std::vector<std::string> inputImagePaths)
+    {
+        tiles->clear();
+        tiles->reserve(inputImagePaths.size());
+        for(std::vector<std::string>::iterator iterFiles = inputImagePaths.begin(); iterFiles != inputImagePaths.end(); ++iterFiles)
+        {
+            RSGISMergeTileInfo tile;
+            tile.path = (*iterFiles);
+            tile.numRows = 0;
+            tile.numClumps = 0;
+            tile.clumpsOffset = 0;
+            tile.ratOffset = 0;
+            tile.firstRATRow = 0;
+            tile.xOff = 0;
+            tile.yOff = 0;
+            tile.width = 0;
+            tile.height = 0;
+            tiles->push_back(tile);
+        }
+    }
+    
+    GDALRasterAttributeTable* RSGISMergeSegmentationTiles::getTileRAT(GDALDataset *tileDataset, RSGISMergeTileInfo *tile)
+    {
+        GDALRasterAttributeTable *attTable = tileDataset->GetRasterBand(1)->GetDefaultRAT();
+        if(attTable == NULL)
+        {
+            throw RSGISImageException("Input image does not have an attribute table.");
+        }
+        tile->numRows = attTable->GetRowCount();
+        return attTable;
+    }
+    
+    void RSGISMergeSegmentationTiles::checkTileClumpIDs(GDALDataset *tileDataset, RSGISMergeTileInfo *tile)
+    {
+        rsgis::rastergis::RSGISRasterAttUtils attUtils;
+        long minVal = 0;
+        long maxVal = 0;
+        attUtils.getImageBandMinMax(tileDataset, 1, &minVal, &maxVal);
+        if((minVal < 0) || (((size_t)maxVal) >= tile->numRows))
+        {
+            throw RSGISImageException("Number of rows and maximum image pixel value does not match.");
+        }
+    }
+    
+    void RSGISMergeSegmentationTiles::findTileWindow(GDALDataset *outputDataset, GDALDataset *tileDataset, RSGISMergeTileInfo *tile, std::mutex *ioMutex)
+    {
+        rsgis::img::RSGISImageUtils imgUtils;
+        GDALDataset *datasets[2] = {tileDataset, outputDataset};
+        int offsets[2][2] = {{0, 0}, {0, 0}};
+        int *dsOffsets[2] = {offsets[0], offsets[1]};
+        double gdalTranslation[6];
+        std::lock_guard<std::mutex> ioLock(*ioMutex);
+        imgUtils.getImageOverlap(datasets, 2, dsOffsets, &tile->width, &tile->height, gdalTranslation);
+        tile->xOff = offsets[1][0];
+        tile->yOff = offsets[1][1];
+    }
+    
+    bool RSGISMergeSegmentationTiles::tileWindowsOverlap(const RSGISMergeTileInfo &tile1, const RSGISMergeTileInfo &tile2)
+    {
+        return (tile1.xOff < (tile2.xOff + tile2.width)) && (tile2.xOff < (tile1.xOff + tile1.width)) && (tile1.yOff < (tile2.yOff + tile2.height)) && (tile2.yOff < (tile1.yOff + tile1.height));
+    }
+    
+    void RSGISMergeSegmentationTiles::processTiles(std::vector<RSGISMergeTileInfo> *tiles, bool orderOverlapping, std::mutex *ioMutex, std::function<void(RSGISMergeTileInfo*, GDALDataset*)> processTile)
+    {
+        size_t numTiles = tiles->size();
+        if(numTiles == 0)
+        {
+            return;
+        }
+        
+        // Tiles are taken in order; if orderOverlapping a tile waits until every
+        // earlier tile whose output window overlaps it has been completed so the
+        // result is the same as merging the tiles one at a time.
+        std::vector<bool> tileDone(numTiles, false);
+        std::mutex doneMutex;
+        std::condition_variable doneCond;
+        std::atomic<bool> failed(false);
+        size_t numTilesDone = 0;
+        rsgis_tqdm pbar;
+        
+        try
+        {
+            rsgis::utils::parallelFor(numTiles, this->numThreads, [&](size_t tileIdx, unsigned int)
+            {
+                try
+                {
+                    RSGISMergeTileInfo *tile = &tiles->at(tileIdx);
+                    if(orderOverlapping)
+                    {
+                        std::unique_lock<std::mutex> doneLock(doneMutex);
+                        for(size_t t = 0; (t < tileIdx) && (!failed); ++t)
+                        {
+                            if(this->tileWindowsOverlap(tiles->at(t), *tile))
+                            {
+                                doneCond.wait(doneLock, [&tileDone, &failed, t]{return tileDone[t] || failed;});
+                            }
+                        }
+                    }
+                    if(failed)
+                    {
+                        return;
+                    }
+                    
+                    GDALDataset *tileDataset = NULL;
+                    {
+                        std::lock_guard<std::mutex> ioLock(*ioMutex);
+                        tileDataset = (GDALDataset *) GDALOpen(tile->path.c_str(), GA_Update);
+                    }
+                    if(tileDataset == NULL)
+                    {
+                        std::string message = std::string("Could not open image ") + tile->path;
+                        throw rsgis::RSGISImageException(message.c_str());
+                    }
+                    try
+                    {
+                        processTile(tile, tileDataset);
+                    }
+                    catch(...)
+                    {
+                        std::lock_guard<std::mutex> ioLock(*ioMutex);
+                        GDALClose(tileDataset);
+                        throw;
+                    }
+                    {
+                        std::lock_guard<std::mutex> ioLock(*ioMutex);
+                        GDALClose(tileDataset);
+                    }
+                    
+                    std::lock_guard<std::mutex> doneLock(doneMutex);
+                    tileDone[tileIdx] = true;
+                    ++numTilesDone;
+                    pbar.progress(numTilesDone, numTiles);
+                }
+                catch(...)
+                {
+                    // Wake any workers waiting on an earlier tile.
+                    {
+                        std::lock_guard<std::mutex> doneLock(doneMutex);
+                        failed = true;
+                    }
+                    doneCond.notify_all();
+                    throw;
+                }
+                doneCond.notify_all();
+            });
+        }
+        catch(...)
+        {
+            pbar.finish();
+            throw;
+        }
+        pbar.finish();
+    }
+    
     size_t RSGISMergeSegmentationTiles::numberBodyClumps(GDALRasterAttributeTable *gdalATT, std::string outColName, std::string clumpPosColName, int tileBody, size_t clumpsOffset)
     {
         size_t numBodyClumps = 0;
@@ -295,6 +470,8 @@ namespace rsgis{namespace segment{
             
             attUtils.writeIntColumn(gdalATT, outColName, colVals, numRows);
             
+            delete[] colVals;
+            delete[] posVals;
         }
         catch (rsgis::RSGISException &e)
         {
@@ -310,7 +487,6 @@ namespace rsgis{namespace segment{
     
     size_t RSGISMergeSegmentationTiles::numberClumps(GDALRasterAttributeTable *gdalATT, std::string outColName, size_t clumpsOffset)
     {
-        rsgis::rastergis::RSGISRasterAttUtils attUtils;
         size_t numClumps = 0;
         try
         {
@@ -326,6 +502,7 @@ namespace rsgis{namespace segment{
             rsgis::rastergis::RSGISRasterAttUtils attUtils;
             attUtils.writeIntColumn(gdalATT, outColName, colVals, numRows);
             
+            delete[] colVals;
         }
         catch (rsgis::RSGISException &e)
         {
@@ -339,188 +516,91 @@ namespace rsgis{namespace segment{
         return numClumps;
     }
     
-    void RSGISMergeSegmentationTiles::addTileBodyClumps(GDALDataset *outputDataset, GDALDataset *tileDataset, GDALDataset *borderMaskDataset, GDALRasterAttributeTable *gdalATT, std::string outClumpIDColName, std::string clumpPosColName, unsigned int tileBody, unsigned int tileBoundary) 
+    void RSGISMergeSegmentationTiles::addTileBodyClumps(GDALDataset *outputDataset, GDALDataset *tileDataset, GDALDataset *borderMaskDataset, GDALRasterAttributeTable *gdalATT, std::string outClumpIDColName, std::string clumpPosColName, unsigned int tileBody, unsigned int tileBoundary, std::mutex *ioMutex) 
     {
         rsgis::img::RSGISImageUtils imgUtils;
         try
         {
-            GDALDataset **datasets = new GDALDataset*[3];
-            datasets[0] = tileDataset;
-            datasets[1] = outputDataset;
-            datasets[2] = borderMaskDataset;
-            
-            double *gdalTranslation = new double[6];
-            int **dsOffsets = new int*[3];
-            for(int i = 0; i < 3; i++)
-            {
-                dsOffsets[i] = new int[2];
-            }
+            GDALDataset *datasets[3] = {tileDataset, outputDataset, borderMaskDataset};
+            int offsets[3][2] = {{0, 0}, {0, 0}, {0, 0}};
+            int *dsOffsets[3] = {offsets[0], offsets[1], offsets[2]};
+            double gdalTranslation[6];
             int height = 0;
             int width = 0;
-            
             int xBlockSize = 0;
             int yBlockSize = 0;
-            
-            imgUtils.getImageOverlap(datasets, 3, dsOffsets, &width, &height, gdalTranslation, &xBlockSize, &yBlockSize);
+            {
+                std::lock_guard<std::mutex> ioLock(*ioMutex);
+                imgUtils.getImageOverlap(datasets, 3, dsOffsets, &width, &height, gdalTranslation, &xBlockSize, &yBlockSize);
+            }
             
             GDALRasterBand *outputBand = outputDataset->GetRasterBand(1);
             GDALRasterBand *clumpsBand = tileDataset->GetRasterBand(1);
             GDALRasterBand *maskBand = borderMaskDataset->GetRasterBand(1);
-                        
-            int *inOffset = new int[2];
-            inOffset[0] = dsOffsets[0][0];
-            inOffset[1] = dsOffsets[0][1];
-            
-            int *outOffset = new int[2];
-            outOffset[0] = dsOffsets[1][0];
-            outOffset[1] = dsOffsets[1][1];
-            
-            int *maskOffset = new int[2];
-            maskOffset[0] = dsOffsets[2][0];
-            maskOffset[1] = dsOffsets[2][1];
-            
-            unsigned int *imgInData = (unsigned int *) CPLMalloc(sizeof(unsigned int)*width*yBlockSize);
-            unsigned int *imgOutData = (unsigned int *) CPLMalloc(sizeof(unsigned int)*width*yBlockSize);
-            unsigned int *imgMaskData = (unsigned int *) CPLMalloc(sizeof(unsigned int)*width*yBlockSize);
-            
-            int nYBlocks = height / yBlockSize;
-            int remainRows = height - (nYBlocks * yBlockSize);
-            int rowOffset = 0;
             
             // read existing column values
             rsgis::rastergis::RSGISRasterAttUtils attUtils;
             size_t numRows = 0;
-            int *posVals = attUtils.readIntColumn(gdalATT, clumpPosColName, &numRows);
-            int *clumpIdVals = attUtils.readIntColumn(gdalATT, outClumpIDColName, &numRows);
-            size_t fid = 0;
+            int *posVals = NULL;
+            int *clumpIdVals = NULL;
+            {
+                std::lock_guard<std::mutex> ioLock(*ioMutex);
+                posVals = attUtils.readIntColumn(gdalATT, clumpPosColName, &numRows);
+                clumpIdVals = attUtils.readIntColumn(gdalATT, outClumpIDColName, &numRows);
+            }
             
-			rsgis_tqdm pbar;
-			// Loop images to process data
-			for(int i = 0; i < nYBlocks; i++)
-			{
-				rowOffset = inOffset[1] + (yBlockSize * i);
-                clumpsBand->RasterIO(GF_Read, inOffset[0], rowOffset, width, yBlockSize, imgInData, width, yBlockSize, GDT_UInt32, 0, 0);
-                rowOffset = outOffset[1] + (yBlockSize * i);
-                outputBand->RasterIO(GF_Read, outOffset[0], rowOffset, width, yBlockSize, imgOutData, width, yBlockSize, GDT_UInt32, 0, 0);
-                rowOffset = maskOffset[1] + (yBlockSize * i);
-                maskBand->RasterIO(GF_Read, maskOffset[0], rowOffset, width, yBlockSize, imgMaskData, width, yBlockSize, GDT_UInt32, 0, 0);
-                
-                for(int m = 0; m < yBlockSize; ++m)
+            std::vector<unsigned int> imgInData(((size_t)width)*yBlockSize);
+            std::vector<unsigned int> imgOutData(((size_t)width)*yBlockSize);
+            std::vector<unsigned int> imgMaskData(((size_t)width)*yBlockSize);
+            
+            try
+            {
+                for(int rowOffset = 0; rowOffset < height; rowOffset += yBlockSize)
                 {
-                    pbar.progress((i*yBlockSize)+m, height);
+                    int nRows = std::min(yBlockSize, height - rowOffset);
+                    size_t nPxls = ((size_t)width)*nRows;
                     
-                    for(int j = 0; j < width; j++)
                     {
-                        if((imgInData[(m*width)+j] > 0) & (imgInData[(m*width)+j] < numRows))
-                        {
-                            try
-                            {
-                                fid = boost::lexical_cast<size_t>(imgInData[(m*width)+j]);
-                            }
-                            catch(boost::numeric::negative_overflow& e)
-                            {
-                                std::cout << "imgInData[" << (m*width)+j << "] = " << imgInData[(m*width)+j] << std::endl;
-                                throw rsgis::img::RSGISImageCalcException(e.what());
-                            }
-                            catch(boost::numeric::positive_overflow& e)
-                            {
-                                std::cout << "imgInData[" << (m*width)+j << "] = " << imgInData[(m*width)+j] << std::endl;
-                                throw rsgis::img::RSGISImageCalcException(e.what());
-                            }
-                            catch(boost::numeric::bad_numeric_cast& e)
-                            {
-                                std::cout << "imgInData[" << (m*width)+j << "] = " << imgInData[(m*width)+j] << std::endl;
-                                throw rsgis::img::RSGISImageCalcException(e.what());
-                            }
-                            
-                            if(posVals[fid] == tileBody)
-                            {
-                                imgOutData[(m*width)+j] = clumpIdVals[fid];
-                            }
-                            else if(posVals[fid] == tileBoundary)
-                            {
-                                imgMaskData[(m*width)+j] = 1;
-                            }
-                            
-                        }
+                        std::lock_guard<std::mutex> ioLock(*ioMutex);
+                        clumpsBand->RasterIO(GF_Read, offsets[0][0], offsets[0][1] + rowOffset, width, nRows, imgInData.data(), width, nRows, GDT_UInt32, 0, 0);
+                        outputBand->RasterIO(GF_Read, offsets[1][0], offsets[1][1] + rowOffset, width, nRows, imgOutData.data(), width, nRows, GDT_UInt32, 0, 0);
+                        maskBand->RasterIO(GF_Read, offsets[2][0], offsets[2][1] + rowOffset, width, nRows, imgMaskData.data(), width, nRows, GDT_UInt32, 0, 0);
                     }
                     
-                }
-                
-                rowOffset = outOffset[1] + (yBlockSize * i);
-                outputBand->RasterIO(GF_Write, outOffset[0], rowOffset, width, yBlockSize, imgOutData, width, yBlockSize, GDT_UInt32, 0, 0);
-                rowOffset = maskOffset[1] + (yBlockSize * i);
-                maskBand->RasterIO(GF_Write, maskOffset[0], rowOffset, width, yBlockSize, imgMaskData, width, yBlockSize, GDT_UInt32, 0, 0);
-            }
-            
-            if(remainRows > 0)
-            {
-                rowOffset = inOffset[1] + (yBlockSize * nYBlocks);
-                clumpsBand->RasterIO(GF_Read, inOffset[0], rowOffset, width, remainRows, imgInData, width, remainRows, GDT_UInt32, 0, 0);
-                rowOffset = outOffset[1] + (yBlockSize * nYBlocks);
-                outputBand->RasterIO(GF_Read, outOffset[0], rowOffset, width, remainRows, imgOutData, width, remainRows, GDT_UInt32, 0, 0);
-                rowOffset = maskOffset[1] + (yBlockSize * nYBlocks);
-                maskBand->RasterIO(GF_Read, maskOffset[0], rowOffset, width, remainRows, imgMaskData, width, remainRows, GDT_UInt32, 0, 0);
-                
-                for(int m = 0; m < remainRows; ++m)
-                {
-                    pbar.progress((nYBlocks*yBlockSize)+m, height);
-                    
-                    for(int j = 0; j < width; j++)
+                    for(size_t j = 0; j < nPxls; ++j)
                     {
-                        if((imgInData[(m*width)+j] > 0) & (imgInData[(m*width)+j] < numRows))
+                        size_t fid = imgInData[j];
+                        if(fid >= numRows)
+                        {
+                            throw RSGISImageException("Number of rows and maximum image pixel value does not match.");
+                        }
+                        else if(fid > 0)
                         {
-                            try
-                            {
-                                fid = boost::lexical_cast<size_t>(imgInData[(m*width)+j]);
-                            }
-                            catch(boost::numeric::negative_overflow& e)
-                            {
-                                std::cout << "imgInData[" << (m*width)+j << "] = " << imgInData[(m*width)+j] << std::endl;
-                                throw rsgis::img::RSGISImageCalcException(e.what());
-                            }
-                            catch(boost::numeric::positive_overflow& e)
-                            {
-                                std::cout << "imgInData[" << (m*width)+j << "] = " << imgInData[(m*width)+j] << std::endl;
-                                throw rsgis::img::RSGISImageCalcException(e.what());
-                            }
-                            catch(boost::numeric::bad_numeric_cast& e)
-                            {
-                                std::cout << "imgInData[" << (m*width)+j << "] = " << imgInData[(m*width)+j] << std::endl;
-                                throw rsgis::img::RSGISImageCalcException(e.what());
-                            }
-                            
                             if(posVals[fid] == tileBody)
                             {
-                                imgOutData[(m*width)+j] = clumpIdVals[fid];
+                                imgOutData[j] = clumpIdVals[fid];
                             }
                             else if(posVals[fid] == tileBoundary)
                             {
-                                imgMaskData[(m*width)+j] = 1;
+                                imgMaskData[j] = 1;
                             }
                         }
                     }
+                    
+                    {
+                        std::lock_guard<std::mutex> ioLock(*ioMutex);
+                        outputBand->RasterIO(GF_Write, offsets[1][0], offsets[1][1] + rowOffset, width, nRows, imgOutData.data(), width, nRows, GDT_UInt32, 0, 0);
+                        maskBand->RasterIO(GF_Write, offsets[2][0], offsets[2][1] + rowOffset, width, nRows, imgMaskData.data(), width, nRows, GDT_UInt32, 0, 0);
+                    }
                 }
-                
-                rowOffset = outOffset[1] + (yBlockSize * nYBlocks);
-                outputBand->RasterIO(GF_Write, outOffset[0], rowOffset, width, remainRows, imgOutData, width, remainRows, GDT_UInt32, 0, 0);
-                rowOffset = maskOffset[1] + (yBlockSize * nYBlocks);
-                maskBand->RasterIO(GF_Write, maskOffset[0], rowOffset, width, remainRows, imgMaskData, width, remainRows, GDT_UInt32, 0, 0);
             }
-            pbar.finish();
-            
-            CPLFree(imgInData);
-            CPLFree(imgOutData);
-            CPLFree(imgMaskData);
-            delete[] outOffset;
-            delete[] inOffset;
-            delete[] maskOffset;
-            delete[] gdalTranslation;
-            for(int i = 0; i < 3; i++)
+            catch(...)
             {
-                delete[] dsOffsets[i];
+                delete[] posVals;
+                delete[] clumpIdVals;
+                throw;
             }
-            delete[] dsOffsets;
+            
             delete[] posVals;
             delete[] clumpIdVals;
         }
@@ -725,156 +805,77 @@ namespace rsgis{namespace segment{
         }
     }
     
-    void RSGISMergeSegmentationTiles::addImageClumps(GDALDataset *outputDataset, GDALDataset *clumpsDataset, GDALRasterAttributeTable *gdalATT, std::string outClumpIDColName) 
+    void RSGISMergeSegmentationTiles::addImageClumps(GDALDataset *outputDataset, GDALDataset *clumpsDataset, GDALRasterAttributeTable *gdalATT, std::string outClumpIDColName, std::mutex *ioMutex) 
     {
         rsgis::img::RSGISImageUtils imgUtils;
         try
         {
-            GDALDataset **datasets = new GDALDataset*[2];
-            datasets[0] = clumpsDataset;
-            datasets[1] = outputDataset;
-            
-            double *gdalTranslation = new double[6];
-            int **dsOffsets = new int*[2];
-            for(int i = 0; i < 2; i++)
-            {
-                dsOffsets[i] = new int[2];
-            }
+            GDALDataset *datasets[2] = {clumpsDataset, outputDataset};
+            int offsets[2][2] = {{0, 0}, {0, 0}};
+            int *dsOffsets[2] = {offsets[0], offsets[1]};
+            double gdalTranslation[6];
             int height = 0;
             int width = 0;
-            
             int xBlockSize = 0;
             int yBlockSize = 0;
-            
-            imgUtils.getImageOverlap(datasets, 2, dsOffsets, &width, &height, gdalTranslation, &xBlockSize, &yBlockSize);
+            {
+                std::lock_guard<std::mutex> ioLock(*ioMutex);
+                imgUtils.getImageOverlap(datasets, 2, dsOffsets, &width, &height, gdalTranslation, &xBlockSize, &yBlockSize);
+            }
             
             GDALRasterBand *outputBand = outputDataset->GetRasterBand(1);
             GDALRasterBand *clumpsBand = clumpsDataset->GetRasterBand(1);
             
-            int *inOffset = new int[2];
-            inOffset[0] = dsOffsets[0][0];
-            inOffset[1] = dsOffsets[0][1];
-            
-            int *outOffset = new int[2];
-            outOffset[0] = dsOffsets[1][0];
-            outOffset[1] = dsOffsets[1][1];
-            
-            unsigned int *imgInData = (unsigned int *) CPLMalloc(sizeof(unsigned int)*width*yBlockSize);
-            unsigned int *imgOutData = (unsigned int *) CPLMalloc(sizeof(unsigned int)*width*yBlockSize);
-            
-            int nYBlocks = height / yBlockSize;
-            int remainRows = height - (nYBlocks * yBlockSize);
-            int rowOffset = 0;
-            
             // read existing column values
             rsgis::rastergis::RSGISRasterAttUtils attUtils;
             size_t numRows = 0;
-            int *clumpIdVals = attUtils.readIntColumn(gdalATT, outClumpIDColName, &numRows);
-            size_t fid = 0;
+            int *clumpIdVals = NULL;
+            {
+                std::lock_guard<std::mutex> ioLock(*ioMutex);
+                clumpIdVals = attUtils.readIntColumn(gdalATT, outClumpIDColName, &numRows);
+            }
             
-			rsgis_tqdm pbar;
-			// Loop images to process data
-			for(int i = 0; i < nYBlocks; i++)
-			{
-				rowOffset = inOffset[1] + (yBlockSize * i);
-                clumpsBand->RasterIO(GF_Read, inOffset[0], rowOffset, width, yBlockSize, imgInData, width, yBlockSize, GDT_UInt32, 0, 0);
-                rowOffset = outOffset[1] + (yBlockSize * i);
-                outputBand->RasterIO(GF_Read, outOffset[0], rowOffset, width, yBlockSize, imgOutData, width, yBlockSize, GDT_UInt32, 0, 0);
-                
-                for(int m = 0; m < yBlockSize; ++m)
+            std::vector<unsigned int> imgInData(((size_t)width)*yBlockSize);
+            std::vector<unsigned int> imgOutData(((size_t)width)*yBlockSize);
+            
+            try
+            {
+                for(int rowOffset = 0; rowOffset < height; rowOffset += yBlockSize)
                 {
-                    pbar.progress((i*yBlockSize)+m, height);
+                    int nRows = std::min(yBlockSize, height - rowOffset);
+                    size_t nPxls = ((size_t)width)*nRows;
                     
-                    for(int j = 0; j < width; j++)
                     {
-                        if((imgInData[(m*width)+j] > 0) & (imgInData[(m*width)+j] < numRows))
-                        {
-                            try
-                            {
-                                fid = boost::lexical_cast<size_t>(imgInData[(m*width)+j]);
-                            }
-                            catch(boost::numeric::negative_overflow& e)
-                            {
-                                std::cout << "imgInData[" << (m*width)+j << "] = " << imgInData[(m*width)+j] << std::endl;
-                                throw rsgis::img::RSGISImageCalcException(e.what());
-                            }
-                            catch(boost::numeric::positive_overflow& e)
-                            {
-                                std::cout << "imgInData[" << (m*width)+j << "] = " << imgInData[(m*width)+j] << std::endl;
-                                throw rsgis::img::RSGISImageCalcException(e.what());
-                            }
-                            catch(boost::numeric::bad_numeric_cast& e)
-                            {
-                                std::cout << "imgInData[" << (m*width)+j << "] = " << imgInData[(m*width)+j] << std::endl;
-                                throw rsgis::img::RSGISImageCalcException(e.what());
-                            }
-                            
-                            imgOutData[(m*width)+j] = clumpIdVals[fid];
-                            
-                        }
+                        std::lock_guard<std::mutex> ioLock(*ioMutex);
+                        clumpsBand->RasterIO(GF_Read, offsets[0][0], offsets[0][1] + rowOffset, width, nRows, imgInData.data(), width, nRows, GDT_UInt32, 0, 0);
+                        outputBand->RasterIO(GF_Read, offsets[1][0], offsets[1][1] + rowOffset, width, nRows, imgOutData.data(), width, nRows, GDT_UInt32, 0, 0);
                     }
                     
-                }
-                
-                rowOffset = outOffset[1] + (yBlockSize * i);
-                outputBand->RasterIO(GF_Write, outOffset[0], rowOffset, width, yBlockSize, imgOutData, width, yBlockSize, GDT_UInt32, 0, 0);
-            }
-            
-            if(remainRows > 0)
-            {
-                rowOffset = inOffset[1] + (yBlockSize * nYBlocks);
-                clumpsBand->RasterIO(GF_Read, inOffset[0], rowOffset, width, remainRows, imgInData, width, remainRows, GDT_UInt32, 0, 0);
-                rowOffset = outOffset[1] + (yBlockSize * nYBlocks);
-                outputBand->RasterIO(GF_Read, outOffset[0], rowOffset, width, remainRows, imgOutData, width, remainRows, GDT_UInt32, 0, 0);
-                
-                for(int m = 0; m < remainRows; ++m)
-                {
-                    pbar.progress((nYBlocks*yBlockSize)+m, height);
-                    
-                    for(int j = 0; j < width; j++)
+                    for(size_t j = 0; j < nPxls; ++j)
                     {
-                        if((imgInData[(m*width)+j] > 0) & (imgInData[(m*width)+j] < numRows))
+                        size_t fid = imgInData[j];
+                        if(fid >= numRows)
                         {
-                            try
-                            {
-                                fid = boost::lexical_cast<size_t>(imgInData[(m*width)+j]);
-                            }
-                            catch(boost::numeric::negative_overflow& e)
-                            {
-                                std::cout << "imgInData[" << (m*width)+j << "] = " << imgInData[(m*width)+j] << std::endl;
-                                throw rsgis::img::RSGISImageCalcException(e.what());
-                            }
-                            catch(boost::numeric::positive_overflow& e)
-                            {
-                                std::cout << "imgInData[" << (m*width)+j << "] = " << imgInData[(m*width)+j] << std::endl;
-                                throw rsgis::img::RSGISImageCalcException(e.what());
-                            }
-                            catch(boost::numeric::bad_numeric_cast& e)
-                            {
-                                std::cout << "imgInData[" << (m*width)+j << "] = " << imgInData[(m*width)+j] << std::endl;
-                                throw rsgis::img::RSGISImageCalcException(e.what());
-                            }
-                            
-                            imgOutData[(m*width)+j] = clumpIdVals[fid];
+                            throw RSGISImageException("Number of rows and maximum image pixel value does not match.");
+                        }
+                        else if(fid > 0)
+                        {
+                            imgOutData[j] = clumpIdVals[fid];
                         }
                     }
+                    
+                    {
+                        std::lock_guard<std::mutex> ioLock(*ioMutex);
+                        outputBand->RasterIO(GF_Write, offsets[1][0], offsets[1][1] + rowOffset, width, nRows, imgOutData.data(), width, nRows, GDT_UInt32, 0, 0);
+                    }
                 }
-                
-                rowOffset = outOffset[1] + (yBlockSize * nYBlocks);
-                outputBand->RasterIO(GF_Write, outOffset[0], rowOffset, width, remainRows, imgOutData, width, remainRows, GDT_UInt32, 0, 0);
             }
-            pbar.finish();
-            
-            CPLFree(imgInData);
-            CPLFree(imgOutData);
-            delete[] outOffset;
-            delete[] inOffset;
-            delete[] gdalTranslation;
-            for(int i = 0; i < 2; i++)
+            catch(...)
             {
-                delete[] dsOffsets[i];
+                delete[] clumpIdVals;
+                throw;
             }
-            delete[] dsOffsets;
+            
             delete[] clumpIdVals;
         }
         catch(rsgis::img::RSGISImageCalcException& e)
@@ -899,6 +900,133 @@ namespace rsgis{namespace segment{
         }
     }
     
+    void RSGISMergeSegmentationTiles::copyTileRATColumns(GDALRasterAttributeTable *inRAT, GDALRasterAttributeTable *outRAT, std::vector<std::string> *fields, size_t firstRow, size_t outRowOffset, std::mutex *ioMutex)
+    {
+        rsgis::rastergis::RSGISRasterAttUtils attUtils;
+        
+        // As copyAttColumnsWithOff, the fields are required but the colour
+        // (not alpha) and histogram columns are only copied if present.
+        std::vector<int> colInIdxs;
+        std::vector<int> colOutIdxs;
+        std::vector<GDALRATFieldType> colTypes;
+        size_t numRows = 0;
+        {
+            std::lock_guard<std::mutex> ioLock(*ioMutex);
+            for(std::vector<std::string>::iterator iterCols = fields->begin(); iterCols != fields->end(); ++iterCols)
+            {
+                colInIdxs.push_back(attUtils.findColumnIndex(inRAT, *iterCols));
+                colOutIdxs.push_back(attUtils.findColumnIndex(outRAT, *iterCols));
+            }
+            const char *optCols[4] = {"Red", "Green", "Blue", "Histogram"};
+            for(int i = 0; i < 4; ++i)
+            {
+                if(std::find(fields->begin(), fields->end(), std::string(optCols[i])) != fields->end())
+                {
+                    continue;
+                }
+                try
+                {
+                    int inIdx = attUtils.findColumnIndex(inRAT, optCols[i]);
+                    colOutIdxs.push_back(attUtils.findColumnIndex(outRAT, optCols[i]));
+                    colInIdxs.push_back(inIdx);
+                }
+                catch (rsgis::RSGISAttributeTableException &e)
+                {
+                    // Column not in the tile so not copied.
+                }
+            }
+            
+            for(size_t j = 0; j < colInIdxs.size(); ++j)
+            {
+                colTypes.push_back(inRAT->GetTypeOfCol(colInIdxs[j]));
+                if((colTypes[j] != GFT_Integer) && (colTypes[j] != GFT_Real) && (colTypes[j] != GFT_String))
+                {
+                    throw rsgis::RSGISAttributeTableException("Column data type was not recognised.");
+                }
+            }
+            
+            numRows = inRAT->GetRowCount();
+        }
+        size_t numCols = colInIdxs.size();
+        if(numRows <= firstRow)
+        {
+            return;
+        }
+        
+        // A block of every column is read from the tile and written to the
+        // output holding the lock once per block.
+        size_t blockLen = std::min<size_t>(RAT_BLOCK_LENGTH, numRows - firstRow);
+        std::vector<std::vector<int> > blockDataInt(numCols);
+        std::vector<std::vector<double> > blockDataReal(numCols);
+        std::vector<std::vector<char*> > blockDataStr(numCols);
+        for(size_t j = 0; j < numCols; ++j)
+        {
+            if(colTypes[j] == GFT_Integer)
+            {
+                blockDataInt[j].resize(blockLen);
+            }
+            else if(colTypes[j] == GFT_Real)
+            {
+                blockDataReal[j].resize(blockLen);
+            }
+            else
+            {
+                blockDataStr[j].assign(blockLen, NULL);
+            }
+        }
+        
+        for(size_t rowOffset = firstRow; rowOffset < numRows; rowOffset += blockLen)
+        {
+            int nRows = std::min(blockLen, numRows - rowOffset);
+            int outRow = outRowOffset + (rowOffset - firstRow);
+            {
+                std::lock_guard<std::mutex> ioLock(*ioMutex);
+                for(size_t j = 0; j < numCols; ++j)
+                {
+                    if(colTypes[j] == GFT_Integer)
+                    {
+                        inRAT->ValuesIO(GF_Read, colInIdxs[j], rowOffset, nRows, blockDataInt[j].data());
+                    }
+                    else if(colTypes[j] == GFT_Real)
+                    {
+                        inRAT->ValuesIO(GF_Read, colInIdxs[j], rowOffset, nRows, blockDataReal[j].data());
+                    }
+                    else
+                    {
+                        inRAT->ValuesIO(GF_Read, colInIdxs[j], rowOffset, nRows, blockDataStr[j].data());
+                    }
+                }
+                for(size_t j = 0; j < numCols; ++j)
+                {
+                    if(colTypes[j] == GFT_Integer)
+                    {
+                        outRAT->ValuesIO(GF_Write, colOutIdxs[j], outRow, nRows, blockDataInt[j].data());
+                    }
+                    else if(colTypes[j] == GFT_Real)
+                    {
+                        outRAT->ValuesIO(GF_Write, colOutIdxs[j], outRow, nRows, blockDataReal[j].data());
+                    }
+                    else
+                    {
+                        outRAT->ValuesIO(GF_Write, colOutIdxs[j], outRow, nRows, blockDataStr[j].data());
+                    }
+                }
+            }
+            
+            for(size_t j = 0; j < numCols; ++j)
+            {
+                if(colTypes[j] == GFT_String)
+                {
+                    for(int i = 0; i < nRows; ++i)
+                    {
+                        CPLFree(blockDataStr[j][i]);
+                        blockDataStr[j][i] = NULL;
+                    }
+                }
+            }
+        }
+    }
+    
     RSGISMergeSegmentationTiles::~RSGISMergeSegmentationTiles()
     {
         
@@ -906,5 +1034,3 @@ namespace rsgis{namespace segment{
     
     
 }}
-
-
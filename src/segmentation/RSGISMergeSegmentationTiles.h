@@ -27,6 +27,14 @@
 #include <string>
 #include <math.h>
 #include <stdlib.h>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
 
 #include "common/rsgis-tqdm.h"
 
@@ -38,6 +46,7 @@
 #include "img/RSGISCalcImage.h"
 
 #include "common/RSGISAttributeTableException.h"
+#include "common/RSGISParallel.h"
 
 #include "rastergis/RSGISRasterAttUtils.h"
 
@@ -59,20 +68,62 @@
 
 namespace rsgis{namespace segment{
 
+    /**
+     * Merges segmentation tiles into a single clumps image. The tiles are
+     * processed concurrently (RSGISLIB_NUM_THREADS or setNumThreads); the
+     * clump IDs and RAT rows of each tile are allocated up front so the output
+     * is the same as merging the tiles one at a time, and tiles whose windows
+     * in the output overlap are still merged in the order given.
+     */
     class DllExport RSGISMergeSegmentationTiles
     {
     public:
         RSGISMergeSegmentationTiles();
+        /**
+         * Set the number of tiles to process at once (0 uses the number of cores).
+         */
+        void setNumThreads(unsigned int numThreads);
         void createTileBorderClumpMask(GDALDataset *borderMaskDataset, std::vector<std::string> inputImagePaths, unsigned int tileBoundary, unsigned int tileOverlap, unsigned int tileBody, std::string colsName);
         void mergeClumpBodies(GDALDataset *outputDataset, GDALDataset *borderMaskDataset, std::vector<std::string> inputImagePaths, unsigned int tileBoundary, unsigned int tileOverlap, unsigned int tileBody, std::string colsName);
         void mergeClumpImages(GDALDataset *outputDataset, std::vector<std::string> inputImagePaths, bool mergeRATs=false);
         ~RSGISMergeSegmentationTiles();
     protected:
+        struct RSGISMergeTileInfo
+        {
+            std::string path;
+            size_t numRows;
+            size_t numClumps;
+            size_t clumpsOffset;
+            size_t ratOffset;
+            size_t firstRATRow;
+            int xOff;
+            int yOff;
+            int width;
+            int height;
+        };
+        void initTiles(std::vector<RSGISMergeTileInfo> *tiles, std::vector<std::string> inputImagePaths);
+        GDALRasterAttributeTable* getTileRAT(GDALDataset *tileDataset, RSGISMergeTileInfo *tile);
+        /**
+         * Check every pixel value of the tile is a row of its RAT (getTileRAT
+         * must have been called) so nothing is written for a tile which would fail.
+         */
+        void checkTileClumpIDs(GDALDataset *tileDataset, RSGISMergeTileInfo *tile);
+        void findTileWindow(GDALDataset *outputDataset, GDALDataset *tileDataset, RSGISMergeTileInfo *tile, std::mutex *ioMutex);
+        bool tileWindowsOverlap(const RSGISMergeTileInfo &tile1, const RSGISMergeTileInfo &tile2);
+        /**
+         * Open each tile (for update) and call processTile for it. If orderOverlapping
+         * a tile is not started until all the earlier tiles it overlaps are complete.
+         * GDAL is not thread safe so all GDAL calls, including those of processTile
+         * on the tile, are made holding ioMutex; only the per-pixel work is concurrent.
+         */
+        void processTiles(std::vector<RSGISMergeTileInfo> *tiles, bool orderOverlapping, std::mutex *ioMutex, std::function<void(RSGISMergeTileInfo*, GDALDataset*)> processTile);
         size_t numberBodyClumps(GDALRasterAttributeTable *gdalATT, std::string outColName, std::string clumpPosColName, int tileBody, size_t clumpsOffset);
         size_t numberClumps(GDALRasterAttributeTable *gdalATT, std::string outColName, size_t clumpsOffset);
-        void addTileBodyClumps(GDALDataset *outputDataset, GDALDataset *tileDataset, GDALDataset *borderMaskDataset, GDALRasterAttributeTable *gdalATT, std::string outClumpIDColName, std::string clumpPosColName, unsigned int tileBody, unsigned int tileBoundary);
+        void addTileBodyClumps(GDALDataset *outputDataset, GDALDataset *tileDataset, GDALDataset *borderMaskDataset, GDALRasterAttributeTable *gdalATT, std::string outClumpIDColName, std::string clumpPosColName, unsigned int tileBody, unsigned int tileBoundary, std::mutex *ioMutex);
         void addTileBorder2Mask(GDALDataset *tileDataset, GDALDataset *borderMaskDataset, GDALRasterAttributeTable *gdalATT, std::string clumpPosColName, unsigned int tileBoundary);
-        void addImageClumps(GDALDataset *outputDataset, GDALDataset *clumpsDataset, GDALRasterAttributeTable *gdalATT, std::string outClumpIDColName);
+        void addImageClumps(GDALDataset *outputDataset, GDALDataset *clumpsDataset, GDALRasterAttributeTable *gdalATT, std::string outClumpIDColName, std::mutex *ioMutex);
+        void copyTileRATColumns(GDALRasterAttributeTable *inRAT, GDALRasterAttributeTable *outRAT, std::vector<std::string> *fields, size_t firstRow, size_t outRowOffset, std::mutex *ioMutex);
+        unsigned int numThreads;
     };
     
     
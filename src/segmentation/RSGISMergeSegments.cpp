@@ -35,8 +35,8 @@ namespace rsgis{namespace segment{
         try
         {
             std::cout << "Populate Neighbours\n";
-            rastergis::RSGISFindClumpNeighbours findNeighboursObj;
-            findNeighboursObj.findNeighboursKEAImageCalc(clumpsImage, 1);
+            rastergis::RSGISRegionAdjacencyGraph rag;
+            rag.readOrBuild(clumpsImage, 1, true);
             std::cout << "Populated Neighbours\n";
             
             std::cout << "Calculate Stats\n";
@@ -87,18 +87,9 @@ namespace rsgis{namespace segment{
             size_t numRows = rat->GetRowCount();
             std::cout << "Number of clumps is " << numRows << "\n";
             
-            std::cout << "Read in neighbours\n";
-            std::vector<std::vector<size_t>* > *neighbours = attUtils.getRATNeighbours(clumpsImage, 1);
-            
-            if(numRows != neighbours->size())
+            if(rag.getNumNodes() > numRows)
             {
-                for(std::vector<std::vector<size_t>* >::iterator iterNeigh = neighbours->begin(); iterNeigh != neighbours->end(); ++iterNeigh)
-                {
-                    delete *iterNeigh;
-                }
-                delete neighbours;
-                
-                throw rsgis::RSGISAttributeTableException("RAT size is different to the number of neighbours retrieved.");
+                throw rsgis::RSGISAttributeTableException("RAT size is smaller than the number of clumps in the neighbours graph.");
             }
             
             size_t tmpNumRows = 0;
@@ -106,214 +97,137 @@ namespace rsgis{namespace segment{
             int *noDataCol = attUtils.readIntColumn(rat, noDataClumpsCol, &tmpNumRows);
             std::cout << "Read input column\n";
             
-            double *numPxls = new double[numRows];
-            
-            double **meanVals = new double*[numSpecBands];
-            double **sumVals = new double*[numSpecBands];
-            
+            // The statistics of the clumps (row major, numSpecBands values per
+            // clump) which are updated in place as clumps are merged.
+            std::vector<double> meanVals(numRows*numSpecBands);
+            std::vector<double> sumVals(numRows*numSpecBands);
+            std::vector<double> numPxls(numRows);
             for(int i = 0; i < numSpecBands; ++i)
             {
                 tmpNumRows = 0;
-                meanVals[i] = attUtils.readDoubleColumn(rat, "Mean"+colNames.at(i), &tmpNumRows);
+                double *meanCol = attUtils.readDoubleColumn(rat, "Mean"+colNames.at(i), &tmpNumRows);
                 if(tmpNumRows != numRows)
                 {
+                    delete[] meanCol;
                     throw rsgis::img::RSGISImageCalcException("Number of rows was incorrect. (Mean)");
                 }
                 tmpNumRows = 0;
-                sumVals[i] = attUtils.readDoubleColumn(rat, "Sum"+colNames.at(i), &tmpNumRows);
+                double *sumCol = attUtils.readDoubleColumn(rat, "Sum"+colNames.at(i), &tmpNumRows);
                 if(tmpNumRows != numRows)
                 {
+                    delete[] meanCol;
+                    delete[] sumCol;
                     throw rsgis::img::RSGISImageCalcException("Number of rows was incorrect. (Sum)");
                 }
-            }
-            
-            
-            
-            std::vector<rsgisClumpInfo*> clumps;
-            for(size_t i = 0; i < numRows; ++i)
-            {
-                rsgisClumpInfo *clump = new rsgisClumpInfo();
-                clump->clumpID = i;
-                if(noDataCol[i] == 1)
+                for(size_t r = 0; r < numRows; ++r)
                 {
-                    clump->clumpID = 0;
+                    meanVals[(r*numSpecBands)+i] = meanCol[r];
+                    sumVals[(r*numSpecBands)+i] = sumCol[r];
                 }
-                clump->origClumpIDs.push_back(i);
-                clump->merge = false;
-                clump->removed = false;
-                clump->mergeTo = NULL;
-                clump->meanVals = new double[numSpecBands];
-                clump->sumVals = new double[numSpecBands];
-                clump->numVals = numSpecBands;
-                for(size_t j = 0; j < numSpecBands; ++j)
+                if(i == 0)
                 {
-                    clump->meanVals[j] = meanVals[j][i];
-                    clump->sumVals[j] = sumVals[j][i];
+                    for(size_t r = 0; r < numRows; ++r)
+                    {
+                        numPxls[r] = sumCol[r] / meanCol[r];
+                    }
                 }
-                clump->numPxls = sumVals[0][i] / meanVals[0][i];
-                clump->neighbours.clear();
-                clump->selected = selectCol[i];
-                clump->noDataRegion = noDataCol[i];
-                clumps.push_back(clump);
+                delete[] meanCol;
+                delete[] sumCol;
             }
-            for(size_t i = 0; i < numRows; ++i)
+            
+            // Selected clumps are merged into their spectrally closest neighbour
+            // which is neither selected nor no data, smallest distance first. The
+            // candidate edges are held in a min-heap; when a clump grows its
+            // version is incremented so the edges to it already in the heap are
+            // ignored when popped and edges with the new distance are pushed.
+            std::vector<bool> removed(numRows, false);
+            std::vector<unsigned int> version(numRows, 0);
+            std::vector<std::vector<unsigned int> > selectedNbrs(numRows);
+            std::vector<size_t> nbrMark(numRows, 0);
+            size_t markStamp = 0;
+            std::priority_queue<rsgisClumpMergeEdge, std::vector<rsgisClumpMergeEdge>, std::greater<rsgisClumpMergeEdge> > mergeHeap;
+            size_t numGraphNodes = rag.getNumNodes();
+            
+            for(size_t s = 0; s < numGraphNodes; ++s)
             {
-                for(size_t j = 0; j < neighbours->at(i)->size(); ++j)
+                if(selectCol[s] != 1)
                 {
-                    clumps.at(i)->neighbours.push_back(clumps.at(neighbours->at(i)->at(j)));
+                    continue;
+                }
+                const unsigned int *nbrs = rag.getNeighbours(s);
+                for(size_t n = 0; n < rag.getNumNeighbours(s); ++n)
+                {
+                    unsigned int u = nbrs[n];
+                    if((selectCol[u] != 1) & (noDataCol[u] != 1))
+                    {
+                        selectedNbrs[u].push_back(s);
+                        mergeHeap.push(rsgisClumpMergeEdge(this->calcDist(&meanVals[s*numSpecBands], &meanVals[((size_t)u)*numSpecBands], numSpecBands), s, u, 0));
+                    }
                 }
             }
             
-            
-            double val = 0.0;
-            bool process = true;
-            bool first = true;
-            rsgisClumpInfo *minClump = NULL;
-            double minVal = 0.0;
-            bool found = false;
-            unsigned int processIter = 1;
-            rsgisClumpInfo *cClump;
-            rsgisClumpInfo *mClump;
-            while(process)
+            std::cout << "Merging clumps\n";
+            size_t numMerges = 0;
+            while(!mergeHeap.empty())
             {
-                std::cout << "Processing Iteration " << processIter++ << std::endl;
-                process = false;
-                for(size_t i = 0; i < clumps.size(); ++i)
+                rsgisClumpMergeEdge edge = mergeHeap.top();
+                mergeHeap.pop();
+                if(removed[edge.selectedID] || (edge.version != version[edge.targetID]))
                 {
-                    cClump = clumps.at(i);
-                    if((cClump->selected == 1) & (!cClump->removed))
-                    {
-                        first = true;
-
-                        for(std::list<rsgisClumpInfo*>::iterator iterNeigh = cClump->neighbours.begin(); iterNeigh != cClump->neighbours.end(); ++iterNeigh)
-                        {
-                            if(((*iterNeigh)->selected != 1) & (!(*iterNeigh)->removed) & ((*iterNeigh)->noDataRegion != 1))
-                            {
-                                val = this->calcDist(cClump->meanVals, (*iterNeigh)->meanVals, numSpecBands);
-                                if(first)
-                                {
-                                    minClump = (*iterNeigh);
-                                    minVal = val;
-                                    first = false;
-                                }
-                                else if(val < minVal)
-                                {
-                                    minClump = (*iterNeigh);
-                                    minVal = val;
-                                }
-                            }
-                        }
-                        
-                        if(!first)
-                        {
-                            cClump->merge = true;
-                            cClump->mergeTo = minClump;
-
-                            process = true;
-                        }
-                    }
+                    continue;
                 }
                 
-                if(process)
+                size_t s = edge.selectedID;
+                size_t u = edge.targetID;
+                rag.mergeNodes(s, u);
+                removed[s] = true;
+                ++version[u];
+                ++numMerges;
+                numPxls[u] += numPxls[s];
+                for(int n = 0; n < numSpecBands; ++n)
                 {
-                    for(size_t i = 0; i < clumps.size(); ++i)
+                    sumVals[(u*numSpecBands)+n] += sumVals[(s*numSpecBands)+n];
+                    meanVals[(u*numSpecBands)+n] = sumVals[(u*numSpecBands)+n] / numPxls[u];
+                }
+                
+                // The selected neighbours of s are now neighbours of u.
+                std::vector<unsigned int> &uNbrs = selectedNbrs[u];
+                const unsigned int *nbrs = rag.getNeighbours(s);
+                for(size_t n = 0; n < rag.getNumNeighbours(s); ++n)
+                {
+                    if((selectCol[nbrs[n]] == 1) && !removed[nbrs[n]])
                     {
-                        cClump = clumps.at(i);
-                        if(cClump->merge)
-                        {
-                            mClump = cClump->mergeTo;
-                            cClump->removed = true;
-                            mClump->origClumpIDs.push_back(cClump->clumpID);
-                            
-                            mClump->numPxls += cClump->numPxls;
-                            for(int n = 0; n < numSpecBands; ++n)
-                            {
-                                mClump->sumVals[n] += cClump->sumVals[n];
-                                mClump->meanVals[n] = mClump->sumVals[n] / mClump->numPxls;
-                            }
-                            
-                            for(std::list<rsgisClumpInfo*>::iterator iterNeigh = mClump->neighbours.begin(); iterNeigh != mClump->neighbours.end(); ++iterNeigh)
-                            {
-                                if((*iterNeigh)->clumpID == cClump->clumpID)
-                                {
-                                    mClump->neighbours.erase(iterNeigh);
-                                    break;
-                                }
-                            }
-                            
-                            for(std::list<rsgisClumpInfo*>::iterator iterNeighC = cClump->neighbours.begin(); iterNeighC != cClump->neighbours.end(); ++iterNeighC)
-                            {
-                                if((*iterNeighC)->clumpID != mClump->clumpID)
-                                {
-                                    found = false;
-                                    for(std::list<rsgisClumpInfo*>::iterator iterNeighM = mClump->neighbours.begin(); iterNeighM != mClump->neighbours.end(); ++iterNeighM)
-                                    {
-                                        if((*iterNeighM)->clumpID == (*iterNeighC)->clumpID)
-                                        {
-                                            found = true;
-                                            break;
-                                        }
-                                    }
-                                    if(!found)
-                                    {
-                                        mClump->neighbours.push_back(*iterNeighC);
-                                        found = false;
-                                        for(std::list<rsgisClumpInfo*>::iterator iterNeighSec = (*iterNeighC)->neighbours.begin(); iterNeighSec != (*iterNeighC)->neighbours.end(); ++iterNeighSec)
-                                        {
-                                            if((*iterNeighSec)->clumpID == mClump->clumpID)
-                                            {
-                                                found = true;
-                                                break;
-                                            }
-                                        }
-                                        if(!found)
-                                        {
-                                            (*iterNeighC)->neighbours.push_back(mClump);
-                                        }
-                                    }
-                                }
-                            }
-                            cClump->neighbours.clear();
-                        }
+                        uNbrs.push_back(nbrs[n]);
                     }
                 }
-            }
-            std::cout << "Completed Iterations\n";
-            
-            
-            int *clumpIDUp = new int[numRows];
-            for(size_t i = 0; i < clumps.size(); ++i)
-            {
-                cClump = clumps.at(i);
-                if(!cClump->removed)
+                
+                // Push the new distances from u to its remaining selected neighbours,
+                // dropping merged and repeated neighbours from the list.
+                ++markStamp;
+                size_t numKept = 0;
+                for(size_t n = 0; n < uNbrs.size(); ++n)
                 {
-                    for(std::vector<unsigned int>::iterator iterClumpIDs = cClump->origClumpIDs.begin(); iterClumpIDs != cClump->origClumpIDs.end(); ++iterClumpIDs)
+                    unsigned int x = uNbrs[n];
+                    if(removed[x] || (nbrMark[x] == markStamp))
                     {
-                        clumpIDUp[*iterClumpIDs] = cClump->clumpID;
+                        continue;
                     }
+                    nbrMark[x] = markStamp;
+                    uNbrs[numKept++] = x;
+                    mergeHeap.push(rsgisClumpMergeEdge(this->calcDist(&meanVals[((size_t)x)*numSpecBands], &meanVals[u*numSpecBands], numSpecBands), x, u, version[u]));
                 }
+                uNbrs.resize(numKept);
             }
-            attUtils.writeIntColumn(rat, "OutClumpIDs", clumpIDUp, numRows);
+            std::cout << "Merged " << numMerges << " clumps\n";
             
-            for(size_t i = 0; i < clumps.size(); ++i)
+            int *clumpIDUp = new int[numRows];
+            for(size_t i = 0; i < numRows; ++i)
             {
-                cClump = clumps.at(i);
-                cClump->neighbours.clear();
-                delete cClump->meanVals;
-                delete cClump->sumVals;
-                delete cClump;
+                size_t outID = (i < numGraphNodes)?rag.findMergedNode(i):i;
+                clumpIDUp[i] = (noDataCol[outID] == 1)?0:outID;
             }
-            clumps.clear();
-            
+            attUtils.writeIntColumn(rat, "OutClumpIDs", clumpIDUp, numRows);
             
-            for(int i = 0; i < numSpecBands; ++i)
-            {
-                delete[] meanVals[i];
-                delete[] sumVals[i];
-            }
-            delete[] meanVals;
-            delete[] sumVals;
-            delete[] numPxls;
             delete[] selectCol;
             delete[] noDataCol;
             delete[] clumpIDUp;
@@ -27,6 +27,10 @@
 #include <string>
 #include <math.h>
 #include <stdlib.h>
+#include <vector>
+#include <list>
+#include <queue>
+#include <functional>
 
 #include "common/rsgis-tqdm.h"
 #include "common/RSGISAttributeTableException.h"
@@ -49,6 +53,7 @@
 #include "rastergis/RSGISRasterAttUtils.h"
 #include "rastergis/RSGISFindClumpNeighbours.h"
 #include "rastergis/RSGISPopRATWithStats.h"
+#include "rastergis/RSGISRegionAdjacencyGraph.h"
 
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
@@ -91,6 +96,32 @@ namespace rsgis{namespace segment{
         std::list<rsgisClumpMergeInfo*> neighbours;
     };
     
+    /**
+     * A candidate merge of a selected clump into a neighbour, ordered by the
+     * spectral distance between them. The version is that of the target
+     * clump when the distance was calculated.
+     */
+    struct rsgisClumpMergeEdge
+    {
+        rsgisClumpMergeEdge(double dist, size_t selectedID, size_t targetID, unsigned int version): dist(dist), selectedID(selectedID), targetID(targetID), version(version){};
+        double dist;
+        size_t selectedID;
+        size_t targetID;
+        unsigned int version;
+        bool operator>(const rsgisClumpMergeEdge &other) const
+        {
+            if(dist != other.dist)
+            {
+                return dist > other.dist;
+            }
+            if(selectedID != other.selectedID)
+            {
+                return selectedID > other.selectedID;
+            }
+            return targetID > other.targetID;
+        };
+    };
+    
     class DllExport RSGISMergeSegments
     {
     public:
@@ -104,7 +135,7 @@ namespace rsgis{namespace segment{
             double outVal = 0.0;
             for(int i = 0; i < numVals; ++i)
             {
-                outVal = (valsRef[i] - valsTest[i])*(valsRef[i] - valsTest[i]);
+                outVal += (valsRef[i] - valsTest[i])*(valsRef[i] - valsTest[i]);
             }
             outVal = sqrt(outVal/numVals);
             return outVal;
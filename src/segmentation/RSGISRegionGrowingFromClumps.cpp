@@ -103,7 +103,12 @@ namespace rsgis{namespace segment{
     
     RSGISRegionGrowingSegmentation::RSGISRegionGrowingSegmentation()
     {
-        
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+    
+    void RSGISRegionGrowingSegmentation::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
     }
     
     void RSGISRegionGrowingSegmentation::performRegionGrowUsingClumps(GDALDataset *spectral, GDALDataset *clumps, GDALDataset *output, std::vector<ClumpSeed> *seeds, float initThreshold, float thresholdIncrements, float maxThreshold, unsigned int maxIterations )
@@ -119,394 +124,310 @@ namespace rsgis{namespace segment{
             throw rsgis::img::RSGISImageCalcException("Heights are not the same");
         }
         
-        rsgis::img::RSGISImageUtils imgUtils;
-        imgUtils.zerosUIntGDALDataset(output);
-        
         unsigned int width = spectral->GetRasterXSize();
         unsigned int height = spectral->GetRasterYSize();
         unsigned int numSpecBands = spectral->GetRasterCount();
         
-        unsigned int *clumpIdxsAbove = new unsigned int[width];
-        unsigned int *clumpIdxs = new unsigned int[width];
-        unsigned int *clumpIdxsBelow = new unsigned int[width];
-        unsigned int *outVals = new unsigned int[width];
-        float **spectralVals = new float*[numSpecBands];
-        
         GDALRasterBand **spectralBands = new GDALRasterBand*[numSpecBands];
         for(unsigned int n = 0; n < numSpecBands; ++n)
         {
             spectralBands[n] = spectral->GetRasterBand(n+1);
-            spectralVals[n] = new float[width]; 
         }
         GDALRasterBand *clumpBand = clumps->GetRasterBand(1);
         GDALRasterBand *outBand = output->GetRasterBand(1);
         
         std::cout << "Building Clump Table\n";
+        std::vector<unsigned int> clumpIdxsAbove(width);
+        std::vector<unsigned int> clumpIdxs(width);
+        std::vector<unsigned int> clumpIdxsBelow(width);
+        std::vector<float> spectralVals(((size_t)width) * numSpecBands);
+        
         unsigned long maxClumpIdx = 0;
         for(unsigned int i = 0; i < height; ++i)
         {
-            clumpBand->RasterIO(GF_Read, 0, i, width, 1, clumpIdxs, width, 1, GDT_UInt32, 0, 0);
+            clumpBand->RasterIO(GF_Read, 0, i, width, 1, &clumpIdxs[0], width, 1, GDT_UInt32, 0, 0);
             for(unsigned int j = 0; j < width; ++j)
             {
-                if((i == 0) & (j == 0))
-                {
-                    maxClumpIdx = clumpIdxs[j];
-                }
-                else if(clumpIdxs[j] > maxClumpIdx)
+                if(clumpIdxs[j] > maxClumpIdx)
                 {
                     maxClumpIdx = clumpIdxs[j];
                 }
             }
         }
         
-        std::vector<rsgis::img::ImgClumpRG*> *clumpTab = new std::vector<rsgis::img::ImgClumpRG*>();
-        clumpTab->reserve(maxClumpIdx);
-        rsgis::img::ImgClumpRG *cClump;
-        for(unsigned int i = 0; i < maxClumpIdx; ++i)
+        RSGISClumpGraph graph;
+        graph.numBands = numSpecBands;
+        graph.numPxls.assign(maxClumpIdx, 0);
+        graph.sumVals.assign(maxClumpIdx * numSpecBands, 0);
+        graph.meanVals.assign(maxClumpIdx * numSpecBands, 0);
+        std::vector<std::vector<unsigned long> > neighbours(maxClumpIdx);
+        
+        // The clump rows are read once each and rolled through the three buffers.
+        if(height > 0)
         {
-            cClump = new rsgis::img::ImgClumpRG(i+1);
-            cClump->sumVals = new float[numSpecBands];
-            cClump->meanVals = new float[numSpecBands];
-            cClump->pxls = new std::vector<rsgis::img::PxlLoc>();
-            for(unsigned int n = 0; n < numSpecBands; ++n)
-            {
-                cClump->sumVals[n] = 0;
-                cClump->meanVals[n] = 0;
-            }
-            cClump->seedVal = 0;
-            clumpTab->push_back(cClump);
+            clumpBand->RasterIO(GF_Read, 0, 0, width, 1, &clumpIdxs[0], width, 1, GDT_UInt32, 0, 0);
         }
-        
         for(unsigned int i = 0; i < height; ++i)
         {
-            if(((long)i)-1 >= 0)
-            {
-                clumpBand->RasterIO(GF_Read, 0, i-1, width, 1, clumpIdxsAbove, width, 1, GDT_UInt32, 0, 0);
-            }
-            clumpBand->RasterIO(GF_Read, 0, i, width, 1, clumpIdxs, width, 1, GDT_UInt32, 0, 0);
             if(((long)i)+1 < height)
             {
-                clumpBand->RasterIO(GF_Read, 0, i+1, width, 1, clumpIdxsBelow, width, 1, GDT_UInt32, 0, 0);
+                clumpBand->RasterIO(GF_Read, 0, i+1, width, 1, &clumpIdxsBelow[0], width, 1, GDT_UInt32, 0, 0);
             }
             for(unsigned int n = 0; n < numSpecBands; ++n)
             {
-                spectralBands[n]->RasterIO(GF_Read, 0, i, width, 1, spectralVals[n], width, 1, GDT_Float32, 0, 0);
+                spectralBands[n]->RasterIO(GF_Read, 0, i, width, 1, &spectralVals[((size_t)n) * width], width, 1, GDT_Float32, 0, 0);
             }
             for(unsigned int j = 0; j < width; ++j)
             {
-                if(clumpIdxs[j] != 0)
+                unsigned int clumpID = clumpIdxs[j];
+                if(clumpID != 0)
                 {
-                    cClump = clumpTab->at(clumpIdxs[j] - 1);
+                    unsigned long clumpIdx = clumpID - 1;
+                    double *clumpSums = &graph.sumVals[clumpIdx * numSpecBands];
                     for(unsigned int n = 0; n < numSpecBands; ++n)
                     {
-                        cClump->sumVals[n] += spectralVals[n][j];
+                        clumpSums[n] += spectralVals[(((size_t)n) * width) + j];
                     }
-                    cClump->pxls->push_back(rsgis::img::PxlLoc(j,i));
+                    ++graph.numPxls[clumpIdx];
                     
-                    // Above
-                    if(((long)i)-1 >= 0)
+                    // Above, below, left and right (the no data clump, 0, is not a neighbour).
+                    std::vector<unsigned long> &clumpNbrs = neighbours[clumpIdx];
+                    if((i > 0) && (clumpIdxsAbove[j] != clumpID) && (clumpIdxsAbove[j] != 0))
                     {
-                        if(clumpIdxsAbove[j] != clumpIdxs[j])
-                        {
-                            cClump->neighbours.push_back(clumpIdxsAbove[j]);
-                        }
+                        clumpNbrs.push_back(clumpIdxsAbove[j] - 1);
                     }
-                    // Below
-                    if(((long)i)+1 < height)
+                    if((((long)i)+1 < height) && (clumpIdxsBelow[j] != clumpID) && (clumpIdxsBelow[j] != 0))
                     {
-                        if(clumpIdxsBelow[j] != clumpIdxs[j])
-                        {
-                            cClump->neighbours.push_back(clumpIdxsBelow[j]);
-                        }
+                        clumpNbrs.push_back(clumpIdxsBelow[j] - 1);
                     }
-                    // Left
-                    if(((long)j)-1 >= 0)
+                    if((j > 0) && (clumpIdxs[j-1] != clumpID) && (clumpIdxs[j-1] != 0))
                     {
-                        if(clumpIdxs[j-1] != clumpIdxs[j])
-                        {
-                            cClump->neighbours.push_back(clumpIdxs[j-1]);
-                        }
+                        clumpNbrs.push_back(clumpIdxs[j-1] - 1);
                     }
-                    // Right
-                    if(((long)j)+1 < width)
+                    if((((long)j)+1 < width) && (clumpIdxs[j+1] != clumpID) && (clumpIdxs[j+1] != 0))
                     {
-                        if(clumpIdxs[j+1] != clumpIdxs[j])
-                        {
-                            cClump->neighbours.push_back(clumpIdxs[j+1]);
-                        }
+                        clumpNbrs.push_back(clumpIdxs[j+1] - 1);
                     }
                 }
             }
+            clumpIdxsAbove.swap(clumpIdxs);
+            clumpIdxs.swap(clumpIdxsBelow);
         }
+        delete[] spectralBands;
         
-        for(std::vector<rsgis::img::ImgClumpRG*>::iterator iterClumps = clumpTab->begin(); iterClumps != clumpTab->end(); ++iterClumps)
+        graph.nbrStart.assign(maxClumpIdx + 1, 0);
+        for(unsigned long c = 0; c < maxClumpIdx; ++c)
         {
             for(unsigned int n = 0; n < numSpecBands; ++n)
             {
-                (*iterClumps)->meanVals[n] = (*iterClumps)->sumVals[n] / (*iterClumps)->pxls->size();
+                graph.meanVals[(c * numSpecBands) + n] = graph.sumVals[(c * numSpecBands) + n] / graph.numPxls[c];
             }
-            (*iterClumps)->neighbours.sort();
-            (*iterClumps)->neighbours.unique();
+            std::vector<unsigned long> &clumpNbrs = neighbours[c];
+            std::sort(clumpNbrs.begin(), clumpNbrs.end());
+            clumpNbrs.erase(std::unique(clumpNbrs.begin(), clumpNbrs.end()), clumpNbrs.end());
+            graph.nbrStart[c+1] = graph.nbrStart[c] + clumpNbrs.size();
+        }
+        graph.nbrIdxs.reserve(graph.nbrStart[maxClumpIdx]);
+        for(unsigned long c = 0; c < maxClumpIdx; ++c)
+        {
+            graph.nbrIdxs.insert(graph.nbrIdxs.end(), neighbours[c].begin(), neighbours[c].end());
+            std::vector<unsigned long>().swap(neighbours[c]);
         }
         
-        unsigned int numThresSteps = ceil((maxThreshold - initThreshold)/thresholdIncrements);
-        float cThres = 0;
-        float percentInAreaInc = 0;
-        rsgis::img::ImgClumpRG *cRegion = NULL;
-        rsgis::img::ImgClumpRG *pRegion = NULL;
-        std::list<unsigned long> *pClumpIds = NULL;
-        std::list<unsigned long> *cClumpIds = NULL;
-        
-        std::cout << "Processing seeds\n";
         for(std::vector<ClumpSeed>::iterator iterSeeds = seeds->begin(); iterSeeds != seeds->end(); ++iterSeeds)
         {
-            std::cout << "Processing seed " << (*iterSeeds).seedID << std::endl;
-            pClumpIds = new std::list<unsigned long>();
-            pRegion = this->growRegion(initThreshold, maxIterations, clumpTab, numSpecBands, (*iterSeeds).clumpID, (*iterSeeds).seedID, pClumpIds);
+            if(((*iterSeeds).clumpID == 0) || ((*iterSeeds).clumpID > maxClumpIdx))
+            {
+                throw rsgis::img::RSGISImageCalcException("A seed clump ID is not within the clumps image.");
+            }
+        }
+        
+        // Each clump is claimed by the last seed (highest index + 1) whose region contains it.
+        std::vector<std::atomic<size_t> > clumpClaims(maxClumpIdx);
+        for(unsigned long c = 0; c < maxClumpIdx; ++c)
+        {
+            clumpClaims[c].store(0);
+        }
+        
+        unsigned int numThresSteps = ceil((maxThreshold - initThreshold)/thresholdIncrements);
+        size_t numSeeds = seeds->size();
+        
+        // The clumps tested (marked with the current testedMark) by each worker.
+        struct SeedScratch
+        {
+            std::vector<unsigned int> tested;
+            unsigned int testedMark;
+            std::vector<unsigned long> pClumps;
+            std::vector<unsigned long> cClumps;
+        };
+        
+        std::cout << "Processing " << numSeeds << " seeds\n";
+        rsgis::utils::RSGISWorkerPool pool(std::max<unsigned int>(1, std::min<size_t>(this->numThreads, numSeeds)));
+        std::vector<SeedScratch> scratch(pool.getNumThreads());
+        pool.parallelFor(numSeeds, [&](size_t s, unsigned int worker)
+        {
+            SeedScratch &seedScratch = scratch[worker];
+            if(seedScratch.tested.empty())
+            {
+                seedScratch.tested.assign(maxClumpIdx, 0);
+                seedScratch.testedMark = 0;
+            }
+            std::vector<unsigned int> &tested = seedScratch.tested;
+            unsigned int &testedMark = seedScratch.testedMark;
+            std::vector<unsigned long> &pClumps = seedScratch.pClumps;
+            std::vector<unsigned long> &cClumps = seedScratch.cClumps;
+            unsigned long pNumPxls = 0;
+            unsigned long cNumPxls = 0;
+            double percentInAreaInc = 0;
             
-            if(pRegion == NULL)
+            unsigned long seedClumpIdx = seeds->at(s).clumpID - 1;
+            if(++testedMark == 0)
+            {
+                std::fill(tested.begin(), tested.end(), 0);
+                testedMark = 1;
+            }
+            if(!this->growRegion(graph, initThreshold, maxIterations, seedClumpIdx, &tested, testedMark, &pClumps, &pNumPxls))
             {
-                pClumpIds->push_back((*iterSeeds).clumpID);
-                cClumpIds = pClumpIds;
+                pClumps.assign(1, seedClumpIdx);
             }
             else
             {
                 // Try seed growth thresholds until the 'right' answer is found.
                 for(unsigned int i = 1; i < numThresSteps; ++i)
                 {
-                    cThres = initThreshold + (i * thresholdIncrements);
-                    
-                    cClumpIds = new std::list<unsigned long>();
-                    cRegion = this->growRegion(cThres, maxIterations, clumpTab, numSpecBands, (*iterSeeds).clumpID, (*iterSeeds).seedID, cClumpIds);
-                    
-                    if(cRegion != NULL)
+                    float cThres = initThreshold + (i * thresholdIncrements);
+                    if(++testedMark == 0)
+                    {
+                        std::fill(tested.begin(), tested.end(), 0);
+                        testedMark = 1;
+                    }
+                    if(!this->growRegion(graph, cThres, maxIterations, seedClumpIdx, &tested, testedMark, &cClumps, &cNumPxls))
                     {
-                        percentInAreaInc = (((double)cRegion->pxls->size()) - ((double)pRegion->pxls->size()))/((double)cRegion->pxls->size());
-                        
-                        if(percentInAreaInc > 0.9)
-                        {
-                            delete[] cRegion->meanVals;
-                            delete[] cRegion->sumVals;
-                            delete cRegion->pxls;
-                            delete cRegion;
-                            delete cClumpIds;
-                            
-                            cRegion = pRegion;
-                            cClumpIds = pClumpIds;
-                            break;
-                        }
-                        else
-                        {
-                            // Delete Previous
-                            delete[] pRegion->meanVals;
-                            delete[] pRegion->sumVals;
-                            delete pRegion->pxls;
-                            delete pRegion;
-                            delete pClumpIds;
-                            
-                            pRegion = cRegion;
-                            pClumpIds = cClumpIds;
-                        }
+                        break;
                     }
-                    else
+                    percentInAreaInc = (((double)cNumPxls) - ((double)pNumPxls))/((double)cNumPxls);
+                    if(percentInAreaInc > 0.9)
                     {
-                        delete cClumpIds;
-                        cRegion = pRegion;
-                        cClumpIds = pClumpIds;
                         break;
                     }
+                    pClumps.swap(cClumps);
+                    pNumPxls = cNumPxls;
                 }
             }
             
-            for(std::list<unsigned long>::iterator iterClumpIDs = cClumpIds->begin(); iterClumpIDs != cClumpIds->end(); ++iterClumpIDs)
-            {
-                clumpTab->at((*iterClumpIDs)-1)->seedVal = (*iterSeeds).seedID;
-            }
-
-            // Clear up.
-            if(cRegion != NULL)
+            size_t claim = s + 1;
+            for(std::vector<unsigned long>::iterator iterClumps = pClumps.begin(); iterClumps != pClumps.end(); ++iterClumps)
             {
-                delete[] cRegion->meanVals;
-                delete[] cRegion->sumVals;
-                delete cRegion->pxls;
-                delete cRegion;
-                delete cClumpIds;
+                std::atomic<size_t> &clumpClaim = clumpClaims[*iterClumps];
+                size_t current = clumpClaim.load();
+                while((current < claim) && !clumpClaim.compare_exchange_weak(current, claim))
+                {
+                    // current is reloaded by compare_exchange_weak.
+                }
             }
-        }
+        });
         
         // Output the grown seed to the output image.
         std::cout << "Writing output to image\n";
+        std::vector<unsigned int> outVals(width);
         for(unsigned int i = 0; i < height; ++i)
         {
-            clumpBand->RasterIO(GF_Read, 0, i, width, 1, clumpIdxs, width, 1, GDT_UInt32, 0, 0);
-            outBand->RasterIO(GF_Read, 0, i, width, 1, outVals, width, 1, GDT_UInt32, 0, 0);
+            clumpBand->RasterIO(GF_Read, 0, i, width, 1, &clumpIdxs[0], width, 1, GDT_UInt32, 0, 0);
             for(unsigned int j = 0; j < width; ++j)
             {
+                outVals[j] = 0;
                 if(clumpIdxs[j] != 0)
                 {
-                    outVals[j] = clumpTab->at(clumpIdxs[j]-1)->seedVal;
+                    size_t claim = clumpClaims[clumpIdxs[j]-1].load();
+                    if(claim > 0)
+                    {
+                        outVals[j] = seeds->at(claim-1).seedID;
+                    }
                 }
             }
-            outBand->RasterIO(GF_Write, 0, i, width, 1, outVals, width, 1, GDT_UInt32, 0, 0);
-        }
-        
-        for(std::vector<rsgis::img::ImgClumpRG*>::iterator iterClumps = clumpTab->begin(); iterClumps != clumpTab->end(); ++iterClumps)
-        {
-            delete[] (*iterClumps)->meanVals;
-            delete[] (*iterClumps)->sumVals;
-            delete (*iterClumps)->pxls;
-            delete (*iterClumps);
-        }
-        delete clumpTab;
-        delete[] outVals;
-        delete[] clumpIdxs;
-        for(unsigned int n = 0; n < numSpecBands; ++n)
-        {
-            delete[] spectralVals[n]; 
+            outBand->RasterIO(GF_Write, 0, i, width, 1, &outVals[0], width, 1, GDT_UInt32, 0, 0);
         }
-        delete[] spectralVals;
-
     }
     
-    
-    rsgis::img::ImgClumpRG* RSGISRegionGrowingSegmentation::growRegion(float threshold, unsigned int maxNumIterations, std::vector<rsgis::img::ImgClumpRG*> *clumpTab, unsigned int numSpecBands, unsigned long seedClumpID, unsigned long seed, std::list<unsigned long> *regionClumps)
+    bool RSGISRegionGrowingSegmentation::growRegion(const RSGISClumpGraph &graph, float threshold, unsigned int maxNumIterations, unsigned long seedClumpIdx, std::vector<unsigned int> *tested, unsigned int testedMark, std::vector<unsigned long> *regionClumps, unsigned long *regionNumPxls)
     {
-        rsgis::img::ImgClumpRG *region = NULL;
-        try 
-        {
-            region = new rsgis::img::ImgClumpRG(seed);
-            region->meanVals = new float[numSpecBands];
-            region->sumVals = new float[numSpecBands];
-            region->pxls = new std::vector<rsgis::img::PxlLoc>();
-            regionClumps->clear();
-            regionClumps->push_back(seedClumpID);
-            
-            rsgis::img::ImgClumpRG *tmpClump = clumpTab->at(seedClumpID-1);
-            for(unsigned int n = 0; n < numSpecBands; ++n)
-            {
-                region->meanVals[n] = tmpClump->meanVals[n];
-                region->sumVals[n] = tmpClump->sumVals[n];
-            }
-            for(std::vector<rsgis::img::PxlLoc>::iterator iterPxls = tmpClump->pxls->begin(); iterPxls != tmpClump->pxls->end(); ++iterPxls)
-            {
-                region->pxls->push_back(*iterPxls);
-            }
-            for(std::list<unsigned long>::iterator iterNeighbours = tmpClump->neighbours.begin(); iterNeighbours != tmpClump->neighbours.end(); ++iterNeighbours)
-            {
-                region->neighbours.push_back(*iterNeighbours);
-            }
+        unsigned int numSpecBands = graph.numBands;
+        std::vector<double> sumVals(graph.sumVals.begin() + (seedClumpIdx * numSpecBands), graph.sumVals.begin() + ((seedClumpIdx+1) * numSpecBands));
+        std::vector<double> meanVals(graph.meanVals.begin() + (seedClumpIdx * numSpecBands), graph.meanVals.begin() + ((seedClumpIdx+1) * numSpecBands));
+        unsigned long numPxls = graph.numPxls[seedClumpIdx];
+        regionClumps->clear();
+        regionClumps->push_back(seedClumpIdx);
+        (*tested)[seedClumpIdx] = testedMark;
+        
+        std::vector<unsigned long> nbrs(graph.nbrIdxs.begin() + graph.nbrStart[seedClumpIdx], graph.nbrIdxs.begin() + graph.nbrStart[seedClumpIdx+1]);
+        std::vector<unsigned long> nextNbrs;
+        unsigned int numIterations = 0;
+        bool change = true;
+        while(change)
+        {
+            ++numIterations;
+            change = false;
             
-            float *cMean = new float[numSpecBands];
-            std::list<unsigned long> nextNeighbours;
-            std::list<unsigned long> testedClumps;
-            testedClumps.push_back(seedClumpID);
-            double distance = 0;
-            bool alreadyTested = true;
-            bool change = true;
-            bool maxNumIterationsReached = false;
-            unsigned int numIterations = 0;
-            while(change)
+            // Test all the neighbours against the mean of the region before this ring.
+            nextNbrs.clear();
+            for(std::vector<unsigned long>::iterator iterNbr = nbrs.begin(); iterNbr != nbrs.end(); ++iterNbr)
             {
-                ++numIterations;
-                change = false;
-                // Make copy of mean values.
+                const double *clumpMean = &graph.meanVals[(*iterNbr) * numSpecBands];
+                double distance = 0;
                 for(unsigned int n = 0; n < numSpecBands; ++n)
                 {
-                    cMean[n] = region->meanVals[n];
+                    distance += ((clumpMean[n] - meanVals[n])*(clumpMean[n] - meanVals[n]));
                 }
+                distance = sqrt(distance);
                 
-                // Test all neighbours to see whether they are part of the region.
-                nextNeighbours.clear();
-                for(std::list<unsigned long>::iterator iterNeighbour = region->neighbours.begin(); iterNeighbour != region->neighbours.end(); ++iterNeighbour)
+                if(distance < threshold)
                 {
-                    tmpClump = clumpTab->at(*iterNeighbour-1);
-                    
-                    distance = 0;
+                    regionClumps->push_back(*iterNbr);
+                    const double *clumpSums = &graph.sumVals[(*iterNbr) * numSpecBands];
                     for(unsigned int n = 0; n < numSpecBands; ++n)
                     {
-                        distance += ((tmpClump->meanVals[n] - cMean[n])*(tmpClump->meanVals[n] - cMean[n]));
+                        sumVals[n] += clumpSums[n];
                     }
-                    distance = sqrt(distance);
-                    
-                    if(distance < threshold)
-                    {
-                        regionClumps->push_back(*iterNeighbour);
-                        for(unsigned int n = 0; n < numSpecBands; ++n)
-                        {
-                            region->sumVals[n] += tmpClump->sumVals[n];
-                        }
-                        for(std::vector<rsgis::img::PxlLoc>::iterator iterPxls = tmpClump->pxls->begin(); iterPxls != tmpClump->pxls->end(); ++iterPxls)
-                        {
-                            region->pxls->push_back(*iterPxls);
-                        }
-                        for(std::list<unsigned long>::iterator iterClumpNeighbours = tmpClump->neighbours.begin(); iterClumpNeighbours != tmpClump->neighbours.end(); ++iterClumpNeighbours)
-                        {
-                            nextNeighbours.push_back(*iterClumpNeighbours);
-                        }
-                        change = true;
-                    }
-                    
-                    testedClumps.push_back(*iterNeighbour);
-                }
-                
-                // Recalculate the mean of the region.
-                for(unsigned int n = 0; n < numSpecBands; ++n)
-                {
-                    region->meanVals[n] = region->sumVals[n]/region->pxls->size();
-                }
-                
-                region->neighbours.clear();
-                nextNeighbours.sort();
-                nextNeighbours.unique();
-                for(std::list<unsigned long>::iterator iterNeighbour = nextNeighbours.begin(); iterNeighbour != nextNeighbours.end(); ++iterNeighbour)
-                {
-                    alreadyTested = false;
-                    
-                    for(std::list<unsigned long>::iterator iterClumps = testedClumps.begin(); iterClumps != testedClumps.end(); ++iterClumps)
-                    {
-                        if((*iterNeighbour) == (*iterClumps))
-                        {
-                            alreadyTested = true;
-                            break;
-                        }
-                    }
-                    
-                    if(!alreadyTested)
-                    {
-                        region->neighbours.push_back(*iterNeighbour);
-                    }
-                }
-                
-                if(region->neighbours.size() == 0)
-                {
-                     break;
+                    numPxls += graph.numPxls[*iterNbr];
+                    nextNbrs.insert(nextNbrs.end(), graph.nbrIdxs.begin() + graph.nbrStart[*iterNbr], graph.nbrIdxs.begin() + graph.nbrStart[(*iterNbr)+1]);
+                    change = true;
                 }
-                
-                if(numIterations == maxNumIterations)
+                (*tested)[*iterNbr] = testedMark;
+            }
+            
+            // Recalculate the mean of the region.
+            for(unsigned int n = 0; n < numSpecBands; ++n)
+            {
+                meanVals[n] = sumVals[n]/numPxls;
+            }
+            
+            // The next ring is the untested neighbours of the clumps just added.
+            std::sort(nextNbrs.begin(), nextNbrs.end());
+            nextNbrs.erase(std::unique(nextNbrs.begin(), nextNbrs.end()), nextNbrs.end());
+            nbrs.clear();
+            for(std::vector<unsigned long>::iterator iterNbr = nextNbrs.begin(); iterNbr != nextNbrs.end(); ++iterNbr)
+            {
+                if((*tested)[*iterNbr] != testedMark)
                 {
-                    maxNumIterationsReached = true;
-                    break;
+                    nbrs.push_back(*iterNbr);
                 }
             }
             
-            if(maxNumIterationsReached)
+            if(nbrs.empty())
+            {
+                break;
+            }
+            
+            if(numIterations == maxNumIterations)
             {
-                delete[] region->meanVals;
-                delete[] region->sumVals;
-                delete region->pxls;
-                delete region;
-                region = NULL;
                 regionClumps->clear();
+                *regionNumPxls = 0;
+                return false;
             }
-                        
-            delete[] cMean;
-        } 
-        catch (rsgis::img::RSGISImageCalcException &e) 
-        {
-            throw e;
         }
         
-        return region;
+        *regionNumPxls = numPxls;
+        return true;
     }
 
                                                                    
@@ -524,303 +445,297 @@ namespace rsgis{namespace segment{
     
     
     
-    RSGISGenerateSeeds::RSGISGenerateSeeds()
+    RSGISClumpSpectralStats::RSGISClumpSpectralStats()
     {
-        
+        this->numThreads = rsgis::utils::getNumThreads();
+        this->numBands = 0;
+        this->maxClumpID = 0;
+        this->stride = 1;
     }
-    
-    void RSGISGenerateSeeds::genSeedsHistogram(GDALDataset *spectral, GDALDataset *clumps, GDALDataset *output, std::vector<BandThreshold> *thresholds) 
+
+    void RSGISClumpSpectralStats::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+
+    void RSGISClumpSpectralStats::calcStats(GDALDataset *spectral, GDALDataset *clumps, GDALDataset *parentClumps)
     {
         if((spectral->GetRasterXSize() != clumps->GetRasterXSize()) |
-           (spectral->GetRasterXSize() != output->GetRasterXSize()))
+           ((parentClumps != NULL) && (spectral->GetRasterXSize() != parentClumps->GetRasterXSize())))
         {
             throw rsgis::img::RSGISImageCalcException("Widths are not the same");
         }
         if((spectral->GetRasterYSize() != clumps->GetRasterYSize()) |
-           (spectral->GetRasterYSize() != output->GetRasterYSize()))
+           ((parentClumps != NULL) && (spectral->GetRasterYSize() != parentClumps->GetRasterYSize())))
         {
             throw rsgis::img::RSGISImageCalcException("Heights are not the same");
         }
-        
-        if(((unsigned int)spectral->GetRasterCount()) != thresholds->size())
-        {
-            throw rsgis::img::RSGISImageCalcException("The number of bands is not the same as the number of thresholds supplied.");
-        }
-        
-        for(unsigned int i = 0; i < thresholds->size(); ++i)
-        {
-            if((thresholds->at(i).band < 1) | (thresholds->at(i).band > ((unsigned int) spectral->GetRasterCount())))
-            {
-                throw rsgis::img::RSGISImageCalcException("Band specified is not within the image.");
-            }
-        }
-        
-        rsgis::img::RSGISImageUtils imgUtils;
-        imgUtils.zerosUIntGDALDataset(output);
-        
+
         unsigned int width = spectral->GetRasterXSize();
         unsigned int height = spectral->GetRasterYSize();
-        unsigned int numSpecBands = spectral->GetRasterCount();
-        
-        float *percentThresholds = new float[numSpecBands];
-        bool bandFound = false;
-        for(unsigned int i = 1; i <= numSpecBands; ++i)
-        {
-            bandFound = false;
-            for(unsigned int j = 0; j < thresholds->size(); ++j)
-            {
-                if(i == thresholds->at(j).band)
-                {
-                    if((thresholds->at(j).threshold < 0) | (thresholds->at(j).threshold > 1))
-                    {
-                        throw rsgis::img::RSGISImageCalcException("Threshold should be between 0 and 1.");
-                    }
-                    percentThresholds[i-1] = thresholds->at(j).threshold;
-                    bandFound = true;
-                    break;
-                }
-            }
-            if(!bandFound)
-            {
-                throw rsgis::img::RSGISImageCalcException("Thresholds were not provided for all bands.");
-            }
-        }
-        
-        
-        unsigned int *clumpIdxs = new unsigned int[width];
-        unsigned int *outVals = new unsigned int[width];
-        float **spectralVals = new float*[numSpecBands];
-        
-        GDALRasterBand **spectralBands = new GDALRasterBand*[numSpecBands];
+        this->numBands = spectral->GetRasterCount();
+        unsigned int numSpecBands = this->numBands;
+        GDALRasterBand *clumpBand = clumps->GetRasterBand(1);
+        GDALRasterBand *parentBand = (parentClumps != NULL)?parentClumps->GetRasterBand(1):NULL;
+        std::vector<GDALRasterBand*> spectralBands(numSpecBands);
         for(unsigned int n = 0; n < numSpecBands; ++n)
         {
             spectralBands[n] = spectral->GetRasterBand(n+1);
-            spectralVals[n] = new float[width]; 
         }
-        GDALRasterBand *clumpBand = clumps->GetRasterBand(1);
-        GDALRasterBand *outBand = output->GetRasterBand(1);
-        
-        unsigned long maxClumpIdx = 0;
-        for(unsigned int i = 0; i < height; ++i)
-        {
-            clumpBand->RasterIO(GF_Read, 0, i, width, 1, clumpIdxs, width, 1, GDT_UInt32, 0, 0);
-            for(unsigned int j = 0; j < width; ++j)
+
+        int blockXSize = 0;
+        int blockYSize = 0;
+        clumpBand->GetBlockSize(&blockXSize, &blockYSize);
+        unsigned int stripRows = (blockYSize > 0)?blockYSize:1;
+        unsigned int numStrips = (height + stripRows - 1) / stripRows;
+
+        // Each thread sums into its own arrays (clump major, the count then the band
+        // sums and sums of squares), grown as larger clump IDs are found. The parent
+        // of a clump is taken from the first strip it was found in.
+        this->stride = 1 + (2 * ((size_t)numSpecBands));
+        size_t clumpStride = this->stride;
+        rsgis::utils::RSGISWorkerPool pool(std::max<unsigned int>(1, std::min(this->numThreads, numStrips)));
+        unsigned int nThreads = pool.getNumThreads();
+        std::vector<std::vector<double> > threadSums(nThreads);
+        std::vector<std::vector<unsigned int> > threadParents(nThreads);
+        std::vector<std::vector<unsigned int> > threadFirstStrips(nThreads);
+        std::vector<std::vector<unsigned int> > threadLabels(nThreads);
+        std::vector<std::vector<unsigned int> > threadParentLabels(nThreads);
+        std::vector<std::vector<float> > threadStripVals(nThreads);
+        std::mutex ioMutex;
+
+        pool.parallelFor(numStrips, [&](size_t s, unsigned int threadIdx)
+        {
+            std::vector<double> &sums = threadSums[threadIdx];
+            std::vector<unsigned int> &parents = threadParents[threadIdx];
+            std::vector<unsigned int> &firstStrips = threadFirstStrips[threadIdx];
+            std::vector<unsigned int> &labels = threadLabels[threadIdx];
+            std::vector<unsigned int> &parentLabels = threadParentLabels[threadIdx];
+            std::vector<float> &stripVals = threadStripVals[threadIdx];
+            labels.resize(((size_t)width) * stripRows);
+            parentLabels.resize((parentBand != NULL)?labels.size():0);
+            stripVals.resize(((size_t)width) * stripRows * numSpecBands);
+
+            unsigned int yStart = s * stripRows;
+            unsigned int numRows = std::min(stripRows, height - yStart);
+            size_t numPxls = ((size_t)width) * numRows;
             {
-                if((i == 0) & (j == 0))
+                std::lock_guard<std::mutex> lock(ioMutex);
+                if(clumpBand->RasterIO(GF_Read, 0, yStart, width, numRows, &labels[0], width, numRows, GDT_UInt32, 0, 0) != CE_None)
                 {
-                    maxClumpIdx = clumpIdxs[j];
+                    throw rsgis::img::RSGISImageCalcException("Could not read the clumps image.");
                 }
-                else if(clumpIdxs[j] > maxClumpIdx)
+                if((parentBand != NULL) && (parentBand->RasterIO(GF_Read, 0, yStart, width, numRows, &parentLabels[0], width, numRows, GDT_UInt32, 0, 0) != CE_None))
                 {
-                    maxClumpIdx = clumpIdxs[j];
+                    throw rsgis::img::RSGISImageCalcException("Could not read the parent clumps image.");
                 }
-            }
-        }
-        
-        std::vector<rsgis::img::ImgClumpMean*> *clumpTab = new std::vector<rsgis::img::ImgClumpMean*>();
-        clumpTab->reserve(maxClumpIdx);
-        rsgis::img::ImgClumpMean *cClump;
-        for(unsigned int i = 0; i < maxClumpIdx; ++i)
-        {
-            cClump = new rsgis::img::ImgClumpMean(i+1);
-            cClump->sumVals = new float[numSpecBands];
-            cClump->meanVals = new float[numSpecBands];
-            for(unsigned int n = 0; n < numSpecBands; ++n)
-            {
-                cClump->sumVals[n] = 0;
-                cClump->meanVals[n] = 0;
-            }
-            clumpTab->push_back(cClump);
-        }
-        
-        for(unsigned int i = 0; i < height; ++i)
-        {
-            clumpBand->RasterIO(GF_Read, 0, i, width, 1, clumpIdxs, width, 1, GDT_UInt32, 0, 0);
-            for(unsigned int n = 0; n < numSpecBands; ++n)
-            {
-                spectralBands[n]->RasterIO(GF_Read, 0, i, width, 1, spectralVals[n], width, 1, GDT_Float32, 0, 0);
-            }
-            for(unsigned int j = 0; j < width; ++j)
-            {
-                if(clumpIdxs[j] != 0)
+                for(unsigned int n = 0; n < numSpecBands; ++n)
                 {
-                    cClump = clumpTab->at(clumpIdxs[j] - 1);
-                    for(unsigned int n = 0; n < numSpecBands; ++n)
+                    if(spectralBands[n]->RasterIO(GF_Read, 0, yStart, width, numRows, &stripVals[n * numPxls], width, numRows, GDT_Float32, 0, 0) != CE_None)
                     {
-                        cClump->sumVals[n] += spectralVals[n][j];
+                        throw rsgis::img::RSGISImageCalcException("Could not read the spectral image.");
                     }
-                    ++cClump->numPxls;
                 }
             }
-        }
-        
-        
-        
-        for(std::vector<rsgis::img::ImgClumpMean*>::iterator iterClumps = clumpTab->begin(); iterClumps != clumpTab->end(); ++iterClumps)
-        {
-            for(unsigned int n = 0; n < numSpecBands; ++n)
+
+            unsigned int maxLabel = 0;
+            for(size_t p = 0; p < numPxls; ++p)
             {
-                (*iterClumps)->meanVals[n] = (*iterClumps)->sumVals[n] / (*iterClumps)->numPxls;
+                maxLabel = std::max(maxLabel, labels[p]);
             }
-        }
-        
-        float *minVals = new float[numSpecBands];
-        float *maxVals = new float[numSpecBands];
-        bool first = true;
-        for(std::vector<rsgis::img::ImgClumpMean*>::iterator iterClumps = clumpTab->begin(); iterClumps != clumpTab->end(); ++iterClumps)
-        {
-            if(first)
+            if((((size_t)maxLabel) + 1) * clumpStride > sums.size())
             {
-                for(unsigned int n = 0; n < numSpecBands; ++n)
-                {
-                    minVals[n] = (*iterClumps)->meanVals[n];
-                    maxVals[n] = (*iterClumps)->meanVals[n];
-                }
-                first = false;
+                sums.resize((((size_t)maxLabel) + 1) * clumpStride, 0);
+                parents.resize(((size_t)maxLabel) + 1, 0);
+                firstStrips.resize(((size_t)maxLabel) + 1, UINT_MAX);
             }
-            else
+            for(size_t p = 0; p < numPxls; ++p)
             {
-                for(unsigned int n = 0; n < numSpecBands; ++n)
+                sums[((size_t)labels[p]) * clumpStride] += 1;
+            }
+            if(parentBand != NULL)
+            {
+                // Strips are taken in increasing order so the first found by a thread is its earliest.
+                for(size_t p = 0; p < numPxls; ++p)
                 {
-                    if((*iterClumps)->meanVals[n] < minVals[n])
+                    if(firstStrips[labels[p]] == UINT_MAX)
                     {
-                        minVals[n] = (*iterClumps)->meanVals[n];
-                    }
-                    else if((*iterClumps)->meanVals[n] > maxVals[n])
-                    {
-                        maxVals[n] = (*iterClumps)->meanVals[n];
+                        firstStrips[labels[p]] = s;
+                        parents[labels[p]] = parentLabels[p];
                     }
                 }
             }
-        }
-        
-        unsigned int **histogram = new unsigned int*[numSpecBands];
-        unsigned int *numBins = new unsigned int[numSpecBands];
-        unsigned int numVals = 0;
-        for(unsigned int n = 0; n < numSpecBands; ++n)
-        {
-            numBins[n] = ceil(maxVals[n] - minVals[n]);
-            histogram[n] = new unsigned int[numBins[n]];
-            for(unsigned int i = 0; i < numBins[n]; ++i)
+            for(unsigned int n = 0; n < numSpecBands; ++n)
             {
-                histogram[n][i] = 0;
+                const float *bandVals = &stripVals[n * numPxls];
+                double *bandSums = &sums[n + 1];
+                double *bandSumSqs = &sums[n + 1 + numSpecBands];
+                for(size_t p = 0; p < numPxls; ++p)
+                {
+                    size_t idx = ((size_t)labels[p]) * clumpStride;
+                    double val = bandVals[p];
+                    bandSums[idx] += val;
+                    bandSumSqs[idx] += val * val;
+                }
             }
-        }
-        
-        unsigned int idx = 0;
-        for(std::vector<rsgis::img::ImgClumpMean*>::iterator iterClumps = clumpTab->begin(); iterClumps != clumpTab->end(); ++iterClumps)
+        });
+
+        // Add the threads' sums together, keeping the parent from the earliest strip.
+        std::vector<double> &totals = threadSums[0];
+        std::vector<unsigned int> &parents = threadParents[0];
+        std::vector<unsigned int> &firstStrips = threadFirstStrips[0];
+        for(unsigned int t = 1; t < nThreads; ++t)
         {
-            for(unsigned int n = 0; n < numSpecBands; ++n)
+            if(threadSums[t].size() > totals.size())
             {
-                idx = floor((*iterClumps)->meanVals[n] - minVals[n]);
-                ++histogram[n][idx];
+                totals.resize(threadSums[t].size(), 0);
+                parents.resize(threadParents[t].size(), 0);
+                firstStrips.resize(threadFirstStrips[t].size(), UINT_MAX);
             }
-            ++numVals;
-        }
-        
-        float *specThresholds = new float[numSpecBands];
-        unsigned int sum = 0;
-        for(unsigned int n = 0; n < numSpecBands; ++n)
-        {
-            sum = 0;
-            for(long i = numBins[n]-1; i >= 0; --i)
+            for(size_t i = 0; i < threadSums[t].size(); ++i)
             {
-                sum += histogram[n][i];
-                if((((float)sum)/numVals) > percentThresholds[n])
-                {
-                    specThresholds[n] = minVals[n] + i;
-                    std::cout << "Band " << n+1 << " threshold = " << specThresholds[n] << std::endl;
-                    break;
-                }
+                totals[i] += threadSums[t][i];
             }
-        }
-        
-        bool classified = false;
-        for(unsigned int i = 0; i < height; ++i)
-        {
-            clumpBand->RasterIO(GF_Read, 0, i, width, 1, clumpIdxs, width, 1, GDT_UInt32, 0, 0);
-            
-            for(unsigned int j = 0; j < width; ++j)
+            for(size_t i = 0; i < threadFirstStrips[t].size(); ++i)
             {
-                if(clumpIdxs[j] != 0)
-                {
-                    classified = true;
-                    cClump = clumpTab->at(clumpIdxs[j] - 1);
-                    for(unsigned int n = 0; n < numSpecBands; ++n)
-                    {
-                        if(cClump->meanVals[n] < specThresholds[n])
-                        {
-                            classified = false;
-                        }
-                    }
-                    
-                    if(classified)
-                    {
-                        outVals[j] = clumpIdxs[j];
-                    }
-                    else
-                    {
-                        outVals[j] = 0;
-                    }
-                }
-                else
+                if(threadFirstStrips[t][i] < firstStrips[i])
                 {
-                    outVals[j] = 0;
+                    firstStrips[i] = threadFirstStrips[t][i];
+                    parents[i] = threadParents[t][i];
                 }
             }
-            
-            outBand->RasterIO(GF_Write, 0, i, width, 1, outVals, width, 1, GDT_UInt32, 0, 0);
+            std::vector<double>().swap(threadSums[t]);
+            std::vector<unsigned int>().swap(threadParents[t]);
+            std::vector<unsigned int>().swap(threadFirstStrips[t]);
         }
-        
-        
-        delete [] specThresholds;
-        delete [] percentThresholds;
-        delete [] minVals;
-        delete [] maxVals;
-        delete [] numBins;
-        
-        for(unsigned int n = 0; n < numSpecBands; ++n)
+        if(totals.empty())
         {
-            delete [] histogram[n];
+            totals.assign(clumpStride, 0);
+            parents.assign(1, 0);
         }
-        delete [] histogram;
-        
-        delete[] clumpIdxs;
-        for(unsigned int n = 0; n < numSpecBands; ++n)
+
+        // Convert the sums to means and variances in place.
+        this->maxClumpID = (totals.size() / clumpStride) - 1;
+        for(size_t c = 0; c <= this->maxClumpID; ++c)
         {
-            delete[] spectralVals[n];
+            double *clumpStats = &totals[c * clumpStride];
+            double count = clumpStats[0];
+            for(unsigned int n = 0; n < numSpecBands; ++n)
+            {
+                double meanVal = (count > 0)?(clumpStats[n + 1] / count):0;
+                double varVal = (count > 0)?((clumpStats[n + 1 + numSpecBands] / count) - (meanVal * meanVal)):0;
+                clumpStats[n + 1] = meanVal;
+                clumpStats[n + 1 + numSpecBands] = std::max(0.0, varVal);
+            }
         }
-        delete[] spectralVals;
-        
-        delete[] spectralBands;
-        
-        delete[] outVals;
-        
-        for(std::vector<rsgis::img::ImgClumpMean*>::iterator iterClumps = clumpTab->begin(); iterClumps != clumpTab->end(); ++iterClumps)
+        this->stats.swap(totals);
+        this->parentIDs.swap(parents);
+        if(parentBand == NULL)
         {
-            delete[] (*iterClumps)->meanVals;
-            delete[] (*iterClumps)->sumVals;
-            delete *iterClumps;
+            this->parentIDs.assign(this->maxClumpID + 1, 0);
         }
-        delete clumpTab;
     }
-    
-    void RSGISGenerateSeeds::genSeedsHistogram(GDALDataset *spectral, GDALDataset *clumps, std::string outputFile, std::vector<BandThreshold> *thresholds) 
+
+    unsigned long RSGISClumpSpectralStats::calcMeanHistogram(unsigned int band, unsigned int numBins, std::vector<unsigned long> *histogram, double *minVal, double *binWidth) const
     {
-        if(spectral->GetRasterXSize() != clumps->GetRasterXSize())
+        if(band >= this->numBands)
         {
-            throw rsgis::img::RSGISImageCalcException("Widths are not the same");
+            throw rsgis::img::RSGISImageCalcException("Band specified is not within the image.");
         }
-        if(spectral->GetRasterYSize() != clumps->GetRasterYSize())
+        if(numBins == 0)
         {
-            throw rsgis::img::RSGISImageCalcException("Heights are not the same");
+            throw rsgis::img::RSGISImageCalcException("The number of histogram bins must be greater than 0.");
         }
-        
+
+        unsigned long numVals = 0;
+        double maxVal = 0;
+        *minVal = 0;
+        for(unsigned long c = 1; c <= this->maxClumpID; ++c)
+        {
+            if(this->getNumPxls(c) == 0)
+            {
+                continue;
+            }
+            double meanVal = this->getMean(c, band);
+            if((numVals == 0) || (meanVal < *minVal))
+            {
+                *minVal = meanVal;
+            }
+            if((numVals == 0) || (meanVal > maxVal))
+            {
+                maxVal = meanVal;
+            }
+            ++numVals;
+        }
+
+        *binWidth = (maxVal > *minVal)?((maxVal - *minVal) / numBins):1;
+        histogram->assign(numBins, 0);
+        for(unsigned long c = 1; c <= this->maxClumpID; ++c)
+        {
+            if(this->getNumPxls(c) == 0)
+            {
+                continue;
+            }
+            // The maximum falls on the upper edge of the last bin.
+            unsigned long idx = floor((this->getMean(c, band) - *minVal) / *binWidth);
+            ++(*histogram)[std::min<unsigned long>(idx, numBins-1)];
+        }
+        return numVals;
+    }
+
+    RSGISClumpSpectralStats::~RSGISClumpSpectralStats()
+    {
+
+    }
+
+
+
+    RSGISGenerateSeeds::RSGISGenerateSeeds()
+    {
+
+    }
+
+    void RSGISGenerateSeeds::genSeedsHistogram(GDALDataset *spectral, GDALDataset *clumps, GDALDataset *output, std::vector<BandThreshold> *thresholds, unsigned int numBins)
+    {
+        if((spectral->GetRasterXSize() != output->GetRasterXSize()) |
+           (spectral->GetRasterYSize() != output->GetRasterYSize()))
+        {
+            throw rsgis::img::RSGISImageCalcException("The output image is not the same size as the input images.");
+        }
+
+        std::vector<unsigned int> seedLUT;
+        this->findSeedClumps(spectral, clumps, thresholds, numBins, &seedLUT);
+
+        RSGISClumpRelabeller relabeller;
+        relabeller.applyLUT(clumps->GetRasterBand(1), output->GetRasterBand(1), seedLUT, NULL);
+    }
+
+    void RSGISGenerateSeeds::genSeedsHistogram(GDALDataset *spectral, GDALDataset *clumps, std::string outputFile, std::vector<BandThreshold> *thresholds, unsigned int numBins)
+    {
+        std::vector<unsigned int> seedLUT;
+        this->findSeedClumps(spectral, clumps, thresholds, numBins, &seedLUT);
+
+        std::ofstream outTxtFile;
+        outTxtFile.open(outputFile.c_str());
+        unsigned long seedID = 1;
+        for(size_t c = 1; c < seedLUT.size(); ++c)
+        {
+            if(seedLUT[c] != 0)
+            {
+                outTxtFile << c << "," << seedID++ << std::endl;
+            }
+        }
+        outTxtFile.flush();
+        outTxtFile.close();
+    }
+
+    void RSGISGenerateSeeds::findSeedClumps(GDALDataset *spectral, GDALDataset *clumps, std::vector<BandThreshold> *thresholds, unsigned int numBins, std::vector<unsigned int> *seedLUT)
+    {
         if(((unsigned int)spectral->GetRasterCount()) != thresholds->size())
         {
             throw rsgis::img::RSGISImageCalcException("The number of bands is not the same as the number of thresholds supplied.");
         }
-        
+
         for(unsigned int i = 0; i < thresholds->size(); ++i)
         {
             if((thresholds->at(i).band < 1) | (thresholds->at(i).band > ((unsigned int) spectral->GetRasterCount())))
@@ -828,12 +743,9 @@ namespace rsgis{namespace segment{
                 throw rsgis::img::RSGISImageCalcException("Band specified is not within the image.");
             }
         }
-                
-        unsigned int width = spectral->GetRasterXSize();
-        unsigned int height = spectral->GetRasterYSize();
+
         unsigned int numSpecBands = spectral->GetRasterCount();
-        
-        float *percentThresholds = new float[numSpecBands];
+        std::vector<float> percentThresholds(numSpecBands, 0);
         bool bandFound = false;
         for(unsigned int i = 1; i <= numSpecBands; ++i)
         {
@@ -856,1035 +768,217 @@ namespace rsgis{namespace segment{
                 throw rsgis::img::RSGISImageCalcException("Thresholds were not provided for all bands.");
             }
         }
-        
-        
-        unsigned int *clumpIdxs = new unsigned int[width];
-        float **spectralVals = new float*[numSpecBands];
-        
-        GDALRasterBand **spectralBands = new GDALRasterBand*[numSpecBands];
+
+        RSGISClumpSpectralStats clumpStats;
+        clumpStats.calcStats(spectral, clumps);
+        unsigned long maxClumpID = clumpStats.getMaxClumpID();
+
+        // The threshold is the lower edge of the bin where the proportion of
+        // the clumps above it first exceeds the band's threshold.
+        std::vector<double> specThresholds(numSpecBands, 0);
+        std::vector<unsigned long> histogram;
         for(unsigned int n = 0; n < numSpecBands; ++n)
         {
-            spectralBands[n] = spectral->GetRasterBand(n+1);
-            spectralVals[n] = new float[width]; 
-        }
-        GDALRasterBand *clumpBand = clumps->GetRasterBand(1);
-        
-        unsigned long maxClumpIdx = 0;
-        for(unsigned int i = 0; i < height; ++i)
-        {
-            clumpBand->RasterIO(GF_Read, 0, i, width, 1, clumpIdxs, width, 1, GDT_UInt32, 0, 0);
-            for(unsigned int j = 0; j < width; ++j)
-            {
-                if((i == 0) & (j == 0))
-                {
-                    maxClumpIdx = clumpIdxs[j];
-                }
-                else if(clumpIdxs[j] > maxClumpIdx)
-                {
-                    maxClumpIdx = clumpIdxs[j];
-                }
-            }
-        }
-        
-        std::vector<rsgis::img::ImgClumpMean*> *clumpTab = new std::vector<rsgis::img::ImgClumpMean*>();
-        clumpTab->reserve(maxClumpIdx);
-        rsgis::img::ImgClumpMean *cClump;
-        for(unsigned int i = 0; i < maxClumpIdx; ++i)
-        {
-            cClump = new rsgis::img::ImgClumpMean(i+1);
-            cClump->sumVals = new float[numSpecBands];
-            cClump->meanVals = new float[numSpecBands];
-            for(unsigned int n = 0; n < numSpecBands; ++n)
-            {
-                cClump->sumVals[n] = 0;
-                cClump->meanVals[n] = 0;
-            }
-            clumpTab->push_back(cClump);
-        }
-        
-        for(unsigned int i = 0; i < height; ++i)
-        {
-            clumpBand->RasterIO(GF_Read, 0, i, width, 1, clumpIdxs, width, 1, GDT_UInt32, 0, 0);
-            for(unsigned int n = 0; n < numSpecBands; ++n)
-            {
-                spectralBands[n]->RasterIO(GF_Read, 0, i, width, 1, spectralVals[n], width, 1, GDT_Float32, 0, 0);
-            }
-            for(unsigned int j = 0; j < width; ++j)
-            {
-                if(clumpIdxs[j] != 0)
-                {
-                    cClump = clumpTab->at(clumpIdxs[j] - 1);
-                    for(unsigned int n = 0; n < numSpecBands; ++n)
-                    {
-                        cClump->sumVals[n] += spectralVals[n][j];
-                    }
-                    ++cClump->numPxls;
-                }
-            }
-        }
-        
-        
-        
-        for(std::vector<rsgis::img::ImgClumpMean*>::iterator iterClumps = clumpTab->begin(); iterClumps != clumpTab->end(); ++iterClumps)
-        {
-            for(unsigned int n = 0; n < numSpecBands; ++n)
-            {
-                (*iterClumps)->meanVals[n] = (*iterClumps)->sumVals[n] / (*iterClumps)->numPxls;
-            }
-        }
-        
-        float *minVals = new float[numSpecBands];
-        float *maxVals = new float[numSpecBands];
-        bool first = true;
-        for(std::vector<rsgis::img::ImgClumpMean*>::iterator iterClumps = clumpTab->begin(); iterClumps != clumpTab->end(); ++iterClumps)
-        {
-            if(first)
-            {
-                for(unsigned int n = 0; n < numSpecBands; ++n)
-                {
-                    minVals[n] = (*iterClumps)->meanVals[n];
-                    maxVals[n] = (*iterClumps)->meanVals[n];
-                }
-                first = false;
-            }
-            else
+            double minVal = 0;
+            double binWidth = 0;
+            unsigned long numVals = clumpStats.calcMeanHistogram(n, numBins, &histogram, &minVal, &binWidth);
+            specThresholds[n] = minVal;
+            unsigned long sum = 0;
+            for(long i = numBins-1; i >= 0; --i)
             {
-                for(unsigned int n = 0; n < numSpecBands; ++n)
+                sum += histogram[i];
+                if((((double)sum)/numVals) > percentThresholds[n])
                 {
-                    if((*iterClumps)->meanVals[n] < minVals[n])
-                    {
-                        minVals[n] = (*iterClumps)->meanVals[n];
-                    }
-                    else if((*iterClumps)->meanVals[n] > maxVals[n])
-                    {
-                        maxVals[n] = (*iterClumps)->meanVals[n];
-                    }
+                    specThresholds[n] = minVal + (i * binWidth);
+                    break;
                 }
             }
+            std::cout << "Band " << n+1 << " threshold = " << specThresholds[n] << std::endl;
         }
-        
-        unsigned int **histogram = new unsigned int*[numSpecBands];
-        unsigned int *numBins = new unsigned int[numSpecBands];
-        unsigned int numVals = 0;
-        for(unsigned int n = 0; n < numSpecBands; ++n)
+
+        seedLUT->assign(maxClumpID + 1, 0);
+        for(unsigned long c = 1; c <= maxClumpID; ++c)
         {
-            numBins[n] = ceil(maxVals[n] - minVals[n]);
-            histogram[n] = new unsigned int[numBins[n]];
-            for(unsigned int i = 0; i < numBins[n]; ++i)
+            if(clumpStats.getNumPxls(c) == 0)
             {
-                histogram[n][i] = 0;
+                continue;
             }
-        }
-        
-        unsigned int idx = 0;
-        for(std::vector<rsgis::img::ImgClumpMean*>::iterator iterClumps = clumpTab->begin(); iterClumps != clumpTab->end(); ++iterClumps)
-        {
+            bool seed = true;
             for(unsigned int n = 0; n < numSpecBands; ++n)
             {
-                idx = floor((*iterClumps)->meanVals[n] - minVals[n]);
-                ++histogram[n][idx];
-            }
-            ++numVals;
-        }
-        
-        float *specThresholds = new float[numSpecBands];
-        unsigned int sum = 0;
-        for(unsigned int n = 0; n < numSpecBands; ++n)
-        {
-            sum = 0;
-            for(long i = numBins[n]-1; i >= 0; --i)
-            {
-                sum += histogram[n][i];
-                if((((float)sum)/numVals) > percentThresholds[n])
+                if(clumpStats.getMean(c, n) < specThresholds[n])
                 {
-                    specThresholds[n] = minVals[n] + i;
-                    std::cout << "Band " << n+1 << " threshold = " << specThresholds[n] << std::endl;
+                    seed = false;
                     break;
                 }
             }
-        }
-        
-        bool classified = false;
-        std::list<unsigned long> outClumpsIds;
-        for(unsigned int i = 0; i < height; ++i)
-        {
-            clumpBand->RasterIO(GF_Read, 0, i, width, 1, clumpIdxs, width, 1, GDT_UInt32, 0, 0);
-            
-            for(unsigned int j = 0; j < width; ++j)
+            if(seed)
             {
-                if(clumpIdxs[j] != 0)
-                {
-                    classified = true;
-                    cClump = clumpTab->at(clumpIdxs[j] - 1);
-                    for(unsigned int n = 0; n < numSpecBands; ++n)
-                    {
-                        if(cClump->meanVals[n] < specThresholds[n])
-                        {
-                            classified = false;
-                        }
-                    }
-                    
-                    if(classified)
-                    {
-                        outClumpsIds.push_back(clumpIdxs[j]);
-                    }
-                }
-            }            
-        }
-        
-        outClumpsIds.sort();
-        outClumpsIds.unique();
-        
-        std::ofstream outTxtFile;
-        outTxtFile.open(outputFile.c_str());
-        unsigned long seedID = 1;
-        for(std::list<unsigned long>::iterator iterClumps = outClumpsIds.begin(); iterClumps != outClumpsIds.end(); ++iterClumps)
-        {
-            outTxtFile << *iterClumps << "," << seedID++ << std::endl;
-        }
-        outTxtFile.flush();
-        outTxtFile.close();
-        
-        delete [] specThresholds;
-        delete [] percentThresholds;
-        delete [] minVals;
-        delete [] maxVals;
-        delete [] numBins;
-        
-        for(unsigned int n = 0; n < numSpecBands; ++n)
-        {
-            delete [] histogram[n];
-        }
-        delete [] histogram;
-        
-        delete[] clumpIdxs;
-        for(unsigned int n = 0; n < numSpecBands; ++n)
-        {
-            delete[] spectralVals[n];
-        }
-        delete[] spectralVals;
-        
-        delete[] spectralBands;
-                
-        for(std::vector<rsgis::img::ImgClumpMean*>::iterator iterClumps = clumpTab->begin(); iterClumps != clumpTab->end(); ++iterClumps)
-        {
-            delete[] (*iterClumps)->meanVals;
-            delete[] (*iterClumps)->sumVals;
-            delete *iterClumps;
+                (*seedLUT)[c] = c;
+            }
         }
-        delete clumpTab;
     }
-    
+
     RSGISGenerateSeeds::~RSGISGenerateSeeds()
     {
-        
+
     }
-    
-    
-    
+
+
+
     RSGISSelectClumps::RSGISSelectClumps()
     {
-        
+
     }
-    
-    void RSGISSelectClumps::selectClumps(GDALDataset *spectral, GDALDataset *clumps, GDALDataset *largeClumps, GDALDataset *output, ClumpSelection selection) 
+
+    void RSGISSelectClumps::selectClumps(GDALDataset *spectral, GDALDataset *clumps, GDALDataset *largeClumps, GDALDataset *output, ClumpSelection selection)
     {
-        if((spectral->GetRasterXSize() != clumps->GetRasterXSize()) |
-           (spectral->GetRasterXSize() != largeClumps->GetRasterXSize()) |
-           (spectral->GetRasterXSize() != output->GetRasterXSize()))
-        {
-            throw rsgis::img::RSGISImageCalcException("Widths are not the same");
-        }
-        if((spectral->GetRasterYSize() != clumps->GetRasterYSize()) |
-           (spectral->GetRasterYSize() != largeClumps->GetRasterYSize()) |
+        if((spectral->GetRasterXSize() != output->GetRasterXSize()) |
            (spectral->GetRasterYSize() != output->GetRasterYSize()))
         {
-            throw rsgis::img::RSGISImageCalcException("Heights are not the same");
+            throw rsgis::img::RSGISImageCalcException("The output image is not the same size as the input images.");
         }
 
-        
-        rsgis::img::RSGISImageUtils imgUtils;
-        imgUtils.zerosUIntGDALDataset(output);
-        
-        unsigned int width = spectral->GetRasterXSize();
-        unsigned int height = spectral->GetRasterYSize();
-        unsigned int numSpecBands = spectral->GetRasterCount();
-        
-        unsigned int *clumpIdxs = new unsigned int[width];
-        unsigned int *lClumpIdxs = new unsigned int[width];
-        unsigned int *outClumpIdxs = new unsigned int[width];
-        float **spectralVals = new float*[numSpecBands];
-        
-        GDALRasterBand **spectralBands = new GDALRasterBand*[numSpecBands];
-        for(unsigned int n = 0; n < numSpecBands; ++n)
-        {
-            spectralBands[n] = spectral->GetRasterBand(n+1);
-            spectralVals[n] = new float[width]; 
-        }
-        GDALRasterBand *clumpBand = clumps->GetRasterBand(1);
-        GDALRasterBand *lClumpBand = largeClumps->GetRasterBand(1);
-        GDALRasterBand *outClumpBand = output->GetRasterBand(1);
-        
-        unsigned long maxClumpIdx = 0;
-        unsigned long maxLClumpIdx = 0;
-        for(unsigned int i = 0; i < height; ++i)
-        {
-            clumpBand->RasterIO(GF_Read, 0, i, width, 1, clumpIdxs, width, 1, GDT_UInt32, 0, 0);
-            lClumpBand->RasterIO(GF_Read, 0, i, width, 1, lClumpIdxs, width, 1, GDT_UInt32, 0, 0);
-            for(unsigned int j = 0; j < width; ++j)
-            {
-                if((i == 0) & (j == 0))
-                {
-                    maxClumpIdx = clumpIdxs[j];
-                    maxLClumpIdx = lClumpIdxs[j];
-                }
-                else 
-                {
-                    if(clumpIdxs[j] > maxClumpIdx)
-                    {
-                        maxClumpIdx = clumpIdxs[j];
-                    }
-                    
-                    if(lClumpIdxs[j] > maxLClumpIdx)
-                    {
-                        maxLClumpIdx = lClumpIdxs[j];
-                    }
-                }
-            }
-        }
-        
-        std::vector< std::list<unsigned long>* > *largeClumpTab = new std::vector< std::list<unsigned long>* >();
-        largeClumpTab->reserve(maxLClumpIdx);
-        for(unsigned int i = 0; i < maxLClumpIdx; ++i)
-        {
-            largeClumpTab->push_back(new std::list<unsigned long>());
-        }
-        
-        std::vector<rsgis::img::ImgClumpMean*> *clumpTab = new std::vector<rsgis::img::ImgClumpMean*>();
-        clumpTab->reserve(maxClumpIdx);
-        rsgis::img::ImgClumpMean *cClump;
-        for(unsigned int i = 0; i < maxClumpIdx; ++i)
-        {
-            cClump = new rsgis::img::ImgClumpMean(i+1);
-            cClump->sumVals = new float[numSpecBands];
-            cClump->meanVals = new float[numSpecBands];
-            for(unsigned int n = 0; n < numSpecBands; ++n)
-            {
-                cClump->sumVals[n] = 0;
-                cClump->meanVals[n] = 0;
-            }
-            clumpTab->push_back(cClump);
-        }
-        
-        for(unsigned int i = 0; i < height; ++i)
-        {
-            clumpBand->RasterIO(GF_Read, 0, i, width, 1, clumpIdxs, width, 1, GDT_UInt32, 0, 0);
-            lClumpBand->RasterIO(GF_Read, 0, i, width, 1, lClumpIdxs, width, 1, GDT_UInt32, 0, 0);
-            for(unsigned int n = 0; n < numSpecBands; ++n)
-            {
-                spectralBands[n]->RasterIO(GF_Read, 0, i, width, 1, spectralVals[n], width, 1, GDT_Float32, 0, 0);
-            }
-            for(unsigned int j = 0; j < width; ++j)
-            {
-                if(clumpIdxs[j] != 0)
-                {
-                    cClump = clumpTab->at(clumpIdxs[j] - 1);
-                    for(unsigned int n = 0; n < numSpecBands; ++n)
-                    {
-                        cClump->sumVals[n] += spectralVals[n][j];
-                    }
-                    ++cClump->numPxls;
-                }
-                
-                if(lClumpIdxs[j] != 0)
-                {
-                    largeClumpTab->at(lClumpIdxs[j]-1)->push_back(clumpIdxs[j]);
-                }
-            }
-        }
-        
-        for(std::vector<rsgis::img::ImgClumpMean*>::iterator iterClumps = clumpTab->begin(); iterClumps != clumpTab->end(); ++iterClumps)
+        std::vector<unsigned int> selected;
+        this->findSelectedClumps(spectral, clumps, largeClumps, selection, &selected);
+
+        std::vector<unsigned int> selectLUT;
+        for(std::vector<unsigned int>::iterator iterClump = selected.begin(); iterClump != selected.end(); ++iterClump)
         {
-            for(unsigned int n = 0; n < numSpecBands; ++n)
+            if(*iterClump >= selectLUT.size())
             {
-                (*iterClumps)->meanVals[n] = (*iterClumps)->sumVals[n] / (*iterClumps)->numPxls;
+                selectLUT.resize(((size_t)*iterClump) + 1, 0);
             }
+            selectLUT[*iterClump] = *iterClump;
         }
-        
-        for(unsigned int i = 0; i < maxLClumpIdx; ++i)
-        {
-            largeClumpTab->at(i)->sort();
-            largeClumpTab->at(i)->unique();
-        }
-        
-        std::list<unsigned long> outClumps;
-        float tmpMeanVal = 0;
-        float distVal = 0;
-        unsigned long sClump = 0;
-        float meanVal = 0;
-        float meanBrightness = 0;
-        float medianBrightness = 0;
-        float sumVals = 0;
-        std::list<float> allVals;
-        std::vector<double> allValsVec;
-        bool first = true;
-        for(unsigned int i = 0; i < maxLClumpIdx; ++i)
-        {
-            first = true;
-            allValsVec.clear();
-            allVals.clear();
-            sumVals = 0;
-            if(largeClumpTab->at(i)->size() > 0)
-            {
-                for(std::list<unsigned long>::iterator iterClump = largeClumpTab->at(i)->begin(); iterClump != largeClumpTab->at(i)->end(); ++iterClump)
-                {
-                    for(unsigned int i = 0; i < numSpecBands; ++i)
-                    {
-                        if(i == 0)
-                        {
-                            meanVal = clumpTab->at((*iterClump)-1)->meanVals[i];
-                        }
-                        else
-                        {
-                            meanVal += clumpTab->at((*iterClump)-1)->meanVals[i];
-                        }
-                    }
-                    meanVal = meanVal / numSpecBands;
-                    if((selection == min) | (selection == max))
-                    {
-                        if(first)
-                        {
-                            tmpMeanVal = meanVal;
-                            sClump = *iterClump;
-                            first = false;
-                        }
-                        else
-                        {
-                            if(selection == max)
-                            {
-                                if(meanVal > tmpMeanVal)
-                                {
-                                    tmpMeanVal = meanVal;
-                                    sClump = *iterClump;
-                                }
-                            }
-                            else if(selection == min)
-                            {
-                                if(meanVal < tmpMeanVal)
-                                {
-                                    tmpMeanVal = meanVal;
-                                    sClump = *iterClump;
-                                }
-                            }
-                        }
-                    }
-                    else if(selection == median)
-                    {
-                        allVals.push_back(meanVal);
-                    }
-                    else if(selection == mean)
-                    {
-                        sumVals += meanVal;
-                    }
-                    else if((selection == percent75th) | (selection == percent95th))
-                    {
-                        allValsVec.push_back(meanVal);
-                    }
-                    else
-                    {
-                        throw rsgis::img::RSGISImageCalcException("Did not recognise clump selection choice.");
-                    }
-                }
-                if(selection == median)
-                {
-                    allVals.sort();
-                    unsigned int counter = 0;
-                    for(std::list<float>::iterator iterVals = allVals.begin(); iterVals != allVals.end(); ++iterVals)
-                    {
-                        if(counter++ == (allVals.size()/2))
-                        {
-                            medianBrightness = *iterVals;
-                            break;
-                        }
-                    }
-                    
-                    first = true;
-                    for(std::list<unsigned long>::iterator iterClump = largeClumpTab->at(i)->begin(); iterClump != largeClumpTab->at(i)->end(); ++iterClump)
-                    {
-                        for(unsigned int i = 0; i < numSpecBands; ++i)
-                        {
-                            if(i == 0)
-                            {
-                                meanVal = clumpTab->at((*iterClump)-1)->meanVals[i];
-                            }
-                            else
-                            {
-                                meanVal += clumpTab->at((*iterClump)-1)->meanVals[i];
-                            }
-                        }
-                        meanVal = meanVal / numSpecBands;
-                        distVal = sqrt((meanVal - meanVal)*(meanVal - meanVal));
-                        if(first)
-                        {
-                            tmpMeanVal = distVal;
-                            sClump = *iterClump;
-                            first = false;
-                        }
-                        else if( distVal < tmpMeanVal)
-                        {
-                            tmpMeanVal = distVal;
-                            sClump = *iterClump;
-                        }
-                    }
-                }
-                else if(selection == mean)
-                {
-                    meanBrightness = sumVals/largeClumpTab->size();
-                    first = true;
-                    for(std::list<unsigned long>::iterator iterClump = largeClumpTab->at(i)->begin(); iterClump != largeClumpTab->at(i)->end(); ++iterClump)
-                    {
-                        for(unsigned int i = 0; i < numSpecBands; ++i)
-                        {
-                            if(i == 0)
-                            {
-                                meanVal = clumpTab->at((*iterClump)-1)->meanVals[i];
-                            }
-                            else
-                            {
-                                meanVal += clumpTab->at((*iterClump)-1)->meanVals[i];
-                            }
-                        }
-                        meanVal = meanVal / numSpecBands;
-                        distVal = sqrt((meanVal - meanBrightness)*(meanVal - meanBrightness));
-                        if(first)
-                        {
-                            tmpMeanVal = distVal;
-                            sClump = *iterClump;
-                            first = false;
-                        }
-                        else if( distVal < tmpMeanVal)
-                        {
-                            tmpMeanVal = distVal;
-                            sClump = *iterClump;
-                        }
-                    }
-                }
-                else if(selection == percent75th)
-                {
-                    std::sort(allValsVec.begin(), allValsVec.end());
-                    float percentileVal = gsl_stats_quantile_from_sorted_data(&allValsVec[0], 1, allValsVec.size(), 0.75);
 
-                    first = true;
-                    for(std::list<unsigned long>::iterator iterClump = largeClumpTab->at(i)->begin(); iterClump != largeClumpTab->at(i)->end(); ++iterClump)
-                    {
-                        for(unsigned int i = 0; i < numSpecBands; ++i)
-                        {
-                            if(i == 0)
-                            {
-                                meanVal = clumpTab->at((*iterClump)-1)->meanVals[i];
-                            }
-                            else
-                            {
-                                meanVal += clumpTab->at((*iterClump)-1)->meanVals[i];
-                            }
-                        }
-                        meanVal = meanVal / numSpecBands;
-                        distVal = sqrt((meanVal - percentileVal)*(meanVal - percentileVal));
-
-                        if(first)
-                        {
-                            tmpMeanVal = distVal;
-                            sClump = *iterClump;
-                            first = false;
-                        }
-                        else if( distVal < tmpMeanVal)
-                        {
-                            tmpMeanVal = distVal;
-                            sClump = *iterClump;
-                        }
-                    }
-                }
-                else if(selection == percent95th)
-                {
-                    std::sort(allValsVec.begin(), allValsVec.end());
-                    float percentileVal = gsl_stats_quantile_from_sorted_data(&allValsVec[0], 1, allValsVec.size(), 0.95);
+        RSGISClumpRelabeller relabeller;
+        relabeller.applyLUT(clumps->GetRasterBand(1), output->GetRasterBand(1), selectLUT, NULL);
+    }
 
-                    first = true;
-                    for(std::list<unsigned long>::iterator iterClump = largeClumpTab->at(i)->begin(); iterClump != largeClumpTab->at(i)->end(); ++iterClump)
-                    {
-                        for(unsigned int i = 0; i < numSpecBands; ++i)
-                        {
-                            if(i == 0)
-                            {
-                                meanVal = clumpTab->at((*iterClump)-1)->meanVals[i];
-                            }
-                            else
-                            {
-                                meanVal += clumpTab->at((*iterClump)-1)->meanVals[i];
-                            }
-                        }
-                        meanVal = meanVal / numSpecBands;
-                        distVal = sqrt((meanVal - percentileVal)*(meanVal - percentileVal));
+    void RSGISSelectClumps::selectClumps(GDALDataset *spectral, GDALDataset *clumps, GDALDataset *largeClumps, std::string outputFile, ClumpSelection selection)
+    {
+        std::vector<unsigned int> selected;
+        this->findSelectedClumps(spectral, clumps, largeClumps, selection, &selected);
 
-                        if(first)
-                        {
-                            tmpMeanVal = distVal;
-                            sClump = *iterClump;
-                            first = false;
-                        }
-                        else if( distVal < tmpMeanVal)
-                        {
-                            tmpMeanVal = distVal;
-                            sClump = *iterClump;
-                        }
-                    }
-                }
-                
-                outClumps.push_back(sClump);
-            }
-        }
-        
-        bool foundClump = false;
-        for(unsigned int i = 0; i < height; ++i)
-        {
-            clumpBand->RasterIO(GF_Read, 0, i, width, 1, clumpIdxs, width, 1, GDT_UInt32, 0, 0);
-            
-            for(unsigned int j = 0; j < width; ++j)
-            {
-                if(clumpIdxs[j] != 0)
-                {
-                    foundClump = false;
-                    for(std::list<unsigned long>::iterator iterClump = outClumps.begin(); iterClump != outClumps.end(); ++iterClump)
-                    {
-                        if(clumpIdxs[j] == *iterClump)
-                        {
-                            outClumpIdxs[j] = clumpIdxs[j];
-                            foundClump = true;
-                            break;
-                        }
-                    }
-                    if(!foundClump)
-                    {
-                        outClumpIdxs[j] = 0;
-                    }
-                }
-                else
-                {
-                    outClumpIdxs[j] = 0;
-                }
-            }
-            
-            outClumpBand->RasterIO(GF_Write, 0, i, width, 1, outClumpIdxs, width, 1, GDT_UInt32, 0, 0);
-        }
-                
-        for(std::vector< std::list<unsigned long>* >::iterator iterLClumps = largeClumpTab->begin(); iterLClumps != largeClumpTab->end(); ++iterLClumps)
-        {
-            delete *iterLClumps;
-        }
-        delete largeClumpTab;
-        
-        delete[] lClumpIdxs;
-        delete[] outClumpIdxs;
-        delete[] clumpIdxs;
-        for(unsigned int n = 0; n < numSpecBands; ++n)
-        {
-            delete[] spectralVals[n];
-        }
-        delete[] spectralVals;
-        delete[] spectralBands;
-        
-        for(std::vector<rsgis::img::ImgClumpMean*>::iterator iterClumps = clumpTab->begin(); iterClumps != clumpTab->end(); ++iterClumps)
+        std::ofstream outTxtFile;
+        outTxtFile.open(outputFile.c_str());
+        unsigned long seedID = 1;
+        for(std::vector<unsigned int>::iterator iterClump = selected.begin(); iterClump != selected.end(); ++iterClump)
         {
-            delete[] (*iterClumps)->meanVals;
-            delete[] (*iterClumps)->sumVals;
-            delete *iterClumps;
+            outTxtFile << *iterClump << "," << seedID++ << std::endl;
         }
-        delete clumpTab;
+        outTxtFile.flush();
+        outTxtFile.close();
     }
-    
-    void RSGISSelectClumps::selectClumps(GDALDataset *spectral, GDALDataset *clumps, GDALDataset *largeClumps, std::string outputFile, ClumpSelection selection) 
+
+    void RSGISSelectClumps::findSelectedClumps(GDALDataset *spectral, GDALDataset *clumps, GDALDataset *largeClumps, ClumpSelection selection, std::vector<unsigned int> *selected)
     {
-        if((spectral->GetRasterXSize() != clumps->GetRasterXSize()) |
-           (spectral->GetRasterXSize() != largeClumps->GetRasterXSize()))
-        {
-            throw rsgis::img::RSGISImageCalcException("Widths are not the same");
-        }
-        if((spectral->GetRasterYSize() != clumps->GetRasterYSize()) |
-           (spectral->GetRasterYSize() != largeClumps->GetRasterYSize()))
-        {
-            throw rsgis::img::RSGISImageCalcException("Heights are not the same");
-        }
-        
-        unsigned int width = spectral->GetRasterXSize();
-        unsigned int height = spectral->GetRasterYSize();
-        unsigned int numSpecBands = spectral->GetRasterCount();
-        
-        unsigned int *clumpIdxs = new unsigned int[width];
-        unsigned int *lClumpIdxs = new unsigned int[width];
-        float **spectralVals = new float*[numSpecBands];
-        
-        GDALRasterBand **spectralBands = new GDALRasterBand*[numSpecBands];
-        for(unsigned int n = 0; n < numSpecBands; ++n)
-        {
-            spectralBands[n] = spectral->GetRasterBand(n+1);
-            spectralVals[n] = new float[width]; 
-        }
-        GDALRasterBand *clumpBand = clumps->GetRasterBand(1);
-        GDALRasterBand *lClumpBand = largeClumps->GetRasterBand(1);
-        
-        unsigned long maxClumpIdx = 0;
-        unsigned long maxLClumpIdx = 0;
-        for(unsigned int i = 0; i < height; ++i)
+        RSGISClumpSpectralStats clumpStats;
+        clumpStats.calcStats(spectral, clumps, largeClumps);
+        unsigned long maxClumpID = clumpStats.getMaxClumpID();
+        unsigned int numSpecBands = clumpStats.getNumBands();
+
+        std::vector<double> brightness(maxClumpID + 1, 0);
+        std::vector<unsigned int> clumpIDs;
+        clumpIDs.reserve(maxClumpID);
+        for(unsigned long c = 1; c <= maxClumpID; ++c)
         {
-            clumpBand->RasterIO(GF_Read, 0, i, width, 1, clumpIdxs, width, 1, GDT_UInt32, 0, 0);
-            lClumpBand->RasterIO(GF_Read, 0, i, width, 1, lClumpIdxs, width, 1, GDT_UInt32, 0, 0);
-            for(unsigned int j = 0; j < width; ++j)
+            if((clumpStats.getNumPxls(c) == 0) || (clumpStats.getParentID(c) == 0))
             {
-                if((i == 0) & (j == 0))
-                {
-                    maxClumpIdx = clumpIdxs[j];
-                    maxLClumpIdx = lClumpIdxs[j];
-                }
-                else 
-                {
-                    if(clumpIdxs[j] > maxClumpIdx)
-                    {
-                        maxClumpIdx = clumpIdxs[j];
-                    }
-                    
-                    if(lClumpIdxs[j] > maxLClumpIdx)
-                    {
-                        maxLClumpIdx = lClumpIdxs[j];
-                    }
-                }
+                continue;
             }
-        }
-        
-        std::vector< std::list<unsigned long>* > *largeClumpTab = new std::vector< std::list<unsigned long>* >();
-        largeClumpTab->reserve(maxLClumpIdx);
-        for(unsigned int i = 0; i < maxLClumpIdx; ++i)
-        {
-            largeClumpTab->push_back(new std::list<unsigned long>());
-        }
-        
-        std::vector<rsgis::img::ImgClumpMean*> *clumpTab = new std::vector<rsgis::img::ImgClumpMean*>();
-        clumpTab->reserve(maxClumpIdx);
-        rsgis::img::ImgClumpMean *cClump;
-        for(unsigned int i = 0; i < maxClumpIdx; ++i)
-        {
-            cClump = new rsgis::img::ImgClumpMean(i+1);
-            cClump->sumVals = new float[numSpecBands];
-            cClump->meanVals = new float[numSpecBands];
+            double sumVal = 0;
             for(unsigned int n = 0; n < numSpecBands; ++n)
             {
-                cClump->sumVals[n] = 0;
-                cClump->meanVals[n] = 0;
+                sumVal += clumpStats.getMean(c, n);
             }
-            clumpTab->push_back(cClump);
+            brightness[c] = sumVal / numSpecBands;
+            clumpIDs.push_back(c);
         }
-        
-        for(unsigned int i = 0; i < height; ++i)
+
+        std::sort(clumpIDs.begin(), clumpIDs.end(), [&](unsigned int a, unsigned int b)
         {
-            clumpBand->RasterIO(GF_Read, 0, i, width, 1, clumpIdxs, width, 1, GDT_UInt32, 0, 0);
-            lClumpBand->RasterIO(GF_Read, 0, i, width, 1, lClumpIdxs, width, 1, GDT_UInt32, 0, 0);
-            for(unsigned int n = 0; n < numSpecBands; ++n)
+            unsigned int parentA = clumpStats.getParentID(a);
+            unsigned int parentB = clumpStats.getParentID(b);
+            if(parentA != parentB)
             {
-                spectralBands[n]->RasterIO(GF_Read, 0, i, width, 1, spectralVals[n], width, 1, GDT_Float32, 0, 0);
+                return parentA < parentB;
             }
-            for(unsigned int j = 0; j < width; ++j)
+            if(brightness[a] != brightness[b])
             {
-                if(clumpIdxs[j] != 0)
-                {
-                    cClump = clumpTab->at(clumpIdxs[j] - 1);
-                    for(unsigned int n = 0; n < numSpecBands; ++n)
-                    {
-                        cClump->sumVals[n] += spectralVals[n][j];
-                    }
-                    ++cClump->numPxls;
-                }
-                
-                if(lClumpIdxs[j] != 0)
-                {
-                    largeClumpTab->at(lClumpIdxs[j]-1)->push_back(clumpIdxs[j]);
-                }
+                return brightness[a] < brightness[b];
             }
-        }
-        
-        for(std::vector<rsgis::img::ImgClumpMean*>::iterator iterClumps = clumpTab->begin(); iterClumps != clumpTab->end(); ++iterClumps)
+            return a < b;
+        });
+
+        selected->clear();
+        std::vector<double> groupVals;
+        size_t groupStart = 0;
+        while(groupStart < clumpIDs.size())
         {
-            for(unsigned int n = 0; n < numSpecBands; ++n)
+            unsigned int parentID = clumpStats.getParentID(clumpIDs[groupStart]);
+            size_t groupEnd = groupStart + 1;
+            while((groupEnd < clumpIDs.size()) && (clumpStats.getParentID(clumpIDs[groupEnd]) == parentID))
             {
-                (*iterClumps)->meanVals[n] = (*iterClumps)->sumVals[n] / (*iterClumps)->numPxls;
+                ++groupEnd;
             }
-        }
-        
-        for(unsigned int i = 0; i < maxLClumpIdx; ++i)
-        {
-            largeClumpTab->at(i)->sort();
-            largeClumpTab->at(i)->unique();
-        }
-        
-        std::list<unsigned long> outClumps;
-        float tmpMeanVal = 0;
-        float distVal = 0;
-        unsigned long sClump = 0;
-        float meanVal = 0;
-        float meanBrightness = 0;
-        float medianBrightness = 0;
-        float sumVals = 0;
-        std::list<float> allVals;
-        std::vector<double> allValsVec;
-        bool first = true;
-        for(unsigned int i = 0; i < maxLClumpIdx; ++i)
-        {
-            first = true;
-            allValsVec.clear();
-            allVals.clear();
-            sumVals = 0;
-            if(largeClumpTab->at(i)->size() > 0)
+
+            // The group is sorted by brightness.
+            groupVals.clear();
+            for(size_t i = groupStart; i < groupEnd; ++i)
             {
-                for(std::list<unsigned long>::iterator iterClump = largeClumpTab->at(i)->begin(); iterClump != largeClumpTab->at(i)->end(); ++iterClump)
-                {
-                    for(unsigned int i = 0; i < numSpecBands; ++i)
-                    {
-                        if(i == 0)
-                        {
-                            meanVal = clumpTab->at((*iterClump)-1)->meanVals[i];
-                        }
-                        else
-                        {
-                            meanVal += clumpTab->at((*iterClump)-1)->meanVals[i];
-                        }
-                    }
-                    meanVal = meanVal / numSpecBands;
-                    if((selection == min) | (selection == max))
-                    {
-                        if(first)
-                        {
-                            tmpMeanVal = meanVal;
-                            sClump = *iterClump;
-                            first = false;
-                        }
-                        else
-                        {
-                            if(selection == max)
-                            {
-                                if(meanVal > tmpMeanVal)
-                                {
-                                    tmpMeanVal = meanVal;
-                                    sClump = *iterClump;
-                                }
-                            }
-                            else if(selection == min)
-                            {
-                                if(meanVal < tmpMeanVal)
-                                {
-                                    tmpMeanVal = meanVal;
-                                    sClump = *iterClump;
-                                }
-                            }
-                        }
-                    }
-                    else if(selection == median)
-                    {
-                        allVals.push_back(meanVal);
-                    }
-                    else if(selection == mean)
-                    {
-                        sumVals += meanVal;
-                    }
-                    else if((selection == percent75th) | (selection == percent95th))
-                    {
-                        allValsVec.push_back(meanVal);
-                    }
-                    else
-                    {
-                        throw rsgis::img::RSGISImageCalcException("Did not recognise clump selection choice.");
-                    }
-                }
-                if(selection == median)
-                {
-                    allVals.sort();
-                    unsigned int counter = 0;
-                    for(std::list<float>::iterator iterVals = allVals.begin(); iterVals != allVals.end(); ++iterVals)
-                    {
-                        if(counter++ == (allVals.size()/2))
-                        {
-                            medianBrightness = *iterVals;
-                            break;
-                        }
-                    }
-                    
-                    first = true;
-                    for(std::list<unsigned long>::iterator iterClump = largeClumpTab->at(i)->begin(); iterClump != largeClumpTab->at(i)->end(); ++iterClump)
-                    {
-                        for(unsigned int i = 0; i < numSpecBands; ++i)
-                        {
-                            if(i == 0)
-                            {
-                                meanVal = clumpTab->at((*iterClump)-1)->meanVals[i];
-                            }
-                            else
-                            {
-                                meanVal += clumpTab->at((*iterClump)-1)->meanVals[i];
-                            }
-                        }
-                        meanVal = meanVal / numSpecBands;
-                        distVal = sqrt((meanVal - meanVal)*(meanVal - meanVal));
-                        if(first)
-                        {
-                            tmpMeanVal = distVal;
-                            sClump = *iterClump;
-                            first = false;
-                        }
-                        else if( distVal < tmpMeanVal)
-                        {
-                            tmpMeanVal = distVal;
-                            sClump = *iterClump;
-                        }
-                    }
-                }
-                else if(selection == mean)
+                groupVals.push_back(brightness[clumpIDs[i]]);
+            }
+            double targetVal = 0;
+            switch(selection)
+            {
+                case min:
+                    targetVal = groupVals.front();
+                    break;
+                case max:
+                    targetVal = groupVals.back();
+                    break;
+                case median:
+                    targetVal = groupVals[groupVals.size()/2];
+                    break;
+                case mean:
                 {
-                    meanBrightness = sumVals/largeClumpTab->size();
-                    first = true;
-                    for(std::list<unsigned long>::iterator iterClump = largeClumpTab->at(i)->begin(); iterClump != largeClumpTab->at(i)->end(); ++iterClump)
+                    double sumVal = 0;
+                    for(std::vector<double>::iterator iterVal = groupVals.begin(); iterVal != groupVals.end(); ++iterVal)
                     {
-                        for(unsigned int i = 0; i < numSpecBands; ++i)
-                        {
-                            if(i == 0)
-                            {
-                                meanVal = clumpTab->at((*iterClump)-1)->meanVals[i];
-                            }
-                            else
-                            {
-                                meanVal += clumpTab->at((*iterClump)-1)->meanVals[i];
-                            }
-                        }
-                        meanVal = meanVal / numSpecBands;
-                        distVal = sqrt((meanVal - meanBrightness)*(meanVal - meanBrightness));
-                        if(first)
-                        {
-                            tmpMeanVal = distVal;
-                            sClump = *iterClump;
-                            first = false;
-                        }
-                        else if( distVal < tmpMeanVal)
-                        {
-                            tmpMeanVal = distVal;
-                            sClump = *iterClump;
-                        }
+                        sumVal += *iterVal;
                     }
+                    targetVal = sumVal / groupVals.size();
+                    break;
                 }
-                else if(selection == percent75th)
-                {
-                    std::sort(allValsVec.begin(), allValsVec.end());
-                    float percentileVal = gsl_stats_quantile_from_sorted_data(&allValsVec[0], 1, allValsVec.size(), 0.75);
-
-                    first = true;
-                    for(std::list<unsigned long>::iterator iterClump = largeClumpTab->at(i)->begin(); iterClump != largeClumpTab->at(i)->end(); ++iterClump)
-                    {
-                        for(unsigned int i = 0; i < numSpecBands; ++i)
-                        {
-                            if(i == 0)
-                            {
-                                meanVal = clumpTab->at((*iterClump)-1)->meanVals[i];
-                            }
-                            else
-                            {
-                                meanVal += clumpTab->at((*iterClump)-1)->meanVals[i];
-                            }
-                        }
-                        meanVal = meanVal / numSpecBands;
-                        distVal = sqrt((meanVal - percentileVal)*(meanVal - percentileVal));
+                case percent75th:
+                    targetVal = gsl_stats_quantile_from_sorted_data(&groupVals[0], 1, groupVals.size(), 0.75);
+                    break;
+                case percent95th:
+                    targetVal = gsl_stats_quantile_from_sorted_data(&groupVals[0], 1, groupVals.size(), 0.95);
+                    break;
+                default:
+                    throw rsgis::img::RSGISImageCalcException("Did not recognise clump selection choice.");
+            }
 
-                        if(first)
-                        {
-                            tmpMeanVal = distVal;
-                            sClump = *iterClump;
-                            first = false;
-                        }
-                        else if( distVal < tmpMeanVal)
-                        {
-                            tmpMeanVal = distVal;
-                            sClump = *iterClump;
-                        }
-                    }
-                }
-                else if(selection == percent95th)
+            // The first clump closest to the target brightness.
+            size_t selectIdx = groupStart;
+            double minDist = fabs(groupVals[0] - targetVal);
+            for(size_t i = groupStart + 1; i < groupEnd; ++i)
+            {
+                double dist = fabs(groupVals[i - groupStart] - targetVal);
+                if(dist < minDist)
                 {
-                    std::sort(allValsVec.begin(), allValsVec.end());
-                    float percentileVal = gsl_stats_quantile_from_sorted_data(&allValsVec[0], 1, allValsVec.size(), 0.95);
-
-                    first = true;
-                    for(std::list<unsigned long>::iterator iterClump = largeClumpTab->at(i)->begin(); iterClump != largeClumpTab->at(i)->end(); ++iterClump)
-                    {
-                        for(unsigned int i = 0; i < numSpecBands; ++i)
-                        {
-                            if(i == 0)
-                            {
-                                meanVal = clumpTab->at((*iterClump)-1)->meanVals[i];
-                            }
-                            else
-                            {
-                                meanVal += clumpTab->at((*iterClump)-1)->meanVals[i];
-                            }
-                        }
-                        meanVal = meanVal / numSpecBands;
-                        distVal = sqrt((meanVal - percentileVal)*(meanVal - percentileVal));
-
-                        if(first)
-                        {
-                            tmpMeanVal = distVal;
-                            sClump = *iterClump;
-                            first = false;
-                        }
-                        else if( distVal < tmpMeanVal)
-                        {
-                            tmpMeanVal = distVal;
-                            sClump = *iterClump;
-                        }
-                    }
+                    minDist = dist;
+                    selectIdx = i;
                 }
-                
-                outClumps.push_back(sClump);
             }
+            selected->push_back(clumpIDs[selectIdx]);
+            groupStart = groupEnd;
         }
-        
-        std::ofstream outTxtFile;
-        outTxtFile.open(outputFile.c_str());
-        unsigned long seedID = 1;
-        for(std::list<unsigned long>::iterator iterClumps = outClumps.begin(); iterClumps != outClumps.end(); ++iterClumps)
-        {
-            outTxtFile << *iterClumps << "," << seedID++ << std::endl;
-        }
-        outTxtFile.flush();
-        outTxtFile.close();
-        
-        for(std::vector< std::list<unsigned long>* >::iterator iterLClumps = largeClumpTab->begin(); iterLClumps != largeClumpTab->end(); ++iterLClumps)
-        {
-            delete *iterLClumps;
-        }
-        delete largeClumpTab;
-        
-        delete[] lClumpIdxs;
-        delete[] clumpIdxs;
-        for(unsigned int n = 0; n < numSpecBands; ++n)
-        {
-            delete[] spectralVals[n];
-        }
-        delete[] spectralVals;
-        delete[] spectralBands;
-        
-        for(std::vector<rsgis::img::ImgClumpMean*>::iterator iterClumps = clumpTab->begin(); iterClumps != clumpTab->end(); ++iterClumps)
-        {
-            delete[] (*iterClumps)->meanVals;
-            delete[] (*iterClumps)->sumVals;
-            delete *iterClumps;
-        }
-        delete clumpTab;
     }
-    
+
     RSGISSelectClumps::~RSGISSelectClumps()
     {
         
@@ -28,6 +28,13 @@
 #include <string>
 #include <vector>
 #include <list>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <cstdlib>
+#include <climits>
 #include <math.h>
 
 #include "gdal_priv.h"
@@ -39,7 +46,10 @@
 
 #include "utils/RSGISTextUtils.h"
 
+#include "segmentation/RSGISClumpPxls.h"
+
 #include "math/RSGISMathsUtils.h"
+#include "common/RSGISParallel.h"
 
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
@@ -118,26 +128,125 @@ namespace rsgis{namespace segment{
     };
     
     
+    /**
+     * Grows a region from each seed clump over the graph of adjacent clumps,
+     * adding the neighbouring clumps whose mean is within the threshold of the
+     * region mean a ring of neighbours at a time, and raising the threshold
+     * until the region would suddenly grow by more than 90%.
+     *
+     * The clump means and adjacency are read into memory once (as compressed
+     * neighbour lists) and the seeds are grown concurrently, as each only
+     * reads the clump graph. Each clump is labelled with the last seed (in
+     * the order given) whose region contains it; the claims are made with an
+     * atomic maximum of the seed index so the output does not depend on the
+     * order in which the threads finish.
+     */
     class DllExport RSGISRegionGrowingSegmentation
     {
     public:
         RSGISRegionGrowingSegmentation();
         void performRegionGrowUsingClumps(GDALDataset *spectral, GDALDataset *clumps, GDALDataset *output, std::vector<ClumpSeed> *seeds, float initThreshold, float thresholdIncrements, float maxThreshold, unsigned int maxIterations );
+        /**
+         * Number of threads used to grow the seeds (default RSGISLIB_NUM_THREADS or 1); 0 uses the number of cores.
+         */
+        void setNumThreads(unsigned int numThreads);
         ~RSGISRegionGrowingSegmentation();
     protected:
-        rsgis::img::ImgClumpRG* growRegion(float threshold, unsigned int maxNumIterations, std::vector<rsgis::img::ImgClumpRG*> *clumpTab, unsigned int numSpecBands, unsigned long seedClumpID, unsigned long seed, std::list<unsigned long> *regionClumps);
+        struct RSGISClumpGraph
+        {
+            unsigned int numBands;
+            // Per clump (index = clump ID - 1).
+            std::vector<unsigned long> numPxls;
+            std::vector<double> sumVals;
+            std::vector<double> meanVals;
+            // The neighbours of clump i are nbrIdxs[nbrStart[i]..nbrStart[i+1]), as indexes.
+            std::vector<size_t> nbrStart;
+            std::vector<unsigned long> nbrIdxs;
+        };
+        /**
+         * Grow the region from the seed clump (an index) with the threshold,
+         * writing the indexes of its clumps to regionClumps and its size to
+         * regionNumPxls. Returns false if maxNumIterations was reached. tested
+         * marks the clumps tested by the call with the value testedMark so it
+         * only needs clearing when the mark wraps around.
+         */
+        bool growRegion(const RSGISClumpGraph &graph, float threshold, unsigned int maxNumIterations, unsigned long seedClumpIdx, std::vector<unsigned int> *tested, unsigned int testedMark, std::vector<unsigned long> *regionClumps, unsigned long *regionNumPxls);
+        unsigned int numThreads;
     };
     
     
+    /**
+     * The number of pixels and the mean and variance of each band for every
+     * clump, accumulated in one pass over the spectral and clumps images into
+     * flat (clump major) arrays indexed by clump ID, so no per clump objects
+     * or pixel lists are held.
+     *
+     * The images are read in strips of block rows shared among threads
+     * (RSGISLIB_NUM_THREADS or setNumThreads), each thread summing into its
+     * own arrays which are added together at the end. If a parent clumps
+     * image is given (e.g., a coarser segmentation) each clump also records
+     * the parent clump of its first pixel.
+     */
+    class DllExport RSGISClumpSpectralStats
+    {
+    public:
+        RSGISClumpSpectralStats();
+        /**
+         * Number of threads (default RSGISLIB_NUM_THREADS or 1); 0 uses the number of cores.
+         */
+        void setNumThreads(unsigned int numThreads);
+        void calcStats(GDALDataset *spectral, GDALDataset *clumps, GDALDataset *parentClumps=NULL);
+        /**
+         * The largest clump ID found.
+         */
+        unsigned long getMaxClumpID() const {return this->maxClumpID;};
+        unsigned int getNumBands() const {return this->numBands;};
+        unsigned long getNumPxls(unsigned long clumpID) const {return this->stats[clumpID * this->stride];};
+        double getMean(unsigned long clumpID, unsigned int band) const {return this->stats[(clumpID * this->stride) + 1 + band];};
+        double getVariance(unsigned long clumpID, unsigned int band) const {return this->stats[(clumpID * this->stride) + 1 + this->numBands + band];};
+        unsigned int getParentID(unsigned long clumpID) const {return this->parentIDs[clumpID];};
+        /**
+         * The histogram of the means of a band over the clumps (excluding 0
+         * and IDs with no pixels) with numBins equal bins between the
+         * minimum and maximum mean. Returns the number of clumps.
+         */
+        unsigned long calcMeanHistogram(unsigned int band, unsigned int numBins, std::vector<unsigned long> *histogram, double *minVal, double *binWidth) const;
+        ~RSGISClumpSpectralStats();
+    protected:
+        unsigned int numThreads;
+        unsigned int numBands;
+        unsigned long maxClumpID;
+        // For each clump the count, band means and band variances.
+        size_t stride;
+        std::vector<double> stats;
+        std::vector<unsigned int> parentIDs;
+    };
+    
+    /**
+     * Selects as seeds the clumps whose mean is within the brightest
+     * proportion (the threshold) of the clumps in every band, using the
+     * histograms of the clump means from RSGISClumpSpectralStats.
+     */
     class DllExport RSGISGenerateSeeds
     {
     public:
         RSGISGenerateSeeds();
-        void genSeedsHistogram(GDALDataset *spectral, GDALDataset *clumps, GDALDataset *output, std::vector<BandThreshold> *thresholds);
-        void genSeedsHistogram(GDALDataset *spectral, GDALDataset *clumps, std::string outputFile, std::vector<BandThreshold> *thresholds);
+        void genSeedsHistogram(GDALDataset *spectral, GDALDataset *clumps, GDALDataset *output, std::vector<BandThreshold> *thresholds, unsigned int numBins=1000);
+        void genSeedsHistogram(GDALDataset *spectral, GDALDataset *clumps, std::string outputFile, std::vector<BandThreshold> *thresholds, unsigned int numBins=1000);
         ~RSGISGenerateSeeds();
+    protected:
+        /**
+         * A lookup table of clump ID to itself for the seeds and 0 otherwise.
+         */
+        void findSeedClumps(GDALDataset *spectral, GDALDataset *clumps, std::vector<BandThreshold> *thresholds, unsigned int numBins, std::vector<unsigned int> *seedLUT);
     };
     
+    /**
+     * Selects one clump within each of the large clumps by the brightness
+     * (mean of the band means) of the clumps whose first pixel is within it.
+     * The clumps are sorted by large clump and brightness so each selection
+     * is made from a contiguous run of the sorted clumps.
+     */
     class DllExport RSGISSelectClumps
     {
     public:
@@ -154,6 +263,11 @@ namespace rsgis{namespace segment{
         void selectClumps(GDALDataset *spectral, GDALDataset *clumps, GDALDataset *largeClumps, GDALDataset *output, ClumpSelection selection);
         void selectClumps(GDALDataset *spectral, GDALDataset *clumps, GDALDataset *largeClumps, std::string outputFile, ClumpSelection selection);
         ~RSGISSelectClumps();
+    protected:
+        /**
+         * The selected clump IDs in the order of the large clumps.
+         */
+        void findSelectedClumps(GDALDataset *spectral, GDALDataset *clumps, GDALDataset *largeClumps, ClumpSelection selection, std::vector<unsigned int> *selected);
     };
     
 }}
@@ -28,7 +28,18 @@ namespace rsgis{namespace segment{
    
     RSGISSpecGroupSegmentation::RSGISSpecGroupSegmentation()
     {
-        
+        this->numThreads = rsgis::utils::getNumThreads();
+        this->tileRows = 0;
+    }
+    
+    void RSGISSpecGroupSegmentation::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+    
+    void RSGISSpecGroupSegmentation::setTileRows(unsigned int tileRows)
+    {
+        this->tileRows = tileRows;
     }
     
     void RSGISSpecGroupSegmentation::performSimpleClump(GDALDataset *spectral, GDALDataset *clumps, float specThreshold, bool noDataValProvided, float noDataVal) 
@@ -706,6 +717,274 @@ namespace rsgis{namespace segment{
         delete[] numVals;
     }
     
+    unsigned long RSGISSpecGroupSegmentation::performParallelSimpleClump(GDALDataset *spectral, GDALDataset *clumps, float specThreshold, bool noDataValProvided, float noDataVal)
+    {
+        if(spectral->GetRasterXSize() != clumps->GetRasterXSize())
+        {
+            throw rsgis::img::RSGISImageCalcException("Widths are not the same");
+        }
+        if(spectral->GetRasterYSize() != clumps->GetRasterYSize())
+        {
+            throw rsgis::img::RSGISImageCalcException("Heights are not the same");
+        }
+        
+        unsigned int width = spectral->GetRasterXSize();
+        unsigned int height = spectral->GetRasterYSize();
+        unsigned int numSpecBands = spectral->GetRasterCount();
+        
+        std::vector<GDALRasterBand*> spectralBands(numSpecBands);
+        for(unsigned int n = 0; n < numSpecBands; ++n)
+        {
+            spectralBands[n] = spectral->GetRasterBand(n+1);
+        }
+        GDALRasterBand *clumpBand = clumps->GetRasterBand(1);
+        
+        // Tiles are strips of whole rows, a multiple of the block height of about 4M values by default.
+        size_t tileNRows = this->tileRows;
+        if(tileNRows == 0)
+        {
+            int blockXSize = 0;
+            int blockYSize = 0;
+            spectralBands[0]->GetBlockSize(&blockXSize, &blockYSize);
+            size_t blockRows = (blockYSize > 0)?blockYSize:1;
+            tileNRows = std::max<size_t>(((4194304 / (((size_t)width)*numSpecBands)) / blockRows) * blockRows, blockRows);
+        }
+        if(tileNRows > height)
+        {
+            tileNRows = height;
+        }
+        if(tileNRows == 0)
+        {
+            tileNRows = 1;
+        }
+        size_t numTiles = (height + tileNRows - 1) / tileNRows;
+        
+        std::vector<RSGISSpecGroupTile> tiles(numTiles);
+        for(size_t t = 0; t < numTiles; ++t)
+        {
+            tiles[t].startRow = t * tileNRows;
+            tiles[t].nRows = std::min<size_t>(tileNRows, height - tiles[t].startRow);
+            tiles[t].numLabels = 0;
+        }
+        
+        rsgis_tqdm pbar;
+        
+        // Grow the groups in the tiles independently, numThreads at a time. The spectral values are
+        // read (and the clumps written) from this thread as GDAL datasets cannot be shared between threads.
+        size_t pxlStride = numSpecBands * sizeof(float);
+        std::vector<std::vector<float> > specVals(this->numThreads);
+        rsgis::utils::RSGISWorkerPool pool(this->numThreads);
+        for(size_t batchStart = 0; batchStart < numTiles; batchStart += this->numThreads)
+        {
+            pbar.progress(batchStart, numTiles*2);
+            size_t batchEnd = std::min<size_t>(batchStart + this->numThreads, numTiles);
+            for(size_t t = batchStart; t < batchEnd; ++t)
+            {
+                std::vector<float> &tileSpecVals = specVals[t-batchStart];
+                tileSpecVals.resize(tiles[t].nRows * width * numSpecBands);
+                for(unsigned int n = 0; n < numSpecBands; ++n)
+                {
+                    if(spectralBands[n]->RasterIO(GF_Read, 0, tiles[t].startRow, width, tiles[t].nRows, &tileSpecVals[n], width, tiles[t].nRows, GDT_Float32, pxlStride, pxlStride*width) != CE_None)
+                    {
+                        throw rsgis::img::RSGISImageCalcException("Could not read the spectral image.");
+                    }
+                }
+            }
+            
+            pool.parallelFor(batchEnd - batchStart, [&](size_t i, unsigned int)
+            {
+                this->growTileGroups(&tiles[batchStart+i], specVals[i].data(), width, numSpecBands, specThreshold, noDataValProvided, noDataVal);
+            });
+        }
+        specVals.clear();
+        
+        // Give each tile a contiguous range of global labels.
+        std::vector<size_t> labelOffsets(numTiles, 0);
+        size_t numProvLabels = 0;
+        for(size_t t = 0; t < numTiles; ++t)
+        {
+            labelOffsets[t] = numProvLabels;
+            numProvLabels += tiles[t].numLabels;
+        }
+        if(numProvLabels >= std::numeric_limits<unsigned int>::max())
+        {
+            throw rsgis::img::RSGISImageCalcException("The number of clumps is too large for a 32 bit clumps image.");
+        }
+        
+        // Join the groups across the seam between each pair of tiles where the pixel
+        // on either side would have been added to the group on the other side.
+        std::vector<unsigned int> parent(numProvLabels+1);
+        for(size_t l = 0; l <= numProvLabels; ++l)
+        {
+            parent[l] = l;
+        }
+        for(size_t t = 1; t < numTiles; ++t)
+        {
+            const unsigned int *aboveLabels = &tiles[t-1].labels[(tiles[t-1].nRows-1) * width];
+            const unsigned int *belowLabels = tiles[t].labels.data();
+            const float *aboveVals = tiles[t-1].lastRowVals.data();
+            const float *belowVals = tiles[t].firstRowVals.data();
+            for(size_t x = 0; x < width; ++x)
+            {
+                if((aboveLabels[x] != 0) && (belowLabels[x] != 0))
+                {
+                    const float *aboveSeed = &tiles[t-1].seedVals[(aboveLabels[x]-1)*numSpecBands];
+                    const float *belowSeed = &tiles[t].seedVals[(belowLabels[x]-1)*numSpecBands];
+                    if((this->eucDistanceInterleaved(aboveSeed, &belowVals[x*numSpecBands], numSpecBands) <= specThreshold) || (this->eucDistanceInterleaved(belowSeed, &aboveVals[x*numSpecBands], numSpecBands) <= specThreshold))
+                    {
+                        this->mergeLabels(&parent, labelOffsets[t-1]+aboveLabels[x], labelOffsets[t]+belowLabels[x]);
+                    }
+                }
+            }
+        }
+        
+        // Number the clumps in order of their first pixel.
+        unsigned long numClumps = 0;
+        for(size_t t = 0; t < numTiles; ++t)
+        {
+            for(size_t l = 1; l <= tiles[t].numLabels; ++l)
+            {
+                size_t gl = labelOffsets[t] + l;
+                if(parent[gl] == gl)
+                {
+                    parent[gl] = ++numClumps;
+                }
+                else
+                {
+                    parent[gl] = parent[parent[gl]];
+                }
+            }
+        }
+        
+        // Write the final labels for each tile.
+        for(size_t t = 0; t < numTiles; ++t)
+        {
+            pbar.progress(numTiles+t, numTiles*2);
+            unsigned int *tileLabels = tiles[t].labels.data();
+            size_t numPxls = tiles[t].nRows * width;
+            for(size_t i = 0; i < numPxls; ++i)
+            {
+                if(tileLabels[i] != 0)
+                {
+                    tileLabels[i] = parent[labelOffsets[t]+tileLabels[i]];
+                }
+            }
+            if(clumpBand->RasterIO(GF_Write, 0, tiles[t].startRow, width, tiles[t].nRows, tileLabels, width, tiles[t].nRows, GDT_UInt32, 0, 0) != CE_None)
+            {
+                throw rsgis::img::RSGISImageCalcException("Could not write to the clumps image.");
+            }
+            std::vector<unsigned int>().swap(tiles[t].labels);
+        }
+        pbar.finish();
+        std::cout << "(Generated " << numClumps << " clumps).\n";
+        
+        return numClumps;
+    }
+    
+    void RSGISSpecGroupSegmentation::growTileGroups(RSGISSpecGroupTile *tile, const float *specVals, unsigned int width, unsigned int numBands, float specThreshold, bool noDataValProvided, float noDataVal)
+    {
+        size_t nRows = tile->nRows;
+        tile->labels.assign(nRows * width, 0);
+        tile->seedVals.clear();
+        unsigned int *labels = tile->labels.data();
+        unsigned int numLabels = 0;
+        
+        std::vector<size_t> searchPxls;
+        for(size_t seedIdx = 0; seedIdx < (nRows * width); ++seedIdx)
+        {
+            if((labels[seedIdx] != 0) || (noDataValProvided && this->isNoData(&specVals[seedIdx*numBands], numBands, noDataVal)))
+            {
+                continue;
+            }
+            
+            if(numLabels == std::numeric_limits<unsigned int>::max())
+            {
+                throw rsgis::img::RSGISImageCalcException("The number of clumps is too large for a 32 bit clumps image.");
+            }
+            unsigned int label = ++numLabels;
+            const float *seedVals = &specVals[seedIdx*numBands];
+            tile->seedVals.insert(tile->seedVals.end(), seedVals, seedVals+numBands);
+            labels[seedIdx] = label;
+            
+            // Breadth first growth from the seed; every pixel is compared to the seed.
+            searchPxls.clear();
+            searchPxls.push_back(seedIdx);
+            for(size_t s = 0; s < searchPxls.size(); ++s)
+            {
+                size_t idx = searchPxls[s];
+                size_t x = idx % width;
+                size_t y = idx / width;
+                size_t nIdxs[4];
+                unsigned int numNIdxs = 0;
+                // Above, below, left and right.
+                if(y > 0)
+                {
+                    nIdxs[numNIdxs++] = idx - width;
+                }
+                if((y+1) < nRows)
+                {
+                    nIdxs[numNIdxs++] = idx + width;
+                }
+                if(x > 0)
+                {
+                    nIdxs[numNIdxs++] = idx - 1;
+                }
+                if((x+1) < width)
+                {
+                    nIdxs[numNIdxs++] = idx + 1;
+                }
+                for(unsigned int i = 0; i < numNIdxs; ++i)
+                {
+                    size_t nIdx = nIdxs[i];
+                    if(labels[nIdx] != 0)
+                    {
+                        continue;
+                    }
+                    const float *nVals = &specVals[nIdx*numBands];
+                    if(noDataValProvided && this->isNoData(nVals, numBands, noDataVal))
+                    {
+                        continue;
+                    }
+                    if(this->eucDistanceInterleaved(seedVals, nVals, numBands) <= specThreshold)
+                    {
+                        labels[nIdx] = label;
+                        searchPxls.push_back(nIdx);
+                    }
+                }
+            }
+        }
+        tile->numLabels = numLabels;
+        
+        // Keep the first and last rows for joining the groups across the seams.
+        tile->firstRowVals.assign(specVals, specVals + (((size_t)width)*numBands));
+        tile->lastRowVals.assign(&specVals[(nRows-1)*width*numBands], &specVals[nRows*width*numBands]);
+    }
+    
+    void RSGISSpecGroupSegmentation::mergeLabels(std::vector<unsigned int> *parent, unsigned int label1, unsigned int label2)
+    {
+        unsigned int root1 = this->findLabelRoot(parent, label1);
+        unsigned int root2 = this->findLabelRoot(parent, label2);
+        if(root1 < root2)
+        {
+            (*parent)[root2] = root1;
+        }
+        else if(root2 < root1)
+        {
+            (*parent)[root1] = root2;
+        }
+    }
+    
+    unsigned int RSGISSpecGroupSegmentation::findLabelRoot(std::vector<unsigned int> *parent, unsigned int label)
+    {
+        // Path halving
+        while((*parent)[label] != label)
+        {
+            (*parent)[label] = (*parent)[(*parent)[label]];
+            label = (*parent)[label];
+        }
+        return label;
+    }
+    
     float RSGISSpecGroupSegmentation::eucDistance(float *vals1, float *vals2, unsigned int numVals)
     {
         float sqSum = 0;
@@ -27,11 +27,16 @@
 #include <string>
 #include <vector>
 #include <queue>
+#include <limits>
+#include <thread>
+#include <exception>
+#include <cstdlib>
 #include <math.h>
 
 #include "gdal_priv.h"
 
 #include "common/rsgis-tqdm.h"
+#include "common/RSGISParallel.h"
 
 #include "img/RSGISImageUtils.h"
 #include "img/RSGISImageCalcException.h"
@@ -58,8 +63,68 @@ namespace rsgis{namespace segment{
         void performSimpleClump(GDALDataset *spectral, GDALDataset *clumps, float specThreshold, bool noDataValProvided, float noDataVal);
         void performSimpleClumpKeepPxlVals(GDALDataset *spectral, GDALDataset *clumps, float specThreshold);
         void performSimpleClumpStdDevWeights(GDALDataset *spectral, GDALDataset *clumps, float specThreshold, bool noDataValProvided, float noDataVal);
+        /**
+         * Group pixels as performSimpleClump but growing the groups within strips
+         * of rows (tiles) concurrently, with the spectral values of each tile held
+         * in memory band interleaved. Groups which touch across a seam are merged
+         * (union-find) where a pixel on one side is within specThreshold of the
+         * seed of the group on the other side, using the row beyond each tile as
+         * a halo. As the groups are seeded within each tile the result is not the
+         * same as performSimpleClump. The labels for the whole image are held in
+         * memory (4 bytes per pixel). Returns the number of clumps.
+         */
+        unsigned long performParallelSimpleClump(GDALDataset *spectral, GDALDataset *clumps, float specThreshold, bool noDataValProvided, float noDataVal);
+        /**
+         * Number of threads used by performParallelSimpleClump (default RSGISLIB_NUM_THREADS or 1); 0 uses the number of cores.
+         */
+        void setNumThreads(unsigned int numThreads);
+        /**
+         * Number of rows in each tile for performParallelSimpleClump; 0 (default) picks a multiple of the block height.
+         */
+        void setTileRows(unsigned int tileRows);
         ~RSGISSpecGroupSegmentation();
     protected:
+        struct RSGISSpecGroupTile
+        {
+            size_t startRow;
+            size_t nRows;
+            unsigned int numLabels;
+            // nRows*width, labels 1..numLabels in raster order of their seeds.
+            std::vector<unsigned int> labels;
+            // The spectral values of the seed of each label (numBands per label, from label 1).
+            std::vector<float> seedVals;
+            std::vector<float> firstRowVals;
+            std::vector<float> lastRowVals;
+        };
+        /**
+         * Grow the groups within a tile from its band interleaved spectral values (specVals, nRows*width*numBands).
+         */
+        void growTileGroups(RSGISSpecGroupTile *tile, const float *specVals, unsigned int width, unsigned int numBands, float specThreshold, bool noDataValProvided, float noDataVal);
+        inline float eucDistanceInterleaved(const float *vals1, const float *vals2, unsigned int numVals)
+        {
+            float sqSum = 0;
+            for(unsigned int i = 0; i < numVals; ++i)
+            {
+                float diff = vals1[i] - vals2[i];
+                sqSum += diff*diff;
+            }
+            return sqrt(sqSum)/numVals;
+        };
+        inline bool isNoData(const float *vals, unsigned int numVals, float noDataVal)
+        {
+            for(unsigned int i = 0; i < numVals; ++i)
+            {
+                if(vals[i] != noDataVal)
+                {
+                    return false;
+                }
+            }
+            return true;
+        };
+        void mergeLabels(std::vector<unsigned int> *parent, unsigned int label1, unsigned int label2);
+        unsigned int findLabelRoot(std::vector<unsigned int> *parent, unsigned int label);
+        unsigned int numThreads;
+        unsigned int tileRows;
         float eucDistance(float *vals1, float *vals2, unsigned int numVals);
         float weightedEucDistance(float *vals1, float *vals2, unsigned int numVals, float *stddev);
     };
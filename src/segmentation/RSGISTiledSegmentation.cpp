@@ -0,0 +1,304 @@
+/*
+ *  RSGISTiledSegmentation.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISTiledSegmentation.h"
+
+namespace rsgis{namespace segment{
+
+    RSGISTiledSegmentation::RSGISTiledSegmentation(unsigned int tileWidth, unsigned int tileHeight)
+    {
+        if((tileWidth == 0) || (tileHeight == 0))
+        {
+            throw rsgis::img::RSGISImageCalcException("The tile width and height must be greater than zero.");
+        }
+        this->tileWidth = tileWidth;
+        this->tileHeight = tileHeight;
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+
+    void RSGISTiledSegmentation::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
+
+    void RSGISTiledSegmentation::planAxis(unsigned int imgSize, unsigned int tileSize, std::vector<std::pair<unsigned int, unsigned int> > *axisTiles)
+    {
+        axisTiles->clear();
+        unsigned int offset = 0;
+        while(offset < imgSize)
+        {
+            unsigned int size = std::min(tileSize, imgSize - offset);
+            if(((imgSize - offset - size) > 0) && ((imgSize - offset - size) < (tileSize/2)))
+            {
+                size = imgSize - offset;
+            }
+            axisTiles->push_back(std::pair<unsigned int, unsigned int>(offset, size));
+            offset += size;
+        }
+    }
+
+    const std::vector<RSGISSegTile>& RSGISTiledSegmentation::planTiles(unsigned int width, unsigned int height)
+    {
+        std::vector<std::pair<unsigned int, unsigned int> > xTiles;
+        std::vector<std::pair<unsigned int, unsigned int> > yTiles;
+        this->planAxis(width, this->tileWidth, &xTiles);
+        this->planAxis(height, this->tileHeight, &yTiles);
+
+        this->tiles.clear();
+        for(std::vector<std::pair<unsigned int, unsigned int> >::iterator iterY = yTiles.begin(); iterY != yTiles.end(); ++iterY)
+        {
+            for(std::vector<std::pair<unsigned int, unsigned int> >::iterator iterX = xTiles.begin(); iterX != xTiles.end(); ++iterX)
+            {
+                RSGISSegTile tile;
+                tile.xOff = iterX->first;
+                tile.width = iterX->second;
+                tile.yOff = iterY->first;
+                tile.height = iterY->second;
+                this->tiles.push_back(tile);
+            }
+        }
+        return this->tiles;
+    }
+
+    unsigned long RSGISTiledSegmentation::segmentTiles(GDALDataset *spectral, rsgis::math::Matrix *clusterCentres, unsigned int minPxls, float distThres, GDALDataset *clumpsDS, GDALDataset *borderMaskDS)
+    {
+        unsigned int width = spectral->GetRasterXSize();
+        unsigned int height = spectral->GetRasterYSize();
+        unsigned int numSpecBands = spectral->GetRasterCount();
+        if((clumpsDS->GetRasterXSize() != ((int)width)) || (clumpsDS->GetRasterYSize() != ((int)height)))
+        {
+            throw rsgis::img::RSGISImageCalcException("The spectral and clumps images are not the same size.");
+        }
+        if((borderMaskDS != NULL) && ((borderMaskDS->GetRasterXSize() != ((int)width)) || (borderMaskDS->GetRasterYSize() != ((int)height))))
+        {
+            throw rsgis::img::RSGISImageCalcException("The spectral and border mask images are not the same size.");
+        }
+        if(((unsigned int)clusterCentres->n) != numSpecBands)
+        {
+            throw rsgis::img::RSGISImageCalcException("The cluster centres do not have the same number of bands as the spectral image.");
+        }
+
+        this->planTiles(width, height);
+        unsigned int numTiles = this->tiles.size();
+        std::cout << "Segmenting " << numTiles << " tiles\n";
+
+        double imgTrans[6];
+        spectral->GetGeoTransform(imgTrans);
+
+        GDALRasterBand *clumpBand = clumpsDS->GetRasterBand(1);
+        GDALRasterBand *borderBand = (borderMaskDS != NULL)?borderMaskDS->GetRasterBand(1):NULL;
+
+        unsigned int nextWrite = 0;
+        unsigned long clumpOffset = 0;
+        std::mutex ioMutex;
+        std::condition_variable writeCond;
+        bool failed = false;
+
+        rsgis::utils::parallelFor(numTiles, this->numThreads, [&](size_t t, unsigned int)
+        {
+            const RSGISSegTile &tile = this->tiles[t];
+            size_t numTilePxls = ((size_t)tile.width) * tile.height;
+            try
+            {
+                double tileTrans[6];
+                std::copy(imgTrans, imgTrans+6, tileTrans);
+                tileTrans[0] = imgTrans[0] + (tile.xOff * imgTrans[1]) + (tile.yOff * imgTrans[2]);
+                tileTrans[3] = imgTrans[3] + (tile.xOff * imgTrans[4]) + (tile.yOff * imgTrans[5]);
+
+                std::vector<unsigned int> clumpVals;
+                unsigned int numTileClumps = 0;
+                {
+                    // The tile is read straight into the scratch raster (band after band).
+                    rsgis::img::RSGISScratchRaster tileSpec(tile.width, tile.height, numSpecBands, GDT_Float32);
+                    tileSpec.getDataset()->SetGeoTransform(tileTrans);
+                    {
+                        std::lock_guard<std::mutex> lock(ioMutex);
+                        if(spectral->RasterIO(GF_Read, tile.xOff, tile.yOff, tile.width, tile.height, tileSpec.getBandData(1), tile.width, tile.height, GDT_Float32, numSpecBands, NULL, 0, 0, 0) != CE_None)
+                        {
+                            throw rsgis::img::RSGISImageCalcException("Could not read the tile from the spectral image.");
+                        }
+                    }
+                    this->segmentTile(tileSpec.getDataset(), clusterCentres, minPxls, distThres, &clumpVals, &numTileClumps);
+                }
+                // Clumps touching an edge shared with another tile.
+                std::vector<unsigned char> borderClumps(numTileClumps+1, 0);
+                bool leftEdge = (tile.xOff > 0);
+                bool rightEdge = ((tile.xOff + tile.width) < width);
+                bool topEdge = (tile.yOff > 0);
+                bool bottomEdge = ((tile.yOff + tile.height) < height);
+                for(unsigned int x = 0; x < tile.width; ++x)
+                {
+                    if(topEdge)
+                    {
+                        borderClumps[clumpVals[x]] = 1;
+                    }
+                    if(bottomEdge)
+                    {
+                        borderClumps[clumpVals[((size_t)(tile.height-1) * tile.width) + x]] = 1;
+                    }
+                }
+                for(unsigned int y = 0; y < tile.height; ++y)
+                {
+                    if(leftEdge)
+                    {
+                        borderClumps[clumpVals[(size_t)y * tile.width]] = 1;
+                    }
+                    if(rightEdge)
+                    {
+                        borderClumps[clumpVals[((size_t)y * tile.width) + tile.width - 1]] = 1;
+                    }
+                }
+                borderClumps[0] = 0;
+                std::vector<unsigned char> borderVals;
+                if(borderBand != NULL)
+                {
+                    borderVals.resize(numTilePxls);
+                    for(size_t i = 0; i < numTilePxls; ++i)
+                    {
+                        borderVals[i] = borderClumps[clumpVals[i]];
+                    }
+                }
+
+                // Write the tiles in order so the clump IDs follow the tiles.
+                std::unique_lock<std::mutex> lock(ioMutex);
+                writeCond.wait(lock, [&]{return (nextWrite == t) || failed;});
+                if(failed)
+                {
+                    return;
+                }
+                if((clumpOffset + numTileClumps) > UINT_MAX)
+                {
+                    throw rsgis::img::RSGISImageCalcException("There are too many clumps for a 32 bit unsigned integer image.");
+                }
+                for(size_t i = 0; i < numTilePxls; ++i)
+                {
+                    if(clumpVals[i] != 0)
+                    {
+                        clumpVals[i] += clumpOffset;
+                    }
+                }
+                if(clumpBand->RasterIO(GF_Write, tile.xOff, tile.yOff, tile.width, tile.height, clumpVals.data(), tile.width, tile.height, GDT_UInt32, 0, 0) != CE_None)
+                {
+                    throw rsgis::img::RSGISImageCalcException("Could not write the tile to the clumps image.");
+                }
+                if(borderBand != NULL)
+                {
+                    if(borderBand->RasterIO(GF_Write, tile.xOff, tile.yOff, tile.width, tile.height, borderVals.data(), tile.width, tile.height, GDT_Byte, 0, 0) != CE_None)
+                    {
+                        throw rsgis::img::RSGISImageCalcException("Could not write the tile to the border mask image.");
+                    }
+                }
+                clumpOffset += numTileClumps;
+                std::cout << "Tile " << (t+1) << " of " << numTiles << " has " << numTileClumps << " clumps\n";
+                ++nextWrite;
+                writeCond.notify_all();
+            }
+            catch(...)
+            {
+                // Wake any workers waiting to write a later tile.
+                {
+                    std::lock_guard<std::mutex> lock(ioMutex);
+                    failed = true;
+                }
+                writeCond.notify_all();
+                throw;
+            }
+        });
+
+        std::cout << "There are " << clumpOffset << " clumps\n";
+        return clumpOffset;
+    }
+
+    void RSGISTiledSegmentation::segmentTile(GDALDataset *tileSpecDS, rsgis::math::Matrix *clusterCentres, unsigned int minPxls, float distThres, std::vector<unsigned int> *clumpVals, unsigned int *numClumps)
+    {
+        unsigned int width = tileSpecDS->GetRasterXSize();
+        unsigned int height = tileSpecDS->GetRasterYSize();
+        size_t numPxls = ((size_t)width) * height;
+        // Scratch rasters, so a large tile is paged to a scratch file rather than exhausting memory.
+        try
+        {
+            rsgis::img::RSGISScratchRaster labels(tileSpecDS, 1, GDT_UInt32);
+            rsgis::img::RSGISScratchRaster tmp(tileSpecDS, 1, GDT_UInt32);
+            rsgis::img::RSGISScratchRaster clumps(tileSpecDS, 1, GDT_UInt32);
+            GDALDataset *labelsDS = labels.getDataset();
+            GDALDataset *tmpDS = tmp.getDataset();
+            GDALDataset *clumpsDS = clumps.getDataset();
+
+            // The tiles are already processed in parallel so each step uses one thread.
+            RSGISLabelPixelsUsingClustersCalcImg labelPxls(1, clusterCentres, true);
+            rsgis::img::RSGISCalcImage calcImage(&labelPxls, "", true);
+            calcImage.setNumThreads(1);
+            calcImage.calcImage(&tileSpecDS, 1, labelsDS);
+
+            RSGISEliminateSinglePixels elimSinglePxls;
+            elimSinglePxls.eliminateBlocks(tileSpecDS, labelsDS, tmpDS, 0, true);
+
+            RSGISClumpPxls clumpPxls;
+            clumpPxls.setNumThreads(1);
+            unsigned long numInitClumps = clumpPxls.performParallelClump(labelsDS, clumpsDS, true, 0, NULL);
+
+            if(numInitClumps > 0)
+            {
+                RSGISEliminateSmallClumps elimSmallClumps;
+                elimSmallClumps.stepwiseEliminateSmallClumpsNoMean(tileSpecDS, clumpsDS, minPxls, distThres, NULL, false);
+            }
+
+            // The clumps are copied directly from the scratch raster.
+            const unsigned int *clumpsData = clumps.getBandDataAs<unsigned int>(1);
+            clumpVals->assign(clumpsData, clumpsData + numPxls);
+        }
+        catch(rsgis::RSGISException &e)
+        {
+            throw rsgis::img::RSGISImageCalcException(e.what());
+        }
+
+        // The elimination leaves gaps in the clump IDs so renumber them in order.
+        unsigned int maxClumpID = 0;
+        for(size_t i = 0; i < numPxls; ++i)
+        {
+            maxClumpID = std::max(maxClumpID, (*clumpVals)[i]);
+        }
+        std::vector<unsigned int> clumpLUT(((size_t)maxClumpID)+1, 0);
+        for(size_t i = 0; i < numPxls; ++i)
+        {
+            clumpLUT[(*clumpVals)[i]] = 1;
+        }
+        *numClumps = 0;
+        for(size_t i = 1; i < clumpLUT.size(); ++i)
+        {
+            if(clumpLUT[i] != 0)
+            {
+                clumpLUT[i] = ++(*numClumps);
+            }
+        }
+        clumpLUT[0] = 0;
+        for(size_t i = 0; i < numPxls; ++i)
+        {
+            (*clumpVals)[i] = clumpLUT[(*clumpVals)[i]];
+        }
+    }
+
+    RSGISTiledSegmentation::~RSGISTiledSegmentation()
+    {
+
+    }
+
+}}
@@ -0,0 +1,133 @@
+/*
+ *  RSGISTiledSegmentation.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISTiledSegmentation_H
+#define RSGISTiledSegmentation_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <cstdlib>
+#include <climits>
+
+#include "gdal_priv.h"
+
+#include "common/RSGISException.h"
+#include "common/RSGISParallel.h"
+
+#include "img/RSGISImageCalcException.h"
+#include "img/RSGISCalcImage.h"
+#include "img/RSGISScratchRaster.h"
+
+#include "math/RSGISMatrices.h"
+
+#include "segmentation/RSGISLabelPixelsUsingClusters.h"
+#include "segmentation/RSGISEliminateSinglePixels.h"
+#include "segmentation/RSGISClumpPxls.h"
+#include "segmentation/RSGISEliminateSmallClumps.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_segmentation_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace segment{
+
+    /**
+     * A tile of the image (pixel offset and size).
+     */
+    struct DllExport RSGISSegTile
+    {
+        unsigned int xOff;
+        unsigned int yOff;
+        unsigned int width;
+        unsigned int height;
+    };
+
+    /**
+     * Segment an image as a set of tiles processed concurrently. Each tile
+     * is read into in memory datasets and segmented with the same steps as
+     * the Shepherd segmentation (label the pixels from the k-means cluster
+     * centres, eliminate single pixels, clump and eliminate the small clumps)
+     * and its clumps are written to the output image (in tile order, so the
+     * clump IDs are the same whatever the number of threads) offset by the
+     * number of clumps in the previous tiles. The clumps which touch an edge
+     * shared with another tile are recorded in a border mask as they are
+     * written, so the border clumps do not need to be found from the tiles
+     * afterwards and no temporary tile images are written.
+     */
+    class DllExport RSGISTiledSegmentation
+    {
+    public:
+        RSGISTiledSegmentation(unsigned int tileWidth, unsigned int tileHeight);
+        /**
+         * The number of tiles segmented at once (default RSGISLIB_NUM_THREADS or 1); 0 uses the number of cores.
+         */
+        void setNumThreads(unsigned int numThreads);
+        /**
+         * Define a grid of tiles over the image. A remainder at the right or
+         * bottom smaller than half a tile is added to the last tile rather
+         * than being a tile of its own.
+         */
+        const std::vector<RSGISSegTile>& planTiles(unsigned int width, unsigned int height);
+        /**
+         * Segment the spectral image tile by tile into clumpsDS (uint32) and
+         * set borderMaskDS (byte, may be NULL) to 1 for the clumps touching a
+         * tile edge within the image. The cluster centres are a (bands x
+         * clusters) matrix, as read by RSGISLabelPixelsUsingClusters, and
+         * pixels which are zero in all bands are not segmented. Returns the
+         * number of clumps.
+         */
+        unsigned long segmentTiles(GDALDataset *spectral, rsgis::math::Matrix *clusterCentres, unsigned int minPxls, float distThres, GDALDataset *clumpsDS, GDALDataset *borderMaskDS);
+        const std::vector<RSGISSegTile>& getTiles() const {return this->tiles;};
+        ~RSGISTiledSegmentation();
+    protected:
+        /**
+         * Split an axis of the image into tiles (offset, size).
+         */
+        void planAxis(unsigned int imgSize, unsigned int tileSize, std::vector<std::pair<unsigned int, unsigned int> > *axisTiles);
+        /**
+         * Segment a tile held in memory, returning its clumps (numbered 1 to
+         * numClumps, 0 where no data) in clumpVals (width x height).
+         */
+        void segmentTile(GDALDataset *tileSpecDS, rsgis::math::Matrix *clusterCentres, unsigned int minPxls, float distThres, std::vector<unsigned int> *clumpVals, unsigned int *numClumps);
+        unsigned int tileWidth;
+        unsigned int tileHeight;
+        unsigned int numThreads;
+        std::vector<RSGISSegTile> tiles;
+    };
+
+}}
+
+#endif
@@ -28,7 +28,13 @@ namespace rsgis{namespace utils{
     
     RSGISExportColumnData2HDF::RSGISExportColumnData2HDF()
     {
-        
+        this->dataH5File = NULL;
+        this->numCols = 0;
+        this->blockSize = 0;
+        this->numColsWritten = 0;
+        this->bufferRows = 0;
+        this->numBufferedRows = 0;
+        this->rowBytes = 0;
     }
 
     H5::DataType RSGISExportColumnData2HDF::getH5DataType(RSGISLibDataType rsgis_datatype)
@@ -117,15 +123,18 @@ namespace rsgis{namespace utils{
             datasetDescription.close();
             delete[] wStrdata;
             
-            this->blockSize = 1000;
-            int deflate = 1;
+            // Chunks of whole rows, sized to fit in the chunk cache.
+            size_t rowSize = ((size_t)numCols) * dataType.getSize();
+            this->blockSize = std::max<size_t>(HDF5_WRITE_CHUNK_NBYTES / std::max<size_t>(rowSize, 1), 1);
+            this->bufferRows = ((size_t)this->blockSize) * HDF5_WRITE_BUFFER_CHUNKS;
+            this->numBufferedRows = 0;
             int initFillVal = 0;
             
             hsize_t dimsDataChunk[] = { blockSize, numCols };
             H5::DSetCreatPropList initParamsData;
             initParamsData.setChunk(2, dimsDataChunk);
             initParamsData.setShuffle();
-            initParamsData.setDeflate(deflate);
+            initParamsData.setDeflate(HDF5_WRITE_DEFLATE);
             initParamsData.setFillValue( H5::PredType::NATIVE_INT, &initFillVal);
             
             hsize_t initDataDims[] = { 0, numCols };
@@ -165,12 +174,60 @@ namespace rsgis{namespace utils{
     
     void RSGISExportColumnData2HDF::addDataRow(void *data, H5::DataType h5Datatype)
     {
+        std::lock_guard<std::mutex> lock(this->writeMutex);
+        if((this->numBufferedRows > 0) && !(this->bufferDataType == h5Datatype))
+        {
+            this->flushBuffer();
+        }
+        if(this->numBufferedRows == 0)
+        {
+            this->bufferDataType = h5Datatype;
+            this->rowBytes = ((size_t)this->numCols) * h5Datatype.getSize();
+            this->rowBuffer.resize(this->bufferRows * this->rowBytes);
+        }
+        std::memcpy(&this->rowBuffer[this->numBufferedRows * this->rowBytes], data, this->rowBytes);
+        ++this->numBufferedRows;
+        if(this->numBufferedRows == this->bufferRows)
+        {
+            this->flushBuffer();
+        }
+    }
+    
+    void RSGISExportColumnData2HDF::addDataRows(void *data, size_t numRows, H5::DataType h5Datatype)
+    {
+        std::lock_guard<std::mutex> lock(this->writeMutex);
+        this->flushBuffer();
+        this->writeRows(data, numRows, h5Datatype);
+    }
+    
+    void RSGISExportColumnData2HDF::flush()
+    {
+        std::lock_guard<std::mutex> lock(this->writeMutex);
+        this->flushBuffer();
+    }
+    
+    void RSGISExportColumnData2HDF::flushBuffer()
+    {
+        if(this->numBufferedRows > 0)
+        {
+            size_t numRows = this->numBufferedRows;
+            this->numBufferedRows = 0;
+            this->writeRows(this->rowBuffer.data(), numRows, this->bufferDataType);
+        }
+    }
+    
+    void RSGISExportColumnData2HDF::writeRows(void *data, size_t numRows, H5::DataType h5Datatype)
+    {
+        if(numRows == 0)
+        {
+            return;
+        }
         try
         {
             H5::Exception::dontPrint();
             
             hsize_t extendDatasetTo[2];
-            extendDatasetTo[0] = this->numColsWritten + 1;
+            extendDatasetTo[0] = this->numColsWritten + numRows;
             extendDatasetTo[1] = this->numCols;
             columnDataSet.extend( extendDatasetTo );
             
@@ -178,7 +235,7 @@ namespace rsgis{namespace utils{
             dataOffset[0] = this->numColsWritten;
             dataOffset[1] = 0;
             hsize_t dataDims[2];
-            dataDims[0] = 1;
+            dataDims[0] = numRows;
             dataDims[1] = numCols;
             
             H5::DataSpace colWriteDataSpace = columnDataSet.getSpace();
@@ -187,7 +244,7 @@ namespace rsgis{namespace utils{
             
             columnDataSet.write(data, h5Datatype, newDataspace, colWriteDataSpace);
             
-            ++this->numColsWritten;
+            this->numColsWritten += numRows;
         }
         catch (rsgis::RSGISFileException &e)
         {
@@ -217,6 +274,8 @@ namespace rsgis{namespace utils{
     
     void RSGISExportColumnData2HDF::close()
     {
+        this->flush();
+        std::vector<unsigned char>().swap(this->rowBuffer);
         this->columnDataSet.close();
         this->dataH5File->flush(H5F_SCOPE_GLOBAL);
         this->dataH5File->close();
@@ -227,6 +286,42 @@ namespace rsgis{namespace utils{
     {
         
     }
+    
+    
+    RSGISExportColumnData2HDFProducer::RSGISExportColumnData2HDFProducer(RSGISExportColumnData2HDF *dataExport, H5::DataType h5Datatype)
+    {
+        this->dataExport = dataExport;
+        this->h5Datatype = h5Datatype;
+        this->bufferRows = std::max<size_t>(dataExport->getBufferRows(), 1);
+        this->numBufferedRows = 0;
+        this->rowBytes = ((size_t)dataExport->getNumCols()) * h5Datatype.getSize();
+        this->rowBuffer.resize(this->bufferRows * this->rowBytes);
+    }
+    
+    void RSGISExportColumnData2HDFProducer::addDataRow(void *data)
+    {
+        std::memcpy(&this->rowBuffer[this->numBufferedRows * this->rowBytes], data, this->rowBytes);
+        ++this->numBufferedRows;
+        if(this->numBufferedRows == this->bufferRows)
+        {
+            this->flush();
+        }
+    }
+    
+    void RSGISExportColumnData2HDFProducer::flush()
+    {
+        if(this->numBufferedRows > 0)
+        {
+            size_t numRows = this->numBufferedRows;
+            this->numBufferedRows = 0;
+            this->dataExport->addDataRows(this->rowBuffer.data(), numRows, this->h5Datatype);
+        }
+    }
+    
+    RSGISExportColumnData2HDFProducer::~RSGISExportColumnData2HDFProducer()
+    {
+        
+    }
 
 
 
@@ -237,6 +332,8 @@ namespace rsgis{namespace utils{
     
     RSGISReadHDFColumnData::RSGISReadHDFColumnData()
     {
+        dataH5File = NULL;
+        chunkRows = 0;
         fileOpen = false;
     }
     
@@ -244,8 +341,16 @@ namespace rsgis{namespace utils{
     {
         try
         {
+            H5::Exception::dontPrint();
+            
+            H5::FileAccPropList dataAccessPlist = H5::FileAccPropList(H5::FileAccPropList::DEFAULT);
+            dataAccessPlist.setCache(HDF5_READ_MDC_NELMTS, HDF5_READ_RDCC_NELMTS, HDF5_READ_RDCC_NBYTES, HDF5_READ_RDCC_W0);
+            dataAccessPlist.setSieveBufSize(HDF5_READ_SIEVE_BUF);
+            hsize_t metaBlockSize = HDF5_READ_META_BLOCKSIZE;
+            dataAccessPlist.setMetaBlockSize(metaBlockSize);
+            
             const H5std_string h5FilePath(filePath);
-            this->dataH5File = new H5::H5File(h5FilePath, H5F_ACC_RDONLY);
+            this->dataH5File = new H5::H5File(h5FilePath, H5F_ACC_RDONLY, H5::FileCreatPropList::DEFAULT, dataAccessPlist);
             fileOpen = true;
         }
         catch (H5::FileIException &e)
@@ -253,6 +358,28 @@ namespace rsgis{namespace utils{
             std::string message  = std::string("Could not open HDF file: ") + filePath;
             throw rsgis::RSGISFileException(message);
         }
+        
+        try
+        {
+            // The dataset is kept open for the reads.
+            this->columnDataSet = this->dataH5File->openDataSet("/DATA/DATA");
+            this->chunkRows = 0;
+            H5::DSetCreatPropList createPlist = this->columnDataSet.getCreatePlist();
+            if(createPlist.getLayout() == H5D_CHUNKED)
+            {
+                hsize_t chunkDims[2];
+                createPlist.getChunk(2, chunkDims);
+                this->chunkRows = chunkDims[0];
+            }
+            if(this->chunkRows == 0)
+            {
+                this->chunkRows = 1000;
+            }
+        }
+        catch (H5::Exception &e)
+        {
+            throw rsgis::RSGISFileException(e.getDetailMsg());
+        }
     }
     
     unsigned int RSGISReadHDFColumnData::getNumRows()
@@ -262,8 +389,7 @@ namespace rsgis{namespace utils{
         {
             try
             {
-                H5::DataSet dsetColData = dataH5File->openDataSet("/DATA/DATA");
-                H5::DataSpace dspaceColData = dsetColData.getSpace();
+                H5::DataSpace dspaceColData = this->columnDataSet.getSpace();
                 int nDIMs = dspaceColData.getSimpleExtentNdims();
                 hsize_t *dims = new hsize_t[nDIMs];
                 dspaceColData.getSimpleExtentDims(dims);
@@ -289,8 +415,7 @@ namespace rsgis{namespace utils{
         {
             try
             {
-                H5::DataSet dsetColData = dataH5File->openDataSet("/DATA/DATA");
-                H5::DataSpace dspaceColData = dsetColData.getSpace();
+                H5::DataSpace dspaceColData = this->columnDataSet.getSpace();
                 int nDIMs = dspaceColData.getSimpleExtentNdims();
                 hsize_t *dims = new hsize_t[nDIMs];
                 dspaceColData.getSimpleExtentDims(dims);
@@ -315,8 +440,7 @@ namespace rsgis{namespace utils{
         {
             if(fileOpen)
             {
-                H5::DataSet dsetColData = this->dataH5File->openDataSet("/DATA/DATA");
-                H5::DataSpace dspaceColData = dsetColData.getSpace();
+                H5::DataSpace dspaceColData = this->columnDataSet.getSpace();
                 int nDIMs = dspaceColData.getSimpleExtentNdims();
                 hsize_t *dims = new hsize_t[nDIMs];
                 dspaceColData.getSimpleExtentDims(dims);
@@ -341,9 +465,8 @@ namespace rsgis{namespace utils{
                 dataDims[1] = nColsData;
                 H5::DataSpace readDataspace = H5::DataSpace(2, dataDims);
                 dspaceColData.selectHyperslab( H5S_SELECT_SET, dataDims, dataOffset);
-                dsetColData.read( data, h5Datatype, readDataspace, dspaceColData);
+                this->columnDataSet.read( data, h5Datatype, readDataspace, dspaceColData);
 
-                dsetColData.close();
                 dspaceColData.close();
                 readDataspace.close();
 
@@ -364,11 +487,24 @@ namespace rsgis{namespace utils{
         }
     }
     
+    unsigned int RSGISReadHDFColumnData::getChunkRows()
+    {
+        if(!fileOpen)
+        {
+            throw RSGISFileException("HDF5 file is not open.");
+        }
+        return this->chunkRows;
+    }
+    
     void RSGISReadHDFColumnData::close()
     {
         if(fileOpen)
         {
+            this->columnDataSet.close();
             dataH5File->close();
+            delete dataH5File;
+            dataH5File = NULL;
+            fileOpen = false;
         }
         else
         {
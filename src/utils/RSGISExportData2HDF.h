@@ -26,6 +26,10 @@
 
 #include <string>
 #include <iostream>
+#include <vector>
+#include <mutex>
+#include <cstring>
+#include <algorithm>
 
 #include <boost/cstdint.hpp>
 
@@ -64,24 +68,83 @@ namespace rsgis{namespace utils{
     static const hsize_t  HDF5_WRITE_META_BLOCKSIZE( 2048 );
     static const unsigned int HDF5_WRITE_DEFLATE( 1 );
     static const hsize_t HDF5_WRITE_CHUNK_SIZE( 250 ); //100
+    static const hsize_t HDF5_WRITE_CHUNK_NBYTES( 262144 ); // Chunks fit within the chunk cache.
+    static const unsigned int HDF5_WRITE_BUFFER_CHUNKS( 16 ); // Rows buffered before a write, in chunks.
     
+    /**
+     * Write rows of column data to the /DATA/DATA dataset of a HDF5 file. The
+     * dataset is chunked on whole rows with chunks of about
+     * HDF5_WRITE_CHUNK_NBYTES (shuffled and deflated) and rows added one at a
+     * time are buffered in memory and written HDF5_WRITE_BUFFER_CHUNKS chunks
+     * at a time, so each chunk is compressed once rather than the dataset
+     * being extended and written for every row. The add functions are
+     * thread safe; several threads can append rows at once (each through a
+     * RSGISExportColumnData2HDFProducer to buffer its own rows), although
+     * the order of the rows from different threads is not defined.
+     */
 	class DllExport RSGISExportColumnData2HDF
 	{
 	public:
 		RSGISExportColumnData2HDF();
         H5::DataType getH5DataType(RSGISLibDataType rsgis_datatype);
         void createFile(std::string filePath, unsigned int numCols, std::string description, H5::DataType dataType);
+        /**
+         * Add a row (numCols values), buffered until close() or flush().
+         */
         void addDataRow(void *data, H5::DataType h5Datatype);
+        /**
+         * Add numRows rows (numRows x numCols values, row major) with a single write.
+         */
+        void addDataRows(void *data, size_t numRows, H5::DataType h5Datatype);
+        /**
+         * Write any buffered rows to the file.
+         */
+        void flush();
+        unsigned int getNumCols() const {return this->numCols;};
+        /**
+         * The number of rows buffered before they are written.
+         */
+        size_t getBufferRows() const {return this->bufferRows;};
         void close();
 		~RSGISExportColumnData2HDF();
     protected:
+        void writeRows(void *data, size_t numRows, H5::DataType h5Datatype);
+        void flushBuffer();
         H5::H5File *dataH5File;
         H5::DataSet columnDataSet;
         unsigned int numCols;
         unsigned int blockSize;
         unsigned int numColsWritten;
+        size_t bufferRows;
+        size_t numBufferedRows;
+        size_t rowBytes;
+        H5::DataType bufferDataType;
+        std::vector<unsigned char> rowBuffer;
+        std::mutex writeMutex;
 	};
     
+    /**
+     * A buffer of rows for one producer (e.g., a thread) writing to a shared
+     * RSGISExportColumnData2HDF, which are passed on in blocks of the
+     * exporter's buffer size. flush() must be called before the exporter is
+     * closed.
+     */
+    class DllExport RSGISExportColumnData2HDFProducer
+    {
+    public:
+        RSGISExportColumnData2HDFProducer(RSGISExportColumnData2HDF *dataExport, H5::DataType h5Datatype);
+        void addDataRow(void *data);
+        void flush();
+        ~RSGISExportColumnData2HDFProducer();
+    protected:
+        RSGISExportColumnData2HDF *dataExport;
+        H5::DataType h5Datatype;
+        size_t bufferRows;
+        size_t numBufferedRows;
+        size_t rowBytes;
+        std::vector<unsigned char> rowBuffer;
+    };
+    
     class DllExport RSGISReadHDFColumnData
     {
     public:
@@ -89,6 +152,12 @@ namespace rsgis{namespace utils{
         void openFile(std::string filePath);
         unsigned int getNumRows();
         unsigned int getNumCols();
+        /**
+         * The number of rows in a chunk of the dataset; reading blocks of
+         * rows which are a multiple of this, from offsets which are a multiple
+         * of it, means each chunk is only decompressed once.
+         */
+        unsigned int getChunkRows();
         void getDataRows(void *data, unsigned int nColsData, unsigned int nRowsData, H5::DataType h5Datatype, unsigned int nRowsOff, unsigned int nRowsRead);
         void close();
         ~RSGISReadHDFColumnData();
@@ -98,6 +167,7 @@ namespace rsgis{namespace utils{
         unsigned int numCols;
         unsigned int blockSize;
         unsigned int numColsWritten;
+        unsigned int chunkRows;
         bool fileOpen;
     };
 
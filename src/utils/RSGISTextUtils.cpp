@@ -32,27 +32,27 @@ namespace rsgis{namespace utils{
 	
 	size_t RSGISTextUtils::countLines(std::string input)
 	{
-		size_t count = 0;
-        std::ifstream inputFile;
-		inputFile.open(input.c_str());
-		if(inputFile.is_open())
+		rsgis::RSGISTextScanner scanner;
+		try
 		{
-			std::string strLine;		
-			while(!inputFile.eof())
-			{
-				getline(inputFile, strLine, '\n');
-				if(strLine.size() > 0)
-				{
-					count++;
-				}
-			}
+			scanner.openFile(input);
 		}
-		else
+		catch(rsgis::RSGISInputStreamException &e)
 		{
 			std::string message = std::string("Text file ") + input + std::string(" could not be openned.");
 			throw RSGISTextException(message.c_str());
 		}
 		
+		size_t count = 0;
+		const char *lineStart = NULL;
+		const char *lineEnd = NULL;
+		while(scanner.nextLine(&lineStart, &lineEnd))
+		{
+			if(lineStart != lineEnd)
+			{
+				count++;
+			}
+		}
 		return count;
 	}
 	
@@ -156,103 +156,49 @@ namespace rsgis{namespace utils{
 	
 	std::string RSGISTextUtils::readFileToString(std::string input)
 	{
-		std::string wholeFile = "";
-		std::ifstream inputFileStream;
-		inputFileStream.open(input.c_str(), std::ios_base::in);
-		if(!inputFileStream.is_open())
+		rsgis::RSGISTextScanner scanner;
+		try
+		{
+			scanner.openFile(input);
+		}
+		catch(rsgis::RSGISInputStreamException &e)
 		{
 			throw RSGISTextException("File could not be opened.");
 		}
 		
-		std::string strLine = "";
-		bool lineEnding = false;
-		char ch, lastch;
-		inputFileStream.get(ch);
-		while (!inputFileStream.eof()) 
-		{					
-			if ((ch == 0x0a) && (lastch == 0x0d))
-			{
-				lineEnding = true; // Windows Line Ending
-			}
-			else if ((lastch == 0x0d) && (ch != 0x0a)) 
-			{
-				lineEnding = true; // Mac Line Ending
-			} 
-			else if (ch == 0x0a) 
-			{
-				lineEnding = true; // UNIX Line Ending
-			}
-			
-			if(lineEnding)
-			{
-				boost::algorithm::trim(strLine);
-				wholeFile += strLine;
-				strLine = "";
-                lineEnding = false;
-			}
-			else 
-			{
-				strLine += ch;
-			}
-			
-			lastch = ch;
-			inputFileStream.get(ch);
+		std::string wholeFile = "";
+		const char *lineStart = NULL;
+		const char *lineEnd = NULL;
+		while(scanner.nextLine(&lineStart, &lineEnd))
+		{
+			std::string strLine(lineStart, lineEnd);
+			boost::algorithm::trim(strLine);
+			wholeFile += strLine;
 		}
-        boost::algorithm::trim(strLine);
-		wholeFile += strLine;
-		inputFileStream.close();
-		
 		return wholeFile;
 	}
     
     std::vector<std::string> RSGISTextUtils::readFileToStringVector(std::string input)
     {
-        std::vector<std::string> wholeFile;
-		std::ifstream inputFileStream;
-		inputFileStream.open(input.c_str(), std::ios_base::in);
-		if(!inputFileStream.is_open())
+		rsgis::RSGISTextScanner scanner;
+		try
+		{
+			scanner.openFile(input);
+		}
+		catch(rsgis::RSGISInputStreamException &e)
 		{
 			throw RSGISTextException("File could not be opened.");
 		}
 		
-		std::string strLine = "";
-		bool lineEnding = false;
-		char ch, lastch;
-		inputFileStream.get(ch);
-		while (!inputFileStream.eof())
+        std::vector<std::string> wholeFile;
+		const char *lineStart = NULL;
+		const char *lineEnd = NULL;
+		while(scanner.nextLine(&lineStart, &lineEnd))
 		{
-			if ((ch == 0x0a) && (lastch == 0x0d))
-			{
-				lineEnding = true; // Windows Line Ending
-			}
-			else if ((lastch == 0x0d) && (ch != 0x0a))
-			{
-				lineEnding = true; // Mac Line Ending
-			}
-			else if (ch == 0x0a)
-			{
-				lineEnding = true; // UNIX Line Ending
-			}
-			
-			if(lineEnding)
-			{
-				boost::algorithm::trim(strLine);
-				wholeFile.push_back(strLine);
-				strLine = "";
-                lineEnding = false;
-			}
-			else
-			{
-				strLine += ch;
-			}
-			
-			lastch = ch;
-			inputFileStream.get(ch);
+			std::string strLine(lineStart, lineEnd);
+			boost::algorithm::trim(strLine);
+			wholeFile.push_back(strLine);
 		}
-		boost::algorithm::trim(strLine);
-        wholeFile.push_back(strLine);
-		inputFileStream.close();
-		
 		return wholeFile;
     }
     
@@ -727,15 +673,18 @@ namespace rsgis{namespace utils{
 	
 	
 	
-	RSGISTextFileLineReader::RSGISTextFileLineReader(): inputFileStream(), fileOpened(false)
+	RSGISTextFileLineReader::RSGISTextFileLineReader(): scanner(), fileOpened(false)
 	{
 		
 	}
 	
 	void RSGISTextFileLineReader::openFile(std::string filepath)
 	{
-		inputFileStream.open(filepath.c_str(), std::ios_base::in);
-		if(!inputFileStream.is_open())
+		try
+		{
+			scanner.openFile(filepath);
+		}
+		catch(rsgis::RSGISInputStreamException &e)
 		{
 			throw RSGISTextException("File could not be opened.");
 		}
@@ -746,7 +695,7 @@ namespace rsgis{namespace utils{
 	{
 		if(fileOpened)
 		{
-			return inputFileStream.eof();
+			return scanner.endOfFile();
 		}
 		return true;
 	}
@@ -754,47 +703,19 @@ namespace rsgis{namespace utils{
 	std::string RSGISTextFileLineReader::readLine()
 	{
 		std::string strLine = "";
-		bool lineEnding = false;
-		char ch, lastch;
-		inputFileStream.get(ch);
-		while (!inputFileStream.eof()) 
-		{					
-			if ((ch == 0x0a) && (lastch == 0x0d))
-			{
-				lineEnding = true; // Windows Line Ending
-                inputFileStream.unget();
-			}
-			else if ((lastch == 0x0d) && (ch != 0x0a)) 
-			{
-				lineEnding = true; // Mac Line Ending
-                inputFileStream.unget();
-			} 
-			else if (ch == 0x0a) 
-			{
-				lineEnding = true; // UNIX Line Ending
-			}
-			
-			if(lineEnding)
-			{
-				break;
-			}
-			else 
-			{
-				strLine += ch;
-			}
-			
-			lastch = ch;
-			inputFileStream.get(ch);      
+		const char *lineStart = NULL;
+		const char *lineEnd = NULL;
+		if(fileOpened && scanner.nextLine(&lineStart, &lineEnd))
+		{
+			strLine.assign(lineStart, lineEnd);
+			boost::algorithm::trim(strLine);
 		}
-		
-		boost::algorithm::trim(strLine);
-		
 		return strLine;
 	}
 	
 	void RSGISTextFileLineReader::closeFile()
 	{
-		inputFileStream.close();
+		scanner.closeFile();
 		fileOpened = false;
 	}
 	
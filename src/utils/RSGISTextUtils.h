@@ -29,6 +29,8 @@
 #include <fstream>
 #include <vector>
 #include "utils/RSGISTextException.h"
+#include "common/RSGISTextScanner.h"
+#include "common/RSGISInputStreamException.h"
 
 #include <boost/numeric/conversion/cast.hpp>
 #include <boost/lexical_cast.hpp>
@@ -132,6 +134,10 @@ namespace rsgis{namespace utils{
 			~RSGISTextUtils();
 		};
 	
+	/**
+	 * Reads a text file a line at a time (trimmed). The file is read into
+	 * memory when it is opened (see rsgis::RSGISTextScanner).
+	 */
 	class DllExport RSGISTextFileLineReader
 	{
 	public:
@@ -142,7 +148,7 @@ namespace rsgis{namespace utils{
 		void closeFile();
 		~RSGISTextFileLineReader();	
 	private:
-        std::ifstream inputFileStream;
+        rsgis::RSGISTextScanner scanner;
 		bool fileOpened;
 	};
 	
@@ -61,9 +61,7 @@ namespace rsgis{namespace vec{
 			std::cout << "There are " << numFeatures << " to process\n";
 			
 			unsigned long i = 0;
-            unsigned int transactionStep = 20000;
-            unsigned int nextTransaction = transactionStep;
-            bool openTransaction = false;
+            RSGISOGRBatchWriter outWriter(output, 20000);
 			rsgis_tqdm pbar;
 			
 			input->ResetReading();
@@ -72,12 +70,6 @@ namespace rsgis{namespace vec{
 				pbar.progress(i, numFeatures);
 				++i;
 
-                if(!openTransaction)
-                {
-                    output->StartTransaction();
-                    openTransaction = true;
-                }
-				
 				fid = inFeature->GetFID();
 				
 				// Get Geometry.
@@ -114,17 +106,12 @@ namespace rsgis{namespace vec{
 				
 				if(polyOK && !nullGeometry)
 				{
-					outFeature = OGRFeature::CreateFeature(outFeatureDefn);
+					outFeature = outWriter.getFeature();
 					outFeature->SetGeometry(nPolygon);
 					outFeature->SetFID(fid);
 					this->copyFeatureData(inFeature, outFeature, inFeatureDefn, outFeatureDefn);
 					
-					if( output->CreateFeature(outFeature) != OGRERR_NONE )
-					{
-						throw RSGISVectorOutputException("Failed to write feature to the output shapefile.");
-					}
-					
-					OGRFeature::DestroyFeature(outFeature);
+					outWriter.writeFeature(outFeature);
 					numOutputted++;
 				}
 				else 
@@ -135,21 +122,10 @@ namespace rsgis{namespace vec{
                     }
 				}
 
-                if(openTransaction && (i == nextTransaction))
-                {
-                    output->CommitTransaction();
-                    openTransaction = false;
-                    nextTransaction = nextTransaction + transactionStep;
-                }
-
 				OGRFeature::DestroyFeature(inFeature);
 			}
 
-            if(openTransaction)
-            {
-                output->CommitTransaction();
-                openTransaction = false;
-            }
+            outWriter.finish();
 			pbar.finish();
 			
 			std::cout << numOutputted << " Polygons have been outputted from the " << numFeatures << " in the input file.\n";
@@ -93,6 +93,61 @@ namespace rsgis{namespace vec{
 		return numOutputted;
 	}
 	
+	long unsigned RSGISCopyPolygonsInPolygon::copyPolygonsInPoly(OGRLayer *input, RSGISOGRLayerSpatialIndex *inputIdx, OGRLayer *output, OGRGeometry *coverPolygon)
+	{
+		OGRFeature *inFeature = NULL;
+		OGRFeature *outFeature = NULL;
+		
+		OGRFeatureDefn *inFeatureDefn = NULL;
+		OGRFeatureDefn *outFeatureDefn = NULL;
+		
+		long unsigned numOutputted = 0;
+		
+		try
+		{
+			// Copy feature defenitions for output shapefile
+			inFeatureDefn = input->GetLayerDefn();
+			this->copyFeatureDefn(output, inFeatureDefn);
+			outFeatureDefn = output->GetLayerDefn();
+			
+			std::vector<RSGISIndexedOGRGeom*> polysInCover;
+			inputIdx->queryWithin(coverPolygon, &polysInCover);
+			
+			std::cout << "There are " << polysInCover.size() << " polygons within the cover polygon\n";
+			
+			for(std::vector<RSGISIndexedOGRGeom*>::iterator iterPolys = polysInCover.begin(); iterPolys != polysInCover.end(); ++iterPolys)
+			{
+				inFeature = input->GetFeature((*iterPolys)->fid);
+				if(inFeature == NULL)
+				{
+					throw RSGISVectorException("Could not read a feature of the input layer by FID.");
+				}
+				
+				numOutputted++;
+				
+				outFeature = OGRFeature::CreateFeature(outFeatureDefn);
+				outFeature->SetGeometry(inFeature->GetGeometryRef());
+				outFeature->SetFID((*iterPolys)->fid);
+				this->copyFeatureData(inFeature, outFeature, inFeatureDefn, outFeatureDefn);
+				
+				if( output->CreateFeature(outFeature) != OGRERR_NONE )
+				{
+					OGRFeature::DestroyFeature(outFeature);
+					OGRFeature::DestroyFeature(inFeature);
+					throw RSGISVectorOutputException("Failed to write feature to the output shapefile.");
+				}
+				
+				OGRFeature::DestroyFeature(outFeature);
+				OGRFeature::DestroyFeature(inFeature);
+			}
+		}
+		catch(RSGISVectorException &e)
+		{
+			throw e;
+		}
+		return numOutputted;
+	}
+	
 	void RSGISCopyPolygonsInPolygon::copyFeatureDefn(OGRLayer *outputSHPLayer, OGRFeatureDefn *inFeatureDefn)
 	{
 		int fieldCount = inFeatureDefn->GetFieldCount();
@@ -33,6 +33,7 @@
 #include "common/RSGISVectorException.h"
 
 #include "vec/RSGISVectorUtils.h"
+#include "vec/RSGISOGRLayerSpatialIndex.h"
 
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
@@ -54,6 +55,12 @@ namespace rsgis{namespace vec{
 	public:
 		RSGISCopyPolygonsInPolygon();
 		long unsigned copyPolygonsInPoly(OGRLayer *input, OGRLayer *output, OGRGeometry *coverPolygon);
+		/**
+		 * As copyPolygonsInPoly but only the polygons of inputIdx (an index of the input
+		 * layer) whose envelopes are within the cover polygon are tested, which are then
+		 * read from input by FID. Build the index once when copying for many cover polygons.
+		 */
+		long unsigned copyPolygonsInPoly(OGRLayer *input, RSGISOGRLayerSpatialIndex *inputIdx, OGRLayer *output, OGRGeometry *coverPolygon);
 		void copyFeatureDefn(OGRLayer *outputSHPLayer, OGRFeatureDefn *inFeatureDefn);
 		void copyFeatureData(OGRFeature *inFeature, OGRFeature *outFeature, OGRFeatureDefn *inFeatureDefn, OGRFeatureDefn *outFeatureDefn);
 		~RSGISCopyPolygonsInPolygon();
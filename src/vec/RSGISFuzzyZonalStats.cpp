@@ -46,80 +46,308 @@ namespace rsgis{namespace vec{
 		calcValue = new RSGISCalcFuzzyZonalStatsFromRasterPolygon(dataSize, attributes, numAttributes, binSize, threshold);
 		calcImage = new rsgis::img::RSGISCalcImageSingle(calcValue);
 		
+		this->numThreads = rsgis::utils::getNumThreads();
+		this->singlePass = false;
+		
 		this->setupFuzzyAttributes();
 	}
 	
+	void RSGISFuzzyZonalStats::setNumThreads(unsigned int numThreads)
+	{
+		this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+	}
+	
+	void RSGISFuzzyZonalStats::getFeatureGroup(OGRFeature *inFeature, int *groupIdx, bool *hard)
+	{
+		*groupIdx = 0;
+		*hard = false;
+		OGRFeatureDefn *featureDefn = inFeature->GetDefnRef();
+		
+		int classFieldIndex = featureDefn->GetFieldIndex(classattribute.c_str());
+		if(classFieldIndex < 0)
+		{
+			std::string message = "This layer does not contain a field with the name \'" + classattribute + "\'";
+			throw RSGISVectorException(message.c_str());
+		}
+		
+		std::string featureClassGroup = std::string(inFeature->GetFieldAsString(classFieldIndex));
+
+		bool contained = false;
+		for(unsigned int n = 0; n < classSets->size(); n++)
+		{
+			if(classSets->at(n)->name == featureClassGroup)
+			{
+				contained = true;
+				*groupIdx = n;
+				if(featureClassGroup == "Hard")
+				{
+					*hard = true;
+				}
+			}
+		}
+		
+		
+		if(!contained)
+		{
+			if(foundHard)
+			{
+				// use hard.
+				*groupIdx = hardGroupIndex;
+				*hard = true;
+			}
+			else
+			{
+				std::string message = "Hard not defined and unknown feature found: " + featureClassGroup;
+				throw RSGISVectorException(message.c_str());
+			}
+		}
+	}
+	
 	void RSGISFuzzyZonalStats::processFeature(OGRFeature *inFeature, OGRFeature *outFeature, geos::geom::Envelope *env, long fid)
 	{
 		try
 		{
-			int groupIdx = 0;
-			bool hard = false;
-
-			OGRFeatureDefn *featureDefn = inFeature->GetDefnRef();
 			OGRFeatureDefn *outFeatureDefn = outFeature->GetDefnRef();
 			
-			int classFieldIndex = featureDefn->GetFieldIndex(classattribute.c_str());
-			if(classFieldIndex < 0)
+			if(this->singlePass && (fid >= 0) && (((size_t)fid) < this->singlePassIdx.size()) && (this->singlePassIdx[fid] >= 0))
 			{
-				std::string message = "This layer does not contain a field with the name \'" + classattribute + "\'";
-				throw RSGISVectorException(message.c_str());
+				// Calculated by calcFuzzyStatsSinglePass.
+				const double *featData = &this->singlePassData[this->singlePassIdx[fid] * dataSize];
+				for(int i = 0; i < dataSize; i++)
+				{
+					data[i] = featData[i];
+				}
+			}
+			else
+			{
+				int groupIdx = 0;
+				bool hard = false;
+				this->getFeatureGroup(inFeature, &groupIdx, &hard);
+				
+				calcValue->reset();
+				calcValue->updateAttributes(groupedAttributes[classSets->at(groupIdx)->index], classSets->at(groupIdx)->count, hard);
+				calcImage->calcImageWithinRasterPolygon(datasets, 2, data, env, fid, true);
 			}
 			
-			std::string featureClassGroup = std::string(inFeature->GetFieldAsString(classFieldIndex));
-
-			bool contained = false;
-			for(unsigned int n = 0; n < classSets->size(); n++)
+			for(int i = 0; i < (dataSize-1); i++)
 			{
-				if(classSets->at(n)->name == featureClassGroup)
+				outFeature->SetField(outFeatureDefn->GetFieldIndex(attributes[i]->name.c_str()), data[i+1]);
+			}
+			
+			
+			if(outPxlCount)
+			{
+				outFeature->SetField(outFeatureDefn->GetFieldIndex("TotalPxls"), data[0]);
+			}
+		}
+		catch(RSGISException& e)
+		{
+			throw RSGISVectorException(e.what());
+		}
+	}
+	
+	void RSGISFuzzyZonalStats::calcFuzzyStatsSinglePass(OGRLayer *inputLayer)
+	{
+		try
+		{
+			// The class group of each feature, indexed by FID.
+			std::vector<long> fidIdx;
+			std::vector<int> featGroups;
+			std::vector<char> featHard;
+			OGRFeature *inFeature = NULL;
+			inputLayer->ResetReading();
+			while( (inFeature = inputLayer->GetNextFeature()) != NULL )
+			{
+				long fid = inFeature->GetFID();
+				int groupIdx = 0;
+				bool hard = false;
+				try
 				{
-					contained = true;
-					groupIdx = n;
-					if(featureClassGroup == "Hard")
-					{
-						hard = true;
-					}
+					this->getFeatureGroup(inFeature, &groupIdx, &hard);
+				}
+				catch(RSGISException &e)
+				{
+					OGRFeature::DestroyFeature(inFeature);
+					throw;
+				}
+				OGRFeature::DestroyFeature(inFeature);
+				if(fid < 0)
+				{
+					continue;
 				}
+				if(((size_t)fid) >= fidIdx.size())
+				{
+					fidIdx.resize(fid+1, -1);
+				}
+				fidIdx[fid] = featGroups.size();
+				featGroups.push_back(classSets->at(groupIdx)->index);
+				featHard.push_back(hard);
 			}
+			inputLayer->ResetReading();
 			
+			size_t numFeats = featGroups.size();
+			int numBins = calcValue->getNumBins();
+			size_t featHistSize = ((size_t)numAttributes) * numBins;
 			
-			if(!contained)
+			// The bands are the feature raster then the image, as for calcImageWithinRasterPolygon.
+			unsigned int numBands = datasets[0]->GetRasterCount() + datasets[1]->GetRasterCount();
+			for(int i = 0; i < numAttributes; i++)
 			{
-				if(foundHard)
+				for(int j = 0; j < attributes[i]->numBands; j++)
 				{
-					// use hard.
-					groupIdx = hardGroupIndex;
-					hard = true;
+					if((attributes[i]->bands[j] > ((int)numBands-1)) | (attributes[i]->bands[j] < 0))
+					{
+						throw rsgis::img::RSGISImageCalcException("The band attributes do not match the image.");
+					}
 				}
-				else
+				if((attributes[i]->index < 0) | (attributes[i]->index >= numAttributes))
 				{
-					std::string message = "Hard not defined and unknown feature found: " + featureClassGroup;
-					throw RSGISVectorException(message.c_str());
+					throw rsgis::img::RSGISImageCalcException("Attribute index not within range.");
 				}
 			}
 			
+			int **dsOffsets = new int*[2];
+			dsOffsets[0] = new int[2];
+			dsOffsets[1] = new int[2];
+			int width = 0;
+			int height = 0;
+			int xBlockSize = 0;
+			int yBlockSize = 0;
+			double gdalTransform[6];
+			rsgis::img::RSGISImageUtils imgUtils;
+			try
+			{
+				imgUtils.getImageOverlap(datasets, 2, dsOffsets, &width, &height, gdalTransform, &xBlockSize, &yBlockSize);
+			}
+			catch(RSGISException &e)
+			{
+				delete[] dsOffsets[0];
+				delete[] dsOffsets[1];
+				delete[] dsOffsets;
+				throw;
+			}
+			std::vector<GDALRasterBand*> bands;
+			std::vector<int> bandXOffs;
+			std::vector<int> bandYOffs;
+			for(int i = 0; i < 2; i++)
+			{
+				for(int j = 0; j < datasets[i]->GetRasterCount(); j++)
+				{
+					bands.push_back(datasets[i]->GetRasterBand(j+1));
+					bandXOffs.push_back(dsOffsets[i][0]);
+					bandYOffs.push_back(dsOffsets[i][1]);
+				}
+			}
+			delete[] dsOffsets[0];
+			delete[] dsOffsets[1];
+			delete[] dsOffsets;
 			
-			calcValue->reset();
-			calcValue->updateAttributes(groupedAttributes[classSets->at(groupIdx)->index], classSets->at(groupIdx)->count, hard);
-			calcImage->calcImageWithinRasterPolygon(datasets, 2, data, env, fid, true);
+			// The histograms are shared: each worker owns a range of the
+			// features and accumulates only their pixels, so there is one
+			// copy of the histograms whatever the number of threads.
+			rsgis::utils::RSGISWorkerPool pool(this->numThreads);
+			unsigned int numWorkers = std::max<size_t>(std::min<size_t>(pool.getNumThreads(), numFeats), 1);
+			std::vector<int> hists(numFeats * featHistSize, 0);
+			std::vector<int> counts(numFeats, 0);
 			
-			for(int i = 0; i < (dataSize-1); i++)
+			// Read strips of whole blocks.
+			size_t stripRows = std::max(yBlockSize, 1);
+			std::vector<float> vals(stripRows * width * numBands);
+			rsgis_tqdm pbar;
+			for(size_t stripStart = 0; stripStart < ((size_t)height); stripStart += stripRows)
 			{
-				outFeature->SetField(outFeatureDefn->GetFieldIndex(attributes[i]->name.c_str()), data[i+1]);
+				pbar.progress(stripStart, height);
+				size_t nRows = std::min<size_t>(stripRows, height - stripStart);
+				size_t bandStride = nRows * width;
+				for(unsigned int n = 0; n < numBands; ++n)
+				{
+					if(bands[n]->RasterIO(GF_Read, bandXOffs[n], bandYOffs[n] + stripStart, width, nRows, &vals[n*bandStride], width, nRows, GDT_Float32, 0, 0) != CE_None)
+					{
+						throw rsgis::img::RSGISImageCalcException("Could not read the image for the fuzzy zonal stats.");
+					}
+				}
+				
+				pool.parallelFor(numWorkers, [&, bandStride](size_t part, unsigned int t)
+				{
+					long startIdx = (numFeats * part) / numWorkers;
+					long endIdx = (numFeats * (part+1)) / numWorkers;
+					this->accumulateFuzzyRows(vals.data(), bandStride, numBands, 0, bandStride, startIdx, endIdx, &fidIdx, &featGroups, hists.data(), counts.data());
+				});
 			}
+			pbar.finish();
 			
-			
-			if(outPxlCount)
+			// Find the memberships from the histogram of each feature.
+			this->singlePassData.assign(numFeats * dataSize, 0.0);
+			for(size_t i = 0; i < numFeats; ++i)
 			{
-				outFeature->SetField(outFeatureDefn->GetFieldIndex("TotalPxls"), data[0]);
+				calcValue->reset();
+				calcValue->updateAttributes(groupedAttributes[featGroups[i]], classSets->at(featGroups[i])->count, featHard[i]);
+				calcValue->setHistograms(&hists[i * featHistSize], counts[i]);
+				double *outVals = calcValue->getOutputValues();
+				for(int j = 0; j < dataSize; ++j)
+				{
+					this->singlePassData[(i*dataSize)+j] = outVals[j];
+				}
 			}
+			this->singlePassIdx = fidIdx;
+			this->singlePass = true;
 		}
-		catch(RSGISException& e)
+		catch(rsgis::img::RSGISImageCalcException &e)
+		{
+			throw RSGISVectorException(e.what());
+		}
+		catch(RSGISVectorException &e)
+		{
+			throw e;
+		}
+		catch(RSGISException &e)
 		{
 			throw RSGISVectorException(e.what());
 		}
 	}
 	
+	void RSGISFuzzyZonalStats::accumulateFuzzyRows(const float *vals, size_t bandStride, unsigned int numBands, size_t startPxl, size_t endPxl, long startIdx, long endIdx, const std::vector<long> *fidIdx, const std::vector<int> *featGroups, int *hists, int *counts)
+	{
+		int numBins = calcValue->getNumBins();
+		size_t featHistSize = ((size_t)numAttributes) * numBins;
+		for(size_t p = startPxl; p < endPxl; ++p)
+		{
+			float fidVal = vals[p];
+			if(!(fidVal >= 0) || (fidVal >= fidIdx->size()) || (fidVal != floor(fidVal)))
+			{
+				continue;
+			}
+			long idx = (*fidIdx)[(size_t)fidVal];
+			if((idx < startIdx) || (idx >= endIdx))
+			{
+				continue;
+			}
+			int group = (*featGroups)[idx];
+			FuzzyAttributes **groupAtts = groupedAttributes[group];
+			int *featHists = &hists[idx * featHistSize];
+			for(int i = 0; i < classSets->at(group)->count; i++)
+			{
+				// The membership is the minimum of the attribute's bands.
+				float min = vals[(groupAtts[i]->bands[0] * bandStride) + p];
+				for(int j = 1; j < groupAtts[i]->numBands; j++)
+				{
+					float val = vals[(groupAtts[i]->bands[j] * bandStride) + p];
+					if(val < min)
+					{
+						min = val;
+					}
+				}
+				int histogramBin = calcValue->findHistogramBin(min);
+				if(histogramBin < 0)
+				{
+					throw rsgis::img::RSGISImageCalcException("Value outside histogram range (0 - 1)");
+				}
+				featHists[(groupAtts[i]->index * numBins) + histogramBin]++;
+			}
+			counts[idx]++;
+		}
+	}
+	
 	void RSGISFuzzyZonalStats::processFeature(OGRFeature *feature, geos::geom::Envelope *env, long fid)
 	{
 		throw RSGISVectorException("Not Implemented");
@@ -393,6 +621,31 @@ namespace rsgis{namespace vec{
 		numPxls++;
 	}
 	
+	int RSGISCalcFuzzyZonalStatsFromRasterPolygon::findHistogramBin(float value)
+	{
+		int histogramBin = -1;
+		for(int j = 0; j < this->numBins; j++)
+		{
+			if(value > binRange[j] & value <= binRange[j+1])
+			{
+				histogramBin = j;
+			}
+		}
+		return histogramBin;
+	}
+	
+	void RSGISCalcFuzzyZonalStatsFromRasterPolygon::setHistograms(const int *hists, int numPxls)
+	{
+		for(int i = 0; i < (this->numOutputValues-1); i++)
+		{
+			for(int j = 0; j < numBins; j++)
+			{
+				histograms[i][j] = hists[(i*numBins)+j];
+			}
+		}
+		this->numPxls = numPxls;
+	}
+	
 	void RSGISCalcFuzzyZonalStatsFromRasterPolygon::calcImageValue(float *bandValuesImage, int numBands, geos::geom::Envelope *extent) 
 	{
 		throw rsgis::img::RSGISImageCalcException("Not implemented");
@@ -26,11 +26,19 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <thread>
+#include <exception>
+#include <algorithm>
+#include <cstdlib>
+#include <math.h>
 
 #include "gdal_priv.h"
 #include "ogrsf_frmts.h"
 
 #include "common/RSGISVectorException.h"
+#include "common/rsgis-tqdm.h"
+#include "common/RSGISParallel.h"
 
 #include "vec/RSGISVectorOutputException.h"
 #include "vec/RSGISProcessOGRFeature.h"
@@ -38,6 +46,7 @@
 #include "img/RSGISCalcImageSingleValue.h"
 #include "img/RSGISCalcImageSingle.h"
 #include "img/RSGISImageCalcException.h"
+#include "img/RSGISImageUtils.h"
 
 #include "geos/geom/Envelope.h"
 
@@ -83,6 +92,17 @@ namespace rsgis{namespace vec{
 			double* getOutputValues()  ;
 			void reset();
 			void updateAttributes(FuzzyAttributes **attributes, int numAttributes, bool hard);
+			int getNumBins(){return numBins;};
+			/**
+			 * The histogram bin of a value, -1 if it is outside the histogram range.
+			 */
+			int findHistogramBin(float value);
+			/**
+			 * Replace the histograms (numBins counts for each attribute index,
+			 * one after another) and the pixel count, e.g., with those
+			 * accumulated for a feature elsewhere.
+			 */
+			void setHistograms(const int *hists, int numPxls);
 			~RSGISCalcFuzzyZonalStatsFromRasterPolygon();
 		private:
 			float calcHistogramCentre(int *histogram); 
@@ -105,9 +125,29 @@ namespace rsgis{namespace vec{
 			virtual void processFeature(OGRFeature *inFeature, OGRFeature *outFeature, geos::geom::Envelope *env, long fid);
 			virtual void processFeature(OGRFeature *feature, geos::geom::Envelope *env, long fid);
 			virtual void createOutputLayerDefinition(OGRLayer *outputLayer, OGRFeatureDefn *inFeatureDefn);
+			/**
+			 * The number of threads used by calcFuzzyStatsSinglePass (0 uses the number of cores).
+			 */
+			void setNumThreads(unsigned int numThreads);
+			/**
+			 * Calculate the fuzzy stats of every feature of inputLayer in a
+			 * single pass over the rasterised features (pixel values are the
+			 * FIDs) and the image, rather than a pass over the envelope of each
+			 * feature, so processFeature only looks up the results (which are
+			 * then written through RSGISProcessVector's batched writer).
+			 *
+			 * The image is read in strips of rows. The per-feature,
+			 * per-attribute histograms are one flat array of
+			 * numFeatures * numAttributes * numBins * 4 bytes, shared between
+			 * the threads (RSGISLIB_NUM_THREADS or setNumThreads) by giving
+			 * each thread a range of the features whose pixels it accumulates.
+			 */
+			void calcFuzzyStatsSinglePass(OGRLayer *inputLayer);
 			virtual ~RSGISFuzzyZonalStats();
 		protected:
 			void setupFuzzyAttributes();
+			void getFeatureGroup(OGRFeature *inFeature, int *groupIdx, bool *hard);
+			void accumulateFuzzyRows(const float *vals, size_t bandStride, unsigned int numBands, size_t startPxl, size_t endPxl, long startIdx, long endIdx, const std::vector<long> *fidIdx, const std::vector<int> *featGroups, int *hists, int *counts);
 			GDALDataset **datasets;
 			FuzzyAttributes** attributes;
 			
@@ -126,6 +166,12 @@ namespace rsgis{namespace vec{
 			std::string classattribute;
             rsgis::img::RSGISCalcImageSingle *calcImage;
 			RSGISCalcFuzzyZonalStatsFromRasterPolygon *calcValue;
+			unsigned int numThreads;
+			// The results of calcFuzzyStatsSinglePass, dataSize values for each
+			// feature, and the index of the results of each FID (-1 if none).
+			bool singlePass;
+			std::vector<long> singlePassIdx;
+			std::vector<double> singlePassData;
 		};
 	
 	
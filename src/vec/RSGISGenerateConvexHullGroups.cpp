@@ -28,21 +28,29 @@ namespace rsgis{namespace vec{
 
     RSGISGenerateConvexHullGroups::RSGISGenerateConvexHullGroups()
     {
-        
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+    
+    void RSGISGenerateConvexHullGroups::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
     }
     
     std::vector<std::pair<std::string,std::vector<geos::geom::Coordinate>* >* >* RSGISGenerateConvexHullGroups::getCoordinateGroups(std::string inputFile, unsigned int eastingsColIdx, unsigned int northingsColIdx, unsigned int attributeColIdx)
     {
-        std::vector<std::pair<std::string,std::vector<geos::geom::Coordinate>* >* > *coordGrps = NULL;
+        std::vector<std::pair<std::string,std::vector<geos::geom::Coordinate>* >* > *coordGrps = new std::vector<std::pair<std::string,std::vector<geos::geom::Coordinate>* >* >();
         try
         {
-            std::cout << "Find the Unique Attribute Values." << std::endl;
-            std::vector<std::string> grps;
-            std::vector<std::string> *tokens = new std::vector<std::string>();
+            // The groups are found and populated in a single pass, in the order
+            // in which they first appear in the file.
+            std::cout << "Reading the points into groups." << std::endl;
+            std::unordered_map<std::string, size_t> grpIdxs;
+            std::vector<std::string> tokens;
             
             std::string line = "";
             std::string att = "";
-            bool foundAtt = false;
+            double eastings = 0.0;
+            double northings = 0.0;
             
             rsgis::utils::RSGISTextUtils textUtils;
             rsgis::utils::RSGISTextFileLineReader lineReader;
@@ -51,139 +59,240 @@ namespace rsgis{namespace vec{
             {
                 line = lineReader.readLine();
                 
-                tokens->clear();
-                textUtils.tokenizeString(line, ',', tokens, true, true);
+                tokens.clear();
+                textUtils.tokenizeString(line, ',', &tokens, true, true);
                 
-                att = tokens->at(attributeColIdx);
+                att = tokens.at(attributeColIdx);
                 if(!textUtils.blankline(att))
                 {
-                    if(grps.empty())
+                    eastings = textUtils.strtodouble(tokens.at(eastingsColIdx));
+                    northings = textUtils.strtodouble(tokens.at(northingsColIdx));
+                    
+                    std::unordered_map<std::string, size_t>::iterator iterGrp = grpIdxs.find(att);
+                    if(iterGrp == grpIdxs.end())
                     {
-                        grps.push_back(att);
-                    }
-                    else
-                    {
-                        foundAtt = false;
-                        for(std::vector<std::string>::iterator iterGrps = grps.begin(); iterGrps != grps.end(); ++iterGrps)
-                        {
-                            if(att == (*iterGrps))
-                            {
-                                foundAtt = true;
-                                break;
-                            }
-                        }
-                        if(!foundAtt)
-                        {
-                            grps.push_back(att);
-                        }
+                        std::pair<std::string,std::vector<geos::geom::Coordinate>* > *grpPair = new std::pair<std::string,std::vector<geos::geom::Coordinate>* >();
+                        grpPair->first = att;
+                        grpPair->second = new std::vector<geos::geom::Coordinate>();
+                        coordGrps->push_back(grpPair);
+                        iterGrp = grpIdxs.insert(std::pair<std::string, size_t>(att, coordGrps->size()-1)).first;
                     }
+                    coordGrps->at(iterGrp->second)->second->push_back(geos::geom::Coordinate(eastings, northings));
                 }
             }
             lineReader.closeFile();
             
-           if(grps.empty())
-           {
-               throw RSGISVectorException("There were no groups identified.");
-           }
-            
-            std::cout << "Groups Are:\n";
-            for(std::vector<std::string>::iterator iterGrps = grps.begin(); iterGrps != grps.end(); ++iterGrps)
+            if(coordGrps->empty())
             {
-                std::cout << "\t" << *iterGrps << std::endl;
+                throw RSGISVectorException("There were no groups identified.");
             }
             
-            std::cout << "Populate the data structure\n";
-            coordGrps = new std::vector<std::pair<std::string,std::vector<geos::geom::Coordinate>* >* >();
-            std::pair<std::string,std::vector<geos::geom::Coordinate>* > *grpPair = NULL;
-            coordGrps->reserve(grps.size());
-            for(size_t i = 0; i < grps.size(); ++i)
+            std::cout << "Groups Are:\n";
+            for(std::vector<std::pair<std::string,std::vector<geos::geom::Coordinate>* >* >::iterator iterGrps = coordGrps->begin(); iterGrps != coordGrps->end(); ++iterGrps)
             {
-                grpPair = new std::pair<std::string,std::vector<geos::geom::Coordinate>* >();
-                grpPair->first = grps.at(i);
-                grpPair->second = new std::vector<geos::geom::Coordinate>();
-                coordGrps->push_back(grpPair);
+                std::cout << "\t" << (*iterGrps)->first << std::endl;
             }
-            
-            double eastings = 0.0;
-            double northings = 0.0;
-            lineReader.openFile(inputFile);
-            while(!lineReader.endOfFile())
-            {
-                line = lineReader.readLine();
-                
-                tokens->clear();
-                textUtils.tokenizeString(line, ',', tokens, true, true);
-                
-                att = tokens->at(attributeColIdx);
-                eastings = textUtils.strtodouble(tokens->at(eastingsColIdx));
-                northings = textUtils.strtodouble(tokens->at(northingsColIdx));
-                if(!textUtils.blankline(att))
-                {
-                    for(std::vector<std::pair<std::string,std::vector<geos::geom::Coordinate>* >* >::iterator iterGrps = coordGrps->begin(); iterGrps != coordGrps->end(); ++iterGrps)
-                    {
-                        if((*iterGrps)->first == att)
-                        {
-                            (*iterGrps)->second->push_back(geos::geom::Coordinate(eastings, northings));
-                        }
-                    }
-                }
-            }
-            lineReader.closeFile();
-            
         }
         catch (RSGISVectorException &e)
         {
+            for(std::vector<std::pair<std::string,std::vector<geos::geom::Coordinate>* >* >::iterator iterGrps = coordGrps->begin(); iterGrps != coordGrps->end(); ++iterGrps)
+            {
+                delete (*iterGrps)->second;
+                delete (*iterGrps);
+            }
+            delete coordGrps;
             throw e;
         }
         catch (rsgis::RSGISException &e)
         {
+            for(std::vector<std::pair<std::string,std::vector<geos::geom::Coordinate>* >* >::iterator iterGrps = coordGrps->begin(); iterGrps != coordGrps->end(); ++iterGrps)
+            {
+                delete (*iterGrps)->second;
+                delete (*iterGrps);
+            }
+            delete coordGrps;
             throw RSGISVectorException(e.what());
         }
         
         return coordGrps;
     }
     
-    
     void RSGISGenerateConvexHullGroups::createPolygonsAsShapefile(std::vector<std::pair<std::string,std::vector<geos::geom::Coordinate>* >* > *coordGrps, std::string outputFile, std::string outProj, bool force)
     {
+        size_t numGrps = coordGrps->size();
+        std::vector<OGRPolygon*> polys(numGrps, NULL);
         try
         {
-            rsgis::geom::RSGISGeometry geomUtils;
-            std::vector<geos::geom::Polygon*> *polys = new std::vector<geos::geom::Polygon*>();
-            std::vector<std::string> *grpNames = new std::vector<std::string>();
-            geos::geom::Polygon *poly = NULL;
+            // Each group's polygon is independent so the groups are shared among the threads.
+            rsgis::utils::parallelFor(numGrps, this->numThreads, [&](size_t idx, unsigned int)
+            {
+                std::vector<geos::geom::Coordinate> *coords = coordGrps->at(idx)->second;
+                std::vector<geos::geom::Coordinate> hull;
+                if(!RSGISGenerateConvexHullGroups::calcConvexHull(coords, &hull))
+                {
+                    double xMin = 0;
+                    double xMax = 0;
+                    double yMin = 0;
+                    double yMax = 0;
+                    for(std::vector<geos::geom::Coordinate>::iterator iterCoords = coords->begin(); iterCoords != coords->end(); ++iterCoords)
+                    {
+                        if(iterCoords == coords->begin())
+                        {
+                            xMin = xMax = (*iterCoords).x;
+                            yMin = yMax = (*iterCoords).y;
+                        }
+                        xMin = std::min(xMin, (*iterCoords).x);
+                        xMax = std::max(xMax, (*iterCoords).x);
+                        yMin = std::min(yMin, (*iterCoords).y);
+                        yMax = std::max(yMax, (*iterCoords).y);
+                    }
+                    hull.clear();
+                    hull.push_back(geos::geom::Coordinate(xMin, yMin));
+                    hull.push_back(geos::geom::Coordinate(xMax, yMin));
+                    hull.push_back(geos::geom::Coordinate(xMax, yMax));
+                    hull.push_back(geos::geom::Coordinate(xMin, yMax));
+                    hull.push_back(geos::geom::Coordinate(xMin, yMin));
+                }
+                
+                OGRLinearRing ring;
+                for(std::vector<geos::geom::Coordinate>::iterator iterHull = hull.begin(); iterHull != hull.end(); ++iterHull)
+                {
+                    ring.addPoint((*iterHull).x, (*iterHull).y);
+                }
+                OGRPolygon *poly = new OGRPolygon();
+                poly->addRing(&ring);
+                polys[idx] = poly;
+            });
             
-            for(std::vector<std::pair<std::string,std::vector<geos::geom::Coordinate>* >* >::iterator iterGrps = coordGrps->begin(); iterGrps != coordGrps->end(); ++iterGrps)
+            OGRRegisterAll();
+            RSGISVectorUtils vecUtils;
+            rsgis::utils::RSGISFileUtils fileUtils;
+            
+            std::string SHPFileOutLayer = vecUtils.getLayerName(outputFile);
+            std::string outputDIR = fileUtils.getFileDirectoryPath(outputFile);
+            if(vecUtils.checkDIR4SHP(outputDIR, SHPFileOutLayer))
             {
-                if((*iterGrps)->second->size() < 3)
+                if(force)
                 {
-                    poly = geomUtils.findBoundingBox((*iterGrps)->second);
+                    vecUtils.deleteSHP(outputDIR, SHPFileOutLayer);
                 }
                 else
                 {
-                    poly = geomUtils.findConvexHull((*iterGrps)->second);
+                    throw RSGISVectorException("Shapefile already exists, either delete or select force.");
                 }
-                polys->push_back(poly);
-                grpNames->push_back((*iterGrps)->first);
             }
             
-            OGRSpatialReference *spatialRef = new OGRSpatialReference(outProj.c_str());
-            rsgis::vec::RSGISVectorIO vecIO;
-            vecIO.exportGEOSPolygons2SHP(outputFile, force, polys, spatialRef, grpNames, "GrpName");
+            GDALDriver *shpFiledriver = GetGDALDriverManager()->GetDriverByName("ESRI Shapefile");
+            if(shpFiledriver == NULL)
+            {
+                throw RSGISVectorOutputException("SHP driver not available.");
+            }
+            GDALDataset *outputSHPDS = shpFiledriver->Create(outputFile.c_str(), 0, 0, 0, GDT_Unknown, NULL);
+            if(outputSHPDS == NULL)
+            {
+                std::string message = std::string("Could not create vector file ") + outputFile;
+                throw RSGISVectorOutputException(message.c_str());
+            }
+            
+            OGRSpatialReference spatialRef(outProj.c_str());
+            OGRLayer *outputSHPLayer = outputSHPDS->CreateLayer(SHPFileOutLayer.c_str(), &spatialRef, wkbPolygon, NULL);
+            if(outputSHPLayer == NULL)
+            {
+                GDALClose(outputSHPDS);
+                std::string message = std::string("Could not create vector layer ") + SHPFileOutLayer;
+                throw RSGISVectorOutputException(message.c_str());
+            }
+            
+            OGRFieldDefn shpField("GrpName", OFTString);
+            shpField.SetWidth(254);
+            if(outputSHPLayer->CreateField(&shpField) != OGRERR_NONE)
+            {
+                GDALClose(outputSHPDS);
+                throw RSGISVectorOutputException("Creating shapefile field \'GrpName\' has failed");
+            }
+            int outColIdx = outputSHPLayer->GetLayerDefn()->GetFieldIndex("GrpName");
+            
+            RSGISOGRBatchWriter outWriter(outputSHPLayer, 20000);
+            for(size_t i = 0; i < numGrps; ++i)
+            {
+                OGRFeature *featureOutput = outWriter.getFeature();
+                featureOutput->SetGeometryDirectly(polys[i]);
+                polys[i] = NULL;
+                featureOutput->SetField(outColIdx, coordGrps->at(i)->first.c_str());
+                outWriter.writeFeature(featureOutput);
+            }
+            outWriter.finish();
+            GDALClose(outputSHPDS);
         }
         catch (RSGISVectorOutputException &e)
         {
+            for(size_t i = 0; i < numGrps; ++i)
+            {
+                delete polys[i];
+            }
             throw RSGISVectorException(e.what());
         }
         catch (RSGISVectorException &e)
         {
+            for(size_t i = 0; i < numGrps; ++i)
+            {
+                delete polys[i];
+            }
             throw e;
         }
         catch (rsgis::RSGISException &e)
         {
+            for(size_t i = 0; i < numGrps; ++i)
+            {
+                delete polys[i];
+            }
             throw RSGISVectorException(e.what());
         }
     }
+    
+    bool RSGISGenerateConvexHullGroups::calcConvexHull(std::vector<geos::geom::Coordinate> *coords, std::vector<geos::geom::Coordinate> *hull)
+    {
+        hull->clear();
+        size_t numPts = coords->size();
+        if(numPts < 3)
+        {
+            return false;
+        }
+        std::sort(coords->begin(), coords->end(), [](const geos::geom::Coordinate &a, const geos::geom::Coordinate &b)
+        {
+            return (a.x < b.x) || ((a.x == b.x) && (a.y < b.y));
+        });
+        
+        // The lower hull left to right then the upper hull right to left,
+        // dropping the points which do not make an anti-clockwise turn.
+        hull->resize(2 * numPts);
+        size_t k = 0;
+        for(size_t i = 0; i < numPts; ++i)
+        {
+            while((k >= 2) && (RSGISGenerateConvexHullGroups::cross((*hull)[k-2], (*hull)[k-1], (*coords)[i]) <= 0))
+            {
+                --k;
+            }
+            (*hull)[k++] = (*coords)[i];
+        }
+        size_t lowerSize = k + 1;
+        for(size_t i = numPts - 1; i > 0; --i)
+        {
+            while((k >= lowerSize) && (RSGISGenerateConvexHullGroups::cross((*hull)[k-2], (*hull)[k-1], (*coords)[i-1]) <= 0))
+            {
+                --k;
+            }
+            (*hull)[k++] = (*coords)[i-1];
+        }
+        // The first point is repeated at the end, closing the ring.
+        hull->resize(k);
+        if(k < 4)
+        {
+            hull->clear();
+            return false;
+        }
+        return true;
+    }
 		
     RSGISGenerateConvexHullGroups::~RSGISGenerateConvexHullGroups()
     {
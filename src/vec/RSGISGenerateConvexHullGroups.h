@@ -27,15 +27,23 @@
 #include <iostream>
 #include <string>
 #include <list>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
 
 #include "ogrsf_frmts.h"
 
 #include "common/RSGISVectorException.h"
+#include "common/RSGISParallel.h"
 
 #include "geom/RSGISGeometry.h"
 
 #include "vec/RSGISVectorUtils.h"
 #include "vec/RSGISVectorIO.h"
+#include "vec/RSGISOGRBatchWriter.h"
+#include "vec/RSGISProcessGeometry.h"
 
 #include "geos/geom/Coordinate.h"
 
@@ -56,14 +64,41 @@
 
 namespace rsgis{namespace vec{
 	
+	/**
+	 * Generate a polygon around each group of points in a CSV file. The
+	 * points are grouped by attribute in a single pass over the file, the
+	 * convex hulls (monotone chain) of the groups are found in parallel and
+	 * the polygons written with RSGISOGRBatchWriter. Groups with fewer than
+	 * three points, or whose points are collinear, are given their bounding
+	 * box.
+	 */
 	class DllExport RSGISGenerateConvexHullGroups
 	{
 	public:
 		RSGISGenerateConvexHullGroups();
+        /**
+         * The number of groups processed at once (default RSGISLIB_NUM_THREADS or 1); 0 uses the number of cores.
+         */
+        void setNumThreads(unsigned int numThreads);
         std::vector<std::pair<std::string,std::vector<geos::geom::Coordinate>* >* >* getCoordinateGroups(std::string inputFile, unsigned int eastingsColIdx, unsigned int northingsColIdx, unsigned int attributeColIdx);
 		void createPolygonsAsShapefile(std::vector<std::pair<std::string,std::vector<geos::geom::Coordinate>* >* > *coordGrps, std::string outputFile, std::string outProj, bool force);
+        /**
+         * The convex hull of the coordinates (Andrew's monotone chain) as a
+         * closed ring in anti-clockwise order. The coordinates are sorted in
+         * place. Returns false if the points are collinear (or fewer than 3).
+         */
+        static bool calcConvexHull(std::vector<geos::geom::Coordinate> *coords, std::vector<geos::geom::Coordinate> *hull);
         
         ~RSGISGenerateConvexHullGroups();
+    protected:
+        /**
+         * The z component of the cross product of (b - a) and (c - a); positive for an anti-clockwise turn.
+         */
+        static double cross(const geos::geom::Coordinate &a, const geos::geom::Coordinate &b, const geos::geom::Coordinate &c)
+        {
+            return ((b.x - a.x) * (c.y - a.y)) - ((b.y - a.y) * (c.x - a.x));
+        };
+        unsigned int numThreads;
 	};
 	
 }}
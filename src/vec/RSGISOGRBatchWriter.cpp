@@ -0,0 +1,147 @@
+/*
+ *  RSGISOGRBatchWriter.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2010 RSGISLib. All rights reserved.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISOGRBatchWriter.h"
+
+namespace rsgis{namespace vec{
+
+    RSGISOGRBatchWriter::RSGISOGRBatchWriter(OGRLayer *layer, unsigned long featsPerTransaction)
+    {
+        if(layer == NULL)
+        {
+            throw RSGISVectorOutputException("The output layer is NULL.");
+        }
+        this->layer = layer;
+        this->feature = NULL;
+        this->featsPerTransaction = (featsPerTransaction == 0)?1:featsPerTransaction;
+        this->numWritten = 0;
+        this->numInTransaction = 0;
+        this->openTransaction = false;
+    }
+
+    OGRFeature* RSGISOGRBatchWriter::getFeature()
+    {
+        if(this->feature == NULL)
+        {
+            this->feature = OGRFeature::CreateFeature(this->layer->GetLayerDefn());
+        }
+        else
+        {
+            for(int i = 0; i < this->feature->GetFieldCount(); ++i)
+            {
+                this->feature->UnsetField(i);
+            }
+            for(int i = 0; i < this->feature->GetGeomFieldCount(); ++i)
+            {
+                this->feature->SetGeomFieldDirectly(i, NULL);
+            }
+            this->feature->SetFID(OGRNullFID);
+        }
+        return this->feature;
+    }
+
+    void RSGISOGRBatchWriter::writeFeature(OGRFeature *feature)
+    {
+        if(!this->openTransaction)
+        {
+            // Drivers without transactions return an error which can be ignored.
+            this->openTransaction = (this->layer->StartTransaction() == OGRERR_NONE);
+            this->numInTransaction = 0;
+        }
+
+        if(this->layer->CreateFeature(feature) != OGRERR_NONE)
+        {
+            throw RSGISVectorOutputException("Failed to write feature to the output layer.");
+        }
+        ++this->numWritten;
+        ++this->numInTransaction;
+
+        if(this->numInTransaction >= this->featsPerTransaction)
+        {
+            this->finish();
+        }
+    }
+
+    void RSGISOGRBatchWriter::finish()
+    {
+        if(this->openTransaction)
+        {
+            this->openTransaction = false;
+            if(this->layer->CommitTransaction() != OGRERR_NONE)
+            {
+                throw RSGISVectorOutputException("Failed to commit the features written to the output layer.");
+            }
+        }
+        this->numInTransaction = 0;
+    }
+
+    char** RSGISOGRBatchWriter::getBulkLayerOptions(GDALDriver *driver, char **lyrOptions)
+    {
+        char **options = CSLDuplicate(lyrOptions);
+        if(driver != NULL)
+        {
+            std::string driverName = std::string(driver->GetDescription());
+            if(((driverName == "GPKG") || (driverName == "SQLite")) && (CSLFetchNameValue(options, "SPATIAL_INDEX") == NULL))
+            {
+                options = CSLSetNameValue(options, "SPATIAL_INDEX", "NO");
+            }
+        }
+        return options;
+    }
+
+    void RSGISOGRBatchWriter::createDeferredSpatialIndex(GDALDriver *driver, GDALDataset *dataset, OGRLayer *layer)
+    {
+        if((driver == NULL) || (dataset == NULL) || (layer == NULL))
+        {
+            return;
+        }
+        std::string driverName = std::string(driver->GetDescription());
+        if((driverName == "GPKG") || (driverName == "SQLite"))
+        {
+            std::string geomColName = std::string(layer->GetGeometryColumn());
+            if(geomColName == "")
+            {
+                return;
+            }
+            std::string sql = std::string("SELECT CreateSpatialIndex('") + std::string(layer->GetName()) + std::string("', '") + geomColName + std::string("')");
+            OGRLayer *resultsLayer = dataset->ExecuteSQL(sql.c_str(), NULL, NULL);
+            if(resultsLayer != NULL)
+            {
+                dataset->ReleaseResultSet(resultsLayer);
+            }
+        }
+    }
+
+    RSGISOGRBatchWriter::~RSGISOGRBatchWriter()
+    {
+        if(this->openTransaction)
+        {
+            this->layer->CommitTransaction();
+        }
+        if(this->feature != NULL)
+        {
+            OGRFeature::DestroyFeature(this->feature);
+        }
+    }
+
+}}
@@ -0,0 +1,106 @@
+/*
+ *  RSGISOGRBatchWriter.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2010 RSGISLib. All rights reserved.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISOGRBatchWriter_H
+#define RSGISOGRBatchWriter_H
+
+#include <iostream>
+#include <string>
+
+#include "ogrsf_frmts.h"
+#include "cpl_string.h"
+
+#include "common/RSGISVectorException.h"
+
+#include "vec/RSGISVectorOutputException.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_vec_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace vec{
+
+    /**
+     * Writes features to a layer inside transactions of featsPerTransaction
+     * features, so drivers with transactions (GPKG, SQLite, PostgreSQL) do
+     * not commit every feature, and provides a single output feature to be
+     * filled and written for each output rather than creating and destroying
+     * a feature each time.
+     *
+     * finish() (or the destructor) commits the last transaction. For the
+     * drivers whose spatial index is updated on each insert the layer can be
+     * created with getBulkLayerOptions and the index built once, after all
+     * the features have been written, with createDeferredSpatialIndex.
+     */
+    class DllExport RSGISOGRBatchWriter
+    {
+    public:
+        RSGISOGRBatchWriter(OGRLayer *layer, unsigned long featsPerTransaction=20000);
+        /**
+         * The reusable feature of the layer definition, with its fields unset,
+         * no geometry and a null FID.
+         */
+        OGRFeature* getFeature();
+        /**
+         * Write a feature to the layer (either the one from getFeature or any
+         * other feature of the layer definition, which is not destroyed).
+         */
+        void writeFeature(OGRFeature *feature);
+        /**
+         * Commit the open transaction.
+         */
+        void finish();
+        unsigned long getNumWritten() const {return numWritten;};
+        /**
+         * Add the layer creation options which stop the spatial index being
+         * updated as features are written, for the drivers which support it.
+         * Returns the (CSL) list of options, which the caller should destroy.
+         */
+        static char** getBulkLayerOptions(GDALDriver *driver, char **lyrOptions=NULL);
+        /**
+         * Build the spatial index of a layer created with getBulkLayerOptions,
+         * once all the features have been written.
+         */
+        static void createDeferredSpatialIndex(GDALDriver *driver, GDALDataset *dataset, OGRLayer *layer);
+        ~RSGISOGRBatchWriter();
+    protected:
+        OGRLayer *layer;
+        OGRFeature *feature;
+        unsigned long featsPerTransaction;
+        unsigned long numWritten;
+        unsigned long numInTransaction;
+        bool openTransaction;
+    };
+
+}}
+
+#endif
@@ -0,0 +1,225 @@
+/*
+ *  RSGISOGRChunkReader.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2010 RSGISLib. All rights reserved.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISOGRChunkReader.h"
+
+namespace rsgis{namespace vec{
+
+    RSGISOGRChunkReader::RSGISOGRChunkReader(OGRLayer *layer, size_t memBudget, size_t maxChunkFeats)
+    {
+        if(layer == NULL)
+        {
+            throw RSGISVectorException("The layer to read is NULL.");
+        }
+        this->layer = layer;
+        this->memBudget = memBudget;
+        this->maxChunkFeats = maxChunkFeats;
+        this->numFeatsRead = 0;
+        this->attFilterSet = false;
+        this->spatialFilterSet = false;
+        this->finished = false;
+        this->layer->ResetReading();
+    }
+
+    void RSGISOGRChunkReader::setAttributeFilter(std::string filter)
+    {
+        OGRErr err = OGRERR_NONE;
+        if(filter == "")
+        {
+            err = this->layer->SetAttributeFilter(NULL);
+            this->attFilterSet = false;
+        }
+        else
+        {
+            err = this->layer->SetAttributeFilter(filter.c_str());
+            this->attFilterSet = true;
+        }
+        if(err != OGRERR_NONE)
+        {
+            std::string message = std::string("Could not set the attribute filter '") + filter + std::string("' on the layer.");
+            throw RSGISVectorException(message);
+        }
+        this->reset();
+    }
+
+    void RSGISOGRChunkReader::setSpatialFilter(OGRGeometry *geom)
+    {
+        this->layer->SetSpatialFilter(geom);
+        this->spatialFilterSet = (geom != NULL);
+        this->reset();
+    }
+
+    void RSGISOGRChunkReader::setSpatialFilterRect(double minX, double minY, double maxX, double maxY)
+    {
+        this->layer->SetSpatialFilterRect(minX, minY, maxX, maxY);
+        this->spatialFilterSet = true;
+        this->reset();
+    }
+
+    void RSGISOGRChunkReader::reset()
+    {
+        this->clearChunk();
+        this->layer->ResetReading();
+        this->numFeatsRead = 0;
+        this->finished = false;
+    }
+
+    bool RSGISOGRChunkReader::nextChunk(std::vector<OGRGeometry*> *geoms, std::vector<long> *fids)
+    {
+        geoms->clear();
+        if(fids != NULL)
+        {
+            fids->clear();
+        }
+
+        if(!this->readChunk())
+        {
+            return false;
+        }
+
+        geoms->insert(geoms->end(), this->chunkGeoms.begin(), this->chunkGeoms.end());
+        if(fids != NULL)
+        {
+            fids->insert(fids->end(), this->chunkFIDs.begin(), this->chunkFIDs.end());
+        }
+        return true;
+    }
+
+    bool RSGISOGRChunkReader::nextChunk(std::vector<geos::geom::Polygon*> *polys)
+    {
+        polys->clear();
+
+        if(!this->readChunk())
+        {
+            return false;
+        }
+
+        rsgis::geom::RSGISGeometry geomUtils;
+        for(std::vector<OGRGeometry*>::iterator iterGeoms = this->chunkGeoms.begin(); iterGeoms != this->chunkGeoms.end(); ++iterGeoms)
+        {
+            OGRwkbGeometryType geometryType = wkbFlatten((*iterGeoms)->getGeometryType());
+            if(geometryType == wkbPolygon)
+            {
+                this->chunkPolys.push_back(this->vecUtils.convertOGRPolygon2GEOSPolygon((OGRPolygon*) *iterGeoms));
+            }
+            else if(geometryType == wkbMultiPolygon)
+            {
+                geos::geom::MultiPolygon *mGEOSPolygon = this->vecUtils.convertOGRMultiPolygonGEOSMultiPolygon((OGRMultiPolygon*) *iterGeoms);
+                geomUtils.retrievePolygons(mGEOSPolygon, &this->chunkPolys);
+                delete mGEOSPolygon;
+            }
+            else
+            {
+                std::string message = std::string("Unsupport data type: ") + std::string((*iterGeoms)->getGeometryName());
+                throw RSGISVectorException(message);
+            }
+        }
+
+        // The OGR geometries are not needed once converted.
+        for(std::vector<OGRGeometry*>::iterator iterGeoms = this->chunkGeoms.begin(); iterGeoms != this->chunkGeoms.end(); ++iterGeoms)
+        {
+            delete *iterGeoms;
+        }
+        this->chunkGeoms.clear();
+
+        polys->insert(polys->end(), this->chunkPolys.begin(), this->chunkPolys.end());
+        return true;
+    }
+
+    bool RSGISOGRChunkReader::readChunk()
+    {
+        this->clearChunk();
+        if(this->finished)
+        {
+            return false;
+        }
+
+        size_t chunkSize = 0;
+        OGRFeature *feature = NULL;
+        while(true)
+        {
+            if((this->maxChunkFeats > 0) && (this->chunkGeoms.size() >= this->maxChunkFeats))
+            {
+                break;
+            }
+            if((!this->chunkGeoms.empty()) && (chunkSize >= this->memBudget))
+            {
+                break;
+            }
+
+            feature = this->layer->GetNextFeature();
+            if(feature == NULL)
+            {
+                this->finished = true;
+                break;
+            }
+            ++this->numFeatsRead;
+
+            // Take ownership of the geometry rather than cloning it.
+            OGRGeometry *geometry = feature->StealGeometry();
+            if((geometry != NULL) && (!geometry->IsEmpty()))
+            {
+                // The WKB size is close to the number of bytes of coordinates held.
+                chunkSize += geometry->WkbSize() + sizeof(OGRGeometry*) + sizeof(long);
+                this->chunkGeoms.push_back(geometry);
+                this->chunkFIDs.push_back(feature->GetFID());
+            }
+            else if(geometry != NULL)
+            {
+                delete geometry;
+            }
+            OGRFeature::DestroyFeature(feature);
+        }
+
+        return !this->chunkGeoms.empty();
+    }
+
+    void RSGISOGRChunkReader::clearChunk()
+    {
+        for(std::vector<OGRGeometry*>::iterator iterGeoms = this->chunkGeoms.begin(); iterGeoms != this->chunkGeoms.end(); ++iterGeoms)
+        {
+            delete *iterGeoms;
+        }
+        this->chunkGeoms.clear();
+        this->chunkFIDs.clear();
+        for(std::vector<geos::geom::Polygon*>::iterator iterPolys = this->chunkPolys.begin(); iterPolys != this->chunkPolys.end(); ++iterPolys)
+        {
+            delete *iterPolys;
+        }
+        this->chunkPolys.clear();
+    }
+
+    RSGISOGRChunkReader::~RSGISOGRChunkReader()
+    {
+        this->clearChunk();
+        if(this->attFilterSet)
+        {
+            this->layer->SetAttributeFilter(NULL);
+        }
+        if(this->spatialFilterSet)
+        {
+            this->layer->SetSpatialFilter(NULL);
+        }
+    }
+
+}}
@@ -0,0 +1,125 @@
+/*
+ *  RSGISOGRChunkReader.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2010 RSGISLib. All rights reserved.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISOGRChunkReader_H
+#define RSGISOGRChunkReader_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ogrsf_frmts.h"
+
+#include "common/RSGISVectorException.h"
+
+#include "vec/RSGISVectorUtils.h"
+
+#include "geom/RSGISGeometry.h"
+
+#include "geos/geom/Polygon.h"
+#include "geos/geom/MultiPolygon.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_vec_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace vec{
+
+    /**
+     * Reads the geometries of a layer in chunks of a bounded size, rather
+     * than reading every feature into a list (as RSGISOGRPolygonReader and
+     * RSGISGEOSPolygonReader do), so layers far larger than memory can be
+     * processed a chunk at a time.
+     *
+     * Attribute and spatial filters are passed to the layer so OGR (and the
+     * driver, e.g. a SQL where clause or the spatial index of a shapefile)
+     * does the filtering; the filters are cleared from the layer when the
+     * reader is destroyed.
+     *
+     * The geometries of a chunk belong to the reader and are deleted by the
+     * next call to nextChunk (or the destructor), clone any to be kept.
+     */
+    class DllExport RSGISOGRChunkReader
+    {
+    public:
+        /**
+         * memBudget is the approximate number of bytes of geometry in a
+         * chunk, a chunk always has at least one feature and may go over the
+         * budget by the size of its last feature. maxChunkFeats limits the
+         * number of features in a chunk (0 for no limit).
+         */
+        RSGISOGRChunkReader(OGRLayer *layer, size_t memBudget=64*1024*1024, size_t maxChunkFeats=0);
+        /**
+         * An OGR SQL where clause, an empty string clears the filter.
+         */
+        void setAttributeFilter(std::string filter);
+        /**
+         * Only read features intersecting geom (NULL clears the filter).
+         */
+        void setSpatialFilter(OGRGeometry *geom);
+        void setSpatialFilterRect(double minX, double minY, double maxX, double maxY);
+        /**
+         * Start again from the first feature.
+         */
+        void reset();
+        /**
+         * The next chunk of the (non-empty) geometries of the layer and, if
+         * fids is not NULL, the FIDs of their features. False once all the
+         * features have been read.
+         */
+        bool nextChunk(std::vector<OGRGeometry*> *geoms, std::vector<long> *fids=NULL);
+        /**
+         * The next chunk of the layer as GEOS polygons, multi-polygons are
+         * split into their polygons. Throws on non-polygon geometries.
+         */
+        bool nextChunk(std::vector<geos::geom::Polygon*> *polys);
+        size_t getNumFeaturesRead() const {return numFeatsRead;};
+        ~RSGISOGRChunkReader();
+    protected:
+        void clearChunk();
+        bool readChunk();
+        OGRLayer *layer;
+        size_t memBudget;
+        size_t maxChunkFeats;
+        size_t numFeatsRead;
+        bool attFilterSet;
+        bool spatialFilterSet;
+        bool finished;
+        std::vector<OGRGeometry*> chunkGeoms;
+        std::vector<long> chunkFIDs;
+        std::vector<geos::geom::Polygon*> chunkPolys;
+        RSGISVectorUtils vecUtils;
+    };
+
+}}
+
+#endif
@@ -0,0 +1,235 @@
+/*
+ *  RSGISOGRLayerSpatialIndex.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2010 RSGISLib. All rights reserved.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISOGRLayerSpatialIndex.h"
+
+namespace rsgis{namespace vec{
+
+    static bool compareIndexedOGRGeoms(const RSGISIndexedOGRGeom *a, const RSGISIndexedOGRGeom *b)
+    {
+        return a->idx < b->idx;
+    }
+
+    RSGISOGRLayerSpatialIndex::RSGISOGRLayerSpatialIndex(bool prepareGeoms)
+    {
+        this->prepareGeoms = prepareGeoms && OGRHasPreparedGeometrySupport();
+        this->built = false;
+        this->geomIdx = new geos::index::strtree::STRtree();
+    }
+
+    RSGISOGRLayerSpatialIndex::RSGISOGRLayerSpatialIndex(OGRLayer *layer, bool prepareGeoms)
+    {
+        this->prepareGeoms = prepareGeoms && OGRHasPreparedGeometrySupport();
+        this->built = false;
+        this->geomIdx = new geos::index::strtree::STRtree();
+
+        if(layer == NULL)
+        {
+            throw RSGISVectorException("The layer to index is NULL.");
+        }
+
+        OGRFeature *feature = NULL;
+        layer->ResetReading();
+        while((feature = layer->GetNextFeature()) != NULL)
+        {
+            OGRGeometry *geometry = feature->GetGeometryRef();
+            if((geometry != NULL) && (!geometry->IsEmpty()))
+            {
+                this->addGeometry(geometry, feature->GetFID());
+            }
+            OGRFeature::DestroyFeature(feature);
+        }
+        layer->ResetReading();
+    }
+
+    void RSGISOGRLayerSpatialIndex::addGeometry(OGRGeometry *geom, long fid)
+    {
+        if(this->built)
+        {
+            throw RSGISVectorException("Geometries cannot be added to the spatial index once it has been queried.");
+        }
+        RSGISIndexedOGRGeom *idxGeom = new RSGISIndexedOGRGeom();
+        idxGeom->geom = geom->clone();
+        idxGeom->geom->getEnvelope(&idxGeom->env);
+        idxGeom->prepGeom = NULL;
+        if(this->prepareGeoms)
+        {
+            idxGeom->prepGeom = OGRCreatePreparedGeometry(idxGeom->geom);
+        }
+        idxGeom->fid = fid;
+        idxGeom->idx = this->geoms.size();
+
+        geos::geom::Envelope *env = new geos::geom::Envelope(idxGeom->env.MinX, idxGeom->env.MaxX, idxGeom->env.MinY, idxGeom->env.MaxY);
+        this->geoms.push_back(idxGeom);
+        this->geosEnvs.push_back(env);
+        this->geomIdx->insert(env, idxGeom);
+    }
+
+    void RSGISOGRLayerSpatialIndex::query(const OGREnvelope &env, std::vector<RSGISIndexedOGRGeom*> *results)
+    {
+        results->clear();
+        this->built = true;
+        if(this->geoms.empty())
+        {
+            return;
+        }
+
+        geos::geom::Envelope queryEnv(env.MinX, env.MaxX, env.MinY, env.MaxY);
+        std::vector<void*> geomResults;
+        this->geomIdx->query(&queryEnv, geomResults);
+
+        results->reserve(geomResults.size());
+        for(std::vector<void*>::iterator iterGeoms = geomResults.begin(); iterGeoms != geomResults.end(); ++iterGeoms)
+        {
+            results->push_back((RSGISIndexedOGRGeom*) (*iterGeoms));
+        }
+        std::sort(results->begin(), results->end(), compareIndexedOGRGeoms);
+    }
+
+    void RSGISOGRLayerSpatialIndex::queryIntersects(OGRGeometry *geom, std::vector<RSGISIndexedOGRGeom*> *results)
+    {
+        OGREnvelope env;
+        geom->getEnvelope(&env);
+        std::vector<RSGISIndexedOGRGeom*> candidates;
+        this->query(env, &candidates);
+
+        results->clear();
+        for(std::vector<RSGISIndexedOGRGeom*>::iterator iterGeoms = candidates.begin(); iterGeoms != candidates.end(); ++iterGeoms)
+        {
+            if(this->geomIntersects(*iterGeoms, geom))
+            {
+                results->push_back(*iterGeoms);
+            }
+        }
+    }
+
+    void RSGISOGRLayerSpatialIndex::queryContains(OGRGeometry *geom, std::vector<RSGISIndexedOGRGeom*> *results)
+    {
+        OGREnvelope env;
+        geom->getEnvelope(&env);
+        std::vector<RSGISIndexedOGRGeom*> candidates;
+        this->query(env, &candidates);
+
+        results->clear();
+        for(std::vector<RSGISIndexedOGRGeom*>::iterator iterGeoms = candidates.begin(); iterGeoms != candidates.end(); ++iterGeoms)
+        {
+            // A geometry can only contain geom if its envelope contains that of geom.
+            if(envelopeContains((*iterGeoms)->env, env) && this->geomContains(*iterGeoms, geom))
+            {
+                results->push_back(*iterGeoms);
+            }
+        }
+    }
+
+    bool RSGISOGRLayerSpatialIndex::anyContains(OGRGeometry *geom, long ignoreFID)
+    {
+        OGREnvelope env;
+        geom->getEnvelope(&env);
+        std::vector<RSGISIndexedOGRGeom*> candidates;
+        this->query(env, &candidates);
+
+        for(std::vector<RSGISIndexedOGRGeom*>::iterator iterGeoms = candidates.begin(); iterGeoms != candidates.end(); ++iterGeoms)
+        {
+            if(((*iterGeoms)->fid != ignoreFID) && envelopeContains((*iterGeoms)->env, env) && this->geomContains(*iterGeoms, geom))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void RSGISOGRLayerSpatialIndex::queryWithin(OGRGeometry *coverGeom, std::vector<RSGISIndexedOGRGeom*> *results)
+    {
+        OGREnvelope coverEnv;
+        coverGeom->getEnvelope(&coverEnv);
+        std::vector<RSGISIndexedOGRGeom*> candidates;
+        this->query(coverEnv, &candidates);
+
+        results->clear();
+        OGRPreparedGeometry *prepCover = NULL;
+        if(OGRHasPreparedGeometrySupport() && (candidates.size() > 1))
+        {
+            prepCover = OGRCreatePreparedGeometry(coverGeom);
+        }
+        for(std::vector<RSGISIndexedOGRGeom*>::iterator iterGeoms = candidates.begin(); iterGeoms != candidates.end(); ++iterGeoms)
+        {
+            if(envelopeContains(coverEnv, (*iterGeoms)->env))
+            {
+                bool within = false;
+                if(prepCover != NULL)
+                {
+                    within = OGRPreparedGeometryContains(prepCover, (*iterGeoms)->geom);
+                }
+                else
+                {
+                    within = coverGeom->Contains((*iterGeoms)->geom);
+                }
+                if(within)
+                {
+                    results->push_back(*iterGeoms);
+                }
+            }
+        }
+        if(prepCover != NULL)
+        {
+            OGRDestroyPreparedGeometry(prepCover);
+        }
+    }
+
+    bool RSGISOGRLayerSpatialIndex::geomContains(RSGISIndexedOGRGeom *idxGeom, OGRGeometry *geom)
+    {
+        if(idxGeom->prepGeom != NULL)
+        {
+            return OGRPreparedGeometryContains(idxGeom->prepGeom, geom);
+        }
+        return idxGeom->geom->Contains(geom);
+    }
+
+    bool RSGISOGRLayerSpatialIndex::geomIntersects(RSGISIndexedOGRGeom *idxGeom, OGRGeometry *geom)
+    {
+        if(idxGeom->prepGeom != NULL)
+        {
+            return OGRPreparedGeometryIntersects(idxGeom->prepGeom, geom);
+        }
+        return idxGeom->geom->Intersects(geom);
+    }
+
+    RSGISOGRLayerSpatialIndex::~RSGISOGRLayerSpatialIndex()
+    {
+        delete this->geomIdx;
+        for(std::vector<RSGISIndexedOGRGeom*>::iterator iterGeoms = this->geoms.begin(); iterGeoms != this->geoms.end(); ++iterGeoms)
+        {
+            if((*iterGeoms)->prepGeom != NULL)
+            {
+                OGRDestroyPreparedGeometry((*iterGeoms)->prepGeom);
+            }
+            delete (*iterGeoms)->geom;
+            delete *iterGeoms;
+        }
+        for(std::vector<geos::geom::Envelope*>::iterator iterEnvs = this->geosEnvs.begin(); iterEnvs != this->geosEnvs.end(); ++iterEnvs)
+        {
+            delete *iterEnvs;
+        }
+    }
+
+}}
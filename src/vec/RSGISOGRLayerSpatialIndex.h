@@ -0,0 +1,129 @@
+/*
+ *  RSGISOGRLayerSpatialIndex.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2010 RSGISLib. All rights reserved.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISOGRLayerSpatialIndex_H
+#define RSGISOGRLayerSpatialIndex_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "ogrsf_frmts.h"
+
+#include "geos/geom/Envelope.h"
+#include "geos/index/strtree/STRtree.h"
+
+#include "common/RSGISVectorException.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_vec_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace vec{
+
+    /**
+     * A geometry held in a RSGISOGRLayerSpatialIndex, prepGeom is NULL if
+     * the geometries were not prepared.
+     */
+    struct DllExport RSGISIndexedOGRGeom
+    {
+        OGRGeometry *geom;
+        OGRPreparedGeometry *prepGeom;
+        OGREnvelope env;
+        long fid;
+        size_t idx;
+    };
+
+    /**
+     * An in memory STRtree of the geometries of a layer (or a list of
+     * geometries) so a geometry can be tested against only those geometries
+     * whose envelopes it overlaps rather than every feature of the layer.
+     *
+     * The geometries are cloned, so the layer can be closed while the index
+     * is in use. With prepareGeoms each is also prepared (where GDAL was
+     * built with GEOS support for it) so repeated contains and intersects
+     * tests against the same indexed geometry are cheaper.
+     */
+    class DllExport RSGISOGRLayerSpatialIndex
+    {
+    public:
+        RSGISOGRLayerSpatialIndex(bool prepareGeoms=true);
+        /**
+         * Index all the features of the layer with a geometry.
+         */
+        RSGISOGRLayerSpatialIndex(OGRLayer *layer, bool prepareGeoms=true);
+        /**
+         * Add (a clone of) a geometry to the index, must be called before the first query.
+         */
+        void addGeometry(OGRGeometry *geom, long fid);
+        size_t size() const {return geoms.size();};
+        RSGISIndexedOGRGeom* getGeometry(size_t idx) const {return geoms.at(idx);};
+        /**
+         * The indexed geometries whose envelope intersects env, in the order they were added.
+         */
+        void query(const OGREnvelope &env, std::vector<RSGISIndexedOGRGeom*> *results);
+        /**
+         * The indexed geometries which intersect geom.
+         */
+        void queryIntersects(OGRGeometry *geom, std::vector<RSGISIndexedOGRGeom*> *results);
+        /**
+         * The indexed geometries which contain geom.
+         */
+        void queryContains(OGRGeometry *geom, std::vector<RSGISIndexedOGRGeom*> *results);
+        /**
+         * Whether any indexed geometry, other than the one with ignoreFID, contains geom.
+         */
+        bool anyContains(OGRGeometry *geom, long ignoreFID=-1);
+        /**
+         * The indexed geometries within coverGeom, coverGeom is prepared
+         * once so it is efficient on a large cover geometry.
+         */
+        void queryWithin(OGRGeometry *coverGeom, std::vector<RSGISIndexedOGRGeom*> *results);
+        static bool envelopeContains(const OGREnvelope &envA, const OGREnvelope &envB)
+        {
+            return (envA.MinX <= envB.MinX) && (envA.MaxX >= envB.MaxX) && (envA.MinY <= envB.MinY) && (envA.MaxY >= envB.MaxY);
+        };
+        ~RSGISOGRLayerSpatialIndex();
+    protected:
+        bool geomContains(RSGISIndexedOGRGeom *idxGeom, OGRGeometry *geom);
+        bool geomIntersects(RSGISIndexedOGRGeom *idxGeom, OGRGeometry *geom);
+        bool prepareGeoms;
+        bool built;
+        std::vector<RSGISIndexedOGRGeom*> geoms;
+        std::vector<geos::geom::Envelope*> geosEnvs;
+        geos::index::strtree::STRtree *geomIdx;
+    };
+
+}}
+
+#endif
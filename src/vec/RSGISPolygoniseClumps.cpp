@@ -0,0 +1,491 @@
+/*
+ *  RSGISPolygoniseClumps.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2010 RSGISLib. All rights reserved.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RSGISPolygoniseClumps.h"
+
+namespace rsgis{namespace vec{
+
+    RSGISPolygoniseClumps::RSGISPolygoniseClumps()
+    {
+        this->useNoData = false;
+        this->noDataVal = 0;
+        this->writer = NULL;
+        this->valFieldIdx = -1;
+        this->numPolysWritten = 0;
+        for(int i = 0; i < 6; ++i)
+        {
+            this->transform[i] = 0.0;
+        }
+    }
+
+    void RSGISPolygoniseClumps::setNoDataValue(bool useNoData, uint32_t noDataVal)
+    {
+        this->useNoData = useNoData;
+        this->noDataVal = noDataVal;
+    }
+
+    unsigned long RSGISPolygoniseClumps::polygonise(GDALDataset *clumpsImage, unsigned int band, OGRLayer *outLayer, std::string valFieldName)
+    {
+        if((band == 0) || (band > ((unsigned int)clumpsImage->GetRasterCount())))
+        {
+            throw RSGISVectorException("The clumps image band is not within the image.");
+        }
+        GDALRasterBand *clumpsBand = clumpsImage->GetRasterBand(band);
+        clumpsImage->GetGeoTransform(this->transform);
+
+        OGRFeatureDefn *outFeatureDefn = outLayer->GetLayerDefn();
+        this->valFieldIdx = outFeatureDefn->GetFieldIndex(valFieldName.c_str());
+        if(this->valFieldIdx < 0)
+        {
+            OGRFieldDefn valField(valFieldName.c_str(), OFTInteger64);
+            if(outLayer->CreateField(&valField) != OGRERR_NONE)
+            {
+                std::string message = std::string("Creating ") + valFieldName + std::string(" field has failed.");
+                throw RSGISVectorOutputException(message.c_str());
+            }
+            this->valFieldIdx = outLayer->GetLayerDefn()->GetFieldIndex(valFieldName.c_str());
+        }
+
+        long width = clumpsBand->GetXSize();
+        long height = clumpsBand->GetYSize();
+
+        int xBlockSize = 0;
+        int yBlockSize = 0;
+        clumpsBand->GetBlockSize(&xBlockSize, &yBlockSize);
+        long numBlockRows = std::max<long>(yBlockSize, 64);
+
+        std::vector<uint32_t> blockData(width * numBlockRows);
+        // -1 represents no data and the area outside of the image.
+        std::vector<long> prevRow(width, -1);
+        std::vector<long> curRow(width, -1);
+        std::vector<long> prevRowVals;
+        std::vector<long> curRowVals;
+
+        this->numPolysWritten = 0;
+        this->activeClumps.clear();
+        // The writer and the clumps are freed however the loop is left.
+        std::unique_ptr<RSGISOGRBatchWriter> batchWriter(new RSGISOGRBatchWriter(outLayer, 20000));
+        this->writer = batchWriter.get();
+        {
+            rsgis_tqdm pbar;
+            long blockStart = 0;
+            long blockRows = 0;
+            for(long y = 0; y <= height; ++y)
+            {
+                pbar.progress(y, height+1);
+                if(y < height)
+                {
+                    if(y >= (blockStart + blockRows))
+                    {
+                        blockStart = y;
+                        blockRows = std::min<long>(numBlockRows, height - y);
+                        if(clumpsBand->RasterIO(GF_Read, 0, blockStart, width, blockRows, blockData.data(), width, blockRows, GDT_UInt32, 0, 0) != CE_None)
+                        {
+                            throw RSGISVectorException("Could not read the clumps image.");
+                        }
+                    }
+                    uint32_t *rowData = blockData.data() + ((y - blockStart) * width);
+                    for(long x = 0; x < width; ++x)
+                    {
+                        if(this->useNoData && (rowData[x] == this->noDataVal))
+                        {
+                            curRow[x] = -1;
+                        }
+                        else
+                        {
+                            curRow[x] = rowData[x];
+                        }
+                    }
+                }
+                else
+                {
+                    std::fill(curRow.begin(), curRow.end(), -1);
+                }
+
+                this->addRowCracks(prevRow, curRow, y, (y < height), &curRowVals);
+
+                // Clumps in the row above but not this row are complete.
+                for(std::vector<long>::iterator iterVals = prevRowVals.begin(); iterVals != prevRowVals.end(); ++iterVals)
+                {
+                    std::unordered_map<long, std::unique_ptr<RSGISClumpCracks> >::iterator iterClump = this->activeClumps.find(*iterVals);
+                    if((iterClump != this->activeClumps.end()) && (iterClump->second->lastRow < y))
+                    {
+                        this->writeClump(iterClump->first, iterClump->second.get());
+                        this->activeClumps.erase(iterClump);
+                    }
+                }
+
+                prevRow.swap(curRow);
+                prevRowVals.swap(curRowVals);
+            }
+            pbar.finish();
+
+            for(std::unordered_map<long, std::unique_ptr<RSGISClumpCracks> >::iterator iterClump = this->activeClumps.begin(); iterClump != this->activeClumps.end(); ++iterClump)
+            {
+                this->writeClump(iterClump->first, iterClump->second.get());
+            }
+            this->activeClumps.clear();
+
+            this->writer->finish();
+        }
+        this->writer = NULL;
+
+        return this->numPolysWritten;
+    }
+
+    void RSGISPolygoniseClumps::addRowCracks(const std::vector<long> &prevRow, const std::vector<long> &curRow, long y, bool inImage, std::vector<long> *curRowVals)
+    {
+        long width = curRow.size();
+
+        // Horizontal cracks between this row and the row above, with the clump on the right of the edge direction.
+        for(long x = 0; x < width; ++x)
+        {
+            long aboveVal = prevRow[x];
+            long belowVal = curRow[x];
+            if(aboveVal != belowVal)
+            {
+                if(belowVal >= 0)
+                {
+                    this->addHorizontalEdge(this->getClump(belowVal, y), x, x+1, y);
+                }
+                if(aboveVal >= 0)
+                {
+                    this->addHorizontalEdge(this->getClump(aboveVal, y-1), x+1, x, y);
+                }
+            }
+        }
+
+        // Vertical cracks within this row.
+        curRowVals->clear();
+        if(inImage)
+        {
+            for(long x = 0; x <= width; ++x)
+            {
+                long leftVal = (x > 0)?curRow[x-1]:-1;
+                long rightVal = (x < width)?curRow[x]:-1;
+                if(leftVal != rightVal)
+                {
+                    if(rightVal >= 0)
+                    {
+                        RSGISClumpCracks *clump = this->getClump(rightVal, y);
+                        clump->lastRow = y;
+                        clump->edges.push_back({x, y+1, x, y});
+                        curRowVals->push_back(rightVal);
+                    }
+                    if(leftVal >= 0)
+                    {
+                        this->getClump(leftVal, y)->edges.push_back({x, y, x, y+1});
+                    }
+                }
+            }
+        }
+    }
+
+    RSGISPolygoniseClumps::RSGISClumpCracks* RSGISPolygoniseClumps::getClump(long clumpVal, long row)
+    {
+        std::unordered_map<long, std::unique_ptr<RSGISClumpCracks> >::iterator iterClump = this->activeClumps.find(clumpVal);
+        if(iterClump != this->activeClumps.end())
+        {
+            return iterClump->second.get();
+        }
+        RSGISClumpCracks *clump = new RSGISClumpCracks();
+        clump->lastRow = row;
+        this->activeClumps[clumpVal].reset(clump);
+        return clump;
+    }
+
+    void RSGISPolygoniseClumps::addHorizontalEdge(RSGISClumpCracks *clump, long x0, long x1, long y)
+    {
+        // Extend the last edge where it is the preceding crack along the same run.
+        if(!clump->edges.empty())
+        {
+            RSGISCrackEdge &lastEdge = clump->edges.back();
+            if((lastEdge.y0 == y) && (lastEdge.y1 == y))
+            {
+                if((x1 > x0) && (lastEdge.x1 > lastEdge.x0) && (lastEdge.x1 == x0))
+                {
+                    lastEdge.x1 = x1;
+                    return;
+                }
+                else if((x1 < x0) && (lastEdge.x1 < lastEdge.x0) && (lastEdge.x0 == x1))
+                {
+                    lastEdge.x0 = x0;
+                    return;
+                }
+            }
+        }
+        clump->edges.push_back({x0, y, x1, y});
+    }
+
+    static inline long edgeDirX(const long x0, const long x1)
+    {
+        return (x1 > x0)?1:((x1 < x0)?-1:0);
+    }
+
+    void RSGISPolygoniseClumps::traceRings(std::vector<RSGISCrackEdge> *edges, std::vector<std::vector<long> > *rings)
+    {
+        size_t numEdges = edges->size();
+        std::vector<size_t> order(numEdges);
+        for(size_t i = 0; i < numEdges; ++i)
+        {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [edges](size_t a, size_t b){
+            if((*edges)[a].y0 != (*edges)[b].y0)
+            {
+                return (*edges)[a].y0 < (*edges)[b].y0;
+            }
+            return (*edges)[a].x0 < (*edges)[b].x0;
+        });
+
+        std::vector<bool> used(numEdges, false);
+        for(size_t k = 0; k < numEdges; ++k)
+        {
+            size_t first = order[k];
+            if(used[first])
+            {
+                continue;
+            }
+
+            std::vector<long> ring;
+            const RSGISCrackEdge &firstEdge = (*edges)[first];
+            long firstDX = edgeDirX(firstEdge.x0, firstEdge.x1);
+            long firstDY = edgeDirX(firstEdge.y0, firstEdge.y1);
+            ring.push_back(firstEdge.x0);
+            ring.push_back(firstEdge.y0);
+            used[first] = true;
+
+            size_t cur = first;
+            while(true)
+            {
+                const RSGISCrackEdge &curEdge = (*edges)[cur];
+                long curDX = edgeDirX(curEdge.x0, curEdge.x1);
+                long curDY = edgeDirX(curEdge.y0, curEdge.y1);
+                long endX = curEdge.x1;
+                long endY = curEdge.y1;
+
+                // The edges starting at the end of the current edge.
+                size_t lower = 0;
+                size_t upper = numEdges;
+                while(lower < upper)
+                {
+                    size_t mid = (lower + upper) / 2;
+                    const RSGISCrackEdge &midEdge = (*edges)[order[mid]];
+                    if((midEdge.y0 < endY) || ((midEdge.y0 == endY) && (midEdge.x0 < endX)))
+                    {
+                        lower = mid + 1;
+                    }
+                    else
+                    {
+                        upper = mid;
+                    }
+                }
+
+                // Where a clump touches itself at a corner there are two edges
+                // to follow, turning right (towards the clump) keeps the rings apart.
+                size_t next = numEdges;
+                int nextRank = 4;
+                for(size_t m = lower; m < numEdges; ++m)
+                {
+                    size_t candidate = order[m];
+                    const RSGISCrackEdge &candEdge = (*edges)[candidate];
+                    if((candEdge.y0 != endY) || (candEdge.x0 != endX))
+                    {
+                        break;
+                    }
+                    if(used[candidate] && (candidate != first))
+                    {
+                        continue;
+                    }
+                    long candDX = edgeDirX(candEdge.x0, candEdge.x1);
+                    long candDY = edgeDirX(candEdge.y0, candEdge.y1);
+                    int rank = 3;
+                    if((candDX == -curDY) && (candDY == curDX))
+                    {
+                        rank = 0;
+                    }
+                    else if((candDX == curDX) && (candDY == curDY))
+                    {
+                        rank = 1;
+                    }
+                    else if((candDX == curDY) && (candDY == -curDX))
+                    {
+                        rank = 2;
+                    }
+                    if(rank < nextRank)
+                    {
+                        next = candidate;
+                        nextRank = rank;
+                    }
+                }
+
+                if(next == numEdges)
+                {
+                    throw RSGISVectorException("Could not close a ring while tracing the boundary of a clump.");
+                }
+                else if(next == first)
+                {
+                    // The start is not a corner if the ring continues straight through it.
+                    if((firstDX == curDX) && (firstDY == curDY))
+                    {
+                        ring.erase(ring.begin(), ring.begin()+2);
+                    }
+                    break;
+                }
+
+                const RSGISCrackEdge &nextEdge = (*edges)[next];
+                if((edgeDirX(nextEdge.x0, nextEdge.x1) != curDX) || (edgeDirX(nextEdge.y0, nextEdge.y1) != curDY))
+                {
+                    ring.push_back(endX);
+                    ring.push_back(endY);
+                }
+                used[next] = true;
+                cur = next;
+            }
+            rings->push_back(ring);
+        }
+    }
+
+    double RSGISPolygoniseClumps::ringArea(const std::vector<long> &ring)
+    {
+        size_t numPts = ring.size()/2;
+        double area = 0.0;
+        for(size_t i = 0; i < numPts; ++i)
+        {
+            size_t j = (i + 1) % numPts;
+            area += (((double)ring[i*2]) * ((double)ring[(j*2)+1])) - (((double)ring[j*2]) * ((double)ring[(i*2)+1]));
+        }
+        return area / 2.0;
+    }
+
+    bool RSGISPolygoniseClumps::ringContains(const std::vector<long> &ring, double x, double y)
+    {
+        size_t numPts = ring.size()/2;
+        bool inside = false;
+        for(size_t i = 0, j = numPts-1; i < numPts; j = i++)
+        {
+            double xi = ring[i*2];
+            double yi = ring[(i*2)+1];
+            double xj = ring[j*2];
+            double yj = ring[(j*2)+1];
+            if(((yi > y) != (yj > y)) && (x < (((xj - xi) * (y - yi)) / (yj - yi)) + xi))
+            {
+                inside = !inside;
+            }
+        }
+        return inside;
+    }
+
+    OGRLinearRing* RSGISPolygoniseClumps::createOGRRing(const std::vector<long> &ring)
+    {
+        OGRLinearRing *ogrRing = new OGRLinearRing();
+        size_t numPts = ring.size()/2;
+        ogrRing->setNumPoints(numPts+1);
+        for(size_t i = 0; i <= numPts; ++i)
+        {
+            size_t idx = (i % numPts) * 2;
+            double x = this->transform[0] + (ring[idx] * this->transform[1]) + (ring[idx+1] * this->transform[2]);
+            double y = this->transform[3] + (ring[idx] * this->transform[4]) + (ring[idx+1] * this->transform[5]);
+            ogrRing->setPoint(i, x, y);
+        }
+        return ogrRing;
+    }
+
+    void RSGISPolygoniseClumps::writeClump(long clumpVal, RSGISClumpCracks *clump)
+    {
+        std::vector<std::vector<long> > rings;
+        this->traceRings(&clump->edges, &rings);
+        std::vector<RSGISCrackEdge>().swap(clump->edges);
+
+        // With the clump on the right of the edges outer rings have a positive area (in pixel coordinates) and holes negative.
+        std::vector<size_t> outerRings;
+        std::vector<double> outerAreas;
+        std::vector<size_t> holes;
+        for(size_t i = 0; i < rings.size(); ++i)
+        {
+            double area = this->ringArea(rings.at(i));
+            if(area > 0)
+            {
+                outerRings.push_back(i);
+                outerAreas.push_back(area);
+            }
+            else
+            {
+                holes.push_back(i);
+            }
+        }
+        if(outerRings.empty())
+        {
+            return;
+        }
+
+        // The polygons are added to the multi-polygon as they are created so it owns them if anything throws.
+        std::unique_ptr<OGRMultiPolygon> mPoly(new OGRMultiPolygon());
+        std::vector<OGRPolygon*> polys;
+        for(std::vector<size_t>::iterator iterRings = outerRings.begin(); iterRings != outerRings.end(); ++iterRings)
+        {
+            OGRPolygon *poly = new OGRPolygon();
+            mPoly->addGeometryDirectly(poly);
+            poly->addRingDirectly(this->createOGRRing(rings.at(*iterRings)));
+            polys.push_back(poly);
+        }
+
+        for(std::vector<size_t>::iterator iterHoles = holes.begin(); iterHoles != holes.end(); ++iterHoles)
+        {
+            const std::vector<long> &hole = rings.at(*iterHoles);
+            size_t outerIdx = 0;
+            if(outerRings.size() > 1)
+            {
+                // A point just inside the hole, the (non clump) left of its first edge.
+                long dx = edgeDirX(hole[0], hole[2]);
+                long dy = edgeDirX(hole[1], hole[3]);
+                double ptX = hole[0] + (0.5 * dx) + (0.25 * dy);
+                double ptY = hole[1] + (0.5 * dy) - (0.25 * dx);
+                double minArea = 0.0;
+                bool found = false;
+                for(size_t i = 0; i < outerRings.size(); ++i)
+                {
+                    if(this->ringContains(rings.at(outerRings.at(i)), ptX, ptY) && ((!found) || (outerAreas.at(i) < minArea)))
+                    {
+                        outerIdx = i;
+                        minArea = outerAreas.at(i);
+                        found = true;
+                    }
+                }
+            }
+            polys.at(outerIdx)->addRingDirectly(this->createOGRRing(hole));
+        }
+
+        OGRFeature *outFeature = this->writer->getFeature();
+        outFeature->SetGeometryDirectly(mPoly.release());
+        outFeature->SetField(this->valFieldIdx, (GIntBig)clumpVal);
+        this->writer->writeFeature(outFeature);
+        ++this->numPolysWritten;
+    }
+
+    RSGISPolygoniseClumps::~RSGISPolygoniseClumps()
+    {
+
+    }
+
+}}
@@ -0,0 +1,129 @@
+/*
+ *  RSGISPolygoniseClumps.h
+ *  RSGIS_LIB
+ *
+ *  Copyright 2010 RSGISLib. All rights reserved.
+ *
+ * This file is part of RSGISLib.
+ *
+ * RSGISLib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RSGISLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSGISPolygoniseClumps_H
+#define RSGISPolygoniseClumps_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <memory>
+#include <stdint.h>
+
+#include "gdal_priv.h"
+#include "ogrsf_frmts.h"
+
+#include "common/RSGISVectorException.h"
+#include "common/rsgis-tqdm.h"
+
+#include "vec/RSGISVectorOutputException.h"
+#include "vec/RSGISOGRBatchWriter.h"
+
+// mark all exported classes/functions with DllExport to have
+// them exported by Visual Studio
+#undef DllExport
+#ifdef _MSC_VER
+    #ifdef rsgis_vec_EXPORTS
+        #define DllExport   __declspec( dllexport )
+    #else
+        #define DllExport   __declspec( dllimport )
+    #endif
+#else
+    #define DllExport
+#endif
+
+namespace rsgis{namespace vec{
+
+    /**
+     * Polygonises a clumps (or any integer valued) image by tracing the
+     * cracks between pixels of differing values, rather than creating and
+     * unioning a polygon for every pixel.
+     *
+     * The image is read in strips of rows and each row is compared with the
+     * row above, so the edges of a clump are collected as the rows are read
+     * and its polygon is built and written (through RSGISOGRBatchWriter) as
+     * soon as the row after its last row has been read; only the clumps
+     * crossing the current row are held in memory.
+     *
+     * The vertices are on the pixel corners, so neighbouring polygons have
+     * exactly the same vertices along their shared boundary (no gaps or
+     * overlaps). Pixels of a value touching only at a corner are given
+     * separate rings (4-connectivity). As a value may have more than one
+     * outer ring (e.g. a class image) every geometry is written as a
+     * multi-polygon, so the layer should be created as wkbMultiPolygon.
+     */
+    class DllExport RSGISPolygoniseClumps
+    {
+    public:
+        RSGISPolygoniseClumps();
+        /**
+         * Pixels with this value (e.g. 0 for a clumps image) are not polygonised.
+         */
+        void setNoDataValue(bool useNoData, uint32_t noDataVal);
+        /**
+         * Write a polygon for each clump of the band to outLayer, with the
+         * clump value in the (Integer64) field valFieldName, which is created
+         * if the layer does not have it. Returns the number of polygons written.
+         */
+        unsigned long polygonise(GDALDataset *clumpsImage, unsigned int band, OGRLayer *outLayer, std::string valFieldName);
+        ~RSGISPolygoniseClumps();
+    protected:
+        struct RSGISCrackEdge
+        {
+            long x0;
+            long y0;
+            long x1;
+            long y1;
+        };
+        struct RSGISClumpCracks
+        {
+            long lastRow;
+            std::vector<RSGISCrackEdge> edges;
+        };
+        /**
+         * Add the cracks between curRow (row y, all -1 below the image) and the
+         * row above to the clumps, recording the values in curRow.
+         */
+        void addRowCracks(const std::vector<long> &prevRow, const std::vector<long> &curRow, long y, bool inImage, std::vector<long> *curRowVals);
+        RSGISClumpCracks* getClump(long clumpVal, long row);
+        void addHorizontalEdge(RSGISClumpCracks *clump, long x0, long x1, long y);
+        void writeClump(long clumpVal, RSGISClumpCracks *clump);
+        void traceRings(std::vector<RSGISCrackEdge> *edges, std::vector<std::vector<long> > *rings);
+        double ringArea(const std::vector<long> &ring);
+        bool ringContains(const std::vector<long> &ring, double x, double y);
+        OGRLinearRing* createOGRRing(const std::vector<long> &ring);
+        bool useNoData;
+        uint32_t noDataVal;
+        double transform[6];
+        std::unordered_map<long, std::unique_ptr<RSGISClumpCracks> > activeClumps;
+        /** The writer of the current polygonise call (owned by that call). */
+        RSGISOGRBatchWriter *writer;
+        int valFieldIdx;
+        unsigned long numPolysWritten;
+    };
+
+}}
+
+#endif
@@ -29,19 +29,22 @@ namespace rsgis{namespace vec{
 	RSGISProcessGeometry::RSGISProcessGeometry(RSGISProcessOGRGeometry *processGeom)
 	{
 		this->processGeom = processGeom;
+		this->numThreads = rsgis::utils::getNumThreads();
+	}
+	
+	void RSGISProcessGeometry::setNumThreads(unsigned int numThreads)
+	{
+		this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
 	}
 	
 	void RSGISProcessGeometry::processGeometry(OGRLayer *inputLayer, OGRLayer *outputLayer, bool copyData, bool outVertical)
 	{
-		OGRGeometry *geometry = NULL;
-		
-		OGRFeature *inFeature = NULL;
 		OGRFeature *outFeature = NULL;
 		
 		OGRFeatureDefn *inFeatureDefn = NULL;
 		OGRFeatureDefn *outFeatureDefn = NULL;
 		
-		long fid = 0;
+		std::vector<OGRFeature*> inFeats;
 		
 		try
 		{
@@ -69,122 +72,105 @@ namespace rsgis{namespace vec{
 				std::cout << "Started " << std::flush;
 			}
 
-            unsigned int transactionStep = 20000;
-            unsigned int nextTransaction = transactionStep;
-            bool openTransaction = false;
+            RSGISOGRBatchWriter outWriter(outputLayer, 20000);
+            rsgis::utils::RSGISWorkerPool pool(this->processGeom->isThreadSafe()?this->numThreads:1);
 
 			inputLayer->ResetReading();
-			while( (inFeature = inputLayer->GetNextFeature()) != NULL )
+			this->readBatch(inputLayer, &inFeats);
+			while(!inFeats.empty())
 			{
-				if((numFeatures > 10) && (i == nextFeedback))
+				// The geometries are edited in place, so are written from the input features.
+				processBatch(inFeats.size(), pool, [&](size_t idx)
 				{
-					if(outVertical)
+					OGRGeometry *geometry = inFeats[idx]->GetGeometryRef();
+					if( geometry != NULL && wkbFlatten(geometry->getGeometryType()) == wkbPolygon )
+					{
+						processGeom->processGeometry((OGRPolygon *) geometry);
+					} 
+					else if( geometry != NULL && wkbFlatten(geometry->getGeometryType()) == wkbMultiPolygon )
 					{
-						std::cout << feedbackCounter << "% Done" << std::endl;
+						processGeom->processGeometry((OGRMultiPolygon *) geometry);
+					}
+					else if( geometry != NULL && wkbFlatten(geometry->getGeometryType()) == wkbPoint )
+					{
+						processGeom->processGeometry((OGRPoint *) geometry);
+					}	
+					else if( geometry != NULL && wkbFlatten(geometry->getGeometryType()) == wkbLineString )
+					{
+						processGeom->processGeometry((OGRLineString *) geometry);
 					}
 					else
 					{
-						std::cout << "." << feedbackCounter << "." << std::flush;
+						throw RSGISVectorException("Unsupport data type.");
 					}
-					
-					feedbackCounter = feedbackCounter + 10;
-                    nextFeedback = nextFeedback + feedback;
-				}
-
-                if(!openTransaction)
-                {
-                    outputLayer->StartTransaction();
-                    openTransaction = true;
-                }
-
-				fid = inFeature->GetFID();
-				
-				outFeature = OGRFeature::CreateFeature(outFeatureDefn);
-				
-				// Get Geometry.
-				geometry = inFeature->GetGeometryRef();
-				if( geometry != NULL && wkbFlatten(geometry->getGeometryType()) == wkbPolygon )
-				{
-					OGRPolygon *polygon = (OGRPolygon *) geometry;
-					processGeom->processGeometry(polygon);
-					outFeature->SetGeometry(polygon);
-				} 
-				else if( geometry != NULL && wkbFlatten(geometry->getGeometryType()) == wkbMultiPolygon )
-				{
-					OGRMultiPolygon *multiPolygon = (OGRMultiPolygon *) geometry;
-					processGeom->processGeometry(multiPolygon);
-					outFeature->SetGeometry(multiPolygon);
-				}
-				else if( geometry != NULL && wkbFlatten(geometry->getGeometryType()) == wkbPoint )
-				{
-					OGRPoint *point = (OGRPoint *) geometry;
-					processGeom->processGeometry(point);
-					outFeature->SetGeometry(point);
-				}	
-				else if( geometry != NULL && wkbFlatten(geometry->getGeometryType()) == wkbLineString )
-				{
-					OGRLineString *line = (OGRLineString *) geometry;
-					processGeom->processGeometry(line);
-					outFeature->SetGeometry(line);
-				}
-				else
-				{
-					throw RSGISVectorException("Unsupport data type.");
-				}
-												
-				outFeature->SetFID(fid);
-				
-				if(copyData)
-				{
-					this->copyFeatureData(inFeature, outFeature, inFeatureDefn, outFeatureDefn);
-				}
+				});
 				
-				if( outputLayer->CreateFeature(outFeature) != OGRERR_NONE )
+				for(size_t idx = 0; idx < inFeats.size(); ++idx)
 				{
-					throw RSGISVectorOutputException("Failed to write feature to the output shapefile.");
+					if((numFeatures > 10) && (i == nextFeedback))
+					{
+						if(outVertical)
+						{
+							std::cout << feedbackCounter << "% Done" << std::endl;
+						}
+						else
+						{
+							std::cout << "." << feedbackCounter << "." << std::flush;
+						}
+						
+						feedbackCounter = feedbackCounter + 10;
+						nextFeedback = nextFeedback + feedback;
+					}
+					
+					outFeature = outWriter.getFeature();
+					outFeature->SetGeometry(inFeats[idx]->GetGeometryRef());
+					outFeature->SetFID(inFeats[idx]->GetFID());
+					
+					if(copyData)
+					{
+						this->copyFeatureData(inFeats[idx], outFeature, inFeatureDefn, outFeatureDefn);
+					}
+					
+					outWriter.writeFeature(outFeature);
+					
+					OGRFeature::DestroyFeature(inFeats[idx]);
+					inFeats[idx] = NULL;
+					i++;
 				}
-
-                if(openTransaction && (i == nextTransaction))
-                {
-                    outputLayer->CommitTransaction();
-                    openTransaction = false;
-                    nextTransaction = nextTransaction + transactionStep;
-                }
-				
-				OGRFeature::DestroyFeature(inFeature);
-				OGRFeature::DestroyFeature(outFeature);
-				i++;
+				this->readBatch(inputLayer, &inFeats);
 			}
 
-            if(openTransaction)
-            {
-                outputLayer->CommitTransaction();
-                openTransaction = false;
-            }
+            outWriter.finish();
 			std::cout << " Complete.\n";
 			
 		}
 		catch(RSGISVectorOutputException& e)
 		{
+			for(std::vector<OGRFeature*>::iterator iterFeat = inFeats.begin(); iterFeat != inFeats.end(); ++iterFeat)
+			{
+				OGRFeature::DestroyFeature(*iterFeat);
+			}
 			throw e;
 		}
 		catch(RSGISVectorException& e)
 		{
+			for(std::vector<OGRFeature*>::iterator iterFeat = inFeats.begin(); iterFeat != inFeats.end(); ++iterFeat)
+			{
+				OGRFeature::DestroyFeature(*iterFeat);
+			}
 			throw RSGISVectorException(std::string(e.what()).c_str());
 		}
 	}
 	
 	void RSGISProcessGeometry::processGeometryPolygonOutput(OGRLayer *inputLayer, OGRLayer *outputLayer, bool copyData, bool outVertical)
 	{
-		OGRGeometry *geometry = NULL;
-		
-		OGRFeature *inFeature = NULL;
 		OGRFeature *outFeature = NULL;
 		
 		OGRFeatureDefn *inFeatureDefn = NULL;
 		OGRFeatureDefn *outFeatureDefn = NULL;
 		
-		long fid = 0;
+		std::vector<OGRFeature*> inFeats;
+		std::vector<OGRPolygon*> outPolys;
 		
 		try
 		{
@@ -212,91 +198,110 @@ namespace rsgis{namespace vec{
 				std::cout << "Started " << std::flush;
 			}
 
-            unsigned int transactionStep = 20000;
-            unsigned int nextTransaction = transactionStep;
-            bool openTransaction = false;
+            RSGISOGRBatchWriter outWriter(outputLayer, 20000);
+            rsgis::utils::RSGISWorkerPool pool(this->processGeom->isThreadSafe()?this->numThreads:1);
 			
 			inputLayer->ResetReading();
-			while( (inFeature = inputLayer->GetNextFeature()) != NULL )
+			this->readBatch(inputLayer, &inFeats);
+			while(!inFeats.empty())
 			{
-				if((numFeatures > 10) && (i == nextFeedback))
+				outPolys.assign(inFeats.size(), NULL);
+				processBatch(inFeats.size(), pool, [&](size_t idx)
 				{
-					if(outVertical)
+					OGRGeometry *geometry = inFeats[idx]->GetGeometryRef();
+					if( geometry != NULL)
 					{
-						std::cout << feedbackCounter << "% Done" << std::endl;
-					}
+						outPolys[idx] = processGeom->processGeometry(geometry);
+					} 
 					else
 					{
-						std::cout << "." << feedbackCounter << "." << std::flush;
+						throw RSGISVectorException("Unsupport data type.");
 					}
-				 
-					feedbackCounter = feedbackCounter + 10;
-                    nextFeedback = nextFeedback + feedback;
-				}
-
-                if(!openTransaction)
-                {
-                    outputLayer->StartTransaction();
-                    openTransaction = true;
-                }
+				});
 				
-				fid = inFeature->GetFID();
-				
-				outFeature = OGRFeature::CreateFeature(outFeatureDefn);
-				
-				// Get Geometry.
-				geometry = inFeature->GetGeometryRef();
-				if( geometry != NULL)
-				{
-					OGRPolygon *polygon = processGeom->processGeometry(geometry);					
-					outFeature->SetGeometry(polygon);
-				} 
-				else
+				for(size_t idx = 0; idx < inFeats.size(); ++idx)
 				{
-					throw RSGISVectorException("Unsupport data type.");
-				}
-				
-				outFeature->SetFID(fid);
-				
-				if(copyData)
-				{
-					this->copyFeatureData(inFeature, outFeature, inFeatureDefn, outFeatureDefn);
-				}
-				
-				if( outputLayer->CreateFeature(outFeature) != OGRERR_NONE )
-				{
-					throw RSGISVectorOutputException("Failed to write feature to the output shapefile.");
+					if((numFeatures > 10) && (i == nextFeedback))
+					{
+						if(outVertical)
+						{
+							std::cout << feedbackCounter << "% Done" << std::endl;
+						}
+						else
+						{
+							std::cout << "." << feedbackCounter << "." << std::flush;
+						}
+					 
+						feedbackCounter = feedbackCounter + 10;
+						nextFeedback = nextFeedback + feedback;
+					}
+					
+					outFeature = outWriter.getFeature();
+					outFeature->SetGeometryDirectly(outPolys[idx]);
+					outPolys[idx] = NULL;
+					outFeature->SetFID(inFeats[idx]->GetFID());
+					
+					if(copyData)
+					{
+						this->copyFeatureData(inFeats[idx], outFeature, inFeatureDefn, outFeatureDefn);
+					}
+					
+					outWriter.writeFeature(outFeature);
+					
+					OGRFeature::DestroyFeature(inFeats[idx]);
+					inFeats[idx] = NULL;
+					i++;
 				}
-
-                if(openTransaction && (i == nextTransaction))
-                {
-                    outputLayer->CommitTransaction();
-                    openTransaction = false;
-                    nextTransaction = nextTransaction + transactionStep;
-                }
-				
-				OGRFeature::DestroyFeature(inFeature);
-				OGRFeature::DestroyFeature(outFeature);
-				i++;
+				this->readBatch(inputLayer, &inFeats);
 			}
-            if(openTransaction)
-            {
-                outputLayer->CommitTransaction();
-                openTransaction = false;
-            }
+            outWriter.finish();
 			std::cout << " Complete.\n";
 			
 		}
 		catch(RSGISVectorOutputException& e)
 		{
+			for(size_t idx = 0; idx < inFeats.size(); ++idx)
+			{
+				OGRFeature::DestroyFeature(inFeats[idx]);
+				if(idx < outPolys.size())
+				{
+					delete outPolys[idx];
+				}
+			}
 			throw e;
 		}
 		catch(RSGISVectorException& e)
 		{
+			for(size_t idx = 0; idx < inFeats.size(); ++idx)
+			{
+				OGRFeature::DestroyFeature(inFeats[idx]);
+				if(idx < outPolys.size())
+				{
+					delete outPolys[idx];
+				}
+			}
 			throw RSGISVectorException(std::string(e.what()).c_str());
 		}
 	}
 	
+	void RSGISProcessGeometry::processBatch(size_t numFeats, rsgis::utils::RSGISWorkerPool &pool, std::function<void(size_t)> processFeat)
+	{
+		pool.parallelFor(numFeats, [&processFeat](size_t idx, unsigned int)
+		{
+			processFeat(idx);
+		});
+	}
+	
+	void RSGISProcessGeometry::readBatch(OGRLayer *inputLayer, std::vector<OGRFeature*> *inFeats)
+	{
+		inFeats->clear();
+		OGRFeature *inFeature = NULL;
+		while((inFeats->size() < featsPerBatch) && ((inFeature = inputLayer->GetNextFeature()) != NULL))
+		{
+			inFeats->push_back(inFeature);
+		}
+	}
+	
 	void RSGISProcessGeometry::copyFeatureDefn(OGRLayer *outputSHPLayer, OGRFeatureDefn *inFeatureDefn)
 	{
 		int fieldCount = inFeatureDefn->GetFieldCount();
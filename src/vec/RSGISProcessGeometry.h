@@ -28,17 +28,25 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <cstdlib>
 
 #include "ogrsf_frmts.h"
 
 #include "common/rsgis-tqdm.h"
 #include "common/RSGISVectorException.h"
+#include "common/RSGISParallel.h"
 
 #include "math/RSGISMathsUtils.h"
 
 #include "vec/RSGISVectorOutputException.h"
 #include "vec/RSGISProcessOGRGeometry.h"
 #include "vec/RSGISVectorUtils.h"
+#include "vec/RSGISOGRBatchWriter.h"
 
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
@@ -55,17 +63,41 @@
 
 namespace rsgis{namespace vec{
 	
+	/**
+	 * Applies a geometry operation to each feature of a layer. The features
+	 * are read in batches and, if the operation is thread safe, the
+	 * geometries of a batch are processed on several threads
+	 * (RSGISLIB_NUM_THREADS) before being written, in the order they were
+	 * read, through RSGISOGRBatchWriter.
+	 */
 	class DllExport RSGISProcessGeometry
 		{
 		public:
 			RSGISProcessGeometry(RSGISProcessOGRGeometry *processGeom);
+			/**
+			 * The number of threads (0 uses the number of cores).
+			 */
+			void setNumThreads(unsigned int numThreads);
 			void processGeometry(OGRLayer *inputLayer, OGRLayer *outputLayer, bool copyData, bool outVertical);
 			void processGeometryPolygonOutput(OGRLayer *inputLayer, OGRLayer *outputLayer, bool copyData, bool outVertical);
+			/**
+			 * Call processFeat for each index of a batch of numFeats features,
+			 * sharing the indexes among the workers of pool (kept for all the
+			 * batches of a layer). The first exception thrown is rethrown once
+			 * all the workers have finished.
+			 */
+			static void processBatch(size_t numFeats, rsgis::utils::RSGISWorkerPool &pool, std::function<void(size_t)> processFeat);
+			static const size_t featsPerBatch = 10000;
 			~RSGISProcessGeometry();
 		protected:
+			/**
+			 * Read up to featsPerBatch features from the layer.
+			 */
+			void readBatch(OGRLayer *inputLayer, std::vector<OGRFeature*> *inFeats);
 			void copyFeatureDefn(OGRLayer *outputSHPLayer, OGRFeatureDefn *inFeatureDefn);
 			void copyFeatureData(OGRFeature *inFeature, OGRFeature *outFeature, OGRFeatureDefn *inFeatureDefn, OGRFeatureDefn *outFeatureDefn);
 			RSGISProcessOGRGeometry *processGeom;
+			unsigned int numThreads;
 		};
 }}
 
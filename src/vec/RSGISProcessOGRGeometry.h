@@ -57,6 +57,12 @@ namespace rsgis{namespace vec{
 			virtual void processGeometry(OGRPoint *point)= 0;
 			virtual void processGeometry(OGRLineString *line)= 0;
 			virtual OGRPolygon* processGeometry(OGRGeometry *geom)= 0;
+			/**
+			 * Whether processGeometry can be called for different geometries
+			 * at the same time, allowing RSGISProcessGeometry to process the
+			 * features on several threads.
+			 */
+			virtual bool isThreadSafe(){return false;};
 			virtual ~RSGISProcessOGRGeometry(){};
 		};
 }}
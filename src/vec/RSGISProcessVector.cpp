@@ -74,7 +74,7 @@ namespace rsgis{namespace vec{
 				std::cout << "Started" << std::flush;
 			}	
 
-            bool inTransaction = false;
+            RSGISOGRBatchWriter outWriter(outputLayer, 20000);
 			inputLayer->ResetReading();
 			while( (inFeature = inputLayer->GetNextFeature()) != NULL )
 			{
@@ -91,15 +91,10 @@ namespace rsgis{namespace vec{
 					
 					feedbackCounter = feedbackCounter + 10;
 				}
-                if(!inTransaction)
-                {
-                    outputLayer->StartTransaction();
-                    inTransaction = true;
-                }
 				
 				fid = inFeature->GetFID();
 				
-				outFeature = OGRFeature::CreateFeature(outFeatureDefn);
+				outFeature = outWriter.getFeature();
 
 				// Get Geometry.
 				nullGeometry = false;
@@ -152,26 +147,12 @@ namespace rsgis{namespace vec{
 						this->copyFeatureData(inFeature, outFeature, inFeatureDefn, outFeatureDefn);
 					}
 					
-					if( outputLayer->CreateFeature(outFeature) != OGRERR_NONE )
-					{
-						throw RSGISVectorOutputException("Failed to write feature to the output shapefile.");
-					}
-
-					OGRFeature::DestroyFeature(outFeature);
+					outWriter.writeFeature(outFeature);
 				}
 				OGRFeature::DestroyFeature(inFeature);
 				i++;
-                if(((i % 20000) == 0) & inTransaction)
-                {
-                    inputLayer->CommitTransaction();
-                    inTransaction = false;
-                }
-            }
-            if(inTransaction)
-            {
-                inputLayer->CommitTransaction();
-                inTransaction = false;
             }
+            outWriter.finish();
 			std::cout << " Complete.\n";
 		}
 		catch(RSGISVectorOutputException& e)
@@ -38,6 +38,7 @@
 #include "vec/RSGISVectorOutputException.h"
 #include "vec/RSGISProcessOGRFeature.h"
 #include "vec/RSGISVectorUtils.h"
+#include "vec/RSGISOGRBatchWriter.h"
 
 #include "geos/geom/Envelope.h"
 
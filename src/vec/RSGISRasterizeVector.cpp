@@ -340,6 +340,12 @@ namespace rsgis{namespace vec{
 
 	int RSGISRasterizeVector::editPixels(GDALDataset *image, float pixelValue, geos::geom::Envelope *env, OGRGeometry *geom)
 	{
+		if(rsgis::img::RSGISPolygonRasteriser::supportsMethod(method) && rsgis::img::RSGISPolygonRasteriser::supportsGeometry(geom))
+		{
+			// For polygons the pixels can be found with a single scanline pass over the geometry.
+			return this->editPixelsScanline(image, pixelValue, env, geom);
+		}
+		
 		long pixelsEdited = 0; // Count for number of pixels edited
 		
 		try
@@ -472,6 +478,67 @@ namespace rsgis{namespace vec{
 		return pixelsEdited;
 	}
 		
+	int RSGISRasterizeVector::editPixelsScanline(GDALDataset *image, float pixelValue, geos::geom::Envelope *env, OGRGeometry *geom)
+	{
+		long pixelsEdited = 0;
+		
+		double gdalTranslation[6];
+		image->GetGeoTransform(gdalTranslation);
+		double imgMinX = gdalTranslation[0];
+		double imgMaxY = gdalTranslation[3];
+		
+		// The same pixel window as editPixels.
+		float resolution = gdalTranslation[1];
+		int startXPxl = 0;
+		int startYPxl = 0;
+		int width = 0;
+		int height = 0;
+		if((env->getWidth() < resolution) | (env->getHeight() < resolution))
+		{
+			startXPxl = (int)(((env->getMinX()-imgMinX)/resolution))-1;
+			startYPxl = (int)(((imgMaxY-env->getMaxY())/resolution))+1;
+			width = (int)((env->getWidth()/resolution)+0.5)+2;
+			height = (int)((env->getHeight()/resolution)+0.5)+2;
+		}
+		else
+		{
+			startXPxl = (int)(((env->getMinX()-imgMinX)/resolution));
+			startYPxl = (int)(((imgMaxY-env->getMaxY())/resolution));
+			width = (int)((env->getWidth()/resolution)+0.5);
+			height = (int)((env->getHeight()/resolution)+0.5);
+		}
+		if((width <= 0) | (height <= 0))
+		{
+			return 0;
+		}
+		
+		rsgis::img::RSGISPolygonRasteriser polyRasteriser(imgMinX+(startXPxl*resolution), imgMaxY-(startYPxl*resolution), resolution, resolution, width, height);
+		polyRasteriser.setPolygon(geom);
+		std::vector<rsgis::img::RSGISPixelSpan> pxlSpans;
+		polyRasteriser.findPixelSpans(method, &pxlSpans);
+		
+		// Only the rows with spans are read and written.
+		GDALRasterBand *imageBand = image->GetRasterBand(1);
+		std::vector<float> rowData(width);
+		size_t spanIdx = 0;
+		while(spanIdx < pxlSpans.size())
+		{
+			long row = pxlSpans[spanIdx].row;
+			imageBand->RasterIO(GF_Read, startXPxl, (row+startYPxl), width, 1, rowData.data(), width, 1, GDT_Float32, 0, 0);
+			for(; (spanIdx < pxlSpans.size()) && (pxlSpans[spanIdx].row == row); ++spanIdx)
+			{
+				for(long j = pxlSpans[spanIdx].xStart; j < pxlSpans[spanIdx].xEnd; ++j)
+				{
+					rowData[j] = pixelValue;
+					pixelsEdited++;
+				}
+			}
+			imageBand->RasterIO(GF_Write, startXPxl, (row+startYPxl), width, 1, rowData.data(), width, 1, GDT_Float32, 0, 0);
+		}
+		
+		return pixelsEdited;
+	}
+	
 	RSGISRasterizeVector::~RSGISRasterizeVector()
 	{
 		
@@ -37,6 +37,7 @@
 
 #include "vec/RSGISVectorUtils.h"
 #include "img/RSGISPixelInPoly.h"
+#include "img/RSGISPolygonRasteriser.h"
 
 #include "geos/geom/Envelope.h"
 #include "geos/geom/Polygon.h"
@@ -74,6 +75,8 @@ namespace rsgis{namespace vec{
 			//void editPixels(GDALDataset *image, float pixelValue, Envelope *env, Geometry *geom);
 			~RSGISRasterizeVector();
 		private:
+            /** editPixels for the methods and geometries supported by RSGISPolygonRasteriser. */
+            int editPixelsScanline(GDALDataset *image, float pixelValue, geos::geom::Envelope *env, OGRGeometry *geom);
             rsgis::img::pixelInPolyOption method;
 		};
 }}
@@ -33,107 +33,37 @@ namespace rsgis{namespace vec{
 	}
 	
 	long unsigned RSGISRemoveContainedPolygons::removeContainedPolygons(OGRLayer *input, OGRLayer *output)
-	{		
-		OGRFeature *inFeature = NULL;
-		OGRFeature *tmpFeature = NULL;
-		OGRFeature *outFeature = NULL;
-		OGRGeometry *geometry = NULL;
-		OGRGeometry *tmpGeometry = NULL;
-
-		bool geomContained = false;
-		
-		OGRFeatureDefn *inFeatureDefn = NULL;
-		OGRFeatureDefn *outFeatureDefn = NULL;
-		
-		unsigned long currentFID = 0;
-		unsigned long tmpFID = 0;
-		unsigned long numOutputted = 0;
-		
+	{
 		try
 		{
-			// Copy feature defenitions for output shapefile
-			inFeatureDefn = input->GetLayerDefn();
-			this->copyFeatureDefn(output, inFeatureDefn);
-			outFeatureDefn = output->GetLayerDefn();
-			
-			unsigned long numFeatures = input->GetFeatureCount(true);
-			
-			for(unsigned long i = 0; i < numFeatures; ++i)
+			// Index the input so each polygon is only tested against those whose envelope contains it.
+			RSGISOGRLayerSpatialIndex polysIdx(input, true);
+			return this->removeContainedPolygons(input, output, &polysIdx, true);
+		}
+		catch(RSGISVectorException &e)
+		{
+			throw e;
+		}
+	}
+	
+	long unsigned RSGISRemoveContainedPolygons::removeContainedPolygons(OGRLayer *input, OGRLayer *output, std::vector<OGRPolygon*> *inputPolys)
+	{
+		try
+		{
+			RSGISOGRLayerSpatialIndex polysIdx(true);
+			for(std::vector<OGRPolygon*>::iterator iterPolys = inputPolys->begin(); iterPolys != inputPolys->end(); ++iterPolys)
 			{
-				geomContained = false;
-				inFeature = input->GetFeature(i);
-				
-				currentFID = inFeature->GetFID();
-				
-				geometry = inFeature->GetGeometryRef(); // Get geometry 
-				
-				if( geometry != NULL )
-				{					
-					for(unsigned long j = 0; j < numFeatures; ++j)
-					{
-						tmpFeature = input->GetFeature(j);
-						tmpFID = tmpFeature->GetFID();
-						
-						if(currentFID != tmpFID)
-						{
-							tmpGeometry = tmpFeature->GetGeometryRef();
-							if( tmpGeometry != NULL )
-							{
-								try 
-								{
-									if(tmpGeometry->Contains(geometry))
-									{
-										geomContained = true;
-										break;
-									}
-								}
-								catch (geos::util::TopologyException &e) 
-								{
-									std::cout << "WARNING: " << e.what() << std::endl;
-								}
-								
-							}
-							else 
-							{
-								std::cout << "Tmp Geometry is NULL - IGNORING...\n";
-							}
-						}
-						OGRFeature::DestroyFeature(tmpFeature);
-					}
-				
-				
-					if(!geomContained)
-					{
-						numOutputted++;
-						
-						outFeature = OGRFeature::CreateFeature(outFeatureDefn);
-						outFeature->SetGeometry(geometry);
-						outFeature->SetFID(currentFID);
-						this->copyFeatureData(inFeature, outFeature, inFeatureDefn, outFeatureDefn);
-						
-						if( output->CreateFeature(outFeature) != OGRERR_NONE )
-						{
-							throw RSGISVectorOutputException("Failed to write feature to the output shapefile.");
-						}
-						
-						OGRFeature::DestroyFeature(outFeature);
-					}
-					OGRFeature::DestroyFeature(inFeature);
-				}
-				else 
-				{
-					std::cout << "Current Geometry is NULL - IGNORING...\n";
-				}
+				polysIdx.addGeometry(*iterPolys, -1);
 			}
+			return this->removeContainedPolygons(input, output, &polysIdx, false);
 		}
 		catch(RSGISVectorException &e)
 		{
 			throw e;
 		}
-		return numOutputted;
 	}
 	
-	long unsigned RSGISRemoveContainedPolygons::removeContainedPolygons(OGRLayer *input, OGRLayer *output, std::vector<OGRPolygon*> *inputPolys)
+	long unsigned RSGISRemoveContainedPolygons::removeContainedPolygons(OGRLayer *input, OGRLayer *output, RSGISOGRLayerSpatialIndex *polysIdx, bool ignoreSelf)
 	{
 		OGRFeature *inFeature = NULL;
 		OGRFeature *outFeature = NULL;
@@ -144,11 +74,9 @@ namespace rsgis{namespace vec{
 		OGRFeatureDefn *inFeatureDefn = NULL;
 		OGRFeatureDefn *outFeatureDefn = NULL;
 		
-		unsigned long currentFID = 0;
+		long currentFID = 0;
 		unsigned long numOutputted = 0;
 		
-		std::vector<OGRPolygon*>::iterator iterPolys;
-		
 		try
 		{
 			// Copy feature defenitions for output shapefile
@@ -156,35 +84,24 @@ namespace rsgis{namespace vec{
 			this->copyFeatureDefn(output, inFeatureDefn);
 			outFeatureDefn = output->GetLayerDefn();
 			
-			unsigned long numFeatures = input->GetFeatureCount(true);
-			
-			for(unsigned long i = 0; i < numFeatures; ++i)
+			input->ResetReading();
+			while( (inFeature = input->GetNextFeature()) != NULL )
 			{
 				geomContained = false;
-				inFeature = input->GetFeature(i);
-				
 				currentFID = inFeature->GetFID();
 				
 				geometry = inFeature->GetGeometryRef(); // Get geometry 
 				
 				if( geometry != NULL )
-				{					
-					for(iterPolys = inputPolys->begin(); iterPolys != inputPolys->end(); ++iterPolys)
+				{
+					try 
 					{
-						try 
-						{
-							if((*iterPolys)->Contains(geometry))
-							{
-								geomContained = true;
-								break;
-							}
-						}
-						catch (geos::util::TopologyException &e) 
-						{
-							std::cout << "WARNING: " << e.what() << std::endl;
-						}
+						geomContained = polysIdx->anyContains(geometry, (ignoreSelf?currentFID:-2));
+					}
+					catch (geos::util::TopologyException &e) 
+					{
+						std::cout << "WARNING: " << e.what() << std::endl;
 					}
-					
 					
 					if(!geomContained)
 					{
@@ -197,17 +114,19 @@ namespace rsgis{namespace vec{
 						
 						if( output->CreateFeature(outFeature) != OGRERR_NONE )
 						{
+							OGRFeature::DestroyFeature(outFeature);
+							OGRFeature::DestroyFeature(inFeature);
 							throw RSGISVectorOutputException("Failed to write feature to the output shapefile.");
 						}
 						
 						OGRFeature::DestroyFeature(outFeature);
 					}
-					OGRFeature::DestroyFeature(inFeature);
 				}
 				else 
 				{
 					std::cout << "Current Geometry is NULL - IGNORING...\n";
 				}
+				OGRFeature::DestroyFeature(inFeature);
 			}
 		}
 		catch(RSGISVectorException &e)
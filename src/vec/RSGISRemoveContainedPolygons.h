@@ -37,6 +37,7 @@
 #include "common/RSGISVectorException.h"
 
 #include "vec/RSGISVectorUtils.h"
+#include "vec/RSGISOGRLayerSpatialIndex.h"
 
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
@@ -59,6 +60,11 @@ namespace rsgis{namespace vec{
 		RSGISRemoveContainedPolygons();
 		long unsigned removeContainedPolygons(OGRLayer *input, OGRLayer *output);
 		long unsigned removeContainedPolygons(OGRLayer *input, OGRLayer *output, std::vector<OGRPolygon*> *inputPolys);
+		/**
+		 * Copy the features of input not contained by a polygon of polysIdx to output,
+		 * with ignoreSelf the polygon of the index with the feature's FID is not tested.
+		 */
+		long unsigned removeContainedPolygons(OGRLayer *input, OGRLayer *output, RSGISOGRLayerSpatialIndex *polysIdx, bool ignoreSelf);
 		void copyFeatureDefn(OGRLayer *outputSHPLayer, OGRFeatureDefn *inFeatureDefn);
 		void copyFeatureData(OGRFeature *inFeature, OGRFeature *outFeature, OGRFeatureDefn *inFeatureDefn, OGRFeatureDefn *outFeatureDefn);
 		~RSGISRemoveContainedPolygons();
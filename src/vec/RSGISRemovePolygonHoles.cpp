@@ -30,27 +30,28 @@ namespace rsgis{namespace vec{
 	{
 		this->areaThreshold = areaThreshold;
         this->areaThresholdUsed = areaThresholdUsed;
+        this->numThreads = rsgis::utils::getNumThreads();
+	}
+	
+	void RSGISRemovePolygonHoles::setNumThreads(unsigned int numThreads)
+	{
+		this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
 	}
 	
 	void RSGISRemovePolygonHoles::removeholes(OGRLayer *input, OGRLayer *output)
 	{
-		RSGISVectorUtils vecUtils;
-		
 		OGRFeature *inFeature = NULL;
 		OGRFeature *outFeature = NULL;
-		OGRGeometry *geometry = NULL;
-		OGRPolygon *polygon = NULL;
-		OGRPolygon *nPolygon = NULL;
-		
-		bool nullGeometry = false;
-		bool polyOK = false;
 		
 		OGRFeatureDefn *inFeatureDefn = NULL;
 		OGRFeatureDefn *outFeatureDefn = NULL;
 		
-		long fid = 0;
 		long unsigned numOutputted = 0;
 		
+		std::vector<OGRFeature*> inFeats;
+		std::vector<OGRPolygon*> outPolys;
+		std::vector<std::string> errMsgs;
+		
 		try
 		{
 			inFeatureDefn = input->GetLayerDefn();
@@ -66,73 +67,81 @@ namespace rsgis{namespace vec{
 			unsigned long i = 0;
 			std::cout << "Started" << std::flush;
 			
+			RSGISOGRBatchWriter outWriter(output, 20000);
+			rsgis::utils::RSGISWorkerPool pool(this->numThreads);
+			
 			input->ResetReading();
-			while( (inFeature = input->GetNextFeature()) != NULL )
+			bool moreFeats = true;
+			while(moreFeats)
 			{
-				if((numFeatures >= 10) && ((i % feedback) == 0))
+				inFeats.clear();
+				while((inFeats.size() < RSGISProcessGeometry::featsPerBatch) && ((inFeature = input->GetNextFeature()) != NULL))
 				{
-					std::cout << ".." << feedbackCounter << ".." << std::flush;
-					feedbackCounter = feedbackCounter + 10;
+					inFeats.push_back(inFeature);
 				}
-				++i;
-				
-				fid = inFeature->GetFID();
+				moreFeats = (inFeats.size() == RSGISProcessGeometry::featsPerBatch);
 				
-				// Get Geometry.
-				polyOK = false;
-				nullGeometry = false;
-				geometry = inFeature->GetGeometryRef();
-				if( geometry != NULL && wkbFlatten(geometry->getGeometryType()) == wkbPolygon )
+				// The polygons without holes are created concurrently; failures are reported when the features are written.
+				outPolys.assign(inFeats.size(), NULL);
+				errMsgs.assign(inFeats.size(), "");
+				RSGISProcessGeometry::processBatch(inFeats.size(), pool, [&](size_t idx)
 				{
-					polygon = (OGRPolygon *) geometry;
-					
-					try 
+					RSGISVectorUtils vecUtils;
+					OGRGeometry *geometry = inFeats[idx]->GetGeometryRef();
+					if( geometry != NULL && wkbFlatten(geometry->getGeometryType()) == wkbPolygon )
 					{
-                        if(areaThresholdUsed)
-                        {
-                            nPolygon = vecUtils.removeHolesOGRPolygon(polygon, areaThreshold);
-                        }
-                        else
-                        {
-                            nPolygon = vecUtils.removeHolesOGRPolygon(polygon);
-                        }
-						polyOK = true;
-					}
-					catch (RSGISVectorException &e) 
+						try 
+						{
+							if(areaThresholdUsed)
+							{
+								outPolys[idx] = vecUtils.removeHolesOGRPolygon((OGRPolygon *) geometry, areaThreshold);
+							}
+							else
+							{
+								outPolys[idx] = vecUtils.removeHolesOGRPolygon((OGRPolygon *) geometry);
+							}
+						}
+						catch (RSGISVectorException &e) 
+						{
+							errMsgs[idx] = e.what();
+						}
+					} 
+					else 
 					{
-						std::cout << fid << ": " << e.what() << std::endl;
-						polyOK = false;
+						errMsgs[idx] = "Geometry was either the incorrect type or NULL.";
 					}
-					
-				} 
-				else 
-				{
-					nullGeometry = true;
-					std::cout << fid << ": Geometry was either the incorrect type or NULL." << std::endl;
-				}
+				});
 				
-				if(polyOK && !nullGeometry)
+				for(size_t idx = 0; idx < inFeats.size(); ++idx)
 				{
-					outFeature = OGRFeature::CreateFeature(outFeatureDefn);
-					outFeature->SetGeometry(nPolygon);
-					outFeature->SetFID(fid);
-					this->copyFeatureData(inFeature, outFeature, inFeatureDefn, outFeatureDefn);
+					if((numFeatures >= 10) && ((i % feedback) == 0))
+					{
+						std::cout << ".." << feedbackCounter << ".." << std::flush;
+						feedbackCounter = feedbackCounter + 10;
+					}
+					++i;
 					
-					if( output->CreateFeature(outFeature) != OGRERR_NONE )
+					if(outPolys[idx] != NULL)
 					{
-						throw RSGISVectorOutputException("Failed to write feature to the output shapefile.");
+						outFeature = outWriter.getFeature();
+						outFeature->SetGeometryDirectly(outPolys[idx]);
+						outPolys[idx] = NULL;
+						outFeature->SetFID(inFeats[idx]->GetFID());
+						this->copyFeatureData(inFeats[idx], outFeature, inFeatureDefn, outFeatureDefn);
+						outWriter.writeFeature(outFeature);
+						numOutputted++;
+					}
+					else 
+					{
+						std::cout << inFeats[idx]->GetFID() << ": " << errMsgs[idx] << std::endl;
+						std::cout << inFeats[idx]->GetFID() << ": Geometry is either NULL or not a polygon\n";
 					}
 					
-					OGRFeature::DestroyFeature(outFeature);
-					numOutputted++;
-				}
-				else 
-				{
-					std::cout << fid << ": Geometry is either NULL or not a polygon\n";
+					OGRFeature::DestroyFeature(inFeats[idx]);
+					inFeats[idx] = NULL;
 				}
-				
-				OGRFeature::DestroyFeature(inFeature);
 			}
+			outWriter.finish();
 			std::cout << " Complete.\n";
 			
 			std::cout << numOutputted << " Polygons have been outputted from the " << numFeatures << " in the input file.\n";
@@ -144,6 +153,14 @@ namespace rsgis{namespace vec{
 		}
 		catch(RSGISVectorException &e)
 		{
+			for(size_t idx = 0; idx < inFeats.size(); ++idx)
+			{
+				OGRFeature::DestroyFeature(inFeats[idx]);
+				if(idx < outPolys.size())
+				{
+					delete outPolys[idx];
+				}
+			}
 			throw e;
 		}
 	}
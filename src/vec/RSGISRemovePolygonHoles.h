@@ -32,8 +32,11 @@
 
 #include "common/rsgis-tqdm.h"
 #include "common/RSGISVectorException.h"
+#include "common/RSGISParallel.h"
 
 #include "vec/RSGISVectorUtils.h"
+#include "vec/RSGISProcessGeometry.h"
+#include "vec/RSGISOGRBatchWriter.h"
 
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
@@ -50,10 +53,20 @@
 
 namespace rsgis{namespace vec{
 	
+	/**
+	 * Removes the holes (or those smaller than a threshold area) from the
+	 * polygons of a layer. The features are read in batches whose polygons
+	 * are processed on several threads (RSGISLIB_NUM_THREADS) and written
+	 * in order through RSGISOGRBatchWriter.
+	 */
 	class DllExport RSGISRemovePolygonHoles
 	{
 	public:
 		RSGISRemovePolygonHoles(float areaThreshold=0, bool areaThresholdUsed=false);
+		/**
+		 * The number of threads (0 uses the number of cores).
+		 */
+		void setNumThreads(unsigned int numThreads);
 		void removeholes(OGRLayer *input, OGRLayer *output);
 		void copyFeatureDefn(OGRLayer *outputSHPLayer, OGRFeatureDefn *inFeatureDefn);
 		void copyFeatureData(OGRFeature *inFeature, OGRFeature *outFeature, OGRFeatureDefn *inFeatureDefn, OGRFeatureDefn *outFeatureDefn);
@@ -61,6 +74,7 @@ namespace rsgis{namespace vec{
     protected:
         float areaThreshold;
         bool areaThresholdUsed;
+        unsigned int numThreads;
 	};
 
 	
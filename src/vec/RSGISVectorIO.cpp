@@ -1828,22 +1828,18 @@ namespace rsgis{namespace vec{
 	{
 		try
 		{			
-			OGRFeatureDefn *outputDefn = outLayer->GetLayerDefn();
+			RSGISOGRBatchWriter outWriter(outLayer, 20000);
 			OGRFeature *featureOutput = NULL;
 			
 			// Write Polygons to file
 			std::list<OGRPolygon*>::iterator iterPolys;
 			for(iterPolys = polys->begin(); iterPolys != polys->end(); iterPolys++)
 			{
-				featureOutput = OGRFeature::CreateFeature(outputDefn);
+				featureOutput = outWriter.getFeature();
 				featureOutput->SetGeometryDirectly(*iterPolys);
-				
-				if( outLayer->CreateFeature(featureOutput) != OGRERR_NONE )
-				{
-					throw RSGISVectorOutputException("Failed to write feature to the output shapefile.");
-				}
-				OGRFeature::DestroyFeature(featureOutput);
+				outWriter.writeFeature(featureOutput);
 			}
+			outWriter.finish();
 		}
 		catch(RSGISException &e)
 		{
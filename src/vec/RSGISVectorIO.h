@@ -37,6 +37,7 @@
 #include "vec/RSGISPointData.h"
 #include "vec/RSGISEmptyPolygon.h"
 #include "vec/RSGISVectorUtils.h"
+#include "vec/RSGISOGRBatchWriter.h"
 
 #include "geom/RSGISPolygon.h"
 #include "geom/RSGISGeometry.h"
@@ -63,6 +63,10 @@ namespace rsgis{namespace vec{
 			virtual void processGeometry(OGRPoint *point);
 			virtual void processGeometry(OGRLineString *line);
 			virtual OGRPolygon* processGeometry(OGRGeometry *geom);
+			/**
+			 * OGRGeometry::Buffer uses its own GEOS (_r) context for each call.
+			 */
+			virtual bool isThreadSafe(){return true;};
 			virtual ~RSGISVectorMorphology();
 		protected:
 			float buffer;
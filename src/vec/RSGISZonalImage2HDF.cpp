@@ -27,10 +27,209 @@ namespace rsgis{namespace vec{
     
     RSGISZonalImage2HDF::RSGISZonalImage2HDF()
     {
-        
+        this->numThreads = rsgis::utils::getNumThreads();
+    }
+    
+    void RSGISZonalImage2HDF::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
     }
 		
     void RSGISZonalImage2HDF::extractBandsToColumns(GDALDataset *dataset, OGRLayer *vecLayer, std::string outputFile, rsgis::img::pixelInPolyOption pixelPolyOption)
+    {
+        if(!rsgis::img::RSGISPolygonRasteriser::supportsMethod(pixelPolyOption))
+        {
+            this->extractBandsToColumnsPerFeature(dataset, vecLayer, outputFile, pixelPolyOption);
+            return;
+        }
+        
+        std::vector<ExtractFeatWindow> featWins;
+        try
+        {
+            unsigned int numImageBands = dataset->GetRasterCount();
+            int imgXSize = dataset->GetRasterXSize();
+            int imgYSize = dataset->GetRasterYSize();
+            double imgTransform[6];
+            dataset->GetGeoTransform(imgTransform);
+            double pxlYRes = fabs(imgTransform[5]);
+            int blockXSize = 0;
+            int blockYSize = 0;
+            dataset->GetRasterBand(1)->GetBlockSize(&blockXSize, &blockYSize);
+            blockXSize = std::max(blockXSize, 1);
+            blockYSize = std::max(blockYSize, 1);
+            
+            // Find the pixel window of each polygon.
+            OGRFeature *inFeature = NULL;
+            vecLayer->ResetReading();
+            while( (inFeature = vecLayer->GetNextFeature()) != NULL )
+            {
+                OGRGeometry *geometry = inFeature->GetGeometryRef();
+                if(!rsgis::img::RSGISPolygonRasteriser::supportsGeometry(geometry))
+                {
+                    std::cout << "WARNING: NULL Geometry Present within input file - IGNORED\n";
+                    OGRFeature::DestroyFeature(inFeature);
+                    continue;
+                }
+                OGREnvelope featEnv;
+                geometry->getEnvelope(&featEnv);
+                ExtractFeatWindow featWin;
+                featWin.xOff = std::min<double>(std::max<double>(floor((featEnv.MinX - imgTransform[0]) / imgTransform[1]), 0), imgXSize);
+                featWin.xEnd = std::min<double>(std::max<double>(ceil((featEnv.MaxX - imgTransform[0]) / imgTransform[1]), 0), imgXSize);
+                featWin.yOff = std::min<double>(std::max<double>(floor((imgTransform[3] - featEnv.MaxY) / pxlYRes), 0), imgYSize);
+                featWin.yEnd = std::min<double>(std::max<double>(ceil((imgTransform[3] - featEnv.MinY) / pxlYRes), 0), imgYSize);
+                if((featWin.xEnd > featWin.xOff) && (featWin.yEnd > featWin.yOff))
+                {
+                    featWin.geom = geometry->clone();
+                    featWins.push_back(featWin);
+                }
+                OGRFeature::DestroyFeature(inFeature);
+            }
+            
+            // Group the polygons by the image block they start in, so a batch
+            // reads as few blocks as possible.
+            std::stable_sort(featWins.begin(), featWins.end(), [blockXSize, blockYSize](const ExtractFeatWindow &a, const ExtractFeatWindow &b)
+            {
+                if((a.yOff / blockYSize) != (b.yOff / blockYSize))
+                {
+                    return (a.yOff / blockYSize) < (b.yOff / blockYSize);
+                }
+                return (a.xOff / blockXSize) < (b.xOff / blockXSize);
+            });
+            
+            rsgis::utils::RSGISExportColumnData2HDF exportCols2HDF;
+            exportCols2HDF.createFile(outputFile, numImageBands, std::string("Pixels Extracted from ")+std::string(dataset->GetFileList()[0]), H5::PredType::IEEE_F32LE);
+            
+            // Limits on the size of a batch; a single polygon larger than the limit is a batch on its own.
+            const size_t maxBatchFeats = 512;
+            const size_t maxBatchPxls = std::max<size_t>(16777216 / std::max<unsigned int>(numImageBands, 1), 1);
+            
+            rsgis::utils::RSGISWorkerPool pool(this->numThreads);
+            rsgis_tqdm pbar;
+            size_t featIdx = 0;
+            std::vector<ExtractFeatBatch> batches;
+            while(featIdx < featWins.size())
+            {
+                pbar.progress(featIdx, featWins.size());
+                
+                // Form and read a batch for each thread.
+                batches.clear();
+                batches.resize(pool.getNumThreads());
+                size_t numBatches = 0;
+                for(; (numBatches < pool.getNumThreads()) && (featIdx < featWins.size()); ++numBatches)
+                {
+                    ExtractFeatBatch &batch = batches[numBatches];
+                    int xOff = featWins[featIdx].xOff;
+                    int yOff = featWins[featIdx].yOff;
+                    int xEnd = featWins[featIdx].xEnd;
+                    int yEnd = featWins[featIdx].yEnd;
+                    batch.windows.push_back(featWins[featIdx++]);
+                    while((featIdx < featWins.size()) && (batch.windows.size() < maxBatchFeats))
+                    {
+                        const ExtractFeatWindow &nextWin = featWins[featIdx];
+                        int nXOff = std::min(xOff, nextWin.xOff);
+                        int nYOff = std::min(yOff, nextWin.yOff);
+                        int nXEnd = std::max(xEnd, nextWin.xEnd);
+                        int nYEnd = std::max(yEnd, nextWin.yEnd);
+                        if((((size_t)(nXEnd - nXOff)) * (nYEnd - nYOff)) > maxBatchPxls)
+                        {
+                            break;
+                        }
+                        xOff = nXOff;
+                        yOff = nYOff;
+                        xEnd = nXEnd;
+                        yEnd = nYEnd;
+                        batch.windows.push_back(nextWin);
+                        ++featIdx;
+                    }
+                    batch.xOff = xOff;
+                    batch.yOff = yOff;
+                    batch.width = xEnd - xOff;
+                    batch.height = yEnd - yOff;
+                    
+                    size_t batchPxls = ((size_t)batch.width) * batch.height;
+                    batch.data.resize(batchPxls * numImageBands);
+                    for(unsigned int n = 0; n < numImageBands; ++n)
+                    {
+                        if(dataset->GetRasterBand(n+1)->RasterIO(GF_Read, batch.xOff, batch.yOff, batch.width, batch.height, &batch.data[n*batchPxls], batch.width, batch.height, GDT_Float32, 0, 0) != CE_None)
+                        {
+                            throw RSGISVectorZonalException("Could not read the image to extract the pixel values.");
+                        }
+                    }
+                }
+                
+                // Find the pixels of the polygons of each batch.
+                pool.parallelFor(numBatches, [&](size_t b, unsigned int)
+                {
+                    this->extractFeatBatch(&batches[b], imgTransform, numImageBands, pixelPolyOption);
+                });
+                
+                // Write the rows from this thread, in batch order.
+                for(size_t b = 0; b < numBatches; ++b)
+                {
+                    size_t numRows = batches[b].rows.size() / std::max<unsigned int>(numImageBands, 1);
+                    if(numRows > 0)
+                    {
+                        exportCols2HDF.addDataRows(batches[b].rows.data(), numRows, H5::PredType::NATIVE_FLOAT);
+                    }
+                }
+            }
+            exportCols2HDF.close();
+            pbar.finish();
+        }
+        catch(RSGISException &e)
+        {
+            for(std::vector<ExtractFeatWindow>::iterator iterWin = featWins.begin(); iterWin != featWins.end(); ++iterWin)
+            {
+                OGRGeometryFactory::destroyGeometry((*iterWin).geom);
+            }
+            throw RSGISVectorZonalException(e.what());
+        }
+        catch(std::exception &e)
+        {
+            for(std::vector<ExtractFeatWindow>::iterator iterWin = featWins.begin(); iterWin != featWins.end(); ++iterWin)
+            {
+                OGRGeometryFactory::destroyGeometry((*iterWin).geom);
+            }
+            throw RSGISVectorZonalException(e.what());
+        }
+        for(std::vector<ExtractFeatWindow>::iterator iterWin = featWins.begin(); iterWin != featWins.end(); ++iterWin)
+        {
+            OGRGeometryFactory::destroyGeometry((*iterWin).geom);
+        }
+    }
+    
+    void RSGISZonalImage2HDF::extractFeatBatch(ExtractFeatBatch *batch, double *imgTransform, unsigned int numImageBands, rsgis::img::pixelInPolyOption pixelPolyOption)
+    {
+        std::vector<rsgis::img::RSGISPixelSpan> pxlSpans;
+        double pxlYRes = fabs(imgTransform[5]);
+        size_t batchPxls = ((size_t)batch->width) * batch->height;
+        
+        batch->rows.clear();
+        for(std::vector<ExtractFeatWindow>::iterator iterWin = batch->windows.begin(); iterWin != batch->windows.end(); ++iterWin)
+        {
+            const ExtractFeatWindow &featWin = *iterWin;
+            pxlSpans.clear();
+            rsgis::img::RSGISPolygonRasteriser polyRasteriser(imgTransform[0] + (featWin.xOff * imgTransform[1]), imgTransform[3] - (featWin.yOff * pxlYRes), imgTransform[1], pxlYRes, featWin.xEnd - featWin.xOff, featWin.yEnd - featWin.yOff);
+            polyRasteriser.setPolygon(featWin.geom);
+            polyRasteriser.findPixelSpans(pixelPolyOption, &pxlSpans);
+            
+            for(std::vector<rsgis::img::RSGISPixelSpan>::iterator iterSpan = pxlSpans.begin(); iterSpan != pxlSpans.end(); ++iterSpan)
+            {
+                size_t rowOff = ((featWin.yOff - batch->yOff + (*iterSpan).row) * ((size_t)batch->width)) + (featWin.xOff - batch->xOff);
+                for(long x = (*iterSpan).xStart; x < (*iterSpan).xEnd; ++x)
+                {
+                    for(unsigned int n = 0; n < numImageBands; ++n)
+                    {
+                        batch->rows.push_back(batch->data[(n * batchPxls) + rowOff + x]);
+                    }
+                }
+            }
+        }
+        // The image data is no longer needed, only the rows.
+        std::vector<float>().swap(batch->data);
+    }
+    
+    void RSGISZonalImage2HDF::extractBandsToColumnsPerFeature(GDALDataset *dataset, OGRLayer *vecLayer, std::string outputFile, rsgis::img::pixelInPolyOption pixelPolyOption)
     {
         try
         {
@@ -27,11 +27,19 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <thread>
+#include <exception>
+#include <algorithm>
+#include <cstdlib>
 #include <math.h>
 
 #include "gdal_priv.h"
 #include "ogrsf_frmts.h"
 
+#include "common/rsgis-tqdm.h"
+#include "common/RSGISParallel.h"
+
 #include "vec/RSGISVectorZonalException.h"
 #include "vec/RSGISVectorIO.h"
 
@@ -44,6 +52,7 @@
 #include "img/RSGISCalcImage.h"
 #include "img/RSGISCalcImageValue.h"
 #include "img/RSGISPixelInPoly.h"
+#include "img/RSGISPolygonRasteriser.h"
 
 #include "geos/geom/Envelope.h"
 #include "geos/geom/Coordinate.h"
@@ -63,12 +72,50 @@
 
 namespace rsgis{namespace vec{
     
+	/**
+	 * Extracts the values of the image pixels within each polygon to the rows
+	 * of a HDF5 file. Where the pixelInPolyOption is supported by
+	 * RSGISPolygonRasteriser the polygons are sorted by the image block they
+	 * start in and grouped into batches which are each read with a single
+	 * read; the pixels of the batches are found (as spans) on numThreads
+	 * threads (RSGISLIB_NUM_THREADS or setNumThreads) and the rows written
+	 * a batch at a time, in batch order. Otherwise each polygon is
+	 * processed in turn with RSGISCalcImage.
+	 */
 	class DllExport RSGISZonalImage2HDF
 	{
 	public:
 		RSGISZonalImage2HDF();
+        /**
+         * The number of batches of polygons to process at once (0 uses the number of cores).
+         */
+        void setNumThreads(unsigned int numThreads);
 		void extractBandsToColumns(GDALDataset *dataset, OGRLayer *vecLayer, std::string outputFile, rsgis::img::pixelInPolyOption pixelPolyOption);
 		~RSGISZonalImage2HDF();
+    protected:
+        struct ExtractFeatWindow
+        {
+            OGRGeometry *geom;
+            int xOff;
+            int yOff;
+            int xEnd;
+            int yEnd;
+        };
+        struct ExtractFeatBatch
+        {
+            std::vector<ExtractFeatWindow> windows;
+            int xOff;
+            int yOff;
+            int width;
+            int height;
+            // The bands, one after another.
+            std::vector<float> data;
+            // The extracted pixels, numBands values per row.
+            std::vector<float> rows;
+        };
+        void extractBandsToColumnsPerFeature(GDALDataset *dataset, OGRLayer *vecLayer, std::string outputFile, rsgis::img::pixelInPolyOption pixelPolyOption);
+        void extractFeatBatch(ExtractFeatBatch *batch, double *imgTransform, unsigned int numImageBands, rsgis::img::pixelInPolyOption pixelPolyOption);
+        unsigned int numThreads;
 	};
     
     
@@ -27,8 +27,13 @@ namespace rsgis{namespace vec{
 	
 	ZonalStats::ZonalStats()
 	{
-		
+        this->numThreads = rsgis::utils::getNumThreads();
 	}
+    
+    void ZonalStats::setNumThreads(unsigned int numThreads)
+    {
+        this->numThreads = rsgis::utils::resolveNumThreads(numThreads);
+    }
 	
 	void ZonalStats::zonalStats(GDALDataset *image, OGRLayer *vector, bool **toCalc,  OGRLayer *outputSHPLayer) 
 	{
@@ -130,31 +135,8 @@ namespace rsgis{namespace vec{
 				}
 			}
 			
-			int numDS = 2;
-			GDALDataset **datasets = new GDALDataset*[numDS];
-			datasets[0] = rasterFeatures;
-			datasets[1] = image;
-			
-			rasterZonalCalc = new RSGISCalcZonalStatsFromRaster(0, featureStats, numAttributes, numFeatures, false);
-			calcImg = new rsgis::img::RSGISCalcImage(rasterZonalCalc, "", true);
-			calcImg->calcImage(datasets, numDS);
-			for(int i = 0; i < numFeatures; i++)
-			{
-				for(int j = 0; j < numAttributes; j++)
-				{
-					featureStats[i][j].mean = featureStats[i][j].meanSum/featureStats[i][j].n;
-				}
-			}
-			rasterZonalCalc->setStdDev(true);
-			calcImg->calcImage(datasets, numDS);
-			for(int i = 0; i < numFeatures; i++)
-			{
-				for(int j = 0; j < numAttributes; j++)
-				{
-					featureStats[i][j].stddev = sqrt(featureStats[i][j].sumDiff/featureStats[i][j].n);
-				}
-			}
-			delete[] datasets;
+			// A single pass over the images for all the features.
+			this->calcRasterZoneStats(image, rasterFeatures, featureStats, numFeatures, numAttributes);
 			featDefn = inputLayer->GetLayerDefn();
 			int fieldCount = featDefn->GetFieldCount();
 			this->outputData2SHP(inputLayer, outputLayer, fieldCount, toCalc, numAttributes, featureStats);
@@ -285,23 +267,7 @@ namespace rsgis{namespace vec{
 				}
 			}
 			
-			int numDS = 2;
-			GDALDataset **datasets = new GDALDataset*[numDS];
-			datasets[0] = rasterFeatures;
-			datasets[1] = image;
-			
-			rasterZonalCalc = new RSGISCalcZonalStatsFromRaster(0, featureStats, numAttributes, numFeatures, false);
-			calcImg = new rsgis::img::RSGISCalcImage(rasterZonalCalc, "", true);
-			std::cout << "Calc stats part 1\n";
-			calcImg->calcImage(datasets, numDS);
-			for(int i = 0; i < numFeatures; i++)
-			{
-				for(int j = 0; j < numAttributes; j++)
-				{
-					featureStats[i][j].mean = featureStats[i][j].meanSum/featureStats[i][j].n;
-				}
-			}
-			delete[] datasets;
+			this->calcRasterZoneStats(image, rasterFeatures, featureStats, numFeatures, numAttributes);
 			this->outputData2Text(outputTxt, toCalc, featureStats, numFeatures, numAttributes);
 		}
 		catch(rsgis::img::RSGISImageCalcException &e)
@@ -366,6 +332,35 @@ namespace rsgis{namespace vec{
 		}
 	}
 
+    void ZonalStats::calcRasterZoneStats(GDALDataset *image, GDALDataset *rasterFeatures, imagestats **featureStats, int numFeatures, int numAttributes)
+    {
+        try
+        {
+            rsgis::rastergis::RSGISZonalStatsAccumulator zoneStatsAcc(numFeatures);
+            zoneStatsAcc.setNumThreads(this->numThreads);
+            zoneStatsAcc.calcZoneStats(rasterFeatures, 1, image);
+            for(int i = 0; i < numFeatures; i++)
+            {
+                for(int j = 0; j < numAttributes; j++)
+                {
+                    const rsgis::rastergis::RSGISZoneBandStats &zoneStats = zoneStatsAcc.getStats(i, j);
+                    featureStats[i][j].n = zoneStats.n;
+                    featureStats[i][j].meanSum = zoneStats.sum;
+                    featureStats[i][j].sumDiff = zoneStats.m2;
+                    featureStats[i][j].first = (zoneStats.n == 0);
+                    featureStats[i][j].mean = (zoneStats.n == 0)?std::numeric_limits<double>::quiet_NaN():zoneStats.mean;
+                    featureStats[i][j].stddev = zoneStatsAcc.getStdDev(i, j);
+                    featureStats[i][j].min = (zoneStats.n == 0)?0:zoneStats.min;
+                    featureStats[i][j].max = (zoneStats.n == 0)?0:zoneStats.max;
+                }
+            }
+        }
+        catch(rsgis::RSGISException &e)
+        {
+            throw rsgis::img::RSGISImageCalcException(e.what());
+        }
+    }
+    
     void ZonalStats::zonalStatsFeatsVectorLyr(GDALDataset *image, OGRLayer *vecLyr, std::vector<ZonalBandAttrs> *zonalBandAtts, rsgis::img::pixelInPolyOption pixelInPolyMethod)
     {
         try
@@ -394,6 +389,347 @@ namespace rsgis{namespace vec{
         }
     }
 
+    void ZonalStats::zonalStatsFeatsVectorLyrBatched(GDALDataset *image, OGRLayer *vecLyr, std::vector<ZonalBandAttrs> *zonalBandAtts, rsgis::img::pixelInPolyOption pixelInPolyMethod)
+    {
+        if((!rsgis::img::RSGISPolygonRasteriser::supportsMethod(pixelInPolyMethod)) || (!vecLyr->TestCapability(OLCRandomRead)))
+        {
+            this->zonalStatsFeatsVectorLyr(image, vecLyr, zonalBandAtts, pixelInPolyMethod);
+            return;
+        }
+        try
+        {
+            // Define the output fields within vector layer.
+            this->addVecLyrDefn(vecLyr, zonalBandAtts);
+            
+            int imgXSize = image->GetRasterXSize();
+            int imgYSize = image->GetRasterYSize();
+            int nImgBands = image->GetRasterCount();
+            double imgTransform[6];
+            image->GetGeoTransform(imgTransform);
+            double pxlYRes = fabs(imgTransform[5]);
+            
+            // Only read the bands which are used.
+            std::vector<int> bandSlots(nImgBands, -1);
+            std::vector<int> usedBands;
+            for(std::vector<ZonalBandAttrs>::iterator iterAtts = zonalBandAtts->begin(); iterAtts != zonalBandAtts->end(); ++iterAtts)
+            {
+                if(((*iterAtts).band < 1) || ((*iterAtts).band > nImgBands))
+                {
+                    throw rsgis::img::RSGISImageCalcException("A band for the zonal stats is not within the image.");
+                }
+                if(bandSlots[(*iterAtts).band-1] < 0)
+                {
+                    bandSlots[(*iterAtts).band-1] = usedBands.size();
+                    usedBands.push_back((*iterAtts).band);
+                }
+            }
+            
+            // Find the pixel window of each feature.
+            std::vector<ZonalFeatWindow> featWins;
+            OGRFeature *feat = NULL;
+            vecLyr->ResetReading();
+            while((feat = vecLyr->GetNextFeature()) != NULL)
+            {
+                OGRGeometry *geom = feat->GetGeometryRef();
+                if(geom == NULL)
+                {
+                    std::cout << "WARNING: NULL Geometry Present within input file - IGNORED\n";
+                    OGRFeature::DestroyFeature(feat);
+                    continue;
+                }
+                if((wkbFlatten(geom->getGeometryType()) != wkbPolygon) && (wkbFlatten(geom->getGeometryType()) != wkbMultiPolygon))
+                {
+                    OGRFeature::DestroyFeature(feat);
+                    throw RSGISVectorException("Unsupported geometry; geometry must be polygon or multi-polygon.");
+                }
+                OGREnvelope featEnv;
+                geom->getEnvelope(&featEnv);
+                ZonalFeatWindow featWin;
+                featWin.fid = feat->GetFID();
+                featWin.hilbertIdx = 0;
+                featWin.xOff = std::min<double>(std::max<double>(floor((featEnv.MinX - imgTransform[0]) / imgTransform[1]), 0), imgXSize);
+                featWin.xEnd = std::min<double>(std::max<double>(ceil((featEnv.MaxX - imgTransform[0]) / imgTransform[1]), 0), imgXSize);
+                featWin.yOff = std::min<double>(std::max<double>(floor((imgTransform[3] - featEnv.MaxY) / pxlYRes), 0), imgYSize);
+                featWin.yEnd = std::min<double>(std::max<double>(ceil((imgTransform[3] - featEnv.MinY) / pxlYRes), 0), imgYSize);
+                featWins.push_back(featWin);
+                OGRFeature::DestroyFeature(feat);
+            }
+            
+            // Sort the features along a Hilbert curve of the centres of their windows.
+            for(std::vector<ZonalFeatWindow>::iterator iterWin = featWins.begin(); iterWin != featWins.end(); ++iterWin)
+            {
+                double cX = (((*iterWin).xOff + (*iterWin).xEnd) / 2.0) / std::max(imgXSize, 1);
+                double cY = (((*iterWin).yOff + (*iterWin).yEnd) / 2.0) / std::max(imgYSize, 1);
+                uint32_t hX = std::min<double>(std::max<double>(cX, 0.0), 1.0) * 65535;
+                uint32_t hY = std::min<double>(std::max<double>(cY, 0.0), 1.0) * 65535;
+                (*iterWin).hilbertIdx = this->hilbertIndex(hX, hY);
+            }
+            std::stable_sort(featWins.begin(), featWins.end(), [](const ZonalFeatWindow &a, const ZonalFeatWindow &b){return a.hilbertIdx < b.hilbertIdx;});
+            
+            // Limits on the size of a batch; a single feature larger than the limit is a batch on its own.
+            const size_t maxBatchFeats = 512;
+            const size_t maxBatchPxls = std::max<size_t>(16777216 / usedBands.size(), 1);
+            
+            rsgis::utils::RSGISWorkerPool pool(this->numThreads);
+            rsgis_tqdm pbar;
+            size_t numWritten = 0;
+            bool inTransaction = false;
+            size_t featIdx = 0;
+            std::vector<ZonalFeatBatch> batches;
+            while(featIdx < featWins.size())
+            {
+                pbar.progress(featIdx, featWins.size());
+                
+                // Form and read a batch for each worker.
+                batches.clear();
+                batches.resize(pool.getNumThreads());
+                size_t numBatches = 0;
+                for(; (numBatches < pool.getNumThreads()) && (featIdx < featWins.size()); ++numBatches)
+                {
+                    ZonalFeatBatch &batch = batches[numBatches];
+                    int xOff = featWins[featIdx].xOff;
+                    int yOff = featWins[featIdx].yOff;
+                    int xEnd = featWins[featIdx].xEnd;
+                    int yEnd = featWins[featIdx].yEnd;
+                    batch.windows.push_back(featWins[featIdx++]);
+                    while((featIdx < featWins.size()) && (batch.windows.size() < maxBatchFeats))
+                    {
+                        const ZonalFeatWindow &nextWin = featWins[featIdx];
+                        int nXOff = std::min(xOff, nextWin.xOff);
+                        int nYOff = std::min(yOff, nextWin.yOff);
+                        int nXEnd = std::max(xEnd, nextWin.xEnd);
+                        int nYEnd = std::max(yEnd, nextWin.yEnd);
+                        if((((size_t)(nXEnd - nXOff)) * (nYEnd - nYOff)) > maxBatchPxls)
+                        {
+                            break;
+                        }
+                        xOff = nXOff;
+                        yOff = nYOff;
+                        xEnd = nXEnd;
+                        yEnd = nYEnd;
+                        batch.windows.push_back(nextWin);
+                        ++featIdx;
+                    }
+                    batch.xOff = xOff;
+                    batch.yOff = yOff;
+                    batch.width = xEnd - xOff;
+                    batch.height = yEnd - yOff;
+                    
+                    size_t batchPxls = ((size_t)batch.width) * batch.height;
+                    batch.data.resize(batchPxls * usedBands.size());
+                    if(batchPxls > 0)
+                    {
+                        for(size_t n = 0; n < usedBands.size(); ++n)
+                        {
+                            if(image->GetRasterBand(usedBands[n])->RasterIO(GF_Read, batch.xOff, batch.yOff, batch.width, batch.height, &batch.data[n*batchPxls], batch.width, batch.height, GDT_Float32, 0, 0) != CE_None)
+                            {
+                                throw rsgis::img::RSGISImageCalcException("Could not read the image for the zonal stats.");
+                            }
+                        }
+                    }
+                    for(std::vector<ZonalFeatWindow>::iterator iterWin = batch.windows.begin(); iterWin != batch.windows.end(); ++iterWin)
+                    {
+                        OGRFeature *batchFeat = vecLyr->GetFeature((*iterWin).fid);
+                        if(batchFeat == NULL)
+                        {
+                            for(std::vector<OGRFeature*>::iterator iterFeat = batch.feats.begin(); iterFeat != batch.feats.end(); ++iterFeat)
+                            {
+                                OGRFeature::DestroyFeature(*iterFeat);
+                            }
+                            batch.feats.clear();
+                            throw RSGISVectorException("Could not read a feature from the vector layer.");
+                        }
+                        batch.feats.push_back(batchFeat);
+                    }
+                }
+                
+                // Calculate the stats for the batches.
+                std::exception_ptr batchError = nullptr;
+                try
+                {
+                    pool.parallelFor(numBatches, [this, &batches, &imgTransform, zonalBandAtts, &bandSlots, pixelInPolyMethod](size_t b, unsigned int)
+                    {
+                        this->calcZonalFeatBatch(&batches[b], imgTransform, zonalBandAtts, &bandSlots, pixelInPolyMethod);
+                    });
+                }
+                catch(...)
+                {
+                    batchError = std::current_exception();
+                }
+                
+                // Write the features back from this thread.
+                for(size_t b = 0; b < numBatches; ++b)
+                {
+                    ZonalFeatBatch &batch = batches[b];
+                    for(size_t f = 0; f < batch.feats.size(); ++f)
+                    {
+                        OGRFeature *outFeat = batch.feats[f];
+                        if(!batchError)
+                        {
+                            if(!inTransaction)
+                            {
+                                vecLyr->StartTransaction();
+                                inTransaction = true;
+                            }
+                            size_t a = 0;
+                            for(std::vector<ZonalBandAttrs>::iterator iterAtts = zonalBandAtts->begin(); iterAtts != zonalBandAtts->end(); ++iterAtts, ++a)
+                            {
+                                const rsgis::math::RSGISStatsSummary &featStats = batch.stats[(f*zonalBandAtts->size())+a];
+                                if((*iterAtts).outMin)
+                                {
+                                    outFeat->SetField((*iterAtts).minName.c_str(), featStats.min);
+                                }
+                                if((*iterAtts).outMax)
+                                {
+                                    outFeat->SetField((*iterAtts).maxName.c_str(), featStats.max);
+                                }
+                                if((*iterAtts).outMean)
+                                {
+                                    outFeat->SetField((*iterAtts).meanName.c_str(), featStats.mean);
+                                }
+                                if((*iterAtts).outSum)
+                                {
+                                    outFeat->SetField((*iterAtts).sumName.c_str(), featStats.sum);
+                                }
+                                if((*iterAtts).outStDev)
+                                {
+                                    outFeat->SetField((*iterAtts).stdName.c_str(), featStats.stdDev);
+                                }
+                                if((*iterAtts).outMedian)
+                                {
+                                    outFeat->SetField((*iterAtts).medianName.c_str(), featStats.median);
+                                }
+                                if((*iterAtts).outMode)
+                                {
+                                    outFeat->SetField((*iterAtts).modeName.c_str(), featStats.mode);
+                                }
+                                if((*iterAtts).outCount)
+                                {
+                                    outFeat->SetField((*iterAtts).countName.c_str(), (double)(batch.counts[(f*zonalBandAtts->size())+a]));
+                                }
+                            }
+                            if(vecLyr->SetFeature(outFeat) != OGRERR_NONE)
+                            {
+                                batchError = std::make_exception_ptr(RSGISVectorOutputException("Failed to write feature to the vector layer."));
+                            }
+                            ++numWritten;
+                            if(((numWritten % 20000) == 0) && inTransaction)
+                            {
+                                vecLyr->CommitTransaction();
+                                inTransaction = false;
+                            }
+                        }
+                        OGRFeature::DestroyFeature(outFeat);
+                    }
+                    batch.feats.clear();
+                }
+                if(batchError)
+                {
+                    if(inTransaction)
+                    {
+                        vecLyr->CommitTransaction();
+                    }
+                    std::rethrow_exception(batchError);
+                }
+            }
+            if(inTransaction)
+            {
+                vecLyr->CommitTransaction();
+            }
+            pbar.finish();
+        }
+        catch (rsgis::RSGISException &e)
+        {
+            throw rsgis::img::RSGISImageCalcException(e.what());
+        }
+        catch (std::exception &e)
+        {
+            throw rsgis::img::RSGISImageCalcException(e.what());
+        }
+    }
+    
+    void ZonalStats::calcZonalFeatBatch(ZonalFeatBatch *batch, double *imgTransform, std::vector<ZonalBandAttrs> *zonalBandAtts, std::vector<int> *bandSlots, rsgis::img::pixelInPolyOption pixelInPolyMethod)
+    {
+        rsgis::math::RSGISMathsUtils mathUtils;
+        rsgis::math::RSGISStatsSummary featStats;
+        std::vector<rsgis::img::RSGISPixelSpan> pxlSpans;
+        std::vector<double> dataVal;
+        double pxlYRes = fabs(imgTransform[5]);
+        size_t batchPxls = ((size_t)batch->width) * batch->height;
+        size_t numAtts = zonalBandAtts->size();
+        batch->stats.resize(batch->feats.size() * numAtts);
+        batch->counts.assign(batch->feats.size() * numAtts, 0);
+        
+        for(size_t f = 0; f < batch->feats.size(); ++f)
+        {
+            const ZonalFeatWindow &featWin = batch->windows[f];
+            pxlSpans.clear();
+            if((featWin.xEnd > featWin.xOff) && (featWin.yEnd > featWin.yOff))
+            {
+                rsgis::img::RSGISPolygonRasteriser polyRasteriser(imgTransform[0] + (featWin.xOff * imgTransform[1]), imgTransform[3] - (featWin.yOff * pxlYRes), imgTransform[1], pxlYRes, featWin.xEnd - featWin.xOff, featWin.yEnd - featWin.yOff);
+                polyRasteriser.setPolygon(batch->feats[f]->GetGeometryRef());
+                polyRasteriser.findPixelSpans(pixelInPolyMethod, &pxlSpans);
+            }
+            
+            size_t a = 0;
+            for(std::vector<ZonalBandAttrs>::iterator iterAtts = zonalBandAtts->begin(); iterAtts != zonalBandAtts->end(); ++iterAtts, ++a)
+            {
+                const float *bandData = &batch->data[(*bandSlots)[(*iterAtts).band-1] * batchPxls];
+                dataVal.clear();
+                for(std::vector<rsgis::img::RSGISPixelSpan>::iterator iterSpan = pxlSpans.begin(); iterSpan != pxlSpans.end(); ++iterSpan)
+                {
+                    const float *rowData = &bandData[((featWin.yOff - batch->yOff + (*iterSpan).row) * ((size_t)batch->width)) + (featWin.xOff - batch->xOff)];
+                    for(long x = (*iterSpan).xStart; x < (*iterSpan).xEnd; ++x)
+                    {
+                        if((rowData[x] >= (*iterAtts).minThres) & (rowData[x] < (*iterAtts).maxThres))
+                        {
+                            dataVal.push_back(rowData[x]);
+                        }
+                    }
+                }
+                mathUtils.initStatsSummaryValues(&featStats);
+                featStats.calcMin = (*iterAtts).outMin;
+                featStats.calcMax = (*iterAtts).outMax;
+                featStats.calcMean = (*iterAtts).outMean;
+                featStats.calcSum = (*iterAtts).outSum;
+                featStats.calcStdDev = (*iterAtts).outStDev;
+                featStats.calcMedian = (*iterAtts).outMedian;
+                featStats.calcMode = (*iterAtts).outMode;
+                featStats.calcVariance = false;
+                if(dataVal.size() > 0)
+                {
+                    mathUtils.generateStats(&dataVal, &featStats);
+                }
+                batch->stats[(f*numAtts)+a] = featStats;
+                batch->counts[(f*numAtts)+a] = dataVal.size();
+            }
+        }
+        // The image data is no longer needed, only the stats.
+        std::vector<float>().swap(batch->data);
+    }
+    
+    uint64_t ZonalStats::hilbertIndex(uint32_t x, uint32_t y)
+    {
+        // Distance along a Hilbert curve over a 65536 x 65536 grid.
+        uint64_t d = 0;
+        for(uint32_t s = 32768; s > 0; s /= 2)
+        {
+            uint32_t rx = ((x & s) > 0)?1:0;
+            uint32_t ry = ((y & s) > 0)?1:0;
+            d += ((uint64_t)s) * s * ((3 * rx) ^ ry);
+            if(ry == 0)
+            {
+                if(rx == 1)
+                {
+                    x = 65535 - x;
+                    y = 65535 - y;
+                }
+                std::swap(x, y);
+            }
+        }
+        return d;
+    }
+    
     void ZonalStats::addVecLyrDefn(OGRLayer *vecLyr, std::vector<ZonalBandAttrs> *zonalBandAtts)
     {
         try
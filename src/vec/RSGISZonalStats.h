@@ -26,6 +26,12 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <thread>
+#include <exception>
+#include <algorithm>
+#include <cstdlib>
+#include <stdint.h>
 #include <math.h>
 
 #include "gdal_priv.h"
@@ -37,11 +43,14 @@
 #include "img/RSGISCalcImage.h"
 #include "img/RSGISCalcImageSingle.h"
 #include "img/RSGISPixelInPoly.h"
+#include "img/RSGISPolygonRasteriser.h"
 
 #include "utils/RSGISTextException.h"
 
 #include "math/RSGISMathsUtils.h"
 
+#include "rastergis/RSGISZonalStatsAccumulator.h"
+
 #include "vec/RSGISVectorOutputException.h"
 #include "vec/RSGISVectorZonalException.h"
 #include "vec/RSGISPolygonData.h"
@@ -58,6 +67,7 @@
 
 #include <boost/math/special_functions/fpclassify.hpp>
 #include <boost/algorithm/string.hpp>
+#include "common/RSGISParallel.h"
 
 // mark all exported classes/functions with DllExport to have
 // them exported by Visual Studio
@@ -150,12 +160,59 @@ namespace rsgis
 				void zonalStatsRaster(GDALDataset *image, GDALDataset *rasterFeatures, OGRLayer *inputLayer, OGRLayer *outputLayer, bool **toCalc);
 				void zonalStatsRaster2txt(GDALDataset *image, GDALDataset *rasterFeatures, OGRLayer *inputLayer, std::string outputTxt, bool **toCalc);
                 void zonalStatsFeatsVectorLyr(GDALDataset *image, OGRLayer *vecLyr, std::vector<ZonalBandAttrs> *zonalBandAtts, rsgis::img::pixelInPolyOption pixelInPolyMethod);
+                /**
+                 * As zonalStatsFeatsVectorLyr but the features are sorted along a Hilbert
+                 * curve of their envelope centres and grouped into batches of neighbouring
+                 * features, so each batch is read from the image once. The batches are
+                 * processed on numThreads threads (RSGISLIB_NUM_THREADS or setNumThreads)
+                 * and the features are written back from a single thread in transactions.
+                 * The layer must support random reading; if it does not, or the pixel in
+                 * polygon method is not supported by RSGISPolygonRasteriser,
+                 * zonalStatsFeatsVectorLyr is used. Features outside the image are given
+                 * the statistics of no pixels rather than raising an error.
+                 */
+                void zonalStatsFeatsVectorLyrBatched(GDALDataset *image, OGRLayer *vecLyr, std::vector<ZonalBandAttrs> *zonalBandAtts, rsgis::img::pixelInPolyOption pixelInPolyMethod);
+                /**
+                 * Number of threads for zonalStatsFeatsVectorLyrBatched; 0 uses the number of cores.
+                 */
+                void setNumThreads(unsigned int numThreads);
                 ~ZonalStats();
 			protected:
+                struct ZonalFeatWindow
+                {
+                    long fid;
+                    uint64_t hilbertIdx;
+                    int xOff;
+                    int yOff;
+                    int xEnd;
+                    int yEnd;
+                };
+                struct ZonalFeatBatch
+                {
+                    std::vector<OGRFeature*> feats;
+                    std::vector<ZonalFeatWindow> windows;
+                    int xOff;
+                    int yOff;
+                    int width;
+                    int height;
+                    // The bands used, one after another.
+                    std::vector<float> data;
+                    // For each feature, the stats and count for each of the zonalBandAtts.
+                    std::vector<rsgis::math::RSGISStatsSummary> stats;
+                    std::vector<size_t> counts;
+                };
+                void calcZonalFeatBatch(ZonalFeatBatch *batch, double *imgTransform, std::vector<ZonalBandAttrs> *zonalBandAtts, std::vector<int> *bandSlots, rsgis::img::pixelInPolyOption pixelInPolyMethod);
+                uint64_t hilbertIndex(uint32_t x, uint32_t y);
+                unsigned int numThreads;
                 void addVecLyrDefn(OGRLayer *vecLyr, std::vector<ZonalBandAttrs> *zonalBandAtts);
 				void createOutputSHPDefinition(OGRLayer *inputSHPLayer, OGRLayer *outputSHPLayer, bool **toCalc, int numBands);
 				void createOutputSHPDefinition(OGRLayer *outputSHPLayer, classzonalstats** attributes, int numAttributes, OGRFeatureDefn *inLayerDef);
 				void outputData2SHP(OGRLayer *inputLayer, OGRLayer *outputSHPLayer, int featureFieldCount, bool **toCalc, int numBands, imagestats **stats);
+				/**
+				 * The stats of each band of image for the features of rasterFeatures (feature index, -1 outside)
+				 * with one pass using RSGISZonalStatsAccumulator.
+				 */
+				void calcRasterZoneStats(GDALDataset *image, GDALDataset *rasterFeatures, imagestats **featureStats, int numFeatures, int numAttributes);
 				void calcImageStats(GDALDataset *image, OGRPolygon *polygon, imagestats *stats);
 				void calcImageStats(GDALDataset *image, RSGISZonalPolygons *polygon);
 				void outputData2Text(std::string outputTxt, bool **toCalc, imagestats **stats, int numFeatures, int numAttributes);
@@ -0,0 +1,369 @@
+/*
+ *  rsgisbenchmark.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2013 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Times the core engines (per-pixel calc, window calc, filters, clumping,
+ * RAT statistics, zonal statistics and mosaicking) on synthetic images
+ * of several sizes with several thread counts, writing one JSON object per
+ * case for regression tracking.
+ *
+ * rsgisbenchmark [--sizes 512,2048] [--threads 1,4] [--reps 3]
+ *                [--filter name] [--tmpdir dir] [--format KEA] [--out file]
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <cstdlib>
+
+#include "gdal_priv.h"
+
+#include "common/RSGISException.h"
+#include "common/RSGISCommons.h"
+#include "img/RSGISCreateTestImages.h"
+#include "rastergis/RSGISZonalStatsAccumulator.h"
+#include "cmds/RSGISCmdException.h"
+#include "cmds/RSGISCmdImageCalc.h"
+#include "cmds/RSGISCmdImageUtils.h"
+#include "cmds/RSGISCmdFilterImages.h"
+#include "cmds/RSGISCmdSegmentation.h"
+#include "cmds/RSGISCmdRasterGIS.h"
+
+struct BenchmarkImages
+{
+    std::string imgFile;
+    std::string classesFile;
+    std::string clumpsFile;
+    std::vector<std::string> tileFiles;
+};
+
+struct BenchmarkCase
+{
+    std::string name;
+    std::function<void(const BenchmarkImages &imgs, unsigned int numThreads, const std::string &outBase)> run;
+};
+
+static std::vector<unsigned int> parseList(std::string list)
+{
+    std::vector<unsigned int> vals;
+    std::stringstream listStream(list);
+    std::string item;
+    while(std::getline(listStream, item, ','))
+    {
+        if(!item.empty())
+        {
+            vals.push_back(atoi(item.c_str()));
+        }
+    }
+    return vals;
+}
+
+static void setThreadsEnv(unsigned int numThreads)
+{
+    std::string numThreadsStr = std::to_string(numThreads);
+#ifdef _MSC_VER
+    _putenv_s("RSGISLIB_NUM_THREADS", numThreadsStr.c_str());
+#else
+    setenv("RSGISLIB_NUM_THREADS", numThreadsStr.c_str(), 1);
+#endif
+}
+
+static std::vector<BenchmarkCase> createCases(std::string format, std::string ext)
+{
+    std::vector<BenchmarkCase> cases;
+
+    cases.push_back({"calc_pixel", [format, ext](const BenchmarkImages &imgs, unsigned int numThreads, const std::string &outBase)
+    {
+        rsgis::cmds::executeImageMaths(imgs.imgFile, outBase + ext, "(b1 - b2) / (b1 + b2)", format, rsgis::rsgis_32float, false);
+    }});
+
+    cases.push_back({"calc_window", [format, ext](const BenchmarkImages &imgs, unsigned int numThreads, const std::string &outBase)
+    {
+        rsgis::cmds::RSGISFilterParameters params;
+        params.type = "Mean";
+        params.fileEnding = "mean";
+        params.size = 5;
+        std::vector<rsgis::cmds::RSGISFilterParameters*> filters(1, &params);
+        rsgis::cmds::executeFilter(imgs.imgFile, &filters, outBase, format, ext.substr(1), rsgis::rsgis_32float);
+    }});
+
+    cases.push_back({"filter_gaussian", [format, ext](const BenchmarkImages &imgs, unsigned int numThreads, const std::string &outBase)
+    {
+        rsgis::cmds::RSGISFilterParameters params;
+        params.type = "GaussianSmooth";
+        params.fileEnding = "gausmooth";
+        params.size = 7;
+        params.stddevX = 2.0;
+        params.stddevY = 2.0;
+        params.angle = 0.0;
+        std::vector<rsgis::cmds::RSGISFilterParameters*> filters(1, &params);
+        rsgis::cmds::executeFilter(imgs.imgFile, &filters, outBase, format, ext.substr(1), rsgis::rsgis_32float);
+    }});
+
+    cases.push_back({"filter_median", [format, ext](const BenchmarkImages &imgs, unsigned int numThreads, const std::string &outBase)
+    {
+        rsgis::cmds::RSGISFilterParameters params;
+        params.type = "Median";
+        params.fileEnding = "median";
+        params.size = 5;
+        std::vector<rsgis::cmds::RSGISFilterParameters*> filters(1, &params);
+        rsgis::cmds::executeFilter(imgs.imgFile, &filters, outBase, format, ext.substr(1), rsgis::rsgis_32float);
+    }});
+
+    cases.push_back({"clump", [format, ext](const BenchmarkImages &imgs, unsigned int numThreads, const std::string &outBase)
+    {
+        rsgis::cmds::executeClump(imgs.classesFile, outBase + ext, format, true, true, 0, true, numThreads);
+    }});
+
+    cases.push_back({"rat_populate_stats", [](const BenchmarkImages &imgs, unsigned int numThreads, const std::string &outBase)
+    {
+        rsgis::cmds::executePopulateStats(imgs.clumpsFile, false, false, true, 1);
+    }});
+
+    cases.push_back({"rat_band_stats", [](const BenchmarkImages &imgs, unsigned int numThreads, const std::string &outBase)
+    {
+        std::vector<rsgis::cmds::RSGISBandAttStatsCmds*> bandStats;
+        for(unsigned int n = 1; n <= 3; ++n)
+        {
+            rsgis::cmds::RSGISBandAttStatsCmds *stats = new rsgis::cmds::RSGISBandAttStatsCmds();
+            std::string prefix = "b" + std::to_string(n);
+            stats->band = n;
+            stats->calcMin = true;
+            stats->minField = prefix + "Min";
+            stats->calcMax = true;
+            stats->maxField = prefix + "Max";
+            stats->calcMean = true;
+            stats->meanField = prefix + "Mean";
+            stats->calcStdDev = true;
+            stats->stdDevField = prefix + "StdDev";
+            stats->calcSum = false;
+            bandStats.push_back(stats);
+        }
+        try
+        {
+            rsgis::cmds::executePopulateRATWithStats(imgs.imgFile, imgs.clumpsFile, &bandStats, 1);
+        }
+        catch(...)
+        {
+            for(size_t i = 0; i < bandStats.size(); ++i)
+            {
+                delete bandStats[i];
+            }
+            throw;
+        }
+        for(size_t i = 0; i < bandStats.size(); ++i)
+        {
+            delete bandStats[i];
+        }
+    }});
+
+    cases.push_back({"zonal_stats", [](const BenchmarkImages &imgs, unsigned int numThreads, const std::string &outBase)
+    {
+        GDALDataset *zonesDS = (GDALDataset *) GDALOpen(imgs.clumpsFile.c_str(), GA_ReadOnly);
+        GDALDataset *valsDS = (GDALDataset *) GDALOpen(imgs.imgFile.c_str(), GA_ReadOnly);
+        if((zonesDS == NULL) || (valsDS == NULL))
+        {
+            if(zonesDS != NULL){GDALClose(zonesDS);}
+            if(valsDS != NULL){GDALClose(valsDS);}
+            throw rsgis::RSGISException("Could not open the zonal statistics images.");
+        }
+        try
+        {
+            double maxZone = 0;
+            int gotMax = false;
+            maxZone = zonesDS->GetRasterBand(1)->GetMaximum(&gotMax);
+            if(!gotMax)
+            {
+                double minMax[2];
+                zonesDS->GetRasterBand(1)->ComputeRasterMinMax(false, minMax);
+                maxZone = minMax[1];
+            }
+            rsgis::rastergis::RSGISZonalStatsAccumulator zonalStats(((size_t)maxZone) + 1);
+            zonalStats.setNumThreads(numThreads);
+            zonalStats.setHistogram(200, 0, 200);
+            zonalStats.calcZoneStats(zonesDS, 1, valsDS);
+        }
+        catch(...)
+        {
+            GDALClose(zonesDS);
+            GDALClose(valsDS);
+            throw;
+        }
+        GDALClose(zonesDS);
+        GDALClose(valsDS);
+    }});
+
+    cases.push_back({"mosaic", [format, ext](const BenchmarkImages &imgs, unsigned int numThreads, const std::string &outBase)
+    {
+        std::vector<std::string> tiles = imgs.tileFiles;
+        rsgis::cmds::executeImageMosaic(tiles.data(), tiles.size(), outBase + ext, 0, 0, 1, 0, format, rsgis::rsgis_32float);
+    }});
+
+    return cases;
+}
+
+static void createImages(std::string tmpDir, std::string format, std::string ext, unsigned int size, BenchmarkImages *imgs)
+{
+    rsgis::img::RSGISCreateTestImages createImgs;
+    std::string base = tmpDir + "/rsgisbench_" + std::to_string(size);
+    imgs->imgFile = base + "_img" + ext;
+    imgs->classesFile = base + "_classes" + ext;
+    imgs->clumpsFile = base + "_clumps" + ext;
+    createImgs.createSyntheticImage(imgs->imgFile, format, size, size, 3, 0.0, size, 42);
+    createImgs.createPatchImage(imgs->classesFile, format, size, size, 16, 5, 42);
+    createImgs.createPatchImage(imgs->clumpsFile, format, size, size, 16, 0, 42);
+
+    // Four overlapping quarters of the image to mosaic back together.
+    imgs->tileFiles.clear();
+    unsigned int tileSize = (size / 2) + 8;
+    for(unsigned int tY = 0; tY < 2; ++tY)
+    {
+        for(unsigned int tX = 0; tX < 2; ++tX)
+        {
+            std::string tileFile = base + "_tile" + std::to_string(tY) + std::to_string(tX) + ext;
+            double tlX = tX * (size - tileSize);
+            double tlY = size - (tY * (size - tileSize));
+            createImgs.createSyntheticImage(tileFile, format, tileSize, tileSize, 3, tlX, tlY, 42 + (tY * 2) + tX);
+            imgs->tileFiles.push_back(tileFile);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<unsigned int> sizes = {512, 2048};
+    std::vector<unsigned int> threads = {1, 4};
+    unsigned int reps = 3;
+    std::string filter = "";
+    std::string tmpDir = ".";
+    std::string format = "KEA";
+    std::string outFile = "";
+
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if((i + 1) >= argc)
+        {
+            std::cerr << "No value given for " << arg << std::endl;
+            return 1;
+        }
+        std::string val = argv[++i];
+        if(arg == "--sizes"){sizes = parseList(val);}
+        else if(arg == "--threads"){threads = parseList(val);}
+        else if(arg == "--reps"){reps = std::max(atoi(val.c_str()), 1);}
+        else if(arg == "--filter"){filter = val;}
+        else if(arg == "--tmpdir"){tmpDir = val;}
+        else if(arg == "--format"){format = val;}
+        else if(arg == "--out"){outFile = val;}
+        else
+        {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    std::map<std::string, std::string> formatExts = {{"KEA", ".kea"}, {"GTiff", ".tif"}, {"HFA", ".img"}, {"ENVI", ".env"}};
+    std::string ext = (formatExts.count(format) > 0)?formatExts[format]:".img";
+
+    std::ofstream outFileStream;
+    if(outFile != "")
+    {
+        outFileStream.open(outFile.c_str());
+        if(!outFileStream.is_open())
+        {
+            std::cerr << "Could not open " << outFile << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &results = (outFile != "")?outFileStream:std::cout;
+
+    GDALAllRegister();
+    std::vector<BenchmarkCase> cases = createCases(format, ext);
+    int numFailed = 0;
+    try
+    {
+        for(std::vector<unsigned int>::iterator iterSize = sizes.begin(); iterSize != sizes.end(); ++iterSize)
+        {
+            BenchmarkImages imgs;
+            createImages(tmpDir, format, ext, *iterSize, &imgs);
+            for(std::vector<BenchmarkCase>::iterator iterCase = cases.begin(); iterCase != cases.end(); ++iterCase)
+            {
+                if((filter != "") && (iterCase->name.find(filter) == std::string::npos))
+                {
+                    continue;
+                }
+                for(std::vector<unsigned int>::iterator iterThreads = threads.begin(); iterThreads != threads.end(); ++iterThreads)
+                {
+                    setThreadsEnv(*iterThreads);
+                    std::string outBase = tmpDir + "/rsgisbench_" + std::to_string(*iterSize) + "_" + iterCase->name + "_out";
+                    std::vector<double> times;
+                    std::string error = "";
+                    for(unsigned int r = 0; r < reps; ++r)
+                    {
+                        try
+                        {
+                            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                            iterCase->run(imgs, *iterThreads, outBase);
+                            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                            times.push_back(elapsed.count());
+                        }
+                        catch(std::exception &e)
+                        {
+                            error = e.what();
+                            break;
+                        }
+                    }
+
+                    results << "{\"case\": \"" << iterCase->name << "\", \"size\": " << *iterSize << ", \"threads\": " << *iterThreads;
+                    if(error != "")
+                    {
+                        ++numFailed;
+                        std::replace(error.begin(), error.end(), '"', '\'');
+                        results << ", \"error\": \"" << error << "\"}" << std::endl;
+                        continue;
+                    }
+                    std::sort(times.begin(), times.end());
+                    double total = 0;
+                    for(std::vector<double>::iterator iterTime = times.begin(); iterTime != times.end(); ++iterTime)
+                    {
+                        total += *iterTime;
+                    }
+                    double median = times[times.size() / 2];
+                    double mpxPerSec = (((double)*iterSize) * ((double)*iterSize)) / (median * 1.0e6);
+                    results << ", \"reps\": " << times.size() << ", \"min_s\": " << times.front() << ", \"median_s\": " << median << ", \"mean_s\": " << (total / times.size()) << ", \"max_s\": " << times.back() << ", \"mpixels_per_s\": " << mpxPerSec << "}" << std::endl;
+                }
+            }
+        }
+    }
+    catch(std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return (numFailed > 0)?2:0;
+}
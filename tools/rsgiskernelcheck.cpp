@@ -0,0 +1,271 @@
+/*
+ *  rsgiskernelcheck.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Checks that every instruction set variant of the RSGISKernels the CPU
+ * supports gives the same (bitwise) result as the scalar one, and that the
+ * block (RSGISKernels) implementations give the same result as the per-pixel
+ * ones, printing each failure and returning non-zero if there are any (run
+ * by ctest).
+ *
+ * rsgiskernelcheck
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <limits>
+#include <cstring>
+
+#include "common/RSGISKernels.h"
+#include "math/RSGISVectors.h"
+#include "classifier/RSGISClassifier.h"
+#include "classifier/RSGISKMeanImageClassifier.h"
+
+static unsigned int numFailures = 0;
+
+static void check(bool ok, const std::string &name, const std::string &msg)
+{
+    if(!ok)
+    {
+        std::cerr << "FAIL [" << name << " " << rsgis::RSGISKernels::getISAName() << "]: " << msg << std::endl;
+        ++numFailures;
+    }
+}
+
+// Random planar data, quantised so there are exact ties as well as near ones.
+static std::vector<std::vector<float> > randomPlanes(std::mt19937 &rng, unsigned int numBands, size_t n)
+{
+    std::uniform_int_distribution<int> dist(0, 400);
+    std::vector<std::vector<float> > planes(numBands, std::vector<float>(n));
+    for(unsigned int b = 0; b < numBands; ++b)
+    {
+        for(size_t i = 0; i < n; ++i)
+        {
+            planes[b][i] = dist(rng) * 0.25f;
+        }
+    }
+    return planes;
+}
+
+template <typename T>
+static bool sameBits(const std::vector<T> &a, const std::vector<T> &b)
+{
+    return (a.size() == b.size()) && (std::memcmp(a.data(), b.data(), sizeof(T) * a.size()) == 0);
+}
+
+// The outputs of each kernel for the same inputs.
+struct KernelResults
+{
+    std::vector<float> affine;
+    std::vector<unsigned char> uint8;
+    std::vector<unsigned short> uint16;
+    std::vector<float> masked;
+    std::vector<float> minMax;
+    std::vector<double> sums;
+    std::vector<size_t> counts;
+    std::vector<unsigned long long> hist;
+    std::vector<unsigned int> nearestIdx;
+    std::vector<float> nearestDist;
+    std::vector<unsigned int> nearestDblIdx;
+    std::vector<double> nearestDblDist;
+    std::vector<float> lut;
+};
+
+static KernelResults runKernels(const std::vector<std::vector<float> > &planes, const std::vector<unsigned char> &mask)
+{
+    KernelResults res;
+    const std::vector<float> &in = planes[0];
+    // An odd length so the remainders after each vector width are used.
+    size_t n = in.size();
+
+    res.affine.resize(n);
+    rsgis::RSGISKernels::affine(in.data(), res.affine.data(), n, 0.37f, -12.5f);
+    res.uint8.resize(n);
+    rsgis::RSGISKernels::scaleToUInt8(in.data(), res.uint8.data(), n, 2.7f, -3.0f);
+    res.uint16.resize(n);
+    rsgis::RSGISKernels::scaleToUInt16(in.data(), res.uint16.data(), n, 731.3f, -100.0f);
+    res.masked.resize(n);
+    rsgis::RSGISKernels::maskedSelect(mask.data(), planes[0].data(), planes[1].data(), res.masked.data(), n);
+
+    for(unsigned int noData = 0; noData < 2; ++noData)
+    {
+        // Each length from 0 up to several vector widths and the full length.
+        for(size_t len = 0; len <= n; len = (len < 70)?(len + 1):((len == n)?(n + 1):n))
+        {
+            float minVal = 0;
+            float maxVal = 0;
+            double sum = 0;
+            res.counts.push_back(rsgis::RSGISKernels::reduceMinMaxSum(in.data(), len, (noData == 1), 25.0f, &minVal, &maxVal, &sum));
+            res.minMax.push_back(minVal);
+            res.minMax.push_back(maxVal);
+            res.sums.push_back(sum);
+        }
+    }
+
+    res.hist.resize(37, 0);
+    rsgis::RSGISKernels::histogram(in.data(), n, 3.0f, 2.5f, 37, res.hist.data());
+
+    std::vector<const float*> bandPlanes;
+    for(size_t b = 0; b < planes.size(); ++b)
+    {
+        bandPlanes.push_back(planes[b].data());
+    }
+    const unsigned int numBands = planes.size();
+    const unsigned int numCentres = 9;
+    std::vector<float> centres;
+    std::vector<double> centresDbl;
+    for(unsigned int c = 0; c < numCentres; ++c)
+    {
+        for(unsigned int b = 0; b < numBands; ++b)
+        {
+            centres.push_back(planes[b][c*53]);
+            centresDbl.push_back(planes[b][c*53] + (c * 0.01));
+        }
+    }
+    res.nearestIdx.resize(n);
+    res.nearestDist.resize(n);
+    rsgis::RSGISKernels::nearestCentre(bandPlanes.data(), numBands, n, centres.data(), numCentres, res.nearestIdx.data(), res.nearestDist.data());
+    res.nearestDblIdx.resize(n);
+    res.nearestDblDist.resize(n);
+    rsgis::RSGISKernels::nearestCentre(bandPlanes.data(), numBands, n, centresDbl.data(), numCentres, res.nearestDblIdx.data(), res.nearestDblDist.data());
+
+    std::vector<float> lutVals(numCentres - 2);
+    for(size_t i = 0; i < lutVals.size(); ++i)
+    {
+        lutVals[i] = i * 1.5f;
+    }
+    res.lut.resize(n);
+    rsgis::RSGISKernels::lutGather(res.nearestIdx.data(), n, lutVals.data(), lutVals.size(), -1.0f, res.lut.data());
+    return res;
+}
+
+static void checkKernels(const KernelResults &ref, const std::vector<std::vector<float> > &planes, const std::vector<unsigned char> &mask)
+{
+    KernelResults res = runKernels(planes, mask);
+    check(sameBits(ref.affine, res.affine), "affine", "differs from scalar");
+    check(sameBits(ref.uint8, res.uint8), "scaleToUInt8", "differs from scalar");
+    check(sameBits(ref.uint16, res.uint16), "scaleToUInt16", "differs from scalar");
+    check(sameBits(ref.masked, res.masked), "maskedSelect", "differs from scalar");
+    check(sameBits(ref.counts, res.counts), "reduceMinMaxSum", "counts differ from scalar");
+    check(sameBits(ref.minMax, res.minMax), "reduceMinMaxSum", "min/max differ from scalar");
+    check(sameBits(ref.sums, res.sums), "reduceMinMaxSum", "sums differ from scalar");
+    check(sameBits(ref.hist, res.hist), "histogram", "differs from scalar");
+    check(sameBits(ref.nearestIdx, res.nearestIdx), "nearestCentre", "indexes differ from scalar");
+    check(sameBits(ref.nearestDist, res.nearestDist), "nearestCentre", "distances differ from scalar");
+    check(sameBits(ref.nearestDblIdx, res.nearestDblIdx), "nearestCentre (double)", "indexes differ from scalar");
+    check(sameBits(ref.nearestDblDist, res.nearestDblDist), "nearestCentre (double)", "distances differ from scalar");
+    check(sameBits(ref.lut, res.lut), "lutGather", "differs from scalar");
+}
+
+static void checkKMeanClassifier()
+{
+    const unsigned int numBands = 5;
+    const unsigned int numClusters = 7;
+    const size_t nPxls = 10007;
+    std::mt19937 rng(42);
+    std::vector<std::vector<float> > planes = randomPlanes(rng, numBands, nPxls);
+    std::vector<const float*> bandPlanes;
+    for(unsigned int b = 0; b < numBands; ++b)
+    {
+        bandPlanes.push_back(planes[b].data());
+    }
+
+    // Centres at the pixel values (and one repeated) so distances tie.
+    std::vector<std::vector<double> > centreVals(numClusters, std::vector<double>(numBands));
+    std::vector<rsgis::math::Vector> centreVecs(numClusters);
+    std::vector<rsgis::classifier::ClusterCentre> centres(numClusters);
+    std::vector<rsgis::classifier::ClusterCentre*> centrePtrs(numClusters);
+    for(unsigned int c = 0; c < numClusters; ++c)
+    {
+        for(unsigned int b = 0; b < numBands; ++b)
+        {
+            centreVals[c][b] = (c == (numClusters-1))?centreVals[0][b]:(planes[b][c*101] + (c * 0.1));
+        }
+        centreVecs[c].vector = centreVals[c].data();
+        centreVecs[c].n = numBands;
+        centres[c].classID = c;
+        centres[c].data = &centreVecs[c];
+        centres[c].numVals = 0;
+        centrePtrs[c] = &centres[c];
+    }
+
+    rsgis::classifier::RSGISApplyKMeanClassifierCalcImageVal calcVal(1, centrePtrs.data(), numClusters);
+    std::vector<double> blockOut(nPxls);
+    double *outPlanes[1] = {blockOut.data()};
+    calcVal.calcImageBlock(bandPlanes.data(), numBands, nPxls, outPlanes);
+
+    std::vector<float> pxlVals(numBands);
+    double pxlOut = 0;
+    unsigned int numDiff = 0;
+    for(size_t i = 0; i < nPxls; ++i)
+    {
+        for(unsigned int b = 0; b < numBands; ++b)
+        {
+            pxlVals[b] = planes[b][i];
+        }
+        calcVal.calcImageValue(pxlVals.data(), numBands, &pxlOut);
+        if(pxlOut != blockOut[i])
+        {
+            ++numDiff;
+        }
+    }
+    check(numDiff == 0, "kmeanclassifier", std::to_string(numDiff) + " pixels differ from calcImageValue");
+}
+
+int main(int argc, char **argv)
+{
+    std::mt19937 rng(7);
+    std::vector<std::vector<float> > planes = randomPlanes(rng, 4, 4099);
+    // Values which are NaN, the no data value, out of range and negative.
+    for(size_t i = 0; (i + 9) < planes[0].size(); i += 17)
+    {
+        planes[0][i] = std::numeric_limits<float>::quiet_NaN();
+        planes[0][i+5] = 25.0f;
+        planes[0][i+9] = -planes[0][i+9] - 1.0f;
+    }
+    planes[0][11] = 1e30f;
+    std::vector<unsigned char> mask(planes[0].size());
+    for(size_t i = 0; i < mask.size(); ++i)
+    {
+        mask[i] = (unsigned char)((i * 7) % 3);
+    }
+
+    rsgis::RSGISKernels::setISA(rsgis::rsgis_isa_scalar);
+    KernelResults ref = runKernels(planes, mask);
+
+    rsgis::RSGISKernelISA supportedISA = rsgis::RSGISKernels::getSupportedISA();
+    for(int isa = rsgis::rsgis_isa_scalar; isa <= supportedISA; ++isa)
+    {
+        rsgis::RSGISKernels::setISA((rsgis::RSGISKernelISA)isa);
+        checkKernels(ref, planes, mask);
+        checkKMeanClassifier();
+    }
+
+    if(numFailures > 0)
+    {
+        std::cerr << numFailures << " check(s) failed." << std::endl;
+        return 1;
+    }
+    std::cout << "All checks passed." << std::endl;
+    return 0;
+}
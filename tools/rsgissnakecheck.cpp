@@ -0,0 +1,234 @@
+/*
+ *  rsgissnakecheck.cpp
+ *  RSGIS_LIB
+ *
+ *  Copyright 2026 RSGISLib.
+ *
+ *  RSGISLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RSGISLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RSGISLib.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Checks the snake optimisation on a small synthetic (in memory) raster:
+ * that the local energy of a node changes by the same amount as the energy of
+ * the whole contour when the node moves, that climbing with the local energies
+ * gives the same contour as climbing with the whole contour's energy, and that
+ * the multi-start climb gives the same contour with 1 and 4 threads. Prints
+ * each failure and returns non-zero if there are any (run by ctest).
+ *
+ * rsgissnakecheck
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+#include "gdal_priv.h"
+
+#include "geos/geom/Coordinate.h"
+#include "geos/geom/Envelope.h"
+
+#include "math/RSGISGlobalOptimisationFunction.h"
+#include "math/RSGISGlobalHillClimbingOptimiser2D.h"
+#include "geom/RSGISIdentifyNonConvexPolygonsSnakes.h"
+
+static unsigned int numFailures = 0;
+
+static void check(bool ok, const std::string &name, const std::string &msg)
+{
+    if(!ok)
+    {
+        std::cerr << "FAIL [" << name << "]: " << msg << std::endl;
+        ++numFailures;
+    }
+}
+
+/**
+ * Passes calcValue through to another function without providing local
+ * values, so the climber scores each move on the whole contour.
+ */
+class RSGISFullValueOnlyFunction : public rsgis::math::RSGISGlobalOptimisationFunction
+{
+public:
+    RSGISFullValueOnlyFunction(rsgis::math::RSGISGlobalOptimisationFunction *func): func(func){};
+    double calcValue(std::vector<geos::geom::Coordinate*> *coords){return func->calcValue(coords);};
+    bool isThreadSafe(){return func->isThreadSafe();};
+protected:
+    rsgis::math::RSGISGlobalOptimisationFunction *func;
+};
+
+static const int imgSize = 64;
+
+// A ring of low values with random variation, so no two moves of a node have
+// (near) equal energies which the full energy (summed over the whole contour)
+// could order differently from the local energy due to rounding.
+static GDALDataset* createEnergyImage()
+{
+    GDALDriver *memDriver = GetGDALDriverManager()->GetDriverByName("MEM");
+    GDALDataset *image = memDriver->Create("", imgSize, imgSize, 1, GDT_Float32, NULL);
+    double trans[6] = {0, 1, 0, imgSize, 0, -1};
+    image->SetGeoTransform(trans);
+    std::vector<float> vals(imgSize * imgSize);
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> noiseDist(0.0f, 3.0f);
+    for(int y = 0; y < imgSize; ++y)
+    {
+        for(int x = 0; x < imgSize; ++x)
+        {
+            double dist = std::sqrt(((x - 32.0) * (x - 32.0)) + ((y - 32.0) * (y - 32.0)));
+            vals[(y * imgSize) + x] = (std::fabs(dist - 18.0) * 4) + noiseDist(rng);
+        }
+    }
+    if(image->GetRasterBand(1)->RasterIO(GF_Write, 0, 0, imgSize, imgSize, vals.data(), imgSize, imgSize, GDT_Float32, 0, 0) != CE_None)
+    {
+        throw std::runtime_error("Could not write the energy image.");
+    }
+    return image;
+}
+
+static std::vector<geos::geom::Coordinate*>* createContour()
+{
+    std::vector<geos::geom::Coordinate*> *coords = new std::vector<geos::geom::Coordinate*>();
+    const unsigned int numNodes = 24;
+    for(unsigned int i = 0; i < numNodes; ++i)
+    {
+        double angle = (2 * M_PI * i) / numNodes;
+        coords->push_back(new geos::geom::Coordinate(std::round(32 + (24 * std::cos(angle))), std::round(32 + (24 * std::sin(angle))), 0));
+    }
+    return coords;
+}
+
+static void deleteContour(std::vector<geos::geom::Coordinate*> *coords)
+{
+    for(std::vector<geos::geom::Coordinate*>::iterator iterCoords = coords->begin(); iterCoords != coords->end(); ++iterCoords)
+    {
+        delete *iterCoords;
+    }
+    delete coords;
+}
+
+static bool sameContour(std::vector<geos::geom::Coordinate*> *a, std::vector<geos::geom::Coordinate*> *b)
+{
+    if(a->size() != b->size())
+    {
+        return false;
+    }
+    for(size_t i = 0; i < a->size(); ++i)
+    {
+        if((a->at(i)->x != b->at(i)->x) || (a->at(i)->y != b->at(i)->y))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void checkLocalEnergy(rsgis::math::RSGISGlobalOptimisationFunction *func)
+{
+    std::vector<geos::geom::Coordinate*> *coords = createContour();
+    double fullValue = func->calcValue(coords);
+    unsigned int numDiff = 0;
+    for(size_t idx = 0; idx < coords->size(); ++idx)
+    {
+        geos::geom::Coordinate *node = coords->at(idx);
+        double localValue = func->calcLocalValue(coords, idx);
+        for(int dy = -1; dy <= 1; ++dy)
+        {
+            for(int dx = -1; dx <= 1; ++dx)
+            {
+                node->x += dx;
+                node->y += dy;
+                double fullChange = func->calcValue(coords) - fullValue;
+                double localChange = func->calcLocalValue(coords, idx) - localValue;
+                if(std::fabs(fullChange - localChange) > 1e-9)
+                {
+                    ++numDiff;
+                }
+                node->x -= dx;
+                node->y -= dy;
+            }
+        }
+    }
+    check(numDiff == 0, "local energy", std::to_string(numDiff) + " node moves change the local and full energy differently");
+    deleteContour(coords);
+}
+
+static void checkLocalScoring(rsgis::math::RSGISGlobalOptimisationFunction *func, geos::geom::Envelope *boundary)
+{
+    RSGISFullValueOnlyFunction fullFunc(func);
+    std::vector<geos::geom::Coordinate*> *coords = createContour();
+    rsgis::math::RSGISGlobalHillClimbingOptimiser2D localOptimiser(func, false, 50);
+    rsgis::math::RSGISGlobalHillClimbingOptimiser2D fullOptimiser(&fullFunc, false, 50);
+    for(unsigned int n = 4; n <= 8; n += 4)
+    {
+        std::vector<geos::geom::Coordinate*> *localCoords = (n == 4)?localOptimiser.optimise4Neighbor(coords, 1, boundary):localOptimiser.optimise8Neighbor(coords, 1, boundary);
+        std::vector<geos::geom::Coordinate*> *fullCoords = (n == 4)?fullOptimiser.optimise4Neighbor(coords, 1, boundary):fullOptimiser.optimise8Neighbor(coords, 1, boundary);
+        check(sameContour(localCoords, fullCoords), "local scoring", "the " + std::to_string(n) + " neighbour contour differs from the one found with the full energy");
+        check(!sameContour(localCoords, coords), "local scoring", "the " + std::to_string(n) + " neighbour contour did not move");
+        deleteContour(localCoords);
+        deleteContour(fullCoords);
+    }
+    deleteContour(coords);
+}
+
+static void checkMultiStartThreads(rsgis::math::RSGISGlobalOptimisationFunction *func, geos::geom::Envelope *boundary)
+{
+    std::vector<geos::geom::Coordinate*> *coords = createContour();
+    rsgis::math::RSGISGlobalHillClimbingOptimiser2D serialOptimiser(func, false, 50);
+    serialOptimiser.setMultiStart(6, 1.0);
+    serialOptimiser.setNumThreads(1);
+    rsgis::math::RSGISGlobalHillClimbingOptimiser2D parallelOptimiser(func, false, 50);
+    parallelOptimiser.setMultiStart(6, 1.0);
+    parallelOptimiser.setNumThreads(4);
+    std::vector<geos::geom::Coordinate*> *serialCoords = serialOptimiser.optimise8Neighbor(coords, 1, boundary);
+    std::vector<geos::geom::Coordinate*> *parallelCoords = parallelOptimiser.optimise8Neighbor(coords, 1, boundary);
+    check(sameContour(serialCoords, parallelCoords), "multi-start", "the contour with 4 threads differs from the one with 1 thread");
+    check(func->calcValue(serialCoords) == func->calcValue(parallelCoords), "multi-start", "the energy with 4 threads differs from the one with 1 thread");
+    deleteContour(serialCoords);
+    deleteContour(parallelCoords);
+    deleteContour(coords);
+}
+
+int main(int argc, char **argv)
+{
+    GDALAllRegister();
+    try
+    {
+        GDALDataset *image = createEnergyImage();
+        geos::geom::Envelope boundary(0, imgSize, 0, imgSize);
+        {
+            rsgis::geom::RSGISSnakeNonConvexGlobalOptimisationFunction func(image, 0.5, 0.25, 1.0);
+            checkLocalEnergy(&func);
+            checkLocalScoring(&func, &boundary);
+            checkMultiStartThreads(&func, &boundary);
+        }
+        GDALClose(image);
+    }
+    catch(std::exception &e)
+    {
+        std::cerr << "FAIL: " << e.what() << std::endl;
+        return 1;
+    }
+
+    if(numFailures > 0)
+    {
+        std::cerr << numFailures << " check(s) failed." << std::endl;
+        return 1;
+    }
+    std::cout << "All checks passed." << std::endl;
+    return 0;
+}